@@ -1,6 +1,10 @@
 // Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
+#ifdef __linux__
+#define _DEFAULT_SOURCE
+#endif
+
 #include "azure_c_shared_utility/gballoc.h"
 
 #include <time.h>
@@ -11,6 +15,16 @@ time_t get_time(time_t* p)
     return time(p);
 }
 
+time_t get_time_coarse(void)
+{
+#if defined(CLOCK_REALTIME_COARSE)
+    struct timespec now;
+    return (clock_gettime(CLOCK_REALTIME_COARSE, &now) == 0) ? now.tv_sec : (time_t)-1;
+#else
+    return time(NULL);
+#endif
+}
+
 struct tm* get_gmtime(time_t* currentTime)
 {
     return gmtime(currentTime);
@@ -11,6 +11,11 @@ time_t get_time(time_t* currentTime)
     return sntp_get_current_timestamp();
 }
 
+time_t get_time_coarse(void)
+{
+    return get_time(NULL);
+}
+
 double get_difftime(time_t stopTime, time_t startTime)
 {
     return (double)stopTime - (double)startTime;
@@ -11,6 +11,11 @@ time_t get_time(time_t* currentTime)
     return time(currentTime);
 }
 
+time_t get_time_coarse(void)
+{
+    return get_time(NULL);
+}
+
 double get_difftime(time_t stopTime, time_t startTime)
 {
     return difftime(stopTime, startTime);
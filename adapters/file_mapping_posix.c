@@ -0,0 +1,155 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define _DEFAULT_SOURCE
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/file_mapping.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+typedef struct FILE_MAPPING_TAG
+{
+    int fd;
+    unsigned char* address;
+    size_t size;
+} FILE_MAPPING;
+
+FILE_MAPPING_HANDLE file_mapping_open(const char* file_path, size_t size, bool* created)
+{
+    FILE_MAPPING* result;
+
+    if ((file_path == NULL) || (size == 0) || (created == NULL))
+    {
+        LogError("Invalid arguments: file_path = %p, size = %lu, created = %p", file_path, (unsigned long)size, created);
+        result = NULL;
+    }
+    else if ((result = (FILE_MAPPING*)malloc(sizeof(FILE_MAPPING))) == NULL)
+    {
+        LogError("Cannot allocate the file mapping");
+    }
+    else
+    {
+        struct stat file_stat;
+
+        if ((result->fd = open(file_path, O_RDWR | O_CREAT, S_IRUSR | S_IWUSR)) < 0)
+        {
+            LogError("Cannot open %s: %d", file_path, errno);
+            free(result);
+            result = NULL;
+        }
+        else if (fstat(result->fd, &file_stat) != 0)
+        {
+            LogError("Cannot get the size of %s: %d", file_path, errno);
+            (void)close(result->fd);
+            free(result);
+            result = NULL;
+        }
+        else if ((file_stat.st_size != 0) && ((uint64_t)file_stat.st_size != (uint64_t)size))
+        {
+            LogError("%s holds %lld bytes instead of %lu", file_path, (long long)file_stat.st_size, (unsigned long)size);
+            (void)close(result->fd);
+            free(result);
+            result = NULL;
+        }
+        else if ((file_stat.st_size == 0) && (ftruncate(result->fd, (off_t)size) != 0))
+        {
+            LogError("Cannot size %s to %lu bytes: %d", file_path, (unsigned long)size, errno);
+            (void)close(result->fd);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            void* address = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, result->fd, 0);
+            if (address == MAP_FAILED)
+            {
+                LogError("Cannot map %s: %d", file_path, errno);
+                (void)close(result->fd);
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                result->address = (unsigned char*)address;
+                result->size = size;
+                *created = (file_stat.st_size == 0);
+            }
+        }
+    }
+
+    return result;
+}
+
+void file_mapping_close(FILE_MAPPING_HANDLE file_mapping)
+{
+    if (file_mapping == NULL)
+    {
+        LogError("NULL file_mapping");
+    }
+    else
+    {
+        if (munmap(file_mapping->address, file_mapping->size) != 0)
+        {
+            LogError("munmap failed: %d", errno);
+        }
+
+        (void)close(file_mapping->fd);
+        free(file_mapping);
+    }
+}
+
+unsigned char* file_mapping_get_address(FILE_MAPPING_HANDLE file_mapping)
+{
+    unsigned char* result;
+
+    if (file_mapping == NULL)
+    {
+        LogError("NULL file_mapping");
+        result = NULL;
+    }
+    else
+    {
+        result = file_mapping->address;
+    }
+
+    return result;
+}
+
+int file_mapping_flush(FILE_MAPPING_HANDLE file_mapping, size_t offset, size_t size)
+{
+    int result;
+
+    if ((file_mapping == NULL) || (offset > file_mapping->size) || (size > file_mapping->size - offset))
+    {
+        LogError("Invalid arguments: file_mapping = %p, offset = %lu, size = %lu", file_mapping, (unsigned long)offset, (unsigned long)size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* msync wants an address aligned on a page */
+        size_t page_size = (size_t)sysconf(_SC_PAGESIZE);
+        size_t start = offset - (offset % page_size);
+
+        if (msync(file_mapping->address + start, size + (offset - start), MS_SYNC) != 0)
+        {
+            LogError("msync failed: %d", errno);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
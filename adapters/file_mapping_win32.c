@@ -0,0 +1,151 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include "windows.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/file_mapping.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+typedef struct FILE_MAPPING_TAG
+{
+    HANDLE file;
+    HANDLE mapping;
+    unsigned char* address;
+    size_t size;
+} FILE_MAPPING;
+
+FILE_MAPPING_HANDLE file_mapping_open(const char* file_path, size_t size, bool* created)
+{
+    FILE_MAPPING* result;
+
+    if ((file_path == NULL) || (size == 0) || (created == NULL))
+    {
+        LogError("Invalid arguments: file_path = %p, size = %lu, created = %p", file_path, (unsigned long)size, created);
+        result = NULL;
+    }
+    else if ((result = (FILE_MAPPING*)malloc(sizeof(FILE_MAPPING))) == NULL)
+    {
+        LogError("Cannot allocate the file mapping");
+    }
+    else
+    {
+        LARGE_INTEGER file_size;
+        LARGE_INTEGER wanted_size;
+
+        wanted_size.QuadPart = (LONGLONG)size;
+
+        if ((result->file = CreateFileA(file_path, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL)) == INVALID_HANDLE_VALUE)
+        {
+            LogError("Cannot open %s: %lu", file_path, (unsigned long)GetLastError());
+            free(result);
+            result = NULL;
+        }
+        else if (!GetFileSizeEx(result->file, &file_size))
+        {
+            LogError("Cannot get the size of %s: %lu", file_path, (unsigned long)GetLastError());
+            (void)CloseHandle(result->file);
+            free(result);
+            result = NULL;
+        }
+        else if ((file_size.QuadPart != 0) && (file_size.QuadPart != wanted_size.QuadPart))
+        {
+            LogError("%s holds %lld bytes instead of %lu", file_path, (long long)file_size.QuadPart, (unsigned long)size);
+            (void)CloseHandle(result->file);
+            free(result);
+            result = NULL;
+        }
+        else if ((file_size.QuadPart == 0) &&
+            (!SetFilePointerEx(result->file, wanted_size, NULL, FILE_BEGIN) || !SetEndOfFile(result->file)))
+        {
+            LogError("Cannot size %s to %lu bytes: %lu", file_path, (unsigned long)size, (unsigned long)GetLastError());
+            (void)CloseHandle(result->file);
+            free(result);
+            result = NULL;
+        }
+        else if ((result->mapping = CreateFileMappingA(result->file, NULL, PAGE_READWRITE, (DWORD)(wanted_size.QuadPart >> 32), (DWORD)wanted_size.QuadPart, NULL)) == NULL)
+        {
+            LogError("Cannot create the mapping of %s: %lu", file_path, (unsigned long)GetLastError());
+            (void)CloseHandle(result->file);
+            free(result);
+            result = NULL;
+        }
+        else if ((result->address = (unsigned char*)MapViewOfFile(result->mapping, FILE_MAP_ALL_ACCESS, 0, 0, size)) == NULL)
+        {
+            LogError("Cannot map %s: %lu", file_path, (unsigned long)GetLastError());
+            (void)CloseHandle(result->mapping);
+            (void)CloseHandle(result->file);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result->size = size;
+            *created = (file_size.QuadPart == 0);
+        }
+    }
+
+    return result;
+}
+
+void file_mapping_close(FILE_MAPPING_HANDLE file_mapping)
+{
+    if (file_mapping == NULL)
+    {
+        LogError("NULL file_mapping");
+    }
+    else
+    {
+        if (!UnmapViewOfFile(file_mapping->address))
+        {
+            LogError("UnmapViewOfFile failed: %lu", (unsigned long)GetLastError());
+        }
+
+        (void)CloseHandle(file_mapping->mapping);
+        (void)CloseHandle(file_mapping->file);
+        free(file_mapping);
+    }
+}
+
+unsigned char* file_mapping_get_address(FILE_MAPPING_HANDLE file_mapping)
+{
+    unsigned char* result;
+
+    if (file_mapping == NULL)
+    {
+        LogError("NULL file_mapping");
+        result = NULL;
+    }
+    else
+    {
+        result = file_mapping->address;
+    }
+
+    return result;
+}
+
+int file_mapping_flush(FILE_MAPPING_HANDLE file_mapping, size_t offset, size_t size)
+{
+    int result;
+
+    if ((file_mapping == NULL) || (offset > file_mapping->size) || (size > file_mapping->size - offset))
+    {
+        LogError("Invalid arguments: file_mapping = %p, offset = %lu, size = %lu", file_mapping, (unsigned long)offset, (unsigned long)size);
+        result = __FAILURE__;
+    }
+    /* FlushViewOfFile hands the pages to the file system, FlushFileBuffers waits for them to be on the disk */
+    else if (!FlushViewOfFile(file_mapping->address + offset, size) || !FlushFileBuffers(file_mapping->file))
+    {
+        LogError("Cannot flush the mapping: %lu", (unsigned long)GetLastError());
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
@@ -16,6 +16,10 @@
 #include "azure_c_shared_utility/threadapi.h"
 #include "azure_c_shared_utility/shared_util_options.h"
 
+#ifdef USE_HTTP_DECOMPRESSION
+#include "zlib.h"
+#endif
+
 #ifdef _MSC_VER
 #define snprintf _snprintf
 #endif
@@ -24,6 +28,7 @@
 /*Codes_SRS_HTTPAPI_COMPACT_21_002: [ The httpapi_compact shall support the http requests. ]*/
 /*Codes_SRS_HTTPAPI_COMPACT_21_003: [ The httpapi_compact shall return error codes defined by HTTPAPI_RESULT. ]*/
 #include "azure_c_shared_utility/httpapi.h"
+#include "azure_c_shared_utility/httpapi_compact.h"
 
 #define MAX_HOSTNAME     64
 #define TEMP_BUFFER_SIZE 1024
@@ -34,13 +39,60 @@
 #define MAX_CLOSE_RETRY   100
 /*Codes_SRS_HTTPAPI_COMPACT_21_079: [ The HTTPAPI_ExecuteRequest shall wait, at least, 20 seconds to send a buffer using the SSL connection. ]*/
 #define MAX_SEND_RETRY   200
-/*Codes_SRS_HTTPAPI_COMPACT_21_081: [ The HTTPAPI_ExecuteRequest shall try to read the message with the response up to 20 seconds. ]*/
+/*Codes_SRS_HTTPAPI_COMPACT_21_081: [ The HTTPAPI_ExecuteRequest shall try to read the message with the response while the host keeps sending bytes, giving up after 20 seconds without receiving any byte. ]*/
 #define MAX_RECEIVE_RETRY   200
-/*Codes_SRS_HTTPAPI_COMPACT_21_083: [ The HTTPAPI_ExecuteRequest shall wait, at least, 100 milliseconds between retries. ]*/
+/*Codes_SRS_HTTPAPI_COMPACT_21_083: [ The HTTPAPI_ExecuteRequest shall wait, at least, 100 milliseconds between the retries to open the connection and to send the request. ]*/
 #define RETRY_INTERVAL_IN_MICROSECONDS  100
 
+/*Codes_SRS_HTTPAPI_COMPACT_21_089: [ While receiving the response, the HTTPAPI_ExecuteRequest shall only wait when a call to xio_dowork brought no bytes, starting with 1 millisecond and doubling the wait up to 100 milliseconds. ]*/
+#define RECEIVE_FIRST_RETRY_INTERVAL_IN_MILLISECONDS    1
+#define RECEIVE_TIMEOUT_IN_MILLISECONDS                 (MAX_RECEIVE_RETRY * RETRY_INTERVAL_IN_MICROSECONDS)
+
+
 DEFINE_ENUM_STRINGS(HTTPAPI_RESULT, HTTPAPI_RESULT_VALUES)
 
+typedef enum RESPONSE_STATE_TAG
+{
+    RESPONSE_STATE_IDLE,
+    RESPONSE_STATE_STATUS_LINE,
+    RESPONSE_STATE_HEADERS,
+    RESPONSE_STATE_BODY,
+    RESPONSE_STATE_CHUNK_SIZE,
+    RESPONSE_STATE_CHUNK_DATA,
+    RESPONSE_STATE_CHUNK_END,
+    RESPONSE_STATE_TRAILER,
+    RESPONSE_STATE_COMPLETE,
+    RESPONSE_STATE_FAILED
+} RESPONSE_STATE;
+
+/*the response is parsed in on_bytes_received, as the bytes arrive, so nothing but the current line is buffered*/
+typedef struct HTTP_RESPONSE_PARSER_TAG
+{
+    RESPONSE_STATE          state;
+    HTTPAPI_RESULT          result;         /*the error to report once state is RESPONSE_STATE_FAILED*/
+    bool                    has_body;       /*false for the responses to HEAD*/
+    int                     status;
+    unsigned int*           statusCode;
+    HTTP_HEADERS_HANDLE     responseHeadersHandle;
+    BUFFER_HANDLE           responseContent;
+    HTTPAPI_WRITE_CONTENT   writeContent;
+    void*                   writeContentContext;
+    size_t                  content_length;
+    bool                    chunked;
+    bool                    connection_close;
+    size_t                  remaining;      /*bytes left in the body or in the current chunk*/
+#ifdef USE_HTTP_DECOMPRESSION
+    bool                    decode;         /*the content is gzip or deflate encoded, it is inflated as it arrives*/
+    bool                    inflater_initialized;
+    bool                    inflate_complete;
+    unsigned char           stream_header[2];   /*the first bytes of the content, that tell a zlib stream from a raw deflate one*/
+    size_t                  stream_header_length;
+    z_stream                inflater;
+#endif
+    size_t                  line_length;
+    char                    line[TEMP_BUFFER_SIZE];
+} HTTP_RESPONSE_PARSER;
+
 typedef struct HTTP_HANDLE_DATA_TAG
 {
     char*           certificate;
@@ -48,10 +100,17 @@ typedef struct HTTP_HANDLE_DATA_TAG
     char*           x509ClientPrivateKey;
     XIO_HANDLE      xio_handle;
     size_t          received_bytes_count;
-    unsigned char*  received_bytes;
     unsigned int    is_io_error : 1;
     unsigned int    is_connected : 1;
     unsigned int    send_completed : 1;
+#ifdef USE_HTTP_DECOMPRESSION
+    unsigned int    decompress_responses : 1;
+#endif
+    size_t          pipeline_depth;
+    HTTPAPI_PIPELINED_REQUEST* pipeline;    /*the batch of httpapi_compact_execute_pipelined_requests, NULL otherwise*/
+    size_t          pipeline_sent;          /*requests of the batch sent on the connection*/
+    size_t          pipeline_responded;     /*requests of the batch with a result, the response to the next one is being parsed*/
+    HTTP_RESPONSE_PARSER response;
 } HTTP_HANDLE_DATA;
 
 /*the following function does the same as sscanf(pos2, "%d", &sec)*/
@@ -239,10 +298,17 @@ HTTP_HANDLE HTTPAPI_CreateConnection(const char* hostName)
                 http_instance->is_connected = 0;
                 http_instance->is_io_error = 0;
                 http_instance->received_bytes_count = 0;
-                http_instance->received_bytes = NULL;
+                http_instance->response.state = RESPONSE_STATE_IDLE;
                 http_instance->certificate = NULL;
                 http_instance->x509ClientCertificate = NULL;
                 http_instance->x509ClientPrivateKey = NULL;
+#ifdef USE_HTTP_DECOMPRESSION
+                http_instance->decompress_responses = 0;
+#endif
+                http_instance->pipeline_depth = 1;
+                http_instance->pipeline = NULL;
+                http_instance->pipeline_sent = 0;
+                http_instance->pipeline_responded = 0;
             }
         }
     }
@@ -261,6 +327,44 @@ static void on_io_close_complete(void* context)
     }
 }
 
+static void CloseXIOConnection(HTTP_HANDLE_DATA* http_instance)
+{
+    http_instance->is_io_error = 0;
+    /*Codes_SRS_HTTPAPI_COMPACT_21_017: [ The HTTPAPI_CloseConnection shall close the connection previously created in HTTPAPI_ExecuteRequest. ]*/
+    if (xio_close(http_instance->xio_handle, on_io_close_complete, http_instance) != 0)
+    {
+        LogError("The SSL got error closing the connection");
+        /*Codes_SRS_HTTPAPI_COMPACT_21_087: [ If the xio return anything different than 0, the HTTPAPI_CloseConnection shall destroy the connection anyway. ]*/
+        http_instance->is_connected = 0;
+    }
+    else
+    {
+        /*Codes_SRS_HTTPAPI_COMPACT_21_084: [ The HTTPAPI_CloseConnection shall wait, at least, 10 seconds for the SSL close process. ]*/
+        int countRetry = MAX_CLOSE_RETRY;
+        while (http_instance->is_connected == 1)
+        {
+            xio_dowork(http_instance->xio_handle);
+            if ((countRetry--) < 0)
+            {
+                /*Codes_SRS_HTTPAPI_COMPACT_21_085: [ If the HTTPAPI_CloseConnection retries 10 seconds to close the connection without success, it shall destroy the connection anyway. ]*/
+                LogError("Close timeout. The SSL didn't close the connection");
+                http_instance->is_connected = 0;
+            }
+            else if (http_instance->is_io_error == 1)
+            {
+                LogError("The SSL got error closing the connection");
+                http_instance->is_connected = 0;
+            }
+            else if (http_instance->is_connected == 1)
+            {
+                LogInfo("Waiting for TLS close connection");
+                /*Codes_SRS_HTTPAPI_COMPACT_21_086: [ The HTTPAPI_CloseConnection shall wait, at least, 100 milliseconds between retries. ]*/
+                ThreadAPI_Sleep(RETRY_INTERVAL_IN_MICROSECONDS);
+            }
+        }
+    }
+}
+
 void HTTPAPI_CloseConnection(HTTP_HANDLE handle)
 {
     HTTP_HANDLE_DATA* http_instance = (HTTP_HANDLE_DATA*)handle;
@@ -271,40 +375,7 @@ void HTTPAPI_CloseConnection(HTTP_HANDLE handle)
         /*Codes_SRS_HTTPAPI_COMPACT_21_019: [ If there is no previous connection, the HTTPAPI_CloseConnection shall not do anything. ]*/
         if (http_instance->xio_handle != NULL)
         {
-            http_instance->is_io_error = 0;
-            /*Codes_SRS_HTTPAPI_COMPACT_21_017: [ The HTTPAPI_CloseConnection shall close the connection previously created in HTTPAPI_ExecuteRequest. ]*/
-            if (xio_close(http_instance->xio_handle, on_io_close_complete, http_instance) != 0)
-            {
-                LogError("The SSL got error closing the connection");
-                /*Codes_SRS_HTTPAPI_COMPACT_21_087: [ If the xio return anything different than 0, the HTTPAPI_CloseConnection shall destroy the connection anyway. ]*/
-                http_instance->is_connected = 0;
-            }
-            else
-            {
-                /*Codes_SRS_HTTPAPI_COMPACT_21_084: [ The HTTPAPI_CloseConnection shall wait, at least, 10 seconds for the SSL close process. ]*/
-                int countRetry = MAX_CLOSE_RETRY;
-                while (http_instance->is_connected == 1)
-                {
-                    xio_dowork(http_instance->xio_handle);
-                    if ((countRetry--) < 0)
-                    {
-                        /*Codes_SRS_HTTPAPI_COMPACT_21_085: [ If the HTTPAPI_CloseConnection retries 10 seconds to close the connection without success, it shall destroy the connection anyway. ]*/
-                        LogError("Close timeout. The SSL didn't close the connection");
-                        http_instance->is_connected = 0;
-                    }
-                    else if (http_instance->is_io_error == 1)
-                    {
-                        LogError("The SSL got error closing the connection");
-                        http_instance->is_connected = 0;
-                    }
-                    else if (http_instance->is_connected == 1)
-                    {
-                        LogInfo("Waiting for TLS close connection");
-                        /*Codes_SRS_HTTPAPI_COMPACT_21_086: [ The HTTPAPI_CloseConnection shall wait, at least, 100 milliseconds between retries. ]*/
-                        ThreadAPI_Sleep(RETRY_INTERVAL_IN_MICROSECONDS);
-                    }
-                }
-            }
+            CloseXIOConnection(http_instance);
             /*Codes_SRS_HTTPAPI_COMPACT_21_076: [ After close the connection, The HTTPAPI_CloseConnection shall destroy the connection previously created in HTTPAPI_CreateConnection. ]*/
             xio_destroy(http_instance->xio_handle);
         }
@@ -396,298 +467,622 @@ static int InternStrnicmp(const char* s1, const char* s2, size_t n)
     return result;
 }
 
-static void on_bytes_received(void* context, const unsigned char* buffer, size_t size)
+static void failResponse(HTTP_HANDLE_DATA* http_instance, HTTPAPI_RESULT result)
 {
-    unsigned char* new_received_bytes;
-    HTTP_HANDLE_DATA* http_instance = (HTTP_HANDLE_DATA*)context;
+    http_instance->response.state = RESPONSE_STATE_FAILED;
+    http_instance->response.result = result;
+}
 
-    if (http_instance != NULL)
+#ifdef USE_HTTP_DECOMPRESSION
+#define IS_CONTENT_DECODED(response) ((response)->decode)
+
+static int startContentDecoder(HTTP_RESPONSE_PARSER* response)
+{
+    int result;
+    unsigned int header = ((unsigned int)response->stream_header[0] << 8) | response->stream_header[1];
+    int windowBits;
+
+    response->inflater.zalloc = Z_NULL;
+    response->inflater.zfree = Z_NULL;
+    response->inflater.opaque = Z_NULL;
+    response->inflater.next_in = Z_NULL;
+    response->inflater.avail_in = 0;
+
+    /*Codes_SRS_HTTPAPI_COMPACT_01_016: [ A deflate content shall be inflated both as a zlib stream and as a raw deflate stream, told apart by its first two bytes. ]*/
+    if (((response->stream_header[0] == 0x1f) && (response->stream_header[1] == 0x8b)) ||
+        (((response->stream_header[0] & 0x0f) == Z_DEFLATED) && ((header % 31) == 0)))
+    {
+        /*15 + 32: the largest window, with a zlib (deflate) or a gzip header detected automatically*/
+        windowBits = 15 + 32;
+    }
+    else
     {
+        /*-15: the largest window, for the servers that send deflate without the zlib header*/
+        windowBits = -15;
+    }
 
-        if (buffer == NULL)
+    if (inflateInit2(&response->inflater, windowBits) != Z_OK)
+    {
+        LogError("unable to initialize the decoder of the response content");
+        result = __FAILURE__;
+    }
+    else
+    {
+        response->inflater_initialized = true;
+        result = 0;
+    }
+
+    return result;
+}
+
+static void stopContentDecoder(HTTP_RESPONSE_PARSER* response)
+{
+    if (response->inflater_initialized)
+    {
+        (void)inflateEnd(&response->inflater);
+        response->inflater_initialized = false;
+    }
+}
+
+/*inflates the content bytes and hands the decoded bytes over exactly like storeContent does for plain content*/
+static void inflateContent(HTTP_HANDLE_DATA* http_instance, const unsigned char* buffer, size_t size)
+{
+    HTTP_RESPONSE_PARSER* response = &http_instance->response;
+    unsigned char decoded[TEMP_BUFFER_SIZE];
+    int inflateResult = Z_OK;
+    bool isDecodedFull = false;
+
+    response->inflater.next_in = (Bytef*)buffer;
+    response->inflater.avail_in = (uInt)size;
+
+    /*what follows the end of the compressed stream is ignored; a full output block means that inflate may have more to give*/
+    while ((!response->inflate_complete) &&
+        (response->state != RESPONSE_STATE_FAILED) &&
+        (inflateResult == Z_OK) &&
+        ((response->inflater.avail_in > 0) || isDecodedFull))
+    {
+        size_t decodedSize;
+
+        response->inflater.next_out = decoded;
+        response->inflater.avail_out = (uInt)sizeof(decoded);
+        inflateResult = inflate(&response->inflater, Z_NO_FLUSH);
+        decodedSize = sizeof(decoded) - response->inflater.avail_out;
+        isDecodedFull = (response->inflater.avail_out == 0);
+
+        if ((inflateResult != Z_OK) && (inflateResult != Z_STREAM_END) && (inflateResult != Z_BUF_ERROR))
         {
-            http_instance->is_io_error = 1;
-            LogError("NULL pointer error");
+            /*Codes_SRS_HTTPAPI_COMPACT_01_004: [ If the content cannot be inflated, the HTTPAPI_ExecuteRequest shall return HTTPAPI_READ_DATA_FAILED. ]*/
+            LogError("unable to inflate the response content (%d)", inflateResult);
+            failResponse(http_instance, HTTPAPI_READ_DATA_FAILED);
         }
         else
         {
-            /* Here we got some bytes so we'll buffer them so the receive functions can consumer it */
-            new_received_bytes = (unsigned char*)realloc(http_instance->received_bytes, http_instance->received_bytes_count + size);
-            if (new_received_bytes == NULL)
+            response->inflate_complete = (inflateResult == Z_STREAM_END);
+
+            if (decodedSize == 0)
             {
-                http_instance->is_io_error = 1;
-                LogError("Error allocating memory for received data");
+                /*nothing to hand over*/
             }
-            else
+            else if (response->responseContent != NULL)
             {
-                http_instance->received_bytes = new_received_bytes;
-                if (memcpy(http_instance->received_bytes + http_instance->received_bytes_count, buffer, size) == NULL)
-                {
-                    http_instance->is_io_error = 1;
-                    LogError("Error copping received data to the HTTP bufffer");
-                }
-                else
+                /*the buffer doubles its capacity when it grows, so appending every decoded block is amortized*/
+                if (BUFFER_append_build(response->responseContent, decoded, decodedSize) != 0)
                 {
-                    http_instance->received_bytes_count += size;
+                    /*Codes_SRS_HTTPAPI_COMPACT_21_052: [ If any memory allocation get fail, the HTTPAPI_ExecuteRequest shall return HTTPAPI_ALLOC_FAILED. ]*/
+                    (void)BUFFER_unbuild(response->responseContent);
+                    failResponse(http_instance, HTTPAPI_ALLOC_FAILED);
                 }
             }
+            else if ((response->writeContent != NULL) &&
+                (response->writeContent(response->writeContentContext, decoded, decodedSize) != 0))
+            {
+                LogError("The HTTP response content could not be written");
+                failResponse(http_instance, HTTPAPI_READ_DATA_FAILED);
+            }
+            else
+            {
+                /*Codes_SRS_HTTPAPI_COMPACT_21_051: [ If the responseContent is NULL, the HTTPAPI_ExecuteRequest shall ignore any content in the response. ]*/
+            }
         }
     }
 }
 
-static void on_io_error(void* context)
+/*the decoder only starts once the first bytes of the content, which may come in different receives, tell the kind of stream*/
+static void decodeContent(HTTP_HANDLE_DATA* http_instance, const unsigned char* buffer, size_t size)
 {
-    HTTP_HANDLE_DATA* http_instance = (HTTP_HANDLE_DATA*)context;
-    if (http_instance != NULL)
+    HTTP_RESPONSE_PARSER* response = &http_instance->response;
+
+    if (!response->inflater_initialized)
     {
-        http_instance->is_io_error = 1;
-        LogError("Error signalled by underlying IO");
+        size_t headerSize = sizeof(response->stream_header) - response->stream_header_length;
+        if (headerSize > size)
+        {
+            headerSize = size;
+        }
+
+        (void)memcpy(response->stream_header + response->stream_header_length, buffer, headerSize);
+        response->stream_header_length += headerSize;
+        buffer += headerSize;
+        size -= headerSize;
+
+        if (response->stream_header_length < sizeof(response->stream_header))
+        {
+            /*wait for the rest of the header*/
+        }
+        else if (startContentDecoder(response) != 0)
+        {
+            /*Codes_SRS_HTTPAPI_COMPACT_21_052: [ If any memory allocation get fail, the HTTPAPI_ExecuteRequest shall return HTTPAPI_ALLOC_FAILED. ]*/
+            failResponse(http_instance, HTTPAPI_ALLOC_FAILED);
+        }
+        else
+        {
+            inflateContent(http_instance, response->stream_header, sizeof(response->stream_header));
+        }
+    }
+
+    if (response->inflater_initialized && (size > 0))
+    {
+        inflateContent(http_instance, buffer, size);
     }
 }
+#else
+#define IS_CONTENT_DECODED(response) false
+#endif
 
-static int conn_receive(HTTP_HANDLE_DATA* http_instance, char* buffer, int count)
+/*appends the received bytes up to the next '\n' to the current line and returns how many bytes were consumed.
+When the line is complete it is NUL terminated, without its CR LF, and isLineComplete is set.*/
+static size_t readLine(HTTP_HANDLE_DATA* http_instance, const unsigned char* buffer, size_t size, bool* isLineComplete)
 {
-    int result;
+    HTTP_RESPONSE_PARSER* response = &http_instance->response;
+    const unsigned char* lineFeed = (const unsigned char*)memchr(buffer, '\n', size);
+    size_t length = (lineFeed == NULL) ? size : (size_t)(lineFeed - buffer);
+    size_t result;
 
-    if ((http_instance == NULL) || (buffer == NULL) || (count < 0))
+    *isLineComplete = false;
+    if (response->line_length + length >= sizeof(response->line))
     {
-        LogError("conn_receive: %s", ((http_instance == NULL) ? "Invalid HTTP instance" : "Invalid HTTP buffer"));
-        result = -1;
+        /*Codes_SRS_HTTPAPI_COMPACT_21_032: [ If the HTTPAPI_ExecuteRequest cannot read the message with the request result, it shall return HTTPAPI_READ_DATA_FAILED. ]*/
+        LogError("Received message is bigger than the http buffer");
+        failResponse(http_instance, HTTPAPI_READ_DATA_FAILED);
+        result = size;
     }
     else
     {
-        result = 0;
-        while (result < count)
-        {
-            xio_dowork(http_instance->xio_handle);
-
-            /* if any error was detected while receiving then simply break and report it */
-            if (http_instance->is_io_error != 0)
-            {
-                LogError("xio reported error on dowork");
-                result = -1;
-                break;
-            }
+        (void)memcpy(response->line + response->line_length, buffer, length);
+        response->line_length += length;
+        result = length;
 
-            if (http_instance->received_bytes_count >= (size_t)count)
+        if (lineFeed != NULL)
+        {
+            if ((response->line_length > 0) && (response->line[response->line_length - 1] == '\r'))
             {
-                /* Consuming bytes from the receive buffer */
-                (void)memcpy(buffer, http_instance->received_bytes, count);
-                (void)memmove(http_instance->received_bytes, http_instance->received_bytes + count, http_instance->received_bytes_count - count);
-                http_instance->received_bytes_count -= count;
-
-                /* we're not reallocating at each consumption so that we don't trash due to byte by byte consumption */
-                if (http_instance->received_bytes_count == 0)
-                {
-                    free(http_instance->received_bytes);
-                    http_instance->received_bytes = NULL;
-                }
-
-                result = count;
-                break;
+                response->line_length--;
             }
-
-            /*Codes_SRS_HTTPAPI_COMPACT_21_083: [ The HTTPAPI_ExecuteRequest shall wait, at least, 100 milliseconds between retries. ]*/
-            ThreadAPI_Sleep(RETRY_INTERVAL_IN_MICROSECONDS);
+            response->line[response->line_length] = '\0';
+            response->line_length = 0;
+            *isLineComplete = true;
+            result++;
         }
     }
 
     return result;
 }
 
-static void conn_receive_discard_buffer(HTTP_HANDLE_DATA* http_instance)
+/*Codes_SRS_HTTPAPI_COMPACT_21_073: [ The message received by the HTTPAPI_ExecuteRequest shall starts with a valid header. ]*/
+static void onStatusLine(HTTP_HANDLE_DATA* http_instance)
 {
-    if (http_instance != NULL)
+    HTTP_RESPONSE_PARSER* response = &http_instance->response;
+
+    if (ParseHttpResponse(response->line, &response->status) != 1)
+    {
+        //Cannot match string, error
+        /*Codes_SRS_HTTPAPI_COMPACT_21_055: [ If the HTTPAPI_ExecuteRequest cannot parser the received message, it shall return HTTPAPI_RECEIVE_RESPONSE_FAILED. ]*/
+        LogInfo("Not a correct HTTP answer");
+        failResponse(http_instance, HTTPAPI_RECEIVE_RESPONSE_FAILED);
+    }
+    else
     {
-        if (http_instance->received_bytes != NULL)
+        /*Codes_SRS_HTTPAPI_COMPACT_21_046: [ The HTTPAPI_ExecuteRequest shall return the http status reported by the host in the received response. ]*/
+        /*Codes_SRS_HTTPAPI_COMPACT_21_048: [ If the statusCode is NULL, the HTTPAPI_ExecuteRequest shall report not report any status. ]*/
+        if (response->statusCode != NULL)
         {
-            free(http_instance->received_bytes);
-            http_instance->received_bytes = NULL;
+            /*Codes_SRS_HTTPAPI_COMPACT_21_047: [ The HTTPAPI_ExecuteRequest shall report the status in the statusCode parameter. ]*/
+            *response->statusCode = (unsigned int)response->status;
         }
-        http_instance->received_bytes_count = 0;
+        response->state = RESPONSE_STATE_HEADERS;
     }
 }
 
-static int readLine(HTTP_HANDLE_DATA* http_instance, char* buf, const size_t maxBufSize)
+static void onHeadersComplete(HTTP_HANDLE_DATA* http_instance)
 {
-    int resultLineSize;
+    HTTP_RESPONSE_PARSER* response = &http_instance->response;
 
-    if ((http_instance == NULL) || (buf == NULL) || (maxBufSize == 0))
+    if ((response->status >= 100) && (response->status < 200))
+    {
+        /*Codes_SRS_HTTPAPI_COMPACT_21_092: [ The HTTPAPI_ExecuteRequest shall skip the interim 1xx responses and return the final response. ]*/
+        response->content_length = 0;
+        response->chunked = false;
+        response->connection_close = false;
+#ifdef USE_HTTP_DECOMPRESSION
+        response->decode = false;
+#endif
+        response->state = RESPONSE_STATE_STATUS_LINE;
+    }
+    /*Codes_SRS_HTTPAPI_COMPACT_42_088: [ The message received by the HTTPAPI_ExecuteRequest should not contain http body. ]*/
+    /*Codes_SRS_HTTPAPI_COMPACT_21_091: [ The responses with status 204 or 304 shall not contain http body. ]*/
+    else if ((!response->has_body) || (response->status == 204) || (response->status == 304))
+    {
+        response->state = RESPONSE_STATE_COMPLETE;
+    }
+    /*Codes_SRS_HTTPAPI_COMPACT_21_075: [ The message received by the HTTPAPI_ExecuteRequest can contain a body with the message content. ]*/
+    else if (response->chunked)
     {
-        LogError("%s", ((http_instance == NULL) ? "Invalid HTTP instance" : "Invalid HTTP buffer"));
-        resultLineSize = -1;
+        response->state = RESPONSE_STATE_CHUNK_SIZE;
+    }
+    else if (response->content_length == 0)
+    {
+        /*Codes_SRS_HTTPAPI_COMPACT_21_033: [ If the whole process succeed, the HTTPAPI_ExecuteRequest shall retur HTTPAPI_OK. ]*/
+        response->state = RESPONSE_STATE_COMPLETE;
+    }
+    /*the decoded content has no known length, it is appended as it is inflated*/
+    else if ((response->responseContent != NULL) && !IS_CONTENT_DECODED(response) &&
+        (BUFFER_pre_build(response->responseContent, response->content_length) != 0))
+    {
+        /*Codes_SRS_HTTPAPI_COMPACT_21_052: [ If any memory allocation get fail, the HTTPAPI_ExecuteRequest shall return HTTPAPI_ALLOC_FAILED. ]*/
+        failResponse(http_instance, HTTPAPI_ALLOC_FAILED);
     }
     else
     {
-        char* destByte = buf;
-        /*Codes_SRS_HTTPAPI_COMPACT_21_081: [ The HTTPAPI_ExecuteRequest shall try to read the message with the response up to 20 seconds. ]*/
-        int countRetry = MAX_RECEIVE_RETRY;
-        bool endOfSearch = false;
-        resultLineSize = -1;
-        while (!endOfSearch)
-        {
-            xio_dowork(http_instance->xio_handle);
+        response->remaining = response->content_length;
+        response->state = RESPONSE_STATE_BODY;
+    }
+}
 
-            /* if any error was detected while receiving then simply break and report it */
-            if (http_instance->is_io_error != 0)
+/*Codes_SRS_HTTPAPI_COMPACT_21_074: [ After the header, the message received by the HTTPAPI_ExecuteRequest can contain addition information about the content. ]*/
+static void onHeaderLine(HTTP_HANDLE_DATA* http_instance)
+{
+    HTTP_RESPONSE_PARSER* response = &http_instance->response;
+    char* buf = response->line;
+    const char* substr;
+    int lengthInMsg;
+    const char ContentLength[] = "content-length:";
+    const size_t ContentLengthSize = sizeof(ContentLength) - 1;
+    const char TransferEncoding[] = "transfer-encoding:";
+    const size_t TransferEncodingSize = sizeof(TransferEncoding) - 1;
+    const char Chunked[] = "chunked";
+    const size_t ChunkedSize = sizeof(Chunked) - 1;
+    const char Connection[] = "connection:";
+    const size_t ConnectionSize = sizeof(Connection) - 1;
+    const char Close[] = "close";
+    const size_t CloseSize = sizeof(Close) - 1;
+#ifdef USE_HTTP_DECOMPRESSION
+    const char ContentEncoding[] = "content-encoding:";
+    const size_t ContentEncodingSize = sizeof(ContentEncoding) - 1;
+#endif
+
+    if (*buf == '\0')
+    {
+        onHeadersComplete(http_instance);
+    }
+    else
+    {
+        if (InternStrnicmp(buf, ContentLength, ContentLengthSize) == 0)
+        {
+            substr = buf + ContentLengthSize;
+            if ((ParseStringToDecimal(substr, &lengthInMsg) != 1) || (lengthInMsg < 0))
             {
-                LogError("xio reported error on dowork");
-                endOfSearch = true;
+                /*Codes_SRS_HTTPAPI_COMPACT_21_032: [ If the HTTPAPI_ExecuteRequest cannot read the message with the request result, it shall return HTTPAPI_READ_DATA_FAILED. ]*/
+                failResponse(http_instance, HTTPAPI_READ_DATA_FAILED);
             }
             else
             {
-                unsigned char* receivedByte = http_instance->received_bytes;
-                while (receivedByte < (http_instance->received_bytes + http_instance->received_bytes_count))
-                {
-                    if ((*receivedByte) != '\r')
-                    {
-                        (*destByte) = (*receivedByte);
-                        destByte++;
-                        receivedByte++;
-
-                        if (destByte >= (buf + maxBufSize - 1))
-                        {
-                            LogError("Received message is bigger than the http buffer");
-                            receivedByte = http_instance->received_bytes + http_instance->received_bytes_count;
-                            endOfSearch = true;
-                            break;
-                        }
-                    }
-                    else
-                    {
-                        receivedByte++;
-                        if ((receivedByte < (http_instance->received_bytes + http_instance->received_bytes_count)) && ((*receivedByte) == '\n'))
-                        {
-                            receivedByte++;
-                        }
-                        (*destByte) = '\0';
-                        resultLineSize = (int)(destByte - buf);
-                        endOfSearch = true;
-                        break;
-                    }
-                }
+                response->content_length = (size_t)lengthInMsg;
+            }
+        }
+        else if (InternStrnicmp(buf, TransferEncoding, TransferEncodingSize) == 0)
+        {
+            substr = buf + TransferEncodingSize;
 
-                http_instance->received_bytes_count -= (receivedByte - http_instance->received_bytes);
-                if (http_instance->received_bytes_count != 0)
-                {
-                    (void)memmove(http_instance->received_bytes, receivedByte, http_instance->received_bytes_count);
-                }
-                else
-                {
-                    conn_receive_discard_buffer(http_instance);
-                }
+            while (isspace(*substr)) substr++;
+
+            if (InternStrnicmp(substr, Chunked, ChunkedSize) == 0)
+            {
+                response->chunked = true;
             }
+        }
+        else if (InternStrnicmp(buf, Connection, ConnectionSize) == 0)
+        {
+            substr = buf + ConnectionSize;
+
+            while (isspace(*substr)) substr++;
 
-            if (!endOfSearch)
+            if (InternStrnicmp(substr, Close, CloseSize) == 0)
             {
-                if ((countRetry--) > 0)
-                {
-                    /*Codes_SRS_HTTPAPI_COMPACT_21_083: [ The HTTPAPI_ExecuteRequest shall wait, at least, 100 milliseconds between retries. ]*/
-                    ThreadAPI_Sleep(RETRY_INTERVAL_IN_MICROSECONDS);
-                }
-                else
-                {
-                    /*Codes_SRS_HTTPAPI_COMPACT_21_082: [ If the HTTPAPI_ExecuteRequest retries 20 seconds to receive the message without success, it shall fail and return HTTPAPI_READ_DATA_FAILED. ]*/
-                    LogError("Receive timeout. The HTTP request is incomplete");
-                    endOfSearch = true;
-                }
+                response->connection_close = true;
             }
         }
-    }
+#ifdef USE_HTTP_DECOMPRESSION
+        else if ((http_instance->decompress_responses != 0) &&
+            (InternStrnicmp(buf, ContentEncoding, ContentEncodingSize) == 0))
+        {
+            substr = buf + ContentEncodingSize;
+
+            while (isspace(*substr)) substr++;
 
-    return resultLineSize;
+            /*only what Accept-Encoding offered is decoded, any other encoding is reported as received*/
+            response->decode = ((InternStrnicmp(substr, "gzip", 4) == 0) || (InternStrnicmp(substr, "x-gzip", 6) == 0) || (InternStrnicmp(substr, "deflate", 7) == 0));
+        }
+#endif
+
+        /*Codes_SRS_HTTPAPI_COMPACT_21_049: [ If responseHeadersHandle is provide, the HTTPAPI_ExecuteRequest shall prepare a Response Header usign the HTTPHeaders_AppendHeaderLines. ]*/
+        if ((response->state != RESPONSE_STATE_FAILED) && (response->status >= 200) && (response->responseHeadersHandle != NULL))
+        {
+            /* the line is only parsed into name and value if the caller reads the headers */
+            (void)HTTPHeaders_AppendHeaderLines(response->responseHeadersHandle, buf, strlen(buf));
+        }
+    }
 }
 
-static int readChunk(HTTP_HANDLE_DATA* http_instance, char* buf, size_t size)
+static void onChunkSizeLine(HTTP_HANDLE_DATA* http_instance)
 {
-    int cur, offset;
+    HTTP_RESPONSE_PARSER* response = &http_instance->response;
+    size_t chunkSize;
+
+    if (ParseStringToHexadecimal(response->line, &chunkSize) != 1)     // chunkSize is length of next line (/r/n is not counted)
+    {
+        //Cannot match string, error
+        /*Codes_SRS_HTTPAPI_COMPACT_21_055: [ If the HTTPAPI_ExecuteRequest cannot parser the received message, it shall return HTTPAPI_RECEIVE_RESPONSE_FAILED. ]*/
+        failResponse(http_instance, HTTPAPI_RECEIVE_RESPONSE_FAILED);
+    }
+    else if (chunkSize == 0)
+    {
+        /*Codes_SRS_HTTPAPI_COMPACT_21_094: [ The trailer that follows the last chunk shall be ignored. ]*/
+        response->state = RESPONSE_STATE_TRAILER;
+    }
+    else if ((response->responseContent != NULL) && !IS_CONTENT_DECODED(response) &&
+        (BUFFER_enlarge(response->responseContent, chunkSize) != 0))
+    {
+        (void)BUFFER_unbuild(response->responseContent);
 
-    // read content with specified length, even if it is received
-    // only in chunks due to fragmentation in the networking layer.
-    // returns -1 in case of error.
-    offset = 0;
-    while (size > (size_t)0)
+        /*Codes_SRS_HTTPAPI_COMPACT_21_052: [ If any memory allocation get fail, the HTTPAPI_ExecuteRequest shall return HTTPAPI_ALLOC_FAILED. ]*/
+        failResponse(http_instance, HTTPAPI_ALLOC_FAILED);
+    }
+    else
     {
-        cur = conn_receive(http_instance, buf + offset, (int)size);
+        response->remaining = chunkSize;
+        response->state = RESPONSE_STATE_CHUNK_DATA;
+    }
+}
+
+static void onLine(HTTP_HANDLE_DATA* http_instance)
+{
+    HTTP_RESPONSE_PARSER* response = &http_instance->response;
 
-        // end of stream reached
-        if (cur == 0)
+    switch (response->state)
+    {
+    case RESPONSE_STATE_STATUS_LINE:
+        onStatusLine(http_instance);
+        break;
+    case RESPONSE_STATE_HEADERS:
+        onHeaderLine(http_instance);
+        break;
+    case RESPONSE_STATE_CHUNK_SIZE:
+        onChunkSizeLine(http_instance);
+        break;
+    case RESPONSE_STATE_CHUNK_END:
+        if (response->line[0] != '\0')
+        {
+            /*Codes_SRS_HTTPAPI_COMPACT_21_032: [ If the HTTPAPI_ExecuteRequest cannot read the message with the request result, it shall return HTTPAPI_READ_DATA_FAILED. ]*/
+            failResponse(http_instance, HTTPAPI_READ_DATA_FAILED);
+        }
+        else
         {
-            break;
+            response->state = RESPONSE_STATE_CHUNK_SIZE;
         }
+        break;
+    case RESPONSE_STATE_TRAILER:
+        if (response->line[0] == '\0')
+        {
+            response->state = RESPONSE_STATE_COMPLETE;
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+/*stores the body bytes that belong to the content (or to the current chunk) and returns how many were consumed*/
+static size_t storeContent(HTTP_HANDLE_DATA* http_instance, const unsigned char* buffer, size_t size)
+{
+    HTTP_RESPONSE_PARSER* response = &http_instance->response;
+    size_t length = (size < response->remaining) ? size : response->remaining;
+
+#ifdef USE_HTTP_DECOMPRESSION
+    if (response->decode)
+    {
+        /*Codes_SRS_HTTPAPI_COMPACT_01_003: [ If decompression is enabled and the response has a Content-Encoding of gzip or deflate, the HTTPAPI_ExecuteRequest shall inflate the content as it arrives and report the decoded content in responseContent or to writeContent. ]*/
+        decodeContent(http_instance, buffer, length);
+    }
+    else
+#endif
+    if (response->responseContent != NULL)
+    {
+        /*Codes_SRS_HTTPAPI_COMPACT_21_050: [ If there is a content in the response, the HTTPAPI_ExecuteRequest shall copy it in the responseContent buffer. ]*/
+        /*Codes_SRS_HTTPAPI_COMPACT_21_088: [ The HTTPAPI_ExecuteRequest shall parse the response as its bytes are received and copy the content directly in the responseContent buffer. ]*/
+        (void)memcpy(BUFFER_u_char(response->responseContent) + BUFFER_length(response->responseContent) - response->remaining, buffer, length);
+    }
+    else if ((response->writeContent != NULL) &&
+        (response->writeContent(response->writeContentContext, buffer, length) != 0))
+    {
+        LogError("The HTTP response content could not be written");
+        failResponse(http_instance, HTTPAPI_READ_DATA_FAILED);
+    }
+    /*Codes_SRS_HTTPAPI_COMPACT_21_051: [ If the responseContent is NULL, the HTTPAPI_ExecuteRequest shall ignore any content in the response. ]*/
 
-        // read cur bytes (might be less than requested)
-        size -= (size_t)cur;
-        offset += cur;
+    response->remaining -= length;
+    if ((response->remaining == 0) && (response->state != RESPONSE_STATE_FAILED))
+    {
+        response->state = (response->state == RESPONSE_STATE_BODY) ? RESPONSE_STATE_COMPLETE : RESPONSE_STATE_CHUNK_END;
     }
 
-    return offset;
+    return length;
 }
 
-static int skipN(HTTP_HANDLE_DATA* http_instance, size_t n)
+/*prepares on_bytes_received to parse the response to the request that is about to be sent*/
+static void StartResponse(HTTP_HANDLE_DATA* http_instance, bool hasBody, unsigned int* statusCode, HTTP_HEADERS_HANDLE responseHeadersHandle,
+    BUFFER_HANDLE responseContent, HTTPAPI_WRITE_CONTENT writeContent, void* writeContentContext)
 {
-    // read and abandon response content with specified length
-    // returns -1 in case of error.
+    HTTP_RESPONSE_PARSER* response = &http_instance->response;
+
+    response->has_body = hasBody;
+    response->status = 0;
+    response->statusCode = statusCode;
+    response->responseHeadersHandle = responseHeadersHandle;
+    response->responseContent = responseContent;
+    response->writeContent = writeContent;
+    response->writeContentContext = writeContentContext;
+    response->content_length = 0;
+    response->chunked = false;
+    response->connection_close = false;
+    response->remaining = 0;
+#ifdef USE_HTTP_DECOMPRESSION
+    response->decode = false;
+    response->inflater_initialized = false;
+    response->inflate_complete = false;
+    response->stream_header_length = 0;
+#endif
+    response->line_length = 0;
+    response->result = HTTPAPI_OK;
+    response->state = RESPONSE_STATE_STATUS_LINE;
+}
 
-    int result;
+/*the result of a response that is complete or failed*/
+static HTTPAPI_RESULT GetResponseResult(HTTP_RESPONSE_PARSER* response)
+{
+    HTTPAPI_RESULT result;
 
-    if (http_instance == NULL)
+#ifdef USE_HTTP_DECOMPRESSION
+    if ((response->state == RESPONSE_STATE_COMPLETE) &&
+        response->decode &&
+        (response->stream_header_length > 0) &&
+        !response->inflate_complete)
     {
-        LogError("Invalid HTTP instance");
-        result = -1;
+        /*Codes_SRS_HTTPAPI_COMPACT_01_004: [ If the content cannot be inflated, the HTTPAPI_ExecuteRequest shall return HTTPAPI_READ_DATA_FAILED. ]*/
+        LogError("The compressed HTTP response content is truncated");
+        result = HTTPAPI_READ_DATA_FAILED;
     }
     else
+#endif
+    if (response->state == RESPONSE_STATE_COMPLETE)
     {
-        /*Codes_SRS_HTTPAPI_COMPACT_21_081: [ The HTTPAPI_ExecuteRequest shall try to read the message with the response up to 20 seconds. ]*/
-        int countRetry = MAX_RECEIVE_RETRY;
-        result = (int)n;
-        while (n > 0)
-        {
-            xio_dowork(http_instance->xio_handle);
+        /*Codes_SRS_HTTPAPI_COMPACT_21_033: [ If the whole process succeed, the HTTPAPI_ExecuteRequest shall retur HTTPAPI_OK. ]*/
+        result = HTTPAPI_OK;
+    }
+    else
+    {
+        result = response->result;
+    }
 
-            /* if any error was detected while receiving then simply break and report it */
-            if (http_instance->is_io_error != 0)
-            {
-                LogError("xio reported error on dowork");
-                result = -1;
-                n = 0;
-            }
-            else
+    return result;
+}
+
+static void StartPipelinedResponse(HTTP_HANDLE_DATA* http_instance)
+{
+    HTTPAPI_PIPELINED_REQUEST* request = &http_instance->pipeline[http_instance->pipeline_responded];
+
+    StartResponse(http_instance, (request->requestType != HTTPAPI_REQUEST_HEAD), request->statusCode, request->responseHeadersHandle, request->responseContent, NULL, NULL);
+}
+
+/*gives its result to the oldest request of the batch waiting for one, and has the parser wait for the response to the next request if it was sent*/
+static void CompletePipelinedResponse(HTTP_HANDLE_DATA* http_instance, HTTPAPI_RESULT result)
+{
+    http_instance->pipeline[http_instance->pipeline_responded].result = result;
+#ifdef USE_HTTP_DECOMPRESSION
+    stopContentDecoder(&http_instance->response);
+#endif
+    http_instance->pipeline_responded++;
+
+    if (http_instance->pipeline_responded < http_instance->pipeline_sent)
+    {
+        StartPipelinedResponse(http_instance);
+    }
+    else
+    {
+        http_instance->response.state = RESPONSE_STATE_IDLE;
+    }
+}
+
+static void on_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    HTTP_HANDLE_DATA* http_instance = (HTTP_HANDLE_DATA*)context;
+
+    if (http_instance != NULL)
+    {
+
+        if (buffer == NULL)
+        {
+            http_instance->is_io_error = 1;
+            LogError("NULL pointer error");
+        }
+        else
+        {
+            http_instance->received_bytes_count += size;
+
+            while (size > 0)
             {
-                if (http_instance->received_bytes_count <= n)
-                {
-                    n -= http_instance->received_bytes_count;
-                    http_instance->received_bytes_count = 0;
-                }
-                else
-                {
-                    http_instance->received_bytes_count -= n;
-                    (void)memmove(http_instance->received_bytes, http_instance->received_bytes + n, http_instance->received_bytes_count);
-                    n = 0;
-                }
+                size_t consumed;
+                bool isLineComplete;
 
-                if (n > 0)
+                switch (http_instance->response.state)
                 {
-                    if ((countRetry--) > 0)
+                case RESPONSE_STATE_STATUS_LINE:
+                case RESPONSE_STATE_HEADERS:
+                case RESPONSE_STATE_CHUNK_SIZE:
+                case RESPONSE_STATE_CHUNK_END:
+                case RESPONSE_STATE_TRAILER:
+                    consumed = readLine(http_instance, buffer, size, &isLineComplete);
+                    if (isLineComplete)
                     {
-                        /*Codes_SRS_HTTPAPI_COMPACT_21_083: [ The HTTPAPI_ExecuteRequest shall wait, at least, 100 milliseconds between retries. ]*/
-                        ThreadAPI_Sleep(RETRY_INTERVAL_IN_MICROSECONDS);
-                    }
-                    else
-                    {
-                        /*Codes_SRS_HTTPAPI_COMPACT_21_082: [ If the HTTPAPI_ExecuteRequest retries 20 seconds to receive the message without success, it shall fail and return HTTPAPI_READ_DATA_FAILED. ]*/
-                        LogError("Receive timeout. The HTTP request is incomplete");
-                        n = 0;
-                        result = -1;
+                        onLine(http_instance);
                     }
+                    break;
+                case RESPONSE_STATE_BODY:
+                case RESPONSE_STATE_CHUNK_DATA:
+                    consumed = storeContent(http_instance, buffer, size);
+                    break;
+                default:
+                    /*no response is expected, or it is already complete or failed*/
+                    LogInfo("Discarding %lu bytes received outside of a response", (unsigned long)size);
+                    consumed = size;
+                    break;
+                }
+
+                buffer += consumed;
+                size -= consumed;
+
+                /*Codes_SRS_HTTPAPI_COMPACT_01_008: [ The responses shall be matched to the pipelined requests in the order the requests were sent. ]*/
+                if ((http_instance->pipeline != NULL) &&
+                    (http_instance->response.state == RESPONSE_STATE_COMPLETE) &&
+                    !http_instance->response.connection_close &&
+                    (http_instance->pipeline_responded + 1 < http_instance->pipeline_sent))
+                {
+                    /*the rest of the bytes belongs to the response to the next request*/
+                    CompletePipelinedResponse(http_instance, GetResponseResult(&http_instance->response));
                 }
             }
         }
     }
-
-    return result;
 }
 
+static void on_io_error(void* context)
+{
+    HTTP_HANDLE_DATA* http_instance = (HTTP_HANDLE_DATA*)context;
+    if (http_instance != NULL)
+    {
+        http_instance->is_io_error = 1;
+        LogError("Error signalled by underlying IO");
+    }
+}
 
 /*Codes_SRS_HTTPAPI_COMPACT_21_021: [ The HTTPAPI_ExecuteRequest shall execute the http communtication with the provided host, sending a request and reciving the response. ]*/
 static HTTPAPI_RESULT OpenXIOConnection(HTTP_HANDLE_DATA* http_instance)
@@ -756,7 +1151,7 @@ static HTTPAPI_RESULT OpenXIOConnection(HTTP_HANDLE_DATA* http_instance)
                     }
                     else
                     {
-                        /*Codes_SRS_HTTPAPI_COMPACT_21_083: [ The HTTPAPI_ExecuteRequest shall wait, at least, 100 milliseconds between retries. ]*/
+                        /*Codes_SRS_HTTPAPI_COMPACT_21_083: [ The HTTPAPI_ExecuteRequest shall wait, at least, 100 milliseconds between the retries to open the connection and to send the request. ]*/
                         ThreadAPI_Sleep(RETRY_INTERVAL_IN_MICROSECONDS);
                     }
                 }
@@ -807,7 +1202,7 @@ static HTTPAPI_RESULT conn_send_all(HTTP_HANDLE_DATA* http_instance, const unsig
             }
             else
             {
-                /*Codes_SRS_HTTPAPI_COMPACT_21_083: [ The HTTPAPI_ExecuteRequest shall wait, at least, 100 milliseconds between retries. ]*/
+                /*Codes_SRS_HTTPAPI_COMPACT_21_083: [ The HTTPAPI_ExecuteRequest shall wait, at least, 100 milliseconds between the retries to open the connection and to send the request. ]*/
                 ThreadAPI_Sleep(RETRY_INTERVAL_IN_MICROSECONDS);
             }
         }
@@ -863,6 +1258,17 @@ static HTTPAPI_RESULT SendHeadsToXIO(HTTP_HANDLE_DATA* http_instance, HTTPAPI_RE
             }
         }
 
+#ifdef USE_HTTP_DECOMPRESSION
+        /*Codes_SRS_HTTPAPI_COMPACT_01_002: [ If decompression is enabled and httpHeadersHandle has no Accept-Encoding header, the HTTPAPI_ExecuteRequest shall send `Accept-Encoding: gzip, deflate`. ]*/
+        if ((result == HTTPAPI_OK) &&
+            (http_instance->decompress_responses != 0) &&
+            (HTTPHeaders_FindHeaderValue(httpHeadersHandle, "Accept-Encoding") == NULL))
+        {
+            const char AcceptEncoding[] = "Accept-Encoding: gzip, deflate\r\n";
+            result = conn_send_all(http_instance, (const unsigned char*)AcceptEncoding, sizeof(AcceptEncoding) - 1);
+        }
+#endif
+
         //Close headers
         if (result == HTTPAPI_OK)
         {
@@ -893,260 +1299,84 @@ static HTTPAPI_RESULT SendContentToXIO(HTTP_HANDLE_DATA* http_instance, const un
     return result;
 }
 
-/*Codes_SRS_HTTPAPI_COMPACT_21_030: [ At the end of the transmission, the HTTPAPI_ExecuteRequest shall receive the response from the host. ]*/
-static HTTPAPI_RESULT ReceiveHeaderFromXIO(HTTP_HANDLE_DATA* http_instance, unsigned int* statusCode)
+static HTTPAPI_RESULT SendStreamedContentToXIO(HTTP_HANDLE_DATA* http_instance, size_t contentLength, HTTPAPI_READ_CONTENT readContent, void* readContentContext)
 {
-    HTTPAPI_RESULT result;
-    char    buf[TEMP_BUFFER_SIZE];
-    int     ret;
-
-    http_instance->is_io_error = 0;
+    HTTPAPI_RESULT result = HTTPAPI_OK;
+    unsigned char buf[TEMP_BUFFER_SIZE];
 
-    //Receive response
-    if (readLine(http_instance, buf, TEMP_BUFFER_SIZE) < 0)
+    while ((contentLength > 0) && (result == HTTPAPI_OK))
     {
-        /*Codes_SRS_HTTPAPI_COMPACT_21_032: [ If the HTTPAPI_ExecuteRequest cannot read the message with the request result, it shall return HTTPAPI_READ_DATA_FAILED. ]*/
-        /*Codes_SRS_HTTPAPI_COMPACT_21_082: [ If the HTTPAPI_ExecuteRequest retries 20 seconds to receive the message without success, it shall fail and return HTTPAPI_READ_DATA_FAILED. ]*/
-        result = HTTPAPI_READ_DATA_FAILED;
-    }
-    //Parse HTTP response
-    else if (ParseHttpResponse(buf, &ret) != 1)
-    {
-        //Cannot match string, error
-        /*Codes_SRS_HTTPAPI_COMPACT_21_055: [ If the HTTPAPI_ExecuteRequest cannot parser the received message, it shall return HTTPAPI_RECEIVE_RESPONSE_FAILED. ]*/
-        LogInfo("Not a correct HTTP answer");
-        result = HTTPAPI_RECEIVE_RESPONSE_FAILED;
-    }
-    else
-    {
-        /*Codes_SRS_HTTPAPI_COMPACT_21_046: [ The HTTPAPI_ExecuteRequest shall return the http status reported by the host in the received response. ]*/
-        /*Codes_SRS_HTTPAPI_COMPACT_21_048: [ If the statusCode is NULL, the HTTPAPI_ExecuteRequest shall report not report any status. ]*/
-        if (statusCode)
+        size_t bytesRead = 0;
+        if ((readContent(readContentContext, buf, (contentLength < sizeof(buf)) ? contentLength : sizeof(buf), &bytesRead) != 0) ||
+            (bytesRead == 0) ||
+            (bytesRead > contentLength))
         {
-            /*Codes_SRS_HTTPAPI_COMPACT_21_047: [ The HTTPAPI_ExecuteRequest shall report the status in the statusCode parameter. ]*/
-            *statusCode = ret;
+            LogError("The HTTP request content could not be read");
+            result = HTTPAPI_ERROR;
         }
-        /*Codes_SRS_HTTPAPI_COMPACT_21_033: [ If the whole process succeed, the HTTPAPI_ExecuteRequest shall retur HTTPAPI_OK. ]*/
-        result = HTTPAPI_OK;
-    }
-
-    return result;
-}
-
-static HTTPAPI_RESULT ReceiveContentInfoFromXIO(HTTP_HANDLE_DATA* http_instance, HTTP_HEADERS_HANDLE responseHeadersHandle, size_t* bodyLength, bool* chunked)
-{
-    HTTPAPI_RESULT result;
-    char    buf[TEMP_BUFFER_SIZE];
-    const char* substr;
-    char* whereIsColon;
-    int lengthInMsg;
-    const char ContentLength[] = "content-length:";
-    const size_t ContentLengthSize = sizeof(ContentLength) - 1;
-    const char TransferEncoding[] = "transfer-encoding:";
-    const size_t TransferEncodingSize = sizeof(TransferEncoding) - 1;
-    const char Chunked[] = "chunked";
-    const size_t ChunkedSize = sizeof(Chunked) - 1;
-
-    http_instance->is_io_error = 0;
-
-    //Read HTTP response headers
-    if (readLine(http_instance, buf, sizeof(buf)) < 0)
-    {
-        /*Codes_SRS_HTTPAPI_COMPACT_21_032: [ If the HTTPAPI_ExecuteRequest cannot read the message with the request result, it shall return HTTPAPI_READ_DATA_FAILED. ]*/
-        /*Codes_SRS_HTTPAPI_COMPACT_21_082: [ If the HTTPAPI_ExecuteRequest retries 20 seconds to receive the message without success, it shall fail and return HTTPAPI_READ_DATA_FAILED. ]*/
-        result = HTTPAPI_READ_DATA_FAILED;
-    }
-    else
-    {
-        /*Codes_SRS_HTTPAPI_COMPACT_21_033: [ If the whole process succeed, the HTTPAPI_ExecuteRequest shall retur HTTPAPI_OK. ]*/
-        result = HTTPAPI_OK;
-
-        while (*buf && (result == HTTPAPI_OK))
+        else
         {
-            if (InternStrnicmp(buf, ContentLength, ContentLengthSize) == 0)
-            {
-                substr = buf + ContentLengthSize;
-                if (ParseStringToDecimal(substr, &lengthInMsg) != 1)
-                {
-                    /*Codes_SRS_HTTPAPI_COMPACT_21_032: [ If the HTTPAPI_ExecuteRequest cannot read the message with the request result, it shall return HTTPAPI_READ_DATA_FAILED. ]*/
-                    result = HTTPAPI_READ_DATA_FAILED;
-                }
-                else
-                {
-                    (*bodyLength) = (size_t)lengthInMsg;
-                }
-            }
-            else if (InternStrnicmp(buf, TransferEncoding, TransferEncodingSize) == 0)
-            {
-                substr = buf + TransferEncodingSize;
-
-                while (isspace(*substr)) substr++;
-
-                if (InternStrnicmp(substr, Chunked, ChunkedSize) == 0)
-                {
-                    (*chunked) = true;
-                }
-            }
-
-            if (result == HTTPAPI_OK)
-            {
-                whereIsColon = strchr((char*)buf, ':');
-                /*Codes_SRS_HTTPAPI_COMPACT_21_049: [ If responseHeadersHandle is provide, the HTTPAPI_ExecuteRequest shall prepare a Response Header usign the HTTPHeaders_AddHeaderNameValuePair. ]*/
-                if (whereIsColon && (responseHeadersHandle != NULL))
-                {
-                    *whereIsColon = '\0';
-                    HTTPHeaders_AddHeaderNameValuePair(responseHeadersHandle, buf, whereIsColon + 1);
-                }
-
-                if (readLine(http_instance, buf, sizeof(buf)) < 0)
-                {
-                    /*Codes_SRS_HTTPAPI_COMPACT_21_032: [ If the HTTPAPI_ExecuteRequest cannot read the message with the request result, it shall return HTTPAPI_READ_DATA_FAILED. ]*/
-                    /*Codes_SRS_HTTPAPI_COMPACT_21_082: [ If the HTTPAPI_ExecuteRequest retries 20 seconds to receive the message without success, it shall fail and return HTTPAPI_READ_DATA_FAILED. ]*/
-                    result = HTTPAPI_READ_DATA_FAILED;
-                }
-            }
+            result = conn_send_all(http_instance, buf, bytesRead);
+            contentLength -= bytesRead;
         }
     }
 
     return result;
 }
 
-static HTTPAPI_RESULT ReadHTTPResponseBodyFromXIO(HTTP_HANDLE_DATA* http_instance, size_t bodyLength, bool chunked, BUFFER_HANDLE responseContent)
+/*Codes_SRS_HTTPAPI_COMPACT_21_030: [ At the end of the transmission, the HTTPAPI_ExecuteRequest shall receive the response from the host. ]*/
+static HTTPAPI_RESULT ReceiveResponseFromXIO(HTTP_HANDLE_DATA* http_instance)
 {
     HTTPAPI_RESULT result;
-    char    buf[TEMP_BUFFER_SIZE];
-    const unsigned char* receivedContent;
+    HTTP_RESPONSE_PARSER* response = &http_instance->response;
+    /*Codes_SRS_HTTPAPI_COMPACT_21_081: [ The HTTPAPI_ExecuteRequest shall try to read the message with the response while the host keeps sending bytes, giving up after 20 seconds without receiving any byte. ]*/
+    unsigned int idleTime = 0;
+    unsigned int retryInterval = RECEIVE_FIRST_RETRY_INTERVAL_IN_MILLISECONDS;
+
+    while ((response->state != RESPONSE_STATE_COMPLETE) &&
+        (response->state != RESPONSE_STATE_FAILED) &&
+        (http_instance->is_io_error == 0))
+    {
+        size_t received_bytes_count = http_instance->received_bytes_count;
 
-    http_instance->is_io_error = 0;
+        xio_dowork(http_instance->xio_handle);
 
-    //Read HTTP response body
-    if (!chunked)
-    {
-        if (bodyLength)
+        if (http_instance->received_bytes_count != received_bytes_count)
         {
-            if (responseContent != NULL)
-            {
-                if (BUFFER_pre_build(responseContent, bodyLength) != 0)
-                {
-                    /*Codes_SRS_HTTPAPI_COMPACT_21_052: [ If any memory allocation get fail, the HTTPAPI_ExecuteRequest shall return HTTPAPI_ALLOC_FAILED. ]*/
-                    result = HTTPAPI_ALLOC_FAILED;
-                }
-                else if (BUFFER_content(responseContent, &receivedContent) != 0)
-                {
-                    (void)BUFFER_unbuild(responseContent);
-
-                    /*Codes_SRS_HTTPAPI_COMPACT_21_052: [ If any memory allocation get fail, the HTTPAPI_ExecuteRequest shall return HTTPAPI_ALLOC_FAILED. ]*/
-                    result = HTTPAPI_ALLOC_FAILED;
-                }
-                else if (readChunk(http_instance, (char*)receivedContent, bodyLength) < 0)
-                {
-                    /*Codes_SRS_HTTPAPI_COMPACT_21_032: [ If the HTTPAPI_ExecuteRequest cannot read the message with the request result, it shall return HTTPAPI_READ_DATA_FAILED. ]*/
-                    result = HTTPAPI_READ_DATA_FAILED;
-                }
-                else
-                {
-                    /*Codes_SRS_HTTPAPI_COMPACT_21_033: [ If the whole process succeed, the HTTPAPI_ExecuteRequest shall retur HTTPAPI_OK. ]*/
-                    result = HTTPAPI_OK;
-                }
-            }
-            else
-            {
-                /*Codes_SRS_HTTPAPI_COMPACT_21_051: [ If the responseContent is NULL, the HTTPAPI_ExecuteRequest shall ignore any content in the response. ]*/
-                if (skipN(http_instance, bodyLength) < 0)
-                {
-                    /*Codes_SRS_HTTPAPI_COMPACT_21_082: [ If the HTTPAPI_ExecuteRequest retries 20 seconds to receive the message without success, it shall fail and return HTTPAPI_READ_DATA_FAILED. ]*/
-                    result = HTTPAPI_READ_DATA_FAILED;
-                }
-                else
-                {
-                    result = HTTPAPI_OK;
-                }
-            }
+            /*the bytes are flowing, go on without waiting*/
+            idleTime = 0;
+            retryInterval = RECEIVE_FIRST_RETRY_INTERVAL_IN_MILLISECONDS;
+        }
+        else if ((http_instance->is_io_error != 0) || (response->state == RESPONSE_STATE_FAILED))
+        {
+            /*reported below*/
+        }
+        else if (idleTime >= RECEIVE_TIMEOUT_IN_MILLISECONDS)
+        {
+            /*Codes_SRS_HTTPAPI_COMPACT_21_082: [ If the HTTPAPI_ExecuteRequest receives no byte of the message for 20 seconds, it shall fail and return HTTPAPI_READ_DATA_FAILED. ]*/
+            LogError("Receive timeout. The HTTP request is incomplete");
+            failResponse(http_instance, HTTPAPI_READ_DATA_FAILED);
         }
         else
         {
-            /*Codes_SRS_HTTPAPI_COMPACT_21_033: [ If the whole process succeed, the HTTPAPI_ExecuteRequest shall retur HTTPAPI_OK. ]*/
-            result = HTTPAPI_OK;
+            /*Codes_SRS_HTTPAPI_COMPACT_21_089: [ While receiving the response, the HTTPAPI_ExecuteRequest shall only wait when a call to xio_dowork brought no bytes, starting with 1 millisecond and doubling the wait up to 100 milliseconds. ]*/
+            ThreadAPI_Sleep(retryInterval);
+            idleTime += retryInterval;
+            retryInterval = ((retryInterval * 2) < RETRY_INTERVAL_IN_MICROSECONDS) ? (retryInterval * 2) : RETRY_INTERVAL_IN_MICROSECONDS;
         }
     }
+
+    if ((response->state == RESPONSE_STATE_COMPLETE) || (response->state == RESPONSE_STATE_FAILED))
+    {
+        result = GetResponseResult(response);
+    }
     else
     {
-        size_t size = 0;
-        /*Codes_SRS_HTTPAPI_COMPACT_21_033: [ If the whole process succeed, the HTTPAPI_ExecuteRequest shall retur HTTPAPI_OK. ]*/
-        result = HTTPAPI_OK;
-        while (result == HTTPAPI_OK)
-        {
-            size_t chunkSize;
-            if (readLine(http_instance, buf, sizeof(buf)) < 0)    // read [length in hex]/r/n
-            {
-                /*Codes_SRS_HTTPAPI_COMPACT_21_032: [ If the HTTPAPI_ExecuteRequest cannot read the message with the request result, it shall return HTTPAPI_READ_DATA_FAILED. ]*/
-                /*Codes_SRS_HTTPAPI_COMPACT_21_082: [ If the HTTPAPI_ExecuteRequest retries 20 seconds to receive the message without success, it shall fail and return HTTPAPI_READ_DATA_FAILED. ]*/
-                result = HTTPAPI_READ_DATA_FAILED;
-            }
-            else if (ParseStringToHexadecimal(buf, &chunkSize) != 1)     // chunkSize is length of next line (/r/n is not counted)
-            {
-                //Cannot match string, error
-                /*Codes_SRS_HTTPAPI_COMPACT_21_055: [ If the HTTPAPI_ExecuteRequest cannot parser the received message, it shall return HTTPAPI_RECEIVE_RESPONSE_FAILED. ]*/
-                result = HTTPAPI_RECEIVE_RESPONSE_FAILED;
-            }
-            else if (chunkSize == 0)
-            {
-                // 0 length means next line is just '\r\n' and end of chunks
-                if (readChunk(http_instance, (char*)buf, (size_t)2) < 0
-                    || buf[0] != '\r' || buf[1] != '\n') // skip /r/n
-                {
-                    (void)BUFFER_unbuild(responseContent);
-
-                    result = HTTPAPI_READ_DATA_FAILED;
-                }
-                break;
-            }
-            else
-            {
-                if (responseContent != NULL)
-                {
-                    if (BUFFER_enlarge(responseContent, chunkSize) != 0)
-                    {
-                        (void)BUFFER_unbuild(responseContent);
-
-                        /*Codes_SRS_HTTPAPI_COMPACT_21_052: [ If any memory allocation get fail, the HTTPAPI_ExecuteRequest shall return HTTPAPI_ALLOC_FAILED. ]*/
-                        result = HTTPAPI_ALLOC_FAILED;
-                    }
-                    else if (BUFFER_content(responseContent, &receivedContent) != 0)
-                    {
-                        (void)BUFFER_unbuild(responseContent);
-
-                        /*Codes_SRS_HTTPAPI_COMPACT_21_052: [ If any memory allocation get fail, the HTTPAPI_ExecuteRequest shall return HTTPAPI_ALLOC_FAILED. ]*/
-                        result = HTTPAPI_ALLOC_FAILED;
-                    }
-                    else if (readChunk(http_instance, (char*)receivedContent + size, chunkSize) < 0)
-                    {
-                        result = HTTPAPI_READ_DATA_FAILED;
-                    }
-                }
-                else
-                {
-                    /*Codes_SRS_HTTPAPI_COMPACT_21_051: [ If the responseContent is NULL, the HTTPAPI_ExecuteRequest shall ignore any content in the response. ]*/
-                    if (skipN(http_instance, chunkSize) < 0)
-                    {
-                        /*Codes_SRS_HTTPAPI_COMPACT_21_082: [ If the HTTPAPI_ExecuteRequest retries 20 seconds to receive the message without success, it shall fail and return HTTPAPI_READ_DATA_FAILED. ]*/
-                        result = HTTPAPI_READ_DATA_FAILED;
-                    }
-                }
-
-                if (result == HTTPAPI_OK)
-                {
-                    if (readChunk(http_instance, (char*)buf, (size_t)2) < 0
-                        || buf[0] != '\r' || buf[1] != '\n') // skip /r/n
-                    {
-                        result = HTTPAPI_READ_DATA_FAILED;
-                    }
-                    size += chunkSize;
-                }
-            }
-        }
-
+        /*Codes_SRS_HTTPAPI_COMPACT_21_032: [ If the HTTPAPI_ExecuteRequest cannot read the message with the request result, it shall return HTTPAPI_READ_DATA_FAILED. ]*/
+        LogError("xio reported error on dowork");
+        result = HTTPAPI_READ_DATA_FAILED;
     }
+
     return result;
 }
 
@@ -1177,15 +1407,14 @@ static bool validRequestType(HTTPAPI_REQUEST_TYPE requestType)
 /*Codes_SRS_HTTPAPI_COMPACT_21_050: [ If there is a content in the response, the HTTPAPI_ExecuteRequest shall copy it in the responseContent buffer. ]*/
 //Note: This function assumes that "Host:" and "Content-Length:" headers are setup
 //      by the caller of HTTPAPI_ExecuteRequest() (which is true for httptransport.c).
-HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+//      readContent/writeContent are only used by HTTPAPI_ExecuteStreamingRequest, they replace content/responseContent.
+static HTTPAPI_RESULT ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
     HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content,
-    size_t contentLength, unsigned int* statusCode,
-    HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent)
+    size_t contentLength, HTTPAPI_READ_CONTENT readContent, void* readContentContext, unsigned int* statusCode,
+    HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent, HTTPAPI_WRITE_CONTENT writeContent, void* writeContentContext)
 {
     HTTPAPI_RESULT result = HTTPAPI_ERROR;
     size_t  headersCount;
-    size_t  bodyLength = 0;
-    bool    chunked = false;
     HTTP_HANDLE_DATA* http_instance = (HTTP_HANDLE_DATA*)handle;
 
     /*Codes_SRS_HTTPAPI_COMPACT_21_034: [ If there is no previous connection, the HTTPAPI_ExecuteRequest shall return HTTPAPI_INVALID_ARG. ]*/
@@ -1204,44 +1433,305 @@ HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE r
         result = HTTPAPI_INVALID_ARG;
         LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
     }
-    /*Codes_SRS_HTTPAPI_COMPACT_21_024: [ The HTTPAPI_ExecuteRequest shall open the transport connection with the host to send the request. ]*/
-    else if ((result = OpenXIOConnection(http_instance)) != HTTPAPI_OK)
+    else
     {
-        LogError("Open HTTP connection failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        if ((http_instance->is_connected != 0) && (http_instance->is_io_error != 0))
+        {
+            /*Codes_SRS_HTTPAPI_COMPACT_21_093: [ If the connection got an error while it was idle, the HTTPAPI_ExecuteRequest shall close it and open a new one. ]*/
+            LogInfo("The HTTP connection got an error, reopening it");
+            CloseXIOConnection(http_instance);
+        }
+
+        /*Codes_SRS_HTTPAPI_COMPACT_21_024: [ The HTTPAPI_ExecuteRequest shall open the transport connection with the host to send the request. ]*/
+        if ((result = OpenXIOConnection(http_instance)) != HTTPAPI_OK)
+        {
+            LogError("Open HTTP connection failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else
+        {
+            /*the response can start arriving while the request is still being sent*/
+            /*Codes_SRS_HTTPAPI_COMPACT_42_084: [ The message received by the HTTPAPI_ExecuteRequest should not contain http body. ]*/
+            StartResponse(http_instance, (requestType != HTTPAPI_REQUEST_HEAD), statusCode, responseHeadersHandle, responseContent, writeContent, writeContentContext);
+
+            /*Codes_SRS_HTTPAPI_COMPACT_21_026: [ If the open process succeed, the HTTPAPI_ExecuteRequest shall send the request message to the host. ]*/
+            if ((result = SendHeadsToXIO(http_instance, requestType, relativePath, httpHeadersHandle, headersCount)) != HTTPAPI_OK)
+            {
+                LogError("Send heads to HTTP failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            }
+            /*Codes_SRS_HTTPAPI_COMPACT_21_042: [ The request can contain the a content message, provided in content parameter. ]*/
+            else if ((readContent == NULL) && ((result = SendContentToXIO(http_instance, content, contentLength)) != HTTPAPI_OK))
+            {
+                LogError("Send content to HTTP failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            }
+            else if ((readContent != NULL) && ((result = SendStreamedContentToXIO(http_instance, contentLength, readContent, readContentContext)) != HTTPAPI_OK))
+            {
+                LogError("Send streamed content to HTTP failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            }
+            /*Codes_SRS_HTTPAPI_COMPACT_21_030: [ At the end of the transmission, the HTTPAPI_ExecuteRequest shall receive the response from the host. ]*/
+            else if ((result = ReceiveResponseFromXIO(http_instance)) != HTTPAPI_OK)
+            {
+                LogError("Receive response from HTTP failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            }
+            else if (http_instance->response.connection_close)
+            {
+                /*Codes_SRS_HTTPAPI_COMPACT_21_090: [ If the response contains the header `Connection: close`, the HTTPAPI_ExecuteRequest shall close the connection, and the next request shall open a new one. ]*/
+                CloseXIOConnection(http_instance);
+            }
+
+#ifdef USE_HTTP_DECOMPRESSION
+            stopContentDecoder(&http_instance->response);
+#endif
+            http_instance->response.state = RESPONSE_STATE_IDLE;
+        }
     }
-    /*Codes_SRS_HTTPAPI_COMPACT_21_026: [ If the open process succeed, the HTTPAPI_ExecuteRequest shall send the request message to the host. ]*/
-    else if ((result = SendHeadsToXIO(http_instance, requestType, relativePath, httpHeadersHandle, headersCount)) != HTTPAPI_OK)
+
+    return result;
+}
+
+HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content,
+    size_t contentLength, unsigned int* statusCode,
+    HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent)
+{
+    return ExecuteRequest(handle, requestType, relativePath, httpHeadersHandle, content, contentLength, NULL, NULL, statusCode, responseHeadersHandle, responseContent, NULL, NULL);
+}
+
+HTTPAPI_RESULT HTTPAPI_ExecuteStreamingRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE httpHeadersHandle, size_t contentLength,
+    HTTPAPI_READ_CONTENT readContent, void* readContentContext, unsigned int* statusCode,
+    HTTP_HEADERS_HANDLE responseHeadersHandle, HTTPAPI_WRITE_CONTENT writeContent, void* writeContentContext)
+{
+    HTTPAPI_RESULT result;
+
+    if ((readContent == NULL) && (contentLength > 0))
+    {
+        result = HTTPAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else
+    {
+        result = ExecuteRequest(handle, requestType, relativePath, httpHeadersHandle, NULL, contentLength, (contentLength > 0) ? readContent : NULL, readContentContext,
+            statusCode, responseHeadersHandle, NULL, writeContent, writeContentContext);
+    }
+
+    return result;
+}
+
+static bool isValidPipelinedRequest(const HTTPAPI_PIPELINED_REQUEST* request)
+{
+    size_t headersCount;
+
+    return ((request->relativePath != NULL) &&
+        (request->httpHeadersHandle != NULL) &&
+        validRequestType(request->requestType) &&
+        (HTTPHeaders_GetHeaderCount(request->httpHeadersHandle, &headersCount) == HTTP_HEADERS_OK));
+}
+
+/*the requests that the server may process twice without harm, RFC 7231 section 4.2.2*/
+static bool isIdempotentRequest(HTTPAPI_REQUEST_TYPE requestType)
+{
+    return ((requestType == HTTPAPI_REQUEST_GET) ||
+        (requestType == HTTPAPI_REQUEST_HEAD) ||
+        (requestType == HTTPAPI_REQUEST_PUT) ||
+        (requestType == HTTPAPI_REQUEST_DELETE));
+}
+
+/*after a response with `Connection: close`, or a failed one, nothing more can be sent on the connection*/
+#define IS_PIPELINE_BROKEN(response) ((((response)->state == RESPONSE_STATE_COMPLETE) && (response)->connection_close) || ((response)->state == RESPONSE_STATE_FAILED))
+
+static HTTPAPI_RESULT SendPipelinedRequest(HTTP_HANDLE_DATA* http_instance, const HTTPAPI_PIPELINED_REQUEST* request)
+{
+    HTTPAPI_RESULT result;
+    size_t headersCount;
+
+    if (HTTPHeaders_GetHeaderCount(request->httpHeadersHandle, &headersCount) != HTTP_HEADERS_OK)
+    {
+        result = HTTPAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else if ((result = SendHeadsToXIO(http_instance, request->requestType, request->relativePath, request->httpHeadersHandle, headersCount)) != HTTPAPI_OK)
     {
         LogError("Send heads to HTTP failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
     }
-    /*Codes_SRS_HTTPAPI_COMPACT_21_042: [ The request can contain the a content message, provided in content parameter. ]*/
-    else if ((result = SendContentToXIO(http_instance, content, contentLength)) != HTTPAPI_OK)
+    else if ((result = SendContentToXIO(http_instance, request->content, request->contentLength)) != HTTPAPI_OK)
     {
         LogError("Send content to HTTP failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
     }
-    /*Codes_SRS_HTTPAPI_COMPACT_21_030: [ At the end of the transmission, the HTTPAPI_ExecuteRequest shall receive the response from the host. ]*/
-    /*Codes_SRS_HTTPAPI_COMPACT_21_073: [ The message received by the HTTPAPI_ExecuteRequest shall starts with a valid header. ]*/
-    else if ((result = ReceiveHeaderFromXIO(http_instance, statusCode)) != HTTPAPI_OK)
+
+    return result;
+}
+
+/*sends the requests of the batch while there is room in the pipeline; the requests before resendEnd were already sent on a connection that closed*/
+static HTTPAPI_RESULT SendPipelinedRequests(HTTP_HANDLE_DATA* http_instance, size_t requestCount, size_t resendEnd)
+{
+    HTTPAPI_RESULT result = HTTPAPI_OK;
+    HTTP_RESPONSE_PARSER* response = &http_instance->response;
+    bool isWaiting = false;
+
+    /*Codes_SRS_HTTPAPI_COMPACT_01_009: [ The httpapi_compact_execute_pipelined_requests shall send a request without waiting for the responses to the previous ones as long as fewer than OPTION_HTTP_PIPELINE_DEPTH requests wait for their response. ]*/
+    while ((result == HTTPAPI_OK) &&
+        !isWaiting &&
+        (http_instance->pipeline_sent < requestCount) &&
+        (http_instance->pipeline_sent - http_instance->pipeline_responded < http_instance->pipeline_depth) &&
+        !IS_PIPELINE_BROKEN(response))
     {
-        LogError("Receive header from HTTP failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        HTTPAPI_PIPELINED_REQUEST* request = &http_instance->pipeline[http_instance->pipeline_sent];
+
+        if (response->state == RESPONSE_STATE_COMPLETE)
+        {
+            /*the response arrived while sending, the parser has to be free for the response to the next request*/
+            CompletePipelinedResponse(http_instance, GetResponseResult(response));
+        }
+        else if ((http_instance->pipeline_sent < resendEnd) && !isIdempotentRequest(request->requestType))
+        {
+            if (http_instance->pipeline_sent == http_instance->pipeline_responded)
+            {
+                /*Codes_SRS_HTTPAPI_COMPACT_01_011: [ A request that is not idempotent and that was sent on a connection that closed before its response shall not be sent again, and its result shall be HTTPAPI_READ_DATA_FAILED. ]*/
+                LogError("The HTTP connection closed before the response to a request that is not idempotent, it is not sent again");
+                http_instance->pipeline_sent++;
+                CompletePipelinedResponse(http_instance, HTTPAPI_READ_DATA_FAILED);
+            }
+            else
+            {
+                /*its result has to wait for the responses to the requests before it*/
+                isWaiting = true;
+            }
+        }
+        else
+        {
+            if (http_instance->pipeline_sent == http_instance->pipeline_responded)
+            {
+                StartPipelinedResponse(http_instance);
+            }
+
+            /*counted before it is sent, the response can start arriving while the request is still being sent*/
+            http_instance->pipeline_sent++;
+            result = SendPipelinedRequest(http_instance, request);
+        }
     }
-    /*Codes_SRS_HTTPAPI_COMPACT_21_074: [ After the header, the message received by the HTTPAPI_ExecuteRequest can contain addition information about the content. ]*/
-    else if ((result = ReceiveContentInfoFromXIO(http_instance, responseHeadersHandle, &bodyLength, &chunked)) != HTTPAPI_OK)
+
+    return result;
+}
+
+HTTPAPI_RESULT httpapi_compact_execute_pipelined_requests(HTTP_HANDLE handle, HTTPAPI_PIPELINED_REQUEST* requests, size_t requestCount)
+{
+    HTTPAPI_RESULT result;
+    HTTP_HANDLE_DATA* http_instance = (HTTP_HANDLE_DATA*)handle;
+    size_t i = 0;
+
+    if ((http_instance != NULL) && (requests != NULL))
+    {
+        while ((i < requestCount) && isValidPipelinedRequest(&requests[i]))
+        {
+            i++;
+        }
+    }
+
+    if ((http_instance == NULL) || (requests == NULL) || (requestCount == 0) || (i < requestCount))
     {
-        LogError("Receive content information from HTTP failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        /*Codes_SRS_HTTPAPI_COMPACT_01_007: [ If the handle or requests is NULL, requestCount is 0, or any request would make HTTPAPI_ExecuteRequest return HTTPAPI_INVALID_ARG, httpapi_compact_execute_pipelined_requests shall fail and return HTTPAPI_INVALID_ARG without sending any request. ]*/
+        result = HTTPAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
     }
-    /*Codes_SRS_HTTPAPI_COMPACT_42_084: [ The message received by the HTTPAPI_ExecuteRequest should not contain http body. ]*/
-    else if (requestType != HTTPAPI_REQUEST_HEAD)
+    else
     {
-        /*Codes_SRS_HTTPAPI_COMPACT_21_075: [ The message received by the HTTPAPI_ExecuteRequest can contain a body with the message content. ]*/
-        if ((result = ReadHTTPResponseBodyFromXIO(http_instance, bodyLength, chunked, responseContent)) != HTTPAPI_OK)
+        HTTP_RESPONSE_PARSER* response = &http_instance->response;
+        size_t resendEnd = 0;
+
+        http_instance->pipeline = requests;
+        http_instance->pipeline_sent = 0;
+        http_instance->pipeline_responded = 0;
+
+        while (http_instance->pipeline_responded < requestCount)
+        {
+            bool isNewConnection = (http_instance->is_connected == 0);
+            size_t respondedBefore = http_instance->pipeline_responded;
+            HTTPAPI_RESULT connectionResult;
+
+            if ((http_instance->is_connected != 0) && (http_instance->is_io_error != 0))
+            {
+                /*Codes_SRS_HTTPAPI_COMPACT_21_093: [ If the connection got an error while it was idle, the HTTPAPI_ExecuteRequest shall close it and open a new one. ]*/
+                LogInfo("The HTTP connection got an error, reopening it");
+                CloseXIOConnection(http_instance);
+                isNewConnection = true;
+            }
+
+            if ((connectionResult = OpenXIOConnection(http_instance)) != HTTPAPI_OK)
+            {
+                /*Codes_SRS_HTTPAPI_COMPACT_01_015: [ If the connection cannot be opened, the requests without a result shall fail with the result of the open. ]*/
+                LogError("Open HTTP connection failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, connectionResult));
+                while (http_instance->pipeline_responded < requestCount)
+                {
+                    requests[http_instance->pipeline_responded++].result = connectionResult;
+                }
+            }
+            else
+            {
+                bool isConnectionUsable;
+
+                if (((connectionResult = SendPipelinedRequests(http_instance, requestCount, resendEnd)) == HTTPAPI_OK) &&
+                    !IS_PIPELINE_BROKEN(response))
+                {
+                    /*the loop above only stops without a request waiting for its response once the batch is done*/
+                    if (http_instance->pipeline_sent > http_instance->pipeline_responded)
+                    {
+                        connectionResult = ReceiveResponseFromXIO(http_instance);
+                    }
+                }
+
+                if ((response->state == RESPONSE_STATE_COMPLETE) || (response->state == RESPONSE_STATE_FAILED))
+                {
+                    isConnectionUsable = (connectionResult == HTTPAPI_OK) && !IS_PIPELINE_BROKEN(response);
+                    CompletePipelinedResponse(http_instance, GetResponseResult(response));
+                }
+                else
+                {
+                    isConnectionUsable = (connectionResult == HTTPAPI_OK);
+                    if (!isConnectionUsable &&
+                        (http_instance->pipeline_sent > http_instance->pipeline_responded) &&
+                        ((response->state != RESPONSE_STATE_STATUS_LINE) || (response->line_length > 0)))
+                    {
+                        /*Codes_SRS_HTTPAPI_COMPACT_01_012: [ If the connection fails while a response is being received, the result of its request shall be HTTPAPI_READ_DATA_FAILED. ]*/
+                        LogError("The HTTP connection failed in the middle of a response");
+                        CompletePipelinedResponse(http_instance, HTTPAPI_READ_DATA_FAILED);
+                    }
+                }
+
+                if (!isConnectionUsable)
+                {
+                    if ((http_instance->pipeline_responded == respondedBefore) && isNewConnection)
+                    {
+                        /*Codes_SRS_HTTPAPI_COMPACT_01_014: [ If a new connection fails before any response, the oldest request without a result shall fail with the error of the connection. ]*/
+                        /*a connection that was kept alive may have been closed by the server while idle, the requests are sent again on a new one first*/
+                        CompletePipelinedResponse(http_instance, (connectionResult != HTTPAPI_OK) ? connectionResult : HTTPAPI_READ_DATA_FAILED);
+                    }
+
+                    /*Codes_SRS_HTTPAPI_COMPACT_01_010: [ When the connection closes, either because of a response with `Connection: close` or because of an error, the idempotent requests without a response shall be sent again on a new connection. ]*/
+                    CloseXIOConnection(http_instance);
+#ifdef USE_HTTP_DECOMPRESSION
+                    stopContentDecoder(response);
+#endif
+                    response->state = RESPONSE_STATE_IDLE;
+                    if (http_instance->pipeline_sent > resendEnd)
+                    {
+                        resendEnd = http_instance->pipeline_sent;
+                    }
+                    http_instance->pipeline_sent = http_instance->pipeline_responded;
+                }
+            }
+        }
+
+        http_instance->pipeline = NULL;
+        response->state = RESPONSE_STATE_IDLE;
+
+        /*Codes_SRS_HTTPAPI_COMPACT_01_013: [ httpapi_compact_execute_pipelined_requests shall return HTTPAPI_OK if every request got its response, otherwise the result of the first request that failed. ]*/
+        result = HTTPAPI_OK;
+        for (i = 0; (i < requestCount) && (result == HTTPAPI_OK); i++)
         {
-            LogError("Read HTTP response body from HTTP failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            result = requests[i].result;
         }
     }
 
-    conn_receive_discard_buffer(http_instance);
-
     return result;
 }
 
@@ -1339,6 +1829,29 @@ HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName, con
             result = HTTPAPI_OK;
         }
     }
+#ifdef USE_HTTP_DECOMPRESSION
+    else if (strcmp(OPTION_HTTP_DECOMPRESS_RESPONSES, optionName) == 0)
+    {
+        /*Codes_SRS_HTTPAPI_COMPACT_01_001: [ If the library is built with `use_http_decompression` and the optionName is OPTION_HTTP_DECOMPRESS_RESPONSES, value shall be a pointer to a bool that enables or disables the decompression of the responses. ]*/
+        http_instance->decompress_responses = (*(const bool*)value) ? 1 : 0;
+        result = HTTPAPI_OK;
+    }
+#endif
+    else if (strcmp(OPTION_HTTP_PIPELINE_DEPTH, optionName) == 0)
+    {
+        if (*(const size_t*)value == 0)
+        {
+            /*Codes_SRS_HTTPAPI_COMPACT_01_006: [ If the pipeline depth is 0, the HTTPAPI_SetOption shall return HTTPAPI_INVALID_ARG. ]*/
+            result = HTTPAPI_INVALID_ARG;
+            LogError("The HTTP pipeline depth cannot be 0");
+        }
+        else
+        {
+            /*Codes_SRS_HTTPAPI_COMPACT_01_005: [ If the optionName is OPTION_HTTP_PIPELINE_DEPTH, value shall be a pointer to a size_t with the largest number of requests httpapi_compact_execute_pipelined_requests keeps waiting for their response. ]*/
+            http_instance->pipeline_depth = *(const size_t*)value;
+            result = HTTPAPI_OK;
+        }
+    }
     else
     {
         /*Codes_SRS_HTTPAPI_COMPACT_21_063: [ If the HTTP do not support the optionName, the HTTPAPI_SetOption shall return HTTPAPI_INVALID_ARG. ]*/
@@ -1423,6 +1936,40 @@ HTTPAPI_RESULT HTTPAPI_CloneOption(const char* optionName, const void* value, co
             result = HTTPAPI_OK;
         }
     }
+#ifdef USE_HTTP_DECOMPRESSION
+    else if (strcmp(OPTION_HTTP_DECOMPRESS_RESPONSES, optionName) == 0)
+    {
+        bool* tempValue = (bool*)malloc(sizeof(bool));
+        if (tempValue == NULL)
+        {
+            /*Codes_SRS_HTTPAPI_COMPACT_21_070: [ If any memory allocation get fail, the HTTPAPI_CloneOption shall return HTTPAPI_ALLOC_FAILED. ]*/
+            result = HTTPAPI_ALLOC_FAILED;
+        }
+        else
+        {
+            /*Codes_SRS_HTTPAPI_COMPACT_21_072: [ If the HTTPAPI_CloneOption get success setting the option, it shall return HTTPAPI_OK. ]*/
+            *tempValue = *(const bool*)value;
+            *savedValue = tempValue;
+            result = HTTPAPI_OK;
+        }
+    }
+#endif
+    else if (strcmp(OPTION_HTTP_PIPELINE_DEPTH, optionName) == 0)
+    {
+        size_t* tempValue = (size_t*)malloc(sizeof(size_t));
+        if (tempValue == NULL)
+        {
+            /*Codes_SRS_HTTPAPI_COMPACT_21_070: [ If any memory allocation get fail, the HTTPAPI_CloneOption shall return HTTPAPI_ALLOC_FAILED. ]*/
+            result = HTTPAPI_ALLOC_FAILED;
+        }
+        else
+        {
+            /*Codes_SRS_HTTPAPI_COMPACT_21_072: [ If the HTTPAPI_CloneOption get success setting the option, it shall return HTTPAPI_OK. ]*/
+            *tempValue = *(const size_t*)value;
+            *savedValue = tempValue;
+            result = HTTPAPI_OK;
+        }
+    }
     else
     {
         /*Codes_SRS_HTTPAPI_COMPACT_21_071: [ If the HTTP do not support the optionName, the HTTPAPI_CloneOption shall return HTTPAPI_INVALID_ARG. ]*/
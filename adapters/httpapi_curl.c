@@ -5,12 +5,17 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <ctype.h>
 
+#include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/strings.h"
 #include "azure_c_shared_utility/httpapi.h"
+#include "azure_c_shared_utility/httpapi_curl.h"
 #include "azure_c_shared_utility/httpheaders.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/lock.h"
 #include "curl/curl.h"
 #include "azure_c_shared_utility/xlogging.h"
 #ifdef USE_OPENSSL
@@ -37,6 +42,8 @@ typedef struct HTTP_HANDLE_DATA_TAG
     long forbidReuse;
     long freshConnect;
     long verbose;
+    long httpVersion; /*CURL_HTTP_VERSION_NONE until OPTION_HTTP_VERSION is set, the default of the request path is used then*/
+    bool decompressResponses;
     const char* x509privatekey;
     const char* x509certificate;
     const char* certificates; /*a list of CA certificates*/
@@ -44,13 +51,131 @@ typedef struct HTTP_HANDLE_DATA_TAG
 
 typedef struct HTTP_RESPONSE_CONTENT_BUFFER_TAG
 {
+    CURL* curl; /*used to look up the Content-Length of the response when the first chunk arrives*/
     unsigned char* buffer;
     size_t bufferSize;
+    size_t bufferCapacity;
     unsigned char error;
 } HTTP_RESPONSE_CONTENT_BUFFER;
 
+typedef struct HTTP_STREAMING_CONTEXT_TAG
+{
+    HTTPAPI_READ_CONTENT readContent;
+    void* readContentContext;
+    HTTPAPI_WRITE_CONTENT writeContent;
+    void* writeContentContext;
+    unsigned char error;
+} HTTP_STREAMING_CONTEXT;
+
 static size_t nUsersOfHTTPAPI = 0; /*used for reference counting (a weak one)*/
 
+/*DNS answers and TLS sessions are shared by all the connections of the process, so a new connection to a host
+someone already talked to skips the name lookup and resumes the TLS session instead of doing a full handshake.
+The connection cache is not shared: libcurl does not support sharing connections between concurrent threads,
+every connection keeps its own connection alive between requests instead.*/
+static CURLSH* g_share = NULL;
+static LOCK_HANDLE g_shareLocks[CURL_LOCK_DATA_LAST];
+
+static void share_lock(CURL* handle, curl_lock_data data, curl_lock_access access, void* userptr)
+{
+    (void)handle;
+    (void)access;
+    (void)userptr;
+
+    if ((data < 0) || (data >= CURL_LOCK_DATA_LAST) ||
+        (Lock(g_shareLocks[data]) != LOCK_OK))
+    {
+        LogError("unable to lock the shared data %d", (int)data);
+    }
+}
+
+static void share_unlock(CURL* handle, curl_lock_data data, void* userptr)
+{
+    (void)handle;
+    (void)userptr;
+
+    if ((data < 0) || (data >= CURL_LOCK_DATA_LAST) ||
+        (Unlock(g_shareLocks[data]) != LOCK_OK))
+    {
+        LogError("unable to unlock the shared data %d", (int)data);
+    }
+}
+
+static void destroy_share_locks(void)
+{
+    size_t i;
+
+    for (i = 0; i < CURL_LOCK_DATA_LAST; i++)
+    {
+        if (g_shareLocks[i] != NULL)
+        {
+            (void)Lock_Deinit(g_shareLocks[i]);
+            g_shareLocks[i] = NULL;
+        }
+    }
+}
+
+static int create_share(void)
+{
+    int result;
+    size_t i;
+
+    /*libcurl also locks data it does not share (CURL_LOCK_DATA_SHARE is the share itself), so every kind gets a lock*/
+    for (i = 0; i < CURL_LOCK_DATA_LAST; i++)
+    {
+        if ((g_shareLocks[i] = Lock_Init()) == NULL)
+        {
+            break;
+        }
+    }
+
+    if (i < CURL_LOCK_DATA_LAST)
+    {
+        LogError("unable to Lock_Init");
+        destroy_share_locks();
+        result = __FAILURE__;
+    }
+    else if ((g_share = curl_share_init()) == NULL)
+    {
+        LogError("unable to curl_share_init");
+        destroy_share_locks();
+        result = __FAILURE__;
+    }
+    else if (
+        (curl_share_setopt(g_share, CURLSHOPT_LOCKFUNC, share_lock) != CURLSHE_OK) ||
+        (curl_share_setopt(g_share, CURLSHOPT_UNLOCKFUNC, share_unlock) != CURLSHE_OK) ||
+        (curl_share_setopt(g_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS) != CURLSHE_OK) ||
+        (curl_share_setopt(g_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION) != CURLSHE_OK)
+        )
+    {
+        LogError("unable to curl_share_setopt");
+        (void)curl_share_cleanup(g_share);
+        g_share = NULL;
+        destroy_share_locks();
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static void destroy_share(void)
+{
+    if (curl_share_cleanup(g_share) != CURLSHE_OK)
+    {
+        /*a connection is still open, the share (and its locks) has to outlive it*/
+        LogError("HTTPAPI_Deinit called while connections still use the shared DNS and TLS session cache");
+    }
+    else
+    {
+        destroy_share_locks();
+    }
+    g_share = NULL;
+}
+
 HTTPAPI_RESULT HTTPAPI_Init(void)
 {
     HTTPAPI_RESULT result;
@@ -61,6 +186,12 @@ HTTPAPI_RESULT HTTPAPI_Init(void)
             result = HTTPAPI_INIT_FAILED;
             LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
         }
+        else if (create_share() != 0)
+        {
+            curl_global_cleanup();
+            result = HTTPAPI_INIT_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
         else
         {
             nUsersOfHTTPAPI++;
@@ -83,6 +214,7 @@ void HTTPAPI_Deinit(void)
         nUsersOfHTTPAPI--;
         if (nUsersOfHTTPAPI == 0)
         {
+            destroy_share();
             curl_global_cleanup();
         }
     }
@@ -122,6 +254,15 @@ HTTP_HANDLE HTTPAPI_CreateConnection(const char* hostName)
                         free(httpHandleData);
                         httpHandleData = NULL;
                     }
+                    else if ((g_share != NULL) &&
+                        (curl_easy_setopt(httpHandleData->curl, CURLOPT_SHARE, g_share) != CURLE_OK))
+                    {
+                        LogError("unable to set CURLOPT_SHARE");
+                        curl_easy_cleanup(httpHandleData->curl);
+                        free(httpHandleData->hostURL);
+                        free(httpHandleData);
+                        httpHandleData = NULL;
+                    }
                     else
                     {
                         httpHandleData->timeout = 242 * 1000; /*242 seconds seems like a nice enough time. Reasone for 242:
@@ -132,6 +273,8 @@ HTTP_HANDLE HTTPAPI_CreateConnection(const char* hostName)
                         httpHandleData->forbidReuse = 0;
                         httpHandleData->freshConnect = 0;
                         httpHandleData->verbose = 0;
+                        httpHandleData->httpVersion = CURL_HTTP_VERSION_NONE;
+                        httpHandleData->decompressResponses = false;
                         httpHandleData->x509certificate = NULL;
                         httpHandleData->x509privatekey = NULL;
                         httpHandleData->certificates = NULL;
@@ -164,53 +307,112 @@ void HTTPAPI_CloseConnection(HTTP_HANDLE handle)
 static size_t HeadersWriteFunction(void *ptr, size_t size, size_t nmemb, void *userdata)
 {
     HTTP_HEADERS_HANDLE responseHeadersHandle = (HTTP_HEADERS_HANDLE)userdata;
-    char* headerLine = (char*)ptr;
 
-    if (headerLine != NULL)
+    /*the line is parsed when the headers are first read, the status line and the empty line that ends the headers are ignored then*/
+    if ((ptr != NULL) &&
+        (HTTPHeaders_AppendHeaderLines(responseHeadersHandle, (const char*)ptr, size * nmemb) != HTTP_HEADERS_OK))
     {
-        char* token = strtok(headerLine, "\r\n");
-        while ((token != NULL) &&
-               (token[0] != '\0'))
-        {
-            char* whereIsColon = strchr(token, ':');
-            if(whereIsColon!=NULL)
-            {
-                *whereIsColon='\0';
-                HTTPHeaders_AddHeaderNameValuePair(responseHeadersHandle, token, whereIsColon+1);
-                *whereIsColon=':';
-            }
-            else
-            {
-                /*not a header, maybe a status-line*/
-            }
-            token = strtok(NULL, "\r\n");
-        }
+        LogError("unable to keep a response header line");
     }
 
     return size * nmemb;
 }
 
+/*returns the Content-Length of the response being received or 0 when it is not known (chunked responses, HEAD...)*/
+static size_t GetResponseContentLength(CURL* curl)
+{
+    size_t result;
+#if LIBCURL_VERSION_NUM >= 0x073700
+    curl_off_t contentLength;
+    if ((curl == NULL) ||
+        (curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &contentLength) != CURLE_OK) ||
+        (contentLength <= 0) ||
+        ((unsigned long long)contentLength > (unsigned long long)SIZE_MAX))
+    {
+        result = 0;
+    }
+    else
+    {
+        result = (size_t)contentLength;
+    }
+#else
+    double contentLength;
+    if ((curl == NULL) ||
+        (curl_easy_getinfo(curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD, &contentLength) != CURLE_OK) ||
+        (contentLength <= 0) ||
+        (contentLength > (double)SIZE_MAX))
+    {
+        result = 0;
+    }
+    else
+    {
+        result = (size_t)contentLength;
+    }
+#endif
+    return result;
+}
+
 static size_t ContentWriteFunction(void *ptr, size_t size, size_t nmemb, void *userdata)
 {
     HTTP_RESPONSE_CONTENT_BUFFER* responseContentBuffer = (HTTP_RESPONSE_CONTENT_BUFFER*)userdata;
     if ((userdata != NULL) &&
         (ptr != NULL) &&
-        (size * nmemb > 0))
+        (size * nmemb > 0) &&
+        (responseContentBuffer->error == 0))
     {
-        void* newBuffer = realloc(responseContentBuffer->buffer, responseContentBuffer->bufferSize + (size * nmemb));
-        if (newBuffer != NULL)
+        size_t requiredSize = responseContentBuffer->bufferSize + (size * nmemb);
+        if (requiredSize < responseContentBuffer->bufferSize)
+        {
+            /*overflow, reported below*/
+        }
+        else if (requiredSize > responseContentBuffer->bufferCapacity)
+        {
+            /*the headers are all in by the time the first chunk arrives, so the whole content is reserved at once when its length is known;
+            otherwise (or when the server sends more than announced) the capacity doubles so that the number of reallocs stays logarithmic*/
+            size_t newCapacity = (responseContentBuffer->bufferCapacity == 0) ? GetResponseContentLength(responseContentBuffer->curl) : responseContentBuffer->bufferCapacity * 2;
+            void* newBuffer;
+            /*when built with GB_USE_BUDGETS the response content is counted in the GBALLOC_BUDGET_HTTP_RESPONSE budget*/
+            int previousBudget = GBALLOC_BUDGET_BEGIN(GBALLOC_BUDGET_HTTP_RESPONSE);
+
+            if ((newCapacity < requiredSize) ||
+                (newCapacity < responseContentBuffer->bufferCapacity))
+            {
+                newCapacity = requiredSize;
+            }
+
+            newBuffer = realloc(responseContentBuffer->buffer, newCapacity);
+            if ((newBuffer == NULL) && (newCapacity > requiredSize))
+            {
+                /*the reservation may be out of reach (a bogus Content-Length, low memory), the exact size might not*/
+                newCapacity = requiredSize;
+                newBuffer = realloc(responseContentBuffer->buffer, newCapacity);
+            }
+
+            GBALLOC_BUDGET_END(previousBudget);
+
+            if (newBuffer != NULL)
+            {
+                responseContentBuffer->buffer = newBuffer;
+                responseContentBuffer->bufferCapacity = newCapacity;
+            }
+        }
+
+        if ((requiredSize >= responseContentBuffer->bufferSize) &&
+            (requiredSize <= responseContentBuffer->bufferCapacity))
         {
-            responseContentBuffer->buffer = newBuffer;
             memcpy(responseContentBuffer->buffer + responseContentBuffer->bufferSize, ptr, size * nmemb);
-            responseContentBuffer->bufferSize += size * nmemb;
+            responseContentBuffer->bufferSize = requiredSize;
         }
         else
         {
-            LogError("Could not allocate buffer of size %lu", (unsigned long)(responseContentBuffer->bufferSize + (size * nmemb)));
+            LogError("Could not allocate buffer of size %lu", (unsigned long)requiredSize);
             responseContentBuffer->error = 1;
             if (responseContentBuffer->buffer != NULL)
             {
                 free(responseContentBuffer->buffer);
+                responseContentBuffer->buffer = NULL;
+                responseContentBuffer->bufferSize = 0;
+                responseContentBuffer->bufferCapacity = 0;
             }
         }
     }
@@ -218,6 +420,48 @@ static size_t ContentWriteFunction(void *ptr, size_t size, size_t nmemb, void *u
     return size * nmemb;
 }
 
+static size_t ReadContentFunction(char *buffer, size_t size, size_t nitems, void *userdata)
+{
+    size_t result;
+    HTTP_STREAMING_CONTEXT* streaming = (HTTP_STREAMING_CONTEXT*)userdata;
+    size_t bytesRead = 0;
+
+    if (streaming->readContent(streaming->readContentContext, (unsigned char*)buffer, size * nitems, &bytesRead) != 0)
+    {
+        LogError("the request content could not be read");
+        streaming->error = 1;
+        result = CURL_READFUNC_ABORT;
+    }
+    else
+    {
+        result = bytesRead;
+    }
+
+    return result;
+}
+
+static size_t StreamingWriteFunction(void *ptr, size_t size, size_t nmemb, void *userdata)
+{
+    size_t result;
+    HTTP_STREAMING_CONTEXT* streaming = (HTTP_STREAMING_CONTEXT*)userdata;
+
+    if ((streaming->writeContent != NULL) &&
+        (size * nmemb > 0) &&
+        (streaming->writeContent(streaming->writeContentContext, (const unsigned char*)ptr, size * nmemb) != 0))
+    {
+        LogError("the response content could not be written");
+        streaming->error = 1;
+        /*anything else than size * nmemb makes curl abort the transfer*/
+        result = 0;
+    }
+    else
+    {
+        result = size * nmemb;
+    }
+
+    return result;
+}
+
 static CURLcode ssl_ctx_callback(CURL *curl, void *ssl_ctx, void *userptr)
 {
     CURLcode result;
@@ -290,236 +534,283 @@ static CURLcode ssl_ctx_callback(CURL *curl, void *ssl_ctx, void *userptr)
     return result;
 }
 
-HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
-                                      HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content,
-                                      size_t contentLength, unsigned int* statusCode,
-                                      HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent)
+/*applies the options that HTTPAPI_SetOption keeps in HTTP_HANDLE_DATA (as opposed to the ones it sets directly on the curl handle)*/
+static HTTPAPI_RESULT set_transfer_options(HTTP_HANDLE_DATA* httpHandleData, CURL* curl, long defaultHttpVersion)
 {
     HTTPAPI_RESULT result;
-    HTTP_HANDLE_DATA* httpHandleData = (HTTP_HANDLE_DATA*)handle;
-    size_t headersCount;
-    HTTP_RESPONSE_CONTENT_BUFFER responseContentBuffer;
 
-    if ((httpHandleData == NULL) ||
-        (relativePath == NULL) ||
-        (httpHeadersHandle == NULL) ||
-        ((content == NULL) && (contentLength > 0))
-    )
+    if (curl_easy_setopt(curl, CURLOPT_VERBOSE, httpHandleData->verbose) != CURLE_OK)
     {
-        result = HTTPAPI_INVALID_ARG;
-        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        result = HTTPAPI_SET_OPTION_FAILED;
+        LogError("failed to set CURLOPT_VERBOSE (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
     }
-    else if (HTTPHeaders_GetHeaderCount(httpHeadersHandle, &headersCount) != HTTP_HEADERS_OK)
+    else if (curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, httpHandleData->timeout) != CURLE_OK)
     {
-        result = HTTPAPI_INVALID_ARG;
-        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        result = HTTPAPI_SET_OPTION_FAILED;
+        LogError("failed to set CURLOPT_TIMEOUT_MS (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else if (curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, httpHandleData->lowSpeedLimit) != CURLE_OK)
+    {
+        result = HTTPAPI_SET_OPTION_FAILED;
+        LogError("failed to set CURLOPT_LOW_SPEED_LIMIT (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else if (curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, httpHandleData->lowSpeedTime) != CURLE_OK)
+    {
+        result = HTTPAPI_SET_OPTION_FAILED;
+        LogError("failed to set CURLOPT_LOW_SPEED_TIME (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else if (curl_easy_setopt(curl, CURLOPT_FRESH_CONNECT, httpHandleData->freshConnect) != CURLE_OK)
+    {
+        result = HTTPAPI_SET_OPTION_FAILED;
+        LogError("failed to set CURLOPT_FRESH_CONNECT (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else if (curl_easy_setopt(curl, CURLOPT_FORBID_REUSE, httpHandleData->forbidReuse) != CURLE_OK)
+    {
+        result = HTTPAPI_SET_OPTION_FAILED;
+        LogError("failed to set CURLOPT_FORBID_REUSE (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else if (curl_easy_setopt(curl, CURLOPT_HTTP_VERSION, (httpHandleData->httpVersion != CURL_HTTP_VERSION_NONE) ? httpHandleData->httpVersion : defaultHttpVersion) != CURLE_OK)
+    {
+        result = HTTPAPI_SET_OPTION_FAILED;
+        LogError("failed to set CURLOPT_HTTP_VERSION (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    /*"" makes curl offer every encoding it has been built with and decode the content before ContentWriteFunction sees it*/
+    else if (curl_easy_setopt(curl, CURLOPT_ACCEPT_ENCODING, httpHandleData->decompressResponses ? "" : NULL) != CURLE_OK)
+    {
+        result = HTTPAPI_SET_OPTION_FAILED;
+        LogError("failed to set CURLOPT_ACCEPT_ENCODING (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
     }
     else
     {
-        char* tempHostURL;
-        size_t tempHostURL_size = strlen(httpHandleData->hostURL) + strlen(relativePath) + 1;
-        tempHostURL = malloc(tempHostURL_size);
-        if (tempHostURL == NULL)
+        result = HTTPAPI_OK;
+    }
+
+    return result;
+}
+
+static HTTPAPI_RESULT set_request_type(CURL* curl, HTTPAPI_REQUEST_TYPE requestType)
+{
+    HTTPAPI_RESULT result = HTTPAPI_OK;
+
+    switch (requestType)
+    {
+    default:
+        result = HTTPAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        break;
+
+    case HTTPAPI_REQUEST_GET:
+        if (curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L) != CURLE_OK)
         {
-            result = HTTPAPI_ERROR;
+            result = HTTPAPI_SET_OPTION_FAILED;
             LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
         }
         else
         {
-            if (curl_easy_setopt(httpHandleData->curl, CURLOPT_VERBOSE, httpHandleData->verbose) != CURLE_OK)
+            if (curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, NULL) != CURLE_OK)
             {
                 result = HTTPAPI_SET_OPTION_FAILED;
-                LogError("failed to set CURLOPT_VERBOSE (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-            }
-            else if ((strcpy_s(tempHostURL, tempHostURL_size, httpHandleData->hostURL) != 0) ||
-                (strcat_s(tempHostURL, tempHostURL_size, relativePath) != 0))
-            {
-                result = HTTPAPI_STRING_PROCESSING_ERROR;
                 LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
             }
-            /* set the URL */
-            else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_URL, tempHostURL) != CURLE_OK)
-            {
-                result = HTTPAPI_SET_OPTION_FAILED;
-                LogError("failed to set CURLOPT_URL (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-            }
-            else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_TIMEOUT_MS, httpHandleData->timeout) != CURLE_OK)
-            {
-                result = HTTPAPI_SET_OPTION_FAILED;
-                LogError("failed to set CURLOPT_TIMEOUT_MS (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-            }
-            else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_LOW_SPEED_LIMIT, httpHandleData->lowSpeedLimit) != CURLE_OK)
+        }
+
+        break;
+
+    case HTTPAPI_REQUEST_HEAD:
+        if (curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L) != CURLE_OK)
+        {
+            result = HTTPAPI_SET_OPTION_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else if (curl_easy_setopt(curl, CURLOPT_NOBODY, 1L) != CURLE_OK)
+        {
+            result = HTTPAPI_SET_OPTION_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else if (curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, NULL) != CURLE_OK)
+        {
+            result = HTTPAPI_SET_OPTION_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+
+        break;
+
+    case HTTPAPI_REQUEST_POST:
+        if (curl_easy_setopt(curl, CURLOPT_POST, 1L) != CURLE_OK)
+        {
+            result = HTTPAPI_SET_OPTION_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else
+        {
+            if (curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, NULL) != CURLE_OK)
             {
                 result = HTTPAPI_SET_OPTION_FAILED;
-                LogError("failed to set CURLOPT_LOW_SPEED_LIMIT (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
             }
-            else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_LOW_SPEED_TIME, httpHandleData->lowSpeedTime) != CURLE_OK)
+        }
+
+        break;
+
+    case HTTPAPI_REQUEST_PUT:
+        if (curl_easy_setopt(curl, CURLOPT_POST, 1L))
+        {
+            result = HTTPAPI_SET_OPTION_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else
+        {
+            if (curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PUT") != CURLE_OK)
             {
                 result = HTTPAPI_SET_OPTION_FAILED;
-                LogError("failed to set CURLOPT_LOW_SPEED_TIME (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
             }
-            else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_FRESH_CONNECT, httpHandleData->freshConnect) != CURLE_OK)
+        }
+        break;
+
+    case HTTPAPI_REQUEST_DELETE:
+        if (curl_easy_setopt(curl, CURLOPT_POST, 1L) != CURLE_OK)
+        {
+            result = HTTPAPI_SET_OPTION_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else
+        {
+            if (curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "DELETE") != CURLE_OK)
             {
                 result = HTTPAPI_SET_OPTION_FAILED;
-                LogError("failed to set CURLOPT_FRESH_CONNECT (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
             }
-            else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_FORBID_REUSE, httpHandleData->forbidReuse) != CURLE_OK)
+        }
+        break;
+
+    case HTTPAPI_REQUEST_PATCH:
+        if (curl_easy_setopt(curl, CURLOPT_POST, 1L) != CURLE_OK)
+        {
+            result = HTTPAPI_SET_OPTION_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else
+        {
+            if (curl_easy_setopt(curl, CURLOPT_CUSTOMREQUEST, "PATCH") != CURLE_OK)
             {
                 result = HTTPAPI_SET_OPTION_FAILED;
-                LogError("failed to set CURLOPT_FORBID_REUSE (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
             }
-            else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_HTTP_VERSION, CURL_HTTP_VERSION_1_1) != CURLE_OK)
+        }
+
+        break;
+    }
+
+    return result;
+}
+
+static HTTPAPI_RESULT build_request_headers(HTTP_HEADERS_HANDLE httpHeadersHandle, size_t headersCount, struct curl_slist** headers)
+{
+    HTTPAPI_RESULT result = HTTPAPI_OK;
+    size_t i;
+
+    *headers = NULL;
+    for (i = 0; i < headersCount; i++)
+    {
+        char *tempBuffer;
+        if (HTTPHeaders_GetHeader(httpHeadersHandle, i, &tempBuffer) != HTTP_HEADERS_OK)
+        {
+            /* error */
+            result = HTTPAPI_HTTP_HEADERS_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            break;
+        }
+        else
+        {
+            struct curl_slist* newHeaders = curl_slist_append(*headers, tempBuffer);
+            if (newHeaders == NULL)
             {
-                result = HTTPAPI_SET_OPTION_FAILED;
-                LogError("failed to set CURLOPT_HTTP_VERSION (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                result = HTTPAPI_ALLOC_FAILED;
+                LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                free(tempBuffer);
+                break;
             }
             else
             {
-                result = HTTPAPI_OK;
+                free(tempBuffer);
+                *headers = newHeaders;
+            }
+        }
+    }
 
-                switch (requestType)
-                {
-                default:
-                    result = HTTPAPI_INVALID_ARG;
-                    LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                    break;
+    if (result != HTTPAPI_OK)
+    {
+        curl_slist_free_all(*headers);
+        *headers = NULL;
+    }
 
-                case HTTPAPI_REQUEST_GET:
-                    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_HTTPGET, 1L) != CURLE_OK)
-                    {
-                        result = HTTPAPI_SET_OPTION_FAILED;
-                        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                    }
-                    else
-                    {
-                        if (curl_easy_setopt(httpHandleData->curl, CURLOPT_CUSTOMREQUEST, NULL) != CURLE_OK)
-                        {
-                            result = HTTPAPI_SET_OPTION_FAILED;
-                            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                        }
-                    }
-
-                    break;
-
-                case HTTPAPI_REQUEST_HEAD:
-                    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_HTTPGET, 1L) != CURLE_OK)
-                    {
-                        result = HTTPAPI_SET_OPTION_FAILED;
-                        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                    }
-                    else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_NOBODY, 1L) != CURLE_OK)
-                    {
-                        result = HTTPAPI_SET_OPTION_FAILED;
-                        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                    }
-                    else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_CUSTOMREQUEST, NULL) != CURLE_OK)
-                    {
-                        result = HTTPAPI_SET_OPTION_FAILED;
-                        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                    }
-
-                    break;
-
-                case HTTPAPI_REQUEST_POST:
-                    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_POST, 1L) != CURLE_OK)
-                    {
-                        result = HTTPAPI_SET_OPTION_FAILED;
-                        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                    }
-                    else
-                    {
-                        if (curl_easy_setopt(httpHandleData->curl, CURLOPT_CUSTOMREQUEST, NULL) != CURLE_OK)
-                        {
-                            result = HTTPAPI_SET_OPTION_FAILED;
-                            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                        }
-                    }
-
-                    break;
-
-                case HTTPAPI_REQUEST_PUT:
-                    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_POST, 1L))
-                    {
-                        result = HTTPAPI_SET_OPTION_FAILED;
-                        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                    }
-                    else
-                    {
-                        if (curl_easy_setopt(httpHandleData->curl, CURLOPT_CUSTOMREQUEST, "PUT") != CURLE_OK)
-                        {
-                            result = HTTPAPI_SET_OPTION_FAILED;
-                            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                        }
-                    }
-                    break;
-
-                case HTTPAPI_REQUEST_DELETE:
-                    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_POST, 1L) != CURLE_OK)
-                    {
-                        result = HTTPAPI_SET_OPTION_FAILED;
-                        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                    }
-                    else
-                    {
-                        if (curl_easy_setopt(httpHandleData->curl, CURLOPT_CUSTOMREQUEST, "DELETE") != CURLE_OK)
-                        {
-                            result = HTTPAPI_SET_OPTION_FAILED;
-                            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                        }
-                    }
-                    break;
+    return result;
+}
 
-                case HTTPAPI_REQUEST_PATCH:
-                    if (curl_easy_setopt(httpHandleData->curl, CURLOPT_POST, 1L) != CURLE_OK)
-                    {
-                        result = HTTPAPI_SET_OPTION_FAILED;
-                        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                    }
-                    else
-                    {
-                        if (curl_easy_setopt(httpHandleData->curl, CURLOPT_CUSTOMREQUEST, "PATCH") != CURLE_OK)
-                        {
-                            result = HTTPAPI_SET_OPTION_FAILED;
-                            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                        }
-                    }
+/*streaming is NULL for HTTPAPI_ExecuteRequest. Otherwise the request body of contentLength bytes comes from streaming->readContent instead of content,
+and the response body goes to streaming->writeContent instead of responseContent*/
+static HTTPAPI_RESULT execute_request(HTTP_HANDLE_DATA* httpHandleData, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+                                      HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content,
+                                      size_t contentLength, unsigned int* statusCode,
+                                      HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent, HTTP_STREAMING_CONTEXT* streaming)
+{
+    HTTPAPI_RESULT result;
+    size_t headersCount;
+    HTTP_RESPONSE_CONTENT_BUFFER responseContentBuffer;
 
-                    break;
-                }
+    if ((httpHandleData == NULL) ||
+        (relativePath == NULL) ||
+        (httpHeadersHandle == NULL) ||
+        ((content == NULL) && (contentLength > 0) && ((streaming == NULL) || (streaming->readContent == NULL)))
+    )
+    {
+        result = HTTPAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else if (HTTPHeaders_GetHeaderCount(httpHeadersHandle, &headersCount) != HTTP_HEADERS_OK)
+    {
+        result = HTTPAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else
+    {
+        char* tempHostURL;
+        size_t tempHostURL_size = strlen(httpHandleData->hostURL) + strlen(relativePath) + 1;
+        tempHostURL = malloc(tempHostURL_size);
+        if (tempHostURL == NULL)
+        {
+            result = HTTPAPI_ERROR;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else
+        {
+            if ((strcpy_s(tempHostURL, tempHostURL_size, httpHandleData->hostURL) != 0) ||
+                (strcat_s(tempHostURL, tempHostURL_size, relativePath) != 0))
+            {
+                result = HTTPAPI_STRING_PROCESSING_ERROR;
+                LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            }
+            /* set the URL */
+            else if (curl_easy_setopt(httpHandleData->curl, CURLOPT_URL, tempHostURL) != CURLE_OK)
+            {
+                result = HTTPAPI_SET_OPTION_FAILED;
+                LogError("failed to set CURLOPT_URL (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            }
+            else if ((result = set_transfer_options(httpHandleData, httpHandleData->curl, CURL_HTTP_VERSION_1_1)) != HTTPAPI_OK)
+            {
+                LogError("failed to set the transfer options (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            }
+            else
+            {
+                result = set_request_type(httpHandleData->curl, requestType);
 
                 if (result == HTTPAPI_OK)
                 {
                     /* add headers */
                     struct curl_slist* headers = NULL;
-                    size_t i;
 
-                    for (i = 0; i < headersCount; i++)
-                    {
-                        char *tempBuffer;
-                        if (HTTPHeaders_GetHeader(httpHeadersHandle, i, &tempBuffer) != HTTP_HEADERS_OK)
-                        {
-                            /* error */
-                            result = HTTPAPI_HTTP_HEADERS_FAILED;
-                            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                            break;
-                        }
-                        else
-                        {
-                            struct curl_slist* newHeaders = curl_slist_append(headers, tempBuffer);
-                            if (newHeaders == NULL)
-                            {
-                                result = HTTPAPI_ALLOC_FAILED;
-                                LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                                free(tempBuffer);
-                                break;
-                            }
-                            else
-                            {
-                                free(tempBuffer);
-                                headers = newHeaders;
-                            }
-                        }
-                    }
+                    result = build_request_headers(httpHeadersHandle, headersCount, &headers);
 
                     if (result == HTTPAPI_OK)
                     {
@@ -531,7 +822,20 @@ HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE r
                         else
                         {
                             /* add content */
-                            if ((content != NULL) &&
+                            if ((streaming != NULL) &&
+                                (contentLength > 0))
+                            {
+                                /*curl pulls the body through ReadContentFunction*/
+                                if ((curl_easy_setopt(httpHandleData->curl, CURLOPT_POSTFIELDS, (void*)NULL) != CURLE_OK) ||
+                                    (curl_easy_setopt(httpHandleData->curl, CURLOPT_POSTFIELDSIZE_LARGE, (curl_off_t)contentLength) != CURLE_OK) ||
+                                    (curl_easy_setopt(httpHandleData->curl, CURLOPT_READFUNCTION, ReadContentFunction) != CURLE_OK) ||
+                                    (curl_easy_setopt(httpHandleData->curl, CURLOPT_READDATA, streaming) != CURLE_OK))
+                                {
+                                    result = HTTPAPI_SET_OPTION_FAILED;
+                                    LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                                }
+                            }
+                            else if ((content != NULL) &&
                                 (contentLength > 0))
                             {
                                 if ((curl_easy_setopt(httpHandleData->curl, CURLOPT_POSTFIELDS, (void*)content) != CURLE_OK) ||
@@ -562,7 +866,7 @@ HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE r
                             {
                                 if ((curl_easy_setopt(httpHandleData->curl, CURLOPT_WRITEHEADER, NULL) != CURLE_OK) ||
                                     (curl_easy_setopt(httpHandleData->curl, CURLOPT_HEADERFUNCTION, NULL) != CURLE_OK) ||
-                                    (curl_easy_setopt(httpHandleData->curl, CURLOPT_WRITEFUNCTION, ContentWriteFunction) != CURLE_OK))
+                                    (curl_easy_setopt(httpHandleData->curl, CURLOPT_WRITEFUNCTION, (streaming != NULL) ? StreamingWriteFunction : ContentWriteFunction) != CURLE_OK))
                                 {
                                     result = HTTPAPI_SET_OPTION_FAILED;
                                     LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
@@ -582,11 +886,13 @@ HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE r
 
                                     if (result == HTTPAPI_OK)
                                     {
+                                        responseContentBuffer.curl = httpHandleData->curl;
                                         responseContentBuffer.buffer = NULL;
                                         responseContentBuffer.bufferSize = 0;
+                                        responseContentBuffer.bufferCapacity = 0;
                                         responseContentBuffer.error = 0;
 
-                                        if (curl_easy_setopt(httpHandleData->curl, CURLOPT_WRITEDATA, &responseContentBuffer) != CURLE_OK)
+                                        if (curl_easy_setopt(httpHandleData->curl, CURLOPT_WRITEDATA, (streaming != NULL) ? (void*)streaming : (void*)&responseContentBuffer) != CURLE_OK)
                                         {
                                             result = HTTPAPI_SET_OPTION_FAILED;
                                             LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
@@ -599,7 +905,7 @@ HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE r
                                             if (curlRes != CURLE_OK)
                                             {
                                                 LogError("curl_easy_perform() failed: %s\n", curl_easy_strerror(curlRes));
-                                                result = HTTPAPI_OPEN_REQUEST_FAILED;
+                                                result = ((streaming != NULL) && streaming->error) ? HTTPAPI_READ_DATA_FAILED : HTTPAPI_OPEN_REQUEST_FAILED;
                                                 LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
                                             }
                                             else
@@ -671,6 +977,96 @@ HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE r
     return result;
 }
 
+HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+                                      HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content,
+                                      size_t contentLength, unsigned int* statusCode,
+                                      HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent)
+{
+    return execute_request((HTTP_HANDLE_DATA*)handle, requestType, relativePath, httpHeadersHandle, content, contentLength, statusCode, responseHeadersHandle, responseContent, NULL);
+}
+
+HTTPAPI_RESULT HTTPAPI_ExecuteStreamingRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+                                      HTTP_HEADERS_HANDLE httpHeadersHandle, size_t contentLength,
+                                      HTTPAPI_READ_CONTENT readContent, void* readContentContext, unsigned int* statusCode,
+                                      HTTP_HEADERS_HANDLE responseHeadersHandle, HTTPAPI_WRITE_CONTENT writeContent, void* writeContentContext)
+{
+    HTTPAPI_RESULT result;
+
+    if ((readContent == NULL) && (contentLength > 0))
+    {
+        result = HTTPAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else
+    {
+        HTTP_STREAMING_CONTEXT streaming;
+        streaming.readContent = readContent;
+        streaming.readContentContext = readContentContext;
+        streaming.writeContent = writeContent;
+        streaming.writeContentContext = writeContentContext;
+        streaming.error = 0;
+
+        result = execute_request((HTTP_HANDLE_DATA*)handle, requestType, relativePath, httpHeadersHandle, NULL, contentLength, statusCode, responseHeadersHandle, NULL, &streaming);
+    }
+
+    return result;
+}
+
+/*maps OPTION_HTTP_VERSION to CURLOPT_HTTP_VERSION, curl only accepts the HTTP/2 values when it has been built with HTTP/2 support*/
+static int get_curl_http_version(HTTP_VERSION_OPTION httpVersion, long* curlHttpVersion)
+{
+    int result;
+    curl_version_info_data* versionInfo = curl_version_info(CURLVERSION_NOW);
+    bool supportsHttp2 = (versionInfo != NULL) && ((versionInfo->features & CURL_VERSION_HTTP2) != 0);
+
+    switch (httpVersion)
+    {
+    case HTTP_VERSION_OPTION_DEFAULT:
+        *curlHttpVersion = CURL_HTTP_VERSION_NONE;
+        result = 0;
+        break;
+    case HTTP_VERSION_OPTION_1_1:
+        *curlHttpVersion = CURL_HTTP_VERSION_1_1;
+        result = 0;
+        break;
+#if LIBCURL_VERSION_NUM >= 0x072F00
+    case HTTP_VERSION_OPTION_2:
+        if (!supportsHttp2)
+        {
+            LogError("libcurl has been built without HTTP/2 support");
+            result = __FAILURE__;
+        }
+        else
+        {
+            *curlHttpVersion = CURL_HTTP_VERSION_2TLS;
+            result = 0;
+        }
+        break;
+#endif
+#if LIBCURL_VERSION_NUM >= 0x073100
+    case HTTP_VERSION_OPTION_2_PRIOR_KNOWLEDGE:
+        if (!supportsHttp2)
+        {
+            LogError("libcurl has been built without HTTP/2 support");
+            result = __FAILURE__;
+        }
+        else
+        {
+            *curlHttpVersion = CURL_HTTP_VERSION_2_PRIOR_KNOWLEDGE;
+            result = 0;
+        }
+        break;
+#endif
+    default:
+        (void)supportsHttp2;
+        LogError("unsupported HTTP version %d", (int)httpVersion);
+        result = __FAILURE__;
+        break;
+    }
+
+    return result;
+}
+
 HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName, const void* value)
 {
     HTTPAPI_RESULT result;
@@ -717,6 +1113,25 @@ HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName, con
             httpHandleData->verbose = *(const long*)value;
             result = HTTPAPI_OK;
         }
+        else if (strcmp(OPTION_HTTP_DECOMPRESS_RESPONSES, optionName) == 0)
+        {
+            httpHandleData->decompressResponses = *(const bool*)value;
+            result = HTTPAPI_OK;
+        }
+        else if (strcmp(OPTION_HTTP_VERSION, optionName) == 0)
+        {
+            long curlHttpVersion;
+            if (get_curl_http_version(*(const HTTP_VERSION_OPTION*)value, &curlHttpVersion) != 0)
+            {
+                result = HTTPAPI_SET_OPTION_FAILED;
+                LogError("unable to set the HTTP version (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            }
+            else
+            {
+                httpHandleData->httpVersion = curlHttpVersion;
+                result = HTTPAPI_OK;
+            }
+        }
         else if (strcmp(SU_OPTION_X509_PRIVATE_KEY, optionName) == 0 || strcmp(OPTION_X509_ECC_KEY, optionName) == 0)
         {
             httpHandleData->x509privatekey = value;
@@ -958,6 +1373,36 @@ HTTPAPI_RESULT HTTPAPI_CloneOption(const char* optionName, const void* value, co
                 result = HTTPAPI_OK;
             }
         }
+        else if (strcmp(OPTION_HTTP_DECOMPRESS_RESPONSES, optionName) == 0)
+        {
+            bool* temp = malloc(sizeof(bool)); /*shall be freed by HTTPAPIEX*/
+            if (temp == NULL)
+            {
+                result = HTTPAPI_ERROR;
+                LogError("malloc failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            }
+            else
+            {
+                *temp = *(const bool*)value;
+                *savedValue = temp;
+                result = HTTPAPI_OK;
+            }
+        }
+        else if (strcmp(OPTION_HTTP_VERSION, optionName) == 0)
+        {
+            HTTP_VERSION_OPTION* temp = malloc(sizeof(HTTP_VERSION_OPTION)); /*shall be freed by HTTPAPIEX*/
+            if (temp == NULL)
+            {
+                result = HTTPAPI_ERROR;
+                LogError("malloc failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            }
+            else
+            {
+                *temp = *(const HTTP_VERSION_OPTION*)value;
+                *savedValue = temp;
+                result = HTTPAPI_OK;
+            }
+        }
         /*all "long" options are cloned in the same way*/
         else if (
             (strcmp(OPTION_CURL_LOW_SPEED_LIMIT, optionName) == 0) ||
@@ -989,3 +1434,559 @@ HTTPAPI_RESULT HTTPAPI_CloneOption(const char* optionName, const void* value, co
     }
     return result;
 }
+
+/*asynchronous requests: every request gets its own easy handle, duplicated from the template connection in settings so that it inherits
+what HTTPAPI_SetOption has set directly on the curl handle (certificates callback, proxy). The easy handles are driven by one multi handle
+which owns the connection cache and multiplexes the requests over one HTTP/2 connection when the server supports it.*/
+#if LIBCURL_VERSION_NUM >= 0x072F00
+#define ASYNC_HTTP_VERSION CURL_HTTP_VERSION_2TLS
+#else
+#define ASYNC_HTTP_VERSION CURL_HTTP_VERSION_1_1
+#endif
+
+typedef struct HTTPAPI_CURL_ASYNC_REQUEST_TAG
+{
+    CURL* curl;
+    struct curl_slist* headers;
+    HTTP_HEADERS_HANDLE responseHeaders;
+    HTTP_RESPONSE_CONTENT_BUFFER responseContentBuffer;
+    HTTP_STREAMING_CONTEXT streaming; /*writeContent is not NULL when the content goes to the caller's sink instead of responseContentBuffer*/
+    ON_HTTPAPI_CURL_REQUEST_COMPLETE on_request_complete;
+    void* on_request_complete_context;
+    LIST_ITEM_HANDLE list_item;
+} HTTPAPI_CURL_ASYNC_REQUEST;
+
+typedef struct HTTPAPI_CURL_ASYNC_SAVED_OPTION_TAG
+{
+    char* optionName;
+    const void* value;
+} HTTPAPI_CURL_ASYNC_SAVED_OPTION;
+
+typedef struct HTTPAPI_CURL_ASYNC_INSTANCE_TAG
+{
+    HTTP_HANDLE_DATA* settings;
+    CURLM* multi;
+    CURLSH* share;
+    SINGLYLINKEDLIST_HANDLE pendingRequests;
+    SINGLYLINKEDLIST_HANDLE savedOptions; /*HTTPAPI_SetOption does not copy the values, so the instance keeps the clones alive*/
+} HTTPAPI_CURL_ASYNC_INSTANCE;
+
+static void destroy_async_request(HTTPAPI_CURL_ASYNC_REQUEST* request)
+{
+    curl_easy_cleanup(request->curl);
+    curl_slist_free_all(request->headers);
+    HTTPHeaders_Free(request->responseHeaders);
+    if (request->responseContentBuffer.buffer != NULL)
+    {
+        free(request->responseContentBuffer.buffer);
+    }
+    free(request);
+}
+
+static void complete_async_request(HTTPAPI_CURL_ASYNC_INSTANCE* instance, HTTPAPI_CURL_ASYNC_REQUEST* request, HTTPAPI_RESULT result)
+{
+    long httpCode = 0;
+
+    (void)curl_multi_remove_handle(instance->multi, request->curl);
+    (void)singlylinkedlist_remove(instance->pendingRequests, request->list_item);
+
+    if (request->streaming.error)
+    {
+        /*the sink refused the content, which is what aborted the transfer*/
+        result = HTTPAPI_READ_DATA_FAILED;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else if (result == HTTPAPI_OK)
+    {
+        if (curl_easy_getinfo(request->curl, CURLINFO_RESPONSE_CODE, &httpCode) != CURLE_OK)
+        {
+            result = HTTPAPI_QUERY_HEADERS_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else if (request->responseContentBuffer.error)
+        {
+            result = HTTPAPI_READ_DATA_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else if (httpCode >= 300)
+        {
+            LogError("Failure in HTTP communication: server reply code is %ld", httpCode);
+        }
+    }
+
+    request->on_request_complete(request->on_request_complete_context, result, (unsigned int)httpCode, request->responseHeaders,
+        request->responseContentBuffer.buffer, request->responseContentBuffer.bufferSize);
+    destroy_async_request(request);
+}
+
+static HTTPAPI_RESULT setup_async_request(HTTPAPI_CURL_ASYNC_INSTANCE* instance, HTTPAPI_CURL_ASYNC_REQUEST* request, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE httpHeadersHandle, size_t headersCount, const unsigned char* content, size_t contentLength)
+{
+    HTTPAPI_RESULT result;
+    char* tempHostURL;
+    size_t tempHostURL_size = strlen(instance->settings->hostURL) + strlen(relativePath) + 1;
+
+    request->responseContentBuffer.curl = request->curl;
+
+    if ((tempHostURL = malloc(tempHostURL_size)) == NULL)
+    {
+        result = HTTPAPI_ALLOC_FAILED;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else
+    {
+        if ((strcpy_s(tempHostURL, tempHostURL_size, instance->settings->hostURL) != 0) ||
+            (strcat_s(tempHostURL, tempHostURL_size, relativePath) != 0))
+        {
+            result = HTTPAPI_STRING_PROCESSING_ERROR;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        /*curl copies the URL*/
+        else if (curl_easy_setopt(request->curl, CURLOPT_URL, tempHostURL) != CURLE_OK)
+        {
+            result = HTTPAPI_SET_OPTION_FAILED;
+            LogError("failed to set CURLOPT_URL (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else if ((result = set_transfer_options(instance->settings, request->curl, ASYNC_HTTP_VERSION)) != HTTPAPI_OK)
+        {
+            LogError("failed to set the transfer options (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else if ((result = set_request_type(request->curl, requestType)) != HTTPAPI_OK)
+        {
+            LogError("failed to set the request type (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else if ((result = build_request_headers(httpHeadersHandle, headersCount, &request->headers)) != HTTPAPI_OK)
+        {
+            LogError("failed to build the request headers (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else if (
+            (curl_easy_setopt(request->curl, CURLOPT_HTTPHEADER, request->headers) != CURLE_OK) ||
+            (curl_easy_setopt(request->curl, CURLOPT_WRITEFUNCTION, (request->streaming.writeContent != NULL) ? StreamingWriteFunction : ContentWriteFunction) != CURLE_OK) ||
+            (curl_easy_setopt(request->curl, CURLOPT_WRITEDATA, (request->streaming.writeContent != NULL) ? (void*)&request->streaming : (void*)&request->responseContentBuffer) != CURLE_OK) ||
+            (curl_easy_setopt(request->curl, CURLOPT_HEADERFUNCTION, HeadersWriteFunction) != CURLE_OK) ||
+            (curl_easy_setopt(request->curl, CURLOPT_WRITEHEADER, request->responseHeaders) != CURLE_OK) ||
+            (curl_easy_setopt(request->curl, CURLOPT_PRIVATE, request) != CURLE_OK) ||
+            (curl_easy_setopt(request->curl, CURLOPT_SHARE, instance->share) != CURLE_OK)
+            )
+        {
+            result = HTTPAPI_SET_OPTION_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+#ifdef CURLPIPE_MULTIPLEX
+        /*wait for a connection that can be multiplexed rather than opening a new connection for every concurrent request*/
+        else if (curl_easy_setopt(request->curl, CURLOPT_PIPEWAIT, 1L) != CURLE_OK)
+        {
+            result = HTTPAPI_SET_OPTION_FAILED;
+            LogError("failed to set CURLOPT_PIPEWAIT (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+#endif
+        else if ((content != NULL) && (contentLength > 0))
+        {
+            /*the content is copied, the caller can release it as soon as httpapi_curl_async_execute_request returns*/
+            if ((curl_easy_setopt(request->curl, CURLOPT_POSTFIELDSIZE, (long)contentLength) != CURLE_OK) ||
+                (curl_easy_setopt(request->curl, CURLOPT_COPYPOSTFIELDS, (const char*)content) != CURLE_OK))
+            {
+                result = HTTPAPI_SET_OPTION_FAILED;
+                LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            }
+        }
+        else if (requestType != HTTPAPI_REQUEST_GET)
+        {
+            if ((curl_easy_setopt(request->curl, CURLOPT_POSTFIELDS, (void*)NULL) != CURLE_OK) ||
+                (curl_easy_setopt(request->curl, CURLOPT_POSTFIELDSIZE, 0L) != CURLE_OK))
+            {
+                result = HTTPAPI_SET_OPTION_FAILED;
+                LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            }
+        }
+        else
+        {
+            /*GET request cannot POST, so "do nothing*/
+        }
+
+        free(tempHostURL);
+    }
+
+    return result;
+}
+
+static void free_saved_option(HTTPAPI_CURL_ASYNC_SAVED_OPTION* savedOption)
+{
+    free(savedOption->optionName);
+    free((void*)savedOption->value);
+    free(savedOption);
+}
+
+static bool find_saved_option_by_name(LIST_ITEM_HANDLE list_item, const void* match_context)
+{
+    const HTTPAPI_CURL_ASYNC_SAVED_OPTION* savedOption = (const HTTPAPI_CURL_ASYNC_SAVED_OPTION*)singlylinkedlist_item_get_value(list_item);
+    return (strcmp(savedOption->optionName, (const char*)match_context) == 0);
+}
+
+HTTPAPI_CURL_ASYNC_HANDLE httpapi_curl_async_create(const char* hostName)
+{
+    HTTPAPI_CURL_ASYNC_INSTANCE* result;
+
+    if (hostName == NULL)
+    {
+        LogError("invalid arg const char* hostName = %p", hostName);
+        result = NULL;
+    }
+    else if ((result = (HTTPAPI_CURL_ASYNC_INSTANCE*)malloc(sizeof(HTTPAPI_CURL_ASYNC_INSTANCE))) == NULL)
+    {
+        LogError("unable to malloc");
+    }
+    else
+    {
+        bool isCreated = false;
+
+        result->multi = NULL;
+        result->share = NULL;
+        result->pendingRequests = NULL;
+        result->savedOptions = NULL;
+
+        if ((result->settings = (HTTP_HANDLE_DATA*)HTTPAPI_CreateConnection(hostName)) == NULL)
+        {
+            LogError("unable to create the template connection");
+        }
+        else if ((result->multi = curl_multi_init()) == NULL)
+        {
+            LogError("unable to curl_multi_init");
+        }
+        else if ((result->share = curl_share_init()) == NULL)
+        {
+            LogError("unable to curl_share_init");
+        }
+        else if (
+            (curl_share_setopt(result->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS) != CURLSHE_OK) ||
+            (curl_share_setopt(result->share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION) != CURLSHE_OK)
+            )
+        {
+            LogError("unable to curl_share_setopt");
+        }
+#ifdef CURLPIPE_MULTIPLEX
+        else if (curl_multi_setopt(result->multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX) != CURLM_OK)
+        {
+            LogError("unable to set CURLMOPT_PIPELINING");
+        }
+#endif
+        else if ((result->pendingRequests = singlylinkedlist_create()) == NULL)
+        {
+            LogError("unable to singlylinkedlist_create");
+        }
+        else if ((result->savedOptions = singlylinkedlist_create()) == NULL)
+        {
+            LogError("unable to singlylinkedlist_create");
+        }
+        else
+        {
+            /*all is fine*/
+            isCreated = true;
+        }
+
+        if (!isCreated)
+        {
+            if (result->pendingRequests != NULL)
+            {
+                singlylinkedlist_destroy(result->pendingRequests);
+            }
+            if (result->share != NULL)
+            {
+                (void)curl_share_cleanup(result->share);
+            }
+            if (result->multi != NULL)
+            {
+                (void)curl_multi_cleanup(result->multi);
+            }
+            HTTPAPI_CloseConnection((HTTP_HANDLE)result->settings);
+            free(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+void httpapi_curl_async_destroy(HTTPAPI_CURL_ASYNC_HANDLE handle)
+{
+    if (handle == NULL)
+    {
+        LogError("invalid arg HTTPAPI_CURL_ASYNC_HANDLE handle = %p", handle);
+    }
+    else
+    {
+        LIST_ITEM_HANDLE list_item;
+
+        while ((list_item = singlylinkedlist_get_head_item(handle->pendingRequests)) != NULL)
+        {
+            complete_async_request(handle, (HTTPAPI_CURL_ASYNC_REQUEST*)singlylinkedlist_item_get_value(list_item), HTTPAPI_ERROR);
+        }
+        singlylinkedlist_destroy(handle->pendingRequests);
+
+        while ((list_item = singlylinkedlist_get_head_item(handle->savedOptions)) != NULL)
+        {
+            free_saved_option((HTTPAPI_CURL_ASYNC_SAVED_OPTION*)singlylinkedlist_item_get_value(list_item));
+            (void)singlylinkedlist_remove(handle->savedOptions, list_item);
+        }
+        singlylinkedlist_destroy(handle->savedOptions);
+
+        (void)curl_multi_cleanup(handle->multi);
+        (void)curl_share_cleanup(handle->share);
+        HTTPAPI_CloseConnection((HTTP_HANDLE)handle->settings);
+        free(handle);
+    }
+}
+
+static HTTPAPI_RESULT execute_async_request(HTTPAPI_CURL_ASYNC_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content, size_t contentLength, HTTPAPI_WRITE_CONTENT writeContent, void* writeContentContext,
+    ON_HTTPAPI_CURL_REQUEST_COMPLETE on_request_complete, void* on_request_complete_context)
+{
+    HTTPAPI_RESULT result;
+    size_t headersCount;
+
+    if ((handle == NULL) ||
+        (relativePath == NULL) ||
+        (httpHeadersHandle == NULL) ||
+        ((content == NULL) && (contentLength > 0)) ||
+        (on_request_complete == NULL)
+        )
+    {
+        result = HTTPAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else if (HTTPHeaders_GetHeaderCount(httpHeadersHandle, &headersCount) != HTTP_HEADERS_OK)
+    {
+        result = HTTPAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else
+    {
+        HTTPAPI_CURL_ASYNC_REQUEST* request = (HTTPAPI_CURL_ASYNC_REQUEST*)malloc(sizeof(HTTPAPI_CURL_ASYNC_REQUEST));
+        if (request == NULL)
+        {
+            result = HTTPAPI_ALLOC_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else
+        {
+            request->headers = NULL;
+            request->responseContentBuffer.buffer = NULL;
+            request->responseContentBuffer.bufferSize = 0;
+            request->responseContentBuffer.bufferCapacity = 0;
+            request->responseContentBuffer.error = 0;
+            request->streaming.readContent = NULL;
+            request->streaming.readContentContext = NULL;
+            request->streaming.writeContent = writeContent;
+            request->streaming.writeContentContext = writeContentContext;
+            request->streaming.error = 0;
+            request->on_request_complete = on_request_complete;
+            request->on_request_complete_context = on_request_complete_context;
+
+            if ((request->curl = curl_easy_duphandle(handle->settings->curl)) == NULL)
+            {
+                result = HTTPAPI_ERROR;
+                LogError("unable to curl_easy_duphandle (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                free(request);
+            }
+            else if ((request->responseHeaders = HTTPHeaders_Alloc()) == NULL)
+            {
+                result = HTTPAPI_ALLOC_FAILED;
+                LogError("unable to HTTPHeaders_Alloc (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                curl_easy_cleanup(request->curl);
+                free(request);
+            }
+            else if ((result = setup_async_request(handle, request, requestType, relativePath, httpHeadersHandle, headersCount, content, contentLength)) != HTTPAPI_OK)
+            {
+                LogError("unable to setup the request (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                destroy_async_request(request);
+            }
+            else if ((request->list_item = singlylinkedlist_add(handle->pendingRequests, request)) == NULL)
+            {
+                result = HTTPAPI_ALLOC_FAILED;
+                LogError("unable to singlylinkedlist_add (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                destroy_async_request(request);
+            }
+            else if (curl_multi_add_handle(handle->multi, request->curl) != CURLM_OK)
+            {
+                result = HTTPAPI_ERROR;
+                LogError("unable to curl_multi_add_handle (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                (void)singlylinkedlist_remove(handle->pendingRequests, request->list_item);
+                destroy_async_request(request);
+            }
+            else
+            {
+                result = HTTPAPI_OK;
+            }
+        }
+    }
+
+    return result;
+}
+
+HTTPAPI_RESULT httpapi_curl_async_execute_request(HTTPAPI_CURL_ASYNC_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content, size_t contentLength,
+    ON_HTTPAPI_CURL_REQUEST_COMPLETE on_request_complete, void* on_request_complete_context)
+{
+    return execute_async_request(handle, requestType, relativePath, httpHeadersHandle, content, contentLength, NULL, NULL, on_request_complete, on_request_complete_context);
+}
+
+HTTPAPI_RESULT httpapi_curl_async_execute_request_streaming(HTTPAPI_CURL_ASYNC_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content, size_t contentLength, HTTPAPI_WRITE_CONTENT writeContent, void* writeContentContext,
+    ON_HTTPAPI_CURL_REQUEST_COMPLETE on_request_complete, void* on_request_complete_context)
+{
+    HTTPAPI_RESULT result;
+
+    if (writeContent == NULL)
+    {
+        result = HTTPAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else
+    {
+        result = execute_async_request(handle, requestType, relativePath, httpHeadersHandle, content, contentLength, writeContent, writeContentContext, on_request_complete, on_request_complete_context);
+    }
+
+    return result;
+}
+
+void httpapi_curl_async_dowork(HTTPAPI_CURL_ASYNC_HANDLE handle)
+{
+    if (handle == NULL)
+    {
+        LogError("invalid arg HTTPAPI_CURL_ASYNC_HANDLE handle = %p", handle);
+    }
+    else
+    {
+        int runningHandles;
+        CURLMcode multiResult = curl_multi_perform(handle->multi, &runningHandles);
+        if (multiResult != CURLM_OK)
+        {
+            LogError("curl_multi_perform() failed: %s", curl_multi_strerror(multiResult));
+        }
+        else
+        {
+            CURLMsg* message;
+            int messagesLeft;
+
+            while ((message = curl_multi_info_read(handle->multi, &messagesLeft)) != NULL)
+            {
+                if (message->msg == CURLMSG_DONE)
+                {
+                    /*message is invalidated by curl_multi_remove_handle, so everything needed is read before completing the request*/
+                    CURLcode curlRes = message->data.result;
+                    char* request = NULL;
+
+                    if ((curl_easy_getinfo(message->easy_handle, CURLINFO_PRIVATE, &request) != CURLE_OK) ||
+                        (request == NULL))
+                    {
+                        LogError("unable to find the request of a completed transfer");
+                        (void)curl_multi_remove_handle(handle->multi, message->easy_handle);
+                    }
+                    else
+                    {
+                        HTTPAPI_RESULT result;
+                        if (curlRes != CURLE_OK)
+                        {
+                            LogError("transfer failed: %s", curl_easy_strerror(curlRes));
+                            result = HTTPAPI_OPEN_REQUEST_FAILED;
+                        }
+                        else
+                        {
+                            result = HTTPAPI_OK;
+                        }
+                        complete_async_request(handle, (HTTPAPI_CURL_ASYNC_REQUEST*)request, result);
+                    }
+                }
+            }
+        }
+    }
+}
+
+int httpapi_curl_async_wait(HTTPAPI_CURL_ASYNC_HANDLE handle, unsigned int timeout_ms)
+{
+    int result;
+
+    if (handle == NULL)
+    {
+        LogError("invalid arg HTTPAPI_CURL_ASYNC_HANDLE handle = %p", handle);
+        result = __FAILURE__;
+    }
+    else
+    {
+        CURLMcode multiResult = curl_multi_wait(handle->multi, NULL, 0, (int)timeout_ms, NULL);
+        if (multiResult != CURLM_OK)
+        {
+            LogError("curl_multi_wait() failed: %s", curl_multi_strerror(multiResult));
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+HTTPAPI_RESULT httpapi_curl_async_set_option(HTTPAPI_CURL_ASYNC_HANDLE handle, const char* optionName, const void* value)
+{
+    HTTPAPI_RESULT result;
+
+    if ((handle == NULL) ||
+        (optionName == NULL) ||
+        (value == NULL))
+    {
+        result = HTTPAPI_INVALID_ARG;
+        LogError("invalid parameter (NULL) passed to httpapi_curl_async_set_option");
+    }
+    else
+    {
+        HTTPAPI_CURL_ASYNC_SAVED_OPTION* savedOption = (HTTPAPI_CURL_ASYNC_SAVED_OPTION*)malloc(sizeof(HTTPAPI_CURL_ASYNC_SAVED_OPTION));
+        if (savedOption == NULL)
+        {
+            result = HTTPAPI_ALLOC_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else if (mallocAndStrcpy_s(&savedOption->optionName, optionName) != 0)
+        {
+            result = HTTPAPI_ALLOC_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            free(savedOption);
+        }
+        else if ((result = HTTPAPI_CloneOption(optionName, value, &savedOption->value)) != HTTPAPI_OK)
+        {
+            LogError("unable to clone option %s (result = %s)", optionName, ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            free(savedOption->optionName);
+            free(savedOption);
+        }
+        else
+        {
+            LIST_ITEM_HANDLE savedOptionItem;
+            if ((savedOptionItem = singlylinkedlist_add(handle->savedOptions, savedOption)) == NULL)
+            {
+                result = HTTPAPI_ALLOC_FAILED;
+                LogError("unable to singlylinkedlist_add (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                free_saved_option(savedOption);
+            }
+            else
+            {
+                /*the previous value of the option, if any, is still used by the template connection until HTTPAPI_SetOption succeeds*/
+                LIST_ITEM_HANDLE previous = singlylinkedlist_find(handle->savedOptions, find_saved_option_by_name, optionName);
+
+                if ((result = HTTPAPI_SetOption((HTTP_HANDLE)handle->settings, optionName, savedOption->value)) != HTTPAPI_OK)
+                {
+                    LogError("unable to set option %s (result = %s)", optionName, ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                    (void)singlylinkedlist_remove(handle->savedOptions, savedOptionItem);
+                    free_saved_option(savedOption);
+                }
+                else if (previous != savedOptionItem)
+                {
+                    free_saved_option((HTTPAPI_CURL_ASYNC_SAVED_OPTION*)singlylinkedlist_item_get_value(previous));
+                    (void)singlylinkedlist_remove(handle->savedOptions, previous);
+                }
+            }
+        }
+    }
+
+    return result;
+}
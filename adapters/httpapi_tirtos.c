@@ -285,6 +285,15 @@ headersDone:
     return (HTTPAPI_OK);
 }
 
+HTTPAPI_RESULT HTTPAPI_ExecuteStreamingRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType,
+        const char* relativePath, HTTP_HEADERS_HANDLE httpHeadersHandle, size_t contentLength,
+        HTTPAPI_READ_CONTENT readContent, void* readContentContext, unsigned int* statusCode,
+        HTTP_HEADERS_HANDLE responseHeadersHandle, HTTPAPI_WRITE_CONTENT writeContent, void* writeContentContext)
+{
+    LogError("HTTPAPI_ExecuteStreamingRequest is not supported");
+    return (HTTPAPI_ERROR);
+}
+
 HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName,
         const void* value)
 {
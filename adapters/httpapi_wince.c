@@ -597,6 +597,26 @@ exit:
     return result;
 }
 
+HTTPAPI_RESULT HTTPAPI_ExecuteStreamingRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE httpHeadersHandle, size_t contentLength,
+    HTTPAPI_READ_CONTENT readContent, void* readContentContext, unsigned int* statusCode,
+    HTTP_HEADERS_HANDLE responseHeadersHandle, HTTPAPI_WRITE_CONTENT writeContent, void* writeContentContext)
+{
+    (void)handle;
+    (void)requestType;
+    (void)relativePath;
+    (void)httpHeadersHandle;
+    (void)contentLength;
+    (void)readContent;
+    (void)readContentContext;
+    (void)statusCode;
+    (void)responseHeadersHandle;
+    (void)writeContent;
+    (void)writeContentContext;
+    LogError("HTTPAPI_ExecuteStreamingRequest is not supported");
+    return HTTPAPI_ERROR;
+}
+
 HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName, const void* value)
 {
     HTTPAPI_RESULT result;
@@ -11,7 +11,10 @@
 #include "winhttp.h"
 #include "wincrypt.h"
 #include "azure_c_shared_utility/httpapi.h"
+#include "azure_c_shared_utility/httpapi_winhttp.h"
 #include "azure_c_shared_utility/httpheaders.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/strings.h"
 #include "azure_c_shared_utility/x509_schannel.h"
@@ -19,6 +22,8 @@
 
 DEFINE_ENUM_STRINGS(HTTPAPI_RESULT, HTTPAPI_RESULT_VALUES)
 
+#define STREAMING_BUFFER_SIZE 4096
+
 typedef enum HTTPAPI_STATE_TAG
 {
     HTTPAPI_NOT_INITIALIZED,
@@ -29,6 +34,8 @@ typedef struct HTTP_HANDLE_DATA_TAG
 {
     /*working set*/
     HINTERNET ConnectionHandle;
+    /*set when ConnectionHandle is the one cached for the host, shared with the other handles to it*/
+    bool isSharedConnection;
     X509_SCHANNEL_HANDLE x509SchannelHandle;
     /*options*/
     unsigned int timeout;
@@ -49,122 +56,99 @@ static HTTPAPI_STATE g_HTTPAPIState = HTTPAPI_NOT_INITIALIZED;
 static HINTERNET g_SessionHandle;
 static size_t nUsersOfHTTPAPI = 0; /*used for reference counting (a weak one)*/
 
-static char* ConcatHttpHeaders(HTTP_HEADERS_HANDLE httpHeadersHandle, size_t toAlloc, size_t headersCount)
+/*HTTPAPI_CreateConnection reuses one WinHttpConnect handle per host, kept until HTTPAPI_Deinit, so that the HTTP_HANDLEs
+to a host share its warm connections (and, with HTTP/2, multiplex their requests on one of them)*/
+typedef struct HTTPAPI_CACHED_CONNECTION_TAG
 {
-    char *result = (char*)malloc(toAlloc * sizeof(char) + 1);
-    size_t i;
-    
-    if (result == NULL)
+    char* hostName;
+    HINTERNET connectionHandle;
+} HTTPAPI_CACHED_CONNECTION;
+
+static LOCK_HANDLE g_ConnectionCacheLock;
+static SINGLYLINKEDLIST_HANDLE g_ConnectionCache; /*of HTTPAPI_CACHED_CONNECTION*, guarded by g_ConnectionCacheLock*/
+
+/*returns NULL if it failed to construct the headers*/
+static HTTPAPI_RESULT ConstructHeadersString(HTTP_HEADERS_HANDLE httpHeadersHandle, wchar_t** httpHeaders)
+{
+    HTTPAPI_RESULT result;
+    size_t headersSize;
+    char *httpHeadersA;
+
+    /*the headers are serialized as name: value\r\n in one pass, the first call only gets their size*/
+    if (HTTPHeaders_Serialize(httpHeadersHandle, NULL, 0, &headersSize) != HTTP_HEADERS_INSUFFICIENT_BUFFER)
     {
-        LogError("unable to malloc");
+        result = HTTPAPI_ERROR;
+        LogError("HTTPHeaders_Serialize failed (result = %s).", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else if ((httpHeadersA = (char*)malloc(headersSize + 1)) == NULL)
+    {
+        result = HTTPAPI_ALLOC_FAILED;
+        LogError("Cannot allocate memory (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
     }
     else
     {
-        result[0] = '\0';
-        for (i = 0; i < headersCount; i++)
+        size_t requiredCharactersForHeaders;
+
+        if (HTTPHeaders_Serialize(httpHeadersHandle, httpHeadersA, headersSize + 1, &headersSize) != HTTP_HEADERS_OK)
         {
-            char* temp;
-            if (HTTPHeaders_GetHeader(httpHeadersHandle, i, &temp) != HTTP_HEADERS_OK)
-            {
-                LogError("unable to HTTPHeaders_GetHeader");
-                break;
-            }
-            else
-            {
-                (void)strcat(result, temp);
-                (void)strcat(result, "\r\n");
-                free(temp);
-            }
+            result = HTTPAPI_ERROR;
+            LogError("Cannot concatenate headers");
         }
-    
-        if (i < headersCount)
+        else if ((requiredCharactersForHeaders = MultiByteToWideChar(CP_ACP, 0, httpHeadersA, -1, NULL, 0)) == 0)
         {
-            free(result);
-            result = NULL;
+            result = HTTPAPI_STRING_PROCESSING_ERROR;
+            LogError("MultiByteToWideChar failed, GetLastError=0x%08x (result = %s)", GetLastError(), ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else if ((*httpHeaders = (wchar_t*)malloc((requiredCharactersForHeaders + 1) * sizeof(wchar_t))) == NULL)
+        {
+            result = HTTPAPI_ALLOC_FAILED;
+            LogError("Cannot allocate memory (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else if (MultiByteToWideChar(CP_ACP, 0, httpHeadersA, -1, *httpHeaders, (int)requiredCharactersForHeaders) == 0)
+        {
+            result = HTTPAPI_STRING_PROCESSING_ERROR;
+            LogError("MultiByteToWideChar failed, GetLastError=0x%08x (result = %s)", GetLastError(), ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            free(*httpHeaders);
+            *httpHeaders = NULL;
         }
         else
         {
-            /*all is good*/
+            result = HTTPAPI_OK;
         }
+
+        free(httpHeadersA);
     }
 
     return result;
 }
 
-/*returns NULL if it failed to construct the headers*/
-static HTTPAPI_RESULT ConstructHeadersString(HTTP_HEADERS_HANDLE httpHeadersHandle, wchar_t** httpHeaders)
+static bool IsServerCertificateTrusted(HINTERNET requestHandle, const char* trustedCertificate)
 {
-    HTTPAPI_RESULT result;
-    size_t headersCount;
+    PCERT_CONTEXT pCertContext = NULL;
+    DWORD bufferLength = sizeof(pCertContext);
+    bool certificateTrusted;
 
-    if (HTTPHeaders_GetHeaderCount(httpHeadersHandle, &headersCount) != HTTP_HEADERS_OK)
+    if (! WinHttpQueryOption(requestHandle, WINHTTP_OPTION_SERVER_CERT_CONTEXT, (void*)&pCertContext, &bufferLength))
     {
-        result = HTTPAPI_ERROR;
-        LogError("HTTPHeaders_GetHeaderCount failed (result = %s).", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        LogErrorWinHTTPWithGetLastErrorAsString("WinHttpQueryOption(WINHTTP_OPTION_SERVER_CERT_CONTEXT) failed");
+        certificateTrusted = false;
+    }
+    else if (x509_verify_certificate_in_chain(trustedCertificate, pCertContext) != 0)
+    {
+        LogError("Certificate does not chain up correctly");
+        certificateTrusted = false;
     }
     else
     {
-        size_t i;
-
-        /*the total size of all the headers is given by sumof(lengthof(everyheader)+2)*/
-        size_t toAlloc = 0;
-        for (i = 0; i < headersCount; i++)
-        {
-            char *temp;
-            if (HTTPHeaders_GetHeader(httpHeadersHandle, i, &temp) == HTTP_HEADERS_OK)
-            {
-                toAlloc += strlen(temp);
-                toAlloc += 2;
-                free(temp);
-            }
-            else
-            {
-                LogError("HTTPHeaders_GetHeader failed");
-                break;
-            }
-        }
-
-        if (i < headersCount)
-        {
-            result = HTTPAPI_ERROR;
-        }
-        else
-        {
-            char *httpHeadersA;
-            size_t requiredCharactersForHeaders;
-
-            if ((httpHeadersA = ConcatHttpHeaders(httpHeadersHandle, toAlloc, headersCount)) == NULL)
-            {
-                result = HTTPAPI_ERROR;
-                LogError("Cannot concatenate headers");
-            }
-            else if ((requiredCharactersForHeaders = MultiByteToWideChar(CP_ACP, 0, httpHeadersA, -1, NULL, 0)) == 0)
-            {
-                result = HTTPAPI_STRING_PROCESSING_ERROR;
-                LogError("MultiByteToWideChar failed, GetLastError=0x%08x (result = %s)", GetLastError(), ENUM_TO_STRING(HTTPAPI_RESULT, result));
-            }
-            else if ((*httpHeaders = (wchar_t*)malloc((requiredCharactersForHeaders + 1) * sizeof(wchar_t))) == NULL)
-            {
-                result = HTTPAPI_ALLOC_FAILED;
-                LogError("Cannot allocate memory (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-            }
-            else if (MultiByteToWideChar(CP_ACP, 0, httpHeadersA, -1, *httpHeaders, (int)requiredCharactersForHeaders) == 0)
-            {
-                result = HTTPAPI_STRING_PROCESSING_ERROR;
-                LogError("MultiByteToWideChar failed, GetLastError=0x%08x (result = %s)", GetLastError(), ENUM_TO_STRING(HTTPAPI_RESULT, result));
-                free(*httpHeaders);
-                *httpHeaders = NULL;
-            }
-            else
-            {
-                result = HTTPAPI_OK;
-            }
+        certificateTrusted = true;
+    }
 
-            free(httpHeadersA);
-        }
+    if (pCertContext != NULL)
+    {
+        CertFreeCertificateContext(pCertContext);
     }
 
-    return result;
+    return certificateTrusted;
 }
 
 void CALLBACK httpapi_WinhttpStatusCallback(
@@ -189,43 +173,42 @@ void CALLBACK httpapi_WinhttpStatusCallback(
         // Silently ignore if there's any statuses we get that we can't handle
         ;
     }
-    else if (handleData->trustedCertificate != NULL)
+    else if ((handleData->trustedCertificate != NULL) &&
+        !IsServerCertificateTrusted(hInternet, handleData->trustedCertificate))
     {
-        PCERT_CONTEXT pCertContext = NULL;
-        DWORD bufferLength = sizeof(pCertContext);
-        bool certificateTrusted;
+        LogError("Server certificate is not trusted.  Aborting HTTP request");
+        // To signal to caller that the request is to be terminated, the callback closes the handle.
+        WinHttpCloseHandle(hInternet);
+        // To avoid a double free of this handle (in HTTPAPI_ExecuteRequset cleanup) record we've processed close already.
+        handleData->handleClosedOnCallbackError = true;
+    }
+}
 
-        if (! WinHttpQueryOption(hInternet, WINHTTP_OPTION_SERVER_CERT_CONTEXT, (void*)&pCertContext, &bufferLength))
-        {
-            LogErrorWinHTTPWithGetLastErrorAsString("WinHttpQueryOption(WINHTTP_OPTION_SERVER_CERT_CONTEXT) failed");
-            certificateTrusted = false;
-        }
-        else if (x509_verify_certificate_in_chain(handleData->trustedCertificate, pCertContext) != 0)
-        {
-            LogError("Certificate does not chain up correctly");
-            certificateTrusted = false;
-        }
-        else
-        {
-            certificateTrusted = true;
-        }
 
-        if (certificateTrusted == false)
-        {
-            LogError("Server certificate is not trusted.  Aborting HTTP request");
-            // To signal to caller that the request is to be terminated, the callback closes the handle.
-            WinHttpCloseHandle(hInternet);
-            // To avoid a double free of this handle (in HTTPAPI_ExecuteRequset cleanup) record we've processed close already.
-            handleData->handleClosedOnCallbackError = true;
-        }
+static bool find_cached_connection_by_host_name(LIST_ITEM_HANDLE list_item, const void* match_context)
+{
+    const HTTPAPI_CACHED_CONNECTION* cachedConnection = (const HTTPAPI_CACHED_CONNECTION*)singlylinkedlist_item_get_value(list_item);
+    return (strcmp(cachedConnection->hostName, (const char*)match_context) == 0);
+}
 
-        if (pCertContext != NULL)
-        {
-            CertFreeCertificateContext(pCertContext);
-        }
+static void DestroyConnectionCache(void)
+{
+    LIST_ITEM_HANDLE list_item;
+
+    while ((list_item = singlylinkedlist_get_head_item(g_ConnectionCache)) != NULL)
+    {
+        HTTPAPI_CACHED_CONNECTION* cachedConnection = (HTTPAPI_CACHED_CONNECTION*)singlylinkedlist_item_get_value(list_item);
+        (void)WinHttpCloseHandle(cachedConnection->connectionHandle);
+        free(cachedConnection->hostName);
+        free(cachedConnection);
+        (void)singlylinkedlist_remove(g_ConnectionCache, list_item);
     }
-}
 
+    singlylinkedlist_destroy(g_ConnectionCache);
+    g_ConnectionCache = NULL;
+    Lock_Deinit(g_ConnectionCacheLock);
+    g_ConnectionCacheLock = NULL;
+}
 
 HTTPAPI_RESULT HTTPAPI_Init(void)
 {
@@ -233,7 +216,19 @@ HTTPAPI_RESULT HTTPAPI_Init(void)
 
     if (nUsersOfHTTPAPI == 0)
     {
-        if ((g_SessionHandle = WinHttpOpen(
+        if ((g_ConnectionCacheLock = Lock_Init()) == NULL)
+        {
+            LogError("Lock_Init failed.");
+            result = HTTPAPI_INIT_FAILED;
+        }
+        else if ((g_ConnectionCache = singlylinkedlist_create()) == NULL)
+        {
+            LogError("singlylinkedlist_create failed.");
+            Lock_Deinit(g_ConnectionCacheLock);
+            g_ConnectionCacheLock = NULL;
+            result = HTTPAPI_INIT_FAILED;
+        }
+        else if ((g_SessionHandle = WinHttpOpen(
             NULL,
             WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
             WINHTTP_NO_PROXY_NAME,
@@ -241,6 +236,7 @@ HTTPAPI_RESULT HTTPAPI_Init(void)
             0)) == NULL)
         {
             LogErrorWinHTTPWithGetLastErrorAsString("WinHttpOpen failed.");
+            DestroyConnectionCache();
             result = HTTPAPI_INIT_FAILED;
         }
         else if (WinHttpSetStatusCallback(g_SessionHandle, httpapi_WinhttpStatusCallback, WINHTTP_CALLBACK_FLAG_SEND_REQUEST, 0) == WINHTTP_INVALID_STATUS_CALLBACK)
@@ -248,10 +244,19 @@ HTTPAPI_RESULT HTTPAPI_Init(void)
             LogErrorWinHTTPWithGetLastErrorAsString("WinHttpSetStatusCallback failed.");
             (void)WinHttpCloseHandle(g_SessionHandle);
             g_SessionHandle = NULL;
+            DestroyConnectionCache();
             result = HTTPAPI_INIT_FAILED;
         }
         else
         {
+#ifdef WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL
+            /*the requests of the handles to a host share its connection when HTTP/2 is negotiated, older systems do not know the option and keep HTTP/1.1*/
+            DWORD protocols = WINHTTP_PROTOCOL_FLAG_HTTP2;
+            if (!WinHttpSetOption(g_SessionHandle, WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL, &protocols, sizeof(protocols)))
+            {
+                LogInfo("HTTP/2 is not available, using HTTP/1.1");
+            }
+#endif
             nUsersOfHTTPAPI++;
             g_HTTPAPIState = HTTPAPI_INITIALIZED;
             result = HTTPAPI_OK;
@@ -275,6 +280,8 @@ void HTTPAPI_Deinit(void)
         {
             if (g_SessionHandle != NULL)
             {
+                /*the cached connections are children of the session, they are closed first*/
+                DestroyConnectionCache();
                 (void)WinHttpCloseHandle(g_SessionHandle);
                 g_SessionHandle = NULL;
                 g_HTTPAPIState = HTTPAPI_NOT_INITIALIZED;
@@ -285,72 +292,172 @@ void HTTPAPI_Deinit(void)
 
 }
 
-HTTP_HANDLE HTTPAPI_CreateConnection(const char* hostName)
+static HINTERNET ConnectToHost(HINTERNET sessionHandle, const char* hostName)
 {
-    HTTP_HANDLE_DATA* result;
-    if (g_HTTPAPIState != HTTPAPI_INITIALIZED)
+    HINTERNET result;
+    wchar_t* hostNameTemp;
+    size_t hostNameTemp_size = MultiByteToWideChar(CP_ACP, 0, hostName, -1, NULL, 0);
+    if (hostNameTemp_size == 0)
     {
-        LogError("g_HTTPAPIState not HTTPAPI_INITIALIZED");
+        LogError("MultiByteToWideChar failed");
+        result = NULL;
+    }
+    else if ((hostNameTemp = (wchar_t*)malloc(sizeof(wchar_t) * hostNameTemp_size)) == NULL)
+    {
+        LogError("malloc failed");
+        result = NULL;
+    }
+    else
+    {
+        if (MultiByteToWideChar(CP_ACP, 0, hostName, -1, hostNameTemp, (int)hostNameTemp_size) == 0)
+        {
+            LogError("MultiByteToWideChar failed");
+            result = NULL;
+        }
+        else if ((result = WinHttpConnect(
+            sessionHandle,
+            hostNameTemp,
+            INTERNET_DEFAULT_HTTPS_PORT,
+            0)) == NULL)
+        {
+            LogErrorWinHTTPWithGetLastErrorAsString("WinHttpConnect returned NULL.");
+        }
+        free(hostNameTemp);
+    }
+
+    return result;
+}
+
+/*gives the connection to hostName cached in g_SessionHandle, connecting once for all the handles to the host*/
+static HINTERNET AcquireCachedConnection(const char* hostName)
+{
+    HINTERNET result;
+
+    if (Lock(g_ConnectionCacheLock) != LOCK_OK)
+    {
+        LogError("unable to Lock");
         result = NULL;
     }
     else
     {
-        result = (HTTP_HANDLE_DATA*)malloc(sizeof(HTTP_HANDLE_DATA));
-        if (result == NULL)
+        LIST_ITEM_HANDLE list_item = singlylinkedlist_find(g_ConnectionCache, find_cached_connection_by_host_name, hostName);
+        if (list_item != NULL)
         {
-            LogError("malloc returned NULL.");
+            result = ((HTTPAPI_CACHED_CONNECTION*)singlylinkedlist_item_get_value(list_item))->connectionHandle;
         }
         else
         {
-            memset(result, 0, sizeof(*result));
-            wchar_t* hostNameTemp;
-            size_t hostNameTemp_size = MultiByteToWideChar(CP_ACP, 0, hostName, -1, NULL, 0);
-            if (hostNameTemp_size == 0)
+            HTTPAPI_CACHED_CONNECTION* cachedConnection = (HTTPAPI_CACHED_CONNECTION*)malloc(sizeof(HTTPAPI_CACHED_CONNECTION));
+            if (cachedConnection == NULL)
             {
-                LogError("MultiByteToWideChar failed");
-                free(result);
+                LogError("malloc failed");
+                result = NULL;
+            }
+            else if (mallocAndStrcpy_s(&cachedConnection->hostName, hostName) != 0)
+            {
+                LogError("mallocAndStrcpy_s failed");
+                free(cachedConnection);
+                result = NULL;
+            }
+            else if ((cachedConnection->connectionHandle = ConnectToHost(g_SessionHandle, hostName)) == NULL)
+            {
+                free(cachedConnection->hostName);
+                free(cachedConnection);
+                result = NULL;
+            }
+            else if (singlylinkedlist_add(g_ConnectionCache, cachedConnection) == NULL)
+            {
+                LogError("singlylinkedlist_add failed");
+                (void)WinHttpCloseHandle(cachedConnection->connectionHandle);
+                free(cachedConnection->hostName);
+                free(cachedConnection);
                 result = NULL;
             }
             else
             {
-                hostNameTemp = (wchar_t*)malloc(sizeof(wchar_t) * hostNameTemp_size);
-                if (hostNameTemp == NULL)
-                {
-                    LogError("malloc failed");
-                    free(result);
-                    result = NULL;
-                }
-                else
-                {
-                    if (MultiByteToWideChar(CP_ACP, 0, hostName, -1, hostNameTemp, (int)hostNameTemp_size) == 0)
-                    {
-                        LogError("MultiByteToWideChar failed");
-                        free(result);
-                        result = NULL;
-                    }
-                    else
-                    {
-                        result->ConnectionHandle = WinHttpConnect(
-                            g_SessionHandle,
-                            hostNameTemp,
-                            INTERNET_DEFAULT_HTTPS_PORT,
-                            0);
-
-                        if (result->ConnectionHandle == NULL)
-                        {
-                            LogErrorWinHTTPWithGetLastErrorAsString("WinHttpConnect returned NULL.");
-                            free(result);
-                            result = NULL;
-                        }
-                        else
-                        {
-                            result->timeout = 60000;
-                        }
-                    }
-                    free(hostNameTemp);
-                }
+                result = cachedConnection->connectionHandle;
             }
         }
+
+        (void)Unlock(g_ConnectionCacheLock);
+    }
+
+    return result;
+}
+
+/*the connections of HTTPAPI_CreateConnection are the ones cached in g_SessionHandle, the ones of the asynchronous API are
+connected in their instance's session*/
+static HTTP_HANDLE_DATA* CreateConnectionData(HINTERNET sessionHandle, const char* hostName, bool isSharedConnection)
+{
+    HTTP_HANDLE_DATA* result = (HTTP_HANDLE_DATA*)malloc(sizeof(HTTP_HANDLE_DATA));
+    if (result == NULL)
+    {
+        LogError("malloc returned NULL.");
+    }
+    else
+    {
+        memset(result, 0, sizeof(*result));
+        result->ConnectionHandle = isSharedConnection ? AcquireCachedConnection(hostName) : ConnectToHost(sessionHandle, hostName);
+        if (result->ConnectionHandle == NULL)
+        {
+            LogError("unable to connect to %s", hostName);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result->isSharedConnection = isSharedConnection;
+            result->timeout = 60000;
+        }
+    }
+
+    return result;
+}
+
+static void CloseConnectionData(HTTP_HANDLE_DATA* handleData)
+{
+    if (handleData->ConnectionHandle != NULL)
+    {
+        if (!handleData->isSharedConnection)
+        {
+            /*a cached connection stays open for the next handles to the host, until HTTPAPI_Deinit*/
+            (void)WinHttpCloseHandle(handleData->ConnectionHandle);
+        }
+        /*no x509 free because the options are owned by httpapiex.*/
+        handleData->ConnectionHandle = NULL;
+    }
+    if (handleData->proxy_host != NULL)
+    {
+        free((void*)handleData->proxy_host);
+    }
+    if (handleData->proxy_username != NULL)
+    {
+        free((void*)handleData->proxy_username);
+    }
+    if (handleData->proxy_password != NULL)
+    {
+        free((void*)handleData->proxy_password);
+    }
+    x509_schannel_destroy(handleData->x509SchannelHandle);
+    free(handleData);
+}
+
+HTTP_HANDLE HTTPAPI_CreateConnection(const char* hostName)
+{
+    HTTP_HANDLE_DATA* result;
+    if (g_HTTPAPIState != HTTPAPI_INITIALIZED)
+    {
+        LogError("g_HTTPAPIState not HTTPAPI_INITIALIZED");
+        result = NULL;
+    }
+    else if (hostName == NULL)
+    {
+        LogError("invalid arg hostName = NULL");
+        result = NULL;
+    }
+    else
+    {
+        result = CreateConnectionData(g_SessionHandle, hostName, true);
     }
 
     return (HTTP_HANDLE)result;
@@ -368,26 +475,7 @@ void HTTPAPI_CloseConnection(HTTP_HANDLE handle)
 
         if (handleData != NULL)
         {
-            if (handleData->ConnectionHandle != NULL)
-            {
-                (void)WinHttpCloseHandle(handleData->ConnectionHandle);
-                /*no x509 free because the options are owned by httpapiex.*/
-                handleData->ConnectionHandle = NULL;
-            }
-            if (handleData->proxy_host != NULL)
-            {
-                free((void*)handleData->proxy_host);
-            }
-            if (handleData->proxy_username != NULL)
-            {
-                free((void*)handleData->proxy_username);
-            }
-            if (handleData->proxy_password != NULL)
-            {
-                free((void*)handleData->proxy_password);
-            }
-            x509_schannel_destroy(handleData->x509SchannelHandle);
-            free(handleData);
+            CloseConnectionData(handleData);
         }
     }
 }
@@ -490,7 +578,9 @@ static HTTPAPI_RESULT InitiateWinhttpRequest(HTTP_HANDLE_DATA* handleData, HTTPA
     return result;
 }
 
-static HTTPAPI_RESULT SendHttpRequest(HTTP_HANDLE_DATA* handleData, HINTERNET requestHandle, const unsigned char* content, size_t contentLength, const wchar_t* httpHeaders)
+/*totalLength is contentLength, unless the rest of the body is written afterwards by SendStreamedHttpRequestContent*/
+/*context is passed to the status callback of the session*/
+static HTTPAPI_RESULT SendHttpRequest(HTTP_HANDLE_DATA* handleData, HINTERNET requestHandle, const unsigned char* content, size_t contentLength, size_t totalLength, const wchar_t* httpHeaders, DWORD_PTR context)
 {
     HTTPAPI_RESULT result;
 
@@ -535,8 +625,8 @@ static HTTPAPI_RESULT SendHttpRequest(HTTP_HANDLE_DATA* handleData, HINTERNET re
                 (DWORD)-1L, /*An unsigned long integer value that contains the length, in characters, of the additional headers. If this parameter is -1L ... */
                 (void*)content,
                 (DWORD)contentLength,
-                (DWORD)contentLength,
-                (DWORD_PTR)handleData))
+                (DWORD)totalLength,
+                context))
         {
             result = HTTPAPI_SEND_REQUEST_FAILED;
             LogErrorWinHTTPWithGetLastErrorAsString("WinHttpSendRequest: (result = %s).", ENUM_TO_STRING(HTTPAPI_RESULT, result));
@@ -550,6 +640,37 @@ static HTTPAPI_RESULT SendHttpRequest(HTTP_HANDLE_DATA* handleData, HINTERNET re
     return result;    
 }
     
+static HTTPAPI_RESULT SendStreamedHttpRequestContent(HINTERNET requestHandle, size_t contentLength, HTTPAPI_READ_CONTENT readContent, void* readContentContext)
+{
+    HTTPAPI_RESULT result = HTTPAPI_OK;
+    unsigned char buffer[STREAMING_BUFFER_SIZE];
+
+    while ((contentLength > 0) && (result == HTTPAPI_OK))
+    {
+        size_t bytesRead = 0;
+        DWORD bytesWritten;
+
+        if ((readContent(readContentContext, buffer, (contentLength < sizeof(buffer)) ? contentLength : sizeof(buffer), &bytesRead) != 0) ||
+            (bytesRead == 0) ||
+            (bytesRead > contentLength))
+        {
+            result = HTTPAPI_ERROR;
+            LogError("the request content could not be read (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else if (!WinHttpWriteData(requestHandle, buffer, (DWORD)bytesRead, &bytesWritten))
+        {
+            result = HTTPAPI_SEND_REQUEST_FAILED;
+            LogErrorWinHTTPWithGetLastErrorAsString("WinHttpWriteData failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else
+        {
+            contentLength -= bytesRead;
+        }
+    }
+
+    return result;
+}
+
 static HTTPAPI_RESULT SetProxyIfNecessary(HTTP_HANDLE_DATA* handleData, HINTERNET requestHandle)
 {
     HTTPAPI_RESULT result;
@@ -630,51 +751,83 @@ static HTTPAPI_RESULT SetProxyIfNecessary(HTTP_HANDLE_DATA* handleData, HINTERNE
     return result;
 }
 
-static HTTPAPI_RESULT ReceiveResponseAndStatusCode(HINTERNET requestHandle, unsigned int* statusCode)
+static HTTPAPI_RESULT QueryStatusCode(HINTERNET requestHandle, unsigned int* statusCode)
 {
     HTTPAPI_RESULT result;
+    DWORD dwStatusCode = 0;
+    DWORD dwBufferLength = sizeof(DWORD);
 
-    if (!WinHttpReceiveResponse(
+    if (!WinHttpQueryHeaders(
         requestHandle,
-        0))
-    {
-        result = HTTPAPI_RECEIVE_RESPONSE_FAILED;
-        LogErrorWinHTTPWithGetLastErrorAsString("WinHttpReceiveResponse: (result = %s).", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-    }
-    else if (statusCode != NULL)
+        WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
+        WINHTTP_HEADER_NAME_BY_INDEX,
+        &dwStatusCode,
+        &dwBufferLength,
+        WINHTTP_NO_HEADER_INDEX))
     {
-        DWORD dwStatusCode = 0;
-        DWORD dwBufferLength = sizeof(DWORD);
-    
-        if (!WinHttpQueryHeaders(
-            requestHandle,
-            WINHTTP_QUERY_STATUS_CODE | WINHTTP_QUERY_FLAG_NUMBER,
-            WINHTTP_HEADER_NAME_BY_INDEX,
-            &dwStatusCode,
-            &dwBufferLength,
-            WINHTTP_NO_HEADER_INDEX))
-        {
-            result = HTTPAPI_QUERY_HEADERS_FAILED;
-            LogErrorWinHTTPWithGetLastErrorAsString("WinHttpQueryHeaders failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
-        }
-        else
-        {
-            *statusCode = dwStatusCode;
-            result = HTTPAPI_OK;
-        }
+        result = HTTPAPI_QUERY_HEADERS_FAILED;
+        LogErrorWinHTTPWithGetLastErrorAsString("WinHttpQueryHeaders failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
     }
     else
     {
+        *statusCode = dwStatusCode;
         result = HTTPAPI_OK;
     }
 
     return result;
 }
 
-static HTTPAPI_RESULT ReceiveResponseContent(HINTERNET requestHandle, BUFFER_HANDLE responseContent)
+static HTTPAPI_RESULT ReceiveResponseAndStatusCode(HINTERNET requestHandle, unsigned int* statusCode)
 {
     HTTPAPI_RESULT result;
-    DWORD responseBytesAvailable;
+
+    if (!WinHttpReceiveResponse(
+        requestHandle,
+        0))
+    {
+        result = HTTPAPI_RECEIVE_RESPONSE_FAILED;
+        LogErrorWinHTTPWithGetLastErrorAsString("WinHttpReceiveResponse: (result = %s).", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else if (statusCode != NULL)
+    {
+        result = QueryStatusCode(requestHandle, statusCode);
+    }
+    else
+    {
+        result = HTTPAPI_OK;
+    }
+
+    return result;
+}
+
+/*when the response has a Content-Length, the content buffer is grown once to hold all of it instead of once per chunk read*/
+static void ReserveResponseContent(HINTERNET requestHandle, BUFFER_HANDLE responseContent)
+{
+    DWORD contentLength = 0;
+    DWORD bufferLength = sizeof(DWORD);
+
+    /*there is no Content-Length for chunked responses, the buffer then grows as data arrives*/
+    if (WinHttpQueryHeaders(
+            requestHandle,
+            WINHTTP_QUERY_CONTENT_LENGTH | WINHTTP_QUERY_FLAG_NUMBER,
+            WINHTTP_HEADER_NAME_BY_INDEX,
+            &contentLength,
+            &bufferLength,
+            WINHTTP_NO_HEADER_INDEX) &&
+        (contentLength > 0) &&
+        (BUFFER_reserve(responseContent, BUFFER_length(responseContent) + contentLength) != 0))
+    {
+        /*not fatal, the reads enlarge the buffer as needed*/
+        LogError("unable to reserve %lu bytes for the response content", (unsigned long)contentLength);
+    }
+}
+
+static HTTPAPI_RESULT ReceiveResponseContent(HINTERNET requestHandle, BUFFER_HANDLE responseContent)
+{
+    HTTPAPI_RESULT result;
+    DWORD responseBytesAvailable;
+
+    ReserveResponseContent(requestHandle, responseContent);
 
     while (true)
     {
@@ -777,74 +930,88 @@ static HTTPAPI_RESULT ReceiveResponseHeaders(HINTERNET requestHandle, HTTP_HEADE
         result = HTTPAPI_QUERY_HEADERS_FAILED;
         LogErrorWinHTTPWithGetLastErrorAsString("WinHttpQueryHeaders failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
     }
-    else    
+    else
     {
-        wchar_t *next_token;
-        wchar_t* token = wcstok_s(responseHeadersTemp, L"\r\n", &next_token);
-        char* tokenTemp = NULL;     
-
-        result = HTTPAPI_OK;
+        /*the whole block is converted at once and handed over unparsed, it is only split into headers if they are read*/
+        int headersSize = WideCharToMultiByte(CP_ACP, 0, responseHeadersTemp, -1, NULL, 0, NULL, NULL);
+        char* headers;
 
-        while ((token != NULL) &&
-            (token[0] != L'\0'))
+        if (headersSize <= 0)
         {
-            size_t tokenTemp_size;
-
-            tokenTemp_size = WideCharToMultiByte(CP_ACP, 0, token, -1, NULL, 0, NULL, NULL);
-            if (tokenTemp_size == 0)
+            result = HTTPAPI_STRING_PROCESSING_ERROR;
+            LogError("WideCharToMultiByte failed");
+        }
+        else if ((headers = (char*)malloc(headersSize)) == NULL)
+        {
+            result = HTTPAPI_ALLOC_FAILED;
+            LogError("malloc failed");
+        }
+        else
+        {
+            if (WideCharToMultiByte(CP_ACP, 0, responseHeadersTemp, -1, headers, headersSize, NULL, NULL) == 0)
             {
                 result = HTTPAPI_STRING_PROCESSING_ERROR;
                 LogError("WideCharToMultiByte failed");
-                break;
             }
-            else if ((tokenTemp = (char*)malloc(sizeof(char) * tokenTemp_size)) == NULL)
+            /*the status line that comes first has no ':', it is ignored as a header*/
+            else if (HTTPHeaders_AppendHeaderLines(responseHeadersHandle, headers, (size_t)headersSize - 1) != HTTP_HEADERS_OK)
             {
-                result = HTTPAPI_ALLOC_FAILED;
-                LogError("malloc failed");
-                break;
-            }
-            else if (WideCharToMultiByte(CP_ACP, 0, token, -1, tokenTemp, (int)tokenTemp_size, NULL, NULL) == 0)
-            {
-                result = HTTPAPI_STRING_PROCESSING_ERROR;
-                LogError("WideCharToMultiByte failed");
-                break;
+                LogError("HTTPHeaders_AppendHeaderLines failed");
+                result = HTTPAPI_HTTP_HEADERS_FAILED;
             }
             else
             {
-                /*breaking the token in 2 parts: everything before the first ":" and everything after the first ":"*/
-                /*if there is no such character, then skip it*/
-                /*if there is a : then replace is by a '\0' and so it breaks the original string in name and value*/
-                char* whereIsColon = strchr(tokenTemp, ':');
-                if (whereIsColon != NULL)
-                {
-                    *whereIsColon = '\0';
-                    if (HTTPHeaders_AddHeaderNameValuePair(responseHeadersHandle, tokenTemp, whereIsColon + 1) != HTTP_HEADERS_OK)
-                    {
-                        LogError("HTTPHeaders_AddHeaderNameValuePair failed");
-                        result = HTTPAPI_HTTP_HEADERS_FAILED;
-                        break;
-                    }
-                }
+                result = HTTPAPI_OK;
             }
-            free(tokenTemp);
-            tokenTemp = NULL;
 
-            token = wcstok_s(NULL, L"\r\n", &next_token);
+            free(headers);
         }
-
-        free(tokenTemp);
-        tokenTemp = NULL;
     }
 
     free(responseHeadersTemp);
     return result;
 }
 
+static HTTPAPI_RESULT ReceiveStreamedResponseContent(HINTERNET requestHandle, HTTPAPI_WRITE_CONTENT writeContent, void* writeContentContext)
+{
+    HTTPAPI_RESULT result;
+    unsigned char buffer[STREAMING_BUFFER_SIZE];
 
-HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    while (true)
+    {
+        DWORD bytesReceived;
+        /*WinHttpReadData used synchronously blocks until data is available and returns 0 bytes at the end of the response*/
+        if (!WinHttpReadData(requestHandle, buffer, sizeof(buffer), &bytesReceived))
+        {
+            result = HTTPAPI_READ_DATA_FAILED;
+            LogErrorWinHTTPWithGetLastErrorAsString("WinHttpReadData failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            break;
+        }
+        else if (bytesReceived == 0)
+        {
+            result = HTTPAPI_OK;
+            break;
+        }
+        else if ((writeContent != NULL) && (writeContent(writeContentContext, buffer, bytesReceived) != 0))
+        {
+            result = HTTPAPI_READ_DATA_FAILED;
+            LogError("the response content could not be written (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            break;
+        }
+        else
+        {
+            /*all is fine, keep going*/
+        }
+    }
+
+    return result;
+}
+
+/*readContent/writeContent are only used by HTTPAPI_ExecuteStreamingRequest, they replace content/responseContent*/
+static HTTPAPI_RESULT ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
     HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content,
-    size_t contentLength, unsigned int* statusCode,
-    HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent)
+    size_t contentLength, HTTPAPI_READ_CONTENT readContent, void* readContentContext, unsigned int* statusCode,
+    HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent, bool streamResponse, HTTPAPI_WRITE_CONTENT writeContent, void* writeContentContext)
 {
     HTTPAPI_RESULT result;
 
@@ -878,10 +1045,14 @@ HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE r
         {
             LogError("Cannot construct http headers");
         }
-        else if ((result = SendHttpRequest(handleData, requestHandle, content, contentLength, httpHeaders)) != HTTPAPI_OK)
+        else if ((result = SendHttpRequest(handleData, requestHandle, content, (readContent != NULL) ? 0 : contentLength, contentLength, httpHeaders, (DWORD_PTR)handleData)) != HTTPAPI_OK)
         {
             LogError("Cannot set options / send http request");
         }
+        else if ((readContent != NULL) && ((result = SendStreamedHttpRequestContent(requestHandle, contentLength, readContent, readContentContext)) != HTTPAPI_OK))
+        {
+            LogError("Cannot send the http request content");
+        }
         else if ((result = ReceiveResponseAndStatusCode(requestHandle, statusCode)) != HTTPAPI_OK)
         {
             LogError("failed receiving response and/or headeders");
@@ -890,6 +1061,10 @@ HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE r
         {
             LogError("failed to receive response content");
         }
+        else if (streamResponse && ((result = ReceiveStreamedResponseContent(requestHandle, writeContent, writeContentContext)) != HTTPAPI_OK))
+        {
+            LogError("failed to receive streamed response content");
+        }
         else if ((responseHeadersHandle != NULL) && ((result = ReceiveResponseHeaders(requestHandle, responseHeadersHandle)) != HTTPAPI_OK))
         {
             LogError("Unable to retrieve http response headers");
@@ -911,6 +1086,35 @@ HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE r
     return result;
 }
 
+HTTPAPI_RESULT HTTPAPI_ExecuteRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content,
+    size_t contentLength, unsigned int* statusCode,
+    HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent)
+{
+    return ExecuteRequest(handle, requestType, relativePath, httpHeadersHandle, content, contentLength, NULL, NULL, statusCode, responseHeadersHandle, responseContent, false, NULL, NULL);
+}
+
+HTTPAPI_RESULT HTTPAPI_ExecuteStreamingRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE httpHeadersHandle, size_t contentLength,
+    HTTPAPI_READ_CONTENT readContent, void* readContentContext, unsigned int* statusCode,
+    HTTP_HEADERS_HANDLE responseHeadersHandle, HTTPAPI_WRITE_CONTENT writeContent, void* writeContentContext)
+{
+    HTTPAPI_RESULT result;
+
+    if ((readContent == NULL) && (contentLength > 0))
+    {
+        result = HTTPAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else
+    {
+        result = ExecuteRequest(handle, requestType, relativePath, httpHeadersHandle, NULL, contentLength, (contentLength > 0) ? readContent : NULL, readContentContext,
+            statusCode, responseHeadersHandle, NULL, true, writeContent, writeContentContext);
+    }
+
+    return result;
+}
+
 HTTPAPI_RESULT HTTPAPI_SetOption(HTTP_HANDLE handle, const char* optionName, const void* value)
 {
     HTTPAPI_RESULT result;
@@ -1221,3 +1425,758 @@ HTTPAPI_RESULT HTTPAPI_CloneOption(const char* optionName, const void* value, co
     }
     return result;
 }
+
+/*asynchronous API: every instance owns a WINHTTP_FLAG_ASYNC session. The status callback runs on the WinHTTP thread pool and
+drives each request through send, receive response, query data available and read data. Once the request handle is closed
+(WINHTTP_CALLBACK_STATUS_HANDLE_CLOSING is the last callback of a handle) the request is queued for httpapi_winhttp_async_dowork,
+which calls the completion callback on the caller's thread.*/
+typedef struct HTTPAPI_WINHTTP_ASYNC_REQUEST_TAG
+{
+    HTTPAPI_WINHTTP_ASYNC_HANDLE instance;
+    HINTERNET requestHandle;
+    wchar_t* httpHeaders;
+    unsigned char* content;
+    size_t contentLength;
+    char* trustedCertificate;
+    unsigned int statusCode;
+    HTTP_HEADERS_HANDLE responseHeaders;
+    /*the buffer is only enlarged, receivedLength is the length of the content*/
+    BUFFER_HANDLE responseContent;
+    size_t receivedLength;
+    HTTPAPI_RESULT result;
+    /*guarded by the instance lock*/
+    bool closeRequested;
+    /*false when httpapi_winhttp_async_execute_request failed after the handle got its context, the callback is then not called*/
+    bool notify;
+    LIST_ITEM_HANDLE list_item;
+    ON_HTTPAPI_WINHTTP_REQUEST_COMPLETE on_request_complete;
+    void* on_request_complete_context;
+} HTTPAPI_WINHTTP_ASYNC_REQUEST;
+
+typedef struct HTTPAPI_WINHTTP_ASYNC_SAVED_OPTION_TAG
+{
+    char* optionName;
+    const void* value;
+} HTTPAPI_WINHTTP_ASYNC_SAVED_OPTION;
+
+typedef struct HTTPAPI_WINHTTP_ASYNC_INSTANCE_TAG
+{
+    HINTERNET sessionHandle;
+    HTTP_HANDLE_DATA* settings;
+    LOCK_HANDLE lock;
+    HANDLE completionEvent;
+    SINGLYLINKEDLIST_HANDLE pendingRequests; /*submitted, the request handle is not closed yet. Guarded by lock*/
+    SINGLYLINKEDLIST_HANDLE completedRequests; /*the request handle is closed, waiting for dowork. Guarded by lock*/
+    SINGLYLINKEDLIST_HANDLE savedOptions; /*HTTPAPI_SetOption does not copy all the values, so the instance keeps the clones alive*/
+} HTTPAPI_WINHTTP_ASYNC_INSTANCE;
+
+static void destroy_async_request(HTTPAPI_WINHTTP_ASYNC_REQUEST* request)
+{
+    free(request->httpHeaders);
+    free(request->content);
+    free(request->trustedCertificate);
+    if (request->responseHeaders != NULL)
+    {
+        HTTPHeaders_Free(request->responseHeaders);
+    }
+    if (request->responseContent != NULL)
+    {
+        BUFFER_delete(request->responseContent);
+    }
+    free(request);
+}
+
+/*closes the request handle once, keeping the result of the first call. The handle is closed outside of the lock because
+WinHTTP may call WINHTTP_CALLBACK_STATUS_HANDLE_CLOSING from WinHttpCloseHandle*/
+static void close_async_request(HTTPAPI_WINHTTP_ASYNC_REQUEST* request, HTTPAPI_RESULT result)
+{
+    bool closeHandle;
+
+    if (Lock(request->instance->lock) != LOCK_OK)
+    {
+        LogError("unable to Lock");
+        closeHandle = false;
+    }
+    else
+    {
+        closeHandle = !request->closeRequested;
+        if (closeHandle)
+        {
+            request->closeRequested = true;
+            request->result = result;
+        }
+        (void)Unlock(request->instance->lock);
+    }
+
+    if (closeHandle)
+    {
+        (void)WinHttpCloseHandle(request->requestHandle);
+    }
+}
+
+static void on_async_request_handle_closing(HTTPAPI_WINHTTP_ASYNC_REQUEST* request)
+{
+    HTTPAPI_WINHTTP_ASYNC_INSTANCE* instance = request->instance;
+
+    if (Lock(instance->lock) != LOCK_OK)
+    {
+        LogError("unable to Lock, the request is leaked");
+    }
+    else
+    {
+        (void)singlylinkedlist_remove(instance->pendingRequests, request->list_item);
+        if ((request->list_item = singlylinkedlist_add(instance->completedRequests, request)) == NULL)
+        {
+            /*nothing references the request anymore*/
+            LogError("unable to singlylinkedlist_add, the completion of the request is lost");
+            destroy_async_request(request);
+        }
+        (void)SetEvent(instance->completionEvent);
+        (void)Unlock(instance->lock);
+    }
+}
+
+static void on_async_headers_available(HTTPAPI_WINHTTP_ASYNC_REQUEST* request)
+{
+    HTTPAPI_RESULT result;
+
+    if ((result = QueryStatusCode(request->requestHandle, &request->statusCode)) != HTTPAPI_OK)
+    {
+        LogError("unable to get the status code (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        close_async_request(request, result);
+    }
+    else if ((result = ReceiveResponseHeaders(request->requestHandle, request->responseHeaders)) != HTTPAPI_OK)
+    {
+        LogError("unable to get the response headers (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        close_async_request(request, result);
+    }
+    else
+    {
+        ReserveResponseContent(request->requestHandle, request->responseContent);
+
+        if (!WinHttpQueryDataAvailable(request->requestHandle, NULL))
+        {
+            result = HTTPAPI_QUERY_DATA_AVAILABLE_FAILED;
+            LogErrorWinHTTPWithGetLastErrorAsString("WinHttpQueryDataAvailable failed (result = %s).", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            close_async_request(request, result);
+        }
+    }
+}
+
+static void on_async_data_available(HTTPAPI_WINHTTP_ASYNC_REQUEST* request, DWORD bytesAvailable)
+{
+    HTTPAPI_RESULT result;
+    size_t bufferLength = BUFFER_length(request->responseContent);
+
+    if (bytesAvailable == 0)
+    {
+        /*end of the response*/
+        close_async_request(request, HTTPAPI_OK);
+    }
+    else if ((request->receivedLength + bytesAvailable > bufferLength) &&
+        (BUFFER_enlarge(request->responseContent, request->receivedLength + bytesAvailable - bufferLength) != 0))
+    {
+        result = HTTPAPI_ALLOC_FAILED;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        close_async_request(request, result);
+    }
+    /*the buffer is not touched until WINHTTP_CALLBACK_STATUS_READ_COMPLETE*/
+    else if (!WinHttpReadData(request->requestHandle, BUFFER_u_char(request->responseContent) + request->receivedLength, bytesAvailable, NULL))
+    {
+        result = HTTPAPI_READ_DATA_FAILED;
+        LogErrorWinHTTPWithGetLastErrorAsString("WinHttpReadData failed (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        close_async_request(request, result);
+    }
+    else
+    {
+        /*keep going*/
+    }
+}
+
+static void on_async_read_complete(HTTPAPI_WINHTTP_ASYNC_REQUEST* request, DWORD bytesRead)
+{
+    HTTPAPI_RESULT result;
+
+    if (bytesRead == 0)
+    {
+        close_async_request(request, HTTPAPI_OK);
+    }
+    else
+    {
+        request->receivedLength += bytesRead;
+
+        if (!WinHttpQueryDataAvailable(request->requestHandle, NULL))
+        {
+            result = HTTPAPI_QUERY_DATA_AVAILABLE_FAILED;
+            LogErrorWinHTTPWithGetLastErrorAsString("WinHttpQueryDataAvailable failed (result = %s).", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            close_async_request(request, result);
+        }
+    }
+}
+
+static void on_async_request_error(HTTPAPI_WINHTTP_ASYNC_REQUEST* request, const WINHTTP_ASYNC_RESULT* asyncResult)
+{
+    HTTPAPI_RESULT result;
+
+    switch (asyncResult->dwResult)
+    {
+    default:
+        result = HTTPAPI_ERROR;
+        break;
+
+    case API_SEND_REQUEST:
+        result = HTTPAPI_SEND_REQUEST_FAILED;
+        break;
+
+    case API_RECEIVE_RESPONSE:
+        result = HTTPAPI_RECEIVE_RESPONSE_FAILED;
+        break;
+
+    case API_QUERY_DATA_AVAILABLE:
+        result = HTTPAPI_QUERY_DATA_AVAILABLE_FAILED;
+        break;
+
+    case API_READ_DATA:
+        result = HTTPAPI_READ_DATA_FAILED;
+        break;
+    }
+
+    LogError("asynchronous request failed, api=%lu, error=%lu (result = %s)", (unsigned long)asyncResult->dwResult, (unsigned long)asyncResult->dwError, ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    /*when the request is cancelled, the result given to close_async_request first is kept*/
+    close_async_request(request, result);
+}
+
+static void CALLBACK httpapi_WinhttpAsyncStatusCallback(
+  IN HINTERNET hInternet,
+  IN DWORD_PTR dwContext,
+  IN DWORD dwInternetStatus,
+  IN LPVOID lpvStatusInformation,
+  IN DWORD dwStatusInformationLength
+)
+{
+    HTTPAPI_WINHTTP_ASYNC_REQUEST* request = (HTTPAPI_WINHTTP_ASYNC_REQUEST*)dwContext;
+
+    if (dwContext == 0)
+    {
+        /*session and connection handles, and requests that never got their context*/
+        ;
+    }
+    else
+    {
+        switch (dwInternetStatus)
+        {
+        default:
+            // Silently ignore if there's any statuses we get that we can't handle
+            break;
+
+        case WINHTTP_CALLBACK_STATUS_SENDING_REQUEST:
+            if ((request->trustedCertificate != NULL) &&
+                !IsServerCertificateTrusted(hInternet, request->trustedCertificate))
+            {
+                LogError("Server certificate is not trusted.  Aborting HTTP request");
+                close_async_request(request, HTTPAPI_SEND_REQUEST_FAILED);
+            }
+            break;
+
+        case WINHTTP_CALLBACK_STATUS_SENDREQUEST_COMPLETE:
+            if (!WinHttpReceiveResponse(hInternet, NULL))
+            {
+                LogErrorWinHTTPWithGetLastErrorAsString("WinHttpReceiveResponse failed");
+                close_async_request(request, HTTPAPI_RECEIVE_RESPONSE_FAILED);
+            }
+            break;
+
+        case WINHTTP_CALLBACK_STATUS_HEADERS_AVAILABLE:
+            on_async_headers_available(request);
+            break;
+
+        case WINHTTP_CALLBACK_STATUS_DATA_AVAILABLE:
+            on_async_data_available(request, *(const DWORD*)lpvStatusInformation);
+            break;
+
+        case WINHTTP_CALLBACK_STATUS_READ_COMPLETE:
+            on_async_read_complete(request, dwStatusInformationLength);
+            break;
+
+        case WINHTTP_CALLBACK_STATUS_REQUEST_ERROR:
+            on_async_request_error(request, (const WINHTTP_ASYNC_RESULT*)lpvStatusInformation);
+            break;
+
+        case WINHTTP_CALLBACK_STATUS_HANDLE_CLOSING:
+            on_async_request_handle_closing(request);
+            break;
+        }
+    }
+}
+
+static void free_saved_option(HTTPAPI_WINHTTP_ASYNC_SAVED_OPTION* savedOption)
+{
+    if (strcmp(savedOption->optionName, OPTION_HTTP_PROXY) == 0)
+    {
+        HTTP_PROXY_OPTIONS* proxyOptions = (HTTP_PROXY_OPTIONS*)savedOption->value;
+        free((void*)proxyOptions->host_address);
+        free((void*)proxyOptions->username);
+        free((void*)proxyOptions->password);
+    }
+    free(savedOption->optionName);
+    free((void*)savedOption->value);
+    free(savedOption);
+}
+
+static bool find_saved_option_by_name(LIST_ITEM_HANDLE list_item, const void* match_context)
+{
+    const HTTPAPI_WINHTTP_ASYNC_SAVED_OPTION* savedOption = (const HTTPAPI_WINHTTP_ASYNC_SAVED_OPTION*)singlylinkedlist_item_get_value(list_item);
+    return (strcmp(savedOption->optionName, (const char*)match_context) == 0);
+}
+
+/*calls the callbacks of the requests whose handle has been closed, without holding the lock*/
+static void dispatch_completed_requests(HTTPAPI_WINHTTP_ASYNC_INSTANCE* instance)
+{
+    while (true)
+    {
+        HTTPAPI_WINHTTP_ASYNC_REQUEST* request = NULL;
+
+        if (Lock(instance->lock) != LOCK_OK)
+        {
+            LogError("unable to Lock");
+        }
+        else
+        {
+            LIST_ITEM_HANDLE list_item = singlylinkedlist_get_head_item(instance->completedRequests);
+            if (list_item != NULL)
+            {
+                request = (HTTPAPI_WINHTTP_ASYNC_REQUEST*)singlylinkedlist_item_get_value(list_item);
+                (void)singlylinkedlist_remove(instance->completedRequests, list_item);
+            }
+            (void)Unlock(instance->lock);
+        }
+
+        if (request == NULL)
+        {
+            break;
+        }
+
+        if (request->notify)
+        {
+            if ((request->result == HTTPAPI_OK) && (request->statusCode >= 300))
+            {
+                LogError("Failure in HTTP communication: server reply code is %u", request->statusCode);
+            }
+            request->on_request_complete(request->on_request_complete_context, request->result, request->statusCode, request->responseHeaders,
+                BUFFER_u_char(request->responseContent), request->receivedLength);
+        }
+        destroy_async_request(request);
+    }
+}
+
+HTTPAPI_WINHTTP_ASYNC_HANDLE httpapi_winhttp_async_create(const char* hostName)
+{
+    HTTPAPI_WINHTTP_ASYNC_INSTANCE* result;
+
+    if (hostName == NULL)
+    {
+        LogError("invalid arg const char* hostName = %p", hostName);
+        result = NULL;
+    }
+    else if (g_HTTPAPIState != HTTPAPI_INITIALIZED)
+    {
+        LogError("g_HTTPAPIState not HTTPAPI_INITIALIZED");
+        result = NULL;
+    }
+    else if ((result = (HTTPAPI_WINHTTP_ASYNC_INSTANCE*)malloc(sizeof(HTTPAPI_WINHTTP_ASYNC_INSTANCE))) == NULL)
+    {
+        LogError("unable to malloc");
+    }
+    else
+    {
+        bool isCreated = false;
+
+        result->settings = NULL;
+        result->lock = NULL;
+        result->completionEvent = NULL;
+        result->pendingRequests = NULL;
+        result->completedRequests = NULL;
+        result->savedOptions = NULL;
+
+        if ((result->sessionHandle = WinHttpOpen(
+            NULL,
+            WINHTTP_ACCESS_TYPE_DEFAULT_PROXY,
+            WINHTTP_NO_PROXY_NAME,
+            WINHTTP_NO_PROXY_BYPASS,
+            WINHTTP_FLAG_ASYNC)) == NULL)
+        {
+            LogErrorWinHTTPWithGetLastErrorAsString("WinHttpOpen failed.");
+        }
+        else if (WinHttpSetStatusCallback(result->sessionHandle, httpapi_WinhttpAsyncStatusCallback,
+            WINHTTP_CALLBACK_FLAG_ALL_COMPLETIONS | WINHTTP_CALLBACK_FLAG_SEND_REQUEST | WINHTTP_CALLBACK_FLAG_HANDLES, 0) == WINHTTP_INVALID_STATUS_CALLBACK)
+        {
+            LogErrorWinHTTPWithGetLastErrorAsString("WinHttpSetStatusCallback failed.");
+        }
+        else if ((result->settings = CreateConnectionData(result->sessionHandle, hostName, false)) == NULL)
+        {
+            LogError("unable to create the connection");
+        }
+        else if ((result->lock = Lock_Init()) == NULL)
+        {
+            LogError("unable to Lock_Init");
+        }
+        else if ((result->completionEvent = CreateEvent(NULL, FALSE, FALSE, NULL)) == NULL)
+        {
+            LogError("unable to CreateEvent, GetLastError=0x%08x", GetLastError());
+        }
+        else if (((result->pendingRequests = singlylinkedlist_create()) == NULL) ||
+            ((result->completedRequests = singlylinkedlist_create()) == NULL) ||
+            ((result->savedOptions = singlylinkedlist_create()) == NULL))
+        {
+            LogError("unable to singlylinkedlist_create");
+        }
+        else
+        {
+#ifdef WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL
+            /*concurrent requests share one connection when HTTP/2 is negotiated, older systems do not know the option and keep HTTP/1.1*/
+            DWORD protocols = WINHTTP_PROTOCOL_FLAG_HTTP2;
+            if (!WinHttpSetOption(result->sessionHandle, WINHTTP_OPTION_ENABLE_HTTP_PROTOCOL, &protocols, sizeof(protocols)))
+            {
+                LogInfo("HTTP/2 is not available, using HTTP/1.1");
+            }
+#endif
+            isCreated = true;
+        }
+
+        if (!isCreated)
+        {
+            if (result->savedOptions != NULL)
+            {
+                singlylinkedlist_destroy(result->savedOptions);
+            }
+            if (result->completedRequests != NULL)
+            {
+                singlylinkedlist_destroy(result->completedRequests);
+            }
+            if (result->pendingRequests != NULL)
+            {
+                singlylinkedlist_destroy(result->pendingRequests);
+            }
+            if (result->completionEvent != NULL)
+            {
+                (void)CloseHandle(result->completionEvent);
+            }
+            if (result->lock != NULL)
+            {
+                (void)Lock_Deinit(result->lock);
+            }
+            if (result->settings != NULL)
+            {
+                CloseConnectionData(result->settings);
+            }
+            if (result->sessionHandle != NULL)
+            {
+                (void)WinHttpSetStatusCallback(result->sessionHandle, NULL, WINHTTP_CALLBACK_FLAG_ALL_NOTIFICATIONS, 0);
+                (void)WinHttpCloseHandle(result->sessionHandle);
+            }
+            free(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+void httpapi_winhttp_async_destroy(HTTPAPI_WINHTTP_ASYNC_HANDLE handle)
+{
+    if (handle == NULL)
+    {
+        LogError("invalid arg HTTPAPI_WINHTTP_ASYNC_HANDLE handle = %p", handle);
+    }
+    else
+    {
+        LIST_ITEM_HANDLE list_item;
+        bool hasPendingRequests = true;
+
+        /*cancel the requests in flight: their handles are closed and the WinHTTP callbacks eventually move them to completedRequests*/
+        while (hasPendingRequests)
+        {
+            HTTPAPI_WINHTTP_ASYNC_REQUEST* toCancel = NULL;
+
+            if (Lock(handle->lock) != LOCK_OK)
+            {
+                LogError("unable to Lock");
+                break;
+            }
+
+            list_item = singlylinkedlist_get_head_item(handle->pendingRequests);
+            hasPendingRequests = (list_item != NULL);
+            while (list_item != NULL)
+            {
+                HTTPAPI_WINHTTP_ASYNC_REQUEST* request = (HTTPAPI_WINHTTP_ASYNC_REQUEST*)singlylinkedlist_item_get_value(list_item);
+                if (!request->closeRequested)
+                {
+                    toCancel = request;
+                    break;
+                }
+                list_item = singlylinkedlist_get_next_item(list_item);
+            }
+            (void)Unlock(handle->lock);
+
+            if (toCancel != NULL)
+            {
+                close_async_request(toCancel, HTTPAPI_ERROR);
+            }
+            else if (hasPendingRequests)
+            {
+                (void)WaitForSingleObject(handle->completionEvent, INFINITE);
+            }
+        }
+
+        dispatch_completed_requests(handle);
+
+        singlylinkedlist_destroy(handle->pendingRequests);
+        singlylinkedlist_destroy(handle->completedRequests);
+
+        CloseConnectionData(handle->settings);
+        (void)WinHttpSetStatusCallback(handle->sessionHandle, NULL, WINHTTP_CALLBACK_FLAG_ALL_NOTIFICATIONS, 0);
+        (void)WinHttpCloseHandle(handle->sessionHandle);
+
+        while ((list_item = singlylinkedlist_get_head_item(handle->savedOptions)) != NULL)
+        {
+            free_saved_option((HTTPAPI_WINHTTP_ASYNC_SAVED_OPTION*)singlylinkedlist_item_get_value(list_item));
+            (void)singlylinkedlist_remove(handle->savedOptions, list_item);
+        }
+        singlylinkedlist_destroy(handle->savedOptions);
+
+        (void)CloseHandle(handle->completionEvent);
+        (void)Lock_Deinit(handle->lock);
+        free(handle);
+    }
+}
+
+HTTPAPI_RESULT httpapi_winhttp_async_execute_request(HTTPAPI_WINHTTP_ASYNC_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE httpHeadersHandle, const unsigned char* content, size_t contentLength,
+    ON_HTTPAPI_WINHTTP_REQUEST_COMPLETE on_request_complete, void* on_request_complete_context)
+{
+    HTTPAPI_RESULT result;
+    HTTPAPI_WINHTTP_ASYNC_REQUEST* request;
+
+    if ((handle == NULL) ||
+        (relativePath == NULL) ||
+        (httpHeadersHandle == NULL) ||
+        ((content == NULL) && (contentLength > 0)) ||
+        (on_request_complete == NULL)
+        )
+    {
+        result = HTTPAPI_INVALID_ARG;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else if ((request = (HTTPAPI_WINHTTP_ASYNC_REQUEST*)malloc(sizeof(HTTPAPI_WINHTTP_ASYNC_REQUEST))) == NULL)
+    {
+        result = HTTPAPI_ALLOC_FAILED;
+        LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+    }
+    else
+    {
+        DWORD_PTR context = (DWORD_PTR)request;
+
+        (void)memset(request, 0, sizeof(HTTPAPI_WINHTTP_ASYNC_REQUEST));
+        request->instance = handle;
+        request->result = HTTPAPI_OK;
+        request->notify = true;
+        request->contentLength = contentLength;
+        request->on_request_complete = on_request_complete;
+        request->on_request_complete_context = on_request_complete_context;
+
+        /*the content must stay valid until WINHTTP_CALLBACK_STATUS_SENDREQUEST_COMPLETE*/
+        if ((contentLength > 0) && ((request->content = (unsigned char*)malloc(contentLength)) == NULL))
+        {
+            result = HTTPAPI_ALLOC_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            destroy_async_request(request);
+        }
+        /*the status callback must not read the options of the instance, httpapi_winhttp_async_set_option can change them meanwhile*/
+        else if ((handle->settings->trustedCertificate != NULL) && (mallocAndStrcpy_s(&request->trustedCertificate, handle->settings->trustedCertificate) != 0))
+        {
+            result = HTTPAPI_ALLOC_FAILED;
+            LogError("unable to copy the trusted certificate (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            destroy_async_request(request);
+        }
+        else if (((request->responseHeaders = HTTPHeaders_Alloc()) == NULL) ||
+            ((request->responseContent = BUFFER_new()) == NULL))
+        {
+            result = HTTPAPI_ALLOC_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            destroy_async_request(request);
+        }
+        else if ((result = ConstructHeadersString(httpHeadersHandle, &request->httpHeaders)) != HTTPAPI_OK)
+        {
+            LogError("Cannot construct http headers");
+            destroy_async_request(request);
+        }
+        else if ((result = InitiateWinhttpRequest(handle->settings, requestType, relativePath, &request->requestHandle)) != HTTPAPI_OK)
+        {
+            LogError("Cannot create Winhttp request handle");
+            destroy_async_request(request);
+        }
+        else if ((result = SetProxyIfNecessary(handle->settings, request->requestHandle)) != HTTPAPI_OK)
+        {
+            LogError("unable to set proxy");
+            (void)WinHttpCloseHandle(request->requestHandle);
+            destroy_async_request(request);
+        }
+        else if (Lock(handle->lock) != LOCK_OK)
+        {
+            result = HTTPAPI_ERROR;
+            LogError("unable to Lock (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            (void)WinHttpCloseHandle(request->requestHandle);
+            destroy_async_request(request);
+        }
+        else
+        {
+            if ((request->list_item = singlylinkedlist_add(handle->pendingRequests, request)) == NULL)
+            {
+                (void)Unlock(handle->lock);
+                result = HTTPAPI_ALLOC_FAILED;
+                LogError("unable to singlylinkedlist_add (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                (void)WinHttpCloseHandle(request->requestHandle);
+                destroy_async_request(request);
+            }
+            else
+            {
+                (void)Unlock(handle->lock);
+
+                if (contentLength > 0)
+                {
+                    (void)memcpy(request->content, content, contentLength);
+                }
+
+                /*from here on the request belongs to the status callback, it is released after WINHTTP_CALLBACK_STATUS_HANDLE_CLOSING*/
+                if (!WinHttpSetOption(request->requestHandle, WINHTTP_OPTION_CONTEXT_VALUE, &context, sizeof(context)))
+                {
+                    result = HTTPAPI_SET_OPTION_FAILED;
+                    LogErrorWinHTTPWithGetLastErrorAsString("unable to set the request context (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                    request->notify = false;
+                    close_async_request(request, result);
+                    /*without a context the handle closing is not seen by the callback*/
+                    if (Lock(handle->lock) == LOCK_OK)
+                    {
+                        (void)singlylinkedlist_remove(handle->pendingRequests, request->list_item);
+                        (void)Unlock(handle->lock);
+                        destroy_async_request(request);
+                    }
+                }
+                else if ((result = SendHttpRequest(handle->settings, request->requestHandle, request->content, contentLength, contentLength, request->httpHeaders, context)) != HTTPAPI_OK)
+                {
+                    LogError("Cannot set options / send http request");
+                    request->notify = false;
+                    close_async_request(request, result);
+                }
+                else
+                {
+                    result = HTTPAPI_OK;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+void httpapi_winhttp_async_dowork(HTTPAPI_WINHTTP_ASYNC_HANDLE handle)
+{
+    if (handle == NULL)
+    {
+        LogError("invalid arg HTTPAPI_WINHTTP_ASYNC_HANDLE handle = %p", handle);
+    }
+    else
+    {
+        dispatch_completed_requests(handle);
+    }
+}
+
+int httpapi_winhttp_async_wait(HTTPAPI_WINHTTP_ASYNC_HANDLE handle, unsigned int timeout_ms)
+{
+    int result;
+
+    if (handle == NULL)
+    {
+        LogError("invalid arg HTTPAPI_WINHTTP_ASYNC_HANDLE handle = %p", handle);
+        result = __FAILURE__;
+    }
+    else
+    {
+        DWORD waitResult = WaitForSingleObject(handle->completionEvent, (DWORD)timeout_ms);
+        if ((waitResult != WAIT_OBJECT_0) && (waitResult != WAIT_TIMEOUT))
+        {
+            LogError("WaitForSingleObject failed, GetLastError=0x%08x", GetLastError());
+            result = __FAILURE__;
+        }
+        else
+        {
+            /*the event is set again whenever a request completes, dowork drains all of them at once*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+HTTPAPI_RESULT httpapi_winhttp_async_set_option(HTTPAPI_WINHTTP_ASYNC_HANDLE handle, const char* optionName, const void* value)
+{
+    HTTPAPI_RESULT result;
+
+    if ((handle == NULL) ||
+        (optionName == NULL) ||
+        (value == NULL))
+    {
+        result = HTTPAPI_INVALID_ARG;
+        LogError("invalid parameter (NULL) passed to httpapi_winhttp_async_set_option");
+    }
+    else
+    {
+        HTTPAPI_WINHTTP_ASYNC_SAVED_OPTION* savedOption = (HTTPAPI_WINHTTP_ASYNC_SAVED_OPTION*)malloc(sizeof(HTTPAPI_WINHTTP_ASYNC_SAVED_OPTION));
+        if (savedOption == NULL)
+        {
+            result = HTTPAPI_ALLOC_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+        }
+        else if (mallocAndStrcpy_s(&savedOption->optionName, optionName) != 0)
+        {
+            result = HTTPAPI_ALLOC_FAILED;
+            LogError("(result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            free(savedOption);
+        }
+        else if ((result = HTTPAPI_CloneOption(optionName, value, &savedOption->value)) != HTTPAPI_OK)
+        {
+            LogError("unable to clone option %s (result = %s)", optionName, ENUM_TO_STRING(HTTPAPI_RESULT, result));
+            free(savedOption->optionName);
+            free(savedOption);
+        }
+        else
+        {
+            LIST_ITEM_HANDLE savedOptionItem;
+            if ((savedOptionItem = singlylinkedlist_add(handle->savedOptions, savedOption)) == NULL)
+            {
+                result = HTTPAPI_ALLOC_FAILED;
+                LogError("unable to singlylinkedlist_add (result = %s)", ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                free_saved_option(savedOption);
+            }
+            else
+            {
+                /*the previous value of the option, if any, is still used by the connection until HTTPAPI_SetOption succeeds*/
+                LIST_ITEM_HANDLE previous = singlylinkedlist_find(handle->savedOptions, find_saved_option_by_name, optionName);
+
+                if ((result = HTTPAPI_SetOption((HTTP_HANDLE)handle->settings, optionName, savedOption->value)) != HTTPAPI_OK)
+                {
+                    LogError("unable to set option %s (result = %s)", optionName, ENUM_TO_STRING(HTTPAPI_RESULT, result));
+                    (void)singlylinkedlist_remove(handle->savedOptions, savedOptionItem);
+                    free_saved_option(savedOption);
+                }
+                else if (previous != savedOptionItem)
+                {
+                    free_saved_option((HTTPAPI_WINHTTP_ASYNC_SAVED_OPTION*)singlylinkedlist_item_get_value(previous));
+                    (void)singlylinkedlist_remove(handle->savedOptions, previous);
+                }
+            }
+        }
+    }
+
+    return result;
+}
@@ -8,6 +8,308 @@
 
 #include "azure_c_shared_utility/macro_utils.h"
 
+#if defined(LOCK_PROFILING)
+#include <stdint.h>
+
+/* Lock_Init is also defined as a function below, the macro only tags the callers */
+#undef Lock_Init
+
+typedef struct LOCK_PROFILED_TAG
+{
+    HANDLE semaphore;
+    /* the counters are only written with the semaphore held */
+    LOCK_PROFILE_INFO info;
+    struct LOCK_PROFILED_TAG* previous;
+    struct LOCK_PROFILED_TAG* next;
+} LOCK_PROFILED;
+
+typedef struct LOCK_PROFILE_SITE_TAG
+{
+    LOCK_PROFILE_INFO info;
+    struct LOCK_PROFILE_SITE_TAG* next;
+} LOCK_PROFILE_SITE;
+
+/* the locks that are alive and the records of the sites of the deinitialized ones, never freed */
+static SRWLOCK profile_registry_lock = SRWLOCK_INIT;
+static LOCK_PROFILED* profiled_locks = NULL;
+static LOCK_PROFILE_SITE* profile_sites = NULL;
+static size_t profiled_lock_count = 0;
+static size_t profile_site_count = 0;
+
+#define LOCK_SEMAPHORE(handle) (((LOCK_PROFILED*)(handle))->semaphore)
+
+static uint64_t get_monotonic_ns(void)
+{
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER now;
+    (void)QueryPerformanceFrequency(&frequency);
+    (void)QueryPerformanceCounter(&now);
+    /* split so that the multiplication does not overflow */
+    return ((uint64_t)(now.QuadPart / frequency.QuadPart) * 1000000000) +
+        (((uint64_t)(now.QuadPart % frequency.QuadPart) * 1000000000) / (uint64_t)frequency.QuadPart);
+}
+
+static DWORD acquire_profiled(LOCK_PROFILED* lock)
+{
+    /* Codes_SRS_LOCK_01_026: [With LOCK_PROFILING, Lock shall first try to acquire the lock without waiting and, if the lock is held, count a contended acquisition and add the time spent waiting for it to the total and max wait of the lock.] */
+    DWORD result = WaitForSingleObject(lock->semaphore, 0);
+    if (result == WAIT_TIMEOUT)
+    {
+        uint64_t start = get_monotonic_ns();
+        result = WaitForSingleObject(lock->semaphore, INFINITE);
+        if (result == WAIT_OBJECT_0)
+        {
+            uint64_t wait_ns = get_monotonic_ns() - start;
+            lock->info.contended_count++;
+            lock->info.total_wait_ns += wait_ns;
+            if (wait_ns > lock->info.max_wait_ns)
+            {
+                lock->info.max_wait_ns = wait_ns;
+            }
+        }
+    }
+
+    if (result == WAIT_OBJECT_0)
+    {
+        /* Codes_SRS_LOCK_01_025: [With LOCK_PROFILING, Lock shall count each acquisition of the lock.] */
+        lock->info.acquisition_count++;
+    }
+
+    return result;
+}
+
+/* unlinks the lock and adds its counters to the record of its site */
+static void retire_profiled(LOCK_PROFILED* lock)
+{
+    LOCK_PROFILE_SITE* site;
+
+    AcquireSRWLockExclusive(&profile_registry_lock);
+
+    if (lock->previous == NULL)
+    {
+        profiled_locks = lock->next;
+    }
+    else
+    {
+        lock->previous->next = lock->next;
+    }
+    if (lock->next != NULL)
+    {
+        lock->next->previous = lock->previous;
+    }
+    profiled_lock_count--;
+
+    site = profile_sites;
+    while ((site != NULL) &&
+        ((site->info.file != lock->info.file) || (site->info.line != lock->info.line)))
+    {
+        site = site->next;
+    }
+
+    if (site == NULL)
+    {
+        site = (LOCK_PROFILE_SITE*)calloc(1, sizeof(LOCK_PROFILE_SITE));
+        if (site == NULL)
+        {
+            LogError("Failed allocating the profile record of %s:%d, its counters are lost", (lock->info.file == NULL) ? "(unknown)" : lock->info.file, lock->info.line);
+        }
+        else
+        {
+            site->info.file = lock->info.file;
+            site->info.line = lock->info.line;
+            site->next = profile_sites;
+            profile_sites = site;
+            profile_site_count++;
+        }
+    }
+
+    if (site != NULL)
+    {
+        /* Codes_SRS_LOCK_01_029: [With LOCK_PROFILING, Lock_Deinit shall add the counters of the lock to the record of its creation site.] */
+        site->info.lock_count++;
+        site->info.acquisition_count += lock->info.acquisition_count;
+        site->info.contended_count += lock->info.contended_count;
+        site->info.total_wait_ns += lock->info.total_wait_ns;
+        if (lock->info.max_wait_ns > site->info.max_wait_ns)
+        {
+            site->info.max_wait_ns = lock->info.max_wait_ns;
+        }
+    }
+
+    ReleaseSRWLockExclusive(&profile_registry_lock);
+}
+
+static int compare_profile_total_wait(const void* left, const void* right)
+{
+    const LOCK_PROFILE_INFO* left_info = (const LOCK_PROFILE_INFO*)left;
+    const LOCK_PROFILE_INFO* right_info = (const LOCK_PROFILE_INFO*)right;
+    return (left_info->total_wait_ns > right_info->total_wait_ns) ? -1 : (left_info->total_wait_ns < right_info->total_wait_ns) ? 1 : 0;
+}
+
+/* copies the profiles of the locks and of the sites, largest total_wait_ns first, the copy is freed by the caller */
+static int copy_profiles(LOCK_PROFILE_INFO** profiles, size_t* count)
+{
+    int result;
+
+    AcquireSRWLockExclusive(&profile_registry_lock);
+
+    /* one spare entry so that there is something to allocate when there are no locks */
+    *profiles = (LOCK_PROFILE_INFO*)malloc((profiled_lock_count + profile_site_count + 1) * sizeof(LOCK_PROFILE_INFO));
+    if (*profiles == NULL)
+    {
+        LogError("Failed allocating the copy of %lu lock profiles", (unsigned long)(profiled_lock_count + profile_site_count));
+        result = __FAILURE__;
+    }
+    else
+    {
+        LOCK_PROFILED* lock;
+        LOCK_PROFILE_SITE* site;
+
+        *count = 0;
+        for (lock = profiled_locks; lock != NULL; lock = lock->next)
+        {
+            (*profiles)[(*count)++] = lock->info;
+        }
+        for (site = profile_sites; site != NULL; site = site->next)
+        {
+            (*profiles)[(*count)++] = site->info;
+        }
+
+        result = 0;
+    }
+
+    ReleaseSRWLockExclusive(&profile_registry_lock);
+
+    if (result == 0)
+    {
+        qsort(*profiles, *count, sizeof(LOCK_PROFILE_INFO), compare_profile_total_wait);
+    }
+
+    return result;
+}
+
+LOCK_HANDLE Lock_Init_at(const char* file, int line)
+{
+    /* Codes_SRS_LOCK_10_002: [Lock_Init on success shall return a valid lock handle which should be a non NULL value] */
+    LOCK_PROFILED* result = (LOCK_PROFILED*)calloc(1, sizeof(LOCK_PROFILED));
+    if (result == NULL)
+    {
+        LogError("malloc failed.");
+    }
+    else
+    {
+        result->semaphore = CreateSemaphoreW(NULL, 1, 1, NULL);
+        if (result->semaphore == NULL)
+        {
+            /* Codes_SRS_LOCK_10_003: [Lock_Init on error shall return NULL ] */
+            LogError("CreateSemaphore failed.");
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            /* Codes_SRS_LOCK_01_027: [With LOCK_PROFILING, Lock_Init shall tag the lock with the file and line of the call to Lock_Init and add it to the profiled locks.] */
+            result->info.file = file;
+            result->info.line = line;
+            result->info.handle = result;
+            result->info.lock_count = 1;
+
+            AcquireSRWLockExclusive(&profile_registry_lock);
+            result->next = profiled_locks;
+            if (profiled_locks != NULL)
+            {
+                profiled_locks->previous = result;
+            }
+            profiled_locks = result;
+            profiled_lock_count++;
+            ReleaseSRWLockExclusive(&profile_registry_lock);
+        }
+    }
+
+    return (LOCK_HANDLE)result;
+}
+
+LOCK_HANDLE Lock_Init(void)
+{
+    /* Codes_SRS_LOCK_01_028: [With LOCK_PROFILING, a lock created by a call to the Lock_Init function rather than through the Lock_Init macro shall be tagged with a NULL file and a line of 0.] */
+    return Lock_Init_at(NULL, 0);
+}
+
+int Lock_GetProfiles(LOCK_PROFILE_INFO* profiles, size_t profile_count, size_t* total_profile_count)
+{
+    int result;
+    LOCK_PROFILE_INFO* all_profiles;
+    size_t all_profile_count;
+
+    if ((total_profile_count == NULL) ||
+        ((profiles == NULL) && (profile_count > 0)))
+    {
+        /* Codes_SRS_LOCK_01_030: [If total_profile_count is NULL, or profiles is NULL and profile_count is not 0, Lock_GetProfiles shall fail and return a non-zero value.] */
+        LogError("Invalid arguments: profiles=%p, profile_count=%lu, total_profile_count=%p",
+            profiles, (unsigned long)profile_count, total_profile_count);
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_LOCK_01_031: [If copying the profiles fails, Lock_GetProfiles shall fail and return a non-zero value.] */
+    else if (copy_profiles(&all_profiles, &all_profile_count) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+
+        /* Codes_SRS_LOCK_01_032: [Lock_GetProfiles shall fill profiles with up to profile_count entries, one per lock alive and one per creation site of deinitialized locks, ordered by decreasing total_wait_ns, set total_profile_count to the number of entries and return 0.] */
+        for (i = 0; (i < profile_count) && (i < all_profile_count); i++)
+        {
+            profiles[i] = all_profiles[i];
+        }
+
+        *total_profile_count = all_profile_count;
+        free(all_profiles);
+        result = 0;
+    }
+
+    return result;
+}
+
+void Lock_DumpProfiles(void)
+{
+    LOCK_PROFILE_INFO* all_profiles;
+    size_t all_profile_count;
+
+    if (copy_profiles(&all_profiles, &all_profile_count) == 0)
+    {
+        size_t i;
+
+        /* Codes_SRS_LOCK_01_033: [Lock_DumpProfiles shall log with LogInfo one line per entry, ordered by decreasing total_wait_ns, with its creation site, the lock or the number of deinitialized locks, the acquisitions, the contended acquisitions and the total and max wait.] */
+        LogInfo("lock: %lu lock profiles", (unsigned long)all_profile_count);
+        for (i = 0; i < all_profile_count; i++)
+        {
+            const LOCK_PROFILE_INFO* info = &all_profiles[i];
+            if (info->handle == NULL)
+            {
+                LogInfo("lock: %s:%d: %lu deinitialized locks, %llu acquisitions, %llu contended, %llu ns waited, %llu ns max wait",
+                    (info->file == NULL) ? "(unknown)" : info->file, info->line, (unsigned long)info->lock_count,
+                    (unsigned long long)info->acquisition_count, (unsigned long long)info->contended_count,
+                    (unsigned long long)info->total_wait_ns, (unsigned long long)info->max_wait_ns);
+            }
+            else
+            {
+                LogInfo("lock: %s:%d: lock %p, %llu acquisitions, %llu contended, %llu ns waited, %llu ns max wait",
+                    (info->file == NULL) ? "(unknown)" : info->file, info->line, info->handle,
+                    (unsigned long long)info->acquisition_count, (unsigned long long)info->contended_count,
+                    (unsigned long long)info->total_wait_ns, (unsigned long long)info->max_wait_ns);
+            }
+        }
+
+        free(all_profiles);
+    }
+}
+
+#else
+
+#define LOCK_SEMAPHORE(handle) ((HANDLE)(handle))
+
 LOCK_HANDLE Lock_Init(void)
 {
     /* Codes_SRS_LOCK_10_002: [Lock_Init on success shall return a valid lock handle which should be a non NULL value] */
@@ -21,6 +323,8 @@ LOCK_HANDLE Lock_Init(void)
     return (LOCK_HANDLE)result;
 }
 
+#endif
+
 LOCK_RESULT Lock_Deinit(LOCK_HANDLE handle)
 {
     LOCK_RESULT result;
@@ -33,7 +337,11 @@ LOCK_RESULT Lock_Deinit(LOCK_HANDLE handle)
     else
     {
         /* Codes_SRS_LOCK_10_012: [Lock_Deinit frees the memory pointed by handle] */
-        CloseHandle((HANDLE)handle);
+        CloseHandle(LOCK_SEMAPHORE(handle));
+#if defined(LOCK_PROFILING)
+        retire_profiled((LOCK_PROFILED*)handle);
+        free(handle);
+#endif
         result = LOCK_OK;
     }
 
@@ -51,7 +359,11 @@ LOCK_RESULT Lock(LOCK_HANDLE handle)
     }
     else
     {
+#if defined(LOCK_PROFILING)
+        DWORD rv = acquire_profiled((LOCK_PROFILED*)handle);
+#else
         DWORD rv = WaitForSingleObject((HANDLE)handle, INFINITE);
+#endif
         switch (rv)
         {
             case WAIT_OBJECT_0:
@@ -95,7 +407,7 @@ LOCK_RESULT Unlock(LOCK_HANDLE handle)
     }
     else
     {
-        if (ReleaseSemaphore((HANDLE)handle, 1, NULL))
+        if (ReleaseSemaphore(LOCK_SEMAPHORE(handle), 1, NULL))
         {
             /* Codes_SRS_LOCK_10_009: [Unlock on success shall return LOCK_OK] */
             result = LOCK_OK;
@@ -110,3 +422,217 @@ LOCK_RESULT Unlock(LOCK_HANDLE handle)
 
     return result;
 }
+
+RWLOCK_HANDLE RWLock_Init(void)
+{
+    SRWLOCK* result = (SRWLOCK*)malloc(sizeof(SRWLOCK));
+    if (result == NULL)
+    {
+        /* Codes_SRS_LOCK_01_002: [RWLock_Init on error shall return NULL] */
+        LogError("malloc failed.");
+    }
+    else
+    {
+        /* Codes_SRS_LOCK_01_001: [RWLock_Init on success shall return a valid reader/writer lock handle which should be a non NULL value] */
+        InitializeSRWLock(result);
+    }
+
+    return (RWLOCK_HANDLE)result;
+}
+
+LOCK_RESULT RWLock_LockShared(RWLOCK_HANDLE handle)
+{
+    LOCK_RESULT result;
+    if (handle == NULL)
+    {
+        /* Codes_SRS_LOCK_01_003: [RWLock_LockShared on NULL handle passed returns LOCK_ERROR] */
+        LogError("Invalid argument; handle is NULL.");
+        result = LOCK_ERROR;
+    }
+    else
+    {
+        /* Codes_SRS_LOCK_01_004: [RWLock_LockShared shall acquire the lock in shared mode and return LOCK_OK] */
+        AcquireSRWLockShared((SRWLOCK*)handle);
+        result = LOCK_OK;
+    }
+
+    return result;
+}
+
+LOCK_RESULT RWLock_UnlockShared(RWLOCK_HANDLE handle)
+{
+    LOCK_RESULT result;
+    if (handle == NULL)
+    {
+        /* Codes_SRS_LOCK_01_006: [RWLock_UnlockShared on NULL handle passed returns LOCK_ERROR] */
+        LogError("Invalid argument; handle is NULL.");
+        result = LOCK_ERROR;
+    }
+    else
+    {
+        /* Codes_SRS_LOCK_01_007: [RWLock_UnlockShared shall release the shared lock and return LOCK_OK] */
+        ReleaseSRWLockShared((SRWLOCK*)handle);
+        result = LOCK_OK;
+    }
+
+    return result;
+}
+
+LOCK_RESULT RWLock_LockExclusive(RWLOCK_HANDLE handle)
+{
+    LOCK_RESULT result;
+    if (handle == NULL)
+    {
+        /* Codes_SRS_LOCK_01_009: [RWLock_LockExclusive on NULL handle passed returns LOCK_ERROR] */
+        LogError("Invalid argument; handle is NULL.");
+        result = LOCK_ERROR;
+    }
+    else
+    {
+        /* Codes_SRS_LOCK_01_010: [RWLock_LockExclusive shall acquire the lock in exclusive mode and return LOCK_OK] */
+        AcquireSRWLockExclusive((SRWLOCK*)handle);
+        result = LOCK_OK;
+    }
+
+    return result;
+}
+
+LOCK_RESULT RWLock_UnlockExclusive(RWLOCK_HANDLE handle)
+{
+    LOCK_RESULT result;
+    if (handle == NULL)
+    {
+        /* Codes_SRS_LOCK_01_012: [RWLock_UnlockExclusive on NULL handle passed returns LOCK_ERROR] */
+        LogError("Invalid argument; handle is NULL.");
+        result = LOCK_ERROR;
+    }
+    else
+    {
+        /* Codes_SRS_LOCK_01_013: [RWLock_UnlockExclusive shall release the exclusive lock and return LOCK_OK] */
+        ReleaseSRWLockExclusive((SRWLOCK*)handle);
+        result = LOCK_OK;
+    }
+
+    return result;
+}
+
+LOCK_RESULT RWLock_Deinit(RWLOCK_HANDLE handle)
+{
+    LOCK_RESULT result;
+    if (handle == NULL)
+    {
+        /* Codes_SRS_LOCK_01_015: [RWLock_Deinit on NULL handle passed returns LOCK_ERROR] */
+        LogError("Invalid argument; handle is NULL.");
+        result = LOCK_ERROR;
+    }
+    else
+    {
+        /* Codes_SRS_LOCK_01_016: [RWLock_Deinit frees all resources associated with handle] */
+        free(handle);
+        result = LOCK_OK;
+    }
+
+    return result;
+}
+
+/* the pause rounds double up to this many pauses, after which a waiter yields instead */
+#define SPIN_LOCK_MAX_PAUSES 64
+
+SPINLOCK_HANDLE SpinLock_Init(void)
+{
+    volatile LONG* result = (volatile LONG*)malloc(sizeof(LONG));
+    if (result == NULL)
+    {
+        /* Codes_SRS_LOCK_01_018: [SpinLock_Init on error shall return NULL] */
+        LogError("malloc failed.");
+    }
+    else
+    {
+        /* Codes_SRS_LOCK_01_017: [SpinLock_Init on success shall return a valid spin lock handle which should be a non NULL value] */
+        *result = 0;
+    }
+
+    return (SPINLOCK_HANDLE)result;
+}
+
+LOCK_RESULT SpinLock_Lock(SPINLOCK_HANDLE handle)
+{
+    LOCK_RESULT result;
+    if (handle == NULL)
+    {
+        /* Codes_SRS_LOCK_01_019: [SpinLock_Lock on NULL handle passed returns LOCK_ERROR] */
+        LogError("Invalid argument; handle is NULL.");
+        result = LOCK_ERROR;
+    }
+    else
+    {
+        volatile LONG* lock = (volatile LONG*)handle;
+
+        /* Codes_SRS_LOCK_01_020: [SpinLock_Lock shall spin until the lock is free, yielding the thread once it has spun for a while, then acquire it and return LOCK_OK] */
+        while (InterlockedExchange(lock, 1) != 0)
+        {
+            unsigned int pauses = 1;
+
+            /* wait for it to look free before trying again, so the cache line is not bounced around */
+            while (*lock != 0)
+            {
+                if (pauses <= SPIN_LOCK_MAX_PAUSES)
+                {
+                    unsigned int i;
+                    for (i = 0; i < pauses; i++)
+                    {
+                        YieldProcessor();
+                    }
+                    pauses *= 2;
+                }
+                else
+                {
+                    /* the holder is probably not running, let it */
+                    (void)SwitchToThread();
+                }
+            }
+        }
+
+        result = LOCK_OK;
+    }
+
+    return result;
+}
+
+LOCK_RESULT SpinLock_Unlock(SPINLOCK_HANDLE handle)
+{
+    LOCK_RESULT result;
+    if (handle == NULL)
+    {
+        /* Codes_SRS_LOCK_01_021: [SpinLock_Unlock on NULL handle passed returns LOCK_ERROR] */
+        LogError("Invalid argument; handle is NULL.");
+        result = LOCK_ERROR;
+    }
+    else
+    {
+        /* Codes_SRS_LOCK_01_022: [SpinLock_Unlock shall release the lock and return LOCK_OK] */
+        (void)InterlockedExchange((volatile LONG*)handle, 0);
+        result = LOCK_OK;
+    }
+
+    return result;
+}
+
+LOCK_RESULT SpinLock_Deinit(SPINLOCK_HANDLE handle)
+{
+    LOCK_RESULT result;
+    if (handle == NULL)
+    {
+        /* Codes_SRS_LOCK_01_023: [SpinLock_Deinit on NULL handle passed returns LOCK_ERROR] */
+        LogError("Invalid argument; handle is NULL.");
+        result = LOCK_ERROR;
+    }
+    else
+    {
+        /* Codes_SRS_LOCK_01_024: [SpinLock_Deinit frees all resources associated with handle] */
+        free(handle);
+        result = LOCK_OK;
+    }
+
+    return result;
+}
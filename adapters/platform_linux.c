@@ -3,7 +3,13 @@
 
 #include "azure_c_shared_utility/platform.h"
 #include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/dns_cache.h"
+#include "azure_c_shared_utility/string_intern.h"
 #include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/socket_reactor.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
 #ifdef USE_OPENSSL
 #include "azure_c_shared_utility/tlsio_openssl.h"
 #endif
@@ -18,14 +24,90 @@
 #include <unistd.h>
 #include <sys/utsname.h>
 
+// how long a reactor thread waits for events before checking whether it has to stop
+#define SOCKET_REACTOR_THREAD_TIMEOUT_MS    100
+
+static SOCKET_REACTOR_HANDLE g_socket_reactor = NULL;
+static THREAD_HANDLE* g_socket_reactor_threads = NULL;
+static size_t g_socket_reactor_thread_count = 0;
+static int g_socket_reactor_stop = 0;
+
+static int socket_reactor_thread(void* arg)
+{
+    SOCKET_REACTOR_HANDLE socket_reactor = (SOCKET_REACTOR_HANDLE)arg;
+
+    while (__sync_fetch_and_add(&g_socket_reactor_stop, 0) == 0)
+    {
+        if (socket_reactor_run(socket_reactor, SOCKET_REACTOR_THREAD_TIMEOUT_MS) < 0)
+        {
+            /* avoid spinning on a persistent failure */
+            ThreadAPI_Sleep(SOCKET_REACTOR_THREAD_TIMEOUT_MS);
+        }
+    }
+
+    return 0;
+}
+
+static void join_socket_reactor_threads(void)
+{
+    size_t i;
+
+    (void)__sync_lock_test_and_set(&g_socket_reactor_stop, 1);
+
+    for (i = 0; i < g_socket_reactor_thread_count; i++)
+    {
+        int thread_result;
+        if (ThreadAPI_Join(g_socket_reactor_threads[i], &thread_result) != THREADAPI_OK)
+        {
+            LogError("Failure joining socket reactor thread %lu", (unsigned long)i);
+        }
+    }
+
+    free(g_socket_reactor_threads);
+    g_socket_reactor_threads = NULL;
+    g_socket_reactor_thread_count = 0;
+}
+
 int platform_init(void)
 {
     int result;
+
+    if (string_intern_init() != 0)
+    {
+        LogError("string_intern_init failed");
+        result = __FAILURE__;
+    }
+    else if (dns_cache_init() != 0)
+    {
+        LogError("dns_cache_init failed");
+        string_intern_deinit();
+        result = __FAILURE__;
+    }
+    else
+    {
 #ifdef USE_OPENSSL
-    result = tlsio_openssl_init();
+        result = tlsio_openssl_init();
+        if (result != 0)
+        {
+            dns_cache_deinit();
+            string_intern_deinit();
+        }
 #else
-    result = 0;
+        result = 0;
 #endif
+#if USE_WOLFSSL
+        if ((result == 0) && (tlsio_wolfssl_init() != 0))
+        {
+#ifdef USE_OPENSSL
+            tlsio_openssl_deinit();
+#endif
+            dns_cache_deinit();
+            string_intern_deinit();
+            result = __FAILURE__;
+        }
+#endif
+    }
+
     return result;
 }
 
@@ -62,9 +144,85 @@ STRING_HANDLE platform_get_platform_info(void)
     return result;
 }
 
+int platform_start_socket_reactor(size_t thread_count)
+{
+    int result;
+
+    if (thread_count == 0)
+    {
+        LogError("Invalid argument: thread_count is 0");
+        result = __FAILURE__;
+    }
+    else if (g_socket_reactor != NULL)
+    {
+        LogError("Socket reactor is already running");
+        result = __FAILURE__;
+    }
+    else if ((g_socket_reactor = socket_reactor_create()) == NULL)
+    {
+        LogError("socket_reactor_create failed");
+        result = __FAILURE__;
+    }
+    else if ((g_socket_reactor_threads = (THREAD_HANDLE*)malloc(thread_count * sizeof(THREAD_HANDLE))) == NULL)
+    {
+        LogError("Failure allocating socket reactor threads");
+        socket_reactor_destroy(g_socket_reactor);
+        g_socket_reactor = NULL;
+        result = __FAILURE__;
+    }
+    else
+    {
+        g_socket_reactor_stop = 0;
+        __sync_synchronize();
+
+        result = 0;
+        for (g_socket_reactor_thread_count = 0; g_socket_reactor_thread_count < thread_count; g_socket_reactor_thread_count++)
+        {
+            if (ThreadAPI_Create(&g_socket_reactor_threads[g_socket_reactor_thread_count], socket_reactor_thread, g_socket_reactor) != THREADAPI_OK)
+            {
+                LogError("Failure creating socket reactor thread %lu", (unsigned long)g_socket_reactor_thread_count);
+                result = __FAILURE__;
+                break;
+            }
+        }
+
+        if (result != 0)
+        {
+            join_socket_reactor_threads();
+            socket_reactor_destroy(g_socket_reactor);
+            g_socket_reactor = NULL;
+        }
+    }
+
+    return result;
+}
+
+void platform_stop_socket_reactor(void)
+{
+    if (g_socket_reactor != NULL)
+    {
+        join_socket_reactor_threads();
+        socket_reactor_destroy(g_socket_reactor);
+        g_socket_reactor = NULL;
+    }
+}
+
+SOCKET_REACTOR_HANDLE platform_get_socket_reactor(void)
+{
+    return g_socket_reactor;
+}
+
 void platform_deinit(void)
 {
+    platform_stop_socket_reactor();
+
 #ifdef USE_OPENSSL
     tlsio_openssl_deinit();
 #endif
+#if USE_WOLFSSL
+    tlsio_wolfssl_deinit();
+#endif
+
+    dns_cache_deinit();
+    string_intern_deinit();
 }
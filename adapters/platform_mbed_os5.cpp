@@ -8,7 +8,7 @@
 
 int platform_init(void)
 {
-    return 0;
+    return tlsio_mbedtls_init();
 }
 
 const IO_INTERFACE_DESCRIPTION *platform_get_default_tlsio(void)
@@ -24,4 +24,5 @@ STRING_HANDLE platform_get_platform_info(void)
 
 void platform_deinit(void)
 {
+    tlsio_mbedtls_deinit();
 }
@@ -20,6 +20,10 @@
 
 #include "azure_c_shared_utility/tlsio_schannel.h"
 
+#if !defined(USE_OPENSSL) && !USE_CYCLONESSL && !USE_WOLFSSL && !defined(WINCE)
+#define USE_SCHANNEL_DEFAULT_TLSIO
+#endif
+
 int platform_init(void)
 {
     int result;
@@ -35,6 +39,12 @@ int platform_init(void)
     {
 #ifdef USE_OPENSSL
         tlsio_openssl_init();
+#endif
+#if USE_WOLFSSL
+        (void)tlsio_wolfssl_init();
+#endif
+#ifdef USE_SCHANNEL_DEFAULT_TLSIO
+        (void)tlsio_schannel_init();
 #endif
         result = 0;
     }
@@ -130,4 +140,10 @@ void platform_deinit(void)
 #ifdef USE_OPENSSL
     tlsio_openssl_deinit();
 #endif
+#if USE_WOLFSSL
+    tlsio_wolfssl_deinit();
+#endif
+#ifdef USE_SCHANNEL_DEFAULT_TLSIO
+    tlsio_schannel_deinit();
+#endif
 }
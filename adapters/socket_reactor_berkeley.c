@@ -0,0 +1,473 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#if defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#include <sys/types.h>
+#include <sys/event.h>
+#include <sys/time.h>
+#define SOCKET_REACTOR_USE_KQUEUE
+#else
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#endif
+#include "azure_c_shared_utility/socket_reactor.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#ifndef SOCKET_REACTOR_MAX_EVENTS
+#define SOCKET_REACTOR_MAX_EVENTS      64
+#endif
+
+#define SOCKET_REACTOR_INITIAL_CAPACITY 64
+
+#ifdef SOCKET_REACTOR_USE_KQUEUE
+/* the EVFILT_USER event of socket_reactor_wake, its identifier space is apart from the descriptors */
+#define SOCKET_REACTOR_WAKE_IDENT       0
+#endif
+
+typedef struct SOCKET_REACTOR_REGISTRATION_TAG
+{
+    ON_SOCKET_REACTOR_EVENT on_event;
+    void* on_event_context;
+} SOCKET_REACTOR_REGISTRATION;
+
+typedef struct SOCKET_REACTOR_INSTANCE_TAG
+{
+    int poll_fd;
+#ifndef SOCKET_REACTOR_USE_KQUEUE
+    /* the eventfd written by socket_reactor_wake, it is in the poll set but not in the registrations */
+    int wake_fd;
+#endif
+    LOCK_HANDLE lock;
+    /* registrations are indexed by the socket descriptor, which keeps dispatch O(1) */
+    SOCKET_REACTOR_REGISTRATION* registrations;
+    size_t registration_capacity;
+} SOCKET_REACTOR_INSTANCE;
+
+static int ensure_registration_capacity(SOCKET_REACTOR_INSTANCE* reactor_instance, int socket)
+{
+    int result;
+
+    if ((size_t)socket < reactor_instance->registration_capacity)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t new_capacity = (reactor_instance->registration_capacity == 0) ? SOCKET_REACTOR_INITIAL_CAPACITY : reactor_instance->registration_capacity;
+        SOCKET_REACTOR_REGISTRATION* new_registrations;
+
+        while (new_capacity <= (size_t)socket)
+        {
+            new_capacity *= 2;
+        }
+
+        new_registrations = (SOCKET_REACTOR_REGISTRATION*)realloc(reactor_instance->registrations, new_capacity * sizeof(SOCKET_REACTOR_REGISTRATION));
+        if (new_registrations == NULL)
+        {
+            LogError("Failure: unable to grow reactor registration table to %lu entries.", (unsigned long)new_capacity);
+            result = __FAILURE__;
+        }
+        else
+        {
+            (void)memset(new_registrations + reactor_instance->registration_capacity, 0, (new_capacity - reactor_instance->registration_capacity) * sizeof(SOCKET_REACTOR_REGISTRATION));
+            reactor_instance->registrations = new_registrations;
+            reactor_instance->registration_capacity = new_capacity;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int add_to_poll_set(SOCKET_REACTOR_INSTANCE* reactor_instance, int socket)
+{
+    int result;
+#ifdef SOCKET_REACTOR_USE_KQUEUE
+    struct kevent changes[2];
+    EV_SET(&changes[0], socket, EVFILT_READ, EV_ADD | EV_CLEAR, 0, 0, NULL);
+    EV_SET(&changes[1], socket, EVFILT_WRITE, EV_ADD | EV_CLEAR, 0, 0, NULL);
+    result = kevent(reactor_instance->poll_fd, changes, 2, NULL, 0, NULL);
+#else
+    struct epoll_event event;
+    (void)memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN | EPOLLOUT | EPOLLRDHUP | EPOLLET;
+    event.data.fd = socket;
+    result = epoll_ctl(reactor_instance->poll_fd, EPOLL_CTL_ADD, socket, &event);
+#endif
+    return result;
+}
+
+static int remove_from_poll_set(SOCKET_REACTOR_INSTANCE* reactor_instance, int socket)
+{
+    int result;
+#ifdef SOCKET_REACTOR_USE_KQUEUE
+    struct kevent changes[2];
+    EV_SET(&changes[0], socket, EVFILT_READ, EV_DELETE, 0, 0, NULL);
+    EV_SET(&changes[1], socket, EVFILT_WRITE, EV_DELETE, 0, 0, NULL);
+    result = kevent(reactor_instance->poll_fd, changes, 2, NULL, 0, NULL);
+#else
+    struct epoll_event event;
+    /* a non-NULL event is required by kernels older than 2.6.9 */
+    (void)memset(&event, 0, sizeof(event));
+    result = epoll_ctl(reactor_instance->poll_fd, EPOLL_CTL_DEL, socket, &event);
+#endif
+    return result;
+}
+
+static int add_wake_event(SOCKET_REACTOR_INSTANCE* reactor_instance)
+{
+    int result;
+#ifdef SOCKET_REACTOR_USE_KQUEUE
+    struct kevent change;
+    EV_SET(&change, SOCKET_REACTOR_WAKE_IDENT, EVFILT_USER, EV_ADD | EV_CLEAR, 0, 0, NULL);
+    result = kevent(reactor_instance->poll_fd, &change, 1, NULL, 0, NULL);
+#else
+    if ((reactor_instance->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) < 0)
+    {
+        result = -1;
+    }
+    else
+    {
+        /* level triggered, the wake stays pending until socket_reactor_run reads the counter */
+        struct epoll_event event;
+        (void)memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.fd = reactor_instance->wake_fd;
+        if ((result = epoll_ctl(reactor_instance->poll_fd, EPOLL_CTL_ADD, reactor_instance->wake_fd, &event)) != 0)
+        {
+            (void)close(reactor_instance->wake_fd);
+        }
+    }
+#endif
+    return result;
+}
+
+static void dispatch_event(SOCKET_REACTOR_INSTANCE* reactor_instance, int socket, unsigned int events)
+{
+    if (Lock(reactor_instance->lock) != LOCK_OK)
+    {
+        LogError("Failure: unable to acquire reactor lock.");
+    }
+    else
+    {
+        /* the callback runs under the lock so that unregister can guarantee it is not running */
+        if ((socket >= 0) &&
+            ((size_t)socket < reactor_instance->registration_capacity) &&
+            (reactor_instance->registrations[socket].on_event != NULL))
+        {
+            reactor_instance->registrations[socket].on_event(reactor_instance->registrations[socket].on_event_context, events);
+        }
+
+        (void)Unlock(reactor_instance->lock);
+    }
+}
+
+SOCKET_REACTOR_HANDLE socket_reactor_create(void)
+{
+    SOCKET_REACTOR_INSTANCE* result;
+
+    if ((result = (SOCKET_REACTOR_INSTANCE*)malloc(sizeof(SOCKET_REACTOR_INSTANCE))) == NULL)
+    {
+        LogError("Allocation Failure: SOCKET_REACTOR_INSTANCE");
+    }
+    else
+    {
+        result->registrations = NULL;
+        result->registration_capacity = 0;
+
+        if ((result->lock = Lock_Init()) == NULL)
+        {
+            LogError("Failure: Lock_Init failed.");
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+#ifdef SOCKET_REACTOR_USE_KQUEUE
+            result->poll_fd = kqueue();
+#else
+            result->poll_fd = epoll_create1(EPOLL_CLOEXEC);
+#endif
+            if (result->poll_fd < 0)
+            {
+                LogError("Failure: unable to create poll descriptor. errno=%d.", errno);
+                (void)Lock_Deinit(result->lock);
+                free(result);
+                result = NULL;
+            }
+            else if (add_wake_event(result) != 0)
+            {
+                LogError("Failure: unable to add the wake event to the poll set. errno=%d.", errno);
+                (void)close(result->poll_fd);
+                (void)Lock_Deinit(result->lock);
+                free(result);
+                result = NULL;
+            }
+        }
+    }
+
+    return result;
+}
+
+void socket_reactor_destroy(SOCKET_REACTOR_HANDLE reactor)
+{
+    if (reactor == NULL)
+    {
+        LogError("Invalid argument: reactor is NULL");
+    }
+    else
+    {
+        (void)close(reactor->poll_fd);
+#ifndef SOCKET_REACTOR_USE_KQUEUE
+        (void)close(reactor->wake_fd);
+#endif
+        (void)Lock_Deinit(reactor->lock);
+        free(reactor->registrations);
+        free(reactor);
+    }
+}
+
+int socket_reactor_register(SOCKET_REACTOR_HANDLE reactor, int socket, ON_SOCKET_REACTOR_EVENT on_event, void* on_event_context)
+{
+    int result;
+
+    if ((reactor == NULL) ||
+        (socket < 0) ||
+        (on_event == NULL))
+    {
+        LogError("Invalid argument: reactor=%p, socket=%d, on_event=%p", reactor, socket, on_event);
+        result = __FAILURE__;
+    }
+    else if (Lock(reactor->lock) != LOCK_OK)
+    {
+        LogError("Failure: unable to acquire reactor lock.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (ensure_registration_capacity(reactor, socket) != 0)
+        {
+            LogError("Failure: unable to make room for socket %d.", socket);
+            result = __FAILURE__;
+        }
+        else if (reactor->registrations[socket].on_event != NULL)
+        {
+            LogError("Failure: socket %d is already registered.", socket);
+            result = __FAILURE__;
+        }
+        else
+        {
+            reactor->registrations[socket].on_event = on_event;
+            reactor->registrations[socket].on_event_context = on_event_context;
+
+            if (add_to_poll_set(reactor, socket) != 0)
+            {
+                LogError("Failure: unable to add socket %d to the poll set. errno=%d.", socket, errno);
+                reactor->registrations[socket].on_event = NULL;
+                reactor->registrations[socket].on_event_context = NULL;
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+
+        (void)Unlock(reactor->lock);
+    }
+
+    return result;
+}
+
+int socket_reactor_unregister(SOCKET_REACTOR_HANDLE reactor, int socket)
+{
+    int result;
+
+    if ((reactor == NULL) ||
+        (socket < 0))
+    {
+        LogError("Invalid argument: reactor=%p, socket=%d", reactor, socket);
+        result = __FAILURE__;
+    }
+    else if (Lock(reactor->lock) != LOCK_OK)
+    {
+        LogError("Failure: unable to acquire reactor lock.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (((size_t)socket >= reactor->registration_capacity) ||
+            (reactor->registrations[socket].on_event == NULL))
+        {
+            LogError("Failure: socket %d is not registered.", socket);
+            result = __FAILURE__;
+        }
+        else
+        {
+            if (remove_from_poll_set(reactor, socket) != 0)
+            {
+                /* the registration is dropped anyway, a stale event will find no callback */
+                LogError("Failure: unable to remove socket %d from the poll set. errno=%d.", socket, errno);
+            }
+
+            reactor->registrations[socket].on_event = NULL;
+            reactor->registrations[socket].on_event_context = NULL;
+            result = 0;
+        }
+
+        (void)Unlock(reactor->lock);
+    }
+
+    return result;
+}
+
+int socket_reactor_run(SOCKET_REACTOR_HANDLE reactor, unsigned int timeout_ms)
+{
+    int result;
+
+    if (reactor == NULL)
+    {
+        LogError("Invalid argument: reactor is NULL");
+        result = -1;
+    }
+    else
+    {
+        int event_count;
+        int i;
+#ifdef SOCKET_REACTOR_USE_KQUEUE
+        struct kevent events[SOCKET_REACTOR_MAX_EVENTS];
+        struct timespec timeout;
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+
+        event_count = kevent(reactor->poll_fd, NULL, 0, events, SOCKET_REACTOR_MAX_EVENTS, &timeout);
+#else
+        struct epoll_event events[SOCKET_REACTOR_MAX_EVENTS];
+
+        event_count = epoll_wait(reactor->poll_fd, events, SOCKET_REACTOR_MAX_EVENTS, (int)timeout_ms);
+#endif
+        if (event_count < 0)
+        {
+            if (errno == EINTR)
+            {
+                result = 0;
+            }
+            else
+            {
+                LogError("Failure: waiting for socket events failed. errno=%d.", errno);
+                result = -1;
+            }
+        }
+        else
+        {
+            result = event_count;
+
+            for (i = 0; i < event_count; i++)
+            {
+                unsigned int reactor_events = 0;
+#ifdef SOCKET_REACTOR_USE_KQUEUE
+                if (events[i].filter == EVFILT_USER)
+                {
+                    /* EV_CLEAR rearmed the wake event as it was returned, it is not counted as dispatched */
+                    result--;
+                }
+                else
+                {
+                    if (events[i].filter == EVFILT_READ)
+                    {
+                        reactor_events |= SOCKET_REACTOR_EVENT_READABLE;
+                    }
+                    else if (events[i].filter == EVFILT_WRITE)
+                    {
+                        reactor_events |= SOCKET_REACTOR_EVENT_WRITABLE;
+                    }
+
+                    if ((events[i].flags & (EV_EOF | EV_ERROR)) != 0)
+                    {
+                        reactor_events |= SOCKET_REACTOR_EVENT_ERROR;
+                    }
+
+                    dispatch_event(reactor, (int)events[i].ident, reactor_events);
+                }
+#else
+                if (events[i].data.fd == reactor->wake_fd)
+                {
+                    uint64_t wake_count;
+
+                    /* reading resets the counter, wakes made meanwhile leave it non-zero again */
+                    if ((read(reactor->wake_fd, &wake_count, sizeof(wake_count)) < 0) && (errno != EAGAIN))
+                    {
+                        LogError("Failure: unable to read the wake event. errno=%d.", errno);
+                    }
+
+                    /* the wake is not counted as dispatched */
+                    result--;
+                }
+                else
+                {
+                    if ((events[i].events & (EPOLLIN | EPOLLPRI)) != 0)
+                    {
+                        reactor_events |= SOCKET_REACTOR_EVENT_READABLE;
+                    }
+
+                    if ((events[i].events & EPOLLOUT) != 0)
+                    {
+                        reactor_events |= SOCKET_REACTOR_EVENT_WRITABLE;
+                    }
+
+                    if ((events[i].events & (EPOLLERR | EPOLLHUP | EPOLLRDHUP)) != 0)
+                    {
+                        reactor_events |= SOCKET_REACTOR_EVENT_ERROR;
+                    }
+
+                    dispatch_event(reactor, events[i].data.fd, reactor_events);
+                }
+#endif
+            }
+        }
+    }
+
+    return result;
+}
+
+int socket_reactor_wake(SOCKET_REACTOR_HANDLE reactor)
+{
+    int result;
+
+    if (reactor == NULL)
+    {
+        LogError("Invalid argument: reactor is NULL");
+        result = __FAILURE__;
+    }
+    else
+    {
+#ifdef SOCKET_REACTOR_USE_KQUEUE
+        struct kevent change;
+        EV_SET(&change, SOCKET_REACTOR_WAKE_IDENT, EVFILT_USER, 0, NOTE_TRIGGER, 0, NULL);
+        if (kevent(reactor->poll_fd, &change, 1, NULL, 0, NULL) != 0)
+#else
+        uint64_t wake_count = 1;
+        /* EAGAIN only happens with the counter at its maximum, the reactor is woken then anyway */
+        if ((write(reactor->wake_fd, &wake_count, sizeof(wake_count)) < 0) && (errno != EAGAIN))
+#endif
+        {
+            LogError("Failure: unable to trigger the wake event. errno=%d.", errno);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,356 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <winsock2.h>
+#include <windows.h>
+#include "azure_c_shared_utility/socket_reactor.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#ifndef SOCKET_REACTOR_MAX_EVENTS
+#define SOCKET_REACTOR_MAX_EVENTS      64
+#endif
+
+#define SOCKET_REACTOR_INITIAL_CAPACITY 64
+
+/* the completion key of a socket is its slot in the registration table and the generation of that
+   slot, so that a completion dequeued after the socket was unregistered (or its slot reused) is dropped */
+#define SOCKET_REACTOR_SLOT_BITS        20
+#define SOCKET_REACTOR_SLOT_MASK        ((((ULONG_PTR)1) << SOCKET_REACTOR_SLOT_BITS) - 1)
+#define SOCKET_REACTOR_MAX_SLOTS        ((size_t)SOCKET_REACTOR_SLOT_MASK)
+#define SOCKET_REACTOR_GENERATION_MASK  (((ULONG_PTR)-1) >> SOCKET_REACTOR_SLOT_BITS)
+
+typedef struct SOCKET_REACTOR_REGISTRATION_TAG
+{
+    SOCKET socket;
+    ULONG_PTR generation;
+    ON_SOCKET_REACTOR_EVENT on_event;
+    void* on_event_context;
+} SOCKET_REACTOR_REGISTRATION;
+
+typedef struct SOCKET_REACTOR_INSTANCE_TAG
+{
+    HANDLE completion_port;
+    LOCK_HANDLE lock;
+    SOCKET_REACTOR_REGISTRATION* registrations;
+    size_t registration_capacity;
+} SOCKET_REACTOR_INSTANCE;
+
+static ULONG_PTR make_completion_key(size_t slot, ULONG_PTR generation)
+{
+    return (generation << SOCKET_REACTOR_SLOT_BITS) | (ULONG_PTR)slot;
+}
+
+static int find_free_slot(SOCKET_REACTOR_INSTANCE* reactor_instance, size_t* slot)
+{
+    int result;
+    size_t i;
+
+    for (i = 0; i < reactor_instance->registration_capacity; i++)
+    {
+        if (reactor_instance->registrations[i].on_event == NULL)
+        {
+            break;
+        }
+    }
+
+    if (i < reactor_instance->registration_capacity)
+    {
+        *slot = i;
+        result = 0;
+    }
+    else
+    {
+        size_t new_capacity = (reactor_instance->registration_capacity == 0) ? SOCKET_REACTOR_INITIAL_CAPACITY : reactor_instance->registration_capacity * 2;
+        SOCKET_REACTOR_REGISTRATION* new_registrations;
+
+        if (new_capacity > SOCKET_REACTOR_MAX_SLOTS)
+        {
+            new_capacity = SOCKET_REACTOR_MAX_SLOTS;
+        }
+
+        if (new_capacity <= reactor_instance->registration_capacity)
+        {
+            LogError("Failure: the reactor cannot hold more than %lu sockets.", (unsigned long)SOCKET_REACTOR_MAX_SLOTS);
+            result = __FAILURE__;
+        }
+        else if ((new_registrations = (SOCKET_REACTOR_REGISTRATION*)realloc(reactor_instance->registrations, new_capacity * sizeof(SOCKET_REACTOR_REGISTRATION))) == NULL)
+        {
+            LogError("Failure: unable to grow reactor registration table to %lu entries.", (unsigned long)new_capacity);
+            result = __FAILURE__;
+        }
+        else
+        {
+            (void)memset(new_registrations + reactor_instance->registration_capacity, 0, (new_capacity - reactor_instance->registration_capacity) * sizeof(SOCKET_REACTOR_REGISTRATION));
+            *slot = reactor_instance->registration_capacity;
+            reactor_instance->registrations = new_registrations;
+            reactor_instance->registration_capacity = new_capacity;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void dispatch_completion(SOCKET_REACTOR_INSTANCE* reactor_instance, const OVERLAPPED_ENTRY* entry)
+{
+    size_t slot = (size_t)(entry->lpCompletionKey & SOCKET_REACTOR_SLOT_MASK);
+    ULONG_PTR generation = entry->lpCompletionKey >> SOCKET_REACTOR_SLOT_BITS;
+
+    if (Lock(reactor_instance->lock) != LOCK_OK)
+    {
+        LogError("Failure: unable to acquire reactor lock.");
+    }
+    else
+    {
+        /* the callback runs under the lock so that unregister can guarantee it is not running */
+        if ((entry->lpOverlapped != NULL) &&
+            (slot < reactor_instance->registration_capacity) &&
+            (reactor_instance->registrations[slot].on_event != NULL) &&
+            (reactor_instance->registrations[slot].generation == generation))
+        {
+            SOCKET_REACTOR_REGISTRATION* registration = &reactor_instance->registrations[slot];
+            SOCKET_REACTOR_OVERLAPPED* operation = CONTAINING_RECORD(entry->lpOverlapped, SOCKET_REACTOR_OVERLAPPED, overlapped);
+            DWORD bytes_transferred;
+            DWORD flags;
+            unsigned int events = operation->event;
+
+            if (WSAGetOverlappedResult(registration->socket, &operation->overlapped, &bytes_transferred, FALSE, &flags))
+            {
+                operation->error = 0;
+            }
+            else
+            {
+                operation->error = WSAGetLastError();
+                events |= SOCKET_REACTOR_EVENT_ERROR;
+            }
+            operation->bytes_transferred = entry->dwNumberOfBytesTransferred;
+
+            registration->on_event(registration->on_event_context, events);
+        }
+        (void)Unlock(reactor_instance->lock);
+    }
+}
+
+SOCKET_REACTOR_HANDLE socket_reactor_create(void)
+{
+    SOCKET_REACTOR_INSTANCE* result;
+
+    if ((result = (SOCKET_REACTOR_INSTANCE*)malloc(sizeof(SOCKET_REACTOR_INSTANCE))) == NULL)
+    {
+        LogError("Allocation Failure: SOCKET_REACTOR_INSTANCE");
+    }
+    else
+    {
+        result->registrations = NULL;
+        result->registration_capacity = 0;
+
+        if ((result->lock = Lock_Init()) == NULL)
+        {
+            LogError("Failure: Lock_Init failed.");
+            free(result);
+            result = NULL;
+        }
+        else if ((result->completion_port = CreateIoCompletionPort(INVALID_HANDLE_VALUE, NULL, 0, 0)) == NULL)
+        {
+            LogError("Failure: unable to create the completion port. error=%lu.", (unsigned long)GetLastError());
+            (void)Lock_Deinit(result->lock);
+            free(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+void socket_reactor_destroy(SOCKET_REACTOR_HANDLE reactor)
+{
+    if (reactor == NULL)
+    {
+        LogError("Invalid argument: reactor is NULL");
+    }
+    else
+    {
+        (void)CloseHandle(reactor->completion_port);
+        (void)Lock_Deinit(reactor->lock);
+        free(reactor->registrations);
+        free(reactor);
+    }
+}
+
+int socket_reactor_register(SOCKET_REACTOR_HANDLE reactor, int socket, ON_SOCKET_REACTOR_EVENT on_event, void* on_event_context)
+{
+    int result;
+
+    if ((reactor == NULL) ||
+        ((SOCKET)socket == INVALID_SOCKET) ||
+        (on_event == NULL))
+    {
+        LogError("Invalid argument: reactor=%p, socket=%d, on_event=%p", reactor, socket, on_event);
+        result = __FAILURE__;
+    }
+    else if (Lock(reactor->lock) != LOCK_OK)
+    {
+        LogError("Failure: unable to acquire reactor lock.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t slot;
+
+        if (find_free_slot(reactor, &slot) != 0)
+        {
+            LogError("Failure: unable to make room for socket %d.", socket);
+            result = __FAILURE__;
+        }
+        else
+        {
+            SOCKET_REACTOR_REGISTRATION* registration = &reactor->registrations[slot];
+            ULONG_PTR generation = (registration->generation + 1) & SOCKET_REACTOR_GENERATION_MASK;
+
+            /* a socket stays associated with the port until it is closed, it cannot be registered twice */
+            if (CreateIoCompletionPort((HANDLE)(SOCKET)socket, reactor->completion_port, make_completion_key(slot, generation), 0) == NULL)
+            {
+                LogError("Failure: unable to associate socket %d with the completion port. error=%lu.", socket, (unsigned long)GetLastError());
+                result = __FAILURE__;
+            }
+            else
+            {
+                registration->socket = (SOCKET)socket;
+                registration->generation = generation;
+                registration->on_event = on_event;
+                registration->on_event_context = on_event_context;
+                result = 0;
+            }
+        }
+        (void)Unlock(reactor->lock);
+    }
+
+    return result;
+}
+
+int socket_reactor_unregister(SOCKET_REACTOR_HANDLE reactor, int socket)
+{
+    int result;
+
+    if ((reactor == NULL) ||
+        ((SOCKET)socket == INVALID_SOCKET))
+    {
+        LogError("Invalid argument: reactor=%p, socket=%d", reactor, socket);
+        result = __FAILURE__;
+    }
+    else if (Lock(reactor->lock) != LOCK_OK)
+    {
+        LogError("Failure: unable to acquire reactor lock.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+
+        for (i = 0; i < reactor->registration_capacity; i++)
+        {
+            if ((reactor->registrations[i].on_event != NULL) &&
+                (reactor->registrations[i].socket == (SOCKET)socket))
+            {
+                break;
+            }
+        }
+
+        if (i == reactor->registration_capacity)
+        {
+            LogError("Failure: socket %d is not registered.", socket);
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* completions still queued for the socket no longer match the key generation and are dropped */
+            reactor->registrations[i].socket = INVALID_SOCKET;
+            reactor->registrations[i].on_event = NULL;
+            reactor->registrations[i].on_event_context = NULL;
+            result = 0;
+        }
+        (void)Unlock(reactor->lock);
+    }
+
+    return result;
+}
+
+int socket_reactor_run(SOCKET_REACTOR_HANDLE reactor, unsigned int timeout_ms)
+{
+    int result;
+
+    if (reactor == NULL)
+    {
+        LogError("Invalid argument: reactor is NULL");
+        result = -1;
+    }
+    else
+    {
+        OVERLAPPED_ENTRY entries[SOCKET_REACTOR_MAX_EVENTS];
+        ULONG entry_count;
+
+        if (!GetQueuedCompletionStatusEx(reactor->completion_port, entries, SOCKET_REACTOR_MAX_EVENTS, &entry_count, (DWORD)timeout_ms, FALSE))
+        {
+            DWORD last_error = GetLastError();
+            if (last_error == WAIT_TIMEOUT)
+            {
+                result = 0;
+            }
+            else
+            {
+                LogError("Failure: waiting for completions failed. error=%lu.", (unsigned long)last_error);
+                result = -1;
+            }
+        }
+        else
+        {
+            ULONG i;
+
+            result = (int)entry_count;
+
+            for (i = 0; i < entry_count; i++)
+            {
+                if (entries[i].lpOverlapped == NULL)
+                {
+                    /* posted by socket_reactor_wake, not counted as dispatched */
+                    result--;
+                }
+                else
+                {
+                    dispatch_completion(reactor, &entries[i]);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+int socket_reactor_wake(SOCKET_REACTOR_HANDLE reactor)
+{
+    int result;
+
+    if (reactor == NULL)
+    {
+        LogError("Invalid argument: reactor is NULL");
+        result = __FAILURE__;
+    }
+    /* a completion without an OVERLAPPED is never produced by a socket operation */
+    else if (!PostQueuedCompletionStatus(reactor->completion_port, 0, 0, NULL))
+    {
+        LogError("Failure: unable to post the wake completion. error=%lu.", (unsigned long)GetLastError());
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
@@ -18,13 +18,16 @@
 #include <signal.h>
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <string.h>
 #include <ctype.h>
+#include <pthread.h>
 #include "azure_c_shared_utility/socketio.h"
 #include <sys/types.h>
 #include <sys/socket.h>
-#include <sys/select.h>
+#include <poll.h>
+#include <sys/uio.h>
 #ifdef TIZENRT
 #include <net/lwip/tcp.h>
 #else
@@ -34,7 +37,10 @@
 #include <unistd.h>
 #include <fcntl.h>
 #include <errno.h>
-#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/constbuffer.h"
+#include "azure_c_shared_utility/constbuffer_array.h"
+#include "azure_c_shared_utility/dns_cache.h"
+#include "dns_async.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/gbnetwork.h"
 #include "azure_c_shared_utility/optimize_size.h"
@@ -42,11 +48,37 @@
 #include "azure_c_shared_utility/shared_util_options.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/const_defines.h"
+#include "azure_c_shared_utility/socket_reactor.h"
+#include "azure_c_shared_utility/string_intern.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#if defined(USE_OBJECT_POOLS) && defined(OBJECT_POOL_STATIC)
+#include "azure_c_shared_utility/object_pool.h"
+#endif
 #include <sys/ioctl.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <sys/un.h>
 
+#ifdef __linux__
+#include <linux/netlink.h>
+#include <linux/rtnetlink.h>
+#define SOCKETIO_HAS_INTERFACE_NOTIFICATIONS
+#endif
+
+#if defined(__linux__) && defined(SO_ZEROCOPY) && defined(MSG_ZEROCOPY)
+#include <linux/errqueue.h>
+#define SOCKETIO_HAS_ZEROCOPY
+#endif
+
+#if defined(USE_OBJECT_POOLS) && defined(OBJECT_POOL_STATIC)
+/* the bytes that could not be sent yet come from the payload pools of object_pool, so a full pool fails the send */
+#define pending_bytes_malloc(size) object_pool_payload_alloc(size)
+#define pending_bytes_free(bytes) object_pool_payload_free(bytes)
+#else
+#define pending_bytes_malloc(size) malloc(size)
+#define pending_bytes_free(bytes) free(bytes)
+#endif
+
 #define SOCKET_SUCCESS                 0
 #define INVALID_SOCKET                 -1
 #define MAC_ADDRESS_STRING_LENGTH      18
@@ -58,6 +90,36 @@
 // connect timeout in seconds
 #define CONNECT_TIMEOUT         10
 
+// how often a host name lookup running in the background is checked for completion
+#ifndef SOCKETIO_LOOKUP_CHECK_INTERVAL_MS
+#define SOCKETIO_LOOKUP_CHECK_INTERVAL_MS       10
+#endif
+
+// delay between starting two connection attempts to the addresses of a host (RFC 8305)
+#ifndef SOCKETIO_CONNECTION_ATTEMPT_DELAY_MS
+#define SOCKETIO_CONNECTION_ATTEMPT_DELAY_MS    250
+#endif
+
+// maximum number of addresses of a host that are tried
+#ifndef SOCKETIO_MAX_CONNECT_ADDRESSES
+#define SOCKETIO_MAX_CONNECT_ADDRESSES  8
+#endif
+
+// maximum number of buffers handed to a single sendmsg call
+#ifndef SOCKETIO_SENDV_MAX_BUFFERS
+#define SOCKETIO_SENDV_MAX_BUFFERS  16
+#endif
+
+// number of pending sends the queue holds before it has to grow
+#ifndef SOCKETIO_PENDING_IO_INITIAL_CAPACITY
+#define SOCKETIO_PENDING_IO_INITIAL_CAPACITY    16
+#endif
+
+// number of zero copy sends waiting for the kernel that are tracked before the list has to grow
+#ifndef SOCKETIO_ZEROCOPY_SEND_INITIAL_CAPACITY
+#define SOCKETIO_ZEROCOPY_SEND_INITIAL_CAPACITY 8
+#endif
+
 typedef enum IO_STATE_TAG
 {
     IO_STATE_CLOSED,
@@ -69,13 +131,70 @@ typedef enum IO_STATE_TAG
 
 typedef struct PENDING_SOCKET_IO_TAG
 {
+    /* a pending send either holds a reference on the caller's buffer or owns a copy of the bytes */
+    CONSTBUFFER_HANDLE buffer_handle;
     unsigned char* bytes;
+    /* what is left to send */
+    const unsigned char* data;
     size_t size;
     ON_SEND_COMPLETE on_send_complete;
     void* callback_context;
-    SINGLYLINKEDLIST_HANDLE pending_io_list;
+    /* a buffer of at least socketio_zerocopy_threshold bytes is sent with MSG_ZEROCOPY, zerocopy_id being the id
+       the kernel gave to the last send call that took some of it */
+    bool zerocopy;
+    bool zerocopy_sent;
+    uint32_t zerocopy_id;
 } PENDING_SOCKET_IO;
 
+/* a send that left the pending queue but completes once the kernel releases the pages of its buffer */
+typedef struct ZEROCOPY_SEND_TAG
+{
+    /* NULL for a send that was copied and only completes after the zero copy sends before it */
+    CONSTBUFFER_HANDLE buffer_handle;
+    uint32_t last_id;
+    ON_SEND_COMPLETE on_send_complete;
+    void* callback_context;
+} ZEROCOPY_SEND;
+
+typedef enum SOCKETIO_ZEROCOPY_STATE_TAG
+{
+    /* SO_ZEROCOPY is only asked for when the socket has a buffer large enough to send */
+    SOCKETIO_ZEROCOPY_UNKNOWN,
+    SOCKETIO_ZEROCOPY_ON,
+    SOCKETIO_ZEROCOPY_OFF
+} SOCKETIO_ZEROCOPY_STATE;
+
+/* the socket options that can be set through socketio_setoption and are kept to be applied to every new socket */
+typedef enum SOCKET_TUNING_OPTION_TAG
+{
+    SOCKET_TUNING_TCP_NODELAY,
+    SOCKET_TUNING_TCP_QUICKACK,
+    SOCKET_TUNING_SO_SNDBUF,
+    SOCKET_TUNING_SO_RCVBUF,
+    SOCKET_TUNING_TCP_FASTOPEN,
+    SOCKET_TUNING_SO_BUSY_POLL,
+    SOCKET_TUNING_OPTION_COUNT
+} SOCKET_TUNING_OPTION;
+
+typedef struct CONNECT_ADDRESS_TAG
+{
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+} CONNECT_ADDRESS;
+
+/* an open in progress resolves the host while dns_lookup is not NULL, then connects to its addresses, carried on by each dowork */
+typedef struct CONNECT_STATE_TAG
+{
+    DNS_ASYNC_HANDLE dns_lookup;
+    CONNECT_ADDRESS addresses[SOCKETIO_MAX_CONNECT_ADDRESSES];
+    int attempts[SOCKETIO_MAX_CONNECT_ADDRESSES];
+    size_t address_count;
+    size_t started_count;
+    size_t in_progress_count;
+    tickcounter_us_t deadline;
+    tickcounter_us_t next_attempt;
+} CONNECT_STATE;
+
 typedef struct SOCKET_IO_INSTANCE_TAG
 {
     int socket;
@@ -84,14 +203,62 @@ typedef struct SOCKET_IO_INSTANCE_TAG
     ON_IO_ERROR on_io_error;
     void* on_bytes_received_context;
     void* on_io_error_context;
-    char* hostname;
+    const char* hostname;
     int port;
     char* target_mac_address;
     IO_STATE io_state;
-    SINGLYLINKEDLIST_HANDLE pending_io_list;
+    ON_IO_OPEN_COMPLETE on_io_open_complete;
+    void* on_io_open_complete_context;
+    /* only allocated while an open is in progress, an idle connection does not pay for it */
+    CONNECT_STATE* connect;
+    /* pending sends are kept by value in a ring, so queueing does not allocate once it is warm */
+    PENDING_SOCKET_IO* pending_ios;
+    size_t pending_io_head;
+    size_t pending_io_count;
+    size_t pending_io_capacity;
+    SOCKET_REACTOR_HANDLE socket_reactor;
+    /* readiness reported by the reactor thread(s), only accessed with atomic builtins */
+    unsigned int ready_events;
+    XIO_STATS stats;
+    /* bit n of tuning_options_set tells whether tuning_values[n] was set */
+    unsigned int tuning_options_set;
+    int tuning_values[SOCKET_TUNING_OPTION_COUNT];
+    /* reads up to RECEIVE_BYTES_VALUE go to recv_bytes, larger ones to large_recv_bytes,
+       or all of them to the buffer of the thread with socketio_shared_receive_buffer */
+    size_t receive_size;
+    bool adaptive_receive;
+    bool shared_receive_buffer;
+    size_t receive_drain_limit;
+    /* zero copy state of the current socket; the kernel numbers the MSG_ZEROCOPY send calls of a socket from 0
+       and the ids before zerocopy_completed_id have been released */
+    size_t zerocopy_threshold;
+    SOCKETIO_ZEROCOPY_STATE zerocopy_state;
+    uint32_t zerocopy_next_id;
+    uint32_t zerocopy_completed_id;
+    ZEROCOPY_SEND* zerocopy_sends;
+    size_t zerocopy_send_head;
+    size_t zerocopy_send_count;
+    size_t zerocopy_send_capacity;
+    unsigned char* large_recv_bytes;
+    size_t large_recv_capacity;
+    /* the memory lent by xio_set_receive_buffer for the next read only */
+    unsigned char* lent_recv_bytes;
+    size_t lent_recv_size;
     unsigned char recv_bytes[RECEIVE_BYTES_VALUE];
 } SOCKET_IO_INSTANCE;
 
+/* the receive buffer shared by the connections worked from a thread, freed when the thread exits */
+typedef struct THREAD_RECEIVE_BUFFER_TAG
+{
+    unsigned char* bytes;
+    size_t capacity;
+} THREAD_RECEIVE_BUFFER;
+
+static __thread THREAD_RECEIVE_BUFFER* thread_receive_buffer = NULL;
+static pthread_once_t thread_receive_buffer_once = PTHREAD_ONCE_INIT;
+static pthread_key_t thread_receive_buffer_key;
+static bool thread_receive_buffer_key_created = false;
+
 typedef struct NETWORK_INTERFACE_DESCRIPTION_TAG
 {
     char* name;
@@ -100,10 +267,143 @@ typedef struct NETWORK_INTERFACE_DESCRIPTION_TAG
     struct NETWORK_INTERFACE_DESCRIPTION_TAG* next;
 } NETWORK_INTERFACE_DESCRIPTION;
 
+/* the interfaces that net_interface_mac_address binds to are enumerated once for the process, while socket IOs with that
+   option exist, and again after the netlink socket reports a link or address change; all of it is guarded by interface_cache_lock */
+static pthread_mutex_t interface_cache_lock = PTHREAD_MUTEX_INITIALIZER;
+static NETWORK_INTERFACE_DESCRIPTION* interface_cache = NULL;
+static bool interface_cache_is_valid = false;
+static size_t interface_cache_user_count = 0;
+static int interface_cache_notifications = INVALID_SOCKET;
+
+static const char* get_tuning_option_name(SOCKET_TUNING_OPTION option)
+{
+    const char* result;
+
+    switch (option)
+    {
+    case SOCKET_TUNING_TCP_NODELAY:
+        result = OPTION_TCP_NODELAY;
+        break;
+    case SOCKET_TUNING_TCP_QUICKACK:
+        result = OPTION_TCP_QUICKACK;
+        break;
+    case SOCKET_TUNING_SO_SNDBUF:
+        result = OPTION_SO_SNDBUF;
+        break;
+    case SOCKET_TUNING_SO_RCVBUF:
+        result = OPTION_SO_RCVBUF;
+        break;
+    case SOCKET_TUNING_TCP_FASTOPEN:
+        result = OPTION_TCP_FASTOPEN;
+        break;
+    case SOCKET_TUNING_SO_BUSY_POLL:
+        result = OPTION_SO_BUSY_POLL;
+        break;
+    default:
+        result = "";
+        break;
+    }
+
+    return result;
+}
+
+static int get_tuning_option(const char* name, SOCKET_TUNING_OPTION* option)
+{
+    int result = __FAILURE__;
+    int i;
+
+    for (i = 0; i < (int)SOCKET_TUNING_OPTION_COUNT; i++)
+    {
+        if (strcmp(name, get_tuning_option_name((SOCKET_TUNING_OPTION)i)) == 0)
+        {
+            *option = (SOCKET_TUNING_OPTION)i;
+            result = 0;
+            break;
+        }
+    }
+
+    return result;
+}
+
+static int apply_tuning_option(int socket, SOCKET_TUNING_OPTION option, int value)
+{
+    int result;
+
+    switch (option)
+    {
+    case SOCKET_TUNING_TCP_NODELAY:
+        result = setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &value, sizeof(value));
+        break;
+    case SOCKET_TUNING_TCP_QUICKACK:
+#ifdef TCP_QUICKACK
+        result = setsockopt(socket, IPPROTO_TCP, TCP_QUICKACK, &value, sizeof(value));
+#else
+        errno = ENOPROTOOPT;
+        result = -1;
+#endif
+        break;
+    case SOCKET_TUNING_SO_SNDBUF:
+        result = setsockopt(socket, SOL_SOCKET, SO_SNDBUF, &value, sizeof(value));
+        break;
+    case SOCKET_TUNING_SO_RCVBUF:
+        result = setsockopt(socket, SOL_SOCKET, SO_RCVBUF, &value, sizeof(value));
+        break;
+    case SOCKET_TUNING_TCP_FASTOPEN:
+        /* a client asks for fast open on the socket it connects with, connect then completes
+           at once and the SYN leaves with the first bytes sent */
+#ifdef TCP_FASTOPEN_CONNECT
+        result = setsockopt(socket, IPPROTO_TCP, TCP_FASTOPEN_CONNECT, &value, sizeof(value));
+#else
+        errno = ENOPROTOOPT;
+        result = -1;
+#endif
+        break;
+    case SOCKET_TUNING_SO_BUSY_POLL:
+#ifdef SO_BUSY_POLL
+        result = setsockopt(socket, SOL_SOCKET, SO_BUSY_POLL, &value, sizeof(value));
+#else
+        errno = ENOPROTOOPT;
+        result = -1;
+#endif
+        break;
+    default:
+        errno = EINVAL;
+        result = -1;
+        break;
+    }
+
+    if (result != 0)
+    {
+        LogError("Failure: setting option %s to %d failed, errno=%d.", get_tuning_option_name(option), value, errno);
+        result = __FAILURE__;
+    }
+
+    return result;
+}
+
+static int apply_tuning_options(SOCKET_IO_INSTANCE* socket_io_instance, int socket)
+{
+    int result = 0;
+    int i;
+
+    for (i = 0; i < (int)SOCKET_TUNING_OPTION_COUNT; i++)
+    {
+        if (((socket_io_instance->tuning_options_set & (1u << i)) != 0) &&
+            (apply_tuning_option(socket, (SOCKET_TUNING_OPTION)i, socket_io_instance->tuning_values[i]) != 0))
+        {
+            result = __FAILURE__;
+            break;
+        }
+    }
+
+    return result;
+}
+
 /*this function will clone an option given by name and value*/
 static void* socketio_CloneOption(const char* name, const void* value)
 {
     void* result;
+    SOCKET_TUNING_OPTION tuning_option;
 
     if (name != NULL)
     {
@@ -129,6 +429,59 @@ static void* socketio_CloneOption(const char* name, const void* value)
                 }
             }
         }
+        else if (strcmp(name, OPTION_SOCKET_REACTOR) == 0)
+        {
+            /* the reactor is not owned by the socket, the handle is shared as is */
+            result = (void*)value;
+        }
+        else if ((strcmp(name, OPTION_SOCKETIO_RECEIVE_SIZE) == 0) ||
+            (strcmp(name, OPTION_SOCKETIO_RECEIVE_DRAIN_LIMIT) == 0) ||
+            (strcmp(name, OPTION_SOCKETIO_ZEROCOPY_THRESHOLD) == 0))
+        {
+            if (value == NULL)
+            {
+                LogError("Failed cloning option %s (value is NULL)", name);
+            }
+            else if ((result = malloc(sizeof(size_t))) == NULL)
+            {
+                LogError("Failed cloning option %s (malloc failed)", name);
+            }
+            else
+            {
+                *(size_t*)result = *(const size_t*)value;
+            }
+        }
+        else if ((strcmp(name, OPTION_SOCKETIO_ADAPTIVE_RECEIVE) == 0) ||
+            (strcmp(name, OPTION_SOCKETIO_SHARED_RECEIVE_BUFFER) == 0))
+        {
+            if (value == NULL)
+            {
+                LogError("Failed cloning option %s (value is NULL)", name);
+            }
+            else if ((result = malloc(sizeof(bool))) == NULL)
+            {
+                LogError("Failed cloning option %s (malloc failed)", name);
+            }
+            else
+            {
+                *(bool*)result = *(const bool*)value;
+            }
+        }
+        else if (get_tuning_option(name, &tuning_option) == 0)
+        {
+            if (value == NULL)
+            {
+                LogError("Failed cloning option %s (value is NULL)", name);
+            }
+            else if ((result = malloc(sizeof(int))) == NULL)
+            {
+                LogError("Failed cloning option %s (malloc failed)", name);
+            }
+            else
+            {
+                *(int*)result = *(const int*)value;
+            }
+        }
         else
         {
             LogError("Cannot clone option %s (not suppported)", name);
@@ -146,7 +499,16 @@ static void socketio_DestroyOption(const char* name, const void* value)
 {
     if (name != NULL)
     {
-        if (strcmp(name, OPTION_NET_INT_MAC_ADDRESS) == 0 && value != NULL)
+        SOCKET_TUNING_OPTION tuning_option;
+
+        if ((strcmp(name, OPTION_NET_INT_MAC_ADDRESS) == 0 ||
+            strcmp(name, OPTION_SOCKETIO_RECEIVE_SIZE) == 0 ||
+            strcmp(name, OPTION_SOCKETIO_ADAPTIVE_RECEIVE) == 0 ||
+            strcmp(name, OPTION_SOCKETIO_SHARED_RECEIVE_BUFFER) == 0 ||
+            strcmp(name, OPTION_SOCKETIO_RECEIVE_DRAIN_LIMIT) == 0 ||
+            strcmp(name, OPTION_SOCKETIO_ZEROCOPY_THRESHOLD) == 0 ||
+            get_tuning_option(name, &tuning_option) == 0) &&
+            value != NULL)
         {
             free((void*)value);
         }
@@ -178,11 +540,75 @@ static OPTIONHANDLER_HANDLE socketio_retrieveoptions(CONCRETE_IO_HANDLE handle)
             OptionHandler_Destroy(result);
             result = NULL;
         }
+        else if (socket_io_instance->socket_reactor != NULL &&
+            OptionHandler_AddOption(result, OPTION_SOCKET_REACTOR, socket_io_instance->socket_reactor) != OPTIONHANDLER_OK)
+        {
+            LogError("failed retrieving options (failed adding socket_reactor)");
+            OptionHandler_Destroy(result);
+            result = NULL;
+        }
+        else if (socket_io_instance->receive_size != RECEIVE_BYTES_VALUE &&
+            OptionHandler_AddOption(result, OPTION_SOCKETIO_RECEIVE_SIZE, &socket_io_instance->receive_size) != OPTIONHANDLER_OK)
+        {
+            LogError("failed retrieving options (failed adding socketio_receive_size)");
+            OptionHandler_Destroy(result);
+            result = NULL;
+        }
+        else if (socket_io_instance->adaptive_receive &&
+            OptionHandler_AddOption(result, OPTION_SOCKETIO_ADAPTIVE_RECEIVE, &socket_io_instance->adaptive_receive) != OPTIONHANDLER_OK)
+        {
+            LogError("failed retrieving options (failed adding socketio_adaptive_receive)");
+            OptionHandler_Destroy(result);
+            result = NULL;
+        }
+        else if (socket_io_instance->shared_receive_buffer &&
+            OptionHandler_AddOption(result, OPTION_SOCKETIO_SHARED_RECEIVE_BUFFER, &socket_io_instance->shared_receive_buffer) != OPTIONHANDLER_OK)
+        {
+            LogError("failed retrieving options (failed adding socketio_shared_receive_buffer)");
+            OptionHandler_Destroy(result);
+            result = NULL;
+        }
+        else if (socket_io_instance->receive_drain_limit != 0 &&
+            OptionHandler_AddOption(result, OPTION_SOCKETIO_RECEIVE_DRAIN_LIMIT, &socket_io_instance->receive_drain_limit) != OPTIONHANDLER_OK)
+        {
+            LogError("failed retrieving options (failed adding socketio_receive_drain_limit)");
+            OptionHandler_Destroy(result);
+            result = NULL;
+        }
+        else if (socket_io_instance->zerocopy_threshold != 0 &&
+            OptionHandler_AddOption(result, OPTION_SOCKETIO_ZEROCOPY_THRESHOLD, &socket_io_instance->zerocopy_threshold) != OPTIONHANDLER_OK)
+        {
+            LogError("failed retrieving options (failed adding socketio_zerocopy_threshold)");
+            OptionHandler_Destroy(result);
+            result = NULL;
+        }
+        else
+        {
+            int i;
+
+            for (i = 0; i < (int)SOCKET_TUNING_OPTION_COUNT; i++)
+            {
+                if (((socket_io_instance->tuning_options_set & (1u << i)) != 0) &&
+                    OptionHandler_AddOption(result, get_tuning_option_name((SOCKET_TUNING_OPTION)i), &socket_io_instance->tuning_values[i]) != OPTIONHANDLER_OK)
+                {
+                    LogError("failed retrieving options (failed adding %s)", get_tuning_option_name((SOCKET_TUNING_OPTION)i));
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                    break;
+                }
+            }
+        }
     }
 
     return result;
 }
 
+static int socketio_sendv(CONCRETE_IO_HANDLE socket_io, const XIO_BUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* callback_context);
+static int socketio_get_stats(CONCRETE_IO_HANDLE socket_io, XIO_STATS* stats, size_t stats_count, size_t* layer_count);
+static int socketio_dowork_ex(CONCRETE_IO_HANDLE socket_io, bool* made_progress, uint64_t* next_deadline_us);
+static int socketio_get_pollable_handle(CONCRETE_IO_HANDLE socket_io, intptr_t* pollable_handle, unsigned int* wanted_events);
+static int socketio_set_receive_buffer(CONCRETE_IO_HANDLE socket_io, unsigned char* buffer, size_t size);
+
 static const IO_INTERFACE_DESCRIPTION socket_io_interface_description =
 {
     socketio_retrieveoptions,
@@ -192,7 +618,13 @@ static const IO_INTERFACE_DESCRIPTION socket_io_interface_description =
     socketio_close,
     socketio_send,
     socketio_dowork,
-    socketio_setoption
+    socketio_setoption,
+    socketio_sendv,
+    socketio_send_constbuffer_array,
+    socketio_get_stats,
+    socketio_dowork_ex,
+    socketio_get_pollable_handle,
+    socketio_set_receive_buffer
 };
 
 static void indicate_error(SOCKET_IO_INSTANCE* socket_io_instance)
@@ -204,184 +636,219 @@ static void indicate_error(SOCKET_IO_INSTANCE* socket_io_instance)
     }
 }
 
-static int add_pending_io(SOCKET_IO_INSTANCE* socket_io_instance, const unsigned char* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+static void indicate_open_complete(SOCKET_IO_INSTANCE* socket_io_instance, IO_OPEN_RESULT open_result)
 {
-    int result;
-    PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)malloc(sizeof(PENDING_SOCKET_IO));
-    if (pending_socket_io == NULL)
+    ON_IO_OPEN_COMPLETE on_io_open_complete = socket_io_instance->on_io_open_complete;
+
+    socket_io_instance->on_io_open_complete = NULL;
+    if (on_io_open_complete != NULL)
     {
-        result = __FAILURE__;
+        on_io_open_complete(socket_io_instance->on_io_open_complete_context, open_result);
     }
-    else
+}
+
+static void on_socket_reactor_event(void* context, unsigned int events)
+{
+    SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)context;
+
+    if ((events & SOCKET_REACTOR_EVENT_ERROR) != 0)
     {
-        pending_socket_io->bytes = (unsigned char*)malloc(size);
-        if (pending_socket_io->bytes == NULL)
-        {
-            LogError("Allocation Failure: Unable to allocate pending list.");
-            free(pending_socket_io);
-            result = __FAILURE__;
-        }
-        else
-        {
-            pending_socket_io->size = size;
-            pending_socket_io->on_send_complete = on_send_complete;
-            pending_socket_io->callback_context = callback_context;
-            pending_socket_io->pending_io_list = socket_io_instance->pending_io_list;
-            (void)memcpy(pending_socket_io->bytes, buffer, size);
+        /* let recv surface the error or the orderly shutdown */
+        events |= SOCKET_REACTOR_EVENT_READABLE;
+    }
 
-            if (singlylinkedlist_add(socket_io_instance->pending_io_list, pending_socket_io) == NULL)
-            {
-                LogError("Failure: Unable to add socket to pending list.");
-                free(pending_socket_io->bytes);
-                free(pending_socket_io);
-                result = __FAILURE__;
-            }
-            else
-            {
-                result = 0;
-            }
-        }
+    (void)__sync_fetch_and_or(&socket_io_instance->ready_events, events);
+}
+
+static unsigned int take_ready_events(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    unsigned int result;
+
+    if (socket_io_instance->socket_reactor == NULL)
+    {
+        /* without a reactor every dowork polls the socket */
+        result = SOCKET_REACTOR_EVENT_READABLE | SOCKET_REACTOR_EVENT_WRITABLE;
     }
+    else
+    {
+        /* clearing before doing the IO makes sure an edge arriving meanwhile is not lost */
+        result = __sync_fetch_and_and(&socket_io_instance->ready_events, 0);
+    }
+
     return result;
 }
 
-static STATIC_VAR_UNUSED void signal_callback(int signum)
+static void restore_ready_events(SOCKET_IO_INSTANCE* socket_io_instance, unsigned int events)
 {
-    AZURE_UNREFERENCED_PARAMETER(signum);
-    LogError("Socket received signal %d.", signum);
+    if (socket_io_instance->socket_reactor != NULL)
+    {
+        (void)__sync_fetch_and_or(&socket_io_instance->ready_events, events);
+    }
 }
 
-static int lookup_address_and_initiate_socket_connection(SOCKET_IO_INSTANCE* socket_io_instance)
+static int register_with_socket_reactor(SOCKET_IO_INSTANCE* socket_io_instance)
 {
     int result;
-    int err;
-
-    struct addrinfo addrInfoHintIp;
-    struct sockaddr_un addrInfoUn;
-    struct sockaddr* connect_addr = NULL;
-    socklen_t connect_addr_len;
-    struct addrinfo* addrInfoIp = NULL;
 
-    if (socket_io_instance->address_type == ADDRESS_TYPE_IP)
+    if (socket_io_instance->socket_reactor == NULL)
     {
-        char portString[16];
-
-        memset(&addrInfoHintIp, 0, sizeof(addrInfoHintIp));
-        addrInfoHintIp.ai_family = AF_INET;
-        addrInfoHintIp.ai_socktype = SOCK_STREAM;
+        result = 0;
+    }
+    else
+    {
+        /* a freshly connected socket is assumed ready, the first dowork will find out */
+        socket_io_instance->ready_events = SOCKET_REACTOR_EVENT_READABLE | SOCKET_REACTOR_EVENT_WRITABLE;
+        __sync_synchronize();
 
-        sprintf(portString, "%u", socket_io_instance->port);
-        err = getaddrinfo(socket_io_instance->hostname, portString, &addrInfoHintIp, &addrInfoIp);
-        if (err != 0)
+        if (socket_reactor_register(socket_io_instance->socket_reactor, socket_io_instance->socket, on_socket_reactor_event, socket_io_instance) != 0)
         {
-            LogError("Failure: getaddrinfo failure %d.", err);
+            LogError("Failure: socket_reactor_register failed.");
             result = __FAILURE__;
         }
         else
         {
-            connect_addr = addrInfoIp->ai_addr;
-            connect_addr_len = sizeof(*addrInfoIp->ai_addr);
             result = 0;
         }
     }
-    else
+
+    return result;
+}
+
+static void unregister_from_socket_reactor(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    if ((socket_io_instance->socket_reactor != NULL) &&
+        (socket_io_instance->socket != INVALID_SOCKET) &&
+        ((socket_io_instance->io_state == IO_STATE_OPEN) || (socket_io_instance->io_state == IO_STATE_ERROR)))
     {
-        size_t hostname_len = strlen(socket_io_instance->hostname);
-        if (hostname_len + 1 > sizeof(addrInfoUn.sun_path))
+        if (socket_reactor_unregister(socket_io_instance->socket_reactor, socket_io_instance->socket) != 0)
         {
-            LogError("Hostname %s is too long for a unix socket (max len = %lu)", socket_io_instance->hostname, (unsigned long)sizeof(addrInfoUn.sun_path));
-            result = __FAILURE__;
-        }
-        else
-        {
-            memset(&addrInfoUn, 0, sizeof(addrInfoUn));
-            addrInfoUn.sun_family = AF_UNIX;
-            // No need to add NULL terminator due to the above memset
-            (void)memcpy(addrInfoUn.sun_path, socket_io_instance->hostname, hostname_len);
-
-            connect_addr = (struct sockaddr*)&addrInfoUn;
-            connect_addr_len = sizeof(addrInfoUn);
-            result = 0;
+            LogError("Failure: socket_reactor_unregister failed.");
         }
     }
+}
+
+/* makes room for entry_count more pending sends */
+static int ensure_pending_io_capacity(SOCKET_IO_INSTANCE* socket_io_instance, size_t entry_count)
+{
+    int result;
 
-    if (result == 0)
+    if (entry_count <= socket_io_instance->pending_io_capacity - socket_io_instance->pending_io_count)
     {
-        int flags;
+        result = 0;
+    }
+    else if (entry_count > (SIZE_MAX / sizeof(PENDING_SOCKET_IO)) - socket_io_instance->pending_io_count)
+    {
+        LogError("Failure: too many pending sends.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t new_capacity = socket_io_instance->pending_io_capacity * 2;
+        PENDING_SOCKET_IO* new_pending_ios;
 
-        if ((-1 == (flags = fcntl(socket_io_instance->socket, F_GETFL, 0))) ||
-            (fcntl(socket_io_instance->socket, F_SETFL, flags | O_NONBLOCK) == -1))
+        if (new_capacity < socket_io_instance->pending_io_count + entry_count)
         {
-            LogError("Failure: fcntl failure.");
+            new_capacity = socket_io_instance->pending_io_count + entry_count;
+        }
+
+        new_pending_ios = (PENDING_SOCKET_IO*)malloc(new_capacity * sizeof(PENDING_SOCKET_IO));
+        if (new_pending_ios == NULL)
+        {
+            LogError("Allocation Failure: Unable to grow pending queue to %lu entries.", (unsigned long)new_capacity);
             result = __FAILURE__;
         }
         else
         {
-            err = connect(socket_io_instance->socket, connect_addr, connect_addr_len);
-            if ((err != 0) && (errno != EINPROGRESS))
+            /* unwrap the ring so that the oldest entry ends up first */
+            size_t i;
+            for (i = 0; i < socket_io_instance->pending_io_count; i++)
             {
-                LogError("Failure: connect failure %d.", errno);
-                result = __FAILURE__;
+                new_pending_ios[i] = socket_io_instance->pending_ios[(socket_io_instance->pending_io_head + i) % socket_io_instance->pending_io_capacity];
             }
-        }
-    }
 
-    if (addrInfoIp != NULL)
-    {
-        freeaddrinfo(addrInfoIp);
+            free(socket_io_instance->pending_ios);
+            socket_io_instance->pending_ios = new_pending_ios;
+            socket_io_instance->pending_io_capacity = new_capacity;
+            socket_io_instance->pending_io_head = 0;
+            result = 0;
+        }
     }
 
     return result;
 }
 
-static int wait_for_connection(SOCKET_IO_INSTANCE* socket_io_instance)
+/* tells whether a buffer of size bytes is sent with MSG_ZEROCOPY, asking for SO_ZEROCOPY on the socket the first time */
+static bool use_zerocopy(SOCKET_IO_INSTANCE* socket_io_instance, size_t size)
 {
-    int result;
-    int err;
-    int retval;
-    int select_errno = 0;
-
-    fd_set fdset;
-    struct timeval tv;
-
-    FD_ZERO(&fdset);
-    FD_SET(socket_io_instance->socket, &fdset);
-    tv.tv_sec = CONNECT_TIMEOUT;
-    tv.tv_usec = 0;
-
-    do
-    {
-        retval = select(socket_io_instance->socket + 1, NULL, &fdset, NULL, &tv);
-
-        if (retval < 0)
-        {
-            select_errno = errno;
-        }
-    } while (retval < 0 && select_errno == EINTR);
+    bool result;
 
-    if (retval != 1)
+    if ((socket_io_instance->zerocopy_threshold == 0) ||
+        (size < socket_io_instance->zerocopy_threshold) ||
+        (socket_io_instance->socket == INVALID_SOCKET))
     {
-        LogError("Failure: select failure.");
-        result = __FAILURE__;
+        result = false;
     }
     else
     {
-        int so_error = 0;
-        socklen_t len = sizeof(so_error);
-        err = getsockopt(socket_io_instance->socket, SOL_SOCKET, SO_ERROR, &so_error, &len);
-        if (err != 0)
+#ifdef SOCKETIO_HAS_ZEROCOPY
+        if (socket_io_instance->zerocopy_state == SOCKETIO_ZEROCOPY_UNKNOWN)
         {
-            LogError("Failure: getsockopt failure %d.", errno);
+            int enable = 1;
+
+            if (setsockopt(socket_io_instance->socket, SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(enable)) != 0)
+            {
+                // older kernels and Unix domain sockets do not have it, their sends are copied as usual
+                LogInfo("SO_ZEROCOPY is not available on the socket, errno=%d, sending copies.", errno);
+                socket_io_instance->zerocopy_state = SOCKETIO_ZEROCOPY_OFF;
+            }
+            else
+            {
+                socket_io_instance->zerocopy_state = SOCKETIO_ZEROCOPY_ON;
+            }
+        }
+#endif
+        result = (socket_io_instance->zerocopy_state == SOCKETIO_ZEROCOPY_ON);
+    }
+
+    return result;
+}
+
+/* makes room for one more zero copy send waiting for the kernel */
+static int ensure_zerocopy_send_capacity(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    int result;
+
+    if (socket_io_instance->zerocopy_send_count < socket_io_instance->zerocopy_send_capacity)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t new_capacity = (socket_io_instance->zerocopy_send_capacity == 0) ? SOCKETIO_ZEROCOPY_SEND_INITIAL_CAPACITY : socket_io_instance->zerocopy_send_capacity * 2;
+        ZEROCOPY_SEND* new_zerocopy_sends;
+
+        if ((new_capacity < socket_io_instance->zerocopy_send_capacity) || (new_capacity > SIZE_MAX / sizeof(ZEROCOPY_SEND)))
+        {
+            LogError("Failure: too many zero copy sends.");
             result = __FAILURE__;
         }
-        else if (so_error != 0)
+        else if ((new_zerocopy_sends = (ZEROCOPY_SEND*)malloc(new_capacity * sizeof(ZEROCOPY_SEND))) == NULL)
         {
-            err = so_error;
-            LogError("Failure: connect failure %d.", so_error);
+            LogError("Allocation Failure: Unable to grow zero copy sends to %lu entries.", (unsigned long)new_capacity);
             result = __FAILURE__;
         }
         else
         {
+            size_t i;
+            for (i = 0; i < socket_io_instance->zerocopy_send_count; i++)
+            {
+                new_zerocopy_sends[i] = socket_io_instance->zerocopy_sends[(socket_io_instance->zerocopy_send_head + i) % socket_io_instance->zerocopy_send_capacity];
+            }
+
+            free(socket_io_instance->zerocopy_sends);
+            socket_io_instance->zerocopy_sends = new_zerocopy_sends;
+            socket_io_instance->zerocopy_send_capacity = new_capacity;
+            socket_io_instance->zerocopy_send_head = 0;
             result = 0;
         }
     }
@@ -389,619 +856,2513 @@ static int wait_for_connection(SOCKET_IO_INSTANCE* socket_io_instance)
     return result;
 }
 
+static int push_zerocopy_send(SOCKET_IO_INSTANCE* socket_io_instance, CONSTBUFFER_HANDLE buffer_handle, uint32_t last_id, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    if (ensure_zerocopy_send_capacity(socket_io_instance) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        ZEROCOPY_SEND* zerocopy_send = &socket_io_instance->zerocopy_sends[(socket_io_instance->zerocopy_send_head + socket_io_instance->zerocopy_send_count) % socket_io_instance->zerocopy_send_capacity];
+        zerocopy_send->buffer_handle = buffer_handle;
+        zerocopy_send->last_id = last_id;
+        zerocopy_send->on_send_complete = on_send_complete;
+        zerocopy_send->callback_context = callback_context;
+        socket_io_instance->zerocopy_send_count++;
+        result = 0;
+    }
 
+    return result;
+}
 
-#ifndef __APPLE__
-static void destroy_network_interface_descriptions(NETWORK_INTERFACE_DESCRIPTION* nid)
+/* takes the oldest zero copy send off the list, handing out its callback */
+static void pop_zerocopy_send(SOCKET_IO_INSTANCE* socket_io_instance, ON_SEND_COMPLETE* on_send_complete, void** callback_context)
 {
-    if (nid != NULL)
+    ZEROCOPY_SEND* zerocopy_send = &socket_io_instance->zerocopy_sends[socket_io_instance->zerocopy_send_head];
+
+    *on_send_complete = zerocopy_send->on_send_complete;
+    *callback_context = zerocopy_send->callback_context;
+    if (zerocopy_send->buffer_handle != NULL)
     {
-        if (nid->next != NULL)
+        CONSTBUFFER_DecRef(zerocopy_send->buffer_handle);
+    }
+
+    socket_io_instance->zerocopy_send_head = (socket_io_instance->zerocopy_send_head + 1) % socket_io_instance->zerocopy_send_capacity;
+    socket_io_instance->zerocopy_send_count--;
+}
+
+/* ids wrap around, a is before b when it is less than half the id space behind */
+static bool is_zerocopy_id_before(uint32_t a, uint32_t b)
+{
+    return (int32_t)(a - b) < 0;
+}
+
+/* completes the zero copy sends whose pages the kernel released, in order */
+static void complete_zerocopy_sends(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    while ((socket_io_instance->zerocopy_send_count > 0) &&
+        is_zerocopy_id_before(socket_io_instance->zerocopy_sends[socket_io_instance->zerocopy_send_head].last_id, socket_io_instance->zerocopy_completed_id))
+    {
+        /* the entry is released first, the callback is free to send again */
+        ON_SEND_COMPLETE on_send_complete;
+        void* callback_context;
+
+        pop_zerocopy_send(socket_io_instance, &on_send_complete, &callback_context);
+        if (on_send_complete != NULL)
         {
-            destroy_network_interface_descriptions(nid->next);
+            socket_io_instance->stats.callback_count++;
+            on_send_complete(callback_context, IO_SEND_OK);
         }
+    }
+}
 
-        if (nid->name != NULL)
+/* the sends still waiting for the kernel when the socket goes away are cancelled, their notifications will not come */
+static void cancel_zerocopy_sends(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    size_t i;
+
+    while (socket_io_instance->zerocopy_send_count > 0)
+    {
+        ON_SEND_COMPLETE on_send_complete;
+        void* callback_context;
+
+        pop_zerocopy_send(socket_io_instance, &on_send_complete, &callback_context);
+        if (on_send_complete != NULL)
         {
-            free(nid->name);
+            socket_io_instance->stats.callback_count++;
+            on_send_complete(callback_context, IO_SEND_CANCELLED);
         }
+    }
 
-        if (nid->mac_address != NULL)
+    /* a queued send partly taken by the old socket carries an id of that socket */
+    for (i = 0; i < socket_io_instance->pending_io_count; i++)
+    {
+        socket_io_instance->pending_ios[(socket_io_instance->pending_io_head + i) % socket_io_instance->pending_io_capacity].zerocopy_sent = false;
+    }
+
+    socket_io_instance->zerocopy_state = SOCKETIO_ZEROCOPY_UNKNOWN;
+    socket_io_instance->zerocopy_next_id = 0;
+    socket_io_instance->zerocopy_completed_id = 0;
+}
+
+/* reads the notifications the kernel queues on the error queue of the socket as it releases the pages of zero copy sends */
+static void receive_zerocopy_notifications(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+#ifdef SOCKETIO_HAS_ZEROCOPY
+    bool drained = false;
+
+    while (!drained)
+    {
+        unsigned char control[CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))];
+        struct msghdr msg;
+        struct cmsghdr* cmsg;
+
+        (void)memset(&msg, 0, sizeof(msg));
+        msg.msg_control = control;
+        msg.msg_controllen = sizeof(control);
+
+        if (recvmsg(socket_io_instance->socket, &msg, MSG_ERRQUEUE) < 0)
         {
-            free(nid->mac_address);
+            if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+            {
+                LogError("Failure: reading the socket error queue failed. errno=%d (%s).", errno, strerror(errno));
+            }
+            drained = true;
         }
-
-        if (nid->ip_address != NULL)
+        else
         {
-            free(nid->ip_address);
+            for (cmsg = CMSG_FIRSTHDR(&msg); cmsg != NULL; cmsg = CMSG_NXTHDR(&msg, cmsg))
+            {
+                if (((cmsg->cmsg_level == IPPROTO_IP) && (cmsg->cmsg_type == IP_RECVERR)) ||
+                    ((cmsg->cmsg_level == IPPROTO_IPV6) && (cmsg->cmsg_type == IPV6_RECVERR)))
+                {
+                    const struct sock_extended_err* extended_err = (const struct sock_extended_err*)CMSG_DATA(cmsg);
+
+                    if ((extended_err->ee_errno == 0) && (extended_err->ee_origin == SO_EE_ORIGIN_ZEROCOPY))
+                    {
+                        /* the ids from ee_info to ee_data are released; TCP releases its sends in order */
+                        if (!is_zerocopy_id_before(extended_err->ee_data, socket_io_instance->zerocopy_completed_id))
+                        {
+                            socket_io_instance->zerocopy_completed_id = extended_err->ee_data + 1;
+                        }
+
+                        if ((extended_err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED) != 0)
+                        {
+                            // the kernel copied the bytes after all (loopback, or a device without scatter-gather),
+                            // pinning the pages only costs on this route
+                            socket_io_instance->zerocopy_state = SOCKETIO_ZEROCOPY_OFF;
+                        }
+                    }
+                }
+            }
         }
+    }
+#endif
 
-        free(nid);
+    complete_zerocopy_sends(socket_io_instance);
+}
+
+static int push_pending_io(SOCKET_IO_INSTANCE* socket_io_instance, CONSTBUFFER_HANDLE buffer_handle, unsigned char* bytes, const unsigned char* data, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    if (ensure_pending_io_capacity(socket_io_instance, 1) != 0)
+    {
+        LogError("Failure: Unable to add socket to pending list.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        PENDING_SOCKET_IO* pending_socket_io = &socket_io_instance->pending_ios[(socket_io_instance->pending_io_head + socket_io_instance->pending_io_count) % socket_io_instance->pending_io_capacity];
+        pending_socket_io->buffer_handle = buffer_handle;
+        pending_socket_io->bytes = bytes;
+        pending_socket_io->data = data;
+        pending_socket_io->size = size;
+        pending_socket_io->on_send_complete = on_send_complete;
+        pending_socket_io->callback_context = callback_context;
+        /* only a buffer that is not released by the caller can be sent without a copy */
+        pending_socket_io->zerocopy = (buffer_handle != NULL) && use_zerocopy(socket_io_instance, size);
+        pending_socket_io->zerocopy_sent = false;
+        pending_socket_io->zerocopy_id = 0;
+        socket_io_instance->pending_io_count++;
+        socket_io_instance->stats.queued_send_count++;
+        result = 0;
     }
+
+    return result;
 }
 
-static NETWORK_INTERFACE_DESCRIPTION* create_network_interface_description(struct ifreq *ifr, NETWORK_INTERFACE_DESCRIPTION* previous_nid)
+static void count_send(SOCKET_IO_INSTANCE* socket_io_instance, size_t size)
 {
-    NETWORK_INTERFACE_DESCRIPTION* result;
+    socket_io_instance->stats.send_count++;
+    socket_io_instance->stats.bytes_sent += size;
+}
 
-    if ((result = (NETWORK_INTERFACE_DESCRIPTION*)malloc(sizeof(NETWORK_INTERFACE_DESCRIPTION))) == NULL)
+static void indicate_send_complete(SOCKET_IO_INSTANCE* socket_io_instance, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    if (on_send_complete != NULL)
     {
-        LogError("Failed allocating NETWORK_INTERFACE_DESCRIPTION");
+        /* sends complete in order, so one done after zero copy sends still in the kernel waits for them */
+        if ((socket_io_instance->zerocopy_send_count == 0) ||
+            (push_zerocopy_send(socket_io_instance, NULL, socket_io_instance->zerocopy_next_id - 1, on_send_complete, callback_context) != 0))
+        {
+            socket_io_instance->stats.callback_count++;
+            on_send_complete(callback_context, IO_SEND_OK);
+        }
     }
-    else if ((result->name = (char*)malloc(sizeof(char) * (strlen(ifr->ifr_name) + 1))) == NULL)
+}
+
+/* the socket calls are what XIO_STATS::time_us measures for this layer */
+static ssize_t send_bytes(SOCKET_IO_INSTANCE* socket_io_instance, const void* buffer, size_t size, int flags)
+{
+    ssize_t result;
+#ifdef XIO_STATS_TIMING
+    uint64_t start_time_us = xio_stats_get_time_us();
+#endif
+
+    result = send(socket_io_instance->socket, buffer, size, flags);
+
+#ifdef XIO_STATS_TIMING
+    socket_io_instance->stats.time_us += xio_stats_get_time_us() - start_time_us;
+#endif
+    return result;
+}
+
+static void free_thread_receive_buffer(void* value)
+{
+    THREAD_RECEIVE_BUFFER* buffer = (THREAD_RECEIVE_BUFFER*)value;
+
+    free(buffer->bytes);
+    free(buffer);
+}
+
+static void create_thread_receive_buffer_key(void)
+{
+    thread_receive_buffer_key_created = (pthread_key_create(&thread_receive_buffer_key, free_thread_receive_buffer) == 0);
+}
+
+// The buffer of the calling thread, grown to size bytes; it only grows, up to the largest read made
+// from the thread. NULL when it cannot be created or grown.
+static unsigned char* get_thread_receive_buffer(size_t size)
+{
+    unsigned char* result;
+
+    if (thread_receive_buffer == NULL)
     {
-        LogError("failed setting interface description name (malloc failed)");
-        destroy_network_interface_descriptions(result);
-        result = NULL;
+        THREAD_RECEIVE_BUFFER* buffer;
+
+        (void)pthread_once(&thread_receive_buffer_once, create_thread_receive_buffer_key);
+
+        if (!thread_receive_buffer_key_created)
+        {
+            LogError("Failure: pthread_key_create failed.");
+        }
+        else if ((buffer = (THREAD_RECEIVE_BUFFER*)malloc(sizeof(THREAD_RECEIVE_BUFFER))) == NULL)
+        {
+            LogError("Failure: unable to allocate the receive buffer of the thread.");
+        }
+        else
+        {
+            buffer->bytes = NULL;
+            buffer->capacity = 0;
+
+            /* the key only serves freeing the buffer when the thread exits */
+            if (pthread_setspecific(thread_receive_buffer_key, buffer) != 0)
+            {
+                LogError("Failure: pthread_setspecific failed.");
+                free(buffer);
+            }
+            else
+            {
+                thread_receive_buffer = buffer;
+            }
+        }
     }
-    else if (strcpy(result->name, ifr->ifr_name) == NULL)
+
+    if (thread_receive_buffer == NULL)
     {
-        LogError("failed setting interface description name (strcpy failed)");
-        destroy_network_interface_descriptions(result);
         result = NULL;
     }
+    else if (size <= thread_receive_buffer->capacity)
+    {
+        result = thread_receive_buffer->bytes;
+    }
     else
     {
-        char* ip_address;
-        unsigned char* mac = (unsigned char*)ifr->ifr_hwaddr.sa_data;
-
-        if ((result->mac_address = (char*)malloc(sizeof(char) * MAC_ADDRESS_STRING_LENGTH)) == NULL)
+        unsigned char* new_bytes = (unsigned char*)realloc(thread_receive_buffer->bytes, size);
+        if (new_bytes == NULL)
         {
-            LogError("failed formatting mac address (malloc failed)");
-            destroy_network_interface_descriptions(result);
+            LogError("Failure: unable to grow the receive buffer of the thread to %lu bytes.", (unsigned long)size);
             result = NULL;
         }
-        else if (sprintf(result->mac_address, "%02X:%02X:%02X:%02X:%02X:%02X", mac[0],mac[1],mac[2],mac[3],mac[4],mac[5]) <= 0)
+        else
         {
-            LogError("failed formatting mac address (sprintf failed)");
-            destroy_network_interface_descriptions(result);
-            result = NULL;
+            thread_receive_buffer->bytes = new_bytes;
+            thread_receive_buffer->capacity = size;
+            result = new_bytes;
         }
-        else if ((ip_address = inet_ntoa(((struct sockaddr_in*)&ifr->ifr_addr)->sin_addr)) == NULL)
+    }
+
+    return result;
+}
+
+// Picks the buffer of the next read: socketio_receive_size bytes, or with socketio_adaptive_receive
+// what is queued on the socket, bounded by RECEIVE_BYTES_VALUE and socketio_receive_size.
+static unsigned char* get_receive_buffer(SOCKET_IO_INSTANCE* socket_io_instance, size_t* read_size)
+{
+    unsigned char* result;
+    size_t size = socket_io_instance->receive_size;
+
+    if (socket_io_instance->adaptive_receive)
+    {
+        int queued;
+
+        if (ioctl(socket_io_instance->socket, FIONREAD, &queued) == 0 && queued >= 0 && (size_t)queued < size)
         {
-            LogError("failed setting the ip address (inet_ntoa failed)");
-            destroy_network_interface_descriptions(result);
-            result = NULL;
+            size = ((size_t)queued < RECEIVE_BYTES_VALUE) ? RECEIVE_BYTES_VALUE : (size_t)queued;
         }
-        else if ((result->ip_address = (char*)malloc(sizeof(char) * (strlen(ip_address) + 1))) == NULL)
+    }
+
+    if (size < RECEIVE_BYTES_VALUE)
+    {
+        size = RECEIVE_BYTES_VALUE;
+    }
+
+    if (socket_io_instance->shared_receive_buffer)
+    {
+        /* the bytes of the previous read have been indicated already, the own buffer is not needed anymore */
+        free(socket_io_instance->large_recv_bytes);
+        socket_io_instance->large_recv_bytes = NULL;
+        socket_io_instance->large_recv_capacity = 0;
+
+        if ((result = get_thread_receive_buffer(size)) != NULL)
         {
-            LogError("failed setting the ip address (malloc failed)");
-            destroy_network_interface_descriptions(result);
-            result = NULL;
+            *read_size = size;
         }
-        else if (strcpy(result->ip_address, ip_address) == NULL)
+        else
         {
-            LogError("failed setting the ip address (strcpy failed)");
-            destroy_network_interface_descriptions(result);
-            result = NULL;
+            result = socket_io_instance->recv_bytes;
+            *read_size = RECEIVE_BYTES_VALUE;
+        }
+    }
+    else if (size == RECEIVE_BYTES_VALUE)
+    {
+        result = socket_io_instance->recv_bytes;
+        *read_size = RECEIVE_BYTES_VALUE;
+    }
+    else if (size <= socket_io_instance->large_recv_capacity)
+    {
+        result = socket_io_instance->large_recv_bytes;
+        *read_size = size;
+    }
+    else
+    {
+        /* the buffer only grows, when a resize fails the small buffer is used for this read */
+        unsigned char* new_buffer = (unsigned char*)realloc(socket_io_instance->large_recv_bytes, size);
+        if (new_buffer == NULL)
+        {
+            LogError("Failure: unable to grow the receive buffer to %lu bytes.", (unsigned long)size);
+            result = socket_io_instance->recv_bytes;
+            *read_size = RECEIVE_BYTES_VALUE;
         }
         else
         {
-            result->next = NULL;
-
-            if (previous_nid != NULL)
-            {
-                previous_nid->next = result;
-            }
+            socket_io_instance->large_recv_bytes = new_buffer;
+            socket_io_instance->large_recv_capacity = size;
+            result = new_buffer;
+            *read_size = size;
         }
     }
 
     return result;
 }
 
-static int get_network_interface_descriptions(int socket, NETWORK_INTERFACE_DESCRIPTION** nid)
+static ssize_t receive_bytes(SOCKET_IO_INSTANCE* socket_io_instance, unsigned char** bytes)
 {
-    int result;
-
-    struct ifreq ifr;
-    struct ifconf ifc;
-    char buf[IFREQ_BUFFER_SIZE];
-
-    ifc.ifc_len = sizeof(buf);
-    ifc.ifc_buf = buf;
+    ssize_t result;
+    size_t read_size;
+#ifdef XIO_STATS_TIMING
+    uint64_t start_time_us = xio_stats_get_time_us();
+#endif
 
-    if (ioctl(socket, SIOCGIFCONF, &ifc) == -1)
+    if (socket_io_instance->lent_recv_bytes != NULL)
     {
-        LogError("ioctl failed querying socket (SIOCGIFCONF, errno=%d)", errno);
-        result = __FAILURE__;
+        *bytes = socket_io_instance->lent_recv_bytes;
+        read_size = socket_io_instance->lent_recv_size;
     }
     else
     {
-        NETWORK_INTERFACE_DESCRIPTION* root_nid = NULL;
-        NETWORK_INTERFACE_DESCRIPTION* new_nid = NULL;
+        *bytes = get_receive_buffer(socket_io_instance, &read_size);
+    }
+    result = recv(socket_io_instance->socket, *bytes, read_size, 0);
 
-        struct ifreq* it = ifc.ifc_req;
-        const struct ifreq* const end = it + (ifc.ifc_len / sizeof(struct ifreq));
+    if ((result > 0) && (*bytes == socket_io_instance->lent_recv_bytes))
+    {
+        /* lent for one read only, the layer above lends it again once it took the bytes */
+        socket_io_instance->lent_recv_bytes = NULL;
+        socket_io_instance->lent_recv_size = 0;
+    }
 
-        result = 0;
+#ifdef TCP_QUICKACK
+    /* the stack leaves quick ack mode on its own, it is turned on again after each read */
+    if ((result > 0) &&
+        ((socket_io_instance->tuning_options_set & (1u << SOCKET_TUNING_TCP_QUICKACK)) != 0) &&
+        (socket_io_instance->tuning_values[SOCKET_TUNING_TCP_QUICKACK] != 0))
+    {
+        (void)setsockopt(socket_io_instance->socket, IPPROTO_TCP, TCP_QUICKACK, &socket_io_instance->tuning_values[SOCKET_TUNING_TCP_QUICKACK], sizeof(int));
+    }
+#endif
 
-        for (; it != end; ++it)
-        {
-            strcpy(ifr.ifr_name, it->ifr_name);
+#ifdef XIO_STATS_TIMING
+    socket_io_instance->stats.time_us += xio_stats_get_time_us() - start_time_us;
+#endif
+    return result;
+}
 
-            if (ioctl(socket, SIOCGIFFLAGS, &ifr) != 0)
-            {
-                LogError("ioctl failed querying socket (SIOCGIFFLAGS, errno=%d)", errno);
-                result = __FAILURE__;
-                break;
+static void pop_pending_io(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    PENDING_SOCKET_IO* pending_socket_io = &socket_io_instance->pending_ios[socket_io_instance->pending_io_head];
+
+    if (pending_socket_io->buffer_handle != NULL)
+    {
+        CONSTBUFFER_DecRef(pending_socket_io->buffer_handle);
+    }
+    else
+    {
+        pending_bytes_free(pending_socket_io->bytes);
+    }
+
+    socket_io_instance->pending_io_head = (socket_io_instance->pending_io_head + 1) % socket_io_instance->pending_io_capacity;
+    socket_io_instance->pending_io_count--;
+}
+
+/* queues the bytes of buffers that follow the first skip_size bytes, coalesced in one allocation */
+static int add_pending_io_from_buffers(SOCKET_IO_INSTANCE* socket_io_instance, const XIO_BUFFER* buffers, size_t buffer_count, size_t skip_size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+    size_t size = 0;
+    size_t i;
+    unsigned char* bytes;
+    int previous_budget;
+
+    for (i = 0; i < buffer_count; i++)
+    {
+        size += buffers[i].size;
+    }
+    size -= skip_size;
+
+    /* when built with GB_USE_BUDGETS the bytes that could not be sent yet are counted in the GBALLOC_BUDGET_IO_PENDING budget */
+    previous_budget = GBALLOC_BUDGET_BEGIN(GBALLOC_BUDGET_IO_PENDING);
+    bytes = (unsigned char*)pending_bytes_malloc(size);
+    GBALLOC_BUDGET_END(previous_budget);
+    if (bytes == NULL)
+    {
+        LogError("Allocation Failure: Unable to allocate pending list.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t offset = 0;
+
+        for (i = 0; i < buffer_count; i++)
+        {
+            if (skip_size >= buffers[i].size)
+            {
+                skip_size -= buffers[i].size;
+            }
+            else
+            {
+                (void)memcpy(bytes + offset, (const unsigned char*)buffers[i].buffer + skip_size, buffers[i].size - skip_size);
+                offset += buffers[i].size - skip_size;
+                skip_size = 0;
+            }
+        }
+
+        if (push_pending_io(socket_io_instance, NULL, bytes, bytes, size, on_send_complete, callback_context) != 0)
+        {
+            pending_bytes_free(bytes);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    return result;
+}
+
+static int add_pending_io(SOCKET_IO_INSTANCE* socket_io_instance, const unsigned char* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    XIO_BUFFER xio_buffer;
+    xio_buffer.buffer = buffer;
+    xio_buffer.size = size;
+    return add_pending_io_from_buffers(socket_io_instance, &xio_buffer, 1, 0, on_send_complete, callback_context);
+}
+
+/* queues the bytes of buffer_handle that follow the first skip_size bytes, by taking a reference instead of a copy */
+static int add_pending_constbuffer(SOCKET_IO_INSTANCE* socket_io_instance, CONSTBUFFER_HANDLE buffer_handle, size_t skip_size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+    const CONSTBUFFER* content = CONSTBUFFER_GetContent(buffer_handle);
+
+    CONSTBUFFER_IncRef(buffer_handle);
+
+    if (push_pending_io(socket_io_instance, buffer_handle, NULL, content->buffer + skip_size, content->size - skip_size, on_send_complete, callback_context) != 0)
+    {
+        CONSTBUFFER_DecRef(buffer_handle);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+/* queues references on the bytes of the buffers of constbuffer_array that follow the first skip_size bytes, the last one completes the send */
+static int add_pending_constbuffer_array(SOCKET_IO_INSTANCE* socket_io_instance, CONSTBUFFER_ARRAY_HANDLE constbuffer_array, uint32_t buffer_count, size_t skip_size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+    uint32_t first_buffer;
+    uint32_t skip;
+
+    /* the array looks up the buffer where a short write stopped without walking the buffers before it */
+    if ((skip_size > UINT32_MAX) ||
+        (constbuffer_array_get_buffer_index_at_offset(constbuffer_array, (uint32_t)skip_size, &first_buffer, &skip) != 0))
+    {
+        LogError("Failure: Unable to find the buffer at offset %lu.", (unsigned long)skip_size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t entry_count = 0;
+        uint32_t last_buffer = first_buffer;
+        uint32_t i;
+
+        for (i = first_buffer; i < buffer_count; i++)
+        {
+            if (constbuffer_array_get_buffer_content(constbuffer_array, i)->size > 0)
+            {
+                last_buffer = i;
+                entry_count++;
+            }
+        }
+
+        /* taking all the room first means that queueing the entries cannot fail half way */
+        if (ensure_pending_io_capacity(socket_io_instance, entry_count) != 0)
+        {
+            LogError("Failure: Unable to add the buffers to the pending list.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+
+            for (i = first_buffer; i <= last_buffer; i++)
+            {
+                const CONSTBUFFER* content = constbuffer_array_get_buffer_content(constbuffer_array, i);
+                if (content->size > 0)
+                {
+                    /* constbuffer_array_get_buffer hands out a reference, the entry keeps it */
+                    CONSTBUFFER_HANDLE buffer_handle = constbuffer_array_get_buffer(constbuffer_array, i);
+                    if (push_pending_io(socket_io_instance, buffer_handle, NULL, content->buffer + skip, content->size - skip,
+                        (i == last_buffer) ? on_send_complete : NULL, (i == last_buffer) ? callback_context : NULL) != 0)
+                    {
+                        CONSTBUFFER_DecRef(buffer_handle);
+                        result = __FAILURE__;
+                        break;
+                    }
+                    skip = 0;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+/* sends what is left of the oldest pending send, with MSG_ZEROCOPY when it is one of those */
+static ssize_t send_pending_bytes(SOCKET_IO_INSTANCE* socket_io_instance, PENDING_SOCKET_IO* pending_socket_io)
+{
+    ssize_t result;
+
+#ifdef SOCKETIO_HAS_ZEROCOPY
+    /* the room for the entry is taken before sending, so that it can always wait for its notification */
+    if (pending_socket_io->zerocopy &&
+        (socket_io_instance->zerocopy_state == SOCKETIO_ZEROCOPY_ON) &&
+        (ensure_zerocopy_send_capacity(socket_io_instance) == 0))
+    {
+        result = send_bytes(socket_io_instance, pending_socket_io->data, pending_socket_io->size, MSG_ZEROCOPY);
+        if (result >= 0)
+        {
+            pending_socket_io->zerocopy_sent = true;
+            pending_socket_io->zerocopy_id = socket_io_instance->zerocopy_next_id;
+            socket_io_instance->zerocopy_next_id++;
+        }
+        else if (errno == ENOBUFS)
+        {
+            /* the socket has too many notifications outstanding, this part is copied */
+            result = send_bytes(socket_io_instance, pending_socket_io->data, pending_socket_io->size, 0);
+        }
+    }
+    else
+#endif
+    {
+        result = send_bytes(socket_io_instance, pending_socket_io->data, pending_socket_io->size, 0);
+    }
+
+    return result;
+}
+
+/* sends the pending sends as long as the socket takes them; fails on a socket error, leaving the failed send first in the queue */
+static int send_pending_ios(SOCKET_IO_INSTANCE* socket_io_instance, bool* sent_part_of_a_send)
+{
+    int result = 0;
+
+    while (socket_io_instance->pending_io_count > 0)
+    {
+        PENDING_SOCKET_IO* pending_socket_io = &socket_io_instance->pending_ios[socket_io_instance->pending_io_head];
+
+        signal(SIGPIPE, SIG_IGN);
+
+        ssize_t send_result = send_pending_bytes(socket_io_instance, pending_socket_io);
+        if ((send_result < 0) || ((size_t)send_result != pending_socket_io->size))
+        {
+            if (send_result == INVALID_SOCKET)
+            {
+                if (errno != EAGAIN) /*send says "come back later" with EAGAIN - likely the socket buffer cannot accept more data*/
+                {
+                    LogError("Failure: sending Socket information. errno=%d (%s).", errno, strerror(errno));
+                    result = __FAILURE__;
+                }
+            }
+            else
+            {
+                /* simply wait until next dowork */
+                *sent_part_of_a_send = true;
+                pending_socket_io->data += send_result;
+                pending_socket_io->size -= send_result;
+            }
+            break;
+        }
+        else
+        {
+            /* the entry is released first, the callback is free to send again */
+            ON_SEND_COMPLETE on_send_complete = pending_socket_io->on_send_complete;
+            void* callback_context = pending_socket_io->callback_context;
+
+            if (pending_socket_io->zerocopy_sent)
+            {
+                /* the kernel still reads the buffer, the reference moves to the sends waiting for it; send_pending_bytes made room for it */
+                (void)push_zerocopy_send(socket_io_instance, pending_socket_io->buffer_handle, pending_socket_io->zerocopy_id, on_send_complete, callback_context);
+                pending_socket_io->buffer_handle = NULL;
+                pending_socket_io->bytes = NULL;
+                pop_pending_io(socket_io_instance);
+            }
+            else
+            {
+                pop_pending_io(socket_io_instance);
+
+                indicate_send_complete(socket_io_instance, on_send_complete, callback_context);
+            }
+        }
+    }
+
+    return result;
+}
+
+static STATIC_VAR_UNUSED void signal_callback(int signum)
+{
+    AZURE_UNREFERENCED_PARAMETER(signum);
+    LogError("Socket received signal %d.", signum);
+}
+
+static int initiate_unix_socket_connection(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    int result;
+    int err;
+
+    struct sockaddr_un addrInfoUn;
+    size_t hostname_len = strlen(socket_io_instance->hostname);
+
+    if (hostname_len + 1 > sizeof(addrInfoUn.sun_path))
+    {
+        LogError("Hostname %s is too long for a unix socket (max len = %lu)", socket_io_instance->hostname, (unsigned long)sizeof(addrInfoUn.sun_path));
+        result = __FAILURE__;
+    }
+    else
+    {
+        int flags;
+
+        memset(&addrInfoUn, 0, sizeof(addrInfoUn));
+        addrInfoUn.sun_family = AF_UNIX;
+        // No need to add NULL terminator due to the above memset
+        (void)memcpy(addrInfoUn.sun_path, socket_io_instance->hostname, hostname_len);
+
+        if ((-1 == (flags = fcntl(socket_io_instance->socket, F_GETFL, 0))) ||
+            (fcntl(socket_io_instance->socket, F_SETFL, flags | O_NONBLOCK) == -1))
+        {
+            LogError("Failure: fcntl failure.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            err = connect(socket_io_instance->socket, (struct sockaddr*)&addrInfoUn, sizeof(addrInfoUn));
+            if ((err != 0) && (errno != EINPROGRESS))
+            {
+                LogError("Failure: connect failure %d.", errno);
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static int wait_for_connection(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    int result;
+    int err;
+    int retval;
+    int poll_errno = 0;
+
+    /* poll has no FD_SETSIZE ceiling on the descriptor value, unlike select */
+    struct pollfd pollfd;
+
+    pollfd.fd = socket_io_instance->socket;
+    pollfd.events = POLLOUT;
+    pollfd.revents = 0;
+
+    do
+    {
+        retval = poll(&pollfd, 1, CONNECT_TIMEOUT * 1000);
+
+        if (retval < 0)
+        {
+            poll_errno = errno;
+        }
+    } while (retval < 0 && poll_errno == EINTR);
+
+    if (retval != 1)
+    {
+        LogError("Failure: poll failure.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        int so_error = 0;
+        socklen_t len = sizeof(so_error);
+        err = getsockopt(socket_io_instance->socket, SOL_SOCKET, SO_ERROR, &so_error, &len);
+        if (err != 0)
+        {
+            LogError("Failure: getsockopt failure %d.", errno);
+            result = __FAILURE__;
+        }
+        else if (so_error != 0)
+        {
+            err = so_error;
+            LogError("Failure: connect failure %d.", so_error);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+
+
+#ifndef __APPLE__
+static void destroy_network_interface_descriptions(NETWORK_INTERFACE_DESCRIPTION* nid)
+{
+    if (nid != NULL)
+    {
+        if (nid->next != NULL)
+        {
+            destroy_network_interface_descriptions(nid->next);
+        }
+
+        if (nid->name != NULL)
+        {
+            free(nid->name);
+        }
+
+        if (nid->mac_address != NULL)
+        {
+            free(nid->mac_address);
+        }
+
+        if (nid->ip_address != NULL)
+        {
+            free(nid->ip_address);
+        }
+
+        free(nid);
+    }
+}
+
+static NETWORK_INTERFACE_DESCRIPTION* create_network_interface_description(struct ifreq *ifr, const struct sockaddr* hw_address, NETWORK_INTERFACE_DESCRIPTION* previous_nid)
+{
+    NETWORK_INTERFACE_DESCRIPTION* result;
+
+    if ((result = (NETWORK_INTERFACE_DESCRIPTION*)malloc(sizeof(NETWORK_INTERFACE_DESCRIPTION))) == NULL)
+    {
+        LogError("Failed allocating NETWORK_INTERFACE_DESCRIPTION");
+    }
+    else if ((result->name = (char*)malloc(sizeof(char) * (strlen(ifr->ifr_name) + 1))) == NULL)
+    {
+        LogError("failed setting interface description name (malloc failed)");
+        destroy_network_interface_descriptions(result);
+        result = NULL;
+    }
+    else if (strcpy(result->name, ifr->ifr_name) == NULL)
+    {
+        LogError("failed setting interface description name (strcpy failed)");
+        destroy_network_interface_descriptions(result);
+        result = NULL;
+    }
+    else
+    {
+        char* ip_address;
+        const unsigned char* mac = (const unsigned char*)hw_address->sa_data;
+
+        if ((result->mac_address = (char*)malloc(sizeof(char) * MAC_ADDRESS_STRING_LENGTH)) == NULL)
+        {
+            LogError("failed formatting mac address (malloc failed)");
+            destroy_network_interface_descriptions(result);
+            result = NULL;
+        }
+        else if (sprintf(result->mac_address, "%02X:%02X:%02X:%02X:%02X:%02X", mac[0],mac[1],mac[2],mac[3],mac[4],mac[5]) <= 0)
+        {
+            LogError("failed formatting mac address (sprintf failed)");
+            destroy_network_interface_descriptions(result);
+            result = NULL;
+        }
+        else if ((ip_address = inet_ntoa(((struct sockaddr_in*)&ifr->ifr_addr)->sin_addr)) == NULL)
+        {
+            LogError("failed setting the ip address (inet_ntoa failed)");
+            destroy_network_interface_descriptions(result);
+            result = NULL;
+        }
+        else if ((result->ip_address = (char*)malloc(sizeof(char) * (strlen(ip_address) + 1))) == NULL)
+        {
+            LogError("failed setting the ip address (malloc failed)");
+            destroy_network_interface_descriptions(result);
+            result = NULL;
+        }
+        else if (strcpy(result->ip_address, ip_address) == NULL)
+        {
+            LogError("failed setting the ip address (strcpy failed)");
+            destroy_network_interface_descriptions(result);
+            result = NULL;
+        }
+        else
+        {
+            result->next = NULL;
+
+            if (previous_nid != NULL)
+            {
+                previous_nid->next = result;
+            }
+        }
+    }
+
+    return result;
+}
+
+static int get_network_interface_descriptions(int socket, NETWORK_INTERFACE_DESCRIPTION** nid)
+{
+    int result;
+
+    struct ifreq ifr;
+    /* ifr_hwaddr and ifr_addr share the storage of an ifreq, so the MAC address is queried in its own */
+    struct ifreq hw_ifr;
+    struct ifconf ifc;
+    char buf[IFREQ_BUFFER_SIZE];
+
+    ifc.ifc_len = sizeof(buf);
+    ifc.ifc_buf = buf;
+
+    if (ioctl(socket, SIOCGIFCONF, &ifc) == -1)
+    {
+        LogError("ioctl failed querying socket (SIOCGIFCONF, errno=%d)", errno);
+        result = __FAILURE__;
+    }
+    else
+    {
+        NETWORK_INTERFACE_DESCRIPTION* root_nid = NULL;
+        NETWORK_INTERFACE_DESCRIPTION* new_nid = NULL;
+
+        struct ifreq* it = ifc.ifc_req;
+        const struct ifreq* const end = it + (ifc.ifc_len / sizeof(struct ifreq));
+
+        result = 0;
+
+        for (; it != end; ++it)
+        {
+            strcpy(ifr.ifr_name, it->ifr_name);
+            strcpy(hw_ifr.ifr_name, it->ifr_name);
+
+            if (ioctl(socket, SIOCGIFFLAGS, &ifr) != 0)
+            {
+                LogError("ioctl failed querying socket (SIOCGIFFLAGS, errno=%d)", errno);
+                result = __FAILURE__;
+                break;
+            }
+            else if (ioctl(socket, SIOCGIFHWADDR, &hw_ifr) != 0)
+            {
+                LogError("ioctl failed querying socket (SIOCGIFHWADDR, errno=%d)", errno);
+                result = __FAILURE__;
+                break;
+            }
+            else if (ioctl(socket, SIOCGIFADDR, &ifr) != 0)
+            {
+                LogError("ioctl failed querying socket (SIOCGIFADDR, errno=%d)", errno);
+                result = __FAILURE__;
+                break;
+            }
+            else if ((new_nid = create_network_interface_description(&ifr, &hw_ifr.ifr_hwaddr, new_nid)) == NULL)
+            {
+                LogError("Failed creating network interface description");
+                result = __FAILURE__;
+                break;
+            }
+            else if (root_nid == NULL)
+            {
+                root_nid = new_nid;
+            }
+        }
+
+        if (result == 0)
+        {
+            *nid = root_nid;
+        }
+        else
+        {
+            destroy_network_interface_descriptions(root_nid);
+        }
+    }
+
+    return result;
+}
+
+static void acquire_network_interface_cache(void)
+{
+    (void)pthread_mutex_lock(&interface_cache_lock);
+    interface_cache_user_count++;
+    (void)pthread_mutex_unlock(&interface_cache_lock);
+}
+
+static void release_network_interface_cache(void)
+{
+    (void)pthread_mutex_lock(&interface_cache_lock);
+    interface_cache_user_count--;
+    if (interface_cache_user_count == 0)
+    {
+        destroy_network_interface_descriptions(interface_cache);
+        interface_cache = NULL;
+        interface_cache_is_valid = false;
+
+        if (interface_cache_notifications != INVALID_SOCKET)
+        {
+            close(interface_cache_notifications);
+            interface_cache_notifications = INVALID_SOCKET;
+        }
+    }
+    (void)pthread_mutex_unlock(&interface_cache_lock);
+}
+
+// Must be called with interface_cache_lock held
+static void open_network_interface_notifications(void)
+{
+#ifdef SOCKETIO_HAS_INTERFACE_NOTIFICATIONS
+    int notifications = socket(AF_NETLINK, SOCK_RAW | SOCK_NONBLOCK | SOCK_CLOEXEC, NETLINK_ROUTE);
+
+    if (notifications < 0)
+    {
+        LogInfo("netlink socket failed (errno=%d), the network interfaces are enumerated for each socket", errno);
+    }
+    else
+    {
+        struct sockaddr_nl address;
+
+        (void)memset(&address, 0, sizeof(address));
+        address.nl_family = AF_NETLINK;
+        address.nl_groups = RTMGRP_LINK | RTMGRP_IPV4_IFADDR | RTMGRP_IPV6_IFADDR;
+
+        if (bind(notifications, (struct sockaddr*)&address, sizeof(address)) != 0)
+        {
+            LogInfo("netlink bind failed (errno=%d), the network interfaces are enumerated for each socket", errno);
+            close(notifications);
+        }
+        else
+        {
+            interface_cache_notifications = notifications;
+        }
+    }
+#endif
+}
+
+// Must be called with interface_cache_lock held
+static bool have_network_interfaces_changed(void)
+{
+    bool result = false;
+
+#ifdef SOCKETIO_HAS_INTERFACE_NOTIFICATIONS
+    unsigned char buffer[4096];
+    bool drained = false;
+
+    while (!drained)
+    {
+        ssize_t received = recv(interface_cache_notifications, buffer, sizeof(buffer), MSG_DONTWAIT);
+
+        if (received > 0)
+        {
+            result = true;
+        }
+        else if ((received < 0) && (errno == ENOBUFS))
+        {
+            /* notifications were dropped, some of them may have been changes */
+            result = true;
+        }
+        else
+        {
+            drained = true;
+        }
+    }
+#endif
+
+    return result;
+}
+
+// Must be called with interface_cache_lock held
+static void refresh_network_interface_cache(int socket)
+{
+    destroy_network_interface_descriptions(interface_cache);
+    interface_cache = NULL;
+    interface_cache_is_valid = false;
+
+    if (interface_cache_notifications == INVALID_SOCKET)
+    {
+        /* subscribing before enumerating makes sure that no change goes unnoticed */
+        open_network_interface_notifications();
+    }
+    else
+    {
+        (void)have_network_interfaces_changed();
+    }
+
+    if (get_network_interface_descriptions(socket, &interface_cache) != 0)
+    {
+        LogError("Failed getting network interface descriptions");
+    }
+    else
+    {
+        /* without notifications the table cannot be trusted past this lookup */
+        interface_cache_is_valid = (interface_cache_notifications != INVALID_SOCKET);
+    }
+}
+
+// Must be called with interface_cache_lock held
+static const NETWORK_INTERFACE_DESCRIPTION* find_network_interface(const char* mac_address)
+{
+    const NETWORK_INTERFACE_DESCRIPTION* result = interface_cache;
+
+    while ((result != NULL) && (strcmp(mac_address, result->mac_address) != 0))
+    {
+        result = result->next;
+    }
+
+    return result;
+}
+
+static int set_target_network_interface(int socket, char* mac_address)
+{
+    int result;
+    const NETWORK_INTERFACE_DESCRIPTION* nid;
+    bool is_refreshed = false;
+
+    (void)pthread_mutex_lock(&interface_cache_lock);
+
+    if (!interface_cache_is_valid || have_network_interfaces_changed())
+    {
+        refresh_network_interface_cache(socket);
+        is_refreshed = true;
+    }
+
+    if (((nid = find_network_interface(mac_address)) == NULL) && !is_refreshed)
+    {
+        /* the interface may have come up with its notification still on the way */
+        refresh_network_interface_cache(socket);
+        nid = find_network_interface(mac_address);
+    }
+
+    if (nid == NULL)
+    {
+        LogError("Did not find a network interface matching MAC ADDRESS");
+        result = __FAILURE__;
+    }
+    else if (setsockopt(socket, SOL_SOCKET, SO_BINDTODEVICE, nid->name, strlen(nid->name)) != 0)
+    {
+        LogError("setsockopt failed (%d)", errno);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (!interface_cache_is_valid)
+    {
+        destroy_network_interface_descriptions(interface_cache);
+        interface_cache = NULL;
+    }
+
+    (void)pthread_mutex_unlock(&interface_cache_lock);
+
+    return result;
+}
+#endif //__APPLE__
+
+static void add_ipv4_connect_address(CONNECT_ADDRESS* address, uint32_t ip_v4, int port)
+{
+    struct sockaddr_in* addr_in = (struct sockaddr_in*)&address->addr;
+
+    memset(address, 0, sizeof(*address));
+    addr_in->sin_family = AF_INET;
+    addr_in->sin_port = htons((uint16_t)port);
+    addr_in->sin_addr.s_addr = ip_v4;
+    address->addr_len = sizeof(struct sockaddr_in);
+}
+
+static void add_ipv6_connect_address(CONNECT_ADDRESS* address, const unsigned char* ip_v6, int port)
+{
+    struct sockaddr_in6* addr_in6 = (struct sockaddr_in6*)&address->addr;
+
+    memset(address, 0, sizeof(*address));
+    addr_in6->sin6_family = AF_INET6;
+    addr_in6->sin6_port = htons((uint16_t)port);
+    (void)memcpy(addr_in6->sin6_addr.s6_addr, ip_v6, DNS_CACHE_IPV6_ADDRESS_SIZE);
+    address->addr_len = sizeof(struct sockaddr_in6);
+}
+
+// Takes the addresses found by the lookup of the host, in the order they are tried: IPv6 first
+// (RFC 8305 section 4), then IPv4.
+static int get_lookup_addresses(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    int result;
+    unsigned char ip_v6[DNS_ASYNC_IPV6_ADDRESS_SIZE];
+    uint32_t ip_v4 = dns_async_get_ipv4(socket_io_instance->connect->dns_lookup);
+
+    socket_io_instance->connect->address_count = 0;
+
+    if (dns_async_get_ipv6(socket_io_instance->connect->dns_lookup, ip_v6, sizeof(ip_v6)) == 0)
+    {
+        add_ipv6_connect_address(&socket_io_instance->connect->addresses[socket_io_instance->connect->address_count++], ip_v6, socket_io_instance->port);
+    }
+    if (ip_v4 != 0)
+    {
+        add_ipv4_connect_address(&socket_io_instance->connect->addresses[socket_io_instance->connect->address_count++], ip_v4, socket_io_instance->port);
+    }
+
+    if (socket_io_instance->connect->address_count == 0)
+    {
+        LogError("Failure: no IP address found for %s.", socket_io_instance->hostname);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+// Returns the socket of a connection attempt that is in progress (or done, then *is_connected is
+// set), INVALID_SOCKET if the attempt failed right away.
+static int start_connection_attempt(SOCKET_IO_INSTANCE* socket_io_instance, const CONNECT_ADDRESS* address, bool* is_connected)
+{
+    int result;
+    int flags;
+
+    *is_connected = false;
+
+    if ((result = socket(address->addr.ss_family, SOCK_STREAM, 0)) < SOCKET_SUCCESS)
+    {
+        LogError("Failure: socket create failure %d.", errno);
+        result = INVALID_SOCKET;
+    }
+#ifndef __APPLE__
+    else if (socket_io_instance->target_mac_address != NULL &&
+             set_target_network_interface(result, socket_io_instance->target_mac_address) != 0)
+    {
+        LogError("Failure: failed selecting target network interface (MACADDR=%s).", socket_io_instance->target_mac_address);
+        close(result);
+        result = INVALID_SOCKET;
+    }
+#endif //__APPLE__
+    else if (apply_tuning_options(socket_io_instance, result) != 0)
+    {
+        // buffer sizes and fast open only take full effect when set before connecting
+        LogError("Failure: failed applying socket options.");
+        close(result);
+        result = INVALID_SOCKET;
+    }
+    else if ((-1 == (flags = fcntl(result, F_GETFL, 0))) ||
+             (fcntl(result, F_SETFL, flags | O_NONBLOCK) == -1))
+    {
+        LogError("Failure: fcntl failure.");
+        close(result);
+        result = INVALID_SOCKET;
+    }
+    else if (connect(result, (const struct sockaddr*)&address->addr, address->addr_len) == 0)
+    {
+        *is_connected = true;
+    }
+    else if (errno != EINPROGRESS)
+    {
+        LogInfo("Connection attempt to %s (address family %d) failed: %d.", socket_io_instance->hostname, (int)address->addr.ss_family, errno);
+        close(result);
+        result = INVALID_SOCKET;
+    }
+
+    return result;
+}
+
+static void close_connection_attempts(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    if (socket_io_instance->connect != NULL)
+    {
+        size_t i;
+
+        for (i = 0; i < socket_io_instance->connect->started_count; i++)
+        {
+            if (socket_io_instance->connect->attempts[i] != INVALID_SOCKET)
+            {
+                close(socket_io_instance->connect->attempts[i]);
+            }
+        }
+
+        if (socket_io_instance->connect->dns_lookup != NULL)
+        {
+            dns_async_destroy(socket_io_instance->connect->dns_lookup);
+        }
+
+        free(socket_io_instance->connect);
+        socket_io_instance->connect = NULL;
+    }
+}
+
+static int begin_connecting(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    int result;
+    tickcounter_us_t now;
+
+    if (tickcounter_get_monotonic_us(&now) != 0)
+    {
+        LogError("Failure: tickcounter_get_monotonic_us failed.");
+        result = __FAILURE__;
+    }
+    else if ((socket_io_instance->connect = (CONNECT_STATE*)malloc(sizeof(CONNECT_STATE))) == NULL)
+    {
+        LogError("Failure: unable to allocate the connect state.");
+        result = __FAILURE__;
+    }
+    // the lookup goes through the process wide DNS cache
+    else if ((socket_io_instance->connect->dns_lookup = dns_async_create(socket_io_instance->hostname, NULL)) == NULL)
+    {
+        LogError("Failure: dns_async_create failed.");
+        free(socket_io_instance->connect);
+        socket_io_instance->connect = NULL;
+        result = __FAILURE__;
+    }
+    else
+    {
+        socket_io_instance->connect->address_count = 0;
+        socket_io_instance->connect->started_count = 0;
+        socket_io_instance->connect->in_progress_count = 0;
+        socket_io_instance->connect->deadline = now + ((tickcounter_us_t)CONNECT_TIMEOUT * 1000000);
+        socket_io_instance->connect->next_attempt = now;
+        result = 0;
+    }
+
+    return result;
+}
+
+// Carries on the open: resolving the host with dns_async, then connecting to it with staggered
+// parallel attempts (Happy Eyeballs, RFC 8305): an attempt is started every
+// SOCKETIO_CONNECTION_ATTEMPT_DELAY_MS, or as soon as the previous ones failed, and the first socket
+// that connects wins. This bounds the connect time by the fastest working path rather than by the
+// timeout of a broken one. The lookup and the attempts are checked without waiting, so an open in
+// progress does not hold up the other connections of the thread; *is_connected is set once
+// socket_io_instance->socket is connected. CONNECT_TIMEOUT covers the lookup too.
+static int continue_connecting(SOCKET_IO_INSTANCE* socket_io_instance, bool* is_connected)
+{
+    int result;
+    tickcounter_us_t now;
+    int connected_socket = INVALID_SOCKET;
+    bool lookup_failed = false;
+    size_t i;
+
+    *is_connected = false;
+
+    if (tickcounter_get_monotonic_us(&now) != 0)
+    {
+        LogError("Failure: tickcounter_get_monotonic_us failed.");
+        close_connection_attempts(socket_io_instance);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+
+        if ((socket_io_instance->connect->dns_lookup != NULL) &&
+            dns_async_is_lookup_complete(socket_io_instance->connect->dns_lookup))
+        {
+            lookup_failed = (get_lookup_addresses(socket_io_instance) != 0);
+            dns_async_destroy(socket_io_instance->connect->dns_lookup);
+            socket_io_instance->connect->dns_lookup = NULL;
+            socket_io_instance->connect->next_attempt = now;
+        }
+
+        if (socket_io_instance->connect->in_progress_count > 0)
+        {
+            struct pollfd pollfds[SOCKETIO_MAX_CONNECT_ADDRESSES];
+            size_t attempt_indices[SOCKETIO_MAX_CONNECT_ADDRESSES];
+            nfds_t pollfd_count = 0;
+            int retval;
+
+            for (i = 0; i < socket_io_instance->connect->started_count; i++)
+            {
+                if (socket_io_instance->connect->attempts[i] != INVALID_SOCKET)
+                {
+                    pollfds[pollfd_count].fd = socket_io_instance->connect->attempts[i];
+                    pollfds[pollfd_count].events = POLLOUT;
+                    pollfds[pollfd_count].revents = 0;
+                    attempt_indices[pollfd_count] = i;
+                    pollfd_count++;
+                }
+            }
+
+            retval = poll(pollfds, pollfd_count, 0);
+            if ((retval < 0) && (errno != EINTR))
+            {
+                LogError("Failure: poll failure %d.", errno);
+                result = __FAILURE__;
+            }
+            else if (retval > 0)
+            {
+                nfds_t j;
+
+                for (j = 0; j < pollfd_count; j++)
+                {
+                    if (pollfds[j].revents != 0)
+                    {
+                        int so_error = 0;
+                        socklen_t len = sizeof(so_error);
+                        i = attempt_indices[j];
+
+                        if ((getsockopt(socket_io_instance->connect->attempts[i], SOL_SOCKET, SO_ERROR, &so_error, &len) == 0) && (so_error == 0))
+                        {
+                            if (connected_socket == INVALID_SOCKET)
+                            {
+                                connected_socket = socket_io_instance->connect->attempts[i];
+                                socket_io_instance->connect->attempts[i] = INVALID_SOCKET;
+                            }
+                        }
+                        else
+                        {
+                            LogInfo("Connection attempt to %s (address family %d) failed: %d.", socket_io_instance->hostname, (int)socket_io_instance->connect->addresses[i].addr.ss_family, so_error);
+                            close(socket_io_instance->connect->attempts[i]);
+                            socket_io_instance->connect->attempts[i] = INVALID_SOCKET;
+                            // do not wait for the delay to try the next address
+                            socket_io_instance->connect->next_attempt = now;
+                        }
+                        socket_io_instance->connect->in_progress_count--;
+                    }
+                }
+            }
+        }
+
+        while ((result == 0) &&
+            !lookup_failed &&
+            (connected_socket == INVALID_SOCKET) &&
+            (socket_io_instance->connect->started_count < socket_io_instance->connect->address_count) &&
+            (now >= socket_io_instance->connect->next_attempt))
+        {
+            bool attempt_connected;
+            size_t index = socket_io_instance->connect->started_count++;
+            int attempt = start_connection_attempt(socket_io_instance, &socket_io_instance->connect->addresses[index], &attempt_connected);
+
+            socket_io_instance->connect->attempts[index] = INVALID_SOCKET;
+            if (attempt_connected)
+            {
+                connected_socket = attempt;
+            }
+            else if (attempt != INVALID_SOCKET)
+            {
+                socket_io_instance->connect->attempts[index] = attempt;
+                socket_io_instance->connect->in_progress_count++;
+                socket_io_instance->connect->next_attempt = now + ((tickcounter_us_t)SOCKETIO_CONNECTION_ATTEMPT_DELAY_MS * 1000);
+            }
+            else
+            {
+                // failed right away, the next address is tried without waiting
+            }
+        }
+
+        if (connected_socket != INVALID_SOCKET)
+        {
+            close_connection_attempts(socket_io_instance);
+            socket_io_instance->socket = connected_socket;
+            *is_connected = true;
+        }
+        else if (lookup_failed)
+        {
+            // a failed lookup is cached by dns_async, it is not removed from the cache
+            close_connection_attempts(socket_io_instance);
+            result = __FAILURE__;
+        }
+        else if ((result != 0) ||
+            (now >= socket_io_instance->connect->deadline) ||
+            ((socket_io_instance->connect->dns_lookup == NULL) && (socket_io_instance->connect->in_progress_count == 0) && (socket_io_instance->connect->started_count == socket_io_instance->connect->address_count)))
+        {
+            LogError("Failure: could not connect to %s:%d.", socket_io_instance->hostname, socket_io_instance->port);
+            close_connection_attempts(socket_io_instance);
+            // the cached addresses may be stale, resolve again next time
+            dns_cache_remove(socket_io_instance->hostname);
+            result = __FAILURE__;
+        }
+        else
+        {
+            // still resolving or connecting
+        }
+    }
+
+    return result;
+}
+
+// The time at which continue_connecting has to run whatever the sockets do: the next check of the
+// lookup, the next attempt to start or the connect timeout. While several attempts are in flight only one of them can be handed out as the
+// pollable handle, the others are then checked every SOCKETIO_CONNECTION_ATTEMPT_DELAY_MS.
+static uint64_t get_connect_deadline(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    uint64_t result = socket_io_instance->connect->deadline;
+    tickcounter_us_t now;
+
+    if ((socket_io_instance->connect->dns_lookup != NULL) &&
+        (tickcounter_get_monotonic_us(&now) == 0) &&
+        (now + ((tickcounter_us_t)SOCKETIO_LOOKUP_CHECK_INTERVAL_MS * 1000) < result))
+    {
+        // the completion of the lookup cannot be waited for on a socket
+        result = now + ((tickcounter_us_t)SOCKETIO_LOOKUP_CHECK_INTERVAL_MS * 1000);
+    }
+
+    if ((socket_io_instance->connect->started_count < socket_io_instance->connect->address_count) &&
+        (socket_io_instance->connect->next_attempt < result))
+    {
+        result = socket_io_instance->connect->next_attempt;
+    }
+
+    if ((socket_io_instance->connect->in_progress_count > 1) &&
+        (tickcounter_get_monotonic_us(&now) == 0) &&
+        (now + ((tickcounter_us_t)SOCKETIO_CONNECTION_ATTEMPT_DELAY_MS * 1000) < result))
+    {
+        result = now + ((tickcounter_us_t)SOCKETIO_CONNECTION_ATTEMPT_DELAY_MS * 1000);
+    }
+
+    return result;
+}
+
+CONCRETE_IO_HANDLE socketio_create(void* io_create_parameters)
+{
+    SOCKETIO_CONFIG* socket_io_config = io_create_parameters;
+    SOCKET_IO_INSTANCE* result;
+
+    if (socket_io_config == NULL)
+    {
+        LogError("Invalid argument: socket_io_config is NULL");
+        result = NULL;
+    }
+    else
+    {
+        result = malloc(sizeof(SOCKET_IO_INSTANCE));
+        if (result != NULL)
+        {
+            result->address_type = ADDRESS_TYPE_IP;
+            result->pending_io_head = 0;
+            result->pending_io_count = 0;
+            result->pending_io_capacity = SOCKETIO_PENDING_IO_INITIAL_CAPACITY;
+            result->pending_ios = (PENDING_SOCKET_IO*)malloc(SOCKETIO_PENDING_IO_INITIAL_CAPACITY * sizeof(PENDING_SOCKET_IO));
+            if (result->pending_ios == NULL)
+            {
+                LogError("Failure: unable to create pending list.");
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                if (socket_io_config->hostname != NULL)
+                {
+                    /* the connections to one host share its name */
+                    result->hostname = string_intern(socket_io_config->hostname);
+                    result->socket = INVALID_SOCKET;
+                }
+                else
+                {
+                    result->hostname = NULL;
+                    result->socket = *((int*)socket_io_config->accepted_socket);
+                }
+
+                if ((result->hostname == NULL) && (result->socket == INVALID_SOCKET))
+                {
+                    LogError("Failure: hostname == NULL and socket is invalid.");
+                    free(result->pending_ios);
+                    free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    result->port = socket_io_config->port;
+                    result->target_mac_address = NULL;
+                    result->on_bytes_received = NULL;
+                    result->on_io_error = NULL;
+                    result->on_bytes_received_context = NULL;
+                    result->on_io_error_context = NULL;
+                    result->io_state = IO_STATE_CLOSED;
+                    result->on_io_open_complete = NULL;
+                    result->on_io_open_complete_context = NULL;
+                    result->connect = NULL;
+                    result->socket_reactor = NULL;
+                    result->ready_events = 0;
+                    result->tuning_options_set = 0;
+                    (void)memset(result->tuning_values, 0, sizeof(result->tuning_values));
+                    result->receive_size = RECEIVE_BYTES_VALUE;
+                    result->adaptive_receive = false;
+                    result->shared_receive_buffer = false;
+                    result->receive_drain_limit = 0;
+                    result->zerocopy_threshold = 0;
+                    result->zerocopy_state = SOCKETIO_ZEROCOPY_UNKNOWN;
+                    result->zerocopy_next_id = 0;
+                    result->zerocopy_completed_id = 0;
+                    result->zerocopy_sends = NULL;
+                    result->zerocopy_send_head = 0;
+                    result->zerocopy_send_count = 0;
+                    result->zerocopy_send_capacity = 0;
+                    result->large_recv_bytes = NULL;
+                    result->large_recv_capacity = 0;
+                    result->lent_recv_bytes = NULL;
+                    result->lent_recv_size = 0;
+                    (void)memset(&result->stats, 0, sizeof(result->stats));
+                    result->stats.layer_name = "socketio";
+                }
+            }
+        }
+        else
+        {
+            LogError("Allocation Failure: SOCKET_IO_INSTANCE");
+        }
+    }
+
+    return result;
+}
+
+void socketio_destroy(CONCRETE_IO_HANDLE socket_io)
+{
+    if (socket_io != NULL)
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        unregister_from_socket_reactor(socket_io_instance);
+        close_connection_attempts(socket_io_instance);
+
+        /* we cannot do much if the close fails, so just ignore the result */
+        if (socket_io_instance->socket != INVALID_SOCKET)
+        {
+            close(socket_io_instance->socket);
+        }
+
+        /* clear allpending IOs */
+        while (socket_io_instance->pending_io_count > 0)
+        {
+            pop_pending_io(socket_io_instance);
+        }
+
+        while (socket_io_instance->zerocopy_send_count > 0)
+        {
+            ON_SEND_COMPLETE on_send_complete;
+            void* callback_context;
+
+            pop_zerocopy_send(socket_io_instance, &on_send_complete, &callback_context);
+        }
+
+        free(socket_io_instance->pending_ios);
+        free(socket_io_instance->zerocopy_sends);
+        string_intern_release(socket_io_instance->hostname);
+#ifndef __APPLE__
+        if (socket_io_instance->target_mac_address != NULL)
+        {
+            free(socket_io_instance->target_mac_address);
+            release_network_interface_cache();
+        }
+#endif //__APPLE__
+        free(socket_io_instance->large_recv_bytes);
+        free(socket_io);
+    }
+}
+
+int socketio_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    int result;
+    bool is_connecting = false;
+
+    SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+    if (socket_io == NULL)
+    {
+        LogError("Invalid argument: SOCKET_IO_INSTANCE is NULL");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (socket_io_instance->io_state != IO_STATE_CLOSED)
+        {
+            LogError("Failure: socket state is not closed.");
+            result = __FAILURE__;
+        }
+        else if (socket_io_instance->socket != INVALID_SOCKET)
+        {
+            // Opening an accepted socket
+            if (register_with_socket_reactor(socket_io_instance) != 0)
+            {
+                LogError("register_with_socket_reactor failed");
+                result = __FAILURE__;
             }
-            else if (ioctl(socket, SIOCGIFHWADDR, &ifr) != 0)
+            else
             {
-                LogError("ioctl failed querying socket (SIOCGIFHWADDR, errno=%d)", errno);
+                socket_io_instance->on_bytes_received_context = on_bytes_received_context;
+                socket_io_instance->on_bytes_received = on_bytes_received;
+                socket_io_instance->on_io_error = on_io_error;
+                socket_io_instance->on_io_error_context = on_io_error_context;
+
+                socket_io_instance->io_state = IO_STATE_OPEN;
+
+                result = 0;
+            }
+        }
+        else
+        {
+            if (socket_io_instance->address_type == ADDRESS_TYPE_IP)
+            {
+                bool is_connected;
+
+                // the connection attempts create their own sockets, one per address tried
+                if ((result = begin_connecting(socket_io_instance)) != 0)
+                {
+                    LogError("begin_connecting failed");
+                }
+                else if ((result = continue_connecting(socket_io_instance, &is_connected)) != 0)
+                {
+                    LogError("continue_connecting failed");
+                }
+                else
+                {
+                    // the connection carries on in socketio_dowork, which indicates the open complete
+                    is_connecting = !is_connected;
+                }
+            }
+            else if ((socket_io_instance->socket = socket(AF_UNIX, SOCK_STREAM, 0)) < SOCKET_SUCCESS)
+            {
+                LogError("Failure: socket create failure %d.", socket_io_instance->socket);
                 result = __FAILURE__;
-                break;
             }
-            else if (ioctl(socket, SIOCGIFADDR, &ifr) != 0)
+#ifndef __APPLE__
+            else if (socket_io_instance->target_mac_address != NULL &&
+                     set_target_network_interface(socket_io_instance->socket, socket_io_instance->target_mac_address) != 0)
+            {
+                LogError("Failure: failed selecting target network interface (MACADDR=%s).", socket_io_instance->target_mac_address);
+                result = __FAILURE__;
+            }
+#endif //__APPLE__
+            else if ((result = initiate_unix_socket_connection(socket_io_instance)) != 0)
+            {
+                LogError("initiate_unix_socket_connection failed");
+            }
+            else if ((result = wait_for_connection(socket_io_instance)) != 0)
+            {
+                LogError("wait_for_connection failed");
+            }
+
+            if ((result == 0) && !is_connecting && ((result = register_with_socket_reactor(socket_io_instance)) != 0))
+            {
+                LogError("register_with_socket_reactor failed");
+            }
+
+            if (result == 0)
+            {
+                socket_io_instance->on_bytes_received = on_bytes_received;
+                socket_io_instance->on_bytes_received_context = on_bytes_received_context;
+
+                socket_io_instance->on_io_error = on_io_error;
+                socket_io_instance->on_io_error_context = on_io_error_context;
+
+                if (is_connecting)
+                {
+                    socket_io_instance->on_io_open_complete = on_io_open_complete;
+                    socket_io_instance->on_io_open_complete_context = on_io_open_complete_context;
+                    socket_io_instance->io_state = IO_STATE_OPENING;
+                }
+                else
+                {
+                    socket_io_instance->io_state = IO_STATE_OPEN;
+                }
+            }
+            else
+            {
+                if (socket_io_instance->socket >= SOCKET_SUCCESS)
+                {
+                    close(socket_io_instance->socket);
+                }
+                socket_io_instance->socket = INVALID_SOCKET;
+            }
+        }
+    }
+
+    if ((on_io_open_complete != NULL) && !is_connecting)
+    {
+        on_io_open_complete(on_io_open_complete_context, result == 0 ? IO_OPEN_OK : IO_OPEN_ERROR);
+    }
+
+    return result;
+}
+
+int socketio_close(CONCRETE_IO_HANDLE socket_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    int result = 0;
+
+    if (socket_io == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        if ((socket_io_instance->io_state != IO_STATE_CLOSED) && (socket_io_instance->io_state != IO_STATE_CLOSING))
+        {
+            // Only close if the socket isn't already in the closed or closing state
+            bool was_opening = (socket_io_instance->io_state == IO_STATE_OPENING);
+
+            unregister_from_socket_reactor(socket_io_instance);
+            close_connection_attempts(socket_io_instance);
+            (void)shutdown(socket_io_instance->socket, SHUT_RDWR);
+            close(socket_io_instance->socket);
+            socket_io_instance->socket = INVALID_SOCKET;
+            socket_io_instance->io_state = IO_STATE_CLOSED;
+            cancel_zerocopy_sends(socket_io_instance);
+
+            if (was_opening)
+            {
+                indicate_open_complete(socket_io_instance, IO_OPEN_CANCELLED);
+            }
+        }
+
+        socket_io_instance->lent_recv_bytes = NULL;
+        socket_io_instance->lent_recv_size = 0;
+
+        if (on_io_close_complete != NULL)
+        {
+            on_io_close_complete(callback_context);
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+int socketio_send(CONCRETE_IO_HANDLE socket_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    if ((socket_io == NULL) ||
+        (buffer == NULL) ||
+        (size == 0))
+    {
+        /* Invalid arguments */
+        LogError("Invalid argument: send given invalid parameter");
+        result = __FAILURE__;
+    }
+    else
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        if (socket_io_instance->io_state != IO_STATE_OPEN)
+        {
+            LogError("Failure: socket state is not opened.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            if (socket_io_instance->pending_io_count > 0)
+            {
+                if (add_pending_io(socket_io_instance, buffer, size, on_send_complete, callback_context) != 0)
+                {
+                    LogError("Failure: add_pending_io failed.");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = 0;
+                }
+            }
+            else
+            {
+                signal(SIGPIPE, SIG_IGN);
+
+                ssize_t send_result = send_bytes(socket_io_instance, buffer, size, 0);
+                if ((send_result < 0) || ((size_t)send_result != size))
+                {
+                    if (send_result == INVALID_SOCKET)
+                    {
+                        if (errno == EAGAIN) /*send says "come back later" with EAGAIN - likely the socket buffer cannot accept more data*/
+                        {
+                            /* queue everything, the next dowork will retry */
+                            if (add_pending_io(socket_io_instance, buffer, size, on_send_complete, callback_context) != 0)
+                            {
+                                LogError("Failure: add_pending_io failed.");
+                                result = __FAILURE__;
+                            }
+                            else
+                            {
+                                result = 0;
+                            }
+                        }
+                        else
+                        {
+                            LogError("Failure: sending socket failed. errno=%d (%s).", errno, strerror(errno));
+                            result = __FAILURE__;
+                        }
+                    }
+                    else
+                    {
+                        /* queue data */
+                        if (add_pending_io(socket_io_instance, buffer + send_result, size - send_result, on_send_complete, callback_context) != 0)
+                        {
+                            LogError("Failure: add_pending_io failed.");
+                            result = __FAILURE__;
+                        }
+                        else
+                        {
+                            result = 0;
+                        }
+                    }
+                }
+                else
+                {
+                    indicate_send_complete(socket_io_instance, on_send_complete, callback_context);
+
+                    result = 0;
+                }
+            }
+
+            if (result == 0)
+            {
+                count_send(socket_io_instance, size);
+            }
+        }
+    }
+
+    return result;
+}
+
+int socketio_send_constbuffer(CONCRETE_IO_HANDLE socket_io, CONSTBUFFER_HANDLE buffer_handle, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+    const CONSTBUFFER* content;
+
+    if ((socket_io == NULL) ||
+        (buffer_handle == NULL) ||
+        ((content = CONSTBUFFER_GetContent(buffer_handle)) == NULL) ||
+        (content->size == 0))
+    {
+        /* Invalid arguments */
+        LogError("Invalid argument: send_constbuffer given invalid parameter");
+        result = __FAILURE__;
+    }
+    else
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        if (socket_io_instance->io_state != IO_STATE_OPEN)
+        {
+            LogError("Failure: socket state is not opened.");
+            result = __FAILURE__;
+        }
+        else if ((socket_io_instance->pending_io_count > 0) || use_zerocopy(socket_io_instance, content->size))
+        {
+            /* a zero copy send goes through the queue, which keeps the reference until the kernel releases the buffer */
+            bool is_first = (socket_io_instance->pending_io_count == 0);
+            bool sent_part_of_a_send;
+
+            if (add_pending_constbuffer(socket_io_instance, buffer_handle, 0, on_send_complete, callback_context) != 0)
+            {
+                LogError("Failure: add_pending_constbuffer failed.");
+                result = __FAILURE__;
+            }
+            else
+            {
+                if (is_first)
+                {
+                    /* a socket error is left for dowork to indicate */
+                    (void)send_pending_ios(socket_io_instance, &sent_part_of_a_send);
+                }
+                result = 0;
+            }
+        }
+        else
+        {
+            signal(SIGPIPE, SIG_IGN);
+
+            ssize_t send_result = send_bytes(socket_io_instance, content->buffer, content->size, 0);
+            if ((send_result < 0) && (errno != EAGAIN))
             {
-                LogError("ioctl failed querying socket (SIOCGIFADDR, errno=%d)", errno);
+                LogError("Failure: sending socket failed. errno=%d (%s).", errno, strerror(errno));
                 result = __FAILURE__;
-                break;
             }
-            else if ((new_nid = create_network_interface_description(&ifr, new_nid)) == NULL)
+            else if ((send_result < 0) || ((size_t)send_result != content->size))
             {
-                LogError("Failed creating network interface description");
-                result = __FAILURE__;
-                break;
+                /* queue a reference on what the socket did not take */
+                if (add_pending_constbuffer(socket_io_instance, buffer_handle, (send_result < 0) ? 0 : (size_t)send_result, on_send_complete, callback_context) != 0)
+                {
+                    LogError("Failure: add_pending_constbuffer failed.");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = 0;
+                }
             }
-            else if (root_nid == NULL)
+            else
             {
-                root_nid = new_nid;
+                indicate_send_complete(socket_io_instance, on_send_complete, callback_context);
+
+                result = 0;
             }
         }
 
         if (result == 0)
         {
-            *nid = root_nid;
-        }
-        else
-        {
-            destroy_network_interface_descriptions(root_nid);
+            count_send(socket_io_instance, content->size);
         }
     }
 
     return result;
 }
 
-static int set_target_network_interface(int socket, char* mac_address)
+/* sends the buffers in batches of at most SOCKETIO_SENDV_MAX_BUFFERS, as long as the socket takes them; returns the result of the last sendmsg */
+static ssize_t send_buffers(SOCKET_IO_INSTANCE* socket_io_instance, const XIO_BUFFER* buffers, size_t buffer_count, size_t* sent_size)
 {
-    int result;
-    NETWORK_INTERFACE_DESCRIPTION* nid;
+    struct iovec iov[SOCKETIO_SENDV_MAX_BUFFERS];
+    size_t next_buffer = 0;
+    ssize_t send_result = 0;
 
-    if (get_network_interface_descriptions(socket, &nid) != 0)
-    {
-        LogError("Failed getting network interface descriptions");
-        result = __FAILURE__;
-    }
-    else
+    *sent_size = 0;
+
+    while (next_buffer < buffer_count)
     {
-        NETWORK_INTERFACE_DESCRIPTION* current_nid = nid;
+        struct msghdr msg;
+        size_t batch_size = 0;
+        size_t iov_count = 0;
+#ifdef XIO_STATS_TIMING
+        uint64_t start_time_us;
+#endif
 
-        while(current_nid != NULL)
+        while ((next_buffer < buffer_count) && (iov_count < SOCKETIO_SENDV_MAX_BUFFERS))
         {
-            if (strcmp(mac_address, current_nid->mac_address) == 0)
+            if (buffers[next_buffer].size > 0)
             {
-                break;
+                iov[iov_count].iov_base = (void*)buffers[next_buffer].buffer;
+                iov[iov_count].iov_len = buffers[next_buffer].size;
+                batch_size += buffers[next_buffer].size;
+                iov_count++;
             }
+            next_buffer++;
+        }
 
-            current_nid = current_nid->next;
+        if (iov_count == 0)
+        {
+            break;
         }
 
-        if (current_nid == NULL)
+        (void)memset(&msg, 0, sizeof(msg));
+        msg.msg_iov = iov;
+        msg.msg_iovlen = iov_count;
+
+#ifdef XIO_STATS_TIMING
+        start_time_us = xio_stats_get_time_us();
+#endif
+        send_result = sendmsg(socket_io_instance->socket, &msg, 0);
+#ifdef XIO_STATS_TIMING
+        socket_io_instance->stats.time_us += xio_stats_get_time_us() - start_time_us;
+#endif
+        if (send_result > 0)
         {
-            LogError("Did not find a network interface matching MAC ADDRESS");
-            result = __FAILURE__;
+            *sent_size += (size_t)send_result;
         }
-        else if (setsockopt(socket, SOL_SOCKET, SO_BINDTODEVICE, current_nid->name, strlen(current_nid->name)) != 0)
+
+        if ((send_result < 0) || ((size_t)send_result != batch_size))
         {
-            LogError("setsockopt failed (%d)", errno);
-            result = __FAILURE__;
+            break;
         }
-        else
+    }
+
+    return send_result;
+}
+
+/* same as send_buffers, for the buffers of constbuffer_array */
+static ssize_t send_constbuffer_array_buffers(SOCKET_IO_INSTANCE* socket_io_instance, CONSTBUFFER_ARRAY_HANDLE constbuffer_array, uint32_t buffer_count, size_t* sent_size)
+{
+    XIO_BUFFER buffers[SOCKETIO_SENDV_MAX_BUFFERS];
+    uint32_t next_buffer = 0;
+    ssize_t send_result = 0;
+
+    *sent_size = 0;
+
+    while (next_buffer < buffer_count)
+    {
+        size_t batch_count = 0;
+        size_t batch_size = 0;
+        size_t batch_sent_size;
+
+        while ((next_buffer < buffer_count) && (batch_count < SOCKETIO_SENDV_MAX_BUFFERS))
         {
-            result = 0;
+            const CONSTBUFFER* content = constbuffer_array_get_buffer_content(constbuffer_array, next_buffer);
+            buffers[batch_count].buffer = content->buffer;
+            buffers[batch_count].size = content->size;
+            batch_size += content->size;
+            batch_count++;
+            next_buffer++;
         }
 
-        destroy_network_interface_descriptions(nid);
+        send_result = send_buffers(socket_io_instance, buffers, batch_count, &batch_sent_size);
+        *sent_size += batch_sent_size;
+
+        if ((send_result < 0) || (batch_sent_size != batch_size))
+        {
+            break;
+        }
     }
 
-    return result;
+    return send_result;
 }
-#endif //__APPLE__
 
-CONCRETE_IO_HANDLE socketio_create(void* io_create_parameters)
+static int socketio_sendv(CONCRETE_IO_HANDLE socket_io, const XIO_BUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* callback_context)
 {
-    SOCKETIO_CONFIG* socket_io_config = io_create_parameters;
-    SOCKET_IO_INSTANCE* result;
+    int result;
+    size_t total_size = 0;
+    size_t i;
 
-    if (socket_io_config == NULL)
+    if ((socket_io == NULL) ||
+        (buffers == NULL) ||
+        (buffer_count == 0))
     {
-        LogError("Invalid argument: socket_io_config is NULL");
-        result = NULL;
+        /* Invalid arguments */
+        LogError("Invalid argument: sendv given invalid parameter");
+        result = __FAILURE__;
     }
     else
     {
-        result = malloc(sizeof(SOCKET_IO_INSTANCE));
-        if (result != NULL)
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+
+        for (i = 0; i < buffer_count; i++)
         {
-            result->address_type = ADDRESS_TYPE_IP;
-            result->pending_io_list = singlylinkedlist_create();
-            if (result->pending_io_list == NULL)
+            total_size += buffers[i].size;
+        }
+
+        if (total_size == 0)
+        {
+            LogError("Invalid argument: sendv given no bytes to send");
+            result = __FAILURE__;
+        }
+        else if (socket_io_instance->io_state != IO_STATE_OPEN)
+        {
+            LogError("Failure: socket state is not opened.");
+            result = __FAILURE__;
+        }
+        else if (socket_io_instance->pending_io_count > 0)
+        {
+            if (add_pending_io_from_buffers(socket_io_instance, buffers, buffer_count, 0, on_send_complete, callback_context) != 0)
             {
-                LogError("Failure: singlylinkedlist_create unable to create pending list.");
-                free(result);
-                result = NULL;
+                LogError("Failure: add_pending_io_from_buffers failed.");
+                result = __FAILURE__;
             }
             else
             {
-                if (socket_io_config->hostname != NULL)
-                {
-                    result->hostname = (char*)malloc(strlen(socket_io_config->hostname) + 1);
-                    if (result->hostname != NULL)
-                    {
-                        (void)strcpy(result->hostname, socket_io_config->hostname);
-                    }
+                result = 0;
+            }
+        }
+        else
+        {
+            size_t sent_size;
+            ssize_t send_result;
 
-                    result->socket = INVALID_SOCKET;
-                }
-                else
-                {
-                    result->hostname = NULL;
-                    result->socket = *((int*)socket_io_config->accepted_socket);
-                }
+            signal(SIGPIPE, SIG_IGN);
 
-                if ((result->hostname == NULL) && (result->socket == INVALID_SOCKET))
+            send_result = send_buffers(socket_io_instance, buffers, buffer_count, &sent_size);
+            if ((send_result < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK))
+            {
+                LogError("Failure: sending socket failed. errno=%d (%s).", errno, strerror(errno));
+                result = __FAILURE__;
+            }
+            else if (sent_size < total_size)
+            {
+                /* queue what the socket did not take */
+                if (add_pending_io_from_buffers(socket_io_instance, buffers, buffer_count, sent_size, on_send_complete, callback_context) != 0)
                 {
-                    LogError("Failure: hostname == NULL and socket is invalid.");
-                    singlylinkedlist_destroy(result->pending_io_list);
-                    free(result);
-                    result = NULL;
+                    LogError("Failure: add_pending_io_from_buffers failed.");
+                    result = __FAILURE__;
                 }
                 else
                 {
-                    result->port = socket_io_config->port;
-                    result->target_mac_address = NULL;
-                    result->on_bytes_received = NULL;
-                    result->on_io_error = NULL;
-                    result->on_bytes_received_context = NULL;
-                    result->on_io_error_context = NULL;
-                    result->io_state = IO_STATE_CLOSED;
+                    result = 0;
                 }
             }
+            else
+            {
+                indicate_send_complete(socket_io_instance, on_send_complete, callback_context);
+
+                result = 0;
+            }
         }
-        else
+
+        if (result == 0)
         {
-            LogError("Allocation Failure: SOCKET_IO_INSTANCE");
+            count_send(socket_io_instance, total_size);
         }
     }
 
     return result;
 }
 
-void socketio_destroy(CONCRETE_IO_HANDLE socket_io)
+static bool has_zerocopy_buffer(SOCKET_IO_INSTANCE* socket_io_instance, CONSTBUFFER_ARRAY_HANDLE constbuffer_array, uint32_t buffer_count)
 {
-    if (socket_io != NULL)
-    {
-        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
-        /* we cannot do much if the close fails, so just ignore the result */
-        if (socket_io_instance->socket != INVALID_SOCKET)
-        {
-            close(socket_io_instance->socket);
-        }
+    bool result = false;
+    uint32_t i;
 
-        /* clear allpending IOs */
-        LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
-        while (first_pending_io != NULL)
-        {
-            PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
-            if (pending_socket_io != NULL)
-            {
-                free(pending_socket_io->bytes);
-                free(pending_socket_io);
-            }
-
-            (void)singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io);
-            first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
-        }
-
-        singlylinkedlist_destroy(socket_io_instance->pending_io_list);
-        free(socket_io_instance->hostname);
-        free(socket_io_instance->target_mac_address);
-        free(socket_io);
+    for (i = 0; (i < buffer_count) && !result; i++)
+    {
+        result = use_zerocopy(socket_io_instance, constbuffer_array_get_buffer_content(constbuffer_array, i)->size);
     }
+
+    return result;
 }
 
-int socketio_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+int socketio_send_constbuffer_array(CONCRETE_IO_HANDLE socket_io, CONSTBUFFER_ARRAY_HANDLE constbuffer_array, ON_SEND_COMPLETE on_send_complete, void* callback_context)
 {
     int result;
+    uint32_t buffer_count;
+    uint32_t total_size;
 
-    SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
-    if (socket_io == NULL)
+    if ((socket_io == NULL) ||
+        (constbuffer_array == NULL) ||
+        (constbuffer_array_get_buffer_count(constbuffer_array, &buffer_count) != 0) ||
+        (constbuffer_array_get_all_buffers_size(constbuffer_array, &total_size) != 0) ||
+        (total_size == 0))
     {
-        LogError("Invalid argument: SOCKET_IO_INSTANCE is NULL");
+        /* Invalid arguments */
+        LogError("Invalid argument: send_constbuffer_array given invalid parameter");
         result = __FAILURE__;
     }
     else
     {
-        if (socket_io_instance->io_state != IO_STATE_CLOSED)
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        if (socket_io_instance->io_state != IO_STATE_OPEN)
         {
-            LogError("Failure: socket state is not closed.");
+            LogError("Failure: socket state is not opened.");
             result = __FAILURE__;
         }
-        else if (socket_io_instance->socket != INVALID_SOCKET)
+        else if ((socket_io_instance->pending_io_count > 0) || has_zerocopy_buffer(socket_io_instance, constbuffer_array, buffer_count))
         {
-            // Opening an accepted socket
-            socket_io_instance->on_bytes_received_context = on_bytes_received_context;
-            socket_io_instance->on_bytes_received = on_bytes_received;
-            socket_io_instance->on_io_error = on_io_error;
-            socket_io_instance->on_io_error_context = on_io_error_context;
+            /* the buffers large enough for zero copy are sent one by one through the queue instead of gathered */
+            bool is_first = (socket_io_instance->pending_io_count == 0);
+            bool sent_part_of_a_send;
 
-            socket_io_instance->io_state = IO_STATE_OPEN;
-
-            result = 0;
+            if (add_pending_constbuffer_array(socket_io_instance, constbuffer_array, buffer_count, 0, on_send_complete, callback_context) != 0)
+            {
+                LogError("Failure: add_pending_constbuffer_array failed.");
+                result = __FAILURE__;
+            }
+            else
+            {
+                if (is_first)
+                {
+                    /* a socket error is left for dowork to indicate */
+                    (void)send_pending_ios(socket_io_instance, &sent_part_of_a_send);
+                }
+                result = 0;
+            }
         }
         else
         {
-            socket_io_instance->socket = socket (socket_io_instance->address_type == ADDRESS_TYPE_IP ? AF_INET : AF_UNIX, SOCK_STREAM, 0);
-            if (socket_io_instance->socket < SOCKET_SUCCESS)
+            size_t sent_size;
+            ssize_t send_result;
+
+            signal(SIGPIPE, SIG_IGN);
+
+            send_result = send_constbuffer_array_buffers(socket_io_instance, constbuffer_array, buffer_count, &sent_size);
+            if ((send_result < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK))
             {
-                LogError("Failure: socket create failure %d.", socket_io_instance->socket);
+                LogError("Failure: sending socket failed. errno=%d (%s).", errno, strerror(errno));
                 result = __FAILURE__;
             }
-#ifndef __APPLE__
-            else if (socket_io_instance->target_mac_address != NULL &&
-                     set_target_network_interface(socket_io_instance->socket, socket_io_instance->target_mac_address) != 0)
+            else if (sent_size < total_size)
             {
-                LogError("Failure: failed selecting target network interface (MACADDR=%s).", socket_io_instance->target_mac_address);
-                result = __FAILURE__;
+                /* queue references on what the socket did not take */
+                if (add_pending_constbuffer_array(socket_io_instance, constbuffer_array, buffer_count, sent_size, on_send_complete, callback_context) != 0)
+                {
+                    LogError("Failure: add_pending_constbuffer_array failed.");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = 0;
+                }
             }
-#endif //__APPLE__
-            else if ((result = lookup_address_and_initiate_socket_connection(socket_io_instance)) != 0)
+            else
             {
-                LogError("lookup_address_and_connect_socket failed");
+                indicate_send_complete(socket_io_instance, on_send_complete, callback_context);
+
+                result = 0;
             }
-            else if ((result = wait_for_connection(socket_io_instance)) != 0)
+        }
+
+        if (result == 0)
+        {
+            count_send(socket_io_instance, total_size);
+        }
+    }
+
+    return result;
+}
+
+/* returns whether bytes moved on the socket or a callback was made */
+/* returns true when the open completed, successfully or not */
+static bool continue_opening(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    bool result;
+    bool is_connected;
+
+    if (continue_connecting(socket_io_instance, &is_connected) != 0)
+    {
+        LogError("continue_connecting failed");
+        socket_io_instance->io_state = IO_STATE_CLOSED;
+        indicate_open_complete(socket_io_instance, IO_OPEN_ERROR);
+        result = true;
+    }
+    else if (!is_connected)
+    {
+        result = false;
+    }
+    else if (register_with_socket_reactor(socket_io_instance) != 0)
+    {
+        LogError("register_with_socket_reactor failed");
+        close(socket_io_instance->socket);
+        socket_io_instance->socket = INVALID_SOCKET;
+        socket_io_instance->io_state = IO_STATE_CLOSED;
+        indicate_open_complete(socket_io_instance, IO_OPEN_ERROR);
+        result = true;
+    }
+    else
+    {
+        socket_io_instance->io_state = IO_STATE_OPEN;
+        indicate_open_complete(socket_io_instance, IO_OPEN_OK);
+        result = true;
+    }
+
+    return result;
+}
+
+static bool dowork_socket(CONCRETE_IO_HANDLE socket_io)
+{
+    bool result = false;
+
+    if (socket_io != NULL)
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        unsigned int ready_events = take_ready_events(socket_io_instance);
+        uint64_t callback_count = socket_io_instance->stats.callback_count;
+        uint64_t bytes_received = socket_io_instance->stats.bytes_received;
+        bool sent_part_of_a_send = false;
+        bool open_completed = false;
+
+        socket_io_instance->stats.dowork_count++;
+
+        if (socket_io_instance->io_state == IO_STATE_OPENING)
+        {
+            open_completed = continue_opening(socket_io_instance);
+            if (open_completed && (socket_io_instance->io_state == IO_STATE_OPEN))
             {
-                LogError("wait_for_connection failed");
+                /* a freshly connected socket is assumed ready */
+                ready_events = SOCKET_REACTOR_EVENT_READABLE | SOCKET_REACTOR_EVENT_WRITABLE;
             }
+        }
 
-            if (result == 0)
+        if ((socket_io_instance->zerocopy_send_count > 0) && (socket_io_instance->socket != INVALID_SOCKET))
+        {
+            /* the notifications wake the reactor as an error event */
+            receive_zerocopy_notifications(socket_io_instance);
+        }
+
+        if ((ready_events & SOCKET_REACTOR_EVENT_WRITABLE) != 0)
+        {
+            while (send_pending_ios(socket_io_instance, &sent_part_of_a_send) != 0)
             {
-                socket_io_instance->on_bytes_received = on_bytes_received;
-                socket_io_instance->on_bytes_received_context = on_bytes_received_context;
+                pop_pending_io(socket_io_instance);
+                indicate_error(socket_io_instance);
+            }
+        }
+
+        if ((socket_io_instance->io_state == IO_STATE_OPEN) &&
+            ((ready_events & SOCKET_REACTOR_EVENT_READABLE) != 0))
+        {
+            ssize_t received = 0;
+            size_t drained = 0;
+            do
+            {
+                unsigned char* received_bytes;
+
+                received = receive_bytes(socket_io_instance, &received_bytes);
+                if (received > 0)
+                {
+                    drained += (size_t)received;
+                    socket_io_instance->stats.bytes_received += (uint64_t)received;
+
+                    if (socket_io_instance->on_bytes_received != NULL)
+                    {
+                        socket_io_instance->stats.callback_count++;
+
+                        /* Explicitly ignoring here the result of the callback */
+                        (void)socket_io_instance->on_bytes_received(socket_io_instance->on_bytes_received_context, received_bytes, received);
+                    }
+                }
+                else if (received == 0)
+                {
+                    // Do not log error here due to this is probably the socket being closed on the other end
+                    indicate_error(socket_io_instance);
+                }
+                else if (received < 0 && errno != EAGAIN)
+                {
+                    LogError("Socketio_Failure: Receiving data from endpoint: errno=%d.", errno);
+                    indicate_error(socket_io_instance);
+                }
 
-                socket_io_instance->on_io_error = on_io_error;
-                socket_io_instance->on_io_error_context = on_io_error_context;
+            } while (received > 0 && socket_io_instance->io_state == IO_STATE_OPEN &&
+                (socket_io_instance->receive_drain_limit == 0 || drained < socket_io_instance->receive_drain_limit));
 
-                socket_io_instance->io_state = IO_STATE_OPEN;
-            }
-            else
+            if (received > 0)
             {
-                if (socket_io_instance->socket >= SOCKET_SUCCESS)
-                {
-                    close(socket_io_instance->socket);
-                }
-                socket_io_instance->socket = INVALID_SOCKET;
+                /* the socket was not drained (or the drain limit was hit), no new edge will be reported for the remaining bytes */
+                restore_ready_events(socket_io_instance, SOCKET_REACTOR_EVENT_READABLE);
             }
         }
-    }
 
-    if (on_io_open_complete != NULL)
-    {
-        on_io_open_complete(on_io_open_complete_context, result == 0 ? IO_OPEN_OK : IO_OPEN_ERROR);
+        if (socket_io_instance->stats.callback_count == callback_count)
+        {
+            socket_io_instance->stats.idle_dowork_count++;
+        }
+
+        result = (socket_io_instance->stats.callback_count != callback_count) ||
+            (socket_io_instance->stats.bytes_received != bytes_received) ||
+            sent_part_of_a_send ||
+            open_completed;
     }
 
     return result;
 }
 
-int socketio_close(CONCRETE_IO_HANDLE socket_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
 {
-    int result = 0;
+    (void)dowork_socket(socket_io);
+}
 
-    if (socket_io == NULL)
+static int socketio_dowork_ex(CONCRETE_IO_HANDLE socket_io, bool* made_progress, uint64_t* next_deadline_us)
+{
+    int result;
+
+    if ((socket_io == NULL) ||
+        (made_progress == NULL) ||
+        (next_deadline_us == NULL))
     {
+        LogError("Invalid argument: socket_io=%p, made_progress=%p, next_deadline_us=%p", socket_io, made_progress, next_deadline_us);
         result = __FAILURE__;
     }
     else
     {
         SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
-        if ((socket_io_instance->io_state != IO_STATE_CLOSED) && (socket_io_instance->io_state != IO_STATE_CLOSING))
-        {
-            // Only close if the socket isn't already in the closed or closing state
-            (void)shutdown(socket_io_instance->socket, SHUT_RDWR);
-            close(socket_io_instance->socket);
-            socket_io_instance->socket = INVALID_SOCKET;
-            socket_io_instance->io_state = IO_STATE_CLOSED;
-        }
-
-        if (on_io_close_complete != NULL)
-        {
-            on_io_close_complete(callback_context);
-        }
 
+        *made_progress = dowork_socket(socket_io);
+        /* only a connection in progress has timers, otherwise the readiness is waited for through the socket reactor */
+        *next_deadline_us = (socket_io_instance->io_state == IO_STATE_OPENING) ? get_connect_deadline(socket_io_instance) : XIO_NO_DEADLINE;
         result = 0;
     }
 
     return result;
 }
 
-int socketio_send(CONCRETE_IO_HANDLE socket_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+static int socketio_get_pollable_handle(CONCRETE_IO_HANDLE socket_io, intptr_t* pollable_handle, unsigned int* wanted_events)
 {
     int result;
 
     if ((socket_io == NULL) ||
-        (buffer == NULL) ||
-        (size == 0))
+        (pollable_handle == NULL) ||
+        (wanted_events == NULL))
     {
-        /* Invalid arguments */
-        LogError("Invalid argument: send given invalid parameter");
+        LogError("Invalid argument: socket_io=%p, pollable_handle=%p, wanted_events=%p", socket_io, pollable_handle, wanted_events);
         result = __FAILURE__;
     }
     else
     {
         SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
-        if (socket_io_instance->io_state != IO_STATE_OPEN)
+
+        if (socket_io_instance->io_state == IO_STATE_OPENING)
         {
-            LogError("Failure: socket state is not opened.");
+            size_t i = socket_io_instance->connect->started_count;
+
+            /* the latest connection attempt, get_connect_deadline makes sure the others are checked too */
+            while ((i > 0) && (socket_io_instance->connect->attempts[i - 1] == INVALID_SOCKET))
+            {
+                i--;
+            }
+
+            if (i == 0)
+            {
+                LogError("Failure: no connection attempt in progress.");
+                result = __FAILURE__;
+            }
+            else
+            {
+                *pollable_handle = (intptr_t)socket_io_instance->connect->attempts[i - 1];
+                *wanted_events = XIO_POLL_WRITABLE;
+                result = 0;
+            }
+        }
+        else if (socket_io_instance->socket == INVALID_SOCKET)
+        {
+            LogError("Failure: the socket is not open.");
             result = __FAILURE__;
         }
         else
         {
-            LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
-            if (first_pending_io != NULL)
+            *pollable_handle = (intptr_t)socket_io_instance->socket;
+            *wanted_events = 0;
+            if (socket_io_instance->io_state == IO_STATE_OPEN)
             {
-                if (add_pending_io(socket_io_instance, buffer, size, on_send_complete, callback_context) != 0)
-                {
-                    LogError("Failure: add_pending_io failed.");
-                    result = __FAILURE__;
-                }
-                else
-                {
-                    result = 0;
-                }
+                *wanted_events |= XIO_POLL_READABLE;
             }
-            else
+            if (socket_io_instance->pending_io_count > 0)
             {
-                signal(SIGPIPE, SIG_IGN);
-
-                ssize_t send_result = send(socket_io_instance->socket, buffer, size, 0);
-                if ((send_result < 0) || ((size_t)send_result != size))
-                {
-                    if (send_result == INVALID_SOCKET)
-                    {
-                        if (errno == EAGAIN) /*send says "come back later" with EAGAIN - likely the socket buffer cannot accept more data*/
-                        {
-                            /*do nothing*/
-                            result = 0;
-                        }
-                        else
-                        {
-                            LogError("Failure: sending socket failed. errno=%d (%s).", errno, strerror(errno));
-                            result = __FAILURE__;
-                        }
-                    }
-                    else
-                    {
-                        /* queue data */
-                        if (add_pending_io(socket_io_instance, buffer + send_result, size - send_result, on_send_complete, callback_context) != 0)
-                        {
-                            LogError("Failure: add_pending_io failed.");
-                            result = __FAILURE__;
-                        }
-                        else
-                        {
-                            result = 0;
-                        }
-                    }
-                }
-                else
-                {
-                    if (on_send_complete != NULL)
-                    {
-                        on_send_complete(callback_context, IO_SEND_OK);
-                    }
-
-                    result = 0;
-                }
+                *wanted_events |= XIO_POLL_WRITABLE;
             }
+            result = 0;
         }
     }
 
     return result;
 }
 
-void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
+static int socketio_set_receive_buffer(CONCRETE_IO_HANDLE socket_io, unsigned char* buffer, size_t size)
 {
-    if (socket_io != NULL)
+    int result;
+
+    if (socket_io == NULL)
+    {
+        LogError("Invalid argument: socket_io is NULL");
+        result = __FAILURE__;
+    }
+    else
     {
         SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
-        LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
-        while (first_pending_io != NULL)
-        {
-            PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
-            if (pending_socket_io == NULL)
-            {
-                indicate_error(socket_io_instance);
-                LogError("Failure: retrieving socket from list");
-                break;
-            }
 
-            signal(SIGPIPE, SIG_IGN);
-
-            ssize_t send_result = send(socket_io_instance->socket, pending_socket_io->bytes, pending_socket_io->size, 0);
-            if ((send_result < 0) || ((size_t)send_result != pending_socket_io->size))
-            {
-                if (send_result == INVALID_SOCKET)
-                {
-                    if (errno == EAGAIN) /*send says "come back later" with EAGAIN - likely the socket buffer cannot accept more data*/
-                    {
-                        /*do nothing until next dowork */
-                        break;
-                    }
-                    else
-                    {
-                        free(pending_socket_io->bytes);
-                        free(pending_socket_io);
-                        (void)singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io);
-
-                        LogError("Failure: sending Socket information. errno=%d (%s).", errno, strerror(errno));
-                        indicate_error(socket_io_instance);
-                    }
-                }
-                else
-                {
-                    /* simply wait until next dowork */
-                    (void)memmove(pending_socket_io->bytes, pending_socket_io->bytes + send_result, pending_socket_io->size - send_result);
-                    pending_socket_io->size -= send_result;
-                    break;
-                }
-            }
-            else
-            {
-                if (pending_socket_io->on_send_complete != NULL)
-                {
-                    pending_socket_io->on_send_complete(pending_socket_io->callback_context, IO_SEND_OK);
-                }
+        /* the next recv reads into it, whatever socketio_receive_size and socketio_shared_receive_buffer say */
+        socket_io_instance->lent_recv_bytes = buffer;
+        socket_io_instance->lent_recv_size = size;
+        result = 0;
+    }
 
-                free(pending_socket_io->bytes);
-                free(pending_socket_io);
-                if (singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io) != 0)
-                {
-                    indicate_error(socket_io_instance);
-                    LogError("Failure: unable to remove socket from list");
-                }
-            }
+    return result;
+}
 
-            first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
-        }
+static int socketio_get_stats(CONCRETE_IO_HANDLE socket_io, XIO_STATS* stats, size_t stats_count, size_t* layer_count)
+{
+    int result;
 
-        if (socket_io_instance->io_state == IO_STATE_OPEN)
-        {
-            ssize_t received = 0;
-            do
-            {
-                received = recv(socket_io_instance->socket, socket_io_instance->recv_bytes, RECEIVE_BYTES_VALUE, 0);
-                if (received > 0)
-                {
-                    if (socket_io_instance->on_bytes_received != NULL)
-                    {
-                        /* Explicitly ignoring here the result of the callback */
-                        (void)socket_io_instance->on_bytes_received(socket_io_instance->on_bytes_received_context, socket_io_instance->recv_bytes, received);
-                    }
-                }
-                else if (received == 0)
-                {
-                    // Do not log error here due to this is probably the socket being closed on the other end
-                    indicate_error(socket_io_instance);
-                }
-                else if (received < 0 && errno != EAGAIN)
-                {
-                    LogError("Socketio_Failure: Receiving data from endpoint: errno=%d.", errno);
-                    indicate_error(socket_io_instance);
-                }
+    if ((socket_io == NULL) ||
+        (stats == NULL) ||
+        (stats_count == 0) ||
+        (layer_count == NULL))
+    {
+        LogError("Invalid argument: socket_io=%p, stats=%p, stats_count=%lu, layer_count=%p.", socket_io, stats, (unsigned long)stats_count, layer_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
 
-            } while (received > 0 && socket_io_instance->io_state == IO_STATE_OPEN);
-        }
+        /* the socket is the bottom of the stack */
+        stats[0] = socket_io_instance->stats;
+        stats[0].pending_send_count = socket_io_instance->pending_io_count + socket_io_instance->zerocopy_send_count;
+        *layer_count = 1;
+        result = 0;
     }
+
+    return result;
 }
 
 // Edison is missing this from netinet/tcp.h, but this code still works if we manually define it.
@@ -1057,10 +3418,12 @@ static int socketio_setaddresstype_option(SOCKET_IO_INSTANCE* socket_io_instance
 int socketio_setoption(CONCRETE_IO_HANDLE socket_io, const char* optionName, const void* value)
 {
     int result;
+    SOCKET_TUNING_OPTION tuning_option;
 
     if (socket_io == NULL ||
         optionName == NULL ||
-        value == NULL)
+        /* a NULL socket reactor takes the socket off its reactor */
+        (value == NULL && strcmp(optionName, OPTION_SOCKET_REACTOR) != 0))
     {
         result = __FAILURE__;
     }
@@ -1093,26 +3456,37 @@ int socketio_setoption(CONCRETE_IO_HANDLE socket_io, const char* optionName, con
             LogError("option not supported.");
             result = __FAILURE__;
 #else
+            char* target_mac_address;
+
             if (strlen(value) == 0)
             {
                 LogError("option value must be a valid mac address");
                 result = __FAILURE__;
             }
-            else if ((socket_io_instance->target_mac_address = (char*)malloc(sizeof(char) * (strlen(value) + 1))) == NULL)
+            else if ((target_mac_address = (char*)malloc(sizeof(char) * (strlen(value) + 1))) == NULL)
             {
                 LogError("failed setting net_interface_mac_address option (malloc failed)");
                 result = __FAILURE__;
             }
-            else if (strcpy(socket_io_instance->target_mac_address, value) == NULL)
+            else if (strcpy(target_mac_address, value) == NULL)
             {
                 LogError("failed setting net_interface_mac_address option (strcpy failed)");
-                free(socket_io_instance->target_mac_address);
-                socket_io_instance->target_mac_address = NULL;
+                free(target_mac_address);
                 result = __FAILURE__;
             }
             else
             {
-                strtoup(socket_io_instance->target_mac_address);
+                strtoup(target_mac_address);
+                if (socket_io_instance->target_mac_address == NULL)
+                {
+                    // the interface table is kept for as long as a socket IO binds to an interface
+                    acquire_network_interface_cache();
+                }
+                else
+                {
+                    free(socket_io_instance->target_mac_address);
+                }
+                socket_io_instance->target_mac_address = target_mac_address;
                 result = 0;
             }
 #endif
@@ -1121,6 +3495,101 @@ int socketio_setoption(CONCRETE_IO_HANDLE socket_io, const char* optionName, con
         {
             result = socketio_setaddresstype_option(socket_io_instance, (const char*)value);
         }
+        else if (strcmp(optionName, OPTION_SOCKETIO_RECEIVE_SIZE) == 0)
+        {
+            if (*(const size_t*)value == 0)
+            {
+                LogError("option value must be greater than 0");
+                result = __FAILURE__;
+            }
+            else
+            {
+                // the buffer is resized by the next read, it may be in use by the receive callback now
+                socket_io_instance->receive_size = *(const size_t*)value;
+                result = 0;
+            }
+        }
+        else if (strcmp(optionName, OPTION_SOCKETIO_ADAPTIVE_RECEIVE) == 0)
+        {
+            socket_io_instance->adaptive_receive = *(const bool*)value;
+            result = 0;
+        }
+        else if (strcmp(optionName, OPTION_SOCKETIO_SHARED_RECEIVE_BUFFER) == 0)
+        {
+            // the buffer of the socket IO is released by the next read, it may be in use by the receive callback now
+            socket_io_instance->shared_receive_buffer = *(const bool*)value;
+            result = 0;
+        }
+        else if (strcmp(optionName, OPTION_SOCKETIO_RECEIVE_DRAIN_LIMIT) == 0)
+        {
+            socket_io_instance->receive_drain_limit = *(const size_t*)value;
+            result = 0;
+        }
+        else if (strcmp(optionName, OPTION_SOCKETIO_ZEROCOPY_THRESHOLD) == 0)
+        {
+#ifdef SOCKETIO_HAS_ZEROCOPY
+            // the sends already queued keep the mode they were queued with
+            socket_io_instance->zerocopy_threshold = *(const size_t*)value;
+            result = 0;
+#else
+            if (*(const size_t*)value != 0)
+            {
+                LogError("zero copy sends are not supported on this platform");
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+#endif
+        }
+        else if (get_tuning_option(optionName, &tuning_option) == 0)
+        {
+            // kept for the sockets created later, applied right away to the one already there
+            if ((socket_io_instance->socket != INVALID_SOCKET) &&
+                (apply_tuning_option(socket_io_instance->socket, tuning_option, *(const int*)value) != 0))
+            {
+                result = __FAILURE__;
+            }
+            else
+            {
+                socket_io_instance->tuning_values[tuning_option] = *(const int*)value;
+                socket_io_instance->tuning_options_set |= (1u << tuning_option);
+                result = 0;
+            }
+        }
+        else if (strcmp(optionName, OPTION_SOCKET_REACTOR) == 0)
+        {
+            /* an open socket moves to the new reactor, as when its connection migrates to the thread running that reactor */
+            unregister_from_socket_reactor(socket_io_instance);
+            socket_io_instance->socket_reactor = (SOCKET_REACTOR_HANDLE)value;
+
+            if ((socket_io_instance->socket != INVALID_SOCKET) &&
+                ((socket_io_instance->io_state == IO_STATE_OPEN) || (socket_io_instance->io_state == IO_STATE_ERROR)) &&
+                (register_with_socket_reactor(socket_io_instance) != 0))
+            {
+                LogError("Failure moving the socket to the new reactor, it is polled on every dowork instead");
+                socket_io_instance->socket_reactor = NULL;
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+        else if (strcmp(optionName, OPTION_SOCKET_DESCRIPTOR) == 0)
+        {
+            if (socket_io_instance->io_state != IO_STATE_OPEN)
+            {
+                LogError("Socket descriptor can only be queried when in state 'IO_STATE_OPEN'.  Current state=%d", socket_io_instance->io_state);
+                result = __FAILURE__;
+            }
+            else
+            {
+                *(int*)value = socket_io_instance->socket;
+                result = 0;
+            }
+        }
         else
         {
             result = __FAILURE__;
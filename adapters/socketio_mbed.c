@@ -6,7 +6,7 @@
 #include <stdio.h>
 #include <string.h>
 #include "azure_c_shared_utility/socketio.h"
-#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/doublylinkedlist.h"
 #include "azure_c_shared_utility/tcpsocketconnection_c.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
@@ -25,11 +25,11 @@ typedef enum IO_STATE_TAG
 
 typedef struct PENDING_SOCKET_IO_TAG
 {
+    DLIST_ENTRY link;
     unsigned char* bytes;
     size_t size;
     ON_SEND_COMPLETE on_send_complete;
     void* callback_context;
-    SINGLYLINKEDLIST_HANDLE pending_io_list;
 } PENDING_SOCKET_IO;
 
 typedef struct SOCKET_IO_INSTANCE_TAG
@@ -42,7 +42,7 @@ typedef struct SOCKET_IO_INSTANCE_TAG
     char* hostname;
     int port;
     IO_STATE io_state;
-    SINGLYLINKEDLIST_HANDLE pending_io_list;
+    DLIST_ENTRY pending_io_list;
 } SOCKET_IO_INSTANCE;
 
 /*this function will clone an option given by name and value*/
@@ -85,7 +85,13 @@ static const IO_INTERFACE_DESCRIPTION socket_io_interface_description =
     socketio_close,
     socketio_send,
     socketio_dowork,
-    socketio_setoption
+    socketio_setoption,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
 };
 
 static void indicate_error(SOCKET_IO_INSTANCE* socket_io_instance)
@@ -117,19 +123,10 @@ static int add_pending_io(SOCKET_IO_INSTANCE* socket_io_instance, const unsigned
             pending_socket_io->size = size;
             pending_socket_io->on_send_complete = on_send_complete;
             pending_socket_io->callback_context = callback_context;
-            pending_socket_io->pending_io_list = socket_io_instance->pending_io_list;
             (void)memcpy(pending_socket_io->bytes, buffer, size);
 
-            if (singlylinkedlist_add(socket_io_instance->pending_io_list, pending_socket_io) == NULL)
-            {
-                free(pending_socket_io->bytes);
-                free(pending_socket_io);
-                result = __FAILURE__;
-            }
-            else
-            {
-                result = 0;
-            }
+            DList_InsertTailList(&socket_io_instance->pending_io_list, &pending_socket_io->link);
+            result = 0;
         }
     }
 
@@ -150,32 +147,24 @@ CONCRETE_IO_HANDLE socketio_create(void* io_create_parameters)
         result = malloc(sizeof(SOCKET_IO_INSTANCE));
         if (result != NULL)
         {
-            result->pending_io_list = singlylinkedlist_create();
-            if (result->pending_io_list == NULL)
+            DList_InitializeListHead(&result->pending_io_list);
+
+            result->hostname = (char*)malloc(strlen(socket_io_config->hostname) + 1);
+            if (result->hostname == NULL)
             {
                 free(result);
                 result = NULL;
             }
             else
             {
-                result->hostname = (char*)malloc(strlen(socket_io_config->hostname) + 1);
-                if (result->hostname == NULL)
-                {
-                    singlylinkedlist_destroy(result->pending_io_list);
-                    free(result);
-                    result = NULL;
-                }
-                else
-                {
-                    strcpy(result->hostname, socket_io_config->hostname);
-                    result->port = socket_io_config->port;
-                    result->on_bytes_received = NULL;
-                    result->on_io_error = NULL;
-                    result->on_bytes_received_context = NULL;
-                    result->on_io_error_context = NULL;
-                    result->io_state = IO_STATE_CLOSED;
-                    result->tcp_socket_connection = NULL;
-                }
+                strcpy(result->hostname, socket_io_config->hostname);
+                result->port = socket_io_config->port;
+                result->on_bytes_received = NULL;
+                result->on_io_error = NULL;
+                result->on_bytes_received_context = NULL;
+                result->on_io_error_context = NULL;
+                result->io_state = IO_STATE_CLOSED;
+                result->tcp_socket_connection = NULL;
             }
         }
     }
@@ -192,21 +181,13 @@ void socketio_destroy(CONCRETE_IO_HANDLE socket_io)
         tcpsocketconnection_destroy(socket_io_instance->tcp_socket_connection);
 
         /* clear all pending IOs */
-        LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
-        while (first_pending_io != NULL)
+        while (!DList_IsListEmpty(&socket_io_instance->pending_io_list))
         {
-            PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
-            if (pending_socket_io != NULL)
-            {
-                free(pending_socket_io->bytes);
-                free(pending_socket_io);
-            }
-
-            (void)singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io);
-            first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+            PENDING_SOCKET_IO* pending_socket_io = containingRecord(DList_RemoveHeadList(&socket_io_instance->pending_io_list), PENDING_SOCKET_IO, link);
+            free(pending_socket_io->bytes);
+            free(pending_socket_io);
         }
 
-        singlylinkedlist_destroy(socket_io_instance->pending_io_list);
         free(socket_io_instance->hostname);
         free(socket_io);
     }
@@ -316,8 +297,7 @@ int socketio_send(CONCRETE_IO_HANDLE socket_io, const void* buffer, size_t size,
         }
         else
         {
-            LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
-            if (first_pending_io != NULL)
+            if (!DList_IsListEmpty(&socket_io_instance->pending_io_list))
             {
                 if (add_pending_io(socket_io_instance, buffer, size, on_send_complete, callback_context) != 0)
                 {
@@ -373,16 +353,9 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
         {
             int received = 1;
 
-            LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
-            while (first_pending_io != NULL)
+            while (!DList_IsListEmpty(&socket_io_instance->pending_io_list))
             {
-                PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
-                if (pending_socket_io == NULL)
-                {
-                    socket_io_instance->io_state = IO_STATE_ERROR;
-                    indicate_error(socket_io_instance);
-                    break;
-                }
+                PENDING_SOCKET_IO* pending_socket_io = containingRecord(socket_io_instance->pending_io_list.Flink, PENDING_SOCKET_IO, link);
 
                 int send_result = tcpsocketconnection_send(socket_io_instance->tcp_socket_connection, (const char*)pending_socket_io->bytes, pending_socket_io->size);
                 if (send_result != pending_socket_io->size)
@@ -405,6 +378,8 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
                 }
                 else
                 {
+                    (void)DList_RemoveEntryList(&pending_socket_io->link);
+
                     if (pending_socket_io->on_send_complete != NULL)
                     {
                         pending_socket_io->on_send_complete(pending_socket_io->callback_context, IO_SEND_OK);
@@ -412,14 +387,7 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
 
                     free(pending_socket_io->bytes);
                     free(pending_socket_io);
-                    if (singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io) != 0)
-                    {
-                        socket_io_instance->io_state = IO_STATE_ERROR;
-                        indicate_error(socket_io_instance);
-                    }
                 }
-
-                first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
             }
 
             while (received > 0)
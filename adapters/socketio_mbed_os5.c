@@ -5,14 +5,19 @@
 #include <stddef.h>
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
 #include "azure_c_shared_utility/socketio.h"
-#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/doublylinkedlist.h"
 #include "azure_c_shared_utility/tcpsocketconnection_c.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/shared_util_options.h"
 #include "netsocket/nsapi_types.h"
 
-#define MBED_RECEIVE_BYTES_VALUE    128
+/* the default size of the reads, OPTION_SOCKETIO_RECEIVE_SIZE changes it */
+#ifndef MBED_RECEIVE_BYTES_VALUE
+#define MBED_RECEIVE_BYTES_VALUE    512
+#endif
 
 typedef enum IO_STATE_TAG
 {
@@ -25,11 +30,11 @@ typedef enum IO_STATE_TAG
 
 typedef struct PENDING_SOCKET_IO_TAG
 {
+    DLIST_ENTRY link;
     unsigned char* bytes;
     size_t size;
     ON_SEND_COMPLETE on_send_complete;
     void* callback_context;
-    SINGLYLINKEDLIST_HANDLE pending_io_list;
 } PENDING_SOCKET_IO;
 
 typedef struct SOCKET_IO_INSTANCE_TAG
@@ -42,36 +47,72 @@ typedef struct SOCKET_IO_INSTANCE_TAG
     char* hostname;
     int port;
     IO_STATE io_state;
-    SINGLYLINKEDLIST_HANDLE pending_io_list;
+    DLIST_ENTRY pending_io_list;
+    /* set by the sigio callback of the socket, socketio_dowork only reads after it was signalled */
+    volatile bool receive_signalled;
+    unsigned char* receive_buffer;
+    size_t receive_buffer_size;
+    size_t receive_size;
 } SOCKET_IO_INSTANCE;
 
 /*this function will clone an option given by name and value*/
 static void* socketio_CloneOption(const char* name, const void* value)
 {
-    (void)name;
-    (void)value;
-    return NULL;
+    void* result;
+
+    if ((name == NULL) || (value == NULL))
+    {
+        LogError("Failed cloning option (name = %p, value = %p)", name, value);
+        result = NULL;
+    }
+    else if (strcmp(name, OPTION_SOCKETIO_RECEIVE_SIZE) == 0)
+    {
+        if ((result = malloc(sizeof(size_t))) == NULL)
+        {
+            LogError("Failed cloning option %s (malloc failed)", name);
+        }
+        else
+        {
+            *(size_t*)result = *(const size_t*)value;
+        }
+    }
+    else
+    {
+        result = NULL;
+    }
+
+    return result;
 }
 
 /*this function destroys an option previously created*/
 static void socketio_DestroyOption(const char* name, const void* value)
 {
-    (void)name;
-    (void)value;
+    if ((name != NULL) &&
+        (value != NULL) &&
+        (strcmp(name, OPTION_SOCKETIO_RECEIVE_SIZE) == 0))
+    {
+        free((void*)value);
+    }
 }
 
 static OPTIONHANDLER_HANDLE socketio_retrieveoptions(CONCRETE_IO_HANDLE socket_io)
 {
     OPTIONHANDLER_HANDLE result;
-    (void)socket_io;
-    result = OptionHandler_Create(socketio_CloneOption, socketio_DestroyOption, socketio_setoption);
-    if (result == NULL)
+    SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+    if (socket_io_instance == NULL)
+    {
+        result = NULL;
+    }
+    else if ((result = OptionHandler_Create(socketio_CloneOption, socketio_DestroyOption, socketio_setoption)) == NULL)
     {
         /*return as is*/
     }
-    else
+    else if ((socket_io_instance->receive_size != MBED_RECEIVE_BYTES_VALUE) &&
+        (OptionHandler_AddOption(result, OPTION_SOCKETIO_RECEIVE_SIZE, &socket_io_instance->receive_size) != OPTIONHANDLER_OK))
     {
-        /*insert here work to add the options to "result" handle*/
+        LogError("OptionHandler_AddOption failed");
+        OptionHandler_Destroy(result);
+        result = NULL;
     }
     return result;
 }
@@ -85,7 +126,13 @@ static const IO_INTERFACE_DESCRIPTION socket_io_interface_description =
     socketio_close,
     socketio_send,
     socketio_dowork,
-    socketio_setoption
+    socketio_setoption,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
 };
 
 static void indicate_error(SOCKET_IO_INSTANCE* socket_io_instance)
@@ -123,48 +170,60 @@ static int add_pending_io(SOCKET_IO_INSTANCE* socket_io_instance, const unsigned
             pending_socket_io->size = size;
             pending_socket_io->on_send_complete = on_send_complete;
             pending_socket_io->callback_context = callback_context;
-            pending_socket_io->pending_io_list = socket_io_instance->pending_io_list;
             (void)memcpy(pending_socket_io->bytes, buffer, size);
-            if (singlylinkedlist_add(socket_io_instance->pending_io_list, pending_socket_io) == NULL)
-            {
-                free(pending_socket_io->bytes);
-                free(pending_socket_io);
-                result = __FAILURE__;
-            }
-            else
-            {
-                result = 0;
-            }
+
+            DList_InsertTailList(&socket_io_instance->pending_io_list, &pending_socket_io->link);
+            result = 0;
         }
     }
 
     return result;
 }
 
+/* called by the network stack, it only records that the socket has to be read */
+static void on_socket_sigio(void* context)
+{
+    ((SOCKET_IO_INSTANCE*)context)->receive_signalled = true;
+}
+
 static int retrieve_data(SOCKET_IO_INSTANCE* socket_io_instance)
 {
     int received = 1;
     int total_received = 0;
 
-    unsigned char* recv_bytes = malloc(MBED_RECEIVE_BYTES_VALUE);
-    if (recv_bytes == NULL)
+    if (!socket_io_instance->receive_signalled)
     {
-        LogError("Socketio_Failure: NULL allocating input buffer.");
-        indicate_error(socket_io_instance);
-        return -1;
+        /* nothing arrived since the socket was last drained */
+        return 0;
     }
-    
+
+    if (socket_io_instance->receive_buffer_size != socket_io_instance->receive_size)
+    {
+        unsigned char* new_receive_buffer = (unsigned char*)realloc(socket_io_instance->receive_buffer, socket_io_instance->receive_size);
+        if (new_receive_buffer == NULL)
+        {
+            LogError("Socketio_Failure: NULL allocating input buffer.");
+            indicate_error(socket_io_instance);
+            return -1;
+        }
+        socket_io_instance->receive_buffer = new_receive_buffer;
+        socket_io_instance->receive_buffer_size = socket_io_instance->receive_size;
+    }
+
+    /* cleared before reading, so that bytes arriving while the socket is drained signal again */
+    socket_io_instance->receive_signalled = false;
+
     while (received > 0)
     {
         /* Codes_SRS_SOCKETIO_MBED_OS5_99_005: [ retrieve_data shall succeed if tcp receive bytes succeed ]*/
-        received = tcpsocketconnection_receive(socket_io_instance->tcp_socket_connection, (char*)recv_bytes, MBED_RECEIVE_BYTES_VALUE);
+        received = tcpsocketconnection_receive(socket_io_instance->tcp_socket_connection, (char*)socket_io_instance->receive_buffer, (int)socket_io_instance->receive_buffer_size);
         if (received > 0)
         {
             total_received += received;
             if (socket_io_instance->on_bytes_received != NULL)
             {
                 /* explictly ignoring here the result of the callback */
-                socket_io_instance->on_bytes_received(socket_io_instance->on_bytes_received_context, recv_bytes, received);
+                socket_io_instance->on_bytes_received(socket_io_instance->on_bytes_received_context, socket_io_instance->receive_buffer, received);
             }
         }
         else if (received < 0)
@@ -173,13 +232,16 @@ static int retrieve_data(SOCKET_IO_INSTANCE* socket_io_instance)
             {
                 indicate_error(socket_io_instance);
                 LogError("Socketio_Failure: underlying IO error %d.", received);
-                free(recv_bytes);
                 return -1;
             }
         }
+        else
+        {
+            /* 0 is the peer closing the connection, the sigio that came with it is consumed, it has to be seen again */
+            socket_io_instance->receive_signalled = true;
+        }
     }
-    free(recv_bytes);
-    
+
     return total_received;
 }
 
@@ -188,15 +250,9 @@ static int send_queued_data(SOCKET_IO_INSTANCE* socket_io_instance)
     int errors = 0;
     int sent = 0;
     
-    LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
-    while (first_pending_io != NULL)
+    while (!DList_IsListEmpty(&socket_io_instance->pending_io_list))
     {
-        PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
-        if (pending_socket_io == NULL)
-        {
-            indicate_error(socket_io_instance);
-            return -1;
-        }
+        PENDING_SOCKET_IO* pending_socket_io = containingRecord(socket_io_instance->pending_io_list.Flink, PENDING_SOCKET_IO, link);
 
         int send_result = tcpsocketconnection_send(socket_io_instance->tcp_socket_connection, (const char*)pending_socket_io->bytes, pending_socket_io->size);
         if (send_result != (int)pending_socket_io->size)
@@ -230,6 +286,8 @@ static int send_queued_data(SOCKET_IO_INSTANCE* socket_io_instance)
         else
         {
             sent += send_result;
+            (void)DList_RemoveEntryList(&pending_socket_io->link);
+
             if (pending_socket_io->on_send_complete != NULL)
             {
                 pending_socket_io->on_send_complete(pending_socket_io->callback_context, IO_SEND_OK);
@@ -237,15 +295,8 @@ static int send_queued_data(SOCKET_IO_INSTANCE* socket_io_instance)
 
             free(pending_socket_io->bytes);
             free(pending_socket_io);
-            if (singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io) != 0)
-            {
-                indicate_error(socket_io_instance);
-                return -1;
-            }
             errors = 0;
         }
-
-        first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
     }
 
     return sent;
@@ -257,6 +308,7 @@ static void close_tcp_connection(SOCKET_IO_INSTANCE* socket_io_instance)
     {
         if (socket_io_instance->tcp_socket_connection != NULL)
         {
+            tcpsocketconnection_set_sigio(socket_io_instance->tcp_socket_connection, NULL, NULL);
             tcpsocketconnection_close(socket_io_instance->tcp_socket_connection);
             tcpsocketconnection_destroy(socket_io_instance->tcp_socket_connection);
             socket_io_instance->tcp_socket_connection = NULL;
@@ -279,31 +331,27 @@ CONCRETE_IO_HANDLE socketio_create(void* io_create_parameters)
         result = (SOCKET_IO_INSTANCE*)malloc(sizeof(SOCKET_IO_INSTANCE));
         if (result != NULL)
         {
-            result->pending_io_list = singlylinkedlist_create();
-            if (result->pending_io_list == NULL)
+            DList_InitializeListHead(&result->pending_io_list);
+
+            result->hostname = strdup(socket_io_config->hostname);
+            if (result->hostname == NULL)
             {
                 free(result);
                 result = NULL;
             }
             else
             {
-                result->hostname = strdup(socket_io_config->hostname);
-                if (result->hostname == NULL)
-                {
-                    singlylinkedlist_destroy(result->pending_io_list);
-                    free(result);
-                    result = NULL;
-                }
-                else
-                {
-                    result->port = socket_io_config->port;
-                    result->on_bytes_received = NULL;
-                    result->on_io_error = NULL;
-                    result->on_bytes_received_context = NULL;
-                    result->on_io_error_context = NULL;
-                    result->io_state = IO_STATE_CLOSED;
-                    result->tcp_socket_connection = NULL;
-                }
+                result->port = socket_io_config->port;
+                result->on_bytes_received = NULL;
+                result->on_io_error = NULL;
+                result->on_bytes_received_context = NULL;
+                result->on_io_error_context = NULL;
+                result->io_state = IO_STATE_CLOSED;
+                result->tcp_socket_connection = NULL;
+                result->receive_signalled = false;
+                result->receive_buffer = NULL;
+                result->receive_buffer_size = 0;
+                result->receive_size = MBED_RECEIVE_BYTES_VALUE;
             }
         }
     }
@@ -321,26 +369,19 @@ void socketio_destroy(CONCRETE_IO_HANDLE socket_io)
         close_tcp_connection(socket_io_instance);
     
         // Clear all pending IOs
-        LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
-        while (first_pending_io != NULL)
+        while (!DList_IsListEmpty(&socket_io_instance->pending_io_list))
         {
-            PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
-            if (pending_socket_io != NULL)
-            {
-                free(pending_socket_io->bytes);
-                free(pending_socket_io);
-            }
-
-            (void)singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io);
-            first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
+            PENDING_SOCKET_IO* pending_socket_io = containingRecord(DList_RemoveHeadList(&socket_io_instance->pending_io_list), PENDING_SOCKET_IO, link);
+            free(pending_socket_io->bytes);
+            free(pending_socket_io);
         }
-        singlylinkedlist_destroy(socket_io_instance->pending_io_list);
     
         if(socket_io_instance->hostname != NULL)
         {
             free(socket_io_instance->hostname);
             socket_io_instance->hostname = NULL;
         }
+        free(socket_io_instance->receive_buffer);
         free(socket_io);
     }
 }
@@ -375,6 +416,10 @@ int socketio_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_c
             {
                 tcpsocketconnection_set_blocking(socket_io_instance->tcp_socket_connection, false, 0);
 
+                /* bytes may have arrived before the callback was attached, the first dowork reads anyway */
+                socket_io_instance->receive_signalled = true;
+                tcpsocketconnection_set_sigio(socket_io_instance->tcp_socket_connection, on_socket_sigio, socket_io_instance);
+
                 socket_io_instance->on_bytes_received = on_bytes_received;
                 socket_io_instance->on_bytes_received_context = on_bytes_received_context;
 
@@ -480,8 +525,38 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
 
 int socketio_setoption(CONCRETE_IO_HANDLE socket_io, const char* optionName, const void* value)
 {
-    /* Not implementing any options, do nothing */
-    return OPTIONHANDLER_OK;
+    int result;
+    SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+
+    if ((socket_io_instance == NULL) ||
+        (optionName == NULL) ||
+        (value == NULL))
+    {
+        LogError("invalid parameter (NULL) passed to socketio_setoption");
+        result = __FAILURE__;
+    }
+    else if (strcmp(optionName, OPTION_SOCKETIO_RECEIVE_SIZE) == 0)
+    {
+        if ((*(const size_t*)value == 0) ||
+            (*(const size_t*)value > INT_MAX))
+        {
+            LogError("option value must be greater than 0 and fit an int");
+            result = __FAILURE__;
+        }
+        else
+        {
+            // the buffer is resized by the next read, it may be in use by the receive callback now
+            socket_io_instance->receive_size = *(const size_t*)value;
+            result = 0;
+        }
+    }
+    else
+    {
+        /* the other options are not implemented, do nothing */
+        result = OPTIONHANDLER_OK;
+    }
+
+    return result;
 }
 
 const IO_INTERFACE_DESCRIPTION* socketio_get_interface_description(void)
@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <stdbool.h>
 #include <winsock2.h>
 #include <ws2tcpip.h>
 #include <windows.h>
@@ -12,13 +13,20 @@
 #include <afunix.h>
 #endif
 #include "azure_c_shared_utility/socketio.h"
-#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/doublylinkedlist.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/gbnetwork.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/socket_reactor.h"
+#include "azure_c_shared_utility/string_intern.h"
 #include "azure_c_shared_utility/xlogging.h"
 
+// size of the receive buffer kept posted on the socket when a socket reactor (completion port) is used
+#ifndef SOCKETIO_OVERLAPPED_RECEIVE_SIZE
+#define SOCKETIO_OVERLAPPED_RECEIVE_SIZE    16384
+#endif
+
 typedef enum IO_STATE_TAG
 {
     IO_STATE_CLOSED,
@@ -29,11 +37,13 @@ typedef enum IO_STATE_TAG
 
 typedef struct PENDING_SOCKET_IO_TAG
 {
+    DLIST_ENTRY link;
     unsigned char* bytes;
     size_t size;
+    /* bytes already sent by overlapped sends */
+    size_t offset;
     ON_SEND_COMPLETE on_send_complete;
     void* callback_context;
-    SINGLYLINKEDLIST_HANDLE pending_io_list;
 } PENDING_SOCKET_IO;
 
 typedef struct SOCKET_IO_INSTANCE_TAG
@@ -44,20 +54,39 @@ typedef struct SOCKET_IO_INSTANCE_TAG
     ON_IO_ERROR on_io_error;
     void* on_bytes_received_context;
     void* on_io_error_context;
-    char* hostname;
+    const char* hostname;
     int port;
     IO_STATE io_state;
-    SINGLYLINKEDLIST_HANDLE pending_io_list;
+    DLIST_ENTRY pending_io_list;
     struct tcp_keepalive keep_alive;
+    /* with a reactor one receive and one send are kept posted as overlapped operations, whose
+       completions are recorded in ready_events by the thread(s) running the reactor */
+    SOCKET_REACTOR_HANDLE socket_reactor;
+    volatile LONG ready_events;
+    SOCKET_REACTOR_OVERLAPPED receive_operation;
+    SOCKET_REACTOR_OVERLAPPED send_operation;
+    bool receive_posted;
+    bool send_posted;
+    unsigned char* receive_buffer;
     unsigned char recv_bytes[RECEIVE_BYTES_VALUE];
 } SOCKET_IO_INSTANCE;
 
 /*this function will clone an option given by name and value*/
 static void* socketio_CloneOption(const char* name, const void* value)
 {
-    (void)name;
-    (void)value;
-    return NULL;
+    void* result;
+
+    if ((name != NULL) && (strcmp(name, OPTION_SOCKET_REACTOR) == 0))
+    {
+        /* the reactor is not owned by the socket, the handle is shared as is */
+        result = (void*)value;
+    }
+    else
+    {
+        result = NULL;
+    }
+
+    return result;
 }
 
 /*this function destroys an option previously created*/
@@ -70,20 +99,27 @@ static void socketio_DestroyOption(const char* name, const void* value)
 static OPTIONHANDLER_HANDLE socketio_retrieveoptions(CONCRETE_IO_HANDLE handle)
 {
     OPTIONHANDLER_HANDLE result;
-    (void)handle;
+    SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)handle;
+
     result = OptionHandler_Create(socketio_CloneOption, socketio_DestroyOption, socketio_setoption);
     if (result == NULL)
     {
         LogError("unable to OptionHandler_Create");
         /*return as is*/
     }
-    else
+    else if ((socket_io_instance != NULL) &&
+        (socket_io_instance->socket_reactor != NULL) &&
+        (OptionHandler_AddOption(result, OPTION_SOCKET_REACTOR, socket_io_instance->socket_reactor) != OPTIONHANDLER_OK))
     {
-        /*insert here work to add the options to "result" handle*/
+        LogError("failed retrieving options (failed adding socket_reactor)");
+        OptionHandler_Destroy(result);
+        result = NULL;
     }
     return result;
 }
 
+static int socketio_get_pollable_handle(CONCRETE_IO_HANDLE socket_io, intptr_t* pollable_handle, unsigned int* wanted_events);
+
 static const IO_INTERFACE_DESCRIPTION socket_io_interface_description =
 {
     socketio_retrieveoptions,
@@ -93,7 +129,13 @@ static const IO_INTERFACE_DESCRIPTION socket_io_interface_description =
     socketio_close,
     socketio_send,
     socketio_dowork,
-    socketio_setoption
+    socketio_setoption,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    socketio_get_pollable_handle,
+    NULL
 };
 
 static void indicate_error(SOCKET_IO_INSTANCE* socket_io_instance)
@@ -124,26 +166,239 @@ static int add_pending_io(SOCKET_IO_INSTANCE* socket_io_instance, const unsigned
         else
         {
             pending_socket_io->size = size;
+            pending_socket_io->offset = 0;
             pending_socket_io->on_send_complete = on_send_complete;
             pending_socket_io->callback_context = callback_context;
-            pending_socket_io->pending_io_list = socket_io_instance->pending_io_list;
             (void)memcpy(pending_socket_io->bytes, buffer, size);
 
-            if (singlylinkedlist_add(socket_io_instance->pending_io_list, pending_socket_io) == NULL)
+            DList_InsertTailList(&socket_io_instance->pending_io_list, &pending_socket_io->link);
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void on_socket_reactor_event(void* context, unsigned int events)
+{
+    SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)context;
+
+    (void)InterlockedOr(&socket_io_instance->ready_events, (LONG)events);
+}
+
+static int post_receive(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    int result;
+
+    if ((socket_io_instance->receive_buffer == NULL) &&
+        ((socket_io_instance->receive_buffer = (unsigned char*)malloc(SOCKETIO_OVERLAPPED_RECEIVE_SIZE)) == NULL))
+    {
+        LogError("Allocation Failure: receive buffer.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        WSABUF wsa_buffer;
+        DWORD flags = 0;
+
+        wsa_buffer.buf = (char*)socket_io_instance->receive_buffer;
+        wsa_buffer.len = SOCKETIO_OVERLAPPED_RECEIVE_SIZE;
+        (void)memset(&socket_io_instance->receive_operation, 0, sizeof(socket_io_instance->receive_operation));
+        socket_io_instance->receive_operation.event = SOCKET_REACTOR_EVENT_READABLE;
+
+        /* a receive that completes right away is still reported through the completion port */
+        if ((WSARecv(socket_io_instance->socket, &wsa_buffer, 1, NULL, &flags, &socket_io_instance->receive_operation.overlapped, NULL) == SOCKET_ERROR) &&
+            (WSAGetLastError() != WSA_IO_PENDING))
+        {
+            LogError("Failure: WSARecv failed %d.", WSAGetLastError());
+            result = __FAILURE__;
+        }
+        else
+        {
+            socket_io_instance->receive_posted = true;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+/* sends what is left of the first pending IO */
+static int post_send(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    int result;
+
+    if (DList_IsListEmpty(&socket_io_instance->pending_io_list))
+    {
+        LogError("Failure: retrieving pending IO from list");
+        result = __FAILURE__;
+    }
+    else
+    {
+        PENDING_SOCKET_IO* pending_socket_io = containingRecord(socket_io_instance->pending_io_list.Flink, PENDING_SOCKET_IO, link);
+        WSABUF wsa_buffer;
+
+        wsa_buffer.buf = (char*)pending_socket_io->bytes + pending_socket_io->offset;
+        wsa_buffer.len = (ULONG)(pending_socket_io->size - pending_socket_io->offset);
+        (void)memset(&socket_io_instance->send_operation, 0, sizeof(socket_io_instance->send_operation));
+        socket_io_instance->send_operation.event = SOCKET_REACTOR_EVENT_WRITABLE;
+
+        if ((WSASend(socket_io_instance->socket, &wsa_buffer, 1, NULL, 0, &socket_io_instance->send_operation.overlapped, NULL) == SOCKET_ERROR) &&
+            (WSAGetLastError() != WSA_IO_PENDING))
+        {
+            LogError("Failure: WSASend failed %d.", WSAGetLastError());
+            result = __FAILURE__;
+        }
+        else
+        {
+            socket_io_instance->send_posted = true;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int start_overlapped_io(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    int result;
+
+    socket_io_instance->ready_events = 0;
+    socket_io_instance->receive_posted = false;
+    socket_io_instance->send_posted = false;
+
+    if (socket_reactor_register(socket_io_instance->socket_reactor, (int)socket_io_instance->socket, on_socket_reactor_event, socket_io_instance) != 0)
+    {
+        LogError("Failure: socket_reactor_register failed.");
+        result = __FAILURE__;
+    }
+    else if (post_receive(socket_io_instance) != 0)
+    {
+        LogError("Failure: post_receive failed.");
+        (void)socket_reactor_unregister(socket_io_instance->socket_reactor, (int)socket_io_instance->socket);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+/* must be called before the socket is closed: the overlapped operations use memory of the instance */
+static void stop_overlapped_io(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    DWORD bytes_transferred;
+    DWORD flags;
+
+    if (socket_io_instance->receive_posted || socket_io_instance->send_posted)
+    {
+        (void)CancelIoEx((HANDLE)socket_io_instance->socket, NULL);
+    }
+
+    /* the completions may still be queued on the port, unregistering makes the reactor drop them */
+    if (socket_io_instance->receive_posted)
+    {
+        (void)WSAGetOverlappedResult(socket_io_instance->socket, &socket_io_instance->receive_operation.overlapped, &bytes_transferred, TRUE, &flags);
+        socket_io_instance->receive_posted = false;
+    }
+
+    if (socket_io_instance->send_posted)
+    {
+        (void)WSAGetOverlappedResult(socket_io_instance->socket, &socket_io_instance->send_operation.overlapped, &bytes_transferred, TRUE, &flags);
+        socket_io_instance->send_posted = false;
+    }
+
+    if (socket_reactor_unregister(socket_io_instance->socket_reactor, (int)socket_io_instance->socket) != 0)
+    {
+        LogError("Failure: socket_reactor_unregister failed.");
+    }
+}
+
+static void remove_first_pending_io(SOCKET_IO_INSTANCE* socket_io_instance, IO_SEND_RESULT send_result)
+{
+    if (!DList_IsListEmpty(&socket_io_instance->pending_io_list))
+    {
+        PENDING_SOCKET_IO* pending_socket_io = containingRecord(DList_RemoveHeadList(&socket_io_instance->pending_io_list), PENDING_SOCKET_IO, link);
+
+        if (pending_socket_io->on_send_complete != NULL)
+        {
+            pending_socket_io->on_send_complete(pending_socket_io->callback_context, send_result);
+        }
+
+        free(pending_socket_io->bytes);
+        free(pending_socket_io);
+    }
+}
+
+/* completion driven dowork: only the operations the reactor reported as completed are looked at */
+static void dowork_overlapped(SOCKET_IO_INSTANCE* socket_io_instance)
+{
+    unsigned int events = (unsigned int)InterlockedExchange(&socket_io_instance->ready_events, 0);
+
+    if (((events & SOCKET_REACTOR_EVENT_WRITABLE) != 0) && socket_io_instance->send_posted)
+    {
+        socket_io_instance->send_posted = false;
+
+        if (socket_io_instance->send_operation.error != 0)
+        {
+            LogError("Failure: sending socket failed %d.", socket_io_instance->send_operation.error);
+            remove_first_pending_io(socket_io_instance, IO_SEND_ERROR);
+            indicate_error(socket_io_instance);
+        }
+        else
+        {
+            if (!DList_IsListEmpty(&socket_io_instance->pending_io_list))
             {
-                LogError("Failure: Unable to add socket to pending list.");
-                free(pending_socket_io->bytes);
-                free(pending_socket_io);
-                result = __FAILURE__;
+                PENDING_SOCKET_IO* pending_socket_io = containingRecord(socket_io_instance->pending_io_list.Flink, PENDING_SOCKET_IO, link);
+
+                pending_socket_io->offset += socket_io_instance->send_operation.bytes_transferred;
+                if (pending_socket_io->offset >= pending_socket_io->size)
+                {
+                    remove_first_pending_io(socket_io_instance, IO_SEND_OK);
+                }
             }
-            else
+
+            if ((socket_io_instance->io_state == IO_STATE_OPEN) &&
+                !socket_io_instance->send_posted &&
+                !DList_IsListEmpty(&socket_io_instance->pending_io_list) &&
+                (post_send(socket_io_instance) != 0))
             {
-                result = 0;
+                indicate_error(socket_io_instance);
             }
         }
     }
 
-    return result;
+    if ((socket_io_instance->io_state == IO_STATE_OPEN) &&
+        ((events & SOCKET_REACTOR_EVENT_READABLE) != 0) && socket_io_instance->receive_posted)
+    {
+        socket_io_instance->receive_posted = false;
+
+        if (socket_io_instance->receive_operation.error != 0)
+        {
+            LogError("Socketio_Failure: Receiving data from endpoint: %d.", socket_io_instance->receive_operation.error);
+            indicate_error(socket_io_instance);
+        }
+        else if (socket_io_instance->receive_operation.bytes_transferred == 0)
+        {
+            indicate_error(socket_io_instance);
+        }
+        else
+        {
+            if (socket_io_instance->on_bytes_received != NULL)
+            {
+                /* Explicitly ignoring here the result of the callback */
+                (void)socket_io_instance->on_bytes_received(socket_io_instance->on_bytes_received_context, socket_io_instance->receive_buffer, (size_t)socket_io_instance->receive_operation.bytes_transferred);
+            }
+
+            if ((socket_io_instance->io_state == IO_STATE_OPEN) &&
+                (post_receive(socket_io_instance) != 0))
+            {
+                indicate_error(socket_io_instance);
+            }
+        }
+    }
 }
 
 CONCRETE_IO_HANDLE socketio_create(void* io_create_parameters)
@@ -163,49 +418,41 @@ CONCRETE_IO_HANDLE socketio_create(void* io_create_parameters)
         if (result != NULL)
         {
             result->address_type = ADDRESS_TYPE_IP;
-            result->pending_io_list = singlylinkedlist_create();
-            if (result->pending_io_list == NULL)
+            DList_InitializeListHead(&result->pending_io_list);
+
+            if (socket_io_config->hostname != NULL)
             {
-                LogError("Failure: singlylinkedlist_create unable to create pending list.");
+                // the connections to one host share its name
+                result->hostname = string_intern(socket_io_config->hostname);
+
+                result->socket = INVALID_SOCKET;
+            }
+            else
+            {
+                result->hostname = NULL;
+                result->socket = *((SOCKET*)socket_io_config->accepted_socket);
+            }
+
+            if ((result->hostname == NULL) && (result->socket == INVALID_SOCKET))
+            {
+                LogError("Failure: hostname == NULL and socket is invalid.");
                 free(result);
                 result = NULL;
             }
             else
             {
-                if (socket_io_config->hostname != NULL)
-                {
-                    result->hostname = (char*)malloc(strlen(socket_io_config->hostname) + 1);
-                    if (result->hostname != NULL)
-                    {
-                        (void)strcpy(result->hostname, socket_io_config->hostname);
-                    }
-
-                    result->socket = INVALID_SOCKET;
-                }
-                else
-                {
-                    result->hostname = NULL;
-                    result->socket = *((SOCKET*)socket_io_config->accepted_socket);
-                }
-
-                if ((result->hostname == NULL) && (result->socket == INVALID_SOCKET))
-                {
-                    LogError("Failure: hostname == NULL and socket is invalid.");
-                    singlylinkedlist_destroy(result->pending_io_list);
-                    free(result);
-                    result = NULL;
-                }
-                else
-                {
-                    result->port = socket_io_config->port;
-                    result->on_bytes_received = NULL;
-                    result->on_io_error = NULL;
-                    result->on_bytes_received_context = NULL;
-                    result->on_io_error_context = NULL;
-                    result->io_state = IO_STATE_CLOSED;
-                    result->keep_alive = tcp_keepalive;
-
-                }
+                result->port = socket_io_config->port;
+                result->on_bytes_received = NULL;
+                result->on_io_error = NULL;
+                result->on_bytes_received_context = NULL;
+                result->on_io_error_context = NULL;
+                result->io_state = IO_STATE_CLOSED;
+                result->keep_alive = tcp_keepalive;
+                result->socket_reactor = NULL;
+                result->ready_events = 0;
+                result->receive_posted = false;
+                result->send_posted = false;
+                result->receive_buffer = NULL;
             }
         }
         else
@@ -219,32 +466,35 @@ CONCRETE_IO_HANDLE socketio_create(void* io_create_parameters)
 
 void socketio_destroy(CONCRETE_IO_HANDLE socket_io)
 {
-    LIST_ITEM_HANDLE first_pending_io;
-
     if (socket_io != NULL)
     {
         SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+        if ((socket_io_instance->socket_reactor != NULL) &&
+            (socket_io_instance->io_state == IO_STATE_OPEN))
+        {
+            stop_overlapped_io(socket_io_instance);
+        }
+
         /* we cannot do much if the close fails, so just ignore the result */
         (void)closesocket(socket_io_instance->socket);
 
         /* clear allpending IOs */
 
-        while ((first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list)) != NULL)
+        while (!DList_IsListEmpty(&socket_io_instance->pending_io_list))
         {
-            PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
-            if (pending_socket_io != NULL)
-            {
-                free(pending_socket_io->bytes);
-                free(pending_socket_io);
-            }
-
-            singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io);
+            PENDING_SOCKET_IO* pending_socket_io = containingRecord(DList_RemoveHeadList(&socket_io_instance->pending_io_list), PENDING_SOCKET_IO, link);
+            free(pending_socket_io->bytes);
+            free(pending_socket_io);
         }
 
-        singlylinkedlist_destroy(socket_io_instance->pending_io_list);
         if (socket_io_instance->hostname != NULL)
         {
-            free(socket_io_instance->hostname);
+            string_intern_release(socket_io_instance->hostname);
+        }
+
+        if (socket_io_instance->receive_buffer != NULL)
+        {
+            free(socket_io_instance->receive_buffer);
         }
 
         free(socket_io);
@@ -363,14 +613,23 @@ int socketio_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_c
         else if (socket_io_instance->socket != INVALID_SOCKET)
         {
             // Opening an accepted socket
-            socket_io_instance->on_bytes_received_context = on_bytes_received_context;
-            socket_io_instance->on_bytes_received = on_bytes_received;
-            socket_io_instance->on_io_error = on_io_error;
-            socket_io_instance->on_io_error_context = on_io_error_context;
+            if ((socket_io_instance->socket_reactor != NULL) &&
+                (start_overlapped_io(socket_io_instance) != 0))
+            {
+                LogError("start_overlapped_io failed");
+                result = __FAILURE__;
+            }
+            else
+            {
+                socket_io_instance->on_bytes_received_context = on_bytes_received_context;
+                socket_io_instance->on_bytes_received = on_bytes_received;
+                socket_io_instance->on_io_error = on_io_error;
+                socket_io_instance->on_io_error_context = on_io_error_context;
 
-            socket_io_instance->io_state = IO_STATE_OPEN;
+                socket_io_instance->io_state = IO_STATE_OPEN;
 
-            result = 0;
+                result = 0;
+            }
         }
         else
         {
@@ -392,6 +651,14 @@ int socketio_open(CONCRETE_IO_HANDLE socket_io, ON_IO_OPEN_COMPLETE on_io_open_c
                 socket_io_instance->socket = INVALID_SOCKET;
                 result = __FAILURE__;
             }
+            else if ((socket_io_instance->socket_reactor != NULL) &&
+                (start_overlapped_io(socket_io_instance) != 0))
+            {
+                LogError("start_overlapped_io failed");
+                (void)closesocket(socket_io_instance->socket);
+                socket_io_instance->socket = INVALID_SOCKET;
+                result = __FAILURE__;
+            }
             else
             {
                 socket_io_instance->on_bytes_received_context = on_bytes_received_context;
@@ -430,6 +697,10 @@ int socketio_close(CONCRETE_IO_HANDLE socket_io, ON_IO_CLOSE_COMPLETE on_io_clos
         if ((socket_io_instance->io_state != IO_STATE_CLOSING) &&
             (socket_io_instance->io_state != IO_STATE_CLOSED))
         {
+            if (socket_io_instance->socket_reactor != NULL)
+            {
+                stop_overlapped_io(socket_io_instance);
+            }
             (void)closesocket(socket_io_instance->socket);
             socket_io_instance->socket = INVALID_SOCKET;
             socket_io_instance->io_state = IO_STATE_CLOSED;
@@ -464,10 +735,32 @@ int socketio_send(CONCRETE_IO_HANDLE socket_io, const void* buffer, size_t size,
             LogError("Failure: socket state is not opened.");
             result = __FAILURE__;
         }
+        else if (socket_io_instance->socket_reactor != NULL)
+        {
+            /* the bytes are copied, the send is completed by the dowork that sees its completion */
+            if (add_pending_io(socket_io_instance, (const unsigned char*)buffer, size, on_send_complete, callback_context) != 0)
+            {
+                LogError("Failure: add_pending_io failed.");
+                result = __FAILURE__;
+            }
+            else if (!socket_io_instance->send_posted &&
+                (post_send(socket_io_instance) != 0))
+            {
+                /* nothing was in flight, so the entry that failed is the one just added */
+                PENDING_SOCKET_IO* pending_socket_io = containingRecord(DList_RemoveHeadList(&socket_io_instance->pending_io_list), PENDING_SOCKET_IO, link);
+
+                free(pending_socket_io->bytes);
+                free(pending_socket_io);
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
         else
         {
-            LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
-            if (first_pending_io != NULL)
+            if (!DList_IsListEmpty(&socket_io_instance->pending_io_list))
             {
                 if (add_pending_io(socket_io_instance, (const unsigned char*)buffer, size, on_send_complete, callback_context) != 0)
                 {
@@ -528,18 +821,16 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
     if (socket_io != NULL)
     {
         SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
-        if (socket_io_instance->io_state == IO_STATE_OPEN)
+        if ((socket_io_instance->io_state == IO_STATE_OPEN) &&
+            (socket_io_instance->socket_reactor != NULL))
+        {
+            dowork_overlapped(socket_io_instance);
+        }
+        else if (socket_io_instance->io_state == IO_STATE_OPEN)
         {
-            LIST_ITEM_HANDLE first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
-            while (first_pending_io != NULL)
+            while (!DList_IsListEmpty(&socket_io_instance->pending_io_list))
             {
-                PENDING_SOCKET_IO* pending_socket_io = (PENDING_SOCKET_IO*)singlylinkedlist_item_get_value(first_pending_io);
-                if (pending_socket_io == NULL)
-                {
-                    LogError("Failure: retrieving socket from list");
-                    indicate_error(socket_io_instance);
-                    break;
-                }
+                PENDING_SOCKET_IO* pending_socket_io = containingRecord(socket_io_instance->pending_io_list.Flink, PENDING_SOCKET_IO, link);
 
                 /* TODO: we need to do more than a cast here to be 100% clean
                 The following bug was filed: [WarnL4] socketio_win32 does not account for already sent bytes and there is a truncation of size from size_t to int */
@@ -549,9 +840,9 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
                     int last_error = WSAGetLastError();
                     if (last_error != WSAEWOULDBLOCK)
                     {
+                        (void)DList_RemoveEntryList(&pending_socket_io->link);
                         free(pending_socket_io->bytes);
                         free(pending_socket_io);
-                        (void)singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io);
                     }
                     else
                     {
@@ -560,6 +851,8 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
                 }
                 else
                 {
+                    (void)DList_RemoveEntryList(&pending_socket_io->link);
+
                     if (pending_socket_io->on_send_complete != NULL)
                     {
                         pending_socket_io->on_send_complete(pending_socket_io->callback_context, IO_SEND_OK);
@@ -567,14 +860,7 @@ void socketio_dowork(CONCRETE_IO_HANDLE socket_io)
 
                     free(pending_socket_io->bytes);
                     free(pending_socket_io);
-                    if (singlylinkedlist_remove(socket_io_instance->pending_io_list, first_pending_io) != 0)
-                    {
-                        LogError("Failure: removing socket from list");
-                        indicate_error(socket_io_instance);
-                    }
                 }
-
-                first_pending_io = singlylinkedlist_get_head_item(socket_io_instance->pending_io_list);
             }
 
             if (socket_io_instance->io_state == IO_STATE_OPEN)
@@ -661,13 +947,53 @@ static int socketio_setaddresstype_option(SOCKET_IO_INSTANCE* socket_io_instance
     return result;
 }
 
+static int socketio_get_pollable_handle(CONCRETE_IO_HANDLE socket_io, intptr_t* pollable_handle, unsigned int* wanted_events)
+{
+    int result;
+
+    if ((socket_io == NULL) ||
+        (pollable_handle == NULL) ||
+        (wanted_events == NULL))
+    {
+        LogError("Invalid argument: socket_io=%p, pollable_handle=%p, wanted_events=%p", socket_io, pollable_handle, wanted_events);
+        result = __FAILURE__;
+    }
+    else
+    {
+        SOCKET_IO_INSTANCE* socket_io_instance = (SOCKET_IO_INSTANCE*)socket_io;
+
+        if (socket_io_instance->socket == INVALID_SOCKET)
+        {
+            LogError("Failure: the socket is not open.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            *pollable_handle = (intptr_t)socket_io_instance->socket;
+            *wanted_events = 0;
+            if (socket_io_instance->io_state == IO_STATE_OPEN)
+            {
+                *wanted_events |= XIO_POLL_READABLE;
+            }
+            if (!DList_IsListEmpty(&socket_io_instance->pending_io_list))
+            {
+                *wanted_events |= XIO_POLL_WRITABLE;
+            }
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
 int socketio_setoption(CONCRETE_IO_HANDLE socket_io, const char* optionName, const void* value)
 {
     int result;
 
     if (socket_io == NULL ||
         optionName == NULL ||
-        value == NULL)
+        /* a NULL socket reactor takes the socket off its reactor */
+        (value == NULL && strcmp(optionName, OPTION_SOCKET_REACTOR) != 0))
     {
         result = __FAILURE__;
     }
@@ -702,6 +1028,19 @@ int socketio_setoption(CONCRETE_IO_HANDLE socket_io, const char* optionName, con
         {
             result = socketio_setaddresstype_option(socket_io_instance, (const char*)value);
         }
+        else if (strcmp(optionName, OPTION_SOCKET_REACTOR) == 0)
+        {
+            if (socket_io_instance->io_state != IO_STATE_CLOSED)
+            {
+                LogError("Socket reactor can only be changed when in state 'IO_STATE_CLOSED'.  Current state=%d", socket_io_instance->io_state);
+                result = __FAILURE__;
+            }
+            else
+            {
+                socket_io_instance->socket_reactor = (SOCKET_REACTOR_HANDLE)value;
+                result = 0;
+            }
+        }
         else
         {
             result = __FAILURE__;
@@ -0,0 +1,233 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#define _DEFAULT_SOURCE
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include "azure_c_shared_utility/sync_wait.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#define MILLISECONDS_IN_1_SECOND 1000
+#define NANOSECONDS_IN_1_MILLISECOND 1000000L
+#define NANOSECONDS_IN_1_SECOND 1000000000L
+
+#if defined(__linux__)
+
+#include <limits.h>
+#include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+
+/* a relative FUTEX_WAIT timeout is measured on CLOCK_MONOTONIC */
+SYNC_WAIT_RESULT sync_wait_on_address(volatile int32_t* address, int32_t compare_value, int timeout_milliseconds)
+{
+    SYNC_WAIT_RESULT result;
+    struct timespec timeout;
+
+    timeout.tv_sec = timeout_milliseconds / MILLISECONDS_IN_1_SECOND;
+    timeout.tv_nsec = (timeout_milliseconds % MILLISECONDS_IN_1_SECOND) * NANOSECONDS_IN_1_MILLISECOND;
+
+    if (syscall(SYS_futex, address, FUTEX_WAIT_PRIVATE, compare_value, (timeout_milliseconds == 0) ? NULL : &timeout, NULL, 0) == 0)
+    {
+        result = SYNC_WAIT_OK;
+    }
+    else if ((errno == EAGAIN) || (errno == EINTR))
+    {
+        /* the word changed already, or a signal came in: the caller checks the word */
+        result = SYNC_WAIT_OK;
+    }
+    else if (errno == ETIMEDOUT)
+    {
+        result = SYNC_WAIT_TIMEOUT;
+    }
+    else
+    {
+        LogError("FUTEX_WAIT failed: %d", errno);
+        result = SYNC_WAIT_ERROR;
+    }
+
+    return result;
+}
+
+void sync_wake_by_address(volatile int32_t* address, bool wake_all)
+{
+    if (syscall(SYS_futex, address, FUTEX_WAKE_PRIVATE, wake_all ? INT_MAX : 1, NULL, NULL, 0) < 0)
+    {
+        LogError("FUTEX_WAKE failed: %d", errno);
+    }
+}
+
+#else
+
+#include <pthread.h>
+
+/*
+* Without a futex the words are hashed onto a few mutex/condition pairs. A waker takes the
+* lock of the pair after the word changed, so a waiter that has checked the word under that
+* lock is already waiting on the condition. The pairs are shared, so wakes are broadcast.
+*/
+#define SYNC_WAIT_BUCKET_COUNT 64
+
+typedef struct SYNC_WAIT_BUCKET_TAG
+{
+    pthread_mutex_t lock;
+    pthread_cond_t condition;
+} SYNC_WAIT_BUCKET;
+
+static SYNC_WAIT_BUCKET sync_wait_buckets[SYNC_WAIT_BUCKET_COUNT];
+static pthread_once_t sync_wait_buckets_once = PTHREAD_ONCE_INIT;
+static bool sync_wait_buckets_initialized = false;
+
+static int init_condition(pthread_cond_t* condition)
+{
+    int result;
+
+#if defined(__APPLE__)
+    /* Apple has no pthread_condattr_setclock, the timed wait below is relative there */
+    result = pthread_cond_init(condition, NULL);
+#else
+    pthread_condattr_t condition_attributes;
+
+    if ((result = pthread_condattr_init(&condition_attributes)) == 0)
+    {
+        if ((result = pthread_condattr_setclock(&condition_attributes, CLOCK_MONOTONIC)) == 0)
+        {
+            result = pthread_cond_init(condition, &condition_attributes);
+        }
+
+        (void)pthread_condattr_destroy(&condition_attributes);
+    }
+#endif
+
+    return result;
+}
+
+static void init_sync_wait_buckets(void)
+{
+    size_t i;
+
+    for (i = 0; i < SYNC_WAIT_BUCKET_COUNT; i++)
+    {
+        if ((pthread_mutex_init(&sync_wait_buckets[i].lock, NULL) != 0) ||
+            (init_condition(&sync_wait_buckets[i].condition) != 0))
+        {
+            LogError("failure initializing the wait buckets");
+            break;
+        }
+    }
+
+    sync_wait_buckets_initialized = (i == SYNC_WAIT_BUCKET_COUNT);
+}
+
+static SYNC_WAIT_BUCKET* get_sync_wait_bucket(volatile int32_t* address)
+{
+    SYNC_WAIT_BUCKET* result;
+
+    if ((pthread_once(&sync_wait_buckets_once, init_sync_wait_buckets) != 0) ||
+        !sync_wait_buckets_initialized)
+    {
+        result = NULL;
+    }
+    else
+    {
+        /* words are at least 4 byte aligned, the low bits say nothing */
+        result = &sync_wait_buckets[((uintptr_t)address >> 2) % SYNC_WAIT_BUCKET_COUNT];
+    }
+
+    return result;
+}
+
+SYNC_WAIT_RESULT sync_wait_on_address(volatile int32_t* address, int32_t compare_value, int timeout_milliseconds)
+{
+    SYNC_WAIT_RESULT result;
+    SYNC_WAIT_BUCKET* bucket = get_sync_wait_bucket(address);
+
+    if (bucket == NULL)
+    {
+        result = SYNC_WAIT_ERROR;
+    }
+    else if (pthread_mutex_lock(&bucket->lock) != 0)
+    {
+        LogError("failure in pthread_mutex_lock");
+        result = SYNC_WAIT_ERROR;
+    }
+    else
+    {
+        int wait_result;
+
+        if (*address != compare_value)
+        {
+            wait_result = 0;
+        }
+        else if (timeout_milliseconds == 0)
+        {
+            wait_result = pthread_cond_wait(&bucket->condition, &bucket->lock);
+        }
+        else
+        {
+            struct timespec timeout;
+#if defined(__APPLE__)
+            timeout.tv_sec = timeout_milliseconds / MILLISECONDS_IN_1_SECOND;
+            timeout.tv_nsec = (timeout_milliseconds % MILLISECONDS_IN_1_SECOND) * NANOSECONDS_IN_1_MILLISECOND;
+            wait_result = pthread_cond_timedwait_relative_np(&bucket->condition, &bucket->lock, &timeout);
+#else
+            if (clock_gettime(CLOCK_MONOTONIC, &timeout) != 0)
+            {
+                wait_result = errno;
+            }
+            else
+            {
+                timeout.tv_sec += timeout_milliseconds / MILLISECONDS_IN_1_SECOND;
+                timeout.tv_nsec += (timeout_milliseconds % MILLISECONDS_IN_1_SECOND) * NANOSECONDS_IN_1_MILLISECOND;
+                timeout.tv_sec += timeout.tv_nsec / NANOSECONDS_IN_1_SECOND;
+                timeout.tv_nsec %= NANOSECONDS_IN_1_SECOND;
+                wait_result = pthread_cond_timedwait(&bucket->condition, &bucket->lock, &timeout);
+            }
+#endif
+        }
+
+        (void)pthread_mutex_unlock(&bucket->lock);
+
+        if (wait_result == 0)
+        {
+            result = SYNC_WAIT_OK;
+        }
+        else if (wait_result == ETIMEDOUT)
+        {
+            result = SYNC_WAIT_TIMEOUT;
+        }
+        else
+        {
+            LogError("waiting on the condition failed: %d", wait_result);
+            result = SYNC_WAIT_ERROR;
+        }
+    }
+
+    return result;
+}
+
+void sync_wake_by_address(volatile int32_t* address, bool wake_all)
+{
+    SYNC_WAIT_BUCKET* bucket = get_sync_wait_bucket(address);
+
+    (void)wake_all;
+
+    if (bucket == NULL)
+    {
+        LogError("no wait bucket");
+    }
+    else if (pthread_mutex_lock(&bucket->lock) != 0)
+    {
+        LogError("failure in pthread_mutex_lock");
+    }
+    else
+    {
+        (void)pthread_cond_broadcast(&bucket->condition);
+        (void)pthread_mutex_unlock(&bucket->lock);
+    }
+}
+
+#endif
@@ -0,0 +1,42 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "windows.h"
+#include "azure_c_shared_utility/sync_wait.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+/* WaitOnAddress measures its timeout on the interrupt time, which does not follow wall clock changes */
+SYNC_WAIT_RESULT sync_wait_on_address(volatile int32_t* address, int32_t compare_value, int timeout_milliseconds)
+{
+    SYNC_WAIT_RESULT result;
+
+    if (WaitOnAddress(address, &compare_value, sizeof(compare_value), (timeout_milliseconds == 0) ? INFINITE : (DWORD)timeout_milliseconds))
+    {
+        result = SYNC_WAIT_OK;
+    }
+    else if (GetLastError() == ERROR_TIMEOUT)
+    {
+        result = SYNC_WAIT_TIMEOUT;
+    }
+    else
+    {
+        LogError("WaitOnAddress failed: %u", (unsigned int)GetLastError());
+        result = SYNC_WAIT_ERROR;
+    }
+
+    return result;
+}
+
+void sync_wake_by_address(volatile int32_t* address, bool wake_all)
+{
+    if (wake_all)
+    {
+        WakeByAddressAll((PVOID)address);
+    }
+    else
+    {
+        WakeByAddressSingle((PVOID)address);
+    }
+}
@@ -107,3 +107,19 @@ int tcpsocketconnection_receive_all(TCPSOCKETCONNECTION_HANDLE tcpSocketConnecti
 	}
 	return -1;
 }
+
+void tcpsocketconnection_set_sigio(TCPSOCKETCONNECTION_HANDLE tcpSocketConnectionHandle, TCPSOCKETCONNECTION_ON_SIGIO on_sigio, void* context)
+{
+	if (tcpSocketConnectionHandle != NULL)
+	{
+		TCPSocket* tsc = (TCPSocket*)tcpSocketConnectionHandle;
+		if (on_sigio == NULL)
+		{
+			tsc->sigio(mbed::Callback<void()>());
+		}
+		else
+		{
+			tsc->sigio(mbed::callback(on_sigio, context));
+		}
+	}
+}
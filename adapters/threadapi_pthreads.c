@@ -2,11 +2,17 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #define _DEFAULT_SOURCE
+#ifdef __linux__
+// pthread_attr_setaffinity_np and pthread_setname_np
+#define _GNU_SOURCE
+#endif
 
 #include "azure_c_shared_utility/threadapi.h"
 
+#include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <errno.h>
 
 #ifdef TI_RTOS
@@ -16,28 +22,227 @@
 #endif
 
 #include <pthread.h>
+#include <sched.h>
 #include <time.h>
+#ifdef __linux__
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#endif
 #include "azure_c_shared_utility/xlogging.h"
 
+#ifdef __linux__
+// the longest thread name Linux keeps, without the terminating zero
+#define THREAD_NAME_MAX_LENGTH  15
+#endif
+
 DEFINE_ENUM_STRINGS(THREADAPI_RESULT, THREADAPI_RESULT_VALUES);
+DEFINE_ENUM_STRINGS(THREADAPI_PRIORITY, THREADAPI_PRIORITY_VALUES);
 
 typedef struct THREAD_INSTANCE_TAG
 {
     pthread_t Pthread_handle;
     THREAD_START_FUNC ThreadStartFunc;
     void* Arg;
+    /* the name and the priority can only be given by the thread itself: the creating thread waits
+       until it reports whether it could (StartResult is then no longer -1) */
+    bool HasStartSync;
+    pthread_mutex_t StartLock;
+    pthread_cond_t StartCondition;
+    const char* Name;
+    THREADAPI_PRIORITY Priority;
+    int StartResult;
 } THREAD_INSTANCE;
 
+static int set_current_thread_name(const char* name)
+{
+    int result;
+
+#if defined(__linux__)
+    char truncated_name[THREAD_NAME_MAX_LENGTH + 1];
+
+    (void)strncpy(truncated_name, name, THREAD_NAME_MAX_LENGTH);
+    truncated_name[THREAD_NAME_MAX_LENGTH] = '\0';
+    result = pthread_setname_np(pthread_self(), truncated_name);
+#elif defined(__APPLE__)
+    result = pthread_setname_np(name);
+#else
+    /* the platform has no way to name a thread, the name is only informative */
+    (void)name;
+    result = 0;
+#endif
+
+    return result;
+}
+
+static int set_current_thread_priority(THREADAPI_PRIORITY priority)
+{
+    int result;
+
+#if defined(__linux__)
+    /* threads of the normal scheduling policy only differ by their nice value, which Linux keeps per thread */
+    int nice_value;
+
+    switch (priority)
+    {
+    default:
+    case THREADAPI_PRIORITY_NORMAL:
+        nice_value = 0;
+        break;
+    case THREADAPI_PRIORITY_LOWEST:
+        nice_value = 19;
+        break;
+    case THREADAPI_PRIORITY_LOW:
+        nice_value = 10;
+        break;
+    case THREADAPI_PRIORITY_HIGH:
+        nice_value = -10;
+        break;
+    case THREADAPI_PRIORITY_HIGHEST:
+        nice_value = -20;
+        break;
+    }
+
+    result = (setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), nice_value) == 0) ? 0 : errno;
+#else
+    int policy;
+    struct sched_param param;
+
+    result = pthread_getschedparam(pthread_self(), &policy, &param);
+    if (result == 0)
+    {
+        int min_priority = sched_get_priority_min(policy);
+        int max_priority = sched_get_priority_max(policy);
+        int middle_priority = min_priority + ((max_priority - min_priority) / 2);
+
+        switch (priority)
+        {
+        default:
+        case THREADAPI_PRIORITY_NORMAL:
+            param.sched_priority = middle_priority;
+            break;
+        case THREADAPI_PRIORITY_LOWEST:
+            param.sched_priority = min_priority;
+            break;
+        case THREADAPI_PRIORITY_LOW:
+            param.sched_priority = min_priority + ((middle_priority - min_priority) / 2);
+            break;
+        case THREADAPI_PRIORITY_HIGH:
+            param.sched_priority = middle_priority + ((max_priority - middle_priority) / 2);
+            break;
+        case THREADAPI_PRIORITY_HIGHEST:
+            param.sched_priority = max_priority;
+            break;
+        }
+
+        result = pthread_setschedparam(pthread_self(), policy, &param);
+    }
+#endif
+
+    return result;
+}
+
 static void* ThreadWrapper(void* threadInstanceArg)
 {
     THREAD_INSTANCE* threadInstance = (THREAD_INSTANCE*)threadInstanceArg;
-    int result = threadInstance->ThreadStartFunc(threadInstance->Arg);
+    int result;
+    int startResult = 0;
+
+    if (threadInstance->HasStartSync)
+    {
+        if ((threadInstance->Name != NULL) &&
+            ((startResult = set_current_thread_name(threadInstance->Name)) != 0))
+        {
+            LogError("failure setting the thread name %s: %d", threadInstance->Name, startResult);
+        }
+        else if ((threadInstance->Priority != THREADAPI_PRIORITY_NORMAL) &&
+            ((startResult = set_current_thread_priority(threadInstance->Priority)) != 0))
+        {
+            LogError("failure setting the thread priority %s: %d", ENUM_TO_STRING(THREADAPI_PRIORITY, threadInstance->Priority), startResult);
+        }
+
+        (void)pthread_mutex_lock(&threadInstance->StartLock);
+        threadInstance->StartResult = startResult;
+        (void)pthread_cond_signal(&threadInstance->StartCondition);
+        (void)pthread_mutex_unlock(&threadInstance->StartLock);
+    }
+
+    if (startResult != 0)
+    {
+        /* ThreadAPI_CreateEx fails and joins the thread */
+        result = 0;
+    }
+    else
+    {
+        result = threadInstance->ThreadStartFunc(threadInstance->Arg);
+    }
+
     return (void*)(intptr_t)result;
 }
 
+static THREADAPI_RESULT create_thread_attr(pthread_attr_t* attr, const THREAD_ATTRIBUTES* attributes)
+{
+    THREADAPI_RESULT result;
+    int error;
+
+    if ((error = pthread_attr_init(attr)) != 0)
+    {
+        result = (error == ENOMEM) ? THREADAPI_NO_MEMORY : THREADAPI_ERROR;
+        LogError("pthread_attr_init failed: %d", error);
+    }
+    else
+    {
+        result = THREADAPI_OK;
+
+        if ((attributes->stack_size != 0) &&
+            ((error = pthread_attr_setstacksize(attr, attributes->stack_size)) != 0))
+        {
+            result = THREADAPI_INVALID_ARG;
+            LogError("pthread_attr_setstacksize(%lu) failed: %d", (unsigned long)attributes->stack_size, error);
+        }
+        else if (attributes->cpu_affinity_mask != 0)
+        {
+#if defined(__linux__)
+            cpu_set_t cpu_set;
+            unsigned int cpu;
+
+            CPU_ZERO(&cpu_set);
+            for (cpu = 0; (cpu < 64) && (cpu < CPU_SETSIZE); cpu++)
+            {
+                if ((attributes->cpu_affinity_mask & ((uint64_t)1 << cpu)) != 0)
+                {
+                    CPU_SET(cpu, &cpu_set);
+                }
+            }
+
+            if ((error = pthread_attr_setaffinity_np(attr, sizeof(cpu_set), &cpu_set)) != 0)
+            {
+                result = THREADAPI_INVALID_ARG;
+                LogError("pthread_attr_setaffinity_np failed: %d", error);
+            }
+#else
+            result = THREADAPI_INVALID_ARG;
+            LogError("CPU affinity is not supported on this platform");
+#endif
+        }
+
+        if (result != THREADAPI_OK)
+        {
+            (void)pthread_attr_destroy(attr);
+        }
+    }
+
+    return result;
+}
+
 THREADAPI_RESULT ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg)
+{
+    return ThreadAPI_CreateEx(threadHandle, func, arg, NULL);
+}
+
+THREADAPI_RESULT ThreadAPI_CreateEx(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg, const THREAD_ATTRIBUTES* attributes)
 {
     THREADAPI_RESULT result;
+    pthread_attr_t attr;
 
     if ((threadHandle == NULL) ||
         (func == NULL))
@@ -45,6 +250,11 @@ THREADAPI_RESULT ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC
         result = THREADAPI_INVALID_ARG;
         LogError("(result = %s)", ENUM_TO_STRING(THREADAPI_RESULT, result));
     }
+    else if ((attributes != NULL) &&
+        ((result = create_thread_attr(&attr, attributes)) != THREADAPI_OK))
+    {
+        LogError("(result = %s)", ENUM_TO_STRING(THREADAPI_RESULT, result));
+    }
     else
     {
         THREAD_INSTANCE* threadInstance = malloc(sizeof(THREAD_INSTANCE));
@@ -57,28 +267,94 @@ THREADAPI_RESULT ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC
         {
             threadInstance->ThreadStartFunc = func;
             threadInstance->Arg = arg;
-            int createResult = pthread_create(&threadInstance->Pthread_handle, NULL, ThreadWrapper, threadInstance);
-            switch (createResult)
+            threadInstance->Name = (attributes == NULL) ? NULL : attributes->name;
+            threadInstance->Priority = (attributes == NULL) ? THREADAPI_PRIORITY_NORMAL : attributes->priority;
+            threadInstance->StartResult = -1;
+            threadInstance->HasStartSync = (threadInstance->Name != NULL) || (threadInstance->Priority != THREADAPI_PRIORITY_NORMAL);
+
+            if (threadInstance->HasStartSync &&
+                (pthread_mutex_init(&threadInstance->StartLock, NULL) != 0))
             {
-            default:
                 free(threadInstance);
 
                 result = THREADAPI_ERROR;
                 LogError("(result = %s)", ENUM_TO_STRING(THREADAPI_RESULT, result));
-                break;
-
-            case 0:
-                *threadHandle = threadInstance;
-                result = THREADAPI_OK;
-                break;
-
-            case EAGAIN:
+            }
+            else if (threadInstance->HasStartSync &&
+                (pthread_cond_init(&threadInstance->StartCondition, NULL) != 0))
+            {
+                (void)pthread_mutex_destroy(&threadInstance->StartLock);
                 free(threadInstance);
 
-                result = THREADAPI_NO_MEMORY;
+                result = THREADAPI_ERROR;
                 LogError("(result = %s)", ENUM_TO_STRING(THREADAPI_RESULT, result));
-                break;
             }
+            else
+            {
+                int createResult = pthread_create(&threadInstance->Pthread_handle, (attributes == NULL) ? NULL : &attr, ThreadWrapper, threadInstance);
+                switch (createResult)
+                {
+                default:
+                    result = THREADAPI_ERROR;
+                    LogError("(result = %s)", ENUM_TO_STRING(THREADAPI_RESULT, result));
+                    break;
+
+                case 0:
+                    result = THREADAPI_OK;
+                    break;
+
+                case EINVAL:
+                    result = THREADAPI_INVALID_ARG;
+                    LogError("(result = %s)", ENUM_TO_STRING(THREADAPI_RESULT, result));
+                    break;
+
+                case EAGAIN:
+                    result = THREADAPI_NO_MEMORY;
+                    LogError("(result = %s)", ENUM_TO_STRING(THREADAPI_RESULT, result));
+                    break;
+                }
+
+                if ((result == THREADAPI_OK) && threadInstance->HasStartSync)
+                {
+                    int startResult;
+
+                    (void)pthread_mutex_lock(&threadInstance->StartLock);
+                    while (threadInstance->StartResult == -1)
+                    {
+                        (void)pthread_cond_wait(&threadInstance->StartCondition, &threadInstance->StartLock);
+                    }
+                    startResult = threadInstance->StartResult;
+                    (void)pthread_mutex_unlock(&threadInstance->StartLock);
+
+                    if (startResult != 0)
+                    {
+                        /* the thread did not run func, it is done already */
+                        (void)pthread_join(threadInstance->Pthread_handle, NULL);
+
+                        result = ((startResult == EINVAL) || (startResult == ERANGE)) ? THREADAPI_INVALID_ARG : THREADAPI_ERROR;
+                        LogError("(result = %s)", ENUM_TO_STRING(THREADAPI_RESULT, result));
+                    }
+                }
+
+                if (result == THREADAPI_OK)
+                {
+                    *threadHandle = threadInstance;
+                }
+                else
+                {
+                    if (threadInstance->HasStartSync)
+                    {
+                        (void)pthread_cond_destroy(&threadInstance->StartCondition);
+                        (void)pthread_mutex_destroy(&threadInstance->StartLock);
+                    }
+                    free(threadInstance);
+                }
+            }
+        }
+
+        if (attributes != NULL)
+        {
+            (void)pthread_attr_destroy(&attr);
         }
     }
 
@@ -113,6 +389,11 @@ THREADAPI_RESULT ThreadAPI_Join(THREAD_HANDLE threadHandle, int* res)
             result = THREADAPI_OK;
         }
 
+        if (threadInstance->HasStartSync)
+        {
+            (void)pthread_cond_destroy(&threadInstance->StartCondition);
+            (void)pthread_mutex_destroy(&threadInstance->StartLock);
+        }
         free(threadInstance);
     }
 
@@ -34,7 +34,39 @@ static void thread_wrapper(const void* createParamArg)
     free((void*)p);
 }
 
+static osPriority get_thread_priority(THREADAPI_PRIORITY priority)
+{
+    osPriority result;
+
+    switch (priority)
+    {
+    default:
+    case THREADAPI_PRIORITY_NORMAL:
+        result = osPriorityNormal;
+        break;
+    case THREADAPI_PRIORITY_LOWEST:
+        result = osPriorityLow;
+        break;
+    case THREADAPI_PRIORITY_LOW:
+        result = osPriorityBelowNormal;
+        break;
+    case THREADAPI_PRIORITY_HIGH:
+        result = osPriorityAboveNormal;
+        break;
+    case THREADAPI_PRIORITY_HIGHEST:
+        result = osPriorityHigh;
+        break;
+    }
+
+    return result;
+}
+
 THREADAPI_RESULT ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg)
+{
+    return ThreadAPI_CreateEx(threadHandle, func, arg, NULL);
+}
+
+THREADAPI_RESULT ThreadAPI_CreateEx(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg, const THREAD_ATTRIBUTES* attributes)
 {
     THREADAPI_RESULT result;
     if ((threadHandle == NULL) ||
@@ -43,6 +75,13 @@ THREADAPI_RESULT ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC
         result = THREADAPI_INVALID_ARG;
         LogError("(result = %s)", ENUM_TO_STRING(THREADAPI_RESULT, result));
     }
+    else if ((attributes != NULL) &&
+        (attributes->cpu_affinity_mask != 0))
+    {
+        /* there is a single core, the thread name is only informative and is not kept either */
+        result = THREADAPI_INVALID_ARG;
+        LogError("CPU affinity is not supported (result = %s)", ENUM_TO_STRING(THREADAPI_RESULT, result));
+    }
     else
     {
         size_t slot;
@@ -60,7 +99,9 @@ THREADAPI_RESULT ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC
                 param->func = func;
                 param->arg = arg;
                 param->p_thread = threads + slot;
-                threads[slot].thrd = new Thread(thread_wrapper, param, osPriorityNormal, STACK_SIZE);
+                threads[slot].thrd = new Thread(thread_wrapper, param,
+                    (attributes == NULL) ? osPriorityNormal : get_thread_priority(attributes->priority),
+                    ((attributes == NULL) || (attributes->stack_size == 0)) ? STACK_SIZE : attributes->stack_size);
                 *threadHandle = (THREAD_HANDLE)(threads + slot);
                 result = THREADAPI_OK;
             }
@@ -7,7 +7,83 @@
 
 DEFINE_ENUM_STRINGS(THREADAPI_RESULT, THREADAPI_RESULT_VALUES);
 
+typedef HRESULT(WINAPI *SET_THREAD_DESCRIPTION_FUNC)(HANDLE thread, PCWSTR description);
+
+static void set_thread_name(HANDLE thread, const char* name)
+{
+    /* SetThreadDescription only exists from Windows 10 1607 on, the name is only informative so it is skipped where it is missing */
+    SET_THREAD_DESCRIPTION_FUNC set_thread_description = (SET_THREAD_DESCRIPTION_FUNC)GetProcAddress(GetModuleHandleW(L"kernel32.dll"), "SetThreadDescription");
+    if (set_thread_description != NULL)
+    {
+        wchar_t wide_name[64];
+
+        if (MultiByteToWideChar(CP_UTF8, 0, name, -1, wide_name, sizeof(wide_name) / sizeof(wide_name[0])) == 0)
+        {
+            LogError("failure converting the thread name %s", name);
+        }
+        else if (FAILED(set_thread_description(thread, wide_name)))
+        {
+            LogError("failure setting the thread name %s", name);
+        }
+    }
+}
+
+static THREADAPI_RESULT apply_thread_attributes(HANDLE thread, const THREAD_ATTRIBUTES* attributes)
+{
+    THREADAPI_RESULT result;
+    int priority;
+
+    switch (attributes->priority)
+    {
+    default:
+    case THREADAPI_PRIORITY_NORMAL:
+        priority = THREAD_PRIORITY_NORMAL;
+        break;
+    case THREADAPI_PRIORITY_LOWEST:
+        priority = THREAD_PRIORITY_LOWEST;
+        break;
+    case THREADAPI_PRIORITY_LOW:
+        priority = THREAD_PRIORITY_BELOW_NORMAL;
+        break;
+    case THREADAPI_PRIORITY_HIGH:
+        priority = THREAD_PRIORITY_ABOVE_NORMAL;
+        break;
+    case THREADAPI_PRIORITY_HIGHEST:
+        priority = THREAD_PRIORITY_HIGHEST;
+        break;
+    }
+
+    if ((attributes->cpu_affinity_mask != 0) &&
+        (SetThreadAffinityMask(thread, (DWORD_PTR)attributes->cpu_affinity_mask) == 0))
+    {
+        result = (GetLastError() == ERROR_INVALID_PARAMETER) ? THREADAPI_INVALID_ARG : THREADAPI_ERROR;
+        LogError("SetThreadAffinityMask failed: %u", (unsigned int)GetLastError());
+    }
+    else if ((priority != THREAD_PRIORITY_NORMAL) &&
+        (!SetThreadPriority(thread, priority)))
+    {
+        result = THREADAPI_ERROR;
+        LogError("SetThreadPriority failed: %u", (unsigned int)GetLastError());
+    }
+    else
+    {
+        if (attributes->name != NULL)
+        {
+            set_thread_name(thread, attributes->name);
+        }
+
+        result = THREADAPI_OK;
+    }
+
+    return result;
+}
+
 THREADAPI_RESULT ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg)
+{
+    return ThreadAPI_CreateEx(threadHandle, func, arg, NULL);
+}
+
+THREADAPI_RESULT ThreadAPI_CreateEx(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg, const THREAD_ATTRIBUTES* attributes)
 {
     THREADAPI_RESULT result;
     if ((threadHandle == NULL) ||
@@ -16,17 +92,46 @@ THREADAPI_RESULT ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC
         result = THREADAPI_INVALID_ARG;
         LogError("(result = %s)", ENUM_TO_STRING(THREADAPI_RESULT, result));
     }
+    else if ((attributes != NULL) &&
+        (sizeof(DWORD_PTR) < sizeof(uint64_t)) &&
+        ((attributes->cpu_affinity_mask >> (sizeof(DWORD_PTR) * 8)) != 0))
+    {
+        result = THREADAPI_INVALID_ARG;
+        LogError("CPU affinity mask does not fit the platform (result = %s)", ENUM_TO_STRING(THREADAPI_RESULT, result));
+    }
     else
     {
-        *threadHandle = CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)func, arg, 0, NULL);
-        if(*threadHandle == NULL)
+        /* the thread starts suspended, so it never runs func without the attributes it asked for */
+        HANDLE thread = (attributes == NULL) ?
+            CreateThread(NULL, 0, (LPTHREAD_START_ROUTINE)func, arg, 0, NULL) :
+            CreateThread(NULL, attributes->stack_size, (LPTHREAD_START_ROUTINE)func, arg, CREATE_SUSPENDED | ((attributes->stack_size != 0) ? STACK_SIZE_PARAM_IS_A_RESERVATION : 0), NULL);
+        if (thread == NULL)
         {
             result = (GetLastError() == ERROR_OUTOFMEMORY) ? THREADAPI_NO_MEMORY : THREADAPI_ERROR;
 
             LogError("(result = %s)", ENUM_TO_STRING(THREADAPI_RESULT, result));
         }
+        else if ((attributes != NULL) &&
+            ((result = apply_thread_attributes(thread, attributes)) != THREADAPI_OK))
+        {
+            /* the thread never ran, nothing of it needs cleaning up */
+            (void)TerminateThread(thread, 0);
+            (void)CloseHandle(thread);
+
+            LogError("(result = %s)", ENUM_TO_STRING(THREADAPI_RESULT, result));
+        }
+        else if ((attributes != NULL) &&
+            (ResumeThread(thread) == (DWORD)-1))
+        {
+            (void)TerminateThread(thread, 0);
+            (void)CloseHandle(thread);
+
+            result = THREADAPI_ERROR;
+            LogError("ResumeThread failed: %u", (unsigned int)GetLastError());
+        }
         else
         {
+            *threadHandle = thread;
             result = THREADAPI_OK;
         }
     }
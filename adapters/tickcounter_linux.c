@@ -9,22 +9,55 @@
 #include "azure_c_shared_utility/xlogging.h"
 #include "linux_time.h"
 
+// CLOCK_MONOTONIC_RAW is not slewed by NTP, and like CLOCK_MONOTONIC it is read through the
+// vDSO without a system call on recent kernels. Platforms without either go through the
+// time basis of linux_time.
+#if defined(CLOCK_MONOTONIC_RAW)
+#define TICKCOUNTER_CLOCK CLOCK_MONOTONIC_RAW
+#elif defined(CLOCK_MONOTONIC)
+#define TICKCOUNTER_CLOCK CLOCK_MONOTONIC
+#endif
+
+#define MICROSECONDS_IN_1_SECOND 1000000
+#define NANOSECONDS_IN_1_MICROSECOND 1000
+#define MICROSECONDS_IN_1_MILLISECOND 1000
 
 typedef struct TICK_COUNTER_INSTANCE_TAG
 {
-    time_t init_time_value;
+    tickcounter_us_t init_time_us;
     tickcounter_ms_t current_ms;
 } TICK_COUNTER_INSTANCE;
 
+static int get_monotonic_us(tickcounter_us_t* monotonic_us)
+{
+    int result;
+    struct timespec ts;
+
+#if defined(TICKCOUNTER_CLOCK)
+    if (clock_gettime(TICKCOUNTER_CLOCK, &ts) != 0)
+#else
+    set_time_basis();
+    if (get_time_ns(&ts) != 0)
+#endif
+    {
+        LogError("Failed to get the current time");
+        result = __FAILURE__;
+    }
+    else
+    {
+        *monotonic_us = ((tickcounter_us_t)ts.tv_sec * MICROSECONDS_IN_1_SECOND) + ((tickcounter_us_t)ts.tv_nsec / NANOSECONDS_IN_1_MICROSECOND);
+        result = 0;
+    }
+
+    return result;
+}
+
 TICK_COUNTER_HANDLE tickcounter_create(void)
 {
     TICK_COUNTER_INSTANCE* result = (TICK_COUNTER_INSTANCE*)malloc(sizeof(TICK_COUNTER_INSTANCE));
     if (result != NULL)
     {
-        set_time_basis();
-
-        result->init_time_value = get_time_s();
-        if (result->init_time_value == INVALID_TIME_VALUE)
+        if (get_monotonic_us(&result->init_time_us) != 0)
         {
             LogError("tickcounter failed: time return INVALID_TIME.");
             free(result);
@@ -57,15 +90,15 @@ int tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_
     }
     else
     {
-        time_t time_value = get_time_s();
-        if (time_value == INVALID_TIME_VALUE)
+        tickcounter_us_t current_us;
+        if (tickcounter_get_current_us(tick_counter, &current_us) != 0)
         {
             result = __FAILURE__;
         }
         else
         {
             TICK_COUNTER_INSTANCE* tick_counter_instance = (TICK_COUNTER_INSTANCE*)tick_counter;
-            tick_counter_instance->current_ms = (tickcounter_ms_t)(difftime(time_value, tick_counter_instance->init_time_value) * 1000);
+            tick_counter_instance->current_ms = (tickcounter_ms_t)(current_us / MICROSECONDS_IN_1_MILLISECOND);
             *current_ms = tick_counter_instance->current_ms;
             result = 0;
         }
@@ -73,3 +106,47 @@ int tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_
 
     return result;
 }
+
+int tickcounter_get_current_us(TICK_COUNTER_HANDLE tick_counter, tickcounter_us_t * current_us)
+{
+    int result;
+
+    if (tick_counter == NULL || current_us == NULL)
+    {
+        LogError("tickcounter failed: Invalid Arguments.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        tickcounter_us_t now_us;
+        if (get_monotonic_us(&now_us) != 0)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            TICK_COUNTER_INSTANCE* tick_counter_instance = (TICK_COUNTER_INSTANCE*)tick_counter;
+            *current_us = now_us - tick_counter_instance->init_time_us;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int tickcounter_get_monotonic_us(tickcounter_us_t * monotonic_us)
+{
+    int result;
+
+    if (monotonic_us == NULL)
+    {
+        LogError("tickcounter failed: Invalid Arguments.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = get_monotonic_us(monotonic_us);
+    }
+
+    return result;
+}
@@ -11,14 +11,24 @@
 #include "azure_c_shared_utility/xlogging.h"
 
 #define INVALID_TIME_VALUE      (time_t)(-1)
+#define MICROSECONDS_IN_1_SECOND 1000000
+
 typedef struct TICK_COUNTER_INSTANCE_TAG
 {
     LARGE_INTEGER perf_freqency;
+    LARGE_INTEGER start_perf_counter;
     LARGE_INTEGER last_perf_counter;
     time_t backup_time_value;
     tickcounter_ms_t current_ms;
 } TICK_COUNTER_INSTANCE;
 
+static tickcounter_us_t perf_counter_to_us(LONGLONG perf_counter, LONGLONG perf_frequency)
+{
+    // split the conversion so that the multiplication does not overflow after a few days
+    return ((tickcounter_us_t)(perf_counter / perf_frequency) * MICROSECONDS_IN_1_SECOND) +
+        (tickcounter_us_t)(((perf_counter % perf_frequency) * MICROSECONDS_IN_1_SECOND) / perf_frequency);
+}
+
 TICK_COUNTER_HANDLE tickcounter_create(void)
 {
     TICK_COUNTER_INSTANCE* result = (TICK_COUNTER_INSTANCE*)malloc(sizeof(TICK_COUNTER_INSTANCE));
@@ -48,6 +58,7 @@ TICK_COUNTER_HANDLE tickcounter_create(void)
             }
             else
             {
+                result->start_perf_counter = result->last_perf_counter;
                 result->backup_time_value = INVALID_TIME_VALUE;
                 result->current_ms = 0;
             }
@@ -117,3 +128,69 @@ int tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_
     }
     return result;
 }
+
+int tickcounter_get_current_us(TICK_COUNTER_HANDLE tick_counter, tickcounter_us_t* current_us)
+{
+    int result;
+    if (tick_counter == NULL || current_us == NULL)
+    {
+        LogError("tickcounter failed: Invalid Arguments.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        TICK_COUNTER_INSTANCE* tick_counter_instance = (TICK_COUNTER_INSTANCE*)tick_counter;
+        if (tick_counter_instance->backup_time_value == INVALID_TIME_VALUE)
+        {
+            LARGE_INTEGER curr_perf_item;
+            if (!QueryPerformanceCounter(&curr_perf_item))
+            {
+                LogError("tickcounter failed: QueryPerformanceCounter failed %d.", GetLastError());
+                result = __FAILURE__;
+            }
+            else
+            {
+                *current_us = perf_counter_to_us(curr_perf_item.QuadPart - tick_counter_instance->start_perf_counter.QuadPart, tick_counter_instance->perf_freqency.QuadPart);
+                result = 0;
+            }
+        }
+        else
+        {
+            time_t time_value = time(NULL);
+            if (time_value == INVALID_TIME_VALUE)
+            {
+                result = __FAILURE__;
+            }
+            else
+            {
+                *current_us = (tickcounter_us_t)(difftime(time_value, tick_counter_instance->backup_time_value) * MICROSECONDS_IN_1_SECOND);
+                result = 0;
+            }
+        }
+    }
+    return result;
+}
+
+int tickcounter_get_monotonic_us(tickcounter_us_t* monotonic_us)
+{
+    int result;
+    LARGE_INTEGER perf_frequency;
+    LARGE_INTEGER perf_counter;
+
+    if (monotonic_us == NULL)
+    {
+        LogError("tickcounter failed: Invalid Arguments.");
+        result = __FAILURE__;
+    }
+    else if (!QueryPerformanceFrequency(&perf_frequency) || !QueryPerformanceCounter(&perf_counter))
+    {
+        LogError("tickcounter failed: QueryPerformanceCounter failed %d.", GetLastError());
+        result = __FAILURE__;
+    }
+    else
+    {
+        *monotonic_us = perf_counter_to_us(perf_counter.QuadPart, perf_frequency.QuadPart);
+        result = 0;
+    }
+    return result;
+}
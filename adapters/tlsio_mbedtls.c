@@ -5,6 +5,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <string.h>
+#include <limits.h>
 
 #include "mbed_wait_api.h"
 #include "mbedtls/config.h"
@@ -15,6 +16,9 @@
 #include "mbedtls/error.h"
 #include "mbedtls/certs.h"
 #include "mbedtls/entropy_poll.h"
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+#include "mbedtls/memory_buffer_alloc.h"
+#endif
 
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/tlsio.h"
@@ -22,11 +26,14 @@
 #include "azure_c_shared_utility/socketio.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/tlsio_options.h"
+#include "azure_c_shared_utility/lock.h"
 
 static const char *const OPTION_UNDERLYING_IO_OPTIONS = "underlying_io_options";
 
 #define HANDSHAKE_TIMEOUT_MS 5000
 #define HANDSHAKE_WAIT_INTERVAL_MS 10
+#define DEFAULT_READ_CHUNK_SIZE 64
 
 typedef enum TLSIO_STATE_ENUM_TAG
 {
@@ -38,6 +45,31 @@ typedef enum TLSIO_STATE_ENUM_TAG
     TLSIO_STATE_ERROR
 } TLSIO_STATE_ENUM;
 
+/* The lists mbedtls_ssl_conf_curves and mbedtls_ssl_conf_sig_hashes keep a pointer to, they live as long as
+   the configuration they were set on. */
+typedef struct TLS_ALGORITHM_LISTS_TAG
+{
+    mbedtls_ecp_group_id curves[TLSIO_OPTIONS_MAX_LIST_COUNT + 1];
+    int sig_hashes[TLSIO_OPTIONS_MAX_LIST_COUNT + 1];
+} TLS_ALGORITHM_LISTS;
+
+/* Instances with the same trusted certificates, maximum fragment length, groups and signature algorithms share one configuration,
+   and with it the parsed CA chain and the random generator. Instances that authenticate with a client
+   certificate always keep their own configuration. */
+typedef struct TLS_SHARED_CONFIG_TAG
+{
+    char *trusted_certificates;
+    size_t max_fragment_length;
+    TLSIO_OPTIONS tls_options;
+    TLS_ALGORITHM_LISTS algorithm_lists;
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context ctr_drbg;
+    mbedtls_ssl_config config;
+    mbedtls_x509_crt trusted_certificates_parsed;
+    size_t ref_count;
+    struct TLS_SHARED_CONFIG_TAG *next;
+} TLS_SHARED_CONFIG;
+
 typedef struct TLS_IO_INSTANCE_TAG
 {
     XIO_HANDLE socket_io;
@@ -64,11 +96,35 @@ typedef struct TLS_IO_INSTANCE_TAG
     char *trusted_certificates;
 
     char *hostname;
+    int port;
     mbedtls_x509_crt owncert;
     mbedtls_pk_context pKey;
     int tls_status;
+    unsigned char *received_bytes;
+    size_t received_bytes_size;
+    size_t read_chunk_size;
+    bool coalesce_received_bytes;
+    size_t max_fragment_length;
+    TLSIO_OPTIONS tls_options;
+    TLS_ALGORITHM_LISTS algorithm_lists;
+    bool use_shared_config;
+    TLS_SHARED_CONFIG *shared_config;
+    bool use_session_cache;
+    bool session_offered;
 } TLS_IO_INSTANCE;
 
+/* Sessions are keyed by hostname, port and client certificate, as in tlsio_openssl, so that a session
+   authenticated with one device's credentials is never resumed by another TLS_IO_INSTANCE. */
+typedef struct TLS_SESSION_CACHE_ENTRY_TAG
+{
+    char *hostname;
+    int port;
+    unsigned char *client_certificate;
+    size_t client_certificate_length;
+    mbedtls_ssl_session session;
+    struct TLS_SESSION_CACHE_ENTRY_TAG *next;
+} TLS_SESSION_CACHE_ENTRY;
+
 typedef enum TLS_STATE_TAG
 {
     TLS_STATE_NOT_INITIALIZED,
@@ -76,6 +132,14 @@ typedef enum TLS_STATE_TAG
     TLS_STATE_CLOSING,
 } TLS_STATE;
 
+static LOCK_HANDLE shared_config_lock = NULL;
+static TLS_SHARED_CONFIG *shared_configs = NULL;
+static LOCK_HANDLE session_cache_lock = NULL;
+static TLS_SESSION_CACHE_ENTRY *session_cache_entries = NULL;
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+static bool memory_buffer_installed = false;
+#endif
+
 static void indicate_error(TLS_IO_INSTANCE *tls_io_instance)
 {
     if ((tls_io_instance->tlsio_state == TLSIO_STATE_NOT_OPEN) || (tls_io_instance->tlsio_state == TLSIO_STATE_ERROR))
@@ -97,27 +161,234 @@ static void indicate_open_complete(TLS_IO_INSTANCE *tls_io_instance, IO_OPEN_RES
     }
 }
 
+// Makes room for one more read_chunk_size read after the first received_byte_count bytes
+static int reserve_received_bytes(TLS_IO_INSTANCE *tls_io_instance, size_t received_byte_count)
+{
+    int result;
+    size_t needed = received_byte_count + tls_io_instance->read_chunk_size;
+
+    if (needed <= tls_io_instance->received_bytes_size)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t new_size = tls_io_instance->received_bytes_size * 2;
+        unsigned char *new_received_bytes;
+
+        if (new_size < needed)
+        {
+            new_size = needed;
+        }
+
+        new_received_bytes = (unsigned char *)realloc(tls_io_instance->received_bytes, new_size);
+        if (new_received_bytes == NULL)
+        {
+            LogError("Failed growing the receive buffer to %lu bytes.", (unsigned long)new_size);
+            result = __FAILURE__;
+        }
+        else
+        {
+            tls_io_instance->received_bytes = new_received_bytes;
+            tls_io_instance->received_bytes_size = new_size;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
 static int decode_ssl_received_bytes(TLS_IO_INSTANCE *tls_io_instance)
 {
     int result = 0;
-    unsigned char buffer[64];
+    unsigned char buffer[DEFAULT_READ_CHUNK_SIZE];
+    size_t received_byte_count = 0;
     int rcv_bytes = 1;
 
     while (rcv_bytes > 0)
     {
-        rcv_bytes = mbedtls_ssl_read(&tls_io_instance->ssl, buffer, sizeof(buffer));
+        unsigned char *read_buffer;
+
+        if (tls_io_instance->read_chunk_size == DEFAULT_READ_CHUNK_SIZE && !tls_io_instance->coalesce_received_bytes)
+        {
+            read_buffer = buffer;
+        }
+        else if (reserve_received_bytes(tls_io_instance, received_byte_count) != 0)
+        {
+            result = __FAILURE__;
+            break;
+        }
+        else
+        {
+            // when not coalescing received_byte_count is always 0
+            read_buffer = tls_io_instance->received_bytes + received_byte_count;
+        }
+
+        rcv_bytes = mbedtls_ssl_read(&tls_io_instance->ssl, read_buffer, tls_io_instance->read_chunk_size);
         if (rcv_bytes > 0)
         {
-            if (tls_io_instance->on_bytes_received != NULL)
+            if (tls_io_instance->coalesce_received_bytes)
+            {
+                received_byte_count += (size_t)rcv_bytes;
+            }
+            else if (tls_io_instance->on_bytes_received != NULL)
             {
-                tls_io_instance->on_bytes_received(tls_io_instance->on_bytes_received_context, buffer, rcv_bytes);
+                tls_io_instance->on_bytes_received(tls_io_instance->on_bytes_received_context, read_buffer, rcv_bytes);
             }
         }
     }
 
+    // everything decoded by this pass is indicated at once, including what was read before a failure
+    if (received_byte_count > 0 && tls_io_instance->on_bytes_received != NULL)
+    {
+        tls_io_instance->on_bytes_received(tls_io_instance->on_bytes_received_context, tls_io_instance->received_bytes, received_byte_count);
+    }
+
     return result;
 }
 
+// Must be called with session_cache_lock held
+static TLS_SESSION_CACHE_ENTRY **find_session_cache_entry(TLS_IO_INSTANCE *tls_io_instance)
+{
+    TLS_SESSION_CACHE_ENTRY **entry = &session_cache_entries;
+    // The DER of the client certificate, empty when it was not set
+    size_t client_certificate_length = (tls_io_instance->owncert.version > 0) ? tls_io_instance->owncert.raw.len : 0;
+
+    while ((*entry != NULL) &&
+           (((*entry)->port != tls_io_instance->port) ||
+            (strcmp((*entry)->hostname, tls_io_instance->hostname) != 0) ||
+            ((*entry)->client_certificate_length != client_certificate_length) ||
+            ((client_certificate_length > 0) && (memcmp((*entry)->client_certificate, tls_io_instance->owncert.raw.p, client_certificate_length) != 0))))
+    {
+        entry = &(*entry)->next;
+    }
+
+    return entry;
+}
+
+static void free_session_cache_entry(TLS_SESSION_CACHE_ENTRY *entry)
+{
+    mbedtls_ssl_session_free(&entry->session);
+    free(entry->client_certificate);
+    free(entry->hostname);
+    free(entry);
+}
+
+static TLS_SESSION_CACHE_ENTRY *create_session_cache_entry(TLS_IO_INSTANCE *tls_io_instance)
+{
+    TLS_SESSION_CACHE_ENTRY *result = (TLS_SESSION_CACHE_ENTRY *)calloc(1, sizeof(TLS_SESSION_CACHE_ENTRY));
+
+    if (result == NULL)
+    {
+        LogError("Failed allocating TLS session cache entry.");
+    }
+    else
+    {
+        mbedtls_ssl_session_init(&result->session);
+        result->port = tls_io_instance->port;
+
+        if (mallocAndStrcpy_s(&result->hostname, tls_io_instance->hostname) != 0)
+        {
+            LogError("Failed copying the hostname of a TLS session cache entry.");
+            free_session_cache_entry(result);
+            result = NULL;
+        }
+        else if (tls_io_instance->owncert.version > 0)
+        {
+            if ((result->client_certificate = (unsigned char *)malloc(tls_io_instance->owncert.raw.len)) == NULL)
+            {
+                LogError("Failed copying the certificate of a TLS session cache entry.");
+                free_session_cache_entry(result);
+                result = NULL;
+            }
+            else
+            {
+                (void)memcpy(result->client_certificate, tls_io_instance->owncert.raw.p, tls_io_instance->owncert.raw.len);
+                result->client_certificate_length = tls_io_instance->owncert.raw.len;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void save_session(TLS_IO_INSTANCE *tls_io_instance)
+{
+    if (Lock(session_cache_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the TLS session cache.");
+    }
+    else
+    {
+        TLS_SESSION_CACHE_ENTRY **entry = find_session_cache_entry(tls_io_instance);
+
+        if ((*entry == NULL) &&
+            ((*entry = create_session_cache_entry(tls_io_instance)) == NULL))
+        {
+            LogError("Failed adding the session to the TLS session cache.");
+        }
+        else
+        {
+            // The session ID and, if the server sent one, the session ticket are copied into the entry
+            mbedtls_ssl_session_free(&(*entry)->session);
+            mbedtls_ssl_session_init(&(*entry)->session);
+            if (mbedtls_ssl_get_session(&tls_io_instance->ssl, &(*entry)->session) != 0)
+            {
+                TLS_SESSION_CACHE_ENTRY *failed_entry = *entry;
+                LogError("Failed getting the TLS session.");
+                *entry = failed_entry->next;
+                free_session_cache_entry(failed_entry);
+            }
+        }
+
+        (void)Unlock(session_cache_lock);
+    }
+}
+
+static void offer_cached_session(TLS_IO_INSTANCE *tls_io_instance)
+{
+    tls_io_instance->session_offered = false;
+
+    if (Lock(session_cache_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the TLS session cache.");
+    }
+    else
+    {
+        TLS_SESSION_CACHE_ENTRY *entry = *find_session_cache_entry(tls_io_instance);
+
+        // mbedtls_ssl_set_session copies the session, so the entry can be replaced while the handshake runs
+        if ((entry != NULL) &&
+            (mbedtls_ssl_set_session(&tls_io_instance->ssl, &entry->session) == 0))
+        {
+            tls_io_instance->session_offered = true;
+        }
+
+        (void)Unlock(session_cache_lock);
+    }
+}
+
+static void forget_offered_session(TLS_IO_INSTANCE *tls_io_instance)
+{
+    if (Lock(session_cache_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the TLS session cache.");
+    }
+    else
+    {
+        // Do not keep offering a session that might be the reason the handshake is failing
+        TLS_SESSION_CACHE_ENTRY **entry = find_session_cache_entry(tls_io_instance);
+        if (*entry != NULL)
+        {
+            TLS_SESSION_CACHE_ENTRY *failed_entry = *entry;
+            *entry = failed_entry->next;
+            free_session_cache_entry(failed_entry);
+        }
+
+        (void)Unlock(session_cache_lock);
+    }
+}
+
 static void on_underlying_io_open_complete(void *context, IO_OPEN_RESULT open_result)
 {
     if (context == NULL)
@@ -139,11 +410,28 @@ static void on_underlying_io_open_complete(void *context, IO_OPEN_RESULT open_re
         {
             tls_io_instance->tlsio_state = TLSIO_STATE_IN_HANDSHAKE;
 
+            if (tls_io_instance->use_session_cache)
+            {
+                offer_cached_session(tls_io_instance);
+            }
+
             do
             {
                 result = mbedtls_ssl_handshake(&tls_io_instance->ssl);
             } while (result == MBEDTLS_ERR_SSL_WANT_READ || result == MBEDTLS_ERR_SSL_WANT_WRITE);
 
+            if (tls_io_instance->use_session_cache)
+            {
+                if (result == 0)
+                {
+                    save_session(tls_io_instance);
+                }
+                else if (tls_io_instance->session_offered)
+                {
+                    forget_offered_session(tls_io_instance);
+                }
+            }
+
             if (result == 0)
             {
                 tls_io_instance->tlsio_state = TLSIO_STATE_OPEN;
@@ -318,41 +606,466 @@ static int on_io_recv(void *context, unsigned char *buf, size_t sz)
     return result;
 }
 
-static int on_io_send(void *context, const unsigned char *buf, size_t sz)
+static int on_io_send(void *context, const unsigned char *buf, size_t sz)
+{
+    int result;
+    if (context == NULL)
+    {
+        LogError("Invalid context NULL value passed");
+        result = 0;
+    }
+    else
+    {
+        TLS_IO_INSTANCE *tls_io_instance = (TLS_IO_INSTANCE *)context;
+
+        if (xio_send(tls_io_instance->socket_io, buf, sz, tls_io_instance->on_send_complete, tls_io_instance->on_send_complete_callback_context) != 0)
+        {
+            indicate_error(tls_io_instance);
+            result = 0;
+        }
+        else
+        {
+            result = sz;
+        }
+    }
+    return result;
+}
+
+static int tlsio_entropy_poll(void *v, unsigned char *output, size_t len, size_t *olen)
+{
+    (void)v;
+    int result = 0;
+    srand((unsigned int)time(NULL));
+    for (uint16_t i = 0; i < len; i++)
+    {
+        output[i] = rand() % 256;
+    }
+    *olen = len;
+    return result;
+}
+
+static void init_ssl_config(mbedtls_entropy_context *entropy, mbedtls_ctr_drbg_context *ctr_drbg, mbedtls_ssl_config *config)
+{
+    const char *pers = "azure_iot_client";
+
+    mbedtls_entropy_init(entropy);
+    // Add a weak entropy source here,avoid some platform doesn't have strong / hardware entropy
+    mbedtls_entropy_add_source(entropy, tlsio_entropy_poll, NULL, MBEDTLS_ENTROPY_MAX_GATHER, MBEDTLS_ENTROPY_SOURCE_WEAK);
+
+    mbedtls_ctr_drbg_init(ctr_drbg);
+    mbedtls_ctr_drbg_seed(ctr_drbg, mbedtls_entropy_func, entropy, (const unsigned char *)pers, strlen(pers));
+
+    mbedtls_ssl_config_init(config);
+    mbedtls_ssl_config_defaults(config, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
+    mbedtls_ssl_conf_rng(config, mbedtls_ctr_drbg_random, ctr_drbg);
+    mbedtls_ssl_conf_authmode(config, MBEDTLS_SSL_VERIFY_REQUIRED);
+    mbedtls_ssl_conf_min_version(config, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3); // v1.2
+}
+
+// Asks the server for records of at most max_fragment_length bytes (RFC 6066), 0 for the default of 16KB
+static int set_max_fragment_length(mbedtls_ssl_config *config, size_t max_fragment_length)
+{
+    int result;
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+    unsigned char mfl_code;
+
+    switch (max_fragment_length)
+    {
+    case 0:
+        mfl_code = MBEDTLS_SSL_MAX_FRAG_LEN_NONE;
+        break;
+    case 512:
+        mfl_code = MBEDTLS_SSL_MAX_FRAG_LEN_512;
+        break;
+    case 1024:
+        mfl_code = MBEDTLS_SSL_MAX_FRAG_LEN_1024;
+        break;
+    case 2048:
+        mfl_code = MBEDTLS_SSL_MAX_FRAG_LEN_2048;
+        break;
+    case 4096:
+        mfl_code = MBEDTLS_SSL_MAX_FRAG_LEN_4096;
+        break;
+    default:
+        mfl_code = MBEDTLS_SSL_MAX_FRAG_LEN_INVALID;
+        break;
+    }
+
+    if (mfl_code == MBEDTLS_SSL_MAX_FRAG_LEN_INVALID)
+    {
+        LogError("Invalid maximum fragment length %lu, it must be 0, 512, 1024, 2048 or 4096", (unsigned long)max_fragment_length);
+        result = __FAILURE__;
+    }
+    else if (mbedtls_ssl_conf_max_frag_len(config, mfl_code) != 0)
+    {
+        LogError("Failed setting the maximum fragment length");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+#else
+    (void)config;
+    if (max_fragment_length != 0)
+    {
+        LogError("mbedTLS was built without MBEDTLS_SSL_MAX_FRAGMENT_LENGTH");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+#endif
+    return result;
+}
+
+// Offers the groups and signature algorithms of tls_options, when set, in their order. mbedTLS 2 only negotiates
+// TLS 1.2, where the groups are elliptic curves and the signature algorithms can only choose the hashes offered,
+// each of them for every key type.
+static int set_algorithm_lists(mbedtls_ssl_config *config, const TLSIO_OPTIONS *tls_options, TLS_ALGORITHM_LISTS *algorithm_lists)
+{
+    int result = 0;
+    size_t count = 0;
+    size_t i;
+
+    for (i = 0; (result == 0) && (i < tls_options->group_count); i++)
+    {
+#if defined(MBEDTLS_ECP_C)
+        const mbedtls_ecp_curve_info *curve_info = mbedtls_ecp_curve_info_from_tls_id(tls_options->group_ids[i]);
+
+        if (curve_info == NULL)
+        {
+            LogError("The group %u of tls_groups is not supported by mbedTLS", (unsigned int)tls_options->group_ids[i]);
+            result = __FAILURE__;
+        }
+        else
+        {
+            algorithm_lists->curves[count++] = curve_info->grp_id;
+        }
+#else
+        LogError("mbedTLS was built without MBEDTLS_ECP_C, tls_groups cannot be used");
+        result = __FAILURE__;
+#endif
+    }
+
+    if ((result == 0) && (count != 0))
+    {
+        algorithm_lists->curves[count] = MBEDTLS_ECP_DP_NONE;
+        mbedtls_ssl_conf_curves(config, algorithm_lists->curves);
+    }
+
+    count = 0;
+    for (i = 0; (result == 0) && (i < tls_options->signature_algorithm_count); i++)
+    {
+        uint16_t signature_algorithm = tls_options->signature_algorithm_ids[i];
+        int hash;
+        size_t j;
+
+        // rsa_pss_* and ed* have no TLS 1.2 equivalent in mbedTLS 2
+        switch ((signature_algorithm & 0xff00) == 0x0800 ? 0 : (signature_algorithm >> 8))
+        {
+        case 4:
+            hash = MBEDTLS_MD_SHA256;
+            break;
+        case 5:
+            hash = MBEDTLS_MD_SHA384;
+            break;
+        case 6:
+            hash = MBEDTLS_MD_SHA512;
+            break;
+        default:
+            hash = MBEDTLS_MD_NONE;
+            break;
+        }
+
+        for (j = 0; (j < count) && (algorithm_lists->sig_hashes[j] != hash); j++)
+        {
+        }
+
+        if (hash == MBEDTLS_MD_NONE)
+        {
+            LogError("The signature algorithm 0x%04x of tls_signature_algorithms is not supported by mbedTLS", (unsigned int)signature_algorithm);
+            result = __FAILURE__;
+        }
+        else if (j == count)
+        {
+            algorithm_lists->sig_hashes[count++] = hash;
+        }
+        else
+        {
+            // Already offered for an earlier signature algorithm
+        }
+    }
+
+    if ((result == 0) && (count != 0))
+    {
+#if defined(MBEDTLS_KEY_EXCHANGE__WITH_CERT__ENABLED)
+        algorithm_lists->sig_hashes[count] = MBEDTLS_MD_NONE;
+        mbedtls_ssl_conf_sig_hashes(config, algorithm_lists->sig_hashes);
+#else
+        LogError("mbedTLS was built without a certificate based key exchange, tls_signature_algorithms cannot be used");
+        result = __FAILURE__;
+#endif
+    }
+
+    return result;
+}
+
+static bool is_same_string(const char *a, const char *b)
+{
+    return ((a == NULL) && (b == NULL)) ||
+        ((a != NULL) && (b != NULL) && (strcmp(a, b) == 0));
+}
+
+static void free_shared_config(TLS_SHARED_CONFIG *shared_config)
+{
+    mbedtls_ssl_config_free(&shared_config->config);
+    mbedtls_x509_crt_free(&shared_config->trusted_certificates_parsed);
+    mbedtls_ctr_drbg_free(&shared_config->ctr_drbg);
+    mbedtls_entropy_free(&shared_config->entropy);
+    free(shared_config->trusted_certificates);
+    tlsio_options_release_resources(&shared_config->tls_options);
+    free(shared_config);
+}
+
+static TLS_SHARED_CONFIG *create_shared_config(TLS_IO_INSTANCE *tls_io_instance)
+{
+    TLS_SHARED_CONFIG *result = (TLS_SHARED_CONFIG *)calloc(1, sizeof(TLS_SHARED_CONFIG));
+
+    if (result == NULL)
+    {
+        LogError("Failed allocating the shared TLS configuration");
+    }
+    else
+    {
+        mbedtls_x509_crt_init(&result->trusted_certificates_parsed);
+        init_ssl_config(&result->entropy, &result->ctr_drbg, &result->config);
+        result->max_fragment_length = tls_io_instance->max_fragment_length;
+        tlsio_options_initialize(&result->tls_options, TLSIO_OPTION_BIT_GROUPS | TLSIO_OPTION_BIT_SIGNATURE_ALGORITHMS);
+        result->ref_count = 1;
+
+        if ((tls_io_instance->trusted_certificates != NULL) &&
+            (mallocAndStrcpy_s(&result->trusted_certificates, tls_io_instance->trusted_certificates) != 0))
+        {
+            LogError("Failed copying the trusted certificates");
+            free_shared_config(result);
+            result = NULL;
+        }
+        else if ((result->trusted_certificates != NULL) &&
+                 (mbedtls_x509_crt_parse(&result->trusted_certificates_parsed, (const unsigned char *)result->trusted_certificates, (int)(strlen(result->trusted_certificates) + 1)) != 0))
+        {
+            LogInfo("Malformed pem certificate");
+            free_shared_config(result);
+            result = NULL;
+        }
+        else if (set_max_fragment_length(&result->config, result->max_fragment_length) != 0)
+        {
+            free_shared_config(result);
+            result = NULL;
+        }
+        else if (((tls_io_instance->tls_options.groups != NULL) &&
+                  (tlsio_options_set(&result->tls_options, OPTION_TLS_GROUPS, tls_io_instance->tls_options.groups) != TLSIO_OPTIONS_RESULT_SUCCESS)) ||
+                 ((tls_io_instance->tls_options.signature_algorithms != NULL) &&
+                  (tlsio_options_set(&result->tls_options, OPTION_TLS_SIGNATURE_ALGORITHMS, tls_io_instance->tls_options.signature_algorithms) != TLSIO_OPTIONS_RESULT_SUCCESS)))
+        {
+            LogError("Failed copying the groups and signature algorithms");
+            free_shared_config(result);
+            result = NULL;
+        }
+        else if (set_algorithm_lists(&result->config, &result->tls_options, &result->algorithm_lists) != 0)
+        {
+            free_shared_config(result);
+            result = NULL;
+        }
+        else
+        {
+            if (result->trusted_certificates != NULL)
+            {
+                mbedtls_ssl_conf_ca_chain(&result->config, &result->trusted_certificates_parsed, NULL);
+            }
+        }
+    }
+
+    return result;
+}
+
+static bool is_shared_config_for(const TLS_SHARED_CONFIG *shared_config, const TLS_IO_INSTANCE *tls_io_instance)
+{
+    // Entries never change once created, they can be compared without the lock
+    return (shared_config->max_fragment_length == tls_io_instance->max_fragment_length) &&
+        is_same_string(shared_config->trusted_certificates, tls_io_instance->trusted_certificates) &&
+        is_same_string(shared_config->tls_options.groups, tls_io_instance->tls_options.groups) &&
+        is_same_string(shared_config->tls_options.signature_algorithms, tls_io_instance->tls_options.signature_algorithms);
+}
+
+static TLS_SHARED_CONFIG *acquire_shared_config(TLS_IO_INSTANCE *tls_io_instance)
+{
+    TLS_SHARED_CONFIG *result;
+
+    if (Lock(shared_config_lock) != LOCK_OK)
+    {
+        LogError("Failed locking the shared TLS configurations");
+        result = NULL;
+    }
+    else
+    {
+        result = shared_configs;
+        while ((result != NULL) && !is_shared_config_for(result, tls_io_instance))
+        {
+            result = result->next;
+        }
+
+        if (result != NULL)
+        {
+            result->ref_count++;
+        }
+        else if ((result = create_shared_config(tls_io_instance)) != NULL)
+        {
+            result->next = shared_configs;
+            shared_configs = result;
+        }
+
+        (void)Unlock(shared_config_lock);
+    }
+
+    return result;
+}
+
+static void release_shared_config(TLS_SHARED_CONFIG *shared_config)
+{
+    if (Lock(shared_config_lock) != LOCK_OK)
+    {
+        LogError("Failed locking the shared TLS configurations");
+    }
+    else
+    {
+        if (--shared_config->ref_count == 0)
+        {
+            TLS_SHARED_CONFIG **entry = &shared_configs;
+
+            while ((*entry != NULL) && (*entry != shared_config))
+            {
+                entry = &(*entry)->next;
+            }
+            if (*entry != NULL)
+            {
+                *entry = shared_config->next;
+            }
+
+            free_shared_config(shared_config);
+        }
+
+        (void)Unlock(shared_config_lock);
+    }
+}
+
+// Sets up the SSL context again, with the records buffers sized for the new configuration
+static int bind_ssl_config(TLS_IO_INSTANCE *tls_io_instance, const mbedtls_ssl_config *config)
+{
+    int result;
+
+    mbedtls_ssl_free(&tls_io_instance->ssl);
+    mbedtls_ssl_init(&tls_io_instance->ssl);
+    mbedtls_ssl_set_bio(&tls_io_instance->ssl, tls_io_instance, on_io_send, on_io_recv, NULL);
+
+    if (mbedtls_ssl_setup(&tls_io_instance->ssl, config) != 0)
+    {
+        LogError("Failed setting up the SSL context");
+        result = __FAILURE__;
+    }
+    else if (mbedtls_ssl_set_hostname(&tls_io_instance->ssl, tls_io_instance->hostname) != 0)
+    {
+        LogError("Failed setting the host name");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static int parse_trusted_certificates(TLS_IO_INSTANCE *tls_io_instance)
+{
+    int result;
+    int parse_result = mbedtls_x509_crt_parse(&tls_io_instance->trusted_certificates_parsed, (const unsigned char *)tls_io_instance->trusted_certificates, (int)(strlen(tls_io_instance->trusted_certificates) + 1));
+
+    if (parse_result != 0)
+    {
+        LogInfo("Malformed pem certificate");
+        result = __FAILURE__;
+    }
+    else
+    {
+        mbedtls_ssl_conf_ca_chain(&tls_io_instance->config, &tls_io_instance->trusted_certificates_parsed, NULL);
+        result = 0;
+    }
+
+    return result;
+}
+
+// Picks the configuration the next handshake uses
+static int prepare_ssl_config(TLS_IO_INSTANCE *tls_io_instance)
 {
     int result;
-    if (context == NULL)
+    bool has_client_certificate = (tls_io_instance->owncert.version > 0) || (tls_io_instance->pKey.pk_info != NULL);
+
+    if (!tls_io_instance->use_shared_config || has_client_certificate)
+    {
+        if (tls_io_instance->use_shared_config)
+        {
+            LogInfo("A TLS IO with a client certificate does not share its configuration");
+        }
+
+        if (tls_io_instance->use_shared_config &&
+            tls_io_instance->trusted_certificates != NULL &&
+            tls_io_instance->trusted_certificates_parsed.version == 0 &&
+            parse_trusted_certificates(tls_io_instance) != 0)
+        {
+            result = __FAILURE__;
+        }
+        else if (tls_io_instance->shared_config == NULL)
+        {
+            result = 0;
+        }
+        else
+        {
+            result = bind_ssl_config(tls_io_instance, &tls_io_instance->config);
+            release_shared_config(tls_io_instance->shared_config);
+            tls_io_instance->shared_config = NULL;
+        }
+    }
+    else if ((tls_io_instance->shared_config != NULL) && is_shared_config_for(tls_io_instance->shared_config, tls_io_instance))
     {
-        LogError("Invalid context NULL value passed");
         result = 0;
     }
     else
     {
-        TLS_IO_INSTANCE *tls_io_instance = (TLS_IO_INSTANCE *)context;
+        TLS_SHARED_CONFIG *shared_config = acquire_shared_config(tls_io_instance);
 
-        if (xio_send(tls_io_instance->socket_io, buf, sz, tls_io_instance->on_send_complete, tls_io_instance->on_send_complete_callback_context) != 0)
+        if (shared_config == NULL)
         {
-            indicate_error(tls_io_instance);
-            result = 0;
+            LogError("Failed getting the shared TLS configuration");
+            result = __FAILURE__;
+        }
+        else if (bind_ssl_config(tls_io_instance, &shared_config->config) != 0)
+        {
+            release_shared_config(shared_config);
+            result = __FAILURE__;
         }
         else
         {
-            result = sz;
+            if (tls_io_instance->shared_config != NULL)
+            {
+                release_shared_config(tls_io_instance->shared_config);
+            }
+            tls_io_instance->shared_config = shared_config;
+            result = 0;
         }
     }
-    return result;
-}
 
-static int tlsio_entropy_poll(void *v, unsigned char *output, size_t len, size_t *olen)
-{
-    (void)v;
-    int result = 0;
-    srand((unsigned int)time(NULL));
-    for (uint16_t i = 0; i < len; i++)
-    {
-        output[i] = rand() % 256;
-    }
-    *olen = len;
     return result;
 }
 
@@ -386,23 +1099,10 @@ static void mbedtls_init(TLS_IO_INSTANCE *tls_io_instance)
         mbedtls_uninit(tls_io_instance);
     }
 
-    const char *pers = "azure_iot_client";
-
     // mbedTLS initialize...
     mbedtls_x509_crt_init(&tls_io_instance->trusted_certificates_parsed);
 
-    mbedtls_entropy_init(&tls_io_instance->entropy);
-    // Add a weak entropy source here,avoid some platform doesn't have strong / hardware entropy
-    mbedtls_entropy_add_source(&tls_io_instance->entropy, tlsio_entropy_poll, NULL, MBEDTLS_ENTROPY_MAX_GATHER, MBEDTLS_ENTROPY_SOURCE_WEAK);
-
-    mbedtls_ctr_drbg_init(&tls_io_instance->ctr_drbg);
-    mbedtls_ctr_drbg_seed(&tls_io_instance->ctr_drbg, mbedtls_entropy_func, &tls_io_instance->entropy, (const unsigned char *)pers, strlen(pers));
-
-    mbedtls_ssl_config_init(&tls_io_instance->config);
-    mbedtls_ssl_config_defaults(&tls_io_instance->config, MBEDTLS_SSL_IS_CLIENT, MBEDTLS_SSL_TRANSPORT_STREAM, MBEDTLS_SSL_PRESET_DEFAULT);
-    mbedtls_ssl_conf_rng(&tls_io_instance->config, mbedtls_ctr_drbg_random, &tls_io_instance->ctr_drbg);
-    mbedtls_ssl_conf_authmode(&tls_io_instance->config, MBEDTLS_SSL_VERIFY_REQUIRED);
-    mbedtls_ssl_conf_min_version(&tls_io_instance->config, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3); // v1.2
+    init_ssl_config(&tls_io_instance->entropy, &tls_io_instance->ctr_drbg, &tls_io_instance->config);
 
     mbedtls_ssl_init(&tls_io_instance->ssl);
     mbedtls_ssl_set_bio(&tls_io_instance->ssl, tls_io_instance, on_io_send, on_io_recv, NULL);
@@ -459,6 +1159,7 @@ CONCRETE_IO_HANDLE tlsio_mbedtls_create(void *io_create_parameters)
             else
             {
 
+                result->port = tls_io_config->port;
                 result->hostname = strdup(tls_io_config->hostname);
                 if (result->hostname == NULL)
                 {
@@ -478,6 +1179,8 @@ CONCRETE_IO_HANDLE tlsio_mbedtls_create(void *io_create_parameters)
                     else
                     {
                         result->tls_status = TLS_STATE_NOT_INITIALIZED;
+                        result->read_chunk_size = DEFAULT_READ_CHUNK_SIZE;
+                        tlsio_options_initialize(&result->tls_options, TLSIO_OPTION_BIT_GROUPS | TLSIO_OPTION_BIT_SIGNATURE_ALGORITHMS);
                         mbedtls_init(result);
 
                         result->tlsio_state = TLSIO_STATE_NOT_OPEN;
@@ -498,6 +1201,11 @@ void tlsio_mbedtls_destroy(CONCRETE_IO_HANDLE tls_io)
 
         mbedtls_uninit(tls_io_instance);
 
+        if (tls_io_instance->shared_config != NULL)
+        {
+            release_shared_config(tls_io_instance->shared_config);
+            tls_io_instance->shared_config = NULL;
+        }
         if (tls_io_instance->socket_io_read_bytes != NULL)
         {
             free(tls_io_instance->socket_io_read_bytes);
@@ -513,6 +1221,12 @@ void tlsio_mbedtls_destroy(CONCRETE_IO_HANDLE tls_io)
             free(tls_io_instance->trusted_certificates);
             tls_io_instance->trusted_certificates = NULL;
         }
+        tlsio_options_release_resources(&tls_io_instance->tls_options);
+        if (tls_io_instance->received_bytes != NULL)
+        {
+            free(tls_io_instance->received_bytes);
+            tls_io_instance->received_bytes = NULL;
+        }
 
         xio_destroy(tls_io_instance->socket_io);
 
@@ -550,16 +1264,24 @@ int tlsio_mbedtls_open(CONCRETE_IO_HANDLE tls_io, ON_IO_OPEN_COMPLETE on_io_open
             tls_io_instance->on_io_error = on_io_error;
             tls_io_instance->on_io_error_context = on_io_error_context;
 
-            tls_io_instance->tlsio_state = TLSIO_STATE_OPENING_UNDERLYING_IO;
+            if (prepare_ssl_config(tls_io_instance) != 0)
+            {
+                LogError("Failed preparing the TLS configuration");
+                result = __FAILURE__;
+            }
+            else
+            {
+                tls_io_instance->tlsio_state = TLSIO_STATE_OPENING_UNDERLYING_IO;
 
-            mbedtls_ssl_session_reset(&tls_io_instance->ssl);
+                mbedtls_ssl_session_reset(&tls_io_instance->ssl);
 
-            if (xio_open(tls_io_instance->socket_io, on_underlying_io_open_complete, tls_io_instance, on_underlying_io_bytes_received, tls_io_instance, on_underlying_io_error, tls_io_instance) != 0)
-            {
+                if (xio_open(tls_io_instance->socket_io, on_underlying_io_open_complete, tls_io_instance, on_underlying_io_bytes_received, tls_io_instance, on_underlying_io_error, tls_io_instance) != 0)
+                {
 
-                LogError("Underlying IO open failed");
-                tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
-                result = __FAILURE__;
+                    LogError("Underlying IO open failed");
+                    tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+                    result = __FAILURE__;
+                }
             }
         }
     }
@@ -684,6 +1406,65 @@ static void *tlsio_mbedtls_CloneOption(const char *name, const void *value)
                 /*return as is*/
             }
         }
+        else if (strcmp(name, OPTION_TLS_GROUPS) == 0 || strcmp(name, OPTION_TLS_SIGNATURE_ALGORITHMS) == 0)
+        {
+            if (tlsio_options_clone_option(name, value, &result) != TLSIO_OPTIONS_RESULT_SUCCESS)
+            {
+                LogError("unable to clone %s value", name);
+                result = NULL;
+            }
+            else
+            {
+                /*return as is*/
+            }
+        }
+        else if (strcmp(name, OPTION_TLS_READ_CHUNK_SIZE) == 0)
+        {
+            size_t *value_clone;
+
+            if ((value_clone = (size_t *)malloc(sizeof(size_t))) == NULL)
+            {
+                LogError("unable to clone tls_read_chunk_size value");
+            }
+            else
+            {
+                *value_clone = *(const size_t *)value;
+            }
+
+            result = value_clone;
+        }
+        else if (strcmp(name, OPTION_TLS_MAX_FRAGMENT_LENGTH) == 0)
+        {
+            size_t *value_clone;
+
+            if ((value_clone = (size_t *)malloc(sizeof(size_t))) == NULL)
+            {
+                LogError("unable to clone tls_max_fragment_length value");
+            }
+            else
+            {
+                *value_clone = *(const size_t *)value;
+            }
+
+            result = value_clone;
+        }
+        else if (strcmp(name, OPTION_TLS_COALESCE_RECEIVED_BYTES) == 0 ||
+                 strcmp(name, OPTION_TLS_SHARED_CONTEXT) == 0 ||
+                 strcmp(name, OPTION_TLS_SESSION_CACHE) == 0)
+        {
+            bool *value_clone;
+
+            if ((value_clone = (bool *)malloc(sizeof(bool))) == NULL)
+            {
+                LogError("unable to clone %s value", name);
+            }
+            else
+            {
+                *value_clone = *(const bool *)value;
+            }
+
+            result = value_clone;
+        }
         else
         {
             LogError("not handled option : %s", name);
@@ -696,14 +1477,21 @@ static void *tlsio_mbedtls_CloneOption(const char *name, const void *value)
 /*this function destroys an option previously created*/
 static void tlsio_mbedtls_DestroyOption(const char *name, const void *value)
 {
-    /*since all options for this layer are actually string copies., disposing of one is just calling free*/
+    /*since all options for this layer are actually heap copies, disposing of one is just calling free*/
     if (name == NULL || value == NULL)
     {
         LogError("invalid parameter detected: const char* name=%p, const void* value=%p", name, value);
     }
     else
     {
-        if (strcmp(name, OPTION_TRUSTED_CERT) == 0)
+        if (strcmp(name, OPTION_TRUSTED_CERT) == 0 ||
+            strcmp(name, OPTION_TLS_READ_CHUNK_SIZE) == 0 ||
+            strcmp(name, OPTION_TLS_COALESCE_RECEIVED_BYTES) == 0 ||
+            strcmp(name, OPTION_TLS_MAX_FRAGMENT_LENGTH) == 0 ||
+            strcmp(name, OPTION_TLS_GROUPS) == 0 ||
+            strcmp(name, OPTION_TLS_SIGNATURE_ALGORITHMS) == 0 ||
+            strcmp(name, OPTION_TLS_SHARED_CONTEXT) == 0 ||
+            strcmp(name, OPTION_TLS_SESSION_CACHE) == 0)
         {
             free((void *)value);
         }
@@ -743,18 +1531,13 @@ int tlsio_mbedtls_setoption(CONCRETE_IO_HANDLE tls_io, const char *optionName, c
                 LogError("unable to mallocAndStrcpy_s");
                 result = __FAILURE__;
             }
+            else if (!tls_io_instance->use_shared_config)
+            {
+                result = parse_trusted_certificates(tls_io_instance);
+            }
             else
             {
-                int parse_result = mbedtls_x509_crt_parse(&tls_io_instance->trusted_certificates_parsed, (const unsigned char *)value, (int)(strlen(value) + 1));
-                if (parse_result != 0)
-                {
-                    LogInfo("Malformed pem certificate");
-                    result = __FAILURE__;
-                }
-                else
-                {
-                    mbedtls_ssl_conf_ca_chain(&tls_io_instance->config, &tls_io_instance->trusted_certificates_parsed, NULL);
-                }
+                // Parsed once per distinct value by the shared configuration, at open
             }
         }
         else if (strcmp(SU_OPTION_X509_CERT, optionName) == 0 || strcmp(OPTION_X509_ECC_CERT, optionName) == 0)
@@ -785,6 +1568,121 @@ int tlsio_mbedtls_setoption(CONCRETE_IO_HANDLE tls_io, const char *optionName, c
                 }
             }
         }
+        else if (strcmp(OPTION_TLS_READ_CHUNK_SIZE, optionName) == 0)
+        {
+            if (value == NULL || *(const size_t *)value == 0 || *(const size_t *)value > INT_MAX)
+            {
+                LogError("Invalid value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else
+            {
+                tls_io_instance->read_chunk_size = *(const size_t *)value;
+            }
+        }
+        else if (strcmp(OPTION_TLS_COALESCE_RECEIVED_BYTES, optionName) == 0)
+        {
+            if (value == NULL)
+            {
+                LogError("NULL value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else
+            {
+                tls_io_instance->coalesce_received_bytes = *(const bool *)value;
+            }
+        }
+        else if (strcmp(OPTION_TLS_MAX_FRAGMENT_LENGTH, optionName) == 0)
+        {
+            if (value == NULL)
+            {
+                LogError("NULL value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else if (set_max_fragment_length(&tls_io_instance->config, *(const size_t *)value) != 0)
+            {
+                LogError("Invalid value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else
+            {
+                tls_io_instance->max_fragment_length = *(const size_t *)value;
+            }
+        }
+        else if (strcmp(OPTION_TLS_GROUPS, optionName) == 0 || strcmp(OPTION_TLS_SIGNATURE_ALGORITHMS, optionName) == 0)
+        {
+            if (tlsio_options_set(&tls_io_instance->tls_options, optionName, value) != TLSIO_OPTIONS_RESULT_SUCCESS)
+            {
+                LogError("Invalid value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else if (set_algorithm_lists(&tls_io_instance->config, &tls_io_instance->tls_options, &tls_io_instance->algorithm_lists) != 0)
+            {
+                LogError("Failed applying option %s", optionName);
+                result = __FAILURE__;
+            }
+            else
+            {
+                // A shared configuration is picked again for the new lists at open
+            }
+        }
+        else if (strcmp(OPTION_TLS_SESSION_CACHE, optionName) == 0)
+        {
+            if (value == NULL)
+            {
+                LogError("NULL value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else if (*(const bool *)value && session_cache_lock == NULL)
+            {
+                LogError("The TLS session cache is not available, tlsio_mbedtls_init was not called");
+                result = __FAILURE__;
+            }
+            else
+            {
+                // Takes effect on the next handshake
+                tls_io_instance->use_session_cache = *(const bool *)value;
+            }
+        }
+        else if (strcmp(OPTION_TLS_SHARED_CONTEXT, optionName) == 0)
+        {
+            if (value == NULL)
+            {
+                LogError("NULL value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else if (shared_config_lock == NULL)
+            {
+                LogError("Option %s needs tlsio_mbedtls_init to have been called", optionName);
+                result = __FAILURE__;
+            }
+            else if (tls_io_instance->tlsio_state != TLSIO_STATE_NOT_OPEN)
+            {
+                LogError("Option %s can only be set while the IO is not open", optionName);
+                result = __FAILURE__;
+            }
+            else if (*(const bool *)value == tls_io_instance->use_shared_config)
+            {
+                // Nothing changes
+            }
+            else if (*(const bool *)value)
+            {
+                // The private copy of the CA chain is not needed anymore
+                mbedtls_ssl_conf_ca_chain(&tls_io_instance->config, NULL, NULL);
+                mbedtls_x509_crt_free(&tls_io_instance->trusted_certificates_parsed);
+                mbedtls_x509_crt_init(&tls_io_instance->trusted_certificates_parsed);
+                tls_io_instance->use_shared_config = true;
+            }
+            else if ((tls_io_instance->trusted_certificates != NULL) &&
+                     (parse_trusted_certificates(tls_io_instance) != 0))
+            {
+                result = __FAILURE__;
+            }
+            else
+            {
+                tls_io_instance->use_shared_config = false;
+            }
+        }
         else
         {
             // tls_io_instance->socket_io is never NULL
@@ -832,6 +1730,55 @@ OPTIONHANDLER_HANDLE tlsio_mbedtls_retrieveoptions(CONCRETE_IO_HANDLE handle)
                 OptionHandler_Destroy(result);
                 result = NULL;
             }
+            else if (tls_io_instance->read_chunk_size != DEFAULT_READ_CHUNK_SIZE &&
+                     OptionHandler_AddOption(result, OPTION_TLS_READ_CHUNK_SIZE, &tls_io_instance->read_chunk_size) != OPTIONHANDLER_OK)
+            {
+                LogError("unable to save tls_read_chunk_size option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (tls_io_instance->coalesce_received_bytes &&
+                     OptionHandler_AddOption(result, OPTION_TLS_COALESCE_RECEIVED_BYTES, &tls_io_instance->coalesce_received_bytes) != OPTIONHANDLER_OK)
+            {
+                LogError("unable to save tls_coalesce_received_bytes option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (tls_io_instance->max_fragment_length != 0 &&
+                     OptionHandler_AddOption(result, OPTION_TLS_MAX_FRAGMENT_LENGTH, &tls_io_instance->max_fragment_length) != OPTIONHANDLER_OK)
+            {
+                LogError("unable to save tls_max_fragment_length option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (tls_io_instance->tls_options.groups != NULL &&
+                     OptionHandler_AddOption(result, OPTION_TLS_GROUPS, tls_io_instance->tls_options.groups) != OPTIONHANDLER_OK)
+            {
+                LogError("unable to save tls_groups option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (tls_io_instance->tls_options.signature_algorithms != NULL &&
+                     OptionHandler_AddOption(result, OPTION_TLS_SIGNATURE_ALGORITHMS, tls_io_instance->tls_options.signature_algorithms) != OPTIONHANDLER_OK)
+            {
+                LogError("unable to save tls_signature_algorithms option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (tls_io_instance->use_shared_config &&
+                     OptionHandler_AddOption(result, OPTION_TLS_SHARED_CONTEXT, &tls_io_instance->use_shared_config) != OPTIONHANDLER_OK)
+            {
+                LogError("unable to save tls_shared_context option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (tls_io_instance->use_session_cache &&
+                     OptionHandler_AddOption(result, OPTION_TLS_SESSION_CACHE, &tls_io_instance->use_session_cache) != OPTIONHANDLER_OK)
+            {
+                LogError("unable to save tls_session_cache option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
             else
             {
                 /*all is fine, all interesting options have been saved*/
@@ -851,9 +1798,104 @@ static const IO_INTERFACE_DESCRIPTION tlsio_mbedtls_interface_description =
         tlsio_mbedtls_close,
         tlsio_mbedtls_send,
         tlsio_mbedtls_dowork,
-        tlsio_mbedtls_setoption};
+        tlsio_mbedtls_setoption,
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        NULL,
+        NULL};
 
 const IO_INTERFACE_DESCRIPTION *tlsio_mbedtls_get_interface_description(void)
 {
     return &tlsio_mbedtls_interface_description;
 }
+
+int tlsio_mbedtls_init(void)
+{
+    if (shared_config_lock == NULL &&
+        (shared_config_lock = Lock_Init()) == NULL)
+    {
+        // Not fatal, the instances just cannot share their configuration
+        LogError("Failed creating the lock of the shared TLS configurations");
+    }
+
+    if (session_cache_lock == NULL &&
+        (session_cache_lock = Lock_Init()) == NULL)
+    {
+        // Not fatal, only OPTION_TLS_SESSION_CACHE becomes unavailable
+        LogError("Failed creating the TLS session cache lock");
+    }
+
+    return 0;
+}
+
+void tlsio_mbedtls_deinit(void)
+{
+    while (shared_configs != NULL)
+    {
+        TLS_SHARED_CONFIG *next = shared_configs->next;
+        LogError("TLS configuration still in use at deinit");
+        free_shared_config(shared_configs);
+        shared_configs = next;
+    }
+
+    if (shared_config_lock != NULL)
+    {
+        (void)Lock_Deinit(shared_config_lock);
+        shared_config_lock = NULL;
+    }
+
+    while (session_cache_entries != NULL)
+    {
+        TLS_SESSION_CACHE_ENTRY *entry = session_cache_entries;
+        session_cache_entries = entry->next;
+        free_session_cache_entry(entry);
+    }
+
+    if (session_cache_lock != NULL)
+    {
+        (void)Lock_Deinit(session_cache_lock);
+        session_cache_lock = NULL;
+    }
+
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+    if (memory_buffer_installed)
+    {
+        mbedtls_memory_buffer_alloc_free();
+        memory_buffer_installed = false;
+    }
+#endif
+}
+
+int tlsio_mbedtls_set_memory_buffer(unsigned char *buffer, size_t size)
+{
+    int result;
+
+    if (buffer == NULL || size == 0)
+    {
+        LogError("Invalid arguments: buffer=%p, size=%lu", buffer, (unsigned long)size);
+        result = __FAILURE__;
+    }
+    else
+    {
+#if defined(MBEDTLS_MEMORY_BUFFER_ALLOC_C)
+        if (memory_buffer_installed)
+        {
+            LogError("A memory buffer is already in use by mbedTLS");
+            result = __FAILURE__;
+        }
+        else
+        {
+            mbedtls_memory_buffer_alloc_init(buffer, size);
+            memory_buffer_installed = true;
+            result = 0;
+        }
+#else
+        LogError("mbedTLS was built without MBEDTLS_MEMORY_BUFFER_ALLOC_C");
+        result = __FAILURE__;
+#endif
+    }
+
+    return result;
+}
@@ -9,6 +9,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <limits.h>
 #include "azure_c_shared_utility/lock.h"
 #include "azure_c_shared_utility/tlsio.h"
 #include "azure_c_shared_utility/tlsio_openssl.h"
@@ -18,8 +19,58 @@
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/x509_openssl.h"
 #include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/tlsio_options.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/const_defines.h"
+#include "azure_c_shared_utility/threadpool.h"
+#include "azure_c_shared_utility/sync_wait.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/constbuffer.h"
+
+// Kernel TLS is only set up by OpenSSL 3 on Linux, and only when the write BIO is the socket itself
+#if defined(__linux__) && (OPENSSL_VERSION_NUMBER >= 0x30000000L) && !defined(OPENSSL_NO_KTLS)
+#define TLSIO_OPENSSL_KTLS_SUPPORTED
+#include <signal.h>
+#endif
+
+// OpenSSL 1.1 and later lock on their own and ignore the locking callbacks, as LibreSSL does since 2.7
+#if (OPENSSL_VERSION_NUMBER < 0x10100000L) || (defined(LIBRESSL_VERSION_NUMBER) && (LIBRESSL_VERSION_NUMBER < 0x20700000L))
+#define TLSIO_OPENSSL_LOCKING_CALLBACKS
+#endif
+
+// TLS 1.3 early data and the signature scheme names of tls_signature_algorithms came with OpenSSL 1.1.1
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L) && !defined(LIBRESSL_VERSION_NUMBER)
+#define TLSIO_OPENSSL_EARLY_DATA_SUPPORTED
+#define TLSIO_OPENSSL_SIGALGS_LIST_SUPPORTED
+#endif
+
+// Lowering the largest record also lowers the split send fragment, which OpenSSL 1.1.0 added and never raises back
+#if (OPENSSL_VERSION_NUMBER >= 0x10100000L) && !defined(LIBRESSL_VERSION_NUMBER)
+#define TLSIO_OPENSSL_SPLIT_SEND_FRAGMENT_SUPPORTED
+#endif
+
+// Providers replaced engines in OpenSSL 3
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L) && !defined(LIBRESSL_VERSION_NUMBER)
+#define TLSIO_OPENSSL_PROVIDERS_SUPPORTED
+#include "openssl/provider.h"
+#endif
+
+// A certificate store can be shared by several SSL_CTXs once it has a reference count (OpenSSL 1.1.0, LibreSSL 2.7)
+#if (OPENSSL_VERSION_NUMBER >= 0x10100000L) && (!defined(LIBRESSL_VERSION_NUMBER) || (LIBRESSL_VERSION_NUMBER >= 0x20700000L))
+#define TLSIO_OPENSSL_SHARED_STORE_SUPPORTED
+#endif
+
+// The file of TrustedCertsFile is mapped where mmap is available, and read through a file BIO elsewhere
+#ifndef _WIN32
+#define TLSIO_OPENSSL_MMAP_SUPPORTED
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+typedef struct TLS_TRUSTED_STORE_TAG TLS_TRUSTED_STORE;
 
 typedef enum TLSIO_STATE_TAG
 {
@@ -51,6 +102,36 @@ static bool is_an_opening_state(TLSIO_STATE state)
 
 typedef int(*TLS_CERTIFICATE_VALIDATION_CALLBACK)(X509_STORE_CTX*, void*);
 
+/* A handshake step given to the handshake thread pool is RUNNING until the worker is done with the SSL and its BIOs,
+   then DONE until the IO thread has taken its result */
+#define TLS_HANDSHAKE_JOB_NONE 0
+#define TLS_HANDSHAKE_JOB_RUNNING 1
+#define TLS_HANDSHAKE_JOB_DONE 2
+
+#if defined(_MSC_VER)
+#define TLS_HANDSHAKE_JOB_COMPARE_EXCHANGE(target, expected, value) ((int32_t)InterlockedCompareExchange((volatile LONG*)(target), (value), (expected)))
+#else
+#define TLS_HANDSHAKE_JOB_COMPARE_EXCHANGE(target, expected, value) __sync_val_compare_and_swap((target), (expected), (value))
+#endif
+#define TLS_HANDSHAKE_JOB_GET_STATE(source) TLS_HANDSHAKE_JOB_COMPARE_EXCHANGE((source), 0, 0)
+
+/* Sends that the socket could not take yet while OpenSSL writes records straight to it */
+typedef struct KTLS_PENDING_SEND_TAG
+{
+    unsigned char* bytes;
+    size_t size;
+    ON_SEND_COMPLETE on_send_complete;
+    void* callback_context;
+    struct KTLS_PENDING_SEND_TAG* next;
+} KTLS_PENDING_SEND;
+
+/* A send held while sends are corked, its bytes are in TLS_IO_INSTANCE::corked_bytes */
+typedef struct TLS_CORKED_SEND_TAG
+{
+    ON_SEND_COMPLETE on_send_complete;
+    void* callback_context;
+} TLS_CORKED_SEND;
+
 typedef struct TLS_IO_INSTANCE_TAG
 {
     XIO_HANDLE underlying_io;
@@ -66,24 +147,312 @@ typedef struct TLS_IO_INSTANCE_TAG
     SSL_CTX* ssl_context;
     BIO* in_bio;
     BIO* out_bio;
+    unsigned char* send_buffer;
+    size_t send_buffer_size;
+    unsigned char* received_bytes;
+    size_t received_bytes_size;
+    size_t received_byte_count;
+    size_t read_chunk_size;
+    // the memory lent by xio_set_receive_buffer for the next SSL_read only
+    unsigned char* lent_received_bytes;
+    size_t lent_received_bytes_size;
+    bool coalesce_received_bytes;
+    bool cork_sends;
+    unsigned char* corked_bytes;
+    size_t corked_bytes_size;
+    size_t corked_byte_count;
+    TLS_CORKED_SEND* corked_sends;
+    size_t corked_sends_size;
+    size_t corked_send_count;
+    bool dynamic_record_size;
+    // the largest plaintext OpenSSL puts in a record now, and the bytes written in small records since the
+    // handshake or the last idle period, see write_sized_records
+    size_t send_fragment_size;
+    size_t small_record_byte_count;
+    tickcounter_us_t last_write_us;
+    bool use_early_data;
+    bool early_data_open;
+    TLS_CORKED_SEND* early_data_sends;
+    size_t early_data_sends_size;
+    size_t early_data_send_count;
+    unsigned char* early_data_bytes;
+    size_t early_data_bytes_size;
+    size_t early_data_byte_count;
     TLSIO_STATE tlsio_state;
-    char* certificate;
+    // The certificates and the key are shared by reference with the retrieved options and the caches, see create_shared_string
+    CONSTBUFFER_HANDLE certificate;
+    char* trusted_certs_file;
+    // The store loaded from trusted_certs_file for an SSL_CTX that is not shared, shared ones keep theirs in the context cache
+    TLS_TRUSTED_STORE* trusted_store;
     char* cipher_list;
-    const char* x509_certificate;
-    const char* x509_private_key;
+    char* alpn;
+    TLSIO_OPTIONS tls_options;
+    CONSTBUFFER_HANDLE x509_certificate;
+    CONSTBUFFER_HANDLE x509_private_key;
+    X509_OPENSSL_CREDENTIALS_HANDLE x509_credentials;
+    OPTION_OPENSSL_KEY_TYPE x509_private_key_type;
+    char* engine_id;
+#ifdef X509_OPENSSL_ENGINES_SUPPORTED
+    ENGINE* engine;
+#endif
+    char* provider_name;
+#ifdef TLSIO_OPENSSL_PROVIDERS_SUPPORTED
+    OSSL_PROVIDER* provider;
+#endif
     TLSIO_VERSION tls_version;
     TLS_CERTIFICATE_VALIDATION_CALLBACK tls_validation_callback;
     void* tls_validation_callback_data;
+    char* hostname;
+    int port;
+    bool use_session_cache;
+    bool session_offered;
+    bool use_ktls;
+    bool ktls_socket_attached;
+    bool use_shared_context;
+    bool ssl_context_shared;
+    KTLS_PENDING_SEND* ktls_pending_sends;
+    KTLS_PENDING_SEND* ktls_last_pending_send;
+    THREADPOOL_HANDLE handshake_threadpool;
+    volatile int32_t handshake_job_state;
+    int handshake_job_ssl_error;
+    unsigned long handshake_job_error;
+    unsigned char* handshake_held_bytes;
+    size_t handshake_held_bytes_size;
+    size_t handshake_held_byte_count;
+    XIO_STATS stats;
 } TLS_IO_INSTANCE;
 
+/* The sends written by one flush of the corked bytes, completed together by the underlying IO */
+typedef struct TLS_CORKED_SEND_BATCH_TAG
+{
+    TLS_IO_INSTANCE* tls_io_instance;
+    TLS_CORKED_SEND* sends;
+    size_t send_count;
+} TLS_CORKED_SEND_BATCH;
+
+/* Sessions are keyed by hostname, port and client certificate, so that a session authenticated
+   with one device's credentials is never resumed by another TLS_IO_INSTANCE in the same process. */
+typedef struct TLS_SESSION_CACHE_ENTRY_TAG
+{
+    char* hostname;
+    int port;
+    CONSTBUFFER_HANDLE x509_certificate;
+    SSL_SESSION* session;
+    struct TLS_SESSION_CACHE_ENTRY_TAG* next;
+} TLS_SESSION_CACHE_ENTRY;
+
+static LOCK_HANDLE session_cache_lock = NULL;
+static TLS_SESSION_CACHE_ENTRY* session_cache_entries = NULL;
+static TLSIO_OPENSSL_SESSION_CACHE_STATS session_cache_stats;
+
+/* Shared contexts are keyed by everything create_ssl_context configures them with, so that the
+   trusted certificates are parsed once and their X509_STORE is shared by all the instances that
+   use the same settings. */
+typedef struct TLS_CONTEXT_CACHE_ENTRY_TAG
+{
+    TLSIO_VERSION tls_version;
+    CONSTBUFFER_HANDLE certificate;
+    char* trusted_certs_file;
+    TLS_TRUSTED_STORE* trusted_store;
+    char* cipher_list;
+    char* groups;
+    char* signature_algorithms;
+    CONSTBUFFER_HANDLE x509_certificate;
+    CONSTBUFFER_HANDLE x509_private_key;
+    OPTION_OPENSSL_KEY_TYPE x509_private_key_type;
+    char* engine_id;
+    char* provider_name;
+    bool use_session_cache;
+    TLS_CERTIFICATE_VALIDATION_CALLBACK tls_validation_callback;
+    void* tls_validation_callback_data;
+    SSL_CTX* ssl_context;
+    size_t ref_count;
+    struct TLS_CONTEXT_CACHE_ENTRY_TAG* next;
+} TLS_CONTEXT_CACHE_ENTRY;
+
+static LOCK_HANDLE context_cache_lock = NULL;
+static TLS_CONTEXT_CACHE_ENTRY* context_cache_entries = NULL;
+
+/* The stores of TrustedCertsFile, keyed by path. The SSL_CTXs using one each hold a reference
+   on the X509_STORE, and their owners (an instance or a context cache entry) one on the entry. */
+struct TLS_TRUSTED_STORE_TAG
+{
+    char* path;
+    X509_STORE* store;
+    size_t ref_count;
+    struct TLS_TRUSTED_STORE_TAG* next;
+};
+
+static LOCK_HANDLE trusted_store_cache_lock = NULL;
+static TLS_TRUSTED_STORE* trusted_store_cache_entries = NULL;
+
+#ifdef TLSIO_OPENSSL_LOCKING_CALLBACKS
 struct CRYPTO_dynlock_value
 {
-    LOCK_HANDLE lock;
+    RWLOCK_HANDLE lock;
 };
+#endif
 
 static const char* const OPTION_UNDERLYING_IO_OPTIONS = "underlying_io_options";
 #define SSL_DO_HANDSHAKE_SUCCESS 1
+#define DEFAULT_READ_CHUNK_SIZE 64
+// corked sends are flushed once they fill a full sized TLS record
+#define CORK_FLUSH_SIZE 16384
+// with tls_dynamic_record_size a record fits in one TCP segment, headers and AEAD tag included, until enough bytes
+// were written for the congestion window to have opened; writing nothing for a while starts over with small records
+#define DYNAMIC_RECORD_SMALL_SIZE 1400
+#define DYNAMIC_RECORD_FULL_SIZE 16384
+#define DYNAMIC_RECORD_BOOST_BYTES (128 * 1024)
+#define DYNAMIC_RECORD_IDLE_US (1000 * 1000)
+// how often dowork_ex has the IO thread come back while a handshake step runs on the handshake thread pool
+#define TLS_HANDSHAKE_JOB_CHECK_INTERVAL_MS 1
+
+
+// keys of the options handled by this layer, see tlsio_openssl_get_option_key
+typedef enum TLSIO_OPENSSL_OPTION_TAG
+{
+    TLSIO_OPENSSL_OPTION_TRUSTED_CERT,
+    TLSIO_OPENSSL_OPTION_TRUSTED_CERT_FILE,
+    TLSIO_OPENSSL_OPTION_CIPHER_SUITE,
+    TLSIO_OPENSSL_OPTION_X509_CERT,
+    TLSIO_OPENSSL_OPTION_X509_PRIVATE_KEY,
+    TLSIO_OPENSSL_OPTION_X509_PRIVATE_KEY_TYPE,
+    TLSIO_OPENSSL_OPTION_ENGINE,
+    TLSIO_OPENSSL_OPTION_PROVIDER,
+    TLSIO_OPENSSL_OPTION_TLS_VALIDATION_CALLBACK,
+    TLSIO_OPENSSL_OPTION_TLS_VALIDATION_CALLBACK_DATA,
+    TLSIO_OPENSSL_OPTION_TLS_VERSION,
+    TLSIO_OPENSSL_OPTION_TLS_READ_CHUNK_SIZE,
+    TLSIO_OPENSSL_OPTION_TLS_COALESCE_RECEIVED_BYTES,
+    TLSIO_OPENSSL_OPTION_TLS_CORK_SENDS,
+    TLSIO_OPENSSL_OPTION_TLS_DYNAMIC_RECORD_SIZE,
+    TLSIO_OPENSSL_OPTION_TLS_KTLS,
+    TLSIO_OPENSSL_OPTION_TLS_SHARED_CONTEXT,
+    TLSIO_OPENSSL_OPTION_TLS_SESSION_CACHE,
+    TLSIO_OPENSSL_OPTION_TLS_EARLY_DATA,
+    TLSIO_OPENSSL_OPTION_TLS_ALPN,
+    TLSIO_OPENSSL_OPTION_TLS_GROUPS,
+    TLSIO_OPENSSL_OPTION_TLS_SIGNATURE_ALGORITHMS,
+    TLSIO_OPENSSL_OPTION_TLS_HANDSHAKE_THREADPOOL,
+    TLSIO_OPENSSL_OPTION_UNDERLYING_IO_OPTIONS,
+    TLSIO_OPENSSL_OPTION_IGNORE_SERVER_NAME_CHECK
+} TLSIO_OPENSSL_OPTION;
+
+// options are resolved to a key once, so that options replayed by an OPTIONHANDLER on reconnect skip the name comparisons;
+// names that are not handled here are passed to the underlying IO
+static int tlsio_openssl_get_option_key(const char* optionName)
+{
+    int result;
+
+    if (strcmp(OPTION_TRUSTED_CERT, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_TRUSTED_CERT;
+    }
+    else if (strcmp(OPTION_TRUSTED_CERT_FILE, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_TRUSTED_CERT_FILE;
+    }
+    else if (strcmp(OPTION_OPENSSL_CIPHER_SUITE, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_CIPHER_SUITE;
+    }
+    else if (strcmp(SU_OPTION_X509_CERT, optionName) == 0 || strcmp(OPTION_X509_ECC_CERT, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_X509_CERT;
+    }
+    else if (strcmp(SU_OPTION_X509_PRIVATE_KEY, optionName) == 0 || strcmp(OPTION_X509_ECC_KEY, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_X509_PRIVATE_KEY;
+    }
+    else if (strcmp(OPTION_OPENSSL_PRIVATE_KEY_TYPE, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_X509_PRIVATE_KEY_TYPE;
+    }
+    else if (strcmp(OPTION_OPENSSL_ENGINE, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_ENGINE;
+    }
+    else if (strcmp(OPTION_OPENSSL_PROVIDER, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_PROVIDER;
+    }
+    else if (strcmp("tls_validation_callback", optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_TLS_VALIDATION_CALLBACK;
+    }
+    else if (strcmp("tls_validation_callback_data", optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_TLS_VALIDATION_CALLBACK_DATA;
+    }
+    else if (strcmp(OPTION_TLS_VERSION, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_TLS_VERSION;
+    }
+    else if (strcmp(OPTION_TLS_READ_CHUNK_SIZE, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_TLS_READ_CHUNK_SIZE;
+    }
+    else if (strcmp(OPTION_TLS_COALESCE_RECEIVED_BYTES, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_TLS_COALESCE_RECEIVED_BYTES;
+    }
+    else if (strcmp(OPTION_TLS_CORK_SENDS, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_TLS_CORK_SENDS;
+    }
+    else if (strcmp(OPTION_TLS_DYNAMIC_RECORD_SIZE, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_TLS_DYNAMIC_RECORD_SIZE;
+    }
+    else if (strcmp(OPTION_TLS_KTLS, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_TLS_KTLS;
+    }
+    else if (strcmp(OPTION_TLS_SHARED_CONTEXT, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_TLS_SHARED_CONTEXT;
+    }
+    else if (strcmp(OPTION_TLS_SESSION_CACHE, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_TLS_SESSION_CACHE;
+    }
+    else if (strcmp(OPTION_TLS_EARLY_DATA, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_TLS_EARLY_DATA;
+    }
+    else if (strcmp(OPTION_TLS_ALPN, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_TLS_ALPN;
+    }
+    else if (strcmp(OPTION_TLS_GROUPS, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_TLS_GROUPS;
+    }
+    else if (strcmp(OPTION_TLS_SIGNATURE_ALGORITHMS, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_TLS_SIGNATURE_ALGORITHMS;
+    }
+    else if (strcmp(OPTION_TLS_HANDSHAKE_THREADPOOL, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_TLS_HANDSHAKE_THREADPOOL;
+    }
+    else if (strcmp(OPTION_UNDERLYING_IO_OPTIONS, optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_UNDERLYING_IO_OPTIONS;
+    }
+    else if (strcmp("ignore_server_name_check", optionName) == 0)
+    {
+        result = TLSIO_OPENSSL_OPTION_IGNORE_SERVER_NAME_CHECK;
+    }
+    else
+    {
+        result = OPTIONHANDLER_NO_KEY;
+    }
+
+    return result;
+}
 
+static int tlsio_openssl_setoption_by_key(void* tls_io, int key, const char* optionName, const void* value);
 
 /*this function will clone an option given by name and value*/
 static void* tlsio_openssl_CloneOption(const char* name, const void* value)
@@ -126,6 +495,57 @@ static void* tlsio_openssl_CloneOption(const char* name, const void* value)
                 /*return as is*/
             }
         }
+        else if ((strcmp(name, OPTION_OPENSSL_ENGINE) == 0) || (strcmp(name, OPTION_OPENSSL_PROVIDER) == 0) || (strcmp(name, OPTION_TRUSTED_CERT_FILE) == 0))
+        {
+            if (mallocAndStrcpy_s((char**)&result, value) != 0)
+            {
+                LogError("unable to mallocAndStrcpy_s %s value", name);
+                result = NULL;
+            }
+            else
+            {
+                /*return as is*/
+            }
+        }
+        else if (strcmp(name, OPTION_OPENSSL_PRIVATE_KEY_TYPE) == 0)
+        {
+            OPTION_OPENSSL_KEY_TYPE* value_clone;
+
+            if ((value_clone = (OPTION_OPENSSL_KEY_TYPE*)malloc(sizeof(OPTION_OPENSSL_KEY_TYPE))) == NULL)
+            {
+                LogError("Failed clonning x509PrivatekeyType option");
+            }
+            else
+            {
+                *value_clone = *(const OPTION_OPENSSL_KEY_TYPE*)value;
+            }
+
+            result = value_clone;
+        }
+        else if (strcmp(name, OPTION_TLS_ALPN) == 0)
+        {
+            if (mallocAndStrcpy_s((char**)&result, value) != 0)
+            {
+                LogError("unable to mallocAndStrcpy_s tls_alpn value");
+                result = NULL;
+            }
+            else
+            {
+                /*return as is*/
+            }
+        }
+        else if ((strcmp(name, OPTION_TLS_GROUPS) == 0) || (strcmp(name, OPTION_TLS_SIGNATURE_ALGORITHMS) == 0))
+        {
+            if (tlsio_options_clone_option(name, value, &result) != TLSIO_OPTIONS_RESULT_SUCCESS)
+            {
+                LogError("unable to clone %s value", name);
+                result = NULL;
+            }
+            else
+            {
+                /*return as is*/
+            }
+        }
         else if (strcmp(name, SU_OPTION_X509_CERT) == 0)
         {
             if (mallocAndStrcpy_s((char**)&result, value) != 0)
@@ -216,9 +636,46 @@ static void* tlsio_openssl_CloneOption(const char* name, const void* value)
                 result = value_clone;
             }
         }
+        else if (strcmp(name, OPTION_TLS_READ_CHUNK_SIZE) == 0)
+        {
+            size_t* value_clone;
+
+            if ((value_clone = (size_t*)malloc(sizeof(size_t))) == NULL)
+            {
+                LogError("Failed clonning tls_read_chunk_size option");
+            }
+            else
+            {
+                *value_clone = *(const size_t*)value;
+            }
+
+            result = value_clone;
+        }
+        else if ((strcmp(name, OPTION_TLS_SESSION_CACHE) == 0) ||
+            (strcmp(name, OPTION_TLS_EARLY_DATA) == 0) ||
+            (strcmp(name, OPTION_TLS_COALESCE_RECEIVED_BYTES) == 0) ||
+            (strcmp(name, OPTION_TLS_CORK_SENDS) == 0) ||
+            (strcmp(name, OPTION_TLS_DYNAMIC_RECORD_SIZE) == 0) ||
+            (strcmp(name, OPTION_TLS_KTLS) == 0) ||
+            (strcmp(name, OPTION_TLS_SHARED_CONTEXT) == 0))
+        {
+            bool* value_clone;
+
+            if ((value_clone = (bool*)malloc(sizeof(bool))) == NULL)
+            {
+                LogError("Failed clonning %s option", name);
+            }
+            else
+            {
+                *value_clone = *(const bool*)value;
+            }
+
+            result = value_clone;
+        }
         else if (
             (strcmp(name, "tls_validation_callback") == 0) ||
-            (strcmp(name, "tls_validation_callback_data") == 0)
+            (strcmp(name, "tls_validation_callback_data") == 0) ||
+            (strcmp(name, OPTION_TLS_HANDSHAKE_THREADPOOL) == 0)
             )
         {
             result = (void*)value;
@@ -246,19 +703,35 @@ static void tlsio_openssl_DestroyOption(const char* name, const void* value)
     {
         if (
             (strcmp(name, OPTION_TRUSTED_CERT) == 0) ||
+            (strcmp(name, OPTION_TRUSTED_CERT_FILE) == 0) ||
             (strcmp(name, OPTION_OPENSSL_CIPHER_SUITE) == 0) ||
             (strcmp(name, SU_OPTION_X509_CERT) == 0) ||
             (strcmp(name, SU_OPTION_X509_PRIVATE_KEY) == 0) ||
             (strcmp(name, OPTION_X509_ECC_CERT) == 0) ||
             (strcmp(name, OPTION_X509_ECC_KEY) == 0) ||
-            (strcmp(name, OPTION_TLS_VERSION) == 0)
+            (strcmp(name, OPTION_OPENSSL_PRIVATE_KEY_TYPE) == 0) ||
+            (strcmp(name, OPTION_OPENSSL_ENGINE) == 0) ||
+            (strcmp(name, OPTION_OPENSSL_PROVIDER) == 0) ||
+            (strcmp(name, OPTION_TLS_VERSION) == 0) ||
+            (strcmp(name, OPTION_TLS_SESSION_CACHE) == 0) ||
+            (strcmp(name, OPTION_TLS_EARLY_DATA) == 0) ||
+            (strcmp(name, OPTION_TLS_ALPN) == 0) ||
+            (strcmp(name, OPTION_TLS_GROUPS) == 0) ||
+            (strcmp(name, OPTION_TLS_SIGNATURE_ALGORITHMS) == 0) ||
+            (strcmp(name, OPTION_TLS_READ_CHUNK_SIZE) == 0) ||
+            (strcmp(name, OPTION_TLS_COALESCE_RECEIVED_BYTES) == 0) ||
+            (strcmp(name, OPTION_TLS_CORK_SENDS) == 0) ||
+            (strcmp(name, OPTION_TLS_DYNAMIC_RECORD_SIZE) == 0) ||
+            (strcmp(name, OPTION_TLS_KTLS) == 0) ||
+            (strcmp(name, OPTION_TLS_SHARED_CONTEXT) == 0)
             )
         {
             free((void*)value);
         }
         else if (
             (strcmp(name, "tls_validation_callback") == 0) ||
-            (strcmp(name, "tls_validation_callback_data") == 0)
+            (strcmp(name, "tls_validation_callback_data") == 0) ||
+            (strcmp(name, OPTION_TLS_HANDSHAKE_THREADPOOL) == 0)
             )
         {
             // nothing to free.
@@ -284,10 +757,10 @@ static OPTIONHANDLER_HANDLE tlsio_openssl_retrieveoptions(CONCRETE_IO_HANDLE han
     }
     else
     {
-        result = OptionHandler_Create(tlsio_openssl_CloneOption, tlsio_openssl_DestroyOption, tlsio_openssl_setoption);
+        result = OptionHandler_CreateWithKeys(tlsio_openssl_CloneOption, tlsio_openssl_DestroyOption, tlsio_openssl_setoption, tlsio_openssl_get_option_key, tlsio_openssl_setoption_by_key);
         if (result == NULL)
         {
-            LogError("unable to OptionHandler_Create");
+            LogError("unable to OptionHandler_CreateWithKeys");
             /*return as is*/
         }
         else
@@ -306,13 +779,22 @@ static OPTIONHANDLER_HANDLE tlsio_openssl_retrieveoptions(CONCRETE_IO_HANDLE han
             }
             else if (
                 (tls_io_instance->certificate != NULL) &&
-                (OptionHandler_AddOption(result, OPTION_TRUSTED_CERT, tls_io_instance->certificate) != OPTIONHANDLER_OK)
+                (OptionHandler_AddSharedOption(result, OPTION_TRUSTED_CERT, tls_io_instance->certificate) != OPTIONHANDLER_OK)
                 )
             {
                 LogError("unable to save TrustedCerts option");
                 OptionHandler_Destroy(result);
                 result = NULL;
             }
+            else if (
+                (tls_io_instance->trusted_certs_file != NULL) &&
+                (OptionHandler_AddOption(result, OPTION_TRUSTED_CERT_FILE, tls_io_instance->trusted_certs_file) != OPTIONHANDLER_OK)
+                )
+            {
+                LogError("unable to save TrustedCertsFile option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
             else if (
                 (tls_io_instance->cipher_list != NULL) &&
                 (OptionHandler_AddOption(result, OPTION_OPENSSL_CIPHER_SUITE, tls_io_instance->cipher_list) != OPTIONHANDLER_OK)
@@ -322,18 +804,108 @@ static OPTIONHANDLER_HANDLE tlsio_openssl_retrieveoptions(CONCRETE_IO_HANDLE han
                 OptionHandler_Destroy(result);
                 result = NULL;
             }
-            else if (tls_io_instance->x509_certificate != NULL && (OptionHandler_AddOption(result, SU_OPTION_X509_CERT, tls_io_instance->x509_certificate) != OPTIONHANDLER_OK) )
+            else if (tls_io_instance->x509_certificate != NULL && (OptionHandler_AddSharedOption(result, SU_OPTION_X509_CERT, tls_io_instance->x509_certificate) != OPTIONHANDLER_OK) )
             {
                 LogError("unable to save x509 certificate option");
                 OptionHandler_Destroy(result);
                 result = NULL;
             }
-            else if (tls_io_instance->x509_private_key != NULL && (OptionHandler_AddOption(result, SU_OPTION_X509_PRIVATE_KEY, tls_io_instance->x509_private_key) != OPTIONHANDLER_OK) )
+            else if (tls_io_instance->x509_private_key != NULL && (OptionHandler_AddSharedOption(result, SU_OPTION_X509_PRIVATE_KEY, tls_io_instance->x509_private_key) != OPTIONHANDLER_OK) )
             {
                 LogError("unable to save x509 privatekey option");
                 OptionHandler_Destroy(result);
                 result = NULL;
             }
+            else if ((tls_io_instance->x509_private_key_type != KEY_TYPE_DEFAULT) && (OptionHandler_AddOption(result, OPTION_OPENSSL_PRIVATE_KEY_TYPE, &tls_io_instance->x509_private_key_type) != OPTIONHANDLER_OK))
+            {
+                LogError("unable to save x509PrivatekeyType option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if ((tls_io_instance->engine_id != NULL) && (OptionHandler_AddOption(result, OPTION_OPENSSL_ENGINE, tls_io_instance->engine_id) != OPTIONHANDLER_OK))
+            {
+                LogError("unable to save Engine option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if ((tls_io_instance->provider_name != NULL) && (OptionHandler_AddOption(result, OPTION_OPENSSL_PROVIDER, tls_io_instance->provider_name) != OPTIONHANDLER_OK))
+            {
+                LogError("unable to save Provider option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (tls_io_instance->use_session_cache && (OptionHandler_AddOption(result, OPTION_TLS_SESSION_CACHE, &tls_io_instance->use_session_cache) != OPTIONHANDLER_OK))
+            {
+                LogError("unable to save tls_session_cache option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (tls_io_instance->use_early_data && (OptionHandler_AddOption(result, OPTION_TLS_EARLY_DATA, &tls_io_instance->use_early_data) != OPTIONHANDLER_OK))
+            {
+                LogError("unable to save tls_early_data option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if ((tls_io_instance->alpn != NULL) && (OptionHandler_AddOption(result, OPTION_TLS_ALPN, tls_io_instance->alpn) != OPTIONHANDLER_OK))
+            {
+                LogError("unable to save tls_alpn option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if ((tls_io_instance->tls_options.groups != NULL) && (OptionHandler_AddOption(result, OPTION_TLS_GROUPS, tls_io_instance->tls_options.groups) != OPTIONHANDLER_OK))
+            {
+                LogError("unable to save tls_groups option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if ((tls_io_instance->tls_options.signature_algorithms != NULL) && (OptionHandler_AddOption(result, OPTION_TLS_SIGNATURE_ALGORITHMS, tls_io_instance->tls_options.signature_algorithms) != OPTIONHANDLER_OK))
+            {
+                LogError("unable to save tls_signature_algorithms option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if ((tls_io_instance->read_chunk_size != DEFAULT_READ_CHUNK_SIZE) && (OptionHandler_AddOption(result, OPTION_TLS_READ_CHUNK_SIZE, &tls_io_instance->read_chunk_size) != OPTIONHANDLER_OK))
+            {
+                LogError("unable to save tls_read_chunk_size option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (tls_io_instance->coalesce_received_bytes && (OptionHandler_AddOption(result, OPTION_TLS_COALESCE_RECEIVED_BYTES, &tls_io_instance->coalesce_received_bytes) != OPTIONHANDLER_OK))
+            {
+                LogError("unable to save tls_coalesce_received_bytes option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (tls_io_instance->cork_sends && (OptionHandler_AddOption(result, OPTION_TLS_CORK_SENDS, &tls_io_instance->cork_sends) != OPTIONHANDLER_OK))
+            {
+                LogError("unable to save tls_cork_sends option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (tls_io_instance->dynamic_record_size && (OptionHandler_AddOption(result, OPTION_TLS_DYNAMIC_RECORD_SIZE, &tls_io_instance->dynamic_record_size) != OPTIONHANDLER_OK))
+            {
+                LogError("unable to save tls_dynamic_record_size option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (tls_io_instance->use_ktls && (OptionHandler_AddOption(result, OPTION_TLS_KTLS, &tls_io_instance->use_ktls) != OPTIONHANDLER_OK))
+            {
+                LogError("unable to save tls_ktls option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (tls_io_instance->use_shared_context && (OptionHandler_AddOption(result, OPTION_TLS_SHARED_CONTEXT, &tls_io_instance->use_shared_context) != OPTIONHANDLER_OK))
+            {
+                LogError("unable to save tls_shared_context option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if ((tls_io_instance->handshake_threadpool != NULL) && (OptionHandler_AddOption(result, OPTION_TLS_HANDSHAKE_THREADPOOL, tls_io_instance->handshake_threadpool) != OPTIONHANDLER_OK))
+            {
+                LogError("unable to save tls_handshake_threadpool option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
             else if (tls_io_instance->tls_version != 0)
             {
                 if (OptionHandler_AddOption(result, OPTION_TLS_VERSION, &tls_io_instance->tls_version) != OPTIONHANDLER_OK)
@@ -386,13 +958,21 @@ static const IO_INTERFACE_DESCRIPTION tlsio_openssl_interface_description =
     tlsio_openssl_close,
     tlsio_openssl_send,
     tlsio_openssl_dowork,
-    tlsio_openssl_setoption
+    tlsio_openssl_setoption,
+    tlsio_openssl_sendv,
+    NULL,
+    tlsio_openssl_get_stats,
+    tlsio_openssl_dowork_ex,
+    tlsio_openssl_get_pollable_handle,
+    tlsio_openssl_set_receive_buffer
 };
 
-static LOCK_HANDLE * openssl_locks = NULL;
+#ifdef TLSIO_OPENSSL_LOCKING_CALLBACKS
+/* OpenSSL takes most of its locks for reading (CRYPTO_READ), those are shared */
+static RWLOCK_HANDLE * openssl_locks = NULL;
 
 
-static void openssl_lock_unlock_helper(LOCK_HANDLE lock, int lock_mode, const char* file, int line)
+static void openssl_lock_unlock_helper(RWLOCK_HANDLE lock, int lock_mode, const char* file, int line)
 {
 #ifdef NO_LOGGING
     // Avoid unused variable warning when logging not compiled in
@@ -402,19 +982,20 @@ static void openssl_lock_unlock_helper(LOCK_HANDLE lock, int lock_mode, const ch
 
     if (lock_mode & CRYPTO_LOCK)
     {
-        if (Lock(lock) != 0)
+        if (((lock_mode & CRYPTO_READ) ? RWLock_LockShared(lock) : RWLock_LockExclusive(lock)) != LOCK_OK)
         {
             LogError("Failed to lock openssl lock (%s:%d)", file, line);
         }
     }
     else
     {
-        if (Unlock(lock) != 0)
+        if (((lock_mode & CRYPTO_READ) ? RWLock_UnlockShared(lock) : RWLock_UnlockExclusive(lock)) != LOCK_OK)
         {
             LogError("Failed to unlock openssl lock (%s:%d)", file, line);
         }
     }
 }
+#endif
 
 static void log_ERR_get_error(const char* message)
 {
@@ -437,7 +1018,8 @@ static void log_ERR_get_error(const char* message)
     }
 }
 
-static STATIC_VAR_UNUSED struct CRYPTO_dynlock_value* openssl_dynamic_locks_create_cb(const char* file, int line)
+#ifdef TLSIO_OPENSSL_LOCKING_CALLBACKS
+static struct CRYPTO_dynlock_value* openssl_dynamic_locks_create_cb(const char* file, int line)
 {
 #ifdef NO_LOGGING
     // Avoid unused variable warning when logging not compiled in
@@ -455,7 +1037,7 @@ static STATIC_VAR_UNUSED struct CRYPTO_dynlock_value* openssl_dynamic_locks_crea
     }
     else
     {
-        result->lock = Lock_Init();
+        result->lock = RWLock_Init();
         if (result->lock == NULL)
         {
             LogError("Failed to create lock for dynamic lock (%s:%d).", file, line);
@@ -468,16 +1050,16 @@ static STATIC_VAR_UNUSED struct CRYPTO_dynlock_value* openssl_dynamic_locks_crea
     return result;
 }
 
-static STATIC_VAR_UNUSED void openssl_dynamic_locks_lock_unlock_cb(int lock_mode, struct CRYPTO_dynlock_value* dynlock_value, const char* file, int line)
+static void openssl_dynamic_locks_lock_unlock_cb(int lock_mode, struct CRYPTO_dynlock_value* dynlock_value, const char* file, int line)
 {
     openssl_lock_unlock_helper(dynlock_value->lock, lock_mode, file, line);
 }
 
-static STATIC_VAR_UNUSED void openssl_dynamic_locks_destroy_cb(struct CRYPTO_dynlock_value* dynlock_value, const char* file, int line)
+static void openssl_dynamic_locks_destroy_cb(struct CRYPTO_dynlock_value* dynlock_value, const char* file, int line)
 {
     (void)file;
     (void)line;
-    Lock_Deinit(dynlock_value->lock);
+    RWLock_Deinit(dynlock_value->lock);
     free(dynlock_value);
 }
 
@@ -499,7 +1081,7 @@ static void openssl_dynamic_locks_install(void)
 #endif
 }
 
-static void STATIC_VAR_UNUSED openssl_static_locks_lock_unlock_cb(int lock_mode, int lock_index, const char * file, int line)
+static void openssl_static_locks_lock_unlock_cb(int lock_mode, int lock_index, const char * file, int line)
 {
     if (lock_index < 0 || lock_index >= CRYPTO_num_locks())
     {
@@ -522,7 +1104,7 @@ static void openssl_static_locks_uninstall(void)
         {
             if (openssl_locks[i] != NULL)
             {
-                Lock_Deinit(openssl_locks[i]);
+                RWLock_Deinit(openssl_locks[i]);
             }
         }
 
@@ -546,7 +1128,7 @@ static int openssl_static_locks_install(void)
     }
     else
     {
-        openssl_locks = malloc(CRYPTO_num_locks() * sizeof(LOCK_HANDLE));
+        openssl_locks = malloc(CRYPTO_num_locks() * sizeof(RWLOCK_HANDLE));
         if (openssl_locks == NULL)
         {
             LogError("Failed to allocate locks");
@@ -557,7 +1139,7 @@ static int openssl_static_locks_install(void)
             int i;
             for (i = 0; i < CRYPTO_num_locks(); i++)
             {
-                openssl_locks[i] = Lock_Init();
+                openssl_locks[i] = RWLock_Init();
                 if (openssl_locks[i] == NULL)
                 {
                     LogError("Failed to allocate lock %d", i);
@@ -570,8 +1152,10 @@ static int openssl_static_locks_install(void)
                 int j;
                 for (j = 0; j < i; j++)
                 {
-                    Lock_Deinit(openssl_locks[j]);
+                    RWLock_Deinit(openssl_locks[j]);
                 }
+                free(openssl_locks);
+                openssl_locks = NULL;
                 result = __FAILURE__;
             }
             else
@@ -584,800 +1168,827 @@ static int openssl_static_locks_install(void)
     }
     return result;
 }
+#endif
 
-static void indicate_error(TLS_IO_INSTANCE* tls_io_instance)
+static bool is_same_string(const char* left, const char* right)
 {
-    if (tls_io_instance->on_io_error == NULL)
-    {
-        LogError("NULL on_io_error.");
-    }
-    else
-    {
-        tls_io_instance->on_io_error(tls_io_instance->on_io_error_context);
-    }
+    return ((left == NULL) && (right == NULL)) ||
+        ((left != NULL) && (right != NULL) && (strcmp(left, right) == 0));
 }
 
-static void indicate_open_complete(TLS_IO_INSTANCE* tls_io_instance, IO_OPEN_RESULT open_result)
+// The certificates can be hundreds of KB, so they are kept in a CONSTBUFFER holding the string and its
+// terminator: retrieving the options and keying the caches takes a reference instead of copying them
+static CONSTBUFFER_HANDLE create_shared_string(const char* value)
 {
-    if (tls_io_instance->on_io_open_complete == NULL)
+    return CONSTBUFFER_Create((const unsigned char*)value, strlen(value) + 1);
+}
+
+static const char* get_shared_string(CONSTBUFFER_HANDLE shared_string)
+{
+    return (shared_string == NULL) ? NULL : (const char*)CONSTBUFFER_GetContent(shared_string)->buffer;
+}
+
+static CONSTBUFFER_HANDLE share_string(CONSTBUFFER_HANDLE shared_string)
+{
+    if (shared_string != NULL)
     {
-        LogError("NULL on_io_open_complete.");
+        CONSTBUFFER_IncRef(shared_string);
     }
-    else
+    return shared_string;
+}
+
+static void release_shared_string(CONSTBUFFER_HANDLE shared_string)
+{
+    if (shared_string != NULL)
     {
-        tls_io_instance->on_io_open_complete(tls_io_instance->on_io_open_complete_context, open_result);
+        CONSTBUFFER_DecRef(shared_string);
     }
 }
 
-static int write_outgoing_bytes(TLS_IO_INSTANCE* tls_io_instance, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+static bool is_same_shared_string(CONSTBUFFER_HANDLE left, CONSTBUFFER_HANDLE right)
 {
-    int result;
+    // Instances fed the same retrieved options share the buffer, so the comparison rarely goes past the handles
+    return (left == right) ||
+        ((left != NULL) && (right != NULL) && (strcmp(get_shared_string(left), get_shared_string(right)) == 0));
+}
 
-    size_t pending = BIO_ctrl_pending(tls_io_instance->out_bio);
+// Must be called with session_cache_lock held
+static TLS_SESSION_CACHE_ENTRY** find_session_cache_entry(TLS_IO_INSTANCE* tls_io_instance)
+{
+    TLS_SESSION_CACHE_ENTRY** entry = &session_cache_entries;
 
-    if (pending == 0)
+    while ((*entry != NULL) &&
+        (((*entry)->port != tls_io_instance->port) ||
+         (strcmp((*entry)->hostname, tls_io_instance->hostname) != 0) ||
+         (!is_same_shared_string((*entry)->x509_certificate, tls_io_instance->x509_certificate))))
     {
-        result = 0;
+        entry = &(*entry)->next;
     }
-    else
-    {
-        unsigned char* bytes_to_send = malloc(pending);
-        if (bytes_to_send == NULL)
-        {
-            LogError("NULL bytes_to_send.");
-            result = __FAILURE__;
-        }
+
+    return entry;
+}
+
+static void free_session_cache_entry(TLS_SESSION_CACHE_ENTRY* entry)
+{
+    SSL_SESSION_free(entry->session);
+    free(entry->hostname);
+    release_shared_string(entry->x509_certificate);
+    free(entry);
+}
+
+// Called by OpenSSL whenever the server hands out a session, which for TLS 1.3 happens after the handshake.
+// Returning 1 keeps the reference OpenSSL passes in, 0 lets OpenSSL release it.
+static int on_new_session(SSL* ssl, SSL_SESSION* session)
+{
+    int result;
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)SSL_get_app_data(ssl);
+
+    if ((tls_io_instance == NULL) || (!tls_io_instance->use_session_cache))
+    {
+        result = 0;
+    }
+    else if (Lock(session_cache_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the TLS session cache.");
+        result = 0;
+    }
+    else
+    {
+        TLS_SESSION_CACHE_ENTRY** entry = find_session_cache_entry(tls_io_instance);
+
+        if (*entry != NULL)
+        {
+            SSL_SESSION_free((*entry)->session);
+            (*entry)->session = session;
+            result = 1;
+        }
         else
         {
-            if (BIO_read(tls_io_instance->out_bio, bytes_to_send, (int)pending) != (int)pending)
+            TLS_SESSION_CACHE_ENTRY* new_entry = (TLS_SESSION_CACHE_ENTRY*)malloc(sizeof(TLS_SESSION_CACHE_ENTRY));
+            if (new_entry == NULL)
             {
-                log_ERR_get_error("BIO_read not in pending state.");
-                result = __FAILURE__;
+                LogError("Failed allocating TLS session cache entry.");
+                result = 0;
             }
             else
             {
-                if (xio_send(tls_io_instance->underlying_io, bytes_to_send, pending, on_send_complete, callback_context) != 0)
+                new_entry->port = tls_io_instance->port;
+                new_entry->session = session;
+                new_entry->next = NULL;
+
+                if (mallocAndStrcpy_s(&new_entry->hostname, tls_io_instance->hostname) != 0)
                 {
-                    LogError("Error in xio_send.");
-                    result = __FAILURE__;
+                    LogError("Failed copying the hostname of a TLS session cache entry.");
+                    free(new_entry);
+                    result = 0;
                 }
                 else
                 {
-                    result = 0;
+                    new_entry->x509_certificate = share_string(tls_io_instance->x509_certificate);
+                    *entry = new_entry;
+                    session_cache_stats.entries++;
+                    result = 1;
                 }
             }
-
-            free(bytes_to_send);
         }
+
+        (void)Unlock(session_cache_lock);
     }
 
     return result;
 }
 
-// Non-NULL tls_io_instance is guaranteed by callers.
-// We are in TLSIO_STATE_IN_HANDSHAKE when entering this method.
-static void send_handshake_bytes(TLS_IO_INSTANCE* tls_io_instance)
+static void offer_cached_session(TLS_IO_INSTANCE* tls_io_instance)
 {
-    int hsret;
-    // ERR_clear_error must be called before any call that might set an
-    // SSL_get_error result
-    ERR_clear_error();
-    hsret = SSL_do_handshake(tls_io_instance->ssl);
-    if (hsret != SSL_DO_HANDSHAKE_SUCCESS)
+    if (Lock(session_cache_lock) != LOCK_OK)
     {
-        int ssl_err = SSL_get_error(tls_io_instance->ssl, hsret);
-        if (ssl_err != SSL_ERROR_WANT_READ && ssl_err != SSL_ERROR_WANT_WRITE)
+        LogError("Failed to lock the TLS session cache.");
+    }
+    else
+    {
+        TLS_SESSION_CACHE_ENTRY* entry = *find_session_cache_entry(tls_io_instance);
+
+        // SSL_set_session takes its own reference, so the entry can be replaced while the handshake runs.
+        // Session IDs and session tickets are both carried by the SSL_SESSION.
+        if ((entry != NULL) &&
+            (SSL_set_session(tls_io_instance->ssl, entry->session) == 1))
+        {
+            tls_io_instance->session_offered = true;
+        }
+
+        (void)Unlock(session_cache_lock);
+    }
+}
+
+static void on_session_cache_handshake_complete(TLS_IO_INSTANCE* tls_io_instance, bool succeeded)
+{
+    if (Lock(session_cache_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the TLS session cache.");
+    }
+    else
+    {
+        if (succeeded)
         {
-            if (ssl_err == SSL_ERROR_SSL)
+            if (SSL_session_reused(tls_io_instance->ssl))
             {
-                LogError("%s", ERR_error_string(ERR_get_error(), NULL));
+                session_cache_stats.hits++;
             }
             else
             {
-                LogError("SSL handshake failed: %d", ssl_err);
+                session_cache_stats.misses++;
             }
-            tls_io_instance->tlsio_state = TLSIO_STATE_HANDSHAKE_FAILED;
         }
-        else
+        else if (tls_io_instance->session_offered)
         {
-            if (write_outgoing_bytes(tls_io_instance, NULL, NULL) != 0)
+            // Do not keep offering a session that might be the reason the handshake is failing
+            TLS_SESSION_CACHE_ENTRY** entry = find_session_cache_entry(tls_io_instance);
+            if (*entry != NULL)
             {
-                LogError("Error in write_outgoing_bytes.");
-                tls_io_instance->tlsio_state = TLSIO_STATE_HANDSHAKE_FAILED;
+                TLS_SESSION_CACHE_ENTRY* failed_entry = *entry;
+                *entry = failed_entry->next;
+                free_session_cache_entry(failed_entry);
+                session_cache_stats.entries--;
             }
         }
+
+        (void)Unlock(session_cache_lock);
+    }
+}
+
+static void indicate_error(TLS_IO_INSTANCE* tls_io_instance)
+{
+    if (tls_io_instance->on_io_error == NULL)
+    {
+        LogError("NULL on_io_error.");
     }
     else
     {
-        tls_io_instance->tlsio_state = TLSIO_STATE_OPEN;
-        indicate_open_complete(tls_io_instance, IO_OPEN_OK);
+        tls_io_instance->on_io_error(tls_io_instance->on_io_error_context);
     }
 }
 
-static void close_openssl_instance(TLS_IO_INSTANCE* tls_io_instance)
+static void indicate_open_complete(TLS_IO_INSTANCE* tls_io_instance, IO_OPEN_RESULT open_result)
 {
-    if (tls_io_instance->ssl != NULL)
+    if (tls_io_instance->on_io_open_complete == NULL)
     {
-        SSL_free(tls_io_instance->ssl);
-        tls_io_instance->ssl = NULL;
+        LogError("NULL on_io_open_complete.");
     }
-    if (tls_io_instance->ssl_context != NULL)
+    else
     {
-        SSL_CTX_free(tls_io_instance->ssl_context);
-        tls_io_instance->ssl_context = NULL;
+        tls_io_instance->on_io_open_complete(tls_io_instance->on_io_open_complete_context, open_result);
     }
 }
 
-static void on_underlying_io_close_complete(void* context)
+static void indicate_send_complete(TLS_IO_INSTANCE* tls_io_instance, ON_SEND_COMPLETE on_send_complete, void* callback_context, IO_SEND_RESULT send_result)
 {
-    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
-
-    switch (tls_io_instance->tlsio_state)
+    if (on_send_complete != NULL)
     {
-    default:
-    case TLSIO_STATE_NOT_OPEN:
-    case TLSIO_STATE_OPEN:
-    case TLSIO_STATE_IN_HANDSHAKE:
-    case TLSIO_STATE_HANDSHAKE_FAILED:
-    case TLSIO_STATE_ERROR:
-        break;
-
-    case TLSIO_STATE_OPENING_UNDERLYING_IO:
-        tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
-        indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
-        break;
-
-    case TLSIO_STATE_CLOSING:
-        tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+        tls_io_instance->stats.callback_count++;
+        on_send_complete(callback_context, send_result);
+    }
+}
 
-        if (tls_io_instance->on_io_close_complete != NULL)
+static void set_send_fragment_size(TLS_IO_INSTANCE* tls_io_instance, size_t send_fragment_size)
+{
+    if (tls_io_instance->send_fragment_size != send_fragment_size)
+    {
+        if (SSL_set_max_send_fragment(tls_io_instance->ssl, (long)send_fragment_size) != 1)
         {
-            tls_io_instance->on_io_close_complete(tls_io_instance->on_io_close_complete_context);
+            // the records keep their current size
+            log_ERR_get_error("SSL_set_max_send_fragment error.");
+        }
+        else
+        {
+#ifdef TLSIO_OPENSSL_SPLIT_SEND_FRAGMENT_SUPPORTED
+            (void)SSL_set_split_send_fragment(tls_io_instance->ssl, (long)send_fragment_size);
+#endif
+            tls_io_instance->send_fragment_size = send_fragment_size;
         }
-        break;
     }
-
-    close_openssl_instance(tls_io_instance);
 }
 
-static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+// Writes in records of about one TCP segment after the handshake or an idle period, so that the first bytes can be
+// decrypted as soon as their segment arrives instead of waiting for a whole 16KB record to come through a cold
+// congestion window, and in full sized records once DYNAMIC_RECORD_BOOST_BYTES were written. A write that crosses
+// the boost is split there, unless OpenSSL writes to the socket: a write the socket cannot take is retried whole.
+static int write_sized_records(TLS_IO_INSTANCE* tls_io_instance, const unsigned char* buffer, size_t size)
 {
-    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+    int result = (int)size;
+    size_t written = 0;
+    tickcounter_us_t now;
 
-    if (tls_io_instance->tlsio_state == TLSIO_STATE_OPENING_UNDERLYING_IO)
+    if (tickcounter_get_monotonic_us(&now) != 0)
     {
-        if (open_result == IO_OPEN_OK)
-        {
-            tls_io_instance->tlsio_state = TLSIO_STATE_IN_HANDSHAKE;
+        // the idle period cannot be told, the writes are not counted as one
+        now = tls_io_instance->last_write_us;
+    }
+    else if (now - tls_io_instance->last_write_us >= DYNAMIC_RECORD_IDLE_US)
+    {
+        tls_io_instance->small_record_byte_count = 0;
+    }
+    else
+    {
+        /* the connection kept busy, the records keep growing */
+    }
 
-            // Begin the handshake process here. It continues in on_underlying_io_bytes_received
-            send_handshake_bytes(tls_io_instance);
+    while (written < size)
+    {
+        size_t part_size = size - written;
+        int res;
+
+        if (tls_io_instance->small_record_byte_count >= DYNAMIC_RECORD_BOOST_BYTES)
+        {
+            set_send_fragment_size(tls_io_instance, DYNAMIC_RECORD_FULL_SIZE);
         }
         else
         {
-            tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
-            indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
-            LogError("Invalid tlsio_state. Expected state is TLSIO_STATE_OPENING_UNDERLYING_IO.");
+            set_send_fragment_size(tls_io_instance, DYNAMIC_RECORD_SMALL_SIZE);
+            if (!tls_io_instance->ktls_socket_attached &&
+                (part_size > DYNAMIC_RECORD_BOOST_BYTES - tls_io_instance->small_record_byte_count))
+            {
+                part_size = DYNAMIC_RECORD_BOOST_BYTES - tls_io_instance->small_record_byte_count;
+            }
+        }
+
+        res = SSL_write(tls_io_instance->ssl, buffer + written, (int)part_size);
+        if (res != (int)part_size)
+        {
+            // only the first write can fail with the socket attached, SSL_get_error is told its result
+            result = res;
+            break;
+        }
+
+        written += part_size;
+        if (tls_io_instance->small_record_byte_count < DYNAMIC_RECORD_BOOST_BYTES)
+        {
+            tls_io_instance->small_record_byte_count += part_size;
         }
     }
+
+    tls_io_instance->last_write_us = now;
+
+    return result;
 }
 
-static void on_underlying_io_error(void* context)
+// The SSL calls are what XIO_STATS::time_us measures for this layer: with the memory BIOs they only
+// encrypt and decrypt, the records are moved to and from the underlying IO outside of them
+static int ssl_write(TLS_IO_INSTANCE* tls_io_instance, const void* buffer, size_t size)
 {
-    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+    int result;
+#ifdef XIO_STATS_TIMING
+    uint64_t start_time_us = xio_stats_get_time_us();
+#endif
 
-    switch (tls_io_instance->tlsio_state)
+    if (tls_io_instance->dynamic_record_size)
     {
-    default:
-        break;
+        result = write_sized_records(tls_io_instance, (const unsigned char*)buffer, size);
+    }
+    else
+    {
+        result = SSL_write(tls_io_instance->ssl, buffer, (int)size);
+    }
 
-    case TLSIO_STATE_OPENING_UNDERLYING_IO:
-    case TLSIO_STATE_IN_HANDSHAKE:
-        tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
-        indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
-        break;
+#ifdef XIO_STATS_TIMING
+    tls_io_instance->stats.time_us += xio_stats_get_time_us() - start_time_us;
+#endif
+    return result;
+}
 
-    case TLSIO_STATE_OPEN:
-        indicate_error(tls_io_instance);
-        break;
-    }
+static int ssl_read(TLS_IO_INSTANCE* tls_io_instance, unsigned char* buffer, size_t size)
+{
+    int result;
+#ifdef XIO_STATS_TIMING
+    uint64_t start_time_us = xio_stats_get_time_us();
+#endif
+
+    result = SSL_read(tls_io_instance->ssl, buffer, (int)size);
+
+#ifdef XIO_STATS_TIMING
+    tls_io_instance->stats.time_us += xio_stats_get_time_us() - start_time_us;
+#endif
+    return result;
 }
 
-static int decode_ssl_received_bytes(TLS_IO_INSTANCE* tls_io_instance)
+static int ssl_do_handshake(TLS_IO_INSTANCE* tls_io_instance)
 {
-    int result = 0;
-    unsigned char buffer[64];
+    int result;
+#ifdef XIO_STATS_TIMING
+    uint64_t start_time_us = xio_stats_get_time_us();
+#endif
 
-    int rcv_bytes = 1;
+    result = SSL_do_handshake(tls_io_instance->ssl);
 
-    while (rcv_bytes > 0)
+#ifdef XIO_STATS_TIMING
+    tls_io_instance->stats.time_us += xio_stats_get_time_us() - start_time_us;
+#endif
+    return result;
+}
+
+// Points the SSL write side at the underlying socket, so that OpenSSL can hand the keys to the kernel
+// when the handshake changes cipher state. Reads keep going through the underlying IO and the in BIO.
+// If the underlying IO cannot give out its socket the memory BIOs are kept.
+static void attach_ktls_socket(TLS_IO_INSTANCE* tls_io_instance)
+{
+#ifdef TLSIO_OPENSSL_KTLS_SUPPORTED
+    int socket_descriptor = -1;
+
+    if (xio_setoption(tls_io_instance->underlying_io, OPTION_SOCKET_DESCRIPTOR, &socket_descriptor) != 0)
     {
-        if (tls_io_instance->ssl == NULL)
+        LogInfo("The underlying IO does not expose its socket, kernel TLS is not used.");
+    }
+    else
+    {
+        BIO* socket_bio = BIO_new_socket(socket_descriptor, BIO_NOCLOSE);
+        if (socket_bio == NULL)
         {
-            LogError("SSL channel closed in decode_ssl_received_bytes.");
-            result = __FAILURE__;
-            return result;
+            log_ERR_get_error("Failed BIO_new_socket, kernel TLS is not used.");
         }
-
-        rcv_bytes = SSL_read(tls_io_instance->ssl, buffer, sizeof(buffer));
-        if (rcv_bytes > 0)
+        else
         {
-            if (tls_io_instance->on_bytes_received == NULL)
-            {
-                LogError("NULL on_bytes_received.");
-            }
-            else
-            {
-                tls_io_instance->on_bytes_received(tls_io_instance->on_bytes_received_context, buffer, rcv_bytes);
-            }
+            // OpenSSL writes to the socket itself from now on, same as socketio does before its sends
+            signal(SIGPIPE, SIG_IGN);
+
+            // the memory out BIO is freed by the SSL, which owns it
+            SSL_set0_wbio(tls_io_instance->ssl, socket_bio);
+            tls_io_instance->out_bio = socket_bio;
+            tls_io_instance->ktls_socket_attached = true;
         }
     }
+#else
+    (void)tls_io_instance;
+#endif
+}
 
-    return result;
+static void free_ktls_pending_send(KTLS_PENDING_SEND* pending_send)
+{
+    free(pending_send->bytes);
+    free(pending_send);
 }
 
-static void on_underlying_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
+static KTLS_PENDING_SEND* remove_first_ktls_pending_send(TLS_IO_INSTANCE* tls_io_instance)
 {
-    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+    KTLS_PENDING_SEND* pending_send = tls_io_instance->ktls_pending_sends;
 
-    int written = BIO_write(tls_io_instance->in_bio, buffer, (int)size);
-    if (written != (int)size)
+    tls_io_instance->ktls_pending_sends = pending_send->next;
+    if (tls_io_instance->ktls_pending_sends == NULL)
     {
-        tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
-        indicate_error(tls_io_instance);
-        log_ERR_get_error("Error in BIO_write.");
+        tls_io_instance->ktls_last_pending_send = NULL;
     }
-    else
-    {
-        switch (tls_io_instance->tlsio_state)
-        {
-        default:
-            break;
 
-        case TLSIO_STATE_IN_HANDSHAKE:
-            send_handshake_bytes(tls_io_instance);
-            break;
+    return pending_send;
+}
 
-        case TLSIO_STATE_OPEN:
-            if (decode_ssl_received_bytes(tls_io_instance) != 0)
-            {
-                tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
-                indicate_error(tls_io_instance);
-                LogError("Error in decode_ssl_received_bytes.");
-            }
-            break;
-        }
+static void cancel_ktls_pending_sends(TLS_IO_INSTANCE* tls_io_instance)
+{
+    while (tls_io_instance->ktls_pending_sends != NULL)
+    {
+        KTLS_PENDING_SEND* pending_send = remove_first_ktls_pending_send(tls_io_instance);
+        indicate_send_complete(tls_io_instance, pending_send->on_send_complete, pending_send->callback_context, IO_SEND_CANCELLED);
+        free_ktls_pending_send(pending_send);
     }
 }
 
-static int add_certificate_to_store(TLS_IO_INSTANCE* tls_io_instance, const char* certValue)
+// Writes directly to the socket. When the socket cannot take the whole record yet the bytes are copied
+// and retried in order from tlsio_openssl_dowork (SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER is set).
+static int send_ktls_bytes(TLS_IO_INSTANCE* tls_io_instance, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
 {
-    int result = 0;
+    int result;
+    bool must_queue;
 
-    if (certValue != NULL)
+    if (tls_io_instance->ktls_pending_sends != NULL)
     {
-        X509_STORE* cert_store = SSL_CTX_get_cert_store(tls_io_instance->ssl_context);
-        if (cert_store == NULL)
+        must_queue = true;
+    }
+    else
+    {
+        int res;
+
+        ERR_clear_error();
+        res = ssl_write(tls_io_instance, buffer, size);
+        if (res == (int)size)
         {
-            log_ERR_get_error("failure in SSL_CTX_get_cert_store.");
-            result = __FAILURE__;
+            must_queue = false;
         }
         else
         {
-#if (OPENSSL_VERSION_NUMBER >= 0x10100000L) && (OPENSSL_VERSION_NUMBER < 0x20000000L)
-            const BIO_METHOD* bio_method;
-#else
-            BIO_METHOD* bio_method;
-#endif
-            bio_method = BIO_s_mem();
-            if (bio_method == NULL)
+            int ssl_err = SSL_get_error(tls_io_instance->ssl, res);
+            must_queue = (ssl_err == SSL_ERROR_WANT_WRITE) || (ssl_err == SSL_ERROR_WANT_READ);
+            if (!must_queue)
             {
-                log_ERR_get_error("failure in BIO_s_mem");
-                result = __FAILURE__;
-            }
-            else
-            {
-                BIO* cert_memory_bio = BIO_new(bio_method);
-
-                if (cert_memory_bio == NULL)
-                {
-                    log_ERR_get_error("failure in BIO_new");
-                    result = __FAILURE__;
-                }
-                else
-                {
-                    int puts_result = BIO_puts(cert_memory_bio, certValue);
-                    if (puts_result < 0)
-                    {
-                        log_ERR_get_error("failure in BIO_puts");
-                        result = __FAILURE__;
-                    }
-                    else
-                    {
-                        if ((size_t)puts_result != strlen(certValue))
-                        {
-                            log_ERR_get_error("mismatching legths");
-                            result = __FAILURE__;
-                        }
-                        else
-                        {
-                            X509* certificate;
-                            while ((certificate = PEM_read_bio_X509(cert_memory_bio, NULL, NULL, NULL)) != NULL)
-                            {
-                                if (!X509_STORE_add_cert(cert_store, certificate))
-                                {
-                                    X509_free(certificate);
-                                    log_ERR_get_error("failure in X509_STORE_add_cert");
-                                    break;
-                                }
-                                X509_free(certificate);
-                            }
-                            if (certificate == NULL)
-                            {
-                                result = 0;/*all is fine*/
-                            }
-                            else
-                            {
-                                /*previous while loop terminated unfortunately*/
-                                result = __FAILURE__;
-                            }
-                        }
-                    }
-                    BIO_free(cert_memory_bio);
-                }
+                log_ERR_get_error("SSL_write error.");
+                return __FAILURE__;
             }
         }
     }
-    return result;
-}
-
-static int create_openssl_instance(TLS_IO_INSTANCE* tlsInstance)
-{
-    int result;
-
-    const SSL_METHOD* method = NULL;
-
-#if (OPENSSL_VERSION_NUMBER < 0x10100000L) || (OPENSSL_VERSION_NUMBER >= 0x20000000L)
-    if (tlsInstance->tls_version == VERSION_1_2)
-    {
-        method = TLSv1_2_method();
-    }
-    else if (tlsInstance->tls_version == VERSION_1_1)
-    {
-        method = TLSv1_1_method();
-    }
-    else
-    {
-        method = TLSv1_method();
-    }
-#else
-    {
-        method = TLS_method();
-    }
-#endif
 
-    tlsInstance->ssl_context = SSL_CTX_new(method);
-    if (tlsInstance->ssl_context == NULL)
-    {
-        log_ERR_get_error("Failed allocating OpenSSL context.");
-        result = __FAILURE__;
-    }
-    else if ((tlsInstance->cipher_list != NULL) &&
-             (SSL_CTX_set_cipher_list(tlsInstance->ssl_context, tlsInstance->cipher_list)) != 1)
-    {
-        SSL_CTX_free(tlsInstance->ssl_context);
-        tlsInstance->ssl_context = NULL;
-        log_ERR_get_error("unable to set cipher list.");
-        result = __FAILURE__;
-    }
-    else if (add_certificate_to_store(tlsInstance, tlsInstance->certificate) != 0)
-    {
-        SSL_CTX_free(tlsInstance->ssl_context);
-        tlsInstance->ssl_context = NULL;
-        log_ERR_get_error("unable to add_certificate_to_store.");
-        result = __FAILURE__;
-    }
-    /*x509 authentication can only be build before underlying connection is realized*/
-    else if (
-        (tlsInstance->x509_certificate != NULL) &&
-        (tlsInstance->x509_private_key != NULL) &&
-        (x509_openssl_add_credentials(tlsInstance->ssl_context, tlsInstance->x509_certificate, tlsInstance->x509_private_key) != 0)
-        )
+    if (!must_queue)
     {
-        SSL_CTX_free(tlsInstance->ssl_context);
-        tlsInstance->ssl_context = NULL;
-        log_ERR_get_error("unable to use x509 authentication");
-        result = __FAILURE__;
+        indicate_send_complete(tls_io_instance, on_send_complete, callback_context, IO_SEND_OK);
+        result = 0;
     }
     else
     {
-        SSL_CTX_set_cert_verify_callback(tlsInstance->ssl_context, tlsInstance->tls_validation_callback, tlsInstance->tls_validation_callback_data);
-
-        tlsInstance->in_bio = BIO_new(BIO_s_mem());
-        if (tlsInstance->in_bio == NULL)
+        KTLS_PENDING_SEND* pending_send = (KTLS_PENDING_SEND*)malloc(sizeof(KTLS_PENDING_SEND));
+        if (pending_send == NULL)
         {
-            SSL_CTX_free(tlsInstance->ssl_context);
-            tlsInstance->ssl_context = NULL;
-            log_ERR_get_error("Failed BIO_new for in BIO.");
+            LogError("Failed allocating pending send.");
+            result = __FAILURE__;
+        }
+        else if ((pending_send->bytes = (unsigned char*)malloc(size)) == NULL)
+        {
+            LogError("Failed allocating %lu bytes for pending send.", (unsigned long)size);
+            free(pending_send);
             result = __FAILURE__;
         }
         else
         {
-            tlsInstance->out_bio = BIO_new(BIO_s_mem());
-            if (tlsInstance->out_bio == NULL)
+            (void)memcpy(pending_send->bytes, buffer, size);
+            pending_send->size = size;
+            pending_send->on_send_complete = on_send_complete;
+            pending_send->callback_context = callback_context;
+            pending_send->next = NULL;
+
+            if (tls_io_instance->ktls_last_pending_send == NULL)
             {
-                (void)BIO_free(tlsInstance->in_bio);
-                SSL_CTX_free(tlsInstance->ssl_context);
-                tlsInstance->ssl_context = NULL;
-                log_ERR_get_error("Failed BIO_new for out BIO.");
-                result = __FAILURE__;
+                tls_io_instance->ktls_pending_sends = pending_send;
             }
             else
             {
-                if ((BIO_set_mem_eof_return(tlsInstance->in_bio, -1) <= 0) ||
-                    (BIO_set_mem_eof_return(tlsInstance->out_bio, -1) <= 0))
-                {
-                    (void)BIO_free(tlsInstance->in_bio);
-                    (void)BIO_free(tlsInstance->out_bio);
-                    SSL_CTX_free(tlsInstance->ssl_context);
-                    tlsInstance->ssl_context = NULL;
-                    LogError("Failed BIO_set_mem_eof_return.");
-                    result = __FAILURE__;
-                }
-                else
-                {
-                    SSL_CTX_set_verify(tlsInstance->ssl_context, SSL_VERIFY_PEER, NULL);
-
-                    // Specifies that the default locations for which CA certificates are loaded should be used.
-                    if (SSL_CTX_set_default_verify_paths(tlsInstance->ssl_context) != 1)
-                    {
-                        // This is only a warning to the user. They can still specify the certificate via SetOption.
-                        LogInfo("WARNING: Unable to specify the default location for CA certificates on this platform.");
-                    }
-
-                    tlsInstance->ssl = SSL_new(tlsInstance->ssl_context);
-                    if (tlsInstance->ssl == NULL)
-                    {
-                        (void)BIO_free(tlsInstance->in_bio);
-                        (void)BIO_free(tlsInstance->out_bio);
-                        SSL_CTX_free(tlsInstance->ssl_context);
-                        tlsInstance->ssl_context = NULL;
-                        log_ERR_get_error("Failed creating OpenSSL instance.");
-                        result = __FAILURE__;
-                    }
-                    else
-                    {
-                        SSL_set_bio(tlsInstance->ssl, tlsInstance->in_bio, tlsInstance->out_bio);
-                        SSL_set_connect_state(tlsInstance->ssl);
-                        result = 0;
-                    }
-                }
+                tls_io_instance->ktls_last_pending_send->next = pending_send;
             }
+            tls_io_instance->ktls_last_pending_send = pending_send;
+            tls_io_instance->stats.queued_send_count++;
+
+            result = 0;
         }
     }
+
     return result;
 }
 
-int tlsio_openssl_init(void)
+static void flush_ktls_pending_sends(TLS_IO_INSTANCE* tls_io_instance)
 {
-    (void)SSL_library_init();
+    // a send complete callback may close this instance, which cancels (and empties) the queue
+    while ((tls_io_instance->ktls_pending_sends != NULL) && (tls_io_instance->ssl != NULL))
+    {
+        KTLS_PENDING_SEND* pending_send = tls_io_instance->ktls_pending_sends;
+        int res;
 
-    SSL_load_error_strings();
-    ERR_load_BIO_strings();
-    OpenSSL_add_all_algorithms();
+        ERR_clear_error();
+        res = ssl_write(tls_io_instance, pending_send->bytes, pending_send->size);
+        if (res == (int)pending_send->size)
+        {
+            (void)remove_first_ktls_pending_send(tls_io_instance);
+            indicate_send_complete(tls_io_instance, pending_send->on_send_complete, pending_send->callback_context, IO_SEND_OK);
+            free_ktls_pending_send(pending_send);
+        }
+        else
+        {
+            int ssl_err = SSL_get_error(tls_io_instance->ssl, res);
+            if ((ssl_err != SSL_ERROR_WANT_WRITE) && (ssl_err != SSL_ERROR_WANT_READ))
+            {
+                log_ERR_get_error("SSL_write error.");
+                (void)remove_first_ktls_pending_send(tls_io_instance);
+                indicate_send_complete(tls_io_instance, pending_send->on_send_complete, pending_send->callback_context, IO_SEND_ERROR);
+                free_ktls_pending_send(pending_send);
 
-    if (openssl_static_locks_install() != 0)
-    {
-        LogError("Failed to install static locks in OpenSSL!");
-        return __FAILURE__;
+                tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+                indicate_error(tls_io_instance);
+            }
+            break;
+        }
     }
-
-    openssl_dynamic_locks_install();
-    return 0;
 }
 
-void tlsio_openssl_deinit(void)
+static void count_send(TLS_IO_INSTANCE* tls_io_instance, size_t size)
 {
-    openssl_dynamic_locks_uninstall();
-    openssl_static_locks_uninstall();
-#if  (OPENSSL_VERSION_NUMBER >= 0x00907000L) &&  (OPENSSL_VERSION_NUMBER < 0x20000000L) && (FIPS_mode_set)
-    FIPS_mode_set(0);
-#endif
-    CRYPTO_set_locking_callback(NULL);
-    CRYPTO_set_id_callback(NULL);
-    ERR_free_strings();
-    EVP_cleanup();
-
-#if   (OPENSSL_VERSION_NUMBER < 0x10000000L)
-    ERR_remove_state(0);
-#elif (OPENSSL_VERSION_NUMBER < 0x10100000L) || (OPENSSL_VERSION_NUMBER >= 0x20000000L)
-    ERR_remove_thread_state(NULL);
-#endif
-#if  (OPENSSL_VERSION_NUMBER >= 0x10002000L) &&  (OPENSSL_VERSION_NUMBER < 0x10010000L) && (SSL_COMP_free_compression_methods)
-    SSL_COMP_free_compression_methods();
-#endif
-    CRYPTO_cleanup_all_ex_data();
+    tls_io_instance->stats.send_count++;
+    tls_io_instance->stats.bytes_sent += size;
 }
 
-CONCRETE_IO_HANDLE tlsio_openssl_create(void* io_create_parameters)
+static int write_outgoing_bytes(TLS_IO_INSTANCE* tls_io_instance, ON_SEND_COMPLETE on_send_complete, void* callback_context)
 {
-    TLSIO_CONFIG* tls_io_config = io_create_parameters;
-    TLS_IO_INSTANCE* result;
+    int result;
 
-    if (tls_io_config == NULL)
+    // with the socket attached OpenSSL has already written everything it produced
+    size_t pending = tls_io_instance->ktls_socket_attached ? 0 : BIO_ctrl_pending(tls_io_instance->out_bio);
+
+    if (pending == 0)
     {
-        result = NULL;
-        LogError("NULL tls_io_config.");
+        result = 0;
     }
     else
     {
-        result = malloc(sizeof(TLS_IO_INSTANCE));
-        if (result == NULL)
-        {
-            LogError("Failed allocating TLSIO instance.");
-        }
-        else
+        // The staging buffer is kept for the lifetime of the connection and only grows,
+        // so steady state flushes do not allocate
+        if (pending > tls_io_instance->send_buffer_size)
         {
-            SOCKETIO_CONFIG socketio_config;
-            const IO_INTERFACE_DESCRIPTION* underlying_io_interface;
-            void* io_interface_parameters;
-
-            if (tls_io_config->underlying_io_interface != NULL)
+            unsigned char* new_send_buffer = (unsigned char*)realloc(tls_io_instance->send_buffer, pending);
+            if (new_send_buffer == NULL)
             {
-                underlying_io_interface = tls_io_config->underlying_io_interface;
-                io_interface_parameters = tls_io_config->underlying_io_parameters;
+                LogError("Failed growing the send buffer to %lu bytes.", (unsigned long)pending);
             }
             else
             {
-                socketio_config.hostname = tls_io_config->hostname;
-                socketio_config.port = tls_io_config->port;
-                socketio_config.accepted_socket = NULL;
-
-                underlying_io_interface = socketio_get_interface_description();
-                io_interface_parameters = &socketio_config;
+                tls_io_instance->send_buffer = new_send_buffer;
+                tls_io_instance->send_buffer_size = pending;
             }
+        }
 
-            if (underlying_io_interface == NULL)
+        if (pending > tls_io_instance->send_buffer_size)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            unsigned char* bytes_to_send = tls_io_instance->send_buffer;
+
+            if (BIO_read(tls_io_instance->out_bio, bytes_to_send, (int)pending) != (int)pending)
             {
-                free(result);
-                result = NULL;
-                LogError("Failed getting socket IO interface description.");
+                log_ERR_get_error("BIO_read not in pending state.");
+                result = __FAILURE__;
             }
             else
             {
-                result->certificate = NULL;
-                result->cipher_list = NULL;
-                result->in_bio = NULL;
-                result->out_bio = NULL;
-                result->on_bytes_received = NULL;
-                result->on_bytes_received_context = NULL;
-                result->on_io_open_complete = NULL;
-                result->on_io_open_complete_context = NULL;
-                result->on_io_close_complete = NULL;
-                result->on_io_close_complete_context = NULL;
-                result->on_io_error = NULL;
-                result->on_io_error_context = NULL;
-                result->ssl = NULL;
-                result->ssl_context = NULL;
-                result->tls_validation_callback = NULL;
-                result->tls_validation_callback_data = NULL;
-                result->x509_certificate = NULL;
-                result->x509_private_key = NULL;
-
-                result->tls_version = VERSION_1_2;
-
-                result->underlying_io = xio_create(underlying_io_interface, io_interface_parameters);
-                if (result->underlying_io == NULL)
+                if (xio_send(tls_io_instance->underlying_io, bytes_to_send, pending, on_send_complete, callback_context) != 0)
                 {
-                    free(result);
-                    result = NULL;
-                    LogError("Failed xio_create.");
+                    LogError("Error in xio_send.");
+                    result = __FAILURE__;
                 }
                 else
                 {
-                    result->tlsio_state = TLSIO_STATE_NOT_OPEN;
+                    result = 0;
                 }
             }
         }
-}
+    }
 
     return result;
 }
 
-void tlsio_openssl_destroy(CONCRETE_IO_HANDLE tls_io)
+static void complete_corked_sends(TLS_IO_INSTANCE* tls_io_instance, TLS_CORKED_SEND* sends, size_t send_count, IO_SEND_RESULT send_result)
 {
-    if (tls_io == NULL)
-    {
-        LogError("NULL tls_io.");
-    }
-    else
+    size_t i;
+
+    for (i = 0; i < send_count; i++)
     {
-        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
-        if (tls_io_instance->certificate != NULL)
-        {
-            free(tls_io_instance->certificate);
-            tls_io_instance->certificate = NULL;
-        }
-        if (tls_io_instance->cipher_list != NULL)
-        {
-            free(tls_io_instance->cipher_list);
-            tls_io_instance->cipher_list = NULL;
-        }
-        free((void*)tls_io_instance->x509_certificate);
-        free((void*)tls_io_instance->x509_private_key);
-        close_openssl_instance(tls_io_instance);
-        if (tls_io_instance->underlying_io != NULL)
-        {
-            xio_destroy(tls_io_instance->underlying_io);
-            tls_io_instance->underlying_io = NULL;
-        }
-        free(tls_io);
+        indicate_send_complete(tls_io_instance, sends[i].on_send_complete, sends[i].callback_context, send_result);
     }
 }
 
-int tlsio_openssl_open(CONCRETE_IO_HANDLE tls_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+static void on_corked_send_batch_complete(void* context, IO_SEND_RESULT send_result)
 {
-    int result;
+    TLS_CORKED_SEND_BATCH* batch = (TLS_CORKED_SEND_BATCH*)context;
 
-    if (tls_io == NULL)
+    complete_corked_sends(batch->tls_io_instance, batch->sends, batch->send_count, send_result);
+    free(batch->sends);
+    free(batch);
+}
+
+// Gives the array back to the instance after a flush, unless a callback corked new sends meanwhile
+static void reuse_corked_sends(TLS_IO_INSTANCE* tls_io_instance, TLS_CORKED_SEND* sends, size_t sends_size)
+{
+    if (tls_io_instance->corked_sends == NULL)
     {
-        result = __FAILURE__;
-        LogError("NULL tls_io.");
+        tls_io_instance->corked_sends = sends;
+        tls_io_instance->corked_sends_size = sends_size;
     }
     else
     {
-        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+        free(sends);
+    }
+}
 
-        if (tls_io_instance->tlsio_state != TLSIO_STATE_NOT_OPEN)
-        {
-            LogError("Invalid tlsio_state. Expected state is TLSIO_STATE_NOT_OPEN.");
-            result = __FAILURE__;
-        }
-        else
-        {
-            tls_io_instance->on_io_open_complete = on_io_open_complete;
-            tls_io_instance->on_io_open_complete_context = on_io_open_complete_context;
-
-            tls_io_instance->on_bytes_received = on_bytes_received;
-            tls_io_instance->on_bytes_received_context = on_bytes_received_context;
-
-            tls_io_instance->on_io_error = on_io_error;
-            tls_io_instance->on_io_error_context = on_io_error_context;
-
-            tls_io_instance->tlsio_state = TLSIO_STATE_OPENING_UNDERLYING_IO;
+static void cancel_corked_sends(TLS_IO_INSTANCE* tls_io_instance)
+{
+    // the array is detached first, a callback may send again
+    TLS_CORKED_SEND* sends = tls_io_instance->corked_sends;
+    size_t send_count = tls_io_instance->corked_send_count;
 
-            if (create_openssl_instance(tls_io_instance) != 0)
-            {
-                LogError("Failed creating the OpenSSL instance.");
-                tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
-                result = __FAILURE__;
-            }
-            else if (xio_open(tls_io_instance->underlying_io, on_underlying_io_open_complete, tls_io_instance,
-                on_underlying_io_bytes_received, tls_io_instance, on_underlying_io_error, tls_io_instance) != 0)
-            {
-                LogError("Failed opening the underlying I/O.");
-                close_openssl_instance(tls_io_instance);
-                tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
-                result = __FAILURE__;
-            }
-            else
-            {
-                result = 0;
-            }
-        }
-    }
+    tls_io_instance->corked_sends = NULL;
+    tls_io_instance->corked_sends_size = 0;
+    tls_io_instance->corked_send_count = 0;
+    tls_io_instance->corked_byte_count = 0;
 
-    return result;
+    complete_corked_sends(tls_io_instance, sends, send_count, IO_SEND_CANCELLED);
+    free(sends);
 }
 
-/* Codes_SRS_TLSIO_30_009: [ The phrase "enter TLSIO_STATE_EXT_CLOSING" means the adapter shall iterate through any unsent messages in the queue and shall delete each message after calling its on_send_complete with the associated callback_context and IO_SEND_CANCELLED. ]*/
-/* Codes_SRS_TLSIO_30_006: [ The phrase "enter TLSIO_STATE_EXT_CLOSED" means the adapter shall forcibly close any existing connections then call the on_io_close_complete function and pass the on_io_close_complete_context that was supplied in tlsio_close_async. ]*/
-/* Codes_SRS_TLSIO_30_051: [ On success, if the underlying TLS does not support asynchronous closing, then the adapter shall enter TLSIO_STATE_EXT_CLOSED immediately after entering TLSIO_STATE_EX_CLOSING. ]*/
-int tlsio_openssl_close(CONCRETE_IO_HANDLE tls_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+// Holds the send until the end of the dowork pass. The buffers only grow, so steady state sends do not allocate.
+static int cork_send(TLS_IO_INSTANCE* tls_io_instance, const XIO_BUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* callback_context)
 {
     int result;
+    size_t total_size = 0;
+    size_t i;
 
-    /* Codes_SRS_TLSIO_30_050: [ If the tlsio_handle parameter is NULL, tlsio_close_async shall log an error and return _FAILURE_. ]*/
-    if (tls_io == NULL)
+    for (i = 0; i < buffer_count; i++)
     {
-        LogError("NULL tls_io.");
-        result = __FAILURE__;
+        total_size += buffers[i].size;
     }
-    else
-    {
-        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
 
-        if (tls_io_instance->tlsio_state != TLSIO_STATE_ERROR && tls_io_instance->tlsio_state != TLSIO_STATE_OPEN)
+    if (tls_io_instance->corked_send_count == tls_io_instance->corked_sends_size)
+    {
+        size_t new_size = (tls_io_instance->corked_sends_size == 0) ? 8 : tls_io_instance->corked_sends_size * 2;
+        TLS_CORKED_SEND* new_sends = (TLS_CORKED_SEND*)realloc(tls_io_instance->corked_sends, new_size * sizeof(TLS_CORKED_SEND));
+        if (new_sends == NULL)
         {
-            /* Codes_RS_TLSIO_30_053: [ If the adapter is in any state other than TLSIO_STATE_EXT_OPEN or TLSIO_STATE_EXT_ERROR then tlsio_close_async shall log that tlsio_close_async has been called and then continue normally. ]*/
-            // LogInfo rather than LogError because this is an unusual but not erroneous situation
-            LogInfo("Closing tlsio from a state other than TLSIO_STATE_EXT_OPEN or TLSIO_STATE_EXT_ERROR");
+            LogError("Failed growing the corked sends to %lu entries.", (unsigned long)new_size);
+        }
+        else
+        {
+            tls_io_instance->corked_sends = new_sends;
+            tls_io_instance->corked_sends_size = new_size;
         }
+    }
+
+    if (tls_io_instance->corked_byte_count + total_size > tls_io_instance->corked_bytes_size)
+    {
+        size_t needed = tls_io_instance->corked_byte_count + total_size;
+        size_t new_size = (tls_io_instance->corked_bytes_size < CORK_FLUSH_SIZE) ? CORK_FLUSH_SIZE : tls_io_instance->corked_bytes_size * 2;
+        unsigned char* new_corked_bytes;
 
-        if (is_an_opening_state(tls_io_instance->tlsio_state))
+        if (new_size < needed)
         {
-            /* Codes_SRS_TLSIO_30_057: [ On success, if the adapter is in TLSIO_STATE_EXT_OPENING, it shall call on_io_open_complete with the on_io_open_complete_context supplied in tlsio_open_async and IO_OPEN_CANCELLED. This callback shall be made before changing the internal state of the adapter. ]*/
-            tls_io_instance->on_io_open_complete(tls_io_instance->on_io_open_complete_context, IO_OPEN_CANCELLED);
+            new_size = needed;
         }
 
-        if (tls_io_instance->tlsio_state == TLSIO_STATE_OPEN)
+        new_corked_bytes = (unsigned char*)realloc(tls_io_instance->corked_bytes, new_size);
+        if (new_corked_bytes == NULL)
         {
-            // Attempt a graceful shutdown
-            /* Codes_SRS_TLSIO_30_056: [ On success the adapter shall enter TLSIO_STATE_EX_CLOSING. ]*/
-            tls_io_instance->tlsio_state = TLSIO_STATE_CLOSING;
-            tls_io_instance->on_io_close_complete = on_io_close_complete;
-            tls_io_instance->on_io_close_complete_context = callback_context;
-            // xio_close is guaranteed to succeed from the open state, and the callback completes the
-            // transition into TLSIO_STATE_NOT_OPEN
-            if (xio_close(tls_io_instance->underlying_io, on_underlying_io_close_complete, tls_io_instance) != 0)
-            {
-                close_openssl_instance(tls_io_instance);
-                tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
-            }
+            LogError("Failed growing the corked bytes to %lu bytes.", (unsigned long)new_size);
         }
         else
         {
-            // Just force the shutdown
-            /* Codes_SRS_TLSIO_30_056: [ On success the adapter shall enter TLSIO_STATE_EX_CLOSING. ]*/
-            /* Codes_SRS_TLSIO_30_051: [ On success, if the underlying TLS does not support asynchronous closing or if the adapter is not in TLSIO_STATE_EXT_OPEN, then the adapter shall enter TLSIO_STATE_EXT_CLOSED immediately after entering TLSIO_STATE_EXT_CLOSING. ]*/
-            // Current implementations of xio_close will fail if not in the open state, but we don't care
-            (void)xio_close(tls_io_instance->underlying_io, NULL, NULL);
-            close_openssl_instance(tls_io_instance);
-            tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+            tls_io_instance->corked_bytes = new_corked_bytes;
+            tls_io_instance->corked_bytes_size = new_size;
+        }
+    }
+
+    if ((tls_io_instance->corked_send_count == tls_io_instance->corked_sends_size) ||
+        (tls_io_instance->corked_byte_count + total_size > tls_io_instance->corked_bytes_size))
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        for (i = 0; i < buffer_count; i++)
+        {
+            if (buffers[i].size > 0)
+            {
+                (void)memcpy(tls_io_instance->corked_bytes + tls_io_instance->corked_byte_count, buffers[i].buffer, buffers[i].size);
+                tls_io_instance->corked_byte_count += buffers[i].size;
+            }
         }
 
+        tls_io_instance->corked_sends[tls_io_instance->corked_send_count].on_send_complete = on_send_complete;
+        tls_io_instance->corked_sends[tls_io_instance->corked_send_count].callback_context = callback_context;
+        tls_io_instance->corked_send_count++;
+        tls_io_instance->stats.queued_send_count++;
+
         result = 0;
     }
-    /* Codes_SRS_TLSIO_30_054: [ On failure, the adapter shall not call on_io_close_complete. ]*/
 
     return result;
 }
 
-int tlsio_openssl_send(CONCRETE_IO_HANDLE tls_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+// Encrypts everything corked in one SSL_write, so OpenSSL emits full sized records, and hands the records to
+// the underlying IO in one send whose completion completes all the corked sends
+static int flush_corked_sends(TLS_IO_INSTANCE* tls_io_instance)
 {
     int result;
 
-    if (tls_io == NULL)
+    if (tls_io_instance->corked_send_count == 0)
     {
-        LogError("NULL tls_io.");
-        result = __FAILURE__;
+        result = 0;
     }
     else
     {
-        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
-
-        if (tls_io_instance->tlsio_state != TLSIO_STATE_OPEN)
+        TLS_CORKED_SEND* sends = tls_io_instance->corked_sends;
+        size_t sends_size = tls_io_instance->corked_sends_size;
+        size_t send_count = tls_io_instance->corked_send_count;
+        size_t byte_count = tls_io_instance->corked_byte_count;
+        TLS_CORKED_SEND_BATCH* batch = NULL;
+        ON_SEND_COMPLETE on_send_complete;
+        void* callback_context;
+
+        // the sends are detached during the flush since a callback may cork new ones, the bytes are copied
+        // by SSL_write (or send_ktls_bytes) and their buffer is kept
+        tls_io_instance->corked_sends = NULL;
+        tls_io_instance->corked_sends_size = 0;
+        tls_io_instance->corked_send_count = 0;
+        tls_io_instance->corked_byte_count = 0;
+
+        if (byte_count == 0)
         {
-            LogError("Invalid tlsio_state. Expected state is TLSIO_STATE_OPEN.");
-            result = __FAILURE__;
+            // only empty sends, there is nothing to write
+            complete_corked_sends(tls_io_instance, sends, send_count, IO_SEND_OK);
+            reuse_corked_sends(tls_io_instance, sends, sends_size);
+            result = 0;
         }
         else
         {
-            int res;
-            if (tls_io_instance->ssl == NULL)
+            if (send_count == 1)
             {
-                LogError("SSL channel closed in tlsio_openssl_send.");
-                result = __FAILURE__;
-                return result;
+                on_send_complete = sends[0].on_send_complete;
+                callback_context = sends[0].callback_context;
+                result = 0;
             }
-
-            res = SSL_write(tls_io_instance->ssl, buffer, (int)size);
-            if (res != (int)size)
+            else if ((batch = (TLS_CORKED_SEND_BATCH*)malloc(sizeof(TLS_CORKED_SEND_BATCH))) == NULL)
             {
-                log_ERR_get_error("SSL_write error.");
+                LogError("Failed allocating corked send batch.");
+                on_send_complete = NULL;
+                callback_context = NULL;
                 result = __FAILURE__;
             }
             else
             {
-                if (write_outgoing_bytes(tls_io_instance, on_send_complete, callback_context) != 0)
+                batch->tls_io_instance = tls_io_instance;
+                batch->sends = sends;
+                batch->send_count = send_count;
+                on_send_complete = on_corked_send_batch_complete;
+                callback_context = batch;
+                result = 0;
+            }
+
+            if (result != 0)
+            {
+                /* nothing to write with */
+            }
+            else if (tls_io_instance->ktls_socket_attached)
+            {
+                // send_ktls_bytes copies what the socket cannot take yet
+                if (send_ktls_bytes(tls_io_instance, tls_io_instance->corked_bytes, byte_count, on_send_complete, callback_context) != 0)
                 {
-                    LogError("Error in write_outgoing_bytes.");
+                    LogError("Error in send_ktls_bytes.");
                     result = __FAILURE__;
                 }
-                else
-                {
-                    result = 0;
-                }
+            }
+            else if (ssl_write(tls_io_instance, tls_io_instance->corked_bytes, byte_count) != (int)byte_count)
+            {
+                log_ERR_get_error("SSL_write error.");
+                result = __FAILURE__;
+            }
+            else if (write_outgoing_bytes(tls_io_instance, on_send_complete, callback_context) != 0)
+            {
+                LogError("Error in write_outgoing_bytes.");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* the underlying IO completes the sends */
+            }
+
+            if (result != 0)
+            {
+                // none of the sends was given to the underlying IO
+                complete_corked_sends(tls_io_instance, sends, send_count, IO_SEND_ERROR);
+                free(sends);
+                free(batch);
+            }
+            else if (batch == NULL)
+            {
+                reuse_corked_sends(tls_io_instance, sends, sends_size);
             }
         }
     }
@@ -1385,221 +1996,3306 @@ int tlsio_openssl_send(CONCRETE_IO_HANDLE tls_io, const void* buffer, size_t siz
     return result;
 }
 
-void tlsio_openssl_dowork(CONCRETE_IO_HANDLE tls_io)
+// On failure the corked sends have been completed with IO_SEND_ERROR, the connection is unusable
+static void flush_corked_sends_or_fail(TLS_IO_INSTANCE* tls_io_instance)
 {
-    if (tls_io == NULL)
+    if (flush_corked_sends(tls_io_instance) != 0)
     {
-        LogError("NULL tls_io.");
+        LogError("Failed flushing the corked sends.");
+        tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+        indicate_error(tls_io_instance);
     }
-    else
+}
+
+// Completes the sends written as early data, which the server has either taken or will get again after the handshake
+static void complete_early_data_sends(TLS_IO_INSTANCE* tls_io_instance, IO_SEND_RESULT send_result)
+{
+    // the sends are detached first, a callback may send again
+    TLS_CORKED_SEND* sends = tls_io_instance->early_data_sends;
+    size_t send_count = tls_io_instance->early_data_send_count;
+
+    free(tls_io_instance->early_data_bytes);
+    tls_io_instance->early_data_bytes = NULL;
+    tls_io_instance->early_data_bytes_size = 0;
+    tls_io_instance->early_data_byte_count = 0;
+    tls_io_instance->early_data_sends = NULL;
+    tls_io_instance->early_data_sends_size = 0;
+    tls_io_instance->early_data_send_count = 0;
+
+    complete_corked_sends(tls_io_instance, sends, send_count, send_result);
+    free(sends);
+}
+
+// Puts the sends the server rejected as early data back in front of the ones corked since, so that they are flushed
+// first once the handshake is done
+static int uncork_early_data_sends(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result;
+
+    if (tls_io_instance->corked_send_count > 0)
     {
-        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+        size_t send_count = tls_io_instance->early_data_send_count + tls_io_instance->corked_send_count;
+        size_t byte_count = tls_io_instance->early_data_byte_count + tls_io_instance->corked_byte_count;
+        TLS_CORKED_SEND* sends = (TLS_CORKED_SEND*)realloc(tls_io_instance->early_data_sends, send_count * sizeof(TLS_CORKED_SEND));
 
-        switch (tls_io_instance->tlsio_state)
+        if (sends == NULL)
         {
-        case TLSIO_STATE_OPENING_UNDERLYING_IO:
-        case TLSIO_STATE_IN_HANDSHAKE:
-        case TLSIO_STATE_OPEN:
-            /* this is needed in order to pump out bytes produces by OpenSSL for things like renegotiation */
-            write_outgoing_bytes(tls_io_instance, NULL, NULL);
-            break;
-        case TLSIO_STATE_NOT_OPEN:
-        case TLSIO_STATE_HANDSHAKE_FAILED:
-        case TLSIO_STATE_CLOSING:
-        case TLSIO_STATE_ERROR:
-        default:
-            break;
+            LogError("Failed growing the early data sends to %lu entries.", (unsigned long)send_count);
+            result = __FAILURE__;
         }
-
-        if (tls_io_instance->tlsio_state != TLSIO_STATE_NOT_OPEN)
+        else
         {
-            /* Same behavior as schannel */
-            xio_dowork(tls_io_instance->underlying_io);
+            unsigned char* bytes;
 
-            if (tls_io_instance->tlsio_state == TLSIO_STATE_HANDSHAKE_FAILED)
+            tls_io_instance->early_data_sends = sends;
+            tls_io_instance->early_data_sends_size = send_count;
+
+            if ((byte_count > tls_io_instance->early_data_bytes_size) &&
+                ((bytes = (unsigned char*)realloc(tls_io_instance->early_data_bytes, byte_count)) == NULL))
             {
-                // The handshake failed so we need to close. The tlsio becomes aware of the
-                // handshake failure during an on_bytes_received while the underlying
-                // xio_dowork is pumping data out of the socket in a while loop. The tlsio can't
-                // close down during the callback because that would mean the xio_dowork would
-                // be trying to read from a closed socket. So instead, the tlsio sets its state
-                // to TLSIO_STATE_HANDSHAKE_FAILED during the on_bytes_received callback,
-                // can then gracefully shut things down here.
-                //
-                // Set the state to TLSIO_STATE_ERROR so close won't gripe about the state
-                tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
-                tlsio_openssl_close(tls_io_instance, NULL, NULL);
-                indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
+                LogError("Failed growing the early data bytes to %lu bytes.", (unsigned long)byte_count);
+                result = __FAILURE__;
+            }
+            else
+            {
+                if (byte_count > tls_io_instance->early_data_bytes_size)
+                {
+                    tls_io_instance->early_data_bytes = bytes;
+                    tls_io_instance->early_data_bytes_size = byte_count;
+                }
+
+                (void)memcpy(sends + tls_io_instance->early_data_send_count, tls_io_instance->corked_sends, tls_io_instance->corked_send_count * sizeof(TLS_CORKED_SEND));
+                if (tls_io_instance->corked_byte_count > 0)
+                {
+                    (void)memcpy(tls_io_instance->early_data_bytes + tls_io_instance->early_data_byte_count, tls_io_instance->corked_bytes, tls_io_instance->corked_byte_count);
+                }
+                tls_io_instance->early_data_send_count = send_count;
+                tls_io_instance->early_data_byte_count = byte_count;
+                result = 0;
             }
         }
     }
+    else
+    {
+        result = 0;
+    }
+
+    if (result == 0)
+    {
+        free(tls_io_instance->corked_sends);
+        free(tls_io_instance->corked_bytes);
+        tls_io_instance->corked_sends = tls_io_instance->early_data_sends;
+        tls_io_instance->corked_sends_size = tls_io_instance->early_data_sends_size;
+        tls_io_instance->corked_send_count = tls_io_instance->early_data_send_count;
+        tls_io_instance->corked_bytes = tls_io_instance->early_data_bytes;
+        tls_io_instance->corked_bytes_size = tls_io_instance->early_data_bytes_size;
+        tls_io_instance->corked_byte_count = tls_io_instance->early_data_byte_count;
+
+        tls_io_instance->early_data_sends = NULL;
+        tls_io_instance->early_data_sends_size = 0;
+        tls_io_instance->early_data_send_count = 0;
+        tls_io_instance->early_data_bytes = NULL;
+        tls_io_instance->early_data_bytes_size = 0;
+        tls_io_instance->early_data_byte_count = 0;
+    }
+
+    return result;
 }
 
-int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, const void* value)
+// Called once the handshake of an IO opened for early data is done. The sends held meanwhile are then flushed,
+// after the early data ones if the server rejected them.
+static void complete_early_data(TLS_IO_INSTANCE* tls_io_instance)
 {
-    int result;
+    tls_io_instance->early_data_open = false;
 
-    if (tls_io == NULL || optionName == NULL)
+    if (tls_io_instance->early_data_send_count == 0)
     {
-        result = __FAILURE__;
+        // the sends all came too late or were too large for early data
+    }
+#ifdef TLSIO_OPENSSL_EARLY_DATA_SUPPORTED
+    else if (SSL_get_early_data_status(tls_io_instance->ssl) == SSL_EARLY_DATA_ACCEPTED)
+    {
+        complete_early_data_sends(tls_io_instance, IO_SEND_OK);
+    }
+#endif
+    else if (uncork_early_data_sends(tls_io_instance) != 0)
+    {
+        LogError("Failed holding the sends rejected as early data.");
+        complete_early_data_sends(tls_io_instance, IO_SEND_ERROR);
+        tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+        indicate_error(tls_io_instance);
     }
     else
     {
-        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+        LogInfo("The server did not take the early data, it is sent again.");
+    }
+}
 
-        if (strcmp(OPTION_TRUSTED_CERT, optionName) == 0)
+// Non-NULL tls_io_instance is guaranteed by callers.
+// Takes the outcome of one SSL_do_handshake step, ssl_error being SSL_ERROR_NONE when the handshake is done and
+// error_code the first error of the error queue of the thread that ran the step.
+static void complete_handshake_step(TLS_IO_INSTANCE* tls_io_instance, int ssl_error, unsigned long error_code)
+{
+    if (ssl_error != SSL_ERROR_NONE)
+    {
+        if (ssl_error != SSL_ERROR_WANT_READ && ssl_error != SSL_ERROR_WANT_WRITE)
         {
-            const char* cert = (const char*)value;
-            size_t len;
+            if (ssl_error == SSL_ERROR_SSL)
+            {
+                LogError("%s", ERR_error_string(error_code, NULL));
+            }
+            else
+            {
+                LogError("SSL handshake failed: %d", ssl_error);
+            }
+            tls_io_instance->tlsio_state = TLSIO_STATE_HANDSHAKE_FAILED;
 
-            if (tls_io_instance->certificate != NULL)
+            if (tls_io_instance->use_session_cache)
             {
-                // Free the memory if it has been previously allocated
-                free(tls_io_instance->certificate);
-                tls_io_instance->certificate = NULL;
+                on_session_cache_handshake_complete(tls_io_instance, false);
+            }
+        }
+        else
+        {
+            if (write_outgoing_bytes(tls_io_instance, NULL, NULL) != 0)
+            {
+                LogError("Error in write_outgoing_bytes.");
+                tls_io_instance->tlsio_state = TLSIO_STATE_HANDSHAKE_FAILED;
+            }
+        }
+    }
+    else
+    {
+        if (tls_io_instance->use_session_cache)
+        {
+            on_session_cache_handshake_complete(tls_io_instance, true);
+        }
+
+#ifdef TLSIO_OPENSSL_KTLS_SUPPORTED
+        if (tls_io_instance->ktls_socket_attached)
+        {
+            LogInfo("Kernel TLS send offload is %s.", BIO_get_ktls_send(SSL_get_wbio(tls_io_instance->ssl)) ? "on" : "not available, records are encrypted by OpenSSL");
+        }
+#endif
+
+        if (tls_io_instance->early_data_open)
+        {
+            // the open was reported when the handshake started
+            complete_early_data(tls_io_instance);
+            if (tls_io_instance->tlsio_state == TLSIO_STATE_IN_HANDSHAKE)
+            {
+                tls_io_instance->tlsio_state = TLSIO_STATE_OPEN;
+                flush_corked_sends_or_fail(tls_io_instance);
+            }
+        }
+        else
+        {
+            tls_io_instance->tlsio_state = TLSIO_STATE_OPEN;
+            indicate_open_complete(tls_io_instance, IO_OPEN_OK);
+        }
+    }
+}
+
+// Whether the session offered for this handshake lets the sends go with the ClientHello
+static bool can_send_early_data(TLS_IO_INSTANCE* tls_io_instance)
+{
+#ifdef TLSIO_OPENSSL_EARLY_DATA_SUPPORTED
+    SSL_SESSION* session;
+
+    return tls_io_instance->use_early_data &&
+        tls_io_instance->session_offered &&
+        !tls_io_instance->ktls_socket_attached &&
+        ((session = SSL_get_session(tls_io_instance->ssl)) != NULL) &&
+        (SSL_SESSION_get_max_early_data(session) > 0);
+#else
+    (void)tls_io_instance;
+    return false;
+#endif
+}
+
+// Writes the sends corked from on_io_open_complete as early data, along with the ClientHello. They are kept until
+// the server tells whether it took them. Sends that do not fit the early data the server allows wait for the handshake.
+static void write_early_data(TLS_IO_INSTANCE* tls_io_instance)
+{
+#ifdef TLSIO_OPENSSL_EARLY_DATA_SUPPORTED
+    size_t written;
+
+    ERR_clear_error();
+    if ((tls_io_instance->corked_byte_count == 0) ||
+        (tls_io_instance->corked_byte_count > SSL_SESSION_get_max_early_data(SSL_get_session(tls_io_instance->ssl))))
+    {
+        // nothing that can go early
+    }
+    else if ((SSL_write_early_data(tls_io_instance->ssl, tls_io_instance->corked_bytes, tls_io_instance->corked_byte_count, &written) != 1) ||
+        (written != tls_io_instance->corked_byte_count))
+    {
+        log_ERR_get_error("SSL_write_early_data error, the sends wait for the handshake.");
+    }
+    else
+    {
+        tls_io_instance->early_data_sends = tls_io_instance->corked_sends;
+        tls_io_instance->early_data_sends_size = tls_io_instance->corked_sends_size;
+        tls_io_instance->early_data_send_count = tls_io_instance->corked_send_count;
+        tls_io_instance->early_data_bytes = tls_io_instance->corked_bytes;
+        tls_io_instance->early_data_bytes_size = tls_io_instance->corked_bytes_size;
+        tls_io_instance->early_data_byte_count = tls_io_instance->corked_byte_count;
+
+        tls_io_instance->corked_sends = NULL;
+        tls_io_instance->corked_sends_size = 0;
+        tls_io_instance->corked_send_count = 0;
+        tls_io_instance->corked_bytes = NULL;
+        tls_io_instance->corked_bytes_size = 0;
+        tls_io_instance->corked_byte_count = 0;
+
+        if (write_outgoing_bytes(tls_io_instance, NULL, NULL) != 0)
+        {
+            LogError("Error in write_outgoing_bytes.");
+            tls_io_instance->tlsio_state = TLSIO_STATE_HANDSHAKE_FAILED;
+        }
+    }
+#else
+    (void)tls_io_instance;
+#endif
+}
+
+// Runs on a worker of the handshake thread pool, which owns the SSL and its BIOs until the job is DONE.
+// The error queue belongs to the worker thread, so its first error is kept for the IO thread.
+static int run_handshake_job(void* context)
+{
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+    int hsret;
+
+    ERR_clear_error();
+    hsret = SSL_do_handshake(tls_io_instance->ssl);
+    tls_io_instance->handshake_job_ssl_error = (hsret == SSL_DO_HANDSHAKE_SUCCESS) ? SSL_ERROR_NONE : SSL_get_error(tls_io_instance->ssl, hsret);
+    tls_io_instance->handshake_job_error = ERR_get_error();
+
+    // a closing IO waits on the state, the wake only touches the word and is harmless once the IO is gone
+    (void)TLS_HANDSHAKE_JOB_COMPARE_EXCHANGE(&tls_io_instance->handshake_job_state, TLS_HANDSHAKE_JOB_RUNNING, TLS_HANDSHAKE_JOB_DONE);
+    sync_wake_by_address(&tls_io_instance->handshake_job_state, true);
+
+    return 0;
+}
+
+// Runs a handshake step on the IO thread
+static void run_handshake_step(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int hsret;
+    // ERR_clear_error must be called before any call that might set an
+    // SSL_get_error result
+    ERR_clear_error();
+    hsret = ssl_do_handshake(tls_io_instance);
+    if (hsret != SSL_DO_HANDSHAKE_SUCCESS)
+    {
+        int ssl_err = SSL_get_error(tls_io_instance->ssl, hsret);
+        complete_handshake_step(tls_io_instance, ssl_err, (ssl_err == SSL_ERROR_SSL) ? ERR_get_error() : 0);
+    }
+    else
+    {
+        complete_handshake_step(tls_io_instance, SSL_ERROR_NONE, 0);
+    }
+}
+
+// Non-NULL tls_io_instance is guaranteed by callers.
+// We are in TLSIO_STATE_IN_HANDSHAKE when entering this method.
+static void send_handshake_bytes(TLS_IO_INSTANCE* tls_io_instance)
+{
+    if (tls_io_instance->handshake_job_state != TLS_HANDSHAKE_JOB_NONE)
+    {
+        // the bytes received meanwhile are held and get their step once the running one is done
+    }
+    else if ((tls_io_instance->handshake_threadpool == NULL) || tls_io_instance->ktls_socket_attached)
+    {
+        run_handshake_step(tls_io_instance);
+    }
+    else
+    {
+        // dowork_tls completes the step once the job is DONE
+        tls_io_instance->handshake_job_state = TLS_HANDSHAKE_JOB_RUNNING;
+        if (threadpool_schedule_work(tls_io_instance->handshake_threadpool, run_handshake_job, tls_io_instance, NULL, NULL) != 0)
+        {
+            LogError("Failed scheduling the handshake step, running it on the IO thread.");
+            tls_io_instance->handshake_job_state = TLS_HANDSHAKE_JOB_NONE;
+            run_handshake_step(tls_io_instance);
+        }
+    }
+}
+
+// Keeps the bytes the underlying IO received while a handshake step runs on the pool, in_bio being the worker's
+static int hold_handshake_bytes(TLS_IO_INSTANCE* tls_io_instance, const unsigned char* buffer, size_t size)
+{
+    int result;
+
+    if (size > tls_io_instance->handshake_held_bytes_size - tls_io_instance->handshake_held_byte_count)
+    {
+        size_t new_size = tls_io_instance->handshake_held_byte_count + size;
+        unsigned char* new_bytes = (unsigned char*)realloc(tls_io_instance->handshake_held_bytes, new_size);
+        if (new_bytes == NULL)
+        {
+            LogError("Failed holding %lu bytes received during the handshake.", (unsigned long)size);
+            result = __FAILURE__;
+        }
+        else
+        {
+            tls_io_instance->handshake_held_bytes = new_bytes;
+            tls_io_instance->handshake_held_bytes_size = new_size;
+            result = 0;
+        }
+    }
+    else
+    {
+        result = 0;
+    }
+
+    if (result == 0)
+    {
+        (void)memcpy(tls_io_instance->handshake_held_bytes + tls_io_instance->handshake_held_byte_count, buffer, size);
+        tls_io_instance->handshake_held_byte_count += size;
+    }
+
+    return result;
+}
+
+// Blocks until the pool is done with the SSL, which the IO is about to free or replace
+static void wait_for_handshake_job(TLS_IO_INSTANCE* tls_io_instance)
+{
+    while (TLS_HANDSHAKE_JOB_GET_STATE(&tls_io_instance->handshake_job_state) == TLS_HANDSHAKE_JOB_RUNNING)
+    {
+        if (sync_wait_on_address(&tls_io_instance->handshake_job_state, TLS_HANDSHAKE_JOB_RUNNING, 0) == SYNC_WAIT_ERROR)
+        {
+            LogError("Failed waiting for the handshake step.");
+        }
+    }
+
+    tls_io_instance->handshake_job_state = TLS_HANDSHAKE_JOB_NONE;
+    tls_io_instance->handshake_held_byte_count = 0;
+}
+
+static void release_trusted_store(TLS_TRUSTED_STORE* trusted_store)
+{
+    if (trusted_store == NULL)
+    {
+        // Nothing to release, the SSL_CTX did not use TrustedCertsFile
+    }
+    else if (Lock(trusted_store_cache_lock) != LOCK_OK)
+    {
+        // Leaks the reference rather than freeing a store other SSL_CTXs may still use
+        LogError("Failed to lock the trusted certificates cache.");
+    }
+    else
+    {
+        if (--trusted_store->ref_count == 0)
+        {
+            TLS_TRUSTED_STORE** entry = &trusted_store_cache_entries;
+
+            while ((*entry != NULL) && (*entry != trusted_store))
+            {
+                entry = &(*entry)->next;
+            }
+
+            if (*entry != NULL)
+            {
+                *entry = trusted_store->next;
+            }
+
+            X509_STORE_free(trusted_store->store);
+            free(trusted_store->path);
+            free(trusted_store);
+        }
+
+        (void)Unlock(trusted_store_cache_lock);
+    }
+}
+
+static void free_context_cache_entry(TLS_CONTEXT_CACHE_ENTRY* entry)
+{
+    SSL_CTX_free(entry->ssl_context);
+    release_trusted_store(entry->trusted_store);
+    release_shared_string(entry->certificate);
+    free(entry->trusted_certs_file);
+    free(entry->cipher_list);
+    free(entry->groups);
+    free(entry->signature_algorithms);
+    release_shared_string(entry->x509_certificate);
+    release_shared_string(entry->x509_private_key);
+    free(entry->engine_id);
+    free(entry->provider_name);
+    free(entry);
+}
+
+static void release_ssl_context(TLS_IO_INSTANCE* tls_io_instance)
+{
+    if (!tls_io_instance->ssl_context_shared)
+    {
+        SSL_CTX_free(tls_io_instance->ssl_context);
+        release_trusted_store(tls_io_instance->trusted_store);
+        tls_io_instance->trusted_store = NULL;
+    }
+    else if (Lock(context_cache_lock) != LOCK_OK)
+    {
+        // Leaks the reference rather than freeing a context other instances may still use
+        LogError("Failed to lock the TLS context cache.");
+    }
+    else
+    {
+        TLS_CONTEXT_CACHE_ENTRY** entry = &context_cache_entries;
+
+        while ((*entry != NULL) && ((*entry)->ssl_context != tls_io_instance->ssl_context))
+        {
+            entry = &(*entry)->next;
+        }
+
+        if (*entry == NULL)
+        {
+            LogError("The shared TLS context is not in the cache.");
+        }
+        else if (--(*entry)->ref_count == 0)
+        {
+            TLS_CONTEXT_CACHE_ENTRY* unused_entry = *entry;
+            *entry = unused_entry->next;
+            free_context_cache_entry(unused_entry);
+        }
+
+        (void)Unlock(context_cache_lock);
+    }
+
+    tls_io_instance->ssl_context = NULL;
+    tls_io_instance->ssl_context_shared = false;
+}
+
+static void close_openssl_instance(TLS_IO_INSTANCE* tls_io_instance)
+{
+    wait_for_handshake_job(tls_io_instance);
+    if (tls_io_instance->handshake_held_bytes != NULL)
+    {
+        free(tls_io_instance->handshake_held_bytes);
+        tls_io_instance->handshake_held_bytes = NULL;
+        tls_io_instance->handshake_held_bytes_size = 0;
+    }
+    tls_io_instance->early_data_open = false;
+    complete_early_data_sends(tls_io_instance, IO_SEND_CANCELLED);
+    cancel_corked_sends(tls_io_instance);
+    if (tls_io_instance->corked_bytes != NULL)
+    {
+        free(tls_io_instance->corked_bytes);
+        tls_io_instance->corked_bytes = NULL;
+        tls_io_instance->corked_bytes_size = 0;
+    }
+    cancel_ktls_pending_sends(tls_io_instance);
+    tls_io_instance->ktls_socket_attached = false;
+    tls_io_instance->lent_received_bytes = NULL;
+    tls_io_instance->lent_received_bytes_size = 0;
+
+    if (tls_io_instance->ssl != NULL)
+    {
+        if (tls_io_instance->use_session_cache)
+        {
+            // No close_notify is ever sent, which would make SSL_free mark the session as not resumable.
+            // The session cache drops sessions on handshake failures by itself.
+            SSL_set_shutdown(tls_io_instance->ssl, SSL_get_shutdown(tls_io_instance->ssl) | SSL_SENT_SHUTDOWN);
+        }
+
+        SSL_free(tls_io_instance->ssl);
+        tls_io_instance->ssl = NULL;
+    }
+    if (tls_io_instance->ssl_context != NULL)
+    {
+        release_ssl_context(tls_io_instance);
+    }
+    if (tls_io_instance->send_buffer != NULL)
+    {
+        free(tls_io_instance->send_buffer);
+        tls_io_instance->send_buffer = NULL;
+        tls_io_instance->send_buffer_size = 0;
+    }
+    if (tls_io_instance->received_bytes != NULL)
+    {
+        // bytes still held for coalescing are dropped with the connection
+        free(tls_io_instance->received_bytes);
+        tls_io_instance->received_bytes = NULL;
+        tls_io_instance->received_bytes_size = 0;
+        tls_io_instance->received_byte_count = 0;
+    }
+}
+
+static void on_underlying_io_close_complete(void* context)
+{
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+
+    switch (tls_io_instance->tlsio_state)
+    {
+    default:
+    case TLSIO_STATE_NOT_OPEN:
+    case TLSIO_STATE_OPEN:
+    case TLSIO_STATE_IN_HANDSHAKE:
+    case TLSIO_STATE_HANDSHAKE_FAILED:
+    case TLSIO_STATE_ERROR:
+        break;
+
+    case TLSIO_STATE_OPENING_UNDERLYING_IO:
+        tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+        indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
+        break;
+
+    case TLSIO_STATE_CLOSING:
+        tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+
+        if (tls_io_instance->on_io_close_complete != NULL)
+        {
+            tls_io_instance->on_io_close_complete(tls_io_instance->on_io_close_complete_context);
+        }
+        break;
+    }
+
+    close_openssl_instance(tls_io_instance);
+}
+
+static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+
+    if (tls_io_instance->tlsio_state == TLSIO_STATE_OPENING_UNDERLYING_IO)
+    {
+        if (open_result == IO_OPEN_OK)
+        {
+            tls_io_instance->tlsio_state = TLSIO_STATE_IN_HANDSHAKE;
+
+            if (tls_io_instance->use_ktls)
+            {
+                attach_ktls_socket(tls_io_instance);
+            }
+
+            if (can_send_early_data(tls_io_instance))
+            {
+                // The open is reported before the handshake, so that the sends made from the callback go out as
+                // early data. The sends made later are held until the handshake is done.
+                tls_io_instance->early_data_open = true;
+                indicate_open_complete(tls_io_instance, IO_OPEN_OK);
+                if (tls_io_instance->tlsio_state == TLSIO_STATE_IN_HANDSHAKE)
+                {
+                    write_early_data(tls_io_instance);
+                }
+            }
+
+            // Begin the handshake process here. It continues in on_underlying_io_bytes_received
+            if (tls_io_instance->tlsio_state == TLSIO_STATE_IN_HANDSHAKE)
+            {
+                send_handshake_bytes(tls_io_instance);
+            }
+        }
+        else
+        {
+            tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+            indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
+            LogError("Invalid tlsio_state. Expected state is TLSIO_STATE_OPENING_UNDERLYING_IO.");
+        }
+    }
+}
+
+static void on_underlying_io_error(void* context)
+{
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+
+    switch (tls_io_instance->tlsio_state)
+    {
+    default:
+        break;
+
+    case TLSIO_STATE_OPENING_UNDERLYING_IO:
+    case TLSIO_STATE_IN_HANDSHAKE:
+        if (tls_io_instance->early_data_open)
+        {
+            // the open has been reported already
+            tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+            indicate_error(tls_io_instance);
+        }
+        else
+        {
+            tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+            indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
+        }
+        break;
+
+    case TLSIO_STATE_OPEN:
+        indicate_error(tls_io_instance);
+        break;
+    }
+}
+
+static void indicate_received_bytes(TLS_IO_INSTANCE* tls_io_instance, const unsigned char* buffer, size_t size)
+{
+    if (tls_io_instance->on_bytes_received == NULL)
+    {
+        LogError("NULL on_bytes_received.");
+    }
+    else
+    {
+        tls_io_instance->stats.bytes_received += size;
+        tls_io_instance->stats.callback_count++;
+        tls_io_instance->on_bytes_received(tls_io_instance->on_bytes_received_context, buffer, size);
+    }
+}
+
+// Makes room for one more read_chunk_size read after the bytes held for coalescing
+static int reserve_received_bytes(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result;
+    size_t needed = tls_io_instance->received_byte_count + tls_io_instance->read_chunk_size;
+
+    if (needed <= tls_io_instance->received_bytes_size)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t new_size = tls_io_instance->received_bytes_size * 2;
+        unsigned char* new_received_bytes;
+
+        if (new_size < needed)
+        {
+            new_size = needed;
+        }
+
+        new_received_bytes = (unsigned char*)realloc(tls_io_instance->received_bytes, new_size);
+        if (new_received_bytes == NULL)
+        {
+            LogError("Failed growing the receive buffer to %lu bytes.", (unsigned long)new_size);
+            result = __FAILURE__;
+        }
+        else
+        {
+            tls_io_instance->received_bytes = new_received_bytes;
+            tls_io_instance->received_bytes_size = new_size;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void indicate_coalesced_received_bytes(TLS_IO_INSTANCE* tls_io_instance)
+{
+    if (tls_io_instance->received_byte_count > 0)
+    {
+        size_t received_byte_count = tls_io_instance->received_byte_count;
+        tls_io_instance->received_byte_count = 0;
+        indicate_received_bytes(tls_io_instance, tls_io_instance->received_bytes, received_byte_count);
+    }
+}
+
+static int decode_ssl_received_bytes(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result = 0;
+    unsigned char buffer[DEFAULT_READ_CHUNK_SIZE];
+
+    int rcv_bytes = 1;
+
+    while (rcv_bytes > 0)
+    {
+        unsigned char* read_buffer;
+        size_t read_size = tls_io_instance->read_chunk_size;
+        bool is_lent = false;
+
+        if (tls_io_instance->ssl == NULL)
+        {
+            LogError("SSL channel closed in decode_ssl_received_bytes.");
+            result = __FAILURE__;
+            return result;
+        }
+
+        if ((tls_io_instance->lent_received_bytes != NULL) && !tls_io_instance->coalesce_received_bytes)
+        {
+            // lent for this read only, the layer above lends it again once it took the bytes
+            read_buffer = tls_io_instance->lent_received_bytes;
+            read_size = tls_io_instance->lent_received_bytes_size;
+            tls_io_instance->lent_received_bytes = NULL;
+            tls_io_instance->lent_received_bytes_size = 0;
+            is_lent = true;
+        }
+        else if ((tls_io_instance->read_chunk_size == DEFAULT_READ_CHUNK_SIZE) && !tls_io_instance->coalesce_received_bytes)
+        {
+            read_buffer = buffer;
+        }
+        else if (reserve_received_bytes(tls_io_instance) != 0)
+        {
+            result = __FAILURE__;
+            break;
+        }
+        else
+        {
+            // when not coalescing received_byte_count is always 0
+            read_buffer = tls_io_instance->received_bytes + tls_io_instance->received_byte_count;
+        }
+
+        rcv_bytes = ssl_read(tls_io_instance, read_buffer, read_size);
+        if ((rcv_bytes <= 0) && is_lent)
+        {
+            // nothing was read into the lent memory, it stays lent for the next read
+            tls_io_instance->lent_received_bytes = read_buffer;
+            tls_io_instance->lent_received_bytes_size = read_size;
+        }
+        else if (rcv_bytes > 0)
+        {
+            if (tls_io_instance->coalesce_received_bytes)
+            {
+                // indicated once the underlying IO has been pumped, at the end of tlsio_openssl_dowork
+                tls_io_instance->received_byte_count += (size_t)rcv_bytes;
+            }
+            else
+            {
+                indicate_received_bytes(tls_io_instance, read_buffer, (size_t)rcv_bytes);
+            }
+        }
+    }
+
+    return result;
+}
+
+static void on_underlying_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+
+    if (tls_io_instance->handshake_job_state != TLS_HANDSHAKE_JOB_NONE)
+    {
+        if (hold_handshake_bytes(tls_io_instance, buffer, size) != 0)
+        {
+            tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+            indicate_error(tls_io_instance);
+        }
+    }
+    else if (BIO_write(tls_io_instance->in_bio, buffer, (int)size) != (int)size)
+    {
+        tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+        indicate_error(tls_io_instance);
+        log_ERR_get_error("Error in BIO_write.");
+    }
+    else
+    {
+        switch (tls_io_instance->tlsio_state)
+        {
+        default:
+            break;
+
+        case TLSIO_STATE_IN_HANDSHAKE:
+            send_handshake_bytes(tls_io_instance);
+            break;
+
+        case TLSIO_STATE_OPEN:
+            if (decode_ssl_received_bytes(tls_io_instance) != 0)
+            {
+                tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+                indicate_error(tls_io_instance);
+                LogError("Error in decode_ssl_received_bytes.");
+            }
+            break;
+        }
+    }
+}
+
+// Takes the result of a handshake step the pool is done with, on the IO thread, which owns the SSL and its BIOs again.
+// The bytes held meanwhile are then fed to OpenSSL as on_underlying_io_bytes_received would have.
+static void complete_handshake_job(TLS_IO_INSTANCE* tls_io_instance)
+{
+    size_t held_byte_count = tls_io_instance->handshake_held_byte_count;
+
+    tls_io_instance->handshake_job_state = TLS_HANDSHAKE_JOB_NONE;
+    tls_io_instance->handshake_held_byte_count = 0;
+
+    if (tls_io_instance->tlsio_state != TLSIO_STATE_IN_HANDSHAKE)
+    {
+        // the open failed meanwhile, the result is of no use anymore
+    }
+    else if ((held_byte_count > 0) &&
+        (BIO_write(tls_io_instance->in_bio, tls_io_instance->handshake_held_bytes, (int)held_byte_count) != (int)held_byte_count))
+    {
+        tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+        indicate_error(tls_io_instance);
+        log_ERR_get_error("Error in BIO_write.");
+    }
+    else
+    {
+        complete_handshake_step(tls_io_instance, tls_io_instance->handshake_job_ssl_error, tls_io_instance->handshake_job_error);
+
+        if (held_byte_count == 0)
+        {
+            // nothing came in while the step ran
+        }
+        else if (tls_io_instance->tlsio_state == TLSIO_STATE_IN_HANDSHAKE)
+        {
+            send_handshake_bytes(tls_io_instance);
+        }
+        else if ((tls_io_instance->tlsio_state == TLSIO_STATE_OPEN) &&
+            (decode_ssl_received_bytes(tls_io_instance) != 0))
+        {
+            tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+            indicate_error(tls_io_instance);
+            LogError("Error in decode_ssl_received_bytes.");
+        }
+    }
+}
+
+static int add_certificates_from_bio(X509_STORE* cert_store, BIO* cert_bio)
+{
+    int result;
+    X509* certificate;
+
+    while ((certificate = PEM_read_bio_X509(cert_bio, NULL, NULL, NULL)) != NULL)
+    {
+        if (!X509_STORE_add_cert(cert_store, certificate))
+        {
+            X509_free(certificate);
+            log_ERR_get_error("failure in X509_STORE_add_cert");
+            break;
+        }
+        X509_free(certificate);
+    }
+    if (certificate == NULL)
+    {
+        result = 0;/*all is fine*/
+    }
+    else
+    {
+        /*previous while loop terminated unfortunately*/
+        result = __FAILURE__;
+    }
+
+    return result;
+}
+
+static int add_certificate_to_store(SSL_CTX* ssl_context, const char* certValue)
+{
+    int result = 0;
+
+    if (certValue != NULL)
+    {
+        X509_STORE* cert_store = SSL_CTX_get_cert_store(ssl_context);
+        if (cert_store == NULL)
+        {
+            log_ERR_get_error("failure in SSL_CTX_get_cert_store.");
+            result = __FAILURE__;
+        }
+        else
+        {
+#if (OPENSSL_VERSION_NUMBER >= 0x10100000L) && (OPENSSL_VERSION_NUMBER < 0x20000000L)
+            const BIO_METHOD* bio_method;
+#else
+            BIO_METHOD* bio_method;
+#endif
+            bio_method = BIO_s_mem();
+            if (bio_method == NULL)
+            {
+                log_ERR_get_error("failure in BIO_s_mem");
+                result = __FAILURE__;
+            }
+            else
+            {
+                BIO* cert_memory_bio = BIO_new(bio_method);
+
+                if (cert_memory_bio == NULL)
+                {
+                    log_ERR_get_error("failure in BIO_new");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    int puts_result = BIO_puts(cert_memory_bio, certValue);
+                    if (puts_result < 0)
+                    {
+                        log_ERR_get_error("failure in BIO_puts");
+                        result = __FAILURE__;
+                    }
+                    else
+                    {
+                        if ((size_t)puts_result != strlen(certValue))
+                        {
+                            log_ERR_get_error("mismatching legths");
+                            result = __FAILURE__;
+                        }
+                        else
+                        {
+                            result = add_certificates_from_bio(cert_store, cert_memory_bio);
+                        }
+                    }
+                    BIO_free(cert_memory_bio);
+                }
+            }
+        }
+    }
+    return result;
+}
+
+#ifdef TLSIO_OPENSSL_SHARED_STORE_SUPPORTED
+// The bundle is parsed straight from the file pages, it is never copied to the heap
+static int load_trusted_certs_file(X509_STORE* cert_store, const char* path)
+{
+    int result;
+#ifdef TLSIO_OPENSSL_MMAP_SUPPORTED
+    int fd = open(path, O_RDONLY);
+    struct stat file_stat;
+
+    if (fd < 0)
+    {
+        LogError("unable to open the trusted certificates file %s, errno=%d", path, errno);
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (fstat(fd, &file_stat) != 0)
+        {
+            LogError("unable to stat the trusted certificates file %s, errno=%d", path, errno);
+            result = __FAILURE__;
+        }
+        else if ((file_stat.st_size <= 0) || ((uintmax_t)file_stat.st_size > INT_MAX))
+        {
+            LogError("unsupported size %jd of the trusted certificates file %s", (intmax_t)file_stat.st_size, path);
+            result = __FAILURE__;
+        }
+        else
+        {
+            void* mapped_file = mmap(NULL, (size_t)file_stat.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+            if (mapped_file == MAP_FAILED)
+            {
+                LogError("unable to map the trusted certificates file %s, errno=%d", path, errno);
+                result = __FAILURE__;
+            }
+            else
+            {
+                BIO* cert_bio = BIO_new_mem_buf(mapped_file, (int)file_stat.st_size);
+
+                if (cert_bio == NULL)
+                {
+                    log_ERR_get_error("failure in BIO_new_mem_buf");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = add_certificates_from_bio(cert_store, cert_bio);
+                    BIO_free(cert_bio);
+                }
+
+                (void)munmap(mapped_file, (size_t)file_stat.st_size);
+            }
+        }
+
+        (void)close(fd);
+    }
+#else
+    BIO* cert_bio = BIO_new_file(path, "r");
+
+    if (cert_bio == NULL)
+    {
+        log_ERR_get_error("unable to open the trusted certificates file");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = add_certificates_from_bio(cert_store, cert_bio);
+        BIO_free(cert_bio);
+    }
+#endif
+
+    if (result == 0)
+    {
+        // The loop reading the certificates stops on the PEM_R_NO_START_LINE error of the end of the file
+        ERR_clear_error();
+
+        if (sk_X509_OBJECT_num(X509_STORE_get0_objects(cert_store)) == 0)
+        {
+            LogError("no certificate found in the trusted certificates file %s", path);
+            result = __FAILURE__;
+        }
+    }
+
+    return result;
+}
+
+static TLS_TRUSTED_STORE* create_trusted_store(const char* path)
+{
+    TLS_TRUSTED_STORE* result;
+
+    if ((result = (TLS_TRUSTED_STORE*)malloc(sizeof(TLS_TRUSTED_STORE))) == NULL)
+    {
+        LogError("Failed allocating the trusted certificates cache entry.");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(TLS_TRUSTED_STORE));
+
+        if (mallocAndStrcpy_s(&result->path, path) != 0)
+        {
+            LogError("Failed copying the path of the trusted certificates file.");
+            free(result);
+            result = NULL;
+        }
+        else if ((result->store = X509_STORE_new()) == NULL)
+        {
+            log_ERR_get_error("failure in X509_STORE_new");
+            free(result->path);
+            free(result);
+            result = NULL;
+        }
+        else if (load_trusted_certs_file(result->store, result->path) != 0)
+        {
+            X509_STORE_free(result->store);
+            free(result->path);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            // Once shared the store must not change, so it gets the default locations of SSL_CTX_set_default_verify_paths now
+            if (X509_STORE_set_default_paths(result->store) != 1)
+            {
+                LogInfo("WARNING: Unable to specify the default location for CA certificates on this platform.");
+            }
+            result->ref_count = 1;
+        }
+    }
+
+    return result;
+}
+
+static TLS_TRUSTED_STORE* acquire_trusted_store(const char* path)
+{
+    TLS_TRUSTED_STORE* result;
+
+    if (trusted_store_cache_lock == NULL)
+    {
+        LogError("TrustedCertsFile is not available, the trusted certificates cache failed to initialize.");
+        result = NULL;
+    }
+    else if (Lock(trusted_store_cache_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the trusted certificates cache.");
+        result = NULL;
+    }
+    else
+    {
+        result = trusted_store_cache_entries;
+        while ((result != NULL) && (strcmp(result->path, path) != 0))
+        {
+            result = result->next;
+        }
+
+        if (result != NULL)
+        {
+            result->ref_count++;
+        }
+        else if ((result = create_trusted_store(path)) != NULL)
+        {
+            result->next = trusted_store_cache_entries;
+            trusted_store_cache_entries = result;
+        }
+
+        (void)Unlock(trusted_store_cache_lock);
+    }
+
+    return result;
+}
+#endif
+
+static int add_trusted_certificates(TLS_IO_INSTANCE* tlsInstance, SSL_CTX* ssl_context, TLS_TRUSTED_STORE** trusted_store)
+{
+    int result;
+
+    if (tlsInstance->trusted_certs_file == NULL)
+    {
+        result = add_certificate_to_store(ssl_context, get_shared_string(tlsInstance->certificate));
+    }
+    else
+    {
+#ifdef TLSIO_OPENSSL_SHARED_STORE_SUPPORTED
+        if ((*trusted_store = acquire_trusted_store(tlsInstance->trusted_certs_file)) == NULL)
+        {
+            result = __FAILURE__;
+        }
+        else if (X509_STORE_up_ref((*trusted_store)->store) != 1)
+        {
+            log_ERR_get_error("failure in X509_STORE_up_ref");
+            result = __FAILURE__;
+        }
+        else
+        {
+            // The SSL_CTX takes over the reference, and frees the store it was created with
+            SSL_CTX_set_cert_store(ssl_context, (*trusted_store)->store);
+            result = 0;
+        }
+#else
+        LogError("TrustedCertsFile needs OpenSSL 1.1.0 or later");
+        result = __FAILURE__;
+#endif
+    }
+
+    return result;
+}
+
+static int add_x509_credentials(TLS_IO_INSTANCE* tlsInstance, SSL_CTX* ssl_context)
+{
+    int result;
+
+    if (tlsInstance->x509_private_key_type == KEY_TYPE_ENGINE)
+    {
+#ifdef X509_OPENSSL_ENGINES_SUPPORTED
+        if (tlsInstance->engine == NULL)
+        {
+            LogError("the x509 private key is an engine key but no engine was set");
+            result = __FAILURE__;
+        }
+        else if (x509_openssl_add_engine_credentials(ssl_context, get_shared_string(tlsInstance->x509_certificate), tlsInstance->engine, get_shared_string(tlsInstance->x509_private_key)) != 0)
+        {
+            LogError("unable to add the x509 engine credentials");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+#else
+        LogError("the x509 private key is an engine key but this OpenSSL has no engines, load it through a Provider instead");
+        result = __FAILURE__;
+#endif
+    }
+    else if (tlsInstance->x509_private_key_type == KEY_TYPE_URI)
+    {
+        if (x509_openssl_add_uri_credentials(ssl_context, get_shared_string(tlsInstance->x509_certificate), get_shared_string(tlsInstance->x509_private_key)) != 0)
+        {
+            LogError("unable to add the x509 URI credentials");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+    // The parsed credentials are kept until the instance is destroyed, so that reopening it does not decode them again
+    else if ((tlsInstance->x509_credentials == NULL) &&
+        ((tlsInstance->x509_credentials = x509_openssl_credentials_acquire(get_shared_string(tlsInstance->x509_certificate), get_shared_string(tlsInstance->x509_private_key))) == NULL))
+    {
+        LogError("unable to parse the x509 credentials");
+        result = __FAILURE__;
+    }
+    else if (x509_openssl_add_parsed_credentials(ssl_context, tlsInstance->x509_credentials) != 0)
+    {
+        LogError("unable to add the x509 credentials");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static int get_group_nid(uint16_t group_id)
+{
+    int result;
+
+    switch (group_id)
+    {
+        case TLSIO_GROUP_SECP256R1:
+            result = NID_X9_62_prime256v1;
+            break;
+        case TLSIO_GROUP_SECP384R1:
+            result = NID_secp384r1;
+            break;
+        case TLSIO_GROUP_SECP521R1:
+            result = NID_secp521r1;
+            break;
+#ifdef NID_X25519
+        case TLSIO_GROUP_X25519:
+            result = NID_X25519;
+            break;
+#endif
+#ifdef NID_X448
+        case TLSIO_GROUP_X448:
+            result = NID_X448;
+            break;
+#endif
+#if (OPENSSL_VERSION_NUMBER >= 0x30000000L)
+        // The finite field groups are only negotiated by OpenSSL 3
+        case TLSIO_GROUP_FFDHE2048:
+            result = NID_ffdhe2048;
+            break;
+        case TLSIO_GROUP_FFDHE3072:
+            result = NID_ffdhe3072;
+            break;
+        case TLSIO_GROUP_FFDHE4096:
+            result = NID_ffdhe4096;
+            break;
+#endif
+        default:
+            result = NID_undef;
+            break;
+    }
+
+    return result;
+}
+
+static int set_key_exchange_groups(TLS_IO_INSTANCE* tlsInstance, SSL_CTX* ssl_context)
+{
+    int result;
+    int group_nids[TLSIO_OPTIONS_MAX_LIST_COUNT];
+    size_t i;
+
+    for (i = 0; i < tlsInstance->tls_options.group_count; i++)
+    {
+        if ((group_nids[i] = get_group_nid(tlsInstance->tls_options.group_ids[i])) == NID_undef)
+        {
+            break;
+        }
+    }
+
+    if (i < tlsInstance->tls_options.group_count)
+    {
+        LogError("The group %u of tls_groups is not supported by this OpenSSL.", (unsigned int)tlsInstance->tls_options.group_ids[i]);
+        result = __FAILURE__;
+    }
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L)
+    else if (SSL_CTX_set1_groups(ssl_context, group_nids, (int)tlsInstance->tls_options.group_count) != 1)
+#else
+    else if (SSL_CTX_set1_curves(ssl_context, group_nids, (int)tlsInstance->tls_options.group_count) != 1)
+#endif
+    {
+        log_ERR_get_error("Failed setting the groups.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static int set_signature_algorithms(TLS_IO_INSTANCE* tlsInstance, SSL_CTX* ssl_context)
+{
+    int result;
+
+#ifdef TLSIO_OPENSSL_SIGALGS_LIST_SUPPORTED
+    // tlsio_options only accepts the RFC 8446 names, which are also the names OpenSSL uses
+    if (SSL_CTX_set1_sigalgs_list(ssl_context, tlsInstance->tls_options.signature_algorithms) != 1)
+    {
+        log_ERR_get_error("Failed setting the signature algorithms.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+#else
+    (void)ssl_context;
+    LogError("tls_signature_algorithms %s needs OpenSSL 1.1.1 or later.", tlsInstance->tls_options.signature_algorithms);
+    result = __FAILURE__;
+#endif
+
+    return result;
+}
+
+// trusted_store receives the store of TrustedCertsFile, which the owner of the SSL_CTX releases after freeing it
+static SSL_CTX* create_ssl_context(TLS_IO_INSTANCE* tlsInstance, TLS_TRUSTED_STORE** trusted_store)
+{
+    SSL_CTX* result;
+
+    const SSL_METHOD* method = NULL;
+
+    *trusted_store = NULL;
+
+#if (OPENSSL_VERSION_NUMBER < 0x10100000L)
+    if (tlsInstance->tls_version == VERSION_1_2)
+    {
+        method = TLSv1_2_method();
+    }
+    else if (tlsInstance->tls_version == VERSION_1_1)
+    {
+        method = TLSv1_1_method();
+    }
+    else
+    {
+        method = TLSv1_method();
+    }
+#else
+    // tls_version is the lowest version offered, TLS 1.3 is negotiated where both ends have it
+    int min_version = (tlsInstance->tls_version == VERSION_1_2) ? TLS1_2_VERSION :
+        (tlsInstance->tls_version == VERSION_1_1) ? TLS1_1_VERSION : TLS1_VERSION;
+
+    {
+        method = TLS_method();
+    }
+#endif
+
+#ifdef TLSIO_OPENSSL_PROVIDERS_SUPPORTED
+    if (tlsInstance->provider_name != NULL)
+    {
+        // The algorithms of the provider are preferred, the default provider still has the ones it lacks
+        size_t properties_length = strlen("?provider=") + strlen(tlsInstance->provider_name) + 1;
+        char* properties = (char*)malloc(properties_length);
+        if (properties == NULL)
+        {
+            LogError("Failed allocating the provider properties.");
+            result = NULL;
+        }
+        else
+        {
+            (void)snprintf(properties, properties_length, "?provider=%s", tlsInstance->provider_name);
+            result = SSL_CTX_new_ex(NULL, properties, method);
+            free(properties);
+        }
+    }
+    else
+#endif
+    {
+        result = SSL_CTX_new(method);
+    }
+
+    if (result == NULL)
+    {
+        log_ERR_get_error("Failed allocating OpenSSL context.");
+    }
+#if (OPENSSL_VERSION_NUMBER >= 0x10100000L)
+    else if (SSL_CTX_set_min_proto_version(result, min_version) != 1)
+    {
+        SSL_CTX_free(result);
+        result = NULL;
+        log_ERR_get_error("unable to set the minimum TLS version.");
+    }
+#endif
+    else if ((tlsInstance->cipher_list != NULL) &&
+             (SSL_CTX_set_cipher_list(result, tlsInstance->cipher_list)) != 1)
+    {
+        SSL_CTX_free(result);
+        result = NULL;
+        log_ERR_get_error("unable to set cipher list.");
+    }
+    else if ((tlsInstance->tls_options.group_count != 0) && (set_key_exchange_groups(tlsInstance, result) != 0))
+    {
+        SSL_CTX_free(result);
+        result = NULL;
+        LogError("unable to set the key exchange groups.");
+    }
+    else if ((tlsInstance->tls_options.signature_algorithm_count != 0) && (set_signature_algorithms(tlsInstance, result) != 0))
+    {
+        SSL_CTX_free(result);
+        result = NULL;
+        LogError("unable to set the signature algorithms.");
+    }
+    else if (add_trusted_certificates(tlsInstance, result, trusted_store) != 0)
+    {
+        SSL_CTX_free(result);
+        result = NULL;
+        log_ERR_get_error("unable to add the trusted certificates.");
+    }
+    /*x509 authentication can only be build before underlying connection is realized*/
+    else if (
+        (tlsInstance->x509_certificate != NULL) &&
+        (tlsInstance->x509_private_key != NULL) &&
+        (add_x509_credentials(tlsInstance, result) != 0)
+        )
+    {
+        SSL_CTX_free(result);
+        result = NULL;
+        log_ERR_get_error("unable to use x509 authentication");
+    }
+    else
+    {
+        SSL_CTX_set_cert_verify_callback(result, tlsInstance->tls_validation_callback, tlsInstance->tls_validation_callback_data);
+        SSL_CTX_set_verify(result, SSL_VERIFY_PEER, NULL);
+
+        if (tlsInstance->use_session_cache)
+        {
+            // OpenSSL only reports the sessions, the process wide cache keeps them across SSL_CTXs
+            SSL_CTX_set_session_cache_mode(result, SSL_SESS_CACHE_CLIENT | SSL_SESS_CACHE_NO_INTERNAL_STORE);
+            SSL_CTX_sess_set_new_cb(result, on_new_session);
+            (void)SSL_CTX_clear_options(result, SSL_OP_NO_TICKET);
+        }
+
+        // Specifies that the default locations for which CA certificates are loaded should be used.
+        // A store of TrustedCertsFile has them already and is shared, so it is left as is.
+        if ((*trusted_store == NULL) && (SSL_CTX_set_default_verify_paths(result) != 1))
+        {
+            // This is only a warning to the user. They can still specify the certificate via SetOption.
+            LogInfo("WARNING: Unable to specify the default location for CA certificates on this platform.");
+        }
+    }
+
+    if ((result == NULL) && (*trusted_store != NULL))
+    {
+        release_trusted_store(*trusted_store);
+        *trusted_store = NULL;
+    }
+
+    return result;
+}
+
+// Must be called with context_cache_lock held
+static TLS_CONTEXT_CACHE_ENTRY* find_context_cache_entry(TLS_IO_INSTANCE* tls_io_instance)
+{
+    TLS_CONTEXT_CACHE_ENTRY* entry = context_cache_entries;
+
+    while ((entry != NULL) &&
+        ((entry->tls_version != tls_io_instance->tls_version) ||
+         (entry->use_session_cache != tls_io_instance->use_session_cache) ||
+         (entry->tls_validation_callback != tls_io_instance->tls_validation_callback) ||
+         (entry->tls_validation_callback_data != tls_io_instance->tls_validation_callback_data) ||
+         (!is_same_string(entry->cipher_list, tls_io_instance->cipher_list)) ||
+         (!is_same_string(entry->groups, tls_io_instance->tls_options.groups)) ||
+         (!is_same_string(entry->signature_algorithms, tls_io_instance->tls_options.signature_algorithms)) ||
+         (!is_same_shared_string(entry->x509_certificate, tls_io_instance->x509_certificate)) ||
+         (!is_same_shared_string(entry->x509_private_key, tls_io_instance->x509_private_key)) ||
+         (entry->x509_private_key_type != tls_io_instance->x509_private_key_type) ||
+         (!is_same_string(entry->engine_id, tls_io_instance->engine_id)) ||
+         (!is_same_string(entry->provider_name, tls_io_instance->provider_name)) ||
+         (!is_same_string(entry->trusted_certs_file, tls_io_instance->trusted_certs_file)) ||
+         (!is_same_shared_string(entry->certificate, tls_io_instance->certificate))))
+    {
+        entry = entry->next;
+    }
+
+    return entry;
+}
+
+static int acquire_shared_ssl_context(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result;
+
+    if (Lock(context_cache_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the TLS context cache.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        TLS_CONTEXT_CACHE_ENTRY* entry = find_context_cache_entry(tls_io_instance);
+
+        if (entry != NULL)
+        {
+            entry->ref_count++;
+            tls_io_instance->ssl_context = entry->ssl_context;
+            tls_io_instance->ssl_context_shared = true;
+            result = 0;
+        }
+        else if ((entry = (TLS_CONTEXT_CACHE_ENTRY*)malloc(sizeof(TLS_CONTEXT_CACHE_ENTRY))) == NULL)
+        {
+            LogError("Failed allocating the TLS context cache entry.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            (void)memset(entry, 0, sizeof(TLS_CONTEXT_CACHE_ENTRY));
+            entry->tls_version = tls_io_instance->tls_version;
+            entry->use_session_cache = tls_io_instance->use_session_cache;
+            entry->tls_validation_callback = tls_io_instance->tls_validation_callback;
+            entry->tls_validation_callback_data = tls_io_instance->tls_validation_callback_data;
+            entry->x509_private_key_type = tls_io_instance->x509_private_key_type;
+            entry->certificate = share_string(tls_io_instance->certificate);
+            entry->x509_certificate = share_string(tls_io_instance->x509_certificate);
+            entry->x509_private_key = share_string(tls_io_instance->x509_private_key);
+
+            if (((tls_io_instance->trusted_certs_file != NULL) && (mallocAndStrcpy_s(&entry->trusted_certs_file, tls_io_instance->trusted_certs_file) != 0)) ||
+                ((tls_io_instance->cipher_list != NULL) && (mallocAndStrcpy_s(&entry->cipher_list, tls_io_instance->cipher_list) != 0)) ||
+                ((tls_io_instance->tls_options.groups != NULL) && (mallocAndStrcpy_s(&entry->groups, tls_io_instance->tls_options.groups) != 0)) ||
+                ((tls_io_instance->tls_options.signature_algorithms != NULL) && (mallocAndStrcpy_s(&entry->signature_algorithms, tls_io_instance->tls_options.signature_algorithms) != 0)) ||
+                ((tls_io_instance->engine_id != NULL) && (mallocAndStrcpy_s(&entry->engine_id, tls_io_instance->engine_id) != 0)) ||
+                ((tls_io_instance->provider_name != NULL) && (mallocAndStrcpy_s(&entry->provider_name, tls_io_instance->provider_name) != 0)))
+            {
+                LogError("Failed copying the TLS context cache key.");
+                free_context_cache_entry(entry);
+                result = __FAILURE__;
+            }
+            else if ((entry->ssl_context = create_ssl_context(tls_io_instance, &entry->trusted_store)) == NULL)
+            {
+                free_context_cache_entry(entry);
+                result = __FAILURE__;
+            }
+            else
+            {
+                entry->ref_count = 1;
+                entry->next = context_cache_entries;
+                context_cache_entries = entry;
+
+                tls_io_instance->ssl_context = entry->ssl_context;
+                tls_io_instance->ssl_context_shared = true;
+                result = 0;
+            }
+        }
+
+        (void)Unlock(context_cache_lock);
+    }
+
+    return result;
+}
+
+static int acquire_ssl_context(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result;
+
+    if (tls_io_instance->use_shared_context && (context_cache_lock != NULL))
+    {
+        result = acquire_shared_ssl_context(tls_io_instance);
+    }
+    else if ((tls_io_instance->ssl_context = create_ssl_context(tls_io_instance, &tls_io_instance->trusted_store)) == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        tls_io_instance->ssl_context_shared = false;
+        result = 0;
+    }
+
+    return result;
+}
+
+// The protocols of tls_alpn are separated by commas and go on the wire with a length byte each
+static bool is_valid_alpn(const char* alpn)
+{
+    size_t protocol_length = 0;
+    bool result = true;
+
+    while (result && (*alpn != '\0'))
+    {
+        if (*alpn == ',')
+        {
+            result = (protocol_length > 0);
+            protocol_length = 0;
+        }
+        else
+        {
+            protocol_length++;
+            result = (protocol_length <= 255);
+        }
+        alpn++;
+    }
+
+    return result && (protocol_length > 0);
+}
+
+static int set_alpn_protocols(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result;
+    size_t alpn_length = strlen(tls_io_instance->alpn);
+    unsigned char* protocols = (unsigned char*)malloc(alpn_length + 1);
+
+    if (protocols == NULL)
+    {
+        LogError("Failed allocating the ALPN protocols.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t start = 0;
+        size_t i;
+
+        // each comma becomes the length of the protocol after it, the first length goes in front
+        for (i = 0; i <= alpn_length; i++)
+        {
+            if ((tls_io_instance->alpn[i] == ',') || (tls_io_instance->alpn[i] == '\0'))
+            {
+                protocols[start] = (unsigned char)(i - start);
+                start = i + 1;
+            }
+            else
+            {
+                protocols[i + 1] = (unsigned char)tls_io_instance->alpn[i];
+            }
+        }
+
+        // SSL_set_alpn_protos returns 0 on success
+        if (SSL_set_alpn_protos(tls_io_instance->ssl, protocols, (unsigned int)(alpn_length + 1)) != 0)
+        {
+            log_ERR_get_error("Failed SSL_set_alpn_protos.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+
+        free(protocols);
+    }
+
+    return result;
+}
+
+static int create_openssl_instance(TLS_IO_INSTANCE* tlsInstance)
+{
+    int result;
+
+    if (acquire_ssl_context(tlsInstance) != 0)
+    {
+        LogError("Failed getting the OpenSSL context.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        tlsInstance->in_bio = BIO_new(BIO_s_mem());
+        if (tlsInstance->in_bio == NULL)
+        {
+            release_ssl_context(tlsInstance);
+            log_ERR_get_error("Failed BIO_new for in BIO.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            tlsInstance->out_bio = BIO_new(BIO_s_mem());
+            if (tlsInstance->out_bio == NULL)
+            {
+                (void)BIO_free(tlsInstance->in_bio);
+                release_ssl_context(tlsInstance);
+                log_ERR_get_error("Failed BIO_new for out BIO.");
+                result = __FAILURE__;
+            }
+            else
+            {
+                if ((BIO_set_mem_eof_return(tlsInstance->in_bio, -1) <= 0) ||
+                    (BIO_set_mem_eof_return(tlsInstance->out_bio, -1) <= 0))
+                {
+                    (void)BIO_free(tlsInstance->in_bio);
+                    (void)BIO_free(tlsInstance->out_bio);
+                    release_ssl_context(tlsInstance);
+                    LogError("Failed BIO_set_mem_eof_return.");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    tlsInstance->session_offered = false;
+                    // a new SSL writes full sized records, the next write decides
+                    tlsInstance->send_fragment_size = DYNAMIC_RECORD_FULL_SIZE;
+                    tlsInstance->small_record_byte_count = 0;
+
+                    tlsInstance->ssl = SSL_new(tlsInstance->ssl_context);
+                    if (tlsInstance->ssl == NULL)
+                    {
+                        (void)BIO_free(tlsInstance->in_bio);
+                        (void)BIO_free(tlsInstance->out_bio);
+                        release_ssl_context(tlsInstance);
+                        log_ERR_get_error("Failed creating OpenSSL instance.");
+                        result = __FAILURE__;
+                    }
+                    else if ((tlsInstance->alpn != NULL) && (set_alpn_protocols(tlsInstance) != 0))
+                    {
+                        // the BIOs are not owned by the SSL yet
+                        SSL_free(tlsInstance->ssl);
+                        tlsInstance->ssl = NULL;
+                        (void)BIO_free(tlsInstance->in_bio);
+                        (void)BIO_free(tlsInstance->out_bio);
+                        release_ssl_context(tlsInstance);
+                        LogError("Failed setting the ALPN protocols.");
+                        result = __FAILURE__;
+                    }
+                    else
+                    {
+                        SSL_set_bio(tlsInstance->ssl, tlsInstance->in_bio, tlsInstance->out_bio);
+                        SSL_set_connect_state(tlsInstance->ssl);
+
+#ifdef TLSIO_OPENSSL_KTLS_SUPPORTED
+                        if (tlsInstance->use_ktls)
+                        {
+                            (void)SSL_set_options(tlsInstance->ssl, SSL_OP_ENABLE_KTLS);
+                            (void)SSL_set_mode(tlsInstance->ssl, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+                        }
+#endif
+
+                        if (tlsInstance->use_session_cache)
+                        {
+                            (void)SSL_set_app_data(tlsInstance->ssl, tlsInstance);
+                            offer_cached_session(tlsInstance);
+                        }
+
+                        result = 0;
+                    }
+                }
+            }
+        }
+    }
+    return result;
+}
+
+static void release_engine(TLS_IO_INSTANCE* tls_io_instance)
+{
+#ifdef X509_OPENSSL_ENGINES_SUPPORTED
+    if (tls_io_instance->engine != NULL)
+    {
+        (void)ENGINE_finish(tls_io_instance->engine);
+        (void)ENGINE_free(tls_io_instance->engine);
+        tls_io_instance->engine = NULL;
+    }
+#endif
+    free(tls_io_instance->engine_id);
+    tls_io_instance->engine_id = NULL;
+}
+
+static int load_engine(TLS_IO_INSTANCE* tls_io_instance, const char* engine_id)
+{
+    int result;
+#ifdef X509_OPENSSL_ENGINES_SUPPORTED
+    ENGINE* engine;
+
+    ENGINE_load_builtin_engines();
+
+    // ENGINE_by_id also tries loading a shared library engine of that id from the engines directory
+    if ((engine = ENGINE_by_id(engine_id)) == NULL)
+    {
+        log_ERR_get_error("unable to find the OpenSSL engine");
+        result = __FAILURE__;
+    }
+    else if (ENGINE_init(engine) != 1)
+    {
+        log_ERR_get_error("unable to initialize the OpenSSL engine");
+        (void)ENGINE_free(engine);
+        result = __FAILURE__;
+    }
+    // The engine takes the algorithms it implements for the whole process, bulk ciphers included
+    else if (ENGINE_set_default(engine, ENGINE_METHOD_ALL) != 1)
+    {
+        log_ERR_get_error("unable to make the OpenSSL engine the default");
+        (void)ENGINE_finish(engine);
+        (void)ENGINE_free(engine);
+        result = __FAILURE__;
+    }
+    else
+    {
+        char* engine_id_copy;
+
+        if (mallocAndStrcpy_s(&engine_id_copy, engine_id) != 0)
+        {
+            LogError("unable to mallocAndStrcpy_s the engine id");
+            (void)ENGINE_finish(engine);
+            (void)ENGINE_free(engine);
+            result = __FAILURE__;
+        }
+        else
+        {
+            release_engine(tls_io_instance);
+            tls_io_instance->engine = engine;
+            tls_io_instance->engine_id = engine_id_copy;
+            result = 0;
+        }
+    }
+#else
+    (void)tls_io_instance;
+    (void)engine_id;
+    LogError("this OpenSSL has no engines, use the %s option instead", OPTION_OPENSSL_PROVIDER);
+    result = __FAILURE__;
+#endif
+    return result;
+}
+
+static void release_provider(TLS_IO_INSTANCE* tls_io_instance)
+{
+#ifdef TLSIO_OPENSSL_PROVIDERS_SUPPORTED
+    if (tls_io_instance->provider != NULL)
+    {
+        (void)OSSL_PROVIDER_unload(tls_io_instance->provider);
+        tls_io_instance->provider = NULL;
+    }
+#endif
+    free(tls_io_instance->provider_name);
+    tls_io_instance->provider_name = NULL;
+}
+
+static int load_provider(TLS_IO_INSTANCE* tls_io_instance, const char* provider_name)
+{
+    int result;
+#ifdef TLSIO_OPENSSL_PROVIDERS_SUPPORTED
+    OSSL_PROVIDER* provider;
+
+    // Loading a provider keeps the default one, which has the algorithms the provider does not implement
+    if ((provider = OSSL_PROVIDER_try_load(NULL, provider_name, 1)) == NULL)
+    {
+        log_ERR_get_error("unable to load the OpenSSL provider");
+        result = __FAILURE__;
+    }
+    else
+    {
+        char* provider_name_copy;
+
+        if (mallocAndStrcpy_s(&provider_name_copy, provider_name) != 0)
+        {
+            LogError("unable to mallocAndStrcpy_s the provider name");
+            (void)OSSL_PROVIDER_unload(provider);
+            result = __FAILURE__;
+        }
+        else
+        {
+            release_provider(tls_io_instance);
+            tls_io_instance->provider = provider;
+            tls_io_instance->provider_name = provider_name_copy;
+            result = 0;
+        }
+    }
+#else
+    (void)tls_io_instance;
+    (void)provider_name;
+    LogError("OpenSSL providers need OpenSSL 3");
+    result = __FAILURE__;
+#endif
+    return result;
+}
+
+/* The library is initialized by the first tlsio_openssl_create rather than by tlsio_openssl_init, so that
+   processes that never open a TLS connection do not pay for loading the algorithms and the error strings.
+   With TLSIO_OPENSSL_MINIMAL_INIT only what TLS needs is loaded: no error strings, and on OpenSSL before 1.1
+   only the ciphers and digests SSL_library_init registers, which leaves out the ones an encrypted private
+   key or a PKCS#12 file may need. */
+static LOCK_HANDLE library_init_lock = NULL;
+static bool library_initialized = false;
+
+// Must be called with library_init_lock held
+static int openssl_library_init(void)
+{
+    int result;
+
+    if (library_initialized)
+    {
+        result = 0;
+    }
+    else
+    {
+#if defined(TLSIO_OPENSSL_MINIMAL_INIT) && (OPENSSL_VERSION_NUMBER >= 0x10100000L) && !defined(LIBRESSL_VERSION_NUMBER)
+        (void)OPENSSL_init_ssl(OPENSSL_INIT_NO_LOAD_SSL_STRINGS | OPENSSL_INIT_NO_LOAD_CRYPTO_STRINGS, NULL);
+#else
+        (void)SSL_library_init();
+#ifndef TLSIO_OPENSSL_MINIMAL_INIT
+        SSL_load_error_strings();
+#if (OPENSSL_VERSION_NUMBER < 0x10100000L) || defined(LIBRESSL_VERSION_NUMBER)
+        ERR_load_BIO_strings();
+#endif
+        OpenSSL_add_all_algorithms();
+#endif
+#endif
+
+#ifdef TLSIO_OPENSSL_LOCKING_CALLBACKS
+        if (openssl_static_locks_install() != 0)
+        {
+            LogError("Failed to install static locks in OpenSSL!");
+            result = __FAILURE__;
+        }
+        else
+        {
+            openssl_dynamic_locks_install();
+            library_initialized = true;
+            result = 0;
+        }
+#else
+        library_initialized = true;
+        result = 0;
+#endif
+    }
+
+    return result;
+}
+
+static int openssl_library_init_once(void)
+{
+    int result;
+
+    if (library_init_lock == NULL)
+    {
+        // tlsio_openssl_init was not called (or failed), there is nothing to serialize with
+        result = openssl_library_init();
+    }
+    else if (Lock(library_init_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the OpenSSL initialization.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = openssl_library_init();
+        (void)Unlock(library_init_lock);
+    }
+
+    return result;
+}
+
+int tlsio_openssl_init(void)
+{
+    library_init_lock = Lock_Init();
+    if (library_init_lock == NULL)
+    {
+        LogError("Failed to create the OpenSSL initialization lock.");
+        return __FAILURE__;
+    }
+
+    session_cache_lock = Lock_Init();
+    if (session_cache_lock == NULL)
+    {
+        // Not fatal, only OPTION_TLS_SESSION_CACHE becomes unavailable
+        LogError("Failed to create the TLS session cache lock.");
+    }
+
+    context_cache_lock = Lock_Init();
+    if (context_cache_lock == NULL)
+    {
+        // Not fatal, only OPTION_TLS_SHARED_CONTEXT becomes unavailable
+        LogError("Failed to create the TLS context cache lock.");
+    }
+
+    trusted_store_cache_lock = Lock_Init();
+    if (trusted_store_cache_lock == NULL)
+    {
+        // Not fatal, only OPTION_TRUSTED_CERT_FILE becomes unavailable
+        LogError("Failed to create the trusted certificates cache lock.");
+    }
+
+    if (x509_openssl_credentials_cache_init() != 0)
+    {
+        // Not fatal, every instance then parses its own x509 credentials
+        LogError("Failed to create the x509 credentials cache.");
+    }
+
+    return 0;
+}
+
+void tlsio_openssl_deinit(void)
+{
+    if (session_cache_lock != NULL)
+    {
+        while (session_cache_entries != NULL)
+        {
+            TLS_SESSION_CACHE_ENTRY* entry = session_cache_entries;
+            session_cache_entries = entry->next;
+            free_session_cache_entry(entry);
+        }
+
+        (void)memset(&session_cache_stats, 0, sizeof(session_cache_stats));
+        Lock_Deinit(session_cache_lock);
+        session_cache_lock = NULL;
+    }
+
+    if (context_cache_lock != NULL)
+    {
+        // Only contexts still referenced by instances that were not destroyed are left
+        while (context_cache_entries != NULL)
+        {
+            TLS_CONTEXT_CACHE_ENTRY* entry = context_cache_entries;
+            context_cache_entries = entry->next;
+            free_context_cache_entry(entry);
+        }
+
+        Lock_Deinit(context_cache_lock);
+        context_cache_lock = NULL;
+    }
+
+    if (trusted_store_cache_lock != NULL)
+    {
+        // The stores still referenced by SSL_CTXs stay alive through the X509_STORE reference count
+        while (trusted_store_cache_entries != NULL)
+        {
+            TLS_TRUSTED_STORE* entry = trusted_store_cache_entries;
+            trusted_store_cache_entries = entry->next;
+            X509_STORE_free(entry->store);
+            free(entry->path);
+            free(entry);
+        }
+
+        Lock_Deinit(trusted_store_cache_lock);
+        trusted_store_cache_lock = NULL;
+    }
+
+    x509_openssl_credentials_cache_deinit();
+
+    if (library_initialized)
+    {
+#ifdef TLSIO_OPENSSL_LOCKING_CALLBACKS
+        openssl_dynamic_locks_uninstall();
+        openssl_static_locks_uninstall();
+#endif
+#if  (OPENSSL_VERSION_NUMBER >= 0x00907000L) &&  (OPENSSL_VERSION_NUMBER < 0x20000000L) && (FIPS_mode_set)
+        FIPS_mode_set(0);
+#endif
+        CRYPTO_set_locking_callback(NULL);
+        CRYPTO_set_id_callback(NULL);
+        ERR_free_strings();
+        EVP_cleanup();
+
+#if   (OPENSSL_VERSION_NUMBER < 0x10000000L)
+        ERR_remove_state(0);
+#elif (OPENSSL_VERSION_NUMBER < 0x10100000L) || defined(LIBRESSL_VERSION_NUMBER)
+        ERR_remove_thread_state(NULL);
+#endif
+#if  (OPENSSL_VERSION_NUMBER >= 0x10002000L) &&  (OPENSSL_VERSION_NUMBER < 0x10010000L) && (SSL_COMP_free_compression_methods)
+        SSL_COMP_free_compression_methods();
+#endif
+        CRYPTO_cleanup_all_ex_data();
+        library_initialized = false;
+    }
+
+    if (library_init_lock != NULL)
+    {
+        Lock_Deinit(library_init_lock);
+        library_init_lock = NULL;
+    }
+}
+
+CONCRETE_IO_HANDLE tlsio_openssl_create(void* io_create_parameters)
+{
+    TLSIO_CONFIG* tls_io_config = io_create_parameters;
+    TLS_IO_INSTANCE* result;
+
+    if (tls_io_config == NULL)
+    {
+        result = NULL;
+        LogError("NULL tls_io_config.");
+    }
+    else if (openssl_library_init_once() != 0)
+    {
+        result = NULL;
+        LogError("Failed initializing OpenSSL.");
+    }
+    else
+    {
+        result = malloc(sizeof(TLS_IO_INSTANCE));
+        if (result == NULL)
+        {
+            LogError("Failed allocating TLSIO instance.");
+        }
+        else
+        {
+            SOCKETIO_CONFIG socketio_config;
+            const IO_INTERFACE_DESCRIPTION* underlying_io_interface;
+            void* io_interface_parameters;
+
+            if (tls_io_config->underlying_io_interface != NULL)
+            {
+                underlying_io_interface = tls_io_config->underlying_io_interface;
+                io_interface_parameters = tls_io_config->underlying_io_parameters;
+            }
+            else
+            {
+                socketio_config.hostname = tls_io_config->hostname;
+                socketio_config.port = tls_io_config->port;
+                socketio_config.accepted_socket = NULL;
+
+                underlying_io_interface = socketio_get_interface_description();
+                io_interface_parameters = &socketio_config;
+            }
+
+            if (underlying_io_interface == NULL)
+            {
+                free(result);
+                result = NULL;
+                LogError("Failed getting socket IO interface description.");
+            }
+            else
+            {
+                result->certificate = NULL;
+                result->cipher_list = NULL;
+                result->alpn = NULL;
+                tlsio_options_initialize(&result->tls_options, TLSIO_OPTION_BIT_GROUPS | TLSIO_OPTION_BIT_SIGNATURE_ALGORITHMS);
+                result->in_bio = NULL;
+                result->out_bio = NULL;
+                result->send_buffer = NULL;
+                result->send_buffer_size = 0;
+                result->received_bytes = NULL;
+                result->received_bytes_size = 0;
+                result->received_byte_count = 0;
+                result->read_chunk_size = DEFAULT_READ_CHUNK_SIZE;
+                result->lent_received_bytes = NULL;
+                result->lent_received_bytes_size = 0;
+                result->coalesce_received_bytes = false;
+                result->cork_sends = false;
+                result->dynamic_record_size = false;
+                result->send_fragment_size = DYNAMIC_RECORD_FULL_SIZE;
+                result->small_record_byte_count = 0;
+                result->last_write_us = 0;
+                result->corked_bytes = NULL;
+                result->corked_bytes_size = 0;
+                result->corked_byte_count = 0;
+                result->corked_sends = NULL;
+                result->corked_sends_size = 0;
+                result->corked_send_count = 0;
+                result->use_early_data = false;
+                result->early_data_open = false;
+                result->early_data_sends = NULL;
+                result->early_data_sends_size = 0;
+                result->early_data_send_count = 0;
+                result->early_data_bytes = NULL;
+                result->early_data_bytes_size = 0;
+                result->early_data_byte_count = 0;
+                result->on_bytes_received = NULL;
+                result->on_bytes_received_context = NULL;
+                result->on_io_open_complete = NULL;
+                result->on_io_open_complete_context = NULL;
+                result->on_io_close_complete = NULL;
+                result->on_io_close_complete_context = NULL;
+                result->on_io_error = NULL;
+                result->on_io_error_context = NULL;
+                result->ssl = NULL;
+                result->ssl_context = NULL;
+                result->trusted_certs_file = NULL;
+                result->trusted_store = NULL;
+                result->tls_validation_callback = NULL;
+                result->tls_validation_callback_data = NULL;
+                result->x509_certificate = NULL;
+                result->x509_private_key = NULL;
+                result->x509_credentials = NULL;
+                result->x509_private_key_type = KEY_TYPE_DEFAULT;
+                result->engine_id = NULL;
+#ifdef X509_OPENSSL_ENGINES_SUPPORTED
+                result->engine = NULL;
+#endif
+                result->provider_name = NULL;
+#ifdef TLSIO_OPENSSL_PROVIDERS_SUPPORTED
+                result->provider = NULL;
+#endif
+                result->hostname = NULL;
+                result->port = tls_io_config->port;
+                result->use_session_cache = false;
+                result->session_offered = false;
+                result->use_ktls = false;
+                result->ktls_socket_attached = false;
+                result->use_shared_context = false;
+                result->ssl_context_shared = false;
+                result->ktls_pending_sends = NULL;
+                result->ktls_last_pending_send = NULL;
+                result->handshake_threadpool = NULL;
+                result->handshake_job_state = TLS_HANDSHAKE_JOB_NONE;
+                result->handshake_job_ssl_error = SSL_ERROR_NONE;
+                result->handshake_job_error = 0;
+                result->handshake_held_bytes = NULL;
+                result->handshake_held_bytes_size = 0;
+                result->handshake_held_byte_count = 0;
+                (void)memset(&result->stats, 0, sizeof(result->stats));
+                result->stats.layer_name = "tlsio_openssl";
+
+                result->tls_version = VERSION_1_2;
+
+                if ((tls_io_config->hostname != NULL) &&
+                    (mallocAndStrcpy_s(&result->hostname, tls_io_config->hostname) != 0))
+                {
+                    free(result);
+                    result = NULL;
+                    LogError("Failed copying the hostname.");
+                }
+                else if ((result->underlying_io = xio_create(underlying_io_interface, io_interface_parameters)) == NULL)
+                {
+                    free(result->hostname);
+                    free(result);
+                    result = NULL;
+                    LogError("Failed xio_create.");
+                }
+                else
+                {
+                    result->tlsio_state = TLSIO_STATE_NOT_OPEN;
+                }
+            }
+        }
+}
+
+    return result;
+}
+
+void tlsio_openssl_destroy(CONCRETE_IO_HANDLE tls_io)
+{
+    if (tls_io == NULL)
+    {
+        LogError("NULL tls_io.");
+    }
+    else
+    {
+        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+        release_shared_string(tls_io_instance->certificate);
+        tls_io_instance->certificate = NULL;
+        free(tls_io_instance->trusted_certs_file);
+        if (tls_io_instance->cipher_list != NULL)
+        {
+            free(tls_io_instance->cipher_list);
+            tls_io_instance->cipher_list = NULL;
+        }
+        free(tls_io_instance->alpn);
+        tlsio_options_release_resources(&tls_io_instance->tls_options);
+        release_shared_string(tls_io_instance->x509_certificate);
+        release_shared_string(tls_io_instance->x509_private_key);
+        free(tls_io_instance->hostname);
+        close_openssl_instance(tls_io_instance);
+        if (tls_io_instance->x509_credentials != NULL)
+        {
+            x509_openssl_credentials_release(tls_io_instance->x509_credentials);
+            tls_io_instance->x509_credentials = NULL;
+        }
+        release_engine(tls_io_instance);
+        release_provider(tls_io_instance);
+        if (tls_io_instance->underlying_io != NULL)
+        {
+            xio_destroy(tls_io_instance->underlying_io);
+            tls_io_instance->underlying_io = NULL;
+        }
+        free(tls_io);
+    }
+}
+
+int tlsio_openssl_open(CONCRETE_IO_HANDLE tls_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    int result;
+
+    if (tls_io == NULL)
+    {
+        result = __FAILURE__;
+        LogError("NULL tls_io.");
+    }
+    else
+    {
+        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+
+        if (tls_io_instance->tlsio_state != TLSIO_STATE_NOT_OPEN)
+        {
+            LogError("Invalid tlsio_state. Expected state is TLSIO_STATE_NOT_OPEN.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            tls_io_instance->on_io_open_complete = on_io_open_complete;
+            tls_io_instance->on_io_open_complete_context = on_io_open_complete_context;
+
+            tls_io_instance->on_bytes_received = on_bytes_received;
+            tls_io_instance->on_bytes_received_context = on_bytes_received_context;
+
+            tls_io_instance->on_io_error = on_io_error;
+            tls_io_instance->on_io_error_context = on_io_error_context;
+
+            tls_io_instance->tlsio_state = TLSIO_STATE_OPENING_UNDERLYING_IO;
+
+            // a failed open may have left a handshake step running on the SSL about to be replaced
+            wait_for_handshake_job(tls_io_instance);
+
+            if (create_openssl_instance(tls_io_instance) != 0)
+            {
+                LogError("Failed creating the OpenSSL instance.");
+                tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+                result = __FAILURE__;
+            }
+            else if (xio_open(tls_io_instance->underlying_io, on_underlying_io_open_complete, tls_io_instance,
+                on_underlying_io_bytes_received, tls_io_instance, on_underlying_io_error, tls_io_instance) != 0)
+            {
+                LogError("Failed opening the underlying I/O.");
+                close_openssl_instance(tls_io_instance);
+                tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+/* Codes_SRS_TLSIO_30_009: [ The phrase "enter TLSIO_STATE_EXT_CLOSING" means the adapter shall iterate through any unsent messages in the queue and shall delete each message after calling its on_send_complete with the associated callback_context and IO_SEND_CANCELLED. ]*/
+/* Codes_SRS_TLSIO_30_006: [ The phrase "enter TLSIO_STATE_EXT_CLOSED" means the adapter shall forcibly close any existing connections then call the on_io_close_complete function and pass the on_io_close_complete_context that was supplied in tlsio_close_async. ]*/
+/* Codes_SRS_TLSIO_30_051: [ On success, if the underlying TLS does not support asynchronous closing, then the adapter shall enter TLSIO_STATE_EXT_CLOSED immediately after entering TLSIO_STATE_EX_CLOSING. ]*/
+int tlsio_openssl_close(CONCRETE_IO_HANDLE tls_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    int result;
+
+    /* Codes_SRS_TLSIO_30_050: [ If the tlsio_handle parameter is NULL, tlsio_close_async shall log an error and return _FAILURE_. ]*/
+    if (tls_io == NULL)
+    {
+        LogError("NULL tls_io.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+
+        if (tls_io_instance->tlsio_state != TLSIO_STATE_ERROR && tls_io_instance->tlsio_state != TLSIO_STATE_OPEN)
+        {
+            /* Codes_RS_TLSIO_30_053: [ If the adapter is in any state other than TLSIO_STATE_EXT_OPEN or TLSIO_STATE_EXT_ERROR then tlsio_close_async shall log that tlsio_close_async has been called and then continue normally. ]*/
+            // LogInfo rather than LogError because this is an unusual but not erroneous situation
+            LogInfo("Closing tlsio from a state other than TLSIO_STATE_EXT_OPEN or TLSIO_STATE_EXT_ERROR");
+        }
+
+        if (is_an_opening_state(tls_io_instance->tlsio_state) && !tls_io_instance->early_data_open)
+        {
+            /* Codes_SRS_TLSIO_30_057: [ On success, if the adapter is in TLSIO_STATE_EXT_OPENING, it shall call on_io_open_complete with the on_io_open_complete_context supplied in tlsio_open_async and IO_OPEN_CANCELLED. This callback shall be made before changing the internal state of the adapter. ]*/
+            tls_io_instance->on_io_open_complete(tls_io_instance->on_io_open_complete_context, IO_OPEN_CANCELLED);
+        }
+
+        if (tls_io_instance->tlsio_state == TLSIO_STATE_OPEN)
+        {
+            // corked sends go out ahead of the close, as they would have without corking
+            if (flush_corked_sends(tls_io_instance) != 0)
+            {
+                LogError("Failed flushing the corked sends.");
+            }
+
+            // Attempt a graceful shutdown
+            /* Codes_SRS_TLSIO_30_056: [ On success the adapter shall enter TLSIO_STATE_EX_CLOSING. ]*/
+            tls_io_instance->tlsio_state = TLSIO_STATE_CLOSING;
+            tls_io_instance->on_io_close_complete = on_io_close_complete;
+            tls_io_instance->on_io_close_complete_context = callback_context;
+            // xio_close is guaranteed to succeed from the open state, and the callback completes the
+            // transition into TLSIO_STATE_NOT_OPEN
+            if (xio_close(tls_io_instance->underlying_io, on_underlying_io_close_complete, tls_io_instance) != 0)
+            {
+                close_openssl_instance(tls_io_instance);
+                tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+            }
+        }
+        else
+        {
+            // Just force the shutdown
+            /* Codes_SRS_TLSIO_30_056: [ On success the adapter shall enter TLSIO_STATE_EX_CLOSING. ]*/
+            /* Codes_SRS_TLSIO_30_051: [ On success, if the underlying TLS does not support asynchronous closing or if the adapter is not in TLSIO_STATE_EXT_OPEN, then the adapter shall enter TLSIO_STATE_EXT_CLOSED immediately after entering TLSIO_STATE_EXT_CLOSING. ]*/
+            // Current implementations of xio_close will fail if not in the open state, but we don't care
+            (void)xio_close(tls_io_instance->underlying_io, NULL, NULL);
+            close_openssl_instance(tls_io_instance);
+            tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+        }
+
+        result = 0;
+    }
+    /* Codes_SRS_TLSIO_30_054: [ On failure, the adapter shall not call on_io_close_complete. ]*/
+
+    return result;
+}
+
+int tlsio_openssl_send(CONCRETE_IO_HANDLE tls_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    if (tls_io == NULL)
+    {
+        LogError("NULL tls_io.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+
+        if ((tls_io_instance->tlsio_state != TLSIO_STATE_OPEN) && !tls_io_instance->early_data_open)
+        {
+            LogError("Invalid tlsio_state. Expected state is TLSIO_STATE_OPEN.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            int res;
+            if (tls_io_instance->ssl == NULL)
+            {
+                LogError("SSL channel closed in tlsio_openssl_send.");
+                result = __FAILURE__;
+                return result;
+            }
+
+            // sends made before the handshake of an early data open is done are held as corked sends
+            if (tls_io_instance->cork_sends || tls_io_instance->early_data_open)
+            {
+                XIO_BUFFER corked_buffer;
+                corked_buffer.buffer = buffer;
+                corked_buffer.size = size;
+
+                result = cork_send(tls_io_instance, &corked_buffer, 1, on_send_complete, callback_context);
+                if (result == 0)
+                {
+                    count_send(tls_io_instance, size);
+                    if ((tls_io_instance->corked_byte_count >= CORK_FLUSH_SIZE) && !tls_io_instance->early_data_open)
+                    {
+                        flush_corked_sends_or_fail(tls_io_instance);
+                    }
+                }
+                return result;
+            }
+
+            if (tls_io_instance->ktls_socket_attached)
+            {
+                result = send_ktls_bytes(tls_io_instance, buffer, size, on_send_complete, callback_context);
+                if (result == 0)
+                {
+                    count_send(tls_io_instance, size);
+                }
+                return result;
+            }
+
+            res = ssl_write(tls_io_instance, buffer, size);
+            if (res != (int)size)
+            {
+                log_ERR_get_error("SSL_write error.");
+                result = __FAILURE__;
+            }
+            else
+            {
+                if (write_outgoing_bytes(tls_io_instance, on_send_complete, callback_context) != 0)
+                {
+                    LogError("Error in write_outgoing_bytes.");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    count_send(tls_io_instance, size);
+                    result = 0;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+int tlsio_openssl_sendv(CONCRETE_IO_HANDLE tls_io, const XIO_BUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    if ((tls_io == NULL) ||
+        (buffers == NULL) ||
+        (buffer_count == 0))
+    {
+        LogError("Invalid argument: tls_io=%p, buffers=%p, buffer_count=%lu.", tls_io, buffers, (unsigned long)buffer_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+
+        if ((tls_io_instance->tlsio_state != TLSIO_STATE_OPEN) && !tls_io_instance->early_data_open)
+        {
+            LogError("Invalid tlsio_state. Expected state is TLSIO_STATE_OPEN.");
+            result = __FAILURE__;
+        }
+        else if (tls_io_instance->ssl == NULL)
+        {
+            LogError("SSL channel closed in tlsio_openssl_sendv.");
+            result = __FAILURE__;
+        }
+        else if (tls_io_instance->cork_sends || tls_io_instance->early_data_open)
+        {
+            /* the buffers are copied next to the sends corked before them, flushing happens after counting */
+            result = cork_send(tls_io_instance, buffers, buffer_count, on_send_complete, callback_context);
+        }
+        else if (tls_io_instance->ktls_socket_attached)
+        {
+            size_t i;
+            size_t last = buffer_count - 1;
+
+            result = 0;
+
+            /* the records go to the socket one buffer at a time, the caller is told when the last one is written */
+            while ((last > 0) && (buffers[last].size == 0))
+            {
+                last--;
+            }
+
+            for (i = 0; i <= last; i++)
+            {
+                if ((buffers[i].size > 0) &&
+                    (send_ktls_bytes(tls_io_instance, buffers[i].buffer, buffers[i].size, (i == last) ? on_send_complete : NULL, callback_context) != 0))
+                {
+                    LogError("Error in send_ktls_bytes.");
+                    result = __FAILURE__;
+                    break;
+                }
+            }
+        }
+        else
+        {
+            size_t i;
+
+            result = 0;
+
+            /* every buffer is encrypted straight from the caller's memory into the out BIO */
+            for (i = 0; i < buffer_count; i++)
+            {
+                if (buffers[i].size > 0)
+                {
+                    int res = ssl_write(tls_io_instance, buffers[i].buffer, buffers[i].size);
+                    if (res != (int)buffers[i].size)
+                    {
+                        log_ERR_get_error("SSL_write error.");
+                        result = __FAILURE__;
+                        break;
+                    }
+                }
+            }
+
+            /* all the records produced are handed to the underlying IO in one send */
+            if ((result == 0) &&
+                (write_outgoing_bytes(tls_io_instance, on_send_complete, callback_context) != 0))
+            {
+                LogError("Error in write_outgoing_bytes.");
+                result = __FAILURE__;
+            }
+        }
+
+        if (result == 0)
+        {
+            size_t i;
+            size_t total_size = 0;
+
+            for (i = 0; i < buffer_count; i++)
+            {
+                total_size += buffers[i].size;
+            }
+
+            count_send(tls_io_instance, total_size);
+
+            if (tls_io_instance->cork_sends && !tls_io_instance->early_data_open && (tls_io_instance->corked_byte_count >= CORK_FLUSH_SIZE))
+            {
+                flush_corked_sends_or_fail(tls_io_instance);
+            }
+        }
+    }
+
+    return result;
+}
+
+/* returns whether this layer or the ones below made progress; next_deadline_us is NULL for tlsio_openssl_dowork,
+   which pumps the underlying IO with xio_dowork */
+static bool dowork_tls(CONCRETE_IO_HANDLE tls_io, uint64_t* next_deadline_us)
+{
+    bool result = false;
+
+    if (tls_io == NULL)
+    {
+        LogError("NULL tls_io.");
+    }
+    else
+    {
+        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+        uint64_t callback_count = tls_io_instance->stats.callback_count;
+        bool underlying_progress = false;
+        tickcounter_us_t now;
+
+        tls_io_instance->stats.dowork_count++;
+
+        if (TLS_HANDSHAKE_JOB_GET_STATE(&tls_io_instance->handshake_job_state) == TLS_HANDSHAKE_JOB_DONE)
+        {
+            complete_handshake_job(tls_io_instance);
+            underlying_progress = true;
+        }
+
+        switch (tls_io_instance->tlsio_state)
+        {
+        case TLSIO_STATE_OPENING_UNDERLYING_IO:
+        case TLSIO_STATE_IN_HANDSHAKE:
+        case TLSIO_STATE_OPEN:
+            if (tls_io_instance->handshake_job_state != TLS_HANDSHAKE_JOB_NONE)
+            {
+                // the out BIO is the worker's until the handshake step is done
+            }
+            else if (tls_io_instance->ktls_socket_attached)
+            {
+                if (tls_io_instance->tlsio_state == TLSIO_STATE_IN_HANDSHAKE)
+                {
+                    /* resumes handshake writes the socket could not take */
+                    send_handshake_bytes(tls_io_instance);
+                }
+                else
+                {
+                    flush_ktls_pending_sends(tls_io_instance);
+                }
+            }
+            else
+            {
+                /* this is needed in order to pump out bytes produces by OpenSSL for things like renegotiation */
+                write_outgoing_bytes(tls_io_instance, NULL, NULL);
+            }
+            break;
+        case TLSIO_STATE_NOT_OPEN:
+        case TLSIO_STATE_HANDSHAKE_FAILED:
+        case TLSIO_STATE_CLOSING:
+        case TLSIO_STATE_ERROR:
+        default:
+            break;
+        }
+
+        if (tls_io_instance->tlsio_state != TLSIO_STATE_NOT_OPEN)
+        {
+            /* Same behavior as schannel */
+            if (next_deadline_us == NULL)
+            {
+                xio_dowork(tls_io_instance->underlying_io);
+            }
+            else if (xio_dowork_ex(tls_io_instance->underlying_io, &underlying_progress, next_deadline_us) != 0)
+            {
+                /* nothing is known of the layers below, the caller shall not go idle */
+                underlying_progress = true;
+                *next_deadline_us = XIO_NO_DEADLINE;
+            }
+
+            if (tls_io_instance->tlsio_state == TLSIO_STATE_OPEN)
+            {
+                indicate_coalesced_received_bytes(tls_io_instance);
+            }
+
+            // the end of a handshake step on the pool cannot be waited for on the socket
+            if ((next_deadline_us != NULL) &&
+                (tls_io_instance->handshake_job_state == TLS_HANDSHAKE_JOB_RUNNING) &&
+                (tickcounter_get_monotonic_us(&now) == 0) &&
+                (now + ((tickcounter_us_t)TLS_HANDSHAKE_JOB_CHECK_INTERVAL_MS * 1000) < *next_deadline_us))
+            {
+                *next_deadline_us = now + ((tickcounter_us_t)TLS_HANDSHAKE_JOB_CHECK_INTERVAL_MS * 1000);
+            }
+
+            /* sends made during this pass, including from the callbacks above, leave as one batch of records */
+            if (tls_io_instance->tlsio_state == TLSIO_STATE_OPEN)
+            {
+                flush_corked_sends_or_fail(tls_io_instance);
+            }
+
+            if (tls_io_instance->tlsio_state == TLSIO_STATE_HANDSHAKE_FAILED)
+            {
+                // The handshake failed so we need to close. The tlsio becomes aware of the
+                // handshake failure during an on_bytes_received while the underlying
+                // xio_dowork is pumping data out of the socket in a while loop. The tlsio can't
+                // close down during the callback because that would mean the xio_dowork would
+                // be trying to read from a closed socket. So instead, the tlsio sets its state
+                // to TLSIO_STATE_HANDSHAKE_FAILED during the on_bytes_received callback,
+                // can then gracefully shut things down here.
+                //
+                // Set the state to TLSIO_STATE_ERROR so close won't gripe about the state
+                tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
+                if (tls_io_instance->early_data_open)
+                {
+                    // the open has been reported already, the owner closes on the error
+                    tls_io_instance->early_data_open = false;
+                    complete_early_data_sends(tls_io_instance, IO_SEND_ERROR);
+                    indicate_error(tls_io_instance);
+                }
+                else
+                {
+                    tlsio_openssl_close(tls_io_instance, NULL, NULL);
+                    indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
+                }
+            }
+        }
+
+        if (tls_io_instance->stats.callback_count == callback_count)
+        {
+            tls_io_instance->stats.idle_dowork_count++;
+        }
+
+        result = underlying_progress || (tls_io_instance->stats.callback_count != callback_count);
+    }
+
+    return result;
+}
+
+void tlsio_openssl_dowork(CONCRETE_IO_HANDLE tls_io)
+{
+    (void)dowork_tls(tls_io, NULL);
+}
+
+int tlsio_openssl_dowork_ex(CONCRETE_IO_HANDLE tls_io, bool* made_progress, uint64_t* next_deadline_us)
+{
+    int result;
+
+    if ((tls_io == NULL) ||
+        (made_progress == NULL) ||
+        (next_deadline_us == NULL))
+    {
+        LogError("Invalid argument: tls_io=%p, made_progress=%p, next_deadline_us=%p", tls_io, made_progress, next_deadline_us);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* TLS has no timers of its own, the deadline is the one of the layers below */
+        *next_deadline_us = XIO_NO_DEADLINE;
+        *made_progress = dowork_tls(tls_io, next_deadline_us);
+        result = 0;
+    }
+
+    return result;
+}
+
+int tlsio_openssl_get_pollable_handle(CONCRETE_IO_HANDLE tls_io, intptr_t* pollable_handle, unsigned int* wanted_events)
+{
+    int result;
+
+    if ((tls_io == NULL) ||
+        (pollable_handle == NULL) ||
+        (wanted_events == NULL))
+    {
+        LogError("Invalid argument: tls_io=%p, pollable_handle=%p, wanted_events=%p", tls_io, pollable_handle, wanted_events);
+        result = __FAILURE__;
+    }
+    else
+    {
+        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+
+        if (xio_get_pollable_handle(tls_io_instance->underlying_io, pollable_handle, wanted_events) != 0)
+        {
+            LogError("Failed getting the pollable handle of the underlying IO.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            // with kernel TLS the records that did not fit in the socket are kept here, not in the underlying IO
+            if (tls_io_instance->ktls_pending_sends != NULL)
+            {
+                *wanted_events |= XIO_POLL_WRITABLE;
+            }
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int tlsio_openssl_set_receive_buffer(CONCRETE_IO_HANDLE tls_io, unsigned char* buffer, size_t size)
+{
+    int result;
+
+    if (tls_io == NULL)
+    {
+        LogError("NULL tls_io.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+
+        // SSL_read takes an int
+        tls_io_instance->lent_received_bytes = buffer;
+        tls_io_instance->lent_received_bytes_size = (size > INT_MAX) ? INT_MAX : size;
+        result = 0;
+    }
+
+    return result;
+}
+
+int tlsio_openssl_get_stats(CONCRETE_IO_HANDLE tls_io, XIO_STATS* stats, size_t stats_count, size_t* layer_count)
+{
+    int result;
+
+    if ((tls_io == NULL) ||
+        (stats == NULL) ||
+        (stats_count == 0) ||
+        (layer_count == NULL))
+    {
+        LogError("Invalid argument: tls_io=%p, stats=%p, stats_count=%lu, layer_count=%p.", tls_io, stats, (unsigned long)stats_count, layer_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+        KTLS_PENDING_SEND* pending_send;
+        size_t underlying_layer_count;
+
+        stats[0] = tls_io_instance->stats;
+        stats[0].pending_send_count = 0;
+        for (pending_send = tls_io_instance->ktls_pending_sends; pending_send != NULL; pending_send = pending_send->next)
+        {
+            stats[0].pending_send_count++;
+        }
+        stats[0].pending_send_count += tls_io_instance->corked_send_count;
+
+        // the layers below follow, when there is room for them and they keep counters
+        if ((stats_count > 1) &&
+            (xio_get_stats(tls_io_instance->underlying_io, &stats[1], stats_count - 1, &underlying_layer_count) == 0))
+        {
+            *layer_count = 1 + underlying_layer_count;
+        }
+        else
+        {
+            *layer_count = 1;
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+static int tlsio_openssl_setoption_by_key(void* tls_io, int key, const char* optionName, const void* value)
+{
+    int result;
+
+    if (tls_io == NULL || optionName == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
+
+        switch (key)
+        {
+        case TLSIO_OPENSSL_OPTION_TRUSTED_CERT:
+        {
+            const char* cert = (const char*)value;
+
+            if (tls_io_instance->trusted_certs_file != NULL)
+            {
+                // The store of the file is shared, the certificates cannot be added to it
+                LogError("%s cannot be set together with %s", optionName, OPTION_TRUSTED_CERT_FILE);
+                result = __FAILURE__;
+                break;
+            }
+
+            // Free the memory if it has been previously allocated
+            release_shared_string(tls_io_instance->certificate);
+
+            // Store the certificate
+            tls_io_instance->certificate = create_shared_string(cert);
+            if (tls_io_instance->certificate == NULL)
+            {
+                LogError("unable to copy %s", optionName);
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+
+            // If we're previously connected then add the cert to the context, unless other instances use it too
+            if ((tls_io_instance->ssl_context != NULL) && !tls_io_instance->ssl_context_shared)
+            {
+                result = add_certificate_to_store(tls_io_instance->ssl_context, cert);
+            }
+            break;
+        }
+        case TLSIO_OPENSSL_OPTION_TRUSTED_CERT_FILE:
+        {
+#ifdef TLSIO_OPENSSL_SHARED_STORE_SUPPORTED
+            char* trusted_certs_file;
+
+            if (tls_io_instance->certificate != NULL)
+            {
+                LogError("%s cannot be set together with %s", optionName, OPTION_TRUSTED_CERT);
+                result = __FAILURE__;
+            }
+            else if (mallocAndStrcpy_s(&trusted_certs_file, (const char*)value) != 0)
+            {
+                LogError("unable to mallocAndStrcpy_s %s", optionName);
+                result = __FAILURE__;
+            }
+            else
+            {
+                // The file is loaded when the next SSL_CTX is created
+                free(tls_io_instance->trusted_certs_file);
+                tls_io_instance->trusted_certs_file = trusted_certs_file;
+                result = 0;
+            }
+#else
+            LogError("%s needs OpenSSL 1.1.0 or later", optionName);
+            result = __FAILURE__;
+#endif
+            break;
+        }
+        case TLSIO_OPENSSL_OPTION_CIPHER_SUITE:
+        {
+            if (tls_io_instance->cipher_list != NULL)
+            {
+                // Free the memory if it has been previously allocated
+                free(tls_io_instance->cipher_list);
+                tls_io_instance->cipher_list = NULL;
+            }
+
+            // Store the cipher suites
+            if (mallocAndStrcpy_s((char**)&tls_io_instance->cipher_list, value) != 0)
+            {
+                LogError("unable to mallocAndStrcpy_s %s", optionName);
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+            break;
+        }
+        case TLSIO_OPENSSL_OPTION_X509_CERT:
+        {
+            if (tls_io_instance->x509_certificate != NULL)
+            {
+                LogError("unable to set x509 options more than once");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /*let's make a copy of this option*/
+                if ((tls_io_instance->x509_certificate = create_shared_string((const char*)value)) == NULL)
+                {
+                    LogError("unable to copy %s", optionName);
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = 0;
+                }
+            }
+            break;
+        }
+        case TLSIO_OPENSSL_OPTION_X509_PRIVATE_KEY:
+        {
+            if (tls_io_instance->x509_private_key != NULL)
+            {
+                LogError("unable to set more than once x509 options");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /*let's make a copy of this option*/
+                if ((tls_io_instance->x509_private_key = create_shared_string((const char*)value)) == NULL)
+                {
+                    LogError("unable to copy %s", optionName);
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    result = 0;
+                }
+            }
+            break;
+        }
+        case TLSIO_OPENSSL_OPTION_X509_PRIVATE_KEY_TYPE:
+        {
+            if (value == NULL)
+            {
+                LogError("NULL value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else if ((*(const OPTION_OPENSSL_KEY_TYPE*)value != KEY_TYPE_DEFAULT) &&
+                (*(const OPTION_OPENSSL_KEY_TYPE*)value != KEY_TYPE_ENGINE) &&
+                (*(const OPTION_OPENSSL_KEY_TYPE*)value != KEY_TYPE_URI))
+            {
+                LogError("Invalid value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else
+            {
+                // Takes effect on the next handshake
+                tls_io_instance->x509_private_key_type = *(const OPTION_OPENSSL_KEY_TYPE*)value;
+                result = 0;
+            }
+            break;
+        }
+        case TLSIO_OPENSSL_OPTION_ENGINE:
+        {
+            if (value == NULL)
+            {
+                LogError("NULL value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else if (is_same_string(tls_io_instance->engine_id, (const char*)value))
+            {
+                // Options replayed on reconnect do not load the engine again
+                result = 0;
+            }
+            else if (load_engine(tls_io_instance, (const char*)value) != 0)
+            {
+                LogError("unable to load the engine of option %s", optionName);
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+            break;
+        }
+        case TLSIO_OPENSSL_OPTION_PROVIDER:
+        {
+            if (value == NULL)
+            {
+                LogError("NULL value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else if (is_same_string(tls_io_instance->provider_name, (const char*)value))
+            {
+                result = 0;
+            }
+            else if (load_provider(tls_io_instance, (const char*)value) != 0)
+            {
+                LogError("unable to load the provider of option %s", optionName);
+                result = __FAILURE__;
+            }
+            else
+            {
+                // Takes effect on the next handshake
+                result = 0;
+            }
+            break;
+        }
+        case TLSIO_OPENSSL_OPTION_TLS_VALIDATION_CALLBACK:
+        {
+#ifdef WIN32
+#pragma warning(push)
+#pragma warning(disable:4055)
+#endif // WIN32
+            tls_io_instance->tls_validation_callback = (TLS_CERTIFICATE_VALIDATION_CALLBACK)value;
+#ifdef WIN32
+#pragma warning(pop)
+#endif // WIN32
+
+            if ((tls_io_instance->ssl_context != NULL) && !tls_io_instance->ssl_context_shared)
+            {
+                SSL_CTX_set_cert_verify_callback(tls_io_instance->ssl_context, tls_io_instance->tls_validation_callback, tls_io_instance->tls_validation_callback_data);
+            }
+
+            result = 0;
+            break;
+        }
+        case TLSIO_OPENSSL_OPTION_TLS_VALIDATION_CALLBACK_DATA:
+        {
+            tls_io_instance->tls_validation_callback_data = (void*)value;
+
+            if ((tls_io_instance->ssl_context != NULL) && !tls_io_instance->ssl_context_shared)
+            {
+                SSL_CTX_set_cert_verify_callback(tls_io_instance->ssl_context, tls_io_instance->tls_validation_callback, tls_io_instance->tls_validation_callback_data);
+            }
+
+            result = 0;
+            break;
+        }
+        case TLSIO_OPENSSL_OPTION_TLS_VERSION:
+        {
+            if (tls_io_instance->ssl_context != NULL)
+            {
+                LogError("Unable to set the tls version after the tls connection is established");
+                result = __FAILURE__;
+            }
+            else
+            {
+                const int version_option = *(const int*)value;
+                if (version_option == 0 || version_option == 10)
+                {
+                    tls_io_instance->tls_version = VERSION_1_0;
+                }
+                else if (version_option == 11)
+                {
+                    tls_io_instance->tls_version = VERSION_1_1;
+                }
+                else if (version_option == 12)
+                {
+                    tls_io_instance->tls_version = VERSION_1_2;
+                }
+                else
+                {
+                    LogInfo("Value of TLS version option %d is not found shall default to version 1.2", version_option);
+                    tls_io_instance->tls_version = VERSION_1_2;
+                }
+                result = 0;
+            }
+            break;
+        }
+        case TLSIO_OPENSSL_OPTION_TLS_READ_CHUNK_SIZE:
+        {
+            if ((value == NULL) ||
+                (*(const size_t*)value == 0) ||
+                (*(const size_t*)value > INT_MAX))
+            {
+                LogError("Invalid value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else
+            {
+                tls_io_instance->read_chunk_size = *(const size_t*)value;
+                result = 0;
+            }
+            break;
+        }
+        case TLSIO_OPENSSL_OPTION_TLS_COALESCE_RECEIVED_BYTES:
+        {
+            if (value == NULL)
+            {
+                LogError("NULL value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else
+            {
+                if (!*(const bool*)value)
+                {
+                    // do not hold on to bytes that would otherwise only be indicated by a later dowork
+                    indicate_coalesced_received_bytes(tls_io_instance);
+                }
+
+                tls_io_instance->coalesce_received_bytes = *(const bool*)value;
+                result = 0;
+            }
+            break;
+        }
+        case TLSIO_OPENSSL_OPTION_TLS_CORK_SENDS:
+        {
+            if (value == NULL)
+            {
+                LogError("NULL value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else
+            {
+                tls_io_instance->cork_sends = *(const bool*)value;
+
+                if (!tls_io_instance->cork_sends && (tls_io_instance->tlsio_state == TLSIO_STATE_OPEN))
+                {
+                    // do not hold on to sends that would otherwise only be written by a later dowork
+                    flush_corked_sends_or_fail(tls_io_instance);
+                }
+                result = 0;
+            }
+            break;
+        }
+        case TLSIO_OPENSSL_OPTION_TLS_DYNAMIC_RECORD_SIZE:
+        {
+            if (value == NULL)
+            {
+                LogError("NULL value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else
+            {
+                tls_io_instance->dynamic_record_size = *(const bool*)value;
+                tls_io_instance->small_record_byte_count = 0;
+
+                if (!tls_io_instance->dynamic_record_size && (tls_io_instance->tlsio_state == TLSIO_STATE_OPEN))
+                {
+                    // the next records are full sized again
+                    set_send_fragment_size(tls_io_instance, DYNAMIC_RECORD_FULL_SIZE);
+                }
+                result = 0;
+            }
+            break;
+        }
+        case TLSIO_OPENSSL_OPTION_TLS_KTLS:
+        {
+            if (value == NULL)
+            {
+                LogError("NULL value for option %s", optionName);
+                result = __FAILURE__;
+            }
+#ifndef TLSIO_OPENSSL_KTLS_SUPPORTED
+            else if (*(const bool*)value)
+            {
+                LogError("Kernel TLS is not supported by this platform or OpenSSL version");
+                result = __FAILURE__;
             }
-
-            // Store the certificate
-            len = strlen(cert);
-            tls_io_instance->certificate = malloc(len + 1);
-            if (tls_io_instance->certificate == NULL)
+#endif
+            else if (tls_io_instance->tlsio_state != TLSIO_STATE_NOT_OPEN)
             {
+                LogError("Option %s can only be changed while not open", optionName);
                 result = __FAILURE__;
             }
             else
             {
-                strcpy(tls_io_instance->certificate, cert);
+                tls_io_instance->use_ktls = *(const bool*)value;
                 result = 0;
             }
-
-            // If we're previously connected then add the cert to the context
-            if (tls_io_instance->ssl_context != NULL)
-            {
-                result = add_certificate_to_store(tls_io_instance, cert);
-            }
+            break;
         }
-        else if (strcmp(OPTION_OPENSSL_CIPHER_SUITE, optionName) == 0)
+        case TLSIO_OPENSSL_OPTION_TLS_SHARED_CONTEXT:
         {
-            if (tls_io_instance->cipher_list != NULL)
+            if (value == NULL)
             {
-                // Free the memory if it has been previously allocated
-                free(tls_io_instance->cipher_list);
-                tls_io_instance->cipher_list = NULL;
+                LogError("NULL value for option %s", optionName);
+                result = __FAILURE__;
             }
-
-            // Store the cipher suites
-            if (mallocAndStrcpy_s((char**)&tls_io_instance->cipher_list, value) != 0)
+            else if (*(const bool*)value && (context_cache_lock == NULL))
             {
-                LogError("unable to mallocAndStrcpy_s %s", optionName);
+                LogError("The shared TLS contexts are not available, tlsio_openssl_init was not called");
+                result = __FAILURE__;
+            }
+            else if (tls_io_instance->tlsio_state != TLSIO_STATE_NOT_OPEN)
+            {
+                LogError("Option %s can only be changed while not open", optionName);
                 result = __FAILURE__;
             }
             else
             {
+                tls_io_instance->use_shared_context = *(const bool*)value;
                 result = 0;
             }
+            break;
         }
-        else if (strcmp(SU_OPTION_X509_CERT, optionName) == 0 || strcmp(OPTION_X509_ECC_CERT, optionName) == 0)
+        case TLSIO_OPENSSL_OPTION_TLS_SESSION_CACHE:
         {
-            if (tls_io_instance->x509_certificate != NULL)
+            if (value == NULL)
             {
-                LogError("unable to set x509 options more than once");
+                LogError("NULL value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else if (*(const bool*)value && ((session_cache_lock == NULL) || (tls_io_instance->hostname == NULL)))
+            {
+                LogError("The TLS session cache is not available, either tlsio_openssl_init was not called or no hostname was given");
                 result = __FAILURE__;
             }
             else
             {
-                /*let's make a copy of this option*/
-                if (mallocAndStrcpy_s((char**)&tls_io_instance->x509_certificate, value) != 0)
-                {
-                    LogError("unable to mallocAndStrcpy_s %s", optionName);
-                    result = __FAILURE__;
-                }
-                else
-                {
-                    result = 0;
-                }
+                // Takes effect on the next handshake
+                tls_io_instance->use_session_cache = *(const bool*)value;
+                result = 0;
             }
+            break;
         }
-        else if (strcmp(SU_OPTION_X509_PRIVATE_KEY, optionName) == 0 || strcmp(OPTION_X509_ECC_KEY, optionName) == 0)
+        case TLSIO_OPENSSL_OPTION_TLS_EARLY_DATA:
         {
-            if (tls_io_instance->x509_private_key != NULL)
+            if (value == NULL)
             {
-                LogError("unable to set more than once x509 options");
+                LogError("NULL value for option %s", optionName);
                 result = __FAILURE__;
             }
-            else
+#ifndef TLSIO_OPENSSL_EARLY_DATA_SUPPORTED
+            else if (*(const bool*)value)
             {
-                /*let's make a copy of this option*/
-                if (mallocAndStrcpy_s((char**)&tls_io_instance->x509_private_key, value) != 0)
-                {
-                    LogError("unable to mallocAndStrcpy_s %s", optionName);
-                    result = __FAILURE__;
-                }
-                else
-                {
-                    result = 0;
-                }
+                LogError("TLS 1.3 early data is not supported by this OpenSSL version");
+                result = __FAILURE__;
             }
-        }
-        else if (strcmp("tls_validation_callback", optionName) == 0)
-        {
-#ifdef WIN32
-#pragma warning(push)
-#pragma warning(disable:4055)
-#endif // WIN32
-            tls_io_instance->tls_validation_callback = (TLS_CERTIFICATE_VALIDATION_CALLBACK)value;
-#ifdef WIN32
-#pragma warning(pop)
-#endif // WIN32
-
-            if (tls_io_instance->ssl_context != NULL)
+#endif
+            else
             {
-                SSL_CTX_set_cert_verify_callback(tls_io_instance->ssl_context, tls_io_instance->tls_validation_callback, tls_io_instance->tls_validation_callback_data);
+                // Takes effect on the next handshake
+                tls_io_instance->use_early_data = *(const bool*)value;
+                result = 0;
             }
-
-            result = 0;
+            break;
         }
-        else if (strcmp("tls_validation_callback_data", optionName) == 0)
+        case TLSIO_OPENSSL_OPTION_TLS_ALPN:
         {
-            tls_io_instance->tls_validation_callback_data = (void*)value;
-
-            if (tls_io_instance->ssl_context != NULL)
+            if (value == NULL)
             {
-                SSL_CTX_set_cert_verify_callback(tls_io_instance->ssl_context, tls_io_instance->tls_validation_callback, tls_io_instance->tls_validation_callback_data);
+                LogError("NULL value for option %s", optionName);
+                result = __FAILURE__;
             }
-
-            result = 0;
-        }
-        else if (strcmp(OPTION_TLS_VERSION, optionName) == 0)
-        {
-            if (tls_io_instance->ssl_context != NULL)
+            else if (!is_valid_alpn((const char*)value))
             {
-                LogError("Unable to set the tls version after the tls connection is established");
+                LogError("Invalid value for option %s, expected a comma separated list of protocols of 1 to 255 characters", optionName);
                 result = __FAILURE__;
             }
             else
             {
-                const int version_option = *(const int*)value;
-                if (version_option == 0 || version_option == 10)
-                {
-                    tls_io_instance->tls_version = VERSION_1_0;
-                }
-                else if (version_option == 11)
+                if (tls_io_instance->alpn != NULL)
                 {
-                    tls_io_instance->tls_version = VERSION_1_1;
+                    free(tls_io_instance->alpn);
+                    tls_io_instance->alpn = NULL;
                 }
-                else if (version_option == 12)
+
+                // Takes effect on the next handshake
+                if (mallocAndStrcpy_s(&tls_io_instance->alpn, (const char*)value) != 0)
                 {
-                    tls_io_instance->tls_version = VERSION_1_2;
+                    LogError("unable to mallocAndStrcpy_s %s", optionName);
+                    result = __FAILURE__;
                 }
                 else
                 {
-                    LogInfo("Value of TLS version option %d is not found shall default to version 1.2", version_option);
-                    tls_io_instance->tls_version = VERSION_1_2;
+                    result = 0;
                 }
+            }
+            break;
+        }
+        case TLSIO_OPENSSL_OPTION_TLS_GROUPS:
+        case TLSIO_OPENSSL_OPTION_TLS_SIGNATURE_ALGORITHMS:
+        {
+            // Takes effect on the next handshake
+            if (tlsio_options_set(&tls_io_instance->tls_options, optionName, value) != TLSIO_OPTIONS_RESULT_SUCCESS)
+            {
+                LogError("Invalid value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else
+            {
                 result = 0;
             }
+            break;
+        }
+        case TLSIO_OPENSSL_OPTION_TLS_HANDSHAKE_THREADPOOL:
+        {
+            // Takes effect on the next handshake step, a step already on the pool runs to its end
+            tls_io_instance->handshake_threadpool = (THREADPOOL_HANDLE)value;
+            result = 0;
+            break;
         }
-        else if (strcmp(optionName, OPTION_UNDERLYING_IO_OPTIONS) == 0)
+        case TLSIO_OPENSSL_OPTION_UNDERLYING_IO_OPTIONS:
         {
             if (OptionHandler_FeedOptions((OPTIONHANDLER_HANDLE)value, (void*)tls_io_instance->underlying_io) != OPTIONHANDLER_OK)
             {
@@ -1610,12 +5306,14 @@ int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
             {
                 result = 0;
             }
+            break;
         }
-        else if (strcmp("ignore_server_name_check", optionName) == 0)
+        case TLSIO_OPENSSL_OPTION_IGNORE_SERVER_NAME_CHECK:
         {
             result = 0;
+            break;
         }
-        else
+        default:
         {
             if (tls_io_instance->underlying_io == NULL)
             {
@@ -1625,12 +5323,272 @@ int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
             {
                 result = xio_setoption(tls_io_instance->underlying_io, optionName, value);
             }
+            break;
+        }
+        }
+    }
+
+    return result;
+}
+
+int tlsio_openssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, const void* value)
+{
+    int result;
+
+    if (tls_io == NULL || optionName == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = tlsio_openssl_setoption_by_key(tls_io, tlsio_openssl_get_option_key(optionName), optionName, value);
+    }
+
+    return result;
+}
+
+int tlsio_openssl_get_session_cache_stats(TLSIO_OPENSSL_SESSION_CACHE_STATS* stats)
+{
+    int result;
+
+    if (stats == NULL)
+    {
+        LogError("NULL stats.");
+        result = __FAILURE__;
+    }
+    else if (session_cache_lock == NULL)
+    {
+        LogError("The TLS session cache is not available.");
+        result = __FAILURE__;
+    }
+    else if (Lock(session_cache_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the TLS session cache.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        *stats = session_cache_stats;
+        (void)Unlock(session_cache_lock);
+        result = 0;
+    }
+
+    return result;
+}
+
+typedef enum TLSIO_OPENSSL_BATCH_ENTRY_STATE_TAG
+{
+    TLSIO_OPENSSL_BATCH_ENTRY_WAITING,
+    TLSIO_OPENSSL_BATCH_ENTRY_OPENING,
+    TLSIO_OPENSSL_BATCH_ENTRY_DONE
+} TLSIO_OPENSSL_BATCH_ENTRY_STATE;
+
+typedef struct TLSIO_OPENSSL_BATCH_ENTRY_INSTANCE_TAG
+{
+    struct TLSIO_OPENSSL_BATCH_TAG* batch;
+    TLSIO_OPENSSL_BATCH_ENTRY entry;
+    TLSIO_OPENSSL_BATCH_ENTRY_STATE state;
+} TLSIO_OPENSSL_BATCH_ENTRY_INSTANCE;
+
+typedef struct TLSIO_OPENSSL_BATCH_TAG
+{
+    TLSIO_OPENSSL_BATCH_ENTRY_INSTANCE* entries;
+    size_t entry_count;
+    // the entries before next_entry have been opened, opening_count of them are still opening
+    size_t next_entry;
+    size_t opening_count;
+    size_t completed_count;
+    size_t max_concurrent_opens;
+    THREADPOOL_HANDLE handshake_threadpool;
+    ON_TLSIO_OPENSSL_BATCH_OPEN_COMPLETE on_open_complete;
+    void* on_open_complete_context;
+} TLSIO_OPENSSL_BATCH;
+
+static void complete_batch_entry(TLSIO_OPENSSL_BATCH_ENTRY_INSTANCE* entry_instance, IO_OPEN_RESULT open_result)
+{
+    TLSIO_OPENSSL_BATCH* batch = entry_instance->batch;
+
+    if (entry_instance->state == TLSIO_OPENSSL_BATCH_ENTRY_OPENING)
+    {
+        batch->opening_count--;
+    }
+    entry_instance->state = TLSIO_OPENSSL_BATCH_ENTRY_DONE;
+    batch->completed_count++;
+
+    if (batch->on_open_complete != NULL)
+    {
+        batch->on_open_complete(batch->on_open_complete_context, (size_t)(entry_instance - batch->entries), open_result);
+    }
+}
+
+static void on_batch_entry_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    TLSIO_OPENSSL_BATCH_ENTRY_INSTANCE* entry_instance = (TLSIO_OPENSSL_BATCH_ENTRY_INSTANCE*)context;
+
+    if (entry_instance->state == TLSIO_OPENSSL_BATCH_ENTRY_OPENING)
+    {
+        complete_batch_entry(entry_instance, open_result);
+    }
+}
+
+// Opens the next entries until max_concurrent_opens of them are opening
+static void start_batch_opens(TLSIO_OPENSSL_BATCH* batch)
+{
+    static const bool use_shared_context = true;
+
+    while ((batch->next_entry < batch->entry_count) &&
+        ((batch->max_concurrent_opens == 0) || (batch->opening_count < batch->max_concurrent_opens)))
+    {
+        TLSIO_OPENSSL_BATCH_ENTRY_INSTANCE* entry_instance = &batch->entries[batch->next_entry];
+        batch->next_entry++;
+
+        // without one of the two the IO still opens, only slower
+        if (xio_setoption(entry_instance->entry.tls_io, OPTION_TLS_SHARED_CONTEXT, &use_shared_context) != 0)
+        {
+            LogInfo("Opening batch entry %lu without a shared TLS context.", (unsigned long)(batch->next_entry - 1));
+        }
+        if ((batch->handshake_threadpool != NULL) &&
+            (xio_setoption(entry_instance->entry.tls_io, OPTION_TLS_HANDSHAKE_THREADPOOL, batch->handshake_threadpool) != 0))
+        {
+            LogInfo("Opening batch entry %lu with its handshake on the IO thread.", (unsigned long)(batch->next_entry - 1));
+        }
+
+        entry_instance->state = TLSIO_OPENSSL_BATCH_ENTRY_OPENING;
+        batch->opening_count++;
+
+        if (xio_open(entry_instance->entry.tls_io, on_batch_entry_open_complete, entry_instance,
+            entry_instance->entry.on_bytes_received, entry_instance->entry.on_bytes_received_context,
+            entry_instance->entry.on_io_error, entry_instance->entry.on_io_error_context) != 0)
+        {
+            LogError("Failed opening batch entry %lu.", (unsigned long)(batch->next_entry - 1));
+            if (entry_instance->state == TLSIO_OPENSSL_BATCH_ENTRY_OPENING)
+            {
+                complete_batch_entry(entry_instance, IO_OPEN_ERROR);
+            }
+        }
+    }
+}
+
+TLSIO_OPENSSL_BATCH_HANDLE tlsio_openssl_open_batch(const TLSIO_OPENSSL_BATCH_ENTRY* entries, size_t entry_count, THREADPOOL_HANDLE handshake_threadpool, size_t max_concurrent_opens, ON_TLSIO_OPENSSL_BATCH_OPEN_COMPLETE on_open_complete, void* on_open_complete_context)
+{
+    TLSIO_OPENSSL_BATCH* result;
+
+    if ((entries == NULL) || (entry_count == 0) || (on_open_complete == NULL))
+    {
+        LogError("Invalid arguments: entries = %p, entry_count = %lu, on_open_complete is %s.", entries, (unsigned long)entry_count, (on_open_complete == NULL) ? "NULL" : "set");
+        result = NULL;
+    }
+    else if (entry_count > ((size_t)-1) / sizeof(TLSIO_OPENSSL_BATCH_ENTRY_INSTANCE))
+    {
+        LogError("Too many entries: %lu.", (unsigned long)entry_count);
+        result = NULL;
+    }
+    else if ((result = (TLSIO_OPENSSL_BATCH*)malloc(sizeof(TLSIO_OPENSSL_BATCH))) == NULL)
+    {
+        LogError("Failed allocating the batch.");
+    }
+    else if ((result->entries = (TLSIO_OPENSSL_BATCH_ENTRY_INSTANCE*)malloc(entry_count * sizeof(TLSIO_OPENSSL_BATCH_ENTRY_INSTANCE))) == NULL)
+    {
+        LogError("Failed allocating the %lu batch entries.", (unsigned long)entry_count);
+        free(result);
+        result = NULL;
+    }
+    else
+    {
+        size_t i;
+
+        for (i = 0; i < entry_count; i++)
+        {
+            result->entries[i].batch = result;
+            result->entries[i].entry = entries[i];
+            result->entries[i].state = TLSIO_OPENSSL_BATCH_ENTRY_WAITING;
+        }
+
+        result->entry_count = entry_count;
+        result->next_entry = 0;
+        result->opening_count = 0;
+        result->completed_count = 0;
+        result->max_concurrent_opens = max_concurrent_opens;
+        result->handshake_threadpool = handshake_threadpool;
+        result->on_open_complete = on_open_complete;
+        result->on_open_complete_context = on_open_complete_context;
+
+        start_batch_opens(result);
+    }
+
+    return result;
+}
+
+int tlsio_openssl_batch_dowork(TLSIO_OPENSSL_BATCH_HANDLE batch, bool* is_complete)
+{
+    int result;
+
+    if (batch == NULL)
+    {
+        LogError("NULL batch.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+
+        // the entries completing here make room for the next ones, started after the pass
+        for (i = 0; i < batch->next_entry; i++)
+        {
+            if (batch->entries[i].state == TLSIO_OPENSSL_BATCH_ENTRY_OPENING)
+            {
+                xio_dowork(batch->entries[i].entry.tls_io);
+            }
+        }
+
+        start_batch_opens(batch);
+
+        if (is_complete != NULL)
+        {
+            *is_complete = (batch->completed_count == batch->entry_count);
         }
+        result = 0;
     }
 
     return result;
 }
 
+void tlsio_openssl_batch_destroy(TLSIO_OPENSSL_BATCH_HANDLE batch)
+{
+    if (batch == NULL)
+    {
+        LogError("NULL batch.");
+    }
+    else
+    {
+        size_t i;
+
+        // no open is started from here on, the ones running are cancelled by their close
+        batch->next_entry = batch->entry_count;
+
+        for (i = 0; i < batch->entry_count; i++)
+        {
+            TLSIO_OPENSSL_BATCH_ENTRY_INSTANCE* entry_instance = &batch->entries[i];
+
+            if (entry_instance->state == TLSIO_OPENSSL_BATCH_ENTRY_OPENING)
+            {
+                (void)xio_close(entry_instance->entry.tls_io, NULL, NULL);
+                if (entry_instance->state == TLSIO_OPENSSL_BATCH_ENTRY_OPENING)
+                {
+                    complete_batch_entry(entry_instance, IO_OPEN_CANCELLED);
+                }
+            }
+            else if (entry_instance->state == TLSIO_OPENSSL_BATCH_ENTRY_WAITING)
+            {
+                complete_batch_entry(entry_instance, IO_OPEN_CANCELLED);
+            }
+        }
+
+        free(batch->entries);
+        free(batch);
+    }
+}
+
 const IO_INTERFACE_DESCRIPTION* tlsio_openssl_get_interface_description(void)
 {
     return &tlsio_openssl_interface_description;
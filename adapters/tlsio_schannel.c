@@ -24,7 +24,8 @@
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/x509_schannel.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
-#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/doublylinkedlist.h"
 #include "azure_c_shared_utility/shared_util_options.h"
 #include "azure_c_shared_utility/gballoc.h"
 
@@ -43,12 +44,32 @@ DEFINE_ENUM_STRINGS(TLSIO_STATE, TLSIO_STATE_VALUES);
 
 typedef struct PENDING_SEND_TAG
 {
+    DLIST_ENTRY link;
     unsigned char* bytes;
     size_t length;
     ON_SEND_COMPLETE on_send_complete;
     void* on_send_complete_context;
 } PENDING_SEND;
 
+/* A credential handle shared by the instances with the same client certificate and validation flags. Schannel keys
+   its session cache on the credential handle, so sharing it lets a new connection to the same host resume the TLS
+   session of a previous one instead of doing a full handshake, and loads the client certificate once. */
+typedef struct TLS_CREDENTIAL_CACHE_ENTRY_TAG
+{
+    char* x509certificate;
+    char* x509privatekey;
+    bool ignore_server_name_check;
+    bool manual_cred_validation;
+    X509_SCHANNEL_HANDLE x509_schannel_handle;
+    CredHandle credential_handle;
+    bool credential_handle_allocated;
+    size_t ref_count;
+    struct TLS_CREDENTIAL_CACHE_ENTRY_TAG* next;
+} TLS_CREDENTIAL_CACHE_ENTRY;
+
+static LOCK_HANDLE credential_cache_lock = NULL;
+static TLS_CREDENTIAL_CACHE_ENTRY* credential_cache_entries = NULL;
+
 typedef struct TLS_IO_INSTANCE_TAG
 {
     XIO_HANDLE socket_io;
@@ -65,15 +86,23 @@ typedef struct TLS_IO_INSTANCE_TAG
     SEC_TCHAR* host_name;
     CredHandle credential_handle;
     bool credential_handle_allocated;
+    /* the cache entry credential_handle was copied from, NULL when the instance owns credential_handle */
+    TLS_CREDENTIAL_CACHE_ENTRY* credential_cache_entry;
     bool ignore_server_name_check;
     unsigned char* received_bytes;
     size_t received_byte_count;
     size_t buffer_size;
     size_t needed_bytes;
+    /* records are encrypted in place into send_buffer, which has room for the largest record
+       (header, message and trailer as given by the stream sizes of the context) */
+    SecPkgContext_StreamSizes stream_sizes;
+    bool stream_sizes_valid;
+    unsigned char* send_buffer;
+    size_t send_buffer_size;
     char* x509certificate;
     char* x509privatekey;
     X509_SCHANNEL_HANDLE x509_schannel_handle;
-    SINGLYLINKEDLIST_HANDLE pending_io_list;
+    DLIST_ENTRY pending_io_list;
     // Certificate to check server certificate chains to, overriding built-in Windows certificate store certificates.
     char* trustedCertificate;
 } TLS_IO_INSTANCE;
@@ -231,7 +260,13 @@ static const IO_INTERFACE_DESCRIPTION tlsio_schannel_interface_description =
     tlsio_schannel_close,
     tlsio_schannel_send,
     tlsio_schannel_dowork,
-    tlsio_schannel_setoption
+    tlsio_schannel_setoption,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
 };
 
 static void indicate_error(TLS_IO_INSTANCE* tls_io_instance)
@@ -269,47 +304,14 @@ static int resize_receive_buffer(TLS_IO_INSTANCE* tls_io_instance, size_t needed
     return result;
 }
 
-static void on_underlying_io_close_complete(void* context)
-{
-    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
-    if (tls_io_instance->tlsio_state == TLSIO_STATE_CLOSING)
-    {
-        tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
-        if (tls_io_instance->on_io_close_complete != NULL)
-        {
-            tls_io_instance->on_io_close_complete(tls_io_instance->on_io_close_complete_context);
-        }
-
-        /* Free security context resources corresponding to creation with open */
-        DeleteSecurityContext(&tls_io_instance->security_context);
-
-        if (tls_io_instance->credential_handle_allocated)
-        {
-            (void)FreeCredentialHandle(&tls_io_instance->credential_handle);
-            tls_io_instance->credential_handle_allocated = false;
-        }
-    }
-}
-
-// This callback usage needs to be either verified and commented or integrated into
-// the state machine.
-static void unchecked_on_send_complete(void* context, IO_SEND_RESULT send_result)
-{
-    (void)context;
-    (void)send_result;
-}
-
-static void send_client_hello(TLS_IO_INSTANCE* tls_io_instance)
+static SECURITY_STATUS acquire_credentials_handle(X509_SCHANNEL_HANDLE x509_schannel_handle, bool ignore_server_name_check, bool manual_cred_validation, CredHandle* credential_handle)
 {
-    SecBuffer init_security_buffers[2];
-    ULONG context_attributes;
-    SECURITY_STATUS status;
     SCHANNEL_CRED auth_data;
     PCCERT_CONTEXT certContext;
     auth_data.dwVersion = SCHANNEL_CRED_VERSION;
-    if (tls_io_instance->x509_schannel_handle != NULL)
+    if (x509_schannel_handle != NULL)
     {
-        certContext = x509_schannel_get_certificate_context(tls_io_instance->x509_schannel_handle);
+        certContext = x509_schannel_get_certificate_context(x509_schannel_handle);
         auth_data.cCreds = 1;
         auth_data.paCred = &certContext;
     }
@@ -330,13 +332,13 @@ static void send_client_hello(TLS_IO_INSTANCE* tls_io_instance)
 #else
     auth_data.dwFlags = SCH_CRED_NO_DEFAULT_CREDS;
 #endif
-    if (tls_io_instance->ignore_server_name_check)
+    if (ignore_server_name_check)
     {
         auth_data.dwFlags |= SCH_CRED_NO_SERVERNAME_CHECK;
     }
     auth_data.dwCredFormat = 0;
 
-    if (tls_io_instance->trustedCertificate != NULL)
+    if (manual_cred_validation)
     {
         // SCH_CRED_MANUAL_CRED_VALIDATION flag signals to schannel to NOT use
         // the Windows certificate store, but instead have application verify
@@ -344,9 +346,228 @@ static void send_client_hello(TLS_IO_INSTANCE* tls_io_instance)
         auth_data.dwFlags |= SCH_CRED_MANUAL_CRED_VALIDATION;
     }
 
-    status = AcquireCredentialsHandle(NULL, UNISP_NAME, SECPKG_CRED_OUTBOUND, NULL,
-        &auth_data, NULL, NULL, &tls_io_instance->credential_handle, NULL);
-    if (status != SEC_E_OK)
+    return AcquireCredentialsHandle(NULL, UNISP_NAME, SECPKG_CRED_OUTBOUND, NULL,
+        &auth_data, NULL, NULL, credential_handle, NULL);
+}
+
+static bool is_same_string(const char* a, const char* b)
+{
+    return (a == NULL) ? (b == NULL) : ((b != NULL) && (strcmp(a, b) == 0));
+}
+
+static void free_credential_cache_entry(TLS_CREDENTIAL_CACHE_ENTRY* entry)
+{
+    if (entry->credential_handle_allocated)
+    {
+        (void)FreeCredentialHandle(&entry->credential_handle);
+    }
+
+    if (entry->x509_schannel_handle != NULL)
+    {
+        x509_schannel_destroy(entry->x509_schannel_handle);
+    }
+
+    free(entry->x509certificate);
+    free(entry->x509privatekey);
+    free(entry);
+}
+
+// Must be called with credential_cache_lock held
+static TLS_CREDENTIAL_CACHE_ENTRY* find_credential_cache_entry(TLS_IO_INSTANCE* tls_io_instance)
+{
+    TLS_CREDENTIAL_CACHE_ENTRY* entry = credential_cache_entries;
+
+    while ((entry != NULL) &&
+        ((entry->ignore_server_name_check != tls_io_instance->ignore_server_name_check) ||
+         (entry->manual_cred_validation != (tls_io_instance->trustedCertificate != NULL)) ||
+         (!is_same_string(entry->x509certificate, tls_io_instance->x509certificate)) ||
+         (!is_same_string(entry->x509privatekey, tls_io_instance->x509privatekey))))
+    {
+        entry = entry->next;
+    }
+
+    return entry;
+}
+
+static int acquire_shared_credentials(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result;
+
+    if (Lock(credential_cache_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the credential cache.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        TLS_CREDENTIAL_CACHE_ENTRY* entry = find_credential_cache_entry(tls_io_instance);
+
+        if (entry != NULL)
+        {
+            entry->ref_count++;
+            result = 0;
+        }
+        else if ((entry = (TLS_CREDENTIAL_CACHE_ENTRY*)malloc(sizeof(TLS_CREDENTIAL_CACHE_ENTRY))) == NULL)
+        {
+            LogError("Failed allocating the credential cache entry.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            SECURITY_STATUS status;
+
+            (void)memset(entry, 0, sizeof(TLS_CREDENTIAL_CACHE_ENTRY));
+            entry->ignore_server_name_check = tls_io_instance->ignore_server_name_check;
+            entry->manual_cred_validation = (tls_io_instance->trustedCertificate != NULL);
+
+            if (((tls_io_instance->x509certificate != NULL) && (mallocAndStrcpy_s(&entry->x509certificate, tls_io_instance->x509certificate) != 0)) ||
+                ((tls_io_instance->x509privatekey != NULL) && (mallocAndStrcpy_s(&entry->x509privatekey, tls_io_instance->x509privatekey) != 0)))
+            {
+                LogError("Failed copying the credential cache key.");
+                free_credential_cache_entry(entry);
+                entry = NULL;
+                result = __FAILURE__;
+            }
+            else if ((entry->x509certificate != NULL) && (entry->x509privatekey != NULL) &&
+                ((entry->x509_schannel_handle = x509_schannel_create(entry->x509certificate, entry->x509privatekey)) == NULL))
+            {
+                LogError("x509_schannel_create failed");
+                free_credential_cache_entry(entry);
+                entry = NULL;
+                result = __FAILURE__;
+            }
+            else if ((status = acquire_credentials_handle(entry->x509_schannel_handle, entry->ignore_server_name_check, entry->manual_cred_validation, &entry->credential_handle)) != SEC_E_OK)
+            {
+                LogError("AcquireCredentialsHandle failed: 0x%lx", (unsigned long)status);
+                free_credential_cache_entry(entry);
+                entry = NULL;
+                result = __FAILURE__;
+            }
+            else
+            {
+                entry->credential_handle_allocated = true;
+                entry->ref_count = 1;
+                entry->next = credential_cache_entries;
+                credential_cache_entries = entry;
+                result = 0;
+            }
+        }
+
+        if (result == 0)
+        {
+            tls_io_instance->credential_handle = entry->credential_handle;
+            tls_io_instance->credential_cache_entry = entry;
+        }
+
+        (void)Unlock(credential_cache_lock);
+    }
+
+    return result;
+}
+
+static void release_credentials(TLS_IO_INSTANCE* tls_io_instance)
+{
+    if (tls_io_instance->credential_cache_entry != NULL)
+    {
+        if (Lock(credential_cache_lock) != LOCK_OK)
+        {
+            // Leaks the reference rather than freeing a handle other instances may still use
+            LogError("Failed to lock the credential cache.");
+        }
+        else
+        {
+            TLS_CREDENTIAL_CACHE_ENTRY** entry = &credential_cache_entries;
+
+            while ((*entry != NULL) && (*entry != tls_io_instance->credential_cache_entry))
+            {
+                entry = &(*entry)->next;
+            }
+
+            if (*entry == NULL)
+            {
+                LogError("The shared credential handle is not in the cache.");
+            }
+            else if (--(*entry)->ref_count == 0)
+            {
+                TLS_CREDENTIAL_CACHE_ENTRY* unused_entry = *entry;
+                *entry = unused_entry->next;
+                free_credential_cache_entry(unused_entry);
+            }
+
+            (void)Unlock(credential_cache_lock);
+        }
+
+        tls_io_instance->credential_cache_entry = NULL;
+    }
+    else if (tls_io_instance->credential_handle_allocated)
+    {
+        (void)FreeCredentialHandle(&tls_io_instance->credential_handle);
+        tls_io_instance->credential_handle_allocated = false;
+    }
+}
+
+static int acquire_credentials(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result;
+
+    /* an open after an error did not go through the close that releases them */
+    release_credentials(tls_io_instance);
+
+    if (credential_cache_lock != NULL)
+    {
+        result = acquire_shared_credentials(tls_io_instance);
+    }
+    else
+    {
+        SECURITY_STATUS status = acquire_credentials_handle(tls_io_instance->x509_schannel_handle, tls_io_instance->ignore_server_name_check, (tls_io_instance->trustedCertificate != NULL), &tls_io_instance->credential_handle);
+        if (status != SEC_E_OK)
+        {
+            LogError("AcquireCredentialsHandle failed: 0x%lx", (unsigned long)status);
+            result = __FAILURE__;
+        }
+        else
+        {
+            tls_io_instance->credential_handle_allocated = true;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void on_underlying_io_close_complete(void* context)
+{
+    TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
+    if (tls_io_instance->tlsio_state == TLSIO_STATE_CLOSING)
+    {
+        tls_io_instance->tlsio_state = TLSIO_STATE_NOT_OPEN;
+        if (tls_io_instance->on_io_close_complete != NULL)
+        {
+            tls_io_instance->on_io_close_complete(tls_io_instance->on_io_close_complete_context);
+        }
+
+        /* Free security context resources corresponding to creation with open */
+        DeleteSecurityContext(&tls_io_instance->security_context);
+
+        release_credentials(tls_io_instance);
+    }
+}
+
+// This callback usage needs to be either verified and commented or integrated into
+// the state machine.
+static void unchecked_on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    (void)context;
+    (void)send_result;
+}
+
+static void send_client_hello(TLS_IO_INSTANCE* tls_io_instance)
+{
+    SecBuffer init_security_buffers[2];
+    ULONG context_attributes;
+    SECURITY_STATUS status;
+
+    if (acquire_credentials(tls_io_instance) != 0)
     {
         tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
         indicate_error(tls_io_instance);
@@ -354,7 +575,6 @@ static void send_client_hello(TLS_IO_INSTANCE* tls_io_instance)
     else
     {
         SecBufferDesc security_buffers_desc;
-        tls_io_instance->credential_handle_allocated = true;
 
         init_security_buffers[0].cbBuffer = 0;
         init_security_buffers[0].BufferType = SECBUFFER_TOKEN;
@@ -461,21 +681,48 @@ static int verify_custom_certificate_if_needed(TLS_IO_INSTANCE* tls_io_instance)
     return result;    
 }
 
-static int set_receive_buffer(TLS_IO_INSTANCE* tls_io_instance, size_t buffer_size)
+/* queries the stream sizes of a freshly negotiated context and sizes the send and receive buffers for a full record */
+static int update_stream_sizes(TLS_IO_INSTANCE* tls_io_instance)
 {
     int result;
+    SECURITY_STATUS status = QueryContextAttributes(&tls_io_instance->security_context, SECPKG_ATTR_STREAM_SIZES, &tls_io_instance->stream_sizes);
 
-    unsigned char* new_buffer = (unsigned char*) realloc(tls_io_instance->received_bytes, buffer_size);
-    if (new_buffer == NULL)
+    if (status != SEC_E_OK)
     {
-        LogError("realloc failed");
+        LogError("QueryContextAttributes failed: %x", status);
+        tls_io_instance->stream_sizes_valid = false;
         result = __FAILURE__;
     }
     else
     {
-        tls_io_instance->received_bytes = new_buffer;
-        tls_io_instance->buffer_size = buffer_size;
-        result = 0;
+        size_t record_size = (size_t)tls_io_instance->stream_sizes.cbHeader + tls_io_instance->stream_sizes.cbMaximumMessage + tls_io_instance->stream_sizes.cbTrailer;
+
+        if (record_size > tls_io_instance->send_buffer_size)
+        {
+            unsigned char* new_buffer = (unsigned char*)realloc(tls_io_instance->send_buffer, record_size);
+            if (new_buffer == NULL)
+            {
+                LogError("realloc failed");
+                result = __FAILURE__;
+            }
+            else
+            {
+                tls_io_instance->send_buffer = new_buffer;
+                tls_io_instance->send_buffer_size = record_size;
+                result = 0;
+            }
+        }
+        else
+        {
+            result = 0;
+        }
+
+        if ((result == 0) && (resize_receive_buffer(tls_io_instance, record_size) != 0))
+        {
+            result = __FAILURE__;
+        }
+
+        tls_io_instance->stream_sizes_valid = (result == 0);
     }
 
     return result;
@@ -502,65 +749,58 @@ static int send_chunk(CONCRETE_IO_HANDLE tls_io, const void* buffer, size_t size
         }
         else
         {
-            SecPkgContext_StreamSizes  sizes;
-            SECURITY_STATUS status = QueryContextAttributes(&tls_io_instance->security_context, SECPKG_ATTR_STREAM_SIZES, &sizes);
-            if (status != SEC_E_OK)
+            if (!tls_io_instance->stream_sizes_valid && (update_stream_sizes(tls_io_instance) != 0))
             {
-                LogError("QueryContextAttributes failed: %x", status);
+                LogError("update_stream_sizes failed");
+                result = __FAILURE__;
+            }
+            else if (size > tls_io_instance->stream_sizes.cbMaximumMessage)
+            {
+                LogError("chunk of %lu bytes is larger than the maximum message size %lu", (unsigned long)size, (unsigned long)tls_io_instance->stream_sizes.cbMaximumMessage);
                 result = __FAILURE__;
             }
             else
             {
                 SecBuffer security_buffers[4];
                 SecBufferDesc security_buffers_desc;
-                size_t needed_buffer = sizes.cbHeader + size + sizes.cbTrailer;
-                unsigned char* out_buffer = (unsigned char*)malloc(needed_buffer);
-                if (out_buffer == NULL)
+                SECURITY_STATUS status;
+                const SecPkgContext_StreamSizes* sizes = &tls_io_instance->stream_sizes;
+                unsigned char* out_buffer = tls_io_instance->send_buffer;
+
+                (void)memcpy(out_buffer + sizes->cbHeader, buffer, size);
+
+                security_buffers[0].BufferType = SECBUFFER_STREAM_HEADER;
+                security_buffers[0].cbBuffer = sizes->cbHeader;
+                security_buffers[0].pvBuffer = out_buffer;
+                security_buffers[1].BufferType = SECBUFFER_DATA;
+                security_buffers[1].cbBuffer = (unsigned long)size;
+                security_buffers[1].pvBuffer = out_buffer + sizes->cbHeader;
+                security_buffers[2].BufferType = SECBUFFER_STREAM_TRAILER;
+                security_buffers[2].cbBuffer = sizes->cbTrailer;
+                security_buffers[2].pvBuffer = out_buffer + sizes->cbHeader + size;
+                security_buffers[3].cbBuffer = 0;
+                security_buffers[3].BufferType = SECBUFFER_EMPTY;
+                security_buffers[3].pvBuffer = 0;
+
+                security_buffers_desc.cBuffers = sizeof(security_buffers) / sizeof(security_buffers[0]);
+                security_buffers_desc.pBuffers = security_buffers;
+                security_buffers_desc.ulVersion = SECBUFFER_VERSION;
+
+                status = EncryptMessage(&tls_io_instance->security_context, 0, &security_buffers_desc, 0);
+                if (FAILED(status))
+                {
+                    LogError("EncryptMessage failed: %x", status);
+                    result = __FAILURE__;
+                }
+                /* the underlying IO copies what it cannot send right away, the buffer is reused for the next record */
+                else if (xio_send(tls_io_instance->socket_io, out_buffer, security_buffers[0].cbBuffer + security_buffers[1].cbBuffer + security_buffers[2].cbBuffer, on_send_complete, callback_context) != 0)
                 {
-                    LogError("malloc failed");
+                    LogError("xio_send failed");
                     result = __FAILURE__;
                 }
                 else
                 {
-                    (void)memcpy(out_buffer + sizes.cbHeader, buffer, size);
-
-                    security_buffers[0].BufferType = SECBUFFER_STREAM_HEADER;
-                    security_buffers[0].cbBuffer = sizes.cbHeader;
-                    security_buffers[0].pvBuffer = out_buffer;
-                    security_buffers[1].BufferType = SECBUFFER_DATA;
-                    security_buffers[1].cbBuffer = (unsigned long)size;
-                    security_buffers[1].pvBuffer = out_buffer + sizes.cbHeader;
-                    security_buffers[2].BufferType = SECBUFFER_STREAM_TRAILER;
-                    security_buffers[2].cbBuffer = sizes.cbTrailer;
-                    security_buffers[2].pvBuffer = out_buffer + sizes.cbHeader + size;
-                    security_buffers[3].cbBuffer = 0;
-                    security_buffers[3].BufferType = SECBUFFER_EMPTY;
-                    security_buffers[3].pvBuffer = 0;
-
-                    security_buffers_desc.cBuffers = sizeof(security_buffers) / sizeof(security_buffers[0]);
-                    security_buffers_desc.pBuffers = security_buffers;
-                    security_buffers_desc.ulVersion = SECBUFFER_VERSION;
-
-                    status = EncryptMessage(&tls_io_instance->security_context, 0, &security_buffers_desc, 0);
-                    if (FAILED(status))
-                    {
-                        LogError("EncryptMessage failed: %x", status);
-                        result = __FAILURE__;
-                    }
-                    else
-                    {
-                        if (xio_send(tls_io_instance->socket_io, out_buffer, security_buffers[0].cbBuffer + security_buffers[1].cbBuffer + security_buffers[2].cbBuffer, on_send_complete, callback_context) != 0)
-                        {
-                            LogError("xio_send failed");
-                            result = __FAILURE__;
-                        }
-                        else
-                        {
-                            result = 0;
-                        }
-                    }
-
-                    free(out_buffer);
+                    result = 0;
                 }
             }
         }
@@ -576,6 +816,10 @@ static int internal_send(TLS_IO_INSTANCE* tls_io_instance, const void* buffer, s
     while (size > 0)
     {
         size_t to_send = 16 * 1024;
+        if (tls_io_instance->stream_sizes_valid && (to_send > tls_io_instance->stream_sizes.cbMaximumMessage))
+        {
+            to_send = tls_io_instance->stream_sizes.cbMaximumMessage;
+        }
         if (to_send > size)
         {
             to_send = size;
@@ -709,7 +953,8 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                             tls_io_instance->on_io_open_complete(tls_io_instance->on_io_open_complete_context, IO_OPEN_ERROR);
                         }
                     }
-                    else if (set_receive_buffer(tls_io_instance, tls_io_instance->needed_bytes + tls_io_instance->received_byte_count) != 0)
+                    else if ((update_stream_sizes(tls_io_instance) != 0) ||
+                        (resize_receive_buffer(tls_io_instance, tls_io_instance->needed_bytes + tls_io_instance->received_byte_count) != 0))
                     {
                         tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
                         if (tls_io_instance->on_io_open_complete != NULL)
@@ -730,35 +975,20 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                         }
                         else
                         {
-                            LIST_ITEM_HANDLE first_pending_io;
                             tls_io_instance->tlsio_state = TLSIO_STATE_OPEN;
 
-                            first_pending_io = singlylinkedlist_get_head_item(tls_io_instance->pending_io_list);
-                            while (first_pending_io != NULL)
+                            while (!DList_IsListEmpty(&tls_io_instance->pending_io_list))
                             {
-                                PENDING_SEND* pending_send = (PENDING_SEND*)singlylinkedlist_item_get_value(first_pending_io);
-                                if (pending_send == NULL)
+                                PENDING_SEND* pending_send = containingRecord(DList_RemoveHeadList(&tls_io_instance->pending_io_list), PENDING_SEND, link);
+
+                                if (internal_send(tls_io_instance, pending_send->bytes, pending_send->length, pending_send->on_send_complete, pending_send->on_send_complete_context) != 0)
                                 {
-                                    LogError("Failure: retrieving pending IO from list");
+                                    LogError("send failed");
                                     indicate_error(tls_io_instance);
-                                    break;
-                                }
-                                else
-                                {
-                                    if (internal_send(tls_io_instance, pending_send->bytes, pending_send->length, pending_send->on_send_complete, pending_send->on_send_complete_context) != 0)
-                                    {
-                                        LogError("send failed");
-                                        indicate_error(tls_io_instance);
-                                    }
-                                    else
-                                    {
-                                        if (singlylinkedlist_remove(tls_io_instance->pending_io_list, first_pending_io) != 0)
-                                        {
-                                            LogError("Failure: removing pending IO from list");
-                                            indicate_error(tls_io_instance);
-                                        }
-                                    }
                                 }
+
+                                free(pending_send->bytes);
+                                free(pending_send);
                             }
                         }
                     }
@@ -788,7 +1018,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                         /* if nothing more to consume, set the needed bytes to 1, to get on the next byte how many we actually need */
                         tls_io_instance->needed_bytes = tls_io_instance->received_byte_count == 0 ? 1 : 0;
 
-                        if (set_receive_buffer(tls_io_instance, tls_io_instance->needed_bytes + tls_io_instance->received_byte_count) != 0)
+                        if (resize_receive_buffer(tls_io_instance, tls_io_instance->needed_bytes + tls_io_instance->received_byte_count) != 0)
                         {
                             tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
                             if (tls_io_instance->on_io_open_complete != NULL)
@@ -902,7 +1132,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                         /* if nothing more to consume, set the needed bytes to 1, to get on the next byte how many we actually need */
                         tls_io_instance->needed_bytes = tls_io_instance->received_byte_count == 0 ? 1 : 0;
 
-                        if (set_receive_buffer(tls_io_instance, tls_io_instance->needed_bytes + tls_io_instance->received_byte_count) != 0)
+                        if (resize_receive_buffer(tls_io_instance, tls_io_instance->needed_bytes + tls_io_instance->received_byte_count) != 0)
                         {
                             tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
                             indicate_error(tls_io_instance);
@@ -1114,25 +1344,17 @@ CONCRETE_IO_HANDLE tlsio_schannel_create(void* io_create_parameters)
                     }
                     else
                     {
-                        result->pending_io_list = singlylinkedlist_create();
-                        if (result->pending_io_list == NULL)
-                        {
-                            LogError("Failed creating pending IO list.");
-                            xio_destroy(result->socket_io);
-                            free(result->host_name);
-                            free(result);
-                            result = NULL;
-                        }
-                        else
-                        {
-                            result->received_bytes = NULL;
-                            result->received_byte_count = 0;
-                            result->buffer_size = 0;
-                            result->tlsio_state = TLSIO_STATE_NOT_OPEN;
-                            result->x509certificate = NULL;
-                            result->x509privatekey = NULL;
-                            result->x509_schannel_handle = NULL;
-                        }
+                        DList_InitializeListHead(&result->pending_io_list);
+                        result->received_bytes = NULL;
+                        result->received_byte_count = 0;
+                        result->buffer_size = 0;
+                        result->stream_sizes_valid = false;
+                        result->send_buffer = NULL;
+                        result->send_buffer_size = 0;
+                        result->tlsio_state = TLSIO_STATE_NOT_OPEN;
+                        result->x509certificate = NULL;
+                        result->x509privatekey = NULL;
+                        result->x509_schannel_handle = NULL;
                     }
                 }
             }
@@ -1147,12 +1369,12 @@ void tlsio_schannel_destroy(CONCRETE_IO_HANDLE tls_io)
     if (tls_io != NULL)
     {
         TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)tls_io;
-        LIST_ITEM_HANDLE first_pending_io;
 
-        if (tls_io_instance->credential_handle_allocated)
+        release_credentials(tls_io_instance);
+
+        if (tls_io_instance->send_buffer != NULL)
         {
-            (void)FreeCredentialHandle(&tls_io_instance->credential_handle);
-            tls_io_instance->credential_handle_allocated = false;
+            free(tls_io_instance->send_buffer);
         }
 
         if (tls_io_instance->received_bytes != NULL)
@@ -1183,31 +1405,19 @@ void tlsio_schannel_destroy(CONCRETE_IO_HANDLE tls_io)
         xio_destroy(tls_io_instance->socket_io);
         free(tls_io_instance->host_name);
 
-        first_pending_io = singlylinkedlist_get_head_item(tls_io_instance->pending_io_list);
-        while (first_pending_io != NULL)
+        while (!DList_IsListEmpty(&tls_io_instance->pending_io_list))
         {
-            PENDING_SEND* pending_send = (PENDING_SEND*)singlylinkedlist_item_get_value(first_pending_io);
-            if (pending_send == NULL)
+            PENDING_SEND* pending_send = containingRecord(DList_RemoveHeadList(&tls_io_instance->pending_io_list), PENDING_SEND, link);
+
+            if (pending_send->on_send_complete != NULL)
             {
-                LogError("Failure: retrieving socket from list");
-                indicate_error(tls_io_instance);
-                break;
+                pending_send->on_send_complete(pending_send->on_send_complete_context, IO_SEND_CANCELLED);
             }
-            else
-            {
-                if (pending_send->on_send_complete != NULL)
-                {
-                    pending_send->on_send_complete(pending_send->on_send_complete_context, IO_SEND_CANCELLED);
-                }
 
-                if (singlylinkedlist_remove(tls_io_instance->pending_io_list, first_pending_io) != 0)
-                {
-                    LogError("Failure: removing pending IO from list");
-                }
-            }
+            free(pending_send->bytes);
+            free(pending_send);
         }
 
-        singlylinkedlist_destroy(tls_io_instance->pending_io_list);
         free(tls_io);
     }
 }
@@ -1318,6 +1528,7 @@ int tlsio_schannel_send(CONCRETE_IO_HANDLE tls_io, const void* buffer, size_t si
             if (new_pending_send->bytes == NULL)
             {
                 LogError("Cannot allocate memory for pending IO payload");
+                free(new_pending_send);
                 result = __FAILURE__;
             }
             else
@@ -1327,15 +1538,8 @@ int tlsio_schannel_send(CONCRETE_IO_HANDLE tls_io, const void* buffer, size_t si
                 new_pending_send->on_send_complete = on_send_complete;
                 new_pending_send->on_send_complete_context = callback_context;
 
-                if (singlylinkedlist_add(tls_io_instance->pending_io_list, new_pending_send) == NULL)
-                {
-                    LogError("Cannot add pending IO to list");
-                    result = __FAILURE__;
-                }
-                else
-                {
-                    result = 0;
-                }
+                DList_InsertTailList(&tls_io_instance->pending_io_list, &new_pending_send->link);
+                result = 0;
             }
         }
     }
@@ -1393,8 +1597,9 @@ int tlsio_schannel_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName,
                 }
                 else
                 {
-                    if (tls_io_instance->x509privatekey != NULL)
+                    if ((tls_io_instance->x509privatekey != NULL) && (credential_cache_lock == NULL))
                     {
+                        /*with the credential cache the certificate is loaded by the first open that needs it*/
                         tls_io_instance->x509_schannel_handle = x509_schannel_create(tls_io_instance->x509certificate, tls_io_instance->x509privatekey);
                         if (tls_io_instance->x509_schannel_handle == NULL)
                         {
@@ -1431,8 +1636,9 @@ int tlsio_schannel_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName,
                 }
                 else
                 {
-                    if (tls_io_instance->x509certificate != NULL)
+                    if ((tls_io_instance->x509certificate != NULL) && (credential_cache_lock == NULL))
                     {
+                        /*with the credential cache the certificate is loaded by the first open that needs it*/
                         tls_io_instance->x509_schannel_handle = x509_schannel_create(tls_io_instance->x509certificate, tls_io_instance->x509privatekey);
                         if (tls_io_instance->x509_schannel_handle == NULL)
                         {
@@ -1498,6 +1704,35 @@ int tlsio_schannel_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName,
     return result;
 }
 
+int tlsio_schannel_init(void)
+{
+    credential_cache_lock = Lock_Init();
+    if (credential_cache_lock == NULL)
+    {
+        // Not fatal, every instance then acquires its own credential handle
+        LogError("Failed to create the credential cache lock.");
+    }
+
+    return 0;
+}
+
+void tlsio_schannel_deinit(void)
+{
+    if (credential_cache_lock != NULL)
+    {
+        // Only handles still referenced by instances that were not destroyed are left
+        while (credential_cache_entries != NULL)
+        {
+            TLS_CREDENTIAL_CACHE_ENTRY* entry = credential_cache_entries;
+            credential_cache_entries = entry->next;
+            free_credential_cache_entry(entry);
+        }
+
+        Lock_Deinit(credential_cache_lock);
+        credential_cache_lock = NULL;
+    }
+}
+
 const IO_INTERFACE_DESCRIPTION* tlsio_schannel_get_interface_description(void)
 {
     return &tlsio_schannel_interface_description;
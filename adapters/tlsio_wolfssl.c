@@ -18,6 +18,8 @@
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/tlsio_options.h"
+#include "azure_c_shared_utility/lock.h"
 
 typedef enum TLSIO_STATE_ENUM_TAG
 {
@@ -50,11 +52,32 @@ typedef struct TLS_IO_INSTANCE_TAG
     char* certificate;
     char* x509certificate;
     char* x509privatekey;
+    TLSIO_OPTIONS tls_options;
     int wolfssl_device_id;
+    char* hostname;
+    int port;
+    bool use_session_cache;
+    bool session_offered;
 } TLS_IO_INSTANCE;
 
+/* Sessions are keyed by hostname, port and client certificate, as in tlsio_openssl, so that a session
+   authenticated with one device's credentials is never resumed by another TLS_IO_INSTANCE. */
+typedef struct TLS_SESSION_CACHE_ENTRY_TAG
+{
+    char* hostname;
+    int port;
+    char* x509certificate;
+    WOLFSSL_SESSION* session;
+    struct TLS_SESSION_CACHE_ENTRY_TAG* next;
+} TLS_SESSION_CACHE_ENTRY;
+
+static LOCK_HANDLE session_cache_lock = NULL;
+static TLS_SESSION_CACHE_ENTRY* session_cache_entries = NULL;
+
 STATIC_VAR_UNUSED const char* const OPTION_WOLFSSL_SET_DEVICE_ID = "SetDeviceId";
 static const size_t SOCKET_READ_LIMIT = 5;
+// Long enough for TLSIO_OPTIONS_MAX_LIST_COUNT of the longest name, "RSA-PSS+SHA512:"
+#define SIGALGS_LIST_SIZE (TLSIO_OPTIONS_MAX_LIST_COUNT * 16)
 
 /*this function will clone an option given by name and value*/
 static void* tlsio_wolfssl_CloneOption(const char* name, const void* value)
@@ -103,6 +126,33 @@ static void* tlsio_wolfssl_CloneOption(const char* name, const void* value)
                 /*return as is*/
             }
         }
+        else if ((strcmp(name, OPTION_TLS_GROUPS) == 0) || (strcmp(name, OPTION_TLS_SIGNATURE_ALGORITHMS) == 0))
+        {
+            if (tlsio_options_clone_option(name, value, &result) != TLSIO_OPTIONS_RESULT_SUCCESS)
+            {
+                LogError("unable to clone %s value", name);
+                result = NULL;
+            }
+            else
+            {
+                /*return as is*/
+            }
+        }
+        else if (strcmp(name, OPTION_TLS_SESSION_CACHE) == 0)
+        {
+            bool* value_clone;
+
+            if ((value_clone = (bool*)malloc(sizeof(bool))) == NULL)
+            {
+                LogError("unable to clone tls_session_cache value");
+            }
+            else
+            {
+                *value_clone = *(const bool*)value;
+            }
+
+            result = value_clone;
+        }
         else
         {
             LogError("not handled option : %s", name);
@@ -115,7 +165,7 @@ static void* tlsio_wolfssl_CloneOption(const char* name, const void* value)
 /*this function destroys an option previously created*/
 static void tlsio_wolfssl_DestroyOption(const char* name, const void* value)
 {
-    /*since all options for this layer are actually string copies., disposing of one is just calling free*/
+    /*since all options for this layer are actually heap copies, disposing of one is just calling free*/
     if ((name == NULL) || (value == NULL))
     {
         LogError("invalid parameter detected: const char* name=%p, const void* value=%p", name, value);
@@ -124,7 +174,10 @@ static void tlsio_wolfssl_DestroyOption(const char* name, const void* value)
     {
         if ((strcmp(name, OPTION_TRUSTED_CERT) == 0) ||
             (strcmp(name, SU_OPTION_X509_CERT) == 0) ||
-            (strcmp(name, SU_OPTION_X509_PRIVATE_KEY) == 0))
+            (strcmp(name, SU_OPTION_X509_PRIVATE_KEY) == 0) ||
+            (strcmp(name, OPTION_TLS_GROUPS) == 0) ||
+            (strcmp(name, OPTION_TLS_SIGNATURE_ALGORITHMS) == 0) ||
+            (strcmp(name, OPTION_TLS_SESSION_CACHE) == 0))
         {
             free((void*)value);
         }
@@ -182,6 +235,33 @@ static OPTIONHANDLER_HANDLE tlsio_wolfssl_retrieveoptions(CONCRETE_IO_HANDLE tls
                 OptionHandler_Destroy(result);
                 result = NULL;
             }
+            else if (
+                (tls_io_instance->tls_options.groups != NULL) &&
+                (OptionHandler_AddOption(result, OPTION_TLS_GROUPS, tls_io_instance->tls_options.groups) != 0)
+                )
+            {
+                LogError("unable to save tls_groups option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (
+                (tls_io_instance->tls_options.signature_algorithms != NULL) &&
+                (OptionHandler_AddOption(result, OPTION_TLS_SIGNATURE_ALGORITHMS, tls_io_instance->tls_options.signature_algorithms) != 0)
+                )
+            {
+                LogError("unable to save tls_signature_algorithms option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
+            else if (
+                (tls_io_instance->use_session_cache) &&
+                (OptionHandler_AddOption(result, OPTION_TLS_SESSION_CACHE, &tls_io_instance->use_session_cache) != 0)
+                )
+            {
+                LogError("unable to save tls_session_cache option");
+                OptionHandler_Destroy(result);
+                result = NULL;
+            }
             else
             {
                 /*all is fine, all interesting options have been saved*/
@@ -202,7 +282,13 @@ static const IO_INTERFACE_DESCRIPTION tlsio_wolfssl_interface_description =
     tlsio_wolfssl_close,
     tlsio_wolfssl_send,
     tlsio_wolfssl_dowork,
-    tlsio_wolfssl_setoption
+    tlsio_wolfssl_setoption,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
 };
 
 static void indicate_error(TLS_IO_INSTANCE* tls_io_instance)
@@ -241,6 +327,143 @@ static int decode_ssl_received_bytes(TLS_IO_INSTANCE* tls_io_instance)
     return result;
 }
 
+static bool is_same_string(const char* left, const char* right)
+{
+    return ((left == NULL) && (right == NULL)) ||
+        ((left != NULL) && (right != NULL) && (strcmp(left, right) == 0));
+}
+
+// Must be called with session_cache_lock held
+static TLS_SESSION_CACHE_ENTRY** find_session_cache_entry(TLS_IO_INSTANCE* tls_io_instance)
+{
+    TLS_SESSION_CACHE_ENTRY** entry = &session_cache_entries;
+
+    while ((*entry != NULL) &&
+        (((*entry)->port != tls_io_instance->port) ||
+         (strcmp((*entry)->hostname, tls_io_instance->hostname) != 0) ||
+         (!is_same_string((*entry)->x509certificate, tls_io_instance->x509certificate))))
+    {
+        entry = &(*entry)->next;
+    }
+
+    return entry;
+}
+
+static void free_session_cache_entry(TLS_SESSION_CACHE_ENTRY* entry)
+{
+    wolfSSL_SESSION_free(entry->session);
+    free(entry->hostname);
+    free(entry->x509certificate);
+    free(entry);
+}
+
+static void save_session(TLS_IO_INSTANCE* tls_io_instance)
+{
+    // Takes a reference of its own, which the cache owns. Carries the session ID and, if the server sent one, the ticket.
+    WOLFSSL_SESSION* session = wolfSSL_get1_session(tls_io_instance->ssl);
+
+    if (session == NULL)
+    {
+        LogInfo("The server did not hand out a session that can be resumed");
+    }
+    else if (Lock(session_cache_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the TLS session cache.");
+        wolfSSL_SESSION_free(session);
+    }
+    else
+    {
+        TLS_SESSION_CACHE_ENTRY** entry = find_session_cache_entry(tls_io_instance);
+
+        if (*entry != NULL)
+        {
+            wolfSSL_SESSION_free((*entry)->session);
+            (*entry)->session = session;
+        }
+        else
+        {
+            TLS_SESSION_CACHE_ENTRY* new_entry = (TLS_SESSION_CACHE_ENTRY*)malloc(sizeof(TLS_SESSION_CACHE_ENTRY));
+            if (new_entry == NULL)
+            {
+                LogError("Failed allocating TLS session cache entry.");
+                wolfSSL_SESSION_free(session);
+            }
+            else
+            {
+                new_entry->port = tls_io_instance->port;
+                new_entry->x509certificate = NULL;
+                new_entry->session = session;
+                new_entry->next = NULL;
+
+                if (mallocAndStrcpy_s(&new_entry->hostname, tls_io_instance->hostname) != 0)
+                {
+                    LogError("Failed copying the hostname of a TLS session cache entry.");
+                    wolfSSL_SESSION_free(session);
+                    free(new_entry);
+                }
+                else if ((tls_io_instance->x509certificate != NULL) &&
+                    (mallocAndStrcpy_s(&new_entry->x509certificate, tls_io_instance->x509certificate) != 0))
+                {
+                    LogError("Failed copying the certificate of a TLS session cache entry.");
+                    wolfSSL_SESSION_free(session);
+                    free(new_entry->hostname);
+                    free(new_entry);
+                }
+                else
+                {
+                    *entry = new_entry;
+                }
+            }
+        }
+
+        (void)Unlock(session_cache_lock);
+    }
+}
+
+static void offer_cached_session(TLS_IO_INSTANCE* tls_io_instance)
+{
+    tls_io_instance->session_offered = false;
+
+    if (Lock(session_cache_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the TLS session cache.");
+    }
+    else
+    {
+        TLS_SESSION_CACHE_ENTRY* entry = *find_session_cache_entry(tls_io_instance);
+
+        // wolfSSL_set_session copies the session, so the entry can be replaced while the handshake runs
+        if ((entry != NULL) &&
+            (wolfSSL_set_session(tls_io_instance->ssl, entry->session) == SSL_SUCCESS))
+        {
+            tls_io_instance->session_offered = true;
+        }
+
+        (void)Unlock(session_cache_lock);
+    }
+}
+
+static void forget_offered_session(TLS_IO_INSTANCE* tls_io_instance)
+{
+    if (Lock(session_cache_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the TLS session cache.");
+    }
+    else
+    {
+        // Do not keep offering a session that might be the reason the handshake is failing
+        TLS_SESSION_CACHE_ENTRY** entry = find_session_cache_entry(tls_io_instance);
+        if (*entry != NULL)
+        {
+            TLS_SESSION_CACHE_ENTRY* failed_entry = *entry;
+            *entry = failed_entry->next;
+            free_session_cache_entry(failed_entry);
+        }
+
+        (void)Unlock(session_cache_lock);
+    }
+}
+
 static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_result)
 {
     TLS_IO_INSTANCE* tls_io_instance = (TLS_IO_INSTANCE*)context;
@@ -260,6 +483,10 @@ static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_re
         if (res != SSL_SUCCESS)
         {
             LogError("WolfSSL connect failed");
+            if (tls_io_instance->use_session_cache && tls_io_instance->session_offered)
+            {
+                forget_offered_session(tls_io_instance);
+            }
             indicate_open_complete(tls_io_instance, IO_OPEN_ERROR);
             tls_io_instance->tlsio_state = TLSIO_STATE_ERROR;
         }
@@ -442,6 +669,10 @@ static int on_handshake_done(WOLFSSL* ssl, void* context)
     }
     else
     {
+        if (tls_io_instance->use_session_cache)
+        {
+            save_session(tls_io_instance);
+        }
         tls_io_instance->tlsio_state = TLSIO_STATE_OPEN;
         indicate_open_complete(tls_io_instance, IO_OPEN_OK);
     }
@@ -536,6 +767,112 @@ static int create_wolfssl_instance(TLS_IO_INSTANCE* tls_io_instance)
     return result;
 }
 
+#ifdef OPENSSL_EXTRA
+// wolfSSL names the signature algorithms by key type and hash
+static const char* get_sigalg_name(uint16_t signature_algorithm)
+{
+    const char* result;
+
+    switch (signature_algorithm)
+    {
+        case TLSIO_SIGNATURE_ALGORITHM_RSA_PKCS1_SHA256:
+            result = "RSA+SHA256";
+            break;
+        case TLSIO_SIGNATURE_ALGORITHM_RSA_PKCS1_SHA384:
+            result = "RSA+SHA384";
+            break;
+        case TLSIO_SIGNATURE_ALGORITHM_RSA_PKCS1_SHA512:
+            result = "RSA+SHA512";
+            break;
+        case TLSIO_SIGNATURE_ALGORITHM_ECDSA_SECP256R1_SHA256:
+            result = "ECDSA+SHA256";
+            break;
+        case TLSIO_SIGNATURE_ALGORITHM_ECDSA_SECP384R1_SHA384:
+            result = "ECDSA+SHA384";
+            break;
+        case TLSIO_SIGNATURE_ALGORITHM_ECDSA_SECP521R1_SHA512:
+            result = "ECDSA+SHA512";
+            break;
+        case TLSIO_SIGNATURE_ALGORITHM_RSA_PSS_RSAE_SHA256:
+            result = "RSA-PSS+SHA256";
+            break;
+        case TLSIO_SIGNATURE_ALGORITHM_RSA_PSS_RSAE_SHA384:
+            result = "RSA-PSS+SHA384";
+            break;
+        case TLSIO_SIGNATURE_ALGORITHM_RSA_PSS_RSAE_SHA512:
+            result = "RSA-PSS+SHA512";
+            break;
+        case TLSIO_SIGNATURE_ALGORITHM_ED25519:
+            result = "ED25519";
+            break;
+        case TLSIO_SIGNATURE_ALGORITHM_ED448:
+            result = "ED448";
+            break;
+        default:
+            result = NULL;
+            break;
+    }
+
+    return result;
+}
+#endif
+
+// The groups and signature algorithms are offered in the order of tls_groups and tls_signature_algorithms
+static int set_groups_and_signature_algorithms(TLS_IO_INSTANCE* tls_io_instance)
+{
+    int result = 0;
+    size_t i;
+
+    for (i = 0; (result == 0) && (i < tls_io_instance->tls_options.group_count); i++)
+    {
+#ifdef HAVE_SUPPORTED_CURVES
+        // The TLSIO_GROUP_* values are the IANA ones wolfSSL uses
+        if (wolfSSL_UseSupportedCurve(tls_io_instance->ssl, tls_io_instance->tls_options.group_ids[i]) != WOLFSSL_SUCCESS)
+        {
+            LogError("The group %u of tls_groups is not supported by wolfSSL", (unsigned int)tls_io_instance->tls_options.group_ids[i]);
+            result = __FAILURE__;
+        }
+#else
+        LogError("wolfSSL was built without HAVE_SUPPORTED_CURVES, tls_groups cannot be used");
+        result = __FAILURE__;
+#endif
+    }
+
+    if ((result == 0) && (tls_io_instance->tls_options.signature_algorithm_count != 0))
+    {
+#ifdef OPENSSL_EXTRA
+        char sigalgs_list[SIGALGS_LIST_SIZE];
+        size_t length = 0;
+
+        for (i = 0; (result == 0) && (i < tls_io_instance->tls_options.signature_algorithm_count); i++)
+        {
+            const char* name = get_sigalg_name(tls_io_instance->tls_options.signature_algorithm_ids[i]);
+
+            if (name == NULL)
+            {
+                LogError("The signature algorithm 0x%04x of tls_signature_algorithms is not supported by wolfSSL", (unsigned int)tls_io_instance->tls_options.signature_algorithm_ids[i]);
+                result = __FAILURE__;
+            }
+            else
+            {
+                length += (size_t)snprintf(sigalgs_list + length, sizeof(sigalgs_list) - length, (length == 0) ? "%s" : ":%s", name);
+            }
+        }
+
+        if ((result == 0) && (wolfSSL_set1_sigalgs_list(tls_io_instance->ssl, sigalgs_list) != WOLFSSL_SUCCESS))
+        {
+            LogError("Failed setting the signature algorithms %s", sigalgs_list);
+            result = __FAILURE__;
+        }
+#else
+        LogError("wolfSSL was built without OPENSSL_EXTRA, tls_signature_algorithms cannot be used");
+        result = __FAILURE__;
+#endif
+    }
+
+    return result;
+}
+
 static int prepare_wolfssl_open(TLS_IO_INSTANCE* tls_io_instance)
 {
     int result;
@@ -559,9 +896,25 @@ static int prepare_wolfssl_open(TLS_IO_INSTANCE* tls_io_instance)
         LogError("Failure setting device id");
         result = __FAILURE__;
     }
+#endif
+    else if (set_groups_and_signature_algorithms(tls_io_instance) != 0)
+    {
+        LogError("Failure setting the groups and signature algorithms");
+        result = __FAILURE__;
+    }
+#ifdef HAVE_SESSION_TICKET
+    else if (tls_io_instance->use_session_cache && wolfSSL_UseSessionTicket(tls_io_instance->ssl) != SSL_SUCCESS)
+    {
+        LogError("Failure enabling session tickets");
+        result = __FAILURE__;
+    }
 #endif
     else
     {
+        if (tls_io_instance->use_session_cache)
+        {
+            offer_cached_session(tls_io_instance);
+        }
         result = 0;
     }
     return result;
@@ -572,11 +925,30 @@ int tlsio_wolfssl_init(void)
     (void)wolfSSL_library_init();
     wolfSSL_load_error_strings();
 
+    session_cache_lock = Lock_Init();
+    if (session_cache_lock == NULL)
+    {
+        // Not fatal, only OPTION_TLS_SESSION_CACHE becomes unavailable
+        LogError("Failed creating the TLS session cache lock.");
+    }
+
     return 0;
 }
 
 void tlsio_wolfssl_deinit(void)
 {
+    if (session_cache_lock != NULL)
+    {
+        while (session_cache_entries != NULL)
+        {
+            TLS_SESSION_CACHE_ENTRY* entry = session_cache_entries;
+            session_cache_entries = entry->next;
+            free_session_cache_entry(entry);
+        }
+
+        Lock_Deinit(session_cache_lock);
+        session_cache_lock = NULL;
+    }
 }
 
 CONCRETE_IO_HANDLE tlsio_wolfssl_create(void* io_create_parameters)
@@ -600,12 +972,21 @@ CONCRETE_IO_HANDLE tlsio_wolfssl_create(void* io_create_parameters)
         else
         {
             (void)memset(result, 0, sizeof(TLS_IO_INSTANCE));
+            tlsio_options_initialize(&result->tls_options, TLSIO_OPTION_BIT_GROUPS | TLSIO_OPTION_BIT_SIGNATURE_ALGORITHMS);
             result->tlsio_state = TLSIO_STATE_NOT_OPEN;
+            result->port = tls_io_config->port;
 
-            result->ssl_context = wolfSSL_CTX_new(wolfTLSv1_2_client_method());
-            if (result->ssl_context == NULL)
+            if ((tls_io_config->hostname != NULL) &&
+                (mallocAndStrcpy_s(&result->hostname, tls_io_config->hostname) != 0))
+            {
+                LogError("Failed copying the hostname");
+                free(result);
+                result = NULL;
+            }
+            else if ((result->ssl_context = wolfSSL_CTX_new(wolfTLSv1_2_client_method())) == NULL)
             {
                 LogError("Cannot create the wolfSSL context");
+                free(result->hostname);
                 free(result);
                 result = NULL;
             }
@@ -638,6 +1019,7 @@ CONCRETE_IO_HANDLE tlsio_wolfssl_create(void* io_create_parameters)
                 {
                     LogError("Failed getting socket IO interface description.");
                     wolfSSL_CTX_free(result->ssl_context);
+                    free(result->hostname);
                     free(result);
                     result = NULL;
                 }
@@ -648,6 +1030,7 @@ CONCRETE_IO_HANDLE tlsio_wolfssl_create(void* io_create_parameters)
                     {
                         LogError("Failure connecting to underlying socket_io");
                         wolfSSL_CTX_free(result->ssl_context);
+                        free(result->hostname);
                         free(result);
                         result = NULL;
                     }
@@ -655,6 +1038,7 @@ CONCRETE_IO_HANDLE tlsio_wolfssl_create(void* io_create_parameters)
                     {
                         LogError("Failure connecting to underlying socket_io");
                         wolfSSL_CTX_free(result->ssl_context);
+                        free(result->hostname);
                         free(result);
                         result = NULL;
                     }
@@ -691,6 +1075,12 @@ void tlsio_wolfssl_destroy(CONCRETE_IO_HANDLE tls_io)
             free(tls_io_instance->x509privatekey);
             tls_io_instance->x509privatekey = NULL;
         }
+        if (tls_io_instance->hostname != NULL)
+        {
+            free(tls_io_instance->hostname);
+            tls_io_instance->hostname = NULL;
+        }
+        tlsio_options_release_resources(&tls_io_instance->tls_options);
         destroy_wolfssl_instance(tls_io_instance);
 
         wolfSSL_CTX_free(tls_io_instance->ssl_context);
@@ -907,6 +1297,38 @@ int tlsio_wolfssl_setoption(CONCRETE_IO_HANDLE tls_io, const char* optionName, c
         {
             result = process_option(&tls_io_instance->x509privatekey, optionName, value);
         }
+        else if ((strcmp(OPTION_TLS_GROUPS, optionName) == 0) || (strcmp(OPTION_TLS_SIGNATURE_ALGORITHMS, optionName) == 0))
+        {
+            // Takes effect on the next handshake
+            if (tlsio_options_set(&tls_io_instance->tls_options, optionName, value) != TLSIO_OPTIONS_RESULT_SUCCESS)
+            {
+                LogError("Invalid value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+        else if (strcmp(OPTION_TLS_SESSION_CACHE, optionName) == 0)
+        {
+            if (value == NULL)
+            {
+                LogError("NULL value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else if (*(const bool*)value && ((session_cache_lock == NULL) || (tls_io_instance->hostname == NULL)))
+            {
+                LogError("The TLS session cache is not available, either tlsio_wolfssl_init was not called or no hostname was given");
+                result = __FAILURE__;
+            }
+            else
+            {
+                // Takes effect on the next handshake
+                tls_io_instance->use_session_cache = *(const bool*)value;
+                result = 0;
+            }
+        }
 #ifdef INVALID_DEVID
         else if (strcmp(OPTION_WOLFSSL_SET_DEVICE_ID, optionName) == 0)
         {
@@ -33,3 +33,26 @@ UNIQUEID_RESULT UniqueId_Generate(char* uid, size_t len)
     }
     return result;
 }
+
+UNIQUEID_RESULT UniqueId_GenerateBinary(unsigned char* uid, size_t len)
+{
+    UNIQUEID_RESULT result;
+
+    /* Codes_SRS_UNIQUEID_07_006: [If uid is NULL then UniqueId_GenerateBinary shall return UNIQUEID_INVALID_ARG] */
+    /* Codes_SRS_UNIQUEID_07_007: [If len is less then 16 then UniqueId_GenerateBinary shall return UNIQUEID_INVALID_ARG] */
+    if (uid == NULL || len < UNIQUEID_BINARY_SIZE)
+    {
+        result = UNIQUEID_INVALID_ARG;
+        LogError("Buffer is NULL or length is less then 16 bytes. (result = %s)", ENUM_TO_STRING(UNIQUEID_RESULT, result));
+    }
+    else
+    {
+        uuid_t uuidVal;
+
+        /* Codes_SRS_UNIQUEID_07_005: [UniqueId_GenerateBinary shall write the 16 bytes of a random (version 4) UUID to uid, in the order they appear in the UUID string.] */
+        uuid_generate_random(uuidVal);
+        (void)memcpy(uid, uuidVal, UNIQUEID_BINARY_SIZE);
+        result = UNIQUEID_OK;
+    }
+    return result;
+}
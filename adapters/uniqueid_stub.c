@@ -22,14 +22,14 @@ static void generate128BitUUID(unsigned char* arrayOfByte)
     //
     // Stick in the version field for random uuid.
     //
-    arrayOfByte[7] &= 0x0f; //clear the bit field
-    arrayOfByte[7] |= 0x40; //set the ones we care about
+    arrayOfByte[6] &= 0x0f; //clear the bit field
+    arrayOfByte[6] |= 0x40; //set the ones we care about
 
     //
     // Stick in the variant field for the random uuid.
     //
-    arrayOfByte[8] &= 0xf3; // Clear
-    arrayOfByte[8] |= 0x08; // Set
+    arrayOfByte[8] &= 0x3f; // Clear
+    arrayOfByte[8] |= 0x80; // Set
 
 }
 
@@ -74,3 +74,23 @@ UNIQUEID_RESULT UniqueId_Generate(char* uid, size_t len)
     }
     return result;
 }
+
+UNIQUEID_RESULT UniqueId_GenerateBinary(unsigned char* uid, size_t len)
+{
+    UNIQUEID_RESULT result;
+
+    /* Codes_SRS_UNIQUEID_07_006: [If uid is NULL then UniqueId_GenerateBinary shall return UNIQUEID_INVALID_ARG] */
+    /* Codes_SRS_UNIQUEID_07_007: [If len is less then 16 then UniqueId_GenerateBinary shall return UNIQUEID_INVALID_ARG] */
+    if (uid == NULL || len < UNIQUEID_BINARY_SIZE)
+    {
+        result = UNIQUEID_INVALID_ARG;
+        LogError("Buffer is NULL or length is less then 16 bytes");
+    }
+    else
+    {
+        /* Codes_SRS_UNIQUEID_07_005: [UniqueId_GenerateBinary shall write the 16 bytes of a random (version 4) UUID to uid, in the order they appear in the UUID string.] */
+        generate128BitUUID(uid);
+        result = UNIQUEID_OK;
+    }
+    return result;
+}
@@ -3,6 +3,7 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 #include "azure_c_shared_utility/uniqueid.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include <rpc.h>
@@ -56,3 +57,43 @@ UNIQUEID_RESULT UniqueId_Generate(char* uid, size_t len)
     }
     return result;
 }
+
+UNIQUEID_RESULT UniqueId_GenerateBinary(unsigned char* uid, size_t len)
+{
+    UNIQUEID_RESULT result;
+
+    /* Codes_SRS_UNIQUEID_07_006: [If uid is NULL then UniqueId_GenerateBinary shall return UNIQUEID_INVALID_ARG] */
+    /* Codes_SRS_UNIQUEID_07_007: [If len is less then 16 then UniqueId_GenerateBinary shall return UNIQUEID_INVALID_ARG] */
+    if (uid == NULL || len < UNIQUEID_BINARY_SIZE)
+    {
+        result = UNIQUEID_INVALID_ARG;
+        LogError("Buffer is NULL or length is less then 16 bytes");
+    }
+    else
+    {
+        UUID uuidVal;
+        RPC_STATUS status = UuidCreate(&uuidVal);
+        if (status != RPC_S_OK && status != RPC_S_UUID_LOCAL_ONLY)
+        {
+            /* Codes_SRS_UNIQUEID_07_008: [If there is a failure for any reason the UniqueId_GenerateBinary shall return UNIQUEID_ERROR] */
+            LogError("Unable to aquire unique Id");
+            result = UNIQUEID_ERROR;
+        }
+        else
+        {
+            /* Codes_SRS_UNIQUEID_07_005: [UniqueId_GenerateBinary shall write the 16 bytes of a random (version 4) UUID to uid, in the order they appear in the UUID string.] */
+            /* the first 3 fields are stored in host order, the string form has them big endian */
+            uid[0] = (unsigned char)(uuidVal.Data1 >> 24);
+            uid[1] = (unsigned char)(uuidVal.Data1 >> 16);
+            uid[2] = (unsigned char)(uuidVal.Data1 >> 8);
+            uid[3] = (unsigned char)uuidVal.Data1;
+            uid[4] = (unsigned char)(uuidVal.Data2 >> 8);
+            uid[5] = (unsigned char)uuidVal.Data2;
+            uid[6] = (unsigned char)(uuidVal.Data3 >> 8);
+            uid[7] = (unsigned char)uuidVal.Data3;
+            (void)memcpy(uid + 8, uuidVal.Data4, sizeof(uuidVal.Data4));
+            result = UNIQUEID_OK;
+        }
+    }
+    return result;
+}
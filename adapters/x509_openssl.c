@@ -1,7 +1,12 @@
 // Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
 #include "azure_c_shared_utility/x509_openssl.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/const_defines.h"
@@ -10,6 +15,12 @@
 #include "openssl/x509.h"
 #include "openssl/pem.h"
 #include "openssl/err.h"
+#include "openssl/evp.h"
+#if (OPENSSL_VERSION_NUMBER >= 0x10101000L) && !defined(LIBRESSL_VERSION_NUMBER)
+#include "openssl/store.h"
+#include "openssl/ui.h"
+#define X509_OPENSSL_STORE_SUPPORTED
+#endif
 
 #ifdef __APPLE__
     #ifndef EVP_PKEY_id
@@ -17,6 +28,32 @@
     #endif // EVP_PKEY_id
 #endif // __APPLE__
 
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+#define X509_OPENSSL_UP_REF(x509_value) X509_up_ref(x509_value)
+#else
+#define X509_OPENSSL_UP_REF(x509_value) CRYPTO_add(&(x509_value)->references, 1, CRYPTO_LOCK_X509)
+#endif
+
+#define X509_OPENSSL_DIGEST_SIZE 32
+
+/* Parsed credentials are keyed by the SHA-256 of their PEM text, so that no copy of the private key
+   PEM is kept around. The same certificate and key loaded into many SSL contexts are decoded once. */
+typedef struct X509_OPENSSL_CREDENTIALS_TAG
+{
+    unsigned char certificate_digest[X509_OPENSSL_DIGEST_SIZE];
+    unsigned char private_key_digest[X509_OPENSSL_DIGEST_SIZE];
+    EVP_PKEY* evp_key;
+    X509* certificate;
+    X509** ca_certificates;
+    size_t ca_certificate_count;
+    size_t ref_count;
+    bool cached;
+    struct X509_OPENSSL_CREDENTIALS_TAG* next;
+} X509_OPENSSL_CREDENTIALS;
+
+static LOCK_HANDLE credentials_cache_lock = NULL;
+static X509_OPENSSL_CREDENTIALS* credentials_cache = NULL;
+
 static void log_ERR_get_error(const char* message)
 {
     char buf[128];
@@ -38,6 +75,19 @@ static void log_ERR_get_error(const char* message)
     }
 }
 
+static void clear_extra_chain_certs(SSL_CTX* ssl_ctx)
+{
+#if (OPENSSL_VERSION_NUMBER >= 0x10100000L) && (OPENSSL_VERSION_NUMBER < 0x20000000L)
+    SSL_CTX_clear_extra_chain_certs(ssl_ctx);
+#else
+    if (ssl_ctx->extra_certs != NULL)
+    {
+        sk_X509_pop_free(ssl_ctx->extra_certs, X509_free);
+        ssl_ctx->extra_certs = NULL;
+    }
+#endif
+}
+
 static int load_certificate_chain(SSL_CTX* ssl_ctx, const char* certificate)
 {
     int result;
@@ -73,15 +123,7 @@ static int load_certificate_chain(SSL_CTX* ssl_ctx, const char* certificate)
                 // certificates.
 
                 /* Codes_SRS_X509_OPENSSL_07_006: [ If successful x509_openssl_add_ecc_credentials shall to import each certificate in the cert chain. ] */
-#if (OPENSSL_VERSION_NUMBER >= 0x10100000L) && (OPENSSL_VERSION_NUMBER < 0x20000000L)
-                SSL_CTX_clear_extra_chain_certs(ssl_ctx);
-#else
-                if (ssl_ctx->extra_certs != NULL)
-                {
-                    sk_X509_pop_free(ssl_ctx->extra_certs, X509_free);
-                    ssl_ctx->extra_certs = NULL;
-                }
-#endif
+                clear_extra_chain_certs(ssl_ctx);
                 while ((ca_chain = PEM_read_bio_X509(bio_cert, NULL, NULL, NULL)) != NULL)
                 {
                     if (SSL_CTX_add_extra_chain_cert(ssl_ctx, ca_chain) != 1)
@@ -346,3 +388,511 @@ int x509_openssl_add_certificates(SSL_CTX* ssl_ctx, const char* certificates)
 
 }
 
+static void free_credentials(X509_OPENSSL_CREDENTIALS* credentials)
+{
+    size_t i;
+
+    for (i = 0; i < credentials->ca_certificate_count; i++)
+    {
+        X509_free(credentials->ca_certificates[i]);
+    }
+    free(credentials->ca_certificates);
+
+    if (credentials->certificate != NULL)
+    {
+        X509_free(credentials->certificate);
+    }
+    if (credentials->evp_key != NULL)
+    {
+        EVP_PKEY_free(credentials->evp_key);
+    }
+    free(credentials);
+}
+
+static int compute_digest(const char* pem, unsigned char digest[X509_OPENSSL_DIGEST_SIZE])
+{
+    int result;
+
+    if (EVP_Digest(pem, strlen(pem), digest, NULL, EVP_sha256(), NULL) != 1)
+    {
+        log_ERR_get_error("failure computing the PEM digest");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static int parse_private_key(X509_OPENSSL_CREDENTIALS* credentials, const char* x509privatekey)
+{
+    int result;
+    BIO* bio_key = BIO_new_mem_buf((char*)x509privatekey, -1); /*taking off the const from the pointer is needed on older versions of OPENSSL*/
+
+    if (bio_key == NULL)
+    {
+        log_ERR_get_error("cannot create private key BIO");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if ((credentials->evp_key = PEM_read_bio_PrivateKey(bio_key, NULL, NULL, NULL)) == NULL)
+        {
+            log_ERR_get_error("Failure creating private key evp_key");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+        BIO_free(bio_key);
+    }
+
+    return result;
+}
+
+static int parse_certificate_chain(X509_OPENSSL_CREDENTIALS* credentials, const char* x509certificate)
+{
+    int result;
+    BIO* bio_cert = BIO_new_mem_buf((char*)x509certificate, -1);
+
+    if (bio_cert == NULL)
+    {
+        log_ERR_get_error("cannot create BIO");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if ((credentials->certificate = PEM_read_bio_X509_AUX(bio_cert, NULL, NULL, NULL)) == NULL)
+        {
+            log_ERR_get_error("Failure PEM_read_bio_X509_AUX");
+            result = __FAILURE__;
+        }
+        else
+        {
+            X509* ca_certificate;
+
+            result = 0;
+            while ((ca_certificate = PEM_read_bio_X509(bio_cert, NULL, NULL, NULL)) != NULL)
+            {
+                X509** new_ca_certificates = (X509**)realloc(credentials->ca_certificates, (credentials->ca_certificate_count + 1) * sizeof(X509*));
+                if (new_ca_certificates == NULL)
+                {
+                    LogError("Failure allocating the CA certificates");
+                    X509_free(ca_certificate);
+                    result = __FAILURE__;
+                    break;
+                }
+                else
+                {
+                    credentials->ca_certificates = new_ca_certificates;
+                    credentials->ca_certificates[credentials->ca_certificate_count++] = ca_certificate;
+                }
+            }
+
+            if (result == 0)
+            {
+                // The chain ends at EOF, reported as a missing start line
+                unsigned long err_value = ERR_peek_last_error();
+                if ((err_value == 0) || (ERR_GET_LIB(err_value) == ERR_LIB_PEM && ERR_GET_REASON(err_value) == PEM_R_NO_START_LINE))
+                {
+                    ERR_clear_error();
+                }
+                else
+                {
+                    log_ERR_get_error("Failure reading the certificate chain");
+                    result = __FAILURE__;
+                }
+            }
+        }
+        BIO_free(bio_cert);
+    }
+
+    return result;
+}
+
+static X509_OPENSSL_CREDENTIALS* parse_credentials(const char* x509certificate, const char* x509privatekey, const unsigned char* certificate_digest, const unsigned char* private_key_digest)
+{
+    X509_OPENSSL_CREDENTIALS* result;
+
+    if ((result = (X509_OPENSSL_CREDENTIALS*)malloc(sizeof(X509_OPENSSL_CREDENTIALS))) == NULL)
+    {
+        LogError("Failure allocating the x509 credentials");
+    }
+    else
+    {
+        (void)memset(result, 0, sizeof(X509_OPENSSL_CREDENTIALS));
+        (void)memcpy(result->certificate_digest, certificate_digest, X509_OPENSSL_DIGEST_SIZE);
+        (void)memcpy(result->private_key_digest, private_key_digest, X509_OPENSSL_DIGEST_SIZE);
+        result->ref_count = 1;
+
+        if ((parse_private_key(result, x509privatekey) != 0) ||
+            (parse_certificate_chain(result, x509certificate) != 0))
+        {
+            LogError("Failure parsing the x509 credentials");
+            free_credentials(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+int x509_openssl_credentials_cache_init(void)
+{
+    int result;
+
+    if (credentials_cache_lock != NULL)
+    {
+        /* Codes_SRS_X509_OPENSSL_01_002: [ If the cache is already initialized, x509_openssl_credentials_cache_init shall fail and return a non-zero value. ]*/
+        LogError("The x509 credentials cache is already initialized");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_X509_OPENSSL_01_001: [ x509_openssl_credentials_cache_init shall create the lock guarding the process wide cache and return 0. ]*/
+    else if ((credentials_cache_lock = Lock_Init()) == NULL)
+    {
+        /* Codes_SRS_X509_OPENSSL_01_003: [ If Lock_Init fails, x509_openssl_credentials_cache_init shall fail and return a non-zero value. ]*/
+        LogError("Failure creating the x509 credentials cache lock");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+void x509_openssl_credentials_cache_deinit(void)
+{
+    if (credentials_cache_lock != NULL)
+    {
+        /* Codes_SRS_X509_OPENSSL_01_004: [ x509_openssl_credentials_cache_deinit shall remove all the credentials from the cache; the ones still acquired shall be freed by their last x509_openssl_credentials_release. ]*/
+        while (credentials_cache != NULL)
+        {
+            X509_OPENSSL_CREDENTIALS* credentials = credentials_cache;
+            credentials_cache = credentials->next;
+            credentials->cached = false;
+            credentials->next = NULL;
+        }
+
+        /* Codes_SRS_X509_OPENSSL_01_005: [ x509_openssl_credentials_cache_deinit shall free the cache lock. ]*/
+        Lock_Deinit(credentials_cache_lock);
+        credentials_cache_lock = NULL;
+    }
+}
+
+X509_OPENSSL_CREDENTIALS_HANDLE x509_openssl_credentials_acquire(const char* x509certificate, const char* x509privatekey)
+{
+    X509_OPENSSL_CREDENTIALS* result;
+    unsigned char certificate_digest[X509_OPENSSL_DIGEST_SIZE];
+    unsigned char private_key_digest[X509_OPENSSL_DIGEST_SIZE];
+
+    if ((x509certificate == NULL) || (x509privatekey == NULL))
+    {
+        /* Codes_SRS_X509_OPENSSL_01_006: [ If x509certificate or x509privatekey is NULL, x509_openssl_credentials_acquire shall fail and return NULL. ]*/
+        LogError("invalid parameter detected: x509certificate=%p, x509privatekey=%p", x509certificate, x509privatekey);
+        result = NULL;
+    }
+    /* Codes_SRS_X509_OPENSSL_01_007: [ x509_openssl_credentials_acquire shall compute the SHA-256 digest of x509certificate and of x509privatekey by calling EVP_Digest. ]*/
+    else if ((compute_digest(x509certificate, certificate_digest) != 0) ||
+        (compute_digest(x509privatekey, private_key_digest) != 0))
+    {
+        /* Codes_SRS_X509_OPENSSL_01_013: [ If any failure is encountered, x509_openssl_credentials_acquire shall fail and return NULL. ]*/
+        result = NULL;
+    }
+    else if (credentials_cache_lock == NULL)
+    {
+        /* Codes_SRS_X509_OPENSSL_01_008: [ If the cache is not initialized, x509_openssl_credentials_acquire shall return credentials parsed from x509certificate and x509privatekey that are not shared. ]*/
+        result = parse_credentials(x509certificate, x509privatekey, certificate_digest, private_key_digest);
+    }
+    else if (Lock(credentials_cache_lock) != LOCK_OK)
+    {
+        /* Codes_SRS_X509_OPENSSL_01_013: [ If any failure is encountered, x509_openssl_credentials_acquire shall fail and return NULL. ]*/
+        LogError("Failure locking the x509 credentials cache");
+        result = NULL;
+    }
+    else
+    {
+        result = credentials_cache;
+        while ((result != NULL) &&
+            ((memcmp(result->certificate_digest, certificate_digest, X509_OPENSSL_DIGEST_SIZE) != 0) ||
+             (memcmp(result->private_key_digest, private_key_digest, X509_OPENSSL_DIGEST_SIZE) != 0)))
+        {
+            result = result->next;
+        }
+
+        if (result != NULL)
+        {
+            /* Codes_SRS_X509_OPENSSL_01_009: [ If credentials with the same digests are in the cache, x509_openssl_credentials_acquire shall increment their reference count and return them without parsing the PEM text. ]*/
+            result->ref_count++;
+        }
+        /* Codes_SRS_X509_OPENSSL_01_010: [ Otherwise x509_openssl_credentials_acquire shall read the private key with PEM_read_bio_PrivateKey, the certificate with PEM_read_bio_X509_AUX and the rest of the chain with PEM_read_bio_X509, and add the parsed credentials to the cache. ]*/
+        else if ((result = parse_credentials(x509certificate, x509privatekey, certificate_digest, private_key_digest)) != NULL)
+        {
+            result->cached = true;
+            result->next = credentials_cache;
+            credentials_cache = result;
+        }
+
+        (void)Unlock(credentials_cache_lock);
+    }
+
+    return result;
+}
+
+void x509_openssl_credentials_release(X509_OPENSSL_CREDENTIALS_HANDLE credentials)
+{
+    if (credentials == NULL)
+    {
+        /* Codes_SRS_X509_OPENSSL_01_011: [ If credentials is NULL, x509_openssl_credentials_release shall return. ]*/
+        LogError("invalid parameter detected: credentials=NULL");
+    }
+    else if (!credentials->cached)
+    {
+        /* Codes_SRS_X509_OPENSSL_01_012: [ x509_openssl_credentials_release shall decrement the reference count of credentials and free them, removing them from the cache, when it reaches 0. ]*/
+        if (--credentials->ref_count == 0)
+        {
+            free_credentials(credentials);
+        }
+    }
+    else if (Lock(credentials_cache_lock) != LOCK_OK)
+    {
+        LogError("Failure locking the x509 credentials cache");
+    }
+    else
+    {
+        /* Codes_SRS_X509_OPENSSL_01_012: [ x509_openssl_credentials_release shall decrement the reference count of credentials and free them, removing them from the cache, when it reaches 0. ]*/
+        if (--credentials->ref_count == 0)
+        {
+            X509_OPENSSL_CREDENTIALS** entry = &credentials_cache;
+
+            while ((*entry != NULL) && (*entry != credentials))
+            {
+                entry = &(*entry)->next;
+            }
+            if (*entry != NULL)
+            {
+                *entry = credentials->next;
+            }
+
+            free_credentials(credentials);
+        }
+
+        (void)Unlock(credentials_cache_lock);
+    }
+}
+
+int x509_openssl_add_parsed_credentials(SSL_CTX* ssl_ctx, X509_OPENSSL_CREDENTIALS_HANDLE credentials)
+{
+    int result;
+
+    if ((ssl_ctx == NULL) || (credentials == NULL))
+    {
+        /* Codes_SRS_X509_OPENSSL_01_014: [ If ssl_ctx or credentials is NULL, x509_openssl_add_parsed_credentials shall fail and return a non-zero value. ]*/
+        LogError("invalid parameter detected: ssl_ctx=%p, credentials=%p", ssl_ctx, credentials);
+        result = __FAILURE__;
+    }
+    else
+    {
+        // Check the type for the EVP key
+        int evp_type = EVP_PKEY_id(credentials->evp_key);
+
+        /* Codes_SRS_X509_OPENSSL_01_015: [ x509_openssl_add_parsed_credentials shall load the private key of credentials into ssl_ctx the same way x509_openssl_add_credentials does. ]*/
+        if (((evp_type == EVP_PKEY_RSA || evp_type == EVP_PKEY_RSA2) ? load_key_RSA(ssl_ctx, credentials->evp_key) : load_ecc_key(ssl_ctx, credentials->evp_key)) != 0)
+        {
+            /* Codes_SRS_X509_OPENSSL_01_018: [ If any failure is encountered, x509_openssl_add_parsed_credentials shall fail and return a non-zero value. ]*/
+            LogError("failure loading private key");
+            result = __FAILURE__;
+        }
+        /* Codes_SRS_X509_OPENSSL_01_016: [ x509_openssl_add_parsed_credentials shall load the certificate of credentials by calling SSL_CTX_use_certificate. ]*/
+        else if (SSL_CTX_use_certificate(ssl_ctx, credentials->certificate) != 1)
+        {
+            /* Codes_SRS_X509_OPENSSL_01_018: [ If any failure is encountered, x509_openssl_add_parsed_credentials shall fail and return a non-zero value. ]*/
+            log_ERR_get_error("Failure SSL_CTX_use_certificate");
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t i;
+
+            /* Codes_SRS_X509_OPENSSL_01_017: [ x509_openssl_add_parsed_credentials shall replace the extra chain certificates of ssl_ctx with a new reference to each CA certificate of credentials. ]*/
+            clear_extra_chain_certs(ssl_ctx);
+
+            result = 0;
+            for (i = 0; i < credentials->ca_certificate_count; i++)
+            {
+                // SSL_CTX_add_extra_chain_cert takes ownership of the reference
+                (void)X509_OPENSSL_UP_REF(credentials->ca_certificates[i]);
+                if (SSL_CTX_add_extra_chain_cert(ssl_ctx, credentials->ca_certificates[i]) != 1)
+                {
+                    /* Codes_SRS_X509_OPENSSL_01_018: [ If any failure is encountered, x509_openssl_add_parsed_credentials shall fail and return a non-zero value. ]*/
+                    log_ERR_get_error("Failure SSL_CTX_add_extra_chain_cert");
+                    X509_free(credentials->ca_certificates[i]);
+                    result = __FAILURE__;
+                    break;
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+static int use_private_key_and_chain(SSL_CTX* ssl_ctx, EVP_PKEY* evp_key, const char* x509certificate)
+{
+    int result;
+
+    if (SSL_CTX_use_PrivateKey(ssl_ctx, evp_key) != 1)
+    {
+        log_ERR_get_error("Failed SSL_CTX_use_PrivateKey");
+        result = __FAILURE__;
+    }
+    else if (load_certificate_chain(ssl_ctx, x509certificate) != 0)
+    {
+        LogError("failure loading private key cert");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+#ifdef X509_OPENSSL_ENGINES_SUPPORTED
+int x509_openssl_add_engine_credentials(SSL_CTX* ssl_ctx, const char* x509certificate, ENGINE* engine, const char* x509privatekey_id)
+{
+    int result;
+
+    if ((ssl_ctx == NULL) || (x509certificate == NULL) || (engine == NULL) || (x509privatekey_id == NULL))
+    {
+        /* Codes_SRS_X509_OPENSSL_01_019: [ If ssl_ctx, x509certificate, engine or x509privatekey_id is NULL, x509_openssl_add_engine_credentials shall fail and return a non-zero value. ]*/
+        LogError("invalid parameter detected: ssl_ctx=%p, x509certificate=%p, engine=%p, x509privatekey_id=%p", ssl_ctx, x509certificate, engine, x509privatekey_id);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_X509_OPENSSL_01_020: [ x509_openssl_add_engine_credentials shall get the private key x509privatekey_id of engine by calling ENGINE_load_private_key. ]*/
+        EVP_PKEY* evp_key = ENGINE_load_private_key(engine, x509privatekey_id, NULL, NULL);
+        if (evp_key == NULL)
+        {
+            /* Codes_SRS_X509_OPENSSL_01_022: [ If any failure is encountered, x509_openssl_add_engine_credentials shall fail and return a non-zero value. ]*/
+            log_ERR_get_error("Failure ENGINE_load_private_key");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_X509_OPENSSL_01_021: [ x509_openssl_add_engine_credentials shall load the private key into ssl_ctx by calling SSL_CTX_use_PrivateKey and the certificate chain of x509certificate the same way x509_openssl_add_credentials does. ]*/
+            if (use_private_key_and_chain(ssl_ctx, evp_key, x509certificate) != 0)
+            {
+                /* Codes_SRS_X509_OPENSSL_01_022: [ If any failure is encountered, x509_openssl_add_engine_credentials shall fail and return a non-zero value. ]*/
+                LogError("failure loading engine private key");
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+            EVP_PKEY_free(evp_key);
+        }
+    }
+
+    return result;
+}
+#endif // X509_OPENSSL_ENGINES_SUPPORTED
+
+#ifdef X509_OPENSSL_STORE_SUPPORTED
+static EVP_PKEY* load_store_private_key(const char* uri)
+{
+    EVP_PKEY* result = NULL;
+    // The URI is not logged since it may carry the PIN of the token
+    OSSL_STORE_CTX* store = OSSL_STORE_open(uri, UI_null(), NULL, NULL, NULL);
+    if (store == NULL)
+    {
+        log_ERR_get_error("Failure OSSL_STORE_open");
+    }
+    else
+    {
+        // Not all loaders can be told what to look for, the loop below skips what is not a key
+        (void)OSSL_STORE_expect(store, OSSL_STORE_INFO_PKEY);
+
+        while ((result == NULL) && !OSSL_STORE_eof(store))
+        {
+            OSSL_STORE_INFO* info = OSSL_STORE_load(store);
+            if (info == NULL)
+            {
+                if (OSSL_STORE_error(store))
+                {
+                    log_ERR_get_error("Failure OSSL_STORE_load");
+                    break;
+                }
+            }
+            else
+            {
+                if (OSSL_STORE_INFO_get_type(info) == OSSL_STORE_INFO_PKEY)
+                {
+                    result = OSSL_STORE_INFO_get1_PKEY(info);
+                }
+                OSSL_STORE_INFO_free(info);
+            }
+        }
+
+        if (result == NULL)
+        {
+            LogError("no private key found at the URI");
+        }
+        (void)OSSL_STORE_close(store);
+    }
+    return result;
+}
+#endif // X509_OPENSSL_STORE_SUPPORTED
+
+int x509_openssl_add_uri_credentials(SSL_CTX* ssl_ctx, const char* x509certificate, const char* x509privatekey_uri)
+{
+    int result;
+
+    if ((ssl_ctx == NULL) || (x509certificate == NULL) || (x509privatekey_uri == NULL))
+    {
+        /* Codes_SRS_X509_OPENSSL_01_023: [ If ssl_ctx, x509certificate or x509privatekey_uri is NULL, x509_openssl_add_uri_credentials shall fail and return a non-zero value. ]*/
+        LogError("invalid parameter detected: ssl_ctx=%p, x509certificate=%p, x509privatekey_uri=%p", ssl_ctx, x509certificate, x509privatekey_uri);
+        result = __FAILURE__;
+    }
+    else
+    {
+#ifdef X509_OPENSSL_STORE_SUPPORTED
+        /* Codes_SRS_X509_OPENSSL_01_024: [ x509_openssl_add_uri_credentials shall get the first private key found at x509privatekey_uri by calling OSSL_STORE_open and OSSL_STORE_load. ]*/
+        EVP_PKEY* evp_key = load_store_private_key(x509privatekey_uri);
+        if (evp_key == NULL)
+        {
+            /* Codes_SRS_X509_OPENSSL_01_027: [ If any failure is encountered, x509_openssl_add_uri_credentials shall fail and return a non-zero value. ]*/
+            LogError("failure loading private key from its URI");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_X509_OPENSSL_01_025: [ x509_openssl_add_uri_credentials shall load the private key into ssl_ctx by calling SSL_CTX_use_PrivateKey and the certificate chain of x509certificate the same way x509_openssl_add_credentials does. ]*/
+            if (use_private_key_and_chain(ssl_ctx, evp_key, x509certificate) != 0)
+            {
+                /* Codes_SRS_X509_OPENSSL_01_027: [ If any failure is encountered, x509_openssl_add_uri_credentials shall fail and return a non-zero value. ]*/
+                LogError("failure loading URI private key");
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+            EVP_PKEY_free(evp_key);
+        }
+#else
+        /* Codes_SRS_X509_OPENSSL_01_026: [ If OSSL_STORE is not available (OpenSSL older than 1.1.1 or LibreSSL), x509_openssl_add_uri_credentials shall fail and return a non-zero value. ]*/
+        LogError("private key URIs need OpenSSL 1.1.1 or later");
+        result = __FAILURE__;
+#endif
+    }
+
+    return result;
+}
@@ -0,0 +1,1379 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* Microbenchmarks of the core primitives of the library.
+
+   Each benchmark runs with a doubling number of iterations until it takes at least
+   BENCHMARK_MIN_ELAPSED_US, then prints one CSV line on stdout:
+
+   benchmark,parameter,iterations,elapsed_us,ns_per_iteration,mb_per_second
+
+   mb_per_second is empty for the benchmarks that do not process a number of bytes.
+   An optional argument only runs the benchmarks whose name contains it. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "azure_c_shared_utility/base32.h"
+#include "azure_c_shared_utility/base64.h"
+#include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/constbuffer.h"
+#include "azure_c_shared_utility/constmap.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/gb_rand.h"
+#include "azure_c_shared_utility/hmacsha256.h"
+#include "azure_c_shared_utility/map.h"
+#include "azure_c_shared_utility/memio.h"
+#include "azure_c_shared_utility/sha.h"
+#include "azure_c_shared_utility/strhash.h"
+#include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/urlencode.h"
+#ifdef BENCHMARK_WSIO
+#include "azure_c_shared_utility/uws_frame_decoder.h"
+#include "azure_c_shared_utility/uws_frame_encoder.h"
+#include "azure_c_shared_utility/utf8_checker.h"
+#endif
+
+#define BENCHMARK_MIN_ELAPSED_US 200000
+#define BENCHMARK_MAX_ITERATIONS ((size_t)1 << 30)
+
+#define BENCHMARK_PIECE_COUNT 64
+#define BENCHMARK_DATA_SIZE 4096
+#define BENCHMARK_MAP_MAX_KEYS 1000
+
+typedef struct BENCHMARK_TAG
+{
+    const char* name;
+    /* the size of the data or the number of elements the benchmark works on */
+    size_t parameter;
+    /* the number of bytes processed by an iteration, 0 if it does not apply */
+    size_t bytes_per_iteration;
+    void*(*setup)(size_t parameter);
+    /* returns 0 on success */
+    int(*run)(void* context, size_t parameter, size_t iterations);
+    void(*teardown)(void* context);
+} BENCHMARK;
+
+static unsigned char data[BENCHMARK_DATA_SIZE];
+static char text[BENCHMARK_DATA_SIZE + 1];
+static char encoded[(BENCHMARK_DATA_SIZE * 3) + 1];
+static unsigned char decoded[BENCHMARK_DATA_SIZE];
+
+static const unsigned char key[32] = "0123456789abcdef0123456789abcdef";
+
+static void* no_setup(size_t parameter)
+{
+    (void)parameter;
+    /* any non-NULL value, the benchmark has no context */
+    return data;
+}
+
+static void no_teardown(void* context)
+{
+    (void)context;
+}
+
+/* STRING and BUFFER */
+
+static int run_string_concat(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)context;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        STRING_HANDLE string = STRING_new();
+        if (string == NULL)
+        {
+            result = 1;
+        }
+        else
+        {
+            size_t j;
+            for (j = 0; (j < parameter) && (result == 0); j++)
+            {
+                result = STRING_concat(string, "abcdefghijklmnop");
+            }
+            STRING_delete(string);
+        }
+    }
+
+    return result;
+}
+
+static int run_string_sprintf(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)context;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        STRING_HANDLE string = STRING_construct_sprintf("%s/%lu", "devices", (unsigned long)i);
+        if (string == NULL)
+        {
+            result = 1;
+        }
+        else
+        {
+            size_t j;
+            for (j = 0; (j < parameter) && (result == 0); j++)
+            {
+                result = STRING_sprintf(string, "&%s=%lu", "param", (unsigned long)j);
+            }
+            STRING_delete(string);
+        }
+    }
+
+    return result;
+}
+
+static int run_string_construct(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)context;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        STRING_HANDLE string = STRING_construct_n(text, parameter);
+        if (string == NULL)
+        {
+            result = 1;
+        }
+        else
+        {
+            STRING_delete(string);
+        }
+    }
+
+    return result;
+}
+
+static int run_string_new_json(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    char saved = text[parameter];
+    (void)context;
+
+    text[parameter] = '\0';
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        STRING_HANDLE string = STRING_new_JSON(text);
+        if (string == NULL)
+        {
+            result = 1;
+        }
+        else
+        {
+            STRING_delete(string);
+        }
+    }
+    text[parameter] = saved;
+
+    return result;
+}
+
+static int run_buffer_append_build(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)context;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        BUFFER_HANDLE buffer = BUFFER_new();
+        if (buffer == NULL)
+        {
+            result = 1;
+        }
+        else
+        {
+            size_t j;
+            for (j = 0; (j < parameter) && (result == 0); j++)
+            {
+                result = BUFFER_append_build(buffer, data, 16);
+            }
+            BUFFER_delete(buffer);
+        }
+    }
+
+    return result;
+}
+
+static void* setup_buffer(size_t parameter)
+{
+    (void)parameter;
+    return BUFFER_new();
+}
+
+static int run_buffer_build(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        result = BUFFER_build((BUFFER_HANDLE)context, data, parameter);
+    }
+
+    return result;
+}
+
+static void teardown_buffer(void* context)
+{
+    BUFFER_delete((BUFFER_HANDLE)context);
+}
+
+/* Map */
+
+static char map_keys[BENCHMARK_MAP_MAX_KEYS][16];
+
+static void* setup_map(size_t parameter)
+{
+    MAP_HANDLE map = Map_Create(NULL);
+    if (map != NULL)
+    {
+        size_t i;
+        for (i = 0; i < parameter; i++)
+        {
+            if (Map_Add(map, map_keys[i], "value") != MAP_OK)
+            {
+                Map_Destroy(map);
+                map = NULL;
+                break;
+            }
+        }
+    }
+
+    return map;
+}
+
+static int run_map_lookup(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        if (Map_GetValueFromKey((MAP_HANDLE)context, map_keys[i % parameter]) == NULL)
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+static int run_map_lookup_missing(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)parameter;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        if (Map_GetValueFromKey((MAP_HANDLE)context, "missing_key") != NULL)
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+static int run_map_to_json(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)parameter;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        STRING_HANDLE json = Map_ToJSON((MAP_HANDLE)context);
+        if (json == NULL)
+        {
+            result = 1;
+        }
+        else
+        {
+            STRING_delete(json);
+        }
+    }
+
+    return result;
+}
+
+static int run_map_to_json_buffer(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)parameter;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        BUFFER_HANDLE json = BUFFER_new();
+        if (json == NULL)
+        {
+            result = 1;
+        }
+        else
+        {
+            if (Map_ToJSONBuffer((MAP_HANDLE)context, json) != MAP_OK)
+            {
+                result = 1;
+            }
+            BUFFER_delete(json);
+        }
+    }
+
+    return result;
+}
+
+static int run_map_clone(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)parameter;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        MAP_HANDLE clone = Map_Clone((MAP_HANDLE)context);
+        if (clone == NULL)
+        {
+            result = 1;
+        }
+        else
+        {
+            Map_Destroy(clone);
+        }
+    }
+
+    return result;
+}
+
+static int run_map_clone_update(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)parameter;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        MAP_HANDLE clone = Map_Clone((MAP_HANDLE)context);
+        if (clone == NULL)
+        {
+            result = 1;
+        }
+        else
+        {
+            if (Map_AddOrUpdate(clone, map_keys[0], "other") != MAP_OK)
+            {
+                result = 1;
+            }
+            Map_Destroy(clone);
+        }
+    }
+
+    return result;
+}
+
+static void teardown_map(void* context)
+{
+    Map_Destroy((MAP_HANDLE)context);
+}
+
+static void* setup_constmap(size_t parameter)
+{
+    CONSTMAP_HANDLE result = NULL;
+    MAP_HANDLE map = (MAP_HANDLE)setup_map(parameter);
+    if (map != NULL)
+    {
+        result = ConstMap_Create(map);
+        Map_Destroy(map);
+    }
+
+    return result;
+}
+
+static int run_constmap_lookup(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        if (ConstMap_GetValue((CONSTMAP_HANDLE)context, map_keys[i % parameter]) == NULL)
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+static int run_constmap_lookup_missing(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)parameter;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        if (ConstMap_ContainsKey((CONSTMAP_HANDLE)context, "missing_key"))
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+static void teardown_constmap(void* context)
+{
+    ConstMap_Destroy((CONSTMAP_HANDLE)context);
+}
+
+static int run_map_build(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)context;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        MAP_HANDLE map = (MAP_HANDLE)setup_map(parameter);
+        if (map == NULL)
+        {
+            result = 1;
+        }
+        else
+        {
+            Map_Destroy(map);
+        }
+    }
+
+    return result;
+}
+
+/* encodings */
+
+static int run_base64_encode(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)context;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        result = Base64_Encode_To(data, parameter, encoded, sizeof(encoded));
+    }
+
+    return result;
+}
+
+static void* setup_base64_decode(size_t parameter)
+{
+    return (Base64_Encode_To(data, parameter, encoded, sizeof(encoded)) == 0) ? encoded : NULL;
+}
+
+static int run_base64_decode(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)parameter;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        size_t decoded_size;
+        result = Base64_Decode_To((const char*)context, decoded, sizeof(decoded), &decoded_size);
+    }
+
+    return result;
+}
+
+static int run_base32_encode(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)context;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        result = Base32_Encode_To(data, parameter, encoded, sizeof(encoded));
+    }
+
+    return result;
+}
+
+static void* setup_base32_decode(size_t parameter)
+{
+    return (Base32_Encode_To(data, parameter, encoded, sizeof(encoded)) == 0) ? encoded : NULL;
+}
+
+static int run_base32_decode(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)parameter;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        size_t decoded_size;
+        result = Base32_Decode_To((const char*)context, decoded, sizeof(decoded), &decoded_size);
+    }
+
+    return result;
+}
+
+static int run_url_encode(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    char saved = text[parameter];
+    (void)context;
+
+    text[parameter] = '\0';
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        result = URL_Encode_To(text, encoded, sizeof(encoded));
+    }
+    text[parameter] = saved;
+
+    return result;
+}
+
+/* hashes */
+
+/* the *_portable benchmarks turn the SHA instructions of the CPU off for comparison */
+static void* setup_portable_sha(size_t parameter)
+{
+    (void)parameter;
+    (void)SHA1UseHardwareAcceleration(0);
+    (void)SHA256UseHardwareAcceleration(0);
+    (void)SHA512UseHardwareAcceleration(0);
+    return data;
+}
+
+static void teardown_portable_sha(void* context)
+{
+    (void)context;
+    /* fails, leaving the portable code in use, when the CPU does not have the instructions */
+    (void)SHA1UseHardwareAcceleration(1);
+    (void)SHA256UseHardwareAcceleration(1);
+    (void)SHA512UseHardwareAcceleration(1);
+}
+
+static int run_sha1(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)context;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        SHA1Context sha;
+        uint8_t digest[SHA1HashSize];
+        if ((SHA1Reset(&sha) != shaSuccess) ||
+            (SHA1Input(&sha, data, (unsigned int)parameter) != shaSuccess) ||
+            (SHA1Result(&sha, digest) != shaSuccess))
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+static int run_sha256(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)context;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        SHA256Context sha;
+        uint8_t digest[SHA256HashSize];
+        if ((SHA256Reset(&sha) != shaSuccess) ||
+            (SHA256Input(&sha, data, (unsigned int)parameter) != shaSuccess) ||
+            (SHA256Result(&sha, digest) != shaSuccess))
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+static int run_sha512(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)context;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        SHA512Context sha;
+        uint8_t digest[SHA512HashSize];
+        if ((SHA512Reset(&sha) != shaSuccess) ||
+            (SHA512Input(&sha, data, (unsigned int)parameter) != shaSuccess) ||
+            (SHA512Result(&sha, digest) != shaSuccess))
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+static int run_hmacsha256(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)context;
+
+    /* a new hash buffer each time, like the SAS token code */
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        BUFFER_HANDLE hash = BUFFER_new();
+        if (hash == NULL)
+        {
+            result = 1;
+        }
+        else
+        {
+            if (HMACSHA256_ComputeHash(key, sizeof(key), data, parameter, hash) != HMACSHA256_OK)
+            {
+                result = 1;
+            }
+            BUFFER_delete(hash);
+        }
+    }
+
+    return result;
+}
+
+#define BENCHMARK_HMAC_BATCH_SIZE 8
+
+static void* setup_hmacsha256_batch(size_t parameter)
+{
+    HMACSHA256_BATCH_ITEM* items = (HMACSHA256_BATCH_ITEM*)malloc(BENCHMARK_HMAC_BATCH_SIZE * sizeof(HMACSHA256_BATCH_ITEM));
+    size_t i;
+
+    if (items != NULL)
+    {
+        for (i = 0; i < BENCHMARK_HMAC_BATCH_SIZE; i++)
+        {
+            items[i].key = key;
+            items[i].keyLen = sizeof(key);
+            items[i].payload = data + i;
+            items[i].payloadLen = parameter;
+            items[i].hash = NULL;
+        }
+    }
+
+    return items;
+}
+
+static int run_hmacsha256_batch(void* context, size_t parameter, size_t iterations)
+{
+    HMACSHA256_BATCH_ITEM* items = (HMACSHA256_BATCH_ITEM*)context;
+    int result = 0;
+    size_t i;
+    (void)parameter;
+
+    /* one iteration is one hash, computed BENCHMARK_HMAC_BATCH_SIZE at a time in new hash buffers */
+    for (i = 0; (i < iterations) && (result == 0); i += BENCHMARK_HMAC_BATCH_SIZE)
+    {
+        size_t count = ((iterations - i) < BENCHMARK_HMAC_BATCH_SIZE) ? (iterations - i) : BENCHMARK_HMAC_BATCH_SIZE;
+        size_t j;
+
+        for (j = 0; j < count; j++)
+        {
+            if ((items[j].hash = BUFFER_new()) == NULL)
+            {
+                result = 1;
+            }
+        }
+        if ((result == 0) &&
+            (HMACSHA256_ComputeHashBatch(items, count) != HMACSHA256_OK))
+        {
+            result = 1;
+        }
+        for (j = 0; j < count; j++)
+        {
+            BUFFER_delete(items[j].hash);
+            items[j].hash = NULL;
+        }
+    }
+
+    return result;
+}
+
+static void teardown_hmacsha256_batch(void* context)
+{
+    free(context);
+}
+
+#ifdef BENCHMARK_WSIO
+
+/* WebSocket */
+
+static int run_uws_frame_encoder_encode(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)context;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        BUFFER_HANDLE frame = uws_frame_encoder_encode(WS_BINARY_FRAME, data, parameter, true, true, 0);
+        if (frame == NULL)
+        {
+            result = 1;
+        }
+        else
+        {
+            BUFFER_delete(frame);
+        }
+    }
+
+    return result;
+}
+
+static void* setup_uws_frame(size_t parameter)
+{
+    return malloc(UWS_FRAME_ENCODER_MAX_HEADER_SIZE + parameter);
+}
+
+/* what uws_client_send_frame_async does: header and masked payload laid out in memory that is reused */
+static int run_uws_frame_encoder_encode_header(void* context, size_t parameter, size_t iterations)
+{
+    unsigned char* frame = (unsigned char*)context;
+    int result = 0;
+    size_t i;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        size_t header_size;
+        result = uws_frame_encoder_encode_header(WS_BINARY_FRAME, parameter, true, true, 0, frame, &header_size);
+        uws_frame_encoder_mask(frame + header_size, data, parameter, frame + header_size - 4);
+    }
+
+    return result;
+}
+
+static void teardown_uws_frame(void* context)
+{
+    free(context);
+}
+
+/* the size of the TCP segments a frame arrives in */
+#define BENCHMARK_UWS_SEGMENT_SIZE 1500
+
+typedef struct BENCHMARK_UWS_FRAME_DECODER_TAG
+{
+    UWS_FRAME_DECODER_HANDLE uws_frame_decoder;
+    BUFFER_HANDLE frame;
+    uint64_t decoded_bytes;
+} BENCHMARK_UWS_FRAME_DECODER;
+
+static void on_benchmark_frame_decoded(void* context, const WS_FRAME_HEADER* header, const unsigned char* payload, size_t size, uint64_t offset)
+{
+    (void)header;
+    (void)payload;
+    (void)offset;
+    ((BENCHMARK_UWS_FRAME_DECODER*)context)->decoded_bytes += size;
+}
+
+static void teardown_uws_frame_decoder(void* context)
+{
+    BENCHMARK_UWS_FRAME_DECODER* benchmark_decoder = (BENCHMARK_UWS_FRAME_DECODER*)context;
+    uws_frame_decoder_destroy(benchmark_decoder->uws_frame_decoder);
+    BUFFER_delete(benchmark_decoder->frame);
+    free(benchmark_decoder);
+}
+
+static void* create_uws_frame_decoder(size_t parameter, bool is_masked)
+{
+    BENCHMARK_UWS_FRAME_DECODER* result = (BENCHMARK_UWS_FRAME_DECODER*)malloc(sizeof(BENCHMARK_UWS_FRAME_DECODER));
+
+    if (result != NULL)
+    {
+        result->decoded_bytes = 0;
+        result->uws_frame_decoder = uws_frame_decoder_create(on_benchmark_frame_decoded, result);
+        result->frame = uws_frame_encoder_encode(WS_BINARY_FRAME, data, parameter, is_masked, true, 0);
+        if ((result->uws_frame_decoder == NULL) || (result->frame == NULL))
+        {
+            teardown_uws_frame_decoder(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+/* frames as a server sends them */
+static void* setup_uws_frame_decoder(size_t parameter)
+{
+    return create_uws_frame_decoder(parameter, false);
+}
+
+/* frames as a client sends them */
+static void* setup_uws_frame_decoder_masked(size_t parameter)
+{
+    return create_uws_frame_decoder(parameter, true);
+}
+
+static int run_uws_frame_decoder_decode(void* context, size_t parameter, size_t iterations)
+{
+    BENCHMARK_UWS_FRAME_DECODER* benchmark_decoder = (BENCHMARK_UWS_FRAME_DECODER*)context;
+    const unsigned char* frame = BUFFER_u_char(benchmark_decoder->frame);
+    size_t frame_size = BUFFER_length(benchmark_decoder->frame);
+    int result = 0;
+    size_t i;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        size_t position;
+
+        for (position = 0; (position < frame_size) && (result == 0); position += BENCHMARK_UWS_SEGMENT_SIZE)
+        {
+            size_t size = ((frame_size - position) < BENCHMARK_UWS_SEGMENT_SIZE) ? (frame_size - position) : BENCHMARK_UWS_SEGMENT_SIZE;
+            result = uws_frame_decoder_decode(benchmark_decoder->uws_frame_decoder, frame + position, size);
+        }
+    }
+
+    if ((result == 0) &&
+        (benchmark_decoder->decoded_bytes != (uint64_t)parameter * iterations))
+    {
+        result = 1;
+    }
+    benchmark_decoder->decoded_bytes = 0;
+
+    return result;
+}
+
+static int run_utf8_checker(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        if (!utf8_checker_is_valid_utf8((const unsigned char*)context, parameter))
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+static void* setup_utf8(size_t parameter)
+{
+    /* ASCII with a 2, 3 and 4 byte sequence every 16 bytes */
+    static const unsigned char pattern[16] = { 'a', 'b', 'c', 'd', 0xC3, 0xA9, 'e', 'f', 0xE2, 0x82, 0xAC, 'g', 0xF0, 0x9F, 0x98, 0x80 };
+    size_t i;
+
+    for (i = 0; i < parameter; i++)
+    {
+        decoded[i] = pattern[i % sizeof(pattern)];
+    }
+
+    return decoded;
+}
+
+#endif
+
+/* CONSTBUFFER */
+
+static void* setup_constbuffer(size_t parameter)
+{
+    return CONSTBUFFER_Create(data, parameter);
+}
+
+static int run_constbuffer_refcount(void* context, size_t parameter, size_t iterations)
+{
+    size_t i;
+    (void)parameter;
+
+    for (i = 0; i < iterations; i++)
+    {
+        CONSTBUFFER_IncRef((CONSTBUFFER_HANDLE)context);
+        CONSTBUFFER_DecRef((CONSTBUFFER_HANDLE)context);
+    }
+
+    return 0;
+}
+
+static void teardown_constbuffer(void* context)
+{
+    CONSTBUFFER_DecRef((CONSTBUFFER_HANDLE)context);
+}
+
+static int run_constbuffer_create(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)context;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        CONSTBUFFER_HANDLE constbuffer = CONSTBUFFER_Create(data, parameter);
+        if (constbuffer == NULL)
+        {
+            result = 1;
+        }
+        else
+        {
+            CONSTBUFFER_DecRef(constbuffer);
+        }
+    }
+
+    return result;
+}
+
+/* memio */
+
+typedef struct BENCHMARK_MEMIO_TAG
+{
+    MEMIO_PAIR_HANDLE pair;
+    XIO_HANDLE sender;
+    XIO_HANDLE receiver;
+    size_t received;
+} BENCHMARK_MEMIO;
+
+static void on_benchmark_memio_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    (void)context;
+    (void)open_result;
+}
+
+static void on_benchmark_memio_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    (void)buffer;
+    ((BENCHMARK_MEMIO*)context)->received += size;
+}
+
+static void on_benchmark_memio_error(void* context)
+{
+    (void)context;
+}
+
+static void teardown_memio(void* context)
+{
+    BENCHMARK_MEMIO* benchmark_memio = (BENCHMARK_MEMIO*)context;
+
+    if (benchmark_memio != NULL)
+    {
+        if (benchmark_memio->sender != NULL)
+        {
+            xio_destroy(benchmark_memio->sender);
+        }
+        if (benchmark_memio->receiver != NULL)
+        {
+            xio_destroy(benchmark_memio->receiver);
+        }
+        if (benchmark_memio->pair != NULL)
+        {
+            memio_pair_destroy(benchmark_memio->pair);
+        }
+        free(benchmark_memio);
+    }
+}
+
+static void* create_memio(size_t max_chunk_size)
+{
+    BENCHMARK_MEMIO* result = (BENCHMARK_MEMIO*)calloc(1, sizeof(BENCHMARK_MEMIO));
+
+    if (result != NULL)
+    {
+        MEMIO_LINK_CONFIG link_config = { 0, 0, 0, 0 };
+        MEMIO_CONFIG sender_config;
+        MEMIO_CONFIG receiver_config;
+
+        link_config.max_chunk_size = max_chunk_size;
+        result->pair = memio_pair_create(&link_config, NULL);
+        sender_config.pair = result->pair;
+        sender_config.side = 0;
+        receiver_config.pair = result->pair;
+        receiver_config.side = 1;
+
+        if ((result->pair == NULL) ||
+            ((result->sender = xio_create(memio_get_interface_description(), &sender_config)) == NULL) ||
+            ((result->receiver = xio_create(memio_get_interface_description(), &receiver_config)) == NULL) ||
+            (xio_open(result->sender, on_benchmark_memio_open_complete, NULL, on_benchmark_memio_bytes_received, result, on_benchmark_memio_error, NULL) != 0) ||
+            (xio_open(result->receiver, on_benchmark_memio_open_complete, NULL, on_benchmark_memio_bytes_received, result, on_benchmark_memio_error, NULL) != 0))
+        {
+            teardown_memio(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+static void* setup_memio(size_t parameter)
+{
+    (void)parameter;
+    return create_memio(0);
+}
+
+/* the chunking an IO over TCP sees at worst, a callback every 16 bytes */
+static void* setup_memio_chunked(size_t parameter)
+{
+    (void)parameter;
+    return create_memio(16);
+}
+
+static int run_memio_send(void* context, size_t parameter, size_t iterations)
+{
+    BENCHMARK_MEMIO* benchmark_memio = (BENCHMARK_MEMIO*)context;
+    int result = 0;
+    size_t i;
+
+    benchmark_memio->received = 0;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        if (xio_send(benchmark_memio->sender, data, parameter, NULL, NULL) != 0)
+        {
+            result = 1;
+        }
+        else
+        {
+            xio_dowork(benchmark_memio->sender);
+            xio_dowork(benchmark_memio->receiver);
+        }
+    }
+
+    if (benchmark_memio->received != iterations * parameter)
+    {
+        result = 1;
+    }
+
+    return result;
+}
+
+/* number formatting and parsing */
+
+static int run_size_tToString(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    char number[32];
+    size_t i;
+    (void)context;
+    (void)parameter;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        /* the expiry of a SAS token has 10 digits */
+        if (size_tToString(number, sizeof(number), 1500000000 + i) != 0)
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+static int run_strtoull_s(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)context;
+    (void)parameter;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        if (strtoull_s("1500000000", NULL, 10) != 1500000000ULL)
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+static int run_strtof_s(void* context, size_t parameter, size_t iterations)
+{
+    int result = 0;
+    size_t i;
+    (void)context;
+    (void)parameter;
+
+    for (i = 0; (i < iterations) && (result == 0); i++)
+    {
+        if (strtof_s("-42.125", NULL) != -42.125f)
+        {
+            result = 1;
+        }
+    }
+
+    return result;
+}
+
+/* random numbers */
+
+static int run_gb_rand(void* context, size_t parameter, size_t iterations)
+{
+    int value = 0;
+    size_t i;
+    (void)context;
+    (void)parameter;
+
+    for (i = 0; i < iterations; i++)
+    {
+        value ^= gb_rand();
+    }
+    decoded[0] = (unsigned char)value;
+
+    return 0;
+}
+
+static int run_gb_rand_fill(void* context, size_t parameter, size_t iterations)
+{
+    size_t i;
+    (void)context;
+
+    for (i = 0; i < iterations; i++)
+    {
+        gb_rand_fill(decoded, parameter);
+    }
+
+    return 0;
+}
+
+/* hashing */
+
+static int run_strhash_bytes(void* context, size_t parameter, size_t iterations)
+{
+    uint64_t value = 0;
+    size_t i;
+    (void)context;
+
+    for (i = 0; i < iterations; i++)
+    {
+        value ^= strhash_bytes(text, parameter);
+    }
+    decoded[0] = (unsigned char)value;
+
+    return 0;
+}
+
+static int run_strhash_bytes_nocase(void* context, size_t parameter, size_t iterations)
+{
+    uint64_t value = 0;
+    size_t i;
+    (void)context;
+
+    for (i = 0; i < iterations; i++)
+    {
+        value ^= strhash_bytes_nocase(text, parameter);
+    }
+    decoded[0] = (unsigned char)value;
+
+    return 0;
+}
+
+/* the FNV-1a loop of the Map, ConstMap and HTTPHeaders indexes, as a baseline */
+static int run_fnv1a(void* context, size_t parameter, size_t iterations)
+{
+    uint32_t value = 0;
+    size_t i;
+    (void)context;
+
+    for (i = 0; i < iterations; i++)
+    {
+        uint32_t hash = 2166136261u;
+        size_t j;
+        for (j = 0; j < parameter; j++)
+        {
+            hash ^= (unsigned char)text[j];
+            hash *= 16777619u;
+        }
+        value ^= hash;
+    }
+    decoded[0] = (unsigned char)value;
+
+    return 0;
+}
+
+static const BENCHMARK benchmarks[] =
+{
+    { "string_concat", BENCHMARK_PIECE_COUNT, 0, no_setup, run_string_concat, no_teardown },
+    { "string_sprintf", 8, 0, no_setup, run_string_sprintf, no_teardown },
+    { "string_construct_n", 64, 64, no_setup, run_string_construct, no_teardown },
+    { "string_construct_n", 1024, 1024, no_setup, run_string_construct, no_teardown },
+    { "string_new_json", 64, 64, no_setup, run_string_new_json, no_teardown },
+    { "string_new_json", 4096, 4096, no_setup, run_string_new_json, no_teardown },
+    { "buffer_append_build", BENCHMARK_PIECE_COUNT, 0, no_setup, run_buffer_append_build, no_teardown },
+    { "buffer_build", 64, 64, setup_buffer, run_buffer_build, teardown_buffer },
+    { "buffer_build", 4096, 4096, setup_buffer, run_buffer_build, teardown_buffer },
+    { "map_build", 10, 0, no_setup, run_map_build, no_teardown },
+    { "map_build", 100, 0, no_setup, run_map_build, no_teardown },
+    { "map_lookup", 1, 0, setup_map, run_map_lookup, teardown_map },
+    { "map_lookup", 10, 0, setup_map, run_map_lookup, teardown_map },
+    { "map_lookup", 100, 0, setup_map, run_map_lookup, teardown_map },
+    { "map_lookup", 1000, 0, setup_map, run_map_lookup, teardown_map },
+    { "map_lookup_missing", 10, 0, setup_map, run_map_lookup_missing, teardown_map },
+    { "map_lookup_missing", 1000, 0, setup_map, run_map_lookup_missing, teardown_map },
+    { "map_to_json", 10, 0, setup_map, run_map_to_json, teardown_map },
+    { "map_to_json", 100, 0, setup_map, run_map_to_json, teardown_map },
+    { "map_to_json_buffer", 10, 0, setup_map, run_map_to_json_buffer, teardown_map },
+    { "map_to_json_buffer", 100, 0, setup_map, run_map_to_json_buffer, teardown_map },
+    { "map_clone", 10, 0, setup_map, run_map_clone, teardown_map },
+    { "map_clone", 100, 0, setup_map, run_map_clone, teardown_map },
+    { "map_clone_update", 10, 0, setup_map, run_map_clone_update, teardown_map },
+    { "constmap_lookup", 10, 0, setup_constmap, run_constmap_lookup, teardown_constmap },
+    { "constmap_lookup", 1000, 0, setup_constmap, run_constmap_lookup, teardown_constmap },
+    { "constmap_lookup_missing", 1000, 0, setup_constmap, run_constmap_lookup_missing, teardown_constmap },
+    { "base64_encode", 64, 64, no_setup, run_base64_encode, no_teardown },
+    { "base64_encode", 4096, 4096, no_setup, run_base64_encode, no_teardown },
+    { "base64_decode", 64, 64, setup_base64_decode, run_base64_decode, no_teardown },
+    { "base64_decode", 4096, 4096, setup_base64_decode, run_base64_decode, no_teardown },
+    { "base32_encode", 64, 64, no_setup, run_base32_encode, no_teardown },
+    { "base32_encode", 4096, 4096, no_setup, run_base32_encode, no_teardown },
+    { "base32_decode", 64, 64, setup_base32_decode, run_base32_decode, no_teardown },
+    { "base32_decode", 4096, 4096, setup_base32_decode, run_base32_decode, no_teardown },
+    { "url_encode", 64, 64, no_setup, run_url_encode, no_teardown },
+    { "url_encode", 4096, 4096, no_setup, run_url_encode, no_teardown },
+    { "sha1", 60, 60, no_setup, run_sha1, no_teardown },
+    { "sha1", 4096, 4096, no_setup, run_sha1, no_teardown },
+    { "sha1_portable", 4096, 4096, setup_portable_sha, run_sha1, teardown_portable_sha },
+    { "sha256", 64, 64, no_setup, run_sha256, no_teardown },
+    { "sha256", 4096, 4096, no_setup, run_sha256, no_teardown },
+    { "sha256_portable", 4096, 4096, setup_portable_sha, run_sha256, teardown_portable_sha },
+    { "sha512", 4096, 4096, no_setup, run_sha512, no_teardown },
+    { "sha512_portable", 4096, 4096, setup_portable_sha, run_sha512, teardown_portable_sha },
+    { "hmacsha256", 64, 64, no_setup, run_hmacsha256, no_teardown },
+    { "hmacsha256", 4096, 4096, no_setup, run_hmacsha256, no_teardown },
+    { "hmacsha256_batch", 64, 64, setup_hmacsha256_batch, run_hmacsha256_batch, teardown_hmacsha256_batch },
+#ifdef BENCHMARK_WSIO
+    { "uws_frame_encoder_encode", 125, 125, no_setup, run_uws_frame_encoder_encode, no_teardown },
+    { "uws_frame_encoder_encode", 4096, 4096, no_setup, run_uws_frame_encoder_encode, no_teardown },
+    { "uws_frame_encoder_encode_header", 125, 125, setup_uws_frame, run_uws_frame_encoder_encode_header, teardown_uws_frame },
+    { "uws_frame_encoder_encode_header", 4096, 4096, setup_uws_frame, run_uws_frame_encoder_encode_header, teardown_uws_frame },
+    { "uws_frame_decoder_decode", 125, 125, setup_uws_frame_decoder, run_uws_frame_decoder_decode, teardown_uws_frame_decoder },
+    { "uws_frame_decoder_decode", 4096, 4096, setup_uws_frame_decoder, run_uws_frame_decoder_decode, teardown_uws_frame_decoder },
+    { "uws_frame_decoder_decode_masked", 4096, 4096, setup_uws_frame_decoder_masked, run_uws_frame_decoder_decode, teardown_uws_frame_decoder },
+    { "utf8_checker_is_valid_utf8", 4096, 4096, setup_utf8, run_utf8_checker, no_teardown },
+#endif
+    { "constbuffer_refcount", 64, 0, setup_constbuffer, run_constbuffer_refcount, teardown_constbuffer },
+    { "constbuffer_create", 64, 0, no_setup, run_constbuffer_create, no_teardown },
+    { "memio_send", 64, 64, setup_memio, run_memio_send, teardown_memio },
+    { "memio_send", 4096, 4096, setup_memio, run_memio_send, teardown_memio },
+    { "memio_send_chunked", 4096, 4096, setup_memio_chunked, run_memio_send, teardown_memio },
+    { "size_tToString", 0, 0, no_setup, run_size_tToString, no_teardown },
+    { "strtoull_s", 0, 0, no_setup, run_strtoull_s, no_teardown },
+    { "strtof_s", 0, 0, no_setup, run_strtof_s, no_teardown },
+    { "gb_rand", 0, 0, no_setup, run_gb_rand, no_teardown },
+    { "gb_rand_fill", 4096, 4096, no_setup, run_gb_rand_fill, no_teardown },
+    { "strhash_bytes", 8, 8, no_setup, run_strhash_bytes, no_teardown },
+    { "strhash_bytes", 16, 16, no_setup, run_strhash_bytes, no_teardown },
+    { "strhash_bytes", 64, 64, no_setup, run_strhash_bytes, no_teardown },
+    { "strhash_bytes", 4096, 4096, no_setup, run_strhash_bytes, no_teardown },
+    { "strhash_bytes_nocase", 16, 16, no_setup, run_strhash_bytes_nocase, no_teardown },
+    { "strhash_bytes_nocase", 4096, 4096, no_setup, run_strhash_bytes_nocase, no_teardown },
+    { "fnv1a", 16, 16, no_setup, run_fnv1a, no_teardown },
+    { "fnv1a", 4096, 4096, no_setup, run_fnv1a, no_teardown }
+};
+
+static int run_benchmark(const BENCHMARK* benchmark)
+{
+    int result;
+    void* context = benchmark->setup(benchmark->parameter);
+
+    if (context == NULL)
+    {
+        (void)fprintf(stderr, "%s(%lu): setup failed\n", benchmark->name, (unsigned long)benchmark->parameter);
+        result = 1;
+    }
+    else
+    {
+        size_t iterations = 1;
+        tickcounter_us_t elapsed_us = 0;
+
+        result = 0;
+        while (result == 0)
+        {
+            tickcounter_us_t start_us;
+            tickcounter_us_t end_us;
+
+            if ((tickcounter_get_monotonic_us(&start_us) != 0) ||
+                (benchmark->run(context, benchmark->parameter, iterations) != 0) ||
+                (tickcounter_get_monotonic_us(&end_us) != 0))
+            {
+                (void)fprintf(stderr, "%s(%lu): run failed\n", benchmark->name, (unsigned long)benchmark->parameter);
+                result = 1;
+            }
+            else
+            {
+                elapsed_us = end_us - start_us;
+                if ((elapsed_us >= BENCHMARK_MIN_ELAPSED_US) || (iterations >= BENCHMARK_MAX_ITERATIONS))
+                {
+                    break;
+                }
+                iterations *= 2;
+            }
+        }
+
+        if (result == 0)
+        {
+            double ns_per_iteration = ((double)elapsed_us * 1000.0) / (double)iterations;
+
+            (void)printf("%s,%lu,%lu,%llu,%.1f,", benchmark->name, (unsigned long)benchmark->parameter, (unsigned long)iterations,
+                (unsigned long long)elapsed_us, ns_per_iteration);
+            if ((benchmark->bytes_per_iteration != 0) && (elapsed_us != 0))
+            {
+                (void)printf("%.1f", ((double)benchmark->bytes_per_iteration * (double)iterations) / (double)elapsed_us);
+            }
+            (void)printf("\n");
+            (void)fflush(stdout);
+        }
+
+        benchmark->teardown(context);
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result = 0;
+    const char* filter = (argc > 1) ? argv[1] : NULL;
+    size_t i;
+
+    for (i = 0; i < BENCHMARK_DATA_SIZE; i++)
+    {
+        data[i] = (unsigned char)(i * 31);
+        /* mostly unreserved characters, with a character to escape every 8 */
+        text[i] = ((i % 8) == 7) ? ' ' : (char)('a' + (i % 26));
+    }
+    text[BENCHMARK_DATA_SIZE] = '\0';
+    for (i = 0; i < BENCHMARK_MAP_MAX_KEYS; i++)
+    {
+        (void)sprintf(map_keys[i], "key_%lu", (unsigned long)i);
+    }
+
+    (void)printf("benchmark,parameter,iterations,elapsed_us,ns_per_iteration,mb_per_second\n");
+    for (i = 0; i < sizeof(benchmarks) / sizeof(benchmarks[0]); i++)
+    {
+        if ((filter == NULL) || (strstr(benchmarks[i].name, filter) != NULL))
+        {
+            if (run_benchmark(&benchmarks[i]) != 0)
+            {
+                result = 1;
+            }
+        }
+    }
+
+    return result;
+}
@@ -665,6 +665,11 @@ function(set_platform_files c_shared_dir)
         if (${use_socketio})
             set(SOCKETIO_C_FILE ${c_shared_dir}/adapters/socketio_win32.c PARENT_SCOPE)
         endif()
+        set(SOCKET_REACTOR_C_FILE ${c_shared_dir}/adapters/socket_reactor_win32.c PARENT_SCOPE)
+        if (NOT WINCE)
+            set(FILE_MAPPING_C_FILE ${c_shared_dir}/adapters/file_mapping_win32.c PARENT_SCOPE)
+            set(SYNC_WAIT_C_FILE ${c_shared_dir}/adapters/sync_wait_win32.c PARENT_SCOPE)
+        endif()
         set(TICKCOUTER_C_FILE ${c_shared_dir}/adapters/tickcounter_win32.c PARENT_SCOPE)
         if (${use_default_uuid})
             set(UNIQUEID_C_FILE ${c_shared_dir}/adapters/uniqueid_stub.c PARENT_SCOPE)
@@ -685,6 +690,7 @@ function(set_platform_files c_shared_dir)
         else()
             set(HTTP_C_FILE ${c_shared_dir}/adapters/httpapi_curl.c PARENT_SCOPE)
         endif()
+        set(FILE_MAPPING_C_FILE ${c_shared_dir}/adapters/file_mapping_posix.c PARENT_SCOPE)
         set(LOCK_C_FILE ${c_shared_dir}/adapters/lock_pthreads.c PARENT_SCOPE)
         if (use_applessl)
             set(PLATFORM_C_FILE ${c_shared_dir}/pal/ios-osx/platform_appleios.c PARENT_SCOPE)
@@ -693,7 +699,10 @@ function(set_platform_files c_shared_dir)
         endif()
         if (${use_socketio})
             set(SOCKETIO_C_FILE ${c_shared_dir}/adapters/socketio_berkeley.c PARENT_SCOPE)
+            set(DNS_ASYNC_C_FILE ${c_shared_dir}/pal/dns_async.c PARENT_SCOPE)
         endif()
+        set(SOCKET_REACTOR_C_FILE ${c_shared_dir}/adapters/socket_reactor_berkeley.c PARENT_SCOPE)
+        set(SYNC_WAIT_C_FILE ${c_shared_dir}/adapters/sync_wait_pthreads.c PARENT_SCOPE)
         set(THREAD_C_FILE ${c_shared_dir}/adapters/threadapi_pthreads.c PARENT_SCOPE)
         set(TICKCOUTER_C_FILE ${c_shared_dir}/adapters/tickcounter_linux.c PARENT_SCOPE)
         if (${use_default_uuid})
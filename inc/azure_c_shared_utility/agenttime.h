@@ -27,6 +27,16 @@ extern "C"
 */
 MOCKABLE_FUNCTION(, time_t, get_time, time_t*, currentTime);
 
+/** @brief Get current calendar time, as seen at the last clock tick.
+*
+*    @details The value can lag behind ::get_time by a few milliseconds,
+*    in exchange it is read without a system call where the platform
+*    keeps such a clock (@c CLOCK_REALTIME_COARSE on Linux). Meant for
+*    second resolution checks done on every request, such as the expiry
+*    of SAS tokens. Returns (time_t)-1 when the time is not available.
+*/
+MOCKABLE_FUNCTION(, time_t, get_time_coarse);
+
 /** @brief Get UTC in @c tm struct.
 *
 *    @details This function provides the same functionality as the
@@ -0,0 +1,72 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file asynclogger.h
+ *    @brief     A logger for xlogging_set_log_function that writes lines on a background thread.
+ *
+ *    @details ::asynclogger_log formats the line into a slot of a ring allocated by
+ *             ::asynclogger_init and returns; it never allocates, never takes a lock while the
+ *             writer thread is busy and never waits for the output. The writer thread hands
+ *             the lines, in order, to the output logger (::consolelogger_log by default).
+ *
+ *             When the ring is full the line is dropped and counted, see
+ *             ::asynclogger_get_dropped_count. Lines longer than the slot are truncated.
+ *
+ *             Typical use:
+ *             @code
+ *             asynclogger_init(0, NULL);
+ *             xlogging_set_log_function(asynclogger_log);
+ *             ...
+ *             xlogging_set_log_function(consolelogger_log);
+ *             asynclogger_deinit();
+ *             @endcode
+ */
+
+#ifndef ASYNCLOGGER_H
+#define ASYNCLOGGER_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif
+
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief    Allocates the ring and starts the writer thread.
+ *
+ * @param    entry_count    The number of lines the ring holds, rounded up to a power of 2, 0 for 1024.
+ * @param    output         The logger the writer thread calls for each line, @c NULL for ::consolelogger_log.
+ *
+ * @return    0 on success, a non-zero value otherwise (including when already initialized).
+ */
+MOCKABLE_FUNCTION(, int, asynclogger_init, size_t, entry_count, LOGGER_LOG, output);
+
+/**
+ * @brief    Writes the lines still in the ring, stops the writer thread and frees the ring.
+ *             Must only be called once no thread uses ::asynclogger_log anymore.
+ */
+MOCKABLE_FUNCTION(, void, asynclogger_deinit);
+
+/**
+ * @brief    Returns the number of lines dropped because the ring was full or the logger not
+ *             initialized.
+ */
+MOCKABLE_FUNCTION(, size_t, asynclogger_get_dropped_count);
+
+/**
+ * @brief    The ::LOGGER_LOG to pass to xlogging_set_log_function. May be called from any thread.
+ */
+extern void asynclogger_log(LOG_CATEGORY log_category, const char* file, const char* func, int line, unsigned int options, const char* format, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ASYNCLOGGER_H */
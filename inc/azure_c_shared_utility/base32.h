@@ -53,6 +53,50 @@ MOCKABLE_FUNCTION(, BUFFER_HANDLE, Base32_Decode, STRING_HANDLE, handle);
 */
 MOCKABLE_FUNCTION(, BUFFER_HANDLE, Base32_Decode_String, const char*, source);
 
+/**
+* @brief    Computes the length of the base32 encoding of size bytes
+*
+* @param    size     The number of bytes to be encoded
+*
+* @return   The number of characters of the encoding, not counting the terminating '\0',
+*           or 0 if it cannot be represented in a size_t
+*/
+MOCKABLE_FUNCTION(, size_t, Base32_Encoded_Length, size_t, size);
+
+/**
+* @brief    Encodes source to base 32 into a caller supplied buffer
+*
+* @param    source              An unsigned char* to be encoded
+* @param    size                The length in bytes of the source variable
+* @param    destination         The buffer receiving the encoding, followed by a '\0'
+* @param    destination_size    The size of destination, at least Base32_Encoded_Length(size) + 1
+*
+* @return   0 on success, a non-zero value if an argument is invalid or destination is too small
+*/
+MOCKABLE_FUNCTION(, int, Base32_Encode_To, const unsigned char*, source, size_t, size, char*, destination, size_t, destination_size);
+
+/**
+* @brief    Computes the number of bytes the base32 encoded source decodes to
+*
+* @param    source   char* of a base32 encode string
+*
+* @return   The number of decoded bytes, or 0 if source is NULL or its length is not a multiple of 8
+*/
+MOCKABLE_FUNCTION(, size_t, Base32_Decoded_Length, const char*, source);
+
+/**
+* @brief    Decodes a base32 encoded char* into a caller supplied buffer
+*
+* @param    source              char* of a base32 encode string
+* @param    destination         The buffer receiving the decoded bytes
+* @param    destination_size    The size of destination, at least Base32_Decoded_Length(source)
+* @param    decoded_size        Receives the number of decoded bytes
+*
+* @return   0 on success, a non-zero value if an argument is invalid, source is not a valid
+*           base32 encoding or destination is too small
+*/
+MOCKABLE_FUNCTION(, int, Base32_Decode_To, const char*, source, unsigned char*, destination, size_t, destination_size, size_t*, decoded_size);
+
 #ifdef __cplusplus
 }
 #endif
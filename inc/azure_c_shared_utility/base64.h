@@ -11,16 +11,36 @@
 
 #include "azure_c_shared_utility/strings.h"
 #include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/constbuffer_array.h"
 
 #ifdef __cplusplus
 #include <cstddef>
+#include <cstdint>
 extern "C" {
 #else
 #include <stddef.h>
+#include <stdint.h>
 #endif
 
 #include "azure_c_shared_utility/umock_c_prod.h"
 
+/*the state carried by the incremental encoder between chunks, to be initialized by Base64_Encoder_Init*/
+typedef struct BASE64_ENCODER_CONTEXT_TAG
+{
+    /*the bytes of the group of 3 started by the previous chunks*/
+    unsigned char leftover[2];
+    size_t leftover_count;
+} BASE64_ENCODER_CONTEXT;
+
+/*the state carried by the incremental decoder between chunks, to be initialized by Base64_Decoder_Init*/
+typedef struct BASE64_DECODER_CONTEXT_TAG
+{
+    /*the 6 bit values of the group of 4 characters started by the previous chunks*/
+    unsigned char values[3];
+    size_t value_count;
+    size_t padding_count;
+    int is_complete;
+} BASE64_DECODER_CONTEXT;
 
 /**
  * @brief    Base64 encodes a buffer and returns the resulting string.
@@ -76,6 +96,156 @@ MOCKABLE_FUNCTION(, STRING_HANDLE, Base64_Encode_Bytes, const unsigned char*, so
  */
 MOCKABLE_FUNCTION(, BUFFER_HANDLE, Base64_Decoder, const char*, source);
 
+/**
+ * @brief    Computes the length of the base64 encoding of @p size bytes.
+ *
+ * @param    size    The number of bytes to be encoded.
+ *
+ * @return    The number of characters of the encoding, not counting the terminating '\0',
+ *             or 0 if it cannot be represented in a @c size_t.
+ */
+MOCKABLE_FUNCTION(, size_t, Base64_Encoded_Length, size_t, size);
+
+/**
+ * @brief    Base64 encodes the buffer pointed to by @p source into a caller supplied buffer.
+ *
+ * @param    source              The buffer that needs to be base64 encoded.
+ * @param    size                The size of @p source.
+ * @param    destination         The buffer receiving the encoding, followed by a '\0'.
+ * @param    destination_size    The size of @p destination, at least
+ *                               @c Base64_Encoded_Length(size) + 1.
+ *
+ * @return    0 on success, a non-zero value if an argument is invalid or @p destination is
+ *             too small.
+ */
+MOCKABLE_FUNCTION(, int, Base64_Encode_To, const unsigned char*, source, size_t, size, char*, destination, size_t, destination_size);
+
+/**
+ * @brief    Computes the number of bytes the base64 string @p source decodes to.
+ *
+ * @param    source    A base64 encoded string.
+ *
+ * @return    The number of decoded bytes, or 0 if @p source is @c NULL or its length is
+ *             not a multiple of 4.
+ */
+MOCKABLE_FUNCTION(, size_t, Base64_Decoded_Length, const char*, source);
+
+/**
+ * @brief    Base64 decodes the string pointed to by @p source into a caller supplied buffer.
+ *
+ * @param    source              A base64 encoded string.
+ * @param    destination         The buffer receiving the decoded bytes.
+ * @param    destination_size    The size of @p destination, at least
+ *                               @c Base64_Decoded_Length(source).
+ * @param    decoded_size        Receives the number of decoded bytes.
+ *
+ * @return    0 on success, a non-zero value if an argument is invalid, @p source is not a
+ *             valid base64 encoding or @p destination is too small.
+ */
+MOCKABLE_FUNCTION(, int, Base64_Decode_To, const char*, source, unsigned char*, destination, size_t, destination_size, size_t*, decoded_size);
+
+/**
+ * @brief    Prepares @p context for encoding a new input with ::Base64_Encoder_Update.
+ *
+ *             The incremental encoder produces the same characters as ::Base64_Encode_To for the
+ *             concatenation of the chunks it is given, without the terminating '\0', and keeps
+ *             at most 2 bytes of the input between the calls, so that an input of any size is
+ *             encoded in constant memory.
+ *
+ * @return    0 on success, a non-zero value if @p context is @c NULL.
+ */
+MOCKABLE_FUNCTION(, int, Base64_Encoder_Init, BASE64_ENCODER_CONTEXT*, context);
+
+/**
+ * @brief    Encodes the next chunk of the input.
+ *
+ * @param    context             The context given to ::Base64_Encoder_Init.
+ * @param    source              The next @p size bytes of the input.
+ * @param    size                The size of @p source.
+ * @param    destination         The buffer receiving the characters of the groups of 3 bytes
+ *                               completed by @p source.
+ * @param    destination_size    The size of @p destination, @c Base64_Encoded_Length(size) is
+ *                               always enough.
+ * @param    written             Receives the number of characters written to @p destination.
+ *
+ * @return    0 on success, a non-zero value if an argument is invalid or @p destination is
+ *             too small, after which @p context has to be initialized again.
+ */
+MOCKABLE_FUNCTION(, int, Base64_Encoder_Update, BASE64_ENCODER_CONTEXT*, context, const unsigned char*, source, size_t, size, char*, destination, size_t, destination_size, size_t*, written);
+
+/**
+ * @brief    Encodes the bytes of @p source starting at @p offset, as many as fit in
+ *             @p destination.
+ *
+ * @param    context             The context given to ::Base64_Encoder_Init.
+ * @param    source              The buffers holding the input.
+ * @param    offset              The offset in @p source of the first byte to encode, advanced
+ *                               past the bytes consumed.
+ * @param    destination         The buffer receiving the characters.
+ * @param    destination_size    The size of @p destination, the call consumes nothing if it
+ *                               is less than 4.
+ * @param    written             Receives the number of characters written to @p destination.
+ *
+ *             The call is meant to be repeated, for instance from an @c HTTPAPI_READ_CONTENT
+ *             callback of a streaming upload, until @p offset reaches the size of @p source,
+ *             before ending the encoding with ::Base64_Encoder_Finish.
+ *
+ * @return    0 on success, a non-zero value if an argument is invalid or @p offset is past the
+ *             end of @p source.
+ */
+MOCKABLE_FUNCTION(, int, Base64_Encoder_Update_From_Array, BASE64_ENCODER_CONTEXT*, context, CONSTBUFFER_ARRAY_HANDLE, source, uint32_t*, offset, char*, destination, size_t, destination_size, size_t*, written);
+
+/**
+ * @brief    Writes the characters, padding included, of the last 1 or 2 bytes of the input and
+ *             prepares @p context for a new input.
+ *
+ * @param    destination_size    The size of @p destination, 4 is always enough.
+ * @param    written             Receives the number of characters written to @p destination,
+ *                               0 or 4.
+ *
+ * @return    0 on success, a non-zero value if an argument is invalid or @p destination is
+ *             too small.
+ */
+MOCKABLE_FUNCTION(, int, Base64_Encoder_Finish, BASE64_ENCODER_CONTEXT*, context, char*, destination, size_t, destination_size, size_t*, written);
+
+/**
+ * @brief    Prepares @p context for decoding a new input with ::Base64_Decoder_Update.
+ *
+ *             The incremental decoder accepts the same inputs as ::Base64_Decode_To, split in
+ *             chunks of any length, and keeps at most 3 characters between the calls.
+ *
+ * @return    0 on success, a non-zero value if @p context is @c NULL.
+ */
+MOCKABLE_FUNCTION(, int, Base64_Decoder_Init, BASE64_DECODER_CONTEXT*, context);
+
+/**
+ * @brief    Decodes the next chunk of the input.
+ *
+ * @param    context             The context given to ::Base64_Decoder_Init.
+ * @param    source              The next @p length characters of the input, not necessarily
+ *                               terminated by a '\0'.
+ * @param    length              The number of characters in @p source.
+ * @param    destination         The buffer receiving the bytes of the groups of 4 characters
+ *                               completed by @p source.
+ * @param    destination_size    The size of @p destination, @c (length + 3) / 4 * 3 is always
+ *                               enough.
+ * @param    written             Receives the number of bytes written to @p destination.
+ *
+ * @return    0 on success, a non-zero value if an argument is invalid, @p source makes the
+ *             input an invalid base64 encoding or @p destination is too small, after which
+ *             @p context has to be initialized again.
+ */
+MOCKABLE_FUNCTION(, int, Base64_Decoder_Update, BASE64_DECODER_CONTEXT*, context, const char*, source, size_t, length, unsigned char*, destination, size_t, destination_size, size_t*, written);
+
+/**
+ * @brief    Checks that the input ended on a complete group of 4 characters and prepares
+ *             @p context for a new input.
+ *
+ * @return    0 on success, a non-zero value if @p context is @c NULL or the length of the input
+ *             is not a multiple of 4.
+ */
+MOCKABLE_FUNCTION(, int, Base64_Decoder_Finish, BASE64_DECODER_CONTEXT*, context);
+
 #ifdef __cplusplus
 }
 #endif
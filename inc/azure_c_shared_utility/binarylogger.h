@@ -0,0 +1,91 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file binarylogger.h
+ *    @brief     A logger for xlogging_set_log_function that records lines in a compact binary form
+ *             and formats them later.
+ *
+ *    @details ::binarylogger_log does not format: it records the category, line, options, the file,
+ *             function and format strings and the raw arguments that the format string describes.
+ *             The file, function and format strings are recorded once per stream and referred to
+ *             by id afterwards; @c %s arguments are copied.
+ *
+ *             The records go to a buffer allocated by ::binarylogger_init. When a file is given
+ *             the buffer is appended to it each time it is full, otherwise the records that do not
+ *             fit anymore are dropped and counted.
+ *
+ *             ::binarylogger_decode turns a stream (the buffer or the file) back into lines; the
+ *             binarylogger_decode sample is a command line decoder for the files.
+ */
+
+#ifndef BINARYLOGGER_H
+#define BINARYLOGGER_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif
+
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** @brief    Called by ::binarylogger_decode for each line, @p message is the formatted line. */
+typedef void(*ON_BINARYLOGGER_LINE)(void* context, LOG_CATEGORY log_category, const char* file, const char* func, int line, unsigned int options, const char* message);
+
+/**
+ * @brief    Allocates the buffer and opens the file the records go to.
+ *
+ * @param    buffer_size    The size of the buffer in bytes, 0 for 64 KB.
+ * @param    file_path      The file the buffer is appended to each time it is full, @c NULL to keep
+ *                          the records in memory only.
+ *
+ * @return    0 on success, a non-zero value otherwise (including when already initialized).
+ */
+MOCKABLE_FUNCTION(, int, binarylogger_init, size_t, buffer_size, const char*, file_path);
+
+/**
+ * @brief    Appends the buffer to the file if there is one, closes it and frees the buffer.
+ *             Must only be called once no thread uses ::binarylogger_log anymore.
+ */
+MOCKABLE_FUNCTION(, void, binarylogger_deinit);
+
+/**
+ * @brief    Appends the buffer to the file. Does nothing when the records are kept in memory only.
+ *
+ * @return    0 on success, a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, binarylogger_flush);
+
+/**
+ * @brief    Returns the records not yet appended to the file, which are all of them when there is
+ *             no file. The content is only stable while no thread logs.
+ *
+ * @param    size    Receives the number of bytes.
+ */
+MOCKABLE_FUNCTION(, const unsigned char*, binarylogger_get_buffer, size_t*, size);
+
+/** @brief    Returns the number of lines dropped because they did not fit or the logger was not initialized. */
+MOCKABLE_FUNCTION(, size_t, binarylogger_get_dropped_count);
+
+/**
+ * @brief    Formats the lines of a stream written by ::binarylogger_log, from its start.
+ *
+ * @return    0 if the whole stream was decoded, a non-zero value if it is not a stream or is corrupt.
+ */
+MOCKABLE_FUNCTION(, int, binarylogger_decode, const unsigned char*, data, size_t, size, ON_BINARYLOGGER_LINE, on_line, void*, context);
+
+/**
+ * @brief    The ::LOGGER_LOG to pass to xlogging_set_log_function. May be called from any thread.
+ */
+extern void binarylogger_log(LOG_CATEGORY log_category, const char* file, const char* func, int line, unsigned int options, const char* format, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* BINARYLOGGER_H */
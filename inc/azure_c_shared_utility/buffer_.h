@@ -35,6 +35,12 @@ MOCKABLE_FUNCTION(, int, BUFFER_fill, BUFFER_HANDLE, handle, unsigned char, fill
 MOCKABLE_FUNCTION(, unsigned char*, BUFFER_u_char, BUFFER_HANDLE, handle);
 MOCKABLE_FUNCTION(, size_t, BUFFER_length, BUFFER_HANDLE, handle);
 MOCKABLE_FUNCTION(, BUFFER_HANDLE, BUFFER_clone, BUFFER_HANDLE, handle);
+MOCKABLE_FUNCTION(, int, BUFFER_reserve, BUFFER_HANDLE, handle, size_t, capacity);
+MOCKABLE_FUNCTION(, size_t, BUFFER_capacity, BUFFER_HANDLE, handle);
+MOCKABLE_FUNCTION(, int, BUFFER_detach, BUFFER_HANDLE, handle, unsigned char**, memory, size_t*, size);
+MOCKABLE_FUNCTION(, BUFFER_HANDLE, BUFFER_create_with_headroom, const unsigned char*, source, size_t, size, size_t, headroom);
+MOCKABLE_FUNCTION(, int, BUFFER_push_front, BUFFER_HANDLE, handle, const unsigned char*, source, size_t, size);
+MOCKABLE_FUNCTION(, size_t, BUFFER_headroom, BUFFER_HANDLE, handle);
 
 #ifdef __cplusplus
 }
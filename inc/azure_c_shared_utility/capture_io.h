@@ -0,0 +1,79 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file capture_io.h
+ *    @brief     An IO that records the traffic going through it into a ring, to be written out as a
+ *               pcapng file when a stall is to be looked at.
+ *
+ *    @details A capture IO is placed anywhere in an IO stack: it passes everything to the layer
+ *             below and, for each send and each indication of received bytes, records into its
+ *             ring the time, the direction, the size and the first @c snap_length bytes. Recording
+ *             is one atomic add, a copy of at most @c snap_length bytes and no lock, so that turning
+ *             the capture on does not change the timing the way logging the bytes does.
+ *
+ *             The ring keeps the last @c record_count records, the older ones being overwritten,
+ *             and may be shared by several capture IOs. ::capture_io_ring_dump writes the records
+ *             to a pcapng file with one interface per capture IO name, of link type
+ *             @c LINKTYPE_USER0 since the bytes are those of the layer below (TLS records for a
+ *             capture IO placed above a socket IO), and the direction in the flags of each packet.
+ *             A record being overwritten while the ring is dumped is left out.
+ */
+
+#ifndef CAPTURE_IO_H
+#define CAPTURE_IO_H
+
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C" {
+#else
+#include <stddef.h>
+#endif /* __cplusplus */
+
+#define CAPTURE_IO_RING_DEFAULT_RECORD_COUNT 4096
+
+typedef struct CAPTURE_IO_RING_TAG* CAPTURE_IO_RING_HANDLE;
+
+typedef struct CAPTURE_IO_CONFIG_TAG
+{
+    const IO_INTERFACE_DESCRIPTION* underlying_io_interface;
+    void* underlying_io_parameters;
+    CAPTURE_IO_RING_HANDLE ring;
+    /* the name of the interface of the records in the pcapng file, capture IOs with the same name share it */
+    const char* name;
+} CAPTURE_IO_CONFIG;
+
+/**
+ * @brief    Creates a ring for the records of capture IOs.
+ *
+ * @param    record_count    The number of records kept, rounded up to a power of 2, 0 for
+ *                           CAPTURE_IO_RING_DEFAULT_RECORD_COUNT.
+ * @param    snap_length     The number of bytes kept from the start of each send or indication,
+ *                           0 to keep only the sizes.
+ *
+ * @return    The ring, or @c NULL on failure.
+ */
+MOCKABLE_FUNCTION(, CAPTURE_IO_RING_HANDLE, capture_io_ring_create, size_t, record_count, size_t, snap_length);
+
+/**
+ * @brief    Frees the ring, once the capture IOs using it are destroyed.
+ */
+MOCKABLE_FUNCTION(, void, capture_io_ring_destroy, CAPTURE_IO_RING_HANDLE, ring);
+
+/**
+ * @brief    Writes the records of the ring, oldest first, to the pcapng file @p file_path. It may
+ *             be called from any thread while the capture IOs record.
+ *
+ * @return    0 on success, a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, capture_io_ring_dump, CAPTURE_IO_RING_HANDLE, ring, const char*, file_path);
+
+MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, capture_io_get_interface_description);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* CAPTURE_IO_H */
@@ -13,11 +13,32 @@ extern "C"
 {
 #endif
 
+    /* The well-known fields of a connection string, NULL when the connection string does not have the key.
+       Returned by connectionstringparser_acquire, they stay valid until connectionstringparser_release is called. */
+    typedef struct CONNECTION_STRING_TAG
+    {
+        const char* host_name;
+        const char* device_id;
+        const char* module_id;
+        const char* shared_access_key_name;
+        const char* shared_access_key;
+        const char* shared_access_signature;
+        const char* gateway_host_name;
+    } CONNECTION_STRING;
+
     MOCKABLE_FUNCTION(, MAP_HANDLE, connectionstringparser_parse_from_char, const char*, connection_string);
     MOCKABLE_FUNCTION(, MAP_HANDLE, connectionstringparser_parse, STRING_HANDLE, connection_string);
     MOCKABLE_FUNCTION(, int, connectionstringparser_splitHostName_from_char, const char*, hostName, STRING_HANDLE, nameString, STRING_HANDLE, suffixString);
     MOCKABLE_FUNCTION(, int, connectionstringparser_splitHostName, STRING_HANDLE, hostNameString, STRING_HANDLE, nameString, STRING_HANDLE, suffixString);
 
+    /* While the process wide cache is initialized, connectionstringparser_acquire returns the same reference counted result
+       to every caller acquiring the same connection string, so it is only parsed once. */
+    MOCKABLE_FUNCTION(, int, connectionstringparser_cache_init);
+    MOCKABLE_FUNCTION(, void, connectionstringparser_cache_deinit);
+    MOCKABLE_FUNCTION(, const CONNECTION_STRING*, connectionstringparser_acquire, const char*, connection_string);
+    MOCKABLE_FUNCTION(, void, connectionstringparser_release, const CONNECTION_STRING*, parsed);
+    MOCKABLE_FUNCTION(, const char*, connectionstringparser_get_value, const CONNECTION_STRING*, parsed, const char*, key);
+
 #ifdef __cplusplus
 }
 #endif
@@ -4,6 +4,10 @@
 #ifndef CONSOLELOGGER_H
 #define CONSOLELOGGER_H
 
+#ifndef __cplusplus
+#include <stdbool.h>
+#endif
+
 #include "azure_c_shared_utility/xlogging.h"
 
 #ifdef __cplusplus
@@ -12,6 +16,10 @@ extern "C" {
 
     extern void consolelogger_log(LOG_CATEGORY log_category, const char* file, const char* func, int line, unsigned int options, const char* format, ...);
 
+    /* Starts every line with the seconds and microseconds of the monotonic clock (off by default),
+       to order and time lines closer than the second of the wall clock time of errors. */
+    extern void consolelogger_set_monotonic_timestamp(bool enabled);
+
 #if (defined(_MSC_VER)) && (!(defined WINCE))
     extern void consolelogger_log_with_GetLastError(const char* file, const char* func, int line, const char* format, ...);
 #endif
@@ -0,0 +1,221 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef CPP_HANDLES_H
+#define CPP_HANDLES_H
+
+/* Move-only C++ owners of STRING_HANDLE, BUFFER_HANDLE and CONSTBUFFER_HANDLE, header only.
+
+   A wrapper constructed from a handle adopts it: nothing is allocated or copied, and the handle is deleted (or its
+   reference released, for a CONSTBUFFER_HANDLE) when the wrapper goes away, unless release hands it back. view
+   returns a std::string_view or a std::span over the content of the handle, without copying; it stays valid until
+   the content is changed or the handle is deleted. The create functions return an empty wrapper when the C function
+   fails, they do not throw.
+
+   string_view needs C++17, the span views need C++20. */
+
+#ifndef __cplusplus
+#error "cpp_handles.h is a C++ header"
+#endif
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#if (__cplusplus >= 202002L) && defined(__has_include)
+#if __has_include(<span>)
+#include <span>
+#define CPP_HANDLES_HAS_SPAN
+#endif
+#endif
+
+#include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/constbuffer.h"
+
+/* owns a HANDLE released with DESTROY */
+template <typename HANDLE, void (*DESTROY)(HANDLE)>
+class cpp_unique_handle
+{
+public:
+    cpp_unique_handle() noexcept
+        : handle(NULL)
+    {
+    }
+
+    /* adopts handle, which may be NULL */
+    explicit cpp_unique_handle(HANDLE handle) noexcept
+        : handle(handle)
+    {
+    }
+
+    cpp_unique_handle(cpp_unique_handle&& other) noexcept
+        : handle(other.handle)
+    {
+        other.handle = NULL;
+    }
+
+    cpp_unique_handle& operator=(cpp_unique_handle&& other) noexcept
+    {
+        if (this != &other)
+        {
+            reset(other.handle);
+            other.handle = NULL;
+        }
+        return *this;
+    }
+
+    cpp_unique_handle(const cpp_unique_handle&) = delete;
+    cpp_unique_handle& operator=(const cpp_unique_handle&) = delete;
+
+    ~cpp_unique_handle()
+    {
+        reset(NULL);
+    }
+
+    HANDLE get() const noexcept
+    {
+        return handle;
+    }
+
+    /* hands the handle over to the caller, who then releases it */
+    HANDLE release() noexcept
+    {
+        HANDLE result = handle;
+        handle = NULL;
+        return result;
+    }
+
+    /* releases the handle owned so far and adopts new_handle */
+    void reset(HANDLE new_handle = NULL) noexcept
+    {
+        HANDLE old_handle = handle;
+        handle = new_handle;
+        if (old_handle != NULL)
+        {
+            DESTROY(old_handle);
+        }
+    }
+
+    explicit operator bool() const noexcept
+    {
+        return handle != NULL;
+    }
+
+private:
+    HANDLE handle;
+};
+
+class string_handle : public cpp_unique_handle<STRING_HANDLE, STRING_delete>
+{
+public:
+    using cpp_unique_handle<STRING_HANDLE, STRING_delete>::cpp_unique_handle;
+
+    /* copies value, which may contain no '\0' */
+    static string_handle create(std::string_view value) noexcept
+    {
+        return string_handle(STRING_from_byte_array(reinterpret_cast<const unsigned char*>(value.data()), value.size()));
+    }
+
+    /* adopts memory, a '\0' terminated string allocated with malloc, without copying it */
+    static string_handle adopt_memory(char* memory) noexcept
+    {
+        return string_handle(STRING_new_with_memory(memory));
+    }
+
+    std::string_view view() const noexcept
+    {
+        return (get() == NULL) ? std::string_view() : std::string_view(STRING_c_str(get()), STRING_length(get()));
+    }
+
+    const char* c_str() const noexcept
+    {
+        return (get() == NULL) ? NULL : STRING_c_str(get());
+    }
+};
+
+class buffer_handle : public cpp_unique_handle<BUFFER_HANDLE, BUFFER_delete>
+{
+public:
+    using cpp_unique_handle<BUFFER_HANDLE, BUFFER_delete>::cpp_unique_handle;
+
+    static buffer_handle create(const void* source, size_t size) noexcept
+    {
+        /* BUFFER_create wants a source even for no bytes */
+        return buffer_handle((size == 0) ? BUFFER_new() : BUFFER_create(static_cast<const unsigned char*>(source), size));
+    }
+
+    size_t size() const noexcept
+    {
+        return (get() == NULL) ? 0 : BUFFER_length(get());
+    }
+
+#if defined(CPP_HANDLES_HAS_SPAN)
+    static buffer_handle create(std::span<const uint8_t> source) noexcept
+    {
+        return create(source.data(), source.size());
+    }
+
+    std::span<const uint8_t> view() const noexcept
+    {
+        return (get() == NULL) ? std::span<const uint8_t>() : std::span<const uint8_t>(BUFFER_u_char(get()), BUFFER_length(get()));
+    }
+
+    std::span<uint8_t> mutable_view() noexcept
+    {
+        return (get() == NULL) ? std::span<uint8_t>() : std::span<uint8_t>(BUFFER_u_char(get()), BUFFER_length(get()));
+    }
+#endif
+};
+
+class constbuffer_handle : public cpp_unique_handle<CONSTBUFFER_HANDLE, CONSTBUFFER_DecRef>
+{
+public:
+    using cpp_unique_handle<CONSTBUFFER_HANDLE, CONSTBUFFER_DecRef>::cpp_unique_handle;
+
+    static constbuffer_handle create(const void* source, size_t size) noexcept
+    {
+        return constbuffer_handle(CONSTBUFFER_Create(static_cast<const unsigned char*>(source), size));
+    }
+
+    /* takes over the memory of buffer, which is left empty, instead of copying it */
+    static constbuffer_handle create_from_buffer_move(buffer_handle& buffer) noexcept
+    {
+        return constbuffer_handle(CONSTBUFFER_CreateFromBufferMove(buffer.get()));
+    }
+
+    /* another reference to the same content */
+    constbuffer_handle share() const noexcept
+    {
+        if (get() != NULL)
+        {
+            CONSTBUFFER_IncRef(get());
+        }
+        return constbuffer_handle(get());
+    }
+
+    /* size bytes from offset of the same content, without copying them */
+    constbuffer_handle slice(size_t offset, size_t size) const noexcept
+    {
+        return constbuffer_handle((get() == NULL) ? NULL : CONSTBUFFER_CreateFromOffsetAndSize(get(), offset, size));
+    }
+
+    size_t size() const noexcept
+    {
+        return (get() == NULL) ? 0 : CONSTBUFFER_GetContent(get())->size;
+    }
+
+#if defined(CPP_HANDLES_HAS_SPAN)
+    static constbuffer_handle create(std::span<const uint8_t> source) noexcept
+    {
+        return create(source.data(), source.size());
+    }
+
+    std::span<const uint8_t> view() const noexcept
+    {
+        const CONSTBUFFER* content = (get() == NULL) ? NULL : CONSTBUFFER_GetContent(get());
+        return (content == NULL) ? std::span<const uint8_t>() : std::span<const uint8_t>(content->buffer, content->size);
+    }
+#endif
+};
+
+#endif /* CPP_HANDLES_H */
@@ -110,6 +110,9 @@ extern long double strtold_s(const char* nptr, char** endPtr);
 MOCKABLE_FUNCTION(, int, mallocAndStrcpy_s, char**, destination, const char*, source);
 MOCKABLE_FUNCTION(, int, unsignedIntToString, char*, destination, size_t, destinationSize, unsigned int, value);
 MOCKABLE_FUNCTION(, int, size_tToString, char*, destination, size_t, destinationSize, size_t, value);
+/*as unsignedIntToString and size_tToString, length receives the number of characters written without the terminating null character*/
+MOCKABLE_FUNCTION(, int, unsignedIntToStringWithLength, char*, destination, size_t, destinationSize, unsigned int, value, size_t*, length);
+MOCKABLE_FUNCTION(, int, size_tToStringWithLength, char*, destination, size_t, destinationSize, size_t, value, size_t*, length);
 
 /*following logic shall define the TOUPPER and ISDIGIT, we do that because the SDK is not happy with some Arduino implementation of it.*/
 #define TOUPPER(c)      ((((c)>='a') && ((c)<='z'))?(c)-'a'+'A':c)
@@ -0,0 +1,118 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file dns_cache.h
+ *    @brief     A process wide cache of host name lookups shared by socketio_berkeley and dns_async.
+ *
+ *    @details getaddrinfo does not report the TTL of the records it resolved, so entries live for
+ *             the TTL configured with ::dns_cache_set_ttl. Failed lookups are cached too, for the
+ *             (shorter) negative TTL, so that a host that cannot be resolved is not looked up once
+ *             per connection attempt.
+ *
+ *             The cache is created by ::dns_cache_init (platform_init on Linux does it). Until then,
+ *             and while it is disabled, every lookup misses and nothing is added.
+ */
+
+#ifndef DNS_CACHE_H
+#define DNS_CACHE_H
+
+#ifdef __cplusplus
+#include <cstdint>
+#include <cstddef>
+#else
+#include <stdint.h>
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+#include "azure_c_shared_utility/macro_utils.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define DNS_CACHE_DEFAULT_TTL_MS            60000
+#define DNS_CACHE_DEFAULT_NEGATIVE_TTL_MS   5000
+#define DNS_CACHE_MAX_ENTRIES               64
+
+#define DNS_CACHE_IPV6_ADDRESS_SIZE         16
+
+#define DNS_CACHE_RESULT_VALUES \
+    DNS_CACHE_MISS, \
+    DNS_CACHE_HIT, \
+    DNS_CACHE_NEGATIVE_HIT
+
+DEFINE_ENUM(DNS_CACHE_RESULT, DNS_CACHE_RESULT_VALUES);
+
+/** @brief    The addresses of a host. @c ip_v4 is in network byte order, 0 when the host has none. */
+typedef struct DNS_CACHE_ADDRESSES_TAG
+{
+    uint32_t ip_v4;
+    unsigned char ip_v6[DNS_CACHE_IPV6_ADDRESS_SIZE];
+    bool has_ip_v6;
+} DNS_CACHE_ADDRESSES;
+
+/**
+ * @brief    Creates the cache, enabled and with the default TTLs.
+ *
+ * @return    0 on success, a non-zero value otherwise (including when already initialized).
+ */
+MOCKABLE_FUNCTION(, int, dns_cache_init);
+
+/**
+ * @brief    Frees the cache and its entries. Must only be called once no thread uses the cache anymore.
+ */
+MOCKABLE_FUNCTION(, void, dns_cache_deinit);
+
+/**
+ * @brief    Sets how long entries are kept. Applies to the entries added afterwards.
+ *
+ * @param    ttl_ms             How long a successful lookup is kept, 0 not to cache them.
+ * @param    negative_ttl_ms    How long a failed lookup is kept, 0 not to cache them.
+ *
+ * @return    0 on success, a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, dns_cache_set_ttl, uint32_t, ttl_ms, uint32_t, negative_ttl_ms);
+
+/**
+ * @brief    Enables or disables the cache. Disabling it also removes all entries.
+ */
+MOCKABLE_FUNCTION(, void, dns_cache_set_enabled, bool, enabled);
+
+/**
+ * @brief    Looks up @p hostname.
+ *
+ * @param    hostname     The host name.
+ * @param    addresses    Receives the addresses on ::DNS_CACHE_HIT.
+ *
+ * @return    ::DNS_CACHE_HIT, ::DNS_CACHE_NEGATIVE_HIT when the last lookup of the host failed, or
+ *             ::DNS_CACHE_MISS when the host has no entry that has not expired.
+ */
+MOCKABLE_FUNCTION(, DNS_CACHE_RESULT, dns_cache_lookup, const char*, hostname, DNS_CACHE_ADDRESSES*, addresses);
+
+/**
+ * @brief    Records the result of a lookup of @p hostname, replacing its entry.
+ *
+ * @param    hostname     The host name.
+ * @param    addresses    The addresses found, @c NULL if the lookup failed.
+ *
+ * @return    0 on success, a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, dns_cache_add, const char*, hostname, const DNS_CACHE_ADDRESSES*, addresses);
+
+/**
+ * @brief    Removes the entry of @p hostname, for instance when connecting to its address failed.
+ */
+MOCKABLE_FUNCTION(, void, dns_cache_remove, const char*, hostname);
+
+/**
+ * @brief    Removes all entries.
+ */
+MOCKABLE_FUNCTION(, void, dns_cache_clear);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* DNS_CACHE_H */
@@ -0,0 +1,64 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file file_mapping.h
+ *    @brief     Maps a file of a fixed size in memory, read/write and shared with the file.
+ *
+ *    @details The stores written through the mapping belong to the page cache of the OS, so they
+ *             reach the file even if the process is killed; ::file_mapping_flush is only needed
+ *             for them to survive a crash of the OS or a power loss. mmap on POSIX systems,
+ *             CreateFileMapping/MapViewOfFile on Windows.
+ */
+
+#ifndef FILE_MAPPING_H
+#define FILE_MAPPING_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct FILE_MAPPING_TAG* FILE_MAPPING_HANDLE;
+
+/**
+ * @brief    Opens @p file_path, creating it when it does not exist, and maps its @p size bytes.
+ *
+ * @param    created    Set to true when the file was created (or was empty) and was sized to
+ *                      @p size bytes of zeroes, false when it already held @p size bytes.
+ *
+ * @return    A valid @c FILE_MAPPING_HANDLE when successful or @c NULL otherwise, in particular
+ *             when the file exists with a size other than @p size.
+ */
+MOCKABLE_FUNCTION(, FILE_MAPPING_HANDLE, file_mapping_open, const char*, file_path, size_t, size, bool*, created);
+
+/**
+ * @brief    Unmaps the file and closes it.
+ */
+MOCKABLE_FUNCTION(, void, file_mapping_close, FILE_MAPPING_HANDLE, file_mapping);
+
+/**
+ * @brief    Returns the address the first byte of the file is mapped at, aligned on a page.
+ */
+MOCKABLE_FUNCTION(, unsigned char*, file_mapping_get_address, FILE_MAPPING_HANDLE, file_mapping);
+
+/**
+ * @brief    Writes the pages holding the @p size bytes at @p offset back to the file and waits
+ *             until they are on the disk.
+ *
+ * @return    0 on success, a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, file_mapping_flush, FILE_MAPPING_HANDLE, file_mapping, size_t, offset, size_t, size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FILE_MAPPING_H */
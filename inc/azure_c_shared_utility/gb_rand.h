@@ -7,10 +7,22 @@
 #include "azure_c_shared_utility/umock_c_prod.h"
 
 #ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
 extern "C" {
+#else
+#include <stddef.h>
+#include <stdint.h>
 #endif
 
+/* The generator is per thread and seeded from the OS, it is not suitable for cryptographic keys. */
+
+/* a value between 0 and 2^31-1 */
 MOCKABLE_FUNCTION(, int, gb_rand);
+MOCKABLE_FUNCTION(, uint32_t, gb_rand_uint32);
+MOCKABLE_FUNCTION(, uint64_t, gb_rand_uint64);
+/* fills size bytes of buffer with random bytes */
+MOCKABLE_FUNCTION(, void, gb_rand_fill, void*, buffer, size_t, size);
 
 #ifdef __cplusplus
 }
@@ -16,6 +16,31 @@ extern "C"
 #include <stdlib.h>
 #endif
 
+/* The functions gballoc hands its blocks to, see gballoc_set_allocator. free_sized_function is optional: when it is
+not NULL it is given the blocks whose size is known, with the size they were last allocated or reallocated with. */
+typedef struct GBALLOC_ALLOCATOR_TAG
+{
+    void* (*malloc_function)(size_t size);
+    void* (*calloc_function)(size_t nmemb, size_t size);
+    void* (*realloc_function)(void* ptr, size_t size);
+    void (*free_function)(void* ptr);
+    void (*free_sized_function)(void* ptr, size_t size);
+} GBALLOC_ALLOCATOR;
+
+/* Budgets cap the bytes used by a subsystem, see gballoc_budget_begin. Budget 0 is the unlimited default, the library
+uses the next three and the ones up to GBALLOC_BUDGET_COUNT - 1 are free for the application. */
+#define GBALLOC_BUDGET_COUNT 8
+#define GBALLOC_BUDGET_NONE 0
+/* the bytes socketio keeps for the sends that could not be written yet */
+#define GBALLOC_BUDGET_IO_PENDING 1
+/* the fragments of a message uws_client reassembles */
+#define GBALLOC_BUDGET_UWS_FRAGMENTS 2
+/* the content of the responses httpapi_curl receives */
+#define GBALLOC_BUDGET_HTTP_RESPONSE 3
+
+/* called on the thread whose allocation of size bytes failed because it would have gone over the limit of budget */
+typedef void(*ON_GBALLOC_BUDGET_EXCEEDED)(void* context, int budget, size_t size);
+
 // GB_USE_CUSTOM_HEAP disables the implementations in gballoc.c and
 // requires that an external library implement the gballoc_malloc family
 // declared here.
@@ -30,6 +55,16 @@ MOCKABLE_FUNCTION(, void, gballoc_free, void*, ptr);
 #define realloc gballoc_realloc
 #define free gballoc_free
 
+#define gballoc_arena_begin(block_size) ((void)(block_size), 0)
+#define gballoc_arena_end() ((void)0)
+
+#define gballoc_set_allocator(allocator) ((void)(allocator), 1)
+
+#define gballoc_budget_set_limit(budget, max_size, on_budget_exceeded, context) ((void)(budget), (void)(max_size), (void)(on_budget_exceeded), (void)(context), 1)
+#define gballoc_budget_begin(budget) ((void)(budget), GBALLOC_BUDGET_NONE)
+#define gballoc_budget_end(previous_budget) ((void)(previous_budget))
+#define gballoc_budget_get_used(budget) ((void)(budget), (size_t)0)
+
 /* all translation units that need memory measurement need to have GB_MEASURE_MEMORY_FOR_THIS defined */
 /* GB_DEBUG_ALLOC is the switch that turns the measurement on/off, so that it is not on always */
 #elif defined(GB_DEBUG_ALLOC)
@@ -40,12 +75,83 @@ MOCKABLE_FUNCTION(, void*, gballoc_malloc, size_t, size);
 MOCKABLE_FUNCTION(, void*, gballoc_calloc, size_t, nmemb, size_t, size);
 MOCKABLE_FUNCTION(, void*, gballoc_realloc, void*, ptr, size_t, size);
 MOCKABLE_FUNCTION(, void, gballoc_free, void*, ptr);
+/* same as gballoc_free, size is the size ptr was last allocated or reallocated with */
+MOCKABLE_FUNCTION(, void, gballoc_free_sized, void*, ptr, size_t, size);
+
+/* Replaces the heap under gballoc with the functions of allocator, NULL restores the C runtime ones. It only affects
+the allocations routed through gballoc (GB_DEBUG_ALLOC and GB_MEASURE_MEMORY_FOR_THIS, as set by the cmake option
+use_gballoc_allocator), and has to be called at startup: the blocks allocated before must not be freed after it, and
+it fails while gballoc is initialized or an arena scope is open. It is not thread safe. */
+MOCKABLE_FUNCTION(, int, gballoc_set_allocator, const GBALLOC_ALLOCATOR*, allocator);
+
+/* Between gballoc_budget_begin and gballoc_budget_end the tracked allocations of the calling thread are counted in
+budget, and fail once they would take it over the limit set by gballoc_budget_set_limit. gballoc_budget_begin returns
+the budget of the thread before it, to be given to gballoc_budget_end. A block stays in the budget it was allocated or
+last reallocated in until it is freed, by any thread. Only the allocations made while gballoc is initialized are
+counted, and gballoc_init sets the memory used of all the budgets back to 0. */
+MOCKABLE_FUNCTION(, int, gballoc_budget_set_limit, int, budget, size_t, max_size, ON_GBALLOC_BUDGET_EXCEEDED, on_budget_exceeded, void*, context);
+MOCKABLE_FUNCTION(, int, gballoc_budget_begin, int, budget);
+MOCKABLE_FUNCTION(, void, gballoc_budget_end, int, previous_budget);
+MOCKABLE_FUNCTION(, size_t, gballoc_budget_get_used, int, budget);
 
 MOCKABLE_FUNCTION(, size_t, gballoc_getMaximumMemoryUsed);
 MOCKABLE_FUNCTION(, size_t, gballoc_getCurrentMemoryUsed);
 MOCKABLE_FUNCTION(, size_t, gballoc_getAllocationCount);
 MOCKABLE_FUNCTION(, void, gballoc_resetMetrics);
 
+/* entry 0 of the histograms counts the size 0 and entry i the sizes from 2^(i-1) to 2^i - 1, the last one also counts all the larger sizes */
+#define GBALLOC_SIZE_CLASS_COUNT 32
+
+typedef struct GBALLOC_STATISTICS_TAG
+{
+    /* sizes of the blocks handed out by the underlying heap, including the new size of the reallocated ones */
+    size_t allocation_size_histogram[GBALLOC_SIZE_CLASS_COUNT];
+    /* reallocations of a tracked block, realloc with a NULL ptr is counted as an allocation only */
+    size_t realloc_count;
+    size_t realloc_grow_count;
+    size_t realloc_shrink_count;
+    /* by how many bytes the growing reallocations grew the block */
+    size_t realloc_growth_histogram[GBALLOC_SIZE_CLASS_COUNT];
+    size_t realloc_in_place_count;
+    size_t realloc_moved_count;
+    /* the bytes the moving reallocations had to copy, the smaller of the old and the new size */
+    size_t realloc_moved_bytes;
+} GBALLOC_STATISTICS;
+
+MOCKABLE_FUNCTION(, int, gballoc_getStatistics, GBALLOC_STATISTICS*, statistics);
+
+/* Between gballoc_arena_begin and gballoc_arena_end all allocations made by the calling thread through gballoc
+are carved out of blocks of block_size bytes (0 picks a default) and are all released by gballoc_arena_end, freeing
+them individually is a no-op. Scopes nest. Memory obtained inside a scope must not be used after the scope ends,
+nor be freed or reallocated by another thread. */
+MOCKABLE_FUNCTION(, int, gballoc_arena_begin, size_t, block_size);
+MOCKABLE_FUNCTION(, void, gballoc_arena_end);
+
+/* With GB_TRACK_ALLOCATION_SITES the allocations of the translation units that measure memory are recorded with the file
+and line that made them, and counters are kept for each of these sites. The allocations made by calling gballoc_malloc
+and friends directly are recorded under a site with a NULL file. */
+#if defined(GB_TRACK_ALLOCATION_SITES)
+typedef struct GBALLOC_SITE_INFO_TAG
+{
+    const char* file;
+    int line;
+    /* allocations (and reallocations) made at the site since gballoc_init or gballoc_resetMetrics */
+    size_t allocation_count;
+    /* bytes of the blocks last sized at the site that are not freed yet */
+    size_t current_size;
+    size_t max_size;
+} GBALLOC_SITE_INFO;
+
+MOCKABLE_FUNCTION(, void*, gballoc_malloc_at, size_t, size, const char*, file, int, line);
+MOCKABLE_FUNCTION(, void*, gballoc_calloc_at, size_t, nmemb, size_t, size, const char*, file, int, line);
+MOCKABLE_FUNCTION(, void*, gballoc_realloc_at, void*, ptr, size_t, size, const char*, file, int, line);
+
+/* fills sites with up to site_count sites, the ones with the largest max_size first, and gives the number of sites in total_site_count */
+MOCKABLE_FUNCTION(, int, gballoc_getAllocationSites, GBALLOC_SITE_INFO*, sites, size_t, site_count, size_t*, total_site_count);
+/* logs one line per site with LogInfo, the ones with the largest max_size first */
+MOCKABLE_FUNCTION(, void, gballoc_dumpAllocationSites);
+#endif
+
 /* if GB_MEASURE_MEMORY_FOR_THIS is defined then we want to redirect memory allocation functions to gballoc_xxx functions */
 #ifdef GB_MEASURE_MEMORY_FOR_THIS
 /* Unfortunately this is still needed here for things to still compile when using _CRTDBG_MAP_ALLOC.
@@ -59,11 +165,27 @@ That is because there is a rogue component (most likely CppUnitTest) including c
 #define _calloc_dbg(nmemb, size, ...) gballoc_calloc(nmemb, size)
 #define _realloc_dbg(ptr, size, ...) gballoc_realloc(ptr, size)
 #define _free_dbg(ptr, ...) gballoc_free(ptr)
+#elif defined(GB_TRACK_ALLOCATION_SITES)
+/* only calls are redirected, free stays a plain name so that it can still be used as a function pointer */
+#define malloc(size) gballoc_malloc_at(size, __FILE__, __LINE__)
+#define calloc(nmemb, size) gballoc_calloc_at(nmemb, size, __FILE__, __LINE__)
+#define realloc(ptr, size) gballoc_realloc_at(ptr, size, __FILE__, __LINE__)
+#define free gballoc_free
+#if defined(GB_USE_ALLOCATOR)
+#define GBALLOC_FREE_SIZED(ptr, size) gballoc_free_sized(ptr, size)
+#endif
 #else
 #define malloc gballoc_malloc
 #define calloc gballoc_calloc
 #define realloc gballoc_realloc
 #define free gballoc_free
+#if defined(GB_USE_ALLOCATOR)
+#define GBALLOC_FREE_SIZED(ptr, size) gballoc_free_sized(ptr, size)
+#endif
+#endif
+#if defined(GB_USE_BUDGETS)
+#define GBALLOC_BUDGET_BEGIN(budget) gballoc_budget_begin(budget)
+#define GBALLOC_BUDGET_END(previous_budget) gballoc_budget_end(previous_budget)
 #endif
 #endif
 
@@ -76,9 +198,33 @@ That is because there is a rogue component (most likely CppUnitTest) including c
 #define gballoc_getCurrentMemoryUsed() SIZE_MAX
 #define gballoc_getAllocationCount() SIZE_MAX
 #define gballoc_resetMetrics() ((void)0)
+#define gballoc_getStatistics(statistics) ((void)(statistics), 1)
+
+#define gballoc_arena_begin(block_size) ((void)(block_size), 0)
+#define gballoc_arena_end() ((void)0)
+
+#define gballoc_set_allocator(allocator) ((void)(allocator), 1)
+
+#define gballoc_budget_set_limit(budget, max_size, on_budget_exceeded, context) ((void)(budget), (void)(max_size), (void)(on_budget_exceeded), (void)(context), 1)
+#define gballoc_budget_begin(budget) ((void)(budget), GBALLOC_BUDGET_NONE)
+#define gballoc_budget_end(previous_budget) ((void)(previous_budget))
+#define gballoc_budget_get_used(budget) ((void)(budget), (size_t)0)
 
 #endif /* GB_DEBUG_ALLOC */
 
+/* GBALLOC_FREE_SIZED(ptr, size) frees a block allocated in the same translation unit whose size is known. Only the
+translation units built with GB_USE_ALLOCATOR pass the size on, the others call free. */
+#ifndef GBALLOC_FREE_SIZED
+#define GBALLOC_FREE_SIZED(ptr, size) ((void)(size), free(ptr))
+#endif
+
+/* GBALLOC_BUDGET_BEGIN and GBALLOC_BUDGET_END put the allocations of the library in a budget in the translation units
+built with GB_USE_BUDGETS, and do nothing in the others */
+#ifndef GBALLOC_BUDGET_BEGIN
+#define GBALLOC_BUDGET_BEGIN(budget) ((void)(budget), GBALLOC_BUDGET_NONE)
+#define GBALLOC_BUDGET_END(previous_budget) ((void)(previous_budget))
+#endif
+
 #ifdef __cplusplus
 }
 #endif
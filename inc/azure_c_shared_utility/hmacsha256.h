@@ -6,6 +6,8 @@
 
 #include "azure_c_shared_utility/macro_utils.h"
 #include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/constbuffer_array.h"
+#include "azure_c_shared_utility/sha.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
 
 #ifdef __cplusplus
@@ -19,8 +21,45 @@ extern "C" {
 
 DEFINE_ENUM(HMACSHA256_RESULT, HMACSHA256_RESULT_VALUES)
 
+/* holds the SHA-256 state after the key XOR ipad and key XOR opad blocks, so
+   that hashing many payloads with the same key does not compress them each time */
+typedef struct HMACSHA256_KEY_CONTEXT_TAG* HMACSHA256_KEY_CONTEXT_HANDLE;
+
+/* an HMAC-SHA256 computed over a payload given in several pieces. It is owned by the caller,
+   typically on the stack, and holds state derived from the key, so Final clears it */
+typedef struct HMACSHA256_STREAM_TAG
+{
+    SHA256Context inner;
+    SHA256Context outer;
+} HMACSHA256_STREAM;
+
+/* one key and payload of HMACSHA256_ComputeHashBatch, hash receives the result as with HMACSHA256_ComputeHash */
+typedef struct HMACSHA256_BATCH_ITEM_TAG
+{
+    const unsigned char* key;
+    size_t keyLen;
+    const unsigned char* payload;
+    size_t payloadLen;
+    BUFFER_HANDLE hash;
+} HMACSHA256_BATCH_ITEM;
+
 MOCKABLE_FUNCTION(, HMACSHA256_RESULT, HMACSHA256_ComputeHash, const unsigned char*, key, size_t, keyLen, const unsigned char*, payload, size_t, payloadLen, BUFFER_HANDLE, hash);
 
+MOCKABLE_FUNCTION(, HMACSHA256_KEY_CONTEXT_HANDLE, HMACSHA256_KeyContext_Create, const unsigned char*, key, size_t, keyLen);
+MOCKABLE_FUNCTION(, void, HMACSHA256_KeyContext_Destroy, HMACSHA256_KEY_CONTEXT_HANDLE, keyContext);
+MOCKABLE_FUNCTION(, HMACSHA256_RESULT, HMACSHA256_ComputeHashWithKeyContext, HMACSHA256_KEY_CONTEXT_HANDLE, keyContext, const unsigned char*, payload, size_t, payloadLen, BUFFER_HANDLE, hash);
+
+MOCKABLE_FUNCTION(, HMACSHA256_RESULT, HMACSHA256_Stream_Init, HMACSHA256_STREAM*, stream, const unsigned char*, key, size_t, keyLen);
+MOCKABLE_FUNCTION(, HMACSHA256_RESULT, HMACSHA256_Stream_InitWithKeyContext, HMACSHA256_STREAM*, stream, HMACSHA256_KEY_CONTEXT_HANDLE, keyContext);
+MOCKABLE_FUNCTION(, HMACSHA256_RESULT, HMACSHA256_Stream_Update, HMACSHA256_STREAM*, stream, const unsigned char*, data, size_t, dataLen);
+MOCKABLE_FUNCTION(, HMACSHA256_RESULT, HMACSHA256_Stream_Final, HMACSHA256_STREAM*, stream, BUFFER_HANDLE, hash);
+
+/* hashes independent items together, several at a time when the CPU can advance several SHA-256 hashes at once */
+MOCKABLE_FUNCTION(, HMACSHA256_RESULT, HMACSHA256_ComputeHashBatch, HMACSHA256_BATCH_ITEM*, items, size_t, itemCount);
+
+/* hashes the buffers of payload in order, as if they were one contiguous payload */
+MOCKABLE_FUNCTION(, HMACSHA256_RESULT, HMACSHA256_ComputeHashOfConstBufferArray, const unsigned char*, key, size_t, keyLen, CONSTBUFFER_ARRAY_HANDLE, payload, BUFFER_HANDLE, hash);
+
 #ifdef __cplusplus
 }
 #endif
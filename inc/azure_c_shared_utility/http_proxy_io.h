@@ -8,7 +8,12 @@
 #include "azure_c_shared_utility/umock_c_prod.h"
 
 #ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
 extern "C" {
+#else
+#include <stddef.h>
+#include <stdint.h>
 #endif /* __cplusplus */
 
 typedef struct HTTP_PROXY_IO_CONFIG_TAG
@@ -21,8 +26,24 @@ typedef struct HTTP_PROXY_IO_CONFIG_TAG
     const char* password;
 } HTTP_PROXY_IO_CONFIG;
 
+/* A pool of CONNECT tunnels established ahead of time, keyed by proxy, credentials and target host:port.
+   An HTTP proxy IO that has the pool set through OPTION_HTTP_PROXY_TUNNEL_POOL takes an idle tunnel to its
+   target when opened, instead of connecting to the proxy and waiting for the CONNECT response, and the pool
+   starts establishing a replacement. Idle tunnels are closed after idle_timeout_ms, bytes received on an idle
+   tunnel close it too. The pool is not thread safe: it and the IOs using it must be worked from one thread,
+   and it must outlive them. */
+typedef struct HTTP_PROXY_TUNNEL_POOL_TAG* HTTP_PROXY_TUNNEL_POOL_HANDLE;
+
 MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, http_proxy_io_get_interface_description);
 
+MOCKABLE_FUNCTION(, HTTP_PROXY_TUNNEL_POOL_HANDLE, http_proxy_tunnel_pool_create, size_t, max_tunnels_per_target, uint32_t, idle_timeout_ms);
+MOCKABLE_FUNCTION(, void, http_proxy_tunnel_pool_destroy, HTTP_PROXY_TUNNEL_POOL_HANDLE, tunnel_pool);
+/* Starts establishing tunnels to the target of config until tunnel_count of them (at most max_tunnels_per_target) are idle or being established */
+MOCKABLE_FUNCTION(, int, http_proxy_tunnel_pool_warm, HTTP_PROXY_TUNNEL_POOL_HANDLE, tunnel_pool, const HTTP_PROXY_IO_CONFIG*, config, size_t, tunnel_count);
+/* Works the tunnels of the pool and closes the ones that failed or stayed idle for too long */
+MOCKABLE_FUNCTION(, void, http_proxy_tunnel_pool_dowork, HTTP_PROXY_TUNNEL_POOL_HANDLE, tunnel_pool);
+MOCKABLE_FUNCTION(, size_t, http_proxy_tunnel_pool_get_idle_count, HTTP_PROXY_TUNNEL_POOL_HANDLE, tunnel_pool);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
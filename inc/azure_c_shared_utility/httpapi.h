@@ -165,6 +165,49 @@ MOCKABLE_FUNCTION(, HTTPAPI_RESULT, HTTPAPI_ExecuteRequest, HTTP_HANDLE, handle,
                                              size_t, contentLength, unsigned int*, statusCode,
                                              HTTP_HEADERS_HANDLE, responseHeadersHandle, BUFFER_HANDLE, responseContent);
 
+/**
+ * @brief    Called by ::HTTPAPI_ExecuteStreamingRequest to get the next piece of
+ *             the request body.
+ *
+ *            The callback copies at most @p bufferSize bytes into @p buffer and
+ *            sets @p bytesRead to the number of bytes copied. Setting @p bytesRead
+ *            to 0 before the announced content length has been produced is an error.
+ *
+ * @return    0 on success, any other value aborts the request.
+ */
+typedef int(*HTTPAPI_READ_CONTENT)(void* context, unsigned char* buffer, size_t bufferSize, size_t* bytesRead);
+
+/**
+ * @brief    Called by ::HTTPAPI_ExecuteStreamingRequest for every piece of the
+ *             response body, in order, as it is received.
+ *
+ * @return    0 on success, any other value aborts the request.
+ */
+typedef int(*HTTPAPI_WRITE_CONTENT)(void* context, const unsigned char* buffer, size_t size);
+
+/**
+ * @brief    Same as ::HTTPAPI_ExecuteRequest, except that the request body is
+ *             pulled from @p readContent and the response body is pushed to
+ *             @p writeContent in pieces, so that neither of them needs to be held
+ *             in memory.
+ *
+ * @param    contentLength             The exact size of the request body. When it is
+ *                                     0, @p readContent is not called and can be @c NULL.
+ * @param    writeContent              Receives the response body. When it is @c NULL
+ *                                     the response body is discarded.
+ *
+ *            The callbacks are called on the thread calling
+ *            ::HTTPAPI_ExecuteStreamingRequest, before it returns. Adapters that cannot
+ *            stream return @c HTTPAPI_ERROR.
+ *
+ * @return    @c HTTPAPI_OK if the API call is successful or an error
+ *             code in case it fails.
+ */
+MOCKABLE_FUNCTION(, HTTPAPI_RESULT, HTTPAPI_ExecuteStreamingRequest, HTTP_HANDLE, handle, HTTPAPI_REQUEST_TYPE, requestType, const char*, relativePath,
+                                             HTTP_HEADERS_HANDLE, httpHeadersHandle, size_t, contentLength,
+                                             HTTPAPI_READ_CONTENT, readContent, void*, readContentContext, unsigned int*, statusCode,
+                                             HTTP_HEADERS_HANDLE, responseHeadersHandle, HTTPAPI_WRITE_CONTENT, writeContent, void*, writeContentContext);
+
 /**
  * @brief    Sets the option named @p optionName bearing the value
  *             @p value for the HTTP_HANDLE @p handle.
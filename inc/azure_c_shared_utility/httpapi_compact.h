@@ -0,0 +1,70 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file httpapi_compact.h
+ *    @brief     HTTP/1.1 pipelining extension of the HTTP API, available when the
+ *             built-in httpapi_compact adapter is used (use_builtin_httpapi).
+ *
+ *    @details ::httpapi_compact_execute_pipelined_requests sends a batch of
+ *             requests on the connection of an @c HTTP_HANDLE without waiting for
+ *             each response before sending the next one, which saves a round trip
+ *             per request for bursts of small requests to the same host. The
+ *             responses are matched to the requests in order. At most
+ *             @c OPTION_HTTP_PIPELINE_DEPTH requests are in flight at any time; the
+ *             default of 1 sends each request after the previous response.
+ *
+ *             When the server closes the connection (@c Connection: close or an
+ *             error) the requests still waiting for their response are sent again on
+ *             a new connection if they are idempotent (GET, HEAD, PUT, DELETE). The
+ *             others fail with @c HTTPAPI_READ_DATA_FAILED since the server may have
+ *             processed them.
+ */
+
+#ifndef HTTPAPI_COMPACT_H
+#define HTTPAPI_COMPACT_H
+
+#include "azure_c_shared_utility/httpapi.h"
+#include "azure_c_shared_utility/httpheaders.h"
+#include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C" {
+#else
+#include <stddef.h>
+#endif
+
+/**
+ * @brief    One request of a pipelined batch. The fields up to @c responseContent
+ *             have the same meaning as the parameters of ::HTTPAPI_ExecuteRequest;
+ *             @c result receives the outcome of this request.
+ */
+typedef struct HTTPAPI_PIPELINED_REQUEST_TAG
+{
+    HTTPAPI_REQUEST_TYPE requestType;
+    const char* relativePath;
+    HTTP_HEADERS_HANDLE httpHeadersHandle;
+    const unsigned char* content;
+    size_t contentLength;
+    unsigned int* statusCode;
+    HTTP_HEADERS_HANDLE responseHeadersHandle;
+    BUFFER_HANDLE responseContent;
+    HTTPAPI_RESULT result;
+} HTTPAPI_PIPELINED_REQUEST;
+
+/**
+ * @brief    Executes the @p requestCount requests of @p requests on @p handle,
+ *             pipelining up to @c OPTION_HTTP_PIPELINE_DEPTH of them.
+ *
+ * @return    @c HTTPAPI_OK when every request got its response, otherwise the
+ *             result of the first request that failed. @c HTTPAPI_INVALID_ARG if any
+ *             parameter or request is invalid, in which case nothing is sent.
+ */
+MOCKABLE_FUNCTION(, HTTPAPI_RESULT, httpapi_compact_execute_pipelined_requests, HTTP_HANDLE, handle, HTTPAPI_PIPELINED_REQUEST*, requests, size_t, requestCount);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HTTPAPI_COMPACT_H */
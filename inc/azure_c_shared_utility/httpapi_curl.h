@@ -0,0 +1,115 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file httpapi_curl.h
+ *    @brief     Asynchronous extension of the HTTP API, available when the curl
+ *             adapter is used.
+ *
+ *    @details Requests submitted with ::httpapi_curl_async_execute_request do not
+ *             block the calling thread. They are driven by ::httpapi_curl_async_dowork
+ *             through a curl multi handle, which shares the connections between the
+ *             requests and multiplexes them over one HTTP/2 connection when the
+ *             server supports it (otherwise HTTP/1.1 with connection reuse is used).
+ *             The HTTP version can be forced with the @c OPTION_HTTP_VERSION option,
+ *             which ::HTTPAPI_SetOption also accepts for the synchronous requests
+ *             (they default to HTTP/1.1).
+ *             ::HTTPAPI_Init must be called before creating an instance, as for
+ *             ::HTTPAPI_CreateConnection.
+ */
+
+#ifndef HTTPAPI_CURL_H
+#define HTTPAPI_CURL_H
+
+#include "azure_c_shared_utility/httpapi.h"
+#include "azure_c_shared_utility/httpheaders.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C" {
+#else
+#include <stddef.h>
+#endif
+
+typedef struct HTTPAPI_CURL_ASYNC_INSTANCE_TAG* HTTPAPI_CURL_ASYNC_HANDLE;
+
+/**
+ * @brief    Called once for every submitted request.
+ *
+ *            @p result is @c HTTPAPI_OK when a response has been received (whatever
+ *            its status code), @c HTTPAPI_ERROR when the request was cancelled by
+ *            ::httpapi_curl_async_destroy and another error code when the transfer
+ *            failed. @p responseHeaders, @p content and @p contentLength describe the
+ *            response and are only valid for the duration of the callback.
+ */
+typedef void(*ON_HTTPAPI_CURL_REQUEST_COMPLETE)(void* context, HTTPAPI_RESULT result, unsigned int statusCode, HTTP_HEADERS_HANDLE responseHeaders, const unsigned char* content, size_t contentLength);
+
+/**
+ * @brief    Creates an asynchronous HTTPS client for the host @p hostName.
+ *
+ * @return    A handle to the instance or @c NULL in case an error occurs.
+ */
+MOCKABLE_FUNCTION(, HTTPAPI_CURL_ASYNC_HANDLE, httpapi_curl_async_create, const char*, hostName);
+
+/**
+ * @brief    Destroys the instance. Requests that have not completed yet are
+ *             cancelled and their callbacks are called with @c HTTPAPI_ERROR.
+ *             Must not be called from a completion callback.
+ */
+MOCKABLE_FUNCTION(, void, httpapi_curl_async_destroy, HTTPAPI_CURL_ASYNC_HANDLE, handle);
+
+/**
+ * @brief    Submits a request. The parameters have the same meaning as for
+ *             ::HTTPAPI_ExecuteRequest; the headers and the content are copied, so
+ *             they can be released as soon as this function returns.
+ *
+ * @return    @c HTTPAPI_OK if the request has been queued, in which case
+ *             @p on_request_complete will be called exactly once, or an error code.
+ */
+MOCKABLE_FUNCTION(, HTTPAPI_RESULT, httpapi_curl_async_execute_request, HTTPAPI_CURL_ASYNC_HANDLE, handle, HTTPAPI_REQUEST_TYPE, requestType, const char*, relativePath,
+                                             HTTP_HEADERS_HANDLE, httpHeadersHandle, const unsigned char*, content, size_t, contentLength,
+                                             ON_HTTPAPI_CURL_REQUEST_COMPLETE, on_request_complete, void*, on_request_complete_context);
+
+/**
+ * @brief    Submits a request whose response content is handed to @p writeContent
+ *             chunk by chunk as it arrives instead of being accumulated, so that
+ *             large downloads do not need to fit in memory. @p writeContent has the
+ *             same contract as for ::HTTPAPI_ExecuteRequestStreaming: returning a
+ *             non-zero value aborts the transfer and the request completes with
+ *             @c HTTPAPI_READ_DATA_FAILED. @p on_request_complete is called with no
+ *             content.
+ *
+ * @return    @c HTTPAPI_OK if the request has been queued, in which case
+ *             @p on_request_complete will be called exactly once, or an error code.
+ */
+MOCKABLE_FUNCTION(, HTTPAPI_RESULT, httpapi_curl_async_execute_request_streaming, HTTPAPI_CURL_ASYNC_HANDLE, handle, HTTPAPI_REQUEST_TYPE, requestType, const char*, relativePath,
+                                             HTTP_HEADERS_HANDLE, httpHeadersHandle, const unsigned char*, content, size_t, contentLength,
+                                             HTTPAPI_WRITE_CONTENT, writeContent, void*, writeContentContext,
+                                             ON_HTTPAPI_CURL_REQUEST_COMPLETE, on_request_complete, void*, on_request_complete_context);
+
+/**
+ * @brief    Makes progress on all the submitted requests without blocking and
+ *             calls the completion callbacks of the requests that have finished.
+ */
+MOCKABLE_FUNCTION(, void, httpapi_curl_async_dowork, HTTPAPI_CURL_ASYNC_HANDLE, handle);
+
+/**
+ * @brief    Waits at most @p timeout_ms milliseconds for activity on the
+ *             connections of the instance, so that a caller can poll
+ *             ::httpapi_curl_async_dowork without spinning.
+ *
+ * @return    0 on success or a non-zero value in case an error occurs.
+ */
+MOCKABLE_FUNCTION(, int, httpapi_curl_async_wait, HTTPAPI_CURL_ASYNC_HANDLE, handle, unsigned int, timeout_ms);
+
+/**
+ * @brief    Sets an option for all requests submitted afterwards. Accepts the
+ *             same options as ::HTTPAPI_SetOption.
+ */
+MOCKABLE_FUNCTION(, HTTPAPI_RESULT, httpapi_curl_async_set_option, HTTPAPI_CURL_ASYNC_HANDLE, handle, const char*, optionName, const void*, value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HTTPAPI_CURL_H */
@@ -0,0 +1,99 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file httpapi_winhttp.h
+ *    @brief     Asynchronous extension of the HTTP API, available when the WinHTTP
+ *             adapter is used.
+ *
+ *    @details Requests submitted with ::httpapi_winhttp_async_execute_request do not
+ *             block the calling thread. Each instance owns a WinHTTP session opened
+ *             with @c WINHTTP_FLAG_ASYNC; the requests make progress on the WinHTTP
+ *             thread pool and their completion callbacks are called by
+ *             ::httpapi_winhttp_async_dowork on the thread that calls it, so that one
+ *             thread can drive many concurrent requests. HTTP/2 is requested when the
+ *             system supports it, in which case concurrent requests share a connection.
+ *             ::HTTPAPI_Init must be called before creating an instance, as for
+ *             ::HTTPAPI_CreateConnection.
+ */
+
+#ifndef HTTPAPI_WINHTTP_H
+#define HTTPAPI_WINHTTP_H
+
+#include "azure_c_shared_utility/httpapi.h"
+#include "azure_c_shared_utility/httpheaders.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C" {
+#else
+#include <stddef.h>
+#endif
+
+typedef struct HTTPAPI_WINHTTP_ASYNC_INSTANCE_TAG* HTTPAPI_WINHTTP_ASYNC_HANDLE;
+
+/**
+ * @brief    Called once for every submitted request, from ::httpapi_winhttp_async_dowork
+ *             or ::httpapi_winhttp_async_destroy.
+ *
+ *            @p result is @c HTTPAPI_OK when a response has been received (whatever
+ *            its status code), @c HTTPAPI_ERROR when the request was cancelled by
+ *            ::httpapi_winhttp_async_destroy and another error code when the transfer
+ *            failed. @p responseHeaders, @p content and @p contentLength describe the
+ *            response and are only valid for the duration of the callback.
+ */
+typedef void(*ON_HTTPAPI_WINHTTP_REQUEST_COMPLETE)(void* context, HTTPAPI_RESULT result, unsigned int statusCode, HTTP_HEADERS_HANDLE responseHeaders, const unsigned char* content, size_t contentLength);
+
+/**
+ * @brief    Creates an asynchronous HTTPS client for the host @p hostName.
+ *
+ * @return    A handle to the instance or @c NULL in case an error occurs.
+ */
+MOCKABLE_FUNCTION(, HTTPAPI_WINHTTP_ASYNC_HANDLE, httpapi_winhttp_async_create, const char*, hostName);
+
+/**
+ * @brief    Destroys the instance. Requests that have not completed yet are
+ *             cancelled and their callbacks are called with @c HTTPAPI_ERROR before
+ *             this function returns. Must not be called from a completion callback.
+ */
+MOCKABLE_FUNCTION(, void, httpapi_winhttp_async_destroy, HTTPAPI_WINHTTP_ASYNC_HANDLE, handle);
+
+/**
+ * @brief    Submits a request. The parameters have the same meaning as for
+ *             ::HTTPAPI_ExecuteRequest; the headers and the content are copied, so
+ *             they can be released as soon as this function returns.
+ *
+ * @return    @c HTTPAPI_OK if the request has been submitted, in which case
+ *             @p on_request_complete will be called exactly once, or an error code.
+ */
+MOCKABLE_FUNCTION(, HTTPAPI_RESULT, httpapi_winhttp_async_execute_request, HTTPAPI_WINHTTP_ASYNC_HANDLE, handle, HTTPAPI_REQUEST_TYPE, requestType, const char*, relativePath,
+                                             HTTP_HEADERS_HANDLE, httpHeadersHandle, const unsigned char*, content, size_t, contentLength,
+                                             ON_HTTPAPI_WINHTTP_REQUEST_COMPLETE, on_request_complete, void*, on_request_complete_context);
+
+/**
+ * @brief    Calls the completion callbacks of the requests that have finished
+ *             since the last call. Never blocks.
+ */
+MOCKABLE_FUNCTION(, void, httpapi_winhttp_async_dowork, HTTPAPI_WINHTTP_ASYNC_HANDLE, handle);
+
+/**
+ * @brief    Waits at most @p timeout_ms milliseconds for a request of the instance
+ *             to finish, so that a caller can poll ::httpapi_winhttp_async_dowork
+ *             without spinning.
+ *
+ * @return    0 on success (including when the timeout expires) or a non-zero value
+ *             in case an error occurs.
+ */
+MOCKABLE_FUNCTION(, int, httpapi_winhttp_async_wait, HTTPAPI_WINHTTP_ASYNC_HANDLE, handle, unsigned int, timeout_ms);
+
+/**
+ * @brief    Sets an option for all requests submitted afterwards. Accepts the
+ *             same options as ::HTTPAPI_SetOption.
+ */
+MOCKABLE_FUNCTION(, HTTPAPI_RESULT, httpapi_winhttp_async_set_option, HTTPAPI_WINHTTP_ASYNC_HANDLE, handle, const char*, optionName, const void*, value);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* HTTPAPI_WINHTTP_H */
@@ -81,6 +81,26 @@ MOCKABLE_FUNCTION(, HTTPAPIEX_HANDLE, HTTPAPIEX_Create, const char*, hostName);
  */
 MOCKABLE_FUNCTION(, HTTPAPIEX_RESULT, HTTPAPIEX_ExecuteRequest, HTTPAPIEX_HANDLE, handle, HTTPAPI_REQUEST_TYPE, requestType, const char*, relativePath, HTTP_HEADERS_HANDLE, requestHttpHeadersHandle, BUFFER_HANDLE, requestContent, unsigned int*, statusCode, HTTP_HEADERS_HANDLE, responseHttpHeadersHandle, BUFFER_HANDLE, responseContent);
 
+/**
+ * @brief    Tries to execute an HTTP request whose request and response bodies
+ *             are streamed instead of being held in memory.
+ *
+ * @param    requestContentLength         The exact size of the request body.
+ * @param    readRequestContent           Produces the request body in pieces, see
+ *                                         ::HTTPAPI_READ_CONTENT. Can be @c NULL when
+ *                                         @p requestContentLength is 0.
+ * @param    writeResponseContent         Consumes the response body in pieces, see
+ *                                         ::HTTPAPI_WRITE_CONTENT. If @c NULL, the
+ *                                         response body is discarded.
+ *
+ *             The other parameters are the same as for ::HTTPAPIEX_ExecuteRequest. A body
+ *             that has started streaming cannot be replayed, so the request is retried on a
+ *             new connection only as long as neither callback has been called.
+ *
+ * @return    An @c HTTPAPIEX_RESULT indicating the status of the call.
+ */
+MOCKABLE_FUNCTION(, HTTPAPIEX_RESULT, HTTPAPIEX_ExecuteStreamingRequest, HTTPAPIEX_HANDLE, handle, HTTPAPI_REQUEST_TYPE, requestType, const char*, relativePath, HTTP_HEADERS_HANDLE, requestHttpHeadersHandle, size_t, requestContentLength, HTTPAPI_READ_CONTENT, readRequestContent, void*, readRequestContentContext, unsigned int*, statusCode, HTTP_HEADERS_HANDLE, responseHttpHeadersHandle, HTTPAPI_WRITE_CONTENT, writeResponseContent, void*, writeResponseContentContext);
+
 /**
  * @brief    Frees all resources used by the @c HTTPAPIEX_HANDLE object.
  *
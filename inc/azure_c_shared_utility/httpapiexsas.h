@@ -14,6 +14,10 @@
 extern "C" {
 #endif
 
+/* a SAS token is reused by the following requests until it expires in less than this many seconds */
+#ifndef HTTPAPIEX_SAS_DEFAULT_TOKEN_REFRESH_MARGIN
+#define HTTPAPIEX_SAS_DEFAULT_TOKEN_REFRESH_MARGIN 600
+#endif
 
 typedef struct HTTPAPIEX_SAS_STATE_TAG* HTTPAPIEX_SAS_HANDLE;
 
@@ -23,6 +27,8 @@ MOCKABLE_FUNCTION(, HTTPAPIEX_SAS_HANDLE, HTTPAPIEX_SAS_Create_From_String, cons
 
 MOCKABLE_FUNCTION(, void, HTTPAPIEX_SAS_Destroy, HTTPAPIEX_SAS_HANDLE, handle);
 
+MOCKABLE_FUNCTION(, int, HTTPAPIEX_SAS_SetTokenRefreshMargin, HTTPAPIEX_SAS_HANDLE, sasHandle, size_t, refreshMargin);
+
 MOCKABLE_FUNCTION(, HTTPAPIEX_RESULT, HTTPAPIEX_SAS_ExecuteRequest, HTTPAPIEX_SAS_HANDLE, sasHandle, HTTPAPIEX_HANDLE, handle, HTTPAPI_REQUEST_TYPE, requestType, const char*, relativePath, HTTP_HEADERS_HANDLE, requestHttpHeadersHandle, BUFFER_HANDLE, requestContent, unsigned int*, statusCode, HTTP_HEADERS_HANDLE, responseHeadersHandle, BUFFER_HANDLE, responseContent);
 
 #ifdef __cplusplus
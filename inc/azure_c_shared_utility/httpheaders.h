@@ -15,6 +15,11 @@
 *                  of all the headers
 *                - ::HTTPHeaders_GetHeader - when the application needs to retrieve the
 *                  <code>name + ": " + value</code> string based on an index.
+*                - ::HTTPHeaders_Serialize - when the application needs all the headers
+*                  written into a request buffer.
+*
+*             Header names are case-insensitive, as RFC 7230 section 3.2 requires. The
+*             names and values are kept in a single growable buffer owned by the handle.
 */
 
 #ifndef HTTPHEADERS_H
@@ -98,6 +103,26 @@ MOCKABLE_FUNCTION(, HTTP_HEADERS_RESULT, HTTPHeaders_AddHeaderNameValuePair, HTT
  */
 MOCKABLE_FUNCTION(, HTTP_HEADERS_RESULT, HTTPHeaders_ReplaceHeaderNameValuePair, HTTP_HEADERS_HANDLE, httpHeadersHandle, const char*, name, const char*, value);
 
+/**
+ * @brief    Appends raw header lines, the way they arrive in a response, without
+ *             parsing them.
+ *
+ * @param    httpHeadersHandle    A valid @c HTTP_HEADERS_HANDLE value.
+ * @param    lines                One or more <code>name: value</code> lines ended by
+ *                                 CR LF or LF; the last terminator can be left out. Lines
+ *                                 without a ':', like a status line, and lines with an
+ *                                 invalid name are ignored.
+ * @param    length               The number of characters in @p lines.
+ *
+ *            The lines are copied into a buffer of the handle and are only parsed, as
+ *            if each was given to ::HTTPHeaders_AddHeaderNameValuePair, the first time
+ *            the headers are read or changed. Headers that are never read cost a copy.
+ *
+ * @return    Returns @c HTTP_HEADERS_OK when execution is successful,
+ *             @c HTTP_HEADERS_INVALID_ARG or @c HTTP_HEADERS_ALLOC_FAILED.
+ */
+MOCKABLE_FUNCTION(, HTTP_HEADERS_RESULT, HTTPHeaders_AppendHeaderLines, HTTP_HEADERS_HANDLE, httpHeadersHandle, const char*, lines, size_t, length);
+
 /**
  * @brief    Retrieves the value for a previously stored name.
  *
@@ -105,7 +130,8 @@ MOCKABLE_FUNCTION(, HTTP_HEADERS_RESULT, HTTPHeaders_ReplaceHeaderNameValuePair,
  * @param    name                 The name of the HTTP header to find.
  *
  * @return    The return value points to a string that shall be @c strcmp equal
- *             to the original stored string.
+ *             to the original stored string. It is valid until the headers are
+ *             modified or freed.
  */
 MOCKABLE_FUNCTION(, const char*, HTTPHeaders_FindHeaderValue, HTTP_HEADERS_HANDLE, httpHeadersHandle, const char*, name);
 
@@ -138,6 +164,23 @@ MOCKABLE_FUNCTION(, HTTP_HEADERS_RESULT, HTTPHeaders_GetHeaderCount, HTTP_HEADER
  */
 MOCKABLE_FUNCTION(, HTTP_HEADERS_RESULT, HTTPHeaders_GetHeader, HTTP_HEADERS_HANDLE, handle, size_t, index, char**, destination);
 
+/**
+ * @brief    This API writes the string name+": "+value+"\r\n" for every header, in
+ *             the order in which the headers were added, followed by a null terminator.
+ *
+ * @param    handle            A valid @c HTTP_HEADERS_HANDLE value.
+ * @param    buffer            The buffer to write into. Can be @c NULL when
+ *                              @p bufferSize is @c 0, to query the size only.
+ * @param    bufferSize        The size of @p buffer in bytes.
+ * @param    serializedSize    Receives the number of characters of the serialized
+ *                              headers, not counting the null terminator.
+ *
+ * @return    Returns @c HTTP_HEADERS_OK when execution is successful,
+ *             @c HTTP_HEADERS_INSUFFICIENT_BUFFER when @p bufferSize is not greater
+ *             than @p *serializedSize or @c HTTP_HEADERS_INVALID_ARG.
+ */
+MOCKABLE_FUNCTION(, HTTP_HEADERS_RESULT, HTTPHeaders_Serialize, HTTP_HEADERS_HANDLE, handle, char*, buffer, size_t, bufferSize, size_t*, serializedSize);
+
 /**
  * @brief    This API produces a clone of the @p handle parameter.
  *
@@ -17,6 +17,16 @@
 #include "azure_c_shared_utility/macro_utils.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
 
+#if defined(LOCK_PROFILING)
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -70,6 +80,141 @@ MOCKABLE_FUNCTION(, LOCK_RESULT, Unlock, LOCK_HANDLE, handle);
  */
 MOCKABLE_FUNCTION(, LOCK_RESULT, Lock_Deinit, LOCK_HANDLE, handle);
 
+/* With LOCK_PROFILING each lock counts its acquisitions, the acquisitions that found it held (contended)
+and the time spent waiting for it, and is tagged with the file and line of the Lock_Init that created it.
+When a lock is deinitialized its counters are added to a record kept for its creation site, so that the
+short lived locks of a site are still accounted for. The locks created by calling Lock_Init through a
+pointer are tagged with a NULL file. */
+#if defined(LOCK_PROFILING)
+typedef struct LOCK_PROFILE_INFO_TAG
+{
+    const char* file;
+    int line;
+    /* the lock for a lock that is alive, NULL for the record of the deinitialized locks of the site */
+    LOCK_HANDLE handle;
+    /* 1 for a lock that is alive, the number of deinitialized locks for the record of a site */
+    size_t lock_count;
+    uint64_t acquisition_count;
+    uint64_t contended_count;
+    /* time spent waiting in the contended acquisitions, in nanoseconds */
+    uint64_t total_wait_ns;
+    uint64_t max_wait_ns;
+} LOCK_PROFILE_INFO;
+
+MOCKABLE_FUNCTION(, LOCK_HANDLE, Lock_Init_at, const char*, file, int, line);
+
+/* fills profiles with up to profile_count entries, the ones with the largest total_wait_ns first, and gives the number of entries
+in total_profile_count. The counters of the locks in use are read without taking them, so they are a snapshot. */
+MOCKABLE_FUNCTION(, int, Lock_GetProfiles, LOCK_PROFILE_INFO*, profiles, size_t, profile_count, size_t*, total_profile_count);
+/* logs one line per entry with LogInfo, the ones with the largest total_wait_ns first */
+MOCKABLE_FUNCTION(, void, Lock_DumpProfiles);
+
+#define Lock_Init() Lock_Init_at(__FILE__, __LINE__)
+#endif
+
+typedef void* RWLOCK_HANDLE;
+
+/**
+ * @brief    This API creates and returns a valid reader/writer lock handle.
+ *             Any number of threads may hold the lock shared at the same time,
+ *             while an exclusive holder excludes everybody else.
+ *
+ * @return    A valid @c RWLOCK_HANDLE when successful or @c NULL otherwise.
+ */
+MOCKABLE_FUNCTION(, RWLOCK_HANDLE, RWLock_Init);
+
+/**
+ * @brief    Acquires the lock in shared mode, for reading. Not recursive.
+ *
+ * @param    handle    A valid handle to the reader/writer lock.
+ *
+ * @return    Returns @c LOCK_OK when the lock has been acquired and
+ *             @c LOCK_ERROR when an error occurs.
+ */
+MOCKABLE_FUNCTION(, LOCK_RESULT, RWLock_LockShared, RWLOCK_HANDLE, handle);
+
+/**
+ * @brief    Releases the lock acquired with ::RWLock_LockShared.
+ *
+ * @param    handle    A valid handle to the reader/writer lock.
+ *
+ * @return    Returns @c LOCK_OK when the lock has been released and
+ *             @c LOCK_ERROR when an error occurs.
+ */
+MOCKABLE_FUNCTION(, LOCK_RESULT, RWLock_UnlockShared, RWLOCK_HANDLE, handle);
+
+/**
+ * @brief    Acquires the lock in exclusive mode, for writing. Not recursive.
+ *
+ * @param    handle    A valid handle to the reader/writer lock.
+ *
+ * @return    Returns @c LOCK_OK when the lock has been acquired and
+ *             @c LOCK_ERROR when an error occurs.
+ */
+MOCKABLE_FUNCTION(, LOCK_RESULT, RWLock_LockExclusive, RWLOCK_HANDLE, handle);
+
+/**
+ * @brief    Releases the lock acquired with ::RWLock_LockExclusive.
+ *
+ * @param    handle    A valid handle to the reader/writer lock.
+ *
+ * @return    Returns @c LOCK_OK when the lock has been released and
+ *             @c LOCK_ERROR when an error occurs.
+ */
+MOCKABLE_FUNCTION(, LOCK_RESULT, RWLock_UnlockExclusive, RWLOCK_HANDLE, handle);
+
+/**
+ * @brief    The reader/writer lock instance is destroyed.
+ *
+ * @param    handle    A valid handle to the reader/writer lock.
+ *
+ * @return    Returns @c LOCK_OK when the lock object has been
+ *             destroyed and @c LOCK_ERROR when an error occurs.
+ */
+MOCKABLE_FUNCTION(, LOCK_RESULT, RWLock_Deinit, RWLOCK_HANDLE, handle);
+
+typedef void* SPINLOCK_HANDLE;
+
+/**
+ * @brief    This API creates and returns a valid spin lock handle. A spin lock
+ *             never puts the thread to sleep, so it is only meant for locks
+ *             held for a few instructions: a waiting thread spins for a while
+ *             and then keeps yielding its time slice until the lock is free.
+ *
+ * @return    A valid @c SPINLOCK_HANDLE when successful or @c NULL otherwise.
+ */
+MOCKABLE_FUNCTION(, SPINLOCK_HANDLE, SpinLock_Init);
+
+/**
+ * @brief    Acquires the spin lock. Not recursive.
+ *
+ * @param    handle    A valid handle to the spin lock.
+ *
+ * @return    Returns @c LOCK_OK when the lock has been acquired and
+ *             @c LOCK_ERROR when an error occurs.
+ */
+MOCKABLE_FUNCTION(, LOCK_RESULT, SpinLock_Lock, SPINLOCK_HANDLE, handle);
+
+/**
+ * @brief    Releases the spin lock.
+ *
+ * @param    handle    A valid handle to the spin lock.
+ *
+ * @return    Returns @c LOCK_OK when the lock has been released and
+ *             @c LOCK_ERROR when an error occurs.
+ */
+MOCKABLE_FUNCTION(, LOCK_RESULT, SpinLock_Unlock, SPINLOCK_HANDLE, handle);
+
+/**
+ * @brief    The spin lock instance is destroyed.
+ *
+ * @param    handle    A valid handle to the spin lock.
+ *
+ * @return    Returns @c LOCK_OK when the lock object has been
+ *             destroyed and @c LOCK_ERROR when an error occurs.
+ */
+MOCKABLE_FUNCTION(, LOCK_RESULT, SpinLock_Deinit, SPINLOCK_HANDLE, handle);
+
 #ifdef __cplusplus
 }
 #endif
@@ -11,6 +11,7 @@
 
 #include "azure_c_shared_utility/macro_utils.h"
 #include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/buffer_.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
 
@@ -55,6 +56,24 @@ typedef int (*MAP_FILTER_CALLBACK)(const char* mapProperty, const char* mapValue
  */
 MOCKABLE_FUNCTION(, MAP_HANDLE, Map_Create, MAP_FILTER_CALLBACK, mapFilterFunc);
 
+/**
+ * @brief   Creates a new map holding the @p count pairs given by @p keys
+ *          and @p values, in that order.
+ *
+ *          All the keys and values are copied into one allocation and the
+ *          hash index is built once, instead of growing the map pair by
+ *          pair. The map has no filter function. Changing the map later
+ *          copies the pairs out of that allocation first.
+ *
+ * @param   keys    An array of @p count keys, all different.
+ * @param   values  An array of @p count values.
+ * @param   count   The number of pairs, 0 giving an empty map.
+ *
+ * @return  A valid @c MAP_HANDLE or @c NULL if any key or value is @c NULL,
+ *          a key is repeated or an error occurs.
+ */
+MOCKABLE_FUNCTION(, MAP_HANDLE, Map_CreateFromArrays, const char* const*, keys, const char* const*, values, size_t, count);
+
 /**
  * @brief   Release all resources associated with the map.
  *
@@ -66,6 +85,9 @@ MOCKABLE_FUNCTION(, void, Map_Destroy, MAP_HANDLE, handle);
  * @brief   Creates a copy of the map indicated by @p handle and returns a
  *          handle to it.
  *
+ *          The copy shares the pairs of the map until either of them
+ *          changes them, so cloning does not depend on the number of pairs.
+ *
  * @param   handle  The handle to an existing map.
  *
  * @return  A valid @c MAP_HANDLE to the cloned copy of the map or @c NULL
@@ -195,6 +217,20 @@ MOCKABLE_FUNCTION(, MAP_RESULT, Map_GetInternals, MAP_HANDLE, handle, const char
 /*this API creates a JSON object from the content of the map*/
 MOCKABLE_FUNCTION(, STRING_HANDLE, Map_ToJSON, MAP_HANDLE, handle);
 
+/**
+ * @brief   Appends the JSON object that ::Map_ToJSON produces to @p destination,
+ *          without a terminating '\0'. The length of the JSON is computed
+ *          first, so that @p destination grows once.
+ *
+ * @param   handle      The handle to an existing map.
+ * @param   destination The buffer the JSON is appended to.
+ *
+ * @return  Returns @c MAP_OK if the JSON was appended, @c MAP_INVALIDARG if
+ *          any of the parameters are @c NULL or @c MAP_ERROR otherwise, in
+ *          which case @p destination is left unchanged.
+ */
+MOCKABLE_FUNCTION(, MAP_RESULT, Map_ToJSONBuffer, MAP_HANDLE, handle, BUFFER_HANDLE, destination);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,62 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef MEMIO_H
+#define MEMIO_H
+
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+extern "C" {
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif /* __cplusplus */
+
+/* A pair of IOs connected to each other in memory, to run a TLS or WebSocket layer (and its peer) over a connection
+   of known latency, bandwidth and chunking, without the noise of the sockets of the kernel. It is meant for
+   benchmarks, tests and fuzzing.
+
+   The pair is created first, then one IO for each of its two sides by passing a MEMIO_CONFIG to xio_create. The
+   bytes sent on a side are copied, and leave it at the bandwidth of the link: the send completes in the dowork of
+   that side once they have left. They are indicated to the other side in its dowork latency_us later, in chunks of
+   at most max_chunk_size bytes, never merging two sends. Bytes sent before the other side is open wait for it.
+
+   Closing a side cancels its sends that did not leave and drops the bytes that wait for it; the other side then
+   gets an IO error once it received the bytes already sent to it, as for a connection reset. The IOs of a pair are
+   not thread safe, both are usually worked by the same thread. */
+typedef struct MEMIO_PAIR_TAG* MEMIO_PAIR_HANDLE;
+
+typedef struct MEMIO_LINK_CONFIG_TAG
+{
+    /* how long the bytes take to reach the other side once they left */
+    uint32_t latency_us;
+    /* how fast the bytes leave, 0 for at once */
+    uint64_t bytes_per_second;
+    /* the largest number of bytes indicated at a time, 0 to indicate each send in one piece */
+    size_t max_chunk_size;
+    /* when not 0, each chunk takes between 1 and max_chunk_size bytes, drawn from a generator seeded with it */
+    uint32_t chunk_seed;
+} MEMIO_LINK_CONFIG;
+
+typedef struct MEMIO_CONFIG_TAG
+{
+    MEMIO_PAIR_HANDLE pair;
+    /* 0 or 1, each side may have one IO at a time */
+    int side;
+} MEMIO_CONFIG;
+
+/* link_0_to_1 and link_1_to_0 may be NULL for a link without latency, bandwidth limit or chunking */
+MOCKABLE_FUNCTION(, MEMIO_PAIR_HANDLE, memio_pair_create, const MEMIO_LINK_CONFIG*, link_0_to_1, const MEMIO_LINK_CONFIG*, link_1_to_0);
+/* the IOs of both sides are to be destroyed first */
+MOCKABLE_FUNCTION(, void, memio_pair_destroy, MEMIO_PAIR_HANDLE, pair);
+MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, memio_get_interface_description);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* MEMIO_H */
@@ -4,13 +4,127 @@
 #ifndef MEMORY_DATA_H
 #define MEMORY_DATA_H
 
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#endif
+
 #include "azure_c_shared_utility/uuid.h"
 #include "umock_c_prod.h"
 
 #ifdef __cplusplus
-#include <cstdint>
 extern "C" {
-#include <stdint.h>
+#endif
+
+/* The memory_data_read_ and memory_data_write_ functions below are the inline forms of the
+   read_ and write_ functions, for encoders converting one field after the other: a load, or a
+   store, and a byte swap where the host is little endian. They are not mockable, code under
+   test that needs to see the calls uses the out of line functions. */
+#if defined(_MSC_VER)
+#include <stdlib.h>
+#define MEMORY_DATA_INLINE static __inline
+/* all the targets of MSVC are little endian */
+#define MEMORY_DATA_SWAP16(x) _byteswap_ushort(x)
+#define MEMORY_DATA_SWAP32(x) _byteswap_ulong(x)
+#define MEMORY_DATA_SWAP64(x) _byteswap_uint64(x)
+#else
+#define MEMORY_DATA_INLINE static inline
+#if defined(__GNUC__) && defined(__BYTE_ORDER__)
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+#define MEMORY_DATA_SWAP16(x) __builtin_bswap16(x)
+#define MEMORY_DATA_SWAP32(x) __builtin_bswap32(x)
+#define MEMORY_DATA_SWAP64(x) __builtin_bswap64(x)
+#elif __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define MEMORY_DATA_SWAP16(x) (x)
+#define MEMORY_DATA_SWAP32(x) (x)
+#define MEMORY_DATA_SWAP64(x) (x)
+#endif
+#endif
+#endif
+
+#if defined(MEMORY_DATA_SWAP16)
+
+MEMORY_DATA_INLINE uint16_t memory_data_read_uint16(const unsigned char* source)
+{
+    uint16_t value;
+    (void)memcpy(&value, source, sizeof(value));
+    return MEMORY_DATA_SWAP16(value);
+}
+
+MEMORY_DATA_INLINE uint32_t memory_data_read_uint32(const unsigned char* source)
+{
+    uint32_t value;
+    (void)memcpy(&value, source, sizeof(value));
+    return MEMORY_DATA_SWAP32(value);
+}
+
+MEMORY_DATA_INLINE uint64_t memory_data_read_uint64(const unsigned char* source)
+{
+    uint64_t value;
+    (void)memcpy(&value, source, sizeof(value));
+    return MEMORY_DATA_SWAP64(value);
+}
+
+MEMORY_DATA_INLINE void memory_data_write_uint16(unsigned char* destination, uint16_t value)
+{
+    value = MEMORY_DATA_SWAP16(value);
+    (void)memcpy(destination, &value, sizeof(value));
+}
+
+MEMORY_DATA_INLINE void memory_data_write_uint32(unsigned char* destination, uint32_t value)
+{
+    value = MEMORY_DATA_SWAP32(value);
+    (void)memcpy(destination, &value, sizeof(value));
+}
+
+MEMORY_DATA_INLINE void memory_data_write_uint64(unsigned char* destination, uint64_t value)
+{
+    value = MEMORY_DATA_SWAP64(value);
+    (void)memcpy(destination, &value, sizeof(value));
+}
+
+#else /* byte order unknown at compile time */
+
+MEMORY_DATA_INLINE uint16_t memory_data_read_uint16(const unsigned char* source)
+{
+    return (uint16_t)(((uint16_t)source[0] << 8) | source[1]);
+}
+
+MEMORY_DATA_INLINE uint32_t memory_data_read_uint32(const unsigned char* source)
+{
+    return ((uint32_t)source[0] << 24) | ((uint32_t)source[1] << 16) | ((uint32_t)source[2] << 8) | (uint32_t)source[3];
+}
+
+MEMORY_DATA_INLINE uint64_t memory_data_read_uint64(const unsigned char* source)
+{
+    return ((uint64_t)memory_data_read_uint32(source) << 32) | memory_data_read_uint32(source + 4);
+}
+
+MEMORY_DATA_INLINE void memory_data_write_uint16(unsigned char* destination, uint16_t value)
+{
+    destination[0] = (unsigned char)(value >> 8);
+    destination[1] = (unsigned char)value;
+}
+
+MEMORY_DATA_INLINE void memory_data_write_uint32(unsigned char* destination, uint32_t value)
+{
+    destination[0] = (unsigned char)(value >> 24);
+    destination[1] = (unsigned char)(value >> 16);
+    destination[2] = (unsigned char)(value >> 8);
+    destination[3] = (unsigned char)value;
+}
+
+MEMORY_DATA_INLINE void memory_data_write_uint64(unsigned char* destination, uint64_t value)
+{
+    memory_data_write_uint32(destination, (uint32_t)(value >> 32));
+    memory_data_write_uint32(destination + 4, (uint32_t)value);
+}
+
 #endif
 
     MOCKABLE_FUNCTION(, void, read_uint8_t,  const unsigned char*, source, uint8_t*, destination);
@@ -37,6 +151,15 @@ extern "C" {
 
     MOCKABLE_FUNCTION(, void, write_uuid_t, unsigned char*, destination, const UUID_T, value);
 
+    /* count values at a time, MSB first in memory; source and destination must not overlap */
+    MOCKABLE_FUNCTION(, void, read_uint16_array, const unsigned char*, source, uint16_t*, destination, size_t, count);
+    MOCKABLE_FUNCTION(, void, read_uint32_array, const unsigned char*, source, uint32_t*, destination, size_t, count);
+    MOCKABLE_FUNCTION(, void, read_uint64_array, const unsigned char*, source, uint64_t*, destination, size_t, count);
+
+    MOCKABLE_FUNCTION(, void, write_uint16_array, unsigned char*, destination, const uint16_t*, source, size_t, count);
+    MOCKABLE_FUNCTION(, void, write_uint32_array, unsigned char*, destination, const uint32_t*, source, size_t, count);
+    MOCKABLE_FUNCTION(, void, write_uint64_array, unsigned char*, destination, const uint64_t*, source, size_t, count);
+
 #ifdef __cplusplus
 }
 #endif
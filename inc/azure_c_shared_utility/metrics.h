@@ -0,0 +1,158 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file metrics.h
+ *    @brief     One snapshot of the counters of the whole library, and its formatting as
+ *               Prometheus text or JSON for a scraper.
+ *
+ *    @details ::metrics_snapshot_create collects into one flat ::METRICS_SNAPSHOT the gballoc
+ *             statistics (when built with @c GB_DEBUG_ALLOC), the lock profiles summed over all
+ *             the locks (when built with @c LOCK_PROFILING), the ::XIO_STATS of each layer of the
+ *             IO stacks added with ::metrics_add_xio and the counters created with
+ *             ::metrics_counter_create. ::metrics_snapshot_format then writes it out, so that a
+ *             module only has to keep its counters.
+ *
+ *             A counter is made of METRICS_COUNTER_SLOT_COUNT slots, each on its own cache line.
+ *             A thread always adds to the same slot, picked the first time it adds to a counter,
+ *             so that threads do not write to the same line unless there are more of them than
+ *             slots, and the snapshot sums the slots.
+ *
+ *             The counters of the IO stacks are read with ::xio_get_stats from the thread taking
+ *             the snapshot: an IO stack is to be removed with ::metrics_remove_xio before it is
+ *             destroyed, and the counters of a stack worked by another thread may be a few
+ *             operations behind.
+ */
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#include "azure_c_shared_utility/macro_utils.h"
+#include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define METRICS_COUNTER_SLOT_COUNT 16
+#define METRICS_CACHE_LINE_SIZE 64
+/* the layers of an IO stack read by a snapshot, the layers below are left out */
+#define METRICS_MAX_XIO_LAYERS 8
+
+#define METRICS_FORMAT_VALUES \
+    METRICS_FORMAT_PROMETHEUS, \
+    METRICS_FORMAT_JSON
+
+DEFINE_ENUM(METRICS_FORMAT, METRICS_FORMAT_VALUES);
+
+typedef struct METRICS_COUNTER_TAG* METRICS_COUNTER_HANDLE;
+
+typedef struct METRICS_COUNTER_VALUE_TAG
+{
+    const char* name;
+    uint64_t value;
+} METRICS_COUNTER_VALUE;
+
+typedef struct METRICS_XIO_LAYER_TAG
+{
+    /* the name given to metrics_add_xio, shared by all the layers of the stack */
+    const char* io_name;
+    XIO_STATS stats;
+} METRICS_XIO_LAYER;
+
+typedef struct METRICS_SNAPSHOT_TAG
+{
+    /* gballoc, has_memory is false when the library does not measure its memory */
+    bool has_memory;
+    size_t memory_current_bytes;
+    size_t memory_max_bytes;
+    size_t allocation_count;
+    size_t realloc_count;
+    size_t realloc_moved_count;
+    size_t realloc_moved_bytes;
+    /* the lock profiles summed over the locks alive and deinitialized, has_locks is false without LOCK_PROFILING */
+    bool has_locks;
+    size_t lock_count;
+    uint64_t lock_acquisition_count;
+    uint64_t lock_contended_count;
+    uint64_t lock_total_wait_ns;
+    uint64_t lock_max_wait_ns;
+    /* the layers of the IO stacks, top layer first for each stack */
+    METRICS_XIO_LAYER* xio_layers;
+    size_t xio_layer_count;
+    METRICS_COUNTER_VALUE* counters;
+    size_t counter_count;
+} METRICS_SNAPSHOT;
+
+/**
+ * @brief    Creates the registry of the counters and the IO stacks.
+ *
+ * @return    0 on success, a non-zero value otherwise (including when already initialized).
+ */
+MOCKABLE_FUNCTION(, int, metrics_init);
+
+/**
+ * @brief    Frees the registry. The counters are to be destroyed and the IO stacks removed first.
+ */
+MOCKABLE_FUNCTION(, void, metrics_deinit);
+
+/**
+ * @brief    Creates a counter reported under @p name (copied), starting at 0.
+ *
+ * @return    The counter, or @c NULL if the registry is not initialized or on failure.
+ */
+MOCKABLE_FUNCTION(, METRICS_COUNTER_HANDLE, metrics_counter_create, const char*, name);
+
+MOCKABLE_FUNCTION(, void, metrics_counter_destroy, METRICS_COUNTER_HANDLE, counter);
+
+/**
+ * @brief    Adds @p value to the slot of the calling thread, with one atomic add and no lock.
+ */
+MOCKABLE_FUNCTION(, void, metrics_counter_add, METRICS_COUNTER_HANDLE, counter, uint64_t, value);
+
+/**
+ * @brief    Sums the slots of @p counter.
+ */
+MOCKABLE_FUNCTION(, uint64_t, metrics_counter_get, METRICS_COUNTER_HANDLE, counter);
+
+/**
+ * @brief    Adds the layers of the IO stack @p xio to the snapshots, reported under @p name (copied).
+ *
+ * @return    0 on success, a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, metrics_add_xio, XIO_HANDLE, xio, const char*, name);
+
+MOCKABLE_FUNCTION(, void, metrics_remove_xio, XIO_HANDLE, xio);
+
+/**
+ * @brief    Collects all the counters. An IO stack whose counters cannot be read is left out.
+ *
+ * @return    The snapshot, to free with ::metrics_snapshot_destroy, or @c NULL on failure.
+ */
+MOCKABLE_FUNCTION(, METRICS_SNAPSHOT*, metrics_snapshot_create);
+
+MOCKABLE_FUNCTION(, void, metrics_snapshot_destroy, METRICS_SNAPSHOT*, snapshot);
+
+/**
+ * @brief    Writes @p snapshot out in the Prometheus text exposition format, with the metric names
+ *             prefixed by aziotsharedutil_, or as one JSON object.
+ *
+ * @return    The text, or @c NULL on failure.
+ */
+MOCKABLE_FUNCTION(, STRING_HANDLE, metrics_snapshot_format, const METRICS_SNAPSHOT*, snapshot, METRICS_FORMAT, format);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* METRICS_H */
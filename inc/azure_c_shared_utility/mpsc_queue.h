@@ -0,0 +1,81 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file mpsc_queue.h
+ *    @brief     Lock free multi-producer/single-consumer FIFO queue of intrusive entries.
+ *
+ *    @details Like ::DLIST_ENTRY, an ::MPSC_QUEUE_ENTRY is embedded in the caller's
+ *             structure and the structure is recovered with @c containingRecord. The queue
+ *             never allocates and never copies.
+ *
+ *             Any number of threads may call ::mpsc_queue_push at the same time. A push is
+ *             one atomic exchange and one store, it never waits for another thread.
+ *             ::mpsc_queue_pop and ::mpsc_queue_is_empty may only be called by one thread
+ *             at a time, the consumer.
+ *
+ *             An entry belongs to the queue from the moment it is pushed until it is
+ *             returned by ::mpsc_queue_pop, and may be pushed again after that.
+ *
+ *             See mpsc_wait_queue.h for a variant whose consumer can block until an entry
+ *             is pushed.
+ */
+
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct MPSC_QUEUE_ENTRY_TAG
+{
+    struct MPSC_QUEUE_ENTRY_TAG* volatile next;
+} MPSC_QUEUE_ENTRY, *PMPSC_QUEUE_ENTRY;
+
+typedef struct MPSC_QUEUE_TAG
+{
+    /* the last pushed entry, swapped by the producers */
+    MPSC_QUEUE_ENTRY* volatile head;
+    /* the next entry to pop, only touched by the consumer */
+    MPSC_QUEUE_ENTRY* tail;
+    /* keeps the queue non-empty, so that push never has to update tail */
+    MPSC_QUEUE_ENTRY stub;
+} MPSC_QUEUE;
+
+/**
+ * @brief    Initializes @p queue as an empty queue. Must be called before any other
+ *             function and while no other thread uses the queue.
+ */
+MOCKABLE_FUNCTION(, void, mpsc_queue_init, MPSC_QUEUE*, queue);
+
+/**
+ * @brief    Adds @p entry at the end of @p queue. May be called from any thread.
+ *
+ * @return    0 on success, a non-zero value if @p queue or @p entry is @c NULL.
+ */
+MOCKABLE_FUNCTION(, int, mpsc_queue_push, MPSC_QUEUE*, queue, MPSC_QUEUE_ENTRY*, entry);
+
+/**
+ * @brief    Removes the entry at the front of @p queue. Consumer only.
+ *
+ * @return    The entry, or @c NULL if the queue is empty. @c NULL is also returned while
+ *             the first pending push has swapped the head but not yet linked its entry;
+ *             ::mpsc_queue_is_empty tells the two cases apart.
+ */
+MOCKABLE_FUNCTION(, MPSC_QUEUE_ENTRY*, mpsc_queue_pop, MPSC_QUEUE*, queue);
+
+/**
+ * @brief    Tells whether @p queue holds no entries, counting an entry whose push has
+ *             started but not finished. Consumer only.
+ *
+ * @return    A non-zero value if the queue is empty (or @p queue is @c NULL), 0 otherwise.
+ */
+MOCKABLE_FUNCTION(, int, mpsc_queue_is_empty, MPSC_QUEUE*, queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MPSC_QUEUE_H */
@@ -0,0 +1,80 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file mpsc_wait_queue.h
+ *    @brief     ::MPSC_QUEUE whose consumer can block until an entry is pushed.
+ *
+ *    @details Producers push without taking any lock as long as the consumer is not
+ *             waiting. Only when it is waiting does a push take the lock to post the
+ *             condition the consumer waits on, so a busy consumer costs the producers
+ *             nothing more than the lock free push.
+ *
+ *             ::mpsc_wait_queue_push and ::mpsc_wait_queue_wake may be called from any
+ *             thread, the other functions only by the consumer.
+ */
+
+#ifndef MPSC_WAIT_QUEUE_H
+#define MPSC_WAIT_QUEUE_H
+
+#include "azure_c_shared_utility/mpsc_queue.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct MPSC_WAIT_QUEUE_TAG* MPSC_WAIT_QUEUE_HANDLE;
+
+/**
+ * @brief    Creates an empty queue.
+ *
+ * @return    A valid @c MPSC_WAIT_QUEUE_HANDLE when successful or @c NULL otherwise.
+ */
+MOCKABLE_FUNCTION(, MPSC_WAIT_QUEUE_HANDLE, mpsc_wait_queue_create);
+
+/**
+ * @brief    Destroys the queue. Entries still in the queue are not touched, they
+ *             belong to the caller again.
+ */
+MOCKABLE_FUNCTION(, void, mpsc_wait_queue_destroy, MPSC_WAIT_QUEUE_HANDLE, mpsc_wait_queue);
+
+/**
+ * @brief    Adds @p entry at the end of the queue and wakes the consumer if it is
+ *             waiting. May be called from any thread.
+ *
+ * @return    0 on success, a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, mpsc_wait_queue_push, MPSC_WAIT_QUEUE_HANDLE, mpsc_wait_queue, MPSC_QUEUE_ENTRY*, entry);
+
+/**
+ * @brief    Removes the entry at the front of the queue without waiting.
+ *
+ * @return    The entry, or @c NULL if there is none.
+ */
+MOCKABLE_FUNCTION(, MPSC_QUEUE_ENTRY*, mpsc_wait_queue_try_pop, MPSC_WAIT_QUEUE_HANDLE, mpsc_wait_queue);
+
+/**
+ * @brief    Removes the entry at the front of the queue, waiting for one to be pushed
+ *             if the queue is empty.
+ *
+ * @param    timeout_milliseconds    How long to wait at most, 0 waits until an entry is
+ *                                   pushed or ::mpsc_wait_queue_wake is called.
+ *
+ * @return    The entry, or @c NULL on timeout, when woken by ::mpsc_wait_queue_wake, on
+ *             a spurious wakeup of the condition or on error.
+ */
+MOCKABLE_FUNCTION(, MPSC_QUEUE_ENTRY*, mpsc_wait_queue_pop, MPSC_WAIT_QUEUE_HANDLE, mpsc_wait_queue, int, timeout_milliseconds);
+
+/**
+ * @brief    Wakes the consumer if it is waiting in ::mpsc_wait_queue_pop, without pushing
+ *             an entry (for example to have it notice that it should stop).
+ *
+ * @return    0 on success, a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, mpsc_wait_queue_wake, MPSC_WAIT_QUEUE_HANDLE, mpsc_wait_queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MPSC_WAIT_QUEUE_H */
@@ -0,0 +1,202 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file object_pool.h
+ *    @brief     Freelists of fixed size blocks, used to recycle small control blocks
+ *             (STRING, BUFFER, list items) instead of going to the heap each time.
+ *
+ *    @details A pool is a statically initialized ::OBJECT_POOL, usually defined at
+ *             file scope with ::OBJECT_POOL_DEFINE. Freed blocks are kept on the pool's
+ *             freelist, up to ::OBJECT_POOL_MAX_CACHED of them, and handed out again by
+ *             ::object_pool_alloc.
+ *
+ *             By default a pool is shared by all threads and is guarded by a spin lock.
+ *             When @c OBJECT_POOL_THREAD_LOCAL is defined each thread gets its own pool
+ *             and no lock is taken. A block may still be freed on a thread other than
+ *             the one that allocated it, it then simply joins the freeing thread's
+ *             freelist. The blocks cached by a thread are not released when the thread
+ *             exits unless it calls ::object_pool_trim.
+ *
+ *             The blocks are taken from the C heap directly rather than through gballoc,
+ *             since a cached block outlives the allocation that produced it and so must
+ *             never come from a gballoc arena scope.
+ *
+ *             When @c OBJECT_POOL_STATIC is defined, the pools defined with
+ *             ::OBJECT_POOL_DEFINE_STATIC take their blocks from a static array sized at
+ *             compile time and never from the heap: ::object_pool_alloc fails once all the
+ *             blocks are in use, and freed blocks always go back to the freelist. The
+ *             payload functions (::object_pool_payload_alloc and co.) hand out variable size
+ *             memory from static pools of size classes of 32 to 4096 bytes, for the values
+ *             of STRING and BUFFER. These pools keep usage statistics and high-water marks,
+ *             which ::object_pool_report logs. The static pools are shared by all threads,
+ *             @c OBJECT_POOL_THREAD_LOCAL cannot be combined with @c OBJECT_POOL_STATIC.
+ */
+
+#ifndef OBJECT_POOL_H
+#define OBJECT_POOL_H
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+extern "C" {
+#else
+#include <stddef.h>
+#endif
+
+#ifndef OBJECT_POOL_MAX_CACHED
+#define OBJECT_POOL_MAX_CACHED 64
+#endif
+
+#if defined(OBJECT_POOL_STATIC) && defined(OBJECT_POOL_THREAD_LOCAL)
+#error "OBJECT_POOL_STATIC pools are shared by all threads, OBJECT_POOL_THREAD_LOCAL cannot be defined with it"
+#endif
+
+#if defined(OBJECT_POOL_THREAD_LOCAL)
+#if defined(_MSC_VER)
+#define OBJECT_POOL_STORAGE __declspec(thread)
+#else
+#define OBJECT_POOL_STORAGE __thread
+#endif
+#else
+#define OBJECT_POOL_STORAGE
+#endif
+
+/* the static storage of a pool is an array of these, so that its blocks are suitably aligned */
+typedef union OBJECT_POOL_ALIGNMENT_TAG
+{
+    void* pointer;
+    long long integer;
+    double floating;
+} OBJECT_POOL_ALIGNMENT;
+
+/* size of the blocks of a static pool: the object size rounded up to the alignment, and at least a pointer */
+#define OBJECT_POOL_BLOCK_SIZE(object_size) \
+    (((((object_size) < sizeof(void*)) ? sizeof(void*) : (object_size)) + sizeof(OBJECT_POOL_ALIGNMENT) - 1) / sizeof(OBJECT_POOL_ALIGNMENT) * sizeof(OBJECT_POOL_ALIGNMENT))
+
+typedef struct OBJECT_POOL_TAG
+{
+    size_t object_size;
+    void* free_list;
+    size_t cached_count;
+    volatile long lock;
+#if defined(OBJECT_POOL_STATIC)
+    const char* name;
+    /* NULL for a pool that takes its blocks from the heap */
+    unsigned char* storage;
+    size_t block_size;
+    size_t capacity;
+    /* blocks of storage handed out at least once, the others are not on the freelist yet */
+    size_t carved_count;
+    size_t in_use_count;
+    size_t high_water_mark;
+    size_t failed_count;
+    /* the pools that were used at least once, for object_pool_report */
+    struct OBJECT_POOL_TAG* volatile next_registered;
+    volatile long registered;
+#endif
+} OBJECT_POOL;
+
+#if defined(OBJECT_POOL_STATIC)
+#define OBJECT_POOL_INITIALIZER(object_size) { (object_size), NULL, 0, 0, NULL, NULL, 0, 0, 0, 0, 0, 0, NULL, 0 }
+#define OBJECT_POOL_STATIC_INITIALIZER(name, object_size, storage, count) \
+    { (object_size), NULL, 0, 0, (name), (unsigned char*)(storage), OBJECT_POOL_BLOCK_SIZE(object_size), (count), 0, 0, 0, 0, NULL, 0 }
+#else
+#define OBJECT_POOL_INITIALIZER(object_size) { (object_size), NULL, 0, 0 }
+#endif
+
+/** @brief    Defines a file scope pool @p name of blocks of @p object_size bytes. */
+#define OBJECT_POOL_DEFINE(name, object_size) \
+    static OBJECT_POOL_STORAGE OBJECT_POOL name = OBJECT_POOL_INITIALIZER(object_size)
+
+/**
+ * @brief    Defines a file scope pool @p name of blocks of @p object_size bytes which,
+ *             when @c OBJECT_POOL_STATIC is defined, holds @p count blocks in static storage
+ *             and never allocates. Otherwise it is the same as ::OBJECT_POOL_DEFINE.
+ */
+#if defined(OBJECT_POOL_STATIC)
+#define OBJECT_POOL_DEFINE_STATIC(name, object_size, count) \
+    static OBJECT_POOL_ALIGNMENT name##_storage[(OBJECT_POOL_BLOCK_SIZE(object_size) / sizeof(OBJECT_POOL_ALIGNMENT)) * (count)]; \
+    static OBJECT_POOL name = OBJECT_POOL_STATIC_INITIALIZER(#name, object_size, name##_storage, count)
+#else
+#define OBJECT_POOL_DEFINE_STATIC(name, object_size, count) \
+    OBJECT_POOL_DEFINE(name, object_size)
+#endif
+
+typedef struct OBJECT_POOL_STATISTICS_TAG
+{
+    size_t object_size;
+    /* number of blocks of static storage, 0 for a pool that takes its blocks from the heap */
+    size_t capacity;
+    size_t in_use_count;
+    size_t high_water_mark;
+    /* allocations that failed because all the blocks of static storage were in use */
+    size_t failed_count;
+} OBJECT_POOL_STATISTICS;
+
+/**
+ * @brief    Returns a block of the pool's object size, recycled from the freelist when
+ *             one is available.
+ *
+ * @return    The block or @c NULL if @p pool is @c NULL or the allocation fails.
+ */
+MOCKABLE_FUNCTION(, void*, object_pool_alloc, OBJECT_POOL*, pool);
+
+/**
+ * @brief    Gives @p object, obtained from ::object_pool_alloc on the same pool, back to
+ *             the pool. The block is released to the heap when the freelist is full.
+ */
+MOCKABLE_FUNCTION(, void, object_pool_free, OBJECT_POOL*, pool, void*, object);
+
+/**
+ * @brief    Releases all the blocks cached by the pool (by the calling thread's pool
+ *             when @c OBJECT_POOL_THREAD_LOCAL is defined). The blocks of static storage
+ *             are kept.
+ */
+MOCKABLE_FUNCTION(, void, object_pool_trim, OBJECT_POOL*, pool);
+
+/**
+ * @brief    Gets the usage of @p pool. Only kept when @c OBJECT_POOL_STATIC is defined.
+ *
+ * @return    0 on success, a non-zero value if an argument is @c NULL or the statistics
+ *             are not kept.
+ */
+MOCKABLE_FUNCTION(, int, object_pool_get_statistics, OBJECT_POOL*, pool, OBJECT_POOL_STATISTICS*, statistics);
+
+/**
+ * @brief    Logs with LogInfo one line per pool used so far, with its capacity, the number
+ *             of blocks in use, the high-water mark and the failed allocations, to size the
+ *             pools of a @c OBJECT_POOL_STATIC build. Logs nothing otherwise.
+ */
+MOCKABLE_FUNCTION(, void, object_pool_report);
+
+/**
+ * @brief    Returns memory for at least @p size bytes from the smallest payload size class that
+ *             can hold them and has a free block. Only available when @c OBJECT_POOL_STATIC is
+ *             defined.
+ *
+ * @return    The memory, or @c NULL if @p size is 0 or larger than the largest class, or if no
+ *             class that can hold it has a free block.
+ */
+MOCKABLE_FUNCTION(, void*, object_pool_payload_alloc, size_t, size);
+
+/**
+ * @brief    Same contract as realloc, for memory obtained from ::object_pool_payload_alloc.
+ *             The memory stays where it is while @p size fits its block.
+ */
+MOCKABLE_FUNCTION(, void*, object_pool_payload_realloc, void*, ptr, size_t, size);
+
+/** @brief    Gives back memory obtained from ::object_pool_payload_alloc. */
+MOCKABLE_FUNCTION(, void, object_pool_payload_free, void*, ptr);
+
+/**
+ * @brief    Tells whether @p ptr was obtained from ::object_pool_payload_alloc, for the owners
+ *             of memory that may also come from the heap.
+ */
+MOCKABLE_FUNCTION(, int, object_pool_is_payload, const void*, ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* OBJECT_POOL_H */
@@ -5,6 +5,7 @@
 #define OPTIONHANDLER_H
 
 #include "azure_c_shared_utility/macro_utils.h"
+#include "azure_c_shared_utility/constbuffer.h"
 
 #define OPTIONHANDLER_RESULT_VALUES \
 OPTIONHANDLER_OK, \
@@ -35,9 +36,25 @@ typedef void (*pfDestroyOption)(const char* name, const void* value);
 /*returns 0 if _SetOption succeeded, any other value is error, if the option is not intended for that module, returns 0*/
 typedef int (*pfSetOption)(void* handle, const char* name, const void* value);
 
+/*the key of an option that is fed by name*/
+#define OPTIONHANDLER_NO_KEY (-1)
+
+/*the following function pointer points to a function that maps an option name to a module defined key*/
+/*returns a non-negative key, or a negative value if the option is to be fed by name through pfSetOption*/
+/*optional, called once per option when it is added so that feeding options does not compare names*/
+typedef int (*pfGetOptionKey)(const char* name);
+
+/*the following function pointer points to a function that sets an option for a module, selected by the key returned by pfGetOptionKey*/
+/*name is the name the option was added with; same return values as pfSetOption*/
+typedef int (*pfSetOptionByKey)(void* handle, int key, const char* name, const void* value);
+
 MOCKABLE_FUNCTION(, OPTIONHANDLER_HANDLE, OptionHandler_Create, pfCloneOption, cloneOption, pfDestroyOption, destroyOption, pfSetOption, setOption);
+MOCKABLE_FUNCTION(, OPTIONHANDLER_HANDLE, OptionHandler_CreateWithKeys, pfCloneOption, cloneOption, pfDestroyOption, destroyOption, pfSetOption, setOption, pfGetOptionKey, getOptionKey, pfSetOptionByKey, setOptionByKey);
 MOCKABLE_FUNCTION(, OPTIONHANDLER_HANDLE, OptionHandler_Clone, OPTIONHANDLER_HANDLE, handler);
 MOCKABLE_FUNCTION(, OPTIONHANDLER_RESULT, OptionHandler_AddOption, OPTIONHANDLER_HANDLE, handle, const char*, name, const void*, value);
+/*adds an option whose value is the content of value, such as a NUL terminated string, without cloning it: the handler and its clones share a reference*/
+/*on value and feed its content to pfSetOption/pfSetOptionByKey; pfCloneOption and pfDestroyOption are not called for it*/
+MOCKABLE_FUNCTION(, OPTIONHANDLER_RESULT, OptionHandler_AddSharedOption, OPTIONHANDLER_HANDLE, handle, const char*, name, CONSTBUFFER_HANDLE, value);
 MOCKABLE_FUNCTION(, OPTIONHANDLER_RESULT, OptionHandler_FeedOptions, OPTIONHANDLER_HANDLE, handle, void*, destinationHandle);
 MOCKABLE_FUNCTION(, void, OptionHandler_Destroy, OPTIONHANDLER_HANDLE, handle);
 
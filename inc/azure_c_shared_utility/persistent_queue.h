@@ -0,0 +1,105 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file persistent_queue.h
+ *    @brief     A store-and-forward queue of messages kept in a memory mapped file.
+ *
+ *    @details The messages waiting for a connection go to a ring of records in a file of a fixed
+ *             size instead of the heap, so that a device that stays offline uses a bounded amount
+ *             of memory and finds its messages again after a restart. Each record holds a
+ *             sequence number and a CRC-32, and opening the file again keeps the records that
+ *             follow the oldest one without a gap, stopping at the first torn or stale record.
+ *
+ *             ::persistent_queue_send hands the oldest messages to an IO with ::xio_sendv,
+ *             straight from the mapping, and removes them from the file once the send completed,
+ *             so a message may be sent again after a failure or a restart but is never lost.
+ *
+ *             The stores reach the file even if the process is killed; ::persistent_queue_flush
+ *             makes them survive a crash of the OS or a power loss as well. The queue is not
+ *             thread safe.
+ */
+
+#ifndef PERSISTENT_QUEUE_H
+#define PERSISTENT_QUEUE_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+#include "azure_c_shared_utility/constbuffer.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct PERSISTENT_QUEUE_TAG* PERSISTENT_QUEUE_HANDLE;
+
+/* the smallest file a queue accepts */
+#define PERSISTENT_QUEUE_MIN_CAPACITY 4096
+
+/**
+ * @brief    Opens the queue kept in @p file_path, creating the file with @p capacity bytes when
+ *             it does not exist and recovering the records it holds otherwise.
+ *
+ * @param    capacity    The size of the file, a multiple of 8 not smaller than
+ *                       ::PERSISTENT_QUEUE_MIN_CAPACITY. Each message takes 24 bytes more than
+ *                       its payload, rounded up to a multiple of 8.
+ *
+ * @return    A valid @c PERSISTENT_QUEUE_HANDLE when successful or @c NULL otherwise, in particular
+ *             when the file has another size or does not hold a queue.
+ */
+MOCKABLE_FUNCTION(, PERSISTENT_QUEUE_HANDLE, persistent_queue_create, const char*, file_path, size_t, capacity);
+
+/**
+ * @brief    Closes the file, which keeps the messages that were not sent. No send of the queue
+ *             may be in progress.
+ */
+MOCKABLE_FUNCTION(, void, persistent_queue_destroy, PERSISTENT_QUEUE_HANDLE, persistent_queue);
+
+/**
+ * @brief    Copies the content of @p payload at the end of the queue.
+ *
+ * @return    0 on success, a non-zero value otherwise, in particular when the queue has no room
+ *             left for it.
+ */
+MOCKABLE_FUNCTION(, int, persistent_queue_push, PERSISTENT_QUEUE_HANDLE, persistent_queue, CONSTBUFFER_HANDLE, payload);
+
+/**
+ * @brief    Sends up to @p max_message_count of the oldest messages with one call to ::xio_sendv,
+ *             back to back, pointing at their payloads in the mapping.
+ *
+ *             When the send completes with @c IO_SEND_OK the messages are removed from the queue,
+ *             otherwise they stay the oldest ones; @p on_send_complete is called after that. Only
+ *             one send may be in progress at a time, messages may be pushed meanwhile.
+ *
+ * @param    sent_message_count    Set to the number of messages sent, 0 when the queue is empty,
+ *                                 in which case @p on_send_complete is not called.
+ *
+ * @return    0 on success, a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, persistent_queue_send, PERSISTENT_QUEUE_HANDLE, persistent_queue, XIO_HANDLE, xio, size_t, max_message_count, size_t*, sent_message_count, ON_SEND_COMPLETE, on_send_complete, void*, on_send_complete_context);
+
+/**
+ * @brief    Gives the number of messages in the queue, including the ones being sent.
+ *
+ * @return    0 on success, a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, persistent_queue_get_count, PERSISTENT_QUEUE_HANDLE, persistent_queue, size_t*, message_count);
+
+/**
+ * @brief    Waits until all the stores made to the queue are on the disk.
+ *
+ * @return    0 on success, a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, persistent_queue_flush, PERSISTENT_QUEUE_HANDLE, persistent_queue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* PERSISTENT_QUEUE_H */
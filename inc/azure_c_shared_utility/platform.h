@@ -6,6 +6,7 @@
 
 #include "azure_c_shared_utility/strings.h"
 #include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/socket_reactor.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
 
 #ifdef __cplusplus
@@ -17,6 +18,11 @@ extern "C" {
     MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, platform_get_default_tlsio);
     MOCKABLE_FUNCTION(, STRING_HANDLE, platform_get_platform_info);
 
+    /* optional: platforms with a socket reactor run it on a pool of worker threads */
+    MOCKABLE_FUNCTION(, int, platform_start_socket_reactor, size_t, thread_count);
+    MOCKABLE_FUNCTION(, void, platform_stop_socket_reactor);
+    MOCKABLE_FUNCTION(, SOCKET_REACTOR_HANDLE, platform_get_socket_reactor);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
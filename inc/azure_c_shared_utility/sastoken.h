@@ -5,6 +5,7 @@
 #define SASTOKEN_H
 
 #include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/hmacsha256.h"
 #include <stdbool.h>
 #include "azure_c_shared_utility/umock_c_prod.h"
 
@@ -12,9 +13,24 @@
 extern "C" {
 #endif
 
+    /* one token of SASToken_CreateBatch: key, scope, keyName and expiry as for SASToken_CreateString, token receives the result */
+    typedef struct SAS_TOKEN_BATCH_ITEM_TAG
+    {
+        const char* key;
+        const char* scope;
+        const char* keyName;
+        size_t expiry;
+        STRING_HANDLE token;
+    } SAS_TOKEN_BATCH_ITEM;
+
     MOCKABLE_FUNCTION(, bool, SASToken_Validate, STRING_HANDLE, sasToken);
+    /* validates the sasTokenLength characters of sasToken in place, without allocating, as SASToken_Validate does */
+    MOCKABLE_FUNCTION(, bool, SASToken_ValidateString, const char*, sasToken, size_t, sasTokenLength);
     MOCKABLE_FUNCTION(, STRING_HANDLE, SASToken_Create, STRING_HANDLE, key, STRING_HANDLE, scope, STRING_HANDLE, keyName, size_t, expiry);
     MOCKABLE_FUNCTION(, STRING_HANDLE, SASToken_CreateString, const char*, key, const char*, scope, const char*, keyName, size_t, expiry);
+    MOCKABLE_FUNCTION(, HMACSHA256_KEY_CONTEXT_HANDLE, SASToken_CreateKeyContext, const char*, key);
+    MOCKABLE_FUNCTION(, STRING_HANDLE, SASToken_CreateStringWithKeyContext, HMACSHA256_KEY_CONTEXT_HANDLE, keyContext, const char*, scope, const char*, keyName, size_t, expiry);
+    MOCKABLE_FUNCTION(, int, SASToken_CreateBatch, SAS_TOKEN_BATCH_ITEM*, items, size_t, itemCount);
 
 #ifdef __cplusplus
 }
@@ -5,6 +5,10 @@
 /********************** See RFC 4634 for details *********************/
 #ifndef _SHA_PRIVATE__H
 #define _SHA_PRIVATE__H
+
+#include <stddef.h>
+#include <stdint.h>
+
 /*
 * These definitions are defined in FIPS-180-2, section 4.1.
 * Ch() and Maj() are defined identically in sections 4.1.1,
@@ -29,5 +33,72 @@
 
 #define SHA_Parity(x, y, z)  ((x) ^ (y) ^ (z))
 
+/*
+* Processes block_count consecutive 64 byte blocks into the
+* SHA-1 intermediate hash.
+*/
+typedef void(*SHA1_PROCESS_BLOCKS)(uint32_t Intermediate_Hash[5], const uint8_t *blocks, size_t block_count);
+
+/*
+* Returns the block function using the SHA instructions of the CPU
+* (SHA-NI on x86, the ARMv8 SHA1 instructions on AArch64), or NULL
+* when the CPU or the compiler does not have them. See sha1_hw.c.
+*/
+extern SHA1_PROCESS_BLOCKS SHA1GetHardwareProcessBlocks(void);
+
+/*
+* Processes block_count consecutive 64 byte blocks into the
+* SHA-224/SHA-256 intermediate hash.
+*/
+typedef void(*SHA224_256_PROCESS_BLOCKS)(uint32_t Intermediate_Hash[8], const uint8_t *blocks, size_t block_count);
+
+/*
+* Returns the block function using the SHA instructions of the CPU
+* (SHA-NI on x86, the ARMv8 SHA2 instructions on AArch64), or NULL
+* when the CPU or the compiler does not have them. See sha256_hw.c.
+*/
+extern SHA224_256_PROCESS_BLOCKS SHA224_256GetHardwareProcessBlocks(void);
+
+/*
+* Number of independent SHA-224/SHA-256 hashes that a lane function
+* advances at once.
+*/
+#define SHA224_256_LANE_COUNT 8
+
+/*
+* Processes one 64 byte block for each of SHA224_256_LANE_COUNT
+* independent SHA-224/SHA-256 intermediate hashes; lane i updates
+* Intermediate_Hashes[i] with blocks[i].
+*/
+typedef void(*SHA224_256_PROCESS_LANES)(uint32_t* const Intermediate_Hashes[SHA224_256_LANE_COUNT], const uint8_t* const blocks[SHA224_256_LANE_COUNT]);
+
+/*
+* Returns the lane function using the AVX2 instructions of the CPU, or
+* NULL when the CPU or the compiler does not have them. See
+* sha256_hw.c.
+*/
+extern SHA224_256_PROCESS_LANES SHA224_256GetHardwareProcessLanes(void);
+
+/*
+* Computes the SHA-256 digests of count messages, message i being the
+* 64 bytes of prefixes[i] followed by the lengths[i] bytes of
+* messages[i]. The messages are hashed SHA224_256_LANE_COUNT at a time
+* when the CPU has a lane function, one after the other otherwise.
+*/
+extern int SHA256ComputePrefixedDigests(size_t count, const uint8_t* const prefixes[], const uint8_t* const messages[], const size_t lengths[], uint8_t (*Message_Digests)[SHA256HashSize]);
+
+/*
+* Processes block_count consecutive 128 byte blocks into the
+* SHA-384/SHA-512 intermediate hash.
+*/
+typedef void(*SHA384_512_PROCESS_BLOCKS)(uint64_t Intermediate_Hash[8], const uint8_t *blocks, size_t block_count);
+
+/*
+* Returns the block function using the ARMv8.2 SHA512 instructions on
+* AArch64, or NULL when the CPU or the compiler does not have them.
+* See sha384-512_hw.c.
+*/
+extern SHA384_512_PROCESS_BLOCKS SHA384_512GetHardwareProcessBlocks(void);
+
 #endif /* _SHA_PRIVATE__H */
 
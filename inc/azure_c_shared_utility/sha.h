@@ -189,6 +189,7 @@ extern int SHA1Reset(SHA1Context *);
 extern int SHA1Input(SHA1Context *, const uint8_t *bytes, unsigned int bytecount);
 extern int SHA1FinalBits(SHA1Context *, const uint8_t bits, unsigned int bitcount);
 extern int SHA1Result(SHA1Context *, uint8_t Message_Digest[SHA1HashSize]);
+extern int SHA1UseHardwareAcceleration(int use);
 
 /* SHA-224 */
 extern int SHA224Reset(SHA224Context *);
@@ -201,6 +202,7 @@ extern int SHA256Reset(SHA256Context *);
 extern int SHA256Input(SHA256Context *, const uint8_t *bytes, unsigned int bytecount);
 extern int SHA256FinalBits(SHA256Context *, const uint8_t bits, unsigned int bitcount);
 extern int SHA256Result(SHA256Context *, uint8_t Message_Digest[SHA256HashSize]);
+extern int SHA256UseHardwareAcceleration(int use);
 
 /* SHA-384 */
 extern int SHA384Reset(SHA384Context *);
@@ -213,6 +215,7 @@ extern int SHA512Reset(SHA512Context *);
 extern int SHA512Input(SHA512Context *, const uint8_t *bytes, unsigned int bytecount);
 extern int SHA512FinalBits(SHA512Context *, const uint8_t bits, unsigned int bitcount);
 extern int SHA512Result(SHA512Context *, uint8_t Message_Digest[SHA512HashSize]);
+extern int SHA512UseHardwareAcceleration(int use);
 
 /* Unified SHA functions, chosen by whichSha */
 extern int USHAReset(USHAContext *, SHAversion whichSha);
@@ -7,8 +7,11 @@
 #include "azure_c_shared_utility/const_defines.h"
 
 #ifdef __cplusplus
+#include <cstddef>
 extern "C"
 {
+#else
+#include <stddef.h>
 #endif
 
     typedef struct HTTP_PROXY_OPTIONS_TAG
@@ -21,13 +24,79 @@ extern "C"
 
     static STATIC_VAR_UNUSED const char* const OPTION_HTTP_PROXY = "proxy_data";
     static STATIC_VAR_UNUSED const char* const OPTION_HTTP_TIMEOUT = "timeout";
+    // http_proxy_tunnel_pool (HTTP_PROXY_TUNNEL_POOL_HANDLE) makes http_proxy_io_open take an idle CONNECT tunnel from that
+    // pool when it has one to the target; the pool is not owned by the IO and NULL stops using it.
+    static STATIC_VAR_UNUSED const char* const OPTION_HTTP_PROXY_TUNNEL_POOL = "http_proxy_tunnel_pool";
+    static STATIC_VAR_UNUSED const char* const OPTION_HTTPAPIEX_MAX_IDLE_CONNECTIONS = "httpapiex_max_idle_connections";
+    static STATIC_VAR_UNUSED const char* const OPTION_HTTPAPIEX_IDLE_TIMEOUT = "httpapiex_idle_timeout";
+
+    // httpapiex_retry_policy (const HTTPAPIEX_RETRY_POLICY*) shapes how HTTPAPIEX retries failed requests to its host.
+    // Retries wait a random delay of up to min(max_backoff_ms, initial_backoff_ms * 2^retry) (full jitter) and each one
+    // takes a token out of retry_budget, which every successful request refills by one. After circuit_breaker_threshold
+    // consecutive failed requests the circuit opens and requests fail fast for circuit_breaker_open_ms, then a single
+    // request probes the host. A 0 disables the corresponding mechanism.
+    typedef struct HTTPAPIEX_RETRY_POLICY_TAG
+    {
+        unsigned int initial_backoff_ms;
+        unsigned int max_backoff_ms;
+        size_t retry_budget;
+        size_t circuit_breaker_threshold;
+        unsigned int circuit_breaker_open_ms;
+    } HTTPAPIEX_RETRY_POLICY;
+
+    static STATIC_VAR_UNUSED const char* const OPTION_HTTPAPIEX_RETRY_POLICY = "httpapiex_retry_policy";
+    // httpapiex_request_compression_threshold (const size_t*) makes HTTPAPIEX send the request bodies of at least that many
+    // bytes gzip compressed, with Content-Encoding: gzip, unless the request already has a Content-Encoding; 0 (the default)
+    // disables it. Streamed bodies are compressed as they are read and the compressed body is held in memory, since its
+    // Content-Length has to be known. It is only supported when the library is built with use_http_compression.
+    static STATIC_VAR_UNUSED const char* const OPTION_HTTPAPIEX_REQUEST_COMPRESSION_THRESHOLD = "httpapiex_request_compression_threshold";
+
+    // http_version (const HTTP_VERSION_OPTION*) selects the HTTP version spoken by the HTTP API adapters that support it (curl).
+    // HTTP_VERSION_OPTION_2 offers h2 through ALPN and falls back to HTTP/1.1 when the server does not pick it,
+    // HTTP_VERSION_OPTION_2_PRIOR_KNOWLEDGE speaks HTTP/2 without negotiating and fails against a server that does not.
+    typedef enum HTTP_VERSION_OPTION_TAG
+    {
+        HTTP_VERSION_OPTION_DEFAULT,
+        HTTP_VERSION_OPTION_1_1,
+        HTTP_VERSION_OPTION_2,
+        HTTP_VERSION_OPTION_2_PRIOR_KNOWLEDGE
+    } HTTP_VERSION_OPTION;
+
+    static STATIC_VAR_UNUSED const char* const OPTION_HTTP_VERSION = "http_version";
+    // http_decompress_responses (const bool*) asks for compressed responses (Accept-Encoding) and decodes them, so that the
+    // content arrives decompressed; httpapi_compact supports it when built with use_http_decompression (gzip and deflate).
+    static STATIC_VAR_UNUSED const char* const OPTION_HTTP_DECOMPRESS_RESPONSES = "http_decompress_responses";
+    // http_pipeline_depth (const size_t*) is the largest number of requests httpapi_compact_execute_pipelined_requests keeps
+    // in flight on the connection, 1 (the default) disables pipelining.
+    static STATIC_VAR_UNUSED const char* const OPTION_HTTP_PIPELINE_DEPTH = "http_pipeline_depth";
 
     static STATIC_VAR_UNUSED const char* const OPTION_TRUSTED_CERT = "TrustedCerts";
+    // The path of a PEM file of trusted certificates, which tlsio_openssl maps read-only and parses once
+    // into a certificate store shared by every instance given the same path. It cannot be set with OPTION_TRUSTED_CERT.
+    static STATIC_VAR_UNUSED const char* const OPTION_TRUSTED_CERT_FILE = "TrustedCertsFile";
 
     // Clients should not use OPTION_OPENSSL_CIPHER_SUITE except for very specialized scenarios.
     // They instead should rely on the underlying client TLS stack and service to negotiate an appropriate cipher.
     static STATIC_VAR_UNUSED const char* const OPTION_OPENSSL_CIPHER_SUITE = "CipherSuite";
 
+    // Engine (const char*) is the id of the OpenSSL engine tlsio_openssl loads, such as "pkcs11", "tpm2tss" or "qatengine". It
+    // becomes the process wide default for the algorithms it implements, so the bulk ciphers and key exchanges run on it too.
+    // Provider (const char*) is the name of the OpenSSL 3 provider to load, such as "tpm2" or "qatprovider"; the algorithms it
+    // implements are preferred by the SSL contexts of the TLS IOs given it.
+    // x509PrivatekeyType (const OPTION_OPENSSL_KEY_TYPE*) tells what x509privatekey holds: a PEM key (KEY_TYPE_DEFAULT), the
+    // id of a key of the engine (KEY_TYPE_ENGINE) or an OSSL_STORE URI (KEY_TYPE_URI, OpenSSL 1.1.1+), such as
+    // "pkcs11:object=device-key" or "handle:0x81000001", for a key kept by a provider or by an engine's store loader.
+    typedef enum OPTION_OPENSSL_KEY_TYPE_TAG
+    {
+        KEY_TYPE_DEFAULT,
+        KEY_TYPE_ENGINE,
+        KEY_TYPE_URI
+    } OPTION_OPENSSL_KEY_TYPE;
+
+    static STATIC_VAR_UNUSED const char* const OPTION_OPENSSL_ENGINE = "Engine";
+    static STATIC_VAR_UNUSED const char* const OPTION_OPENSSL_PROVIDER = "Provider";
+    static STATIC_VAR_UNUSED const char* const OPTION_OPENSSL_PRIVATE_KEY_TYPE = "x509PrivatekeyType";
+
     static STATIC_VAR_UNUSED const char* const SU_OPTION_X509_CERT = "x509certificate";
     static STATIC_VAR_UNUSED const char* const SU_OPTION_X509_PRIVATE_KEY = "x509privatekey";
 
@@ -43,10 +112,84 @@ extern "C"
     static STATIC_VAR_UNUSED const char* const OPTION_NET_INT_MAC_ADDRESS = "net_interface_mac_address";
 
     static STATIC_VAR_UNUSED const char* const OPTION_TLS_VERSION = "tls_version";
+    static STATIC_VAR_UNUSED const char* const OPTION_TLS_SESSION_CACHE = "tls_session_cache";
+    // tls_early_data (const bool*): when a resumed TLS 1.3 session allows it, the open completes before the handshake and
+    // the sends made from on_io_open_complete go out with the ClientHello as early data, saving a round trip. Early data
+    // can be replayed by an attacker, so only idempotent sends (an HTTP upgrade or an MQTT CONNECT) may be made there.
+    // Sends the server rejects are sent again after the handshake. Needs tls_session_cache.
+    static STATIC_VAR_UNUSED const char* const OPTION_TLS_EARLY_DATA = "tls_early_data";
+    // tls_alpn (const char*) is the comma separated list of protocols offered through ALPN, such as "mqtt" or "h2,http/1.1".
+    static STATIC_VAR_UNUSED const char* const OPTION_TLS_ALPN = "tls_alpn";
+    // tls_groups (const char*) is the colon separated list of key exchange groups offered, most preferred first, such as
+    // "X25519:P-256". tls_signature_algorithms (const char*) lists the TLS 1.3 signature scheme names the same way, such as
+    // "ecdsa_secp256r1_sha256:rsa_pss_rsae_sha256". tlsio_options.h has the names accepted by both.
+    static STATIC_VAR_UNUSED const char* const OPTION_TLS_GROUPS = "tls_groups";
+    static STATIC_VAR_UNUSED const char* const OPTION_TLS_SIGNATURE_ALGORITHMS = "tls_signature_algorithms";
+    static STATIC_VAR_UNUSED const char* const OPTION_TLS_READ_CHUNK_SIZE = "tls_read_chunk_size";
+    static STATIC_VAR_UNUSED const char* const OPTION_TLS_COALESCE_RECEIVED_BYTES = "tls_coalesce_received_bytes";
+    static STATIC_VAR_UNUSED const char* const OPTION_TLS_CORK_SENDS = "tls_cork_sends";
+    // tls_dynamic_record_size (const bool*) writes records of about one TCP segment after the handshake and after a second
+    // without sends, so the first bytes of a burst can be decrypted before a cold congestion window let a 16KB record
+    // through, and full sized records once 128KB were sent.
+    static STATIC_VAR_UNUSED const char* const OPTION_TLS_DYNAMIC_RECORD_SIZE = "tls_dynamic_record_size";
+    static STATIC_VAR_UNUSED const char* const OPTION_TLS_KTLS = "tls_ktls";
+    static STATIC_VAR_UNUSED const char* const OPTION_TLS_SHARED_CONTEXT = "tls_shared_context";
+    static STATIC_VAR_UNUSED const char* const OPTION_TLS_MAX_FRAGMENT_LENGTH = "tls_max_fragment_length";
+    // tls_handshake_threadpool (THREADPOOL_HANDLE) runs the handshake steps, with their key exchange and certificate
+    // checks, on a worker of that pool and leaves the IO thread free meanwhile; the pool is not owned by the IO and has to
+    // outlive it, NULL runs the handshake on the IO thread. The tls_validation_callback is then called on the worker.
+    // Handshakes that write to the socket for tls_ktls stay on the IO thread.
+    static STATIC_VAR_UNUSED const char* const OPTION_TLS_HANDSHAKE_THREADPOOL = "tls_handshake_threadpool";
 
     static STATIC_VAR_UNUSED const char* const OPTION_ADDRESS_TYPE = "ADDRESS_TYPE";
     static STATIC_VAR_UNUSED const char* const OPTION_ADDRESS_TYPE_DOMAIN_SOCKET = "DOMAIN_SOCKET";
     static STATIC_VAR_UNUSED const char* const OPTION_ADDRESS_TYPE_IP_SOCKET = "IP_SOCKET";
+    // OPTION_SOCKET_REACTOR is a SOCKET_REACTOR_HANDLE, NULL to poll the socket on every dowork. socketio_berkeley
+    // moves an open socket to the new reactor, socketio_win32 only takes it while closed.
+    static STATIC_VAR_UNUSED const char* const OPTION_SOCKET_REACTOR = "socket_reactor";
+    // OPTION_SOCKET_DESCRIPTOR is a query: value is an int* that receives the descriptor of the open socket,
+    // which stays owned by the socket IO.
+    static STATIC_VAR_UNUSED const char* const OPTION_SOCKET_DESCRIPTOR = "socket_descriptor";
+    // The socket tuning options take an int*. They are kept by the socket IO and applied to every socket it
+    // connects with; options the platform does not have are rejected.
+    static STATIC_VAR_UNUSED const char* const OPTION_TCP_NODELAY = "tcp_nodelay";
+    static STATIC_VAR_UNUSED const char* const OPTION_TCP_QUICKACK = "tcp_quickack";
+    static STATIC_VAR_UNUSED const char* const OPTION_SO_SNDBUF = "so_sndbuf";
+    static STATIC_VAR_UNUSED const char* const OPTION_SO_RCVBUF = "so_rcvbuf";
+    static STATIC_VAR_UNUSED const char* const OPTION_TCP_FASTOPEN = "tcp_fastopen";
+    static STATIC_VAR_UNUSED const char* const OPTION_SO_BUSY_POLL = "so_busy_poll";
+    // socketio_receive_size (size_t*) is the largest read, RECEIVE_BYTES_VALUE by default. With
+    // socketio_adaptive_receive (bool*) each read is sized from the bytes queued on the socket instead.
+    // socketio_receive_drain_limit (size_t*) caps the bytes read per dowork call, 0 (the default) reads until drained.
+    // With socketio_shared_receive_buffer (bool*) the reads go to a buffer of the thread calling dowork, shared by all the
+    // connections it works, instead of buffers of each connection; the received bytes are only valid during on_bytes_received.
+    static STATIC_VAR_UNUSED const char* const OPTION_SOCKETIO_RECEIVE_SIZE = "socketio_receive_size";
+    static STATIC_VAR_UNUSED const char* const OPTION_SOCKETIO_ADAPTIVE_RECEIVE = "socketio_adaptive_receive";
+    static STATIC_VAR_UNUSED const char* const OPTION_SOCKETIO_RECEIVE_DRAIN_LIMIT = "socketio_receive_drain_limit";
+    static STATIC_VAR_UNUSED const char* const OPTION_SOCKETIO_SHARED_RECEIVE_BUFFER = "socketio_shared_receive_buffer";
+    // socketio_zerocopy_threshold (size_t*) sends the CONSTBUFFERs of at least that many bytes with MSG_ZEROCOPY where the
+    // socket supports it; such a send completes when the kernel releases the buffer, which can be past an ACK of the peer.
+    // 0 (the default) copies every send.
+    static STATIC_VAR_UNUSED const char* const OPTION_SOCKETIO_ZEROCOPY_THRESHOLD = "socketio_zerocopy_threshold";
+
+    static STATIC_VAR_UNUSED const char* const OPTION_WS_FRAGMENT_STREAMING = "ws_fragment_streaming";
+    // ws_keepalive (WS_KEEPALIVE_OPTIONS*) sends a Ping after an idle interval and reports WS_ERROR_PONG_TIMEOUT
+    // when nothing comes back in time, so that a dead connection is found without the application polling.
+    static STATIC_VAR_UNUSED const char* const OPTION_WS_KEEPALIVE = "ws_keepalive";
+    static STATIC_VAR_UNUSED const char* const OPTION_WS_PERMESSAGE_DEFLATE = "ws_permessage_deflate";
+    // ws_receive_buffer_size (size_t*) lends that much of the memory the frames are decoded from to the underlying IO,
+    // for it to read the next bytes into it instead of having them copied; 0 (the default) copies them.
+    static STATIC_VAR_UNUSED const char* const OPTION_WS_RECEIVE_BUFFER_SIZE = "ws_receive_buffer_size";
+    // ws_receive_limits (WS_RECEIVE_LIMITS*) closes the connection with 1009 when the peer sends a frame or a message
+    // bigger than allowed, instead of growing the memory the received bytes are accumulated in without bound.
+    static STATIC_VAR_UNUSED const char* const OPTION_WS_RECEIVE_LIMITS = "ws_receive_limits";
+    // ws_send_coalescing (size_t*) lets the frames sent between two uws_client_dowork calls be sent together,
+    // until they add up to that many bytes; 0 (the default) sends each frame at once.
+    static STATIC_VAR_UNUSED const char* const OPTION_WS_SEND_COALESCING = "ws_send_coalescing";
+    // ws_send_fragment_size (size_t*) sends the data frames with more payload than that as fragments of that size,
+    // released one at a time so that control frames go out between them; 0 (the default) sends each frame whole.
+    static STATIC_VAR_UNUSED const char* const OPTION_WS_SEND_FRAGMENT_SIZE = "ws_send_fragment_size";
+    static STATIC_VAR_UNUSED const char* const OPTION_WSIO_SEND_WINDOW = "wsio_send_window";
 
 #ifdef __cplusplus
 }
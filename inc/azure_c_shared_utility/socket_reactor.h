@@ -0,0 +1,111 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file socket_reactor.h
+*    @brief      A readiness notification reactor shared by many sockets.
+*    @details    The socket reactor wraps epoll (Linux) or kqueue (BSD/macOS)
+*                so that IO adapters such as socketio_berkeley can learn when a
+*                socket became readable or writable instead of polling every
+*                socket on every dowork. Event callbacks are invoked from the
+*                thread(s) calling ::socket_reactor_run and are expected to
+*                only record the readiness; the actual IO stays on the thread
+*                that drives the IO adapter.
+*
+*                On Windows the reactor is an I/O completion port and reports
+*                completions rather than readiness: registering a socket
+*                associates it with the port, and each overlapped operation
+*                started on it with a ::SOCKET_REACTOR_OVERLAPPED is reported
+*                with the event stored in that structure once it completed.
+*/
+
+#ifndef SOCKET_REACTOR_H
+#define SOCKET_REACTOR_H
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef _WIN32
+#include <winsock2.h>
+#include <windows.h>
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SOCKET_REACTOR_INSTANCE_TAG* SOCKET_REACTOR_HANDLE;
+
+#define SOCKET_REACTOR_EVENT_READABLE   0x01
+#define SOCKET_REACTOR_EVENT_WRITABLE   0x02
+#define SOCKET_REACTOR_EVENT_ERROR      0x04
+
+typedef void(*ON_SOCKET_REACTOR_EVENT)(void* context, unsigned int events);
+
+#ifdef _WIN32
+/** @brief    An overlapped operation on a registered socket. @c event is what the callback gets
+ *            when the operation completed (with SOCKET_REACTOR_EVENT_ERROR added if it failed),
+ *            @c bytes_transferred and @c error (a WSA error code) are filled in before the call. */
+typedef struct SOCKET_REACTOR_OVERLAPPED_TAG
+{
+    OVERLAPPED overlapped;
+    unsigned int event;
+    unsigned long bytes_transferred;
+    int error;
+} SOCKET_REACTOR_OVERLAPPED;
+#endif
+
+/**
+ * @brief    Creates a new reactor backed by an epoll or kqueue descriptor, or a completion port.
+ *
+ * @return    A valid @c SOCKET_REACTOR_HANDLE when successful or @c NULL otherwise.
+ */
+MOCKABLE_FUNCTION(, SOCKET_REACTOR_HANDLE, socket_reactor_create);
+
+/**
+ * @brief    Destroys the reactor. All sockets must have been unregistered and
+ *             no thread may be inside ::socket_reactor_run.
+ */
+MOCKABLE_FUNCTION(, void, socket_reactor_destroy, SOCKET_REACTOR_HANDLE, reactor);
+
+/**
+ * @brief    Registers @p socket for edge triggered read and write readiness.
+ *
+ *             @p on_event is called with a combination of the
+ *             SOCKET_REACTOR_EVENT_* flags each time the socket transitions
+ *             into a readable or writable state.
+ *
+ * @return    0 on success, non-zero otherwise.
+ */
+MOCKABLE_FUNCTION(, int, socket_reactor_register, SOCKET_REACTOR_HANDLE, reactor, int, socket, ON_SOCKET_REACTOR_EVENT, on_event, void*, on_event_context);
+
+/**
+ * @brief    Unregisters @p socket. Once this call returns the callback given
+ *             at registration time is guaranteed not to be running and will not
+ *             be invoked again. Must be called before the socket is closed.
+ *
+ * @return    0 on success, non-zero otherwise.
+ */
+MOCKABLE_FUNCTION(, int, socket_reactor_unregister, SOCKET_REACTOR_HANDLE, reactor, int, socket);
+
+/**
+ * @brief    Waits up to @p timeout_ms milliseconds for readiness events and
+ *             dispatches them. Can be called concurrently from several threads.
+ *
+ * @return    The number of dispatched events, or a negative value on failure.
+ */
+MOCKABLE_FUNCTION(, int, socket_reactor_run, SOCKET_REACTOR_HANDLE, reactor, unsigned int, timeout_ms);
+
+/**
+ * @brief    Makes one thread waiting in ::socket_reactor_run return before its
+ *             timeout, without dispatching any event. May be called from any
+ *             thread; if no thread is waiting the next ::socket_reactor_run
+ *             returns at once.
+ *
+ * @return    0 on success, non-zero otherwise.
+ */
+MOCKABLE_FUNCTION(, int, socket_reactor_wake, SOCKET_REACTOR_HANDLE, reactor);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOCKET_REACTOR_H */
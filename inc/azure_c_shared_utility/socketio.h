@@ -5,6 +5,7 @@
 #define SOCKETIO_H
 
 #include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/constbuffer.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
 
@@ -35,6 +36,10 @@ MOCKABLE_FUNCTION(, void, socketio_destroy, CONCRETE_IO_HANDLE, socket_io);
 MOCKABLE_FUNCTION(, int, socketio_open, CONCRETE_IO_HANDLE, socket_io, ON_IO_OPEN_COMPLETE, on_io_open_complete, void*, on_io_open_complete_context, ON_BYTES_RECEIVED, on_bytes_received, void*, on_bytes_received_context, ON_IO_ERROR, on_io_error, void*, on_io_error_context);
 MOCKABLE_FUNCTION(, int, socketio_close, CONCRETE_IO_HANDLE, socket_io, ON_IO_CLOSE_COMPLETE, on_io_close_complete, void*, callback_context);
 MOCKABLE_FUNCTION(, int, socketio_send, CONCRETE_IO_HANDLE, socket_io, const void*, buffer, size_t, size, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
+/* sends the content of buffer_handle; if the socket cannot take all of it a reference is queued instead of a copy (socketio_berkeley only) */
+MOCKABLE_FUNCTION(, int, socketio_send_constbuffer, CONCRETE_IO_HANDLE, socket_io, CONSTBUFFER_HANDLE, buffer_handle, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
+/* sends the buffers of constbuffer_array with sendmsg; what the socket cannot take is queued as references on the buffers (socketio_berkeley only) */
+MOCKABLE_FUNCTION(, int, socketio_send_constbuffer_array, CONCRETE_IO_HANDLE, socket_io, CONSTBUFFER_ARRAY_HANDLE, constbuffer_array, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
 MOCKABLE_FUNCTION(, void, socketio_dowork, CONCRETE_IO_HANDLE, socket_io);
 MOCKABLE_FUNCTION(, int, socketio_setoption, CONCRETE_IO_HANDLE, socket_io, const char*, optionName, const void*, value);
 
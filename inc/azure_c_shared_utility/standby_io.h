@@ -0,0 +1,46 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef STANDBY_IO_H
+#define STANDBY_IO_H
+
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+#include <cstdint>
+extern "C" {
+#else
+#include <stdint.h>
+#endif /* __cplusplus */
+
+/* An IO that keeps a second connection of the layer below open and idle, so that an open after a failure does not
+   wait for DNS, TCP and TLS again. It is placed between the layer to fail over and the one above it, for example
+   between a TLS IO and a WebSocket IO. Both connections are created with underlying_io_interface, the first one with
+   underlying_io_parameters and the standby one with standby_io_parameters, which may name a secondary endpoint.
+
+   Once opened, the standby connection is opened in the background. When the connection in use fails, the error is
+   still reported to the layer above, since the bytes in flight and the state of the layers above (a WebSocket
+   upgrade for example) cannot move to another connection, and the standby connection becomes the one in use: the
+   open that follows completes before returning. The failed connection is then reopened as the new standby.
+
+   An idle standby connection is replaced every refresh_interval_ms (0 to keep it as long as it stays up), and a
+   standby connection that failed to open is opened again after retry_interval_ms. Bytes received on the idle standby
+   connection close it. Both connections are worked by the dowork of the standby IO. It is not thread safe. */
+typedef struct STANDBY_IO_CONFIG_TAG
+{
+    const IO_INTERFACE_DESCRIPTION* underlying_io_interface;
+    void* underlying_io_parameters;
+    /* the parameters of the standby connection, NULL to use underlying_io_parameters */
+    void* standby_io_parameters;
+    uint32_t refresh_interval_ms;
+    uint32_t retry_interval_ms;
+} STANDBY_IO_CONFIG;
+
+MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, standby_io_get_interface_description);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* STANDBY_IO_H */
@@ -0,0 +1,80 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file strhash.h
+ *    @brief     A fast seeded hash of strings and bytes for the indexes of the library.
+ *
+ *    @details The hash follows wyhash: a short key costs two 64x64->128 bit multiplications and
+ *             a long one a multiplication per 16 bytes, with everything read 4 or 8 bytes at a time.
+ *             The functions without a seed use a seed drawn once per process from ::gb_rand_uint64,
+ *             so that a peer that picks the keys (header names, for instance) cannot predict which
+ *             of them collide. The value of a hash thus changes from one run to the next and must not
+ *             be stored or sent. This is not a cryptographic hash.
+ *
+ *             The @c _nocase functions fold the ASCII letters to lower case as they read, so that
+ *             keys that only differ in the case of ASCII letters get the same hash.
+ */
+
+#ifndef STRHASH_H
+#define STRHASH_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief    Returns the seed of the process, drawn the first time it is needed. It is never 0.
+ */
+MOCKABLE_FUNCTION(, uint64_t, strhash_get_process_seed);
+
+/**
+ * @brief    Hashes length bytes of data with the seed of the process. data may be @c NULL when
+ *           length is 0.
+ */
+MOCKABLE_FUNCTION(, uint64_t, strhash_bytes, const void*, data, size_t, length);
+
+/**
+ * @brief    Hashes length bytes of data with the seed of the process, ignoring the case of the
+ *           ASCII letters.
+ */
+MOCKABLE_FUNCTION(, uint64_t, strhash_bytes_nocase, const void*, data, size_t, length);
+
+/**
+ * @brief    Hashes the @c '\0' terminated value with the seed of the process, a @c NULL value
+ *           hashes as an empty string.
+ */
+MOCKABLE_FUNCTION(, uint64_t, strhash_string, const char*, value);
+
+/**
+ * @brief    Hashes the @c '\0' terminated value with the seed of the process, ignoring the case of
+ *           the ASCII letters.
+ */
+MOCKABLE_FUNCTION(, uint64_t, strhash_string_nocase, const char*, value);
+
+/**
+ * @brief    Hashes length bytes of data with the given seed, for the indexes that keep their own
+ *           seed and for reproducible results.
+ */
+MOCKABLE_FUNCTION(, uint64_t, strhash_bytes_with_seed, const void*, data, size_t, length, uint64_t, seed);
+
+/**
+ * @brief    Hashes length bytes of data with the given seed, ignoring the case of the ASCII
+ *           letters.
+ */
+MOCKABLE_FUNCTION(, uint64_t, strhash_bytes_nocase_with_seed, const void*, data, size_t, length, uint64_t, seed);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STRHASH_H */
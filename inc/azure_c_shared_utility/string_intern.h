@@ -0,0 +1,80 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file string_intern.h
+ *    @brief     A process wide pool of immutable, reference counted strings.
+ *
+ *    @details Every connection keeps its host name and the names of its options, and most
+ *             connections of a process share a handful of them. ::string_intern returns the
+ *             pooled copy of a string, so that the layers of all connections hold one copy of
+ *             each, and two strings interned while the pool exists are equal exactly when
+ *             their pointers are.
+ *
+ *             The pool is created by ::string_intern_init (platform_init on Linux does it).
+ *             Until then ::string_intern returns a private copy, which works the same way
+ *             except that it is not shared: ::string_intern_equals compares those by content.
+ */
+
+#ifndef STRING_INTERN_H
+#define STRING_INTERN_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define STRING_INTERN_INITIAL_BUCKET_COUNT  64
+
+/**
+ * @brief    Creates the pool.
+ *
+ * @return    0 on success, a non-zero value otherwise (including when already initialized).
+ */
+MOCKABLE_FUNCTION(, int, string_intern_init);
+
+/**
+ * @brief    Frees the pool. Must only be called once no thread uses it anymore; strings still
+ *             referenced then stay valid, as private copies, until released.
+ */
+MOCKABLE_FUNCTION(, void, string_intern_deinit);
+
+/**
+ * @brief    Returns a reference to the pooled string equal to @p value, adding it to the pool
+ *             if it is not there yet. The string must not be modified.
+ *
+ * @return    The interned string, to release with ::string_intern_release, or @c NULL on failure.
+ */
+MOCKABLE_FUNCTION(, const char*, string_intern, const char*, value);
+
+/**
+ * @brief    Returns one more reference to an interned string.
+ *
+ * @return    @p interned (a new private copy if it is not pooled), or @c NULL on failure.
+ */
+MOCKABLE_FUNCTION(, const char*, string_intern_clone, const char*, interned);
+
+/**
+ * @brief    Releases a reference returned by ::string_intern or ::string_intern_clone. Does
+ *             nothing if @p interned is @c NULL.
+ */
+MOCKABLE_FUNCTION(, void, string_intern_release, const char*, interned);
+
+/**
+ * @brief    Tells whether two interned strings are equal: one pointer comparison when both are
+ *             pooled. Either may be @c NULL, which only equals @c NULL.
+ */
+MOCKABLE_FUNCTION(, bool, string_intern_equals, const char*, left, const char*, right);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* STRING_INTERN_H */
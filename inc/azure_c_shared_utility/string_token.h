@@ -17,6 +17,22 @@ extern "C"
 
 typedef struct STRING_TOKEN_TAG* STRING_TOKEN_HANDLE;
 
+/*
+*    @brief     Caller-owned state of a tokenization that does not allocate memory nor copy the tokens.
+*    @Remark    After a successful call to StringToken_NextView, the current token is the length characters of the source string starting at value
+*               (it is not null-terminated and may be empty), and delimiter points to the element of the delimiters array that ended it,
+*               or is NULL if the token extends to the end of the source string. The remaining fields are internal to the tokenizer.
+*/
+typedef struct STRING_TOKEN_VIEW_TAG
+{
+    const char* value;
+    size_t length;
+    const char* delimiter;
+
+    const char* next;
+    const char* end;
+} STRING_TOKEN_VIEW;
+
 /*
 *    @brief     Tries to identify the first token defined in source up to its length using the delimiters provided. 
 *    @Remark    If no delimiter is found, the entire source string becomes the resulting token. Empty tokens (when delimiters occur side-by-side) can also detected.
@@ -85,6 +101,26 @@ MOCKABLE_FUNCTION(, int, StringToken_Split, const char*, source, size_t, length,
 */
 MOCKABLE_FUNCTION(, void, StringToken_Destroy, STRING_TOKEN_HANDLE, token);
 
+/*
+*    @brief     Prepares a STRING_TOKEN_VIEW for tokenizing source up to its length. No token is current until StringToken_NextView is called.
+*    @param     view          The caller-owned view to be initialized.
+*    @param     source        The string to be tokenized. It must remain valid while the view is used.
+*    @param     length        The length of the source string, not including the null-terminator.
+*    @return    Zero if no failures occur, or a non-zero value otherwise.
+*/
+MOCKABLE_FUNCTION(, int, StringToken_InitView, STRING_TOKEN_VIEW*, view, const char*, source, size_t, length);
+
+/*
+*    @brief     Identifies the next token of the source string, using the delimiters provided. The first call identifies the first token.
+*    @Remark    Tokens are reported in place (as view->value and view->length), so no memory is allocated. Empty tokens (when delimiters occur
+*               side-by-side or at either end of the source string) are reported with a zero length.
+*    @param     view          The view initialized by StringToken_InitView.
+*    @param     delimiters    Array with null-terminated strings to be used as token delimiters.
+*    @param     n_delims      Number of elements in delimiters array.
+*    @return    True if a token could be identified, or false if the tokenizer already reached the end of the source string or the arguments are invalid.
+*/
+MOCKABLE_FUNCTION(, bool, StringToken_NextView, STRING_TOKEN_VIEW*, view, const char**, delimiters, size_t, n_delims);
+
 #ifdef __cplusplus
 }
 #endif
@@ -26,6 +26,9 @@ MOCKABLE_FUNCTION(, STRING_HANDLE, STRING_from_byte_array, const unsigned char*,
 MOCKABLE_FUNCTION(, void, STRING_delete, STRING_HANDLE, handle);
 MOCKABLE_FUNCTION(, int, STRING_concat, STRING_HANDLE, handle, const char*, s2);
 MOCKABLE_FUNCTION(, int, STRING_concat_with_STRING, STRING_HANDLE, s1, STRING_HANDLE, s2);
+MOCKABLE_FUNCTION(, int, STRING_concat_JSON, STRING_HANDLE, handle, const char*, source);
+MOCKABLE_FUNCTION(, int, STRING_JSON_length, const char*, source, size_t*, length);
+MOCKABLE_FUNCTION(, int, STRING_JSON_write, char*, destination, size_t, destinationSize, const char*, source, size_t*, written);
 MOCKABLE_FUNCTION(, int, STRING_quote, STRING_HANDLE, handle);
 MOCKABLE_FUNCTION(, int, STRING_copy, STRING_HANDLE, s1, const char*, s2);
 MOCKABLE_FUNCTION(, int, STRING_copy_n, STRING_HANDLE, s1, const char*, s2, size_t, n);
@@ -34,6 +37,7 @@ MOCKABLE_FUNCTION(, int, STRING_empty, STRING_HANDLE, handle);
 MOCKABLE_FUNCTION(, size_t, STRING_length, STRING_HANDLE, handle);
 MOCKABLE_FUNCTION(, int, STRING_compare, STRING_HANDLE, s1, STRING_HANDLE, s2);
 MOCKABLE_FUNCTION(, int, STRING_replace, STRING_HANDLE, handle, char, target, char, replace);
+MOCKABLE_FUNCTION(, int, STRING_reserve, STRING_HANDLE, handle, size_t, capacity);
 
 extern STRING_HANDLE STRING_construct_sprintf(const char* format, ...);
 extern int STRING_sprintf(STRING_HANDLE s1, const char* format, ...);
@@ -0,0 +1,125 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file sync_event.h
+ *    @brief     Events and counting semaphores that need no lock.
+ *
+ *    @details A waiter spins for a short while before it parks on ::sync_wait_on_address,
+ *             so a wakeup that comes quickly (for example between a producer and an IO
+ *             thread) costs no system call, and a setter only makes one when a thread
+ *             is parked. Timeouts are measured on a monotonic clock.
+ *
+ *             All the functions but the destroy ones may be called from any thread.
+ */
+
+#ifndef SYNC_EVENT_H
+#define SYNC_EVENT_H
+
+#include "azure_c_shared_utility/macro_utils.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+#include <cstdint>
+extern "C" {
+#else
+#include <stdbool.h>
+#include <stdint.h>
+#endif
+
+typedef struct SYNC_EVENT_TAG* SYNC_EVENT_HANDLE;
+typedef struct SYNC_SEMAPHORE_TAG* SYNC_SEMAPHORE_HANDLE;
+
+#define SYNC_EVENT_RESULT_VALUES \
+    SYNC_EVENT_OK, \
+    SYNC_EVENT_INVALID_ARG, \
+    SYNC_EVENT_ERROR, \
+    SYNC_EVENT_TIMEOUT
+
+DEFINE_ENUM(SYNC_EVENT_RESULT, SYNC_EVENT_RESULT_VALUES);
+
+/**
+ * @brief    Creates an event.
+ *
+ * @param    manual_reset    If true the event stays set until ::sync_event_reset and
+ *                           releases every waiter, otherwise a successful wait resets
+ *                           it and ::sync_event_set releases one waiter.
+ * @param    initially_set   Whether the event starts set.
+ *
+ * @return    A valid @c SYNC_EVENT_HANDLE when successful or @c NULL otherwise.
+ */
+MOCKABLE_FUNCTION(, SYNC_EVENT_HANDLE, sync_event_create, bool, manual_reset, bool, initially_set);
+
+/**
+ * @brief    Destroys the event. No thread may be waiting on it.
+ */
+MOCKABLE_FUNCTION(, void, sync_event_destroy, SYNC_EVENT_HANDLE, sync_event);
+
+/**
+ * @brief    Sets the event, waking the waiters it releases.
+ */
+MOCKABLE_FUNCTION(, SYNC_EVENT_RESULT, sync_event_set, SYNC_EVENT_HANDLE, sync_event);
+
+/**
+ * @brief    Resets the event.
+ */
+MOCKABLE_FUNCTION(, SYNC_EVENT_RESULT, sync_event_reset, SYNC_EVENT_HANDLE, sync_event);
+
+/**
+ * @brief    Waits for the event to be set.
+ *
+ * @param    timeout_milliseconds    How long to wait at most, 0 waits until the event is set.
+ *
+ * @return    @c SYNC_EVENT_OK once the event is set, @c SYNC_EVENT_TIMEOUT if it was not
+ *             set in time, or another error code in case it fails.
+ */
+MOCKABLE_FUNCTION(, SYNC_EVENT_RESULT, sync_event_wait, SYNC_EVENT_HANDLE, sync_event, int, timeout_milliseconds);
+
+/**
+ * @brief    Checks the event without waiting, resetting an auto reset event that is set.
+ *
+ * @return    @c SYNC_EVENT_OK if the event is set, @c SYNC_EVENT_TIMEOUT if it is not.
+ */
+MOCKABLE_FUNCTION(, SYNC_EVENT_RESULT, sync_event_try_wait, SYNC_EVENT_HANDLE, sync_event);
+
+/**
+ * @brief    Creates a semaphore holding @p initial_count units.
+ *
+ * @return    A valid @c SYNC_SEMAPHORE_HANDLE when successful or @c NULL otherwise.
+ */
+MOCKABLE_FUNCTION(, SYNC_SEMAPHORE_HANDLE, sync_semaphore_create, uint32_t, initial_count);
+
+/**
+ * @brief    Destroys the semaphore. No thread may be waiting on it.
+ */
+MOCKABLE_FUNCTION(, void, sync_semaphore_destroy, SYNC_SEMAPHORE_HANDLE, sync_semaphore);
+
+/**
+ * @brief    Adds @p count units to the semaphore, waking as many waiters.
+ *
+ * @return    @c SYNC_EVENT_OK on success, @c SYNC_EVENT_INVALID_ARG if @p count is 0 or
+ *             would take the semaphore over INT32_MAX units.
+ */
+MOCKABLE_FUNCTION(, SYNC_EVENT_RESULT, sync_semaphore_release, SYNC_SEMAPHORE_HANDLE, sync_semaphore, uint32_t, count);
+
+/**
+ * @brief    Takes one unit of the semaphore, waiting for one to be released if there is none.
+ *
+ * @param    timeout_milliseconds    How long to wait at most, 0 waits until a unit is released.
+ *
+ * @return    @c SYNC_EVENT_OK once a unit is taken, @c SYNC_EVENT_TIMEOUT if none was
+ *             released in time, or another error code in case it fails.
+ */
+MOCKABLE_FUNCTION(, SYNC_EVENT_RESULT, sync_semaphore_wait, SYNC_SEMAPHORE_HANDLE, sync_semaphore, int, timeout_milliseconds);
+
+/**
+ * @brief    Takes one unit of the semaphore without waiting.
+ *
+ * @return    @c SYNC_EVENT_OK if a unit was taken, @c SYNC_EVENT_TIMEOUT if there is none.
+ */
+MOCKABLE_FUNCTION(, SYNC_EVENT_RESULT, sync_semaphore_try_wait, SYNC_SEMAPHORE_HANDLE, sync_semaphore);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYNC_EVENT_H */
@@ -0,0 +1,57 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file sync_wait.h
+ *    @brief     Blocks a thread while a 32 bit word holds a given value.
+ *
+ *    @details This is the parking primitive ::sync_event is built on: a futex on Linux,
+ *             WaitOnAddress on Windows and a table of pthread conditions elsewhere.
+ *             Only the waiter and the waker touch the kernel, an uncontended word stays
+ *             in user space. Wakeups may be spurious, waiters check the word again.
+ */
+
+#ifndef SYNC_WAIT_H
+#define SYNC_WAIT_H
+
+#include "azure_c_shared_utility/macro_utils.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+#include <cstdint>
+extern "C" {
+#else
+#include <stdbool.h>
+#include <stdint.h>
+#endif
+
+#define SYNC_WAIT_RESULT_VALUES \
+    SYNC_WAIT_OK, \
+    SYNC_WAIT_TIMEOUT, \
+    SYNC_WAIT_ERROR
+
+DEFINE_ENUM(SYNC_WAIT_RESULT, SYNC_WAIT_RESULT_VALUES);
+
+/**
+ * @brief    Waits until @p address is woken by ::sync_wake_by_address, returning
+ *             at once if it does not hold @p compare_value.
+ *
+ * @param    timeout_milliseconds    How long to wait at most, measured on a monotonic
+ *                                   clock; 0 waits until woken.
+ *
+ * @return    @c SYNC_WAIT_OK when woken (possibly spuriously) or when the word does not
+ *             hold @p compare_value, @c SYNC_WAIT_TIMEOUT when the timeout expired and
+ *             @c SYNC_WAIT_ERROR on failure.
+ */
+MOCKABLE_FUNCTION(, SYNC_WAIT_RESULT, sync_wait_on_address, volatile int32_t*, address, int32_t, compare_value, int, timeout_milliseconds);
+
+/**
+ * @brief    Wakes one or all the threads waiting on @p address. The word has to be
+ *             changed before, or the threads go back to waiting.
+ */
+MOCKABLE_FUNCTION(, void, sync_wake_by_address, volatile int32_t*, address, bool, wake_all);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SYNC_WAIT_H */
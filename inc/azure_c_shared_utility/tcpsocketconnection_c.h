@@ -10,6 +10,10 @@ extern "C" {
 
     typedef void* TCPSOCKETCONNECTION_HANDLE;
 
+    /* called from the network stack, possibly in interrupt context, when the state of the socket changes (data to read,
+       room to send, closed by the peer); it should only record that and not call back into the socket */
+    typedef void(*TCPSOCKETCONNECTION_ON_SIGIO)(void* context);
+
     TCPSOCKETCONNECTION_HANDLE tcpsocketconnection_create(void);
     void tcpsocketconnection_set_blocking(TCPSOCKETCONNECTION_HANDLE tcpSocketConnectionHandle, bool blocking, unsigned int timeout);
     void tcpsocketconnection_destroy(TCPSOCKETCONNECTION_HANDLE tcpSocketConnectionHandle);
@@ -20,6 +24,8 @@ extern "C" {
     int tcpsocketconnection_send_all(TCPSOCKETCONNECTION_HANDLE tcpSocketConnectionHandle, const char* data, int length);
     int tcpsocketconnection_receive(TCPSOCKETCONNECTION_HANDLE tcpSocketConnectionHandle, char* data, int length);
     int tcpsocketconnection_receive_all(TCPSOCKETCONNECTION_HANDLE tcpSocketConnectionHandle, char* data, int length);
+    /* only available with Mbed OS 5, on_sigio being NULL detaches the callback */
+    void tcpsocketconnection_set_sigio(TCPSOCKETCONNECTION_HANDLE tcpSocketConnectionHandle, TCPSOCKETCONNECTION_ON_SIGIO on_sigio, void* context);
 
 #ifdef __cplusplus
 }
@@ -13,7 +13,12 @@
 #include "azure_c_shared_utility/umock_c_prod.h"
 
 #ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
 extern "C" {
+#else
+#include <stddef.h>
+#include <stdint.h>
 #endif
 
 typedef int(*THREAD_START_FUNC)(void *);
@@ -31,6 +36,32 @@ DEFINE_ENUM(THREADAPI_RESULT, THREADAPI_RESULT_VALUES);
 
 typedef void* THREAD_HANDLE;
 
+#define THREADAPI_PRIORITY_VALUES \
+    THREADAPI_PRIORITY_NORMAL,    \
+    THREADAPI_PRIORITY_LOWEST,    \
+    THREADAPI_PRIORITY_LOW,       \
+    THREADAPI_PRIORITY_HIGH,      \
+    THREADAPI_PRIORITY_HIGHEST
+
+/** @brief The scheduling priority of a thread relative to the other threads of the process.
+ *           Raising it may need privileges the process does not have.
+ */
+DEFINE_ENUM(THREADAPI_PRIORITY, THREADAPI_PRIORITY_VALUES);
+
+/** @brief The attributes of a thread created with ::ThreadAPI_CreateEx. A zeroed structure
+ *           gives the same thread as ::ThreadAPI_Create.
+ */
+typedef struct THREAD_ATTRIBUTES_TAG
+{
+    /** @brief The stack size in bytes, 0 for the platform default. The platform may round it up. */
+    size_t stack_size;
+    /** @brief The name shown by debuggers and tools, NULL for none. The platform may truncate it (15 characters on Linux). */
+    const char* name;
+    /** @brief Bit n allows the thread to run on CPU n, 0 lets it run on any CPU. */
+    uint64_t cpu_affinity_mask;
+    THREADAPI_PRIORITY priority;
+} THREAD_ATTRIBUTES;
+
 /**
  * @brief    Creates a thread with the entry point specified by the @p func
  *             argument.
@@ -47,6 +78,24 @@ typedef void* THREAD_HANDLE;
  */
 MOCKABLE_FUNCTION(, THREADAPI_RESULT, ThreadAPI_Create, THREAD_HANDLE*, threadHandle, THREAD_START_FUNC, func, void*, arg);
 
+/**
+ * @brief    Creates a thread like ::ThreadAPI_Create, with the stack size, name, CPU
+ *             affinity and priority given by @p attributes.
+ *
+ * @param   threadHandle    The handle to the new thread is returned in this
+ *                             pointer.
+ * @param    func            A function pointer that indicates the entry point
+ *                             to the new thread.
+ * @param   arg                A void pointer that must be passed to the function
+ *                             pointed to by @p func.
+ * @param   attributes      The attributes of the thread, NULL for the defaults.
+ *
+ * @return    @c THREADAPI_OK if the API call is successful, @c THREADAPI_INVALID_ARG
+ *             if an attribute is not valid or not supported by the platform, or
+ *             another error code in case it fails. No thread is left running on failure.
+ */
+MOCKABLE_FUNCTION(, THREADAPI_RESULT, ThreadAPI_CreateEx, THREAD_HANDLE*, threadHandle, THREAD_START_FUNC, func, void*, arg, const THREAD_ATTRIBUTES*, attributes);
+
 /**
  * @brief    Blocks the calling thread by waiting on the thread identified by
  *             the @p threadHandle argument to complete.
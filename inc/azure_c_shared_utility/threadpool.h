@@ -0,0 +1,85 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file threadpool.h
+ *    @brief     A fixed set of worker threads that run scheduled work items.
+ *
+ *    @details Each worker has its own deque of work items. Work scheduled from a work item
+ *             goes to the deque of the worker running it and is taken back in LIFO order,
+ *             work scheduled from any other thread is spread over the workers. A worker
+ *             whose deque is empty steals the oldest item of another worker before it goes
+ *             to sleep, so a burst scheduled on one worker still runs on all of them.
+ *
+ *             Workers sleep on a condition while there is no work; scheduling only takes
+ *             the pool lock to wake one when some worker is asleep.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct THREADPOOL_TAG* THREADPOOL_HANDLE;
+
+/** @brief The work item itself, its return value is handed to the completion callback. */
+typedef int(*THREADPOOL_WORK_FUNCTION)(void* context);
+
+/** @brief Called on the worker right after the work function returned. */
+typedef void(*ON_THREADPOOL_WORK_COMPLETE)(void* context, int work_result);
+
+typedef struct THREADPOOL_CONFIG_TAG
+{
+    /* the number of workers, 0 creates one per processor */
+    size_t worker_count;
+    /* pins worker i to processor i modulo the processor count, where the platform supports it */
+    bool pin_workers;
+} THREADPOOL_CONFIG;
+
+/**
+ * @brief    Creates a thread pool and starts its workers.
+ *
+ * @param    config    The pool configuration, or @c NULL for one unpinned worker per processor.
+ *
+ * @return    A valid @c THREADPOOL_HANDLE when successful or @c NULL otherwise.
+ */
+MOCKABLE_FUNCTION(, THREADPOOL_HANDLE, threadpool_create, const THREADPOOL_CONFIG*, config);
+
+/**
+ * @brief    Runs all the work still scheduled, stops the workers and frees the pool.
+ *             Work items may keep scheduling work until then, any other thread scheduling
+ *             work meanwhile fails. Must not be called by a work item.
+ */
+MOCKABLE_FUNCTION(, void, threadpool_destroy, THREADPOOL_HANDLE, threadpool);
+
+/**
+ * @brief    Schedules @p work_function to run on one of the workers. May be called from any
+ *             thread, including from a work item.
+ *
+ * @param    on_work_complete    Optional, called with @p on_work_complete_context and the
+ *                               value returned by @p work_function.
+ *
+ * @return    0 on success, a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, threadpool_schedule_work, THREADPOOL_HANDLE, threadpool, THREADPOOL_WORK_FUNCTION, work_function, void*, work_context, ON_THREADPOOL_WORK_COMPLETE, on_work_complete, void*, on_work_complete_context);
+
+/**
+ * @brief    Returns the number of workers of the pool, 0 if @p threadpool is @c NULL.
+ */
+MOCKABLE_FUNCTION(, size_t, threadpool_get_worker_count, THREADPOOL_HANDLE, threadpool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* THREADPOOL_H */
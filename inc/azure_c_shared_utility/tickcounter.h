@@ -19,12 +19,22 @@ extern "C"
     typedef uint_fast32_t tickcounter_ms_t;
 #endif
 
+    // Microseconds do not fit 32 bits for long, so they are 64-bit everywhere
+    typedef uint_fast64_t tickcounter_us_t;
+
     typedef struct TICK_COUNTER_INSTANCE_TAG *TICK_COUNTER_HANDLE;
 
     MOCKABLE_FUNCTION(, TICK_COUNTER_HANDLE, tickcounter_create);
     MOCKABLE_FUNCTION(, void, tickcounter_destroy, TICK_COUNTER_HANDLE, tick_counter);
     MOCKABLE_FUNCTION(, int, tickcounter_get_current_ms, TICK_COUNTER_HANDLE, tick_counter, tickcounter_ms_t *, current_ms);
 
+    // The microsecond clock is only provided by the Linux and Windows tick counters.
+    // tickcounter_get_current_us counts from tickcounter_create, like tickcounter_get_current_ms.
+    MOCKABLE_FUNCTION(, int, tickcounter_get_current_us, TICK_COUNTER_HANDLE, tick_counter, tickcounter_us_t *, current_us);
+    // Needs no tick counter and does not allocate, for time stamping hot paths. Counts from an
+    // unspecified point in the past, so only differences between two values are meaningful.
+    MOCKABLE_FUNCTION(, int, tickcounter_get_monotonic_us, tickcounter_us_t *, monotonic_us);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
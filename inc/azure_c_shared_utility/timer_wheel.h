@@ -0,0 +1,95 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file timer_wheel.h
+ *    @brief     Hierarchical timer wheel with O(1) start and cancel, driven by tickcounter.
+ *
+ *    @details A layer that needs timeouts creates a timer once and starts or cancels it as
+ *             often as needed, neither allocates. ::timer_wheel_dowork reads the tick
+ *             counter once and only visits the timers whose deadline passed (plus, every
+ *             256 ms, the ones moving down a level of the wheel), however many are running.
+ *
+ *             Deadlines have a resolution of 1 ms. The wheel is not thread safe, all its
+ *             functions must be called from the thread that calls ::timer_wheel_dowork,
+ *             which is also the thread the expiration callbacks run on.
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct TIMER_WHEEL_TAG* TIMER_WHEEL_HANDLE;
+typedef struct TIMER_WHEEL_TIMER_TAG* TIMER_WHEEL_TIMER_HANDLE;
+
+/** @brief Called from ::timer_wheel_dowork once the timer expired. The timer may be started
+ *         again or destroyed from within the callback. */
+typedef void(*ON_TIMER_EXPIRED)(void* context);
+
+/**
+ * @brief    Creates a timer wheel with its own tick counter.
+ *
+ * @return    A valid @c TIMER_WHEEL_HANDLE when successful or @c NULL otherwise.
+ */
+MOCKABLE_FUNCTION(, TIMER_WHEEL_HANDLE, timer_wheel_create);
+
+/**
+ * @brief    Frees the timer wheel. All its timers must have been destroyed before.
+ */
+MOCKABLE_FUNCTION(, void, timer_wheel_destroy, TIMER_WHEEL_HANDLE, timer_wheel);
+
+/**
+ * @brief    Creates a timer that is not running.
+ *
+ * @param    on_timer_expired    Called with @p context each time the timer expires.
+ *
+ * @return    A valid @c TIMER_WHEEL_TIMER_HANDLE when successful or @c NULL otherwise.
+ */
+MOCKABLE_FUNCTION(, TIMER_WHEEL_TIMER_HANDLE, timer_wheel_create_timer, TIMER_WHEEL_HANDLE, timer_wheel, ON_TIMER_EXPIRED, on_timer_expired, void*, context);
+
+/**
+ * @brief    Cancels the timer if it is running and frees it.
+ */
+MOCKABLE_FUNCTION(, void, timer_wheel_destroy_timer, TIMER_WHEEL_TIMER_HANDLE, timer);
+
+/**
+ * @brief    Starts the timer so that it expires @p timeout_ms from now, restarting it if it
+ *             is already running.
+ *
+ * @return    0 on success, a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, timer_wheel_start_timer, TIMER_WHEEL_TIMER_HANDLE, timer, tickcounter_ms_t, timeout_ms);
+
+/**
+ * @brief    Stops the timer without calling its callback. Does nothing if it is not running.
+ */
+MOCKABLE_FUNCTION(, void, timer_wheel_cancel_timer, TIMER_WHEEL_TIMER_HANDLE, timer);
+
+/**
+ * @brief    Tells whether the timer is running, that is started and neither expired nor
+ *             cancelled since.
+ */
+MOCKABLE_FUNCTION(, bool, timer_wheel_is_timer_running, TIMER_WHEEL_TIMER_HANDLE, timer);
+
+/**
+ * @brief    Calls the callbacks of all the timers that expired, in deadline order.
+ */
+MOCKABLE_FUNCTION(, void, timer_wheel_dowork, TIMER_WHEEL_HANDLE, timer_wheel);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* TIMER_WHEEL_H */
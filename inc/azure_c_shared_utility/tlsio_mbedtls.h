@@ -17,6 +17,14 @@ extern "C" {
 
 extern const IO_INTERFACE_DESCRIPTION* tlsio_mbedtls_get_interface_description(void);
 
+/* Creates the state the instances share when OPTION_TLS_SHARED_CONTEXT is set. Called by platform_init. */
+extern int tlsio_mbedtls_init(void);
+extern void tlsio_mbedtls_deinit(void);
+
+/* Makes mbedTLS allocate from buffer instead of the heap (needs MBEDTLS_MEMORY_BUFFER_ALLOC_C).
+   Must be called before any TLS IO is created, the buffer must stay valid until tlsio_mbedtls_deinit. */
+extern int tlsio_mbedtls_set_memory_buffer(unsigned char* buffer, size_t size);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
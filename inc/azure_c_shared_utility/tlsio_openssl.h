@@ -5,6 +5,7 @@
 #define TLSIO_OPENSSL_H
 
 #include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/threadpool.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
 
 #ifdef __cplusplus
@@ -14,6 +15,32 @@ extern "C" {
 #include <stddef.h>
 #endif /* __cplusplus */
 
+/* counters of the process wide TLS session cache used by the tlsio_openssl instances that have OPTION_TLS_SESSION_CACHE set */
+typedef struct TLSIO_OPENSSL_SESSION_CACHE_STATS_TAG
+{
+    /* handshakes that resumed a cached session */
+    size_t hits;
+    /* handshakes that had to do a full handshake, either because nothing was cached or because the server declined the session */
+    size_t misses;
+    /* sessions currently held by the cache */
+    size_t entries;
+} TLSIO_OPENSSL_SESSION_CACHE_STATS;
+
+/* an IO opened by tlsio_openssl_open_batch, created with the tlsio_openssl interface and its options already set */
+typedef struct TLSIO_OPENSSL_BATCH_ENTRY_TAG
+{
+    XIO_HANDLE tls_io;
+    ON_BYTES_RECEIVED on_bytes_received;
+    void* on_bytes_received_context;
+    ON_IO_ERROR on_io_error;
+    void* on_io_error_context;
+} TLSIO_OPENSSL_BATCH_ENTRY;
+
+typedef struct TLSIO_OPENSSL_BATCH_TAG* TLSIO_OPENSSL_BATCH_HANDLE;
+
+/* called once for each entry, entry_index being its position in the entries given to tlsio_openssl_open_batch */
+typedef void(*ON_TLSIO_OPENSSL_BATCH_OPEN_COMPLETE)(void* context, size_t entry_index, IO_OPEN_RESULT open_result);
+
 MOCKABLE_FUNCTION(, int, tlsio_openssl_init);
 MOCKABLE_FUNCTION(, void, tlsio_openssl_deinit);
 
@@ -22,10 +49,26 @@ MOCKABLE_FUNCTION(, void, tlsio_openssl_destroy, CONCRETE_IO_HANDLE, tls_io);
 MOCKABLE_FUNCTION(, int, tlsio_openssl_open, CONCRETE_IO_HANDLE, tls_io, ON_IO_OPEN_COMPLETE, on_io_open_complete, void*, on_io_open_complete_context, ON_BYTES_RECEIVED, on_bytes_received, void*, on_bytes_received_context, ON_IO_ERROR, on_io_error, void*, on_io_error_context);
 MOCKABLE_FUNCTION(, int, tlsio_openssl_close, CONCRETE_IO_HANDLE, tls_io, ON_IO_CLOSE_COMPLETE, on_io_close_complete, void*, callback_context);
 MOCKABLE_FUNCTION(, int, tlsio_openssl_send, CONCRETE_IO_HANDLE, tls_io, const void*, buffer, size_t, size, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
+MOCKABLE_FUNCTION(, int, tlsio_openssl_sendv, CONCRETE_IO_HANDLE, tls_io, const XIO_BUFFER*, buffers, size_t, buffer_count, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
 MOCKABLE_FUNCTION(, void, tlsio_openssl_dowork, CONCRETE_IO_HANDLE, tls_io);
+MOCKABLE_FUNCTION(, int, tlsio_openssl_dowork_ex, CONCRETE_IO_HANDLE, tls_io, bool*, made_progress, uint64_t*, next_deadline_us);
 MOCKABLE_FUNCTION(, int, tlsio_openssl_setoption, CONCRETE_IO_HANDLE, tls_io, const char*, optionName, const void*, value);
+MOCKABLE_FUNCTION(, int, tlsio_openssl_get_stats, CONCRETE_IO_HANDLE, tls_io, XIO_STATS*, stats, size_t, stats_count, size_t*, layer_count);
+MOCKABLE_FUNCTION(, int, tlsio_openssl_get_pollable_handle, CONCRETE_IO_HANDLE, tls_io, intptr_t*, pollable_handle, unsigned int*, wanted_events);
+MOCKABLE_FUNCTION(, int, tlsio_openssl_set_receive_buffer, CONCRETE_IO_HANDLE, tls_io, unsigned char*, buffer, size_t, size);
 
 MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, tlsio_openssl_get_interface_description);
+MOCKABLE_FUNCTION(, int, tlsio_openssl_get_session_cache_stats, TLSIO_OPENSSL_SESSION_CACHE_STATS*, stats);
+
+/* Opens many IOs at once, such as the downstream connections of a gateway starting up. The IOs get OPTION_TLS_SHARED_CONTEXT,
+   so that the ones with the same settings parse their certificates into one SSL_CTX, and OPTION_TLS_HANDSHAKE_THREADPOOL
+   when handshake_threadpool is not NULL, so that their handshakes run on its workers side by side. At most
+   max_concurrent_opens IOs are opening at a time, 0 opening them all at once. tlsio_openssl_batch_dowork does the work of
+   the IOs still opening and starts the next ones; an IO whose open completed is the caller's to work from then on.
+   tlsio_openssl_batch_destroy cancels the opens not completed yet. */
+MOCKABLE_FUNCTION(, TLSIO_OPENSSL_BATCH_HANDLE, tlsio_openssl_open_batch, const TLSIO_OPENSSL_BATCH_ENTRY*, entries, size_t, entry_count, THREADPOOL_HANDLE, handshake_threadpool, size_t, max_concurrent_opens, ON_TLSIO_OPENSSL_BATCH_OPEN_COMPLETE, on_open_complete, void*, on_open_complete_context);
+MOCKABLE_FUNCTION(, int, tlsio_openssl_batch_dowork, TLSIO_OPENSSL_BATCH_HANDLE, batch, bool*, is_complete);
+MOCKABLE_FUNCTION(, void, tlsio_openssl_batch_destroy, TLSIO_OPENSSL_BATCH_HANDLE, batch);
 
 #ifdef __cplusplus
 }
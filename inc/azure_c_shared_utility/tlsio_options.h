@@ -7,7 +7,16 @@
 #ifndef TLSIO_OPTIONS_H
 #define TLSIO_OPTIONS_H
 
+#ifdef __cplusplus
+#include <cstdint>
+#include <cstddef>
+#else
+#include <stdint.h>
+#include <stddef.h>
+#endif
+
 #include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/constbuffer.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
 
 #ifdef __cplusplus
@@ -21,8 +30,40 @@ extern "C" {
         TLSIO_OPTION_BIT_TRUSTED_CERTS = 0x01,
         TLSIO_OPTION_BIT_x509_RSA_CERT = 0x02,
         TLSIO_OPTION_BIT_x509_ECC_CERT = 0x04,
+        TLSIO_OPTION_BIT_GROUPS =        0x08,
+        TLSIO_OPTION_BIT_SIGNATURE_ALGORITHMS = 0x10,
     } TLSIO_OPTION_BIT;
 
+    // The groups of OPTION_TLS_GROUPS, by their IANA NamedGroup value. The names accepted are
+    // X25519, X448, P-256 (or secp256r1, prime256v1), P-384 (or secp384r1), P-521 (or secp521r1),
+    // ffdhe2048, ffdhe3072 and ffdhe4096.
+    #define TLSIO_GROUP_SECP256R1 23
+    #define TLSIO_GROUP_SECP384R1 24
+    #define TLSIO_GROUP_SECP521R1 25
+    #define TLSIO_GROUP_X25519 29
+    #define TLSIO_GROUP_X448 30
+    #define TLSIO_GROUP_FFDHE2048 256
+    #define TLSIO_GROUP_FFDHE3072 257
+    #define TLSIO_GROUP_FFDHE4096 258
+
+    // The signature algorithms of OPTION_TLS_SIGNATURE_ALGORITHMS, by their IANA SignatureScheme
+    // value. The names accepted are the lower case names of RFC 8446, such as ecdsa_secp256r1_sha256.
+    // The hash is in the high byte, except for rsa_pss_* where the low byte tells it and ed* which have none.
+    #define TLSIO_SIGNATURE_ALGORITHM_RSA_PKCS1_SHA256 0x0401
+    #define TLSIO_SIGNATURE_ALGORITHM_RSA_PKCS1_SHA384 0x0501
+    #define TLSIO_SIGNATURE_ALGORITHM_RSA_PKCS1_SHA512 0x0601
+    #define TLSIO_SIGNATURE_ALGORITHM_ECDSA_SECP256R1_SHA256 0x0403
+    #define TLSIO_SIGNATURE_ALGORITHM_ECDSA_SECP384R1_SHA384 0x0503
+    #define TLSIO_SIGNATURE_ALGORITHM_ECDSA_SECP521R1_SHA512 0x0603
+    #define TLSIO_SIGNATURE_ALGORITHM_RSA_PSS_RSAE_SHA256 0x0804
+    #define TLSIO_SIGNATURE_ALGORITHM_RSA_PSS_RSAE_SHA384 0x0805
+    #define TLSIO_SIGNATURE_ALGORITHM_RSA_PSS_RSAE_SHA512 0x0806
+    #define TLSIO_SIGNATURE_ALGORITHM_ED25519 0x0807
+    #define TLSIO_SIGNATURE_ALGORITHM_ED448 0x0808
+
+    // The most entries a groups or signature algorithms list may have
+    #define TLSIO_OPTIONS_MAX_LIST_COUNT 16
+
     typedef enum TLSIO_OPTIONS_x509_TYPE_TAG
     {
         TLSIO_OPTIONS_x509_TYPE_UNSPECIFIED = TLSIO_OPTION_BIT_NONE,
@@ -39,7 +80,8 @@ extern "C" {
 
 
     // This struct contains the commonly-used options which
-    // are supported by tlsio_options.
+    // are supported by tlsio_options. The certificates and the key point into
+    // the *_buffer fields, which the retrieved options share instead of copying.
     typedef struct TLSIO_OPTIONS_TAG
     {
         int supported_options;
@@ -47,6 +89,16 @@ extern "C" {
         TLSIO_OPTIONS_x509_TYPE x509_type;
         const char* x509_cert;
         const char* x509_key;
+        CONSTBUFFER_HANDLE trusted_certs_buffer;
+        CONSTBUFFER_HANDLE x509_cert_buffer;
+        CONSTBUFFER_HANDLE x509_key_buffer;
+        // The lists as set, and their entries in order of preference
+        const char* groups;
+        uint16_t group_ids[TLSIO_OPTIONS_MAX_LIST_COUNT];
+        size_t group_count;
+        const char* signature_algorithms;
+        uint16_t signature_algorithm_ids[TLSIO_OPTIONS_MAX_LIST_COUNT];
+        size_t signature_algorithm_count;
     } TLSIO_OPTIONS;
 
     // Initialize the TLSIO_OPTIONS struct and specify which options are supported as a bit-or'ed
@@ -14,6 +14,12 @@ extern "C" {
 #include <stddef.h>
 #endif /* __cplusplus */
 
+/* tlsio_schannel_init creates the cache that lets the instances with the same client certificate and validation
+   flags share a credential handle, and with it the Schannel session cache. Without it (or if it fails), every
+   instance acquires its own credential handle. */
+MOCKABLE_FUNCTION(, int, tlsio_schannel_init);
+MOCKABLE_FUNCTION(, void, tlsio_schannel_deinit);
+
 MOCKABLE_FUNCTION(, CONCRETE_IO_HANDLE, tlsio_schannel_create, void*, io_create_parameters);
 MOCKABLE_FUNCTION(, void, tlsio_schannel_destroy, CONCRETE_IO_HANDLE, tls_io);
 MOCKABLE_FUNCTION(, int, tlsio_schannel_open, CONCRETE_IO_HANDLE, tls_io, ON_IO_OPEN_COMPLETE, on_io_open_complete, void*, on_io_open_complete_context, ON_BYTES_RECEIVED, on_bytes_received, void*, on_bytes_received_context, ON_IO_ERROR, on_io_error, void*, on_io_error_context);
@@ -24,6 +24,11 @@ extern "C" {
 
         MOCKABLE_FUNCTION(, UNIQUEID_RESULT, UniqueId_Generate, char*, uid, size_t, bufferSize);
 
+/* writes the 16 bytes of a random (version 4) UUID, in the order they appear in its string form */
+#define UNIQUEID_BINARY_SIZE      16
+
+        MOCKABLE_FUNCTION(, UNIQUEID_RESULT, UniqueId_GenerateBinary, unsigned char*, uid, size_t, bufferSize);
+
 #ifdef __cplusplus
 }
 #endif
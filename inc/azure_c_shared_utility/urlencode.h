@@ -25,6 +25,29 @@ extern "C" {
     MOCKABLE_FUNCTION(, STRING_HANDLE, URL_Encode, STRING_HANDLE, input);
     MOCKABLE_FUNCTION(, STRING_HANDLE, URL_EncodeString, const char*, textEncode);
 
+    /* @brief   Computes the length of the URL encoding of a string.
+    *
+    * @return   Returns the number of characters of the encoding, not counting the terminating '\0',
+    * or 0 if text is NULL.
+    */
+    MOCKABLE_FUNCTION(, size_t, URL_Encoded_Length, const char*, text);
+
+    /* @brief   URL Encode a string into a caller supplied buffer, in a single pass over the string.
+    *
+    * @param    destination_size must be at least URL_Encoded_Length(text) + 1.
+    *
+    * @return   Returns 0 on success, a non-zero value if an argument is invalid or destination is
+    * too small, in which case destination is left holding an empty string.
+    */
+    MOCKABLE_FUNCTION(, int, URL_Encode_To, const char*, text, char*, destination, size_t, destination_size);
+
+    /* @brief   URL Encode a string only when some of its characters need escaping.
+    *
+    * @return   Returns text itself when none of its characters needs escaping, otherwise destination
+    * holding the encoding as URL_Encode_To produces it, or NULL on failure.
+    */
+    MOCKABLE_FUNCTION(, const char*, URL_Encode_If_Needed, const char*, text, char*, destination, size_t, destination_size);
+
     /* @brief   URL Decode (aka percent decode) a string.
     * Please note that the URL decoder only supports decoding characters that fall within the
     * 7-bit ASCII range. It does NOT support 8-bit extended ASCII, and will fail if you try.
@@ -37,6 +60,26 @@ extern "C" {
     MOCKABLE_FUNCTION(, STRING_HANDLE, URL_Decode, STRING_HANDLE, input);
     MOCKABLE_FUNCTION(, STRING_HANDLE, URL_DecodeString, const char*, textDecode);
 
+    /* @brief   URL Decode the first *length characters of text over themselves, which the decoding is
+    * never longer than. Nothing past them is written, so a segment of a larger string, such as a
+    * query string parameter, can be decoded in place. The decoding is followed by a '\0' only when
+    * it is shorter than *length characters, callers should rely on the updated *length instead.
+    *
+    * @return   Returns 0 and sets *length to the length of the decoding on success, a non-zero value
+    * if an argument is invalid or text is not a valid encoding, in which case text is left unchanged.
+    */
+    MOCKABLE_FUNCTION(, int, URL_DecodeInPlace, char*, text, size_t*, length);
+
+    /* @brief   URL Decode a string only when it contains escaped characters.
+    *
+    * @param    destination_size must be at least the length of the decoding plus 1; strlen(text) + 1
+    * is always enough.
+    *
+    * @return   Returns text itself when it contains no '%', otherwise destination holding the decoding,
+    * or NULL if text is not a valid encoding or destination is too small.
+    */
+    MOCKABLE_FUNCTION(, const char*, URL_Decode_If_Needed, const char*, text, char*, destination, size_t, destination_size);
+
 #ifdef __cplusplus
 }
 #endif
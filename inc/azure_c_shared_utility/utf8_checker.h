@@ -14,8 +14,24 @@ extern "C" {
 
 #include "azure_c_shared_utility/umock_c_prod.h"
 
+/* The state of the validation of a string received in fragments, such as a fragmented
+   websocket text message. A code point cut between 2 fragments is kept in pending. */
+typedef struct UTF8_CHECKER_STATE_TAG
+{
+    unsigned char pending[4];
+    size_t pending_length;
+    bool is_valid;
+} UTF8_CHECKER_STATE;
+
 MOCKABLE_FUNCTION(, bool, utf8_checker_is_valid_utf8, const unsigned char*, utf8_str, size_t, length);
 
+/* Starts the validation of a new string. */
+MOCKABLE_FUNCTION(, void, utf8_checker_init, UTF8_CHECKER_STATE*, state);
+/* Validates the next fragment, returns false as soon as the bytes seen so far are not UTF-8. */
+MOCKABLE_FUNCTION(, bool, utf8_checker_validate_fragment, UTF8_CHECKER_STATE*, state, const unsigned char*, utf8_str, size_t, length);
+/* Ends the validation, returns false if a fragment was not UTF-8 or the last one ended with an incomplete code point. */
+MOCKABLE_FUNCTION(, bool, utf8_checker_complete, UTF8_CHECKER_STATE*, state);
+
 #ifdef __cplusplus
 }
 #endif /* __cplusplus */
@@ -18,6 +18,10 @@ extern "C" {
 
 typedef unsigned char UUID_T[16];
 
+/* Length of the string form of an UUID (e.g., "7f907d75-5e13-44cf-a1a3-19a01a2b4528") and size of a buffer holding it */
+#define UUID_STRING_LENGTH  36
+#define UUID_STRING_SIZE    (UUID_STRING_LENGTH + 1)
+
 /* These 2 strings can be conveniently used directly in printf statements
   Notice that PRI_UUID has to be used like any other print format specifier, meaning it
   has to be preceded with % */
@@ -51,6 +55,14 @@ MOCKABLE_FUNCTION(, int, UUID_from_string, const char*, uuid_string, UUID_T*, uu
 */
 MOCKABLE_FUNCTION(, char*, UUID_to_string, const UUID_T*, uuid);
 
+/* @brief               Writes the string representation of the UUID value to a caller provided buffer, without allocating.
+*  @param uuid          Sequence of bytes representing an UUID.
+*  @param buffer        Buffer receiving the null-terminated string representation of the UUID value.
+*  @param buffer_size   Size of buffer, at least UUID_STRING_SIZE.
+*  @returns             Zero if no failures occur, non-zero otherwise.
+*/
+MOCKABLE_FUNCTION(, int, UUID_to_string_buffer, const UUID_T*, uuid, char*, buffer, size_t, buffer_size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -51,7 +51,9 @@ DEFINE_ENUM(WS_OPEN_RESULT, WS_OPEN_RESULT_VALUES);
     WS_ERROR_BAD_FRAME_RECEIVED, \
     WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST, \
     WS_ERROR_UNDERLYING_IO_ERROR, \
-    WS_ERROR_CANNOT_CLOSE_UNDERLYING_IO
+    WS_ERROR_CANNOT_CLOSE_UNDERLYING_IO, \
+    WS_ERROR_PONG_TIMEOUT, \
+    WS_ERROR_MESSAGE_TOO_BIG
 
 DEFINE_ENUM(WS_ERROR, WS_ERROR_VALUES);
 
@@ -87,7 +89,12 @@ DEFINE_ENUM(WS_ERROR, WS_ERROR_VALUES);
 #define CLOSE_UNEXPECTED_CONDITION          1011
 #define CLOSE_RESERVED_1015                 1015
 
+/* fragment_flags values passed to ON_WS_FRAGMENT_RECEIVED, a fragment that has neither flag set is a continuation fragment */
+#define WS_FRAGMENT_FIRST           0x01
+#define WS_FRAGMENT_FINAL           0x02
+
 typedef void(*ON_WS_FRAME_RECEIVED)(void* context, unsigned char frame_type, const unsigned char* buffer, size_t size);
+typedef void(*ON_WS_FRAGMENT_RECEIVED)(void* context, unsigned char frame_type, unsigned char fragment_flags, const unsigned char* buffer, size_t size);
 typedef void(*ON_WS_SEND_FRAME_COMPLETE)(void* context, WS_SEND_FRAME_RESULT ws_send_frame_result);
 typedef void(*ON_WS_OPEN_COMPLETE)(void* context, WS_OPEN_RESULT ws_open_result);
 typedef void(*ON_WS_CLOSE_COMPLETE)(void* context);
@@ -99,6 +106,52 @@ typedef struct WS_PROTOCOL_TAG
     const char* protocol;
 } WS_PROTOCOL;
 
+/* value for OPTION_WS_FRAGMENT_STREAMING: when on_ws_fragment_received is not NULL, fragmented messages are not accumulated,
+   each fragment is indicated as it is received instead. A NULL on_ws_fragment_received switches back to accumulating. */
+typedef struct WS_FRAGMENT_STREAMING_TAG
+{
+    ON_WS_FRAGMENT_RECEIVED on_ws_fragment_received;
+    void* on_ws_fragment_received_context;
+} WS_FRAGMENT_STREAMING;
+
+/* value for OPTION_WS_PERMESSAGE_DEFLATE (RFC 7692), only available when built with use_ws_permessage_deflate.
+   The window bits and the mem_level bound the memory used by each connection: compressing takes about
+   (1 << (client_max_window_bits + 2)) + (1 << (mem_level + 9)) bytes and decompressing about (1 << server_max_window_bits) + 7KB. */
+typedef struct WS_PERMESSAGE_DEFLATE_OPTIONS_TAG
+{
+    /* 9..15, the largest window used to compress the frames sent to the server */
+    int client_max_window_bits;
+    /* 8..15, the largest window the server is asked to use for the frames it sends, 15 leaves it unconstrained */
+    int server_max_window_bits;
+    bool client_no_context_takeover;
+    bool server_no_context_takeover;
+    /* -1 (zlib default) or 0..9 */
+    int compression_level;
+    /* 1..9 */
+    int mem_level;
+} WS_PERMESSAGE_DEFLATE_OPTIONS;
+
+/* value for OPTION_WS_KEEPALIVE: once the connection is open, a Ping is sent when nothing was received for ping_interval_ms,
+   and when nothing is received either within pong_timeout_ms of that Ping the connection is reported dead with
+   WS_ERROR_PONG_TIMEOUT. The timers run in uws_client_dowork. A ping_interval_ms of 0 (the default) sends no Ping. */
+typedef struct WS_KEEPALIVE_OPTIONS_TAG
+{
+    unsigned int ping_interval_ms;
+    unsigned int pong_timeout_ms;
+} WS_KEEPALIVE_OPTIONS;
+
+/* value for OPTION_WS_RECEIVE_LIMITS: bounds the memory a peer can make a connection take for what it receives. A frame with
+   more payload than max_frame_size, a message of more than max_message_size bytes (once decompressed when compressed) or a
+   frame that does not fit in receive_memory_budget together with the fragments accumulated before it closes the connection
+   with 1009 and reports WS_ERROR_MESSAGE_TOO_BIG, as soon as its header is received. The budget also bounds the upgrade
+   response and the memory lent to the underlying IO with ws_receive_buffer_size. 0 (the default) leaves a limit out. */
+typedef struct WS_RECEIVE_LIMITS_TAG
+{
+    size_t max_frame_size;
+    size_t max_message_size;
+    size_t receive_memory_budget;
+} WS_RECEIVE_LIMITS;
+
 MOCKABLE_FUNCTION(, UWS_CLIENT_HANDLE, uws_client_create, const char*, hostname, unsigned int, port, const char*, resource_name, bool, use_ssl, const WS_PROTOCOL*, protocols, size_t, protocol_count);
 MOCKABLE_FUNCTION(, UWS_CLIENT_HANDLE, uws_client_create_with_io, const IO_INTERFACE_DESCRIPTION*, io_interface, void*, io_create_parameters, const char*, hostname, unsigned int, port, const char*, resource_name, const WS_PROTOCOL*, protocols, size_t, protocol_count)
 MOCKABLE_FUNCTION(, void, uws_client_destroy, UWS_CLIENT_HANDLE, uws_client);
@@ -107,9 +160,12 @@ MOCKABLE_FUNCTION(, int, uws_client_close_async, UWS_CLIENT_HANDLE, uws_client,
 MOCKABLE_FUNCTION(, int, uws_client_close_handshake_async, UWS_CLIENT_HANDLE, uws_client, uint16_t, close_code, const char*, close_reason, ON_WS_CLOSE_COMPLETE, on_ws_close_complete, void*, on_ws_close_complete_context);
 MOCKABLE_FUNCTION(, int, uws_client_send_frame_async, UWS_CLIENT_HANDLE, uws_client, unsigned char, frame_type, const unsigned char*, buffer, size_t, size, bool, is_final, ON_WS_SEND_FRAME_COMPLETE, on_ws_send_frame_complete, void*, callback_context);
 MOCKABLE_FUNCTION(, void, uws_client_dowork, UWS_CLIENT_HANDLE, uws_client);
+MOCKABLE_FUNCTION(, int, uws_client_dowork_ex, UWS_CLIENT_HANDLE, uws_client, bool*, made_progress, uint64_t*, next_deadline_us);
 MOCKABLE_FUNCTION(, int, uws_client_set_request_header, UWS_CLIENT_HANDLE, uws_client, const char*, name, const char*, value);
 MOCKABLE_FUNCTION(, int, uws_client_set_option, UWS_CLIENT_HANDLE, uws_client, const char*, option_name, const void*, value);
 MOCKABLE_FUNCTION(, OPTIONHANDLER_HANDLE, uws_client_retrieve_options, UWS_CLIENT_HANDLE, uws_client);
+MOCKABLE_FUNCTION(, int, uws_client_get_stats, UWS_CLIENT_HANDLE, uws_client, XIO_STATS*, stats, size_t, stats_count, size_t*, layer_count);
+MOCKABLE_FUNCTION(, int, uws_client_get_pollable_handle, UWS_CLIENT_HANDLE, uws_client, intptr_t*, pollable_handle, unsigned int*, wanted_events);
 
 #ifdef __cplusplus
 }
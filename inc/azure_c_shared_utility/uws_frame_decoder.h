@@ -0,0 +1,47 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef UWS_FRAME_DECODER_H
+#define UWS_FRAME_DECODER_H
+
+#include "azure_c_shared_utility/uws_frame_encoder.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+extern "C" {
+#else
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+typedef struct UWS_FRAME_DECODER_INSTANCE_TAG* UWS_FRAME_DECODER_HANDLE;
+
+typedef struct WS_FRAME_HEADER_TAG
+{
+    WS_FRAME_TYPE opcode;
+    bool is_final;
+    /* RSV1, RSV2 and RSV3 as the reserved argument of uws_frame_encoder_encode */
+    unsigned char reserved;
+    bool is_masked;
+    uint64_t payload_length;
+} WS_FRAME_HEADER;
+
+/* Called with the payload of a frame in one or more consecutive pieces, offset being where the piece starts in the payload;
+   the frame is complete when offset + size is header->payload_length, a frame without payload is indicated once with size 0.
+   The payload is unmasked and only valid for the duration of the call. */
+typedef void(*ON_WS_FRAME_DECODED)(void* context, const WS_FRAME_HEADER* header, const unsigned char* payload, size_t size, uint64_t offset);
+
+MOCKABLE_FUNCTION(, UWS_FRAME_DECODER_HANDLE, uws_frame_decoder_create, ON_WS_FRAME_DECODED, on_frame_decoded, void*, on_frame_decoded_context);
+MOCKABLE_FUNCTION(, void, uws_frame_decoder_destroy, UWS_FRAME_DECODER_HANDLE, uws_frame_decoder);
+
+/* decodes the bytes in any chunking, only a partial header is kept between calls; must not be called from on_frame_decoded */
+MOCKABLE_FUNCTION(, int, uws_frame_decoder_decode, UWS_FRAME_DECODER_HANDLE, uws_frame_decoder, const unsigned char*, buffer, size_t, size);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* UWS_FRAME_DECODER_H */
@@ -26,6 +26,19 @@ typedef struct WSIO_CONFIG_TAG
     const char* protocol;
 } WSIO_CONFIG;
 
+typedef void(*ON_WSIO_SEND_WINDOW_CHANGED)(void* context, bool is_open);
+
+/* value for OPTION_WSIO_SEND_WINDOW: once the bytes queued by wsio_send and not yet completed reach high_watermark
+   the send window closes and wsio_send fails until enough sends complete to bring the queued bytes down to low_watermark.
+   A high_watermark of 0 disables the window. on_send_window_changed is optional and is called on every transition. */
+typedef struct WSIO_SEND_WINDOW_TAG
+{
+    size_t high_watermark;
+    size_t low_watermark;
+    ON_WSIO_SEND_WINDOW_CHANGED on_send_window_changed;
+    void* on_send_window_changed_context;
+} WSIO_SEND_WINDOW;
+
 MOCKABLE_FUNCTION(, const IO_INTERFACE_DESCRIPTION*, wsio_get_interface_description);
 
 #ifdef __cplusplus
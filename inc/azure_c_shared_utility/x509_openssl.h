@@ -6,6 +6,12 @@
 
 #include "openssl/ssl.h"
 
+// The ENGINE API is deprecated in OpenSSL 3, where hardware keys are reached through providers and OSSL_STORE URIs
+#if !defined(OPENSSL_NO_ENGINE) && (OPENSSL_VERSION_NUMBER < 0x30000000L)
+#define X509_OPENSSL_ENGINES_SUPPORTED
+#include "openssl/engine.h"
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -15,6 +21,21 @@ extern "C" {
 MOCKABLE_FUNCTION(,int, x509_openssl_add_certificates, SSL_CTX*, ssl_ctx, const char*, certificates);
 MOCKABLE_FUNCTION(,int, x509_openssl_add_credentials, SSL_CTX*, ssl_ctx, const char*, x509certificate, const char*, x509privatekey);
 
+typedef struct X509_OPENSSL_CREDENTIALS_TAG* X509_OPENSSL_CREDENTIALS_HANDLE;
+
+MOCKABLE_FUNCTION(,int, x509_openssl_credentials_cache_init);
+MOCKABLE_FUNCTION(,void, x509_openssl_credentials_cache_deinit);
+MOCKABLE_FUNCTION(,X509_OPENSSL_CREDENTIALS_HANDLE, x509_openssl_credentials_acquire, const char*, x509certificate, const char*, x509privatekey);
+MOCKABLE_FUNCTION(,void, x509_openssl_credentials_release, X509_OPENSSL_CREDENTIALS_HANDLE, credentials);
+MOCKABLE_FUNCTION(,int, x509_openssl_add_parsed_credentials, SSL_CTX*, ssl_ctx, X509_OPENSSL_CREDENTIALS_HANDLE, credentials);
+
+// The private key is kept by an engine (ENGINE_load_private_key) or found at an OSSL_STORE URI (OpenSSL 1.1.1+),
+// so it never leaves the hardware holding it; x509certificate is PEM text as for x509_openssl_add_credentials.
+#ifdef X509_OPENSSL_ENGINES_SUPPORTED
+MOCKABLE_FUNCTION(,int, x509_openssl_add_engine_credentials, SSL_CTX*, ssl_ctx, const char*, x509certificate, ENGINE*, engine, const char*, x509privatekey_id);
+#endif
+MOCKABLE_FUNCTION(,int, x509_openssl_add_uri_credentials, SSL_CTX*, ssl_ctx, const char*, x509certificate, const char*, x509privatekey_uri);
+
 #ifdef __cplusplus
 }
 #endif
@@ -5,15 +5,19 @@
 #define XIO_H
 
 #include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/constbuffer_array.h"
 
 #include "azure_c_shared_utility/umock_c_prod.h"
 #include "azure_c_shared_utility/macro_utils.h"
 
 #ifdef __cplusplus
 #include <cstddef>
+#include <cstdint>
 extern "C" {
 #else
+#include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
 #endif /* __cplusplus */
 
 typedef struct XIO_INSTANCE_TAG* XIO_HANDLE;
@@ -33,6 +37,42 @@ DEFINE_ENUM(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
 
 DEFINE_ENUM(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
 
+typedef struct XIO_BUFFER_TAG
+{
+    const void* buffer;
+    size_t size;
+} XIO_BUFFER;
+
+/* the counters of one layer of an IO stack, see xio_get_stats */
+typedef struct XIO_STATS_TAG
+{
+    const char* layer_name;
+    /* bytes given to the layer by sends that it accepted */
+    uint64_t bytes_sent;
+    /* bytes the layer indicated to the layer above */
+    uint64_t bytes_received;
+    uint64_t send_count;
+    /* sends (or parts of sends) that could not complete at once and were queued */
+    uint64_t queued_send_count;
+    /* depth of the send queue when the counters were read */
+    uint64_t pending_send_count;
+    uint64_t dowork_count;
+    /* dowork calls that made no callback to the layer above */
+    uint64_t idle_dowork_count;
+    /* on_bytes_received and on_send_complete calls made to the layer above */
+    uint64_t callback_count;
+    /* time spent in the layer's own work (socket calls, TLS records, WebSocket frames), excluding the
+       layers below and above; only measured when built with XIO_STATS_TIMING, 0 otherwise */
+    uint64_t time_us;
+} XIO_STATS;
+
+/* the next_deadline_us of xio_dowork_ex when no layer of the IO stack waits for a time */
+#define XIO_NO_DEADLINE UINT64_MAX
+
+/* the readiness an IO stack waits for on its pollable handle, see xio_get_pollable_handle */
+#define XIO_POLL_READABLE 0x01
+#define XIO_POLL_WRITABLE 0x02
+
 typedef void(*ON_BYTES_RECEIVED)(void* context, const unsigned char* buffer, size_t size);
 typedef void(*ON_SEND_COMPLETE)(void* context, IO_SEND_RESULT send_result);
 typedef void(*ON_IO_OPEN_COMPLETE)(void* context, IO_OPEN_RESULT open_result);
@@ -47,6 +87,12 @@ typedef int(*IO_CLOSE)(CONCRETE_IO_HANDLE concrete_io, ON_IO_CLOSE_COMPLETE on_i
 typedef int(*IO_SEND)(CONCRETE_IO_HANDLE concrete_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context);
 typedef void(*IO_DOWORK)(CONCRETE_IO_HANDLE concrete_io);
 typedef int(*IO_SETOPTION)(CONCRETE_IO_HANDLE concrete_io, const char* optionName, const void* value);
+typedef int(*IO_SENDV)(CONCRETE_IO_HANDLE concrete_io, const XIO_BUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* callback_context);
+typedef int(*IO_SEND_CONSTBUFFER_ARRAY)(CONCRETE_IO_HANDLE concrete_io, CONSTBUFFER_ARRAY_HANDLE constbuffer_array, ON_SEND_COMPLETE on_send_complete, void* callback_context);
+typedef int(*IO_GET_STATS)(CONCRETE_IO_HANDLE concrete_io, XIO_STATS* stats, size_t stats_count, size_t* layer_count);
+typedef int(*IO_DOWORK_EX)(CONCRETE_IO_HANDLE concrete_io, bool* made_progress, uint64_t* next_deadline_us);
+typedef int(*IO_GET_POLLABLE_HANDLE)(CONCRETE_IO_HANDLE concrete_io, intptr_t* pollable_handle, unsigned int* wanted_events);
+typedef int(*IO_SET_RECEIVE_BUFFER)(CONCRETE_IO_HANDLE concrete_io, unsigned char* buffer, size_t size);
 
 
 typedef struct IO_INTERFACE_DESCRIPTION_TAG
@@ -59,6 +105,18 @@ typedef struct IO_INTERFACE_DESCRIPTION_TAG
     IO_SEND concrete_io_send;
     IO_DOWORK concrete_io_dowork;
     IO_SETOPTION concrete_io_setoption;
+    /* optional, may be NULL: xio_sendv coalesces the buffers and uses concrete_io_send instead */
+    IO_SENDV concrete_io_sendv;
+    /* optional, may be NULL: xio_send_constbuffer_array holds a reference on the array and uses xio_sendv instead */
+    IO_SEND_CONSTBUFFER_ARRAY concrete_io_send_constbuffer_array;
+    /* optional, may be NULL: xio_get_stats fails for concrete IOs that do not keep counters */
+    IO_GET_STATS concrete_io_get_stats;
+    /* optional, may be NULL: xio_dowork_ex uses concrete_io_dowork instead and reports that progress was made */
+    IO_DOWORK_EX concrete_io_dowork_ex;
+    /* optional, may be NULL: xio_get_pollable_handle fails for concrete IOs that are not backed by a socket */
+    IO_GET_POLLABLE_HANDLE concrete_io_get_pollable_handle;
+    /* optional, may be NULL: xio_set_receive_buffer fails and the received bytes are indicated from the buffers of the concrete IO */
+    IO_SET_RECEIVE_BUFFER concrete_io_set_receive_buffer;
 } IO_INTERFACE_DESCRIPTION;
 
 MOCKABLE_FUNCTION(, XIO_HANDLE, xio_create, const IO_INTERFACE_DESCRIPTION*, io_interface_description, const void*, io_create_parameters);
@@ -66,9 +124,34 @@ MOCKABLE_FUNCTION(, void, xio_destroy, XIO_HANDLE, xio);
 MOCKABLE_FUNCTION(, int, xio_open, XIO_HANDLE, xio, ON_IO_OPEN_COMPLETE, on_io_open_complete, void*, on_io_open_complete_context, ON_BYTES_RECEIVED, on_bytes_received, void*, on_bytes_received_context, ON_IO_ERROR, on_io_error, void*, on_io_error_context);
 MOCKABLE_FUNCTION(, int, xio_close, XIO_HANDLE, xio, ON_IO_CLOSE_COMPLETE, on_io_close_complete, void*, callback_context);
 MOCKABLE_FUNCTION(, int, xio_send, XIO_HANDLE, xio, const void*, buffer, size_t, size, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
+MOCKABLE_FUNCTION(, int, xio_sendv, XIO_HANDLE, xio, const XIO_BUFFER*, buffers, size_t, buffer_count, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
+MOCKABLE_FUNCTION(, int, xio_send_constbuffer_array, XIO_HANDLE, xio, CONSTBUFFER_ARRAY_HANDLE, constbuffer_array, ON_SEND_COMPLETE, on_send_complete, void*, callback_context);
 MOCKABLE_FUNCTION(, void, xio_dowork, XIO_HANDLE, xio);
+
+/* xio_dowork that tells whether the pass moved bytes or made a callback to the layer above, in any layer of the stack, and the
+   earliest time (tickcounter_get_monotonic_us clock) at which a layer has work to do whatever the socket does, XIO_NO_DEADLINE if none.
+   When no progress was made the caller can wait for the socket (e.g. through a socket reactor) or for the deadline before the next call. */
+MOCKABLE_FUNCTION(, int, xio_dowork_ex, XIO_HANDLE, xio, bool*, made_progress, uint64_t*, next_deadline_us);
 MOCKABLE_FUNCTION(, int, xio_setoption, XIO_HANDLE, xio, const char*, optionName, const void*, value);
 MOCKABLE_FUNCTION(, OPTIONHANDLER_HANDLE, xio_retrieveoptions, XIO_HANDLE, xio);
+MOCKABLE_FUNCTION(, int, xio_get_stats, XIO_HANDLE, xio, XIO_STATS*, stats, size_t, stats_count, size_t*, layer_count);
+
+/* gives the socket (file descriptor or SOCKET) at the bottom of the IO stack and the XIO_POLL_* readiness the stack waits for on it,
+   for callers running their own poll loop instead of a socket reactor. A layer may hold bytes it already read: a connection whose
+   last xio_dowork_ex made progress is to be worked again before waiting for its handle. */
+MOCKABLE_FUNCTION(, int, xio_get_pollable_handle, XIO_HANDLE, xio, intptr_t*, pollable_handle, unsigned int*, wanted_events);
+
+/* lends the IO the memory its next read (recv, SSL_read) is to write up to size received bytes to, so that the layer above owning
+   the memory finds them in place: on_bytes_received is then called with buffer, and the layer above does not copy them. The memory
+   is used for one read that returns bytes and forgotten, the layer above lends it again once it has taken the bytes, typically at the end of its
+   on_bytes_received, and lends NULL (with a size of 0) before moving or freeing it outside of the callbacks of the IO. Closing the IO
+   forgets it too. An IO may still indicate bytes from its own buffers, while it coalesces received bytes for instance. */
+MOCKABLE_FUNCTION(, int, xio_set_receive_buffer, XIO_HANDLE, xio, unsigned char*, buffer, size_t, size);
+
+#ifdef XIO_STATS_TIMING
+/* the clock of XIO_STATS::time_us, in microseconds */
+MOCKABLE_FUNCTION(, uint64_t, xio_stats_get_time_us);
+#endif
 
 #ifdef __cplusplus
 }
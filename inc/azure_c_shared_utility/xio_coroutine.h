@@ -0,0 +1,434 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef XIO_COROUTINE_H
+#define XIO_COROUTINE_H
+
+/* C++20 coroutine awaitables over an XIO_HANDLE, header only.
+
+   An xio_coroutine_io wraps an IO created with xio_create, which stays owned by the caller. Its open, send, close and
+   receive return awaitables that live in the frame of the awaiting coroutine and are the context of the callback of
+   the operation, so an operation allocates nothing. The coroutine is resumed from the callback, that is from
+   xio_dowork, or at once when the IO fails the call or completes it before returning.
+
+   The bytes a receive resumes with are not copied when a receive is waiting for them: they are valid until the
+   coroutine suspends again. Bytes that arrive while no receive is waiting are kept in a BUFFER until the next
+   receive, which gets all of them at once. A receive resumes with error set once the IO reported an error or was
+   closed, after the bytes received before that.
+
+   The awaitables can be used from any coroutine type. xio_coroutine_task is a minimal one that starts at once, and
+   xio_coroutine_run calls the dowork of an IO until a task is done. Nothing here is thread safe: the IO is used from
+   the thread that calls its dowork, and it must not be destroyed from within a coroutine resumed by one of its
+   callbacks. */
+
+#ifndef __cplusplus
+#error "xio_coroutine.h is a C++20 header"
+#endif
+
+#include <coroutine>
+#include <exception>
+#include <cstddef>
+#include <cstdint>
+
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+/* the bytes a receive resumes with */
+struct xio_coroutine_bytes
+{
+    const unsigned char* bytes;
+    size_t size;
+    /* the IO reported an error or was closed, there are no more bytes */
+    bool error;
+};
+
+/* the state shared by the awaitables: a callback that comes before the IO call returns does not resume the
+   coroutine, await_suspend lets it go on instead */
+template <typename RESULT>
+class xio_coroutine_operation
+{
+public:
+    xio_coroutine_operation(const xio_coroutine_operation&) = delete;
+    xio_coroutine_operation& operator=(const xio_coroutine_operation&) = delete;
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    RESULT await_resume() const noexcept
+    {
+        return result;
+    }
+
+protected:
+    explicit xio_coroutine_operation(XIO_HANDLE xio) noexcept
+        : xio(xio), result(), in_call(false), completed(false)
+    {
+    }
+
+    /* start is the IO call, failure the result when it fails */
+    template <typename START>
+    bool suspend(std::coroutine_handle<> coroutine, START start, RESULT failure) noexcept
+    {
+        waiter = coroutine;
+        in_call = true;
+        if (start() != 0)
+        {
+            result = failure;
+            completed = true;
+        }
+        in_call = false;
+        return !completed;
+    }
+
+    void complete(RESULT operation_result) noexcept
+    {
+        result = operation_result;
+        completed = true;
+        if (!in_call)
+        {
+            waiter.resume();
+        }
+    }
+
+    XIO_HANDLE xio;
+
+private:
+    RESULT result;
+    std::coroutine_handle<> waiter;
+    bool in_call;
+    bool completed;
+};
+
+class xio_coroutine_io
+{
+public:
+    explicit xio_coroutine_io(XIO_HANDLE xio) noexcept
+        : xio(xio), backlog(NULL), backlog_consumed(false), has_error(false), receiver(NULL)
+    {
+    }
+
+    ~xio_coroutine_io()
+    {
+        if (backlog != NULL)
+        {
+            BUFFER_delete(backlog);
+        }
+    }
+
+    xio_coroutine_io(const xio_coroutine_io&) = delete;
+    xio_coroutine_io& operator=(const xio_coroutine_io&) = delete;
+
+    class open_awaitable : public xio_coroutine_operation<IO_OPEN_RESULT>
+    {
+    public:
+        explicit open_awaitable(xio_coroutine_io& io) noexcept
+            : xio_coroutine_operation<IO_OPEN_RESULT>(io.xio), io(io)
+        {
+        }
+
+        bool await_suspend(std::coroutine_handle<> coroutine) noexcept
+        {
+            io.has_error = false;
+            return suspend(coroutine, [this]() { return xio_open(xio, on_open_complete, this, on_bytes_received, &io, on_io_error, &io); }, IO_OPEN_ERROR);
+        }
+
+    private:
+        static void on_open_complete(void* context, IO_OPEN_RESULT open_result)
+        {
+            static_cast<open_awaitable*>(context)->complete(open_result);
+        }
+
+        xio_coroutine_io& io;
+    };
+
+    class send_awaitable : public xio_coroutine_operation<IO_SEND_RESULT>
+    {
+    public:
+        /* the IOs copy what they cannot send at once, so buffer only needs to be valid for the xio_send call */
+        send_awaitable(XIO_HANDLE xio, const void* buffer, size_t size) noexcept
+            : xio_coroutine_operation<IO_SEND_RESULT>(xio), buffer(buffer), size(size)
+        {
+        }
+
+        bool await_suspend(std::coroutine_handle<> coroutine) noexcept
+        {
+            return suspend(coroutine, [this]() { return xio_send(xio, buffer, size, on_send_complete, this); }, IO_SEND_ERROR);
+        }
+
+    private:
+        static void on_send_complete(void* context, IO_SEND_RESULT send_result)
+        {
+            static_cast<send_awaitable*>(context)->complete(send_result);
+        }
+
+        const void* buffer;
+        size_t size;
+    };
+
+    /* resumes with 0 once the IO is closed, a non-zero value if xio_close failed */
+    class close_awaitable : public xio_coroutine_operation<int>
+    {
+    public:
+        explicit close_awaitable(xio_coroutine_io& io) noexcept
+            : xio_coroutine_operation<int>(io.xio), io(io)
+        {
+        }
+
+        bool await_suspend(std::coroutine_handle<> coroutine) noexcept
+        {
+            return suspend(coroutine, [this]() { return xio_close(xio, on_close_complete, this); }, 1);
+        }
+
+    private:
+        static void on_close_complete(void* context)
+        {
+            close_awaitable* awaitable = static_cast<close_awaitable*>(context);
+            awaitable->io.fail_receiver();
+            awaitable->complete(0);
+        }
+
+        xio_coroutine_io& io;
+    };
+
+    class receive_awaitable
+    {
+    public:
+        explicit receive_awaitable(xio_coroutine_io& io) noexcept
+            : io(io), waiter(), received{ NULL, 0, false }
+        {
+        }
+
+        receive_awaitable(const receive_awaitable&) = delete;
+        receive_awaitable& operator=(const receive_awaitable&) = delete;
+
+        bool await_ready() const noexcept
+        {
+            return (io.backlog_size() > 0) || io.has_error;
+        }
+
+        void await_suspend(std::coroutine_handle<> coroutine) noexcept
+        {
+            waiter = coroutine;
+            io.receiver = this;
+        }
+
+        xio_coroutine_bytes await_resume() noexcept
+        {
+            if (waiter)
+            {
+                /* resumed by a callback, which filled received */
+            }
+            else if (io.backlog_size() > 0)
+            {
+                received.bytes = BUFFER_u_char(io.backlog);
+                received.size = BUFFER_length(io.backlog);
+                received.error = false;
+                io.backlog_consumed = true;
+            }
+            else
+            {
+                received.error = true;
+            }
+            return received;
+        }
+
+    private:
+        friend class xio_coroutine_io;
+
+        void complete(const unsigned char* bytes, size_t size, bool error) noexcept
+        {
+            received.bytes = bytes;
+            received.size = size;
+            received.error = error;
+            waiter.resume();
+        }
+
+        xio_coroutine_io& io;
+        std::coroutine_handle<> waiter;
+        xio_coroutine_bytes received;
+    };
+
+    open_awaitable open() noexcept
+    {
+        return open_awaitable(*this);
+    }
+
+    send_awaitable send(const void* buffer, size_t size) noexcept
+    {
+        return send_awaitable(xio, buffer, size);
+    }
+
+    close_awaitable close() noexcept
+    {
+        return close_awaitable(*this);
+    }
+
+    /* only one receive can wait at a time */
+    receive_awaitable receive() noexcept
+    {
+        return receive_awaitable(*this);
+    }
+
+    void dowork() noexcept
+    {
+        xio_dowork(xio);
+    }
+
+    XIO_HANDLE handle() const noexcept
+    {
+        return xio;
+    }
+
+private:
+    /* the bytes a receive got from the backlog are only valid until the coroutine suspends again, the next bytes
+       then replace them and reuse the memory */
+    size_t backlog_size() const noexcept
+    {
+        return ((backlog == NULL) || backlog_consumed) ? 0 : BUFFER_length(backlog);
+    }
+
+    void fail_receiver() noexcept
+    {
+        has_error = true;
+        if (receiver != NULL)
+        {
+            receive_awaitable* waiting = receiver;
+            receiver = NULL;
+            waiting->complete(NULL, 0, true);
+        }
+    }
+
+    static void on_bytes_received(void* context, const unsigned char* buffer, size_t size)
+    {
+        xio_coroutine_io* io = static_cast<xio_coroutine_io*>(context);
+
+        if (io->receiver != NULL)
+        {
+            /* the bytes are handed over without a copy, they stay valid while the coroutine runs from here */
+            receive_awaitable* waiting = io->receiver;
+            io->receiver = NULL;
+            waiting->complete(buffer, size, false);
+        }
+        else
+        {
+            int result;
+
+            if ((io->backlog == NULL) && ((io->backlog = BUFFER_new()) == NULL))
+            {
+                result = __FAILURE__;
+            }
+            else if (io->backlog_consumed)
+            {
+                result = BUFFER_build(io->backlog, buffer, size);
+                io->backlog_consumed = false;
+            }
+            else
+            {
+                result = BUFFER_append_build(io->backlog, buffer, size);
+            }
+
+            if (result != 0)
+            {
+                LogError("Cannot keep %lu received bytes", (unsigned long)size);
+                io->has_error = true;
+            }
+        }
+    }
+
+    static void on_io_error(void* context)
+    {
+        static_cast<xio_coroutine_io*>(context)->fail_receiver();
+    }
+
+    XIO_HANDLE xio;
+    BUFFER_HANDLE backlog;
+    bool backlog_consumed;
+    bool has_error;
+    receive_awaitable* receiver;
+};
+
+/* a coroutine that starts at once and keeps its frame until it is destroyed, so that done can be polled */
+class xio_coroutine_task
+{
+public:
+    struct promise_type
+    {
+        xio_coroutine_task get_return_object() noexcept
+        {
+            return xio_coroutine_task(std::coroutine_handle<promise_type>::from_promise(*this));
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void() noexcept
+        {
+        }
+
+        /* the task is resumed from C callbacks, which an exception must not go through */
+        void unhandled_exception() noexcept
+        {
+            std::terminate();
+        }
+    };
+
+    explicit xio_coroutine_task(std::coroutine_handle<promise_type> coroutine) noexcept
+        : coroutine(coroutine)
+    {
+    }
+
+    xio_coroutine_task(xio_coroutine_task&& other) noexcept
+        : coroutine(other.coroutine)
+    {
+        other.coroutine = nullptr;
+    }
+
+    xio_coroutine_task(const xio_coroutine_task&) = delete;
+    xio_coroutine_task& operator=(const xio_coroutine_task&) = delete;
+    xio_coroutine_task& operator=(xio_coroutine_task&&) = delete;
+
+    ~xio_coroutine_task()
+    {
+        if (coroutine)
+        {
+            coroutine.destroy();
+        }
+    }
+
+    bool done() const noexcept
+    {
+        return !coroutine || coroutine.done();
+    }
+
+private:
+    std::coroutine_handle<promise_type> coroutine;
+};
+
+/* calls the dowork of io until task is done, sleeping a millisecond after the passes that made no progress */
+inline void xio_coroutine_run(xio_coroutine_io& io, const xio_coroutine_task& task)
+{
+    while (!task.done())
+    {
+        bool made_progress;
+        uint64_t next_deadline_us;
+
+        if ((xio_dowork_ex(io.handle(), &made_progress, &next_deadline_us) != 0) || !made_progress)
+        {
+            ThreadAPI_Sleep(1);
+        }
+    }
+}
+
+#endif /* XIO_COROUTINE_H */
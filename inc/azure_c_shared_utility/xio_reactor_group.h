@@ -0,0 +1,131 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file xio_reactor_group.h
+ *    @brief     A set of reactor threads, each owning the IO stacks placed on it.
+ *
+ *    @details Every reactor of the group is one thread with its own socket reactor. A
+ *             connection (an ::XIO_HANDLE) added to the group is placed on the least loaded
+ *             reactor, whose thread from then on is the only one calling xio_dowork_ex on it
+ *             and the one all of its callbacks run on. The connection's work never takes a
+ *             lock shared with the other reactors.
+ *
+ *             Other threads reach a connection through ::xio_reactor_group_call, which runs
+ *             a function on the thread owning it, for instance to open it or to send on it.
+ *             The requests for a connection run in the order they were made, and keep that
+ *             order across a ::xio_reactor_group_migrate moving it to another reactor.
+ *
+ *             The bottom socket IO of the connection is put on the socket reactor of its
+ *             reactor with OPTION_SOCKET_REACTOR. An IO stack that does not take the option
+ *             (no socket at the bottom, or socketio_win32 once opened) is polled instead.
+ */
+
+#ifndef XIO_REACTOR_GROUP_H
+#define XIO_REACTOR_GROUP_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#else
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct XIO_REACTOR_GROUP_TAG* XIO_REACTOR_GROUP_HANDLE;
+typedef struct XIO_REACTOR_CONNECTION_TAG* XIO_REACTOR_CONNECTION_HANDLE;
+
+/** @brief Runs on the reactor thread owning the connection, with the connection's IO stack. */
+typedef void(*ON_XIO_REACTOR_CALL)(void* context, XIO_HANDLE xio);
+
+typedef struct XIO_REACTOR_GROUP_CONFIG_TAG
+{
+    /* the number of reactors, 0 creates one per processor */
+    size_t reactor_count;
+    /* pins reactor i to processor i modulo the processor count, where the platform supports it */
+    bool pin_reactors;
+} XIO_REACTOR_GROUP_CONFIG;
+
+typedef struct XIO_REACTOR_LOAD_TAG
+{
+    /* the connections placed on or moving to the reactor */
+    size_t connection_count;
+    /* the share of the last second the reactor thread spent working its connections */
+    unsigned int busy_percent;
+} XIO_REACTOR_LOAD;
+
+/**
+ * @brief    Creates the group and starts its reactor threads.
+ *
+ * @param    config    The group configuration, or @c NULL for one unpinned reactor per processor.
+ *
+ * @return    A valid @c XIO_REACTOR_GROUP_HANDLE when successful or @c NULL otherwise.
+ */
+MOCKABLE_FUNCTION(, XIO_REACTOR_GROUP_HANDLE, xio_reactor_group_create, const XIO_REACTOR_GROUP_CONFIG*, config);
+
+/**
+ * @brief    Runs the requests already made, stops the reactor threads and frees the group.
+ *             Connections still in the group are taken off their socket reactor and left
+ *             to the caller, who may destroy them. Must not be called from a reactor thread.
+ */
+MOCKABLE_FUNCTION(, void, xio_reactor_group_destroy, XIO_REACTOR_GROUP_HANDLE, group);
+
+/**
+ * @brief    Places @p xio on the reactor with the fewest connections, the least busy one
+ *             among those. From then on @p xio may only be used on that reactor's thread.
+ *
+ * @param    on_added    Optional, called on the reactor thread once @p xio is on it.
+ *
+ * @return    The connection, valid until ::xio_reactor_group_remove, or @c NULL on failure.
+ */
+MOCKABLE_FUNCTION(, XIO_REACTOR_CONNECTION_HANDLE, xio_reactor_group_add, XIO_REACTOR_GROUP_HANDLE, group, XIO_HANDLE, xio, ON_XIO_REACTOR_CALL, on_added, void*, on_added_context);
+
+/**
+ * @brief    Takes the connection out of the group. The connection handle must not be used
+ *             after this call; once @p on_removed ran the IO stack belongs to the caller again.
+ *
+ * @param    on_removed    Optional, called on the reactor thread after the IO stack left the
+ *                         reactor, for instance to close or destroy it.
+ *
+ * @return    0 on success, a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, xio_reactor_group_remove, XIO_REACTOR_CONNECTION_HANDLE, connection, ON_XIO_REACTOR_CALL, on_removed, void*, on_removed_context);
+
+/**
+ * @brief    Runs @p on_call on the reactor thread owning the connection. May be called from
+ *             any thread, including from a callback of this or another connection.
+ *
+ * @return    0 on success, a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, xio_reactor_group_call, XIO_REACTOR_CONNECTION_HANDLE, connection, ON_XIO_REACTOR_CALL, on_call, void*, on_call_context);
+
+/**
+ * @brief    Moves the connection to the reactor @p reactor_index, after the requests made
+ *             before for it ran on its current reactor.
+ *
+ * @return    0 on success, a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, xio_reactor_group_migrate, XIO_REACTOR_CONNECTION_HANDLE, connection, size_t, reactor_index);
+
+/**
+ * @brief    Returns the number of reactors of the group, 0 if @p group is @c NULL.
+ */
+MOCKABLE_FUNCTION(, size_t, xio_reactor_group_get_reactor_count, XIO_REACTOR_GROUP_HANDLE, group);
+
+/**
+ * @brief    Gives the load of the reactor @p reactor_index, to decide on migrations.
+ *
+ * @return    0 on success, a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, xio_reactor_group_get_load, XIO_REACTOR_GROUP_HANDLE, group, size_t, reactor_index, XIO_REACTOR_LOAD*, load);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XIO_REACTOR_GROUP_H */
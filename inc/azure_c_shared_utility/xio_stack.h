@@ -0,0 +1,45 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifndef XIO_STACK_H
+#define XIO_STACK_H
+
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#include <cstddef>
+#else
+#include <stddef.h>
+#endif /* __cplusplus */
+
+/* The layers of a connection, from the socket up: the socket IO, an optional HTTP proxy tunnel, an optional TLS IO and
+   an optional WebSocket IO. xio_stack_create creates them all and returns the top one; xio_destroy of it destroys the stack.
+   Stacks of any other shape are built as before, by giving each layer the interface and parameters of the one below. */
+typedef struct XIO_STACK_CONFIG_TAG
+{
+    const char* hostname;
+    int port;
+    /* the HTTP proxy tunnelled through, NULL for a direct connection */
+    const char* proxy_hostname;
+    int proxy_port;
+    const char* proxy_username;
+    const char* proxy_password;
+    /* the TLS IO, such as platform_get_default_tlsio(), NULL for a plain connection */
+    const IO_INTERFACE_DESCRIPTION* tlsio_interface;
+    /* the WebSocket resource and protocol, NULL ws_resource_name for no WebSocket layer */
+    const char* ws_resource_name;
+    const char* ws_protocol;
+} XIO_STACK_CONFIG;
+
+/* Besides creating the layers, xio_stack_create sets the options that make the layers hand bytes to each other in
+   fewer calls where it knows them, that is for a TLS IO under a WebSocket IO and for the socket IO at the bottom.
+   An option a layer does not support is left unset. */
+MOCKABLE_FUNCTION(, XIO_HANDLE, xio_stack_create, const XIO_STACK_CONFIG*, config);
+
+#ifdef __cplusplus
+}
+#endif /* __cplusplus */
+
+#endif /* XIO_STACK_H */
@@ -0,0 +1,179 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file xio_trace.h
+ *    @brief     Begin and end events for the sends going through an IO stack, to attribute the
+ *               latency of one message to the layers it crosses.
+ *
+ *    @details When built with @c XIO_TRACE (CMake option use_xio_trace), ::xio_send,
+ *             ::xio_sendv and ::xio_send_constbuffer_array give each send a span, an event
+ *             when the layer is handed the send and another one when the layer calls its
+ *             @c ON_SEND_COMPLETE, and uws_client does the same for its frames. A span started
+ *             while the layer above is sending (the layer sends what it was given before
+ *             returning) is a child of the span of the layer above and carries its
+ *             correlation id, so all the spans of one message share the correlation id of the
+ *             outermost send. A layer that sends later, from its dowork, makes the span of the
+ *             queued send current around that send with ::xio_trace_enter; a send made of
+ *             several coalesced messages carries the correlation id of the first one.
+ *
+ *             The events go to the sink set with ::xio_trace_set_sink, from the thread that
+ *             makes the send or the callback. While no sink is set a hook costs one predicted
+ *             branch; built without @c XIO_TRACE the hooks are not compiled at all.
+ *
+ *             Two sinks come with the module: the ring of ::xio_trace_ring_create, which keeps
+ *             the events without a lock for a reader to pick them up later, and the span
+ *             builder of xio_trace_otel.h.
+ */
+
+#ifndef XIO_TRACE_H
+#define XIO_TRACE_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+#include "azure_c_shared_utility/macro_utils.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define XIO_TRACE_EVENT_TYPE_VALUES \
+    XIO_TRACE_EVENT_BEGIN, \
+    XIO_TRACE_EVENT_END
+
+DEFINE_ENUM(XIO_TRACE_EVENT_TYPE, XIO_TRACE_EVENT_TYPE_VALUES);
+
+/** @brief The identity of a span. A @c span_id of 0 is a span that is not traced, the events of
+ *         the hooks are only made for the other ones. */
+typedef struct XIO_TRACE_SPAN_TAG
+{
+    /* the span_id of the outermost span of the message */
+    uint64_t correlation_id;
+    uint64_t span_id;
+    /* 0 for the outermost span */
+    uint64_t parent_span_id;
+} XIO_TRACE_SPAN;
+
+typedef struct XIO_TRACE_EVENT_TAG
+{
+    XIO_TRACE_EVENT_TYPE type;
+    XIO_TRACE_SPAN span;
+    /* the XIO_STATS layer_name of the layer, a string literal */
+    const char* layer_name;
+    /* "send", "sendv", "send_constbuffer_array" or "send_frame" */
+    const char* operation;
+    /* tickcounter_get_monotonic_us clock */
+    uint64_t time_us;
+    /* XIO_TRACE_EVENT_BEGIN: the bytes handed to the layer */
+    uint64_t size;
+    /* XIO_TRACE_EVENT_END: the IO_SEND_RESULT or WS_SEND_FRAME_RESULT, 0 when the send succeeded */
+    int result;
+} XIO_TRACE_EVENT;
+
+/** @brief Called with each event, from the thread of the send or of the callback; it must not
+ *         send on an IO. */
+typedef void(*XIO_TRACE_SINK)(void* context, const XIO_TRACE_EVENT* event);
+
+typedef struct XIO_TRACE_RING_TAG* XIO_TRACE_RING_HANDLE;
+
+/* non-zero while a sink is set, read by the hooks */
+extern volatile long xio_trace_enabled;
+
+#ifdef XIO_TRACE
+#define XIO_TRACE_IS_ENABLED() (xio_trace_enabled != 0)
+
+#define XIO_TRACE_BEGIN(span, layer_name, operation, size) \
+    do { if (XIO_TRACE_IS_ENABLED()) { xio_trace_begin((span), (layer_name), (operation), (size)); } else { (span)->span_id = 0; } } while (0)
+
+#define XIO_TRACE_END(span, layer_name, operation, result) \
+    do { if ((span)->span_id != 0) { xio_trace_end((span), (layer_name), (operation), (result)); } } while (0)
+
+/* previous is an XIO_TRACE_SPAN that keeps the span that was current */
+#define XIO_TRACE_ENTER(span, previous) \
+    do { if ((span)->span_id != 0) { (previous) = xio_trace_enter(span); } } while (0)
+
+#define XIO_TRACE_LEAVE(span, previous) \
+    do { if ((span)->span_id != 0) { xio_trace_leave(previous); } } while (0)
+#else
+#define XIO_TRACE_IS_ENABLED() 0
+#define XIO_TRACE_BEGIN(span, layer_name, operation, size)
+#define XIO_TRACE_END(span, layer_name, operation, result)
+#define XIO_TRACE_ENTER(span, previous)
+#define XIO_TRACE_LEAVE(span, previous)
+#endif
+
+/**
+ * @brief    Sets the sink the events go to, @c NULL to stop tracing. Only to be called while no
+ *           IO sends: a send that started while a sink was set may end with the next one.
+ *
+ * @return   0 on success, a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, xio_trace_set_sink, XIO_TRACE_SINK, sink, void*, sink_context);
+
+/**
+ * @brief    Starts span as a child of the span current on the thread, or as the outermost span
+ *           of a new message, and makes its begin event. Use through ::XIO_TRACE_BEGIN.
+ */
+MOCKABLE_FUNCTION(, void, xio_trace_begin, XIO_TRACE_SPAN*, span, const char*, layer_name, const char*, operation, uint64_t, size);
+
+/**
+ * @brief    Makes the end event of span. Use through ::XIO_TRACE_END.
+ */
+MOCKABLE_FUNCTION(, void, xio_trace_end, const XIO_TRACE_SPAN*, span, const char*, layer_name, const char*, operation, int, result);
+
+/**
+ * @brief    Makes span the current span of the thread, so that the spans begun until
+ *           ::xio_trace_leave are its children.
+ *
+ * @return   The span that was current, to give to ::xio_trace_leave.
+ */
+MOCKABLE_FUNCTION(, XIO_TRACE_SPAN, xio_trace_enter, const XIO_TRACE_SPAN*, span);
+
+/**
+ * @brief    Makes previous, returned by ::xio_trace_enter, the current span of the thread again.
+ */
+MOCKABLE_FUNCTION(, void, xio_trace_leave, XIO_TRACE_SPAN, previous);
+
+/**
+ * @brief    Creates a ring of event_count events, rounded up to a power of 2, 0 for 4096.
+ *           Install it with @c xio_trace_set_sink(xio_trace_ring_sink, ring).
+ *
+ * @return   A valid @c XIO_TRACE_RING_HANDLE when successful or @c NULL otherwise.
+ */
+MOCKABLE_FUNCTION(, XIO_TRACE_RING_HANDLE, xio_trace_ring_create, size_t, event_count);
+
+/**
+ * @brief    Frees the ring, which must not be the sink anymore.
+ */
+MOCKABLE_FUNCTION(, void, xio_trace_ring_destroy, XIO_TRACE_RING_HANDLE, ring);
+
+/**
+ * @brief    The ::XIO_TRACE_SINK of a ring, its context being the ring. Claims a slot of the
+ *           ring with a compare-and-swap, the event is dropped and counted when the ring is full.
+ */
+extern void xio_trace_ring_sink(void* context, const XIO_TRACE_EVENT* event);
+
+/**
+ * @brief    Takes up to event_count events out of the ring, oldest first. Only one thread at a
+ *           time may read a ring.
+ *
+ * @return   0 on success (read_count may be 0), a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, xio_trace_ring_read, XIO_TRACE_RING_HANDLE, ring, XIO_TRACE_EVENT*, events, size_t, event_count, size_t*, read_count);
+
+/**
+ * @brief    Returns the number of events dropped because the ring was full.
+ */
+MOCKABLE_FUNCTION(, uint64_t, xio_trace_ring_get_dropped_count, XIO_TRACE_RING_HANDLE, ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XIO_TRACE_H */
@@ -0,0 +1,109 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/** @file xio_trace_otel.h
+ *    @brief     Turns the events of xio_trace.h into spans of the OpenTelemetry trace data model.
+ *
+ *    @details A span builder pairs the begin and end events of each span and hands the
+ *             finished span to a callback, with the trace id, span id and parent span id that
+ *             an OpenTelemetry exporter expects: the trace id is made of a random prefix drawn
+ *             when the builder is created and of the correlation id, so all the spans of one
+ *             message are one trace. ::xio_trace_otel_format_span writes a span as an OTLP/JSON
+ *             Span object.
+ *
+ *             The builder is either the sink itself (::xio_trace_otel_sink, which takes a lock)
+ *             or is fed the events read from a ring with ::xio_trace_otel_add_events, off the
+ *             threads that send.
+ *
+ *             The open spans are kept in a table indexed by span id: a begin whose entry is
+ *             taken by a span that is still open, and an end without a begin, are dropped and
+ *             counted. Span times are the monotonic times of the events moved to the
+ *             UNIX epoch with the offset read when the builder was created.
+ */
+
+#ifndef XIO_TRACE_OTEL_H
+#define XIO_TRACE_OTEL_H
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#endif
+
+#include "azure_c_shared_utility/xio_trace.h"
+#include "azure_c_shared_utility/umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct XIO_TRACE_OTEL_TAG* XIO_TRACE_OTEL_HANDLE;
+
+typedef struct XIO_TRACE_OTEL_SPAN_TAG
+{
+    uint8_t trace_id[16];
+    uint8_t span_id[8];
+    /* all zeros for the outermost span of a message */
+    uint8_t parent_span_id[8];
+    const char* layer_name;
+    const char* operation;
+    uint64_t start_time_unix_nano;
+    uint64_t end_time_unix_nano;
+    uint64_t size;
+    /* the result of the end event, 0 when the send succeeded */
+    int result;
+} XIO_TRACE_OTEL_SPAN;
+
+/** @brief Called with each finished span, outside of the lock of the builder. */
+typedef void(*ON_XIO_TRACE_OTEL_SPAN)(void* context, const XIO_TRACE_OTEL_SPAN* span);
+
+/**
+ * @brief    Creates a span builder that keeps up to max_open_spans spans open, rounded up to a
+ *           power of 2, 0 for 1024.
+ *
+ * @return   A valid @c XIO_TRACE_OTEL_HANDLE when successful or @c NULL otherwise.
+ */
+MOCKABLE_FUNCTION(, XIO_TRACE_OTEL_HANDLE, xio_trace_otel_create, size_t, max_open_spans, ON_XIO_TRACE_OTEL_SPAN, on_span, void*, on_span_context);
+
+/**
+ * @brief    Frees the span builder, which must not be the sink anymore. The spans still open are
+ *           dropped.
+ */
+MOCKABLE_FUNCTION(, void, xio_trace_otel_destroy, XIO_TRACE_OTEL_HANDLE, otel);
+
+/**
+ * @brief    The ::XIO_TRACE_SINK of a span builder, its context being the builder. May be called
+ *           from any thread.
+ */
+extern void xio_trace_otel_sink(void* context, const XIO_TRACE_EVENT* event);
+
+/**
+ * @brief    Adds events, for instance read with ::xio_trace_ring_read, in the order they were made.
+ *
+ * @return   0 on success, a non-zero value otherwise.
+ */
+MOCKABLE_FUNCTION(, int, xio_trace_otel_add_events, XIO_TRACE_OTEL_HANDLE, otel, const XIO_TRACE_EVENT*, events, size_t, event_count);
+
+/**
+ * @brief    Returns the number of events dropped because the table of open spans was full or
+ *           the span of an end event was not open.
+ */
+MOCKABLE_FUNCTION(, uint64_t, xio_trace_otel_get_dropped_count, XIO_TRACE_OTEL_HANDLE, otel);
+
+/**
+ * @brief    Writes span as an OTLP/JSON Span object, with a @c '\0'.
+ *
+ * @param    written    Set to the length of the object, without the @c '\0', also when
+ *                      buffer_size is too small so that the caller can retry.
+ *
+ * @return   0 on success, a non-zero value otherwise (including when buffer_size is too small).
+ */
+MOCKABLE_FUNCTION(, int, xio_trace_otel_format_span, const XIO_TRACE_OTEL_SPAN*, span, char*, buffer, size_t, buffer_size, size_t*, written);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* XIO_TRACE_OTEL_H */
@@ -38,6 +38,16 @@ typedef enum LOG_CATEGORY_TAG
     AZ_LOG_TRACE
 } LOG_CATEGORY;
 
+/* LOG_LEVEL_MIN is the least severe category that is compiled in, the cmake option log_level_min sets it.
+   The LOG calls of less severe categories are removed, their arguments are not evaluated. */
+#define AZ_LOG_LEVEL_ERROR 0
+#define AZ_LOG_LEVEL_INFO 1
+#define AZ_LOG_LEVEL_TRACE 2
+
+#ifndef LOG_LEVEL_MIN
+#define LOG_LEVEL_MIN AZ_LOG_LEVEL_TRACE
+#endif
+
 #if defined _MSC_VER
 #define FUNC_NAME __FUNCDNAME__
 #else
@@ -61,6 +71,10 @@ typedef void(*LOGGER_LOG_GETLASTERROR)(const char* file, const char* func, int l
 #define LogError(...)
 #define xlogging_get_log_function() NULL
 #define xlogging_set_log_function(...)
+#define xlogging_get_log_level() AZ_LOG_ERROR
+#define xlogging_set_log_level(...)
+#define xlogging_get_log_binary_max_size() 0
+#define xlogging_set_log_binary_max_size(...)
 #define LogErrorWinHTTPWithGetLastErrorAsString(...)
 #define UNUSED(x) (void)(x)
 #elif (defined MINIMAL_LOGERROR)
@@ -70,6 +84,10 @@ typedef void(*LOGGER_LOG_GETLASTERROR)(const char* file, const char* func, int l
 #define LogError(...) printf("error %s: line %d\n",__FILE__,__LINE__);
 #define xlogging_get_log_function() NULL
 #define xlogging_set_log_function(...)
+#define xlogging_get_log_level() AZ_LOG_ERROR
+#define xlogging_set_log_level(...)
+#define xlogging_get_log_binary_max_size() 0
+#define xlogging_set_log_binary_max_size(...)
 #define LogErrorWinHTTPWithGetLastErrorAsString(...)
 #define UNUSED(x) (void)(x)
 
@@ -91,7 +109,9 @@ typedef void(*LOGGER_LOG_GETLASTERROR)(const char* file, const char* func, int l
 
 // In order to make sure that the compiler evaluates the arguments and issues an error if they do not conform to printf
 // specifications, we call printf with the format and __VA_ARGS__ but the call is behind an if (0) so that it does
-// not actually get executed at runtime
+// not actually get executed at runtime.
+// A category less severe than LOG_LEVEL_MIN makes the whole call dead code, and one less severe than the
+// level set with xlogging_set_log_level skips the call to the logger, so that nothing gets formatted.
 #if defined _MSC_VER
 // ignore warning C4127 
 #define LOG(log_category, log_options, format, ...) \
@@ -101,16 +121,18 @@ typedef void(*LOGGER_LOG_GETLASTERROR)(const char* file, const char* func, int l
     { \
         (void)printf(format, __VA_ARGS__); \
     } \
+    __pragma(warning(suppress: 4127)) \
+    if ((int)(log_category) <= LOG_LEVEL_MIN) \
     { \
         LOGGER_LOG l = xlogging_get_log_function(); \
-        if (l != NULL) \
+        if ((l != NULL) && ((int)(log_category) <= (int)xlogging_get_log_level())) \
         { \
             l(log_category, __FILE__, FUNC_NAME, __LINE__, log_options, format, __VA_ARGS__); \
         } \
     } \
 }
 #else
-#define LOG(log_category, log_options, format, ...) { if (0) { (void)printf(format, ##__VA_ARGS__); } { LOGGER_LOG l = xlogging_get_log_function(); if (l != NULL) l(log_category, __FILE__, FUNC_NAME, __LINE__, log_options, format, ##__VA_ARGS__); } }
+#define LOG(log_category, log_options, format, ...) { if (0) { (void)printf(format, ##__VA_ARGS__); } if ((int)(log_category) <= LOG_LEVEL_MIN) { LOGGER_LOG l = xlogging_get_log_function(); if ((l != NULL) && ((int)(log_category) <= (int)xlogging_get_log_level())) l(log_category, __FILE__, FUNC_NAME, __LINE__, log_options, format, ##__VA_ARGS__); } }
 #endif
 
 #if defined _MSC_VER
@@ -156,6 +178,14 @@ extern void LogBinary(const char* comment, const void* data, size_t size);
 extern void xlogging_set_log_function(LOGGER_LOG log_function);
 extern LOGGER_LOG xlogging_get_log_function(void);
 
+/* the least severe category that gets logged, AZ_LOG_TRACE (everything) by default */
+extern void xlogging_set_log_level(LOG_CATEGORY log_level);
+extern LOG_CATEGORY xlogging_get_log_level(void);
+
+/* the most bytes of its buffer LogBinary dumps before a truncation line, 0 (everything) by default */
+extern void xlogging_set_log_binary_max_size(size_t max_size);
+extern size_t xlogging_get_log_binary_max_size(void);
+
 #endif /* NOT ESP8266_RTOS */
 
 #ifdef __cplusplus
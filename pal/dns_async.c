@@ -1,16 +1,28 @@
 // Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
+// DNS_ASYNC_USE_GETADDRINFO_A selects the glibc getaddrinfo_a backend, which resolves in the
+// background instead of blocking in dns_async_is_lookup_complete. It needs _GNU_SOURCE before
+// the first system header and linking with -lanl.
+#if defined(DNS_ASYNC_USE_GETADDRINFO_A) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE
+#endif
 
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
+
+#ifdef DNS_ASYNC_USE_GETADDRINFO_A
+#include <pthread.h>
+#endif
 
 // This file is OS-specific, and is identified by setting include directories
 // in the project
 #include "socket_async_os.h"
 
 #include "dns_async.h"
+#include "azure_c_shared_utility/dns_cache.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/xlogging.h"
@@ -24,14 +36,200 @@
 #define EXTRACT_IPV4(ptr) ((struct sockaddr_in *) ptr->ai_addr)->sin_addr.s_addr
 #endif
 
-typedef struct
+#ifdef AF_INET6
+#define EXTRACT_IPV6(ptr) ((struct sockaddr_in6 *) ptr->ai_addr)->sin6_addr.s6_addr
+#endif
+
+typedef struct DNS_ASYNC_INSTANCE_TAG
 {
     char* hostname;
     uint32_t ip_v4;
+    unsigned char ip_v6[DNS_ASYNC_IPV6_ADDRESS_SIZE];
+    bool has_ip_v6;
     bool is_complete;
     bool is_failed;
+#ifdef DNS_ASYNC_USE_GETADDRINFO_A
+    struct addrinfo hints;
+    struct gaicb request;
+    struct DNS_ASYNC_INSTANCE_TAG* next_abandoned;
+#endif
 } DNS_ASYNC_INSTANCE;
 
+static void set_lookup_hints(struct addrinfo* hints)
+{
+    //--------------------------------
+    // Setup the hints address info structure
+    // which is passed to the getaddrinfo() function
+    memset(hints, 0, sizeof(*hints));
+#ifdef AF_INET6
+    hints->ai_family = AF_UNSPEC;
+#else
+    hints->ai_family = AF_INET;
+#endif
+    hints->ai_socktype = SOCK_STREAM;
+    hints->ai_protocol = IPPROTO_TCP;
+}
+
+static void set_lookup_result(DNS_ASYNC_INSTANCE* dns, struct addrinfo* addrInfo)
+{
+    struct addrinfo *ptr = NULL;
+
+    // Keep the first address of each family, in the order the resolver sorted them
+    for (ptr = addrInfo; ptr != NULL; ptr = ptr->ai_next)
+    {
+        switch (ptr->ai_family)
+        {
+        case AF_INET:
+            if (dns->ip_v4 == 0)
+            {
+                /* Codes_SRS_DNS_ASYNC_30_032: [ If dns_async_is_create_complete has returned true and the lookup process has succeeded, dns_async_get_ipv4 shall return the discovered IPv4 address. ]*/
+                dns->ip_v4 = EXTRACT_IPV4(ptr);
+            }
+            break;
+#ifdef AF_INET6
+        case AF_INET6:
+            if (!dns->has_ip_v6)
+            {
+                /* Codes_SRS_DNS_ASYNC_01_004: [ If dns_async_is_lookup_complete has returned true and the lookup process has found an IPv6 address, dns_async_get_ipv6 shall copy the first discovered IPv6 address to address and return 0. ]*/
+                (void)memcpy(dns->ip_v6, EXTRACT_IPV6(ptr), DNS_ASYNC_IPV6_ADDRESS_SIZE);
+                dns->has_ip_v6 = true;
+            }
+            break;
+#endif
+        default:
+            break;
+        }
+    }
+
+    /* Codes_SRS_DNS_ASYNC_30_033: [ If dns_async_is_create_complete has returned true and the lookup process has failed, dns_async_get_ipv4 shall return 0. ]*/
+    dns->is_failed = (dns->ip_v4 == 0) && !dns->has_ip_v6;
+}
+
+/* Codes_SRS_DNS_ASYNC_01_009: [ dns_async shall use the addresses or the failure cached by dns_cache for hostname instead of looking it up. ]*/
+static bool set_cached_result(DNS_ASYNC_INSTANCE* dns)
+{
+    bool result;
+    DNS_CACHE_ADDRESSES addresses;
+
+    switch (dns_cache_lookup(dns->hostname, &addresses))
+    {
+    case DNS_CACHE_HIT:
+        dns->ip_v4 = addresses.ip_v4;
+        dns->has_ip_v6 = addresses.has_ip_v6;
+        (void)memcpy(dns->ip_v6, addresses.ip_v6, DNS_ASYNC_IPV6_ADDRESS_SIZE);
+        dns->is_failed = (dns->ip_v4 == 0) && !dns->has_ip_v6;
+        result = true;
+        break;
+    case DNS_CACHE_NEGATIVE_HIT:
+        LogInfo("Failed DNS lookup for %s is cached", dns->hostname);
+        dns->is_failed = true;
+        result = true;
+        break;
+    default:
+        result = false;
+        break;
+    }
+
+    return result;
+}
+
+/* Codes_SRS_DNS_ASYNC_01_010: [ dns_async shall add the result of each lookup it makes to dns_cache. ]*/
+static void cache_result(DNS_ASYNC_INSTANCE* dns)
+{
+    if (dns->is_failed)
+    {
+        (void)dns_cache_add(dns->hostname, NULL);
+    }
+    else
+    {
+        DNS_CACHE_ADDRESSES addresses;
+        addresses.ip_v4 = dns->ip_v4;
+        addresses.has_ip_v6 = dns->has_ip_v6;
+        (void)memcpy(addresses.ip_v6, dns->ip_v6, DNS_ASYNC_IPV6_ADDRESS_SIZE);
+        (void)dns_cache_add(dns->hostname, &addresses);
+    }
+}
+
+#ifdef DNS_ASYNC_USE_GETADDRINFO_A
+// Lookups that were still running when their handle was destroyed. glibc keeps using the
+// gaicb until the lookup finishes, so they are freed by a later create or destroy.
+static pthread_mutex_t abandoned_lock = PTHREAD_MUTEX_INITIALIZER;
+static DNS_ASYNC_INSTANCE* abandoned_lookups = NULL;
+
+static void free_instance(DNS_ASYNC_INSTANCE* dns)
+{
+    if ((dns->request.ar_result != NULL) && (gai_error(&dns->request) == 0))
+    {
+        freeaddrinfo(dns->request.ar_result);
+    }
+    free(dns->hostname);
+    free(dns);
+}
+
+static void free_abandoned_lookups(DNS_ASYNC_INSTANCE* new_abandoned)
+{
+    DNS_ASYNC_INSTANCE** current;
+
+    (void)pthread_mutex_lock(&abandoned_lock);
+
+    /* Codes_SRS_DNS_ASYNC_01_008: [ Lookups abandoned by dns_async_destroy shall be freed by a later dns_async_create or dns_async_destroy once they have finished. ]*/
+    current = &abandoned_lookups;
+    while (*current != NULL)
+    {
+        DNS_ASYNC_INSTANCE* dns = *current;
+        if (gai_error(&dns->request) == EAI_INPROGRESS)
+        {
+            current = &dns->next_abandoned;
+        }
+        else
+        {
+            *current = dns->next_abandoned;
+            free_instance(dns);
+        }
+    }
+
+    if (new_abandoned != NULL)
+    {
+        new_abandoned->next_abandoned = abandoned_lookups;
+        abandoned_lookups = new_abandoned;
+    }
+
+    (void)pthread_mutex_unlock(&abandoned_lock);
+}
+
+static int start_lookup(DNS_ASYNC_INSTANCE* dns)
+{
+    int result;
+    struct gaicb* requests[1];
+    int gai_result;
+
+    free_abandoned_lookups(NULL);
+
+    set_lookup_hints(&dns->hints);
+    memset(&dns->request, 0, sizeof(dns->request));
+    dns->request.ar_name = dns->hostname;
+    dns->request.ar_service = NULL;
+    dns->request.ar_request = &dns->hints;
+    dns->request.ar_result = NULL;
+    dns->next_abandoned = NULL;
+    requests[0] = &dns->request;
+
+    /* Codes_SRS_DNS_ASYNC_01_001: [ When built with DNS_ASYNC_USE_GETADDRINFO_A, dns_async_create shall start the lookup in the background with getaddrinfo_a. ]*/
+    gai_result = getaddrinfo_a(GAI_NOWAIT, requests, 1, NULL);
+    if (gai_result != 0)
+    {
+        LogError("getaddrinfo_a for %s failed: %d", dns->hostname, gai_result);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+#endif
+
 DNS_ASYNC_HANDLE dns_async_create(const char* hostname, DNS_ASYNC_OPTIONS* options)
 {
     /* Codes_SRS_DNS_ASYNC_30_012: [ The optional options parameter shall be ignored. ]*/
@@ -58,6 +256,7 @@ DNS_ASYNC_HANDLE dns_async_create(const char* hostname, DNS_ASYNC_OPTIONS* optio
             result->is_complete = false;
             result->is_failed = false;
             result->ip_v4 = 0;
+            result->has_ip_v6 = false;
             /* Codes_SRS_DNS_ASYNC_30_010: [ dns_async_create shall make a copy of the hostname parameter to allow immediate deletion by the caller. ]*/
             ms_result = mallocAndStrcpy_s(&result->hostname, hostname);
             if (ms_result != 0)
@@ -66,6 +265,19 @@ DNS_ASYNC_HANDLE dns_async_create(const char* hostname, DNS_ASYNC_OPTIONS* optio
                 free(result);
                 result = NULL;
             }
+#ifdef DNS_ASYNC_USE_GETADDRINFO_A
+            else if (set_cached_result(result))
+            {
+                result->is_complete = true;
+            }
+            else if (start_lookup(result) != 0)
+            {
+                /* Codes_SRS_DNS_ASYNC_30_014: [ On any failure, dns_async_create shall log an error and return NULL. ]*/
+                free(result->hostname);
+                free(result);
+                result = NULL;
+            }
+#endif
         }
     }
     return result;
@@ -90,10 +302,41 @@ bool dns_async_is_lookup_complete(DNS_ASYNC_HANDLE dns_in)
             /* Codes_SRS_DNS_ASYNC_30_024: [ If dns_async_is_create_complete has previously returned true, dns_async_is_create_complete shall do nothing and return true. ]*/
             result = true;
         }
+#ifdef DNS_ASYNC_USE_GETADDRINFO_A
+        else
+        {
+            /* Codes_SRS_DNS_ASYNC_30_021: [ dns_async_is_create_complete shall perform the asynchronous work of DNS lookup and log any errors. ]*/
+            /* Codes_SRS_DNS_ASYNC_01_002: [ When built with DNS_ASYNC_USE_GETADDRINFO_A, dns_async_is_lookup_complete shall poll the background lookup without blocking. ]*/
+            int getAddrResult = gai_error(&dns->request);
+            if (getAddrResult == EAI_INPROGRESS)
+            {
+                /* Codes_SRS_DNS_ASYNC_30_023: [ If the DNS lookup process is not yet complete, dns_async_is_create_complete shall return false. ]*/
+                result = false;
+            }
+            else
+            {
+                dns->is_complete = true;
+                if (getAddrResult == 0)
+                {
+                    set_lookup_result(dns, dns->request.ar_result);
+                    freeaddrinfo(dns->request.ar_result);
+                    dns->request.ar_result = NULL;
+                }
+                else
+                {
+                    /* Codes_SRS_DNS_ASYNC_30_033: [ If dns_async_is_create_complete has returned true and the lookup process has failed, dns_async_get_ipv4 shall return 0. ]*/
+                    LogInfo("Failed DNS lookup for %s: %d", dns->hostname, getAddrResult);
+                    dns->is_failed = true;
+                }
+                cache_result(dns);
+                /* Codes_SRS_DNS_ASYNC_30_022: [ If the DNS lookup process has completed, dns_async_is_create_complete shall return true. ]*/
+                result = true;
+            }
+        }
+#else
         else
         {
             struct addrinfo *addrInfo = NULL;
-            struct addrinfo *ptr = NULL;
             struct addrinfo hints;
             int getAddrResult;
 
@@ -102,48 +345,35 @@ bool dns_async_is_lookup_complete(DNS_ASYNC_HANDLE dns_in)
             // synchronous implementation
             dns->is_complete = true;
 
-            //--------------------------------
-            // Setup the hints address info structure
-            // which is passed to the getaddrinfo() function
-            memset(&hints, 0, sizeof(hints));
-            hints.ai_family = AF_INET;
-            hints.ai_socktype = SOCK_STREAM;
-            hints.ai_protocol = IPPROTO_TCP;
-
-            //--------------------------------
-            // Call getaddrinfo(). If the call succeeds,
-            // the result variable will hold a linked list
-            // of addrinfo structures containing response
-            // information
-            getAddrResult = getaddrinfo(dns->hostname, NULL, &hints, &addrInfo);
-            if (getAddrResult == 0)
+            if (!set_cached_result(dns))
             {
-                // If we find the AF_INET address, use it as the return value
-                for (ptr = addrInfo; ptr != NULL; ptr = ptr->ai_next)
+                set_lookup_hints(&hints);
+
+                //--------------------------------
+                // Call getaddrinfo(). If the call succeeds,
+                // the result variable will hold a linked list
+                // of addrinfo structures containing response
+                // information
+                getAddrResult = getaddrinfo(dns->hostname, NULL, &hints, &addrInfo);
+                if (getAddrResult == 0)
                 {
-                    switch (ptr->ai_family)
-                    {
-                    case AF_INET:
-                        /* Codes_SRS_DNS_ASYNC_30_032: [ If dns_async_is_create_complete has returned true and the lookup process has succeeded, dns_async_get_ipv4 shall return the discovered IPv4 address. ]*/
-                        dns->ip_v4 = EXTRACT_IPV4(ptr);
-                        break;
-                    }
+                    set_lookup_result(dns, addrInfo);
+                    freeaddrinfo(addrInfo);
                 }
-                /* Codes_SRS_DNS_ASYNC_30_033: [ If dns_async_is_create_complete has returned true and the lookup process has failed, dns_async_get_ipv4 shall return 0. ]*/
-                dns->is_failed = (dns->ip_v4 == 0);
-                freeaddrinfo(addrInfo);
-            }
-            else
-            {
-                /* Codes_SRS_DNS_ASYNC_30_033: [ If dns_async_is_create_complete has returned true and the lookup process has failed, dns_async_get_ipv4 shall return 0. ]*/
-                LogInfo("Failed DNS lookup for %s: %d", dns->hostname, getAddrResult);
-                dns->is_failed = true;
+                else
+                {
+                    /* Codes_SRS_DNS_ASYNC_30_033: [ If dns_async_is_create_complete has returned true and the lookup process has failed, dns_async_get_ipv4 shall return 0. ]*/
+                    LogInfo("Failed DNS lookup for %s: %d", dns->hostname, getAddrResult);
+                    dns->is_failed = true;
+                }
+                cache_result(dns);
             }
             // This synchronous implementation is incapable of being incomplete, so SRS_DNS_ASYNC_30_023 does not ever happen
             /* Codes_SRS_DNS_ASYNC_30_023: [ If the DNS lookup process is not yet complete, dns_async_is_create_complete shall return false. ]*/
             /* Codes_SRS_DNS_ASYNC_30_022: [ If the DNS lookup process has completed, dns_async_is_create_complete shall return true. ]*/
             result = true;
         }
+#endif
     }
 
     return result;
@@ -160,8 +390,21 @@ void dns_async_destroy(DNS_ASYNC_HANDLE dns_in)
     else
     {
         /* Codes_SRS_DNS_ASYNC_30_051: [ dns_async_destroy shall delete all acquired resources and delete the DNS_ASYNC_HANDLE. ]*/
+#ifdef DNS_ASYNC_USE_GETADDRINFO_A
+        /* Codes_SRS_DNS_ASYNC_01_007: [ When built with DNS_ASYNC_USE_GETADDRINFO_A, dns_async_destroy shall cancel a lookup that has not completed and shall not wait for it. ]*/
+        if (!dns->is_complete && gai_cancel(&dns->request) == EAI_NOTCANCELED)
+        {
+            free_abandoned_lookups(dns);
+        }
+        else
+        {
+            free_abandoned_lookups(NULL);
+            free_instance(dns);
+        }
+#else
         free(dns->hostname);
         free(dns);
+#endif
     }
 }
 
@@ -199,3 +442,35 @@ uint32_t dns_async_get_ipv4(DNS_ASYNC_HANDLE dns_in)
     }
     return result;
 }
+
+int dns_async_get_ipv6(DNS_ASYNC_HANDLE dns_in, unsigned char* address, size_t address_size)
+{
+    DNS_ASYNC_INSTANCE* dns = (DNS_ASYNC_INSTANCE*)dns_in;
+    int result;
+    if ((dns == NULL) ||
+        (address == NULL) ||
+        (address_size < DNS_ASYNC_IPV6_ADDRESS_SIZE))
+    {
+        /* Codes_SRS_DNS_ASYNC_01_003: [ If dns or address is NULL or address_size is smaller than DNS_ASYNC_IPV6_ADDRESS_SIZE, dns_async_get_ipv6 shall log an error and return a non-zero value. ]*/
+        LogError("Invalid arguments: dns = %p, address = %p, address_size = %lu", dns, address, (unsigned long)address_size);
+        result = __FAILURE__;
+    }
+    else if (!dns->is_complete)
+    {
+        /* Codes_SRS_DNS_ASYNC_01_005: [ If dns_async_is_lookup_complete has not yet returned true, dns_async_get_ipv6 shall log an error and return a non-zero value. ]*/
+        LogError("dns_async_get_ipv6 when not complete");
+        result = __FAILURE__;
+    }
+    else if (!dns->has_ip_v6)
+    {
+        /* Codes_SRS_DNS_ASYNC_01_006: [ If the lookup process has failed or found no IPv6 address, dns_async_get_ipv6 shall return a non-zero value. ]*/
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_DNS_ASYNC_01_004: [ If dns_async_is_lookup_complete has returned true and the lookup process has found an IPv6 address, dns_async_get_ipv6 shall copy the first discovered IPv6 address to address and return 0. ]*/
+        (void)memcpy(address, dns->ip_v6, DNS_ASYNC_IPV6_ADDRESS_SIZE);
+        result = 0;
+    }
+    return result;
+}
@@ -109,3 +109,79 @@ LOCK_RESULT Unlock(LOCK_HANDLE handle)
 
     return result;
 }
+
+/* FreeRTOS has no reader/writer lock and a spin lock brings nothing on a single core,
+   both are the exclusive lock above. */
+RWLOCK_HANDLE RWLock_Init(void)
+{
+    /* Codes_SRS_LOCK_01_001: [RWLock_Init on success shall return a valid reader/writer lock handle which should be a non NULL value] */
+    /* Codes_SRS_LOCK_01_002: [RWLock_Init on error shall return NULL] */
+    return (RWLOCK_HANDLE)Lock_Init();
+}
+
+LOCK_RESULT RWLock_LockShared(RWLOCK_HANDLE handle)
+{
+    /* Codes_SRS_LOCK_01_003: [RWLock_LockShared on NULL handle passed returns LOCK_ERROR] */
+    /* Codes_SRS_LOCK_01_004: [RWLock_LockShared shall acquire the lock in shared mode and return LOCK_OK] */
+    /* Codes_SRS_LOCK_01_005: [RWLock_LockShared on error shall return LOCK_ERROR] */
+    return Lock((LOCK_HANDLE)handle);
+}
+
+LOCK_RESULT RWLock_UnlockShared(RWLOCK_HANDLE handle)
+{
+    /* Codes_SRS_LOCK_01_006: [RWLock_UnlockShared on NULL handle passed returns LOCK_ERROR] */
+    /* Codes_SRS_LOCK_01_007: [RWLock_UnlockShared shall release the shared lock and return LOCK_OK] */
+    /* Codes_SRS_LOCK_01_008: [RWLock_UnlockShared on error shall return LOCK_ERROR] */
+    return Unlock((LOCK_HANDLE)handle);
+}
+
+LOCK_RESULT RWLock_LockExclusive(RWLOCK_HANDLE handle)
+{
+    /* Codes_SRS_LOCK_01_009: [RWLock_LockExclusive on NULL handle passed returns LOCK_ERROR] */
+    /* Codes_SRS_LOCK_01_010: [RWLock_LockExclusive shall acquire the lock in exclusive mode and return LOCK_OK] */
+    /* Codes_SRS_LOCK_01_011: [RWLock_LockExclusive on error shall return LOCK_ERROR] */
+    return Lock((LOCK_HANDLE)handle);
+}
+
+LOCK_RESULT RWLock_UnlockExclusive(RWLOCK_HANDLE handle)
+{
+    /* Codes_SRS_LOCK_01_012: [RWLock_UnlockExclusive on NULL handle passed returns LOCK_ERROR] */
+    /* Codes_SRS_LOCK_01_013: [RWLock_UnlockExclusive shall release the exclusive lock and return LOCK_OK] */
+    /* Codes_SRS_LOCK_01_014: [RWLock_UnlockExclusive on error shall return LOCK_ERROR] */
+    return Unlock((LOCK_HANDLE)handle);
+}
+
+LOCK_RESULT RWLock_Deinit(RWLOCK_HANDLE handle)
+{
+    /* Codes_SRS_LOCK_01_015: [RWLock_Deinit on NULL handle passed returns LOCK_ERROR] */
+    /* Codes_SRS_LOCK_01_016: [RWLock_Deinit frees all resources associated with handle] */
+    return Lock_Deinit((LOCK_HANDLE)handle);
+}
+
+SPINLOCK_HANDLE SpinLock_Init(void)
+{
+    /* Codes_SRS_LOCK_01_017: [SpinLock_Init on success shall return a valid spin lock handle which should be a non NULL value] */
+    /* Codes_SRS_LOCK_01_018: [SpinLock_Init on error shall return NULL] */
+    return (SPINLOCK_HANDLE)Lock_Init();
+}
+
+LOCK_RESULT SpinLock_Lock(SPINLOCK_HANDLE handle)
+{
+    /* Codes_SRS_LOCK_01_019: [SpinLock_Lock on NULL handle passed returns LOCK_ERROR] */
+    /* Codes_SRS_LOCK_01_020: [SpinLock_Lock shall spin until the lock is free, yielding the thread once it has spun for a while, then acquire it and return LOCK_OK] */
+    return Lock((LOCK_HANDLE)handle);
+}
+
+LOCK_RESULT SpinLock_Unlock(SPINLOCK_HANDLE handle)
+{
+    /* Codes_SRS_LOCK_01_021: [SpinLock_Unlock on NULL handle passed returns LOCK_ERROR] */
+    /* Codes_SRS_LOCK_01_022: [SpinLock_Unlock shall release the lock and return LOCK_OK] */
+    return Unlock((LOCK_HANDLE)handle);
+}
+
+LOCK_RESULT SpinLock_Deinit(SPINLOCK_HANDLE handle)
+{
+    /* Codes_SRS_LOCK_01_023: [SpinLock_Deinit on NULL handle passed returns LOCK_ERROR] */
+    /* Codes_SRS_LOCK_01_024: [SpinLock_Deinit frees all resources associated with handle] */
+    return Lock_Deinit((LOCK_HANDLE)handle);
+}
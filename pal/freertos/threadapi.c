@@ -26,6 +26,17 @@ THREADAPI_RESULT ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC
     return THREADAPI_ERROR;
 }
 
+/*Codes_SRS_THREADAPI_FREERTOS_01_001: [ FreeRTOS is not guaranteed to support threading, so ThreadAPI_CreateEx shall return THREADAPI_ERROR. ]*/
+THREADAPI_RESULT ThreadAPI_CreateEx(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg, const THREAD_ATTRIBUTES* attributes)
+{
+    (void)threadHandle;
+    (void)func;
+    (void)arg;
+    (void)attributes;
+    LogError("FreeRTOS does not support multi-threading.");
+    return THREADAPI_ERROR;
+}
+
 /*Codes_SRS_THREADAPI_FREERTOS_30_005: [ FreeRTOS is not guaranteed to support threading, so ThreadAPI_Join shall return THREADAPI_ERROR. ]*/
 THREADAPI_RESULT ThreadAPI_Join(THREAD_HANDLE threadHandle, int* res)
 {
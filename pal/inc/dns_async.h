@@ -8,6 +8,8 @@
 #ifndef AZURE_IOT_DNS_H
 #define AZURE_IOT_DNS_H
 
+#include <stddef.h>
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -17,6 +19,9 @@ extern "C" {
 
     typedef void* DNS_ASYNC_HANDLE;
 
+    // The size of the address filled in by dns_async_get_ipv6, in network byte order
+    #define DNS_ASYNC_IPV6_ADDRESS_SIZE 16
+
     // If options are added in future, DNS_ASYNC_OPTIONS will become a struct containing the options
     typedef void DNS_ASYNC_OPTIONS;
 
@@ -47,6 +52,17 @@ extern "C" {
     */
     MOCKABLE_FUNCTION(, uint32_t, dns_async_get_ipv4, DNS_ASYNC_HANDLE, dns);
 
+    /**
+    * @brief    Copy the IPv6 address of a completed lookup process. Call only after dns_async_is_lookup_complete indicates completion.
+    *
+    * @param   dns             The DNS_ASYNC_HANDLE.
+    * @param   address         Receives the address, DNS_ASYNC_IPV6_ADDRESS_SIZE bytes in network byte order.
+    * @param   address_size    The size of address.
+    *
+    * @return    @c 0 if an IPv6 address was found, non-zero on failure, when not finished or when the host has no IPv6 address.
+    */
+    MOCKABLE_FUNCTION(, int, dns_async_get_ipv6, DNS_ASYNC_HANDLE, dns, unsigned char*, address, size_t, address_size);
+
     /**
     * @brief    Destroy the module.
     *
@@ -13,6 +13,7 @@ extern "C" {
 #endif
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include "azure_c_shared_utility/macro_utils.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
@@ -39,6 +40,27 @@ typedef SOCKET_ASYNC_OPTIONS* SOCKET_ASYNC_OPTIONS_HANDLE;
 
 typedef int SOCKET_ASYNC_HANDLE;
 
+// One of the buffers given to socket_async_send_vector
+typedef struct
+{
+    const void* buffer;
+    size_t size;
+} SOCKET_ASYNC_BUFFER;
+
+// socket_async_send_vector sends at most this many buffers in one call (the smallest IOV_MAX POSIX allows)
+#define SOCKET_ASYNC_MAX_BUFFER_COUNT 16
+
+// One of the sockets given to socket_async_wait_any. The caller sets sock and wait_for_send, the
+// ready states are set by socket_async_wait_any.
+typedef struct
+{
+    SOCKET_ASYNC_HANDLE sock;
+    bool wait_for_send;     // also wait for room to send, or for socket_async_create to complete
+    bool is_receive_ready;  // socket_async_receive will not report 0 bytes (data, or the peer closed)
+    bool is_send_ready;     // set only if wait_for_send
+    bool has_error;         // the socket failed and must be destroyed
+} SOCKET_ASYNC_WAIT_ITEM;
+
 /**
 * @brief    Create a non-blocking socket that is correctly configured for asynchronous use.
 *
@@ -90,6 +112,25 @@ MOCKABLE_FUNCTION(, int, socket_async_is_create_complete, SOCKET_ASYNC_HANDLE, s
 */
 MOCKABLE_FUNCTION(, int, socket_async_send, SOCKET_ASYNC_HANDLE, sock, const void*, buffer, size_t, size, size_t*, sent_count);
 
+/**
+* @brief    Send several buffers on the specified socket with one call to the socket layer, as if
+*           they were concatenated.
+*
+* @param    sock The socket to be used.
+*
+* @param    buffers The buffers containing the message to transmit. Only the first
+*           SOCKET_ASYNC_MAX_BUFFER_COUNT buffers are sent by one call.
+*
+* @param    buffer_count The number of buffers.
+*
+* @param    sent_count Receives the number of bytes transmitted, counted from the start of the
+*           first buffer. The N == 0 case means normal operation but the socket's outgoing buffer was full.
+*
+* @return   @c 0 if successful.
+*           __FAILURE__ means an unexpected error has occurred and the socket must be destroyed.
+*/
+MOCKABLE_FUNCTION(, int, socket_async_send_vector, SOCKET_ASYNC_HANDLE, sock, const SOCKET_ASYNC_BUFFER*, buffers, size_t, buffer_count, size_t*, sent_count);
+
 /**
 * @brief    Receive a message on the specified socket.
 *
@@ -107,6 +148,24 @@ MOCKABLE_FUNCTION(, int, socket_async_send, SOCKET_ASYNC_HANDLE, sock, const voi
 MOCKABLE_FUNCTION(, int, socket_async_receive, SOCKET_ASYNC_HANDLE, sock, void*, buffer, size_t, size, size_t*, received_count);
 
 
+/**
+* @brief    Wait until at least one of several sockets is ready, so that a single task can service
+*           them all without polling each one.
+*
+* @param    items The sockets to wait for. Their ready states receive the result.
+*
+* @param    item_count The number of items.
+*
+* @param    timeout_ms The longest time to wait in milliseconds. 0 checks the sockets and returns.
+*
+* @param    ready_count Receives the number of items with at least one ready state set, 0 if the
+*           timeout expired.
+*
+* @return   @c 0 if successful.
+*           __FAILURE__ means an unexpected error has occurred.
+*/
+MOCKABLE_FUNCTION(, int, socket_async_wait_any, SOCKET_ASYNC_WAIT_ITEM*, items, size_t, item_count, uint32_t, timeout_ms, size_t*, ready_count);
+
 /**
 * @brief    Close the socket returned by socket_async_create.
 *
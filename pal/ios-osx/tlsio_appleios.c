@@ -761,7 +761,13 @@ static const IO_INTERFACE_DESCRIPTION tlsio_appleios_interface_description =
     tlsio_appleios_close_async,
     tlsio_appleios_send_async,
     tlsio_appleios_dowork,
-    tlsio_appleios_setoption
+    tlsio_appleios_setoption,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
 };
 
 /* Codes_SRS_TLSIO_30_001: [ The tlsio_appleios_compact shall implement and export all the Concrete functions in the VTable IO_INTERFACE_DESCRIPTION defined in the xio.h. ]*/
@@ -12,13 +12,11 @@
 //   REFCOUNT_USE_STD_ATOMIC      -- C11 atomicity
 //   REFCOUNT_USE_GNU_C_ATOMIC    -- GNU-specific atomicity
 
+// gcc and clang use their builtins whatever the language mode, C11 atomics are for the other compilers
 #if defined(__GNUC__)
 #define REFCOUNT_USE_GNU_C_ATOMIC 1
-#endif
-
-#if defined(__STDC_VERSION__) && (__STDC_VERSION__ == 201112)
+#elif defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) && !defined(__STDC_NO_ATOMICS__)
 #define REFCOUNT_USE_STD_ATOMIC 1
-#undef REFCOUNT_USE_GNU_C_ATOMIC
 #endif
 
 // This FREERTOS_ARCH_ESP8266 behavior is deprecated. Microcontrollers
@@ -43,14 +41,19 @@
 /*The following mechanisms are considered in this order
 REFCOUNT_ATOMIC_DONTCARE does not use atomic operations
 - will result in ++/-- used for increment/decrement.
-C11
+gcc (and clang, which defines __GNUC__), in any C or C++ mode
+- will result in no include (for gcc these are intrinsics build in)
+- will use __atomic_add_fetch/__atomic_sub_fetch, or __sync_add_and_fetch/__sync_sub_and_fetch on compilers older than gcc 4.7
+- about the return value: "... return the result of the operation." (https://gcc.gnu.org/onlinedocs/gcc/_005f_005fatomic-Builtins.html)
+C11, for other compilers that have atomics
 - will result in #include <stdatomic.h>
-- will use atomic_fetch_add/sub;
+- will use atomic_fetch_add_explicit/atomic_fetch_sub_explicit;
 - about the return value: "Atomically, the value pointed to by object immediately before the effects"
-gcc
-- will result in no include (for gcc these are intrinsics build in)
-- will use __sync_fetch_and_add/sub
-- about the return value: "... returns the value that had previously been in memory." (https://gcc.gnu.org/onlinedocs/gcc-4.4.3/gcc/Atomic-Builtins.html#Atomic-Builtins)
+
+Taking a reference only needs the increment to be atomic: whoever hands out the reference already holds one,
+so the increment is relaxed. The decrement is acquire-release: the release makes the writes done through a
+reference visible before it is dropped, the acquire lets whoever drops the last reference see them before
+freeing the object. The count is initialized before the object is shared, so that store is relaxed as well.
 */
 
 
@@ -64,15 +67,21 @@ gcc
 #elif defined(REFCOUNT_USE_STD_ATOMIC)
 #include <stdatomic.h>
 #define DEC_RETURN_ZERO (1)
-#define INC_REF_VAR(count) atomic_fetch_add(&(count), 1)
-#define DEC_REF_VAR(count) atomic_fetch_sub(&(count), 1)
-#define INIT_REF_VAR(count) atomic_store(&(count), 1)
+#define INC_REF_VAR(count) atomic_fetch_add_explicit(&(count), 1, memory_order_relaxed)
+#define DEC_REF_VAR(count) atomic_fetch_sub_explicit(&(count), 1, memory_order_acq_rel)
+#define INIT_REF_VAR(count) atomic_store_explicit(&(count), 1, memory_order_relaxed)
 
 #elif defined(REFCOUNT_USE_GNU_C_ATOMIC)
 #define DEC_RETURN_ZERO (0)
+#if defined(__ATOMIC_RELAXED)
+#define INC_REF_VAR(count) __atomic_add_fetch(&(count), 1, __ATOMIC_RELAXED)
+#define DEC_REF_VAR(count) __atomic_sub_fetch(&(count), 1, __ATOMIC_ACQ_REL)
+#define INIT_REF_VAR(count) __atomic_store_n(&(count), 1, __ATOMIC_RELAXED)
+#else
 #define INC_REF_VAR(count) __sync_add_and_fetch(&(count), 1)
 #define DEC_REF_VAR(count) __sync_sub_and_fetch(&(count), 1)
 #define INIT_REF_VAR(count) do { count = 1; __sync_synchronize(); } while((void)0,0)
+#endif
 
 #endif /*defined(REFCOUNT_USE_GNU_C_ATOMIC)*/
 
@@ -273,6 +273,96 @@ int socket_async_send(SOCKET_ASYNC_HANDLE sock, const void* buffer, size_t size,
     return result;
 }
 
+int socket_async_send_vector(SOCKET_ASYNC_HANDLE sock, const SOCKET_ASYNC_BUFFER* buffers, size_t buffer_count, size_t* sent_count)
+{
+    int result;
+    if (buffers == NULL && buffer_count > 0)
+    {
+        /* Codes_SRS_SOCKET_ASYNC_01_001: [ If the buffers parameter is NULL and buffer_count is not 0, socket_async_send_vector shall log the error and return FAILURE. ]*/
+        LogError("buffers is NULL");
+        result = __FAILURE__;
+    }
+    else if (sent_count == NULL)
+    {
+        /* Codes_SRS_SOCKET_ASYNC_01_002: [ If the sent_count parameter is NULL, socket_async_send_vector shall log the error and return FAILURE. ]*/
+        LogError("sent_count is NULL");
+        result = __FAILURE__;
+    }
+    else
+    {
+        struct iovec iov[SOCKET_ASYNC_MAX_BUFFER_COUNT];
+        size_t iov_count = 0;
+        size_t i;
+
+        result = 0;
+
+        /* Codes_SRS_SOCKET_ASYNC_01_004: [ At most SOCKET_ASYNC_MAX_BUFFER_COUNT buffers shall be given to the underlying socket by one call. ]*/
+        for (i = 0; (i < buffer_count) && (iov_count < SOCKET_ASYNC_MAX_BUFFER_COUNT); i++)
+        {
+            if (buffers[i].size == 0)
+            {
+                // Empty buffers would only use up entries of iov
+            }
+            else if (buffers[i].buffer == NULL)
+            {
+                /* Codes_SRS_SOCKET_ASYNC_01_003: [ If a buffer with a non-zero size is NULL, socket_async_send_vector shall log the error and return FAILURE. ]*/
+                LogError("buffer %lu is NULL", (unsigned long)i);
+                result = __FAILURE__;
+                break;
+            }
+            else
+            {
+                iov[iov_count].iov_base = (void*)buffers[i].buffer;
+                iov[iov_count].iov_len = buffers[i].size;
+                iov_count++;
+            }
+        }
+
+        if (result != 0)
+        {
+            // Already logged
+        }
+        else if (iov_count == 0)
+        {
+            /* Codes_SRS_SOCKET_ASYNC_01_005: [ If all the buffers are empty, socket_async_send_vector shall set sent_count to 0 and return 0. ]*/
+            *sent_count = 0;
+        }
+        else
+        {
+            struct msghdr msg;
+            ssize_t send_result;
+
+            (void)memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iov;
+            msg.msg_iovlen = iov_count;
+
+            /* Codes_SRS_SOCKET_ASYNC_01_006: [ socket_async_send_vector shall send the buffers with a single call to the underlying sendmsg. ]*/
+            send_result = sendmsg(sock, &msg, 0);
+            if (send_result < 0)
+            {
+                int sock_err = get_socket_errno(sock);
+                if (sock_err == EAGAIN || sock_err == EWOULDBLOCK)
+                {
+                    /* Codes_SRS_SOCKET_ASYNC_01_008: [ If the underlying socket is unable to accept any bytes for transmission because its buffer is full, socket_async_send_vector shall return 0 and the sent_count parameter shall receive the value 0. ]*/
+                    *sent_count = 0;
+                }
+                else
+                {
+                    /* Codes_SRS_SOCKET_ASYNC_01_009: [ If the underlying sendmsg fails unexpectedly, socket_async_send_vector shall log the error and return FAILURE. ]*/
+                    LogError("Unexpected sendmsg error: %d", sock_err);
+                    result = __FAILURE__;
+                }
+            }
+            else
+            {
+                /* Codes_SRS_SOCKET_ASYNC_01_007: [ If the underlying socket accepts one or more bytes for transmission, socket_async_send_vector shall return 0 and the sent_count parameter shall receive the number of bytes accepted for transmission. ]*/
+                *sent_count = (size_t)send_result;
+            }
+        }
+    }
+    return result;
+}
+
 int socket_async_receive(SOCKET_ASYNC_HANDLE sock, void* buffer, size_t size, size_t* received_count)
 {
     int result;
@@ -330,6 +420,96 @@ int socket_async_receive(SOCKET_ASYNC_HANDLE sock, void* buffer, size_t size, si
     return result;
 }
 
+int socket_async_wait_any(SOCKET_ASYNC_WAIT_ITEM* items, size_t item_count, uint32_t timeout_ms, size_t* ready_count)
+{
+    int result;
+    if (items == NULL || item_count == 0 || ready_count == NULL)
+    {
+        /* Codes_SRS_SOCKET_ASYNC_01_010: [ If items is NULL, item_count is 0 or ready_count is NULL, socket_async_wait_any shall log an error and return FAILURE. ]*/
+        LogError("Invalid arguments: items = %p, item_count = %lu, ready_count = %p", items, (unsigned long)item_count, ready_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        fd_set readset;
+        fd_set writeset;
+        fd_set errset;
+        int max_sock = -1;
+        size_t i;
+
+        FD_ZERO(&readset);
+        FD_ZERO(&writeset);
+        FD_ZERO(&errset);
+
+        for (i = 0; i < item_count; i++)
+        {
+            if (items[i].sock < 0 || items[i].sock >= FD_SETSIZE)
+            {
+                break;
+            }
+
+            /* Codes_SRS_SOCKET_ASYNC_01_012: [ socket_async_wait_any shall wait for all the sockets with a single call to the underlying select, for received bytes and errors and, for the items with wait_for_send set, for room to send. ]*/
+            FD_SET(items[i].sock, &readset);
+            FD_SET(items[i].sock, &errset);
+            if (items[i].wait_for_send)
+            {
+                FD_SET(items[i].sock, &writeset);
+            }
+
+            if (items[i].sock > max_sock)
+            {
+                max_sock = items[i].sock;
+            }
+        }
+
+        if (i < item_count)
+        {
+            /* Codes_SRS_SOCKET_ASYNC_01_011: [ If a socket cannot be waited for by select, socket_async_wait_any shall log an error and return FAILURE. ]*/
+            LogError("Socket %d cannot be waited for", items[i].sock);
+            result = __FAILURE__;
+        }
+        else
+        {
+            struct timeval tv;
+            int select_ret;
+
+            /* Codes_SRS_SOCKET_ASYNC_01_013: [ socket_async_wait_any shall wait at most timeout_ms milliseconds. ]*/
+            tv.tv_sec = (long)(timeout_ms / 1000);
+            tv.tv_usec = (long)((timeout_ms % 1000) * 1000);
+
+            select_ret = select(max_sock + 1, &readset, &writeset, &errset, &tv);
+            if (select_ret < 0)
+            {
+                /* Codes_SRS_SOCKET_ASYNC_01_016: [ If the underlying select fails, socket_async_wait_any shall log an error and return FAILURE. ]*/
+                LogError("Socket select failed: %d", get_socket_errno(max_sock));
+                result = __FAILURE__;
+            }
+            else
+            {
+                size_t ready = 0;
+
+                /* Codes_SRS_SOCKET_ASYNC_01_014: [ On success, socket_async_wait_any shall set the ready states of every item, set ready_count to the number of items with a ready state set and return 0. ]*/
+                for (i = 0; i < item_count; i++)
+                {
+                    items[i].is_receive_ready = (FD_ISSET(items[i].sock, &readset) != 0);
+                    items[i].is_send_ready = items[i].wait_for_send && (FD_ISSET(items[i].sock, &writeset) != 0);
+                    items[i].has_error = (FD_ISSET(items[i].sock, &errset) != 0);
+
+                    if (items[i].is_receive_ready || items[i].is_send_ready || items[i].has_error)
+                    {
+                        ready++;
+                    }
+                }
+
+                /* Codes_SRS_SOCKET_ASYNC_01_015: [ If the timeout expires first, ready_count shall be set to 0. ]*/
+                *ready_count = ready;
+                result = 0;
+            }
+        }
+    }
+    return result;
+}
+
 void socket_async_destroy(SOCKET_ASYNC_HANDLE sock)
 {
     /* Codes_SRS_SOCKET_ASYNC_30_071: [ socket_async_destroy shall call the underlying close method on the supplied socket. ]*/
@@ -2,6 +2,7 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
+#include <string.h>
 
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/tlsio_options.h"
@@ -23,6 +24,99 @@ void tlsio_options_initialize(TLSIO_OPTIONS* options, int supported_options)
     options->x509_type = TLSIO_OPTIONS_x509_TYPE_UNSPECIFIED;
     options->x509_cert = NULL;
     options->x509_key = NULL;
+    options->trusted_certs_buffer = NULL;
+    options->x509_cert_buffer = NULL;
+    options->x509_key_buffer = NULL;
+    options->groups = NULL;
+    options->group_count = 0;
+    options->signature_algorithms = NULL;
+    options->signature_algorithm_count = 0;
+}
+
+typedef struct TLSIO_NAMED_VALUE_TAG
+{
+    const char* name;
+    uint16_t value;
+} TLSIO_NAMED_VALUE;
+
+static const TLSIO_NAMED_VALUE tls_groups[] =
+{
+    { "X25519", TLSIO_GROUP_X25519 },
+    { "X448", TLSIO_GROUP_X448 },
+    { "P-256", TLSIO_GROUP_SECP256R1 },
+    { "secp256r1", TLSIO_GROUP_SECP256R1 },
+    { "prime256v1", TLSIO_GROUP_SECP256R1 },
+    { "P-384", TLSIO_GROUP_SECP384R1 },
+    { "secp384r1", TLSIO_GROUP_SECP384R1 },
+    { "P-521", TLSIO_GROUP_SECP521R1 },
+    { "secp521r1", TLSIO_GROUP_SECP521R1 },
+    { "ffdhe2048", TLSIO_GROUP_FFDHE2048 },
+    { "ffdhe3072", TLSIO_GROUP_FFDHE3072 },
+    { "ffdhe4096", TLSIO_GROUP_FFDHE4096 }
+};
+
+static const TLSIO_NAMED_VALUE tls_signature_algorithms[] =
+{
+    { "rsa_pkcs1_sha256", TLSIO_SIGNATURE_ALGORITHM_RSA_PKCS1_SHA256 },
+    { "rsa_pkcs1_sha384", TLSIO_SIGNATURE_ALGORITHM_RSA_PKCS1_SHA384 },
+    { "rsa_pkcs1_sha512", TLSIO_SIGNATURE_ALGORITHM_RSA_PKCS1_SHA512 },
+    { "ecdsa_secp256r1_sha256", TLSIO_SIGNATURE_ALGORITHM_ECDSA_SECP256R1_SHA256 },
+    { "ecdsa_secp384r1_sha384", TLSIO_SIGNATURE_ALGORITHM_ECDSA_SECP384R1_SHA384 },
+    { "ecdsa_secp521r1_sha512", TLSIO_SIGNATURE_ALGORITHM_ECDSA_SECP521R1_SHA512 },
+    { "rsa_pss_rsae_sha256", TLSIO_SIGNATURE_ALGORITHM_RSA_PSS_RSAE_SHA256 },
+    { "rsa_pss_rsae_sha384", TLSIO_SIGNATURE_ALGORITHM_RSA_PSS_RSAE_SHA384 },
+    { "rsa_pss_rsae_sha512", TLSIO_SIGNATURE_ALGORITHM_RSA_PSS_RSAE_SHA512 },
+    { "ed25519", TLSIO_SIGNATURE_ALGORITHM_ED25519 },
+    { "ed448", TLSIO_SIGNATURE_ALGORITHM_ED448 }
+};
+
+// Parses a colon separated list of names into their values, in the order given
+static int parse_name_list(const char* list, const TLSIO_NAMED_VALUE* names, size_t name_count, uint16_t* values, size_t* value_count)
+{
+    int result = 0;
+    size_t count = 0;
+
+    while (result == 0)
+    {
+        size_t length = strcspn(list, ":");
+        size_t i;
+
+        for (i = 0; i < name_count; i++)
+        {
+            if ((strlen(names[i].name) == length) && (strncmp(names[i].name, list, length) == 0))
+            {
+                break;
+            }
+        }
+
+        if (i == name_count)
+        {
+            LogError("Unknown name \"%.*s\" in list", (int)length, list);
+            result = __FAILURE__;
+        }
+        else if (count == TLSIO_OPTIONS_MAX_LIST_COUNT)
+        {
+            LogError("More than %d entries in list", TLSIO_OPTIONS_MAX_LIST_COUNT);
+            result = __FAILURE__;
+        }
+        else
+        {
+            values[count++] = names[i].value;
+
+            if (list[length] == '\0')
+            {
+                break;
+            }
+            list += length + 1;
+        }
+    }
+
+    if (result == 0)
+    {
+        *value_count = count;
+    }
+
+    return result;
 }
 
 static int set_and_validate_x509_type(TLSIO_OPTIONS* options, TLSIO_OPTIONS_x509_TYPE x509_type)
@@ -54,13 +148,23 @@ static int set_and_validate_x509_type(TLSIO_OPTIONS* options, TLSIO_OPTIONS_x509
     return result;
 }
 
+static void release_shared_string(CONSTBUFFER_HANDLE shared_string)
+{
+    if (shared_string != NULL)
+    {
+        CONSTBUFFER_DecRef(shared_string);
+    }
+}
+
 void tlsio_options_release_resources(TLSIO_OPTIONS* options)
 {
     if (options != NULL)
     {
-        free((void*)options->trusted_certs);
-        free((void*)options->x509_cert);
-        free((void*)options->x509_key);
+        release_shared_string(options->trusted_certs_buffer);
+        release_shared_string(options->x509_cert_buffer);
+        release_shared_string(options->x509_key_buffer);
+        free((void*)options->groups);
+        free((void*)options->signature_algorithms);
     }
     else
     {
@@ -76,6 +180,20 @@ static bool is_supported_string_option(const char* name)
         (strcmp(name, SU_OPTION_X509_CERT) == 0) ||
         (strcmp(name, SU_OPTION_X509_PRIVATE_KEY) == 0) ||
         (strcmp(name, OPTION_X509_ECC_CERT) == 0) ||
+        (strcmp(name, OPTION_X509_ECC_KEY) == 0) ||
+        (strcmp(name, OPTION_TLS_GROUPS) == 0) ||
+        (strcmp(name, OPTION_TLS_SIGNATURE_ALGORITHMS) == 0);
+}
+
+// The certificates and the key are kept in a CONSTBUFFER holding the string and its terminator,
+// so that tlsio_options_retrieve_options_ex shares them with the OptionHandler rather than copying them
+static bool is_shared_string_option(const char* name)
+{
+    return
+        (strcmp(name, OPTION_TRUSTED_CERT) == 0) ||
+        (strcmp(name, SU_OPTION_X509_CERT) == 0) ||
+        (strcmp(name, SU_OPTION_X509_PRIVATE_KEY) == 0) ||
+        (strcmp(name, OPTION_X509_ECC_CERT) == 0) ||
         (strcmp(name, OPTION_X509_ECC_KEY) == 0);
 }
 
@@ -134,6 +252,7 @@ TLSIO_OPTIONS_RESULT tlsio_options_set(TLSIO_OPTIONS* options,
 {
     TLSIO_OPTIONS_RESULT result;
     char* copied_value = NULL;
+    CONSTBUFFER_HANDLE shared_value = NULL;
 
     if (options == NULL || optionName == NULL || value == NULL)
     {
@@ -145,7 +264,13 @@ TLSIO_OPTIONS_RESULT tlsio_options_set(TLSIO_OPTIONS* options,
     {
         result = TLSIO_OPTIONS_RESULT_NOT_HANDLED;
     }
-    else if(mallocAndStrcpy_s(&copied_value, value) != 0)
+    else if (is_shared_string_option(optionName) &&
+        ((shared_value = CONSTBUFFER_Create((const unsigned char*)value, strlen((const char*)value) + 1)) == NULL))
+    {
+        LogError("unable to CONSTBUFFER_Create option value");
+        result = TLSIO_OPTIONS_RESULT_ERROR;
+    }
+    else if (!is_shared_string_option(optionName) && (mallocAndStrcpy_s(&copied_value, value) != 0))
     {
         LogError("unable to mallocAndStrcpy_s option value");
         result = TLSIO_OPTIONS_RESULT_ERROR;
@@ -164,7 +289,8 @@ TLSIO_OPTIONS_RESULT tlsio_options_set(TLSIO_OPTIONS* options,
         }
         else
         {
-            options->trusted_certs = copied_value;
+            options->trusted_certs_buffer = shared_value;
+            options->trusted_certs = (const char*)CONSTBUFFER_GetContent(shared_value)->buffer;
             result = TLSIO_OPTIONS_RESULT_SUCCESS;
         }
     }
@@ -183,7 +309,8 @@ TLSIO_OPTIONS_RESULT tlsio_options_set(TLSIO_OPTIONS* options,
         }
         else
         {
-            options->x509_cert = copied_value;
+            options->x509_cert_buffer = shared_value;
+            options->x509_cert = (const char*)CONSTBUFFER_GetContent(shared_value)->buffer;
             result = TLSIO_OPTIONS_RESULT_SUCCESS;
         }
     }
@@ -202,7 +329,57 @@ TLSIO_OPTIONS_RESULT tlsio_options_set(TLSIO_OPTIONS* options,
         }
         else
         {
-            options->x509_key = copied_value;
+            options->x509_key_buffer = shared_value;
+            options->x509_key = (const char*)CONSTBUFFER_GetContent(shared_value)->buffer;
+            result = TLSIO_OPTIONS_RESULT_SUCCESS;
+        }
+    }
+    else if (strcmp(OPTION_TLS_GROUPS, optionName) == 0)
+    {
+        uint16_t group_ids[TLSIO_OPTIONS_MAX_LIST_COUNT];
+        size_t group_count;
+
+        if ((options->supported_options & TLSIO_OPTION_BIT_GROUPS) == 0)
+        {
+            LogError("Groups option not supported");
+            result = TLSIO_OPTIONS_RESULT_ERROR;
+        }
+        else if (parse_name_list(copied_value, tls_groups, sizeof(tls_groups) / sizeof(tls_groups[0]), group_ids, &group_count) != 0)
+        {
+            LogError("Invalid groups option: %s", copied_value);
+            result = TLSIO_OPTIONS_RESULT_ERROR;
+        }
+        else
+        {
+            // Unlike the certificates the lists may be changed, the next handshake uses the last one set
+            free((void*)options->groups);
+            options->groups = copied_value;
+            (void)memcpy(options->group_ids, group_ids, group_count * sizeof(uint16_t));
+            options->group_count = group_count;
+            result = TLSIO_OPTIONS_RESULT_SUCCESS;
+        }
+    }
+    else if (strcmp(OPTION_TLS_SIGNATURE_ALGORITHMS, optionName) == 0)
+    {
+        uint16_t signature_algorithm_ids[TLSIO_OPTIONS_MAX_LIST_COUNT];
+        size_t signature_algorithm_count;
+
+        if ((options->supported_options & TLSIO_OPTION_BIT_SIGNATURE_ALGORITHMS) == 0)
+        {
+            LogError("Signature algorithms option not supported");
+            result = TLSIO_OPTIONS_RESULT_ERROR;
+        }
+        else if (parse_name_list(copied_value, tls_signature_algorithms, sizeof(tls_signature_algorithms) / sizeof(tls_signature_algorithms[0]), signature_algorithm_ids, &signature_algorithm_count) != 0)
+        {
+            LogError("Invalid signature algorithms option: %s", copied_value);
+            result = TLSIO_OPTIONS_RESULT_ERROR;
+        }
+        else
+        {
+            free((void*)options->signature_algorithms);
+            options->signature_algorithms = copied_value;
+            (void)memcpy(options->signature_algorithm_ids, signature_algorithm_ids, signature_algorithm_count * sizeof(uint16_t));
+            options->signature_algorithm_count = signature_algorithm_count;
             result = TLSIO_OPTIONS_RESULT_SUCCESS;
         }
     }
@@ -215,6 +392,7 @@ TLSIO_OPTIONS_RESULT tlsio_options_set(TLSIO_OPTIONS* options,
     if (result != TLSIO_OPTIONS_RESULT_SUCCESS)
     {
         free(copied_value);
+        release_shared_string(shared_value);
     }
 
     return result;
@@ -266,13 +444,31 @@ OPTIONHANDLER_HANDLE tlsio_options_retrieve_options_ex(TLSIO_OPTIONS* options,
         }
         else if (
                 (options->trusted_certs != NULL) &&
-                (OptionHandler_AddOption(result, OPTION_TRUSTED_CERT, options->trusted_certs) != OPTIONHANDLER_OK)
+                (OptionHandler_AddSharedOption(result, OPTION_TRUSTED_CERT, options->trusted_certs_buffer) != OPTIONHANDLER_OK)
                 )
         {
             LogError("unable to save TrustedCerts option");
             OptionHandler_Destroy(result);
             result = NULL;
         }
+        else if (
+                (options->groups != NULL) &&
+                (OptionHandler_AddOption(result, OPTION_TLS_GROUPS, options->groups) != OPTIONHANDLER_OK)
+                )
+        {
+            LogError("unable to save tls_groups option");
+            OptionHandler_Destroy(result);
+            result = NULL;
+        }
+        else if (
+                (options->signature_algorithms != NULL) &&
+                (OptionHandler_AddOption(result, OPTION_TLS_SIGNATURE_ALGORITHMS, options->signature_algorithms) != OPTIONHANDLER_OK)
+                )
+        {
+            LogError("unable to save tls_signature_algorithms option");
+            OptionHandler_Destroy(result);
+            result = NULL;
+        }
         else if (options->x509_type != TLSIO_OPTIONS_x509_TYPE_UNSPECIFIED)
         {
             const char* x509_cert_option;
@@ -288,8 +484,8 @@ OPTIONHANDLER_HANDLE tlsio_options_retrieve_options_ex(TLSIO_OPTIONS* options,
                 x509_key_option = SU_OPTION_X509_PRIVATE_KEY;
             }
             if (
-                (options->x509_cert != NULL) &&
-                (OptionHandler_AddOption(result, x509_cert_option, options->x509_cert) != OPTIONHANDLER_OK)
+                (options->x509_cert_buffer != NULL) &&
+                (OptionHandler_AddSharedOption(result, x509_cert_option, options->x509_cert_buffer) != OPTIONHANDLER_OK)
                 )
             {
                 LogError("unable to save x509 cert option");
@@ -297,8 +493,8 @@ OPTIONHANDLER_HANDLE tlsio_options_retrieve_options_ex(TLSIO_OPTIONS* options,
                 result = NULL;
             }
             else if (
-                (options->x509_key != NULL) &&
-                (OptionHandler_AddOption(result, x509_key_option, options->x509_key) != OPTIONHANDLER_OK)
+                (options->x509_key_buffer != NULL) &&
+                (OptionHandler_AddSharedOption(result, x509_key_option, options->x509_key_buffer) != OPTIONHANDLER_OK)
                 )
             {
                 LogError("unable to save x509 key option");
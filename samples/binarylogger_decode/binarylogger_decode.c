@@ -0,0 +1,86 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* Prints the lines of a file written by binarylogger the way consolelogger_log would have:
+       binarylogger_decode <file> */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "azure_c_shared_utility/binarylogger.h"
+
+static void print_line(void* context, LOG_CATEGORY log_category, const char* file, const char* func, int line, unsigned int options, const char* message)
+{
+    FILE* out = (FILE*)context;
+
+    switch (log_category)
+    {
+    case AZ_LOG_INFO:
+        (void)fprintf(out, "Info: ");
+        break;
+    case AZ_LOG_ERROR:
+        (void)fprintf(out, "Error: File:%s Func:%s Line:%d ", (file == NULL) ? "" : file, (func == NULL) ? "" : func, line);
+        break;
+    default:
+        break;
+    }
+
+    (void)fprintf(out, "%s", message);
+    if ((options & LOG_LINE) != 0)
+    {
+        (void)fprintf(out, "\r\n");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+    FILE* file;
+
+    if (argc != 2)
+    {
+        (void)fprintf(stderr, "usage: %s <file>\n", argv[0]);
+        result = 2;
+    }
+    else if ((file = fopen(argv[1], "rb")) == NULL)
+    {
+        (void)fprintf(stderr, "cannot open %s\n", argv[1]);
+        result = 1;
+    }
+    else
+    {
+        unsigned char* data = NULL;
+        size_t size = 0;
+        size_t capacity = 0;
+        size_t read_size;
+
+        result = 0;
+        do
+        {
+            if (size == capacity)
+            {
+                unsigned char* new_data;
+                capacity = (capacity == 0) ? 64 * 1024 : capacity * 2;
+                if ((new_data = (unsigned char*)realloc(data, capacity)) == NULL)
+                {
+                    (void)fprintf(stderr, "out of memory\n");
+                    result = 1;
+                    break;
+                }
+                data = new_data;
+            }
+            read_size = fread(data + size, 1, capacity - size, file);
+            size += read_size;
+        } while (read_size > 0);
+        (void)fclose(file);
+
+        if ((result == 0) && (binarylogger_decode(data, size, print_line, stdout) != 0))
+        {
+            (void)fprintf(stderr, "%s is not a complete binarylogger file\n", argv[1]);
+            result = 1;
+        }
+
+        free(data);
+    }
+
+    return result;
+}
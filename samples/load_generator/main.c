@@ -0,0 +1,1294 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* Simulates many devices, each with its own xio stack sending messages to an echo server, to size a deployment
+   and to give the performance work a reference workload.
+
+   load_generator [-host name -port port [-tls] [-cafile path] [-ws resource -wsprotocol protocol]]
+                  [-clients count] [-threads count] [-size bytes] [-rate messages_per_second] [-window messages]
+                  [-duration seconds] [-churn reconnects_per_second]
+
+   Without -host the clients connect to a plain echo server started in a thread of this process on the loopback
+   interface. -tls and -ws need a -host echo server speaking TLS or WebSocket; -cafile gives the certificates it
+   is trusted with (OPTION_TRUSTED_CERT_FILE). The stacks are created with xio_stack_create.
+
+   The clients are spread over the threads, each thread working its clients with xio_dowork_ex. A client sends
+   a message every 1/rate second, or when the rate is 0 keeps window messages in flight; a send that would put
+   more than window messages in flight is skipped and counted. -churn closes that many open clients per second,
+   which then reconnect. After -duration seconds the clients stop sending, wait for their echoes and close.
+   One CSV line is printed on stdout:
+
+   stack,clients,threads,message_size,rate,window,duration_s,churn,ramp_us,messages,msgs_per_second,mb_per_second,
+   p50_us,p90_us,p99_us,p999_us,max_us,connects,connect_p50_us,connect_p99_us,errors,skipped_sends,cpu_percent,bytes_per_connection
+
+   The latency of a message is the time from its xio_send to the reception of its last echoed byte and the one of a
+   connect the time from xio_open to its open complete, both within 1/16 of their value. ramp_us is the time it took
+   for all the clients to be open at once. cpu_percent is the CPU time of the process over the run, the built-in echo
+   server included, 100 being one processor. bytes_per_connection, the memory allocated by the library for each open
+   client once they all are, is only given when the library is built with memory_trace or use_gballoc_arena.
+
+   Thousands of clients need as many file descriptors (twice as many with the built-in echo server): the soft limit
+   is raised to the hard one. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/resource.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/xio_stack.h"
+
+#define DEFAULT_CLIENT_COUNT 100
+#define DEFAULT_THREAD_COUNT 1
+#define DEFAULT_MESSAGE_SIZE 256
+#define DEFAULT_RATE 10
+#define DEFAULT_WINDOW 16
+#define DEFAULT_DURATION_S 10
+#define TIMEOUT_US (10 * 1000 * 1000)
+/* how long a client whose connection failed waits before connecting again */
+#define RETRY_DELAY_US (1000 * 1000)
+/* the opens a thread has in progress at once, so that a large -clients ramps up instead of flooding the server */
+#define MAX_OPENING_PER_THREAD 64
+#define ECHO_BUFFER_SIZE (64 * 1024)
+
+/* latencies are counted in 16 linear sub-buckets per power of 2 */
+#define HISTOGRAM_SUB_BUCKET_BITS 4
+#define HISTOGRAM_SUB_BUCKET_COUNT (1 << HISTOGRAM_SUB_BUCKET_BITS)
+#define HISTOGRAM_BUCKET_COUNT ((64 - HISTOGRAM_SUB_BUCKET_BITS + 1) * HISTOGRAM_SUB_BUCKET_COUNT)
+
+typedef struct LOAD_OPTIONS_TAG
+{
+    const char* host;
+    int port;
+    bool use_tls;
+    const char* ca_file;
+    const char* ws_resource_name;
+    const char* ws_protocol;
+    size_t client_count;
+    size_t thread_count;
+    size_t message_size;
+    size_t rate;
+    size_t window;
+    size_t duration_s;
+    size_t churn;
+} LOAD_OPTIONS;
+
+/* latency histogram */
+
+typedef struct LATENCY_HISTOGRAM_TAG
+{
+    uint64_t counts[HISTOGRAM_BUCKET_COUNT];
+    uint64_t total;
+    uint64_t max;
+} LATENCY_HISTOGRAM;
+
+static size_t histogram_bucket(uint64_t value)
+{
+    size_t result;
+
+    if (value < HISTOGRAM_SUB_BUCKET_COUNT)
+    {
+        result = (size_t)value;
+    }
+    else
+    {
+        size_t exponent = HISTOGRAM_SUB_BUCKET_BITS;
+        while ((exponent < 63) && ((value >> (exponent + 1)) != 0))
+        {
+            exponent++;
+        }
+        result = ((exponent - HISTOGRAM_SUB_BUCKET_BITS + 1) * HISTOGRAM_SUB_BUCKET_COUNT) +
+            (size_t)((value >> (exponent - HISTOGRAM_SUB_BUCKET_BITS)) & (HISTOGRAM_SUB_BUCKET_COUNT - 1));
+    }
+
+    return result;
+}
+
+/* the lowest value counted in a bucket */
+static uint64_t histogram_bucket_value(size_t bucket)
+{
+    size_t row = bucket / HISTOGRAM_SUB_BUCKET_COUNT;
+    uint64_t sub_bucket = bucket % HISTOGRAM_SUB_BUCKET_COUNT;
+    return (row == 0) ? sub_bucket : ((HISTOGRAM_SUB_BUCKET_COUNT + sub_bucket) << (row - 1));
+}
+
+static void histogram_add(LATENCY_HISTOGRAM* histogram, uint64_t value)
+{
+    histogram->counts[histogram_bucket(value)]++;
+    histogram->total++;
+    if (value > histogram->max)
+    {
+        histogram->max = value;
+    }
+}
+
+static void histogram_merge(LATENCY_HISTOGRAM* histogram, const LATENCY_HISTOGRAM* other)
+{
+    size_t i;
+    for (i = 0; i < HISTOGRAM_BUCKET_COUNT; i++)
+    {
+        histogram->counts[i] += other->counts[i];
+    }
+    histogram->total += other->total;
+    if (other->max > histogram->max)
+    {
+        histogram->max = other->max;
+    }
+}
+
+/* permille is the share of the values at or below the returned one, 500 for the median */
+static uint64_t histogram_percentile(const LATENCY_HISTOGRAM* histogram, unsigned int permille)
+{
+    uint64_t result = 0;
+    uint64_t rank = ((histogram->total * permille) + 999) / 1000;
+    uint64_t seen = 0;
+    size_t i;
+
+    for (i = 0; (i < HISTOGRAM_BUCKET_COUNT) && (seen < rank); i++)
+    {
+        seen += histogram->counts[i];
+        result = histogram_bucket_value(i);
+    }
+
+    return result;
+}
+
+/* built-in echo server: one thread polling every connection, sending back what it reads */
+
+typedef struct ECHO_PEER_TAG
+{
+    /* what a send could not take yet, no more is read until it is sent */
+    unsigned char* pending;
+    size_t pending_size;
+    size_t pending_offset;
+} ECHO_PEER;
+
+typedef struct ECHO_SERVER_TAG
+{
+    int listen_socket;
+    int port;
+    int stop_pipe[2];
+    /* 0 is the listening socket, 1 the stop pipe, then one entry for each peer */
+    struct pollfd* poll_fds;
+    ECHO_PEER* peers;
+    size_t count;
+    size_t capacity;
+    unsigned char buffer[ECHO_BUFFER_SIZE];
+} ECHO_SERVER;
+
+static int set_non_blocking(int socket)
+{
+    int flags = fcntl(socket, F_GETFL, 0);
+    return ((flags == -1) || (fcntl(socket, F_SETFL, flags | O_NONBLOCK) == -1)) ? __FAILURE__ : 0;
+}
+
+static void echo_server_remove(ECHO_SERVER* server, size_t index)
+{
+    (void)close(server->poll_fds[index].fd);
+    free(server->peers[index].pending);
+    server->count--;
+    server->poll_fds[index] = server->poll_fds[server->count];
+    server->peers[index] = server->peers[server->count];
+}
+
+static void echo_server_accept(ECHO_SERVER* server)
+{
+    int socket;
+
+    while ((socket = accept(server->listen_socket, NULL, NULL)) >= 0)
+    {
+        int no_delay = 1;
+
+        if ((server->count == server->capacity) && (server->capacity <= (SIZE_MAX / 2) / sizeof(ECHO_PEER)))
+        {
+            size_t capacity = server->capacity * 2;
+            struct pollfd* poll_fds = (struct pollfd*)realloc(server->poll_fds, capacity * sizeof(struct pollfd));
+            ECHO_PEER* peers;
+
+            if (poll_fds != NULL)
+            {
+                server->poll_fds = poll_fds;
+                if ((peers = (ECHO_PEER*)realloc(server->peers, capacity * sizeof(ECHO_PEER))) != NULL)
+                {
+                    server->peers = peers;
+                    server->capacity = capacity;
+                }
+            }
+        }
+
+        if ((server->count == server->capacity) ||
+            (set_non_blocking(socket) != 0))
+        {
+            (void)fprintf(stderr, "echo server: cannot take one more connection\n");
+            (void)close(socket);
+        }
+        else
+        {
+            (void)setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+            server->poll_fds[server->count].fd = socket;
+            server->poll_fds[server->count].events = POLLIN;
+            server->poll_fds[server->count].revents = 0;
+            server->peers[server->count].pending = NULL;
+            server->peers[server->count].pending_size = 0;
+            server->peers[server->count].pending_offset = 0;
+            server->count++;
+        }
+    }
+}
+
+/* returns false once the peer is closed or failed */
+static bool echo_server_flush(ECHO_SERVER* server, size_t index)
+{
+    ECHO_PEER* peer = &server->peers[index];
+    bool result = true;
+
+    while (result && (peer->pending_offset < peer->pending_size))
+    {
+        ssize_t sent = send(server->poll_fds[index].fd, peer->pending + peer->pending_offset, peer->pending_size - peer->pending_offset, MSG_NOSIGNAL);
+        if (sent > 0)
+        {
+            peer->pending_offset += (size_t)sent;
+        }
+        else if ((sent < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK)))
+        {
+            break;
+        }
+        else
+        {
+            result = false;
+        }
+    }
+
+    if (result && (peer->pending_offset == peer->pending_size))
+    {
+        free(peer->pending);
+        peer->pending = NULL;
+        peer->pending_size = 0;
+        peer->pending_offset = 0;
+    }
+    server->poll_fds[index].events = (peer->pending == NULL) ? POLLIN : POLLOUT;
+
+    return result;
+}
+
+static bool echo_server_echo(ECHO_SERVER* server, size_t index)
+{
+    bool result;
+    ssize_t received = recv(server->poll_fds[index].fd, server->buffer, sizeof(server->buffer), 0);
+
+    if (received > 0)
+    {
+        ECHO_PEER* peer = &server->peers[index];
+        ssize_t sent = send(server->poll_fds[index].fd, server->buffer, (size_t)received, MSG_NOSIGNAL);
+
+        if ((sent < 0) && (errno != EAGAIN) && (errno != EWOULDBLOCK))
+        {
+            result = false;
+        }
+        else
+        {
+            size_t sent_size = (sent < 0) ? 0 : (size_t)sent;
+
+            if (sent_size == (size_t)received)
+            {
+                result = true;
+            }
+            else if ((peer->pending = (unsigned char*)malloc((size_t)received - sent_size)) == NULL)
+            {
+                (void)fprintf(stderr, "echo server: cannot keep the bytes to send\n");
+                result = false;
+            }
+            else
+            {
+                (void)memcpy(peer->pending, server->buffer + sent_size, (size_t)received - sent_size);
+                peer->pending_size = (size_t)received - sent_size;
+                peer->pending_offset = 0;
+                server->poll_fds[index].events = POLLOUT;
+                result = true;
+            }
+        }
+    }
+    else
+    {
+        result = (received < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK));
+    }
+
+    return result;
+}
+
+static int echo_server_run(void* context)
+{
+    int result = 0;
+    ECHO_SERVER* server = (ECHO_SERVER*)context;
+    bool stopping = false;
+
+    while (!stopping)
+    {
+        if (poll(server->poll_fds, (nfds_t)server->count, -1) < 0)
+        {
+            if (errno != EINTR)
+            {
+                (void)fprintf(stderr, "echo server: poll failed\n");
+                result = __FAILURE__;
+                stopping = true;
+            }
+        }
+        else
+        {
+            size_t i;
+
+            /* backwards, since removing a peer moves the last one in its place */
+            for (i = server->count - 1; i >= 2; i--)
+            {
+                short revents = server->poll_fds[i].revents;
+                bool is_open = true;
+
+                if ((revents & POLLOUT) != 0)
+                {
+                    is_open = echo_server_flush(server, i);
+                }
+                else if ((revents & (POLLIN | POLLHUP | POLLERR)) != 0)
+                {
+                    is_open = echo_server_echo(server, i);
+                }
+
+                if (!is_open)
+                {
+                    echo_server_remove(server, i);
+                }
+            }
+
+            if ((server->poll_fds[1].revents & POLLIN) != 0)
+            {
+                stopping = true;
+            }
+            else if ((server->poll_fds[0].revents & POLLIN) != 0)
+            {
+                echo_server_accept(server);
+            }
+        }
+    }
+
+    while (server->count > 2)
+    {
+        echo_server_remove(server, server->count - 1);
+    }
+
+    return result;
+}
+
+static int echo_server_start(ECHO_SERVER* server)
+{
+    int result;
+    struct sockaddr_in address;
+    socklen_t address_length = sizeof(address);
+
+    (void)memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+
+    server->capacity = 64;
+    server->count = 2;
+
+    if ((server->poll_fds = (struct pollfd*)malloc(server->capacity * sizeof(struct pollfd))) == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else if ((server->peers = (ECHO_PEER*)malloc(server->capacity * sizeof(ECHO_PEER))) == NULL)
+    {
+        free(server->poll_fds);
+        result = __FAILURE__;
+    }
+    else if (pipe(server->stop_pipe) != 0)
+    {
+        free(server->peers);
+        free(server->poll_fds);
+        result = __FAILURE__;
+    }
+    else if ((server->listen_socket = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+    {
+        (void)close(server->stop_pipe[0]);
+        (void)close(server->stop_pipe[1]);
+        free(server->peers);
+        free(server->poll_fds);
+        result = __FAILURE__;
+    }
+    else if ((bind(server->listen_socket, (struct sockaddr*)&address, sizeof(address)) != 0) ||
+        (listen(server->listen_socket, SOMAXCONN) != 0) ||
+        (getsockname(server->listen_socket, (struct sockaddr*)&address, &address_length) != 0) ||
+        (set_non_blocking(server->listen_socket) != 0))
+    {
+        (void)close(server->listen_socket);
+        (void)close(server->stop_pipe[0]);
+        (void)close(server->stop_pipe[1]);
+        free(server->peers);
+        free(server->poll_fds);
+        result = __FAILURE__;
+    }
+    else
+    {
+        server->port = ntohs(address.sin_port);
+        server->poll_fds[0].fd = server->listen_socket;
+        server->poll_fds[0].events = POLLIN;
+        server->poll_fds[0].revents = 0;
+        server->poll_fds[1].fd = server->stop_pipe[0];
+        server->poll_fds[1].events = POLLIN;
+        server->poll_fds[1].revents = 0;
+        result = 0;
+    }
+
+    return result;
+}
+
+static void echo_server_stop(ECHO_SERVER* server)
+{
+    (void)close(server->listen_socket);
+    (void)close(server->stop_pipe[0]);
+    (void)close(server->stop_pipe[1]);
+    free(server->peers);
+    free(server->poll_fds);
+}
+
+/* clients */
+
+typedef enum CLIENT_STATE_TAG
+{
+    /* no stack, connects once its retry time is reached */
+    CLIENT_STATE_IDLE,
+    CLIENT_STATE_OPENING,
+    CLIENT_STATE_OPEN,
+    CLIENT_STATE_CLOSING,
+    /* closed for good, the run is over for it */
+    CLIENT_STATE_DONE
+} CLIENT_STATE;
+
+typedef struct LOAD_RUN_TAG
+{
+    const LOAD_OPTIONS* options;
+    const unsigned char* payload;
+    /* the clients send from start to end */
+    tickcounter_us_t start;
+    tickcounter_us_t end;
+    /* under lock: the open clients, and the first time they all were */
+    LOCK_HANDLE lock;
+    size_t open_count;
+    tickcounter_us_t ramp_end;
+    size_t memory_in_use;
+    size_t base_memory_in_use;
+} LOAD_RUN;
+
+typedef struct LOAD_WORKER_TAG LOAD_WORKER;
+
+typedef struct LOAD_CLIENT_TAG
+{
+    LOAD_WORKER* worker;
+    XIO_HANDLE io;
+    CLIENT_STATE state;
+    bool open_complete;
+    bool open_failed;
+    bool close_complete;
+    bool has_error;
+    /* when it was opened or closed, when it sends next, or when it connects again while idle */
+    tickcounter_us_t open_start;
+    tickcounter_us_t close_start;
+    tickcounter_us_t next_time;
+    /* the send time of the messages in flight, window entries used as a ring */
+    tickcounter_us_t* send_times;
+    size_t sent;
+    size_t completed;
+    uint64_t received_bytes;
+} LOAD_CLIENT;
+
+struct LOAD_WORKER_TAG
+{
+    LOAD_RUN* run;
+    LOAD_CLIENT* clients;
+    size_t client_count;
+    THREAD_HANDLE thread;
+    size_t opening_count;
+    tickcounter_us_t next_churn;
+    size_t next_churn_client;
+    LATENCY_HISTOGRAM latencies;
+    LATENCY_HISTOGRAM connect_latencies;
+    uint64_t messages;
+    uint64_t errors;
+    uint64_t skipped_sends;
+};
+
+static tickcounter_us_t now_us(void)
+{
+    tickcounter_us_t result;
+    if (tickcounter_get_monotonic_us(&result) != 0)
+    {
+        result = 0;
+    }
+    return result;
+}
+
+static void on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    LOAD_CLIENT* client = (LOAD_CLIENT*)context;
+    client->open_complete = true;
+    client->open_failed = (open_result != IO_OPEN_OK);
+}
+
+static void on_io_close_complete(void* context)
+{
+    LOAD_CLIENT* client = (LOAD_CLIENT*)context;
+    client->close_complete = true;
+}
+
+static void on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    LOAD_CLIENT* client = (LOAD_CLIENT*)context;
+    if ((send_result != IO_SEND_OK) && (send_result != IO_SEND_CANCELLED))
+    {
+        client->has_error = true;
+    }
+}
+
+static void on_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    LOAD_CLIENT* client = (LOAD_CLIENT*)context;
+    LOAD_WORKER* worker = client->worker;
+    const LOAD_OPTIONS* options = worker->run->options;
+    tickcounter_us_t now = now_us();
+    size_t checked = 0;
+
+    while ((checked < size) && !client->has_error)
+    {
+        size_t offset = (size_t)((client->received_bytes + checked) % options->message_size);
+        size_t chunk = options->message_size - offset;
+        if (chunk > size - checked)
+        {
+            chunk = size - checked;
+        }
+        if (memcmp(buffer + checked, worker->run->payload + offset, chunk) != 0)
+        {
+            (void)fprintf(stderr, "the echoed bytes differ from the sent ones\n");
+            client->has_error = true;
+        }
+        checked += chunk;
+    }
+
+    client->received_bytes += size;
+    while ((client->completed < client->sent) &&
+        (client->received_bytes >= (uint64_t)(client->completed + 1) * options->message_size))
+    {
+        histogram_add(&worker->latencies, now - client->send_times[client->completed % options->window]);
+        client->completed++;
+        worker->messages++;
+    }
+}
+
+static void on_io_error(void* context)
+{
+    LOAD_CLIENT* client = (LOAD_CLIENT*)context;
+    client->has_error = true;
+}
+
+static void count_open_client(LOAD_RUN* run, bool is_opened)
+{
+    if (Lock(run->lock) != LOCK_OK)
+    {
+        (void)fprintf(stderr, "cannot count the open clients\n");
+    }
+    else
+    {
+        if (!is_opened)
+        {
+            run->open_count--;
+        }
+        else if (++run->open_count == run->options->client_count)
+        {
+            if (run->ramp_end == 0)
+            {
+                run->ramp_end = now_us();
+#ifdef GB_DEBUG_ALLOC
+                run->memory_in_use = gballoc_getCurrentMemoryUsed();
+#endif
+            }
+        }
+        (void)Unlock(run->lock);
+    }
+}
+
+static void open_client(LOAD_CLIENT* client, tickcounter_us_t now)
+{
+    const LOAD_OPTIONS* options = client->worker->run->options;
+    XIO_STACK_CONFIG config;
+
+    (void)memset(&config, 0, sizeof(config));
+    config.hostname = options->host;
+    config.port = options->port;
+    config.tlsio_interface = options->use_tls ? platform_get_default_tlsio() : NULL;
+    config.ws_resource_name = options->ws_resource_name;
+    config.ws_protocol = options->ws_protocol;
+
+    client->open_complete = false;
+    client->open_failed = false;
+    client->close_complete = false;
+    client->has_error = false;
+    client->sent = 0;
+    client->completed = 0;
+    client->received_bytes = 0;
+    client->open_start = now;
+
+    if ((options->use_tls && (config.tlsio_interface == NULL)) ||
+        ((client->io = xio_stack_create(&config)) == NULL))
+    {
+        (void)fprintf(stderr, "cannot create the xio stack\n");
+        client->worker->errors++;
+        client->next_time = now + RETRY_DELAY_US;
+    }
+    else if ((options->ca_file != NULL) && (xio_setoption(client->io, OPTION_TRUSTED_CERT_FILE, options->ca_file) != 0))
+    {
+        (void)fprintf(stderr, "cannot set the trusted certificates file\n");
+        xio_destroy(client->io);
+        client->worker->errors++;
+        client->next_time = now + RETRY_DELAY_US;
+    }
+    else if (xio_open(client->io, on_io_open_complete, client, on_io_bytes_received, client, on_io_error, client) != 0)
+    {
+        (void)fprintf(stderr, "xio_open failed\n");
+        xio_destroy(client->io);
+        client->worker->errors++;
+        client->next_time = now + RETRY_DELAY_US;
+    }
+    else
+    {
+        client->state = CLIENT_STATE_OPENING;
+        client->worker->opening_count++;
+    }
+}
+
+static void close_client(LOAD_CLIENT* client, tickcounter_us_t now)
+{
+    client->close_start = now;
+    if (client->state == CLIENT_STATE_OPEN)
+    {
+        count_open_client(client->worker->run, false);
+    }
+
+    if (xio_close(client->io, on_io_close_complete, client) != 0)
+    {
+        client->close_complete = true;
+    }
+    client->state = CLIENT_STATE_CLOSING;
+}
+
+/* destroys the stack of a client that failed, it connects again after a while unless the run is over */
+static void fail_client(LOAD_CLIENT* client, tickcounter_us_t now, bool is_sending)
+{
+    if (client->state == CLIENT_STATE_OPEN)
+    {
+        count_open_client(client->worker->run, false);
+    }
+    else if (client->state == CLIENT_STATE_OPENING)
+    {
+        client->worker->opening_count--;
+    }
+
+    xio_destroy(client->io);
+    client->worker->errors++;
+    client->next_time = now + RETRY_DELAY_US;
+    client->state = is_sending ? CLIENT_STATE_IDLE : CLIENT_STATE_DONE;
+}
+
+static void send_messages(LOAD_CLIENT* client, tickcounter_us_t now)
+{
+    LOAD_WORKER* worker = client->worker;
+    const LOAD_OPTIONS* options = worker->run->options;
+    bool can_send = true;
+
+    while (can_send && !client->has_error)
+    {
+        bool is_due = (options->rate == 0) || (now >= client->next_time);
+        bool has_room = (client->sent - client->completed < options->window);
+
+        if (!is_due || ((options->rate == 0) && !has_room))
+        {
+            can_send = false;
+        }
+        else
+        {
+            if (options->rate != 0)
+            {
+                /* a client that fell behind by more than a second does not try to catch up */
+                client->next_time = (now - client->next_time > 1000000) ? now : client->next_time;
+                client->next_time += 1000000 / options->rate;
+            }
+
+            if (!has_room)
+            {
+                worker->skipped_sends++;
+            }
+            else
+            {
+                client->send_times[client->sent % options->window] = now;
+                client->sent++;
+                if (xio_send(client->io, worker->run->payload, options->message_size, on_send_complete, client) != 0)
+                {
+                    (void)fprintf(stderr, "xio_send failed\n");
+                    client->has_error = true;
+                }
+            }
+        }
+    }
+}
+
+/* returns true when the stack of the client made progress */
+static bool work_client(LOAD_CLIENT* client, tickcounter_us_t now, bool is_sending)
+{
+    LOAD_WORKER* worker = client->worker;
+    bool made_progress = false;
+
+    if (client->state == CLIENT_STATE_IDLE)
+    {
+        if (!is_sending)
+        {
+            client->state = CLIENT_STATE_DONE;
+        }
+        else if ((now >= client->next_time) && (worker->opening_count < MAX_OPENING_PER_THREAD))
+        {
+            open_client(client, now);
+            made_progress = true;
+        }
+    }
+
+    if ((client->state == CLIENT_STATE_OPENING) ||
+        (client->state == CLIENT_STATE_OPEN) ||
+        (client->state == CLIENT_STATE_CLOSING))
+    {
+        uint64_t next_deadline;
+
+        if ((client->state == CLIENT_STATE_OPEN) && is_sending)
+        {
+            send_messages(client, now);
+        }
+
+        if (xio_dowork_ex(client->io, &made_progress, &next_deadline) != 0)
+        {
+            made_progress = true;
+        }
+
+        if (client->state == CLIENT_STATE_OPENING)
+        {
+            if (client->open_complete && !client->open_failed)
+            {
+                worker->opening_count--;
+                histogram_add(&worker->connect_latencies, now_us() - client->open_start);
+                client->state = CLIENT_STATE_OPEN;
+                client->next_time = now;
+                count_open_client(worker->run, true);
+            }
+            else if (client->open_complete || client->has_error || (now - client->open_start > TIMEOUT_US))
+            {
+                (void)fprintf(stderr, "a client could not connect\n");
+                fail_client(client, now, is_sending);
+            }
+        }
+        else if (client->state == CLIENT_STATE_OPEN)
+        {
+            if (client->has_error)
+            {
+                (void)fprintf(stderr, "a client failed\n");
+                fail_client(client, now, is_sending);
+            }
+            else if (!is_sending && (client->completed == client->sent))
+            {
+                close_client(client, now);
+            }
+            else if (!is_sending && (now - worker->run->end > TIMEOUT_US))
+            {
+                (void)fprintf(stderr, "a client did not get all its echoes back\n");
+                worker->errors++;
+                close_client(client, now);
+            }
+        }
+        else if (client->close_complete || (now - client->close_start > TIMEOUT_US))
+        {
+            xio_destroy(client->io);
+            client->state = is_sending ? CLIENT_STATE_IDLE : CLIENT_STATE_DONE;
+            client->next_time = now;
+        }
+    }
+
+    return made_progress;
+}
+
+/* closes one more open client, which connects again */
+static void churn_client(LOAD_WORKER* worker, tickcounter_us_t now)
+{
+    size_t i;
+
+    for (i = 0; i < worker->client_count; i++)
+    {
+        LOAD_CLIENT* client = &worker->clients[(worker->next_churn_client + i) % worker->client_count];
+        if (client->state == CLIENT_STATE_OPEN)
+        {
+            worker->next_churn_client = (size_t)(client - worker->clients) + 1;
+            close_client(client, now);
+            break;
+        }
+    }
+}
+
+static int worker_run(void* context)
+{
+    LOAD_WORKER* worker = (LOAD_WORKER*)context;
+    const LOAD_OPTIONS* options = worker->run->options;
+    /* the churn of the run is shared by the threads */
+    tickcounter_us_t churn_period = (options->churn == 0) ? 0 : (((tickcounter_us_t)options->thread_count * 1000000) / options->churn);
+    bool is_running = true;
+
+    worker->next_churn = worker->run->start + churn_period;
+
+    while (is_running)
+    {
+        tickcounter_us_t now = now_us();
+        bool is_sending = (now < worker->run->end);
+        bool made_progress = false;
+        size_t i;
+
+        if (is_sending && (churn_period != 0) && (now >= worker->next_churn))
+        {
+            churn_client(worker, now);
+            worker->next_churn += churn_period;
+        }
+
+        is_running = false;
+        for (i = 0; i < worker->client_count; i++)
+        {
+            made_progress = work_client(&worker->clients[i], now, is_sending) || made_progress;
+            is_running = is_running || (worker->clients[i].state != CLIENT_STATE_DONE);
+        }
+
+        if (is_running && !made_progress)
+        {
+            ThreadAPI_Sleep(1);
+        }
+    }
+
+    return 0;
+}
+
+static double cpu_seconds(void)
+{
+    struct rusage usage;
+    double result;
+
+    if (getrusage(RUSAGE_SELF, &usage) != 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        result = (double)usage.ru_utime.tv_sec + ((double)usage.ru_utime.tv_usec / 1e6) +
+            (double)usage.ru_stime.tv_sec + ((double)usage.ru_stime.tv_usec / 1e6);
+    }
+
+    return result;
+}
+
+static void print_report(const LOAD_RUN* run, LOAD_WORKER* workers, tickcounter_us_t elapsed, double cpu)
+{
+    const LOAD_OPTIONS* options = run->options;
+    LATENCY_HISTOGRAM* latencies = (LATENCY_HISTOGRAM*)calloc(1, sizeof(LATENCY_HISTOGRAM));
+    LATENCY_HISTOGRAM* connect_latencies = (LATENCY_HISTOGRAM*)calloc(1, sizeof(LATENCY_HISTOGRAM));
+
+    if ((latencies == NULL) || (connect_latencies == NULL))
+    {
+        (void)fprintf(stderr, "cannot allocate the report\n");
+    }
+    else
+    {
+        double seconds = (elapsed == 0) ? 1e-6 : ((double)elapsed / 1e6);
+        uint64_t messages = 0;
+        uint64_t errors = 0;
+        uint64_t skipped_sends = 0;
+        char stack[64];
+        size_t i;
+
+        for (i = 0; i < options->thread_count; i++)
+        {
+            histogram_merge(latencies, &workers[i].latencies);
+            histogram_merge(connect_latencies, &workers[i].connect_latencies);
+            messages += workers[i].messages;
+            errors += workers[i].errors;
+            skipped_sends += workers[i].skipped_sends;
+        }
+
+        (void)snprintf(stack, sizeof(stack), "%s%ssocketio",
+            (options->ws_resource_name != NULL) ? "wsio/" : "", options->use_tls ? "tlsio/" : "");
+        (void)printf("stack,clients,threads,message_size,rate,window,duration_s,churn,ramp_us,messages,msgs_per_second,mb_per_second,"
+            "p50_us,p90_us,p99_us,p999_us,max_us,connects,connect_p50_us,connect_p99_us,errors,skipped_sends,cpu_percent,bytes_per_connection\n");
+        (void)printf("%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%llu,%llu,%.1f,%.2f,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%.1f,",
+            stack, (unsigned long)options->client_count, (unsigned long)options->thread_count, (unsigned long)options->message_size,
+            (unsigned long)options->rate, (unsigned long)options->window, (unsigned long)options->duration_s, (unsigned long)options->churn,
+            (unsigned long long)((run->ramp_end == 0) ? 0 : (run->ramp_end - run->start)), (unsigned long long)messages,
+            (double)messages / seconds, ((double)messages * (double)options->message_size) / (seconds * 1e6),
+            (unsigned long long)histogram_percentile(latencies, 500), (unsigned long long)histogram_percentile(latencies, 900),
+            (unsigned long long)histogram_percentile(latencies, 990), (unsigned long long)histogram_percentile(latencies, 999),
+            (unsigned long long)latencies->max, (unsigned long long)connect_latencies->total,
+            (unsigned long long)histogram_percentile(connect_latencies, 500), (unsigned long long)histogram_percentile(connect_latencies, 990),
+            (unsigned long long)errors, (unsigned long long)skipped_sends, (cpu * 100.0) / seconds);
+#ifdef GB_DEBUG_ALLOC
+        if (run->ramp_end != 0)
+        {
+            (void)printf("%lu", (unsigned long)((run->memory_in_use - run->base_memory_in_use) / options->client_count));
+        }
+#endif
+        (void)printf("\n");
+    }
+
+    free(connect_latencies);
+    free(latencies);
+}
+
+static int run_load(const LOAD_OPTIONS* options)
+{
+    int result;
+    LOAD_RUN run;
+    LOAD_WORKER* workers;
+    LOAD_CLIENT* clients;
+    tickcounter_us_t* send_times;
+    unsigned char* payload;
+
+    (void)memset(&run, 0, sizeof(run));
+    run.options = options;
+
+    if (((payload = (unsigned char*)malloc(options->message_size)) == NULL) ||
+        ((workers = (LOAD_WORKER*)calloc(options->thread_count, sizeof(LOAD_WORKER))) == NULL))
+    {
+        (void)fprintf(stderr, "cannot allocate the threads\n");
+        free(payload);
+        result = __FAILURE__;
+    }
+    else if ((clients = (LOAD_CLIENT*)calloc(options->client_count, sizeof(LOAD_CLIENT))) == NULL)
+    {
+        (void)fprintf(stderr, "cannot allocate the clients\n");
+        free(workers);
+        free(payload);
+        result = __FAILURE__;
+    }
+    else if ((send_times = (tickcounter_us_t*)calloc(options->client_count, options->window * sizeof(tickcounter_us_t))) == NULL)
+    {
+        (void)fprintf(stderr, "cannot allocate the send times\n");
+        free(clients);
+        free(workers);
+        free(payload);
+        result = __FAILURE__;
+    }
+    else if ((run.lock = Lock_Init()) == NULL)
+    {
+        (void)fprintf(stderr, "cannot create the lock\n");
+        free(send_times);
+        free(clients);
+        free(workers);
+        free(payload);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t started_count;
+        size_t i;
+        double cpu_start = cpu_seconds();
+        tickcounter_us_t end;
+
+        for (i = 0; i < options->message_size; i++)
+        {
+            payload[i] = (unsigned char)((i * 7) + 1);
+        }
+        run.payload = payload;
+
+        /* client i goes to thread i modulo the thread count */
+        for (i = 0; i < options->thread_count; i++)
+        {
+            workers[i].run = &run;
+            workers[i].clients = clients + ((options->client_count * i) / options->thread_count);
+            workers[i].client_count = ((options->client_count * (i + 1)) / options->thread_count) - ((options->client_count * i) / options->thread_count);
+        }
+        for (i = 0; i < options->client_count; i++)
+        {
+            size_t worker_index = 0;
+            while ((worker_index + 1 < options->thread_count) && (clients + i >= workers[worker_index + 1].clients))
+            {
+                worker_index++;
+            }
+            clients[i].worker = &workers[worker_index];
+            clients[i].send_times = send_times + (i * options->window);
+            clients[i].state = CLIENT_STATE_IDLE;
+        }
+
+#ifdef GB_DEBUG_ALLOC
+        run.base_memory_in_use = gballoc_getCurrentMemoryUsed();
+#endif
+        run.start = now_us();
+        run.end = run.start + ((tickcounter_us_t)options->duration_s * 1000000);
+
+        for (started_count = 0; started_count < options->thread_count; started_count++)
+        {
+            if (ThreadAPI_Create(&workers[started_count].thread, worker_run, &workers[started_count]) != THREADAPI_OK)
+            {
+                (void)fprintf(stderr, "cannot start a thread\n");
+                break;
+            }
+        }
+
+        /* the threads started run their clients to the end anyway */
+        for (i = 0; i < started_count; i++)
+        {
+            int thread_result;
+            (void)ThreadAPI_Join(workers[i].thread, &thread_result);
+        }
+        end = now_us();
+
+        if (started_count != options->thread_count)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            print_report(&run, workers, end - run.start, cpu_seconds() - cpu_start);
+            result = 0;
+        }
+
+        (void)Lock_Deinit(run.lock);
+        free(send_times);
+        free(clients);
+        free(workers);
+        free(payload);
+    }
+
+    return result;
+}
+
+static int parse_size(const char* text, size_t* value)
+{
+    char* end;
+    unsigned long parsed = strtoul(text, &end, 10);
+    int result;
+
+    if ((end == text) || (*end != '\0'))
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        *value = (size_t)parsed;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int parse_options(int argc, char** argv, LOAD_OPTIONS* options)
+{
+    int result = 0;
+    int i;
+    size_t port = 0;
+
+    (void)memset(options, 0, sizeof(LOAD_OPTIONS));
+    options->client_count = DEFAULT_CLIENT_COUNT;
+    options->thread_count = DEFAULT_THREAD_COUNT;
+    options->message_size = DEFAULT_MESSAGE_SIZE;
+    options->rate = DEFAULT_RATE;
+    options->window = DEFAULT_WINDOW;
+    options->duration_s = DEFAULT_DURATION_S;
+
+    for (i = 1; (i < argc) && (result == 0); i++)
+    {
+        if (strcmp(argv[i], "-tls") == 0)
+        {
+            options->use_tls = true;
+        }
+        else if ((i + 1 < argc) && (strcmp(argv[i], "-host") == 0))
+        {
+            options->host = argv[++i];
+        }
+        else if ((i + 1 < argc) && (strcmp(argv[i], "-port") == 0))
+        {
+            result = parse_size(argv[++i], &port);
+        }
+        else if ((i + 1 < argc) && (strcmp(argv[i], "-cafile") == 0))
+        {
+            options->ca_file = argv[++i];
+        }
+        else if ((i + 1 < argc) && (strcmp(argv[i], "-ws") == 0))
+        {
+            options->ws_resource_name = argv[++i];
+        }
+        else if ((i + 1 < argc) && (strcmp(argv[i], "-wsprotocol") == 0))
+        {
+            options->ws_protocol = argv[++i];
+        }
+        else if ((i + 1 < argc) && (strcmp(argv[i], "-clients") == 0))
+        {
+            result = parse_size(argv[++i], &options->client_count);
+        }
+        else if ((i + 1 < argc) && (strcmp(argv[i], "-threads") == 0))
+        {
+            result = parse_size(argv[++i], &options->thread_count);
+        }
+        else if ((i + 1 < argc) && (strcmp(argv[i], "-size") == 0))
+        {
+            result = parse_size(argv[++i], &options->message_size);
+        }
+        else if ((i + 1 < argc) && (strcmp(argv[i], "-rate") == 0))
+        {
+            result = parse_size(argv[++i], &options->rate);
+        }
+        else if ((i + 1 < argc) && (strcmp(argv[i], "-window") == 0))
+        {
+            result = parse_size(argv[++i], &options->window);
+        }
+        else if ((i + 1 < argc) && (strcmp(argv[i], "-duration") == 0))
+        {
+            result = parse_size(argv[++i], &options->duration_s);
+        }
+        else if ((i + 1 < argc) && (strcmp(argv[i], "-churn") == 0))
+        {
+            result = parse_size(argv[++i], &options->churn);
+        }
+        else
+        {
+            result = __FAILURE__;
+        }
+    }
+
+    options->port = (int)port;
+
+    if ((result == 0) &&
+        ((options->client_count == 0) || (options->thread_count == 0) || (options->thread_count > options->client_count) ||
+        (options->message_size == 0) || (options->window == 0) || (options->rate > 1000000) || (port > 65535) ||
+        ((options->host != NULL) && (port == 0)) || ((options->ws_resource_name != NULL) && (options->ws_protocol == NULL))))
+    {
+        result = __FAILURE__;
+    }
+    if ((result == 0) && (options->host == NULL) && (options->use_tls || (options->ws_resource_name != NULL)))
+    {
+        (void)fprintf(stderr, "-tls and -ws need a -host echo server, the built-in one echoes plain bytes\n");
+        result = __FAILURE__;
+    }
+
+    return result;
+}
+
+/* every client takes a descriptor, and one more on the built-in echo server */
+static void raise_file_limit(void)
+{
+    struct rlimit limit;
+
+    if ((getrlimit(RLIMIT_NOFILE, &limit) == 0) && (limit.rlim_cur < limit.rlim_max))
+    {
+        limit.rlim_cur = limit.rlim_max;
+        (void)setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+    LOAD_OPTIONS options;
+
+    if (parse_options(argc, argv, &options) != 0)
+    {
+        (void)fprintf(stderr, "usage: load_generator [-host name -port port [-tls] [-cafile path] [-ws resource -wsprotocol protocol]]\n"
+            "                      [-clients count] [-threads count] [-size bytes] [-rate messages_per_second] [-window messages]\n"
+            "                      [-duration seconds] [-churn reconnects_per_second]\n");
+        result = __FAILURE__;
+    }
+#ifdef GB_DEBUG_ALLOC
+    else if (gballoc_init() != 0)
+    {
+        (void)fprintf(stderr, "cannot initialize gballoc\n");
+        result = __FAILURE__;
+    }
+#endif
+    else
+    {
+        (void)signal(SIGPIPE, SIG_IGN);
+        raise_file_limit();
+
+        if (platform_init() != 0)
+        {
+            (void)fprintf(stderr, "cannot initialize the platform\n");
+            result = __FAILURE__;
+        }
+        else if (options.host != NULL)
+        {
+            result = run_load(&options);
+            platform_deinit();
+        }
+        else
+        {
+            ECHO_SERVER* server = (ECHO_SERVER*)malloc(sizeof(ECHO_SERVER));
+
+            if ((server == NULL) || (echo_server_start(server) != 0))
+            {
+                (void)fprintf(stderr, "cannot listen on the loopback interface\n");
+                result = __FAILURE__;
+            }
+            else
+            {
+                THREAD_HANDLE server_thread;
+
+                options.host = "127.0.0.1";
+                options.port = server->port;
+
+                if (ThreadAPI_Create(&server_thread, echo_server_run, server) != THREADAPI_OK)
+                {
+                    (void)fprintf(stderr, "cannot start the echo server\n");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    int server_result;
+                    char stop = 0;
+
+                    result = run_load(&options);
+
+                    if ((write(server->stop_pipe[1], &stop, 1) != 1) ||
+                        (ThreadAPI_Join(server_thread, &server_result) != THREADAPI_OK) ||
+                        (server_result != 0))
+                    {
+                        (void)fprintf(stderr, "the echo server failed\n");
+                        result = __FAILURE__;
+                    }
+                }
+
+                echo_server_stop(server);
+            }
+
+            free(server);
+            platform_deinit();
+        }
+
+#ifdef GB_DEBUG_ALLOC
+        gballoc_deinit();
+#endif
+    }
+
+    return (result == 0) ? 0 : 1;
+}
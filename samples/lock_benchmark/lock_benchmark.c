@@ -0,0 +1,176 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* Compares Lock, RWLock and SpinLock guarding a short, read-mostly lookup (one write every
+   WRITE_EVERY operations) as the number of contending threads grows. */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#define _POSIX_C_SOURCE 200112L
+#include <time.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/threadapi.h"
+
+#define MAX_THREADS 16
+#define ITERATIONS_PER_THREAD 2000000
+#define WRITE_EVERY 100
+#define TABLE_SIZE 16
+
+typedef struct LOCK_KIND_TAG
+{
+    const char* name;
+    void* handle;
+    LOCK_RESULT(*lock_read)(void* handle);
+    LOCK_RESULT(*unlock_read)(void* handle);
+    LOCK_RESULT(*lock_write)(void* handle);
+    LOCK_RESULT(*unlock_write)(void* handle);
+} LOCK_KIND;
+
+/* stands in for the option values the lock guards */
+static volatile int table[TABLE_SIZE];
+
+/* tickcounter only has a resolution of 1 second on some platforms */
+static double elapsed_seconds(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    (void)QueryPerformanceFrequency(&frequency);
+    (void)QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1000000000.0);
+#endif
+}
+
+static int lookups(void* arg)
+{
+    const LOCK_KIND* kind = (const LOCK_KIND*)arg;
+    int sum = 0;
+    int i;
+
+    for (i = 0; i < ITERATIONS_PER_THREAD; i++)
+    {
+        if ((i % WRITE_EVERY) == 0)
+        {
+            (void)kind->lock_write(kind->handle);
+            table[i % TABLE_SIZE] = i;
+            (void)kind->unlock_write(kind->handle);
+        }
+        else
+        {
+            (void)kind->lock_read(kind->handle);
+            sum += table[i % TABLE_SIZE];
+            (void)kind->unlock_read(kind->handle);
+        }
+    }
+
+    return sum;
+}
+
+static int run_benchmark(const LOCK_KIND* kind, size_t thread_count)
+{
+    int result = 0;
+    THREAD_HANDLE threads[MAX_THREADS];
+    double start;
+    size_t created_threads;
+    size_t i;
+
+    start = elapsed_seconds();
+    for (created_threads = 0; created_threads < thread_count; created_threads++)
+    {
+        if (ThreadAPI_Create(&threads[created_threads], lookups, (void*)kind) != THREADAPI_OK)
+        {
+            (void)printf("Failed creating a thread\r\n");
+            result = 1;
+            break;
+        }
+    }
+
+    for (i = 0; i < created_threads; i++)
+    {
+        int thread_result;
+        (void)ThreadAPI_Join(threads[i], &thread_result);
+    }
+
+    if (result == 0)
+    {
+        double elapsed = elapsed_seconds() - start;
+        (void)printf("%-8s %2u threads: %8.1f ms, %8.2f million lookups per second\r\n",
+            kind->name, (unsigned int)thread_count, elapsed * 1000.0, ((double)thread_count * ITERATIONS_PER_THREAD) / (elapsed * 1000000.0));
+    }
+
+    return result;
+}
+
+static int run_benchmarks(const LOCK_KIND* kind, size_t max_threads)
+{
+    int result;
+
+    if (kind->handle == NULL)
+    {
+        (void)printf("Failed creating the %s\r\n", kind->name);
+        result = 1;
+    }
+    else
+    {
+        size_t thread_count;
+
+        result = 0;
+        for (thread_count = 1; (result == 0) && (thread_count <= max_threads); thread_count *= 2)
+        {
+            result = run_benchmark(kind, thread_count);
+        }
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+    size_t max_threads = (argc > 1) ? (size_t)atoi(argv[1]) : 8;
+    LOCK_KIND mutex = { "Lock", NULL, Lock, Unlock, Lock, Unlock };
+    LOCK_KIND rwlock = { "RWLock", NULL, RWLock_LockShared, RWLock_UnlockShared, RWLock_LockExclusive, RWLock_UnlockExclusive };
+    LOCK_KIND spinlock = { "SpinLock", NULL, SpinLock_Lock, SpinLock_Unlock, SpinLock_Lock, SpinLock_Unlock };
+
+    if (max_threads > MAX_THREADS)
+    {
+        max_threads = MAX_THREADS;
+    }
+
+    mutex.handle = Lock_Init();
+    rwlock.handle = RWLock_Init();
+    spinlock.handle = SpinLock_Init();
+
+    result = run_benchmarks(&mutex, max_threads);
+    if (result == 0)
+    {
+        result = run_benchmarks(&rwlock, max_threads);
+    }
+    if (result == 0)
+    {
+        result = run_benchmarks(&spinlock, max_threads);
+    }
+
+    if (spinlock.handle != NULL)
+    {
+        (void)SpinLock_Deinit(spinlock.handle);
+    }
+    if (rwlock.handle != NULL)
+    {
+        (void)RWLock_Deinit(rwlock.handle);
+    }
+    if (mutex.handle != NULL)
+    {
+        (void)Lock_Deinit(mutex.handle);
+    }
+
+    return result;
+}
@@ -0,0 +1,128 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* Measures how CONSTBUFFER_IncRef/CONSTBUFFER_DecRef throughput scales with the number of threads,
+   both when all threads share one buffer (one message fanned out to many subscribers) and when
+   each thread has its own buffer. */
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#define _POSIX_C_SOURCE 200112L
+#include <time.h>
+#endif
+#include <stdio.h>
+#include <stdlib.h>
+#include "azure_c_shared_utility/constbuffer.h"
+#include "azure_c_shared_utility/threadapi.h"
+
+#define MAX_THREADS 16
+#define ITERATIONS_PER_THREAD 4000000
+
+static const unsigned char payload[] = "{\"temperature\":21.5}";
+
+/* tickcounter only has a resolution of 1 second on some platforms */
+static double elapsed_seconds(void)
+{
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    (void)QueryPerformanceFrequency(&frequency);
+    (void)QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+    struct timespec now;
+    (void)clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + ((double)now.tv_nsec / 1000000000.0);
+#endif
+}
+
+static int inc_dec_ref(void* arg)
+{
+    CONSTBUFFER_HANDLE handle = (CONSTBUFFER_HANDLE)arg;
+    int i;
+
+    for (i = 0; i < ITERATIONS_PER_THREAD; i++)
+    {
+        CONSTBUFFER_IncRef(handle);
+        CONSTBUFFER_DecRef(handle);
+    }
+
+    return 0;
+}
+
+static int run_benchmark(const char* name, size_t thread_count, int shared)
+{
+    int result = 0;
+    CONSTBUFFER_HANDLE handles[MAX_THREADS];
+    THREAD_HANDLE threads[MAX_THREADS];
+    double start;
+    size_t created_handles;
+    size_t created_threads;
+    size_t i;
+
+    for (created_handles = 0; created_handles < (shared ? 1 : thread_count); created_handles++)
+    {
+        handles[created_handles] = CONSTBUFFER_Create(payload, sizeof(payload));
+        if (handles[created_handles] == NULL)
+        {
+            (void)printf("Failed creating a CONSTBUFFER\r\n");
+            result = 1;
+            break;
+        }
+    }
+
+    start = elapsed_seconds();
+    for (created_threads = 0; (result == 0) && (created_threads < thread_count); created_threads++)
+    {
+        if (ThreadAPI_Create(&threads[created_threads], inc_dec_ref, handles[shared ? 0 : created_threads]) != THREADAPI_OK)
+        {
+            (void)printf("Failed creating a thread\r\n");
+            result = 1;
+            break;
+        }
+    }
+
+    for (i = 0; i < created_threads; i++)
+    {
+        int thread_result;
+        (void)ThreadAPI_Join(threads[i], &thread_result);
+    }
+
+    if (result == 0)
+    {
+        double elapsed = elapsed_seconds() - start;
+        (void)printf("%-8s %2u threads: %8.1f ms, %8.2f million IncRef/DecRef pairs per second\r\n",
+            name, (unsigned int)thread_count, elapsed * 1000.0, ((double)thread_count * ITERATIONS_PER_THREAD) / (elapsed * 1000000.0));
+    }
+
+    for (i = 0; i < created_handles; i++)
+    {
+        CONSTBUFFER_DecRef(handles[i]);
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result = 0;
+    size_t max_threads = (argc > 1) ? (size_t)atoi(argv[1]) : 8;
+    size_t thread_count;
+
+    if (max_threads > MAX_THREADS)
+    {
+        max_threads = MAX_THREADS;
+    }
+
+    for (thread_count = 1; (result == 0) && (thread_count <= max_threads); thread_count *= 2)
+    {
+        result = run_benchmark("shared", thread_count, 1);
+    }
+    for (thread_count = 1; (result == 0) && (thread_count <= max_threads); thread_count *= 2)
+    {
+        result = run_benchmark("private", thread_count, 0);
+    }
+
+    return result;
+}
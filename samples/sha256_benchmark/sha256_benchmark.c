@@ -0,0 +1,110 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* Compares the portable SHA-256 code with the SHA instructions of the CPU, for bulk
+   hashing and for the HMAC-SHA256 of a SAS token string to sign. */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/hmacsha256.h"
+#include "azure_c_shared_utility/sha.h"
+
+#define BULK_SIZE (1024 * 1024)
+#define BULK_ITERATIONS 64
+#define HMAC_ITERATIONS 200000
+
+static unsigned char bulk_data[BULK_SIZE];
+
+static const unsigned char key[32] = "0123456789abcdef0123456789abcdef";
+static const char string_to_sign[] = "myhub.azure-devices.net%2Fdevices%2Fdevice-000123\n1735689600";
+
+static unsigned long elapsed_ms(clock_t start, clock_t end)
+{
+    return (unsigned long)(((double)(end - start) * 1000) / CLOCKS_PER_SEC);
+}
+
+static int run_benchmark(const char* name, uint8_t digest[SHA256HashSize])
+{
+    int result;
+    clock_t start;
+    clock_t bulk_end;
+    clock_t hmac_end;
+    BUFFER_HANDLE hash = BUFFER_new();
+    int i;
+
+    if (hash == NULL)
+    {
+        (void)printf("Failed creating the hash buffer\r\n");
+        result = 1;
+    }
+    else
+    {
+        SHA256Context context;
+
+        start = clock();
+        for (i = 0; i < BULK_ITERATIONS; i++)
+        {
+            (void)SHA256Reset(&context);
+            (void)SHA256Input(&context, bulk_data, BULK_SIZE);
+            (void)SHA256Result(&context, digest);
+        }
+        bulk_end = clock();
+
+        result = 0;
+        for (i = 0; (i < HMAC_ITERATIONS) && (result == 0); i++)
+        {
+            if (HMACSHA256_ComputeHash(key, sizeof(key), (const unsigned char*)string_to_sign, sizeof(string_to_sign) - 1, hash) != HMACSHA256_OK)
+            {
+                (void)printf("HMACSHA256_ComputeHash failed\r\n");
+                result = 1;
+            }
+        }
+        hmac_end = clock();
+
+        if (result == 0)
+        {
+            (void)printf("%-10s SHA-256 %4d MB in %6lu ms, HMAC-SHA256 %d SAS signatures in %6lu ms\r\n",
+                name, BULK_ITERATIONS, elapsed_ms(start, bulk_end), HMAC_ITERATIONS, elapsed_ms(bulk_end, hmac_end));
+        }
+
+        BUFFER_delete(hash);
+    }
+
+    return result;
+}
+
+int main(void)
+{
+    int result;
+    uint8_t portable_digest[SHA256HashSize];
+    uint8_t hardware_digest[SHA256HashSize];
+    size_t i;
+
+    for (i = 0; i < BULK_SIZE; i++)
+    {
+        bulk_data[i] = (unsigned char)(i * 31);
+    }
+
+    (void)SHA256UseHardwareAcceleration(0);
+    result = run_benchmark("portable", portable_digest);
+    if (result == 0)
+    {
+        if (SHA256UseHardwareAcceleration(1) != shaSuccess)
+        {
+            (void)printf("This CPU has no SHA instructions\r\n");
+        }
+        else
+        {
+            result = run_benchmark("hardware", hardware_digest);
+            if ((result == 0) && (memcmp(portable_digest, hardware_digest, SHA256HashSize) != 0))
+            {
+                (void)printf("The digests differ\r\n");
+                result = 1;
+            }
+        }
+    }
+
+    return result;
+}
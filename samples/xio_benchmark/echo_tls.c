@@ -0,0 +1,120 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "openssl/ssl.h"
+#include "openssl/err.h"
+#include "openssl/ec.h"
+#include "openssl/pem.h"
+#include "openssl/x509.h"
+#include "echo_tls.h"
+
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+#define X509_getm_notBefore X509_get_notBefore
+#define X509_getm_notAfter X509_get_notAfter
+#endif
+
+ECHO_TLS_HANDLE echo_tls_create(char** certificate_pem)
+{
+    SSL_CTX* result = NULL;
+    EVP_PKEY_CTX* key_context = EVP_PKEY_CTX_new_id(EVP_PKEY_EC, NULL);
+    EVP_PKEY* key = NULL;
+    X509* certificate = NULL;
+    BIO* pem = NULL;
+
+    *certificate_pem = NULL;
+
+    if ((key_context == NULL) ||
+        (EVP_PKEY_keygen_init(key_context) != 1) ||
+        (EVP_PKEY_CTX_set_ec_paramgen_curve_nid(key_context, NID_X9_62_prime256v1) != 1) ||
+        (EVP_PKEY_CTX_set_ec_param_enc(key_context, OPENSSL_EC_NAMED_CURVE) != 1) ||
+        (EVP_PKEY_keygen(key_context, &key) != 1) ||
+        ((certificate = X509_new()) == NULL) ||
+        (X509_set_version(certificate, 2) != 1) ||
+        (ASN1_INTEGER_set(X509_get_serialNumber(certificate), 1) != 1) ||
+        (X509_gmtime_adj(X509_getm_notBefore(certificate), -60) == NULL) ||
+        (X509_gmtime_adj(X509_getm_notAfter(certificate), 24 * 60 * 60) == NULL) ||
+        (X509_set_pubkey(certificate, key) != 1) ||
+        (X509_NAME_add_entry_by_txt(X509_get_subject_name(certificate), "CN", MBSTRING_ASC, (const unsigned char*)"localhost", -1, -1, 0) != 1) ||
+        (X509_set_issuer_name(certificate, X509_get_subject_name(certificate)) != 1) ||
+        (X509_sign(certificate, key, EVP_sha256()) == 0) ||
+        ((pem = BIO_new(BIO_s_mem())) == NULL) ||
+        (PEM_write_bio_X509(pem, certificate) != 1))
+    {
+        (void)fprintf(stderr, "cannot create the certificate of the echo server\n");
+        ERR_print_errors_fp(stderr);
+    }
+    else
+    {
+        char* pem_data;
+        long pem_length = BIO_get_mem_data(pem, &pem_data);
+
+        if (((*certificate_pem = (char*)malloc((size_t)pem_length + 1)) == NULL) ||
+            ((result = SSL_CTX_new(SSLv23_server_method())) == NULL) ||
+            (SSL_CTX_use_certificate(result, certificate) != 1) ||
+            (SSL_CTX_use_PrivateKey(result, key) != 1))
+        {
+            (void)fprintf(stderr, "cannot create the TLS context of the echo server\n");
+            ERR_print_errors_fp(stderr);
+            if (result != NULL)
+            {
+                SSL_CTX_free(result);
+                result = NULL;
+            }
+            free(*certificate_pem);
+            *certificate_pem = NULL;
+        }
+        else
+        {
+            (void)memcpy(*certificate_pem, pem_data, (size_t)pem_length);
+            (*certificate_pem)[pem_length] = '\0';
+        }
+    }
+
+    BIO_free(pem);
+    X509_free(certificate);
+    EVP_PKEY_free(key);
+    EVP_PKEY_CTX_free(key_context);
+
+    return (ECHO_TLS_HANDLE)result;
+}
+
+void echo_tls_destroy(ECHO_TLS_HANDLE tls)
+{
+    SSL_CTX_free((SSL_CTX*)tls);
+}
+
+ECHO_TLS_CONNECTION_HANDLE echo_tls_accept(ECHO_TLS_HANDLE tls, int socket)
+{
+    SSL* result = SSL_new((SSL_CTX*)tls);
+
+    if ((result == NULL) ||
+        (SSL_set_fd(result, socket) != 1) ||
+        (SSL_accept(result) != 1))
+    {
+        (void)fprintf(stderr, "echo server: TLS handshake failed\n");
+        ERR_print_errors_fp(stderr);
+        SSL_free(result);
+        result = NULL;
+    }
+
+    return (ECHO_TLS_CONNECTION_HANDLE)result;
+}
+
+int echo_tls_receive(ECHO_TLS_CONNECTION_HANDLE connection, unsigned char* buffer, size_t size)
+{
+    return SSL_read((SSL*)connection, buffer, (int)size);
+}
+
+int echo_tls_send(ECHO_TLS_CONNECTION_HANDLE connection, const unsigned char* buffer, size_t size)
+{
+    return SSL_write((SSL*)connection, buffer, (int)size);
+}
+
+void echo_tls_close(ECHO_TLS_CONNECTION_HANDLE connection)
+{
+    (void)SSL_shutdown((SSL*)connection);
+    SSL_free((SSL*)connection);
+}
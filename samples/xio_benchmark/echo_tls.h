@@ -0,0 +1,26 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* The TLS side of the echo server of xio_benchmark, kept apart because the OpenSSL headers and sha.h
+   of the library both declare SHA1, SHA256... */
+
+#ifndef ECHO_TLS_H
+#define ECHO_TLS_H
+
+#include <stddef.h>
+
+typedef struct ECHO_TLS_TAG* ECHO_TLS_HANDLE;
+typedef struct ECHO_TLS_CONNECTION_TAG* ECHO_TLS_CONNECTION_HANDLE;
+
+/* creates a self signed certificate for localhost, certificate_pem receives it (to be freed) for TrustedCerts */
+ECHO_TLS_HANDLE echo_tls_create(char** certificate_pem);
+void echo_tls_destroy(ECHO_TLS_HANDLE tls);
+
+/* does the TLS handshake on an accepted socket */
+ECHO_TLS_CONNECTION_HANDLE echo_tls_accept(ECHO_TLS_HANDLE tls, int socket);
+/* both return the number of bytes, 0 or less when the connection is closed or failed */
+int echo_tls_receive(ECHO_TLS_CONNECTION_HANDLE connection, unsigned char* buffer, size_t size);
+int echo_tls_send(ECHO_TLS_CONNECTION_HANDLE connection, const unsigned char* buffer, size_t size);
+void echo_tls_close(ECHO_TLS_CONNECTION_HANDLE connection);
+
+#endif /* ECHO_TLS_H */
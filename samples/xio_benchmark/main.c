@@ -0,0 +1,1007 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* Measures the throughput and the latency of a whole xio stack against an echo server running on the
+   loopback interface in a thread of this process.
+
+   xio_benchmark [-proxy] [-tls] [-ws] [-stats] [-size bytes] [-count messages] [-rate messages_per_second] [-window messages]
+
+   The stack always starts with socketio, -proxy puts http_proxy_io over it (the echo server answers the
+   CONNECT request), -tls the platform tlsio (the echo server uses a self signed certificate it creates) and
+   -ws wsio. The messages are sent with xio_send, either at the given rate or, when the rate is 0, keeping
+   window messages in flight, and the echoed bytes are checked. One CSV line is printed on stdout:
+
+   stack,message_size,message_count,rate,window,elapsed_us,msgs_per_second,mb_per_second,p50_us,p99_us,max_us,allocations_per_message
+
+   The latency of a message is the time from its xio_send to the reception of its last echoed byte.
+   allocations_per_message is only given when the library is built with memory_trace or use_gballoc_arena,
+   which make the gballoc counters available.
+
+   -stats adds the counters of each layer given by xio_get_stats, from the top of the stack down, as a
+   second CSV block (time_us is only measured when the library is built with use_xio_stats_timing):
+
+   layer,bytes_sent,bytes_received,send_count,queued_send_count,pending_send_count,dowork_count,idle_dowork_count,callback_count,time_us */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/base64.h"
+#include "azure_c_shared_utility/http_proxy_io.h"
+#include "azure_c_shared_utility/platform.h"
+#include "azure_c_shared_utility/sha.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/tlsio.h"
+#include "azure_c_shared_utility/xio.h"
+#ifdef XIO_BENCHMARK_WSIO
+#include "azure_c_shared_utility/wsio.h"
+#endif
+#ifdef USE_OPENSSL
+#include "echo_tls.h"
+#endif
+
+#define DEFAULT_MESSAGE_SIZE 256
+#define DEFAULT_MESSAGE_COUNT 10000
+#define DEFAULT_WINDOW 1
+#define TIMEOUT_US (10 * 1000 * 1000)
+#define ECHO_BUFFER_SIZE (64 * 1024)
+#define HTTP_HEADER_MAX_SIZE 4096
+#define MAX_LAYER_COUNT 8
+
+static const char WEBSOCKET_GUID[] = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+typedef struct BENCHMARK_OPTIONS_TAG
+{
+    bool use_proxy;
+    bool use_tls;
+    bool use_ws;
+    bool print_stats;
+    size_t message_size;
+    size_t message_count;
+    size_t rate;
+    size_t window;
+} BENCHMARK_OPTIONS;
+
+/* echo server */
+
+typedef struct ECHO_SERVER_TAG
+{
+    const BENCHMARK_OPTIONS* options;
+    int listen_socket;
+    int port;
+#ifdef USE_OPENSSL
+    ECHO_TLS_HANDLE tls;
+#endif
+} ECHO_SERVER;
+
+typedef struct ECHO_CONNECTION_TAG
+{
+    int socket;
+#ifdef USE_OPENSSL
+    ECHO_TLS_CONNECTION_HANDLE tls_connection;
+#endif
+} ECHO_CONNECTION;
+
+/* returns the number of bytes received, 0 or less when the connection is closed or failed */
+static int connection_receive(ECHO_CONNECTION* connection, unsigned char* buffer, size_t size)
+{
+    int result;
+#ifdef USE_OPENSSL
+    if (connection->tls_connection != NULL)
+    {
+        result = echo_tls_receive(connection->tls_connection, buffer, size);
+    }
+    else
+#endif
+    {
+        result = (int)recv(connection->socket, buffer, size, 0);
+    }
+    return result;
+}
+
+static int connection_send(ECHO_CONNECTION* connection, const unsigned char* buffer, size_t size)
+{
+    int result = 0;
+
+    while ((size > 0) && (result == 0))
+    {
+        int sent;
+#ifdef USE_OPENSSL
+        if (connection->tls_connection != NULL)
+        {
+            sent = echo_tls_send(connection->tls_connection, buffer, size);
+        }
+        else
+#endif
+        {
+            sent = (int)send(connection->socket, buffer, size, 0);
+        }
+
+        if (sent <= 0)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            buffer += sent;
+            size -= (size_t)sent;
+        }
+    }
+
+    return result;
+}
+
+/* reads up to the empty line ending an HTTP header, one byte at a time so that nothing after it is consumed */
+static int receive_http_header(ECHO_CONNECTION* connection, char* header, size_t header_size)
+{
+    int result = __FAILURE__;
+    size_t length = 0;
+
+    while (length < header_size - 1)
+    {
+        if (connection_receive(connection, (unsigned char*)header + length, 1) != 1)
+        {
+            break;
+        }
+        length++;
+        header[length] = '\0';
+        if ((length >= 4) && (strcmp(header + length - 4, "\r\n\r\n") == 0))
+        {
+            result = 0;
+            break;
+        }
+    }
+
+    return result;
+}
+
+static int accept_proxy_connect(ECHO_CONNECTION* connection)
+{
+    int result;
+    char header[HTTP_HEADER_MAX_SIZE];
+    static const char response[] = "HTTP/1.1 200 Connection established\r\n\r\n";
+
+    if (receive_http_header(connection, header, sizeof(header)) != 0)
+    {
+        (void)fprintf(stderr, "echo server: no CONNECT request\n");
+        result = __FAILURE__;
+    }
+    else if (strncmp(header, "CONNECT ", 8) != 0)
+    {
+        (void)fprintf(stderr, "echo server: not a CONNECT request\n");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = connection_send(connection, (const unsigned char*)response, sizeof(response) - 1);
+    }
+
+    return result;
+}
+
+static int accept_websocket_upgrade(ECHO_CONNECTION* connection)
+{
+    int result;
+    char header[HTTP_HEADER_MAX_SIZE];
+    const char* key;
+    const char* key_end;
+
+    if (receive_http_header(connection, header, sizeof(header)) != 0)
+    {
+        (void)fprintf(stderr, "echo server: no upgrade request\n");
+        result = __FAILURE__;
+    }
+    else if (((key = strstr(header, "Sec-WebSocket-Key: ")) == NULL) ||
+        ((key_end = strstr(key, "\r\n")) == NULL))
+    {
+        (void)fprintf(stderr, "echo server: no Sec-WebSocket-Key in the upgrade request\n");
+        result = __FAILURE__;
+    }
+    else
+    {
+        char accept_input[128];
+        size_t key_length;
+
+        key += 19;
+        key_length = (size_t)(key_end - key);
+        if (key_length + sizeof(WEBSOCKET_GUID) > sizeof(accept_input))
+        {
+            (void)fprintf(stderr, "echo server: Sec-WebSocket-Key too long\n");
+            result = __FAILURE__;
+        }
+        else
+        {
+            SHA1Context sha;
+            uint8_t digest[SHA1HashSize];
+            STRING_HANDLE accept = NULL;
+
+            (void)memcpy(accept_input, key, key_length);
+            (void)memcpy(accept_input + key_length, WEBSOCKET_GUID, sizeof(WEBSOCKET_GUID));
+
+            if ((SHA1Reset(&sha) != shaSuccess) ||
+                (SHA1Input(&sha, (const uint8_t*)accept_input, (unsigned int)strlen(accept_input)) != shaSuccess) ||
+                (SHA1Result(&sha, digest) != shaSuccess) ||
+                ((accept = Base64_Encode_Bytes(digest, sizeof(digest))) == NULL))
+            {
+                (void)fprintf(stderr, "echo server: cannot compute Sec-WebSocket-Accept\n");
+                result = __FAILURE__;
+            }
+            else
+            {
+                char response[256];
+                int length = snprintf(response, sizeof(response),
+                    "HTTP/1.1 101 Switching Protocols\r\n"
+                    "Upgrade: websocket\r\n"
+                    "Connection: Upgrade\r\n"
+                    "Sec-WebSocket-Accept: %s\r\n"
+                    "Sec-WebSocket-Protocol: benchmark\r\n"
+                    "\r\n", STRING_c_str(accept));
+
+                result = ((length > 0) && ((size_t)length < sizeof(response))) ?
+                    connection_send(connection, (const unsigned char*)response, (size_t)length) :
+                    __FAILURE__;
+            }
+
+            STRING_delete(accept);
+        }
+    }
+
+    return result;
+}
+
+static int echo_bytes(ECHO_CONNECTION* connection)
+{
+    int result = 0;
+    unsigned char* buffer = (unsigned char*)malloc(ECHO_BUFFER_SIZE);
+
+    if (buffer == NULL)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        int received;
+        while ((result == 0) && ((received = connection_receive(connection, buffer, ECHO_BUFFER_SIZE)) > 0))
+        {
+            result = connection_send(connection, buffer, (size_t)received);
+        }
+        free(buffer);
+    }
+
+    return result;
+}
+
+/* sends back the data frames unmasked, answers pings and the close frame */
+static int echo_websocket_frames(ECHO_CONNECTION* connection)
+{
+    int result = 0;
+    size_t capacity = ECHO_BUFFER_SIZE;
+    size_t count = 0;
+    unsigned char* buffer = (unsigned char*)malloc(capacity);
+    bool closed = false;
+
+    if (buffer == NULL)
+    {
+        result = __FAILURE__;
+    }
+
+    while ((result == 0) && !closed)
+    {
+        size_t needed = 2;
+
+        if (count >= 2)
+        {
+            size_t extended_length_size = ((buffer[1] & 0x7F) == 126) ? 2 : (((buffer[1] & 0x7F) == 127) ? 8 : 0);
+            size_t mask_size = ((buffer[1] & 0x80) != 0) ? 4 : 0;
+            size_t header_size = 2 + extended_length_size + mask_size;
+
+            needed = header_size;
+            if (count >= header_size)
+            {
+                uint64_t payload_length = buffer[1] & 0x7F;
+                size_t i;
+
+                if (extended_length_size > 0)
+                {
+                    payload_length = 0;
+                    for (i = 0; i < extended_length_size; i++)
+                    {
+                        payload_length = (payload_length << 8) | buffer[2 + i];
+                    }
+                }
+
+                if (payload_length > SIZE_MAX - header_size)
+                {
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    needed = header_size + (size_t)payload_length;
+                    if (count >= needed)
+                    {
+                        unsigned char* payload = buffer + header_size;
+                        unsigned char opcode = buffer[0] & 0x0F;
+                        /* the header of an unmasked frame is never longer, so it is written right before the payload */
+                        size_t response_header_size = 2 + extended_length_size;
+                        unsigned char* response = payload - response_header_size;
+
+                        for (i = 0; (mask_size != 0) && (i < (size_t)payload_length); i++)
+                        {
+                            payload[i] ^= buffer[2 + extended_length_size + (i % 4)];
+                        }
+
+                        (void)memmove(response + 1, buffer + 1, 1 + extended_length_size);
+                        response[1] &= 0x7F;
+                        if (opcode == 0x8)
+                        {
+                            response[0] = 0x88;
+                            closed = true;
+                        }
+                        else if (opcode == 0x9)
+                        {
+                            response[0] = 0x8A;
+                        }
+                        else
+                        {
+                            response[0] = buffer[0] & 0x8F;
+                        }
+
+                        if ((opcode != 0xA) &&
+                            (connection_send(connection, response, response_header_size + (size_t)payload_length) != 0))
+                        {
+                            result = __FAILURE__;
+                        }
+
+                        (void)memmove(buffer, buffer + needed, count - needed);
+                        count -= needed;
+                        continue;
+                    }
+                }
+            }
+        }
+
+        if (result == 0)
+        {
+            int received;
+
+            if (needed > capacity)
+            {
+                unsigned char* new_buffer = (unsigned char*)realloc(buffer, needed);
+                if (new_buffer == NULL)
+                {
+                    result = __FAILURE__;
+                    break;
+                }
+                buffer = new_buffer;
+                capacity = needed;
+            }
+
+            received = connection_receive(connection, buffer + count, capacity - count);
+            if (received <= 0)
+            {
+                /* the client went away without a close frame */
+                closed = true;
+            }
+            else
+            {
+                count += (size_t)received;
+            }
+        }
+    }
+
+    free(buffer);
+
+    return result;
+}
+
+static int echo_server_run(void* context)
+{
+    int result;
+    ECHO_SERVER* server = (ECHO_SERVER*)context;
+    ECHO_CONNECTION connection;
+
+    connection.socket = accept(server->listen_socket, NULL, NULL);
+#ifdef USE_OPENSSL
+    connection.tls_connection = NULL;
+#endif
+    if (connection.socket < 0)
+    {
+        (void)fprintf(stderr, "echo server: accept failed\n");
+        result = __FAILURE__;
+    }
+    else
+    {
+        int no_delay = 1;
+        (void)setsockopt(connection.socket, IPPROTO_TCP, TCP_NODELAY, &no_delay, sizeof(no_delay));
+
+        if (server->options->use_proxy && (accept_proxy_connect(&connection) != 0))
+        {
+            result = __FAILURE__;
+        }
+#ifdef USE_OPENSSL
+        else if (server->options->use_tls &&
+            ((connection.tls_connection = echo_tls_accept(server->tls, connection.socket)) == NULL))
+        {
+            result = __FAILURE__;
+        }
+#endif
+        else if (server->options->use_ws)
+        {
+            result = ((accept_websocket_upgrade(&connection) != 0) || (echo_websocket_frames(&connection) != 0)) ? __FAILURE__ : 0;
+        }
+        else
+        {
+            result = echo_bytes(&connection);
+        }
+
+#ifdef USE_OPENSSL
+        if (connection.tls_connection != NULL)
+        {
+            echo_tls_close(connection.tls_connection);
+        }
+#endif
+        (void)close(connection.socket);
+    }
+
+    return result;
+}
+
+static int echo_server_listen(ECHO_SERVER* server)
+{
+    int result;
+    struct sockaddr_in address;
+    socklen_t address_length = sizeof(address);
+
+    (void)memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+
+    if ((server->listen_socket = socket(AF_INET, SOCK_STREAM, 0)) < 0)
+    {
+        result = __FAILURE__;
+    }
+    else if ((bind(server->listen_socket, (struct sockaddr*)&address, sizeof(address)) != 0) ||
+        (listen(server->listen_socket, 1) != 0) ||
+        (getsockname(server->listen_socket, (struct sockaddr*)&address, &address_length) != 0))
+    {
+        (void)close(server->listen_socket);
+        result = __FAILURE__;
+    }
+    else
+    {
+        server->port = ntohs(address.sin_port);
+        result = 0;
+    }
+
+    return result;
+}
+
+/* client */
+
+typedef struct BENCHMARK_CLIENT_TAG
+{
+    const BENCHMARK_OPTIONS* options;
+    XIO_HANDLE io;
+    int open_result;
+    bool is_closed;
+    bool has_error;
+    unsigned char* payload;
+    tickcounter_us_t* send_times;
+    tickcounter_us_t* latencies;
+    size_t sent;
+    size_t completed;
+    uint64_t received_bytes;
+    tickcounter_us_t last_receive;
+} BENCHMARK_CLIENT;
+
+static tickcounter_us_t now_us(void)
+{
+    tickcounter_us_t result;
+    if (tickcounter_get_monotonic_us(&result) != 0)
+    {
+        result = 0;
+    }
+    return result;
+}
+
+static void on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    BENCHMARK_CLIENT* client = (BENCHMARK_CLIENT*)context;
+    client->open_result = (open_result == IO_OPEN_OK) ? 1 : -1;
+}
+
+static void on_io_close_complete(void* context)
+{
+    BENCHMARK_CLIENT* client = (BENCHMARK_CLIENT*)context;
+    client->is_closed = true;
+}
+
+static void on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    BENCHMARK_CLIENT* client = (BENCHMARK_CLIENT*)context;
+    if (send_result != IO_SEND_OK)
+    {
+        (void)fprintf(stderr, "send failed\n");
+        client->has_error = true;
+    }
+}
+
+static void on_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    BENCHMARK_CLIENT* client = (BENCHMARK_CLIENT*)context;
+    size_t message_size = client->options->message_size;
+    tickcounter_us_t now = now_us();
+    size_t checked = 0;
+
+    while ((checked < size) && !client->has_error)
+    {
+        size_t offset = (size_t)((client->received_bytes + checked) % message_size);
+        size_t chunk = message_size - offset;
+        if (chunk > size - checked)
+        {
+            chunk = size - checked;
+        }
+        if (memcmp(buffer + checked, client->payload + offset, chunk) != 0)
+        {
+            (void)fprintf(stderr, "the echoed bytes differ from the sent ones\n");
+            client->has_error = true;
+        }
+        checked += chunk;
+    }
+
+    client->received_bytes += size;
+    client->last_receive = now;
+    while ((client->completed < client->sent) &&
+        (client->received_bytes >= (uint64_t)(client->completed + 1) * message_size))
+    {
+        client->latencies[client->completed] = now - client->send_times[client->completed];
+        client->completed++;
+    }
+}
+
+static void on_io_error(void* context)
+{
+    BENCHMARK_CLIENT* client = (BENCHMARK_CLIENT*)context;
+    (void)fprintf(stderr, "the xio stack reported an error\n");
+    client->has_error = true;
+}
+
+static int compare_latencies(const void* left, const void* right)
+{
+    tickcounter_us_t left_latency = *(const tickcounter_us_t*)left;
+    tickcounter_us_t right_latency = *(const tickcounter_us_t*)right;
+    return (left_latency < right_latency) ? -1 : ((left_latency > right_latency) ? 1 : 0);
+}
+
+static int run_client(BENCHMARK_CLIENT* client)
+{
+    int result = 0;
+    const BENCHMARK_OPTIONS* options = client->options;
+    tickcounter_us_t start = now_us();
+    tickcounter_us_t last_progress = start;
+    size_t last_completed = 0;
+#ifdef GB_DEBUG_ALLOC
+    size_t allocations = gballoc_getAllocationCount();
+#endif
+
+    while ((client->completed < options->message_count) && !client->has_error)
+    {
+        tickcounter_us_t now = now_us();
+
+        while ((client->sent < options->message_count) &&
+            ((options->rate == 0) ?
+                (client->sent - client->completed < options->window) :
+                ((uint64_t)(now - start) * options->rate >= (uint64_t)client->sent * 1000000)))
+        {
+            client->send_times[client->sent] = now;
+            client->sent++;
+            if (xio_send(client->io, client->payload, options->message_size, on_send_complete, client) != 0)
+            {
+                (void)fprintf(stderr, "xio_send failed\n");
+                client->has_error = true;
+                break;
+            }
+        }
+
+        xio_dowork(client->io);
+
+        if (client->completed != last_completed)
+        {
+            last_completed = client->completed;
+            last_progress = now;
+        }
+        else if (now - last_progress > TIMEOUT_US)
+        {
+            (void)fprintf(stderr, "timed out after %lu messages\n", (unsigned long)client->completed);
+            client->has_error = true;
+        }
+    }
+
+#ifdef GB_DEBUG_ALLOC
+    allocations = gballoc_getAllocationCount() - allocations;
+#endif
+
+    if (client->has_error)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        tickcounter_us_t elapsed = client->last_receive - start;
+        double seconds = (elapsed == 0) ? 1e-6 : ((double)elapsed / 1e6);
+        size_t count = options->message_count;
+        char stack[64];
+
+        qsort(client->latencies, count, sizeof(tickcounter_us_t), compare_latencies);
+
+        (void)snprintf(stack, sizeof(stack), "%s%s%ssocketio",
+            options->use_ws ? "wsio/" : "", options->use_tls ? "tlsio/" : "", options->use_proxy ? "http_proxy_io/" : "");
+        (void)printf("stack,message_size,message_count,rate,window,elapsed_us,msgs_per_second,mb_per_second,p50_us,p99_us,max_us,allocations_per_message\n");
+        (void)printf("%s,%lu,%lu,%lu,%lu,%llu,%.1f,%.2f,%llu,%llu,%llu,",
+            stack, (unsigned long)options->message_size, (unsigned long)count, (unsigned long)options->rate, (unsigned long)options->window,
+            (unsigned long long)elapsed, (double)count / seconds, ((double)count * (double)options->message_size) / (seconds * 1e6),
+            (unsigned long long)client->latencies[count / 2], (unsigned long long)client->latencies[(count * 99) / 100],
+            (unsigned long long)client->latencies[count - 1]);
+#ifdef GB_DEBUG_ALLOC
+        (void)printf("%.2f", (double)allocations / (double)count);
+#endif
+        (void)printf("\n");
+    }
+
+    return result;
+}
+
+static void print_layer_stats(XIO_HANDLE io)
+{
+    XIO_STATS stats[MAX_LAYER_COUNT];
+    size_t layer_count;
+
+    if (xio_get_stats(io, stats, MAX_LAYER_COUNT, &layer_count) != 0)
+    {
+        (void)fprintf(stderr, "the xio stack does not keep counters\n");
+    }
+    else
+    {
+        size_t i;
+
+        (void)printf("layer,bytes_sent,bytes_received,send_count,queued_send_count,pending_send_count,dowork_count,idle_dowork_count,callback_count,time_us\n");
+        for (i = 0; i < layer_count; i++)
+        {
+            (void)printf("%s,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu,%llu\n",
+                stats[i].layer_name, (unsigned long long)stats[i].bytes_sent, (unsigned long long)stats[i].bytes_received,
+                (unsigned long long)stats[i].send_count, (unsigned long long)stats[i].queued_send_count, (unsigned long long)stats[i].pending_send_count,
+                (unsigned long long)stats[i].dowork_count, (unsigned long long)stats[i].idle_dowork_count, (unsigned long long)stats[i].callback_count,
+                (unsigned long long)stats[i].time_us);
+        }
+    }
+}
+
+static int run_benchmark(const BENCHMARK_OPTIONS* options, int port, const char* certificate_pem)
+{
+    int result;
+    BENCHMARK_CLIENT client;
+    SOCKETIO_CONFIG socketio_config;
+    HTTP_PROXY_IO_CONFIG proxy_config;
+    TLSIO_CONFIG tlsio_config;
+#ifdef XIO_BENCHMARK_WSIO
+    WSIO_CONFIG wsio_config;
+#endif
+    const IO_INTERFACE_DESCRIPTION* io_interface;
+    void* io_parameters;
+    size_t i;
+
+    (void)memset(&client, 0, sizeof(client));
+    client.options = options;
+
+    socketio_config.hostname = "127.0.0.1";
+    socketio_config.port = port;
+    socketio_config.accepted_socket = NULL;
+    io_interface = socketio_get_interface_description();
+    io_parameters = &socketio_config;
+
+    if (options->use_proxy)
+    {
+        proxy_config.hostname = "localhost";
+        proxy_config.port = port;
+        proxy_config.proxy_hostname = "127.0.0.1";
+        proxy_config.proxy_port = port;
+        proxy_config.username = NULL;
+        proxy_config.password = NULL;
+        io_interface = http_proxy_io_get_interface_description();
+        io_parameters = &proxy_config;
+    }
+
+    if (options->use_tls)
+    {
+        tlsio_config.hostname = "localhost";
+        tlsio_config.port = port;
+        tlsio_config.underlying_io_interface = io_interface;
+        tlsio_config.underlying_io_parameters = io_parameters;
+        io_interface = platform_get_default_tlsio();
+        io_parameters = &tlsio_config;
+    }
+
+#ifdef XIO_BENCHMARK_WSIO
+    if (options->use_ws)
+    {
+        wsio_config.underlying_io_interface = io_interface;
+        wsio_config.underlying_io_parameters = io_parameters;
+        wsio_config.hostname = "localhost";
+        wsio_config.port = port;
+        wsio_config.resource_name = "/echo";
+        wsio_config.protocol = "benchmark";
+        io_interface = wsio_get_interface_description();
+        io_parameters = &wsio_config;
+    }
+#endif
+
+    if (((client.payload = (unsigned char*)malloc(options->message_size)) == NULL) ||
+        ((client.send_times = (tickcounter_us_t*)malloc(options->message_count * sizeof(tickcounter_us_t))) == NULL) ||
+        ((client.latencies = (tickcounter_us_t*)malloc(options->message_count * sizeof(tickcounter_us_t))) == NULL))
+    {
+        (void)fprintf(stderr, "cannot allocate the messages\n");
+        result = __FAILURE__;
+    }
+    else if ((io_interface == NULL) || ((client.io = xio_create(io_interface, io_parameters)) == NULL))
+    {
+        (void)fprintf(stderr, "cannot create the xio stack\n");
+        result = __FAILURE__;
+    }
+    else
+    {
+        for (i = 0; i < options->message_size; i++)
+        {
+            client.payload[i] = (unsigned char)((i * 7) + 1);
+        }
+
+        if ((certificate_pem != NULL) && (xio_setoption(client.io, OPTION_TRUSTED_CERT, certificate_pem) != 0))
+        {
+            (void)fprintf(stderr, "cannot set the trusted certificate\n");
+            result = __FAILURE__;
+        }
+        else if (xio_open(client.io, on_io_open_complete, &client, on_io_bytes_received, &client, on_io_error, &client) != 0)
+        {
+            (void)fprintf(stderr, "xio_open failed\n");
+            result = __FAILURE__;
+        }
+        else
+        {
+            tickcounter_us_t open_start = now_us();
+
+            while ((client.open_result == 0) && !client.has_error && (now_us() - open_start < TIMEOUT_US))
+            {
+                xio_dowork(client.io);
+            }
+
+            if (client.open_result != 1)
+            {
+                (void)fprintf(stderr, "the xio stack did not open\n");
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = run_client(&client);
+
+                if ((result == 0) && options->print_stats)
+                {
+                    print_layer_stats(client.io);
+                }
+            }
+
+            if (xio_close(client.io, on_io_close_complete, &client) == 0)
+            {
+                tickcounter_us_t close_start = now_us();
+                while (!client.is_closed && (now_us() - close_start < TIMEOUT_US))
+                {
+                    xio_dowork(client.io);
+                }
+            }
+        }
+
+        xio_destroy(client.io);
+    }
+
+    free(client.latencies);
+    free(client.send_times);
+    free(client.payload);
+
+    return result;
+}
+
+static int parse_size(const char* text, size_t* value)
+{
+    char* end;
+    unsigned long parsed = strtoul(text, &end, 10);
+    int result;
+
+    if ((end == text) || (*end != '\0'))
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        *value = (size_t)parsed;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int parse_options(int argc, char** argv, BENCHMARK_OPTIONS* options)
+{
+    int result = 0;
+    int i;
+
+    options->use_proxy = false;
+    options->use_tls = false;
+    options->use_ws = false;
+    options->print_stats = false;
+    options->message_size = DEFAULT_MESSAGE_SIZE;
+    options->message_count = DEFAULT_MESSAGE_COUNT;
+    options->rate = 0;
+    options->window = DEFAULT_WINDOW;
+
+    for (i = 1; (i < argc) && (result == 0); i++)
+    {
+        if (strcmp(argv[i], "-proxy") == 0)
+        {
+            options->use_proxy = true;
+        }
+        else if (strcmp(argv[i], "-tls") == 0)
+        {
+            options->use_tls = true;
+        }
+        else if (strcmp(argv[i], "-ws") == 0)
+        {
+            options->use_ws = true;
+        }
+        else if (strcmp(argv[i], "-stats") == 0)
+        {
+            options->print_stats = true;
+        }
+        else if ((i + 1 < argc) && (strcmp(argv[i], "-size") == 0))
+        {
+            result = parse_size(argv[++i], &options->message_size);
+        }
+        else if ((i + 1 < argc) && (strcmp(argv[i], "-count") == 0))
+        {
+            result = parse_size(argv[++i], &options->message_count);
+        }
+        else if ((i + 1 < argc) && (strcmp(argv[i], "-rate") == 0))
+        {
+            result = parse_size(argv[++i], &options->rate);
+        }
+        else if ((i + 1 < argc) && (strcmp(argv[i], "-window") == 0))
+        {
+            result = parse_size(argv[++i], &options->window);
+        }
+        else
+        {
+            result = __FAILURE__;
+        }
+    }
+
+    if ((result == 0) && ((options->message_size == 0) || (options->message_count == 0) || (options->window == 0)))
+    {
+        result = __FAILURE__;
+    }
+#ifndef USE_OPENSSL
+    if ((result == 0) && options->use_tls)
+    {
+        (void)fprintf(stderr, "-tls needs the library to be built with use_openssl, the echo server uses OpenSSL\n");
+        result = __FAILURE__;
+    }
+#endif
+#ifndef XIO_BENCHMARK_WSIO
+    if ((result == 0) && options->use_ws)
+    {
+        (void)fprintf(stderr, "-ws needs the library to be built with use_wsio\n");
+        result = __FAILURE__;
+    }
+#endif
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    int result;
+    BENCHMARK_OPTIONS options;
+    ECHO_SERVER server;
+    char* certificate_pem = NULL;
+
+    if (parse_options(argc, argv, &options) != 0)
+    {
+        (void)fprintf(stderr, "usage: xio_benchmark [-proxy] [-tls] [-ws] [-stats] [-size bytes] [-count messages] [-rate messages_per_second] [-window messages]\n");
+        result = __FAILURE__;
+    }
+#ifdef GB_DEBUG_ALLOC
+    else if (gballoc_init() != 0)
+    {
+        (void)fprintf(stderr, "cannot initialize gballoc\n");
+        result = __FAILURE__;
+    }
+#endif
+    else
+    {
+        if (platform_init() != 0)
+        {
+            (void)fprintf(stderr, "cannot initialize the platform\n");
+            result = __FAILURE__;
+        }
+        else
+        {
+            server.options = &options;
+#ifdef USE_OPENSSL
+            server.tls = NULL;
+#endif
+            if (echo_server_listen(&server) != 0)
+            {
+                (void)fprintf(stderr, "cannot listen on the loopback interface\n");
+                result = __FAILURE__;
+            }
+            else
+            {
+                THREAD_HANDLE server_thread;
+
+#ifdef USE_OPENSSL
+                if (options.use_tls && ((server.tls = echo_tls_create(&certificate_pem)) == NULL))
+                {
+                    result = __FAILURE__;
+                }
+                else
+#endif
+                if (ThreadAPI_Create(&server_thread, echo_server_run, &server) != THREADAPI_OK)
+                {
+                    (void)fprintf(stderr, "cannot start the echo server\n");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    int server_result;
+
+                    result = run_benchmark(&options, server.port, certificate_pem);
+
+                    /* unblocks accept if the client never connected */
+                    (void)shutdown(server.listen_socket, SHUT_RDWR);
+                    if ((ThreadAPI_Join(server_thread, &server_result) != THREADAPI_OK) || (server_result != 0))
+                    {
+                        (void)fprintf(stderr, "the echo server failed\n");
+                        result = __FAILURE__;
+                    }
+                }
+
+#ifdef USE_OPENSSL
+                if (server.tls != NULL)
+                {
+                    echo_tls_destroy(server.tls);
+                }
+#endif
+                free(certificate_pem);
+                (void)close(server.listen_socket);
+            }
+
+            platform_deinit();
+        }
+
+#ifdef GB_DEBUG_ALLOC
+        gballoc_deinit();
+#endif
+    }
+
+    return (result == 0) ? 0 : 1;
+}
@@ -0,0 +1,365 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/asynclogger.h"
+#include "azure_c_shared_utility/consolelogger.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#define ASYNCLOGGER_DEFAULT_ENTRY_COUNT 1024
+#define ASYNCLOGGER_MESSAGE_SIZE 256
+
+/*
+* The ring is a bounded multi-producer/single-consumer queue with a sequence number per
+* entry. Entry i of the ring is free for position p while its sequence is p; a producer that
+* wins the compare-and-swap of head from p to p+1 fills it and publishes it by moving its
+* sequence to p+1, and the writer frees it again by moving the sequence to p+entry_count.
+*
+* asynclogger_log must not log: it may well be the installed LOGGER_LOG.
+*/
+#if defined(_MSC_VER)
+#define ASYNCLOGGER_ADD(value, addend) InterlockedExchangeAdd(&(value), (addend))
+#define ASYNCLOGGER_CAS(value, exchange, comparand) InterlockedCompareExchange(&(value), (exchange), (comparand))
+#else
+#define ASYNCLOGGER_ADD(value, addend) __sync_fetch_and_add(&(value), (addend))
+#define ASYNCLOGGER_CAS(value, exchange, comparand) __sync_val_compare_and_swap(&(value), (comparand), (exchange))
+#endif
+#define ASYNCLOGGER_READ(value) ASYNCLOGGER_ADD(value, 0)
+/* positions wrap around, so they are only ever compared through their difference */
+#define ASYNCLOGGER_DIFF(a, b) ((long)((unsigned long)(a) - (unsigned long)(b)))
+#define ASYNCLOGGER_NEXT(a) ((long)((unsigned long)(a) + 1))
+
+typedef struct ASYNCLOGGER_ENTRY_TAG
+{
+    volatile long sequence;
+    LOG_CATEGORY log_category;
+    const char* file;
+    const char* func;
+    int line;
+    unsigned int options;
+    char message[ASYNCLOGGER_MESSAGE_SIZE];
+} ASYNCLOGGER_ENTRY;
+
+typedef struct ASYNCLOGGER_TAG
+{
+    ASYNCLOGGER_ENTRY* entries;
+    unsigned long entry_mask;
+    LOGGER_LOG output;
+    volatile long head;
+    /* only touched by the writer */
+    long tail;
+    THREAD_HANDLE writer;
+    LOCK_HANDLE lock;
+    COND_HANDLE lines_available;
+    volatile long writer_waiting;
+    volatile long stopping;
+} ASYNCLOGGER;
+
+static ASYNCLOGGER* g_asynclogger = NULL;
+static volatile long g_dropped_count = 0;
+
+/* writes the next line, returns 0 if there is none */
+static int write_next_line(ASYNCLOGGER* asynclogger)
+{
+    int result;
+    ASYNCLOGGER_ENTRY* entry = &asynclogger->entries[(unsigned long)asynclogger->tail & asynclogger->entry_mask];
+
+    if (ASYNCLOGGER_DIFF(ASYNCLOGGER_READ(entry->sequence), ASYNCLOGGER_NEXT(asynclogger->tail)) != 0)
+    {
+        /*empty, or the next line is still being formatted*/
+        result = 0;
+    }
+    else
+    {
+        /*Codes_SRS_ASYNCLOGGER_01_016: [ The writer thread shall call the output logger with the category, file, function, line and options of each line, in the order in which the lines were added to the ring. ]*/
+        asynclogger->output(entry->log_category, entry->file, entry->func, entry->line, entry->options, "%s", entry->message);
+
+        (void)ASYNCLOGGER_ADD(entry->sequence, (long)asynclogger->entry_mask);
+        asynclogger->tail = ASYNCLOGGER_NEXT(asynclogger->tail);
+        result = 1;
+    }
+
+    return result;
+}
+
+static int writer_thread(void* arg)
+{
+    ASYNCLOGGER* asynclogger = (ASYNCLOGGER*)arg;
+    int result = 0;
+
+    for (;;)
+    {
+        if (write_next_line(asynclogger))
+        {
+            continue;
+        }
+
+        /*Codes_SRS_ASYNCLOGGER_01_018: [ Once asynclogger_deinit was called and the ring is empty, the writer thread shall exit. ]*/
+        if (ASYNCLOGGER_READ(asynclogger->stopping) != 0)
+        {
+            break;
+        }
+
+        if (Lock(asynclogger->lock) != LOCK_OK)
+        {
+            (void)printf("asynclogger: failure in Lock, the writer thread stops\r\n");
+            result = __FAILURE__;
+            break;
+        }
+        else
+        {
+            (void)ASYNCLOGGER_ADD(asynclogger->writer_waiting, 1);
+
+            /*Codes_SRS_ASYNCLOGGER_01_017: [ When the ring is empty, the writer thread shall wait on a condition. ]*/
+            if ((ASYNCLOGGER_READ(asynclogger->stopping) == 0) &&
+                (ASYNCLOGGER_DIFF(ASYNCLOGGER_READ(asynclogger->head), asynclogger->tail) == 0) &&
+                (Condition_Wait(asynclogger->lines_available, asynclogger->lock, 0) != COND_OK))
+            {
+                (void)printf("asynclogger: failure in Condition_Wait, the writer thread stops\r\n");
+                result = __FAILURE__;
+            }
+
+            (void)ASYNCLOGGER_ADD(asynclogger->writer_waiting, -1);
+            (void)Unlock(asynclogger->lock);
+
+            if (result != 0)
+            {
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void wake_writer(ASYNCLOGGER* asynclogger)
+{
+    if (Lock(asynclogger->lock) == LOCK_OK)
+    {
+        (void)Condition_Post(asynclogger->lines_available);
+        (void)Unlock(asynclogger->lock);
+    }
+}
+
+int asynclogger_init(size_t entry_count, LOGGER_LOG output)
+{
+    int result;
+
+    if (g_asynclogger != NULL)
+    {
+        /*Codes_SRS_ASYNCLOGGER_01_001: [ If the logger is already initialized, asynclogger_init shall fail and return a non-zero value. ]*/
+        LogError("asynclogger is already initialized");
+        result = __FAILURE__;
+    }
+    else if (entry_count > (((size_t)~(size_t)0) >> 2) / sizeof(ASYNCLOGGER_ENTRY))
+    {
+        /*Codes_SRS_ASYNCLOGGER_01_006: [ If any failure occurs, asynclogger_init shall free what it allocated and return a non-zero value. ]*/
+        LogError("invalid argument size_t entry_count=%lu", (unsigned long)entry_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_ASYNCLOGGER_01_002: [ asynclogger_init shall allocate a ring of entry_count entries rounded up to a power of 2, or of 1024 entries if entry_count is 0. ]*/
+        size_t ring_size = 1;
+        size_t target = (entry_count == 0) ? ASYNCLOGGER_DEFAULT_ENTRY_COUNT : entry_count;
+        ASYNCLOGGER* asynclogger;
+
+        while (ring_size < target)
+        {
+            ring_size <<= 1;
+        }
+
+        if ((asynclogger = (ASYNCLOGGER*)malloc(sizeof(ASYNCLOGGER))) == NULL)
+        {
+            /*Codes_SRS_ASYNCLOGGER_01_006: [ If any failure occurs, asynclogger_init shall free what it allocated and return a non-zero value. ]*/
+            LogError("failure in malloc(sizeof(ASYNCLOGGER)=%lu)", (unsigned long)sizeof(ASYNCLOGGER));
+            result = __FAILURE__;
+        }
+        else
+        {
+            if ((asynclogger->entries = (ASYNCLOGGER_ENTRY*)malloc(ring_size * sizeof(ASYNCLOGGER_ENTRY))) == NULL)
+            {
+                /*Codes_SRS_ASYNCLOGGER_01_006: [ If any failure occurs, asynclogger_init shall free what it allocated and return a non-zero value. ]*/
+                LogError("failure allocating %lu entries", (unsigned long)ring_size);
+                result = __FAILURE__;
+            }
+            else
+            {
+                /*Codes_SRS_ASYNCLOGGER_01_003: [ asynclogger_init shall create a lock and a condition. ]*/
+                if ((asynclogger->lock = Lock_Init()) == NULL)
+                {
+                    /*Codes_SRS_ASYNCLOGGER_01_006: [ If any failure occurs, asynclogger_init shall free what it allocated and return a non-zero value. ]*/
+                    LogError("failure in Lock_Init");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    if ((asynclogger->lines_available = Condition_Init()) == NULL)
+                    {
+                        /*Codes_SRS_ASYNCLOGGER_01_006: [ If any failure occurs, asynclogger_init shall free what it allocated and return a non-zero value. ]*/
+                        LogError("failure in Condition_Init");
+                        result = __FAILURE__;
+                    }
+                    else
+                    {
+                        size_t i;
+                        for (i = 0; i < ring_size; i++)
+                        {
+                            asynclogger->entries[i].sequence = (long)i;
+                        }
+                        asynclogger->entry_mask = (unsigned long)(ring_size - 1);
+                        /*Codes_SRS_ASYNCLOGGER_01_004: [ If output is NULL, the writer thread shall write the lines with consolelogger_log. ]*/
+                        asynclogger->output = (output == NULL) ? consolelogger_log : output;
+                        asynclogger->head = 0;
+                        asynclogger->tail = 0;
+                        asynclogger->writer_waiting = 0;
+                        asynclogger->stopping = 0;
+
+                        /*Codes_SRS_ASYNCLOGGER_01_005: [ asynclogger_init shall start the writer thread with ThreadAPI_Create, reset the dropped count and return 0. ]*/
+                        if (ThreadAPI_Create(&asynclogger->writer, writer_thread, asynclogger) != THREADAPI_OK)
+                        {
+                            /*Codes_SRS_ASYNCLOGGER_01_006: [ If any failure occurs, asynclogger_init shall free what it allocated and return a non-zero value. ]*/
+                            LogError("failure in ThreadAPI_Create");
+                            result = __FAILURE__;
+                        }
+                        else
+                        {
+                            g_dropped_count = 0;
+                            g_asynclogger = asynclogger;
+                            result = 0;
+                            goto all_ok;
+                        }
+
+                        Condition_Deinit(asynclogger->lines_available);
+                    }
+                    (void)Lock_Deinit(asynclogger->lock);
+                }
+                free(asynclogger->entries);
+            }
+            free(asynclogger);
+        }
+    }
+
+all_ok:
+    return result;
+}
+
+void asynclogger_deinit(void)
+{
+    ASYNCLOGGER* asynclogger = g_asynclogger;
+
+    if (asynclogger == NULL)
+    {
+        /*Codes_SRS_ASYNCLOGGER_01_007: [ If the logger is not initialized, asynclogger_deinit shall return. ]*/
+        LogError("asynclogger is not initialized");
+    }
+    else
+    {
+        int thread_result;
+
+        /*Codes_SRS_ASYNCLOGGER_01_008: [ asynclogger_deinit shall tell the writer thread to stop once the ring is empty, wake it and wait for it with ThreadAPI_Join. ]*/
+        (void)ASYNCLOGGER_ADD(asynclogger->stopping, 1);
+        wake_writer(asynclogger);
+        if (ThreadAPI_Join(asynclogger->writer, &thread_result) != THREADAPI_OK)
+        {
+            LogError("failure in ThreadAPI_Join");
+        }
+
+        /*Codes_SRS_ASYNCLOGGER_01_009: [ asynclogger_deinit shall free the condition, the lock and the ring. ]*/
+        g_asynclogger = NULL;
+        Condition_Deinit(asynclogger->lines_available);
+        (void)Lock_Deinit(asynclogger->lock);
+        free(asynclogger->entries);
+        free(asynclogger);
+    }
+}
+
+size_t asynclogger_get_dropped_count(void)
+{
+    /*Codes_SRS_ASYNCLOGGER_01_010: [ asynclogger_get_dropped_count shall return the number of lines dropped since asynclogger_init. ]*/
+    return (size_t)(unsigned long)ASYNCLOGGER_READ(g_dropped_count);
+}
+
+void asynclogger_log(LOG_CATEGORY log_category, const char* file, const char* func, int line, unsigned int options, const char* format, ...)
+{
+    ASYNCLOGGER* asynclogger = g_asynclogger;
+
+    if ((asynclogger == NULL) || (format == NULL))
+    {
+        /*Codes_SRS_ASYNCLOGGER_01_011: [ If the logger is not initialized or format is NULL, asynclogger_log shall drop the line and count it. ]*/
+        (void)ASYNCLOGGER_ADD(g_dropped_count, 1);
+    }
+    else
+    {
+        ASYNCLOGGER_ENTRY* entry = NULL;
+        long position = ASYNCLOGGER_READ(asynclogger->head);
+
+        /*Codes_SRS_ASYNCLOGGER_01_012: [ asynclogger_log shall claim the next entry of the ring with a compare-and-swap, without taking a lock. ]*/
+        for (;;)
+        {
+            ASYNCLOGGER_ENTRY* candidate = &asynclogger->entries[(unsigned long)position & asynclogger->entry_mask];
+            long diff = ASYNCLOGGER_DIFF(ASYNCLOGGER_READ(candidate->sequence), position);
+
+            if (diff == 0)
+            {
+                long observed = ASYNCLOGGER_CAS(asynclogger->head, ASYNCLOGGER_NEXT(position), position);
+                if (observed == position)
+                {
+                    entry = candidate;
+                    break;
+                }
+                position = observed;
+            }
+            else if (diff < 0)
+            {
+                /*the writer has not freed this entry yet: the ring is full*/
+                break;
+            }
+            else
+            {
+                /*another producer took the entry, try the next one*/
+                position = ASYNCLOGGER_READ(asynclogger->head);
+            }
+        }
+
+        if (entry == NULL)
+        {
+            /*Codes_SRS_ASYNCLOGGER_01_013: [ If the ring is full, asynclogger_log shall drop the line and count it. ]*/
+            (void)ASYNCLOGGER_ADD(g_dropped_count, 1);
+        }
+        else
+        {
+            va_list args;
+
+            /*Codes_SRS_ASYNCLOGGER_01_014: [ asynclogger_log shall format the line into the entry, truncating it to the size of the entry, and store the category, file, function, line and options. ]*/
+            entry->log_category = log_category;
+            entry->file = file;
+            entry->func = func;
+            entry->line = line;
+            entry->options = options;
+            va_start(args, format);
+            if (vsnprintf(entry->message, sizeof(entry->message), format, args) < 0)
+            {
+                entry->message[0] = '\0';
+            }
+            va_end(args);
+
+            /*publish, this is also the barrier ordering the check of writer_waiting below*/
+            (void)ASYNCLOGGER_ADD(entry->sequence, 1);
+
+            /*Codes_SRS_ASYNCLOGGER_01_015: [ If the writer thread is waiting, asynclogger_log shall post the condition while holding the lock. ]*/
+            if (ASYNCLOGGER_READ(asynclogger->writer_waiting) != 0)
+            {
+                wake_writer(asynclogger);
+            }
+        }
+    }
+}
@@ -4,19 +4,46 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdint.h>
-#include <ctype.h>
+#include <string.h>
 #include "azure_c_shared_utility/buffer_.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/optimize_size.h"
 
 #include "azure_c_shared_utility/base32.h"
 
-static const unsigned char BASE32_EQUAL_SIGN = 32;
+#define BASE32_PAD_VALUE        32
+#define BASE32_INVALID_VALUE    0xFF
+
+static const char BASE32_VALUES[32] =
+{
+    'a', 'b', 'c', 'd', 'e', 'f', 'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p',
+    'q', 'r', 's', 't', 'u', 'v', 'w', 'x', 'y', 'z', '2', '3', '4', '5', '6', '7'
+};
+
+/*the 5 bit value of each base32 character in either case, BASE32_PAD_VALUE for '=' and BASE32_INVALID_VALUE for all the other characters*/
+static const unsigned char BASE32_CHAR_VALUES[256] =
+{
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 26, 27, 28, 29, 30, 31, 255, 255, 255, 255, 255, 32, 255, 255,
+    255,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 255, 255, 255, 255, 255,
+    255,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,
+    255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255
+};
 
-static const char BASE32_VALUES[] = "abcdefghijklmnopqrstuvwxyz234567=";
 #define TARGET_BLOCK_SIZE       5
-#define INVALID_CHAR_POS        260
 
 #define BASE32_INPUT_SIZE       8
 
@@ -32,39 +59,122 @@ static size_t base32_decoding_length(size_t src_len)
     return ((src_len*TARGET_BLOCK_SIZE) / 8);
 }
 
-static unsigned char convert_value_to_base32_char(unsigned char value)
+/*the number of bytes of the last block of an encoding of src_len characters, given by its padding*/
+static size_t base32_decoded_size(const char* source, size_t src_len)
 {
-    unsigned char result;
-
-    if (value >= 50 && value <= 55)
-    {
-        result = 0x1a+(value-50);
-    }
-    else if (value == 61)
-    {
-        result = 0x20;
-    }
-    else if ((value <= 49) || (value >= 56 && value <= 64))
+    size_t result = base32_decoding_length(src_len);
+    // Because we are packing 5 bytes into an 8 byte variable we need to check every other
+    // variable for padding
+    if ((src_len > 0) && (source[src_len - 1] == '='))
     {
-        result = 0xFF;
+        --result;
+        if (source[src_len - 3] == '=')
+        {
+            --result;
+            if (source[src_len - 4] == '=')
+            {
+                --result;
+                if (source[src_len - 6] == '=')
+                {
+                    --result;
+                }
+            }
+        }
     }
-    else if (value >= 65 && value <= 90)
+    return result;
+}
+
+/*encodes one block of 5 bytes as 8 characters*/
+static void base32_encode_block(char* destination, const unsigned char* source)
+{
+    uint32_t high = ((uint32_t)source[0] << 12) | ((uint32_t)source[1] << 4) | ((uint32_t)source[2] >> 4);
+    uint32_t low = (((uint32_t)source[2] & 0x0f) << 16) | ((uint32_t)source[3] << 8) | (uint32_t)source[4];
+
+    /* Codes_SRS_BASE32_07_011: [ base32_encode_impl shall then map the 5 bit chunks into one of the BASE32 values (a-z,2,3,4,5,6,7) values. ] */
+    destination[0] = BASE32_VALUES[high >> 15];
+    destination[1] = BASE32_VALUES[(high >> 10) & 0x1f];
+    destination[2] = BASE32_VALUES[(high >> 5) & 0x1f];
+    destination[3] = BASE32_VALUES[high & 0x1f];
+    destination[4] = BASE32_VALUES[low >> 15];
+    destination[5] = BASE32_VALUES[(low >> 10) & 0x1f];
+    destination[6] = BASE32_VALUES[(low >> 5) & 0x1f];
+    destination[7] = BASE32_VALUES[low & 0x1f];
+}
+
+/*encodes src_size bytes of source in destination, which has room for base32_encoding_length(src_size) + 1 characters*/
+static void base32_encode_blocks(char* destination, const unsigned char* source, size_t src_size)
+{
+    /* Codes_SRS_BASE32_07_010: [ base32_encode_impl shall look through source and separate each block into 5 bit chunks ] */
+    while (src_size >= TARGET_BLOCK_SIZE)
     {
-        result = 0x00 + (value - 65);
+        base32_encode_block(destination, source);
+        destination += BASE32_INPUT_SIZE;
+        source += TARGET_BLOCK_SIZE;
+        src_size -= TARGET_BLOCK_SIZE;
     }
-    else if (value >= 91 && value <= 96)
+
+    if (src_size > 0)
     {
-        result = 0xFF;
+        unsigned char block[TARGET_BLOCK_SIZE] = { 0 };
+        size_t index;
+
+        (void)memcpy(block, source, src_size);
+        base32_encode_block(destination, block);
+
+        /* Codes_SRS_BASE32_07_012: [ If the src_size is not divisible by 8, base32_encode_impl shall pad the remaining places with =. ] */
+        for (index = ((src_size * 8) + 4) / 5; index < BASE32_INPUT_SIZE; index++)
+        {
+            destination[index] = '=';
+        }
+        destination += BASE32_INPUT_SIZE;
     }
-    else if (value >= 97 && value <= 123)
+    *destination = '\0';
+}
+
+/*decodes one block of 8 characters as 5 bytes; the padding decodes as 0 bits and any other character as 1 bits*/
+static void base32_decode_block(unsigned char* destination, const unsigned char* source)
+{
+    /* Codes_SRS_BASE32_07_024: [ base32_decode_impl shall loop through and collect 8 characters from the source variable. ] */
+    uint32_t high =
+        (((uint32_t)BASE32_CHAR_VALUES[source[0]] & 0x1f) << 15) |
+        (((uint32_t)BASE32_CHAR_VALUES[source[1]] & 0x1f) << 10) |
+        (((uint32_t)BASE32_CHAR_VALUES[source[2]] & 0x1f) << 5) |
+        ((uint32_t)BASE32_CHAR_VALUES[source[3]] & 0x1f);
+    uint32_t low =
+        (((uint32_t)BASE32_CHAR_VALUES[source[4]] & 0x1f) << 15) |
+        (((uint32_t)BASE32_CHAR_VALUES[source[5]] & 0x1f) << 10) |
+        (((uint32_t)BASE32_CHAR_VALUES[source[6]] & 0x1f) << 5) |
+        ((uint32_t)BASE32_CHAR_VALUES[source[7]] & 0x1f);
+
+    // Codes_SRS_BASE32_07_025: [ base32_decode_impl shall group 5 bytes at a time into the temp buffer. ]
+    destination[0] = (unsigned char)(high >> 12);
+    destination[1] = (unsigned char)(high >> 4);
+    destination[2] = (unsigned char)((high << 4) | (low >> 16));
+    destination[3] = (unsigned char)(low >> 8);
+    destination[4] = (unsigned char)low;
+}
+
+/*decodes the src_len characters of source (a multiple of 8) in destination, which has room for base32_decoded_size bytes;
+the characters are not validated*/
+static void base32_decode_blocks(unsigned char* destination, const char* source, size_t src_len)
+{
+    size_t dest_size = base32_decoded_size(source, src_len);
+    const unsigned char* iterator = (const unsigned char*)source;
+
+    while (dest_size >= TARGET_BLOCK_SIZE)
     {
-        result = 0x00 + (value - 97);
+        base32_decode_block(destination, iterator);
+        destination += TARGET_BLOCK_SIZE;
+        iterator += BASE32_INPUT_SIZE;
+        dest_size -= TARGET_BLOCK_SIZE;
     }
-    else // value > 123
+
+    if (dest_size > 0)
     {
-        result = 0xFF;
+        unsigned char block[TARGET_BLOCK_SIZE];
+        base32_decode_block(block, iterator);
+        (void)memcpy(destination, block, dest_size);
     }
-    return result;
 }
 
 static char* base32_encode_impl(const unsigned char* source, size_t src_size)
@@ -80,78 +190,7 @@ static char* base32_encode_impl(const unsigned char* source, size_t src_size)
     }
     else
     {
-        const unsigned char* iterator = source;
-        size_t block_len = 0;
-        size_t result_len = 0;
-        unsigned char pos1 = 0;
-        unsigned char pos2 = 0;
-        unsigned char pos3 = 0;
-        unsigned char pos4 = 0;
-        unsigned char pos5 = 0;
-        unsigned char pos6 = 0;
-        unsigned char pos7 = 0;
-        unsigned char pos8 = 0;
-
-        memset(result, 0, output_len + 1);
-
-        // Go through the source buffer sectioning off blocks of 5
-        /* Codes_SRS_BASE32_07_010: [ base32_encode_impl shall look through source and separate each block into 5 bit chunks ] */
-        while (src_size >= 1 && result != NULL)
-        {
-            pos1 = pos2 = pos3 = pos4 = pos5 = pos6 = pos7 = pos8 = 0;
-            block_len = src_size > TARGET_BLOCK_SIZE ? TARGET_BLOCK_SIZE : src_size;
-            // Fall through switch block to process the 5 (or smaller) block
-            switch (block_len)
-            {
-            case 5:
-                pos8 = (iterator[4] & 0x1f);
-                pos7 = ((iterator[4] & 0xe0) >> 5);
-                // fall through
-            case 4:
-                pos7 |= ((iterator[3] & 0x03) << 3);
-                pos6 = ((iterator[3] & 0x7c) >> 2);
-                pos5 = ((iterator[3] & 0x80) >> 7);
-                // fall through
-            case 3:
-                pos5 |= ((iterator[2] & 0x0f) << 1);
-                pos4 = ((iterator[2] & 0xf0) >> 4);
-                // fall through
-            case 2:
-                pos4 |= ((iterator[1] & 0x01) << 4);
-                pos3 = ((iterator[1] & 0x3e) >> 1);
-                pos2 = ((iterator[1] & 0xc0) >> 6);
-                // fall through
-            case 1:
-                pos2 |= ((iterator[0] & 0x07) << 2);
-                pos1 = ((iterator[0] & 0xf8) >> 3);
-                break;
-            }
-            // Move the iterator the block size
-            iterator += block_len;
-            // and decrement the src_size;
-            src_size -= block_len;
-
-            /* Codes_SRS_BASE32_07_012: [ If the src_size is not divisible by 8, base32_encode_impl shall pad the remaining places with =. ] */
-            switch (block_len)
-            {
-                case 1: pos3 = pos4 = 32; // fall through
-                case 2: pos5 = 32; // fall through
-                case 3: pos6 = pos7 = 32; // fall through
-                case 4: pos8 = 32; // fall through
-                case 5:
-                    break;
-            }
-
-            /* Codes_SRS_BASE32_07_011: [ base32_encode_impl shall then map the 5 bit chunks into one of the BASE32 values (a-z,2,3,4,5,6,7) values. ] */
-            result[result_len++] = BASE32_VALUES[pos1];
-            result[result_len++] = BASE32_VALUES[pos2];
-            result[result_len++] = BASE32_VALUES[pos3];
-            result[result_len++] = BASE32_VALUES[pos4];
-            result[result_len++] = BASE32_VALUES[pos5];
-            result[result_len++] = BASE32_VALUES[pos6];
-            result[result_len++] = BASE32_VALUES[pos7];
-            result[result_len++] = BASE32_VALUES[pos8];
-        }
+        base32_encode_blocks(result, source, src_size);
     }
     return result;
 }
@@ -169,16 +208,25 @@ static BUFFER_HANDLE base32_decode_impl(const char* source)
     }
     else
     {
-        size_t dest_size = 0;
         unsigned char* temp_buffer;
-        unsigned char* dest_buff;
-        bool continue_processing = true;
-        unsigned char input[8];
-        const char* iterator = source;
+        size_t index;
+
+        for (index = 0; index < src_length; index++)
+        {
+            if ((unsigned char)source[index] >= ASCII_VALUE_MAX)
+            {
+                break;
+            }
+        }
 
+        if (index < src_length)
+        {
+            /* Codes_SRS_BASE32_07_023: [ If an error is encountered, base32_decode_impl shall return NULL. ] */
+            LogError("Failure source encoding");
+            result = NULL;
+        }
         /* Codes_SRS_BASE32_07_022: [ base32_decode_impl shall allocate a temp buffer to store the in process value. ] */
-        size_t allocation_len = base32_decoding_length(src_length);
-        if ((temp_buffer = (unsigned char*)malloc(allocation_len)) == NULL)
+        else if ((temp_buffer = (unsigned char*)malloc(base32_decoding_length(src_length))) == NULL)
         {
             /* Codes_SRS_BASE32_07_023: [ If an error is encountered, base32_decode_impl shall return NULL. ] */
             LogError("Failure allocating buffer");
@@ -186,80 +234,13 @@ static BUFFER_HANDLE base32_decode_impl(const char* source)
         }
         else
         {
-            dest_buff = temp_buffer;
-            while (*iterator != '\0')
-            {
-                size_t index = 0;
-                /* Codes_SRS_BASE32_07_024: [ base32_decode_impl shall loop through and collect 8 characters from the source variable. ] */
-                for (index = 0; index < BASE32_INPUT_SIZE; index++)
-                {
-                    input[index] = *iterator;
-                    iterator++;
-                    if (input[index] >= ASCII_VALUE_MAX)
-                    {
-                        LogError("Failure source encoding");
-                        continue_processing = false;
-                        break;
-                    }
-
-                    input[index] = convert_value_to_base32_char(input[index]);
-                }
+            base32_decode_blocks(temp_buffer, source, src_length);
 
-                if (!continue_processing)
-                {
-                    result = NULL;
-                    break;
-                }
-                else if ((dest_size + TARGET_BLOCK_SIZE) > allocation_len)
-                {
-                    LogError("Failure target length exceeded");
-                    result = NULL;
-                    continue_processing = false;
-                    break;
-                }
-                else
-                {
-                    // Codes_SRS_BASE32_07_025: [ base32_decode_impl shall group 5 bytes at a time into the temp buffer. ]
-                    *dest_buff++ = ((input[0] & 0x1f) << 3) | ((input[1] & 0x1c) >> 2);
-                    *dest_buff++ = ((input[1] & 0x03) << 6) | ((input[2] & 0x1f) << 1) | ((input[3] & 0x10) >> 4);
-                    *dest_buff++ = ((input[3] & 0x0f) << 4) | ((input[4] & 0x1e) >> 1);
-                    *dest_buff++ = ((input[4] & 0x01) << 7) | ((input[5] & 0x1f) << 2) | ((input[6] & 0x18) >> 3);
-                    *dest_buff++ = ((input[6] & 0x07) << 5) | (input[7] & 0x1f);
-                    dest_size += TARGET_BLOCK_SIZE;
-                    // If there is padding remove it
-                    // Because we are packing 5 bytes into an 8 byte variable we need to check every other
-                    // variable for padding
-                    if (input[7] == BASE32_EQUAL_SIGN)
-                    {
-                        --dest_size;
-                        if (input[5] == BASE32_EQUAL_SIGN)
-                        {
-                            --dest_size;
-                            if (input[4] == BASE32_EQUAL_SIGN)
-                            {
-                                --dest_size;
-                                if (input[2] == BASE32_EQUAL_SIGN)
-                                {
-                                    --dest_size;
-                                }
-                            }
-                        }
-                    }
-                }
-            }
-
-            if (!continue_processing)
-            {
-                result = NULL;
-            }
-            else
+            /* Codes_SRS_BASE32_07_026: [ Once base32_decode_impl is complete it shall create a BUFFER with the temp buffer. ] */
+            result = BUFFER_create(temp_buffer, base32_decoded_size(source, src_length));
+            if (result == NULL)
             {
-                /* Codes_SRS_BASE32_07_026: [ Once base32_decode_impl is complete it shall create a BUFFER with the temp buffer. ] */
-                result = BUFFER_create(temp_buffer, dest_size);
-                if (result == NULL)
-                {
-                    LogError("Failure: BUFFER_create failed to create decoded buffer");
-                }
+                LogError("Failure: BUFFER_create failed to create decoded buffer");
             }
             free(temp_buffer);
         }
@@ -396,3 +377,136 @@ STRING_HANDLE Base32_Encode(BUFFER_HANDLE source)
     /* Codes_SRS_BASE32_07_002: [ If successful Base32_Encode shall return the base32 value of source. ] */
     return result;
 }
+
+size_t Base32_Encoded_Length(size_t size)
+{
+    size_t result;
+    if (size > (((size_t)-1) / 8) * TARGET_BLOCK_SIZE)
+    {
+        /* Codes_SRS_BASE32_01_002: [ If the encoding of size bytes cannot be represented in a size_t, Base32_Encoded_Length shall return 0. ] */
+        LogError("Invalid argument: size=%lu is too large", (unsigned long)size);
+        result = 0;
+    }
+    else
+    {
+        /* Codes_SRS_BASE32_01_001: [ Base32_Encoded_Length shall return the number of characters in the base32 encoding of size bytes, not counting the terminating '\0'. ] */
+        result = base32_encoding_length(size);
+    }
+    return result;
+}
+
+int Base32_Encode_To(const unsigned char* source, size_t size, char* destination, size_t destination_size)
+{
+    int result;
+    if (((source == NULL) && (size > 0)) ||
+        (destination == NULL))
+    {
+        /* Codes_SRS_BASE32_01_003: [ If source is NULL and size is not 0, or destination is NULL, Base32_Encode_To shall fail and return a non-zero value. ] */
+        LogError("Invalid arguments: const unsigned char* source=%p, size_t size=%lu, char* destination=%p", source, (unsigned long)size, destination);
+        result = __FAILURE__;
+    }
+    else if ((size > (((size_t)-1) / 8) * TARGET_BLOCK_SIZE) ||
+        (destination_size <= base32_encoding_length(size)))
+    {
+        /* Codes_SRS_BASE32_01_004: [ If destination_size is less than Base32_Encoded_Length(size) + 1, Base32_Encode_To shall fail and return a non-zero value. ] */
+        LogError("destination_size=%lu is too small for the encoding of %lu bytes", (unsigned long)destination_size, (unsigned long)size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_BASE32_01_005: [ Otherwise Base32_Encode_To shall write the base32 encoding of source, followed by a '\0', to destination and return 0. ] */
+        base32_encode_blocks(destination, source, size);
+        result = 0;
+    }
+    return result;
+}
+
+size_t Base32_Decoded_Length(const char* source)
+{
+    size_t result;
+    if (source == NULL)
+    {
+        /* Codes_SRS_BASE32_01_006: [ If source is NULL, Base32_Decoded_Length shall return 0. ] */
+        LogError("Invalid argument: const char* source=%p", source);
+        result = 0;
+    }
+    else
+    {
+        size_t src_length = strlen(source);
+        if ((src_length % BASE32_INPUT_SIZE) != 0)
+        {
+            /* Codes_SRS_BASE32_01_007: [ If the length of source is not a multiple of 8, Base32_Decoded_Length shall return 0. ] */
+            LogError("Failure invalid input length %lu", (unsigned long)src_length);
+            result = 0;
+        }
+        else
+        {
+            /* Codes_SRS_BASE32_01_008: [ Otherwise Base32_Decoded_Length shall return the number of bytes source decodes to. ] */
+            result = base32_decoded_size(source, src_length);
+        }
+    }
+    return result;
+}
+
+/*checks that source only holds base32 characters followed, in its last block, by the padding of 1 to 4 bytes*/
+static bool is_valid_base32(const char* source, size_t src_length)
+{
+    size_t index = 0;
+    size_t padding_length;
+
+    while ((index < src_length) && (BASE32_CHAR_VALUES[(unsigned char)source[index]] < BASE32_PAD_VALUE))
+    {
+        index++;
+    }
+    padding_length = src_length - index;
+    while ((index < src_length) && (source[index] == '='))
+    {
+        index++;
+    }
+
+    return (index == src_length) &&
+        ((src_length % BASE32_INPUT_SIZE) == 0) &&
+        ((padding_length == 0) || (padding_length == 1) || (padding_length == 3) || (padding_length == 4) || (padding_length == 6));
+}
+
+int Base32_Decode_To(const char* source, unsigned char* destination, size_t destination_size, size_t* decoded_size)
+{
+    int result;
+    if ((source == NULL) ||
+        (decoded_size == NULL) ||
+        ((destination == NULL) && (destination_size > 0)))
+    {
+        /* Codes_SRS_BASE32_01_009: [ If source or decoded_size is NULL, or destination is NULL and destination_size is not 0, Base32_Decode_To shall fail and return a non-zero value. ] */
+        LogError("Invalid arguments: const char* source=%p, unsigned char* destination=%p, size_t destination_size=%lu, size_t* decoded_size=%p",
+            source, destination, (unsigned long)destination_size, decoded_size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t src_length = strlen(source);
+        if (!is_valid_base32(source, src_length))
+        {
+            /* Codes_SRS_BASE32_01_010: [ If source is not a valid base32 encoding (its length is not a multiple of 8 or it contains characters other than the base32 alphabet in either case and the padding of its last block), Base32_Decode_To shall fail and return a non-zero value. ] */
+            LogError("Invalid Base32 string");
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t decoded_length = base32_decoded_size(source, src_length);
+            if (destination_size < decoded_length)
+            {
+                /* Codes_SRS_BASE32_01_011: [ If destination_size is less than the number of bytes source decodes to, Base32_Decode_To shall fail and return a non-zero value. ] */
+                LogError("destination_size=%lu is too small for %lu decoded bytes", (unsigned long)destination_size, (unsigned long)decoded_length);
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_BASE32_01_012: [ Otherwise Base32_Decode_To shall write the decoded bytes to destination, set decoded_size to their number and return 0. ] */
+                base32_decode_blocks(destination, source, src_length);
+                *decoded_size = decoded_length;
+                result = 0;
+            }
+        }
+    }
+    return result;
+}
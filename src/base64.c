@@ -5,106 +5,70 @@
 #include "azure_c_shared_utility/gballoc.h"
 #include <stddef.h>
 #include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
 #include "azure_c_shared_utility/base64.h"
 #include "azure_c_shared_utility/xlogging.h"
 
 
-#define splitInt(intVal, bytePos)   (char)((intVal >> (bytePos << 3)) & 0xFF)
-#define joinChars(a, b, c, d) (uint32_t)((uint32_t)a + ((uint32_t)b << 8) + ((uint32_t)c << 16) + ((uint32_t)d << 24))
+#define BASE64_INVALID_VALUE 64
 
-static char base64char(unsigned char val)
+static const char base64_alphabet[64] =
 {
-    char result;
+    'A', 'B', 'C', 'D', 'E', 'F', 'G', 'H', 'I', 'J', 'K', 'L', 'M', 'N', 'O', 'P',
+    'Q', 'R', 'S', 'T', 'U', 'V', 'W', 'X', 'Y', 'Z', 'a', 'b', 'c', 'd', 'e', 'f',
+    'g', 'h', 'i', 'j', 'k', 'l', 'm', 'n', 'o', 'p', 'q', 'r', 's', 't', 'u', 'v',
+    'w', 'x', 'y', 'z', '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', '+', '/'
+};
 
-    if (val < 26)
-    {
-        result = 'A' + (char)val;
-    }
-    else if (val < 52)
-    {
-        result = 'a' + ((char)val - 26);
-    }
-    else if (val < 62)
-    {
-        result = '0' + ((char)val - 52);
-    }
-    else if (val == 62)
-    {
-        result = '+';
-    }
-    else
-    {
-        result = '/';
-    }
-
-    return result;
-}
-
-static char base64b16(unsigned char val)
-{
-    const uint32_t base64b16values[4] = {
-        joinChars('A', 'E', 'I', 'M'),
-        joinChars('Q', 'U', 'Y', 'c'),
-        joinChars('g', 'k', 'o', 's'),
-        joinChars('w', '0', '4', '8')
-    };
-    return splitInt(base64b16values[val >> 2], (val & 0x03));
-}
-
-static char base64b8(unsigned char val)
+/*the 6 bit value of each base64 character, BASE64_INVALID_VALUE for all the other characters (the padding '=' included)*/
+static const unsigned char base64_values[256] =
 {
-    const uint32_t base64b8values = joinChars('A', 'Q', 'g', 'w');
-    return splitInt(base64b8values, val);
-}
+    64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+    64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+    64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 62, 64, 64, 64, 63,
+    52, 53, 54, 55, 56, 57, 58, 59, 60, 61, 64, 64, 64, 64, 64, 64,
+    64,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14,
+    15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 64, 64, 64, 64, 64,
+    64, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40,
+    41, 42, 43, 44, 45, 46, 47, 48, 49, 50, 51, 64, 64, 64, 64, 64,
+    64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+    64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+    64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+    64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+    64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+    64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+    64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64,
+    64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64, 64
+};
 
-static int base64toValue(char base64character, unsigned char* value)
-{
-    int result = 0;
-    if (('A' <= base64character) && (base64character <= 'Z'))
-    {
-        *value = base64character - 'A';
-    }
-    else if (('a' <= base64character) && (base64character <= 'z'))
-    {
-        *value = ('Z' - 'A') + 1 + (base64character - 'a');
-    }
-    else if (('0' <= base64character) && (base64character <= '9'))
-    {
-        *value = ('Z' - 'A') + 1 + ('z' - 'a') + 1 + (base64character - '0');
-    }
-    else if ('+' == base64character)
-    {
-        *value = 62;
-    }
-    else if ('/' == base64character)
-    {
-        *value = 63;
-    }
-    else
-    {
-        *value = 0;
-        result = -1;
-    }
-    return result;
-}
+#define base64toValue(base64character) (base64_values[(unsigned char)(base64character)])
 
 static size_t numberOfBase64Characters(const char* encodedString)
 {
     size_t length = 0;
-    unsigned char junkChar;
-    while (base64toValue(encodedString[length],&junkChar) != -1)
+    while (base64toValue(encodedString[length]) != BASE64_INVALID_VALUE)
     {
         length++;
     }
     return length;
 }
 
+/*checks that the sourceLength - numberOfEncodedChars characters following the base64 characters of encodedString are up to two '='*/
+static bool hasValidBase64Padding(const char* encodedString, size_t sourceLength, size_t numberOfEncodedChars)
+{
+    size_t paddingLength = sourceLength - numberOfEncodedChars;
+
+    return (paddingLength <= 2) &&
+        ((paddingLength < 1) || (encodedString[numberOfEncodedChars] == '=')) &&
+        ((paddingLength < 2) || (encodedString[numberOfEncodedChars + 1] == '='));
+}
+
 /*returns the count of original bytes before being base64 encoded*/
 /*notice NO validation of the content of encodedString. Its length is validated to be a multiple of 4.*/
-static size_t Base64decode_len(const char *encodedString)
+static size_t Base64decode_len(const char *encodedString, size_t sourceLength)
 {
     size_t result;
-    size_t sourceLength = strlen(encodedString);
 
     if (sourceLength == 0)
     {
@@ -125,12 +89,10 @@ static size_t Base64decode_len(const char *encodedString)
     return result;
 }
 
-static void Base64decode(unsigned char *decodedString, const char *base64String)
+/*decodes the first numberOfEncodedChars characters of base64String, which are all known to be base64 characters*/
+static void Base64decode(unsigned char *decodedString, const char *base64String, size_t numberOfEncodedChars)
 {
-
-    size_t numberOfEncodedChars;
-    size_t indexOfFirstEncodedChar;
-    size_t decodedIndex;
+    const unsigned char* encoded = (const unsigned char*)base64String;
 
     //
     // We can only operate on individual bytes.  If we attempt to work
@@ -138,50 +100,85 @@ static void Base64decode(unsigned char *decodedString, const char *base64String)
     // architectures
     //
 
-    numberOfEncodedChars = numberOfBase64Characters(base64String);
-    indexOfFirstEncodedChar = 0;
-    decodedIndex = 0;
     while (numberOfEncodedChars >= 4)
     {
-        unsigned char c1;
-        unsigned char c2;
-        unsigned char c3;
-        unsigned char c4;
-        (void)base64toValue(base64String[indexOfFirstEncodedChar], &c1);
-        (void)base64toValue(base64String[indexOfFirstEncodedChar + 1], &c2);
-        (void)base64toValue(base64String[indexOfFirstEncodedChar + 2], &c3);
-        (void)base64toValue(base64String[indexOfFirstEncodedChar + 3], &c4);
-        decodedString[decodedIndex] = (c1 << 2) | (c2 >> 4);
-        decodedIndex++;
-        decodedString[decodedIndex] = ((c2 & 0x0f) << 4) | (c3 >> 2);
-        decodedIndex++;
-        decodedString[decodedIndex] = ((c3 & 0x03) << 6) | c4;
-        decodedIndex++;
+        uint32_t quantum =
+            ((uint32_t)base64_values[encoded[0]] << 18) |
+            ((uint32_t)base64_values[encoded[1]] << 12) |
+            ((uint32_t)base64_values[encoded[2]] << 6) |
+            (uint32_t)base64_values[encoded[3]];
+        decodedString[0] = (unsigned char)(quantum >> 16);
+        decodedString[1] = (unsigned char)(quantum >> 8);
+        decodedString[2] = (unsigned char)quantum;
+        decodedString += 3;
+        encoded += 4;
         numberOfEncodedChars -= 4;
-        indexOfFirstEncodedChar += 4;
+    }
 
+    if (numberOfEncodedChars >= 2)
+    {
+        uint32_t quantum =
+            ((uint32_t)base64_values[encoded[0]] << 18) |
+            ((uint32_t)base64_values[encoded[1]] << 12);
+        if (numberOfEncodedChars == 3)
+        {
+            quantum |= (uint32_t)base64_values[encoded[2]] << 6;
+            decodedString[1] = (unsigned char)(quantum >> 8);
+        }
+        decodedString[0] = (unsigned char)(quantum >> 16);
     }
+}
 
-    if (numberOfEncodedChars == 2)
+static size_t Base64encode_len(size_t size)
+{
+    /*4 characters for every started group of 3 bytes*/
+    return (size == 0) ? 0 : ((((size - 1) / 3) + 1) * 4);
+}
+
+/*encodes group_count groups of 3 bytes from source in the group_count * 4 characters of encoded*/
+static void Base64encode_groups(char* encoded, const unsigned char* source, size_t group_count)
+{
+    while (group_count > 0)
     {
-        unsigned char c1;
-        unsigned char c2;
-        (void)base64toValue(base64String[indexOfFirstEncodedChar], &c1);
-        (void)base64toValue(base64String[indexOfFirstEncodedChar + 1], &c2);
-        decodedString[decodedIndex] = (c1 << 2) | (c2 >> 4);
+        uint32_t quantum = ((uint32_t)source[0] << 16) | ((uint32_t)source[1] << 8) | (uint32_t)source[2];
+        encoded[0] = base64_alphabet[quantum >> 18];
+        encoded[1] = base64_alphabet[(quantum >> 12) & 0x3F];
+        encoded[2] = base64_alphabet[(quantum >> 6) & 0x3F];
+        encoded[3] = base64_alphabet[quantum & 0x3F];
+        encoded += 4;
+        source += 3;
+        group_count--;
     }
-    else if (numberOfEncodedChars == 3)
+}
+
+/*encodes size bytes from source in encoded, which has room for Base64encode_len(size) + 1 characters*/
+static void Base64encode(char* encoded, const unsigned char* source, size_t size)
+{
+    /*b0            b1(+1)          b2(+2)
+    7 6 5 4 3 2 1 0 7 6 5 4 3 2 1 0 7 6 5 4 3 2 1 0
+    |----c1---| |----c2---| |----c3---| |----c4---|
+    */
+    Base64encode_groups(encoded, source, size / 3);
+    encoded += size / 3 * 4;
+    source += size / 3 * 3;
+    size %= 3;
+
+    if (size != 0)
     {
-        unsigned char c1;
-        unsigned char c2;
-        unsigned char c3;
-        (void)base64toValue(base64String[indexOfFirstEncodedChar], &c1);
-        (void)base64toValue(base64String[indexOfFirstEncodedChar + 1], &c2);
-        (void)base64toValue(base64String[indexOfFirstEncodedChar + 2], &c3);
-        decodedString[decodedIndex] = (c1 << 2) | (c2 >> 4);
-        decodedIndex++;
-        decodedString[decodedIndex] = ((c2 & 0x0f) << 4) | (c3 >> 2);
+        uint32_t quantum = (uint32_t)source[0] << 16;
+        if (size == 2)
+        {
+            quantum |= (uint32_t)source[1] << 8;
+        }
+        encoded[0] = base64_alphabet[quantum >> 18];
+        encoded[1] = base64_alphabet[(quantum >> 12) & 0x3F];
+        encoded[2] = (size == 2) ? base64_alphabet[(quantum >> 6) & 0x3F] : '=';
+        encoded[3] = '=';
+        encoded += 4;
     }
+
+    /*null terminating the string*/
+    encoded[0] = '\0';
 }
 
 BUFFER_HANDLE Base64_Decoder(const char* source)
@@ -195,12 +192,20 @@ BUFFER_HANDLE Base64_Decoder(const char* source)
     }
     else
     {
-        if ((strlen(source) % 4) != 0)
+        size_t sourceLength = strlen(source);
+        size_t numberOfEncodedChars = numberOfBase64Characters(source);
+        if ((sourceLength % 4) != 0)
         {
             /*Codes_SRS_BASE64_06_011: [If the source string has an invalid length for a base 64 encoded string then Base64_Decode shall return NULL.]*/
             LogError("Invalid length Base64 string!");
             result = NULL;
         }
+        else if (!hasValidBase64Padding(source, sourceLength, numberOfEncodedChars))
+        {
+            /*Codes_SRS_BASE64_01_038: [ If source contains characters other than the base64 alphabet and up to two trailing '=', Base64_Decoder shall return NULL. ]*/
+            LogError("Invalid Base64 string");
+            result = NULL;
+        }
         else
         {
             if ((result = BUFFER_new()) == NULL)
@@ -210,7 +215,7 @@ BUFFER_HANDLE Base64_Decoder(const char* source)
             }
             else
             {
-                size_t sizeOfOutputBuffer = Base64decode_len(source);
+                size_t sizeOfOutputBuffer = Base64decode_len(source, sourceLength);
                 /*Codes_SRS_BASE64_06_009: [If the string pointed to by source is zero length then the handle returned shall refer to a zero length buffer.]*/
                 if (sizeOfOutputBuffer > 0)
                 {
@@ -223,7 +228,7 @@ BUFFER_HANDLE Base64_Decoder(const char* source)
                     }
                     else
                     {
-                        Base64decode(BUFFER_u_char(result), source);
+                        Base64decode(BUFFER_u_char(result), source, numberOfEncodedChars);
                     }
                 }
             }
@@ -236,11 +241,8 @@ BUFFER_HANDLE Base64_Decoder(const char* source)
 static STRING_HANDLE Base64_Encode_Internal(const unsigned char* source, size_t size)
 {
     STRING_HANDLE result;
-    size_t neededSize = 0;
     char* encoded;
-    size_t currentPosition = 0;
-    neededSize += (size == 0) ? (0) : ((((size - 1) / 3) + 1) * 4);
-    neededSize += 1; /*+1 because \0 at the end of the string*/
+    size_t neededSize = Base64encode_len(size) + 1; /*+1 because \0 at the end of the string*/
     /*Codes_SRS_BASE64_06_006: [If when allocating memory to produce the encoding a failure occurs then Base64_Encoder shall return NULL.]*/
     encoded = (char*)malloc(neededSize);
     if (encoded == NULL)
@@ -250,58 +252,7 @@ static STRING_HANDLE Base64_Encode_Internal(const unsigned char* source, size_t
     }
     else
     {
-        /*b0            b1(+1)          b2(+2)
-        7 6 5 4 3 2 1 0 7 6 5 4 3 2 1 0 7 6 5 4 3 2 1 0
-        |----c1---| |----c2---| |----c3---| |----c4---|
-        */
-
-        size_t destinationPosition = 0;
-        while (size - currentPosition >= 3)
-        {
-            char c1 = base64char(source[currentPosition] >> 2);
-            char c2 = base64char(
-                ((source[currentPosition] & 3) << 4) |
-                    (source[currentPosition + 1] >> 4)
-            );
-            char c3 = base64char(
-                ((source[currentPosition + 1] & 0x0F) << 2) |
-                    ((source[currentPosition + 2] >> 6) & 3)
-            );
-            char c4 = base64char(
-                source[currentPosition + 2] & 0x3F
-            );
-            currentPosition += 3;
-            encoded[destinationPosition++] = c1;
-            encoded[destinationPosition++] = c2;
-            encoded[destinationPosition++] = c3;
-            encoded[destinationPosition++] = c4;
-
-        }
-        if (size - currentPosition == 2)
-        {
-            char c1 = base64char(source[currentPosition] >> 2);
-            char c2 = base64char(
-                ((source[currentPosition] & 0x03) << 4) |
-                    (source[currentPosition + 1] >> 4)
-            );
-            char c3 = base64b16(source[currentPosition + 1] & 0x0F);
-            encoded[destinationPosition++] = c1;
-            encoded[destinationPosition++] = c2;
-            encoded[destinationPosition++] = c3;
-            encoded[destinationPosition++] = '=';
-        }
-        else if (size - currentPosition == 1)
-        {
-            char c1 = base64char(source[currentPosition] >> 2);
-            char c2 = base64b8(source[currentPosition] & 0x03);
-            encoded[destinationPosition++] = c1;
-            encoded[destinationPosition++] = c2;
-            encoded[destinationPosition++] = '=';
-            encoded[destinationPosition++] = '=';
-        }
-
-        /*null terminating the string*/
-        encoded[destinationPosition] = '\0';
+        Base64encode(encoded, source, size);
         /*Codes_SRS_BASE64_06_007: [Otherwise Base64_Encoder shall return a pointer to STRING, that string contains the base 64 encoding of input.]*/
         result = STRING_new_with_memory(encoded);
         if (result == NULL)
@@ -366,3 +317,493 @@ STRING_HANDLE Base64_Encoder(BUFFER_HANDLE input)
     }
     return result;
 }
+
+size_t Base64_Encoded_Length(size_t size)
+{
+    size_t result;
+    if (size > (((size_t)-1) / 4) * 3)
+    {
+        /*Codes_SRS_BASE64_01_002: [ If the encoding of size bytes cannot be represented in a size_t, Base64_Encoded_Length shall return 0. ]*/
+        LogError("Invalid argument: size=%lu is too large", (unsigned long)size);
+        result = 0;
+    }
+    else
+    {
+        /*Codes_SRS_BASE64_01_001: [ Base64_Encoded_Length shall return the number of characters in the base64 encoding of size bytes, not counting the terminating '\0'. ]*/
+        result = Base64encode_len(size);
+    }
+    return result;
+}
+
+int Base64_Encode_To(const unsigned char* source, size_t size, char* destination, size_t destination_size)
+{
+    int result;
+    if (((source == NULL) && (size > 0)) ||
+        (destination == NULL))
+    {
+        /*Codes_SRS_BASE64_01_003: [ If source is NULL and size is not 0, or destination is NULL, Base64_Encode_To shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: const unsigned char* source=%p, size_t size=%lu, char* destination=%p", source, (unsigned long)size, destination);
+        result = __FAILURE__;
+    }
+    else if ((size > (((size_t)-1) / 4) * 3) ||
+        (destination_size <= Base64encode_len(size)))
+    {
+        /*Codes_SRS_BASE64_01_004: [ If destination_size is less than Base64_Encoded_Length(size) + 1, Base64_Encode_To shall fail and return a non-zero value. ]*/
+        LogError("destination_size=%lu is too small for the encoding of %lu bytes", (unsigned long)destination_size, (unsigned long)size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_BASE64_01_005: [ Otherwise Base64_Encode_To shall write the base64 encoding of source, followed by a '\0', to destination and return 0. ]*/
+        Base64encode(destination, source, size);
+        result = 0;
+    }
+    return result;
+}
+
+size_t Base64_Decoded_Length(const char* source)
+{
+    size_t result;
+    if (source == NULL)
+    {
+        /*Codes_SRS_BASE64_01_006: [ If source is NULL, Base64_Decoded_Length shall return 0. ]*/
+        LogError("Invalid argument: const char* source=%p", source);
+        result = 0;
+    }
+    else
+    {
+        size_t sourceLength = strlen(source);
+        if ((sourceLength % 4) != 0)
+        {
+            /*Codes_SRS_BASE64_01_007: [ If the length of source is not a multiple of 4, Base64_Decoded_Length shall return 0. ]*/
+            LogError("Invalid length Base64 string!");
+            result = 0;
+        }
+        else
+        {
+            /*Codes_SRS_BASE64_01_008: [ Otherwise Base64_Decoded_Length shall return the number of bytes source decodes to. ]*/
+            result = Base64decode_len(source, sourceLength);
+        }
+    }
+    return result;
+}
+
+int Base64_Decode_To(const char* source, unsigned char* destination, size_t destination_size, size_t* decoded_size)
+{
+    int result;
+    if ((source == NULL) ||
+        (decoded_size == NULL) ||
+        ((destination == NULL) && (destination_size > 0)))
+    {
+        /*Codes_SRS_BASE64_01_009: [ If source or decoded_size is NULL, or destination is NULL and destination_size is not 0, Base64_Decode_To shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: const char* source=%p, unsigned char* destination=%p, size_t destination_size=%lu, size_t* decoded_size=%p",
+            source, destination, (unsigned long)destination_size, decoded_size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t sourceLength = strlen(source);
+        size_t numberOfEncodedChars = numberOfBase64Characters(source);
+
+        if (((sourceLength % 4) != 0) ||
+            !hasValidBase64Padding(source, sourceLength, numberOfEncodedChars))
+        {
+            /*Codes_SRS_BASE64_01_010: [ If source is not a valid base64 encoding (its length is not a multiple of 4 or it contains characters other than the base64 alphabet and up to two trailing '='), Base64_Decode_To shall fail and return a non-zero value. ]*/
+            LogError("Invalid Base64 string");
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t decodedLength = Base64decode_len(source, sourceLength);
+            if (destination_size < decodedLength)
+            {
+                /*Codes_SRS_BASE64_01_011: [ If destination_size is less than the number of bytes source decodes to, Base64_Decode_To shall fail and return a non-zero value. ]*/
+                LogError("destination_size=%lu is too small for %lu decoded bytes", (unsigned long)destination_size, (unsigned long)decodedLength);
+                result = __FAILURE__;
+            }
+            else
+            {
+                /*Codes_SRS_BASE64_01_012: [ Otherwise Base64_Decode_To shall write the decoded bytes to destination, set decoded_size to their number and return 0. ]*/
+                Base64decode(destination, source, numberOfEncodedChars);
+                *decoded_size = decodedLength;
+                result = 0;
+            }
+        }
+    }
+    return result;
+}
+
+/*encodes the groups of 3 bytes completed by the size bytes of source, keeping the bytes of the last started group in context. destination has room for the characters of all the completed groups*/
+static size_t Base64_Encoder_Feed(BASE64_ENCODER_CONTEXT* context, const unsigned char* source, size_t size, char* destination)
+{
+    size_t written = 0;
+    size_t group_count;
+
+    if ((context->leftover_count > 0) &&
+        (context->leftover_count + size >= 3))
+    {
+        /*the first bytes of source complete the group started by the previous chunks*/
+        unsigned char group[3];
+        size_t taken = 3 - context->leftover_count;
+        group[0] = context->leftover[0];
+        group[1] = (context->leftover_count > 1) ? context->leftover[1] : source[0];
+        group[2] = source[taken - 1];
+        Base64encode_groups(destination, group, 1);
+        written = 4;
+        source += taken;
+        size -= taken;
+        context->leftover_count = 0;
+    }
+
+    group_count = (context->leftover_count == 0) ? (size / 3) : 0;
+    Base64encode_groups(destination + written, source, group_count);
+    written += group_count * 4;
+    source += group_count * 3;
+    size -= group_count * 3;
+
+    /*what remains is at most 2 bytes, all kept for the next group*/
+    while (size > 0)
+    {
+        context->leftover[context->leftover_count] = *source;
+        context->leftover_count++;
+        source++;
+        size--;
+    }
+
+    return written;
+}
+
+/*the number of characters produced when size more bytes are given to an encoder holding leftover_count bytes*/
+static size_t Base64_Encoder_Feed_len(size_t leftover_count, size_t size)
+{
+    return ((size / 3) + (((size % 3) + leftover_count) / 3)) * 4;
+}
+
+int Base64_Encoder_Init(BASE64_ENCODER_CONTEXT* context)
+{
+    int result;
+    if (context == NULL)
+    {
+        /*Codes_SRS_BASE64_01_013: [ If context is NULL, Base64_Encoder_Init shall fail and return a non-zero value. ]*/
+        LogError("Invalid argument: BASE64_ENCODER_CONTEXT* context=%p", context);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_BASE64_01_014: [ Otherwise Base64_Encoder_Init shall set context to hold no bytes of the input and return 0. ]*/
+        context->leftover_count = 0;
+        result = 0;
+    }
+    return result;
+}
+
+int Base64_Encoder_Update(BASE64_ENCODER_CONTEXT* context, const unsigned char* source, size_t size, char* destination, size_t destination_size, size_t* written)
+{
+    int result;
+    if ((context == NULL) ||
+        ((source == NULL) && (size > 0)) ||
+        ((destination == NULL) && (destination_size > 0)) ||
+        (written == NULL))
+    {
+        /*Codes_SRS_BASE64_01_015: [ If context or written is NULL, or source is NULL and size is not 0, or destination is NULL and destination_size is not 0, Base64_Encoder_Update shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: BASE64_ENCODER_CONTEXT* context=%p, const unsigned char* source=%p, size_t size=%lu, char* destination=%p, size_t destination_size=%lu, size_t* written=%p",
+            context, source, (unsigned long)size, destination, (unsigned long)destination_size, written);
+        result = __FAILURE__;
+    }
+    else if ((size > (((size_t)-1) / 4) * 3) ||
+        (destination_size < Base64_Encoder_Feed_len(context->leftover_count, size)))
+    {
+        /*Codes_SRS_BASE64_01_016: [ If destination_size is less than the number of characters of the groups of 3 bytes completed by source, Base64_Encoder_Update shall fail and return a non-zero value. ]*/
+        LogError("destination_size=%lu is too small for the encoding of %lu bytes", (unsigned long)destination_size, (unsigned long)size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_BASE64_01_017: [ Otherwise Base64_Encoder_Update shall write to destination the characters of the groups of 3 bytes completed by source, keep in context the bytes of the last started group, set written to the number of characters written and return 0. ]*/
+        *written = Base64_Encoder_Feed(context, source, size, destination);
+        result = 0;
+    }
+    return result;
+}
+
+int Base64_Encoder_Update_From_Array(BASE64_ENCODER_CONTEXT* context, CONSTBUFFER_ARRAY_HANDLE source, uint32_t* offset, char* destination, size_t destination_size, size_t* written)
+{
+    int result;
+    uint32_t all_buffers_size;
+    if ((context == NULL) ||
+        (source == NULL) ||
+        (offset == NULL) ||
+        ((destination == NULL) && (destination_size > 0)) ||
+        (written == NULL))
+    {
+        /*Codes_SRS_BASE64_01_018: [ If context, source, offset or written is NULL, or destination is NULL and destination_size is not 0, Base64_Encoder_Update_From_Array shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: BASE64_ENCODER_CONTEXT* context=%p, CONSTBUFFER_ARRAY_HANDLE source=%p, uint32_t* offset=%p, char* destination=%p, size_t destination_size=%lu, size_t* written=%p",
+            context, source, offset, destination, (unsigned long)destination_size, written);
+        result = __FAILURE__;
+    }
+    /*Codes_SRS_BASE64_01_019: [ Base64_Encoder_Update_From_Array shall get the size of source by calling constbuffer_array_get_all_buffers_size. ]*/
+    else if (constbuffer_array_get_all_buffers_size(source, &all_buffers_size) != 0)
+    {
+        /*Codes_SRS_BASE64_01_020: [ If any call to the constbuffer_array functions fails, Base64_Encoder_Update_From_Array shall fail and return a non-zero value. ]*/
+        LogError("constbuffer_array_get_all_buffers_size failed");
+        result = __FAILURE__;
+    }
+    else if (*offset > all_buffers_size)
+    {
+        /*Codes_SRS_BASE64_01_021: [ If offset is past the end of source, Base64_Encoder_Update_From_Array shall fail and return a non-zero value. ]*/
+        LogError("offset=%lu is past the end of the %lu bytes of source", (unsigned long)*offset, (unsigned long)all_buffers_size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_BASE64_01_022: [ Base64_Encoder_Update_From_Array shall consume the bytes of source starting at offset, as many as complete the groups of 3 bytes whose characters fit in destination_size, or all of them if fewer. ]*/
+        size_t to_consume;
+        uint32_t remaining = all_buffers_size - *offset;
+        if (destination_size < 4)
+        {
+            to_consume = 0;
+        }
+        else
+        {
+            to_consume = (destination_size / 4) * 3 - context->leftover_count;
+            if (to_consume > remaining)
+            {
+                to_consume = remaining;
+            }
+        }
+
+        *written = 0;
+        result = 0;
+
+        if (to_consume > 0)
+        {
+            uint32_t buffer_index;
+            uint32_t offset_in_buffer;
+
+            /*Codes_SRS_BASE64_01_023: [ Base64_Encoder_Update_From_Array shall find the buffer holding the byte at offset by calling constbuffer_array_get_buffer_index_at_offset and read the buffers from there by calling constbuffer_array_get_buffer_content. ]*/
+            if (constbuffer_array_get_buffer_index_at_offset(source, *offset, &buffer_index, &offset_in_buffer) != 0)
+            {
+                /*Codes_SRS_BASE64_01_020: [ If any call to the constbuffer_array functions fails, Base64_Encoder_Update_From_Array shall fail and return a non-zero value. ]*/
+                LogError("constbuffer_array_get_buffer_index_at_offset failed for offset=%lu", (unsigned long)*offset);
+                result = __FAILURE__;
+            }
+            else
+            {
+                size_t consumed = 0;
+                while (consumed < to_consume)
+                {
+                    const CONSTBUFFER* content = constbuffer_array_get_buffer_content(source, buffer_index);
+                    if (content == NULL)
+                    {
+                        /*Codes_SRS_BASE64_01_020: [ If any call to the constbuffer_array functions fails, Base64_Encoder_Update_From_Array shall fail and return a non-zero value. ]*/
+                        LogError("constbuffer_array_get_buffer_content failed for buffer_index=%lu", (unsigned long)buffer_index);
+                        result = __FAILURE__;
+                        break;
+                    }
+                    else
+                    {
+                        size_t chunk_size = content->size - offset_in_buffer;
+                        if (chunk_size > to_consume - consumed)
+                        {
+                            chunk_size = to_consume - consumed;
+                        }
+                        *written += Base64_Encoder_Feed(context, content->buffer + offset_in_buffer, chunk_size, destination + *written);
+                        consumed += chunk_size;
+                        offset_in_buffer = 0;
+                        buffer_index++;
+                    }
+                }
+
+                if (result == 0)
+                {
+                    /*Codes_SRS_BASE64_01_024: [ On success Base64_Encoder_Update_From_Array shall advance offset past the bytes consumed, set written to the number of characters written and return 0. ]*/
+                    *offset += (uint32_t)consumed;
+                }
+            }
+        }
+    }
+    return result;
+}
+
+int Base64_Encoder_Finish(BASE64_ENCODER_CONTEXT* context, char* destination, size_t destination_size, size_t* written)
+{
+    int result;
+    if ((context == NULL) ||
+        ((destination == NULL) && (destination_size > 0)) ||
+        (written == NULL))
+    {
+        /*Codes_SRS_BASE64_01_025: [ If context or written is NULL, or destination is NULL and destination_size is not 0, Base64_Encoder_Finish shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: BASE64_ENCODER_CONTEXT* context=%p, char* destination=%p, size_t destination_size=%lu, size_t* written=%p",
+            context, destination, (unsigned long)destination_size, written);
+        result = __FAILURE__;
+    }
+    else if ((context->leftover_count > 0) &&
+        (destination_size < 4))
+    {
+        /*Codes_SRS_BASE64_01_026: [ If context holds bytes of the input and destination_size is less than 4, Base64_Encoder_Finish shall fail and return a non-zero value. ]*/
+        LogError("destination_size=%lu is too small for the last 4 characters", (unsigned long)destination_size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_BASE64_01_027: [ Otherwise Base64_Encoder_Finish shall write to destination the 4 characters, padding included, of the bytes held in context if any, set written to their number, set context to hold no bytes and return 0. ]*/
+        if (context->leftover_count > 0)
+        {
+            char encoded[5];
+            Base64encode(encoded, context->leftover, context->leftover_count);
+            (void)memcpy(destination, encoded, 4);
+            *written = 4;
+        }
+        else
+        {
+            *written = 0;
+        }
+        context->leftover_count = 0;
+        result = 0;
+    }
+    return result;
+}
+
+int Base64_Decoder_Init(BASE64_DECODER_CONTEXT* context)
+{
+    int result;
+    if (context == NULL)
+    {
+        /*Codes_SRS_BASE64_01_028: [ If context is NULL, Base64_Decoder_Init shall fail and return a non-zero value. ]*/
+        LogError("Invalid argument: BASE64_DECODER_CONTEXT* context=%p", context);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_BASE64_01_029: [ Otherwise Base64_Decoder_Init shall set context to hold no characters of the input and return 0. ]*/
+        context->value_count = 0;
+        context->padding_count = 0;
+        context->is_complete = 0;
+        result = 0;
+    }
+    return result;
+}
+
+int Base64_Decoder_Update(BASE64_DECODER_CONTEXT* context, const char* source, size_t length, unsigned char* destination, size_t destination_size, size_t* written)
+{
+    int result;
+    if ((context == NULL) ||
+        ((source == NULL) && (length > 0)) ||
+        ((destination == NULL) && (destination_size > 0)) ||
+        (written == NULL))
+    {
+        /*Codes_SRS_BASE64_01_030: [ If context or written is NULL, or source is NULL and length is not 0, or destination is NULL and destination_size is not 0, Base64_Decoder_Update shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: BASE64_DECODER_CONTEXT* context=%p, const char* source=%p, size_t length=%lu, unsigned char* destination=%p, size_t destination_size=%lu, size_t* written=%p",
+            context, source, (unsigned long)length, destination, (unsigned long)destination_size, written);
+        result = __FAILURE__;
+    }
+    else
+    {
+        const unsigned char* encoded = (const unsigned char*)source;
+        size_t decoded = 0;
+        size_t i;
+
+        result = 0;
+
+        for (i = 0; i < length; i++)
+        {
+            unsigned char value = base64_values[encoded[i]];
+
+            if ((context->is_complete) ||
+                ((encoded[i] == '=') && (context->value_count < 2)) ||
+                ((encoded[i] != '=') && ((value == BASE64_INVALID_VALUE) || (context->padding_count > 0))))
+            {
+                /*Codes_SRS_BASE64_01_031: [ If source makes the input an invalid base64 encoding (a character other than the base64 alphabet, a '=' other than one of the up to two ending the last group of 4 characters, or a character after that group), Base64_Decoder_Update shall fail and return a non-zero value. ]*/
+                LogError("Invalid Base64 character at index %lu of source", (unsigned long)i);
+                result = __FAILURE__;
+                break;
+            }
+            else if (encoded[i] == '=')
+            {
+                context->padding_count++;
+            }
+            else
+            {
+                /*the value completing a group is not kept, the group is decoded right away*/
+                if (context->value_count < 3)
+                {
+                    context->values[context->value_count] = value;
+                }
+                context->value_count++;
+            }
+
+            if (context->value_count + context->padding_count == 4)
+            {
+                size_t group_size = 3 - context->padding_count;
+                if (destination_size - decoded < group_size)
+                {
+                    /*Codes_SRS_BASE64_01_032: [ If destination_size is less than the number of bytes of the groups of 4 characters completed by source, Base64_Decoder_Update shall fail and return a non-zero value. ]*/
+                    LogError("destination_size=%lu is too small for the decoded bytes", (unsigned long)destination_size);
+                    result = __FAILURE__;
+                    break;
+                }
+                else
+                {
+                    uint32_t quantum =
+                        ((uint32_t)context->values[0] << 18) |
+                        ((uint32_t)context->values[1] << 12) |
+                        ((context->value_count > 2) ? ((uint32_t)context->values[2] << 6) : 0) |
+                        ((context->value_count > 3) ? (uint32_t)value : 0);
+                    destination[decoded] = (unsigned char)(quantum >> 16);
+                    if (group_size > 1)
+                    {
+                        destination[decoded + 1] = (unsigned char)(quantum >> 8);
+                        if (group_size > 2)
+                        {
+                            destination[decoded + 2] = (unsigned char)quantum;
+                        }
+                    }
+                    decoded += group_size;
+
+                    /*a group with padding ends the input*/
+                    context->is_complete = (context->padding_count > 0);
+                    context->value_count = 0;
+                    context->padding_count = 0;
+                }
+            }
+        }
+
+        if (result == 0)
+        {
+            /*Codes_SRS_BASE64_01_033: [ Otherwise Base64_Decoder_Update shall write to destination the bytes of the groups of 4 characters completed by source, keep in context the characters of the last started group, set written to the number of bytes written and return 0. ]*/
+            *written = decoded;
+        }
+    }
+    return result;
+}
+
+int Base64_Decoder_Finish(BASE64_DECODER_CONTEXT* context)
+{
+    int result;
+    if (context == NULL)
+    {
+        /*Codes_SRS_BASE64_01_034: [ If context is NULL, Base64_Decoder_Finish shall fail and return a non-zero value. ]*/
+        LogError("Invalid argument: BASE64_DECODER_CONTEXT* context=%p", context);
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (context->value_count + context->padding_count != 0)
+        {
+            /*Codes_SRS_BASE64_01_035: [ If context holds the characters of a started group of 4, Base64_Decoder_Finish shall fail and return a non-zero value. ]*/
+            LogError("The length of the Base64 input is not a multiple of 4");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /*Codes_SRS_BASE64_01_036: [ Otherwise Base64_Decoder_Finish shall return 0. ]*/
+            result = 0;
+        }
+
+        /*Codes_SRS_BASE64_01_037: [ Base64_Decoder_Finish shall set context to hold no characters of the input. ]*/
+        context->value_count = 0;
+        context->padding_count = 0;
+        context->is_complete = 0;
+    }
+    return result;
+}
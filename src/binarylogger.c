@@ -0,0 +1,1178 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/binarylogger.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+/*
+* A stream is a header followed by records, all integers are little endian:
+*
+*   header          'A' 'Z' 'B' 'L' version
+*   string record   'S' id:u32 length:u16 bytes '\0'
+*   line record     'L' category:u8 options:u8 line:i32 file_id:u32 func_id:u32 format_id:u32 arguments_size:u16 arguments
+*   argument        'i' i64 | 'u' u64 | 'f' double as u64 | 'p' u64 | 's' length:u16 bytes '\0'
+*
+* String ids are given in sequence from 1, 0 stands for NULL. The arguments are the ones the
+* conversions of the format string consume, a '*' width or precision being an 'i' argument.
+*
+* binarylogger_log must not log: it may well be the installed LOGGER_LOG.
+*/
+#define BINARYLOGGER_VERSION 1
+#define BINARYLOGGER_HEADER_SIZE 5
+#define BINARYLOGGER_RECORD_STRING 'S'
+#define BINARYLOGGER_RECORD_LINE 'L'
+#define BINARYLOGGER_ARGUMENT_SIGNED 'i'
+#define BINARYLOGGER_ARGUMENT_UNSIGNED 'u'
+#define BINARYLOGGER_ARGUMENT_DOUBLE 'f'
+#define BINARYLOGGER_ARGUMENT_POINTER 'p'
+#define BINARYLOGGER_ARGUMENT_STRING 's'
+
+#define BINARYLOGGER_STRING_RECORD_SIZE(length) (1 + 4 + 2 + (length) + 1)
+#define BINARYLOGGER_LINE_RECORD_SIZE(arguments_size) (1 + 1 + 1 + 4 + 4 + 4 + 4 + 2 + (arguments_size))
+#define BINARYLOGGER_MAX_STRING_LENGTH 0xFFFF
+
+#define BINARYLOGGER_DEFAULT_BUFFER_SIZE (64 * 1024)
+#define BINARYLOGGER_MAX_ARGUMENTS_SIZE 1024
+/* the file, function and format strings that get an id, a power of 2 */
+#define BINARYLOGGER_STRING_TABLE_SIZE 1024
+#define BINARYLOGGER_MAX_MESSAGE_SIZE 1024
+#define BINARYLOGGER_MAX_SPECIFICATION_SIZE 64
+
+#if defined(_MSC_VER)
+#define BINARYLOGGER_ADD(value, addend) InterlockedExchangeAdd(&(value), (addend))
+#else
+#define BINARYLOGGER_ADD(value, addend) __sync_fetch_and_add(&(value), (addend))
+#endif
+
+typedef enum LENGTH_MODIFIER_TAG
+{
+    LENGTH_MODIFIER_NONE,
+    LENGTH_MODIFIER_HH,
+    LENGTH_MODIFIER_H,
+    LENGTH_MODIFIER_L,
+    LENGTH_MODIFIER_LL,
+    LENGTH_MODIFIER_J,
+    LENGTH_MODIFIER_Z,
+    LENGTH_MODIFIER_T,
+    LENGTH_MODIFIER_LONG_DOUBLE
+} LENGTH_MODIFIER;
+
+/* one conversion of a format string, the text after its '%' */
+typedef struct CONVERSION_TAG
+{
+    const char* flags;
+    size_t flags_length;
+    int width_is_argument;
+    const char* width;
+    size_t width_length;
+    int has_precision;
+    int precision_is_argument;
+    const char* precision;
+    size_t precision_length;
+    LENGTH_MODIFIER length_modifier;
+    char specifier;
+} CONVERSION;
+
+typedef struct STRING_TABLE_ENTRY_TAG
+{
+    const char* string;
+    uint32_t id;
+} STRING_TABLE_ENTRY;
+
+typedef struct BINARYLOGGER_TAG
+{
+    SPINLOCK_HANDLE lock;
+    unsigned char* buffer;
+    size_t buffer_size;
+    size_t used;
+    FILE* file;
+    uint32_t next_string_id;
+    size_t string_count;
+    STRING_TABLE_ENTRY strings[BINARYLOGGER_STRING_TABLE_SIZE];
+} BINARYLOGGER;
+
+static BINARYLOGGER* g_binarylogger = NULL;
+static volatile long g_dropped_count = 0;
+
+static void read_digits(const char** position, const char** digits, size_t* digits_length)
+{
+    *digits = *position;
+    while ((**position >= '0') && (**position <= '9'))
+    {
+        (*position)++;
+    }
+    *digits_length = (size_t)(*position - *digits);
+}
+
+/* parses the conversion at position (after the '%') and returns the text that follows it */
+static const char* parse_conversion(const char* position, CONVERSION* conversion)
+{
+    conversion->flags = position;
+    while ((*position == '-') || (*position == '+') || (*position == ' ') || (*position == '#') || (*position == '0'))
+    {
+        position++;
+    }
+    conversion->flags_length = (size_t)(position - conversion->flags);
+
+    conversion->width_is_argument = (*position == '*');
+    if (conversion->width_is_argument)
+    {
+        position++;
+        conversion->width = NULL;
+        conversion->width_length = 0;
+    }
+    else
+    {
+        read_digits(&position, &conversion->width, &conversion->width_length);
+    }
+
+    conversion->has_precision = (*position == '.');
+    conversion->precision_is_argument = 0;
+    conversion->precision = NULL;
+    conversion->precision_length = 0;
+    if (conversion->has_precision)
+    {
+        position++;
+        conversion->precision_is_argument = (*position == '*');
+        if (conversion->precision_is_argument)
+        {
+            position++;
+        }
+        else
+        {
+            read_digits(&position, &conversion->precision, &conversion->precision_length);
+        }
+    }
+
+    switch (*position)
+    {
+    case 'h':
+        position++;
+        if (*position == 'h')
+        {
+            position++;
+            conversion->length_modifier = LENGTH_MODIFIER_HH;
+        }
+        else
+        {
+            conversion->length_modifier = LENGTH_MODIFIER_H;
+        }
+        break;
+    case 'l':
+        position++;
+        if (*position == 'l')
+        {
+            position++;
+            conversion->length_modifier = LENGTH_MODIFIER_LL;
+        }
+        else
+        {
+            conversion->length_modifier = LENGTH_MODIFIER_L;
+        }
+        break;
+    case 'j':
+        position++;
+        conversion->length_modifier = LENGTH_MODIFIER_J;
+        break;
+    case 'z':
+        position++;
+        conversion->length_modifier = LENGTH_MODIFIER_Z;
+        break;
+    case 't':
+        position++;
+        conversion->length_modifier = LENGTH_MODIFIER_T;
+        break;
+    case 'L':
+        position++;
+        conversion->length_modifier = LENGTH_MODIFIER_LONG_DOUBLE;
+        break;
+    default:
+        conversion->length_modifier = LENGTH_MODIFIER_NONE;
+        break;
+    }
+
+    conversion->specifier = *position;
+    if (*position != '\0')
+    {
+        position++;
+    }
+
+    return position;
+}
+
+static void put_u16(unsigned char* destination, uint16_t value)
+{
+    destination[0] = (unsigned char)value;
+    destination[1] = (unsigned char)(value >> 8);
+}
+
+static void put_u32(unsigned char* destination, uint32_t value)
+{
+    destination[0] = (unsigned char)value;
+    destination[1] = (unsigned char)(value >> 8);
+    destination[2] = (unsigned char)(value >> 16);
+    destination[3] = (unsigned char)(value >> 24);
+}
+
+static void put_u64(unsigned char* destination, uint64_t value)
+{
+    put_u32(destination, (uint32_t)value);
+    put_u32(destination + 4, (uint32_t)(value >> 32));
+}
+
+static uint16_t get_u16(const unsigned char* source)
+{
+    return (uint16_t)(source[0] | (source[1] << 8));
+}
+
+static uint32_t get_u32(const unsigned char* source)
+{
+    return (uint32_t)source[0] | ((uint32_t)source[1] << 8) | ((uint32_t)source[2] << 16) | ((uint32_t)source[3] << 24);
+}
+
+static uint64_t get_u64(const unsigned char* source)
+{
+    return (uint64_t)get_u32(source) | ((uint64_t)get_u32(source + 4) << 32);
+}
+
+/* returns 0 if the argument does not fit */
+static int put_number(unsigned char* arguments, size_t* arguments_size, char tag, uint64_t value)
+{
+    int result;
+
+    if (*arguments_size + 1 + 8 > BINARYLOGGER_MAX_ARGUMENTS_SIZE)
+    {
+        result = 0;
+    }
+    else
+    {
+        arguments[*arguments_size] = (unsigned char)tag;
+        put_u64(arguments + *arguments_size + 1, value);
+        *arguments_size += 1 + 8;
+        result = 1;
+    }
+
+    return result;
+}
+
+static int put_string(unsigned char* arguments, size_t* arguments_size, const char* value, int has_precision, long precision)
+{
+    int result;
+
+    if (*arguments_size + 1 + 2 + 1 > BINARYLOGGER_MAX_ARGUMENTS_SIZE)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t space = BINARYLOGGER_MAX_ARGUMENTS_SIZE - (*arguments_size + 1 + 2 + 1);
+        size_t length = 0;
+
+        if (value == NULL)
+        {
+            value = "(null)";
+        }
+
+        /* with a precision the string does not need to be terminated */
+        while ((length < space) && (value[length] != '\0') && (!has_precision || (precision < 0) || (length < (size_t)precision)))
+        {
+            length++;
+        }
+
+        arguments[*arguments_size] = BINARYLOGGER_ARGUMENT_STRING;
+        put_u16(arguments + *arguments_size + 1, (uint16_t)length);
+        (void)memcpy(arguments + *arguments_size + 3, value, length);
+        arguments[*arguments_size + 3 + length] = '\0';
+        *arguments_size += 1 + 2 + length + 1;
+        result = 1;
+    }
+
+    return result;
+}
+
+static size_t encode_arguments(unsigned char* arguments, const char* format, va_list* args)
+{
+    size_t arguments_size = 0;
+    int fits = 1;
+
+    while (fits && (*format != '\0'))
+    {
+        if (*format != '%')
+        {
+            format++;
+        }
+        else
+        {
+            CONVERSION conversion;
+            long precision = -1;
+
+            format = parse_conversion(format + 1, &conversion);
+
+            if (conversion.width_is_argument)
+            {
+                fits = put_number(arguments, &arguments_size, BINARYLOGGER_ARGUMENT_SIGNED, (uint64_t)(int64_t)va_arg(*args, int));
+            }
+            if (fits && conversion.precision_is_argument)
+            {
+                precision = va_arg(*args, int);
+                fits = put_number(arguments, &arguments_size, BINARYLOGGER_ARGUMENT_SIGNED, (uint64_t)(int64_t)precision);
+            }
+            else if (conversion.has_precision)
+            {
+                precision = strtol(conversion.precision, NULL, 10);
+            }
+
+            if (fits)
+            {
+                switch (conversion.specifier)
+                {
+                case 'd':
+                case 'i':
+                {
+                    int64_t value;
+                    switch (conversion.length_modifier)
+                    {
+                    case LENGTH_MODIFIER_L: value = (int64_t)va_arg(*args, long); break;
+                    case LENGTH_MODIFIER_LL: value = (int64_t)va_arg(*args, long long); break;
+                    case LENGTH_MODIFIER_J: value = (int64_t)va_arg(*args, intmax_t); break;
+                    case LENGTH_MODIFIER_Z: value = (int64_t)va_arg(*args, size_t); break;
+                    case LENGTH_MODIFIER_T: value = (int64_t)va_arg(*args, ptrdiff_t); break;
+                    case LENGTH_MODIFIER_HH: value = (int64_t)(signed char)va_arg(*args, int); break;
+                    case LENGTH_MODIFIER_H: value = (int64_t)(short)va_arg(*args, int); break;
+                    default: value = (int64_t)va_arg(*args, int); break;
+                    }
+                    fits = put_number(arguments, &arguments_size, BINARYLOGGER_ARGUMENT_SIGNED, (uint64_t)value);
+                    break;
+                }
+                case 'u':
+                case 'o':
+                case 'x':
+                case 'X':
+                {
+                    uint64_t value;
+                    switch (conversion.length_modifier)
+                    {
+                    case LENGTH_MODIFIER_L: value = (uint64_t)va_arg(*args, unsigned long); break;
+                    case LENGTH_MODIFIER_LL: value = (uint64_t)va_arg(*args, unsigned long long); break;
+                    case LENGTH_MODIFIER_J: value = (uint64_t)va_arg(*args, uintmax_t); break;
+                    case LENGTH_MODIFIER_Z: value = (uint64_t)va_arg(*args, size_t); break;
+                    case LENGTH_MODIFIER_T: value = (uint64_t)va_arg(*args, ptrdiff_t); break;
+                    case LENGTH_MODIFIER_HH: value = (uint64_t)(unsigned char)va_arg(*args, unsigned int); break;
+                    case LENGTH_MODIFIER_H: value = (uint64_t)(unsigned short)va_arg(*args, unsigned int); break;
+                    default: value = (uint64_t)va_arg(*args, unsigned int); break;
+                    }
+                    fits = put_number(arguments, &arguments_size, BINARYLOGGER_ARGUMENT_UNSIGNED, value);
+                    break;
+                }
+                case 'c':
+                    fits = put_number(arguments, &arguments_size, BINARYLOGGER_ARGUMENT_SIGNED, (uint64_t)(int64_t)va_arg(*args, int));
+                    break;
+                case 'e':
+                case 'E':
+                case 'f':
+                case 'F':
+                case 'g':
+                case 'G':
+                case 'a':
+                case 'A':
+                {
+                    double value = (conversion.length_modifier == LENGTH_MODIFIER_LONG_DOUBLE) ? (double)va_arg(*args, long double) : va_arg(*args, double);
+                    uint64_t bits;
+                    (void)memcpy(&bits, &value, sizeof(bits));
+                    fits = put_number(arguments, &arguments_size, BINARYLOGGER_ARGUMENT_DOUBLE, bits);
+                    break;
+                }
+                case 's':
+                    if (conversion.length_modifier == LENGTH_MODIFIER_L)
+                    {
+                        /* wide strings are not recorded */
+                        (void)va_arg(*args, void*);
+                        fits = put_string(arguments, &arguments_size, "", 0, 0);
+                    }
+                    else
+                    {
+                        fits = put_string(arguments, &arguments_size, va_arg(*args, const char*), conversion.has_precision, precision);
+                    }
+                    break;
+                case 'p':
+                    fits = put_number(arguments, &arguments_size, BINARYLOGGER_ARGUMENT_POINTER, (uint64_t)(uintptr_t)va_arg(*args, void*));
+                    break;
+                case 'n':
+                    (void)va_arg(*args, void*);
+                    break;
+                case '%':
+                    break;
+                default:
+                    /* the arguments that follow cannot be known */
+                    fits = 0;
+                    break;
+                }
+            }
+        }
+    }
+
+    return arguments_size;
+}
+
+/* the id of a string already recorded in the stream, 0 if it is not */
+static uint32_t find_string(BINARYLOGGER* binarylogger, const char* string, size_t* slot)
+{
+    uint32_t result = 0;
+    size_t index = (size_t)((((uintptr_t)string >> 3) ^ ((uintptr_t)string >> 13)) & (BINARYLOGGER_STRING_TABLE_SIZE - 1));
+    size_t probes;
+
+    *slot = BINARYLOGGER_STRING_TABLE_SIZE;
+    for (probes = 0; probes < BINARYLOGGER_STRING_TABLE_SIZE; probes++)
+    {
+        if (binarylogger->strings[index].string == string)
+        {
+            result = binarylogger->strings[index].id;
+            break;
+        }
+        else if (binarylogger->strings[index].string == NULL)
+        {
+            *slot = index;
+            break;
+        }
+        index = (index + 1) & (BINARYLOGGER_STRING_TABLE_SIZE - 1);
+    }
+
+    return result;
+}
+
+static size_t string_record_size(BINARYLOGGER* binarylogger, const char* string)
+{
+    size_t result;
+    size_t slot;
+
+    if ((string == NULL) || (find_string(binarylogger, string, &slot) != 0))
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t length = strlen(string);
+        result = BINARYLOGGER_STRING_RECORD_SIZE((length > BINARYLOGGER_MAX_STRING_LENGTH) ? BINARYLOGGER_MAX_STRING_LENGTH : length);
+    }
+
+    return result;
+}
+
+/* returns the id of string, writing its string record first if it has none yet */
+static uint32_t record_string(BINARYLOGGER* binarylogger, const char* string)
+{
+    uint32_t result;
+    size_t slot;
+
+    if (string == NULL)
+    {
+        result = 0;
+    }
+    else if ((result = find_string(binarylogger, string, &slot)) == 0)
+    {
+        size_t length = strlen(string);
+        unsigned char* record = binarylogger->buffer + binarylogger->used;
+
+        if (length > BINARYLOGGER_MAX_STRING_LENGTH)
+        {
+            length = BINARYLOGGER_MAX_STRING_LENGTH;
+        }
+
+        result = binarylogger->next_string_id++;
+        /* once the table is full, the other strings are recorded each time they are used */
+        if (slot < BINARYLOGGER_STRING_TABLE_SIZE)
+        {
+            binarylogger->strings[slot].string = string;
+            binarylogger->strings[slot].id = result;
+            binarylogger->string_count++;
+        }
+
+        record[0] = BINARYLOGGER_RECORD_STRING;
+        put_u32(record + 1, result);
+        put_u16(record + 5, (uint16_t)length);
+        (void)memcpy(record + 7, string, length);
+        record[7 + length] = '\0';
+        binarylogger->used += BINARYLOGGER_STRING_RECORD_SIZE(length);
+    }
+
+    return result;
+}
+
+static int write_buffer(BINARYLOGGER* binarylogger)
+{
+    int result;
+
+    if ((binarylogger->used > 0) && (fwrite(binarylogger->buffer, 1, binarylogger->used, binarylogger->file) != binarylogger->used))
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        binarylogger->used = 0;
+        result = 0;
+    }
+
+    return result;
+}
+
+int binarylogger_init(size_t buffer_size, const char* file_path)
+{
+    int result;
+
+    if (g_binarylogger != NULL)
+    {
+        /*Codes_SRS_BINARYLOGGER_01_001: [ If the logger is already initialized, binarylogger_init shall fail and return a non-zero value. ]*/
+        LogError("binarylogger is already initialized");
+        result = __FAILURE__;
+    }
+    else
+    {
+        BINARYLOGGER* binarylogger;
+
+        /*Codes_SRS_BINARYLOGGER_01_002: [ binarylogger_init shall allocate a buffer of buffer_size bytes, 64 KB if buffer_size is 0, and create a spin lock. ]*/
+        if (buffer_size == 0)
+        {
+            buffer_size = BINARYLOGGER_DEFAULT_BUFFER_SIZE;
+        }
+
+        if (buffer_size < BINARYLOGGER_HEADER_SIZE)
+        {
+            /*Codes_SRS_BINARYLOGGER_01_003: [ If buffer_size is not 0 and smaller than the header of a stream, binarylogger_init shall fail and return a non-zero value. ]*/
+            LogError("invalid argument size_t buffer_size=%lu", (unsigned long)buffer_size);
+            result = __FAILURE__;
+        }
+        else if ((binarylogger = (BINARYLOGGER*)malloc(sizeof(BINARYLOGGER))) == NULL)
+        {
+            /*Codes_SRS_BINARYLOGGER_01_006: [ If any failure occurs, binarylogger_init shall free what it allocated and return a non-zero value. ]*/
+            LogError("failure in malloc(sizeof(BINARYLOGGER)=%lu)", (unsigned long)sizeof(BINARYLOGGER));
+            result = __FAILURE__;
+        }
+        else
+        {
+            if ((binarylogger->buffer = (unsigned char*)malloc(buffer_size)) == NULL)
+            {
+                /*Codes_SRS_BINARYLOGGER_01_006: [ If any failure occurs, binarylogger_init shall free what it allocated and return a non-zero value. ]*/
+                LogError("failure in malloc(%lu)", (unsigned long)buffer_size);
+                result = __FAILURE__;
+            }
+            else
+            {
+                if ((binarylogger->lock = SpinLock_Init()) == NULL)
+                {
+                    /*Codes_SRS_BINARYLOGGER_01_006: [ If any failure occurs, binarylogger_init shall free what it allocated and return a non-zero value. ]*/
+                    LogError("failure in SpinLock_Init");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    /*Codes_SRS_BINARYLOGGER_01_004: [ If file_path is not NULL, binarylogger_init shall open the file for writing. ]*/
+                    if ((file_path != NULL) && ((binarylogger->file = fopen(file_path, "wb")) == NULL))
+                    {
+                        /*Codes_SRS_BINARYLOGGER_01_006: [ If any failure occurs, binarylogger_init shall free what it allocated and return a non-zero value. ]*/
+                        LogError("failure opening %s", file_path);
+                        result = __FAILURE__;
+                    }
+                    else
+                    {
+                        /*Codes_SRS_BINARYLOGGER_01_005: [ binarylogger_init shall write the header of the stream to the buffer, reset the dropped count and return 0. ]*/
+                        if (file_path == NULL)
+                        {
+                            binarylogger->file = NULL;
+                        }
+                        binarylogger->buffer_size = buffer_size;
+                        binarylogger->buffer[0] = 'A';
+                        binarylogger->buffer[1] = 'Z';
+                        binarylogger->buffer[2] = 'B';
+                        binarylogger->buffer[3] = 'L';
+                        binarylogger->buffer[4] = BINARYLOGGER_VERSION;
+                        binarylogger->used = BINARYLOGGER_HEADER_SIZE;
+                        binarylogger->next_string_id = 1;
+                        binarylogger->string_count = 0;
+                        (void)memset(binarylogger->strings, 0, sizeof(binarylogger->strings));
+
+                        g_dropped_count = 0;
+                        g_binarylogger = binarylogger;
+                        result = 0;
+                        goto all_ok;
+                    }
+                    (void)SpinLock_Deinit(binarylogger->lock);
+                }
+                free(binarylogger->buffer);
+            }
+            free(binarylogger);
+        }
+    }
+
+all_ok:
+    return result;
+}
+
+void binarylogger_deinit(void)
+{
+    BINARYLOGGER* binarylogger = g_binarylogger;
+
+    if (binarylogger == NULL)
+    {
+        /*Codes_SRS_BINARYLOGGER_01_007: [ If the logger is not initialized, binarylogger_deinit shall return. ]*/
+        LogError("binarylogger is not initialized");
+    }
+    else
+    {
+        g_binarylogger = NULL;
+
+        /*Codes_SRS_BINARYLOGGER_01_008: [ If there is a file, binarylogger_deinit shall append the buffer to it and close it. ]*/
+        if (binarylogger->file != NULL)
+        {
+            if (write_buffer(binarylogger) != 0)
+            {
+                LogError("failure writing the log file");
+            }
+            (void)fclose(binarylogger->file);
+        }
+
+        /*Codes_SRS_BINARYLOGGER_01_009: [ binarylogger_deinit shall free the spin lock and the buffer. ]*/
+        (void)SpinLock_Deinit(binarylogger->lock);
+        free(binarylogger->buffer);
+        free(binarylogger);
+    }
+}
+
+int binarylogger_flush(void)
+{
+    int result;
+    BINARYLOGGER* binarylogger = g_binarylogger;
+
+    if (binarylogger == NULL)
+    {
+        /*Codes_SRS_BINARYLOGGER_01_010: [ If the logger is not initialized, binarylogger_flush shall fail and return a non-zero value. ]*/
+        LogError("binarylogger is not initialized");
+        result = __FAILURE__;
+    }
+    else if (binarylogger->file == NULL)
+    {
+        /*Codes_SRS_BINARYLOGGER_01_011: [ If there is no file, binarylogger_flush shall return 0. ]*/
+        result = 0;
+    }
+    else if (SpinLock_Lock(binarylogger->lock) != LOCK_OK)
+    {
+        /*Codes_SRS_BINARYLOGGER_01_013: [ If any failure occurs, binarylogger_flush shall return a non-zero value. ]*/
+        LogError("failure in SpinLock_Lock");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_BINARYLOGGER_01_012: [ binarylogger_flush shall append the buffer to the file, empty the buffer and return 0. ]*/
+        if ((write_buffer(binarylogger) != 0) || (fflush(binarylogger->file) != 0))
+        {
+            /*Codes_SRS_BINARYLOGGER_01_013: [ If any failure occurs, binarylogger_flush shall return a non-zero value. ]*/
+            LogError("failure writing the log file");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+        (void)SpinLock_Unlock(binarylogger->lock);
+    }
+
+    return result;
+}
+
+const unsigned char* binarylogger_get_buffer(size_t* size)
+{
+    const unsigned char* result;
+    BINARYLOGGER* binarylogger = g_binarylogger;
+
+    if ((binarylogger == NULL) || (size == NULL))
+    {
+        /*Codes_SRS_BINARYLOGGER_01_014: [ If the logger is not initialized or size is NULL, binarylogger_get_buffer shall return NULL. ]*/
+        LogError("invalid argument size_t* size=%p or binarylogger not initialized", size);
+        result = NULL;
+    }
+    else
+    {
+        /*Codes_SRS_BINARYLOGGER_01_015: [ binarylogger_get_buffer shall return the buffer and set size to the number of bytes it holds. ]*/
+        *size = binarylogger->used;
+        result = binarylogger->buffer;
+    }
+
+    return result;
+}
+
+size_t binarylogger_get_dropped_count(void)
+{
+    /*Codes_SRS_BINARYLOGGER_01_016: [ binarylogger_get_dropped_count shall return the number of lines dropped since binarylogger_init. ]*/
+    return (size_t)(unsigned long)BINARYLOGGER_ADD(g_dropped_count, 0);
+}
+
+void binarylogger_log(LOG_CATEGORY log_category, const char* file, const char* func, int line, unsigned int options, const char* format, ...)
+{
+    BINARYLOGGER* binarylogger = g_binarylogger;
+
+    if ((binarylogger == NULL) || (format == NULL))
+    {
+        /*Codes_SRS_BINARYLOGGER_01_017: [ If the logger is not initialized or format is NULL, binarylogger_log shall drop the line and count it. ]*/
+        (void)BINARYLOGGER_ADD(g_dropped_count, 1);
+    }
+    else
+    {
+        unsigned char arguments[BINARYLOGGER_MAX_ARGUMENTS_SIZE];
+        size_t arguments_size;
+        va_list args;
+
+        /*Codes_SRS_BINARYLOGGER_01_018: [ binarylogger_log shall record the arguments that the conversions of format consume, without formatting them, copying the strings of %s conversions up to their precision. ]*/
+        va_start(args, format);
+        arguments_size = encode_arguments(arguments, format, &args);
+        va_end(args);
+
+        if (SpinLock_Lock(binarylogger->lock) != LOCK_OK)
+        {
+            (void)BINARYLOGGER_ADD(g_dropped_count, 1);
+        }
+        else
+        {
+            size_t size = string_record_size(binarylogger, file) + string_record_size(binarylogger, func) + string_record_size(binarylogger, format) + BINARYLOGGER_LINE_RECORD_SIZE(arguments_size);
+
+            /*Codes_SRS_BINARYLOGGER_01_020: [ If the record does not fit in the buffer and there is a file, binarylogger_log shall append the buffer to the file and empty it first. ]*/
+            if ((binarylogger->used + size > binarylogger->buffer_size) && (binarylogger->file != NULL))
+            {
+                (void)write_buffer(binarylogger);
+            }
+
+            if (binarylogger->used + size > binarylogger->buffer_size)
+            {
+                /*Codes_SRS_BINARYLOGGER_01_021: [ If the record does not fit in the buffer, binarylogger_log shall drop the line and count it. ]*/
+                (void)BINARYLOGGER_ADD(g_dropped_count, 1);
+            }
+            else
+            {
+                /*Codes_SRS_BINARYLOGGER_01_019: [ binarylogger_log shall record file, func and format once per stream, as string records giving them an id, and refer to them by id in the line record. ]*/
+                uint32_t file_id = record_string(binarylogger, file);
+                uint32_t func_id = record_string(binarylogger, func);
+                uint32_t format_id = record_string(binarylogger, format);
+                unsigned char* record = binarylogger->buffer + binarylogger->used;
+
+                record[0] = BINARYLOGGER_RECORD_LINE;
+                record[1] = (unsigned char)log_category;
+                record[2] = (unsigned char)options;
+                put_u32(record + 3, (uint32_t)line);
+                put_u32(record + 7, file_id);
+                put_u32(record + 11, func_id);
+                put_u32(record + 15, format_id);
+                put_u16(record + 19, (uint16_t)arguments_size);
+                (void)memcpy(record + 21, arguments, arguments_size);
+                binarylogger->used += BINARYLOGGER_LINE_RECORD_SIZE(arguments_size);
+            }
+
+            (void)SpinLock_Unlock(binarylogger->lock);
+        }
+    }
+}
+
+/* decoding */
+
+typedef struct DECODED_ARGUMENTS_TAG
+{
+    const unsigned char* position;
+    const unsigned char* end;
+} DECODED_ARGUMENTS;
+
+/* returns 0 if the next argument is missing or is not a tag argument */
+static int next_argument(DECODED_ARGUMENTS* arguments, char tag, uint64_t* value, const char** string)
+{
+    int result;
+
+    if ((arguments->position == arguments->end) || (*arguments->position != (unsigned char)tag))
+    {
+        result = 0;
+    }
+    else if (tag == BINARYLOGGER_ARGUMENT_STRING)
+    {
+        size_t length;
+        if ((arguments->end - arguments->position < 1 + 2) ||
+            ((size_t)(arguments->end - arguments->position) < (size_t)1 + 2 + (length = get_u16(arguments->position + 1)) + 1) ||
+            (arguments->position[3 + length] != '\0'))
+        {
+            result = 0;
+        }
+        else
+        {
+            *string = (const char*)arguments->position + 3;
+            arguments->position += 1 + 2 + length + 1;
+            result = 1;
+        }
+    }
+    else if (arguments->end - arguments->position < 1 + 8)
+    {
+        result = 0;
+    }
+    else
+    {
+        *value = get_u64(arguments->position + 1);
+        arguments->position += 1 + 8;
+        result = 1;
+    }
+
+    return result;
+}
+
+static void append_text(char* message, size_t* message_length, const char* text, size_t text_length)
+{
+    size_t space = BINARYLOGGER_MAX_MESSAGE_SIZE - 1 - *message_length;
+    if (text_length > space)
+    {
+        text_length = space;
+    }
+    (void)memcpy(message + *message_length, text, text_length);
+    *message_length += text_length;
+    message[*message_length] = '\0';
+}
+
+static void append_formatted(size_t* message_length, int formatted_length)
+{
+    if (formatted_length > 0)
+    {
+        *message_length += (size_t)formatted_length;
+        if (*message_length > BINARYLOGGER_MAX_MESSAGE_SIZE - 1)
+        {
+            /*truncated by snprintf*/
+            *message_length = BINARYLOGGER_MAX_MESSAGE_SIZE - 1;
+        }
+    }
+}
+
+/* builds "%<flags><width><precision><modifier><specifier>" with the '*' replaced by their argument, returns 0 on failure */
+static int build_specification(char* specification, const CONVERSION* conversion, DECODED_ARGUMENTS* arguments, const char* modifier, char specifier)
+{
+    int result;
+    uint64_t width = 0;
+    uint64_t precision = 0;
+    const char* unused;
+
+    if ((conversion->flags_length + conversion->width_length + conversion->precision_length + 40 > BINARYLOGGER_MAX_SPECIFICATION_SIZE) ||
+        (conversion->width_is_argument && !next_argument(arguments, BINARYLOGGER_ARGUMENT_SIGNED, &width, &unused)) ||
+        (conversion->precision_is_argument && !next_argument(arguments, BINARYLOGGER_ARGUMENT_SIGNED, &precision, &unused)))
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t length = 0;
+
+        specification[length++] = '%';
+        (void)memcpy(specification + length, conversion->flags, conversion->flags_length);
+        length += conversion->flags_length;
+        if (conversion->width_is_argument)
+        {
+            length += (size_t)sprintf(specification + length, "%d", (int)(int64_t)width);
+        }
+        else
+        {
+            (void)memcpy(specification + length, conversion->width, conversion->width_length);
+            length += conversion->width_length;
+        }
+        if (conversion->has_precision)
+        {
+            specification[length++] = '.';
+            if (conversion->precision_is_argument)
+            {
+                length += (size_t)sprintf(specification + length, "%d", (int)(int64_t)precision);
+            }
+            else
+            {
+                (void)memcpy(specification + length, conversion->precision, conversion->precision_length);
+                length += conversion->precision_length;
+            }
+        }
+        (void)strcpy(specification + length, modifier);
+        length += strlen(modifier);
+        specification[length++] = specifier;
+        specification[length] = '\0';
+        result = 1;
+    }
+
+    return result;
+}
+
+static void format_line(char* message, const char* format, DECODED_ARGUMENTS* arguments)
+{
+    size_t message_length = 0;
+    int complete = 0;
+
+    message[0] = '\0';
+    while (!complete)
+    {
+        const char* percent = strchr(format, '%');
+
+        if (percent == NULL)
+        {
+            append_text(message, &message_length, format, strlen(format));
+            complete = 1;
+        }
+        else
+        {
+            CONVERSION conversion;
+            char specification[BINARYLOGGER_MAX_SPECIFICATION_SIZE];
+            char* destination;
+            size_t space;
+            const char* next;
+            uint64_t value = 0;
+            const char* string = NULL;
+            int ok;
+
+            append_text(message, &message_length, format, (size_t)(percent - format));
+            next = parse_conversion(percent + 1, &conversion);
+            destination = message + message_length;
+            space = BINARYLOGGER_MAX_MESSAGE_SIZE - message_length;
+
+            switch (conversion.specifier)
+            {
+            case 'd':
+            case 'i':
+            case 'c':
+                ok = build_specification(specification, &conversion, arguments, (conversion.specifier == 'c') ? "" : "ll", conversion.specifier) &&
+                    next_argument(arguments, BINARYLOGGER_ARGUMENT_SIGNED, &value, &string);
+                if (ok)
+                {
+                    if (conversion.specifier == 'c')
+                    {
+                        append_formatted(&message_length, snprintf(destination, space, specification, (int)(int64_t)value));
+                    }
+                    else
+                    {
+                        append_formatted(&message_length, snprintf(destination, space, specification, (long long)(int64_t)value));
+                    }
+                }
+                break;
+            case 'u':
+            case 'o':
+            case 'x':
+            case 'X':
+                ok = build_specification(specification, &conversion, arguments, "ll", conversion.specifier) &&
+                    next_argument(arguments, BINARYLOGGER_ARGUMENT_UNSIGNED, &value, &string);
+                if (ok)
+                {
+                    append_formatted(&message_length, snprintf(destination, space, specification, (unsigned long long)value));
+                }
+                break;
+            case 'e':
+            case 'E':
+            case 'f':
+            case 'F':
+            case 'g':
+            case 'G':
+            case 'a':
+            case 'A':
+                ok = build_specification(specification, &conversion, arguments, "", conversion.specifier) &&
+                    next_argument(arguments, BINARYLOGGER_ARGUMENT_DOUBLE, &value, &string);
+                if (ok)
+                {
+                    double number;
+                    (void)memcpy(&number, &value, sizeof(number));
+                    append_formatted(&message_length, snprintf(destination, space, specification, number));
+                }
+                break;
+            case 's':
+                ok = build_specification(specification, &conversion, arguments, "", 's') &&
+                    next_argument(arguments, BINARYLOGGER_ARGUMENT_STRING, &value, &string);
+                if (ok)
+                {
+                    append_formatted(&message_length, snprintf(destination, space, specification, string));
+                }
+                break;
+            case 'p':
+                /* the pointer is the one of the process that logged, possibly of another size */
+                ok = build_specification(specification, &conversion, arguments, "ll", 'x') &&
+                    next_argument(arguments, BINARYLOGGER_ARGUMENT_POINTER, &value, &string);
+                if (ok)
+                {
+                    append_text(message, &message_length, "0x", 2);
+                    destination = message + message_length;
+                    space = BINARYLOGGER_MAX_MESSAGE_SIZE - message_length;
+                    append_formatted(&message_length, snprintf(destination, space, specification, (unsigned long long)value));
+                }
+                break;
+            case 'n':
+                ok = 1;
+                break;
+            case '%':
+                append_text(message, &message_length, "%", 1);
+                ok = 1;
+                break;
+            default:
+                ok = 0;
+                break;
+            }
+
+            if (!ok)
+            {
+                /* the arguments were not recorded from here on, the rest is shown as it is */
+                append_text(message, &message_length, percent, strlen(percent));
+                complete = 1;
+            }
+            else
+            {
+                format = next;
+            }
+        }
+    }
+}
+
+typedef struct DECODED_STRING_TAG
+{
+    const char* string;
+} DECODED_STRING;
+
+static int get_decoded_string(const DECODED_STRING* strings, size_t string_count, uint32_t id, const char** string)
+{
+    int result;
+
+    if (id == 0)
+    {
+        *string = NULL;
+        result = 1;
+    }
+    else if (id > string_count)
+    {
+        result = 0;
+    }
+    else
+    {
+        *string = strings[id - 1].string;
+        result = 1;
+    }
+
+    return result;
+}
+
+int binarylogger_decode(const unsigned char* data, size_t size, ON_BINARYLOGGER_LINE on_line, void* context)
+{
+    int result;
+
+    if ((data == NULL) || (on_line == NULL))
+    {
+        /*Codes_SRS_BINARYLOGGER_01_022: [ If data or on_line is NULL, binarylogger_decode shall fail and return a non-zero value. ]*/
+        LogError("invalid argument const unsigned char* data=%p, ON_BINARYLOGGER_LINE on_line=%p", data, on_line);
+        result = __FAILURE__;
+    }
+    else if ((size < BINARYLOGGER_HEADER_SIZE) || (data[0] != 'A') || (data[1] != 'Z') || (data[2] != 'B') || (data[3] != 'L') || (data[4] != BINARYLOGGER_VERSION))
+    {
+        /*Codes_SRS_BINARYLOGGER_01_023: [ If data does not start with the header of a stream, binarylogger_decode shall fail and return a non-zero value. ]*/
+        LogError("not a binarylogger stream");
+        result = __FAILURE__;
+    }
+    else
+    {
+        DECODED_STRING* strings = NULL;
+        size_t string_count = 0;
+        size_t string_capacity = 0;
+        size_t position = BINARYLOGGER_HEADER_SIZE;
+        char* message = (char*)malloc(BINARYLOGGER_MAX_MESSAGE_SIZE);
+
+        if (message == NULL)
+        {
+            /*Codes_SRS_BINARYLOGGER_01_026: [ If any failure occurs, binarylogger_decode shall return a non-zero value. ]*/
+            LogError("failure in malloc(%d)", BINARYLOGGER_MAX_MESSAGE_SIZE);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+
+            while ((result == 0) && (position < size))
+            {
+                const unsigned char* record = data + position;
+                size_t left = size - position;
+
+                if ((record[0] == BINARYLOGGER_RECORD_STRING) && (left >= BINARYLOGGER_STRING_RECORD_SIZE(0)))
+                {
+                    uint32_t id = get_u32(record + 1);
+                    size_t length = get_u16(record + 5);
+
+                    if ((left < BINARYLOGGER_STRING_RECORD_SIZE(length)) || (record[7 + length] != '\0') || (id != string_count + 1))
+                    {
+                        /*Codes_SRS_BINARYLOGGER_01_025: [ If a record is truncated, unknown or refers to a string that was not recorded before, binarylogger_decode shall fail and return a non-zero value. ]*/
+                        LogError("corrupt string record at offset %lu", (unsigned long)position);
+                        result = __FAILURE__;
+                    }
+                    else
+                    {
+                        if (string_count == string_capacity)
+                        {
+                            size_t new_capacity = (string_capacity == 0) ? 64 : string_capacity * 2;
+                            DECODED_STRING* new_strings = (DECODED_STRING*)realloc(strings, new_capacity * sizeof(DECODED_STRING));
+                            if (new_strings == NULL)
+                            {
+                                /*Codes_SRS_BINARYLOGGER_01_026: [ If any failure occurs, binarylogger_decode shall return a non-zero value. ]*/
+                                LogError("failure growing the string table");
+                                result = __FAILURE__;
+                            }
+                            else
+                            {
+                                strings = new_strings;
+                                string_capacity = new_capacity;
+                            }
+                        }
+
+                        if (result == 0)
+                        {
+                            strings[string_count].string = (const char*)record + 7;
+                            string_count++;
+                            position += BINARYLOGGER_STRING_RECORD_SIZE(length);
+                        }
+                    }
+                }
+                else if ((record[0] == BINARYLOGGER_RECORD_LINE) && (left >= BINARYLOGGER_LINE_RECORD_SIZE(0)))
+                {
+                    size_t arguments_size = get_u16(record + 19);
+                    const char* file;
+                    const char* func;
+                    const char* format;
+
+                    if ((left < BINARYLOGGER_LINE_RECORD_SIZE(arguments_size)) ||
+                        !get_decoded_string(strings, string_count, get_u32(record + 7), &file) ||
+                        !get_decoded_string(strings, string_count, get_u32(record + 11), &func) ||
+                        !get_decoded_string(strings, string_count, get_u32(record + 15), &format) ||
+                        (format == NULL))
+                    {
+                        /*Codes_SRS_BINARYLOGGER_01_025: [ If a record is truncated, unknown or refers to a string that was not recorded before, binarylogger_decode shall fail and return a non-zero value. ]*/
+                        LogError("corrupt line record at offset %lu", (unsigned long)position);
+                        result = __FAILURE__;
+                    }
+                    else
+                    {
+                        DECODED_ARGUMENTS arguments;
+                        arguments.position = record + 21;
+                        arguments.end = arguments.position + arguments_size;
+
+                        /*Codes_SRS_BINARYLOGGER_01_024: [ binarylogger_decode shall format each line record with its format string and arguments and call on_line with context, its category, file, function, line, options and the formatted line. ]*/
+                        format_line(message, format, &arguments);
+                        on_line(context, (LOG_CATEGORY)record[1], file, func, (int)(int32_t)get_u32(record + 3), record[2], message);
+                        position += BINARYLOGGER_LINE_RECORD_SIZE(arguments_size);
+                    }
+                }
+                else
+                {
+                    /*Codes_SRS_BINARYLOGGER_01_025: [ If a record is truncated, unknown or refers to a string that was not recorded before, binarylogger_decode shall fail and return a non-zero value. ]*/
+                    LogError("corrupt record at offset %lu", (unsigned long)position);
+                    result = __FAILURE__;
+                }
+            }
+
+            free(message);
+        }
+
+        free(strings);
+    }
+
+    return result;
+}
@@ -9,22 +9,243 @@
 #include "azure_c_shared_utility/buffer_.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
+#ifdef USE_OBJECT_POOLS
+#include "azure_c_shared_utility/object_pool.h"
+#endif
+
+#if defined(USE_OBJECT_POOLS) && !defined(BUFFER_INLINE_CAPACITY)
+#define BUFFER_INLINE_CAPACITY 64
+#endif
 
 typedef struct BUFFER_TAG
 {
     unsigned char* buffer;
     size_t size;
+    /* number of bytes allocated from buffer on, never less than size */
+    size_t capacity;
+    /* number of bytes allocated before buffer, so that prepending does not move the content. 0 when buffer is NULL */
+    size_t headroom;
+#ifdef USE_OBJECT_POOLS
+    /* buffers of up to BUFFER_INLINE_CAPACITY bytes live here, so that they need no allocation of their own */
+    unsigned char inline_buffer[BUFFER_INLINE_CAPACITY];
+#endif
 } BUFFER;
 
+#ifdef USE_OBJECT_POOLS
+/*the number of BUFFER control blocks when built with OBJECT_POOL_STATIC*/
+#ifndef BUFFER_POOL_COUNT
+#define BUFFER_POOL_COUNT 32
+#endif
+OBJECT_POOL_DEFINE_STATIC(buffer_pool, sizeof(BUFFER), BUFFER_POOL_COUNT);
+#endif
+
+#if defined(USE_OBJECT_POOLS) && defined(OBJECT_POOL_STATIC)
+/* Codes_SRS_BUFFER_01_031: [ When built with OBJECT_POOL_STATIC, the buffers that do not fit in the BUFFER control block shall be allocated from the payload pools of object_pool. ] */
+#define BUFFER_memory_malloc(size) object_pool_payload_alloc(size)
+/* memory handed over by the caller stays on the heap */
+#define BUFFER_memory_realloc(ptr, size) ((((ptr) == NULL) || object_pool_is_payload(ptr)) ? object_pool_payload_realloc(ptr, size) : realloc(ptr, size))
+#define BUFFER_memory_is_payload(ptr) object_pool_is_payload(ptr)
+#define BUFFER_memory_free(ptr, size) (object_pool_is_payload(ptr) ? object_pool_payload_free(ptr) : GBALLOC_FREE_SIZED(ptr, size))
+#else
+#define BUFFER_memory_malloc(size) malloc(size)
+#define BUFFER_memory_realloc(ptr, size) realloc(ptr, size)
+#define BUFFER_memory_is_payload(ptr) 0
+#define BUFFER_memory_free(ptr, size) GBALLOC_FREE_SIZED(ptr, size)
+#endif
+
+static BUFFER* BUFFER_alloc_handle(void)
+{
+    BUFFER* result;
+#ifdef USE_OBJECT_POOLS
+    /* Codes_SRS_BUFFER_01_013: [ When built with USE_OBJECT_POOLS, the BUFFER control blocks shall be recycled through an object pool. ] */
+    result = (BUFFER*)object_pool_alloc(&buffer_pool);
+#else
+    result = (BUFFER*)malloc(sizeof(BUFFER));
+#endif
+    if (result != NULL)
+    {
+        result->buffer = NULL;
+        result->headroom = 0;
+    }
+    return result;
+}
+
+/* start of the allocation that holds the headroom and the content */
+static unsigned char* BUFFER_storage(const BUFFER* b)
+{
+    return (b->buffer == NULL) ? NULL : (b->buffer - b->headroom);
+}
+
+static void BUFFER_free_handle(BUFFER* b)
+{
+#ifdef USE_OBJECT_POOLS
+    object_pool_free(&buffer_pool, b);
+#else
+    GBALLOC_FREE_SIZED(b, sizeof(BUFFER));
+#endif
+}
+
+/* allocates size bytes that do not replace b->buffer yet, b->buffer is still valid until it is freed */
+static unsigned char* BUFFER_alloc_value(BUFFER* b, size_t size)
+{
+    unsigned char* result;
+#ifdef USE_OBJECT_POOLS
+    /* Codes_SRS_BUFFER_01_014: [ When built with USE_OBJECT_POOLS, buffers of up to BUFFER_INLINE_CAPACITY bytes shall be stored in the BUFFER control block. ] */
+    if ((size <= BUFFER_INLINE_CAPACITY) && (BUFFER_storage(b) != b->inline_buffer))
+    {
+        result = b->inline_buffer;
+    }
+    else
+#endif
+    {
+        (void)b;
+        result = (unsigned char*)BUFFER_memory_malloc(size);
+    }
+    return result;
+}
+
+/* same contract as realloc(b->buffer, size), the headroom being kept in front: on failure b->buffer is left untouched */
+static unsigned char* BUFFER_realloc_value(BUFFER* b, size_t size)
+{
+    unsigned char* result;
+    unsigned char* storage = BUFFER_storage(b);
+    size_t storage_size = b->headroom + size;
+    if (storage_size < size)
+    {
+        LogError("Buffer size overflows with a headroom of %lu bytes", (unsigned long)b->headroom);
+        result = NULL;
+    }
+    else
+    {
+#ifdef USE_OBJECT_POOLS
+        if (((storage == NULL) || (storage == b->inline_buffer)) && (storage_size <= BUFFER_INLINE_CAPACITY))
+        {
+            result = b->inline_buffer;
+        }
+        else if (storage == b->inline_buffer)
+        {
+            /* the content outgrows the inline storage and moves to the heap */
+            result = (unsigned char*)BUFFER_memory_malloc(storage_size);
+            if (result != NULL)
+            {
+                (void)memcpy(result, b->inline_buffer, b->headroom + b->capacity);
+            }
+        }
+        else
+#endif
+        {
+            result = (unsigned char*)BUFFER_memory_realloc(storage, storage_size);
+        }
+
+        if (result != NULL)
+        {
+            result += b->headroom;
+        }
+    }
+    return result;
+}
+
+static void BUFFER_free_value(BUFFER* b)
+{
+    unsigned char* storage = BUFFER_storage(b);
+#ifdef USE_OBJECT_POOLS
+    if (storage != b->inline_buffer)
+#endif
+    {
+        /* the headroom and the capacity are what was allocated */
+        BUFFER_memory_free(storage, b->headroom + b->capacity);
+    }
+    b->headroom = 0;
+}
+
+/* Makes room for at least required bytes. The capacity at least doubles, so that appending in a loop is amortized O(1). */
+static int BUFFER_ensure_capacity(BUFFER* b, size_t required)
+{
+    int result;
+    if (required <= b->capacity)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t new_capacity = (b->capacity > ((size_t)~(size_t)0) / 2) ? required : (b->capacity * 2);
+        unsigned char* temp;
+        if (new_capacity < required)
+        {
+            new_capacity = required;
+        }
+
+        temp = BUFFER_realloc_value(b, new_capacity);
+        if (temp == NULL)
+        {
+            LogError("Failure reallocating buffer to %lu bytes", (unsigned long)new_capacity);
+            result = __FAILURE__;
+        }
+        else
+        {
+            b->buffer = temp;
+            b->capacity = new_capacity;
+            result = 0;
+        }
+    }
+    return result;
+}
+
+/* Makes room for at least required bytes before the content. Another b->size bytes are kept free, so that prepending in a loop is amortized O(1). */
+static int BUFFER_ensure_headroom(BUFFER* b, size_t required)
+{
+    int result;
+    if (required <= b->headroom)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t new_headroom = required + b->size;
+        unsigned char* temp;
+        if (new_headroom < required)
+        {
+            new_headroom = required;
+        }
+
+        if (new_headroom + b->capacity < new_headroom)
+        {
+            LogError("Headroom of %lu bytes is too large", (unsigned long)new_headroom);
+            result = __FAILURE__;
+        }
+        else if ((temp = BUFFER_alloc_value(b, new_headroom + b->capacity)) == NULL)
+        {
+            LogError("Failure allocating a headroom of %lu bytes", (unsigned long)new_headroom);
+            result = __FAILURE__;
+        }
+        else
+        {
+            if (b->size > 0)
+            {
+                (void)memcpy(temp + new_headroom, b->buffer, b->size);
+            }
+            if (b->buffer != NULL)
+            {
+                BUFFER_free_value(b);
+            }
+            b->buffer = temp + new_headroom;
+            b->headroom = new_headroom;
+            result = 0;
+        }
+    }
+    return result;
+}
+
 /* Codes_SRS_BUFFER_07_001: [BUFFER_new shall allocate a BUFFER_HANDLE that will contain a NULL unsigned char*.] */
 BUFFER_HANDLE BUFFER_new(void)
 {
-    BUFFER* temp = (BUFFER*)malloc(sizeof(BUFFER));
+    BUFFER* temp = BUFFER_alloc_handle();
     /* Codes_SRS_BUFFER_07_002: [BUFFER_new shall return NULL on any error that occurs.] */
     if (temp != NULL)
     {
         temp->buffer = NULL;
         temp->size = 0;
+        temp->capacity = 0;
     }
     return (BUFFER_HANDLE)temp;
 }
@@ -37,7 +258,7 @@ static int BUFFER_safemalloc(BUFFER* handleptr, size_t size)
     {
         sizetomalloc = 1;
     }
-    handleptr->buffer = (unsigned char*)malloc(sizetomalloc);
+    handleptr->buffer = BUFFER_alloc_value(handleptr, sizetomalloc);
     if (handleptr->buffer == NULL)
     {
         /*Codes_SRS_BUFFER_02_003: [If allocating memory fails, then BUFFER_create shall return NULL.]*/
@@ -48,6 +269,7 @@ static int BUFFER_safemalloc(BUFFER* handleptr, size_t size)
     {
         // we still consider the real buffer size is 0
         handleptr->size = size;
+        handleptr->capacity = sizetomalloc;
         result = 0;
     }
     return result;
@@ -65,7 +287,7 @@ BUFFER_HANDLE BUFFER_create(const unsigned char* source, size_t size)
     else
     {
         /*Codes_SRS_BUFFER_02_002: [Otherwise, BUFFER_create shall allocate memory to hold size bytes and shall copy from source size bytes into the newly allocated memory.] */
-        result = (BUFFER*)malloc(sizeof(BUFFER));
+        result = BUFFER_alloc_handle();
         if (result == NULL)
         {
             /*Codes_SRS_BUFFER_02_003: [If allocating memory fails, then BUFFER_create shall return NULL.] */
@@ -78,7 +300,7 @@ BUFFER_HANDLE BUFFER_create(const unsigned char* source, size_t size)
             if (BUFFER_safemalloc(result, size) != 0)
             {
                 LogError("unable to BUFFER_safemalloc ");
-                free(result);
+                BUFFER_free_handle(result);
                 result = NULL;
             }
             else
@@ -95,24 +317,26 @@ BUFFER_HANDLE BUFFER_create(const unsigned char* source, size_t size)
 BUFFER_HANDLE BUFFER_create_with_size(size_t buff_size)
 {
     BUFFER* result;
-    result = (BUFFER*)malloc(sizeof(BUFFER));
+    result = BUFFER_alloc_handle();
     if (result != NULL)
     {
         if (buff_size == 0)
         {
             // Codes_SRS_BUFFER_07_030: [ If buff_size is 0 BUFFER_create_with_size shall create a valid non-NULL handle of zero size. ]
             result->size = 0;
+            result->capacity = 0;
             result->buffer = NULL;
         }
         else
         {
             // Codes_SRS_BUFFER_07_031: [ BUFFER_create_with_size shall allocate a buffer of buff_size. ]
             result->size = buff_size;
-            if ((result->buffer = (unsigned char*)malloc(result->size)) == NULL)
+            result->capacity = buff_size;
+            if ((result->buffer = BUFFER_alloc_value(result, result->size)) == NULL)
             {
                 // Codes_SRS_BUFFER_07_032: [ If allocating memory fails, then BUFFER_create_with_size shall return NULL. ]
                 LogError("unable to allocate buffer");
-                free(result);
+                BUFFER_free_handle(result);
                 result = NULL;
             }
         }
@@ -136,9 +360,9 @@ void BUFFER_delete(BUFFER_HANDLE handle)
         if (b->buffer != NULL)
         {
             /* Codes_SRS_BUFFER_07_003: [BUFFER_delete shall delete the data associated with the BUFFER_HANDLE along with the Buffer.] */
-            free(b->buffer);
+            BUFFER_free_value(b);
         }
-        free(b);
+        BUFFER_free_handle(b);
     }
 }
 
@@ -158,9 +382,10 @@ int BUFFER_build(BUFFER_HANDLE handle, const unsigned char* source, size_t size)
     {
         /* Codes_SRS_BUFFER_01_003: [If size is zero, source can be NULL.] */
         BUFFER* b = (BUFFER*)handle;
-        free(b->buffer);
+        BUFFER_free_value(b);
         b->buffer = NULL;
         b->size = 0;
+        b->capacity = 0;
 
         result = 0;
     }
@@ -175,7 +400,7 @@ int BUFFER_build(BUFFER_HANDLE handle, const unsigned char* source, size_t size)
         {
             BUFFER* b = (BUFFER*)handle;
             /* Codes_SRS_BUFFER_07_011: [BUFFER_build shall overwrite previous contents if the buffer has been previously allocated.] */
-            unsigned char* newBuffer = (unsigned char*)realloc(b->buffer, size);
+            unsigned char* newBuffer = BUFFER_realloc_value(b, size);
             if (newBuffer == NULL)
             {
                 /* Codes_SRS_BUFFER_07_010: [BUFFER_build shall return nonzero if any error is encountered.] */
@@ -186,6 +411,7 @@ int BUFFER_build(BUFFER_HANDLE handle, const unsigned char* source, size_t size)
             {
                 b->buffer = newBuffer;
                 b->size = size;
+                b->capacity = size;
                 /* Codes_SRS_BUFFER_01_002: [The size argument can be zero, in which case nothing shall be copied from source.] */
                 (void)memcpy(b->buffer, source, size);
 
@@ -228,8 +454,9 @@ int BUFFER_append_build(BUFFER_HANDLE handle, const unsigned char* source, size_
         else
         {
             /* Codes_SRS_BUFFER_07_032: [ if handle->buffer is not NULL BUFFER_append_build shall realloc the buffer to be the handle->size + size ] */
-            unsigned char* temp = (unsigned char*)realloc(handle->buffer, handle->size + size);
-            if (temp == NULL)
+            /* Codes_SRS_BUFFER_01_006: [ If the capacity is not enough, BUFFER_append_build, BUFFER_enlarge and BUFFER_append shall grow the capacity to the larger of the required size and twice the current capacity. ] */
+            if ((handle->size + size < size) ||
+                (BUFFER_ensure_capacity(handle, handle->size + size) != 0))
             {
                 /* Codes_SRS_BUFFER_07_035: [ If any error is encountered BUFFER_append_build shall return a non-null value. ] */
                 LogError("Failure reallocating temporary buffer");
@@ -238,7 +465,6 @@ int BUFFER_append_build(BUFFER_HANDLE handle, const unsigned char* source, size_
             else
             {
                 /* Codes_SRS_BUFFER_07_033: [ ... and copy the contents of source to the end of the buffer. ] */
-                handle->buffer = temp;
                 // Append the BUFFER
                 (void)memcpy(&handle->buffer[handle->size], source, size);
                 handle->size += size;
@@ -277,7 +503,7 @@ int BUFFER_pre_build(BUFFER_HANDLE handle, size_t size)
         }
         else
         {
-            if ((b->buffer = (unsigned char*)malloc(size)) == NULL)
+            if ((b->buffer = BUFFER_alloc_value(b, size)) == NULL)
             {
                 /* Codes_SRS_BUFFER_07_013: [BUFFER_pre_build shall return nonzero if any error is encountered.] */
                 LogError("Failure allocating buffer");
@@ -286,6 +512,7 @@ int BUFFER_pre_build(BUFFER_HANDLE handle, size_t size)
             else
             {
                 b->size = size;
+                b->capacity = size;
                 result = 0;
             }
         }
@@ -327,9 +554,10 @@ extern int BUFFER_unbuild(BUFFER_HANDLE handle)
         if (b->buffer != NULL)
         {
             LogError("Failure buffer data is NULL");
-            free(b->buffer);
+            BUFFER_free_value(b);
             b->buffer = NULL;
             b->size = 0;
+            b->capacity = 0;
             result = 0;
         }
         else
@@ -360,8 +588,9 @@ int BUFFER_enlarge(BUFFER_HANDLE handle, size_t enlargeSize)
     else
     {
         BUFFER* b = (BUFFER*)handle;
-        unsigned char* temp = (unsigned char*)realloc(b->buffer, b->size + enlargeSize);
-        if (temp == NULL)
+        /* Codes_SRS_BUFFER_01_006: [ If the capacity is not enough, BUFFER_append_build, BUFFER_enlarge and BUFFER_append shall grow the capacity to the larger of the required size and twice the current capacity. ] */
+        if ((b->size + enlargeSize < enlargeSize) ||
+            (BUFFER_ensure_capacity(b, b->size + enlargeSize) != 0))
         {
             /* Codes_SRS_BUFFER_07_018: [BUFFER_enlarge shall return a nonzero result if any error is encountered.] */
             LogError("Failure: allocating temp buffer.");
@@ -369,7 +598,6 @@ int BUFFER_enlarge(BUFFER_HANDLE handle, size_t enlargeSize)
         }
         else
         {
-            b->buffer = temp;
             b->size += enlargeSize;
             result = 0;
         }
@@ -405,14 +633,25 @@ int BUFFER_shrink(BUFFER_HANDLE handle, size_t decreaseSize, bool fromEnd)
         if (alloc_size == 0)
         {
             /* Codes_SRS_BUFFER_07_043: [ If the decreaseSize is equal the buffer size , BUFFER_shrink shall deallocate the buffer and set the size to zero. ] */
-            free(handle->buffer);
+            BUFFER_free_value(handle);
             handle->buffer = NULL;
             handle->size = 0;
+            handle->capacity = 0;
+            result = 0;
+        }
+        else if (!fromEnd)
+        {
+            /* Codes_SRS_BUFFER_07_041: [ if the fromEnd variable is false, BUFFER_shrink shall remove the beginning of the buffer of size decreaseSize. ] */
+            /* Codes_SRS_BUFFER_01_019: [ When removing the beginning of the buffer, BUFFER_shrink shall turn the removed bytes into headroom, without allocating or moving the content. ] */
+            handle->buffer += decreaseSize;
+            handle->headroom += decreaseSize;
+            handle->size = alloc_size;
+            handle->capacity -= decreaseSize;
             result = 0;
         }
         else
         {
-            unsigned char* tmp = malloc(alloc_size);
+            unsigned char* tmp = BUFFER_alloc_value(handle, alloc_size);
             if (tmp == NULL)
             {
                 /* Codes_SRS_BUFFER_07_042: [ If a failure is encountered, BUFFER_shrink shall return a non-null value ] */
@@ -421,24 +660,13 @@ int BUFFER_shrink(BUFFER_HANDLE handle, size_t decreaseSize, bool fromEnd)
             }
             else
             {
-                if (fromEnd)
-                {
-                    /* Codes_SRS_BUFFER_07_040: [ if the fromEnd variable is true, BUFFER_shrink shall remove the end of the buffer of size decreaseSize. ] */
-                    memcpy(tmp, handle->buffer, alloc_size);
-                    free(handle->buffer);
-                    handle->buffer = tmp;
-                    handle->size = alloc_size;
-                    result = 0;
-                }
-                else
-                {
-                    /* Codes_SRS_BUFFER_07_041: [ if the fromEnd variable is false, BUFFER_shrink shall remove the beginning of the buffer of size decreaseSize. ] */
-                    memcpy(tmp, handle->buffer + decreaseSize, alloc_size);
-                    free(handle->buffer);
-                    handle->buffer = tmp;
-                    handle->size = alloc_size;
-                    result = 0;
-                }
+                /* Codes_SRS_BUFFER_07_040: [ if the fromEnd variable is true, BUFFER_shrink shall remove the end of the buffer of size decreaseSize. ] */
+                memcpy(tmp, handle->buffer, alloc_size);
+                BUFFER_free_value(handle);
+                handle->buffer = tmp;
+                handle->size = alloc_size;
+                handle->capacity = alloc_size;
+                result = 0;
             }
         }
     }
@@ -496,8 +724,9 @@ int BUFFER_append(BUFFER_HANDLE handle1, BUFFER_HANDLE handle2)
             else
             {
                 // b2->size != 0, whatever b1->size is
-                unsigned char* temp = (unsigned char*)realloc(b1->buffer, b1->size + b2->size);
-                if (temp == NULL)
+                /* Codes_SRS_BUFFER_01_006: [ If the capacity is not enough, BUFFER_append_build, BUFFER_enlarge and BUFFER_append shall grow the capacity to the larger of the required size and twice the current capacity. ] */
+                if ((b1->size + b2->size < b2->size) ||
+                    (BUFFER_ensure_capacity(b1, b1->size + b2->size) != 0))
                 {
                     /* Codes_SRS_BUFFER_07_023: [BUFFER_append shall return a nonzero upon any error that is encountered.] */
                     LogError("Failure: allocating temp buffer.");
@@ -506,7 +735,6 @@ int BUFFER_append(BUFFER_HANDLE handle1, BUFFER_HANDLE handle2)
                 else
                 {
                     /* Codes_SRS_BUFFER_07_024: [BUFFER_append concatenates b2 onto b1 without modifying b2 and shall return zero on success.]*/
-                    b1->buffer = temp;
                     // Append the BUFFER
                     (void)memcpy(&b1->buffer[b1->size], b2->buffer, b2->size);
                     b1->size += b2->size;
@@ -548,10 +776,20 @@ int BUFFER_prepend(BUFFER_HANDLE handle1, BUFFER_HANDLE handle2)
                 // do nothing
                 result = 0;
             }
+            else if (b2->size <= b1->headroom)
+            {
+                /* Codes_SRS_BUFFER_01_020: [ If handle1 has enough headroom, BUFFER_prepend shall copy the content of handle2 into it without allocating. ]*/
+                b1->buffer -= b2->size;
+                b1->headroom -= b2->size;
+                b1->capacity += b2->size;
+                b1->size += b2->size;
+                (void)memcpy(b1->buffer, b2->buffer, b2->size);
+                result = 0;
+            }
             else
             {
                 // b2->size != 0
-                unsigned char* temp = (unsigned char*)malloc(b1->size + b2->size);
+                unsigned char* temp = BUFFER_alloc_value(b1, b1->size + b2->size);
                 if (temp == NULL)
                 {
                     /* Codes_SRS_BUFFER_01_005: [ BUFFER_prepend shall return a non-zero upon value any error that is encountered. ]*/
@@ -565,9 +803,10 @@ int BUFFER_prepend(BUFFER_HANDLE handle1, BUFFER_HANDLE handle2)
                     (void)memcpy(temp, b2->buffer, b2->size);
                     // start from b1->size to append b1
                     (void)memcpy(&temp[b2->size], b1->buffer, b1->size);
-                    free(b1->buffer);
+                    BUFFER_free_value(b1);
                     b1->buffer = temp;
                     b1->size += b2->size;
+                    b1->capacity = b1->size;
                     result = 0;
                 }
             }
@@ -645,12 +884,12 @@ BUFFER_HANDLE BUFFER_clone(BUFFER_HANDLE handle)
     else
     {
         BUFFER* suppliedBuff = (BUFFER*)handle;
-        BUFFER* b = (BUFFER*)malloc(sizeof(BUFFER));
+        BUFFER* b = BUFFER_alloc_handle();
         if (b != NULL)
         {
             if (BUFFER_safemalloc(b, suppliedBuff->size) != 0)
             {
-                free(b);
+                BUFFER_free_handle(b);
                 LogError("Failure: allocating temp buffer.");
                 result = NULL;
             }
@@ -668,3 +907,221 @@ BUFFER_HANDLE BUFFER_clone(BUFFER_HANDLE handle)
     }
     return result;
 }
+
+int BUFFER_reserve(BUFFER_HANDLE handle, size_t capacity)
+{
+    int result;
+    if (handle == NULL)
+    {
+        /* Codes_SRS_BUFFER_01_007: [ If handle is NULL, BUFFER_reserve shall return a non-zero value. ] */
+        LogError("Invalid parameter specified, handle == NULL.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        BUFFER* b = (BUFFER*)handle;
+        if (capacity <= b->capacity)
+        {
+            /* Codes_SRS_BUFFER_01_008: [ If capacity is not larger than the current capacity, BUFFER_reserve shall do nothing and return 0. ] */
+            result = 0;
+        }
+        else
+        {
+            /* Codes_SRS_BUFFER_01_009: [ Otherwise BUFFER_reserve shall reallocate the underlying buffer to hold exactly capacity bytes, without changing its size or content, and return 0. ] */
+            unsigned char* temp = BUFFER_realloc_value(b, capacity);
+            if (temp == NULL)
+            {
+                /* Codes_SRS_BUFFER_01_010: [ If reallocating fails, BUFFER_reserve shall return a non-zero value and leave the buffer unchanged. ] */
+                LogError("Failure reallocating buffer to %lu bytes", (unsigned long)capacity);
+                result = __FAILURE__;
+            }
+            else
+            {
+                b->buffer = temp;
+                b->capacity = capacity;
+                result = 0;
+            }
+        }
+    }
+    return result;
+}
+
+size_t BUFFER_capacity(BUFFER_HANDLE handle)
+{
+    size_t result;
+    if (handle == NULL)
+    {
+        /* Codes_SRS_BUFFER_01_011: [ If handle is NULL, BUFFER_capacity shall return 0. ] */
+        result = 0;
+    }
+    else
+    {
+        /* Codes_SRS_BUFFER_01_012: [ Otherwise BUFFER_capacity shall return the number of bytes the buffer can hold without reallocating. ] */
+        BUFFER* b = (BUFFER*)handle;
+        result = b->capacity;
+    }
+    return result;
+}
+
+int BUFFER_detach(BUFFER_HANDLE handle, unsigned char** memory, size_t* size)
+{
+    int result;
+    if ((handle == NULL) ||
+        (memory == NULL) ||
+        (size == NULL))
+    {
+        /* Codes_SRS_BUFFER_01_015: [ If handle, memory or size is NULL, BUFFER_detach shall fail and return a non-zero value. ] */
+        LogError("Invalid arguments: handle = %p, memory = %p, size = %p", handle, memory, size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        BUFFER* b = (BUFFER*)handle;
+        unsigned char* detached = b->buffer;
+
+        result = 0;
+#ifdef USE_OBJECT_POOLS
+        /* Codes_SRS_BUFFER_01_032: [ When built with OBJECT_POOL_STATIC, if the content is stored in a payload pool, BUFFER_detach shall copy it to a new allocation of its size and give the payload block back. ] */
+        if ((BUFFER_storage(b) == b->inline_buffer) || BUFFER_memory_is_payload(BUFFER_storage(b)))
+        {
+            /* Codes_SRS_BUFFER_01_017: [ If the content is stored in the BUFFER control block, BUFFER_detach shall copy it to a new allocation of its size. ] */
+            if (b->size == 0)
+            {
+                detached = NULL;
+            }
+            else if ((detached = (unsigned char*)malloc(b->size)) == NULL)
+            {
+                /* Codes_SRS_BUFFER_01_018: [ If any failure occurs, BUFFER_detach shall return a non-zero value and leave the buffer unchanged. ] */
+                LogError("Failure allocating %lu bytes", (unsigned long)b->size);
+                result = __FAILURE__;
+            }
+            else
+            {
+                (void)memcpy(detached, b->buffer, b->size);
+            }
+
+            if ((result == 0) && (BUFFER_storage(b) != b->inline_buffer))
+            {
+                BUFFER_memory_free(BUFFER_storage(b), b->headroom + b->capacity);
+            }
+        }
+        else
+#endif
+        if (b->headroom > 0)
+        {
+            /* Codes_SRS_BUFFER_01_021: [ If the buffer has headroom, BUFFER_detach shall first move the content to the start of its memory. ] */
+            detached = BUFFER_storage(b);
+            (void)memmove(detached, b->buffer, b->size);
+        }
+
+        if (result == 0)
+        {
+            /* Codes_SRS_BUFFER_01_016: [ Otherwise BUFFER_detach shall hand the memory of the buffer and its size to the caller, who frees it with free, leave the buffer empty and return 0. ] */
+            *memory = detached;
+            *size = b->size;
+            b->buffer = NULL;
+            b->size = 0;
+            b->capacity = 0;
+            b->headroom = 0;
+        }
+    }
+    return result;
+}
+
+BUFFER_HANDLE BUFFER_create_with_headroom(const unsigned char* source, size_t size, size_t headroom)
+{
+    BUFFER* result;
+    if ((source == NULL) && (size > 0))
+    {
+        /* Codes_SRS_BUFFER_01_022: [ If source is NULL and size is not 0, BUFFER_create_with_headroom shall fail and return NULL. ] */
+        LogError("invalid parameter source: %p, size: %lu", source, (unsigned long)size);
+        result = NULL;
+    }
+    else if (headroom + size < headroom)
+    {
+        /* Codes_SRS_BUFFER_01_024: [ If any failure occurs, BUFFER_create_with_headroom shall return NULL. ] */
+        LogError("invalid parameters: size %lu with a headroom of %lu bytes", (unsigned long)size, (unsigned long)headroom);
+        result = NULL;
+    }
+    else if ((result = BUFFER_alloc_handle()) == NULL)
+    {
+        /* Codes_SRS_BUFFER_01_024: [ If any failure occurs, BUFFER_create_with_headroom shall return NULL. ] */
+        LogError("Failure allocating BUFFER structure");
+    }
+    else
+    {
+        /* Codes_SRS_BUFFER_01_023: [ Otherwise BUFFER_create_with_headroom shall allocate headroom bytes followed by size bytes copied from source, and return a non-NULL handle. ] */
+        size_t storage_size = (headroom + size == 0) ? 1 : (headroom + size);
+        unsigned char* storage = BUFFER_alloc_value(result, storage_size);
+        if (storage == NULL)
+        {
+            /* Codes_SRS_BUFFER_01_024: [ If any failure occurs, BUFFER_create_with_headroom shall return NULL. ] */
+            LogError("Failure allocating data");
+            BUFFER_free_handle(result);
+            result = NULL;
+        }
+        else
+        {
+            result->buffer = storage + headroom;
+            result->headroom = headroom;
+            result->size = size;
+            result->capacity = storage_size - headroom;
+            if (size > 0)
+            {
+                (void)memcpy(result->buffer, source, size);
+            }
+        }
+    }
+    return (BUFFER_HANDLE)result;
+}
+
+int BUFFER_push_front(BUFFER_HANDLE handle, const unsigned char* source, size_t size)
+{
+    int result;
+    if ((handle == NULL) || (source == NULL) || (size == 0))
+    {
+        /* Codes_SRS_BUFFER_01_025: [ If handle or source is NULL or size is 0, BUFFER_push_front shall return a non-zero value. ] */
+        LogError("Invalid arguments: handle = %p, source = %p, size = %lu", handle, source, (unsigned long)size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        BUFFER* b = (BUFFER*)handle;
+        /* Codes_SRS_BUFFER_01_027: [ If the headroom is not enough, BUFFER_push_front shall reallocate the buffer with a headroom of size plus the size of the content. ] */
+        if ((b->size + size < size) ||
+            (BUFFER_ensure_headroom(b, size) != 0))
+        {
+            /* Codes_SRS_BUFFER_01_028: [ If any failure occurs, BUFFER_push_front shall return a non-zero value and leave the buffer unchanged. ] */
+            LogError("Failure making room for %lu bytes", (unsigned long)size);
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_BUFFER_01_026: [ Otherwise BUFFER_push_front shall copy size bytes from source into the headroom, in front of the content, and return 0. ] */
+            b->buffer -= size;
+            b->headroom -= size;
+            b->capacity += size;
+            b->size += size;
+            (void)memcpy(b->buffer, source, size);
+            result = 0;
+        }
+    }
+    return result;
+}
+
+size_t BUFFER_headroom(BUFFER_HANDLE handle)
+{
+    size_t result;
+    if (handle == NULL)
+    {
+        /* Codes_SRS_BUFFER_01_029: [ If handle is NULL, BUFFER_headroom shall return 0. ] */
+        result = 0;
+    }
+    else
+    {
+        /* Codes_SRS_BUFFER_01_030: [ Otherwise BUFFER_headroom shall return the number of bytes that can be prepended without reallocating. ] */
+        BUFFER* b = (BUFFER*)handle;
+        result = b->headroom;
+    }
+    return result;
+}
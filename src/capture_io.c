@@ -0,0 +1,1033 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <limits.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/capture_io.h"
+#include "azure_c_shared_utility/constbuffer_array.h"
+#include "azure_c_shared_utility/agenttime.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+/*
+* Record i of the ring holds position p when its sequence is 2p+2, and is being written for p
+* while its sequence is 2p+1. A recording takes the next position with an atomic add and claims
+* the record with a compare-and-swap from the sequence it read, provided that sequence belongs to
+* an older position and is not being written: a record that another thread is still writing (the
+* ring went around while it was copying) is not recorded at all, and counted.
+*
+* The dump reads a record between two reads of its sequence and leaves it out when they differ,
+* so it never takes a lock the recordings take. The interface names are only changed when a
+* capture IO is created, under the lock of the ring.
+*/
+#if defined(_MSC_VER)
+#include <windows.h>
+#define CAPTURE_IO_ADD(value, addend) InterlockedExchangeAdd(&(value), (addend))
+#define CAPTURE_IO_CAS(value, exchange, comparand) InterlockedCompareExchange(&(value), (exchange), (comparand))
+#else
+#define CAPTURE_IO_ADD(value, addend) __sync_fetch_and_add(&(value), (addend))
+#define CAPTURE_IO_CAS(value, exchange, comparand) __sync_val_compare_and_swap(&(value), (comparand), (exchange))
+#endif
+#define CAPTURE_IO_READ(value) CAPTURE_IO_ADD(value, 0)
+/* positions wrap around, so they are only ever compared through their difference */
+#define CAPTURE_IO_DIFF(a, b) ((long)((unsigned long)(a) - (unsigned long)(b)))
+#define CAPTURE_IO_WRITING_SEQUENCE(position) ((long)(((unsigned long)(position) * 2) + 1))
+#define CAPTURE_IO_PUBLISHED_SEQUENCE(position) ((long)(((unsigned long)(position) * 2) + 2))
+
+#define PCAPNG_SECTION_HEADER_BLOCK         0x0A0D0D0A
+#define PCAPNG_INTERFACE_DESCRIPTION_BLOCK  0x00000001
+#define PCAPNG_ENHANCED_PACKET_BLOCK        0x00000006
+#define PCAPNG_BYTE_ORDER_MAGIC             0x1A2B3C4D
+#define PCAPNG_LINKTYPE_USER0               147
+#define PCAPNG_OPTION_END                   0
+#define PCAPNG_OPTION_IF_NAME               2
+#define PCAPNG_OPTION_EPB_FLAGS             2
+#define PCAPNG_EPB_FLAGS_INBOUND            0x00000001
+#define PCAPNG_EPB_FLAGS_OUTBOUND           0x00000002
+/* the fixed part of the body of an enhanced packet block, and its flags option with the end of options */
+#define PCAPNG_EPB_FIXED_SIZE               20
+#define PCAPNG_EPB_OPTIONS_SIZE             12
+
+#define PCAPNG_PAD(size) (((size) + 3) & ~(size_t)3)
+
+typedef enum CAPTURE_IO_DIRECTION_TAG
+{
+    CAPTURE_IO_DIRECTION_IN,
+    CAPTURE_IO_DIRECTION_OUT
+} CAPTURE_IO_DIRECTION;
+
+typedef struct CAPTURE_IO_RECORD_TAG
+{
+    volatile long sequence;
+    uint32_t interface_id;
+    uint32_t direction;
+    uint64_t time_us;
+    uint32_t original_length;
+    uint32_t captured_length;
+    /* followed by the snap_length bytes of the data */
+} CAPTURE_IO_RECORD;
+
+typedef struct CAPTURE_IO_RING_TAG
+{
+    unsigned char* records;
+    /* the size of a record with its data, a multiple of 8 */
+    size_t record_size;
+    unsigned long record_mask;
+    size_t snap_length;
+    volatile long head;
+    volatile long dropped_count;
+    /* the wall clock of the monotonic time 0, for the timestamps of the file */
+    uint64_t epoch_offset_us;
+    LOCK_HANDLE lock;
+    char** interface_names;
+    size_t interface_count;
+} CAPTURE_IO_RING;
+
+typedef struct CAPTURE_IO_INSTANCE_TAG
+{
+    XIO_HANDLE underlying_io;
+    CAPTURE_IO_RING* ring;
+    uint32_t interface_id;
+    ON_BYTES_RECEIVED on_bytes_received;
+    void* on_bytes_received_context;
+    XIO_STATS stats;
+} CAPTURE_IO_INSTANCE;
+
+static uint64_t get_now_us(void)
+{
+    tickcounter_us_t now_us;
+
+    if (tickcounter_get_monotonic_us(&now_us) != 0)
+    {
+        now_us = 0;
+    }
+
+    return (uint64_t)now_us;
+}
+
+static CAPTURE_IO_RECORD* get_record(CAPTURE_IO_RING* ring, unsigned long position)
+{
+    return (CAPTURE_IO_RECORD*)(void*)(ring->records + ((position & ring->record_mask) * ring->record_size));
+}
+
+/* claims the next record, NULL when it is still being written for an older position */
+static CAPTURE_IO_RECORD* begin_record(CAPTURE_IO_RING* ring, uint32_t interface_id, CAPTURE_IO_DIRECTION direction, size_t size)
+{
+    long position = CAPTURE_IO_ADD(ring->head, 1);
+    CAPTURE_IO_RECORD* result = get_record(ring, (unsigned long)position);
+    long sequence = CAPTURE_IO_READ(result->sequence);
+
+    if (((sequence & 1) != 0) ||
+        (CAPTURE_IO_DIFF(sequence, CAPTURE_IO_WRITING_SEQUENCE(position)) >= 0) ||
+        (CAPTURE_IO_CAS(result->sequence, CAPTURE_IO_WRITING_SEQUENCE(position), sequence) != sequence))
+    {
+        (void)CAPTURE_IO_ADD(ring->dropped_count, 1);
+        result = NULL;
+    }
+    else
+    {
+        result->interface_id = interface_id;
+        result->direction = (uint32_t)direction;
+        result->time_us = get_now_us();
+        result->original_length = (size > UINT32_MAX) ? UINT32_MAX : (uint32_t)size;
+        result->captured_length = 0;
+    }
+
+    return result;
+}
+
+static void append_to_record(CAPTURE_IO_RING* ring, CAPTURE_IO_RECORD* record, const void* buffer, size_t size)
+{
+    size_t room = ring->snap_length - record->captured_length;
+    size_t copy_size = (size < room) ? size : room;
+
+    if (copy_size > 0)
+    {
+        (void)memcpy((unsigned char*)(record + 1) + record->captured_length, buffer, copy_size);
+        record->captured_length += (uint32_t)copy_size;
+    }
+}
+
+static void end_record(CAPTURE_IO_RECORD* record)
+{
+    long sequence = record->sequence;
+
+    /* the compare-and-swap is the barrier that publishes the content */
+    (void)CAPTURE_IO_CAS(record->sequence, sequence + 1, sequence);
+}
+
+static void record_bytes(CAPTURE_IO_INSTANCE* capture_io_instance, CAPTURE_IO_DIRECTION direction, const void* buffer, size_t size)
+{
+    CAPTURE_IO_RECORD* record = begin_record(capture_io_instance->ring, capture_io_instance->interface_id, direction, size);
+
+    if (record != NULL)
+    {
+        append_to_record(capture_io_instance->ring, record, buffer, size);
+        end_record(record);
+    }
+}
+
+CAPTURE_IO_RING_HANDLE capture_io_ring_create(size_t record_count, size_t snap_length)
+{
+    CAPTURE_IO_RING* result;
+    size_t rounded_record_count = 1;
+
+    if (record_count == 0)
+    {
+        /* Codes_SRS_CAPTURE_IO_01_002: [ If record_count is 0, capture_io_ring_create shall use CAPTURE_IO_RING_DEFAULT_RECORD_COUNT. ]*/
+        record_count = CAPTURE_IO_RING_DEFAULT_RECORD_COUNT;
+    }
+
+    /* Codes_SRS_CAPTURE_IO_01_003: [ capture_io_ring_create shall round record_count up to a power of 2. ]*/
+    while ((rounded_record_count < record_count) && (rounded_record_count <= (LONG_MAX / 2)))
+    {
+        rounded_record_count *= 2;
+    }
+
+    if ((rounded_record_count < record_count) ||
+        (snap_length > UINT32_MAX) ||
+        (snap_length > (SIZE_MAX / rounded_record_count) - sizeof(CAPTURE_IO_RECORD) - 8))
+    {
+        /* Codes_SRS_CAPTURE_IO_01_004: [ If the records would not fit in memory, capture_io_ring_create shall fail and return NULL. ]*/
+        LogError("Invalid arguments: record_count=%lu, snap_length=%lu", (unsigned long)record_count, (unsigned long)snap_length);
+        result = NULL;
+    }
+    /* Codes_SRS_CAPTURE_IO_01_001: [ capture_io_ring_create shall allocate the ring, its records with room for snap_length bytes each and its lock. ]*/
+    else if ((result = (CAPTURE_IO_RING*)malloc(sizeof(CAPTURE_IO_RING))) == NULL)
+    {
+        /* Codes_SRS_CAPTURE_IO_01_005: [ If any failure occurs, capture_io_ring_create shall free what it created and return NULL. ]*/
+        LogError("Cannot allocate capture ring");
+    }
+    else
+    {
+        result->record_size = (sizeof(CAPTURE_IO_RECORD) + snap_length + 7) & ~(size_t)7;
+        if ((result->records = (unsigned char*)calloc(rounded_record_count, result->record_size)) == NULL)
+        {
+            /* Codes_SRS_CAPTURE_IO_01_005: [ If any failure occurs, capture_io_ring_create shall free what it created and return NULL. ]*/
+            LogError("Cannot allocate %lu capture records", (unsigned long)rounded_record_count);
+            free(result);
+            result = NULL;
+        }
+        else if ((result->lock = Lock_Init()) == NULL)
+        {
+            /* Codes_SRS_CAPTURE_IO_01_005: [ If any failure occurs, capture_io_ring_create shall free what it created and return NULL. ]*/
+            LogError("Cannot create the lock of the capture ring");
+            free(result->records);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            /* Codes_SRS_CAPTURE_IO_01_006: [ capture_io_ring_create shall take the wall clock from get_time and the monotonic clock from tickcounter_get_monotonic_us to time the records. ]*/
+            time_t now = get_time(NULL);
+            uint64_t now_us = get_now_us();
+            uint64_t wall_us = (now == (time_t)-1) ? 0 : (uint64_t)now * 1000000;
+
+            result->epoch_offset_us = (wall_us > now_us) ? wall_us - now_us : 0;
+            result->record_mask = (unsigned long)(rounded_record_count - 1);
+            result->snap_length = snap_length;
+            result->head = 0;
+            result->dropped_count = 0;
+            result->interface_names = NULL;
+            result->interface_count = 0;
+        }
+    }
+
+    return result;
+}
+
+void capture_io_ring_destroy(CAPTURE_IO_RING_HANDLE ring)
+{
+    if (ring == NULL)
+    {
+        /* Codes_SRS_CAPTURE_IO_01_007: [ If ring is NULL, capture_io_ring_destroy shall do nothing. ]*/
+        LogError("NULL ring");
+    }
+    else
+    {
+        size_t i;
+
+        /* Codes_SRS_CAPTURE_IO_01_008: [ capture_io_ring_destroy shall free the interface names, the records, the lock and the ring. ]*/
+        for (i = 0; i < ring->interface_count; i++)
+        {
+            free(ring->interface_names[i]);
+        }
+
+        free(ring->interface_names);
+        (void)Lock_Deinit(ring->lock);
+        free(ring->records);
+        free(ring);
+    }
+}
+
+static void put_uint16(unsigned char* buffer, uint16_t value)
+{
+    (void)memcpy(buffer, &value, sizeof(value));
+}
+
+static void put_uint32(unsigned char* buffer, uint32_t value)
+{
+    (void)memcpy(buffer, &value, sizeof(value));
+}
+
+/* the blocks are written in the byte order of the host, which the byte order magic tells the readers */
+static int write_block(FILE* file, uint32_t block_type, const unsigned char* body, size_t body_size)
+{
+    int result;
+    unsigned char header[8];
+    unsigned char padding[3] = { 0, 0, 0 };
+    uint32_t total_length = (uint32_t)(12 + PCAPNG_PAD(body_size));
+
+    put_uint32(header, block_type);
+    put_uint32(header + 4, total_length);
+
+    if ((fwrite(header, 1, sizeof(header), file) != sizeof(header)) ||
+        ((body_size > 0) && (fwrite(body, 1, body_size, file) != body_size)) ||
+        ((PCAPNG_PAD(body_size) > body_size) && (fwrite(padding, 1, PCAPNG_PAD(body_size) - body_size, file) != PCAPNG_PAD(body_size) - body_size)) ||
+        (fwrite(header + 4, 1, 4, file) != 4))
+    {
+        LogError("Cannot write a pcapng block");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static int write_section_header(FILE* file)
+{
+    unsigned char body[16];
+
+    put_uint32(body, PCAPNG_BYTE_ORDER_MAGIC);
+    put_uint16(body + 4, 1);
+    put_uint16(body + 6, 0);
+    /* the section length is not known */
+    (void)memset(body + 8, 0xFF, 8);
+
+    return write_block(file, PCAPNG_SECTION_HEADER_BLOCK, body, sizeof(body));
+}
+
+// Must be called with the lock of the ring held.
+static int write_interfaces(CAPTURE_IO_RING* ring, FILE* file)
+{
+    int result = 0;
+    size_t i;
+
+    for (i = 0; (result == 0) && (i < ring->interface_count); i++)
+    {
+        size_t name_length = strlen(ring->interface_names[i]);
+        size_t body_size = 8 + 4 + PCAPNG_PAD(name_length) + 4;
+        unsigned char* body;
+
+        if (name_length > UINT16_MAX)
+        {
+            name_length = UINT16_MAX;
+            body_size = 8 + 4 + PCAPNG_PAD(name_length) + 4;
+        }
+
+        if ((body = (unsigned char*)calloc(1, body_size)) == NULL)
+        {
+            LogError("Cannot allocate an interface block");
+            result = __FAILURE__;
+        }
+        else
+        {
+            put_uint16(body, PCAPNG_LINKTYPE_USER0);
+            put_uint16(body + 2, 0);
+            put_uint32(body + 4, (uint32_t)ring->snap_length);
+            put_uint16(body + 8, PCAPNG_OPTION_IF_NAME);
+            put_uint16(body + 10, (uint16_t)name_length);
+            (void)memcpy(body + 12, ring->interface_names[i], name_length);
+            /* the end of options stays zeroed */
+
+            result = write_block(file, PCAPNG_INTERFACE_DESCRIPTION_BLOCK, body, body_size);
+            free(body);
+        }
+    }
+
+    return result;
+}
+
+static int write_records(CAPTURE_IO_RING* ring, FILE* file, size_t* skipped_count)
+{
+    int result = 0;
+    unsigned char* copy = (unsigned char*)malloc(ring->record_size);
+    unsigned char* body = (unsigned char*)malloc(PCAPNG_EPB_FIXED_SIZE + PCAPNG_PAD(ring->snap_length) + PCAPNG_EPB_OPTIONS_SIZE);
+
+    *skipped_count = 0;
+
+    if ((copy == NULL) ||
+        (body == NULL))
+    {
+        LogError("Cannot allocate the buffers of the dump");
+        result = __FAILURE__;
+    }
+    else
+    {
+        long head = CAPTURE_IO_READ(ring->head);
+        unsigned long record_count = (unsigned long)ring->record_mask + 1;
+        unsigned long available = ((unsigned long)head < record_count) ? (unsigned long)head : record_count;
+        unsigned long position;
+
+        for (position = (unsigned long)head - available; (result == 0) && (position != (unsigned long)head); position++)
+        {
+            CAPTURE_IO_RECORD* record = get_record(ring, position);
+            long sequence = CAPTURE_IO_READ(record->sequence);
+            const CAPTURE_IO_RECORD* copied_record = (const CAPTURE_IO_RECORD*)(const void*)copy;
+
+            if (sequence != CAPTURE_IO_PUBLISHED_SEQUENCE(position))
+            {
+                (*skipped_count)++;
+            }
+            else
+            {
+                (void)memcpy(copy, record, ring->record_size);
+
+                if ((CAPTURE_IO_READ(record->sequence) != sequence) ||
+                    (copied_record->captured_length > ring->snap_length))
+                {
+                    (*skipped_count)++;
+                }
+                else
+                {
+                    uint64_t time_us = copied_record->time_us + ring->epoch_offset_us;
+                    size_t data_size = PCAPNG_PAD(copied_record->captured_length);
+                    unsigned char* options = body + PCAPNG_EPB_FIXED_SIZE + data_size;
+
+                    put_uint32(body, copied_record->interface_id);
+                    put_uint32(body + 4, (uint32_t)(time_us >> 32));
+                    put_uint32(body + 8, (uint32_t)time_us);
+                    put_uint32(body + 12, copied_record->captured_length);
+                    put_uint32(body + 16, copied_record->original_length);
+                    (void)memset(body + PCAPNG_EPB_FIXED_SIZE, 0, data_size);
+                    (void)memcpy(body + PCAPNG_EPB_FIXED_SIZE, copied_record + 1, copied_record->captured_length);
+                    put_uint16(options, PCAPNG_OPTION_EPB_FLAGS);
+                    put_uint16(options + 2, 4);
+                    put_uint32(options + 4, (copied_record->direction == (uint32_t)CAPTURE_IO_DIRECTION_IN) ? PCAPNG_EPB_FLAGS_INBOUND : PCAPNG_EPB_FLAGS_OUTBOUND);
+                    put_uint32(options + 8, PCAPNG_OPTION_END);
+
+                    result = write_block(file, PCAPNG_ENHANCED_PACKET_BLOCK, body, PCAPNG_EPB_FIXED_SIZE + data_size + PCAPNG_EPB_OPTIONS_SIZE);
+                }
+            }
+        }
+    }
+
+    free(copy);
+    free(body);
+
+    return result;
+}
+
+int capture_io_ring_dump(CAPTURE_IO_RING_HANDLE ring, const char* file_path)
+{
+    int result;
+
+    if ((ring == NULL) ||
+        (file_path == NULL))
+    {
+        /* Codes_SRS_CAPTURE_IO_01_009: [ If ring or file_path is NULL, capture_io_ring_dump shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: ring=%p, file_path=%p", ring, file_path);
+        result = __FAILURE__;
+    }
+    else
+    {
+        FILE* file = fopen(file_path, "wb");
+
+        if (file == NULL)
+        {
+            /* Codes_SRS_CAPTURE_IO_01_014: [ If opening, writing or closing the file fails, capture_io_ring_dump shall fail and return a non-zero value. ]*/
+            LogError("Cannot open %s", file_path);
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t skipped_count = 0;
+
+            /* Codes_SRS_CAPTURE_IO_01_010: [ capture_io_ring_dump shall write a pcapng section header block, then one interface description block of link type LINKTYPE_USER0 per interface name, under the lock of the ring. ]*/
+            if (write_section_header(file) != 0)
+            {
+                result = __FAILURE__;
+            }
+            else if (Lock(ring->lock) != LOCK_OK)
+            {
+                /* Codes_SRS_CAPTURE_IO_01_015: [ If locking the ring fails, capture_io_ring_dump shall fail and return a non-zero value. ]*/
+                LogError("Cannot lock the capture ring");
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = write_interfaces(ring, file);
+                (void)Unlock(ring->lock);
+
+                /* Codes_SRS_CAPTURE_IO_01_011: [ capture_io_ring_dump shall then write one enhanced packet block per record of the ring, oldest first, with its time, its captured bytes, its size and its direction in the epb_flags option. ]*/
+                /* Codes_SRS_CAPTURE_IO_01_012: [ capture_io_ring_dump shall leave out the records that are being written or are overwritten while it reads them. ]*/
+                if ((result == 0) &&
+                    (write_records(ring, file, &skipped_count) != 0))
+                {
+                    result = __FAILURE__;
+                }
+            }
+
+            if (fclose(file) != 0)
+            {
+                /* Codes_SRS_CAPTURE_IO_01_014: [ If opening, writing or closing the file fails, capture_io_ring_dump shall fail and return a non-zero value. ]*/
+                LogError("Cannot close %s", file_path);
+                result = __FAILURE__;
+            }
+
+            if ((skipped_count > 0) || (CAPTURE_IO_READ(ring->dropped_count) != 0))
+            {
+                LogInfo("capture ring dump: %lu records being written left out, %ld recordings dropped", (unsigned long)skipped_count, (long)CAPTURE_IO_READ(ring->dropped_count));
+            }
+
+            /* Codes_SRS_CAPTURE_IO_01_013: [ On success, capture_io_ring_dump shall return 0. ]*/
+        }
+    }
+
+    return result;
+}
+
+static int add_interface(CAPTURE_IO_RING* ring, const char* name, uint32_t* interface_id)
+{
+    int result;
+
+    if (Lock(ring->lock) != LOCK_OK)
+    {
+        LogError("Cannot lock the capture ring");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+
+        for (i = 0; i < ring->interface_count; i++)
+        {
+            if (strcmp(ring->interface_names[i], name) == 0)
+            {
+                break;
+            }
+        }
+
+        if (i < ring->interface_count)
+        {
+            *interface_id = (uint32_t)i;
+            result = 0;
+        }
+        else
+        {
+            char** new_names = (char**)realloc(ring->interface_names, (ring->interface_count + 1) * sizeof(char*));
+            if (new_names == NULL)
+            {
+                LogError("Cannot grow the interface names");
+                result = __FAILURE__;
+            }
+            else
+            {
+                ring->interface_names = new_names;
+                if (mallocAndStrcpy_s(&ring->interface_names[ring->interface_count], name) != 0)
+                {
+                    LogError("Cannot copy the interface name");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    *interface_id = (uint32_t)ring->interface_count;
+                    ring->interface_count++;
+                    result = 0;
+                }
+            }
+        }
+
+        (void)Unlock(ring->lock);
+    }
+
+    return result;
+}
+
+static void on_underlying_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    CAPTURE_IO_INSTANCE* capture_io_instance = (CAPTURE_IO_INSTANCE*)context;
+
+    /* Codes_SRS_CAPTURE_IO_01_030: [ When the underlying IO indicates received bytes, the capture IO shall record them as inbound and indicate them to the layer above. ]*/
+    record_bytes(capture_io_instance, CAPTURE_IO_DIRECTION_IN, buffer, size);
+    capture_io_instance->stats.bytes_received += size;
+    capture_io_instance->stats.callback_count++;
+    capture_io_instance->on_bytes_received(capture_io_instance->on_bytes_received_context, buffer, size);
+}
+
+static CONCRETE_IO_HANDLE capture_io_create(void* io_create_parameters)
+{
+    CAPTURE_IO_INSTANCE* result;
+
+    if (io_create_parameters == NULL)
+    {
+        /* Codes_SRS_CAPTURE_IO_01_021: [ If io_create_parameters is NULL, capture_io_create shall fail and return NULL. ]*/
+        LogError("NULL io_create_parameters.");
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_CAPTURE_IO_01_022: [ io_create_parameters shall be used as a CAPTURE_IO_CONFIG*. ]*/
+        CAPTURE_IO_CONFIG* capture_io_config = (CAPTURE_IO_CONFIG*)io_create_parameters;
+
+        if ((capture_io_config->underlying_io_interface == NULL) ||
+            (capture_io_config->ring == NULL) ||
+            (capture_io_config->name == NULL))
+        {
+            /* Codes_SRS_CAPTURE_IO_01_023: [ If underlying_io_interface, ring or name is NULL, capture_io_create shall fail and return NULL. ]*/
+            LogError("Bad arguments: underlying_io_interface = %p, ring = %p, name = %p",
+                capture_io_config->underlying_io_interface, capture_io_config->ring, capture_io_config->name);
+            result = NULL;
+        }
+        /* Codes_SRS_CAPTURE_IO_01_020: [ capture_io_create shall create a new instance of the capture IO. ]*/
+        else if ((result = (CAPTURE_IO_INSTANCE*)malloc(sizeof(CAPTURE_IO_INSTANCE))) == NULL)
+        {
+            /* Codes_SRS_CAPTURE_IO_01_026: [ If any failure occurs, capture_io_create shall free what it created and return NULL. ]*/
+            LogError("Failed allocating capture IO instance.");
+        }
+        /* Codes_SRS_CAPTURE_IO_01_024: [ capture_io_create shall add name to the interfaces of the ring, unless a capture IO already added it. ]*/
+        else if (add_interface(capture_io_config->ring, capture_io_config->name, &result->interface_id) != 0)
+        {
+            /* Codes_SRS_CAPTURE_IO_01_026: [ If any failure occurs, capture_io_create shall free what it created and return NULL. ]*/
+            free(result);
+            result = NULL;
+        }
+        /* Codes_SRS_CAPTURE_IO_01_025: [ capture_io_create shall create the underlying IO by calling xio_create with underlying_io_interface and underlying_io_parameters. ]*/
+        else if ((result->underlying_io = xio_create(capture_io_config->underlying_io_interface, capture_io_config->underlying_io_parameters)) == NULL)
+        {
+            /* Codes_SRS_CAPTURE_IO_01_026: [ If any failure occurs, capture_io_create shall free what it created and return NULL. ]*/
+            LogError("Unable to create the underlying IO.");
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result->ring = capture_io_config->ring;
+            result->on_bytes_received = NULL;
+            result->on_bytes_received_context = NULL;
+            (void)memset(&result->stats, 0, sizeof(result->stats));
+            result->stats.layer_name = "capture_io";
+        }
+    }
+
+    return result;
+}
+
+static void capture_io_destroy(CONCRETE_IO_HANDLE capture_io)
+{
+    if (capture_io == NULL)
+    {
+        /* Codes_SRS_CAPTURE_IO_01_028: [ If capture_io is NULL, capture_io_destroy shall do nothing. ]*/
+        LogError("NULL capture_io.");
+    }
+    else
+    {
+        CAPTURE_IO_INSTANCE* capture_io_instance = (CAPTURE_IO_INSTANCE*)capture_io;
+
+        /* Codes_SRS_CAPTURE_IO_01_027: [ capture_io_destroy shall destroy the underlying IO and free the instance, the records staying in the ring. ]*/
+        xio_destroy(capture_io_instance->underlying_io);
+        free(capture_io_instance);
+    }
+}
+
+static int capture_io_open(CONCRETE_IO_HANDLE capture_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    int result;
+
+    if ((capture_io == NULL) ||
+        (on_bytes_received == NULL))
+    {
+        /* Codes_SRS_CAPTURE_IO_01_031: [ If capture_io or on_bytes_received is NULL, capture_io_open shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: capture_io = %p, on_bytes_received = %p.", capture_io, on_bytes_received);
+        result = __FAILURE__;
+    }
+    else
+    {
+        CAPTURE_IO_INSTANCE* capture_io_instance = (CAPTURE_IO_INSTANCE*)capture_io;
+
+        capture_io_instance->on_bytes_received = on_bytes_received;
+        capture_io_instance->on_bytes_received_context = on_bytes_received_context;
+
+        /* Codes_SRS_CAPTURE_IO_01_032: [ capture_io_open shall call xio_open on the underlying IO with the open and error callbacks of the layer above and its own received bytes callback. ]*/
+        if (xio_open(capture_io_instance->underlying_io, on_io_open_complete, on_io_open_complete_context, on_underlying_io_bytes_received, capture_io_instance, on_io_error, on_io_error_context) != 0)
+        {
+            /* Codes_SRS_CAPTURE_IO_01_033: [ If xio_open fails, capture_io_open shall fail and return a non-zero value. ]*/
+            LogError("Cannot open the underlying IO.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int capture_io_close(CONCRETE_IO_HANDLE capture_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* on_io_close_complete_context)
+{
+    int result;
+
+    if (capture_io == NULL)
+    {
+        LogError("NULL capture_io.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        CAPTURE_IO_INSTANCE* capture_io_instance = (CAPTURE_IO_INSTANCE*)capture_io;
+
+        /* Codes_SRS_CAPTURE_IO_01_034: [ capture_io_close shall return the result of xio_close on the underlying IO. ]*/
+        result = xio_close(capture_io_instance->underlying_io, on_io_close_complete, on_io_close_complete_context);
+    }
+
+    return result;
+}
+
+static int capture_io_send(CONCRETE_IO_HANDLE capture_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* on_send_complete_context)
+{
+    int result;
+
+    if ((capture_io == NULL) ||
+        (buffer == NULL) ||
+        (size == 0))
+    {
+        /* Codes_SRS_CAPTURE_IO_01_035: [ If capture_io or buffer is NULL or size is 0, capture_io_send shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: capture_io = %p, buffer = %p, size = %lu.", capture_io, buffer, (unsigned long)size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        CAPTURE_IO_INSTANCE* capture_io_instance = (CAPTURE_IO_INSTANCE*)capture_io;
+
+        /* Codes_SRS_CAPTURE_IO_01_036: [ capture_io_send shall record the bytes as outbound and send them by calling xio_send on the underlying IO. ]*/
+        record_bytes(capture_io_instance, CAPTURE_IO_DIRECTION_OUT, buffer, size);
+
+        if (xio_send(capture_io_instance->underlying_io, buffer, size, on_send_complete, on_send_complete_context) != 0)
+        {
+            /* Codes_SRS_CAPTURE_IO_01_037: [ If the underlying send fails, capture_io_send, capture_io_sendv and capture_io_send_constbuffer_array shall fail and return a non-zero value. ]*/
+            LogError("Underlying xio_send failed.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            capture_io_instance->stats.bytes_sent += size;
+            capture_io_instance->stats.send_count++;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int capture_io_sendv(CONCRETE_IO_HANDLE capture_io, const XIO_BUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* on_send_complete_context)
+{
+    int result;
+
+    if ((capture_io == NULL) ||
+        (buffers == NULL) ||
+        (buffer_count == 0))
+    {
+        LogError("Bad arguments: capture_io = %p, buffers = %p, buffer_count = %lu.", capture_io, buffers, (unsigned long)buffer_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        CAPTURE_IO_INSTANCE* capture_io_instance = (CAPTURE_IO_INSTANCE*)capture_io;
+        CAPTURE_IO_RECORD* record;
+        size_t size = 0;
+        size_t i;
+
+        for (i = 0; i < buffer_count; i++)
+        {
+            size += buffers[i].size;
+        }
+
+        /* Codes_SRS_CAPTURE_IO_01_038: [ capture_io_sendv and capture_io_send_constbuffer_array shall record the buffers as one outbound record and hand them to xio_sendv and xio_send_constbuffer_array of the underlying IO. ]*/
+        if ((record = begin_record(capture_io_instance->ring, capture_io_instance->interface_id, CAPTURE_IO_DIRECTION_OUT, size)) != NULL)
+        {
+            for (i = 0; (i < buffer_count) && (record->captured_length < capture_io_instance->ring->snap_length); i++)
+            {
+                append_to_record(capture_io_instance->ring, record, buffers[i].buffer, buffers[i].size);
+            }
+
+            end_record(record);
+        }
+
+        if (xio_sendv(capture_io_instance->underlying_io, buffers, buffer_count, on_send_complete, on_send_complete_context) != 0)
+        {
+            LogError("Underlying xio_sendv failed.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            capture_io_instance->stats.bytes_sent += size;
+            capture_io_instance->stats.send_count++;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int capture_io_send_constbuffer_array(CONCRETE_IO_HANDLE capture_io, CONSTBUFFER_ARRAY_HANDLE constbuffer_array, ON_SEND_COMPLETE on_send_complete, void* on_send_complete_context)
+{
+    int result;
+    uint32_t buffer_count;
+
+    if ((capture_io == NULL) ||
+        (constbuffer_array == NULL))
+    {
+        LogError("Bad arguments: capture_io = %p, constbuffer_array = %p.", capture_io, constbuffer_array);
+        result = __FAILURE__;
+    }
+    else if (constbuffer_array_get_buffer_count(constbuffer_array, &buffer_count) != 0)
+    {
+        LogError("Cannot get the buffer count of the array.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        CAPTURE_IO_INSTANCE* capture_io_instance = (CAPTURE_IO_INSTANCE*)capture_io;
+        CAPTURE_IO_RECORD* record;
+        size_t size = 0;
+        uint32_t i;
+
+        for (i = 0; i < buffer_count; i++)
+        {
+            const CONSTBUFFER* content = constbuffer_array_get_buffer_content(constbuffer_array, i);
+            if (content != NULL)
+            {
+                size += content->size;
+            }
+        }
+
+        /* Codes_SRS_CAPTURE_IO_01_038: [ capture_io_sendv and capture_io_send_constbuffer_array shall record the buffers as one outbound record and hand them to xio_sendv and xio_send_constbuffer_array of the underlying IO. ]*/
+        if ((record = begin_record(capture_io_instance->ring, capture_io_instance->interface_id, CAPTURE_IO_DIRECTION_OUT, size)) != NULL)
+        {
+            for (i = 0; (i < buffer_count) && (record->captured_length < capture_io_instance->ring->snap_length); i++)
+            {
+                const CONSTBUFFER* content = constbuffer_array_get_buffer_content(constbuffer_array, i);
+                if (content != NULL)
+                {
+                    append_to_record(capture_io_instance->ring, record, content->buffer, content->size);
+                }
+            }
+
+            end_record(record);
+        }
+
+        if (xio_send_constbuffer_array(capture_io_instance->underlying_io, constbuffer_array, on_send_complete, on_send_complete_context) != 0)
+        {
+            LogError("Underlying xio_send_constbuffer_array failed.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            capture_io_instance->stats.bytes_sent += size;
+            capture_io_instance->stats.send_count++;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void capture_io_dowork(CONCRETE_IO_HANDLE capture_io)
+{
+    if (capture_io == NULL)
+    {
+        /* Codes_SRS_CAPTURE_IO_01_040: [ If capture_io is NULL, capture_io_dowork shall do nothing. ]*/
+        LogError("NULL capture_io.");
+    }
+    else
+    {
+        CAPTURE_IO_INSTANCE* capture_io_instance = (CAPTURE_IO_INSTANCE*)capture_io;
+        uint64_t callback_count = capture_io_instance->stats.callback_count;
+
+        capture_io_instance->stats.dowork_count++;
+
+        /* Codes_SRS_CAPTURE_IO_01_039: [ capture_io_dowork and capture_io_dowork_ex shall call xio_dowork and xio_dowork_ex on the underlying IO. ]*/
+        xio_dowork(capture_io_instance->underlying_io);
+
+        if (capture_io_instance->stats.callback_count == callback_count)
+        {
+            capture_io_instance->stats.idle_dowork_count++;
+        }
+    }
+}
+
+static int capture_io_dowork_ex(CONCRETE_IO_HANDLE capture_io, bool* made_progress, uint64_t* next_deadline_us)
+{
+    int result;
+
+    if (capture_io == NULL)
+    {
+        LogError("NULL capture_io.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        CAPTURE_IO_INSTANCE* capture_io_instance = (CAPTURE_IO_INSTANCE*)capture_io;
+        uint64_t callback_count = capture_io_instance->stats.callback_count;
+
+        capture_io_instance->stats.dowork_count++;
+
+        /* Codes_SRS_CAPTURE_IO_01_039: [ capture_io_dowork and capture_io_dowork_ex shall call xio_dowork and xio_dowork_ex on the underlying IO. ]*/
+        result = xio_dowork_ex(capture_io_instance->underlying_io, made_progress, next_deadline_us);
+
+        if (capture_io_instance->stats.callback_count == callback_count)
+        {
+            capture_io_instance->stats.idle_dowork_count++;
+        }
+    }
+
+    return result;
+}
+
+static int capture_io_get_pollable_handle(CONCRETE_IO_HANDLE capture_io, intptr_t* pollable_handle, unsigned int* wanted_events)
+{
+    int result;
+
+    if (capture_io == NULL)
+    {
+        LogError("NULL capture_io.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CAPTURE_IO_01_041: [ capture_io_get_pollable_handle, capture_io_set_receive_buffer, capture_io_set_option and capture_io_retrieve_options shall return the result of the same call on the underlying IO. ]*/
+        result = xio_get_pollable_handle(((CAPTURE_IO_INSTANCE*)capture_io)->underlying_io, pollable_handle, wanted_events);
+    }
+
+    return result;
+}
+
+static int capture_io_get_stats(CONCRETE_IO_HANDLE capture_io, XIO_STATS* stats, size_t stats_count, size_t* layer_count)
+{
+    int result;
+
+    if ((capture_io == NULL) ||
+        (stats == NULL) ||
+        (stats_count == 0) ||
+        (layer_count == NULL))
+    {
+        LogError("Bad arguments: capture_io = %p, stats = %p, stats_count = %lu, layer_count = %p.",
+            capture_io, stats, (unsigned long)stats_count, layer_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        CAPTURE_IO_INSTANCE* capture_io_instance = (CAPTURE_IO_INSTANCE*)capture_io;
+        size_t underlying_layer_count;
+
+        /* Codes_SRS_CAPTURE_IO_01_042: [ capture_io_get_stats shall fill the first entry of stats with the counters of the capture IO and the following ones by calling xio_get_stats on the underlying IO. ]*/
+        stats[0] = capture_io_instance->stats;
+
+        if ((stats_count > 1) &&
+            (xio_get_stats(capture_io_instance->underlying_io, &stats[1], stats_count - 1, &underlying_layer_count) == 0))
+        {
+            *layer_count = 1 + underlying_layer_count;
+        }
+        else
+        {
+            *layer_count = 1;
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+static int capture_io_set_receive_buffer(CONCRETE_IO_HANDLE capture_io, unsigned char* buffer, size_t size)
+{
+    int result;
+
+    if (capture_io == NULL)
+    {
+        LogError("NULL capture_io.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CAPTURE_IO_01_041: [ capture_io_get_pollable_handle, capture_io_set_receive_buffer, capture_io_set_option and capture_io_retrieve_options shall return the result of the same call on the underlying IO. ]*/
+        result = xio_set_receive_buffer(((CAPTURE_IO_INSTANCE*)capture_io)->underlying_io, buffer, size);
+    }
+
+    return result;
+}
+
+static int capture_io_set_option(CONCRETE_IO_HANDLE capture_io, const char* option_name, const void* value)
+{
+    int result;
+
+    if ((capture_io == NULL) || (option_name == NULL))
+    {
+        LogError("Bad arguments: capture_io = %p, option_name = %p", capture_io, option_name);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_CAPTURE_IO_01_041: [ capture_io_get_pollable_handle, capture_io_set_receive_buffer, capture_io_set_option and capture_io_retrieve_options shall return the result of the same call on the underlying IO. ]*/
+        result = xio_setoption(((CAPTURE_IO_INSTANCE*)capture_io)->underlying_io, option_name, value);
+    }
+
+    return result;
+}
+
+static OPTIONHANDLER_HANDLE capture_io_retrieve_options(CONCRETE_IO_HANDLE capture_io)
+{
+    OPTIONHANDLER_HANDLE result;
+
+    if (capture_io == NULL)
+    {
+        LogError("invalid parameter detected: CONCRETE_IO_HANDLE handle=%p", capture_io);
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_CAPTURE_IO_01_041: [ capture_io_get_pollable_handle, capture_io_set_receive_buffer, capture_io_set_option and capture_io_retrieve_options shall return the result of the same call on the underlying IO. ]*/
+        result = xio_retrieveoptions(((CAPTURE_IO_INSTANCE*)capture_io)->underlying_io);
+    }
+
+    return result;
+}
+
+static const IO_INTERFACE_DESCRIPTION capture_io_interface_description =
+{
+    capture_io_retrieve_options,
+    capture_io_create,
+    capture_io_destroy,
+    capture_io_open,
+    capture_io_close,
+    capture_io_send,
+    capture_io_dowork,
+    capture_io_set_option,
+    capture_io_sendv,
+    capture_io_send_constbuffer_array,
+    capture_io_get_stats,
+    capture_io_dowork_ex,
+    capture_io_get_pollable_handle,
+    capture_io_set_receive_buffer
+};
+
+const IO_INTERFACE_DESCRIPTION* capture_io_get_interface_description(void)
+{
+    /* Codes_SRS_CAPTURE_IO_01_043: [ capture_io_get_interface_description shall return a pointer to an IO_INTERFACE_DESCRIPTION structure that contains pointers to the functions of the capture IO. ]*/
+    return &capture_io_interface_description;
+}
@@ -1,155 +1,545 @@
 // Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/connection_string_parser.h"
 #include "azure_c_shared_utility/map.h"
 #include "azure_c_shared_utility/strings.h"
-#include "azure_c_shared_utility/string_tokenizer.h"
-#include <stdbool.h>
+#include "azure_c_shared_utility/string_token.h"
+#include "azure_c_shared_utility/lock.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
 
+#define CONNECTION_STRING_CACHE_BUCKETS 256
 
-MAP_HANDLE connectionstringparser_parse_from_char(const char* connection_string)
+static const char* KEY_DELIMITERS[] = { "=" };
+static const char* VALUE_DELIMITERS[] = { ";" };
+
+typedef int(*ON_CONNECTION_STRING_PAIR)(void* context, const char* key, const char* value);
+
+typedef struct CONNECTION_STRING_PAIR_TAG
+{
+    const char* key;
+    const char* value;
+} CONNECTION_STRING_PAIR;
+
+/* The fields handed out to callers point into text, which holds the connection string (the cache key)
+   followed by a copy of it in which the keys and values are null-terminated in place. */
+typedef struct CONNECTION_STRING_INSTANCE_TAG
+{
+    CONNECTION_STRING fields;
+    size_t hash;
+    size_t length;
+    char* text;
+    CONNECTION_STRING_PAIR* pairs;
+    size_t pair_count;
+    size_t ref_count;
+    bool cached;
+    struct CONNECTION_STRING_INSTANCE_TAG* next;
+} CONNECTION_STRING_INSTANCE;
+
+static LOCK_HANDLE connection_string_cache_lock = NULL;
+static CONNECTION_STRING_INSTANCE* connection_string_cache[CONNECTION_STRING_CACHE_BUCKETS];
+
+/* buffer holds length characters followed by a null-terminator; on_pair is called for each key/value pair, with both null-terminated in place */
+static int tokenize_pairs(char* buffer, size_t length, ON_CONNECTION_STRING_PAIR on_pair, void* context)
+{
+    int result = 0;
+    STRING_TOKEN_VIEW view;
+
+    /* Codes_SRS_CONNECTIONSTRINGPARSER_01_004: [connectionstringparser_parse shall start scanning at the beginning of the connection string.] */
+    (void)StringToken_InitView(&view, buffer, length);
+
+    /* Codes_SRS_CONNECTIONSTRINGPARSER_01_005: [The following actions shall be repeated until parsing is complete:] */
+    /* Codes_SRS_CONNECTIONSTRINGPARSER_01_006: [connectionstringparser_parse shall find a token (the key of the key/value pair) delimited by the = character, by calling StringToken_NextView.] */
+    while (StringToken_NextView(&view, KEY_DELIMITERS, 1))
+    {
+        char* key = buffer + (view.value - buffer);
+        size_t key_length = view.length;
+
+        if (view.delimiter == NULL)
+        {
+            /* Codes_SRS_CONNECTIONSTRINGPARSER_01_007: [If the remainder of the connection string is empty, parsing shall be considered complete.] */
+            if (key_length != 0)
+            {
+                /* Codes_SRS_CONNECTIONSTRINGPARSER_01_020: [If the remainder of the connection string is not empty and has no = character, connectionstringparser_parse shall fail and return NULL (freeing the allocated result map).] */
+                LogError("Key token without a value in the connection string.");
+                result = __FAILURE__;
+            }
+            break;
+        }
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_019: [If the key length is zero then connectionstringparser_parse shall fail and return NULL (freeing the allocated result map).] */
+        else if (key_length == 0)
+        {
+            LogError("The key token is empty.");
+            result = __FAILURE__;
+            break;
+        }
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_008: [connectionstringparser_parse shall find a token (the value of the key/value pair) delimited by the ; character or the end of the connection string, by calling StringToken_NextView.] */
+        else if (!StringToken_NextView(&view, VALUE_DELIMITERS, 1) ||
+            /* Codes_SRS_CONNECTIONSTRINGPARSER_01_009: [If the value token is empty, connectionstringparser_parse shall fail and return NULL (freeing the allocated result map).] */
+            (view.length == 0))
+        {
+            LogError("Error reading value token from the connection string.");
+            result = __FAILURE__;
+            break;
+        }
+        else
+        {
+            char* value = buffer + (view.value - buffer);
+
+            /* Codes_SRS_CONNECTIONSTRINGPARSER_01_011: [The key and value shall be null-terminated in place, by overwriting the delimiter that follows them in the copy of the connection string.] */
+            key[key_length] = '\0';
+            value[view.length] = '\0';
+
+            if (on_pair(context, key, value) != 0)
+            {
+                result = __FAILURE__;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+static int add_pair_to_map(void* context, const char* key, const char* value)
+{
+    int result;
+
+    /* Codes_SRS_CONNECTIONSTRINGPARSER_01_010: [The key and value shall be added to the result map by using Map_Add.] */
+    if (Map_Add((MAP_HANDLE)context, key, value) != 0)
+    {
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_012: [If Map_Add fails connectionstringparser_parse shall fail and return NULL (freeing the allocated result map).] */
+        LogError("Could not add the key/value pair to the result map.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static MAP_HANDLE parse_connection_string(const char* connection_string, size_t length)
 {
     MAP_HANDLE result;
-    STRING_HANDLE connString = NULL;
+    char* buffer;
 
-    /* Codes_SRS_CONNECTIONSTRINGPARSER_21_020: [connectionstringparser_parse_from_char shall create a STRING_HANDLE from the connection_string passed in as argument and parse it using the connectionstringparser_parse.]*/
-    if ((connString = STRING_construct(connection_string)) == NULL)
+    /* Codes_SRS_CONNECTIONSTRINGPARSER_01_003: [connectionstringparser_parse shall make a single copy of the connection string, in which the key and value tokens are null-terminated in place.] */
+    if ((buffer = (char*)malloc(length + 1)) == NULL)
     {
-        /* Codes_SRS_CONNECTIONSTRINGPARSER_21_021: [If connectionstringparser_parse_from_char get error creating a STRING_HANDLE, it shall return NULL.]*/
-        LogError("Error constructing connection String");
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_015: [If allocating the copy of the connection string fails, connectionstringparser_parse shall fail and return NULL.] */
         result = NULL;
+        LogError("Error allocating the connection string copy.");
     }
     else
     {
-        result = connectionstringparser_parse(connString);
-        STRING_delete(connString);
+        (void)memcpy(buffer, connection_string, length);
+        buffer[length] = '\0';
+
+        result = Map_Create(NULL);
+        if (result == NULL)
+        {
+            /* Codes_SRS_CONNECTIONSTRINGPARSER_01_018: [If creating the result map fails, then connectionstringparser_parse shall return NULL.] */
+            LogError("Error creating Map.");
+        }
+        else if (tokenize_pairs(buffer, length, add_pair_to_map, result) != 0)
+        {
+            LogError("Error parsing connection string.");
+            Map_Destroy(result);
+            result = NULL;
+        }
+
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_014: [After the parsing is complete the copy of the connection string shall be freed.] */
+        free(buffer);
     }
 
     return result;
 }
 
-/* Codes_SRS_CONNECTIONSTRINGPARSER_01_001: [connectionstringparser_parse shall parse all key value pairs from the connection_string passed in as argument and return a new map that holds the key/value pairs.] */
-MAP_HANDLE connectionstringparser_parse(STRING_HANDLE connection_string)
+static size_t hash_connection_string(const char* connection_string, size_t length)
 {
-    MAP_HANDLE result;
+    /*FNV-1a*/
+    size_t hash = (size_t)2166136261u;
+    size_t i;
 
-    if (connection_string == NULL)
+    for (i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char)connection_string[i];
+        hash *= (size_t)16777619u;
+    }
+
+    return hash;
+}
+
+static const char** get_field_slot(CONNECTION_STRING* fields, const char* key)
+{
+    const char** result;
+
+    if (strcmp(key, "HostName") == 0)
+    {
+        result = &fields->host_name;
+    }
+    else if (strcmp(key, "DeviceId") == 0)
+    {
+        result = &fields->device_id;
+    }
+    else if (strcmp(key, "ModuleId") == 0)
+    {
+        result = &fields->module_id;
+    }
+    else if (strcmp(key, "SharedAccessKeyName") == 0)
+    {
+        result = &fields->shared_access_key_name;
+    }
+    else if (strcmp(key, "SharedAccessKey") == 0)
+    {
+        result = &fields->shared_access_key;
+    }
+    else if (strcmp(key, "SharedAccessSignature") == 0)
+    {
+        result = &fields->shared_access_signature;
+    }
+    else if (strcmp(key, "GatewayHostName") == 0)
+    {
+        result = &fields->gateway_host_name;
+    }
+    else
     {
-        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_002: [If connection_string is NULL then connectionstringparser_parse shall fail and return NULL.] */
         result = NULL;
-        LogError("NULL connection string passed to tokenizer.");
+    }
+
+    return result;
+}
+
+static int add_pair_to_instance(void* context, const char* key, const char* value)
+{
+    int result;
+    CONNECTION_STRING_INSTANCE* instance = (CONNECTION_STRING_INSTANCE*)context;
+    size_t i;
+
+    for (i = 0; i < instance->pair_count; i++)
+    {
+        if (strcmp(instance->pairs[i].key, key) == 0)
+        {
+            break;
+        }
+    }
+
+    if (i < instance->pair_count)
+    {
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_027: [If a key occurs more than once, connectionstringparser_acquire shall fail and return NULL.] */
+        LogError("Key %s occurs more than once in the connection string.", key);
+        result = __FAILURE__;
     }
     else
     {
-        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_003: [connectionstringparser_parse shall create a STRING tokenizer to be used for parsing the connection string, by calling STRING_TOKENIZER_create.] */
-        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_004: [connectionstringparser_parse shall start scanning at the beginning of the connection string.] */
-        STRING_TOKENIZER_HANDLE tokenizer = STRING_TOKENIZER_create(connection_string);
-        if (tokenizer == NULL)
+        const char** slot;
+
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_026: [connectionstringparser_acquire shall store the values of HostName, DeviceId, ModuleId, SharedAccessKeyName, SharedAccessKey, SharedAccessSignature and GatewayHostName in the corresponding fields of the result, which are NULL for the keys that are absent.] */
+        if ((slot = get_field_slot(&instance->fields, key)) != NULL)
         {
-            /* Codes_SRS_CONNECTIONSTRINGPARSER_01_015: [If STRING_TOKENIZER_create fails, connectionstringparser_parse shall fail and return NULL.] */
+            *slot = value;
+        }
+
+        instance->pairs[instance->pair_count].key = key;
+        instance->pairs[instance->pair_count].value = value;
+        instance->pair_count++;
+        result = 0;
+    }
+
+    return result;
+}
+
+static void free_instance(CONNECTION_STRING_INSTANCE* instance)
+{
+    free(instance->pairs);
+    free(instance->text);
+    free(instance);
+}
+
+static CONNECTION_STRING_INSTANCE* parse_instance(const char* connection_string, size_t length, size_t hash)
+{
+    CONNECTION_STRING_INSTANCE* result;
+
+    if ((result = (CONNECTION_STRING_INSTANCE*)malloc(sizeof(CONNECTION_STRING_INSTANCE))) == NULL)
+    {
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_028: [If any failure occurs, connectionstringparser_acquire shall fail and return NULL.] */
+        LogError("Error allocating the parsed connection string.");
+    }
+    else
+    {
+        size_t max_pair_count = 0;
+        size_t i;
+
+        (void)memset(result, 0, sizeof(CONNECTION_STRING_INSTANCE));
+        result->hash = hash;
+        result->length = length;
+        result->ref_count = 1;
+
+        for (i = 0; i < length; i++)
+        {
+            if (connection_string[i] == '=')
+            {
+                max_pair_count++;
+            }
+        }
+
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_025: [connectionstringparser_acquire shall parse the connection string the same way as connectionstringparser_parse_from_char, in a single copy of it that the fields of the result point into.] */
+        if (((result->text = (char*)malloc(2 * (length + 1))) == NULL) ||
+            ((max_pair_count != 0) && ((result->pairs = (CONNECTION_STRING_PAIR*)malloc(max_pair_count * sizeof(CONNECTION_STRING_PAIR))) == NULL)))
+        {
+            /* Codes_SRS_CONNECTIONSTRINGPARSER_01_028: [If any failure occurs, connectionstringparser_acquire shall fail and return NULL.] */
+            LogError("Error allocating the parsed connection string.");
+            free_instance(result);
             result = NULL;
-            LogError("Error creating STRING tokenizer.");
         }
         else
         {
-            /* Codes_SRS_CONNECTIONSTRINGPARSER_01_016: [2 STRINGs shall be allocated in order to hold the to be parsed key and value tokens.] */
-            STRING_HANDLE token_key_string = STRING_new();
-            if (token_key_string == NULL)
+            char* buffer = result->text + length + 1;
+
+            (void)memcpy(result->text, connection_string, length);
+            result->text[length] = '\0';
+            (void)memcpy(buffer, connection_string, length + 1);
+
+            if (tokenize_pairs(buffer, length, add_pair_to_instance, result) != 0)
             {
-                /* Codes_SRS_CONNECTIONSTRINGPARSER_01_017: [If allocating the STRINGs fails connectionstringparser_parse shall fail and return NULL.] */
+                /* Codes_SRS_CONNECTIONSTRINGPARSER_01_028: [If any failure occurs, connectionstringparser_acquire shall fail and return NULL.] */
+                LogError("Error parsing connection string.");
+                free_instance(result);
                 result = NULL;
-                LogError("Error creating key token STRING.");
             }
-            else
+        }
+    }
+
+    return result;
+}
+
+int connectionstringparser_cache_init(void)
+{
+    int result;
+
+    if (connection_string_cache_lock != NULL)
+    {
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_022: [If the cache is already initialized, connectionstringparser_cache_init shall fail and return a non-zero value.] */
+        LogError("The connection string cache is already initialized");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_CONNECTIONSTRINGPARSER_01_021: [connectionstringparser_cache_init shall create the lock guarding the process wide cache and return 0.] */
+    else if ((connection_string_cache_lock = Lock_Init()) == NULL)
+    {
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_023: [If Lock_Init fails, connectionstringparser_cache_init shall fail and return a non-zero value.] */
+        LogError("Failure creating the connection string cache lock");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+void connectionstringparser_cache_deinit(void)
+{
+    if (connection_string_cache_lock != NULL)
+    {
+        size_t i;
+
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_024: [connectionstringparser_cache_deinit shall remove all the parsed connection strings from the cache and free the cache lock; they shall be freed by their last connectionstringparser_release.] */
+        for (i = 0; i < CONNECTION_STRING_CACHE_BUCKETS; i++)
+        {
+            while (connection_string_cache[i] != NULL)
+            {
+                CONNECTION_STRING_INSTANCE* instance = connection_string_cache[i];
+                connection_string_cache[i] = instance->next;
+                instance->cached = false;
+                instance->next = NULL;
+            }
+        }
+
+        Lock_Deinit(connection_string_cache_lock);
+        connection_string_cache_lock = NULL;
+    }
+}
+
+const CONNECTION_STRING* connectionstringparser_acquire(const char* connection_string)
+{
+    CONNECTION_STRING_INSTANCE* result;
+
+    if (connection_string == NULL)
+    {
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_029: [If connection_string is NULL, connectionstringparser_acquire shall fail and return NULL.] */
+        LogError("invalid parameter detected: connection_string=NULL");
+        result = NULL;
+    }
+    else
+    {
+        size_t length = strlen(connection_string);
+        size_t hash = hash_connection_string(connection_string, length);
+
+        if (connection_string_cache_lock == NULL)
+        {
+            /* Codes_SRS_CONNECTIONSTRINGPARSER_01_030: [If the cache is not initialized, connectionstringparser_acquire shall return a parsed connection string that is not shared.] */
+            result = parse_instance(connection_string, length, hash);
+        }
+        else if (Lock(connection_string_cache_lock) != LOCK_OK)
+        {
+            /* Codes_SRS_CONNECTIONSTRINGPARSER_01_028: [If any failure occurs, connectionstringparser_acquire shall fail and return NULL.] */
+            LogError("Failure locking the connection string cache");
+            result = NULL;
+        }
+        else
+        {
+            CONNECTION_STRING_INSTANCE** bucket = &connection_string_cache[hash % CONNECTION_STRING_CACHE_BUCKETS];
+
+            /* Codes_SRS_CONNECTIONSTRINGPARSER_01_031: [The cache shall be keyed by a hash of the connection string, and entries with the same hash shall be compared with the full connection string.] */
+            result = *bucket;
+            while ((result != NULL) &&
+                ((result->hash != hash) || (result->length != length) || (memcmp(result->text, connection_string, length) != 0)))
+            {
+                result = result->next;
+            }
+
+            if (result != NULL)
+            {
+                /* Codes_SRS_CONNECTIONSTRINGPARSER_01_032: [If the same connection string is in the cache, connectionstringparser_acquire shall increment its reference count and return it without parsing the connection string.] */
+                result->ref_count++;
+            }
+            /* Codes_SRS_CONNECTIONSTRINGPARSER_01_033: [Otherwise connectionstringparser_acquire shall parse the connection string and add the result to the cache.] */
+            else if ((result = parse_instance(connection_string, length, hash)) != NULL)
+            {
+                result->cached = true;
+                result->next = *bucket;
+                *bucket = result;
+            }
+
+            (void)Unlock(connection_string_cache_lock);
+        }
+    }
+
+    return (result == NULL) ? NULL : &result->fields;
+}
+
+void connectionstringparser_release(const CONNECTION_STRING* parsed)
+{
+    CONNECTION_STRING_INSTANCE* instance = (CONNECTION_STRING_INSTANCE*)parsed;
+
+    if (instance == NULL)
+    {
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_034: [If parsed is NULL, connectionstringparser_release shall return.] */
+        LogError("invalid parameter detected: parsed=NULL");
+    }
+    else if (!instance->cached)
+    {
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_035: [connectionstringparser_release shall decrement the reference count of parsed and free it, removing it from the cache, when it reaches 0.] */
+        if (--instance->ref_count == 0)
+        {
+            free_instance(instance);
+        }
+    }
+    else if (Lock(connection_string_cache_lock) != LOCK_OK)
+    {
+        LogError("Failure locking the connection string cache");
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_035: [connectionstringparser_release shall decrement the reference count of parsed and free it, removing it from the cache, when it reaches 0.] */
+        if (--instance->ref_count == 0)
+        {
+            CONNECTION_STRING_INSTANCE** entry = &connection_string_cache[instance->hash % CONNECTION_STRING_CACHE_BUCKETS];
+
+            while ((*entry != NULL) && (*entry != instance))
             {
-                STRING_HANDLE token_value_string = STRING_new();
-                if (token_value_string == NULL)
-                {
-                    /* Codes_SRS_CONNECTIONSTRINGPARSER_01_017: [If allocating the STRINGs fails connectionstringparser_parse shall fail and return NULL.] */
-                    result = NULL;
-                    LogError("Error creating value token STRING.");
-                }
-                else
-                {
-                    result = Map_Create(NULL);
-                    if (result == NULL)
-                    {
-                        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_018: [If creating the result map fails, then connectionstringparser_parse shall return NULL.] */
-                        LogError("Error creating Map.");
-                    }
-                    else
-                    {
-                        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_005: [The following actions shall be repeated until parsing is complete:] */
-                        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_006: [connectionstringparser_parse shall find a token (the key of the key/value pair) delimited by the = character, by calling STRING_TOKENIZER_get_next_token.] */
-                        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_007: [If STRING_TOKENIZER_get_next_token fails, parsing shall be considered complete.] */
-                        while (STRING_TOKENIZER_get_next_token(tokenizer, token_key_string, "=") == 0)
-                        {
-                            bool is_error = false;
-
-                            /* Codes_SRS_CONNECTIONSTRINGPARSER_01_008: [connectionstringparser_parse shall find a token (the value of the key/value pair) delimited by the ; character, by calling STRING_TOKENIZER_get_next_token.] */
-                            if (STRING_TOKENIZER_get_next_token(tokenizer, token_value_string, ";") != 0)
-                            {
-                                /* Codes_SRS_CONNECTIONSTRINGPARSER_01_009: [If STRING_TOKENIZER_get_next_token fails, connectionstringparser_parse shall fail and return NULL (freeing the allocated result map).] */
-                                is_error = true;
-                                LogError("Error reading value token from the connection string.");
-                            }
-                            else
-                            {
-                                /* Codes_SRS_CONNECTIONSTRINGPARSER_01_011: [The C strings for the key and value shall be extracted from the previously parsed STRINGs by using STRING_c_str.] */
-                                const char* token = STRING_c_str(token_key_string);
-                                /* Codes_SRS_CONNECTIONSTRINGPARSER_01_013: [If STRING_c_str fails then connectionstringparser_parse shall fail and return NULL (freeing the allocated result map).] */
-                                if ((token == NULL) ||
-                                    /* Codes_SRS_CONNECTIONSTRINGPARSER_01_019: [If the key length is zero then connectionstringparser_parse shall fail and return NULL (freeing the allocated result map).] */
-                                    (strlen(token) == 0))
-                                {
-                                    is_error = true;
-                                    LogError("The key token is NULL or empty.");
-                                }
-                                else
-                                {
-                                    /* Codes_SRS_CONNECTIONSTRINGPARSER_01_011: [The C strings for the key and value shall be extracted from the previously parsed STRINGs by using STRING_c_str.] */
-                                    const char* value = STRING_c_str(token_value_string);
-                                    if (value == NULL)
-                                    {
-                                        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_013: [If STRING_c_str fails then connectionstringparser_parse shall fail and return NULL (freeing the allocated result map).] */
-                                        is_error = true;
-                                        LogError("Could not get C string for value token.");
-                                    }
-                                    else
-                                    {
-                                        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_010: [The key and value shall be added to the result map by using Map_Add.] */
-                                        if (Map_Add(result, token, value) != 0)
-                                        {
-                                            /* Codes_SRS_CONNECTIONSTRINGPARSER_01_012: [If Map_Add fails connectionstringparser_parse shall fail and return NULL (freeing the allocated result map).] */
-                                            is_error = true;
-                                            LogError("Could not add the key/value pair to the result map.");
-                                        }
-                                    }
-                                }
-                            }
-
-                            if (is_error)
-                            {
-                                LogError("Error parsing connection string.");
-                                Map_Destroy(result);
-                                result = NULL;
-                                break;
-                            }
-                        }
-                    }
-
-                    STRING_delete(token_value_string);
-                }
-
-                STRING_delete(token_key_string);
+                entry = &(*entry)->next;
+            }
+            if (*entry != NULL)
+            {
+                *entry = instance->next;
             }
 
-            /* Codes_SRS_CONNECTIONSTRINGPARSER_01_014: [After the parsing is complete the previously allocated STRINGs and STRING tokenizer shall be freed by calling STRING_TOKENIZER_destroy.] */
-            STRING_TOKENIZER_destroy(tokenizer);
+            free_instance(instance);
         }
+
+        (void)Unlock(connection_string_cache_lock);
+    }
+}
+
+const char* connectionstringparser_get_value(const CONNECTION_STRING* parsed, const char* key)
+{
+    const char* result;
+
+    if ((parsed == NULL) || (key == NULL))
+    {
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_036: [If parsed or key is NULL, connectionstringparser_get_value shall return NULL.] */
+        LogError("invalid parameter detected: parsed=%p, key=%p", parsed, key);
+        result = NULL;
+    }
+    else
+    {
+        const CONNECTION_STRING_INSTANCE* instance = (const CONNECTION_STRING_INSTANCE*)parsed;
+        size_t i;
+
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_037: [connectionstringparser_get_value shall return the value of key in parsed, or NULL if parsed has no such key.] */
+        result = NULL;
+        for (i = 0; i < instance->pair_count; i++)
+        {
+            if (strcmp(instance->pairs[i].key, key) == 0)
+            {
+                result = instance->pairs[i].value;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+MAP_HANDLE connectionstringparser_parse_from_char(const char* connection_string)
+{
+    MAP_HANDLE result;
+
+    if (connection_string == NULL)
+    {
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_21_021: [If connection_string is NULL then connectionstringparser_parse_from_char shall fail and return NULL.]*/
+        LogError("NULL connection string passed to tokenizer.");
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_21_020: [connectionstringparser_parse_from_char shall parse the connection_string passed in as argument in the same way as connectionstringparser_parse, without creating a STRING_HANDLE.]*/
+        result = parse_connection_string(connection_string, strlen(connection_string));
+    }
+
+    return result;
+}
+
+/* Codes_SRS_CONNECTIONSTRINGPARSER_01_001: [connectionstringparser_parse shall parse all key value pairs from the connection_string passed in as argument and return a new map that holds the key/value pairs.] */
+MAP_HANDLE connectionstringparser_parse(STRING_HANDLE connection_string)
+{
+    MAP_HANDLE result;
+    const char* connection_string_value;
+
+    if (connection_string == NULL)
+    {
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_002: [If connection_string is NULL then connectionstringparser_parse shall fail and return NULL.] */
+        result = NULL;
+        LogError("NULL connection string passed to tokenizer.");
+    }
+    else if ((connection_string_value = STRING_c_str(connection_string)) == NULL)
+    {
+        /* Codes_SRS_CONNECTIONSTRINGPARSER_01_013: [If STRING_c_str fails then connectionstringparser_parse shall fail and return NULL.] */
+        result = NULL;
+        LogError("Could not get C string for the connection string.");
+    }
+    else
+    {
+        result = parse_connection_string(connection_string_value, STRING_length(connection_string));
     }
 
     return result;
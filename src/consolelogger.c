@@ -1,11 +1,81 @@
 // Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
+#if defined(__linux__) && !defined(_DEFAULT_SOURCE)
+/* ctime_r */
+#define _DEFAULT_SOURCE
+#endif
+
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
 #include <time.h>
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/consolelogger.h"
+#include "azure_c_shared_utility/tickcounter.h"
+
+#if defined(_MSC_VER)
+#define CONSOLELOGGER_THREAD_LOCAL __declspec(thread)
+#else
+#define CONSOLELOGGER_THREAD_LOCAL __thread
+#endif
+
+/* ctime writes at most 26 characters, the line feed and the terminator included */
+#define CONSOLELOGGER_TIMESTAMP_SIZE 26
+
+/* Each thread keeps the last second it formatted, so that a burst of lines calls ctime once
+   per second instead of once per line, and never through the buffer ctime shares between threads. */
+static CONSOLELOGGER_THREAD_LOCAL time_t cached_second = (time_t)-1;
+static CONSOLELOGGER_THREAD_LOCAL char cached_timestamp[CONSOLELOGGER_TIMESTAMP_SIZE];
+
+static bool monotonic_timestamp = false;
+
+static const char* get_timestamp(void)
+{
+    time_t t = time(NULL);
+    if (t != cached_second)
+    {
+#if defined(_MSC_VER)
+        if (ctime_s(cached_timestamp, sizeof(cached_timestamp), &t) != 0)
+        {
+            cached_timestamp[0] = '\0';
+        }
+#elif defined(__unix__) || defined(__APPLE__)
+        if (ctime_r(&t, cached_timestamp) == NULL)
+        {
+            cached_timestamp[0] = '\0';
+        }
+#else
+        const char* text = ctime(&t);
+        if (text == NULL)
+        {
+            cached_timestamp[0] = '\0';
+        }
+        else
+        {
+            (void)strncpy(cached_timestamp, text, sizeof(cached_timestamp) - 1);
+            cached_timestamp[sizeof(cached_timestamp) - 1] = '\0';
+        }
+#endif
+        cached_second = t;
+    }
+    return cached_timestamp;
+}
+
+static void print_monotonic_timestamp(void)
+{
+    tickcounter_us_t now;
+    if (monotonic_timestamp &&
+        (tickcounter_get_monotonic_us(&now) == 0))
+    {
+        (void)printf("[%llu.%06u] ", (unsigned long long)(now / 1000000), (unsigned int)(now % 1000000));
+    }
+}
+
+void consolelogger_set_monotonic_timestamp(bool enabled)
+{
+    monotonic_timestamp = enabled;
+}
 
 #if (defined(_MSC_VER)) && (!(defined WINCE))
 #include "windows.h"
@@ -118,7 +188,7 @@ void consolelogger_log_with_GetLastError(const char* file, const char* func, int
     DWORD lastError;
     char* lastErrorAsString;
     int lastErrorAsString_should_be_freed;
-    time_t t;
+    const char* timestamp;
     int systemMessage_should_be_freed;
     char* systemMessage;
     int userMessage_should_be_freed;
@@ -148,13 +218,13 @@ void consolelogger_log_with_GetLastError(const char* file, const char* func, int
         lastErrorAsString_should_be_freed = 1;
     }
 
-    t = time(NULL);
-    systemMessage = printf_alloc("Error: Time:%.24s File:%s Func:%s Line:%d %s", ctime(&t), file, func, line, lastErrorAsString);
+    timestamp = get_timestamp();
+    systemMessage = printf_alloc("Error: Time:%.24s File:%s Func:%s Line:%d %s", timestamp, file, func, line, lastErrorAsString);
 
     if (systemMessage == NULL)
     {
         systemMessage = "";
-        (void)printf("Error: [FAILED] Time:%.24s File : %s Func : %s Line : %d %s", ctime(&t), file, func, line, lastErrorAsString);
+        (void)printf("Error: [FAILED] Time:%.24s File : %s Func : %s Line : %d %s", timestamp, file, func, line, lastErrorAsString);
         systemMessage_should_be_freed = 0;
     }
     else
@@ -173,6 +243,7 @@ void consolelogger_log_with_GetLastError(const char* file, const char* func, int
     else
     {
         /*3. printf the system message(__FILE__, __LINE__ etc) + the last error + whatever the user wanted*/
+        print_monotonic_timestamp();
         (void)printf("%s %s\n", systemMessage, userMessage);
         userMessage_should_be_freed = 1;
     }
@@ -200,11 +271,10 @@ __attribute__ ((format (printf, 6, 7)))
 #endif
 void consolelogger_log(LOG_CATEGORY log_category, const char* file, const char* func, int line, unsigned int options, const char* format, ...)
 {
-    time_t t;
     va_list args;
     va_start(args, format);
 
-    t = time(NULL);
+    print_monotonic_timestamp();
 
     switch (log_category)
     {
@@ -212,7 +282,7 @@ void consolelogger_log(LOG_CATEGORY log_category, const char* file, const char*
         (void)printf("Info: ");
         break;
     case AZ_LOG_ERROR:
-        (void)printf("Error: Time:%.24s File:%s Func:%s Line:%d ", ctime(&t), file, func, line);
+        (void)printf("Error: Time:%.24s File:%s Func:%s Line:%d ", get_timestamp(), file, func, line);
         break;
     default:
         break;
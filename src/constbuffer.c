@@ -12,7 +12,8 @@
 #define CONSTBUFFER_TYPE_VALUES \
     CONSTBUFFER_TYPE_COPIED, \
     CONSTBUFFER_TYPE_MEMORY_MOVED, \
-    CONSTBUFFER_TYPE_WITH_CUSTOM_FREE
+    CONSTBUFFER_TYPE_WITH_CUSTOM_FREE, \
+    CONSTBUFFER_TYPE_FROM_OFFSET_AND_SIZE
 
 DEFINE_ENUM(CONSTBUFFER_TYPE, CONSTBUFFER_TYPE_VALUES)
 
@@ -23,6 +24,7 @@ typedef struct CONSTBUFFER_HANDLE_DATA_TAG
     CONSTBUFFER_TYPE buffer_type;
     CONSTBUFFER_CUSTOM_FREE_FUNC custom_free_func;
     void* custom_free_func_context;
+    CONSTBUFFER_HANDLE original_handle; /*the buffer owning the memory of a CONSTBUFFER_TYPE_FROM_OFFSET_AND_SIZE buffer*/
 } CONSTBUFFER_HANDLE_DATA;
 
 static CONSTBUFFER_HANDLE CONSTBUFFER_Create_Internal(const unsigned char* source, size_t size)
@@ -101,6 +103,52 @@ CONSTBUFFER_HANDLE CONSTBUFFER_CreateFromBuffer(BUFFER_HANDLE buffer)
     return result;
 }
 
+/*this creates a new constbuffer that takes over the memory of an existing BUFFER_HANDLE*/
+CONSTBUFFER_HANDLE CONSTBUFFER_CreateFromBufferMove(BUFFER_HANDLE buffer)
+{
+    CONSTBUFFER_HANDLE result;
+
+    if (buffer == NULL)
+    {
+        /* Codes_SRS_CONSTBUFFER_01_024: [ If buffer is NULL then CONSTBUFFER_CreateFromBufferMove shall fail and return NULL. ]*/
+        LogError("Invalid arguments: BUFFER_HANDLE buffer=%p", buffer);
+        result = NULL;
+    }
+    else
+    {
+        result = (CONSTBUFFER_HANDLE)malloc(sizeof(CONSTBUFFER_HANDLE_DATA));
+        if (result == NULL)
+        {
+            /* Codes_SRS_CONSTBUFFER_01_027: [ If any error occurs, CONSTBUFFER_CreateFromBufferMove shall fail, leave buffer unchanged and return NULL. ]*/
+            LogError("malloc failed");
+        }
+        else
+        {
+            unsigned char* memory;
+            size_t size;
+
+            /* Codes_SRS_CONSTBUFFER_01_025: [ CONSTBUFFER_CreateFromBufferMove shall take the memory of buffer by calling BUFFER_detach, without copying it, which leaves buffer empty. ]*/
+            if (BUFFER_detach(buffer, &memory, &size) != 0)
+            {
+                /* Codes_SRS_CONSTBUFFER_01_027: [ If any error occurs, CONSTBUFFER_CreateFromBufferMove shall fail, leave buffer unchanged and return NULL. ]*/
+                LogError("BUFFER_detach failed");
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                /* Codes_SRS_CONSTBUFFER_01_026: [ CONSTBUFFER_CreateFromBufferMove shall return a non-NULL handle with its ref count set to 1, which frees the memory when it is freed. ]*/
+                result->alias.buffer = memory;
+                result->alias.size = size;
+                result->buffer_type = CONSTBUFFER_TYPE_MEMORY_MOVED;
+                INIT_REF_VAR(result->count);
+            }
+        }
+    }
+
+    return result;
+}
+
 CONSTBUFFER_HANDLE CONSTBUFFER_CreateWithMoveMemory(unsigned char* source, size_t size)
 {
     CONSTBUFFER_HANDLE result;
@@ -180,6 +228,53 @@ CONSTBUFFER_HANDLE CONSTBUFFER_CreateWithCustomFree(const unsigned char* source,
     return result;
 }
 
+CONSTBUFFER_HANDLE CONSTBUFFER_CreateFromOffsetAndSize(CONSTBUFFER_HANDLE handle, size_t offset, size_t size)
+{
+    CONSTBUFFER_HANDLE result;
+
+    if (
+        /* Codes_SRS_CONSTBUFFER_01_015: [ If handle is NULL then CONSTBUFFER_CreateFromOffsetAndSize shall fail and return NULL. ]*/
+        (handle == NULL) ||
+        /* Codes_SRS_CONSTBUFFER_01_016: [ If offset is greater than the size of the buffer of handle then CONSTBUFFER_CreateFromOffsetAndSize shall fail and return NULL. ]*/
+        (offset > handle->alias.size) ||
+        /* Codes_SRS_CONSTBUFFER_01_017: [ If offset + size exceeds the size of the buffer of handle then CONSTBUFFER_CreateFromOffsetAndSize shall fail and return NULL. ]*/
+        (size > handle->alias.size - offset)
+        )
+    {
+        LogError("Invalid arguments: CONSTBUFFER_HANDLE handle=%p, size_t offset=%u, size_t size=%u",
+            handle, (unsigned int)offset, (unsigned int)size);
+        result = NULL;
+    }
+    else
+    {
+        result = (CONSTBUFFER_HANDLE)malloc(sizeof(CONSTBUFFER_HANDLE_DATA));
+        if (result == NULL)
+        {
+            /* Codes_SRS_CONSTBUFFER_01_021: [ If any error occurs, CONSTBUFFER_CreateFromOffsetAndSize shall fail and return NULL. ]*/
+            LogError("malloc failed");
+        }
+        else
+        {
+            /* Codes_SRS_CONSTBUFFER_01_019: [ If handle is itself a sub-range of another buffer, the new buffer shall refer to that other buffer, so that slicing a slice does not chain the buffers. ]*/
+            CONSTBUFFER_HANDLE original_handle = (handle->buffer_type == CONSTBUFFER_TYPE_FROM_OFFSET_AND_SIZE) ? handle->original_handle : handle;
+
+            /* Codes_SRS_CONSTBUFFER_01_018: [ CONSTBUFFER_CreateFromOffsetAndSize shall inc_ref the buffer owning the memory and keep it until the new buffer is freed. ]*/
+            INC_REF_VAR(original_handle->count);
+            result->original_handle = original_handle;
+
+            /* Codes_SRS_CONSTBUFFER_01_020: [ CONSTBUFFER_CreateFromOffsetAndSize shall return a non-NULL handle whose content is the size bytes starting at offset in the buffer of handle, without copying them. ]*/
+            result->alias.buffer = (size == 0) ? NULL : handle->alias.buffer + offset;
+            result->alias.size = size;
+            result->buffer_type = CONSTBUFFER_TYPE_FROM_OFFSET_AND_SIZE;
+
+            /* Codes_SRS_CONSTBUFFER_01_022: [ The non-NULL handle returned by CONSTBUFFER_CreateFromOffsetAndSize shall have its ref count set to 1. ]*/
+            INIT_REF_VAR(result->count);
+        }
+    }
+
+    return result;
+}
+
 void CONSTBUFFER_IncRef(CONSTBUFFER_HANDLE constbufferHandle)
 {
     if (constbufferHandle == NULL)
@@ -232,6 +327,11 @@ void CONSTBUFFER_DecRef(CONSTBUFFER_HANDLE constbufferHandle)
                 /* Codes_SRS_CONSTBUFFER_01_012: [ If the buffer was created by calling CONSTBUFFER_CreateWithCustomFree, the customFreeFunc function shall be called to free the memory, while passed customFreeFuncContext as argument. ]*/
                 constbufferHandle->custom_free_func(constbufferHandle->custom_free_func_context);
             }
+            else if (constbufferHandle->buffer_type == CONSTBUFFER_TYPE_FROM_OFFSET_AND_SIZE)
+            {
+                /* Codes_SRS_CONSTBUFFER_01_023: [ If the buffer was created by calling CONSTBUFFER_CreateFromOffsetAndSize, CONSTBUFFER_DecRef shall dec_ref the buffer owning the memory. ]*/
+                CONSTBUFFER_DecRef(constbufferHandle->original_handle);
+            }
 
             /*Codes_SRS_CONSTBUFFER_02_017: [If the refcount reaches zero, then CONSTBUFFER_DecRef shall deallocate all resources used by the CONSTBUFFER_HANDLE.]*/
             free(constbufferHandle);
@@ -12,17 +12,170 @@
 #include "azure_c_shared_utility/constbuffer_array.h"
 #include "azure_c_shared_utility/refcount.h"
 
+#if defined(_MSC_VER)
+#include <windows.h>
+/*InterlockedCompareExchange returns the initial value*/
+#define CONSTBUFFER_ARRAY_CLAIM_SLOT(slot, expected, desired) (InterlockedCompareExchange((slot), (desired), (expected)) == (expected))
+#else
+#define CONSTBUFFER_ARRAY_CLAIM_SLOT(slot, expected, desired) __sync_bool_compare_and_swap((slot), (expected), (desired))
+#endif
+
+/*the smallest number of free slots left at each end of a storage created when an array grows*/
+#define CONSTBUFFER_ARRAY_MIN_HEADROOM 4
+
+/*the slots are indexed by longs for the atomic operations, LONG is 32 bits wide on Windows*/
+#define CONSTBUFFER_ARRAY_MAX_CAPACITY ((uint32_t)INT32_MAX)
+
+/*
+* A CONSTBUFFER_ARRAY_HANDLE is a view (start, nBuffers) over a storage shared by all the arrays derived from the same array.
+* The storage holds one reference to the buffers in its used slots [used_begin, used_end) and has free slots at both ends.
+* Adding next to a view goes into the free slot next to it when the view ends at the used slots (the first array to claim a
+* slot wins, the others copy), removing makes a smaller view over the same storage. Either way only the new array is allocated,
+* and when a copy is needed the new storage has as much free room as the array has buffers, so growing an array is O(1) amortized.
+*
+* The storage also keeps offsets[i], the sum of the sizes of the buffers before slot i counted from an arbitrary base, for i in
+* [used_begin, used_end]. A slot sets the offset of its far side when it is claimed, and the used slots never change afterwards,
+* so the size of a view is the difference of the offsets at its ends and the buffer holding a given byte is a binary search.
+* The offsets are 64 bits and wrap around, only their differences are ever used.
+*/
+typedef struct CONSTBUFFER_ARRAY_STORAGE_TAG CONSTBUFFER_ARRAY_STORAGE;
+
 typedef struct CONSTBUFFER_ARRAY_HANDLE_DATA_TAG
 {
+    COUNT_TYPE count;
+    CONSTBUFFER_ARRAY_STORAGE* storage;
+    uint32_t start;
     uint32_t nBuffers;
+} CONSTBUFFER_ARRAY_HANDLE_DATA;
+
+struct CONSTBUFFER_ARRAY_STORAGE_TAG
+{
+    /*the array created together with the storage lives in the same allocation, it has to be the first member so that freeing the storage frees it*/
+    CONSTBUFFER_ARRAY_HANDLE_DATA first_array;
+    COUNT_TYPE count; /*number of arrays using the storage*/
+    volatile long used_begin;
+    volatile long used_end;
+    uint32_t capacity;
+    uint64_t* offsets; /*capacity + 1 entries, after the buffers in the same allocation*/
 #ifdef _MSC_VER
     /*warning C4200: nonstandard extension used: zero-sized array in struct/union : looks very standard in C99 and it is called flexible array. Documentation-wise is a flexible array, but called "unsized" in Microsoft's docs*/ /*https://msdn.microsoft.com/en-us/library/b6fae073.aspx*/
 #pragma warning(disable:4200)
 #endif
     CONSTBUFFER_HANDLE buffers[];
-} CONSTBUFFER_ARRAY_HANDLE_DATA;
+};
+
+#define ARRAY_BUFFERS(constbuffer_array_handle) ((constbuffer_array_handle)->storage->buffers + (constbuffer_array_handle)->start)
+#define ARRAY_OFFSETS(constbuffer_array_handle) ((constbuffer_array_handle)->storage->offsets + (constbuffer_array_handle)->start)
+
+/*the offsets follow the buffers, at the next multiple of their size*/
+#define CONSTBUFFER_ARRAY_OFFSETS_POSITION(capacity) ((sizeof(CONSTBUFFER_ARRAY_STORAGE) + (size_t)(capacity) * sizeof(CONSTBUFFER_HANDLE) + sizeof(uint64_t) - 1) / sizeof(uint64_t) * sizeof(uint64_t))
+
+static int constbuffer_array_get_size(CONSTBUFFER_HANDLE constbuffer_handle, uint64_t* size)
+{
+    int result;
+    const CONSTBUFFER* content = CONSTBUFFER_GetContent(constbuffer_handle);
+
+    if (content == NULL)
+    {
+        LogError("failure in CONSTBUFFER_GetContent(%p)", constbuffer_handle);
+        result = __FAILURE__;
+    }
+    else
+    {
+        *size = (uint64_t)content->size;
+        result = 0;
+    }
+
+    return result;
+}
+
+/*creates a storage with buffer_count used slots after headroom free slots, followed by headroom free slots, and returns the array viewing the used slots. The caller fills the used slots and the offsets after them.*/
+static CONSTBUFFER_ARRAY_HANDLE constbuffer_array_create_storage(uint32_t buffer_count, uint32_t headroom)
+{
+    CONSTBUFFER_ARRAY_HANDLE result;
+
+    if (
+        (buffer_count > CONSTBUFFER_ARRAY_MAX_CAPACITY) ||
+        (headroom > (CONSTBUFFER_ARRAY_MAX_CAPACITY - buffer_count) / 2)
+        )
+    {
+        LogError("too many buffers: uint32_t buffer_count=%" PRIu32 ", uint32_t headroom=%" PRIu32, buffer_count, headroom);
+        result = NULL;
+    }
+    else
+    {
+        uint32_t capacity = buffer_count + 2 * headroom;
+        CONSTBUFFER_ARRAY_STORAGE* storage;
+
+#if SIZE_MAX <= UINT32_MAX
+        if ((size_t)capacity > (SIZE_MAX - sizeof(CONSTBUFFER_ARRAY_STORAGE) - 2 * sizeof(uint64_t)) / (sizeof(CONSTBUFFER_HANDLE) + sizeof(uint64_t)))
+        {
+            LogError("storage size overflow: uint32_t capacity=%" PRIu32, capacity);
+            storage = NULL;
+        }
+        else
+#endif
+        {
+            storage = (CONSTBUFFER_ARRAY_STORAGE*)malloc(CONSTBUFFER_ARRAY_OFFSETS_POSITION(capacity) + ((size_t)capacity + 1) * sizeof(uint64_t));
+        }
+
+        if (storage == NULL)
+        {
+            LogError("failure in malloc");
+            result = NULL;
+        }
+        else
+        {
+            INIT_REF_VAR(storage->count);
+            storage->capacity = capacity;
+            storage->used_begin = (long)headroom;
+            storage->used_end = (long)(headroom + buffer_count);
+            storage->offsets = (uint64_t*)(void*)((unsigned char*)storage + CONSTBUFFER_ARRAY_OFFSETS_POSITION(capacity));
+            storage->offsets[headroom] = 0;
+
+            result = &storage->first_array;
+            INIT_REF_VAR(result->count);
+            result->storage = storage;
+            result->start = headroom;
+            result->nBuffers = buffer_count;
+        }
+    }
+
+    return result;
+}
+
+/*creates an array viewing buffer_count used slots of storage from start*/
+static CONSTBUFFER_ARRAY_HANDLE constbuffer_array_create_view(CONSTBUFFER_ARRAY_STORAGE* storage, uint32_t start, uint32_t buffer_count)
+{
+    CONSTBUFFER_ARRAY_HANDLE result = (CONSTBUFFER_ARRAY_HANDLE)malloc(sizeof(CONSTBUFFER_ARRAY_HANDLE_DATA));
+    if (result == NULL)
+    {
+        LogError("failure in malloc");
+    }
+    else
+    {
+        INIT_REF_VAR(result->count);
+        INC_REF_VAR(storage->count);
+        result->storage = storage;
+        result->start = start;
+        result->nBuffers = buffer_count;
+    }
+    return result;
+}
+
+static void constbuffer_array_storage_dec_ref(CONSTBUFFER_ARRAY_STORAGE* storage)
+{
+    if (DEC_REF_VAR(storage->count) == DEC_RETURN_ZERO)
+    {
+        long i;
+        for (i = storage->used_begin; i < storage->used_end; i++)
+        {
+            CONSTBUFFER_DecRef(storage->buffers[i]);
+        }
 
-DEFINE_REFCOUNT_TYPE(CONSTBUFFER_ARRAY_HANDLE_DATA);
+        free(storage);
+    }
+}
 
 CONSTBUFFER_ARRAY_HANDLE constbuffer_array_create(const CONSTBUFFER_HANDLE* buffers, uint32_t buffer_count)
 {
@@ -39,7 +192,7 @@ CONSTBUFFER_ARRAY_HANDLE constbuffer_array_create(const CONSTBUFFER_HANDLE* buff
     else
     {
         /* Codes_SRS_CONSTBUFFER_ARRAY_01_009: [ constbuffer_array_create shall allocate memory for a new CONSTBUFFER_ARRAY_HANDLE that can hold buffer_count buffers. ]*/
-        result = REFCOUNT_TYPE_CREATE_WITH_EXTRA_SIZE(CONSTBUFFER_ARRAY_HANDLE_DATA, buffer_count * sizeof(CONSTBUFFER_HANDLE));
+        result = constbuffer_array_create_storage(buffer_count, 0);
         if (result == NULL)
         {
             /* Codes_SRS_CONSTBUFFER_ARRAY_01_014: [ If any error occurs, constbuffer_array_create shall fail and return NULL. ]*/
@@ -47,18 +200,39 @@ CONSTBUFFER_ARRAY_HANDLE constbuffer_array_create(const CONSTBUFFER_HANDLE* buff
         }
         else
         {
+            uint64_t* offsets = result->storage->offsets;
             uint32_t i;
             for (i = 0; i < buffer_count; i++)
             {
-                /* Codes_SRS_CONSTBUFFER_ARRAY_01_010: [ constbuffer_array_create shall clone the buffers in buffers and store them. ]*/
-                CONSTBUFFER_IncRef(buffers[i]);
-                result->buffers[i] = buffers[i];
+                uint64_t size;
+
+                /* Codes_SRS_CONSTBUFFER_ARRAY_01_045: [ constbuffer_array_create shall get the content of each buffer by calling CONSTBUFFER_GetContent and store the sum of the sizes of the buffers before each buffer. ]*/
+                if (constbuffer_array_get_size(buffers[i], &size) != 0)
+                {
+                    break;
+                }
+
+                offsets[i + 1] = offsets[i] + size;
             }
 
-            result->nBuffers = buffer_count;
+            if (i < buffer_count)
+            {
+                /* Codes_SRS_CONSTBUFFER_ARRAY_01_014: [ If any error occurs, constbuffer_array_create shall fail and return NULL. ]*/
+                LogError("failure getting the size of buffer %" PRIu32, i);
+                free(result->storage);
+            }
+            else
+            {
+                for (i = 0; i < buffer_count; i++)
+                {
+                    /* Codes_SRS_CONSTBUFFER_ARRAY_01_010: [ constbuffer_array_create shall clone the buffers in buffers and store them. ]*/
+                    CONSTBUFFER_IncRef(buffers[i]);
+                    result->storage->buffers[i] = buffers[i];
+                }
 
-            /* Codes_SRS_CONSTBUFFER_ARRAY_01_011: [ On success constbuffer_array_create shall return a non-NULL handle. ]*/
-            goto all_ok;
+                /* Codes_SRS_CONSTBUFFER_ARRAY_01_011: [ On success constbuffer_array_create shall return a non-NULL handle. ]*/
+                goto all_ok;
+            }
         }
     }
 
@@ -73,7 +247,7 @@ CONSTBUFFER_ARRAY_HANDLE constbuffer_array_create_empty(void)
     CONSTBUFFER_ARRAY_HANDLE result;
 
     /*Codes_SRS_CONSTBUFFER_ARRAY_02_004: [ constbuffer_array_create_empty shall allocate memory for a new CONSTBUFFER_ARRAY_HANDLE. ]*/
-    result = REFCOUNT_TYPE_CREATE(CONSTBUFFER_ARRAY_HANDLE_DATA); /*explicit 0*/
+    result = constbuffer_array_create_storage(0, 0);
     if (result == NULL)
     {
         /*Codes_SRS_CONSTBUFFER_ARRAY_02_001: [ If are any failure is encountered, constbuffer_array_create_empty shall fail and return NULL. ]*/
@@ -83,7 +257,6 @@ CONSTBUFFER_ARRAY_HANDLE constbuffer_array_create_empty(void)
     else
     {
         /*Codes_SRS_CONSTBUFFER_ARRAY_02_041: [ constbuffer_array_create_empty shall succeed and return a non-NULL value. ]*/
-        result->nBuffers = 0;
     }
     return result;
 }
@@ -146,7 +319,7 @@ CONSTBUFFER_ARRAY_HANDLE constbuffer_array_create_from_array_array(const CONSTBU
             else
             {
                 /*Codes_SRS_CONSTBUFFER_ARRAY_42_003: [ constbuffer_array_create_from_array_array shall allocate memory to hold all of the CONSTBUFFER_HANDLES from buffer_arrays. ]*/
-                result = REFCOUNT_TYPE_CREATE_WITH_EXTRA_SIZE(CONSTBUFFER_ARRAY_HANDLE_DATA, (total_buffer_count) * sizeof(CONSTBUFFER_HANDLE));
+                result = constbuffer_array_create_storage(total_buffer_count, 0);
                 if (result == NULL)
                 {
                     /*Codes_SRS_CONSTBUFFER_ARRAY_42_008: [ If there are any failures then constbuffer_array_create_from_array_array shall fail and return NULL. ]*/
@@ -158,15 +331,17 @@ CONSTBUFFER_ARRAY_HANDLE constbuffer_array_create_from_array_array(const CONSTBU
                     uint32_t array_idx;
                     uint32_t source_idx;
 
-                    result->nBuffers = total_buffer_count;
-
                     for (dest_idx = 0, array_idx = 0; array_idx < buffer_array_count; ++array_idx)
                     {
+                        const CONSTBUFFER_HANDLE* source_buffers = ARRAY_BUFFERS(buffer_arrays[array_idx]);
+                        const uint64_t* source_offsets = ARRAY_OFFSETS(buffer_arrays[array_idx]);
                         for (source_idx = 0; source_idx < buffer_arrays[array_idx]->nBuffers; ++source_idx, ++dest_idx)
                         {
                             /*Codes_SRS_CONSTBUFFER_ARRAY_42_004: [ constbuffer_array_create_from_array_array shall copy all of the CONSTBUFFER_HANDLES from each const buffer array in buffer_arrays to the newly constructed array by calling CONSTBUFFER_IncRef. ]*/
-                            CONSTBUFFER_IncRef(buffer_arrays[array_idx]->buffers[source_idx]);
-                            result->buffers[dest_idx] = buffer_arrays[array_idx]->buffers[source_idx];
+                            CONSTBUFFER_IncRef(source_buffers[source_idx]);
+                            result->storage->buffers[dest_idx] = source_buffers[source_idx];
+                            /*Codes_SRS_CONSTBUFFER_ARRAY_01_046: [ constbuffer_array_create_from_array_array shall take the sizes of the buffers from the arrays in buffer_arrays. ]*/
+                            result->storage->offsets[dest_idx + 1] = result->storage->offsets[dest_idx] + (source_offsets[source_idx + 1] - source_offsets[source_idx]);
                         }
                     }
 
@@ -181,6 +356,54 @@ allOk:;
     return result;
 }
 
+/*creates a new storage holding the buffers of constbuffer_array_handle and constbuffer_handle of size constbuffer_size, in front of them or after them*/
+static CONSTBUFFER_ARRAY_HANDLE constbuffer_array_copy_and_add(CONSTBUFFER_ARRAY_HANDLE constbuffer_array_handle, CONSTBUFFER_HANDLE constbuffer_handle, uint64_t constbuffer_size, bool add_in_front)
+{
+    CONSTBUFFER_ARRAY_HANDLE result;
+    uint32_t nBuffers = constbuffer_array_handle->nBuffers;
+
+    result = constbuffer_array_create_storage(nBuffers + 1, (nBuffers < CONSTBUFFER_ARRAY_MIN_HEADROOM) ? CONSTBUFFER_ARRAY_MIN_HEADROOM : nBuffers);
+    if (result == NULL)
+    {
+        LogError("failure in constbuffer_array_create_storage");
+    }
+    else
+    {
+        const CONSTBUFFER_HANDLE* source_buffers = ARRAY_BUFFERS(constbuffer_array_handle);
+        const uint64_t* source_offsets = ARRAY_OFFSETS(constbuffer_array_handle);
+        CONSTBUFFER_HANDLE* destination_buffers = ARRAY_BUFFERS(result);
+        uint64_t* destination_offsets = ARRAY_OFFSETS(result);
+        uint32_t i;
+
+        CONSTBUFFER_IncRef(constbuffer_handle);
+        if (add_in_front)
+        {
+            destination_buffers[0] = constbuffer_handle;
+            destination_offsets[1] = constbuffer_size;
+            destination_buffers++;
+            destination_offsets++;
+        }
+        else
+        {
+            destination_buffers[nBuffers] = constbuffer_handle;
+        }
+
+        for (i = 0; i < nBuffers; i++)
+        {
+            CONSTBUFFER_IncRef(source_buffers[i]);
+            destination_buffers[i] = source_buffers[i];
+            destination_offsets[i + 1] = destination_offsets[i] + (source_offsets[i + 1] - source_offsets[i]);
+        }
+
+        if (!add_in_front)
+        {
+            destination_offsets[nBuffers + 1] = destination_offsets[nBuffers] + constbuffer_size;
+        }
+    }
+
+    return result;
+}
+
 CONSTBUFFER_ARRAY_HANDLE constbuffer_array_add_front(CONSTBUFFER_ARRAY_HANDLE constbuffer_array_handle, CONSTBUFFER_HANDLE constbuffer_handle)
 {
     CONSTBUFFER_ARRAY_HANDLE result;
@@ -195,31 +418,70 @@ CONSTBUFFER_ARRAY_HANDLE constbuffer_array_add_front(CONSTBUFFER_ARRAY_HANDLE co
     }
     else
     {
-        /*Codes_SRS_CONSTBUFFER_ARRAY_02_042: [ constbuffer_array_add_front shall allocate enough memory to hold all of constbuffer_array_handle existing CONSTBUFFER_HANDLE and constbuffer_handle. ]*/
-        result = REFCOUNT_TYPE_CREATE_WITH_EXTRA_SIZE(CONSTBUFFER_ARRAY_HANDLE_DATA, (constbuffer_array_handle->nBuffers + 1) * sizeof(CONSTBUFFER_HANDLE));
-        if (result == NULL)
+        CONSTBUFFER_ARRAY_STORAGE* storage = constbuffer_array_handle->storage;
+        long start = (long)constbuffer_array_handle->start;
+        uint64_t constbuffer_size = 0;
+        bool failed = false;
+
+        /*Codes_SRS_CONSTBUFFER_ARRAY_01_047: [ constbuffer_array_add_front shall get the size of constbuffer_handle by calling CONSTBUFFER_GetContent. ]*/
+        if (constbuffer_array_get_size(constbuffer_handle, &constbuffer_size) != 0)
         {
             /*Codes_SRS_CONSTBUFFER_ARRAY_02_011: [ If there any failures constbuffer_array_add_front shall fail and return NULL. ]*/
-            LogError("failure in malloc");
-            /*return as is*/
+            LogError("failure getting the size of the buffer");
+            failed = true;
         }
-        else
+        else if (
+            /*Codes_SRS_CONSTBUFFER_ARRAY_01_026: [ If constbuffer_array_handle starts at the first used slot of its storage and there is a free slot in front of it, constbuffer_array_add_front shall allocate a new CONSTBUFFER_ARRAY_HANDLE sharing the storage. ]*/
+            (start > 0) &&
+            (storage->used_begin == start)
+            )
         {
-            uint32_t i;
+            result = constbuffer_array_create_view(storage, (uint32_t)(start - 1), constbuffer_array_handle->nBuffers + 1);
+            if (result == NULL)
+            {
+                /*Codes_SRS_CONSTBUFFER_ARRAY_02_011: [ If there any failures constbuffer_array_add_front shall fail and return NULL. ]*/
+                LogError("failure in constbuffer_array_create_view");
+                failed = true;
+            }
+            /*Codes_SRS_CONSTBUFFER_ARRAY_01_027: [ constbuffer_array_add_front shall claim the free slot atomically, so that only one of the arrays adding in front of the same buffers uses it. ]*/
+            else if (CONSTBUFFER_ARRAY_CLAIM_SLOT(&storage->used_begin, start, start - 1))
+            {
+                /*Codes_SRS_CONSTBUFFER_ARRAY_01_028: [ constbuffer_array_add_front shall inc_ref constbuffer_handle and store it in the claimed slot. ]*/
+                CONSTBUFFER_IncRef(constbuffer_handle);
+                storage->buffers[start - 1] = constbuffer_handle;
+                storage->offsets[start - 1] = storage->offsets[start] - constbuffer_size;
+
+                /*Codes_SRS_CONSTBUFFER_ARRAY_02_010: [ constbuffer_array_add_front shall succeed and return a non-NULL value. ]*/
+                goto allOk;
+            }
+            else
+            {
+                /*another array took the slot first*/
+                constbuffer_array_dec_ref(result);
+            }
+        }
 
+        if (failed)
+        {
+            /*return NULL*/
+        }
+        else
+        {
+            /*Codes_SRS_CONSTBUFFER_ARRAY_02_042: [ Otherwise constbuffer_array_add_front shall allocate a new storage with room for all of constbuffer_array_handle existing CONSTBUFFER_HANDLE, constbuffer_handle and as many free slots at each end as there are CONSTBUFFER_HANDLE, but at least 4. ]*/
             /*Codes_SRS_CONSTBUFFER_ARRAY_02_043: [ constbuffer_array_add_front shall copy constbuffer_handle and all of constbuffer_array_handle existing CONSTBUFFER_HANDLE. ]*/
             /*Codes_SRS_CONSTBUFFER_ARRAY_02_044: [ constbuffer_array_add_front shall inc_ref all the CONSTBUFFER_HANDLE it had copied. ]*/
-            result->nBuffers = constbuffer_array_handle->nBuffers + 1;
-            CONSTBUFFER_IncRef(constbuffer_handle);
-            result->buffers[0] = constbuffer_handle;
-            for (i = 1; i < result->nBuffers; i++)
+            result = constbuffer_array_copy_and_add(constbuffer_array_handle, constbuffer_handle, constbuffer_size, true);
+            if (result == NULL)
+            {
+                /*Codes_SRS_CONSTBUFFER_ARRAY_02_011: [ If there any failures constbuffer_array_add_front shall fail and return NULL. ]*/
+                LogError("failure in constbuffer_array_copy_and_add");
+                /*return as is*/
+            }
+            else
             {
-                CONSTBUFFER_IncRef(constbuffer_array_handle->buffers[i - 1]);
-                result->buffers[i] = constbuffer_array_handle->buffers[i - 1];
+                /*Codes_SRS_CONSTBUFFER_ARRAY_02_010: [ constbuffer_array_add_front shall succeed and return a non-NULL value. ]*/
+                goto allOk;
             }
-
-            /*Codes_SRS_CONSTBUFFER_ARRAY_02_010: [ constbuffer_array_add_front shall succeed and return a non-NULL value. ]*/
-            goto allOk;
         }
     }
     /*Codes_SRS_CONSTBUFFER_ARRAY_02_011: [ If there any failures constbuffer_array_add_front shall fail and return NULL. ]*/
@@ -228,6 +490,90 @@ allOk:;
     return result;
 }
 
+CONSTBUFFER_ARRAY_HANDLE constbuffer_array_add_back(CONSTBUFFER_ARRAY_HANDLE constbuffer_array_handle, CONSTBUFFER_HANDLE constbuffer_handle)
+{
+    CONSTBUFFER_ARRAY_HANDLE result;
+    if (
+        /*Codes_SRS_CONSTBUFFER_ARRAY_01_029: [ If constbuffer_array_handle is NULL then constbuffer_array_add_back shall fail and return NULL ]*/
+        (constbuffer_array_handle == NULL) ||
+        /*Codes_SRS_CONSTBUFFER_ARRAY_01_030: [ If constbuffer_handle is NULL then constbuffer_array_add_back shall fail and return NULL ]*/
+        (constbuffer_handle == NULL)
+        )
+    {
+        LogError("invalid arguments CONSTBUFFER_ARRAY_HANDLE constbuffer_array_handle=%p, CONSTBUFFER_HANDLE constbuffer_handle=%p", constbuffer_array_handle, constbuffer_handle);
+    }
+    else
+    {
+        CONSTBUFFER_ARRAY_STORAGE* storage = constbuffer_array_handle->storage;
+        long end = (long)(constbuffer_array_handle->start + constbuffer_array_handle->nBuffers);
+        uint64_t constbuffer_size = 0;
+        bool failed = false;
+
+        /*Codes_SRS_CONSTBUFFER_ARRAY_01_048: [ constbuffer_array_add_back shall get the size of constbuffer_handle by calling CONSTBUFFER_GetContent. ]*/
+        if (constbuffer_array_get_size(constbuffer_handle, &constbuffer_size) != 0)
+        {
+            /*Codes_SRS_CONSTBUFFER_ARRAY_01_036: [ If there any failures constbuffer_array_add_back shall fail and return NULL. ]*/
+            LogError("failure getting the size of the buffer");
+            failed = true;
+        }
+        else if (
+            /*Codes_SRS_CONSTBUFFER_ARRAY_01_031: [ If constbuffer_array_handle ends at the last used slot of its storage and there is a free slot after it, constbuffer_array_add_back shall allocate a new CONSTBUFFER_ARRAY_HANDLE sharing the storage. ]*/
+            (end < (long)storage->capacity) &&
+            (storage->used_end == end)
+            )
+        {
+            result = constbuffer_array_create_view(storage, constbuffer_array_handle->start, constbuffer_array_handle->nBuffers + 1);
+            if (result == NULL)
+            {
+                /*Codes_SRS_CONSTBUFFER_ARRAY_01_036: [ If there any failures constbuffer_array_add_back shall fail and return NULL. ]*/
+                LogError("failure in constbuffer_array_create_view");
+                failed = true;
+            }
+            /*Codes_SRS_CONSTBUFFER_ARRAY_01_032: [ constbuffer_array_add_back shall claim the free slot atomically, so that only one of the arrays adding after the same buffers uses it. ]*/
+            else if (CONSTBUFFER_ARRAY_CLAIM_SLOT(&storage->used_end, end, end + 1))
+            {
+                /*Codes_SRS_CONSTBUFFER_ARRAY_01_033: [ constbuffer_array_add_back shall inc_ref constbuffer_handle and store it in the claimed slot. ]*/
+                CONSTBUFFER_IncRef(constbuffer_handle);
+                storage->buffers[end] = constbuffer_handle;
+                storage->offsets[end + 1] = storage->offsets[end] + constbuffer_size;
+
+                /*Codes_SRS_CONSTBUFFER_ARRAY_01_035: [ constbuffer_array_add_back shall succeed and return a non-NULL value. ]*/
+                goto allOk;
+            }
+            else
+            {
+                /*another array took the slot first*/
+                constbuffer_array_dec_ref(result);
+            }
+        }
+
+        if (failed)
+        {
+            /*return NULL*/
+        }
+        else
+        {
+            /*Codes_SRS_CONSTBUFFER_ARRAY_01_034: [ Otherwise constbuffer_array_add_back shall allocate a new storage with room for all of constbuffer_array_handle existing CONSTBUFFER_HANDLE, constbuffer_handle and as many free slots at each end as there are CONSTBUFFER_HANDLE, but at least 4, and copy and inc_ref all of them. ]*/
+            result = constbuffer_array_copy_and_add(constbuffer_array_handle, constbuffer_handle, constbuffer_size, false);
+            if (result == NULL)
+            {
+                /*Codes_SRS_CONSTBUFFER_ARRAY_01_036: [ If there any failures constbuffer_array_add_back shall fail and return NULL. ]*/
+                LogError("failure in constbuffer_array_copy_and_add");
+                /*return as is*/
+            }
+            else
+            {
+                /*Codes_SRS_CONSTBUFFER_ARRAY_01_035: [ constbuffer_array_add_back shall succeed and return a non-NULL value. ]*/
+                goto allOk;
+            }
+        }
+    }
+    /*Codes_SRS_CONSTBUFFER_ARRAY_01_036: [ If there any failures constbuffer_array_add_back shall fail and return NULL. ]*/
+    result = NULL;
+allOk:;
+    return result;
+}
+
 CONSTBUFFER_ARRAY_HANDLE constbuffer_array_remove_front(CONSTBUFFER_ARRAY_HANDLE constbuffer_array_handle, CONSTBUFFER_HANDLE* constbuffer_handle)
 {
     CONSTBUFFER_ARRAY_HANDLE result;
@@ -252,32 +598,23 @@ CONSTBUFFER_ARRAY_HANDLE constbuffer_array_remove_front(CONSTBUFFER_ARRAY_HANDLE
         }
         else
         {
-            /*Codes_SRS_CONSTBUFFER_ARRAY_02_046: [ constbuffer_array_remove_front shall allocate memory to hold all of constbuffer_array_handle CONSTBUFFER_HANDLEs except the front one. ]*/
-            result = REFCOUNT_TYPE_CREATE_WITH_EXTRA_SIZE(CONSTBUFFER_ARRAY_HANDLE_DATA, (constbuffer_array_handle->nBuffers - 1) * sizeof(CONSTBUFFER_HANDLE));
+            /*Codes_SRS_CONSTBUFFER_ARRAY_02_046: [ constbuffer_array_remove_front shall allocate a new CONSTBUFFER_ARRAY_HANDLE sharing the storage of constbuffer_array_handle and holding all of its CONSTBUFFER_HANDLEs except the front one. ]*/
+            result = constbuffer_array_create_view(constbuffer_array_handle->storage, constbuffer_array_handle->start + 1, constbuffer_array_handle->nBuffers - 1);
             if (result == NULL)
             {
                 /*Codes_SRS_CONSTBUFFER_ARRAY_02_036: [ If there are any failures then constbuffer_array_remove_front shall fail and return NULL. ]*/
-                LogError("failure in malloc");
+                LogError("failure in constbuffer_array_create_view");
                 /*return as is*/
             }
             else
             {
-                uint32_t i;
+                CONSTBUFFER_HANDLE front = ARRAY_BUFFERS(constbuffer_array_handle)[0];
 
                 /* Codes_SRS_CONSTBUFFER_ARRAY_01_001: [ constbuffer_array_remove_front shall inc_ref the removed buffer. ]*/
-                CONSTBUFFER_IncRef(constbuffer_array_handle->buffers[0]);
-                result->nBuffers = constbuffer_array_handle->nBuffers - 1;
-
-                /*Codes_SRS_CONSTBUFFER_ARRAY_02_047: [ constbuffer_array_remove_front shall copy all of constbuffer_array_handle CONSTBUFFER_HANDLEs except the front one. ]*/
-                /*Codes_SRS_CONSTBUFFER_ARRAY_02_048: [ constbuffer_array_remove_front shall inc_ref all the copied CONSTBUFFER_HANDLEs. ]*/
-                for (i = 1; i < constbuffer_array_handle->nBuffers; i++)
-                {
-                    CONSTBUFFER_IncRef(constbuffer_array_handle->buffers[i]);
-                    result->buffers[i - 1] = constbuffer_array_handle->buffers[i];
-                }
+                CONSTBUFFER_IncRef(front);
 
                 /*Codes_SRS_CONSTBUFFER_ARRAY_02_049: [ constbuffer_array_remove_front shall succeed, write in constbuffer_handle the front handle and return a non-NULL value. ]*/
-                *constbuffer_handle = constbuffer_array_handle->buffers[0];
+                *constbuffer_handle = front;
                 goto allOk;
             }
         }
@@ -288,6 +625,56 @@ allOk:;
     return result;
 }
 
+CONSTBUFFER_ARRAY_HANDLE constbuffer_array_remove_back(CONSTBUFFER_ARRAY_HANDLE constbuffer_array_handle, CONSTBUFFER_HANDLE* constbuffer_handle)
+{
+    CONSTBUFFER_ARRAY_HANDLE result;
+    if (
+        /*Codes_SRS_CONSTBUFFER_ARRAY_01_037: [ If constbuffer_array_handle is NULL then constbuffer_array_remove_back shall fail and return NULL. ]*/
+        (constbuffer_array_handle == NULL) ||
+        /*Codes_SRS_CONSTBUFFER_ARRAY_01_038: [ If constbuffer_handle is NULL then constbuffer_array_remove_back shall fail and return NULL. ]*/
+        (constbuffer_handle == NULL)
+        )
+    {
+        /*Codes_SRS_CONSTBUFFER_ARRAY_01_043: [ If there are any failures then constbuffer_array_remove_back shall fail and return NULL. ]*/
+        LogError("invalid arguments CONSTBUFFER_ARRAY_HANDLE constbuffer_array_handle=%p, CONSTBUFFER_HANDLE* constbuffer_handle=%p", constbuffer_array_handle, constbuffer_handle);
+    }
+    else
+    {
+        /*Codes_SRS_CONSTBUFFER_ARRAY_01_039: [ If there is no back CONSTBUFFER_HANDLE then constbuffer_array_remove_back shall fail and return NULL. ]*/
+        if (constbuffer_array_handle->nBuffers == 0)
+        {
+            /*Codes_SRS_CONSTBUFFER_ARRAY_01_043: [ If there are any failures then constbuffer_array_remove_back shall fail and return NULL. ]*/
+            LogError("cannot remove from that which does not have");
+        }
+        else
+        {
+            /*Codes_SRS_CONSTBUFFER_ARRAY_01_040: [ constbuffer_array_remove_back shall allocate a new CONSTBUFFER_ARRAY_HANDLE sharing the storage of constbuffer_array_handle and holding all of its CONSTBUFFER_HANDLEs except the back one. ]*/
+            result = constbuffer_array_create_view(constbuffer_array_handle->storage, constbuffer_array_handle->start, constbuffer_array_handle->nBuffers - 1);
+            if (result == NULL)
+            {
+                /*Codes_SRS_CONSTBUFFER_ARRAY_01_043: [ If there are any failures then constbuffer_array_remove_back shall fail and return NULL. ]*/
+                LogError("failure in constbuffer_array_create_view");
+                /*return as is*/
+            }
+            else
+            {
+                CONSTBUFFER_HANDLE back = ARRAY_BUFFERS(constbuffer_array_handle)[constbuffer_array_handle->nBuffers - 1];
+
+                /*Codes_SRS_CONSTBUFFER_ARRAY_01_041: [ constbuffer_array_remove_back shall inc_ref the removed buffer. ]*/
+                CONSTBUFFER_IncRef(back);
+
+                /*Codes_SRS_CONSTBUFFER_ARRAY_01_042: [ constbuffer_array_remove_back shall succeed, write in constbuffer_handle the back handle and return a non-NULL value. ]*/
+                *constbuffer_handle = back;
+                goto allOk;
+            }
+        }
+    }
+    /*Codes_SRS_CONSTBUFFER_ARRAY_01_043: [ If there are any failures then constbuffer_array_remove_back shall fail and return NULL. ]*/
+    result = NULL;
+allOk:;
+    return result;
+}
+
 int constbuffer_array_get_buffer_count(CONSTBUFFER_ARRAY_HANDLE constbuffer_array_handle, uint32_t* buffer_count)
 {
     int result;
@@ -331,8 +718,8 @@ CONSTBUFFER_HANDLE constbuffer_array_get_buffer(CONSTBUFFER_ARRAY_HANDLE constbu
     else
     {
         /* Codes_SRS_CONSTBUFFER_ARRAY_01_006: [ The returned handle shall have its reference count incremented. ]*/
-        CONSTBUFFER_IncRef(constbuffer_array_handle->buffers[buffer_index]);
-        result = constbuffer_array_handle->buffers[buffer_index];
+        result = ARRAY_BUFFERS(constbuffer_array_handle)[buffer_index];
+        CONSTBUFFER_IncRef(result);
 
         /* Codes_SRS_CONSTBUFFER_ARRAY_01_005: [ On success, constbuffer_array_get_buffer shall return a non-NULL handle to the buffer_index-th const buffer in the array. ]*/
         goto all_ok;
@@ -361,7 +748,7 @@ const CONSTBUFFER* constbuffer_array_get_buffer_content(CONSTBUFFER_ARRAY_HANDLE
     else
     {
         /* Codes_SRS_CONSTBUFFER_ARRAY_01_025: [ Otherwise constbuffer_array_get_buffer_content shall call CONSTBUFFER_GetContent for the buffer_index-th buffer and return its result. ]*/
-        result = CONSTBUFFER_GetContent(constbuffer_array_handle->buffers[buffer_index]);
+        result = CONSTBUFFER_GetContent(ARRAY_BUFFERS(constbuffer_array_handle)[buffer_index]);
     }
 
     return result;
@@ -377,7 +764,7 @@ void constbuffer_array_inc_ref(CONSTBUFFER_ARRAY_HANDLE constbuffer_array_handle
     else
     {
         /* Codes_SRS_CONSTBUFFER_ARRAY_01_018: [ Otherwise constbuffer_array_inc_ref shall increment the reference count for constbuffer_array_handle. ]*/
-        INC_REF(CONSTBUFFER_ARRAY_HANDLE_DATA, constbuffer_array_handle);
+        INC_REF_VAR(constbuffer_array_handle->count);
     }
 }
 
@@ -391,17 +778,18 @@ void constbuffer_array_dec_ref(CONSTBUFFER_ARRAY_HANDLE constbuffer_array_handle
     else
     {
         /* Codes_SRS_CONSTBUFFER_ARRAY_01_016: [ Otherwise constbuffer_array_dec_ref shall decrement the reference count for constbuffer_array_handle. ]*/
-        if (DEC_REF(CONSTBUFFER_ARRAY_HANDLE_DATA, constbuffer_array_handle) == DEC_RETURN_ZERO)
+        if (DEC_REF_VAR(constbuffer_array_handle->count) == DEC_RETURN_ZERO)
         {
-            uint32_t i;
+            CONSTBUFFER_ARRAY_STORAGE* storage = constbuffer_array_handle->storage;
 
             /*Codes_SRS_CONSTBUFFER_ARRAY_02_038: [ If the reference count reaches 0, constbuffer_array_dec_ref shall free all used resources. ]*/
-            for (i = 0; i < constbuffer_array_handle->nBuffers; i++)
+            if (constbuffer_array_handle != &storage->first_array)
             {
-                CONSTBUFFER_DecRef(constbuffer_array_handle->buffers[i]);
+                free(constbuffer_array_handle);
             }
 
-            REFCOUNT_TYPE_DESTROY(CONSTBUFFER_ARRAY_HANDLE_DATA, constbuffer_array_handle);
+            /*Codes_SRS_CONSTBUFFER_ARRAY_01_044: [ When the last CONSTBUFFER_ARRAY_HANDLE using a storage is freed, constbuffer_array_dec_ref shall dec_ref all the CONSTBUFFER_HANDLEs in the storage and free it. ]*/
+            constbuffer_array_storage_dec_ref(storage);
         }
     }
 }
@@ -423,27 +811,10 @@ int constbuffer_array_get_all_buffers_size(CONSTBUFFER_ARRAY_HANDLE constbuffer_
     }
     else
     {
-        uint32_t i;
-        uint32_t total_size = 0;
-
-        for (i = 0; i < constbuffer_array_handle->nBuffers; i++)
-        {
-            const CONSTBUFFER* content = CONSTBUFFER_GetContent(constbuffer_array_handle->buffers[i]);
-#if SIZE_MAX > UINT32_MAX
-            if (content->size > UINT32_MAX)
-            {
-                break;
-            }
-#endif
-            if (total_size + (uint32_t)content->size < total_size)
-            {
-                break;
-            }
-
-            total_size += (uint32_t)content->size;
-        }
+        /* Codes_SRS_CONSTBUFFER_ARRAY_01_049: [ constbuffer_array_get_all_buffers_size shall compute the size from the sizes stored when the buffers were added, without calling CONSTBUFFER_GetContent. ]*/
+        uint64_t total_size = ARRAY_OFFSETS(constbuffer_array_handle)[constbuffer_array_handle->nBuffers] - ARRAY_OFFSETS(constbuffer_array_handle)[0];
 
-        if (i < constbuffer_array_handle->nBuffers)
+        if (total_size > UINT32_MAX)
         {
             /* Codes_SRS_CONSTBUFFER_ARRAY_01_021: [ If summing up the sizes results in an uint32_t overflow, shall fail and return a non-zero value. ]*/
             LogError("Overflow in computing all buffers size");
@@ -452,7 +823,62 @@ int constbuffer_array_get_all_buffers_size(CONSTBUFFER_ARRAY_HANDLE constbuffer_
         else
         {
             /* Codes_SRS_CONSTBUFFER_ARRAY_01_022: [ Otherwise constbuffer_array_get_all_buffers_size shall write in all_buffers_size the total size of all buffers in the array and return 0. ]*/
-            *all_buffers_size = total_size;
+            *all_buffers_size = (uint32_t)total_size;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int constbuffer_array_get_buffer_index_at_offset(CONSTBUFFER_ARRAY_HANDLE constbuffer_array_handle, uint32_t offset, uint32_t* buffer_index, uint32_t* offset_in_buffer)
+{
+    int result;
+
+    if (
+        /* Codes_SRS_CONSTBUFFER_ARRAY_01_050: [ If constbuffer_array_handle is NULL, constbuffer_array_get_buffer_index_at_offset shall fail and return a non-zero value. ]*/
+        (constbuffer_array_handle == NULL) ||
+        /* Codes_SRS_CONSTBUFFER_ARRAY_01_051: [ If buffer_index or offset_in_buffer is NULL, constbuffer_array_get_buffer_index_at_offset shall fail and return a non-zero value. ]*/
+        (buffer_index == NULL) ||
+        (offset_in_buffer == NULL)
+        )
+    {
+        LogError("Invalid arguments: CONSTBUFFER_ARRAY_HANDLE constbuffer_array_handle=%p, uint32_t offset=%" PRIu32 ", uint32_t* buffer_index=%p, uint32_t* offset_in_buffer=%p",
+            constbuffer_array_handle, offset, buffer_index, offset_in_buffer);
+        result = __FAILURE__;
+    }
+    else
+    {
+        const uint64_t* offsets = ARRAY_OFFSETS(constbuffer_array_handle);
+
+        if ((uint64_t)offset >= offsets[constbuffer_array_handle->nBuffers] - offsets[0])
+        {
+            /* Codes_SRS_CONSTBUFFER_ARRAY_01_052: [ If offset is not less than the size of all the buffers of the array, constbuffer_array_get_buffer_index_at_offset shall fail and return a non-zero value. ]*/
+            LogError("offset %" PRIu32 " is past the end of the array", offset);
+            result = __FAILURE__;
+        }
+        else
+        {
+            /*the first buffer that ends after offset, comparing differences since the offsets wrap around*/
+            uint32_t low = 0;
+            uint32_t high = constbuffer_array_handle->nBuffers - 1;
+
+            while (low < high)
+            {
+                uint32_t middle = low + (high - low) / 2;
+                if (offsets[middle + 1] - offsets[0] > (uint64_t)offset)
+                {
+                    high = middle;
+                }
+                else
+                {
+                    low = middle + 1;
+                }
+            }
+
+            /* Codes_SRS_CONSTBUFFER_ARRAY_01_053: [ Otherwise constbuffer_array_get_buffer_index_at_offset shall find with a binary search the buffer holding the byte at offset, skipping empty buffers, write its index in buffer_index and the position of the byte in it in offset_in_buffer, and return 0. ]*/
+            *buffer_index = low;
+            *offset_in_buffer = (uint32_t)((uint64_t)offset - (offsets[low] - offsets[0]));
             result = 0;
         }
     }
@@ -4,6 +4,8 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stddef.h>
+#include <stdint.h>
+#include <string.h>
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/map.h"
 #include "azure_c_shared_utility/constmap.h"
@@ -12,15 +14,110 @@
 
 DEFINE_ENUM_STRINGS(CONSTMAP_RESULT, CONSTMAP_RESULT_VALUES);
 
+/*a slot of the lookup index: the hash of a key and its position in keys + 1, 0 means the slot is empty*/
+typedef struct CONSTMAP_INDEX_SLOT_TAG
+{
+    uint32_t hash;
+    uint32_t position;
+} CONSTMAP_INDEX_SLOT;
+
 typedef struct CONSTMAP_HANDLE_DATA_TAG
 {
     MAP_HANDLE map;
+    /*the map never changes, so its keys and values stay where they are and the index is built once*/
+    const char*const* keys;
+    const char*const* values;
+    size_t count;
+    /*NULL when the index could not be built, lookups then go to the map*/
+    CONSTMAP_INDEX_SLOT* index;
+    size_t indexMask;
 } CONSTMAP_HANDLE_DATA;
 
 DEFINE_REFCOUNT_TYPE(CONSTMAP_HANDLE_DATA);
 
 #define LOG_CONSTMAP_ERROR(result) LogError("result = %s", ENUM_TO_STRING(CONSTMAP_RESULT, (result)));
 
+static uint32_t ConstMap_HashKey(const char* key)
+{
+    /*FNV-1a*/
+    uint32_t hash = 2166136261u;
+    while (*key != '\0')
+    {
+        hash ^= (unsigned char)*key;
+        hash *= 16777619u;
+        key++;
+    }
+    return hash;
+}
+
+/*builds an index at most half full, a failure only means lookups go to the map*/
+static void ConstMap_BuildIndex(CONSTMAP_HANDLE_DATA* handleData)
+{
+    size_t indexSize = 8;
+
+    handleData->index = NULL;
+    handleData->indexMask = 0;
+
+    if (Map_GetInternals(handleData->map, &handleData->keys, &handleData->values, &handleData->count) != MAP_OK)
+    {
+        LogError("unable to get the pairs of the map, lookups go to the map");
+    }
+    else if (handleData->count >= (size_t)UINT32_MAX)
+    {
+        LogError("too many pairs to index, lookups go to the map");
+    }
+    else
+    {
+        while ((indexSize < handleData->count * 2) && (indexSize <= ((size_t)-1) / (2 * sizeof(CONSTMAP_INDEX_SLOT))))
+        {
+            indexSize *= 2;
+        }
+
+        if ((indexSize < handleData->count * 2) ||
+            ((handleData->index = (CONSTMAP_INDEX_SLOT*)malloc(indexSize * sizeof(CONSTMAP_INDEX_SLOT))) == NULL))
+        {
+            LogError("unable to allocate the index, lookups go to the map");
+        }
+        else
+        {
+            size_t i;
+            (void)memset(handleData->index, 0, indexSize * sizeof(CONSTMAP_INDEX_SLOT));
+            handleData->indexMask = indexSize - 1;
+            for (i = 0; i < handleData->count; i++)
+            {
+                uint32_t hash = ConstMap_HashKey(handleData->keys[i]);
+                size_t slot = hash & handleData->indexMask;
+                while (handleData->index[slot].position != 0)
+                {
+                    slot = (slot + 1) & handleData->indexMask;
+                }
+                handleData->index[slot].hash = hash;
+                handleData->index[slot].position = (uint32_t)(i + 1);
+            }
+        }
+    }
+}
+
+/*returns the position of key in keys + 1, or 0 if the map does not have it*/
+static size_t ConstMap_IndexFind(const CONSTMAP_HANDLE_DATA* handleData, const char* key)
+{
+    uint32_t hash = ConstMap_HashKey(key);
+    size_t slot = hash & handleData->indexMask;
+    size_t result = 0;
+    while (handleData->index[slot].position != 0)
+    {
+        /*the hashes spare nearly every string comparison with a key that does not match*/
+        if ((handleData->index[slot].hash == hash) &&
+            (strcmp(handleData->keys[handleData->index[slot].position - 1], key) == 0))
+        {
+            result = handleData->index[slot].position;
+            break;
+        }
+        slot = (slot + 1) & handleData->indexMask;
+    }
+    return result;
+}
+
 CONSTMAP_HANDLE ConstMap_Create(MAP_HANDLE sourceMap)
 {
     CONSTMAP_HANDLE_DATA* result = REFCOUNT_TYPE_CREATE(CONSTMAP_HANDLE_DATA);
@@ -41,6 +138,11 @@ CONSTMAP_HANDLE ConstMap_Create(MAP_HANDLE sourceMap)
             /*Codes_SRS_CONSTMAP_17_002: [If during creation there are any errors, then ConstMap_Create shall return NULL.]*/
             result = NULL;
         }
+        else
+        {
+            /*Codes_SRS_CONSTMAP_01_001: [ConstMap_Create shall build a hash index of the keys, so that ConstMap_ContainsKey and ConstMap_GetValue do not depend on the number of pairs; if the index cannot be built, they shall look the key up in the map instead.]*/
+            ConstMap_BuildIndex(result);
+        }
     }
     /*Codes_SRS_CONSTMAP_17_003: [Otherwise, it shall return a non-NULL handle that can be used in subsequent calls.]*/
     return (CONSTMAP_HANDLE)result;
@@ -59,6 +161,7 @@ void ConstMap_Destroy(CONSTMAP_HANDLE handle)
         if (DEC_REF(CONSTMAP_HANDLE_DATA, handle) == DEC_RETURN_ZERO)
         {
             /*Codes_SRS_CONSTMAP_17_004: [If the reference count is zero, ConstMap_Destroy shall release all resources associated with the immutable map.]*/
+            free(((CONSTMAP_HANDLE_DATA *)handle)->index);
             Map_Destroy(((CONSTMAP_HANDLE_DATA *)handle)->map);
             REFCOUNT_TYPE_DESTROY(CONSTMAP_HANDLE_DATA, handle);
         }
@@ -137,13 +240,23 @@ bool ConstMap_ContainsKey(CONSTMAP_HANDLE handle, const char* key )
         }
         else
         {
-            /*Codes_SRS_CONSTMAP_17_025: [Otherwise if a key exists then ConstMap_ContainsKey shall return true.]*/
-            MAP_RESULT mapResult = Map_ContainsKey(((CONSTMAP_HANDLE_DATA *)handle)->map, key, &keyExists);
-            if (mapResult != MAP_OK)
+            CONSTMAP_HANDLE_DATA* handleData = (CONSTMAP_HANDLE_DATA *)handle;
+            if (handleData->index != NULL)
             {
+                /*Codes_SRS_CONSTMAP_17_025: [Otherwise if a key exists then ConstMap_ContainsKey shall return true.]*/
                 /*Codes_SRS_CONSTMAP_17_026: [If a key doesn't exist, then ConstMap_ContainsKey shall return false.]*/
-                keyExists = false;
-                LOG_CONSTMAP_ERROR(ConstMap_ErrorConvert(mapResult));
+                keyExists = (ConstMap_IndexFind(handleData, key) != 0);
+            }
+            else
+            {
+                /*Codes_SRS_CONSTMAP_17_025: [Otherwise if a key exists then ConstMap_ContainsKey shall return true.]*/
+                MAP_RESULT mapResult = Map_ContainsKey(handleData->map, key, &keyExists);
+                if (mapResult != MAP_OK)
+                {
+                    /*Codes_SRS_CONSTMAP_17_026: [If a key doesn't exist, then ConstMap_ContainsKey shall return false.]*/
+                    keyExists = false;
+                    LOG_CONSTMAP_ERROR(ConstMap_ErrorConvert(mapResult));
+                }
             }
         }
     }
@@ -196,9 +309,18 @@ const char* ConstMap_GetValue(CONSTMAP_HANDLE handle, const char* key)
         }
         else
         {
+            CONSTMAP_HANDLE_DATA* handleData = (CONSTMAP_HANDLE_DATA *)handle;
             /*Codes_SRS_CONSTMAP_17_041: [If the key is not found, then ConstMap_GetValue returns NULL.]*/
             /*Codes_SRS_CONSTMAP_17_042: [Otherwise, ConstMap_GetValue returns the key's value.]*/
-            value = Map_GetValueFromKey(((CONSTMAP_HANDLE_DATA *)handle)->map, key);
+            if (handleData->index != NULL)
+            {
+                size_t position = ConstMap_IndexFind(handleData, key);
+                value = (position == 0) ? NULL : handleData->values[position - 1];
+            }
+            else
+            {
+                value = Map_GetValueFromKey(handleData->map, key);
+            }
         }
     }
     return value;
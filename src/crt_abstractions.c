@@ -366,7 +366,20 @@ unsigned long long strtoull_s(const char* nptr, char** endptr, int base)
         if (validStr && IN_BASE_RANGE(digitVal, base))
         {
             errno = 0;
-            do
+            if (base == 10)
+            {
+                /* the first 19 decimal digits always fit in an unsigned long long, they need no overflow check */
+                int digitCount = 0;
+                unsigned int decimalDigit;
+                while ((digitCount < 19) && ((decimalDigit = (unsigned int)(*runner - '0')) < 10))
+                {
+                    result = (result * 10) + decimalDigit;
+                    runner++;
+                    digitCount++;
+                }
+                digitVal = DIGIT_VAL(*runner);
+            }
+            while (IN_BASE_RANGE(digitVal, base))
             {
                 if (((ULLONG_MAX - digitVal) / base) < result)
                 {
@@ -381,7 +394,7 @@ unsigned long long strtoull_s(const char* nptr, char** endptr, int base)
                 }
                 runner++;
                 digitVal = DIGIT_VAL(*runner);
-            } while (IN_BASE_RANGE(digitVal, base));
+            }
         }
         else
         {
@@ -473,6 +486,91 @@ static bool isNaN(const char** endptr)
 
 DEFINE_ENUM(FLOAT_STRING_TYPE, FLOAT_STRING_TYPE_VALUES);
 
+/*the powers of 10 that a double represents exactly*/
+static const double EXACT_POWERS_OF_10[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15
+};
+
+#define SHORT_DECIMAL_MAX_DIGITS 15
+
+/* fast path for the common short decimals such as "42" or "-3.25": up to 15 digits without exponent
+   fit exactly in a double and are converted with a single division. Returns false for anything else,
+   which goes through splitFloatString. */
+static bool parseShortDecimal(const char* nptr, char** endptr, double* value)
+{
+    bool result;
+    const char* runner = nptr;
+    unsigned long long mantissa = 0;
+    int digitCount = 0;
+    int fractionSize = 0;
+    bool isNegative = false;
+    unsigned int digit;
+
+    while (IS_SPACE(*runner))
+    {
+        runner++;
+    }
+    if ((*runner) == '+')
+    {
+        runner++;
+    }
+    else if ((*runner) == '-')
+    {
+        isNegative = true;
+        runner++;
+    }
+
+    if ((unsigned int)(*runner - '0') >= 10)
+    {
+        /* INF, NAN and the invalid strings */
+        result = false;
+    }
+    else
+    {
+        while (((digit = (unsigned int)(*runner - '0')) < 10) && (digitCount <= SHORT_DECIMAL_MAX_DIGITS))
+        {
+            mantissa = (mantissa * 10) + digit;
+            digitCount++;
+            runner++;
+        }
+
+        if ((*runner) == '.')
+        {
+            runner++;
+            while (((digit = (unsigned int)(*runner - '0')) < 10) && (digitCount <= SHORT_DECIMAL_MAX_DIGITS))
+            {
+                mantissa = (mantissa * 10) + digit;
+                digitCount++;
+                fractionSize++;
+                runner++;
+            }
+        }
+
+        /* splitFloatString parses the fraction with strtoull_s, which skips spaces and a sign after the '.' */
+        if ((digitCount > SHORT_DECIMAL_MAX_DIGITS) ||
+            ((*runner) == 'e') || ((*runner) == 'E') ||
+            ((fractionSize == 0) && (*(runner - 1) == '.') && (IS_SPACE(*runner) || ((*runner) == '+') || ((*runner) == '-'))))
+        {
+            result = false;
+        }
+        else
+        {
+            *value = (double)mantissa / EXACT_POWERS_OF_10[fractionSize];
+            if (isNegative)
+            {
+                *value = -(*value);
+            }
+            *endptr = (char*)runner;
+            /* like the conversion of the integer part by strtoull_s in splitFloatString */
+            errno = 0;
+            result = true;
+        }
+    }
+
+    return result;
+}
+
 static FLOAT_STRING_TYPE splitFloatString(const char* nptr, char** endptr, int *signal, double *fraction, int *exponential)
 {
     FLOAT_STRING_TYPE result = FST_ERROR;
@@ -585,40 +683,48 @@ float strtof_s(const char* nptr, char** endptr)
     /*Codes_SRS_CRT_ABSTRACTIONS_21_036: [**If the nptr is NULL, the strtof_s must not perform any conversion and must returns 0.0f; endptr must receive NULL, provided that endptr is not a NULL pointer.]*/
     if (nptr != NULL)
     {
-        switch (splitFloatString(nptr, &runner, &signal, &fraction, &exponential))
+        if (parseShortDecimal(nptr, &runner, &val))
         {
-        case FST_INFINITY:
-            /*Codes_SRS_CRT_ABSTRACTIONS_21_023: [If the string is 'INF' of 'INFINITY' (ignoring case), the strtof_s must return the INFINITY value for float.]*/
-            result = INFINITY * (signal);
-            errno = 0;
-            break;
-        case FST_NAN:
-            /*Codes_SRS_CRT_ABSTRACTIONS_21_024: [If the string is 'NAN' or 'NAN(...)' (ignoring case), the strtof_s must return 0.0f and points endptr to the first character after the 'NAN' sequence.]*/
-            result = NAN;
-            break;
-        case FST_NUMBER:
-            val = fraction * pow(10.0, (double)exponential) * (double)signal;
-            if ((val >= (FLT_MAX * (-1.0f))) && (val <= FLT_MAX))
-            {
-                /*Codes_SRS_CRT_ABSTRACTIONS_21_016: [The strtof_s must return the float that represents the value in the initial part of the string. If any.]*/
-                result = (float)val;
-            }
-            else
+            /*Codes_SRS_CRT_ABSTRACTIONS_21_016: [The strtof_s must return the float that represents the value in the initial part of the string. If any.]*/
+            result = (float)val;
+        }
+        else
+        {
+            switch (splitFloatString(nptr, &runner, &signal, &fraction, &exponential))
             {
+            case FST_INFINITY:
+                /*Codes_SRS_CRT_ABSTRACTIONS_21_023: [If the string is 'INF' of 'INFINITY' (ignoring case), the strtof_s must return the INFINITY value for float.]*/
+                result = INFINITY * (signal);
+                errno = 0;
+                break;
+            case FST_NAN:
+                /*Codes_SRS_CRT_ABSTRACTIONS_21_024: [If the string is 'NAN' or 'NAN(...)' (ignoring case), the strtof_s must return 0.0f and points endptr to the first character after the 'NAN' sequence.]*/
+                result = NAN;
+                break;
+            case FST_NUMBER:
+                val = fraction * pow(10.0, (double)exponential) * (double)signal;
+                if ((val >= (FLT_MAX * (-1.0f))) && (val <= FLT_MAX))
+                {
+                    /*Codes_SRS_CRT_ABSTRACTIONS_21_016: [The strtof_s must return the float that represents the value in the initial part of the string. If any.]*/
+                    result = (float)val;
+                }
+                else
+                {
+                    /*Codes_SRS_CRT_ABSTRACTIONS_21_022: [If the correct value is outside the range, the strtof_s returns the value plus or minus HUGE_VALF, and errno will receive the value ERANGE.]*/
+                    result = HUGE_VALF * (signal);
+                    errno = ERANGE;
+                }
+                break;
+            case FST_OVERFLOW:
                 /*Codes_SRS_CRT_ABSTRACTIONS_21_022: [If the correct value is outside the range, the strtof_s returns the value plus or minus HUGE_VALF, and errno will receive the value ERANGE.]*/
                 result = HUGE_VALF * (signal);
                 errno = ERANGE;
+                break;
+            default:
+                /*Codes_SRS_CRT_ABSTRACTIONS_21_020: [If the subject sequence is empty or does not have the expected form, the strtof_s must not perform any conversion and must returns 0.0f; the value of nptr is stored in the object pointed to by endptr, provided that endptr is not a NULL pointer.]*/
+                runner = (char*)nptr;
+                break;
             }
-            break;
-        case FST_OVERFLOW:
-            /*Codes_SRS_CRT_ABSTRACTIONS_21_022: [If the correct value is outside the range, the strtof_s returns the value plus or minus HUGE_VALF, and errno will receive the value ERANGE.]*/
-            result = HUGE_VALF * (signal);
-            errno = ERANGE;
-            break;
-        default:
-            /*Codes_SRS_CRT_ABSTRACTIONS_21_020: [If the subject sequence is empty or does not have the expected form, the strtof_s must not perform any conversion and must returns 0.0f; the value of nptr is stored in the object pointed to by endptr, provided that endptr is not a NULL pointer.]*/
-            runner = (char*)nptr;
-            break;
         }
     }
 
@@ -639,6 +745,7 @@ long double strtold_s(const char* nptr, char** endptr)
     double fraction;
     int exponential;
     char* runner = (char*)nptr;
+    double val;
 
     /*Codes_SRS_CRT_ABSTRACTIONS_21_031: [If no conversion could be performed, the strtold_s returns the value 0.0.]*/
     long double result = 0.0;
@@ -646,40 +753,48 @@ long double strtold_s(const char* nptr, char** endptr)
     /*Codes_SRS_CRT_ABSTRACTIONS_21_037: [If the nptr is NULL, the strtold_s must not perform any conversion and must returns 0.0; endptr must receive NULL, provided that endptr is not a NULL pointer.]*/
     if (nptr != NULL)
     {
-        switch (splitFloatString(nptr, &runner, &signal, &fraction, &exponential))
+        if (parseShortDecimal(nptr, &runner, &val))
         {
-        case FST_INFINITY:
-            /*Codes_SRS_CRT_ABSTRACTIONS_21_033: [If the string is 'INF' of 'INFINITY' (ignoring case), the strtold_s must return the INFINITY value for long double.]*/
-            result = (long double)INFINITY * (long double)(signal);
-            errno = 0;
-            break;
-        case FST_NAN:
-            /*Codes_SRS_CRT_ABSTRACTIONS_21_034: [If the string is 'NAN' or 'NAN(...)' (ignoring case), the strtold_s must return 0.0 and points endptr to the first character after the 'NAN' sequence.]*/
-            result = (long double)NAN;
-            break;
-        case FST_NUMBER:
-            if ((exponential != DBL_MAX_10_EXP || (fraction <= 1.7976931348623158)) &&
-                (exponential != (DBL_MAX_10_EXP * (-1)) || (fraction <= 2.2250738585072014)))
-            {
-                /*Codes_SRS_CRT_ABSTRACTIONS_21_026: [The strtold_s must return the long double that represents the value in the initial part of the string. If any.]*/
-                result = fraction * pow(10.0, (double)exponential) * (double)signal;
-            }
-            else
+            /*Codes_SRS_CRT_ABSTRACTIONS_21_026: [The strtold_s must return the long double that represents the value in the initial part of the string. If any.]*/
+            result = val;
+        }
+        else
+        {
+            switch (splitFloatString(nptr, &runner, &signal, &fraction, &exponential))
             {
+            case FST_INFINITY:
+                /*Codes_SRS_CRT_ABSTRACTIONS_21_033: [If the string is 'INF' of 'INFINITY' (ignoring case), the strtold_s must return the INFINITY value for long double.]*/
+                result = (long double)INFINITY * (long double)(signal);
+                errno = 0;
+                break;
+            case FST_NAN:
+                /*Codes_SRS_CRT_ABSTRACTIONS_21_034: [If the string is 'NAN' or 'NAN(...)' (ignoring case), the strtold_s must return 0.0 and points endptr to the first character after the 'NAN' sequence.]*/
+                result = (long double)NAN;
+                break;
+            case FST_NUMBER:
+                if ((exponential != DBL_MAX_10_EXP || (fraction <= 1.7976931348623158)) &&
+                    (exponential != (DBL_MAX_10_EXP * (-1)) || (fraction <= 2.2250738585072014)))
+                {
+                    /*Codes_SRS_CRT_ABSTRACTIONS_21_026: [The strtold_s must return the long double that represents the value in the initial part of the string. If any.]*/
+                    result = fraction * pow(10.0, (double)exponential) * (double)signal;
+                }
+                else
+                {
+                    /*Codes_SRS_CRT_ABSTRACTIONS_21_032: [If the correct value is outside the range, the strtold_s returns the value plus or minus HUGE_VALL, and errno will receive the value ERANGE.]*/
+                    result = (long double)HUGE_VALF * (long double)(signal);
+                    errno = ERANGE;
+                }
+                break;
+            case FST_OVERFLOW:
                 /*Codes_SRS_CRT_ABSTRACTIONS_21_032: [If the correct value is outside the range, the strtold_s returns the value plus or minus HUGE_VALL, and errno will receive the value ERANGE.]*/
                 result = (long double)HUGE_VALF * (long double)(signal);
                 errno = ERANGE;
+                break;
+            default:
+                /*Codes_SRS_CRT_ABSTRACTIONS_21_030: [If the subject sequence is empty or does not have the expected form, the strtold_s must not perform any conversion and must returns 0.0; the value of nptr is stored in the object pointed to by endptr, provided that endptr is not a NULL pointer.]*/
+                runner = (char*)nptr;
+                break;
             }
-            break;
-        case FST_OVERFLOW:
-            /*Codes_SRS_CRT_ABSTRACTIONS_21_032: [If the correct value is outside the range, the strtold_s returns the value plus or minus HUGE_VALL, and errno will receive the value ERANGE.]*/
-            result = (long double)HUGE_VALF * (long double)(signal);
-            errno = ERANGE;
-            break;
-        default:
-            /*Codes_SRS_CRT_ABSTRACTIONS_21_030: [If the subject sequence is empty or does not have the expected form, the strtold_s must not perform any conversion and must returns 0.0; the value of nptr is stored in the object pointed to by endptr, provided that endptr is not a NULL pointer.]*/
-            runner = (char*)nptr;
-            break;
         }
     }
 
@@ -735,6 +850,62 @@ int mallocAndStrcpy_s(char** destination, const char* source)
     return result;
 }
 
+/*the decimal representation of 0 to 99, 2 characters each*/
+static const char DECIMAL_DIGIT_PAIRS[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/*writes value in decimal in destination, 2 digits at a time from the end of a scratch buffer large enough for SIZE_MAX*/
+static int formatDecimal(char* destination, size_t destinationSize, size_t value, size_t* length)
+{
+    int result;
+    char digits[((sizeof(size_t) * 5) + 1) / 2];
+    char* pos = digits + sizeof(digits);
+    size_t digitCount;
+
+    while (value >= 100)
+    {
+        size_t pair = (value % 100) * 2;
+        value /= 100;
+        pos -= 2;
+        pos[0] = DECIMAL_DIGIT_PAIRS[pair];
+        pos[1] = DECIMAL_DIGIT_PAIRS[pair + 1];
+    }
+    if (value >= 10)
+    {
+        pos -= 2;
+        pos[0] = DECIMAL_DIGIT_PAIRS[value * 2];
+        pos[1] = DECIMAL_DIGIT_PAIRS[(value * 2) + 1];
+    }
+    else
+    {
+        *(--pos) = (char)('0' + value);
+    }
+
+    digitCount = (size_t)((digits + sizeof(digits)) - pos);
+    if (digitCount >= destinationSize)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        (void)memcpy(destination, pos, digitCount);
+        destination[digitCount] = '\0';
+        *length = digitCount;
+        result = 0;
+    }
+
+    return result;
+}
+
 /*takes "value" and transforms it into a decimal string*/
 /*10 => "10"*/
 /*return 0 when everything went ok*/
@@ -742,8 +913,7 @@ int mallocAndStrcpy_s(char** destination, const char* source)
 int unsignedIntToString(char* destination, size_t destinationSize, unsigned int value)
 {
     int result;
-    size_t pos;
-    /*the below loop gets the number in reverse order*/
+    size_t length;
     /*Codes_SRS_CRT_ABSTRACTIONS_02_003: [If destination is NULL then unsignedIntToString shall fail.] */
     /*Codes_SRS_CRT_ABSTRACTIONS_02_002: [If the conversion fails for any reason (for example, insufficient buffer space), a non-zero return value shall be supplied and unsignedIntToString shall fail.] */
     if (
@@ -753,35 +923,41 @@ int unsignedIntToString(char* destination, size_t destinationSize, unsigned int
     {
         result = __FAILURE__;
     }
+    else if (formatDecimal(destination, destinationSize, value, &length) != 0)
+    {
+        /*Codes_SRS_CRT_ABSTRACTIONS_02_002: [If the conversion fails for any reason (for example, insufficient buffer space), a non-zero return value shall be supplied and unsignedIntToString shall fail.] */
+        result = __FAILURE__;
+    }
     else
     {
-        pos = 0;
-        do
-        {
-            destination[pos++] = '0' + (value % 10);
-            value /= 10;
-        } while ((value > 0) && (pos < (destinationSize-1)));
+        /*Codes_SRS_CRT_ABSTRACTIONS_02_004: [If the conversion has been successfull then unsignedIntToString shall return 0.] */
+        result = 0;
+    }
+    return result;
+}
 
-        if (value == 0)
-        {
-            size_t w;
-            destination[pos] = '\0';
-            /*all converted and they fit*/
-            for (w = 0; w <= (pos-1) >> 1; w++)
-            {
-                char temp;
-                temp = destination[w];
-                destination[w] = destination[pos - 1 - w];
-                destination[pos -1 - w] = temp;
-            }
-            /*Codes_SRS_CRT_ABSTRACTIONS_02_004: [If the conversion has been successfull then unsignedIntToString shall return 0.] */
-            result = 0;
-        }
-        else
-        {
-            /*Codes_SRS_CRT_ABSTRACTIONS_02_002: [If the conversion fails for any reason (for example, insufficient buffer space), a non-zero return value shall be supplied and unsignedIntToString shall fail.] */
-            result = __FAILURE__;
-        }
+/*Codes_SRS_CRT_ABSTRACTIONS_01_001: [unsignedIntToStringWithLength shall convert value like unsignedIntToString does and store the number of characters written, not counting the terminating null character, in length.] */
+int unsignedIntToStringWithLength(char* destination, size_t destinationSize, unsigned int value, size_t* length)
+{
+    int result;
+    /*Codes_SRS_CRT_ABSTRACTIONS_01_002: [If destination or length is NULL, or destination cannot hold the decimal representation of value and a null character, unsignedIntToStringWithLength shall fail and return a non-zero value.] */
+    if (
+        (destination == NULL) ||
+        (length == NULL) ||
+        (destinationSize < 2)
+        )
+    {
+        result = __FAILURE__;
+    }
+    else if (formatDecimal(destination, destinationSize, value, length) != 0)
+    {
+        /*Codes_SRS_CRT_ABSTRACTIONS_01_002: [If destination or length is NULL, or destination cannot hold the decimal representation of value and a null character, unsignedIntToStringWithLength shall fail and return a non-zero value.] */
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_CRT_ABSTRACTIONS_01_003: [On success unsignedIntToStringWithLength shall return 0.] */
+        result = 0;
     }
     return result;
 }
@@ -793,8 +969,7 @@ int unsignedIntToString(char* destination, size_t destinationSize, unsigned int
 int size_tToString(char* destination, size_t destinationSize, size_t value)
 {
     int result;
-    size_t pos;
-    /*the below loop gets the number in reverse order*/
+    size_t length;
     /*Codes_SRS_CRT_ABSTRACTIONS_02_003: [If destination is NULL then unsignedIntToString shall fail.] */
     /*Codes_SRS_CRT_ABSTRACTIONS_02_002: [If the conversion fails for any reason (for example, insufficient buffer space), a non-zero return value shall be supplied and unsignedIntToString shall fail.] */
     if (
@@ -804,35 +979,41 @@ int size_tToString(char* destination, size_t destinationSize, size_t value)
     {
         result = __FAILURE__;
     }
+    else if (formatDecimal(destination, destinationSize, value, &length) != 0)
+    {
+        /*Codes_SRS_CRT_ABSTRACTIONS_02_002: [If the conversion fails for any reason (for example, insufficient buffer space), a non-zero return value shall be supplied and unsignedIntToString shall fail.] */
+        result = __FAILURE__;
+    }
     else
     {
-        pos = 0;
-        do
-        {
-            destination[pos++] = '0' + (value % 10);
-            value /= 10;
-        } while ((value > 0) && (pos < (destinationSize - 1)));
+        /*Codes_SRS_CRT_ABSTRACTIONS_02_004: [If the conversion has been successfull then unsignedIntToString shall return 0.] */
+        result = 0;
+    }
+    return result;
+}
 
-        if (value == 0)
-        {
-            size_t w;
-            destination[pos] = '\0';
-            /*all converted and they fit*/
-            for (w = 0; w <= (pos - 1) >> 1; w++)
-            {
-                char temp;
-                temp = destination[w];
-                destination[w] = destination[pos - 1 - w];
-                destination[pos - 1 - w] = temp;
-            }
-            /*Codes_SRS_CRT_ABSTRACTIONS_02_004: [If the conversion has been successfull then unsignedIntToString shall return 0.] */
-            result = 0;
-        }
-        else
-        {
-            /*Codes_SRS_CRT_ABSTRACTIONS_02_002: [If the conversion fails for any reason (for example, insufficient buffer space), a non-zero return value shall be supplied and unsignedIntToString shall fail.] */
-            result = __FAILURE__;
-        }
+/*Codes_SRS_CRT_ABSTRACTIONS_01_004: [size_tToStringWithLength shall convert value like size_tToString does and store the number of characters written, not counting the terminating null character, in length.] */
+int size_tToStringWithLength(char* destination, size_t destinationSize, size_t value, size_t* length)
+{
+    int result;
+    /*Codes_SRS_CRT_ABSTRACTIONS_01_005: [If destination or length is NULL, or destination cannot hold the decimal representation of value and a null character, size_tToStringWithLength shall fail and return a non-zero value.] */
+    if (
+        (destination == NULL) ||
+        (length == NULL) ||
+        (destinationSize < 2)
+        )
+    {
+        result = __FAILURE__;
+    }
+    else if (formatDecimal(destination, destinationSize, value, length) != 0)
+    {
+        /*Codes_SRS_CRT_ABSTRACTIONS_01_005: [If destination or length is NULL, or destination cannot hold the decimal representation of value and a null character, size_tToStringWithLength shall fail and return a non-zero value.] */
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_CRT_ABSTRACTIONS_01_006: [On success size_tToStringWithLength shall return 0.] */
+        result = 0;
     }
     return result;
 }
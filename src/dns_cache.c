@@ -0,0 +1,440 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/dns_cache.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+/*
+* A gateway opens many connections to a handful of hosts, so the entries are a short list,
+* most recently added first. The list is bounded by DNS_CACHE_MAX_ENTRIES: when it is full
+* the expired entries are dropped, and if none has expired the oldest one is.
+*
+* Ages are only ever compared through differences of tickcounter readings, which stay
+* right when a 32 bit tickcounter_ms_t wraps.
+*/
+typedef struct DNS_CACHE_ENTRY_TAG
+{
+    char* hostname;
+    bool is_negative;
+    DNS_CACHE_ADDRESSES addresses;
+    tickcounter_ms_t added_ms;
+    uint32_t ttl_ms;
+    struct DNS_CACHE_ENTRY_TAG* next;
+} DNS_CACHE_ENTRY;
+
+static LOCK_HANDLE cache_lock = NULL;
+static TICK_COUNTER_HANDLE cache_tick_counter = NULL;
+static DNS_CACHE_ENTRY* cache_entries = NULL;
+static size_t cache_entry_count = 0;
+static bool cache_is_enabled = false;
+static uint32_t cache_ttl_ms = DNS_CACHE_DEFAULT_TTL_MS;
+static uint32_t cache_negative_ttl_ms = DNS_CACHE_DEFAULT_NEGATIVE_TTL_MS;
+
+static bool is_expired(const DNS_CACHE_ENTRY* entry, tickcounter_ms_t now)
+{
+    return (tickcounter_ms_t)(now - entry->added_ms) >= entry->ttl_ms;
+}
+
+// Must be called with cache_lock held
+static DNS_CACHE_ENTRY** find_entry(const char* hostname)
+{
+    DNS_CACHE_ENTRY** entry = &cache_entries;
+
+    while ((*entry != NULL) && (strcmp((*entry)->hostname, hostname) != 0))
+    {
+        entry = &(*entry)->next;
+    }
+
+    return entry;
+}
+
+// Must be called with cache_lock held
+static void remove_entry(DNS_CACHE_ENTRY** entry)
+{
+    DNS_CACHE_ENTRY* removed = *entry;
+
+    *entry = removed->next;
+    cache_entry_count--;
+    free(removed->hostname);
+    free(removed);
+}
+
+// Must be called with cache_lock held
+static void remove_all_entries(void)
+{
+    while (cache_entries != NULL)
+    {
+        remove_entry(&cache_entries);
+    }
+}
+
+// Must be called with cache_lock held
+static void make_room(tickcounter_ms_t now)
+{
+    DNS_CACHE_ENTRY** entry = &cache_entries;
+    DNS_CACHE_ENTRY** oldest = NULL;
+
+    while (*entry != NULL)
+    {
+        if (is_expired(*entry, now))
+        {
+            remove_entry(entry);
+        }
+        else
+        {
+            if ((oldest == NULL) ||
+                ((tickcounter_ms_t)(now - (*entry)->added_ms) > (tickcounter_ms_t)(now - (*oldest)->added_ms)))
+            {
+                oldest = entry;
+            }
+            entry = &(*entry)->next;
+        }
+    }
+
+    if ((cache_entry_count >= DNS_CACHE_MAX_ENTRIES) && (oldest != NULL))
+    {
+        remove_entry(oldest);
+    }
+}
+
+int dns_cache_init(void)
+{
+    int result;
+
+    if (cache_lock != NULL)
+    {
+        /* Codes_SRS_DNS_CACHE_01_001: [ If the cache is already initialized, dns_cache_init shall fail and return a non-zero value. ]*/
+        LogError("dns_cache is already initialized");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_DNS_CACHE_01_002: [ dns_cache_init shall create a lock and a tick counter. ]*/
+    else if ((cache_tick_counter = tickcounter_create()) == NULL)
+    {
+        /* Codes_SRS_DNS_CACHE_01_004: [ If any failure occurs, dns_cache_init shall free what it created and return a non-zero value. ]*/
+        LogError("tickcounter_create failed");
+        result = __FAILURE__;
+    }
+    else if ((cache_lock = Lock_Init()) == NULL)
+    {
+        /* Codes_SRS_DNS_CACHE_01_004: [ If any failure occurs, dns_cache_init shall free what it created and return a non-zero value. ]*/
+        LogError("Lock_Init failed");
+        tickcounter_destroy(cache_tick_counter);
+        cache_tick_counter = NULL;
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_DNS_CACHE_01_003: [ dns_cache_init shall enable the cache with a TTL of DNS_CACHE_DEFAULT_TTL_MS and a negative TTL of DNS_CACHE_DEFAULT_NEGATIVE_TTL_MS and return 0. ]*/
+        cache_is_enabled = true;
+        cache_ttl_ms = DNS_CACHE_DEFAULT_TTL_MS;
+        cache_negative_ttl_ms = DNS_CACHE_DEFAULT_NEGATIVE_TTL_MS;
+        result = 0;
+    }
+
+    return result;
+}
+
+void dns_cache_deinit(void)
+{
+    if (cache_lock == NULL)
+    {
+        /* Codes_SRS_DNS_CACHE_01_005: [ If the cache is not initialized, dns_cache_deinit shall return. ]*/
+        LogError("dns_cache is not initialized");
+    }
+    else
+    {
+        /* Codes_SRS_DNS_CACHE_01_006: [ dns_cache_deinit shall free all entries, the lock and the tick counter. ]*/
+        remove_all_entries();
+        (void)Lock_Deinit(cache_lock);
+        cache_lock = NULL;
+        tickcounter_destroy(cache_tick_counter);
+        cache_tick_counter = NULL;
+        cache_is_enabled = false;
+    }
+}
+
+int dns_cache_set_ttl(uint32_t ttl_ms, uint32_t negative_ttl_ms)
+{
+    int result;
+
+    if (cache_lock == NULL)
+    {
+        /* Codes_SRS_DNS_CACHE_01_007: [ If the cache is not initialized, dns_cache_set_ttl shall fail and return a non-zero value. ]*/
+        LogError("dns_cache is not initialized");
+        result = __FAILURE__;
+    }
+    else if (Lock(cache_lock) != LOCK_OK)
+    {
+        /* Codes_SRS_DNS_CACHE_01_009: [ If any failure occurs, dns_cache_set_ttl shall return a non-zero value. ]*/
+        LogError("Failed to lock the DNS cache");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_DNS_CACHE_01_008: [ dns_cache_set_ttl shall set the TTLs given to the entries added afterwards and return 0. ]*/
+        cache_ttl_ms = ttl_ms;
+        cache_negative_ttl_ms = negative_ttl_ms;
+        (void)Unlock(cache_lock);
+        result = 0;
+    }
+
+    return result;
+}
+
+void dns_cache_set_enabled(bool enabled)
+{
+    if (cache_lock == NULL)
+    {
+        /* Codes_SRS_DNS_CACHE_01_010: [ If the cache is not initialized, dns_cache_set_enabled shall return. ]*/
+        LogError("dns_cache is not initialized");
+    }
+    else if (Lock(cache_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the DNS cache");
+    }
+    else
+    {
+        /* Codes_SRS_DNS_CACHE_01_011: [ dns_cache_set_enabled shall enable or disable the cache and, when disabling it, remove all entries. ]*/
+        cache_is_enabled = enabled;
+        if (!enabled)
+        {
+            remove_all_entries();
+        }
+        (void)Unlock(cache_lock);
+    }
+}
+
+DNS_CACHE_RESULT dns_cache_lookup(const char* hostname, DNS_CACHE_ADDRESSES* addresses)
+{
+    DNS_CACHE_RESULT result;
+
+    if ((hostname == NULL) || (addresses == NULL))
+    {
+        /* Codes_SRS_DNS_CACHE_01_012: [ If hostname or addresses is NULL, dns_cache_lookup shall return DNS_CACHE_MISS. ]*/
+        LogError("Invalid arguments: hostname = %p, addresses = %p", hostname, addresses);
+        result = DNS_CACHE_MISS;
+    }
+    else if (cache_lock == NULL)
+    {
+        /* Codes_SRS_DNS_CACHE_01_013: [ If the cache is not initialized or is disabled, dns_cache_lookup shall return DNS_CACHE_MISS. ]*/
+        result = DNS_CACHE_MISS;
+    }
+    else if (Lock(cache_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the DNS cache");
+        result = DNS_CACHE_MISS;
+    }
+    else
+    {
+        tickcounter_ms_t now;
+
+        if (!cache_is_enabled)
+        {
+            /* Codes_SRS_DNS_CACHE_01_013: [ If the cache is not initialized or is disabled, dns_cache_lookup shall return DNS_CACHE_MISS. ]*/
+            result = DNS_CACHE_MISS;
+        }
+        else if (tickcounter_get_current_ms(cache_tick_counter, &now) != 0)
+        {
+            LogError("tickcounter_get_current_ms failed");
+            result = DNS_CACHE_MISS;
+        }
+        else
+        {
+            DNS_CACHE_ENTRY** entry = find_entry(hostname);
+
+            if (*entry == NULL)
+            {
+                /* Codes_SRS_DNS_CACHE_01_014: [ If hostname has no entry, dns_cache_lookup shall return DNS_CACHE_MISS. ]*/
+                result = DNS_CACHE_MISS;
+            }
+            else if (is_expired(*entry, now))
+            {
+                /* Codes_SRS_DNS_CACHE_01_015: [ If the entry of hostname has expired, dns_cache_lookup shall remove it and return DNS_CACHE_MISS. ]*/
+                remove_entry(entry);
+                result = DNS_CACHE_MISS;
+            }
+            else if ((*entry)->is_negative)
+            {
+                /* Codes_SRS_DNS_CACHE_01_016: [ If the entry of hostname records a failed lookup, dns_cache_lookup shall return DNS_CACHE_NEGATIVE_HIT. ]*/
+                result = DNS_CACHE_NEGATIVE_HIT;
+            }
+            else
+            {
+                /* Codes_SRS_DNS_CACHE_01_017: [ Otherwise dns_cache_lookup shall copy the addresses of the entry to addresses and return DNS_CACHE_HIT. ]*/
+                *addresses = (*entry)->addresses;
+                result = DNS_CACHE_HIT;
+            }
+        }
+
+        (void)Unlock(cache_lock);
+    }
+
+    return result;
+}
+
+int dns_cache_add(const char* hostname, const DNS_CACHE_ADDRESSES* addresses)
+{
+    int result;
+
+    if (hostname == NULL)
+    {
+        /* Codes_SRS_DNS_CACHE_01_018: [ If hostname is NULL, dns_cache_add shall fail and return a non-zero value. ]*/
+        LogError("NULL hostname");
+        result = __FAILURE__;
+    }
+    else if (cache_lock == NULL)
+    {
+        /* Codes_SRS_DNS_CACHE_01_019: [ If the cache is not initialized or is disabled, dns_cache_add shall do nothing and return 0. ]*/
+        result = 0;
+    }
+    else if (Lock(cache_lock) != LOCK_OK)
+    {
+        /* Codes_SRS_DNS_CACHE_01_024: [ If any failure occurs, dns_cache_add shall return a non-zero value. ]*/
+        LogError("Failed to lock the DNS cache");
+        result = __FAILURE__;
+    }
+    else
+    {
+        tickcounter_ms_t now;
+        uint32_t ttl_ms = (addresses == NULL) ? cache_negative_ttl_ms : cache_ttl_ms;
+
+        if (!cache_is_enabled)
+        {
+            /* Codes_SRS_DNS_CACHE_01_019: [ If the cache is not initialized or is disabled, dns_cache_add shall do nothing and return 0. ]*/
+            result = 0;
+        }
+        else if (tickcounter_get_current_ms(cache_tick_counter, &now) != 0)
+        {
+            /* Codes_SRS_DNS_CACHE_01_024: [ If any failure occurs, dns_cache_add shall return a non-zero value. ]*/
+            LogError("tickcounter_get_current_ms failed");
+            result = __FAILURE__;
+        }
+        else
+        {
+            DNS_CACHE_ENTRY** entry = find_entry(hostname);
+
+            if (ttl_ms == 0)
+            {
+                /* Codes_SRS_DNS_CACHE_01_020: [ If the TTL for the kind of result is 0, dns_cache_add shall remove the entry of hostname and return 0. ]*/
+                if (*entry != NULL)
+                {
+                    remove_entry(entry);
+                }
+                result = 0;
+            }
+            else if (*entry != NULL)
+            {
+                /* Codes_SRS_DNS_CACHE_01_021: [ If hostname already has an entry, dns_cache_add shall replace its result and restart its TTL. ]*/
+                (*entry)->is_negative = (addresses == NULL);
+                if (addresses != NULL)
+                {
+                    (*entry)->addresses = *addresses;
+                }
+                (*entry)->added_ms = now;
+                (*entry)->ttl_ms = ttl_ms;
+                result = 0;
+            }
+            else
+            {
+                DNS_CACHE_ENTRY* new_entry;
+
+                if (cache_entry_count >= DNS_CACHE_MAX_ENTRIES)
+                {
+                    /* Codes_SRS_DNS_CACHE_01_023: [ If the cache holds DNS_CACHE_MAX_ENTRIES entries, dns_cache_add shall remove the expired entries and, if none has expired, the oldest entry. ]*/
+                    make_room(now);
+                }
+
+                if ((new_entry = (DNS_CACHE_ENTRY*)malloc(sizeof(DNS_CACHE_ENTRY))) == NULL)
+                {
+                    /* Codes_SRS_DNS_CACHE_01_024: [ If any failure occurs, dns_cache_add shall return a non-zero value. ]*/
+                    LogError("Failed allocating DNS cache entry");
+                    result = __FAILURE__;
+                }
+                else if (mallocAndStrcpy_s(&new_entry->hostname, hostname) != 0)
+                {
+                    /* Codes_SRS_DNS_CACHE_01_024: [ If any failure occurs, dns_cache_add shall return a non-zero value. ]*/
+                    LogError("Failed copying the hostname of a DNS cache entry");
+                    free(new_entry);
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    /* Codes_SRS_DNS_CACHE_01_022: [ Otherwise dns_cache_add shall add an entry for hostname, recording a failed lookup if addresses is NULL, and return 0. ]*/
+                    new_entry->is_negative = (addresses == NULL);
+                    if (addresses != NULL)
+                    {
+                        new_entry->addresses = *addresses;
+                    }
+                    else
+                    {
+                        (void)memset(&new_entry->addresses, 0, sizeof(new_entry->addresses));
+                    }
+                    new_entry->added_ms = now;
+                    new_entry->ttl_ms = ttl_ms;
+                    new_entry->next = cache_entries;
+                    cache_entries = new_entry;
+                    cache_entry_count++;
+                    result = 0;
+                }
+            }
+        }
+
+        (void)Unlock(cache_lock);
+    }
+
+    return result;
+}
+
+void dns_cache_remove(const char* hostname)
+{
+    if (hostname == NULL)
+    {
+        /* Codes_SRS_DNS_CACHE_01_025: [ If hostname is NULL or the cache is not initialized, dns_cache_remove shall return. ]*/
+        LogError("NULL hostname");
+    }
+    else if (cache_lock == NULL)
+    {
+        /* Codes_SRS_DNS_CACHE_01_025: [ If hostname is NULL or the cache is not initialized, dns_cache_remove shall return. ]*/
+    }
+    else if (Lock(cache_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the DNS cache");
+    }
+    else
+    {
+        /* Codes_SRS_DNS_CACHE_01_026: [ dns_cache_remove shall remove the entry of hostname if it has one. ]*/
+        DNS_CACHE_ENTRY** entry = find_entry(hostname);
+        if (*entry != NULL)
+        {
+            remove_entry(entry);
+        }
+        (void)Unlock(cache_lock);
+    }
+}
+
+void dns_cache_clear(void)
+{
+    if (cache_lock == NULL)
+    {
+        /* Codes_SRS_DNS_CACHE_01_027: [ If the cache is not initialized, dns_cache_clear shall return. ]*/
+    }
+    else if (Lock(cache_lock) != LOCK_OK)
+    {
+        LogError("Failed to lock the DNS cache");
+    }
+    else
+    {
+        /* Codes_SRS_DNS_CACHE_01_028: [ dns_cache_clear shall remove all entries. ]*/
+        remove_all_entries();
+        (void)Unlock(cache_lock);
+    }
+}
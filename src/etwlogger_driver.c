@@ -11,6 +11,9 @@
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/etwlogger.h"
 
+/*most messages fit, the longer ones are formatted in a malloc'd string*/
+#define ETW_MESSAGE_BUFFER_SIZE 512
+
 /*returns a string as if printed by vprintf*/
 static char* vprintf_alloc(const char* format, va_list va)
 {
@@ -39,6 +42,51 @@ static char* vprintf_alloc(const char* format, va_list va)
     return result;
 }
 
+/*formats in buffer when the message fits, in a malloc'd string otherwise. returns NULL if it fails, the result is to be given to free_message*/
+static char* format_message(char* buffer, size_t buffer_size, const char* format, va_list va)
+{
+    char* result;
+    int neededSize;
+    va_list va_retry;
+
+    va_copy(va_retry, va);
+    neededSize = vsnprintf(buffer, buffer_size, format, va);
+    if (neededSize < 0)
+    {
+        result = NULL;
+    }
+    else if ((size_t)neededSize < buffer_size)
+    {
+        result = buffer;
+    }
+    else
+    {
+        result = (char*)malloc(neededSize + 1);
+        if (result == NULL)
+        {
+            /*return as is*/
+        }
+        else
+        {
+            if (vsnprintf(result, neededSize + 1, format, va_retry) != neededSize)
+            {
+                free(result);
+                result = NULL;
+            }
+        }
+    }
+    va_end(va_retry);
+    return result;
+}
+
+static void free_message(char* message, char* buffer)
+{
+    if (message != buffer)
+    {
+        free(message);
+    }
+}
+
 /*returns a string as if printed by printf*/
 static char* printf_alloc(const char* format, ...)
 {
@@ -138,80 +186,126 @@ static void lazyRegisterEventProvider(void)
 void etwlogger_log_with_GetLastError(const char* file, const char* func, int line, const char* format, ...)
 {
     DWORD lastError;
-    char* lastErrorAsString;
 
     lastError = GetLastError(); /*needs to be done before lazRegistedEventProvider*/
     lazyRegisterEventProvider();
 
-    va_list args;
-    va_start(args, format);
+    /*nothing is formatted when no session listens to the events*/
+    if (EventEnabledLogErrorEvent() || EventEnabledLogLastError())
+    {
+        char* lastErrorAsString;
+        char buffer[ETW_MESSAGE_BUFFER_SIZE];
+        va_list args;
+        va_start(args, format);
 
-    SYSTEMTIME t;
-    GetSystemTime(&t);
+        SYSTEMTIME t;
+        GetSystemTime(&t);
 
-    lastErrorAsString = lastErrorToString(lastError);
-    if (lastErrorAsString == NULL)
-    {
-        char* userMessage = vprintf_alloc(format, args);
-        if (userMessage == NULL)
+        lastErrorAsString = lastErrorToString(lastError);
+        if (lastErrorAsString == NULL)
         {
-            if (EventWriteLogErrorEvent("unable to print user error or last error", file, &t, func, line) != ERROR_SUCCESS)
+            char* userMessage = format_message(buffer, sizeof(buffer), format, args);
+            if (userMessage == NULL)
             {
-                (void)printf("failure in EventWriteLogErrorEvent");
+                if (EventWriteLogErrorEvent("unable to print user error or last error", file, &t, func, line) != ERROR_SUCCESS)
+                {
+                    (void)printf("failure in EventWriteLogErrorEvent");
+                }
             }
-        }
-        else
-        {
-            if (EventWriteLogErrorEvent(userMessage, file, &t, func, line) != ERROR_SUCCESS)
+            else
             {
-                (void)printf("failure in EventWriteLogErrorEvent");
+                if (EventWriteLogErrorEvent(userMessage, file, &t, func, line) != ERROR_SUCCESS)
+                {
+                    (void)printf("failure in EventWriteLogErrorEvent");
+                }
+                free_message(userMessage, buffer);
             }
-            free(userMessage);
         }
-    }
-    else
-    {
-        char* userMessage = vprintf_alloc(format, args);
-        if (userMessage == NULL)
+        else
         {
-            if (EventWriteLogErrorEvent(lastErrorAsString, file, &t, func, line) != ERROR_SUCCESS)
+            char* userMessage = format_message(buffer, sizeof(buffer), format, args);
+            if (userMessage == NULL)
             {
-                (void)printf("failure in EventWriteLogErrorEvent");
+                if (EventWriteLogErrorEvent(lastErrorAsString, file, &t, func, line) != ERROR_SUCCESS)
+                {
+                    (void)printf("failure in EventWriteLogErrorEvent");
+                }
             }
-        }
-        else
-        {
-            if (EventWriteLogLastError(userMessage, file, &t, func, line, lastErrorAsString) != ERROR_SUCCESS)
+            else
             {
-                (void)printf("failure in EventWriteLogErrorEvent");
+                if (EventWriteLogLastError(userMessage, file, &t, func, line, lastErrorAsString) != ERROR_SUCCESS)
+                {
+                    (void)printf("failure in EventWriteLogErrorEvent");
+                }
+                free_message(userMessage, buffer);
             }
-            free(userMessage);
+            free(lastErrorAsString);
         }
-        free(lastErrorAsString);
-    }
-
 
-    va_end(args);
+        va_end(args);
+    }
 }
 
-
-
-
 void etwlogger_log(LOG_CATEGORY log_category, const char* file, const char* func, int line, unsigned int options, const char* format, ...)
 {
+    int isEnabled;
+
     (void)options;
 
     lazyRegisterEventProvider();
 
-    va_list args;
-    va_start(args, format);
-    char* text = vprintf_alloc(format, args);
-    if (text == NULL)
+    /*disabled events cost this check, nothing is formatted when no session listens to them*/
+    switch (log_category)
+    {
+        case AZ_LOG_INFO:
+            isEnabled = EventEnabledLogInfoEvent();
+            break;
+        case AZ_LOG_ERROR:
+            isEnabled = EventEnabledLogErrorEvent();
+            break;
+        default:
+            isEnabled = 0;
+            break;
+    }
+
+    if (isEnabled)
     {
-        switch (log_category)
+        char buffer[ETW_MESSAGE_BUFFER_SIZE];
+        va_list args;
+        va_start(args, format);
+        char* text = format_message(buffer, sizeof(buffer), format, args);
+        if (text == NULL)
+        {
+            switch (log_category)
+            {
+                case AZ_LOG_INFO:
+                    if (EventWriteLogInfoEvent("INTERNAL LOGGING ERROR: failed in format_message") != ERROR_SUCCESS)
+                    {
+                        /*fallback on printf...*/
+                        (void)printf("failed in EventWriteLogInfoEvent");
+                    }
+                    break;
+                case AZ_LOG_ERROR:
+                {
+                    SYSTEMTIME t;
+                    GetSystemTime(&t);
+                    if (EventWriteLogErrorEvent("INTERNAL LOGGING ERROR: failed in format_message", file, &t, func, line) != ERROR_SUCCESS)
+                    {
+                        /*fallback on printf...*/
+                        (void)printf("failed in EventWriteLogErrorEvent");
+                    }
+                    break;
+                }
+                default:
+                    break;
+            }
+        }
+        else
         {
+            switch (log_category)
+            {
             case AZ_LOG_INFO:
-                if (EventWriteLogInfoEvent("INTERNAL LOGGING ERROR: failed in vprintf_alloc") != ERROR_SUCCESS)
+                if (EventWriteLogInfoEvent(text) != ERROR_SUCCESS)
                 {
                     /*fallback on printf...*/
                     (void)printf("failed in EventWriteLogInfoEvent");
@@ -221,7 +315,7 @@ void etwlogger_log(LOG_CATEGORY log_category, const char* file, const char* func
             {
                 SYSTEMTIME t;
                 GetSystemTime(&t);
-                if (EventWriteLogErrorEvent("INTERNAL LOGGING ERROR: failed in vprintf_alloc", file, &t, func, line) != ERROR_SUCCESS)
+                if (EventWriteLogErrorEvent(text, file, &t, func, line) != ERROR_SUCCESS)
                 {
                     /*fallback on printf...*/
                     (void)printf("failed in EventWriteLogErrorEvent");
@@ -230,35 +324,9 @@ void etwlogger_log(LOG_CATEGORY log_category, const char* file, const char* func
             }
             default:
                 break;
-        }
-    }
-    else
-    {
-        switch (log_category)
-        {
-        case AZ_LOG_INFO:
-            if (EventWriteLogInfoEvent(text) != ERROR_SUCCESS)
-            {
-                /*fallback on printf...*/
-                (void)printf("failed in EventWriteLogInfoEvent");
-            }
-            break;
-        case AZ_LOG_ERROR:
-        {
-            SYSTEMTIME t;
-            GetSystemTime(&t);
-            if (EventWriteLogErrorEvent(text, file, &t, func, line) != ERROR_SUCCESS)
-            {
-                /*fallback on printf...*/
-                (void)printf("failed in EventWriteLogErrorEvent");
             }
-            break;
-        }
-        default:
-            break;
+            free_message(text, buffer);
         }
-        free(text);
+        va_end(args);
     }
-    va_end(args);
 }
-
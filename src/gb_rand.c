@@ -1,16 +1,241 @@
 // Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
+/* rand_s has to be requested before the first include of stdlib.h */
+#if defined(_WIN32) && !defined(_CRT_RAND_S)
+#define _CRT_RAND_S
+#elif defined(__linux__) && !defined(_DEFAULT_SOURCE)
+/* syscall */
+#define _DEFAULT_SOURCE
+#endif
+
 #ifdef __cplusplus
 #include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
 #else
 #include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
 #endif
 
 #include "azure_c_shared_utility/gb_rand.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+/* Each thread has its own xoshiro256** generator, so that callers do not share (and on most
+   C runtimes lock) the state of rand(). The generator is seeded from the OS the first time a
+   thread uses it, from the time and the address of its state when the OS has no randomness to offer.
+   It is fast and statistically good, but it is not a cryptographically secure generator. */
+
+#if defined(_MSC_VER)
+#define GB_RAND_THREAD_LOCAL __declspec(thread)
+#else
+#define GB_RAND_THREAD_LOCAL __thread
+#endif
+
+#if defined(_WIN32)
+#define GB_RAND_SEED_RAND_S
+#elif defined(__APPLE__) || defined(__FreeBSD__) || defined(__NetBSD__) || defined(__OpenBSD__)
+#define GB_RAND_SEED_ARC4RANDOM
+#elif defined(__linux__) || defined(__unix__)
+#define GB_RAND_SEED_DEV_URANDOM
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+#endif
+
+typedef struct GB_RAND_STATE_TAG
+{
+    uint64_t s[4];
+    int seeded;
+} GB_RAND_STATE;
+
+static GB_RAND_THREAD_LOCAL GB_RAND_STATE gb_rand_state;
+
+static uint64_t rotate_left(uint64_t value, int count)
+{
+    return (value << count) | (value >> (64 - count));
+}
+
+static uint64_t splitmix64(uint64_t* value)
+{
+    uint64_t result = (*value += 0x9E3779B97F4A7C15ull);
+    result = (result ^ (result >> 30)) * 0xBF58476D1CE4E5B9ull;
+    result = (result ^ (result >> 27)) * 0x94D049BB133111EBull;
+    return result ^ (result >> 31);
+}
+
+#if defined(GB_RAND_SEED_DEV_URANDOM)
+static int read_urandom(unsigned char* seed, size_t size)
+{
+    int result;
+    int fd;
+
+    if ((fd = open("/dev/urandom", O_RDONLY)) < 0)
+    {
+        result = -1;
+    }
+    else
+    {
+        size_t pos = 0;
+        while (pos < size)
+        {
+            ssize_t read_size = read(fd, seed + pos, size - pos);
+            if (read_size > 0)
+            {
+                pos += (size_t)read_size;
+            }
+            else if ((read_size < 0) && (errno == EINTR))
+            {
+                continue;
+            }
+            else
+            {
+                break;
+            }
+        }
+        (void)close(fd);
+        result = (pos == size) ? 0 : -1;
+    }
+
+    return result;
+}
+#endif
+
+static int get_os_seed(uint64_t seed[4])
+{
+    int result;
+#if defined(GB_RAND_SEED_RAND_S)
+    size_t i;
+    result = 0;
+    for (i = 0; (i < 8) && (result == 0); i++)
+    {
+        unsigned int value;
+        if (rand_s(&value) != 0)
+        {
+            result = -1;
+        }
+        else
+        {
+            seed[i / 2] = (seed[i / 2] << 32) | value;
+        }
+    }
+#elif defined(GB_RAND_SEED_ARC4RANDOM)
+    arc4random_buf(seed, 4 * sizeof(uint64_t));
+    result = 0;
+#elif defined(GB_RAND_SEED_DEV_URANDOM)
+    result = -1;
+#if defined(__linux__) && defined(SYS_getrandom)
+    /* getrandom needs neither a file descriptor nor /dev, it is called directly because older C runtimes do not wrap it */
+    if (syscall(SYS_getrandom, seed, 4 * sizeof(uint64_t), 0) == (long)(4 * sizeof(uint64_t)))
+    {
+        result = 0;
+    }
+#endif
+    if (result != 0)
+    {
+        result = read_urandom((unsigned char*)seed, 4 * sizeof(uint64_t));
+    }
+#else
+    (void)seed;
+    result = -1;
+#endif
+    return result;
+}
+
+static void seed_state(GB_RAND_STATE* state)
+{
+    uint64_t seed[4] = { 0, 0, 0, 0 };
+    uint64_t mix;
+    size_t i;
+
+    if (get_os_seed(seed) != 0)
+    {
+        LogInfo("gb_rand: no randomness available from the OS, seeding from the time");
+    }
+
+    /* the OS seed goes through splitmix64 like the fallback values, which also guarantees
+       that the state can never be all zeros from a weak OS seed */
+    mix = (uint64_t)time(NULL) ^ ((uint64_t)clock() << 32) ^ (uint64_t)(uintptr_t)state;
+    for (i = 0; i < 4; i++)
+    {
+        mix ^= seed[i];
+        state->s[i] = splitmix64(&mix);
+    }
+    if ((state->s[0] | state->s[1] | state->s[2] | state->s[3]) == 0)
+    {
+        state->s[0] = 1;
+    }
+    state->seeded = 1;
+}
+
+static uint64_t next_value(void)
+{
+    GB_RAND_STATE* state = &gb_rand_state;
+    uint64_t result;
+    uint64_t t;
+
+    if (!state->seeded)
+    {
+        seed_state(state);
+    }
+
+    result = rotate_left(state->s[1] * 5, 7) * 9;
+    t = state->s[1] << 17;
+    state->s[2] ^= state->s[0];
+    state->s[3] ^= state->s[1];
+    state->s[1] ^= state->s[2];
+    state->s[0] ^= state->s[3];
+    state->s[2] ^= t;
+    state->s[3] = rotate_left(state->s[3], 45);
+
+    return result;
+}
 
-/*this is rand*/
 int gb_rand(void)
 {
-    return rand();
+    /* 31 bits, so that the result is never negative, like the result of rand() */
+    return (int)(next_value() >> 33);
+}
+
+uint32_t gb_rand_uint32(void)
+{
+    return (uint32_t)(next_value() >> 32);
+}
+
+uint64_t gb_rand_uint64(void)
+{
+    return next_value();
+}
+
+void gb_rand_fill(void* buffer, size_t size)
+{
+    if ((buffer == NULL) && (size > 0))
+    {
+        LogError("Invalid argument: buffer is NULL, size=%lu", (unsigned long)size);
+    }
+    else
+    {
+        unsigned char* pos = (unsigned char*)buffer;
+
+        while (size >= sizeof(uint64_t))
+        {
+            uint64_t value = next_value();
+            (void)memcpy(pos, &value, sizeof(value));
+            pos += sizeof(value);
+            size -= sizeof(value);
+        }
+        if (size > 0)
+        {
+            uint64_t value = next_value();
+            (void)memcpy(pos, &value, size);
+        }
+    }
 }
@@ -5,22 +5,250 @@
 #include <stdlib.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
 #include "azure_c_shared_utility/lock.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
 
 #ifndef GB_USE_CUSTOM_HEAP
 
+/* the types of the header are only declared with GB_DEBUG_ALLOC, and the allocation functions must not be redirected in here */
+#undef GB_MEASURE_MEMORY_FOR_THIS
+#ifndef GB_DEBUG_ALLOC
+#define GB_DEBUG_ALLOC
+#endif
+#include "azure_c_shared_utility/gballoc.h"
+
 #ifndef SIZE_MAX
 #define SIZE_MAX ((size_t)~(size_t)0)
 #endif
 
-typedef struct ALLOCATION_TAG
+/* the heap under gballoc, the C runtime one unless gballoc_set_allocator replaced it */
+#define GBALLOC_DEFAULT_ALLOCATOR { malloc, calloc, realloc, free, NULL }
+static GBALLOC_ALLOCATOR allocator = GBALLOC_DEFAULT_ALLOCATOR;
+
+#define underlying_malloc(size) allocator.malloc_function(size)
+#define underlying_calloc(nmemb, size) allocator.calloc_function(nmemb, size)
+#define underlying_realloc(ptr, size) allocator.realloc_function(ptr, size)
+#define underlying_free(ptr) allocator.free_function(ptr)
+
+/* the size a block is freed with when gballoc does not know it */
+#define GBALLOC_UNKNOWN_SIZE SIZE_MAX
+
+static void underlying_free_sized(void* ptr, size_t size)
 {
-    size_t size;
-    void* ptr;
-    void* next;
-} ALLOCATION;
+    if ((size != GBALLOC_UNKNOWN_SIZE) && (allocator.free_sized_function != NULL))
+    {
+        allocator.free_sized_function(ptr, size);
+    }
+    else
+    {
+        allocator.free_function(ptr);
+    }
+}
+
+/* the size header mode has no lock, the list mode counts while holding its lock */
+#if defined(GB_USE_SIZE_HEADER)
+#define GBALLOC_STATISTICS_ADD(counter, value) (void)__sync_add_and_fetch(&(counter), (value))
+#else
+#define GBALLOC_STATISTICS_ADD(counter, value) ((counter) += (value))
+#endif
+
+#if defined(_MSC_VER)
+#define GBALLOC_THREAD_LOCAL __declspec(thread)
+#else
+#define GBALLOC_THREAD_LOCAL __thread
+#endif
+
+static size_t get_size_class(size_t size)
+{
+    size_t result = 0;
+
+    while ((size != 0) && (result < GBALLOC_SIZE_CLASS_COUNT - 1))
+    {
+        size >>= 1;
+        result++;
+    }
+
+    return result;
+}
+
+static void count_allocation_size(GBALLOC_STATISTICS* statistics, size_t size)
+{
+    /* Codes_SRS_GBALLOC_01_085: [Each allocation served by the underlying heap shall be counted in the entry of allocation_size_histogram of its size, the new size of a reallocation included.] */
+    GBALLOC_STATISTICS_ADD(statistics->allocation_size_histogram[get_size_class(size)], 1);
+}
+
+static void count_reallocation(GBALLOC_STATISTICS* statistics, size_t old_size, size_t new_size, int is_moved)
+{
+    /* Codes_SRS_GBALLOC_01_086: [Each successful reallocation of a tracked block shall be counted in realloc_count, and in realloc_grow_count with its growth in realloc_growth_histogram or in realloc_shrink_count when the size changes.] */
+    GBALLOC_STATISTICS_ADD(statistics->realloc_count, 1);
+    if (new_size > old_size)
+    {
+        GBALLOC_STATISTICS_ADD(statistics->realloc_grow_count, 1);
+        GBALLOC_STATISTICS_ADD(statistics->realloc_growth_histogram[get_size_class(new_size - old_size)], 1);
+    }
+    else if (new_size < old_size)
+    {
+        GBALLOC_STATISTICS_ADD(statistics->realloc_shrink_count, 1);
+    }
+
+    /* Codes_SRS_GBALLOC_01_087: [A reallocation that returns a different block shall be counted in realloc_moved_count and add the smaller of the old and new size to realloc_moved_bytes, any other in realloc_in_place_count.] */
+    if (is_moved)
+    {
+        GBALLOC_STATISTICS_ADD(statistics->realloc_moved_count, 1);
+        GBALLOC_STATISTICS_ADD(statistics->realloc_moved_bytes, (old_size < new_size) ? old_size : new_size);
+    }
+    else
+    {
+        GBALLOC_STATISTICS_ADD(statistics->realloc_in_place_count, 1);
+    }
+}
+
+typedef struct GBALLOC_BUDGET_STATE_TAG
+{
+    /* 0 when the budget has no limit */
+    size_t max_size;
+    size_t current_size;
+    ON_GBALLOC_BUDGET_EXCEEDED on_budget_exceeded;
+    void* on_budget_exceeded_context;
+} GBALLOC_BUDGET_STATE;
+
+static GBALLOC_BUDGET_STATE budgets[GBALLOC_BUDGET_COUNT];
+static GBALLOC_THREAD_LOCAL int current_budget = GBALLOC_BUDGET_NONE;
+
+static void reset_budgets(void)
+{
+    size_t i;
+    for (i = 0; i < GBALLOC_BUDGET_COUNT; i++)
+    {
+        budgets[i].current_size = 0;
+    }
+}
+
+/* counts size bytes in budget, the list mode calls it while holding its lock */
+static int charge_budget(int budget, size_t size)
+{
+    int result;
+
+    if (budget == GBALLOC_BUDGET_NONE)
+    {
+        result = 0;
+    }
+    else
+    {
+        GBALLOC_BUDGET_STATE* state = &budgets[budget];
+#if defined(GB_USE_SIZE_HEADER)
+        size_t new_size = __sync_add_and_fetch(&state->current_size, size);
+#else
+        size_t new_size = (state->current_size += size);
+#endif
+        if ((new_size < size) ||
+            ((state->max_size != 0) && (new_size > state->max_size)))
+        {
+            /* Codes_SRS_GBALLOC_01_104: [An allocation that would take the memory used of its budget over the limit shall fail, and on_budget_exceeded shall be called with the budget and the size of the allocation.] */
+#if defined(GB_USE_SIZE_HEADER)
+            (void)__sync_sub_and_fetch(&state->current_size, size);
+#else
+            state->current_size -= size;
+#endif
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void uncharge_budget(int budget, size_t size)
+{
+    if (budget != GBALLOC_BUDGET_NONE)
+    {
+        GBALLOC_BUDGET_STATE* state = &budgets[budget];
+        /* a block of an earlier gballoc_init does not take the count below 0 */
+#if defined(GB_USE_SIZE_HEADER)
+        size_t current_size = state->current_size;
+        while (!__sync_bool_compare_and_swap(&state->current_size, current_size, (current_size < size) ? 0 : (current_size - size)))
+        {
+            current_size = state->current_size;
+        }
+#else
+        state->current_size = (state->current_size < size) ? 0 : (state->current_size - size);
+#endif
+    }
+}
+
+/* called once the allocation has failed, the list mode calls it after giving back its lock so that the callback can allocate */
+static void notify_budget_exceeded(int budget, size_t size)
+{
+    LogError("Allocation of %lu bytes exceeds the limit of budget %d (%lu bytes)", (unsigned long)size, budget, (unsigned long)budgets[budget].max_size);
+    if (budgets[budget].on_budget_exceeded != NULL)
+    {
+        /* what the callback allocates is not counted in the budget, so that it cannot fail again */
+        int previous_budget = current_budget;
+        current_budget = GBALLOC_BUDGET_NONE;
+        budgets[budget].on_budget_exceeded(budgets[budget].on_budget_exceeded_context, budget, size);
+        current_budget = previous_budget;
+    }
+}
+
+#if defined(GB_USE_SIZE_HEADER)
+
+/* In this mode the size of each block lives in a header in front of the block, so free is O(1),
+and the counters are spread over shards picked by block address, so that no lock is taken */
+
+#if !defined(__GNUC__)
+#error "GB_USE_SIZE_HEADER requires the GCC __sync atomic builtins"
+#endif
+
+#if defined(GB_TRACK_ALLOCATION_SITES)
+#error "GB_TRACK_ALLOCATION_SITES needs the allocation list and cannot be combined with GB_USE_SIZE_HEADER"
+#endif
+
+#ifndef GBALLOC_SHARD_COUNT
+#define GBALLOC_SHARD_COUNT 16
+#endif
+
+#define GBALLOC_CACHE_LINE_SIZE 64
+#define GBALLOC_HEADER_MAGIC ((size_t)0x6762616C6C6F6321ULL)
+/* the low bits of the magic carry the budget of the block */
+#define GBALLOC_HEADER_MAGIC_OF(size, budget) (GBALLOC_HEADER_MAGIC ^ (size) ^ (size_t)(budget))
+
+typedef union GBALLOC_HEADER_TAG
+{
+    struct
+    {
+        size_t size;
+        /* the magic is xor-ed with the size, so that blocks not coming from gballoc are told apart */
+        size_t magic;
+    } info;
+    /* keeps the user block aligned the same way malloc aligns it */
+    long double align_long_double;
+    long long align_long_long;
+    void* align_pointer;
+} GBALLOC_HEADER;
+
+typedef union GBALLOC_SHARD_TAG
+{
+    struct
+    {
+        size_t current_size;
+        size_t high_water_mark;
+        size_t allocation_count;
+    } counters;
+    /* each shard has its own cache line so that threads do not fight over it */
+    unsigned char padding[GBALLOC_CACHE_LINE_SIZE];
+} GBALLOC_SHARD;
+
+typedef union GBALLOC_SHARD_STATISTICS_TAG
+{
+    GBALLOC_STATISTICS statistics;
+    /* rounded up to whole cache lines, for the same reason as the shards */
+    unsigned char padding[((sizeof(GBALLOC_STATISTICS) + GBALLOC_CACHE_LINE_SIZE - 1) / GBALLOC_CACHE_LINE_SIZE) * GBALLOC_CACHE_LINE_SIZE];
+} GBALLOC_SHARD_STATISTICS;
 
 typedef enum GBALLOC_STATE_TAG
 {
@@ -28,13 +256,121 @@ typedef enum GBALLOC_STATE_TAG
     GBALLOC_STATE_NOT_INIT
 } GBALLOC_STATE;
 
-static ALLOCATION* head = NULL;
-static size_t totalSize = 0;
+static GBALLOC_SHARD shards[GBALLOC_SHARD_COUNT];
+static GBALLOC_SHARD_STATISTICS shard_statistics[GBALLOC_SHARD_COUNT];
 static size_t maxSize = 0;
-static size_t g_allocations = 0;
 static GBALLOC_STATE gballocState = GBALLOC_STATE_NOT_INIT;
 
-static LOCK_HANDLE gballocThreadSafeLock = NULL;
+static size_t get_shard_index(const GBALLOC_HEADER* header)
+{
+    uintptr_t address = (uintptr_t)header;
+    return (size_t)(((address >> 4) ^ (address >> 12)) % GBALLOC_SHARD_COUNT);
+}
+
+static GBALLOC_SHARD* get_shard(const GBALLOC_HEADER* header)
+{
+    return &shards[get_shard_index(header)];
+}
+
+static GBALLOC_STATISTICS* get_shard_statistics(const GBALLOC_HEADER* header)
+{
+    return &shard_statistics[get_shard_index(header)].statistics;
+}
+
+static size_t get_current_size(void)
+{
+    size_t result = 0;
+    size_t i;
+
+    for (i = 0; i < GBALLOC_SHARD_COUNT; i++)
+    {
+        result += __sync_fetch_and_add(&shards[i].counters.current_size, 0);
+    }
+
+    return result;
+}
+
+static void reset_counters(void)
+{
+    size_t i;
+
+    for (i = 0; i < GBALLOC_SHARD_COUNT; i++)
+    {
+        (void)__sync_lock_test_and_set(&shards[i].counters.current_size, 0);
+        (void)__sync_lock_test_and_set(&shards[i].counters.high_water_mark, 0);
+        (void)__sync_lock_test_and_set(&shards[i].counters.allocation_count, 0);
+    }
+
+    (void)__sync_lock_test_and_set(&maxSize, 0);
+    (void)memset(shard_statistics, 0, sizeof(shard_statistics));
+}
+
+static void count_allocation(GBALLOC_HEADER* header, size_t size)
+{
+    GBALLOC_SHARD* shard = get_shard(header);
+    size_t shard_size = __sync_add_and_fetch(&shard->counters.current_size, size);
+    size_t shard_high_water_mark = shard->counters.high_water_mark;
+
+    (void)__sync_add_and_fetch(&shard->counters.allocation_count, 1);
+
+    /* a new overall maximum can only be reached when a shard reaches a new high, which is rare once warm,
+    so that is the only time all the shards are summed up */
+    if (shard_size > shard_high_water_mark)
+    {
+        size_t current_size;
+        size_t current_max;
+
+        (void)__sync_bool_compare_and_swap(&shard->counters.high_water_mark, shard_high_water_mark, shard_size);
+
+        current_size = get_current_size();
+        current_max = maxSize;
+        while ((current_size > current_max) &&
+            !__sync_bool_compare_and_swap(&maxSize, current_max, current_size))
+        {
+            current_max = maxSize;
+        }
+    }
+}
+
+static void count_free(GBALLOC_HEADER* header)
+{
+    (void)__sync_sub_and_fetch(&get_shard(header)->counters.current_size, header->info.size);
+}
+
+static GBALLOC_HEADER* get_header(void* ptr)
+{
+    GBALLOC_HEADER* result;
+
+    if (ptr == NULL)
+    {
+        result = NULL;
+    }
+    else
+    {
+        result = (GBALLOC_HEADER*)ptr - 1;
+        if ((result->info.magic ^ GBALLOC_HEADER_MAGIC_OF(result->info.size, GBALLOC_BUDGET_NONE)) >= GBALLOC_BUDGET_COUNT)
+        {
+            /* the block was allocated while gballoc was not initialized */
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+static int get_header_budget(const GBALLOC_HEADER* header)
+{
+    return (int)(header->info.magic ^ GBALLOC_HEADER_MAGIC_OF(header->info.size, GBALLOC_BUDGET_NONE));
+}
+
+static void* track_block(GBALLOC_HEADER* header, size_t size, int budget)
+{
+    header->info.size = size;
+    header->info.magic = GBALLOC_HEADER_MAGIC_OF(size, budget);
+    count_allocation(header, size);
+    count_allocation_size(get_shard_statistics(header), size);
+    return header + 1;
+}
 
 int gballoc_init(void)
 {
@@ -45,20 +381,14 @@ int gballoc_init(void)
         /* Codes_SRS_GBALLOC_01_025: [Init after Init shall fail and return a non-zero value.] */
         result = __FAILURE__;
     }
-    /* Codes_SRS_GBALLOC_01_026: [gballoc_Init shall create a lock handle that will be used to make the other gballoc APIs thread-safe.] */
-    else if ((gballocThreadSafeLock = Lock_Init()) == NULL)
-    {
-        /* Codes_SRS_GBALLOC_01_027: [If the Lock creation fails, gballoc_init shall return a non-zero value.]*/
-        result = __FAILURE__;
-    }
     else
     {
-        gballocState = GBALLOC_STATE_INIT;
-
+        /* Codes_SRS_GBALLOC_01_052: [When built with GB_USE_SIZE_HEADER, gballoc_init shall not create a lock.] */
         /* Codes_ SRS_GBALLOC_01_002: [Upon initialization the total memory used and maximum total memory used tracked by the module shall be set to 0.] */
-        totalSize = 0;
-        maxSize = 0;
-        g_allocations = 0;
+        reset_counters();
+        /* Codes_SRS_GBALLOC_01_106: [gballoc_init shall set the memory used of all the budgets to 0.] */
+        reset_budgets();
+        gballocState = GBALLOC_STATE_INIT;
 
         /* Codes_SRS_GBALLOC_01_024: [gballoc_init shall initialize the gballoc module and return 0 upon success.] */
         result = 0;
@@ -69,273 +399,208 @@ int gballoc_init(void)
 
 void gballoc_deinit(void)
 {
-    if (gballocState == GBALLOC_STATE_INIT)
-    {
-        /* Codes_SRS_GBALLOC_01_028: [gballoc_deinit shall free all resources allocated by gballoc_init.] */
-        (void)Lock_Deinit(gballocThreadSafeLock);
-    }
-
     gballocState = GBALLOC_STATE_NOT_INIT;
 }
 
-void* gballoc_malloc(size_t size)
+static void* heap_malloc(size_t size, const char* file, int line)
 {
     void* result;
 
+    (void)file;
+    (void)line;
+
     if (gballocState != GBALLOC_STATE_INIT)
     {
         /* Codes_SRS_GBALLOC_01_039: [If gballoc was not initialized gballoc_malloc shall simply call malloc without any memory tracking being performed.] */
-        result = malloc(size);
+        result = underlying_malloc(size);
     }
-    /* Codes_SRS_GBALLOC_01_030: [gballoc_malloc shall ensure thread safety by using the lock created by gballoc_Init.] */
-    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    else if (size > SIZE_MAX - sizeof(GBALLOC_HEADER))
     {
-        /* Codes_SRS_GBALLOC_01_048: [If acquiring the lock fails, gballoc_malloc shall return NULL.] */
-        LogError("Failed to get the Lock.");
+        LogError("Invalid size: %lu", (unsigned long)size);
+        result = NULL;
+    }
+    else if (charge_budget(current_budget, size) != 0)
+    {
+        notify_budget_exceeded(current_budget, size);
         result = NULL;
     }
     else
     {
-        ALLOCATION* allocation = (ALLOCATION*)malloc(sizeof(ALLOCATION));
-        if (allocation == NULL)
+        /* Codes_SRS_GBALLOC_01_053: [When built with GB_USE_SIZE_HEADER, gballoc_malloc shall allocate size bytes plus a header that records size and is placed in front of the returned block.] */
+        GBALLOC_HEADER* header = (GBALLOC_HEADER*)underlying_malloc(sizeof(GBALLOC_HEADER) + size);
+        if (header == NULL)
         {
+            /* Codes_SRS_GBALLOC_01_012: [When the underlying malloc call fails, gballoc_malloc shall return NULL and size should not be counted towards total memory used.] */
+            uncharge_budget(current_budget, size);
             result = NULL;
         }
         else
         {
-            /* Codes_SRS_GBALLOC_01_003: [gb_malloc shall call the C99 malloc function and return its result.] */
-            result = malloc(size);
-            if (result == NULL)
-            {
-                /* Codes_SRS_GBALLOC_01_012: [When the underlying malloc call fails, gballoc_malloc shall return NULL and size should not be counted towards total memory used.] */
-                free(allocation);
-            }
-            else
-            {
-                /* Codes_SRS_GBALLOC_01_004: [If the underlying malloc call is successful, gb_malloc shall increment the total memory used with the amount indicated by size.] */
-                allocation->ptr = result;
-                allocation->size = size;
-                allocation->next = head;
-                head = allocation;
-
-                g_allocations++;
-                totalSize += size;
-                /* Codes_SRS_GBALLOC_01_011: [The maximum total memory used shall be the maximum of the total memory used at any point.] */
-                if (maxSize < totalSize)
-                {
-                    maxSize = totalSize;
-                }
-            }
+            /* Codes_SRS_GBALLOC_01_004: [If the underlying malloc call is successful, gb_malloc shall increment the total memory used with the amount indicated by size.] */
+            result = track_block(header, size, current_budget);
         }
-
-        (void)Unlock(gballocThreadSafeLock);
     }
 
     return result;
 }
 
-void* gballoc_calloc(size_t nmemb, size_t size)
+static void* heap_calloc(size_t nmemb, size_t size, const char* file, int line)
 {
     void* result;
 
+    (void)file;
+    (void)line;
+
     if (gballocState != GBALLOC_STATE_INIT)
     {
         /* Codes_SRS_GBALLOC_01_040: [If gballoc was not initialized gballoc_calloc shall simply call calloc without any memory tracking being performed.] */
-        result = calloc(nmemb, size);
+        result = underlying_calloc(nmemb, size);
     }
-    /* Codes_SRS_GBALLOC_01_031: [gballoc_calloc shall ensure thread safety by using the lock created by gballoc_Init]  */
-    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    else if ((size != 0) && (nmemb > (SIZE_MAX - sizeof(GBALLOC_HEADER)) / size))
     {
-        /* Codes_SRS_GBALLOC_01_046: [If acquiring the lock fails, gballoc_calloc shall return NULL.] */
-        LogError("Failed to get the Lock.");
+        LogError("Invalid size: nmemb=%lu, size=%lu", (unsigned long)nmemb, (unsigned long)size);
+        result = NULL;
+    }
+    else if (charge_budget(current_budget, nmemb * size) != 0)
+    {
+        notify_budget_exceeded(current_budget, nmemb * size);
         result = NULL;
     }
     else
     {
-        ALLOCATION* allocation = (ALLOCATION*)malloc(sizeof(ALLOCATION));
-        if (allocation == NULL)
+        /* Codes_SRS_GBALLOC_01_054: [When built with GB_USE_SIZE_HEADER, gballoc_calloc shall allocate nmemb*size zeroed bytes plus the size header.] */
+        GBALLOC_HEADER* header = (GBALLOC_HEADER*)underlying_calloc(1, sizeof(GBALLOC_HEADER) + (nmemb * size));
+        if (header == NULL)
         {
+            /* Codes_SRS_GBALLOC_01_022: [When the underlying calloc call fails, gballoc_calloc shall return NULL and size should not be counted towards total memory used.] */
+            uncharge_budget(current_budget, nmemb * size);
             result = NULL;
         }
         else
         {
-            /* Codes_SRS_GBALLOC_01_020: [gballoc_calloc shall call the C99 calloc function and return its result.] */
-            result = calloc(nmemb, size);
-            if (result == NULL)
-            {
-                /* Codes_SRS_GBALLOC_01_022: [When the underlying calloc call fails, gballoc_calloc shall return NULL and size should not be counted towards total memory used.] */
-                free(allocation);
-            }
-            else
-            {
-                /* Codes_SRS_GBALLOC_01_021: [If the underlying calloc call is successful, gballoc_calloc shall increment the total memory used with nmemb*size.] */
-                allocation->ptr = result;
-                allocation->size = nmemb * size;
-                allocation->next = head;
-                head = allocation;
-                g_allocations++;
-
-                totalSize += allocation->size;
-                /* Codes_SRS_GBALLOC_01_011: [The maximum total memory used shall be the maximum of the total memory used at any point.] */
-                if (maxSize < totalSize)
-                {
-                    maxSize = totalSize;
-                }
-            }
+            /* Codes_SRS_GBALLOC_01_021: [If the underlying calloc call is successful, gballoc_calloc shall increment the total memory used with nmemb*size.] */
+            result = track_block(header, nmemb * size, current_budget);
         }
-
-        (void)Unlock(gballocThreadSafeLock);
     }
 
     return result;
 }
 
-void* gballoc_realloc(void* ptr, size_t size)
+static void* heap_realloc(void* ptr, size_t size, const char* file, int line)
 {
-    ALLOCATION* curr;
     void* result;
-    ALLOCATION* allocation = NULL;
+    GBALLOC_HEADER* header = get_header(ptr);
 
-    if (gballocState != GBALLOC_STATE_INIT)
+    (void)file;
+    (void)line;
+
+    if ((ptr != NULL) && (header == NULL))
     {
-        /* Codes_SRS_GBALLOC_01_041: [If gballoc was not initialized gballoc_realloc shall shall simply call realloc without any memory tracking being performed.] */
-        result = realloc(ptr, size);
+        /* Codes_SRS_GBALLOC_01_055: [When built with GB_USE_SIZE_HEADER and ptr does not carry a gballoc header, gballoc_realloc shall simply call realloc without any memory tracking being performed.] */
+        result = underlying_realloc(ptr, size);
     }
-    /* Codes_SRS_GBALLOC_01_032: [gballoc_realloc shall ensure thread safety by using the lock created by gballoc_Init.] */
-    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    else if (gballocState != GBALLOC_STATE_INIT)
     {
-        /* Codes_SRS_GBALLOC_01_047: [If acquiring the lock fails, gballoc_realloc shall return NULL.] */
-        LogError("Failed to get the Lock.");
+        if (header == NULL)
+        {
+            /* Codes_SRS_GBALLOC_01_041: [If gballoc was not initialized gballoc_realloc shall shall simply call realloc without any memory tracking being performed.] */
+            result = underlying_realloc(ptr, size);
+        }
+        else
+        {
+            /* the block was tracked, it keeps its header so that it can still be told apart */
+            GBALLOC_HEADER* new_header = (GBALLOC_HEADER*)underlying_realloc(header, sizeof(GBALLOC_HEADER) + size);
+            if (new_header == NULL)
+            {
+                result = NULL;
+            }
+            else
+            {
+                new_header->info.size = size;
+                new_header->info.magic = GBALLOC_HEADER_MAGIC_OF(size, GBALLOC_BUDGET_NONE);
+                result = new_header + 1;
+            }
+        }
+    }
+    else if (size > SIZE_MAX - sizeof(GBALLOC_HEADER))
+    {
+        LogError("Invalid size: %lu", (unsigned long)size);
+        result = NULL;
+    }
+    /* Codes_SRS_GBALLOC_01_105: [A reallocation shall count the new size in the budget of the calling thread before giving the old size back to the budget of the block, since both blocks may exist at once.] */
+    else if (charge_budget(current_budget, size) != 0)
+    {
+        notify_budget_exceeded(current_budget, size);
         result = NULL;
     }
     else
     {
-        if (ptr == NULL)
+        size_t old_size = (header == NULL) ? 0 : header->info.size;
+        int old_budget = (header == NULL) ? GBALLOC_BUDGET_NONE : get_header_budget(header);
+        uintptr_t old_address = (uintptr_t)header;
+        GBALLOC_HEADER* new_header;
+
+        /* the header is invalidated before the block may move, the old shard gives the size back */
+        if (header != NULL)
         {
-            /* Codes_SRS_GBALLOC_01_017: [When ptr is NULL, gballoc_realloc shall call the underlying realloc with ptr being NULL and the realloc result shall be tracked by gballoc.] */
-            allocation = (ALLOCATION*)malloc(sizeof(ALLOCATION));
+            count_free(header);
+            header->info.magic = 0;
         }
-        else
+
+        /* Codes_SRS_GBALLOC_01_017: [When ptr is NULL, gballoc_realloc shall call the underlying realloc with ptr being NULL and the realloc result shall be tracked by gballoc.] */
+        new_header = (GBALLOC_HEADER*)underlying_realloc(header, sizeof(GBALLOC_HEADER) + size);
+        if (new_header == NULL)
         {
-            curr = head;
-            while (curr != NULL)
+            /* Codes_SRS_GBALLOC_01_014: [When the underlying realloc call fails, gballoc_realloc shall return NULL and no change should be made to the counted total memory usage.] */
+            if (header != NULL)
             {
-                if (curr->ptr == ptr)
-                {
-                    allocation = curr;
-                    break;
-                }
-                else
-                {
-                    curr = (ALLOCATION*)curr->next;
-                }
+                header->info.magic = GBALLOC_HEADER_MAGIC_OF(old_size, old_budget);
+                (void)__sync_add_and_fetch(&get_shard(header)->counters.current_size, old_size);
             }
-        }
 
-        if (allocation == NULL)
-        {
-            /* Codes_SRS_GBALLOC_01_015: [When allocating memory used for tracking by gballoc_realloc fails, gballoc_realloc shall return NULL and no change should be made to the counted total memory usage.] */
-            /* Codes_SRS_GBALLOC_01_016: [When the ptr pointer cannot be found in the pointers tracked by gballoc, gballoc_realloc shall return NULL and the underlying realloc shall not be called.] */
+            uncharge_budget(current_budget, size);
             result = NULL;
         }
         else
         {
-            result = realloc(ptr, size);
-            if (result == NULL)
-            {
-                /* Codes_SRS_GBALLOC_01_014: [When the underlying realloc call fails, gballoc_realloc shall return NULL and no change should be made to the counted total memory usage.] */
-                if (ptr == NULL)
-                {
-                    free(allocation);
-                }
-            }
-            else
+            /* Codes_SRS_GBALLOC_01_006: [If the underlying realloc call is successful, gballoc_realloc shall look up the size associated with the pointer ptr and decrease the total memory used with that size.] */
+            /* Codes_SRS_GBALLOC_01_007: [If realloc is successful, gballoc_realloc shall also increment the total memory used value tracked by this module.] */
+            result = track_block(new_header, size, current_budget);
+            uncharge_budget(old_budget, old_size);
+            if (header != NULL)
             {
-                if (ptr != NULL)
-                {
-                    /* Codes_SRS_GBALLOC_01_006: [If the underlying realloc call is successful, gballoc_realloc shall look up the size associated with the pointer ptr and decrease the total memory used with that size.] */
-                    allocation->ptr = result;
-                    totalSize -= allocation->size;
-                    allocation->size = size;
-                }
-                else
-                {
-                    /* add block */
-                    allocation->ptr = result;
-                    allocation->size = size;
-                    allocation->next = head;
-                    head = allocation;
-                }
-
-                /* Codes_SRS_GBALLOC_01_007: [If realloc is successful, gballoc_realloc shall also increment the total memory used value tracked by this module.] */
-                totalSize += size;
-                g_allocations++;
-
-                /* Codes_SRS_GBALLOC_01_011: [The maximum total memory used shall be the maximum of the total memory used at any point.] */
-                if (maxSize < totalSize)
-                {
-                    maxSize = totalSize;
-                }
+                count_reallocation(get_shard_statistics(new_header), old_size, size, (uintptr_t)new_header != old_address);
             }
         }
-
-        (void)Unlock(gballocThreadSafeLock);
     }
 
     return result;
 }
 
-void gballoc_free(void* ptr)
+/* size is the size of ptr when the caller knows it, GBALLOC_UNKNOWN_SIZE otherwise */
+static void heap_free(void* ptr, size_t size)
 {
-    ALLOCATION* curr = head;
-    ALLOCATION* prev = NULL;
+    GBALLOC_HEADER* header = get_header(ptr);
 
-    if (gballocState != GBALLOC_STATE_INIT)
-    {
-        /* Codes_SRS_GBALLOC_01_042: [If gballoc was not initialized gballoc_free shall shall simply call free.] */
-        free(ptr);
-    }
-    /* Codes_SRS_GBALLOC_01_033: [gballoc_free shall ensure thread safety by using the lock created by gballoc_Init.] */
-    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    if (header == NULL)
     {
-        /* Codes_SRS_GBALLOC_01_049: [If acquiring the lock fails, gballoc_free shall do nothing.] */
-        LogError("Failed to get the Lock.");
+        /* Codes_SRS_GBALLOC_01_056: [When built with GB_USE_SIZE_HEADER and ptr does not carry a gballoc header, gballoc_free shall simply call free.] */
+        underlying_free_sized(ptr, size);
     }
     else
     {
-        /* Codes_SRS_GBALLOC_01_009: [gballoc_free shall also look up the size associated with the ptr pointer and decrease the total memory used with the associated size amount.] */
-        while (curr != NULL)
+        /* Codes_SRS_GBALLOC_01_057: [When built with GB_USE_SIZE_HEADER, gballoc_free shall read the size from the header in front of ptr, decrease the total memory used with it and free the header and block in one call.] */
+        if (gballocState == GBALLOC_STATE_INIT)
         {
-            if (curr->ptr == ptr)
-            {
-                /* Codes_SRS_GBALLOC_01_008: [gballoc_free shall call the C99 free function.] */
-                free(ptr);
-                totalSize -= curr->size;
-                if (prev != NULL)
-                {
-                    prev->next = curr->next;
-                }
-                else
-                {
-                    head = (ALLOCATION*)curr->next;
-                }
-
-                free(curr);
-                break;
-            }
-
-            prev = curr;
-            curr = (ALLOCATION*)curr->next;
+            count_free(header);
+            /* Codes_SRS_GBALLOC_01_107: [Freeing a block shall give its size back to the budget it was allocated or last reallocated in.] */
+            uncharge_budget(get_header_budget(header), header->info.size);
         }
 
-        if ((curr == NULL) && (ptr != NULL))
-        {
-            /* Codes_SRS_GBALLOC_01_019: [When the ptr pointer cannot be found in the pointers tracked by gballoc, gballoc_free shall not free any memory.] */
-
-            /* could not find the allocation */
-            LogError("Could not free allocation for address %p (not found)", ptr);
-        }
-        (void)Unlock(gballocThreadSafeLock);
+        /* a double free trips over the cleared magic instead of corrupting the counters */
+        header->info.magic = 0;
+        /* Codes_SRS_GBALLOC_01_096: [When the block is tracked, gballoc_free and gballoc_free_sized shall give free_sized_function the size recorded by gballoc, including the size of its own bookkeeping.] */
+        underlying_free_sized(header, sizeof(GBALLOC_HEADER) + header->info.size);
     }
 }
 
@@ -349,18 +614,15 @@ size_t gballoc_getMaximumMemoryUsed(void)
         LogError("gballoc is not initialized.");
         result = SIZE_MAX;
     }
-    /* Codes_SRS_GBALLOC_01_034: [gballoc_getMaximumMemoryUsed shall ensure thread safety by using the lock created by gballoc_Init.]  */
-    else if (LOCK_OK != Lock(gballocThreadSafeLock))
-    {
-        /* Codes_SRS_GBALLOC_01_050: [If the lock cannot be acquired, gballoc_getMaximumMemoryUsed shall return SIZE_MAX.]  */
-        LogError("Failed to get the Lock.");
-        result = SIZE_MAX;
-    }
     else
     {
-        /* Codes_SRS_GBALLOC_01_010: [gballoc_getMaximumMemoryUsed shall return the maximum amount of total memory used recorded since the module initialization.] */
+        /* Codes_SRS_GBALLOC_01_058: [When built with GB_USE_SIZE_HEADER, the maximum shall be updated each time a shard reaches a new high and may therefore under-report a peak reached while other shards were shrinking.] */
+        size_t current_size = get_current_size();
         result = maxSize;
-        (void)Unlock(gballocThreadSafeLock);
+        if (result < current_size)
+        {
+            result = current_size;
+        }
     }
 
     return result;
@@ -376,18 +638,10 @@ size_t gballoc_getCurrentMemoryUsed(void)
         LogError("gballoc is not initialized.");
         result = SIZE_MAX;
     }
-    /* Codes_SRS_GBALLOC_01_036: [gballoc_getCurrentMemoryUsed shall ensure thread safety by using the lock created by gballoc_Init.]*/
-    else if (LOCK_OK != Lock(gballocThreadSafeLock))
-    {
-        /* Codes_SRS_GBALLOC_01_051: [If the lock cannot be acquired, gballoc_getCurrentMemoryUsed shall return SIZE_MAX.] */
-        LogError("Failed to get the Lock.");
-        result = SIZE_MAX;
-    }
     else
     {
-        /*Codes_SRS_GBALLOC_02_001: [gballoc_getCurrentMemoryUsed shall return the currently used memory size.] */
-        result = totalSize;
-        (void)Unlock(gballocThreadSafeLock);
+        /* Codes_SRS_GBALLOC_01_059: [When built with GB_USE_SIZE_HEADER, gballoc_getCurrentMemoryUsed shall return the sum of the per shard memory used.] */
+        result = get_current_size();
     }
 
     return result;
@@ -403,18 +657,16 @@ size_t gballoc_getAllocationCount(void)
         LogError("gballoc is not initialized.");
         result = 0;
     }
-    /* Codes_SRS_GBALLOC_07_002: [ gballoc_getAllocationCount shall ensure thread safety by using the lock created by gballoc_Init ] */
-    else if (LOCK_OK != Lock(gballocThreadSafeLock))
-    {
-        /* Codes_SRS_GBALLOC_07_003: [ If the lock cannot be acquired, gballoc_getAllocationCount shall return 0. ] */
-        LogError("Failed to get the Lock.");
-        result = 0;
-    }
     else
     {
+        size_t i;
+
         /* Codes_SRS_GBALLOC_07_004: [ gballoc_getAllocationCount shall return the currently number of allocations. ] */
-        result = g_allocations;
-        (void)Unlock(gballocThreadSafeLock);
+        result = 0;
+        for (i = 0; i < GBALLOC_SHARD_COUNT; i++)
+        {
+            result += __sync_fetch_and_add(&shards[i].counters.allocation_count, 0);
+        }
     }
 
     return result;
@@ -427,20 +679,1352 @@ void gballoc_resetMetrics()
     {
         LogError("gballoc is not initialized.");
     }
-    /* Codes_SRS_GBALLOC_07_006: [ gballoc_resetMetrics shall ensure thread safety by using the lock created by gballoc_Init ]*/
-    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    else
     {
-        /* Codes_SRS_GBALLOC_07_007: [ If the lock cannot be acquired, gballoc_reset Metrics shall do nothing.] */
-        LogError("Failed to get the Lock.");
+        /* Codes_SRS_GBALLOC_07_008: [ gballoc_resetMetrics shall reset the total allocation size, max allocation size and number of allocation to zero. ] */
+        reset_counters();
+    }
+}
+
+static size_t read_counter(size_t* counter)
+{
+    return __sync_fetch_and_add(counter, 0);
+}
+
+int gballoc_getStatistics(GBALLOC_STATISTICS* statistics)
+{
+    int result;
+
+    if (statistics == NULL)
+    {
+        /* Codes_SRS_GBALLOC_01_088: [If statistics is NULL, gballoc_getStatistics shall fail and return a non-zero value.] */
+        LogError("Invalid argument: statistics is NULL");
+        result = __FAILURE__;
+    }
+    else if (gballocState != GBALLOC_STATE_INIT)
+    {
+        /* Codes_SRS_GBALLOC_01_089: [If gballoc was not initialized or the lock cannot be acquired, gballoc_getStatistics shall fail and return a non-zero value.] */
+        LogError("gballoc is not initialized.");
+        result = __FAILURE__;
     }
     else
     {
-        /* Codes_SRS_GBALLOC_07_008: [ gballoc_resetMetrics shall reset the total allocation size, max allocation size and number of allocation to zero. ] */
-        totalSize = 0;
-        maxSize = 0;
-        g_allocations = 0;
-        (void)Unlock(gballocThreadSafeLock);
+        size_t i;
+
+        /* Codes_SRS_GBALLOC_01_091: [When built with GB_USE_SIZE_HEADER, gballoc_getStatistics shall return the sum of the per shard statistics.] */
+        (void)memset(statistics, 0, sizeof(GBALLOC_STATISTICS));
+        for (i = 0; i < GBALLOC_SHARD_COUNT; i++)
+        {
+            GBALLOC_STATISTICS* shard = &shard_statistics[i].statistics;
+            size_t j;
+
+            for (j = 0; j < GBALLOC_SIZE_CLASS_COUNT; j++)
+            {
+                statistics->allocation_size_histogram[j] += read_counter(&shard->allocation_size_histogram[j]);
+                statistics->realloc_growth_histogram[j] += read_counter(&shard->realloc_growth_histogram[j]);
+            }
+
+            statistics->realloc_count += read_counter(&shard->realloc_count);
+            statistics->realloc_grow_count += read_counter(&shard->realloc_grow_count);
+            statistics->realloc_shrink_count += read_counter(&shard->realloc_shrink_count);
+            statistics->realloc_in_place_count += read_counter(&shard->realloc_in_place_count);
+            statistics->realloc_moved_count += read_counter(&shard->realloc_moved_count);
+            statistics->realloc_moved_bytes += read_counter(&shard->realloc_moved_bytes);
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+#else /* GB_USE_SIZE_HEADER */
+
+#if defined(GB_TRACK_ALLOCATION_SITES)
+
+#ifndef GBALLOC_SITE_BUCKET_COUNT
+#define GBALLOC_SITE_BUCKET_COUNT 256
+#endif
+
+typedef struct GBALLOC_SITE_TAG
+{
+    GBALLOC_SITE_INFO info;
+    struct GBALLOC_SITE_TAG* next;
+} GBALLOC_SITE;
+
+#endif
+
+typedef struct ALLOCATION_TAG
+{
+    size_t size;
+    void* ptr;
+    void* next;
+    int budget;
+#if defined(GB_TRACK_ALLOCATION_SITES)
+    /* the site that last sized the block, NULL if the site could not be recorded */
+    GBALLOC_SITE* site;
+#endif
+} ALLOCATION;
+
+typedef enum GBALLOC_STATE_TAG
+{
+    GBALLOC_STATE_INIT,
+    GBALLOC_STATE_NOT_INIT
+} GBALLOC_STATE;
+
+static ALLOCATION* head = NULL;
+static size_t totalSize = 0;
+static size_t maxSize = 0;
+static size_t g_allocations = 0;
+static GBALLOC_STATISTICS statistics;
+static GBALLOC_STATE gballocState = GBALLOC_STATE_NOT_INIT;
+
+static LOCK_HANDLE gballocThreadSafeLock = NULL;
+
+#if defined(GB_TRACK_ALLOCATION_SITES)
+
+/* the sites are hashed by line only, so that the same file reached through different __FILE__ literals is one site */
+static GBALLOC_SITE* site_buckets[GBALLOC_SITE_BUCKET_COUNT];
+static size_t site_count = 0;
+
+static int is_same_file(const char* file, const char* other_file)
+{
+    return (file == other_file) ||
+        ((file != NULL) && (other_file != NULL) && (strcmp(file, other_file) == 0));
+}
+
+/* must be called with the lock held */
+static GBALLOC_SITE* get_site(const char* file, int line)
+{
+    GBALLOC_SITE** bucket = &site_buckets[(unsigned int)line % GBALLOC_SITE_BUCKET_COUNT];
+    GBALLOC_SITE* result;
+
+    for (result = *bucket; result != NULL; result = result->next)
+    {
+        if ((result->info.line == line) && is_same_file(result->info.file, file))
+        {
+            break;
+        }
+    }
+
+    if (result == NULL)
+    {
+        result = (GBALLOC_SITE*)underlying_malloc(sizeof(GBALLOC_SITE));
+        if (result == NULL)
+        {
+            /* the allocation is still counted in the totals, only not attributed */
+            LogError("Failed allocating the allocation site record");
+        }
+        else
+        {
+            (void)memset(&result->info, 0, sizeof(result->info));
+            result->info.file = file;
+            result->info.line = line;
+            result->next = *bucket;
+            *bucket = result;
+            site_count++;
+        }
+    }
+
+    return result;
+}
+
+static void count_site_allocation(ALLOCATION* allocation, const char* file, int line)
+{
+    GBALLOC_SITE* site = get_site(file, line);
+
+    allocation->site = site;
+    if (site != NULL)
+    {
+        site->info.allocation_count++;
+        site->info.current_size += allocation->size;
+        if (site->info.max_size < site->info.current_size)
+        {
+            site->info.max_size = site->info.current_size;
+        }
+    }
+}
+
+static void count_site_free(ALLOCATION* allocation)
+{
+    if (allocation->site != NULL)
+    {
+        allocation->site->info.current_size -= allocation->size;
+        allocation->site = NULL;
+    }
+}
+
+static void reset_site_metrics(void)
+{
+    size_t i;
+
+    for (i = 0; i < GBALLOC_SITE_BUCKET_COUNT; i++)
+    {
+        GBALLOC_SITE* site;
+        for (site = site_buckets[i]; site != NULL; site = site->next)
+        {
+            /* the live blocks are still live, only the history is dropped */
+            site->info.allocation_count = 0;
+            site->info.max_size = site->info.current_size;
+        }
     }
 }
 
+static void free_sites(void)
+{
+    ALLOCATION* allocation;
+    size_t i;
+
+    /* blocks that outlive gballoc must not point at the site records anymore */
+    for (allocation = head; allocation != NULL; allocation = (ALLOCATION*)allocation->next)
+    {
+        allocation->site = NULL;
+    }
+
+    for (i = 0; i < GBALLOC_SITE_BUCKET_COUNT; i++)
+    {
+        while (site_buckets[i] != NULL)
+        {
+            GBALLOC_SITE* next = site_buckets[i]->next;
+            underlying_free(site_buckets[i]);
+            site_buckets[i] = next;
+        }
+    }
+
+    site_count = 0;
+}
+
+#else /* GB_TRACK_ALLOCATION_SITES */
+
+#define count_site_allocation(allocation, file, line) ((void)(file), (void)(line))
+#define count_site_free(allocation) ((void)0)
+
+#endif /* GB_TRACK_ALLOCATION_SITES */
+
+int gballoc_init(void)
+{
+    int result;
+
+    if (gballocState != GBALLOC_STATE_NOT_INIT)
+    {
+        /* Codes_SRS_GBALLOC_01_025: [Init after Init shall fail and return a non-zero value.] */
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_GBALLOC_01_026: [gballoc_Init shall create a lock handle that will be used to make the other gballoc APIs thread-safe.] */
+    else if ((gballocThreadSafeLock = Lock_Init()) == NULL)
+    {
+        /* Codes_SRS_GBALLOC_01_027: [If the Lock creation fails, gballoc_init shall return a non-zero value.]*/
+        result = __FAILURE__;
+    }
+    else
+    {
+        gballocState = GBALLOC_STATE_INIT;
+
+        /* Codes_ SRS_GBALLOC_01_002: [Upon initialization the total memory used and maximum total memory used tracked by the module shall be set to 0.] */
+        totalSize = 0;
+        maxSize = 0;
+        g_allocations = 0;
+        (void)memset(&statistics, 0, sizeof(statistics));
+        /* Codes_SRS_GBALLOC_01_106: [gballoc_init shall set the memory used of all the budgets to 0.] */
+        reset_budgets();
+
+        /* Codes_SRS_GBALLOC_01_024: [gballoc_init shall initialize the gballoc module and return 0 upon success.] */
+        result = 0;
+    }
+
+    return result;
+}
+
+void gballoc_deinit(void)
+{
+    if (gballocState == GBALLOC_STATE_INIT)
+    {
+        /* Codes_SRS_GBALLOC_01_028: [gballoc_deinit shall free all resources allocated by gballoc_init.] */
+#if defined(GB_TRACK_ALLOCATION_SITES)
+        /* Codes_SRS_GBALLOC_01_080: [gballoc_deinit shall free the site records.] */
+        free_sites();
+#endif
+        (void)Lock_Deinit(gballocThreadSafeLock);
+    }
+
+    gballocState = GBALLOC_STATE_NOT_INIT;
+}
+
+static void* heap_malloc(size_t size, const char* file, int line)
+{
+    void* result;
+
+    if (gballocState != GBALLOC_STATE_INIT)
+    {
+        /* Codes_SRS_GBALLOC_01_039: [If gballoc was not initialized gballoc_malloc shall simply call malloc without any memory tracking being performed.] */
+        result = underlying_malloc(size);
+    }
+    /* Codes_SRS_GBALLOC_01_030: [gballoc_malloc shall ensure thread safety by using the lock created by gballoc_Init.] */
+    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    {
+        /* Codes_SRS_GBALLOC_01_048: [If acquiring the lock fails, gballoc_malloc shall return NULL.] */
+        LogError("Failed to get the Lock.");
+        result = NULL;
+    }
+    else
+    {
+        ALLOCATION* allocation;
+        int is_budget_exceeded = 0;
+
+        if (charge_budget(current_budget, size) != 0)
+        {
+            is_budget_exceeded = 1;
+            result = NULL;
+        }
+        else if ((allocation = (ALLOCATION*)underlying_malloc(sizeof(ALLOCATION))) == NULL)
+        {
+            uncharge_budget(current_budget, size);
+            result = NULL;
+        }
+        else
+        {
+            /* Codes_SRS_GBALLOC_01_003: [gb_malloc shall call the C99 malloc function and return its result.] */
+            result = underlying_malloc(size);
+            if (result == NULL)
+            {
+                /* Codes_SRS_GBALLOC_01_012: [When the underlying malloc call fails, gballoc_malloc shall return NULL and size should not be counted towards total memory used.] */
+                underlying_free(allocation);
+                uncharge_budget(current_budget, size);
+            }
+            else
+            {
+                /* Codes_SRS_GBALLOC_01_004: [If the underlying malloc call is successful, gb_malloc shall increment the total memory used with the amount indicated by size.] */
+                allocation->ptr = result;
+                allocation->size = size;
+                allocation->budget = current_budget;
+                allocation->next = head;
+                head = allocation;
+                /* Codes_SRS_GBALLOC_01_075: [When built with GB_TRACK_ALLOCATION_SITES, each tracked allocation shall be counted in the counters of the site identified by file and line.] */
+                count_site_allocation(allocation, file, line);
+                count_allocation_size(&statistics, size);
+
+                g_allocations++;
+                totalSize += size;
+                /* Codes_SRS_GBALLOC_01_011: [The maximum total memory used shall be the maximum of the total memory used at any point.] */
+                if (maxSize < totalSize)
+                {
+                    maxSize = totalSize;
+                }
+            }
+        }
+
+        (void)Unlock(gballocThreadSafeLock);
+
+        if (is_budget_exceeded)
+        {
+            notify_budget_exceeded(current_budget, size);
+        }
+    }
+
+    return result;
+}
+
+static void* heap_calloc(size_t nmemb, size_t size, const char* file, int line)
+{
+    void* result;
+
+    if (gballocState != GBALLOC_STATE_INIT)
+    {
+        /* Codes_SRS_GBALLOC_01_040: [If gballoc was not initialized gballoc_calloc shall simply call calloc without any memory tracking being performed.] */
+        result = underlying_calloc(nmemb, size);
+    }
+    /* Codes_SRS_GBALLOC_01_031: [gballoc_calloc shall ensure thread safety by using the lock created by gballoc_Init]  */
+    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    {
+        /* Codes_SRS_GBALLOC_01_046: [If acquiring the lock fails, gballoc_calloc shall return NULL.] */
+        LogError("Failed to get the Lock.");
+        result = NULL;
+    }
+    else
+    {
+        ALLOCATION* allocation;
+        int is_budget_exceeded = 0;
+
+        if (charge_budget(current_budget, nmemb * size) != 0)
+        {
+            is_budget_exceeded = 1;
+            result = NULL;
+        }
+        else if ((allocation = (ALLOCATION*)underlying_malloc(sizeof(ALLOCATION))) == NULL)
+        {
+            uncharge_budget(current_budget, nmemb * size);
+            result = NULL;
+        }
+        else
+        {
+            /* Codes_SRS_GBALLOC_01_020: [gballoc_calloc shall call the C99 calloc function and return its result.] */
+            result = underlying_calloc(nmemb, size);
+            if (result == NULL)
+            {
+                /* Codes_SRS_GBALLOC_01_022: [When the underlying calloc call fails, gballoc_calloc shall return NULL and size should not be counted towards total memory used.] */
+                underlying_free(allocation);
+                uncharge_budget(current_budget, nmemb * size);
+            }
+            else
+            {
+                /* Codes_SRS_GBALLOC_01_021: [If the underlying calloc call is successful, gballoc_calloc shall increment the total memory used with nmemb*size.] */
+                allocation->ptr = result;
+                allocation->size = nmemb * size;
+                allocation->budget = current_budget;
+                allocation->next = head;
+                head = allocation;
+                /* Codes_SRS_GBALLOC_01_075: [When built with GB_TRACK_ALLOCATION_SITES, each tracked allocation shall be counted in the counters of the site identified by file and line.] */
+                count_site_allocation(allocation, file, line);
+                count_allocation_size(&statistics, allocation->size);
+                g_allocations++;
+
+                totalSize += allocation->size;
+                /* Codes_SRS_GBALLOC_01_011: [The maximum total memory used shall be the maximum of the total memory used at any point.] */
+                if (maxSize < totalSize)
+                {
+                    maxSize = totalSize;
+                }
+            }
+        }
+
+        (void)Unlock(gballocThreadSafeLock);
+
+        if (is_budget_exceeded)
+        {
+            notify_budget_exceeded(current_budget, nmemb * size);
+        }
+    }
+
+    return result;
+}
+
+static void* heap_realloc(void* ptr, size_t size, const char* file, int line)
+{
+    ALLOCATION* curr;
+    void* result;
+    ALLOCATION* allocation = NULL;
+    int is_budget_exceeded = 0;
+
+    if (gballocState != GBALLOC_STATE_INIT)
+    {
+        /* Codes_SRS_GBALLOC_01_041: [If gballoc was not initialized gballoc_realloc shall shall simply call realloc without any memory tracking being performed.] */
+        result = underlying_realloc(ptr, size);
+    }
+    /* Codes_SRS_GBALLOC_01_032: [gballoc_realloc shall ensure thread safety by using the lock created by gballoc_Init.] */
+    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    {
+        /* Codes_SRS_GBALLOC_01_047: [If acquiring the lock fails, gballoc_realloc shall return NULL.] */
+        LogError("Failed to get the Lock.");
+        result = NULL;
+    }
+    else
+    {
+        if (ptr == NULL)
+        {
+            /* Codes_SRS_GBALLOC_01_017: [When ptr is NULL, gballoc_realloc shall call the underlying realloc with ptr being NULL and the realloc result shall be tracked by gballoc.] */
+            allocation = (ALLOCATION*)underlying_malloc(sizeof(ALLOCATION));
+        }
+        else
+        {
+            curr = head;
+            while (curr != NULL)
+            {
+                if (curr->ptr == ptr)
+                {
+                    allocation = curr;
+                    break;
+                }
+                else
+                {
+                    curr = (ALLOCATION*)curr->next;
+                }
+            }
+        }
+
+        if (allocation == NULL)
+        {
+            /* Codes_SRS_GBALLOC_01_015: [When allocating memory used for tracking by gballoc_realloc fails, gballoc_realloc shall return NULL and no change should be made to the counted total memory usage.] */
+            /* Codes_SRS_GBALLOC_01_016: [When the ptr pointer cannot be found in the pointers tracked by gballoc, gballoc_realloc shall return NULL and the underlying realloc shall not be called.] */
+            result = NULL;
+        }
+        /* Codes_SRS_GBALLOC_01_105: [A reallocation shall count the new size in the budget of the calling thread before giving the old size back to the budget of the block, since both blocks may exist at once.] */
+        else if (charge_budget(current_budget, size) != 0)
+        {
+            if (ptr == NULL)
+            {
+                underlying_free(allocation);
+            }
+
+            is_budget_exceeded = 1;
+            result = NULL;
+        }
+        else
+        {
+            uintptr_t old_address = (uintptr_t)ptr;
+
+            result = underlying_realloc(ptr, size);
+            if (result == NULL)
+            {
+                /* Codes_SRS_GBALLOC_01_014: [When the underlying realloc call fails, gballoc_realloc shall return NULL and no change should be made to the counted total memory usage.] */
+                if (ptr == NULL)
+                {
+                    underlying_free(allocation);
+                }
+                uncharge_budget(current_budget, size);
+            }
+            else
+            {
+                if (ptr != NULL)
+                {
+                    count_reallocation(&statistics, allocation->size, size, (uintptr_t)result != old_address);
+
+                    /* Codes_SRS_GBALLOC_01_006: [If the underlying realloc call is successful, gballoc_realloc shall look up the size associated with the pointer ptr and decrease the total memory used with that size.] */
+                    allocation->ptr = result;
+                    totalSize -= allocation->size;
+                    /* Codes_SRS_GBALLOC_01_076: [When built with GB_TRACK_ALLOCATION_SITES, a reallocated block shall be given back to the site that last sized it and be counted in the site of the reallocation.] */
+                    count_site_free(allocation);
+                    uncharge_budget(allocation->budget, allocation->size);
+                    allocation->size = size;
+                }
+                else
+                {
+                    /* add block */
+                    allocation->ptr = result;
+                    allocation->size = size;
+                    allocation->next = head;
+                    head = allocation;
+                }
+
+                allocation->budget = current_budget;
+
+                count_site_allocation(allocation, file, line);
+                count_allocation_size(&statistics, size);
+
+                /* Codes_SRS_GBALLOC_01_007: [If realloc is successful, gballoc_realloc shall also increment the total memory used value tracked by this module.] */
+                totalSize += size;
+                g_allocations++;
+
+                /* Codes_SRS_GBALLOC_01_011: [The maximum total memory used shall be the maximum of the total memory used at any point.] */
+                if (maxSize < totalSize)
+                {
+                    maxSize = totalSize;
+                }
+            }
+        }
+
+        (void)Unlock(gballocThreadSafeLock);
+
+        if (is_budget_exceeded)
+        {
+            notify_budget_exceeded(current_budget, size);
+        }
+    }
+
+    return result;
+}
+
+/* size is the size of ptr when the caller knows it, GBALLOC_UNKNOWN_SIZE otherwise */
+static void heap_free(void* ptr, size_t size)
+{
+    ALLOCATION* curr;
+    ALLOCATION* prev = NULL;
+
+    if (gballocState != GBALLOC_STATE_INIT)
+    {
+        /* Codes_SRS_GBALLOC_01_042: [If gballoc was not initialized gballoc_free shall shall simply call free.] */
+        underlying_free_sized(ptr, size);
+    }
+    /* Codes_SRS_GBALLOC_01_033: [gballoc_free shall ensure thread safety by using the lock created by gballoc_Init.] */
+    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    {
+        /* Codes_SRS_GBALLOC_01_049: [If acquiring the lock fails, gballoc_free shall do nothing.] */
+        LogError("Failed to get the Lock.");
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_01_009: [gballoc_free shall also look up the size associated with the ptr pointer and decrease the total memory used with the associated size amount.] */
+        curr = head;
+        while (curr != NULL)
+        {
+            if (curr->ptr == ptr)
+            {
+                /* Codes_SRS_GBALLOC_01_008: [gballoc_free shall call the C99 free function.] */
+                /* Codes_SRS_GBALLOC_01_096: [When the block is tracked, gballoc_free and gballoc_free_sized shall give free_sized_function the size recorded by gballoc, including the size of its own bookkeeping.] */
+                underlying_free_sized(ptr, curr->size);
+                totalSize -= curr->size;
+                /* Codes_SRS_GBALLOC_01_107: [Freeing a block shall give its size back to the budget it was allocated or last reallocated in.] */
+                uncharge_budget(curr->budget, curr->size);
+                /* Codes_SRS_GBALLOC_01_077: [When built with GB_TRACK_ALLOCATION_SITES, gballoc_free shall decrease the memory used of the site that last sized the block.] */
+                count_site_free(curr);
+                if (prev != NULL)
+                {
+                    prev->next = curr->next;
+                }
+                else
+                {
+                    head = (ALLOCATION*)curr->next;
+                }
+
+                underlying_free_sized(curr, sizeof(ALLOCATION));
+                break;
+            }
+
+            prev = curr;
+            curr = (ALLOCATION*)curr->next;
+        }
+
+        if ((curr == NULL) && (ptr != NULL))
+        {
+            /* Codes_SRS_GBALLOC_01_019: [When the ptr pointer cannot be found in the pointers tracked by gballoc, gballoc_free shall not free any memory.] */
+
+            /* could not find the allocation */
+            LogError("Could not free allocation for address %p (not found)", ptr);
+        }
+        (void)Unlock(gballocThreadSafeLock);
+    }
+}
+
+size_t gballoc_getMaximumMemoryUsed(void)
+{
+    size_t result;
+
+    /* Codes_SRS_GBALLOC_01_038: [If gballoc was not initialized gballoc_getMaximumMemoryUsed shall return MAX_INT_SIZE.] */
+    if (gballocState != GBALLOC_STATE_INIT)
+    {
+        LogError("gballoc is not initialized.");
+        result = SIZE_MAX;
+    }
+    /* Codes_SRS_GBALLOC_01_034: [gballoc_getMaximumMemoryUsed shall ensure thread safety by using the lock created by gballoc_Init.]  */
+    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    {
+        /* Codes_SRS_GBALLOC_01_050: [If the lock cannot be acquired, gballoc_getMaximumMemoryUsed shall return SIZE_MAX.]  */
+        LogError("Failed to get the Lock.");
+        result = SIZE_MAX;
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_01_010: [gballoc_getMaximumMemoryUsed shall return the maximum amount of total memory used recorded since the module initialization.] */
+        result = maxSize;
+        (void)Unlock(gballocThreadSafeLock);
+    }
+
+    return result;
+}
+
+size_t gballoc_getCurrentMemoryUsed(void)
+{
+    size_t result;
+
+    /* Codes_SRS_GBALLOC_01_044: [If gballoc was not initialized gballoc_getCurrentMemoryUsed shall return SIZE_MAX.] */
+    if (gballocState != GBALLOC_STATE_INIT)
+    {
+        LogError("gballoc is not initialized.");
+        result = SIZE_MAX;
+    }
+    /* Codes_SRS_GBALLOC_01_036: [gballoc_getCurrentMemoryUsed shall ensure thread safety by using the lock created by gballoc_Init.]*/
+    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    {
+        /* Codes_SRS_GBALLOC_01_051: [If the lock cannot be acquired, gballoc_getCurrentMemoryUsed shall return SIZE_MAX.] */
+        LogError("Failed to get the Lock.");
+        result = SIZE_MAX;
+    }
+    else
+    {
+        /*Codes_SRS_GBALLOC_02_001: [gballoc_getCurrentMemoryUsed shall return the currently used memory size.] */
+        result = totalSize;
+        (void)Unlock(gballocThreadSafeLock);
+    }
+
+    return result;
+}
+
+size_t gballoc_getAllocationCount(void)
+{
+    size_t result;
+
+    /* Codes_SRS_GBALLOC_07_001: [ If gballoc was not initialized gballoc_getAllocationCount shall return 0. ] */
+    if (gballocState != GBALLOC_STATE_INIT)
+    {
+        LogError("gballoc is not initialized.");
+        result = 0;
+    }
+    /* Codes_SRS_GBALLOC_07_002: [ gballoc_getAllocationCount shall ensure thread safety by using the lock created by gballoc_Init ] */
+    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    {
+        /* Codes_SRS_GBALLOC_07_003: [ If the lock cannot be acquired, gballoc_getAllocationCount shall return 0. ] */
+        LogError("Failed to get the Lock.");
+        result = 0;
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_07_004: [ gballoc_getAllocationCount shall return the currently number of allocations. ] */
+        result = g_allocations;
+        (void)Unlock(gballocThreadSafeLock);
+    }
+
+    return result;
+}
+
+void gballoc_resetMetrics()
+{
+    /* Codes_SRS_GBALLOC_07_005: [ If gballoc was not initialized gballoc_reset Metrics shall do nothing.] */
+    if (gballocState != GBALLOC_STATE_INIT)
+    {
+        LogError("gballoc is not initialized.");
+    }
+    /* Codes_SRS_GBALLOC_07_006: [ gballoc_resetMetrics shall ensure thread safety by using the lock created by gballoc_Init ]*/
+    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    {
+        /* Codes_SRS_GBALLOC_07_007: [ If the lock cannot be acquired, gballoc_reset Metrics shall do nothing.] */
+        LogError("Failed to get the Lock.");
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_07_008: [ gballoc_resetMetrics shall reset the total allocation size, max allocation size and number of allocation to zero. ] */
+        totalSize = 0;
+        maxSize = 0;
+        g_allocations = 0;
+        /* Codes_SRS_GBALLOC_01_090: [gballoc_resetMetrics shall also reset the statistics.] */
+        (void)memset(&statistics, 0, sizeof(statistics));
+#if defined(GB_TRACK_ALLOCATION_SITES)
+        /* Codes_SRS_GBALLOC_01_078: [When built with GB_TRACK_ALLOCATION_SITES, gballoc_resetMetrics shall reset the allocation count of each site and set its maximum to the memory it currently uses.] */
+        reset_site_metrics();
+#endif
+        (void)Unlock(gballocThreadSafeLock);
+    }
+}
+
+int gballoc_getStatistics(GBALLOC_STATISTICS* statistics_copy)
+{
+    int result;
+
+    if (statistics_copy == NULL)
+    {
+        /* Codes_SRS_GBALLOC_01_088: [If statistics is NULL, gballoc_getStatistics shall fail and return a non-zero value.] */
+        LogError("Invalid argument: statistics is NULL");
+        result = __FAILURE__;
+    }
+    else if (gballocState != GBALLOC_STATE_INIT)
+    {
+        /* Codes_SRS_GBALLOC_01_089: [If gballoc was not initialized or the lock cannot be acquired, gballoc_getStatistics shall fail and return a non-zero value.] */
+        LogError("gballoc is not initialized.");
+        result = __FAILURE__;
+    }
+    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    {
+        LogError("Failed to get the Lock.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_01_092: [gballoc_getStatistics shall copy the statistics gathered since gballoc_init or gballoc_resetMetrics to statistics and return 0.] */
+        *statistics_copy = statistics;
+        (void)Unlock(gballocThreadSafeLock);
+        result = 0;
+    }
+
+    return result;
+}
+
+#if defined(GB_TRACK_ALLOCATION_SITES)
+
+static int compare_site_max_size(const void* left, const void* right)
+{
+    const GBALLOC_SITE_INFO* left_site = (const GBALLOC_SITE_INFO*)left;
+    const GBALLOC_SITE_INFO* right_site = (const GBALLOC_SITE_INFO*)right;
+
+    return (left_site->max_size < right_site->max_size) ? 1 :
+        (left_site->max_size > right_site->max_size) ? -1 : 0;
+}
+
+/* copies all the sites, largest max_size first, the copy is freed by the caller */
+static int copy_sites(GBALLOC_SITE_INFO** sites, size_t* count)
+{
+    int result;
+
+    if (gballocState != GBALLOC_STATE_INIT)
+    {
+        LogError("gballoc is not initialized.");
+        result = __FAILURE__;
+    }
+    else if (LOCK_OK != Lock(gballocThreadSafeLock))
+    {
+        LogError("Failed to get the Lock.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* one spare entry so that there is something to allocate when there are no sites */
+        *sites = (GBALLOC_SITE_INFO*)underlying_malloc((site_count + 1) * sizeof(GBALLOC_SITE_INFO));
+        if (*sites == NULL)
+        {
+            LogError("Failed allocating the copy of %lu sites", (unsigned long)site_count);
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t i;
+
+            *count = 0;
+            for (i = 0; i < GBALLOC_SITE_BUCKET_COUNT; i++)
+            {
+                GBALLOC_SITE* site;
+                for (site = site_buckets[i]; site != NULL; site = site->next)
+                {
+                    (*sites)[(*count)++] = site->info;
+                }
+            }
+
+            result = 0;
+        }
+
+        (void)Unlock(gballocThreadSafeLock);
+
+        /* sorting happens outside of the lock, the copy is private */
+        if (result == 0)
+        {
+            qsort(*sites, *count, sizeof(GBALLOC_SITE_INFO), compare_site_max_size);
+        }
+    }
+
+    return result;
+}
+
+int gballoc_getAllocationSites(GBALLOC_SITE_INFO* sites, size_t site_count_to_fill, size_t* total_site_count)
+{
+    int result;
+    GBALLOC_SITE_INFO* all_sites;
+    size_t all_site_count;
+
+    if ((total_site_count == NULL) ||
+        ((sites == NULL) && (site_count_to_fill > 0)))
+    {
+        /* Codes_SRS_GBALLOC_01_081: [If total_site_count is NULL, or sites is NULL and site_count is not 0, gballoc_getAllocationSites shall fail and return a non-zero value.] */
+        LogError("Invalid arguments: sites=%p, site_count=%lu, total_site_count=%p",
+            sites, (unsigned long)site_count_to_fill, total_site_count);
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_GBALLOC_01_082: [If gballoc was not initialized or the lock cannot be acquired, gballoc_getAllocationSites shall fail and return a non-zero value.] */
+    else if (copy_sites(&all_sites, &all_site_count) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+
+        /* Codes_SRS_GBALLOC_01_083: [gballoc_getAllocationSites shall fill sites with up to site_count sites ordered by decreasing max_size, set total_site_count to the number of sites and return 0.] */
+        for (i = 0; (i < site_count_to_fill) && (i < all_site_count); i++)
+        {
+            sites[i] = all_sites[i];
+        }
+
+        *total_site_count = all_site_count;
+        underlying_free(all_sites);
+        result = 0;
+    }
+
+    return result;
+}
+
+void gballoc_dumpAllocationSites(void)
+{
+    GBALLOC_SITE_INFO* all_sites;
+    size_t all_site_count;
+
+    if (copy_sites(&all_sites, &all_site_count) == 0)
+    {
+        size_t i;
+
+        /* Codes_SRS_GBALLOC_01_084: [gballoc_dumpAllocationSites shall log with LogInfo one line per site, ordered by decreasing max_size, with its file, line, allocation count, memory used and maximum memory used.] */
+        LogInfo("gballoc: %lu allocation sites, %lu bytes in use", (unsigned long)all_site_count, (unsigned long)gballoc_getCurrentMemoryUsed());
+        for (i = 0; i < all_site_count; i++)
+        {
+            LogInfo("gballoc: %s:%d: %lu allocations, %lu bytes in use, %lu bytes max",
+                (all_sites[i].file == NULL) ? "(direct)" : all_sites[i].file, all_sites[i].line,
+                (unsigned long)all_sites[i].allocation_count, (unsigned long)all_sites[i].current_size, (unsigned long)all_sites[i].max_size);
+        }
+
+        underlying_free(all_sites);
+    }
+}
+
+#endif /* GB_TRACK_ALLOCATION_SITES */
+
+#endif /* GB_USE_SIZE_HEADER */
+
+/* Arena scopes: between gballoc_arena_begin and gballoc_arena_end the allocations made by the calling thread
+are carved out of large blocks and are all given back at once by gballoc_arena_end */
+
+#ifndef GBALLOC_ARENA_DEFAULT_BLOCK_SIZE
+#define GBALLOC_ARENA_DEFAULT_BLOCK_SIZE 4096
+#endif
+
+typedef union GBALLOC_ARENA_CHUNK_TAG
+{
+    /* the requested size, needed by realloc to know how much to copy */
+    size_t size;
+    /* keeps each chunk aligned the same way malloc aligns a block */
+    long double align_long_double;
+    long long align_long_long;
+    void* align_pointer;
+} GBALLOC_ARENA_CHUNK;
+
+typedef union GBALLOC_ARENA_BLOCK_TAG
+{
+    struct
+    {
+        union GBALLOC_ARENA_BLOCK_TAG* next;
+        size_t size;
+        size_t used;
+        /* offset of the last chunk, which is the only one that can grow in place */
+        size_t last;
+    } info;
+    GBALLOC_ARENA_CHUNK align_chunk;
+} GBALLOC_ARENA_BLOCK;
+
+typedef struct GBALLOC_ARENA_TAG
+{
+    struct GBALLOC_ARENA_TAG* previous;
+    GBALLOC_ARENA_BLOCK* blocks;
+    size_t block_size;
+} GBALLOC_ARENA;
+
+static GBALLOC_THREAD_LOCAL GBALLOC_ARENA* current_arena = NULL;
+
+static unsigned char* get_block_data(GBALLOC_ARENA_BLOCK* block)
+{
+    return (unsigned char*)(block + 1);
+}
+
+/* rounds size up to whole chunks and adds the chunk header, returns 0 on overflow */
+static size_t get_chunk_footprint(size_t size)
+{
+    size_t result;
+
+    if (size > SIZE_MAX - (2 * sizeof(GBALLOC_ARENA_CHUNK)))
+    {
+        result = 0;
+    }
+    else
+    {
+        result = sizeof(GBALLOC_ARENA_CHUNK) + (((size + sizeof(GBALLOC_ARENA_CHUNK) - 1) / sizeof(GBALLOC_ARENA_CHUNK)) * sizeof(GBALLOC_ARENA_CHUNK));
+    }
+
+    return result;
+}
+
+static void* arena_malloc(GBALLOC_ARENA* arena, size_t size, const char* file, int line)
+{
+    void* result;
+    size_t footprint = get_chunk_footprint(size);
+
+    if (footprint == 0)
+    {
+        LogError("Invalid size: %lu", (unsigned long)size);
+        result = NULL;
+    }
+    else
+    {
+        GBALLOC_ARENA_BLOCK* block = arena->blocks;
+
+        if ((block == NULL) || (block->info.size - block->info.used < footprint))
+        {
+            /* Codes_SRS_GBALLOC_01_063: [When the current block cannot hold the allocation, a new block of block_size bytes, or larger if the allocation does not fit in block_size, shall be allocated with the underlying heap.] */
+            size_t new_block_size = (footprint > arena->block_size) ? footprint : arena->block_size;
+            if (new_block_size > SIZE_MAX - sizeof(GBALLOC_ARENA_BLOCK))
+            {
+                LogError("Invalid size: %lu", (unsigned long)size);
+                block = NULL;
+            }
+            else
+            {
+                block = (GBALLOC_ARENA_BLOCK*)heap_malloc(sizeof(GBALLOC_ARENA_BLOCK) + new_block_size, file, line);
+                if (block == NULL)
+                {
+                    /* Codes_SRS_GBALLOC_01_064: [If allocating a new block fails, the allocation shall return NULL.] */
+                    LogError("Failed allocating an arena block of %lu bytes", (unsigned long)new_block_size);
+                }
+                else
+                {
+                    block->info.size = new_block_size;
+                    block->info.used = 0;
+                    block->info.last = 0;
+                    if ((new_block_size > arena->block_size) && (arena->blocks != NULL))
+                    {
+                        /* an oversized block is full right away, the current block keeps serving the small allocations */
+                        block->info.next = arena->blocks->info.next;
+                        arena->blocks->info.next = block;
+                    }
+                    else
+                    {
+                        block->info.next = arena->blocks;
+                        arena->blocks = block;
+                    }
+                }
+            }
+        }
+
+        if (block == NULL)
+        {
+            result = NULL;
+        }
+        else
+        {
+            /* Codes_SRS_GBALLOC_01_062: [Inside an arena scope gballoc_malloc shall carve the allocation out of the current block of the innermost arena of the calling thread without calling the underlying heap.] */
+            GBALLOC_ARENA_CHUNK* chunk = (GBALLOC_ARENA_CHUNK*)(get_block_data(block) + block->info.used);
+            chunk->size = size;
+            block->info.last = block->info.used;
+            block->info.used += footprint;
+            result = chunk + 1;
+        }
+    }
+
+    return result;
+}
+
+/* finds the arena scope of the calling thread, if any, that handed out ptr */
+static GBALLOC_ARENA_BLOCK* find_arena_block(const void* ptr, GBALLOC_ARENA** owner)
+{
+    GBALLOC_ARENA_BLOCK* result = NULL;
+    GBALLOC_ARENA* arena;
+
+    for (arena = current_arena; (arena != NULL) && (result == NULL); arena = arena->previous)
+    {
+        GBALLOC_ARENA_BLOCK* block;
+        for (block = arena->blocks; block != NULL; block = block->info.next)
+        {
+            const unsigned char* data = get_block_data(block);
+            if (((const unsigned char*)ptr >= data) && ((const unsigned char*)ptr < data + block->info.used))
+            {
+                *owner = arena;
+                result = block;
+                break;
+            }
+        }
+    }
+
+    return result;
+}
+
+int gballoc_arena_begin(size_t block_size)
+{
+    int result;
+    GBALLOC_ARENA* arena = (GBALLOC_ARENA*)heap_malloc(sizeof(GBALLOC_ARENA), __FILE__, __LINE__);
+
+    if (arena == NULL)
+    {
+        /* Codes_SRS_GBALLOC_01_061: [If allocating the arena fails, gballoc_arena_begin shall return a non-zero value.] */
+        LogError("Failed allocating the arena");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_01_060: [gballoc_arena_begin shall start a new arena scope for the calling thread, nested in the current one if any, and return 0.] */
+        /* Codes_SRS_GBALLOC_01_071: [If block_size is 0, GBALLOC_ARENA_DEFAULT_BLOCK_SIZE shall be used.] */
+        arena->block_size = (block_size == 0) ? GBALLOC_ARENA_DEFAULT_BLOCK_SIZE : block_size;
+        arena->blocks = NULL;
+        arena->previous = current_arena;
+        current_arena = arena;
+        result = 0;
+    }
+
+    return result;
+}
+
+void gballoc_arena_end(void)
+{
+    GBALLOC_ARENA* arena = current_arena;
+
+    if (arena == NULL)
+    {
+        /* Codes_SRS_GBALLOC_01_070: [If the calling thread has no arena scope, gballoc_arena_end shall do nothing.] */
+        LogError("No arena scope to end");
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_01_069: [gballoc_arena_end shall free all the blocks of the innermost arena of the calling thread and make the enclosing scope, if any, the current one.] */
+        while (arena->blocks != NULL)
+        {
+            GBALLOC_ARENA_BLOCK* next = arena->blocks->info.next;
+            heap_free(arena->blocks, GBALLOC_UNKNOWN_SIZE);
+            arena->blocks = next;
+        }
+
+        current_arena = arena->previous;
+        heap_free(arena, sizeof(GBALLOC_ARENA));
+    }
+}
+
+static void* malloc_at(size_t size, const char* file, int line)
+{
+    void* result;
+
+    if (current_arena != NULL)
+    {
+        result = arena_malloc(current_arena, size, file, line);
+    }
+    else
+    {
+        result = heap_malloc(size, file, line);
+    }
+
+    return result;
+}
+
+static void* calloc_at(size_t nmemb, size_t size, const char* file, int line)
+{
+    void* result;
+
+    if (current_arena == NULL)
+    {
+        result = heap_calloc(nmemb, size, file, line);
+    }
+    else if ((size != 0) && (nmemb > SIZE_MAX / size))
+    {
+        LogError("Invalid size: nmemb=%lu, size=%lu", (unsigned long)nmemb, (unsigned long)size);
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_01_065: [Inside an arena scope gballoc_calloc shall carve nmemb*size bytes out of the arena and zero them.] */
+        result = arena_malloc(current_arena, nmemb * size, file, line);
+        if (result != NULL)
+        {
+            (void)memset(result, 0, nmemb * size);
+        }
+    }
+
+    return result;
+}
+
+static void* realloc_at(void* ptr, size_t size, const char* file, int line)
+{
+    void* result;
+    GBALLOC_ARENA* owner = NULL;
+    GBALLOC_ARENA_BLOCK* block = (ptr == NULL) ? NULL : find_arena_block(ptr, &owner);
+
+    if (block != NULL)
+    {
+        GBALLOC_ARENA_CHUNK* chunk = (GBALLOC_ARENA_CHUNK*)ptr - 1;
+        size_t footprint = get_chunk_footprint(size);
+
+        if ((footprint != 0) &&
+            ((unsigned char*)chunk == get_block_data(block) + block->info.last) &&
+            (block->info.size - block->info.last >= footprint))
+        {
+            /* Codes_SRS_GBALLOC_01_066: [When ptr is the last allocation of its arena block and the block has room for size bytes, gballoc_realloc shall resize it in place and return ptr.] */
+            chunk->size = size;
+            block->info.used = block->info.last + footprint;
+            result = ptr;
+        }
+        else if (size <= chunk->size)
+        {
+            /* Codes_SRS_GBALLOC_01_073: [When ptr was handed out by an arena scope and size is not larger than its current size, gballoc_realloc shall return ptr.] */
+            chunk->size = size;
+            result = ptr;
+        }
+        else
+        {
+            /* Codes_SRS_GBALLOC_01_067: [Otherwise, when ptr was handed out by an arena scope, gballoc_realloc shall allocate size bytes from that same arena and copy the contents of ptr into it.] */
+            result = arena_malloc(owner, size, file, line);
+            if (result != NULL)
+            {
+                (void)memcpy(result, ptr, (chunk->size < size) ? chunk->size : size);
+            }
+        }
+    }
+    else if ((ptr == NULL) && (current_arena != NULL))
+    {
+        result = arena_malloc(current_arena, size, file, line);
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_01_072: [Blocks that were not handed out by an arena scope of the calling thread shall be handled by the underlying heap, also inside a scope.] */
+        result = heap_realloc(ptr, size, file, line);
+    }
+
+    return result;
+}
+
+void* gballoc_malloc(size_t size)
+{
+    /* Codes_SRS_GBALLOC_01_074: [When built with GB_TRACK_ALLOCATION_SITES, the allocations made by calling gballoc_malloc, gballoc_calloc and gballoc_realloc directly shall be counted under a site with a NULL file and line 0.] */
+    return malloc_at(size, NULL, 0);
+}
+
+void* gballoc_calloc(size_t nmemb, size_t size)
+{
+    return calloc_at(nmemb, size, NULL, 0);
+}
+
+void* gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc_at(ptr, size, NULL, 0);
+}
+
+#if defined(GB_TRACK_ALLOCATION_SITES)
+
+/* Codes_SRS_GBALLOC_01_079: [gballoc_malloc_at, gballoc_calloc_at and gballoc_realloc_at shall behave as gballoc_malloc, gballoc_calloc and gballoc_realloc and count the allocation under the site given by file and line.] */
+void* gballoc_malloc_at(size_t size, const char* file, int line)
+{
+    return malloc_at(size, file, line);
+}
+
+void* gballoc_calloc_at(size_t nmemb, size_t size, const char* file, int line)
+{
+    return calloc_at(nmemb, size, file, line);
+}
+
+void* gballoc_realloc_at(void* ptr, size_t size, const char* file, int line)
+{
+    return realloc_at(ptr, size, file, line);
+}
+
+#endif
+
+static void free_block(void* ptr, size_t size)
+{
+    GBALLOC_ARENA* owner;
+
+    if ((ptr != NULL) && (find_arena_block(ptr, &owner) != NULL))
+    {
+        /* Codes_SRS_GBALLOC_01_068: [When ptr was handed out by an arena scope of the calling thread, gballoc_free shall do nothing, the memory is given back by gballoc_arena_end.] */
+    }
+    else
+    {
+        heap_free(ptr, size);
+    }
+}
+
+void gballoc_free(void* ptr)
+{
+    free_block(ptr, GBALLOC_UNKNOWN_SIZE);
+}
+
+void gballoc_free_sized(void* ptr, size_t size)
+{
+    /* Codes_SRS_GBALLOC_01_093: [gballoc_free_sized shall behave as gballoc_free.] */
+    /* Codes_SRS_GBALLOC_01_094: [When the block is not tracked by gballoc and free_sized_function is not NULL, gballoc_free_sized shall call free_sized_function with ptr and size, otherwise it shall call free_function.] */
+    free_block(ptr, size);
+}
+
+int gballoc_set_allocator(const GBALLOC_ALLOCATOR* new_allocator)
+{
+    int result;
+
+    if (gballocState == GBALLOC_STATE_INIT)
+    {
+        /* Codes_SRS_GBALLOC_01_097: [If gballoc is initialized or the calling thread has an arena scope, gballoc_set_allocator shall fail and return a non-zero value.] */
+        LogError("The allocator cannot be replaced while gballoc is initialized");
+        result = __FAILURE__;
+    }
+    else if (current_arena != NULL)
+    {
+        LogError("The allocator cannot be replaced inside an arena scope");
+        result = __FAILURE__;
+    }
+    else if (new_allocator == NULL)
+    {
+        /* Codes_SRS_GBALLOC_01_098: [If allocator is NULL, gballoc_set_allocator shall restore the malloc, calloc, realloc and free functions of the C runtime and return 0.] */
+        GBALLOC_ALLOCATOR default_allocator = GBALLOC_DEFAULT_ALLOCATOR;
+        allocator = default_allocator;
+        result = 0;
+    }
+    else if ((new_allocator->malloc_function == NULL) ||
+        (new_allocator->calloc_function == NULL) ||
+        (new_allocator->realloc_function == NULL) ||
+        (new_allocator->free_function == NULL))
+    {
+        /* Codes_SRS_GBALLOC_01_099: [If any of malloc_function, calloc_function, realloc_function and free_function is NULL, gballoc_set_allocator shall fail and return a non-zero value.] */
+        LogError("Invalid allocator: malloc_function=%p, calloc_function=%p, realloc_function=%p, free_function=%p",
+            (void*)new_allocator->malloc_function, (void*)new_allocator->calloc_function, (void*)new_allocator->realloc_function, (void*)new_allocator->free_function);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_01_095: [gballoc_set_allocator shall make gballoc allocate and free the blocks it gets from the heap, including its own bookkeeping, with the functions of allocator and return 0.] */
+        allocator = *new_allocator;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int is_budget_valid(int budget)
+{
+    return (budget >= GBALLOC_BUDGET_NONE) && (budget < GBALLOC_BUDGET_COUNT);
+}
+
+int gballoc_budget_set_limit(int budget, size_t max_size, ON_GBALLOC_BUDGET_EXCEEDED on_budget_exceeded, void* context)
+{
+    int result;
+
+    if (!is_budget_valid(budget) || (budget == GBALLOC_BUDGET_NONE))
+    {
+        /* Codes_SRS_GBALLOC_01_101: [If budget is not between 1 and GBALLOC_BUDGET_COUNT - 1, gballoc_budget_set_limit shall fail and return a non-zero value.] */
+        LogError("Invalid budget: %d", budget);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_01_100: [gballoc_budget_set_limit shall set the limit of budget to max_size bytes, 0 meaning no limit, and the callback called when an allocation fails because of it, then return 0.] */
+        budgets[budget].on_budget_exceeded = on_budget_exceeded;
+        budgets[budget].on_budget_exceeded_context = context;
+        budgets[budget].max_size = max_size;
+        result = 0;
+    }
+
+    return result;
+}
+
+int gballoc_budget_begin(int budget)
+{
+    int result = current_budget;
+
+    if (!is_budget_valid(budget))
+    {
+        /* Codes_SRS_GBALLOC_01_103: [If budget is not between 0 and GBALLOC_BUDGET_COUNT - 1, gballoc_budget_begin shall leave the budget of the calling thread unchanged.] */
+        LogError("Invalid budget: %d", budget);
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_01_102: [gballoc_budget_begin shall make budget the budget of the allocations of the calling thread and return the budget it had before.] */
+        current_budget = budget;
+    }
+
+    return result;
+}
+
+void gballoc_budget_end(int previous_budget)
+{
+    if (!is_budget_valid(previous_budget))
+    {
+        LogError("Invalid budget: %d", previous_budget);
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_01_108: [gballoc_budget_end shall make previous_budget the budget of the allocations of the calling thread.] */
+        current_budget = previous_budget;
+    }
+}
+
+size_t gballoc_budget_get_used(int budget)
+{
+    size_t result;
+
+    if (!is_budget_valid(budget) || (budget == GBALLOC_BUDGET_NONE))
+    {
+        /* Codes_SRS_GBALLOC_01_110: [If budget is not between 1 and GBALLOC_BUDGET_COUNT - 1, gballoc_budget_get_used shall return 0.] */
+        result = 0;
+    }
+    else
+    {
+        /* Codes_SRS_GBALLOC_01_109: [gballoc_budget_get_used shall return the bytes of the tracked blocks counted in budget that are not freed yet.] */
+        result = budgets[budget].current_size;
+    }
+
+    return result;
+}
+
 #endif // GB_USE_CUSTOM_HEAP
@@ -1,10 +1,74 @@
 // Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
+#include <stdlib.h>
 #include <stddef.h>
+#include <string.h>
+#include <limits.h>
+#include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/hmacsha256.h"
 #include "azure_c_shared_utility/hmac.h"
+#include "azure_c_shared_utility/sha.h"
+#include "azure_c_shared_utility/sha-private.h"
 #include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/constbuffer_array.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+typedef struct HMACSHA256_KEY_CONTEXT_TAG
+{
+    HMACSHA256_STREAM pads;
+} HMACSHA256_KEY_CONTEXT;
+
+/* computes the key XOR ipad and key XOR opad blocks */
+static int compute_padded_keys(const unsigned char* key, size_t keyLen, unsigned char k_ipad[SHA256_Message_Block_Size], unsigned char k_opad[SHA256_Message_Block_Size])
+{
+    uint8_t hashedKey[SHA256HashSize];
+    size_t i;
+    int error = shaSuccess;
+
+    /* keys longer than a block are replaced by their hash, as in hmacReset */
+    if (keyLen > SHA256_Message_Block_Size)
+    {
+        SHA256Context keyHashContext;
+        error = SHA256Reset(&keyHashContext) ||
+            SHA256Input(&keyHashContext, key, (unsigned int)keyLen) ||
+            SHA256Result(&keyHashContext, hashedKey);
+        key = hashedKey;
+        keyLen = SHA256HashSize;
+    }
+
+    if (error == shaSuccess)
+    {
+        (void)memset(k_ipad, 0x36, SHA256_Message_Block_Size);
+        (void)memset(k_opad, 0x5c, SHA256_Message_Block_Size);
+        for (i = 0; i < keyLen; i++)
+        {
+            k_ipad[i] ^= key[i];
+            k_opad[i] ^= key[i];
+        }
+    }
+
+    (void)memset(hashedKey, 0, sizeof(hashedKey));
+
+    return error;
+}
+
+/* starts the inner and outer hashes with the key XOR ipad and key XOR opad blocks */
+static int compute_pads(HMACSHA256_STREAM* pads, const unsigned char* key, size_t keyLen)
+{
+    unsigned char k_ipad[SHA256_Message_Block_Size];
+    unsigned char k_opad[SHA256_Message_Block_Size];
+    int error = compute_padded_keys(key, keyLen, k_ipad, k_opad) ||
+        SHA256Reset(&pads->inner) ||
+        SHA256Input(&pads->inner, k_ipad, sizeof(k_ipad)) ||
+        SHA256Reset(&pads->outer) ||
+        SHA256Input(&pads->outer, k_opad, sizeof(k_opad));
+
+    (void)memset(k_ipad, 0, sizeof(k_ipad));
+    (void)memset(k_opad, 0, sizeof(k_opad));
+
+    return error;
+}
 
 HMACSHA256_RESULT HMACSHA256_ComputeHash(const unsigned char* key, size_t keyLen, const unsigned char* payload, size_t payloadLen, BUFFER_HANDLE hash)
 {
@@ -33,3 +97,333 @@ HMACSHA256_RESULT HMACSHA256_ComputeHash(const unsigned char* key, size_t keyLen
 
     return result;
 }
+
+HMACSHA256_KEY_CONTEXT_HANDLE HMACSHA256_KeyContext_Create(const unsigned char* key, size_t keyLen)
+{
+    HMACSHA256_KEY_CONTEXT* result;
+
+    if ((key == NULL) ||
+        (keyLen == 0))
+    {
+        LogError("Invalid arguments: key = %p, keyLen = %lu", key, (unsigned long)keyLen);
+        result = NULL;
+    }
+    else if ((result = (HMACSHA256_KEY_CONTEXT*)malloc(sizeof(HMACSHA256_KEY_CONTEXT))) == NULL)
+    {
+        LogError("Cannot allocate the HMAC-SHA256 key context");
+    }
+    else if (compute_pads(&result->pads, key, keyLen) != shaSuccess)
+    {
+        LogError("Cannot compute the HMAC-SHA256 pads");
+        free(result);
+        result = NULL;
+    }
+
+    return result;
+}
+
+void HMACSHA256_KeyContext_Destroy(HMACSHA256_KEY_CONTEXT_HANDLE keyContext)
+{
+    if (keyContext == NULL)
+    {
+        LogError("NULL keyContext");
+    }
+    else
+    {
+        /* the states are as secret as the key */
+        (void)memset(keyContext, 0, sizeof(HMACSHA256_KEY_CONTEXT));
+        free(keyContext);
+    }
+}
+
+HMACSHA256_RESULT HMACSHA256_ComputeHashWithKeyContext(HMACSHA256_KEY_CONTEXT_HANDLE keyContext, const unsigned char* payload, size_t payloadLen, BUFFER_HANDLE hash)
+{
+    HMACSHA256_RESULT result;
+
+    if (keyContext == NULL ||
+        payload == NULL ||
+        payloadLen == 0 ||
+        hash == NULL)
+    {
+        result = HMACSHA256_INVALID_ARG;
+    }
+    else
+    {
+        HMACSHA256_STREAM stream = keyContext->pads;
+
+        /* SHA(K XOR opad, SHA(K XOR ipad, text)), starting from the saved pad states */
+        if ((result = HMACSHA256_Stream_Update(&stream, payload, payloadLen)) == HMACSHA256_OK)
+        {
+            result = HMACSHA256_Stream_Final(&stream, hash);
+        }
+    }
+
+    return result;
+}
+
+HMACSHA256_RESULT HMACSHA256_Stream_Init(HMACSHA256_STREAM* stream, const unsigned char* key, size_t keyLen)
+{
+    HMACSHA256_RESULT result;
+
+    if ((stream == NULL) ||
+        (key == NULL) ||
+        (keyLen == 0))
+    {
+        LogError("Invalid arguments: stream = %p, key = %p, keyLen = %lu", stream, key, (unsigned long)keyLen);
+        result = HMACSHA256_INVALID_ARG;
+    }
+    else if (compute_pads(stream, key, keyLen) != shaSuccess)
+    {
+        LogError("Cannot compute the HMAC-SHA256 pads");
+        result = HMACSHA256_ERROR;
+    }
+    else
+    {
+        result = HMACSHA256_OK;
+    }
+
+    return result;
+}
+
+HMACSHA256_RESULT HMACSHA256_Stream_InitWithKeyContext(HMACSHA256_STREAM* stream, HMACSHA256_KEY_CONTEXT_HANDLE keyContext)
+{
+    HMACSHA256_RESULT result;
+
+    if ((stream == NULL) ||
+        (keyContext == NULL))
+    {
+        LogError("Invalid arguments: stream = %p, keyContext = %p", stream, keyContext);
+        result = HMACSHA256_INVALID_ARG;
+    }
+    else
+    {
+        *stream = keyContext->pads;
+        result = HMACSHA256_OK;
+    }
+
+    return result;
+}
+
+HMACSHA256_RESULT HMACSHA256_Stream_Update(HMACSHA256_STREAM* stream, const unsigned char* data, size_t dataLen)
+{
+    HMACSHA256_RESULT result;
+
+    if ((stream == NULL) ||
+        ((data == NULL) && (dataLen != 0)))
+    {
+        LogError("Invalid arguments: stream = %p, data = %p, dataLen = %lu", stream, data, (unsigned long)dataLen);
+        result = HMACSHA256_INVALID_ARG;
+    }
+    else
+    {
+        result = HMACSHA256_OK;
+
+        /* SHA256Input counts bytes in an unsigned int */
+        while ((dataLen > 0) && (result == HMACSHA256_OK))
+        {
+            unsigned int chunkLen = (dataLen > UINT_MAX) ? UINT_MAX : (unsigned int)dataLen;
+
+            if (SHA256Input(&stream->inner, data, chunkLen) != shaSuccess)
+            {
+                LogError("SHA256Input failed");
+                result = HMACSHA256_ERROR;
+            }
+            else
+            {
+                data += chunkLen;
+                dataLen -= chunkLen;
+            }
+        }
+    }
+
+    return result;
+}
+
+HMACSHA256_RESULT HMACSHA256_Stream_Final(HMACSHA256_STREAM* stream, BUFFER_HANDLE hash)
+{
+    HMACSHA256_RESULT result;
+
+    if ((stream == NULL) ||
+        (hash == NULL))
+    {
+        LogError("Invalid arguments: stream = %p, hash = %p", stream, hash);
+        result = HMACSHA256_INVALID_ARG;
+    }
+    else
+    {
+        uint8_t innerDigest[SHA256HashSize];
+
+        if ((BUFFER_enlarge(hash, 32) != 0) ||
+            (SHA256Result(&stream->inner, innerDigest) != shaSuccess) ||
+            (SHA256Input(&stream->outer, innerDigest, SHA256HashSize) != shaSuccess) ||
+            (SHA256Result(&stream->outer, BUFFER_u_char(hash)) != shaSuccess))
+        {
+            LogError("Cannot compute the HMAC-SHA256 result");
+            result = HMACSHA256_ERROR;
+        }
+        else
+        {
+            result = HMACSHA256_OK;
+        }
+
+        /* the states are as secret as the key */
+        (void)memset(stream, 0, sizeof(HMACSHA256_STREAM));
+    }
+
+    return result;
+}
+
+HMACSHA256_RESULT HMACSHA256_ComputeHashOfConstBufferArray(const unsigned char* key, size_t keyLen, CONSTBUFFER_ARRAY_HANDLE payload, BUFFER_HANDLE hash)
+{
+    HMACSHA256_RESULT result;
+    uint32_t bufferCount;
+
+    if ((key == NULL) ||
+        (keyLen == 0) ||
+        (payload == NULL) ||
+        (hash == NULL))
+    {
+        LogError("Invalid arguments: key = %p, keyLen = %lu, payload = %p, hash = %p", key, (unsigned long)keyLen, payload, hash);
+        result = HMACSHA256_INVALID_ARG;
+    }
+    else if (constbuffer_array_get_buffer_count(payload, &bufferCount) != 0)
+    {
+        LogError("constbuffer_array_get_buffer_count failed");
+        result = HMACSHA256_ERROR;
+    }
+    else
+    {
+        HMACSHA256_STREAM stream;
+
+        if ((result = HMACSHA256_Stream_Init(&stream, key, keyLen)) == HMACSHA256_OK)
+        {
+            uint32_t i;
+
+            /* the buffers are read in place, none of them is copied */
+            for (i = 0; (i < bufferCount) && (result == HMACSHA256_OK); i++)
+            {
+                const CONSTBUFFER* content = constbuffer_array_get_buffer_content(payload, i);
+                if (content == NULL)
+                {
+                    LogError("constbuffer_array_get_buffer_content failed for buffer %lu", (unsigned long)i);
+                    result = HMACSHA256_ERROR;
+                }
+                else
+                {
+                    result = HMACSHA256_Stream_Update(&stream, content->buffer, content->size);
+                }
+            }
+
+            if (result == HMACSHA256_OK)
+            {
+                result = HMACSHA256_Stream_Final(&stream, hash);
+            }
+            else
+            {
+                (void)memset(&stream, 0, sizeof(HMACSHA256_STREAM));
+            }
+        }
+    }
+
+    return result;
+}
+
+/* hashes items[0..itemCount), itemCount being at most SHA224_256_LANE_COUNT, as HMACSHA256_ComputeHash does */
+static HMACSHA256_RESULT compute_hash_lanes(HMACSHA256_BATCH_ITEM* items, size_t itemCount)
+{
+    HMACSHA256_RESULT result = HMACSHA256_OK;
+    unsigned char k_ipads[SHA224_256_LANE_COUNT][SHA256_Message_Block_Size];
+    unsigned char k_opads[SHA224_256_LANE_COUNT][SHA256_Message_Block_Size];
+    uint8_t innerDigests[SHA224_256_LANE_COUNT][SHA256HashSize];
+    uint8_t outerDigests[SHA224_256_LANE_COUNT][SHA256HashSize];
+    const uint8_t* ipads[SHA224_256_LANE_COUNT];
+    const uint8_t* opads[SHA224_256_LANE_COUNT];
+    const uint8_t* payloads[SHA224_256_LANE_COUNT];
+    const uint8_t* inners[SHA224_256_LANE_COUNT];
+    size_t payloadLengths[SHA224_256_LANE_COUNT];
+    size_t innerLengths[SHA224_256_LANE_COUNT];
+    size_t i;
+
+    for (i = 0; (i < itemCount) && (result == HMACSHA256_OK); i++)
+    {
+        if (compute_padded_keys(items[i].key, items[i].keyLen, k_ipads[i], k_opads[i]) != shaSuccess)
+        {
+            LogError("Cannot compute the HMAC-SHA256 pads of item %lu", (unsigned long)i);
+            result = HMACSHA256_ERROR;
+        }
+        else
+        {
+            ipads[i] = k_ipads[i];
+            opads[i] = k_opads[i];
+            payloads[i] = items[i].payload;
+            payloadLengths[i] = items[i].payloadLen;
+            inners[i] = innerDigests[i];
+            innerLengths[i] = SHA256HashSize;
+        }
+    }
+
+    /* SHA(K XOR opad, SHA(K XOR ipad, text)) for all the items at once */
+    if ((result == HMACSHA256_OK) &&
+        ((SHA256ComputePrefixedDigests(itemCount, ipads, payloads, payloadLengths, innerDigests) != shaSuccess) ||
+         (SHA256ComputePrefixedDigests(itemCount, opads, inners, innerLengths, outerDigests) != shaSuccess)))
+    {
+        LogError("Cannot compute the HMAC-SHA256 digests");
+        result = HMACSHA256_ERROR;
+    }
+
+    for (i = 0; (i < itemCount) && (result == HMACSHA256_OK); i++)
+    {
+        if (BUFFER_enlarge(items[i].hash, SHA256HashSize) != 0)
+        {
+            LogError("Cannot enlarge the hash buffer of item %lu", (unsigned long)i);
+            result = HMACSHA256_ERROR;
+        }
+        else
+        {
+            (void)memcpy(BUFFER_u_char(items[i].hash), outerDigests[i], SHA256HashSize);
+        }
+    }
+
+    /* the pads and the inner digests are as secret as the keys */
+    (void)memset(k_ipads, 0, sizeof(k_ipads));
+    (void)memset(k_opads, 0, sizeof(k_opads));
+    (void)memset(innerDigests, 0, sizeof(innerDigests));
+
+    return result;
+}
+
+HMACSHA256_RESULT HMACSHA256_ComputeHashBatch(HMACSHA256_BATCH_ITEM* items, size_t itemCount)
+{
+    HMACSHA256_RESULT result;
+    size_t i;
+
+    for (i = 0; (items != NULL) && (i < itemCount); i++)
+    {
+        if ((items[i].key == NULL) ||
+            (items[i].keyLen == 0) ||
+            (items[i].payload == NULL) ||
+            (items[i].payloadLen == 0) ||
+            (items[i].hash == NULL))
+        {
+            break;
+        }
+    }
+
+    if ((items == NULL) ||
+        (itemCount == 0) ||
+        (i < itemCount))
+    {
+        LogError("Invalid arguments: items = %p, itemCount = %lu, invalid item = %lu", items, (unsigned long)itemCount, (unsigned long)i);
+        result = HMACSHA256_INVALID_ARG;
+    }
+    else
+    {
+        result = HMACSHA256_OK;
+        for (i = 0; (i < itemCount) && (result == HMACSHA256_OK); i += SHA224_256_LANE_COUNT)
+        {
+            result = compute_hash_lanes(items + i, ((itemCount - i) < SHA224_256_LANE_COUNT) ? (itemCount - i) : SHA224_256_LANE_COUNT);
+        }
+    }
+
+    return result;
+}
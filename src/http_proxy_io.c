@@ -7,12 +7,20 @@
 #include <stdint.h>
 #include <limits.h>
 #include <stddef.h>
+#include <string.h>
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/xio.h"
 #include "azure_c_shared_utility/socketio.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/http_proxy_io.h"
 #include "azure_c_shared_utility/base64.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+
+/* Only the status line of the CONNECT response is kept, the headers that follow it are skipped */
+#define HTTP_PROXY_IO_MAX_STATUS_LINE_LENGTH    256
+
+static const char end_of_headers[] = "\r\n\r\n";
 
 typedef enum HTTP_PROXY_IO_STATE_TAG
 {
@@ -42,10 +50,43 @@ typedef struct HTTP_PROXY_IO_INSTANCE_TAG
     char* username;
     char* password;
     XIO_HANDLE underlying_io;
-    unsigned char* receive_buffer;
-    size_t receive_buffer_size;
+    char status_line[HTTP_PROXY_IO_MAX_STATUS_LINE_LENGTH + 1];
+    size_t status_line_length;
+    bool status_line_received;
+    int status_code;
+    size_t end_of_headers_matched;
+    XIO_STATS stats;
+    HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool;
+    /* the pooled instance whose underlying IO this instance is using, swapped with its own */
+    struct HTTP_PROXY_IO_INSTANCE_TAG* pooled_tunnel;
+    /* set on a pooled instance once taken, the callbacks of its underlying IO go to that instance */
+    struct HTTP_PROXY_IO_INSTANCE_TAG* adopted_by;
 } HTTP_PROXY_IO_INSTANCE;
 
+typedef enum HTTP_PROXY_TUNNEL_STATE_TAG
+{
+    HTTP_PROXY_TUNNEL_STATE_OPENING,
+    HTTP_PROXY_TUNNEL_STATE_IDLE,
+    HTTP_PROXY_TUNNEL_STATE_FAILED
+} HTTP_PROXY_TUNNEL_STATE;
+
+typedef struct HTTP_PROXY_TUNNEL_TAG
+{
+    HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance;
+    HTTP_PROXY_TUNNEL_STATE state;
+    tickcounter_ms_t idle_since;
+    struct HTTP_PROXY_TUNNEL_POOL_TAG* tunnel_pool;
+    struct HTTP_PROXY_TUNNEL_TAG* next;
+} HTTP_PROXY_TUNNEL;
+
+typedef struct HTTP_PROXY_TUNNEL_POOL_TAG
+{
+    size_t max_tunnels_per_target;
+    tickcounter_ms_t idle_timeout_ms;
+    TICK_COUNTER_HANDLE tick_counter;
+    HTTP_PROXY_TUNNEL* tunnels;
+} HTTP_PROXY_TUNNEL_POOL;
+
 static CONCRETE_IO_HANDLE http_proxy_io_create(void* io_create_parameters)
 {
     HTTP_PROXY_IO_INSTANCE* result;
@@ -184,9 +225,15 @@ static CONCRETE_IO_HANDLE http_proxy_io_create(void* io_create_parameters)
                                     {
                                         result->port = http_proxy_io_config->port;
                                         result->proxy_port = http_proxy_io_config->proxy_port;
-                                        result->receive_buffer = NULL;
-                                        result->receive_buffer_size = 0;
+                                        result->status_line_length = 0;
+                                        result->status_line_received = false;
+                                        result->end_of_headers_matched = 0;
                                         result->http_proxy_io_state = HTTP_PROXY_IO_STATE_CLOSED;
+                                        (void)memset(&result->stats, 0, sizeof(result->stats));
+                                        result->stats.layer_name = "http_proxy_io";
+                                        result->tunnel_pool = NULL;
+                                        result->pooled_tunnel = NULL;
+                                        result->adopted_by = NULL;
                                     }
                                 }
                             }
@@ -200,6 +247,26 @@ static CONCRETE_IO_HANDLE http_proxy_io_create(void* io_create_parameters)
     return result;
 }
 
+static void http_proxy_io_destroy(CONCRETE_IO_HANDLE http_proxy_io);
+static HTTP_PROXY_IO_INSTANCE* take_pooled_tunnel(HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance);
+
+/* Gives back the underlying IO of the instance and destroys the pooled instance with the tunnel it had taken */
+static void release_pooled_tunnel(HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance)
+{
+    if (http_proxy_io_instance->pooled_tunnel != NULL)
+    {
+        HTTP_PROXY_IO_INSTANCE* pooled_tunnel = http_proxy_io_instance->pooled_tunnel;
+        XIO_HANDLE tunnel_io = http_proxy_io_instance->underlying_io;
+
+        http_proxy_io_instance->underlying_io = pooled_tunnel->underlying_io;
+        http_proxy_io_instance->pooled_tunnel = NULL;
+        pooled_tunnel->underlying_io = tunnel_io;
+
+        /* pooled_tunnel->adopted_by stays set, so that whatever the underlying IO still calls back lands on an instance that is not open */
+        http_proxy_io_destroy(pooled_tunnel);
+    }
+}
+
 static void http_proxy_io_destroy(CONCRETE_IO_HANDLE http_proxy_io)
 {
     if (http_proxy_io == NULL)
@@ -212,10 +279,8 @@ static void http_proxy_io_destroy(CONCRETE_IO_HANDLE http_proxy_io)
         HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = (HTTP_PROXY_IO_INSTANCE*)http_proxy_io;
 
         /* Codes_SRS_HTTP_PROXY_IO_01_013: [ http_proxy_io_destroy shall free the HTTP proxy IO instance indicated by http_proxy_io. ]*/
-        if (http_proxy_io_instance->receive_buffer != NULL)
-        {
-            free(http_proxy_io_instance->receive_buffer);
-        }
+        /* Codes_SRS_HTTP_PROXY_IO_01_117: [ If the IO took a tunnel from a tunnel pool, http_proxy_io_destroy shall also destroy the tunnel. ]*/
+        release_pooled_tunnel(http_proxy_io_instance);
 
         /* Codes_SRS_HTTP_PROXY_IO_01_016: [ http_proxy_io_destroy shall destroy the underlying IO created in http_proxy_io_create by calling xio_destroy. ]*/
         xio_destroy(http_proxy_io_instance->underlying_io);
@@ -242,6 +307,14 @@ static void unchecked_on_send_complete(void* context, IO_SEND_RESULT send_result
     (void)send_result;
 }
 
+/* The underlying IO of a tunnel taken from a pool still calls back with the pooled instance as context */
+static HTTP_PROXY_IO_INSTANCE* get_callback_instance(void* context)
+{
+    HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = (HTTP_PROXY_IO_INSTANCE*)context;
+
+    return (http_proxy_io_instance->adopted_by != NULL) ? http_proxy_io_instance->adopted_by : http_proxy_io_instance;
+}
+
 static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_result)
 {
     if (context == NULL)
@@ -251,7 +324,7 @@ static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_re
     }
     else
     {
-        HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = (HTTP_PROXY_IO_INSTANCE*)context;
+        HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = get_callback_instance(context);
         switch (http_proxy_io_instance->http_proxy_io_state)
         {
         default:
@@ -294,6 +367,9 @@ static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_re
 
                 /* Codes_SRS_HTTP_PROXY_IO_01_057: [ When on_underlying_io_open_complete is called, the http_proxy_io shall send the CONNECT request constructed per RFC 2817: ]*/
                 http_proxy_io_instance->http_proxy_io_state = HTTP_PROXY_IO_STATE_WAITING_FOR_CONNECT_RESPONSE;
+                http_proxy_io_instance->status_line_length = 0;
+                http_proxy_io_instance->status_line_received = false;
+                http_proxy_io_instance->end_of_headers_matched = 0;
 
                 if (http_proxy_io_instance->username != NULL)
                 {
@@ -453,7 +529,7 @@ static void on_underlying_io_error(void* context)
     }
     else
     {
-        HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = (HTTP_PROXY_IO_INSTANCE*)context;
+        HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = get_callback_instance(context);
 
         switch (http_proxy_io_instance->http_proxy_io_state)
         {
@@ -485,7 +561,7 @@ static void on_underlying_io_close_complete(void* context)
     }
     else
     {
-        HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = (HTTP_PROXY_IO_INSTANCE*)context;
+        HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = get_callback_instance(context);
 
         switch (http_proxy_io_instance->http_proxy_io_state)
         {
@@ -603,6 +679,78 @@ static int ParseHttpResponse(const char* src, int* dst)
     return result;
 }
 
+static void indicate_received_bytes(HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance, const unsigned char* buffer, size_t size)
+{
+    http_proxy_io_instance->stats.bytes_received += size;
+    http_proxy_io_instance->stats.callback_count++;
+    http_proxy_io_instance->on_bytes_received(http_proxy_io_instance->on_bytes_received_context, buffer, size);
+}
+
+static void count_send(HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance, size_t size)
+{
+    http_proxy_io_instance->stats.send_count++;
+    http_proxy_io_instance->stats.bytes_sent += size;
+}
+
+/* Scans the received bytes for the end of the CONNECT response headers, keeping only the status line.
+   Returns the number of bytes consumed when the end of the headers was found, 0 when more bytes are needed
+   and a value greater than size if the response cannot be parsed. */
+static size_t scan_connect_response(HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance, const unsigned char* buffer, size_t size)
+{
+    size_t result = 0;
+    size_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        unsigned char c = buffer[i];
+
+        if (c == (unsigned char)end_of_headers[http_proxy_io_instance->end_of_headers_matched])
+        {
+            http_proxy_io_instance->end_of_headers_matched++;
+        }
+        else
+        {
+            http_proxy_io_instance->end_of_headers_matched = (c == '\r') ? 1 : 0;
+        }
+
+        if (!http_proxy_io_instance->status_line_received)
+        {
+            if (http_proxy_io_instance->end_of_headers_matched == 2)
+            {
+                /* the CR ending the status line was stored last */
+                http_proxy_io_instance->status_line[http_proxy_io_instance->status_line_length - 1] = '\0';
+                http_proxy_io_instance->status_line_received = true;
+
+                if (ParseHttpResponse(http_proxy_io_instance->status_line, &http_proxy_io_instance->status_code) != 0)
+                {
+                    /* Codes_SRS_HTTP_PROXY_IO_01_068: [ If parsing the CONNECT response fails, the on_open_complete callback shall be triggered with IO_OPEN_ERROR, passing also the on_open_complete_context argument as context. ]*/
+                    LogError("Cannot decode HTTP response");
+                    result = size + 1;
+                    break;
+                }
+            }
+            else if (http_proxy_io_instance->status_line_length == HTTP_PROXY_IO_MAX_STATUS_LINE_LENGTH)
+            {
+                /* Codes_SRS_HTTP_PROXY_IO_01_101: [ If the status line of the CONNECT response is longer than HTTP_PROXY_IO_MAX_STATUS_LINE_LENGTH bytes, the on_open_complete callback shall be triggered with IO_OPEN_ERROR, passing also the on_open_complete_context argument as context. ]*/
+                LogError("CONNECT response status line is too long");
+                result = size + 1;
+                break;
+            }
+            else
+            {
+                http_proxy_io_instance->status_line[http_proxy_io_instance->status_line_length++] = (char)c;
+            }
+        }
+        else if (http_proxy_io_instance->end_of_headers_matched == sizeof(end_of_headers) - 1)
+        {
+            result = i + 1;
+            break;
+        }
+    }
+
+    return result;
+}
+
 static void on_underlying_io_bytes_received(void* context, const unsigned char* buffer, size_t size)
 {
     if (context == NULL)
@@ -612,70 +760,55 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
     }
     else
     {
-        HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = (HTTP_PROXY_IO_INSTANCE*)context;
+        HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = get_callback_instance(context);
 
-        switch (http_proxy_io_instance->http_proxy_io_state)
+        /* once the tunnel is up the bytes go straight to the caller */
+        if (http_proxy_io_instance->http_proxy_io_state == HTTP_PROXY_IO_STATE_OPEN)
         {
-        default:
-        case HTTP_PROXY_IO_STATE_CLOSING:
-            LogError("Bytes received in invalid state");
-            break;
-
-        case HTTP_PROXY_IO_STATE_OPENING_UNDERLYING_IO:
-            /* Codes_SRS_HTTP_PROXY_IO_01_080: [ If on_underlying_io_bytes_received is called while the underlying IO is being opened, the on_open_complete callback shall be triggered with IO_OPEN_ERROR, passing also the on_open_complete_context argument as context. ]*/
-            LogError("Bytes received while opening underlying IO");
-            indicate_open_complete_error_and_close(http_proxy_io_instance);
-            break;
-
-        case HTTP_PROXY_IO_STATE_WAITING_FOR_CONNECT_RESPONSE:
+            /* Codes_SRS_HTTP_PROXY_IO_01_074: [ If on_underlying_io_bytes_received is called while OPEN, all bytes shall be indicated as received by calling the on_bytes_received callback and passing the on_bytes_received_context as context argument. ]*/
+            indicate_received_bytes(http_proxy_io_instance, buffer, size);
+        }
+        else
         {
-            /* Codes_SRS_HTTP_PROXY_IO_01_065: [ When bytes are received and the response to the CONNECT request was not yet received, the bytes shall be accumulated until a double new-line is detected. ]*/
-            unsigned char* new_receive_buffer = (unsigned char*)realloc(http_proxy_io_instance->receive_buffer, http_proxy_io_instance->receive_buffer_size + size + 1);
-            if (new_receive_buffer == NULL)
+            switch (http_proxy_io_instance->http_proxy_io_state)
             {
-                /* Codes_SRS_HTTP_PROXY_IO_01_067: [ If allocating memory for the buffered bytes fails, the on_open_complete callback shall be triggered with IO_OPEN_ERROR, passing also the on_open_complete_context argument as context. ]*/
-                LogError("Cannot allocate memory for received data");
+            default:
+            case HTTP_PROXY_IO_STATE_CLOSING:
+                LogError("Bytes received in invalid state");
+                break;
+
+            case HTTP_PROXY_IO_STATE_OPENING_UNDERLYING_IO:
+                /* Codes_SRS_HTTP_PROXY_IO_01_080: [ If on_underlying_io_bytes_received is called while the underlying IO is being opened, the on_open_complete callback shall be triggered with IO_OPEN_ERROR, passing also the on_open_complete_context argument as context. ]*/
+                LogError("Bytes received while opening underlying IO");
                 indicate_open_complete_error_and_close(http_proxy_io_instance);
-            }
-            else
-            {
-                http_proxy_io_instance->receive_buffer = new_receive_buffer;
-                memcpy(http_proxy_io_instance->receive_buffer + http_proxy_io_instance->receive_buffer_size, buffer, size);
-                http_proxy_io_instance->receive_buffer_size += size;
-            }
+                break;
 
-            if (http_proxy_io_instance->receive_buffer_size >= 4)
+            case HTTP_PROXY_IO_STATE_WAITING_FOR_CONNECT_RESPONSE:
             {
-                const char* request_end_ptr;
-
-                http_proxy_io_instance->receive_buffer[http_proxy_io_instance->receive_buffer_size] = 0;
-
+                /* Codes_SRS_HTTP_PROXY_IO_01_065: [ When bytes are received and the response to the CONNECT request was not yet received, the bytes shall be scanned as they arrive until a double new-line is detected. ]*/
                 /* Codes_SRS_HTTP_PROXY_IO_01_066: [ When a double new-line is detected the response shall be parsed in order to extract the status code. ]*/
-                if ((http_proxy_io_instance->receive_buffer_size >= 4) &&
-                    ((request_end_ptr = strstr((const char*)http_proxy_io_instance->receive_buffer, "\r\n\r\n")) != NULL))
-                {
-                    int status_code;
+                size_t consumed = scan_connect_response(http_proxy_io_instance, buffer, size);
 
+                if (consumed > size)
+                {
+                    indicate_open_complete_error_and_close(http_proxy_io_instance);
+                }
+                else if (consumed > 0)
+                {
                     /* This part should really be done with the HTTPAPI, but that has to be done as a separate step
                     as the HTTPAPI has to expose somehow the underlying IO and currently this would be a too big of a change. */
 
-                    if (ParseHttpResponse((const char*)http_proxy_io_instance->receive_buffer, &status_code) != 0)
-                    {
-                        /* Codes_SRS_HTTP_PROXY_IO_01_068: [ If parsing the CONNECT response fails, the on_open_complete callback shall be triggered with IO_OPEN_ERROR, passing also the on_open_complete_context argument as context. ]*/
-                        LogError("Cannot decode HTTP response");
-                        indicate_open_complete_error_and_close(http_proxy_io_instance);
-                    }
                     /* Codes_SRS_HTTP_PROXY_IO_01_069: [ Any successful (2xx) response to a CONNECT request indicates that the proxy has established a connection to the requested host and port, and has switched to tunneling the current connection to that server connection. ]*/
                     /* Codes_SRS_HTTP_PROXY_IO_01_090: [ Any successful (2xx) response to a CONNECT request indicates that the proxy has established a connection to the requested host and port, and has switched to tunneling the current connection to that server connection. ]*/
-                    else if ((status_code < 200) || (status_code > 299))
+                    if ((http_proxy_io_instance->status_code < 200) || (http_proxy_io_instance->status_code > 299))
                     {
                         /* Codes_SRS_HTTP_PROXY_IO_01_071: [ If the status code is not successful, the on_open_complete callback shall be triggered with IO_OPEN_ERROR, passing also the on_open_complete_context argument as context. ]*/
-                        LogError("Bad status (%d) received in CONNECT response", status_code);
+                        LogError("Bad status (%d) received in CONNECT response", http_proxy_io_instance->status_code);
                         indicate_open_complete_error_and_close(http_proxy_io_instance);
                     }
                     else
                     {
-                        size_t length_remaining = http_proxy_io_instance->receive_buffer + http_proxy_io_instance->receive_buffer_size - ((const unsigned char *)request_end_ptr + 4);
+                        size_t length_remaining = size - consumed;
 
                         /* Codes_SRS_HTTP_PROXY_IO_01_073: [ Once a success status code was parsed, the IO shall be OPEN. ]*/
                         http_proxy_io_instance->http_proxy_io_state = HTTP_PROXY_IO_STATE_OPEN;
@@ -685,17 +818,17 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                         if (length_remaining > 0)
                         {
                             /* Codes_SRS_HTTP_PROXY_IO_01_072: [ Any bytes that are extra (not consumed by the CONNECT response), shall be indicated as received by calling the on_bytes_received callback and passing the on_bytes_received_context as context argument. ]*/
-                            http_proxy_io_instance->on_bytes_received(http_proxy_io_instance->on_bytes_received_context, (const unsigned char*)request_end_ptr + 4, length_remaining);
+                            indicate_received_bytes(http_proxy_io_instance, buffer + consumed, length_remaining);
                         }
                     }
                 }
+                else
+                {
+                    /* the end of the response was not received yet */
+                }
+                break;
+            }
             }
-            break;
-        }
-        case HTTP_PROXY_IO_STATE_OPEN:
-            /* Codes_SRS_HTTP_PROXY_IO_01_074: [ If on_underlying_io_bytes_received is called while OPEN, all bytes shall be indicated as received by calling the on_bytes_received callback and passing the on_bytes_received_context as context argument. ]*/
-            http_proxy_io_instance->on_bytes_received(http_proxy_io_instance->on_bytes_received_context, buffer, size);
-            break;
         }
     }
 }
@@ -729,6 +862,8 @@ static int http_proxy_io_open(CONCRETE_IO_HANDLE http_proxy_io, ON_IO_OPEN_COMPL
         }
         else
         {
+            HTTP_PROXY_IO_INSTANCE* pooled_tunnel;
+
             http_proxy_io_instance->on_bytes_received = on_bytes_received;
             http_proxy_io_instance->on_bytes_received_context = on_bytes_received_context;
 
@@ -738,20 +873,44 @@ static int http_proxy_io_open(CONCRETE_IO_HANDLE http_proxy_io, ON_IO_OPEN_COMPL
             http_proxy_io_instance->on_io_open_complete = on_io_open_complete;
             http_proxy_io_instance->on_io_open_complete_context = on_io_open_complete_context;
 
-            http_proxy_io_instance->http_proxy_io_state = HTTP_PROXY_IO_STATE_OPENING_UNDERLYING_IO;
+            /* Codes_SRS_HTTP_PROXY_IO_01_116: [ Before opening, http_proxy_io_open shall destroy the tunnel taken from a tunnel pool by a previous open and use the underlying IO created in http_proxy_io_create again. ]*/
+            release_pooled_tunnel(http_proxy_io_instance);
 
-            /* Codes_SRS_HTTP_PROXY_IO_01_019: [ http_proxy_io_open shall open the underlying IO by calling xio_open on the underlying IO handle created in http_proxy_io_create, while passing to it the callbacks on_underlying_io_open_complete, on_underlying_io_bytes_received and on_underlying_io_error. ]*/
-            if (xio_open(http_proxy_io_instance->underlying_io, on_underlying_io_open_complete, http_proxy_io_instance, on_underlying_io_bytes_received, http_proxy_io_instance, on_underlying_io_error, http_proxy_io_instance) != 0)
+            if ((http_proxy_io_instance->tunnel_pool != NULL) &&
+                ((pooled_tunnel = take_pooled_tunnel(http_proxy_io_instance)) != NULL))
             {
-                /* Codes_SRS_HTTP_PROXY_IO_01_020: [ If xio_open fails, then http_proxy_io_open shall return a non-zero value. ]*/
-                http_proxy_io_instance->http_proxy_io_state = HTTP_PROXY_IO_STATE_CLOSED;
-                LogError("Cannot open the underlying IO.");
-                result = __LINE__;
+                /* Codes_SRS_HTTP_PROXY_IO_01_113: [ If a tunnel pool was set and it has an idle tunnel to the same target through the same proxy with the same credentials, http_proxy_io_open shall take it instead of opening the underlying IO, and the IO shall be OPEN. ]*/
+                XIO_HANDLE tunnel_io = pooled_tunnel->underlying_io;
+
+                pooled_tunnel->underlying_io = http_proxy_io_instance->underlying_io;
+                pooled_tunnel->adopted_by = http_proxy_io_instance;
+                http_proxy_io_instance->underlying_io = tunnel_io;
+                http_proxy_io_instance->pooled_tunnel = pooled_tunnel;
+                http_proxy_io_instance->http_proxy_io_state = HTTP_PROXY_IO_STATE_OPEN;
+
+                /* Codes_SRS_HTTP_PROXY_IO_01_114: [ When a tunnel is taken from the pool, the on_io_open_complete callback shall be triggered with IO_OPEN_OK before http_proxy_io_open returns. ]*/
+                http_proxy_io_instance->on_io_open_complete(http_proxy_io_instance->on_io_open_complete_context, IO_OPEN_OK);
+
+                /* Codes_SRS_HTTP_PROXY_IO_01_017: [ http_proxy_io_open shall open the HTTP proxy IO and on success it shall return 0. ]*/
+                result = 0;
             }
             else
             {
-                /* Codes_SRS_HTTP_PROXY_IO_01_017: [ http_proxy_io_open shall open the HTTP proxy IO and on success it shall return 0. ]*/
-                result = 0;
+                http_proxy_io_instance->http_proxy_io_state = HTTP_PROXY_IO_STATE_OPENING_UNDERLYING_IO;
+
+                /* Codes_SRS_HTTP_PROXY_IO_01_019: [ http_proxy_io_open shall open the underlying IO by calling xio_open on the underlying IO handle created in http_proxy_io_create, while passing to it the callbacks on_underlying_io_open_complete, on_underlying_io_bytes_received and on_underlying_io_error. ]*/
+                if (xio_open(http_proxy_io_instance->underlying_io, on_underlying_io_open_complete, http_proxy_io_instance, on_underlying_io_bytes_received, http_proxy_io_instance, on_underlying_io_error, http_proxy_io_instance) != 0)
+                {
+                    /* Codes_SRS_HTTP_PROXY_IO_01_020: [ If xio_open fails, then http_proxy_io_open shall return a non-zero value. ]*/
+                    http_proxy_io_instance->http_proxy_io_state = HTTP_PROXY_IO_STATE_CLOSED;
+                    LogError("Cannot open the underlying IO.");
+                    result = __LINE__;
+                }
+                else
+                {
+                    /* Codes_SRS_HTTP_PROXY_IO_01_017: [ http_proxy_io_open shall open the HTTP proxy IO and on success it shall return 0. ]*/
+                    result = 0;
+                }
             }
         }
     }
@@ -860,6 +1019,8 @@ static int http_proxy_io_send(CONCRETE_IO_HANDLE http_proxy_io, const void* buff
             }
             else
             {
+                count_send(http_proxy_io_instance, size);
+
                 /* Codes_SRS_HTTP_PROXY_IO_01_029: [ http_proxy_io_send shall send the size bytes pointed to by buffer and on success it shall return 0. ]*/
                 result = 0;
             }
@@ -869,6 +1030,100 @@ static int http_proxy_io_send(CONCRETE_IO_HANDLE http_proxy_io, const void* buff
     return result;
 }
 
+static int http_proxy_io_sendv(CONCRETE_IO_HANDLE http_proxy_io, const XIO_BUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* on_send_complete_context)
+{
+    int result;
+
+    if ((http_proxy_io == NULL) ||
+        (buffers == NULL) ||
+        (buffer_count == 0))
+    {
+        result = __LINE__;
+        LogError("Bad arguments: http_proxy_io = %p, buffers = %p, buffer_count = %lu.",
+            http_proxy_io, buffers, (unsigned long)buffer_count);
+    }
+    else
+    {
+        HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = (HTTP_PROXY_IO_INSTANCE*)http_proxy_io;
+
+        if (http_proxy_io_instance->http_proxy_io_state != HTTP_PROXY_IO_STATE_OPEN)
+        {
+            result = __LINE__;
+            LogError("Invalid HTTP proxy IO state. Expected state is HTTP_PROXY_IO_STATE_OPEN.");
+        }
+        else
+        {
+            /* once the tunnel is up the buffers are handed down untouched */
+            if (xio_sendv(http_proxy_io_instance->underlying_io, buffers, buffer_count, on_send_complete, on_send_complete_context) != 0)
+            {
+                result = __LINE__;
+                LogError("Underlying xio_sendv failed.");
+            }
+            else
+            {
+                size_t i;
+                size_t total_size = 0;
+
+                for (i = 0; i < buffer_count; i++)
+                {
+                    total_size += buffers[i].size;
+                }
+
+                count_send(http_proxy_io_instance, total_size);
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static int http_proxy_io_send_constbuffer_array(CONCRETE_IO_HANDLE http_proxy_io, CONSTBUFFER_ARRAY_HANDLE constbuffer_array, ON_SEND_COMPLETE on_send_complete, void* on_send_complete_context)
+{
+    int result;
+
+    if ((http_proxy_io == NULL) ||
+        (constbuffer_array == NULL))
+    {
+        result = __LINE__;
+        LogError("Bad arguments: http_proxy_io = %p, constbuffer_array = %p.",
+            http_proxy_io, constbuffer_array);
+    }
+    else
+    {
+        HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = (HTTP_PROXY_IO_INSTANCE*)http_proxy_io;
+
+        if (http_proxy_io_instance->http_proxy_io_state != HTTP_PROXY_IO_STATE_OPEN)
+        {
+            result = __LINE__;
+            LogError("Invalid HTTP proxy IO state. Expected state is HTTP_PROXY_IO_STATE_OPEN.");
+        }
+        else
+        {
+            /* the array is handed down as is, the underlying IO holds the references it needs */
+            if (xio_send_constbuffer_array(http_proxy_io_instance->underlying_io, constbuffer_array, on_send_complete, on_send_complete_context) != 0)
+            {
+                result = __LINE__;
+                LogError("Underlying xio_send_constbuffer_array failed.");
+            }
+            else
+            {
+                uint32_t total_size;
+
+                if (constbuffer_array_get_all_buffers_size(constbuffer_array, &total_size) != 0)
+                {
+                    total_size = 0;
+                }
+
+                count_send(http_proxy_io_instance, total_size);
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
 static void http_proxy_io_dowork(CONCRETE_IO_HANDLE http_proxy_io)
 {
     if (http_proxy_io == NULL)
@@ -882,10 +1137,149 @@ static void http_proxy_io_dowork(CONCRETE_IO_HANDLE http_proxy_io)
 
         if (http_proxy_io_instance->http_proxy_io_state != HTTP_PROXY_IO_STATE_CLOSED)
         {
+            uint64_t callback_count = http_proxy_io_instance->stats.callback_count;
+
+            http_proxy_io_instance->stats.dowork_count++;
+
             /* Codes_SRS_HTTP_PROXY_IO_01_037: [ http_proxy_io_dowork shall call xio_dowork on the underlying IO created in http_proxy_io_create. ]*/
             xio_dowork(http_proxy_io_instance->underlying_io);
+
+            if (http_proxy_io_instance->stats.callback_count == callback_count)
+            {
+                http_proxy_io_instance->stats.idle_dowork_count++;
+            }
+        }
+    }
+}
+
+static int http_proxy_io_dowork_ex(CONCRETE_IO_HANDLE http_proxy_io, bool* made_progress, uint64_t* next_deadline_us)
+{
+    int result;
+
+    if ((http_proxy_io == NULL) ||
+        (made_progress == NULL) ||
+        (next_deadline_us == NULL))
+    {
+        /* Codes_SRS_HTTP_PROXY_IO_01_102: [ If http_proxy_io, made_progress or next_deadline_us is NULL, http_proxy_io_dowork_ex shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: http_proxy_io = %p, made_progress = %p, next_deadline_us = %p",
+            http_proxy_io, made_progress, next_deadline_us);
+        result = __FAILURE__;
+    }
+    else
+    {
+        HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = (HTTP_PROXY_IO_INSTANCE*)http_proxy_io;
+
+        if (http_proxy_io_instance->http_proxy_io_state == HTTP_PROXY_IO_STATE_CLOSED)
+        {
+            /* Codes_SRS_HTTP_PROXY_IO_01_103: [ If the IO is not open, http_proxy_io_dowork_ex shall set made_progress to false, set next_deadline_us to XIO_NO_DEADLINE and return 0. ]*/
+            *made_progress = false;
+            *next_deadline_us = XIO_NO_DEADLINE;
+        }
+        else
+        {
+            uint64_t callback_count = http_proxy_io_instance->stats.callback_count;
+            bool underlying_progress;
+
+            http_proxy_io_instance->stats.dowork_count++;
+
+            /* Codes_SRS_HTTP_PROXY_IO_01_104: [ Otherwise http_proxy_io_dowork_ex shall call xio_dowork_ex on the underlying IO, passing next_deadline_us down to it. ]*/
+            if (xio_dowork_ex(http_proxy_io_instance->underlying_io, &underlying_progress, next_deadline_us) != 0)
+            {
+                /* Codes_SRS_HTTP_PROXY_IO_01_106: [ If xio_dowork_ex fails, made_progress shall be set to true and next_deadline_us to XIO_NO_DEADLINE. ]*/
+                LogError("xio_dowork_ex failed");
+                underlying_progress = true;
+                *next_deadline_us = XIO_NO_DEADLINE;
+            }
+
+            if (http_proxy_io_instance->stats.callback_count == callback_count)
+            {
+                http_proxy_io_instance->stats.idle_dowork_count++;
+            }
+
+            /* Codes_SRS_HTTP_PROXY_IO_01_105: [ made_progress shall be set to true if a callback was made or the underlying IO made progress, false otherwise. ]*/
+            *made_progress = underlying_progress || (http_proxy_io_instance->stats.callback_count != callback_count);
+        }
+
+        /* Codes_SRS_HTTP_PROXY_IO_01_107: [ On success http_proxy_io_dowork_ex shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+static int http_proxy_io_get_pollable_handle(CONCRETE_IO_HANDLE http_proxy_io, intptr_t* pollable_handle, unsigned int* wanted_events)
+{
+    int result;
+
+    if ((http_proxy_io == NULL) ||
+        (pollable_handle == NULL) ||
+        (wanted_events == NULL))
+    {
+        /* Codes_SRS_HTTP_PROXY_IO_01_108: [ If http_proxy_io, pollable_handle or wanted_events is NULL, http_proxy_io_get_pollable_handle shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: http_proxy_io = %p, pollable_handle = %p, wanted_events = %p",
+            http_proxy_io, pollable_handle, wanted_events);
+        result = __FAILURE__;
+    }
+    else
+    {
+        HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = (HTTP_PROXY_IO_INSTANCE*)http_proxy_io;
+
+        /* Codes_SRS_HTTP_PROXY_IO_01_109: [ http_proxy_io_get_pollable_handle shall call xio_get_pollable_handle on the underlying IO, passing pollable_handle and wanted_events down to it. ]*/
+        if (xio_get_pollable_handle(http_proxy_io_instance->underlying_io, pollable_handle, wanted_events) != 0)
+        {
+            /* Codes_SRS_HTTP_PROXY_IO_01_110: [ If xio_get_pollable_handle fails, http_proxy_io_get_pollable_handle shall fail and return a non-zero value. ]*/
+            LogError("xio_get_pollable_handle failed");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_HTTP_PROXY_IO_01_111: [ On success http_proxy_io_get_pollable_handle shall return 0. ]*/
+            result = 0;
         }
     }
+
+    return result;
+}
+
+static int http_proxy_io_get_stats(CONCRETE_IO_HANDLE http_proxy_io, XIO_STATS* stats, size_t stats_count, size_t* layer_count)
+{
+    int result;
+
+    if ((http_proxy_io == NULL) ||
+        (stats == NULL) ||
+        (stats_count == 0) ||
+        (layer_count == NULL))
+    {
+        /* Codes_SRS_HTTP_PROXY_IO_01_096: [ If http_proxy_io, stats or layer_count is NULL or stats_count is 0, http_proxy_io_get_stats shall fail and return a non-zero value. ]*/
+        result = __LINE__;
+        LogError("Bad arguments: http_proxy_io = %p, stats = %p, stats_count = %lu, layer_count = %p.",
+            http_proxy_io, stats, (unsigned long)stats_count, layer_count);
+    }
+    else
+    {
+        HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = (HTTP_PROXY_IO_INSTANCE*)http_proxy_io;
+        size_t underlying_layer_count;
+
+        /* Codes_SRS_HTTP_PROXY_IO_01_097: [ http_proxy_io_get_stats shall fill the first entry of stats with the counters of the HTTP proxy IO instance. ]*/
+        stats[0] = http_proxy_io_instance->stats;
+
+        /* Codes_SRS_HTTP_PROXY_IO_01_098: [ If stats_count is greater than 1, http_proxy_io_get_stats shall fill the following entries by calling xio_get_stats on the underlying IO. ]*/
+        if ((stats_count > 1) &&
+            (xio_get_stats(http_proxy_io_instance->underlying_io, &stats[1], stats_count - 1, &underlying_layer_count) == 0))
+        {
+            *layer_count = 1 + underlying_layer_count;
+        }
+        else
+        {
+            /* Codes_SRS_HTTP_PROXY_IO_01_099: [ If xio_get_stats fails, only the counters of the HTTP proxy IO instance shall be given. ]*/
+            *layer_count = 1;
+        }
+
+        /* Codes_SRS_HTTP_PROXY_IO_01_100: [ On success http_proxy_io_get_stats shall set layer_count to the number of entries filled and return 0. ]*/
+        result = 0;
+    }
+
+    return result;
 }
 
 static int http_proxy_io_set_option(CONCRETE_IO_HANDLE http_proxy_io, const char* option_name, const void* value)
@@ -903,11 +1297,15 @@ static int http_proxy_io_set_option(CONCRETE_IO_HANDLE http_proxy_io, const char
     {
         HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = (HTTP_PROXY_IO_INSTANCE*)http_proxy_io;
 
-        /* Codes_SRS_HTTP_PROXY_IO_01_045: [ None. ]*/
-
+        if (strcmp(option_name, OPTION_HTTP_PROXY_TUNNEL_POOL) == 0)
+        {
+            /* Codes_SRS_HTTP_PROXY_IO_01_112: [ OPTION_HTTP_PROXY_TUNNEL_POOL shall set the HTTP_PROXY_TUNNEL_POOL_HANDLE given as value as the tunnel pool used by the following opens, NULL meaning none. ]*/
+            http_proxy_io_instance->tunnel_pool = (HTTP_PROXY_TUNNEL_POOL_HANDLE)value;
+            result = 0;
+        }
         /* Codes_SRS_HTTP_PROXY_IO_01_043: [ If the option_name argument indicates an option that is not handled by http_proxy_io_set_option, then xio_setoption shall be called on the underlying IO created in http_proxy_io_create, passing the option name and value to it. ]*/
         /* Codes_SRS_HTTP_PROXY_IO_01_056: [ The value argument shall be allowed to be NULL. ]*/
-        if (xio_setoption(http_proxy_io_instance->underlying_io, option_name, value) != 0)
+        else if (xio_setoption(http_proxy_io_instance->underlying_io, option_name, value) != 0)
         {
             /* Codes_SRS_HTTP_PROXY_IO_01_044: [ if xio_setoption fails, http_proxy_io_set_option shall return a non-zero value. ]*/
             LogError("Unrecognized option");
@@ -957,7 +1355,13 @@ static const IO_INTERFACE_DESCRIPTION http_proxy_io_interface_description =
     http_proxy_io_close,
     http_proxy_io_send,
     http_proxy_io_dowork,
-    http_proxy_io_set_option
+    http_proxy_io_set_option,
+    http_proxy_io_sendv,
+    http_proxy_io_send_constbuffer_array,
+    http_proxy_io_get_stats,
+    http_proxy_io_dowork_ex,
+    http_proxy_io_get_pollable_handle,
+    NULL
 };
 
 const IO_INTERFACE_DESCRIPTION* http_proxy_io_get_interface_description(void)
@@ -965,3 +1369,367 @@ const IO_INTERFACE_DESCRIPTION* http_proxy_io_get_interface_description(void)
     /* Codes_SRS_HTTP_PROXY_IO_01_049: [ http_proxy_io_get_interface_description shall return a pointer to an IO_INTERFACE_DESCRIPTION structure that contains pointers to the functions: http_proxy_io_retrieve_options, http_proxy_io_retrieve_create, http_proxy_io_destroy, http_proxy_io_open, http_proxy_io_close, http_proxy_io_send and http_proxy_io_dowork. ]*/
     return &http_proxy_io_interface_description;
 }
+
+static void get_tunnel_config(const HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance, HTTP_PROXY_IO_CONFIG* config)
+{
+    config->hostname = http_proxy_io_instance->hostname;
+    config->port = http_proxy_io_instance->port;
+    config->proxy_hostname = http_proxy_io_instance->proxy_hostname;
+    config->proxy_port = http_proxy_io_instance->proxy_port;
+    config->username = http_proxy_io_instance->username;
+    config->password = http_proxy_io_instance->password;
+}
+
+static bool are_equal_or_null(const char* left, const char* right)
+{
+    return ((left == NULL) && (right == NULL)) ||
+        ((left != NULL) && (right != NULL) && (strcmp(left, right) == 0));
+}
+
+static bool is_tunnel_to(const HTTP_PROXY_TUNNEL* tunnel, const HTTP_PROXY_IO_CONFIG* config)
+{
+    const HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = tunnel->http_proxy_io_instance;
+
+    /* host names are compared as given, the same host spelled differently does not share tunnels */
+    return (http_proxy_io_instance->port == config->port) &&
+        (http_proxy_io_instance->proxy_port == config->proxy_port) &&
+        (strcmp(http_proxy_io_instance->hostname, config->hostname) == 0) &&
+        (strcmp(http_proxy_io_instance->proxy_hostname, config->proxy_hostname) == 0) &&
+        are_equal_or_null(http_proxy_io_instance->username, config->username) &&
+        are_equal_or_null(http_proxy_io_instance->password, config->password);
+}
+
+static void on_tunnel_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    HTTP_PROXY_TUNNEL* tunnel = (HTTP_PROXY_TUNNEL*)context;
+
+    if (open_result != IO_OPEN_OK)
+    {
+        LogError("Establishing a tunnel to %s:%d failed", tunnel->http_proxy_io_instance->hostname, tunnel->http_proxy_io_instance->port);
+        tunnel->state = HTTP_PROXY_TUNNEL_STATE_FAILED;
+    }
+    else if (tickcounter_get_current_ms(tunnel->tunnel_pool->tick_counter, &tunnel->idle_since) != 0)
+    {
+        LogError("Failed getting the current time, the tunnel cannot be kept");
+        tunnel->state = HTTP_PROXY_TUNNEL_STATE_FAILED;
+    }
+    else
+    {
+        tunnel->state = HTTP_PROXY_TUNNEL_STATE_IDLE;
+    }
+}
+
+static void on_tunnel_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    HTTP_PROXY_TUNNEL* tunnel = (HTTP_PROXY_TUNNEL*)context;
+
+    (void)buffer;
+
+    /* Codes_SRS_HTTP_PROXY_IO_01_132: [ A tunnel that receives bytes while idle in the pool shall be closed by the next http_proxy_tunnel_pool_dowork, since the bytes have nobody to go to. ]*/
+    LogError("%lu bytes received on an idle tunnel to %s:%d, dropping the tunnel", (unsigned long)size, tunnel->http_proxy_io_instance->hostname, tunnel->http_proxy_io_instance->port);
+    tunnel->state = HTTP_PROXY_TUNNEL_STATE_FAILED;
+}
+
+static void on_tunnel_error(void* context)
+{
+    HTTP_PROXY_TUNNEL* tunnel = (HTTP_PROXY_TUNNEL*)context;
+
+    LogError("Idle tunnel to %s:%d failed", tunnel->http_proxy_io_instance->hostname, tunnel->http_proxy_io_instance->port);
+    tunnel->state = HTTP_PROXY_TUNNEL_STATE_FAILED;
+}
+
+static void destroy_tunnel(HTTP_PROXY_TUNNEL* tunnel)
+{
+    HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance = tunnel->http_proxy_io_instance;
+
+    if ((http_proxy_io_instance->http_proxy_io_state != HTTP_PROXY_IO_STATE_CLOSED) &&
+        (http_proxy_io_close(http_proxy_io_instance, NULL, NULL) != 0))
+    {
+        LogError("Failed closing a pooled tunnel, destroying it anyway");
+    }
+
+    http_proxy_io_destroy(http_proxy_io_instance);
+    free(tunnel);
+}
+
+static int start_tunnel(HTTP_PROXY_TUNNEL_POOL* tunnel_pool, const HTTP_PROXY_IO_CONFIG* config)
+{
+    int result;
+    HTTP_PROXY_TUNNEL* tunnel = (HTTP_PROXY_TUNNEL*)malloc(sizeof(HTTP_PROXY_TUNNEL));
+
+    if (tunnel == NULL)
+    {
+        LogError("Failed allocating a pooled tunnel");
+        result = __FAILURE__;
+    }
+    /* the tunnel is an HTTP proxy IO of its own, opened with callbacks of the pool until an open takes it */
+    else if ((tunnel->http_proxy_io_instance = (HTTP_PROXY_IO_INSTANCE*)http_proxy_io_create((void*)config)) == NULL)
+    {
+        LogError("Failed creating the HTTP proxy IO of a pooled tunnel");
+        free(tunnel);
+        result = __FAILURE__;
+    }
+    else
+    {
+        tunnel->tunnel_pool = tunnel_pool;
+        tunnel->state = HTTP_PROXY_TUNNEL_STATE_OPENING;
+        tunnel->idle_since = 0;
+
+        if (http_proxy_io_open(tunnel->http_proxy_io_instance, on_tunnel_open_complete, tunnel, on_tunnel_bytes_received, tunnel, on_tunnel_error, tunnel) != 0)
+        {
+            LogError("Failed opening a pooled tunnel");
+            http_proxy_io_destroy(tunnel->http_proxy_io_instance);
+            free(tunnel);
+            result = __FAILURE__;
+        }
+        else
+        {
+            tunnel->next = tunnel_pool->tunnels;
+            tunnel_pool->tunnels = tunnel;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static size_t count_tunnels_to(const HTTP_PROXY_TUNNEL_POOL* tunnel_pool, const HTTP_PROXY_IO_CONFIG* config)
+{
+    size_t result = 0;
+    const HTTP_PROXY_TUNNEL* tunnel;
+
+    for (tunnel = tunnel_pool->tunnels; tunnel != NULL; tunnel = tunnel->next)
+    {
+        if ((tunnel->state != HTTP_PROXY_TUNNEL_STATE_FAILED) && is_tunnel_to(tunnel, config))
+        {
+            result++;
+        }
+    }
+
+    return result;
+}
+
+static bool is_tunnel_expired(const HTTP_PROXY_TUNNEL_POOL* tunnel_pool, const HTTP_PROXY_TUNNEL* tunnel, tickcounter_ms_t now)
+{
+    return (tunnel->state == HTTP_PROXY_TUNNEL_STATE_IDLE) &&
+        (now - tunnel->idle_since >= tunnel_pool->idle_timeout_ms);
+}
+
+static HTTP_PROXY_IO_INSTANCE* take_pooled_tunnel(HTTP_PROXY_IO_INSTANCE* http_proxy_io_instance)
+{
+    HTTP_PROXY_IO_INSTANCE* result = NULL;
+    HTTP_PROXY_TUNNEL_POOL* tunnel_pool = http_proxy_io_instance->tunnel_pool;
+    tickcounter_ms_t now;
+
+    if (tickcounter_get_current_ms(tunnel_pool->tick_counter, &now) != 0)
+    {
+        LogError("Failed getting the current time, not using the tunnel pool");
+    }
+    else
+    {
+        HTTP_PROXY_IO_CONFIG config;
+        HTTP_PROXY_TUNNEL** tunnel;
+
+        get_tunnel_config(http_proxy_io_instance, &config);
+
+        for (tunnel = &tunnel_pool->tunnels; *tunnel != NULL; tunnel = &(*tunnel)->next)
+        {
+            /* Codes_SRS_HTTP_PROXY_IO_01_131: [ Tunnels idle for idle_timeout_ms or longer shall not be taken. ]*/
+            if (((*tunnel)->state == HTTP_PROXY_TUNNEL_STATE_IDLE) &&
+                !is_tunnel_expired(tunnel_pool, *tunnel, now) &&
+                is_tunnel_to(*tunnel, &config))
+            {
+                HTTP_PROXY_TUNNEL* taken_tunnel = *tunnel;
+
+                *tunnel = taken_tunnel->next;
+                result = taken_tunnel->http_proxy_io_instance;
+                free(taken_tunnel);
+                break;
+            }
+        }
+
+        /* Codes_SRS_HTTP_PROXY_IO_01_115: [ When a tunnel is taken from the pool, the pool shall start establishing a new tunnel to the same target. ]*/
+        if ((result != NULL) && (start_tunnel(tunnel_pool, &config) != 0))
+        {
+            LogError("Failed starting the replacement of a pooled tunnel");
+        }
+    }
+
+    return result;
+}
+
+HTTP_PROXY_TUNNEL_POOL_HANDLE http_proxy_tunnel_pool_create(size_t max_tunnels_per_target, uint32_t idle_timeout_ms)
+{
+    HTTP_PROXY_TUNNEL_POOL* result;
+
+    if ((max_tunnels_per_target == 0) ||
+        (idle_timeout_ms == 0))
+    {
+        /* Codes_SRS_HTTP_PROXY_IO_01_119: [ If max_tunnels_per_target or idle_timeout_ms is 0, http_proxy_tunnel_pool_create shall fail and return NULL. ]*/
+        LogError("Bad arguments: max_tunnels_per_target = %lu, idle_timeout_ms = %lu",
+            (unsigned long)max_tunnels_per_target, (unsigned long)idle_timeout_ms);
+        result = NULL;
+    }
+    /* Codes_SRS_HTTP_PROXY_IO_01_118: [ http_proxy_tunnel_pool_create shall create an empty tunnel pool and return a handle to it. ]*/
+    else if ((result = (HTTP_PROXY_TUNNEL_POOL*)malloc(sizeof(HTTP_PROXY_TUNNEL_POOL))) == NULL)
+    {
+        /* Codes_SRS_HTTP_PROXY_IO_01_120: [ If any error occurs, http_proxy_tunnel_pool_create shall fail and return NULL. ]*/
+        LogError("Failed allocating the tunnel pool");
+    }
+    else if ((result->tick_counter = tickcounter_create()) == NULL)
+    {
+        /* Codes_SRS_HTTP_PROXY_IO_01_120: [ If any error occurs, http_proxy_tunnel_pool_create shall fail and return NULL. ]*/
+        LogError("Failed creating the tick counter of the tunnel pool");
+        free(result);
+        result = NULL;
+    }
+    else
+    {
+        result->max_tunnels_per_target = max_tunnels_per_target;
+        result->idle_timeout_ms = idle_timeout_ms;
+        result->tunnels = NULL;
+    }
+
+    return result;
+}
+
+void http_proxy_tunnel_pool_destroy(HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool)
+{
+    if (tunnel_pool == NULL)
+    {
+        /* Codes_SRS_HTTP_PROXY_IO_01_122: [ If tunnel_pool is NULL, http_proxy_tunnel_pool_destroy shall do nothing. ]*/
+        LogError("NULL tunnel_pool.");
+    }
+    else
+    {
+        /* Codes_SRS_HTTP_PROXY_IO_01_121: [ http_proxy_tunnel_pool_destroy shall close and destroy the tunnels of the pool and free the pool. ]*/
+        while (tunnel_pool->tunnels != NULL)
+        {
+            HTTP_PROXY_TUNNEL* tunnel = tunnel_pool->tunnels;
+
+            tunnel_pool->tunnels = tunnel->next;
+            destroy_tunnel(tunnel);
+        }
+
+        tickcounter_destroy(tunnel_pool->tick_counter);
+        free(tunnel_pool);
+    }
+}
+
+int http_proxy_tunnel_pool_warm(HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool, const HTTP_PROXY_IO_CONFIG* config, size_t tunnel_count)
+{
+    int result;
+
+    if ((tunnel_pool == NULL) ||
+        (config == NULL) ||
+        (config->hostname == NULL) ||
+        (config->proxy_hostname == NULL))
+    {
+        /* Codes_SRS_HTTP_PROXY_IO_01_124: [ If tunnel_pool or config is NULL, or the hostname or proxy_hostname member of config is NULL, http_proxy_tunnel_pool_warm shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: tunnel_pool = %p, config = %p", tunnel_pool, config);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t tunnels_to_start;
+        size_t tunnel_total = (tunnel_count < tunnel_pool->max_tunnels_per_target) ? tunnel_count : tunnel_pool->max_tunnels_per_target;
+        size_t existing_tunnels = count_tunnels_to(tunnel_pool, config);
+
+        /* Codes_SRS_HTTP_PROXY_IO_01_123: [ http_proxy_tunnel_pool_warm shall start establishing tunnels to the target of config, as http_proxy_io_open would, until tunnel_count tunnels to it, capped at max_tunnels_per_target, are idle or being established. ]*/
+        tunnels_to_start = (existing_tunnels < tunnel_total) ? (tunnel_total - existing_tunnels) : 0;
+        result = 0;
+
+        while (tunnels_to_start > 0)
+        {
+            if (start_tunnel(tunnel_pool, config) != 0)
+            {
+                /* Codes_SRS_HTTP_PROXY_IO_01_125: [ If starting a tunnel fails, http_proxy_tunnel_pool_warm shall fail and return a non-zero value, keeping the tunnels already started. ]*/
+                LogError("Failed starting a tunnel to %s:%d", config->hostname, config->port);
+                result = __FAILURE__;
+                break;
+            }
+
+            tunnels_to_start--;
+        }
+    }
+
+    return result;
+}
+
+void http_proxy_tunnel_pool_dowork(HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool)
+{
+    if (tunnel_pool == NULL)
+    {
+        /* Codes_SRS_HTTP_PROXY_IO_01_127: [ If tunnel_pool is NULL, http_proxy_tunnel_pool_dowork shall do nothing. ]*/
+        LogError("NULL tunnel_pool.");
+    }
+    else
+    {
+        HTTP_PROXY_TUNNEL* tunnel;
+        HTTP_PROXY_TUNNEL** tunnel_link;
+        tickcounter_ms_t now;
+        bool check_expiry;
+
+        /* Codes_SRS_HTTP_PROXY_IO_01_126: [ http_proxy_tunnel_pool_dowork shall call http_proxy_io_dowork for each tunnel of the pool. ]*/
+        for (tunnel = tunnel_pool->tunnels; tunnel != NULL; tunnel = tunnel->next)
+        {
+            http_proxy_io_dowork(tunnel->http_proxy_io_instance);
+        }
+
+        if (tickcounter_get_current_ms(tunnel_pool->tick_counter, &now) != 0)
+        {
+            LogError("Failed getting the current time, idle tunnels are not checked for expiry");
+            check_expiry = false;
+        }
+        else
+        {
+            check_expiry = true;
+        }
+
+        /* the tunnels are only removed here, never from the callbacks of their IOs */
+        tunnel_link = &tunnel_pool->tunnels;
+        while (*tunnel_link != NULL)
+        {
+            tunnel = *tunnel_link;
+
+            /* Codes_SRS_HTTP_PROXY_IO_01_128: [ http_proxy_tunnel_pool_dowork shall close and destroy the tunnels that failed to establish or failed while idle. ]*/
+            /* Codes_SRS_HTTP_PROXY_IO_01_129: [ http_proxy_tunnel_pool_dowork shall close and destroy the tunnels that have been idle for idle_timeout_ms or longer; they are not replaced. ]*/
+            if ((tunnel->state == HTTP_PROXY_TUNNEL_STATE_FAILED) ||
+                (check_expiry && is_tunnel_expired(tunnel_pool, tunnel, now)))
+            {
+                *tunnel_link = tunnel->next;
+                destroy_tunnel(tunnel);
+            }
+            else
+            {
+                tunnel_link = &tunnel->next;
+            }
+        }
+    }
+}
+
+size_t http_proxy_tunnel_pool_get_idle_count(HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool)
+{
+    size_t result = 0;
+
+    if (tunnel_pool == NULL)
+    {
+        /* Codes_SRS_HTTP_PROXY_IO_01_130: [ http_proxy_tunnel_pool_get_idle_count shall return the number of established tunnels waiting in the pool, 0 if tunnel_pool is NULL. ]*/
+        LogError("NULL tunnel_pool.");
+    }
+    else
+    {
+        const HTTP_PROXY_TUNNEL* tunnel;
+
+        /* Codes_SRS_HTTP_PROXY_IO_01_130: [ http_proxy_tunnel_pool_get_idle_count shall return the number of established tunnels waiting in the pool, 0 if tunnel_pool is NULL. ]*/
+        for (tunnel = tunnel_pool->tunnels; tunnel != NULL; tunnel = tunnel->next)
+        {
+            if (tunnel->state == HTTP_PROXY_TUNNEL_STATE_IDLE)
+            {
+                result++;
+            }
+        }
+    }
+
+    return result;
+}
@@ -114,7 +114,13 @@ static const IO_INTERFACE_DESCRIPTION http_proxy_stub_interface_description =
     http_proxy_stub_close,
     http_proxy_stub_send,
     http_proxy_stub_dowork,
-    http_proxy_stub_set_option
+    http_proxy_stub_set_option,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL
 };
 
 const IO_INTERFACE_DESCRIPTION* http_proxy_io_get_interface_description(void)
@@ -122,3 +128,47 @@ const IO_INTERFACE_DESCRIPTION* http_proxy_io_get_interface_description(void)
     /* Codes_SRS_HTTP_PROXY_IO_01_049: [ http_proxy_io_get_interface_description shall return a pointer to an IO_INTERFACE_DESCRIPTION structure that contains pointers to the functions: http_proxy_io_retrieve_options, http_proxy_io_retrieve_create, http_proxy_io_destroy, http_proxy_io_open, http_proxy_io_close, http_proxy_io_send and http_proxy_io_dowork. ]*/
     return &http_proxy_stub_interface_description;
 }
+
+HTTP_PROXY_TUNNEL_POOL_HANDLE http_proxy_tunnel_pool_create(size_t max_tunnels_per_target, uint32_t idle_timeout_ms)
+{
+    (void)max_tunnels_per_target;
+    (void)idle_timeout_ms;
+
+    LogError("Function %s is a stub and should never be called", __FUNCTION__);
+
+    return NULL;
+}
+
+void http_proxy_tunnel_pool_destroy(HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool)
+{
+    (void)tunnel_pool;
+
+    LogError("Function %s is a stub and should never be called", __FUNCTION__);
+}
+
+int http_proxy_tunnel_pool_warm(HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool, const HTTP_PROXY_IO_CONFIG* config, size_t tunnel_count)
+{
+    (void)tunnel_pool;
+    (void)config;
+    (void)tunnel_count;
+
+    LogError("Function %s is a stub and should never be called", __FUNCTION__);
+
+    return __FAILURE__;
+}
+
+void http_proxy_tunnel_pool_dowork(HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool)
+{
+    (void)tunnel_pool;
+
+    LogError("Function %s is a stub and should never be called", __FUNCTION__);
+}
+
+size_t http_proxy_tunnel_pool_get_idle_count(HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool)
+{
+    (void)tunnel_pool;
+
+    LogError("Function %s is a stub and should never be called", __FUNCTION__);
+
+    return 0;
+}
@@ -2,6 +2,8 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/httpapiex.h"
 #include "azure_c_shared_utility/optimize_size.h"
@@ -9,6 +11,18 @@
 #include "azure_c_shared_utility/strings.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/vector.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/gb_rand.h"
+
+#ifdef USE_HTTP_COMPRESSION
+#include "zlib.h"
+
+/*the size of the pieces the request bodies are read and compressed by*/
+#define HTTPAPIEX_COMPRESSION_CHUNK_SIZE 4096
+#endif
 
 typedef struct HTTPAPIEX_SAVED_OPTION_TAG
 {
@@ -16,12 +30,41 @@ typedef struct HTTPAPIEX_SAVED_OPTION_TAG
     const void* value;
 }HTTPAPIEX_SAVED_OPTION;
 
+typedef struct HTTPAPIEX_POOLED_CONNECTION_TAG
+{
+    HTTP_HANDLE httpHandle;
+    tickcounter_ms_t lastUsed;
+    unsigned int optionsGeneration; /*connections created before the last HTTPAPIEX_SetOption are not reused*/
+    struct HTTPAPIEX_POOLED_CONNECTION_TAG* next;
+}HTTPAPIEX_POOLED_CONNECTION;
+
 typedef struct HTTPAPIEX_HANDLE_DATA_TAG
 {
     STRING_HANDLE hostName;
     int k;
     HTTP_HANDLE httpHandle;
     VECTOR_HANDLE savedOptions;
+    /*connection pool, only exists once OPTION_HTTPAPIEX_MAX_IDLE_CONNECTIONS has been set. Then httpHandle and k are not used.*/
+    LOCK_HANDLE poolLock;
+    TICK_COUNTER_HANDLE poolTickCounter;
+    bool poolHttpApiInitialized;
+    size_t maxIdleConnections;
+    tickcounter_ms_t idleTimeout;
+    HTTPAPIEX_POOLED_CONNECTION* idleConnections; /*most recently used first*/
+    size_t idleConnectionCount;
+    unsigned int optionsGeneration;
+    /*retry policy, only used once OPTION_HTTPAPIEX_RETRY_POLICY has been set. Its state is guarded by poolLock when the connection pool is enabled.*/
+    bool hasRetryPolicy;
+    HTTPAPIEX_RETRY_POLICY retryPolicy;
+    TICK_COUNTER_HANDLE retryTickCounter;
+    size_t retryTokens;
+    size_t consecutiveFailures;
+    bool isCircuitOpen;
+    tickcounter_ms_t circuitOpenedAt;
+#ifdef USE_HTTP_COMPRESSION
+    /*request bodies of at least this size are gzip compressed, 0 (the default) disables the compression*/
+    size_t compressionThreshold;
+#endif
 }HTTPAPIEX_HANDLE_DATA;
 
 DEFINE_ENUM_STRINGS(HTTPAPIEX_RESULT, HTTPAPIEX_RESULT_VALUES);
@@ -70,6 +113,24 @@ HTTPAPIEX_HANDLE HTTPAPIEX_Create(const char* hostName)
                 {
                     handleData->k = -1;
                     handleData->httpHandle = NULL;
+                    handleData->poolLock = NULL;
+                    handleData->poolTickCounter = NULL;
+                    handleData->poolHttpApiInitialized = false;
+                    handleData->maxIdleConnections = 0;
+                    handleData->idleTimeout = 0;
+                    handleData->idleConnections = NULL;
+                    handleData->idleConnectionCount = 0;
+                    handleData->optionsGeneration = 0;
+                    handleData->hasRetryPolicy = false;
+                    (void)memset(&handleData->retryPolicy, 0, sizeof(handleData->retryPolicy));
+                    handleData->retryTickCounter = NULL;
+                    handleData->retryTokens = 0;
+                    handleData->consecutiveFailures = 0;
+                    handleData->isCircuitOpen = false;
+                    handleData->circuitOpenedAt = 0;
+#ifdef USE_HTTP_COMPRESSION
+                    handleData->compressionThreshold = 0;
+#endif
                     result = handleData;
                 }
             }
@@ -81,12 +142,19 @@ HTTPAPIEX_HANDLE HTTPAPIEX_Create(const char* hostName)
 /*this function builds the default request http headers if none are specified*/
 /*returns 0 if no error*/
 /*any other code is error*/
-static int buildRequestHttpHeadersHandle(HTTPAPIEX_HANDLE_DATA *handleData, BUFFER_HANDLE requestContent, HTTP_HEADERS_HANDLE originalRequestHttpHeadersHandle, bool* isOriginalRequestHttpHeadersHandle, HTTP_HEADERS_HANDLE* toBeUsedRequestHttpHeadersHandle)
+/*the Content-Length is the size of requestContent or, when requestContent is NULL, contentLength*/
+/*a Content-Encoding is only added to a copy of the original headers, so that they can be used again for a request that is not compressed*/
+static int buildRequestHttpHeadersHandle(HTTPAPIEX_HANDLE_DATA *handleData, BUFFER_HANDLE requestContent, size_t contentLength, const char* contentEncoding, HTTP_HEADERS_HANDLE originalRequestHttpHeadersHandle, bool* isOriginalRequestHttpHeadersHandle, HTTP_HEADERS_HANDLE* toBeUsedRequestHttpHeadersHandle)
 {
     int result;
 
 
-    if (originalRequestHttpHeadersHandle != NULL)
+    if ((originalRequestHttpHeadersHandle != NULL) && (contentEncoding != NULL))
+    {
+        *isOriginalRequestHttpHeadersHandle = false;
+        *toBeUsedRequestHttpHeadersHandle = HTTPHeaders_Clone(originalRequestHttpHeadersHandle);
+    }
+    else if (originalRequestHttpHeadersHandle != NULL)
     {
         *toBeUsedRequestHttpHeadersHandle = originalRequestHttpHeadersHandle;
         *isOriginalRequestHttpHeadersHandle = true;
@@ -110,7 +178,7 @@ static int buildRequestHttpHeadersHandle(HTTPAPIEX_HANDLE_DATA *handleData, BUFF
     else
     {
         char temp[22] = { 0 };
-        (void)size_tToString(temp, 22, BUFFER_length(requestContent)); /*cannot fail, MAX_uint64 has 19 digits*/
+        (void)size_tToString(temp, 22, (requestContent != NULL) ? BUFFER_length(requestContent) : contentLength); /*cannot fail, MAX_uint64 has 19 digits*/
         /*Codes_SRS_HTTPAPIEX_02_011: [If parameter requestHttpHeadersHandle is not NULL then HTTPAPIEX_ExecuteRequest shall create or update the following headers of the request:
         Host:{hostname}
         Content-Length:the size of the requestContent parameter, and shall use the so constructed HTTPHEADERS object to all calls to HTTPAPI_ExecuteRequest as parameter httpHeadersHandle.]
@@ -121,7 +189,8 @@ static int buildRequestHttpHeadersHandle(HTTPAPIEX_HANDLE_DATA *handleData, BUFF
         */
         if (!(
             (HTTPHeaders_ReplaceHeaderNameValuePair(*toBeUsedRequestHttpHeadersHandle, "Host", STRING_c_str(handleData->hostName)) == HTTP_HEADERS_OK) &&
-            (HTTPHeaders_ReplaceHeaderNameValuePair(*toBeUsedRequestHttpHeadersHandle, "Content-Length", temp) == HTTP_HEADERS_OK)
+            (HTTPHeaders_ReplaceHeaderNameValuePair(*toBeUsedRequestHttpHeadersHandle, "Content-Length", temp) == HTTP_HEADERS_OK) &&
+            ((contentEncoding == NULL) || (HTTPHeaders_ReplaceHeaderNameValuePair(*toBeUsedRequestHttpHeadersHandle, "Content-Encoding", contentEncoding) == HTTP_HEADERS_OK))
             ))
         {
             if (! *isOriginalRequestHttpHeadersHandle)
@@ -169,28 +238,596 @@ static int buildBufferIfNotExist(BUFFER_HANDLE originalRequestContent, bool* isO
     int result;
     if (originalRequestContent == NULL)
     {
-        *toBeUsedRequestContent = BUFFER_new();
-        if (*toBeUsedRequestContent == NULL)
+        *toBeUsedRequestContent = BUFFER_new();
+        if (*toBeUsedRequestContent == NULL)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            *isOriginalRequestContent = false;
+            result = 0;
+        }
+    }
+    else
+    {
+        *isOriginalRequestContent = true;
+        *toBeUsedRequestContent = originalRequestContent;
+        result = 0;
+    }
+    return result;
+}
+
+/*a compressed request body, read from memory by the adapter of a streaming request*/
+typedef struct HTTPAPIEX_COMPRESSED_CONTENT_TAG
+{
+    BUFFER_HANDLE content;
+    size_t position;
+}HTTPAPIEX_COMPRESSED_CONTENT;
+
+#ifdef USE_HTTP_COMPRESSION
+static voidpf compressionAlloc(voidpf opaque, uInt items, uInt size)
+{
+    void* result;
+    (void)opaque;
+
+    if ((size != 0) && (items > SIZE_MAX / size))
+    {
+        result = Z_NULL;
+    }
+    else
+    {
+        result = malloc((size_t)items * size);
+    }
+
+    return result;
+}
+
+static void compressionFree(voidpf opaque, voidpf address)
+{
+    (void)opaque;
+    free(address);
+}
+
+/*bodies that are already encoded by the caller (a Content-Encoding header is present) are left alone*/
+static bool isRequestToBeCompressed(HTTPAPIEX_HANDLE_DATA* handleData, HTTP_HEADERS_HANDLE requestHttpHeadersHandle, size_t contentLength)
+{
+    return (handleData->compressionThreshold != 0) &&
+        (contentLength >= handleData->compressionThreshold) &&
+        ((requestHttpHeadersHandle == NULL) || (HTTPHeaders_FindHeaderValue(requestHttpHeadersHandle, "Content-Encoding") == NULL));
+}
+
+/*runs deflate on the input of stream and appends what it produces to compressedContent, until the input is consumed or, with Z_FINISH, the stream ends*/
+static int deflateToBuffer(z_stream* stream, int flush, unsigned char* chunk, BUFFER_HANDLE compressedContent)
+{
+    int result = 0;
+    int deflateResult;
+
+    do
+    {
+        size_t produced;
+        stream->next_out = chunk;
+        stream->avail_out = HTTPAPIEX_COMPRESSION_CHUNK_SIZE;
+        deflateResult = deflate(stream, flush);
+        produced = HTTPAPIEX_COMPRESSION_CHUNK_SIZE - stream->avail_out;
+        if (deflateResult == Z_STREAM_ERROR)
+        {
+            LogError("deflate failed");
+            result = __FAILURE__;
+        }
+        else if ((produced > 0) && (BUFFER_append_build(compressedContent, chunk, produced) != 0))
+        {
+            LogError("unable to BUFFER_append_build");
+            result = __FAILURE__;
+        }
+    } while ((result == 0) && ((flush == Z_FINISH) ? (deflateResult != Z_STREAM_END) : (stream->avail_out == 0)));
+
+    return result;
+}
+
+/*gzip compresses the contentLength bytes of content or, when content is NULL, the contentLength bytes read piece by piece with readContent*/
+static BUFFER_HANDLE gzipRequestContent(const unsigned char* content, size_t contentLength, HTTPAPI_READ_CONTENT readContent, void* readContentContext)
+{
+    BUFFER_HANDLE result;
+    z_stream stream;
+    /*the first half receives the pieces read with readContent, the second half what deflate produces*/
+    unsigned char* chunks;
+
+    (void)memset(&stream, 0, sizeof(stream));
+    stream.zalloc = compressionAlloc;
+    stream.zfree = compressionFree;
+
+    if ((chunks = (unsigned char*)malloc(2 * HTTPAPIEX_COMPRESSION_CHUNK_SIZE)) == NULL)
+    {
+        LogError("unable to malloc");
+        result = NULL;
+    }
+    else
+    {
+        /*15 + 16: the largest window, with a gzip header and trailer*/
+        if (deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            LogError("unable to deflateInit2");
+            result = NULL;
+        }
+        else
+        {
+            if ((result = BUFFER_new()) == NULL)
+            {
+                LogError("unable to BUFFER_new");
+            }
+            else
+            {
+                size_t remaining = contentLength;
+                int compressResult = 0;
+
+                while ((compressResult == 0) && (remaining > 0))
+                {
+                    size_t pieceSize;
+                    if (content != NULL)
+                    {
+                        /*avail_in is an uInt, large bodies are given to deflate in slices*/
+                        pieceSize = (remaining > (1U << 30)) ? (1U << 30) : remaining;
+                        stream.next_in = (Bytef*)(content + (contentLength - remaining));
+                    }
+                    else
+                    {
+                        size_t toRead = (remaining > HTTPAPIEX_COMPRESSION_CHUNK_SIZE) ? HTTPAPIEX_COMPRESSION_CHUNK_SIZE : remaining;
+                        pieceSize = 0;
+                        if ((readContent(readContentContext, chunks, toRead, &pieceSize) != 0) ||
+                            (pieceSize == 0) ||
+                            (pieceSize > toRead))
+                        {
+                            LogError("unable to read the request content, %lu bytes are missing", (unsigned long)remaining);
+                            compressResult = __FAILURE__;
+                            break;
+                        }
+                        stream.next_in = chunks;
+                    }
+                    stream.avail_in = (uInt)pieceSize;
+                    compressResult = deflateToBuffer(&stream, Z_NO_FLUSH, chunks + HTTPAPIEX_COMPRESSION_CHUNK_SIZE, result);
+                    remaining -= pieceSize;
+                }
+
+                if ((compressResult != 0) ||
+                    (deflateToBuffer(&stream, Z_FINISH, chunks + HTTPAPIEX_COMPRESSION_CHUNK_SIZE, result) != 0))
+                {
+                    BUFFER_delete(result);
+                    result = NULL;
+                }
+            }
+            (void)deflateEnd(&stream);
+        }
+        free(chunks);
+    }
+
+    return result;
+}
+
+static int readCompressedContent(void* context, unsigned char* buffer, size_t bufferSize, size_t* bytesRead)
+{
+    HTTPAPIEX_COMPRESSED_CONTENT* compressedContent = (HTTPAPIEX_COMPRESSED_CONTENT*)context;
+    size_t available = BUFFER_length(compressedContent->content) - compressedContent->position;
+    *bytesRead = (bufferSize < available) ? bufferSize : available;
+    (void)memcpy(buffer, BUFFER_u_char(compressedContent->content) + compressedContent->position, *bytesRead);
+    compressedContent->position += *bytesRead;
+    return 0;
+}
+#endif
+
+/*replaces the request content with its gzip compression when it is large enough and the compression makes it smaller. contentEncoding is set to the encoding of the content to be sent, NULL when it is not compressed*/
+static int compressRequestContent(HTTPAPIEX_HANDLE_DATA* handleData, HTTP_HEADERS_HANDLE requestHttpHeadersHandle, BUFFER_HANDLE* toBeUsedRequestContent, bool* isOriginalRequestContent, const char** contentEncoding)
+{
+    int result;
+#ifdef USE_HTTP_COMPRESSION
+    /*the request content is only looked at when the compression is enabled*/
+    size_t contentLength = (handleData->compressionThreshold != 0) ? BUFFER_length(*toBeUsedRequestContent) : 0;
+    *contentEncoding = NULL;
+    if (isRequestToBeCompressed(handleData, requestHttpHeadersHandle, contentLength))
+    {
+        const unsigned char* content = BUFFER_u_char(*toBeUsedRequestContent);
+        BUFFER_HANDLE compressedContent = gzipRequestContent(content, contentLength, NULL, NULL);
+        if (compressedContent == NULL)
+        {
+            /*Codes_SRS_HTTPAPIEX_01_005: [ If compressing the request content fails then HTTPAPIEX_ExecuteRequest shall fail and return HTTPAPIEX_ERROR. ]*/
+            LogError("unable to compress the request content");
+            result = __FAILURE__;
+        }
+        else if (BUFFER_length(compressedContent) >= contentLength)
+        {
+            /*Codes_SRS_HTTPAPIEX_01_004: [ If the compressed content is not smaller than the request content then HTTPAPIEX_ExecuteRequest shall send the request content uncompressed. ]*/
+            BUFFER_delete(compressedContent);
+            result = 0;
+        }
+        else
+        {
+            /*Codes_SRS_HTTPAPIEX_01_003: [ If request compression is enabled, requestContent is at least as large as the threshold and requestHttpHeadersHandle has no Content-Encoding header, then HTTPAPIEX_ExecuteRequest shall send the gzip compression of requestContent, with a Content-Encoding: gzip header and the Content-Length of the compressed content, without modifying requestHttpHeadersHandle. ]*/
+            if (*isOriginalRequestContent == false)
+            {
+                BUFFER_delete(*toBeUsedRequestContent);
+            }
+            *toBeUsedRequestContent = compressedContent;
+            *isOriginalRequestContent = false;
+            *contentEncoding = "gzip";
+            result = 0;
+        }
+    }
+    else
+    {
+        result = 0;
+    }
+#else
+    (void)handleData;
+    (void)requestHttpHeadersHandle;
+    (void)toBeUsedRequestContent;
+    (void)isOriginalRequestContent;
+    *contentEncoding = NULL;
+    result = 0;
+#endif
+    return result;
+}
+
+/*reads and compresses the body of a streaming request when it is large enough, the request is then streamed from compressedContent instead of readRequestContent*/
+static int compressStreamedRequestContent(HTTPAPIEX_HANDLE_DATA* handleData, HTTP_HEADERS_HANDLE requestHttpHeadersHandle, size_t* requestContentLength,
+    HTTPAPI_READ_CONTENT* readRequestContent, void** readRequestContentContext, HTTPAPIEX_COMPRESSED_CONTENT* compressedContent, const char** contentEncoding)
+{
+    int result = 0;
+    compressedContent->content = NULL;
+    compressedContent->position = 0;
+    *contentEncoding = NULL;
+#ifdef USE_HTTP_COMPRESSION
+    if (isRequestToBeCompressed(handleData, requestHttpHeadersHandle, *requestContentLength))
+    {
+        /*Codes_SRS_HTTPAPIEX_01_006: [ If request compression is enabled, requestContentLength is at least as large as the threshold and requestHttpHeadersHandle has no Content-Encoding header, then HTTPAPIEX_ExecuteStreamingRequest shall read the request body with readRequestContent and compress it as it is read, before sending the compressed body with a Content-Encoding: gzip header and the Content-Length of the compressed body. ]*/
+        if ((compressedContent->content = gzipRequestContent(NULL, *requestContentLength, *readRequestContent, *readRequestContentContext)) == NULL)
+        {
+            LogError("unable to compress the request content");
+            result = __FAILURE__;
+        }
+        else
+        {
+            *requestContentLength = BUFFER_length(compressedContent->content);
+            *readRequestContent = readCompressedContent;
+            *readRequestContentContext = compressedContent;
+            *contentEncoding = "gzip";
+        }
+    }
+#else
+    (void)handleData;
+    (void)requestHttpHeadersHandle;
+    (void)requestContentLength;
+    (void)readRequestContent;
+    (void)readRequestContentContext;
+#endif
+    return result;
+}
+
+static unsigned int dummyStatusCode;
+
+static void closePooledConnection(HTTPAPIEX_POOLED_CONNECTION* connection)
+{
+    HTTPAPI_CloseConnection(connection->httpHandle);
+    free(connection);
+}
+
+/*closes the idle connections that are past idleTimeout or that exceed maxIdleConnections. Called with poolLock held.*/
+static void trimIdleConnections(HTTPAPIEX_HANDLE_DATA* handleData)
+{
+    tickcounter_ms_t now = 0;
+    bool checkIdleTimeout = (handleData->idleTimeout != 0);
+    HTTPAPIEX_POOLED_CONNECTION** current = &handleData->idleConnections;
+    size_t kept = 0;
+
+    if (checkIdleTimeout && (tickcounter_get_current_ms(handleData->poolTickCounter, &now) != 0))
+    {
+        LogError("unable to get the current time, idle connections are not timed out");
+        checkIdleTimeout = false;
+    }
+
+    while (*current != NULL)
+    {
+        HTTPAPIEX_POOLED_CONNECTION* connection = *current;
+        if ((kept >= handleData->maxIdleConnections) ||
+            (connection->optionsGeneration != handleData->optionsGeneration) ||
+            (checkIdleTimeout && (now - connection->lastUsed > handleData->idleTimeout)))
+        {
+            *current = connection->next;
+            handleData->idleConnectionCount--;
+            closePooledConnection(connection);
+        }
+        else
+        {
+            kept++;
+            current = &connection->next;
+        }
+    }
+}
+
+/*returns the most recently used idle connection or a new one, NULL if none could be created*/
+static HTTPAPIEX_POOLED_CONNECTION* acquirePooledConnection(HTTPAPIEX_HANDLE_DATA* handleData, bool forceNew)
+{
+    HTTPAPIEX_POOLED_CONNECTION* result = NULL;
+
+    if (Lock(handleData->poolLock) != LOCK_OK)
+    {
+        LogError("unable to Lock");
+    }
+    else
+    {
+        if (!forceNew)
+        {
+            trimIdleConnections(handleData);
+            if (handleData->idleConnections != NULL)
+            {
+                result = handleData->idleConnections;
+                handleData->idleConnections = result->next;
+                handleData->idleConnectionCount--;
+            }
+        }
+
+        if (result == NULL)
+        {
+            if (!handleData->poolHttpApiInitialized)
+            {
+                if (HTTPAPI_Init() != HTTPAPI_OK)
+                {
+                    LogError("unable to HTTPAPI_Init");
+                }
+                else
+                {
+                    handleData->poolHttpApiInitialized = true;
+                }
+            }
+
+            if (handleData->poolHttpApiInitialized)
+            {
+                if ((result = (HTTPAPIEX_POOLED_CONNECTION*)malloc(sizeof(HTTPAPIEX_POOLED_CONNECTION))) == NULL)
+                {
+                    LogError("unable to malloc");
+                }
+                else if ((result->httpHandle = HTTPAPI_CreateConnection(STRING_c_str(handleData->hostName))) == NULL)
+                {
+                    LogError("unable to HTTPAPI_CreateConnection");
+                    free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    size_t i;
+                    size_t vectorSize = VECTOR_size(handleData->savedOptions);
+                    for (i = 0; i < vectorSize; i++)
+                    {
+                        HTTPAPIEX_SAVED_OPTION* option = (HTTPAPIEX_SAVED_OPTION*)VECTOR_element(handleData->savedOptions, i);
+                        if (HTTPAPI_SetOption(result->httpHandle, option->optionName, option->value) != HTTPAPI_OK)
+                        {
+                            LogError("HTTPAPI_SetOption failed when called for option %s", option->optionName);
+                        }
+                    }
+                    result->optionsGeneration = handleData->optionsGeneration;
+                }
+            }
+        }
+
+        (void)Unlock(handleData->poolLock);
+    }
+
+    return result;
+}
+
+static void releasePooledConnection(HTTPAPIEX_HANDLE_DATA* handleData, HTTPAPIEX_POOLED_CONNECTION* connection)
+{
+    if (Lock(handleData->poolLock) != LOCK_OK)
+    {
+        LogError("unable to Lock, connection is closed");
+        closePooledConnection(connection);
+    }
+    else
+    {
+        if (tickcounter_get_current_ms(handleData->poolTickCounter, &connection->lastUsed) != 0)
+        {
+            LogError("unable to get the current time");
+            connection->lastUsed = 0;
+        }
+
+        connection->next = handleData->idleConnections;
+        handleData->idleConnections = connection;
+        handleData->idleConnectionCount++;
+        trimIdleConnections(handleData);
+
+        (void)Unlock(handleData->poolLock);
+    }
+}
+
+static int lockRetryState(HTTPAPIEX_HANDLE_DATA* handleData)
+{
+    int result;
+    if ((handleData->poolLock != NULL) && (Lock(handleData->poolLock) != LOCK_OK))
+    {
+        LogError("unable to Lock");
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+    return result;
+}
+
+static void unlockRetryState(HTTPAPIEX_HANDLE_DATA* handleData)
+{
+    if (handleData->poolLock != NULL)
+    {
+        (void)Unlock(handleData->poolLock);
+    }
+}
+
+/*returns false when the circuit breaker is open, true when it is closed or it has been open long enough for a request to probe the host*/
+static bool isRequestAdmitted(HTTPAPIEX_HANDLE_DATA* handleData)
+{
+    bool result = true;
+
+    if (handleData->hasRetryPolicy && (lockRetryState(handleData) == 0))
+    {
+        if ((handleData->retryPolicy.circuit_breaker_threshold != 0) && handleData->isCircuitOpen)
+        {
+            tickcounter_ms_t now;
+            if (tickcounter_get_current_ms(handleData->retryTickCounter, &now) != 0)
+            {
+                LogError("unable to get the current time, the request is attempted");
+            }
+            else if (now - handleData->circuitOpenedAt < handleData->retryPolicy.circuit_breaker_open_ms)
+            {
+                result = false;
+            }
+            else
+            {
+                /*half open: this request probes the host, the others keep failing fast until its outcome is known*/
+                handleData->circuitOpenedAt = now;
+            }
+        }
+        unlockRetryState(handleData);
+    }
+
+    return result;
+}
+
+/*returns false when the request shall not be retried, otherwise waits the jittered backoff of retry number retryCount (0 based) and returns true*/
+static bool waitBeforeRetry(HTTPAPIEX_HANDLE_DATA* handleData, size_t retryCount)
+{
+    bool result;
+
+    if (!handleData->hasRetryPolicy)
+    {
+        result = true;
+    }
+    else if (lockRetryState(handleData) != 0)
+    {
+        result = false;
+    }
+    else
+    {
+        unsigned int delay = 0;
+
+        if ((handleData->retryPolicy.retry_budget != 0) && (handleData->retryTokens == 0))
+        {
+            LogError("the retry budget is exhausted, the request is not retried");
+            result = false;
+        }
+        else
+        {
+            unsigned int maxDelay = handleData->retryPolicy.initial_backoff_ms;
+            size_t i;
+
+            if (handleData->retryPolicy.retry_budget != 0)
+            {
+                handleData->retryTokens--;
+            }
+
+            for (i = 0; (i < retryCount) && (maxDelay < handleData->retryPolicy.max_backoff_ms); i++)
+            {
+                maxDelay = (maxDelay > handleData->retryPolicy.max_backoff_ms / 2) ? handleData->retryPolicy.max_backoff_ms : maxDelay * 2;
+            }
+            if (maxDelay > handleData->retryPolicy.max_backoff_ms)
+            {
+                maxDelay = handleData->retryPolicy.max_backoff_ms;
+            }
+
+            if (maxDelay > 0)
+            {
+                /*full jitter: spreads the retries of the clients that failed together*/
+                delay = (unsigned int)(gb_rand_uint32() % ((uint64_t)maxDelay + 1));
+            }
+            result = true;
+        }
+        unlockRetryState(handleData);
+
+        if (delay > 0)
+        {
+            ThreadAPI_Sleep(delay);
+        }
+    }
+
+    return result;
+}
+
+/*only HTTPAPIEX_OK and HTTPAPIEX_RECOVERYFAILED say something about the host, other results are not counted*/
+static void recordRequestOutcome(HTTPAPIEX_HANDLE_DATA* handleData, HTTPAPIEX_RESULT result)
+{
+    if (handleData->hasRetryPolicy &&
+        ((result == HTTPAPIEX_OK) || (result == HTTPAPIEX_RECOVERYFAILED)) &&
+        (lockRetryState(handleData) == 0))
+    {
+        if (result == HTTPAPIEX_OK)
+        {
+            handleData->consecutiveFailures = 0;
+            handleData->isCircuitOpen = false;
+            if (handleData->retryTokens < handleData->retryPolicy.retry_budget)
+            {
+                handleData->retryTokens++;
+            }
+        }
+        else
+        {
+            handleData->consecutiveFailures++;
+            if ((handleData->retryPolicy.circuit_breaker_threshold != 0) &&
+                (handleData->consecutiveFailures >= handleData->retryPolicy.circuit_breaker_threshold))
+            {
+                if (tickcounter_get_current_ms(handleData->retryTickCounter, &handleData->circuitOpenedAt) != 0)
+                {
+                    LogError("unable to get the current time, the circuit is not opened");
+                }
+                else
+                {
+                    LogError("%lu consecutive requests to %s failed, the circuit is open", (unsigned long)handleData->consecutiveFailures, STRING_c_str(handleData->hostName));
+                    handleData->isCircuitOpen = true;
+                }
+            }
+        }
+        unlockRetryState(handleData);
+    }
+}
+
+/*the pool has its own recovery: a failed request is retried once, on a new connection since a reused one might have been closed by the server while idle*/
+static HTTPAPIEX_RESULT executePooledRequest(HTTPAPIEX_HANDLE_DATA* handleData, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE requestHttpHeadersHandle, BUFFER_HANDLE requestContent, unsigned int* statusCode,
+    HTTP_HEADERS_HANDLE responseHttpHeadersHandle, BUFFER_HANDLE responseContent)
+{
+    HTTPAPIEX_RESULT result = HTTPAPIEX_RECOVERYFAILED;
+    size_t length = BUFFER_length(requestContent);
+    unsigned char* buffer = BUFFER_u_char(requestContent);
+    int attempt;
+
+    for (attempt = 0; attempt < 2; attempt++)
+    {
+        HTTPAPIEX_POOLED_CONNECTION* connection;
+        if ((attempt > 0) && !waitBeforeRetry(handleData, (size_t)attempt - 1))
         {
-            result = __FAILURE__;
+            break;
+        }
+        else if ((connection = acquirePooledConnection(handleData, attempt > 0)) == NULL)
+        {
+            break;
+        }
+        else if (HTTPAPI_ExecuteRequest(connection->httpHandle, requestType, relativePath, requestHttpHeadersHandle, buffer, length, statusCode, responseHttpHeadersHandle, responseContent) != HTTPAPI_OK)
+        {
+            closePooledConnection(connection);
         }
         else
         {
-            *isOriginalRequestContent = false;
-            result = 0;
+            releasePooledConnection(handleData, connection);
+            result = HTTPAPIEX_OK;
+            break;
         }
     }
-    else
+
+    if (result != HTTPAPIEX_OK)
     {
-        *isOriginalRequestContent = true;
-        *toBeUsedRequestContent = originalRequestContent;
-        result = 0;
+        LogError("unable to recover sending to a working state");
     }
+
     return result;
 }
 
-static unsigned int dummyStatusCode;
-
 static int buildAllRequests(HTTPAPIEX_HANDLE_DATA* handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
     HTTP_HEADERS_HANDLE requestHttpHeadersHandle, BUFFER_HANDLE requestContent, unsigned int* statusCode,
     HTTP_HEADERS_HANDLE responseHttpHeadersHandle, BUFFER_HANDLE responseContent,
@@ -203,6 +840,7 @@ static int buildAllRequests(HTTPAPIEX_HANDLE_DATA* handle, HTTPAPI_REQUEST_TYPE
     BUFFER_HANDLE *toBeUsedResponseContent, bool *isOriginalResponseContent)
 {
     int result;
+    const char* contentEncoding;
     (void)requestType;
     /*Codes_SRS_HTTPAPIEX_02_013: [If requestContent is NULL then HTTPAPIEX_ExecuteRequest shall behave as if a buffer of zero size would have been used, that is, it shall call HTTPAPI_ExecuteRequest with parameter content = NULL and contentLength = 0.]*/
     /*Codes_SRS_HTTPAPIEX_02_014: [If requestContent is not NULL then its content and its size shall be used for parameters content and contentLength of HTTPAPI_ExecuteRequest.] */
@@ -211,9 +849,17 @@ static int buildAllRequests(HTTPAPIEX_HANDLE_DATA* handle, HTTPAPI_REQUEST_TYPE
         LogError("unable to build the request content");
         result = __FAILURE__;
     }
+    else if (compressRequestContent(handle, requestHttpHeadersHandle, toBeUsedRequestContent, isOriginalRequestContent, &contentEncoding) != 0)
+    {
+        if (*isOriginalRequestContent == false)
+        {
+            BUFFER_delete(*toBeUsedRequestContent);
+        }
+        result = __FAILURE__;
+    }
     else
     {
-        if (buildRequestHttpHeadersHandle(handle, *toBeUsedRequestContent, requestHttpHeadersHandle, isOriginalRequestHttpHeadersHandle, toBeUsedRequestHttpHeadersHandle) != 0)
+        if (buildRequestHttpHeadersHandle(handle, *toBeUsedRequestContent, 0, contentEncoding, requestHttpHeadersHandle, isOriginalRequestHttpHeadersHandle, toBeUsedRequestHttpHeadersHandle) != 0)
         {
             /*Codes_SRS_HTTPAPIEX_02_010: [If any of the operations in SRS_HTTAPIEX_02_009 fails, then HTTPAPIEX_ExecuteRequest shall return HTTPAPIEX_ERROR.] */
             if (*isOriginalRequestContent == false)
@@ -345,6 +991,26 @@ HTTPAPIEX_RESULT HTTPAPIEX_ExecuteRequest(HTTPAPIEX_HANDLE handle, HTTPAPI_REQUE
                 /*Codes_SRS_HTTPAPIEX_02_026: [A step shall be retried at most once.]*/
                 /*Codes_SRS_HTTPAPIEX_02_027: [If a step has been retried then all subsequent steps shall be retried too.]*/
                 bool st[3] = { false, false, false }; /*the three levels of possible failure in resilient send: HTTAPI_Init, HTTPAPI_CreateConnection, HTTPAPI_ExecuteRequest*/
+                bool isRetryPending = false;
+                size_t retryCount = 0;
+                bool isAdmitted = isRequestAdmitted(handleData);
+
+                /*Codes_SRS_HTTPAPIEX_02_064: [If the circuit breaker of the retry policy is open then HTTPAPIEX_ExecuteRequest shall fail without executing the request and return HTTPAPIEX_RECOVERYFAILED.]*/
+                if (!isAdmitted)
+                {
+                    result = HTTPAPIEX_RECOVERYFAILED;
+                    LogError("the circuit breaker is open, the request is not sent");
+                    goto out;
+                }
+
+                /*Codes_SRS_HTTPAPIEX_02_049: [If the connection pool is enabled then HTTPAPIEX_ExecuteRequest shall execute the request on the most recently used idle connection, or on a new connection when there is none.]*/
+                /*Codes_SRS_HTTPAPIEX_02_050: [If executing the request on a pooled connection fails then HTTPAPIEX_ExecuteRequest shall close that connection and retry the request once on a new connection.]*/
+                if (handleData->poolLock != NULL)
+                {
+                    result = executePooledRequest(handleData, requestType, toBeUsedRelativePath, toBeUsedRequestHttpHeadersHandle, toBeUsedRequestContent, toBeUsedStatusCode, toBeUsedResponseHttpHeadersHandle, toBeUsedResponseContent);
+                    goto out;
+                }
+
                 if (handleData->k == -1)
                 {
                     handleData->k = 0;
@@ -366,6 +1032,18 @@ HTTPAPIEX_RESULT HTTPAPIEX_ExecuteRequest(HTTPAPIEX_HANDLE handle, HTTPAPI_REQUE
                     }
                     else
                     {
+                        if (isRetryPending)
+                        {
+                            /*Codes_SRS_HTTPAPIEX_02_062: [If a retry policy is set then HTTPAPIEX_ExecuteRequest shall wait a random delay between 0 and min(max_backoff_ms, initial_backoff_ms * 2^n) before the retry n (0 based).]*/
+                            /*Codes_SRS_HTTPAPIEX_02_063: [If the retry budget of the retry policy has no token left then HTTPAPIEX_ExecuteRequest shall not retry and shall return HTTPAPIEX_RECOVERYFAILED.]*/
+                            if (!waitBeforeRetry(handleData, retryCount))
+                            {
+                                break;
+                            }
+                            retryCount++;
+                            isRetryPending = false;
+                        }
+
                         switch (handleData->k)
                         {
                         case 0:
@@ -444,6 +1122,7 @@ HTTPAPIEX_RESULT HTTPAPIEX_ExecuteRequest(HTTPAPIEX_HANDLE handle, HTTPAPI_REQUE
                     }
                     else
                     {
+                        isRetryPending = true;
                         st[handleData->k] = false;
                         handleData->k--;
                         switch (handleData->k)
@@ -474,6 +1153,12 @@ HTTPAPIEX_RESULT HTTPAPIEX_ExecuteRequest(HTTPAPIEX_HANDLE handle, HTTPAPI_REQUE
                 result = HTTPAPIEX_RECOVERYFAILED;
                 LogError("unable to recover sending to a working state");
             out:;
+                /*Codes_SRS_HTTPAPIEX_02_065: [If a retry policy is set then HTTPAPIEX_ExecuteRequest shall count the consecutive requests that returned HTTPAPIEX_RECOVERYFAILED and open the circuit breaker for circuit_breaker_open_ms once they reach circuit_breaker_threshold.]*/
+                /*Codes_SRS_HTTPAPIEX_02_066: [A request that returns HTTPAPIEX_OK shall close the circuit breaker, reset the count of consecutive failures and give a token back to the retry budget.]*/
+                if (isAdmitted)
+                {
+                    recordRequestOutcome(handleData, result);
+                }
                 /*in all cases, unbuild the temporaries*/
                 if (isOriginalRequestContent == false)
                 {
@@ -498,6 +1183,249 @@ HTTPAPIEX_RESULT HTTPAPIEX_ExecuteRequest(HTTPAPIEX_HANDLE handle, HTTPAPI_REQUE
 }
 
 
+typedef struct HTTPAPIEX_STREAMING_CONTEXT_TAG
+{
+    HTTPAPI_READ_CONTENT readRequestContent;
+    void* readRequestContentContext;
+    HTTPAPI_WRITE_CONTENT writeResponseContent;
+    void* writeResponseContentContext;
+    bool hasStreamed; /*once a body has started to flow the request cannot be replayed*/
+}HTTPAPIEX_STREAMING_CONTEXT;
+
+static int readStreamedRequestContent(void* context, unsigned char* buffer, size_t bufferSize, size_t* bytesRead)
+{
+    HTTPAPIEX_STREAMING_CONTEXT* streamingContext = (HTTPAPIEX_STREAMING_CONTEXT*)context;
+    streamingContext->hasStreamed = true;
+    return streamingContext->readRequestContent(streamingContext->readRequestContentContext, buffer, bufferSize, bytesRead);
+}
+
+static int writeStreamedResponseContent(void* context, const unsigned char* buffer, size_t size)
+{
+    int result;
+    HTTPAPIEX_STREAMING_CONTEXT* streamingContext = (HTTPAPIEX_STREAMING_CONTEXT*)context;
+    streamingContext->hasStreamed = true;
+    if (streamingContext->writeResponseContent == NULL)
+    {
+        /*Codes_SRS_HTTPAPIEX_02_058: [If writeResponseContent is NULL then the response body shall be discarded.]*/
+        result = 0;
+    }
+    else
+    {
+        result = streamingContext->writeResponseContent(streamingContext->writeResponseContentContext, buffer, size);
+    }
+    return result;
+}
+
+/*brings the classic (not pooled) connection to the state HTTPAPIEX_ExecuteRequest leaves it in on success (k == 2)*/
+static int ensureConnection(HTTPAPIEX_HANDLE_DATA* handleData)
+{
+    int result;
+
+    if ((handleData->k < 1) && (HTTPAPI_Init() != HTTPAPI_OK))
+    {
+        LogError("unable to HTTPAPI_Init");
+        handleData->k = 0;
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (handleData->k < 1)
+        {
+            handleData->k = 1;
+        }
+
+        if (handleData->k == 2)
+        {
+            result = 0;
+        }
+        else if ((handleData->httpHandle = HTTPAPI_CreateConnection(STRING_c_str(handleData->hostName))) == NULL)
+        {
+            LogError("unable to HTTPAPI_CreateConnection");
+            HTTPAPI_Deinit();
+            handleData->k = 0;
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t i;
+            size_t vectorSize = VECTOR_size(handleData->savedOptions);
+            for (i = 0; i < vectorSize; i++)
+            {
+                HTTPAPIEX_SAVED_OPTION* option = (HTTPAPIEX_SAVED_OPTION*)VECTOR_element(handleData->savedOptions, i);
+                if (HTTPAPI_SetOption(handleData->httpHandle, option->optionName, option->value) != HTTPAPI_OK)
+                {
+                    LogError("HTTPAPI_SetOption failed when called for option %s", option->optionName);
+                }
+            }
+            handleData->k = 2;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static HTTPAPIEX_RESULT executeStreamingRequest(HTTPAPIEX_HANDLE_DATA* handleData, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE requestHttpHeadersHandle, size_t requestContentLength, HTTPAPIEX_STREAMING_CONTEXT* streamingContext, unsigned int* statusCode,
+    HTTP_HEADERS_HANDLE responseHttpHeadersHandle)
+{
+    HTTPAPIEX_RESULT result = HTTPAPIEX_RECOVERYFAILED;
+    HTTPAPI_READ_CONTENT readContent = (streamingContext->readRequestContent != NULL) ? readStreamedRequestContent : NULL;
+    int attempt;
+
+    for (attempt = 0; (attempt < 2) && !streamingContext->hasStreamed; attempt++)
+    {
+        if ((attempt > 0) && !waitBeforeRetry(handleData, (size_t)attempt - 1))
+        {
+            break;
+        }
+        else if (handleData->poolLock != NULL)
+        {
+            HTTPAPIEX_POOLED_CONNECTION* connection = acquirePooledConnection(handleData, attempt > 0);
+            if (connection == NULL)
+            {
+                break;
+            }
+            else if (HTTPAPI_ExecuteStreamingRequest(connection->httpHandle, requestType, relativePath, requestHttpHeadersHandle, requestContentLength, readContent, streamingContext, statusCode, responseHttpHeadersHandle, writeStreamedResponseContent, streamingContext) != HTTPAPI_OK)
+            {
+                closePooledConnection(connection);
+            }
+            else
+            {
+                releasePooledConnection(handleData, connection);
+                result = HTTPAPIEX_OK;
+                break;
+            }
+        }
+        else
+        {
+            if (ensureConnection(handleData) != 0)
+            {
+                break;
+            }
+            else if (HTTPAPI_ExecuteStreamingRequest(handleData->httpHandle, requestType, relativePath, requestHttpHeadersHandle, requestContentLength, readContent, streamingContext, statusCode, responseHttpHeadersHandle, writeStreamedResponseContent, streamingContext) != HTTPAPI_OK)
+            {
+                HTTPAPI_CloseConnection(handleData->httpHandle);
+                handleData->httpHandle = NULL;
+                handleData->k = 1;
+            }
+            else
+            {
+                result = HTTPAPIEX_OK;
+                break;
+            }
+        }
+    }
+
+    if (result != HTTPAPIEX_OK)
+    {
+        if (handleData->k == 1)
+        {
+            HTTPAPI_Deinit();
+            handleData->k = 0;
+        }
+
+        if (streamingContext->hasStreamed)
+        {
+            /*Codes_SRS_HTTPAPIEX_02_060: [If the request fails after readRequestContent or writeResponseContent has been called then HTTPAPIEX_ExecuteStreamingRequest shall not retry it and shall return HTTPAPIEX_ERROR.]*/
+            result = HTTPAPIEX_ERROR;
+            LogError("the request failed after its content started streaming, it cannot be retried");
+        }
+        else
+        {
+            LogError("unable to recover sending to a working state");
+        }
+    }
+
+    return result;
+}
+
+HTTPAPIEX_RESULT HTTPAPIEX_ExecuteStreamingRequest(HTTPAPIEX_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath,
+    HTTP_HEADERS_HANDLE requestHttpHeadersHandle, size_t requestContentLength, HTTPAPI_READ_CONTENT readRequestContent, void* readRequestContentContext, unsigned int* statusCode,
+    HTTP_HEADERS_HANDLE responseHttpHeadersHandle, HTTPAPI_WRITE_CONTENT writeResponseContent, void* writeResponseContentContext)
+{
+    HTTPAPIEX_RESULT result;
+    /*Codes_SRS_HTTPAPIEX_02_054: [If parameter handle is NULL, requestType is not a valid request or readRequestContent is NULL while requestContentLength is not 0 then HTTPAPIEX_ExecuteStreamingRequest shall fail and return HTTPAPIEX_INVALID_ARG.]*/
+    if ((handle == NULL) ||
+        (requestType >= COUNT_ARG(HTTPAPI_REQUEST_TYPE_VALUES)) ||
+        ((readRequestContent == NULL) && (requestContentLength > 0)))
+    {
+        result = HTTPAPIEX_INVALID_ARG;
+        LOG_HTTAPIEX_ERROR();
+    }
+    else
+    {
+        HTTPAPIEX_HANDLE_DATA* handleData = (HTTPAPIEX_HANDLE_DATA*)handle;
+        HTTP_HEADERS_HANDLE toBeUsedRequestHttpHeadersHandle; bool isOriginalRequestHttpHeadersHandle;
+        HTTP_HEADERS_HANDLE toBeUsedResponseHttpHeadersHandle; bool isOriginalResponseHttpHeadersHandle;
+        const char* contentEncoding;
+        HTTPAPIEX_COMPRESSED_CONTENT compressedContent;
+
+        if (compressStreamedRequestContent(handleData, requestHttpHeadersHandle, &requestContentLength, &readRequestContent, &readRequestContentContext, &compressedContent, &contentEncoding) != 0)
+        {
+            /*Codes_SRS_HTTPAPIEX_01_007: [ If reading or compressing the request body fails then HTTPAPIEX_ExecuteStreamingRequest shall fail and return HTTPAPIEX_ERROR. ]*/
+            result = HTTPAPIEX_ERROR;
+            LOG_HTTAPIEX_ERROR();
+        }
+        /*Codes_SRS_HTTPAPIEX_02_055: [HTTPAPIEX_ExecuteStreamingRequest shall build the request headers, the relative path, the status code and the response headers the same way HTTPAPIEX_ExecuteRequest does, using requestContentLength for the Content-Length header.]*/
+        else if (buildRequestHttpHeadersHandle(handleData, NULL, requestContentLength, contentEncoding, requestHttpHeadersHandle, &isOriginalRequestHttpHeadersHandle, &toBeUsedRequestHttpHeadersHandle) != 0)
+        {
+            result = HTTPAPIEX_ERROR;
+            LOG_HTTAPIEX_ERROR();
+        }
+        else if (buildResponseHttpHeadersHandle(responseHttpHeadersHandle, &isOriginalResponseHttpHeadersHandle, &toBeUsedResponseHttpHeadersHandle) != 0)
+        {
+            if (isOriginalRequestHttpHeadersHandle == false)
+            {
+                HTTPHeaders_Free(toBeUsedRequestHttpHeadersHandle);
+            }
+            result = HTTPAPIEX_ERROR;
+            LOG_HTTAPIEX_ERROR();
+        }
+        else
+        {
+            HTTPAPIEX_STREAMING_CONTEXT streamingContext;
+            streamingContext.readRequestContent = readRequestContent;
+            streamingContext.readRequestContentContext = readRequestContentContext;
+            streamingContext.writeResponseContent = writeResponseContent;
+            streamingContext.writeResponseContentContext = writeResponseContentContext;
+            streamingContext.hasStreamed = false;
+
+            /*Codes_SRS_HTTPAPIEX_02_056: [HTTPAPIEX_ExecuteStreamingRequest shall call HTTPAPI_ExecuteStreamingRequest on the connection HTTPAPIEX_ExecuteRequest would use, creating it if needed.]*/
+            /*Codes_SRS_HTTPAPIEX_02_057: [The request body shall be read with readRequestContent and the response body shall be passed to writeResponseContent.]*/
+            /*Codes_SRS_HTTPAPIEX_02_059: [If HTTPAPI_ExecuteStreamingRequest fails before any body has been streamed then HTTPAPIEX_ExecuteStreamingRequest shall close the connection and retry the request once on a new connection.]*/
+            /*Codes_SRS_HTTPAPIEX_02_067: [HTTPAPIEX_ExecuteStreamingRequest shall apply the retry policy the same way HTTPAPIEX_ExecuteRequest does.]*/
+            if (!isRequestAdmitted(handleData))
+            {
+                result = HTTPAPIEX_RECOVERYFAILED;
+                LogError("the circuit breaker is open, the request is not sent");
+            }
+            else
+            {
+                result = executeStreamingRequest(handleData, requestType, (relativePath == NULL) ? "" : relativePath,
+                    toBeUsedRequestHttpHeadersHandle, requestContentLength, &streamingContext, (statusCode == NULL) ? &dummyStatusCode : statusCode,
+                    toBeUsedResponseHttpHeadersHandle);
+                recordRequestOutcome(handleData, result);
+            }
+
+            if (isOriginalRequestHttpHeadersHandle == false)
+            {
+                HTTPHeaders_Free(toBeUsedRequestHttpHeadersHandle);
+            }
+            if (isOriginalResponseHttpHeadersHandle == false)
+            {
+                HTTPHeaders_Free(toBeUsedResponseHttpHeadersHandle);
+            }
+        }
+
+        if (compressedContent.content != NULL)
+        {
+            BUFFER_delete(compressedContent.content);
+        }
+    }
+    return result;
+}
+
 void HTTPAPIEX_Destroy(HTTPAPIEX_HANDLE handle)
 {
     if (handle != NULL)
@@ -512,6 +1440,27 @@ void HTTPAPIEX_Destroy(HTTPAPIEX_HANDLE handle)
             HTTPAPI_CloseConnection(handleData->httpHandle);
             HTTPAPI_Deinit();
         }
+
+        /*Codes_SRS_HTTPAPIEX_02_053: [HTTPAPIEX_Destroy shall close all the idle connections of the connection pool.]*/
+        if (handleData->poolLock != NULL)
+        {
+            while (handleData->idleConnections != NULL)
+            {
+                HTTPAPIEX_POOLED_CONNECTION* connection = handleData->idleConnections;
+                handleData->idleConnections = connection->next;
+                closePooledConnection(connection);
+            }
+            if (handleData->poolHttpApiInitialized)
+            {
+                HTTPAPI_Deinit();
+            }
+            tickcounter_destroy(handleData->poolTickCounter);
+            (void)Lock_Deinit(handleData->poolLock);
+        }
+        if (handleData->retryTickCounter != NULL)
+        {
+            tickcounter_destroy(handleData->retryTickCounter);
+        }
         STRING_delete(handleData->hostName);
 
         vectorSize = VECTOR_size(handleData->savedOptions);
@@ -579,6 +1528,123 @@ static int createOrUpdateOption(HTTPAPIEX_HANDLE_DATA* handleData, const char* o
     return result;
 }
 
+static HTTPAPIEX_RESULT setPoolOption(HTTPAPIEX_HANDLE_DATA* handleData, const char* optionName, const void* value)
+{
+    HTTPAPIEX_RESULT result;
+
+    if (handleData->poolLock == NULL)
+    {
+        if (strcmp(optionName, OPTION_HTTPAPIEX_IDLE_TIMEOUT) == 0)
+        {
+            handleData->idleTimeout = *(const unsigned int*)value;
+            result = HTTPAPIEX_OK;
+        }
+        else if (*(const size_t*)value == 0)
+        {
+            handleData->maxIdleConnections = 0;
+            result = HTTPAPIEX_OK;
+        }
+        else if (handleData->httpHandle != NULL)
+        {
+            /*Codes_SRS_HTTPAPIEX_02_046: [If OPTION_HTTPAPIEX_MAX_IDLE_CONNECTIONS enables the connection pool after HTTPAPIEX_ExecuteRequest has created a connection then HTTPAPIEX_SetOption shall return HTTPAPIEX_ERROR.]*/
+            LogError("the connection pool has to be enabled before the first request");
+            result = HTTPAPIEX_ERROR;
+        }
+        /*Codes_SRS_HTTPAPIEX_02_045: [Setting OPTION_HTTPAPIEX_MAX_IDLE_CONNECTIONS to a value other than 0 shall enable the connection pool, which makes HTTPAPIEX_ExecuteRequest and HTTPAPIEX_SetOption thread safe.]*/
+        else if ((handleData->poolLock = Lock_Init()) == NULL)
+        {
+            /*Codes_SRS_HTTPAPIEX_02_047: [If enabling the connection pool fails then HTTPAPIEX_SetOption shall return HTTPAPIEX_ERROR.]*/
+            LogError("unable to Lock_Init");
+            result = HTTPAPIEX_ERROR;
+        }
+        else if ((handleData->poolTickCounter = tickcounter_create()) == NULL)
+        {
+            LogError("unable to tickcounter_create");
+            (void)Lock_Deinit(handleData->poolLock);
+            handleData->poolLock = NULL;
+            result = HTTPAPIEX_ERROR;
+        }
+        else
+        {
+            handleData->maxIdleConnections = *(const size_t*)value;
+            result = HTTPAPIEX_OK;
+        }
+    }
+    else if (Lock(handleData->poolLock) != LOCK_OK)
+    {
+        LogError("unable to Lock");
+        result = HTTPAPIEX_ERROR;
+    }
+    else
+    {
+        /*Codes_SRS_HTTPAPIEX_02_048: [Once the connection pool is enabled, idle connections in excess of OPTION_HTTPAPIEX_MAX_IDLE_CONNECTIONS or idle for longer than OPTION_HTTPAPIEX_IDLE_TIMEOUT shall be closed.]*/
+        if (strcmp(optionName, OPTION_HTTPAPIEX_IDLE_TIMEOUT) == 0)
+        {
+            handleData->idleTimeout = *(const unsigned int*)value;
+        }
+        else
+        {
+            handleData->maxIdleConnections = *(const size_t*)value;
+        }
+        trimIdleConnections(handleData);
+        (void)Unlock(handleData->poolLock);
+        result = HTTPAPIEX_OK;
+    }
+
+    return result;
+}
+
+static HTTPAPIEX_RESULT setRetryPolicyOption(HTTPAPIEX_HANDLE_DATA* handleData, const HTTPAPIEX_RETRY_POLICY* retryPolicy)
+{
+    HTTPAPIEX_RESULT result;
+
+    if (lockRetryState(handleData) != 0)
+    {
+        result = HTTPAPIEX_ERROR;
+    }
+    else
+    {
+        if ((retryPolicy->circuit_breaker_threshold != 0) &&
+            (handleData->retryTickCounter == NULL) &&
+            ((handleData->retryTickCounter = tickcounter_create()) == NULL))
+        {
+            /*Codes_SRS_HTTPAPIEX_02_068: [If setting OPTION_HTTPAPIEX_RETRY_POLICY fails then HTTPAPIEX_SetOption shall return HTTPAPIEX_ERROR.]*/
+            LogError("unable to tickcounter_create");
+            result = HTTPAPIEX_ERROR;
+        }
+        else
+        {
+            /*Codes_SRS_HTTPAPIEX_02_061: [Setting OPTION_HTTPAPIEX_RETRY_POLICY shall replace the retry policy, fill its retry budget and close its circuit breaker.]*/
+            handleData->retryPolicy = *retryPolicy;
+            handleData->retryTokens = retryPolicy->retry_budget;
+            handleData->consecutiveFailures = 0;
+            handleData->isCircuitOpen = false;
+            handleData->hasRetryPolicy = true;
+            result = HTTPAPIEX_OK;
+        }
+        unlockRetryState(handleData);
+    }
+
+    return result;
+}
+
+static HTTPAPIEX_RESULT setCompressionOption(HTTPAPIEX_HANDLE_DATA* handleData, const size_t* compressionThreshold)
+{
+    HTTPAPIEX_RESULT result;
+#ifdef USE_HTTP_COMPRESSION
+    /*Codes_SRS_HTTPAPIEX_01_001: [ Setting OPTION_HTTPAPIEX_REQUEST_COMPRESSION_THRESHOLD shall make the requests whose body is at least *value bytes be sent gzip compressed, 0 disabling the compression. ]*/
+    handleData->compressionThreshold = *compressionThreshold;
+    result = HTTPAPIEX_OK;
+#else
+    /*Codes_SRS_HTTPAPIEX_01_002: [ If the library is built without use_http_compression, setting OPTION_HTTPAPIEX_REQUEST_COMPRESSION_THRESHOLD shall fail and return HTTPAPIEX_ERROR. ]*/
+    (void)handleData;
+    (void)compressionThreshold;
+    LogError("the request compression is not supported, the library is built without use_http_compression");
+    result = HTTPAPIEX_ERROR;
+#endif
+    return result;
+}
+
 HTTPAPIEX_RESULT HTTPAPIEX_SetOption(HTTPAPIEX_HANDLE handle, const char* optionName, const void* value)
 {
     HTTPAPIEX_RESULT result;
@@ -594,6 +1660,23 @@ HTTPAPIEX_RESULT HTTPAPIEX_SetOption(HTTPAPIEX_HANDLE handle, const char* option
         result = HTTPAPIEX_INVALID_ARG;
         LOG_HTTAPIEX_ERROR();
     }
+    /*Codes_SRS_HTTPAPIEX_02_030: [If parameter optionName is one of the options handled by HTTPAPIEX then it shall be set to value *value.]*/
+    /*Codes_SRS_HTTPAPIEX_02_044: [Options handled by HTTPAPIEX shall not be passed to HTTPAPI_CloneOption nor to HTTPAPI_SetOption.]*/
+    else if (
+        (strcmp(optionName, OPTION_HTTPAPIEX_MAX_IDLE_CONNECTIONS) == 0) ||
+        (strcmp(optionName, OPTION_HTTPAPIEX_IDLE_TIMEOUT) == 0)
+        )
+    {
+        result = setPoolOption((HTTPAPIEX_HANDLE_DATA*)handle, optionName, value);
+    }
+    else if (strcmp(optionName, OPTION_HTTPAPIEX_RETRY_POLICY) == 0)
+    {
+        result = setRetryPolicyOption((HTTPAPIEX_HANDLE_DATA*)handle, (const HTTPAPIEX_RETRY_POLICY*)value);
+    }
+    else if (strcmp(optionName, OPTION_HTTPAPIEX_REQUEST_COMPRESSION_THRESHOLD) == 0)
+    {
+        result = setCompressionOption((HTTPAPIEX_HANDLE_DATA*)handle, (const size_t*)value);
+    }
     else
     {
         const void* savedOption;
@@ -617,8 +1700,28 @@ HTTPAPIEX_RESULT HTTPAPIEX_SetOption(HTTPAPIEX_HANDLE handle, const char* option
         else
         {
             HTTPAPIEX_HANDLE_DATA* handleData = (HTTPAPIEX_HANDLE_DATA*)handle;
-            /*Codes_SRS_HTTPAPIEX_02_039: [If HTTPAPI_CloneOption returns HTTPAPI_OK then HTTPAPIEX_SetOption shall create or update the pair optionName/value.]*/
-            if (createOrUpdateOption(handleData, optionName, savedOption) != 0)
+            int createOrUpdateResult;
+
+            /*Codes_SRS_HTTPAPIEX_02_051: [If the connection pool is enabled then HTTPAPIEX_SetOption shall update the saved options under the pool lock.]*/
+            if ((handleData->poolLock != NULL) && (Lock(handleData->poolLock) != LOCK_OK))
+            {
+                LogError("unable to Lock");
+                free((void*)savedOption);
+                createOrUpdateResult = __FAILURE__;
+            }
+            else
+            {
+                /*Codes_SRS_HTTPAPIEX_02_039: [If HTTPAPI_CloneOption returns HTTPAPI_OK then HTTPAPIEX_SetOption shall create or update the pair optionName/value.]*/
+                createOrUpdateResult = createOrUpdateOption(handleData, optionName, savedOption);
+                if (handleData->poolLock != NULL)
+                {
+                    /*Codes_SRS_HTTPAPIEX_02_052: [Idle connections of the connection pool created before the option was set shall not be reused.]*/
+                    handleData->optionsGeneration++;
+                    (void)Unlock(handleData->poolLock);
+                }
+            }
+
+            if (createOrUpdateResult != 0)
             {
                 /*Codes_SRS_HTTPAPIEX_02_041: [If creating or updating the pair optionName/value fails then shall return HTTPAPIEX_ERROR.] */
                 result = HTTPAPIEX_ERROR;
@@ -4,10 +4,12 @@
 #include <stdlib.h>
 #include "azure_c_shared_utility/gballoc.h"
 #include <stddef.h>
+#include <stdbool.h>
 #include <time.h>
 #include "azure_c_shared_utility/agenttime.h"
 #include "azure_c_shared_utility/strings.h"
 #include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/hmacsha256.h"
 #include "azure_c_shared_utility/sastoken.h"
 #include "azure_c_shared_utility/httpheaders.h"
 #include "azure_c_shared_utility/httpapiex.h"
@@ -16,12 +18,18 @@
 #include "azure_c_shared_utility/crt_abstractions.h"
 
 #define SHARED_ACCESS_SIGNATURE_PREFIX "sas="
+#define SAS_TOKEN_LIFETIME_IN_SECONDS 3600
 
 typedef struct HTTPAPIEX_SAS_STATE_TAG
 {
     char* key;
     char* uriResource;
     char* keyName;
+    HMACSHA256_KEY_CONTEXT_HANDLE keyContext;
+    /* the token last put in the Authorization header, reused until it gets within refreshMargin seconds of tokenExpiry */
+    STRING_HANDLE token;
+    size_t tokenExpiry;
+    size_t refreshMargin;
 } HTTPAPIEX_SAS_STATE;
 
 static HTTPAPIEX_SAS_STATE* construct_httpex_sas(const char* key, const char* uriResource, const char* keyName)
@@ -36,6 +44,7 @@ static HTTPAPIEX_SAS_STATE* construct_httpex_sas(const char* key, const char* ur
     else
     {
         (void)memset(result, 0, sizeof(HTTPAPIEX_SAS_STATE));
+        result->refreshMargin = HTTPAPIEX_SAS_DEFAULT_TOKEN_REFRESH_MARGIN;
         if (mallocAndStrcpy_s(&result->key, key) != 0)
         {
             /*Codes_SRS_HTTPAPIEXSAS_06_004: [If there are any other errors in the instantiation of this handle then HTTPAPIEX_SAS_Create shall return NULL.]*/
@@ -57,6 +66,15 @@ static HTTPAPIEX_SAS_STATE* construct_httpex_sas(const char* key, const char* ur
             HTTPAPIEX_SAS_Destroy(result);
             result = NULL;
         }
+        else if (strncmp(key, SHARED_ACCESS_SIGNATURE_PREFIX, 4) != 0)
+        {
+            /*Codes_SRS_HTTPAPIEXSAS_01_002: [ If key is not prefixed with "sas=", the key context used to sign the SAS tokens shall be created once by calling SASToken_CreateKeyContext. ]*/
+            if ((result->keyContext = SASToken_CreateKeyContext(key)) == NULL)
+            {
+                /*Codes_SRS_HTTPAPIEXSAS_01_003: [ If creating the key context fails, the handle shall still be created and the SAS tokens shall be created by SASToken_CreateString. ]*/
+                LogError("Failure creating the key context, the key is decoded for each SAS token.");
+            }
+        }
     }
     return result;
 }
@@ -123,10 +141,36 @@ void HTTPAPIEX_SAS_Destroy(HTTPAPIEX_SAS_HANDLE handle)
         {
             free(state->keyName);
         }
+        if (state->keyContext)
+        {
+            HMACSHA256_KeyContext_Destroy(state->keyContext);
+        }
+        if (state->token)
+        {
+            STRING_delete(state->token);
+        }
         free(state);
     }
 }
 
+int HTTPAPIEX_SAS_SetTokenRefreshMargin(HTTPAPIEX_SAS_HANDLE sasHandle, size_t refreshMargin)
+{
+    int result;
+    if (sasHandle == NULL)
+    {
+        /*Codes_SRS_HTTPAPIEXSAS_01_005: [ If sasHandle is NULL, HTTPAPIEX_SAS_SetTokenRefreshMargin shall fail and return a non-zero value. ]*/
+        LogError("NULL sasHandle");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_HTTPAPIEXSAS_01_006: [ Otherwise HTTPAPIEX_SAS_SetTokenRefreshMargin shall set the refresh margin used by the following requests and return 0. ]*/
+        sasHandle->refreshMargin = refreshMargin;
+        result = 0;
+    }
+    return result;
+}
+
 HTTPAPIEX_RESULT HTTPAPIEX_SAS_ExecuteRequest(HTTPAPIEX_SAS_HANDLE sasHandle, HTTPAPIEX_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath, HTTP_HEADERS_HANDLE requestHttpHeadersHandle, BUFFER_HANDLE requestContent, unsigned int* statusCode, HTTP_HEADERS_HANDLE responseHeadersHandle, BUFFER_HANDLE responseContent)
 {
     /*Codes_SRS_HTTPAPIEXSAS_06_007: [If the parameter sasHandle is NULL then HTTPAPIEX_SAS_ExecuteRequest shall simply invoke HTTPAPIEX_ExecuteRequest with the remaining parameters (following sasHandle) as its arguments and shall return immediately with the result of that call as the result of HTTPAPIEX_SAS_ExecuteRequest.]*/
@@ -140,8 +184,8 @@ HTTPAPIEX_RESULT HTTPAPIEX_SAS_ExecuteRequest(HTTPAPIEX_SAS_HANDLE sasHandle, HT
             if (HTTPHeaders_FindHeaderValue(requestHttpHeadersHandle, "Authorization") != NULL)
             {
                 HTTPAPIEX_SAS_STATE* state = (HTTPAPIEX_SAS_STATE*)sasHandle;
-                /*Codes_SRS_HTTPAPIEXSAS_06_018: [A value of type time_t that shall be known as currentTime is obtained from calling get_time.]*/
-                time_t currentTime = get_time(NULL);
+                /*Codes_SRS_HTTPAPIEXSAS_06_018: [A value of type time_t that shall be known as currentTime is obtained from calling get_time_coarse.]*/
+                time_t currentTime = get_time_coarse();
                 /*Codes_SRS_HTTPAPIEXSAS_06_019: [If the value of currentTime is (time_t)-1 is then fallthrough.]*/
                 if (currentTime == (time_t)-1)
                 {
@@ -149,34 +193,64 @@ HTTPAPIEX_RESULT HTTPAPIEX_SAS_ExecuteRequest(HTTPAPIEX_SAS_HANDLE sasHandle, HT
                 }
                 else
                 {
-                    STRING_HANDLE newSASToken = NULL;
-                    if (strncmp(state->key, SHARED_ACCESS_SIGNATURE_PREFIX, 4) == 0)
-                    {
-                        /*Codes_SRS_HTTPAPIEXSAS_06_017: [If state->key is prefixed with "sas=", SharedAccessSignature will be used rather than created.  STRING_construct will be invoked.]*/
-                        newSASToken = STRING_construct(&state->key[4]);
-                    }
-                    else
+                    size_t now = (size_t)difftime(currentTime, 0);
+                    bool isTokenProvided = (strncmp(state->key, SHARED_ACCESS_SIGNATURE_PREFIX, 4) == 0);
+
+                    /*Codes_SRS_HTTPAPIEXSAS_01_007: [ If a token was made by a previous request and it expires later than the refresh margin from currentTime, it shall be used again without creating a new one. ]*/
+                    /*Codes_SRS_HTTPAPIEXSAS_01_008: [ A token provided with the "sas=" prefix shall never be refreshed. ]*/
+                    if ((state->token == NULL) ||
+                        ((!isTokenProvided) && (now + state->refreshMargin >= state->tokenExpiry)))
                     {
+                        STRING_HANDLE newSASToken;
+                        size_t expiry = now + SAS_TOKEN_LIFETIME_IN_SECONDS;
+                        if (isTokenProvided)
+                        {
+                            /*Codes_SRS_HTTPAPIEXSAS_06_017: [If state->key is prefixed with "sas=", SharedAccessSignature will be used rather than created.  STRING_construct will be invoked.]*/
+                            newSASToken = STRING_construct(&state->key[4]);
+                        }
                         /*Codes_SRS_HTTPAPIEXSAS_06_011: [SASToken_Create shall be invoked.]*/
                         /*Codes_SRS_HTTPAPIEXSAS_06_012: [If the return result of SASToken_Create is NULL then fallthrough.]*/
-                        size_t expiry = (size_t)(difftime(currentTime, 0) + 3600);
-                        newSASToken = SASToken_CreateString(state->key, state->uriResource, state->keyName, expiry);
+                        else if (state->keyContext != NULL)
+                        {
+                            /*Codes_SRS_HTTPAPIEXSAS_01_004: [ If a key context was created, SASToken_CreateStringWithKeyContext shall be invoked with it instead of SASToken_CreateString. ]*/
+                            newSASToken = SASToken_CreateStringWithKeyContext(state->keyContext, state->uriResource, state->keyName, expiry);
+                        }
+                        else
+                        {
+                            newSASToken = SASToken_CreateString(state->key, state->uriResource, state->keyName, expiry);
+                        }
+
+                        if (newSASToken == NULL)
+                        {
+                            LogError("Unable to create a new SAS token.");
+                            /*Codes_SRS_HTTPAPIEXSAS_01_009: [ If creating the new token fails, the previous token shall still be used if it has not expired yet. ]*/
+                            if ((state->token != NULL) &&
+                                (now >= state->tokenExpiry))
+                            {
+                                STRING_delete(state->token);
+                                state->token = NULL;
+                            }
+                        }
+                        else
+                        {
+                            /*Codes_SRS_HTTPAPIEXSAS_06_015: [The previous token shall be deleted with STRING_delete when it is replaced by newSASToken.]*/
+                            if (state->token != NULL)
+                            {
+                                STRING_delete(state->token);
+                            }
+                            state->token = newSASToken;
+                            state->tokenExpiry = expiry;
+                        }
                     }
 
-                    if (newSASToken != NULL)
+                    if (state->token != NULL)
                     {
                         /*Codes_SRS_HTTPAPIEXSAS_06_013: [HTTPHeaders_ReplaceHeaderNameValuePair shall be invoked with "Authorization" as its second argument and STRING_c_str (newSASToken) as its third argument.]*/
-                        if (HTTPHeaders_ReplaceHeaderNameValuePair(requestHttpHeadersHandle, "Authorization", STRING_c_str(newSASToken)) != HTTP_HEADERS_OK)
+                        if (HTTPHeaders_ReplaceHeaderNameValuePair(requestHttpHeadersHandle, "Authorization", STRING_c_str(state->token)) != HTTP_HEADERS_OK)
                         {
                             /*Codes_SRS_HTTPAPIEXSAS_06_014: [If the result of the invocation of HTTPHeaders_ReplaceHeaderNameValuePair is NOT HTTP_HEADERS_OK then fallthrough.]*/
                             LogError("Unable to replace the old SAS Token.");
                         }
-                        /*Codes_SRS_HTTPAPIEXSAS_06_015: [STRING_delete(newSASToken) will be invoked.]*/
-                        STRING_delete(newSASToken);
-                    }
-                    else
-                    {
-                        LogError("Unable to create a new SAS token.");
                     }
                 }
             }
@@ -2,8 +2,9 @@
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include "azure_c_shared_utility/gballoc.h"
-#include "azure_c_shared_utility/map.h"
 #include "azure_c_shared_utility/httpheaders.h"
 #include <string.h>
 #include "azure_c_shared_utility/crt_abstractions.h"
@@ -11,11 +12,260 @@
 
 DEFINE_ENUM_STRINGS(HTTP_HEADERS_RESULT, HTTP_HEADERS_RESULT_VALUES);
 
+#define HTTP_HEADERS_MIN_ARENA_SIZE      256
+#define HTTP_HEADERS_MIN_HEADER_CAPACITY  8
+
+/*name and value are null-terminated strings in the arena, referenced by offset since the arena moves when it grows*/
+typedef struct HTTP_HEADER_TAG
+{
+    size_t name_offset;
+    size_t name_length;
+    size_t value_offset;
+    size_t value_length;
+    size_t hash;
+} HTTP_HEADER;
+
 typedef struct HTTP_HEADERS_HANDLE_DATA_TAG
 {
-    MAP_HANDLE headers;
+    char* arena;
+    size_t arena_size;
+    size_t arena_capacity;
+    /*bytes of the arena taken by values that were since concatenated to or replaced*/
+    size_t released_size;
+    /*the headers, in the order in which they were added, followed by the hash index*/
+    HTTP_HEADER* headers;
+    size_t header_count;
+    size_t header_capacity;
+    /*open addressing with linear probing over 2 * header_capacity slots, a slot holds a header index + 1 or 0 when free*/
+    size_t* index;
+    size_t serialized_size;
+    /*lines given to HTTPHeaders_AppendHeaderLines, each ended by a '\n', that are parsed into headers the first time the headers are read or changed*/
+    char* raw;
+    size_t raw_size;
+    size_t raw_capacity;
+    size_t raw_parsed;
 } HTTP_HEADERS_HANDLE_DATA;
 
+static char to_lower(char c)
+{
+    return ((c >= 'A') && (c <= 'Z')) ? (char)(c - 'A' + 'a') : c;
+}
+
+static size_t hash_header_name(const char* name, size_t name_length)
+{
+    /*FNV-1a over the lower-cased name, so that names differing only in case land in the same slot*/
+    size_t result = 2166136261u;
+    size_t i;
+
+    for (i = 0; i < name_length; i++)
+    {
+        result ^= (unsigned char)to_lower(name[i]);
+        result *= 16777619u;
+    }
+
+    return result;
+}
+
+static bool header_name_equals(const HTTP_HEADERS_HANDLE_DATA* handleData, const HTTP_HEADER* header, const char* name, size_t name_length, size_t hash)
+{
+    bool result;
+
+    if ((header->hash != hash) || (header->name_length != name_length))
+    {
+        result = false;
+    }
+    else
+    {
+        const char* header_name = handleData->arena + header->name_offset;
+        size_t i;
+
+        for (i = 0; i < name_length; i++)
+        {
+            if (to_lower(header_name[i]) != to_lower(name[i]))
+            {
+                break;
+            }
+        }
+
+        result = (i == name_length);
+    }
+
+    return result;
+}
+
+/*returns the index slot that holds the header called name, or the free slot where it would be inserted*/
+static size_t* find_index_slot(const HTTP_HEADERS_HANDLE_DATA* handleData, const char* name, size_t name_length, size_t hash)
+{
+    size_t mask = (2 * handleData->header_capacity) - 1;
+    size_t slot = hash & mask;
+
+    while ((handleData->index[slot] != 0) &&
+        !header_name_equals(handleData, &handleData->headers[handleData->index[slot] - 1], name, name_length, hash))
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return &handleData->index[slot];
+}
+
+static HTTP_HEADER* find_header(const HTTP_HEADERS_HANDLE_DATA* handleData, const char* name, size_t name_length, size_t hash)
+{
+    HTTP_HEADER* result;
+
+    if (handleData->header_count == 0)
+    {
+        result = NULL;
+    }
+    else
+    {
+        size_t* slot = find_index_slot(handleData, name, name_length, hash);
+        result = (*slot == 0) ? NULL : &handleData->headers[*slot - 1];
+    }
+
+    return result;
+}
+
+static int grow_headers(HTTP_HEADERS_HANDLE_DATA* handleData)
+{
+    int result;
+    size_t new_capacity = (handleData->header_capacity == 0) ? HTTP_HEADERS_MIN_HEADER_CAPACITY : handleData->header_capacity * 2;
+    HTTP_HEADER* new_headers;
+
+    if ((new_capacity > (SIZE_MAX / (sizeof(HTTP_HEADER) + 2 * sizeof(size_t)))) ||
+        ((new_headers = (HTTP_HEADER*)malloc(new_capacity * (sizeof(HTTP_HEADER) + 2 * sizeof(size_t)))) == NULL))
+    {
+        LogError("unable to grow the headers to %lu entries", (unsigned long)new_capacity);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t i;
+
+        if (handleData->headers != NULL)
+        {
+            (void)memcpy(new_headers, handleData->headers, handleData->header_count * sizeof(HTTP_HEADER));
+            free(handleData->headers);
+        }
+
+        handleData->headers = new_headers;
+        handleData->header_capacity = new_capacity;
+        handleData->index = (size_t*)(new_headers + new_capacity);
+        (void)memset(handleData->index, 0, 2 * new_capacity * sizeof(size_t));
+
+        for (i = 0; i < handleData->header_count; i++)
+        {
+            HTTP_HEADER* header = &handleData->headers[i];
+            *find_index_slot(handleData, handleData->arena + header->name_offset, header->name_length, header->hash) = i + 1;
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+/*makes room for size more bytes at the end of the arena. When the arena has to move, only the live names and values are
+carried over and the previous arena is returned in *previous, so that a value that points into it stays readable until the caller frees it*/
+static int reserve_arena(HTTP_HEADERS_HANDLE_DATA* handleData, size_t size, char** previous)
+{
+    int result;
+    size_t live_size = handleData->arena_size - handleData->released_size;
+
+    if (size <= handleData->arena_capacity - handleData->arena_size)
+    {
+        *previous = NULL;
+        result = 0;
+    }
+    else if (size > (SIZE_MAX / 2) - live_size)
+    {
+        LogError("header arena size overflow");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t new_capacity = 2 * (live_size + size);
+        char* new_arena;
+
+        if (new_capacity < HTTP_HEADERS_MIN_ARENA_SIZE)
+        {
+            new_capacity = HTTP_HEADERS_MIN_ARENA_SIZE;
+        }
+
+        if ((new_arena = (char*)malloc(new_capacity)) == NULL)
+        {
+            LogError("unable to grow the header arena to %lu bytes", (unsigned long)new_capacity);
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t new_size = 0;
+            size_t i;
+
+            for (i = 0; i < handleData->header_count; i++)
+            {
+                HTTP_HEADER* header = &handleData->headers[i];
+
+                (void)memcpy(new_arena + new_size, handleData->arena + header->name_offset, header->name_length + 1);
+                header->name_offset = new_size;
+                new_size += header->name_length + 1;
+
+                (void)memcpy(new_arena + new_size, handleData->arena + header->value_offset, header->value_length + 1);
+                header->value_offset = new_size;
+                new_size += header->value_length + 1;
+            }
+
+            *previous = handleData->arena;
+            handleData->arena = new_arena;
+            handleData->arena_size = new_size;
+            handleData->arena_capacity = new_capacity;
+            handleData->released_size = 0;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+/*makes room for size more bytes at the end of the lines that are not parsed yet*/
+static int reserve_raw(HTTP_HEADERS_HANDLE_DATA* handleData, size_t size)
+{
+    int result;
+
+    if (size <= handleData->raw_capacity - handleData->raw_size)
+    {
+        result = 0;
+    }
+    else if (size > (SIZE_MAX / 2) - handleData->raw_size)
+    {
+        LogError("header lines size overflow");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t new_capacity = 2 * (handleData->raw_size + size);
+        char* new_raw;
+
+        if (new_capacity < HTTP_HEADERS_MIN_ARENA_SIZE)
+        {
+            new_capacity = HTTP_HEADERS_MIN_ARENA_SIZE;
+        }
+
+        if ((new_raw = (char*)realloc(handleData->raw, new_capacity)) == NULL)
+        {
+            LogError("unable to grow the header lines to %lu bytes", (unsigned long)new_capacity);
+            result = __FAILURE__;
+        }
+        else
+        {
+            handleData->raw = new_raw;
+            handleData->raw_capacity = new_capacity;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
 HTTP_HEADERS_HANDLE HTTPHeaders_Alloc(void)
 {
     /*Codes_SRS_HTTP_HEADERS_99_002:[ This API shall produce a HTTP_HANDLE that can later be used in subsequent calls to the module.]*/
@@ -29,17 +279,8 @@ HTTP_HEADERS_HANDLE HTTPHeaders_Alloc(void)
     else
     {
         /*Codes_SRS_HTTP_HEADERS_99_004:[ After a successful init, HTTPHeaders_GetHeaderCount shall report 0 existing headers.]*/
-        result->headers = Map_Create(NULL);
-        if (result->headers == NULL)
-        {
-            LogError("Map_Create failed");
-            free(result);
-            result = NULL;
-        }
-        else
-        {
-            /*all is fine*/
-        }
+        /*Codes_SRS_HTTP_HEADERS_99_038: [The names and the values of the headers shall be stored in a single arena owned by the handle, that is allocated when the first header is added and grows as needed.]*/
+        (void)memset(result, 0, sizeof(HTTP_HEADERS_HANDLE_DATA));
     }
 
     /*Codes_SRS_HTTP_HEADERS_99_003:[ The function shall return NULL when the function cannot execute properly]*/
@@ -59,11 +300,217 @@ void HTTPHeaders_Free(HTTP_HEADERS_HANDLE handle)
         /*Codes_SRS_HTTP_HEADERS_99_005:[ Calling this API shall de-allocate the data structures allocated by previous API calls to the same handle.]*/
         HTTP_HEADERS_HANDLE_DATA* handleData = (HTTP_HEADERS_HANDLE_DATA*)handle;
 
-        Map_Destroy(handleData->headers);
+        free(handleData->arena);
+        free(handleData->headers);
+        free(handleData->raw);
         free(handleData);
     }
 }
 
+static HTTP_HEADERS_RESULT add_header(HTTP_HEADERS_HANDLE_DATA* handleData, const char* name, size_t name_length, size_t hash, const char* value, size_t value_length)
+{
+    HTTP_HEADERS_RESULT result;
+    char* previous_arena;
+
+    if ((handleData->header_count == handleData->header_capacity) &&
+        (grow_headers(handleData) != 0))
+    {
+        /*Codes_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
+        result = HTTP_HEADERS_ALLOC_FAILED;
+        LogError("failed to grow the headers, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
+    }
+    else if ((name_length > SIZE_MAX - value_length - 2) ||
+        (reserve_arena(handleData, name_length + 1 + value_length + 1, &previous_arena) != 0))
+    {
+        /*Codes_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
+        result = HTTP_HEADERS_ALLOC_FAILED;
+        LogError("failed to grow the header arena, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
+    }
+    else
+    {
+        HTTP_HEADER* header = &handleData->headers[handleData->header_count];
+
+        header->name_offset = handleData->arena_size;
+        header->name_length = name_length;
+        header->value_offset = header->name_offset + name_length + 1;
+        header->value_length = value_length;
+        header->hash = hash;
+        /*name and value do not have to be null-terminated, the lines of HTTPHeaders_AppendHeaderLines are not*/
+        (void)memcpy(handleData->arena + header->name_offset, name, name_length);
+        handleData->arena[header->name_offset + name_length] = '\0';
+        (void)memcpy(handleData->arena + header->value_offset, value, value_length);
+        handleData->arena[header->value_offset + value_length] = '\0';
+        handleData->arena_size += name_length + 1 + value_length + 1;
+        if (previous_arena != NULL)
+        {
+            free(previous_arena);
+        }
+
+        /*the slot is looked up again since growing the headers rebuilt the index*/
+        *find_index_slot(handleData, name, name_length, hash) = handleData->header_count + 1;
+        handleData->header_count++;
+        handleData->serialized_size += name_length + /*COLON_AND_SPACE_LENGTH*/ 2 + value_length + /*CRLF_LENGTH*/ 2;
+
+        result = HTTP_HEADERS_OK;
+    }
+
+    return result;
+}
+
+static HTTP_HEADERS_RESULT set_header_value(HTTP_HEADERS_HANDLE_DATA* handleData, HTTP_HEADER* header, const char* value, size_t value_length, bool replace)
+{
+    HTTP_HEADERS_RESULT result;
+    size_t new_value_length = replace ? value_length : header->value_length + /*COMMA_AND_SPACE_LENGTH*/ 2 + value_length;
+
+    if (replace && (value_length <= header->value_length))
+    {
+        /*the new value fits where the old one was*/
+        (void)memmove(handleData->arena + header->value_offset, value, value_length + 1);
+        handleData->released_size += header->value_length - value_length;
+        handleData->serialized_size -= header->value_length - value_length;
+        header->value_length = value_length;
+        result = HTTP_HEADERS_OK;
+    }
+    else
+    {
+        char* previous_arena;
+
+        if ((new_value_length < value_length) ||
+            (new_value_length == SIZE_MAX) ||
+            (reserve_arena(handleData, new_value_length + 1, &previous_arena) != 0))
+        {
+            /*Codes_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
+            result = HTTP_HEADERS_ALLOC_FAILED;
+            LogError("failed to grow the header arena, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
+        }
+        else
+        {
+            char* runNewValue = handleData->arena + handleData->arena_size;
+
+            if (!replace)
+            {
+                /*Codes_SRS_HTTP_HEADERS_99_017:[ If the name already exists in the collection of headers, the function shall concatenate the new value after the existing value, separated by a comma and a space as in: old-value+", "+new-value.]*/
+                (void)memcpy(runNewValue, handleData->arena + header->value_offset, header->value_length);
+                runNewValue += header->value_length;
+                (*runNewValue++) = ',';
+                (*runNewValue++) = ' ';
+            }
+            (void)memcpy(runNewValue, value, value_length);
+            runNewValue[value_length] = '\0';
+
+            handleData->released_size += header->value_length + 1;
+            handleData->serialized_size += new_value_length - header->value_length;
+            header->value_offset = handleData->arena_size;
+            header->value_length = new_value_length;
+            handleData->arena_size += new_value_length + 1;
+            if (previous_arena != NULL)
+            {
+                free(previous_arena);
+            }
+
+            result = HTTP_HEADERS_OK;
+        }
+    }
+
+    return result;
+}
+
+/*Codes_SRS_HTTP_HEADERS_99_036:[ If name contains the characters outside character codes 33 to 126 then the return value shall be HTTP_HEADERS_INVALID_ARG]*/
+/*Codes_SRS_HTTP_HEADERS_99_031:[ If name contains the character ":" then the return value shall be HTTP_HEADERS_INVALID_ARG.]*/
+static bool is_valid_header_name(const char* name, size_t name_length)
+{
+    size_t i;
+
+    for (i = 0; i < name_length; i++)
+    {
+        if ((name[i] < 33) || (126 < name[i]) || (name[i] == ':'))
+        {
+            break;
+        }
+    }
+
+    return (i == name_length);
+}
+
+static HTTP_HEADERS_RESULT store_header(HTTP_HEADERS_HANDLE_DATA* handleData, const char* name, size_t name_length, const char* value, size_t value_length, bool replace)
+{
+    HTTP_HEADERS_RESULT result;
+    /*Codes_SRS_HTTP_HEADERS_99_039: [Header names shall be compared case-insensitively.]*/
+    /*Codes_SRS_HTTP_HEADERS_99_040: [The headers shall be indexed by a hash of their case-folded names.]*/
+    size_t hash = hash_header_name(name, name_length);
+    HTTP_HEADER* existingHeader = find_header(handleData, name, name_length, hash);
+
+    /*Codes_SRS_HTTP_HEADERS_99_016:[ The function shall store the name:value pair in such a way that when later retrieved by a call to GetHeader it will return a string that shall strcmp equal to the name+": "+value.]*/
+    if (existingHeader == NULL)
+    {
+        result = add_header(handleData, name, name_length, hash, value, value_length);
+    }
+    else
+    {
+        result = set_header_value(handleData, existingHeader, value, value_length, replace);
+    }
+
+    return result;
+}
+
+/*Codes_SRS_HTTP_HEADERS_99_049: [The lines appended by HTTPHeaders_AppendHeaderLines shall be parsed and added as if by HTTPHeaders_AddHeaderNameValuePair, in order, the first time the headers are read or changed.]*/
+static HTTP_HEADERS_RESULT parse_header_lines(HTTP_HEADERS_HANDLE_DATA* handleData)
+{
+    HTTP_HEADERS_RESULT result = HTTP_HEADERS_OK;
+
+    while ((result == HTTP_HEADERS_OK) && (handleData->raw_parsed < handleData->raw_size))
+    {
+        const char* line = handleData->raw + handleData->raw_parsed;
+        /*every appended block ends with a '\n'*/
+        const char* end = (const char*)memchr(line, '\n', handleData->raw_size - handleData->raw_parsed);
+        size_t line_length = (size_t)(end - line);
+        size_t content_length = ((line_length > 0) && (line[line_length - 1] == '\r')) ? line_length - 1 : line_length;
+        const char* colon = (const char*)memchr(line, ':', content_length);
+
+        if (colon == NULL)
+        {
+            /*Codes_SRS_HTTP_HEADERS_99_050: [Lines without a ':' or with an invalid header name shall be ignored.]*/
+            /*a status line or the empty line that ends the headers*/
+        }
+        else if (!is_valid_header_name(line, (size_t)(colon - line)))
+        {
+            /*Codes_SRS_HTTP_HEADERS_99_050: [Lines without a ':' or with an invalid header name shall be ignored.]*/
+            LogInfo("ignoring a header line with an invalid name");
+        }
+        else
+        {
+            const char* value = colon + 1;
+
+            /*Codes_SRS_HTTP_HEADERS_02_002: [The LWS from the beginning of the value shall not be stored.] */
+            while ((value < line + content_length) && ((*value == ' ') || (*value == '\t')))
+            {
+                value++;
+            }
+
+            result = store_header(handleData, line, (size_t)(colon - line), value, (size_t)(line + content_length - value), false);
+        }
+
+        if (result == HTTP_HEADERS_OK)
+        {
+            handleData->raw_parsed += line_length + 1;
+        }
+    }
+
+    if (result == HTTP_HEADERS_OK)
+    {
+        /*the buffer is kept for the next lines, a handle is often reused for the headers of one response after the other*/
+        handleData->raw_size = 0;
+        handleData->raw_parsed = 0;
+    }
+    else
+    {
+        /*Codes_SRS_HTTP_HEADERS_99_051: [If the appended lines cannot be parsed for lack of memory, the API that reads or changes the headers shall fail.]*/
+        LogError("unable to parse the appended header lines, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
+    }
+
+    return result;
+}
+
 /*Codes_SRS_HTTP_HEADERS_99_012:[ Calling this API shall record a header from name and value parameters.]*/
 static HTTP_HEADERS_RESULT headers_ReplaceHeaderNameValuePair(HTTP_HEADERS_HANDLE handle, const char* name, const char* value, bool replace)
 {
@@ -80,27 +527,21 @@ static HTTP_HEADERS_RESULT headers_ReplaceHeaderNameValuePair(HTTP_HEADERS_HANDL
     }
     else
     {
-        /*Codes_SRS_HTTP_HEADERS_99_036:[ If name contains the characters outside character codes 33 to 126 then the return value shall be HTTP_HEADERS_INVALID_ARG]*/
-        /*Codes_SRS_HTTP_HEADERS_99_031:[ If name contains the character ":" then the return value shall be HTTP_HEADERS_INVALID_ARG.]*/
-        size_t i;
+        HTTP_HEADERS_HANDLE_DATA* handleData = (HTTP_HEADERS_HANDLE_DATA*)handle;
         size_t nameLen = strlen(name);
-        for (i = 0; i < nameLen; i++)
-        {
-            if ((name[i] < 33) || (126 < name[i]) || (name[i] == ':'))
-            {
-                break;
-            }
-        }
 
-        if (i < nameLen)
+        if (!is_valid_header_name(name, nameLen))
         {
             result = HTTP_HEADERS_INVALID_ARG;
             LogError("(result = %s)", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
         }
+        /*the lines appended before come first*/
+        else if ((result = parse_header_lines(handleData)) != HTTP_HEADERS_OK)
+        {
+            LogError("(result = %s)", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
+        }
         else
         {
-            HTTP_HEADERS_HANDLE_DATA* handleData = (HTTP_HEADERS_HANDLE_DATA*)handle;
-            const char* existingValue = Map_GetValueFromKey(handleData->headers, name);
             /*eat up the whitespaces from value, as per RFC 2616, chapter 4.2 "The field value MAY be preceded by any amount of LWS, though a single SP is preferred."*/
             /*Codes_SRS_HTTP_HEADERS_02_002: [The LWS from the beginning of the value shall not be stored.] */
             while ((value[0] == ' ') || (value[0] == '\t') || (value[0] == '\r') || (value[0] == '\n'))
@@ -108,56 +549,8 @@ static HTTP_HEADERS_RESULT headers_ReplaceHeaderNameValuePair(HTTP_HEADERS_HANDL
                 value++;
             }
 
-            if (!replace && (existingValue != NULL))
-            {
-                size_t existingValueLen = strlen(existingValue);
-                size_t valueLen = strlen(value);
-                char* newValue = (char*)malloc(sizeof(char) * (existingValueLen + /*COMMA_AND_SPACE_LENGTH*/ 2 + valueLen + /*EOL*/ 1));
-                if (newValue == NULL)
-                {
-                    /*Codes_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
-                    result = HTTP_HEADERS_ALLOC_FAILED;
-                    LogError("failed to malloc , result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
-                }
-                else
-                {
-                    char* runNewValue;
-                    /*Codes_SRS_HTTP_HEADERS_99_017:[ If the name already exists in the collection of headers, the function shall concatenate the new value after the existing value, separated by a comma and a space as in: old-value+", "+new-value.]*/
-                    (void)memcpy(newValue, existingValue, existingValueLen);
-                    runNewValue = newValue + existingValueLen;
-                    (*runNewValue++) = ',';
-                    (*runNewValue++) = ' ';
-                    (void)memcpy(runNewValue, value, valueLen + /*EOL*/ 1);
-
-                    /*Codes_SRS_HTTP_HEADERS_99_016:[ The function shall store the name:value pair in such a way that when later retrieved by a call to GetHeader it will return a string that shall strcmp equal to the name+": "+value.]*/
-                    if (Map_AddOrUpdate(handleData->headers, name, newValue) != MAP_OK)
-                    {
-                        /*Codes_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
-                        result = HTTP_HEADERS_ERROR;
-                        LogError("failed to Map_AddOrUpdate, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
-                    }
-                    else
-                    {
-                        /*Codes_SRS_HTTP_HEADERS_99_013:[ The function shall return HTTP_HEADERS_OK when execution is successful.]*/
-                        result = HTTP_HEADERS_OK;
-                    }
-                    free(newValue);
-                }
-            }
-            else
-            {
-                /*Codes_SRS_HTTP_HEADERS_99_016:[ The function shall store the name:value pair in such a way that when later retrieved by a call to GetHeader it will return a string that shall strcmp equal to the name+": "+value.]*/
-                if (Map_AddOrUpdate(handleData->headers, name, value) != MAP_OK)
-                {
-                    /*Codes_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
-                    result = HTTP_HEADERS_ALLOC_FAILED;
-                    LogError("failed to Map_AddOrUpdate, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
-                }
-                else
-                {
-                    result = HTTP_HEADERS_OK;
-                }
-            }
+            /*Codes_SRS_HTTP_HEADERS_99_013:[ The function shall return HTTP_HEADERS_OK when execution is successful.]*/
+            result = store_header(handleData, name, nameLen, value, strlen(value), replace);
         }
     }
 
@@ -175,6 +568,50 @@ HTTP_HEADERS_RESULT HTTPHeaders_ReplaceHeaderNameValuePair(HTTP_HEADERS_HANDLE h
     return headers_ReplaceHeaderNameValuePair(httpHeadersHandle, name, value, true);
 }
 
+HTTP_HEADERS_RESULT HTTPHeaders_AppendHeaderLines(HTTP_HEADERS_HANDLE httpHeadersHandle, const char* lines, size_t length)
+{
+    HTTP_HEADERS_RESULT result;
+
+    if ((httpHeadersHandle == NULL) ||
+        ((lines == NULL) && (length > 0)))
+    {
+        /*Codes_SRS_HTTP_HEADERS_99_046: [If httpHeadersHandle is NULL, or lines is NULL while length is not 0, HTTPHeaders_AppendHeaderLines shall return HTTP_HEADERS_INVALID_ARG.]*/
+        result = HTTP_HEADERS_INVALID_ARG;
+        LogError("invalid arg (NULL), result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
+    }
+    else if (length == 0)
+    {
+        result = HTTP_HEADERS_OK;
+    }
+    else
+    {
+        HTTP_HEADERS_HANDLE_DATA* handleData = (HTTP_HEADERS_HANDLE_DATA*)httpHeadersHandle;
+        /*a block that does not end with a line terminator ends with a whole line anyway*/
+        bool isTerminated = (lines[length - 1] == '\n');
+
+        if ((length == SIZE_MAX) ||
+            (reserve_raw(handleData, isTerminated ? length : length + 1) != 0))
+        {
+            /*Codes_SRS_HTTP_HEADERS_99_048: [If the lines cannot be stored, HTTPHeaders_AppendHeaderLines shall return HTTP_HEADERS_ALLOC_FAILED.]*/
+            result = HTTP_HEADERS_ALLOC_FAILED;
+            LogError("failed to store the header lines, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
+        }
+        else
+        {
+            /*Codes_SRS_HTTP_HEADERS_99_047: [HTTPHeaders_AppendHeaderLines shall copy the lines into a buffer owned by the handle without parsing them, and return HTTP_HEADERS_OK.]*/
+            (void)memcpy(handleData->raw + handleData->raw_size, lines, length);
+            handleData->raw_size += length;
+            if (!isTerminated)
+            {
+                handleData->raw[handleData->raw_size++] = '\n';
+            }
+            result = HTTP_HEADERS_OK;
+        }
+    }
+
+    return result;
+}
+
 
 const char* HTTPHeaders_FindHeaderValue(HTTP_HEADERS_HANDLE httpHeadersHandle, const char* name)
 {
@@ -187,13 +624,21 @@ const char* HTTPHeaders_FindHeaderValue(HTTP_HEADERS_HANDLE httpHeadersHandle, c
     {
         result = NULL;
     }
+    else if (parse_header_lines((HTTP_HEADERS_HANDLE_DATA*)httpHeadersHandle) != HTTP_HEADERS_OK)
+    {
+        /*Codes_SRS_HTTP_HEADERS_99_051: [If the appended lines cannot be parsed for lack of memory, the API that reads or changes the headers shall fail.]*/
+        result = NULL;
+    }
     else
     {
         /*Codes_SRS_HTTP_HEADERS_99_018:[ Calling this API shall retrieve the value for a previously stored name.]*/
         /*Codes_SRS_HTTP_HEADERS_99_020:[ The return value shall be different than NULL when the name matches the name of a previously stored name:value pair.] */
         /*Codes_SRS_HTTP_HEADERS_99_021:[ In this case the return value shall point to a string that shall strcmp equal to the original stored string.]*/
+        /*Codes_SRS_HTTP_HEADERS_99_039: [Header names shall be compared case-insensitively.]*/
         HTTP_HEADERS_HANDLE_DATA* handleData = (HTTP_HEADERS_HANDLE_DATA*)httpHeadersHandle;
-        result = Map_GetValueFromKey(handleData->headers, name);
+        size_t name_length = strlen(name);
+        HTTP_HEADER* header = find_header(handleData, name, name_length, hash_header_name(name, name_length));
+        result = (header == NULL) ? NULL : handleData->arena + header->value_offset;
     }
     return result;
 
@@ -210,23 +655,17 @@ HTTP_HEADERS_RESULT HTTPHeaders_GetHeaderCount(HTTP_HEADERS_HANDLE handle, size_
         result = HTTP_HEADERS_INVALID_ARG;
         LogError("(result = %s)", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
     }
+    else if (parse_header_lines(handle) != HTTP_HEADERS_OK)
+    {
+        /*Codes_SRS_HTTP_HEADERS_99_051: [If the appended lines cannot be parsed for lack of memory, the API that reads or changes the headers shall fail.]*/
+        result = HTTP_HEADERS_ERROR;
+    }
     else
     {
-        HTTP_HEADERS_HANDLE_DATA *handleData = (HTTP_HEADERS_HANDLE_DATA *)handle;
-        const char*const* keys;
-        const char*const* values;
         /*Codes_SRS_HTTP_HEADERS_99_023:[ Calling this API shall provide the number of stored headers.]*/
-        if (Map_GetInternals(handleData->headers, &keys, &values, headerCount) != MAP_OK)
-        {
-            /*Codes_SRS_HTTP_HEADERS_99_037:[ The function shall return HTTP_HEADERS_ERROR when an internal error occurs.]*/
-            result = HTTP_HEADERS_ERROR;
-            LogError("Map_GetInternals failed, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
-        }
-        else
-        {
-            /*Codes_SRS_HTTP_HEADERS_99_026:[ The function shall write in *headersCount the number of currently stored headers and shall return HTTP_HEADERS_OK]*/
-            result = HTTP_HEADERS_OK;
-        }
+        /*Codes_SRS_HTTP_HEADERS_99_026:[ The function shall write in *headersCount the number of currently stored headers and shall return HTTP_HEADERS_OK]*/
+        *headerCount = handle->header_count;
+        result = HTTP_HEADERS_OK;
     }
 
     return result;
@@ -247,52 +686,97 @@ HTTP_HEADERS_RESULT HTTPHeaders_GetHeader(HTTP_HEADERS_HANDLE handle, size_t ind
         result = HTTP_HEADERS_INVALID_ARG;
         LogError("invalid arg (NULL), result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
     }
+    else if (parse_header_lines(handle) != HTTP_HEADERS_OK)
+    {
+        /*Codes_SRS_HTTP_HEADERS_99_051: [If the appended lines cannot be parsed for lack of memory, the API that reads or changes the headers shall fail.]*/
+        result = HTTP_HEADERS_ERROR;
+    }
     /*Codes_SRS_HTTP_HEADERS_99_029:[ The function shall return HTTP_HEADERS_INVALID_ARG if index is not valid (for example, out of range) for the currently stored headers.]*/
+    else if (index >= handle->header_count)
+    {
+        result = HTTP_HEADERS_INVALID_ARG;
+        LogError("index out of bounds, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
+    }
     else
     {
         HTTP_HEADERS_HANDLE_DATA* handleData = (HTTP_HEADERS_HANDLE_DATA*)handle;
-        const char*const* keys;
-        const char*const* values;
-        size_t headerCount;
-        if (Map_GetInternals(handleData->headers, &keys, &values, &headerCount) != MAP_OK)
+        const HTTP_HEADER* header = &handleData->headers[index];
+
+        *destination = (char*)malloc(sizeof(char) * (header->name_length + /*COLON_AND_SPACE_LENGTH*/ 2 + header->value_length + /*EOL*/ 1));
+        if (*destination == NULL)
         {
             /*Codes_SRS_HTTP_HEADERS_99_034:[ The function shall return HTTP_HEADERS_ERROR when an internal error occurs]*/
             result = HTTP_HEADERS_ERROR;
-            LogError("Map_GetInternals failed, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
+            LogError("unable to malloc, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
         }
         else
         {
-            /*Codes_SRS_HTTP_HEADERS_99_029:[ The function shall return HTTP_HEADERS_INVALID_ARG if index is not valid (for example, out of range) for the currently stored headers.]*/
-            if (index >= headerCount)
-            {
-                result = HTTP_HEADERS_INVALID_ARG;
-                LogError("index out of bounds, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
-            }
-            else
+            /*Codes_SRS_HTTP_HEADERS_99_016:[ The function shall store the name:value pair in such a way that when later retrieved by a call to GetHeader it will return a string that shall strcmp equal to the name+": "+value.]*/
+            /*Codes_SRS_HTTP_HEADERS_99_027:[ Calling this API shall produce the string value+": "+pair) for the index header in the *destination parameter.]*/
+            char* runDestination = (*destination);
+            (void)memcpy(runDestination, handleData->arena + header->name_offset, header->name_length);
+            runDestination += header->name_length;
+            (*runDestination++) = ':';
+            (*runDestination++) = ' ';
+            (void)memcpy(runDestination, handleData->arena + header->value_offset, header->value_length + /*EOL*/ 1);
+            /*Codes_SRS_HTTP_HEADERS_99_035:[ The function shall return HTTP_HEADERS_OK when the function executed without error.]*/
+            result = HTTP_HEADERS_OK;
+        }
+    }
+
+    return result;
+}
+
+HTTP_HEADERS_RESULT HTTPHeaders_Serialize(HTTP_HEADERS_HANDLE handle, char* buffer, size_t bufferSize, size_t* serializedSize)
+{
+    HTTP_HEADERS_RESULT result;
+
+    /*Codes_SRS_HTTP_HEADERS_99_041: [If handle or serializedSize is NULL, HTTPHeaders_Serialize shall return HTTP_HEADERS_INVALID_ARG.]*/
+    /*Codes_SRS_HTTP_HEADERS_99_042: [If buffer is NULL and bufferSize is not 0, HTTPHeaders_Serialize shall return HTTP_HEADERS_INVALID_ARG.]*/
+    if ((handle == NULL) ||
+        (serializedSize == NULL) ||
+        ((buffer == NULL) && (bufferSize != 0)))
+    {
+        result = HTTP_HEADERS_INVALID_ARG;
+        LogError("invalid arg (handle=%p, buffer=%p, bufferSize=%lu, serializedSize=%p), result= %s", handle, buffer, (unsigned long)bufferSize, serializedSize, ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
+    }
+    else if (parse_header_lines(handle) != HTTP_HEADERS_OK)
+    {
+        /*Codes_SRS_HTTP_HEADERS_99_051: [If the appended lines cannot be parsed for lack of memory, the API that reads or changes the headers shall fail.]*/
+        result = HTTP_HEADERS_ERROR;
+    }
+    else
+    {
+        /*Codes_SRS_HTTP_HEADERS_99_043: [HTTPHeaders_Serialize shall write in *serializedSize the number of characters of name+": "+value+"\r\n" for all the headers, not counting the null terminator.]*/
+        *serializedSize = handle->serialized_size;
+
+        if (bufferSize <= handle->serialized_size)
+        {
+            /*Codes_SRS_HTTP_HEADERS_99_044: [If bufferSize is not greater than *serializedSize, HTTPHeaders_Serialize shall return HTTP_HEADERS_INSUFFICIENT_BUFFER without writing to buffer.]*/
+            result = HTTP_HEADERS_INSUFFICIENT_BUFFER;
+        }
+        else
+        {
+            /*Codes_SRS_HTTP_HEADERS_99_045: [Otherwise HTTPHeaders_Serialize shall write name+": "+value+"\r\n" for every header, in the order in which they were added, followed by a null terminator, into buffer and return HTTP_HEADERS_OK.]*/
+            char* runBuffer = buffer;
+            size_t i;
+
+            for (i = 0; i < handle->header_count; i++)
             {
-                size_t keyLen = strlen(keys[index]);
-                size_t valueLen = strlen(values[index]);
-                *destination = (char*)malloc(sizeof(char) * (keyLen + /*COLON_AND_SPACE_LENGTH*/ 2 + valueLen + /*EOL*/ 1));
-                if (*destination == NULL)
-                {
-                    /*Codes_SRS_HTTP_HEADERS_99_034:[ The function shall return HTTP_HEADERS_ERROR when an internal error occurs]*/
-                    result = HTTP_HEADERS_ERROR;
-                    LogError("unable to malloc, result= %s", ENUM_TO_STRING(HTTP_HEADERS_RESULT, result));
-                }
-                else
-                {
-                    /*Codes_SRS_HTTP_HEADERS_99_016:[ The function shall store the name:value pair in such a way that when later retrieved by a call to GetHeader it will return a string that shall strcmp equal to the name+": "+value.]*/
-                    /*Codes_SRS_HTTP_HEADERS_99_027:[ Calling this API shall produce the string value+": "+pair) for the index header in the *destination parameter.]*/
-                    char* runDestination = (*destination);
-                    (void)memcpy(runDestination, keys[index], keyLen);
-                    runDestination += keyLen;
-                    (*runDestination++) = ':';
-                    (*runDestination++) = ' ';
-                    (void)memcpy(runDestination, values[index], valueLen + /*EOL*/ 1);
-                    /*Codes_SRS_HTTP_HEADERS_99_035:[ The function shall return HTTP_HEADERS_OK when the function executed without error.]*/
-                    result = HTTP_HEADERS_OK;
-                }
+                const HTTP_HEADER* header = &handle->headers[i];
+
+                (void)memcpy(runBuffer, handle->arena + header->name_offset, header->name_length);
+                runBuffer += header->name_length;
+                (*runBuffer++) = ':';
+                (*runBuffer++) = ' ';
+                (void)memcpy(runBuffer, handle->arena + header->value_offset, header->value_length);
+                runBuffer += header->value_length;
+                (*runBuffer++) = '\r';
+                (*runBuffer++) = '\n';
             }
+            *runBuffer = '\0';
+
+            result = HTTP_HEADERS_OK;
         }
     }
 
@@ -307,6 +791,11 @@ HTTP_HEADERS_HANDLE HTTPHeaders_Clone(HTTP_HEADERS_HANDLE handle)
     {
         result = NULL;
     }
+    else if (parse_header_lines(handle) != HTTP_HEADERS_OK)
+    {
+        /*Codes_SRS_HTTP_HEADERS_02_005: [If cloning fails for any reason, then HTTPHeaders_Clone shall return NULL.] */
+        result = NULL;
+    }
     else
     {
         /*Codes_SRS_HTTP_HEADERS_02_004: [Otherwise HTTPHeaders_Clone shall clone the content of handle to a new handle.] */
@@ -314,20 +803,43 @@ HTTP_HEADERS_HANDLE HTTPHeaders_Clone(HTTP_HEADERS_HANDLE handle)
         if (result == NULL)
         {
             /*Codes_SRS_HTTP_HEADERS_02_005: [If cloning fails for any reason, then HTTPHeaders_Clone shall return NULL.] */
+            LogError("malloc failed");
         }
         else
         {
             HTTP_HEADERS_HANDLE_DATA* handleData = handle;
-            result->headers = Map_Clone(handleData->headers);
-            if (result->headers == NULL)
+            size_t headers_size = handleData->header_capacity * (sizeof(HTTP_HEADER) + 2 * sizeof(size_t));
+
+            *result = *handleData;
+            result->arena = NULL;
+            result->headers = NULL;
+            /*every appended line was parsed above*/
+            result->raw = NULL;
+            result->raw_size = 0;
+            result->raw_capacity = 0;
+            result->raw_parsed = 0;
+
+            if (((handleData->arena_capacity > 0) && ((result->arena = (char*)malloc(handleData->arena_capacity)) == NULL)) ||
+                ((headers_size > 0) && ((result->headers = (HTTP_HEADER*)malloc(headers_size)) == NULL)))
             {
                 /*Codes_SRS_HTTP_HEADERS_02_005: [If cloning fails for any reason, then HTTPHeaders_Clone shall return NULL.] */
+                LogError("unable to copy the headers");
+                free(result->arena);
                 free(result);
                 result = NULL;
             }
             else
             {
-                /*all is fine*/
+                /*the index is copied with the headers since header indexes and hashes do not depend on where the storage is*/
+                if (handleData->arena_size > 0)
+                {
+                    (void)memcpy(result->arena, handleData->arena, handleData->arena_size);
+                }
+                if (headers_size > 0)
+                {
+                    (void)memcpy(result->headers, handleData->headers, headers_size);
+                    result->index = (size_t*)(result->headers + result->header_capacity);
+                }
             }
         }
     }
@@ -5,16 +5,40 @@
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/map.h"
 #include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/refcount.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/buffer_.h"
 
 DEFINE_ENUM_STRINGS(MAP_RESULT, MAP_RESULT_VALUES);
 
+/*maps with up to this many pairs grow one pair at a time and are searched linearly, larger ones grow geometrically and get a hash index*/
+#ifndef MAP_SMALL_CAPACITY
+#define MAP_SMALL_CAPACITY 8
+#endif
+
+/*a slot in the hash index holds the position of the key in keys + 1, 0 means the slot is empty*/
+#define MAP_INDEX_EMPTY_SLOT 0
+
+/*
+* Map_Clone does not copy the pairs: the clone and the map share keys, values and index, and sharers counts the maps
+* using them (it is NULL while a map is the only one). A map copies the pairs before it changes them for the first time,
+* and the last map using them frees them.
+*
+* Map_CreateFromArrays puts keys, values and all their strings in one block, arena. The strings in it cannot be freed
+* or reallocated one by one, so a map copies the pairs out of the arena before it changes them, as it does for shared pairs.
+*/
 typedef struct MAP_HANDLE_DATA_TAG
 {
+    /*keys and values stay in insertion order, the index only points into them*/
     char** keys;
     char** values;
     size_t count;
+    size_t capacity;
+    size_t* index;
+    size_t indexSize;
+    COUNT_TYPE* sharers;
+    char* arena;
     MAP_FILTER_CALLBACK mapFilterCallback;
 }MAP_HANDLE_DATA;
 
@@ -31,11 +55,154 @@ MAP_HANDLE Map_Create(MAP_FILTER_CALLBACK mapFilterFunc)
         result->keys = NULL;
         result->values = NULL;
         result->count = 0;
+        result->capacity = 0;
+        result->index = NULL;
+        result->indexSize = 0;
+        result->sharers = NULL;
+        result->arena = NULL;
         result->mapFilterCallback = mapFilterFunc;
     }
     return (MAP_HANDLE)result;
 }
 
+static size_t Map_HashKey(const char* key)
+{
+    /*FNV-1a*/
+    size_t hash = (size_t)2166136261u;
+    while (*key != '\0')
+    {
+        hash ^= (unsigned char)*key;
+        hash *= (size_t)16777619u;
+        key++;
+    }
+    return hash;
+}
+
+static void Map_IndexInsert(size_t* index, size_t indexSize, const char* key, size_t position)
+{
+    size_t slot = Map_HashKey(key) & (indexSize - 1);
+    while (index[slot] != MAP_INDEX_EMPTY_SLOT)
+    {
+        slot = (slot + 1) & (indexSize - 1);
+    }
+    index[slot] = position + 1;
+}
+
+/*(re)builds the hash index so that it stays at most half full, a failure only means lookups stay linear*/
+static void Map_RebuildIndex(MAP_HANDLE_DATA* handleData)
+{
+    if (handleData->count <= MAP_SMALL_CAPACITY)
+    {
+        if (handleData->index != NULL)
+        {
+            free(handleData->index);
+            handleData->index = NULL;
+            handleData->indexSize = 0;
+        }
+    }
+    else
+    {
+        size_t newIndexSize = (handleData->indexSize == 0) ? (MAP_SMALL_CAPACITY * 4) : handleData->indexSize;
+        size_t* newIndex;
+        while (newIndexSize < handleData->count * 2)
+        {
+            newIndexSize *= 2;
+        }
+
+        if (newIndexSize == handleData->indexSize)
+        {
+            newIndex = handleData->index;
+        }
+        else
+        {
+            newIndex = (size_t*)malloc(newIndexSize * sizeof(size_t));
+            if (newIndex == NULL)
+            {
+                LogError("unable to grow the map index, lookups fall back to a linear search");
+                free(handleData->index);
+                handleData->index = NULL;
+                handleData->indexSize = 0;
+            }
+            else
+            {
+                free(handleData->index);
+            }
+        }
+
+        if (newIndex != NULL)
+        {
+            size_t i;
+            (void)memset(newIndex, 0, newIndexSize * sizeof(size_t));
+            for (i = 0; i < handleData->count; i++)
+            {
+                Map_IndexInsert(newIndex, newIndexSize, handleData->keys[i], i);
+            }
+            handleData->index = newIndex;
+            handleData->indexSize = newIndexSize;
+        }
+    }
+}
+
+/*called after the pair at position count - 1 has been added*/
+static void Map_IndexAdd(MAP_HANDLE_DATA* handleData)
+{
+    if ((handleData->index != NULL) &&
+        (handleData->count * 2 <= handleData->indexSize))
+    {
+        Map_IndexInsert(handleData->index, handleData->indexSize, handleData->keys[handleData->count - 1], handleData->count - 1);
+    }
+    else if (handleData->count > MAP_SMALL_CAPACITY)
+    {
+        Map_RebuildIndex(handleData);
+    }
+    else
+    {
+        /*small maps are searched linearly*/
+    }
+}
+
+static void Map_FreePairs(char** keys, char** values, size_t count, size_t* index, char* arena)
+{
+    if (arena != NULL)
+    {
+        /*keys, values and the strings are all in the arena*/
+        free(arena);
+    }
+    else
+    {
+        size_t i;
+        for (i = 0; i < count; i++)
+        {
+            free(keys[i]);
+            free(values[i]);
+        }
+        free(keys);
+        free(values);
+    }
+    if (index != NULL)
+    {
+        free(index);
+    }
+}
+
+/*drops the reference of handleData to its pairs, they are freed when no other map uses them*/
+static void Map_ReleasePairs(MAP_HANDLE_DATA* handleData)
+{
+    if (handleData->sharers == NULL)
+    {
+        Map_FreePairs(handleData->keys, handleData->values, handleData->count, handleData->index, handleData->arena);
+    }
+    else if (DEC_REF_VAR(*handleData->sharers) == DEC_RETURN_ZERO)
+    {
+        Map_FreePairs(handleData->keys, handleData->values, handleData->count, handleData->index, handleData->arena);
+        free((void*)handleData->sharers);
+    }
+    else
+    {
+        /*other maps still use the pairs*/
+    }
+}
+
 void Map_Destroy(MAP_HANDLE handle)
 {
     /*Codes_SRS_MAP_02_005: [If parameter handle is NULL then Map_Destroy shall take no action.] */
@@ -43,15 +210,8 @@ void Map_Destroy(MAP_HANDLE handle)
     {
         /*Codes_SRS_MAP_02_004: [Map_Destroy shall release all resources associated with the map.] */
         MAP_HANDLE_DATA* handleData = (MAP_HANDLE_DATA*)handle;
-        size_t i;
-
-        for (i = 0; i < handleData->count; i++)
-        {
-            free(handleData->keys[i]);
-            free(handleData->values[i]);
-        }
-        free(handleData->keys);
-        free(handleData->values);
+        /*Codes_SRS_MAP_01_010: [Map_Destroy shall free the pairs only when no other map shares them.] */
+        Map_ReleasePairs(handleData);
         free(handleData);
     }
 }
@@ -117,90 +277,159 @@ MAP_HANDLE Map_Clone(MAP_HANDLE handle)
         }
         else
         {
+            result->index = NULL;
+            result->indexSize = 0;
+            result->sharers = NULL;
+            result->arena = NULL;
             if (handleData->count == 0)
             {
                 result->count = 0;
+                result->capacity = 0;
                 result->keys = NULL;
                 result->values = NULL;
                 result->mapFilterCallback = NULL;
             }
-            else
+            else if (handleData->sharers == NULL)
             {
-                result->mapFilterCallback = handleData->mapFilterCallback;
-                result->count = handleData->count;
-                if( (result->keys = Map_CloneVector((const char* const*)handleData->keys, handleData->count))==NULL)
-                {
-                    /*Codes_SRS_MAP_02_047: [If during cloning, any operation fails, then Map_Clone shall return NULL.] */
-                    LogError("unable to clone keys");
-                    free(result);
-                    result = NULL;
-                }
-                else if ((result->values = Map_CloneVector((const char* const*)handleData->values, handleData->count)) == NULL)
+                /*the map is the only one using its pairs so far*/
+                if ((handleData->sharers = (COUNT_TYPE*)malloc(sizeof(COUNT_TYPE))) == NULL)
                 {
-                    size_t i;
                     /*Codes_SRS_MAP_02_047: [If during cloning, any operation fails, then Map_Clone shall return NULL.] */
-                    LogError("unable to clone values");
-                    for (i = 0; i < result->count; i++)
-                    {
-                        free(result->keys[i]);
-                    }
-                    free(result->keys);
+                    LogError("unable to malloc");
                     free(result);
                     result = NULL;
                 }
                 else
                 {
-                    /*all fine, return it*/
+                    INIT_REF_VAR(*handleData->sharers);
                 }
             }
+            else
+            {
+                /*the pairs are already shared*/
+            }
+
+            if ((result != NULL) && (handleData->count > 0))
+            {
+                /*Codes_SRS_MAP_01_008: [Map_Clone shall not copy the pairs: the clone shall share them with the map until either of them changes them, which shall then copy them first.] */
+                (void)INC_REF_VAR(*handleData->sharers);
+                result->mapFilterCallback = handleData->mapFilterCallback;
+                result->keys = handleData->keys;
+                result->values = handleData->values;
+                result->count = handleData->count;
+                result->capacity = handleData->capacity;
+                result->index = handleData->index;
+                result->indexSize = handleData->indexSize;
+                result->sharers = handleData->sharers;
+                result->arena = handleData->arena;
+            }
         }
     }
     return (MAP_HANDLE)result;
 }
 
-static int Map_IncreaseStorageKeysValues(MAP_HANDLE_DATA* handleData)
+/*gives handleData its own copy of the pairs it shares with other maps or has in an arena, it has to be called before the pairs are changed*/
+static int Map_OwnPairs(MAP_HANDLE_DATA* handleData)
 {
     int result;
-    char** newKeys = (char**)realloc(handleData->keys, (handleData->count + 1) * sizeof(char*));
-    if (newKeys == NULL)
+    if ((handleData->sharers == NULL) &&
+        (handleData->arena == NULL))
     {
-        LogError("realloc error");
-        result = __FAILURE__;
+        result = 0;
     }
     else
     {
-        char** newValues;
-        handleData->keys = newKeys;
-        handleData->keys[handleData->count] = NULL;
-        newValues = (char**)realloc(handleData->values, (handleData->count + 1) * sizeof(char*));
-        if (newValues == NULL)
+        char** keys;
+        char** values;
+        if ((keys = Map_CloneVector((const char* const*)handleData->keys, handleData->count)) == NULL)
         {
-            LogError("realloc error");
-            if (handleData->count == 0) /*avoiding an implementation defined behavior */
+            LogError("unable to copy the shared keys");
+            result = __FAILURE__;
+        }
+        else if ((values = Map_CloneVector((const char* const*)handleData->values, handleData->count)) == NULL)
+        {
+            size_t i;
+            LogError("unable to copy the shared values");
+            for (i = 0; i < handleData->count; i++)
             {
-                free(handleData->keys);
-                handleData->keys = NULL;
+                free(keys[i]);
             }
-            else
+            free(keys);
+            result = __FAILURE__;
+        }
+        else
+        {
+            Map_ReleasePairs(handleData);
+            handleData->keys = keys;
+            handleData->values = values;
+            handleData->capacity = handleData->count;
+            handleData->index = NULL;
+            handleData->indexSize = 0;
+            handleData->sharers = NULL;
+            handleData->arena = NULL;
+            Map_RebuildIndex(handleData);
+            result = 0;
+        }
+    }
+    return result;
+}
+
+static int Map_IncreaseStorageKeysValues(MAP_HANDLE_DATA* handleData)
+{
+    int result;
+    if (handleData->count < handleData->capacity)
+    {
+        /*there is room left from a previous geometric growth*/
+        handleData->keys[handleData->count] = NULL;
+        handleData->values[handleData->count] = NULL;
+        handleData->count++;
+        result = 0;
+    }
+    else
+    {
+        size_t newCapacity = (handleData->capacity < MAP_SMALL_CAPACITY) ? (handleData->capacity + 1) : (handleData->capacity * 2);
+        char** newKeys = (char**)realloc(handleData->keys, newCapacity * sizeof(char*));
+        if (newKeys == NULL)
+        {
+            LogError("realloc error");
+            result = __FAILURE__;
+        }
+        else
+        {
+            char** newValues;
+            handleData->keys = newKeys;
+            handleData->keys[handleData->count] = NULL;
+            newValues = (char**)realloc(handleData->values, newCapacity * sizeof(char*));
+            if (newValues == NULL)
             {
-                char** undoneKeys = (char**)realloc(handleData->keys, (handleData->count) * sizeof(char*));
-                if (undoneKeys == NULL)
+                LogError("realloc error");
+                if (handleData->count == 0) /*avoiding an implementation defined behavior */
                 {
-                    LogError("CATASTROPHIC error, unable to undo through realloc to a smaller size");
+                    free(handleData->keys);
+                    handleData->keys = NULL;
                 }
                 else
                 {
-                    handleData->keys = undoneKeys;
+                    char** undoneKeys = (char**)realloc(handleData->keys, (handleData->capacity) * sizeof(char*));
+                    if (undoneKeys == NULL)
+                    {
+                        LogError("CATASTROPHIC error, unable to undo through realloc to a smaller size");
+                    }
+                    else
+                    {
+                        handleData->keys = undoneKeys;
+                    }
                 }
+                result = __FAILURE__;
+            }
+            else
+            {
+                handleData->values = newValues;
+                handleData->values[handleData->count] = NULL;
+                handleData->capacity = newCapacity;
+                handleData->count++;
+                result = 0;
             }
-            result = __FAILURE__;
-        }
-        else
-        {
-            handleData->values = newValues;
-            handleData->values[handleData->count] = NULL;
-            handleData->count++;
-            result = 0;
         }
     }
     return result;
@@ -215,8 +444,14 @@ static void Map_DecreaseStorageKeysValues(MAP_HANDLE_DATA* handleData)
         free(handleData->values);
         handleData->values = NULL;
         handleData->count = 0;
+        handleData->capacity = 0;
         handleData->mapFilterCallback = NULL;
     }
+    else if (handleData->capacity > MAP_SMALL_CAPACITY)
+    {
+        /*large maps keep their capacity, the next insert will reuse it*/
+        handleData->count--;
+    }
     else
     {
         /*certainly > 1...*/
@@ -242,6 +477,7 @@ static void Map_DecreaseStorageKeysValues(MAP_HANDLE_DATA* handleData)
         }
 
         handleData->count--;
+        handleData->capacity = handleData->count;
     }
 }
 
@@ -252,6 +488,21 @@ static char** findKey(MAP_HANDLE_DATA* handleData, const char* key)
     {
         result = NULL;
     }
+    else if (handleData->index != NULL)
+    {
+        size_t slot = Map_HashKey(key) & (handleData->indexSize - 1);
+        result = NULL;
+        while (handleData->index[slot] != MAP_INDEX_EMPTY_SLOT)
+        {
+            char** candidate = handleData->keys + (handleData->index[slot] - 1);
+            if (strcmp(*candidate, key) == 0)
+            {
+                result = candidate;
+                break;
+            }
+            slot = (slot + 1) & (handleData->indexSize - 1);
+        }
+    }
     else
     {
         size_t i;
@@ -291,10 +542,132 @@ static char** findValue(MAP_HANDLE_DATA* handleData, const char* value)
     return result;
 }
 
+MAP_HANDLE Map_CreateFromArrays(const char* const* keys, const char* const* values, size_t count)
+{
+    MAP_HANDLE_DATA* result;
+    if ((count > 0) &&
+        ((keys == NULL) || (values == NULL)))
+    {
+        /*Codes_SRS_MAP_01_011: [If count is not 0 and keys or values is NULL, then Map_CreateFromArrays shall return NULL.] */
+        LogError("invalid arg to Map_CreateFromArrays (NULL keys or values for %lu pairs)", (unsigned long)count);
+        result = NULL;
+    }
+    else if (count == 0)
+    {
+        /*Codes_SRS_MAP_01_012: [If count is 0, Map_CreateFromArrays shall create a new, empty map as Map_Create does without a filter.] */
+        result = (MAP_HANDLE_DATA*)Map_Create(NULL);
+    }
+    else
+    {
+        /*the arena holds the key pointers, the value pointers, then the strings*/
+        size_t arenaSize = 2 * count * sizeof(char*);
+        size_t i;
+
+        if (count > ((size_t)-1) / (2 * sizeof(char*)))
+        {
+            i = 0;
+        }
+        else
+        {
+            for (i = 0; i < count; i++)
+            {
+                size_t keyLength;
+                size_t valueLength;
+                if ((keys[i] == NULL) || (values[i] == NULL))
+                {
+                    break;
+                }
+                keyLength = strlen(keys[i]) + 1;
+                valueLength = strlen(values[i]) + 1;
+                if ((keyLength > ((size_t)-1) - arenaSize) ||
+                    (valueLength > ((size_t)-1) - arenaSize - keyLength))
+                {
+                    break;
+                }
+                arenaSize += keyLength + valueLength;
+            }
+        }
+
+        if (i < count)
+        {
+            /*Codes_SRS_MAP_01_013: [If any of the keys or values is NULL, then Map_CreateFromArrays shall return NULL.] */
+            LogError("invalid arg to Map_CreateFromArrays (NULL or too long pair at %lu)", (unsigned long)i);
+            result = NULL;
+        }
+        else if ((result = (MAP_HANDLE_DATA*)malloc(sizeof(MAP_HANDLE_DATA))) == NULL)
+        {
+            /*Codes_SRS_MAP_01_015: [If any allocation fails, then Map_CreateFromArrays shall return NULL.] */
+            LogError("unable to malloc");
+        }
+        /*Codes_SRS_MAP_01_014: [Map_CreateFromArrays shall copy all the keys and values into one allocation and shall build the hash index, when the map needs one, once.] */
+        else if ((result->arena = (char*)malloc(arenaSize)) == NULL)
+        {
+            /*Codes_SRS_MAP_01_015: [If any allocation fails, then Map_CreateFromArrays shall return NULL.] */
+            LogError("unable to malloc the arena of %lu bytes", (unsigned long)arenaSize);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            char* strings = result->arena + 2 * count * sizeof(char*);
+            result->keys = (char**)result->arena;
+            result->values = result->keys + count;
+            result->count = count;
+            result->capacity = count;
+            result->index = NULL;
+            result->indexSize = 0;
+            result->sharers = NULL;
+            result->mapFilterCallback = NULL;
+
+            for (i = 0; i < count; i++)
+            {
+                size_t keyLength = strlen(keys[i]) + 1;
+                size_t valueLength = strlen(values[i]) + 1;
+                (void)memcpy(strings, keys[i], keyLength);
+                result->keys[i] = strings;
+                strings += keyLength;
+                (void)memcpy(strings, values[i], valueLength);
+                result->values[i] = strings;
+                strings += valueLength;
+            }
+
+            /*a failure to allocate the index only means lookups stay linear*/
+            Map_RebuildIndex(result);
+
+            /*a key found at another position than its own is a duplicate of an earlier key*/
+            for (i = 0; i < count; i++)
+            {
+                if (findKey(result, result->keys[i]) != result->keys + i)
+                {
+                    break;
+                }
+            }
+
+            if (i < count)
+            {
+                /*Codes_SRS_MAP_01_016: [If a key appears more than once, then Map_CreateFromArrays shall return NULL.] */
+                LogError("duplicate key %s passed to Map_CreateFromArrays", result->keys[i]);
+                Map_Destroy((MAP_HANDLE)result);
+                result = NULL;
+            }
+            else
+            {
+                /*Codes_SRS_MAP_01_017: [Otherwise, Map_CreateFromArrays shall return a non-NULL handle to a map holding the pairs in the order of the arrays.] */
+            }
+        }
+    }
+    return (MAP_HANDLE)result;
+}
+
 static int insertNewKeyValue(MAP_HANDLE_DATA* handleData, const char* key, const char* value)
 {
     int result;
-    if (Map_IncreaseStorageKeysValues(handleData) != 0) /*this increases handleData->count*/
+    /*Codes_SRS_MAP_01_009: [Before Map_Add, Map_AddOrUpdate or Map_Delete change the pairs of a map that shares them with other maps, they shall copy the pairs; if the copy fails they shall return MAP_ERROR.] */
+    if (Map_OwnPairs(handleData) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else if (Map_IncreaseStorageKeysValues(handleData) != 0) /*this increases handleData->count*/
     {
         result = __FAILURE__;
     }
@@ -317,6 +690,7 @@ static int insertNewKeyValue(MAP_HANDLE_DATA* handleData, const char* key, const
             }
             else
             {
+                Map_IndexAdd(handleData);
                 result = 0;
             }
         }
@@ -419,9 +793,15 @@ MAP_RESULT Map_AddOrUpdate(MAP_HANDLE handle, const char* key, const char* value
                 /*Codes_SRS_MAP_02_016: [If the key already exists, then Map_AddOrUpdate shall overwrite the value of the existing key with parameter value.]*/
                 size_t index = whereIsIt - handleData->keys;
                 size_t valueLength = strlen(value);
+                char* newValue;
+                /*Codes_SRS_MAP_01_009: [Before Map_Add, Map_AddOrUpdate or Map_Delete change the pairs of a map that shares them with other maps, they shall copy the pairs; if the copy fails they shall return MAP_ERROR.] */
+                if (Map_OwnPairs(handleData) != 0)
+                {
+                    result = MAP_ERROR;
+                    LOG_MAP_ERROR;
+                }
                 /*try to realloc value of this key*/
-                char* newValue = (char*)realloc(handleData->values[index],valueLength  + 1);
-                if (newValue == NULL)
+                else if ((newValue = (char*)realloc(handleData->values[index], valueLength + 1)) == NULL)
                 {
                     result = MAP_ERROR;
                     LOG_MAP_ERROR;
@@ -465,12 +845,26 @@ MAP_RESULT Map_Delete(MAP_HANDLE handle, const char* key)
         {
             /*Codes_SRS_MAP_02_023: [Otherwise, Map_Delete shall remove the key and its associated value from the map and return MAP_OK.]*/
             size_t index = whereIsIt - handleData->keys;
-            free(handleData->keys[index]);
-            free(handleData->values[index]);
-            memmove(handleData->keys + index, handleData->keys + index + 1, (handleData->count - index - 1)*sizeof(char*)); /*if order doesn't matter... then this can be optimized*/
-            memmove(handleData->values + index, handleData->values + index + 1, (handleData->count - index - 1)*sizeof(char*));
-            Map_DecreaseStorageKeysValues(handleData);
-            result = MAP_OK;
+            /*Codes_SRS_MAP_01_009: [Before Map_Add, Map_AddOrUpdate or Map_Delete change the pairs of a map that shares them with other maps, they shall copy the pairs; if the copy fails they shall return MAP_ERROR.] */
+            if (Map_OwnPairs(handleData) != 0)
+            {
+                result = MAP_ERROR;
+                LOG_MAP_ERROR;
+            }
+            else
+            {
+                free(handleData->keys[index]);
+                free(handleData->values[index]);
+                memmove(handleData->keys + index, handleData->keys + index + 1, (handleData->count - index - 1)*sizeof(char*)); /*if order doesn't matter... then this can be optimized*/
+                memmove(handleData->values + index, handleData->values + index + 1, (handleData->count - index - 1)*sizeof(char*));
+                Map_DecreaseStorageKeysValues(handleData);
+                if (handleData->index != NULL)
+                {
+                    /*positions after index have shifted*/
+                    Map_RebuildIndex(handleData);
+                }
+                result = MAP_OK;
+            }
         }
 
     }
@@ -584,94 +978,161 @@ MAP_RESULT Map_GetInternals(MAP_HANDLE handle, const char*const** keys, const ch
     return result;
 }
 
+/*the JSON of the map is {"key1":"value1","key2":"value2"...}: the braces, the keys and values, a ':' for every pair and a ',' between pairs*/
+static int Map_JSONLength(const MAP_HANDLE_DATA* handleData, size_t* length)
+{
+    int result = 0;
+    size_t total = 2 + ((handleData->count > 0) ? ((handleData->count * 2) - 1) : 0);
+    size_t i;
+    for (i = 0; i < handleData->count; i++)
+    {
+        size_t keyLength;
+        size_t valueLength;
+        if ((STRING_JSON_length(handleData->keys[i], &keyLength) != 0) ||
+            (STRING_JSON_length(handleData->values[i], &valueLength) != 0))
+        {
+            LogError("unable to represent the pair %lu in JSON", (unsigned long)i);
+            result = __FAILURE__;
+            break;
+        }
+        else if ((keyLength > ((size_t)-1) - total) || (valueLength > ((size_t)-1) - total - keyLength))
+        {
+            LogError("the JSON representation of the map is too long");
+            result = __FAILURE__;
+            break;
+        }
+        else
+        {
+            total += keyLength + valueLength;
+        }
+    }
+    *length = total;
+    return result;
+}
+
+/*writes the length characters that Map_JSONLength computed at destination, without a '\0'*/
+static int Map_WriteJSON(const MAP_HANDLE_DATA* handleData, char* destination, size_t length)
+{
+    int result = 0;
+    size_t position = 0;
+    size_t i;
+    destination[position++] = '{';
+    for (i = 0; i < handleData->count; i++)
+    {
+        size_t written;
+        if (i > 0)
+        {
+            destination[position++] = ',';
+        }
+        if (STRING_JSON_write(destination + position, length - position - 2, handleData->keys[i], &written) != 0)
+        {
+            result = __FAILURE__;
+            break;
+        }
+        position += written;
+        destination[position++] = ':';
+        if (STRING_JSON_write(destination + position, length - position - 1, handleData->values[i], &written) != 0)
+        {
+            result = __FAILURE__;
+            break;
+        }
+        position += written;
+    }
+    if (result != 0)
+    {
+        LogError("unable to write the pair %lu in JSON", (unsigned long)i);
+    }
+    else
+    {
+        destination[position] = '}';
+    }
+    return result;
+}
+
 STRING_HANDLE Map_ToJSON(MAP_HANDLE handle)
 {
     STRING_HANDLE result;
+    size_t length;
     /*Codes_SRS_MAP_02_052: [If parameter handle is NULL then Map_ToJSON shall return NULL.] */
     if (handle == NULL)
     {
         result = NULL;
         LogError("invalid arg (NULL)");
     }
+    /*Codes_SRS_MAP_01_004: [Map_ToJSON shall compute the exact length of the JSON representation before writing it, so that it allocates its content once.] */
+    else if (Map_JSONLength((MAP_HANDLE_DATA*)handle, &length) != 0)
+    {
+        /*Codes_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
+        result = NULL;
+        LogError("unable to compute the length of the JSON");
+    }
     else
     {
+        char* json = (length < ((size_t)-1)) ? (char*)malloc(length + 1) : NULL;
+        if (json == NULL)
+        {
+            /*Codes_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
+            result = NULL;
+            LogError("unable to allocate %lu bytes for the JSON", (unsigned long)length);
+        }
         /*Codes_SRS_MAP_02_048: [Map_ToJSON shall produce a STRING_HANDLE representing the content of the MAP.] */
-        result = STRING_construct("{");
-        if (result == NULL)
+        /*Codes_SRS_MAP_02_049: [If the MAP is empty, then Map_ToJSON shall produce the string "{}".*/
+        /*Codes_SRS_MAP_02_050: [If the map has properties then Map_ToJSON shall produce the following string:{"name1":"value1", "name2":"value2" ...}]*/
+        else if (Map_WriteJSON((MAP_HANDLE_DATA*)handle, json, length) != 0)
         {
-            LogError("STRING_construct failed");
+            result = NULL;
+            free(json);
         }
         else
         {
-            size_t i;
-            MAP_HANDLE_DATA* handleData = (MAP_HANDLE_DATA *)handle;
-            /*Codes_SRS_MAP_02_049: [If the MAP is empty, then Map_ToJSON shall produce the string "{}".*/
-            bool breakFor = false; /*used to break out of for*/
-            for (i = 0; (i < handleData->count) && (!breakFor); i++)
+            json[length] = '\0';
+            /*the STRING takes ownership of json*/
+            if ((result = STRING_new_with_memory(json)) == NULL)
             {
-                /*add one entry to the JSON*/
-                /*Codes_SRS_MAP_02_050: [If the map has properties then Map_ToJSON shall produce the following string:{"name1":"value1", "name2":"value2" ...}]*/
-                STRING_HANDLE key = STRING_new_JSON(handleData->keys[i]);
-                if (key == NULL)
-                {
-                    LogError("STRING_new_JSON failed");
-                    STRING_delete(result);
-                    result = NULL;
-                    breakFor = true;
-                }
-                else
-                {
-                    STRING_HANDLE value = STRING_new_JSON(handleData->values[i]);
-                    if (value == NULL)
-                    {
-                        LogError("STRING_new_JSON failed");
-                        STRING_delete(result);
-                        result = NULL;
-                        breakFor = true;
-                    }
-                    else
-                    {
-                        if (!(
-                            ((i>0) ? (STRING_concat(result, ",") == 0) : 1) &&
-                            (STRING_concat_with_STRING(result, key) == 0) &&
-                            (STRING_concat(result, ":") == 0) &&
-                            (STRING_concat_with_STRING(result, value) == 0)
-                            ))
-                        {
-                            LogError("failed to build the JSON");
-                            STRING_delete(result);
-                            result = NULL;
-                            breakFor = true;
-                        }
-                        else
-                        {
-                            /*all nice, go to the next element in the map*/
-                        }
-                        STRING_delete(value);
-                    }
-                    STRING_delete(key);
-                }
-            }
-
-            if (breakFor)
-            {
-                LogError("error happened during JSON string builder");
-            }
-            else
-            {
-                if (STRING_concat(result, "}") != 0)
-                {
-                    LogError("failed to build the JSON");
-                    STRING_delete(result);
-                    result = NULL;
-                }
-                else
-                {
-                    /*return as is, JSON has been build*/
-                }
+                LogError("STRING_new_with_memory failed");
+                free(json);
             }
         }
     }
     return result;
+}
 
+MAP_RESULT Map_ToJSONBuffer(MAP_HANDLE handle, BUFFER_HANDLE destination)
+{
+    MAP_RESULT result;
+    size_t length;
+    if ((handle == NULL) || (destination == NULL))
+    {
+        /*Codes_SRS_MAP_01_006: [If handle or destination is NULL then Map_ToJSONBuffer shall return MAP_INVALIDARG.] */
+        LogError("invalid arg: handle=%p, destination=%p", handle, destination);
+        result = MAP_INVALIDARG;
+    }
+    else if (Map_JSONLength((MAP_HANDLE_DATA*)handle, &length) != 0)
+    {
+        /*Codes_SRS_MAP_01_007: [If any error occurs while producing the output, then Map_ToJSONBuffer shall return MAP_ERROR and leave destination unchanged.] */
+        LogError("unable to compute the length of the JSON");
+        result = MAP_ERROR;
+    }
+    else
+    {
+        size_t oldLength = BUFFER_length(destination);
+        /*Codes_SRS_MAP_01_005: [Map_ToJSONBuffer shall append to destination the JSON representation that Map_ToJSON produces, without a '\0', growing it once by its exact length.] */
+        if (BUFFER_enlarge(destination, length) != 0)
+        {
+            /*Codes_SRS_MAP_01_007: [If any error occurs while producing the output, then Map_ToJSONBuffer shall return MAP_ERROR and leave destination unchanged.] */
+            LogError("unable to grow the buffer by %lu bytes", (unsigned long)length);
+            result = MAP_ERROR;
+        }
+        else if (Map_WriteJSON((MAP_HANDLE_DATA*)handle, (char*)BUFFER_u_char(destination) + oldLength, length) != 0)
+        {
+            /*Codes_SRS_MAP_01_007: [If any error occurs while producing the output, then Map_ToJSONBuffer shall return MAP_ERROR and leave destination unchanged.] */
+            (void)BUFFER_shrink(destination, length, true);
+            result = MAP_ERROR;
+        }
+        else
+        {
+            result = MAP_OK;
+        }
+    }
+    return result;
 }
@@ -0,0 +1,807 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/memio.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#define MEMIO_SIDE_COUNT    2
+
+/* the bytes of one send, on the link from the side that sent them to the other one */
+typedef struct MEMIO_SEGMENT_TAG
+{
+    struct MEMIO_SEGMENT_TAG* next;
+    ON_SEND_COMPLETE on_send_complete;
+    void* on_send_complete_context;
+    /* when the bytes have left the sending side, and when they reach the other one */
+    tickcounter_us_t departure_us;
+    tickcounter_us_t arrival_us;
+    size_t size;
+    size_t indicated;
+    bool completed;
+    unsigned char bytes[];
+} MEMIO_SEGMENT;
+
+typedef struct MEMIO_LINK_TAG
+{
+    MEMIO_LINK_CONFIG config;
+    /* xorshift32 state of the chunk sizes */
+    uint32_t chunk_random;
+    /* the link does not read the clock when it has neither latency nor bandwidth limit */
+    bool is_timed;
+    MEMIO_SEGMENT* head;
+    MEMIO_SEGMENT* tail;
+    /* the first segment whose send has not completed, the first one not fully indicated; a segment is freed once
+       both have moved past it */
+    MEMIO_SEGMENT* next_to_complete;
+    MEMIO_SEGMENT* next_to_indicate;
+    /* when the last segment leaves, the next one starts leaving then */
+    tickcounter_us_t busy_until_us;
+} MEMIO_LINK;
+
+typedef enum MEMIO_STATE_TAG
+{
+    MEMIO_STATE_CLOSED,
+    MEMIO_STATE_OPEN,
+    MEMIO_STATE_ERROR
+} MEMIO_STATE;
+
+typedef struct MEMIO_INSTANCE_TAG
+{
+    struct MEMIO_PAIR_TAG* pair;
+    int side;
+    MEMIO_STATE memio_state;
+    ON_BYTES_RECEIVED on_bytes_received;
+    void* on_bytes_received_context;
+    ON_IO_ERROR on_io_error;
+    void* on_io_error_context;
+    /* set when the other side closed, the error is indicated once the bytes it sent were */
+    bool peer_closed;
+    XIO_STATS stats;
+} MEMIO_INSTANCE;
+
+typedef struct MEMIO_PAIR_TAG
+{
+    /* links[i] carries the bytes sent by side i */
+    MEMIO_LINK links[MEMIO_SIDE_COUNT];
+    MEMIO_INSTANCE* instances[MEMIO_SIDE_COUNT];
+} MEMIO_PAIR;
+
+static tickcounter_us_t get_link_now_us(const MEMIO_LINK* link)
+{
+    tickcounter_us_t result;
+
+    if (!link->is_timed)
+    {
+        result = 0;
+    }
+    else if (tickcounter_get_monotonic_us(&result) != 0)
+    {
+        LogError("tickcounter_get_monotonic_us failed");
+        result = 0;
+    }
+
+    return result;
+}
+
+static size_t get_chunk_size(MEMIO_LINK* link, size_t remaining)
+{
+    size_t result = remaining;
+
+    if (link->config.max_chunk_size != 0)
+    {
+        size_t chunk_size = link->config.max_chunk_size;
+
+        if (link->config.chunk_seed != 0)
+        {
+            link->chunk_random ^= link->chunk_random << 13;
+            link->chunk_random ^= link->chunk_random >> 17;
+            link->chunk_random ^= link->chunk_random << 5;
+            chunk_size = 1 + (size_t)(link->chunk_random % link->config.max_chunk_size);
+        }
+
+        if (chunk_size < result)
+        {
+            result = chunk_size;
+        }
+    }
+
+    return result;
+}
+
+/* frees the segments at the head of the link that completed and were fully indicated */
+static void release_segments(MEMIO_LINK* link)
+{
+    while ((link->head != NULL) &&
+        link->head->completed &&
+        (link->head->indicated == link->head->size))
+    {
+        MEMIO_SEGMENT* segment = link->head;
+
+        link->head = segment->next;
+        if (link->head == NULL)
+        {
+            link->tail = NULL;
+        }
+        free(segment);
+    }
+}
+
+static void init_link(MEMIO_LINK* link, const MEMIO_LINK_CONFIG* link_config)
+{
+    if (link_config == NULL)
+    {
+        (void)memset(&link->config, 0, sizeof(link->config));
+    }
+    else
+    {
+        link->config = *link_config;
+    }
+
+    link->chunk_random = link->config.chunk_seed;
+    link->is_timed = (link->config.latency_us != 0) || (link->config.bytes_per_second != 0);
+    link->head = NULL;
+    link->tail = NULL;
+    link->next_to_complete = NULL;
+    link->next_to_indicate = NULL;
+    link->busy_until_us = 0;
+}
+
+MEMIO_PAIR_HANDLE memio_pair_create(const MEMIO_LINK_CONFIG* link_0_to_1, const MEMIO_LINK_CONFIG* link_1_to_0)
+{
+    MEMIO_PAIR* result;
+
+    /* Codes_SRS_MEMIO_01_001: [ memio_pair_create shall create a pair of sides with no IO, connected by a link from side 0 to side 1 configured by link_0_to_1 and a link from side 1 to side 0 configured by link_1_to_0. ]*/
+    if ((result = (MEMIO_PAIR*)malloc(sizeof(MEMIO_PAIR))) == NULL)
+    {
+        /* Codes_SRS_MEMIO_01_002: [ If allocating memory fails, memio_pair_create shall fail and return NULL. ]*/
+        LogError("Failed allocating the memio pair.");
+    }
+    else
+    {
+        /* Codes_SRS_MEMIO_01_003: [ A NULL link configuration shall give a link without latency, bandwidth limit or chunking. ]*/
+        init_link(&result->links[0], link_0_to_1);
+        init_link(&result->links[1], link_1_to_0);
+        result->instances[0] = NULL;
+        result->instances[1] = NULL;
+    }
+
+    return result;
+}
+
+void memio_pair_destroy(MEMIO_PAIR_HANDLE pair)
+{
+    if (pair == NULL)
+    {
+        /* Codes_SRS_MEMIO_01_004: [ If pair is NULL, memio_pair_destroy shall return. ]*/
+        LogError("NULL pair.");
+    }
+    else
+    {
+        size_t i;
+
+        if ((pair->instances[0] != NULL) || (pair->instances[1] != NULL))
+        {
+            LogError("Destroying a memio pair that still has IOs.");
+        }
+
+        /* Codes_SRS_MEMIO_01_005: [ memio_pair_destroy shall free the bytes left on both links and the pair. ]*/
+        for (i = 0; i < MEMIO_SIDE_COUNT; i++)
+        {
+            while (pair->links[i].head != NULL)
+            {
+                MEMIO_SEGMENT* segment = pair->links[i].head;
+                pair->links[i].head = segment->next;
+                free(segment);
+            }
+        }
+
+        free(pair);
+    }
+}
+
+static CONCRETE_IO_HANDLE memio_create(void* io_create_parameters)
+{
+    MEMIO_INSTANCE* result;
+
+    if (io_create_parameters == NULL)
+    {
+        /* Codes_SRS_MEMIO_01_006: [ If io_create_parameters is NULL, memio_create shall fail and return NULL. ]*/
+        LogError("NULL io_create_parameters.");
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_MEMIO_01_007: [ io_create_parameters shall be used as a MEMIO_CONFIG*. ]*/
+        MEMIO_CONFIG* memio_config = (MEMIO_CONFIG*)io_create_parameters;
+
+        if ((memio_config->pair == NULL) ||
+            (memio_config->side < 0) ||
+            (memio_config->side >= MEMIO_SIDE_COUNT) ||
+            (memio_config->pair->instances[memio_config->side] != NULL))
+        {
+            /* Codes_SRS_MEMIO_01_008: [ If pair is NULL, side is neither 0 nor 1, or the side already has an IO, memio_create shall fail and return NULL. ]*/
+            LogError("Bad arguments: pair = %p, side = %d", memio_config->pair, memio_config->side);
+            result = NULL;
+        }
+        /* Codes_SRS_MEMIO_01_009: [ memio_create shall create a closed IO for the side of the pair. ]*/
+        else if ((result = (MEMIO_INSTANCE*)malloc(sizeof(MEMIO_INSTANCE))) == NULL)
+        {
+            /* Codes_SRS_MEMIO_01_010: [ If allocating memory fails, memio_create shall fail and return NULL. ]*/
+            LogError("Failed allocating the memio instance.");
+        }
+        else
+        {
+            result->pair = memio_config->pair;
+            result->side = memio_config->side;
+            result->memio_state = MEMIO_STATE_CLOSED;
+            result->on_bytes_received = NULL;
+            result->on_bytes_received_context = NULL;
+            result->on_io_error = NULL;
+            result->on_io_error_context = NULL;
+            result->peer_closed = false;
+            (void)memset(&result->stats, 0, sizeof(result->stats));
+            result->stats.layer_name = "memio";
+            result->pair->instances[result->side] = result;
+        }
+    }
+
+    return result;
+}
+
+static void close_instance(MEMIO_INSTANCE* memio_instance)
+{
+    MEMIO_LINK* outgoing_link = &memio_instance->pair->links[memio_instance->side];
+    MEMIO_LINK* incoming_link = &memio_instance->pair->links[MEMIO_SIDE_COUNT - 1 - memio_instance->side];
+    MEMIO_INSTANCE* peer_instance = memio_instance->pair->instances[MEMIO_SIDE_COUNT - 1 - memio_instance->side];
+    tickcounter_us_t now_us = get_link_now_us(outgoing_link);
+    MEMIO_SEGMENT* left_segment = NULL;
+    MEMIO_SEGMENT* cancelled_segments = NULL;
+    MEMIO_SEGMENT* segment;
+    bool kept_next_to_indicate = false;
+
+    memio_instance->memio_state = MEMIO_STATE_CLOSED;
+
+    /* the sends that did not leave are a tail of the link since the segments leave in order */
+    for (segment = outgoing_link->head; (segment != NULL) && (segment->completed || (segment->departure_us <= now_us)); segment = segment->next)
+    {
+        left_segment = segment;
+        kept_next_to_indicate = kept_next_to_indicate || (segment == outgoing_link->next_to_indicate);
+    }
+
+    if (left_segment == NULL)
+    {
+        cancelled_segments = outgoing_link->head;
+        outgoing_link->head = NULL;
+    }
+    else
+    {
+        cancelled_segments = left_segment->next;
+        left_segment->next = NULL;
+    }
+    outgoing_link->tail = left_segment;
+    if (!kept_next_to_indicate)
+    {
+        outgoing_link->next_to_indicate = NULL;
+    }
+    outgoing_link->busy_until_us = (left_segment == NULL) ? 0 : left_segment->departure_us;
+
+    /* Codes_SRS_MEMIO_01_020: [ memio_close shall drop the bytes that wait to be indicated to the IO. ]*/
+    for (segment = incoming_link->next_to_indicate; segment != NULL; segment = segment->next)
+    {
+        segment->indicated = segment->size;
+    }
+    incoming_link->next_to_indicate = NULL;
+    release_segments(incoming_link);
+
+    /* Codes_SRS_MEMIO_01_021: [ If the IO of the other side is open, it shall indicate an error once the bytes already sent to it were indicated. ]*/
+    if ((peer_instance != NULL) && (peer_instance->memio_state == MEMIO_STATE_OPEN))
+    {
+        peer_instance->peer_closed = true;
+    }
+
+    /* Codes_SRS_MEMIO_01_018: [ memio_close shall complete with IO_SEND_OK the sends whose bytes have left, in order. ]*/
+    segment = outgoing_link->next_to_complete;
+    outgoing_link->next_to_complete = NULL;
+    while (segment != NULL)
+    {
+        MEMIO_SEGMENT* next_segment = segment->next;
+
+        segment->completed = true;
+        if (segment->on_send_complete != NULL)
+        {
+            memio_instance->stats.callback_count++;
+            segment->on_send_complete(segment->on_send_complete_context, IO_SEND_OK);
+        }
+        segment = next_segment;
+    }
+    release_segments(outgoing_link);
+
+    /* Codes_SRS_MEMIO_01_019: [ memio_close shall complete with IO_SEND_CANCELLED the sends whose bytes have not left, and drop their bytes. ]*/
+    while (cancelled_segments != NULL)
+    {
+        segment = cancelled_segments;
+        cancelled_segments = segment->next;
+        if (segment->on_send_complete != NULL)
+        {
+            memio_instance->stats.callback_count++;
+            segment->on_send_complete(segment->on_send_complete_context, IO_SEND_CANCELLED);
+        }
+        free(segment);
+    }
+}
+
+static void memio_destroy(CONCRETE_IO_HANDLE memio)
+{
+    if (memio == NULL)
+    {
+        /* Codes_SRS_MEMIO_01_011: [ If memio is NULL, memio_destroy shall return. ]*/
+        LogError("NULL memio.");
+    }
+    else
+    {
+        MEMIO_INSTANCE* memio_instance = (MEMIO_INSTANCE*)memio;
+
+        /* Codes_SRS_MEMIO_01_012: [ memio_destroy shall close the IO if it is open, and free it, leaving the side of the pair without IO. ]*/
+        if (memio_instance->memio_state != MEMIO_STATE_CLOSED)
+        {
+            close_instance(memio_instance);
+        }
+
+        memio_instance->pair->instances[memio_instance->side] = NULL;
+        free(memio_instance);
+    }
+}
+
+static int memio_open(CONCRETE_IO_HANDLE memio, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    int result;
+
+    if ((memio == NULL) ||
+        (on_io_open_complete == NULL) ||
+        (on_bytes_received == NULL) ||
+        (on_io_error == NULL))
+    {
+        /* Codes_SRS_MEMIO_01_013: [ If memio, on_io_open_complete, on_bytes_received or on_io_error is NULL, memio_open shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: memio = %p, on_io_open_complete = %p, on_bytes_received = %p, on_io_error = %p",
+            memio, on_io_open_complete, on_bytes_received, on_io_error);
+        result = __FAILURE__;
+    }
+    else
+    {
+        MEMIO_INSTANCE* memio_instance = (MEMIO_INSTANCE*)memio;
+
+        if (memio_instance->memio_state != MEMIO_STATE_CLOSED)
+        {
+            /* Codes_SRS_MEMIO_01_014: [ If the IO is not closed, memio_open shall fail and return a non-zero value. ]*/
+            LogError("memio is not closed.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_MEMIO_01_015: [ memio_open shall open the IO and call on_io_open_complete with IO_OPEN_OK before returning 0. ]*/
+            memio_instance->on_bytes_received = on_bytes_received;
+            memio_instance->on_bytes_received_context = on_bytes_received_context;
+            memio_instance->on_io_error = on_io_error;
+            memio_instance->on_io_error_context = on_io_error_context;
+            memio_instance->peer_closed = false;
+            memio_instance->memio_state = MEMIO_STATE_OPEN;
+            on_io_open_complete(on_io_open_complete_context, IO_OPEN_OK);
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int memio_close(CONCRETE_IO_HANDLE memio, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    int result;
+
+    if (memio == NULL)
+    {
+        /* Codes_SRS_MEMIO_01_016: [ If memio is NULL, memio_close shall fail and return a non-zero value. ]*/
+        LogError("NULL memio.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        MEMIO_INSTANCE* memio_instance = (MEMIO_INSTANCE*)memio;
+
+        if (memio_instance->memio_state == MEMIO_STATE_CLOSED)
+        {
+            /* Codes_SRS_MEMIO_01_017: [ If the IO is closed, memio_close shall fail and return a non-zero value. ]*/
+            LogError("memio is already closed.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            close_instance(memio_instance);
+
+            /* Codes_SRS_MEMIO_01_022: [ memio_close shall then call on_io_close_complete, if it is not NULL, and return 0. ]*/
+            if (on_io_close_complete != NULL)
+            {
+                on_io_close_complete(callback_context);
+            }
+
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int memio_sendv(CONCRETE_IO_HANDLE memio, const XIO_BUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+    size_t size = 0;
+    size_t i;
+
+    if ((memio == NULL) ||
+        (buffers == NULL) ||
+        (buffer_count == 0))
+    {
+        /* Codes_SRS_MEMIO_01_023: [ If memio or buffers is NULL, or buffer_count is 0, memio_sendv shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: memio = %p, buffers = %p, buffer_count = %lu", memio, buffers, (unsigned long)buffer_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        bool are_buffers_valid = true;
+
+        for (i = 0; are_buffers_valid && (i < buffer_count); i++)
+        {
+            are_buffers_valid = ((buffers[i].buffer != NULL) || (buffers[i].size == 0)) &&
+                (buffers[i].size <= SIZE_MAX - sizeof(MEMIO_SEGMENT) - size);
+            size += buffers[i].size;
+        }
+
+        if (!are_buffers_valid || (size == 0))
+        {
+            /* Codes_SRS_MEMIO_01_024: [ If a buffer with bytes has a NULL pointer, or the buffers hold no byte, memio_sendv shall fail and return a non-zero value. ]*/
+            LogError("Bad buffers.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            MEMIO_INSTANCE* memio_instance = (MEMIO_INSTANCE*)memio;
+            MEMIO_SEGMENT* segment;
+
+            if (memio_instance->memio_state != MEMIO_STATE_OPEN)
+            {
+                /* Codes_SRS_MEMIO_01_025: [ If the IO is not open, memio_sendv shall fail and return a non-zero value. ]*/
+                LogError("memio is not open.");
+                result = __FAILURE__;
+            }
+            else if ((segment = (MEMIO_SEGMENT*)malloc(sizeof(MEMIO_SEGMENT) + size)) == NULL)
+            {
+                /* Codes_SRS_MEMIO_01_026: [ If allocating memory fails, memio_sendv shall fail and return a non-zero value. ]*/
+                LogError("Failed allocating %lu bytes to send.", (unsigned long)size);
+                result = __FAILURE__;
+            }
+            else
+            {
+                MEMIO_LINK* link = &memio_instance->pair->links[memio_instance->side];
+                tickcounter_us_t start_us = get_link_now_us(link);
+                size_t offset = 0;
+
+                /* Codes_SRS_MEMIO_01_027: [ memio_sendv shall copy the bytes of the buffers, back to back, at the end of the link to the other side. ]*/
+                for (i = 0; i < buffer_count; i++)
+                {
+                    if (buffers[i].size > 0)
+                    {
+                        (void)memcpy(segment->bytes + offset, buffers[i].buffer, buffers[i].size);
+                        offset += buffers[i].size;
+                    }
+                }
+
+                /* Codes_SRS_MEMIO_01_028: [ The bytes shall leave once the bytes sent before them have, after size / bytes_per_second seconds, and reach the other side latency_us later. ]*/
+                if (link->busy_until_us > start_us)
+                {
+                    start_us = link->busy_until_us;
+                }
+                segment->departure_us = start_us;
+                if (link->config.bytes_per_second != 0)
+                {
+                    segment->departure_us += (tickcounter_us_t)(((uint64_t)size * 1000000) / link->config.bytes_per_second);
+                }
+                segment->arrival_us = segment->departure_us + link->config.latency_us;
+                link->busy_until_us = segment->departure_us;
+
+                segment->next = NULL;
+                segment->on_send_complete = on_send_complete;
+                segment->on_send_complete_context = callback_context;
+                segment->size = size;
+                segment->indicated = 0;
+                segment->completed = false;
+
+                if (link->tail == NULL)
+                {
+                    link->head = segment;
+                }
+                else
+                {
+                    link->tail->next = segment;
+                }
+                link->tail = segment;
+                if (link->next_to_complete == NULL)
+                {
+                    link->next_to_complete = segment;
+                }
+                if (link->next_to_indicate == NULL)
+                {
+                    link->next_to_indicate = segment;
+                }
+
+                memio_instance->stats.bytes_sent += size;
+                memio_instance->stats.send_count++;
+                memio_instance->stats.queued_send_count++;
+
+                /* Codes_SRS_MEMIO_01_029: [ On success memio_sendv shall return 0. ]*/
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static int memio_send(CONCRETE_IO_HANDLE memio, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    if ((buffer == NULL) || (size == 0))
+    {
+        /* Codes_SRS_MEMIO_01_030: [ If buffer is NULL or size is 0, memio_send shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: buffer = %p, size = %lu", buffer, (unsigned long)size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        XIO_BUFFER xio_buffer;
+
+        /* Codes_SRS_MEMIO_01_031: [ Otherwise memio_send shall behave as memio_sendv with the one buffer. ]*/
+        xio_buffer.buffer = buffer;
+        xio_buffer.size = size;
+        result = memio_sendv(memio, &xio_buffer, 1, on_send_complete, callback_context);
+    }
+
+    return result;
+}
+
+static void complete_sends(MEMIO_INSTANCE* memio_instance)
+{
+    MEMIO_LINK* link = &memio_instance->pair->links[memio_instance->side];
+    tickcounter_us_t now_us = get_link_now_us(link);
+    MEMIO_SEGMENT* segment;
+
+    while ((memio_instance->memio_state != MEMIO_STATE_CLOSED) &&
+        ((segment = link->next_to_complete) != NULL) &&
+        (segment->departure_us <= now_us))
+    {
+        segment->completed = true;
+        link->next_to_complete = segment->next;
+
+        if (segment->on_send_complete != NULL)
+        {
+            memio_instance->stats.callback_count++;
+            segment->on_send_complete(segment->on_send_complete_context, IO_SEND_OK);
+        }
+    }
+
+    release_segments(link);
+}
+
+static void indicate_bytes(MEMIO_INSTANCE* memio_instance)
+{
+    MEMIO_LINK* link = &memio_instance->pair->links[MEMIO_SIDE_COUNT - 1 - memio_instance->side];
+    tickcounter_us_t now_us = get_link_now_us(link);
+    MEMIO_SEGMENT* segment;
+
+    while ((memio_instance->memio_state == MEMIO_STATE_OPEN) &&
+        ((segment = link->next_to_indicate) != NULL) &&
+        (segment->arrival_us <= now_us))
+    {
+        size_t chunk_size = get_chunk_size(link, segment->size - segment->indicated);
+
+        memio_instance->stats.bytes_received += chunk_size;
+        memio_instance->stats.callback_count++;
+        memio_instance->on_bytes_received(memio_instance->on_bytes_received_context, segment->bytes + segment->indicated, chunk_size);
+
+        /* a close from the callback dropped the segment */
+        if (memio_instance->memio_state == MEMIO_STATE_OPEN)
+        {
+            segment->indicated += chunk_size;
+            if (segment->indicated == segment->size)
+            {
+                link->next_to_indicate = segment->next;
+            }
+        }
+    }
+
+    release_segments(link);
+
+    if ((memio_instance->memio_state == MEMIO_STATE_OPEN) &&
+        memio_instance->peer_closed &&
+        (link->next_to_indicate == NULL))
+    {
+        memio_instance->peer_closed = false;
+        memio_instance->memio_state = MEMIO_STATE_ERROR;
+        memio_instance->stats.callback_count++;
+        memio_instance->on_io_error(memio_instance->on_io_error_context);
+    }
+}
+
+static int memio_dowork_ex(CONCRETE_IO_HANDLE memio, bool* made_progress, uint64_t* next_deadline_us)
+{
+    int result;
+
+    if ((memio == NULL) ||
+        (made_progress == NULL) ||
+        (next_deadline_us == NULL))
+    {
+        /* Codes_SRS_MEMIO_01_032: [ If memio, made_progress or next_deadline_us is NULL, memio_dowork_ex shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: memio = %p, made_progress = %p, next_deadline_us = %p",
+            memio, made_progress, next_deadline_us);
+        result = __FAILURE__;
+    }
+    else
+    {
+        MEMIO_INSTANCE* memio_instance = (MEMIO_INSTANCE*)memio;
+        uint64_t callback_count = memio_instance->stats.callback_count;
+
+        memio_instance->stats.dowork_count++;
+        *next_deadline_us = XIO_NO_DEADLINE;
+
+        if (memio_instance->memio_state != MEMIO_STATE_CLOSED)
+        {
+            MEMIO_LINK* outgoing_link = &memio_instance->pair->links[memio_instance->side];
+            MEMIO_LINK* incoming_link = &memio_instance->pair->links[MEMIO_SIDE_COUNT - 1 - memio_instance->side];
+
+            /* Codes_SRS_MEMIO_01_033: [ memio_dowork_ex shall complete with IO_SEND_OK the sends whose bytes have left, in order. ]*/
+            complete_sends(memio_instance);
+
+            /* Codes_SRS_MEMIO_01_034: [ When the IO is open, memio_dowork_ex shall then indicate the bytes that reached it with on_bytes_received, in order, each call giving at most the chunk size of the link and never bytes of two sends. ]*/
+            /* Codes_SRS_MEMIO_01_035: [ When the other side closed and all the bytes it sent were indicated, memio_dowork_ex shall call on_io_error once. ]*/
+            indicate_bytes(memio_instance);
+
+            /* Codes_SRS_MEMIO_01_036: [ memio_dowork_ex shall give the earliest time a send is to complete or bytes are to reach the IO as next_deadline_us, XIO_NO_DEADLINE if none. ]*/
+            if ((memio_instance->memio_state != MEMIO_STATE_CLOSED) &&
+                (outgoing_link->next_to_complete != NULL))
+            {
+                *next_deadline_us = outgoing_link->next_to_complete->departure_us;
+            }
+            if ((memio_instance->memio_state == MEMIO_STATE_OPEN) &&
+                (incoming_link->next_to_indicate != NULL) &&
+                (incoming_link->next_to_indicate->arrival_us < *next_deadline_us))
+            {
+                *next_deadline_us = incoming_link->next_to_indicate->arrival_us;
+            }
+        }
+
+        /* Codes_SRS_MEMIO_01_037: [ memio_dowork_ex shall set made_progress to true when it called back the layer above, and return 0. ]*/
+        *made_progress = (memio_instance->stats.callback_count != callback_count);
+        if (!*made_progress)
+        {
+            memio_instance->stats.idle_dowork_count++;
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+static void memio_dowork(CONCRETE_IO_HANDLE memio)
+{
+    bool made_progress;
+    uint64_t next_deadline_us;
+
+    /* Codes_SRS_MEMIO_01_038: [ memio_dowork shall do the work of memio_dowork_ex. ]*/
+    (void)memio_dowork_ex(memio, &made_progress, &next_deadline_us);
+}
+
+static int memio_get_stats(CONCRETE_IO_HANDLE memio, XIO_STATS* stats, size_t stats_count, size_t* layer_count)
+{
+    int result;
+
+    if ((memio == NULL) ||
+        (stats == NULL) ||
+        (stats_count == 0) ||
+        (layer_count == NULL))
+    {
+        LogError("Bad arguments: memio = %p, stats = %p, stats_count = %lu, layer_count = %p.",
+            memio, stats, (unsigned long)stats_count, layer_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        MEMIO_INSTANCE* memio_instance = (MEMIO_INSTANCE*)memio;
+        MEMIO_SEGMENT* segment;
+
+        /* Codes_SRS_MEMIO_01_039: [ memio_get_stats shall fill the first entry of stats with the counters of the IO, the bottom layer of the stack. ]*/
+        stats[0] = memio_instance->stats;
+        stats[0].pending_send_count = 0;
+        for (segment = memio_instance->pair->links[memio_instance->side].next_to_complete; segment != NULL; segment = segment->next)
+        {
+            stats[0].pending_send_count++;
+        }
+        *layer_count = 1;
+        result = 0;
+    }
+
+    return result;
+}
+
+static int memio_setoption(CONCRETE_IO_HANDLE memio, const char* option_name, const void* value)
+{
+    (void)value;
+
+    /* Codes_SRS_MEMIO_01_040: [ memio_setoption shall fail and return a non-zero value, the IO has no option. ]*/
+    LogError("memio has no option: memio = %p, option_name = %s", memio, (option_name == NULL) ? "NULL" : option_name);
+    return __FAILURE__;
+}
+
+static void* memio_clone_option(const char* name, const void* value)
+{
+    (void)value;
+    LogError("memio has no option %s", (name == NULL) ? "NULL" : name);
+    return NULL;
+}
+
+static void memio_destroy_option(const char* name, const void* value)
+{
+    (void)name;
+    (void)value;
+}
+
+static OPTIONHANDLER_HANDLE memio_retrieveoptions(CONCRETE_IO_HANDLE memio)
+{
+    OPTIONHANDLER_HANDLE result;
+
+    if (memio == NULL)
+    {
+        LogError("NULL memio.");
+        result = NULL;
+    }
+    /* Codes_SRS_MEMIO_01_041: [ memio_retrieveoptions shall return an empty option handler created with OptionHandler_Create. ]*/
+    else if ((result = OptionHandler_Create(memio_clone_option, memio_destroy_option, memio_setoption)) == NULL)
+    {
+        LogError("OptionHandler_Create failed");
+    }
+
+    return result;
+}
+
+static const IO_INTERFACE_DESCRIPTION memio_interface_description =
+{
+    memio_retrieveoptions,
+    memio_create,
+    memio_destroy,
+    memio_open,
+    memio_close,
+    memio_send,
+    memio_dowork,
+    memio_setoption,
+    memio_sendv,
+    NULL,
+    memio_get_stats,
+    memio_dowork_ex,
+    NULL,
+    NULL
+};
+
+const IO_INTERFACE_DESCRIPTION* memio_get_interface_description(void)
+{
+    /* Codes_SRS_MEMIO_01_042: [ memio_get_interface_description shall return a pointer to an IO_INTERFACE_DESCRIPTION structure that contains pointers to the functions of the memio. ]*/
+    return &memio_interface_description;
+}
@@ -7,6 +7,83 @@
 
 #include "azure_c_shared_utility/memory_data.h"
 
+/* The array functions reverse the bytes of 16 bytes of values per instruction where the
+   target has byte shuffles, and the values left go through the inline functions. */
+#if defined(__SSSE3__) || (defined(_MSC_VER) && defined(__AVX__))
+#include <tmmintrin.h>
+#define MEMORY_DATA_SSSE3
+#elif defined(__ARM_NEON) && defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+#include <arm_neon.h>
+#define MEMORY_DATA_NEON
+#endif
+
+/* each of these returns the values it converted, a multiple of the values in 16 bytes */
+static size_t swap_bytes_16(unsigned char* to, const unsigned char* from, size_t count)
+{
+    size_t i = 0;
+#if defined(MEMORY_DATA_SSSE3)
+    const __m128i shuffle = _mm_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    for (; i + 8 <= count; i += 8)
+    {
+        _mm_storeu_si128((__m128i*)(to + i * 2), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(from + i * 2)), shuffle));
+    }
+#elif defined(MEMORY_DATA_NEON)
+    for (; i + 8 <= count; i += 8)
+    {
+        vst1q_u8(to + i * 2, vrev16q_u8(vld1q_u8(from + i * 2)));
+    }
+#else
+    (void)to;
+    (void)from;
+    (void)count;
+#endif
+    return i;
+}
+
+static size_t swap_bytes_32(unsigned char* to, const unsigned char* from, size_t count)
+{
+    size_t i = 0;
+#if defined(MEMORY_DATA_SSSE3)
+    const __m128i shuffle = _mm_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+    for (; i + 4 <= count; i += 4)
+    {
+        _mm_storeu_si128((__m128i*)(to + i * 4), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(from + i * 4)), shuffle));
+    }
+#elif defined(MEMORY_DATA_NEON)
+    for (; i + 4 <= count; i += 4)
+    {
+        vst1q_u8(to + i * 4, vrev32q_u8(vld1q_u8(from + i * 4)));
+    }
+#else
+    (void)to;
+    (void)from;
+    (void)count;
+#endif
+    return i;
+}
+
+static size_t swap_bytes_64(unsigned char* to, const unsigned char* from, size_t count)
+{
+    size_t i = 0;
+#if defined(MEMORY_DATA_SSSE3)
+    const __m128i shuffle = _mm_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+    for (; i + 2 <= count; i += 2)
+    {
+        _mm_storeu_si128((__m128i*)(to + i * 8), _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(from + i * 8)), shuffle));
+    }
+#elif defined(MEMORY_DATA_NEON)
+    for (; i + 2 <= count; i += 2)
+    {
+        vst1q_u8(to + i * 8, vrev64q_u8(vld1q_u8(from + i * 8)));
+    }
+#else
+    (void)to;
+    (void)from;
+    (void)count;
+#endif
+    return i;
+}
+
 void read_uint8_t(const unsigned char* source, uint8_t* destination)
 {
     /*Codes_SRS_MEMORY_DATA_02_041: [ read_uint8_t shall write in destination the byte at source ]*/
@@ -16,36 +93,19 @@ void read_uint8_t(const unsigned char* source, uint8_t* destination)
 void read_uint16_t(const unsigned char* source, uint16_t* destination)
 {
     /*Codes_SRS_MEMORY_DATA_02_042: [ read_uint16_t shall write in destination the bytes at source MSB first and return. ]*/
-    *destination = 
-        (source[0]<<8)+
-        (source[1])
-        ;
+    *destination = memory_data_read_uint16(source);
 }
 
 void read_uint32_t(const unsigned char* source, uint32_t* destination)
 {
     /*Codes_SRS_MEMORY_DATA_02_043: [ read_uint32_t shall write in destination the bytes at source MSB first. ]*/
-    *destination =
-        (source[0] << 24) +
-        (source[1] << 16) +
-        (source[2] << 8) +
-        (source[3])
-        ;
+    *destination = memory_data_read_uint32(source);
 }
 
 void read_uint64_t(const unsigned char* source, uint64_t* destination)
 {
     /*Codes_SRS_MEMORY_DATA_02_044: [ read_uint64_t shall write in destination the bytes at source MSB first. ]*/
-    *destination =
-        ((uint64_t)source[0] << 56) +
-        ((uint64_t)source[1] << 48) +
-        ((uint64_t)source[2] << 40) +
-        ((uint64_t)source[3] << 32) +
-        ((uint64_t)source[4] << 24) +
-        ((uint64_t)source[5] << 16) +
-        ((uint64_t)source[6] << 8) +
-        ((uint64_t)source[7])
-        ;
+    *destination = memory_data_read_uint64(source);
 }
 
 void write_uint8_t(unsigned char* destination, uint8_t value)
@@ -57,30 +117,19 @@ void write_uint8_t(unsigned char* destination, uint8_t value)
 void write_uint16_t(unsigned char* destination, uint16_t value)
 {
     /*Codes_SRS_MEMORY_DATA_02_051: [ write_uint16_t shall write in destination the bytes of value MSB first. ]*/
-    destination[0] = (value>>8) & 0xFF;
-    destination[1] = (value) & 0xFF;
+    memory_data_write_uint16(destination, value);
 }
 
 void write_uint32_t(unsigned char* destination, uint32_t value)
 {
     /*Codes_SRS_MEMORY_DATA_02_052: [ write_uint32_t shall write in destination the bytes of value MSB first. ]*/
-    destination[0] = (value >> 24)&0xFF;
-    destination[1] = (value >> 16)&0xFF;
-    destination[2] = (value >> 8) & 0xFF;
-    destination[3] = (value)&0xFF;
+    memory_data_write_uint32(destination, value);
 }
 
 void write_uint64_t(unsigned char* destination, uint64_t value)
 {
     /*Codes_SRS_MEMORY_DATA_02_053: [ write_uint64_t shall write in destination the bytes of value MSB first. ]*/
-    destination[0] = (value >> 56)&0xFF;
-    destination[1] = (value >> 48)&0xFF;
-    destination[2] = (value >> 40)&0xFF;
-    destination[3] = (value >> 32)&0xFF;
-    destination[4] = (value >> 24)&0xFF;
-    destination[5] = (value >> 16)&0xFF;
-    destination[6] = (value >> 8)&0xFF;
-    destination[7] = (value)&0xFF;
+    memory_data_write_uint64(destination, value);
 }
 
 void write_int8_t(unsigned char* destination, int8_t value)
@@ -166,4 +215,64 @@ void read_uuid_t(const unsigned char* source, UUID_T* destination)
 {
     /*Codes_SRS_MEMORY_DATA_02_049: [ read_uuid_t shall write in destination the bytes at source. ]*/
     (void)memcpy(destination, source, sizeof(UUID_T));
-}
\ No newline at end of file
+}
+
+void read_uint16_array(const unsigned char* source, uint16_t* destination, size_t count)
+{
+    /*Codes_SRS_MEMORY_DATA_01_001: [ read_uint16_array shall write in destination[i] the 2 bytes at source + 2 * i MSB first, for each i less than count. ]*/
+    size_t i = swap_bytes_16((unsigned char*)destination, source, count);
+    for (; i < count; i++)
+    {
+        destination[i] = memory_data_read_uint16(source + i * 2);
+    }
+}
+
+void read_uint32_array(const unsigned char* source, uint32_t* destination, size_t count)
+{
+    /*Codes_SRS_MEMORY_DATA_01_002: [ read_uint32_array shall write in destination[i] the 4 bytes at source + 4 * i MSB first, for each i less than count. ]*/
+    size_t i = swap_bytes_32((unsigned char*)destination, source, count);
+    for (; i < count; i++)
+    {
+        destination[i] = memory_data_read_uint32(source + i * 4);
+    }
+}
+
+void read_uint64_array(const unsigned char* source, uint64_t* destination, size_t count)
+{
+    /*Codes_SRS_MEMORY_DATA_01_003: [ read_uint64_array shall write in destination[i] the 8 bytes at source + 8 * i MSB first, for each i less than count. ]*/
+    size_t i = swap_bytes_64((unsigned char*)destination, source, count);
+    for (; i < count; i++)
+    {
+        destination[i] = memory_data_read_uint64(source + i * 8);
+    }
+}
+
+void write_uint16_array(unsigned char* destination, const uint16_t* source, size_t count)
+{
+    /*Codes_SRS_MEMORY_DATA_01_004: [ write_uint16_array shall write at destination + 2 * i the bytes of source[i] MSB first, for each i less than count. ]*/
+    size_t i = swap_bytes_16(destination, (const unsigned char*)source, count);
+    for (; i < count; i++)
+    {
+        memory_data_write_uint16(destination + i * 2, source[i]);
+    }
+}
+
+void write_uint32_array(unsigned char* destination, const uint32_t* source, size_t count)
+{
+    /*Codes_SRS_MEMORY_DATA_01_005: [ write_uint32_array shall write at destination + 4 * i the bytes of source[i] MSB first, for each i less than count. ]*/
+    size_t i = swap_bytes_32(destination, (const unsigned char*)source, count);
+    for (; i < count; i++)
+    {
+        memory_data_write_uint32(destination + i * 4, source[i]);
+    }
+}
+
+void write_uint64_array(unsigned char* destination, const uint64_t* source, size_t count)
+{
+    /*Codes_SRS_MEMORY_DATA_01_006: [ write_uint64_array shall write at destination + 8 * i the bytes of source[i] MSB first, for each i less than count. ]*/
+    size_t i = swap_bytes_64(destination, (const unsigned char*)source, count);
+    for (; i < count; i++)
+    {
+        memory_data_write_uint64(destination + i * 8, source[i]);
+    }
+}
@@ -0,0 +1,853 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/metrics.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+/*
+* The registry keeps the counters and the IO stacks in two arrays under registry_lock, which is
+* only taken to create, destroy, add, remove and take a snapshot: adding to a counter does not
+* touch it. The slots of a counter are allocated in one block, aligned on a cache line.
+*/
+#if defined(_MSC_VER)
+#include <windows.h>
+#define METRICS_THREAD_LOCAL __declspec(thread)
+#define METRICS_ADD64(value, addend) InterlockedExchangeAdd64((volatile LONG64*)&(value), (LONG64)(addend))
+#define METRICS_READ64(value) ((uint64_t)InterlockedCompareExchange64((volatile LONG64*)&(value), 0, 0))
+#define METRICS_NEXT_SLOT(value) ((unsigned long)InterlockedIncrement(&(value)))
+#else
+#define METRICS_THREAD_LOCAL __thread
+#define METRICS_ADD64(value, addend) __sync_fetch_and_add(&(value), (addend))
+#define METRICS_READ64(value) __sync_fetch_and_add(&(value), 0)
+#define METRICS_NEXT_SLOT(value) ((unsigned long)__sync_add_and_fetch(&(value), 1))
+#endif
+
+#define METRICS_NAME_PREFIX "aziotsharedutil_"
+
+typedef struct METRICS_COUNTER_SLOT_TAG
+{
+    volatile uint64_t value;
+    unsigned char padding[METRICS_CACHE_LINE_SIZE - sizeof(uint64_t)];
+} METRICS_COUNTER_SLOT;
+
+typedef struct METRICS_COUNTER_TAG
+{
+    METRICS_COUNTER_SLOT* slots;
+    void* slots_memory;
+    char* name;
+} METRICS_COUNTER;
+
+typedef struct METRICS_XIO_TAG
+{
+    XIO_HANDLE xio;
+    char* name;
+} METRICS_XIO;
+
+static LOCK_HANDLE registry_lock = NULL;
+static METRICS_COUNTER** registry_counters = NULL;
+static size_t registry_counter_count = 0;
+static METRICS_XIO* registry_xios = NULL;
+static size_t registry_xio_count = 0;
+
+/* the slot of the thread plus 1, 0 until the thread first adds to a counter */
+static METRICS_THREAD_LOCAL unsigned int thread_slot = 0;
+static volatile long last_thread_slot = 0;
+
+int metrics_init(void)
+{
+    int result;
+
+    if (registry_lock != NULL)
+    {
+        /* Codes_SRS_METRICS_01_002: [ If the registry is already initialized, metrics_init shall fail and return a non-zero value. ]*/
+        LogError("metrics already initialized");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_METRICS_01_001: [ metrics_init shall create the lock of the registry. ]*/
+    else if ((registry_lock = Lock_Init()) == NULL)
+    {
+        /* Codes_SRS_METRICS_01_003: [ If creating the lock fails, metrics_init shall fail and return a non-zero value. ]*/
+        LogError("Cannot create the metrics lock");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_METRICS_01_004: [ On success, metrics_init shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+void metrics_deinit(void)
+{
+    if (registry_lock == NULL)
+    {
+        LogError("metrics not initialized");
+    }
+    else
+    {
+        size_t i;
+
+        if ((registry_counter_count > 0) || (registry_xio_count > 0))
+        {
+            LogError("%lu counters and %lu IO stacks left in the metrics registry", (unsigned long)registry_counter_count, (unsigned long)registry_xio_count);
+        }
+
+        /* Codes_SRS_METRICS_01_005: [ metrics_deinit shall free the registry and its lock, the counters left in it staying usable until destroyed. ]*/
+        for (i = 0; i < registry_xio_count; i++)
+        {
+            free(registry_xios[i].name);
+        }
+
+        free(registry_xios);
+        registry_xios = NULL;
+        registry_xio_count = 0;
+        free(registry_counters);
+        registry_counters = NULL;
+        registry_counter_count = 0;
+        (void)Lock_Deinit(registry_lock);
+        registry_lock = NULL;
+    }
+}
+
+METRICS_COUNTER_HANDLE metrics_counter_create(const char* name)
+{
+    METRICS_COUNTER* result;
+
+    if (name == NULL)
+    {
+        /* Codes_SRS_METRICS_01_006: [ If name is NULL, metrics_counter_create shall fail and return NULL. ]*/
+        LogError("NULL name");
+        result = NULL;
+    }
+    else if (registry_lock == NULL)
+    {
+        /* Codes_SRS_METRICS_01_007: [ If the registry is not initialized, metrics_counter_create shall fail and return NULL. ]*/
+        LogError("metrics not initialized");
+        result = NULL;
+    }
+    else if ((result = (METRICS_COUNTER*)malloc(sizeof(METRICS_COUNTER))) == NULL)
+    {
+        /* Codes_SRS_METRICS_01_008: [ If any allocation fails, metrics_counter_create shall fail and return NULL. ]*/
+        LogError("Cannot allocate counter");
+    }
+    /* Codes_SRS_METRICS_01_009: [ metrics_counter_create shall allocate METRICS_COUNTER_SLOT_COUNT zeroed slots, each on its own cache line, and copy name. ]*/
+    else if ((result->slots_memory = calloc(1, (METRICS_COUNTER_SLOT_COUNT * sizeof(METRICS_COUNTER_SLOT)) + METRICS_CACHE_LINE_SIZE - 1)) == NULL)
+    {
+        /* Codes_SRS_METRICS_01_008: [ If any allocation fails, metrics_counter_create shall fail and return NULL. ]*/
+        LogError("Cannot allocate counter slots");
+        free(result);
+        result = NULL;
+    }
+    else if (mallocAndStrcpy_s(&result->name, name) != 0)
+    {
+        /* Codes_SRS_METRICS_01_008: [ If any allocation fails, metrics_counter_create shall fail and return NULL. ]*/
+        LogError("Cannot copy counter name");
+        free(result->slots_memory);
+        free(result);
+        result = NULL;
+    }
+    else
+    {
+        bool is_registered = false;
+
+        result->slots = (METRICS_COUNTER_SLOT*)(((uintptr_t)result->slots_memory + METRICS_CACHE_LINE_SIZE - 1) & ~(uintptr_t)(METRICS_CACHE_LINE_SIZE - 1));
+
+        /* Codes_SRS_METRICS_01_010: [ metrics_counter_create shall add the counter to the registry under its lock. ]*/
+        if (Lock(registry_lock) != LOCK_OK)
+        {
+            LogError("Cannot lock the metrics registry");
+        }
+        else
+        {
+            METRICS_COUNTER** new_counters = (METRICS_COUNTER**)realloc(registry_counters, (registry_counter_count + 1) * sizeof(METRICS_COUNTER*));
+            if (new_counters == NULL)
+            {
+                LogError("Cannot grow the counters of the metrics registry");
+            }
+            else
+            {
+                registry_counters = new_counters;
+                registry_counters[registry_counter_count] = result;
+                registry_counter_count++;
+                is_registered = true;
+            }
+
+            (void)Unlock(registry_lock);
+        }
+
+        if (!is_registered)
+        {
+            /* Codes_SRS_METRICS_01_011: [ If locking or growing the registry fails, metrics_counter_create shall fail and return NULL. ]*/
+            free(result->name);
+            free(result->slots_memory);
+            free(result);
+            result = NULL;
+        }
+    }
+
+    return result;
+}
+
+void metrics_counter_destroy(METRICS_COUNTER_HANDLE counter)
+{
+    if (counter == NULL)
+    {
+        /* Codes_SRS_METRICS_01_012: [ If counter is NULL, metrics_counter_destroy shall do nothing. ]*/
+        LogError("NULL counter");
+    }
+    else
+    {
+        /* Codes_SRS_METRICS_01_013: [ metrics_counter_destroy shall remove the counter from the registry under its lock and free it. ]*/
+        if ((registry_lock != NULL) &&
+            (Lock(registry_lock) == LOCK_OK))
+        {
+            size_t i;
+
+            for (i = 0; i < registry_counter_count; i++)
+            {
+                if (registry_counters[i] == counter)
+                {
+                    registry_counters[i] = registry_counters[registry_counter_count - 1];
+                    registry_counter_count--;
+                    break;
+                }
+            }
+
+            (void)Unlock(registry_lock);
+        }
+
+        free(counter->name);
+        free(counter->slots_memory);
+        free(counter);
+    }
+}
+
+void metrics_counter_add(METRICS_COUNTER_HANDLE counter, uint64_t value)
+{
+    if (counter != NULL)
+    {
+        /* Codes_SRS_METRICS_01_014: [ metrics_counter_add shall atomically add value to the slot of the calling thread, picked round robin the first time the thread adds to a counter. ]*/
+        if (thread_slot == 0)
+        {
+            thread_slot = (unsigned int)((METRICS_NEXT_SLOT(last_thread_slot) - 1) % METRICS_COUNTER_SLOT_COUNT) + 1;
+        }
+
+        (void)METRICS_ADD64(counter->slots[thread_slot - 1].value, value);
+    }
+}
+
+uint64_t metrics_counter_get(METRICS_COUNTER_HANDLE counter)
+{
+    uint64_t result = 0;
+
+    if (counter == NULL)
+    {
+        /* Codes_SRS_METRICS_01_015: [ If counter is NULL, metrics_counter_get shall return 0. ]*/
+        LogError("NULL counter");
+    }
+    else
+    {
+        size_t i;
+
+        /* Codes_SRS_METRICS_01_016: [ metrics_counter_get shall return the sum of the slots of the counter. ]*/
+        for (i = 0; i < METRICS_COUNTER_SLOT_COUNT; i++)
+        {
+            result += METRICS_READ64(counter->slots[i].value);
+        }
+    }
+
+    return result;
+}
+
+int metrics_add_xio(XIO_HANDLE xio, const char* name)
+{
+    int result;
+
+    if ((xio == NULL) ||
+        (name == NULL))
+    {
+        /* Codes_SRS_METRICS_01_017: [ If xio or name is NULL, metrics_add_xio shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: xio=%p, name=%p", xio, name);
+        result = __FAILURE__;
+    }
+    else if (registry_lock == NULL)
+    {
+        /* Codes_SRS_METRICS_01_018: [ If the registry is not initialized, metrics_add_xio shall fail and return a non-zero value. ]*/
+        LogError("metrics not initialized");
+        result = __FAILURE__;
+    }
+    else if (Lock(registry_lock) != LOCK_OK)
+    {
+        /* Codes_SRS_METRICS_01_019: [ If locking, growing the registry or copying name fails, metrics_add_xio shall fail and return a non-zero value. ]*/
+        LogError("Cannot lock the metrics registry");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_METRICS_01_020: [ metrics_add_xio shall add xio and a copy of name to the registry under its lock. ]*/
+        METRICS_XIO* new_xios = (METRICS_XIO*)realloc(registry_xios, (registry_xio_count + 1) * sizeof(METRICS_XIO));
+        if (new_xios == NULL)
+        {
+            /* Codes_SRS_METRICS_01_019: [ If locking, growing the registry or copying name fails, metrics_add_xio shall fail and return a non-zero value. ]*/
+            LogError("Cannot grow the IO stacks of the metrics registry");
+            result = __FAILURE__;
+        }
+        else
+        {
+            registry_xios = new_xios;
+            if (mallocAndStrcpy_s(&registry_xios[registry_xio_count].name, name) != 0)
+            {
+                /* Codes_SRS_METRICS_01_019: [ If locking, growing the registry or copying name fails, metrics_add_xio shall fail and return a non-zero value. ]*/
+                LogError("Cannot copy IO stack name");
+                result = __FAILURE__;
+            }
+            else
+            {
+                registry_xios[registry_xio_count].xio = xio;
+                registry_xio_count++;
+
+                /* Codes_SRS_METRICS_01_021: [ On success, metrics_add_xio shall return 0. ]*/
+                result = 0;
+            }
+        }
+
+        (void)Unlock(registry_lock);
+    }
+
+    return result;
+}
+
+void metrics_remove_xio(XIO_HANDLE xio)
+{
+    if (xio == NULL)
+    {
+        /* Codes_SRS_METRICS_01_022: [ If xio is NULL, metrics_remove_xio shall do nothing. ]*/
+        LogError("NULL xio");
+    }
+    else if ((registry_lock == NULL) ||
+        (Lock(registry_lock) != LOCK_OK))
+    {
+        LogError("Cannot lock the metrics registry");
+    }
+    else
+    {
+        size_t i;
+
+        /* Codes_SRS_METRICS_01_023: [ metrics_remove_xio shall remove xio from the registry under its lock. ]*/
+        for (i = 0; i < registry_xio_count; i++)
+        {
+            if (registry_xios[i].xio == xio)
+            {
+                free(registry_xios[i].name);
+                registry_xios[i] = registry_xios[registry_xio_count - 1];
+                registry_xio_count--;
+                break;
+            }
+        }
+
+        (void)Unlock(registry_lock);
+    }
+}
+
+static void collect_memory(METRICS_SNAPSHOT* snapshot)
+{
+#if defined(GB_DEBUG_ALLOC)
+    GBALLOC_STATISTICS statistics;
+
+    /* Codes_SRS_METRICS_01_026: [ When built with GB_DEBUG_ALLOC, metrics_snapshot_create shall fill the memory counters from gballoc_getCurrentMemoryUsed, gballoc_getMaximumMemoryUsed, gballoc_getAllocationCount and gballoc_getStatistics, and set has_memory, when gballoc_getStatistics succeeds. ]*/
+    if (gballoc_getStatistics(&statistics) == 0)
+    {
+        snapshot->has_memory = true;
+        snapshot->memory_current_bytes = gballoc_getCurrentMemoryUsed();
+        snapshot->memory_max_bytes = gballoc_getMaximumMemoryUsed();
+        snapshot->allocation_count = gballoc_getAllocationCount();
+        snapshot->realloc_count = statistics.realloc_count;
+        snapshot->realloc_moved_count = statistics.realloc_moved_count;
+        snapshot->realloc_moved_bytes = statistics.realloc_moved_bytes;
+    }
+#else
+    (void)snapshot;
+#endif
+}
+
+static void collect_locks(METRICS_SNAPSHOT* snapshot)
+{
+#if defined(LOCK_PROFILING)
+    size_t profile_count;
+
+    /* Codes_SRS_METRICS_01_027: [ When built with LOCK_PROFILING, metrics_snapshot_create shall sum the entries of Lock_GetProfiles and set has_locks. ]*/
+    if (Lock_GetProfiles(NULL, 0, &profile_count) == 0)
+    {
+        LOCK_PROFILE_INFO* profiles = (profile_count == 0) ? NULL : (LOCK_PROFILE_INFO*)malloc(profile_count * sizeof(LOCK_PROFILE_INFO));
+        size_t filled_count = profile_count;
+
+        if ((profile_count > 0) &&
+            ((profiles == NULL) || (Lock_GetProfiles(profiles, profile_count, &filled_count) != 0)))
+        {
+            LogError("Cannot read the lock profiles");
+        }
+        else
+        {
+            size_t i;
+
+            snapshot->has_locks = true;
+            for (i = 0; (i < profile_count) && (i < filled_count); i++)
+            {
+                snapshot->lock_count += profiles[i].lock_count;
+                snapshot->lock_acquisition_count += profiles[i].acquisition_count;
+                snapshot->lock_contended_count += profiles[i].contended_count;
+                snapshot->lock_total_wait_ns += profiles[i].total_wait_ns;
+                if (profiles[i].max_wait_ns > snapshot->lock_max_wait_ns)
+                {
+                    snapshot->lock_max_wait_ns = profiles[i].max_wait_ns;
+                }
+            }
+        }
+
+        free(profiles);
+    }
+#else
+    (void)snapshot;
+#endif
+}
+
+// Must be called with registry_lock held.
+static int collect_registry(METRICS_SNAPSHOT* snapshot)
+{
+    int result = 0;
+    size_t i;
+
+    if ((registry_counter_count > 0) &&
+        ((snapshot->counters = (METRICS_COUNTER_VALUE*)calloc(registry_counter_count, sizeof(METRICS_COUNTER_VALUE))) == NULL))
+    {
+        LogError("Cannot allocate the counters of the snapshot");
+        result = __FAILURE__;
+    }
+    else if ((registry_xio_count > 0) &&
+        ((snapshot->xio_layers = (METRICS_XIO_LAYER*)calloc(registry_xio_count * METRICS_MAX_XIO_LAYERS, sizeof(METRICS_XIO_LAYER))) == NULL))
+    {
+        LogError("Cannot allocate the IO layers of the snapshot");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_METRICS_01_028: [ metrics_snapshot_create shall copy the name and the value of each counter of the registry. ]*/
+        for (i = 0; i < registry_counter_count; i++)
+        {
+            if (mallocAndStrcpy_s((char**)&snapshot->counters[snapshot->counter_count].name, registry_counters[i]->name) != 0)
+            {
+                LogError("Cannot copy the name of a counter");
+                result = __FAILURE__;
+                break;
+            }
+
+            snapshot->counters[snapshot->counter_count].value = metrics_counter_get(registry_counters[i]);
+            snapshot->counter_count++;
+        }
+
+        /* Codes_SRS_METRICS_01_029: [ metrics_snapshot_create shall read up to METRICS_MAX_XIO_LAYERS layers of each IO stack of the registry with xio_get_stats, leaving out the stacks for which it fails. ]*/
+        for (i = 0; (result == 0) && (i < registry_xio_count); i++)
+        {
+            XIO_STATS stats[METRICS_MAX_XIO_LAYERS];
+            size_t layer_count;
+
+            if (xio_get_stats(registry_xios[i].xio, stats, METRICS_MAX_XIO_LAYERS, &layer_count) != 0)
+            {
+                LogError("Cannot read the counters of the IO stack %s", registry_xios[i].name);
+            }
+            else
+            {
+                size_t j;
+                char* io_name;
+
+                if (mallocAndStrcpy_s(&io_name, registry_xios[i].name) != 0)
+                {
+                    LogError("Cannot copy the name of an IO stack");
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    /* the first layer of the stack owns the copy of the name */
+                    for (j = 0; (j < layer_count) && (j < METRICS_MAX_XIO_LAYERS); j++)
+                    {
+                        snapshot->xio_layers[snapshot->xio_layer_count].io_name = io_name;
+                        snapshot->xio_layers[snapshot->xio_layer_count].stats = stats[j];
+                        snapshot->xio_layer_count++;
+                    }
+
+                    if (j == 0)
+                    {
+                        free(io_name);
+                    }
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+METRICS_SNAPSHOT* metrics_snapshot_create(void)
+{
+    METRICS_SNAPSHOT* result;
+
+    if (registry_lock == NULL)
+    {
+        /* Codes_SRS_METRICS_01_024: [ If the registry is not initialized, metrics_snapshot_create shall fail and return NULL. ]*/
+        LogError("metrics not initialized");
+        result = NULL;
+    }
+    else if ((result = (METRICS_SNAPSHOT*)calloc(1, sizeof(METRICS_SNAPSHOT))) == NULL)
+    {
+        /* Codes_SRS_METRICS_01_025: [ If any allocation or locking the registry fails, metrics_snapshot_create shall fail and return NULL. ]*/
+        LogError("Cannot allocate snapshot");
+    }
+    else
+    {
+        collect_memory(result);
+        collect_locks(result);
+
+        if (Lock(registry_lock) != LOCK_OK)
+        {
+            /* Codes_SRS_METRICS_01_025: [ If any allocation or locking the registry fails, metrics_snapshot_create shall fail and return NULL. ]*/
+            LogError("Cannot lock the metrics registry");
+            metrics_snapshot_destroy(result);
+            result = NULL;
+        }
+        else
+        {
+            int collect_result = collect_registry(result);
+
+            (void)Unlock(registry_lock);
+
+            if (collect_result != 0)
+            {
+                /* Codes_SRS_METRICS_01_025: [ If any allocation or locking the registry fails, metrics_snapshot_create shall fail and return NULL. ]*/
+                metrics_snapshot_destroy(result);
+                result = NULL;
+            }
+        }
+    }
+
+    return result;
+}
+
+void metrics_snapshot_destroy(METRICS_SNAPSHOT* snapshot)
+{
+    if (snapshot == NULL)
+    {
+        /* Codes_SRS_METRICS_01_030: [ If snapshot is NULL, metrics_snapshot_destroy shall do nothing. ]*/
+        LogError("NULL snapshot");
+    }
+    else
+    {
+        size_t i;
+
+        /* Codes_SRS_METRICS_01_031: [ metrics_snapshot_destroy shall free the snapshot and the names copied into it. ]*/
+        for (i = 0; i < snapshot->counter_count; i++)
+        {
+            free((void*)snapshot->counters[i].name);
+        }
+
+        for (i = 0; i < snapshot->xio_layer_count; i++)
+        {
+            if ((i == 0) || (snapshot->xio_layers[i].io_name != snapshot->xio_layers[i - 1].io_name))
+            {
+                free((void*)snapshot->xio_layers[i].io_name);
+            }
+        }
+
+        free(snapshot->counters);
+        free(snapshot->xio_layers);
+        free(snapshot);
+    }
+}
+
+typedef struct METRICS_VALUE_TAG
+{
+    /* the Prometheus name, without the prefix */
+    const char* name;
+    const char* json_name;
+    /* counter or gauge */
+    const char* type;
+    uint64_t value;
+} METRICS_VALUE;
+
+typedef struct METRICS_XIO_FIELD_TAG
+{
+    const char* name;
+    const char* json_name;
+    const char* type;
+    size_t offset;
+} METRICS_XIO_FIELD;
+
+static const METRICS_XIO_FIELD xio_fields[] =
+{
+    { "xio_bytes_sent_total", "bytes_sent", "counter", offsetof(XIO_STATS, bytes_sent) },
+    { "xio_bytes_received_total", "bytes_received", "counter", offsetof(XIO_STATS, bytes_received) },
+    { "xio_sends_total", "send_count", "counter", offsetof(XIO_STATS, send_count) },
+    { "xio_queued_sends_total", "queued_send_count", "counter", offsetof(XIO_STATS, queued_send_count) },
+    { "xio_pending_sends", "pending_send_count", "gauge", offsetof(XIO_STATS, pending_send_count) },
+    { "xio_doworks_total", "dowork_count", "counter", offsetof(XIO_STATS, dowork_count) },
+    { "xio_idle_doworks_total", "idle_dowork_count", "counter", offsetof(XIO_STATS, idle_dowork_count) },
+    { "xio_callbacks_total", "callback_count", "counter", offsetof(XIO_STATS, callback_count) },
+    { "xio_time_microseconds_total", "time_us", "counter", offsetof(XIO_STATS, time_us) }
+};
+
+static uint64_t get_xio_field(const XIO_STATS* stats, const METRICS_XIO_FIELD* field)
+{
+    return *(const uint64_t*)(const void*)((const unsigned char*)stats + field->offset);
+}
+
+static size_t get_values(const METRICS_SNAPSHOT* snapshot, METRICS_VALUE* values)
+{
+    size_t count = 0;
+
+    if (snapshot->has_memory)
+    {
+        const METRICS_VALUE memory_values[] =
+        {
+            { "memory_current_bytes", "memory_current_bytes", "gauge", (uint64_t)snapshot->memory_current_bytes },
+            { "memory_max_bytes", "memory_max_bytes", "gauge", (uint64_t)snapshot->memory_max_bytes },
+            { "allocations", "allocation_count", "gauge", (uint64_t)snapshot->allocation_count },
+            { "reallocs_total", "realloc_count", "counter", (uint64_t)snapshot->realloc_count },
+            { "realloc_moves_total", "realloc_moved_count", "counter", (uint64_t)snapshot->realloc_moved_count },
+            { "realloc_moved_bytes_total", "realloc_moved_bytes", "counter", (uint64_t)snapshot->realloc_moved_bytes }
+        };
+
+        (void)memcpy(values + count, memory_values, sizeof(memory_values));
+        count += sizeof(memory_values) / sizeof(memory_values[0]);
+    }
+
+    if (snapshot->has_locks)
+    {
+        const METRICS_VALUE lock_values[] =
+        {
+            { "locks", "lock_count", "gauge", (uint64_t)snapshot->lock_count },
+            { "lock_acquisitions_total", "lock_acquisition_count", "counter", snapshot->lock_acquisition_count },
+            { "lock_contentions_total", "lock_contended_count", "counter", snapshot->lock_contended_count },
+            { "lock_wait_nanoseconds_total", "lock_total_wait_ns", "counter", snapshot->lock_total_wait_ns },
+            { "lock_max_wait_nanoseconds", "lock_max_wait_ns", "gauge", snapshot->lock_max_wait_ns }
+        };
+
+        (void)memcpy(values + count, lock_values, sizeof(lock_values));
+        count += sizeof(lock_values) / sizeof(lock_values[0]);
+    }
+
+    return count;
+}
+
+/* the label values of the text format escape the backslash, the double quote and the line feed */
+static int concat_label_value(STRING_HANDLE text, const char* value)
+{
+    int result = 0;
+    const char* start = value;
+    const char* current;
+
+    for (current = value; (result == 0) && (*current != '\0'); current++)
+    {
+        const char* escape = (*current == '\\') ? "\\\\" : (*current == '"') ? "\\\"" : (*current == '\n') ? "\\n" : NULL;
+
+        if (escape != NULL)
+        {
+            if (((current > start) && (STRING_sprintf(text, "%.*s", (int)(current - start), start) != 0)) ||
+                (STRING_concat(text, escape) != 0))
+            {
+                result = __FAILURE__;
+            }
+
+            start = current + 1;
+        }
+    }
+
+    if ((result == 0) &&
+        (current > start) &&
+        (STRING_concat(text, start) != 0))
+    {
+        result = __FAILURE__;
+    }
+
+    return result;
+}
+
+static int format_prometheus(const METRICS_SNAPSHOT* snapshot, STRING_HANDLE text)
+{
+    int result = 0;
+    METRICS_VALUE values[16];
+    size_t value_count = get_values(snapshot, values);
+    size_t i;
+    size_t j;
+
+    for (i = 0; (result == 0) && (i < value_count); i++)
+    {
+        if (STRING_sprintf(text, "# TYPE " METRICS_NAME_PREFIX "%s %s\n" METRICS_NAME_PREFIX "%s %llu\n", values[i].name, values[i].type, values[i].name, (unsigned long long)values[i].value) != 0)
+        {
+            result = __FAILURE__;
+        }
+    }
+
+    /* the samples of a metric are grouped under its TYPE line */
+    for (i = 0; (result == 0) && (snapshot->xio_layer_count > 0) && (i < sizeof(xio_fields) / sizeof(xio_fields[0])); i++)
+    {
+        size_t depth = 0;
+
+        if (STRING_sprintf(text, "# TYPE " METRICS_NAME_PREFIX "%s %s\n", xio_fields[i].name, xio_fields[i].type) != 0)
+        {
+            result = __FAILURE__;
+        }
+
+        for (j = 0; (result == 0) && (j < snapshot->xio_layer_count); j++)
+        {
+            depth = ((j == 0) || (snapshot->xio_layers[j].io_name != snapshot->xio_layers[j - 1].io_name)) ? 0 : depth + 1;
+
+            if ((STRING_sprintf(text, METRICS_NAME_PREFIX "%s{io=\"", xio_fields[i].name) != 0) ||
+                (concat_label_value(text, snapshot->xio_layers[j].io_name) != 0) ||
+                (STRING_concat(text, "\",layer=\"") != 0) ||
+                (concat_label_value(text, (snapshot->xio_layers[j].stats.layer_name == NULL) ? "" : snapshot->xio_layers[j].stats.layer_name) != 0) ||
+                (STRING_sprintf(text, "\",depth=\"%lu\"} %llu\n", (unsigned long)depth, (unsigned long long)get_xio_field(&snapshot->xio_layers[j].stats, &xio_fields[i])) != 0))
+            {
+                result = __FAILURE__;
+            }
+        }
+    }
+
+    if ((result == 0) &&
+        (snapshot->counter_count > 0) &&
+        (STRING_concat(text, "# TYPE " METRICS_NAME_PREFIX "counter_total counter\n") != 0))
+    {
+        result = __FAILURE__;
+    }
+
+    for (i = 0; (result == 0) && (i < snapshot->counter_count); i++)
+    {
+        if ((STRING_concat(text, METRICS_NAME_PREFIX "counter_total{name=\"") != 0) ||
+            (concat_label_value(text, snapshot->counters[i].name) != 0) ||
+            (STRING_sprintf(text, "\"} %llu\n", (unsigned long long)snapshot->counters[i].value) != 0))
+        {
+            result = __FAILURE__;
+        }
+    }
+
+    return result;
+}
+
+static int format_json(const METRICS_SNAPSHOT* snapshot, STRING_HANDLE text)
+{
+    int result = 0;
+    METRICS_VALUE values[16];
+    size_t value_count = get_values(snapshot, values);
+    size_t i;
+    size_t j;
+
+    if (STRING_concat(text, "{") != 0)
+    {
+        result = __FAILURE__;
+    }
+
+    for (i = 0; (result == 0) && (i < value_count); i++)
+    {
+        if (STRING_sprintf(text, "\"%s\":%llu,", values[i].json_name, (unsigned long long)values[i].value) != 0)
+        {
+            result = __FAILURE__;
+        }
+    }
+
+    if ((result == 0) &&
+        (STRING_concat(text, "\"xio\":[") != 0))
+    {
+        result = __FAILURE__;
+    }
+
+    for (i = 0; (result == 0) && (i < snapshot->xio_layer_count); i++)
+    {
+        if ((STRING_concat(text, (i == 0) ? "{\"io\":" : ",{\"io\":") != 0) ||
+            (STRING_concat_JSON(text, snapshot->xio_layers[i].io_name) != 0) ||
+            (STRING_concat(text, ",\"layer\":") != 0) ||
+            (STRING_concat_JSON(text, (snapshot->xio_layers[i].stats.layer_name == NULL) ? "" : snapshot->xio_layers[i].stats.layer_name) != 0))
+        {
+            result = __FAILURE__;
+        }
+
+        for (j = 0; (result == 0) && (j < sizeof(xio_fields) / sizeof(xio_fields[0])); j++)
+        {
+            if (STRING_sprintf(text, ",\"%s\":%llu", xio_fields[j].json_name, (unsigned long long)get_xio_field(&snapshot->xio_layers[i].stats, &xio_fields[j])) != 0)
+            {
+                result = __FAILURE__;
+            }
+        }
+
+        if ((result == 0) &&
+            (STRING_concat(text, "}") != 0))
+        {
+            result = __FAILURE__;
+        }
+    }
+
+    if ((result == 0) &&
+        (STRING_concat(text, "],\"counters\":{") != 0))
+    {
+        result = __FAILURE__;
+    }
+
+    for (i = 0; (result == 0) && (i < snapshot->counter_count); i++)
+    {
+        if (((i > 0) && (STRING_concat(text, ",") != 0)) ||
+            (STRING_concat_JSON(text, snapshot->counters[i].name) != 0) ||
+            (STRING_sprintf(text, ":%llu", (unsigned long long)snapshot->counters[i].value) != 0))
+        {
+            result = __FAILURE__;
+        }
+    }
+
+    if ((result == 0) &&
+        (STRING_concat(text, "}}") != 0))
+    {
+        result = __FAILURE__;
+    }
+
+    return result;
+}
+
+STRING_HANDLE metrics_snapshot_format(const METRICS_SNAPSHOT* snapshot, METRICS_FORMAT format)
+{
+    STRING_HANDLE result;
+
+    if ((snapshot == NULL) ||
+        ((format != METRICS_FORMAT_PROMETHEUS) && (format != METRICS_FORMAT_JSON)))
+    {
+        /* Codes_SRS_METRICS_01_032: [ If snapshot is NULL or format is unknown, metrics_snapshot_format shall fail and return NULL. ]*/
+        LogError("Invalid arguments: snapshot=%p, format=%d", snapshot, (int)format);
+        result = NULL;
+    }
+    else if ((result = STRING_new()) == NULL)
+    {
+        /* Codes_SRS_METRICS_01_035: [ If building the text fails, metrics_snapshot_format shall fail and return NULL. ]*/
+        LogError("Cannot create the metrics text");
+    }
+    /* Codes_SRS_METRICS_01_033: [ With METRICS_FORMAT_PROMETHEUS, metrics_snapshot_format shall write one TYPE line per metric followed by its samples, the names prefixed by aziotsharedutil_, the IO layers labelled with io, layer and depth and the counters with name. ]*/
+    /* Codes_SRS_METRICS_01_034: [ With METRICS_FORMAT_JSON, metrics_snapshot_format shall write one object with the memory and lock values, an xio array with one object per layer and a counters object. ]*/
+    else if (((format == METRICS_FORMAT_PROMETHEUS) ? format_prometheus(snapshot, result) : format_json(snapshot, result)) != 0)
+    {
+        /* Codes_SRS_METRICS_01_035: [ If building the text fails, metrics_snapshot_format shall fail and return NULL. ]*/
+        LogError("Cannot format the metrics");
+        STRING_delete(result);
+        result = NULL;
+    }
+    else
+    {
+        /* all fine */
+    }
+
+    return result;
+}
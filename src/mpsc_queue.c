@@ -0,0 +1,169 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stddef.h>
+#include "azure_c_shared_utility/mpsc_queue.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+/*
+* The queue is a singly linked list that producers append to by swapping head, after
+* which they link the previous head to their entry. The consumer reads from tail.
+* A stub entry is pushed whenever the consumer would otherwise take the last entry,
+* so the list is never empty and the producers never have to touch tail.
+*
+* Every atomic access is sequentially consistent, except for the link store which only has
+* to publish the entry: mpsc_wait_queue relies on a push and a consumer checking for
+* emptiness never missing each other.
+*/
+#if defined(_MSC_VER)
+#include <windows.h>
+#define MPSC_QUEUE_EXCHANGE(target, value) ((MPSC_QUEUE_ENTRY*)InterlockedExchangePointer((PVOID volatile*)(target), (value)))
+#define MPSC_QUEUE_STORE(target, value) ((void)InterlockedExchangePointer((PVOID volatile*)(target), (value)))
+#define MPSC_QUEUE_LOAD(source) ((MPSC_QUEUE_ENTRY*)InterlockedCompareExchangePointer((PVOID volatile*)(source), NULL, NULL))
+#elif defined(__ATOMIC_SEQ_CST)
+#define MPSC_QUEUE_EXCHANGE(target, value) __atomic_exchange_n((target), (value), __ATOMIC_SEQ_CST)
+#define MPSC_QUEUE_STORE(target, value) __atomic_store_n((target), (value), __ATOMIC_RELEASE)
+#define MPSC_QUEUE_LOAD(source) __atomic_load_n((source), __ATOMIC_SEQ_CST)
+#else
+/*__sync_lock_test_and_set is only an acquire barrier, the full barrier in front of it publishes the entry*/
+#define MPSC_QUEUE_EXCHANGE(target, value) (__sync_synchronize(), (MPSC_QUEUE_ENTRY*)__sync_lock_test_and_set((target), (value)))
+#define MPSC_QUEUE_STORE(target, value) ((void)__sync_lock_test_and_set((target), (value)))
+#define MPSC_QUEUE_LOAD(source) ((MPSC_QUEUE_ENTRY*)__sync_val_compare_and_swap((source), NULL, NULL))
+#endif
+
+static void push_entry(MPSC_QUEUE* queue, MPSC_QUEUE_ENTRY* entry)
+{
+    MPSC_QUEUE_ENTRY* previous_head;
+
+    entry->next = NULL;
+    previous_head = MPSC_QUEUE_EXCHANGE(&queue->head, entry);
+
+    /*until this store the consumer cannot see the entry, mpsc_queue_is_empty still counts it*/
+    MPSC_QUEUE_STORE(&previous_head->next, entry);
+}
+
+void mpsc_queue_init(MPSC_QUEUE* queue)
+{
+    if (queue == NULL)
+    {
+        /*Codes_SRS_MPSC_QUEUE_01_001: [ If queue is NULL, mpsc_queue_init shall return. ]*/
+        LogError("invalid argument MPSC_QUEUE* queue=%p", queue);
+    }
+    else
+    {
+        /*Codes_SRS_MPSC_QUEUE_01_002: [ mpsc_queue_init shall initialize queue as an empty queue. ]*/
+        queue->stub.next = NULL;
+        queue->head = &queue->stub;
+        queue->tail = &queue->stub;
+    }
+}
+
+int mpsc_queue_push(MPSC_QUEUE* queue, MPSC_QUEUE_ENTRY* entry)
+{
+    int result;
+
+    if (
+        /*Codes_SRS_MPSC_QUEUE_01_003: [ If queue is NULL, mpsc_queue_push shall fail and return a non-zero value. ]*/
+        (queue == NULL) ||
+        /*Codes_SRS_MPSC_QUEUE_01_004: [ If entry is NULL, mpsc_queue_push shall fail and return a non-zero value. ]*/
+        (entry == NULL)
+        )
+    {
+        LogError("invalid arguments MPSC_QUEUE* queue=%p, MPSC_QUEUE_ENTRY* entry=%p", queue, entry);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_MPSC_QUEUE_01_005: [ mpsc_queue_push shall add entry at the end of queue without taking any lock. ]*/
+        push_entry(queue, entry);
+
+        /*Codes_SRS_MPSC_QUEUE_01_006: [ mpsc_queue_push shall succeed and return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+MPSC_QUEUE_ENTRY* mpsc_queue_pop(MPSC_QUEUE* queue)
+{
+    MPSC_QUEUE_ENTRY* result;
+
+    if (queue == NULL)
+    {
+        /*Codes_SRS_MPSC_QUEUE_01_007: [ If queue is NULL, mpsc_queue_pop shall fail and return NULL. ]*/
+        LogError("invalid argument MPSC_QUEUE* queue=%p", queue);
+        result = NULL;
+    }
+    else
+    {
+        MPSC_QUEUE_ENTRY* tail = queue->tail;
+        MPSC_QUEUE_ENTRY* next = MPSC_QUEUE_LOAD(&tail->next);
+
+        if (tail == &queue->stub)
+        {
+            if (next == NULL)
+            {
+                /*Codes_SRS_MPSC_QUEUE_01_008: [ If queue is empty, mpsc_queue_pop shall return NULL. ]*/
+                result = NULL;
+                goto all_ok;
+            }
+
+            /*the stub is not an entry, step over it*/
+            queue->tail = next;
+            tail = next;
+            next = MPSC_QUEUE_LOAD(&tail->next);
+        }
+
+        if (next != NULL)
+        {
+            /*Codes_SRS_MPSC_QUEUE_01_009: [ mpsc_queue_pop shall remove the entry at the front of queue and return it. ]*/
+            queue->tail = next;
+            result = tail;
+        }
+        else if (tail != MPSC_QUEUE_LOAD(&queue->head))
+        {
+            /*Codes_SRS_MPSC_QUEUE_01_010: [ If the push of the entry following the front entry has not finished linking it, mpsc_queue_pop shall return NULL. ]*/
+            result = NULL;
+        }
+        else
+        {
+            /*tail is the only entry: put the stub behind it so that it can be taken*/
+            push_entry(queue, &queue->stub);
+            next = MPSC_QUEUE_LOAD(&tail->next);
+            if (next != NULL)
+            {
+                /*Codes_SRS_MPSC_QUEUE_01_009: [ mpsc_queue_pop shall remove the entry at the front of queue and return it. ]*/
+                queue->tail = next;
+                result = tail;
+            }
+            else
+            {
+                /*Codes_SRS_MPSC_QUEUE_01_010: [ If the push of the entry following the front entry has not finished linking it, mpsc_queue_pop shall return NULL. ]*/
+                result = NULL;
+            }
+        }
+    }
+
+all_ok:
+    return result;
+}
+
+int mpsc_queue_is_empty(MPSC_QUEUE* queue)
+{
+    int result;
+
+    if (queue == NULL)
+    {
+        /*Codes_SRS_MPSC_QUEUE_01_011: [ If queue is NULL, mpsc_queue_is_empty shall return a non-zero value. ]*/
+        LogError("invalid argument MPSC_QUEUE* queue=%p", queue);
+        result = 1;
+    }
+    else
+    {
+        /*Codes_SRS_MPSC_QUEUE_01_012: [ mpsc_queue_is_empty shall return a non-zero value if no entry was pushed that was not popped yet, including entries whose push has not finished, and 0 otherwise. ]*/
+        result = (queue->tail == &queue->stub) && (MPSC_QUEUE_LOAD(&queue->head) == &queue->stub);
+    }
+
+    return result;
+}
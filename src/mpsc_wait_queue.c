@@ -0,0 +1,289 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/mpsc_wait_queue.h"
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+/*
+* The consumer raises waiting (under the lock) before it checks the queue one last time
+* and waits, a producer checks waiting after its push. Both are full barriers, so either
+* the consumer sees the entry or the producer sees the consumer waiting and posts the
+* condition, taking the lock to make sure the consumer is really waiting by then.
+* Wakes are recorded in wake_pending the same way.
+*/
+#if defined(_MSC_VER)
+#include <windows.h>
+#define MPSC_WAIT_QUEUE_SET_FLAG(flag) ((void)InterlockedOr(&(flag), 1))
+#define MPSC_WAIT_QUEUE_TAKE_FLAG(flag) InterlockedAnd(&(flag), 0)
+#define MPSC_WAIT_QUEUE_READ_FLAG(flag) InterlockedCompareExchange(&(flag), 0, 0)
+#else
+#define MPSC_WAIT_QUEUE_SET_FLAG(flag) ((void)__sync_fetch_and_or(&(flag), 1))
+#define MPSC_WAIT_QUEUE_TAKE_FLAG(flag) __sync_fetch_and_and(&(flag), 0)
+#define MPSC_WAIT_QUEUE_READ_FLAG(flag) __sync_fetch_and_add(&(flag), 0)
+#endif
+
+typedef struct MPSC_WAIT_QUEUE_TAG
+{
+    MPSC_QUEUE queue;
+    LOCK_HANDLE lock;
+    COND_HANDLE condition;
+    volatile long waiting;
+    volatile long wake_pending;
+} MPSC_WAIT_QUEUE;
+
+static int post_if_waiting(MPSC_WAIT_QUEUE* mpsc_wait_queue)
+{
+    int result;
+
+    if (MPSC_WAIT_QUEUE_READ_FLAG(mpsc_wait_queue->waiting) == 0)
+    {
+        result = 0;
+    }
+    else if (Lock(mpsc_wait_queue->lock) != LOCK_OK)
+    {
+        LogError("failure in Lock");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (Condition_Post(mpsc_wait_queue->condition) != COND_OK)
+        {
+            LogError("failure in Condition_Post");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+
+        (void)Unlock(mpsc_wait_queue->lock);
+    }
+
+    return result;
+}
+
+/*an entry whose push is half way through is linked within a few instructions, wait for it*/
+static MPSC_QUEUE_ENTRY* pop_entry(MPSC_WAIT_QUEUE* mpsc_wait_queue)
+{
+    MPSC_QUEUE_ENTRY* result;
+
+    while (((result = mpsc_queue_pop(&mpsc_wait_queue->queue)) == NULL) &&
+        !mpsc_queue_is_empty(&mpsc_wait_queue->queue))
+    {
+    }
+
+    return result;
+}
+
+MPSC_WAIT_QUEUE_HANDLE mpsc_wait_queue_create(void)
+{
+    /*Codes_SRS_MPSC_WAIT_QUEUE_01_001: [ mpsc_wait_queue_create shall allocate memory for a new queue. ]*/
+    MPSC_WAIT_QUEUE* result = (MPSC_WAIT_QUEUE*)malloc(sizeof(MPSC_WAIT_QUEUE));
+    if (result == NULL)
+    {
+        /*Codes_SRS_MPSC_WAIT_QUEUE_01_005: [ If any failure occurs, mpsc_wait_queue_create shall fail and return NULL. ]*/
+        LogError("failure in malloc(sizeof(MPSC_WAIT_QUEUE)=%lu)", (unsigned long)sizeof(MPSC_WAIT_QUEUE));
+    }
+    else
+    {
+        /*Codes_SRS_MPSC_WAIT_QUEUE_01_002: [ mpsc_wait_queue_create shall create a lock and a condition. ]*/
+        result->lock = Lock_Init();
+        if (result->lock == NULL)
+        {
+            /*Codes_SRS_MPSC_WAIT_QUEUE_01_005: [ If any failure occurs, mpsc_wait_queue_create shall fail and return NULL. ]*/
+            LogError("failure in Lock_Init");
+        }
+        else
+        {
+            result->condition = Condition_Init();
+            if (result->condition == NULL)
+            {
+                /*Codes_SRS_MPSC_WAIT_QUEUE_01_005: [ If any failure occurs, mpsc_wait_queue_create shall fail and return NULL. ]*/
+                LogError("failure in Condition_Init");
+            }
+            else
+            {
+                /*Codes_SRS_MPSC_WAIT_QUEUE_01_003: [ mpsc_wait_queue_create shall initialize the queue as empty. ]*/
+                mpsc_queue_init(&result->queue);
+                result->waiting = 0;
+                result->wake_pending = 0;
+
+                /*Codes_SRS_MPSC_WAIT_QUEUE_01_004: [ mpsc_wait_queue_create shall succeed and return a non-NULL value. ]*/
+                goto all_ok;
+            }
+            (void)Lock_Deinit(result->lock);
+        }
+        free(result);
+        result = NULL;
+    }
+all_ok:
+    return result;
+}
+
+void mpsc_wait_queue_destroy(MPSC_WAIT_QUEUE_HANDLE mpsc_wait_queue)
+{
+    if (mpsc_wait_queue == NULL)
+    {
+        /*Codes_SRS_MPSC_WAIT_QUEUE_01_006: [ If mpsc_wait_queue is NULL, mpsc_wait_queue_destroy shall return. ]*/
+        LogError("invalid argument MPSC_WAIT_QUEUE_HANDLE mpsc_wait_queue=%p", mpsc_wait_queue);
+    }
+    else
+    {
+        /*Codes_SRS_MPSC_WAIT_QUEUE_01_007: [ mpsc_wait_queue_destroy shall free the condition, the lock and the memory of the queue, without touching the entries in it. ]*/
+        Condition_Deinit(mpsc_wait_queue->condition);
+        (void)Lock_Deinit(mpsc_wait_queue->lock);
+        free(mpsc_wait_queue);
+    }
+}
+
+int mpsc_wait_queue_push(MPSC_WAIT_QUEUE_HANDLE mpsc_wait_queue, MPSC_QUEUE_ENTRY* entry)
+{
+    int result;
+
+    if (
+        /*Codes_SRS_MPSC_WAIT_QUEUE_01_008: [ If mpsc_wait_queue or entry is NULL, mpsc_wait_queue_push shall fail and return a non-zero value. ]*/
+        (mpsc_wait_queue == NULL) ||
+        (entry == NULL)
+        )
+    {
+        LogError("invalid arguments MPSC_WAIT_QUEUE_HANDLE mpsc_wait_queue=%p, MPSC_QUEUE_ENTRY* entry=%p", mpsc_wait_queue, entry);
+        result = __FAILURE__;
+    }
+    /*Codes_SRS_MPSC_WAIT_QUEUE_01_009: [ mpsc_wait_queue_push shall add entry at the end of the queue with mpsc_queue_push. ]*/
+    else if (mpsc_queue_push(&mpsc_wait_queue->queue, entry) != 0)
+    {
+        /*Codes_SRS_MPSC_WAIT_QUEUE_01_012: [ If any failure occurs, mpsc_wait_queue_push shall fail and return a non-zero value. ]*/
+        LogError("failure in mpsc_queue_push");
+        result = __FAILURE__;
+    }
+    /*Codes_SRS_MPSC_WAIT_QUEUE_01_010: [ If the consumer is waiting, mpsc_wait_queue_push shall post the condition while holding the lock. ]*/
+    else if (post_if_waiting(mpsc_wait_queue) != 0)
+    {
+        /*Codes_SRS_MPSC_WAIT_QUEUE_01_012: [ If any failure occurs, mpsc_wait_queue_push shall fail and return a non-zero value. ]*/
+        LogError("failure waking the consumer");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_MPSC_WAIT_QUEUE_01_011: [ mpsc_wait_queue_push shall succeed and return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+MPSC_QUEUE_ENTRY* mpsc_wait_queue_try_pop(MPSC_WAIT_QUEUE_HANDLE mpsc_wait_queue)
+{
+    MPSC_QUEUE_ENTRY* result;
+
+    if (mpsc_wait_queue == NULL)
+    {
+        /*Codes_SRS_MPSC_WAIT_QUEUE_01_013: [ If mpsc_wait_queue is NULL, mpsc_wait_queue_try_pop shall fail and return NULL. ]*/
+        LogError("invalid argument MPSC_WAIT_QUEUE_HANDLE mpsc_wait_queue=%p", mpsc_wait_queue);
+        result = NULL;
+    }
+    else
+    {
+        /*Codes_SRS_MPSC_WAIT_QUEUE_01_014: [ mpsc_wait_queue_try_pop shall remove and return the entry at the front of the queue, or return NULL if the queue is empty. ]*/
+        result = pop_entry(mpsc_wait_queue);
+    }
+
+    return result;
+}
+
+MPSC_QUEUE_ENTRY* mpsc_wait_queue_pop(MPSC_WAIT_QUEUE_HANDLE mpsc_wait_queue, int timeout_milliseconds)
+{
+    MPSC_QUEUE_ENTRY* result;
+
+    if (
+        /*Codes_SRS_MPSC_WAIT_QUEUE_01_015: [ If mpsc_wait_queue is NULL or timeout_milliseconds is negative, mpsc_wait_queue_pop shall fail and return NULL. ]*/
+        (mpsc_wait_queue == NULL) ||
+        (timeout_milliseconds < 0)
+        )
+    {
+        LogError("invalid arguments MPSC_WAIT_QUEUE_HANDLE mpsc_wait_queue=%p, int timeout_milliseconds=%d", mpsc_wait_queue, timeout_milliseconds);
+        result = NULL;
+    }
+    /*Codes_SRS_MPSC_WAIT_QUEUE_01_016: [ If the queue is not empty, mpsc_wait_queue_pop shall remove and return the entry at the front of the queue without taking the lock. ]*/
+    else if ((result = pop_entry(mpsc_wait_queue)) != NULL)
+    {
+        /*return it*/
+    }
+    else if (Lock(mpsc_wait_queue->lock) != LOCK_OK)
+    {
+        /*Codes_SRS_MPSC_WAIT_QUEUE_01_021: [ If any failure occurs, mpsc_wait_queue_pop shall fail and return NULL. ]*/
+        LogError("failure in Lock");
+    }
+    else
+    {
+        /*Codes_SRS_MPSC_WAIT_QUEUE_01_017: [ Otherwise mpsc_wait_queue_pop shall take the lock, mark the consumer as waiting and check the queue again. ]*/
+        MPSC_WAIT_QUEUE_SET_FLAG(mpsc_wait_queue->waiting);
+
+        if (MPSC_WAIT_QUEUE_TAKE_FLAG(mpsc_wait_queue->wake_pending) != 0)
+        {
+            /*Codes_SRS_MPSC_WAIT_QUEUE_01_020: [ If mpsc_wait_queue_wake was called since the last wait, mpsc_wait_queue_pop shall return NULL without waiting. ]*/
+        }
+        else if ((result = pop_entry(mpsc_wait_queue)) != NULL)
+        {
+            /*pushed in the meantime*/
+        }
+        else
+        {
+            /*Codes_SRS_MPSC_WAIT_QUEUE_01_018: [ If the queue is still empty, mpsc_wait_queue_pop shall wait on the condition for at most timeout_milliseconds, 0 meaning no timeout. ]*/
+            COND_RESULT wait_result = Condition_Wait(mpsc_wait_queue->condition, mpsc_wait_queue->lock, timeout_milliseconds);
+            if ((wait_result != COND_OK) && (wait_result != COND_TIMEOUT))
+            {
+                /*Codes_SRS_MPSC_WAIT_QUEUE_01_021: [ If any failure occurs, mpsc_wait_queue_pop shall fail and return NULL. ]*/
+                LogError("failure in Condition_Wait");
+            }
+            else
+            {
+                /*Codes_SRS_MPSC_WAIT_QUEUE_01_019: [ After waiting, mpsc_wait_queue_pop shall remove and return the entry at the front of the queue, or return NULL if the queue is still empty. ]*/
+                (void)MPSC_WAIT_QUEUE_TAKE_FLAG(mpsc_wait_queue->wake_pending);
+                result = pop_entry(mpsc_wait_queue);
+            }
+        }
+
+        (void)MPSC_WAIT_QUEUE_TAKE_FLAG(mpsc_wait_queue->waiting);
+        (void)Unlock(mpsc_wait_queue->lock);
+    }
+
+    return result;
+}
+
+int mpsc_wait_queue_wake(MPSC_WAIT_QUEUE_HANDLE mpsc_wait_queue)
+{
+    int result;
+
+    if (mpsc_wait_queue == NULL)
+    {
+        /*Codes_SRS_MPSC_WAIT_QUEUE_01_022: [ If mpsc_wait_queue is NULL, mpsc_wait_queue_wake shall fail and return a non-zero value. ]*/
+        LogError("invalid argument MPSC_WAIT_QUEUE_HANDLE mpsc_wait_queue=%p", mpsc_wait_queue);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_MPSC_WAIT_QUEUE_01_023: [ mpsc_wait_queue_wake shall record the wake, so that the current or next wait of mpsc_wait_queue_pop returns NULL. ]*/
+        MPSC_WAIT_QUEUE_SET_FLAG(mpsc_wait_queue->wake_pending);
+
+        /*Codes_SRS_MPSC_WAIT_QUEUE_01_024: [ If the consumer is waiting, mpsc_wait_queue_wake shall post the condition while holding the lock. ]*/
+        if (post_if_waiting(mpsc_wait_queue) != 0)
+        {
+            /*Codes_SRS_MPSC_WAIT_QUEUE_01_026: [ If any failure occurs, mpsc_wait_queue_wake shall fail and return a non-zero value. ]*/
+            LogError("failure waking the consumer");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /*Codes_SRS_MPSC_WAIT_QUEUE_01_025: [ mpsc_wait_queue_wake shall succeed and return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
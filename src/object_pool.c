@@ -0,0 +1,512 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/* the blocks deliberately come from the C heap and not through gballoc, see object_pool.h */
+#include <stdlib.h>
+#include <string.h>
+#include "azure_c_shared_utility/object_pool.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#if !defined(OBJECT_POOL_THREAD_LOCAL) && defined(_MSC_VER)
+#include <windows.h>
+#endif
+
+typedef union OBJECT_POOL_FREE_BLOCK_TAG
+{
+    /* a cached block holds the link to the next cached block */
+    union OBJECT_POOL_FREE_BLOCK_TAG* next;
+    void* align_pointer;
+} OBJECT_POOL_FREE_BLOCK;
+
+#if defined(OBJECT_POOL_THREAD_LOCAL)
+
+/* each thread has its own pool, nothing to guard */
+#define lock_pool(pool) ((void)(pool))
+#define unlock_pool(pool) ((void)(pool))
+
+#else
+
+static void lock_pool(OBJECT_POOL* pool)
+{
+    /* the lock is only held for a couple of pointer updates, spinning is cheaper than a kernel lock */
+#if defined(_MSC_VER)
+    while (InterlockedExchange(&pool->lock, 1) != 0)
+    {
+        YieldProcessor();
+    }
+#else
+    while (__sync_lock_test_and_set(&pool->lock, 1) != 0)
+    {
+        while (pool->lock != 0)
+        {
+        }
+    }
+#endif
+}
+
+static void unlock_pool(OBJECT_POOL* pool)
+{
+#if defined(_MSC_VER)
+    (void)InterlockedExchange(&pool->lock, 0);
+#else
+    __sync_lock_release(&pool->lock);
+#endif
+}
+
+#endif
+
+#if defined(OBJECT_POOL_STATIC)
+
+/* the payload size classes and the number of blocks of each, see object_pool_payload_alloc */
+#ifndef OBJECT_POOL_PAYLOAD_32_COUNT
+#define OBJECT_POOL_PAYLOAD_32_COUNT 32
+#endif
+#ifndef OBJECT_POOL_PAYLOAD_64_COUNT
+#define OBJECT_POOL_PAYLOAD_64_COUNT 32
+#endif
+#ifndef OBJECT_POOL_PAYLOAD_128_COUNT
+#define OBJECT_POOL_PAYLOAD_128_COUNT 16
+#endif
+#ifndef OBJECT_POOL_PAYLOAD_256_COUNT
+#define OBJECT_POOL_PAYLOAD_256_COUNT 16
+#endif
+#ifndef OBJECT_POOL_PAYLOAD_512_COUNT
+#define OBJECT_POOL_PAYLOAD_512_COUNT 8
+#endif
+#ifndef OBJECT_POOL_PAYLOAD_1024_COUNT
+#define OBJECT_POOL_PAYLOAD_1024_COUNT 4
+#endif
+#ifndef OBJECT_POOL_PAYLOAD_2048_COUNT
+#define OBJECT_POOL_PAYLOAD_2048_COUNT 2
+#endif
+#ifndef OBJECT_POOL_PAYLOAD_4096_COUNT
+#define OBJECT_POOL_PAYLOAD_4096_COUNT 1
+#endif
+
+OBJECT_POOL_DEFINE_STATIC(payload_pool_32, 32, OBJECT_POOL_PAYLOAD_32_COUNT);
+OBJECT_POOL_DEFINE_STATIC(payload_pool_64, 64, OBJECT_POOL_PAYLOAD_64_COUNT);
+OBJECT_POOL_DEFINE_STATIC(payload_pool_128, 128, OBJECT_POOL_PAYLOAD_128_COUNT);
+OBJECT_POOL_DEFINE_STATIC(payload_pool_256, 256, OBJECT_POOL_PAYLOAD_256_COUNT);
+OBJECT_POOL_DEFINE_STATIC(payload_pool_512, 512, OBJECT_POOL_PAYLOAD_512_COUNT);
+OBJECT_POOL_DEFINE_STATIC(payload_pool_1024, 1024, OBJECT_POOL_PAYLOAD_1024_COUNT);
+OBJECT_POOL_DEFINE_STATIC(payload_pool_2048, 2048, OBJECT_POOL_PAYLOAD_2048_COUNT);
+OBJECT_POOL_DEFINE_STATIC(payload_pool_4096, 4096, OBJECT_POOL_PAYLOAD_4096_COUNT);
+
+/* smallest first */
+static OBJECT_POOL* const payload_pools[] =
+{
+    &payload_pool_32, &payload_pool_64, &payload_pool_128, &payload_pool_256,
+    &payload_pool_512, &payload_pool_1024, &payload_pool_2048, &payload_pool_4096
+};
+
+#define PAYLOAD_POOL_COUNT (sizeof(payload_pools) / sizeof(payload_pools[0]))
+
+/* pools are only ever added, at the head, so that object_pool_report can walk the list without a lock */
+static OBJECT_POOL* volatile registered_pools = NULL;
+
+static void register_pool(OBJECT_POOL* pool)
+{
+#if defined(_MSC_VER)
+    if (InterlockedExchange(&pool->registered, 1) == 0)
+    {
+        OBJECT_POOL* head;
+        do
+        {
+            head = registered_pools;
+            pool->next_registered = head;
+        } while (InterlockedCompareExchangePointer((PVOID volatile*)&registered_pools, pool, head) != head);
+    }
+#else
+    if (__sync_lock_test_and_set(&pool->registered, 1) == 0)
+    {
+        OBJECT_POOL* head;
+        do
+        {
+            head = registered_pools;
+            pool->next_registered = head;
+        } while (!__sync_bool_compare_and_swap(&registered_pools, head, pool));
+    }
+#endif
+}
+
+static int is_in_storage(const OBJECT_POOL* pool, const void* object)
+{
+    return (pool->storage != NULL) &&
+        ((const unsigned char*)object >= pool->storage) &&
+        ((const unsigned char*)object < pool->storage + (pool->capacity * pool->block_size));
+}
+
+static OBJECT_POOL* find_payload_pool(const void* ptr)
+{
+    OBJECT_POOL* result = NULL;
+    size_t i;
+
+    for (i = 0; i < PAYLOAD_POOL_COUNT; i++)
+    {
+        if (is_in_storage(payload_pools[i], ptr))
+        {
+            result = payload_pools[i];
+            break;
+        }
+    }
+
+    return result;
+}
+
+#endif
+
+void* object_pool_alloc(OBJECT_POOL* pool)
+{
+    void* result;
+
+    if (pool == NULL)
+    {
+        /* Codes_SRS_OBJECT_POOL_01_001: [ If pool is NULL, object_pool_alloc shall fail and return NULL. ]*/
+        LogError("Invalid argument: pool is NULL");
+        result = NULL;
+    }
+    else
+    {
+        OBJECT_POOL_FREE_BLOCK* block;
+
+        lock_pool(pool);
+        /* Codes_SRS_OBJECT_POOL_01_002: [ If the pool has a cached block, object_pool_alloc shall remove it from the pool and return it. ]*/
+        block = (OBJECT_POOL_FREE_BLOCK*)pool->free_list;
+        if (block != NULL)
+        {
+            pool->free_list = block->next;
+            pool->cached_count--;
+        }
+#if defined(OBJECT_POOL_STATIC)
+        else if (pool->carved_count < pool->capacity)
+        {
+            /* Codes_SRS_OBJECT_POOL_01_010: [ Otherwise, if the pool has static storage, object_pool_alloc shall return the next block of the storage that was never handed out. ]*/
+            block = (OBJECT_POOL_FREE_BLOCK*)(pool->storage + (pool->carved_count * pool->block_size));
+            pool->carved_count++;
+        }
+
+        if ((block != NULL) || (pool->storage != NULL))
+        {
+            /* Codes_SRS_OBJECT_POOL_01_012: [ When OBJECT_POOL_STATIC is defined, object_pool_alloc shall count the blocks in use and keep their high-water mark. ]*/
+            if (block != NULL)
+            {
+                pool->in_use_count++;
+                if (pool->in_use_count > pool->high_water_mark)
+                {
+                    pool->high_water_mark = pool->in_use_count;
+                }
+            }
+            else
+            {
+                pool->failed_count++;
+            }
+        }
+#endif
+        unlock_pool(pool);
+
+#if defined(OBJECT_POOL_STATIC)
+        register_pool(pool);
+#endif
+
+        if (block != NULL)
+        {
+            result = block;
+        }
+#if defined(OBJECT_POOL_STATIC)
+        else if (pool->storage != NULL)
+        {
+            /* Codes_SRS_OBJECT_POOL_01_011: [ If all the blocks of the static storage are in use, object_pool_alloc shall fail and return NULL without allocating. ]*/
+            LogError("All the %lu blocks of pool %s are in use", (unsigned long)pool->capacity, pool->name);
+            result = NULL;
+        }
+#endif
+        else
+        {
+            /* Codes_SRS_OBJECT_POOL_01_003: [ Otherwise object_pool_alloc shall allocate a block of the object size of the pool, or of the size of a pointer if that is larger. ]*/
+            result = malloc((pool->object_size < sizeof(OBJECT_POOL_FREE_BLOCK)) ? sizeof(OBJECT_POOL_FREE_BLOCK) : pool->object_size);
+            if (result == NULL)
+            {
+                /* Codes_SRS_OBJECT_POOL_01_004: [ If allocating the block fails, object_pool_alloc shall return NULL. ]*/
+                LogError("Failure allocating a block of %lu bytes", (unsigned long)pool->object_size);
+            }
+#if defined(OBJECT_POOL_STATIC)
+            else
+            {
+                lock_pool(pool);
+                pool->in_use_count++;
+                if (pool->in_use_count > pool->high_water_mark)
+                {
+                    pool->high_water_mark = pool->in_use_count;
+                }
+                unlock_pool(pool);
+            }
+#endif
+        }
+    }
+
+    return result;
+}
+
+void object_pool_free(OBJECT_POOL* pool, void* object)
+{
+    if ((pool == NULL) || (object == NULL))
+    {
+        /* Codes_SRS_OBJECT_POOL_01_005: [ If pool or object is NULL, object_pool_free shall do nothing. ]*/
+    }
+    else
+    {
+        OBJECT_POOL_FREE_BLOCK* block = (OBJECT_POOL_FREE_BLOCK*)object;
+        int cached;
+
+        lock_pool(pool);
+#if defined(OBJECT_POOL_STATIC)
+        pool->in_use_count--;
+        if (is_in_storage(pool, object))
+        {
+            /* Codes_SRS_OBJECT_POOL_01_013: [ A block of static storage shall always be added to the pool, and never freed. ]*/
+            block->next = (OBJECT_POOL_FREE_BLOCK*)pool->free_list;
+            pool->free_list = block;
+            cached = 1;
+        }
+        else
+#endif
+        if (pool->cached_count < OBJECT_POOL_MAX_CACHED)
+        {
+            /* Codes_SRS_OBJECT_POOL_01_006: [ If the pool holds less than OBJECT_POOL_MAX_CACHED blocks, object_pool_free shall add object to the pool. ]*/
+            block->next = (OBJECT_POOL_FREE_BLOCK*)pool->free_list;
+            pool->free_list = block;
+            pool->cached_count++;
+            cached = 1;
+        }
+        else
+        {
+            cached = 0;
+        }
+        unlock_pool(pool);
+
+        if (!cached)
+        {
+            /* Codes_SRS_OBJECT_POOL_01_007: [ Otherwise object_pool_free shall free object. ]*/
+            free(object);
+        }
+    }
+}
+
+void object_pool_trim(OBJECT_POOL* pool)
+{
+    if (pool == NULL)
+    {
+        /* Codes_SRS_OBJECT_POOL_01_008: [ If pool is NULL, object_pool_trim shall do nothing. ]*/
+        LogError("Invalid argument: pool is NULL");
+    }
+    else
+    {
+        OBJECT_POOL_FREE_BLOCK* block;
+
+        /* Codes_SRS_OBJECT_POOL_01_009: [ object_pool_trim shall free all the blocks cached by the pool. ]*/
+        lock_pool(pool);
+#if defined(OBJECT_POOL_STATIC)
+        if (pool->storage != NULL)
+        {
+            /* Codes_SRS_OBJECT_POOL_01_014: [ object_pool_trim shall keep the blocks of a pool with static storage. ]*/
+            block = NULL;
+        }
+        else
+#endif
+        {
+            block = (OBJECT_POOL_FREE_BLOCK*)pool->free_list;
+            pool->free_list = NULL;
+            pool->cached_count = 0;
+        }
+        unlock_pool(pool);
+
+        while (block != NULL)
+        {
+            OBJECT_POOL_FREE_BLOCK* next = block->next;
+            free(block);
+            block = next;
+        }
+    }
+}
+
+int object_pool_get_statistics(OBJECT_POOL* pool, OBJECT_POOL_STATISTICS* statistics)
+{
+    int result;
+
+    if ((pool == NULL) || (statistics == NULL))
+    {
+        /* Codes_SRS_OBJECT_POOL_01_015: [ If pool or statistics is NULL, object_pool_get_statistics shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: pool = %p, statistics = %p", pool, statistics);
+        result = __FAILURE__;
+    }
+    else
+    {
+#if defined(OBJECT_POOL_STATIC)
+        /* Codes_SRS_OBJECT_POOL_01_016: [ object_pool_get_statistics shall fill statistics with the object size, the number of blocks of static storage, the blocks in use, their high-water mark and the count of failed allocations of the pool and return 0. ]*/
+        lock_pool(pool);
+        statistics->object_size = pool->object_size;
+        statistics->capacity = pool->capacity;
+        statistics->in_use_count = pool->in_use_count;
+        statistics->high_water_mark = pool->high_water_mark;
+        statistics->failed_count = pool->failed_count;
+        unlock_pool(pool);
+        result = 0;
+#else
+        /* Codes_SRS_OBJECT_POOL_01_017: [ When OBJECT_POOL_STATIC is not defined, object_pool_get_statistics shall fail and return a non-zero value. ]*/
+        LogError("The pool statistics are only kept when OBJECT_POOL_STATIC is defined");
+        result = __FAILURE__;
+#endif
+    }
+
+    return result;
+}
+
+void object_pool_report(void)
+{
+#if defined(OBJECT_POOL_STATIC)
+    OBJECT_POOL* pool;
+
+    /* Codes_SRS_OBJECT_POOL_01_018: [ object_pool_report shall log with LogInfo one line per pool used so far with its name, block size, capacity, blocks in use, high-water mark and failed allocations. ]*/
+    for (pool = registered_pools; pool != NULL; pool = pool->next_registered)
+    {
+        OBJECT_POOL_STATISTICS statistics;
+        (void)object_pool_get_statistics(pool, &statistics);
+        LogInfo("object_pool: %s: %lu bytes, %lu blocks, %lu in use, %lu max, %lu failed",
+            (pool->name == NULL) ? "(heap)" : pool->name, (unsigned long)statistics.object_size, (unsigned long)statistics.capacity,
+            (unsigned long)statistics.in_use_count, (unsigned long)statistics.high_water_mark, (unsigned long)statistics.failed_count);
+    }
+#endif
+}
+
+void* object_pool_payload_alloc(size_t size)
+{
+    void* result;
+#if defined(OBJECT_POOL_STATIC)
+    size_t i;
+    size_t smallest = PAYLOAD_POOL_COUNT;
+
+    result = NULL;
+    if (size == 0)
+    {
+        /* Codes_SRS_OBJECT_POOL_01_019: [ If size is 0, object_pool_payload_alloc shall fail and return NULL. ]*/
+        LogError("Invalid argument: size is 0");
+    }
+    else
+    {
+        /* Codes_SRS_OBJECT_POOL_01_020: [ object_pool_payload_alloc shall return a block of the smallest payload size class that holds size bytes and has a free block. ]*/
+        for (i = 0; (i < PAYLOAD_POOL_COUNT) && (result == NULL); i++)
+        {
+            if (payload_pools[i]->object_size >= size)
+            {
+                if (smallest == PAYLOAD_POOL_COUNT)
+                {
+                    smallest = i;
+                }
+
+                /* only a hint taken without the lock, object_pool_alloc decides */
+                if ((payload_pools[i]->free_list != NULL) || (payload_pools[i]->carved_count < payload_pools[i]->capacity))
+                {
+                    result = object_pool_alloc(payload_pools[i]);
+                }
+            }
+        }
+
+        if ((result == NULL) && (smallest < PAYLOAD_POOL_COUNT))
+        {
+            /* counts the failure against the class the size belongs to, unless a block was given back meanwhile */
+            result = object_pool_alloc(payload_pools[smallest]);
+        }
+
+        if (result == NULL)
+        {
+            /* Codes_SRS_OBJECT_POOL_01_021: [ If size is larger than the largest payload size class or no class that holds it has a free block, object_pool_payload_alloc shall fail and return NULL. ]*/
+            LogError("No payload block of %lu bytes is available", (unsigned long)size);
+        }
+    }
+#else
+    /* Codes_SRS_OBJECT_POOL_01_022: [ When OBJECT_POOL_STATIC is not defined, object_pool_payload_alloc shall fail and return NULL. ]*/
+    (void)size;
+    LogError("The payload pools only exist when OBJECT_POOL_STATIC is defined");
+    result = NULL;
+#endif
+    return result;
+}
+
+void* object_pool_payload_realloc(void* ptr, size_t size)
+{
+    void* result;
+#if defined(OBJECT_POOL_STATIC)
+    OBJECT_POOL* pool;
+
+    if (ptr == NULL)
+    {
+        /* Codes_SRS_OBJECT_POOL_01_023: [ If ptr is NULL, object_pool_payload_realloc shall behave as object_pool_payload_alloc. ]*/
+        result = object_pool_payload_alloc(size);
+    }
+    else if ((pool = find_payload_pool(ptr)) == NULL)
+    {
+        /* Codes_SRS_OBJECT_POOL_01_024: [ If ptr was not obtained from object_pool_payload_alloc, object_pool_payload_realloc shall fail and return NULL. ]*/
+        LogError("%p is not a payload block", ptr);
+        result = NULL;
+    }
+    else if (size <= pool->object_size)
+    {
+        /* Codes_SRS_OBJECT_POOL_01_025: [ If size fits the block of ptr, object_pool_payload_realloc shall return ptr. ]*/
+        result = ptr;
+    }
+    else if ((result = object_pool_payload_alloc(size)) == NULL)
+    {
+        /* Codes_SRS_OBJECT_POOL_01_027: [ If obtaining the new block fails, object_pool_payload_realloc shall return NULL and leave ptr untouched. ]*/
+    }
+    else
+    {
+        /* Codes_SRS_OBJECT_POOL_01_026: [ Otherwise object_pool_payload_realloc shall copy the content of ptr to a block that holds size bytes, give back ptr and return the new block. ]*/
+        (void)memcpy(result, ptr, pool->object_size);
+        object_pool_free(pool, ptr);
+    }
+#else
+    (void)ptr;
+    (void)size;
+    LogError("The payload pools only exist when OBJECT_POOL_STATIC is defined");
+    result = NULL;
+#endif
+    return result;
+}
+
+void object_pool_payload_free(void* ptr)
+{
+#if defined(OBJECT_POOL_STATIC)
+    if (ptr == NULL)
+    {
+        /* Codes_SRS_OBJECT_POOL_01_028: [ If ptr is NULL, object_pool_payload_free shall do nothing. ]*/
+    }
+    else
+    {
+        OBJECT_POOL* pool = find_payload_pool(ptr);
+        if (pool == NULL)
+        {
+            /* Codes_SRS_OBJECT_POOL_01_029: [ If ptr was not obtained from object_pool_payload_alloc, object_pool_payload_free shall log an error and do nothing. ]*/
+            LogError("%p is not a payload block", ptr);
+        }
+        else
+        {
+            /* Codes_SRS_OBJECT_POOL_01_030: [ Otherwise object_pool_payload_free shall give ptr back to its payload pool. ]*/
+            object_pool_free(pool, ptr);
+        }
+    }
+#else
+    (void)ptr;
+#endif
+}
+
+int object_pool_is_payload(const void* ptr)
+{
+#if defined(OBJECT_POOL_STATIC)
+    /* Codes_SRS_OBJECT_POOL_01_031: [ object_pool_is_payload shall return a non-zero value if ptr is in the storage of a payload pool and 0 otherwise. ]*/
+    return (ptr != NULL) && (find_payload_pool(ptr) != NULL);
+#else
+    (void)ptr;
+    return 0;
+#endif
+}
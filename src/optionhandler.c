@@ -3,14 +3,23 @@
 
 #include <stdlib.h>
 #include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/constbuffer.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/gballoc.h"
-#include "azure_c_shared_utility/vector.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/string_intern.h"
+
+#define OPTION_STORAGE_INITIAL_CAPACITY 4
 
 typedef struct OPTION_TAG
 {
+    /*interned, the handlers of all the connections share the names of their options*/
     const char* name;
+    /*the key given by pfGetOptionKey when the option was added, OPTIONHANDLER_NO_KEY for options fed by name*/
+    int key;
     void* storage;
+    /*the buffer holding storage for options added by OptionHandler_AddSharedOption, NULL for the ones cloned by pfCloneOption*/
+    CONSTBUFFER_HANDLE shared_value;
 }OPTION;
 
 typedef struct OPTIONHANDLER_HANDLE_DATA_TAG
@@ -18,10 +27,14 @@ typedef struct OPTIONHANDLER_HANDLE_DATA_TAG
     pfCloneOption cloneOption;
     pfDestroyOption destroyOption;
     pfSetOption setOption;
-    VECTOR_HANDLE storage;
+    pfGetOptionKey getOptionKey;
+    pfSetOptionByKey setOptionByKey;
+    OPTION* options;
+    size_t option_count;
+    size_t option_capacity;
 }OPTIONHANDLER_HANDLE_DATA;
 
-static OPTIONHANDLER_HANDLE CreateInternal(pfCloneOption cloneOption, pfDestroyOption destroyOption, pfSetOption setOption)
+static OPTIONHANDLER_HANDLE CreateInternal(pfCloneOption cloneOption, pfDestroyOption destroyOption, pfSetOption setOption, pfGetOptionKey getOptionKey, pfSetOptionByKey setOptionByKey)
 {
     OPTIONHANDLER_HANDLE result;
 
@@ -34,33 +47,89 @@ static OPTIONHANDLER_HANDLE CreateInternal(pfCloneOption cloneOption, pfDestroyO
     }
     else
     {
-        /*Codes_SRS_OPTIONHANDLER_02_002: [ OptionHandler_Create shall create an empty VECTOR that will hold pairs of const char* and void*. ]*/
-        result->storage = VECTOR_create(sizeof(OPTION));
-        if (result->storage == NULL)
+        /*Codes_SRS_OPTIONHANDLER_02_002: [ OptionHandler_Create shall start with an empty array of options, allocated when the first option is added. ]*/
+        /*Codes_SRS_OPTIONHANDLER_02_003: [ If all the operations succeed then OptionHandler_Create shall succeed and return a non-NULL handle. ]*/
+        result->cloneOption = cloneOption;
+        result->destroyOption = destroyOption;
+        result->setOption = setOption;
+        result->getOptionKey = getOptionKey;
+        result->setOptionByKey = setOptionByKey;
+        result->options = NULL;
+        result->option_count = 0;
+        result->option_capacity = 0;
+        /*return as is*/
+    }
+
+    return result;
+}
+
+static int ReserveOptions(OPTIONHANDLER_HANDLE handle, size_t capacity)
+{
+    int result;
+
+    if (capacity <= handle->option_capacity)
+    {
+        result = 0;
+    }
+    else
+    {
+        OPTION* new_options = (OPTION*)realloc(handle->options, capacity * sizeof(OPTION));
+        if (new_options == NULL)
         {
-            /*Codes_SRS_OPTIONHANDLER_02_004: [ Otherwise, OptionHandler_Create shall fail and return NULL. ]*/
-            LogError("unable to VECTOR_create");
-            free(result);
-            result = NULL;
+            LogError("unable to realloc");
+            result = __FAILURE__;
         }
         else
         {
-            /*Codes_SRS_OPTIONHANDLER_02_003: [ If all the operations succeed then OptionHandler_Create shall succeed and return a non-NULL handle. ]*/
-            result->cloneOption = cloneOption;
-            result->destroyOption = destroyOption;
-            result->setOption = setOption;
-            /*return as is*/
+            handle->options = new_options;
+            handle->option_capacity = capacity;
+            result = 0;
         }
     }
 
     return result;
 }
 
-static OPTIONHANDLER_RESULT AddOptionInternal(OPTIONHANDLER_HANDLE handle, const char* name, const void* value)
+static OPTIONHANDLER_RESULT AddSharedOptionInternal(OPTIONHANDLER_HANDLE handle, const char* name, bool name_is_interned, int key, CONSTBUFFER_HANDLE value)
 {
     OPTIONHANDLER_RESULT result;
     const char* cloneOfName;
-    if (mallocAndStrcpy_s((char**)&cloneOfName, name) != 0)
+    if ((cloneOfName = (name_is_interned ? string_intern_clone(name) : string_intern(name))) == NULL)
+    {
+        /*Codes_SRS_OPTIONHANDLER_01_022: [ If any failure is encountered, OptionHandler_AddSharedOption shall fail and return OPTIONHANDLER_ERROR. ]*/
+        LogError("unable to clone name");
+        result = OPTIONHANDLER_ERROR;
+    }
+    else if ((handle->option_count == handle->option_capacity) &&
+        (ReserveOptions(handle, (handle->option_capacity == 0) ? OPTION_STORAGE_INITIAL_CAPACITY : handle->option_capacity * 2) != 0))
+    {
+        /*Codes_SRS_OPTIONHANDLER_01_022: [ If any failure is encountered, OptionHandler_AddSharedOption shall fail and return OPTIONHANDLER_ERROR. ]*/
+        LogError("unable to grow the option storage");
+        string_intern_release(cloneOfName);
+        result = OPTIONHANDLER_ERROR;
+    }
+    else
+    {
+        OPTION* option = &handle->options[handle->option_count++];
+
+        /*Codes_SRS_OPTIONHANDLER_01_020: [ OptionHandler_AddSharedOption shall take a reference on value by calling CONSTBUFFER_IncRef instead of calling pfCloneOption, and save it with the name and the key of the option. ]*/
+        CONSTBUFFER_IncRef(value);
+        option->name = cloneOfName;
+        option->key = key;
+        option->storage = (void*)CONSTBUFFER_GetContent(value)->buffer;
+        option->shared_value = value;
+        /*Codes_SRS_OPTIONHANDLER_01_021: [ If all the operations succeed then OptionHandler_AddSharedOption shall succeed and return OPTIONHANDLER_OK. ]*/
+        result = OPTIONHANDLER_OK;
+    }
+
+    return result;
+}
+
+static OPTIONHANDLER_RESULT AddOptionInternal(OPTIONHANDLER_HANDLE handle, const char* name, bool name_is_interned, int key, const void* value)
+{
+    OPTIONHANDLER_RESULT result;
+    const char* cloneOfName;
+    if ((cloneOfName = (name_is_interned ? string_intern_clone(name) : string_intern(name))) == NULL)
     {
         /*Codes_SRS_OPTIONHANDLER_02_009: [ Otherwise, OptionHandler_AddProperty shall succeed and return OPTIONHANDLER_ERROR. ]*/
         LogError("unable to clone name");
@@ -74,28 +143,28 @@ static OPTIONHANDLER_RESULT AddOptionInternal(OPTIONHANDLER_HANDLE handle, const
         {
             /*Codes_SRS_OPTIONHANDLER_02_009: [ Otherwise, OptionHandler_AddProperty shall succeed and return OPTIONHANDLER_ERROR. ]*/
             LogError("unable to clone value");
-            free((void*)cloneOfName);
+            string_intern_release(cloneOfName);
+            result = OPTIONHANDLER_ERROR;
+        }
+        /*Codes_SRS_OPTIONHANDLER_02_007: [ OptionHandler_AddOption shall save the name, the key and the newly created clone of value in its array of options, growing the array when it is full. ]*/
+        else if ((handle->option_count == handle->option_capacity) &&
+            (ReserveOptions(handle, (handle->option_capacity == 0) ? OPTION_STORAGE_INITIAL_CAPACITY : handle->option_capacity * 2) != 0))
+        {
+            /*Codes_SRS_OPTIONHANDLER_02_009: [ Otherwise, OptionHandler_AddProperty shall succeed and return OPTIONHANDLER_ERROR. ]*/
+            LogError("unable to grow the option storage");
+            handle->destroyOption(name, cloneOfValue);
+            string_intern_release(cloneOfName);
             result = OPTIONHANDLER_ERROR;
         }
         else
         {
-            OPTION temp;
-            temp.name = cloneOfName;
-            temp.storage = cloneOfValue;
-            /*Codes_SRS_OPTIONHANDLER_02_007: [ OptionHandler_AddProperty shall use VECTOR APIs to save the name and the newly created clone of value. ]*/
-            if (VECTOR_push_back(handle->storage, &temp, 1) != 0)
-            {
-                /*Codes_SRS_OPTIONHANDLER_02_009: [ Otherwise, OptionHandler_AddProperty shall succeed and return OPTIONHANDLER_ERROR. ]*/
-                LogError("unable to VECTOR_push_back");
-                handle->destroyOption(name, cloneOfValue);
-                free((void*)cloneOfName);
-                result = OPTIONHANDLER_ERROR;
-            }
-            else
-            {
-                /*Codes_SRS_OPTIONHANDLER_02_008: [ If all the operations succed then OptionHandler_AddProperty shall succeed and return OPTIONHANDLER_OK. ]*/
-                result = OPTIONHANDLER_OK;
-            }
+            OPTION* option = &handle->options[handle->option_count++];
+            option->name = cloneOfName;
+            option->key = key;
+            option->storage = cloneOfValue;
+            option->shared_value = NULL;
+            /*Codes_SRS_OPTIONHANDLER_02_008: [ If all the operations succed then OptionHandler_AddProperty shall succeed and return OPTIONHANDLER_OK. ]*/
+            result = OPTIONHANDLER_OK;
         }
     }
 
@@ -105,15 +174,23 @@ static OPTIONHANDLER_RESULT AddOptionInternal(OPTIONHANDLER_HANDLE handle, const
 static void DestroyInternal(OPTIONHANDLER_HANDLE handle)
 {
     /*Codes_SRS_OPTIONHANDLER_02_016: [ Otherwise, OptionHandler_Destroy shall free all used resources. ]*/
-    size_t nOptions = VECTOR_size(handle->storage), i;
-    for (i = 0; i < nOptions; i++)
+    size_t i;
+    for (i = 0; i < handle->option_count; i++)
     {
-        OPTION* option = (OPTION*)VECTOR_element(handle->storage, i);
-        handle->destroyOption(option->name, option->storage);
-        free((void*)option->name);
+        OPTION* option = &handle->options[i];
+        if (option->shared_value != NULL)
+        {
+            /*Codes_SRS_OPTIONHANDLER_01_024: [ OptionHandler_Destroy shall release the options added by OptionHandler_AddSharedOption by calling CONSTBUFFER_DecRef instead of pfDestroyOption. ]*/
+            CONSTBUFFER_DecRef(option->shared_value);
+        }
+        else
+        {
+            handle->destroyOption(option->name, option->storage);
+        }
+        string_intern_release(option->name);
     }
 
-    VECTOR_destroy(handle->storage);
+    free(handle->options);
     free(handle);
 }
 
@@ -132,13 +209,38 @@ OPTIONHANDLER_HANDLE OptionHandler_Create(pfCloneOption cloneOption, pfDestroyOp
     }
     else
     {
-        result = CreateInternal(cloneOption, destroyOption, setOption);
+        result = CreateInternal(cloneOption, destroyOption, setOption, NULL, NULL);
     }
 
     return result;
 
 }
 
+OPTIONHANDLER_HANDLE OptionHandler_CreateWithKeys(pfCloneOption cloneOption, pfDestroyOption destroyOption, pfSetOption setOption, pfGetOptionKey getOptionKey, pfSetOptionByKey setOptionByKey)
+{
+    OPTIONHANDLER_HANDLE_DATA* result;
+    /*Codes_SRS_OPTIONHANDLER_01_012: [ OptionHandler_CreateWithKeys shall fail and return NULL if any parameters are NULL. ]*/
+    if (
+        (cloneOption == NULL) ||
+        (destroyOption == NULL) ||
+        (setOption == NULL) ||
+        (getOptionKey == NULL) ||
+        (setOptionByKey == NULL)
+        )
+    {
+        LogError("invalid parameter = pfCloneOption cloneOption=%p, pfDestroyOption destroyOption=%p, pfSetOption setOption=%p, pfGetOptionKey getOptionKey=%p, pfSetOptionByKey setOptionByKey=%p",
+            cloneOption, destroyOption, setOption, getOptionKey, setOptionByKey);
+        result = NULL;
+    }
+    else
+    {
+        /*Codes_SRS_OPTIONHANDLER_01_013: [ Otherwise OptionHandler_CreateWithKeys shall behave as OptionHandler_Create and also remember getOptionKey and setOptionByKey. ]*/
+        result = CreateInternal(cloneOption, destroyOption, setOption, getOptionKey, setOptionByKey);
+    }
+
+    return result;
+}
+
 OPTIONHANDLER_HANDLE OptionHandler_Clone(OPTIONHANDLER_HANDLE handler)
 {
     OPTIONHANDLER_HANDLE_DATA* result;
@@ -154,25 +256,37 @@ OPTIONHANDLER_HANDLE OptionHandler_Clone(OPTIONHANDLER_HANDLE handler)
         /* Codes_SRS_OPTIONHANDLER_01_001: [ OptionHandler_Clone shall clone an existing option handler instance. ]*/
         /* Codes_SRS_OPTIONHANDLER_01_002: [ On success it shall return a non-NULL handle. ]*/
         /* Codes_SRS_OPTIONHANDLER_01_003: [ OptionHandler_Clone shall allocate memory for the new option handler instance. ]*/
-        result = CreateInternal(handler->cloneOption, handler->destroyOption, handler->setOption);
+        result = CreateInternal(handler->cloneOption, handler->destroyOption, handler->setOption, handler->getOptionKey, handler->setOptionByKey);
         if (result == NULL)
         {
             /* Codes_SRS_OPTIONHANDLER_01_004: [ If allocating memory fails, OptionHandler_Clone shall return NULL. ]*/
             LogError("unable to create option handler");
         }
+        /* Codes_SRS_OPTIONHANDLER_01_014: [ OptionHandler_Clone shall allocate in one step an array large enough for all the options of handler. ]*/
+        else if (ReserveOptions(result, handler->option_count) != 0)
+        {
+            /* Codes_SRS_OPTIONHANDLER_01_011: [ If allocating the array for the cloned options fails, OptionHandler_Clone shall return NULL. ]*/
+            LogError("unable to allocate the option storage");
+            DestroyInternal(result);
+            result = NULL;
+        }
         else
         {
-            /* Codes_SRS_OPTIONHANDLER_01_005: [ OptionHandler_Clone shall iterate through all the options stored by the option handler to be cloned by using VECTOR's iteration mechanism. ]*/
-            size_t option_count = VECTOR_size(handler->storage);
+            /* Codes_SRS_OPTIONHANDLER_01_005: [ OptionHandler_Clone shall iterate through all the options stored by the option handler to be cloned. ]*/
+            size_t option_count = handler->option_count;
             size_t i;
 
             for (i = 0; i < option_count; i++)
             {
-                OPTION* option = (OPTION*)VECTOR_element(handler->storage, i);
+                OPTION* option = &handler->options[i];
 
-                /* Codes_SRS_OPTIONHANDLER_01_006: [ For each option the option name shall be cloned by calling mallocAndStrcpy_s. ]*/
+                /* Codes_SRS_OPTIONHANDLER_01_006: [ For each option the option name shall be cloned by calling string_intern_clone. ]*/
                 /* Codes_SRS_OPTIONHANDLER_01_007: [ For each option the value shall be cloned by using the cloning function associated with the source option handler handler. ]*/
-                if (AddOptionInternal(result, option->name, option->storage) != OPTIONHANDLER_OK)
+                /* Codes_SRS_OPTIONHANDLER_01_015: [ The key of each option shall be copied from handler, without calling getOptionKey. ]*/
+                /* Codes_SRS_OPTIONHANDLER_01_023: [ The options added by OptionHandler_AddSharedOption shall be shared with the clone by calling CONSTBUFFER_IncRef. ]*/
+                if (((option->shared_value != NULL) ?
+                    AddSharedOptionInternal(result, option->name, true, option->key, option->shared_value) :
+                    AddOptionInternal(result, option->name, true, option->key, option->storage)) != OPTIONHANDLER_OK)
                 {
                     /* Codes_SRS_OPTIONHANDLER_01_008: [ If cloning one of the option names fails, OptionHandler_Clone shall return NULL. ]*/
                     /* Codes_SRS_OPTIONHANDLER_01_009: [ If cloning one of the option values fails, OptionHandler_Clone shall return NULL. ]*/
@@ -207,7 +321,32 @@ OPTIONHANDLER_RESULT OptionHandler_AddOption(OPTIONHANDLER_HANDLE handle, const
     }
     else
     {
-        result = AddOptionInternal(handle, name, value);
+        /*Codes_SRS_OPTIONHANDLER_01_016: [ If the handler was created with OptionHandler_CreateWithKeys, OptionHandler_AddOption shall call getOptionKey passing name to get the key of the option. ]*/
+        int key = (handle->getOptionKey != NULL) ? handle->getOptionKey(name) : OPTIONHANDLER_NO_KEY;
+        result = AddOptionInternal(handle, name, false, (key < 0) ? OPTIONHANDLER_NO_KEY : key, value);
+    }
+
+    return result;
+}
+
+OPTIONHANDLER_RESULT OptionHandler_AddSharedOption(OPTIONHANDLER_HANDLE handle, const char* name, CONSTBUFFER_HANDLE value)
+{
+    OPTIONHANDLER_RESULT result;
+    if (
+        (handle == NULL) ||
+        (name == NULL) ||
+        (value == NULL)
+        )
+    {
+        /*Codes_SRS_OPTIONHANDLER_01_018: [ OptionHandler_AddSharedOption shall fail and return OPTIONHANDLER_INVALIDARG if any parameter is NULL. ]*/
+        LogError("invalid arguments: OPTIONHANDLER_HANDLE handle=%p, const char* name=%p, CONSTBUFFER_HANDLE value=%p", handle, name, value);
+        result = OPTIONHANDLER_INVALIDARG;
+    }
+    else
+    {
+        /*Codes_SRS_OPTIONHANDLER_01_019: [ If the handler was created with OptionHandler_CreateWithKeys, OptionHandler_AddSharedOption shall call getOptionKey passing name to get the key of the option. ]*/
+        int key = (handle->getOptionKey != NULL) ? handle->getOptionKey(name) : OPTIONHANDLER_NO_KEY;
+        result = AddSharedOptionInternal(handle, name, false, (key < 0) ? OPTIONHANDLER_NO_KEY : key, value);
     }
 
     return result;
@@ -227,13 +366,16 @@ OPTIONHANDLER_RESULT OptionHandler_FeedOptions(OPTIONHANDLER_HANDLE handle, void
     }
     else
     {
-        /*Codes_SRS_OPTIONHANDLER_02_011: [ Otherwise, OptionHandler_FeedOptions shall use VECTOR's iteration mechanisms to retrieve pairs of name, value (const char* and void*). ]*/
-        size_t nOptions = VECTOR_size(handle->storage), i;
+        /*Codes_SRS_OPTIONHANDLER_02_011: [ Otherwise, OptionHandler_FeedOptions shall iterate through the stored options in the order they were added. ]*/
+        size_t nOptions = handle->option_count, i;
         for (i = 0;i < nOptions;i++)
         {
-            OPTION* option = (OPTION*)VECTOR_element(handle->storage, i);
-            /*Codes_SRS_OPTIONHANDLER_02_012: [ OptionHandler_FeedOptions shall call for every pair of name,value setOption passing destinationHandle, name and value. ]*/
-            if (handle->setOption(destinationHandle, option->name, option->storage) != 0)
+            OPTION* option = &handle->options[i];
+            /*Codes_SRS_OPTIONHANDLER_01_017: [ For every option that has a key OptionHandler_FeedOptions shall call setOptionByKey passing destinationHandle, the key, name and value. ]*/
+            /*Codes_SRS_OPTIONHANDLER_02_012: [ OptionHandler_FeedOptions shall call for every other pair of name,value setOption passing destinationHandle, name and value. ]*/
+            if (((option->key != OPTIONHANDLER_NO_KEY) ?
+                handle->setOptionByKey(destinationHandle, option->key, option->name, option->storage) :
+                handle->setOption(destinationHandle, option->name, option->storage)) != 0)
             {
                 LogError("failure while trying to _SetOption");
                 break;
@@ -0,0 +1,601 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/persistent_queue.h"
+#include "azure_c_shared_utility/file_mapping.h"
+#include "azure_c_shared_utility/constbuffer.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+/*
+* The file starts with two header slots. Each update of the header goes to the slot the previous
+* one did not use, with a generation one higher, so a torn update leaves the other slot valid.
+* The records follow, each aligned on 8 bytes: a RECORD_HEADER and the payload. A record that
+* does not fit before the end of the file goes to the start of the records, behind a wrap marker
+* (or nothing, when not even a RECORD_HEADER fits before the end).
+*
+* The header only tells where the oldest record is and its sequence number: the records that
+* follow are found again by reading them until one does not have the next sequence number or a
+* valid CRC. The records from before a wrap have older sequence numbers, so they are never taken
+* for newer ones. The file is in the byte order of the device.
+*/
+#define QUEUE_MAGIC 0x51505a41
+#define QUEUE_VERSION 1
+#define RECORD_MAGIC 0x44435252
+#define WRAP_MAGIC 0x50415257
+
+#define HEADER_SLOT_SIZE 64
+#define HEADER_SLOT_COUNT 2
+#define RECORDS_START (HEADER_SLOT_SIZE * HEADER_SLOT_COUNT)
+#define RECORD_HEADER_SIZE sizeof(RECORD_HEADER)
+#define RECORD_SIZE(payload_size) ((RECORD_HEADER_SIZE + (payload_size) + 7) & ~(size_t)7)
+
+typedef struct QUEUE_HEADER_TAG
+{
+    uint32_t magic;
+    uint32_t version;
+    uint64_t capacity;
+    uint64_t generation;
+    uint64_t head;
+    uint64_t head_sequence;
+    /* over all the fields above */
+    uint32_t crc;
+    uint32_t reserved;
+} QUEUE_HEADER;
+
+typedef struct RECORD_HEADER_TAG
+{
+    uint32_t magic;
+    uint32_t size;
+    uint64_t sequence;
+    /* over size, sequence and the payload */
+    uint32_t crc;
+    uint32_t reserved;
+} RECORD_HEADER;
+
+typedef struct PERSISTENT_QUEUE_TAG
+{
+    FILE_MAPPING_HANDLE file_mapping;
+    unsigned char* base;
+    size_t capacity;
+    uint64_t generation;
+    /* the oldest record, or where the next one goes (maybe behind a wrap) when the queue is empty */
+    size_t head;
+    uint64_t head_sequence;
+    size_t tail;
+    size_t message_count;
+    /* the records being sent are the sending_count oldest ones, sending_end follows the last of them */
+    size_t sending_count;
+    size_t sending_end;
+    XIO_BUFFER* send_buffers;
+    size_t send_buffer_count;
+    ON_SEND_COMPLETE on_send_complete;
+    void* on_send_complete_context;
+} PERSISTENT_QUEUE;
+
+/* CRC-32 (the one of zlib and Ethernet), 4 bits at a time */
+static const uint32_t crc32_nibble_table[16] =
+{
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+static uint32_t crc32_update(uint32_t crc, const unsigned char* bytes, size_t size)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        crc ^= bytes[i];
+        crc = (crc >> 4) ^ crc32_nibble_table[crc & 0x0F];
+        crc = (crc >> 4) ^ crc32_nibble_table[crc & 0x0F];
+    }
+
+    return crc;
+}
+
+static uint32_t compute_header_crc(const QUEUE_HEADER* header)
+{
+    return ~crc32_update(0xFFFFFFFF, (const unsigned char*)header, offsetof(QUEUE_HEADER, crc));
+}
+
+static uint32_t compute_record_crc(const RECORD_HEADER* record, const unsigned char* payload)
+{
+    uint32_t crc = crc32_update(0xFFFFFFFF, (const unsigned char*)&record->size, offsetof(RECORD_HEADER, crc) - offsetof(RECORD_HEADER, size));
+    return ~crc32_update(crc, payload, record->size);
+}
+
+static RECORD_HEADER* record_at(PERSISTENT_QUEUE* persistent_queue, size_t offset)
+{
+    return (RECORD_HEADER*)(persistent_queue->base + offset);
+}
+
+static bool is_valid_wrap(PERSISTENT_QUEUE* persistent_queue, size_t offset, uint64_t sequence)
+{
+    RECORD_HEADER* record = record_at(persistent_queue, offset);
+    return (record->magic == WRAP_MAGIC) && (record->size == 0) && (record->sequence == sequence) &&
+        (record->crc == compute_record_crc(record, NULL));
+}
+
+static bool is_valid_record(PERSISTENT_QUEUE* persistent_queue, size_t offset, uint64_t sequence)
+{
+    RECORD_HEADER* record = record_at(persistent_queue, offset);
+    return (record->magic == RECORD_MAGIC) && (record->sequence == sequence) &&
+        (record->size <= persistent_queue->capacity - offset - RECORD_HEADER_SIZE) &&
+        (record->crc == compute_record_crc(record, persistent_queue->base + offset + RECORD_HEADER_SIZE));
+}
+
+/* where the record that goes at offset really is, behind a wrap that the queue wrote */
+static size_t skip_wrap(PERSISTENT_QUEUE* persistent_queue, size_t offset)
+{
+    size_t result;
+
+    if ((persistent_queue->capacity - offset < RECORD_HEADER_SIZE) ||
+        (record_at(persistent_queue, offset)->magic == WRAP_MAGIC))
+    {
+        result = RECORDS_START;
+    }
+    else
+    {
+        result = offset;
+    }
+
+    return result;
+}
+
+static void write_header(PERSISTENT_QUEUE* persistent_queue)
+{
+    QUEUE_HEADER* header;
+
+    persistent_queue->generation++;
+    header = (QUEUE_HEADER*)(persistent_queue->base + (size_t)(persistent_queue->generation % HEADER_SLOT_COUNT) * HEADER_SLOT_SIZE);
+    header->magic = QUEUE_MAGIC;
+    header->version = QUEUE_VERSION;
+    header->capacity = persistent_queue->capacity;
+    header->generation = persistent_queue->generation;
+    header->head = persistent_queue->head;
+    header->head_sequence = persistent_queue->head_sequence;
+    header->crc = compute_header_crc(header);
+    header->reserved = 0;
+}
+
+static const QUEUE_HEADER* find_current_header(PERSISTENT_QUEUE* persistent_queue)
+{
+    const QUEUE_HEADER* result = NULL;
+    size_t i;
+
+    for (i = 0; i < HEADER_SLOT_COUNT; i++)
+    {
+        const QUEUE_HEADER* header = (const QUEUE_HEADER*)(persistent_queue->base + (i * HEADER_SLOT_SIZE));
+
+        if ((header->magic == QUEUE_MAGIC) &&
+            (header->version == QUEUE_VERSION) &&
+            (header->capacity == persistent_queue->capacity) &&
+            (header->head >= RECORDS_START) &&
+            (header->head <= persistent_queue->capacity) &&
+            ((header->head % 8) == 0) &&
+            (header->crc == compute_header_crc(header)) &&
+            ((result == NULL) || (header->generation > result->generation)))
+        {
+            result = header;
+        }
+    }
+
+    return result;
+}
+
+/* follows the records from the head of the header for as long as they have the next sequence number and a valid CRC */
+static void recover_records(PERSISTENT_QUEUE* persistent_queue)
+{
+    size_t offset = persistent_queue->head;
+    uint64_t sequence = persistent_queue->head_sequence;
+
+    for (;;)
+    {
+        size_t record_offset = offset;
+
+        if (persistent_queue->capacity - record_offset < RECORD_HEADER_SIZE)
+        {
+            record_offset = RECORDS_START;
+        }
+        else if (is_valid_wrap(persistent_queue, record_offset, sequence))
+        {
+            record_offset = RECORDS_START;
+        }
+
+        if (!is_valid_record(persistent_queue, record_offset, sequence) ||
+            /* a ring full of records that chain up would otherwise be followed forever */
+            (persistent_queue->message_count > persistent_queue->capacity / RECORD_HEADER_SIZE))
+        {
+            break;
+        }
+
+        if (persistent_queue->message_count == 0)
+        {
+            persistent_queue->head = record_offset;
+        }
+        persistent_queue->message_count++;
+        sequence++;
+        offset = record_offset + RECORD_SIZE(record_at(persistent_queue, record_offset)->size);
+    }
+
+    persistent_queue->tail = offset;
+}
+
+PERSISTENT_QUEUE_HANDLE persistent_queue_create(const char* file_path, size_t capacity)
+{
+    PERSISTENT_QUEUE* result;
+
+    if ((file_path == NULL) || (capacity < PERSISTENT_QUEUE_MIN_CAPACITY) || ((capacity % 8) != 0))
+    {
+        /* Codes_SRS_PERSISTENT_QUEUE_01_001: [ If file_path is NULL, or capacity is smaller than PERSISTENT_QUEUE_MIN_CAPACITY or not a multiple of 8, persistent_queue_create shall fail and return NULL. ]*/
+        LogError("Invalid arguments: file_path = %p, capacity = %lu", file_path, (unsigned long)capacity);
+        result = NULL;
+    }
+    else if ((result = (PERSISTENT_QUEUE*)malloc(sizeof(PERSISTENT_QUEUE))) == NULL)
+    {
+        /* Codes_SRS_PERSISTENT_QUEUE_01_002: [ If allocating memory for the queue fails, persistent_queue_create shall fail and return NULL. ]*/
+        LogError("Cannot allocate the persistent queue");
+    }
+    else
+    {
+        bool created;
+
+        (void)memset(result, 0, sizeof(PERSISTENT_QUEUE));
+        result->capacity = capacity;
+
+        /* Codes_SRS_PERSISTENT_QUEUE_01_003: [ persistent_queue_create shall map the capacity bytes of the file at file_path by calling file_mapping_open. ]*/
+        if ((result->file_mapping = file_mapping_open(file_path, capacity, &created)) == NULL)
+        {
+            /* Codes_SRS_PERSISTENT_QUEUE_01_004: [ If file_mapping_open fails, persistent_queue_create shall fail and return NULL. ]*/
+            LogError("Cannot map %s", file_path);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            result->base = file_mapping_get_address(result->file_mapping);
+
+            if (created)
+            {
+                /* Codes_SRS_PERSISTENT_QUEUE_01_005: [ When the file was created, persistent_queue_create shall write an empty queue to it. ]*/
+                result->head = RECORDS_START;
+                result->tail = RECORDS_START;
+                write_header(result);
+            }
+            else
+            {
+                const QUEUE_HEADER* header = find_current_header(result);
+
+                if (header == NULL)
+                {
+                    /* Codes_SRS_PERSISTENT_QUEUE_01_006: [ If none of the header slots of an existing file holds a valid header for capacity bytes, persistent_queue_create shall fail and return NULL, leaving the file as it is. ]*/
+                    LogError("%s does not hold a persistent queue of %lu bytes", file_path, (unsigned long)capacity);
+                    file_mapping_close(result->file_mapping);
+                    free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    /* Codes_SRS_PERSISTENT_QUEUE_01_007: [ Otherwise persistent_queue_create shall take the header slot with the highest generation among the valid ones. ]*/
+                    result->generation = header->generation;
+                    result->head = (size_t)header->head;
+                    result->head_sequence = header->head_sequence;
+
+                    /* Codes_SRS_PERSISTENT_QUEUE_01_008: [ persistent_queue_create shall keep the records that follow the head of the header, for as long as each one has the next sequence number and a valid CRC. ]*/
+                    /* Codes_SRS_PERSISTENT_QUEUE_01_009: [ The next message pushed shall go where the first record that is not kept starts. ]*/
+                    recover_records(result);
+                }
+            }
+        }
+    }
+
+    /* Codes_SRS_PERSISTENT_QUEUE_01_010: [ On success persistent_queue_create shall return a non-NULL handle. ]*/
+    return result;
+}
+
+void persistent_queue_destroy(PERSISTENT_QUEUE_HANDLE persistent_queue)
+{
+    if (persistent_queue == NULL)
+    {
+        /* Codes_SRS_PERSISTENT_QUEUE_01_011: [ If persistent_queue is NULL, persistent_queue_destroy shall return. ]*/
+        LogError("NULL persistent_queue");
+    }
+    else
+    {
+        if (persistent_queue->sending_count != 0)
+        {
+            LogError("Destroying a persistent queue while a send is in progress");
+        }
+
+        /* Codes_SRS_PERSISTENT_QUEUE_01_012: [ persistent_queue_destroy shall close the file mapping with file_mapping_close and free the queue. ]*/
+        file_mapping_close(persistent_queue->file_mapping);
+        free(persistent_queue->send_buffers);
+        free(persistent_queue);
+    }
+}
+
+int persistent_queue_push(PERSISTENT_QUEUE_HANDLE persistent_queue, CONSTBUFFER_HANDLE payload)
+{
+    int result;
+    const CONSTBUFFER* content;
+
+    if ((persistent_queue == NULL) || (payload == NULL))
+    {
+        /* Codes_SRS_PERSISTENT_QUEUE_01_013: [ If persistent_queue or payload is NULL, persistent_queue_push shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: persistent_queue = %p, payload = %p", persistent_queue, payload);
+        result = __FAILURE__;
+    }
+    else if ((content = CONSTBUFFER_GetContent(payload)) == NULL)
+    {
+        LogError("Cannot get the content of the payload");
+        result = __FAILURE__;
+    }
+    else if ((content->size > UINT32_MAX) ||
+        (content->size > persistent_queue->capacity - RECORDS_START - RECORD_HEADER_SIZE))
+    {
+        /* Codes_SRS_PERSISTENT_QUEUE_01_014: [ If the record of the payload would not fit in an empty queue, persistent_queue_push shall fail and return a non-zero value. ]*/
+        LogError("A payload of %lu bytes does not fit in the queue", (unsigned long)content->size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t record_size = RECORD_SIZE(content->size);
+        size_t offset;
+        bool wraps = false;
+        bool fits;
+
+        /* Codes_SRS_PERSISTENT_QUEUE_01_015: [ persistent_queue_push shall place the record after the newest one, or at the start of the records when there is not enough room before the end of the file. ]*/
+        if ((persistent_queue->message_count == 0) || (persistent_queue->tail > persistent_queue->head))
+        {
+            if (record_size <= persistent_queue->capacity - persistent_queue->tail)
+            {
+                fits = true;
+            }
+            else
+            {
+                wraps = true;
+                fits = (persistent_queue->message_count == 0) || (RECORDS_START + record_size <= persistent_queue->head);
+            }
+        }
+        else
+        {
+            fits = (persistent_queue->tail + record_size <= persistent_queue->head);
+        }
+
+        if (!fits)
+        {
+            /* Codes_SRS_PERSISTENT_QUEUE_01_016: [ If the record would overwrite one of the records in the queue, persistent_queue_push shall fail and return a non-zero value. ]*/
+            LogError("The queue has no room left for a payload of %lu bytes", (unsigned long)content->size);
+            result = __FAILURE__;
+        }
+        else
+        {
+            uint64_t sequence = persistent_queue->head_sequence + persistent_queue->message_count;
+            RECORD_HEADER* record;
+
+            if (!wraps)
+            {
+                offset = persistent_queue->tail;
+            }
+            else
+            {
+                /* Codes_SRS_PERSISTENT_QUEUE_01_017: [ When the record goes to the start of the records, a wrap marker with the sequence number of the record shall be written where the record would have gone, if there is room for it. ]*/
+                if (persistent_queue->capacity - persistent_queue->tail >= RECORD_HEADER_SIZE)
+                {
+                    RECORD_HEADER* wrap = record_at(persistent_queue, persistent_queue->tail);
+                    wrap->magic = WRAP_MAGIC;
+                    wrap->size = 0;
+                    wrap->sequence = sequence;
+                    wrap->crc = compute_record_crc(wrap, NULL);
+                    wrap->reserved = 0;
+                }
+
+                offset = RECORDS_START;
+            }
+
+            /* Codes_SRS_PERSISTENT_QUEUE_01_018: [ The record shall hold the size of the payload, the next sequence number, a CRC-32 of both and of the payload, followed by a copy of the payload. ]*/
+            record = record_at(persistent_queue, offset);
+            if (content->size > 0)
+            {
+                (void)memcpy(persistent_queue->base + offset + RECORD_HEADER_SIZE, content->buffer, content->size);
+            }
+            record->size = (uint32_t)content->size;
+            record->sequence = sequence;
+            record->crc = compute_record_crc(record, persistent_queue->base + offset + RECORD_HEADER_SIZE);
+            record->reserved = 0;
+            record->magic = RECORD_MAGIC;
+
+            if (persistent_queue->message_count == 0)
+            {
+                persistent_queue->head = offset;
+            }
+            persistent_queue->tail = offset + record_size;
+            persistent_queue->message_count++;
+
+            /* Codes_SRS_PERSISTENT_QUEUE_01_019: [ On success persistent_queue_push shall return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void on_xio_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    PERSISTENT_QUEUE* persistent_queue = (PERSISTENT_QUEUE*)context;
+    ON_SEND_COMPLETE on_send_complete = persistent_queue->on_send_complete;
+    void* on_send_complete_context = persistent_queue->on_send_complete_context;
+
+    if (send_result == IO_SEND_OK)
+    {
+        /* Codes_SRS_PERSISTENT_QUEUE_01_027: [ When the send completes with IO_SEND_OK, the messages sent shall be removed from the queue by writing a header whose head is the record that follows them. ]*/
+        persistent_queue->head = persistent_queue->sending_end;
+        persistent_queue->head_sequence += persistent_queue->sending_count;
+        persistent_queue->message_count -= persistent_queue->sending_count;
+        if (persistent_queue->message_count > 0)
+        {
+            persistent_queue->head = skip_wrap(persistent_queue, persistent_queue->head);
+        }
+        write_header(persistent_queue);
+    }
+    else
+    {
+        /* Codes_SRS_PERSISTENT_QUEUE_01_028: [ Otherwise the messages shall stay in the queue, to be sent again. ]*/
+        LogError("Sending %lu messages of the persistent queue failed", (unsigned long)persistent_queue->sending_count);
+    }
+
+    persistent_queue->sending_count = 0;
+
+    /* Codes_SRS_PERSISTENT_QUEUE_01_029: [ Then on_send_complete shall be called with on_send_complete_context and the send result. ]*/
+    if (on_send_complete != NULL)
+    {
+        on_send_complete(on_send_complete_context, send_result);
+    }
+}
+
+int persistent_queue_send(PERSISTENT_QUEUE_HANDLE persistent_queue, XIO_HANDLE xio, size_t max_message_count, size_t* sent_message_count, ON_SEND_COMPLETE on_send_complete, void* on_send_complete_context)
+{
+    int result;
+
+    if ((persistent_queue == NULL) || (xio == NULL) || (max_message_count == 0) || (sent_message_count == NULL))
+    {
+        /* Codes_SRS_PERSISTENT_QUEUE_01_020: [ If persistent_queue, xio or sent_message_count is NULL, or max_message_count is 0, persistent_queue_send shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: persistent_queue = %p, xio = %p, max_message_count = %lu, sent_message_count = %p",
+            persistent_queue, xio, (unsigned long)max_message_count, sent_message_count);
+        result = __FAILURE__;
+    }
+    else if (persistent_queue->sending_count != 0)
+    {
+        /* Codes_SRS_PERSISTENT_QUEUE_01_021: [ If a send of the queue is in progress, persistent_queue_send shall fail and return a non-zero value. ]*/
+        LogError("A send of the persistent queue is in progress");
+        result = __FAILURE__;
+    }
+    else if (persistent_queue->message_count == 0)
+    {
+        /* Codes_SRS_PERSISTENT_QUEUE_01_022: [ If the queue is empty, persistent_queue_send shall set sent_message_count to 0 and return 0 without sending. ]*/
+        *sent_message_count = 0;
+        result = 0;
+    }
+    else
+    {
+        size_t message_count = (max_message_count < persistent_queue->message_count) ? max_message_count : persistent_queue->message_count;
+
+        if (message_count > persistent_queue->send_buffer_count)
+        {
+            /* Codes_SRS_PERSISTENT_QUEUE_01_023: [ persistent_queue_send shall grow the array of XIO_BUFFERs it keeps to hold one for each of the messages to send. ]*/
+            XIO_BUFFER* send_buffers = (XIO_BUFFER*)realloc(persistent_queue->send_buffers, message_count * sizeof(XIO_BUFFER));
+            if (send_buffers == NULL)
+            {
+                /* Codes_SRS_PERSISTENT_QUEUE_01_024: [ If growing the array fails, persistent_queue_send shall fail and return a non-zero value. ]*/
+                LogError("Cannot allocate %lu send buffers", (unsigned long)message_count);
+                message_count = 0;
+            }
+            else
+            {
+                persistent_queue->send_buffers = send_buffers;
+                persistent_queue->send_buffer_count = message_count;
+            }
+        }
+
+        if (message_count == 0)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t offset = persistent_queue->head;
+            size_t i;
+
+            /* Codes_SRS_PERSISTENT_QUEUE_01_025: [ persistent_queue_send shall point the XIO_BUFFERs at the payloads of the up to max_message_count oldest messages, in the mapping, and send them with xio_sendv. ]*/
+            for (i = 0; i < message_count; i++)
+            {
+                RECORD_HEADER* record;
+
+                if (i > 0)
+                {
+                    offset = skip_wrap(persistent_queue, offset);
+                }
+
+                record = record_at(persistent_queue, offset);
+                persistent_queue->send_buffers[i].buffer = persistent_queue->base + offset + RECORD_HEADER_SIZE;
+                persistent_queue->send_buffers[i].size = record->size;
+                offset += RECORD_SIZE(record->size);
+            }
+
+            persistent_queue->sending_count = message_count;
+            persistent_queue->sending_end = offset;
+            persistent_queue->on_send_complete = on_send_complete;
+            persistent_queue->on_send_complete_context = on_send_complete_context;
+            *sent_message_count = message_count;
+
+            if (xio_sendv(xio, persistent_queue->send_buffers, message_count, on_xio_send_complete, persistent_queue) != 0)
+            {
+                /* Codes_SRS_PERSISTENT_QUEUE_01_026: [ If xio_sendv fails, persistent_queue_send shall fail and return a non-zero value, leaving the messages in the queue. ]*/
+                LogError("xio_sendv failed");
+                persistent_queue->sending_count = 0;
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_PERSISTENT_QUEUE_01_030: [ On success persistent_queue_send shall set sent_message_count to the number of messages sent and return 0. ]*/
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+int persistent_queue_get_count(PERSISTENT_QUEUE_HANDLE persistent_queue, size_t* message_count)
+{
+    int result;
+
+    if ((persistent_queue == NULL) || (message_count == NULL))
+    {
+        /* Codes_SRS_PERSISTENT_QUEUE_01_031: [ If persistent_queue or message_count is NULL, persistent_queue_get_count shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: persistent_queue = %p, message_count = %p", persistent_queue, message_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_PERSISTENT_QUEUE_01_032: [ Otherwise persistent_queue_get_count shall set message_count to the number of messages in the queue, including the ones being sent, and return 0. ]*/
+        *message_count = persistent_queue->message_count;
+        result = 0;
+    }
+
+    return result;
+}
+
+int persistent_queue_flush(PERSISTENT_QUEUE_HANDLE persistent_queue)
+{
+    int result;
+
+    if (persistent_queue == NULL)
+    {
+        /* Codes_SRS_PERSISTENT_QUEUE_01_033: [ If persistent_queue is NULL, persistent_queue_flush shall fail and return a non-zero value. ]*/
+        LogError("NULL persistent_queue");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_PERSISTENT_QUEUE_01_034: [ persistent_queue_flush shall flush the whole file with file_mapping_flush. ]*/
+    else if (file_mapping_flush(persistent_queue->file_mapping, 0, persistent_queue->capacity) != 0)
+    {
+        /* Codes_SRS_PERSISTENT_QUEUE_01_035: [ If file_mapping_flush fails, persistent_queue_flush shall fail and return a non-zero value. ]*/
+        LogError("Cannot flush the persistent queue");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_PERSISTENT_QUEUE_01_036: [ On success persistent_queue_flush shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
@@ -4,9 +4,9 @@
 #include <stdlib.h>
 #include <stdio.h>
 #include <string.h>
+#include <stdint.h>
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/sastoken.h"
-#include "azure_c_shared_utility/urlencode.h"
 #include "azure_c_shared_utility/hmacsha256.h"
 #include "azure_c_shared_utility/base64.h"
 #include "azure_c_shared_utility/agenttime.h"
@@ -14,187 +14,129 @@
 #include "azure_c_shared_utility/buffer_.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
+#include "azure_c_shared_utility/optimize_size.h"
 
-static double getExpiryValue(const char* expiryASCII)
+#define SAS_TOKEN_FIELD_NOT_FOUND ((size_t)-1)
+#define SAS_TOKEN_FIELD_COUNT 3
+
+/* where the value of a field of the token starts, and where the separator that ends it is */
+typedef struct SAS_TOKEN_FIELD_TAG
+{
+    const char* name;
+    size_t name_length;
+    size_t start;
+    size_t stop;
+} SAS_TOKEN_FIELD;
+
+/* the expiry has digits only and fits in 64 bits, 0 when it does not */
+static uint64_t parse_expiry(const char* value, size_t length)
 {
-    double value = 0;
-    size_t i = 0;
-    for (i = 0; expiryASCII[i] != '\0'; i++)
+    uint64_t result = 0;
+    size_t i;
+
+    for (i = 0; i < length; i++)
     {
-        if (expiryASCII[i] >= '0' && expiryASCII[i] <= '9')
-        {
-            value = value * 10 + (double)(expiryASCII[i] - '0');
-        }
-        else
+        if ((value[i] < '0') || (value[i] > '9') ||
+            (result > (UINT64_MAX - 9) / 10))
         {
-            value = 0;
+            result = 0;
             break;
         }
+        result = (result * 10) + (uint64_t)(value[i] - '0');
     }
-    return value;
+
+    return result;
 }
 
-bool SASToken_Validate(STRING_HANDLE sasToken)
+bool SASToken_ValidateString(const char* sasToken, size_t sasTokenLength)
 {
     bool result;
-    /*Codes_SRS_SASTOKEN_25_025: [**SASToken_Validate shall get the SASToken value by invoking STRING_c_str on the handle.**]***/
-    const char* sasTokenArray = STRING_c_str(sasToken);
 
-    /* Codes_SRS_SASTOKEN_25_024: [**If handle is NULL then SASToken_Validate shall return false.**] */
-    /* Codes_SRS_SASTOKEN_25_026: [**If STRING_c_str on handle return NULL then SASToken_Validate shall return false.**] */
-    if (sasToken == NULL || sasTokenArray == NULL)
+    /*Codes_SRS_SASTOKEN_01_013: [ If sasToken is NULL then SASToken_ValidateString shall return false. ]*/
+    if (sasToken == NULL)
     {
         result = false;
     }
     else
     {
-        int seStart = -1, seStop = -1;
-        int srStart = -1, srStop = -1;
-        int sigStart = -1, sigStop = -1;
-        int tokenLength = (int)STRING_length(sasToken);
-        int i;
-        for (i = 0; i < tokenLength; i++)
+        /*Codes_SRS_SASTOKEN_01_014: [ SASToken_ValidateString shall scan the sasTokenLength characters of sasToken in place, allocating no memory. ]*/
+        SAS_TOKEN_FIELD fields[SAS_TOKEN_FIELD_COUNT] =
         {
-            if (sasTokenArray[i] == 's' && sasTokenArray[i + 1] == 'e' && sasTokenArray[i + 2] == '=') // Look for se=
-            {
-                seStart = i + 3;
-                if (srStart > 0 && srStop < 0)
-                {
-                    if (sasTokenArray[i - 1] != '&' && sasTokenArray[i - 1] == ' ') // look for either & or space
-                        srStop = i - 1;
-                    else if (sasTokenArray[i - 1] == '&')
-                        srStop = i - 2;
-                    else
-                        seStart = -1; // as the format is not either "&se=" or " se="
-                }
-                else if (sigStart > 0 && sigStop < 0)
-                {
-                    if (sasTokenArray[i - 1] != '&' && sasTokenArray[i - 1] == ' ')
-                        sigStop = i - 1;
-                    else if (sasTokenArray[i - 1] == '&')
-                        sigStop = i - 2;
-                    else
-                        seStart = -1;
-                }
-            }
-            else if (sasTokenArray[i] == 's' && sasTokenArray[i + 1] == 'r' && sasTokenArray[i + 2] == '=') // Look for sr=
-            {
-                srStart = i + 3;
-                if (seStart > 0 && seStop < 0)
-                {
-                    if (sasTokenArray[i - 1] != '&' && sasTokenArray[i - 1] == ' ')
-                        seStop = i - 1;
-                    else if (sasTokenArray[i - 1] == '&')
-                        seStop = i - 2;
-                    else
-                        srStart = -1;
-                }
-                else if (sigStart > 0 && sigStop < 0)
-                {
-                    if (sasTokenArray[i - 1] != '&' && sasTokenArray[i - 1] == ' ')
-                        sigStop = i - 1;
-                    else if (sasTokenArray[i - 1] == '&')
-                        sigStop = i - 2;
-                    else
-                        srStart = -1;
-                }
-            }
-            else if (sasTokenArray[i] == 's' && sasTokenArray[i + 1] == 'i' && sasTokenArray[i + 2] == 'g' && sasTokenArray[i + 3] == '=') // Look for sig=
+            { "se=", 3, SAS_TOKEN_FIELD_NOT_FOUND, SAS_TOKEN_FIELD_NOT_FOUND },
+            { "sr=", 3, SAS_TOKEN_FIELD_NOT_FOUND, SAS_TOKEN_FIELD_NOT_FOUND },
+            { "sig=", 4, SAS_TOKEN_FIELD_NOT_FOUND, SAS_TOKEN_FIELD_NOT_FOUND }
+        };
+        SAS_TOKEN_FIELD* open_field = NULL;
+        size_t i;
+        size_t j;
+
+        for (i = 0; i < sasTokenLength; i++)
+        {
+            for (j = 0; j < SAS_TOKEN_FIELD_COUNT; j++)
             {
-                sigStart = i + 4;
-                if (srStart > 0 && srStop < 0)
-                {
-                    if (sasTokenArray[i - 1] != '&' && sasTokenArray[i - 1] == ' ')
-                        srStop = i - 1;
-                    else if (sasTokenArray[i - 1] == '&')
-                        srStop = i - 2;
-                    else
-                        sigStart = -1;
-                }
-                else if (seStart > 0 && seStop < 0)
+                if ((sasTokenLength - i >= fields[j].name_length) &&
+                    (memcmp(sasToken + i, fields[j].name, fields[j].name_length) == 0))
                 {
-                    if (sasTokenArray[i - 1] != '&' && sasTokenArray[i - 1] == ' ')
-                        seStop = i - 1;
-                    else if (sasTokenArray[i - 1] == '&')
-                        seStop = i - 2;
-                    else
-                        sigStart = -1;
+                    if ((open_field != NULL) && (open_field != &fields[j]))
+                    {
+                        /* a field is ended by the "&" or " " before the next one */
+                        if ((sasToken[i - 1] == '&') || (sasToken[i - 1] == ' '))
+                        {
+                            open_field->stop = i - 1;
+                            open_field = NULL;
+                        }
+                        else
+                        {
+                            fields[j].start = SAS_TOKEN_FIELD_NOT_FOUND;
+                            break;
+                        }
+                    }
+
+                    fields[j].start = i + fields[j].name_length;
+                    fields[j].stop = SAS_TOKEN_FIELD_NOT_FOUND;
+                    open_field = &fields[j];
+                    break;
                 }
             }
         }
 
-        /*Codes_SRS_SASTOKEN_25_027: [**If SASTOKEN does not obey the SASToken format then SASToken_Validate shall return false.**]***/
-        /*Codes_SRS_SASTOKEN_25_028: [**SASToken_validate shall check for the presence of sr, se and sig from the token and return false if not found**]***/
-        if (seStart < 0 || srStart < 0 || sigStart < 0)
+        if (open_field != NULL)
         {
-            result = false;
+            open_field->stop = sasTokenLength;
         }
-        else
+
+        /*Codes_SRS_SASTOKEN_25_027: [**If SASTOKEN does not obey the SASToken format then SASToken_Validate shall return false.**]***/
+        /*Codes_SRS_SASTOKEN_25_028: [**SASToken_validate shall check for the presence of sr, se and sig from the token and return false if not found**]***/
+        result = true;
+        for (j = 0; j < SAS_TOKEN_FIELD_COUNT; j++)
         {
-            if (seStop < 0)
+            if ((fields[j].start == SAS_TOKEN_FIELD_NOT_FOUND) ||
+                (fields[j].stop == SAS_TOKEN_FIELD_NOT_FOUND) ||
+                (fields[j].stop <= fields[j].start))
             {
-                seStop = tokenLength;
-            }
-            else if (srStop < 0)
-            {
-                srStop = tokenLength;
-            }
-            else if (sigStop < 0)
-            {
-                sigStop = tokenLength;
+                result = false;
+                break;
             }
+        }
+
+        if (result)
+        {
+            /* the expiry ends at the "&" of a field other than sr and sig, such as skn */
+            const char* expiry_start = sasToken + fields[0].start;
+            const char* expiry_end = (const char*)memchr(expiry_start, '&', fields[0].stop - fields[0].start);
+            /*Codes_SRS_SASTOKEN_01_015: [ The expiry shall be parsed as an integer; if it is not only digits or does not fit in 64 bits, SASToken_ValidateString shall return false. ]*/
+            uint64_t expiry = parse_expiry(expiry_start, (expiry_end == NULL) ? (fields[0].stop - fields[0].start) : (size_t)(expiry_end - expiry_start));
 
-            if ((seStop <= seStart) ||
-                (srStop <= srStart) ||
-                (sigStop <= sigStart))
+            /*Codes_SRS_SASTOKEN_25_029: [**SASToken_validate shall check for expiry time from token and if token has expired then would return false **]***/
+            if ((expiry == 0) ||
+                ((double)expiry < get_difftime(get_time_coarse(), (time_t)0)))
             {
                 result = false;
             }
             else
             {
-                char* expiryASCII = (char*)malloc(seStop - seStart + 1);
-                /*Codes_SRS_SASTOKEN_25_031: [**If malloc fails during validation then SASToken_Validate shall return false.**]***/
-                if (expiryASCII == NULL)
-                {
-                    result = false;
-                }
-                else
-                {
-                    double expiry;
-                    // Add the Null terminator here
-                    memset(expiryASCII, 0, seStop - seStart + 1);
-                    for (i = seStart; i < seStop; i++)
-                    {
-                        // The se contains the expiration values, if a & token is encountered then
-                        // the se field is complete.
-                        if (sasTokenArray[i] == '&')
-                        {
-                            break;
-                        }
-                        expiryASCII[i - seStart] = sasTokenArray[i];
-                    }
-                    expiry = getExpiryValue(expiryASCII);
-                    /*Codes_SRS_SASTOKEN_25_029: [**SASToken_validate shall check for expiry time from token and if token has expired then would return false **]***/
-                    if (expiry <= 0)
-                    {
-                        result = false;
-                    }
-                    else
-                    {
-                        double secSinceEpoch = get_difftime(get_time(NULL), (time_t)0);
-                        if (expiry < secSinceEpoch)
-                        {
-                            /*Codes_SRS_SASTOKEN_25_029: [**SASToken_validate shall check for expiry time from token and if token has expired then would return false **]***/
-                            result = false;
-                        }
-                        else
-                        {
-                            /*Codes_SRS_SASTOKEN_25_030: [**SASToken_validate shall return true only if the format is obeyed and the token has not yet expired **]***/
-                            result = true;
-                        }
-                    }
-                    free(expiryASCII);
-                }
+                /*Codes_SRS_SASTOKEN_25_030: [**SASToken_validate shall return true only if the format is obeyed and the token has not yet expired **]***/
+                result = true;
             }
         }
     }
@@ -202,101 +144,250 @@ bool SASToken_Validate(STRING_HANDLE sasToken)
     return result;
 }
 
-static STRING_HANDLE construct_sas_token(const char* key, const char* scope, const char* keyname, size_t expiry)
+bool SASToken_Validate(STRING_HANDLE sasToken)
+{
+    bool result;
+    /*Codes_SRS_SASTOKEN_25_025: [**SASToken_Validate shall get the SASToken value by invoking STRING_c_str on the handle.**]***/
+    const char* sasTokenArray = STRING_c_str(sasToken);
+
+    /* Codes_SRS_SASTOKEN_25_024: [**If handle is NULL then SASToken_Validate shall return false.**] */
+    /* Codes_SRS_SASTOKEN_25_026: [**If STRING_c_str on handle return NULL then SASToken_Validate shall return false.**] */
+    if (sasToken == NULL || sasTokenArray == NULL)
+    {
+        result = false;
+    }
+    else
+    {
+        /*Codes_SRS_SASTOKEN_01_016: [ Otherwise SASToken_Validate shall return the result of SASToken_ValidateString on the value and length of the handle. ]*/
+        result = SASToken_ValidateString(sasTokenArray, STRING_length(sasToken));
+    }
+
+    return result;
+}
+
+#define SAS_TOKEN_PREFIX "SharedAccessSignature sr="
+#define SAS_TOKEN_SIGNATURE_FIELD "&sig="
+#define SAS_TOKEN_EXPIRY_FIELD "&se="
+#define SAS_TOKEN_KEYNAME_FIELD "&skn="
+
+/* writes digit as URL_Encode would write the base64 digit (64 is the padding "="), returns the number of characters;
+   destination NULL only counts them */
+static size_t write_url_encoded_base64_digit(char* destination, unsigned int digit)
+{
+    static const char base64_digits[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/=";
+    static const char* const escaped_digits[] = { "%2b", "%2f", "%3d" };
+    size_t result;
+
+    if (digit < 62)
+    {
+        if (destination != NULL)
+        {
+            destination[0] = base64_digits[digit];
+        }
+        result = 1;
+    }
+    else
+    {
+        if (destination != NULL)
+        {
+            (void)memcpy(destination, escaped_digits[digit - 62], 3);
+        }
+        result = 3;
+    }
+
+    return result;
+}
+
+/* base64 encodes source and URL encodes the result in the same pass, returns the number of characters;
+   destination NULL only counts them */
+static size_t write_url_encoded_base64(char* destination, const unsigned char* source, size_t size)
+{
+    size_t result = 0;
+    size_t i;
+
+    for (i = 0; i < size; i += 3)
+    {
+        unsigned int group = (unsigned int)source[i] << 16;
+        unsigned int digits[4];
+        size_t j;
+
+        if (i + 1 < size)
+        {
+            group |= (unsigned int)source[i + 1] << 8;
+        }
+        if (i + 2 < size)
+        {
+            group |= (unsigned int)source[i + 2];
+        }
+
+        digits[0] = (group >> 18) & 0x3F;
+        digits[1] = (group >> 12) & 0x3F;
+        digits[2] = (i + 1 < size) ? ((group >> 6) & 0x3F) : 64;
+        digits[3] = (i + 2 < size) ? (group & 0x3F) : 64;
+
+        for (j = 0; j < 4; j++)
+        {
+            result += write_url_encoded_base64_digit((destination == NULL) ? NULL : destination + result, digits[j]);
+        }
+    }
+
+    return result;
+}
+
+static char* append_text(char* destination, const char* text, size_t length)
+{
+    (void)memcpy(destination, text, length);
+    return destination + length;
+}
+
+/* builds the token signed by hash in one buffer of its exact length */
+static STRING_HANDLE create_sas_token(BUFFER_HANDLE hash, const char* scope, const char* tokenExpirationTime, const char* keyname)
 {
     STRING_HANDLE result;
+    const unsigned char* hashBytes = BUFFER_u_char(hash);
+    size_t hashLength = BUFFER_length(hash);
+    size_t scopeLength = strlen(scope);
+    size_t expiryLength = strlen(tokenExpirationTime);
+    size_t keynameLength = (keyname == NULL) ? 0 : strlen(keyname);
+    size_t signatureLength = write_url_encoded_base64(NULL, hashBytes, hashLength);
+    size_t tokenLength = (sizeof(SAS_TOKEN_PREFIX) - 1) + scopeLength +
+        (sizeof(SAS_TOKEN_SIGNATURE_FIELD) - 1) + signatureLength +
+        (sizeof(SAS_TOKEN_EXPIRY_FIELD) - 1) + expiryLength +
+        ((keyname == NULL) ? 0 : ((sizeof(SAS_TOKEN_KEYNAME_FIELD) - 1) + keynameLength));
+    /*Codes_SRS_SASTOKEN_01_017: [ The token shall be written in one buffer allocated with its exact length, which becomes the result through STRING_new_with_memory. ]*/
+    char* token = (char*)malloc(tokenLength + 1);
 
-    char tokenExpirationTime[32] = { 0 };
+    /*Codes_SRS_SASTOKEN_06_014: [If there are any errors from the following operations then NULL shall be returned.]*/
+    if (token == NULL)
+    {
+        LogError("Unable to allocate memory for the SAS token.");
+        result = NULL;
+    }
+    else
+    {
+        char* current = token;
 
-    BUFFER_HANDLE decodedKey;
+        /*Codes_SRS_SASTOKEN_06_016: [The string "SharedAccessSignature sr=" is the first part of the result of SASToken_Create.]*/
+        current = append_text(current, SAS_TOKEN_PREFIX, sizeof(SAS_TOKEN_PREFIX) - 1);
+        /*Codes_SRS_SASTOKEN_06_017: [The scope parameter is appended to result.]*/
+        current = append_text(current, scope, scopeLength);
+        /*Codes_SRS_SASTOKEN_06_018: [The string "&sig=" is appended to result.]*/
+        current = append_text(current, SAS_TOKEN_SIGNATURE_FIELD, sizeof(SAS_TOKEN_SIGNATURE_FIELD) - 1);
+        /*Codes_SRS_SASTOKEN_06_015: [The hash is base 64 encoded.]*/
+        /*Codes_SRS_SASTOKEN_06_028: [base64Signature shall be url encoded.]*/
+        /*Codes_SRS_SASTOKEN_06_019: [The string urlEncodedSignature shall be appended to result.]*/
+        /*Codes_SRS_SASTOKEN_01_018: [ The hash shall be base64 encoded and URL encoded in the same pass. ]*/
+        current += write_url_encoded_base64(current, hashBytes, hashLength);
+        /*Codes_SRS_SASTOKEN_06_020: [The string "&se=" shall be appended to result.]*/
+        current = append_text(current, SAS_TOKEN_EXPIRY_FIELD, sizeof(SAS_TOKEN_EXPIRY_FIELD) - 1);
+        /*Codes_SRS_SASTOKEN_06_021: [tokenExpirationTime is appended to result.]*/
+        current = append_text(current, tokenExpirationTime, expiryLength);
+        if (keyname != NULL)
+        {
+            /*Codes_SRS_SASTOKEN_06_022: [If keyName is non-NULL, the string "&skn=" is appended to result.]*/
+            current = append_text(current, SAS_TOKEN_KEYNAME_FIELD, sizeof(SAS_TOKEN_KEYNAME_FIELD) - 1);
+            /*Codes_SRS_SASTOKEN_06_023: [If keyName is non-NULL, the argument keyName is appended to result.]*/
+            current = append_text(current, keyname, keynameLength);
+        }
+        *current = '\0';
 
-    /*Codes_SRS_SASTOKEN_06_029: [The key parameter is decoded from base64.]*/
-    if ((decodedKey = Base64_Decoder(key)) == NULL)
+        if ((result = STRING_new_with_memory(token)) == NULL)
+        {
+            LogError("Unable to create the SAS token string.");
+            free(token);
+        }
+    }
+
+    return result;
+}
+
+/* exactly one of decodedKey and keyContext is non-NULL */
+static STRING_HANDLE build_sas_token(BUFFER_HANDLE decodedKey, HMACSHA256_KEY_CONTEXT_HANDLE keyContext, const char* scope, const char* keyname, size_t expiry)
+{
+    STRING_HANDLE result;
+
+    char tokenExpirationTime[32] = { 0 };
+
+    /*Codes_SRS_SASTOKEN_06_026: [If the conversion to string form fails for any reason then SASToken_Create shall return NULL.]*/
+    if (size_tToString(tokenExpirationTime, sizeof(tokenExpirationTime), expiry) != 0)
     {
-        /*Codes_SRS_SASTOKEN_06_030: [If there is an error in the decoding then SASToken_Create shall return NULL.]*/
-        LogError("Unable to decode the key for generating the SAS.");
+        LogError("For some reason converting seconds to a string failed.  No SAS can be generated.");
         result = NULL;
     }
     else
     {
-        /*Codes_SRS_SASTOKEN_06_026: [If the conversion to string form fails for any reason then SASToken_Create shall return NULL.]*/
-        if (size_tToString(tokenExpirationTime, sizeof(tokenExpirationTime), expiry) != 0)
+        STRING_HANDLE toBeHashed = NULL;
+        BUFFER_HANDLE hash = NULL;
+        if (((hash = BUFFER_new()) == NULL) ||
+            ((toBeHashed = STRING_new()) == NULL))
         {
-            LogError("For some reason converting seconds to a string failed.  No SAS can be generated.");
+            LogError("Unable to allocate memory to prepare SAS token.");
+            result = NULL;
+        }
+        /*Codes_SRS_SASTOKEN_06_009: [The scope is the basis for creating a STRING_HANDLE.]*/
+        /*Codes_SRS_SASTOKEN_06_010: [A "\n" is appended to that string.]*/
+        /*Codes_SRS_SASTOKEN_06_011: [tokenExpirationTime is appended to that string.]*/
+        else if ((STRING_concat(toBeHashed, scope) != 0) ||
+            (STRING_concat(toBeHashed, "\n") != 0) ||
+            (STRING_concat(toBeHashed, tokenExpirationTime) != 0))
+        {
+            LogError("Unable to build the input to the HMAC to prepare SAS token.");
             result = NULL;
         }
         else
         {
-            STRING_HANDLE toBeHashed = NULL;
-            BUFFER_HANDLE hash = NULL;
-            if (((hash = BUFFER_new()) == NULL) ||
-                ((toBeHashed = STRING_new()) == NULL) ||
-                ((result = STRING_new()) == NULL))
+            HMACSHA256_RESULT hashResult;
+            size_t inLen = STRING_length(toBeHashed);
+            const unsigned char* inBuf = (const unsigned char*)STRING_c_str(toBeHashed);
+            if (keyContext != NULL)
             {
-                LogError("Unable to allocate memory to prepare SAS token.");
+                /*Codes_SRS_SASTOKEN_01_004: [ The HMAC256 hash shall be calculated with HMACSHA256_ComputeHashWithKeyContext using keyContext, over toBeHashed. ]*/
+                hashResult = HMACSHA256_ComputeHashWithKeyContext(keyContext, inBuf, inLen, hash);
+            }
+            else
+            {
+                size_t outLen = BUFFER_length(decodedKey);
+                unsigned char* outBuf = BUFFER_u_char(decodedKey);
+                hashResult = HMACSHA256_ComputeHash(outBuf, outLen, inBuf, inLen, hash);
+            }
+            /*Codes_SRS_SASTOKEN_06_013: [If an error is returned from the HMAC256 function then NULL is returned from SASToken_Create.]*/
+            /*Codes_SRS_SASTOKEN_06_012: [An HMAC256 hash is calculated using the decodedKey, over toBeHashed.]*/
+            if (hashResult != HMACSHA256_OK)
+            {
+                LogError("Unable to compute the signature of the SAS token.");
                 result = NULL;
             }
+            else if ((result = create_sas_token(hash, scope, tokenExpirationTime, keyname)) == NULL)
+            {
+                LogError("Unable to build the SAS token.");
+            }
             else
             {
-                /*Codes_SRS_SASTOKEN_06_009: [The scope is the basis for creating a STRING_HANDLE.]*/
-                /*Codes_SRS_SASTOKEN_06_010: [A "\n" is appended to that string.]*/
-                /*Codes_SRS_SASTOKEN_06_011: [tokenExpirationTime is appended to that string.]*/
-                if ((STRING_concat(toBeHashed, scope) != 0) ||
-                    (STRING_concat(toBeHashed, "\n") != 0) ||
-                    (STRING_concat(toBeHashed, tokenExpirationTime) != 0))
-                {
-                    LogError("Unable to build the input to the HMAC to prepare SAS token.");
-                    STRING_delete(result);
-                    result = NULL;
-                }
-                else
-                {
-                    STRING_HANDLE base64Signature = NULL;
-                    STRING_HANDLE urlEncodedSignature = NULL;
-                    size_t inLen = STRING_length(toBeHashed);
-                    const unsigned char* inBuf = (const unsigned char*)STRING_c_str(toBeHashed);
-                    size_t outLen = BUFFER_length(decodedKey);
-                    unsigned char* outBuf = BUFFER_u_char(decodedKey);
-                    /*Codes_SRS_SASTOKEN_06_013: [If an error is returned from the HMAC256 function then NULL is returned from SASToken_Create.]*/
-                    /*Codes_SRS_SASTOKEN_06_012: [An HMAC256 hash is calculated using the decodedKey, over toBeHashed.]*/
-                    /*Codes_SRS_SASTOKEN_06_014: [If there are any errors from the following operations then NULL shall be returned.]*/
-                    /*Codes_SRS_SASTOKEN_06_015: [The hash is base 64 encoded.]*/
-                    /*Codes_SRS_SASTOKEN_06_028: [base64Signature shall be url encoded.]*/
-                    /*Codes_SRS_SASTOKEN_06_016: [The string "SharedAccessSignature sr=" is the first part of the result of SASToken_Create.]*/
-                    /*Codes_SRS_SASTOKEN_06_017: [The scope parameter is appended to result.]*/
-                    /*Codes_SRS_SASTOKEN_06_018: [The string "&sig=" is appended to result.]*/
-                    /*Codes_SRS_SASTOKEN_06_019: [The string urlEncodedSignature shall be appended to result.]*/
-                    /*Codes_SRS_SASTOKEN_06_020: [The string "&se=" shall be appended to result.]*/
-                    /*Codes_SRS_SASTOKEN_06_021: [tokenExpirationTime is appended to result.]*/
-                    /*Codes_SRS_SASTOKEN_06_022: [If keyName is non-NULL, the string "&skn=" is appended to result.]*/
-                    /*Codes_SRS_SASTOKEN_06_023: [If keyName is non-NULL, the argument keyName is appended to result.]*/
-                    if ((HMACSHA256_ComputeHash(outBuf, outLen, inBuf, inLen, hash) != HMACSHA256_OK) ||
-                        ((base64Signature = Base64_Encoder(hash)) == NULL) ||
-                        ((urlEncodedSignature = URL_Encode(base64Signature)) == NULL) ||
-                        (STRING_copy(result, "SharedAccessSignature sr=") != 0) ||
-                        (STRING_concat(result, scope) != 0) ||
-                        (STRING_concat(result, "&sig=") != 0) ||
-                        (STRING_concat_with_STRING(result, urlEncodedSignature) != 0) ||
-                        (STRING_concat(result, "&se=") != 0) ||
-                        (STRING_concat(result, tokenExpirationTime) != 0) ||
-                        ((keyname != NULL) && (STRING_concat(result, "&skn=") != 0)) ||
-                        ((keyname != NULL) && (STRING_concat(result, keyname) != 0)))
-                    {
-                        LogError("Unable to build the SAS token.");
-                        STRING_delete(result);
-                        result = NULL;
-                    }
-                    else
-                    {
-                        /* everything OK */
-                    }
-                    STRING_delete(base64Signature);
-                    STRING_delete(urlEncodedSignature);
-                }
+                /* everything OK */
             }
-            STRING_delete(toBeHashed);
-            BUFFER_delete(hash);
         }
+        STRING_delete(toBeHashed);
+        BUFFER_delete(hash);
+    }
+    return result;
+}
+
+static STRING_HANDLE construct_sas_token(const char* key, const char* scope, const char* keyname, size_t expiry)
+{
+    STRING_HANDLE result;
+
+    BUFFER_HANDLE decodedKey;
+
+    /*Codes_SRS_SASTOKEN_06_029: [The key parameter is decoded from base64.]*/
+    if ((decodedKey = Base64_Decoder(key)) == NULL)
+    {
+        /*Codes_SRS_SASTOKEN_06_030: [If there is an error in the decoding then SASToken_Create shall return NULL.]*/
+        LogError("Unable to decode the key for generating the SAS.");
+        result = NULL;
+    }
+    else
+    {
+        result = build_sas_token(decodedKey, NULL, scope, keyname, expiry);
         BUFFER_delete(decodedKey);
     }
     return result;
@@ -344,3 +435,203 @@ STRING_HANDLE SASToken_CreateString(const char* key, const char* scope, const ch
     }
     return result;
 }
+
+HMACSHA256_KEY_CONTEXT_HANDLE SASToken_CreateKeyContext(const char* key)
+{
+    HMACSHA256_KEY_CONTEXT_HANDLE result;
+    BUFFER_HANDLE decodedKey;
+
+    if (key == NULL)
+    {
+        /*Codes_SRS_SASTOKEN_01_001: [ If key is NULL then SASToken_CreateKeyContext shall return NULL. ]*/
+        LogError("Invalid Parameter to SASToken_CreateKeyContext. key: %p", key);
+        result = NULL;
+    }
+    /*Codes_SRS_SASTOKEN_01_002: [ The key parameter shall be decoded from base64 and a key context shall be created from the decoded key by calling HMACSHA256_KeyContext_Create. ]*/
+    else if ((decodedKey = Base64_Decoder(key)) == NULL)
+    {
+        /*Codes_SRS_SASTOKEN_01_003: [ If decoding the key or creating the key context fails then SASToken_CreateKeyContext shall return NULL. ]*/
+        LogError("Unable to decode the key for generating the SAS.");
+        result = NULL;
+    }
+    else
+    {
+        size_t decodedKeyLength = BUFFER_length(decodedKey);
+        unsigned char* decodedKeyBytes = BUFFER_u_char(decodedKey);
+        if ((result = HMACSHA256_KeyContext_Create(decodedKeyBytes, decodedKeyLength)) == NULL)
+        {
+            /*Codes_SRS_SASTOKEN_01_003: [ If decoding the key or creating the key context fails then SASToken_CreateKeyContext shall return NULL. ]*/
+            LogError("Unable to create the key context for generating the SAS.");
+        }
+        BUFFER_delete(decodedKey);
+    }
+    return result;
+}
+
+STRING_HANDLE SASToken_CreateStringWithKeyContext(HMACSHA256_KEY_CONTEXT_HANDLE keyContext, const char* scope, const char* keyName, size_t expiry)
+{
+    STRING_HANDLE result;
+
+    /*Codes_SRS_SASTOKEN_01_005: [ If keyContext or scope is NULL then SASToken_CreateStringWithKeyContext shall return NULL. ]*/
+    if ((keyContext == NULL) ||
+        (scope == NULL))
+    {
+        LogError("Invalid Parameter to SASToken_CreateStringWithKeyContext. keyContext: %p, scope: %p, keyName: %p", keyContext, scope, keyName);
+        result = NULL;
+    }
+    else
+    {
+        /*Codes_SRS_SASTOKEN_01_006: [ Otherwise SASToken_CreateStringWithKeyContext shall build the token as SASToken_Create does, without decoding a key. ]*/
+        result = build_sas_token(NULL, keyContext, scope, keyName, expiry);
+    }
+    return result;
+}
+
+typedef struct SAS_TOKEN_BATCH_STATE_TAG
+{
+    char tokenExpirationTime[32];
+    BUFFER_HANDLE decodedKey;
+    STRING_HANDLE toBeHashed;
+} SAS_TOKEN_BATCH_STATE;
+
+/* decodes the key of item and builds its string to sign, hashItem receives both */
+static int prepare_batch_item(const SAS_TOKEN_BATCH_ITEM* item, SAS_TOKEN_BATCH_STATE* state, HMACSHA256_BATCH_ITEM* hashItem)
+{
+    int result;
+
+    if (size_tToString(state->tokenExpirationTime, sizeof(state->tokenExpirationTime), item->expiry) != 0)
+    {
+        LogError("For some reason converting seconds to a string failed.  No SAS can be generated.");
+        result = __FAILURE__;
+    }
+    else if ((state->decodedKey = Base64_Decoder(item->key)) == NULL)
+    {
+        LogError("Unable to decode the key for generating the SAS.");
+        result = __FAILURE__;
+    }
+    else if (((hashItem->hash = BUFFER_new()) == NULL) ||
+        ((state->toBeHashed = STRING_new()) == NULL))
+    {
+        LogError("Unable to allocate memory to prepare SAS token.");
+        result = __FAILURE__;
+    }
+    else if ((STRING_concat(state->toBeHashed, item->scope) != 0) ||
+        (STRING_concat(state->toBeHashed, "\n") != 0) ||
+        (STRING_concat(state->toBeHashed, state->tokenExpirationTime) != 0))
+    {
+        LogError("Unable to build the input to the HMAC to prepare SAS token.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        hashItem->key = BUFFER_u_char(state->decodedKey);
+        hashItem->keyLen = BUFFER_length(state->decodedKey);
+        hashItem->payload = (const unsigned char*)STRING_c_str(state->toBeHashed);
+        hashItem->payloadLen = STRING_length(state->toBeHashed);
+        result = 0;
+    }
+
+    return result;
+}
+
+int SASToken_CreateBatch(SAS_TOKEN_BATCH_ITEM* items, size_t itemCount)
+{
+    int result;
+    size_t i;
+
+    /*Codes_SRS_SASTOKEN_01_007: [ If items is NULL or itemCount is 0 then SASToken_CreateBatch shall fail and return a non-zero value. ]*/
+    if ((items == NULL) ||
+        (itemCount == 0))
+    {
+        LogError("Invalid Parameter to SASToken_CreateBatch. items: %p, itemCount: %lu", items, (unsigned long)itemCount);
+        result = __FAILURE__;
+    }
+    else
+    {
+        for (i = 0; i < itemCount; i++)
+        {
+            items[i].token = NULL;
+            if ((items[i].key == NULL) ||
+                (items[i].scope == NULL))
+            {
+                break;
+            }
+        }
+
+        if (i < itemCount)
+        {
+            /*Codes_SRS_SASTOKEN_01_008: [ If the key or the scope of any item is NULL then SASToken_CreateBatch shall fail and return a non-zero value. ]*/
+            LogError("Invalid Parameter to SASToken_CreateBatch. item %lu has key: %p, scope: %p", (unsigned long)i, items[i].key, items[i].scope);
+            result = __FAILURE__;
+        }
+        else
+        {
+            SAS_TOKEN_BATCH_STATE* states;
+            HMACSHA256_BATCH_ITEM* hashItems;
+
+            if ((itemCount > ((size_t)-1) / sizeof(SAS_TOKEN_BATCH_STATE)) ||
+                ((states = (SAS_TOKEN_BATCH_STATE*)malloc(itemCount * sizeof(SAS_TOKEN_BATCH_STATE))) == NULL))
+            {
+                LogError("Unable to allocate memory to prepare SAS token batch.");
+                result = __FAILURE__;
+            }
+            else if ((hashItems = (HMACSHA256_BATCH_ITEM*)malloc(itemCount * sizeof(HMACSHA256_BATCH_ITEM))) == NULL)
+            {
+                LogError("Unable to allocate memory to prepare SAS token batch.");
+                free(states);
+                result = __FAILURE__;
+            }
+            else
+            {
+                (void)memset(states, 0, itemCount * sizeof(SAS_TOKEN_BATCH_STATE));
+                (void)memset(hashItems, 0, itemCount * sizeof(HMACSHA256_BATCH_ITEM));
+
+                /*Codes_SRS_SASTOKEN_01_009: [ For each item SASToken_CreateBatch shall decode the key from base64 and build the string to sign as SASToken_Create does. ]*/
+                result = 0;
+                for (i = 0; i < itemCount; i++)
+                {
+                    if (prepare_batch_item(&items[i], &states[i], &hashItems[i]) != 0)
+                    {
+                        result = __FAILURE__;
+                        break;
+                    }
+                }
+
+                /*Codes_SRS_SASTOKEN_01_010: [ SASToken_CreateBatch shall compute the signatures of all the items with one call to HMACSHA256_ComputeHashBatch. ]*/
+                if ((result == 0) &&
+                    (HMACSHA256_ComputeHashBatch(hashItems, itemCount) != HMACSHA256_OK))
+                {
+                    LogError("Unable to compute the signatures of the SAS token batch.");
+                    result = __FAILURE__;
+                }
+
+                /*Codes_SRS_SASTOKEN_01_011: [ SASToken_CreateBatch shall then build the token of each item as SASToken_Create does and store it in the token field of the item. ]*/
+                for (i = 0; (result == 0) && (i < itemCount); i++)
+                {
+                    if ((items[i].token = create_sas_token(hashItems[i].hash, items[i].scope, states[i].tokenExpirationTime, items[i].keyName)) == NULL)
+                    {
+                        LogError("Unable to build the SAS token of item %lu.", (unsigned long)i);
+                        result = __FAILURE__;
+                    }
+                }
+
+                /*Codes_SRS_SASTOKEN_01_012: [ If any of the operations fails then SASToken_CreateBatch shall fail, destroy the tokens it created, set the token of every item to NULL and return a non-zero value. ]*/
+                for (i = 0; i < itemCount; i++)
+                {
+                    if (result != 0)
+                    {
+                        STRING_delete(items[i].token);
+                        items[i].token = NULL;
+                    }
+                    STRING_delete(states[i].toBeHashed);
+                    BUFFER_delete(states[i].decodedKey);
+                    BUFFER_delete(hashItems[i].hash);
+                }
+                free(hashItems);
+                free(states);
+            }
+        }
+    }
+
+    return result;
+}
@@ -39,6 +39,7 @@
 */
 
 #include <stdlib.h>
+#include <string.h>
 #include "azure_c_shared_utility/gballoc.h"
 
 #include "azure_c_shared_utility/sha.h"
@@ -63,6 +64,33 @@
 static void SHA1Finalize(SHA1Context *context, uint8_t Pad_Byte);
 static void SHA1PadMessage(SHA1Context *, uint8_t Pad_Byte);
 static void SHA1ProcessMessageBlock(SHA1Context *);
+static void SHA1ProcessBlocks(uint32_t Intermediate_Hash[SHA1HashSize / 4], const uint8_t *blocks, size_t block_count);
+
+/*
+* The block function in use: the SHA extensions of the CPU when it has
+* them (see sha1_hw.c), SHA1ProcessBlocks otherwise. It is resolved on
+* first use; threads racing to resolve it all store the same value.
+*/
+static SHA1_PROCESS_BLOCKS SHA1_Process_Blocks = NULL;
+
+/* Whole blocks are hashed straight from the input in chunks of this
+* many bytes, so that the length in bits of a chunk fits in 32 bits */
+#define SHA1_MAX_CHUNK_SIZE (1U << 24)
+
+static SHA1_PROCESS_BLOCKS SHA1GetProcessBlocks(void)
+{
+    SHA1_PROCESS_BLOCKS result = SHA1_Process_Blocks;
+    if (result == NULL)
+    {
+        result = SHA1GetHardwareProcessBlocks();
+        if (result == NULL)
+        {
+            result = SHA1ProcessBlocks;
+        }
+        SHA1_Process_Blocks = result;
+    }
+    return result;
+}
 
 /*
 *  SHA1Reset
@@ -140,15 +168,27 @@ int SHA1Input(SHA1Context *context,
     if (context->Corrupted)
         return context->Corrupted;
 
-    while (length-- && !context->Corrupted) {
-        context->Message_Block[context->Message_Block_Index++] =
-            (*message_array & 0xFF);
-
-        if (!SHA1AddLength(context, 8) &&
-            (context->Message_Block_Index == SHA1_Message_Block_Size))
-            SHA1ProcessMessageBlock(context);
-
-        message_array++;
+    while (length && !context->Corrupted) {
+        if ((context->Message_Block_Index == 0) && (length >= SHA1_Message_Block_Size)) {
+            /* whole blocks do not need to be copied to Message_Block */
+            unsigned int chunk_size = ((length < SHA1_MAX_CHUNK_SIZE) ? length : SHA1_MAX_CHUNK_SIZE) & ~(unsigned int)(SHA1_Message_Block_Size - 1);
+            if (!SHA1AddLength(context, chunk_size * 8))
+                SHA1GetProcessBlocks()(context->Intermediate_Hash, message_array, chunk_size / SHA1_Message_Block_Size);
+            message_array += chunk_size;
+            length -= chunk_size;
+        } else {
+            unsigned int copy_size = SHA1_Message_Block_Size - context->Message_Block_Index;
+            if (copy_size > length)
+                copy_size = length;
+            (void)memcpy(context->Message_Block + context->Message_Block_Index, message_array, copy_size);
+            context->Message_Block_Index += (int_least16_t)copy_size;
+
+            if (!SHA1AddLength(context, copy_size * 8) &&
+                (context->Message_Block_Index == SHA1_Message_Block_Size))
+                SHA1ProcessMessageBlock(context);
+            message_array += copy_size;
+            length -= copy_size;
+        }
     }
 
     return shaSuccess;
@@ -344,6 +384,43 @@ static void SHA1PadMessage(SHA1Context *context, uint8_t Pad_Byte)
     SHA1ProcessMessageBlock(context);
 }
 
+/*
+* SHA1UseHardwareAcceleration
+*
+* Description:
+*   This function selects whether the SHA-1 blocks are processed with
+*   the SHA instructions of the CPU or with the portable code. The
+*   instructions are used by default when the CPU has them.
+*
+* Parameters:
+*   use: [in]
+*     Non-zero to use the SHA instructions, 0 for the portable code.
+*
+* Returns:
+*   sha Error Code, shaBadParam if the SHA instructions are asked
+*   for and not available.
+*/
+int SHA1UseHardwareAcceleration(int use)
+{
+    int result;
+    SHA1_PROCESS_BLOCKS hardware_process_blocks = SHA1GetHardwareProcessBlocks();
+    if (!use)
+    {
+        SHA1_Process_Blocks = SHA1ProcessBlocks;
+        result = shaSuccess;
+    }
+    else if (hardware_process_blocks == NULL)
+    {
+        result = shaBadParam;
+    }
+    else
+    {
+        SHA1_Process_Blocks = hardware_process_blocks;
+        result = shaSuccess;
+    }
+    return result;
+}
+
 /*
 * SHA1ProcessMessageBlock
 *
@@ -356,13 +433,38 @@ static void SHA1PadMessage(SHA1Context *context, uint8_t Pad_Byte)
 *
 * Returns:
 *   Nothing.
+*/
+static void SHA1ProcessMessageBlock(SHA1Context *context)
+{
+    SHA1GetProcessBlocks()(context->Intermediate_Hash, context->Message_Block, 1);
+
+    context->Message_Block_Index = 0;
+}
+
+/*
+* SHA1ProcessBlocks
+*
+* Description:
+*   This function will process block_count consecutive blocks of
+*   512 bits of the message, without SHA instructions.
+*
+* Parameters:
+*   Intermediate_Hash: [in/out]
+*     The intermediate hash to update
+*   blocks: [in]
+*     The blocks to process
+*   block_count: [in]
+*     The number of blocks
+*
+* Returns:
+*   Nothing.
 *
 * Comments:
 *   Many of the variable names in this code, especially the
 *   single character names, were used because those were the
 *   names used in the publication.
 */
-static void SHA1ProcessMessageBlock(SHA1Context *context)
+static void SHA1ProcessBlocks(uint32_t Intermediate_Hash[SHA1HashSize / 4], const uint8_t *blocks, size_t block_count)
 {
     /* Constants defined in FIPS-180-2, section 4.2.1 */
     const uint32_t K[4] = {
@@ -373,68 +475,68 @@ static void SHA1ProcessMessageBlock(SHA1Context *context)
     uint32_t   W[80];           /* Word sequence */
     uint32_t   A, B, C, D, E;   /* Word buffers */
 
-    /*
-    * Initialize the first 16 words in the array W
-    */
-    for (t = 0; t < 16; t++) {
-        W[t] = ((uint32_t)context->Message_Block[t * 4]) << 24;
-        W[t] |= ((uint32_t)context->Message_Block[t * 4 + 1]) << 16;
-        W[t] |= ((uint32_t)context->Message_Block[t * 4 + 2]) << 8;
-        W[t] |= ((uint32_t)context->Message_Block[t * 4 + 3]);
-    }
-
-    for (t = 16; t < 80; t++)
-        W[t] = SHA1_ROTL(1, W[t - 3] ^ W[t - 8] ^ W[t - 14] ^ W[t - 16]);
-
-    A = context->Intermediate_Hash[0];
-    B = context->Intermediate_Hash[1];
-    C = context->Intermediate_Hash[2];
-    D = context->Intermediate_Hash[3];
-    E = context->Intermediate_Hash[4];
-
-    for (t = 0; t < 20; t++) {
-        temp = SHA1_ROTL(5, A) + SHA_Ch(B, C, D) + E + W[t] + K[0];
-        E = D;
-        D = C;
-        C = SHA1_ROTL(30, B);
-        B = A;
-        A = temp;
-    }
-
-    for (t = 20; t < 40; t++) {
-        temp = SHA1_ROTL(5, A) + SHA_Parity(B, C, D) + E + W[t] + K[1];
-        E = D;
-        D = C;
-        C = SHA1_ROTL(30, B);
-        B = A;
-        A = temp;
-    }
-
-    for (t = 40; t < 60; t++) {
-        temp = SHA1_ROTL(5, A) + SHA_Maj(B, C, D) + E + W[t] + K[2];
-        E = D;
-        D = C;
-        C = SHA1_ROTL(30, B);
-        B = A;
-        A = temp;
+    while (block_count-- > 0) {
+        /*
+        * Initialize the first 16 words in the array W
+        */
+        for (t = 0; t < 16; t++) {
+            W[t] = ((uint32_t)blocks[t * 4]) << 24;
+            W[t] |= ((uint32_t)blocks[t * 4 + 1]) << 16;
+            W[t] |= ((uint32_t)blocks[t * 4 + 2]) << 8;
+            W[t] |= ((uint32_t)blocks[t * 4 + 3]);
+        }
+
+        for (t = 16; t < 80; t++)
+            W[t] = SHA1_ROTL(1, W[t - 3] ^ W[t - 8] ^ W[t - 14] ^ W[t - 16]);
+
+        A = Intermediate_Hash[0];
+        B = Intermediate_Hash[1];
+        C = Intermediate_Hash[2];
+        D = Intermediate_Hash[3];
+        E = Intermediate_Hash[4];
+
+        for (t = 0; t < 20; t++) {
+            temp = SHA1_ROTL(5, A) + SHA_Ch(B, C, D) + E + W[t] + K[0];
+            E = D;
+            D = C;
+            C = SHA1_ROTL(30, B);
+            B = A;
+            A = temp;
+        }
+
+        for (t = 20; t < 40; t++) {
+            temp = SHA1_ROTL(5, A) + SHA_Parity(B, C, D) + E + W[t] + K[1];
+            E = D;
+            D = C;
+            C = SHA1_ROTL(30, B);
+            B = A;
+            A = temp;
+        }
+
+        for (t = 40; t < 60; t++) {
+            temp = SHA1_ROTL(5, A) + SHA_Maj(B, C, D) + E + W[t] + K[2];
+            E = D;
+            D = C;
+            C = SHA1_ROTL(30, B);
+            B = A;
+            A = temp;
+        }
+
+        for (t = 60; t < 80; t++) {
+            temp = SHA1_ROTL(5, A) + SHA_Parity(B, C, D) + E + W[t] + K[3];
+            E = D;
+            D = C;
+            C = SHA1_ROTL(30, B);
+            B = A;
+            A = temp;
+        }
+
+        Intermediate_Hash[0] += A;
+        Intermediate_Hash[1] += B;
+        Intermediate_Hash[2] += C;
+        Intermediate_Hash[3] += D;
+        Intermediate_Hash[4] += E;
+
+        blocks += SHA1_Message_Block_Size;
     }
-
-    for (t = 60; t < 80; t++) {
-        temp = SHA1_ROTL(5, A) + SHA_Parity(B, C, D) + E + W[t] + K[3];
-        E = D;
-        D = C;
-        C = SHA1_ROTL(30, B);
-        B = A;
-        A = temp;
-    }
-
-    context->Intermediate_Hash[0] += A;
-    context->Intermediate_Hash[1] += B;
-    context->Intermediate_Hash[2] += C;
-
-    context->Intermediate_Hash[3] += D;
-    context->Intermediate_Hash[4] += E;
-
-    context->Message_Block_Index = 0;
 }
-
@@ -0,0 +1,255 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+* SHA-1 block functions using the SHA instructions of the CPU:
+* SHA-NI on x86 and the ARMv8 SHA1 instructions on AArch64.
+*
+* The instructions are only used when the CPU reports them at run time,
+* sha1.c falls back to its portable block function otherwise. Define
+* NO_SHA_HARDWARE_ACCELERATION to build without them.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "azure_c_shared_utility/sha.h"
+#include "azure_c_shared_utility/sha-private.h"
+
+#if !defined(NO_SHA_HARDWARE_ACCELERATION)
+
+#if (defined(__x86_64__) || defined(__i386__)) && ((defined(__clang__) && (__clang_major__ >= 4)) || (!defined(__clang__) && defined(__GNUC__) && (__GNUC__ >= 5)))
+#define SHA1_HW_X86
+#define SHA1_HW_X86_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+#include <cpuid.h>
+#include <immintrin.h>
+#elif (defined(_M_X64) || defined(_M_IX86)) && defined(_MSC_VER) && (_MSC_VER >= 1900)
+#define SHA1_HW_X86
+#define SHA1_HW_X86_TARGET
+#include <intrin.h>
+#include <immintrin.h>
+#elif defined(__aarch64__) && (defined(__linux__) || defined(__APPLE__)) && ((defined(__clang__) && (__clang_major__ >= 8)) || (!defined(__clang__) && defined(__GNUC__) && (__GNUC__ >= 6)))
+#define SHA1_HW_ARM
+#if defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2)
+#define SHA1_HW_ARM_TARGET
+#elif defined(__clang__)
+#define SHA1_HW_ARM_TARGET __attribute__((target("crypto")))
+#else
+#define SHA1_HW_ARM_TARGET __attribute__((target("+crypto")))
+#endif
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#ifndef HWCAP_SHA1
+#define HWCAP_SHA1 (1 << 5)
+#endif
+#endif
+#endif
+
+#endif /* NO_SHA_HARDWARE_ACCELERATION */
+
+#if defined(SHA1_HW_X86)
+
+static int SHA1_HW_X86_Available(void)
+{
+    /* SSSE3 and SSE4.1 are CPUID.1:ECX bits 9 and 19, SHA is CPUID.(EAX=7,ECX=0):EBX bit 29 */
+    int result;
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        result = 0;
+    }
+    else
+    {
+        __cpuid(info, 1);
+        result = ((info[2] & (1 << 9)) != 0) && ((info[2] & (1 << 19)) != 0);
+        __cpuidex(info, 7, 0);
+        result = result && ((info[1] & (1 << 29)) != 0);
+    }
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0, NULL) < 7)
+    {
+        result = 0;
+    }
+    else
+    {
+        __cpuid(1, eax, ebx, ecx, edx);
+        result = ((ecx & (1U << 9)) != 0) && ((ecx & (1U << 19)) != 0);
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        result = result && ((ebx & (1U << 29)) != 0);
+    }
+#endif
+    return result;
+}
+
+SHA1_HW_X86_TARGET
+static void SHA1_HW_X86_ProcessBlocks(uint32_t Intermediate_Hash[5], const uint8_t *blocks, size_t block_count)
+{
+    /* turns a big endian block into native 32 bit lanes, word 0 in the highest lane */
+    const __m128i byte_swap = _mm_set_epi64x(0x0001020304050607LL, 0x08090a0b0c0d0e0fLL);
+    __m128i abcd;
+    __m128i e0;
+
+    /* the instructions keep A in the highest lane and E alone in the highest lane of another register */
+    abcd = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&Intermediate_Hash[0]), 0x1B);
+    e0 = _mm_set_epi32((int)Intermediate_Hash[4], 0, 0, 0);
+
+    while (block_count-- > 0)
+    {
+        __m128i W[4];
+        __m128i E[2];
+        __m128i saved_abcd = abcd;
+        __m128i saved_e0 = e0;
+        int g;
+
+        /* 4 rounds at a time; E alternates between the E of the next 4 rounds and the saved ABCD
+           that sha1nexte turns into it, W holds the last 16 words of the message schedule */
+        E[0] = e0;
+        for (g = 0; g < 20; g++)
+        {
+            int current = g & 1;
+
+            if (g < 4)
+            {
+                W[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(blocks + (g * 16))), byte_swap);
+            }
+
+            if (g == 0)
+            {
+                E[0] = _mm_add_epi32(E[0], W[0]);
+            }
+            else
+            {
+                E[current] = _mm_sha1nexte_epu32(E[current], W[g & 3]);
+            }
+            E[current ^ 1] = abcd;
+
+            if ((g >= 3) && (g <= 18))
+            {
+                W[(g + 1) & 3] = _mm_sha1msg2_epu32(W[(g + 1) & 3], W[g & 3]);
+            }
+
+            /* the round function is an immediate operand */
+            switch (g / 5)
+            {
+            case 0:
+                abcd = _mm_sha1rnds4_epu32(abcd, E[current], 0);
+                break;
+            case 1:
+                abcd = _mm_sha1rnds4_epu32(abcd, E[current], 1);
+                break;
+            case 2:
+                abcd = _mm_sha1rnds4_epu32(abcd, E[current], 2);
+                break;
+            default:
+                abcd = _mm_sha1rnds4_epu32(abcd, E[current], 3);
+                break;
+            }
+
+            if ((g >= 1) && (g <= 16))
+            {
+                W[(g - 1) & 3] = _mm_sha1msg1_epu32(W[(g - 1) & 3], W[g & 3]);
+            }
+            if ((g >= 2) && (g <= 17))
+            {
+                W[(g - 2) & 3] = _mm_xor_si128(W[(g - 2) & 3], W[g & 3]);
+            }
+        }
+
+        /* after the last 4 rounds E[0] holds the ABCD they started from */
+        e0 = _mm_sha1nexte_epu32(E[0], saved_e0);
+        abcd = _mm_add_epi32(abcd, saved_abcd);
+        blocks += SHA1_Message_Block_Size;
+    }
+
+    _mm_storeu_si128((__m128i*)&Intermediate_Hash[0], _mm_shuffle_epi32(abcd, 0x1B));
+    Intermediate_Hash[4] = (uint32_t)_mm_extract_epi32(e0, 3);
+}
+
+#elif defined(SHA1_HW_ARM)
+
+static int SHA1_HW_ARM_Available(void)
+{
+#if defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_SHA1) != 0;
+#else
+    /* every 64 bit Apple CPU has the SHA1 instructions */
+    return 1;
+#endif
+}
+
+SHA1_HW_ARM_TARGET
+static void SHA1_HW_ARM_ProcessBlocks(uint32_t Intermediate_Hash[5], const uint8_t *blocks, size_t block_count)
+{
+    /* Constants defined in FIPS-180-2, section 4.2.1 */
+    static const uint32_t K[4] = {
+        0x5A827999, 0x6ED9EBA1, 0x8F1BBCDC, 0xCA62C1D6
+    };
+    uint32x4_t abcd = vld1q_u32(&Intermediate_Hash[0]);
+    uint32_t e0 = Intermediate_Hash[4];
+
+    while (block_count-- > 0)
+    {
+        uint32x4_t W[4];
+        uint32x4_t saved_abcd = abcd;
+        uint32_t e = e0;
+        int g;
+
+        /* 4 rounds at a time, W holds the last 16 words of the message schedule */
+        for (g = 0; g < 20; g++)
+        {
+            uint32x4_t words;
+            uint32_t next_e;
+            if (g < 4)
+            {
+                words = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + (g * 16))));
+            }
+            else
+            {
+                words = vsha1su1q_u32(vsha1su0q_u32(W[g & 3], W[(g + 1) & 3], W[(g + 2) & 3]), W[(g + 3) & 3]);
+            }
+            W[g & 3] = words;
+
+            words = vaddq_u32(words, vdupq_n_u32(K[g / 5]));
+            next_e = vsha1h_u32(vgetq_lane_u32(abcd, 0));
+            if (g < 5)
+            {
+                abcd = vsha1cq_u32(abcd, e, words);
+            }
+            else if ((g >= 10) && (g < 15))
+            {
+                abcd = vsha1mq_u32(abcd, e, words);
+            }
+            else
+            {
+                abcd = vsha1pq_u32(abcd, e, words);
+            }
+            e = next_e;
+        }
+
+        abcd = vaddq_u32(abcd, saved_abcd);
+        e0 += e;
+        blocks += SHA1_Message_Block_Size;
+    }
+
+    vst1q_u32(&Intermediate_Hash[0], abcd);
+    Intermediate_Hash[4] = e0;
+}
+
+#endif
+
+SHA1_PROCESS_BLOCKS SHA1GetHardwareProcessBlocks(void)
+{
+    SHA1_PROCESS_BLOCKS result;
+#if defined(SHA1_HW_X86)
+    result = SHA1_HW_X86_Available() ? SHA1_HW_X86_ProcessBlocks : NULL;
+#elif defined(SHA1_HW_ARM)
+    result = SHA1_HW_ARM_Available() ? SHA1_HW_ARM_ProcessBlocks : NULL;
+#else
+    result = NULL;
+#endif
+    return result;
+}
@@ -41,6 +41,7 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
 
 #include "azure_c_shared_utility/sha.h"
 #include "azure_c_shared_utility/sha-private.h"
@@ -73,6 +74,7 @@
 static void SHA224_256Finalize(SHA256Context *context, uint8_t Pad_Byte);
 static void SHA224_256PadMessage(SHA256Context *context, uint8_t Pad_Byte);
 static void SHA224_256ProcessMessageBlock(SHA256Context *context);
+static void SHA224_256ProcessBlocks(uint32_t Intermediate_Hash[SHA256HashSize / 4], const uint8_t *blocks, size_t block_count);
 static int SHA224_256Reset(SHA256Context *context, uint32_t *H0);
 static int SHA224_256ResultN(SHA256Context *context, uint8_t Message_Digest[], int HashSize);
 
@@ -88,6 +90,63 @@ static uint32_t SHA256_H0[SHA256HashSize / 4] = {
     0x510E527F, 0x9B05688C, 0x1F83D9AB, 0x5BE0CD19
 };
 
+/*
+* The block function in use: the SHA extensions of the CPU when it has
+* them (see sha256_hw.c), SHA224_256ProcessBlocks otherwise. It is
+* resolved on first use; threads racing to resolve it all store the
+* same value.
+*/
+static SHA224_256_PROCESS_BLOCKS SHA224_256_Process_Blocks = NULL;
+
+/*
+* The lane function in use, resolved on first use like the block
+* function. It is only used by CPUs without the SHA instructions, one
+* message at a time with them is faster than 8 lanes of vector code.
+* SHA256UseHardwareAcceleration(0) turns it off as well.
+*/
+static SHA224_256_PROCESS_LANES SHA224_256_Process_Lanes = NULL;
+static int SHA224_256_Process_Lanes_Resolved = 0;
+static int SHA224_256_Lanes_Disabled = 0;
+
+static SHA224_256_PROCESS_LANES SHA224_256GetProcessLanes(void)
+{
+    SHA224_256_PROCESS_LANES result;
+    if (SHA224_256_Lanes_Disabled)
+    {
+        result = NULL;
+    }
+    else if (SHA224_256_Process_Lanes_Resolved)
+    {
+        result = SHA224_256_Process_Lanes;
+    }
+    else
+    {
+        result = (SHA224_256GetHardwareProcessBlocks() == NULL) ? SHA224_256GetHardwareProcessLanes() : NULL;
+        SHA224_256_Process_Lanes = result;
+        SHA224_256_Process_Lanes_Resolved = 1;
+    }
+    return result;
+}
+
+/* Whole blocks are hashed straight from the input in chunks of this
+* many bytes, so that the length in bits of a chunk fits in 32 bits */
+#define SHA224_256_MAX_CHUNK_SIZE (1U << 24)
+
+static SHA224_256_PROCESS_BLOCKS SHA224_256GetProcessBlocks(void)
+{
+    SHA224_256_PROCESS_BLOCKS result = SHA224_256_Process_Blocks;
+    if (result == NULL)
+    {
+        result = SHA224_256GetHardwareProcessBlocks();
+        if (result == NULL)
+        {
+            result = SHA224_256ProcessBlocks;
+        }
+        SHA224_256_Process_Blocks = result;
+    }
+    return result;
+}
+
 /*
 * SHA224Reset
 *
@@ -239,15 +298,36 @@ int SHA256Input(SHA256Context *context, const uint8_t *message_array, unsigned i
     }
     else
     {
-        while (length-- && !context->Corrupted)
+        while (length && !context->Corrupted)
         {
-            context->Message_Block[context->Message_Block_Index++] = (*message_array & 0xFF);
-
-            if (!SHA224_256AddLength(context, 8) && (context->Message_Block_Index == SHA256_Message_Block_Size))
+            if ((context->Message_Block_Index == 0) && (length >= SHA256_Message_Block_Size))
+            {
+                /* whole blocks do not need to be copied to Message_Block */
+                unsigned int chunk_size = ((length < SHA224_256_MAX_CHUNK_SIZE) ? length : SHA224_256_MAX_CHUNK_SIZE) & ~(unsigned int)(SHA256_Message_Block_Size - 1);
+                if (!SHA224_256AddLength(context, chunk_size * 8))
+                {
+                    SHA224_256GetProcessBlocks()(context->Intermediate_Hash, message_array, chunk_size / SHA256_Message_Block_Size);
+                }
+                message_array += chunk_size;
+                length -= chunk_size;
+            }
+            else
             {
-                SHA224_256ProcessMessageBlock(context);
+                unsigned int copy_size = SHA256_Message_Block_Size - context->Message_Block_Index;
+                if (copy_size > length)
+                {
+                    copy_size = length;
+                }
+                (void)memcpy(context->Message_Block + context->Message_Block_Index, message_array, copy_size);
+                context->Message_Block_Index += (int_least16_t)copy_size;
+
+                if (!SHA224_256AddLength(context, copy_size * 8) && (context->Message_Block_Index == SHA256_Message_Block_Size))
+                {
+                    SHA224_256ProcessMessageBlock(context);
+                }
+                message_array += copy_size;
+                length -= copy_size;
             }
-            message_array++;
         }
         result = shaSuccess;
     }
@@ -339,6 +419,221 @@ int SHA256Result(SHA256Context *context, uint8_t Message_Digest[SHA256HashSize])
     return SHA224_256ResultN(context, Message_Digest, SHA256HashSize);
 }
 
+/*
+* SHA256UseHardwareAcceleration
+*
+* Description:
+*   This function selects whether the SHA-224 and SHA-256 blocks are
+*   processed with the SHA instructions of the CPU or with the
+*   portable code. The instructions are used by default when the CPU
+*   has them. It also selects whether SHA256ComputePrefixedDigests
+*   may hash several messages at once with the vector instructions.
+*
+* Parameters:
+*   use: [in]
+*     Non-zero to use the SHA instructions, 0 for the portable code.
+*
+* Returns:
+*   sha Error Code, shaBadParam if the SHA instructions are asked
+*   for and not available.
+*/
+int SHA256UseHardwareAcceleration(int use)
+{
+    int result;
+    SHA224_256_PROCESS_BLOCKS hardware_process_blocks = SHA224_256GetHardwareProcessBlocks();
+    if (!use)
+    {
+        SHA224_256_Process_Blocks = SHA224_256ProcessBlocks;
+        SHA224_256_Lanes_Disabled = 1;
+        result = shaSuccess;
+    }
+    else if (hardware_process_blocks == NULL)
+    {
+        /* the lanes do not need the SHA instructions and are used again whenever the CPU allows it */
+        SHA224_256_Lanes_Disabled = 0;
+        result = shaBadParam;
+    }
+    else
+    {
+        SHA224_256_Process_Blocks = hardware_process_blocks;
+        SHA224_256_Lanes_Disabled = 0;
+        result = shaSuccess;
+    }
+    return result;
+}
+
+/*
+* SHA224_256HashLanes
+*
+* Description:
+*   This helper function computes the digests of up to
+*   SHA224_256_LANE_COUNT prefixed messages with the lane function,
+*   all the lanes advancing one block per call. Lanes whose message
+*   has fewer blocks than the longest one process their last block
+*   and are then given a scratch hash to update.
+*
+* Parameters:
+*   See SHA256ComputePrefixedDigests, with count at most
+*   SHA224_256_LANE_COUNT.
+*
+* Returns:
+*   Nothing.
+*/
+static void SHA224_256HashLanes(SHA224_256_PROCESS_LANES process_lanes, size_t count, const uint8_t* const prefixes[], const uint8_t* const messages[], const size_t lengths[], uint8_t (*Message_Digests)[SHA256HashSize])
+{
+    uint32_t hashes[SHA224_256_LANE_COUNT][SHA256HashSize / 4];
+    uint32_t scratch_hash[SHA256HashSize / 4];
+    /* the last bytes of a message, the padding and the length take one or two blocks */
+    uint8_t tails[SHA224_256_LANE_COUNT][2 * SHA256_Message_Block_Size];
+    size_t whole_block_counts[SHA224_256_LANE_COUNT];
+    size_t block_counts[SHA224_256_LANE_COUNT];
+    size_t max_block_count = 0;
+    size_t lane;
+    size_t block;
+    int i;
+
+    (void)memset(scratch_hash, 0, sizeof(scratch_hash));
+    for (lane = 0; lane < count; lane++)
+    {
+        size_t rest = lengths[lane] % SHA256_Message_Block_Size;
+        size_t tail_size = (rest + 9 <= SHA256_Message_Block_Size) ? SHA256_Message_Block_Size : 2 * SHA256_Message_Block_Size;
+        uint64_t bit_length = ((uint64_t)lengths[lane] + SHA256_Message_Block_Size) * 8;
+
+        (void)memcpy(hashes[lane], SHA256_H0, sizeof(hashes[lane]));
+        whole_block_counts[lane] = lengths[lane] / SHA256_Message_Block_Size;
+        (void)memcpy(tails[lane], messages[lane] + (whole_block_counts[lane] * SHA256_Message_Block_Size), rest);
+        tails[lane][rest] = 0x80;
+        (void)memset(tails[lane] + rest + 1, 0, tail_size - rest - 1 - 8);
+        for (i = 0; i < 8; i++)
+        {
+            tails[lane][tail_size - 1 - i] = (uint8_t)(bit_length >> (8 * i));
+        }
+
+        block_counts[lane] = 1 + whole_block_counts[lane] + (tail_size / SHA256_Message_Block_Size);
+        if (block_counts[lane] > max_block_count)
+        {
+            max_block_count = block_counts[lane];
+        }
+    }
+
+    for (block = 0; block < max_block_count; block++)
+    {
+        uint32_t* lane_hashes[SHA224_256_LANE_COUNT];
+        const uint8_t* lane_blocks[SHA224_256_LANE_COUNT];
+
+        for (lane = 0; lane < SHA224_256_LANE_COUNT; lane++)
+        {
+            if ((lane >= count) || (block >= block_counts[lane]))
+            {
+                lane_hashes[lane] = scratch_hash;
+                lane_blocks[lane] = tails[0];
+            }
+            else
+            {
+                lane_hashes[lane] = hashes[lane];
+                if (block == 0)
+                {
+                    lane_blocks[lane] = prefixes[lane];
+                }
+                else if (block - 1 < whole_block_counts[lane])
+                {
+                    /* whole blocks are read in place */
+                    lane_blocks[lane] = messages[lane] + ((block - 1) * SHA256_Message_Block_Size);
+                }
+                else
+                {
+                    lane_blocks[lane] = tails[lane] + ((block - 1 - whole_block_counts[lane]) * SHA256_Message_Block_Size);
+                }
+            }
+        }
+
+        process_lanes(lane_hashes, lane_blocks);
+    }
+
+    for (lane = 0; lane < count; lane++)
+    {
+        for (i = 0; i < SHA256HashSize; ++i)
+        {
+            Message_Digests[lane][i] = (uint8_t)(hashes[lane][i >> 2] >> 8 * (3 - (i & 0x03)));
+        }
+    }
+}
+
+/*
+* SHA256ComputePrefixedDigests
+*
+* Description:
+*   This function computes the SHA-256 digests of count messages,
+*   message i being the 64 bytes of prefixes[i] followed by the
+*   lengths[i] bytes of messages[i]. HMAC-SHA256 uses it to hash
+*   the padded keys followed by the payloads of a batch.
+*
+* Parameters:
+*   count: [in]
+*     The number of messages
+*   prefixes: [in]
+*     The 64 byte blocks that start the messages
+*   messages: [in]
+*     The rest of the messages
+*   lengths: [in]
+*     The lengths of the rest of the messages
+*   Message_Digests: [out]
+*     Where the digests are returned.
+*
+* Returns:
+*   sha Error Code.
+*/
+int SHA256ComputePrefixedDigests(size_t count, const uint8_t* const prefixes[], const uint8_t* const messages[], const size_t lengths[], uint8_t (*Message_Digests)[SHA256HashSize])
+{
+    int result;
+
+    if ((count > 0) &&
+        (!prefixes || !messages || !lengths || !Message_Digests))
+    {
+        result = shaNull;
+    }
+    else
+    {
+        SHA224_256_PROCESS_LANES process_lanes = SHA224_256GetProcessLanes();
+        size_t first;
+
+        result = shaSuccess;
+        for (first = 0; (first < count) && (result == shaSuccess); first += SHA224_256_LANE_COUNT)
+        {
+            size_t lane_count = ((count - first) < SHA224_256_LANE_COUNT) ? (count - first) : SHA224_256_LANE_COUNT;
+
+            if ((process_lanes != NULL) && (lane_count > 1))
+            {
+                SHA224_256HashLanes(process_lanes, lane_count, prefixes + first, messages + first, lengths + first, Message_Digests + first);
+            }
+            else
+            {
+                size_t i;
+                for (i = first; (i < first + lane_count) && (result == shaSuccess); i++)
+                {
+                    SHA256Context context;
+                    const uint8_t* message = messages[i];
+                    size_t length = lengths[i];
+
+                    result = SHA256Reset(&context) ||
+                        SHA256Input(&context, prefixes[i], SHA256_Message_Block_Size);
+                    /* SHA256Input counts bytes in an unsigned int */
+                    while ((result == shaSuccess) && (length > 0))
+                    {
+                        unsigned int chunk_size = (length > SHA224_256_MAX_CHUNK_SIZE) ? SHA224_256_MAX_CHUNK_SIZE : (unsigned int)length;
+                        result = SHA256Input(&context, message, chunk_size);
+                        message += chunk_size;
+                        length -= chunk_size;
+                    }
+                    result = result || SHA256Result(&context, Message_Digests[i]);
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
 /*
 * SHA224_256Finalize
 *
@@ -450,13 +745,38 @@ static void SHA224_256PadMessage(SHA256Context *context, uint8_t Pad_Byte)
 *
 * Returns:
 *   Nothing.
+*/
+static void SHA224_256ProcessMessageBlock(SHA256Context *context)
+{
+    SHA224_256GetProcessBlocks()(context->Intermediate_Hash, context->Message_Block, 1);
+
+    context->Message_Block_Index = 0;
+}
+
+/*
+* SHA224_256ProcessBlocks
+*
+* Description:
+*   This function will process block_count consecutive blocks of
+*   512 bits of the message, without SHA instructions.
+*
+* Parameters:
+*   Intermediate_Hash: [in/out]
+*     The intermediate hash to update
+*   blocks: [in]
+*     The blocks to process
+*   block_count: [in]
+*     The number of blocks
+*
+* Returns:
+*   Nothing.
 *
 * Comments:
 *   Many of the variable names in this code, especially the
 *   single character names, were used because those were the
 *   names used in the publication.
 */
-static void SHA224_256ProcessMessageBlock(SHA256Context *context)
+static void SHA224_256ProcessBlocks(uint32_t Intermediate_Hash[SHA256HashSize / 4], const uint8_t *blocks, size_t block_count)
 {
     /* Constants defined in FIPS-180-2, section 4.2.2 */
     static const uint32_t K[64] = {
@@ -479,54 +799,57 @@ static void SHA224_256ProcessMessageBlock(SHA256Context *context)
     uint32_t   W[64];                   /* Word sequence */
     uint32_t   A, B, C, D, E, F, G, H;  /* Word buffers */
 
-    /*
-    * Initialize the first 16 words in the array W
-    */
-    for (t = t4 = 0; t < 16; t++, t4 += 4)
-    {
-        W[t] = (((uint32_t)context->Message_Block[t4]) << 24) |
-            (((uint32_t)context->Message_Block[t4 + 1]) << 16) |
-            (((uint32_t)context->Message_Block[t4 + 2]) << 8) |
-            (((uint32_t)context->Message_Block[t4 + 3]));
-    }
-    for (t = 16; t < 64; t++)
-    {
-        W[t] = SHA256_sigma1(W[t - 2]) + W[t - 7] +
-            SHA256_sigma0(W[t - 15]) + W[t - 16];
-    }
-    A = context->Intermediate_Hash[0];
-    B = context->Intermediate_Hash[1];
-    C = context->Intermediate_Hash[2];
-    D = context->Intermediate_Hash[3];
-    E = context->Intermediate_Hash[4];
-    F = context->Intermediate_Hash[5];
-    G = context->Intermediate_Hash[6];
-    H = context->Intermediate_Hash[7];
-
-    for (t = 0; t < 64; t++)
-    {
-        temp1 = H + SHA256_SIGMA1(E) + SHA_Ch(E, F, G) + K[t] + W[t];
-        temp2 = SHA256_SIGMA0(A) + SHA_Maj(A, B, C);
-        H = G;
-        G = F;
-        F = E;
-        E = D + temp1;
-        D = C;
-        C = B;
-        B = A;
-        A = temp1 + temp2;
-    }
-
-    context->Intermediate_Hash[0] += A;
-    context->Intermediate_Hash[1] += B;
-    context->Intermediate_Hash[2] += C;
-    context->Intermediate_Hash[3] += D;
-    context->Intermediate_Hash[4] += E;
-    context->Intermediate_Hash[5] += F;
-    context->Intermediate_Hash[6] += G;
-    context->Intermediate_Hash[7] += H;
+    while (block_count-- > 0)
+    {
+        /*
+        * Initialize the first 16 words in the array W
+        */
+        for (t = t4 = 0; t < 16; t++, t4 += 4)
+        {
+            W[t] = (((uint32_t)blocks[t4]) << 24) |
+                (((uint32_t)blocks[t4 + 1]) << 16) |
+                (((uint32_t)blocks[t4 + 2]) << 8) |
+                (((uint32_t)blocks[t4 + 3]));
+        }
+        for (t = 16; t < 64; t++)
+        {
+            W[t] = SHA256_sigma1(W[t - 2]) + W[t - 7] +
+                SHA256_sigma0(W[t - 15]) + W[t - 16];
+        }
+        A = Intermediate_Hash[0];
+        B = Intermediate_Hash[1];
+        C = Intermediate_Hash[2];
+        D = Intermediate_Hash[3];
+        E = Intermediate_Hash[4];
+        F = Intermediate_Hash[5];
+        G = Intermediate_Hash[6];
+        H = Intermediate_Hash[7];
+
+        for (t = 0; t < 64; t++)
+        {
+            temp1 = H + SHA256_SIGMA1(E) + SHA_Ch(E, F, G) + K[t] + W[t];
+            temp2 = SHA256_SIGMA0(A) + SHA_Maj(A, B, C);
+            H = G;
+            G = F;
+            F = E;
+            E = D + temp1;
+            D = C;
+            C = B;
+            B = A;
+            A = temp1 + temp2;
+        }
 
-    context->Message_Block_Index = 0;
+        Intermediate_Hash[0] += A;
+        Intermediate_Hash[1] += B;
+        Intermediate_Hash[2] += C;
+        Intermediate_Hash[3] += D;
+        Intermediate_Hash[4] += E;
+        Intermediate_Hash[5] += F;
+        Intermediate_Hash[6] += G;
+        Intermediate_Hash[7] += H;
+
+        blocks += SHA256_Message_Block_Size;
+    }
 }
 
 /*
@@ -0,0 +1,417 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+* SHA-224/SHA-256 block functions using the SHA instructions of the CPU:
+* SHA-NI on x86 and the ARMv8 SHA2 instructions on AArch64, and a lane
+* function using AVX2 on x86 that advances 8 independent hashes at once.
+*
+* The instructions are only used when the CPU reports them at run time,
+* sha224.c falls back to its portable block function otherwise. Define
+* NO_SHA_HARDWARE_ACCELERATION to build without them.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "azure_c_shared_utility/sha.h"
+#include "azure_c_shared_utility/sha-private.h"
+
+#if !defined(NO_SHA_HARDWARE_ACCELERATION)
+
+#if (defined(__x86_64__) || defined(__i386__)) && ((defined(__clang__) && (__clang_major__ >= 4)) || (!defined(__clang__) && defined(__GNUC__) && (__GNUC__ >= 5)))
+#define SHA256_HW_X86
+#define SHA256_HW_X86_TARGET __attribute__((target("sha,sse4.1,ssse3")))
+#define SHA256_HW_AVX2_TARGET __attribute__((target("avx2")))
+#include <cpuid.h>
+#include <immintrin.h>
+#elif (defined(_M_X64) || defined(_M_IX86)) && defined(_MSC_VER) && (_MSC_VER >= 1900)
+#define SHA256_HW_X86
+#define SHA256_HW_X86_TARGET
+#define SHA256_HW_AVX2_TARGET
+#include <intrin.h>
+#include <immintrin.h>
+#elif defined(__aarch64__) && (defined(__linux__) || defined(__APPLE__)) && ((defined(__clang__) && (__clang_major__ >= 8)) || (!defined(__clang__) && defined(__GNUC__) && (__GNUC__ >= 6)))
+#define SHA256_HW_ARM
+#if defined(__ARM_FEATURE_CRYPTO) || defined(__ARM_FEATURE_SHA2)
+#define SHA256_HW_ARM_TARGET
+#elif defined(__clang__)
+#define SHA256_HW_ARM_TARGET __attribute__((target("crypto")))
+#else
+#define SHA256_HW_ARM_TARGET __attribute__((target("+crypto")))
+#endif
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#ifndef HWCAP_SHA2
+#define HWCAP_SHA2 (1 << 6)
+#endif
+#endif
+#endif
+
+#endif /* NO_SHA_HARDWARE_ACCELERATION */
+
+#if defined(SHA256_HW_X86) || defined(SHA256_HW_ARM)
+/* Constants defined in FIPS-180-2, section 4.2.2 */
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b,
+    0x59f111f1, 0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01,
+    0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7,
+    0xc19bf174, 0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc,
+    0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da, 0x983e5152,
+    0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc,
+    0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819,
+    0xd6990624, 0xf40e3585, 0x106aa070, 0x19a4c116, 0x1e376c08,
+    0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f,
+    0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+#endif
+
+#if defined(SHA256_HW_X86)
+
+static int SHA256_HW_X86_Available(void)
+{
+    /* SSSE3 and SSE4.1 are CPUID.1:ECX bits 9 and 19, SHA is CPUID.(EAX=7,ECX=0):EBX bit 29 */
+    int result;
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        result = 0;
+    }
+    else
+    {
+        __cpuid(info, 1);
+        result = ((info[2] & (1 << 9)) != 0) && ((info[2] & (1 << 19)) != 0);
+        __cpuidex(info, 7, 0);
+        result = result && ((info[1] & (1 << 29)) != 0);
+    }
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0, NULL) < 7)
+    {
+        result = 0;
+    }
+    else
+    {
+        __cpuid(1, eax, ebx, ecx, edx);
+        result = ((ecx & (1U << 9)) != 0) && ((ecx & (1U << 19)) != 0);
+        __cpuid_count(7, 0, eax, ebx, ecx, edx);
+        result = result && ((ebx & (1U << 29)) != 0);
+    }
+#endif
+    return result;
+}
+
+SHA256_HW_X86_TARGET
+static void SHA256_HW_X86_ProcessBlocks(uint32_t Intermediate_Hash[8], const uint8_t *blocks, size_t block_count)
+{
+    /* turns the big endian words of a block into native 32 bit lanes */
+    const __m128i byte_swap = _mm_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+    __m128i state0;
+    __m128i state1;
+    __m128i temp;
+
+    /* the instructions keep the state as ABEF and CDGH */
+    temp = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&Intermediate_Hash[0]), 0xB1);
+    state1 = _mm_shuffle_epi32(_mm_loadu_si128((const __m128i*)&Intermediate_Hash[4]), 0x1B);
+    state0 = _mm_alignr_epi8(temp, state1, 8);
+    state1 = _mm_blend_epi16(state1, temp, 0xF0);
+
+    while (block_count-- > 0)
+    {
+        __m128i W[4];
+        __m128i abef = state0;
+        __m128i cdgh = state1;
+        int t;
+
+        /* 4 rounds at a time, W holds the last 16 words of the message schedule */
+        for (t = 0; t < 16; t++)
+        {
+            __m128i words;
+            if (t < 4)
+            {
+                words = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(blocks + (t * 16))), byte_swap);
+            }
+            else
+            {
+                words = _mm_sha256msg1_epu32(W[t & 3], W[(t + 1) & 3]);
+                words = _mm_add_epi32(words, _mm_alignr_epi8(W[(t + 3) & 3], W[(t + 2) & 3], 4));
+                words = _mm_sha256msg2_epu32(words, W[(t + 3) & 3]);
+            }
+            W[t & 3] = words;
+
+            temp = _mm_add_epi32(words, _mm_loadu_si128((const __m128i*)&K[t * 4]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, temp);
+            temp = _mm_shuffle_epi32(temp, 0x0E);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, temp);
+        }
+
+        state0 = _mm_add_epi32(state0, abef);
+        state1 = _mm_add_epi32(state1, cdgh);
+        blocks += SHA256_Message_Block_Size;
+    }
+
+    temp = _mm_shuffle_epi32(state0, 0x1B);
+    state1 = _mm_shuffle_epi32(state1, 0xB1);
+    state0 = _mm_blend_epi16(temp, state1, 0xF0);
+    state1 = _mm_alignr_epi8(state1, temp, 8);
+    _mm_storeu_si128((__m128i*)&Intermediate_Hash[0], state0);
+    _mm_storeu_si128((__m128i*)&Intermediate_Hash[4], state1);
+}
+
+static int SHA256_HW_AVX2_Available(void)
+{
+    /* AVX2 is CPUID.(EAX=7,ECX=0):EBX bit 5, and the OS must save the YMM registers:
+       OSXSAVE is CPUID.1:ECX bit 27 and XCR0 bits 1 and 2 are the SSE and AVX states */
+    int result;
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7)
+    {
+        result = 0;
+    }
+    else
+    {
+        __cpuid(info, 1);
+        result = ((info[2] & (1 << 27)) != 0) && ((_xgetbv(0) & 6) == 6);
+        __cpuidex(info, 7, 0);
+        result = result && ((info[1] & (1 << 5)) != 0);
+    }
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid_max(0, NULL) < 7)
+    {
+        result = 0;
+    }
+    else
+    {
+        __cpuid(1, eax, ebx, ecx, edx);
+        if ((ecx & (1U << 27)) == 0)
+        {
+            result = 0;
+        }
+        else
+        {
+            unsigned int xcr0_low;
+            unsigned int xcr0_high;
+            __asm__ __volatile__("xgetbv" : "=a"(xcr0_low), "=d"(xcr0_high) : "c"(0));
+            (void)xcr0_high;
+            result = (xcr0_low & 6) == 6;
+            __cpuid_count(7, 0, eax, ebx, ecx, edx);
+            result = result && ((ebx & (1U << 5)) != 0);
+        }
+    }
+#endif
+    return result;
+}
+
+#define SHA256_AVX2_ROTR(x, bits) _mm256_or_si256(_mm256_srli_epi32((x), (bits)), _mm256_slli_epi32((x), 32 - (bits)))
+
+/* transposes the 8 rows of 8 words of rows, so that words[j] holds word j of every row */
+SHA256_HW_AVX2_TARGET
+static void SHA256_HW_AVX2_Transpose(__m256i words[8], const __m256i rows[8])
+{
+    __m256i t0 = _mm256_unpacklo_epi32(rows[0], rows[1]);
+    __m256i t1 = _mm256_unpackhi_epi32(rows[0], rows[1]);
+    __m256i t2 = _mm256_unpacklo_epi32(rows[2], rows[3]);
+    __m256i t3 = _mm256_unpackhi_epi32(rows[2], rows[3]);
+    __m256i t4 = _mm256_unpacklo_epi32(rows[4], rows[5]);
+    __m256i t5 = _mm256_unpackhi_epi32(rows[4], rows[5]);
+    __m256i t6 = _mm256_unpacklo_epi32(rows[6], rows[7]);
+    __m256i t7 = _mm256_unpackhi_epi32(rows[6], rows[7]);
+    __m256i u0 = _mm256_unpacklo_epi64(t0, t2);
+    __m256i u1 = _mm256_unpackhi_epi64(t0, t2);
+    __m256i u2 = _mm256_unpacklo_epi64(t1, t3);
+    __m256i u3 = _mm256_unpackhi_epi64(t1, t3);
+    __m256i u4 = _mm256_unpacklo_epi64(t4, t6);
+    __m256i u5 = _mm256_unpackhi_epi64(t4, t6);
+    __m256i u6 = _mm256_unpacklo_epi64(t5, t7);
+    __m256i u7 = _mm256_unpackhi_epi64(t5, t7);
+    words[0] = _mm256_permute2x128_si256(u0, u4, 0x20);
+    words[1] = _mm256_permute2x128_si256(u1, u5, 0x20);
+    words[2] = _mm256_permute2x128_si256(u2, u6, 0x20);
+    words[3] = _mm256_permute2x128_si256(u3, u7, 0x20);
+    words[4] = _mm256_permute2x128_si256(u0, u4, 0x31);
+    words[5] = _mm256_permute2x128_si256(u1, u5, 0x31);
+    words[6] = _mm256_permute2x128_si256(u2, u6, 0x31);
+    words[7] = _mm256_permute2x128_si256(u3, u7, 0x31);
+}
+
+SHA256_HW_AVX2_TARGET
+static void SHA256_HW_AVX2_ProcessLanes(uint32_t* const Intermediate_Hashes[SHA224_256_LANE_COUNT], const uint8_t* const blocks[SHA224_256_LANE_COUNT])
+{
+    /* turns the big endian words of a block into native 32 bit lanes */
+    const __m256i byte_swap = _mm256_set_epi64x(0x0c0d0e0f08090a0bLL, 0x0405060700010203LL, 0x0c0d0e0f08090a0bLL, 0x0405060700010203LL);
+    __m256i rows[8];
+    __m256i state[8];
+    __m256i W[16];
+    __m256i a, b, c, d, e, f, g, h;
+    int i;
+    int t;
+
+    /* lane i of state[j] and W[t] belongs to hash i: the state and the message are transposed */
+    for (i = 0; i < 8; i++)
+    {
+        rows[i] = _mm256_loadu_si256((const __m256i*)Intermediate_Hashes[i]);
+    }
+    SHA256_HW_AVX2_Transpose(state, rows);
+    for (t = 0; t < 16; t += 8)
+    {
+        for (i = 0; i < 8; i++)
+        {
+            rows[i] = _mm256_loadu_si256((const __m256i*)(blocks[i] + (t * 4)));
+        }
+        SHA256_HW_AVX2_Transpose(&W[t], rows);
+        for (i = 0; i < 8; i++)
+        {
+            W[t + i] = _mm256_shuffle_epi8(W[t + i], byte_swap);
+        }
+    }
+
+    a = state[0];
+    b = state[1];
+    c = state[2];
+    d = state[3];
+    e = state[4];
+    f = state[5];
+    g = state[6];
+    h = state[7];
+
+    for (t = 0; t < 64; t++)
+    {
+        __m256i temp1;
+        __m256i temp2;
+        __m256i words;
+        if (t < 16)
+        {
+            words = W[t];
+        }
+        else
+        {
+            /* W holds the last 16 words of the message schedule */
+            __m256i w15 = W[(t - 15) & 15];
+            __m256i w2 = W[(t - 2) & 15];
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(SHA256_AVX2_ROTR(w15, 7), SHA256_AVX2_ROTR(w15, 18)), _mm256_srli_epi32(w15, 3));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(SHA256_AVX2_ROTR(w2, 17), SHA256_AVX2_ROTR(w2, 19)), _mm256_srli_epi32(w2, 10));
+            words = _mm256_add_epi32(_mm256_add_epi32(W[t & 15], s0), _mm256_add_epi32(W[(t - 7) & 15], s1));
+            W[t & 15] = words;
+        }
+
+        temp1 = _mm256_add_epi32(h, _mm256_xor_si256(_mm256_xor_si256(SHA256_AVX2_ROTR(e, 6), SHA256_AVX2_ROTR(e, 11)), SHA256_AVX2_ROTR(e, 25)));
+        temp1 = _mm256_add_epi32(temp1, _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g)));
+        temp1 = _mm256_add_epi32(temp1, _mm256_add_epi32(words, _mm256_set1_epi32((int)K[t])));
+        temp2 = _mm256_xor_si256(_mm256_xor_si256(SHA256_AVX2_ROTR(a, 2), SHA256_AVX2_ROTR(a, 13)), SHA256_AVX2_ROTR(a, 22));
+        temp2 = _mm256_add_epi32(temp2, _mm256_or_si256(_mm256_and_si256(_mm256_or_si256(a, b), c), _mm256_and_si256(a, b)));
+        h = g;
+        g = f;
+        f = e;
+        e = _mm256_add_epi32(d, temp1);
+        d = c;
+        c = b;
+        b = a;
+        a = _mm256_add_epi32(temp1, temp2);
+    }
+
+    state[0] = _mm256_add_epi32(state[0], a);
+    state[1] = _mm256_add_epi32(state[1], b);
+    state[2] = _mm256_add_epi32(state[2], c);
+    state[3] = _mm256_add_epi32(state[3], d);
+    state[4] = _mm256_add_epi32(state[4], e);
+    state[5] = _mm256_add_epi32(state[5], f);
+    state[6] = _mm256_add_epi32(state[6], g);
+    state[7] = _mm256_add_epi32(state[7], h);
+
+    SHA256_HW_AVX2_Transpose(rows, state);
+    for (i = 0; i < 8; i++)
+    {
+        _mm256_storeu_si256((__m256i*)Intermediate_Hashes[i], rows[i]);
+    }
+}
+
+#elif defined(SHA256_HW_ARM)
+
+static int SHA256_HW_ARM_Available(void)
+{
+#if defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_SHA2) != 0;
+#else
+    /* every 64 bit Apple CPU has the SHA2 instructions */
+    return 1;
+#endif
+}
+
+SHA256_HW_ARM_TARGET
+static void SHA256_HW_ARM_ProcessBlocks(uint32_t Intermediate_Hash[8], const uint8_t *blocks, size_t block_count)
+{
+    uint32x4_t state0 = vld1q_u32(&Intermediate_Hash[0]);
+    uint32x4_t state1 = vld1q_u32(&Intermediate_Hash[4]);
+
+    while (block_count-- > 0)
+    {
+        uint32x4_t W[4];
+        uint32x4_t abcd = state0;
+        uint32x4_t efgh = state1;
+        int t;
+
+        /* 4 rounds at a time, W holds the last 16 words of the message schedule */
+        for (t = 0; t < 16; t++)
+        {
+            uint32x4_t words;
+            uint32x4_t temp;
+            uint32x4_t previous_state0;
+            if (t < 4)
+            {
+                words = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(blocks + (t * 16))));
+            }
+            else
+            {
+                words = vsha256su1q_u32(vsha256su0q_u32(W[t & 3], W[(t + 1) & 3]), W[(t + 2) & 3], W[(t + 3) & 3]);
+            }
+            W[t & 3] = words;
+
+            temp = vaddq_u32(words, vld1q_u32(&K[t * 4]));
+            previous_state0 = state0;
+            state0 = vsha256hq_u32(state0, state1, temp);
+            state1 = vsha256h2q_u32(state1, previous_state0, temp);
+        }
+
+        state0 = vaddq_u32(state0, abcd);
+        state1 = vaddq_u32(state1, efgh);
+        blocks += SHA256_Message_Block_Size;
+    }
+
+    vst1q_u32(&Intermediate_Hash[0], state0);
+    vst1q_u32(&Intermediate_Hash[4], state1);
+}
+
+#endif
+
+SHA224_256_PROCESS_BLOCKS SHA224_256GetHardwareProcessBlocks(void)
+{
+    SHA224_256_PROCESS_BLOCKS result;
+#if defined(SHA256_HW_X86)
+    result = SHA256_HW_X86_Available() ? SHA256_HW_X86_ProcessBlocks : NULL;
+#elif defined(SHA256_HW_ARM)
+    result = SHA256_HW_ARM_Available() ? SHA256_HW_ARM_ProcessBlocks : NULL;
+#else
+    result = NULL;
+#endif
+    return result;
+}
+
+SHA224_256_PROCESS_LANES SHA224_256GetHardwareProcessLanes(void)
+{
+    SHA224_256_PROCESS_LANES result;
+#if defined(SHA256_HW_X86)
+    result = SHA256_HW_AVX2_Available() ? SHA256_HW_AVX2_ProcessLanes : NULL;
+#else
+    result = NULL;
+#endif
+    return result;
+}
@@ -43,6 +43,7 @@
 */
 
 #include <stdlib.h>
+#include <string.h>
 #include "azure_c_shared_utility/gballoc.h"
 
 #include "azure_c_shared_utility/sha.h"
@@ -306,10 +307,34 @@ static void SHA384_512Finalize(SHA512Context *context,
 static void SHA384_512PadMessage(SHA512Context *context,
     uint8_t Pad_Byte);
 static void SHA384_512ProcessMessageBlock(SHA512Context *context);
+static void SHA384_512ProcessBlocks(uint64_t Intermediate_Hash[SHA512HashSize / 8], const uint8_t *blocks, size_t block_count);
 static int SHA384_512Reset(SHA512Context *context, uint64_t H0[]);
 static int SHA384_512ResultN(SHA512Context *context,
     uint8_t Message_Digest[], int HashSize);
 
+/*
+* The block function in use: the SHA512 instructions of the CPU when it
+* has them (see sha384-512_hw.c), SHA384_512ProcessBlocks otherwise. It
+* is resolved on first use; threads racing to resolve it all store the
+* same value.
+*/
+static SHA384_512_PROCESS_BLOCKS SHA384_512_Process_Blocks = NULL;
+
+static SHA384_512_PROCESS_BLOCKS SHA384_512GetProcessBlocks(void)
+{
+    SHA384_512_PROCESS_BLOCKS result = SHA384_512_Process_Blocks;
+    if (result == NULL)
+    {
+        result = SHA384_512GetHardwareProcessBlocks();
+        if (result == NULL)
+        {
+            result = SHA384_512ProcessBlocks;
+        }
+        SHA384_512_Process_Blocks = result;
+    }
+    return result;
+}
+
 /* Initial Hash Values: FIPS-180-2 sections 5.3.3 and 5.3.4 */
 static uint64_t SHA384_H0[] = {
     0xCBBB9D5DC1059ED8ull, 0x629A292A367CD507ull, 0x9159015A3070DD17ull,
@@ -480,6 +505,7 @@ int SHA512Input(SHA512Context *context,
     if (context->Corrupted)
         return context->Corrupted;
 
+#ifdef USE_32BIT_ONLY
     while (length-- && !context->Corrupted) {
         context->Message_Block[context->Message_Block_Index++] =
             (*message_array & 0xFF);
@@ -490,6 +516,30 @@ int SHA512Input(SHA512Context *context,
 
         message_array++;
     }
+#else /* !USE_32BIT_ONLY */
+    while (length && !context->Corrupted) {
+        if ((context->Message_Block_Index == 0) && (length >= SHA512_Message_Block_Size)) {
+            /* whole blocks do not need to be copied to Message_Block */
+            unsigned int chunk_size = length & ~(unsigned int)(SHA512_Message_Block_Size - 1);
+            if (!SHA384_512AddLength(context, (uint64_t)chunk_size * 8))
+                SHA384_512GetProcessBlocks()(context->Intermediate_Hash, message_array, chunk_size / SHA512_Message_Block_Size);
+            message_array += chunk_size;
+            length -= chunk_size;
+        } else {
+            unsigned int copy_size = SHA512_Message_Block_Size - context->Message_Block_Index;
+            if (copy_size > length)
+                copy_size = length;
+            (void)memcpy(context->Message_Block + context->Message_Block_Index, message_array, copy_size);
+            context->Message_Block_Index += (int_least16_t)copy_size;
+
+            if (!SHA384_512AddLength(context, (uint64_t)copy_size * 8) &&
+                (context->Message_Block_Index == SHA512_Message_Block_Size))
+                SHA384_512ProcessMessageBlock(context);
+            message_array += copy_size;
+            length -= copy_size;
+        }
+    }
+#endif /* USE_32BIT_ONLY */
 
     return shaSuccess;
 }
@@ -850,6 +900,76 @@ static void SHA384_512ProcessMessageBlock(SHA512Context *context)
     SHA512_ADDTO2(&context->Intermediate_Hash[14], H);
 
 #else /* !USE_32BIT_ONLY */
+    SHA384_512GetProcessBlocks()(context->Intermediate_Hash, context->Message_Block, 1);
+#endif /* USE_32BIT_ONLY */
+
+    context->Message_Block_Index = 0;
+}
+
+#ifndef USE_32BIT_ONLY
+/*
+* SHA512UseHardwareAcceleration
+*
+* Description:
+*   This function selects whether the SHA-384 and SHA-512 blocks are
+*   processed with the SHA512 instructions of the CPU or with the
+*   portable code. The instructions are used by default when the CPU
+*   has them.
+*
+* Parameters:
+*   use: [in]
+*     Non-zero to use the SHA512 instructions, 0 for the portable code.
+*
+* Returns:
+*   sha Error Code, shaBadParam if the SHA512 instructions are asked
+*   for and not available.
+*/
+int SHA512UseHardwareAcceleration(int use)
+{
+    int result;
+    SHA384_512_PROCESS_BLOCKS hardware_process_blocks = SHA384_512GetHardwareProcessBlocks();
+    if (!use)
+    {
+        SHA384_512_Process_Blocks = SHA384_512ProcessBlocks;
+        result = shaSuccess;
+    }
+    else if (hardware_process_blocks == NULL)
+    {
+        result = shaBadParam;
+    }
+    else
+    {
+        SHA384_512_Process_Blocks = hardware_process_blocks;
+        result = shaSuccess;
+    }
+    return result;
+}
+
+/*
+* SHA384_512ProcessBlocks
+*
+* Description:
+*   This function will process block_count consecutive blocks of
+*   1024 bits of the message, without SHA512 instructions.
+*
+* Parameters:
+*   Intermediate_Hash: [in/out]
+*     The intermediate hash to update
+*   blocks: [in]
+*     The blocks to process
+*   block_count: [in]
+*     The number of blocks
+*
+* Returns:
+*   Nothing.
+*
+* Comments:
+*   Many of the variable names in this code, especially the
+*   single character names, were used because those were the
+*   names used in the publication.
+*/
+static void SHA384_512ProcessBlocks(uint64_t Intermediate_Hash[SHA512HashSize / 8], const uint8_t *blocks, size_t block_count)
+{
     static const uint64_t K[80] = {
         0x428A2F98D728AE22ull, 0x7137449123EF65CDull, 0xB5C0FBCFEC4D3B2Full,
         0xE9B5DBA58189DBBCull, 0x3956C25BF348B538ull, 0x59F111F1B605D019ull,
@@ -884,57 +1004,60 @@ static void SHA384_512ProcessMessageBlock(SHA512Context *context)
     uint64_t   W[80];                   /* Word sequence */
     uint64_t   A, B, C, D, E, F, G, H;  /* Word buffers */
 
-    /*
-    * Initialize the first 16 words in the array W
-    */
-    for (t = t8 = 0; t < 16; t++, t8 += 8)
-        W[t] = ((uint64_t)(context->Message_Block[t8]) << 56) |
-        ((uint64_t)(context->Message_Block[t8 + 1]) << 48) |
-        ((uint64_t)(context->Message_Block[t8 + 2]) << 40) |
-        ((uint64_t)(context->Message_Block[t8 + 3]) << 32) |
-        ((uint64_t)(context->Message_Block[t8 + 4]) << 24) |
-        ((uint64_t)(context->Message_Block[t8 + 5]) << 16) |
-        ((uint64_t)(context->Message_Block[t8 + 6]) << 8) |
-        ((uint64_t)(context->Message_Block[t8 + 7]));
-
-    for (t = 16; t < 80; t++)
-        W[t] = SHA512_sigma1(W[t - 2]) + W[t - 7] +
-        SHA512_sigma0(W[t - 15]) + W[t - 16];
-
-    A = context->Intermediate_Hash[0];
-    B = context->Intermediate_Hash[1];
-    C = context->Intermediate_Hash[2];
-    D = context->Intermediate_Hash[3];
-    E = context->Intermediate_Hash[4];
-    F = context->Intermediate_Hash[5];
-    G = context->Intermediate_Hash[6];
-    H = context->Intermediate_Hash[7];
-
-    for (t = 0; t < 80; t++) {
-        temp1 = H + SHA512_SIGMA1(E) + SHA_Ch(E, F, G) + K[t] + W[t];
-        temp2 = SHA512_SIGMA0(A) + SHA_Maj(A, B, C);
-        H = G;
-        G = F;
-        F = E;
-        E = D + temp1;
-        D = C;
-        C = B;
-        B = A;
-        A = temp1 + temp2;
+    while (block_count-- > 0) {
+        /*
+        * Initialize the first 16 words in the array W
+        */
+        for (t = t8 = 0; t < 16; t++, t8 += 8)
+            W[t] = ((uint64_t)(blocks[t8]) << 56) |
+            ((uint64_t)(blocks[t8 + 1]) << 48) |
+            ((uint64_t)(blocks[t8 + 2]) << 40) |
+            ((uint64_t)(blocks[t8 + 3]) << 32) |
+            ((uint64_t)(blocks[t8 + 4]) << 24) |
+            ((uint64_t)(blocks[t8 + 5]) << 16) |
+            ((uint64_t)(blocks[t8 + 6]) << 8) |
+            ((uint64_t)(blocks[t8 + 7]));
+
+        for (t = 16; t < 80; t++)
+            W[t] = SHA512_sigma1(W[t - 2]) + W[t - 7] +
+            SHA512_sigma0(W[t - 15]) + W[t - 16];
+
+        A = Intermediate_Hash[0];
+        B = Intermediate_Hash[1];
+        C = Intermediate_Hash[2];
+        D = Intermediate_Hash[3];
+        E = Intermediate_Hash[4];
+        F = Intermediate_Hash[5];
+        G = Intermediate_Hash[6];
+        H = Intermediate_Hash[7];
+
+        for (t = 0; t < 80; t++) {
+            temp1 = H + SHA512_SIGMA1(E) + SHA_Ch(E, F, G) + K[t] + W[t];
+            temp2 = SHA512_SIGMA0(A) + SHA_Maj(A, B, C);
+            H = G;
+            G = F;
+            F = E;
+            E = D + temp1;
+            D = C;
+            C = B;
+            B = A;
+            A = temp1 + temp2;
+        }
+
+        Intermediate_Hash[0] += A;
+        Intermediate_Hash[1] += B;
+        Intermediate_Hash[2] += C;
+        Intermediate_Hash[3] += D;
+        Intermediate_Hash[4] += E;
+        Intermediate_Hash[5] += F;
+        Intermediate_Hash[6] += G;
+        Intermediate_Hash[7] += H;
+
+        blocks += SHA512_Message_Block_Size;
     }
-
-    context->Intermediate_Hash[0] += A;
-    context->Intermediate_Hash[1] += B;
-    context->Intermediate_Hash[2] += C;
-    context->Intermediate_Hash[3] += D;
-    context->Intermediate_Hash[4] += E;
-    context->Intermediate_Hash[5] += F;
-    context->Intermediate_Hash[6] += G;
-    context->Intermediate_Hash[7] += H;
+}
 #endif /* USE_32BIT_ONLY */
 
-    context->Message_Block_Index = 0;
-}
 
 /*
 * SHA384_512Reset
@@ -0,0 +1,161 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+/*
+* SHA-384/SHA-512 block function using the ARMv8.2 SHA512 instructions
+* of AArch64 CPUs.
+*
+* The instructions are only used when the CPU reports them at run time,
+* sha384-512.c falls back to its portable block function otherwise, as
+* it always does on x86. Define NO_SHA_HARDWARE_ACCELERATION to build
+* without them.
+*/
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "azure_c_shared_utility/sha.h"
+#include "azure_c_shared_utility/sha-private.h"
+
+#if !defined(NO_SHA_HARDWARE_ACCELERATION)
+
+#if defined(__aarch64__) && (defined(__linux__) || defined(__APPLE__)) && ((defined(__clang__) && (__clang_major__ >= 10)) || (!defined(__clang__) && defined(__GNUC__) && (__GNUC__ >= 8)))
+#define SHA512_HW_ARM
+#if defined(__ARM_FEATURE_SHA512)
+#define SHA512_HW_ARM_TARGET
+#elif defined(__clang__)
+#define SHA512_HW_ARM_TARGET __attribute__((target("sha3")))
+#else
+#define SHA512_HW_ARM_TARGET __attribute__((target("+sha3")))
+#endif
+#include <arm_neon.h>
+#if defined(__linux__)
+#include <sys/auxv.h>
+#ifndef HWCAP_SHA512
+#define HWCAP_SHA512 (1 << 21)
+#endif
+#else
+#include <sys/sysctl.h>
+#endif
+#endif
+
+#endif /* NO_SHA_HARDWARE_ACCELERATION */
+
+#if defined(SHA512_HW_ARM)
+
+/* Constants defined in FIPS-180-2, section 4.2.3 */
+static const uint64_t K[80] = {
+    0x428A2F98D728AE22ull, 0x7137449123EF65CDull, 0xB5C0FBCFEC4D3B2Full,
+    0xE9B5DBA58189DBBCull, 0x3956C25BF348B538ull, 0x59F111F1B605D019ull,
+    0x923F82A4AF194F9Bull, 0xAB1C5ED5DA6D8118ull, 0xD807AA98A3030242ull,
+    0x12835B0145706FBEull, 0x243185BE4EE4B28Cull, 0x550C7DC3D5FFB4E2ull,
+    0x72BE5D74F27B896Full, 0x80DEB1FE3B1696B1ull, 0x9BDC06A725C71235ull,
+    0xC19BF174CF692694ull, 0xE49B69C19EF14AD2ull, 0xEFBE4786384F25E3ull,
+    0x0FC19DC68B8CD5B5ull, 0x240CA1CC77AC9C65ull, 0x2DE92C6F592B0275ull,
+    0x4A7484AA6EA6E483ull, 0x5CB0A9DCBD41FBD4ull, 0x76F988DA831153B5ull,
+    0x983E5152EE66DFABull, 0xA831C66D2DB43210ull, 0xB00327C898FB213Full,
+    0xBF597FC7BEEF0EE4ull, 0xC6E00BF33DA88FC2ull, 0xD5A79147930AA725ull,
+    0x06CA6351E003826Full, 0x142929670A0E6E70ull, 0x27B70A8546D22FFCull,
+    0x2E1B21385C26C926ull, 0x4D2C6DFC5AC42AEDull, 0x53380D139D95B3DFull,
+    0x650A73548BAF63DEull, 0x766A0ABB3C77B2A8ull, 0x81C2C92E47EDAEE6ull,
+    0x92722C851482353Bull, 0xA2BFE8A14CF10364ull, 0xA81A664BBC423001ull,
+    0xC24B8B70D0F89791ull, 0xC76C51A30654BE30ull, 0xD192E819D6EF5218ull,
+    0xD69906245565A910ull, 0xF40E35855771202Aull, 0x106AA07032BBD1B8ull,
+    0x19A4C116B8D2D0C8ull, 0x1E376C085141AB53ull, 0x2748774CDF8EEB99ull,
+    0x34B0BCB5E19B48A8ull, 0x391C0CB3C5C95A63ull, 0x4ED8AA4AE3418ACBull,
+    0x5B9CCA4F7763E373ull, 0x682E6FF3D6B2B8A3ull, 0x748F82EE5DEFB2FCull,
+    0x78A5636F43172F60ull, 0x84C87814A1F0AB72ull, 0x8CC702081A6439ECull,
+    0x90BEFFFA23631E28ull, 0xA4506CEBDE82BDE9ull, 0xBEF9A3F7B2C67915ull,
+    0xC67178F2E372532Bull, 0xCA273ECEEA26619Cull, 0xD186B8C721C0C207ull,
+    0xEADA7DD6CDE0EB1Eull, 0xF57D4F7FEE6ED178ull, 0x06F067AA72176FBAull,
+    0x0A637DC5A2C898A6ull, 0x113F9804BEF90DAEull, 0x1B710B35131C471Bull,
+    0x28DB77F523047D84ull, 0x32CAAB7B40C72493ull, 0x3C9EBE0A15C9BEBCull,
+    0x431D67C49C100D4Cull, 0x4CC5D4BECB3E42B6ull, 0x597F299CFC657E2Aull,
+    0x5FCB6FAB3AD6FAECull, 0x6C44198C4A475817ull
+};
+
+static int SHA512_HW_ARM_Available(void)
+{
+#if defined(__linux__)
+    return (getauxval(AT_HWCAP) & HWCAP_SHA512) != 0;
+#else
+    int value = 0;
+    size_t size = sizeof(value);
+    return (sysctlbyname("hw.optional.armv8_2_sha512", &value, &size, NULL, 0) == 0) && (value != 0);
+#endif
+}
+
+SHA512_HW_ARM_TARGET
+static void SHA512_HW_ARM_ProcessBlocks(uint64_t Intermediate_Hash[8], const uint8_t *blocks, size_t block_count)
+{
+    /* S holds AB, CD, EF and GH; each 2 rounds shift them by one register, so
+       the register holding AB in round pair t is S[(4 - t) & 3] */
+    uint64x2_t S[4];
+    int i;
+
+    for (i = 0; i < 4; i++)
+    {
+        S[i] = vld1q_u64(&Intermediate_Hash[i * 2]);
+    }
+
+    while (block_count-- > 0)
+    {
+        uint64x2_t W[8];
+        uint64x2_t saved[4];
+        int t;
+
+        for (i = 0; i < 4; i++)
+        {
+            saved[i] = S[i];
+        }
+        for (i = 0; i < 8; i++)
+        {
+            W[i] = vreinterpretq_u64_u8(vrev64q_u8(vld1q_u8(blocks + (i * 16))));
+        }
+
+        /* 2 rounds at a time, W holds the last 16 words of the message schedule */
+        for (t = 0; t < 40; t++)
+        {
+            uint64x2_t* ab = &S[(4 - t) & 3];
+            uint64x2_t* cd = &S[(5 - t) & 3];
+            uint64x2_t* ef = &S[(6 - t) & 3];
+            uint64x2_t* gh = &S[(7 - t) & 3];
+            uint64x2_t words = vaddq_u64(W[t & 7], vld1q_u64(&K[t * 2]));
+            uint64x2_t sum;
+
+            words = vaddq_u64(vextq_u64(words, words, 1), *gh);
+            sum = vsha512hq_u64(words, vextq_u64(*ef, *gh, 1), vextq_u64(*cd, *ef, 1));
+            *gh = vsha512h2q_u64(sum, *cd, *ab);
+            *cd = vaddq_u64(*cd, sum);
+
+            if (t < 32)
+            {
+                W[t & 7] = vsha512su1q_u64(vsha512su0q_u64(W[t & 7], W[(t + 1) & 7]), W[(t + 7) & 7], vextq_u64(W[(t + 4) & 7], W[(t + 5) & 7], 1));
+            }
+        }
+
+        for (i = 0; i < 4; i++)
+        {
+            S[i] = vaddq_u64(S[i], saved[i]);
+        }
+        blocks += SHA512_Message_Block_Size;
+    }
+
+    for (i = 0; i < 4; i++)
+    {
+        vst1q_u64(&Intermediate_Hash[i * 2], S[i]);
+    }
+}
+
+#endif
+
+SHA384_512_PROCESS_BLOCKS SHA384_512GetHardwareProcessBlocks(void)
+{
+    SHA384_512_PROCESS_BLOCKS result;
+#if defined(SHA512_HW_ARM)
+    result = SHA512_HW_ARM_Available() ? SHA512_HW_ARM_ProcessBlocks : NULL;
+#else
+    result = NULL;
+#endif
+    return result;
+}
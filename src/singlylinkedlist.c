@@ -6,6 +6,9 @@
 #include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
+#ifdef USE_OBJECT_POOLS
+#include "azure_c_shared_utility/object_pool.h"
+#endif
 
 typedef struct LIST_ITEM_INSTANCE_TAG
 {
@@ -19,6 +22,20 @@ typedef struct SINGLYLINKEDLIST_INSTANCE_TAG
     LIST_ITEM_INSTANCE* tail;
 } LIST_INSTANCE;
 
+#ifdef USE_OBJECT_POOLS
+/*the number of list nodes when built with OBJECT_POOL_STATIC*/
+#ifndef SINGLYLINKEDLIST_ITEM_POOL_COUNT
+#define SINGLYLINKEDLIST_ITEM_POOL_COUNT 128
+#endif
+OBJECT_POOL_DEFINE_STATIC(list_item_pool, sizeof(LIST_ITEM_INSTANCE), SINGLYLINKEDLIST_ITEM_POOL_COUNT);
+/* Codes_SRS_LIST_01_026: [ When built with USE_OBJECT_POOLS, the list nodes shall be recycled through an object pool. ]*/
+#define alloc_list_item() ((LIST_ITEM_INSTANCE*)object_pool_alloc(&list_item_pool))
+#define free_list_item(list_item) object_pool_free(&list_item_pool, list_item)
+#else
+#define alloc_list_item() ((LIST_ITEM_INSTANCE*)malloc(sizeof(LIST_ITEM_INSTANCE)))
+#define free_list_item(list_item) free(list_item)
+#endif
+
 SINGLYLINKEDLIST_HANDLE singlylinkedlist_create(void)
 {
     LIST_INSTANCE* result;
@@ -46,7 +63,7 @@ void singlylinkedlist_destroy(SINGLYLINKEDLIST_HANDLE list)
         {
             LIST_ITEM_INSTANCE* current_item = list_instance->head;
             list_instance->head = (LIST_ITEM_INSTANCE*)current_item->next;
-            free(current_item);
+            free_list_item(current_item);
         }
 
         /* Codes_SRS_LIST_01_003: [singlylinkedlist_destroy shall free all resources associated with the list identified by the handle argument.] */
@@ -68,7 +85,7 @@ LIST_ITEM_HANDLE singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void*
     else
     {
         LIST_INSTANCE* list_instance = (LIST_INSTANCE*)list;
-        result = (LIST_ITEM_INSTANCE*)malloc(sizeof(LIST_ITEM_INSTANCE));
+        result = alloc_list_item();
 
         if (result == NULL)
         {
@@ -132,7 +149,7 @@ int singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item)
                     list_instance->tail = previous_item;
                 }
 
-                free(current_item);
+                free_list_item(current_item);
 
                 break;
             }
@@ -303,7 +320,7 @@ int singlylinkedlist_remove_if(SINGLYLINKEDLIST_HANDLE list, LIST_CONDITION_FUNC
                     list_instance->tail = previous_item;
                 }
 
-                free(current_item);
+                free_list_item(current_item);
             }
             /* Codes_SRS_LIST_09_005: [ If the condition function returns false, singlylinkedlist_find shall consider that item as not to be removed. ] */
             else
@@ -378,7 +395,7 @@ LIST_ITEM_HANDLE singlylinkedlist_add_head(SINGLYLINKEDLIST_HANDLE list, const v
     }
     else
     {
-        result = malloc(sizeof(LIST_ITEM_INSTANCE));
+        result = alloc_list_item();
 
         if (result == NULL)
         {
@@ -0,0 +1,998 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/standby_io.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+/* how soon xio_dowork_ex asks to be called again while a connection is being opened in the background, since the
+   pollable handle given to the caller is the one of the connection in use */
+#define STANDBY_IO_OPENING_WORK_INTERVAL_US     10000
+
+#define STANDBY_IO_LINK_COUNT   2
+
+typedef enum STANDBY_IO_STATE_TAG
+{
+    STANDBY_IO_STATE_CLOSED,
+    STANDBY_IO_STATE_OPENING,
+    STANDBY_IO_STATE_OPEN,
+    STANDBY_IO_STATE_CLOSING,
+    STANDBY_IO_STATE_ERROR
+} STANDBY_IO_STATE;
+
+typedef enum STANDBY_IO_LINK_STATE_TAG
+{
+    STANDBY_IO_LINK_STATE_CLOSED,
+    STANDBY_IO_LINK_STATE_OPENING,
+    STANDBY_IO_LINK_STATE_OPEN,
+    STANDBY_IO_LINK_STATE_CLOSING
+} STANDBY_IO_LINK_STATE;
+
+/* one connection of the layer below, the callbacks of its IO get the link as context */
+typedef struct STANDBY_IO_LINK_TAG
+{
+    XIO_HANDLE underlying_io;
+    STANDBY_IO_LINK_STATE state;
+    /* when the link was opened, for the refresh of an idle standby link */
+    tickcounter_us_t open_since_us;
+    /* a closed link is not opened in the background before this time, set when the link failed */
+    tickcounter_us_t retry_after_us;
+    struct STANDBY_IO_INSTANCE_TAG* standby_io_instance;
+} STANDBY_IO_LINK;
+
+typedef struct STANDBY_IO_INSTANCE_TAG
+{
+    STANDBY_IO_STATE standby_io_state;
+    ON_BYTES_RECEIVED on_bytes_received;
+    void* on_bytes_received_context;
+    ON_IO_ERROR on_io_error;
+    void* on_io_error_context;
+    ON_IO_OPEN_COMPLETE on_io_open_complete;
+    void* on_io_open_complete_context;
+    ON_IO_CLOSE_COMPLETE on_io_close_complete;
+    void* on_io_close_complete_context;
+    STANDBY_IO_LINK links[STANDBY_IO_LINK_COUNT];
+    /* the link used by the layer above, the other one is the standby link */
+    size_t active_link;
+    /* set by the first open, the standby link is kept open from then on */
+    bool keep_standby;
+    tickcounter_us_t refresh_interval_us;
+    tickcounter_us_t retry_interval_us;
+    XIO_STATS stats;
+} STANDBY_IO_INSTANCE;
+
+static tickcounter_us_t get_now_us(void)
+{
+    tickcounter_us_t result;
+
+    if (tickcounter_get_monotonic_us(&result) != 0)
+    {
+        LogError("tickcounter_get_monotonic_us failed");
+        result = 0;
+    }
+
+    return result;
+}
+
+static bool is_active_link(const STANDBY_IO_LINK* link)
+{
+    return (link == &link->standby_io_instance->links[link->standby_io_instance->active_link]);
+}
+
+static STANDBY_IO_LINK* get_standby_link(STANDBY_IO_INSTANCE* standby_io_instance)
+{
+    return &standby_io_instance->links[STANDBY_IO_LINK_COUNT - 1 - standby_io_instance->active_link];
+}
+
+/* the link an open uses: an open one, else one being opened, else a closed one, the link used last first */
+static size_t pick_link(const STANDBY_IO_INSTANCE* standby_io_instance)
+{
+    static const STANDBY_IO_LINK_STATE preferred_states[] = { STANDBY_IO_LINK_STATE_OPEN, STANDBY_IO_LINK_STATE_OPENING, STANDBY_IO_LINK_STATE_CLOSED };
+    size_t result = standby_io_instance->active_link;
+    bool found = false;
+    size_t i;
+
+    for (i = 0; !found && (i < sizeof(preferred_states) / sizeof(preferred_states[0])); i++)
+    {
+        size_t j;
+
+        for (j = 0; !found && (j < STANDBY_IO_LINK_COUNT); j++)
+        {
+            size_t link_index = (standby_io_instance->active_link + j) % STANDBY_IO_LINK_COUNT;
+
+            if (standby_io_instance->links[link_index].state == preferred_states[i])
+            {
+                result = link_index;
+                found = true;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void on_link_open_complete(void* context, IO_OPEN_RESULT open_result);
+static void on_link_bytes_received(void* context, const unsigned char* buffer, size_t size);
+static void on_link_error(void* context);
+
+static void on_link_close_complete(void* context)
+{
+    STANDBY_IO_LINK* link = (STANDBY_IO_LINK*)context;
+    STANDBY_IO_INSTANCE* standby_io_instance = link->standby_io_instance;
+
+    link->state = STANDBY_IO_LINK_STATE_CLOSED;
+
+    if (is_active_link(link) &&
+        (standby_io_instance->standby_io_state == STANDBY_IO_STATE_CLOSING))
+    {
+        /* Codes_SRS_STANDBY_IO_01_031: [ When the link in use completes its close while the standby IO is CLOSING, the standby IO shall be CLOSED and on_io_close_complete shall be called, if it is not NULL. ]*/
+        standby_io_instance->standby_io_state = STANDBY_IO_STATE_CLOSED;
+        if (standby_io_instance->on_io_close_complete != NULL)
+        {
+            standby_io_instance->on_io_close_complete(standby_io_instance->on_io_close_complete_context);
+        }
+    }
+}
+
+static int open_link(STANDBY_IO_LINK* link)
+{
+    int result;
+
+    link->state = STANDBY_IO_LINK_STATE_OPENING;
+
+    if (xio_open(link->underlying_io, on_link_open_complete, link, on_link_bytes_received, link, on_link_error, link) != 0)
+    {
+        LogError("Cannot open the underlying IO.");
+        link->state = STANDBY_IO_LINK_STATE_CLOSED;
+        link->retry_after_us = get_now_us() + link->standby_io_instance->retry_interval_us;
+        result = __LINE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+/* closes a link that is not given back to the layer above, a failed one is not opened again before retry_interval_ms */
+static void close_link(STANDBY_IO_LINK* link, bool failed)
+{
+    link->state = STANDBY_IO_LINK_STATE_CLOSING;
+    link->retry_after_us = failed ? (get_now_us() + link->standby_io_instance->retry_interval_us) : 0;
+
+    if (xio_close(link->underlying_io, on_link_close_complete, link) != 0)
+    {
+        /* an IO that refuses to close is opened again from the state it is in */
+        LogError("Cannot close the underlying IO.");
+        link->state = STANDBY_IO_LINK_STATE_CLOSED;
+    }
+}
+
+static void maintain_standby_link(STANDBY_IO_INSTANCE* standby_io_instance)
+{
+    if (standby_io_instance->keep_standby)
+    {
+        STANDBY_IO_LINK* standby_link = get_standby_link(standby_io_instance);
+
+        if (standby_link->state == STANDBY_IO_LINK_STATE_CLOSED)
+        {
+            if (get_now_us() >= standby_link->retry_after_us)
+            {
+                /* Codes_SRS_STANDBY_IO_01_040: [ If the standby link is closed and the retry interval since its last failure has passed, it shall be opened by calling xio_open. ]*/
+                (void)open_link(standby_link);
+            }
+        }
+        else if ((standby_link->state == STANDBY_IO_LINK_STATE_OPEN) &&
+            (standby_io_instance->refresh_interval_us > 0) &&
+            (get_now_us() - standby_link->open_since_us >= standby_io_instance->refresh_interval_us))
+        {
+            /* Codes_SRS_STANDBY_IO_01_041: [ If the standby link has been open and idle for refresh_interval_ms and refresh_interval_ms is not 0, it shall be closed by calling xio_close and opened again once closed. ]*/
+            close_link(standby_link, false);
+        }
+    }
+}
+
+/* the standby IO was opening on a link that failed: it goes on with the standby link if it is open or opening */
+static void on_active_link_open_failed(STANDBY_IO_INSTANCE* standby_io_instance)
+{
+    STANDBY_IO_LINK* standby_link = get_standby_link(standby_io_instance);
+
+    if (standby_link->state == STANDBY_IO_LINK_STATE_OPEN)
+    {
+        /* Codes_SRS_STANDBY_IO_01_021: [ If the link being opened fails while the standby link is open, the standby link shall be used, the standby IO shall be OPEN and on_io_open_complete shall be called with IO_OPEN_OK. ]*/
+        standby_io_instance->active_link = STANDBY_IO_LINK_COUNT - 1 - standby_io_instance->active_link;
+        standby_io_instance->standby_io_state = STANDBY_IO_STATE_OPEN;
+        standby_io_instance->on_io_open_complete(standby_io_instance->on_io_open_complete_context, IO_OPEN_OK);
+    }
+    else if (standby_link->state == STANDBY_IO_LINK_STATE_OPENING)
+    {
+        /* Codes_SRS_STANDBY_IO_01_022: [ If the link being opened fails while the standby link is opening, the standby IO shall wait for the standby link instead. ]*/
+        standby_io_instance->active_link = STANDBY_IO_LINK_COUNT - 1 - standby_io_instance->active_link;
+    }
+    else
+    {
+        /* Codes_SRS_STANDBY_IO_01_023: [ Otherwise the standby IO shall be CLOSED and on_io_open_complete shall be called with IO_OPEN_ERROR. ]*/
+        standby_io_instance->standby_io_state = STANDBY_IO_STATE_CLOSED;
+        standby_io_instance->on_io_open_complete(standby_io_instance->on_io_open_complete_context, IO_OPEN_ERROR);
+    }
+}
+
+static void on_link_failed(STANDBY_IO_LINK* link)
+{
+    STANDBY_IO_INSTANCE* standby_io_instance = link->standby_io_instance;
+    bool was_opening = (link->state == STANDBY_IO_LINK_STATE_OPENING);
+
+    /* Codes_SRS_STANDBY_IO_01_024: [ A link that fails shall be closed by calling xio_close, and shall not be opened in the background before retry_interval_ms has passed. ]*/
+    close_link(link, true);
+
+    if (is_active_link(link))
+    {
+        if (was_opening && (standby_io_instance->standby_io_state == STANDBY_IO_STATE_OPENING))
+        {
+            on_active_link_open_failed(standby_io_instance);
+        }
+        else if (standby_io_instance->standby_io_state == STANDBY_IO_STATE_OPEN)
+        {
+            STANDBY_IO_LINK* standby_link = get_standby_link(standby_io_instance);
+
+            standby_io_instance->standby_io_state = STANDBY_IO_STATE_ERROR;
+
+            if (standby_link->state == STANDBY_IO_LINK_STATE_OPEN)
+            {
+                /* Codes_SRS_STANDBY_IO_01_026: [ If the standby link is open, it shall become the link in use by the next open. ]*/
+                standby_io_instance->active_link = STANDBY_IO_LINK_COUNT - 1 - standby_io_instance->active_link;
+            }
+
+            /* Codes_SRS_STANDBY_IO_01_025: [ When the link in use fails while the standby IO is OPEN, the standby IO shall be in ERROR and on_io_error shall be called. ]*/
+            standby_io_instance->on_io_error(standby_io_instance->on_io_error_context);
+        }
+    }
+}
+
+static void on_link_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    STANDBY_IO_LINK* link = (STANDBY_IO_LINK*)context;
+
+    if (link->state != STANDBY_IO_LINK_STATE_OPENING)
+    {
+        /* the open was cancelled by a close */
+    }
+    else if (open_result != IO_OPEN_OK)
+    {
+        LogError("Underlying IO open failed");
+        on_link_failed(link);
+    }
+    else
+    {
+        STANDBY_IO_INSTANCE* standby_io_instance = link->standby_io_instance;
+
+        link->state = STANDBY_IO_LINK_STATE_OPEN;
+        link->open_since_us = get_now_us();
+
+        if (is_active_link(link) &&
+            (standby_io_instance->standby_io_state == STANDBY_IO_STATE_OPENING))
+        {
+            /* Codes_SRS_STANDBY_IO_01_020: [ When the link being opened for the layer above completes its open, the standby IO shall be OPEN and on_io_open_complete shall be called with IO_OPEN_OK. ]*/
+            standby_io_instance->standby_io_state = STANDBY_IO_STATE_OPEN;
+            standby_io_instance->on_io_open_complete(standby_io_instance->on_io_open_complete_context, IO_OPEN_OK);
+        }
+    }
+}
+
+static void on_link_bytes_received(void* context, const unsigned char* buffer, size_t size)
+{
+    STANDBY_IO_LINK* link = (STANDBY_IO_LINK*)context;
+    STANDBY_IO_INSTANCE* standby_io_instance = link->standby_io_instance;
+
+    if (is_active_link(link) &&
+        (standby_io_instance->standby_io_state == STANDBY_IO_STATE_OPEN))
+    {
+        /* Codes_SRS_STANDBY_IO_01_027: [ The bytes received on the link in use while the standby IO is OPEN shall be indicated by calling on_bytes_received. ]*/
+        standby_io_instance->stats.bytes_received += size;
+        standby_io_instance->stats.callback_count++;
+        standby_io_instance->on_bytes_received(standby_io_instance->on_bytes_received_context, buffer, size);
+    }
+    else if (link->state == STANDBY_IO_LINK_STATE_OPEN)
+    {
+        /* Codes_SRS_STANDBY_IO_01_028: [ Bytes received on an idle link shall close it as failed. ]*/
+        LogError("%lu bytes received on an idle standby connection", (unsigned long)size);
+        on_link_failed(link);
+    }
+}
+
+static void on_link_error(void* context)
+{
+    STANDBY_IO_LINK* link = (STANDBY_IO_LINK*)context;
+
+    if ((link->state == STANDBY_IO_LINK_STATE_OPENING) ||
+        (link->state == STANDBY_IO_LINK_STATE_OPEN))
+    {
+        LogError("Underlying IO error");
+        on_link_failed(link);
+    }
+}
+
+static CONCRETE_IO_HANDLE standby_io_create(void* io_create_parameters)
+{
+    STANDBY_IO_INSTANCE* result;
+
+    if (io_create_parameters == NULL)
+    {
+        /* Codes_SRS_STANDBY_IO_01_002: [ If io_create_parameters is NULL, standby_io_create shall fail and return NULL. ]*/
+        LogError("NULL io_create_parameters.");
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_STANDBY_IO_01_003: [ io_create_parameters shall be used as a STANDBY_IO_CONFIG*. ]*/
+        STANDBY_IO_CONFIG* standby_io_config = (STANDBY_IO_CONFIG*)io_create_parameters;
+
+        if ((standby_io_config->underlying_io_interface == NULL) ||
+            (standby_io_config->underlying_io_parameters == NULL))
+        {
+            /* Codes_SRS_STANDBY_IO_01_004: [ If underlying_io_interface or underlying_io_parameters is NULL, standby_io_create shall fail and return NULL. ]*/
+            LogError("Bad arguments: underlying_io_interface = %p, underlying_io_parameters = %p",
+                standby_io_config->underlying_io_interface, standby_io_config->underlying_io_parameters);
+            result = NULL;
+        }
+        /* Codes_SRS_STANDBY_IO_01_001: [ standby_io_create shall create a new instance of the standby IO. ]*/
+        else if ((result = (STANDBY_IO_INSTANCE*)malloc(sizeof(STANDBY_IO_INSTANCE))) == NULL)
+        {
+            /* Codes_SRS_STANDBY_IO_01_006: [ If any failure occurs, standby_io_create shall free what it created and return NULL. ]*/
+            LogError("Failed allocating standby IO instance.");
+        }
+        else
+        {
+            /* Codes_SRS_STANDBY_IO_01_005: [ standby_io_create shall create the two underlying IOs by calling xio_create with underlying_io_interface, the first one with underlying_io_parameters and the second one with standby_io_parameters, or underlying_io_parameters if standby_io_parameters is NULL. ]*/
+            result->links[0].underlying_io = xio_create(standby_io_config->underlying_io_interface, standby_io_config->underlying_io_parameters);
+            if (result->links[0].underlying_io == NULL)
+            {
+                /* Codes_SRS_STANDBY_IO_01_006: [ If any failure occurs, standby_io_create shall free what it created and return NULL. ]*/
+                LogError("Unable to create the underlying IO.");
+                free(result);
+                result = NULL;
+            }
+            else
+            {
+                result->links[1].underlying_io = xio_create(standby_io_config->underlying_io_interface,
+                    (standby_io_config->standby_io_parameters != NULL) ? standby_io_config->standby_io_parameters : standby_io_config->underlying_io_parameters);
+                if (result->links[1].underlying_io == NULL)
+                {
+                    /* Codes_SRS_STANDBY_IO_01_006: [ If any failure occurs, standby_io_create shall free what it created and return NULL. ]*/
+                    LogError("Unable to create the standby underlying IO.");
+                    xio_destroy(result->links[0].underlying_io);
+                    free(result);
+                    result = NULL;
+                }
+                else
+                {
+                    size_t i;
+
+                    for (i = 0; i < STANDBY_IO_LINK_COUNT; i++)
+                    {
+                        result->links[i].state = STANDBY_IO_LINK_STATE_CLOSED;
+                        result->links[i].open_since_us = 0;
+                        result->links[i].retry_after_us = 0;
+                        result->links[i].standby_io_instance = result;
+                    }
+
+                    result->standby_io_state = STANDBY_IO_STATE_CLOSED;
+                    result->active_link = 0;
+                    result->keep_standby = false;
+                    result->refresh_interval_us = (tickcounter_us_t)standby_io_config->refresh_interval_ms * 1000;
+                    result->retry_interval_us = (tickcounter_us_t)standby_io_config->retry_interval_ms * 1000;
+                    result->on_io_close_complete = NULL;
+                    result->on_io_close_complete_context = NULL;
+                    (void)memset(&result->stats, 0, sizeof(result->stats));
+                    result->stats.layer_name = "standby_io";
+                }
+            }
+        }
+    }
+
+    return result;
+}
+
+static void standby_io_destroy(CONCRETE_IO_HANDLE standby_io)
+{
+    if (standby_io == NULL)
+    {
+        /* Codes_SRS_STANDBY_IO_01_008: [ If standby_io is NULL, standby_io_destroy shall do nothing. ]*/
+        LogError("NULL standby_io.");
+    }
+    else
+    {
+        STANDBY_IO_INSTANCE* standby_io_instance = (STANDBY_IO_INSTANCE*)standby_io;
+        size_t i;
+
+        standby_io_instance->keep_standby = false;
+
+        /* Codes_SRS_STANDBY_IO_01_007: [ standby_io_destroy shall close the underlying IOs that are not closed by calling xio_close, destroy them by calling xio_destroy and free the instance. ]*/
+        for (i = 0; i < STANDBY_IO_LINK_COUNT; i++)
+        {
+            if (standby_io_instance->links[i].state != STANDBY_IO_LINK_STATE_CLOSED)
+            {
+                standby_io_instance->links[i].state = STANDBY_IO_LINK_STATE_CLOSING;
+                (void)xio_close(standby_io_instance->links[i].underlying_io, NULL, NULL);
+            }
+        }
+
+        for (i = 0; i < STANDBY_IO_LINK_COUNT; i++)
+        {
+            xio_destroy(standby_io_instance->links[i].underlying_io);
+        }
+
+        free(standby_io_instance);
+    }
+}
+
+static int standby_io_open(CONCRETE_IO_HANDLE standby_io, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    int result;
+
+    if ((standby_io == NULL) ||
+        (on_io_open_complete == NULL) ||
+        (on_bytes_received == NULL) ||
+        (on_io_error == NULL))
+    {
+        /* Codes_SRS_STANDBY_IO_01_010: [ If any of the arguments standby_io, on_io_open_complete, on_bytes_received or on_io_error are NULL then standby_io_open shall return a non-zero value. ]*/
+        LogError("Bad arguments: standby_io = %p, on_io_open_complete = %p, on_bytes_received = %p, on_io_error = %p.",
+            standby_io, on_io_open_complete, on_bytes_received, on_io_error);
+        result = __LINE__;
+    }
+    else
+    {
+        STANDBY_IO_INSTANCE* standby_io_instance = (STANDBY_IO_INSTANCE*)standby_io;
+
+        if (standby_io_instance->standby_io_state != STANDBY_IO_STATE_CLOSED)
+        {
+            /* Codes_SRS_STANDBY_IO_01_011: [ If the standby IO is not CLOSED, standby_io_open shall fail and return a non-zero value. ]*/
+            LogError("Invalid standby IO state. Expected state is STANDBY_IO_STATE_CLOSED.");
+            result = __LINE__;
+        }
+        else
+        {
+            STANDBY_IO_LINK* active_link;
+
+            standby_io_instance->on_bytes_received = on_bytes_received;
+            standby_io_instance->on_bytes_received_context = on_bytes_received_context;
+            standby_io_instance->on_io_error = on_io_error;
+            standby_io_instance->on_io_error_context = on_io_error_context;
+            standby_io_instance->on_io_open_complete = on_io_open_complete;
+            standby_io_instance->on_io_open_complete_context = on_io_open_complete_context;
+
+            /* Codes_SRS_STANDBY_IO_01_012: [ standby_io_open shall use the first link that is open, else the first one being opened, else the first one closed, trying the link used last first. ]*/
+            standby_io_instance->active_link = pick_link(standby_io_instance);
+            active_link = &standby_io_instance->links[standby_io_instance->active_link];
+
+            if (active_link->state == STANDBY_IO_LINK_STATE_OPEN)
+            {
+                /* Codes_SRS_STANDBY_IO_01_013: [ If the link used is open, the standby IO shall be OPEN and on_io_open_complete shall be called with IO_OPEN_OK before standby_io_open returns. ]*/
+                standby_io_instance->standby_io_state = STANDBY_IO_STATE_OPEN;
+                standby_io_instance->on_io_open_complete(standby_io_instance->on_io_open_complete_context, IO_OPEN_OK);
+                result = 0;
+            }
+            else if (active_link->state == STANDBY_IO_LINK_STATE_OPENING)
+            {
+                /* Codes_SRS_STANDBY_IO_01_014: [ If the link used is being opened, the standby IO shall complete its open with the one of the link. ]*/
+                standby_io_instance->standby_io_state = STANDBY_IO_STATE_OPENING;
+                result = 0;
+            }
+            else if (active_link->state == STANDBY_IO_LINK_STATE_CLOSING)
+            {
+                /* Codes_SRS_STANDBY_IO_01_015: [ If both links are still closing, standby_io_open shall fail and return a non-zero value. ]*/
+                LogError("Both underlying IOs are closing.");
+                result = __LINE__;
+            }
+            else
+            {
+                standby_io_instance->standby_io_state = STANDBY_IO_STATE_OPENING;
+
+                /* Codes_SRS_STANDBY_IO_01_016: [ If the link used is closed, standby_io_open shall open it by calling xio_open. ]*/
+                if (open_link(active_link) != 0)
+                {
+                    /* Codes_SRS_STANDBY_IO_01_017: [ If xio_open fails, standby_io_open shall fail and return a non-zero value. ]*/
+                    standby_io_instance->standby_io_state = STANDBY_IO_STATE_CLOSED;
+                    LogError("Cannot open the underlying IO.");
+                    result = __LINE__;
+                }
+                else
+                {
+                    result = 0;
+                }
+            }
+
+            if (result == 0)
+            {
+                /* Codes_SRS_STANDBY_IO_01_018: [ On success standby_io_open shall also open the other link in the background if it is closed, by calling xio_open. ]*/
+                standby_io_instance->keep_standby = true;
+                maintain_standby_link(standby_io_instance);
+
+                /* Codes_SRS_STANDBY_IO_01_019: [ On success standby_io_open shall return 0. ]*/
+            }
+        }
+    }
+
+    return result;
+}
+
+static int standby_io_close(CONCRETE_IO_HANDLE standby_io, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* on_io_close_complete_context)
+{
+    int result;
+
+    if (standby_io == NULL)
+    {
+        /* Codes_SRS_STANDBY_IO_01_033: [ If standby_io is NULL, standby_io_close shall fail and return a non-zero value. ]*/
+        LogError("NULL standby_io.");
+        result = __LINE__;
+    }
+    else
+    {
+        STANDBY_IO_INSTANCE* standby_io_instance = (STANDBY_IO_INSTANCE*)standby_io;
+        STANDBY_IO_LINK* active_link = &standby_io_instance->links[standby_io_instance->active_link];
+
+        if ((standby_io_instance->standby_io_state == STANDBY_IO_STATE_CLOSED) ||
+            (standby_io_instance->standby_io_state == STANDBY_IO_STATE_CLOSING))
+        {
+            /* Codes_SRS_STANDBY_IO_01_034: [ If the standby IO is CLOSED or CLOSING, standby_io_close shall fail and return a non-zero value. ]*/
+            LogError("Invalid standby IO state. Expected state is STANDBY_IO_STATE_OPEN.");
+            result = __LINE__;
+        }
+        else if (standby_io_instance->standby_io_state == STANDBY_IO_STATE_OPENING)
+        {
+            /* Codes_SRS_STANDBY_IO_01_035: [ standby_io_close while OPENING shall close the link being opened and call on_io_open_complete with IO_OPEN_CANCELLED. ]*/
+            standby_io_instance->standby_io_state = STANDBY_IO_STATE_CLOSED;
+            close_link(active_link, false);
+            standby_io_instance->on_io_open_complete(standby_io_instance->on_io_open_complete_context, IO_OPEN_CANCELLED);
+            result = 0;
+        }
+        else if (standby_io_instance->standby_io_state == STANDBY_IO_STATE_ERROR)
+        {
+            /* Codes_SRS_STANDBY_IO_01_036: [ standby_io_close in ERROR shall leave the links as they are, the standby IO shall be CLOSED and on_io_close_complete shall be called before standby_io_close returns, if it is not NULL. ]*/
+            standby_io_instance->standby_io_state = STANDBY_IO_STATE_CLOSED;
+            if (on_io_close_complete != NULL)
+            {
+                on_io_close_complete(on_io_close_complete_context);
+            }
+            result = 0;
+        }
+        else
+        {
+            standby_io_instance->standby_io_state = STANDBY_IO_STATE_CLOSING;
+            standby_io_instance->on_io_close_complete = on_io_close_complete;
+            standby_io_instance->on_io_close_complete_context = on_io_close_complete_context;
+            active_link->state = STANDBY_IO_LINK_STATE_CLOSING;
+            active_link->retry_after_us = 0;
+
+            /* Codes_SRS_STANDBY_IO_01_030: [ standby_io_close while OPEN shall close the link in use by calling xio_close. The standby link stays open. ]*/
+            if (xio_close(active_link->underlying_io, on_link_close_complete, active_link) != 0)
+            {
+                /* Codes_SRS_STANDBY_IO_01_032: [ If xio_close fails, standby_io_close shall fail and return a non-zero value. ]*/
+                LogError("Cannot close the underlying IO.");
+                active_link->state = STANDBY_IO_LINK_STATE_OPEN;
+                standby_io_instance->standby_io_state = STANDBY_IO_STATE_OPEN;
+                result = __LINE__;
+            }
+            else
+            {
+                /* Codes_SRS_STANDBY_IO_01_037: [ On success standby_io_close shall return 0. ]*/
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static int standby_io_send(CONCRETE_IO_HANDLE standby_io, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* on_send_complete_context)
+{
+    int result;
+
+    if ((standby_io == NULL) ||
+        (buffer == NULL) ||
+        (size == 0))
+    {
+        /* Codes_SRS_STANDBY_IO_01_042: [ If standby_io or buffer is NULL or size is 0, standby_io_send shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: standby_io = %p, buffer = %p, size = %lu.",
+            standby_io, buffer, (unsigned long)size);
+        result = __LINE__;
+    }
+    else
+    {
+        STANDBY_IO_INSTANCE* standby_io_instance = (STANDBY_IO_INSTANCE*)standby_io;
+
+        if (standby_io_instance->standby_io_state != STANDBY_IO_STATE_OPEN)
+        {
+            /* Codes_SRS_STANDBY_IO_01_043: [ If the standby IO is not OPEN, standby_io_send shall fail and return a non-zero value. ]*/
+            LogError("Invalid standby IO state. Expected state is STANDBY_IO_STATE_OPEN.");
+            result = __LINE__;
+        }
+        /* Codes_SRS_STANDBY_IO_01_044: [ standby_io_send shall send the bytes by calling xio_send on the link in use. ]*/
+        else if (xio_send(standby_io_instance->links[standby_io_instance->active_link].underlying_io, buffer, size, on_send_complete, on_send_complete_context) != 0)
+        {
+            /* Codes_SRS_STANDBY_IO_01_045: [ If xio_send fails, standby_io_send shall fail and return a non-zero value. ]*/
+            LogError("Underlying xio_send failed.");
+            result = __LINE__;
+        }
+        else
+        {
+            /* Codes_SRS_STANDBY_IO_01_046: [ On success standby_io_send shall return 0. ]*/
+            standby_io_instance->stats.bytes_sent += size;
+            standby_io_instance->stats.send_count++;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int standby_io_sendv(CONCRETE_IO_HANDLE standby_io, const XIO_BUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* on_send_complete_context)
+{
+    int result;
+
+    if ((standby_io == NULL) ||
+        (buffers == NULL) ||
+        (buffer_count == 0))
+    {
+        LogError("Bad arguments: standby_io = %p, buffers = %p, buffer_count = %lu.",
+            standby_io, buffers, (unsigned long)buffer_count);
+        result = __LINE__;
+    }
+    else
+    {
+        STANDBY_IO_INSTANCE* standby_io_instance = (STANDBY_IO_INSTANCE*)standby_io;
+
+        if (standby_io_instance->standby_io_state != STANDBY_IO_STATE_OPEN)
+        {
+            LogError("Invalid standby IO state. Expected state is STANDBY_IO_STATE_OPEN.");
+            result = __LINE__;
+        }
+        /* Codes_SRS_STANDBY_IO_01_047: [ standby_io_sendv and standby_io_send_constbuffer_array shall hand the buffers to xio_sendv and xio_send_constbuffer_array of the link in use. ]*/
+        else if (xio_sendv(standby_io_instance->links[standby_io_instance->active_link].underlying_io, buffers, buffer_count, on_send_complete, on_send_complete_context) != 0)
+        {
+            LogError("Underlying xio_sendv failed.");
+            result = __LINE__;
+        }
+        else
+        {
+            size_t i;
+
+            for (i = 0; i < buffer_count; i++)
+            {
+                standby_io_instance->stats.bytes_sent += buffers[i].size;
+            }
+
+            standby_io_instance->stats.send_count++;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int standby_io_send_constbuffer_array(CONCRETE_IO_HANDLE standby_io, CONSTBUFFER_ARRAY_HANDLE constbuffer_array, ON_SEND_COMPLETE on_send_complete, void* on_send_complete_context)
+{
+    int result;
+
+    if ((standby_io == NULL) ||
+        (constbuffer_array == NULL))
+    {
+        LogError("Bad arguments: standby_io = %p, constbuffer_array = %p.",
+            standby_io, constbuffer_array);
+        result = __LINE__;
+    }
+    else
+    {
+        STANDBY_IO_INSTANCE* standby_io_instance = (STANDBY_IO_INSTANCE*)standby_io;
+
+        if (standby_io_instance->standby_io_state != STANDBY_IO_STATE_OPEN)
+        {
+            LogError("Invalid standby IO state. Expected state is STANDBY_IO_STATE_OPEN.");
+            result = __LINE__;
+        }
+        /* Codes_SRS_STANDBY_IO_01_047: [ standby_io_sendv and standby_io_send_constbuffer_array shall hand the buffers to xio_sendv and xio_send_constbuffer_array of the link in use. ]*/
+        else if (xio_send_constbuffer_array(standby_io_instance->links[standby_io_instance->active_link].underlying_io, constbuffer_array, on_send_complete, on_send_complete_context) != 0)
+        {
+            LogError("Underlying xio_send_constbuffer_array failed.");
+            result = __LINE__;
+        }
+        else
+        {
+            uint32_t total_size;
+
+            if (constbuffer_array_get_all_buffers_size(constbuffer_array, &total_size) != 0)
+            {
+                total_size = 0;
+            }
+
+            standby_io_instance->stats.bytes_sent += total_size;
+            standby_io_instance->stats.send_count++;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static void standby_io_dowork(CONCRETE_IO_HANDLE standby_io)
+{
+    if (standby_io == NULL)
+    {
+        /* Codes_SRS_STANDBY_IO_01_039: [ If standby_io is NULL, standby_io_dowork shall do nothing. ]*/
+        LogError("NULL standby_io.");
+    }
+    else
+    {
+        STANDBY_IO_INSTANCE* standby_io_instance = (STANDBY_IO_INSTANCE*)standby_io;
+        uint64_t callback_count = standby_io_instance->stats.callback_count;
+        size_t i;
+
+        standby_io_instance->stats.dowork_count++;
+
+        /* Codes_SRS_STANDBY_IO_01_038: [ standby_io_dowork shall call xio_dowork on each link that is not closed. ]*/
+        for (i = 0; i < STANDBY_IO_LINK_COUNT; i++)
+        {
+            if (standby_io_instance->links[i].state != STANDBY_IO_LINK_STATE_CLOSED)
+            {
+                xio_dowork(standby_io_instance->links[i].underlying_io);
+            }
+        }
+
+        maintain_standby_link(standby_io_instance);
+
+        if (standby_io_instance->stats.callback_count == callback_count)
+        {
+            standby_io_instance->stats.idle_dowork_count++;
+        }
+    }
+}
+
+static int standby_io_dowork_ex(CONCRETE_IO_HANDLE standby_io, bool* made_progress, uint64_t* next_deadline_us)
+{
+    int result;
+
+    if ((standby_io == NULL) ||
+        (made_progress == NULL) ||
+        (next_deadline_us == NULL))
+    {
+        /* Codes_SRS_STANDBY_IO_01_048: [ If standby_io, made_progress or next_deadline_us is NULL, standby_io_dowork_ex shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: standby_io = %p, made_progress = %p, next_deadline_us = %p",
+            standby_io, made_progress, next_deadline_us);
+        result = __FAILURE__;
+    }
+    else
+    {
+        STANDBY_IO_INSTANCE* standby_io_instance = (STANDBY_IO_INSTANCE*)standby_io;
+        uint64_t callback_count = standby_io_instance->stats.callback_count;
+        bool progress = false;
+        STANDBY_IO_LINK* standby_link;
+        size_t i;
+
+        standby_io_instance->stats.dowork_count++;
+        *next_deadline_us = XIO_NO_DEADLINE;
+
+        /* Codes_SRS_STANDBY_IO_01_049: [ standby_io_dowork_ex shall call xio_dowork_ex on each link that is not closed and give the earliest of their deadlines. ]*/
+        for (i = 0; i < STANDBY_IO_LINK_COUNT; i++)
+        {
+            if (standby_io_instance->links[i].state != STANDBY_IO_LINK_STATE_CLOSED)
+            {
+                bool link_progress;
+                uint64_t link_deadline_us;
+
+                if (xio_dowork_ex(standby_io_instance->links[i].underlying_io, &link_progress, &link_deadline_us) != 0)
+                {
+                    LogError("xio_dowork_ex failed");
+                    link_progress = true;
+                    link_deadline_us = XIO_NO_DEADLINE;
+                }
+
+                progress = progress || link_progress;
+                if (link_deadline_us < *next_deadline_us)
+                {
+                    *next_deadline_us = link_deadline_us;
+                }
+            }
+        }
+
+        maintain_standby_link(standby_io_instance);
+
+        /* Codes_SRS_STANDBY_IO_01_050: [ While the standby link is kept, the deadline shall also cover its reopening, its refresh, and a work interval while it is being opened or closed. ]*/
+        standby_link = get_standby_link(standby_io_instance);
+        if (standby_io_instance->keep_standby)
+        {
+            uint64_t standby_deadline_us = XIO_NO_DEADLINE;
+
+            switch (standby_link->state)
+            {
+            case STANDBY_IO_LINK_STATE_CLOSED:
+                standby_deadline_us = standby_link->retry_after_us;
+                break;
+            case STANDBY_IO_LINK_STATE_OPEN:
+                if (standby_io_instance->refresh_interval_us > 0)
+                {
+                    standby_deadline_us = standby_link->open_since_us + standby_io_instance->refresh_interval_us;
+                }
+                break;
+            default:
+                standby_deadline_us = get_now_us() + STANDBY_IO_OPENING_WORK_INTERVAL_US;
+                break;
+            }
+
+            if (standby_deadline_us < *next_deadline_us)
+            {
+                *next_deadline_us = standby_deadline_us;
+            }
+        }
+
+        if (standby_io_instance->stats.callback_count == callback_count)
+        {
+            standby_io_instance->stats.idle_dowork_count++;
+        }
+
+        /* Codes_SRS_STANDBY_IO_01_051: [ made_progress shall be set to true if a callback was made or a link made progress, false otherwise. ]*/
+        *made_progress = progress || (standby_io_instance->stats.callback_count != callback_count);
+
+        /* Codes_SRS_STANDBY_IO_01_052: [ On success standby_io_dowork_ex shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+static int standby_io_get_pollable_handle(CONCRETE_IO_HANDLE standby_io, intptr_t* pollable_handle, unsigned int* wanted_events)
+{
+    int result;
+
+    if ((standby_io == NULL) ||
+        (pollable_handle == NULL) ||
+        (wanted_events == NULL))
+    {
+        LogError("Bad arguments: standby_io = %p, pollable_handle = %p, wanted_events = %p",
+            standby_io, pollable_handle, wanted_events);
+        result = __FAILURE__;
+    }
+    else
+    {
+        STANDBY_IO_INSTANCE* standby_io_instance = (STANDBY_IO_INSTANCE*)standby_io;
+
+        /* Codes_SRS_STANDBY_IO_01_053: [ standby_io_get_pollable_handle shall call xio_get_pollable_handle on the link in use. ]*/
+        if (xio_get_pollable_handle(standby_io_instance->links[standby_io_instance->active_link].underlying_io, pollable_handle, wanted_events) != 0)
+        {
+            LogError("xio_get_pollable_handle failed");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int standby_io_get_stats(CONCRETE_IO_HANDLE standby_io, XIO_STATS* stats, size_t stats_count, size_t* layer_count)
+{
+    int result;
+
+    if ((standby_io == NULL) ||
+        (stats == NULL) ||
+        (stats_count == 0) ||
+        (layer_count == NULL))
+    {
+        LogError("Bad arguments: standby_io = %p, stats = %p, stats_count = %lu, layer_count = %p.",
+            standby_io, stats, (unsigned long)stats_count, layer_count);
+        result = __LINE__;
+    }
+    else
+    {
+        STANDBY_IO_INSTANCE* standby_io_instance = (STANDBY_IO_INSTANCE*)standby_io;
+        size_t underlying_layer_count;
+
+        /* Codes_SRS_STANDBY_IO_01_054: [ standby_io_get_stats shall fill the first entry of stats with the counters of the standby IO and the following ones by calling xio_get_stats on the link in use. ]*/
+        stats[0] = standby_io_instance->stats;
+
+        if ((stats_count > 1) &&
+            (xio_get_stats(standby_io_instance->links[standby_io_instance->active_link].underlying_io, &stats[1], stats_count - 1, &underlying_layer_count) == 0))
+        {
+            *layer_count = 1 + underlying_layer_count;
+        }
+        else
+        {
+            *layer_count = 1;
+        }
+
+        result = 0;
+    }
+
+    return result;
+}
+
+static int standby_io_set_option(CONCRETE_IO_HANDLE standby_io, const char* option_name, const void* value)
+{
+    int result;
+
+    if ((standby_io == NULL) || (option_name == NULL))
+    {
+        /* Codes_SRS_STANDBY_IO_01_056: [ If standby_io or option_name is NULL, standby_io_set_option shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: standby_io = %p, option_name = %p",
+            standby_io, option_name);
+        result = __LINE__;
+    }
+    else
+    {
+        STANDBY_IO_INSTANCE* standby_io_instance = (STANDBY_IO_INSTANCE*)standby_io;
+        size_t i;
+
+        result = 0;
+
+        /* Codes_SRS_STANDBY_IO_01_055: [ standby_io_set_option shall set the option on both links by calling xio_setoption. ]*/
+        for (i = 0; i < STANDBY_IO_LINK_COUNT; i++)
+        {
+            if (xio_setoption(standby_io_instance->links[i].underlying_io, option_name, value) != 0)
+            {
+                /* Codes_SRS_STANDBY_IO_01_057: [ If xio_setoption fails for either link, standby_io_set_option shall return a non-zero value. ]*/
+                LogError("Setting option %s on the underlying IO failed", option_name);
+                result = __LINE__;
+            }
+        }
+    }
+
+    return result;
+}
+
+static OPTIONHANDLER_HANDLE standby_io_retrieve_options(CONCRETE_IO_HANDLE standby_io)
+{
+    OPTIONHANDLER_HANDLE result;
+
+    if (standby_io == NULL)
+    {
+        LogError("invalid parameter detected: CONCRETE_IO_HANDLE handle=%p", standby_io);
+        result = NULL;
+    }
+    else
+    {
+        STANDBY_IO_INSTANCE* standby_io_instance = (STANDBY_IO_INSTANCE*)standby_io;
+
+        /* Codes_SRS_STANDBY_IO_01_058: [ standby_io_retrieve_options shall return the result of xio_retrieveoptions on the link in use. ]*/
+        result = xio_retrieveoptions(standby_io_instance->links[standby_io_instance->active_link].underlying_io);
+        if (result == NULL)
+        {
+            LogError("unable to create option handler");
+        }
+    }
+
+    return result;
+}
+
+static const IO_INTERFACE_DESCRIPTION standby_io_interface_description =
+{
+    standby_io_retrieve_options,
+    standby_io_create,
+    standby_io_destroy,
+    standby_io_open,
+    standby_io_close,
+    standby_io_send,
+    standby_io_dowork,
+    standby_io_set_option,
+    standby_io_sendv,
+    standby_io_send_constbuffer_array,
+    standby_io_get_stats,
+    standby_io_dowork_ex,
+    standby_io_get_pollable_handle,
+    NULL
+};
+
+const IO_INTERFACE_DESCRIPTION* standby_io_get_interface_description(void)
+{
+    /* Codes_SRS_STANDBY_IO_01_059: [ standby_io_get_interface_description shall return a pointer to an IO_INTERFACE_DESCRIPTION structure that contains pointers to the functions of the standby IO. ]*/
+    return &standby_io_interface_description;
+}
@@ -0,0 +1,244 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#endif
+
+#include "azure_c_shared_utility/strhash.h"
+#include "azure_c_shared_utility/gb_rand.h"
+
+/*
+* The hash is wyhash (final version 4, public domain): keys of up to 16 bytes are read as two
+* 64 bit words from overlapping 4 byte reads, longer ones 16 bytes (48 bytes in 3 lanes when
+* there are more than 48) at a time, and every step mixes two words by multiplying them to 128
+* bits and folding the halves together.
+*
+* The case-insensitive hash lowers the ASCII letters of each word it reads, 8 bytes at a time, so
+* it costs a few more instructions per word and no branch per byte.
+*
+* The process seed is published once with a compare-and-swap, so that all the threads hash with
+* the same seed, and each thread keeps a copy of it mixed with the constants as wyhash does at the
+* start of each hash.
+*/
+#if defined(_MSC_VER)
+#include <windows.h>
+#if defined(_M_X64)
+#include <intrin.h>
+#pragma intrinsic(_umul128)
+#elif defined(_M_ARM64)
+#include <intrin.h>
+#pragma intrinsic(__umulh)
+#endif
+#define STRHASH_THREAD_LOCAL __declspec(thread)
+#define STRHASH_CAS(value, exchange, comparand) ((uint64_t)InterlockedCompareExchange64((volatile LONG64*)&(value), (LONG64)(exchange), (LONG64)(comparand)))
+#else
+#define STRHASH_THREAD_LOCAL __thread
+#define STRHASH_CAS(value, exchange, comparand) __sync_val_compare_and_swap(&(value), (comparand), (exchange))
+#endif
+
+static const uint64_t strhash_secret[4] =
+{
+    0xa0761d6478bd642full, 0xe7037ed1a0b428dbull, 0x8ebc6af09c88c6e3ull, 0x589965cc75374cc3ull
+};
+
+static volatile uint64_t process_seed = 0;
+static STRHASH_THREAD_LOCAL uint64_t thread_seed = 0;
+static STRHASH_THREAD_LOCAL uint64_t thread_mixed_seed = 0;
+
+static void multiply(uint64_t* a, uint64_t* b)
+{
+#if defined(__SIZEOF_INT128__)
+    __uint128_t result = (__uint128_t)*a * *b;
+    *a = (uint64_t)result;
+    *b = (uint64_t)(result >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    *a = _umul128(*a, *b, b);
+#elif defined(_MSC_VER) && defined(_M_ARM64)
+    uint64_t high = __umulh(*a, *b);
+    *a = *a * *b;
+    *b = high;
+#else
+    uint64_t high_a = *a >> 32;
+    uint64_t high_b = *b >> 32;
+    uint64_t low_a = (uint32_t)*a;
+    uint64_t low_b = (uint32_t)*b;
+    uint64_t high = high_a * high_b;
+    uint64_t middle_0 = high_a * low_b;
+    uint64_t middle_1 = high_b * low_a;
+    uint64_t low = low_a * low_b;
+    uint64_t t = low + (middle_0 << 32);
+    uint64_t carry = (t < low) ? 1 : 0;
+    uint64_t result_low = t + (middle_1 << 32);
+    carry += (result_low < t) ? 1 : 0;
+    *a = result_low;
+    *b = high + (middle_0 >> 32) + (middle_1 >> 32) + carry;
+#endif
+}
+
+static uint64_t mix(uint64_t a, uint64_t b)
+{
+    multiply(&a, &b);
+    return a ^ b;
+}
+
+/* sets bit 5 of the bytes that are 'A' to 'Z' */
+static uint64_t to_lower_word(uint64_t word)
+{
+    uint64_t heptets = word & 0x7f7f7f7f7f7f7f7full;
+    uint64_t above_z = heptets + 0x2525252525252525ull;
+    uint64_t from_a = heptets + 0x3f3f3f3f3f3f3f3full;
+    uint64_t is_upper = (from_a ^ above_z) & ~word & 0x8080808080808080ull;
+    return word | (is_upper >> 2);
+}
+
+static uint64_t read_64(const unsigned char* p, int nocase)
+{
+    uint64_t result;
+    (void)memcpy(&result, p, sizeof(result));
+    return nocase ? to_lower_word(result) : result;
+}
+
+static uint64_t read_32(const unsigned char* p, int nocase)
+{
+    uint32_t result;
+    (void)memcpy(&result, p, sizeof(result));
+    return nocase ? to_lower_word(result) : result;
+}
+
+/* 1 to 3 bytes: the first, the middle and the last, which may be the same bytes */
+static uint64_t read_short(const unsigned char* p, size_t length, int nocase)
+{
+    uint64_t result = ((uint64_t)p[0] << 16) | ((uint64_t)p[length >> 1] << 8) | p[length - 1];
+    return nocase ? to_lower_word(result) : result;
+}
+
+static uint64_t mix_seed(uint64_t seed)
+{
+    return seed ^ mix(seed ^ strhash_secret[0], strhash_secret[1]);
+}
+
+static uint64_t hash_with_mixed_seed(const void* data, size_t length, uint64_t seed, int nocase)
+{
+    const unsigned char* p = (const unsigned char*)data;
+    uint64_t a;
+    uint64_t b;
+
+    if (length <= 16)
+    {
+        if (length >= 4)
+        {
+            size_t middle = (length >> 3) << 2;
+            a = (read_32(p, nocase) << 32) | read_32(p + middle, nocase);
+            b = (read_32(p + length - 4, nocase) << 32) | read_32(p + length - 4 - middle, nocase);
+        }
+        else if (length > 0)
+        {
+            a = read_short(p, length, nocase);
+            b = 0;
+        }
+        else
+        {
+            a = 0;
+            b = 0;
+        }
+    }
+    else
+    {
+        size_t remaining = length;
+        if (remaining > 48)
+        {
+            uint64_t seed_1 = seed;
+            uint64_t seed_2 = seed;
+            do
+            {
+                seed = mix(read_64(p, nocase) ^ strhash_secret[1], read_64(p + 8, nocase) ^ seed);
+                seed_1 = mix(read_64(p + 16, nocase) ^ strhash_secret[2], read_64(p + 24, nocase) ^ seed_1);
+                seed_2 = mix(read_64(p + 32, nocase) ^ strhash_secret[3], read_64(p + 40, nocase) ^ seed_2);
+                p += 48;
+                remaining -= 48;
+            } while (remaining > 48);
+            seed ^= seed_1 ^ seed_2;
+        }
+
+        while (remaining > 16)
+        {
+            seed = mix(read_64(p, nocase) ^ strhash_secret[1], read_64(p + 8, nocase) ^ seed);
+            p += 16;
+            remaining -= 16;
+        }
+
+        /* the last 16 bytes, which overlap the bytes already mixed when there are less */
+        a = read_64(p + remaining - 16, nocase);
+        b = read_64(p + remaining - 8, nocase);
+    }
+
+    a ^= strhash_secret[1];
+    b ^= seed;
+    multiply(&a, &b);
+    return mix(a ^ strhash_secret[0] ^ (uint64_t)length, b ^ strhash_secret[1]);
+}
+
+uint64_t strhash_get_process_seed(void)
+{
+    uint64_t result = thread_seed;
+
+    if (result == 0)
+    {
+        /* Codes_SRS_STRHASH_01_001: [ The first time the seed is needed `strhash_get_process_seed` shall draw it with `gb_rand_uint64`, with its lowest bit set so that it is never 0. ]*/
+        uint64_t candidate = gb_rand_uint64() | 1;
+
+        /* Codes_SRS_STRHASH_01_002: [ When another thread published a seed first, `strhash_get_process_seed` shall return that seed, so that all the threads hash with the same seed. ]*/
+        uint64_t published = STRHASH_CAS(process_seed, candidate, 0);
+        result = (published == 0) ? candidate : published;
+
+        thread_mixed_seed = mix_seed(result);
+        thread_seed = result;
+    }
+
+    return result;
+}
+
+uint64_t strhash_bytes(const void* data, size_t length)
+{
+    /* Codes_SRS_STRHASH_01_003: [ `strhash_bytes` shall return the hash of the `length` bytes at `data` with the seed of the process. ]*/
+    (void)strhash_get_process_seed();
+    return hash_with_mixed_seed(data, length, thread_mixed_seed, 0);
+}
+
+uint64_t strhash_bytes_nocase(const void* data, size_t length)
+{
+    /* Codes_SRS_STRHASH_01_004: [ `strhash_bytes_nocase` shall return the hash of the `length` bytes at `data` with the ASCII letters lowered, with the seed of the process. ]*/
+    (void)strhash_get_process_seed();
+    return hash_with_mixed_seed(data, length, thread_mixed_seed, 1);
+}
+
+uint64_t strhash_string(const char* value)
+{
+    /* Codes_SRS_STRHASH_01_005: [ `strhash_string` shall return the hash of the characters of `value` before its `'\0'`, and the hash of no bytes when `value` is `NULL`. ]*/
+    return strhash_bytes(value, (value == NULL) ? 0 : strlen(value));
+}
+
+uint64_t strhash_string_nocase(const char* value)
+{
+    /* Codes_SRS_STRHASH_01_006: [ `strhash_string_nocase` shall return the case-insensitive hash of the characters of `value` before its `'\0'`, and the hash of no bytes when `value` is `NULL`. ]*/
+    return strhash_bytes_nocase(value, (value == NULL) ? 0 : strlen(value));
+}
+
+uint64_t strhash_bytes_with_seed(const void* data, size_t length, uint64_t seed)
+{
+    /* Codes_SRS_STRHASH_01_007: [ `strhash_bytes_with_seed` shall return the hash of the `length` bytes at `data` with `seed`. ]*/
+    return hash_with_mixed_seed(data, length, mix_seed(seed), 0);
+}
+
+uint64_t strhash_bytes_nocase_with_seed(const void* data, size_t length, uint64_t seed)
+{
+    /* Codes_SRS_STRHASH_01_008: [ `strhash_bytes_nocase_with_seed` shall return the hash of the `length` bytes at `data` with the ASCII letters lowered, with `seed`. ]*/
+    return hash_with_mixed_seed(data, length, mix_seed(seed), 1);
+}
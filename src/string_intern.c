@@ -0,0 +1,359 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/string_intern.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+/*
+* The pool is a hash table with chains, doubled when it holds more strings than buckets.
+* Each string is allocated in one block behind its entry, so that the entry is found from
+* the string pointer alone. Reference counts of pooled strings only change under pool_lock:
+* strings are interned when a connection is created and released when it is destroyed, far
+* from any data path, and the lock keeps a lookup from reviving a string being freed.
+*
+* A string that is not pooled (interned before string_intern_init, or left referenced at
+* string_intern_deinit) is not shared between threads by this module: cloning it copies it.
+*/
+typedef struct STRING_INTERN_ENTRY_TAG
+{
+    struct STRING_INTERN_ENTRY_TAG* next;
+    uint32_t hash;
+    uint32_t ref_count;
+    bool is_pooled;
+    char value[1];
+} STRING_INTERN_ENTRY;
+
+static LOCK_HANDLE pool_lock = NULL;
+static STRING_INTERN_ENTRY** pool_buckets = NULL;
+static size_t pool_bucket_count = 0;
+static size_t pool_entry_count = 0;
+
+static STRING_INTERN_ENTRY* get_entry(const char* interned)
+{
+    return (STRING_INTERN_ENTRY*)(void*)(interned - offsetof(STRING_INTERN_ENTRY, value));
+}
+
+/* FNV-1a */
+static uint32_t hash_string(const char* value, size_t* length)
+{
+    uint32_t hash = 2166136261U;
+    const unsigned char* current = (const unsigned char*)value;
+
+    while (*current != '\0')
+    {
+        hash = (hash ^ *current) * 16777619U;
+        current++;
+    }
+
+    *length = (size_t)((const char*)current - value);
+    return hash;
+}
+
+static STRING_INTERN_ENTRY* create_entry(const char* value, size_t length, uint32_t hash, bool is_pooled)
+{
+    STRING_INTERN_ENTRY* result = (STRING_INTERN_ENTRY*)malloc(offsetof(STRING_INTERN_ENTRY, value) + length + 1);
+    if (result == NULL)
+    {
+        LogError("Cannot allocate interned string");
+    }
+    else
+    {
+        result->next = NULL;
+        result->hash = hash;
+        result->ref_count = 1;
+        result->is_pooled = is_pooled;
+        (void)memcpy(result->value, value, length + 1);
+    }
+
+    return result;
+}
+
+// Must be called with pool_lock held. Keeps the current buckets when the new ones cannot be allocated.
+static void grow_buckets(void)
+{
+    size_t new_bucket_count = pool_bucket_count * 2;
+    STRING_INTERN_ENTRY** new_buckets = (STRING_INTERN_ENTRY**)calloc(new_bucket_count, sizeof(STRING_INTERN_ENTRY*));
+    if (new_buckets != NULL)
+    {
+        size_t i;
+
+        for (i = 0; i < pool_bucket_count; i++)
+        {
+            while (pool_buckets[i] != NULL)
+            {
+                STRING_INTERN_ENTRY* entry = pool_buckets[i];
+                size_t new_index = entry->hash & (new_bucket_count - 1);
+
+                pool_buckets[i] = entry->next;
+                entry->next = new_buckets[new_index];
+                new_buckets[new_index] = entry;
+            }
+        }
+
+        free(pool_buckets);
+        pool_buckets = new_buckets;
+        pool_bucket_count = new_bucket_count;
+    }
+}
+
+int string_intern_init(void)
+{
+    int result;
+
+    if (pool_lock != NULL)
+    {
+        /* Codes_SRS_STRING_INTERN_01_001: [ If the pool is already initialized, string_intern_init shall fail and return a non-zero value. ]*/
+        LogError("string_intern is already initialized");
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_STRING_INTERN_01_002: [ string_intern_init shall allocate STRING_INTERN_INITIAL_BUCKET_COUNT buckets and create a lock. ]*/
+    else if ((pool_buckets = (STRING_INTERN_ENTRY**)calloc(STRING_INTERN_INITIAL_BUCKET_COUNT, sizeof(STRING_INTERN_ENTRY*))) == NULL)
+    {
+        /* Codes_SRS_STRING_INTERN_01_003: [ If any failure occurs, string_intern_init shall free what it created and return a non-zero value. ]*/
+        LogError("Cannot allocate the string_intern buckets");
+        result = __FAILURE__;
+    }
+    else if ((pool_lock = Lock_Init()) == NULL)
+    {
+        /* Codes_SRS_STRING_INTERN_01_003: [ If any failure occurs, string_intern_init shall free what it created and return a non-zero value. ]*/
+        LogError("Cannot create the string_intern lock");
+        free(pool_buckets);
+        pool_buckets = NULL;
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_STRING_INTERN_01_004: [ On success string_intern_init shall return 0. ]*/
+        pool_bucket_count = STRING_INTERN_INITIAL_BUCKET_COUNT;
+        pool_entry_count = 0;
+        result = 0;
+    }
+
+    return result;
+}
+
+void string_intern_deinit(void)
+{
+    if (pool_lock == NULL)
+    {
+        /* Codes_SRS_STRING_INTERN_01_005: [ If the pool is not initialized, string_intern_deinit shall return. ]*/
+    }
+    else
+    {
+        size_t i;
+
+        /* Codes_SRS_STRING_INTERN_01_006: [ string_intern_deinit shall turn the strings still referenced into private copies, and free the buckets and the lock. ]*/
+        if (pool_entry_count > 0)
+        {
+            LogError("%lu interned strings are still referenced", (unsigned long)pool_entry_count);
+        }
+
+        for (i = 0; i < pool_bucket_count; i++)
+        {
+            while (pool_buckets[i] != NULL)
+            {
+                STRING_INTERN_ENTRY* entry = pool_buckets[i];
+                pool_buckets[i] = entry->next;
+                entry->next = NULL;
+                entry->is_pooled = false;
+            }
+        }
+
+        free(pool_buckets);
+        pool_buckets = NULL;
+        pool_bucket_count = 0;
+        pool_entry_count = 0;
+
+        Lock_Deinit(pool_lock);
+        pool_lock = NULL;
+    }
+}
+
+const char* string_intern(const char* value)
+{
+    const char* result;
+
+    if (value == NULL)
+    {
+        /* Codes_SRS_STRING_INTERN_01_007: [ If value is NULL, string_intern shall fail and return NULL. ]*/
+        LogError("Invalid argument: value is NULL");
+        result = NULL;
+    }
+    else
+    {
+        size_t length;
+        uint32_t hash = hash_string(value, &length);
+
+        if (pool_lock == NULL)
+        {
+            /* Codes_SRS_STRING_INTERN_01_008: [ If the pool is not initialized, string_intern shall return a private copy of value. ]*/
+            STRING_INTERN_ENTRY* entry = create_entry(value, length, hash, false);
+            result = (entry == NULL) ? NULL : entry->value;
+        }
+        else if (Lock(pool_lock) != LOCK_OK)
+        {
+            /* Codes_SRS_STRING_INTERN_01_009: [ If any failure occurs, string_intern shall fail and return NULL. ]*/
+            LogError("Cannot lock the string_intern pool");
+            result = NULL;
+        }
+        else
+        {
+            size_t index = hash & (pool_bucket_count - 1);
+            STRING_INTERN_ENTRY* entry = pool_buckets[index];
+
+            while ((entry != NULL) &&
+                ((entry->hash != hash) || (strcmp(entry->value, value) != 0)))
+            {
+                entry = entry->next;
+            }
+
+            if (entry != NULL)
+            {
+                /* Codes_SRS_STRING_INTERN_01_010: [ If the pool holds a string equal to value, string_intern shall add a reference to it and return it. ]*/
+                entry->ref_count++;
+                result = entry->value;
+            }
+            /* Codes_SRS_STRING_INTERN_01_011: [ Otherwise string_intern shall add a copy of value to the pool and return it. ]*/
+            else if ((entry = create_entry(value, length, hash, true)) == NULL)
+            {
+                /* Codes_SRS_STRING_INTERN_01_009: [ If any failure occurs, string_intern shall fail and return NULL. ]*/
+                result = NULL;
+            }
+            else
+            {
+                entry->next = pool_buckets[index];
+                pool_buckets[index] = entry;
+                pool_entry_count++;
+                if (pool_entry_count > pool_bucket_count)
+                {
+                    grow_buckets();
+                }
+                result = entry->value;
+            }
+
+            (void)Unlock(pool_lock);
+        }
+    }
+
+    return result;
+}
+
+const char* string_intern_clone(const char* interned)
+{
+    const char* result;
+
+    if (interned == NULL)
+    {
+        /* Codes_SRS_STRING_INTERN_01_012: [ If interned is NULL, string_intern_clone shall fail and return NULL. ]*/
+        LogError("Invalid argument: interned is NULL");
+        result = NULL;
+    }
+    else
+    {
+        STRING_INTERN_ENTRY* entry = get_entry(interned);
+
+        if (!entry->is_pooled)
+        {
+            /* Codes_SRS_STRING_INTERN_01_013: [ If interned is not pooled, string_intern_clone shall return a new private copy of it. ]*/
+            STRING_INTERN_ENTRY* copy = create_entry(interned, strlen(interned), entry->hash, false);
+            result = (copy == NULL) ? NULL : copy->value;
+        }
+        else if (Lock(pool_lock) != LOCK_OK)
+        {
+            /* Codes_SRS_STRING_INTERN_01_014: [ If any failure occurs, string_intern_clone shall fail and return NULL. ]*/
+            LogError("Cannot lock the string_intern pool");
+            result = NULL;
+        }
+        else
+        {
+            /* Codes_SRS_STRING_INTERN_01_015: [ Otherwise string_intern_clone shall add a reference to interned and return it. ]*/
+            entry->ref_count++;
+            (void)Unlock(pool_lock);
+            result = interned;
+        }
+    }
+
+    return result;
+}
+
+void string_intern_release(const char* interned)
+{
+    if (interned == NULL)
+    {
+        /* Codes_SRS_STRING_INTERN_01_016: [ If interned is NULL, string_intern_release shall return. ]*/
+    }
+    else
+    {
+        STRING_INTERN_ENTRY* entry = get_entry(interned);
+
+        if (!entry->is_pooled)
+        {
+            /* Codes_SRS_STRING_INTERN_01_017: [ If interned is not pooled, string_intern_release shall remove a reference and free it when none is left. ]*/
+            entry->ref_count--;
+            if (entry->ref_count == 0)
+            {
+                free(entry);
+            }
+        }
+        else if (Lock(pool_lock) != LOCK_OK)
+        {
+            /* the string is leaked rather than freed while another thread might find it */
+            LogError("Cannot lock the string_intern pool");
+        }
+        else
+        {
+            /* Codes_SRS_STRING_INTERN_01_018: [ Otherwise string_intern_release shall remove a reference, and when none is left remove the string from the pool and free it. ]*/
+            entry->ref_count--;
+            if (entry->ref_count == 0)
+            {
+                STRING_INTERN_ENTRY** link = &pool_buckets[entry->hash & (pool_bucket_count - 1)];
+
+                while (*link != entry)
+                {
+                    link = &(*link)->next;
+                }
+                *link = entry->next;
+                pool_entry_count--;
+                free(entry);
+            }
+
+            (void)Unlock(pool_lock);
+        }
+    }
+}
+
+bool string_intern_equals(const char* left, const char* right)
+{
+    bool result;
+
+    if (left == right)
+    {
+        /* Codes_SRS_STRING_INTERN_01_019: [ If left and right are the same pointer, string_intern_equals shall return true. ]*/
+        result = true;
+    }
+    else if ((left == NULL) || (right == NULL))
+    {
+        /* Codes_SRS_STRING_INTERN_01_020: [ If only one of left and right is NULL, string_intern_equals shall return false. ]*/
+        result = false;
+    }
+    else if (get_entry(left)->is_pooled && get_entry(right)->is_pooled)
+    {
+        /* Codes_SRS_STRING_INTERN_01_021: [ If both strings are pooled and different pointers, string_intern_equals shall return false. ]*/
+        result = false;
+    }
+    else
+    {
+        /* Codes_SRS_STRING_INTERN_01_022: [ Otherwise string_intern_equals shall return whether the strings have the same content. ]*/
+        result = (strcmp(left, right) == 0);
+    }
+
+    return result;
+}
@@ -4,12 +4,44 @@
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
 #include "azure_c_shared_utility/string_token.h"
 
+/*
+* The delimiters are looked for through the set of their first bytes, built once per call: a single
+* first byte is looked for with memchr, up to STRING_TOKEN_SIMD_MAX_FIRST_BYTES of them 16 bytes at a
+* time with the SIMD instructions of the CPU (SSE2 on x86, NEON on AArch64), and the delimiters are only
+* compared at the positions holding one of them. Define NO_STRING_TOKEN_SIMD to build without SIMD.
+*/
+#if !defined(NO_STRING_TOKEN_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define STRING_TOKEN_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) && (defined(__clang__) || defined(__GNUC__))
+#define STRING_TOKEN_NEON
+#include <arm_neon.h>
+#endif
+#endif /* NO_STRING_TOKEN_SIMD */
+
+#define STRING_TOKEN_SIMD_MAX_FIRST_BYTES 4
+
+typedef struct DELIMITER_SET_TAG
+{
+    /* a bit per byte value that starts one of the delimiters */
+    uint32_t first_byte_bits[8];
+    /* the first STRING_TOKEN_SIMD_MAX_FIRST_BYTES of them, first_byte_count counts them all */
+    unsigned char first_bytes[STRING_TOKEN_SIMD_MAX_FIRST_BYTES];
+    size_t first_byte_count;
+} DELIMITER_SET;
+
 typedef struct STRING_TOKEN_TAG
 {
     const char* source;
@@ -20,31 +52,181 @@ typedef struct STRING_TOKEN_TAG
     const char* delimiter;
 } STRING_TOKEN;
 
-static size_t* get_delimiters_lengths(const char** delimiters, size_t n_delims)
+static int validate_delimiters(const char** delimiters, size_t n_delims)
+{
+    int result = 0;
+    size_t i;
+
+    for (i = 0; i < n_delims; i++)
+    {
+        if (delimiters[i] == NULL)
+        {
+            // Codes_SRS_STRING_TOKENIZER_09_002: [ If any of the strings in delimiters are NULL, the function shall return NULL ]
+            LogError("Invalid argument (delimiter %lu is NULL)", (unsigned long)i);
+            result = __FAILURE__;
+            break;
+        }
+    }
+
+    return result;
+}
+
+// The empty delimiters are left out, as they never match.
+static void build_delimiter_set(DELIMITER_SET* delimiter_set, const char** delimiters, size_t n_delims)
+{
+    size_t j;
+
+    (void)memset(delimiter_set, 0, sizeof(DELIMITER_SET));
+
+    for (j = 0; j < n_delims; j++)
+    {
+        unsigned char first_byte = (unsigned char)delimiters[j][0];
+
+        if (first_byte != '\0' &&
+            (delimiter_set->first_byte_bits[first_byte >> 5] & ((uint32_t)1 << (first_byte & 31))) == 0)
+        {
+            delimiter_set->first_byte_bits[first_byte >> 5] |= ((uint32_t)1 << (first_byte & 31));
+            if (delimiter_set->first_byte_count < STRING_TOKEN_SIMD_MAX_FIRST_BYTES)
+            {
+                delimiter_set->first_bytes[delimiter_set->first_byte_count] = first_byte;
+            }
+            delimiter_set->first_byte_count++;
+        }
+    }
+}
+
+// Returns the first position in [current_pos, stop_pos) holding the first byte of one of the delimiters, or stop_pos.
+static const char* find_first_byte(const DELIMITER_SET* delimiter_set, const char* current_pos, const char* stop_pos)
 {
-    size_t* result;
+    const unsigned char* position = (const unsigned char*)current_pos;
+    const unsigned char* stop = (const unsigned char*)stop_pos;
 
-    if ((result = malloc(sizeof(size_t) * n_delims)) == NULL)
+    if (delimiter_set->first_byte_count == 0)
+    {
+        position = stop;
+    }
+    else if (delimiter_set->first_byte_count == 1)
     {
-        LogError("Failed to allocate array for delimiters lengths");
+        position = (const unsigned char*)memchr(position, delimiter_set->first_bytes[0], (size_t)(stop - position));
+        if (position == NULL)
+        {
+            position = stop;
+        }
     }
     else
     {
-        size_t i;
-        for (i = 0; i < n_delims; i++)
+#if defined(STRING_TOKEN_SSE2)
+        if (delimiter_set->first_byte_count <= STRING_TOKEN_SIMD_MAX_FIRST_BYTES)
         {
-            if (delimiters[i] == NULL)
+            __m128i first_bytes[STRING_TOKEN_SIMD_MAX_FIRST_BYTES];
+            size_t j;
+
+            for (j = 0; j < delimiter_set->first_byte_count; j++)
             {
-                // Codes_SRS_STRING_TOKENIZER_09_002: [ If any of the strings in delimiters are NULL, the function shall return NULL ]
-                LogError("Invalid argument (delimiter %lu is NULL)", (unsigned long)i);
-                free(result);
-                result = NULL;
-                break;
+                first_bytes[j] = _mm_set1_epi8((char)delimiter_set->first_bytes[j]);
             }
-            else
+
+            while ((stop - position) >= 16)
             {
-                result[i] = strlen(delimiters[i]);
+                __m128i block = _mm_loadu_si128((const __m128i*)position);
+                __m128i found = _mm_cmpeq_epi8(block, first_bytes[0]);
+                unsigned int mask;
+
+                for (j = 1; j < delimiter_set->first_byte_count; j++)
+                {
+                    found = _mm_or_si128(found, _mm_cmpeq_epi8(block, first_bytes[j]));
+                }
+
+                mask = (unsigned int)_mm_movemask_epi8(found);
+                if (mask != 0)
+                {
+#if defined(_MSC_VER)
+                    unsigned long index;
+                    (void)_BitScanForward(&index, mask);
+                    position += index;
+#else
+                    position += __builtin_ctz(mask);
+#endif
+                    break;
+                }
+                position += 16;
+            }
+        }
+#elif defined(STRING_TOKEN_NEON)
+        if (delimiter_set->first_byte_count <= STRING_TOKEN_SIMD_MAX_FIRST_BYTES)
+        {
+            uint8x16_t first_bytes[STRING_TOKEN_SIMD_MAX_FIRST_BYTES];
+            size_t j;
+
+            for (j = 0; j < delimiter_set->first_byte_count; j++)
+            {
+                first_bytes[j] = vdupq_n_u8(delimiter_set->first_bytes[j]);
             }
+
+            while ((stop - position) >= 16)
+            {
+                uint8x16_t block = vld1q_u8(position);
+                uint8x16_t found = vceqq_u8(block, first_bytes[0]);
+                uint64_t mask;
+
+                for (j = 1; j < delimiter_set->first_byte_count; j++)
+                {
+                    found = vorrq_u8(found, vceqq_u8(block, first_bytes[j]));
+                }
+
+                /* 4 bits per byte */
+                mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(found), 4)), 0);
+                if (mask != 0)
+                {
+                    position += (__builtin_ctzll(mask) >> 2);
+                    break;
+                }
+                position += 16;
+            }
+        }
+#endif
+        /* the tail, or after a block holding one of the first bytes, the bytes up to it */
+        while (position < stop &&
+            (delimiter_set->first_byte_bits[*position >> 5] & ((uint32_t)1 << (*position & 31))) == 0)
+        {
+            position++;
+        }
+    }
+
+    return (const char*)position;
+}
+
+// Returns the position in [current_pos, stop_pos) where the first of the delimiters occurs (in the order
+// provided when several start at the same position), or NULL if none does.
+static const char* find_delimiter(const DELIMITER_SET* delimiter_set, const char* current_pos, const char* stop_pos, const char** delimiters, size_t n_delims, const char** delimiter)
+{
+    const char* result = NULL;
+
+    while (result == NULL &&
+        (current_pos = find_first_byte(delimiter_set, current_pos, stop_pos)) < stop_pos)
+    {
+        size_t j;
+
+        for (j = 0; j < n_delims; j++)
+        {
+            if (*current_pos == *delimiters[j])
+            {
+                size_t delimiter_length = strlen(delimiters[j]);
+
+                if (delimiter_length != 0 &&
+                    delimiter_length <= (size_t)(stop_pos - current_pos) &&
+                    memcmp(current_pos, delimiters[j], delimiter_length) == 0)
+                {
+                    *delimiter = delimiters[j];
+                    result = current_pos;
+                    break;
+                }
+            }
+        }
+
+        if (result == NULL)
+        {
+            current_pos++;
         }
     }
 
@@ -60,86 +242,57 @@ static int get_next_token(STRING_TOKEN* token, const char** delimiters, size_t n
         // The parser reached the end of the input string.
         result = __FAILURE__;
     }
+    else if (validate_delimiters(delimiters, n_delims) != 0)
+    {
+        LogError("Failed to validate delimiters");
+        result = __FAILURE__;
+    }
     else
     {
-        size_t* delimiters_lengths;
+        const char* new_token_start;
+        const char* delimiter = NULL;
+        const char* delimiter_start;
+        DELIMITER_SET delimiter_set;
 
-        if ((delimiters_lengths = get_delimiters_lengths(delimiters, n_delims)) == NULL)
+        if (token->delimiter_start == NULL)
         {
-            LogError("Failed to get delimiters lengths");
-            result = __FAILURE__;
+            // Codes_SRS_STRING_TOKENIZER_09_005: [ The source string shall be split in a token starting from the beginning of source up to occurrence of any one of the demiliters, whichever occurs first in the order provided ]
+            new_token_start = token->source;
         }
         else
         {
-            const char* new_token_start;
-            const char* current_pos;
-            const char* stop_pos = (char*)token->source + token->length;
-            size_t j; // iterator for the delimiters.
+            // Codes_SRS_STRING_TOKENIZER_09_010: [ The next token shall be selected starting from the position in source right after the previous delimiter up to occurrence of any one of demiliters, whichever occurs first in the order provided ]
+            new_token_start = token->delimiter_start + strlen(token->delimiter);
+        }
 
-            if (token->delimiter_start == NULL)
-            {
-                // Codes_SRS_STRING_TOKENIZER_09_005: [ The source string shall be split in a token starting from the beginning of source up to occurrence of any one of the demiliters, whichever occurs first in the order provided ]
-                new_token_start = (char*)token->source;
-            }
-            else
-            {
-                // Codes_SRS_STRING_TOKENIZER_09_010: [ The next token shall be selected starting from the position in source right after the previous delimiter up to occurrence of any one of demiliters, whichever occurs first in the order provided ]
-                new_token_start = token->delimiter_start + strlen(token->delimiter);
-            }
+        build_delimiter_set(&delimiter_set, delimiters, n_delims);
 
-            current_pos = new_token_start;
-            result = 0;
+        if ((delimiter_start = find_delimiter(&delimiter_set, new_token_start, token->source + token->length, delimiters, n_delims, &delimiter)) != NULL)
+        {
+            token->delimiter_start = delimiter_start;
+            token->delimiter = delimiter;
 
-            while (current_pos < stop_pos)
+            if (token->delimiter_start == token->source)
             {
-                for (j = 0; j < n_delims; j++)
-                {
-                    if (*current_pos == *delimiters[j])
-                    {
-                        size_t k;
-                        for (k = 1; k < delimiters_lengths[j] && (current_pos + k) < stop_pos; k++)
-                        {
-                            if (*(current_pos + k) != *(delimiters[j] + k))
-                            {
-                                break;
-                            }
-                        }
-
-                        if (k == delimiters_lengths[j])
-                        {
-                            token->delimiter_start = current_pos;
-                            token->delimiter = delimiters[j];
-
-                            if (token->delimiter_start == token->source)
-                            {
-                                // Delimiter occurs in the beginning of the source string.
-                                token->token_start = NULL;
-                            }
-                            else
-                            {
-                                token->token_start = new_token_start;
-                            }
-                            goto SCAN_COMPLETED;
-                        }
-                    }
-                }
-
-                current_pos++;
+                // Delimiter occurs in the beginning of the source string.
+                token->token_start = NULL;
             }
-
-            // Codes_SRS_STRING_TOKENIZER_09_006: [ If the source string does not have any of the demiliters, the resulting token shall be the entire source string ]
-            // Codes_SRS_STRING_TOKENIZER_09_011: [ If the source string, starting right after the position of the last delimiter found, does not have any of the demiliters, the resulting token shall be the entire remaining of the source string ]
-            if (current_pos == stop_pos)
+            else
             {
                 token->token_start = new_token_start;
-                token->delimiter_start = NULL;
-                // Codes_SRS_STRING_TOKENIZER_09_019: [ If the current token extends to the end of source, the function shall return NULL ]
-                token->delimiter = NULL;
             }
-
-SCAN_COMPLETED:
-            free(delimiters_lengths);
         }
+        else
+        {
+            // Codes_SRS_STRING_TOKENIZER_09_006: [ If the source string does not have any of the demiliters, the resulting token shall be the entire source string ]
+            // Codes_SRS_STRING_TOKENIZER_09_011: [ If the source string, starting right after the position of the last delimiter found, does not have any of the demiliters, the resulting token shall be the entire remaining of the source string ]
+            token->token_start = new_token_start;
+            token->delimiter_start = NULL;
+            // Codes_SRS_STRING_TOKENIZER_09_019: [ If the current token extends to the end of source, the function shall return NULL ]
+            token->delimiter = NULL;
+        }
+
+        result = 0;
     }
 
     return result;
@@ -387,4 +540,76 @@ void StringToken_Destroy(STRING_TOKEN_HANDLE token)
         // Codes_SRS_STRING_TOKENIZER_09_021: [ Otherwise the memory allocated for STRING_TOKEN shall be released ]
         free(token);
     }
-}
\ No newline at end of file
+}
+int StringToken_InitView(STRING_TOKEN_VIEW* view, const char* source, size_t length)
+{
+    int result;
+
+    // Codes_SRS_STRING_TOKENIZER_09_028: [ If view or source are NULL, the function shall return a non-zero value ]
+    if (view == NULL || source == NULL)
+    {
+        LogError("Invalid argument (view=%p, source=%p)", view, source);
+        result = __FAILURE__;
+    }
+    else
+    {
+        // Codes_SRS_STRING_TOKENIZER_09_029: [ The function shall set view to scan source up to length from its beginning, with no current token, and return zero ]
+        view->value = NULL;
+        view->length = 0;
+        view->delimiter = NULL;
+        view->next = source;
+        view->end = source + length;
+        result = 0;
+    }
+
+    return result;
+}
+
+bool StringToken_NextView(STRING_TOKEN_VIEW* view, const char** delimiters, size_t n_delims)
+{
+    bool result;
+
+    // Codes_SRS_STRING_TOKENIZER_09_030: [ If view or delimiters are NULL, n_delims is zero or any of the strings in delimiters are NULL, the function shall return false ]
+    if (view == NULL || delimiters == NULL || n_delims == 0 || validate_delimiters(delimiters, n_delims) != 0)
+    {
+        LogError("Invalid argument (view=%p, delimiters=%p, n_delims=%lu)", view, delimiters, (unsigned long)n_delims);
+        result = false;
+    }
+    // Codes_SRS_STRING_TOKENIZER_09_031: [ If the previous token already extended to the end of source, the function shall return false ]
+    else if (view->next == NULL)
+    {
+        result = false;
+    }
+    else
+    {
+        const char* delimiter = NULL;
+        const char* delimiter_start;
+        DELIMITER_SET delimiter_set;
+
+        build_delimiter_set(&delimiter_set, delimiters, n_delims);
+        delimiter_start = find_delimiter(&delimiter_set, view->next, view->end, delimiters, n_delims, &delimiter);
+
+        // Codes_SRS_STRING_TOKENIZER_09_032: [ The token shall start at the beginning of source on the first call, or right after the previous delimiter otherwise, and extend up to the first occurrence of any one of delimiters, whichever occurs first in the order provided ]
+        view->value = view->next;
+
+        if (delimiter_start == NULL)
+        {
+            // Codes_SRS_STRING_TOKENIZER_09_033: [ If none of delimiters occurs, the token shall extend to the end of source and delimiter shall be set to NULL ]
+            view->length = (size_t)(view->end - view->next);
+            view->delimiter = NULL;
+            view->next = NULL;
+        }
+        else
+        {
+            // Codes_SRS_STRING_TOKENIZER_09_034: [ Otherwise delimiter shall point to the element of delimiters that ended the token ]
+            view->length = (size_t)(delimiter_start - view->next);
+            view->delimiter = delimiter;
+            view->next = delimiter_start + strlen(delimiter);
+        }
+
+        // Codes_SRS_STRING_TOKENIZER_09_035: [ The function shall not allocate memory, shall not modify source and shall return true ]
+        result = true;
+    }
+
+    return result;
+}
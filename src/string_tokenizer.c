@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include "azure_c_shared_utility/gballoc.h"
 #include <stdbool.h>
+#include <string.h>
 #include "azure_c_shared_utility/string_tokenizer.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
@@ -94,29 +95,11 @@ int STRING_TOKENIZER_get_next_token(STRING_TOKENIZER_HANDLE tokenizer, STRING_HA
         }
         else
         {
-            size_t i;
             /* Codes_SRS_STRING_04_005: [STRING_TOKENIZER_get_next_token searches the string inside STRING_TOKENIZER_HANDLE for the first character that is NOT contained in the current delimiter] */
-            for (i = 0; i < remainingInputStringSize; i++)
-            {
-                size_t j;
-
-                bool foundDelimitter = false;
-                for (j = 0; j < delimitterSize; j++)
-                {
-                    if (token->currentPos[i] == delimiters[j])
-                    {
-                        foundDelimitter = true;
-                        break;
-                    }
-                }
-
-                /* Codes_SRS_STRING_04_007: [If such a character is found, STRING_TOKENIZER_get_next_token consider it as the start of a token.] */
-                if (!foundDelimitter)
-                {
-                    break;
-                }
-            }
+            /* strspn and strcspn look the characters up in a table of the delimiters built once, rather than comparing each character with each delimiter */
+            size_t i = strspn(token->currentPos, delimiters);
 
+            /* Codes_SRS_STRING_04_007: [If such a character is found, STRING_TOKENIZER_get_next_token consider it as the start of a token.] */
             /* Codes_SRS_STRING_04_006: [If no such character is found, then STRING_TOKENIZER_get_next_token shall return a nonzero Value (You've reach the end of the string or the string consists with only delimiters).] */
             //At this point update Current Pos to the character of the last token found or end of String.
             token->currentPos += i;
@@ -131,32 +114,12 @@ int STRING_TOKENIZER_get_next_token(STRING_TOKENIZER_HANDLE tokenizer, STRING_HA
             }
             else
             {
-                bool foundDelimitter = false;
-                const char* endOfTokenPosition=NULL;
-                size_t amountOfCharactersToCopy;
-                size_t j;
                 //At this point the Current Pos is pointing to a character that is point to a nonDelimiter. So, now search for a Delimiter, till the end of the String.
                 /*Codes_SRS_STRING_04_008: [STRING_TOKENIZER_get_next_token than searches from the start of a token for a character that is contained in the delimiters string.] */
                 /* Codes_SRS_STRING_04_009: [If no such character is found, STRING_TOKENIZER_get_next_token extends the current token to the end of the string inside t, copies the token to output and returns 0.] */
                 /* Codes_SRS_STRING_04_010: [If such a character is found, STRING_TOKENIZER_get_next_token consider it the end of the token and copy it's content to output, updates the current position inside t to the next character and returns 0.] */
-                for (j = 0; j < delimitterSize; j++)
-                {
-                    if ((endOfTokenPosition = strchr(token->currentPos, delimiters[j])) != NULL)
-                    {
-                        foundDelimitter = true;
-                        break;
-                    }
-                }
-
-                //If token not found, than update the EndOfToken to the end of the inputString;
-                if (endOfTokenPosition == NULL)
-                {
-                    amountOfCharactersToCopy = remainingInputStringSize;
-                }
-                else
-                {
-                    amountOfCharactersToCopy = endOfTokenPosition - token->currentPos;
-                }
+                size_t amountOfCharactersToCopy = strcspn(token->currentPos, delimiters);
+                bool foundDelimitter = (amountOfCharactersToCopy < remainingInputStringSize);
 
                 //copy here the string to output.
                 if (STRING_copy_n(output, token->currentPos, amountOfCharactersToCopy) != 0)
@@ -10,6 +10,7 @@
 #include <string.h>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdbool.h>
 
 //
 // PUT NO CLIENT LIBRARY INCLUDES BEFORE HERE
@@ -18,31 +19,369 @@
 #include "azure_c_shared_utility/strings.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
+#ifdef USE_OBJECT_POOLS
+#include "azure_c_shared_utility/object_pool.h"
+#endif
+
+/*strings shorter than this (the '\0' included) are kept in the STRING itself, 0 keeps every value on the heap*/
+#ifndef STRING_INLINE_CAPACITY
+#define STRING_INLINE_CAPACITY 24
+#endif
+
+/*STRING_construct_sprintf and STRING_sprintf format into a stack buffer of this size (unless the spare capacity of the STRING is
+larger) and only format a second time, into memory of the right size, when the result does not fit*/
+#if defined(STRINGS_C_SPRINTF_BUFFER_SIZE)
+#define STRING_SPRINTF_BUFFER_SIZE STRINGS_C_SPRINTF_BUFFER_SIZE
+#elif !defined(STRING_SPRINTF_BUFFER_SIZE)
+#define STRING_SPRINTF_BUFFER_SIZE 256
+#endif
 
 static const char hexToASCII[16] = { '0', '1', '2', '3', '4', '5', '6', '7', '8', '9', 'A', 'B', 'C', 'D', 'E', 'F' };
 
+/*
+* STRING_new_JSON and STRING_concat_JSON look for the characters that need escaping 16 at a time with
+* the SIMD instructions of the CPU (SSE2 on x86, NEON on AArch64) and copy the runs between them in bulk.
+* Define NO_STRING_JSON_SIMD to build without them.
+*/
+#if !defined(NO_STRING_JSON_SIMD)
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define STRING_JSON_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) && (defined(__clang__) || defined(__GNUC__))
+#define STRING_JSON_NEON
+#include <arm_neon.h>
+#endif
+#endif /* NO_STRING_JSON_SIMD */
+
+#define JSON_ESCAPE_INVALID 1
+
+/*how a character goes to the JSON representation: 0 as it is, JSON_ESCAPE_INVALID not at all, 'u' as \u00xx and any other value as '\' followed by that value*/
+static const unsigned char JSON_ESCAPE[256] =
+{
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+    'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u', 'u',
+    0, 0, '"', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '/',
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, '\\', 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID,
+    JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID,
+    JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID,
+    JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID,
+    JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID,
+    JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID,
+    JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID,
+    JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID, JSON_ESCAPE_INVALID
+};
+
+/*returns how many characters at the start of source (at most length) go to the JSON representation as they are*/
+static size_t json_clean_prefix(const unsigned char* source, size_t length)
+{
+    size_t result = 0;
+#if defined(STRING_JSON_SSE2)
+    const __m128i space = _mm_set1_epi8(0x20);
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i slash = _mm_set1_epi8('/');
+    while ((length - result) >= 16)
+    {
+        __m128i block = _mm_loadu_si128((const __m128i*)(source + result));
+        /*the signed comparison catches the control characters and the characters from 0x80 up*/
+        __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmplt_epi8(block, space), _mm_cmpeq_epi8(block, quote)),
+            _mm_or_si128(_mm_cmpeq_epi8(block, backslash), _mm_cmpeq_epi8(block, slash)));
+        unsigned int mask = (unsigned int)_mm_movemask_epi8(special);
+        if (mask != 0)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            (void)_BitScanForward(&index, mask);
+            result += index;
+#else
+            result += (size_t)__builtin_ctz(mask);
+#endif
+            break;
+        }
+        result += 16;
+    }
+#elif defined(STRING_JSON_NEON)
+    const uint8x16_t space = vdupq_n_u8(0x20);
+    const uint8x16_t high = vdupq_n_u8(0x80);
+    const uint8x16_t quote = vdupq_n_u8('"');
+    const uint8x16_t backslash = vdupq_n_u8('\\');
+    const uint8x16_t slash = vdupq_n_u8('/');
+    while ((length - result) >= 16)
+    {
+        uint8x16_t block = vld1q_u8(source + result);
+        uint8x16_t special = vorrq_u8(
+            vorrq_u8(vcltq_u8(block, space), vcgeq_u8(block, high)),
+            vorrq_u8(vceqq_u8(block, quote), vorrq_u8(vceqq_u8(block, backslash), vceqq_u8(block, slash))));
+        /*4 bits per character*/
+        uint64_t mask = vget_lane_u64(vreinterpret_u64_u8(vshrn_n_u16(vreinterpretq_u16_u8(special), 4)), 0);
+        if (mask != 0)
+        {
+            result += (size_t)(__builtin_ctzll(mask) >> 2);
+            break;
+        }
+        result += 16;
+    }
+#endif
+    /*the tail of source, or after a block with a special character, the characters up to it*/
+    while ((result < length) && (JSON_ESCAPE[source[result]] == 0))
+    {
+        result++;
+    }
+    return result;
+}
+
+/*computes the size of the JSON representation of source without the quotes, fails if a character cannot be represented*/
+static int json_escaped_size(const unsigned char* source, size_t length, size_t* escapedSize)
+{
+    int result = 0;
+    size_t size = 0;
+    size_t i = 0;
+    while (i < length)
+    {
+        size_t run = json_clean_prefix(source + i, length - i);
+        size += run;
+        i += run;
+        if (i < length)
+        {
+            unsigned char escape = JSON_ESCAPE[source[i]];
+            if (escape == JSON_ESCAPE_INVALID)
+            {
+                result = __FAILURE__;
+                break;
+            }
+            size += (escape == 'u') ? 6 : 2;
+            i++;
+        }
+    }
+    *escapedSize = size;
+    return result;
+}
+
+/*writes the JSON representation of source without the quotes in at most destinationSize characters, json_escaped_size tells how many it needs;
+fails if a character cannot be represented or does not fit, in which case what has been written so far stays in destination*/
+static int json_escape(char* destination, size_t destinationSize, const unsigned char* source, size_t length, size_t* written)
+{
+    int result = 0;
+    size_t position = 0;
+    size_t i = 0;
+    while (i < length)
+    {
+        size_t run = json_clean_prefix(source + i, length - i);
+        if (run > destinationSize - position)
+        {
+            result = __FAILURE__;
+            break;
+        }
+        /*Codes_SRS_STRING_02_013: [The string shall copy the characters of source "as they are" (until the '\0' character) with the following exceptions:] */
+        (void)memcpy(destination + position, source + i, run);
+        position += run;
+        i += run;
+        if (i < length)
+        {
+            unsigned char escape = JSON_ESCAPE[source[i]];
+            if ((escape == JSON_ESCAPE_INVALID) ||
+                (((escape == 'u') ? (size_t)6 : (size_t)2) > destinationSize - position))
+            {
+                result = __FAILURE__;
+                break;
+            }
+            destination[position++] = '\\';
+            if (escape == 'u')
+            {
+                /*Codes_SRS_STRING_02_019: [If the character code is less than 0x20 then it shall be represented as \u00xx, where xx is the hex representation of the character code.]*/
+                destination[position++] = 'u';
+                destination[position++] = '0';
+                destination[position++] = '0';
+                destination[position++] = hexToASCII[(source[i] & 0xF0) >> 4]; /*high nibble*/
+                destination[position++] = hexToASCII[source[i] & 0x0F]; /*low nibble*/
+            }
+            else
+            {
+                /*Codes_SRS_STRING_02_016: [If the character is " (quote) then it shall be repsented as \".] */
+                /*Codes_SRS_STRING_02_017: [If the character is \ (backslash) then it shall represented as \\.] */
+                /*Codes_SRS_STRING_02_018: [If the character is / (slash) then it shall be represented as \/.] */
+                destination[position++] = (char)escape;
+            }
+            i++;
+        }
+    }
+    *written = position;
+    return result;
+}
+
 typedef struct STRING_TAG
 {
     char* s;
+    size_t length; /*number of characters in s, not counting the '\0'*/
+    size_t capacity; /*number of bytes allocated for s, including the '\0'*/
+#if STRING_INLINE_CAPACITY > 0
+    /*values of up to STRING_INLINE_CAPACITY bytes live here, so that they need no allocation of their own*/
+    char inline_value[STRING_INLINE_CAPACITY];
+#endif
 } STRING;
 
+#ifdef USE_OBJECT_POOLS
+/*the number of STRING control blocks when built with OBJECT_POOL_STATIC*/
+#ifndef STRING_POOL_COUNT
+#define STRING_POOL_COUNT 64
+#endif
+OBJECT_POOL_DEFINE_STATIC(string_pool, sizeof(STRING), STRING_POOL_COUNT);
+#endif
+
+#if defined(USE_OBJECT_POOLS) && defined(OBJECT_POOL_STATIC)
+/* Codes_SRS_STRING_01_023: [ When built with OBJECT_POOL_STATIC, the values that do not fit in the STRING control block shall be allocated from the payload pools of object_pool. ] */
+#define STRING_memory_malloc(size) object_pool_payload_alloc(size)
+/*values handed over by STRING_new_with_memory come from the heap and stay there*/
+#define STRING_memory_realloc(ptr, size) ((((ptr) == NULL) || object_pool_is_payload(ptr)) ? object_pool_payload_realloc(ptr, size) : realloc(ptr, size))
+#define STRING_memory_free(ptr) (object_pool_is_payload(ptr) ? object_pool_payload_free(ptr) : free(ptr))
+#else
+#define STRING_memory_malloc(size) malloc(size)
+#define STRING_memory_realloc(ptr, size) realloc(ptr, size)
+#define STRING_memory_free(ptr) free(ptr)
+#endif
+
+static STRING* STRING_alloc_handle(void)
+{
+    STRING* result;
+#ifdef USE_OBJECT_POOLS
+    /* Codes_SRS_STRING_01_008: [ When built with USE_OBJECT_POOLS, the STRING control blocks shall be recycled through an object pool. ] */
+    result = (STRING*)object_pool_alloc(&string_pool);
+#else
+    result = (STRING*)malloc(sizeof(STRING));
+#endif
+    if (result != NULL)
+    {
+        result->s = NULL;
+    }
+    return result;
+}
+
+static void STRING_free_handle(STRING* value)
+{
+#ifdef USE_OBJECT_POOLS
+    object_pool_free(&string_pool, value);
+#else
+    GBALLOC_FREE_SIZED(value, sizeof(STRING));
+#endif
+}
+
+/*allocates size bytes for the value of a handle that does not hold a value yet*/
+static char* STRING_alloc_value(STRING* value, size_t size)
+{
+    char* result;
+#if STRING_INLINE_CAPACITY > 0
+    /* Codes_SRS_STRING_01_009: [ Values of up to STRING_INLINE_CAPACITY bytes, including the terminating '\0', shall be stored in the STRING control block without a separate allocation. ] */
+    if (size <= STRING_INLINE_CAPACITY)
+    {
+        result = value->inline_value;
+    }
+    else
+#endif
+    {
+        (void)value;
+        result = (char*)STRING_memory_malloc(size);
+    }
+    return result;
+}
+
+/*same contract as realloc(value->s, size): on failure value->s is left untouched*/
+static char* STRING_realloc_value(STRING* value, size_t size)
+{
+    char* result;
+#if STRING_INLINE_CAPACITY > 0
+    if (((value->s == NULL) || (value->s == value->inline_value)) && (size <= STRING_INLINE_CAPACITY))
+    {
+        result = value->inline_value;
+    }
+    else if (value->s == value->inline_value)
+    {
+        /* Codes_SRS_STRING_01_010: [ When a value stored in the STRING control block grows beyond STRING_INLINE_CAPACITY bytes, it shall be moved to memory allocated with malloc. ] */
+        result = (char*)STRING_memory_malloc(size);
+        if (result != NULL)
+        {
+            (void)memcpy(result, value->inline_value, value->capacity);
+        }
+    }
+    else
+#endif
+    {
+        result = (char*)STRING_memory_realloc(value->s, size);
+    }
+    return result;
+}
+
+static void STRING_free_value(STRING* value)
+{
+#if STRING_INLINE_CAPACITY > 0
+    if (value->s != value->inline_value)
+#endif
+    {
+        STRING_memory_free(value->s);
+    }
+}
+
+/*makes sure that value->s can hold at least required bytes (including the '\0'). When it has to grow, the capacity grows to the
+larger of required and twice the current capacity, so that a long chain of appends only reallocates a logarithmic number of times*/
+static int STRING_ensure_capacity(STRING* value, size_t required)
+{
+    int result;
+    if (required <= value->capacity)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t newCapacity = (value->capacity > ((size_t)-1) / 2) ? required : value->capacity * 2;
+        char* temp;
+        if (newCapacity < required)
+        {
+            newCapacity = required;
+        }
+
+        temp = STRING_realloc_value(value, newCapacity);
+        if (temp == NULL)
+        {
+            LogError("Failure reallocating value.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            value->s = temp;
+            value->capacity = newCapacity;
+            result = 0;
+        }
+    }
+    return result;
+}
+
 /*this function will allocate a new string with just '\0' in it*/
 /*return NULL if it fails*/
 /* Codes_SRS_STRING_07_001: [STRING_new shall allocate a new STRING_HANDLE pointing to an empty string.] */
 STRING_HANDLE STRING_new(void)
 {
     STRING* result;
-    if ((result = (STRING*)malloc(sizeof(STRING))) != NULL)
+    if ((result = STRING_alloc_handle()) != NULL)
     {
-        if ((result->s = (char*)malloc(1)) != NULL)
+        if ((result->s = STRING_alloc_value(result, 1)) != NULL)
         {
             result->s[0] = '\0';
+            result->length = 0;
+            result->capacity = 1;
         }
         else
         {
             /* Codes_SRS_STRING_07_002: [STRING_new shall return an NULL STRING_HANDLE on any error that is encountered.] */
             LogError("Failure allocating in STRING_new.");
-            free(result);
+            STRING_free_handle(result);
             result = NULL;
         }
     }
@@ -61,20 +400,22 @@ STRING_HANDLE STRING_clone(STRING_HANDLE handle)
     else
     {
         /*Codes_SRS_STRING_02_003: [If STRING_clone fails for any reason, it shall return NULL.] */
-        if ((result = (STRING*)malloc(sizeof(STRING))) != NULL)
+        if ((result = STRING_alloc_handle()) != NULL)
         {
             STRING* source = (STRING*)handle;
             /*Codes_SRS_STRING_02_003: [If STRING_clone fails for any reason, it shall return NULL.] */
-            size_t sourceLen = strlen(source->s);
-            if ((result->s = (char*)malloc(sourceLen + 1)) == NULL)
+            size_t sourceLen = source->length;
+            if ((result->s = STRING_alloc_value(result, sourceLen + 1)) == NULL)
             {
                 LogError("Failure allocating clone value.");
-                free(result);
+                STRING_free_handle(result);
                 result = NULL;
             }
             else
             {
                 (void)memcpy(result->s, source->s, sourceLen + 1);
+                result->length = sourceLen;
+                result->capacity = sourceLen + 1;
             }
         }
         else
@@ -97,19 +438,21 @@ STRING_HANDLE STRING_construct(const char* psz)
     else
     {
         STRING* str;
-        if ((str = (STRING*)malloc(sizeof(STRING))) != NULL)
+        if ((str = STRING_alloc_handle()) != NULL)
         {
             size_t nLen = strlen(psz) + 1;
-            if ((str->s = (char*)malloc(nLen)) != NULL)
+            if ((str->s = STRING_alloc_value(str, nLen)) != NULL)
             {
                 (void)memcpy(str->s, psz, nLen);
+                str->length = nLen - 1;
+                str->capacity = nLen;
                 result = (STRING_HANDLE)str;
             }
             /* Codes_SRS_STRING_07_032: [STRING_construct encounters any error it shall return a NULL value.] */
             else
             {
                 LogError("Failure allocating constructed value.");
-                free(str);
+                STRING_free_handle(str);
                 result = NULL;
             }
         }
@@ -129,14 +472,7 @@ __attribute__ ((format (printf, 1, 2)))
 STRING_HANDLE STRING_construct_sprintf(const char* format, ...)
 {
     STRING* result;
-
-#ifdef STRINGS_C_SPRINTF_BUFFER_SIZE
-    size_t maxBufSize = STRINGS_C_SPRINTF_BUFFER_SIZE;
-    char buf[STRINGS_C_SPRINTF_BUFFER_SIZE];
-#else
-    size_t maxBufSize = 0;
-    char* buf = NULL;
-#endif
+    char buf[STRING_SPRINTF_BUFFER_SIZE];
 
     if (format != NULL)
     {
@@ -145,33 +481,50 @@ STRING_HANDLE STRING_construct_sprintf(const char* format, ...)
         va_start(arg_list, format);
 
         /* Codes_SRS_STRING_07_041: [STRING_construct_sprintf shall determine the size of the resulting string and allocate the necessary memory.] */
-        length = vsnprintf(buf, maxBufSize, format, arg_list);
+        /* Codes_SRS_STRING_01_022: [ STRING_construct_sprintf and STRING_sprintf shall format only once when the result fits in STRING_SPRINTF_BUFFER_SIZE bytes or in the spare capacity of the STRING. ] */
+        length = vsnprintf(buf, sizeof(buf), format, arg_list);
         va_end(arg_list);
         if (length > 0)
         {
-            result = (STRING*)malloc(sizeof(STRING));
+            result = STRING_alloc_handle();
             if (result != NULL)
             {
-                result->s = (char*)malloc(length+1);
-                if (result->s != NULL)
+                result->s = STRING_alloc_value(result, length+1);
+                if (result->s == NULL)
                 {
-                    va_start(arg_list, format);
-                    if (vsnprintf(result->s, length+1, format, arg_list) < 0)
+                    /* Codes_SRS_STRING_07_040: [If any error is encountered STRING_construct_sprintf shall return NULL.] */
+                    STRING_free_handle(result);
+                    result = NULL;
+                    LogError("Failure: allocation sprintf value failed.");
+                }
+                else
+                {
+                    int written;
+                    if ((size_t)length < sizeof(buf))
+                    {
+                        (void)memcpy(result->s, buf, (size_t)length + 1);
+                        written = length;
+                    }
+                    else
+                    {
+                        va_start(arg_list, format);
+                        written = vsnprintf(result->s, length+1, format, arg_list);
+                        va_end(arg_list);
+                    }
+
+                    if (written < 0)
                     {
                         /* Codes_SRS_STRING_07_040: [If any error is encountered STRING_construct_sprintf shall return NULL.] */
-                        free(result->s);
-                        free(result);
+                        STRING_free_value(result);
+                        STRING_free_handle(result);
                         result = NULL;
                         LogError("Failure: vsnprintf formatting failed.");
                     }
-                    va_end(arg_list);
-                }
-                else
-                {
-                    /* Codes_SRS_STRING_07_040: [If any error is encountered STRING_construct_sprintf shall return NULL.] */
-                    free(result);
-                    result = NULL;
-                    LogError("Failure: allocation sprintf value failed.");
+                    else
+                    {
+                        result->length = (size_t)length;
+                        result->capacity = (size_t)length + 1;
+                    }
                 }
             }
             else
@@ -213,9 +566,11 @@ STRING_HANDLE STRING_new_with_memory(const char* memory)
     }
     else
     {
-        if ((result = (STRING*)malloc(sizeof(STRING))) != NULL)
+        if ((result = STRING_alloc_handle()) != NULL)
         {
             result->s = (char*)memory;
+            result->length = strlen(memory);
+            result->capacity = result->length + 1;
         }
         else
         {
@@ -234,21 +589,23 @@ STRING_HANDLE STRING_new_quoted(const char* source)
         /* Codes_SRS_STRING_07_009: [STRING_new_quoted shall return a NULL STRING_HANDLE if the supplied const char* is NULL.] */
         result = NULL;
     }
-    else if ((result = (STRING*)malloc(sizeof(STRING))) != NULL)
+    else if ((result = STRING_alloc_handle()) != NULL)
     {
         size_t sourceLength = strlen(source);
-        if ((result->s = (char*)malloc(sourceLength + 3)) != NULL)
+        if ((result->s = STRING_alloc_value(result, sourceLength + 3)) != NULL)
         {
             result->s[0] = '"';
             (void)memcpy(result->s + 1, source, sourceLength);
             result->s[sourceLength + 1] = '"';
             result->s[sourceLength + 2] = '\0';
+            result->length = sourceLength + 2;
+            result->capacity = sourceLength + 3;
         }
         else
         {
             /* Codes_SRS_STRING_07_031: [STRING_new_quoted shall return a NULL STRING_HANDLE if any error is encountered.] */
             LogError("Failure allocating quoted string value.");
-            free(result);
+            STRING_free_handle(result);
             result = NULL;
         }
     }
@@ -261,112 +618,176 @@ STRING_HANDLE STRING_new_quoted(const char* source)
 STRING_HANDLE STRING_new_JSON(const char* source)
 {
     STRING* result;
+    size_t vlen;
+    size_t escapedSize;
     if (source == NULL)
     {
         /*Codes_SRS_STRING_02_011: [If source is NULL then STRING_new_JSON shall return NULL.] */
         result = NULL;
         LogError("invalid arg (NULL)");
     }
+    /*Codes_SRS_STRING_02_014: [If any character has the value outside [1...127] then STRING_new_JSON shall fail and return NULL.] */
+    else if (json_escaped_size((const unsigned char*)source, vlen = strlen(source), &escapedSize) != 0)
+    {
+        result = NULL;
+        LogError("invalid character in input string");
+    }
+    else if ((result = STRING_alloc_handle()) == NULL)
+    {
+        /*Codes_SRS_STRING_02_021: [If the complete JSON representation cannot be produced, then STRING_new_JSON shall fail and return NULL.] */
+        LogError("malloc json failure");
+    }
+    else if ((result->s = STRING_alloc_value(result, escapedSize + 3)) == NULL)
+    {
+        /*Codes_SRS_STRING_02_021: [If the complete JSON representation cannot be produced, then STRING_new_JSON shall fail and return NULL.] */
+        STRING_free_handle(result);
+        result = NULL;
+        LogError("malloc failed");
+    }
     else
     {
-        size_t i;
-        size_t nControlCharacters = 0; /*counts how many characters are to be expanded from 1 character to \uxxxx (6 characters)*/
-        size_t nEscapeCharacters = 0;
-        size_t vlen = strlen(source);
-
-        for (i = 0; i < vlen; i++)
+        /*Codes_SRS_STRING_02_012: [The string shall begin with the quote character.] */
+        result->s[0] = '"';
+        if (escapedSize == vlen)
         {
-            /*Codes_SRS_STRING_02_014: [If any character has the value outside [1...127] then STRING_new_JSON shall fail and return NULL.] */
-            if ((unsigned char)source[i] >= 128) /*this be a UNICODE character begin*/
-            {
-                break;
-            }
-            else
-            {
-                if (source[i] <= 0x1F)
-                {
-                    nControlCharacters++;
-                }
-                else if (
-                    (source[i] == '"') ||
-                    (source[i] == '\\') ||
-                    (source[i] == '/')
-                    )
-                {
-                    nEscapeCharacters++;
-                }
-            }
+            /*Codes_SRS_STRING_02_013: [The string shall copy the characters of source "as they are" (until the '\0' character) with the following exceptions:] */
+            (void)memcpy(result->s + 1, source, vlen);
         }
+        else
+        {
+            size_t written;
+            (void)json_escape(result->s + 1, escapedSize, (const unsigned char*)source, vlen, &written);
+        }
+        /*Codes_SRS_STRING_02_020: [The string shall end with " (quote).] */
+        result->s[escapedSize + 1] = '"';
+        /*zero terminating it*/
+        result->s[escapedSize + 2] = '\0';
+        result->length = escapedSize + 2;
+        result->capacity = escapedSize + 3;
+    }
+    return (STRING_HANDLE)result;
+}
+
+/* Codes_SRS_STRING_01_011: [ STRING_concat_JSON shall append to handle the JSON representation of source that STRING_new_JSON produces. ] */
+int STRING_concat_JSON(STRING_HANDLE handle, const char* source)
+{
+    int result;
+    if ((handle == NULL) || (source == NULL))
+    {
+        /* Codes_SRS_STRING_01_012: [ If handle or source is NULL, STRING_concat_JSON shall fail and return a non-zero value. ] */
+        LogError("Invalid argument: handle=%p, source=%p", handle, source);
+        result = __FAILURE__;
+    }
+    else
+    {
+        STRING* s1 = (STRING*)handle;
+        size_t s1Length = s1->length;
+        size_t vlen = strlen(source);
+        size_t escapedSize;
+        /*source can be a pointer inside s1, remember where so that it survives a realloc; it ends at or before s1Length, where writing starts*/
+        int sourceIsInside = (source >= s1->s) && (source < s1->s + s1->capacity);
+        size_t sourceOffset = sourceIsInside ? (size_t)(source - s1->s) : 0;
 
-        if (i < vlen)
+        if (json_escaped_size((const unsigned char*)source, vlen, &escapedSize) != 0)
         {
-            result = NULL;
+            /* Codes_SRS_STRING_01_013: [ If source has a character that STRING_new_JSON rejects, STRING_concat_JSON shall fail, return a non-zero value and leave handle unchanged. ] */
             LogError("invalid character in input string");
+            result = __FAILURE__;
+        }
+        else if (escapedSize >= ((size_t)-1) - 3 - s1Length)
+        {
+            LogError("Failure: resulting string is too long.");
+            result = __FAILURE__;
+        }
+        /* Codes_SRS_STRING_01_014: [ If the capacity is not enough, STRING_concat_JSON shall grow it like STRING_concat does; if that fails, STRING_concat_JSON shall return a non-zero value and leave handle unchanged. ] */
+        else if (STRING_ensure_capacity(s1, s1Length + escapedSize + 3) != 0)
+        {
+            result = __FAILURE__;
         }
         else
         {
-            if ((result = (STRING*)malloc(sizeof(STRING))) == NULL)
+            char* destination = s1->s + s1Length;
+            if (sourceIsInside)
             {
-                /*Codes_SRS_STRING_02_021: [If the complete JSON representation cannot be produced, then STRING_new_JSON shall fail and return NULL.] */
-                LogError("malloc json failure");
+                source = s1->s + sourceOffset;
             }
-            else if ((result->s = (char*)malloc(vlen + 5 * nControlCharacters + nEscapeCharacters + 3)) == NULL)
+            destination[0] = '"';
+            if (escapedSize == vlen)
             {
-                /*Codes_SRS_STRING_02_021: [If the complete JSON representation cannot be produced, then STRING_new_JSON shall fail and return NULL.] */
-                free(result);
-                result = NULL;
-                LogError("malloc failed");
+                (void)memmove(destination + 1, source, vlen);
             }
             else
             {
-                size_t pos = 0;
-                /*Codes_SRS_STRING_02_012: [The string shall begin with the quote character.] */
-                result->s[pos++] = '"';
-                for (i = 0; i < vlen; i++)
-                {
-                    if (source[i] <= 0x1F)
-                    {
-                        /*Codes_SRS_STRING_02_019: [If the character code is less than 0x20 then it shall be represented as \u00xx, where xx is the hex representation of the character code.]*/
-                        result->s[pos++] = '\\';
-                        result->s[pos++] = 'u';
-                        result->s[pos++] = '0';
-                        result->s[pos++] = '0';
-                        result->s[pos++] = hexToASCII[(source[i] & 0xF0) >> 4]; /*high nibble*/
-                        result->s[pos++] = hexToASCII[source[i] & 0x0F]; /*low nibble*/
-                    }
-                    else if (source[i] == '"')
-                    {
-                        /*Codes_SRS_STRING_02_016: [If the character is " (quote) then it shall be repsented as \".] */
-                        result->s[pos++] = '\\';
-                        result->s[pos++] = '"';
-                    }
-                    else if (source[i] == '\\')
-                    {
-                        /*Codes_SRS_STRING_02_017: [If the character is \ (backslash) then it shall represented as \\.] */
-                        result->s[pos++] = '\\';
-                        result->s[pos++] = '\\';
-                    }
-                    else if (source[i] == '/')
-                    {
-                        /*Codes_SRS_STRING_02_018: [If the character is / (slash) then it shall be represented as \/.] */
-                        result->s[pos++] = '\\';
-                        result->s[pos++] = '/';
-                    }
-                    else
-                    {
-                        /*Codes_SRS_STRING_02_013: [The string shall copy the characters of source "as they are" (until the '\0' character) with the following exceptions:] */
-                        result->s[pos++] = source[i];
-                    }
-                }
-                /*Codes_SRS_STRING_02_020: [The string shall end with " (quote).] */
-                result->s[pos++] = '"';
-                /*zero terminating it*/
-                result->s[pos] = '\0';
+                size_t written;
+                (void)json_escape(destination + 1, escapedSize, (const unsigned char*)source, vlen, &written);
             }
+            destination[escapedSize + 1] = '"';
+            destination[escapedSize + 2] = '\0';
+            s1->length = s1Length + escapedSize + 2;
+            /* Codes_SRS_STRING_01_015: [ On success STRING_concat_JSON shall return 0. ] */
+            result = 0;
         }
+    }
+    return result;
+}
 
+int STRING_JSON_length(const char* source, size_t* length)
+{
+    int result;
+    size_t escapedSize;
+    if ((source == NULL) || (length == NULL))
+    {
+        /* Codes_SRS_STRING_01_017: [ If source or length is NULL, STRING_JSON_length shall fail and return a non-zero value. ] */
+        LogError("Invalid argument: source=%p, length=%p", source, length);
+        result = __FAILURE__;
     }
-    return (STRING_HANDLE)result;
+    else if (json_escaped_size((const unsigned char*)source, strlen(source), &escapedSize) != 0)
+    {
+        /* Codes_SRS_STRING_01_018: [ If source has a character that STRING_new_JSON rejects, STRING_JSON_length shall fail and return a non-zero value. ] */
+        LogError("invalid character in input string");
+        result = __FAILURE__;
+    }
+    else if (escapedSize > ((size_t)-1) - 2)
+    {
+        LogError("Failure: JSON representation is too long.");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_STRING_01_016: [ STRING_JSON_length shall write in length the number of characters of the JSON representation of source that STRING_new_JSON produces, quotes included, and return 0. ] */
+        *length = escapedSize + 2;
+        result = 0;
+    }
+    return result;
+}
+
+int STRING_JSON_write(char* destination, size_t destinationSize, const char* source, size_t* written)
+{
+    int result;
+    size_t escapedSize;
+    if ((destination == NULL) || (source == NULL) || (written == NULL))
+    {
+        /* Codes_SRS_STRING_01_020: [ If destination, source or written is NULL, STRING_JSON_write shall fail and return a non-zero value. ] */
+        LogError("Invalid argument: destination=%p, source=%p, written=%p", destination, source, written);
+        result = __FAILURE__;
+    }
+    /*sizing and writing are a single pass, the quotes are the only room known in advance*/
+    else if ((destinationSize < 2) ||
+        (json_escape(destination + 1, destinationSize - 2, (const unsigned char*)source, strlen(source), &escapedSize) != 0))
+    {
+        /* Codes_SRS_STRING_01_021: [ If source has a character that STRING_new_JSON rejects or destinationSize is smaller than the JSON representation, STRING_JSON_write shall fail and return a non-zero value; what it wrote at destination is then unspecified. ] */
+        LogError("invalid character in input string or destination too small");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_STRING_01_019: [ STRING_JSON_write shall write at destination the JSON representation of source that STRING_new_JSON produces, without a '\0', write in written the number of characters it wrote and return 0. ] */
+        destination[0] = '"';
+        destination[escapedSize + 1] = '"';
+        *written = escapedSize + 2;
+        result = 0;
+    }
+    return result;
 }
 
 /*this function will concatenate to the string s1 the string s2, resulting in s1+s2*/
@@ -384,19 +805,32 @@ int STRING_concat(STRING_HANDLE handle, const char* s2)
     else
     {
         STRING* s1 = (STRING*)handle;
-        size_t s1Length = strlen(s1->s);
+        size_t s1Length = s1->length;
         size_t s2Length = strlen(s2);
-        char* temp = (char*)realloc(s1->s, s1Length + s2Length + 1);
-        if (temp == NULL)
+        /*s2 can be a pointer inside s1 (for example STRING_c_str of the same handle), remember where so that it survives a realloc*/
+        int s2IsInside = (s2 >= s1->s) && (s2 < s1->s + s1->capacity);
+        size_t s2Offset = s2IsInside ? (size_t)(s2 - s1->s) : 0;
+        if (s2Length >= ((size_t)-1) - s1Length)
+        {
+            /* Codes_SRS_STRING_07_013: [STRING_concat shall return a nonzero number if an error is encountered.] */
+            LogError("Failure: resulting string is too long.");
+            result = __FAILURE__;
+        }
+        /* Codes_SRS_STRING_01_001: [ If the capacity is not enough, STRING_concat, STRING_concat_with_STRING and STRING_sprintf shall grow the capacity to the larger of the required size and twice the current capacity. ] */
+        else if (STRING_ensure_capacity(s1, s1Length + s2Length + 1) != 0)
         {
             /* Codes_SRS_STRING_07_013: [STRING_concat shall return a nonzero number if an error is encountered.] */
-            LogError("Failure reallocating value.");
             result = __FAILURE__;
         }
         else
         {
-            s1->s = temp;
-            (void)memcpy(s1->s + s1Length, s2, s2Length + 1);
+            if (s2IsInside)
+            {
+                s2 = s1->s + s2Offset;
+            }
+            (void)memmove(s1->s + s1Length, s2, s2Length);
+            s1->s[s1Length + s2Length] = '\0';
+            s1->length = s1Length + s2Length;
             result = 0;
         }
     }
@@ -421,20 +855,27 @@ int STRING_concat_with_STRING(STRING_HANDLE s1, STRING_HANDLE s2)
         STRING* dest = (STRING*)s1;
         STRING* src = (STRING*)s2;
 
-        size_t s1Length = strlen(dest->s);
-        size_t s2Length = strlen(src->s);
-        char* temp = (char*)realloc(dest->s, s1Length + s2Length + 1);
-        if (temp == NULL)
+        size_t s1Length = dest->length;
+        size_t s2Length = src->length;
+        if (s2Length >= ((size_t)-1) - s1Length)
+        {
+            /* Codes_SRS_STRING_07_035: [String_Concat_with_STRING shall return a nonzero number if an error is encountered.] */
+            LogError("Failure: resulting string is too long");
+            result = __FAILURE__;
+        }
+        /* Codes_SRS_STRING_01_001: [ If the capacity is not enough, STRING_concat, STRING_concat_with_STRING and STRING_sprintf shall grow the capacity to the larger of the required size and twice the current capacity. ] */
+        else if (STRING_ensure_capacity(dest, s1Length + s2Length + 1) != 0)
         {
             /* Codes_SRS_STRING_07_035: [String_Concat_with_STRING shall return a nonzero number if an error is encountered.] */
-            LogError("Failure reallocating value");
             result = __FAILURE__;
         }
         else
         {
-            dest->s = temp;
             /* Codes_SRS_STRING_07_034: [String_Concat_with_STRING shall concatenate a given STRING_HANDLE variable with a source STRING_HANDLE.] */
-            (void)memcpy(dest->s + s1Length, src->s, s2Length + 1);
+            /*src->s is re-read after the realloc, so concatenating a string with itself is fine*/
+            (void)memcpy(dest->s + s1Length, src->s, s2Length);
+            dest->s[s1Length + s2Length] = '\0';
+            dest->length = s1Length + s2Length;
             result = 0;
         }
     }
@@ -460,7 +901,7 @@ int STRING_copy(STRING_HANDLE handle, const char* s2)
         if (s1->s != s2)
         {
             size_t s2Length = strlen(s2);
-            char* temp = (char*)realloc(s1->s, s2Length + 1);
+            char* temp = STRING_realloc_value(s1, s2Length + 1);
             if (temp == NULL)
             {
                 LogError("Failure reallocating value.");
@@ -471,6 +912,8 @@ int STRING_copy(STRING_HANDLE handle, const char* s2)
             {
                 s1->s = temp;
                 memmove(s1->s, s2, s2Length + 1);
+                s1->length = s2Length;
+                s1->capacity = s2Length + 1;
                 result = 0;
             }
         }
@@ -505,7 +948,7 @@ int STRING_copy_n(STRING_HANDLE handle, const char* s2, size_t n)
             s2Length = n;
         }
 
-        temp = (char*)realloc(s1->s, s2Length + 1);
+        temp = STRING_realloc_value(s1, s2Length + 1);
         if (temp == NULL)
         {
             LogError("Failure reallocating value.");
@@ -517,6 +960,8 @@ int STRING_copy_n(STRING_HANDLE handle, const char* s2, size_t n)
             s1->s = temp;
             (void)memcpy(s1->s, s2, s2Length);
             s1->s[s2Length] = 0;
+            s1->length = s2Length;
+            s1->capacity = s2Length + 1;
             result = 0;
         }
 
@@ -531,14 +976,6 @@ int STRING_sprintf(STRING_HANDLE handle, const char* format, ...)
 {
     int result;
 
-#ifdef STRINGS_C_SPRINTF_BUFFER_SIZE
-    size_t maxBufSize = STRINGS_C_SPRINTF_BUFFER_SIZE;
-    char buf[STRINGS_C_SPRINTF_BUFFER_SIZE];
-#else
-    size_t maxBufSize = 0;
-    char* buf = NULL;
-#endif
-
     if (handle == NULL || format == NULL)
     {
         /* Codes_SRS_STRING_07_042: [if the parameters s1 or format are NULL then STRING_sprintf shall return non zero value.] */
@@ -547,16 +984,25 @@ int STRING_sprintf(STRING_HANDLE handle, const char* format, ...)
     }
     else
     {
+        STRING* s1 = (STRING*)handle;
+        size_t s1Length = s1->length;
+        size_t available = s1->capacity - s1Length;
+        char buf[STRING_SPRINTF_BUFFER_SIZE];
+        /* Codes_SRS_STRING_01_022: [ STRING_construct_sprintf and STRING_sprintf shall format only once when the result fits in STRING_SPRINTF_BUFFER_SIZE bytes or in the spare capacity of the STRING. ] */
+        bool in_place = (available >= sizeof(buf));
+        char* target = in_place ? (s1->s + s1Length) : buf;
+        size_t target_size = in_place ? available : sizeof(buf);
         va_list arg_list;
         int s2Length;
-        va_start(arg_list, format);
 
-        s2Length = vsnprintf(buf, maxBufSize, format, arg_list);
+        va_start(arg_list, format);
+        s2Length = vsnprintf(target, target_size, format, arg_list);
         va_end(arg_list);
         if (s2Length < 0)
         {
             /* Codes_SRS_STRING_07_043: [If any error is encountered STRING_sprintf shall return a non zero value.] */
             LogError("Failure vsnprintf return < 0");
+            s1->s[s1Length] = '\0';
             result = __FAILURE__;
         }
         else if (s2Length == 0)
@@ -564,36 +1010,45 @@ int STRING_sprintf(STRING_HANDLE handle, const char* format, ...)
             // Don't need to reallocate and nothing should be added
             result = 0;
         }
+        else if (in_place && ((size_t)s2Length < target_size))
+        {
+            /* Codes_SRS_STRING_07_044: [On success STRING_sprintf shall return 0.]*/
+            s1->length = s1Length + s2Length;
+            result = 0;
+        }
+        /* Codes_SRS_STRING_01_001: [ If the capacity is not enough, STRING_concat, STRING_concat_with_STRING and STRING_sprintf shall grow the capacity to the larger of the required size and twice the current capacity. ] */
+        else if (STRING_ensure_capacity(s1, s1Length + s2Length + 1) != 0)
+        {
+            /* Codes_SRS_STRING_07_043: [If any error is encountered STRING_sprintf shall return a non zero value.] */
+            LogError("Failure unable to reallocate memory");
+            s1->s[s1Length] = '\0';
+            result = __FAILURE__;
+        }
+        else if ((size_t)s2Length < target_size)
+        {
+            /* the result is in buf */
+            (void)memcpy(s1->s + s1Length, buf, (size_t)s2Length + 1);
+            /* Codes_SRS_STRING_07_044: [On success STRING_sprintf shall return 0.]*/
+            s1->length = s1Length + s2Length;
+            result = 0;
+        }
         else
         {
-            STRING* s1 = (STRING*)handle;
-            char* temp;
-            size_t s1Length = strlen(s1->s);
-            temp = (char*)realloc(s1->s, s1Length + s2Length + 1);
-            if (temp != NULL)
+            va_start(arg_list, format);
+            if (vsnprintf(s1->s + s1Length, (size_t)s2Length + 1, format, arg_list) < 0)
             {
-                s1->s = temp;
-                va_start(arg_list, format);
-                if (vsnprintf(s1->s + s1Length, s1Length + s2Length + 1, format, arg_list) < 0)
-                {
-                    /* Codes_SRS_STRING_07_043: [If any error is encountered STRING_sprintf shall return a non zero value.] */
-                    LogError("Failure vsnprintf formatting error");
-                    s1->s[s1Length] = '\0';
-                    result = __FAILURE__;
-                }
-                else
-                {
-                    /* Codes_SRS_STRING_07_044: [On success STRING_sprintf shall return 0.]*/
-                    result = 0;
-                }
-                va_end(arg_list);
+                /* Codes_SRS_STRING_07_043: [If any error is encountered STRING_sprintf shall return a non zero value.] */
+                LogError("Failure vsnprintf formatting error");
+                s1->s[s1Length] = '\0';
+                result = __FAILURE__;
             }
             else
             {
-                /* Codes_SRS_STRING_07_043: [If any error is encountered STRING_sprintf shall return a non zero value.] */
-                LogError("Failure unable to reallocate memory");
-                result = __FAILURE__;
+                /* Codes_SRS_STRING_07_044: [On success STRING_sprintf shall return 0.]*/
+                s1->length = s1Length + s2Length;
+                result = 0;
             }
+            va_end(arg_list);
         }
     }
     return result;
@@ -614,8 +1069,8 @@ int STRING_quote(STRING_HANDLE handle)
     else
     {
         STRING* s1 = (STRING*)handle;
-        size_t s1Length = strlen(s1->s);
-        char* temp = (char*)realloc(s1->s, s1Length + 2 + 1);/*2 because 2 quotes, 1 because '\0'*/
+        size_t s1Length = s1->length;
+        char* temp = STRING_realloc_value(s1, s1Length + 2 + 1);/*2 because 2 quotes, 1 because '\0'*/
         if (temp == NULL)
         {
             LogError("Failure reallocating value.");
@@ -629,6 +1084,8 @@ int STRING_quote(STRING_HANDLE handle)
             s1->s[0] = '"';
             s1->s[s1Length + 1] = '"';
             s1->s[s1Length + 2] = '\0';
+            s1->length = s1Length + 2;
+            s1->capacity = s1Length + 3;
             result = 0;
         }
     }
@@ -648,7 +1105,7 @@ int STRING_empty(STRING_HANDLE handle)
     else
     {
         STRING* s1 = (STRING*)handle;
-        char* temp = (char*)realloc(s1->s, 1);
+        char* temp = STRING_realloc_value(s1, 1);
         if (temp == NULL)
         {
             LogError("Failure reallocating value.");
@@ -659,6 +1116,8 @@ int STRING_empty(STRING_HANDLE handle)
         {
             s1->s = temp;
             s1->s[0] = '\0';
+            s1->length = 0;
+            s1->capacity = 1;
             result = 0;
         }
     }
@@ -673,9 +1132,9 @@ void STRING_delete(STRING_HANDLE handle)
     if (handle != NULL)
     {
         STRING* value = (STRING*)handle;
-        free(value->s);
+        STRING_free_value(value);
         value->s = NULL;
-        free(value);
+        STRING_free_handle(value);
     }
 }
 
@@ -703,7 +1162,7 @@ size_t STRING_length(STRING_HANDLE handle)
     if (handle != NULL)
     {
         STRING* value = (STRING*)handle;
-        result = strlen(value->s);
+        result = value->length;
     }
     return result;
 }
@@ -730,19 +1189,21 @@ STRING_HANDLE STRING_construct_n(const char* psz, size_t n)
         else
         {
             STRING* str;
-            if ((str = (STRING*)malloc(sizeof(STRING))) != NULL)
+            if ((str = STRING_alloc_handle()) != NULL)
             {
-                if ((str->s = (char*)malloc(len + 1)) != NULL)
+                if ((str->s = STRING_alloc_value(str, len + 1)) != NULL)
                 {
                     (void)memcpy(str->s, psz, n);
                     str->s[n] = '\0';
+                    str->length = n;
+                    str->capacity = len + 1;
                     result = (STRING_HANDLE)str;
                 }
                 /* Codes_SRS_STRING_02_010: [In all other error cases, STRING_construct_n shall return NULL.]  */
                 else
                 {
                     LogError("Failure allocating value.");
-                    free(str);
+                    STRING_free_handle(str);
                     result = NULL;
                 }
             }
@@ -797,7 +1258,7 @@ STRING_HANDLE STRING_from_byte_array(const unsigned char* source, size_t size)
     else
     {
         /*Codes_SRS_STRING_02_023: [ Otherwise, STRING_from_BUFFER shall build a string that has the same content (byte-by-byte) as source and return a non-NULL handle. ]*/
-        result = (STRING*)malloc(sizeof(STRING));
+        result = STRING_alloc_handle();
         if (result == NULL)
         {
             /*Codes_SRS_STRING_02_024: [ If building the string fails, then STRING_from_BUFFER shall fail and return NULL. ]*/
@@ -807,18 +1268,21 @@ STRING_HANDLE STRING_from_byte_array(const unsigned char* source, size_t size)
         else
         {
             /*Codes_SRS_STRING_02_023: [ Otherwise, STRING_from_BUFFER shall build a string that has the same content (byte-by-byte) as source and return a non-NULL handle. ]*/
-            result->s = (char*)malloc(size + 1);
+            result->s = STRING_alloc_value(result, size + 1);
             if (result->s == NULL)
             {
                 /*Codes_SRS_STRING_02_024: [ If building the string fails, then STRING_from_BUFFER shall fail and return NULL. ]*/
                 LogError("oom - unable to malloc");
-                free(result);
+                STRING_free_handle(result);
                 result = NULL;
             }
             else
             {
                 (void)memcpy(result->s, source, size);
                 result->s[size] = '\0'; /*all is fine*/
+                /*source can contain '\0' bytes, the length of the string is up to the first one of them*/
+                result->length = strlen(result->s);
+                result->capacity = size + 1;
             }
         }
     }
@@ -844,7 +1308,7 @@ int STRING_replace(STRING_HANDLE handle, char target, char replace)
         size_t index;
         /* Codes_SRS_STRING_07_047: [ STRING_replace shall replace all instances of target with replace. ] */
         STRING* str_value = (STRING*)handle;
-        length = strlen(str_value->s);
+        length = str_value->length;
         for (index = 0; index < length; index++)
         {
             if (str_value->s[index] == target)
@@ -852,8 +1316,58 @@ int STRING_replace(STRING_HANDLE handle, char target, char replace)
                 str_value->s[index] = replace;
             }
         }
+        if (replace == '\0')
+        {
+            /*the string now ends at the first replaced character*/
+            str_value->length = strlen(str_value->s);
+        }
         /* Codes_SRS_STRING_07_049: [ On success STRING_replace shall return zero. ] */
         result = 0;
     }
     return result;
 }
+
+int STRING_reserve(STRING_HANDLE handle, size_t capacity)
+{
+    int result;
+    if (handle == NULL)
+    {
+        /* Codes_SRS_STRING_01_002: [ If handle is NULL, STRING_reserve shall fail and return a non-zero value. ] */
+        LogError("Invalid argument (NULL)");
+        result = __FAILURE__;
+    }
+    else if (capacity == (size_t)-1)
+    {
+        /* Codes_SRS_STRING_01_003: [ If capacity + 1 overflows, STRING_reserve shall fail and return a non-zero value. ] */
+        LogError("Invalid argument: capacity is too big");
+        result = __FAILURE__;
+    }
+    else
+    {
+        STRING* value = (STRING*)handle;
+        if (capacity + 1 <= value->capacity)
+        {
+            /* Codes_SRS_STRING_01_004: [ If the string can already hold capacity characters, STRING_reserve shall not allocate and shall return 0. ] */
+            result = 0;
+        }
+        else
+        {
+            /* Codes_SRS_STRING_01_005: [ Otherwise STRING_reserve shall reallocate the string so that it can hold capacity characters plus the terminating '\0', leaving its content unchanged. ] */
+            char* temp = STRING_realloc_value(value, capacity + 1);
+            if (temp == NULL)
+            {
+                /* Codes_SRS_STRING_01_006: [ If reallocating fails, STRING_reserve shall return a non-zero value and leave the string unchanged. ] */
+                LogError("Failure reallocating value.");
+                result = __FAILURE__;
+            }
+            else
+            {
+                value->s = temp;
+                value->capacity = capacity + 1;
+                /* Codes_SRS_STRING_01_007: [ On success STRING_reserve shall return 0. ] */
+                result = 0;
+            }
+        }
+    }
+    return result;
+}
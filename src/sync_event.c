@@ -0,0 +1,436 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/sync_event.h"
+#include "azure_c_shared_utility/sync_wait.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+/*
+* The state of an event (0 or 1) and the count of a semaphore are the words waiters park on,
+* while they are 0. A waiter counts itself in waiters before it parks and a setter reads waiters
+* after it changed the word. Both are full barriers, so either the waiter sees the new value
+* (sync_wait_on_address returns at once) or the setter sees the waiter and wakes it. A setter
+* that sees no waiter makes no system call.
+*/
+#if defined(_MSC_VER)
+#include <windows.h>
+#define SYNC_EVENT_INCREMENT(target) ((void)InterlockedIncrement((volatile LONG*)(target)))
+#define SYNC_EVENT_DECREMENT(target) ((void)InterlockedDecrement((volatile LONG*)(target)))
+#define SYNC_EVENT_FETCH_OR(target, value) ((int32_t)InterlockedOr((volatile LONG*)(target), (value)))
+#define SYNC_EVENT_FETCH_AND(target, value) ((int32_t)InterlockedAnd((volatile LONG*)(target), (value)))
+#define SYNC_EVENT_COMPARE_EXCHANGE(target, expected, value) ((int32_t)InterlockedCompareExchange((volatile LONG*)(target), (value), (expected)))
+/* volatile reads are acquire reads with MSVC */
+#define SYNC_EVENT_LOAD(source) (*(source))
+#define SYNC_EVENT_PAUSE() YieldProcessor()
+#else
+#define SYNC_EVENT_INCREMENT(target) ((void)__sync_add_and_fetch((target), 1))
+#define SYNC_EVENT_DECREMENT(target) ((void)__sync_sub_and_fetch((target), 1))
+#define SYNC_EVENT_FETCH_OR(target, value) __sync_fetch_and_or((target), (value))
+#define SYNC_EVENT_FETCH_AND(target, value) __sync_fetch_and_and((target), (value))
+#define SYNC_EVENT_COMPARE_EXCHANGE(target, expected, value) __sync_val_compare_and_swap((target), (expected), (value))
+#if defined(__ATOMIC_SEQ_CST)
+#define SYNC_EVENT_LOAD(source) __atomic_load_n((source), __ATOMIC_SEQ_CST)
+#else
+#define SYNC_EVENT_LOAD(source) __sync_fetch_and_add((source), 0)
+#endif
+#if defined(__i386__) || defined(__x86_64__)
+#define SYNC_EVENT_PAUSE() __builtin_ia32_pause()
+#elif defined(__aarch64__) || (defined(__ARM_ARCH) && (__ARM_ARCH >= 7))
+#define SYNC_EVENT_PAUSE() __asm__ __volatile__("yield")
+#else
+#define SYNC_EVENT_PAUSE() ((void)0)
+#endif
+#endif
+
+/* how many times a waiter checks the word, pausing in between, before it parks; about a microsecond or two */
+#define SYNC_EVENT_SPIN_COUNT 128
+
+DEFINE_ENUM_STRINGS(SYNC_EVENT_RESULT, SYNC_EVENT_RESULT_VALUES);
+
+typedef struct SYNC_EVENT_TAG
+{
+    volatile int32_t state;
+    volatile int32_t waiters;
+    bool manual_reset;
+} SYNC_EVENT;
+
+typedef struct SYNC_SEMAPHORE_TAG
+{
+    volatile int32_t count;
+    volatile int32_t waiters;
+} SYNC_SEMAPHORE;
+
+typedef bool(*TRY_TAKE)(void* sync_object);
+
+static bool try_take_event(void* sync_object)
+{
+    SYNC_EVENT* sync_event = (SYNC_EVENT*)sync_object;
+    bool result;
+
+    /* reading first keeps the spinning waiters from bouncing the cache line around */
+    if (SYNC_EVENT_LOAD(&sync_event->state) == 0)
+    {
+        result = false;
+    }
+    else if (sync_event->manual_reset)
+    {
+        result = true;
+    }
+    else
+    {
+        result = (SYNC_EVENT_COMPARE_EXCHANGE(&sync_event->state, 1, 0) == 1);
+    }
+
+    return result;
+}
+
+static bool try_take_semaphore(void* sync_object)
+{
+    SYNC_SEMAPHORE* sync_semaphore = (SYNC_SEMAPHORE*)sync_object;
+    bool result = false;
+    int32_t count;
+
+    while (((count = SYNC_EVENT_LOAD(&sync_semaphore->count)) > 0) &&
+        !(result = (SYNC_EVENT_COMPARE_EXCHANGE(&sync_semaphore->count, count, count - 1) == count)))
+    {
+    }
+
+    return result;
+}
+
+static SYNC_EVENT_RESULT wait_until_taken(volatile int32_t* word, volatile int32_t* waiters, TRY_TAKE try_take, void* sync_object, int timeout_milliseconds)
+{
+    SYNC_EVENT_RESULT result;
+    unsigned int spins;
+    bool taken = try_take(sync_object);
+
+    for (spins = 0; !taken && (spins < SYNC_EVENT_SPIN_COUNT); spins++)
+    {
+        SYNC_EVENT_PAUSE();
+        taken = try_take(sync_object);
+    }
+
+    if (taken)
+    {
+        result = SYNC_EVENT_OK;
+    }
+    else
+    {
+        TICK_COUNTER_HANDLE tick_counter = NULL;
+
+        /* a tick counter is not thread safe, so every timed wait that parks has its own */
+        if ((timeout_milliseconds != 0) &&
+            ((tick_counter = tickcounter_create()) == NULL))
+        {
+            LogError("failure in tickcounter_create");
+            result = SYNC_EVENT_ERROR;
+        }
+        else
+        {
+            do
+            {
+                int remaining_milliseconds = 0;
+                tickcounter_ms_t elapsed_ms;
+
+                if (tick_counter == NULL)
+                {
+                    result = SYNC_EVENT_OK;
+                }
+                else if (tickcounter_get_current_ms(tick_counter, &elapsed_ms) != 0)
+                {
+                    LogError("failure in tickcounter_get_current_ms");
+                    result = SYNC_EVENT_ERROR;
+                }
+                else if (elapsed_ms >= (tickcounter_ms_t)timeout_milliseconds)
+                {
+                    result = SYNC_EVENT_TIMEOUT;
+                }
+                else
+                {
+                    remaining_milliseconds = timeout_milliseconds - (int)elapsed_ms;
+                    result = SYNC_EVENT_OK;
+                }
+
+                if (result == SYNC_EVENT_OK)
+                {
+                    SYNC_WAIT_RESULT wait_result;
+
+                    SYNC_EVENT_INCREMENT(waiters);
+                    wait_result = sync_wait_on_address(word, 0, remaining_milliseconds);
+                    SYNC_EVENT_DECREMENT(waiters);
+
+                    if (wait_result == SYNC_WAIT_ERROR)
+                    {
+                        LogError("failure in sync_wait_on_address");
+                        result = SYNC_EVENT_ERROR;
+                    }
+                    else
+                    {
+                        /* a timed out wait is only reported once the clock agrees, the next round checks */
+                        taken = try_take(sync_object);
+                    }
+                }
+            } while ((result == SYNC_EVENT_OK) && !taken);
+
+            if (tick_counter != NULL)
+            {
+                tickcounter_destroy(tick_counter);
+            }
+        }
+    }
+
+    return result;
+}
+
+SYNC_EVENT_HANDLE sync_event_create(bool manual_reset, bool initially_set)
+{
+    SYNC_EVENT* result = (SYNC_EVENT*)malloc(sizeof(SYNC_EVENT));
+    if (result == NULL)
+    {
+        /* Codes_SRS_SYNC_EVENT_01_002: [ If allocating memory for the event fails, sync_event_create shall fail and return NULL. ]*/
+        LogError("failure allocating the event");
+    }
+    else
+    {
+        /* Codes_SRS_SYNC_EVENT_01_001: [ sync_event_create shall create an event that is reset manually if manual_reset is true, and set if initially_set is true, and return a non-NULL handle to it. ]*/
+        result->state = initially_set ? 1 : 0;
+        result->waiters = 0;
+        result->manual_reset = manual_reset;
+    }
+
+    return result;
+}
+
+void sync_event_destroy(SYNC_EVENT_HANDLE sync_event)
+{
+    if (sync_event == NULL)
+    {
+        /* Codes_SRS_SYNC_EVENT_01_004: [ If sync_event is NULL, sync_event_destroy shall do nothing. ]*/
+        LogError("NULL sync_event");
+    }
+    else
+    {
+        /* Codes_SRS_SYNC_EVENT_01_003: [ sync_event_destroy shall free the event. ]*/
+        free(sync_event);
+    }
+}
+
+SYNC_EVENT_RESULT sync_event_set(SYNC_EVENT_HANDLE sync_event)
+{
+    SYNC_EVENT_RESULT result;
+
+    if (sync_event == NULL)
+    {
+        /* Codes_SRS_SYNC_EVENT_01_005: [ If sync_event is NULL, sync_event_set shall fail and return SYNC_EVENT_INVALID_ARG. ]*/
+        LogError("NULL sync_event");
+        result = SYNC_EVENT_INVALID_ARG;
+    }
+    else
+    {
+        /* Codes_SRS_SYNC_EVENT_01_006: [ sync_event_set shall set the event. ]*/
+        /* Codes_SRS_SYNC_EVENT_01_007: [ If the event was not set and a thread is parked on it, sync_event_set shall wake one waiter of an auto reset event, or all the waiters of a manual reset event, with sync_wake_by_address. ]*/
+        if ((SYNC_EVENT_FETCH_OR(&sync_event->state, 1) == 0) &&
+            (SYNC_EVENT_LOAD(&sync_event->waiters) != 0))
+        {
+            sync_wake_by_address(&sync_event->state, sync_event->manual_reset);
+        }
+
+        /* Codes_SRS_SYNC_EVENT_01_008: [ On success sync_event_set shall return SYNC_EVENT_OK. ]*/
+        result = SYNC_EVENT_OK;
+    }
+
+    return result;
+}
+
+SYNC_EVENT_RESULT sync_event_reset(SYNC_EVENT_HANDLE sync_event)
+{
+    SYNC_EVENT_RESULT result;
+
+    if (sync_event == NULL)
+    {
+        /* Codes_SRS_SYNC_EVENT_01_009: [ If sync_event is NULL, sync_event_reset shall fail and return SYNC_EVENT_INVALID_ARG. ]*/
+        LogError("NULL sync_event");
+        result = SYNC_EVENT_INVALID_ARG;
+    }
+    else
+    {
+        /* Codes_SRS_SYNC_EVENT_01_010: [ sync_event_reset shall reset the event and return SYNC_EVENT_OK. ]*/
+        (void)SYNC_EVENT_FETCH_AND(&sync_event->state, 0);
+        result = SYNC_EVENT_OK;
+    }
+
+    return result;
+}
+
+SYNC_EVENT_RESULT sync_event_wait(SYNC_EVENT_HANDLE sync_event, int timeout_milliseconds)
+{
+    SYNC_EVENT_RESULT result;
+
+    if ((sync_event == NULL) ||
+        (timeout_milliseconds < 0))
+    {
+        /* Codes_SRS_SYNC_EVENT_01_011: [ If sync_event is NULL or timeout_milliseconds is negative, sync_event_wait shall fail and return SYNC_EVENT_INVALID_ARG. ]*/
+        LogError("Invalid arguments: SYNC_EVENT_HANDLE sync_event=%p, int timeout_milliseconds=%d", sync_event, timeout_milliseconds);
+        result = SYNC_EVENT_INVALID_ARG;
+    }
+    else
+    {
+        /* Codes_SRS_SYNC_EVENT_01_012: [ sync_event_wait shall check the event up to SYNC_EVENT_SPIN_COUNT times, pausing the processor in between, before it parks. ]*/
+        /* Codes_SRS_SYNC_EVENT_01_013: [ Once the event is set, sync_event_wait shall return SYNC_EVENT_OK, resetting an auto reset event. ]*/
+        /* Codes_SRS_SYNC_EVENT_01_014: [ While the event is not set, sync_event_wait shall park with sync_wait_on_address, at most for the time left of timeout_milliseconds as measured by a tick counter, and check the event again when it returns. ]*/
+        /* Codes_SRS_SYNC_EVENT_01_015: [ If timeout_milliseconds is not 0 and the event is not set in time, sync_event_wait shall return SYNC_EVENT_TIMEOUT. ]*/
+        /* Codes_SRS_SYNC_EVENT_01_016: [ If creating or reading the tick counter or sync_wait_on_address fails, sync_event_wait shall fail and return SYNC_EVENT_ERROR. ]*/
+        result = wait_until_taken(&sync_event->state, &sync_event->waiters, try_take_event, sync_event, timeout_milliseconds);
+    }
+
+    return result;
+}
+
+SYNC_EVENT_RESULT sync_event_try_wait(SYNC_EVENT_HANDLE sync_event)
+{
+    SYNC_EVENT_RESULT result;
+
+    if (sync_event == NULL)
+    {
+        /* Codes_SRS_SYNC_EVENT_01_017: [ If sync_event is NULL, sync_event_try_wait shall fail and return SYNC_EVENT_INVALID_ARG. ]*/
+        LogError("NULL sync_event");
+        result = SYNC_EVENT_INVALID_ARG;
+    }
+    else
+    {
+        /* Codes_SRS_SYNC_EVENT_01_018: [ If the event is set, sync_event_try_wait shall return SYNC_EVENT_OK, resetting an auto reset event, otherwise it shall return SYNC_EVENT_TIMEOUT. ]*/
+        result = try_take_event(sync_event) ? SYNC_EVENT_OK : SYNC_EVENT_TIMEOUT;
+    }
+
+    return result;
+}
+
+SYNC_SEMAPHORE_HANDLE sync_semaphore_create(uint32_t initial_count)
+{
+    SYNC_SEMAPHORE* result;
+
+    if (initial_count > INT32_MAX)
+    {
+        /* Codes_SRS_SYNC_EVENT_01_020: [ If initial_count is greater than INT32_MAX, sync_semaphore_create shall fail and return NULL. ]*/
+        LogError("Invalid arguments: uint32_t initial_count=%u", (unsigned int)initial_count);
+        result = NULL;
+    }
+    else if ((result = (SYNC_SEMAPHORE*)malloc(sizeof(SYNC_SEMAPHORE))) == NULL)
+    {
+        /* Codes_SRS_SYNC_EVENT_01_021: [ If allocating memory for the semaphore fails, sync_semaphore_create shall fail and return NULL. ]*/
+        LogError("failure allocating the semaphore");
+    }
+    else
+    {
+        /* Codes_SRS_SYNC_EVENT_01_019: [ sync_semaphore_create shall create a semaphore holding initial_count units and return a non-NULL handle to it. ]*/
+        result->count = (int32_t)initial_count;
+        result->waiters = 0;
+    }
+
+    return result;
+}
+
+void sync_semaphore_destroy(SYNC_SEMAPHORE_HANDLE sync_semaphore)
+{
+    if (sync_semaphore == NULL)
+    {
+        /* Codes_SRS_SYNC_EVENT_01_023: [ If sync_semaphore is NULL, sync_semaphore_destroy shall do nothing. ]*/
+        LogError("NULL sync_semaphore");
+    }
+    else
+    {
+        /* Codes_SRS_SYNC_EVENT_01_022: [ sync_semaphore_destroy shall free the semaphore. ]*/
+        free(sync_semaphore);
+    }
+}
+
+SYNC_EVENT_RESULT sync_semaphore_release(SYNC_SEMAPHORE_HANDLE sync_semaphore, uint32_t count)
+{
+    SYNC_EVENT_RESULT result;
+
+    if ((sync_semaphore == NULL) ||
+        (count == 0) ||
+        (count > INT32_MAX))
+    {
+        /* Codes_SRS_SYNC_EVENT_01_024: [ If sync_semaphore is NULL or count is 0 or greater than INT32_MAX, sync_semaphore_release shall fail and return SYNC_EVENT_INVALID_ARG. ]*/
+        LogError("Invalid arguments: SYNC_SEMAPHORE_HANDLE sync_semaphore=%p, uint32_t count=%u", sync_semaphore, (unsigned int)count);
+        result = SYNC_EVENT_INVALID_ARG;
+    }
+    else
+    {
+        int32_t current_count;
+        bool added = false;
+
+        /* Codes_SRS_SYNC_EVENT_01_025: [ sync_semaphore_release shall add count units to the semaphore. ]*/
+        while (((current_count = SYNC_EVENT_LOAD(&sync_semaphore->count)) <= (int32_t)(INT32_MAX - count)) &&
+            !(added = (SYNC_EVENT_COMPARE_EXCHANGE(&sync_semaphore->count, current_count, current_count + (int32_t)count) == current_count)))
+        {
+        }
+
+        if (!added)
+        {
+            /* Codes_SRS_SYNC_EVENT_01_026: [ If the semaphore would hold more than INT32_MAX units, sync_semaphore_release shall fail and return SYNC_EVENT_INVALID_ARG. ]*/
+            LogError("semaphore holding %ld units cannot take %u more", (long)current_count, (unsigned int)count);
+            result = SYNC_EVENT_INVALID_ARG;
+        }
+        else
+        {
+            /* Codes_SRS_SYNC_EVENT_01_027: [ If a thread is parked on the semaphore, sync_semaphore_release shall wake one waiter when count is 1 and all of them otherwise, with sync_wake_by_address. ]*/
+            if (SYNC_EVENT_LOAD(&sync_semaphore->waiters) != 0)
+            {
+                sync_wake_by_address(&sync_semaphore->count, count > 1);
+            }
+
+            /* Codes_SRS_SYNC_EVENT_01_028: [ On success sync_semaphore_release shall return SYNC_EVENT_OK. ]*/
+            result = SYNC_EVENT_OK;
+        }
+    }
+
+    return result;
+}
+
+SYNC_EVENT_RESULT sync_semaphore_wait(SYNC_SEMAPHORE_HANDLE sync_semaphore, int timeout_milliseconds)
+{
+    SYNC_EVENT_RESULT result;
+
+    if ((sync_semaphore == NULL) ||
+        (timeout_milliseconds < 0))
+    {
+        /* Codes_SRS_SYNC_EVENT_01_029: [ If sync_semaphore is NULL or timeout_milliseconds is negative, sync_semaphore_wait shall fail and return SYNC_EVENT_INVALID_ARG. ]*/
+        LogError("Invalid arguments: SYNC_SEMAPHORE_HANDLE sync_semaphore=%p, int timeout_milliseconds=%d", sync_semaphore, timeout_milliseconds);
+        result = SYNC_EVENT_INVALID_ARG;
+    }
+    else
+    {
+        /* Codes_SRS_SYNC_EVENT_01_030: [ sync_semaphore_wait shall take one unit of the semaphore and return SYNC_EVENT_OK, spinning and parking while it holds none as sync_event_wait does. ]*/
+        /* Codes_SRS_SYNC_EVENT_01_031: [ If timeout_milliseconds is not 0 and no unit is released in time, sync_semaphore_wait shall return SYNC_EVENT_TIMEOUT. ]*/
+        /* Codes_SRS_SYNC_EVENT_01_032: [ If creating or reading the tick counter or sync_wait_on_address fails, sync_semaphore_wait shall fail and return SYNC_EVENT_ERROR. ]*/
+        result = wait_until_taken(&sync_semaphore->count, &sync_semaphore->waiters, try_take_semaphore, sync_semaphore, timeout_milliseconds);
+    }
+
+    return result;
+}
+
+SYNC_EVENT_RESULT sync_semaphore_try_wait(SYNC_SEMAPHORE_HANDLE sync_semaphore)
+{
+    SYNC_EVENT_RESULT result;
+
+    if (sync_semaphore == NULL)
+    {
+        /* Codes_SRS_SYNC_EVENT_01_033: [ If sync_semaphore is NULL, sync_semaphore_try_wait shall fail and return SYNC_EVENT_INVALID_ARG. ]*/
+        LogError("NULL sync_semaphore");
+        result = SYNC_EVENT_INVALID_ARG;
+    }
+    else
+    {
+        /* Codes_SRS_SYNC_EVENT_01_034: [ If the semaphore holds a unit, sync_semaphore_try_wait shall take it and return SYNC_EVENT_OK, otherwise it shall return SYNC_EVENT_TIMEOUT. ]*/
+        result = try_take_semaphore(sync_semaphore) ? SYNC_EVENT_OK : SYNC_EVENT_TIMEOUT;
+    }
+
+    return result;
+}
@@ -0,0 +1,525 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#if defined(__linux__)
+/* cpu_set_t and pthread_setaffinity_np */
+#define _GNU_SOURCE
+#endif
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/threadpool.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/doublylinkedlist.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#elif defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#else
+#include <unistd.h>
+#endif
+
+/*
+* pending counts the items sitting in the deques and sleeping counts the workers waiting on
+* the condition. A worker raises sleeping (under the lock) before it checks pending one last
+* time, a scheduler raises pending before it checks sleeping. Both are full barriers, so
+* either the worker sees the item or the scheduler sees the worker asleep and posts the
+* condition, taking the lock to make sure the worker is really waiting by then.
+*/
+#if defined(_MSC_VER)
+#define THREADPOOL_INCREMENT(value) InterlockedIncrement(&(value))
+#define THREADPOOL_DECREMENT(value) InterlockedDecrement(&(value))
+#define THREADPOOL_READ(value) InterlockedCompareExchange(&(value), 0, 0)
+#define THREADPOOL_THREAD_LOCAL __declspec(thread)
+#else
+#define THREADPOOL_INCREMENT(value) __sync_add_and_fetch(&(value), 1)
+#define THREADPOOL_DECREMENT(value) __sync_sub_and_fetch(&(value), 1)
+#define THREADPOOL_READ(value) __sync_fetch_and_add(&(value), 0)
+#define THREADPOOL_THREAD_LOCAL __thread
+#endif
+
+typedef struct WORK_ITEM_TAG
+{
+    THREADPOOL_WORK_FUNCTION work_function;
+    void* work_context;
+    ON_THREADPOOL_WORK_COMPLETE on_work_complete;
+    void* on_work_complete_context;
+    DLIST_ENTRY link;
+} WORK_ITEM;
+
+typedef struct WORKER_TAG
+{
+    struct THREADPOOL_TAG* threadpool;
+    size_t index;
+    THREAD_HANDLE thread;
+    /* the owner pushes and pops at the tail, thieves take from the head */
+    SPINLOCK_HANDLE deque_lock;
+    DLIST_ENTRY deque;
+} WORKER;
+
+typedef struct THREADPOOL_TAG
+{
+    WORKER* workers;
+    size_t worker_count;
+    size_t processor_count;
+    bool pin_workers;
+    LOCK_HANDLE lock;
+    COND_HANDLE work_available;
+    volatile long pending;
+    volatile long sleeping;
+    volatile long stopping;
+    volatile long next_worker;
+} THREADPOOL;
+
+/* the worker the calling thread is, if it is one */
+static THREADPOOL_THREAD_LOCAL WORKER* current_worker;
+
+static size_t get_processor_count(void)
+{
+    long result;
+
+#if defined(_WIN32)
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    result = (long)system_info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    result = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    result = 1;
+#endif
+
+    return (result < 1) ? 1 : (size_t)result;
+}
+
+static void pin_current_thread(size_t processor)
+{
+#if defined(_WIN32)
+    DWORD_PTR mask = (DWORD_PTR)1 << (processor % (sizeof(DWORD_PTR) * 8));
+    if (SetThreadAffinityMask(GetCurrentThread(), mask) == 0)
+    {
+        LogError("SetThreadAffinityMask failed for processor %lu", (unsigned long)processor);
+    }
+#elif defined(__linux__)
+    cpu_set_t cpu_set;
+    CPU_ZERO(&cpu_set);
+    CPU_SET((int)processor, &cpu_set);
+    if (pthread_setaffinity_np(pthread_self(), sizeof(cpu_set), &cpu_set) != 0)
+    {
+        LogError("pthread_setaffinity_np failed for processor %lu", (unsigned long)processor);
+    }
+#else
+    LogInfo("pinning workers is not supported on this platform, worker for processor %lu not pinned", (unsigned long)processor);
+#endif
+}
+
+static int wake_sleeping_worker(THREADPOOL* threadpool)
+{
+    int result;
+
+    if (THREADPOOL_READ(threadpool->sleeping) == 0)
+    {
+        result = 0;
+    }
+    else if (Lock(threadpool->lock) != LOCK_OK)
+    {
+        LogError("failure in Lock");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (Condition_Post(threadpool->work_available) != COND_OK)
+        {
+            LogError("failure in Condition_Post");
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+
+        (void)Unlock(threadpool->lock);
+    }
+
+    return result;
+}
+
+static WORK_ITEM* take_own_work(WORKER* worker)
+{
+    WORK_ITEM* result;
+
+    (void)SpinLock_Lock(worker->deque_lock);
+    if (DList_IsListEmpty(&worker->deque))
+    {
+        result = NULL;
+    }
+    else
+    {
+        PDLIST_ENTRY newest = worker->deque.Blink;
+        (void)DList_RemoveEntryList(newest);
+        result = containingRecord(newest, WORK_ITEM, link);
+    }
+    (void)SpinLock_Unlock(worker->deque_lock);
+
+    return result;
+}
+
+static WORK_ITEM* steal_work(WORKER* thief)
+{
+    WORK_ITEM* result = NULL;
+    THREADPOOL* threadpool = thief->threadpool;
+    size_t i;
+
+    for (i = 1; (result == NULL) && (i < threadpool->worker_count); i++)
+    {
+        WORKER* victim = &threadpool->workers[(thief->index + i) % threadpool->worker_count];
+
+        (void)SpinLock_Lock(victim->deque_lock);
+        if (!DList_IsListEmpty(&victim->deque))
+        {
+            result = containingRecord(DList_RemoveHeadList(&victim->deque), WORK_ITEM, link);
+        }
+        (void)SpinLock_Unlock(victim->deque_lock);
+    }
+
+    return result;
+}
+
+static int worker_thread(void* arg)
+{
+    WORKER* worker = (WORKER*)arg;
+    THREADPOOL* threadpool = worker->threadpool;
+
+    current_worker = worker;
+
+    if (threadpool->pin_workers)
+    {
+        /*Codes_SRS_THREADPOOL_01_008: [ If pin_workers is true, each worker shall pin itself to the processor of its index modulo the processor count; a failure to do so shall only be logged. ]*/
+        pin_current_thread(worker->index % threadpool->processor_count);
+    }
+
+    for (;;)
+    {
+        /*Codes_SRS_THREADPOOL_01_009: [ A worker shall take the newest work item of its own deque, or otherwise steal the oldest work item of another worker. ]*/
+        WORK_ITEM* work_item = take_own_work(worker);
+        if (work_item == NULL)
+        {
+            work_item = steal_work(worker);
+        }
+
+        if (work_item != NULL)
+        {
+            int work_result;
+
+            if (THREADPOOL_DECREMENT(threadpool->pending) > 0)
+            {
+                /*more work than this worker, let a sleeping one help*/
+                (void)wake_sleeping_worker(threadpool);
+            }
+
+            /*Codes_SRS_THREADPOOL_01_010: [ A worker shall call the work function of the work item, then the completion callback if there is one with the value returned by the work function, and free the work item. ]*/
+            work_result = work_item->work_function(work_item->work_context);
+            if (work_item->on_work_complete != NULL)
+            {
+                work_item->on_work_complete(work_item->on_work_complete_context, work_result);
+            }
+            free(work_item);
+        }
+        else if (THREADPOOL_READ(threadpool->pending) > 0)
+        {
+            /*an item is being pushed or taken right now, look again*/
+        }
+        else if (Lock(threadpool->lock) != LOCK_OK)
+        {
+            LogError("failure in Lock, worker %lu stops", (unsigned long)worker->index);
+            break;
+        }
+        else
+        {
+            int stop = 0;
+
+            (void)THREADPOOL_INCREMENT(threadpool->sleeping);
+            if (THREADPOOL_READ(threadpool->pending) == 0)
+            {
+                if (THREADPOOL_READ(threadpool->stopping) != 0)
+                {
+                    /*Codes_SRS_THREADPOOL_01_012: [ Once the pool is stopping and no work is left, a worker shall exit. ]*/
+                    /*another worker may be waiting for the same wake up*/
+                    (void)Condition_Post(threadpool->work_available);
+                    stop = 1;
+                }
+                /*Codes_SRS_THREADPOOL_01_011: [ When there is no work, a worker shall wait on the condition of the pool. ]*/
+                else if (Condition_Wait(threadpool->work_available, threadpool->lock, 0) != COND_OK)
+                {
+                    LogError("failure in Condition_Wait, worker %lu stops", (unsigned long)worker->index);
+                    stop = 1;
+                }
+            }
+            (void)THREADPOOL_DECREMENT(threadpool->sleeping);
+
+            (void)Unlock(threadpool->lock);
+
+            if (stop)
+            {
+                break;
+            }
+        }
+    }
+
+    current_worker = NULL;
+    return 0;
+}
+
+static void stop_workers(THREADPOOL* threadpool, size_t started_count)
+{
+    size_t i;
+
+    (void)THREADPOOL_INCREMENT(threadpool->stopping);
+
+    if (Lock(threadpool->lock) != LOCK_OK)
+    {
+        LogError("failure in Lock, workers that sleep are not woken");
+    }
+    else
+    {
+        (void)Condition_Post(threadpool->work_available);
+        (void)Unlock(threadpool->lock);
+    }
+
+    for (i = 0; i < started_count; i++)
+    {
+        int thread_result;
+        if (ThreadAPI_Join(threadpool->workers[i].thread, &thread_result) != THREADAPI_OK)
+        {
+            LogError("failure in ThreadAPI_Join for worker %lu", (unsigned long)i);
+        }
+    }
+}
+
+static void free_threadpool(THREADPOOL* threadpool, size_t initialized_worker_count)
+{
+    size_t i;
+
+    for (i = 0; i < initialized_worker_count; i++)
+    {
+        (void)SpinLock_Deinit(threadpool->workers[i].deque_lock);
+    }
+    free(threadpool->workers);
+    Condition_Deinit(threadpool->work_available);
+    (void)Lock_Deinit(threadpool->lock);
+    free(threadpool);
+}
+
+THREADPOOL_HANDLE threadpool_create(const THREADPOOL_CONFIG* config)
+{
+    /*Codes_SRS_THREADPOOL_01_003: [ threadpool_create shall allocate memory for the pool and create its lock and condition. ]*/
+    THREADPOOL* result = (THREADPOOL*)malloc(sizeof(THREADPOOL));
+    if (result == NULL)
+    {
+        /*Codes_SRS_THREADPOOL_01_007: [ If any failure occurs, threadpool_create shall stop the workers it started, free all resources and return NULL. ]*/
+        LogError("failure in malloc(sizeof(THREADPOOL)=%lu)", (unsigned long)sizeof(THREADPOOL));
+    }
+    else
+    {
+        result->processor_count = get_processor_count();
+        /*Codes_SRS_THREADPOOL_01_001: [ If config is NULL, threadpool_create shall create one worker per processor and not pin them. ]*/
+        result->pin_workers = (config != NULL) && config->pin_workers;
+        /*Codes_SRS_THREADPOOL_01_002: [ If the worker_count of config is 0, threadpool_create shall create one worker per processor. ]*/
+        result->worker_count = ((config == NULL) || (config->worker_count == 0)) ? result->processor_count : config->worker_count;
+        result->pending = 0;
+        result->sleeping = 0;
+        result->stopping = 0;
+        result->next_worker = 0;
+
+        if ((result->lock = Lock_Init()) == NULL)
+        {
+            /*Codes_SRS_THREADPOOL_01_007: [ If any failure occurs, threadpool_create shall stop the workers it started, free all resources and return NULL. ]*/
+            LogError("failure in Lock_Init");
+        }
+        else
+        {
+            if ((result->work_available = Condition_Init()) == NULL)
+            {
+                /*Codes_SRS_THREADPOOL_01_007: [ If any failure occurs, threadpool_create shall stop the workers it started, free all resources and return NULL. ]*/
+                LogError("failure in Condition_Init");
+            }
+            else
+            {
+                if ((result->worker_count > SIZE_MAX / sizeof(WORKER)) ||
+                    ((result->workers = (WORKER*)malloc(result->worker_count * sizeof(WORKER))) == NULL))
+                {
+                    /*Codes_SRS_THREADPOOL_01_007: [ If any failure occurs, threadpool_create shall stop the workers it started, free all resources and return NULL. ]*/
+                    LogError("failure allocating %lu workers", (unsigned long)result->worker_count);
+                }
+                else
+                {
+                    size_t initialized_count;
+                    size_t started_count = 0;
+
+                    /*Codes_SRS_THREADPOOL_01_004: [ threadpool_create shall create a spin lock and an empty deque for each worker. ]*/
+                    for (initialized_count = 0; initialized_count < result->worker_count; initialized_count++)
+                    {
+                        WORKER* worker = &result->workers[initialized_count];
+                        worker->threadpool = result;
+                        worker->index = initialized_count;
+                        DList_InitializeListHead(&worker->deque);
+                        if ((worker->deque_lock = SpinLock_Init()) == NULL)
+                        {
+                            LogError("failure in SpinLock_Init");
+                            break;
+                        }
+                    }
+
+                    if (initialized_count == result->worker_count)
+                    {
+                        /*Codes_SRS_THREADPOOL_01_005: [ threadpool_create shall start each worker with ThreadAPI_Create. ]*/
+                        for (started_count = 0; started_count < result->worker_count; started_count++)
+                        {
+                            if (ThreadAPI_Create(&result->workers[started_count].thread, worker_thread, &result->workers[started_count]) != THREADAPI_OK)
+                            {
+                                LogError("failure in ThreadAPI_Create");
+                                break;
+                            }
+                        }
+
+                        if (started_count == result->worker_count)
+                        {
+                            /*Codes_SRS_THREADPOOL_01_006: [ threadpool_create shall succeed and return a non-NULL value. ]*/
+                            goto all_ok;
+                        }
+
+                        /*Codes_SRS_THREADPOOL_01_007: [ If any failure occurs, threadpool_create shall stop the workers it started, free all resources and return NULL. ]*/
+                        stop_workers(result, started_count);
+                    }
+
+                    free_threadpool(result, initialized_count);
+                    result = NULL;
+                    goto all_ok;
+                }
+                Condition_Deinit(result->work_available);
+            }
+            (void)Lock_Deinit(result->lock);
+        }
+        free(result);
+        result = NULL;
+    }
+all_ok:
+    return result;
+}
+
+void threadpool_destroy(THREADPOOL_HANDLE threadpool)
+{
+    if (threadpool == NULL)
+    {
+        /*Codes_SRS_THREADPOOL_01_013: [ If threadpool is NULL, threadpool_destroy shall return. ]*/
+        LogError("invalid argument THREADPOOL_HANDLE threadpool=%p", threadpool);
+    }
+    else
+    {
+        /*Codes_SRS_THREADPOOL_01_014: [ threadpool_destroy shall mark the pool as stopping and wake the workers. ]*/
+        /*Codes_SRS_THREADPOOL_01_015: [ threadpool_destroy shall wait with ThreadAPI_Join for all workers to exit, which they do after running all the work still scheduled. ]*/
+        stop_workers(threadpool, threadpool->worker_count);
+
+        /*Codes_SRS_THREADPOOL_01_016: [ threadpool_destroy shall free the spin locks, the condition, the lock and the memory of the pool. ]*/
+        free_threadpool(threadpool, threadpool->worker_count);
+    }
+}
+
+int threadpool_schedule_work(THREADPOOL_HANDLE threadpool, THREADPOOL_WORK_FUNCTION work_function, void* work_context, ON_THREADPOOL_WORK_COMPLETE on_work_complete, void* on_work_complete_context)
+{
+    int result;
+
+    if (
+        /*Codes_SRS_THREADPOOL_01_017: [ If threadpool or work_function is NULL, threadpool_schedule_work shall fail and return a non-zero value. ]*/
+        (threadpool == NULL) ||
+        (work_function == NULL)
+        )
+    {
+        LogError("invalid arguments THREADPOOL_HANDLE threadpool=%p, THREADPOOL_WORK_FUNCTION work_function=%p", threadpool, work_function);
+        result = __FAILURE__;
+    }
+    else if (
+        (THREADPOOL_READ(threadpool->stopping) != 0) &&
+        ((current_worker == NULL) || (current_worker->threadpool != threadpool))
+        )
+    {
+        /*Codes_SRS_THREADPOOL_01_018: [ If the pool is being destroyed and threadpool_schedule_work is not called by one of its workers, threadpool_schedule_work shall fail and return a non-zero value. ]*/
+        LogError("the thread pool is being destroyed");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_THREADPOOL_01_019: [ threadpool_schedule_work shall allocate a work item holding work_function, work_context, on_work_complete and on_work_complete_context. ]*/
+        WORK_ITEM* work_item = (WORK_ITEM*)malloc(sizeof(WORK_ITEM));
+        if (work_item == NULL)
+        {
+            /*Codes_SRS_THREADPOOL_01_020: [ If allocating the work item fails, threadpool_schedule_work shall fail and return a non-zero value. ]*/
+            LogError("failure in malloc(sizeof(WORK_ITEM)=%lu)", (unsigned long)sizeof(WORK_ITEM));
+            result = __FAILURE__;
+        }
+        else
+        {
+            WORKER* worker;
+
+            work_item->work_function = work_function;
+            work_item->work_context = work_context;
+            work_item->on_work_complete = on_work_complete;
+            work_item->on_work_complete_context = on_work_complete_context;
+
+            /*Codes_SRS_THREADPOOL_01_021: [ When called by a worker of threadpool, threadpool_schedule_work shall add the work item at the tail of the deque of that worker, otherwise at the tail of the deque of the next worker in turn. ]*/
+            if ((current_worker != NULL) && (current_worker->threadpool == threadpool))
+            {
+                worker = current_worker;
+            }
+            else
+            {
+                worker = &threadpool->workers[(size_t)(unsigned long)THREADPOOL_INCREMENT(threadpool->next_worker) % threadpool->worker_count];
+            }
+
+            (void)SpinLock_Lock(worker->deque_lock);
+            DList_InsertTailList(&worker->deque, &work_item->link);
+            (void)SpinLock_Unlock(worker->deque_lock);
+
+            (void)THREADPOOL_INCREMENT(threadpool->pending);
+
+            /*Codes_SRS_THREADPOOL_01_022: [ If a worker is waiting, threadpool_schedule_work shall post the condition of the pool while holding its lock. ]*/
+            if (wake_sleeping_worker(threadpool) != 0)
+            {
+                /*the item is queued, the next worker that looks for work runs it*/
+                LogError("failure waking a worker");
+            }
+
+            /*Codes_SRS_THREADPOOL_01_023: [ threadpool_schedule_work shall succeed and return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+size_t threadpool_get_worker_count(THREADPOOL_HANDLE threadpool)
+{
+    size_t result;
+
+    if (threadpool == NULL)
+    {
+        /*Codes_SRS_THREADPOOL_01_024: [ If threadpool is NULL, threadpool_get_worker_count shall return 0. ]*/
+        LogError("invalid argument THREADPOOL_HANDLE threadpool=%p", threadpool);
+        result = 0;
+    }
+    else
+    {
+        /*Codes_SRS_THREADPOOL_01_025: [ threadpool_get_worker_count shall return the number of workers of threadpool. ]*/
+        result = threadpool->worker_count;
+    }
+
+    return result;
+}
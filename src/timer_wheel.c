@@ -0,0 +1,371 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/timer_wheel.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/doublylinkedlist.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+/*
+* The wheel has a 256 slot level of 1 ms, then three 64 slot levels, each slot of a level
+* covering a whole turn of the level below: 256 ms, 16 s and about 17 minutes. That is
+* 2^26 ms, about 18.6 hours; a timer further away waits in the last level and is placed
+* again each time it moves down. A level is moved down one slot every time the level
+* below it wraps around.
+*
+* current is the next millisecond to process. tickcounter_ms_t may be 32 bits and wrap, so
+* deadlines are only ever compared through their difference with current.
+*/
+#define LEVEL_0_BITS 8
+#define LEVEL_N_BITS 6
+#define LEVEL_0_SIZE (1 << LEVEL_0_BITS)
+#define LEVEL_N_SIZE (1 << LEVEL_N_BITS)
+#define LEVEL_0_MASK (LEVEL_0_SIZE - 1)
+#define LEVEL_N_MASK (LEVEL_N_SIZE - 1)
+#define LEVEL_N_COUNT 3
+#define LEVEL_SHIFT(level) (LEVEL_0_BITS + ((level) * LEVEL_N_BITS))
+#define WHEEL_SPAN ((tickcounter_ms_t)1 << LEVEL_SHIFT(LEVEL_N_COUNT))
+
+#define TICKCOUNTER_MS_HALF_RANGE (((tickcounter_ms_t)~(tickcounter_ms_t)0) >> 1)
+/* deadline is now or in the past */
+#define IS_DUE(deadline, now) ((tickcounter_ms_t)((now) - (deadline)) <= TICKCOUNTER_MS_HALF_RANGE)
+
+typedef struct TIMER_WHEEL_TAG
+{
+    TICK_COUNTER_HANDLE tick_counter;
+    tickcounter_ms_t current;
+    size_t running_count;
+    size_t timer_count;
+    DLIST_ENTRY level_0[LEVEL_0_SIZE];
+    DLIST_ENTRY level_n[LEVEL_N_COUNT][LEVEL_N_SIZE];
+} TIMER_WHEEL;
+
+typedef struct TIMER_WHEEL_TIMER_TAG
+{
+    TIMER_WHEEL* timer_wheel;
+    ON_TIMER_EXPIRED on_timer_expired;
+    void* context;
+    tickcounter_ms_t deadline;
+    bool is_running;
+    DLIST_ENTRY link;
+} TIMER_WHEEL_TIMER;
+
+static void add_timer(TIMER_WHEEL* timer_wheel, TIMER_WHEEL_TIMER* timer)
+{
+    tickcounter_ms_t delta = (tickcounter_ms_t)(timer->deadline - timer_wheel->current);
+    PDLIST_ENTRY slot;
+
+    if (delta > TICKCOUNTER_MS_HALF_RANGE)
+    {
+        /*already due, expires with the next millisecond processed*/
+        slot = &timer_wheel->level_0[timer_wheel->current & LEVEL_0_MASK];
+    }
+    else if (delta < LEVEL_0_SIZE)
+    {
+        slot = &timer_wheel->level_0[timer->deadline & LEVEL_0_MASK];
+    }
+    else
+    {
+        tickcounter_ms_t placement = timer->deadline;
+        int level;
+
+        if (delta >= WHEEL_SPAN)
+        {
+            /*beyond the wheel, waits in the furthest slot and is placed again from there*/
+            placement = timer_wheel->current + (WHEEL_SPAN - 1);
+            delta = WHEEL_SPAN - 1;
+        }
+
+        for (level = 0; delta >= ((tickcounter_ms_t)1 << LEVEL_SHIFT(level + 1)); level++)
+        {
+        }
+
+        slot = &timer_wheel->level_n[level][(placement >> LEVEL_SHIFT(level)) & LEVEL_N_MASK];
+    }
+
+    DList_InsertTailList(slot, &timer->link);
+}
+
+/* moves all the timers of slot to the empty list head taken */
+static void take_slot(PDLIST_ENTRY slot, PDLIST_ENTRY taken)
+{
+    /*link taken into the ring of slot, then drop slot out of it*/
+    DList_InitializeListHead(taken);
+    DList_AppendTailList(slot, taken);
+    (void)DList_RemoveEntryList(slot);
+    DList_InitializeListHead(slot);
+}
+
+/* moves the timers of the current slot of a level down, returns the index of that slot */
+static size_t cascade(TIMER_WHEEL* timer_wheel, int level)
+{
+    size_t index = (size_t)((timer_wheel->current >> LEVEL_SHIFT(level)) & LEVEL_N_MASK);
+    DLIST_ENTRY moved;
+
+    take_slot(&timer_wheel->level_n[level][index], &moved);
+
+    while (!DList_IsListEmpty(&moved))
+    {
+        add_timer(timer_wheel, containingRecord(DList_RemoveHeadList(&moved), TIMER_WHEEL_TIMER, link));
+    }
+
+    return index;
+}
+
+TIMER_WHEEL_HANDLE timer_wheel_create(void)
+{
+    /*Codes_SRS_TIMER_WHEEL_01_001: [ timer_wheel_create shall allocate memory for a new timer wheel and create its tick counter. ]*/
+    TIMER_WHEEL* result = (TIMER_WHEEL*)malloc(sizeof(TIMER_WHEEL));
+    if (result == NULL)
+    {
+        /*Codes_SRS_TIMER_WHEEL_01_004: [ If any failure occurs, timer_wheel_create shall fail and return NULL. ]*/
+        LogError("failure in malloc(sizeof(TIMER_WHEEL)=%lu)", (unsigned long)sizeof(TIMER_WHEEL));
+    }
+    else if ((result->tick_counter = tickcounter_create()) == NULL)
+    {
+        /*Codes_SRS_TIMER_WHEEL_01_004: [ If any failure occurs, timer_wheel_create shall fail and return NULL. ]*/
+        LogError("failure in tickcounter_create");
+        free(result);
+        result = NULL;
+    }
+    else if (tickcounter_get_current_ms(result->tick_counter, &result->current) != 0)
+    {
+        /*Codes_SRS_TIMER_WHEEL_01_004: [ If any failure occurs, timer_wheel_create shall fail and return NULL. ]*/
+        LogError("failure in tickcounter_get_current_ms");
+        tickcounter_destroy(result->tick_counter);
+        free(result);
+        result = NULL;
+    }
+    else
+    {
+        size_t i;
+        int level;
+
+        /*Codes_SRS_TIMER_WHEEL_01_002: [ timer_wheel_create shall start the wheel at the current time of the tick counter, with no timer running. ]*/
+        result->running_count = 0;
+        result->timer_count = 0;
+        for (i = 0; i < LEVEL_0_SIZE; i++)
+        {
+            DList_InitializeListHead(&result->level_0[i]);
+        }
+        for (level = 0; level < LEVEL_N_COUNT; level++)
+        {
+            for (i = 0; i < LEVEL_N_SIZE; i++)
+            {
+                DList_InitializeListHead(&result->level_n[level][i]);
+            }
+        }
+
+        /*Codes_SRS_TIMER_WHEEL_01_003: [ timer_wheel_create shall succeed and return a non-NULL value. ]*/
+    }
+
+    return result;
+}
+
+void timer_wheel_destroy(TIMER_WHEEL_HANDLE timer_wheel)
+{
+    if (timer_wheel == NULL)
+    {
+        /*Codes_SRS_TIMER_WHEEL_01_005: [ If timer_wheel is NULL, timer_wheel_destroy shall return. ]*/
+        LogError("invalid argument TIMER_WHEEL_HANDLE timer_wheel=%p", timer_wheel);
+    }
+    else
+    {
+        if (timer_wheel->timer_count != 0)
+        {
+            LogError("destroying a timer wheel that still has %lu timers", (unsigned long)timer_wheel->timer_count);
+        }
+
+        /*Codes_SRS_TIMER_WHEEL_01_006: [ timer_wheel_destroy shall destroy the tick counter and free the memory of the wheel. ]*/
+        tickcounter_destroy(timer_wheel->tick_counter);
+        free(timer_wheel);
+    }
+}
+
+TIMER_WHEEL_TIMER_HANDLE timer_wheel_create_timer(TIMER_WHEEL_HANDLE timer_wheel, ON_TIMER_EXPIRED on_timer_expired, void* context)
+{
+    TIMER_WHEEL_TIMER* result;
+
+    if (
+        /*Codes_SRS_TIMER_WHEEL_01_007: [ If timer_wheel or on_timer_expired is NULL, timer_wheel_create_timer shall fail and return NULL. ]*/
+        (timer_wheel == NULL) ||
+        (on_timer_expired == NULL)
+        )
+    {
+        LogError("invalid arguments TIMER_WHEEL_HANDLE timer_wheel=%p, ON_TIMER_EXPIRED on_timer_expired=%p", timer_wheel, on_timer_expired);
+        result = NULL;
+    }
+    /*Codes_SRS_TIMER_WHEEL_01_008: [ timer_wheel_create_timer shall allocate memory for a timer that is not running and return it. ]*/
+    else if ((result = (TIMER_WHEEL_TIMER*)malloc(sizeof(TIMER_WHEEL_TIMER))) == NULL)
+    {
+        /*Codes_SRS_TIMER_WHEEL_01_009: [ If allocating memory fails, timer_wheel_create_timer shall fail and return NULL. ]*/
+        LogError("failure in malloc(sizeof(TIMER_WHEEL_TIMER)=%lu)", (unsigned long)sizeof(TIMER_WHEEL_TIMER));
+    }
+    else
+    {
+        result->timer_wheel = timer_wheel;
+        result->on_timer_expired = on_timer_expired;
+        result->context = context;
+        result->deadline = 0;
+        result->is_running = false;
+        DList_InitializeListHead(&result->link);
+        timer_wheel->timer_count++;
+    }
+
+    return result;
+}
+
+void timer_wheel_destroy_timer(TIMER_WHEEL_TIMER_HANDLE timer)
+{
+    if (timer == NULL)
+    {
+        /*Codes_SRS_TIMER_WHEEL_01_010: [ If timer is NULL, timer_wheel_destroy_timer shall return. ]*/
+        LogError("invalid argument TIMER_WHEEL_TIMER_HANDLE timer=%p", timer);
+    }
+    else
+    {
+        /*Codes_SRS_TIMER_WHEEL_01_011: [ timer_wheel_destroy_timer shall cancel the timer if it is running and free it. ]*/
+        timer_wheel_cancel_timer(timer);
+        timer->timer_wheel->timer_count--;
+        free(timer);
+    }
+}
+
+int timer_wheel_start_timer(TIMER_WHEEL_TIMER_HANDLE timer, tickcounter_ms_t timeout_ms)
+{
+    int result;
+    tickcounter_ms_t now;
+
+    if (timer == NULL)
+    {
+        /*Codes_SRS_TIMER_WHEEL_01_012: [ If timer is NULL, timer_wheel_start_timer shall fail and return a non-zero value. ]*/
+        LogError("invalid argument TIMER_WHEEL_TIMER_HANDLE timer=%p", timer);
+        result = __FAILURE__;
+    }
+    else if (timeout_ms > TICKCOUNTER_MS_HALF_RANGE)
+    {
+        /*Codes_SRS_TIMER_WHEEL_01_013: [ If timeout_ms is more than half the range of tickcounter_ms_t, timer_wheel_start_timer shall fail and return a non-zero value. ]*/
+        LogError("timeout_ms=%lu is too far away to be told apart from the past", (unsigned long)timeout_ms);
+        result = __FAILURE__;
+    }
+    else if (tickcounter_get_current_ms(timer->timer_wheel->tick_counter, &now) != 0)
+    {
+        /*Codes_SRS_TIMER_WHEEL_01_014: [ If tickcounter_get_current_ms fails, timer_wheel_start_timer shall fail and return a non-zero value, leaving the timer as it was. ]*/
+        LogError("failure in tickcounter_get_current_ms");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /*Codes_SRS_TIMER_WHEEL_01_015: [ If the timer is running, timer_wheel_start_timer shall cancel it first. ]*/
+        timer_wheel_cancel_timer(timer);
+
+        /*Codes_SRS_TIMER_WHEEL_01_016: [ timer_wheel_start_timer shall place the timer in the wheel so that it expires timeout_ms after the current time of the tick counter. ]*/
+        timer->deadline = now + timeout_ms;
+        timer->is_running = true;
+        add_timer(timer->timer_wheel, timer);
+        timer->timer_wheel->running_count++;
+
+        /*Codes_SRS_TIMER_WHEEL_01_017: [ timer_wheel_start_timer shall succeed and return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+void timer_wheel_cancel_timer(TIMER_WHEEL_TIMER_HANDLE timer)
+{
+    if (timer == NULL)
+    {
+        /*Codes_SRS_TIMER_WHEEL_01_018: [ If timer is NULL, timer_wheel_cancel_timer shall return. ]*/
+        LogError("invalid argument TIMER_WHEEL_TIMER_HANDLE timer=%p", timer);
+    }
+    else if (timer->is_running)
+    {
+        /*Codes_SRS_TIMER_WHEEL_01_019: [ If the timer is running, timer_wheel_cancel_timer shall remove it from the wheel without calling its callback. ]*/
+        (void)DList_RemoveEntryList(&timer->link);
+        DList_InitializeListHead(&timer->link);
+        timer->is_running = false;
+        timer->timer_wheel->running_count--;
+    }
+}
+
+bool timer_wheel_is_timer_running(TIMER_WHEEL_TIMER_HANDLE timer)
+{
+    bool result;
+
+    if (timer == NULL)
+    {
+        /*Codes_SRS_TIMER_WHEEL_01_020: [ If timer is NULL, timer_wheel_is_timer_running shall return false. ]*/
+        LogError("invalid argument TIMER_WHEEL_TIMER_HANDLE timer=%p", timer);
+        result = false;
+    }
+    else
+    {
+        /*Codes_SRS_TIMER_WHEEL_01_021: [ timer_wheel_is_timer_running shall return whether the timer was started and neither expired nor was cancelled since. ]*/
+        result = timer->is_running;
+    }
+
+    return result;
+}
+
+void timer_wheel_dowork(TIMER_WHEEL_HANDLE timer_wheel)
+{
+    tickcounter_ms_t now;
+
+    if (timer_wheel == NULL)
+    {
+        /*Codes_SRS_TIMER_WHEEL_01_022: [ If timer_wheel is NULL, timer_wheel_dowork shall return. ]*/
+        LogError("invalid argument TIMER_WHEEL_HANDLE timer_wheel=%p", timer_wheel);
+    }
+    else if (tickcounter_get_current_ms(timer_wheel->tick_counter, &now) != 0)
+    {
+        /*Codes_SRS_TIMER_WHEEL_01_023: [ If tickcounter_get_current_ms fails, timer_wheel_dowork shall return without expiring any timer. ]*/
+        LogError("failure in tickcounter_get_current_ms");
+    }
+    else
+    {
+        /*Codes_SRS_TIMER_WHEEL_01_024: [ timer_wheel_dowork shall process each millisecond from the last one it processed up to the current time of the tick counter. ]*/
+        while (IS_DUE(timer_wheel->current, now))
+        {
+            size_t index;
+            DLIST_ENTRY expired;
+
+            if (timer_wheel->running_count == 0)
+            {
+                /*Codes_SRS_TIMER_WHEEL_01_025: [ When no timer is running, timer_wheel_dowork shall skip to the current time at once. ]*/
+                timer_wheel->current = now + 1;
+                break;
+            }
+
+            index = (size_t)(timer_wheel->current & LEVEL_0_MASK);
+            if ((index == 0) &&
+                (cascade(timer_wheel, 0) == 0) &&
+                (cascade(timer_wheel, 1) == 0))
+            {
+                (void)cascade(timer_wheel, 2);
+            }
+
+            /*timers started from the callbacks below belong to the following milliseconds*/
+            timer_wheel->current++;
+
+            take_slot(&timer_wheel->level_0[index], &expired);
+
+            while (!DList_IsListEmpty(&expired))
+            {
+                TIMER_WHEEL_TIMER* timer = containingRecord(DList_RemoveHeadList(&expired), TIMER_WHEEL_TIMER, link);
+                DList_InitializeListHead(&timer->link);
+                timer->is_running = false;
+                timer_wheel->running_count--;
+
+                /*Codes_SRS_TIMER_WHEEL_01_026: [ For each timer whose deadline is in a processed millisecond, timer_wheel_dowork shall mark the timer as not running and call its on_timer_expired with its context. ]*/
+                /*the callback may start, cancel or destroy any timer, this one included*/
+                timer->on_timer_expired(timer->context);
+            }
+        }
+    }
+}
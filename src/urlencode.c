@@ -4,6 +4,7 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <string.h>
+#include <stdbool.h>
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/urlencode.h"
 #include "azure_c_shared_utility/xlogging.h"
@@ -51,10 +52,32 @@
     ((c >= 'd') && (c <= 'f'))                      \
 )
 
+/*The number of characters each byte is encoded to: 1 for the unreserved characters and the terminating '\0',
+3 for "%xx" below 0x80 and 6 for "%c2%xx" or "%c3%xx" above*/
+static const unsigned char URL_ENCODED_SIZE[256] =
+{
+    1, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3, 3,
+    3, 1, 3, 3, 3, 3, 3, 3, 1, 1, 1, 3, 3, 1, 1, 3,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 3, 3, 3, 3, 3, 3,
+    3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 3, 3, 3, 3, 1,
+    3, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 3, 3, 3, 3, 3,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6,
+    6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6, 6
+};
+
 static size_t URL_PrintableChar(unsigned char charVal, char* buffer)
 {
     size_t size;
-    if (IS_PRINTABLE(charVal))
+    if (URL_ENCODED_SIZE[charVal] == 1)
     {
         buffer[0] = (char)charVal;
         size = 1;
@@ -197,64 +220,223 @@ static void createDecodedString(const char* input, size_t input_size, char* outp
     }
 }
 
-static size_t URL_PrintableCharSize(unsigned char charVal)
+/*Checks the length characters of text with the rules of calculateDecodedStringSize, without requiring text to
+be '\0' terminated, and computes the length of the decoding, not counting a terminating '\0'*/
+static int validate_encoded_text(const char* text, size_t length, size_t* decodedLength, bool* hasEscape)
 {
-    size_t size;
-    if (IS_PRINTABLE(charVal))
+    int result = 0;
+    size_t i = 0;
+
+    *decodedLength = 0;
+    *hasEscape = false;
+    while (i < length)
     {
-        size = 1;
+        if (text[i] == '%')
+        {
+            if ((length - i < 3) || !IS_HEXDIGIT(text[i + 1]) || !IS_HEXDIGIT(text[i + 2]))
+            {
+                LogError("Incomplete or invalid percent encoding");
+                result = __FAILURE__;
+                break;
+            }
+            else if (!IS_IN_ASCII_RANGE(text[i + 1]))
+            {
+                LogError("Out of range of characters accepted by this decoder");
+                result = __FAILURE__;
+                break;
+            }
+            else
+            {
+                *hasEscape = true;
+                i += 3;
+            }
+        }
+        else if (!IS_PRINTABLE(text[i]))
+        {
+            LogError("Unprintable value in encoded string");
+            result = __FAILURE__;
+            break;
+        }
+        else
+        {
+            i++;
+        }
+        (*decodedLength)++;
     }
-    else
+
+    return result;
+}
+
+/*Decodes length characters already checked by validate_encoded_text. output may be input: the write position
+never passes the read position*/
+static void decode_validated_text(const char* input, size_t length, char* output)
+{
+    size_t i = 0;
+
+    while (i < length)
     {
-        if (charVal < 0x80)
+        if (input[i] != '%')
         {
-            size = 3;
+            *output++ = input[i];
+            i++;
         }
         else
         {
-            size = 6;
+            *output++ = (char)charFromNibbles(input[i + 1], input[i + 2]);
+            i += 3;
         }
     }
-    return size;
+    *output = '\0';
 }
 
-static STRING_HANDLE encode_url_data(const char* text)
+static size_t URL_EncodedLength(const char* text, size_t* textLength)
 {
-    STRING_HANDLE result;
+    const unsigned char* iterator = (const unsigned char*)text;
     size_t lengthOfResult = 0;
-    char* encodedURL;
-    unsigned char currentUnsignedChar;
-    const char* iterator = text;
 
+    while (*iterator != 0)
+    {
+        lengthOfResult += URL_ENCODED_SIZE[*iterator++];
+    }
+    *textLength = (size_t)(iterator - (const unsigned char*)text);
+    return lengthOfResult;
+}
+
+static size_t URL_FirstCharToEscape(const char* text)
+{
+    const unsigned char* iterator = (const unsigned char*)text;
+
+    while ((*iterator != 0) && (URL_ENCODED_SIZE[*iterator] == 1))
+    {
+        iterator++;
+    }
+    return (size_t)(iterator - (const unsigned char*)text);
+}
+
+static STRING_HANDLE encode_url_data(const char* text)
+{
+    STRING_HANDLE result;
+    size_t textLength;
     /*Codes_SRS_URL_ENCODE_06_003: [If input is a zero length string then URL_Encode will return a zero length string.]*/
-    do
+    size_t lengthOfResult = URL_EncodedLength(text, &textLength);
+
+    if (lengthOfResult == textLength)
+    {
+        /*Codes_SRS_URL_ENCODE_01_001: [ If no character of input needs escaping, URL_Encode shall return a copy of input without encoding it character by character. ]*/
+        result = STRING_construct_n(text, textLength);
+        if (result == NULL)
+        {
+            /*Codes_SRS_URL_ENCODE_06_002: [If an error occurs during the encoding of input then URL_Encode will return NULL.]*/
+            LogError("URL_Encode:: MALLOC failure on encode.");
+        }
+    }
+    else
     {
-        currentUnsignedChar = (unsigned char)(*iterator++);
-        lengthOfResult += URL_PrintableCharSize(currentUnsignedChar);
-    } while (currentUnsignedChar != 0);
+        char* encodedURL;
+        if ((encodedURL = (char*)malloc(lengthOfResult + 1)) == NULL)
+        {
+            /*Codes_SRS_URL_ENCODE_06_002: [If an error occurs during the encoding of input then URL_Encode will return NULL.]*/
+            result = NULL;
+            LogError("URL_Encode:: MALLOC failure on encode.");
+        }
+        else
+        {
+            size_t currentEncodePosition = 0;
+            size_t i;
+            for (i = 0; i <= textLength; i++)
+            {
+                currentEncodePosition += URL_PrintableChar((unsigned char)text[i], &encodedURL[currentEncodePosition]);
+            }
 
-    if ((encodedURL = (char*)malloc(lengthOfResult)) == NULL)
+            result = STRING_new_with_memory(encodedURL);
+            if (result == NULL)
+            {
+                LogError("URL_Encode:: MALLOC failure on encode.");
+                free(encodedURL);
+            }
+        }
+    }
+    return result;
+}
+
+size_t URL_Encoded_Length(const char* text)
+{
+    size_t result;
+    if (text == NULL)
     {
-        /*Codes_SRS_URL_ENCODE_06_002: [If an error occurs during the encoding of input then URL_Encode will return NULL.]*/
-        result = NULL;
-        LogError("URL_Encode:: MALLOC failure on encode.");
+        /*Codes_SRS_URL_ENCODE_01_002: [ If text is NULL, URL_Encoded_Length shall return 0. ]*/
+        result = 0;
+        LogError("URL_Encoded_Length:: NULL text");
     }
     else
     {
+        /*Codes_SRS_URL_ENCODE_01_003: [ Otherwise URL_Encoded_Length shall return the number of characters of the encoding of text, not counting the terminating '\0'. ]*/
+        size_t textLength;
+        result = URL_EncodedLength(text, &textLength);
+    }
+    return result;
+}
+
+int URL_Encode_To(const char* text, char* destination, size_t destination_size)
+{
+    int result;
+    if ((text == NULL) ||
+        (destination == NULL) ||
+        (destination_size == 0))
+    {
+        /*Codes_SRS_URL_ENCODE_01_004: [ If text or destination is NULL or destination_size is 0, URL_Encode_To shall fail and return a non-zero value. ]*/
+        result = __FAILURE__;
+        LogError("URL_Encode_To:: Invalid arguments: text = %p, destination = %p, destination_size = %lu", text, destination, (unsigned long)destination_size);
+    }
+    else
+    {
+        const unsigned char* iterator = (const unsigned char*)text;
         size_t currentEncodePosition = 0;
-        iterator = text;;
-        do
-        {
-            currentUnsignedChar = (unsigned char)(*iterator++);
-            currentEncodePosition += URL_PrintableChar(currentUnsignedChar, &encodedURL[currentEncodePosition]);
-        } while (currentUnsignedChar != 0);
+        unsigned char currentUnsignedChar;
 
-        result = STRING_new_with_memory(encodedURL);
-        if (result == NULL)
+        /*Codes_SRS_URL_ENCODE_01_005: [ URL_Encode_To shall write the encoding of text followed by a '\0' to destination in a single pass over text and return 0. ]*/
+        result = 0;
+        while ((currentUnsignedChar = *iterator++) != 0)
         {
-            LogError("URL_Encode:: MALLOC failure on encode.");
-            free(encodedURL);
+            if (destination_size - currentEncodePosition <= URL_ENCODED_SIZE[currentUnsignedChar])
+            {
+                /*Codes_SRS_URL_ENCODE_01_006: [ If destination_size is smaller than the length of the encoding of text plus 1, URL_Encode_To shall fail, set destination to an empty string and return a non-zero value. ]*/
+                result = __FAILURE__;
+                LogError("URL_Encode_To:: destination_size %lu is too small", (unsigned long)destination_size);
+                currentEncodePosition = 0;
+                break;
+            }
+            currentEncodePosition += URL_PrintableChar(currentUnsignedChar, &destination[currentEncodePosition]);
         }
+        destination[currentEncodePosition] = '\0';
+    }
+    return result;
+}
+
+const char* URL_Encode_If_Needed(const char* text, char* destination, size_t destination_size)
+{
+    const char* result;
+    if (text == NULL)
+    {
+        /*Codes_SRS_URL_ENCODE_01_007: [ If text is NULL, URL_Encode_If_Needed shall fail and return NULL. ]*/
+        result = NULL;
+        LogError("URL_Encode_If_Needed:: NULL text");
+    }
+    else if (text[URL_FirstCharToEscape(text)] == '\0')
+    {
+        /*Codes_SRS_URL_ENCODE_01_008: [ If no character of text needs escaping, URL_Encode_If_Needed shall return text without copying it. ]*/
+        result = text;
+    }
+    /*Codes_SRS_URL_ENCODE_01_009: [ Otherwise URL_Encode_If_Needed shall encode text into destination as URL_Encode_To does and return destination. ]*/
+    else if (URL_Encode_To(text, destination, destination_size) != 0)
+    {
+        /*Codes_SRS_URL_ENCODE_01_010: [ If URL_Encode_To fails, URL_Encode_If_Needed shall return NULL. ]*/
+        result = NULL;
+        LogError("URL_Encode_If_Needed:: cannot encode text into destination");
+    }
+    else
+    {
+        result = destination;
     }
     return result;
 }
@@ -298,15 +480,30 @@ STRING_HANDLE URL_DecodeString(const char* textDecode)
     }
     else
     {
-        STRING_HANDLE tempString = STRING_construct(textDecode);
-        if (tempString == NULL)
+        size_t textLength = strlen(textDecode);
+        size_t decodedLength;
+        bool hasEscape;
+        char* decodedString;
+
+        if (validate_encoded_text(textDecode, textLength, &decodedLength, &hasEscape) != 0)
+        {
+            LogError("URL_DecodeString:: Invalid input string");
+            result = NULL;
+        }
+        else if ((decodedString = (char*)malloc(decodedLength + 1)) == NULL)
         {
+            LogError("URL_DecodeString:: MALLOC failure on decode.");
             result = NULL;
         }
         else
         {
-            result = URL_Decode(tempString);
-            STRING_delete(tempString);
+            decode_validated_text(textDecode, textLength, decodedString);
+            result = STRING_new_with_memory(decodedString);
+            if (result == NULL)
+            {
+                LogError("URL_DecodeString:: MALLOC failure on decode");
+                free(decodedString);
+            }
         }
     }
     return result;
@@ -349,3 +546,76 @@ STRING_HANDLE URL_Decode(STRING_HANDLE input)
     }
     return result;
 }
+
+int URL_DecodeInPlace(char* text, size_t* length)
+{
+    int result;
+    size_t decodedLength;
+    bool hasEscape;
+
+    if ((text == NULL) ||
+        (length == NULL))
+    {
+        /*Codes_SRS_URL_ENCODE_01_011: [ If text or length is NULL, URL_DecodeInPlace shall fail and return a non-zero value. ]*/
+        result = __FAILURE__;
+        LogError("URL_DecodeInPlace:: Invalid arguments: text = %p, length = %p", text, length);
+    }
+    else if (validate_encoded_text(text, *length, &decodedLength, &hasEscape) != 0)
+    {
+        /*Codes_SRS_URL_ENCODE_01_012: [ If the first *length characters of text are not a valid encoding, URL_DecodeInPlace shall fail, leave text unchanged and return a non-zero value. ]*/
+        result = __FAILURE__;
+        LogError("URL_DecodeInPlace:: Invalid input string");
+    }
+    else
+    {
+        /*Codes_SRS_URL_ENCODE_01_013: [ Otherwise URL_DecodeInPlace shall write the decoding of text over its first *length characters, followed by a '\0' only when the decoding is shorter, set *length to the length of the decoding and return 0. ]*/
+        /* without escapes the text already is its decoding, there is no room for a '\0' within *length characters */
+        if (hasEscape)
+        {
+            decode_validated_text(text, *length, text);
+        }
+        *length = decodedLength;
+        result = 0;
+    }
+    return result;
+}
+
+const char* URL_Decode_If_Needed(const char* text, char* destination, size_t destination_size)
+{
+    const char* result;
+    size_t textLength;
+    size_t decodedLength;
+    bool hasEscape;
+
+    if (text == NULL)
+    {
+        /*Codes_SRS_URL_ENCODE_01_014: [ If text is NULL, URL_Decode_If_Needed shall fail and return NULL. ]*/
+        result = NULL;
+        LogError("URL_Decode_If_Needed:: NULL text");
+    }
+    else if (validate_encoded_text(text, (textLength = strlen(text)), &decodedLength, &hasEscape) != 0)
+    {
+        /*Codes_SRS_URL_ENCODE_01_015: [ If text is not a valid encoding, URL_Decode_If_Needed shall fail and return NULL. ]*/
+        result = NULL;
+        LogError("URL_Decode_If_Needed:: Invalid input string");
+    }
+    else if (!hasEscape)
+    {
+        /*Codes_SRS_URL_ENCODE_01_016: [ If text contains no '%', URL_Decode_If_Needed shall return text without copying it. ]*/
+        result = text;
+    }
+    else if ((destination == NULL) ||
+        (destination_size <= decodedLength))
+    {
+        /*Codes_SRS_URL_ENCODE_01_017: [ If destination is NULL or destination_size is smaller than the length of the decoding of text plus 1, URL_Decode_If_Needed shall fail and return NULL. ]*/
+        result = NULL;
+        LogError("URL_Decode_If_Needed:: destination %p of size %lu cannot hold the decoding", destination, (unsigned long)destination_size);
+    }
+    else
+    {
+        /*Codes_SRS_URL_ENCODE_01_018: [ Otherwise URL_Decode_If_Needed shall write the decoding of text followed by a '\0' to destination and return destination. ]*/
+        decode_validated_text(text, textLength, destination);
+        result = destination;
+    }
+    return result;
+}
@@ -1,97 +1,108 @@
- // Copyright (c) Microsoft. All rights reserved.
+// Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
 #ifdef __cplusplus
 #include <cstdlib>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #else
 #include <stdlib.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <string.h>
 #endif
 
 #include "azure_c_shared_utility/utf8_checker.h"
 
-bool utf8_checker_is_valid_utf8(const unsigned char* utf8_str, size_t length)
-{
-    bool result;
+/*
+* Long strings are validated 16 bytes at a time with the SIMD instructions of the CPU
+* (SSSE3 on x86, NEON on AArch64), using the lookup tables of Keiser and Lemire,
+* "Validating UTF-8 In Less Than One Instruction Per Byte". The tables are adjusted to
+* accept exactly what the byte by byte validator accepts: code points up to 0x1FFFFF
+* (lead bytes up to 0xF7) and surrogates are valid, overlong encodings are not.
+* Define NO_UTF8_CHECKER_SIMD to build without them.
+*/
+#if !defined(NO_UTF8_CHECKER_SIMD)
 
-    if (utf8_str == NULL)
+#if (defined(__x86_64__) || defined(__i386__)) && ((defined(__clang__) && (__clang_major__ >= 4)) || (!defined(__clang__) && defined(__GNUC__) && (__GNUC__ >= 5)))
+#define UTF8_CHECKER_SSSE3
+#define UTF8_CHECKER_SSSE3_TARGET __attribute__((target("ssse3")))
+#include <cpuid.h>
+#include <tmmintrin.h>
+#elif (defined(_M_X64) || defined(_M_IX86)) && defined(_MSC_VER) && (_MSC_VER >= 1900)
+#define UTF8_CHECKER_SSSE3
+#define UTF8_CHECKER_SSSE3_TARGET
+#include <intrin.h>
+#include <tmmintrin.h>
+#elif defined(__aarch64__) && (defined(__clang__) || defined(__GNUC__))
+#define UTF8_CHECKER_NEON
+#include <arm_neon.h>
+#endif
+
+#endif /* NO_UTF8_CHECKER_SIMD */
+
+/* strings shorter than this many bytes are not worth going through the SIMD code */
+#define UTF8_CHECKER_SIMD_MIN_LENGTH 64
+
+typedef bool(*UTF8_CHECKER_VALIDATE)(const unsigned char* utf8_str, size_t length);
+
+/* ASCII runs are skipped 16 bytes at a time, 2 words of 8 bytes */
+static size_t utf8_checker_skip_ascii(const unsigned char* utf8_str, size_t pos, size_t length)
+{
+    while (length - pos >= 16)
     {
-        /* Codes_SRS_UTF8_CHECKER_01_002: [ If utf8_checker_is_valid_utf8 is called with NULL utf8_str it shall return false. ]*/
-        result = false;
+        uint64_t words[2];
+        (void)memcpy(words, utf8_str + pos, sizeof(words));
+        if (((words[0] | words[1]) & 0x8080808080808080ULL) != 0)
+        {
+            break;
+        }
+        pos += 16;
     }
-    else
+
+    while ((pos < length) &&
+           ((utf8_str[pos] >> 7) == 0x00))
     {
-        size_t pos = 0;
+        pos++;
+    }
 
-        /* Codes_SRS_UTF8_CHECKER_01_003: [ If length is 0, utf8_checker_is_valid_utf8 shall consider utf8_str to be valid UTF-8 and return true. ]*/
-        result = true;
+    return pos;
+}
 
-        while ((result == true) &&
-               (pos < length))
-        {
-            /* Codes_SRS_UTF8_CHECKER_01_001: [ utf8_checker_is_valid_utf8 shall verify that the sequence of chars pointed to by utf8_str represent UTF-8 encoded codepoints. ]*/
-            if ((utf8_str[pos] >> 3) == 0x1E)
-            {
-                /* 4 bytes */
-                /* Codes_SRS_UTF8_CHECKER_01_009: [ 000uuuuu zzzzyyyy yyxxxxxx 11110uuu 10uuzzzz 10yyyyyy 10xxxxxx ]*/
-                uint32_t code_point = (utf8_str[pos] & 0x07);
+static bool utf8_checker_validate_scalar(const unsigned char* utf8_str, size_t length)
+{
+    size_t pos = 0;
 
-                pos++;
-                if ((pos < length) &&
-                    ((utf8_str[pos] >> 6) == 0x02))
-                {
-                    code_point <<= 6;
-                    code_point += utf8_str[pos] & 0x3F;
+    /* Codes_SRS_UTF8_CHECKER_01_003: [ If length is 0, utf8_checker_is_valid_utf8 shall consider utf8_str to be valid UTF-8 and return true. ]*/
+    bool result = true;
 
-                    pos++;
-                    if ((pos < length) &&
-                        ((utf8_str[pos] >> 6) == 0x02))
-                    {
-                        code_point <<= 6;
-                        code_point += utf8_str[pos] & 0x3F;
+    while ((result == true) &&
+           (pos < length))
+    {
+        /* Codes_SRS_UTF8_CHECKER_01_001: [ utf8_checker_is_valid_utf8 shall verify that the sequence of chars pointed to by utf8_str represent UTF-8 encoded codepoints. ]*/
+        if ((utf8_str[pos] >> 7) == 0x00)
+        {
+            /* 1 byte */
+            /* Codes_SRS_UTF8_CHECKER_01_006: [ 00000000 0xxxxxxx 0xxxxxxx ]*/
+            /* Codes_SRS_UTF8_CHECKER_01_005: [ On success it shall return true. ]*/
+            /* Codes_SRS_UTF8_CHECKER_01_010: [ utf8_checker_is_valid_utf8 shall skip runs of 1 byte code points several bytes at a time. ]*/
+            result = true;
+            pos = utf8_checker_skip_ascii(utf8_str, pos + 1, length);
+        }
+        else if ((utf8_str[pos] >> 3) == 0x1E)
+        {
+            /* 4 bytes */
+            /* Codes_SRS_UTF8_CHECKER_01_009: [ 000uuuuu zzzzyyyy yyxxxxxx 11110uuu 10uuzzzz 10yyyyyy 10xxxxxx ]*/
+            uint32_t code_point = (utf8_str[pos] & 0x07);
 
-                        pos++;
-                        if ((pos < length) &&
-                            ((utf8_str[pos] >> 6) == 0x02))
-                        {
-                            code_point <<= 6;
-                            code_point += utf8_str[pos] & 0x3F;
-
-                            if (code_point <= 0xFFFF)
-                            {
-                                result = false;
-                            }
-                            else
-                            {
-                                /* Codes_SRS_UTF8_CHECKER_01_005: [ On success it shall return true. ]*/
-                                result = true;
-                                pos++;
-                            }
-                        }
-                        else
-                        {
-                            result = false;
-                        }
-                    }
-                    else
-                    {
-                        result = false;
-                    }
-                }
-                else
-                {
-                    result = false;
-                }
-            }
-            else if ((utf8_str[pos] >> 4) == 0x0E)
+            pos++;
+            if ((pos < length) &&
+                ((utf8_str[pos] >> 6) == 0x02))
             {
-                /* 3 bytes */
-                /* Codes_SRS_UTF8_CHECKER_01_008: [ zzzzyyyy yyxxxxxx 1110zzzz 10yyyyyy 10xxxxxx ]*/
-                uint32_t code_point = (utf8_str[pos] & 0x0F);
+                code_point <<= 6;
+                code_point += utf8_str[pos] & 0x3F;
 
                 pos++;
                 if ((pos < length) &&
@@ -107,7 +118,7 @@ bool utf8_checker_is_valid_utf8(const unsigned char* utf8_str, size_t length)
                         code_point <<= 6;
                         code_point += utf8_str[pos] & 0x3F;
 
-                        if (code_point <= 0x7FF)
+                        if (code_point <= 0xFFFF)
                         {
                             result = false;
                         }
@@ -128,11 +139,23 @@ bool utf8_checker_is_valid_utf8(const unsigned char* utf8_str, size_t length)
                     result = false;
                 }
             }
-            else if ((utf8_str[pos] >> 5) == 0x06)
+            else
+            {
+                result = false;
+            }
+        }
+        else if ((utf8_str[pos] >> 4) == 0x0E)
+        {
+            /* 3 bytes */
+            /* Codes_SRS_UTF8_CHECKER_01_008: [ zzzzyyyy yyxxxxxx 1110zzzz 10yyyyyy 10xxxxxx ]*/
+            uint32_t code_point = (utf8_str[pos] & 0x0F);
+
+            pos++;
+            if ((pos < length) &&
+                ((utf8_str[pos] >> 6) == 0x02))
             {
-                /* 2 bytes */
-                /* Codes_SRS_UTF8_CHECKER_01_007: [ 00000yyy yyxxxxxx 110yyyyy 10xxxxxx ]*/
-                uint32_t code_point = (utf8_str[pos] & 0x1F);
+                code_point <<= 6;
+                code_point += utf8_str[pos] & 0x3F;
 
                 pos++;
                 if ((pos < length) &&
@@ -141,7 +164,7 @@ bool utf8_checker_is_valid_utf8(const unsigned char* utf8_str, size_t length)
                     code_point <<= 6;
                     code_point += utf8_str[pos] & 0x3F;
 
-                    if (code_point <= 0x7F)
+                    if (code_point <= 0x7FF)
                     {
                         result = false;
                     }
@@ -157,20 +180,438 @@ bool utf8_checker_is_valid_utf8(const unsigned char* utf8_str, size_t length)
                     result = false;
                 }
             }
-            else if ((utf8_str[pos] >> 7) == 0x00)
+            else
             {
-                /* 1 byte */
-                /* Codes_SRS_UTF8_CHECKER_01_006: [ 00000000 0xxxxxxx 0xxxxxxx ]*/
-                /* Codes_SRS_UTF8_CHECKER_01_005: [ On success it shall return true. ]*/
-                result = true;
-                pos++;
+                result = false;
+            }
+        }
+        else if ((utf8_str[pos] >> 5) == 0x06)
+        {
+            /* 2 bytes */
+            /* Codes_SRS_UTF8_CHECKER_01_007: [ 00000yyy yyxxxxxx 110yyyyy 10xxxxxx ]*/
+            uint32_t code_point = (utf8_str[pos] & 0x1F);
+
+            pos++;
+            if ((pos < length) &&
+                ((utf8_str[pos] >> 6) == 0x02))
+            {
+                code_point <<= 6;
+                code_point += utf8_str[pos] & 0x3F;
+
+                if (code_point <= 0x7F)
+                {
+                    result = false;
+                }
+                else
+                {
+                    /* Codes_SRS_UTF8_CHECKER_01_005: [ On success it shall return true. ]*/
+                    result = true;
+                    pos++;
+                }
             }
             else
             {
-                /* error */
                 result = false;
             }
         }
+        else
+        {
+            /* error */
+            result = false;
+        }
+    }
+
+    return result;
+}
+
+#if defined(UTF8_CHECKER_SSSE3) || defined(UTF8_CHECKER_NEON)
+
+/* The error bits of the lookup tables, each names a pair of bytes that cannot follow each other */
+#define UTF8_TOO_SHORT      0x01 /* 11______ 0_______ or 11______ 11______ */
+#define UTF8_TOO_LONG       0x02 /* 0_______ 10______ */
+#define UTF8_OVERLONG_3     0x04 /* 11100000 100_____ */
+#define UTF8_INVALID_LEAD   0x08 /* 11111___ 10______ */
+#define UTF8_OVERLONG_2     0x20 /* 1100000_ 10______ */
+#define UTF8_OVERLONG_4     0x40 /* 11110000 1000____ */
+#define UTF8_TWO_CONTS      0x80 /* 10______ 10______ */
+#define UTF8_CARRY          (UTF8_TOO_SHORT | UTF8_TOO_LONG | UTF8_TWO_CONTS)
+
+/* indexed by the high nibble of the first byte of a pair */
+static const uint8_t UTF8_BYTE_1_HIGH[16] =
+{
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG, UTF8_TOO_LONG,
+    UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS, UTF8_TWO_CONTS,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_2,
+    UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT | UTF8_OVERLONG_3,
+    UTF8_TOO_SHORT | UTF8_INVALID_LEAD | UTF8_OVERLONG_4
+};
+
+/* indexed by the low nibble of the first byte of a pair */
+static const uint8_t UTF8_BYTE_1_LOW[16] =
+{
+    UTF8_CARRY | UTF8_OVERLONG_2 | UTF8_OVERLONG_3 | UTF8_OVERLONG_4,
+    UTF8_CARRY | UTF8_OVERLONG_2,
+    UTF8_CARRY, UTF8_CARRY, UTF8_CARRY, UTF8_CARRY, UTF8_CARRY, UTF8_CARRY,
+    UTF8_CARRY | UTF8_INVALID_LEAD, UTF8_CARRY | UTF8_INVALID_LEAD,
+    UTF8_CARRY | UTF8_INVALID_LEAD, UTF8_CARRY | UTF8_INVALID_LEAD,
+    UTF8_CARRY | UTF8_INVALID_LEAD, UTF8_CARRY | UTF8_INVALID_LEAD,
+    UTF8_CARRY | UTF8_INVALID_LEAD, UTF8_CARRY | UTF8_INVALID_LEAD
+};
+
+/* indexed by the high nibble of the second byte of a pair */
+static const uint8_t UTF8_BYTE_2_HIGH[16] =
+{
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_OVERLONG_4 | UTF8_INVALID_LEAD,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_OVERLONG_3 | UTF8_INVALID_LEAD,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_INVALID_LEAD,
+    UTF8_TOO_LONG | UTF8_OVERLONG_2 | UTF8_TWO_CONTS | UTF8_INVALID_LEAD,
+    UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT, UTF8_TOO_SHORT
+};
+
+/* a block ending with one of these bytes in its last 3 positions needs continuation bytes from the next block */
+static const uint8_t UTF8_INCOMPLETE_MAX[16] =
+{
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
+    0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xF0 - 1, 0xE0 - 1, 0xC0 - 1
+};
+
+#endif
+
+#if defined(UTF8_CHECKER_SSSE3)
+
+static int utf8_checker_ssse3_available(void)
+{
+    /* SSSE3 is CPUID.1:ECX bit 9 */
+    int result;
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    result = (info[2] & (1 << 9)) != 0;
+#else
+    unsigned int eax, ebx, ecx, edx;
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx) == 0)
+    {
+        result = 0;
+    }
+    else
+    {
+        result = (ecx & (1U << 9)) != 0;
+    }
+#endif
+    return result;
+}
+
+UTF8_CHECKER_SSSE3_TARGET
+static __m128i utf8_checker_ssse3_check_block(__m128i input, __m128i previous_input, __m128i byte_1_high_table, __m128i byte_1_low_table, __m128i byte_2_high_table)
+{
+    const __m128i low_nibble_mask = _mm_set1_epi8(0x0F);
+    __m128i prev1 = _mm_alignr_epi8(input, previous_input, 15);
+    __m128i prev2 = _mm_alignr_epi8(input, previous_input, 14);
+    __m128i prev3 = _mm_alignr_epi8(input, previous_input, 13);
+    __m128i special_cases;
+    __m128i must_be_continuation;
+
+    special_cases = _mm_shuffle_epi8(byte_1_high_table, _mm_and_si128(_mm_srli_epi16(prev1, 4), low_nibble_mask));
+    special_cases = _mm_and_si128(special_cases, _mm_shuffle_epi8(byte_1_low_table, _mm_and_si128(prev1, low_nibble_mask)));
+    special_cases = _mm_and_si128(special_cases, _mm_shuffle_epi8(byte_2_high_table, _mm_and_si128(_mm_srli_epi16(input, 4), low_nibble_mask)));
+
+    /* the third and fourth bytes of 3 and 4 byte sequences must be continuation bytes, the pair check only looks at the second */
+    must_be_continuation = _mm_or_si128(_mm_subs_epu8(prev2, _mm_set1_epi8((char)(0xE0 - 0x80))), _mm_subs_epu8(prev3, _mm_set1_epi8((char)(0xF0 - 0x80))));
+    must_be_continuation = _mm_and_si128(must_be_continuation, _mm_set1_epi8((char)0x80));
+
+    return _mm_xor_si128(must_be_continuation, special_cases);
+}
+
+UTF8_CHECKER_SSSE3_TARGET
+static bool utf8_checker_validate_ssse3(const unsigned char* utf8_str, size_t length)
+{
+    const __m128i byte_1_high_table = _mm_loadu_si128((const __m128i*)UTF8_BYTE_1_HIGH);
+    const __m128i byte_1_low_table = _mm_loadu_si128((const __m128i*)UTF8_BYTE_1_LOW);
+    const __m128i byte_2_high_table = _mm_loadu_si128((const __m128i*)UTF8_BYTE_2_HIGH);
+    const __m128i incomplete_max = _mm_loadu_si128((const __m128i*)UTF8_INCOMPLETE_MAX);
+    __m128i error = _mm_setzero_si128();
+    __m128i previous_input = _mm_setzero_si128();
+    __m128i previous_incomplete = _mm_setzero_si128();
+    unsigned char last_block[16];
+    size_t pos = 0;
+
+    for (;;)
+    {
+        __m128i input;
+        if (length - pos >= 16)
+        {
+            input = _mm_loadu_si128((const __m128i*)(utf8_str + pos));
+        }
+        else
+        {
+            /* the last block is padded with 0s, which also flags a sequence cut by the end of the string */
+            (void)memset(last_block, 0, sizeof(last_block));
+            (void)memcpy(last_block, utf8_str + pos, length - pos);
+            input = _mm_loadu_si128((const __m128i*)last_block);
+        }
+
+        if (_mm_movemask_epi8(input) == 0)
+        {
+            /* Codes_SRS_UTF8_CHECKER_01_010: [ utf8_checker_is_valid_utf8 shall skip runs of 1 byte code points several bytes at a time. ]*/
+            error = _mm_or_si128(error, previous_incomplete);
+        }
+        else
+        {
+            error = _mm_or_si128(error, utf8_checker_ssse3_check_block(input, previous_input, byte_1_high_table, byte_1_low_table, byte_2_high_table));
+            previous_incomplete = _mm_subs_epu8(input, incomplete_max);
+        }
+        previous_input = input;
+
+        if (length - pos < 16)
+        {
+            break;
+        }
+        pos += 16;
+    }
+
+    return _mm_movemask_epi8(_mm_cmpeq_epi8(error, _mm_setzero_si128())) == 0xFFFF;
+}
+
+#elif defined(UTF8_CHECKER_NEON)
+
+static uint8x16_t utf8_checker_neon_check_block(uint8x16_t input, uint8x16_t previous_input, uint8x16_t byte_1_high_table, uint8x16_t byte_1_low_table, uint8x16_t byte_2_high_table)
+{
+    const uint8x16_t low_nibble_mask = vdupq_n_u8(0x0F);
+    uint8x16_t prev1 = vextq_u8(previous_input, input, 15);
+    uint8x16_t prev2 = vextq_u8(previous_input, input, 14);
+    uint8x16_t prev3 = vextq_u8(previous_input, input, 13);
+    uint8x16_t special_cases;
+    uint8x16_t must_be_continuation;
+
+    special_cases = vqtbl1q_u8(byte_1_high_table, vshrq_n_u8(prev1, 4));
+    special_cases = vandq_u8(special_cases, vqtbl1q_u8(byte_1_low_table, vandq_u8(prev1, low_nibble_mask)));
+    special_cases = vandq_u8(special_cases, vqtbl1q_u8(byte_2_high_table, vshrq_n_u8(input, 4)));
+
+    /* the third and fourth bytes of 3 and 4 byte sequences must be continuation bytes, the pair check only looks at the second */
+    must_be_continuation = vorrq_u8(vqsubq_u8(prev2, vdupq_n_u8(0xE0 - 0x80)), vqsubq_u8(prev3, vdupq_n_u8(0xF0 - 0x80)));
+    must_be_continuation = vandq_u8(must_be_continuation, vdupq_n_u8(0x80));
+
+    return veorq_u8(must_be_continuation, special_cases);
+}
+
+static bool utf8_checker_validate_neon(const unsigned char* utf8_str, size_t length)
+{
+    const uint8x16_t byte_1_high_table = vld1q_u8(UTF8_BYTE_1_HIGH);
+    const uint8x16_t byte_1_low_table = vld1q_u8(UTF8_BYTE_1_LOW);
+    const uint8x16_t byte_2_high_table = vld1q_u8(UTF8_BYTE_2_HIGH);
+    const uint8x16_t incomplete_max = vld1q_u8(UTF8_INCOMPLETE_MAX);
+    uint8x16_t error = vdupq_n_u8(0);
+    uint8x16_t previous_input = vdupq_n_u8(0);
+    uint8x16_t previous_incomplete = vdupq_n_u8(0);
+    unsigned char last_block[16];
+    size_t pos = 0;
+
+    for (;;)
+    {
+        uint8x16_t input;
+        if (length - pos >= 16)
+        {
+            input = vld1q_u8(utf8_str + pos);
+        }
+        else
+        {
+            /* the last block is padded with 0s, which also flags a sequence cut by the end of the string */
+            (void)memset(last_block, 0, sizeof(last_block));
+            (void)memcpy(last_block, utf8_str + pos, length - pos);
+            input = vld1q_u8(last_block);
+        }
+
+        if (vmaxvq_u8(input) < 0x80)
+        {
+            /* Codes_SRS_UTF8_CHECKER_01_010: [ utf8_checker_is_valid_utf8 shall skip runs of 1 byte code points several bytes at a time. ]*/
+            error = vorrq_u8(error, previous_incomplete);
+        }
+        else
+        {
+            error = vorrq_u8(error, utf8_checker_neon_check_block(input, previous_input, byte_1_high_table, byte_1_low_table, byte_2_high_table));
+            previous_incomplete = vqsubq_u8(input, incomplete_max);
+        }
+        previous_input = input;
+
+        if (length - pos < 16)
+        {
+            break;
+        }
+        pos += 16;
+    }
+
+    return vmaxvq_u8(error) == 0;
+}
+
+#endif
+
+/* The validator of long strings, resolved on first use; threads racing to resolve it all store the same value */
+static UTF8_CHECKER_VALIDATE utf8_checker_validate_long = NULL;
+
+static UTF8_CHECKER_VALIDATE utf8_checker_get_validate_long(void)
+{
+    UTF8_CHECKER_VALIDATE result = utf8_checker_validate_long;
+    if (result == NULL)
+    {
+#if defined(UTF8_CHECKER_SSSE3)
+        result = utf8_checker_ssse3_available() ? utf8_checker_validate_ssse3 : utf8_checker_validate_scalar;
+#elif defined(UTF8_CHECKER_NEON)
+        result = utf8_checker_validate_neon;
+#else
+        result = utf8_checker_validate_scalar;
+#endif
+        utf8_checker_validate_long = result;
+    }
+    return result;
+}
+
+bool utf8_checker_is_valid_utf8(const unsigned char* utf8_str, size_t length)
+{
+    bool result;
+
+    if (utf8_str == NULL)
+    {
+        /* Codes_SRS_UTF8_CHECKER_01_002: [ If utf8_checker_is_valid_utf8 is called with NULL utf8_str it shall return false. ]*/
+        result = false;
+    }
+    else if (length < UTF8_CHECKER_SIMD_MIN_LENGTH)
+    {
+        result = utf8_checker_validate_scalar(utf8_str, length);
+    }
+    else
+    {
+        /* Codes_SRS_UTF8_CHECKER_01_011: [ When the CPU has SIMD instructions, utf8_checker_is_valid_utf8 shall validate long strings 16 bytes at a time and accept exactly the strings the byte by byte validation accepts. ]*/
+        result = utf8_checker_get_validate_long()(utf8_str, length);
+    }
+
+    return result;
+}
+
+/* returns the number of bytes of the code point starting with lead_byte, or 0 if it is not a lead byte */
+static size_t utf8_checker_sequence_length(unsigned char lead_byte)
+{
+    size_t result;
+    if (((lead_byte >> 6) == 0x03) &&
+        (lead_byte < 0xF8))
+    {
+        result = (lead_byte >= 0xF0) ? 4 : ((lead_byte >= 0xE0) ? 3 : 2);
+    }
+    else
+    {
+        result = 0;
+    }
+    return result;
+}
+
+void utf8_checker_init(UTF8_CHECKER_STATE* state)
+{
+    /* Codes_SRS_UTF8_CHECKER_01_012: [ If state is NULL, utf8_checker_init shall return. ]*/
+    if (state != NULL)
+    {
+        /* Codes_SRS_UTF8_CHECKER_01_013: [ utf8_checker_init shall set state to hold an empty, valid string. ]*/
+        state->pending_length = 0;
+        state->is_valid = true;
+    }
+}
+
+bool utf8_checker_validate_fragment(UTF8_CHECKER_STATE* state, const unsigned char* utf8_str, size_t length)
+{
+    bool result;
+
+    if ((state == NULL) ||
+        (utf8_str == NULL))
+    {
+        /* Codes_SRS_UTF8_CHECKER_01_014: [ If state or utf8_str is NULL, utf8_checker_validate_fragment shall return false. ]*/
+        result = false;
+    }
+    else if (!state->is_valid)
+    {
+        /* Codes_SRS_UTF8_CHECKER_01_015: [ If a previous fragment was found not to be valid UTF-8, utf8_checker_validate_fragment shall return false. ]*/
+        result = false;
+    }
+    else
+    {
+        size_t pos = 0;
+
+        /* Codes_SRS_UTF8_CHECKER_01_016: [ utf8_checker_validate_fragment shall first complete the code point left incomplete by the previous fragment with the first bytes of utf8_str and validate it. ]*/
+        if (state->pending_length > 0)
+        {
+            size_t needed = utf8_checker_sequence_length(state->pending[0]);
+            bool is_cut = false;
+            while ((state->pending_length < needed) &&
+                   (pos < length) &&
+                   !is_cut)
+            {
+                /* a byte other than a continuation byte ends the code point early, which makes it invalid */
+                is_cut = ((utf8_str[pos] >> 6) != 0x02);
+                state->pending[state->pending_length++] = utf8_str[pos++];
+            }
+
+            if ((state->pending_length == needed) ||
+                is_cut)
+            {
+                state->is_valid = utf8_checker_validate_scalar(state->pending, state->pending_length);
+                state->pending_length = 0;
+            }
+        }
+
+        /* a pending code point still incomplete means all of utf8_str went into it */
+        if ((state->is_valid) &&
+            (state->pending_length == 0))
+        {
+            size_t tail_length = 0;
+            size_t i;
+
+            /* Codes_SRS_UTF8_CHECKER_01_017: [ A code point cut by the end of utf8_str shall be kept in state and validated with the next fragment. ]*/
+            for (i = 1; (i <= 3) && (i <= length - pos); i++)
+            {
+                unsigned char current_byte = utf8_str[length - i];
+                if ((current_byte >> 6) != 0x02)
+                {
+                    if (utf8_checker_sequence_length(current_byte) > i)
+                    {
+                        tail_length = i;
+                    }
+                    break;
+                }
+            }
+
+            /* Codes_SRS_UTF8_CHECKER_01_018: [ The remaining bytes of utf8_str shall be validated as utf8_checker_is_valid_utf8 does. ]*/
+            state->is_valid = utf8_checker_is_valid_utf8(utf8_str + pos, length - pos - tail_length);
+            if (state->is_valid)
+            {
+                (void)memcpy(state->pending, utf8_str + length - tail_length, tail_length);
+                state->pending_length = tail_length;
+            }
+        }
+
+        /* Codes_SRS_UTF8_CHECKER_01_019: [ utf8_checker_validate_fragment shall return true if all the bytes seen so far are valid UTF-8, possibly ending with an incomplete code point, and false otherwise. ]*/
+        result = state->is_valid;
+    }
+
+    return result;
+}
+
+bool utf8_checker_complete(UTF8_CHECKER_STATE* state)
+{
+    bool result;
+
+    if (state == NULL)
+    {
+        /* Codes_SRS_UTF8_CHECKER_01_020: [ If state is NULL, utf8_checker_complete shall return false. ]*/
+        result = false;
+    }
+    else
+    {
+        /* Codes_SRS_UTF8_CHECKER_01_021: [ utf8_checker_complete shall return true if all the fragments were valid UTF-8 and the last one did not end with an incomplete code point, and false otherwise. ]*/
+        result = state->is_valid && (state->pending_length == 0);
+
+        /* Codes_SRS_UTF8_CHECKER_01_022: [ utf8_checker_complete shall reset state so that it can be used for the next message. ]*/
+        utf8_checker_init(state);
     }
 
     return result;
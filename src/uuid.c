@@ -9,8 +9,6 @@
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
 
-#define UUID_STRING_LENGTH          36
-#define UUID_STRING_SIZE            (UUID_STRING_LENGTH + 1)
 #define __SUCCESS__                 0
 #define UUID_FORMAT_STRING          "%02x%02x%02x%02x-%02x%02x-%02x%02x-%02x%02x-%02x%02x%02x%02x%02x%02x"
 
@@ -75,6 +73,49 @@ int UUID_from_string(const char* uuid_string, UUID_T* uuid)
     return result;
 }
 
+static const char hex_digits[] = "0123456789abcdef";
+
+int UUID_to_string_buffer(const UUID_T* uuid, char* buffer, size_t buffer_size)
+{
+    int result;
+
+    // Codes_SRS_UUID_09_017: [ If uuid or buffer are NULL, UUID_to_string_buffer shall return a non-zero value ]
+    if (uuid == NULL || buffer == NULL)
+    {
+        LogError("Invalid argument (uuid=%p, buffer=%p)", uuid, buffer);
+        result = __FAILURE__;
+    }
+    // Codes_SRS_UUID_09_018: [ If buffer_size is less than UUID_STRING_SIZE, UUID_to_string_buffer shall return a non-zero value ]
+    else if (buffer_size < UUID_STRING_SIZE)
+    {
+        LogError("Buffer too small for an UUID string (%lu)", (unsigned long)buffer_size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        const unsigned char* uuid_bytes = (const unsigned char*)uuid;
+        size_t i;
+        size_t j = 0;
+
+        // Codes_SRS_UUID_09_019: [ Each character in uuid shall be written in the respective positions of buffer as a 2-digit lowercase HEX value, with dashes as per RFC 4122, followed by a null terminator ]
+        for (i = 0; i < sizeof(UUID_T); i++)
+        {
+            if (i == 4 || i == 6 || i == 8 || i == 10)
+            {
+                buffer[j++] = '-';
+            }
+            buffer[j++] = hex_digits[uuid_bytes[i] >> 4];
+            buffer[j++] = hex_digits[uuid_bytes[i] & 0x0f];
+        }
+        buffer[j] = '\0';
+
+        // Codes_SRS_UUID_09_020: [ If no failures occur, UUID_to_string_buffer shall return zero ]
+        result = __SUCCESS__;
+    }
+
+    return result;
+}
+
 char* UUID_to_string(const UUID_T* uuid)
 {
     char* result;
@@ -91,24 +132,13 @@ char* UUID_to_string(const UUID_T* uuid)
         // Codes_SRS_UUID_09_013: [ If uuid_string fails to be allocated, UUID_to_string shall return NULL ]
         LogError("Failed allocating UUID string");
     }
-    else
+    // Codes_SRS_UUID_09_014: [ Each character in uuid shall be written in the respective positions of uuid_string as a 2-digit HEX value ]
+    else if (UUID_to_string_buffer(uuid, result, UUID_STRING_SIZE) != 0)
     {
-        unsigned char* uuid_bytes;
-        int number_of_chars_written;
-
-        uuid_bytes = (unsigned char*)uuid;
-
-        // Codes_SRS_UUID_09_014: [ Each character in uuid shall be written in the respective positions of uuid_string as a 2-digit HEX value ]  
-        number_of_chars_written = sprintf(result, "%" PRI_UUID,
-            UUID_FORMAT_VALUES(uuid_bytes));
-
-        if (number_of_chars_written != UUID_STRING_LENGTH)
-        {
-            // Tests_SRS_UUID_09_015: [ If uuid_string fails to be set, UUID_to_string shall return NULL ]
-            LogError("Failed encoding UUID string");
-            free(result);
-            result = NULL;
-        }
+        // Codes_SRS_UUID_09_015: [ If uuid_string fails to be set, UUID_to_string shall return NULL ]
+        LogError("Failed encoding UUID string");
+        free(result);
+        result = NULL;
     }
 
     // Codes_SRS_UUID_09_016: [ If no failures occur, UUID_to_string shall return uuid_string ]
@@ -125,42 +155,17 @@ int UUID_generate(UUID_T* uuid)
         LogError("Invalid argument (uuid is NULL)");
         result = __FAILURE__;
     }
+    // Codes_SRS_UUID_09_002: [ UUID_generate shall obtain the UUID bytes from UniqueId_GenerateBinary, writing them directly in uuid ]
+    else if (UniqueId_GenerateBinary(*uuid, sizeof(UUID_T)) != UNIQUEID_OK)
+    {
+        // Codes_SRS_UUID_09_003: [ If the UUID fails to be obtained, UUID_generate shall fail and return a non-zero value ]
+        LogError("Failed generating UUID");
+        result = __FAILURE__;
+    }
     else
     {
-        char* uuid_string;
-
-        if ((uuid_string = (char*)malloc(sizeof(char) * UUID_STRING_SIZE)) == NULL)
-        {
-            // Codes_SRS_UUID_09_003: [ If the UUID string fails to be obtained, UUID_generate shall fail and return a non-zero value ]
-            LogError("Failed allocating UUID string");
-            result = __FAILURE__;
-        }
-        else
-        {
-            (void)memset(uuid_string, 0, sizeof(char) * UUID_STRING_SIZE);
-
-            // Codes_SRS_UUID_09_002: [ UUID_generate shall obtain an UUID string from UniqueId_Generate ]
-            if (UniqueId_Generate(uuid_string, UUID_STRING_SIZE) != UNIQUEID_OK)
-            {
-                // Codes_SRS_UUID_09_003: [ If the UUID string fails to be obtained, UUID_generate shall fail and return a non-zero value ]
-                LogError("Failed generating UUID");
-                result = __FAILURE__;
-            }
-            // Codes_SRS_UUID_09_004: [ The UUID string shall be parsed into an UUID_T type (16 unsigned char array) and filled in uuid ]
-            else if (UUID_from_string(uuid_string, uuid) != 0)
-            {
-                // Codes_SRS_UUID_09_005: [ If uuid fails to be set, UUID_generate shall fail and return a non-zero value ]
-                LogError("Failed parsing UUID string");
-                result = __FAILURE__;
-            }
-            else
-            {
-                // Codes_SRS_UUID_09_006: [ If no failures occur, UUID_generate shall return zero ]
-                result = __SUCCESS__;
-            }
-
-            free(uuid_string);
-        }
+        // Codes_SRS_UUID_09_006: [ If no failures occur, UUID_generate shall return zero ]
+        result = __SUCCESS__;
     }
 
     return result;
@@ -11,7 +11,8 @@
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/xio.h"
-#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/xio_trace.h"
+#include "azure_c_shared_utility/doublylinkedlist.h"
 #include "azure_c_shared_utility/socketio.h"
 #include "azure_c_shared_utility/platform.h"
 #include "azure_c_shared_utility/tlsio.h"
@@ -24,13 +25,32 @@
 #include "azure_c_shared_utility/base64.h"
 #include "azure_c_shared_utility/optionhandler.h"
 #include "azure_c_shared_utility/map.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/timer_wheel.h"
+
+#ifdef USE_WS_PERMESSAGE_DEFLATE
+#include "zlib.h"
+#endif
 
 static const char* UWS_CLIENT_OPTIONS = "uWSClientOptions";
 
+#ifdef USE_WS_PERMESSAGE_DEFLATE
+static const char* SEC_WEBSOCKET_EXTENSIONS_HEADER = "Sec-WebSocket-Extensions";
+static const char* PERMESSAGE_DEFLATE_EXTENSION = "permessage-deflate";
+/* the empty stored block a Z_SYNC_FLUSH ends with, removed from each message sent and appended to each message received */
+static const unsigned char DEFLATE_MESSAGE_TAIL[] = { 0x00, 0x00, 0xFF, 0xFF };
+/* RSV1 as passed to uws_frame_encoder_encode */
+#define WS_RESERVED_RSV1 0x04
+#endif
+
 static const char* HTTP_HEADER_KEY_VALUE_SEPARATOR = ": ";
 static const size_t HTTP_HEADER_KEY_VALUE_SEPARATOR_LENGTH = 2;
 static const char* HTTP_HEADER_TERMINATOR = "\r\n";
 static const size_t HTTP_HEADER_TERMINATOR_LENGTH = 2;
+/* the 16 bytes of the nonce always encode to 24 base64 characters */
+#define WS_NONCE_SIZE 16
+#define WS_BASE64_NONCE_LENGTH 24
 
 /* Requirements not needed as they are optional:
 Codes_SRS_UWS_CLIENT_01_254: [ If an endpoint receives a Ping frame and has not yet sent Pong frame(s) in response to previous Ping frame(s), the endpoint MAY elect to send a Pong frame for only the most recently processed Ping frame. ]
@@ -66,16 +86,39 @@ typedef struct WS_INSTANCE_PROTOCOL_TAG
     char* protocol;
 } WS_INSTANCE_PROTOCOL;
 
+/* A data frame sent as fragments, its payload follows the structure */
+typedef struct WS_UNSENT_MESSAGE_TAG
+{
+    /* the opcode and RSV bits of the next fragment */
+    unsigned char frame_type;
+    unsigned char reserved;
+    bool is_final;
+    bool fragment_in_flight;
+    size_t payload_size;
+    size_t sent_size;
+    /* the pending send of the next message waiting to be sent as fragments */
+    struct WS_PENDING_SEND_TAG* next_unsent_send;
+} WS_UNSENT_MESSAGE;
+
 typedef struct WS_PENDING_SEND_TAG
 {
+    DLIST_ENTRY link;
     ON_WS_SEND_FRAME_COMPLETE on_ws_send_frame_complete;
     void* context;
     UWS_CLIENT_HANDLE uws_client;
+    /* the pending send of the next frame sent by the same xio_send, NULL for the last one */
+    struct WS_PENDING_SEND_TAG* next_batched_send;
+    /* NULL when the frame was encoded and sent in one piece */
+    WS_UNSENT_MESSAGE* unsent_message;
+#ifdef XIO_TRACE
+    /* from uws_client_send_frame_async to on_ws_send_frame_complete, the span of the xio_send of the frame is its child */
+    XIO_TRACE_SPAN trace_span;
+#endif
 } WS_PENDING_SEND;
 
 typedef struct UWS_CLIENT_INSTANCE_TAG
 {
-    SINGLYLINKEDLIST_HANDLE pending_sends;
+    DLIST_ENTRY pending_sends;
     XIO_HANDLE underlying_io;
     char* hostname;
     char* resource_name;
@@ -94,13 +137,113 @@ typedef struct UWS_CLIENT_INSTANCE_TAG
     void* on_ws_error_context;
     ON_WS_CLOSE_COMPLETE on_ws_close_complete;
     void* on_ws_close_complete_context;
+    /* stream_buffer points to the first byte not yet decoded, somewhere inside stream_buffer_memory */
     unsigned char* stream_buffer;
     size_t stream_buffer_count;
+    unsigned char* stream_buffer_memory;
+    size_t stream_buffer_size;
+    /* with a receive buffer size the memory after the pending bytes is lent to the underlying IO, for it to read
+       the next bytes into it, and grown to that size when less than half of it is left; the underlying IO of a
+       connection that cannot read into it is not asked again */
+    size_t receive_buffer_size;
+    bool receive_buffer_not_lendable;
     unsigned char* fragment_buffer;
     size_t fragment_buffer_count;
+    size_t fragment_buffer_size;
     unsigned char fragmented_frame_type;
+    /* with receive limits each frame is checked as soon as its header is received, received_message_size being the
+       payload of the fragments received so far for the current message */
+    WS_RECEIVE_LIMITS receive_limits;
+    size_t received_message_size;
+    ON_WS_FRAGMENT_RECEIVED on_ws_fragment_received;
+    void* on_ws_fragment_received_context;
+    XIO_STATS stats;
+    /* data frames are laid out here, the memory is kept for the next frames */
+    unsigned char* send_buffer;
+    size_t send_buffer_size;
+    /* with send coalescing the frames waiting to be sent are the first send_batch_length bytes of send_buffer,
+       their pending sends chained from send_batch_first_item */
+    size_t send_coalescing_size;
+    size_t send_batch_length;
+    WS_PENDING_SEND* send_batch_first_item;
+    WS_PENDING_SEND* send_batch_last_item;
+    /* with a send fragment size the big data frames and the data frames sent after them are released one fragment at a time,
+       from unsent_first_item, while control frames are sent at once */
+    size_t send_fragment_size;
+    WS_PENDING_SEND* unsent_first_item;
+    WS_PENDING_SEND* unsent_last_item;
+    bool sending_fragments;
+    /* the upgrade request is built once, only its Sec-WebSocket-Key is replaced for each open;
+       it is freed when a request header or the extension offer changes */
+    char* upgrade_request;
+    size_t upgrade_request_length;
+    size_t upgrade_request_key_offset;
+    /* with keepalive one timer runs while the instance is OPEN, for the ping interval and then, once a Ping was sent,
+       for the pong timeout; any byte received in the meantime counts as a sign of life */
+    WS_KEEPALIVE_OPTIONS keepalive_options;
+    TIMER_WHEEL_HANDLE keepalive_timer_wheel;
+    TIMER_WHEEL_TIMER_HANDLE keepalive_timer;
+    bool keepalive_waiting_for_pong;
+    bool keepalive_bytes_received;
+    /* monotonic time by which the keepalive timer expires, for uws_client_dowork_ex */
+    uint64_t keepalive_deadline_us;
+#ifdef USE_WS_PERMESSAGE_DEFLATE
+    bool permessage_deflate_requested;
+    WS_PERMESSAGE_DEFLATE_OPTIONS permessage_deflate_options;
+    bool permessage_deflate_negotiated;
+    bool client_no_context_takeover;
+    bool server_no_context_takeover;
+    bool receiving_compressed_message;
+    bool sending_compressed_message;
+    /* what the fragments received so far for the current compressed message decompressed to */
+    size_t inflated_message_size;
+    z_stream deflate_stream;
+    z_stream inflate_stream;
+    unsigned char* deflate_buffer;
+    size_t deflate_buffer_size;
+    unsigned char* inflate_buffer;
+    size_t inflate_buffer_size;
+#endif
 } UWS_CLIENT_INSTANCE;
 
+#ifdef USE_WS_PERMESSAGE_DEFLATE
+static voidpf permessage_deflate_alloc(voidpf opaque, uInt items, uInt size)
+{
+    void* result;
+    (void)opaque;
+
+    if ((size != 0) && (items > SIZE_MAX / size))
+    {
+        result = Z_NULL;
+    }
+    else
+    {
+        result = malloc((size_t)items * size);
+    }
+
+    return result;
+}
+
+static void permessage_deflate_free(voidpf opaque, voidpf address)
+{
+    (void)opaque;
+    free(address);
+}
+
+static void end_permessage_deflate(UWS_CLIENT_INSTANCE* uws_client)
+{
+    if (uws_client->permessage_deflate_negotiated)
+    {
+        (void)deflateEnd(&uws_client->deflate_stream);
+        (void)inflateEnd(&uws_client->inflate_stream);
+        uws_client->permessage_deflate_negotiated = false;
+    }
+
+    uws_client->receiving_compressed_message = false;
+    uws_client->sending_compressed_message = false;
+}
+#endif
+
 /* Codes_SRS_UWS_CLIENT_01_360: [ Connection confidentiality and integrity is provided by running the WebSocket Protocol over TLS (wss URIs). ]*/
 /* Codes_SRS_UWS_CLIENT_01_361: [ WebSocket implementations MUST support TLS and SHOULD employ it when communicating with their peers. ]*/
 /* Codes_SRS_UWS_CLIENT_01_063: [ A client will need to supply a /host/, /port/, /resource name/, and a /secure/ flag, which are the components of a WebSocket URI as discussed in Section 3, along with a list of /protocols/ and /extensions/ to be used. ]*/
@@ -146,6 +289,7 @@ UWS_CLIENT_HANDLE uws_client_create(const char* hostname, unsigned int port, con
             else
             {
                 (void)memset(result, 0, sizeof(UWS_CLIENT_INSTANCE));
+                result->stats.layer_name = "uws_client";
 
                 /* Codes_SRS_UWS_CLIENT_01_004: [ The argument hostname shall be copied for later use. ]*/
                 if (mallocAndStrcpy_s(&result->hostname, hostname) != 0)
@@ -176,12 +320,78 @@ UWS_CLIENT_HANDLE uws_client_create(const char* hostname, unsigned int port, con
                     }
                     else
                     {
-                        /* Codes_SRS_UWS_CLIENT_01_017: [ uws_client_create shall create a pending send IO list that is to be used to queue send packets by calling singlylinkedlist_create. ]*/
-                        result->pending_sends = singlylinkedlist_create();
-                        if (result->pending_sends == NULL)
+                        /* Codes_SRS_UWS_CLIENT_01_017: [ uws_client_create shall initialize an empty pending send IO list that is to be used to queue send packets. ]*/
+                        DList_InitializeListHead(&result->pending_sends);
+
+                        if (use_ssl == true)
+                        {
+                            TLSIO_CONFIG tlsio_config;
+
+                            /* Codes_SRS_UWS_CLIENT_01_006: [ If use_ssl is true then uws_client_create shall obtain the interface used to create a tlsio instance by calling platform_get_default_tlsio. ]*/
+                            /* Codes_SRS_UWS_CLIENT_01_076: [ If /secure/ is true, the client MUST perform a TLS handshake over the connection after opening the connection and before sending the handshake data [RFC2818]. ]*/
+                            const IO_INTERFACE_DESCRIPTION* tlsio_interface = platform_get_default_tlsio();
+                            if (tlsio_interface == NULL)
+                            {
+                                /* Codes_SRS_UWS_CLIENT_01_007: [ If obtaining the underlying IO interface fails, then uws_client_create shall fail and return NULL. ]*/
+                                LogError("NULL TLSIO interface description");
+                                result->underlying_io = NULL;
+                            }
+                            else
+                            {
+                                SOCKETIO_CONFIG socketio_config;
+
+                                /* Codes_SRS_UWS_CLIENT_01_013: [ The create arguments for the tls IO (when use_ssl is 1) shall have: ]*/
+                                /* Codes_SRS_UWS_CLIENT_01_014: [ - hostname set to the hostname argument passed to uws_client_create. ]*/
+                                /* Codes_SRS_UWS_CLIENT_01_015: [ - port set to the port argument passed to uws_client_create. ]*/
+                                socketio_config.hostname = hostname;
+                                socketio_config.port = port;
+                                socketio_config.accepted_socket = NULL;
+
+                                tlsio_config.hostname = hostname;
+                                tlsio_config.port = port;
+                                tlsio_config.underlying_io_interface = socketio_get_interface_description();
+                                tlsio_config.underlying_io_parameters = &socketio_config;
+
+                                result->underlying_io = xio_create(tlsio_interface, &tlsio_config);
+                                if (result->underlying_io == NULL)
+                                {
+                                    LogError("Cannot create underlying TLS IO.");
+                                }
+                            }
+                        }
+                        else
+                        {
+                            SOCKETIO_CONFIG socketio_config;
+                            /* Codes_SRS_UWS_CLIENT_01_005: [ If use_ssl is false then uws_client_create shall obtain the interface used to create a socketio instance by calling socketio_get_interface_description. ]*/
+                            const IO_INTERFACE_DESCRIPTION* socketio_interface = socketio_get_interface_description();
+                            if (socketio_interface == NULL)
+                            {
+                                /* Codes_SRS_UWS_CLIENT_01_007: [ If obtaining the underlying IO interface fails, then uws_client_create shall fail and return NULL. ]*/
+                                LogError("NULL socketio interface description");
+                                result->underlying_io = NULL;
+                            }
+                            else
+                            {
+                                /* Codes_SRS_UWS_CLIENT_01_010: [ The create arguments for the socket IO (when use_ssl is 0) shall have: ]*/
+                                /* Codes_SRS_UWS_CLIENT_01_011: [ - hostname set to the hostname argument passed to uws_client_create. ]*/
+                                /* Codes_SRS_UWS_CLIENT_01_012: [ - port set to the port argument passed to uws_client_create. ]*/
+                                socketio_config.hostname = hostname;
+                                socketio_config.port = port;
+                                socketio_config.accepted_socket = NULL;
+
+                                /* Codes_SRS_UWS_CLIENT_01_008: [ The obtained interface shall be used to create the IO used as underlying IO by the newly created uws instance. ]*/
+                                /* Codes_SRS_UWS_CLIENT_01_009: [ The underlying IO shall be created by calling xio_create. ]*/
+                                result->underlying_io = xio_create(socketio_interface, &socketio_config);
+                                if (result->underlying_io == NULL)
+                                {
+                                    LogError("Cannot create underlying socket IO.");
+                                }
+                            }
+                        }
+
+                        if (result->underlying_io == NULL)
                         {
-                            /* Codes_SRS_UWS_CLIENT_01_018: [ If singlylinkedlist_create fails then uws_client_create shall fail and return NULL. ]*/
-                            LogError("Could not allocate pending send frames list");
+                            /* Codes_SRS_UWS_CLIENT_01_016: [ If xio_create fails, then uws_client_create shall fail and return NULL. ]*/
                             Map_Destroy(result->request_headers);
                             free(result->resource_name);
                             free(result->hostname);
@@ -190,107 +400,58 @@ UWS_CLIENT_HANDLE uws_client_create(const char* hostname, unsigned int port, con
                         }
                         else
                         {
-                            if (use_ssl == true)
-                            {
-                                TLSIO_CONFIG tlsio_config;
+                            result->uws_state = UWS_STATE_CLOSED;
+                            /* Codes_SRS_UWS_CLIENT_01_403: [ The argument port shall be copied for later use. ]*/
+                            result->port = port;
 
-                                /* Codes_SRS_UWS_CLIENT_01_006: [ If use_ssl is true then uws_client_create shall obtain the interface used to create a tlsio instance by calling platform_get_default_tlsio. ]*/
-                                /* Codes_SRS_UWS_CLIENT_01_076: [ If /secure/ is true, the client MUST perform a TLS handshake over the connection after opening the connection and before sending the handshake data [RFC2818]. ]*/
-                                const IO_INTERFACE_DESCRIPTION* tlsio_interface = platform_get_default_tlsio();
-                                if (tlsio_interface == NULL)
-                                {
-                                    /* Codes_SRS_UWS_CLIENT_01_007: [ If obtaining the underlying IO interface fails, then uws_client_create shall fail and return NULL. ]*/
-                                    LogError("NULL TLSIO interface description");
-                                    result->underlying_io = NULL;
-                                }
-                                else
-                                {
-                                    SOCKETIO_CONFIG socketio_config;
-
-                                    /* Codes_SRS_UWS_CLIENT_01_013: [ The create arguments for the tls IO (when use_ssl is 1) shall have: ]*/
-                                    /* Codes_SRS_UWS_CLIENT_01_014: [ - hostname set to the hostname argument passed to uws_client_create. ]*/
-                                    /* Codes_SRS_UWS_CLIENT_01_015: [ - port set to the port argument passed to uws_client_create. ]*/
-                                    socketio_config.hostname = hostname;
-                                    socketio_config.port = port;
-                                    socketio_config.accepted_socket = NULL;
-
-                                    tlsio_config.hostname = hostname;
-                                    tlsio_config.port = port;
-                                    tlsio_config.underlying_io_interface = socketio_get_interface_description();
-                                    tlsio_config.underlying_io_parameters = &socketio_config;
-
-                                    result->underlying_io = xio_create(tlsio_interface, &tlsio_config);
-                                    if (result->underlying_io == NULL)
-                                    {
-                                        LogError("Cannot create underlying TLS IO.");
-                                    }
-                                }
+                            result->fragmented_frame_type = WS_FRAME_TYPE_UNKNOWN;
+
+                            result->protocol_count = protocol_count;
+
+                            /* Codes_SRS_UWS_CLIENT_01_410: [ The protocols argument shall be allowed to be NULL, in which case no protocol is to be specified by the client in the upgrade request. ]*/
+                            if (protocols == NULL)
+                            {
+                                result->protocols = NULL;
                             }
                             else
                             {
-                                SOCKETIO_CONFIG socketio_config;
-                                /* Codes_SRS_UWS_CLIENT_01_005: [ If use_ssl is false then uws_client_create shall obtain the interface used to create a socketio instance by calling socketio_get_interface_description. ]*/
-                                const IO_INTERFACE_DESCRIPTION* socketio_interface = socketio_get_interface_description();
-                                if (socketio_interface == NULL)
+                                result->protocols = (WS_INSTANCE_PROTOCOL*)malloc(sizeof(WS_INSTANCE_PROTOCOL) * protocol_count);
+                                if (result->protocols == NULL)
                                 {
-                                    /* Codes_SRS_UWS_CLIENT_01_007: [ If obtaining the underlying IO interface fails, then uws_client_create shall fail and return NULL. ]*/
-                                    LogError("NULL socketio interface description");
-                                    result->underlying_io = NULL;
+                                    /* Codes_SRS_UWS_CLIENT_01_414: [ If allocating memory for the copied protocol information fails then uws_client_create shall fail and return NULL. ]*/
+                                    LogError("Cannot allocate memory for the protocols array.");
+                                    xio_destroy(result->underlying_io);
+                                            Map_Destroy(result->request_headers);
+                                    free(result->resource_name);
+                                    free(result->hostname);
+                                    free(result);
+                                    result = NULL;
                                 }
                                 else
                                 {
-                                    /* Codes_SRS_UWS_CLIENT_01_010: [ The create arguments for the socket IO (when use_ssl is 0) shall have: ]*/
-                                    /* Codes_SRS_UWS_CLIENT_01_011: [ - hostname set to the hostname argument passed to uws_client_create. ]*/
-                                    /* Codes_SRS_UWS_CLIENT_01_012: [ - port set to the port argument passed to uws_client_create. ]*/
-                                    socketio_config.hostname = hostname;
-                                    socketio_config.port = port;
-                                    socketio_config.accepted_socket = NULL;
-
-                                    /* Codes_SRS_UWS_CLIENT_01_008: [ The obtained interface shall be used to create the IO used as underlying IO by the newly created uws instance. ]*/
-                                    /* Codes_SRS_UWS_CLIENT_01_009: [ The underlying IO shall be created by calling xio_create. ]*/
-                                    result->underlying_io = xio_create(socketio_interface, &socketio_config);
-                                    if (result->underlying_io == NULL)
+                                    /* Codes_SRS_UWS_CLIENT_01_413: [ The protocol information indicated by protocols and protocol_count shall be copied for later use (for constructing the upgrade request). ]*/
+                                    for (i = 0; i < protocol_count; i++)
                                     {
-                                        LogError("Cannot create underlying socket IO.");
+                                        if (mallocAndStrcpy_s(&result->protocols[i].protocol, protocols[i].protocol) != 0)
+                                        {
+                                            /* Codes_SRS_UWS_CLIENT_01_414: [ If allocating memory for the copied protocol information fails then uws_client_create shall fail and return NULL. ]*/
+                                            LogError("Cannot allocate memory for the protocol index %u.", (unsigned int)i);
+                                            break;
+                                        }
                                     }
-                                }
-                            }
-
-                            if (result->underlying_io == NULL)
-                            {
-                                /* Codes_SRS_UWS_CLIENT_01_016: [ If xio_create fails, then uws_client_create shall fail and return NULL. ]*/
-                                singlylinkedlist_destroy(result->pending_sends);
-                                Map_Destroy(result->request_headers);
-                                free(result->resource_name);
-                                free(result->hostname);
-                                free(result);
-                                result = NULL;
-                            }
-                            else
-                            {
-                                result->uws_state = UWS_STATE_CLOSED;
-                                /* Codes_SRS_UWS_CLIENT_01_403: [ The argument port shall be copied for later use. ]*/
-                                result->port = port;
 
-                                result->fragmented_frame_type = WS_FRAME_TYPE_UNKNOWN;
+                                    if (i < protocol_count)
+                                    {
+                                        size_t j;
 
-                                result->protocol_count = protocol_count;
+                                        for (j = 0; j < i; j++)
+                                        {
+                                            free(result->protocols[j].protocol);
+                                        }
 
-                                /* Codes_SRS_UWS_CLIENT_01_410: [ The protocols argument shall be allowed to be NULL, in which case no protocol is to be specified by the client in the upgrade request. ]*/
-                                if (protocols == NULL)
-                                {
-                                    result->protocols = NULL;
-                                }
-                                else
-                                {
-                                    result->protocols = (WS_INSTANCE_PROTOCOL*)malloc(sizeof(WS_INSTANCE_PROTOCOL) * protocol_count);
-                                    if (result->protocols == NULL)
-                                    {
-                                        /* Codes_SRS_UWS_CLIENT_01_414: [ If allocating memory for the copied protocol information fails then uws_client_create shall fail and return NULL. ]*/
-                                        LogError("Cannot allocate memory for the protocols array.");
+                                        free(result->protocols);
                                         xio_destroy(result->underlying_io);
-                                        singlylinkedlist_destroy(result->pending_sends);
-                                        Map_Destroy(result->request_headers);
+                                                    Map_Destroy(result->request_headers);
                                         free(result->resource_name);
                                         free(result->hostname);
                                         free(result);
@@ -298,39 +459,7 @@ UWS_CLIENT_HANDLE uws_client_create(const char* hostname, unsigned int port, con
                                     }
                                     else
                                     {
-                                        /* Codes_SRS_UWS_CLIENT_01_413: [ The protocol information indicated by protocols and protocol_count shall be copied for later use (for constructing the upgrade request). ]*/
-                                        for (i = 0; i < protocol_count; i++)
-                                        {
-                                            if (mallocAndStrcpy_s(&result->protocols[i].protocol, protocols[i].protocol) != 0)
-                                            {
-                                                /* Codes_SRS_UWS_CLIENT_01_414: [ If allocating memory for the copied protocol information fails then uws_client_create shall fail and return NULL. ]*/
-                                                LogError("Cannot allocate memory for the protocol index %u.", (unsigned int)i);
-                                                break;
-                                            }
-                                        }
-
-                                        if (i < protocol_count)
-                                        {
-                                            size_t j;
-
-                                            for (j = 0; j < i; j++)
-                                            {
-                                                free(result->protocols[j].protocol);
-                                            }
-
-                                            free(result->protocols);
-                                            xio_destroy(result->underlying_io);
-                                            singlylinkedlist_destroy(result->pending_sends);
-                                            Map_Destroy(result->request_headers);
-                                            free(result->resource_name);
-                                            free(result->hostname);
-                                            free(result);
-                                            result = NULL;
-                                        }
-                                        else
-                                        {
-                                            result->protocol_count = protocol_count;
-                                        }
+                                        result->protocol_count = protocol_count;
                                     }
                                 }
                             }
@@ -387,6 +516,7 @@ UWS_CLIENT_HANDLE uws_client_create_with_io(const IO_INTERFACE_DESCRIPTION* io_i
             else
             {
                 memset(result, 0, sizeof(UWS_CLIENT_INSTANCE));
+                result->stats.layer_name = "uws_client";
 
                 /* Codes_SRS_UWS_CLIENT_01_518: [ The argument hostname shall be copied for later use. ]*/
                 if (mallocAndStrcpy_s(&result->hostname, hostname) != 0)
@@ -417,12 +547,15 @@ UWS_CLIENT_HANDLE uws_client_create_with_io(const IO_INTERFACE_DESCRIPTION* io_i
                     }
                     else
                     {
-                        /* Codes_SRS_UWS_CLIENT_01_530: [ uws_client_create_with_io shall create a pending send IO list that is to be used to queue send packets by calling singlylinkedlist_create. ]*/
-                        result->pending_sends = singlylinkedlist_create();
-                        if (result->pending_sends == NULL)
+                        /* Codes_SRS_UWS_CLIENT_01_530: [ uws_client_create_with_io shall initialize an empty pending send IO list that is to be used to queue send packets. ]*/
+                        DList_InitializeListHead(&result->pending_sends);
+
+                        /* Codes_SRS_UWS_CLIENT_01_521: [ The underlying IO shall be created by calling xio_create, while passing as arguments the io_interface and io_create_parameters argument values. ]*/
+                        result->underlying_io = xio_create(io_interface, io_create_parameters);
+                        if (result->underlying_io == NULL)
                         {
-                            /* Codes_SRS_UWS_CLIENT_01_531: [ If singlylinkedlist_create fails then uws_client_create_with_io shall fail and return NULL. ]*/
-                            LogError("Could not allocate pending send frames list");
+                            /* Codes_SRS_UWS_CLIENT_01_522: [ If xio_create fails, then uws_client_create_with_io shall fail and return NULL. ]*/
+                            LogError("Cannot create underlying IO.");
                             Map_Destroy(result->request_headers);
                             free(result->resource_name);
                             free(result->hostname);
@@ -431,45 +564,59 @@ UWS_CLIENT_HANDLE uws_client_create_with_io(const IO_INTERFACE_DESCRIPTION* io_i
                         }
                         else
                         {
-                            /* Codes_SRS_UWS_CLIENT_01_521: [ The underlying IO shall be created by calling xio_create, while passing as arguments the io_interface and io_create_parameters argument values. ]*/
-                            result->underlying_io = xio_create(io_interface, io_create_parameters);
-                            if (result->underlying_io == NULL)
-                            {
-                                /* Codes_SRS_UWS_CLIENT_01_522: [ If xio_create fails, then uws_client_create_with_io shall fail and return NULL. ]*/
-                                LogError("Cannot create underlying IO.");
-                                singlylinkedlist_destroy(result->pending_sends);
-                                Map_Destroy(result->request_headers);
-                                free(result->resource_name);
-                                free(result->hostname);
-                                free(result);
-                                result = NULL;
-                            }
-                            else
-                            {
-                                result->uws_state = UWS_STATE_CLOSED;
+                            result->uws_state = UWS_STATE_CLOSED;
 
-                                /* Codes_SRS_UWS_CLIENT_01_520: [ The argument port shall be copied for later use. ]*/
-                                result->port = port;
+                            /* Codes_SRS_UWS_CLIENT_01_520: [ The argument port shall be copied for later use. ]*/
+                            result->port = port;
 
-                                result->fragmented_frame_type = WS_FRAME_TYPE_UNKNOWN;
+                            result->fragmented_frame_type = WS_FRAME_TYPE_UNKNOWN;
 
-                                result->protocol_count = protocol_count;
+                            result->protocol_count = protocol_count;
 
-                                /* Codes_SRS_UWS_CLIENT_01_524: [ The protocols argument shall be allowed to be NULL, in which case no protocol is to be specified by the client in the upgrade request. ]*/
-                                if (protocols == NULL)
+                            /* Codes_SRS_UWS_CLIENT_01_524: [ The protocols argument shall be allowed to be NULL, in which case no protocol is to be specified by the client in the upgrade request. ]*/
+                            if (protocols == NULL)
+                            {
+                                result->protocols = NULL;
+                            }
+                            else
+                            {
+                                result->protocols = (WS_INSTANCE_PROTOCOL*)malloc(sizeof(WS_INSTANCE_PROTOCOL) * protocol_count);
+                                if (result->protocols == NULL)
                                 {
-                                    result->protocols = NULL;
+                                    /* Codes_SRS_UWS_CLIENT_01_414: [ If allocating memory for the copied protocol information fails then uws_client_create shall fail and return NULL. ]*/
+                                    LogError("Cannot allocate memory for the protocols array.");
+                                    xio_destroy(result->underlying_io);
+                                            Map_Destroy(result->request_headers);
+                                    free(result->resource_name);
+                                    free(result->hostname);
+                                    free(result);
+                                    result = NULL;
                                 }
                                 else
                                 {
-                                    result->protocols = (WS_INSTANCE_PROTOCOL*)malloc(sizeof(WS_INSTANCE_PROTOCOL) * protocol_count);
-                                    if (result->protocols == NULL)
+                                    /* Codes_SRS_UWS_CLIENT_01_527: [ The protocol information indicated by protocols and protocol_count shall be copied for later use (for constructing the upgrade request). ]*/
+                                    for (i = 0; i < protocol_count; i++)
+                                    {
+                                        if (mallocAndStrcpy_s(&result->protocols[i].protocol, protocols[i].protocol) != 0)
+                                        {
+                                            /* Codes_SRS_UWS_CLIENT_01_528: [ If allocating memory for the copied protocol information fails then uws_client_create_with_io shall fail and return NULL. ]*/
+                                            LogError("Cannot allocate memory for the protocol index %u.", (unsigned int)i);
+                                            break;
+                                        }
+                                    }
+
+                                    if (i < protocol_count)
                                     {
-                                        /* Codes_SRS_UWS_CLIENT_01_414: [ If allocating memory for the copied protocol information fails then uws_client_create shall fail and return NULL. ]*/
-                                        LogError("Cannot allocate memory for the protocols array.");
+                                        size_t j;
+
+                                        for (j = 0; j < i; j++)
+                                        {
+                                            free(result->protocols[j].protocol);
+                                        }
+
+                                        free(result->protocols);
                                         xio_destroy(result->underlying_io);
-                                        singlylinkedlist_destroy(result->pending_sends);
-                                        Map_Destroy(result->request_headers);
+                                                    Map_Destroy(result->request_headers);
                                         free(result->resource_name);
                                         free(result->hostname);
                                         free(result);
@@ -477,39 +624,7 @@ UWS_CLIENT_HANDLE uws_client_create_with_io(const IO_INTERFACE_DESCRIPTION* io_i
                                     }
                                     else
                                     {
-                                        /* Codes_SRS_UWS_CLIENT_01_527: [ The protocol information indicated by protocols and protocol_count shall be copied for later use (for constructing the upgrade request). ]*/
-                                        for (i = 0; i < protocol_count; i++)
-                                        {
-                                            if (mallocAndStrcpy_s(&result->protocols[i].protocol, protocols[i].protocol) != 0)
-                                            {
-                                                /* Codes_SRS_UWS_CLIENT_01_528: [ If allocating memory for the copied protocol information fails then uws_client_create_with_io shall fail and return NULL. ]*/
-                                                LogError("Cannot allocate memory for the protocol index %u.", (unsigned int)i);
-                                                break;
-                                            }
-                                        }
-
-                                        if (i < protocol_count)
-                                        {
-                                            size_t j;
-
-                                            for (j = 0; j < i; j++)
-                                            {
-                                                free(result->protocols[j].protocol);
-                                            }
-
-                                            free(result->protocols);
-                                            xio_destroy(result->underlying_io);
-                                            singlylinkedlist_destroy(result->pending_sends);
-                                            Map_Destroy(result->request_headers);
-                                            free(result->resource_name);
-                                            free(result->hostname);
-                                            free(result);
-                                            result = NULL;
-                                        }
-                                        else
-                                        {
-                                            result->protocol_count = protocol_count;
-                                        }
+                                        result->protocol_count = protocol_count;
                                     }
                                 }
                             }
@@ -532,8 +647,24 @@ void uws_client_destroy(UWS_CLIENT_HANDLE uws_client)
     }
     else
     {
-        free(uws_client->stream_buffer);
+        if ((uws_client->receive_buffer_size > 0) &&
+            (uws_client->underlying_io != NULL))
+        {
+            /* Codes_SRS_UWS_CLIENT_01_635: [ If a receive buffer size is set, uws_client_destroy shall call xio_set_receive_buffer with NULL and 0 before freeing the memory used for accumulating received bytes. ]*/
+            (void)xio_set_receive_buffer(uws_client->underlying_io, NULL, 0);
+        }
+
+        free(uws_client->stream_buffer_memory);
         free(uws_client->fragment_buffer);
+        /* Codes_SRS_UWS_CLIENT_01_568: [ uws_client_destroy shall free the send buffer. ]*/
+        free(uws_client->send_buffer);
+        /* Codes_SRS_UWS_CLIENT_01_584: [ uws_client_destroy shall free the kept upgrade request. ]*/
+        free(uws_client->upgrade_request);
+#ifdef USE_WS_PERMESSAGE_DEFLATE
+        end_permessage_deflate(uws_client);
+        free(uws_client->deflate_buffer);
+        free(uws_client->inflate_buffer);
+#endif
 
         /* Codes_SRS_UWS_CLIENT_01_021: [ uws_client_destroy shall perform a close action if the uws instance has already been open. ]*/
         switch (uws_client->uws_state)
@@ -568,11 +699,21 @@ void uws_client_destroy(UWS_CLIENT_HANDLE uws_client)
             uws_client->underlying_io = NULL;
         }
 
-        /* Codes_SRS_UWS_CLIENT_01_024: [ uws_client_destroy shall free the list used to track the pending sends by calling singlylinkedlist_destroy. ]*/
-        singlylinkedlist_destroy(uws_client->pending_sends);
         free(uws_client->resource_name);
         free(uws_client->hostname);
         Map_Destroy(uws_client->request_headers);
+
+        /* Codes_SRS_UWS_CLIENT_01_626: [ uws_client_destroy shall destroy the keepalive timer and its timer wheel with timer_wheel_destroy_timer and timer_wheel_destroy. ]*/
+        if (uws_client->keepalive_timer != NULL)
+        {
+            timer_wheel_destroy_timer(uws_client->keepalive_timer);
+        }
+
+        if (uws_client->keepalive_timer_wheel != NULL)
+        {
+            timer_wheel_destroy(uws_client->keepalive_timer_wheel);
+        }
+
         free(uws_client);
     }
 }
@@ -616,6 +757,109 @@ static void unchecked_on_send_complete(void* context, IO_SEND_RESULT send_result
     (void)send_result;
 }
 
+static void start_keepalive_timer(UWS_CLIENT_INSTANCE* uws_client, unsigned int timeout_ms)
+{
+    tickcounter_us_t now_us;
+
+    if (timer_wheel_start_timer(uws_client->keepalive_timer, timeout_ms) != 0)
+    {
+        LogError("timer_wheel_start_timer failed, the connection is not watched anymore");
+        uws_client->keepalive_deadline_us = XIO_NO_DEADLINE;
+    }
+    else if (tickcounter_get_monotonic_us(&now_us) != 0)
+    {
+        /* without a deadline uws_client_dowork_ex callers may wait too long, yet the timer still expires in any uws_client_dowork */
+        LogError("tickcounter_get_monotonic_us failed");
+        uws_client->keepalive_deadline_us = XIO_NO_DEADLINE;
+    }
+    else
+    {
+        /* one more millisecond for the resolution of the timer wheel */
+        uws_client->keepalive_deadline_us = (uint64_t)now_us + ((uint64_t)timeout_ms + 1) * 1000;
+    }
+}
+
+static void start_keepalive(UWS_CLIENT_INSTANCE* uws_client)
+{
+    if ((uws_client->keepalive_timer != NULL) &&
+        (uws_client->keepalive_options.ping_interval_ms > 0))
+    {
+        uws_client->keepalive_waiting_for_pong = false;
+        uws_client->keepalive_bytes_received = false;
+        start_keepalive_timer(uws_client, uws_client->keepalive_options.ping_interval_ms);
+    }
+}
+
+static void send_keepalive_ping(UWS_CLIENT_INSTANCE* uws_client)
+{
+    /* Codes_SRS_UWS_CLIENT_01_140: [ To avoid confusing network intermediaries (such as intercepting proxies) and for security reasons that are further discussed in Section 10.3, a client MUST mask all frames that it sends to the server (see Section 5.3 for further details). ]*/
+    BUFFER_HANDLE ping_frame_buffer = uws_frame_encoder_encode(WS_PING_FRAME, NULL, 0, true, true, 0);
+    if (ping_frame_buffer == NULL)
+    {
+        LogError("Encoding of PING failed.");
+    }
+    else
+    {
+        if (xio_send(uws_client->underlying_io, BUFFER_u_char(ping_frame_buffer), BUFFER_length(ping_frame_buffer), unchecked_on_send_complete, NULL) != 0)
+        {
+            LogError("Sending PING frame failed.");
+        }
+
+        BUFFER_delete(ping_frame_buffer);
+    }
+}
+
+static void on_keepalive_timer_expired(void* context)
+{
+    UWS_CLIENT_INSTANCE* uws_client = (UWS_CLIENT_INSTANCE*)context;
+
+    uws_client->keepalive_deadline_us = XIO_NO_DEADLINE;
+
+    if ((uws_client->uws_state != UWS_STATE_OPEN) ||
+        (uws_client->keepalive_options.ping_interval_ms == 0))
+    {
+        /* Codes_SRS_UWS_CLIENT_01_620: [ When the keepalive timer expires while the uws instance is not OPEN or keepalive was disabled, nothing shall be done. ]*/
+    }
+    else if (uws_client->keepalive_bytes_received)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_617: [ When the keepalive timer expires and bytes were received since it was started, the timer shall be started again with the ping interval. ]*/
+        start_keepalive(uws_client);
+    }
+    else if (uws_client->keepalive_waiting_for_pong)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_619: [ When the pong timeout expires and no bytes were received since the Ping was sent, an error shall be reported by calling on_ws_error with WS_ERROR_PONG_TIMEOUT. ]*/
+        LogError("Nothing received within %u ms of a Ping, the connection is dead", uws_client->keepalive_options.pong_timeout_ms);
+        uws_client->keepalive_waiting_for_pong = false;
+        indicate_ws_error(uws_client, WS_ERROR_PONG_TIMEOUT);
+    }
+    else
+    {
+        /* Codes_SRS_UWS_CLIENT_01_618: [ When the ping interval expires and no bytes were received since the timer was started, a Ping frame without payload shall be encoded with uws_frame_encoder_encode and sent with xio_send, and the timer shall be started with the pong timeout. ]*/
+        /* a Ping that could not be sent is not retried: if the connection is dead the pong timeout still finds it */
+        send_keepalive_ping(uws_client);
+        uws_client->keepalive_waiting_for_pong = true;
+        start_keepalive_timer(uws_client, uws_client->keepalive_options.pong_timeout_ms);
+    }
+}
+
+static int send_batched_frames(UWS_CLIENT_INSTANCE* uws_client);
+static void send_unsent_fragments(UWS_CLIENT_INSTANCE* uws_client);
+
+/* forgets the messages waiting to be sent as fragments, their pending sends are left to be cancelled */
+static void discard_unsent_messages(UWS_CLIENT_INSTANCE* uws_client)
+{
+    uws_client->unsent_first_item = NULL;
+    uws_client->unsent_last_item = NULL;
+}
+
+/* forgets the frames waiting to be sent, their pending sends are left to be cancelled */
+static void discard_send_batch(UWS_CLIENT_INSTANCE* uws_client)
+{
+    uws_client->send_batch_length = 0;
+    uws_client->send_batch_first_item = NULL;
+    uws_client->send_batch_last_item = NULL;
+}
+
 static int send_close_frame(UWS_CLIENT_INSTANCE* uws_client, unsigned int close_error_code)
 {
     unsigned char* close_frame;
@@ -639,6 +883,9 @@ static int send_close_frame(UWS_CLIENT_INSTANCE* uws_client, unsigned int close_
         close_frame = BUFFER_u_char(close_frame_buffer);
         close_frame_length = BUFFER_length(close_frame_buffer);
 
+        /* Codes_SRS_UWS_CLIENT_01_576: [ Before a CLOSE frame is sent, the frames waiting to be sent because of send coalescing shall be sent. ]*/
+        (void)send_batched_frames(uws_client);
+
         /* Codes_SRS_UWS_CLIENT_01_471: [ The callback on_underlying_io_close_sent shall be passed as argument to xio_send. ]*/
         if (xio_send(uws_client->underlying_io, close_frame, close_frame_length, unchecked_on_send_complete, NULL) != 0)
         {
@@ -719,143 +966,664 @@ static char* get_request_headers(MAP_HANDLE headers)
     return result;
 }
 
-static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+#ifdef USE_WS_PERMESSAGE_DEFLATE
+static bool is_valid_permessage_deflate_options(const WS_PERMESSAGE_DEFLATE_OPTIONS* options)
 {
-    UWS_CLIENT_HANDLE uws_client = (UWS_CLIENT_HANDLE)context;
-    /* Codes_SRS_UWS_CLIENT_01_401: [ If on_underlying_io_open_complete is called with a NULL context, on_underlying_io_open_complete shall do nothing. ]*/
-    if (uws_client == NULL)
+    /* raw deflate streams cannot be created by zlib with a 256 bytes window, hence 9 is the minimum for compressing */
+    return (options->client_max_window_bits >= 9) && (options->client_max_window_bits <= 15) &&
+        (options->server_max_window_bits >= 8) && (options->server_max_window_bits <= 15) &&
+        (options->compression_level >= -1) && (options->compression_level <= 9) &&
+        (options->mem_level >= 1) && (options->mem_level <= 9);
+}
+
+static void build_permessage_deflate_offer(UWS_CLIENT_INSTANCE* uws_client, char* offer, size_t offer_size)
+{
+    offer[0] = '\0';
+
+    if (uws_client->permessage_deflate_requested)
     {
-        LogError("NULL context");
+        const WS_PERMESSAGE_DEFLATE_OPTIONS* options = &uws_client->permessage_deflate_options;
+        char server_max_window_bits[32];
+
+        if (options->server_max_window_bits < 15)
+        {
+            (void)snprintf(server_max_window_bits, sizeof(server_max_window_bits), "; server_max_window_bits=%d", options->server_max_window_bits);
+        }
+        else
+        {
+            server_max_window_bits[0] = '\0';
+        }
+
+        (void)snprintf(offer, offer_size, "%s: %s; client_max_window_bits=%d%s%s%s\r\n",
+            SEC_WEBSOCKET_EXTENSIONS_HEADER,
+            PERMESSAGE_DEFLATE_EXTENSION,
+            options->client_max_window_bits,
+            server_max_window_bits,
+            options->client_no_context_takeover ? "; client_no_context_takeover" : "",
+            options->server_no_context_takeover ? "; server_no_context_takeover" : "");
     }
-    else
+}
+
+static const char* skip_whitespace(const char* position, const char* end)
+{
+    while ((position < end) && ((*position == ' ') || (*position == '\t')))
     {
-        switch (uws_client->uws_state)
+        position++;
+    }
+
+    return position;
+}
+
+static bool is_token(const char* start, size_t length, const char* token)
+{
+    return (strlen(token) == length) && (strncmp(start, token, length) == 0);
+}
+
+/* HTTP header names are case insensitive */
+static bool is_header_name(const char* start, const char* header_name, size_t length)
+{
+    size_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        if (tolower((unsigned char)start[i]) != tolower((unsigned char)header_name[i]))
         {
-        default:
-        case UWS_STATE_WAITING_FOR_UPGRADE_RESPONSE:
-            /* Codes_SRS_UWS_CLIENT_01_407: [ When on_underlying_io_open_complete is called when the uws instance has send the upgrade request but it is waiting for the response, an error shall be reported to the user by calling the on_ws_open_complete with WS_OPEN_ERROR_MULTIPLE_UNDERLYING_IO_OPEN_EVENTS. ]*/
-            LogError("underlying on_io_open_complete was called again after upgrade request was sent.");
-            indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_MULTIPLE_UNDERLYING_IO_OPEN_EVENTS);
             break;
-        case UWS_STATE_OPENING_UNDERLYING_IO:
-            switch (open_result)
-            {
-            default:
-            case IO_OPEN_ERROR:
-                /* Codes_SRS_UWS_CLIENT_01_369: [ When on_underlying_io_open_complete is called with IO_OPEN_ERROR while uws is OPENING (uws_client_open_async was called), uws shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_UNDERLYING_IO_OPEN_FAILED. ]*/
-                indicate_ws_open_complete_error(uws_client, WS_OPEN_ERROR_UNDERLYING_IO_OPEN_FAILED);
-                break;
+        }
+    }
 
-            case IO_OPEN_CANCELLED:
-                /* Codes_SRS_UWS_CLIENT_01_402: [ When on_underlying_io_open_complete is called with IO_OPEN_CANCELLED while uws is OPENING (uws_client_open_async was called), uws shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_UNDERLYING_IO_OPEN_CANCELLED. ]*/
-                indicate_ws_open_complete_error(uws_client, WS_OPEN_ERROR_UNDERLYING_IO_OPEN_CANCELLED);
-                break;
+    return i == length;
+}
 
-            case IO_OPEN_OK:
-            {
-                int upgrade_request_length;
-                char* upgrade_request;
-                size_t i;
-                unsigned char nonce[16];
-                STRING_HANDLE base64_nonce;
-                char* request_headers = NULL;
+static int parse_window_bits(const char* value, size_t value_length, int* window_bits)
+{
+    int result;
 
-                /* Codes_SRS_UWS_CLIENT_01_089: [ The value of this header field MUST be a nonce consisting of a randomly selected 16-byte value that has been base64-encoded (see Section 4 of [RFC4648]). ]*/
-                /* Codes_SRS_UWS_CLIENT_01_090: [ The nonce MUST be selected randomly for each connection. ]*/
-                for (i = 0; i < sizeof(nonce); i++)
-                {
-                    nonce[i] = (unsigned char)gb_rand();
-                }
+    if ((value_length >= 2) && (value[0] == '"') && (value[value_length - 1] == '"'))
+    {
+        value++;
+        value_length -= 2;
+    }
 
-                /* Codes_SRS_UWS_CLIENT_01_497: [ The nonce needed for the upgrade request shall be Base64 encoded with Base64_Encode_Bytes. ]*/
-                base64_nonce = Base64_Encode_Bytes(nonce, sizeof(nonce));
-                if (base64_nonce == NULL)
-                {
-                    /* Codes_SRS_UWS_CLIENT_01_498: [ If Base64 encoding the nonce for the upgrade request fails, then the uws client shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_BASE64_ENCODE_FAILED. ]*/
-                    LogError("Cannot construct the WebSocket upgrade request");
-                    indicate_ws_open_complete_error(uws_client, WS_OPEN_ERROR_BASE64_ENCODE_FAILED);
+    if ((value_length == 1) && (value[0] >= '8') && (value[0] <= '9'))
+    {
+        *window_bits = value[0] - '0';
+        result = 0;
+    }
+    else if ((value_length == 2) && (value[0] == '1') && (value[1] >= '0') && (value[1] <= '5'))
+    {
+        *window_bits = 10 + (value[1] - '0');
+        result = 0;
+    }
+    else
+    {
+        result = __FAILURE__;
+    }
+
+    return result;
+}
+
+/* Parses the value of one Sec-WebSocket-Extensions header of the upgrade response. Only a single permessage-deflate
+   is accepted, since that is the only extension that can have been offered. */
+static int parse_permessage_deflate_response(UWS_CLIENT_INSTANCE* uws_client, const char* value, const char* value_end, bool* accepted, int* client_window_bits, int* server_window_bits)
+{
+    int result = 0;
+    const char* position = value;
+
+    while ((result == 0) && (position < value_end))
+    {
+        const char* extension_end = position;
+        const char* parameter;
+        const char* parameter_end;
+        bool has_client_max_window_bits = false;
+        bool has_server_max_window_bits = false;
+        bool has_client_no_context_takeover = false;
+        bool has_server_no_context_takeover = false;
+
+        while ((extension_end < value_end) && (*extension_end != ','))
+        {
+            extension_end++;
+        }
+
+        position = skip_whitespace(position, extension_end);
+        parameter_end = position;
+        while ((parameter_end < extension_end) && (*parameter_end != ';') && (*parameter_end != ' ') && (*parameter_end != '\t'))
+        {
+            parameter_end++;
+        }
+
+        if (!is_token(position, parameter_end - position, PERMESSAGE_DEFLATE_EXTENSION) ||
+            (*accepted))
+        {
+            LogError("Unexpected extension in the WebSocket upgrade response: %.*s", (int)(extension_end - position), position);
+            result = __FAILURE__;
+            break;
+        }
+
+        *accepted = true;
+        parameter = parameter_end;
+
+        while (parameter < extension_end)
+        {
+            const char* name;
+            size_t name_length;
+            const char* parameter_value = NULL;
+            size_t parameter_value_length = 0;
+
+            parameter = skip_whitespace(parameter, extension_end);
+            if (parameter == extension_end)
+            {
+                break;
+            }
+
+            if (*parameter != ';')
+            {
+                LogError("Malformed permessage-deflate parameters in the WebSocket upgrade response");
+                result = __FAILURE__;
+                break;
+            }
+
+            parameter = skip_whitespace(parameter + 1, extension_end);
+            name = parameter;
+            while ((parameter < extension_end) && (*parameter != ';') && (*parameter != '=') && (*parameter != ' ') && (*parameter != '\t'))
+            {
+                parameter++;
+            }
+            name_length = parameter - name;
+
+            parameter = skip_whitespace(parameter, extension_end);
+            if ((parameter < extension_end) && (*parameter == '='))
+            {
+                parameter = skip_whitespace(parameter + 1, extension_end);
+                parameter_value = parameter;
+                while ((parameter < extension_end) && (*parameter != ';') && (*parameter != ' ') && (*parameter != '\t'))
+                {
+                    parameter++;
+                }
+                parameter_value_length = parameter - parameter_value;
+            }
+
+            if (is_token(name, name_length, "server_no_context_takeover") && (parameter_value == NULL) && !has_server_no_context_takeover)
+            {
+                has_server_no_context_takeover = true;
+            }
+            else if (is_token(name, name_length, "client_no_context_takeover") && (parameter_value == NULL) && !has_client_no_context_takeover)
+            {
+                has_client_no_context_takeover = true;
+            }
+            else if (is_token(name, name_length, "server_max_window_bits") && (parameter_value != NULL) && !has_server_max_window_bits &&
+                (parse_window_bits(parameter_value, parameter_value_length, server_window_bits) == 0) &&
+                (*server_window_bits <= uws_client->permessage_deflate_options.server_max_window_bits))
+            {
+                has_server_max_window_bits = true;
+            }
+            else if (is_token(name, name_length, "client_max_window_bits") && (parameter_value != NULL) && !has_client_max_window_bits &&
+                (parse_window_bits(parameter_value, parameter_value_length, client_window_bits) == 0) &&
+                (*client_window_bits >= 9) &&
+                (*client_window_bits <= uws_client->permessage_deflate_options.client_max_window_bits))
+            {
+                has_client_max_window_bits = true;
+            }
+            else
+            {
+                LogError("Unsupported permessage-deflate parameter in the WebSocket upgrade response: %.*s", (int)name_length, name);
+                result = __FAILURE__;
+                break;
+            }
+        }
+
+        if (result == 0)
+        {
+            uws_client->client_no_context_takeover = uws_client->permessage_deflate_options.client_no_context_takeover || has_client_no_context_takeover;
+            uws_client->server_no_context_takeover = has_server_no_context_takeover;
+            if (!has_server_max_window_bits)
+            {
+                *server_window_bits = uws_client->permessage_deflate_options.server_max_window_bits;
+            }
+            if (!has_client_max_window_bits)
+            {
+                *client_window_bits = uws_client->permessage_deflate_options.client_max_window_bits;
+            }
+        }
+
+        position = extension_end + 1;
+    }
+
+    return result;
+}
+
+/* Looks for the extensions accepted by the server in the upgrade response and sets up the compression contexts */
+static WS_OPEN_RESULT negotiate_permessage_deflate(UWS_CLIENT_INSTANCE* uws_client, const char* response, const char* response_end)
+{
+    WS_OPEN_RESULT result = WS_OPEN_OK;
+    bool accepted = false;
+    int client_window_bits = 15;
+    int server_window_bits = 15;
+    size_t header_name_length = strlen(SEC_WEBSOCKET_EXTENSIONS_HEADER);
+    const char* line = strstr(response, "\r\n");
+
+    while ((result == WS_OPEN_OK) && (line != NULL) && (line < response_end))
+    {
+        const char* line_end;
+
+        line += 2;
+        line_end = strstr(line, "\r\n");
+        if ((line_end == NULL) || (line_end > response_end))
+        {
+            line_end = response_end;
+        }
+
+        if (((size_t)(line_end - line) > header_name_length) &&
+            (line[header_name_length] == ':') &&
+            is_header_name(line, SEC_WEBSOCKET_EXTENSIONS_HEADER, header_name_length))
+        {
+            /* Codes_SRS_UWS_CLIENT_01_545: [ If the upgrade response accepts an extension that was not offered, or accepts permessage-deflate with parameters that are unknown, repeated or exceed the offered ones, the open shall fail by calling on_ws_open_complete with WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE. ]*/
+            if ((!uws_client->permessage_deflate_requested) ||
+                (parse_permessage_deflate_response(uws_client, line + header_name_length + 1, line_end, &accepted, &client_window_bits, &server_window_bits) != 0))
+            {
+                LogError("Cannot accept the extensions in the WebSocket upgrade response");
+                result = WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE;
+            }
+        }
+
+        line = line_end;
+    }
+
+    if ((result == WS_OPEN_OK) && accepted)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_544: [ If the upgrade response accepts permessage-deflate, a raw deflate context using the negotiated client window bits and a raw inflate context using the negotiated server window bits shall be created for the connection. ]*/
+        (void)memset(&uws_client->deflate_stream, 0, sizeof(uws_client->deflate_stream));
+        uws_client->deflate_stream.zalloc = permessage_deflate_alloc;
+        uws_client->deflate_stream.zfree = permessage_deflate_free;
+        (void)memset(&uws_client->inflate_stream, 0, sizeof(uws_client->inflate_stream));
+        uws_client->inflate_stream.zalloc = permessage_deflate_alloc;
+        uws_client->inflate_stream.zfree = permessage_deflate_free;
+
+        if (deflateInit2(&uws_client->deflate_stream, uws_client->permessage_deflate_options.compression_level, Z_DEFLATED, -client_window_bits, uws_client->permessage_deflate_options.mem_level, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_546: [ If creating the compression contexts fails, the open shall fail by calling on_ws_open_complete with WS_OPEN_ERROR_NOT_ENOUGH_MEMORY. ]*/
+            LogError("Cannot create the permessage-deflate compression context");
+            result = WS_OPEN_ERROR_NOT_ENOUGH_MEMORY;
+        }
+        else if (inflateInit2(&uws_client->inflate_stream, -server_window_bits) != Z_OK)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_546: [ If creating the compression contexts fails, the open shall fail by calling on_ws_open_complete with WS_OPEN_ERROR_NOT_ENOUGH_MEMORY. ]*/
+            LogError("Cannot create the permessage-deflate decompression context");
+            (void)deflateEnd(&uws_client->deflate_stream);
+            result = WS_OPEN_ERROR_NOT_ENOUGH_MEMORY;
+        }
+        else
+        {
+            uws_client->permessage_deflate_negotiated = true;
+        }
+    }
+
+    return result;
+}
+
+/* Makes sure that the buffer has room for at least one more byte than used, growing it geometrically */
+static int grow_permessage_deflate_buffer(unsigned char** buffer, size_t* buffer_size, size_t used, size_t size_hint)
+{
+    int result;
+
+    if (used < *buffer_size)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t new_size = (*buffer_size > ((size_t)-1) / 2) ? ((size_t)-1) : *buffer_size * 2;
+        unsigned char* new_buffer;
+
+        if (new_size < size_hint)
+        {
+            new_size = size_hint;
+        }
+
+        if (new_size <= used)
+        {
+            LogError("Compressed message too big");
+            result = __FAILURE__;
+        }
+        else if ((new_buffer = (unsigned char*)realloc(*buffer, new_size)) == NULL)
+        {
+            LogError("Cannot allocate memory for permessage-deflate");
+            result = __FAILURE__;
+        }
+        else
+        {
+            *buffer = new_buffer;
+            *buffer_size = new_size;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+/* Compresses the payload of one frame into deflate_buffer, dropping the empty block that ends the message */
+static int deflate_message_bytes(UWS_CLIENT_INSTANCE* uws_client, const unsigned char* bytes, size_t length, bool is_final, size_t* deflated_length)
+{
+    int result = 0;
+    size_t used = 0;
+    z_stream* stream = &uws_client->deflate_stream;
+
+    stream->next_in = (Bytef*)bytes;
+    stream->avail_in = (uInt)length;
+
+    do
+    {
+        int deflate_result;
+
+        if (grow_permessage_deflate_buffer(&uws_client->deflate_buffer, &uws_client->deflate_buffer_size, used, length + 64) != 0)
+        {
+            result = __FAILURE__;
+            break;
+        }
+
+        stream->next_out = uws_client->deflate_buffer + used;
+        stream->avail_out = (uInt)(uws_client->deflate_buffer_size - used);
+        deflate_result = deflate(stream, Z_SYNC_FLUSH);
+        used = uws_client->deflate_buffer_size - stream->avail_out;
+
+        if ((deflate_result != Z_OK) && (deflate_result != Z_BUF_ERROR))
+        {
+            LogError("deflate failed: %d", deflate_result);
+            result = __FAILURE__;
+            break;
+        }
+    } while (stream->avail_out == 0);
+
+    if (result == 0)
+    {
+        if (is_final)
+        {
+            if ((used >= sizeof(DEFLATE_MESSAGE_TAIL)) &&
+                (memcmp(uws_client->deflate_buffer + used - sizeof(DEFLATE_MESSAGE_TAIL), DEFLATE_MESSAGE_TAIL, sizeof(DEFLATE_MESSAGE_TAIL)) == 0))
+            {
+                used -= sizeof(DEFLATE_MESSAGE_TAIL);
+            }
+
+            /* Codes_SRS_UWS_CLIENT_01_552: [ When no context takeover was negotiated for a direction, the compression context for that direction shall be reset after each message. ]*/
+            if (uws_client->client_no_context_takeover)
+            {
+                (void)deflateReset(stream);
+            }
+        }
+
+        *deflated_length = used;
+    }
+
+    return result;
+}
+
+/* Decompresses the payload of a compressed message (or of a part of it) into inflate_buffer, failing with is_too_big set
+   as soon as it decompresses to more than max_inflated_length bytes */
+static int inflate_message_bytes(UWS_CLIENT_INSTANCE* uws_client, const unsigned char* bytes, size_t length, bool is_final, size_t max_inflated_length, size_t* inflated_length, bool* is_too_big)
+{
+    int result = 0;
+    size_t used = 0;
+    int pass;
+    z_stream* stream = &uws_client->inflate_stream;
+
+    *is_too_big = false;
+
+    /* Codes_SRS_UWS_CLIENT_01_549: [ When a message with RSV1 set is received, its payload shall be decompressed, after appending 0x00 0x00 0xFF 0xFF to the final fragment, and the decompressed bytes shall be the ones indicated to the user. ]*/
+    for (pass = 0; (result == 0) && (pass < (is_final ? 2 : 1)); pass++)
+    {
+        if (pass == 0)
+        {
+            stream->next_in = (Bytef*)bytes;
+            stream->avail_in = (uInt)length;
+        }
+        else
+        {
+            stream->next_in = (Bytef*)DEFLATE_MESSAGE_TAIL;
+            stream->avail_in = (uInt)sizeof(DEFLATE_MESSAGE_TAIL);
+        }
+
+        do
+        {
+            int inflate_result;
+
+            if (grow_permessage_deflate_buffer(&uws_client->inflate_buffer, &uws_client->inflate_buffer_size, used, length * 2 + 64) != 0)
+            {
+                result = __FAILURE__;
+                break;
+            }
+
+            stream->next_out = uws_client->inflate_buffer + used;
+            stream->avail_out = (uInt)(uws_client->inflate_buffer_size - used);
+            inflate_result = inflate(stream, Z_SYNC_FLUSH);
+            used = uws_client->inflate_buffer_size - stream->avail_out;
+
+            if (used > max_inflated_length)
+            {
+                *is_too_big = true;
+                result = __FAILURE__;
+                break;
+            }
+            else if (inflate_result == Z_STREAM_END)
+            {
+                /* the peer is allowed to end a message with a final deflate block, the next message starts a new stream */
+                (void)inflateReset(stream);
+            }
+            else if (inflate_result == Z_BUF_ERROR)
+            {
+                if (stream->avail_out != 0)
+                {
+                    break;
+                }
+            }
+            else if (inflate_result != Z_OK)
+            {
+                LogError("inflate failed: %d", inflate_result);
+                result = __FAILURE__;
+                break;
+            }
+        } while ((stream->avail_in > 0) || (stream->avail_out == 0));
+    }
+
+    if (result == 0)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_552: [ When no context takeover was negotiated for a direction, the compression context for that direction shall be reset after each message. ]*/
+        if (is_final && uws_client->server_no_context_takeover)
+        {
+            (void)inflateReset(stream);
+        }
+
+        *inflated_length = used;
+    }
+
+    return result;
+}
+#endif
+
+/* Builds the upgrade request kept by the uws instance, with a placeholder for the Sec-WebSocket-Key value */
+static WS_OPEN_RESULT build_upgrade_request(UWS_CLIENT_INSTANCE* uws_client)
+{
+    WS_OPEN_RESULT result;
+    char* request_headers;
+
+    if ((request_headers = get_request_headers(uws_client->request_headers)) == NULL)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_408: [ If constructing of the WebSocket upgrade request fails, uws shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_CONSTRUCTING_UPGRADE_REQUEST. ]*/
+        LogError("Cannot construct the WebSocket request headers");
+        result = WS_OPEN_ERROR_CONSTRUCTING_UPGRADE_REQUEST;
+    }
+    else
+    {
+        /* Codes_SRS_UWS_CLIENT_01_081: [ The handshake consists of an HTTP Upgrade request, along with a list of required and optional header fields. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_082: [ The handshake MUST be a valid HTTP request as specified by [RFC2616]. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_083: [ The method of the request MUST be GET, and the HTTP version MUST be at least 1.1. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_084: [ The "Request-URI" part of the request MUST match the /resource name/ defined in Section 3 (a relative URI) or be an absolute http/https URI that, when parsed, has a /resource name/, /host/, and /port/ that match the corresponding ws/wss URI. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_085: [ The request MUST contain a |Host| header field whose value contains /host/ plus optionally ":" followed by /port/ (when not using the default port). ]*/
+        /* Codes_SRS_UWS_CLIENT_01_086: [ The request MUST contain an |Upgrade| header field whose value MUST include the "websocket" keyword. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_087: [ The request MUST contain a |Connection| header field whose value MUST include the "Upgrade" token. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_088: [ The request MUST include a header field with the name |Sec-WebSocket-Key|. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_094: [ The request MUST include a header field with the name |Sec-WebSocket-Version|. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_095: [ The value of this header field MUST be 13. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_096: [ The request MAY include a header field with the name |Sec-WebSocket-Protocol|. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_100: [ The request MAY include a header field with the name |Sec-WebSocket-Extensions|. ]*/
+        /* Codes_SRS_UWS_CLIENT_01_101: [ The request MAY include any other header fields, for example, cookies [RFC6265] and/or authentication-related header fields such as the |Authorization| header field [RFC2616], which are processed according to documents that define them. ] */
+        const char upgrade_request_prefix_format[] = "GET %s HTTP/1.1\r\n"
+            "Host: %s:%d\r\n"
+            "Upgrade: websocket\r\n"
+            "Connection: Upgrade\r\n"
+            "Sec-WebSocket-Key: ";
+        const char upgrade_request_suffix_format[] = "%s\r\n"
+            "Sec-WebSocket-Protocol: %s\r\n"
+            "Sec-WebSocket-Version: 13\r\n"
+            "%s"
+            "%s"
+            "\r\n";
+        char key_placeholder[WS_BASE64_NONCE_LENGTH + 1];
+        char extension_offer[192];
+        size_t upgrade_request_size;
+
+#ifdef USE_WS_PERMESSAGE_DEFLATE
+        /* Codes_SRS_UWS_CLIENT_01_543: [ If the ws_permessage_deflate option was set, the upgrade request shall offer permessage-deflate in a Sec-WebSocket-Extensions header, with client_max_window_bits, server_max_window_bits (when less than 15), client_no_context_takeover and server_no_context_takeover as set in the option. ]*/
+        build_permessage_deflate_offer(uws_client, extension_offer, sizeof(extension_offer));
+#else
+        extension_offer[0] = '\0';
+#endif
+
+        (void)memset(key_placeholder, 'A', WS_BASE64_NONCE_LENGTH);
+        key_placeholder[WS_BASE64_NONCE_LENGTH] = '\0';
+
+        /* 11 digits are enough for any port */
+        upgrade_request_size = strlen(upgrade_request_prefix_format) + strlen(upgrade_request_suffix_format) + strlen(uws_client->resource_name) + strlen(uws_client->hostname) + 11 +
+            WS_BASE64_NONCE_LENGTH + strlen(uws_client->protocols[0].protocol) + strlen(extension_offer) + strlen(request_headers) + 1;
+
+        /* Codes_SRS_UWS_CLIENT_01_581: [ The upgrade request shall be built once, with a placeholder for the Sec-WebSocket-Key value, and kept by the uws instance for the next opens. ]*/
+        if ((uws_client->upgrade_request = (char*)malloc(upgrade_request_size)) == NULL)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_406: [ If not enough memory can be allocated to construct the WebSocket upgrade request, uws shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_NOT_ENOUGH_MEMORY. ]*/
+            LogError("Cannot allocate memory for the WebSocket upgrade request");
+            result = WS_OPEN_ERROR_NOT_ENOUGH_MEMORY;
+        }
+        else
+        {
+            int key_offset = sprintf(uws_client->upgrade_request, upgrade_request_prefix_format,
+                uws_client->resource_name,
+                uws_client->hostname,
+                uws_client->port);
+            int suffix_length = (key_offset < 0) ? -1 : sprintf(uws_client->upgrade_request + key_offset, upgrade_request_suffix_format,
+                key_placeholder,
+                uws_client->protocols[0].protocol,
+                extension_offer,
+                request_headers);
+
+            if (suffix_length < 0)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_408: [ If constructing of the WebSocket upgrade request fails, uws shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_CONSTRUCTING_UPGRADE_REQUEST. ]*/
+                LogError("Cannot construct the WebSocket upgrade request");
+                free(uws_client->upgrade_request);
+                uws_client->upgrade_request = NULL;
+                result = WS_OPEN_ERROR_CONSTRUCTING_UPGRADE_REQUEST;
+            }
+            else
+            {
+                uws_client->upgrade_request_key_offset = (size_t)key_offset;
+                uws_client->upgrade_request_length = (size_t)key_offset + (size_t)suffix_length;
+                result = WS_OPEN_OK;
+            }
+        }
+
+        free(request_headers);
+    }
+
+    return result;
+}
+
+/* Forgets the kept upgrade request, so that the next open builds it again */
+static void discard_upgrade_request(UWS_CLIENT_INSTANCE* uws_client)
+{
+    if (uws_client->upgrade_request != NULL)
+    {
+        free(uws_client->upgrade_request);
+        uws_client->upgrade_request = NULL;
+    }
+}
+
+static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_result)
+{
+    UWS_CLIENT_HANDLE uws_client = (UWS_CLIENT_HANDLE)context;
+    /* Codes_SRS_UWS_CLIENT_01_401: [ If on_underlying_io_open_complete is called with a NULL context, on_underlying_io_open_complete shall do nothing. ]*/
+    if (uws_client == NULL)
+    {
+        LogError("NULL context");
+    }
+    else
+    {
+        switch (uws_client->uws_state)
+        {
+        default:
+        case UWS_STATE_WAITING_FOR_UPGRADE_RESPONSE:
+            /* Codes_SRS_UWS_CLIENT_01_407: [ When on_underlying_io_open_complete is called when the uws instance has send the upgrade request but it is waiting for the response, an error shall be reported to the user by calling the on_ws_open_complete with WS_OPEN_ERROR_MULTIPLE_UNDERLYING_IO_OPEN_EVENTS. ]*/
+            LogError("underlying on_io_open_complete was called again after upgrade request was sent.");
+            indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_MULTIPLE_UNDERLYING_IO_OPEN_EVENTS);
+            break;
+        case UWS_STATE_OPENING_UNDERLYING_IO:
+            switch (open_result)
+            {
+            default:
+            case IO_OPEN_ERROR:
+                /* Codes_SRS_UWS_CLIENT_01_369: [ When on_underlying_io_open_complete is called with IO_OPEN_ERROR while uws is OPENING (uws_client_open_async was called), uws shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_UNDERLYING_IO_OPEN_FAILED. ]*/
+                indicate_ws_open_complete_error(uws_client, WS_OPEN_ERROR_UNDERLYING_IO_OPEN_FAILED);
+                break;
+
+            case IO_OPEN_CANCELLED:
+                /* Codes_SRS_UWS_CLIENT_01_402: [ When on_underlying_io_open_complete is called with IO_OPEN_CANCELLED while uws is OPENING (uws_client_open_async was called), uws shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_UNDERLYING_IO_OPEN_CANCELLED. ]*/
+                indicate_ws_open_complete_error(uws_client, WS_OPEN_ERROR_UNDERLYING_IO_OPEN_CANCELLED);
+                break;
+
+            case IO_OPEN_OK:
+            {
+                size_t i;
+                unsigned char nonce[WS_NONCE_SIZE];
+                char base64_nonce[WS_BASE64_NONCE_LENGTH + 1];
+                WS_OPEN_RESULT build_result;
+
+                /* Codes_SRS_UWS_CLIENT_01_089: [ The value of this header field MUST be a nonce consisting of a randomly selected 16-byte value that has been base64-encoded (see Section 4 of [RFC4648]). ]*/
+                /* Codes_SRS_UWS_CLIENT_01_090: [ The nonce MUST be selected randomly for each connection. ]*/
+                for (i = 0; i < sizeof(nonce); i++)
+                {
+                    nonce[i] = (unsigned char)gb_rand();
+                }
+
+                /* Codes_SRS_UWS_CLIENT_01_497: [ The nonce needed for the upgrade request shall be Base64 encoded with Base64_Encode_To. ]*/
+                if (Base64_Encode_To(nonce, sizeof(nonce), base64_nonce, sizeof(base64_nonce)) != 0)
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_498: [ If Base64 encoding the nonce for the upgrade request fails, then the uws client shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_BASE64_ENCODE_FAILED. ]*/
+                    LogError("Cannot construct the WebSocket upgrade request");
+                    indicate_ws_open_complete_error(uws_client, WS_OPEN_ERROR_BASE64_ENCODE_FAILED);
                 }
-                else if ((request_headers = get_request_headers(uws_client->request_headers)) == NULL)
+                /* Codes_SRS_UWS_CLIENT_01_371: [ When on_underlying_io_open_complete is called with IO_OPEN_OK while uws is OPENING (uws_client_open_async was called), uws shall prepare the WebSockets upgrade request. ]*/
+                else if ((uws_client->upgrade_request == NULL) &&
+                    ((build_result = build_upgrade_request(uws_client)) != WS_OPEN_OK))
                 {
-                    LogError("Cannot construct the WebSocket request headers");
-                    indicate_ws_open_complete_error(uws_client, WS_OPEN_ERROR_CONSTRUCTING_UPGRADE_REQUEST);
+                    indicate_ws_open_complete_error_and_close(uws_client, build_result);
                 }
                 else
                 {
-                    /* Codes_SRS_UWS_CLIENT_01_371: [ When on_underlying_io_open_complete is called with IO_OPEN_OK while uws is OPENING (uws_client_open_async was called), uws shall prepare the WebSockets upgrade request. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_081: [ The handshake consists of an HTTP Upgrade request, along with a list of required and optional header fields. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_082: [ The handshake MUST be a valid HTTP request as specified by [RFC2616]. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_083: [ The method of the request MUST be GET, and the HTTP version MUST be at least 1.1. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_084: [ The "Request-URI" part of the request MUST match the /resource name/ defined in Section 3 (a relative URI) or be an absolute http/https URI that, when parsed, has a /resource name/, /host/, and /port/ that match the corresponding ws/wss URI. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_085: [ The request MUST contain a |Host| header field whose value contains /host/ plus optionally ":" followed by /port/ (when not using the default port). ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_086: [ The request MUST contain an |Upgrade| header field whose value MUST include the "websocket" keyword. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_087: [ The request MUST contain a |Connection| header field whose value MUST include the "Upgrade" token. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_088: [ The request MUST include a header field with the name |Sec-WebSocket-Key|. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_094: [ The request MUST include a header field with the name |Sec-WebSocket-Version|. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_095: [ The value of this header field MUST be 13. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_096: [ The request MAY include a header field with the name |Sec-WebSocket-Protocol|. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_100: [ The request MAY include a header field with the name |Sec-WebSocket-Extensions|. ]*/
-                    /* Codes_SRS_UWS_CLIENT_01_101: [ The request MAY include any other header fields, for example, cookies [RFC6265] and/or authentication-related header fields such as the |Authorization| header field [RFC2616], which are processed according to documents that define them. ] */
-                    const char upgrade_request_format[] = "GET %s HTTP/1.1\r\n"
-                        "Host: %s:%d\r\n"
-                        "Upgrade: websocket\r\n"
-                        "Connection: Upgrade\r\n"
-                        "Sec-WebSocket-Key: %s\r\n"
-                        "Sec-WebSocket-Protocol: %s\r\n"
-                        "Sec-WebSocket-Version: 13\r\n"
-                        "%s"
-                        "\r\n";
-
-                    const char* base64_nonce_chars = STRING_c_str(base64_nonce);
-
-                    upgrade_request_length = (int)(strlen(upgrade_request_format) + strlen(uws_client->resource_name)+strlen(uws_client->hostname) + strlen(base64_nonce_chars) + strlen(uws_client->protocols[0].protocol) + strlen(request_headers) + 5);
-                    if (upgrade_request_length < 0)
+                    /* Codes_SRS_UWS_CLIENT_01_582: [ For each open only the Sec-WebSocket-Key value of the kept upgrade request shall be replaced, with the Base64 encoded nonce. ]*/
+                    (void)memcpy(uws_client->upgrade_request + uws_client->upgrade_request_key_offset, base64_nonce, WS_BASE64_NONCE_LENGTH);
+
+                    /* No need to have any send complete here, as we are monitoring the received bytes */
+                    /* Codes_SRS_UWS_CLIENT_01_372: [ Once prepared the WebSocket upgrade request shall be sent by calling xio_send. ]*/
+                    /* Codes_SRS_UWS_CLIENT_01_080: [ Once a connection to the server has been established (including a connection via a proxy or over a TLS-encrypted tunnel), the client MUST send an opening handshake to the server. ]*/
+                    if (xio_send(uws_client->underlying_io, uws_client->upgrade_request, uws_client->upgrade_request_length, unchecked_on_send_complete, NULL) != 0)
                     {
-                        /* Codes_SRS_UWS_CLIENT_01_408: [ If constructing of the WebSocket upgrade request fails, uws shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_CONSTRUCTING_UPGRADE_REQUEST. ]*/
-                        LogError("Cannot construct the WebSocket upgrade request");
-                        indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_CONSTRUCTING_UPGRADE_REQUEST);
+                        /* Codes_SRS_UWS_CLIENT_01_373: [ If xio_send fails then uws shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_CANNOT_SEND_UPGRADE_REQUEST. ]*/
+                        LogError("Cannot send upgrade request");
+                        indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_CANNOT_SEND_UPGRADE_REQUEST);
                     }
                     else
                     {
-                        upgrade_request = (char*)malloc(upgrade_request_length + 1);
-                        if (upgrade_request == NULL)
-                        {
-                            /* Codes_SRS_UWS_CLIENT_01_406: [ If not enough memory can be allocated to construct the WebSocket upgrade request, uws shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_NOT_ENOUGH_MEMORY. ]*/
-                            LogError("Cannot allocate memory for the WebSocket upgrade request");
-                            indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_NOT_ENOUGH_MEMORY);
-                        }
-                        else
-                        {
-
-                            upgrade_request_length = sprintf(upgrade_request, upgrade_request_format,
-                                uws_client->resource_name,
-                                uws_client->hostname,
-                                uws_client->port,
-                                base64_nonce_chars,
-                                uws_client->protocols[0].protocol,
-                                request_headers);
-
-                            /* No need to have any send complete here, as we are monitoring the received bytes */
-                            /* Codes_SRS_UWS_CLIENT_01_372: [ Once prepared the WebSocket upgrade request shall be sent by calling xio_send. ]*/
-                            /* Codes_SRS_UWS_CLIENT_01_080: [ Once a connection to the server has been established (including a connection via a proxy or over a TLS-encrypted tunnel), the client MUST send an opening handshake to the server. ]*/
-                            if (xio_send(uws_client->underlying_io, upgrade_request, upgrade_request_length, unchecked_on_send_complete, NULL) != 0)
-                            {
-                                /* Codes_SRS_UWS_CLIENT_01_373: [ If xio_send fails then uws shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_CANNOT_SEND_UPGRADE_REQUEST. ]*/
-                                LogError("Cannot send upgrade request");
-                                indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_CANNOT_SEND_UPGRADE_REQUEST);
-                            }
-                            else
-                            {
-                                /* Codes_SRS_UWS_CLIENT_01_102: [ Once the client's opening handshake has been sent, the client MUST wait for a response from the server before sending any further data. ]*/
-                                uws_client->uws_state = UWS_STATE_WAITING_FOR_UPGRADE_RESPONSE;
-                            }
-
-                            free(upgrade_request);
-                        }
+                        /* Codes_SRS_UWS_CLIENT_01_102: [ Once the client's opening handshake has been sent, the client MUST wait for a response from the server before sending any further data. ]*/
+                        uws_client->uws_state = UWS_STATE_WAITING_FOR_UPGRADE_RESPONSE;
                     }
-
-                    STRING_delete(base64_nonce);
-                    free(request_headers);
                 }
 
                 break;
@@ -865,14 +1633,153 @@ static void on_underlying_io_open_complete(void* context, IO_OPEN_RESULT open_re
     }
 }
 
-static void consume_stream_buffer_bytes(UWS_CLIENT_INSTANCE* uws_client, size_t consumed_bytes)
+/* Makes room for size more bytes after the pending bytes of the stream buffer, and for a '\0' after them.
+   Decoded frames are consumed by moving stream_buffer forward, so the leftover bytes are moved back to the
+   start of the memory at most once per received chunk, and the memory only grows (geometrically) when the
+   pending bytes do not fit in it anymore. Once the memory is big enough no more allocations are made. */
+static int reserve_stream_buffer_bytes(UWS_CLIENT_INSTANCE* uws_client, size_t size)
 {
-    if (consumed_bytes < uws_client->stream_buffer_count)
+    int result;
+
+    if (size >= ((size_t)-1) - uws_client->stream_buffer_count)
     {
-        (void)memmove(uws_client->stream_buffer, uws_client->stream_buffer + consumed_bytes, uws_client->stream_buffer_count - consumed_bytes);
+        LogError("Too many bytes received");
+        result = __FAILURE__;
     }
+    else
+    {
+        size_t needed_size = uws_client->stream_buffer_count + size + 1;
+        size_t offset = (size_t)(uws_client->stream_buffer - uws_client->stream_buffer_memory);
 
+        if (offset + needed_size > uws_client->stream_buffer_size)
+        {
+            /* move the pending bytes to the start of the memory, this is enough if they were only offset */
+            if ((offset > 0) && (uws_client->stream_buffer_count > 0))
+            {
+                (void)memmove(uws_client->stream_buffer_memory, uws_client->stream_buffer, uws_client->stream_buffer_count);
+            }
+            uws_client->stream_buffer = uws_client->stream_buffer_memory;
+        }
+
+        if (needed_size > uws_client->stream_buffer_size)
+        {
+            size_t new_size = (uws_client->stream_buffer_size > ((size_t)-1) / 2) ? needed_size : uws_client->stream_buffer_size * 2;
+            unsigned char* new_memory;
+            /* with a receive memory budget the memory does not grow more than needed past the budget */
+            if ((uws_client->receive_limits.receive_memory_budget > 0) &&
+                (new_size - 1 > uws_client->receive_limits.receive_memory_budget))
+            {
+                new_size = uws_client->receive_limits.receive_memory_budget + 1;
+            }
+            if (new_size < needed_size)
+            {
+                new_size = needed_size;
+            }
+
+            new_memory = (unsigned char*)realloc(uws_client->stream_buffer_memory, new_size);
+            if (new_memory == NULL)
+            {
+                LogError("Cannot allocate memory for received data");
+                result = __FAILURE__;
+            }
+            else
+            {
+                uws_client->stream_buffer_memory = new_memory;
+                uws_client->stream_buffer_size = new_size;
+                uws_client->stream_buffer = new_memory;
+                result = 0;
+            }
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int append_stream_buffer_bytes(UWS_CLIENT_INSTANCE* uws_client, const unsigned char* buffer, size_t size)
+{
+    int result;
+
+    if (buffer == uws_client->stream_buffer + uws_client->stream_buffer_count)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_634: [ Bytes received in the memory lent with xio_set_receive_buffer shall be accumulated without being copied. ]*/
+        uws_client->stream_buffer_count += size;
+        result = 0;
+    }
+    else if (reserve_stream_buffer_bytes(uws_client, size) != 0)
+    {
+        result = __FAILURE__;
+    }
+    else
+    {
+        (void)memcpy(uws_client->stream_buffer + uws_client->stream_buffer_count, buffer, size);
+        uws_client->stream_buffer_count += size;
+        result = 0;
+    }
+
+    return result;
+}
+
+/* Lends the memory after the pending bytes to the underlying IO for its next read, the '\0' after them still fitting */
+static void lend_stream_buffer(UWS_CLIENT_INSTANCE* uws_client)
+{
+    size_t receive_memory_budget = uws_client->receive_limits.receive_memory_budget;
+    size_t lend_size = uws_client->receive_buffer_size;
+    size_t room;
+
+    /* Codes_SRS_UWS_CLIENT_01_642: [ When a receive memory budget is set, the memory lent to the underlying IO shall not exceed what is left of the budget after the bytes not yet decoded and the accumulated fragments, nothing being lent when nothing is left. ]*/
+    if (receive_memory_budget > 0)
+    {
+        size_t buffered = uws_client->stream_buffer_count + uws_client->fragment_buffer_count;
+
+        if (buffered >= receive_memory_budget)
+        {
+            lend_size = 0;
+        }
+        else if (receive_memory_budget - buffered < lend_size)
+        {
+            lend_size = receive_memory_budget - buffered;
+        }
+    }
+
+    room = uws_client->stream_buffer_size - (size_t)(uws_client->stream_buffer - uws_client->stream_buffer_memory) - uws_client->stream_buffer_count;
+
+    if ((lend_size > 0) &&
+        ((room <= 1) || (room - 1 < lend_size / 2)) &&
+        (reserve_stream_buffer_bytes(uws_client, lend_size) == 0))
+    {
+        room = uws_client->stream_buffer_size - (size_t)(uws_client->stream_buffer - uws_client->stream_buffer_memory) - uws_client->stream_buffer_count;
+    }
+
+    if ((receive_memory_budget > 0) &&
+        (room > lend_size + 1))
+    {
+        room = lend_size + 1;
+    }
+
+    /* Codes_SRS_UWS_CLIENT_01_636: [ If xio_set_receive_buffer fails, the memory shall not be lent again until the next uws_client_open_async. ]*/
+    if ((room > 1) &&
+        (xio_set_receive_buffer(uws_client->underlying_io, uws_client->stream_buffer + uws_client->stream_buffer_count, room - 1) != 0))
+    {
+        uws_client->receive_buffer_not_lendable = true;
+    }
+}
+
+static void consume_stream_buffer_bytes(UWS_CLIENT_INSTANCE* uws_client, size_t consumed_bytes)
+{
     uws_client->stream_buffer_count -= consumed_bytes;
+
+    if (uws_client->stream_buffer_count == 0)
+    {
+        uws_client->stream_buffer = uws_client->stream_buffer_memory;
+    }
+    else
+    {
+        uws_client->stream_buffer += consumed_bytes;
+    }
 }
 
 static void on_underlying_io_close_complete(void* context)
@@ -1008,37 +1915,187 @@ static int ParseHttpResponse(const char* src, int* dst)
         }
         else
         {
-            if (ParseStringToDecimal(src, dst) != 0)
-            {
-                result = __FAILURE__;
-            }
-            else
-            {
-                result = 0;
-            }
+            if (ParseStringToDecimal(src, dst) != 0)
+            {
+                result = __FAILURE__;
+            }
+            else
+            {
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+static void indicate_ws_frame_received(UWS_CLIENT_INSTANCE* uws_client, unsigned char frame_type, const unsigned char* payload, size_t payload_length)
+{
+    uws_client->stats.bytes_received += payload_length;
+    uws_client->stats.callback_count++;
+    uws_client->on_ws_frame_received(uws_client->on_ws_frame_received_context, frame_type, payload, payload_length);
+}
+
+/* Gives the bytes to be indicated to the user for received message data, decompressing them when the message is compressed */
+static int decode_message_payload(UWS_CLIENT_INSTANCE* uws_client, const unsigned char* bytes, size_t length, bool is_final, const unsigned char** payload, size_t* payload_length)
+{
+    int result;
+
+#ifdef USE_WS_PERMESSAGE_DEFLATE
+    if (uws_client->receiving_compressed_message)
+    {
+        int inflate_result;
+        bool is_too_big;
+        size_t max_inflated_length = (uws_client->receive_limits.max_message_size > 0) ?
+            uws_client->receive_limits.max_message_size - uws_client->inflated_message_size : (size_t)-1;
+#ifdef XIO_STATS_TIMING
+        uint64_t start_time_us = xio_stats_get_time_us();
+#endif
+
+        inflate_result = inflate_message_bytes(uws_client, bytes, length, is_final, max_inflated_length, payload_length, &is_too_big);
+
+#ifdef XIO_STATS_TIMING
+        uws_client->stats.time_us += xio_stats_get_time_us() - start_time_us;
+#endif
+
+        if (is_too_big)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_640: [ If a compressed message decompresses to more than the maximum message size, the connection shall be closed with a Close frame with status code 1009 and an error shall be indicated by calling the on_ws_error callback with WS_ERROR_MESSAGE_TOO_BIG. ]*/
+            LogError("Received message decompresses to more than %lu bytes", (unsigned long)uws_client->receive_limits.max_message_size);
+            indicate_ws_error_and_close(uws_client, WS_ERROR_MESSAGE_TOO_BIG, 1009);
+            result = __FAILURE__;
+        }
+        else if (inflate_result != 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_551: [ If decompressing a received message fails, an error shall be indicated by calling the on_ws_error callback with WS_ERROR_BAD_FRAME_RECEIVED. ]*/
+            LogError("Cannot decompress received message");
+            indicate_ws_error(uws_client, WS_ERROR_BAD_FRAME_RECEIVED);
+            result = __FAILURE__;
+        }
+        else
+        {
+            *payload = uws_client->inflate_buffer;
+            uws_client->inflated_message_size = is_final ? 0 : uws_client->inflated_message_size + *payload_length;
+            result = 0;
         }
     }
+    else
+#else
+    (void)uws_client;
+    (void)is_final;
+#endif
+    {
+        *payload = bytes;
+        *payload_length = length;
+        result = 0;
+    }
+
+    return result;
+}
+
+/* Tells whether a frame, of which the header says that it has length bytes of payload and needed_bytes bytes in all, goes over the receive limits */
+static bool is_over_receive_limits(UWS_CLIENT_INSTANCE* uws_client, unsigned char opcode, size_t length, size_t needed_bytes)
+{
+    bool result;
+    const WS_RECEIVE_LIMITS* receive_limits = &uws_client->receive_limits;
+    size_t message_size = (opcode == (unsigned char)WS_CONTINUATION_FRAME) ? uws_client->received_message_size : 0;
+
+    if ((receive_limits->max_frame_size > 0) &&
+        (length > receive_limits->max_frame_size))
+    {
+        /* Codes_SRS_UWS_CLIENT_01_637: [ When a maximum frame size is set and the header of a received frame gives it more payload than that, the connection shall be closed with a Close frame with status code 1009 and an error shall be indicated by calling the on_ws_error callback with WS_ERROR_MESSAGE_TOO_BIG. ]*/
+        result = true;
+    }
+    else if ((opcode < (unsigned char)WS_CLOSE_FRAME) &&
+        (receive_limits->max_message_size > 0) &&
+        (length > receive_limits->max_message_size - message_size))
+    {
+        /* Codes_SRS_UWS_CLIENT_01_638: [ When a maximum message size is set and the payload of a received data frame together with the payload of the fragments received before it for the same message is more than that, the connection shall be closed with a Close frame with status code 1009 and an error shall be indicated by calling the on_ws_error callback with WS_ERROR_MESSAGE_TOO_BIG. ]*/
+        result = true;
+    }
+    else if ((receive_limits->receive_memory_budget > 0) &&
+        ((needed_bytes > receive_limits->receive_memory_budget) ||
+         (uws_client->fragment_buffer_count > receive_limits->receive_memory_budget - needed_bytes)))
+    {
+        /* Codes_SRS_UWS_CLIENT_01_639: [ When a receive memory budget is set and a received frame together with the accumulated fragments needs more than that, the connection shall be closed with a Close frame with status code 1009 and an error shall be indicated by calling the on_ws_error callback with WS_ERROR_MESSAGE_TOO_BIG. ]*/
+        result = true;
+    }
+    else
+    {
+        result = false;
+    }
 
     return result;
 }
 
-static int process_frame_fragment(UWS_CLIENT_INSTANCE *uws_client, size_t length, size_t needed_bytes)
+static int process_frame_fragment(UWS_CLIENT_INSTANCE *uws_client, unsigned char frame_type, unsigned char fragment_flags, size_t length, size_t needed_bytes)
 {
     int result;
-    unsigned char *new_fragment_bytes = (unsigned char *)realloc(uws_client->fragment_buffer, uws_client->fragment_buffer_count + length);
-    if (new_fragment_bytes == NULL)
+    size_t needed_size = uws_client->fragment_buffer_count + length;
+
+    uws_client->received_message_size = (((fragment_flags & WS_FRAGMENT_FIRST) != 0) ? 0 : uws_client->received_message_size) + length;
+
+    if (uws_client->on_ws_fragment_received != NULL)
     {
-        /* Codes_SRS_UWS_CLIENT_01_379: [ If allocating memory for accumulating the bytes fails, uws shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_NOT_ENOUGH_MEMORY. ]*/
-        LogError("Cannot allocate memory for received data");
-        indicate_ws_error(uws_client, WS_ERROR_NOT_ENOUGH_MEMORY);
-        result = __FAILURE__;
+        const unsigned char* payload;
+        size_t payload_length;
+
+        if (decode_message_payload(uws_client, uws_client->stream_buffer + needed_bytes - length, length, (fragment_flags & WS_FRAGMENT_FINAL) != 0, &payload, &payload_length) != 0)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_UWS_CLIENT_01_535: [ When fragment streaming is enabled, each fragment of a fragmented message shall be indicated as soon as it is decoded by calling on_ws_fragment_received with the message type, the fragment flags and the fragment payload, without accumulating it. ]*/
+            uws_client->stats.bytes_received += payload_length;
+            uws_client->stats.callback_count++;
+            uws_client->on_ws_fragment_received(uws_client->on_ws_fragment_received_context, frame_type, fragment_flags, payload, payload_length);
+            result = 0;
+        }
+    }
+    else if (needed_size > uws_client->fragment_buffer_size)
+    {
+        /* grow geometrically so that the memory of a fragmented message is reused for the following ones */
+        size_t new_size = (uws_client->fragment_buffer_size > ((size_t)-1) / 2) ? needed_size : uws_client->fragment_buffer_size * 2;
+        unsigned char *new_fragment_bytes;
+        int previous_budget;
+        if ((uws_client->receive_limits.receive_memory_budget > 0) &&
+            (new_size > uws_client->receive_limits.receive_memory_budget))
+        {
+            new_size = uws_client->receive_limits.receive_memory_budget;
+        }
+        if (new_size < needed_size)
+        {
+            new_size = needed_size;
+        }
+
+        /* Codes_SRS_UWS_CLIENT_01_607: [ When built with GB_USE_BUDGETS, the memory that accumulates the fragments of a message shall be counted in the GBALLOC_BUDGET_UWS_FRAGMENTS budget. ]*/
+        previous_budget = GBALLOC_BUDGET_BEGIN(GBALLOC_BUDGET_UWS_FRAGMENTS);
+        new_fragment_bytes = (unsigned char *)realloc(uws_client->fragment_buffer, new_size);
+        GBALLOC_BUDGET_END(previous_budget);
+        if (new_fragment_bytes == NULL)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_379: [ If allocating memory for accumulating the bytes fails, uws shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_NOT_ENOUGH_MEMORY. ]*/
+            LogError("Cannot allocate memory for received data");
+            indicate_ws_error(uws_client, WS_ERROR_NOT_ENOUGH_MEMORY);
+            result = __FAILURE__;
+        }
+        else
+        {
+            uws_client->fragment_buffer = new_fragment_bytes;
+            uws_client->fragment_buffer_size = new_size;
+            result = 0;
+        }
     }
     else
     {
-        uws_client->fragment_buffer = new_fragment_bytes;
+        result = 0;
+    }
+
+    if ((result == 0) && (uws_client->on_ws_fragment_received == NULL) && (length > 0))
+    {
         (void)memcpy(uws_client->fragment_buffer + uws_client->fragment_buffer_count, uws_client->stream_buffer + needed_bytes - length, length);
         uws_client->fragment_buffer_count += length;
-        result = 0;
     }
 
     return result;
@@ -1061,6 +2118,9 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
         {
             unsigned char decode_stream = 1;
 
+            /* Codes_SRS_UWS_CLIENT_01_621: [ Any bytes received shall count as a sign of life of the connection for keepalive. ]*/
+            uws_client->keepalive_bytes_received = true;
+
             switch (uws_client->uws_state)
             {
             default:
@@ -1077,8 +2137,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
             case UWS_STATE_WAITING_FOR_UPGRADE_RESPONSE:
             {
                 /* Codes_SRS_UWS_CLIENT_01_378: [ When on_underlying_io_bytes_received is called while the uws is OPENING, the received bytes shall be accumulated in order to attempt parsing the WebSocket Upgrade response. ]*/
-                unsigned char* new_received_bytes = (unsigned char*)realloc(uws_client->stream_buffer, uws_client->stream_buffer_count + size + 1);
-                if (new_received_bytes == NULL)
+                if (append_stream_buffer_bytes(uws_client, buffer, size) != 0)
                 {
                     /* Codes_SRS_UWS_CLIENT_01_379: [ If allocating memory for accumulating the bytes fails, uws shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_NOT_ENOUGH_MEMORY. ]*/
                     indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_NOT_ENOUGH_MEMORY);
@@ -1086,10 +2145,6 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                 }
                 else
                 {
-                    uws_client->stream_buffer = new_received_bytes;
-                    (void)memcpy(uws_client->stream_buffer + uws_client->stream_buffer_count, buffer, size);
-                    uws_client->stream_buffer_count += size;
-
                     decode_stream = 1;
                 }
 
@@ -1100,21 +2155,16 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
             case UWS_STATE_CLOSING_WAITING_FOR_CLOSE:
             {
                 /* Codes_SRS_UWS_CLIENT_01_385: [ If the state of the uws instance is OPEN, the received bytes shall be used for decoding WebSocket frames. ]*/
-                unsigned char* new_received_bytes = (unsigned char*)realloc(uws_client->stream_buffer, uws_client->stream_buffer_count + size + 1);
-                if (new_received_bytes == NULL)
+                /* Codes_SRS_UWS_CLIENT_01_532: [ The memory used for accumulating received bytes shall only be reallocated when the bytes not yet decoded together with the new bytes do not fit in it. ]*/
+                if (append_stream_buffer_bytes(uws_client, buffer, size) != 0)
                 {
                     /* Codes_SRS_UWS_CLIENT_01_418: [ If allocating memory for the bytes accumulated for decoding WebSocket frames fails, an error shall be indicated by calling the on_ws_error callback with WS_ERROR_NOT_ENOUGH_MEMORY. ]*/
-                    LogError("Cannot allocate memory for received data");
                     indicate_ws_error(uws_client, WS_ERROR_NOT_ENOUGH_MEMORY);
 
                     decode_stream = 0;
                 }
                 else
                 {
-                    uws_client->stream_buffer = new_received_bytes;
-                    (void)memcpy(uws_client->stream_buffer + uws_client->stream_buffer_count, buffer, size);
-                    uws_client->stream_buffer_count += size;
-
                     decode_stream = 1;
                 }
 
@@ -1150,6 +2200,9 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                         ((request_end_ptr = strstr((const char*)uws_client->stream_buffer, "\r\n\r\n")) != NULL))
                     {
                         int status_code;
+#ifdef USE_WS_PERMESSAGE_DEFLATE
+                        WS_OPEN_RESULT negotiate_result;
+#endif
 
                         /* This part should really be done with the HTTPAPI, but that has to be done as a separate step
                         as the HTTPAPI has to expose somehow the underlying IO and currently this would be a too big of a change. */
@@ -1168,6 +2221,12 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                             LogError("Bad status (%d) received in WebSocket Upgrade response", status_code);
                             indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_BAD_RESPONSE_STATUS);
                         }
+#ifdef USE_WS_PERMESSAGE_DEFLATE
+                        else if ((negotiate_result = negotiate_permessage_deflate(uws_client, (const char*)uws_client->stream_buffer, request_end_ptr + 2)) != WS_OPEN_OK)
+                        {
+                            indicate_ws_open_complete_error_and_close(uws_client, negotiate_result);
+                        }
+#endif
                         else
                         {
                             /* Codes_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames ]*/
@@ -1176,6 +2235,9 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                             /* Codes_SRS_UWS_CLIENT_01_381: [ If the status is 101, uws shall be considered OPEN and this shall be indicated by calling the on_ws_open_complete callback passed to uws_client_open_async with IO_OPEN_OK. ]*/
                             uws_client->uws_state = UWS_STATE_OPEN;
 
+                            /* Codes_SRS_UWS_CLIENT_01_616: [ When the uws instance becomes OPEN and keepalive is enabled, the keepalive timer shall be started with the ping interval by calling timer_wheel_start_timer. ]*/
+                            start_keepalive(uws_client);
+
                             /* Codes_SRS_UWS_CLIENT_01_065: [ When the client is to _Establish a WebSocket Connection_ given a set of (/host/, /port/, /resource name/, and /secure/ flag), along with a list of /protocols/ and /extensions/ to be used, and an /origin/ in the case of web browsers, it MUST open a connection, send an opening handshake, and read the server's handshake in response. ]*/
                             /* Codes_SRS_UWS_CLIENT_01_115: [ If the server's response is validated as provided for above, it is said that _The WebSocket Connection is Established_ and that the WebSocket Connection is in the OPEN state. ]*/
                             uws_client->on_ws_open_complete(uws_client->on_ws_open_complete_context, WS_OPEN_OK);
@@ -1183,6 +2245,13 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                             decode_stream = 1;
                         }
                     }
+                    else if ((uws_client->receive_limits.receive_memory_budget > 0) &&
+                        (uws_client->stream_buffer_count > uws_client->receive_limits.receive_memory_budget))
+                    {
+                        /* Codes_SRS_UWS_CLIENT_01_641: [ When a receive memory budget is set and more bytes than that are accumulated without the end of the WebSocket upgrade response, the open shall fail by calling on_ws_open_complete with WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE. ]*/
+                        LogError("WebSocket upgrade response bigger than the receive memory budget");
+                        indicate_ws_open_complete_error_and_close(uws_client, WS_OPEN_ERROR_BAD_UPGRADE_RESPONSE);
+                    }
 
                     break;
                 }
@@ -1192,6 +2261,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                 {
                     size_t needed_bytes = 2;
                     size_t length;
+                    bool is_length_decoded = false;
 
                     /* Codes_SRS_UWS_CLIENT_01_277: [ To receive WebSocket data, an endpoint listens on the underlying network connection. ]*/
                     /* Codes_SRS_UWS_CLIENT_01_278: [ Incoming data MUST be parsed as WebSocket frames as defined in Section 5.2. ]*/
@@ -1208,6 +2278,22 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                             indicate_ws_error_and_close(uws_client, WS_ERROR_BAD_FRAME_RECEIVED, 1002);
                         }
 
+#ifdef USE_WS_PERMESSAGE_DEFLATE
+                        if ((uws_client->stream_buffer[0] & 0x40) != 0)
+                        {
+                            unsigned char rsv1_opcode = uws_client->stream_buffer[0] & 0xF;
+
+                            if ((!uws_client->permessage_deflate_negotiated) ||
+                                ((rsv1_opcode != (unsigned char)WS_TEXT_FRAME) && (rsv1_opcode != (unsigned char)WS_BINARY_FRAME)))
+                            {
+                                /* Codes_SRS_UWS_CLIENT_01_550: [ If a frame with RSV1 set is received while permessage-deflate was not negotiated, or RSV1 is set on a control frame or on a continuation frame, an error shall be indicated by calling the on_ws_error callback with WS_ERROR_BAD_FRAME_RECEIVED. ]*/
+                                LogError("Frame with RSV1 set received, opcode 0x%x", (unsigned int)rsv1_opcode);
+                                indicate_ws_error(uws_client, WS_ERROR_BAD_FRAME_RECEIVED);
+                                has_error = 1;
+                            }
+                        }
+#endif
+
                         /* Codes_SRS_UWS_CLIENT_01_163: [ The length of the "Payload data", in bytes: ]*/
                         /* Codes_SRS_UWS_CLIENT_01_164: [ if 0-125, that is the payload length. ]*/
                         length = uws_client->stream_buffer[1];
@@ -1233,6 +2319,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                 else
                                 {
                                     needed_bytes += (size_t)length;
+                                    is_length_decoded = true;
                                 }
                             }
                         }
@@ -1274,6 +2361,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                     else
                                     {
                                         needed_bytes += length;
+                                        is_length_decoded = true;
                                     }
                                 }
                             }
@@ -1281,6 +2369,17 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                         else
                         {
                             needed_bytes += length;
+                            is_length_decoded = true;
+                        }
+
+                        /* the limits are checked before the payload is accumulated, so that a frame that is too big is not waited for */
+                        if ((has_error == 0) &&
+                            is_length_decoded &&
+                            is_over_receive_limits(uws_client, uws_client->stream_buffer[0] & 0xF, length, needed_bytes))
+                        {
+                            LogError("Received a frame with %lu bytes of payload, over the receive limits", (unsigned long)length);
+                            indicate_ws_error_and_close(uws_client, WS_ERROR_MESSAGE_TOO_BIG, 1009);
+                            has_error = 1;
                         }
 
                         if ((has_error == 0) &&
@@ -1291,6 +2390,15 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                             /* Codes_SRS_UWS_CLIENT_01_147: [ Indicates that this is the final fragment in a message. ]*/
                             bool is_final = (uws_client->stream_buffer[0] & 0x80) != 0;
 
+#ifdef USE_WS_PERMESSAGE_DEFLATE
+                            /* RSV1 on the first frame of a message tells whether the whole message is compressed */
+                            if (((opcode == (unsigned char)WS_TEXT_FRAME) || (opcode == (unsigned char)WS_BINARY_FRAME)) &&
+                                (uws_client->fragmented_frame_type == WS_FRAME_TYPE_UNKNOWN))
+                            {
+                                uws_client->receiving_compressed_message = (uws_client->stream_buffer[0] & 0x40) != 0;
+                            }
+#endif
+
                             switch (opcode)
                             {
                             default:
@@ -1301,7 +2409,18 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                 /* Codes_SRS_UWS_CLIENT_01_213: [ A fragmented message consists of a single frame with the FIN bit clear and an opcode other than 0, followed by zero or more frames with the FIN bit clear and the opcode set to 0, and terminated by a single frame with the FIN bit set and an opcode of 0. ]*/
                                 /* Codes_SRS_UWS_CLIENT_01_216: [ Message fragments MUST be delivered to the recipient in the order sent by the sender. ]*/
                                 /* Codes_SRS_UWS_CLIENT_01_219: [ A sender MAY create fragments of any size for non-control messages. ]*/
-                                if (process_frame_fragment(uws_client, length, needed_bytes) != 0)
+                                if ((uws_client->on_ws_fragment_received != NULL) &&
+                                    (uws_client->fragmented_frame_type == WS_FRAME_TYPE_UNKNOWN))
+                                {
+                                    /* Codes_SRS_UWS_CLIENT_01_537: [ When fragment streaming is enabled and a continuation fragment is received without an initial fragment, an error shall be indicated by calling the on_ws_error callback with WS_ERROR_BAD_FRAME_RECEIVED. ]*/
+                                    LogError("Continuation fragment received without initial fragment specifying frame data type");
+                                    indicate_ws_error(uws_client, WS_ERROR_BAD_FRAME_RECEIVED);
+                                    decode_stream = 1;
+                                    break;
+                                }
+
+                                /* Codes_SRS_UWS_CLIENT_01_536: [ The first fragment of a message shall be indicated with WS_FRAGMENT_FIRST, the final one with WS_FRAGMENT_FINAL and the ones in between with no flag set. ]*/
+                                if (process_frame_fragment(uws_client, uws_client->fragmented_frame_type, is_final ? WS_FRAGMENT_FINAL : 0, length, needed_bytes) != 0)
                                 {
                                     break;
                                 }
@@ -1316,7 +2435,19 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                         decode_stream = 1;
                                         break;
                                     }
-                                    uws_client->on_ws_frame_received(uws_client->on_ws_frame_received_context, uws_client->fragmented_frame_type, uws_client->fragment_buffer, uws_client->fragment_buffer_count);
+
+                                    if (uws_client->on_ws_fragment_received == NULL)
+                                    {
+                                        const unsigned char* payload;
+                                        size_t payload_length;
+
+                                        if (decode_message_payload(uws_client, uws_client->fragment_buffer, uws_client->fragment_buffer_count, true, &payload, &payload_length) != 0)
+                                        {
+                                            break;
+                                        }
+
+                                        indicate_ws_frame_received(uws_client, uws_client->fragmented_frame_type, payload, payload_length);
+                                    }
                                     uws_client->fragment_buffer_count = 0;
                                     uws_client->fragmented_frame_type = WS_FRAME_TYPE_UNKNOWN;
                                 }
@@ -1335,7 +2466,15 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                 /* Codes_SRS_UWS_CLIENT_01_282: [ If the frame comprises an unfragmented message (Section 5.4), it is said that _A WebSocket Message Has Been Received_ with type /type/ and data /data/. ]*/
                                 if (is_final)
                                 {
-                                    uws_client->on_ws_frame_received(uws_client->on_ws_frame_received_context, WS_FRAME_TYPE_TEXT, uws_client->stream_buffer + needed_bytes - length, length);
+                                    const unsigned char* payload;
+                                    size_t payload_length;
+
+                                    if (decode_message_payload(uws_client, uws_client->stream_buffer + needed_bytes - length, length, true, &payload, &payload_length) != 0)
+                                    {
+                                        break;
+                                    }
+
+                                    indicate_ws_frame_received(uws_client, WS_FRAME_TYPE_TEXT, payload, payload_length);
                                 }
                                 else
                                 {
@@ -1350,7 +2489,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                     /* Codes_SRS_UWS_CLIENT_01_213: [ A fragmented message consists of a single frame with the FIN bit clear and an opcode other than 0, followed by zero or more frames with the FIN bit clear and the opcode set to 0, and terminated by a single frame with the FIN bit set and an opcode of 0. ]*/
                                     /* Codes_SRS_UWS_CLIENT_01_216: [ Message fragments MUST be delivered to the recipient in the order sent by the sender. ]*/
                                     /* Codes_SRS_UWS_CLIENT_01_219: [ A sender MAY create fragments of any size for non-control messages. ]*/
-                                    if (process_frame_fragment(uws_client, length, needed_bytes) != 0)
+                                    if (process_frame_fragment(uws_client, WS_FRAME_TYPE_TEXT, WS_FRAGMENT_FIRST, length, needed_bytes) != 0)
                                     {
                                         break;
                                     }
@@ -1375,7 +2514,15 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                 /* Codes_SRS_UWS_CLIENT_01_282: [ If the frame comprises an unfragmented message (Section 5.4), it is said that _A WebSocket Message Has Been Received_ with type /type/ and data /data/. ]*/
                                 if (is_final)
                                 {
-                                    uws_client->on_ws_frame_received(uws_client->on_ws_frame_received_context, WS_FRAME_TYPE_BINARY, uws_client->stream_buffer + needed_bytes - length, length);
+                                    const unsigned char* payload;
+                                    size_t payload_length;
+
+                                    if (decode_message_payload(uws_client, uws_client->stream_buffer + needed_bytes - length, length, true, &payload, &payload_length) != 0)
+                                    {
+                                        break;
+                                    }
+
+                                    indicate_ws_frame_received(uws_client, WS_FRAME_TYPE_BINARY, payload, payload_length);
                                 }
                                 else
                                 {
@@ -1390,7 +2537,7 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                     /* Codes_SRS_UWS_CLIENT_01_213: [ A fragmented message consists of a single frame with the FIN bit clear and an opcode other than 0, followed by zero or more frames with the FIN bit clear and the opcode set to 0, and terminated by a single frame with the FIN bit set and an opcode of 0. ]*/
                                     /* Codes_SRS_UWS_CLIENT_01_216: [ Message fragments MUST be delivered to the recipient in the order sent by the sender. ]*/
                                     /* Codes_SRS_UWS_CLIENT_01_219: [ A sender MAY create fragments of any size for non-control messages. ]*/
-                                    if (process_frame_fragment(uws_client, length, needed_bytes) != 0)
+                                    if (process_frame_fragment(uws_client, WS_FRAME_TYPE_BINARY, WS_FRAGMENT_FIRST, length, needed_bytes) != 0)
                                     {
                                         break;
                                     }
@@ -1514,6 +2661,9 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                                     {
                                         close_frame_bytes = BUFFER_u_char(close_frame_buffer);
                                         close_frame_length = BUFFER_length(close_frame_buffer);
+
+                                        /* Codes_SRS_UWS_CLIENT_01_576: [ Before a CLOSE frame is sent, the frames waiting to be sent because of send coalescing shall be sent. ]*/
+                                        (void)send_batched_frames(uws_client);
                                         if (xio_send(uws_client->underlying_io, close_frame_bytes, close_frame_length, on_underlying_io_close_sent, uws_client) != 0)
                                         {
                                             LogError("Cannot send the response CLOSE frame");
@@ -1592,6 +2742,16 @@ static void on_underlying_io_bytes_received(void* context, const unsigned char*
                 }
                 }
             }
+
+            /* Codes_SRS_UWS_CLIENT_01_633: [ If a receive buffer size is set and the uws instance is still accumulating received bytes, on_underlying_io_bytes_received shall lend the memory after the bytes not yet decoded to the underlying IO by calling xio_set_receive_buffer, growing it to the receive buffer size first when less than half of that is left. ]*/
+            if ((uws_client->receive_buffer_size > 0) &&
+                !uws_client->receive_buffer_not_lendable &&
+                ((uws_client->uws_state == UWS_STATE_WAITING_FOR_UPGRADE_RESPONSE) ||
+                 (uws_client->uws_state == UWS_STATE_OPEN) ||
+                 (uws_client->uws_state == UWS_STATE_CLOSING_WAITING_FOR_CLOSE)))
+            {
+                lend_stream_buffer(uws_client);
+            }
         }
     }
 }
@@ -1661,9 +2821,17 @@ int uws_client_open_async(UWS_CLIENT_HANDLE uws_client, ON_WS_OPEN_COMPLETE on_w
         {
             uws_client->uws_state = UWS_STATE_OPENING_UNDERLYING_IO;
 
+            uws_client->stream_buffer = uws_client->stream_buffer_memory;
             uws_client->stream_buffer_count = 0;
+            uws_client->receive_buffer_not_lendable = false;
             uws_client->fragment_buffer_count = 0;
             uws_client->fragmented_frame_type = WS_FRAME_TYPE_UNKNOWN;
+            uws_client->received_message_size = 0;
+#ifdef USE_WS_PERMESSAGE_DEFLATE
+            /* the extension is negotiated again for each connection */
+            end_permessage_deflate(uws_client);
+            uws_client->inflated_message_size = 0;
+#endif
 
             uws_client->on_ws_open_complete = on_ws_open_complete;
             uws_client->on_ws_open_complete_context = on_ws_open_complete_context;
@@ -1696,32 +2864,46 @@ int uws_client_open_async(UWS_CLIENT_HANDLE uws_client, ON_WS_OPEN_COMPLETE on_w
     return result;
 }
 
-static int complete_send_frame(WS_PENDING_SEND* ws_pending_send, LIST_ITEM_HANDLE pending_send_frame_item, WS_SEND_FRAME_RESULT ws_send_frame_result)
+static void complete_send_frame(WS_PENDING_SEND* ws_pending_send, WS_SEND_FRAME_RESULT ws_send_frame_result)
 {
-    int result;
     UWS_CLIENT_INSTANCE* uws_client = ws_pending_send->uws_client;
 
-    /* Codes_SRS_UWS_CLIENT_01_432: [ The indicated sent frame shall be removed from the list by calling singlylinkedlist_remove. ]*/
-    if (singlylinkedlist_remove(uws_client->pending_sends, pending_send_frame_item) != 0)
+    /* Codes_SRS_UWS_CLIENT_01_432: [ The indicated sent frame shall be removed from the list by unlinking the list entry embedded in it. ]*/
+    (void)DList_RemoveEntryList(&ws_pending_send->link);
+
+    /* Codes_SRS_UWS_CLIENT_01_609: [ When built with XIO_TRACE, the span of a frame shall end with the result given to on_ws_send_frame_complete. ]*/
+    XIO_TRACE_END(&ws_pending_send->trace_span, "uws_client", "send_frame", (int)ws_send_frame_result);
+
+    if (ws_pending_send->on_ws_send_frame_complete != NULL)
     {
-        LogError("Failed removing item from list");
-        result = __FAILURE__;
+        uws_client->stats.callback_count++;
+
+        /* Codes_SRS_UWS_CLIENT_01_037: [ When indicating pending send frames as cancelled the callback context passed to the on_ws_send_frame_complete callback shall be the context given to uws_client_send_frame_async. ]*/
+        ws_pending_send->on_ws_send_frame_complete(ws_pending_send->context, ws_send_frame_result);
     }
-    else
+
+    /* Codes_SRS_UWS_CLIENT_01_434: [ The memory associated with the sent frame shall be freed. ]*/
+    if (ws_pending_send->unsent_message != NULL)
     {
-        if (ws_pending_send->on_ws_send_frame_complete != NULL)
-        {
-            /* Codes_SRS_UWS_CLIENT_01_037: [ When indicating pending send frames as cancelled the callback context passed to the on_ws_send_frame_complete callback shall be the context given to uws_client_send_frame_async. ]*/
-            ws_pending_send->on_ws_send_frame_complete(ws_pending_send->context, ws_send_frame_result);
-        }
+        free(ws_pending_send->unsent_message);
+    }
+    free(ws_pending_send);
+}
 
-        /* Codes_SRS_UWS_CLIENT_01_434: [ The memory associated with the sent frame shall be freed. ]*/
-        free(ws_pending_send);
+/* Tells whether ws_pending_send is still queued, a callback may have completed it; only the addresses are compared */
+static bool is_pending_send(UWS_CLIENT_INSTANCE* uws_client, const WS_PENDING_SEND* ws_pending_send)
+{
+    PDLIST_ENTRY entry;
 
-        result = 0;
+    for (entry = uws_client->pending_sends.Flink; entry != &uws_client->pending_sends; entry = entry->Flink)
+    {
+        if (entry == &ws_pending_send->link)
+        {
+            break;
+        }
     }
 
-    return result;
+    return (entry != &uws_client->pending_sends);
 }
 
 /* Codes_SRS_UWS_CLIENT_01_029: [ uws_client_close_async shall close the uws instance connection if an open action is either pending or has completed successfully (if the IO is open). ]*/
@@ -1768,140 +2950,390 @@ int uws_client_close_async(UWS_CLIENT_HANDLE uws_client, ON_WS_CLOSE_COMPLETE on
             else
             {
                 /* Codes_SRS_UWS_CLIENT_01_034: [ uws_client_close_async shall obtain all the pending send frames by repetitively querying for the head of the pending IO list and freeing that head item. ]*/
-                LIST_ITEM_HANDLE first_pending_send;
+                /* Codes_SRS_UWS_CLIENT_01_577: [ The frames waiting to be sent because of send coalescing shall be cancelled with the other pending send frames, without being sent. ]*/
+                discard_send_batch(uws_client);
+                /* Codes_SRS_UWS_CLIENT_01_593: [ The messages waiting to be sent as fragments shall be cancelled with the other pending send frames, without sending their remaining fragments. ]*/
+                discard_unsent_messages(uws_client);
+
+                /* Codes_SRS_UWS_CLIENT_01_035: [ Obtaining the head of the pending send frames list shall be done by taking the first entry of the list. ]*/
+                while (!DList_IsListEmpty(&uws_client->pending_sends))
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_036: [ For each pending send frame the send complete callback shall be called with UWS_SEND_FRAME_CANCELLED. ]*/
+                    complete_send_frame(containingRecord(uws_client->pending_sends.Flink, WS_PENDING_SEND, link), WS_SEND_FRAME_CANCELLED);
+                }
+
+                /* Codes_SRS_UWS_CLIENT_01_396: [ On success uws_client_close_async shall return 0. ]*/
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+/* Codes_SRS_UWS_CLIENT_01_317: [ Clients SHOULD NOT close the WebSocket connection arbitrarily. ]*/
+int uws_client_close_handshake_async(UWS_CLIENT_HANDLE uws_client, uint16_t close_code, const char* close_reason, ON_WS_CLOSE_COMPLETE on_ws_close_complete, void* on_ws_close_complete_context)
+{
+    int result;
+
+    if (uws_client == NULL)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_467: [ if uws_client is NULL, uws_client_close_handshake_async shall return a non-zero value. ]*/
+        LogError("NULL uws_client");
+        result = __FAILURE__;
+    }
+    else
+    {
+        if ((uws_client->uws_state == UWS_STATE_CLOSED) ||
+            /* Codes_SRS_UWS_CLIENT_01_474: [ uws_client_close_handshake_async when already CLOSING shall fail and return a non-zero value. ]*/
+            (uws_client->uws_state == UWS_STATE_CLOSING_WAITING_FOR_CLOSE) ||
+            (uws_client->uws_state == UWS_STATE_CLOSING_SENDING_CLOSE) ||
+            (uws_client->uws_state == UWS_STATE_CLOSING_UNDERLYING_IO))
+        {
+            /* Codes_SRS_UWS_CLIENT_01_473: [ uws_client_close_handshake_async when no open action has been issued shall fail and return a non-zero value. ]*/
+            LogError("uws_client_close_handshake_async has been called when already CLOSED");
+            result = __FAILURE__;
+        }
+        else
+        {
+            (void)close_reason;
+
+            /* Codes_SRS_UWS_CLIENT_01_468: [ on_ws_close_complete and on_ws_close_complete_context shall be saved and the callback on_ws_close_complete shall be triggered when the close is complete. ]*/
+            /* Codes_SRS_UWS_CLIENT_01_469: [ The on_ws_close_complete argument shall be allowed to be NULL, in which case no callback shall be called when the close is complete. ]*/
+            /* Codes_SRS_UWS_CLIENT_01_470: [ on_ws_close_complete_context shall also be allowed to be NULL. ]*/
+            uws_client->on_ws_close_complete = on_ws_close_complete;
+            uws_client->on_ws_close_complete_context = on_ws_close_complete_context;
+
+            uws_client->uws_state = UWS_STATE_CLOSING_WAITING_FOR_CLOSE;
+
+            /* Codes_SRS_UWS_CLIENT_01_577: [ The frames waiting to be sent because of send coalescing shall be cancelled with the other pending send frames, without being sent. ]*/
+            discard_send_batch(uws_client);
+            /* Codes_SRS_UWS_CLIENT_01_593: [ The messages waiting to be sent as fragments shall be cancelled with the other pending send frames, without sending their remaining fragments. ]*/
+            discard_unsent_messages(uws_client);
 
-                /* Codes_SRS_UWS_CLIENT_01_035: [ Obtaining the head of the pending send frames list shall be done by calling singlylinkedlist_get_head_item. ]*/
-                while ((first_pending_send = singlylinkedlist_get_head_item(uws_client->pending_sends)) != NULL)
+            /* Codes_SRS_UWS_CLIENT_01_465: [ uws_client_close_handshake_async shall initiate the close handshake by sending a close frame to the peer. ]*/
+            if (send_close_frame(uws_client, close_code) != 0)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_472: [ If xio_send fails, uws_client_close_handshake_async shall fail and return a non-zero value. ]*/
+                LogError("Sending CLOSE frame failed");
+                result = __FAILURE__;
+            }
+            else
+            {
+                while (!DList_IsListEmpty(&uws_client->pending_sends))
                 {
-                    WS_PENDING_SEND* ws_pending_send = (WS_PENDING_SEND*)singlylinkedlist_item_get_value(first_pending_send);
+                    complete_send_frame(containingRecord(uws_client->pending_sends.Flink, WS_PENDING_SEND, link), WS_SEND_FRAME_CANCELLED);
+                }
+
+                /* Codes_SRS_UWS_CLIENT_01_466: [ On success uws_client_close_handshake_async shall return 0. ]*/
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
+
+/* Completes the frames sent by one xio_send, starting with ws_pending_send */
+static void complete_send_frames(UWS_CLIENT_INSTANCE* uws_client, WS_PENDING_SEND* ws_pending_send, WS_SEND_FRAME_RESULT ws_send_frame_result)
+{
+    while (ws_pending_send != NULL)
+    {
+        WS_PENDING_SEND* next_batched_send = ws_pending_send->next_batched_send;
+
+        /* Codes_SRS_UWS_CLIENT_01_574: [ When the frames sent by one xio_send complete, each of them shall be indicated in the order it was sent, as if it had been sent alone. ]*/
+        complete_send_frame(ws_pending_send, ws_send_frame_result);
+
+        if ((next_batched_send != NULL) &&
+            !is_pending_send(uws_client, next_batched_send))
+        {
+            /* the callback closed the instance, cancelling the following frames */
+            ws_pending_send = NULL;
+        }
+        else
+        {
+            ws_pending_send = next_batched_send;
+        }
+    }
+}
+
+/* Removes the message whose fragments are being sent from the messages waiting to be sent as fragments */
+static void remove_first_unsent_message(UWS_CLIENT_INSTANCE* uws_client, WS_UNSENT_MESSAGE* unsent_message)
+{
+    uws_client->unsent_first_item = unsent_message->next_unsent_send;
+    if (uws_client->unsent_first_item == NULL)
+    {
+        uws_client->unsent_last_item = NULL;
+    }
+}
+
+/* Completes a fragment of a message, the message being completed with its last fragment or the first one that fails */
+static void complete_send_fragment(UWS_CLIENT_INSTANCE* uws_client, WS_PENDING_SEND* ws_pending_send, WS_SEND_FRAME_RESULT ws_send_frame_result)
+{
+    WS_UNSENT_MESSAGE* unsent_message = ws_pending_send->unsent_message;
+
+    unsent_message->fragment_in_flight = false;
+
+    if ((ws_send_frame_result != WS_SEND_FRAME_OK) ||
+        (unsent_message->sent_size == unsent_message->payload_size))
+    {
+        if (unsent_message->sent_size < unsent_message->payload_size)
+        {
+            remove_first_unsent_message(uws_client, unsent_message);
+        }
+
+        /* Codes_SRS_UWS_CLIENT_01_590: [ When the last fragment of a message is sent, or a fragment of it fails, the message shall be indicated once by calling on_ws_send_frame_complete, with the result of that fragment. ]*/
+        complete_send_frame(ws_pending_send, ws_send_frame_result);
+    }
+
+    /* Codes_SRS_UWS_CLIENT_01_589: [ The fragments shall be sent one at a time, the next fragment being sent once the previous one of the same message is sent, so that the frames sent in between are not held back by the whole message. ]*/
+    send_unsent_fragments(uws_client);
+}
+
+static void on_underlying_io_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    if (context == NULL)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_435: [ When on_underlying_io_send_complete is called with a NULL context, it shall do nothing. ]*/
+        LogError("on_underlying_io_send_complete called with NULL context");
+    }
+    else
+    {
+        WS_PENDING_SEND* ws_pending_send = (WS_PENDING_SEND*)context;
+        UWS_CLIENT_HANDLE uws_client = ws_pending_send->uws_client;
+        WS_SEND_FRAME_RESULT ws_send_frame_result;
+
+        switch (send_result)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_436: [ When on_underlying_io_send_complete is called with any other error code, the send shall be indicated to the uws user by calling on_ws_send_frame_complete with WS_SEND_FRAME_ERROR. ]*/
+        default:
+        case IO_SEND_ERROR:
+            /* Codes_SRS_UWS_CLIENT_01_390: [ When on_underlying_io_send_complete is called with IO_SEND_ERROR as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling on_ws_send_frame_complete with WS_SEND_FRAME_ERROR. ]*/
+            ws_send_frame_result = WS_SEND_FRAME_ERROR;
+            break;
+
+        case IO_SEND_OK:
+            /* Codes_SRS_UWS_CLIENT_01_389: [ When on_underlying_io_send_complete is called with IO_SEND_OK as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling on_ws_send_frame_complete with WS_SEND_FRAME_OK. ]*/
+            ws_send_frame_result = WS_SEND_FRAME_OK;
+            break;
+
+        case IO_SEND_CANCELLED:
+            /* Codes_SRS_UWS_CLIENT_01_391: [ When on_underlying_io_send_complete is called with IO_SEND_CANCELLED as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling on_ws_send_frame_complete with WS_SEND_FRAME_CANCELLED. ]*/
+            ws_send_frame_result = WS_SEND_FRAME_CANCELLED;
+            break;
+        }
+
+        if (ws_pending_send->unsent_message != NULL)
+        {
+            complete_send_fragment(uws_client, ws_pending_send, ws_send_frame_result);
+        }
+        else
+        {
+            complete_send_frames(uws_client, ws_pending_send, ws_send_frame_result);
+        }
+    }
+}
+
+/* Makes sure that the send buffer can hold a frame with payload_size bytes of payload at frame_offset, growing it geometrically */
+static int ensure_send_buffer_size(UWS_CLIENT_INSTANCE* uws_client, size_t frame_offset, size_t payload_size)
+{
+    int result;
+
+    if (payload_size > ((size_t)-1) - UWS_FRAME_ENCODER_MAX_HEADER_SIZE - frame_offset)
+    {
+        LogError("Frame too big: %u bytes", (unsigned int)payload_size);
+        result = __FAILURE__;
+    }
+    else if (frame_offset + payload_size + UWS_FRAME_ENCODER_MAX_HEADER_SIZE <= uws_client->send_buffer_size)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t needed_size = frame_offset + payload_size + UWS_FRAME_ENCODER_MAX_HEADER_SIZE;
+        size_t new_size = (uws_client->send_buffer_size > ((size_t)-1) / 2) ? ((size_t)-1) : uws_client->send_buffer_size * 2;
+        unsigned char* new_buffer;
 
-                    /* Codes_SRS_UWS_CLIENT_01_036: [ For each pending send frame the send complete callback shall be called with UWS_SEND_FRAME_CANCELLED. ]*/
-                    complete_send_frame(ws_pending_send, first_pending_send, WS_SEND_FRAME_CANCELLED);
-                }
+        if (new_size < needed_size)
+        {
+            new_size = needed_size;
+        }
 
-                /* Codes_SRS_UWS_CLIENT_01_396: [ On success uws_client_close_async shall return 0. ]*/
-                result = 0;
-            }
+        if ((new_buffer = (unsigned char*)realloc(uws_client->send_buffer, new_size)) == NULL)
+        {
+            result = __FAILURE__;
+        }
+        else
+        {
+            uws_client->send_buffer = new_buffer;
+            uws_client->send_buffer_size = new_size;
+            result = 0;
         }
     }
 
     return result;
 }
 
-/* Codes_SRS_UWS_CLIENT_01_317: [ Clients SHOULD NOT close the WebSocket connection arbitrarily. ]*/
-int uws_client_close_handshake_async(UWS_CLIENT_HANDLE uws_client, uint16_t close_code, const char* close_reason, ON_WS_CLOSE_COMPLETE on_ws_close_complete, void* on_ws_close_complete_context)
+/* Sends the frames waiting because of send coalescing with one xio_send */
+static int send_batched_frames(UWS_CLIENT_INSTANCE* uws_client)
 {
     int result;
 
-    if (uws_client == NULL)
+    if (uws_client->send_batch_first_item == NULL)
     {
-        /* Codes_SRS_UWS_CLIENT_01_467: [ if uws_client is NULL, uws_client_close_handshake_async shall return a non-zero value. ]*/
-        LogError("NULL uws_client");
-        result = __FAILURE__;
+        result = 0;
     }
     else
     {
-        if ((uws_client->uws_state == UWS_STATE_CLOSED) ||
-            /* Codes_SRS_UWS_CLIENT_01_474: [ uws_client_close_handshake_async when already CLOSING shall fail and return a non-zero value. ]*/
-            (uws_client->uws_state == UWS_STATE_CLOSING_WAITING_FOR_CLOSE) ||
-            (uws_client->uws_state == UWS_STATE_CLOSING_SENDING_CLOSE) ||
-            (uws_client->uws_state == UWS_STATE_CLOSING_UNDERLYING_IO))
+        WS_PENDING_SEND* first_batched_send = uws_client->send_batch_first_item;
+        unsigned char* batch = uws_client->send_buffer;
+        size_t batch_length = uws_client->send_batch_length;
+        size_t batch_buffer_size = uws_client->send_buffer_size;
+        int send_result;
+#ifdef XIO_TRACE
+        XIO_TRACE_SPAN first_trace_span = first_batched_send->trace_span;
+        XIO_TRACE_SPAN previous_trace_span;
+#endif
+
+        /* Codes_SRS_UWS_CLIENT_01_567: [ While xio_send runs the send buffer shall be taken from the uws instance, so that a frame sent from a callback of xio_send gets a buffer of its own; afterwards only one of the two buffers shall be kept. ]*/
+        discard_send_batch(uws_client);
+        uws_client->send_buffer = NULL;
+        uws_client->send_buffer_size = 0;
+        /* Codes_SRS_UWS_CLIENT_01_610: [ When built with XIO_TRACE, the span of the frame, or of the first of the frames sent together, shall be the current span of the thread while xio_send runs. ]*/
+        XIO_TRACE_ENTER(&first_trace_span, previous_trace_span);
+        send_result = xio_send(uws_client->underlying_io, batch, batch_length, on_underlying_io_send_complete, first_batched_send);
+        XIO_TRACE_LEAVE(&first_trace_span, previous_trace_span);
+        if (uws_client->send_buffer == NULL)
         {
-            /* Codes_SRS_UWS_CLIENT_01_473: [ uws_client_close_handshake_async when no open action has been issued shall fail and return a non-zero value. ]*/
-            LogError("uws_client_close_handshake_async has been called when already CLOSED");
-            result = __FAILURE__;
+            uws_client->send_buffer = batch;
+            uws_client->send_buffer_size = batch_buffer_size;
         }
         else
         {
-            (void)close_reason;
-
-            /* Codes_SRS_UWS_CLIENT_01_468: [ on_ws_close_complete and on_ws_close_complete_context shall be saved and the callback on_ws_close_complete shall be triggered when the close is complete. ]*/
-            /* Codes_SRS_UWS_CLIENT_01_469: [ The on_ws_close_complete argument shall be allowed to be NULL, in which case no callback shall be called when the close is complete. ]*/
-            /* Codes_SRS_UWS_CLIENT_01_470: [ on_ws_close_complete_context shall also be allowed to be NULL. ]*/
-            uws_client->on_ws_close_complete = on_ws_close_complete;
-            uws_client->on_ws_close_complete_context = on_ws_close_complete_context;
+            free(batch);
+        }
 
-            uws_client->uws_state = UWS_STATE_CLOSING_WAITING_FOR_CLOSE;
+        if (send_result != 0)
+        {
+            LogError("Could not send the batched frames through the underlying IO");
 
-            /* Codes_SRS_UWS_CLIENT_01_465: [ uws_client_close_handshake_async shall initiate the close handshake by sending a close frame to the peer. ]*/
-            if (send_close_frame(uws_client, close_code) != 0)
+            /* Codes_SRS_UWS_CLIENT_01_575: [ If sending the frames waiting because of send coalescing fails, each of them shall be indicated by calling on_ws_send_frame_complete with WS_SEND_FRAME_ERROR. ]*/
+            if (is_pending_send(uws_client, first_batched_send))
             {
-                /* Codes_SRS_UWS_CLIENT_01_472: [ If xio_send fails, uws_client_close_handshake_async shall fail and return a non-zero value. ]*/
-                LogError("Sending CLOSE frame failed");
-                result = __FAILURE__;
+                complete_send_frames(uws_client, first_batched_send, WS_SEND_FRAME_ERROR);
             }
-            else
-            {
-                LIST_ITEM_HANDLE first_pending_send;
-
-                while ((first_pending_send = singlylinkedlist_get_head_item(uws_client->pending_sends)) != NULL)
-                {
-                    WS_PENDING_SEND* ws_pending_send = (WS_PENDING_SEND*)singlylinkedlist_item_get_value(first_pending_send);
 
-                    complete_send_frame(ws_pending_send, first_pending_send, WS_SEND_FRAME_CANCELLED);
-                }
-
-                /* Codes_SRS_UWS_CLIENT_01_466: [ On success uws_client_close_handshake_async shall return 0. ]*/
-                result = 0;
-            }
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
         }
     }
 
     return result;
 }
 
-static void on_underlying_io_send_complete(void* context, IO_SEND_RESULT send_result)
+/* Sends the next fragment of the messages waiting to be sent as fragments, unless one is being sent.
+   A fragment that completes from within xio_send lets the loop send the next one, instead of recursing. */
+static void send_unsent_fragments(UWS_CLIENT_INSTANCE* uws_client)
 {
-    if (context == NULL)
+    if (!uws_client->sending_fragments)
     {
-        /* Codes_SRS_UWS_CLIENT_01_435: [ When on_underlying_io_send_complete is called with a NULL context, it shall do nothing. ]*/
-        LogError("on_underlying_io_send_complete called with NULL context");
-    }
-    else
-    {
-        LIST_ITEM_HANDLE ws_pending_send_list_item = (LIST_ITEM_HANDLE)context;
-        WS_PENDING_SEND* ws_pending_send = (WS_PENDING_SEND*)singlylinkedlist_item_get_value(ws_pending_send_list_item);
-        if (ws_pending_send != NULL)
-        {
-            UWS_CLIENT_HANDLE uws_client = ws_pending_send->uws_client;
-            WS_SEND_FRAME_RESULT ws_send_frame_result;
+        uws_client->sending_fragments = true;
 
-            switch (send_result)
+        while ((uws_client->uws_state == UWS_STATE_OPEN) &&
+            (uws_client->unsent_first_item != NULL))
+        {
+            WS_PENDING_SEND* ws_pending_send = uws_client->unsent_first_item;
+            WS_UNSENT_MESSAGE* unsent_message = ws_pending_send->unsent_message;
+            size_t fragment_size = unsent_message->payload_size - unsent_message->sent_size;
+            bool is_last_fragment;
+            size_t header_size;
+            int send_result;
+#ifdef XIO_TRACE
+            XIO_TRACE_SPAN trace_span = ws_pending_send->trace_span;
+            XIO_TRACE_SPAN previous_trace_span;
+#endif
+
+            if (unsent_message->fragment_in_flight)
             {
-                /* Codes_SRS_UWS_CLIENT_01_436: [ When on_underlying_io_send_complete is called with any other error code, the send shall be indicated to the uws user by calling on_ws_send_frame_complete with WS_SEND_FRAME_ERROR. ]*/
-            default:
-            case IO_SEND_ERROR:
-                /* Codes_SRS_UWS_CLIENT_01_390: [ When on_underlying_io_send_complete is called with IO_SEND_ERROR as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling on_ws_send_frame_complete with WS_SEND_FRAME_ERROR. ]*/
-                ws_send_frame_result = WS_SEND_FRAME_ERROR;
                 break;
+            }
 
-            case IO_SEND_OK:
-                /* Codes_SRS_UWS_CLIENT_01_389: [ When on_underlying_io_send_complete is called with IO_SEND_OK as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling on_ws_send_frame_complete with WS_SEND_FRAME_OK. ]*/
-                ws_send_frame_result = WS_SEND_FRAME_OK;
-                break;
+            /* what is left of the messages is sent whole once the send fragment size is set back to 0 */
+            if ((uws_client->send_fragment_size > 0) &&
+                (fragment_size > uws_client->send_fragment_size))
+            {
+                fragment_size = uws_client->send_fragment_size;
+            }
+            is_last_fragment = (unsent_message->sent_size + fragment_size == unsent_message->payload_size);
 
-            case IO_SEND_CANCELLED:
-                /* Codes_SRS_UWS_CLIENT_01_391: [ When on_underlying_io_send_complete is called with IO_SEND_CANCELLED as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling on_ws_send_frame_complete with WS_SEND_FRAME_CANCELLED. ]*/
-                ws_send_frame_result = WS_SEND_FRAME_CANCELLED;
-                break;
+            if (ensure_send_buffer_size(uws_client, 0, fragment_size) != 0)
+            {
+                LogError("Cannot allocate memory for the WebSocket fragment");
+                send_result = __FAILURE__;
+            }
+            /* Codes_SRS_UWS_CLIENT_01_588: [ When a send fragment size is set, a data frame with more payload than that, and any data frame sent while messages are waiting to be sent as fragments, shall be copied and sent as fragments of at most that size, only the first one having the opcode and RSV bits of the frame and only the last one having the FIN bit of the frame, and uws_client_send_frame_async shall return 0. ]*/
+            else if (uws_frame_encoder_encode_header((WS_FRAME_TYPE)unsent_message->frame_type, fragment_size, true, is_last_fragment && unsent_message->is_final, unsent_message->reserved, uws_client->send_buffer, &header_size) != 0)
+            {
+                LogError("Failed encoding WebSocket fragment header");
+                send_result = __FAILURE__;
+            }
+            else
+            {
+                unsigned char* fragment = uws_client->send_buffer;
+                size_t fragment_buffer_size = uws_client->send_buffer_size;
+
+                /* the masking key ends the header */
+                uws_frame_encoder_mask(fragment + header_size, (const unsigned char*)(unsent_message + 1) + unsent_message->sent_size, fragment_size, fragment + header_size - 4);
+
+                unsent_message->frame_type = (unsigned char)WS_CONTINUATION_FRAME;
+                unsent_message->reserved = 0;
+                unsent_message->sent_size += fragment_size;
+                unsent_message->fragment_in_flight = true;
+                if (is_last_fragment)
+                {
+                    remove_first_unsent_message(uws_client, unsent_message);
+                }
+
+                /* Codes_SRS_UWS_CLIENT_01_567: [ While xio_send runs the send buffer shall be taken from the uws instance, so that a frame sent from a callback of xio_send gets a buffer of its own; afterwards only one of the two buffers shall be kept. ]*/
+                uws_client->send_buffer = NULL;
+                uws_client->send_buffer_size = 0;
+                /* Codes_SRS_UWS_CLIENT_01_610: [ When built with XIO_TRACE, the span of the frame, or of the first of the frames sent together, shall be the current span of the thread while xio_send runs. ]*/
+                XIO_TRACE_ENTER(&trace_span, previous_trace_span);
+                send_result = xio_send(uws_client->underlying_io, fragment, header_size + fragment_size, on_underlying_io_send_complete, ws_pending_send);
+                XIO_TRACE_LEAVE(&trace_span, previous_trace_span);
+                if (uws_client->send_buffer == NULL)
+                {
+                    uws_client->send_buffer = fragment;
+                    uws_client->send_buffer_size = fragment_buffer_size;
+                }
+                else
+                {
+                    free(fragment);
+                }
             }
 
-            if (complete_send_frame(ws_pending_send, ws_pending_send_list_item, ws_send_frame_result) != 0)
+            if (send_result != 0)
             {
-                /* Codes_SRS_UWS_CLIENT_01_433: [ If singlylinkedlist_remove fails an error shall be indicated by calling the on_ws_error callback with WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST. ]*/
-                indicate_ws_error(uws_client, WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST);
+                LogError("Could not send WebSocket fragment through the underlying IO");
+
+                /* Codes_SRS_UWS_CLIENT_01_592: [ If sending a fragment fails, the message shall be indicated by calling on_ws_send_frame_complete with WS_SEND_FRAME_ERROR. ]*/
+                if (is_pending_send(uws_client, ws_pending_send))
+                {
+                    if (uws_client->unsent_first_item == ws_pending_send)
+                    {
+                        remove_first_unsent_message(uws_client, unsent_message);
+                    }
+
+                    complete_send_frame(ws_pending_send, WS_SEND_FRAME_ERROR);
+                }
             }
         }
-        else
-        {
-            LogError("Failing getting singlylinkedlist_item_get_value on_underlying_io_send_complete");
-        }
-    }
-}
 
-static bool find_list_node(LIST_ITEM_HANDLE list_item, const void* match_context)
-{
-    return list_item == (LIST_ITEM_HANDLE)match_context;
+        uws_client->sending_fragments = false;
+    }
 }
 
 int uws_client_send_frame_async(UWS_CLIENT_HANDLE uws_client, unsigned char frame_type, const unsigned char* buffer, size_t size, bool is_final, ON_WS_SEND_FRAME_COMPLETE on_ws_send_frame_complete, void* on_ws_send_frame_complete_context)
@@ -1940,31 +3372,112 @@ int uws_client_send_frame_async(UWS_CLIENT_HANDLE uws_client, unsigned char fram
         }
         else
         {
-            BUFFER_HANDLE non_control_frame_buffer;
+            unsigned char* encoded_frame = NULL;
+            size_t encoded_frame_length = 0;
+            WS_UNSENT_MESSAGE* unsent_message = NULL;
+            const unsigned char* payload = buffer;
+            size_t payload_size = size;
+            unsigned char reserved = 0;
+#ifdef XIO_STATS_TIMING
+            /* compressing and encoding (masking) the frame is what XIO_STATS::time_us measures for this layer */
+            uint64_t start_time_us = xio_stats_get_time_us();
+#endif
+
+#ifdef USE_WS_PERMESSAGE_DEFLATE
+            bool compression_failed = false;
+
+            if ((uws_client->permessage_deflate_negotiated) &&
+                ((frame_type == WS_FRAME_TYPE_TEXT) || (frame_type == WS_FRAME_TYPE_BINARY) ||
+                ((frame_type == (unsigned char)WS_CONTINUATION_FRAME) && uws_client->sending_compressed_message)))
+            {
+                /* Codes_SRS_UWS_CLIENT_01_547: [ When permessage-deflate was negotiated, the payload of the text and binary messages sent shall be compressed, RSV1 shall be set on the first frame of the message and the trailing 0x00 0x00 0xFF 0xFF shall be removed from the final frame. ]*/
+                if (deflate_message_bytes(uws_client, buffer, size, is_final, &payload_size) != 0)
+                {
+                    compression_failed = true;
+                }
+                else
+                {
+                    payload = uws_client->deflate_buffer;
+                    if (frame_type != (unsigned char)WS_CONTINUATION_FRAME)
+                    {
+                        reserved = WS_RESERVED_RSV1;
+                    }
+                    uws_client->sending_compressed_message = !is_final;
+                }
+            }
 
-            /* Codes_SRS_UWS_CLIENT_01_425: [ Encoding shall be done by calling uws_frame_encoder_encode and passing to it the buffer and size argument for payload, the is_final flag and setting is_masked to true. ]*/
-            /* Codes_SRS_UWS_CLIENT_01_270: [ An endpoint MUST encapsulate the /data/ in a WebSocket frame as defined in Section 5.2. ]*/
-            /* Codes_SRS_UWS_CLIENT_01_272: [ The opcode (frame-opcode) of the first frame containing the data MUST be set to the appropriate value from Section 5.2 for data that is to be interpreted by the recipient as text or binary data. ]*/
-            /* Codes_SRS_UWS_CLIENT_01_274: [ If the data is being sent by the client, the frame(s) MUST be masked as defined in Section 5.3. ]*/
-            non_control_frame_buffer = uws_frame_encoder_encode((WS_FRAME_TYPE)frame_type, buffer, size, true, is_final, 0);
-            if (non_control_frame_buffer == NULL)
+            if (compression_failed)
             {
-                /* Codes_SRS_UWS_CLIENT_01_426: [ If uws_frame_encoder_encode fails, uws_client_send_frame_async shall fail and return a non-zero value. ]*/
-                LogError("Failed encoding WebSocket frame");
-                free(ws_pending_send);
-                result = __FAILURE__;
+                /* Codes_SRS_UWS_CLIENT_01_548: [ If compressing the payload fails, uws_client_send_frame_async shall fail and return a non-zero value. ]*/
+                LogError("Failed compressing WebSocket frame");
+            }
+            else
+#endif
+            if ((frame_type < (unsigned char)WS_CLOSE_FRAME) &&
+                (((uws_client->send_fragment_size > 0) && (payload_size > uws_client->send_fragment_size)) || (uws_client->unsent_first_item != NULL)))
+            {
+                if ((payload_size > ((size_t)-1) - sizeof(WS_UNSENT_MESSAGE)) ||
+                    ((unsent_message = (WS_UNSENT_MESSAGE*)malloc(sizeof(WS_UNSENT_MESSAGE) + payload_size)) == NULL))
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_591: [ If allocating memory for the copy of the frame fails, uws_client_send_frame_async shall fail and return a non-zero value. ]*/
+                    LogError("Cannot allocate memory for the WebSocket frame to be sent as fragments");
+                }
+                else
+                {
+                    unsent_message->frame_type = frame_type;
+                    unsent_message->reserved = reserved;
+                    unsent_message->is_final = is_final;
+                    unsent_message->fragment_in_flight = false;
+                    unsent_message->payload_size = payload_size;
+                    unsent_message->sent_size = 0;
+                    unsent_message->next_unsent_send = NULL;
+                    if (payload_size > 0)
+                    {
+                        (void)memcpy(unsent_message + 1, payload, payload_size);
+                    }
+                }
             }
             else
             {
-                const unsigned char* encoded_frame;
-                size_t encoded_frame_length;
-                LIST_ITEM_HANDLE new_pending_send_list_item;
+                size_t header_size;
+                size_t frame_offset = uws_client->send_batch_length;
+
+                /* Codes_SRS_UWS_CLIENT_01_565: [ The frame shall be laid out in a send buffer that the uws instance keeps for the next frames, grown with realloc when it cannot hold the largest header and the payload. ]*/
+                if (ensure_send_buffer_size(uws_client, frame_offset, payload_size) != 0)
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_566: [ If growing the send buffer fails, uws_client_send_frame_async shall fail and return a non-zero value. ]*/
+                    LogError("Cannot allocate memory for the WebSocket frame");
+                }
+                /* Codes_SRS_UWS_CLIENT_01_425: [ Encoding shall be done by calling uws_frame_encoder_encode_header with the size of the payload, the is_final flag and is_masked set to true, and then masking the payload behind the header with uws_frame_encoder_mask. ]*/
+                /* Codes_SRS_UWS_CLIENT_01_270: [ An endpoint MUST encapsulate the /data/ in a WebSocket frame as defined in Section 5.2. ]*/
+                /* Codes_SRS_UWS_CLIENT_01_272: [ The opcode (frame-opcode) of the first frame containing the data MUST be set to the appropriate value from Section 5.2 for data that is to be interpreted by the recipient as text or binary data. ]*/
+                /* Codes_SRS_UWS_CLIENT_01_274: [ If the data is being sent by the client, the frame(s) MUST be masked as defined in Section 5.3. ]*/
+                else if (uws_frame_encoder_encode_header((WS_FRAME_TYPE)frame_type, payload_size, true, is_final, reserved, uws_client->send_buffer + frame_offset, &header_size) != 0)
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_426: [ If uws_frame_encoder_encode_header fails, uws_client_send_frame_async shall fail and return a non-zero value. ]*/
+                    LogError("Failed encoding WebSocket frame header");
+                }
+                else
+                {
+                    /* the masking key ends the header */
+                    encoded_frame = uws_client->send_buffer + frame_offset;
+                    encoded_frame_length = header_size + payload_size;
+                    uws_frame_encoder_mask(encoded_frame + header_size, payload, payload_size, encoded_frame + header_size - 4);
+                }
+            }
 
-                /* Codes_SRS_UWS_CLIENT_01_428: [ The encoded frame buffer memory shall be obtained by calling BUFFER_u_char on the encode buffer. ]*/
-                encoded_frame = BUFFER_u_char(non_control_frame_buffer);
-                /* Codes_SRS_UWS_CLIENT_01_429: [ The encoded frame size shall be obtained by calling BUFFER_length on the encode buffer. ]*/
-                encoded_frame_length = BUFFER_length(non_control_frame_buffer);
+#ifdef XIO_STATS_TIMING
+            uws_client->stats.time_us += xio_stats_get_time_us() - start_time_us;
+#endif
 
+            if ((encoded_frame == NULL) &&
+                (unsent_message == NULL))
+            {
+                free(ws_pending_send);
+                result = __FAILURE__;
+            }
+            else
+            {
                 /* Codes_SRS_UWS_CLIENT_01_038: [ uws_client_send_frame_async shall create and queue a structure that contains: ]*/
                 /* Codes_SRS_UWS_CLIENT_01_050: [ The argument on_ws_send_frame_complete shall be optional, if NULL is passed by the caller then no send complete callback shall be triggered. ]*/
                 /* Codes_SRS_UWS_CLIENT_01_040: [ - the send complete callback on_ws_send_frame_complete ]*/
@@ -1972,15 +3485,67 @@ int uws_client_send_frame_async(UWS_CLIENT_HANDLE uws_client, unsigned char fram
                 ws_pending_send->on_ws_send_frame_complete = on_ws_send_frame_complete;
                 ws_pending_send->context = on_ws_send_frame_complete_context;
                 ws_pending_send->uws_client = uws_client;
+                ws_pending_send->next_batched_send = NULL;
+                ws_pending_send->unsent_message = unsent_message;
+
+                /* Codes_SRS_UWS_CLIENT_01_608: [ When built with XIO_TRACE, uws_client_send_frame_async shall begin a span for the frame, with the layer name uws_client, the operation send_frame and the size of the payload. ]*/
+                XIO_TRACE_BEGIN(&ws_pending_send->trace_span, "uws_client", "send_frame", size);
+
+                /* Codes_SRS_UWS_CLIENT_01_048: [ Queueing shall be done by inserting the list entry embedded in the pending send at the tail of the pending send list, without allocating. ]*/
+                DList_InsertTailList(&uws_client->pending_sends, &ws_pending_send->link);
 
-                /* Codes_SRS_UWS_CLIENT_01_048: [ Queueing shall be done by calling singlylinkedlist_add. ]*/
-                new_pending_send_list_item = singlylinkedlist_add(uws_client->pending_sends, ws_pending_send);
-                if (new_pending_send_list_item == NULL)
+                if (unsent_message != NULL)
                 {
-                    /* Codes_SRS_UWS_CLIENT_01_049: [ If singlylinkedlist_add fails, uws_client_send_frame_async shall fail and return a non-zero value. ]*/
-                    LogError("Could not allocate memory for pending frames");
-                    free(ws_pending_send);
-                    result = __FAILURE__;
+                    if (uws_client->unsent_last_item == NULL)
+                    {
+                        uws_client->unsent_first_item = ws_pending_send;
+                    }
+                    else
+                    {
+                        uws_client->unsent_last_item->unsent_message->next_unsent_send = ws_pending_send;
+                    }
+                    uws_client->unsent_last_item = ws_pending_send;
+
+                    uws_client->stats.send_count++;
+                    uws_client->stats.queued_send_count++;
+                    uws_client->stats.bytes_sent += size;
+
+                    /* the frames waiting because of send coalescing go first, no frame waits for it while fragments are sent */
+                    (void)send_batched_frames(uws_client);
+
+                    /* Codes_SRS_UWS_CLIENT_01_589: [ The fragments shall be sent one at a time, the next fragment being sent once the previous one of the same message is sent, so that the frames sent in between are not held back by the whole message. ]*/
+                    send_unsent_fragments(uws_client);
+
+                    /* Codes_SRS_UWS_CLIENT_01_042: [ On success, uws_client_send_frame_async shall return 0. ]*/
+                    result = 0;
+                }
+                else if (((uws_client->send_coalescing_size > 0) || (uws_client->send_batch_first_item != NULL)) &&
+                    (uws_client->unsent_first_item == NULL))
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_571: [ When send coalescing is enabled or frames are waiting to be sent, the frame shall be left in the send buffer behind the frames waiting to be sent instead of being sent with xio_send, and uws_client_send_frame_async shall return 0. ]*/
+                    if (uws_client->send_batch_last_item == NULL)
+                    {
+                        uws_client->send_batch_first_item = ws_pending_send;
+                    }
+                    else
+                    {
+                        uws_client->send_batch_last_item->next_batched_send = ws_pending_send;
+                    }
+                    uws_client->send_batch_last_item = ws_pending_send;
+                    uws_client->send_batch_length += encoded_frame_length;
+
+                    uws_client->stats.send_count++;
+                    uws_client->stats.queued_send_count++;
+                    uws_client->stats.bytes_sent += size;
+
+                    /* Codes_SRS_UWS_CLIENT_01_572: [ Once the frames waiting to be sent reach the send coalescing size, they shall be sent with one xio_send. ]*/
+                    if (uws_client->send_batch_length >= uws_client->send_coalescing_size)
+                    {
+                        (void)send_batched_frames(uws_client);
+                    }
+
+                    /* Codes_SRS_UWS_CLIENT_01_042: [ On success, uws_client_send_frame_async shall return 0. ]*/
+                    result = 0;
                 }
                 else
                 {
@@ -1991,16 +3556,42 @@ int uws_client_send_frame_async(UWS_CLIENT_HANDLE uws_client, unsigned char fram
                     /* Codes_SRS_UWS_CLIENT_01_056: [ - the send_complete callback shall be the on_underlying_io_send_complete function. ]*/
                     /* Codes_SRS_UWS_CLIENT_01_057: [ - the send_complete_context argument shall identify the pending send. ]*/
                     /* Codes_SRS_UWS_CLIENT_01_276: [ The frame(s) that have been formed MUST be transmitted over the underlying network connection. ]*/
-                    if (xio_send(uws_client->underlying_io, encoded_frame, encoded_frame_length, on_underlying_io_send_complete, new_pending_send_list_item) != 0)
+                    size_t encoded_frame_buffer_size = uws_client->send_buffer_size;
+                    int send_result;
+#ifdef XIO_TRACE
+                    XIO_TRACE_SPAN trace_span = ws_pending_send->trace_span;
+                    XIO_TRACE_SPAN previous_trace_span;
+#endif
+
+                    /* Codes_SRS_UWS_CLIENT_01_567: [ While xio_send runs the send buffer shall be taken from the uws instance, so that a frame sent from a callback of xio_send gets a buffer of its own; afterwards only one of the two buffers shall be kept. ]*/
+                    uws_client->send_buffer = NULL;
+                    uws_client->send_buffer_size = 0;
+                    /* Codes_SRS_UWS_CLIENT_01_610: [ When built with XIO_TRACE, the span of the frame, or of the first of the frames sent together, shall be the current span of the thread while xio_send runs. ]*/
+                    XIO_TRACE_ENTER(&trace_span, previous_trace_span);
+                    send_result = xio_send(uws_client->underlying_io, encoded_frame, encoded_frame_length, on_underlying_io_send_complete, ws_pending_send);
+                    XIO_TRACE_LEAVE(&trace_span, previous_trace_span);
+                    if (uws_client->send_buffer == NULL)
+                    {
+                        uws_client->send_buffer = encoded_frame;
+                        uws_client->send_buffer_size = encoded_frame_buffer_size;
+                    }
+                    else
+                    {
+                        free(encoded_frame);
+                    }
+
+                    if (send_result != 0)
                     {
                         /* Codes_SRS_UWS_CLIENT_01_058: [ If xio_send fails, uws_client_send_frame_async shall fail and return a non-zero value. ]*/
                         LogError("Could not send bytes through the underlying IO");
 
                         /* Codes_SRS_UWS_CLIENT_09_001: [ If xio_send fails and the message is still queued, it shall be de-queued and destroyed. ] */
-                        if (singlylinkedlist_find(uws_client->pending_sends, find_list_node, new_pending_send_list_item) != NULL)
+                        if (is_pending_send(uws_client, ws_pending_send))
                         {
                             // Guards against double free in case the underlying I/O invoked 'on_underlying_io_send_complete' within xio_send.
-                            (void)singlylinkedlist_remove(uws_client->pending_sends, new_pending_send_list_item);
+                            (void)DList_RemoveEntryList(&ws_pending_send->link);
+                            /* Codes_SRS_UWS_CLIENT_01_611: [ When built with XIO_TRACE, the span of a frame that uws_client_send_frame_async fails shall end with WS_SEND_FRAME_ERROR. ]*/
+                            XIO_TRACE_END(&ws_pending_send->trace_span, "uws_client", "send_frame", (int)WS_SEND_FRAME_ERROR);
                             free(ws_pending_send);
                         }
 
@@ -2008,35 +3599,224 @@ int uws_client_send_frame_async(UWS_CLIENT_HANDLE uws_client, unsigned char fram
                     }
                     else
                     {
+                        uws_client->stats.send_count++;
+                        uws_client->stats.bytes_sent += size;
+
                         /* Codes_SRS_UWS_CLIENT_01_042: [ On success, uws_client_send_frame_async shall return 0. ]*/
                         result = 0;
                     }
                 }
+            }
+        }
+    }
+
+    return result;
+}
+
+void uws_client_dowork(UWS_CLIENT_HANDLE uws_client)
+{
+    if (uws_client == NULL)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_059: [ If the uws_client argument is NULL, uws_client_dowork shall do nothing. ]*/
+        LogError("NULL uws handle.");
+    }
+    else
+    {
+        /* Codes_SRS_UWS_CLIENT_01_060: [ If the IO is not yet open, uws_client_dowork shall do nothing. ]*/
+        if (uws_client->uws_state != UWS_STATE_CLOSED)
+        {
+            uint64_t callback_count = uws_client->stats.callback_count;
+
+            uws_client->stats.dowork_count++;
+
+            /* Codes_SRS_UWS_CLIENT_01_573: [ uws_client_dowork shall send the frames waiting because of send coalescing with one xio_send before calling xio_dowork. ]*/
+            (void)send_batched_frames(uws_client);
+
+            /* Codes_SRS_UWS_CLIENT_01_430: [ uws_client_dowork shall call xio_dowork with the IO handle argument set to the underlying IO created in uws_client_create. ]*/
+            xio_dowork(uws_client->underlying_io);
+
+            /* Codes_SRS_UWS_CLIENT_01_622: [ When keepalive was enabled, uws_client_dowork shall call timer_wheel_dowork after xio_dowork. ]*/
+            if (uws_client->keepalive_timer_wheel != NULL)
+            {
+                timer_wheel_dowork(uws_client->keepalive_timer_wheel);
+            }
+
+            if (uws_client->stats.callback_count == callback_count)
+            {
+                uws_client->stats.idle_dowork_count++;
+            }
+        }
+    }
+}
+
+int uws_client_dowork_ex(UWS_CLIENT_HANDLE uws_client, bool* made_progress, uint64_t* next_deadline_us)
+{
+    int result;
+
+    if ((uws_client == NULL) ||
+        (made_progress == NULL) ||
+        (next_deadline_us == NULL))
+    {
+        /* Codes_SRS_UWS_CLIENT_01_597: [ If uws_client, made_progress or next_deadline_us is NULL, uws_client_dowork_ex shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: uws_client=%p, made_progress=%p, next_deadline_us=%p", uws_client, made_progress, next_deadline_us);
+        result = __FAILURE__;
+    }
+    else
+    {
+        if (uws_client->uws_state == UWS_STATE_CLOSED)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_598: [ If the IO is not yet open, uws_client_dowork_ex shall set made_progress to false, set next_deadline_us to XIO_NO_DEADLINE and return 0. ]*/
+            *made_progress = false;
+            *next_deadline_us = XIO_NO_DEADLINE;
+        }
+        else
+        {
+            uint64_t callback_count = uws_client->stats.callback_count;
+            bool sent_batch = (uws_client->send_batch_first_item != NULL);
+            bool underlying_progress;
+
+            uws_client->stats.dowork_count++;
+
+            /* Codes_SRS_UWS_CLIENT_01_599: [ Otherwise uws_client_dowork_ex shall send the frames waiting because of send coalescing and call xio_dowork_ex on the underlying IO, passing next_deadline_us down to it. ]*/
+            (void)send_batched_frames(uws_client);
+
+            if (xio_dowork_ex(uws_client->underlying_io, &underlying_progress, next_deadline_us) != 0)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_601: [ If xio_dowork_ex fails, made_progress shall be set to true and next_deadline_us to XIO_NO_DEADLINE. ]*/
+                LogError("xio_dowork_ex failed");
+                underlying_progress = true;
+                *next_deadline_us = XIO_NO_DEADLINE;
+            }
+
+            /* Codes_SRS_UWS_CLIENT_01_623: [ When keepalive was enabled, uws_client_dowork_ex shall call timer_wheel_dowork after xio_dowork_ex and, while the uws instance is OPEN, lower next_deadline_us to the time the keepalive timer expires. ]*/
+            if (uws_client->keepalive_timer_wheel != NULL)
+            {
+                timer_wheel_dowork(uws_client->keepalive_timer_wheel);
+
+                if ((uws_client->uws_state == UWS_STATE_OPEN) &&
+                    (uws_client->keepalive_deadline_us < *next_deadline_us))
+                {
+                    *next_deadline_us = uws_client->keepalive_deadline_us;
+                }
+            }
 
-                BUFFER_delete(non_control_frame_buffer);
+            if (uws_client->stats.callback_count == callback_count)
+            {
+                uws_client->stats.idle_dowork_count++;
             }
+
+            /* Codes_SRS_UWS_CLIENT_01_600: [ made_progress shall be set to true if frames waiting because of send coalescing were sent, a callback was made or the underlying IO made progress, false otherwise. ]*/
+            *made_progress = sent_batch || underlying_progress || (uws_client->stats.callback_count != callback_count);
+        }
+
+        /* Codes_SRS_UWS_CLIENT_01_602: [ On success uws_client_dowork_ex shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+int uws_client_get_stats(UWS_CLIENT_HANDLE uws_client, XIO_STATS* stats, size_t stats_count, size_t* layer_count)
+{
+    int result;
+
+    if ((uws_client == NULL) ||
+        (stats == NULL) ||
+        (stats_count == 0) ||
+        (layer_count == NULL))
+    {
+        /* Codes_SRS_UWS_CLIENT_01_560: [ If uws_client, stats or layer_count is NULL or stats_count is 0, uws_client_get_stats shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: uws_client=%p, stats=%p, stats_count=%u, layer_count=%p.", uws_client, stats, (unsigned int)stats_count, layer_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        PDLIST_ENTRY pending_send_entry;
+        size_t underlying_layer_count;
+
+        /* Codes_SRS_UWS_CLIENT_01_561: [ uws_client_get_stats shall fill the first entry of stats with the counters of the uws instance and the number of frames waiting for their send to complete. ]*/
+        stats[0] = uws_client->stats;
+        stats[0].pending_send_count = 0;
+        for (pending_send_entry = uws_client->pending_sends.Flink; pending_send_entry != &uws_client->pending_sends; pending_send_entry = pending_send_entry->Flink)
+        {
+            stats[0].pending_send_count++;
+        }
+
+        /* Codes_SRS_UWS_CLIENT_01_562: [ If stats_count is greater than 1, uws_client_get_stats shall fill the following entries by calling xio_get_stats on the underlying IO. ]*/
+        if ((stats_count > 1) &&
+            (xio_get_stats(uws_client->underlying_io, &stats[1], stats_count - 1, &underlying_layer_count) == 0))
+        {
+            *layer_count = 1 + underlying_layer_count;
+        }
+        else
+        {
+            /* Codes_SRS_UWS_CLIENT_01_563: [ If xio_get_stats fails, only the counters of the uws instance shall be given. ]*/
+            *layer_count = 1;
         }
+
+        /* Codes_SRS_UWS_CLIENT_01_564: [ On success uws_client_get_stats shall set layer_count to the number of entries filled and return 0. ]*/
+        result = 0;
     }
 
     return result;
 }
 
-void uws_client_dowork(UWS_CLIENT_HANDLE uws_client)
+int uws_client_get_pollable_handle(UWS_CLIENT_HANDLE uws_client, intptr_t* pollable_handle, unsigned int* wanted_events)
 {
-    if (uws_client == NULL)
+    int result;
+
+    if ((uws_client == NULL) ||
+        (pollable_handle == NULL) ||
+        (wanted_events == NULL))
     {
-        /* Codes_SRS_UWS_CLIENT_01_059: [ If the uws_client argument is NULL, uws_client_dowork shall do nothing. ]*/
-        LogError("NULL uws handle.");
+        /* Codes_SRS_UWS_CLIENT_01_603: [ If uws_client, pollable_handle or wanted_events is NULL, uws_client_get_pollable_handle shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: uws_client=%p, pollable_handle=%p, wanted_events=%p", uws_client, pollable_handle, wanted_events);
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_UWS_CLIENT_01_604: [ uws_client_get_pollable_handle shall call xio_get_pollable_handle on the underlying IO, passing pollable_handle and wanted_events down to it. ]*/
+    else if (xio_get_pollable_handle(uws_client->underlying_io, pollable_handle, wanted_events) != 0)
+    {
+        /* Codes_SRS_UWS_CLIENT_01_605: [ If xio_get_pollable_handle fails, uws_client_get_pollable_handle shall fail and return a non-zero value. ]*/
+        LogError("xio_get_pollable_handle failed");
+        result = __FAILURE__;
     }
     else
     {
-        /* Codes_SRS_UWS_CLIENT_01_060: [ If the IO is not yet open, uws_client_dowork shall do nothing. ]*/
-        if (uws_client->uws_state != UWS_STATE_CLOSED)
+        /* Codes_SRS_UWS_CLIENT_01_606: [ On success uws_client_get_pollable_handle shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+static int create_keepalive_timer(UWS_CLIENT_INSTANCE* uws_client)
+{
+    int result;
+
+    uws_client->keepalive_timer_wheel = timer_wheel_create();
+    if (uws_client->keepalive_timer_wheel == NULL)
+    {
+        LogError("timer_wheel_create failed");
+        result = __FAILURE__;
+    }
+    else
+    {
+        uws_client->keepalive_timer = timer_wheel_create_timer(uws_client->keepalive_timer_wheel, on_keepalive_timer_expired, uws_client);
+        if (uws_client->keepalive_timer == NULL)
         {
-            /* Codes_SRS_UWS_CLIENT_01_430: [ uws_client_dowork shall call xio_dowork with the IO handle argument set to the underlying IO created in uws_client_create. ]*/
-            xio_dowork(uws_client->underlying_io);
+            LogError("timer_wheel_create_timer failed");
+            timer_wheel_destroy(uws_client->keepalive_timer_wheel);
+            uws_client->keepalive_timer_wheel = NULL;
+            result = __FAILURE__;
+        }
+        else
+        {
+            uws_client->keepalive_deadline_us = XIO_NO_DEADLINE;
+            result = 0;
         }
     }
+
+    return result;
 }
 
 int uws_client_set_option(UWS_CLIENT_HANDLE uws_client, const char* option_name, const void* value)
@@ -2069,6 +3849,180 @@ int uws_client_set_option(UWS_CLIENT_HANDLE uws_client, const char* option_name,
                 result = 0;
             }
         }
+        else if (strcmp(OPTION_WS_FRAGMENT_STREAMING, option_name) == 0)
+        {
+            const WS_FRAGMENT_STREAMING* fragment_streaming = (const WS_FRAGMENT_STREAMING*)value;
+
+            if (fragment_streaming == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_538: [ If the option name is ws_fragment_streaming and value is NULL, uws_client_set_option shall fail and return a non-zero value. ]*/
+                LogError("NULL value for option %s", option_name);
+                result = __FAILURE__;
+            }
+            else if (uws_client->fragmented_frame_type != WS_FRAME_TYPE_UNKNOWN)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_539: [ If a fragmented message is being received, setting ws_fragment_streaming shall fail and return a non-zero value. ]*/
+                LogError("Cannot change fragment streaming while a fragmented message is being received");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_01_533: [ If the option name is ws_fragment_streaming, uws_client_set_option shall store the on_ws_fragment_received callback and its context from the WS_FRAGMENT_STREAMING structure pointed to by value. ]*/
+                /* Codes_SRS_UWS_CLIENT_01_534: [ Setting a NULL on_ws_fragment_received shall disable fragment streaming, fragmented messages being accumulated and indicated with on_ws_frame_received. ]*/
+                uws_client->on_ws_fragment_received = fragment_streaming->on_ws_fragment_received;
+                uws_client->on_ws_fragment_received_context = fragment_streaming->on_ws_fragment_received_context;
+
+                /* Codes_SRS_UWS_CLIENT_01_442: [ On success, uws_client_set_option shall return 0. ]*/
+                result = 0;
+            }
+        }
+        else if (strcmp(OPTION_WS_SEND_COALESCING, option_name) == 0)
+        {
+            if (value == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_570: [ If the option name is ws_send_coalescing and value is NULL, uws_client_set_option shall fail and return a non-zero value. ]*/
+                LogError("NULL value for option %s", option_name);
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_01_569: [ If the option name is ws_send_coalescing, uws_client_set_option shall store the size_t pointed to by value as the number of bytes of frames that can wait to be sent together, 0 disabling send coalescing. ]*/
+                uws_client->send_coalescing_size = *(const size_t*)value;
+
+                /* Codes_SRS_UWS_CLIENT_01_442: [ On success, uws_client_set_option shall return 0. ]*/
+                result = 0;
+            }
+        }
+        else if (strcmp(OPTION_WS_SEND_FRAGMENT_SIZE, option_name) == 0)
+        {
+            if (value == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_587: [ If the option name is ws_send_fragment_size and value is NULL, uws_client_set_option shall fail and return a non-zero value. ]*/
+                LogError("NULL value for option %s", option_name);
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_01_586: [ If the option name is ws_send_fragment_size, uws_client_set_option shall store the size_t pointed to by value as the largest payload of the data frames sent, 0 sending each data frame whole. ]*/
+                uws_client->send_fragment_size = *(const size_t*)value;
+
+                /* Codes_SRS_UWS_CLIENT_01_442: [ On success, uws_client_set_option shall return 0. ]*/
+                result = 0;
+            }
+        }
+        else if (strcmp(OPTION_WS_KEEPALIVE, option_name) == 0)
+        {
+            const WS_KEEPALIVE_OPTIONS* keepalive_options = (const WS_KEEPALIVE_OPTIONS*)value;
+
+            if ((keepalive_options == NULL) ||
+                ((keepalive_options->ping_interval_ms > 0) && (keepalive_options->pong_timeout_ms == 0)))
+            {
+                /* Codes_SRS_UWS_CLIENT_01_612: [ If the option name is ws_keepalive and value is NULL or has a ping interval with a pong timeout of 0, uws_client_set_option shall fail and return a non-zero value. ]*/
+                LogError("Invalid value for option %s", option_name);
+                result = __FAILURE__;
+            }
+            else if ((keepalive_options->ping_interval_ms > 0) &&
+                (uws_client->keepalive_timer == NULL) &&
+                (create_keepalive_timer(uws_client) != 0))
+            {
+                /* Codes_SRS_UWS_CLIENT_01_614: [ If timer_wheel_create or timer_wheel_create_timer fails, uws_client_set_option shall fail and return a non-zero value. ]*/
+                LogError("Cannot create the keepalive timer");
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_01_613: [ If the option name is ws_keepalive, uws_client_set_option shall store a copy of the WS_KEEPALIVE_OPTIONS pointed to by value, creating a timer wheel with timer_wheel_create and its keepalive timer with timer_wheel_create_timer the first time a ping interval is set. ]*/
+                uws_client->keepalive_options = *keepalive_options;
+
+                /* Codes_SRS_UWS_CLIENT_01_615: [ If the uws instance is OPEN, setting ws_keepalive shall start the keepalive timer with the new ping interval, or cancel it with timer_wheel_cancel_timer when the ping interval is 0. ]*/
+                if (keepalive_options->ping_interval_ms == 0)
+                {
+                    if (uws_client->keepalive_timer != NULL)
+                    {
+                        timer_wheel_cancel_timer(uws_client->keepalive_timer);
+                        uws_client->keepalive_deadline_us = XIO_NO_DEADLINE;
+                    }
+                }
+                else if (uws_client->uws_state == UWS_STATE_OPEN)
+                {
+                    start_keepalive(uws_client);
+                }
+
+                /* Codes_SRS_UWS_CLIENT_01_442: [ On success, uws_client_set_option shall return 0. ]*/
+                result = 0;
+            }
+        }
+        else if (strcmp(OPTION_WS_RECEIVE_BUFFER_SIZE, option_name) == 0)
+        {
+            if (value == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_629: [ If the option name is ws_receive_buffer_size and value is NULL, uws_client_set_option shall fail and return a non-zero value. ]*/
+                LogError("NULL value for option %s", option_name);
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_01_628: [ If the option name is ws_receive_buffer_size, uws_client_set_option shall store the size_t pointed to by value as the size of the memory lent to the underlying IO for receiving, 0 copying the received bytes. ]*/
+                uws_client->receive_buffer_size = *(const size_t*)value;
+
+                /* Codes_SRS_UWS_CLIENT_01_442: [ On success, uws_client_set_option shall return 0. ]*/
+                result = 0;
+            }
+        }
+        else if (strcmp(OPTION_WS_RECEIVE_LIMITS, option_name) == 0)
+        {
+            if (value == NULL)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_643: [ If the option name is ws_receive_limits and value is NULL, uws_client_set_option shall fail and return a non-zero value. ]*/
+                LogError("NULL value for option %s", option_name);
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_01_644: [ If the option name is ws_receive_limits, uws_client_set_option shall store a copy of the WS_RECEIVE_LIMITS pointed to by value, to be applied to the frames received from then on. ]*/
+                uws_client->receive_limits = *(const WS_RECEIVE_LIMITS*)value;
+
+                /* Codes_SRS_UWS_CLIENT_01_442: [ On success, uws_client_set_option shall return 0. ]*/
+                result = 0;
+            }
+        }
+        else if (strcmp(OPTION_WS_PERMESSAGE_DEFLATE, option_name) == 0)
+        {
+#ifdef USE_WS_PERMESSAGE_DEFLATE
+            const WS_PERMESSAGE_DEFLATE_OPTIONS* permessage_deflate_options = (const WS_PERMESSAGE_DEFLATE_OPTIONS*)value;
+
+            if ((permessage_deflate_options == NULL) ||
+                (!is_valid_permessage_deflate_options(permessage_deflate_options)))
+            {
+                /* Codes_SRS_UWS_CLIENT_01_553: [ If the option name is ws_permessage_deflate and value is NULL or holds window bits, a compression level or a mem_level out of range, uws_client_set_option shall fail and return a non-zero value. ]*/
+                LogError("Invalid value for option %s", option_name);
+                result = __FAILURE__;
+            }
+            else if (uws_client->uws_state != UWS_STATE_CLOSED)
+            {
+                /* Codes_SRS_UWS_CLIENT_01_558: [ If the uws instance is not CLOSED, setting ws_permessage_deflate shall fail and return a non-zero value. ]*/
+                LogError("Option %s can only be set before opening", option_name);
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_UWS_CLIENT_01_559: [ If the option name is ws_permessage_deflate, uws_client_set_option shall store a copy of the WS_PERMESSAGE_DEFLATE_OPTIONS pointed to by value, to be used for the following opens. ]*/
+                uws_client->permessage_deflate_options = *permessage_deflate_options;
+                uws_client->permessage_deflate_requested = true;
+
+                /* Codes_SRS_UWS_CLIENT_01_585: [ Setting ws_permessage_deflate shall discard the kept upgrade request, so that the next open sends the new offer. ]*/
+                discard_upgrade_request(uws_client);
+
+                /* Codes_SRS_UWS_CLIENT_01_442: [ On success, uws_client_set_option shall return 0. ]*/
+                result = 0;
+            }
+#else
+            /* Codes_SRS_UWS_CLIENT_01_554: [ If the library was built without permessage-deflate support, setting ws_permessage_deflate shall fail and return a non-zero value. ]*/
+            (void)value;
+            LogError("Option %s is not supported, build with use_ws_permessage_deflate", option_name);
+            result = __FAILURE__;
+#endif
+        }
         else
         {
             /* Codes_SRS_UWS_CLIENT_01_441: [ Otherwise all options shall be passed as they are to the underlying IO by calling xio_setoption. ]*/
@@ -2109,6 +4063,111 @@ static void* uws_client_clone_option(const char* name, const void* value)
             /* Codes_SRS_UWS_CLIENT_01_507: [ uws_client_clone_option called with name being uWSClientOptions shall return the same value. ]*/
             result = (void*)value;
         }
+        else if (strcmp(name, OPTION_WS_FRAGMENT_STREAMING) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_540: [ uws_client_clone_option called with name being ws_fragment_streaming shall return a newly allocated copy of the WS_FRAGMENT_STREAMING value. ]*/
+            WS_FRAGMENT_STREAMING* fragment_streaming = (WS_FRAGMENT_STREAMING*)malloc(sizeof(WS_FRAGMENT_STREAMING));
+            if (fragment_streaming == NULL)
+            {
+                LogError("Cannot allocate memory for the cloned %s option", name);
+            }
+            else
+            {
+                *fragment_streaming = *(const WS_FRAGMENT_STREAMING*)value;
+            }
+
+            result = fragment_streaming;
+        }
+        else if (strcmp(name, OPTION_WS_SEND_COALESCING) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_578: [ uws_client_clone_option called with name being ws_send_coalescing shall return a newly allocated copy of the size_t value. ]*/
+            size_t* send_coalescing_size = (size_t*)malloc(sizeof(size_t));
+            if (send_coalescing_size == NULL)
+            {
+                LogError("Cannot allocate memory for the cloned %s option", name);
+            }
+            else
+            {
+                *send_coalescing_size = *(const size_t*)value;
+            }
+
+            result = send_coalescing_size;
+        }
+        else if (strcmp(name, OPTION_WS_SEND_FRAGMENT_SIZE) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_594: [ uws_client_clone_option called with name being ws_send_fragment_size shall return a newly allocated copy of the size_t value. ]*/
+            size_t* send_fragment_size = (size_t*)malloc(sizeof(size_t));
+            if (send_fragment_size == NULL)
+            {
+                LogError("Cannot allocate memory for the cloned %s option", name);
+            }
+            else
+            {
+                *send_fragment_size = *(const size_t*)value;
+            }
+
+            result = send_fragment_size;
+        }
+        else if (strcmp(name, OPTION_WS_KEEPALIVE) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_624: [ uws_client_clone_option called with name being ws_keepalive shall return a newly allocated copy of the WS_KEEPALIVE_OPTIONS value. ]*/
+            WS_KEEPALIVE_OPTIONS* keepalive_options = (WS_KEEPALIVE_OPTIONS*)malloc(sizeof(WS_KEEPALIVE_OPTIONS));
+            if (keepalive_options == NULL)
+            {
+                LogError("Cannot allocate memory for the cloned %s option", name);
+            }
+            else
+            {
+                *keepalive_options = *(const WS_KEEPALIVE_OPTIONS*)value;
+            }
+
+            result = keepalive_options;
+        }
+        else if (strcmp(name, OPTION_WS_RECEIVE_BUFFER_SIZE) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_631: [ uws_client_clone_option called with name being ws_receive_buffer_size shall return a newly allocated copy of the size_t value. ]*/
+            size_t* receive_buffer_size = (size_t*)malloc(sizeof(size_t));
+            if (receive_buffer_size == NULL)
+            {
+                LogError("Cannot allocate memory for the cloned %s option", name);
+            }
+            else
+            {
+                *receive_buffer_size = *(const size_t*)value;
+            }
+
+            result = receive_buffer_size;
+        }
+        else if (strcmp(name, OPTION_WS_RECEIVE_LIMITS) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_645: [ uws_client_clone_option called with name being ws_receive_limits shall return a newly allocated copy of the WS_RECEIVE_LIMITS value. ]*/
+            WS_RECEIVE_LIMITS* receive_limits = (WS_RECEIVE_LIMITS*)malloc(sizeof(WS_RECEIVE_LIMITS));
+            if (receive_limits == NULL)
+            {
+                LogError("Cannot allocate memory for the cloned %s option", name);
+            }
+            else
+            {
+                *receive_limits = *(const WS_RECEIVE_LIMITS*)value;
+            }
+
+            result = receive_limits;
+        }
+        else if (strcmp(name, OPTION_WS_PERMESSAGE_DEFLATE) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_555: [ uws_client_clone_option called with name being ws_permessage_deflate shall return a newly allocated copy of the WS_PERMESSAGE_DEFLATE_OPTIONS value. ]*/
+            WS_PERMESSAGE_DEFLATE_OPTIONS* permessage_deflate_options = (WS_PERMESSAGE_DEFLATE_OPTIONS*)malloc(sizeof(WS_PERMESSAGE_DEFLATE_OPTIONS));
+            if (permessage_deflate_options == NULL)
+            {
+                LogError("Cannot allocate memory for the cloned %s option", name);
+            }
+            else
+            {
+                *permessage_deflate_options = *(const WS_PERMESSAGE_DEFLATE_OPTIONS*)value;
+            }
+
+            result = permessage_deflate_options;
+        }
         else
         {
             /* Codes_SRS_UWS_CLIENT_01_512: [ uws_client_clone_option called with any other option name than uWSClientOptions shall return NULL. ]*/
@@ -2137,6 +4196,41 @@ static void uws_client_destroy_option(const char* name, const void* value)
             /* Codes_SRS_UWS_CLIENT_01_508: [ uws_client_destroy_option called with the option name being uWSClientOptions shall destroy the value by calling OptionHandler_Destroy. ]*/
             OptionHandler_Destroy((OPTIONHANDLER_HANDLE)value);
         }
+        else if (strcmp(name, OPTION_WS_FRAGMENT_STREAMING) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_541: [ uws_client_destroy_option called with the option name being ws_fragment_streaming shall free the value. ]*/
+            free((void*)value);
+        }
+        else if (strcmp(name, OPTION_WS_SEND_COALESCING) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_579: [ uws_client_destroy_option called with the option name being ws_send_coalescing shall free the value. ]*/
+            free((void*)value);
+        }
+        else if (strcmp(name, OPTION_WS_SEND_FRAGMENT_SIZE) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_595: [ uws_client_destroy_option called with the option name being ws_send_fragment_size shall free the value. ]*/
+            free((void*)value);
+        }
+        else if (strcmp(name, OPTION_WS_KEEPALIVE) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_625: [ uws_client_destroy_option called with the option name being ws_keepalive shall free the value. ]*/
+            free((void*)value);
+        }
+        else if (strcmp(name, OPTION_WS_RECEIVE_BUFFER_SIZE) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_632: [ uws_client_destroy_option called with the option name being ws_receive_buffer_size shall free the value. ]*/
+            free((void*)value);
+        }
+        else if (strcmp(name, OPTION_WS_RECEIVE_LIMITS) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_646: [ uws_client_destroy_option called with the option name being ws_receive_limits shall free the value. ]*/
+            free((void*)value);
+        }
+        else if (strcmp(name, OPTION_WS_PERMESSAGE_DEFLATE) == 0)
+        {
+            /* Codes_SRS_UWS_CLIENT_01_556: [ uws_client_destroy_option called with the option name being ws_permessage_deflate shall free the value. ]*/
+            free((void*)value);
+        }
         else
         {
             /* Codes_SRS_UWS_CLIENT_01_513: [ If uws_client_destroy_option is called with any other name it shall do nothing. ]*/
@@ -2187,6 +4281,91 @@ OPTIONHANDLER_HANDLE uws_client_retrieve_options(UWS_CLIENT_HANDLE uws_client)
                     OptionHandler_Destroy(result);
                     result = NULL;
                 }
+                else if (uws_client->on_ws_fragment_received != NULL)
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_542: [ If fragment streaming is enabled, uws_client_retrieve_options shall also add the ws_fragment_streaming option. ]*/
+                    WS_FRAGMENT_STREAMING fragment_streaming;
+                    fragment_streaming.on_ws_fragment_received = uws_client->on_ws_fragment_received;
+                    fragment_streaming.on_ws_fragment_received_context = uws_client->on_ws_fragment_received_context;
+
+                    if (OptionHandler_AddOption(result, OPTION_WS_FRAGMENT_STREAMING, &fragment_streaming) != OPTIONHANDLER_OK)
+                    {
+                        /* Codes_SRS_UWS_CLIENT_01_505: [ If OptionHandler_AddOption fails, uws_client_retrieve_options shall fail and return NULL. ]*/
+                        LogError("OptionHandler_AddOption failed");
+                        OptionHandler_Destroy(result);
+                        result = NULL;
+                    }
+                }
+
+                /* Codes_SRS_UWS_CLIENT_01_580: [ If send coalescing is enabled, uws_client_retrieve_options shall also add the ws_send_coalescing option. ]*/
+                if ((result != NULL) &&
+                    (uws_client->send_coalescing_size > 0) &&
+                    (OptionHandler_AddOption(result, OPTION_WS_SEND_COALESCING, &uws_client->send_coalescing_size) != OPTIONHANDLER_OK))
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_505: [ If OptionHandler_AddOption fails, uws_client_retrieve_options shall fail and return NULL. ]*/
+                    LogError("OptionHandler_AddOption failed");
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                }
+
+                /* Codes_SRS_UWS_CLIENT_01_596: [ If a send fragment size is set, uws_client_retrieve_options shall also add the ws_send_fragment_size option. ]*/
+                if ((result != NULL) &&
+                    (uws_client->send_fragment_size > 0) &&
+                    (OptionHandler_AddOption(result, OPTION_WS_SEND_FRAGMENT_SIZE, &uws_client->send_fragment_size) != OPTIONHANDLER_OK))
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_505: [ If OptionHandler_AddOption fails, uws_client_retrieve_options shall fail and return NULL. ]*/
+                    LogError("OptionHandler_AddOption failed");
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                }
+
+                /* Codes_SRS_UWS_CLIENT_01_627: [ If keepalive is enabled, uws_client_retrieve_options shall also add the ws_keepalive option. ]*/
+                if ((result != NULL) &&
+                    (uws_client->keepalive_options.ping_interval_ms > 0) &&
+                    (OptionHandler_AddOption(result, OPTION_WS_KEEPALIVE, &uws_client->keepalive_options) != OPTIONHANDLER_OK))
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_505: [ If OptionHandler_AddOption fails, uws_client_retrieve_options shall fail and return NULL. ]*/
+                    LogError("OptionHandler_AddOption failed");
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                }
+
+                /* Codes_SRS_UWS_CLIENT_01_630: [ If a receive buffer size is set, uws_client_retrieve_options shall also add the ws_receive_buffer_size option. ]*/
+                if ((result != NULL) &&
+                    (uws_client->receive_buffer_size > 0) &&
+                    (OptionHandler_AddOption(result, OPTION_WS_RECEIVE_BUFFER_SIZE, &uws_client->receive_buffer_size) != OPTIONHANDLER_OK))
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_505: [ If OptionHandler_AddOption fails, uws_client_retrieve_options shall fail and return NULL. ]*/
+                    LogError("OptionHandler_AddOption failed");
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                }
+
+                /* Codes_SRS_UWS_CLIENT_01_647: [ If any receive limit is set, uws_client_retrieve_options shall also add the ws_receive_limits option. ]*/
+                if ((result != NULL) &&
+                    ((uws_client->receive_limits.max_frame_size > 0) ||
+                     (uws_client->receive_limits.max_message_size > 0) ||
+                     (uws_client->receive_limits.receive_memory_budget > 0)) &&
+                    (OptionHandler_AddOption(result, OPTION_WS_RECEIVE_LIMITS, &uws_client->receive_limits) != OPTIONHANDLER_OK))
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_505: [ If OptionHandler_AddOption fails, uws_client_retrieve_options shall fail and return NULL. ]*/
+                    LogError("OptionHandler_AddOption failed");
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                }
+
+#ifdef USE_WS_PERMESSAGE_DEFLATE
+                /* Codes_SRS_UWS_CLIENT_01_557: [ If the ws_permessage_deflate option was set, uws_client_retrieve_options shall also add the ws_permessage_deflate option. ]*/
+                if ((result != NULL) &&
+                    (uws_client->permessage_deflate_requested) &&
+                    (OptionHandler_AddOption(result, OPTION_WS_PERMESSAGE_DEFLATE, &uws_client->permessage_deflate_options) != OPTIONHANDLER_OK))
+                {
+                    /* Codes_SRS_UWS_CLIENT_01_505: [ If OptionHandler_AddOption fails, uws_client_retrieve_options shall fail and return NULL. ]*/
+                    LogError("OptionHandler_AddOption failed");
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                }
+#endif
             }
         }
 
@@ -2214,6 +4393,9 @@ int uws_client_set_request_header(UWS_CLIENT_HANDLE uws_client, const char* name
     }
     else
     {
+        // Codes_SRS_UWS_CLIENT_01_583: [ On success the kept upgrade request shall be discarded, so that the next open sends the new header. ]
+        discard_upgrade_request(uws_client);
+
         // Codes_SRS_UWS_CLIENT_09_005: [ If no failures occur the function shall return zero. ]
         result = 0;
     }
@@ -0,0 +1,299 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/uws_frame_decoder.h"
+#include "azure_c_shared_utility/uws_frame_encoder.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+/* masked payload is unmasked in pieces of this size, so that decoding never allocates */
+#define UNMASK_BUFFER_SIZE 4096
+
+typedef enum UWS_FRAME_DECODER_STATE_TAG
+{
+    UWS_FRAME_DECODER_STATE_HEADER,
+    UWS_FRAME_DECODER_STATE_PAYLOAD,
+    UWS_FRAME_DECODER_STATE_ERROR
+} UWS_FRAME_DECODER_STATE;
+
+typedef struct UWS_FRAME_DECODER_INSTANCE_TAG
+{
+    ON_WS_FRAME_DECODED on_frame_decoded;
+    void* on_frame_decoded_context;
+    UWS_FRAME_DECODER_STATE state;
+    unsigned char header_bytes[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    size_t header_count;
+    WS_FRAME_HEADER header;
+    unsigned char masking_key[4];
+    uint64_t payload_offset;
+    unsigned char unmask_buffer[UNMASK_BUFFER_SIZE];
+} UWS_FRAME_DECODER_INSTANCE;
+
+/* the size of the header that starts with the 2 bytes at header_bytes */
+static size_t get_header_size(const unsigned char* header_bytes)
+{
+    size_t result = 2;
+    unsigned char length = header_bytes[1] & 0x7F;
+
+    if (length == 127)
+    {
+        result += 8;
+    }
+    else if (length == 126)
+    {
+        result += 2;
+    }
+
+    if ((header_bytes[1] & 0x80) != 0)
+    {
+        result += 4;
+    }
+
+    return result;
+}
+
+static int parse_header(UWS_FRAME_DECODER_INSTANCE* uws_frame_decoder)
+{
+    int result;
+    const unsigned char* header_bytes = uws_frame_decoder->header_bytes;
+    unsigned char length = header_bytes[1] & 0x7F;
+    size_t position = 2;
+
+    /* Codes_SRS_UWS_FRAME_DECODER_01_008: [ Once all the bytes of a header are available, uws_frame_decoder_decode shall decode from them the FIN bit, the RSV bits, the opcode, the MASK bit, the payload length and the masking key as RFC6455 section 5.2 describes. ]*/
+    uws_frame_decoder->header.is_final = (header_bytes[0] & 0x80) != 0;
+    uws_frame_decoder->header.reserved = (header_bytes[0] >> 4) & 0x07;
+    uws_frame_decoder->header.opcode = (WS_FRAME_TYPE)(header_bytes[0] & 0x0F);
+    uws_frame_decoder->header.is_masked = (header_bytes[1] & 0x80) != 0;
+
+    if (length == 127)
+    {
+        uws_frame_decoder->header.payload_length = ((uint64_t)header_bytes[2] << 56) |
+            ((uint64_t)header_bytes[3] << 48) |
+            ((uint64_t)header_bytes[4] << 40) |
+            ((uint64_t)header_bytes[5] << 32) |
+            ((uint64_t)header_bytes[6] << 24) |
+            ((uint64_t)header_bytes[7] << 16) |
+            ((uint64_t)header_bytes[8] << 8) |
+            (uint64_t)header_bytes[9];
+        position += 8;
+    }
+    else if (length == 126)
+    {
+        uws_frame_decoder->header.payload_length = ((uint64_t)header_bytes[2] << 8) | (uint64_t)header_bytes[3];
+        position += 2;
+    }
+    else
+    {
+        uws_frame_decoder->header.payload_length = length;
+    }
+
+    if (uws_frame_decoder->header.is_masked)
+    {
+        (void)memcpy(uws_frame_decoder->masking_key, header_bytes + position, 4);
+    }
+
+    if ((length == 127) && ((header_bytes[2] & 0x80) != 0))
+    {
+        /* Codes_SRS_UWS_FRAME_DECODER_01_010: [ If the most significant bit of a 64 bit payload length is set, uws_frame_decoder_decode shall fail and return a non-zero value. ]*/
+        LogError("Bad frame: received a 64 bit length frame with the highest bit set");
+        result = __FAILURE__;
+    }
+    else if (((length == 127) && (uws_frame_decoder->header.payload_length < 65536)) ||
+        ((length == 126) && (uws_frame_decoder->header.payload_length < 126)))
+    {
+        /* Codes_SRS_UWS_FRAME_DECODER_01_009: [ If the payload length is not encoded with the minimal number of bytes, uws_frame_decoder_decode shall fail and return a non-zero value. ]*/
+        LogError("Bad frame: length %lu not encoded with the minimal number of bytes", (unsigned long)uws_frame_decoder->header.payload_length);
+        result = __FAILURE__;
+    }
+    else if (((header_bytes[0] & 0x08) != 0) &&
+        ((!uws_frame_decoder->header.is_final) || (uws_frame_decoder->header.payload_length > 125)))
+    {
+        /* Codes_SRS_UWS_FRAME_DECODER_01_011: [ If a control frame (opcode 0x8 or higher) is fragmented or has more than 125 bytes of payload, uws_frame_decoder_decode shall fail and return a non-zero value. ]*/
+        LogError("Bad frame: control frame 0x%x fragmented or with %lu bytes of payload", (unsigned int)uws_frame_decoder->header.opcode, (unsigned long)uws_frame_decoder->header.payload_length);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+static void indicate_payload(UWS_FRAME_DECODER_INSTANCE* uws_frame_decoder, const unsigned char* payload, size_t size)
+{
+    if (uws_frame_decoder->header.is_masked)
+    {
+        size_t done = 0;
+
+        /* Codes_SRS_UWS_FRAME_DECODER_01_013: [ A masked payload shall be unmasked with uws_frame_encoder_mask into a buffer of the decoder and indicated in pieces of at most 4096 bytes. ]*/
+        do
+        {
+            unsigned char masking_key[4];
+            size_t piece = size - done;
+            size_t i;
+
+            if (piece > UNMASK_BUFFER_SIZE)
+            {
+                piece = UNMASK_BUFFER_SIZE;
+            }
+
+            /* the key lines up with the first byte of the payload */
+            for (i = 0; i < 4; i++)
+            {
+                masking_key[i] = uws_frame_decoder->masking_key[(uws_frame_decoder->payload_offset + i) & 3];
+            }
+
+            uws_frame_encoder_mask(uws_frame_decoder->unmask_buffer, payload + done, piece, masking_key);
+            uws_frame_decoder->on_frame_decoded(uws_frame_decoder->on_frame_decoded_context, &uws_frame_decoder->header, uws_frame_decoder->unmask_buffer, piece, uws_frame_decoder->payload_offset);
+            uws_frame_decoder->payload_offset += piece;
+            done += piece;
+        } while (done < size);
+    }
+    else
+    {
+        /* Codes_SRS_UWS_FRAME_DECODER_01_012: [ The payload of a frame shall be indicated by calling on_frame_decoded with the bytes of buffer that hold it, without copying them. ]*/
+        uws_frame_decoder->on_frame_decoded(uws_frame_decoder->on_frame_decoded_context, &uws_frame_decoder->header, payload, size, uws_frame_decoder->payload_offset);
+        uws_frame_decoder->payload_offset += size;
+    }
+}
+
+UWS_FRAME_DECODER_HANDLE uws_frame_decoder_create(ON_WS_FRAME_DECODED on_frame_decoded, void* on_frame_decoded_context)
+{
+    UWS_FRAME_DECODER_INSTANCE* result;
+
+    if (on_frame_decoded == NULL)
+    {
+        /* Codes_SRS_UWS_FRAME_DECODER_01_002: [ If on_frame_decoded is NULL, uws_frame_decoder_create shall fail and return NULL. ]*/
+        LogError("NULL on_frame_decoded");
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_UWS_FRAME_DECODER_01_001: [ uws_frame_decoder_create shall create a decoder that indicates the frames it decodes to on_frame_decoded and return a non-NULL handle to it. ]*/
+        result = (UWS_FRAME_DECODER_INSTANCE*)malloc(sizeof(UWS_FRAME_DECODER_INSTANCE));
+        if (result == NULL)
+        {
+            /* Codes_SRS_UWS_FRAME_DECODER_01_003: [ If allocating memory for the decoder fails, uws_frame_decoder_create shall fail and return NULL. ]*/
+            LogError("Cannot allocate memory for the frame decoder");
+        }
+        else
+        {
+            result->on_frame_decoded = on_frame_decoded;
+            result->on_frame_decoded_context = on_frame_decoded_context;
+            result->state = UWS_FRAME_DECODER_STATE_HEADER;
+            result->header_count = 0;
+            result->payload_offset = 0;
+        }
+    }
+
+    return result;
+}
+
+void uws_frame_decoder_destroy(UWS_FRAME_DECODER_HANDLE uws_frame_decoder)
+{
+    if (uws_frame_decoder == NULL)
+    {
+        /* Codes_SRS_UWS_FRAME_DECODER_01_005: [ If uws_frame_decoder is NULL, uws_frame_decoder_destroy shall do nothing. ]*/
+        LogError("NULL uws_frame_decoder");
+    }
+    else
+    {
+        /* Codes_SRS_UWS_FRAME_DECODER_01_004: [ uws_frame_decoder_destroy shall free the decoder. ]*/
+        free(uws_frame_decoder);
+    }
+}
+
+int uws_frame_decoder_decode(UWS_FRAME_DECODER_HANDLE uws_frame_decoder, const unsigned char* buffer, size_t size)
+{
+    int result;
+
+    if ((uws_frame_decoder == NULL) ||
+        ((buffer == NULL) && (size > 0)))
+    {
+        /* Codes_SRS_UWS_FRAME_DECODER_01_006: [ If uws_frame_decoder is NULL, or buffer is NULL and size is not 0, uws_frame_decoder_decode shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: uws_frame_decoder=%p, buffer=%p, size=%u", uws_frame_decoder, buffer, (unsigned int)size);
+        result = __FAILURE__;
+    }
+    else if (uws_frame_decoder->state == UWS_FRAME_DECODER_STATE_ERROR)
+    {
+        /* Codes_SRS_UWS_FRAME_DECODER_01_015: [ Once decoding failed, uws_frame_decoder_decode shall fail and return a non-zero value. ]*/
+        LogError("The decoder failed already");
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t position = 0;
+
+        /* Codes_SRS_UWS_FRAME_DECODER_01_007: [ uws_frame_decoder_decode shall decode the frames in the size bytes at buffer, the bytes of a header that is not complete yet being kept for the next call. ]*/
+        result = 0;
+        while ((result == 0) &&
+            ((position < size) || ((uws_frame_decoder->state == UWS_FRAME_DECODER_STATE_PAYLOAD) && (uws_frame_decoder->header.payload_length == 0))))
+        {
+            if (uws_frame_decoder->state == UWS_FRAME_DECODER_STATE_HEADER)
+            {
+                size_t header_size = (uws_frame_decoder->header_count < 2) ? 2 : get_header_size(uws_frame_decoder->header_bytes);
+                size_t available = size - position;
+
+                if (available > header_size - uws_frame_decoder->header_count)
+                {
+                    available = header_size - uws_frame_decoder->header_count;
+                }
+
+                (void)memcpy(uws_frame_decoder->header_bytes + uws_frame_decoder->header_count, buffer + position, available);
+                uws_frame_decoder->header_count += available;
+                position += available;
+
+                if ((uws_frame_decoder->header_count >= 2) &&
+                    (uws_frame_decoder->header_count == get_header_size(uws_frame_decoder->header_bytes)))
+                {
+                    if (parse_header(uws_frame_decoder) != 0)
+                    {
+                        uws_frame_decoder->state = UWS_FRAME_DECODER_STATE_ERROR;
+                        result = __FAILURE__;
+                    }
+                    else
+                    {
+                        uws_frame_decoder->state = UWS_FRAME_DECODER_STATE_PAYLOAD;
+                        uws_frame_decoder->header_count = 0;
+                        uws_frame_decoder->payload_offset = 0;
+                    }
+                }
+            }
+            else if (uws_frame_decoder->header.payload_length == 0)
+            {
+                /* Codes_SRS_UWS_FRAME_DECODER_01_014: [ A frame without payload shall be indicated once, with payload NULL and size 0. ]*/
+                uws_frame_decoder->on_frame_decoded(uws_frame_decoder->on_frame_decoded_context, &uws_frame_decoder->header, NULL, 0, 0);
+                uws_frame_decoder->state = UWS_FRAME_DECODER_STATE_HEADER;
+            }
+            else
+            {
+                uint64_t remaining = uws_frame_decoder->header.payload_length - uws_frame_decoder->payload_offset;
+                size_t piece = size - position;
+
+                if ((uint64_t)piece > remaining)
+                {
+                    piece = (size_t)remaining;
+                }
+
+                indicate_payload(uws_frame_decoder, buffer + position, piece);
+                position += piece;
+
+                if (uws_frame_decoder->payload_offset == uws_frame_decoder->header.payload_length)
+                {
+                    uws_frame_decoder->state = UWS_FRAME_DECODER_STATE_HEADER;
+                }
+            }
+        }
+
+        /* Codes_SRS_UWS_FRAME_DECODER_01_016: [ On success uws_frame_decoder_decode shall return 0. ]*/
+    }
+
+    return result;
+}
@@ -9,6 +9,82 @@
 
 #include "azure_c_shared_utility/vector_types_internal.h"
 
+/* makes room for at least requiredCount elements; capacity grows geometrically so that appending N elements one at a time costs O(N) */
+static int ensure_capacity(VECTOR_HANDLE handle, size_t requiredCount)
+{
+    int result;
+
+    if (requiredCount <= handle->capacity)
+    {
+        result = 0;
+    }
+    else
+    {
+        size_t newCapacity = (handle->capacity > (((size_t)-1) / 2)) ? requiredCount : handle->capacity * 2;
+        void* temp;
+
+        if (newCapacity < requiredCount)
+        {
+            newCapacity = requiredCount;
+        }
+
+        if (newCapacity > ((size_t)-1) / handle->elementSize)
+        {
+            LogError("vector cannot hold %zd elements of size %zd.", requiredCount, handle->elementSize);
+            result = __FAILURE__;
+        }
+        else if ((temp = realloc(handle->storage, newCapacity * handle->elementSize)) == NULL)
+        {
+            LogError("realloc failed.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            handle->storage = temp;
+            handle->capacity = newCapacity;
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+/* checks that the numElements starting at elements belong to the vector */
+static int validate_range(VECTOR_HANDLE handle, void* elements, size_t numElements)
+{
+    int result;
+
+    if (elements < handle->storage)
+    {
+        /* Codes_SRS_VECTOR_10_040: [VECTOR_erase shall return if elements is out of bound.] */
+        LogError("invalid argument elements(%p) is not a member of this object.", elements);
+        result = __FAILURE__;
+    }
+    else
+    {
+        ptrdiff_t diff = ((unsigned char*)elements) - ((unsigned char*)handle->storage);
+        if ((diff % handle->elementSize) != 0)
+        {
+            /* Codes_SRS_VECTOR_10_041: [VECTOR_erase shall return if elements is misaligned.] */
+            LogError("invalid argument - elements(%p) is misaligned", elements);
+            result = __FAILURE__;
+        }
+        else if (((size_t)diff / handle->elementSize) > handle->count ||
+            numElements > handle->count - ((size_t)diff / handle->elementSize))
+        {
+            /* Codes_SRS_VECTOR_10_040: [VECTOR_erase shall return if elements is out of bound.] */
+            LogError("invalid argument - numElements(%zd) is out of bound.", numElements);
+            result = __FAILURE__;
+        }
+        else
+        {
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
 VECTOR_HANDLE VECTOR_create(size_t elementSize)
 {
     VECTOR_HANDLE result;
@@ -32,6 +108,7 @@ VECTOR_HANDLE VECTOR_create(size_t elementSize)
             /* Codes_SRS_VECTOR_10_001: [VECTOR_create shall allocate a VECTOR_HANDLE that will contain an empty vector.The size of each element is given with the parameter elementSize.] */
             result->storage = NULL;
             result->count = 0;
+            result->capacity = 0;
             result->elementSize = elementSize;
         }
     }
@@ -74,11 +151,13 @@ VECTOR_HANDLE VECTOR_move(VECTOR_HANDLE handle)
         {
             /* Codes_SRS_VECTOR_10_004: [VECTOR_move shall allocate a VECTOR_HANDLE and move the data to it from the given handle.] */
             result->count = handle->count;
+            result->capacity = handle->capacity;
             result->elementSize = handle->elementSize;
             result->storage = handle->storage;
 
             handle->storage = NULL;
             handle->count = 0;
+            handle->capacity = 0;
         }
     }
     return result;
@@ -97,24 +176,58 @@ int VECTOR_push_back(VECTOR_HANDLE handle, const void* elements, size_t numEleme
         LogError("invalid argument - handle(%p), elements(%p), numElements(%zd).", handle, elements, numElements);
         result = __FAILURE__;
     }
+    else if (numElements > ((size_t)-1) - handle->count ||
+        ensure_capacity(handle, handle->count + numElements) != 0)
+    {
+        /* Codes_SRS_VECTOR_10_012: [VECTOR_push_back shall fail and return non-zero if memory allocation fails.] */
+        LogError("unable to make room for %zd elements.", numElements);
+        result = __FAILURE__;
+    }
     else
     {
-        size_t curSize = handle->elementSize * handle->count;
-        size_t appendSize = handle->elementSize * numElements;
+        /* Codes_SRS_VECTOR_10_013: [VECTOR_push_back shall append the given elements and return 0 indicating success.] */
+        /* Codes_SRS_VECTOR_10_042: [VECTOR_push_back shall only reallocate the internal storage when its capacity is exceeded, at least doubling it.] */
+        (void)memcpy((unsigned char*)handle->storage + (handle->elementSize * handle->count), elements, handle->elementSize * numElements);
+        handle->count += numElements;
+        result = 0;
+    }
+    return result;
+}
 
-        void* temp = realloc(handle->storage, curSize + appendSize);
+int VECTOR_reserve(VECTOR_HANDLE handle, size_t numElements)
+{
+    int result;
+    if (handle == NULL)
+    {
+        /* Codes_SRS_VECTOR_10_043: [VECTOR_reserve shall fail and return non-zero if handle is NULL.] */
+        LogError("invalid argument handle(NULL).");
+        result = __FAILURE__;
+    }
+    else if (numElements <= handle->capacity)
+    {
+        /* Codes_SRS_VECTOR_10_044: [VECTOR_reserve shall return 0 without allocating if the capacity is already at least numElements.] */
+        result = 0;
+    }
+    else if (numElements > ((size_t)-1) / handle->elementSize)
+    {
+        /* Codes_SRS_VECTOR_10_046: [VECTOR_reserve shall fail and return non-zero if memory allocation fails.] */
+        LogError("vector cannot hold %zd elements of size %zd.", numElements, handle->elementSize);
+        result = __FAILURE__;
+    }
+    else
+    {
+        void* temp = realloc(handle->storage, numElements * handle->elementSize);
         if (temp == NULL)
         {
-           /* Codes_SRS_VECTOR_10_012: [VECTOR_push_back shall fail and return non-zero if memory allocation fails.] */
+            /* Codes_SRS_VECTOR_10_046: [VECTOR_reserve shall fail and return non-zero if memory allocation fails.] */
             LogError("realloc failed.");
             result = __FAILURE__;
         }
         else
         {
-            /* Codes_SRS_VECTOR_10_013: [VECTOR_push_back shall append the given elements and return 0 indicating success.] */
-            (void)memcpy((unsigned char*)temp + curSize, elements, appendSize);
+            /* Codes_SRS_VECTOR_10_045: [VECTOR_reserve shall grow the internal storage to hold exactly numElements elements and return 0.] */
             handle->storage = temp;
-            handle->count += numElements;
+            handle->capacity = numElements;
             result = 0;
         }
     }
@@ -132,56 +245,64 @@ void VECTOR_erase(VECTOR_HANDLE handle, void* elements, size_t numElements)
         /* Codes_SRS_VECTOR_10_039: [VECTOR_erase shall return if numElements is 0.] */
         LogError("invalid argument - handle(%p), elements(%p), numElements(%zd).", handle, elements, numElements);
     }
+    else if (validate_range(handle, elements, numElements) != 0)
+    {
+        /* Codes_SRS_VECTOR_10_027: [VECTOR_erase shall return if numElements is out of bound.] */
+        LogError("invalid range - elements(%p), numElements(%zd).", elements, numElements);
+    }
     else
     {
-        if (elements < handle->storage)
+        /* Codes_SRS_VECTOR_10_014: [VECTOR_erase shall remove the 'numElements' starting at 'elements', keeping the order of the remaining elements.] */
+        unsigned char* src = (unsigned char*)elements + (handle->elementSize * numElements);
+        unsigned char* srcEnd = (unsigned char*)handle->storage + (handle->elementSize * handle->count);
+
+        handle->count -= numElements;
+        if (handle->count == 0)
         {
-            /* Codes_SRS_VECTOR_10_040: [VECTOR_erase shall return if elements is out of bound.] */
-            LogError("invalid argument elements(%p) is not a member of this object.", elements);
+            /* Codes_SRS_VECTOR_10_047: [VECTOR_erase shall release the internal storage when the vector becomes empty.] */
+            free(handle->storage);
+            handle->storage = NULL;
+            handle->capacity = 0;
         }
         else
         {
-            ptrdiff_t diff = ((unsigned char*)elements) - ((unsigned char*)handle->storage);
-            if ((diff % handle->elementSize) != 0)
-            {
-                /* Codes_SRS_VECTOR_10_041: [VECTOR_erase shall return if elements is misaligned.] */
-                LogError("invalid argument - elements(%p) is misaligned", elements);
-            }
-            else
-            {
-                /* Compute the arguments needed for memmove. */
-                unsigned char* src = (unsigned char*)elements + (handle->elementSize * numElements);
-                unsigned char* srcEnd = (unsigned char*)handle->storage + (handle->elementSize * handle->count);
-                if (src > srcEnd)
-                {
-                    /* Codes_SRS_VECTOR_10_040: [VECTOR_erase shall return if elements is out of bound.] */
-                    LogError("invalid argument - numElements(%zd) is out of bound.", numElements);
-                }
-                else
-                {
-                    /* Codes_SRS_VECTOR_10_014: [VECTOR_erase shall remove the 'numElements' starting at 'elements' and reduce its internal storage.] */
-                    handle->count -= numElements;
-                    if (handle->count == 0)
-                    {
-                        free(handle->storage);
-                        handle->storage = NULL;
-                    }
-                    else
-                    {
-                        void* tmp;
-                        (void)memmove(elements, src, srcEnd - src);
-                        tmp = realloc(handle->storage, (handle->elementSize * handle->count));
-                        if (tmp == NULL)
-                        {
-                            LogInfo("realloc failed. Keeping original internal storage pointer.");
-                        }
-                        else
-                        {
-                            handle->storage = tmp;
-                        }
-                    }
-                }
-            }
+            /* the capacity is kept, VECTOR_shrink_to_fit releases it */
+            (void)memmove(elements, src, srcEnd - src);
+        }
+    }
+}
+
+void VECTOR_erase_unordered(VECTOR_HANDLE handle, void* elements, size_t numElements)
+{
+    if (handle == NULL || elements == NULL || numElements == 0)
+    {
+        /* Codes_SRS_VECTOR_10_048: [VECTOR_erase_unordered shall return if handle or elements are NULL or numElements is 0.] */
+        LogError("invalid argument - handle(%p), elements(%p), numElements(%zd).", handle, elements, numElements);
+    }
+    else if (validate_range(handle, elements, numElements) != 0)
+    {
+        /* Codes_SRS_VECTOR_10_049: [VECTOR_erase_unordered shall return if the numElements starting at elements are out of bound or misaligned.] */
+        LogError("invalid range - elements(%p), numElements(%zd).", elements, numElements);
+    }
+    else
+    {
+        size_t index = (((unsigned char*)elements) - ((unsigned char*)handle->storage)) / handle->elementSize;
+        size_t tailCount = handle->count - (index + numElements);
+        size_t moveCount = (tailCount < numElements) ? tailCount : numElements;
+
+        /* Codes_SRS_VECTOR_10_050: [VECTOR_erase_unordered shall remove the numElements starting at elements by moving the last elements of the vector in their place.] */
+        if (moveCount > 0)
+        {
+            (void)memcpy(elements, (unsigned char*)handle->storage + (handle->elementSize * (handle->count - moveCount)), handle->elementSize * moveCount);
+        }
+        handle->count -= numElements;
+
+        if (handle->count == 0)
+        {
+            /* Codes_SRS_VECTOR_10_051: [VECTOR_erase_unordered shall release the internal storage when the vector becomes empty.] */
+            free(handle->storage);
+            handle->storage = NULL;
+            handle->capacity = 0;
         }
     }
 }
@@ -199,6 +320,7 @@ void VECTOR_clear(VECTOR_HANDLE handle)
         free(handle->storage);
         handle->storage = NULL;
         handle->count = 0;
+        handle->capacity = 0;
     }
 }
 
@@ -336,3 +458,62 @@ size_t VECTOR_size(VECTOR_HANDLE handle)
     }
     return result;
 }
+
+size_t VECTOR_capacity(VECTOR_HANDLE handle)
+{
+    size_t result;
+    if (handle == NULL)
+    {
+        /* Codes_SRS_VECTOR_10_053: [VECTOR_capacity shall return 0 if the given handle is NULL.] */
+        LogError("invalid argument handle(NULL).");
+        result = 0;
+    }
+    else
+    {
+        /* Codes_SRS_VECTOR_10_052: [VECTOR_capacity shall return the number of elements the internal storage can hold without reallocating.] */
+        result = handle->capacity;
+    }
+    return result;
+}
+
+int VECTOR_shrink_to_fit(VECTOR_HANDLE handle)
+{
+    int result;
+    if (handle == NULL)
+    {
+        /* Codes_SRS_VECTOR_10_054: [VECTOR_shrink_to_fit shall fail and return non-zero if handle is NULL.] */
+        LogError("invalid argument handle(NULL).");
+        result = __FAILURE__;
+    }
+    else if (handle->count == handle->capacity)
+    {
+        /* Codes_SRS_VECTOR_10_055: [VECTOR_shrink_to_fit shall return 0 without reallocating if the capacity already equals the size.] */
+        result = 0;
+    }
+    else if (handle->count == 0)
+    {
+        /* Codes_SRS_VECTOR_10_056: [VECTOR_shrink_to_fit shall release the internal storage of an empty vector.] */
+        free(handle->storage);
+        handle->storage = NULL;
+        handle->capacity = 0;
+        result = 0;
+    }
+    else
+    {
+        void* temp = realloc(handle->storage, handle->count * handle->elementSize);
+        if (temp == NULL)
+        {
+            /* Codes_SRS_VECTOR_10_058: [VECTOR_shrink_to_fit shall fail and return non-zero if memory allocation fails, leaving the vector unchanged.] */
+            LogError("realloc failed.");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_VECTOR_10_057: [VECTOR_shrink_to_fit shall reduce the internal storage to the size of the vector and return 0.] */
+            handle->storage = temp;
+            handle->capacity = handle->count;
+            result = 0;
+        }
+    }
+    return result;
+}
@@ -4,12 +4,13 @@
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdio.h>
+#include <string.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/wsio.h"
 #include "azure_c_shared_utility/xlogging.h"
-#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/doublylinkedlist.h"
 #include "azure_c_shared_utility/optionhandler.h"
 #include "azure_c_shared_utility/xio.h"
 #include "azure_c_shared_utility/shared_util_options.h"
@@ -19,6 +20,11 @@
 
 static const char* WSIO_OPTIONS = "WSIOOptions";
 
+/*the number of pending IOs kept in each wsio instance, only the sends in flight past that many allocate theirs*/
+#ifndef WSIO_PENDING_IO_RECORD_COUNT
+#define WSIO_PENDING_IO_RECORD_COUNT 16
+#endif
+
 typedef enum IO_STATE_TAG
 {
     IO_STATE_NOT_OPEN,
@@ -30,9 +36,14 @@ typedef enum IO_STATE_TAG
 
 typedef struct PENDING_IO_TAG
 {
+    DLIST_ENTRY link;
     ON_SEND_COMPLETE on_send_complete;
     void* callback_context;
     void* wsio;
+    size_t size;
+    /* true for the records kept in the instance, false for the ones allocated when all the records were in use */
+    bool is_record;
+    struct PENDING_IO_TAG* next_free_record;
 } PENDING_IO;
 
 typedef struct WSIO_INSTANCE_TAG
@@ -46,10 +57,53 @@ typedef struct WSIO_INSTANCE_TAG
     ON_IO_CLOSE_COMPLETE on_io_close_complete;
     void* on_io_close_complete_context;
     IO_STATE io_state;
-    SINGLYLINKEDLIST_HANDLE pending_io_list;
+    DLIST_ENTRY pending_io_list;
     UWS_CLIENT_HANDLE uws;
+    WSIO_SEND_WINDOW send_window;
+    size_t pending_bytes;
+    bool send_window_closed;
+    XIO_STATS stats;
+#if WSIO_PENDING_IO_RECORD_COUNT > 0
+    PENDING_IO pending_io_records[WSIO_PENDING_IO_RECORD_COUNT];
+#endif
+    PENDING_IO* free_pending_io_records;
 } WSIO_INSTANCE;
 
+static PENDING_IO* alloc_pending_io(WSIO_INSTANCE* wsio_instance)
+{
+    PENDING_IO* result = wsio_instance->free_pending_io_records;
+
+    if (result != NULL)
+    {
+        /* Codes_SRS_WSIO_01_214: [ The pending IO shall be taken from the records kept in the wsio instance, without allocating. ]*/
+        wsio_instance->free_pending_io_records = result->next_free_record;
+    }
+    else
+    {
+        /* Codes_SRS_WSIO_01_215: [ When all the records are in use, the pending IO shall be allocated. ]*/
+        result = (PENDING_IO*)malloc(sizeof(PENDING_IO));
+        if (result != NULL)
+        {
+            result->is_record = false;
+        }
+    }
+
+    return result;
+}
+
+static void free_pending_io(WSIO_INSTANCE* wsio_instance, PENDING_IO* pending_io)
+{
+    if (pending_io->is_record)
+    {
+        pending_io->next_free_record = wsio_instance->free_pending_io_records;
+        wsio_instance->free_pending_io_records = pending_io;
+    }
+    else
+    {
+        free(pending_io);
+    }
+}
+
 static void indicate_error(WSIO_INSTANCE* wsio_instance)
 {
     wsio_instance->io_state = IO_STATE_ERROR;
@@ -61,25 +115,63 @@ static void indicate_open_complete(WSIO_INSTANCE* ws_io_instance, IO_OPEN_RESULT
     ws_io_instance->on_io_open_complete(ws_io_instance->on_io_open_complete_context, open_result);
 }
 
-static void complete_send_item(LIST_ITEM_HANDLE pending_io_list_item, IO_SEND_RESULT io_send_result)
+static void update_send_window(WSIO_INSTANCE* wsio_instance)
 {
-    PENDING_IO* pending_io = (PENDING_IO*)singlylinkedlist_item_get_value(pending_io_list_item);
-    WSIO_INSTANCE* wsio_instance = (WSIO_INSTANCE*)pending_io->wsio;
+    bool send_window_closed;
 
-    /* Codes_SRS_WSIO_01_145: [ Removing it from the list shall be done by calling singlylinkedlist_remove. ]*/
-    if (singlylinkedlist_remove(wsio_instance->pending_io_list, pending_io_list_item) != 0)
+    if (wsio_instance->send_window.high_watermark == 0)
     {
-        LogError("Failed removing pending IO from linked list.");
+        send_window_closed = false;
     }
+    else if (wsio_instance->pending_bytes >= wsio_instance->send_window.high_watermark)
+    {
+        /* Codes_SRS_WSIO_01_191: [ When the number of queued bytes reaches the high_watermark the send window shall be closed. ]*/
+        send_window_closed = true;
+    }
+    else if (wsio_instance->pending_bytes <= wsio_instance->send_window.low_watermark)
+    {
+        /* Codes_SRS_WSIO_01_193: [ When completing pending IOs brings the number of queued bytes down to the low_watermark the send window shall be opened again. ]*/
+        send_window_closed = false;
+    }
+    else
+    {
+        send_window_closed = wsio_instance->send_window_closed;
+    }
+
+    if (send_window_closed != wsio_instance->send_window_closed)
+    {
+        wsio_instance->send_window_closed = send_window_closed;
+
+        /* Codes_SRS_WSIO_01_194: [ Whenever the send window is closed or opened, on_send_window_changed shall be called with the on_send_window_changed_context and is_open set to false or true respectively. ]*/
+        /* Codes_SRS_WSIO_01_195: [ on_send_window_changed shall be optional. ]*/
+        if (wsio_instance->send_window.on_send_window_changed != NULL)
+        {
+            wsio_instance->send_window.on_send_window_changed(wsio_instance->send_window.on_send_window_changed_context, !send_window_closed);
+        }
+    }
+}
+
+static void complete_send_item(PENDING_IO* pending_io, IO_SEND_RESULT io_send_result)
+{
+    WSIO_INSTANCE* wsio_instance = (WSIO_INSTANCE*)pending_io->wsio;
+
+    /* Codes_SRS_WSIO_01_145: [ Removing it from the list shall be done by unlinking the list entry embedded in the pending IO. ]*/
+    (void)DList_RemoveEntryList(&pending_io->link);
+
+    wsio_instance->pending_bytes -= pending_io->size;
+    wsio_instance->stats.pending_send_count--;
 
     /* Codes_SRS_WSIO_01_105: [ The argument on_send_complete shall be optional, if NULL is passed by the caller then no send complete callback shall be triggered. ]*/
     if (pending_io->on_send_complete != NULL)
     {
+        wsio_instance->stats.callback_count++;
         pending_io->on_send_complete(pending_io->callback_context, io_send_result);
     }
 
-    /* Codes_SRS_WSIO_01_144: [ Also the pending IO data shall be freed. ]*/
-    free(pending_io);
+    /* Codes_SRS_WSIO_01_144: [ Also the pending IO data shall be freed, a record kept in the wsio instance being made available again. ]*/
+    free_pending_io(wsio_instance, pending_io);
+
+    update_send_window(wsio_instance);
 }
 
 static void on_underlying_ws_send_frame_complete(void* context, WS_SEND_FRAME_RESULT ws_send_frame_result)
@@ -91,7 +183,7 @@ static void on_underlying_ws_send_frame_complete(void* context, WS_SEND_FRAME_RE
     else
     {
         IO_SEND_RESULT io_send_result;
-        LIST_ITEM_HANDLE list_item_handle = (LIST_ITEM_HANDLE)context;
+        PENDING_IO* pending_io = (PENDING_IO*)context;
 
         /* Codes_SRS_WSIO_01_143: [ When on_underlying_ws_send_frame_complete is called after sending a WebSocket frame, the pending IO shall be removed from the list. ]*/
         switch (ws_send_frame_result)
@@ -113,7 +205,7 @@ static void on_underlying_ws_send_frame_complete(void* context, WS_SEND_FRAME_RE
             break;
         }
 
-        complete_send_item(list_item_handle, io_send_result);
+        complete_send_item(pending_io, io_send_result);
     }
 }
 
@@ -165,8 +257,6 @@ static int internal_close(WSIO_INSTANCE* wsio_instance, ON_IO_CLOSE_COMPLETE on_
         }
         else
         {
-            LIST_ITEM_HANDLE first_pending_io;
-
             wsio_instance->io_state = IO_STATE_CLOSING;
 
             wsio_instance->on_io_close_complete = on_io_close_complete;
@@ -184,10 +274,10 @@ static int internal_close(WSIO_INSTANCE* wsio_instance, ON_IO_CLOSE_COMPLETE on_
 
             /* Codes_SRS_WSIO_01_085: [ wsio_close shall close the websockets IO if an open action is either pending or has completed successfully (if the IO is open).  ]*/
             /* Codes_SRS_WSIO_01_091: [ wsio_close shall obtain all the pending IO items by repetitively querying for the head of the pending IO list and freeing that head item. ]*/
-            /* Codes_SRS_WSIO_01_092: [ Obtaining the head of the pending IO list shall be done by calling singlylinkedlist_get_head_item. ]*/
-            while ((first_pending_io = singlylinkedlist_get_head_item(wsio_instance->pending_io_list)) != NULL)
+            /* Codes_SRS_WSIO_01_092: [ Obtaining the head of the pending IO list shall be done by taking the first entry of the list. ]*/
+            while (!DList_IsListEmpty(&wsio_instance->pending_io_list))
             {
-                complete_send_item(first_pending_io, IO_SEND_CANCELLED);
+                complete_send_item(containingRecord(wsio_instance->pending_io_list.Flink, PENDING_IO, link), IO_SEND_CANCELLED);
             }
 
             /* Codes_SRS_WSIO_01_133: [ On success wsio_close shall return 0. ]*/
@@ -237,6 +327,27 @@ CONCRETE_IO_HANDLE wsio_create(void* io_create_parameters)
             result->on_io_error_context = NULL;
             result->on_io_close_complete = NULL;
             result->on_io_close_complete_context = NULL;
+            result->send_window.high_watermark = 0;
+            result->send_window.low_watermark = 0;
+            result->send_window.on_send_window_changed = NULL;
+            result->send_window.on_send_window_changed_context = NULL;
+            result->pending_bytes = 0;
+            result->send_window_closed = false;
+            (void)memset(&result->stats, 0, sizeof(result->stats));
+            result->stats.layer_name = "wsio";
+
+            result->free_pending_io_records = NULL;
+#if WSIO_PENDING_IO_RECORD_COUNT > 0
+            {
+                size_t i;
+                for (i = WSIO_PENDING_IO_RECORD_COUNT; i > 0; i--)
+                {
+                    result->pending_io_records[i - 1].is_record = true;
+                    result->pending_io_records[i - 1].next_free_record = result->free_pending_io_records;
+                    result->free_pending_io_records = &result->pending_io_records[i - 1];
+                }
+            }
+#endif
 
             /* Codes_SRS_WSIO_01_070: [ The underlying uws instance shall be created by calling uws_client_create_with_io. ]*/
             /* Codes_SRS_WSIO_01_071: [ The arguments for uws_client_create_with_io shall be: ]*/
@@ -256,20 +367,9 @@ CONCRETE_IO_HANDLE wsio_create(void* io_create_parameters)
             }
             else
             {
-                /* Codes_SRS_WSIO_01_076: [ wsio_create shall create a pending send IO list that is to be used to queue send packets by calling singlylinkedlist_create. ]*/
-                result->pending_io_list = singlylinkedlist_create();
-                if (result->pending_io_list == NULL)
-                {
-                    /* Codes_SRS_WSIO_01_077: [ If singlylinkedlist_create fails then wsio_create shall fail and return NULL. ]*/
-                    LogError("Cannot create singly linked list.");
-                    uws_client_destroy(result->uws);
-                    free(result);
-                    result = NULL;
-                }
-                else
-                {
-                    result->io_state = IO_STATE_NOT_OPEN;
-                }
+                /* Codes_SRS_WSIO_01_076: [ wsio_create shall initialize an empty pending send IO list that is to be used to queue send packets. ]*/
+                DList_InitializeListHead(&result->pending_io_list);
+                result->io_state = IO_STATE_NOT_OPEN;
             }
         }
     }
@@ -296,8 +396,6 @@ void wsio_destroy(CONCRETE_IO_HANDLE ws_io)
         /* Codes_SRS_WSIO_01_078: [ wsio_destroy shall free all resources associated with the wsio instance. ]*/
         /* Codes_SRS_WSIO_01_080: [ wsio_destroy shall destroy the uws instance created in wsio_create by calling uws_client_destroy. ]*/
         uws_client_destroy(wsio_instance->uws);
-        /* Codes_SRS_WSIO_01_081: [ wsio_destroy shall free the list used to track the pending send IOs by calling singlylinkedlist_destroy. ]*/
-        singlylinkedlist_destroy(wsio_instance->pending_io_list);
         free(ws_io);
     }
 }
@@ -395,6 +493,8 @@ static void on_underlying_ws_frame_received(void* context, unsigned char frame_t
                     {
                         /* Codes_SRS_WSIO_01_124: [ When on_underlying_ws_frame_received is called the bytes in the frame shall be indicated by calling the on_bytes_received callback passed to wsio_open. ]*/
                         /* Codes_SRS_WSIO_01_125: [ When calling on_bytes_received, the on_bytes_received_context argument given in wsio_open shall be passed to the callback on_bytes_received. ]*/
+                        wsio_instance->stats.bytes_received += size;
+                        wsio_instance->stats.callback_count++;
                         wsio_instance->on_bytes_received(wsio_instance->on_bytes_received_context, buffer, size);
                     }
                 }
@@ -579,10 +679,15 @@ int wsio_send(CONCRETE_IO_HANDLE ws_io, const void* buffer, size_t size, ON_SEND
             LogError("Attempting to send when not open");
             result = __FAILURE__;
         }
+        else if (wsio_instance->send_window_closed)
+        {
+            /* Codes_SRS_WSIO_01_192: [ While the send window is closed wsio_send shall fail and return a non-zero value without queueing the buffer. ]*/
+            LogError("Send window is closed, %u bytes are pending", (unsigned int)wsio_instance->pending_bytes);
+            result = __FAILURE__;
+        }
         else
         {
-            LIST_ITEM_HANDLE new_item;
-            PENDING_IO* pending_socket_io = (PENDING_IO*)malloc(sizeof(PENDING_IO));
+            PENDING_IO* pending_socket_io = alloc_pending_io(wsio_instance);
             if (pending_socket_io == NULL)
             {
                 /* Codes_SRS_WSIO_01_134: [ If allocating memory for the pending IO data fails, wsio_send shall fail and return a non-zero value. ]*/
@@ -594,34 +699,36 @@ int wsio_send(CONCRETE_IO_HANDLE ws_io, const void* buffer, size_t size, ON_SEND
                 pending_socket_io->on_send_complete = on_send_complete;
                 pending_socket_io->callback_context = callback_context;
                 pending_socket_io->wsio = wsio_instance;
+                pending_socket_io->size = size;
 
-                /* Codes_SRS_WSIO_01_102: [ An entry shall be queued in the singly linked list by calling singlylinkedlist_add. ]*/
-                if ((new_item = singlylinkedlist_add(wsio_instance->pending_io_list, pending_socket_io)) == NULL)
+                /* Codes_SRS_WSIO_01_102: [ An entry shall be queued at the tail of the pending IO list through the list entry embedded in it, without allocating. ]*/
+                DList_InsertTailList(&wsio_instance->pending_io_list, &pending_socket_io->link);
+
+                /* counted before the frame is sent, its send may complete right away */
+                wsio_instance->stats.pending_send_count++;
+
+                /* Codes_SRS_WSIO_01_095: [ wsio_send shall call uws_client_send_frame_async, passing the buffer and size arguments as they are: ]*/
+                /* Codes_SRS_WSIO_01_097: [ The is_final argument shall be set to true. ]*/
+                /* Codes_SRS_WSIO_01_096: [ The frame type used shall be WS_FRAME_TYPE_BINARY. ]*/
+                if (uws_client_send_frame_async(wsio_instance->uws, WS_FRAME_TYPE_BINARY, (const unsigned char*)buffer, size, true, on_underlying_ws_send_frame_complete, pending_socket_io) != 0)
                 {
-                    /* Codes_SRS_WSIO_01_104: [ If singlylinkedlist_add fails, wsio_send shall fail and return a non-zero value. ]*/
-                    free(pending_socket_io);
+                    (void)DList_RemoveEntryList(&pending_socket_io->link);
+
+                    wsio_instance->stats.pending_send_count--;
+                    free_pending_io(wsio_instance, pending_socket_io);
                     result = __FAILURE__;
                 }
                 else
                 {
-                    /* Codes_SRS_WSIO_01_095: [ wsio_send shall call uws_client_send_frame_async, passing the buffer and size arguments as they are: ]*/
-                    /* Codes_SRS_WSIO_01_097: [ The is_final argument shall be set to true. ]*/
-                    /* Codes_SRS_WSIO_01_096: [ The frame type used shall be WS_FRAME_TYPE_BINARY. ]*/
-                    if (uws_client_send_frame_async(wsio_instance->uws, WS_FRAME_TYPE_BINARY, (const unsigned char*)buffer, size, true, on_underlying_ws_send_frame_complete, new_item) != 0)
-                    {
-                        if (singlylinkedlist_remove(wsio_instance->pending_io_list, new_item) != 0)
-                        {
-                            LogError("Failed removing pending IO from linked list.");
-                        }
+                    wsio_instance->stats.send_count++;
+                    wsio_instance->stats.bytes_sent += size;
 
-                        free(pending_socket_io);
-                        result = __FAILURE__;
-                    }
-                    else
-                    {
-                        /* Codes_SRS_WSIO_01_098: [ On success, wsio_send shall return 0. ]*/
-                        result = 0;
-                    }
+                    /* Codes_SRS_WSIO_01_190: [ On success, size shall be added to the number of queued bytes. ]*/
+                    wsio_instance->pending_bytes += size;
+                    update_send_window(wsio_instance);
+
+                    /* Codes_SRS_WSIO_01_098: [ On success, wsio_send shall return 0. ]*/
+                    result = 0;
                 }
             }
         }
@@ -644,12 +751,148 @@ void wsio_dowork(CONCRETE_IO_HANDLE ws_io)
         /* Codes_SRS_WSIO_01_108: [ If the IO is not yet open, wsio_dowork shall do nothing. ]*/
         if (wsio_instance->io_state != IO_STATE_NOT_OPEN)
         {
+            uint64_t callback_count = wsio_instance->stats.callback_count;
+
+            wsio_instance->stats.dowork_count++;
+
             /* Codes_SRS_WSIO_01_106: [ wsio_dowork shall call uws_client_dowork with the uws handle created in wsio_create. ]*/
             uws_client_dowork(wsio_instance->uws);
+
+            if (wsio_instance->stats.callback_count == callback_count)
+            {
+                wsio_instance->stats.idle_dowork_count++;
+            }
         }
     }
 }
 
+static int wsio_dowork_ex(CONCRETE_IO_HANDLE ws_io, bool* made_progress, uint64_t* next_deadline_us)
+{
+    int result;
+
+    if ((ws_io == NULL) ||
+        (made_progress == NULL) ||
+        (next_deadline_us == NULL))
+    {
+        /* Codes_SRS_WSIO_01_204: [ If ws_io, made_progress or next_deadline_us is NULL, wsio_dowork_ex shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: ws_io=%p, made_progress=%p, next_deadline_us=%p", ws_io, made_progress, next_deadline_us);
+        result = __FAILURE__;
+    }
+    else
+    {
+        WSIO_INSTANCE* wsio_instance = (WSIO_INSTANCE*)ws_io;
+
+        if (wsio_instance->io_state == IO_STATE_NOT_OPEN)
+        {
+            /* Codes_SRS_WSIO_01_205: [ If the IO is not yet open, wsio_dowork_ex shall set made_progress to false, set next_deadline_us to XIO_NO_DEADLINE and return 0. ]*/
+            *made_progress = false;
+            *next_deadline_us = XIO_NO_DEADLINE;
+        }
+        else
+        {
+            uint64_t callback_count = wsio_instance->stats.callback_count;
+            bool uws_progress;
+
+            wsio_instance->stats.dowork_count++;
+
+            /* Codes_SRS_WSIO_01_206: [ Otherwise wsio_dowork_ex shall call uws_client_dowork_ex with the uws handle created in wsio_create, passing next_deadline_us down to it. ]*/
+            if (uws_client_dowork_ex(wsio_instance->uws, &uws_progress, next_deadline_us) != 0)
+            {
+                /* Codes_SRS_WSIO_01_208: [ If uws_client_dowork_ex fails, made_progress shall be set to true and next_deadline_us to XIO_NO_DEADLINE. ]*/
+                LogError("uws_client_dowork_ex failed");
+                uws_progress = true;
+                *next_deadline_us = XIO_NO_DEADLINE;
+            }
+
+            if (wsio_instance->stats.callback_count == callback_count)
+            {
+                wsio_instance->stats.idle_dowork_count++;
+            }
+
+            /* Codes_SRS_WSIO_01_207: [ made_progress shall be set to true if a callback was made or the uws instance made progress, false otherwise. ]*/
+            *made_progress = uws_progress || (wsio_instance->stats.callback_count != callback_count);
+        }
+
+        /* Codes_SRS_WSIO_01_209: [ On success wsio_dowork_ex shall return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+static int wsio_get_pollable_handle(CONCRETE_IO_HANDLE ws_io, intptr_t* pollable_handle, unsigned int* wanted_events)
+{
+    int result;
+
+    if ((ws_io == NULL) ||
+        (pollable_handle == NULL) ||
+        (wanted_events == NULL))
+    {
+        /* Codes_SRS_WSIO_01_210: [ If ws_io, pollable_handle or wanted_events is NULL, wsio_get_pollable_handle shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: ws_io=%p, pollable_handle=%p, wanted_events=%p", ws_io, pollable_handle, wanted_events);
+        result = __FAILURE__;
+    }
+    else
+    {
+        WSIO_INSTANCE* wsio_instance = (WSIO_INSTANCE*)ws_io;
+
+        /* Codes_SRS_WSIO_01_211: [ wsio_get_pollable_handle shall call uws_client_get_pollable_handle with the uws handle created in wsio_create, passing pollable_handle and wanted_events down to it. ]*/
+        if (uws_client_get_pollable_handle(wsio_instance->uws, pollable_handle, wanted_events) != 0)
+        {
+            /* Codes_SRS_WSIO_01_212: [ If uws_client_get_pollable_handle fails, wsio_get_pollable_handle shall fail and return a non-zero value. ]*/
+            LogError("uws_client_get_pollable_handle failed");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_WSIO_01_213: [ On success wsio_get_pollable_handle shall return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+static int wsio_get_stats(CONCRETE_IO_HANDLE ws_io, XIO_STATS* stats, size_t stats_count, size_t* layer_count)
+{
+    int result;
+
+    if ((ws_io == NULL) ||
+        (stats == NULL) ||
+        (stats_count == 0) ||
+        (layer_count == NULL))
+    {
+        /* Codes_SRS_WSIO_01_199: [ If ws_io, stats or layer_count is NULL or stats_count is 0, wsio_get_stats shall fail and return a non-zero value. ]*/
+        LogError("Bad arguments: ws_io=%p, stats=%p, stats_count=%u, layer_count=%p", ws_io, stats, (unsigned int)stats_count, layer_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        WSIO_INSTANCE* wsio_instance = (WSIO_INSTANCE*)ws_io;
+        size_t underlying_layer_count;
+
+        /* Codes_SRS_WSIO_01_200: [ wsio_get_stats shall fill the first entry of stats with the counters of the wsio instance. ]*/
+        stats[0] = wsio_instance->stats;
+
+        /* Codes_SRS_WSIO_01_201: [ If stats_count is greater than 1, wsio_get_stats shall fill the following entries by calling uws_client_get_stats. ]*/
+        if ((stats_count > 1) &&
+            (uws_client_get_stats(wsio_instance->uws, &stats[1], stats_count - 1, &underlying_layer_count) == 0))
+        {
+            *layer_count = 1 + underlying_layer_count;
+        }
+        else
+        {
+            /* Codes_SRS_WSIO_01_202: [ If uws_client_get_stats fails, only the counters of the wsio instance shall be given. ]*/
+            *layer_count = 1;
+        }
+
+        /* Codes_SRS_WSIO_01_203: [ On success wsio_get_stats shall set layer_count to the number of entries filled and return 0. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
 int wsio_setoption(CONCRETE_IO_HANDLE ws_io, const char* optionName, const void* value)
 {
     int result;
@@ -682,6 +925,36 @@ int wsio_setoption(CONCRETE_IO_HANDLE ws_io, const char* optionName, const void*
                 result = 0;
             }
         }
+        else if (strcmp(OPTION_WSIO_SEND_WINDOW, optionName) == 0)
+        {
+            const WSIO_SEND_WINDOW* send_window = (const WSIO_SEND_WINDOW*)value;
+
+            if (send_window == NULL)
+            {
+                /* Codes_SRS_WSIO_01_188: [ If the option name is wsio_send_window and value is NULL, or high_watermark is not zero and low_watermark is not smaller than high_watermark, wsio_setoption shall fail and return a non-zero value. ]*/
+                LogError("NULL value for option %s", optionName);
+                result = __FAILURE__;
+            }
+            else if ((send_window->high_watermark != 0) &&
+                (send_window->low_watermark >= send_window->high_watermark))
+            {
+                /* Codes_SRS_WSIO_01_188: [ If the option name is wsio_send_window and value is NULL, or high_watermark is not zero and low_watermark is not smaller than high_watermark, wsio_setoption shall fail and return a non-zero value. ]*/
+                LogError("Invalid send window: low_watermark=%u, high_watermark=%u",
+                    (unsigned int)send_window->low_watermark, (unsigned int)send_window->high_watermark);
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_WSIO_01_187: [ If the option name is wsio_send_window, wsio_setoption shall store the WSIO_SEND_WINDOW structure pointed to by value. ]*/
+                wsio_instance->send_window = *send_window;
+
+                /* Codes_SRS_WSIO_01_189: [ The new watermarks shall be applied immediately to the bytes already queued. ]*/
+                update_send_window(wsio_instance);
+
+                /* Codes_SRS_WSIO_01_158: [ On success, wsio_setoption shall return 0. ]*/
+                result = 0;
+            }
+        }
         else
         {
             /* Codes_SRS_WSIO_01_156: [ Otherwise all options shall be passed as they are to uws by calling uws_client_set_option. ]*/
@@ -722,6 +995,21 @@ static void* wsio_clone_option(const char* name, const void* value)
             /* Codes_SRS_WSIO_01_171: [** wsio_clone_option called with name being WSIOOptions shall return the same value. ]*/
             result = (void*)value;
         }
+        else if (strcmp(name, OPTION_WSIO_SEND_WINDOW) == 0)
+        {
+            /* Codes_SRS_WSIO_01_214: [ wsio_clone_option called with name being wsio_send_window shall return a newly allocated copy of the WSIO_SEND_WINDOW value. ]*/
+            WSIO_SEND_WINDOW* send_window = (WSIO_SEND_WINDOW*)malloc(sizeof(WSIO_SEND_WINDOW));
+            if (send_window == NULL)
+            {
+                LogError("Cannot allocate memory for the cloned %s option", name);
+            }
+            else
+            {
+                *send_window = *(const WSIO_SEND_WINDOW*)value;
+            }
+
+            result = send_window;
+        }
         else
         {
             /* Codes_SRS_WSIO_01_173: [ wsio_clone_option called with any other option name than WSIOOptions shall return NULL. ]*/
@@ -750,6 +1038,11 @@ static void wsio_destroy_option(const char* name, const void* value)
             /* Codes_SRS_WSIO_01_175: [ wsio_destroy_option called with the option name being WSIOOptions shall destroy the value by calling OptionHandler_Destroy. ]*/
             OptionHandler_Destroy((OPTIONHANDLER_HANDLE)value);
         }
+        else if (strcmp(name, OPTION_WSIO_SEND_WINDOW) == 0)
+        {
+            /* Codes_SRS_WSIO_01_215: [ wsio_destroy_option called with the option name being wsio_send_window shall free the value. ]*/
+            free((void*)value);
+        }
         else
         {
             /* Codes_SRS_WSIO_01_176: [ If wsio_destroy_option is called with any other name it shall do nothing. ]*/
@@ -801,6 +1094,15 @@ OPTIONHANDLER_HANDLE wsio_retrieveoptions(CONCRETE_IO_HANDLE handle)
                     OptionHandler_Destroy(result);
                     result = NULL;
                 }
+                /* Codes_SRS_WSIO_01_198: [ If a send window is configured, wsio_retrieveoptions shall also add the wsio_send_window option. ]*/
+                else if ((wsio->send_window.high_watermark != 0) &&
+                    (OptionHandler_AddOption(result, OPTION_WSIO_SEND_WINDOW, &wsio->send_window) != OPTIONHANDLER_OK))
+                {
+                    /* Codes_SRS_WSIO_01_182: [ If OptionHandler_AddOption fails, uws_client_retrieve_options shall fail and return NULL. ]*/
+                    LogError("unable to OptionHandler_AddOption");
+                    OptionHandler_Destroy(result);
+                    result = NULL;
+                }
             }
         }
     }
@@ -817,7 +1119,13 @@ static const IO_INTERFACE_DESCRIPTION ws_io_interface_description =
     wsio_close,
     wsio_send,
     wsio_dowork,
-    wsio_setoption
+    wsio_setoption,
+    NULL,
+    NULL,
+    wsio_get_stats,
+    wsio_dowork_ex,
+    wsio_get_pollable_handle,
+    NULL
 };
 
 const IO_INTERFACE_DESCRIPTION* wsio_get_interface_description(void)
@@ -3,10 +3,18 @@
 
 #include <stdlib.h>
 #include <stddef.h>
+#include <string.h>
+#include <stdint.h>
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xio.h"
 #include "azure_c_shared_utility/xlogging.h"
+#ifdef XIO_STATS_TIMING
+#include "azure_c_shared_utility/tickcounter.h"
+#endif
+#ifdef XIO_TRACE
+#include "azure_c_shared_utility/xio_trace.h"
+#endif
 
 static const char* CONCRETE_OPTIONS = "concreteOptions";
 
@@ -14,8 +22,153 @@ typedef struct XIO_INSTANCE_TAG
 {
     const IO_INTERFACE_DESCRIPTION* io_interface_description;
     CONCRETE_IO_HANDLE concrete_xio_handle;
+#ifdef XIO_TRACE
+    /* the XIO_STATS layer_name of the concrete IO, read at the first traced send */
+    const char* trace_layer_name;
+#endif
 } XIO_INSTANCE;
 
+#ifdef _MSC_VER
+#pragma warning(disable:4200) /* nonstandard extension used : zero-sized array in struct/union */
+#endif
+
+/* a CONSTBUFFER_ARRAY sent through xio_sendv, kept alive until the send completes */
+typedef struct CONSTBUFFER_ARRAY_SEND_TAG
+{
+    CONSTBUFFER_ARRAY_HANDLE constbuffer_array;
+    ON_SEND_COMPLETE on_send_complete;
+    void* callback_context;
+    XIO_BUFFER buffers[];
+} CONSTBUFFER_ARRAY_SEND;
+
+#ifdef XIO_TRACE
+/* a send that is traced, its span ends when the concrete IO completes it */
+typedef struct XIO_TRACED_SEND_TAG
+{
+    XIO_TRACE_SPAN span;
+    const char* layer_name;
+    const char* operation;
+    ON_SEND_COMPLETE on_send_complete;
+    void* callback_context;
+    /* set while the concrete send call runs, tells it that the send completed from within the call */
+    bool* completed_in_call;
+} XIO_TRACED_SEND;
+
+/* lives on the stack of the traced send call */
+typedef struct XIO_TRACE_CALL_TAG
+{
+    XIO_TRACED_SEND* traced_send;
+    XIO_TRACE_SPAN previous_span;
+    bool completed_in_call;
+} XIO_TRACE_CALL;
+
+static const char* get_trace_layer_name(XIO_INSTANCE* xio_instance)
+{
+    if (xio_instance->trace_layer_name == NULL)
+    {
+        XIO_STATS stats;
+        size_t layer_count;
+
+        if ((xio_instance->io_interface_description->concrete_io_get_stats != NULL) &&
+            (xio_instance->io_interface_description->concrete_io_get_stats(xio_instance->concrete_xio_handle, &stats, 1, &layer_count) == 0) &&
+            (stats.layer_name != NULL))
+        {
+            xio_instance->trace_layer_name = stats.layer_name;
+        }
+        else
+        {
+            xio_instance->trace_layer_name = "xio";
+        }
+    }
+
+    return xio_instance->trace_layer_name;
+}
+
+static void on_traced_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    XIO_TRACED_SEND* traced_send = (XIO_TRACED_SEND*)context;
+    XIO_TRACED_SEND completed_send = *traced_send;
+
+    /* Codes_SRS_XIO_01_066: [ When a traced send completes, the span shall end with send_result, the memory of the traced send shall be freed and on_send_complete shall be called with send_result. ]*/
+    if (traced_send->completed_in_call != NULL)
+    {
+        *traced_send->completed_in_call = true;
+    }
+    free(traced_send);
+
+    XIO_TRACE_END(&completed_send.span, completed_send.layer_name, completed_send.operation, (int)send_result);
+    if (completed_send.on_send_complete != NULL)
+    {
+        completed_send.on_send_complete(completed_send.callback_context, send_result);
+    }
+}
+
+/* replaces on_send_complete and callback_context by the ones of a traced send when tracing is on */
+static void begin_traced_send(XIO_TRACE_CALL* trace_call, XIO_INSTANCE* xio_instance, const char* operation, uint64_t size, ON_SEND_COMPLETE* on_send_complete, void** callback_context)
+{
+    trace_call->traced_send = NULL;
+
+    if (XIO_TRACE_IS_ENABLED())
+    {
+        XIO_TRACED_SEND* traced_send = (XIO_TRACED_SEND*)malloc(sizeof(XIO_TRACED_SEND));
+        if (traced_send == NULL)
+        {
+            /* Codes_SRS_XIO_01_067: [ If allocating the traced send fails, the send shall go on without being traced. ]*/
+            LogError("Failure allocating the traced send, the send is not traced");
+        }
+        else
+        {
+            /* Codes_SRS_XIO_01_064: [ When tracing is on, xio_send, xio_sendv and xio_send_constbuffer_array shall begin a span with the XIO_STATS layer_name of the concrete IO ("xio" if it keeps no counters), the name of the function without xio_ and the number of bytes sent. ]*/
+            traced_send->layer_name = get_trace_layer_name(xio_instance);
+            traced_send->operation = operation;
+            traced_send->on_send_complete = *on_send_complete;
+            traced_send->callback_context = *callback_context;
+            traced_send->completed_in_call = &trace_call->completed_in_call;
+            XIO_TRACE_BEGIN(&traced_send->span, traced_send->layer_name, operation, size);
+
+            if (traced_send->span.span_id == 0)
+            {
+                /* the sink went away */
+                free(traced_send);
+            }
+            else
+            {
+                /* Codes_SRS_XIO_01_065: [ The span shall be the current span of the thread while the concrete IO is called, and the concrete IO shall be given a callback that ends it. ]*/
+                trace_call->traced_send = traced_send;
+                trace_call->completed_in_call = false;
+                XIO_TRACE_ENTER(&traced_send->span, trace_call->previous_span);
+                *on_send_complete = on_traced_send_complete;
+                *callback_context = traced_send;
+            }
+        }
+    }
+}
+
+static void end_traced_send(XIO_TRACE_CALL* trace_call, int send_result)
+{
+    XIO_TRACED_SEND* traced_send = trace_call->traced_send;
+
+    if (traced_send != NULL)
+    {
+        xio_trace_leave(trace_call->previous_span);
+
+        if (!trace_call->completed_in_call)
+        {
+            if (send_result != 0)
+            {
+                /* Codes_SRS_XIO_01_068: [ If the concrete IO fails the send, the span shall end with IO_SEND_ERROR and the memory of the traced send shall be freed. ]*/
+                XIO_TRACE_END(&traced_send->span, traced_send->layer_name, traced_send->operation, (int)IO_SEND_ERROR);
+                free(traced_send);
+            }
+            else
+            {
+                traced_send->completed_in_call = NULL;
+            }
+        }
+    }
+}
+#endif
+
 XIO_HANDLE xio_create(const IO_INTERFACE_DESCRIPTION* io_interface_description, const void* xio_create_parameters)
 {
     XIO_INSTANCE* xio_instance;
@@ -42,6 +195,9 @@ XIO_HANDLE xio_create(const IO_INTERFACE_DESCRIPTION* io_interface_description,
         {
             /* Codes_SRS_XIO_01_001: [xio_create shall return on success a non-NULL handle to a new IO interface.] */
             xio_instance->io_interface_description = io_interface_description;
+#ifdef XIO_TRACE
+            xio_instance->trace_layer_name = NULL;
+#endif
 
             /* Codes_SRS_XIO_01_002: [In order to instantiate the concrete IO implementation the function concrete_io_create from the io_interface_description shall be called, passing the xio_create_parameters argument.] */
             xio_instance->concrete_xio_handle = xio_instance->io_interface_description->concrete_io_create((void*)xio_create_parameters);
@@ -143,12 +299,262 @@ int xio_send(XIO_HANDLE xio, const void* buffer, size_t size, ON_SEND_COMPLETE o
     else
     {
         XIO_INSTANCE* xio_instance = (XIO_INSTANCE*)xio;
+#ifdef XIO_TRACE
+        XIO_TRACE_CALL trace_call;
+        begin_traced_send(&trace_call, xio_instance, "send", size, &on_send_complete, &callback_context);
+#endif
 
         /* Codes_SRS_XIO_01_008: [xio_send shall pass the sequence of bytes pointed to by buffer to the concrete IO implementation specified in xio_create, by calling the concrete_io_send function while passing down the buffer and size arguments to it.] */
         /* Codes_SRS_XIO_01_009: [On success, xio_send shall return 0.] */
         /* Codes_SRS_XIO_01_015: [If the underlying concrete_io_send fails, xio_send shall return a non-zero value.] */
         /* Codes_SRS_XIO_01_027: [xio_send shall pass to the concrete_io_send function the on_send_complete and callback_context arguments.] */
         result = xio_instance->io_interface_description->concrete_io_send(xio_instance->concrete_xio_handle, buffer, size, on_send_complete, callback_context);
+#ifdef XIO_TRACE
+        end_traced_send(&trace_call, result);
+#endif
+    }
+
+    return result;
+}
+
+static int send_coalesced(XIO_INSTANCE* xio_instance, const XIO_BUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+    size_t total_size = 0;
+    size_t i;
+
+    for (i = 0; i < buffer_count; i++)
+    {
+        total_size += buffers[i].size;
+    }
+
+    if (total_size == 0)
+    {
+        /* Codes_SRS_XIO_01_036: [If the total size of all buffers is 0, xio_sendv shall call concrete_io_send with a NULL buffer and a size of 0.] */
+        result = xio_instance->io_interface_description->concrete_io_send(xio_instance->concrete_xio_handle, NULL, 0, on_send_complete, callback_context);
+    }
+    else
+    {
+        /* Codes_SRS_XIO_01_035: [If concrete_io_sendv is NULL and buffer_count is greater than 1, xio_sendv shall copy all buffers in order into one allocation and call concrete_io_send with it, then free the allocation.] */
+        unsigned char* coalesced = (unsigned char*)malloc(total_size);
+        if (coalesced == NULL)
+        {
+            /* Codes_SRS_XIO_01_037: [If allocating the coalesced buffer fails, xio_sendv shall return a non-zero value.] */
+            LogError("Failure allocating %lu bytes to coalesce the send buffers", (unsigned long)total_size);
+            result = __FAILURE__;
+        }
+        else
+        {
+            size_t offset = 0;
+
+            for (i = 0; i < buffer_count; i++)
+            {
+                if (buffers[i].size > 0)
+                {
+                    (void)memcpy(coalesced + offset, buffers[i].buffer, buffers[i].size);
+                    offset += buffers[i].size;
+                }
+            }
+
+            result = xio_instance->io_interface_description->concrete_io_send(xio_instance->concrete_xio_handle, coalesced, total_size, on_send_complete, callback_context);
+            free(coalesced);
+        }
+    }
+
+    return result;
+}
+
+static int send_buffers(XIO_INSTANCE* xio_instance, const XIO_BUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    if (xio_instance->io_interface_description->concrete_io_sendv != NULL)
+    {
+        /* Codes_SRS_XIO_01_033: [If the concrete IO implements concrete_io_sendv, xio_sendv shall pass all arguments down to it and return its result.] */
+        result = xio_instance->io_interface_description->concrete_io_sendv(xio_instance->concrete_xio_handle, buffers, buffer_count, on_send_complete, callback_context);
+    }
+    else if (buffer_count == 1)
+    {
+        /* Codes_SRS_XIO_01_034: [If concrete_io_sendv is NULL and buffer_count is 1, xio_sendv shall call concrete_io_send with the only buffer, without copying it.] */
+        result = xio_instance->io_interface_description->concrete_io_send(xio_instance->concrete_xio_handle, buffers[0].buffer, buffers[0].size, on_send_complete, callback_context);
+    }
+    else
+    {
+        result = send_coalesced(xio_instance, buffers, buffer_count, on_send_complete, callback_context);
+    }
+
+    return result;
+}
+
+#ifdef XIO_TRACE
+static uint64_t get_buffers_size(const XIO_BUFFER* buffers, size_t buffer_count)
+{
+    uint64_t result = 0;
+    size_t i;
+
+    for (i = 0; i < buffer_count; i++)
+    {
+        result += buffers[i].size;
+    }
+
+    return result;
+}
+#endif
+
+int xio_sendv(XIO_HANDLE xio, const XIO_BUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    /* Codes_SRS_XIO_01_032: [If the argument xio is NULL or buffers is NULL or buffer_count is 0, xio_sendv shall return a non-zero value.] */
+    if ((xio == NULL) ||
+        (buffers == NULL) ||
+        (buffer_count == 0))
+    {
+        LogError("Invalid arguments: XIO_HANDLE xio=%p, const XIO_BUFFER* buffers=%p, size_t buffer_count=%lu", xio, buffers, (unsigned long)buffer_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        XIO_INSTANCE* xio_instance = (XIO_INSTANCE*)xio;
+#ifdef XIO_TRACE
+        XIO_TRACE_CALL trace_call;
+        begin_traced_send(&trace_call, xio_instance, "sendv", XIO_TRACE_IS_ENABLED() ? get_buffers_size(buffers, buffer_count) : 0, &on_send_complete, &callback_context);
+#endif
+
+        result = send_buffers(xio_instance, buffers, buffer_count, on_send_complete, callback_context);
+#ifdef XIO_TRACE
+        end_traced_send(&trace_call, result);
+#endif
+    }
+
+    return result;
+}
+
+/* returns 0 when the size does not fit in a size_t */
+static size_t get_constbuffer_array_send_size(uint32_t buffer_count)
+{
+    size_t result;
+#if SIZE_MAX <= UINT32_MAX
+    if (buffer_count > (SIZE_MAX - sizeof(CONSTBUFFER_ARRAY_SEND)) / sizeof(XIO_BUFFER))
+    {
+        LogError("Too many buffers: %lu", (unsigned long)buffer_count);
+        result = 0;
+    }
+    else
+#endif
+    {
+        result = sizeof(CONSTBUFFER_ARRAY_SEND) + ((size_t)buffer_count * sizeof(XIO_BUFFER));
+    }
+    return result;
+}
+
+static void on_constbuffer_array_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    CONSTBUFFER_ARRAY_SEND* constbuffer_array_send = (CONSTBUFFER_ARRAY_SEND*)context;
+    ON_SEND_COMPLETE on_send_complete = constbuffer_array_send->on_send_complete;
+    void* callback_context = constbuffer_array_send->callback_context;
+
+    /* Codes_SRS_XIO_01_045: [When the send completes, xio_send_constbuffer_array shall dec_ref constbuffer_array, free the allocated memory and call on_send_complete with send_result.] */
+    constbuffer_array_dec_ref(constbuffer_array_send->constbuffer_array);
+    free(constbuffer_array_send);
+
+    if (on_send_complete != NULL)
+    {
+        on_send_complete(callback_context, send_result);
+    }
+}
+
+int xio_send_constbuffer_array(XIO_HANDLE xio, CONSTBUFFER_ARRAY_HANDLE constbuffer_array, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    int result;
+
+    /* Codes_SRS_XIO_01_038: [If the argument xio is NULL or constbuffer_array is NULL, xio_send_constbuffer_array shall return a non-zero value.] */
+    if ((xio == NULL) ||
+        (constbuffer_array == NULL))
+    {
+        LogError("Invalid arguments: XIO_HANDLE xio=%p, CONSTBUFFER_ARRAY_HANDLE constbuffer_array=%p", xio, constbuffer_array);
+        result = __FAILURE__;
+    }
+    else
+    {
+        XIO_INSTANCE* xio_instance = (XIO_INSTANCE*)xio;
+        uint32_t buffer_count;
+#ifdef XIO_TRACE
+        XIO_TRACE_CALL trace_call;
+        uint32_t all_buffers_size = 0;
+
+        if (XIO_TRACE_IS_ENABLED() &&
+            (constbuffer_array_get_all_buffers_size(constbuffer_array, &all_buffers_size) != 0))
+        {
+            all_buffers_size = 0;
+        }
+        begin_traced_send(&trace_call, xio_instance, "send_constbuffer_array", all_buffers_size, &on_send_complete, &callback_context);
+#endif
+
+        if (xio_instance->io_interface_description->concrete_io_send_constbuffer_array != NULL)
+        {
+            /* Codes_SRS_XIO_01_039: [If the concrete IO implements concrete_io_send_constbuffer_array, xio_send_constbuffer_array shall pass all arguments down to it and return its result.] */
+            result = xio_instance->io_interface_description->concrete_io_send_constbuffer_array(xio_instance->concrete_xio_handle, constbuffer_array, on_send_complete, callback_context);
+        }
+        else if (constbuffer_array_get_buffer_count(constbuffer_array, &buffer_count) != 0)
+        {
+            /* Codes_SRS_XIO_01_046: [If any failure occurs, xio_send_constbuffer_array shall return a non-zero value.] */
+            LogError("Failure getting the buffer count");
+            result = __FAILURE__;
+        }
+        else if (buffer_count == 0)
+        {
+            /* Codes_SRS_XIO_01_040: [If constbuffer_array has no buffers, xio_send_constbuffer_array shall call concrete_io_send with a NULL buffer and a size of 0.] */
+            result = xio_instance->io_interface_description->concrete_io_send(xio_instance->concrete_xio_handle, NULL, 0, on_send_complete, callback_context);
+        }
+        else
+        {
+            /* Codes_SRS_XIO_01_041: [Otherwise xio_send_constbuffer_array shall allocate memory to hold constbuffer_array, on_send_complete, callback_context and one XIO_BUFFER for each buffer of constbuffer_array.] */
+            size_t send_size = get_constbuffer_array_send_size(buffer_count);
+            CONSTBUFFER_ARRAY_SEND* constbuffer_array_send = (send_size == 0) ? NULL : (CONSTBUFFER_ARRAY_SEND*)malloc(send_size);
+            if (constbuffer_array_send == NULL)
+            {
+                /* Codes_SRS_XIO_01_046: [If any failure occurs, xio_send_constbuffer_array shall return a non-zero value.] */
+                LogError("Failure allocating the send context for %lu buffers", (unsigned long)buffer_count);
+                result = __FAILURE__;
+            }
+            else
+            {
+                uint32_t i;
+
+                /* Codes_SRS_XIO_01_042: [xio_send_constbuffer_array shall point each XIO_BUFFER at the content of the matching buffer, without copying it.] */
+                for (i = 0; i < buffer_count; i++)
+                {
+                    const CONSTBUFFER* content = constbuffer_array_get_buffer_content(constbuffer_array, i);
+                    constbuffer_array_send->buffers[i].buffer = content->buffer;
+                    constbuffer_array_send->buffers[i].size = content->size;
+                }
+
+                /* Codes_SRS_XIO_01_043: [xio_send_constbuffer_array shall inc_ref constbuffer_array, so that the buffers stay alive until the send completes.] */
+                constbuffer_array_inc_ref(constbuffer_array);
+                constbuffer_array_send->constbuffer_array = constbuffer_array;
+                constbuffer_array_send->on_send_complete = on_send_complete;
+                constbuffer_array_send->callback_context = callback_context;
+
+                /* Codes_SRS_XIO_01_044: [xio_send_constbuffer_array shall send the XIO_BUFFERs with xio_sendv.] */
+                if (send_buffers(xio_instance, constbuffer_array_send->buffers, buffer_count, on_constbuffer_array_send_complete, constbuffer_array_send) != 0)
+                {
+                    /* Codes_SRS_XIO_01_047: [If xio_sendv fails, xio_send_constbuffer_array shall dec_ref constbuffer_array, free the allocated memory and return a non-zero value.] */
+                    LogError("xio_sendv failed");
+                    constbuffer_array_dec_ref(constbuffer_array);
+                    free(constbuffer_array_send);
+                    result = __FAILURE__;
+                }
+                else
+                {
+                    /* Codes_SRS_XIO_01_048: [On success, xio_send_constbuffer_array shall return 0.] */
+                    result = 0;
+                }
+            }
+        }
+#ifdef XIO_TRACE
+        end_traced_send(&trace_call, result);
+#endif
     }
 
     return result;
@@ -166,6 +572,47 @@ void xio_dowork(XIO_HANDLE xio)
     }
 }
 
+int xio_dowork_ex(XIO_HANDLE xio, bool* made_progress, uint64_t* next_deadline_us)
+{
+    int result;
+
+    /* Codes_SRS_XIO_01_054: [ If xio, made_progress or next_deadline_us is NULL, xio_dowork_ex shall fail and return a non-zero value. ]*/
+    if ((xio == NULL) ||
+        (made_progress == NULL) ||
+        (next_deadline_us == NULL))
+    {
+        LogError("invalid argument detected: XIO_HANDLE xio=%p, bool* made_progress=%p, uint64_t* next_deadline_us=%p", xio, made_progress, next_deadline_us);
+        result = __FAILURE__;
+    }
+    else
+    {
+        XIO_INSTANCE* xio_instance = (XIO_INSTANCE*)xio;
+
+        if (xio_instance->io_interface_description->concrete_io_dowork_ex == NULL)
+        {
+            /* Codes_SRS_XIO_01_055: [ If the concrete IO does not implement concrete_io_dowork_ex, xio_dowork_ex shall call concrete_io_dowork, set made_progress to true, as it cannot tell that no work was done, and set next_deadline_us to XIO_NO_DEADLINE. ]*/
+            xio_instance->io_interface_description->concrete_io_dowork(xio_instance->concrete_xio_handle);
+            *made_progress = true;
+            *next_deadline_us = XIO_NO_DEADLINE;
+            result = 0;
+        }
+        /* Codes_SRS_XIO_01_056: [ xio_dowork_ex shall pass all arguments down to concrete_io_dowork_ex. ]*/
+        else if (xio_instance->io_interface_description->concrete_io_dowork_ex(xio_instance->concrete_xio_handle, made_progress, next_deadline_us) != 0)
+        {
+            /* Codes_SRS_XIO_01_057: [ If concrete_io_dowork_ex fails, xio_dowork_ex shall fail and return a non-zero value. ]*/
+            LogError("concrete_io_dowork_ex failed");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_XIO_01_058: [ On success, xio_dowork_ex shall return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
 int xio_setoption(XIO_HANDLE xio, const char* optionName, const void* value)
 {
     int result;
@@ -301,3 +748,133 @@ OPTIONHANDLER_HANDLE xio_retrieveoptions(XIO_HANDLE xio)
     return result;
 }
 
+int xio_get_stats(XIO_HANDLE xio, XIO_STATS* stats, size_t stats_count, size_t* layer_count)
+{
+    int result;
+
+    /* Codes_SRS_XIO_01_049: [ If xio, stats or layer_count is NULL or stats_count is 0, xio_get_stats shall fail and return a non-zero value. ]*/
+    if ((xio == NULL) ||
+        (stats == NULL) ||
+        (stats_count == 0) ||
+        (layer_count == NULL))
+    {
+        LogError("invalid argument detected: XIO_HANDLE xio=%p, XIO_STATS* stats=%p, size_t stats_count=%lu, size_t* layer_count=%p", xio, stats, (unsigned long)stats_count, layer_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        XIO_INSTANCE* xio_instance = (XIO_INSTANCE*)xio;
+
+        /* Codes_SRS_XIO_01_050: [ If the concrete IO does not implement concrete_io_get_stats, xio_get_stats shall fail and return a non-zero value. ]*/
+        if (xio_instance->io_interface_description->concrete_io_get_stats == NULL)
+        {
+            LogError("the concrete IO does not keep counters");
+            result = __FAILURE__;
+        }
+        /* Codes_SRS_XIO_01_051: [ xio_get_stats shall pass all arguments down to concrete_io_get_stats. ]*/
+        else if (xio_instance->io_interface_description->concrete_io_get_stats(xio_instance->concrete_xio_handle, stats, stats_count, layer_count) != 0)
+        {
+            /* Codes_SRS_XIO_01_052: [ If concrete_io_get_stats fails, xio_get_stats shall fail and return a non-zero value. ]*/
+            LogError("concrete_io_get_stats failed");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_XIO_01_053: [ On success, xio_get_stats shall return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int xio_get_pollable_handle(XIO_HANDLE xio, intptr_t* pollable_handle, unsigned int* wanted_events)
+{
+    int result;
+
+    /* Codes_SRS_XIO_01_059: [ If xio, pollable_handle or wanted_events is NULL, xio_get_pollable_handle shall fail and return a non-zero value. ]*/
+    if ((xio == NULL) ||
+        (pollable_handle == NULL) ||
+        (wanted_events == NULL))
+    {
+        LogError("invalid argument detected: XIO_HANDLE xio=%p, intptr_t* pollable_handle=%p, unsigned int* wanted_events=%p", xio, pollable_handle, wanted_events);
+        result = __FAILURE__;
+    }
+    else
+    {
+        XIO_INSTANCE* xio_instance = (XIO_INSTANCE*)xio;
+
+        /* Codes_SRS_XIO_01_060: [ If the concrete IO does not implement concrete_io_get_pollable_handle, xio_get_pollable_handle shall fail and return a non-zero value. ]*/
+        if (xio_instance->io_interface_description->concrete_io_get_pollable_handle == NULL)
+        {
+            LogError("the concrete IO does not expose a pollable handle");
+            result = __FAILURE__;
+        }
+        /* Codes_SRS_XIO_01_061: [ xio_get_pollable_handle shall pass all arguments down to concrete_io_get_pollable_handle. ]*/
+        else if (xio_instance->io_interface_description->concrete_io_get_pollable_handle(xio_instance->concrete_xio_handle, pollable_handle, wanted_events) != 0)
+        {
+            /* Codes_SRS_XIO_01_062: [ If concrete_io_get_pollable_handle fails, xio_get_pollable_handle shall fail and return a non-zero value. ]*/
+            LogError("concrete_io_get_pollable_handle failed");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_XIO_01_063: [ On success, xio_get_pollable_handle shall return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+int xio_set_receive_buffer(XIO_HANDLE xio, unsigned char* buffer, size_t size)
+{
+    int result;
+
+    /* Codes_SRS_XIO_01_069: [ If xio is NULL, or only one of buffer and size is NULL or 0, xio_set_receive_buffer shall fail and return a non-zero value. ]*/
+    if ((xio == NULL) ||
+        ((buffer == NULL) != (size == 0)))
+    {
+        LogError("invalid argument detected: XIO_HANDLE xio=%p, unsigned char* buffer=%p, size_t size=%lu", xio, buffer, (unsigned long)size);
+        result = __FAILURE__;
+    }
+    else
+    {
+        XIO_INSTANCE* xio_instance = (XIO_INSTANCE*)xio;
+
+        /* Codes_SRS_XIO_01_070: [ If the concrete IO does not implement concrete_io_set_receive_buffer, xio_set_receive_buffer shall fail and return a non-zero value. ]*/
+        if (xio_instance->io_interface_description->concrete_io_set_receive_buffer == NULL)
+        {
+            LogError("the concrete IO does not read into a lent buffer");
+            result = __FAILURE__;
+        }
+        /* Codes_SRS_XIO_01_071: [ xio_set_receive_buffer shall pass all arguments down to concrete_io_set_receive_buffer. ]*/
+        else if (xio_instance->io_interface_description->concrete_io_set_receive_buffer(xio_instance->concrete_xio_handle, buffer, size) != 0)
+        {
+            /* Codes_SRS_XIO_01_072: [ If concrete_io_set_receive_buffer fails, xio_set_receive_buffer shall fail and return a non-zero value. ]*/
+            LogError("concrete_io_set_receive_buffer failed");
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_XIO_01_073: [ On success, xio_set_receive_buffer shall return 0. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+#ifdef XIO_STATS_TIMING
+uint64_t xio_stats_get_time_us(void)
+{
+    tickcounter_us_t now_us;
+
+    if (tickcounter_get_monotonic_us(&now_us) != 0)
+    {
+        now_us = 0;
+    }
+
+    return (uint64_t)now_us;
+}
+#endif
@@ -0,0 +1,922 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xio_reactor_group.h"
+#include "azure_c_shared_utility/socket_reactor.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/doublylinkedlist.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+/*
+* The group lock only guards the request lists, the holder of each connection and the loads.
+* The connection lists and everything done to the IO stacks belong to the reactor threads.
+* All the requests for a connection are in the request list of its holder, in the order they
+* were made: a migration makes the target the holder and moves them there behind the adopt
+* request, so the target runs them once the connection is on it.
+*/
+
+/* the longest a reactor waits without a deadline, which bounds how stale its busy_percent gets */
+#define XIO_REACTOR_GROUP_MAX_WAIT_MS       1000
+/* the longest a reactor waits while it works a connection not on its socket reactor */
+#define XIO_REACTOR_GROUP_POLL_INTERVAL_MS  10
+#define XIO_REACTOR_GROUP_LOAD_WINDOW_US    1000000
+/* the processors a THREAD_ATTRIBUTES affinity mask can name */
+#define XIO_REACTOR_GROUP_MAX_PINNED        64
+
+typedef enum XIO_REACTOR_REQUEST_TYPE_TAG
+{
+    XIO_REACTOR_REQUEST_ADD,
+    XIO_REACTOR_REQUEST_CALL,
+    XIO_REACTOR_REQUEST_MIGRATE,
+    XIO_REACTOR_REQUEST_ADOPT,
+    XIO_REACTOR_REQUEST_REMOVE,
+    XIO_REACTOR_REQUEST_STOP
+} XIO_REACTOR_REQUEST_TYPE;
+
+typedef struct XIO_REACTOR_REQUEST_TAG
+{
+    DLIST_ENTRY link;
+    XIO_REACTOR_REQUEST_TYPE type;
+    struct XIO_REACTOR_CONNECTION_TAG* connection;
+    ON_XIO_REACTOR_CALL on_call;
+    void* on_call_context;
+    /* for a migration: its target and the request the target gets, allocated up front */
+    size_t reactor_index;
+    struct XIO_REACTOR_REQUEST_TAG* adopt_request;
+} XIO_REACTOR_REQUEST;
+
+typedef struct XIO_REACTOR_TAG
+{
+    struct XIO_REACTOR_GROUP_TAG* group;
+    size_t index;
+    THREAD_HANDLE thread;
+    SOCKET_REACTOR_HANDLE socket_reactor;
+    /* under the group lock */
+    DLIST_ENTRY requests;
+    XIO_REACTOR_LOAD load;
+    /* only touched by the reactor thread */
+    DLIST_ENTRY connections;
+    size_t polled_count;
+    XIO_REACTOR_REQUEST stop_request;
+} XIO_REACTOR;
+
+typedef struct XIO_REACTOR_CONNECTION_TAG
+{
+    struct XIO_REACTOR_GROUP_TAG* group;
+    XIO_HANDLE xio;
+    /* under the group lock: the reactor getting its requests, and the one its load is counted on */
+    XIO_REACTOR* holder;
+    XIO_REACTOR* counted_on;
+    /* only touched by the reactor thread working it */
+    DLIST_ENTRY link;
+    bool polled;
+} XIO_REACTOR_CONNECTION;
+
+typedef struct XIO_REACTOR_GROUP_TAG
+{
+    XIO_REACTOR* reactors;
+    size_t reactor_count;
+    size_t processor_count;
+    bool pin_reactors;
+    LOCK_HANDLE lock;
+} XIO_REACTOR_GROUP;
+
+static size_t get_processor_count(void)
+{
+    long result;
+
+#if defined(_WIN32)
+    SYSTEM_INFO system_info;
+    GetSystemInfo(&system_info);
+    result = (long)system_info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+    result = sysconf(_SC_NPROCESSORS_ONLN);
+#else
+    result = 1;
+#endif
+
+    return (result < 1) ? 1 : (size_t)result;
+}
+
+static XIO_REACTOR_REQUEST* create_request(XIO_REACTOR_REQUEST_TYPE type, XIO_REACTOR_CONNECTION* connection, ON_XIO_REACTOR_CALL on_call, void* on_call_context)
+{
+    XIO_REACTOR_REQUEST* result = (XIO_REACTOR_REQUEST*)malloc(sizeof(XIO_REACTOR_REQUEST));
+    if (result == NULL)
+    {
+        LogError("failure in malloc(sizeof(XIO_REACTOR_REQUEST)=%lu)", (unsigned long)sizeof(XIO_REACTOR_REQUEST));
+    }
+    else
+    {
+        result->type = type;
+        result->connection = connection;
+        result->on_call = on_call;
+        result->on_call_context = on_call_context;
+        result->reactor_index = 0;
+        result->adopt_request = NULL;
+    }
+
+    return result;
+}
+
+static void free_request(XIO_REACTOR_REQUEST* request)
+{
+    if (request->type != XIO_REACTOR_REQUEST_STOP)
+    {
+        free(request->adopt_request);
+        free(request);
+    }
+}
+
+static void wake_reactor(XIO_REACTOR* reactor)
+{
+    if (socket_reactor_wake(reactor->socket_reactor) != 0)
+    {
+        /* the request still runs, after the wait the reactor is in */
+        LogError("failure in socket_reactor_wake for reactor %lu", (unsigned long)reactor->index);
+    }
+}
+
+/* queues a request behind the ones already made for its connection */
+static int post_request(XIO_REACTOR_GROUP* group, XIO_REACTOR_REQUEST* request)
+{
+    int result;
+
+    if (Lock(group->lock) != LOCK_OK)
+    {
+        LogError("failure in Lock");
+        result = __FAILURE__;
+    }
+    else
+    {
+        XIO_REACTOR* reactor = request->connection->holder;
+
+        if (request->type == XIO_REACTOR_REQUEST_MIGRATE)
+        {
+            request->connection->counted_on->load.connection_count--;
+            request->connection->counted_on = &group->reactors[request->reactor_index];
+            request->connection->counted_on->load.connection_count++;
+        }
+        else if (request->type == XIO_REACTOR_REQUEST_REMOVE)
+        {
+            request->connection->counted_on->load.connection_count--;
+        }
+
+        DList_InsertTailList(&reactor->requests, &request->link);
+        (void)Unlock(group->lock);
+
+        wake_reactor(reactor);
+        result = 0;
+    }
+
+    return result;
+}
+
+static XIO_REACTOR_REQUEST* take_request(XIO_REACTOR* reactor)
+{
+    XIO_REACTOR_REQUEST* result;
+
+    if (Lock(reactor->group->lock) != LOCK_OK)
+    {
+        /* the requests stay queued, the next pass takes them */
+        LogError("failure in Lock");
+        result = NULL;
+    }
+    else
+    {
+        if (DList_IsListEmpty(&reactor->requests))
+        {
+            result = NULL;
+        }
+        else
+        {
+            result = containingRecord(DList_RemoveHeadList(&reactor->requests), XIO_REACTOR_REQUEST, link);
+        }
+
+        (void)Unlock(reactor->group->lock);
+    }
+
+    return result;
+}
+
+static void attach_connection(XIO_REACTOR* reactor, XIO_REACTOR_CONNECTION* connection)
+{
+    if (xio_setoption(connection->xio, OPTION_SOCKET_REACTOR, reactor->socket_reactor) != 0)
+    {
+        LogInfo("The IO stack does not take %s, reactor %lu polls it", OPTION_SOCKET_REACTOR, (unsigned long)reactor->index);
+        connection->polled = true;
+        reactor->polled_count++;
+    }
+    else
+    {
+        connection->polled = false;
+    }
+
+    DList_InsertTailList(&reactor->connections, &connection->link);
+}
+
+static void detach_connection(XIO_REACTOR* reactor, XIO_REACTOR_CONNECTION* connection)
+{
+    (void)DList_RemoveEntryList(&connection->link);
+
+    if (connection->polled)
+    {
+        reactor->polled_count--;
+    }
+}
+
+static void hand_off_connection(XIO_REACTOR* reactor, XIO_REACTOR_REQUEST* request)
+{
+    XIO_REACTOR_CONNECTION* connection = request->connection;
+    XIO_REACTOR* target = &reactor->group->reactors[request->reactor_index];
+    XIO_REACTOR_REQUEST* adopt_request = request->adopt_request;
+
+    request->adopt_request = NULL;
+    detach_connection(reactor, connection);
+
+    if (Lock(reactor->group->lock) != LOCK_OK)
+    {
+        /* the connection cannot leave without its requests, it stays on this reactor */
+        LogError("failure in Lock, connection stays on reactor %lu", (unsigned long)reactor->index);
+        attach_connection(reactor, connection);
+        free(adopt_request);
+    }
+    else
+    {
+        PDLIST_ENTRY entry = reactor->requests.Flink;
+
+        connection->holder = target;
+        DList_InsertTailList(&target->requests, &adopt_request->link);
+
+        while (entry != &reactor->requests)
+        {
+            PDLIST_ENTRY next_entry = entry->Flink;
+            if (containingRecord(entry, XIO_REACTOR_REQUEST, link)->connection == connection)
+            {
+                (void)DList_RemoveEntryList(entry);
+                DList_InsertTailList(&target->requests, entry);
+            }
+            entry = next_entry;
+        }
+
+        (void)Unlock(reactor->group->lock);
+
+        wake_reactor(target);
+    }
+}
+
+static void remove_connection(XIO_REACTOR* reactor, XIO_REACTOR_CONNECTION* connection)
+{
+    detach_connection(reactor, connection);
+
+    /* a polled connection may still be on the socket reactor it was put on before it migrated */
+    if ((xio_setoption(connection->xio, OPTION_SOCKET_REACTOR, NULL) != 0) &&
+        (!connection->polled))
+    {
+        LogError("failure taking the IO stack off the socket reactor of reactor %lu", (unsigned long)reactor->index);
+    }
+
+    if (Lock(reactor->group->lock) != LOCK_OK)
+    {
+        LogError("failure in Lock");
+    }
+    else
+    {
+        /* whatever was asked for the connection after its removal is dropped */
+        PDLIST_ENTRY entry = reactor->requests.Flink;
+
+        while (entry != &reactor->requests)
+        {
+            PDLIST_ENTRY next_entry = entry->Flink;
+            XIO_REACTOR_REQUEST* request = containingRecord(entry, XIO_REACTOR_REQUEST, link);
+            if (request->connection == connection)
+            {
+                LogError("A request was made for a connection after its removal, it is dropped");
+                (void)DList_RemoveEntryList(entry);
+                free_request(request);
+            }
+            entry = next_entry;
+        }
+
+        (void)Unlock(reactor->group->lock);
+    }
+}
+
+/* returns false for the stop request */
+static bool run_request(XIO_REACTOR* reactor, XIO_REACTOR_REQUEST* request)
+{
+    bool result = true;
+    XIO_REACTOR_CONNECTION* connection = request->connection;
+
+    switch (request->type)
+    {
+    case XIO_REACTOR_REQUEST_ADD:
+        attach_connection(reactor, connection);
+        if (request->on_call != NULL)
+        {
+            request->on_call(request->on_call_context, connection->xio);
+        }
+        break;
+
+    case XIO_REACTOR_REQUEST_ADOPT:
+        attach_connection(reactor, connection);
+        break;
+
+    case XIO_REACTOR_REQUEST_CALL:
+        request->on_call(request->on_call_context, connection->xio);
+        break;
+
+    case XIO_REACTOR_REQUEST_MIGRATE:
+        if (request->reactor_index != reactor->index)
+        {
+            hand_off_connection(reactor, request);
+        }
+        break;
+
+    case XIO_REACTOR_REQUEST_REMOVE:
+        remove_connection(reactor, connection);
+        if (request->on_call != NULL)
+        {
+            request->on_call(request->on_call_context, connection->xio);
+        }
+        free(connection);
+        break;
+
+    case XIO_REACTOR_REQUEST_STOP:
+        result = false;
+        break;
+    }
+
+    free_request(request);
+
+    return result;
+}
+
+/* returns the longest the reactor may wait before working its connections again */
+static unsigned int work_connections(XIO_REACTOR* reactor)
+{
+    unsigned int result;
+    bool made_progress = false;
+    uint64_t next_deadline_us = XIO_NO_DEADLINE;
+    PDLIST_ENTRY entry = reactor->connections.Flink;
+
+    while (entry != &reactor->connections)
+    {
+        XIO_REACTOR_CONNECTION* connection = containingRecord(entry, XIO_REACTOR_CONNECTION, link);
+        bool connection_made_progress;
+        uint64_t connection_deadline_us;
+
+        /* the callbacks of the connection only queue requests, the list does not change meanwhile */
+        if (xio_dowork_ex(connection->xio, &connection_made_progress, &connection_deadline_us) != 0)
+        {
+            LogError("failure in xio_dowork_ex");
+        }
+        else
+        {
+            made_progress = made_progress || connection_made_progress;
+            if (connection_deadline_us < next_deadline_us)
+            {
+                next_deadline_us = connection_deadline_us;
+            }
+        }
+
+        entry = entry->Flink;
+    }
+
+    if (made_progress)
+    {
+        /* a layer may hold bytes it read already, the connections are worked again right away */
+        result = 0;
+    }
+    else
+    {
+        tickcounter_us_t now_us;
+
+        result = (reactor->polled_count > 0) ? XIO_REACTOR_GROUP_POLL_INTERVAL_MS : XIO_REACTOR_GROUP_MAX_WAIT_MS;
+
+        if ((next_deadline_us != XIO_NO_DEADLINE) &&
+            (tickcounter_get_monotonic_us(&now_us) == 0))
+        {
+            if (next_deadline_us <= now_us)
+            {
+                result = 0;
+            }
+            else if ((next_deadline_us - now_us) < (uint64_t)result * 1000)
+            {
+                result = (unsigned int)((next_deadline_us - now_us + 999) / 1000);
+            }
+        }
+    }
+
+    return result;
+}
+
+static void update_load(XIO_REACTOR* reactor, uint64_t busy_us, uint64_t window_us)
+{
+    if (Lock(reactor->group->lock) != LOCK_OK)
+    {
+        LogError("failure in Lock");
+    }
+    else
+    {
+        reactor->load.busy_percent = (unsigned int)((busy_us * 100) / window_us);
+        (void)Unlock(reactor->group->lock);
+    }
+}
+
+static int reactor_thread(void* argument)
+{
+    XIO_REACTOR* reactor = (XIO_REACTOR*)argument;
+    bool running = true;
+    tickcounter_us_t window_start_us;
+    uint64_t busy_us = 0;
+
+    if (tickcounter_get_monotonic_us(&window_start_us) != 0)
+    {
+        window_start_us = 0;
+    }
+
+    while (running)
+    {
+        XIO_REACTOR_REQUEST* request;
+        tickcounter_us_t work_start_us;
+        tickcounter_us_t work_end_us;
+        unsigned int wait_ms;
+
+        if (tickcounter_get_monotonic_us(&work_start_us) != 0)
+        {
+            work_start_us = window_start_us;
+        }
+
+        while (running && ((request = take_request(reactor)) != NULL))
+        {
+            running = run_request(reactor, request);
+        }
+
+        if (running)
+        {
+            wait_ms = work_connections(reactor);
+
+            if (tickcounter_get_monotonic_us(&work_end_us) != 0)
+            {
+                work_end_us = work_start_us;
+            }
+
+            busy_us += work_end_us - work_start_us;
+            if (work_end_us - window_start_us >= XIO_REACTOR_GROUP_LOAD_WINDOW_US)
+            {
+                update_load(reactor, busy_us, work_end_us - window_start_us);
+                window_start_us = work_end_us;
+                busy_us = 0;
+            }
+
+            if (socket_reactor_run(reactor->socket_reactor, wait_ms) < 0)
+            {
+                LogError("failure in socket_reactor_run for reactor %lu", (unsigned long)reactor->index);
+                ThreadAPI_Sleep((wait_ms < XIO_REACTOR_GROUP_POLL_INTERVAL_MS) ? wait_ms : XIO_REACTOR_GROUP_POLL_INTERVAL_MS);
+            }
+        }
+    }
+
+    return 0;
+}
+
+static int start_reactor_thread(XIO_REACTOR_GROUP* group, XIO_REACTOR* reactor)
+{
+    int result;
+    THREAD_ATTRIBUTES attributes;
+    THREADAPI_RESULT thread_result;
+
+    attributes.stack_size = 0;
+    attributes.name = "xio_reactor";
+    attributes.cpu_affinity_mask = group->pin_reactors ? ((uint64_t)1 << ((reactor->index % group->processor_count) % XIO_REACTOR_GROUP_MAX_PINNED)) : 0;
+    attributes.priority = THREADAPI_PRIORITY_NORMAL;
+
+    if ((thread_result = ThreadAPI_CreateEx(&reactor->thread, reactor_thread, reactor, &attributes)) == THREADAPI_INVALID_ARG)
+    {
+        LogInfo("the platform does not name or pin threads, reactor %lu gets a default thread", (unsigned long)reactor->index);
+        thread_result = ThreadAPI_Create(&reactor->thread, reactor_thread, reactor);
+    }
+
+    if (thread_result != THREADAPI_OK)
+    {
+        LogError("failure starting the thread of reactor %lu", (unsigned long)reactor->index);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+/* stops and joins the first started_count reactors, the others never ran */
+static void stop_reactors(XIO_REACTOR_GROUP* group, size_t started_count)
+{
+    size_t i;
+
+    if (Lock(group->lock) != LOCK_OK)
+    {
+        LogError("failure in Lock, the reactor threads cannot be stopped");
+    }
+    else
+    {
+        for (i = 0; i < started_count; i++)
+        {
+            DList_InsertTailList(&group->reactors[i].requests, &group->reactors[i].stop_request.link);
+        }
+
+        (void)Unlock(group->lock);
+
+        for (i = 0; i < started_count; i++)
+        {
+            int thread_result;
+
+            wake_reactor(&group->reactors[i]);
+            if (ThreadAPI_Join(group->reactors[i].thread, &thread_result) != THREADAPI_OK)
+            {
+                LogError("failure in ThreadAPI_Join for reactor %lu", (unsigned long)i);
+            }
+        }
+    }
+}
+
+/* with the threads stopped, runs what was queued behind the stop requests and lets go of the connections left */
+static void release_reactors(XIO_REACTOR_GROUP* group)
+{
+    bool ran_request;
+    size_t i;
+
+    do
+    {
+        /* a migration run here queues requests on another reactor, possibly one already drained */
+        ran_request = false;
+        for (i = 0; i < group->reactor_count; i++)
+        {
+            XIO_REACTOR_REQUEST* request;
+            while ((request = take_request(&group->reactors[i])) != NULL)
+            {
+                (void)run_request(&group->reactors[i], request);
+                ran_request = true;
+            }
+        }
+    } while (ran_request);
+
+    for (i = 0; i < group->reactor_count; i++)
+    {
+        XIO_REACTOR* reactor = &group->reactors[i];
+
+        while (!DList_IsListEmpty(&reactor->connections))
+        {
+            XIO_REACTOR_CONNECTION* connection = containingRecord(DList_RemoveHeadList(&reactor->connections), XIO_REACTOR_CONNECTION, link);
+
+            LogInfo("A connection is still in the group, it is left to its owner");
+            if ((xio_setoption(connection->xio, OPTION_SOCKET_REACTOR, NULL) != 0) &&
+                (!connection->polled))
+            {
+                LogError("failure taking the IO stack off the socket reactor of reactor %lu", (unsigned long)i);
+            }
+            free(connection);
+        }
+    }
+}
+
+static void free_reactors(XIO_REACTOR_GROUP* group, size_t initialized_count)
+{
+    size_t i;
+
+    for (i = 0; i < initialized_count; i++)
+    {
+        socket_reactor_destroy(group->reactors[i].socket_reactor);
+    }
+    free(group->reactors);
+}
+
+XIO_REACTOR_GROUP_HANDLE xio_reactor_group_create(const XIO_REACTOR_GROUP_CONFIG* config)
+{
+    XIO_REACTOR_GROUP* result;
+
+    /* Codes_SRS_XIO_REACTOR_GROUP_01_001: [ xio_reactor_group_create shall allocate the group and create its lock. ]*/
+    if ((result = (XIO_REACTOR_GROUP*)malloc(sizeof(XIO_REACTOR_GROUP))) == NULL)
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_005: [ If any failure occurs, xio_reactor_group_create shall stop the reactors it started, free all resources and return NULL. ]*/
+        LogError("failure in malloc(sizeof(XIO_REACTOR_GROUP)=%lu)", (unsigned long)sizeof(XIO_REACTOR_GROUP));
+    }
+    else
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_002: [ If config is NULL or its reactor_count is 0, xio_reactor_group_create shall create one reactor per processor; reactors are pinned only when config asks for it. ]*/
+        result->processor_count = get_processor_count();
+        result->reactor_count = ((config == NULL) || (config->reactor_count == 0)) ? result->processor_count : config->reactor_count;
+        result->pin_reactors = (config != NULL) && config->pin_reactors;
+
+        if ((result->lock = Lock_Init()) == NULL)
+        {
+            /* Codes_SRS_XIO_REACTOR_GROUP_01_005: [ If any failure occurs, xio_reactor_group_create shall stop the reactors it started, free all resources and return NULL. ]*/
+            LogError("failure in Lock_Init");
+            free(result);
+            result = NULL;
+        }
+        else if ((result->reactor_count > SIZE_MAX / sizeof(XIO_REACTOR)) ||
+            ((result->reactors = (XIO_REACTOR*)malloc(result->reactor_count * sizeof(XIO_REACTOR))) == NULL))
+        {
+            /* Codes_SRS_XIO_REACTOR_GROUP_01_005: [ If any failure occurs, xio_reactor_group_create shall stop the reactors it started, free all resources and return NULL. ]*/
+            LogError("failure allocating %lu reactors", (unsigned long)result->reactor_count);
+            (void)Lock_Deinit(result->lock);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            size_t initialized_count;
+            size_t started_count = 0;
+
+            /* Codes_SRS_XIO_REACTOR_GROUP_01_003: [ xio_reactor_group_create shall create a socket reactor for each reactor. ]*/
+            for (initialized_count = 0; initialized_count < result->reactor_count; initialized_count++)
+            {
+                XIO_REACTOR* reactor = &result->reactors[initialized_count];
+                reactor->group = result;
+                reactor->index = initialized_count;
+                reactor->load.connection_count = 0;
+                reactor->load.busy_percent = 0;
+                reactor->polled_count = 0;
+                reactor->stop_request.type = XIO_REACTOR_REQUEST_STOP;
+                reactor->stop_request.connection = NULL;
+                reactor->stop_request.adopt_request = NULL;
+                DList_InitializeListHead(&reactor->requests);
+                DList_InitializeListHead(&reactor->connections);
+                if ((reactor->socket_reactor = socket_reactor_create()) == NULL)
+                {
+                    LogError("failure in socket_reactor_create");
+                    break;
+                }
+            }
+
+            if (initialized_count == result->reactor_count)
+            {
+                /* Codes_SRS_XIO_REACTOR_GROUP_01_004: [ xio_reactor_group_create shall start a thread for each reactor, named xio_reactor and pinned to the processor of its index when pin_reactors is true. ]*/
+                for (started_count = 0; started_count < result->reactor_count; started_count++)
+                {
+                    if (start_reactor_thread(result, &result->reactors[started_count]) != 0)
+                    {
+                        break;
+                    }
+                }
+            }
+
+            if (started_count != result->reactor_count)
+            {
+                /* Codes_SRS_XIO_REACTOR_GROUP_01_005: [ If any failure occurs, xio_reactor_group_create shall stop the reactors it started, free all resources and return NULL. ]*/
+                stop_reactors(result, started_count);
+                free_reactors(result, initialized_count);
+                (void)Lock_Deinit(result->lock);
+                free(result);
+                result = NULL;
+            }
+        }
+    }
+
+    return result;
+}
+
+void xio_reactor_group_destroy(XIO_REACTOR_GROUP_HANDLE group)
+{
+    if (group == NULL)
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_006: [ If group is NULL, xio_reactor_group_destroy shall return. ]*/
+        LogError("Invalid argument: group is NULL");
+    }
+    else
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_007: [ xio_reactor_group_destroy shall queue a stop request behind the requests of each reactor and join the reactor threads. ]*/
+        stop_reactors(group, group->reactor_count);
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_008: [ xio_reactor_group_destroy shall run the requests still queued, set OPTION_SOCKET_REACTOR to NULL on the connections left in the group and free them. ]*/
+        release_reactors(group);
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_009: [ xio_reactor_group_destroy shall destroy the socket reactors and the lock and free the group. ]*/
+        free_reactors(group, group->reactor_count);
+        (void)Lock_Deinit(group->lock);
+        free(group);
+    }
+}
+
+XIO_REACTOR_CONNECTION_HANDLE xio_reactor_group_add(XIO_REACTOR_GROUP_HANDLE group, XIO_HANDLE xio, ON_XIO_REACTOR_CALL on_added, void* on_added_context)
+{
+    XIO_REACTOR_CONNECTION* result;
+    XIO_REACTOR_REQUEST* request;
+
+    if ((group == NULL) ||
+        (xio == NULL))
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_010: [ If group or xio is NULL, xio_reactor_group_add shall fail and return NULL. ]*/
+        LogError("Invalid arguments: group=%p, xio=%p", group, xio);
+        result = NULL;
+    }
+    else if ((result = (XIO_REACTOR_CONNECTION*)malloc(sizeof(XIO_REACTOR_CONNECTION))) == NULL)
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_014: [ If any failure occurs, xio_reactor_group_add shall fail and return NULL. ]*/
+        LogError("failure in malloc(sizeof(XIO_REACTOR_CONNECTION)=%lu)", (unsigned long)sizeof(XIO_REACTOR_CONNECTION));
+    }
+    else if ((request = create_request(XIO_REACTOR_REQUEST_ADD, result, on_added, on_added_context)) == NULL)
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_014: [ If any failure occurs, xio_reactor_group_add shall fail and return NULL. ]*/
+        free(result);
+        result = NULL;
+    }
+    else if (Lock(group->lock) != LOCK_OK)
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_014: [ If any failure occurs, xio_reactor_group_add shall fail and return NULL. ]*/
+        LogError("failure in Lock");
+        free_request(request);
+        free(result);
+        result = NULL;
+    }
+    else
+    {
+        XIO_REACTOR* reactor = &group->reactors[0];
+        size_t i;
+
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_011: [ xio_reactor_group_add shall place the connection on the reactor with the fewest connections, the one with the lowest busy_percent among those. ]*/
+        for (i = 1; i < group->reactor_count; i++)
+        {
+            XIO_REACTOR* candidate = &group->reactors[i];
+            if ((candidate->load.connection_count < reactor->load.connection_count) ||
+                ((candidate->load.connection_count == reactor->load.connection_count) && (candidate->load.busy_percent < reactor->load.busy_percent)))
+            {
+                reactor = candidate;
+            }
+        }
+
+        result->group = group;
+        result->xio = xio;
+        result->holder = reactor;
+        result->counted_on = reactor;
+        result->polled = false;
+        reactor->load.connection_count++;
+
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_012: [ The reactor thread shall set OPTION_SOCKET_REACTOR to its socket reactor on the connection, polling the connection if that fails, and then call on_added if it is not NULL. ]*/
+        DList_InsertTailList(&reactor->requests, &request->link);
+        (void)Unlock(group->lock);
+
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_013: [ xio_reactor_group_add shall wake the reactor and return the connection. ]*/
+        wake_reactor(reactor);
+    }
+
+    return result;
+}
+
+int xio_reactor_group_remove(XIO_REACTOR_CONNECTION_HANDLE connection, ON_XIO_REACTOR_CALL on_removed, void* on_removed_context)
+{
+    int result;
+    XIO_REACTOR_REQUEST* request;
+
+    if (connection == NULL)
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_015: [ If connection is NULL, xio_reactor_group_remove shall fail and return a non-zero value. ]*/
+        LogError("Invalid argument: connection is NULL");
+        result = __FAILURE__;
+    }
+    else if ((request = create_request(XIO_REACTOR_REQUEST_REMOVE, connection, on_removed, on_removed_context)) == NULL)
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_018: [ If any failure occurs, xio_reactor_group_remove shall fail and return a non-zero value. ]*/
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_XIO_REACTOR_GROUP_01_016: [ xio_reactor_group_remove shall queue the removal behind the requests made for the connection and wake its reactor. ]*/
+    else if (post_request(connection->group, request) != 0)
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_018: [ If any failure occurs, xio_reactor_group_remove shall fail and return a non-zero value. ]*/
+        free_request(request);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_017: [ The reactor thread shall set OPTION_SOCKET_REACTOR to NULL on the connection, drop the requests made for it afterwards, call on_removed if it is not NULL and free the connection. ]*/
+        result = 0;
+    }
+
+    return result;
+}
+
+int xio_reactor_group_call(XIO_REACTOR_CONNECTION_HANDLE connection, ON_XIO_REACTOR_CALL on_call, void* on_call_context)
+{
+    int result;
+    XIO_REACTOR_REQUEST* request;
+
+    if ((connection == NULL) ||
+        (on_call == NULL))
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_019: [ If connection or on_call is NULL, xio_reactor_group_call shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: connection=%p, on_call=%p", connection, on_call);
+        result = __FAILURE__;
+    }
+    else if ((request = create_request(XIO_REACTOR_REQUEST_CALL, connection, on_call, on_call_context)) == NULL)
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_021: [ If any failure occurs, xio_reactor_group_call shall fail and return a non-zero value. ]*/
+        result = __FAILURE__;
+    }
+    /* Codes_SRS_XIO_REACTOR_GROUP_01_020: [ xio_reactor_group_call shall queue the call behind the requests made for the connection and wake its reactor, whose thread calls on_call with on_call_context and the IO stack. ]*/
+    else if (post_request(connection->group, request) != 0)
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_021: [ If any failure occurs, xio_reactor_group_call shall fail and return a non-zero value. ]*/
+        free_request(request);
+        result = __FAILURE__;
+    }
+    else
+    {
+        result = 0;
+    }
+
+    return result;
+}
+
+int xio_reactor_group_migrate(XIO_REACTOR_CONNECTION_HANDLE connection, size_t reactor_index)
+{
+    int result;
+    XIO_REACTOR_REQUEST* request;
+
+    if ((connection == NULL) ||
+        (reactor_index >= connection->group->reactor_count))
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_022: [ If connection is NULL or reactor_index is not the index of a reactor of the group, xio_reactor_group_migrate shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: connection=%p, reactor_index=%lu", connection, (unsigned long)reactor_index);
+        result = __FAILURE__;
+    }
+    else if ((request = create_request(XIO_REACTOR_REQUEST_MIGRATE, connection, NULL, NULL)) == NULL)
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_025: [ If any failure occurs, xio_reactor_group_migrate shall fail and return a non-zero value. ]*/
+        result = __FAILURE__;
+    }
+    else if ((request->adopt_request = create_request(XIO_REACTOR_REQUEST_ADOPT, connection, NULL, NULL)) == NULL)
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_025: [ If any failure occurs, xio_reactor_group_migrate shall fail and return a non-zero value. ]*/
+        free_request(request);
+        result = __FAILURE__;
+    }
+    else
+    {
+        request->reactor_index = reactor_index;
+
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_023: [ xio_reactor_group_migrate shall queue the migration behind the requests made for the connection, count the connection on the target reactor and wake its current reactor. ]*/
+        if (post_request(connection->group, request) != 0)
+        {
+            /* Codes_SRS_XIO_REACTOR_GROUP_01_025: [ If any failure occurs, xio_reactor_group_migrate shall fail and return a non-zero value. ]*/
+            free_request(request);
+            result = __FAILURE__;
+        }
+        else
+        {
+            /* Codes_SRS_XIO_REACTOR_GROUP_01_024: [ The reactor thread shall take the connection off its connections, make the target reactor receive the requests for it, queue an adopt request first, and wake the target, whose thread sets OPTION_SOCKET_REACTOR to its socket reactor. ]*/
+            result = 0;
+        }
+    }
+
+    return result;
+}
+
+size_t xio_reactor_group_get_reactor_count(XIO_REACTOR_GROUP_HANDLE group)
+{
+    /* Codes_SRS_XIO_REACTOR_GROUP_01_026: [ xio_reactor_group_get_reactor_count shall return the number of reactors of group, 0 if group is NULL. ]*/
+    return (group == NULL) ? 0 : group->reactor_count;
+}
+
+int xio_reactor_group_get_load(XIO_REACTOR_GROUP_HANDLE group, size_t reactor_index, XIO_REACTOR_LOAD* load)
+{
+    int result;
+
+    if ((group == NULL) ||
+        (reactor_index >= group->reactor_count) ||
+        (load == NULL))
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_027: [ If group or load is NULL or reactor_index is not the index of a reactor of the group, xio_reactor_group_get_load shall fail and return a non-zero value. ]*/
+        LogError("Invalid arguments: group=%p, reactor_index=%lu, load=%p", group, (unsigned long)reactor_index, load);
+        result = __FAILURE__;
+    }
+    else if (Lock(group->lock) != LOCK_OK)
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_029: [ If any failure occurs, xio_reactor_group_get_load shall fail and return a non-zero value. ]*/
+        LogError("failure in Lock");
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_XIO_REACTOR_GROUP_01_028: [ xio_reactor_group_get_load shall copy the connection count and busy_percent of the reactor into load. ]*/
+        *load = group->reactors[reactor_index].load;
+        (void)Unlock(group->lock);
+        result = 0;
+    }
+
+    return result;
+}
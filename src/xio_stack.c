@@ -0,0 +1,132 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stdbool.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+#include "azure_c_shared_utility/xio_stack.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_c_shared_utility/http_proxy_io.h"
+#include "azure_c_shared_utility/tlsio.h"
+#include "azure_c_shared_utility/wsio.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+
+/* A TLS IO under a WebSocket IO reads whole records and gives the frame decoder all the bytes of a dowork at once */
+#define XIO_STACK_TLS_READ_CHUNK_SIZE 16384
+
+static void set_stack_option(XIO_HANDLE xio, const char* option_name, const void* value)
+{
+    /* Codes_SRS_XIO_STACK_01_013: [ If setting one of these options fails, xio_stack_create shall carry on without it. ]*/
+    if (xio_setoption(xio, option_name, value) != 0)
+    {
+        LogInfo("The IO stack does not support %s, it is left unset", option_name);
+    }
+}
+
+XIO_HANDLE xio_stack_create(const XIO_STACK_CONFIG* config)
+{
+    XIO_HANDLE result;
+
+    if ((config == NULL) ||
+        (config->hostname == NULL) ||
+        ((config->ws_resource_name != NULL) && (config->ws_protocol == NULL)))
+    {
+        /* Codes_SRS_XIO_STACK_01_001: [ If config is NULL, its hostname is NULL, or it has a ws_resource_name but no ws_protocol, xio_stack_create shall fail and return NULL. ]*/
+        LogError("Invalid arguments: config=%p, hostname=%p, ws_resource_name=%p, ws_protocol=%p",
+            config, (config == NULL) ? NULL : config->hostname, (config == NULL) ? NULL : config->ws_resource_name, (config == NULL) ? NULL : config->ws_protocol);
+        result = NULL;
+    }
+    else
+    {
+        /* The layers copy what they keep of the configs when they are created, so the configs only live for this call */
+        SOCKETIO_CONFIG socketio_config;
+        HTTP_PROXY_IO_CONFIG http_proxy_io_config;
+        TLSIO_CONFIG tlsio_config;
+        WSIO_CONFIG wsio_config;
+        const IO_INTERFACE_DESCRIPTION* io_interface;
+        void* io_parameters;
+
+        if (config->proxy_hostname == NULL)
+        {
+            /* Codes_SRS_XIO_STACK_01_002: [ Without a proxy_hostname the bottom layer shall be a socket IO connecting to hostname and port. ]*/
+            socketio_config.hostname = config->hostname;
+            socketio_config.port = config->port;
+            socketio_config.accepted_socket = NULL;
+            io_interface = socketio_get_interface_description();
+            io_parameters = &socketio_config;
+        }
+        else
+        {
+            /* Codes_SRS_XIO_STACK_01_003: [ With a proxy_hostname the bottom layer shall be an HTTP proxy IO tunnelling to hostname and port through proxy_hostname, proxy_port, proxy_username and proxy_password. ]*/
+            http_proxy_io_config.hostname = config->hostname;
+            http_proxy_io_config.port = config->port;
+            http_proxy_io_config.proxy_hostname = config->proxy_hostname;
+            http_proxy_io_config.proxy_port = config->proxy_port;
+            http_proxy_io_config.username = config->proxy_username;
+            http_proxy_io_config.password = config->proxy_password;
+            io_interface = http_proxy_io_get_interface_description();
+            io_parameters = &http_proxy_io_config;
+        }
+
+        if (config->tlsio_interface != NULL)
+        {
+            /* Codes_SRS_XIO_STACK_01_004: [ If tlsio_interface is not NULL a TLS IO of that interface shall be stacked on the layer below, for hostname and port. ]*/
+            tlsio_config.hostname = config->hostname;
+            tlsio_config.port = config->port;
+            tlsio_config.underlying_io_interface = io_interface;
+            tlsio_config.underlying_io_parameters = io_parameters;
+            io_interface = config->tlsio_interface;
+            io_parameters = &tlsio_config;
+        }
+
+        if (config->ws_resource_name != NULL)
+        {
+            /* Codes_SRS_XIO_STACK_01_005: [ If ws_resource_name is not NULL a WebSocket IO for ws_resource_name and ws_protocol shall be stacked on the layer below. ]*/
+            wsio_config.underlying_io_interface = io_interface;
+            wsio_config.underlying_io_parameters = io_parameters;
+            wsio_config.hostname = config->hostname;
+            wsio_config.port = config->port;
+            wsio_config.resource_name = config->ws_resource_name;
+            wsio_config.protocol = config->ws_protocol;
+            io_interface = wsio_get_interface_description();
+            io_parameters = &wsio_config;
+        }
+
+        if (io_interface == NULL)
+        {
+            /* Codes_SRS_XIO_STACK_01_006: [ If getting the interface description of a layer fails, xio_stack_create shall fail and return NULL. ]*/
+            LogError("Failed getting the interface description of the top layer");
+            result = NULL;
+        }
+        /* Codes_SRS_XIO_STACK_01_007: [ xio_stack_create shall create the stack by calling xio_create for the top layer, which creates each layer below it. ]*/
+        else if ((result = xio_create(io_interface, io_parameters)) == NULL)
+        {
+            /* Codes_SRS_XIO_STACK_01_008: [ If xio_create fails, xio_stack_create shall fail and return NULL. ]*/
+            LogError("Failed creating the IO stack for %s:%d", config->hostname, config->port);
+        }
+        else
+        {
+            /* Codes_SRS_XIO_STACK_01_009: [ The options shall be set on the top layer, which passes the ones it does not handle to the layers below. ]*/
+            bool shared_receive_buffer = true;
+
+            /* Codes_SRS_XIO_STACK_01_010: [ xio_stack_create shall set OPTION_SOCKETIO_SHARED_RECEIVE_BUFFER, since every layer above the socket consumes the received bytes during on_bytes_received. ]*/
+            set_stack_option(result, OPTION_SOCKETIO_SHARED_RECEIVE_BUFFER, &shared_receive_buffer);
+
+            if ((config->tlsio_interface != NULL) && (config->ws_resource_name != NULL))
+            {
+                bool coalesce_received_bytes = true;
+                size_t read_chunk_size = XIO_STACK_TLS_READ_CHUNK_SIZE;
+
+                /* Codes_SRS_XIO_STACK_01_011: [ For a TLS IO under the WebSocket IO, xio_stack_create shall set OPTION_TLS_READ_CHUNK_SIZE to 16384 and OPTION_TLS_COALESCE_RECEIVED_BYTES to true. ]*/
+                set_stack_option(result, OPTION_TLS_READ_CHUNK_SIZE, &read_chunk_size);
+                set_stack_option(result, OPTION_TLS_COALESCE_RECEIVED_BYTES, &coalesce_received_bytes);
+            }
+
+            /* Codes_SRS_XIO_STACK_01_012: [ On success xio_stack_create shall return the handle of the top layer. ]*/
+        }
+    }
+
+    return result;
+}
@@ -0,0 +1,375 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xio_trace.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#define XIO_TRACE_RING_DEFAULT_EVENT_COUNT 4096
+
+/*
+* The span current on a thread is a thread local, the layers below take their parent and
+* correlation id from it while the layer above is sending.
+*
+* The ring is the bounded multi-producer/single-consumer queue of asynclogger: entry i of the
+* ring is free for position p while its sequence is p; a producer that wins the
+* compare-and-swap of head from p to p+1 fills it and publishes it by moving its sequence to
+* p+1, and the reader frees it again by moving the sequence to p+event_count.
+*
+* Nothing here logs on the paths of the events: the sink may well be called while logging.
+*/
+#if defined(_MSC_VER)
+#include <windows.h>
+#define XIO_TRACE_THREAD_LOCAL __declspec(thread)
+#define XIO_TRACE_ADD(value, addend) InterlockedExchangeAdd(&(value), (addend))
+#define XIO_TRACE_CAS(value, exchange, comparand) InterlockedCompareExchange(&(value), (exchange), (comparand))
+#define XIO_TRACE_NEXT_ID(value) ((uint64_t)InterlockedIncrement64((volatile LONGLONG*)&(value)))
+#else
+#define XIO_TRACE_THREAD_LOCAL __thread
+#define XIO_TRACE_ADD(value, addend) __sync_fetch_and_add(&(value), (addend))
+#define XIO_TRACE_CAS(value, exchange, comparand) __sync_val_compare_and_swap(&(value), (comparand), (exchange))
+#define XIO_TRACE_NEXT_ID(value) __sync_add_and_fetch(&(value), 1)
+#endif
+#define XIO_TRACE_READ(value) XIO_TRACE_ADD(value, 0)
+/* positions wrap around, so they are only ever compared through their difference */
+#define XIO_TRACE_DIFF(a, b) ((long)((unsigned long)(a) - (unsigned long)(b)))
+#define XIO_TRACE_POSITION_NEXT(a) ((long)((unsigned long)(a) + 1))
+
+typedef struct XIO_TRACE_RING_ENTRY_TAG
+{
+    volatile long sequence;
+    XIO_TRACE_EVENT event;
+} XIO_TRACE_RING_ENTRY;
+
+typedef struct XIO_TRACE_RING_TAG
+{
+    XIO_TRACE_RING_ENTRY* entries;
+    unsigned long entry_mask;
+    volatile long head;
+    /* only touched by the reader */
+    long tail;
+    volatile long dropped_count;
+} XIO_TRACE_RING;
+
+volatile long xio_trace_enabled = 0;
+
+static XIO_TRACE_SINK g_sink = NULL;
+static void* g_sink_context = NULL;
+static volatile uint64_t g_last_span_id = 0;
+static XIO_TRACE_THREAD_LOCAL XIO_TRACE_SPAN current_span;
+
+static uint64_t get_time_us(void)
+{
+    tickcounter_us_t now_us;
+
+    if (tickcounter_get_monotonic_us(&now_us) != 0)
+    {
+        now_us = 0;
+    }
+
+    return (uint64_t)now_us;
+}
+
+static void make_event(XIO_TRACE_SINK sink, void* sink_context, XIO_TRACE_EVENT_TYPE type, const XIO_TRACE_SPAN* span, const char* layer_name, const char* operation, uint64_t size, int result)
+{
+    XIO_TRACE_EVENT event;
+
+    event.type = type;
+    event.span = *span;
+    event.layer_name = layer_name;
+    event.operation = operation;
+    event.time_us = get_time_us();
+    event.size = size;
+    event.result = result;
+    sink(sink_context, &event);
+}
+
+int xio_trace_set_sink(XIO_TRACE_SINK sink, void* sink_context)
+{
+    if (sink == NULL)
+    {
+        /* Codes_SRS_XIO_TRACE_01_001: [ If sink is NULL, xio_trace_set_sink shall stop tracing, so that the hooks make no event anymore, and return 0. ]*/
+        (void)XIO_TRACE_CAS(xio_trace_enabled, 0, 1);
+        g_sink = NULL;
+        g_sink_context = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_XIO_TRACE_01_002: [ Otherwise xio_trace_set_sink shall keep sink and sink_context, start tracing and return 0. ]*/
+        g_sink = sink;
+        g_sink_context = sink_context;
+        (void)XIO_TRACE_CAS(xio_trace_enabled, 1, 0);
+    }
+
+    return 0;
+}
+
+void xio_trace_begin(XIO_TRACE_SPAN* span, const char* layer_name, const char* operation, uint64_t size)
+{
+    XIO_TRACE_SINK sink = g_sink;
+
+    if (span == NULL)
+    {
+        /* Codes_SRS_XIO_TRACE_01_003: [ If span is NULL, xio_trace_begin shall return. ]*/
+    }
+    else if (sink == NULL)
+    {
+        /* Codes_SRS_XIO_TRACE_01_004: [ If no sink is set, xio_trace_begin shall set the span_id of span to 0, so that the span is not traced, and return. ]*/
+        span->span_id = 0;
+    }
+    else
+    {
+        /* Codes_SRS_XIO_TRACE_01_005: [ xio_trace_begin shall give span a new span_id from a process wide counter, which is never 0. ]*/
+        span->span_id = XIO_TRACE_NEXT_ID(g_last_span_id);
+        if (span->span_id == 0)
+        {
+            span->span_id = XIO_TRACE_NEXT_ID(g_last_span_id);
+        }
+
+        if (current_span.span_id != 0)
+        {
+            /* Codes_SRS_XIO_TRACE_01_006: [ If a span is current on the thread, xio_trace_begin shall make span its child: the parent_span_id of span shall be the span_id of the current span and its correlation_id the correlation_id of the current span. ]*/
+            span->parent_span_id = current_span.span_id;
+            span->correlation_id = current_span.correlation_id;
+        }
+        else
+        {
+            /* Codes_SRS_XIO_TRACE_01_007: [ Otherwise span shall be the outermost span of a new message: its parent_span_id shall be 0 and its correlation_id its span_id. ]*/
+            span->parent_span_id = 0;
+            span->correlation_id = span->span_id;
+        }
+
+        /* Codes_SRS_XIO_TRACE_01_008: [ xio_trace_begin shall call the sink with an XIO_TRACE_EVENT_BEGIN event carrying span, layer_name, operation, size and the time given by tickcounter_get_monotonic_us (0 if it fails). ]*/
+        make_event(sink, g_sink_context, XIO_TRACE_EVENT_BEGIN, span, layer_name, operation, size, 0);
+    }
+}
+
+void xio_trace_end(const XIO_TRACE_SPAN* span, const char* layer_name, const char* operation, int result)
+{
+    XIO_TRACE_SINK sink = g_sink;
+
+    if ((span == NULL) ||
+        (span->span_id == 0) ||
+        (sink == NULL))
+    {
+        /* Codes_SRS_XIO_TRACE_01_009: [ If span is NULL, is not traced or no sink is set, xio_trace_end shall return. ]*/
+    }
+    else
+    {
+        /* Codes_SRS_XIO_TRACE_01_010: [ xio_trace_end shall call the sink with an XIO_TRACE_EVENT_END event carrying span, layer_name, operation, result and the time given by tickcounter_get_monotonic_us (0 if it fails). ]*/
+        make_event(sink, g_sink_context, XIO_TRACE_EVENT_END, span, layer_name, operation, 0, result);
+    }
+}
+
+XIO_TRACE_SPAN xio_trace_enter(const XIO_TRACE_SPAN* span)
+{
+    XIO_TRACE_SPAN result = current_span;
+
+    /* Codes_SRS_XIO_TRACE_01_011: [ If span is NULL, xio_trace_enter shall leave the current span of the thread alone. ]*/
+    if (span != NULL)
+    {
+        /* Codes_SRS_XIO_TRACE_01_012: [ xio_trace_enter shall make span the current span of the thread. ]*/
+        current_span = *span;
+    }
+
+    /* Codes_SRS_XIO_TRACE_01_013: [ xio_trace_enter shall return the span that was current on the thread, with a span_id of 0 if there was none. ]*/
+    return result;
+}
+
+void xio_trace_leave(XIO_TRACE_SPAN previous)
+{
+    /* Codes_SRS_XIO_TRACE_01_014: [ xio_trace_leave shall make previous the current span of the thread. ]*/
+    current_span = previous;
+}
+
+XIO_TRACE_RING_HANDLE xio_trace_ring_create(size_t event_count)
+{
+    XIO_TRACE_RING* result;
+
+    if (event_count > (((size_t)~(size_t)0) >> 2) / sizeof(XIO_TRACE_RING_ENTRY))
+    {
+        /* Codes_SRS_XIO_TRACE_01_015: [ If event_count is too large for the entries to be allocated, xio_trace_ring_create shall fail and return NULL. ]*/
+        LogError("invalid argument size_t event_count=%lu", (unsigned long)event_count);
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_XIO_TRACE_01_016: [ xio_trace_ring_create shall allocate a ring of event_count events rounded up to a power of 2, or of 4096 events if event_count is 0. ]*/
+        size_t ring_size = 1;
+        size_t target = (event_count == 0) ? XIO_TRACE_RING_DEFAULT_EVENT_COUNT : event_count;
+
+        while (ring_size < target)
+        {
+            ring_size <<= 1;
+        }
+
+        if ((result = (XIO_TRACE_RING*)malloc(sizeof(XIO_TRACE_RING))) == NULL)
+        {
+            /* Codes_SRS_XIO_TRACE_01_017: [ If any allocation fails, xio_trace_ring_create shall free what it allocated and return NULL. ]*/
+            LogError("failure in malloc(sizeof(XIO_TRACE_RING)=%lu)", (unsigned long)sizeof(XIO_TRACE_RING));
+        }
+        else if ((result->entries = (XIO_TRACE_RING_ENTRY*)malloc(ring_size * sizeof(XIO_TRACE_RING_ENTRY))) == NULL)
+        {
+            /* Codes_SRS_XIO_TRACE_01_017: [ If any allocation fails, xio_trace_ring_create shall free what it allocated and return NULL. ]*/
+            LogError("failure allocating %lu events", (unsigned long)ring_size);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            size_t i;
+
+            for (i = 0; i < ring_size; i++)
+            {
+                result->entries[i].sequence = (long)i;
+            }
+            result->entry_mask = (unsigned long)(ring_size - 1);
+            result->head = 0;
+            result->tail = 0;
+            result->dropped_count = 0;
+        }
+    }
+
+    return result;
+}
+
+void xio_trace_ring_destroy(XIO_TRACE_RING_HANDLE ring)
+{
+    if (ring == NULL)
+    {
+        /* Codes_SRS_XIO_TRACE_01_018: [ If ring is NULL, xio_trace_ring_destroy shall return. ]*/
+        LogError("invalid argument XIO_TRACE_RING_HANDLE ring=%p", ring);
+    }
+    else
+    {
+        /* Codes_SRS_XIO_TRACE_01_019: [ xio_trace_ring_destroy shall free the events and the ring. ]*/
+        free(ring->entries);
+        free(ring);
+    }
+}
+
+void xio_trace_ring_sink(void* context, const XIO_TRACE_EVENT* event)
+{
+    XIO_TRACE_RING* ring = (XIO_TRACE_RING*)context;
+
+    if (ring == NULL)
+    {
+        /* Codes_SRS_XIO_TRACE_01_020: [ If context is NULL, xio_trace_ring_sink shall return. ]*/
+    }
+    else if (event == NULL)
+    {
+        /* Codes_SRS_XIO_TRACE_01_021: [ If event is NULL, xio_trace_ring_sink shall count it as dropped. ]*/
+        (void)XIO_TRACE_ADD(ring->dropped_count, 1);
+    }
+    else
+    {
+        XIO_TRACE_RING_ENTRY* entry = NULL;
+        long position = XIO_TRACE_READ(ring->head);
+
+        /* Codes_SRS_XIO_TRACE_01_022: [ xio_trace_ring_sink shall claim the next entry of the ring with a compare-and-swap, without taking a lock. ]*/
+        for (;;)
+        {
+            XIO_TRACE_RING_ENTRY* candidate = &ring->entries[(unsigned long)position & ring->entry_mask];
+            long diff = XIO_TRACE_DIFF(XIO_TRACE_READ(candidate->sequence), position);
+
+            if (diff == 0)
+            {
+                long observed = XIO_TRACE_CAS(ring->head, XIO_TRACE_POSITION_NEXT(position), position);
+                if (observed == position)
+                {
+                    entry = candidate;
+                    break;
+                }
+                position = observed;
+            }
+            else if (diff < 0)
+            {
+                /* the reader has not freed this entry yet: the ring is full */
+                break;
+            }
+            else
+            {
+                /* another producer took the entry, try the next one */
+                position = XIO_TRACE_READ(ring->head);
+            }
+        }
+
+        if (entry == NULL)
+        {
+            /* Codes_SRS_XIO_TRACE_01_023: [ If the ring is full, xio_trace_ring_sink shall drop the event and count it. ]*/
+            (void)XIO_TRACE_ADD(ring->dropped_count, 1);
+        }
+        else
+        {
+            /* Codes_SRS_XIO_TRACE_01_024: [ xio_trace_ring_sink shall copy the event into the entry and publish it. ]*/
+            entry->event = *event;
+            (void)XIO_TRACE_ADD(entry->sequence, 1);
+        }
+    }
+}
+
+int xio_trace_ring_read(XIO_TRACE_RING_HANDLE ring, XIO_TRACE_EVENT* events, size_t event_count, size_t* read_count)
+{
+    int result;
+
+    if ((ring == NULL) ||
+        (events == NULL) ||
+        (event_count == 0) ||
+        (read_count == NULL))
+    {
+        /* Codes_SRS_XIO_TRACE_01_025: [ If ring, events or read_count is NULL or event_count is 0, xio_trace_ring_read shall fail and return a non-zero value. ]*/
+        LogError("invalid argument XIO_TRACE_RING_HANDLE ring=%p, XIO_TRACE_EVENT* events=%p, size_t event_count=%lu, size_t* read_count=%p", ring, events, (unsigned long)event_count, read_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        size_t count = 0;
+
+        /* Codes_SRS_XIO_TRACE_01_026: [ xio_trace_ring_read shall copy into events, oldest first, up to event_count events, stopping at the first entry that is not published yet, and free their entries. ]*/
+        while (count < event_count)
+        {
+            XIO_TRACE_RING_ENTRY* entry = &ring->entries[(unsigned long)ring->tail & ring->entry_mask];
+
+            if (XIO_TRACE_DIFF(XIO_TRACE_READ(entry->sequence), XIO_TRACE_POSITION_NEXT(ring->tail)) != 0)
+            {
+                /* empty, or the next event is still being copied */
+                break;
+            }
+
+            events[count] = entry->event;
+            count++;
+            (void)XIO_TRACE_ADD(entry->sequence, (long)ring->entry_mask);
+            ring->tail = XIO_TRACE_POSITION_NEXT(ring->tail);
+        }
+
+        /* Codes_SRS_XIO_TRACE_01_027: [ xio_trace_ring_read shall set read_count to the number of events copied and return 0. ]*/
+        *read_count = count;
+        result = 0;
+    }
+
+    return result;
+}
+
+uint64_t xio_trace_ring_get_dropped_count(XIO_TRACE_RING_HANDLE ring)
+{
+    uint64_t result;
+
+    if (ring == NULL)
+    {
+        /* Codes_SRS_XIO_TRACE_01_028: [ If ring is NULL, xio_trace_ring_get_dropped_count shall return 0. ]*/
+        LogError("invalid argument XIO_TRACE_RING_HANDLE ring=%p", ring);
+        result = 0;
+    }
+    else
+    {
+        /* Codes_SRS_XIO_TRACE_01_029: [ xio_trace_ring_get_dropped_count shall return the number of events the ring dropped since it was created. ]*/
+        result = (uint64_t)(unsigned long)XIO_TRACE_READ(ring->dropped_count);
+    }
+
+    return result;
+}
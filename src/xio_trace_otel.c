@@ -0,0 +1,375 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xio_trace_otel.h"
+#include "azure_c_shared_utility/agenttime.h"
+#include "azure_c_shared_utility/gb_rand.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/xlogging.h"
+
+#define XIO_TRACE_OTEL_DEFAULT_MAX_OPEN_SPANS 1024
+
+/* the span ids come from one counter, so the entry span_id & open_span_mask is only wanted again
+   once max_open_spans more spans began */
+typedef struct XIO_TRACE_OTEL_OPEN_SPAN_TAG
+{
+    /* 0 while the entry is free */
+    uint64_t span_id;
+    XIO_TRACE_EVENT begin;
+} XIO_TRACE_OTEL_OPEN_SPAN;
+
+typedef struct XIO_TRACE_OTEL_TAG
+{
+    XIO_TRACE_OTEL_OPEN_SPAN* open_spans;
+    uint64_t open_span_mask;
+    ON_XIO_TRACE_OTEL_SPAN on_span;
+    void* on_span_context;
+    LOCK_HANDLE lock;
+    uint8_t trace_id_prefix[8];
+    /* the UNIX time, in nanoseconds, of the 0 of the tickcounter_get_monotonic_us clock */
+    uint64_t epoch_offset_ns;
+    uint64_t dropped_count;
+} XIO_TRACE_OTEL;
+
+static void write_big_endian(uint8_t* destination, uint64_t value)
+{
+    int i;
+
+    for (i = 7; i >= 0; i--)
+    {
+        destination[i] = (uint8_t)value;
+        value >>= 8;
+    }
+}
+
+static uint64_t get_epoch_offset_ns(void)
+{
+    uint64_t result;
+    time_t now = get_time(NULL);
+    tickcounter_us_t now_us;
+
+    if ((now == (time_t)-1) ||
+        (tickcounter_get_monotonic_us(&now_us) != 0))
+    {
+        LogError("Cannot read the time, the spans have monotonic times");
+        result = 0;
+    }
+    else
+    {
+        result = ((uint64_t)now * 1000000000) - ((uint64_t)now_us * 1000);
+    }
+
+    return result;
+}
+
+/* returns true when event ended a span, which is then in span */
+static bool add_event(XIO_TRACE_OTEL* otel, const XIO_TRACE_EVENT* event, XIO_TRACE_OTEL_SPAN* span)
+{
+    bool result = false;
+    XIO_TRACE_OTEL_OPEN_SPAN* open_span = &otel->open_spans[event->span.span_id & otel->open_span_mask];
+
+    if (event->span.span_id == 0)
+    {
+        /* Codes_SRS_XIO_TRACE_OTEL_01_013: [ Events of a span that is not traced (span_id 0) shall be dropped and counted. ]*/
+        otel->dropped_count++;
+    }
+    else if (event->type == XIO_TRACE_EVENT_BEGIN)
+    {
+        if (open_span->span_id != 0)
+        {
+            /* Codes_SRS_XIO_TRACE_OTEL_01_014: [ If the entry of the table of open spans for the span_id of a begin event is taken by a span that is still open, the event shall be dropped and counted. ]*/
+            otel->dropped_count++;
+        }
+        else
+        {
+            /* Codes_SRS_XIO_TRACE_OTEL_01_015: [ A begin event shall be kept in the entry of the table of open spans given by its span_id. ]*/
+            open_span->span_id = event->span.span_id;
+            open_span->begin = *event;
+        }
+    }
+    else if (open_span->span_id != event->span.span_id)
+    {
+        /* Codes_SRS_XIO_TRACE_OTEL_01_016: [ An end event whose span is not open shall be dropped and counted. ]*/
+        otel->dropped_count++;
+    }
+    else
+    {
+        /* Codes_SRS_XIO_TRACE_OTEL_01_017: [ An end event shall finish the open span of the same span_id and free its entry. ]*/
+        /* Codes_SRS_XIO_TRACE_OTEL_01_018: [ The trace id of a span shall be the 8 random bytes drawn by xio_trace_otel_create followed by the correlation_id, big endian; its span id and parent span id shall be the span_id and parent_span_id, big endian. ]*/
+        (void)memcpy(span->trace_id, otel->trace_id_prefix, sizeof(otel->trace_id_prefix));
+        write_big_endian(span->trace_id + 8, open_span->begin.span.correlation_id);
+        write_big_endian(span->span_id, open_span->begin.span.span_id);
+        write_big_endian(span->parent_span_id, open_span->begin.span.parent_span_id);
+
+        /* Codes_SRS_XIO_TRACE_OTEL_01_019: [ The layer name, operation and size of a span shall be the ones of its begin event, its result the one of its end event, and its start and end times the times of its events moved to the UNIX epoch, in nanoseconds. ]*/
+        span->layer_name = open_span->begin.layer_name;
+        span->operation = open_span->begin.operation;
+        span->start_time_unix_nano = otel->epoch_offset_ns + (open_span->begin.time_us * 1000);
+        span->end_time_unix_nano = otel->epoch_offset_ns + (event->time_us * 1000);
+        span->size = open_span->begin.size;
+        span->result = event->result;
+
+        open_span->span_id = 0;
+        result = true;
+    }
+
+    return result;
+}
+
+static void add_events(XIO_TRACE_OTEL* otel, const XIO_TRACE_EVENT* events, size_t event_count)
+{
+    size_t i;
+
+    for (i = 0; i < event_count; i++)
+    {
+        XIO_TRACE_OTEL_SPAN span;
+        bool finished;
+
+        if (Lock(otel->lock) != LOCK_OK)
+        {
+            LogError("failure in Lock");
+            finished = false;
+        }
+        else
+        {
+            finished = add_event(otel, &events[i], &span);
+            (void)Unlock(otel->lock);
+        }
+
+        if (finished)
+        {
+            /* Codes_SRS_XIO_TRACE_OTEL_01_020: [ Each finished span shall be given to on_span, with on_span_context, without holding the lock. ]*/
+            otel->on_span(otel->on_span_context, &span);
+        }
+    }
+}
+
+XIO_TRACE_OTEL_HANDLE xio_trace_otel_create(size_t max_open_spans, ON_XIO_TRACE_OTEL_SPAN on_span, void* on_span_context)
+{
+    XIO_TRACE_OTEL* result;
+
+    if ((on_span == NULL) ||
+        (max_open_spans > (((size_t)~(size_t)0) >> 2) / sizeof(XIO_TRACE_OTEL_OPEN_SPAN)))
+    {
+        /* Codes_SRS_XIO_TRACE_OTEL_01_001: [ If on_span is NULL or max_open_spans is too large for the table to be allocated, xio_trace_otel_create shall fail and return NULL. ]*/
+        LogError("invalid argument size_t max_open_spans=%lu, ON_XIO_TRACE_OTEL_SPAN on_span=%p", (unsigned long)max_open_spans, on_span);
+        result = NULL;
+    }
+    else
+    {
+        /* Codes_SRS_XIO_TRACE_OTEL_01_002: [ xio_trace_otel_create shall allocate a table of max_open_spans open spans rounded up to a power of 2, or of 1024 if max_open_spans is 0, all free. ]*/
+        size_t table_size = 1;
+        size_t target = (max_open_spans == 0) ? XIO_TRACE_OTEL_DEFAULT_MAX_OPEN_SPANS : max_open_spans;
+
+        while (table_size < target)
+        {
+            table_size <<= 1;
+        }
+
+        if ((result = (XIO_TRACE_OTEL*)malloc(sizeof(XIO_TRACE_OTEL))) == NULL)
+        {
+            /* Codes_SRS_XIO_TRACE_OTEL_01_005: [ If any failure occurs, xio_trace_otel_create shall free what it allocated and return NULL. ]*/
+            LogError("failure in malloc(sizeof(XIO_TRACE_OTEL)=%lu)", (unsigned long)sizeof(XIO_TRACE_OTEL));
+        }
+        else if ((result->open_spans = (XIO_TRACE_OTEL_OPEN_SPAN*)calloc(table_size, sizeof(XIO_TRACE_OTEL_OPEN_SPAN))) == NULL)
+        {
+            /* Codes_SRS_XIO_TRACE_OTEL_01_005: [ If any failure occurs, xio_trace_otel_create shall free what it allocated and return NULL. ]*/
+            LogError("failure allocating %lu open spans", (unsigned long)table_size);
+            free(result);
+            result = NULL;
+        }
+        /* Codes_SRS_XIO_TRACE_OTEL_01_003: [ xio_trace_otel_create shall create a lock. ]*/
+        else if ((result->lock = Lock_Init()) == NULL)
+        {
+            /* Codes_SRS_XIO_TRACE_OTEL_01_005: [ If any failure occurs, xio_trace_otel_create shall free what it allocated and return NULL. ]*/
+            LogError("failure in Lock_Init");
+            free(result->open_spans);
+            free(result);
+            result = NULL;
+        }
+        else
+        {
+            /* Codes_SRS_XIO_TRACE_OTEL_01_004: [ xio_trace_otel_create shall draw the 8 bytes that start the trace ids with gb_rand_fill and read the offset of the monotonic clock to the UNIX epoch with get_time and tickcounter_get_monotonic_us. ]*/
+            gb_rand_fill(result->trace_id_prefix, sizeof(result->trace_id_prefix));
+            result->epoch_offset_ns = get_epoch_offset_ns();
+            result->open_span_mask = (uint64_t)(table_size - 1);
+            result->on_span = on_span;
+            result->on_span_context = on_span_context;
+            result->dropped_count = 0;
+        }
+    }
+
+    return result;
+}
+
+void xio_trace_otel_destroy(XIO_TRACE_OTEL_HANDLE otel)
+{
+    if (otel == NULL)
+    {
+        /* Codes_SRS_XIO_TRACE_OTEL_01_006: [ If otel is NULL, xio_trace_otel_destroy shall return. ]*/
+        LogError("invalid argument XIO_TRACE_OTEL_HANDLE otel=%p", otel);
+    }
+    else
+    {
+        /* Codes_SRS_XIO_TRACE_OTEL_01_007: [ xio_trace_otel_destroy shall free the lock, the table of open spans and the builder. ]*/
+        (void)Lock_Deinit(otel->lock);
+        free(otel->open_spans);
+        free(otel);
+    }
+}
+
+void xio_trace_otel_sink(void* context, const XIO_TRACE_EVENT* event)
+{
+    if ((context == NULL) ||
+        (event == NULL))
+    {
+        /* Codes_SRS_XIO_TRACE_OTEL_01_008: [ If context or event is NULL, xio_trace_otel_sink shall return. ]*/
+    }
+    else
+    {
+        /* Codes_SRS_XIO_TRACE_OTEL_01_009: [ xio_trace_otel_sink shall add event to the builder while holding its lock. ]*/
+        add_events((XIO_TRACE_OTEL*)context, event, 1);
+    }
+}
+
+int xio_trace_otel_add_events(XIO_TRACE_OTEL_HANDLE otel, const XIO_TRACE_EVENT* events, size_t event_count)
+{
+    int result;
+
+    if ((otel == NULL) ||
+        ((events == NULL) && (event_count > 0)))
+    {
+        /* Codes_SRS_XIO_TRACE_OTEL_01_010: [ If otel is NULL, or events is NULL while event_count is not 0, xio_trace_otel_add_events shall fail and return a non-zero value. ]*/
+        LogError("invalid argument XIO_TRACE_OTEL_HANDLE otel=%p, const XIO_TRACE_EVENT* events=%p, size_t event_count=%lu", otel, events, (unsigned long)event_count);
+        result = __FAILURE__;
+    }
+    else
+    {
+        /* Codes_SRS_XIO_TRACE_OTEL_01_011: [ xio_trace_otel_add_events shall add the events in order, each while holding the lock, and return 0. ]*/
+        add_events(otel, events, event_count);
+        result = 0;
+    }
+
+    return result;
+}
+
+uint64_t xio_trace_otel_get_dropped_count(XIO_TRACE_OTEL_HANDLE otel)
+{
+    uint64_t result;
+
+    if (otel == NULL)
+    {
+        /* Codes_SRS_XIO_TRACE_OTEL_01_012: [ If otel is NULL, xio_trace_otel_get_dropped_count shall return 0. ]*/
+        LogError("invalid argument XIO_TRACE_OTEL_HANDLE otel=%p", otel);
+        result = 0;
+    }
+    else if (Lock(otel->lock) != LOCK_OK)
+    {
+        LogError("failure in Lock");
+        result = 0;
+    }
+    else
+    {
+        /* Codes_SRS_XIO_TRACE_OTEL_01_021: [ xio_trace_otel_get_dropped_count shall return the number of events dropped since the builder was created. ]*/
+        result = otel->dropped_count;
+        (void)Unlock(otel->lock);
+    }
+
+    return result;
+}
+
+static void write_hex(char* destination, const uint8_t* bytes, size_t size)
+{
+    static const char hex_digits[] = "0123456789abcdef";
+    size_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        destination[2 * i] = hex_digits[bytes[i] >> 4];
+        destination[(2 * i) + 1] = hex_digits[bytes[i] & 0x0F];
+    }
+    destination[2 * size] = '\0';
+}
+
+int xio_trace_otel_format_span(const XIO_TRACE_OTEL_SPAN* span, char* buffer, size_t buffer_size, size_t* written)
+{
+    int result;
+
+    if ((span == NULL) ||
+        (written == NULL) ||
+        ((buffer == NULL) && (buffer_size > 0)))
+    {
+        /* Codes_SRS_XIO_TRACE_OTEL_01_022: [ If span or written is NULL, or buffer is NULL while buffer_size is not 0, xio_trace_otel_format_span shall fail and return a non-zero value. ]*/
+        LogError("invalid argument const XIO_TRACE_OTEL_SPAN* span=%p, char* buffer=%p, size_t buffer_size=%lu, size_t* written=%p", span, buffer, (unsigned long)buffer_size, written);
+        result = __FAILURE__;
+    }
+    else
+    {
+        char trace_id[33];
+        char span_id[17];
+        char parent_span_id[17];
+        static const uint8_t no_parent[8] = { 0 };
+        int length;
+
+        write_hex(trace_id, span->trace_id, sizeof(span->trace_id));
+        write_hex(span_id, span->span_id, sizeof(span->span_id));
+        if (memcmp(span->parent_span_id, no_parent, sizeof(no_parent)) == 0)
+        {
+            parent_span_id[0] = '\0';
+        }
+        else
+        {
+            write_hex(parent_span_id, span->parent_span_id, sizeof(span->parent_span_id));
+        }
+
+        /* Codes_SRS_XIO_TRACE_OTEL_01_023: [ xio_trace_otel_format_span shall write span as an OTLP/JSON Span object: the ids in lower case hex (an empty parentSpanId for the outermost span), the name made of the layer name and the operation, the kind SPAN_KIND_INTERNAL, the times as decimal strings, the layer name, operation, size and result as xio.* attributes, and a status code of STATUS_CODE_OK when result is 0, STATUS_CODE_ERROR otherwise. ]*/
+        length = snprintf(buffer, buffer_size,
+            "{\"traceId\":\"%s\",\"spanId\":\"%s\",\"parentSpanId\":\"%s\",\"name\":\"%s %s\",\"kind\":1,"
+            "\"startTimeUnixNano\":\"%llu\",\"endTimeUnixNano\":\"%llu\","
+            "\"attributes\":[{\"key\":\"xio.layer\",\"value\":{\"stringValue\":\"%s\"}},"
+            "{\"key\":\"xio.operation\",\"value\":{\"stringValue\":\"%s\"}},"
+            "{\"key\":\"xio.size\",\"value\":{\"intValue\":\"%llu\"}},"
+            "{\"key\":\"xio.result\",\"value\":{\"intValue\":\"%d\"}}],"
+            "\"status\":{\"code\":%d}}",
+            trace_id, span_id, parent_span_id,
+            (span->layer_name == NULL) ? "xio" : span->layer_name, (span->operation == NULL) ? "send" : span->operation,
+            (unsigned long long)span->start_time_unix_nano, (unsigned long long)span->end_time_unix_nano,
+            (span->layer_name == NULL) ? "xio" : span->layer_name, (span->operation == NULL) ? "send" : span->operation,
+            (unsigned long long)span->size,
+            span->result,
+            (span->result == 0) ? 1 : 2);
+        if (length < 0)
+        {
+            /* Codes_SRS_XIO_TRACE_OTEL_01_025: [ If formatting fails, xio_trace_otel_format_span shall fail and return a non-zero value. ]*/
+            LogError("failure in snprintf");
+            result = __FAILURE__;
+        }
+        else
+        {
+            *written = (size_t)length;
+
+            if ((size_t)length >= buffer_size)
+            {
+                /* Codes_SRS_XIO_TRACE_OTEL_01_024: [ If buffer_size cannot hold the object and its '\0', xio_trace_otel_format_span shall set written to the length of the object and fail with a non-zero value. ]*/
+                result = __FAILURE__;
+            }
+            else
+            {
+                /* Codes_SRS_XIO_TRACE_OTEL_01_026: [ On success xio_trace_otel_format_span shall set written to the length of the object, without the '\0', and return 0. ]*/
+                result = 0;
+            }
+        }
+    }
+
+    return result;
+}
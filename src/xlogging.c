@@ -1,6 +1,7 @@
 // Copyright (c) Microsoft. All rights reserved.
 // Licensed under the MIT license. See LICENSE file in the project root for full license information.
 
+#include <string.h>
 #include "azure_c_shared_utility/xlogging.h"
 #include "azure_c_shared_utility/consolelogger.h"
 
@@ -19,16 +20,18 @@ void consolelogger_log(LOG_CATEGORY log_category, const char* file, const char*
     va_list args;
     va_start(args, format);
 
-    time_t t = time(NULL);
-
     switch (log_category)
     {
     case AZ_LOG_INFO:
         (void)printf("Info: ");
         break;
     case AZ_LOG_ERROR:
+    {
+        /* only errors print the time, and WinCE has neither thread locals nor ctime_s to cache it */
+        time_t t = time(NULL);
         (void)printf("Error: Time:%.24s File:%s Func:%s Line:%d ", ctime(&t), file, func, line);
         break;
+    }
     default:
         break;
     }
@@ -42,6 +45,12 @@ void consolelogger_log(LOG_CATEGORY log_category, const char* file, const char*
         (void)printf("\r\n");
     }
 }
+
+void consolelogger_set_monotonic_timestamp(bool enabled)
+{
+    /* WinCE lines carry no monotonic timestamp */
+    (void)enabled;
+}
 #endif // WINCE
 
 LOGGER_LOG global_log_function = consolelogger_log;
@@ -56,6 +65,18 @@ LOGGER_LOG xlogging_get_log_function(void)
     return global_log_function;
 }
 
+static LOG_CATEGORY global_log_level = AZ_LOG_TRACE;
+
+void xlogging_set_log_level(LOG_CATEGORY log_level)
+{
+    global_log_level = log_level;
+}
+
+LOG_CATEGORY xlogging_get_log_level(void)
+{
+    return global_log_level;
+}
+
 #if (defined(_MSC_VER)) && (!(defined WINCE))
 
 LOGGER_LOG_GETLASTERROR global_log_function_GetLastError = consolelogger_log_with_GetLastError;
@@ -77,64 +98,69 @@ LOGGER_LOG_GETLASTERROR xlogging_get_log_function_GetLastError(void)
 /* Return the printable char for the provided value. */
 #define PRINTABLE(c)         ((c >= ' ') && (c <= '~')) ? (char)c : '.'
 
-/* Convert the lower nibble of the provided byte to a hexadecimal printable char. */
-#define HEX_STR(c)           (((c) & 0xF) < 0xA) ? (char)(((c) & 0xF) + '0') : (char)(((c) & 0xF) - 0xA + 'A')
+static const char hex_digits[] = "0123456789ABCDEF";
+
+/* 0 dumps the whole buffer */
+static size_t global_log_binary_max_size = 0;
+
+void xlogging_set_log_binary_max_size(size_t max_size)
+{
+    global_log_binary_max_size = max_size;
+}
+
+size_t xlogging_get_log_binary_max_size(void)
+{
+    return global_log_binary_max_size;
+}
+
+/* Formats count (at most LINE_SIZE) bytes as one line, the hex column padded to a full line. */
+static void format_binary_line(const unsigned char* bytes, size_t count, char* hexBuf, char* charBuf)
+{
+    size_t i;
+    char* hex = hexBuf;
+
+    for (i = 0; i < count; i++)
+    {
+        hex[0] = hex_digits[bytes[i] >> 4];
+        hex[1] = hex_digits[bytes[i] & 0xF];
+        hex[2] = ' ';
+        hex += 3;
+        charBuf[i] = PRINTABLE(bytes[i]);
+    }
+    charBuf[count] = '\0';
+
+    /* Fill the rest of the line with spaces to keep the charBuf alignment. */
+    (void)memset(hex, ' ', (LINE_SIZE - count) * 3);
+    hexBuf[LINE_SIZE * 3] = '\0';
+}
 
 void LogBinary(const char* comment, const void* data, size_t size)
 {
     char charBuf[LINE_SIZE + 1];
     char hexBuf[LINE_SIZE * 3 + 1];
-    size_t countbuf = 0;
-    size_t i = 0;
     const unsigned char* bufAsChar = (const unsigned char*)data;
-    const unsigned char* startPos = bufAsChar;
-
-    LOG(AZ_LOG_TRACE, LOG_LINE, "%s     %lu bytes", comment, (unsigned long)size);
+    size_t max_size = global_log_binary_max_size;
+    size_t dump_size;
+    size_t offset;
 
-    /* Print the whole buffer. */
-    for (i = 0; i < size; i++)
+    /* no need to go through the buffer if none of its lines gets logged */
+    if ((LOG_LEVEL_MIN == AZ_LOG_LEVEL_TRACE) && (xlogging_get_log_level() == AZ_LOG_TRACE) && (xlogging_get_log_function() != NULL))
     {
-        /* Store the printable value of the char in the charBuf to print. */
-        charBuf[countbuf] = PRINTABLE(*bufAsChar);
-
-        /* Convert the high nibble to a printable hexadecimal value. */
-        hexBuf[countbuf * 3] = HEX_STR(*bufAsChar >> 4);
-
-        /* Convert the low nibble to a printable hexadecimal value. */
-        hexBuf[countbuf * 3 + 1] = HEX_STR(*bufAsChar);
+        LOG(AZ_LOG_TRACE, LOG_LINE, "%s     %lu bytes", comment, (unsigned long)size);
 
-        hexBuf[countbuf * 3 + 2] = ' ';
+        dump_size = ((max_size != 0) && (size > max_size)) ? max_size : size;
 
-        countbuf++;
-        bufAsChar++;
-        /* If the line is full, print it to start another one. */
-        if (countbuf == LINE_SIZE)
+        for (offset = 0; offset < dump_size; offset += LINE_SIZE)
         {
-            charBuf[countbuf] = '\0';
-            hexBuf[countbuf * 3] = '\0';
-            LOG(AZ_LOG_TRACE, LOG_LINE, "%p: %s    %s", startPos, hexBuf, charBuf);
-            countbuf = 0;
-            startPos = bufAsChar;
+            size_t count = (dump_size - offset < LINE_SIZE) ? (dump_size - offset) : LINE_SIZE;
+            format_binary_line(bufAsChar + offset, count, hexBuf, charBuf);
+            LOG(AZ_LOG_TRACE, LOG_LINE, "%p: %s    %s", (const void*)(bufAsChar + offset), hexBuf, charBuf);
         }
-    }
-
-    /* If the last line does not fit the line size. */
-    if (countbuf > 0)
-    {
-        /* Close the charBuf string. */
-        charBuf[countbuf] = '\0';
 
-        /* Fill the hexBuf with spaces to keep the charBuf alignment. */
-        while ((countbuf++) < LINE_SIZE - 1)
+        if (dump_size < size)
         {
-            hexBuf[countbuf * 3] = ' ';
-            hexBuf[countbuf * 3 + 1] = ' ';
-            hexBuf[countbuf * 3 + 2] = ' ';
+            LOG(AZ_LOG_TRACE, LOG_LINE, "... %lu more bytes not dumped", (unsigned long)(size - dump_size));
         }
-        hexBuf[countbuf * 3] = '\0';
-
-        /* Print the last line. */
-        LOG(AZ_LOG_TRACE, LOG_LINE, "%p: %s    %s", startPos, hexBuf, charBuf);
     }
 }
 
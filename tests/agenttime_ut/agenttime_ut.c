@@ -72,6 +72,19 @@ BEGIN_TEST_SUITE(agenttime_unittests)
             ASSERT_ARE_EQUAL(int, (int)result, (int)t);
         }
 
+        /* Tests_SRS_AGENT_TIME_01_004: [ get_time_coarse shall return the current time with at least one second resolution, or (time_t)-1 if it is not available. ]*/
+        TEST_FUNCTION(get_time_coarse_is_within_a_second_of_get_time)
+        {
+            ///act
+            time_t before = get_time(NULL);
+            time_t result = get_time_coarse();
+            time_t after = get_time(NULL);
+
+            ///assert
+            ASSERT_IS_TRUE(get_difftime(result, before) >= -1.0);
+            ASSERT_IS_TRUE(get_difftime(after, result) >= 0.0);
+        }
+
         TEST_FUNCTION(get_gmtime_success)
         {
             ///act
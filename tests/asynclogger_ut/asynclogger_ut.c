@@ -0,0 +1,654 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdarg>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdarg.h>
+#include <string.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#include "macro_utils.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/threadapi.h"
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/asynclogger.h"
+
+IMPLEMENT_UMOCK_C_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(COND_RESULT, COND_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(THREADAPI_RESULT, THREADAPI_RESULT_VALUES);
+
+static const LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4242;
+static const COND_HANDLE TEST_COND_HANDLE = (COND_HANDLE)0x4243;
+
+/* the writer thread does not run until it is joined, ThreadAPI_Join runs it on the test thread */
+static THREAD_START_FUNC test_thread_func;
+static void* test_thread_arg;
+static int test_thread_result;
+
+static THREADAPI_RESULT my_ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg)
+{
+    test_thread_func = func;
+    test_thread_arg = arg;
+    *threadHandle = (THREAD_HANDLE)&test_thread_func;
+    return THREADAPI_OK;
+}
+
+static THREADAPI_RESULT my_ThreadAPI_Join(THREAD_HANDLE threadHandle, int* res)
+{
+    (void)threadHandle;
+    *res = test_thread_func(test_thread_arg);
+    return THREADAPI_OK;
+}
+
+/* how many times Condition_Wait logs a line and returns COND_OK before returning COND_ERROR */
+static size_t g_condition_wait_ok_count;
+
+static COND_RESULT my_Condition_Wait(COND_HANDLE handle, LOCK_HANDLE lock, int timeout_milliseconds)
+{
+    COND_RESULT result;
+
+    (void)handle;
+    (void)lock;
+    (void)timeout_milliseconds;
+
+    if (g_condition_wait_ok_count == 0)
+    {
+        result = COND_ERROR;
+    }
+    else
+    {
+        g_condition_wait_ok_count--;
+        asynclogger_log(AZ_LOG_INFO, "wait.c", "wait", 1, 0, "logged while waiting");
+        result = COND_OK;
+    }
+
+    return result;
+}
+
+/* the lines handed to the output logger */
+#define TEST_MAX_LINES 1100
+
+typedef struct TEST_LINE_TAG
+{
+    LOG_CATEGORY log_category;
+    const char* file;
+    const char* func;
+    int line;
+    unsigned int options;
+    char message[512];
+} TEST_LINE;
+
+static TEST_LINE test_lines[TEST_MAX_LINES];
+static size_t test_line_count;
+
+static void test_output(LOG_CATEGORY log_category, const char* file, const char* func, int line, unsigned int options, const char* format, ...)
+{
+    va_list args;
+
+    ASSERT_IS_TRUE(test_line_count < TEST_MAX_LINES);
+    test_lines[test_line_count].log_category = log_category;
+    test_lines[test_line_count].file = file;
+    test_lines[test_line_count].func = func;
+    test_lines[test_line_count].line = line;
+    test_lines[test_line_count].options = options;
+    va_start(args, format);
+    (void)vsnprintf(test_lines[test_line_count].message, sizeof(test_lines[test_line_count].message), format, args);
+    va_end(args);
+    test_line_count++;
+}
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+static void init_logger(size_t entry_count)
+{
+    int result = asynclogger_init(entry_count, test_output);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    umock_c_reset_all_calls();
+}
+
+static void setup_deinit_expectations(void)
+{
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Deinit(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+}
+
+BEGIN_TEST_SUITE(asynclogger_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result, "umock_c_init");
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_charptr_register_types");
+
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(COND_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_START_FUNC, void*);
+    REGISTER_TYPE(LOCK_RESULT, LOCK_RESULT);
+    REGISTER_TYPE(COND_RESULT, COND_RESULT);
+    REGISTER_TYPE(THREADAPI_RESULT, THREADAPI_RESULT);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Init, TEST_COND_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Post, COND_OK);
+    REGISTER_GLOBAL_MOCK_HOOK(Condition_Wait, my_Condition_Wait);
+    REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Create, my_ThreadAPI_Create);
+    REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Join, my_ThreadAPI_Join);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    test_thread_func = NULL;
+    test_thread_arg = NULL;
+    test_thread_result = 0;
+    g_condition_wait_ok_count = 0;
+    test_line_count = 0;
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/* asynclogger_init */
+
+/* Tests_SRS_ASYNCLOGGER_01_002: [ asynclogger_init shall allocate a ring of entry_count entries rounded up to a power of 2, or of 1024 entries if entry_count is 0. ]*/
+/* Tests_SRS_ASYNCLOGGER_01_003: [ asynclogger_init shall create a lock and a condition. ]*/
+/* Tests_SRS_ASYNCLOGGER_01_005: [ asynclogger_init shall start the writer thread with ThreadAPI_Create, reset the dropped count and return 0. ]*/
+TEST_FUNCTION(asynclogger_init_allocates_the_ring_and_starts_the_writer_thread)
+{
+    // arrange
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init());
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = asynclogger_init(16, test_output);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, asynclogger_get_dropped_count());
+
+    // cleanup
+    asynclogger_deinit();
+}
+
+/* Tests_SRS_ASYNCLOGGER_01_001: [ If the logger is already initialized, asynclogger_init shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(asynclogger_init_when_already_initialized_fails)
+{
+    // arrange
+    int result;
+    init_logger(16);
+
+    // act
+    result = asynclogger_init(16, test_output);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    asynclogger_deinit();
+}
+
+/* Tests_SRS_ASYNCLOGGER_01_006: [ If any failure occurs, asynclogger_init shall free what it allocated and return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_the_logger_fails_asynclogger_init_fails)
+{
+    // arrange
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = asynclogger_init(16, test_output);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_ASYNCLOGGER_01_006: [ If any failure occurs, asynclogger_init shall free what it allocated and return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_the_ring_fails_asynclogger_init_fails)
+{
+    // arrange
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = asynclogger_init(16, test_output);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_ASYNCLOGGER_01_006: [ If any failure occurs, asynclogger_init shall free what it allocated and return a non-zero value. ]*/
+TEST_FUNCTION(when_Lock_Init_fails_asynclogger_init_fails)
+{
+    // arrange
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = asynclogger_init(16, test_output);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_ASYNCLOGGER_01_006: [ If any failure occurs, asynclogger_init shall free what it allocated and return a non-zero value. ]*/
+TEST_FUNCTION(when_Condition_Init_fails_asynclogger_init_fails)
+{
+    // arrange
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = asynclogger_init(16, test_output);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_ASYNCLOGGER_01_006: [ If any failure occurs, asynclogger_init shall free what it allocated and return a non-zero value. ]*/
+TEST_FUNCTION(when_ThreadAPI_Create_fails_asynclogger_init_fails)
+{
+    // arrange
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init());
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(THREADAPI_ERROR);
+    STRICT_EXPECTED_CALL(Condition_Deinit(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = asynclogger_init(16, test_output);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    asynclogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "not initialized");
+    ASSERT_ARE_EQUAL(size_t, 1, asynclogger_get_dropped_count());
+}
+
+/* Tests_SRS_ASYNCLOGGER_01_002: [ asynclogger_init shall allocate a ring of entry_count entries rounded up to a power of 2, or of 1024 entries if entry_count is 0. ]*/
+/* Tests_SRS_ASYNCLOGGER_01_013: [ If the ring is full, asynclogger_log shall drop the line and count it. ]*/
+TEST_FUNCTION(asynclogger_init_rounds_entry_count_up_to_a_power_of_2)
+{
+    // arrange
+    size_t i;
+    init_logger(3);
+
+    // act
+    for (i = 0; i < 5; i++)
+    {
+        asynclogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "line %d", (int)i);
+    }
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, asynclogger_get_dropped_count());
+
+    // cleanup
+    asynclogger_deinit();
+    ASSERT_ARE_EQUAL(size_t, 4, test_line_count);
+}
+
+/* Tests_SRS_ASYNCLOGGER_01_002: [ asynclogger_init shall allocate a ring of entry_count entries rounded up to a power of 2, or of 1024 entries if entry_count is 0. ]*/
+TEST_FUNCTION(asynclogger_init_with_0_entry_count_allocates_1024_entries)
+{
+    // arrange
+    size_t i;
+    init_logger(0);
+
+    // act
+    for (i = 0; i < 1025; i++)
+    {
+        asynclogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "line %d", (int)i);
+    }
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, asynclogger_get_dropped_count());
+
+    // cleanup
+    asynclogger_deinit();
+    ASSERT_ARE_EQUAL(size_t, 1024, test_line_count);
+}
+
+/* Tests_SRS_ASYNCLOGGER_01_005: [ asynclogger_init shall start the writer thread with ThreadAPI_Create, reset the dropped count and return 0. ]*/
+TEST_FUNCTION(asynclogger_init_resets_the_dropped_count)
+{
+    // arrange
+    asynclogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "not initialized");
+    ASSERT_ARE_NOT_EQUAL(size_t, 0, asynclogger_get_dropped_count());
+
+    // act
+    init_logger(16);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, asynclogger_get_dropped_count());
+
+    // cleanup
+    asynclogger_deinit();
+}
+
+/* Tests_SRS_ASYNCLOGGER_01_004: [ If output is NULL, the writer thread shall write the lines with consolelogger_log. ]*/
+TEST_FUNCTION(asynclogger_init_with_NULL_output_writes_to_the_console)
+{
+    // arrange
+    int result = asynclogger_init(16, NULL);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    asynclogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "written by consolelogger_log");
+
+    // act
+    asynclogger_deinit();
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, test_line_count);
+}
+
+/* asynclogger_deinit */
+
+/* Tests_SRS_ASYNCLOGGER_01_007: [ If the logger is not initialized, asynclogger_deinit shall return. ]*/
+TEST_FUNCTION(asynclogger_deinit_when_not_initialized_returns)
+{
+    // arrange
+
+    // act
+    asynclogger_deinit();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_ASYNCLOGGER_01_008: [ asynclogger_deinit shall tell the writer thread to stop once the ring is empty, wake it and wait for it with ThreadAPI_Join. ]*/
+/* Tests_SRS_ASYNCLOGGER_01_009: [ asynclogger_deinit shall free the condition, the lock and the ring. ]*/
+/* Tests_SRS_ASYNCLOGGER_01_018: [ Once asynclogger_deinit was called and the ring is empty, the writer thread shall exit. ]*/
+TEST_FUNCTION(asynclogger_deinit_stops_the_writer_thread_and_frees_the_ring)
+{
+    // arrange
+    init_logger(16);
+    setup_deinit_expectations();
+
+    // act
+    asynclogger_deinit();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, test_line_count);
+}
+
+/* Tests_SRS_ASYNCLOGGER_01_008: [ asynclogger_deinit shall tell the writer thread to stop once the ring is empty, wake it and wait for it with ThreadAPI_Join. ]*/
+/* Tests_SRS_ASYNCLOGGER_01_016: [ The writer thread shall call the output logger with the category, file, function, line and options of each line, in the order in which the lines were added to the ring. ]*/
+TEST_FUNCTION(asynclogger_deinit_writes_the_lines_left_in_the_ring_in_order)
+{
+    // arrange
+    init_logger(16);
+    asynclogger_log(AZ_LOG_ERROR, "a.c", "func_a", 11, LOG_LINE, "first %d", 1);
+    asynclogger_log(AZ_LOG_INFO, "b.c", "func_b", 22, 0, "second %s", "line");
+    asynclogger_log(AZ_LOG_TRACE, "c.c", "func_c", 33, LOG_LINE, "third");
+    setup_deinit_expectations();
+
+    // act
+    asynclogger_deinit();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 3, test_line_count);
+    ASSERT_ARE_EQUAL(int, (int)AZ_LOG_ERROR, (int)test_lines[0].log_category);
+    ASSERT_ARE_EQUAL(char_ptr, "a.c", test_lines[0].file);
+    ASSERT_ARE_EQUAL(char_ptr, "func_a", test_lines[0].func);
+    ASSERT_ARE_EQUAL(int, 11, test_lines[0].line);
+    ASSERT_ARE_EQUAL(int, (int)LOG_LINE, (int)test_lines[0].options);
+    ASSERT_ARE_EQUAL(char_ptr, "first 1", test_lines[0].message);
+    ASSERT_ARE_EQUAL(int, (int)AZ_LOG_INFO, (int)test_lines[1].log_category);
+    ASSERT_ARE_EQUAL(char_ptr, "b.c", test_lines[1].file);
+    ASSERT_ARE_EQUAL(char_ptr, "func_b", test_lines[1].func);
+    ASSERT_ARE_EQUAL(int, 22, test_lines[1].line);
+    ASSERT_ARE_EQUAL(int, 0, (int)test_lines[1].options);
+    ASSERT_ARE_EQUAL(char_ptr, "second line", test_lines[1].message);
+    ASSERT_ARE_EQUAL(int, (int)AZ_LOG_TRACE, (int)test_lines[2].log_category);
+    ASSERT_ARE_EQUAL(char_ptr, "third", test_lines[2].message);
+}
+
+/* asynclogger_log */
+
+/* Tests_SRS_ASYNCLOGGER_01_010: [ asynclogger_get_dropped_count shall return the number of lines dropped since asynclogger_init. ]*/
+/* Tests_SRS_ASYNCLOGGER_01_011: [ If the logger is not initialized or format is NULL, asynclogger_log shall drop the line and count it. ]*/
+TEST_FUNCTION(asynclogger_log_when_not_initialized_counts_a_dropped_line)
+{
+    // arrange
+    init_logger(16);
+    asynclogger_deinit();
+    umock_c_reset_all_calls();
+
+    // act
+    asynclogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "dropped");
+    asynclogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "dropped");
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 2, asynclogger_get_dropped_count());
+}
+
+/* Tests_SRS_ASYNCLOGGER_01_011: [ If the logger is not initialized or format is NULL, asynclogger_log shall drop the line and count it. ]*/
+TEST_FUNCTION(asynclogger_log_with_NULL_format_counts_a_dropped_line)
+{
+    // arrange
+    init_logger(16);
+
+    // act
+    asynclogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, asynclogger_get_dropped_count());
+
+    // cleanup
+    asynclogger_deinit();
+    ASSERT_ARE_EQUAL(size_t, 0, test_line_count);
+}
+
+/* Tests_SRS_ASYNCLOGGER_01_012: [ asynclogger_log shall claim the next entry of the ring with a compare-and-swap, without taking a lock. ]*/
+/* Tests_SRS_ASYNCLOGGER_01_014: [ asynclogger_log shall format the line into the entry, truncating it to the size of the entry, and store the category, file, function, line and options. ]*/
+TEST_FUNCTION(asynclogger_log_does_not_allocate_or_lock_when_the_writer_thread_is_not_waiting)
+{
+    // arrange
+    init_logger(16);
+
+    // act
+    asynclogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "no lock %d", 42);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, asynclogger_get_dropped_count());
+
+    // cleanup
+    asynclogger_deinit();
+    ASSERT_ARE_EQUAL(size_t, 1, test_line_count);
+    ASSERT_ARE_EQUAL(char_ptr, "no lock 42", test_lines[0].message);
+}
+
+/* Tests_SRS_ASYNCLOGGER_01_013: [ If the ring is full, asynclogger_log shall drop the line and count it. ]*/
+TEST_FUNCTION(asynclogger_log_when_the_ring_is_full_counts_a_dropped_line)
+{
+    // arrange
+    init_logger(2);
+    asynclogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "first");
+    asynclogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "second");
+
+    // act
+    asynclogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "third");
+    asynclogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "fourth");
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, asynclogger_get_dropped_count());
+
+    // cleanup
+    asynclogger_deinit();
+    ASSERT_ARE_EQUAL(size_t, 2, test_line_count);
+    ASSERT_ARE_EQUAL(char_ptr, "first", test_lines[0].message);
+    ASSERT_ARE_EQUAL(char_ptr, "second", test_lines[1].message);
+}
+
+/* Tests_SRS_ASYNCLOGGER_01_014: [ asynclogger_log shall format the line into the entry, truncating it to the size of the entry, and store the category, file, function, line and options. ]*/
+TEST_FUNCTION(asynclogger_log_truncates_long_lines)
+{
+    // arrange
+    char long_line[400];
+    (void)memset(long_line, 'x', sizeof(long_line) - 1);
+    long_line[sizeof(long_line) - 1] = '\0';
+    init_logger(16);
+
+    // act
+    asynclogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "%s", long_line);
+
+    // assert
+    asynclogger_deinit();
+    ASSERT_ARE_EQUAL(size_t, 1, test_line_count);
+    ASSERT_ARE_EQUAL(size_t, 255, strlen(test_lines[0].message));
+    ASSERT_ARE_EQUAL(int, 0, strncmp(long_line, test_lines[0].message, 255));
+}
+
+/* Tests_SRS_ASYNCLOGGER_01_015: [ If the writer thread is waiting, asynclogger_log shall post the condition while holding the lock. ]*/
+/* Tests_SRS_ASYNCLOGGER_01_016: [ The writer thread shall call the output logger with the category, file, function, line and options of each line, in the order in which the lines were added to the ring. ]*/
+/* Tests_SRS_ASYNCLOGGER_01_017: [ When the ring is empty, the writer thread shall wait on a condition. ]*/
+TEST_FUNCTION(asynclogger_log_wakes_the_waiting_writer_thread)
+{
+    // arrange
+    init_logger(16);
+    g_condition_wait_ok_count = 1;
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, TEST_LOCK_HANDLE, 0));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, TEST_LOCK_HANDLE, 0));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    /* the writer thread waits, a line is logged, the writer thread writes it and waits again, which fails */
+    test_thread_result = test_thread_func(test_thread_arg);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, test_thread_result);
+    ASSERT_ARE_EQUAL(size_t, 1, test_line_count);
+    ASSERT_ARE_EQUAL(char_ptr, "wait.c", test_lines[0].file);
+    ASSERT_ARE_EQUAL(char_ptr, "logged while waiting", test_lines[0].message);
+
+    // cleanup
+    asynclogger_deinit();
+}
+
+/* Tests_SRS_ASYNCLOGGER_01_017: [ When the ring is empty, the writer thread shall wait on a condition. ]*/
+TEST_FUNCTION(when_Lock_fails_the_writer_thread_exits)
+{
+    // arrange
+    init_logger(16);
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE))
+        .SetReturn(LOCK_ERROR);
+
+    // act
+    test_thread_result = test_thread_func(test_thread_arg);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, test_thread_result);
+
+    // cleanup
+    asynclogger_deinit();
+}
+
+END_TEST_SUITE(asynclogger_unittests)
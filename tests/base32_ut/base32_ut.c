@@ -507,4 +507,227 @@ BEGIN_TEST_SUITE(base32_ut)
         STRING_delete(input);
     }
 
+    /* Tests_SRS_BASE32_01_001: [ Base32_Encoded_Length shall return the number of characters in the base32 encoding of size bytes, not counting the terminating '\0'. ] */
+    TEST_FUNCTION(Base32_Encoded_Length_success)
+    {
+        size_t index;
+        size_t num_elements = sizeof(test_val_len) / sizeof(test_val_len[0]);
+
+        //arrange
+
+        //act
+        for (index = 0; index < num_elements; index++)
+        {
+            //assert
+            ASSERT_ARE_EQUAL(size_t, strlen(test_val_len[index].base32_data), Base32_Encoded_Length(test_val_len[index].input_len));
+        }
+        ASSERT_ARE_EQUAL(size_t, 0, Base32_Encoded_Length(0));
+    }
+
+    /* Tests_SRS_BASE32_01_002: [ If the encoding of size bytes cannot be represented in a size_t, Base32_Encoded_Length shall return 0. ] */
+    TEST_FUNCTION(Base32_Encoded_Length_too_large_returns_0)
+    {
+        //arrange
+
+        //act
+        size_t result = Base32_Encoded_Length((size_t)-1);
+
+        //assert
+        ASSERT_ARE_EQUAL(size_t, 0, result);
+    }
+
+    /* Tests_SRS_BASE32_01_003: [ If source is NULL and size is not 0, or destination is NULL, Base32_Encode_To shall fail and return a non-zero value. ] */
+    TEST_FUNCTION(Base32_Encode_To_source_NULL_fail)
+    {
+        char destination[32];
+
+        //arrange
+
+        //act
+        int result = Base32_Encode_To(NULL, 1, destination, sizeof(destination));
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    }
+
+    /* Tests_SRS_BASE32_01_003: [ If source is NULL and size is not 0, or destination is NULL, Base32_Encode_To shall fail and return a non-zero value. ] */
+    TEST_FUNCTION(Base32_Encode_To_destination_NULL_fail)
+    {
+        //arrange
+
+        //act
+        int result = Base32_Encode_To(test_val_len[0].input_data, test_val_len[0].input_len, NULL, 32);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    }
+
+    /* Tests_SRS_BASE32_01_004: [ If destination_size is less than Base32_Encoded_Length(size) + 1, Base32_Encode_To shall fail and return a non-zero value. ] */
+    TEST_FUNCTION(Base32_Encode_To_destination_too_small_fail)
+    {
+        char destination[8];
+
+        //arrange
+
+        //act
+        int result = Base32_Encode_To(test_val_len[0].input_data, test_val_len[0].input_len, destination, sizeof(destination));
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    }
+
+    /* Tests_SRS_BASE32_01_005: [ Otherwise Base32_Encode_To shall write the base32 encoding of source, followed by a '\0', to destination and return 0. ] */
+    TEST_FUNCTION(Base32_Encode_To_success)
+    {
+        size_t index;
+        size_t num_elements = sizeof(test_val_len) / sizeof(test_val_len[0]);
+
+        //arrange
+
+        //act
+        for (index = 0; index < num_elements; index++)
+        {
+            char destination[64];
+            char tmp_msg[64];
+            int result;
+            sprintf(tmp_msg, "Base32_Encode_To failure in test %lu", (unsigned long)index);
+
+            result = Base32_Encode_To(test_val_len[index].input_data, test_val_len[index].input_len, destination, strlen(test_val_len[index].base32_data) + 1);
+
+            //assert
+            ASSERT_ARE_EQUAL(int, 0, result, tmp_msg);
+            ASSERT_ARE_EQUAL(char_ptr, test_val_len[index].base32_data, destination, tmp_msg);
+        }
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_BASE32_01_006: [ If source is NULL, Base32_Decoded_Length shall return 0. ] */
+    /* Tests_SRS_BASE32_01_007: [ If the length of source is not a multiple of 8, Base32_Decoded_Length shall return 0. ] */
+    TEST_FUNCTION(Base32_Decoded_Length_invalid_source_returns_0)
+    {
+        //arrange
+
+        //act
+        size_t null_result = Base32_Decoded_Length(NULL);
+        size_t length_result = Base32_Decoded_Length("invalid_string");
+
+        //assert
+        ASSERT_ARE_EQUAL(size_t, 0, null_result);
+        ASSERT_ARE_EQUAL(size_t, 0, length_result);
+    }
+
+    /* Tests_SRS_BASE32_01_008: [ Otherwise Base32_Decoded_Length shall return the number of bytes source decodes to. ] */
+    TEST_FUNCTION(Base32_Decoded_Length_success)
+    {
+        size_t index;
+        size_t num_elements = sizeof(test_val_len) / sizeof(test_val_len[0]);
+
+        //arrange
+
+        //act
+        for (index = 0; index < num_elements; index++)
+        {
+            //assert
+            ASSERT_ARE_EQUAL(size_t, test_val_len[index].input_len, Base32_Decoded_Length(test_val_len[index].base32_data));
+        }
+    }
+
+    /* Tests_SRS_BASE32_01_009: [ If source or decoded_size is NULL, or destination is NULL and destination_size is not 0, Base32_Decode_To shall fail and return a non-zero value. ] */
+    TEST_FUNCTION(Base32_Decode_To_invalid_arguments_fail)
+    {
+        unsigned char destination[16];
+        size_t decoded_size;
+
+        //arrange
+
+        //act
+        int null_source_result = Base32_Decode_To(NULL, destination, sizeof(destination), &decoded_size);
+        int null_destination_result = Base32_Decode_To(test_val_len[0].base32_data, NULL, sizeof(destination), &decoded_size);
+        int null_decoded_size_result = Base32_Decode_To(test_val_len[0].base32_data, destination, sizeof(destination), NULL);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, null_source_result);
+        ASSERT_ARE_NOT_EQUAL(int, 0, null_destination_result);
+        ASSERT_ARE_NOT_EQUAL(int, 0, null_decoded_size_result);
+    }
+
+    /* Tests_SRS_BASE32_01_010: [ If source is not a valid base32 encoding (its length is not a multiple of 8 or it contains characters other than the base32 alphabet in either case and the padding of its last block), Base32_Decode_To shall fail and return a non-zero value. ] */
+    TEST_FUNCTION(Base32_Decode_To_invalid_encoding_fail)
+    {
+        static const char* invalid_encodings[] = { "invalid_string", "aebagba1", "aebag{af", "ae=====a", "a=======", "aea=====", "========", "aeaeaeae========" };
+        unsigned char destination[16];
+        size_t decoded_size;
+        size_t index;
+
+        //arrange
+
+        //act
+        for (index = 0; index < sizeof(invalid_encodings) / sizeof(invalid_encodings[0]); index++)
+        {
+            int result = Base32_Decode_To(invalid_encodings[index], destination, sizeof(destination), &decoded_size);
+
+            //assert
+            ASSERT_ARE_NOT_EQUAL(int, 0, result, invalid_encodings[index]);
+        }
+    }
+
+    /* Tests_SRS_BASE32_01_011: [ If destination_size is less than the number of bytes source decodes to, Base32_Decode_To shall fail and return a non-zero value. ] */
+    TEST_FUNCTION(Base32_Decode_To_destination_too_small_fail)
+    {
+        unsigned char destination[5];
+        size_t decoded_size;
+
+        //arrange
+
+        //act
+        int result = Base32_Decode_To("mzxw6ytboi======", destination, sizeof(destination), &decoded_size);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    }
+
+    /* Tests_SRS_BASE32_01_012: [ Otherwise Base32_Decode_To shall write the decoded bytes to destination, set decoded_size to their number and return 0. ] */
+    TEST_FUNCTION(Base32_Decode_To_success)
+    {
+        size_t index;
+        size_t num_elements = sizeof(test_val_len) / sizeof(test_val_len[0]);
+
+        //arrange
+
+        //act
+        for (index = 0; index < num_elements; index++)
+        {
+            unsigned char destination[32];
+            size_t decoded_size = 0;
+            char tmp_msg[64];
+            int result;
+            sprintf(tmp_msg, "Base32_Decode_To failure in test %lu", (unsigned long)index);
+
+            result = Base32_Decode_To(test_val_len[index].base32_data, destination, test_val_len[index].input_len, &decoded_size);
+
+            //assert
+            ASSERT_ARE_EQUAL(int, 0, result, tmp_msg);
+            ASSERT_ARE_EQUAL(size_t, test_val_len[index].input_len, decoded_size, tmp_msg);
+            ASSERT_ARE_EQUAL(int, 0, memcmp(test_val_len[index].input_data, destination, decoded_size), tmp_msg);
+        }
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_BASE32_01_012: [ Otherwise Base32_Decode_To shall write the decoded bytes to destination, set decoded_size to their number and return 0. ] */
+    TEST_FUNCTION(Base32_Decode_To_upper_case_success)
+    {
+        unsigned char destination[8];
+        size_t decoded_size = 0;
+
+        //arrange
+
+        //act
+        int result = Base32_Decode_To("MZXW6YTBOI======", destination, sizeof(destination), &decoded_size);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, 6, decoded_size);
+        ASSERT_ARE_EQUAL(int, 0, memcmp("foobar", destination, 6));
+    }
+
 END_TEST_SUITE(base32_ut)
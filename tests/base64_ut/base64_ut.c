@@ -36,6 +36,8 @@ static void my_gballoc_free(void* ptr)
 #include "azure_c_shared_utility/base64.h"
 #include "azure_c_shared_utility/strings.h"
 #include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/constbuffer.h"
+#include "azure_c_shared_utility/constbuffer_array.h"
 
 static const struct
 {
@@ -1800,5 +1802,674 @@ TEST_FUNCTION(Base64_Decoder_invalid_length_fails_6)
 
 }
 
+/*Tests_SRS_BASE64_01_038: [ If source contains characters other than the base64 alphabet and up to two trailing '=', Base64_Decoder shall return NULL. ]*/
+TEST_FUNCTION(Base64_Decoder_with_an_invalid_character_fails)
+{
+    ///Arrange
+    BUFFER_HANDLE result;
+
+    ///act
+    result = Base64_Decoder("Zm9v!mFy");
+
+    ///assert
+    ASSERT_IS_NULL(result);
+}
+
+/*Tests_SRS_BASE64_01_038: [ If source contains characters other than the base64 alphabet and up to two trailing '=', Base64_Decoder shall return NULL. ]*/
+TEST_FUNCTION(Base64_Decoder_with_padding_before_the_last_group_fails)
+{
+    ///Arrange
+    BUFFER_HANDLE result;
+
+    ///act
+    result = Base64_Decoder("Zg==Zm9v");
+
+    ///assert
+    ASSERT_IS_NULL(result);
+}
+
+
+/*Tests_SRS_BASE64_01_001: [ Base64_Encoded_Length shall return the number of characters in the base64 encoding of size bytes, not counting the terminating '\0'. ]*/
+TEST_FUNCTION(Base64_Encoded_Length_returns_the_encoded_length)
+{
+    ///act
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, Base64_Encoded_Length(0));
+    ASSERT_ARE_EQUAL(size_t, 4, Base64_Encoded_Length(1));
+    ASSERT_ARE_EQUAL(size_t, 4, Base64_Encoded_Length(2));
+    ASSERT_ARE_EQUAL(size_t, 4, Base64_Encoded_Length(3));
+    ASSERT_ARE_EQUAL(size_t, 8, Base64_Encoded_Length(4));
+}
+
+/*Tests_SRS_BASE64_01_002: [ If the encoding of size bytes cannot be represented in a size_t, Base64_Encoded_Length shall return 0. ]*/
+TEST_FUNCTION(Base64_Encoded_Length_with_a_too_large_size_returns_0)
+{
+    ///act
+    size_t result = Base64_Encoded_Length((size_t)-1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_003: [ If source is NULL and size is not 0, or destination is NULL, Base64_Encode_To shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Encode_To_with_NULL_source_fails)
+{
+    ///arrange
+    char destination[8];
+
+    ///act
+    int result = Base64_Encode_To(NULL, 1, destination, sizeof(destination));
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_003: [ If source is NULL and size is not 0, or destination is NULL, Base64_Encode_To shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Encode_To_with_NULL_destination_fails)
+{
+    ///act
+    int result = Base64_Encode_To((const unsigned char*)"a", 1, NULL, 8);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_004: [ If destination_size is less than Base64_Encoded_Length(size) + 1, Base64_Encode_To shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Encode_To_with_a_too_small_destination_fails)
+{
+    ///arrange
+    char destination[4];
+
+    ///act
+    int result = Base64_Encode_To((const unsigned char*)"a", 1, destination, sizeof(destination));
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_005: [ Otherwise Base64_Encode_To shall write the base64 encoding of source, followed by a '\0', to destination and return 0. ]*/
+TEST_FUNCTION(Base64_Encode_To_with_zero_size_produces_an_empty_string)
+{
+    ///arrange
+    char destination[1] = { 'x' };
+
+    ///act
+    int result = Base64_Encode_To(NULL, 0, destination, sizeof(destination));
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, "", destination);
+}
+
+/*Tests_SRS_BASE64_01_005: [ Otherwise Base64_Encode_To shall write the base64 encoding of source, followed by a '\0', to destination and return 0. ]*/
+TEST_FUNCTION(Base64_Encode_To_exhaustive_succeeds)
+{
+    size_t i;
+    for (i = 0; i < sizeof(testVector_BINARY_with_equal_signs) / sizeof(testVector_BINARY_with_equal_signs[0]); i++)
+    {
+        ///arrange
+        char destination[32];
+        int result;
+        umock_c_reset_all_calls();
+
+        ///act
+        result = Base64_Encode_To(testVector_BINARY_with_equal_signs[i].inputData, testVector_BINARY_with_equal_signs[i].inputLength, destination, Base64_Encoded_Length(testVector_BINARY_with_equal_signs[i].inputLength) + 1);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, testVector_BINARY_with_equal_signs[i].expectedOutput, destination);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+}
+
+/*Tests_SRS_BASE64_01_006: [ If source is NULL, Base64_Decoded_Length shall return 0. ]*/
+TEST_FUNCTION(Base64_Decoded_Length_with_NULL_source_returns_0)
+{
+    ///act
+    size_t result = Base64_Decoded_Length(NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_007: [ If the length of source is not a multiple of 4, Base64_Decoded_Length shall return 0. ]*/
+TEST_FUNCTION(Base64_Decoded_Length_with_an_invalid_length_returns_0)
+{
+    ///act
+    size_t result = Base64_Decoded_Length("12345");
+
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_008: [ Otherwise Base64_Decoded_Length shall return the number of bytes source decodes to. ]*/
+TEST_FUNCTION(Base64_Decoded_Length_returns_the_decoded_length)
+{
+    ///act
+    ///assert
+    ASSERT_ARE_EQUAL(size_t, 0, Base64_Decoded_Length(""));
+    ASSERT_ARE_EQUAL(size_t, 1, Base64_Decoded_Length("AA=="));
+    ASSERT_ARE_EQUAL(size_t, 2, Base64_Decoded_Length("AAA="));
+    ASSERT_ARE_EQUAL(size_t, 3, Base64_Decoded_Length("AAAA"));
+}
+
+/*Tests_SRS_BASE64_01_009: [ If source or decoded_size is NULL, or destination is NULL and destination_size is not 0, Base64_Decode_To shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Decode_To_with_NULL_source_fails)
+{
+    ///arrange
+    unsigned char destination[3];
+    size_t decoded_size;
+
+    ///act
+    int result = Base64_Decode_To(NULL, destination, sizeof(destination), &decoded_size);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_009: [ If source or decoded_size is NULL, or destination is NULL and destination_size is not 0, Base64_Decode_To shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Decode_To_with_NULL_decoded_size_fails)
+{
+    ///arrange
+    unsigned char destination[3];
+
+    ///act
+    int result = Base64_Decode_To("AAAA", destination, sizeof(destination), NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_009: [ If source or decoded_size is NULL, or destination is NULL and destination_size is not 0, Base64_Decode_To shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Decode_To_with_NULL_destination_fails)
+{
+    ///arrange
+    size_t decoded_size;
+
+    ///act
+    int result = Base64_Decode_To("AAAA", NULL, 3, &decoded_size);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_010: [ If source is not a valid base64 encoding (its length is not a multiple of 4 or it contains characters other than the base64 alphabet and up to two trailing '='), Base64_Decode_To shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Decode_To_with_invalid_sources_fails)
+{
+    static const char* const invalid_sources[] = { "1", "12345", "AA=A", "A===", "====", "AA*A", "AAAA AAA" };
+    size_t i;
+    for (i = 0; i < sizeof(invalid_sources) / sizeof(invalid_sources[0]); i++)
+    {
+        ///arrange
+        unsigned char destination[8];
+        size_t decoded_size;
+
+        ///act
+        int result = Base64_Decode_To(invalid_sources[i], destination, sizeof(destination), &decoded_size);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result, invalid_sources[i]);
+    }
+}
+
+/*Tests_SRS_BASE64_01_011: [ If destination_size is less than the number of bytes source decodes to, Base64_Decode_To shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Decode_To_with_a_too_small_destination_fails)
+{
+    ///arrange
+    unsigned char destination[2];
+    size_t decoded_size;
+
+    ///act
+    int result = Base64_Decode_To("AAAA", destination, sizeof(destination), &decoded_size);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_012: [ Otherwise Base64_Decode_To shall write the decoded bytes to destination, set decoded_size to their number and return 0. ]*/
+TEST_FUNCTION(Base64_Decode_To_with_an_empty_source_succeeds)
+{
+    ///arrange
+    size_t decoded_size = 42;
+
+    ///act
+    int result = Base64_Decode_To("", NULL, 0, &decoded_size);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, decoded_size);
+}
+
+/*Tests_SRS_BASE64_01_012: [ Otherwise Base64_Decode_To shall write the decoded bytes to destination, set decoded_size to their number and return 0. ]*/
+TEST_FUNCTION(Base64_Decode_To_exhaustive_succeeds)
+{
+    size_t i;
+    for (i = 0; i < sizeof(testVector_BINARY_with_equal_signs) / sizeof(testVector_BINARY_with_equal_signs[0]); i++)
+    {
+        ///arrange
+        unsigned char destination[16];
+        size_t decoded_size;
+        int result;
+        umock_c_reset_all_calls();
+
+        ///act
+        result = Base64_Decode_To(testVector_BINARY_with_equal_signs[i].expectedOutput, destination, Base64_Decoded_Length(testVector_BINARY_with_equal_signs[i].expectedOutput), &decoded_size);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, testVector_BINARY_with_equal_signs[i].inputLength, decoded_size);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(destination, testVector_BINARY_with_equal_signs[i].inputData, decoded_size));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+}
+
+/*Tests_SRS_BASE64_01_013: [ If context is NULL, Base64_Encoder_Init shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Encoder_Init_with_NULL_context_fails)
+{
+    ///act
+    int result = Base64_Encoder_Init(NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_015: [ If context or written is NULL, or source is NULL and size is not 0, or destination is NULL and destination_size is not 0, Base64_Encoder_Update shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Encoder_Update_with_NULL_context_fails)
+{
+    ///arrange
+    char destination[4];
+    size_t written;
+
+    ///act
+    int result = Base64_Encoder_Update(NULL, (const unsigned char*)"abc", 3, destination, sizeof(destination), &written);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_015: [ If context or written is NULL, or source is NULL and size is not 0, or destination is NULL and destination_size is not 0, Base64_Encoder_Update shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Encoder_Update_with_NULL_source_fails)
+{
+    ///arrange
+    BASE64_ENCODER_CONTEXT context;
+    char destination[4];
+    size_t written;
+    (void)Base64_Encoder_Init(&context);
+
+    ///act
+    int result = Base64_Encoder_Update(&context, NULL, 3, destination, sizeof(destination), &written);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_015: [ If context or written is NULL, or source is NULL and size is not 0, or destination is NULL and destination_size is not 0, Base64_Encoder_Update shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Encoder_Update_with_NULL_written_fails)
+{
+    ///arrange
+    BASE64_ENCODER_CONTEXT context;
+    char destination[4];
+    (void)Base64_Encoder_Init(&context);
+
+    ///act
+    int result = Base64_Encoder_Update(&context, (const unsigned char*)"abc", 3, destination, sizeof(destination), NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_016: [ If destination_size is less than the number of characters of the groups of 3 bytes completed by source, Base64_Encoder_Update shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Encoder_Update_with_a_too_small_destination_fails)
+{
+    ///arrange
+    BASE64_ENCODER_CONTEXT context;
+    char destination[4];
+    size_t written;
+    (void)Base64_Encoder_Init(&context);
+    ASSERT_ARE_EQUAL(int, 0, Base64_Encoder_Update(&context, (const unsigned char*)"a", 1, NULL, 0, &written));
+
+    ///act
+    int result = Base64_Encoder_Update(&context, (const unsigned char*)"abcde", 5, destination, sizeof(destination), &written);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_014: [ Otherwise Base64_Encoder_Init shall set context to hold no bytes of the input and return 0. ]*/
+/*Tests_SRS_BASE64_01_017: [ Otherwise Base64_Encoder_Update shall write to destination the characters of the groups of 3 bytes completed by source, keep in context the bytes of the last started group, set written to the number of characters written and return 0. ]*/
+/*Tests_SRS_BASE64_01_027: [ Otherwise Base64_Encoder_Finish shall write to destination the 4 characters, padding included, of the bytes held in context if any, set written to their number, set context to hold no bytes and return 0. ]*/
+TEST_FUNCTION(Base64_Encoder_Update_one_byte_at_a_time_exhaustive_succeeds)
+{
+    size_t i;
+    for (i = 0; i < sizeof(testVector_BINARY_with_equal_signs) / sizeof(testVector_BINARY_with_equal_signs[0]); i++)
+    {
+        ///arrange
+        BASE64_ENCODER_CONTEXT context;
+        char destination[32];
+        size_t destination_length = 0;
+        size_t written;
+        size_t j;
+        umock_c_reset_all_calls();
+
+        ///act
+        ASSERT_ARE_EQUAL(int, 0, Base64_Encoder_Init(&context));
+        for (j = 0; j < testVector_BINARY_with_equal_signs[i].inputLength; j++)
+        {
+            ASSERT_ARE_EQUAL(int, 0, Base64_Encoder_Update(&context, testVector_BINARY_with_equal_signs[i].inputData + j, 1, destination + destination_length, sizeof(destination) - destination_length, &written));
+            destination_length += written;
+        }
+        ASSERT_ARE_EQUAL(int, 0, Base64_Encoder_Finish(&context, destination + destination_length, sizeof(destination) - destination_length, &written));
+        destination_length += written;
+        destination[destination_length] = '\0';
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, testVector_BINARY_with_equal_signs[i].expectedOutput, destination);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+}
+
+/*Tests_SRS_BASE64_01_017: [ Otherwise Base64_Encoder_Update shall write to destination the characters of the groups of 3 bytes completed by source, keep in context the bytes of the last started group, set written to the number of characters written and return 0. ]*/
+TEST_FUNCTION(Base64_Encoder_Update_completes_the_group_started_by_the_previous_chunk)
+{
+    ///arrange
+    BASE64_ENCODER_CONTEXT context;
+    char destination[9] = { 0 };
+    size_t written;
+    (void)Base64_Encoder_Init(&context);
+    ASSERT_ARE_EQUAL(int, 0, Base64_Encoder_Update(&context, (const unsigned char*)"ab", 2, destination, sizeof(destination), &written));
+    ASSERT_ARE_EQUAL(size_t, 0, written);
+
+    ///act
+    int result = Base64_Encoder_Update(&context, (const unsigned char*)"cdefg", 5, destination, Base64_Encoded_Length(5), &written);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 8, written);
+    ASSERT_ARE_EQUAL(char_ptr, "YWJjZGVm", destination);
+    ASSERT_ARE_EQUAL(int, 0, Base64_Encoder_Finish(&context, destination, 4, &written));
+    ASSERT_ARE_EQUAL(size_t, 4, written);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(destination, "Zw==", 4));
+}
+
+/*Tests_SRS_BASE64_01_018: [ If context, source, offset or written is NULL, or destination is NULL and destination_size is not 0, Base64_Encoder_Update_From_Array shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Encoder_Update_From_Array_with_NULL_source_fails)
+{
+    ///arrange
+    BASE64_ENCODER_CONTEXT context;
+    char destination[4];
+    uint32_t offset = 0;
+    size_t written;
+    (void)Base64_Encoder_Init(&context);
+
+    ///act
+    int result = Base64_Encoder_Update_From_Array(&context, NULL, &offset, destination, sizeof(destination), &written);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_018: [ If context, source, offset or written is NULL, or destination is NULL and destination_size is not 0, Base64_Encoder_Update_From_Array shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Encoder_Update_From_Array_with_NULL_offset_fails)
+{
+    ///arrange
+    BASE64_ENCODER_CONTEXT context;
+    char destination[4];
+    size_t written;
+    CONSTBUFFER_ARRAY_HANDLE source = constbuffer_array_create_empty();
+    ASSERT_IS_NOT_NULL(source);
+    (void)Base64_Encoder_Init(&context);
+
+    ///act
+    int result = Base64_Encoder_Update_From_Array(&context, source, NULL, destination, sizeof(destination), &written);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    ///cleanup
+    constbuffer_array_dec_ref(source);
+}
+
+/*Tests_SRS_BASE64_01_021: [ If offset is past the end of source, Base64_Encoder_Update_From_Array shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Encoder_Update_From_Array_with_offset_past_the_end_fails)
+{
+    ///arrange
+    BASE64_ENCODER_CONTEXT context;
+    char destination[4];
+    uint32_t offset = 1;
+    size_t written;
+    CONSTBUFFER_ARRAY_HANDLE source = constbuffer_array_create_empty();
+    ASSERT_IS_NOT_NULL(source);
+    (void)Base64_Encoder_Init(&context);
+
+    ///act
+    int result = Base64_Encoder_Update_From_Array(&context, source, &offset, destination, sizeof(destination), &written);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    ///cleanup
+    constbuffer_array_dec_ref(source);
+}
+
+/*Tests_SRS_BASE64_01_019: [ Base64_Encoder_Update_From_Array shall get the size of source by calling constbuffer_array_get_all_buffers_size. ]*/
+/*Tests_SRS_BASE64_01_022: [ Base64_Encoder_Update_From_Array shall consume the bytes of source starting at offset, as many as complete the groups of 3 bytes whose characters fit in destination_size, or all of them if fewer. ]*/
+/*Tests_SRS_BASE64_01_023: [ Base64_Encoder_Update_From_Array shall find the buffer holding the byte at offset by calling constbuffer_array_get_buffer_index_at_offset and read the buffers from there by calling constbuffer_array_get_buffer_content. ]*/
+/*Tests_SRS_BASE64_01_024: [ On success Base64_Encoder_Update_From_Array shall advance offset past the bytes consumed, set written to the number of characters written and return 0. ]*/
+TEST_FUNCTION(Base64_Encoder_Update_From_Array_encodes_as_much_as_fits_in_destination)
+{
+    ///arrange
+    BASE64_ENCODER_CONTEXT context;
+    char destination[17] = { 0 };
+    uint32_t offset = 0;
+    size_t written;
+    CONSTBUFFER_HANDLE buffers[3];
+    CONSTBUFFER_ARRAY_HANDLE source;
+    buffers[0] = CONSTBUFFER_Create((const unsigned char*)"ab", 2);
+    buffers[1] = CONSTBUFFER_Create(NULL, 0);
+    buffers[2] = CONSTBUFFER_Create((const unsigned char*)"cdefg", 5);
+    source = constbuffer_array_create(buffers, 3);
+    ASSERT_IS_NOT_NULL(source);
+    (void)Base64_Encoder_Init(&context);
+    umock_c_reset_all_calls();
+
+    ///act
+    int result = Base64_Encoder_Update_From_Array(&context, source, &offset, destination, 7, &written);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint32_t, 3, offset);
+    ASSERT_ARE_EQUAL(size_t, 4, written);
+    ASSERT_ARE_EQUAL(char_ptr, "YWJj", destination);
+    ASSERT_ARE_EQUAL(int, 0, Base64_Encoder_Update_From_Array(&context, source, &offset, destination, 16, &written));
+    ASSERT_ARE_EQUAL(uint32_t, 7, offset);
+    ASSERT_ARE_EQUAL(size_t, 4, written);
+    ASSERT_ARE_EQUAL(int, 0, Base64_Encoder_Finish(&context, destination + written, 4, &written));
+    ASSERT_ARE_EQUAL(char_ptr, "ZGVmZw==", destination);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    constbuffer_array_dec_ref(source);
+    CONSTBUFFER_DecRef(buffers[0]);
+    CONSTBUFFER_DecRef(buffers[1]);
+    CONSTBUFFER_DecRef(buffers[2]);
+}
+
+/*Tests_SRS_BASE64_01_026: [ If context holds bytes of the input and destination_size is less than 4, Base64_Encoder_Finish shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Encoder_Finish_with_a_too_small_destination_fails)
+{
+    ///arrange
+    BASE64_ENCODER_CONTEXT context;
+    char destination[3];
+    size_t written;
+    (void)Base64_Encoder_Init(&context);
+    ASSERT_ARE_EQUAL(int, 0, Base64_Encoder_Update(&context, (const unsigned char*)"a", 1, NULL, 0, &written));
+
+    ///act
+    int result = Base64_Encoder_Finish(&context, destination, sizeof(destination), &written);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_025: [ If context or written is NULL, or destination is NULL and destination_size is not 0, Base64_Encoder_Finish shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Encoder_Finish_with_NULL_context_fails)
+{
+    ///arrange
+    char destination[4];
+    size_t written;
+
+    ///act
+    int result = Base64_Encoder_Finish(NULL, destination, sizeof(destination), &written);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_028: [ If context is NULL, Base64_Decoder_Init shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Decoder_Init_with_NULL_context_fails)
+{
+    ///act
+    int result = Base64_Decoder_Init(NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_030: [ If context or written is NULL, or source is NULL and length is not 0, or destination is NULL and destination_size is not 0, Base64_Decoder_Update shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Decoder_Update_with_NULL_source_fails)
+{
+    ///arrange
+    BASE64_DECODER_CONTEXT context;
+    unsigned char destination[3];
+    size_t written;
+    (void)Base64_Decoder_Init(&context);
+
+    ///act
+    int result = Base64_Decoder_Update(&context, NULL, 4, destination, sizeof(destination), &written);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_030: [ If context or written is NULL, or source is NULL and length is not 0, or destination is NULL and destination_size is not 0, Base64_Decoder_Update shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Decoder_Update_with_NULL_written_fails)
+{
+    ///arrange
+    BASE64_DECODER_CONTEXT context;
+    unsigned char destination[3];
+    (void)Base64_Decoder_Init(&context);
+
+    ///act
+    int result = Base64_Decoder_Update(&context, "AAAA", 4, destination, sizeof(destination), NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_031: [ If source makes the input an invalid base64 encoding (a character other than the base64 alphabet, a '=' other than one of the up to two ending the last group of 4 characters, or a character after that group), Base64_Decoder_Update shall fail and return a non-zero value. ]*/
+/*Tests_SRS_BASE64_01_035: [ If context holds the characters of a started group of 4, Base64_Decoder_Finish shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Decoder_Update_with_invalid_sources_fails)
+{
+    static const char* const invalid_sources[] = { "1", "12345", "AA=A", "A===", "====", "AA*A", "AAAA AAA", "AA==AAAA" };
+    size_t i;
+    for (i = 0; i < sizeof(invalid_sources) / sizeof(invalid_sources[0]); i++)
+    {
+        ///arrange
+        BASE64_DECODER_CONTEXT context;
+        unsigned char destination[8];
+        size_t written;
+        int result;
+        (void)Base64_Decoder_Init(&context);
+
+        ///act
+        result = Base64_Decoder_Update(&context, invalid_sources[i], strlen(invalid_sources[i]), destination, sizeof(destination), &written);
+        if (result == 0)
+        {
+            result = Base64_Decoder_Finish(&context);
+        }
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result, invalid_sources[i]);
+    }
+}
+
+/*Tests_SRS_BASE64_01_032: [ If destination_size is less than the number of bytes of the groups of 4 characters completed by source, Base64_Decoder_Update shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Decoder_Update_with_a_too_small_destination_fails)
+{
+    ///arrange
+    BASE64_DECODER_CONTEXT context;
+    unsigned char destination[2];
+    size_t written;
+    (void)Base64_Decoder_Init(&context);
+
+    ///act
+    int result = Base64_Decoder_Update(&context, "AAAA", 4, destination, sizeof(destination), &written);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_029: [ Otherwise Base64_Decoder_Init shall set context to hold no characters of the input and return 0. ]*/
+/*Tests_SRS_BASE64_01_033: [ Otherwise Base64_Decoder_Update shall write to destination the bytes of the groups of 4 characters completed by source, keep in context the characters of the last started group, set written to the number of bytes written and return 0. ]*/
+/*Tests_SRS_BASE64_01_036: [ Otherwise Base64_Decoder_Finish shall return 0. ]*/
+TEST_FUNCTION(Base64_Decoder_Update_one_character_at_a_time_exhaustive_succeeds)
+{
+    size_t i;
+    for (i = 0; i < sizeof(testVector_BINARY_with_equal_signs) / sizeof(testVector_BINARY_with_equal_signs[0]); i++)
+    {
+        ///arrange
+        BASE64_DECODER_CONTEXT context;
+        unsigned char destination[16];
+        size_t decoded_size = 0;
+        size_t written;
+        const char* encoded = testVector_BINARY_with_equal_signs[i].expectedOutput;
+        size_t j;
+        umock_c_reset_all_calls();
+
+        ///act
+        ASSERT_ARE_EQUAL(int, 0, Base64_Decoder_Init(&context));
+        for (j = 0; encoded[j] != '\0'; j++)
+        {
+            ASSERT_ARE_EQUAL(int, 0, Base64_Decoder_Update(&context, encoded + j, 1, destination + decoded_size, sizeof(destination) - decoded_size, &written));
+            decoded_size += written;
+        }
+        ASSERT_ARE_EQUAL(int, 0, Base64_Decoder_Finish(&context));
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, testVector_BINARY_with_equal_signs[i].inputLength, decoded_size);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(destination, testVector_BINARY_with_equal_signs[i].inputData, decoded_size));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+}
+
+/*Tests_SRS_BASE64_01_034: [ If context is NULL, Base64_Decoder_Finish shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(Base64_Decoder_Finish_with_NULL_context_fails)
+{
+    ///act
+    int result = Base64_Decoder_Finish(NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_BASE64_01_037: [ Base64_Decoder_Finish shall set context to hold no characters of the input. ]*/
+TEST_FUNCTION(Base64_Decoder_Finish_lets_the_context_decode_a_new_input)
+{
+    ///arrange
+    BASE64_DECODER_CONTEXT context;
+    unsigned char destination[3];
+    size_t written;
+    (void)Base64_Decoder_Init(&context);
+    ASSERT_ARE_EQUAL(int, 0, Base64_Decoder_Update(&context, "AA==", 4, destination, sizeof(destination), &written));
+    ASSERT_ARE_EQUAL(int, 0, Base64_Decoder_Finish(&context));
+
+    ///act
+    int result = Base64_Decoder_Update(&context, "AQID", 4, destination, sizeof(destination), &written);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 3, written);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(destination, "\x01\x02\x03", 3));
+}
 
 END_TEST_SUITE(base64_unittests);
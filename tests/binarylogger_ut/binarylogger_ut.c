@@ -0,0 +1,798 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#include "macro_utils.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/binarylogger.h"
+
+IMPLEMENT_UMOCK_C_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+
+static const SPINLOCK_HANDLE TEST_SPINLOCK_HANDLE = (SPINLOCK_HANDLE)0x4242;
+
+/* the lines decoded by binarylogger_decode */
+#define TEST_MAX_LINES 16
+
+typedef struct TEST_LINE_TAG
+{
+    void* context;
+    LOG_CATEGORY log_category;
+    const char* file;
+    const char* func;
+    int line;
+    unsigned int options;
+    char message[1024];
+} TEST_LINE;
+
+static TEST_LINE test_lines[TEST_MAX_LINES];
+static size_t test_line_count;
+
+static void test_on_line(void* context, LOG_CATEGORY log_category, const char* file, const char* func, int line, unsigned int options, const char* message)
+{
+    ASSERT_IS_TRUE(test_line_count < TEST_MAX_LINES);
+    test_lines[test_line_count].context = context;
+    test_lines[test_line_count].log_category = log_category;
+    test_lines[test_line_count].file = file;
+    test_lines[test_line_count].func = func;
+    test_lines[test_line_count].line = line;
+    test_lines[test_line_count].options = options;
+    (void)strcpy(test_lines[test_line_count].message, message);
+    test_line_count++;
+}
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+static void init_logger(size_t buffer_size)
+{
+    int result = binarylogger_init(buffer_size, NULL);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    umock_c_reset_all_calls();
+}
+
+/* decodes the buffer of the logger, the decoded lines are in test_lines */
+static void decode_buffer(void)
+{
+    size_t size;
+    const unsigned char* buffer = binarylogger_get_buffer(&size);
+    int result;
+    ASSERT_IS_NOT_NULL(buffer);
+    result = binarylogger_decode(buffer, size, test_on_line, NULL);
+    ASSERT_ARE_EQUAL(int, 0, result);
+}
+
+/* copies the buffer of the logger */
+static size_t copy_buffer(unsigned char* destination, size_t destination_size)
+{
+    size_t size;
+    const unsigned char* buffer = binarylogger_get_buffer(&size);
+    ASSERT_IS_NOT_NULL(buffer);
+    ASSERT_IS_TRUE(size <= destination_size);
+    (void)memcpy(destination, buffer, size);
+    return size;
+}
+
+BEGIN_TEST_SUITE(binarylogger_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result, "umock_c_init");
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_charptr_register_types");
+
+    REGISTER_UMOCK_ALIAS_TYPE(SPINLOCK_HANDLE, void*);
+    REGISTER_TYPE(LOCK_RESULT, LOCK_RESULT);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_RETURN(SpinLock_Init, TEST_SPINLOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(SpinLock_Deinit, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(SpinLock_Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(SpinLock_Unlock, LOCK_OK);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    test_line_count = 0;
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/* binarylogger_init */
+
+/* Tests_SRS_BINARYLOGGER_01_002: [ binarylogger_init shall allocate a buffer of buffer_size bytes, 64 KB if buffer_size is 0, and create a spin lock. ]*/
+/* Tests_SRS_BINARYLOGGER_01_005: [ binarylogger_init shall write the header of the stream to the buffer, reset the dropped count and return 0. ]*/
+/* Tests_SRS_BINARYLOGGER_01_015: [ binarylogger_get_buffer shall return the buffer and set size to the number of bytes it holds. ]*/
+TEST_FUNCTION(binarylogger_init_allocates_the_buffer_and_writes_the_header)
+{
+    // arrange
+    int result;
+    const unsigned char* buffer;
+    size_t size;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(0x10000));
+    STRICT_EXPECTED_CALL(SpinLock_Init());
+
+    // act
+    result = binarylogger_init(0, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    buffer = binarylogger_get_buffer(&size);
+    ASSERT_IS_NOT_NULL(buffer);
+    ASSERT_ARE_EQUAL(size_t, 5, size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(buffer, "AZBL\1", 5));
+    ASSERT_ARE_EQUAL(size_t, 0, binarylogger_get_dropped_count());
+
+    // cleanup
+    binarylogger_deinit();
+}
+
+/* Tests_SRS_BINARYLOGGER_01_001: [ If the logger is already initialized, binarylogger_init shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(binarylogger_init_when_already_initialized_fails)
+{
+    // arrange
+    int result;
+    init_logger(256);
+
+    // act
+    result = binarylogger_init(256, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    binarylogger_deinit();
+}
+
+/* Tests_SRS_BINARYLOGGER_01_003: [ If buffer_size is not 0 and smaller than the header of a stream, binarylogger_init shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(binarylogger_init_with_a_buffer_smaller_than_the_header_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = binarylogger_init(4, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_BINARYLOGGER_01_006: [ If any failure occurs, binarylogger_init shall free what it allocated and return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_the_logger_fails_binarylogger_init_fails)
+{
+    // arrange
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = binarylogger_init(256, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_BINARYLOGGER_01_006: [ If any failure occurs, binarylogger_init shall free what it allocated and return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_the_buffer_fails_binarylogger_init_fails)
+{
+    // arrange
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(256))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = binarylogger_init(256, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_BINARYLOGGER_01_006: [ If any failure occurs, binarylogger_init shall free what it allocated and return a non-zero value. ]*/
+TEST_FUNCTION(when_SpinLock_Init_fails_binarylogger_init_fails)
+{
+    // arrange
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(256));
+    STRICT_EXPECTED_CALL(SpinLock_Init())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = binarylogger_init(256, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_BINARYLOGGER_01_005: [ binarylogger_init shall write the header of the stream to the buffer, reset the dropped count and return 0. ]*/
+TEST_FUNCTION(binarylogger_init_resets_the_dropped_count)
+{
+    // arrange
+    binarylogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "not initialized");
+    ASSERT_ARE_NOT_EQUAL(size_t, 0, binarylogger_get_dropped_count());
+
+    // act
+    init_logger(256);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, binarylogger_get_dropped_count());
+
+    // cleanup
+    binarylogger_deinit();
+}
+
+/* binarylogger_deinit */
+
+/* Tests_SRS_BINARYLOGGER_01_007: [ If the logger is not initialized, binarylogger_deinit shall return. ]*/
+TEST_FUNCTION(binarylogger_deinit_when_not_initialized_returns)
+{
+    // arrange
+
+    // act
+    binarylogger_deinit();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_BINARYLOGGER_01_009: [ binarylogger_deinit shall free the spin lock and the buffer. ]*/
+TEST_FUNCTION(binarylogger_deinit_frees_the_spin_lock_and_the_buffer)
+{
+    // arrange
+    init_logger(256);
+    STRICT_EXPECTED_CALL(SpinLock_Deinit(TEST_SPINLOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    binarylogger_deinit();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* binarylogger_flush */
+
+/* Tests_SRS_BINARYLOGGER_01_010: [ If the logger is not initialized, binarylogger_flush shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(binarylogger_flush_when_not_initialized_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = binarylogger_flush();
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_BINARYLOGGER_01_011: [ If there is no file, binarylogger_flush shall return 0. ]*/
+TEST_FUNCTION(binarylogger_flush_without_a_file_keeps_the_buffer)
+{
+    // arrange
+    int result;
+    size_t size;
+    init_logger(256);
+    binarylogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "kept");
+    umock_c_reset_all_calls();
+
+    // act
+    result = binarylogger_flush();
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)binarylogger_get_buffer(&size);
+    ASSERT_IS_TRUE(size > 5);
+
+    // cleanup
+    binarylogger_deinit();
+}
+
+/* binarylogger_get_buffer */
+
+/* Tests_SRS_BINARYLOGGER_01_014: [ If the logger is not initialized or size is NULL, binarylogger_get_buffer shall return NULL. ]*/
+TEST_FUNCTION(binarylogger_get_buffer_when_not_initialized_returns_NULL)
+{
+    // arrange
+    size_t size;
+    const unsigned char* result;
+
+    // act
+    result = binarylogger_get_buffer(&size);
+
+    // assert
+    ASSERT_IS_NULL(result);
+}
+
+/* Tests_SRS_BINARYLOGGER_01_014: [ If the logger is not initialized or size is NULL, binarylogger_get_buffer shall return NULL. ]*/
+TEST_FUNCTION(binarylogger_get_buffer_with_NULL_size_returns_NULL)
+{
+    // arrange
+    const unsigned char* result;
+    init_logger(256);
+
+    // act
+    result = binarylogger_get_buffer(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+
+    // cleanup
+    binarylogger_deinit();
+}
+
+/* binarylogger_log */
+
+/* Tests_SRS_BINARYLOGGER_01_016: [ binarylogger_get_dropped_count shall return the number of lines dropped since binarylogger_init. ]*/
+/* Tests_SRS_BINARYLOGGER_01_017: [ If the logger is not initialized or format is NULL, binarylogger_log shall drop the line and count it. ]*/
+TEST_FUNCTION(binarylogger_log_when_not_initialized_counts_a_dropped_line)
+{
+    // arrange
+    init_logger(256);
+    binarylogger_deinit();
+    umock_c_reset_all_calls();
+
+    // act
+    binarylogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "dropped");
+    binarylogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "dropped");
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 2, binarylogger_get_dropped_count());
+}
+
+/* Tests_SRS_BINARYLOGGER_01_017: [ If the logger is not initialized or format is NULL, binarylogger_log shall drop the line and count it. ]*/
+TEST_FUNCTION(binarylogger_log_with_NULL_format_counts_a_dropped_line)
+{
+    // arrange
+    init_logger(256);
+
+    // act
+    binarylogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, binarylogger_get_dropped_count());
+
+    // cleanup
+    binarylogger_deinit();
+}
+
+/* Tests_SRS_BINARYLOGGER_01_018: [ binarylogger_log shall record the arguments that the conversions of format consume, without formatting them, copying the strings of %s conversions up to their precision. ]*/
+/* Tests_SRS_BINARYLOGGER_01_024: [ binarylogger_decode shall format each line record with its format string and arguments and call on_line with context, its category, file, function, line, options and the formatted line. ]*/
+TEST_FUNCTION(binarylogger_log_records_a_line_that_binarylogger_decode_formats)
+{
+    // arrange
+    init_logger(1024);
+    STRICT_EXPECTED_CALL(SpinLock_Lock(TEST_SPINLOCK_HANDLE));
+    STRICT_EXPECTED_CALL(SpinLock_Unlock(TEST_SPINLOCK_HANDLE));
+
+    // act
+    binarylogger_log(AZ_LOG_ERROR, "a.c", "func_a", 42, LOG_LINE, "value=%d name=%s", 7, "seven");
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    decode_buffer();
+    ASSERT_ARE_EQUAL(size_t, 1, test_line_count);
+    ASSERT_ARE_EQUAL(int, (int)AZ_LOG_ERROR, (int)test_lines[0].log_category);
+    ASSERT_ARE_EQUAL(char_ptr, "a.c", test_lines[0].file);
+    ASSERT_ARE_EQUAL(char_ptr, "func_a", test_lines[0].func);
+    ASSERT_ARE_EQUAL(int, 42, test_lines[0].line);
+    ASSERT_ARE_EQUAL(int, (int)LOG_LINE, (int)test_lines[0].options);
+    ASSERT_ARE_EQUAL(char_ptr, "value=7 name=seven", test_lines[0].message);
+
+    // cleanup
+    binarylogger_deinit();
+}
+
+/* Tests_SRS_BINARYLOGGER_01_018: [ binarylogger_log shall record the arguments that the conversions of format consume, without formatting them, copying the strings of %s conversions up to their precision. ]*/
+TEST_FUNCTION(binarylogger_log_records_all_the_printf_conversions)
+{
+    // arrange
+    char expected[3][256];
+    init_logger(2048);
+    (void)sprintf(expected[0], "%d %i %u %x %X %o %5d|%-5d|%05d %ld %lld %lu %llu %zu %hhd %hu", -1, 42, 3000000000u, 255u, 255u, 8u, 7, 7, 7, -5L, -6LL, 7UL, 18446744073709551615ULL, (size_t)9, 300, 70000);
+    (void)sprintf(expected[1], "%f %.2f %e %g %10.3f %c%c %% 100%%", 3.14159, 2.5, 1e10, 0.0001, -1.5, 'o', 'k');
+    (void)sprintf(expected[2], "%s|%10s|%-10s|%.3s|%.*s|%*d", "str", "right", "left", "truncate", 2, "ab_cut", 6, 9);
+
+    // act
+    binarylogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "%d %i %u %x %X %o %5d|%-5d|%05d %ld %lld %lu %llu %zu %hhd %hu", -1, 42, 3000000000u, 255u, 255u, 8u, 7, 7, 7, -5L, -6LL, 7UL, 18446744073709551615ULL, (size_t)9, 300, 70000);
+    binarylogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "%f %.2f %e %g %10.3f %c%c %% 100%%", 3.14159, 2.5, 1e10, 0.0001, -1.5, 'o', 'k');
+    binarylogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "%s|%10s|%-10s|%.3s|%.*s|%*d", "str", "right", "left", "truncate", 2, "ab_cut", 6, 9);
+
+    // assert
+    decode_buffer();
+    ASSERT_ARE_EQUAL(size_t, 3, test_line_count);
+    ASSERT_ARE_EQUAL(char_ptr, expected[0], test_lines[0].message);
+    ASSERT_ARE_EQUAL(char_ptr, expected[1], test_lines[1].message);
+    ASSERT_ARE_EQUAL(char_ptr, expected[2], test_lines[2].message);
+
+    // cleanup
+    binarylogger_deinit();
+}
+
+/* Tests_SRS_BINARYLOGGER_01_018: [ binarylogger_log shall record the arguments that the conversions of format consume, without formatting them, copying the strings of %s conversions up to their precision. ]*/
+TEST_FUNCTION(binarylogger_log_copies_the_strings)
+{
+    // arrange
+    char changing[8];
+    init_logger(1024);
+    (void)strcpy(changing, "before");
+
+    // act
+    binarylogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "%s", changing);
+    (void)strcpy(changing, "after");
+
+    // assert
+    decode_buffer();
+    ASSERT_ARE_EQUAL(size_t, 1, test_line_count);
+    ASSERT_ARE_EQUAL(char_ptr, "before", test_lines[0].message);
+
+    // cleanup
+    binarylogger_deinit();
+}
+
+/* Tests_SRS_BINARYLOGGER_01_018: [ binarylogger_log shall record the arguments that the conversions of format consume, without formatting them, copying the strings of %s conversions up to their precision. ]*/
+TEST_FUNCTION(binarylogger_log_copies_a_string_only_up_to_its_precision)
+{
+    // arrange
+    const char not_terminated[3] = { 'a', 'b', 'c' };
+    init_logger(1024);
+
+    // act
+    binarylogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "%.3s", not_terminated);
+
+    // assert
+    decode_buffer();
+    ASSERT_ARE_EQUAL(size_t, 1, test_line_count);
+    ASSERT_ARE_EQUAL(char_ptr, "abc", test_lines[0].message);
+
+    // cleanup
+    binarylogger_deinit();
+}
+
+/* Tests_SRS_BINARYLOGGER_01_019: [ binarylogger_log shall record file, func and format once per stream, as string records giving them an id, and refer to them by id in the line record. ]*/
+TEST_FUNCTION(binarylogger_log_records_the_strings_once)
+{
+    // arrange
+    static const char format[] = "line %d";
+    size_t size_after_first;
+    size_t size_after_second;
+    init_logger(1024);
+    binarylogger_log(AZ_LOG_INFO, "file.c", "func", 1, 0, format, 1);
+    (void)binarylogger_get_buffer(&size_after_first);
+
+    // act
+    binarylogger_log(AZ_LOG_INFO, "file.c", "func", 2, 0, format, 2);
+
+    // assert
+    (void)binarylogger_get_buffer(&size_after_second);
+    /* a line record and an 'i' argument */
+    ASSERT_ARE_EQUAL(size_t, 21 + 9, size_after_second - size_after_first);
+    decode_buffer();
+    ASSERT_ARE_EQUAL(size_t, 2, test_line_count);
+    ASSERT_ARE_EQUAL(char_ptr, "line 1", test_lines[0].message);
+    ASSERT_ARE_EQUAL(char_ptr, "line 2", test_lines[1].message);
+    ASSERT_ARE_EQUAL(char_ptr, "file.c", test_lines[1].file);
+    ASSERT_ARE_EQUAL(int, 2, test_lines[1].line);
+
+    // cleanup
+    binarylogger_deinit();
+}
+
+/* Tests_SRS_BINARYLOGGER_01_019: [ binarylogger_log shall record file, func and format once per stream, as string records giving them an id, and refer to them by id in the line record. ]*/
+TEST_FUNCTION(binarylogger_log_with_NULL_file_and_func_decodes_them_as_NULL)
+{
+    // arrange
+    init_logger(1024);
+
+    // act
+    binarylogger_log(AZ_LOG_TRACE, NULL, NULL, 3, 0, "no file");
+
+    // assert
+    decode_buffer();
+    ASSERT_ARE_EQUAL(size_t, 1, test_line_count);
+    ASSERT_IS_NULL(test_lines[0].file);
+    ASSERT_IS_NULL(test_lines[0].func);
+    ASSERT_ARE_EQUAL(char_ptr, "no file", test_lines[0].message);
+
+    // cleanup
+    binarylogger_deinit();
+}
+
+/* Tests_SRS_BINARYLOGGER_01_021: [ If the record does not fit in the buffer, binarylogger_log shall drop the line and count it. ]*/
+TEST_FUNCTION(binarylogger_log_when_the_buffer_is_full_counts_a_dropped_line)
+{
+    // arrange
+    size_t size_before;
+    size_t size_after;
+    init_logger(64);
+    binarylogger_log(AZ_LOG_INFO, "f", "g", 1, 0, "fits");
+    (void)binarylogger_get_buffer(&size_before);
+
+    // act
+    binarylogger_log(AZ_LOG_INFO, "f", "g", 1, 0, "%s", "does not fit in what is left of the buffer");
+
+    // assert
+    (void)binarylogger_get_buffer(&size_after);
+    ASSERT_ARE_EQUAL(size_t, size_before, size_after);
+    ASSERT_ARE_EQUAL(size_t, 1, binarylogger_get_dropped_count());
+    decode_buffer();
+    ASSERT_ARE_EQUAL(size_t, 1, test_line_count);
+    ASSERT_ARE_EQUAL(char_ptr, "fits", test_lines[0].message);
+
+    // cleanup
+    binarylogger_deinit();
+}
+
+/* Tests_SRS_BINARYLOGGER_01_021: [ If the record does not fit in the buffer, binarylogger_log shall drop the line and count it. ]*/
+TEST_FUNCTION(when_SpinLock_Lock_fails_binarylogger_log_counts_a_dropped_line)
+{
+    // arrange
+    init_logger(1024);
+    STRICT_EXPECTED_CALL(SpinLock_Lock(TEST_SPINLOCK_HANDLE))
+        .SetReturn(LOCK_ERROR);
+
+    // act
+    binarylogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "dropped");
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, binarylogger_get_dropped_count());
+
+    // cleanup
+    binarylogger_deinit();
+}
+
+/* binarylogger_decode */
+
+/* Tests_SRS_BINARYLOGGER_01_022: [ If data or on_line is NULL, binarylogger_decode shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(binarylogger_decode_with_NULL_data_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = binarylogger_decode(NULL, 5, test_on_line, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_BINARYLOGGER_01_022: [ If data or on_line is NULL, binarylogger_decode shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(binarylogger_decode_with_NULL_on_line_fails)
+{
+    // arrange
+    int result;
+    static const unsigned char header[] = { 'A', 'Z', 'B', 'L', 1 };
+
+    // act
+    result = binarylogger_decode(header, sizeof(header), NULL, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_BINARYLOGGER_01_023: [ If data does not start with the header of a stream, binarylogger_decode shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(binarylogger_decode_without_the_header_fails)
+{
+    // arrange
+    int result;
+    static const unsigned char not_a_stream[] = { 'A', 'Z', 'B', 'X', 1 };
+
+    // act
+    result = binarylogger_decode(not_a_stream, sizeof(not_a_stream), test_on_line, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, test_line_count);
+}
+
+/* Tests_SRS_BINARYLOGGER_01_024: [ binarylogger_decode shall format each line record with its format string and arguments and call on_line with context, its category, file, function, line, options and the formatted line. ]*/
+TEST_FUNCTION(binarylogger_decode_passes_the_context)
+{
+    // arrange
+    int result;
+    size_t size;
+    const unsigned char* buffer;
+    init_logger(1024);
+    binarylogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "hello");
+    buffer = binarylogger_get_buffer(&size);
+
+    // act
+    result = binarylogger_decode(buffer, size, test_on_line, (void*)0x4243);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, test_line_count);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x4243, test_lines[0].context);
+
+    // cleanup
+    binarylogger_deinit();
+}
+
+/* Tests_SRS_BINARYLOGGER_01_025: [ If a record is truncated, unknown or refers to a string that was not recorded before, binarylogger_decode shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(binarylogger_decode_with_a_truncated_record_fails_after_the_complete_ones)
+{
+    // arrange
+    unsigned char stream[1024];
+    size_t size;
+    size_t truncated_size;
+    int result;
+    init_logger(1024);
+    binarylogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "first");
+    (void)binarylogger_get_buffer(&truncated_size);
+    binarylogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "second %d", 2);
+    size = copy_buffer(stream, sizeof(stream));
+    binarylogger_deinit();
+
+    // act
+    result = binarylogger_decode(stream, size - 1, test_on_line, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, test_line_count);
+    ASSERT_ARE_EQUAL(char_ptr, "first", test_lines[0].message);
+    ASSERT_IS_TRUE(truncated_size < size);
+}
+
+/* Tests_SRS_BINARYLOGGER_01_025: [ If a record is truncated, unknown or refers to a string that was not recorded before, binarylogger_decode shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(binarylogger_decode_with_an_unknown_record_fails)
+{
+    // arrange
+    int result;
+    static const unsigned char stream[] = { 'A', 'Z', 'B', 'L', 1, 'X', 0, 0 };
+
+    // act
+    result = binarylogger_decode(stream, sizeof(stream), test_on_line, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, test_line_count);
+}
+
+/* Tests_SRS_BINARYLOGGER_01_025: [ If a record is truncated, unknown or refers to a string that was not recorded before, binarylogger_decode shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(binarylogger_decode_with_a_line_record_referring_to_an_unknown_string_fails)
+{
+    // arrange
+    int result;
+    static const unsigned char stream[] =
+    {
+        'A', 'Z', 'B', 'L', 1,
+        'L', AZ_LOG_INFO, 0, 1, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 0, 0, 0, 0, 0
+    };
+
+    // act
+    result = binarylogger_decode(stream, sizeof(stream), test_on_line, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, test_line_count);
+}
+
+/* Tests_SRS_BINARYLOGGER_01_026: [ If any failure occurs, binarylogger_decode shall return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_the_message_fails_binarylogger_decode_fails)
+{
+    // arrange
+    int result;
+    static const unsigned char header[] = { 'A', 'Z', 'B', 'L', 1 };
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(NULL));
+
+    // act
+    result = binarylogger_decode(header, sizeof(header), test_on_line, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_BINARYLOGGER_01_026: [ If any failure occurs, binarylogger_decode shall return a non-zero value. ]*/
+TEST_FUNCTION(when_growing_the_string_table_fails_binarylogger_decode_fails)
+{
+    // arrange
+    unsigned char stream[1024];
+    size_t size;
+    int result;
+    init_logger(1024);
+    binarylogger_log(AZ_LOG_INFO, __FILE__, FUNC_NAME, __LINE__, 0, "line");
+    size = copy_buffer(stream, sizeof(stream));
+    binarylogger_deinit();
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(NULL));
+
+    // act
+    result = binarylogger_decode(stream, size, test_on_line, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, test_line_count);
+}
+
+END_TEST_SUITE(binarylogger_unittests)
@@ -883,8 +883,8 @@ BEGIN_TEST_SUITE(Buffer_UnitTests)
         BUFFER_delete(hBuffer);
     }
 
-    /* Tests_SRS_BUFFER_07_039: [ BUFFER_shrink shall allocate a temporary buffer of existing buffer size minus decreaseSize. ] */
     /* Tests_SRS_BUFFER_07_041: [ if the fromEnd variable is false, BUFFER_shrink shall remove the beginning of the buffer of size decreaseSize. ] */
+    /* Tests_SRS_BUFFER_01_019: [ When removing the beginning of the buffer, BUFFER_shrink shall turn the removed bytes into headroom, without allocating or moving the content. ] */
     TEST_FUNCTION(BUFFER_shrink_from_beginning_succeed)
     {
         const unsigned char TEST_TOTAL_BUFFER[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x1b, 0x1c, 0x1d, 0x1e, 0x1f, 0x20, 0x21, 0x22, 0x23, 0x24, 0x25, 0x26 };
@@ -896,9 +896,6 @@ BEGIN_TEST_SUITE(Buffer_UnitTests)
         nResult = BUFFER_build(hBuffer, TEST_TOTAL_BUFFER, TOTAL_ALLOCATION_SIZE);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(TOTAL_ALLOCATION_SIZE-ALLOCATION_SIZE));
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-
         //act
         nResult = BUFFER_shrink(hBuffer, ALLOCATION_SIZE, false);
 
@@ -906,6 +903,7 @@ BEGIN_TEST_SUITE(Buffer_UnitTests)
         ASSERT_ARE_EQUAL(int, nResult, 0);
         ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hBuffer), ADDITIONAL_BUFFER, ALLOCATION_SIZE));
         ASSERT_ARE_EQUAL(size_t, BUFFER_length(hBuffer), ALLOCATION_SIZE);
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE, BUFFER_headroom(hBuffer));
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         //cleanup
@@ -1712,4 +1710,525 @@ BEGIN_TEST_SUITE(Buffer_UnitTests)
         BUFFER_delete(buffer);
     }
 
+    /* Tests_SRS_BUFFER_01_006: [ If the capacity is not enough, BUFFER_append_build, BUFFER_enlarge and BUFFER_append shall grow the capacity to the larger of the required size and twice the current capacity. ] */
+    TEST_FUNCTION(BUFFER_append_build_within_capacity_does_not_realloc)
+    {
+        //arrange
+        int nResult;
+        BUFFER_HANDLE hBuffer;
+        hBuffer = BUFFER_create(BUFFER_TEST_VALUE, ALLOCATION_SIZE);
+        (void)BUFFER_append_build(hBuffer, ADDITIONAL_BUFFER, 1);
+        umock_c_reset_all_calls();
+
+        //act
+        nResult = BUFFER_append_build(hBuffer, ADDITIONAL_BUFFER + 1, ALLOCATION_SIZE - 1);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, nResult);
+        ASSERT_ARE_EQUAL(size_t, TOTAL_ALLOCATION_SIZE, BUFFER_length(hBuffer));
+        ASSERT_ARE_EQUAL(size_t, TOTAL_ALLOCATION_SIZE, BUFFER_capacity(hBuffer));
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hBuffer), TOTAL_BUFFER, TOTAL_ALLOCATION_SIZE));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        BUFFER_delete(hBuffer);
+    }
+
+    /* Tests_SRS_BUFFER_01_006: [ If the capacity is not enough, BUFFER_append_build, BUFFER_enlarge and BUFFER_append shall grow the capacity to the larger of the required size and twice the current capacity. ] */
+    TEST_FUNCTION(BUFFER_enlarge_doubles_the_capacity)
+    {
+        //arrange
+        int nResult;
+        BUFFER_HANDLE hBuffer;
+        hBuffer = BUFFER_create(BUFFER_TEST_VALUE, ALLOCATION_SIZE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 2 * ALLOCATION_SIZE))
+            .IgnoreArgument(1);
+
+        //act
+        nResult = BUFFER_enlarge(hBuffer, 1);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, nResult);
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE + 1, BUFFER_length(hBuffer));
+        ASSERT_ARE_EQUAL(size_t, 2 * ALLOCATION_SIZE, BUFFER_capacity(hBuffer));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        BUFFER_delete(hBuffer);
+    }
+
+    /* Tests_SRS_BUFFER_01_007: [ If handle is NULL, BUFFER_reserve shall return a non-zero value. ] */
+    TEST_FUNCTION(BUFFER_reserve_with_NULL_handle_fails)
+    {
+        //act
+        int result = BUFFER_reserve(NULL, ALLOCATION_SIZE);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_BUFFER_01_009: [ Otherwise BUFFER_reserve shall reallocate the underlying buffer to hold exactly capacity bytes, without changing its size or content, and return 0. ] */
+    TEST_FUNCTION(BUFFER_reserve_grows_the_capacity_and_keeps_the_content)
+    {
+        //arrange
+        int result;
+        BUFFER_HANDLE hBuffer = BUFFER_create(BUFFER_TEST_VALUE, ALLOCATION_SIZE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 100))
+            .IgnoreArgument(1);
+
+        //act
+        result = BUFFER_reserve(hBuffer, 100);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, 100, BUFFER_capacity(hBuffer));
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE, BUFFER_length(hBuffer));
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hBuffer), BUFFER_TEST_VALUE, ALLOCATION_SIZE));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        BUFFER_delete(hBuffer);
+    }
+
+    /* Tests_SRS_BUFFER_01_008: [ If capacity is not larger than the current capacity, BUFFER_reserve shall do nothing and return 0. ] */
+    TEST_FUNCTION(BUFFER_reserve_with_smaller_capacity_does_nothing)
+    {
+        //arrange
+        int result;
+        BUFFER_HANDLE hBuffer = BUFFER_create(BUFFER_TEST_VALUE, ALLOCATION_SIZE);
+        umock_c_reset_all_calls();
+
+        //act
+        result = BUFFER_reserve(hBuffer, ALLOCATION_SIZE - 1);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE, BUFFER_capacity(hBuffer));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        BUFFER_delete(hBuffer);
+    }
+
+    /* Tests_SRS_BUFFER_01_010: [ If reallocating fails, BUFFER_reserve shall return a non-zero value and leave the buffer unchanged. ] */
+    TEST_FUNCTION(when_realloc_fails_BUFFER_reserve_fails)
+    {
+        //arrange
+        int result;
+        BUFFER_HANDLE hBuffer = BUFFER_create(BUFFER_TEST_VALUE, ALLOCATION_SIZE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 100))
+            .IgnoreArgument(1)
+            .SetReturn(NULL);
+
+        //act
+        result = BUFFER_reserve(hBuffer, 100);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE, BUFFER_capacity(hBuffer));
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hBuffer), BUFFER_TEST_VALUE, ALLOCATION_SIZE));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        BUFFER_delete(hBuffer);
+    }
+
+    /* Tests_SRS_BUFFER_01_011: [ If handle is NULL, BUFFER_capacity shall return 0. ] */
+    TEST_FUNCTION(BUFFER_capacity_with_NULL_handle_returns_0)
+    {
+        //act
+        size_t result = BUFFER_capacity(NULL);
+
+        //assert
+        ASSERT_ARE_EQUAL(size_t, 0, result);
+    }
+
+    /* Tests_SRS_BUFFER_01_015: [ If handle, memory or size is NULL, BUFFER_detach shall fail and return a non-zero value. ] */
+    TEST_FUNCTION(BUFFER_detach_with_NULL_handle_fails)
+    {
+        //arrange
+        unsigned char* memory;
+        size_t size;
+
+        //act
+        int result = BUFFER_detach(NULL, &memory, &size);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_BUFFER_01_015: [ If handle, memory or size is NULL, BUFFER_detach shall fail and return a non-zero value. ] */
+    TEST_FUNCTION(BUFFER_detach_with_NULL_memory_fails)
+    {
+        //arrange
+        int result;
+        size_t size;
+        BUFFER_HANDLE hBuffer = BUFFER_create(BUFFER_TEST_VALUE, ALLOCATION_SIZE);
+        umock_c_reset_all_calls();
+
+        //act
+        result = BUFFER_detach(hBuffer, NULL, &size);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE, BUFFER_length(hBuffer));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        BUFFER_delete(hBuffer);
+    }
+
+    /* Tests_SRS_BUFFER_01_015: [ If handle, memory or size is NULL, BUFFER_detach shall fail and return a non-zero value. ] */
+    TEST_FUNCTION(BUFFER_detach_with_NULL_size_fails)
+    {
+        //arrange
+        int result;
+        unsigned char* memory;
+        BUFFER_HANDLE hBuffer = BUFFER_create(BUFFER_TEST_VALUE, ALLOCATION_SIZE);
+        umock_c_reset_all_calls();
+
+        //act
+        result = BUFFER_detach(hBuffer, &memory, NULL);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE, BUFFER_length(hBuffer));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        BUFFER_delete(hBuffer);
+    }
+
+    /* Tests_SRS_BUFFER_01_016: [ Otherwise BUFFER_detach shall hand the memory of the buffer and its size to the caller, who frees it with free, leave the buffer empty and return 0. ] */
+    TEST_FUNCTION(BUFFER_detach_hands_over_the_memory_and_empties_the_buffer)
+    {
+        //arrange
+        int result;
+        unsigned char* memory;
+        size_t size;
+        const unsigned char* original_memory;
+        BUFFER_HANDLE hBuffer = BUFFER_create(BUFFER_TEST_VALUE, ALLOCATION_SIZE);
+        original_memory = BUFFER_u_char(hBuffer);
+        umock_c_reset_all_calls();
+
+        //act
+        result = BUFFER_detach(hBuffer, &memory, &size);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE, size);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(memory, BUFFER_TEST_VALUE, ALLOCATION_SIZE));
+        ASSERT_ARE_EQUAL(size_t, 0, BUFFER_length(hBuffer));
+        ASSERT_IS_NULL(BUFFER_u_char(hBuffer));
+#ifndef USE_OBJECT_POOLS
+        /* inline object pool storage is copied out, everything else is handed over as is */
+        ASSERT_ARE_EQUAL(void_ptr, (void*)original_memory, (void*)memory);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+#else
+        (void)original_memory;
+#endif
+
+        //cleanup
+        free(memory);
+        BUFFER_delete(hBuffer);
+    }
+
+    /* Tests_SRS_BUFFER_01_016: [ Otherwise BUFFER_detach shall hand the memory of the buffer and its size to the caller, who frees it with free, leave the buffer empty and return 0. ] */
+    TEST_FUNCTION(BUFFER_detach_of_an_empty_buffer_succeeds)
+    {
+        //arrange
+        int result;
+        unsigned char* memory;
+        size_t size;
+        BUFFER_HANDLE hBuffer = BUFFER_new();
+        umock_c_reset_all_calls();
+
+        //act
+        result = BUFFER_detach(hBuffer, &memory, &size);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_IS_NULL(memory);
+        ASSERT_ARE_EQUAL(size_t, 0, size);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        BUFFER_delete(hBuffer);
+    }
+
+    /* Tests_SRS_BUFFER_01_022: [ If source is NULL and size is not 0, BUFFER_create_with_headroom shall fail and return NULL. ] */
+    TEST_FUNCTION(BUFFER_create_with_headroom_with_NULL_source_fails)
+    {
+        ///arrange
+
+        ///act
+        BUFFER_HANDLE res = BUFFER_create_with_headroom(NULL, 1, ALLOCATION_SIZE);
+
+        ///assert
+        ASSERT_IS_NULL(res);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_BUFFER_01_023: [ Otherwise BUFFER_create_with_headroom shall allocate headroom bytes followed by size bytes copied from source, and return a non-NULL handle. ] */
+    TEST_FUNCTION(BUFFER_create_with_headroom_succeeds)
+    {
+        ///arrange
+        BUFFER_HANDLE res;
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(gballoc_malloc(ALLOCATION_SIZE + TOTAL_ALLOCATION_SIZE));
+
+        ///act
+        res = BUFFER_create_with_headroom(BUFFER_TEST_VALUE, ALLOCATION_SIZE, TOTAL_ALLOCATION_SIZE);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(res);
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE, BUFFER_length(res));
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(res), BUFFER_TEST_VALUE, ALLOCATION_SIZE));
+        ASSERT_ARE_EQUAL(size_t, TOTAL_ALLOCATION_SIZE, BUFFER_headroom(res));
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE, BUFFER_capacity(res));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        BUFFER_delete(res);
+    }
+
+    /* Tests_SRS_BUFFER_01_023: [ Otherwise BUFFER_create_with_headroom shall allocate headroom bytes followed by size bytes copied from source, and return a non-NULL handle. ] */
+    TEST_FUNCTION(BUFFER_create_with_headroom_with_no_content_succeeds)
+    {
+        ///arrange
+        BUFFER_HANDLE res;
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(gballoc_malloc(ALLOCATION_SIZE));
+
+        ///act
+        res = BUFFER_create_with_headroom(NULL, 0, ALLOCATION_SIZE);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(res);
+        ASSERT_ARE_EQUAL(size_t, 0, BUFFER_length(res));
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE, BUFFER_headroom(res));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        BUFFER_delete(res);
+    }
+
+    /* Tests_SRS_BUFFER_01_024: [ If any failure occurs, BUFFER_create_with_headroom shall return NULL. ] */
+    TEST_FUNCTION(BUFFER_create_with_headroom_fails_when_allocating_the_data_fails)
+    {
+        ///arrange
+        BUFFER_HANDLE res;
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(gballoc_malloc(ALLOCATION_SIZE + TOTAL_ALLOCATION_SIZE))
+            .SetReturn(NULL);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+        ///act
+        res = BUFFER_create_with_headroom(BUFFER_TEST_VALUE, ALLOCATION_SIZE, TOTAL_ALLOCATION_SIZE);
+
+        ///assert
+        ASSERT_IS_NULL(res);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_BUFFER_01_025: [ If handle or source is NULL or size is 0, BUFFER_push_front shall return a non-zero value. ] */
+    TEST_FUNCTION(BUFFER_push_front_with_NULL_handle_fails)
+    {
+        ///arrange
+
+        ///act
+        int result = BUFFER_push_front(NULL, BUFFER_TEST_VALUE, ALLOCATION_SIZE);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_BUFFER_01_025: [ If handle or source is NULL or size is 0, BUFFER_push_front shall return a non-zero value. ] */
+    TEST_FUNCTION(BUFFER_push_front_with_NULL_source_fails)
+    {
+        ///arrange
+        int result;
+        BUFFER_HANDLE hBuffer = BUFFER_create_with_headroom(BUFFER_TEST_VALUE, ALLOCATION_SIZE, ALLOCATION_SIZE);
+        umock_c_reset_all_calls();
+
+        ///act
+        result = BUFFER_push_front(hBuffer, NULL, ALLOCATION_SIZE);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE, BUFFER_length(hBuffer));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        BUFFER_delete(hBuffer);
+    }
+
+    /* Tests_SRS_BUFFER_01_025: [ If handle or source is NULL or size is 0, BUFFER_push_front shall return a non-zero value. ] */
+    TEST_FUNCTION(BUFFER_push_front_with_0_size_fails)
+    {
+        ///arrange
+        int result;
+        BUFFER_HANDLE hBuffer = BUFFER_create_with_headroom(BUFFER_TEST_VALUE, ALLOCATION_SIZE, ALLOCATION_SIZE);
+        umock_c_reset_all_calls();
+
+        ///act
+        result = BUFFER_push_front(hBuffer, ADDITIONAL_BUFFER, 0);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE, BUFFER_length(hBuffer));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        BUFFER_delete(hBuffer);
+    }
+
+    /* Tests_SRS_BUFFER_01_026: [ Otherwise BUFFER_push_front shall copy size bytes from source into the headroom, in front of the content, and return 0. ] */
+    TEST_FUNCTION(BUFFER_push_front_into_the_headroom_does_not_allocate)
+    {
+        ///arrange
+        int result;
+        BUFFER_HANDLE hBuffer = BUFFER_create_with_headroom(BUFFER_TEST_VALUE, ALLOCATION_SIZE, ALLOCATION_SIZE);
+        const unsigned char* original_content = BUFFER_u_char(hBuffer);
+        umock_c_reset_all_calls();
+
+        ///act
+        result = BUFFER_push_front(hBuffer, ADDITIONAL_BUFFER, ALLOCATION_SIZE);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, TOTAL_ALLOCATION_SIZE, BUFFER_length(hBuffer));
+        ASSERT_ARE_EQUAL(void_ptr, (void*)(original_content - ALLOCATION_SIZE), (void*)BUFFER_u_char(hBuffer));
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hBuffer), ADDITIONAL_BUFFER, ALLOCATION_SIZE));
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hBuffer) + ALLOCATION_SIZE, BUFFER_TEST_VALUE, ALLOCATION_SIZE));
+        ASSERT_ARE_EQUAL(size_t, 0, BUFFER_headroom(hBuffer));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        BUFFER_delete(hBuffer);
+    }
+
+    /* Tests_SRS_BUFFER_01_027: [ If the headroom is not enough, BUFFER_push_front shall reallocate the buffer with a headroom of size plus the size of the content. ] */
+    TEST_FUNCTION(BUFFER_push_front_grows_the_headroom)
+    {
+        ///arrange
+        int result;
+        BUFFER_HANDLE hBuffer = BUFFER_create(BUFFER_TEST_VALUE, ALLOCATION_SIZE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(ALLOCATION_SIZE + ALLOCATION_SIZE + ALLOCATION_SIZE));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+        ///act
+        result = BUFFER_push_front(hBuffer, ADDITIONAL_BUFFER, ALLOCATION_SIZE);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, TOTAL_ALLOCATION_SIZE, BUFFER_length(hBuffer));
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hBuffer), ADDITIONAL_BUFFER, ALLOCATION_SIZE));
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hBuffer) + ALLOCATION_SIZE, BUFFER_TEST_VALUE, ALLOCATION_SIZE));
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE, BUFFER_headroom(hBuffer));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        BUFFER_delete(hBuffer);
+    }
+
+    /* Tests_SRS_BUFFER_01_028: [ If any failure occurs, BUFFER_push_front shall return a non-zero value and leave the buffer unchanged. ] */
+    TEST_FUNCTION(BUFFER_push_front_fails_when_growing_the_headroom_fails)
+    {
+        ///arrange
+        int result;
+        BUFFER_HANDLE hBuffer = BUFFER_create(BUFFER_TEST_VALUE, ALLOCATION_SIZE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .SetReturn(NULL);
+
+        ///act
+        result = BUFFER_push_front(hBuffer, ADDITIONAL_BUFFER, ALLOCATION_SIZE);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE, BUFFER_length(hBuffer));
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hBuffer), BUFFER_TEST_VALUE, ALLOCATION_SIZE));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        BUFFER_delete(hBuffer);
+    }
+
+    /* Tests_SRS_BUFFER_01_020: [ If handle1 has enough headroom, BUFFER_prepend shall copy the content of handle2 into it without allocating. ]*/
+    TEST_FUNCTION(BUFFER_prepend_into_the_headroom_does_not_allocate)
+    {
+        ///arrange
+        int result;
+        BUFFER_HANDLE hBuffer = BUFFER_create_with_headroom(BUFFER_TEST_VALUE, ALLOCATION_SIZE, ALLOCATION_SIZE);
+        BUFFER_HANDLE hPrepend = BUFFER_create(ADDITIONAL_BUFFER, ALLOCATION_SIZE);
+        umock_c_reset_all_calls();
+
+        ///act
+        result = BUFFER_prepend(hBuffer, hPrepend);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, TOTAL_ALLOCATION_SIZE, BUFFER_length(hBuffer));
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hBuffer), ADDITIONAL_BUFFER, ALLOCATION_SIZE));
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hBuffer) + ALLOCATION_SIZE, BUFFER_TEST_VALUE, ALLOCATION_SIZE));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        BUFFER_delete(hPrepend);
+        BUFFER_delete(hBuffer);
+    }
+
+    /* Tests_SRS_BUFFER_01_021: [ If the buffer has headroom, BUFFER_detach shall first move the content to the start of its memory. ] */
+    TEST_FUNCTION(BUFFER_detach_with_headroom_moves_the_content_to_the_start)
+    {
+        ///arrange
+        int result;
+        unsigned char* memory;
+        size_t size;
+        BUFFER_HANDLE hBuffer = BUFFER_create_with_headroom(BUFFER_TEST_VALUE, ALLOCATION_SIZE, ALLOCATION_SIZE);
+        umock_c_reset_all_calls();
+
+        ///act
+        result = BUFFER_detach(hBuffer, &memory, &size);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, ALLOCATION_SIZE, size);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(memory, BUFFER_TEST_VALUE, ALLOCATION_SIZE));
+        ASSERT_ARE_EQUAL(size_t, 0, BUFFER_headroom(hBuffer));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        free(memory);
+        BUFFER_delete(hBuffer);
+    }
+
+    /* Tests_SRS_BUFFER_01_029: [ If handle is NULL, BUFFER_headroom shall return 0. ] */
+    TEST_FUNCTION(BUFFER_headroom_with_NULL_handle_returns_0)
+    {
+        ///arrange
+
+        ///act
+        size_t result = BUFFER_headroom(NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 0, result);
+    }
+
 END_TEST_SUITE(Buffer_UnitTests)
@@ -0,0 +1,798 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdbool.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes_bool.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+#if defined _MSC_VER
+#pragma warning(disable: 4054) /* MSC incorrectly fires this */
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    void* real_malloc(size_t size)
+    {
+        return malloc(size);
+    }
+
+    void* real_calloc(size_t nmemb, size_t size)
+    {
+        return calloc(nmemb, size);
+    }
+
+    void* real_realloc(void* ptr, size_t size)
+    {
+        return realloc(ptr, size);
+    }
+
+    void real_free(void* ptr)
+    {
+        free(ptr);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/constbuffer_array.h"
+#include "azure_c_shared_utility/agenttime.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/tickcounter.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/capture_io.h"
+
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+
+#define TEST_UNDERLYING_INTERFACE_DESCRIPTION   (const IO_INTERFACE_DESCRIPTION*)0x4242
+#define TEST_IO_HANDLE                          (XIO_HANDLE)0x4243
+#define TEST_LOCK_HANDLE                        (LOCK_HANDLE)0x4244
+#define TEST_DUMP_FILE                          "capture_io_ut.pcapng"
+
+MOCK_FUNCTION_WITH_CODE(, void, test_on_io_open_complete, void*, context, IO_OPEN_RESULT, open_result)
+MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_bytes_received, void*, context, const unsigned char*, buffer, size_t, size)
+MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_io_error, void*, context)
+MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_send_complete, void*, context, IO_SEND_RESULT, send_result)
+MOCK_FUNCTION_END();
+
+static ON_BYTES_RECEIVED g_on_bytes_received;
+static void* g_on_bytes_received_context;
+static tickcounter_us_t g_current_us;
+
+static int my_xio_open(XIO_HANDLE xio, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    (void)xio;
+    (void)on_io_open_complete;
+    (void)on_io_open_complete_context;
+    (void)on_io_error;
+    (void)on_io_error_context;
+    g_on_bytes_received = on_bytes_received;
+    g_on_bytes_received_context = on_bytes_received_context;
+    return 0;
+}
+
+static int my_tickcounter_get_monotonic_us(tickcounter_us_t* monotonic_us)
+{
+    *monotonic_us = g_current_us;
+    return 0;
+}
+
+static int test_underlying_parameters;
+
+/* what read_dump found in TEST_DUMP_FILE */
+typedef struct TEST_DUMP_TAG
+{
+    size_t section_count;
+    size_t interface_count;
+    size_t packet_count;
+    /* the last packet */
+    uint32_t interface_id;
+    uint32_t captured_length;
+    uint32_t original_length;
+    uint32_t flags;
+    unsigned char data[16];
+} TEST_DUMP;
+
+static uint32_t get_uint32(const unsigned char* buffer)
+{
+    uint32_t value;
+    (void)memcpy(&value, buffer, sizeof(value));
+    return value;
+}
+
+static void read_dump(TEST_DUMP* dump)
+{
+    unsigned char content[4096];
+    size_t size;
+    size_t offset = 0;
+    FILE* file = fopen(TEST_DUMP_FILE, "rb");
+    ASSERT_IS_NOT_NULL(file);
+    size = fread(content, 1, sizeof(content), file);
+    (void)fclose(file);
+    (void)remove(TEST_DUMP_FILE);
+
+    (void)memset(dump, 0, sizeof(*dump));
+    while (offset + 12 <= size)
+    {
+        uint32_t block_type = get_uint32(content + offset);
+        uint32_t block_length = get_uint32(content + offset + 4);
+        ASSERT_IS_TRUE(offset + block_length <= size);
+        ASSERT_ARE_EQUAL(uint32_t, block_length, get_uint32(content + offset + block_length - 4));
+
+        if (block_type == 0x0A0D0D0A)
+        {
+            ASSERT_ARE_EQUAL(uint32_t, 0x1A2B3C4D, get_uint32(content + offset + 8));
+            dump->section_count++;
+        }
+        else if (block_type == 1)
+        {
+            dump->interface_count++;
+        }
+        else if (block_type == 6)
+        {
+            dump->packet_count++;
+            dump->interface_id = get_uint32(content + offset + 8);
+            dump->captured_length = get_uint32(content + offset + 20);
+            dump->original_length = get_uint32(content + offset + 24);
+            ASSERT_IS_TRUE(dump->captured_length <= sizeof(dump->data));
+            (void)memcpy(dump->data, content + offset + 28, dump->captured_length);
+            dump->flags = get_uint32(content + offset + 28 + ((dump->captured_length + 3) & ~3u) + 4);
+        }
+
+        offset += block_length;
+    }
+
+    ASSERT_ARE_EQUAL(size_t, size, offset);
+}
+
+static CONCRETE_IO_HANDLE create_and_open_capture_io(CAPTURE_IO_RING_HANDLE ring)
+{
+    CAPTURE_IO_CONFIG capture_io_config = { TEST_UNDERLYING_INTERFACE_DESCRIPTION, &test_underlying_parameters, ring, "client" };
+    CONCRETE_IO_HANDLE capture_io = capture_io_get_interface_description()->concrete_io_create(&capture_io_config);
+    (void)capture_io_get_interface_description()->concrete_io_open(capture_io, test_on_io_open_complete, (void*)0x4246, test_on_bytes_received, (void*)0x4247, test_on_io_error, (void*)0x4248);
+    umock_c_reset_all_calls();
+    return capture_io;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+BEGIN_TEST_SUITE(capture_io_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, real_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_calloc, real_calloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, real_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, real_free);
+    REGISTER_GLOBAL_MOCK_RETURN(xio_create, TEST_IO_HANDLE);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_open, my_xio_open);
+    REGISTER_GLOBAL_MOCK_RETURN(xio_send, 0);
+    REGISTER_GLOBAL_MOCK_RETURN(xio_setoption, 0);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(get_time, (time_t)1500000000);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_monotonic_us, my_tickcounter_get_monotonic_us);
+    REGISTER_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT);
+    REGISTER_TYPE(IO_SEND_RESULT, IO_SEND_RESULT);
+    REGISTER_TYPE(LOCK_RESULT, LOCK_RESULT);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(time_t, int);
+    REGISTER_UMOCK_ALIAS_TYPE(time_t*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(CONSTBUFFER_ARRAY_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_CLOSE_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_SEND_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(tickcounter_us_t*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_STATS*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(size_t*, void*);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+    g_on_bytes_received = NULL;
+    g_on_bytes_received_context = NULL;
+    g_current_us = 1000;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* capture_io_ring_create */
+
+/* Tests_SRS_CAPTURE_IO_01_001: [ capture_io_ring_create shall allocate the ring, its records with room for snap_length bytes each and its lock. ]*/
+/* Tests_SRS_CAPTURE_IO_01_003: [ capture_io_ring_create shall round record_count up to a power of 2. ]*/
+/* Tests_SRS_CAPTURE_IO_01_006: [ capture_io_ring_create shall take the wall clock from get_time and the monotonic clock from tickcounter_get_monotonic_us to time the records. ]*/
+TEST_FUNCTION(capture_io_ring_create_succeeds)
+{
+    // arrange
+    CAPTURE_IO_RING_HANDLE ring;
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_calloc(4, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+
+    // act
+    ring = capture_io_ring_create(3, 16);
+
+    // assert
+    ASSERT_IS_NOT_NULL(ring);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    capture_io_ring_destroy(ring);
+}
+
+/* Tests_SRS_CAPTURE_IO_01_002: [ If record_count is 0, capture_io_ring_create shall use CAPTURE_IO_RING_DEFAULT_RECORD_COUNT. ]*/
+TEST_FUNCTION(capture_io_ring_create_with_0_record_count_uses_the_default)
+{
+    // arrange
+    CAPTURE_IO_RING_HANDLE ring;
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_calloc(CAPTURE_IO_RING_DEFAULT_RECORD_COUNT, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+
+    // act
+    ring = capture_io_ring_create(0, 0);
+
+    // assert
+    ASSERT_IS_NOT_NULL(ring);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    capture_io_ring_destroy(ring);
+}
+
+/* Tests_SRS_CAPTURE_IO_01_005: [ If any failure occurs, capture_io_ring_create shall free what it created and return NULL. ]*/
+TEST_FUNCTION(when_creating_the_lock_fails_capture_io_ring_create_fails)
+{
+    // arrange
+    CAPTURE_IO_RING_HANDLE ring;
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_calloc(4, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init())
+        .SetReturn(NULL);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    ring = capture_io_ring_create(4, 16);
+
+    // assert
+    ASSERT_IS_NULL(ring);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CAPTURE_IO_01_004: [ If the records would not fit in memory, capture_io_ring_create shall fail and return NULL. ]*/
+TEST_FUNCTION(capture_io_ring_create_with_a_huge_snap_length_fails)
+{
+    // arrange
+    CAPTURE_IO_RING_HANDLE ring;
+
+    // act
+    ring = capture_io_ring_create(4, SIZE_MAX / 2);
+
+    // assert
+    ASSERT_IS_NULL(ring);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CAPTURE_IO_01_007: [ If ring is NULL, capture_io_ring_destroy shall do nothing. ]*/
+TEST_FUNCTION(capture_io_ring_destroy_with_NULL_ring_does_nothing)
+{
+    // act
+    capture_io_ring_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* capture_io_create */
+
+/* Tests_SRS_CAPTURE_IO_01_021: [ If io_create_parameters is NULL, capture_io_create shall fail and return NULL. ]*/
+TEST_FUNCTION(capture_io_create_with_NULL_io_create_parameters_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE capture_io;
+
+    // act
+    capture_io = capture_io_get_interface_description()->concrete_io_create(NULL);
+
+    // assert
+    ASSERT_IS_NULL(capture_io);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CAPTURE_IO_01_023: [ If underlying_io_interface, ring or name is NULL, capture_io_create shall fail and return NULL. ]*/
+TEST_FUNCTION(capture_io_create_with_NULL_ring_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE capture_io;
+    CAPTURE_IO_CONFIG capture_io_config = { TEST_UNDERLYING_INTERFACE_DESCRIPTION, &test_underlying_parameters, NULL, "client" };
+
+    // act
+    capture_io = capture_io_get_interface_description()->concrete_io_create(&capture_io_config);
+
+    // assert
+    ASSERT_IS_NULL(capture_io);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CAPTURE_IO_01_020: [ capture_io_create shall create a new instance of the capture IO. ]*/
+/* Tests_SRS_CAPTURE_IO_01_022: [ io_create_parameters shall be used as a CAPTURE_IO_CONFIG*. ]*/
+/* Tests_SRS_CAPTURE_IO_01_024: [ capture_io_create shall add name to the interfaces of the ring, unless a capture IO already added it. ]*/
+/* Tests_SRS_CAPTURE_IO_01_025: [ capture_io_create shall create the underlying IO by calling xio_create with underlying_io_interface and underlying_io_parameters. ]*/
+TEST_FUNCTION(capture_io_create_adds_the_interface_and_creates_the_underlying_io)
+{
+    // arrange
+    CONCRETE_IO_HANDLE capture_io;
+    CAPTURE_IO_RING_HANDLE ring = capture_io_ring_create(4, 16);
+    CAPTURE_IO_CONFIG capture_io_config = { TEST_UNDERLYING_INTERFACE_DESCRIPTION, &test_underlying_parameters, ring, "client" };
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, sizeof(char*)));
+    STRICT_EXPECTED_CALL(gballoc_malloc(7));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(xio_create(TEST_UNDERLYING_INTERFACE_DESCRIPTION, &test_underlying_parameters));
+
+    // act
+    capture_io = capture_io_get_interface_description()->concrete_io_create(&capture_io_config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(capture_io);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    capture_io_get_interface_description()->concrete_io_destroy(capture_io);
+    capture_io_ring_destroy(ring);
+}
+
+/* Tests_SRS_CAPTURE_IO_01_024: [ capture_io_create shall add name to the interfaces of the ring, unless a capture IO already added it. ]*/
+TEST_FUNCTION(capture_io_create_reuses_the_interface_of_the_same_name)
+{
+    // arrange
+    CONCRETE_IO_HANDLE capture_io_1;
+    CONCRETE_IO_HANDLE capture_io_2;
+    CAPTURE_IO_RING_HANDLE ring = capture_io_ring_create(4, 16);
+    CAPTURE_IO_CONFIG capture_io_config = { TEST_UNDERLYING_INTERFACE_DESCRIPTION, &test_underlying_parameters, ring, "client" };
+    TEST_DUMP dump;
+    capture_io_1 = capture_io_get_interface_description()->concrete_io_create(&capture_io_config);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(xio_create(TEST_UNDERLYING_INTERFACE_DESCRIPTION, &test_underlying_parameters));
+
+    // act
+    capture_io_2 = capture_io_get_interface_description()->concrete_io_create(&capture_io_config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(capture_io_2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, capture_io_ring_dump(ring, TEST_DUMP_FILE));
+    read_dump(&dump);
+    ASSERT_ARE_EQUAL(size_t, 1, dump.interface_count);
+
+    // cleanup
+    capture_io_get_interface_description()->concrete_io_destroy(capture_io_1);
+    capture_io_get_interface_description()->concrete_io_destroy(capture_io_2);
+    capture_io_ring_destroy(ring);
+}
+
+/* Tests_SRS_CAPTURE_IO_01_026: [ If any failure occurs, capture_io_create shall free what it created and return NULL. ]*/
+TEST_FUNCTION(when_xio_create_fails_capture_io_create_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE capture_io;
+    CAPTURE_IO_RING_HANDLE ring = capture_io_ring_create(4, 16);
+    CAPTURE_IO_CONFIG capture_io_config = { TEST_UNDERLYING_INTERFACE_DESCRIPTION, &test_underlying_parameters, ring, "client" };
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, sizeof(char*)));
+    STRICT_EXPECTED_CALL(gballoc_malloc(7));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(xio_create(TEST_UNDERLYING_INTERFACE_DESCRIPTION, &test_underlying_parameters))
+        .SetReturn(NULL);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    capture_io = capture_io_get_interface_description()->concrete_io_create(&capture_io_config);
+
+    // assert
+    ASSERT_IS_NULL(capture_io);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    capture_io_ring_destroy(ring);
+}
+
+/* capture_io_open */
+
+/* Tests_SRS_CAPTURE_IO_01_031: [ If capture_io or on_bytes_received is NULL, capture_io_open shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(capture_io_open_with_NULL_on_bytes_received_fails)
+{
+    // arrange
+    int result;
+    CAPTURE_IO_RING_HANDLE ring = capture_io_ring_create(4, 16);
+    CAPTURE_IO_CONFIG capture_io_config = { TEST_UNDERLYING_INTERFACE_DESCRIPTION, &test_underlying_parameters, ring, "client" };
+    CONCRETE_IO_HANDLE capture_io = capture_io_get_interface_description()->concrete_io_create(&capture_io_config);
+    umock_c_reset_all_calls();
+
+    // act
+    result = capture_io_get_interface_description()->concrete_io_open(capture_io, test_on_io_open_complete, NULL, NULL, NULL, test_on_io_error, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    capture_io_get_interface_description()->concrete_io_destroy(capture_io);
+    capture_io_ring_destroy(ring);
+}
+
+/* Tests_SRS_CAPTURE_IO_01_032: [ capture_io_open shall call xio_open on the underlying IO with the open and error callbacks of the layer above and its own received bytes callback. ]*/
+TEST_FUNCTION(capture_io_open_opens_the_underlying_io)
+{
+    // arrange
+    int result;
+    CAPTURE_IO_RING_HANDLE ring = capture_io_ring_create(4, 16);
+    CAPTURE_IO_CONFIG capture_io_config = { TEST_UNDERLYING_INTERFACE_DESCRIPTION, &test_underlying_parameters, ring, "client" };
+    CONCRETE_IO_HANDLE capture_io = capture_io_get_interface_description()->concrete_io_create(&capture_io_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, test_on_io_open_complete, (void*)0x4246, IGNORED_PTR_ARG, capture_io, test_on_io_error, (void*)0x4248));
+
+    // act
+    result = capture_io_get_interface_description()->concrete_io_open(capture_io, test_on_io_open_complete, (void*)0x4246, test_on_bytes_received, (void*)0x4247, test_on_io_error, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    capture_io_get_interface_description()->concrete_io_destroy(capture_io);
+    capture_io_ring_destroy(ring);
+}
+
+/* Tests_SRS_CAPTURE_IO_01_033: [ If xio_open fails, capture_io_open shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_xio_open_fails_capture_io_open_fails)
+{
+    // arrange
+    int result;
+    CAPTURE_IO_RING_HANDLE ring = capture_io_ring_create(4, 16);
+    CAPTURE_IO_CONFIG capture_io_config = { TEST_UNDERLYING_INTERFACE_DESCRIPTION, &test_underlying_parameters, ring, "client" };
+    CONCRETE_IO_HANDLE capture_io = capture_io_get_interface_description()->concrete_io_create(&capture_io_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, test_on_io_open_complete, (void*)0x4246, IGNORED_PTR_ARG, capture_io, test_on_io_error, (void*)0x4248))
+        .SetReturn(1);
+
+    // act
+    result = capture_io_get_interface_description()->concrete_io_open(capture_io, test_on_io_open_complete, (void*)0x4246, test_on_bytes_received, (void*)0x4247, test_on_io_error, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    capture_io_get_interface_description()->concrete_io_destroy(capture_io);
+    capture_io_ring_destroy(ring);
+}
+
+/* capture_io_send */
+
+/* Tests_SRS_CAPTURE_IO_01_035: [ If capture_io or buffer is NULL or size is 0, capture_io_send shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(capture_io_send_with_0_size_fails)
+{
+    // arrange
+    int result;
+    const unsigned char bytes[] = { 0x42 };
+    CAPTURE_IO_RING_HANDLE ring = capture_io_ring_create(4, 16);
+    CONCRETE_IO_HANDLE capture_io = create_and_open_capture_io(ring);
+
+    // act
+    result = capture_io_get_interface_description()->concrete_io_send(capture_io, bytes, 0, test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    capture_io_get_interface_description()->concrete_io_destroy(capture_io);
+    capture_io_ring_destroy(ring);
+}
+
+/* Tests_SRS_CAPTURE_IO_01_036: [ capture_io_send shall record the bytes as outbound and send them by calling xio_send on the underlying IO. ]*/
+/* Tests_SRS_CAPTURE_IO_01_011: [ capture_io_ring_dump shall then write one enhanced packet block per record of the ring, oldest first, with its time, its captured bytes, its size and its direction in the epb_flags option. ]*/
+TEST_FUNCTION(capture_io_send_records_the_bytes_as_outbound_and_sends_them)
+{
+    // arrange
+    int result;
+    const unsigned char bytes[] = { 'h', 'e', 'l', 'l', 'o' };
+    CAPTURE_IO_RING_HANDLE ring = capture_io_ring_create(4, 4);
+    CONCRETE_IO_HANDLE capture_io = create_and_open_capture_io(ring);
+    TEST_DUMP dump;
+
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, bytes, sizeof(bytes), test_on_send_complete, (void*)0x4249));
+
+    // act
+    result = capture_io_get_interface_description()->concrete_io_send(capture_io, bytes, sizeof(bytes), test_on_send_complete, (void*)0x4249);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, capture_io_ring_dump(ring, TEST_DUMP_FILE));
+    read_dump(&dump);
+    ASSERT_ARE_EQUAL(size_t, 1, dump.section_count);
+    ASSERT_ARE_EQUAL(size_t, 1, dump.interface_count);
+    ASSERT_ARE_EQUAL(size_t, 1, dump.packet_count);
+    ASSERT_ARE_EQUAL(uint32_t, 0, dump.interface_id);
+    ASSERT_ARE_EQUAL(uint32_t, 4, dump.captured_length);
+    ASSERT_ARE_EQUAL(uint32_t, 5, dump.original_length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(dump.data, "hell", 4));
+    ASSERT_ARE_EQUAL(uint32_t, 2, dump.flags);
+
+    // cleanup
+    capture_io_get_interface_description()->concrete_io_destroy(capture_io);
+    capture_io_ring_destroy(ring);
+}
+
+/* Tests_SRS_CAPTURE_IO_01_037: [ If the underlying send fails, capture_io_send, capture_io_sendv and capture_io_send_constbuffer_array shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_xio_send_fails_capture_io_send_fails)
+{
+    // arrange
+    int result;
+    const unsigned char bytes[] = { 0x42 };
+    CAPTURE_IO_RING_HANDLE ring = capture_io_ring_create(4, 16);
+    CONCRETE_IO_HANDLE capture_io = create_and_open_capture_io(ring);
+
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, bytes, sizeof(bytes), test_on_send_complete, NULL))
+        .SetReturn(1);
+
+    // act
+    result = capture_io_get_interface_description()->concrete_io_send(capture_io, bytes, sizeof(bytes), test_on_send_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    capture_io_get_interface_description()->concrete_io_destroy(capture_io);
+    capture_io_ring_destroy(ring);
+}
+
+/* on_bytes_received */
+
+/* Tests_SRS_CAPTURE_IO_01_030: [ When the underlying IO indicates received bytes, the capture IO shall record them as inbound and indicate them to the layer above. ]*/
+TEST_FUNCTION(received_bytes_are_recorded_as_inbound_and_indicated)
+{
+    // arrange
+    const unsigned char bytes[] = { 'o', 'k' };
+    CAPTURE_IO_RING_HANDLE ring = capture_io_ring_create(4, 16);
+    CONCRETE_IO_HANDLE capture_io = create_and_open_capture_io(ring);
+    TEST_DUMP dump;
+
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_bytes_received((void*)0x4247, bytes, sizeof(bytes)));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, bytes, sizeof(bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, capture_io_ring_dump(ring, TEST_DUMP_FILE));
+    read_dump(&dump);
+    ASSERT_ARE_EQUAL(size_t, 1, dump.packet_count);
+    ASSERT_ARE_EQUAL(uint32_t, 2, dump.captured_length);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(dump.data, "ok", 2));
+    ASSERT_ARE_EQUAL(uint32_t, 1, dump.flags);
+
+    // cleanup
+    capture_io_get_interface_description()->concrete_io_destroy(capture_io);
+    capture_io_ring_destroy(ring);
+}
+
+/* capture_io_ring_dump */
+
+/* Tests_SRS_CAPTURE_IO_01_009: [ If ring or file_path is NULL, capture_io_ring_dump shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(capture_io_ring_dump_with_NULL_file_path_fails)
+{
+    // arrange
+    int result;
+    CAPTURE_IO_RING_HANDLE ring = capture_io_ring_create(4, 16);
+    umock_c_reset_all_calls();
+
+    // act
+    result = capture_io_ring_dump(ring, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    capture_io_ring_destroy(ring);
+}
+
+/* Tests_SRS_CAPTURE_IO_01_011: [ capture_io_ring_dump shall then write one enhanced packet block per record of the ring, oldest first, with its time, its captured bytes, its size and its direction in the epb_flags option. ]*/
+TEST_FUNCTION(capture_io_ring_dump_keeps_the_last_records)
+{
+    // arrange
+    const unsigned char bytes[] = { '0', '1', '2', '3', '4', '5' };
+    CAPTURE_IO_RING_HANDLE ring = capture_io_ring_create(4, 16);
+    CONCRETE_IO_HANDLE capture_io = create_and_open_capture_io(ring);
+    TEST_DUMP dump;
+    size_t i;
+
+    for (i = 0; i < sizeof(bytes); i++)
+    {
+        (void)capture_io_get_interface_description()->concrete_io_send(capture_io, &bytes[i], 1, test_on_send_complete, NULL);
+    }
+
+    // act
+    ASSERT_ARE_EQUAL(int, 0, capture_io_ring_dump(ring, TEST_DUMP_FILE));
+
+    // assert
+    read_dump(&dump);
+    ASSERT_ARE_EQUAL(size_t, 4, dump.packet_count);
+    ASSERT_ARE_EQUAL(uint32_t, 1, dump.captured_length);
+    ASSERT_ARE_EQUAL(int, '5', (int)dump.data[0]);
+
+    // cleanup
+    capture_io_get_interface_description()->concrete_io_destroy(capture_io);
+    capture_io_ring_destroy(ring);
+}
+
+/* capture_io_get_stats */
+
+/* Tests_SRS_CAPTURE_IO_01_042: [ capture_io_get_stats shall fill the first entry of stats with the counters of the capture IO and the following ones by calling xio_get_stats on the underlying IO. ]*/
+TEST_FUNCTION(capture_io_get_stats_fills_the_counters_of_the_capture_io)
+{
+    // arrange
+    int result;
+    const unsigned char bytes[] = { 0x42, 0x43 };
+    XIO_STATS stats[1];
+    size_t layer_count;
+    CAPTURE_IO_RING_HANDLE ring = capture_io_ring_create(4, 16);
+    CONCRETE_IO_HANDLE capture_io = create_and_open_capture_io(ring);
+    (void)capture_io_get_interface_description()->concrete_io_send(capture_io, bytes, sizeof(bytes), test_on_send_complete, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = capture_io_get_interface_description()->concrete_io_get_stats(capture_io, stats, 1, &layer_count);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, layer_count);
+    ASSERT_ARE_EQUAL(char_ptr, "capture_io", stats[0].layer_name);
+    ASSERT_ARE_EQUAL(uint64_t, 2, stats[0].bytes_sent);
+    ASSERT_ARE_EQUAL(uint64_t, 1, stats[0].send_count);
+
+    // cleanup
+    capture_io_get_interface_description()->concrete_io_destroy(capture_io);
+    capture_io_ring_destroy(ring);
+}
+
+/* capture_io_set_option */
+
+/* Tests_SRS_CAPTURE_IO_01_041: [ capture_io_get_pollable_handle, capture_io_set_receive_buffer, capture_io_set_option and capture_io_retrieve_options shall return the result of the same call on the underlying IO. ]*/
+TEST_FUNCTION(capture_io_set_option_sets_the_option_on_the_underlying_io)
+{
+    // arrange
+    int result;
+    int value = 42;
+    CAPTURE_IO_RING_HANDLE ring = capture_io_ring_create(4, 16);
+    CONCRETE_IO_HANDLE capture_io = create_and_open_capture_io(ring);
+
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_IO_HANDLE, "some_option", &value));
+
+    // act
+    result = capture_io_get_interface_description()->concrete_io_setoption(capture_io, "some_option", &value);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    capture_io_get_interface_description()->concrete_io_destroy(capture_io);
+    capture_io_ring_destroy(ring);
+}
+
+/* capture_io_get_interface_description */
+
+/* Tests_SRS_CAPTURE_IO_01_043: [ capture_io_get_interface_description shall return a pointer to an IO_INTERFACE_DESCRIPTION structure that contains pointers to the functions of the capture IO. ]*/
+TEST_FUNCTION(capture_io_get_interface_description_returns_all_the_functions)
+{
+    // act
+    const IO_INTERFACE_DESCRIPTION* io_interface_description = capture_io_get_interface_description();
+
+    // assert
+    ASSERT_IS_NOT_NULL(io_interface_description);
+    ASSERT_IS_NOT_NULL(io_interface_description->concrete_io_create);
+    ASSERT_IS_NOT_NULL(io_interface_description->concrete_io_sendv);
+    ASSERT_IS_NOT_NULL(io_interface_description->concrete_io_get_stats);
+    ASSERT_IS_NOT_NULL(io_interface_description->concrete_io_set_receive_buffer);
+}
+
+END_TEST_SUITE(capture_io_unittests)
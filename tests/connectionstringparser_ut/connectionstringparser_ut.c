@@ -3,8 +3,12 @@
 
 #ifdef __cplusplus
 #include <cstdlib>
+#include <cstdio>
+#include <cstring>
 #else
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 #endif
 
 static void* my_gballoc_malloc(size_t size)
@@ -34,8 +38,9 @@ void* my_gballoc_realloc(void* ptr, size_t size)
 #define ENABLE_MOCKS
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/map.h"
-#include "azure_c_shared_utility/string_tokenizer.h"
 #include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/lock.h"
 #include "azure_c_shared_utility/optimize_size.h"
 #include "azure_c_shared_utility/xlogging.h"
 #undef ENABLE_MOCKS
@@ -43,7 +48,6 @@ void* my_gballoc_realloc(void* ptr, size_t size)
 #include "azure_c_shared_utility/connection_string_parser.h"
 
 #include "real_map.h"
-#include "real_string_tokenizer.h"
 #include "real_strings.h"
 
 IMPLEMENT_UMOCK_C_ENUM_TYPE(MAP_RESULT, MAP_RESULT_VALUES);
@@ -58,6 +62,10 @@ static const char* TEST_STRING_2_PAIR = "key1=value1;key2=value2";
 STRING_HANDLE TEST_STRING_HANDLE_2_PAIR;
 static const char* TEST_STRING_2_PAIR_SEMICOLON = "key1=value1;key2=value2;";
 STRING_HANDLE TEST_STRING_HANDLE_2_PAIR_SEMICOLON;
+static const char* TEST_STRING_NO_KEY = "=value1";
+static const char* TEST_STRING_PAIR_AND_KEY = "key1=value1;key2";
+static const char* TEST_DEVICE_CONNECTION_STRING = "HostName=some.azure-devices.net;DeviceId=device1;SharedAccessKey=abc==;Custom=value1";
+static const LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4243;
 
 DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
 
@@ -85,18 +93,23 @@ TEST_SUITE_INITIALIZE(suite_init)
     ASSERT_ARE_EQUAL(int, 0, result);
 
     REGISTER_TYPE(MAP_RESULT, MAP_RESULT);
-    REGISTER_UMOCK_ALIAS_TYPE(STRING_TOKENIZER_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(STRING_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(MAP_FILTER_CALLBACK, void*);
     REGISTER_UMOCK_ALIAS_TYPE(MAP_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(STRING_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_RESULT, int);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock_Init, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
 
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
 
     REGISTER_STRING_GLOBAL_MOCK_HOOK;
-    REGISTER_STRING_TOKENIZER_GLOBAL_MOCK_HOOK;
     REGISTER_MAP_GLOBAL_MOCK_HOOK;
 
     TEST_STRING_HANDLE_PAIR = STRING_construct(TEST_STRING_PAIR);
@@ -135,31 +148,24 @@ TEST_FUNCTION_CLEANUP(TestMethodCleanup)
 /* connectionstringparser_parse */
 
 /* Tests_SRS_CONNECTIONSTRINGPARSER_01_001: [connectionstringparser_parse shall parse all key value pairs from the connection_string passed in as argument and return a new map that holds the key/value pairs.]  */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_003: [connectionstringparser_parse shall create a STRING tokenizer to be used for parsing the connection string, by calling STRING_TOKENIZER_create.] */
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_003: [connectionstringparser_parse shall make a single copy of the connection string, in which the key and value tokens are null-terminated in place.] */
 /* Tests_SRS_CONNECTIONSTRINGPARSER_01_004: [connectionstringparser_parse shall start scanning at the beginning of the connection string.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_016: [2 STRINGs shall be allocated in order to hold the to be parsed key and value tokens.] */
 /* Tests_SRS_CONNECTIONSTRINGPARSER_01_005: [The following actions shall be repeated until parsing is complete:] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_006: [connectionstringparser_parse shall find a token (the key of the key/value pair) delimited by the "=" character, by calling STRING_TOKENIZER_get_next_token.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_007: [If STRING_TOKENIZER_get_next_token fails, parsing shall be considered complete.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_014: [After the parsing is complete the previously allocated STRINGs and STRING tokenizer shall be freed by calling STRING_TOKENIZER_destroy.] */
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_006: [connectionstringparser_parse shall find a token (the key of the key/value pair) delimited by the "=" character, by calling StringToken_NextView.] */
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_007: [If the remainder of the connection string is empty, parsing shall be considered complete.] */
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_014: [After the parsing is complete the copy of the connection string shall be freed.] */
 TEST_FUNCTION(connectionstringparser_parse_with_an_empty_string_yields_an_empty_map)
 {
     // arrange
     MAP_HANDLE result;
     STRING_HANDLE connectionString = STRING_new();
-    STRING_HANDLE key = STRING_new();
-    STRING_HANDLE value = STRING_new();
-    STRING_TOKENIZER_HANDLE tokens = STRING_TOKENIZER_create(connectionString);
 
     umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_create(connectionString)).SetReturn(tokens);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(key);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(value);
+    STRICT_EXPECTED_CALL(STRING_c_str(connectionString));
+    STRICT_EXPECTED_CALL(STRING_length(connectionString));
+    STRICT_EXPECTED_CALL(gballoc_malloc(1));
     STRICT_EXPECTED_CALL(Map_Create(NULL));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, key, "="));
-    STRICT_EXPECTED_CALL(STRING_delete(value));
-    STRICT_EXPECTED_CALL(STRING_delete(key));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_destroy(tokens));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = connectionstringparser_parse(connectionString);
@@ -185,59 +191,33 @@ TEST_FUNCTION(connectionstringparser_parse_with_NULL_connection_string_fails)
     ASSERT_ARE_EQUAL(void_ptr, NULL, result);
 }
 
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_015: [If STRING_TOKENIZER_create fails, connectionstringparser_parse shall fail and return NULL.] */
-TEST_FUNCTION(when_creating_the_string_tokenizer_fails_then_connectionstringparser_fails)
-{
-    // arrange
-    MAP_HANDLE result;
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_create(TEST_STRING_HANDLE_PAIR))
-        .SetReturn((STRING_TOKENIZER_HANDLE)NULL);
-
-    // act
-    result = connectionstringparser_parse(TEST_STRING_HANDLE_PAIR);
-
-    // assert
-    ASSERT_ARE_EQUAL(void_ptr, NULL, result);
-
-    // cleanup
-}
-
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_017: [If allocating the STRINGs fails connectionstringparser_parse shall fail and return NULL.] */
-TEST_FUNCTION(when_allocating_the_key_token_string_fails_then_connectionstringparser_fails)
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_013: [If STRING_c_str fails then connectionstringparser_parse shall fail and return NULL.] */
+TEST_FUNCTION(when_getting_the_C_string_for_the_connection_string_fails_then_connectionstringparser_parse_fails)
 {
     // arrange
     MAP_HANDLE result;
-    STRING_TOKENIZER_HANDLE tokens = STRING_TOKENIZER_create(TEST_STRING_HANDLE_PAIR);
 
     umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_create(TEST_STRING_HANDLE_PAIR)).SetReturn(tokens);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn((STRING_HANDLE)NULL);
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_destroy(tokens));
+    STRICT_EXPECTED_CALL(STRING_c_str(TEST_STRING_HANDLE_PAIR)).SetReturn((const char*)NULL);
 
     // act
     result = connectionstringparser_parse(TEST_STRING_HANDLE_PAIR);
 
     // assert
-    ASSERT_ARE_EQUAL(void_ptr, NULL, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
+    ASSERT_ARE_EQUAL(void_ptr, NULL, result);
 }
 
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_017: [If allocating the STRINGs fails connectionstringparser_parse shall fail and return NULL.] */
-TEST_FUNCTION(when_allocating_the_value_token_string_fails_then_connectionstringparser_fails)
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_015: [If allocating the copy of the connection string fails, connectionstringparser_parse shall fail and return NULL.] */
+TEST_FUNCTION(when_allocating_the_connection_string_copy_fails_then_connectionstringparser_fails)
 {
     // arrange
     MAP_HANDLE result;
-    STRING_HANDLE key = STRING_new();
-    STRING_TOKENIZER_HANDLE tokens = STRING_TOKENIZER_create(TEST_STRING_HANDLE_PAIR);
 
     umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_create(TEST_STRING_HANDLE_PAIR)).SetReturn(tokens);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(key);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn((STRING_HANDLE)NULL);
-    STRICT_EXPECTED_CALL(STRING_delete(key));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_destroy(tokens));
+    STRICT_EXPECTED_CALL(STRING_c_str(TEST_STRING_HANDLE_PAIR));
+    STRICT_EXPECTED_CALL(STRING_length(TEST_STRING_HANDLE_PAIR));
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_STRING_PAIR) + 1)).SetReturn(NULL);
 
     // act
     result = connectionstringparser_parse(TEST_STRING_HANDLE_PAIR);
@@ -254,18 +234,13 @@ TEST_FUNCTION(when_allocating_the_result_map_fails_then_connectionstringparser_f
 {
     // arrange
     MAP_HANDLE result;
-    STRING_HANDLE key = STRING_new();
-    STRING_HANDLE value = STRING_new();
-    STRING_TOKENIZER_HANDLE tokens = STRING_TOKENIZER_create(TEST_STRING_HANDLE_PAIR);
 
     umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_create(TEST_STRING_HANDLE_PAIR)).SetReturn(tokens);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(key);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(value);
+    STRICT_EXPECTED_CALL(STRING_c_str(TEST_STRING_HANDLE_PAIR));
+    STRICT_EXPECTED_CALL(STRING_length(TEST_STRING_HANDLE_PAIR));
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_STRING_PAIR) + 1));
     STRICT_EXPECTED_CALL(Map_Create(NULL)).SetReturn((MAP_HANDLE)NULL);
-    STRICT_EXPECTED_CALL(STRING_delete(value));
-    STRICT_EXPECTED_CALL(STRING_delete(key));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_destroy(tokens));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = connectionstringparser_parse(TEST_STRING_HANDLE_PAIR);
@@ -278,44 +253,23 @@ TEST_FUNCTION(when_allocating_the_result_map_fails_then_connectionstringparser_f
 }
 
 /* Tests_SRS_CONNECTIONSTRINGPARSER_01_001: [connectionstringparser_parse shall parse all key value pairs from the connection_string passed in as argument and return a new map that holds the key/value pairs.]  */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_003: [connectionstringparser_parse shall create a STRING tokenizer to be used for parsing the connection string, by calling STRING_TOKENIZER_create.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_004: [connectionstringparser_parse shall start scanning at the beginning of the connection string.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_016: [2 STRINGs shall be allocated in order to hold the to be parsed key and value tokens.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_005: [The following actions shall be repeated until parsing is complete:] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_006: [connectionstringparser_parse shall find a token (the key of the key/value pair) delimited by the "=" character, by calling STRING_TOKENIZER_get_next_token.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_007: [If STRING_TOKENIZER_get_next_token fails, parsing shall be considered complete.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_014: [After the parsing is complete the previously allocated STRINGs and STRING tokenizer shall be freed by calling STRING_TOKENIZER_destroy.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_008: [connectionstringparser_parse shall find a token (the value of the key/value pair) delimited by the ";" character, by calling STRING_TOKENIZER_get_next_token.] */
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_008: [connectionstringparser_parse shall find a token (the value of the key/value pair) delimited by the ";" character or the end of the connection string, by calling StringToken_NextView.] */
 /* Tests_SRS_CONNECTIONSTRINGPARSER_01_010: [The key and value shall be added to the result map by using Map_Add.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_011: [The C strings for the key and value shall be extracted from the previously parsed STRINGs by using STRING_c_str.] */
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_011: [The key and value shall be null-terminated in place, by overwriting the delimiter that follows them in the copy of the connection string.] */
 TEST_FUNCTION(connectionstringparser_parse_with_a_key_value_pair_adds_it_to_the_result_map)
 {
     // arrange
     MAP_HANDLE result;
-    STRING_HANDLE key = STRING_new();
-    STRING_HANDLE value = STRING_new();
-    STRING_TOKENIZER_HANDLE tokens = STRING_TOKENIZER_create(TEST_STRING_HANDLE_PAIR);
 
     umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_create(TEST_STRING_HANDLE_PAIR)).SetReturn(tokens);
-    STRICT_EXPECTED_CALL(STRING_new())
-        .SetReturn(key);
-    STRICT_EXPECTED_CALL(STRING_new())
-        .SetReturn(value);
+    STRICT_EXPECTED_CALL(STRING_c_str(TEST_STRING_HANDLE_PAIR));
+    STRICT_EXPECTED_CALL(STRING_length(TEST_STRING_HANDLE_PAIR));
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_STRING_PAIR) + 1));
     STRICT_EXPECTED_CALL(Map_Create(NULL));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, key, "="));
-    STRICT_EXPECTED_CALL(STRING_copy_n(key, TEST_STRING_PAIR, 4));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, value, ";"));
-    STRICT_EXPECTED_CALL(STRING_copy_n(value, (TEST_STRING_PAIR +5), 6));
-    STRICT_EXPECTED_CALL(STRING_c_str(key));
-    STRICT_EXPECTED_CALL(STRING_c_str(value));
     STRICT_EXPECTED_CALL(Map_Add(IGNORED_PTR_ARG, "key1", "value1")).IgnoreArgument(1);
     STRICT_EXPECTED_CALL(gballoc_malloc(5));
     STRICT_EXPECTED_CALL(gballoc_malloc(7));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, key, "="));
-    STRICT_EXPECTED_CALL(STRING_delete(value));
-    STRICT_EXPECTED_CALL(STRING_delete(key));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_destroy(tokens));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = connectionstringparser_parse(TEST_STRING_HANDLE_PAIR);
@@ -324,35 +278,26 @@ TEST_FUNCTION(connectionstringparser_parse_with_a_key_value_pair_adds_it_to_the_
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     ASSERT_ARE_NOT_EQUAL(void_ptr, NULL, result);
     ASSERT_ARE_EQUAL(char_ptr, "value1", Map_GetValueFromKey(result, "key1"));
+    ASSERT_ARE_EQUAL(char_ptr, TEST_STRING_PAIR, STRING_c_str(TEST_STRING_HANDLE_PAIR));
 
     // cleanup
     Map_Destroy(result);
 }
 
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_009: [If STRING_TOKENIZER_get_next_token fails, connectionstringparser_parse shall fail and return NULL (freeing the allocated result map).] */
-TEST_FUNCTION(when_getting_the_value_token_fails_then_connectionstringparser_parse_fails)
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_009: [If the value token is empty, connectionstringparser_parse shall fail and return NULL (freeing the allocated result map).] */
+TEST_FUNCTION(when_the_value_is_empty_then_connectionstringparser_parse_fails)
 {
     // arrange
     MAP_HANDLE result;
-    STRING_HANDLE key = STRING_new();
-    STRING_HANDLE value = STRING_new();
     MAP_HANDLE map = Map_Create(NULL);
-    STRING_TOKENIZER_HANDLE tokens = STRING_TOKENIZER_create(TEST_STRING_HANDLE_KEY);
 
     umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_create(TEST_STRING_HANDLE_KEY)).SetReturn(tokens);
-    STRICT_EXPECTED_CALL(STRING_new())
-        .SetReturn(key);
-    STRICT_EXPECTED_CALL(STRING_new())
-        .SetReturn(value);
+    STRICT_EXPECTED_CALL(STRING_c_str(TEST_STRING_HANDLE_KEY));
+    STRICT_EXPECTED_CALL(STRING_length(TEST_STRING_HANDLE_KEY));
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_STRING_KEY) + 1));
     STRICT_EXPECTED_CALL(Map_Create(NULL)).SetReturn(map);
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, key, "="));
-    STRICT_EXPECTED_CALL(STRING_copy_n(key, TEST_STRING_KEY, 4));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, value, ";"));
     STRICT_EXPECTED_CALL(Map_Destroy(map));
-    STRICT_EXPECTED_CALL(STRING_delete(value));
-    STRICT_EXPECTED_CALL(STRING_delete(key));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_destroy(tokens));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = connectionstringparser_parse(TEST_STRING_HANDLE_KEY);
@@ -367,133 +312,61 @@ TEST_FUNCTION(when_the_key_is_zero_length_then_connectionstringparser_parse_fail
 {
     // arrange
     MAP_HANDLE result;
-    STRING_HANDLE key = STRING_new();
-    STRING_HANDLE value = STRING_new();
     MAP_HANDLE map = Map_Create(NULL);
 
     umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_create(TEST_STRING_HANDLE_PAIR));
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_STRING_HANDLE_PAIR));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)).IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(key);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(value);
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_STRING_NO_KEY) + 1));
     STRICT_EXPECTED_CALL(Map_Create(NULL)).SetReturn(map);
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(IGNORED_PTR_ARG, key, "=")).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(STRING_copy_n(key, TEST_STRING_PAIR, 4));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(IGNORED_PTR_ARG, value, ";")).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(STRING_copy_n(value, (TEST_STRING_PAIR + 5), 6));
-    STRICT_EXPECTED_CALL(STRING_c_str(key)).SetReturn("");
     STRICT_EXPECTED_CALL(Map_Destroy(map));
-    STRICT_EXPECTED_CALL(STRING_delete(value));
-    STRICT_EXPECTED_CALL(STRING_delete(key));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_destroy(IGNORED_PTR_ARG)).IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
-    result = connectionstringparser_parse(TEST_STRING_HANDLE_PAIR);
+    result = connectionstringparser_parse_from_char(TEST_STRING_NO_KEY);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     ASSERT_ARE_EQUAL(void_ptr, NULL, result);
 }
 
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_012: [If Map_Add fails connectionstringparser_parse shall fail and return NULL (freeing the allocated result map).] */
-TEST_FUNCTION(when_adding_the_key_value_pair_to_the_map_fails_then_connectionstringparser_parse_fails)
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_020: [If the remainder of the connection string is not empty and has no = character, connectionstringparser_parse shall fail and return NULL (freeing the allocated result map).] */
+TEST_FUNCTION(when_the_last_key_has_no_value_then_connectionstringparser_parse_fails)
 {
     // arrange
     MAP_HANDLE result;
-    STRING_HANDLE key = STRING_new();
-    STRING_HANDLE value = STRING_new();
     MAP_HANDLE map = Map_Create(NULL);
-    STRING_TOKENIZER_HANDLE tokens = STRING_TOKENIZER_create(TEST_STRING_HANDLE_PAIR);
 
     umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_create(TEST_STRING_HANDLE_PAIR)).SetReturn(tokens);
-    STRICT_EXPECTED_CALL(STRING_new())
-        .SetReturn(key);
-    STRICT_EXPECTED_CALL(STRING_new())
-        .SetReturn(value);
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_STRING_PAIR_AND_KEY) + 1));
     STRICT_EXPECTED_CALL(Map_Create(NULL)).SetReturn(map);
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, key, "="));
-    STRICT_EXPECTED_CALL(STRING_copy_n(key, TEST_STRING_PAIR, 4));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, value, ";"));
-    STRICT_EXPECTED_CALL(STRING_copy_n(value, (TEST_STRING_PAIR + 5), 6));
-    STRICT_EXPECTED_CALL(STRING_c_str(key));
-    STRICT_EXPECTED_CALL(STRING_c_str(value));
-    STRICT_EXPECTED_CALL(Map_Add(map, "key1", "value1")).SetReturn((MAP_RESULT)MAP_INVALIDARG);
+    STRICT_EXPECTED_CALL(Map_Add(map, "key1", "value1"));
+    STRICT_EXPECTED_CALL(gballoc_malloc(5));
+    STRICT_EXPECTED_CALL(gballoc_malloc(7));
     STRICT_EXPECTED_CALL(Map_Destroy(map));
-    STRICT_EXPECTED_CALL(STRING_delete(value));
-    STRICT_EXPECTED_CALL(STRING_delete(key));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_destroy(tokens));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
-    result = connectionstringparser_parse(TEST_STRING_HANDLE_PAIR);
+    result = connectionstringparser_parse_from_char(TEST_STRING_PAIR_AND_KEY);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     ASSERT_ARE_EQUAL(void_ptr, NULL, result);
 }
 
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_013: [If STRING_c_str fails then connectionstringparser_parse shall fail and return NULL (freeing the allocated result map).] */
-TEST_FUNCTION(when_getting_the_C_string_for_the_key_fails_then_connectionstringparser_parse_fails)
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_012: [If Map_Add fails connectionstringparser_parse shall fail and return NULL (freeing the allocated result map).] */
+TEST_FUNCTION(when_adding_the_key_value_pair_to_the_map_fails_then_connectionstringparser_parse_fails)
 {
     // arrange
     MAP_HANDLE result;
-    STRING_HANDLE key = STRING_new();
-    STRING_HANDLE value = STRING_new();
     MAP_HANDLE map = Map_Create(NULL);
 
     umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_create(TEST_STRING_HANDLE_PAIR));
     STRICT_EXPECTED_CALL(STRING_c_str(TEST_STRING_HANDLE_PAIR));
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)).IgnoreAllArguments();
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(key);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(value);
-    STRICT_EXPECTED_CALL(Map_Create(NULL)).SetReturn(map);
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(IGNORED_PTR_ARG, key, "=")).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(STRING_copy_n(key, TEST_STRING_PAIR, 4));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(IGNORED_PTR_ARG, value, ";")).IgnoreArgument(1);
-    STRICT_EXPECTED_CALL(STRING_copy_n(value, (TEST_STRING_PAIR + 5), 6));
-    STRICT_EXPECTED_CALL(STRING_c_str(key)).SetReturn(NULL);
-    STRICT_EXPECTED_CALL(Map_Destroy(map));
-    STRICT_EXPECTED_CALL(STRING_delete(value));
-    STRICT_EXPECTED_CALL(STRING_delete(key));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_destroy(IGNORED_PTR_ARG)).IgnoreArgument(1);
-
-    // act
-    result = connectionstringparser_parse(TEST_STRING_HANDLE_PAIR);
-
-    // assert
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_EQUAL(void_ptr, NULL, result);
-}
-
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_013: [If STRING_c_str fails then connectionstringparser_parse shall fail and return NULL (freeing the allocated result map).] */
-TEST_FUNCTION(when_getting_the_C_string_for_the_value_fails_then_connectionstringparser_parse_fails)
-{
-    // arrange
-    MAP_HANDLE result;
-    STRING_HANDLE key = STRING_new();
-    STRING_HANDLE value = STRING_new();
-    MAP_HANDLE map = Map_Create(NULL);
-    STRING_TOKENIZER_HANDLE tokens = STRING_TOKENIZER_create(TEST_STRING_HANDLE_PAIR);
-
-    umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_create(TEST_STRING_HANDLE_PAIR)).SetReturn(tokens);
-    STRICT_EXPECTED_CALL(STRING_new())
-        .SetReturn(key);
-    STRICT_EXPECTED_CALL(STRING_new())
-        .SetReturn(value);
+    STRICT_EXPECTED_CALL(STRING_length(TEST_STRING_HANDLE_PAIR));
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_STRING_PAIR) + 1));
     STRICT_EXPECTED_CALL(Map_Create(NULL)).SetReturn(map);
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, key, "="));
-    STRICT_EXPECTED_CALL(STRING_copy_n(key, TEST_STRING_PAIR, 4));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, value, ";"));
-    STRICT_EXPECTED_CALL(STRING_copy_n(value, (TEST_STRING_PAIR + 5), 6));
-    STRICT_EXPECTED_CALL(STRING_c_str(key));
-    STRICT_EXPECTED_CALL(STRING_c_str(value)).SetReturn((const char*)NULL);
+    STRICT_EXPECTED_CALL(Map_Add(map, "key1", "value1")).SetReturn((MAP_RESULT)MAP_INVALIDARG);
     STRICT_EXPECTED_CALL(Map_Destroy(map));
-    STRICT_EXPECTED_CALL(STRING_delete(value));
-    STRICT_EXPECTED_CALL(STRING_delete(key));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_destroy(tokens));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = connectionstringparser_parse(TEST_STRING_HANDLE_PAIR);
@@ -504,59 +377,29 @@ TEST_FUNCTION(when_getting_the_C_string_for_the_value_fails_then_connectionstrin
 }
 
 /* Tests_SRS_CONNECTIONSTRINGPARSER_01_001: [connectionstringparser_parse shall parse all key value pairs from the connection_string passed in as argument and return a new map that holds the key/value pairs.]  */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_003: [connectionstringparser_parse shall create a STRING tokenizer to be used for parsing the connection string, by calling STRING_TOKENIZER_create.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_004: [connectionstringparser_parse shall start scanning at the beginning of the connection string.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_016: [2 STRINGs shall be allocated in order to hold the to be parsed key and value tokens.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_005: [The following actions shall be repeated until parsing is complete:] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_006: [connectionstringparser_parse shall find a token (the key of the key/value pair) delimited by the "=" character, by calling STRING_TOKENIZER_get_next_token.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_007: [If STRING_TOKENIZER_get_next_token fails, parsing shall be considered complete.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_014: [After the parsing is complete the previously allocated STRINGs and STRING tokenizer shall be freed by calling STRING_TOKENIZER_destroy.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_008: [connectionstringparser_parse shall find a token (the value of the key/value pair) delimited by the ";" character, by calling STRING_TOKENIZER_get_next_token.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_010: [The key and value shall be added to the result map by using Map_Add.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_011: [The C strings for the key and value shall be extracted from the previously parsed STRINGs by using STRING_c_str.] */
 TEST_FUNCTION(connectionstringparser_parse_with_2_key_value_pairs_adds_them_to_the_result_map)
 {
     // arrange
     MAP_HANDLE result;
-    STRING_HANDLE key = STRING_new();
-    STRING_HANDLE value = STRING_new();
     MAP_HANDLE map = Map_Create(NULL);
-    STRING_TOKENIZER_HANDLE tokens = STRING_TOKENIZER_create(TEST_STRING_HANDLE_2_PAIR);
 
     umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_create(TEST_STRING_HANDLE_2_PAIR)).SetReturn(tokens);
-    STRICT_EXPECTED_CALL(STRING_new())
-        .SetReturn(key);
-    STRICT_EXPECTED_CALL(STRING_new())
-        .SetReturn(value);
+    STRICT_EXPECTED_CALL(STRING_c_str(TEST_STRING_HANDLE_2_PAIR));
+    STRICT_EXPECTED_CALL(STRING_length(TEST_STRING_HANDLE_2_PAIR));
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_STRING_2_PAIR) + 1));
     STRICT_EXPECTED_CALL(Map_Create(NULL)).SetReturn(map);
 
     // 1st kvp
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, key, "="));
-    STRICT_EXPECTED_CALL(STRING_copy_n(key, TEST_STRING_2_PAIR, 4));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, value, ";"));
-    STRICT_EXPECTED_CALL(STRING_copy_n(value, (TEST_STRING_2_PAIR + 5), 6));
-    STRICT_EXPECTED_CALL(STRING_c_str(key));
-    STRICT_EXPECTED_CALL(STRING_c_str(value));
     STRICT_EXPECTED_CALL(Map_Add(map, "key1", "value1"));
     STRICT_EXPECTED_CALL(gballoc_malloc(5));
     STRICT_EXPECTED_CALL(gballoc_malloc(7));
 
     // 2st kvp
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, key, "="));
-    STRICT_EXPECTED_CALL(STRING_copy_n(key, (TEST_STRING_2_PAIR + 12), 4));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, value, ";"));
-    STRICT_EXPECTED_CALL(STRING_copy_n(value, (TEST_STRING_2_PAIR + 17), 6));
-    STRICT_EXPECTED_CALL(STRING_c_str(key));
-    STRICT_EXPECTED_CALL(STRING_c_str(value));
     STRICT_EXPECTED_CALL(Map_Add(map, "key2", "value2"));
     STRICT_EXPECTED_CALL(gballoc_malloc(5));
     STRICT_EXPECTED_CALL(gballoc_malloc(7));
 
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, key, "="));
-    STRICT_EXPECTED_CALL(STRING_delete(value));
-    STRICT_EXPECTED_CALL(STRING_delete(key));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_destroy(tokens));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = connectionstringparser_parse(TEST_STRING_HANDLE_2_PAIR);
@@ -569,63 +412,32 @@ TEST_FUNCTION(connectionstringparser_parse_with_2_key_value_pairs_adds_them_to_t
 
     // cleanup
     Map_Destroy(result);
-
 }
 
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_001: [connectionstringparser_parse shall parse all key value pairs from the connection_string passed in as argument and return a new map that holds the key/value pairs.]  */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_003: [connectionstringparser_parse shall create a STRING tokenizer to be used for parsing the connection string, by calling STRING_TOKENIZER_create.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_004: [connectionstringparser_parse shall start scanning at the beginning of the connection string.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_016: [2 STRINGs shall be allocated in order to hold the to be parsed key and value tokens.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_005: [The following actions shall be repeated until parsing is complete:] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_006: [connectionstringparser_parse shall find a token (the key of the key/value pair) delimited by the "=" character, by calling STRING_TOKENIZER_get_next_token.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_007: [If STRING_TOKENIZER_get_next_token fails, parsing shall be considered complete.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_014: [After the parsing is complete the previously allocated STRINGs and STRING tokenizer shall be freed by calling STRING_TOKENIZER_destroy.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_008: [connectionstringparser_parse shall find a token (the value of the key/value pair) delimited by the ";" character, by calling STRING_TOKENIZER_get_next_token.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_010: [The key and value shall be added to the result map by using Map_Add.] */
-/* Tests_SRS_CONNECTIONSTRINGPARSER_01_011: [The C strings for the key and value shall be extracted from the previously parsed STRINGs by using STRING_c_str.] */
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_007: [If the remainder of the connection string is empty, parsing shall be considered complete.] */
 TEST_FUNCTION(connectionstringparser_parse_with_2_key_value_pairs_ended_with_semicolon_adds_them_to_the_result_map)
 {
     // arrange
     MAP_HANDLE result;
-    STRING_HANDLE key = STRING_new();
-    STRING_HANDLE value = STRING_new();
     MAP_HANDLE map = Map_Create(NULL);
-    STRING_TOKENIZER_HANDLE tokens = STRING_TOKENIZER_create(TEST_STRING_HANDLE_2_PAIR_SEMICOLON);
 
     umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_create(TEST_STRING_HANDLE_2_PAIR_SEMICOLON)).SetReturn(tokens);
-    STRICT_EXPECTED_CALL(STRING_new())
-        .SetReturn(key);
-    STRICT_EXPECTED_CALL(STRING_new())
-        .SetReturn(value);
+    STRICT_EXPECTED_CALL(STRING_c_str(TEST_STRING_HANDLE_2_PAIR_SEMICOLON));
+    STRICT_EXPECTED_CALL(STRING_length(TEST_STRING_HANDLE_2_PAIR_SEMICOLON));
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_STRING_2_PAIR_SEMICOLON) + 1));
     STRICT_EXPECTED_CALL(Map_Create(NULL)).SetReturn(map);
 
     // 1st kvp
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, key, "="));
-    STRICT_EXPECTED_CALL(STRING_copy_n(key, TEST_STRING_2_PAIR_SEMICOLON, 4));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, value, ";"));
-    STRICT_EXPECTED_CALL(STRING_copy_n(value, (TEST_STRING_2_PAIR_SEMICOLON + 5), 6));
-    STRICT_EXPECTED_CALL(STRING_c_str(key));
-    STRICT_EXPECTED_CALL(STRING_c_str(value));
     STRICT_EXPECTED_CALL(Map_Add(map, "key1", "value1"));
     STRICT_EXPECTED_CALL(gballoc_malloc(5));
     STRICT_EXPECTED_CALL(gballoc_malloc(7));
 
     // 2st kvp
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, key, "="));
-    STRICT_EXPECTED_CALL(STRING_copy_n(key, (TEST_STRING_2_PAIR_SEMICOLON + 12), 4));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, value, ";"));
-    STRICT_EXPECTED_CALL(STRING_copy_n(value, (TEST_STRING_2_PAIR_SEMICOLON + 17), 6));
-    STRICT_EXPECTED_CALL(STRING_c_str(key));
-    STRICT_EXPECTED_CALL(STRING_c_str(value));
     STRICT_EXPECTED_CALL(Map_Add(map, "key2", "value2"));
     STRICT_EXPECTED_CALL(gballoc_malloc(5));
     STRICT_EXPECTED_CALL(gballoc_malloc(7));
 
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(tokens, key, "="));
-    STRICT_EXPECTED_CALL(STRING_delete(value));
-    STRICT_EXPECTED_CALL(STRING_delete(key));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_destroy(tokens));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = connectionstringparser_parse(TEST_STRING_HANDLE_2_PAIR_SEMICOLON);
@@ -640,53 +452,28 @@ TEST_FUNCTION(connectionstringparser_parse_with_2_key_value_pairs_ended_with_sem
     Map_Destroy(result);
 }
 
-/* Tests_SRS_CONNECTIONSTRINGPARSER_21_020: [connectionstringparser_parse_from_char shall create a STRING_HANDLE from the connection_string passed in as argument and parse it using the connectionstringparser_parse.]*/
+/* Tests_SRS_CONNECTIONSTRINGPARSER_21_020: [connectionstringparser_parse_from_char shall parse the connection_string passed in as argument in the same way as connectionstringparser_parse, without creating a STRING_HANDLE.]*/
 TEST_FUNCTION(connectionstringparser_parse_from_char_with_2_key_value_pairs_ended_with_semicolon_adds_them_to_the_result_map)
 {
     // arrange
     MAP_HANDLE result;
-    STRING_HANDLE key = STRING_new();
-    STRING_HANDLE value = STRING_new();
     MAP_HANDLE map = Map_Create(NULL);
-    STRING_TOKENIZER_HANDLE tokens = STRING_TOKENIZER_create(TEST_STRING_HANDLE_2_PAIR_SEMICOLON);
-    STRING_HANDLE test_string_val = STRING_construct(TEST_STRING_2_PAIR_SEMICOLON);
 
     umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(STRING_construct(TEST_STRING_2_PAIR_SEMICOLON)).SetReturn(test_string_val);
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_create(IGNORED_PTR_ARG)).SetReturn(tokens);
-    STRICT_EXPECTED_CALL(STRING_new())
-        .SetReturn(key);
-    STRICT_EXPECTED_CALL(STRING_new())
-        .SetReturn(value);
+    STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_STRING_2_PAIR_SEMICOLON) + 1));
     STRICT_EXPECTED_CALL(Map_Create(NULL)).SetReturn(map);
 
     // 1st kvp
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(IGNORED_PTR_ARG, IGNORED_PTR_ARG, "="));
-    STRICT_EXPECTED_CALL(STRING_copy_n(IGNORED_PTR_ARG, TEST_STRING_2_PAIR_SEMICOLON, 4));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(IGNORED_PTR_ARG, IGNORED_PTR_ARG, ";"));
-    STRICT_EXPECTED_CALL(STRING_copy_n(IGNORED_PTR_ARG, (TEST_STRING_2_PAIR_SEMICOLON + 5), 6));
-    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(Map_Add(IGNORED_PTR_ARG, "key1", "value1"));
     STRICT_EXPECTED_CALL(gballoc_malloc(5));
     STRICT_EXPECTED_CALL(gballoc_malloc(7));
 
     // 2st kvp
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(IGNORED_PTR_ARG, IGNORED_PTR_ARG, "="));
-    STRICT_EXPECTED_CALL(STRING_copy_n(IGNORED_PTR_ARG, (TEST_STRING_2_PAIR_SEMICOLON + 12), 4));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(IGNORED_PTR_ARG, IGNORED_PTR_ARG, ";"));
-    STRICT_EXPECTED_CALL(STRING_copy_n(IGNORED_PTR_ARG, (TEST_STRING_2_PAIR_SEMICOLON + 17), 6));
-    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(Map_Add(IGNORED_PTR_ARG, "key2", "value2"));
     STRICT_EXPECTED_CALL(gballoc_malloc(5));
     STRICT_EXPECTED_CALL(gballoc_malloc(7));
 
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_get_next_token(IGNORED_PTR_ARG, IGNORED_PTR_ARG, "="));
-    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_TOKENIZER_destroy(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = connectionstringparser_parse_from_char(TEST_STRING_2_PAIR_SEMICOLON);
@@ -701,7 +488,7 @@ TEST_FUNCTION(connectionstringparser_parse_from_char_with_2_key_value_pairs_ende
     Map_Destroy(result);
 }
 
-/* Tests_SRS_CONNECTIONSTRINGPARSER_21_021: [If connectionstringparser_parse_from_char get error creating a STRING_HANDLE, it shall return NULL.]*/
+/* Tests_SRS_CONNECTIONSTRINGPARSER_21_021: [If connection_string is NULL then connectionstringparser_parse_from_char shall fail and return NULL.]*/
 TEST_FUNCTION(connectionstringparser_parse_from_char_with_NULL_connection_string_fails)
 {
     // arrange
@@ -1020,4 +807,296 @@ TEST_FUNCTION(connectionstringparser_splitHostName_with_NULL_hostName_failed)
 }
 
 
+/* connectionstringparser_acquire */
+
+static void setup_parse_instance_expectations(void)
+{
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(2 * (strlen(TEST_DEVICE_CONNECTION_STRING) + 1)));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+}
+
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_029: [If connection_string is NULL, connectionstringparser_acquire shall fail and return NULL.] */
+TEST_FUNCTION(connectionstringparser_acquire_with_NULL_connection_string_fails)
+{
+    // arrange
+    const CONNECTION_STRING* result;
+
+    umock_c_reset_all_calls();
+
+    // act
+    result = connectionstringparser_acquire(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(result);
+}
+
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_025: [connectionstringparser_acquire shall parse the connection string the same way as connectionstringparser_parse_from_char, in a single copy of it that the fields of the result point into.] */
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_026: [connectionstringparser_acquire shall store the values of HostName, DeviceId, ModuleId, SharedAccessKeyName, SharedAccessKey, SharedAccessSignature and GatewayHostName in the corresponding fields of the result, which are NULL for the keys that are absent.] */
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_030: [If the cache is not initialized, connectionstringparser_acquire shall return a parsed connection string that is not shared.] */
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_037: [connectionstringparser_get_value shall return the value of key in parsed, or NULL if parsed has no such key.] */
+TEST_FUNCTION(connectionstringparser_acquire_without_cache_parses_the_well_known_fields)
+{
+    // arrange
+    const CONNECTION_STRING* result;
+    const CONNECTION_STRING* other;
+
+    umock_c_reset_all_calls();
+    setup_parse_instance_expectations();
+
+    // act
+    result = connectionstringparser_acquire(TEST_DEVICE_CONNECTION_STRING);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, "some.azure-devices.net", result->host_name);
+    ASSERT_ARE_EQUAL(char_ptr, "device1", result->device_id);
+    ASSERT_ARE_EQUAL(char_ptr, "abc==", result->shared_access_key);
+    ASSERT_IS_NULL(result->module_id);
+    ASSERT_IS_NULL(result->shared_access_key_name);
+    ASSERT_IS_NULL(result->shared_access_signature);
+    ASSERT_IS_NULL(result->gateway_host_name);
+    ASSERT_ARE_EQUAL(char_ptr, "value1", connectionstringparser_get_value(result, "Custom"));
+    ASSERT_ARE_EQUAL(char_ptr, "device1", connectionstringparser_get_value(result, "DeviceId"));
+    ASSERT_IS_NULL(connectionstringparser_get_value(result, "ModuleId"));
+
+    other = connectionstringparser_acquire(TEST_DEVICE_CONNECTION_STRING);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, (void*)result, (void*)other);
+
+    // cleanup
+    connectionstringparser_release(other);
+    connectionstringparser_release(result);
+}
+
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_027: [If a key occurs more than once, connectionstringparser_acquire shall fail and return NULL.] */
+TEST_FUNCTION(connectionstringparser_acquire_with_a_duplicate_key_fails)
+{
+    // arrange
+    const CONNECTION_STRING* result;
+
+    umock_c_reset_all_calls();
+
+    // act
+    result = connectionstringparser_acquire("DeviceId=device1;DeviceId=device2");
+
+    // assert
+    ASSERT_IS_NULL(result);
+}
+
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_028: [If any failure occurs, connectionstringparser_acquire shall fail and return NULL.] */
+TEST_FUNCTION(connectionstringparser_acquire_with_an_invalid_connection_string_fails)
+{
+    // arrange
+    const CONNECTION_STRING* result;
+
+    umock_c_reset_all_calls();
+
+    // act
+    result = connectionstringparser_acquire(TEST_STRING_PAIR_AND_KEY);
+
+    // assert
+    ASSERT_IS_NULL(result);
+}
+
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_028: [If any failure occurs, connectionstringparser_acquire shall fail and return NULL.] */
+TEST_FUNCTION(when_an_allocation_fails_connectionstringparser_acquire_fails)
+{
+    // arrange
+    size_t i;
+
+    ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
+
+    umock_c_reset_all_calls();
+    setup_parse_instance_expectations();
+    umock_c_negative_tests_snapshot();
+
+    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        // arrange
+        char error_msg[64];
+        const CONNECTION_STRING* result;
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(i);
+
+        // act
+        result = connectionstringparser_acquire(TEST_DEVICE_CONNECTION_STRING);
+
+        // assert
+        sprintf(error_msg, "On failed call %lu", (unsigned long)i);
+        ASSERT_IS_NULL(result, error_msg);
+    }
+
+    // cleanup
+    umock_c_negative_tests_deinit();
+}
+
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_021: [connectionstringparser_cache_init shall create the lock guarding the process wide cache and return 0.] */
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_022: [If the cache is already initialized, connectionstringparser_cache_init shall fail and return a non-zero value.] */
+TEST_FUNCTION(connectionstringparser_cache_init_twice_fails)
+{
+    // arrange
+    int result;
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(Lock_Init());
+
+    // act
+    ASSERT_ARE_EQUAL(int, 0, connectionstringparser_cache_init());
+    result = connectionstringparser_cache_init();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    connectionstringparser_cache_deinit();
+}
+
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_023: [If Lock_Init fails, connectionstringparser_cache_init shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_Lock_Init_fails_connectionstringparser_cache_init_fails)
+{
+    // arrange
+    int result;
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(Lock_Init()).SetReturn(NULL);
+
+    // act
+    result = connectionstringparser_cache_init();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_031: [The cache shall be keyed by a hash of the connection string, and entries with the same hash shall be compared with the full connection string.] */
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_032: [If the same connection string is in the cache, connectionstringparser_acquire shall increment its reference count and return it without parsing the connection string.] */
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_033: [Otherwise connectionstringparser_acquire shall parse the connection string and add the result to the cache.] */
+TEST_FUNCTION(connectionstringparser_acquire_with_cache_shares_the_result)
+{
+    // arrange
+    const CONNECTION_STRING* first;
+    const CONNECTION_STRING* second;
+    char copy[128];
+
+    (void)strcpy(copy, TEST_DEVICE_CONNECTION_STRING);
+    ASSERT_ARE_EQUAL(int, 0, connectionstringparser_cache_init());
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    setup_parse_instance_expectations();
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    first = connectionstringparser_acquire(TEST_DEVICE_CONNECTION_STRING);
+    second = connectionstringparser_acquire(copy);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(first);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)first, (void*)second);
+    ASSERT_ARE_EQUAL(char_ptr, "device1", second->device_id);
+
+    // cleanup
+    connectionstringparser_release(second);
+    connectionstringparser_release(first);
+    connectionstringparser_cache_deinit();
+}
+
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_035: [connectionstringparser_release shall decrement the reference count of parsed and free it, removing it from the cache, when it reaches 0.] */
+TEST_FUNCTION(connectionstringparser_release_frees_the_result_on_the_last_release)
+{
+    // arrange
+    const CONNECTION_STRING* first;
+    const CONNECTION_STRING* second;
+
+    ASSERT_ARE_EQUAL(int, 0, connectionstringparser_cache_init());
+    first = connectionstringparser_acquire(TEST_DEVICE_CONNECTION_STRING);
+    second = connectionstringparser_acquire(TEST_DEVICE_CONNECTION_STRING);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    setup_parse_instance_expectations();
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    connectionstringparser_release(second);
+    connectionstringparser_release(first);
+    first = connectionstringparser_acquire(TEST_DEVICE_CONNECTION_STRING);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(first);
+
+    // cleanup
+    connectionstringparser_release(first);
+    connectionstringparser_cache_deinit();
+}
+
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_024: [connectionstringparser_cache_deinit shall remove all the parsed connection strings from the cache and free the cache lock; they shall be freed by their last connectionstringparser_release.] */
+TEST_FUNCTION(connectionstringparser_cache_deinit_leaves_acquired_results_valid)
+{
+    // arrange
+    const CONNECTION_STRING* parsed;
+
+    ASSERT_ARE_EQUAL(int, 0, connectionstringparser_cache_init());
+    parsed = connectionstringparser_acquire(TEST_DEVICE_CONNECTION_STRING);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    connectionstringparser_cache_deinit();
+    ASSERT_ARE_EQUAL(char_ptr, "device1", parsed->device_id);
+    connectionstringparser_release(parsed);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_034: [If parsed is NULL, connectionstringparser_release shall return.] */
+TEST_FUNCTION(connectionstringparser_release_with_NULL_returns)
+{
+    // arrange
+    umock_c_reset_all_calls();
+
+    // act
+    connectionstringparser_release(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CONNECTIONSTRINGPARSER_01_036: [If parsed or key is NULL, connectionstringparser_get_value shall return NULL.] */
+TEST_FUNCTION(connectionstringparser_get_value_with_NULL_arguments_returns_NULL)
+{
+    // arrange
+    const CONNECTION_STRING* parsed = connectionstringparser_acquire(TEST_DEVICE_CONNECTION_STRING);
+    umock_c_reset_all_calls();
+
+    // act
+    // assert
+    ASSERT_IS_NULL(connectionstringparser_get_value(NULL, "DeviceId"));
+    ASSERT_IS_NULL(connectionstringparser_get_value(parsed, NULL));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    connectionstringparser_release(parsed);
+}
+
 END_TEST_SUITE(connectionstringparser_ut)
@@ -162,6 +162,8 @@ TEST_FUNCTION(constbuffer_array_create_succeeds)
     test_buffers[1] = TEST_CONSTBUFFER_HANDLE_2;
 
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_1));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_2));
     STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_1));
     STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_2));
 
@@ -229,6 +231,8 @@ TEST_FUNCTION(when_underlying_calls_fail_constbuffer_array_create_fails)
     test_buffers[1] = TEST_CONSTBUFFER_HANDLE_2;
 
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_1));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_2));
     STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_1));
     STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_2));
 
@@ -329,10 +333,12 @@ static CONSTBUFFER_ARRAY_HANDLE TEST_constbuffer_array_add_front(CONSTBUFFER_ARR
     uint32_t i;
     CONSTBUFFER_ARRAY_HANDLE result;
 
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(constbuffer_handle));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(constbuffer_handle));
     for (i = 0; i < nExistingBuffers; i++)
     {
-        STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(constbuffer_handle));
+        STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(IGNORED_PTR_ARG));
     }
 
     result = constbuffer_array_add_front(constbuffer_array, constbuffer_handle);
@@ -341,17 +347,27 @@ static CONSTBUFFER_ARRAY_HANDLE TEST_constbuffer_array_add_front(CONSTBUFFER_ARR
     return result;
 }
 
+/*adds constbuffer_handle in front of constbuffer_array as if its content was content*/
+static CONSTBUFFER_ARRAY_HANDLE TEST_constbuffer_array_add_front_with_content(CONSTBUFFER_ARRAY_HANDLE constbuffer_array, CONSTBUFFER_HANDLE constbuffer_handle, const CONSTBUFFER* content)
+{
+    CONSTBUFFER_ARRAY_HANDLE result;
+
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(constbuffer_handle))
+        .SetReturn(content);
+
+    result = constbuffer_array_add_front(constbuffer_array, constbuffer_handle);
+    ASSERT_IS_NOT_NULL(result);
+    umock_c_reset_all_calls();
+    return result;
+}
+
 static CONSTBUFFER_ARRAY_HANDLE TEST_constbuffer_array_remove_front(CONSTBUFFER_ARRAY_HANDLE constbuffer_array, uint32_t nExistingBuffers, CONSTBUFFER_HANDLE* constbuffer_handle)
 {
-    uint32_t i;
     CONSTBUFFER_ARRAY_HANDLE result;
 
     ASSERT_IS_TRUE(nExistingBuffers > 0);
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    for (i = 0; i < nExistingBuffers-1; i++)
-    {
-        STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(IGNORED_PTR_ARG));
-    }
+    STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(IGNORED_PTR_ARG));
 
     result = constbuffer_array_remove_front(constbuffer_array, constbuffer_handle);
     ASSERT_IS_NOT_NULL(result);
@@ -889,11 +905,12 @@ TEST_FUNCTION(constbuffer_array_add_front_with_constbuffer_handle_NULL_fails)
 
 static void constbuffer_array_add_front_inert_path(void)
 {
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_1));
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_1));
 }
 
-/*Tests_SRS_CONSTBUFFER_ARRAY_02_042: [ constbuffer_array_add_front shall allocate enough memory to hold all of constbuffer_array_handle existing CONSTBUFFER_HANDLE and constbuffer_handle. ]*/
+/*Tests_SRS_CONSTBUFFER_ARRAY_02_042: [ Otherwise constbuffer_array_add_front shall allocate a new storage with room for all of constbuffer_array_handle existing CONSTBUFFER_HANDLE, constbuffer_handle and as many free slots at each end as there are CONSTBUFFER_HANDLE, but at least 4. ]*/
 /*Tests_SRS_CONSTBUFFER_ARRAY_02_043: [ constbuffer_array_add_front shall copy constbuffer_handle and all of constbuffer_array_handle existing CONSTBUFFER_HANDLE. ]*/
 /*Tests_SRS_CONSTBUFFER_ARRAY_02_044: [ constbuffer_array_add_front shall inc_ref all the CONSTBUFFER_HANDLE it had copied. ]*/
 /*Tests_SRS_CONSTBUFFER_ARRAY_02_010: [ constbuffer_array_add_front shall succeed and return a non-NULL value. ]*/
@@ -1023,24 +1040,14 @@ TEST_FUNCTION(constbuffer_array_remove_front_with_constbuffer_array_handle_empty
     constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
 }
 
-static void constbuffer_array_remove_front_inert_path(uint32_t nExistingItems)
+static void constbuffer_array_remove_front_inert_path(CONSTBUFFER_HANDLE front)
 {
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     // clone front buffer
-    STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(IGNORED_PTR_ARG));
-    if (nExistingItems > 0)
-    {
-        uint32_t i;
-        for (i = 0; i < nExistingItems-1; i++)
-        {
-            STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(IGNORED_PTR_ARG));
-        }
-    }
+    STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(front));
 }
 
-/*Tests_SRS_CONSTBUFFER_ARRAY_02_046: [ constbuffer_array_remove_front shall allocate memory to hold all of constbuffer_array_handle CONSTBUFFER_HANDLEs except the front one. ]*/
-/*Tests_SRS_CONSTBUFFER_ARRAY_02_047: [ constbuffer_array_remove_front shall copy all of constbuffer_array_handle CONSTBUFFER_HANDLEs except the front one. ]*/
-/*Tests_SRS_CONSTBUFFER_ARRAY_02_048: [ constbuffer_array_remove_front shall inc_ref all the copied CONSTBUFFER_HANDLEs. ]*/
+/*Tests_SRS_CONSTBUFFER_ARRAY_02_046: [ constbuffer_array_remove_front shall allocate a new CONSTBUFFER_ARRAY_HANDLE sharing the storage of constbuffer_array_handle and holding all of its CONSTBUFFER_HANDLEs except the front one. ]*/
 /*Tests_SRS_CONSTBUFFER_ARRAY_01_001: [ constbuffer_array_remove_front shall inc_ref the removed buffer. ]*/
 /*Tests_SRS_CONSTBUFFER_ARRAY_02_049: [ constbuffer_array_remove_front shall succeed, write in constbuffer_handle the front handle and return a non-NULL value. ]*/
 TEST_FUNCTION(constbuffer_array_remove_front_with_1_item_succeeds)
@@ -1053,7 +1060,7 @@ TEST_FUNCTION(constbuffer_array_remove_front_with_1_item_succeeds)
 
     umock_c_reset_all_calls();
 
-    constbuffer_array_remove_front_inert_path(1);
+    constbuffer_array_remove_front_inert_path(TEST_CONSTBUFFER_HANDLE_1);
 
     ///act
     afterRemove = constbuffer_array_remove_front(afterAdd, &removed);
@@ -1071,9 +1078,7 @@ TEST_FUNCTION(constbuffer_array_remove_front_with_1_item_succeeds)
     constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
 }
 
-/*Tests_SRS_CONSTBUFFER_ARRAY_02_046: [ constbuffer_array_remove_front shall allocate memory to hold all of constbuffer_array_handle CONSTBUFFER_HANDLEs except the front one. ]*/
-/*Tests_SRS_CONSTBUFFER_ARRAY_02_047: [ constbuffer_array_remove_front shall copy all of constbuffer_array_handle CONSTBUFFER_HANDLEs except the front one. ]*/
-/*Tests_SRS_CONSTBUFFER_ARRAY_02_048: [ constbuffer_array_remove_front shall inc_ref all the copied CONSTBUFFER_HANDLEs. ]*/
+/*Tests_SRS_CONSTBUFFER_ARRAY_02_046: [ constbuffer_array_remove_front shall allocate a new CONSTBUFFER_ARRAY_HANDLE sharing the storage of constbuffer_array_handle and holding all of its CONSTBUFFER_HANDLEs except the front one. ]*/
 /*Tests_SRS_CONSTBUFFER_ARRAY_01_001: [ constbuffer_array_remove_front shall inc_ref the removed buffer. ]*/
 /*Tests_SRS_CONSTBUFFER_ARRAY_02_049: [ constbuffer_array_remove_front shall succeed, write in constbuffer_handle the front handle and return a non-NULL value. ]*/
 TEST_FUNCTION(constbuffer_array_remove_front_with_2_items_succeeds)
@@ -1086,7 +1091,7 @@ TEST_FUNCTION(constbuffer_array_remove_front_with_2_items_succeeds)
     CONSTBUFFER_ARRAY_HANDLE afterRemove1;
     umock_c_reset_all_calls();
 
-    constbuffer_array_remove_front_inert_path(2);
+    constbuffer_array_remove_front_inert_path(TEST_CONSTBUFFER_HANDLE_2);
 
     ///act
     afterRemove1 = constbuffer_array_remove_front(afterAdd2, &removed);
@@ -1114,7 +1119,7 @@ TEST_FUNCTION(constbuffer_array_remove_front_unhappy_paths)
     size_t i;
     umock_c_reset_all_calls();
 
-    constbuffer_array_remove_front_inert_path(1);
+    constbuffer_array_remove_front_inert_path(TEST_CONSTBUFFER_HANDLE_1);
 
     umock_c_negative_tests_snapshot();
     for (i = 0; i < umock_c_negative_tests_call_count(); i++)
@@ -1140,205 +1145,644 @@ TEST_FUNCTION(constbuffer_array_remove_front_unhappy_paths)
     constbuffer_array_dec_ref(afterAdd);
 }
 
-/* constbuffer_array_get_buffer_count */
-
-/* Tests_SRS_CONSTBUFFER_ARRAY_01_002: [ On success, constbuffer_array_get_buffer_count shall return 0 and write the buffer count in buffer_count. ]*/
-TEST_FUNCTION(constbuffer_array_get_buffer_count_returns_0_for_an_empty_array)
+static void validate_constbuffer_array(CONSTBUFFER_ARRAY_HANDLE constbuffer_array, const CONSTBUFFER_HANDLE* expected_buffers, uint32_t expected_count)
 {
-    // arrange
-    CONSTBUFFER_ARRAY_HANDLE constbuffer_array = TEST_constbuffer_array_create_empty();
-    uint32_t buffer_count;
-
-    // act
-    int result = constbuffer_array_get_buffer_count(constbuffer_array, &buffer_count);
+    uint32_t count;
+    uint32_t i;
 
-    // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(uint32_t, 0, buffer_count);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, constbuffer_array_get_buffer_count(constbuffer_array, &count));
+    ASSERT_ARE_EQUAL(uint32_t, expected_count, count);
 
-    // cleanup
-    constbuffer_array_dec_ref(constbuffer_array);
+    for (i = 0; i < expected_count; i++)
+    {
+        CONSTBUFFER_HANDLE temp = constbuffer_array_get_buffer(constbuffer_array, i);
+        ASSERT_ARE_EQUAL(void_ptr, expected_buffers[i], temp, "Validate result[%" PRIu32 "]", i);
+        CONSTBUFFER_DecRef(temp);
+    }
 }
 
-/* Tests_SRS_CONSTBUFFER_ARRAY_01_002: [ On success, constbuffer_array_get_buffer_count shall return 0 and write the buffer count in buffer_count. ]*/
-TEST_FUNCTION(constbuffer_array_get_buffer_count_after_add_on_empty_array_yields_1)
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_026: [ If constbuffer_array_handle starts at the first used slot of its storage and there is a free slot in front of it, constbuffer_array_add_front shall allocate a new CONSTBUFFER_ARRAY_HANDLE sharing the storage. ]*/
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_027: [ constbuffer_array_add_front shall claim the free slot atomically, so that only one of the arrays adding in front of the same buffers uses it. ]*/
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_028: [ constbuffer_array_add_front shall inc_ref constbuffer_handle and store it in the claimed slot. ]*/
+TEST_FUNCTION(constbuffer_array_add_front_with_room_in_front_shares_the_storage)
 {
-    // arrange
-    CONSTBUFFER_ARRAY_HANDLE constbuffer_array = TEST_constbuffer_array_create_empty();
-    CONSTBUFFER_ARRAY_HANDLE afterAdd1 = TEST_constbuffer_array_add_front(constbuffer_array, 0, TEST_CONSTBUFFER_HANDLE_1);
-    uint32_t buffer_count;
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create_empty();
+    CONSTBUFFER_ARRAY_HANDLE afterAdd1 = TEST_constbuffer_array_add_front(TEST_CONSTBUFFER_ARRAY_HANDLE, 0, TEST_CONSTBUFFER_HANDLE_1);
+    CONSTBUFFER_HANDLE expected[2];
+    CONSTBUFFER_ARRAY_HANDLE result;
 
-    // act
-    int result = constbuffer_array_get_buffer_count(afterAdd1, &buffer_count);
+    expected[0] = TEST_CONSTBUFFER_HANDLE_2;
+    expected[1] = TEST_CONSTBUFFER_HANDLE_1;
 
-    // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(uint32_t, 1, buffer_count);
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_2));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_2));
+
+    ///act
+    result = constbuffer_array_add_front(afterAdd1, TEST_CONSTBUFFER_HANDLE_2);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    validate_constbuffer_array(result, expected, 2);
+    validate_constbuffer_array(afterAdd1, &expected[1], 1);
 
-    // cleanup
+    ///clean
+    constbuffer_array_dec_ref(result);
     constbuffer_array_dec_ref(afterAdd1);
-    constbuffer_array_dec_ref(constbuffer_array);
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
 }
 
-/* Tests_SRS_CONSTBUFFER_ARRAY_01_002: [ On success, constbuffer_array_get_buffer_count shall return 0 and write the buffer count in buffer_count. ]*/
-TEST_FUNCTION(constbuffer_array_get_buffer_count_on_a_1_buffer_array_yields_1)
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_027: [ constbuffer_array_add_front shall claim the free slot atomically, so that only one of the arrays adding in front of the same buffers uses it. ]*/
+/*Tests_SRS_CONSTBUFFER_ARRAY_02_042: [ Otherwise constbuffer_array_add_front shall allocate a new storage with room for all of constbuffer_array_handle existing CONSTBUFFER_HANDLE, constbuffer_handle and as many free slots at each end as there are CONSTBUFFER_HANDLE, but at least 4. ]*/
+/*Tests_SRS_CONSTBUFFER_ARRAY_02_043: [ constbuffer_array_add_front shall copy constbuffer_handle and all of constbuffer_array_handle existing CONSTBUFFER_HANDLE. ]*/
+/*Tests_SRS_CONSTBUFFER_ARRAY_02_044: [ constbuffer_array_add_front shall inc_ref all the CONSTBUFFER_HANDLE it had copied. ]*/
+TEST_FUNCTION(constbuffer_array_add_front_when_the_slot_in_front_is_taken_copies)
 {
-    // arrange
-    CONSTBUFFER_HANDLE test_buffers[1];
-    CONSTBUFFER_ARRAY_HANDLE constbuffer_array;
-    uint32_t buffer_count;
-    int result;
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create_empty();
+    CONSTBUFFER_ARRAY_HANDLE afterAdd1 = TEST_constbuffer_array_add_front(TEST_CONSTBUFFER_ARRAY_HANDLE, 0, TEST_CONSTBUFFER_HANDLE_1);
+    CONSTBUFFER_ARRAY_HANDLE afterAdd2 = constbuffer_array_add_front(afterAdd1, TEST_CONSTBUFFER_HANDLE_2);
+    CONSTBUFFER_HANDLE expected[3];
+    CONSTBUFFER_ARRAY_HANDLE result;
+    umock_c_reset_all_calls();
 
-    test_buffers[0] = TEST_CONSTBUFFER_HANDLE_1;
+    expected[0] = TEST_CONSTBUFFER_HANDLE_3;
+    expected[1] = TEST_CONSTBUFFER_HANDLE_1;
+    expected[2] = TEST_CONSTBUFFER_HANDLE_2;
 
-    constbuffer_array = constbuffer_array_create(test_buffers, sizeof(test_buffers) / sizeof(test_buffers[0]));
-    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_3));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_3));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_1));
 
-    // act
-    result = constbuffer_array_get_buffer_count(constbuffer_array, &buffer_count);
+    ///act
+    result = constbuffer_array_add_front(afterAdd1, TEST_CONSTBUFFER_HANDLE_3);
 
-    // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(uint32_t, 1, buffer_count);
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    validate_constbuffer_array(result, expected, 2);
+    expected[0] = TEST_CONSTBUFFER_HANDLE_2;
+    validate_constbuffer_array(afterAdd2, expected, 2);
 
-    // cleanup
-    constbuffer_array_dec_ref(constbuffer_array);
+    ///clean
+    constbuffer_array_dec_ref(result);
+    constbuffer_array_dec_ref(afterAdd2);
+    constbuffer_array_dec_ref(afterAdd1);
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
 }
 
-/* Tests_SRS_CONSTBUFFER_ARRAY_01_002: [ On success, constbuffer_array_get_buffer_count shall return 0 and write the buffer count in buffer_count. ]*/
-TEST_FUNCTION(constbuffer_array_get_buffer_count_on_a_2_buffer_array_yields_2)
+/*Tests_SRS_CONSTBUFFER_ARRAY_02_011: [ If there any failures constbuffer_array_add_front shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_array_fails_constbuffer_array_add_front_with_room_in_front_fails)
 {
-    // arrange
-    CONSTBUFFER_HANDLE test_buffers[2];
-    CONSTBUFFER_ARRAY_HANDLE constbuffer_array;
-    uint32_t buffer_count;
-    int result;
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create_empty();
+    CONSTBUFFER_ARRAY_HANDLE afterAdd1 = TEST_constbuffer_array_add_front(TEST_CONSTBUFFER_ARRAY_HANDLE, 0, TEST_CONSTBUFFER_HANDLE_1);
+    CONSTBUFFER_ARRAY_HANDLE result;
+    CONSTBUFFER_ARRAY_HANDLE afterAdd2;
 
-    test_buffers[0] = TEST_CONSTBUFFER_HANDLE_1;
-    test_buffers[1] = TEST_CONSTBUFFER_HANDLE_2;
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_2));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
 
-    constbuffer_array = constbuffer_array_create(test_buffers, sizeof(test_buffers) / sizeof(test_buffers[0]));
-    umock_c_reset_all_calls();
+    ///act
+    result = constbuffer_array_add_front(afterAdd1, TEST_CONSTBUFFER_HANDLE_2);
 
-    // act
-    result = constbuffer_array_get_buffer_count(constbuffer_array, &buffer_count);
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-    // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(uint32_t, 2, buffer_count);
+    /*the slot in front is still free*/
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_2));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_2));
+    afterAdd2 = constbuffer_array_add_front(afterAdd1, TEST_CONSTBUFFER_HANDLE_2);
+    ASSERT_IS_NOT_NULL(afterAdd2);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-    // cleanup
-    constbuffer_array_dec_ref(constbuffer_array);
+    ///clean
+    constbuffer_array_dec_ref(afterAdd2);
+    constbuffer_array_dec_ref(afterAdd1);
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
 }
 
-/* Tests_SRS_CONSTBUFFER_ARRAY_01_003: [ If constbuffer_array_handle is NULL, constbuffer_array_get_buffer_count shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(constbuffer_array_get_buffer_count_with_NULL_constbuffer_array_handle_fails)
+/*constbuffer_array_add_back*/
+
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_029: [ If constbuffer_array_handle is NULL then constbuffer_array_add_back shall fail and return NULL ]*/
+TEST_FUNCTION(constbuffer_array_add_back_with_constbuffer_array_handle_NULL_fails)
 {
-    // arrange
-    uint32_t buffer_count;
+    ///arrange
 
-    // act
-    int result = constbuffer_array_get_buffer_count(NULL, &buffer_count);
+    ///act
+    CONSTBUFFER_ARRAY_HANDLE result = constbuffer_array_add_back(NULL, TEST_CONSTBUFFER_HANDLE_1);
 
-    // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ///assert
+    ASSERT_IS_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_CONSTBUFFER_ARRAY_01_004: [ If buffer_count is NULL, constbuffer_array_get_buffer_count shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(constbuffer_array_get_buffer_count_with_NULL_buffer_count_fails)
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_030: [ If constbuffer_handle is NULL then constbuffer_array_add_back shall fail and return NULL ]*/
+TEST_FUNCTION(constbuffer_array_add_back_with_constbuffer_handle_NULL_fails)
 {
-    // arrange
-    CONSTBUFFER_ARRAY_HANDLE constbuffer_array = TEST_constbuffer_array_create_empty();
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create_empty();
 
-    // act
-    int result = constbuffer_array_get_buffer_count(constbuffer_array, NULL);
+    ///act
+    CONSTBUFFER_ARRAY_HANDLE result = constbuffer_array_add_back(TEST_CONSTBUFFER_ARRAY_HANDLE, NULL);
 
-    // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ///assert
+    ASSERT_IS_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-    // cleanup
-    constbuffer_array_dec_ref(constbuffer_array);
+    ///clean
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
 }
 
-/* constbuffer_array_get_buffer */
-
-/* Tests_SRS_CONSTBUFFER_ARRAY_01_005: [ On success, constbuffer_array_get_buffer shall return a non-NULL handle to the buffer_index-th const buffer in the array. ]*/
-/* Tests_SRS_CONSTBUFFER_ARRAY_01_006: [ The returned handle shall have its reference count incremented. ]*/
-TEST_FUNCTION(constbuffer_array_get_buffer_succeeds)
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_034: [ Otherwise constbuffer_array_add_back shall allocate a new storage with room for all of constbuffer_array_handle existing CONSTBUFFER_HANDLE, constbuffer_handle and as many free slots at each end as there are CONSTBUFFER_HANDLE, but at least 4, and copy and inc_ref all of them. ]*/
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_035: [ constbuffer_array_add_back shall succeed and return a non-NULL value. ]*/
+TEST_FUNCTION(constbuffer_array_add_back_without_room_copies)
 {
-    // arrange
-    CONSTBUFFER_HANDLE test_buffers[2];
-    CONSTBUFFER_ARRAY_HANDLE constbuffer_array;
-    CONSTBUFFER_HANDLE result;
-
-    test_buffers[0] = TEST_CONSTBUFFER_HANDLE_1;
-    test_buffers[1] = TEST_CONSTBUFFER_HANDLE_2;
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create(2, 0);
+    CONSTBUFFER_HANDLE expected[3];
+    CONSTBUFFER_ARRAY_HANDLE result;
 
-    constbuffer_array = constbuffer_array_create(test_buffers, sizeof(test_buffers) / sizeof(test_buffers[0]));
-    umock_c_reset_all_calls();
+    expected[0] = TEST_CONSTBUFFER_HANDLE_1;
+    expected[1] = TEST_CONSTBUFFER_HANDLE_2;
+    expected[2] = TEST_CONSTBUFFER_HANDLE_3;
 
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_3));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_3));
     STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_1));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_2));
 
-    // act
-    result = constbuffer_array_get_buffer(constbuffer_array, 0);
+    ///act
+    result = constbuffer_array_add_back(TEST_CONSTBUFFER_ARRAY_HANDLE, TEST_CONSTBUFFER_HANDLE_3);
 
-    // assert
-    ASSERT_ARE_EQUAL(void_ptr, TEST_CONSTBUFFER_HANDLE_1, result);
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    validate_constbuffer_array(result, expected, 3);
 
-    // cleanup
-    constbuffer_array_dec_ref(constbuffer_array);
-    CONSTBUFFER_DecRef(result);
+    ///clean
+    constbuffer_array_dec_ref(result);
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
 }
 
-/* Tests_SRS_CONSTBUFFER_ARRAY_01_005: [ On success, constbuffer_array_get_buffer shall return a non-NULL handle to the buffer_index-th const buffer in the array. ]*/
-/* Tests_SRS_CONSTBUFFER_ARRAY_01_006: [ The returned handle shall have its reference count incremented. ]*/
-TEST_FUNCTION(constbuffer_array_get_buffer_for_2nd_buffer_succeeds)
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_031: [ If constbuffer_array_handle ends at the last used slot of its storage and there is a free slot after it, constbuffer_array_add_back shall allocate a new CONSTBUFFER_ARRAY_HANDLE sharing the storage. ]*/
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_032: [ constbuffer_array_add_back shall claim the free slot atomically, so that only one of the arrays adding after the same buffers uses it. ]*/
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_033: [ constbuffer_array_add_back shall inc_ref constbuffer_handle and store it in the claimed slot. ]*/
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_035: [ constbuffer_array_add_back shall succeed and return a non-NULL value. ]*/
+TEST_FUNCTION(constbuffer_array_add_back_with_room_at_the_back_shares_the_storage)
 {
-    // arrange
-    CONSTBUFFER_HANDLE test_buffers[2];
-    CONSTBUFFER_ARRAY_HANDLE constbuffer_array;
-    CONSTBUFFER_HANDLE result;
-
-    test_buffers[0] = TEST_CONSTBUFFER_HANDLE_1;
-    test_buffers[1] = TEST_CONSTBUFFER_HANDLE_2;
-
-    constbuffer_array = constbuffer_array_create(test_buffers, sizeof(test_buffers) / sizeof(test_buffers[0]));
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create_empty();
+    CONSTBUFFER_ARRAY_HANDLE afterAdd1 = constbuffer_array_add_back(TEST_CONSTBUFFER_ARRAY_HANDLE, TEST_CONSTBUFFER_HANDLE_1);
+    CONSTBUFFER_HANDLE expected[2];
+    CONSTBUFFER_ARRAY_HANDLE result;
     umock_c_reset_all_calls();
 
+    expected[0] = TEST_CONSTBUFFER_HANDLE_1;
+    expected[1] = TEST_CONSTBUFFER_HANDLE_2;
+
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_2));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_2));
 
-    // act
-    result = constbuffer_array_get_buffer(constbuffer_array, 1);
+    ///act
+    result = constbuffer_array_add_back(afterAdd1, TEST_CONSTBUFFER_HANDLE_2);
 
-    // assert
-    ASSERT_ARE_EQUAL(void_ptr, TEST_CONSTBUFFER_HANDLE_2, result);
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    validate_constbuffer_array(result, expected, 2);
+    validate_constbuffer_array(afterAdd1, expected, 1);
 
-    // cleanup
-    constbuffer_array_dec_ref(constbuffer_array);
-    CONSTBUFFER_DecRef(result);
+    ///clean
+    constbuffer_array_dec_ref(result);
+    constbuffer_array_dec_ref(afterAdd1);
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
 }
 
-/* Tests_SRS_CONSTBUFFER_ARRAY_01_007: [ If constbuffer_array_handle is NULL, constbuffer_array_get_buffer shall fail and return NULL. ]*/
-TEST_FUNCTION(constbuffer_array_get_buffer_with_NULL_constbuffer_array_handle_fails)
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_032: [ constbuffer_array_add_back shall claim the free slot atomically, so that only one of the arrays adding after the same buffers uses it. ]*/
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_034: [ Otherwise constbuffer_array_add_back shall allocate a new storage with room for all of constbuffer_array_handle existing CONSTBUFFER_HANDLE, constbuffer_handle and as many free slots at each end as there are CONSTBUFFER_HANDLE, but at least 4, and copy and inc_ref all of them. ]*/
+TEST_FUNCTION(constbuffer_array_add_back_when_the_slot_at_the_back_is_taken_copies)
 {
-    // arrange
-    CONSTBUFFER_HANDLE result;
-
-    // act
-    result = constbuffer_array_get_buffer(NULL, 0);
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create_empty();
+    CONSTBUFFER_ARRAY_HANDLE afterAdd1 = constbuffer_array_add_back(TEST_CONSTBUFFER_ARRAY_HANDLE, TEST_CONSTBUFFER_HANDLE_1);
+    CONSTBUFFER_ARRAY_HANDLE afterAdd2 = constbuffer_array_add_back(afterAdd1, TEST_CONSTBUFFER_HANDLE_2);
+    CONSTBUFFER_HANDLE expected[2];
+    CONSTBUFFER_ARRAY_HANDLE result;
+    umock_c_reset_all_calls();
 
-    // assert
-    ASSERT_IS_NULL(result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-}
+    expected[0] = TEST_CONSTBUFFER_HANDLE_1;
+    expected[1] = TEST_CONSTBUFFER_HANDLE_3;
+
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_3));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_3));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_1));
+
+    ///act
+    result = constbuffer_array_add_back(afterAdd1, TEST_CONSTBUFFER_HANDLE_3);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    validate_constbuffer_array(result, expected, 2);
+    expected[1] = TEST_CONSTBUFFER_HANDLE_2;
+    validate_constbuffer_array(afterAdd2, expected, 2);
+
+    ///clean
+    constbuffer_array_dec_ref(result);
+    constbuffer_array_dec_ref(afterAdd2);
+    constbuffer_array_dec_ref(afterAdd1);
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
+}
+
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_036: [ If there any failures constbuffer_array_add_back shall fail and return NULL. ]*/
+TEST_FUNCTION(constbuffer_array_add_back_unhappy_paths)
+{
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create_empty();
+    size_t i;
+
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_1));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_1));
+
+    umock_c_negative_tests_snapshot();
+    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        if (umock_c_negative_tests_can_call_fail(i))
+        {
+            CONSTBUFFER_ARRAY_HANDLE result;
+
+            umock_c_negative_tests_reset();
+            umock_c_negative_tests_fail_call(i);
+
+            ///act
+            result = constbuffer_array_add_back(TEST_CONSTBUFFER_ARRAY_HANDLE, TEST_CONSTBUFFER_HANDLE_1);
+
+            ///assert
+            ASSERT_IS_NULL(result);
+        }
+    }
+
+    ///clean
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
+}
+
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_031: [ If constbuffer_array_handle ends at the last used slot of its storage and there is a free slot after it, constbuffer_array_add_back shall allocate a new CONSTBUFFER_ARRAY_HANDLE sharing the storage. ]*/
+TEST_FUNCTION(constbuffer_array_add_back_after_remove_back_copies)
+{
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create_empty();
+    CONSTBUFFER_ARRAY_HANDLE afterAdd1 = constbuffer_array_add_back(TEST_CONSTBUFFER_ARRAY_HANDLE, TEST_CONSTBUFFER_HANDLE_1);
+    CONSTBUFFER_HANDLE removed;
+    CONSTBUFFER_ARRAY_HANDLE afterRemove = constbuffer_array_remove_back(afterAdd1, &removed);
+    CONSTBUFFER_ARRAY_HANDLE result;
+    CONSTBUFFER_DecRef(removed);
+    umock_c_reset_all_calls();
+
+    /*the slot after afterRemove still holds TEST_CONSTBUFFER_HANDLE_1*/
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_2));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_2));
+
+    ///act
+    result = constbuffer_array_add_back(afterRemove, TEST_CONSTBUFFER_HANDLE_2);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    validate_constbuffer_array(result, &TEST_CONSTBUFFER_HANDLE_2, 1);
+    validate_constbuffer_array(afterAdd1, &TEST_CONSTBUFFER_HANDLE_1, 1);
+
+    ///clean
+    constbuffer_array_dec_ref(result);
+    constbuffer_array_dec_ref(afterRemove);
+    constbuffer_array_dec_ref(afterAdd1);
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
+}
+
+/*constbuffer_array_remove_back*/
+
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_037: [ If constbuffer_array_handle is NULL then constbuffer_array_remove_back shall fail and return NULL. ]*/
+TEST_FUNCTION(constbuffer_array_remove_back_with_constbuffer_array_handle_NULL_fails)
+{
+    ///arrange
+    CONSTBUFFER_HANDLE constbuffer_handle;
+
+    ///act
+    CONSTBUFFER_ARRAY_HANDLE result = constbuffer_array_remove_back(NULL, &constbuffer_handle);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_038: [ If constbuffer_handle is NULL then constbuffer_array_remove_back shall fail and return NULL. ]*/
+TEST_FUNCTION(constbuffer_array_remove_back_with_constbuffer_handle_NULL_fails)
+{
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create(1, 0);
+
+    ///act
+    CONSTBUFFER_ARRAY_HANDLE result = constbuffer_array_remove_back(TEST_CONSTBUFFER_ARRAY_HANDLE, NULL);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///clean
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
+}
+
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_039: [ If there is no back CONSTBUFFER_HANDLE then constbuffer_array_remove_back shall fail and return NULL. ]*/
+TEST_FUNCTION(constbuffer_array_remove_back_with_constbuffer_array_handle_empty_fails)
+{
+    ///arrange
+    CONSTBUFFER_HANDLE constbuffer_handle;
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create_empty();
+
+    ///act
+    CONSTBUFFER_ARRAY_HANDLE result = constbuffer_array_remove_back(TEST_CONSTBUFFER_ARRAY_HANDLE, &constbuffer_handle);
+
+    ///assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
+}
+
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_040: [ constbuffer_array_remove_back shall allocate a new CONSTBUFFER_ARRAY_HANDLE sharing the storage of constbuffer_array_handle and holding all of its CONSTBUFFER_HANDLEs except the back one. ]*/
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_041: [ constbuffer_array_remove_back shall inc_ref the removed buffer. ]*/
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_042: [ constbuffer_array_remove_back shall succeed, write in constbuffer_handle the back handle and return a non-NULL value. ]*/
+TEST_FUNCTION(constbuffer_array_remove_back_with_3_items_succeeds)
+{
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create(3, 0);
+    CONSTBUFFER_HANDLE removed = NULL;
+    CONSTBUFFER_ARRAY_HANDLE afterRemove;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_3));
+
+    ///act
+    afterRemove = constbuffer_array_remove_back(TEST_CONSTBUFFER_ARRAY_HANDLE, &removed);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(afterRemove);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_CONSTBUFFER_HANDLE_3, removed);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    validate_sorted_constbuffer_array(afterRemove, 2);
+    validate_sorted_constbuffer_array(TEST_CONSTBUFFER_ARRAY_HANDLE, 3);
+
+    ///cleanup
+    constbuffer_array_dec_ref(afterRemove);
+    CONSTBUFFER_DecRef(removed);
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
+}
+
+/*Tests_SRS_CONSTBUFFER_ARRAY_01_043: [ If there are any failures then constbuffer_array_remove_back shall fail and return NULL. ]*/
+TEST_FUNCTION(constbuffer_array_remove_back_unhappy_paths)
+{
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create(2, 0);
+    size_t i;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_2));
+
+    umock_c_negative_tests_snapshot();
+    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        if (umock_c_negative_tests_can_call_fail(i))
+        {
+            CONSTBUFFER_HANDLE removed;
+            CONSTBUFFER_ARRAY_HANDLE afterRemove;
+
+            umock_c_negative_tests_reset();
+            umock_c_negative_tests_fail_call(i);
+
+            ///act
+            afterRemove = constbuffer_array_remove_back(TEST_CONSTBUFFER_ARRAY_HANDLE, &removed);
+
+            ///assert
+            ASSERT_IS_NULL(afterRemove);
+        }
+    }
+
+    ///clean
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
+}
+
+/* constbuffer_array_get_buffer_count */
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_002: [ On success, constbuffer_array_get_buffer_count shall return 0 and write the buffer count in buffer_count. ]*/
+TEST_FUNCTION(constbuffer_array_get_buffer_count_returns_0_for_an_empty_array)
+{
+    // arrange
+    CONSTBUFFER_ARRAY_HANDLE constbuffer_array = TEST_constbuffer_array_create_empty();
+    uint32_t buffer_count;
+
+    // act
+    int result = constbuffer_array_get_buffer_count(constbuffer_array, &buffer_count);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint32_t, 0, buffer_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    constbuffer_array_dec_ref(constbuffer_array);
+}
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_002: [ On success, constbuffer_array_get_buffer_count shall return 0 and write the buffer count in buffer_count. ]*/
+TEST_FUNCTION(constbuffer_array_get_buffer_count_after_add_on_empty_array_yields_1)
+{
+    // arrange
+    CONSTBUFFER_ARRAY_HANDLE constbuffer_array = TEST_constbuffer_array_create_empty();
+    CONSTBUFFER_ARRAY_HANDLE afterAdd1 = TEST_constbuffer_array_add_front(constbuffer_array, 0, TEST_CONSTBUFFER_HANDLE_1);
+    uint32_t buffer_count;
+
+    // act
+    int result = constbuffer_array_get_buffer_count(afterAdd1, &buffer_count);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint32_t, 1, buffer_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    constbuffer_array_dec_ref(afterAdd1);
+    constbuffer_array_dec_ref(constbuffer_array);
+}
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_002: [ On success, constbuffer_array_get_buffer_count shall return 0 and write the buffer count in buffer_count. ]*/
+TEST_FUNCTION(constbuffer_array_get_buffer_count_on_a_1_buffer_array_yields_1)
+{
+    // arrange
+    CONSTBUFFER_HANDLE test_buffers[1];
+    CONSTBUFFER_ARRAY_HANDLE constbuffer_array;
+    uint32_t buffer_count;
+    int result;
+
+    test_buffers[0] = TEST_CONSTBUFFER_HANDLE_1;
+
+    constbuffer_array = constbuffer_array_create(test_buffers, sizeof(test_buffers) / sizeof(test_buffers[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = constbuffer_array_get_buffer_count(constbuffer_array, &buffer_count);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint32_t, 1, buffer_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    constbuffer_array_dec_ref(constbuffer_array);
+}
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_002: [ On success, constbuffer_array_get_buffer_count shall return 0 and write the buffer count in buffer_count. ]*/
+TEST_FUNCTION(constbuffer_array_get_buffer_count_on_a_2_buffer_array_yields_2)
+{
+    // arrange
+    CONSTBUFFER_HANDLE test_buffers[2];
+    CONSTBUFFER_ARRAY_HANDLE constbuffer_array;
+    uint32_t buffer_count;
+    int result;
+
+    test_buffers[0] = TEST_CONSTBUFFER_HANDLE_1;
+    test_buffers[1] = TEST_CONSTBUFFER_HANDLE_2;
+
+    constbuffer_array = constbuffer_array_create(test_buffers, sizeof(test_buffers) / sizeof(test_buffers[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = constbuffer_array_get_buffer_count(constbuffer_array, &buffer_count);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint32_t, 2, buffer_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    constbuffer_array_dec_ref(constbuffer_array);
+}
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_003: [ If constbuffer_array_handle is NULL, constbuffer_array_get_buffer_count shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(constbuffer_array_get_buffer_count_with_NULL_constbuffer_array_handle_fails)
+{
+    // arrange
+    uint32_t buffer_count;
+
+    // act
+    int result = constbuffer_array_get_buffer_count(NULL, &buffer_count);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_004: [ If buffer_count is NULL, constbuffer_array_get_buffer_count shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(constbuffer_array_get_buffer_count_with_NULL_buffer_count_fails)
+{
+    // arrange
+    CONSTBUFFER_ARRAY_HANDLE constbuffer_array = TEST_constbuffer_array_create_empty();
+
+    // act
+    int result = constbuffer_array_get_buffer_count(constbuffer_array, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    constbuffer_array_dec_ref(constbuffer_array);
+}
+
+/* constbuffer_array_get_buffer */
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_005: [ On success, constbuffer_array_get_buffer shall return a non-NULL handle to the buffer_index-th const buffer in the array. ]*/
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_006: [ The returned handle shall have its reference count incremented. ]*/
+TEST_FUNCTION(constbuffer_array_get_buffer_succeeds)
+{
+    // arrange
+    CONSTBUFFER_HANDLE test_buffers[2];
+    CONSTBUFFER_ARRAY_HANDLE constbuffer_array;
+    CONSTBUFFER_HANDLE result;
+
+    test_buffers[0] = TEST_CONSTBUFFER_HANDLE_1;
+    test_buffers[1] = TEST_CONSTBUFFER_HANDLE_2;
+
+    constbuffer_array = constbuffer_array_create(test_buffers, sizeof(test_buffers) / sizeof(test_buffers[0]));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_1));
+
+    // act
+    result = constbuffer_array_get_buffer(constbuffer_array, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_CONSTBUFFER_HANDLE_1, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    constbuffer_array_dec_ref(constbuffer_array);
+    CONSTBUFFER_DecRef(result);
+}
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_005: [ On success, constbuffer_array_get_buffer shall return a non-NULL handle to the buffer_index-th const buffer in the array. ]*/
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_006: [ The returned handle shall have its reference count incremented. ]*/
+TEST_FUNCTION(constbuffer_array_get_buffer_for_2nd_buffer_succeeds)
+{
+    // arrange
+    CONSTBUFFER_HANDLE test_buffers[2];
+    CONSTBUFFER_ARRAY_HANDLE constbuffer_array;
+    CONSTBUFFER_HANDLE result;
+
+    test_buffers[0] = TEST_CONSTBUFFER_HANDLE_1;
+    test_buffers[1] = TEST_CONSTBUFFER_HANDLE_2;
+
+    constbuffer_array = constbuffer_array_create(test_buffers, sizeof(test_buffers) / sizeof(test_buffers[0]));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_CONSTBUFFER_HANDLE_2));
+
+    // act
+    result = constbuffer_array_get_buffer(constbuffer_array, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_CONSTBUFFER_HANDLE_2, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    constbuffer_array_dec_ref(constbuffer_array);
+    CONSTBUFFER_DecRef(result);
+}
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_007: [ If constbuffer_array_handle is NULL, constbuffer_array_get_buffer shall fail and return NULL. ]*/
+TEST_FUNCTION(constbuffer_array_get_buffer_with_NULL_constbuffer_array_handle_fails)
+{
+    // arrange
+    CONSTBUFFER_HANDLE result;
+
+    // act
+    result = constbuffer_array_get_buffer(NULL, 0);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
 
 /* Tests_SRS_CONSTBUFFER_ARRAY_01_008: [ If buffer_index is greater or equal to the number of buffers in the array, constbuffer_array_get_buffer shall fail and return NULL. ]*/
 TEST_FUNCTION(constbuffer_array_get_buffer_with_index_equal_to_number_of_buffers_fails)
@@ -1600,17 +2044,40 @@ TEST_FUNCTION(constbuffer_array_dec_ref_does_not_free_when_references_are_still_
 
 /* Tests_SRS_CONSTBUFFER_ARRAY_01_016: [ Otherwise constbuffer_array_dec_ref shall decrement the reference count for constbuffer_array_handle. ]*/
 /* Tests_SRS_CONSTBUFFER_ARRAY_02_038: [ If the reference count reaches 0, constbuffer_array_dec_ref shall free all used resources. ]*/
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_044: [ When the last CONSTBUFFER_ARRAY_HANDLE using a storage is freed, constbuffer_array_dec_ref shall dec_ref all the CONSTBUFFER_HANDLEs in the storage and free it. ]*/
 TEST_FUNCTION(constbuffer_array_dec_ref_frees)
 {
     ///arrange
     CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create_empty();
     CONSTBUFFER_ARRAY_HANDLE afterAdd1 = TEST_constbuffer_array_add_front(TEST_CONSTBUFFER_ARRAY_HANDLE, 0, TEST_CONSTBUFFER_HANDLE_1);
-    CONSTBUFFER_ARRAY_HANDLE afterAdd2 = TEST_constbuffer_array_add_front(afterAdd1, 1, TEST_CONSTBUFFER_HANDLE_2);
+    CONSTBUFFER_ARRAY_HANDLE afterAdd2 = constbuffer_array_add_front(afterAdd1, TEST_CONSTBUFFER_HANDLE_2);
+    constbuffer_array_dec_ref(afterAdd2);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(CONSTBUFFER_DecRef(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(CONSTBUFFER_DecRef(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_DecRef(TEST_CONSTBUFFER_HANDLE_2));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_DecRef(TEST_CONSTBUFFER_HANDLE_1));
+    STRICT_EXPECTED_CALL(gballoc_free(afterAdd1));
+
+    ///act
+    constbuffer_array_dec_ref(afterAdd1);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
+}
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_02_038: [ If the reference count reaches 0, constbuffer_array_dec_ref shall free all used resources. ]*/
+TEST_FUNCTION(constbuffer_array_dec_ref_of_an_array_sharing_the_storage_frees_only_the_array)
+{
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create_empty();
+    CONSTBUFFER_ARRAY_HANDLE afterAdd1 = TEST_constbuffer_array_add_front(TEST_CONSTBUFFER_ARRAY_HANDLE, 0, TEST_CONSTBUFFER_HANDLE_1);
+    CONSTBUFFER_ARRAY_HANDLE afterAdd2 = constbuffer_array_add_front(afterAdd1, TEST_CONSTBUFFER_HANDLE_2);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(afterAdd2));
 
     ///act
     constbuffer_array_dec_ref(afterAdd2);
@@ -1623,6 +2090,29 @@ TEST_FUNCTION(constbuffer_array_dec_ref_frees)
     constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
 }
 
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_044: [ When the last CONSTBUFFER_ARRAY_HANDLE using a storage is freed, constbuffer_array_dec_ref shall dec_ref all the CONSTBUFFER_HANDLEs in the storage and free it. ]*/
+TEST_FUNCTION(constbuffer_array_dec_ref_of_the_last_array_sharing_the_storage_frees_the_storage)
+{
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create(2, 0);
+    CONSTBUFFER_HANDLE removed;
+    CONSTBUFFER_ARRAY_HANDLE afterRemove = constbuffer_array_remove_front(TEST_CONSTBUFFER_ARRAY_HANDLE, &removed);
+    CONSTBUFFER_DecRef(removed);
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(afterRemove));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_DecRef(TEST_CONSTBUFFER_HANDLE_1));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_DecRef(TEST_CONSTBUFFER_HANDLE_2));
+    STRICT_EXPECTED_CALL(gballoc_free(TEST_CONSTBUFFER_ARRAY_HANDLE));
+
+    ///act
+    constbuffer_array_dec_ref(afterRemove);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 /* constbuffer_array_get_all_buffers_size */
 
 /* Tests_SRS_CONSTBUFFER_ARRAY_01_019: [ If constbuffer_array_handle is NULL, constbuffer_array_get_all_buffers_size shall fail and return a non-zero value. ]*/
@@ -1662,18 +2152,13 @@ TEST_FUNCTION(constbuffer_array_get_all_buffers_size_with_NULL_all_buffers_size_
 TEST_FUNCTION(constbuffer_array_get_all_buffers_size_when_overflow_happens_fails)
 {
     ///arrange
+    const CONSTBUFFER fake_const_buffer_1 = { (const unsigned char*)0x4242, UINT32_MAX };
+    const CONSTBUFFER fake_const_buffer_2 = { (const unsigned char*)0x4242, 1 };
     CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create_empty();
-    CONSTBUFFER_ARRAY_HANDLE afterAdd1 = TEST_constbuffer_array_add_front(TEST_CONSTBUFFER_ARRAY_HANDLE, 0, TEST_CONSTBUFFER_HANDLE_1);
-    CONSTBUFFER_ARRAY_HANDLE afterAdd2 = TEST_constbuffer_array_add_front(afterAdd1, 1, TEST_CONSTBUFFER_HANDLE_2);
+    CONSTBUFFER_ARRAY_HANDLE afterAdd1 = TEST_constbuffer_array_add_front_with_content(TEST_CONSTBUFFER_ARRAY_HANDLE, TEST_CONSTBUFFER_HANDLE_1, &fake_const_buffer_1);
+    CONSTBUFFER_ARRAY_HANDLE afterAdd2 = TEST_constbuffer_array_add_front_with_content(afterAdd1, TEST_CONSTBUFFER_HANDLE_2, &fake_const_buffer_2);
     uint32_t all_buffers_size;
     int result;
-    const CONSTBUFFER fake_const_buffer_1 = { (const unsigned char*)0x4242, UINT32_MAX };
-    const CONSTBUFFER fake_const_buffer_2 = { (const unsigned char*)0x4242, 1 };
-
-    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_2))
-        .SetReturn(&fake_const_buffer_2);
-    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_1))
-        .SetReturn(&fake_const_buffer_1);
 
     ///act
     result = constbuffer_array_get_all_buffers_size(afterAdd2, &all_buffers_size);
@@ -1692,18 +2177,13 @@ TEST_FUNCTION(constbuffer_array_get_all_buffers_size_when_overflow_happens_fails
 TEST_FUNCTION(constbuffer_array_get_all_buffers_size_max_all_size_succeeds)
 {
     ///arrange
+    const CONSTBUFFER fake_const_buffer_1 = { (const unsigned char*)0x4242, UINT32_MAX - 1 };
+    const CONSTBUFFER fake_const_buffer_2 = { (const unsigned char*)0x4242, 1 };
     CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create_empty();
-    CONSTBUFFER_ARRAY_HANDLE afterAdd1 = TEST_constbuffer_array_add_front(TEST_CONSTBUFFER_ARRAY_HANDLE, 0, TEST_CONSTBUFFER_HANDLE_1);
-    CONSTBUFFER_ARRAY_HANDLE afterAdd2 = TEST_constbuffer_array_add_front(afterAdd1, 1, TEST_CONSTBUFFER_HANDLE_2);
+    CONSTBUFFER_ARRAY_HANDLE afterAdd1 = TEST_constbuffer_array_add_front_with_content(TEST_CONSTBUFFER_ARRAY_HANDLE, TEST_CONSTBUFFER_HANDLE_1, &fake_const_buffer_1);
+    CONSTBUFFER_ARRAY_HANDLE afterAdd2 = TEST_constbuffer_array_add_front_with_content(afterAdd1, TEST_CONSTBUFFER_HANDLE_2, &fake_const_buffer_2);
     uint32_t all_buffers_size;
     int result;
-    const CONSTBUFFER fake_const_buffer_1 = { (const unsigned char*)0x4242, UINT32_MAX - 1 };
-    const CONSTBUFFER fake_const_buffer_2 = { (const unsigned char*)0x4242, 1 };
-
-    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_2))
-        .SetReturn(&fake_const_buffer_2);
-    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_1))
-        .SetReturn(&fake_const_buffer_1);
 
     ///act
     result = constbuffer_array_get_all_buffers_size(afterAdd2, &all_buffers_size);
@@ -1724,14 +2204,11 @@ TEST_FUNCTION(constbuffer_array_get_all_buffers_size_max_all_size_succeeds)
 TEST_FUNCTION(constbuffer_array_get_all_buffers_size_when_buffer_size_bigger_than_UINT32_MAX_fails)
 {
     ///arrange
+    const CONSTBUFFER fake_const_buffer_1 = { (const unsigned char*)0x4242, (size_t)UINT32_MAX + 1 };
     CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create_empty();
-    CONSTBUFFER_ARRAY_HANDLE afterAdd1 = TEST_constbuffer_array_add_front(TEST_CONSTBUFFER_ARRAY_HANDLE, 0, TEST_CONSTBUFFER_HANDLE_1);
+    CONSTBUFFER_ARRAY_HANDLE afterAdd1 = TEST_constbuffer_array_add_front_with_content(TEST_CONSTBUFFER_ARRAY_HANDLE, TEST_CONSTBUFFER_HANDLE_1, &fake_const_buffer_1);
     uint32_t all_buffers_size;
     int result;
-    const CONSTBUFFER fake_const_buffer_1 = { (const unsigned char*)0x4242, (size_t)UINT32_MAX + 1 };
-
-    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_1))
-        .SetReturn(&fake_const_buffer_1);
 
     ///act
     result = constbuffer_array_get_all_buffers_size(afterAdd1, &all_buffers_size);
@@ -1775,8 +2252,6 @@ TEST_FUNCTION(constbuffer_array_get_all_buffers_size_with_1_buffer_succeeds)
     uint32_t all_buffers_size;
     int result;
 
-    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_1));
-
     ///act
     result = constbuffer_array_get_all_buffers_size(afterAdd1, &all_buffers_size);
 
@@ -1791,6 +2266,7 @@ TEST_FUNCTION(constbuffer_array_get_all_buffers_size_with_1_buffer_succeeds)
 }
 
 /* Tests_SRS_CONSTBUFFER_ARRAY_01_022: [ Otherwise constbuffer_array_get_all_buffers_size shall write in all_buffers_size the total size of all buffers in the array and return 0. ]*/
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_049: [ constbuffer_array_get_all_buffers_size shall compute the size from the sizes stored when the buffers were added, without calling CONSTBUFFER_GetContent. ]*/
 TEST_FUNCTION(constbuffer_array_get_all_buffers_size_with_2_buffers_succeeds)
 {
     ///arrange
@@ -1800,9 +2276,6 @@ TEST_FUNCTION(constbuffer_array_get_all_buffers_size_with_2_buffers_succeeds)
     uint32_t all_buffers_size;
     int result;
 
-    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_2));
-    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_1));
-
     ///act
     result = constbuffer_array_get_all_buffers_size(afterAdd2, &all_buffers_size);
 
@@ -1817,4 +2290,265 @@ TEST_FUNCTION(constbuffer_array_get_all_buffers_size_with_2_buffers_succeeds)
     constbuffer_array_dec_ref(afterAdd2);
 }
 
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_045: [ constbuffer_array_create shall get the content of each buffer by calling CONSTBUFFER_GetContent and store the sum of the sizes of the buffers before each buffer. ]*/
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_049: [ constbuffer_array_get_all_buffers_size shall compute the size from the sizes stored when the buffers were added, without calling CONSTBUFFER_GetContent. ]*/
+TEST_FUNCTION(constbuffer_array_get_all_buffers_size_after_create_succeeds)
+{
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create(3, 0);
+    uint32_t all_buffers_size;
+    int result;
+
+    ///act
+    result = constbuffer_array_get_all_buffers_size(TEST_CONSTBUFFER_ARRAY_HANDLE, &all_buffers_size);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint32_t, 6, all_buffers_size);
+
+    // cleanup
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
+}
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_014: [ If any error occurs, constbuffer_array_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_getting_the_content_of_a_buffer_fails_constbuffer_array_create_fails)
+{
+    ///arrange
+    CONSTBUFFER_HANDLE test_buffers[2];
+    CONSTBUFFER_ARRAY_HANDLE constbuffer_array;
+
+    test_buffers[0] = TEST_CONSTBUFFER_HANDLE_1;
+    test_buffers[1] = TEST_CONSTBUFFER_HANDLE_2;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_1));
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_CONSTBUFFER_HANDLE_2))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    ///act
+    constbuffer_array = constbuffer_array_create(test_buffers, sizeof(test_buffers) / sizeof(test_buffers[0]));
+
+    ///assert
+    ASSERT_IS_NULL(constbuffer_array);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_046: [ constbuffer_array_create_from_array_array shall take the sizes of the buffers from the arrays in buffer_arrays. ]*/
+TEST_FUNCTION(constbuffer_array_get_all_buffers_size_after_create_from_array_array_succeeds)
+{
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE buffer_arrays[2];
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE;
+    uint32_t all_buffers_size;
+    int result;
+
+    buffer_arrays[0] = TEST_constbuffer_array_create(2, 0);
+    buffer_arrays[1] = TEST_constbuffer_array_create(1, 3);
+    TEST_CONSTBUFFER_ARRAY_HANDLE = constbuffer_array_create_from_array_array(buffer_arrays, 2);
+    ASSERT_IS_NOT_NULL(TEST_CONSTBUFFER_ARRAY_HANDLE);
+    umock_c_reset_all_calls();
+
+    ///act
+    result = constbuffer_array_get_all_buffers_size(TEST_CONSTBUFFER_ARRAY_HANDLE, &all_buffers_size);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint32_t, 1 + 2 + 4, all_buffers_size);
+
+    // cleanup
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
+    constbuffer_array_dec_ref(buffer_arrays[1]);
+    constbuffer_array_dec_ref(buffer_arrays[0]);
+}
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_049: [ constbuffer_array_get_all_buffers_size shall compute the size from the sizes stored when the buffers were added, without calling CONSTBUFFER_GetContent. ]*/
+TEST_FUNCTION(constbuffer_array_get_all_buffers_size_of_views_sharing_the_storage_succeeds)
+{
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create(3, 0);
+    CONSTBUFFER_HANDLE removed;
+    CONSTBUFFER_ARRAY_HANDLE afterRemove = constbuffer_array_remove_front(TEST_CONSTBUFFER_ARRAY_HANDLE, &removed);
+    CONSTBUFFER_ARRAY_HANDLE afterAdd = constbuffer_array_add_back(TEST_CONSTBUFFER_ARRAY_HANDLE, TEST_CONSTBUFFER_HANDLE_6);
+    CONSTBUFFER_ARRAY_HANDLE afterAddBack = constbuffer_array_add_back(afterAdd, TEST_CONSTBUFFER_HANDLE_5);
+    uint32_t remove_size;
+    uint32_t add_size;
+    uint32_t add_back_size;
+    CONSTBUFFER_DecRef(removed);
+    umock_c_reset_all_calls();
+
+    ///act
+    ASSERT_ARE_EQUAL(int, 0, constbuffer_array_get_all_buffers_size(afterRemove, &remove_size));
+    ASSERT_ARE_EQUAL(int, 0, constbuffer_array_get_all_buffers_size(afterAdd, &add_size));
+    ASSERT_ARE_EQUAL(int, 0, constbuffer_array_get_all_buffers_size(afterAddBack, &add_back_size));
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(uint32_t, 2 + 3, remove_size);
+    ASSERT_ARE_EQUAL(uint32_t, 1 + 2 + 3 + 6, add_size);
+    ASSERT_ARE_EQUAL(uint32_t, 1 + 2 + 3 + 6 + 5, add_back_size);
+
+    // cleanup
+    constbuffer_array_dec_ref(afterAddBack);
+    constbuffer_array_dec_ref(afterAdd);
+    constbuffer_array_dec_ref(afterRemove);
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
+}
+
+/* constbuffer_array_get_buffer_index_at_offset */
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_050: [ If constbuffer_array_handle is NULL, constbuffer_array_get_buffer_index_at_offset shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(constbuffer_array_get_buffer_index_at_offset_with_NULL_constbuffer_array_handle_fails)
+{
+    ///arrange
+    uint32_t buffer_index;
+    uint32_t offset_in_buffer;
+    int result;
+
+    ///act
+    result = constbuffer_array_get_buffer_index_at_offset(NULL, 0, &buffer_index, &offset_in_buffer);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_051: [ If buffer_index or offset_in_buffer is NULL, constbuffer_array_get_buffer_index_at_offset shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(constbuffer_array_get_buffer_index_at_offset_with_NULL_buffer_index_fails)
+{
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create(2, 0);
+    uint32_t offset_in_buffer;
+    int result;
+
+    ///act
+    result = constbuffer_array_get_buffer_index_at_offset(TEST_CONSTBUFFER_ARRAY_HANDLE, 0, NULL, &offset_in_buffer);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
+}
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_051: [ If buffer_index or offset_in_buffer is NULL, constbuffer_array_get_buffer_index_at_offset shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(constbuffer_array_get_buffer_index_at_offset_with_NULL_offset_in_buffer_fails)
+{
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create(2, 0);
+    uint32_t buffer_index;
+    int result;
+
+    ///act
+    result = constbuffer_array_get_buffer_index_at_offset(TEST_CONSTBUFFER_ARRAY_HANDLE, 0, &buffer_index, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
+}
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_052: [ If offset is not less than the size of all the buffers of the array, constbuffer_array_get_buffer_index_at_offset shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(constbuffer_array_get_buffer_index_at_offset_with_offset_equal_to_the_size_fails)
+{
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create(3, 0);
+    uint32_t buffer_index;
+    uint32_t offset_in_buffer;
+    int result;
+
+    ///act
+    result = constbuffer_array_get_buffer_index_at_offset(TEST_CONSTBUFFER_ARRAY_HANDLE, 6, &buffer_index, &offset_in_buffer);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
+}
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_052: [ If offset is not less than the size of all the buffers of the array, constbuffer_array_get_buffer_index_at_offset shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(constbuffer_array_get_buffer_index_at_offset_on_an_empty_array_fails)
+{
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create_empty();
+    uint32_t buffer_index;
+    uint32_t offset_in_buffer;
+    int result;
+
+    ///act
+    result = constbuffer_array_get_buffer_index_at_offset(TEST_CONSTBUFFER_ARRAY_HANDLE, 0, &buffer_index, &offset_in_buffer);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
+}
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_053: [ Otherwise constbuffer_array_get_buffer_index_at_offset shall find with a binary search the buffer holding the byte at offset, skipping empty buffers, write its index in buffer_index and the position of the byte in it in offset_in_buffer, and return 0. ]*/
+TEST_FUNCTION(constbuffer_array_get_buffer_index_at_offset_finds_the_buffer_of_each_byte)
+{
+    ///arrange
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create(3, 0);
+    /* the buffers hold 1, 2 and 3 bytes */
+    const uint32_t expected_index[] = { 0, 1, 1, 2, 2, 2 };
+    const uint32_t expected_offset_in_buffer[] = { 0, 0, 1, 0, 1, 2 };
+    uint32_t offset;
+
+    for (offset = 0; offset < 6; offset++)
+    {
+        uint32_t buffer_index;
+        uint32_t offset_in_buffer;
+
+        ///act
+        int result = constbuffer_array_get_buffer_index_at_offset(TEST_CONSTBUFFER_ARRAY_HANDLE, offset, &buffer_index, &offset_in_buffer);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(uint32_t, expected_index[offset], buffer_index);
+        ASSERT_ARE_EQUAL(uint32_t, expected_offset_in_buffer[offset], offset_in_buffer);
+    }
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
+}
+
+/* Tests_SRS_CONSTBUFFER_ARRAY_01_053: [ Otherwise constbuffer_array_get_buffer_index_at_offset shall find with a binary search the buffer holding the byte at offset, skipping empty buffers, write its index in buffer_index and the position of the byte in it in offset_in_buffer, and return 0. ]*/
+TEST_FUNCTION(constbuffer_array_get_buffer_index_at_offset_skips_empty_buffers)
+{
+    ///arrange
+    const CONSTBUFFER empty_const_buffer = { (const unsigned char*)0x4242, 0 };
+    CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = TEST_constbuffer_array_create(1, 1);
+    CONSTBUFFER_ARRAY_HANDLE afterAdd1 = TEST_constbuffer_array_add_front_with_content(TEST_CONSTBUFFER_ARRAY_HANDLE, TEST_CONSTBUFFER_HANDLE_3, &empty_const_buffer);
+    CONSTBUFFER_ARRAY_HANDLE afterAdd2 = TEST_constbuffer_array_add_front(afterAdd1, 2, TEST_CONSTBUFFER_HANDLE_1);
+    uint32_t buffer_index;
+    uint32_t offset_in_buffer;
+    int result;
+
+    /* the buffers hold 1, 0 and 2 bytes, the first one in the free slot in front of afterAdd1 */
+
+    ///act
+    result = constbuffer_array_get_buffer_index_at_offset(afterAdd2, 1, &buffer_index, &offset_in_buffer);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(uint32_t, 2, buffer_index);
+    ASSERT_ARE_EQUAL(uint32_t, 0, offset_in_buffer);
+
+    // cleanup
+    constbuffer_array_dec_ref(afterAdd2);
+    constbuffer_array_dec_ref(afterAdd1);
+    constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE);
+}
+
 END_TEST_SUITE(constbuffer_array_unittests)
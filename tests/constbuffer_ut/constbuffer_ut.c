@@ -4,9 +4,11 @@
 #ifdef __cplusplus
 #include <cstdlib>
 #include <cstddef>
+#include <cstdint>
 #else
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdint.h>
 #endif
 
 #include "testrunnerswitcher.h"
@@ -77,6 +79,24 @@ static size_t my_BUFFER_length(BUFFER_HANDLE handle)
     return result;
 }
 
+static int my_BUFFER_detach(BUFFER_HANDLE handle, unsigned char** memory, size_t* size)
+{
+    int result;
+    if (handle == BUFFER1_HANDLE)
+    {
+        *memory = (unsigned char*)my_gballoc_malloc(BUFFER1_length);
+        (void)memcpy(*memory, BUFFER1_u_char, BUFFER1_length);
+        *size = BUFFER1_length;
+        result = 0;
+    }
+    else
+    {
+        result = __LINE__;
+        ASSERT_FAIL("who am I?");
+    }
+    return result;
+}
+
 MOCK_FUNCTION_WITH_CODE(, void, test_free_func, void*, context)
 MOCK_FUNCTION_END()
 
@@ -102,6 +122,7 @@ BEGIN_TEST_SUITE(constbuffer_unittests)
         REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
         REGISTER_GLOBAL_MOCK_HOOK(BUFFER_u_char, my_BUFFER_u_char);
         REGISTER_GLOBAL_MOCK_HOOK(BUFFER_length, my_BUFFER_length);
+        REGISTER_GLOBAL_MOCK_HOOK(BUFFER_detach, my_BUFFER_detach);
     }
 
     TEST_SUITE_CLEANUP(TestClassCleanup)
@@ -604,6 +625,180 @@ BEGIN_TEST_SUITE(constbuffer_unittests)
         free(test_buffer);
     }
 
+    /* CONSTBUFFER_CreateFromOffsetAndSize */
+
+    /* Tests_SRS_CONSTBUFFER_01_015: [ If handle is NULL then CONSTBUFFER_CreateFromOffsetAndSize shall fail and return NULL. ]*/
+    TEST_FUNCTION(CONSTBUFFER_CreateFromOffsetAndSize_with_NULL_handle_fails)
+    {
+        ///arrange
+
+        ///act
+        CONSTBUFFER_HANDLE handle = CONSTBUFFER_CreateFromOffsetAndSize(NULL, 0, 1);
+
+        ///assert
+        ASSERT_IS_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_CONSTBUFFER_01_016: [ If offset is greater than the size of the buffer of handle then CONSTBUFFER_CreateFromOffsetAndSize shall fail and return NULL. ]*/
+    TEST_FUNCTION(CONSTBUFFER_CreateFromOffsetAndSize_with_offset_past_the_end_fails)
+    {
+        ///arrange
+        CONSTBUFFER_HANDLE original = CONSTBUFFER_Create(BUFFER1_u_char, BUFFER1_length);
+        CONSTBUFFER_HANDLE handle;
+        umock_c_reset_all_calls();
+
+        ///act
+        handle = CONSTBUFFER_CreateFromOffsetAndSize(original, BUFFER1_length + 1, 0);
+
+        ///assert
+        ASSERT_IS_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        CONSTBUFFER_DecRef(original);
+    }
+
+    /* Tests_SRS_CONSTBUFFER_01_017: [ If offset + size exceeds the size of the buffer of handle then CONSTBUFFER_CreateFromOffsetAndSize shall fail and return NULL. ]*/
+    TEST_FUNCTION(CONSTBUFFER_CreateFromOffsetAndSize_with_size_past_the_end_fails)
+    {
+        ///arrange
+        CONSTBUFFER_HANDLE original = CONSTBUFFER_Create(BUFFER1_u_char, BUFFER1_length);
+        CONSTBUFFER_HANDLE handle;
+        umock_c_reset_all_calls();
+
+        ///act
+        handle = CONSTBUFFER_CreateFromOffsetAndSize(original, 1, BUFFER1_length);
+
+        ///assert
+        ASSERT_IS_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        CONSTBUFFER_DecRef(original);
+    }
+
+    /* Tests_SRS_CONSTBUFFER_01_017: [ If offset + size exceeds the size of the buffer of handle then CONSTBUFFER_CreateFromOffsetAndSize shall fail and return NULL. ]*/
+    TEST_FUNCTION(CONSTBUFFER_CreateFromOffsetAndSize_with_offset_plus_size_overflowing_fails)
+    {
+        ///arrange
+        CONSTBUFFER_HANDLE original = CONSTBUFFER_Create(BUFFER1_u_char, BUFFER1_length);
+        CONSTBUFFER_HANDLE handle;
+        umock_c_reset_all_calls();
+
+        ///act
+        handle = CONSTBUFFER_CreateFromOffsetAndSize(original, 2, SIZE_MAX);
+
+        ///assert
+        ASSERT_IS_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        CONSTBUFFER_DecRef(original);
+    }
+
+    /* Tests_SRS_CONSTBUFFER_01_018: [ CONSTBUFFER_CreateFromOffsetAndSize shall inc_ref the buffer owning the memory and keep it until the new buffer is freed. ]*/
+    /* Tests_SRS_CONSTBUFFER_01_020: [ CONSTBUFFER_CreateFromOffsetAndSize shall return a non-NULL handle whose content is the size bytes starting at offset in the buffer of handle, without copying them. ]*/
+    TEST_FUNCTION(CONSTBUFFER_CreateFromOffsetAndSize_succeeds)
+    {
+        ///arrange
+        CONSTBUFFER_HANDLE original = CONSTBUFFER_Create(BUFFER1_u_char, BUFFER1_length);
+        const CONSTBUFFER* original_content = CONSTBUFFER_GetContent(original);
+        const CONSTBUFFER* content;
+        CONSTBUFFER_HANDLE handle;
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+        ///act
+        handle = CONSTBUFFER_CreateFromOffsetAndSize(original, 3, 6);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        content = CONSTBUFFER_GetContent(handle);
+        ASSERT_ARE_EQUAL(size_t, 6, content->size);
+        ASSERT_ARE_EQUAL(void_ptr, original_content->buffer + 3, content->buffer);
+
+        ///cleanup
+        CONSTBUFFER_DecRef(original);
+        CONSTBUFFER_DecRef(handle);
+    }
+
+    /* Tests_SRS_CONSTBUFFER_01_020: [ CONSTBUFFER_CreateFromOffsetAndSize shall return a non-NULL handle whose content is the size bytes starting at offset in the buffer of handle, without copying them. ]*/
+    TEST_FUNCTION(CONSTBUFFER_CreateFromOffsetAndSize_with_0_size_at_the_end_succeeds)
+    {
+        ///arrange
+        CONSTBUFFER_HANDLE original = CONSTBUFFER_Create(BUFFER1_u_char, BUFFER1_length);
+        const CONSTBUFFER* content;
+        CONSTBUFFER_HANDLE handle;
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+        ///act
+        handle = CONSTBUFFER_CreateFromOffsetAndSize(original, BUFFER1_length, 0);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        content = CONSTBUFFER_GetContent(handle);
+        ASSERT_ARE_EQUAL(size_t, 0, content->size);
+
+        ///cleanup
+        CONSTBUFFER_DecRef(handle);
+        CONSTBUFFER_DecRef(original);
+    }
+
+    /* Tests_SRS_CONSTBUFFER_01_019: [ If handle is itself a sub-range of another buffer, the new buffer shall refer to that other buffer, so that slicing a slice does not chain the buffers. ]*/
+    TEST_FUNCTION(CONSTBUFFER_CreateFromOffsetAndSize_of_a_slice_refers_to_the_original_buffer)
+    {
+        ///arrange
+        CONSTBUFFER_HANDLE original = CONSTBUFFER_Create(BUFFER1_u_char, BUFFER1_length);
+        const CONSTBUFFER* original_content = CONSTBUFFER_GetContent(original);
+        CONSTBUFFER_HANDLE slice = CONSTBUFFER_CreateFromOffsetAndSize(original, 3, 6);
+        const CONSTBUFFER* content;
+        CONSTBUFFER_HANDLE handle;
+        umock_c_reset_all_calls();
+
+        ///act
+        handle = CONSTBUFFER_CreateFromOffsetAndSize(slice, 2, 4);
+        CONSTBUFFER_DecRef(slice);
+        CONSTBUFFER_DecRef(original);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(handle);
+        content = CONSTBUFFER_GetContent(handle);
+        ASSERT_ARE_EQUAL(size_t, 4, content->size);
+        ASSERT_ARE_EQUAL(void_ptr, original_content->buffer + 5, content->buffer);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER1_u_char + 5, content->buffer, 4));
+
+        ///cleanup
+        CONSTBUFFER_DecRef(handle);
+    }
+
+    /* Tests_SRS_CONSTBUFFER_01_021: [ If any error occurs, CONSTBUFFER_CreateFromOffsetAndSize shall fail and return NULL. ]*/
+    TEST_FUNCTION(when_malloc_fails_CONSTBUFFER_CreateFromOffsetAndSize_fails)
+    {
+        ///arrange
+        CONSTBUFFER_HANDLE original = CONSTBUFFER_Create(BUFFER1_u_char, BUFFER1_length);
+        CONSTBUFFER_HANDLE handle;
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .SetReturn(NULL);
+
+        ///act
+        handle = CONSTBUFFER_CreateFromOffsetAndSize(original, 1, 2);
+
+        ///assert
+        ASSERT_IS_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        CONSTBUFFER_DecRef(original);
+    }
+
     /* CONSTBUFFER_GetContent */
 
     /*Tests_SRS_CONSTBUFFER_02_011: [If constbufferHandle is NULL then CONSTBUFFER_GetContent shall return NULL.]*/
@@ -843,4 +1038,104 @@ BEGIN_TEST_SUITE(constbuffer_unittests)
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     }
 
+    /* Tests_SRS_CONSTBUFFER_01_022: [ The non-NULL handle returned by CONSTBUFFER_CreateFromOffsetAndSize shall have its ref count set to 1. ]*/
+    /* Tests_SRS_CONSTBUFFER_01_023: [ If the buffer was created by calling CONSTBUFFER_CreateFromOffsetAndSize, CONSTBUFFER_DecRef shall dec_ref the buffer owning the memory. ]*/
+    TEST_FUNCTION(CONSTBUFFER_CreateFromOffsetAndSize_is_ref_counted_1)
+    {
+        ///arrange
+        CONSTBUFFER_HANDLE original = CONSTBUFFER_Create(BUFFER1_u_char, BUFFER1_length);
+        CONSTBUFFER_HANDLE handle = CONSTBUFFER_CreateFromOffsetAndSize(original, 1, 2);
+        CONSTBUFFER_DecRef(original);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_free(original));
+        STRICT_EXPECTED_CALL(gballoc_free(handle));
+
+        ///act
+        CONSTBUFFER_DecRef(handle);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* CONSTBUFFER_CreateFromBufferMove */
+
+    /* Tests_SRS_CONSTBUFFER_01_024: [ If buffer is NULL then CONSTBUFFER_CreateFromBufferMove shall fail and return NULL. ]*/
+    TEST_FUNCTION(CONSTBUFFER_CreateFromBufferMove_with_NULL_fails)
+    {
+        ///arrange
+
+        ///act
+        CONSTBUFFER_HANDLE handle = CONSTBUFFER_CreateFromBufferMove(NULL);
+
+        ///assert
+        ASSERT_IS_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_CONSTBUFFER_01_025: [ CONSTBUFFER_CreateFromBufferMove shall take the memory of buffer by calling BUFFER_detach, without copying it, which leaves buffer empty. ]*/
+    /* Tests_SRS_CONSTBUFFER_01_026: [ CONSTBUFFER_CreateFromBufferMove shall return a non-NULL handle with its ref count set to 1, which frees the memory when it is freed. ]*/
+    TEST_FUNCTION(CONSTBUFFER_CreateFromBufferMove_succeeds)
+    {
+        ///arrange
+        CONSTBUFFER_HANDLE handle;
+        const CONSTBUFFER* content;
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(BUFFER_detach(BUFFER1_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+        ///act
+        handle = CONSTBUFFER_CreateFromBufferMove(BUFFER1_HANDLE);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(handle);
+        content = CONSTBUFFER_GetContent(handle);
+        ASSERT_ARE_EQUAL(size_t, BUFFER1_length, content->size);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER1_u_char, content->buffer, BUFFER1_length));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(gballoc_free((void*)content->buffer));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        CONSTBUFFER_DecRef(handle);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_CONSTBUFFER_01_027: [ If any error occurs, CONSTBUFFER_CreateFromBufferMove shall fail, leave buffer unchanged and return NULL. ]*/
+    TEST_FUNCTION(CONSTBUFFER_CreateFromBufferMove_fails_when_malloc_fails)
+    {
+        ///arrange
+        CONSTBUFFER_HANDLE handle;
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .SetReturn(NULL);
+
+        ///act
+        handle = CONSTBUFFER_CreateFromBufferMove(BUFFER1_HANDLE);
+
+        ///assert
+        ASSERT_IS_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_CONSTBUFFER_01_027: [ If any error occurs, CONSTBUFFER_CreateFromBufferMove shall fail, leave buffer unchanged and return NULL. ]*/
+    TEST_FUNCTION(CONSTBUFFER_CreateFromBufferMove_fails_when_BUFFER_detach_fails)
+    {
+        ///arrange
+        CONSTBUFFER_HANDLE handle;
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(BUFFER_detach(BUFFER1_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .SetReturn(1);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+        ///act
+        handle = CONSTBUFFER_CreateFromBufferMove(BUFFER1_HANDLE);
+
+        ///assert
+        ASSERT_IS_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
 END_TEST_SUITE(constbuffer_unittests)
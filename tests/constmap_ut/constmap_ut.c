@@ -55,14 +55,16 @@ static TEST_MUTEX_HANDLE g_testByTest;
 TEST_DEFINE_ENUM_TYPE(CONSTMAP_RESULT, CONSTMAP_RESULT_VALUES);
 
 #define VALID_MAP_HANDLE    (MAP_HANDLE)0xDEAF
-#define VALID_CONST_CHAR_POINTER (const char*const*)0xDADA
 #define VALID_MAP_CLONE1     (MAP_HANDLE)0xDEDE
 #define VALID_MAP_CLONE2     (MAP_HANDLE)0xDEDD
 #define INVALID_MAP_HANDLE  (MAP_HANDLE)0xDEAD
 #define INVALID_CLONE_HANDLE  (MAP_HANDLE)0xDEAE
-#define VALID_KV_COUNT        (size_t)100
 #define VALID_VALUE            "value"
 
+static const char* const TEST_KEYS[] = { "aKey", "bKey", "cKey" };
+static const char* const TEST_VALUES[] = { VALID_VALUE, "bValue", "cValue" };
+#define VALID_KV_COUNT        (sizeof(TEST_KEYS) / sizeof(TEST_KEYS[0]))
+
 static MAP_RESULT currentMapResult;
 
 MAP_HANDLE my_Map_Clone(MAP_HANDLE sourceMap)
@@ -130,8 +132,8 @@ MAP_RESULT my_Map_GetInternals(MAP_HANDLE handle, const char*const** keys, const
 {
     MAP_RESULT result = currentMapResult;
     (void)handle;
-    *keys = VALID_CONST_CHAR_POINTER;
-    *values = VALID_CONST_CHAR_POINTER;
+    *keys = TEST_KEYS;
+    *values = TEST_VALUES;
     *count = VALID_KV_COUNT;
     return result;
 }
@@ -196,6 +198,7 @@ BEGIN_TEST_SUITE(constmap_unittests)
     /*Tests_SRS_CONSTMAP_17_048: [ConstMap_Create shall accept any non-NULL MAP_HANDLE as input.]*/
     /*Tests_SRS_CONSTMAP_17_003: [Otherwise, it shall return a non-NULL handle that can be used in subsequent calls.]*/
     /*Tests_SRS_CONSTMAP_17_004: [If the reference count is zero, ConstMap_Destroy shall release all resources associated with the immutable map.]*/
+    /*Tests_SRS_CONSTMAP_01_001: [ConstMap_Create shall build a hash index of the keys, so that ConstMap_ContainsKey and ConstMap_GetValue do not depend on the number of pairs; if the index cannot be built, they shall look the key up in the map instead.]*/
     TEST_FUNCTION(ConstMap_Create_Destroy_Success)
     {
         // Arrange
@@ -204,7 +207,13 @@ BEGIN_TEST_SUITE(constmap_unittests)
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
         STRICT_EXPECTED_CALL(Map_Clone(VALID_MAP_HANDLE));
+        STRICT_EXPECTED_CALL(Map_GetInternals(VALID_MAP_CLONE1, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4);
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
 
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
         STRICT_EXPECTED_CALL(Map_Destroy(VALID_MAP_CLONE1));
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
@@ -275,6 +284,73 @@ BEGIN_TEST_SUITE(constmap_unittests)
 
     }
 
+    /*Tests_SRS_CONSTMAP_01_001: [ConstMap_Create shall build a hash index of the keys, so that ConstMap_ContainsKey and ConstMap_GetValue do not depend on the number of pairs; if the index cannot be built, they shall look the key up in the map instead.]*/
+    TEST_FUNCTION(ConstMap_Create_Index_Malloc_Failed_Succeeds)
+    {
+        // Arrange
+        MAP_HANDLE sourceMap;
+        CONSTMAP_HANDLE aHandle;
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(Map_Clone(VALID_MAP_HANDLE));
+        STRICT_EXPECTED_CALL(Map_GetInternals(VALID_MAP_CLONE1, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4);
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(Map_ContainsKey(VALID_MAP_CLONE1, "aKey", IGNORED_PTR_ARG))
+            .IgnoreArgument(3);
+
+        STRICT_EXPECTED_CALL(gballoc_free(NULL));
+        STRICT_EXPECTED_CALL(Map_Destroy(VALID_MAP_CLONE1));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        whenShallmalloc_fail = 2;
+        sourceMap = VALID_MAP_HANDLE;
+
+        ///Act
+        aHandle = ConstMap_Create(sourceMap);
+
+        ///Assert
+        ASSERT_IS_NOT_NULL(aHandle);
+        ASSERT_IS_TRUE(ConstMap_ContainsKey(aHandle, "aKey"));
+
+        ConstMap_Destroy(aHandle);
+
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_CONSTMAP_01_001: [ConstMap_Create shall build a hash index of the keys, so that ConstMap_ContainsKey and ConstMap_GetValue do not depend on the number of pairs; if the index cannot be built, they shall look the key up in the map instead.]*/
+    TEST_FUNCTION(ConstMap_Create_GetInternals_Failed_Succeeds)
+    {
+        // Arrange
+        MAP_HANDLE sourceMap;
+        CONSTMAP_HANDLE aHandle;
+        const char* value;
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(Map_Clone(VALID_MAP_HANDLE));
+        STRICT_EXPECTED_CALL(Map_GetInternals(VALID_MAP_CLONE1, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+            .IgnoreArgument(2).IgnoreArgument(3).IgnoreArgument(4);
+        STRICT_EXPECTED_CALL(Map_GetValueFromKey(VALID_MAP_CLONE1, "aKey"));
+
+        currentMapResult = MAP_ERROR;
+        sourceMap = VALID_MAP_HANDLE;
+
+        ///Act
+        aHandle = ConstMap_Create(sourceMap);
+        currentMapResult = MAP_OK;
+        value = ConstMap_GetValue(aHandle, "aKey");
+
+        ///Assert
+        ASSERT_IS_NOT_NULL(aHandle);
+        ASSERT_ARE_EQUAL(char_ptr, VALID_VALUE, value);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //Ablution
+        ConstMap_Destroy(aHandle);
+    }
+
     /*Tests_SRS_CONSTMAP_17_039: [ConstMap_Clone shall increase the internal reference count of the immutable map indicated by parameter handle] */
     TEST_FUNCTION(ConstMap_Clone_Destroy_Success)
     {
@@ -433,10 +509,6 @@ BEGIN_TEST_SUITE(constmap_unittests)
 
         umock_c_reset_all_calls();
 
-        // Call to Map
-        STRICT_EXPECTED_CALL(Map_ContainsKey(IGNORED_PTR_ARG, key, IGNORED_PTR_ARG))
-            .IgnoreArgument(1).IgnoreArgument(3);
-
         ///Act
         keyExists = ConstMap_ContainsKey(aHandle, key);
 
@@ -450,6 +522,31 @@ BEGIN_TEST_SUITE(constmap_unittests)
         ConstMap_Destroy(aHandle);
     }
 
+    /*Tests_SRS_CONSTMAP_17_025: [Otherwise if a key exists then ConstMap_ContainsKey shall return true.]*/
+    /*Tests_SRS_CONSTMAP_17_026: [If a key doesn't exist, then ConstMap_ContainsKey shall return false.]*/
+    TEST_FUNCTION(ConstMap_ContainsKey_All_Keys_Succeeds)
+    {
+        // Arrange
+        size_t i;
+        MAP_HANDLE sourceMap = VALID_MAP_HANDLE;
+        CONSTMAP_HANDLE aHandle = ConstMap_Create(sourceMap);
+        umock_c_reset_all_calls();
+
+        ///Act
+        for (i = 0; i < VALID_KV_COUNT; i++)
+        {
+            ASSERT_IS_TRUE(ConstMap_ContainsKey(aHandle, TEST_KEYS[i]));
+        }
+
+        ///Assert
+        ASSERT_IS_FALSE(ConstMap_ContainsKey(aHandle, "dKey"));
+        ASSERT_IS_FALSE(ConstMap_ContainsKey(aHandle, "aKe"));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //Ablution
+        ConstMap_Destroy(aHandle);
+    }
+
     /*Tests_SRS_CONSTMAP_17_024: [If parameter handle or key are NULL then ConstMap_ContainsKey shall return false.]*/
     TEST_FUNCTION(ConstMap_ContainsKey_Null)
     {
@@ -499,7 +596,11 @@ BEGIN_TEST_SUITE(constmap_unittests)
         bool keyExists;
 
         MAP_HANDLE sourceMap = VALID_MAP_HANDLE;
-        CONSTMAP_HANDLE aHandle = ConstMap_Create(sourceMap);
+        CONSTMAP_HANDLE aHandle;
+
+        // without the index the lookups go to the map
+        whenShallmalloc_fail = 2;
+        aHandle = ConstMap_Create(sourceMap);
         umock_c_reset_all_calls();
 
         // Call to Map_ContainsKey (match with mapErrorList size)
@@ -649,10 +750,6 @@ BEGIN_TEST_SUITE(constmap_unittests)
         CONSTMAP_HANDLE aHandle = ConstMap_Create(sourceMap);
         umock_c_reset_all_calls();
 
-        // Call to Map
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, key))
-            .IgnoreArgument(1);
-
         ///Act
         value = ConstMap_GetValue(aHandle, key);
 
@@ -667,6 +764,31 @@ BEGIN_TEST_SUITE(constmap_unittests)
 
     }
 
+    /*Tests_SRS_CONSTMAP_17_041: [If the key is not found, then ConstMap_GetValue returns NULL.]*/
+    /*Tests_SRS_CONSTMAP_17_042: [Otherwise, ConstMap_GetValue returns the key's value.]*/
+    TEST_FUNCTION(ConstMap_GetValue_All_Keys_Succeeds)
+    {
+        // Arrange
+        size_t i;
+        MAP_HANDLE sourceMap = VALID_MAP_HANDLE;
+        CONSTMAP_HANDLE aHandle = ConstMap_Create(sourceMap);
+        umock_c_reset_all_calls();
+
+        ///Act
+        for (i = 0; i < VALID_KV_COUNT; i++)
+        {
+            ASSERT_ARE_EQUAL(char_ptr, TEST_VALUES[i], ConstMap_GetValue(aHandle, TEST_KEYS[i]));
+        }
+
+        ///Assert
+        ASSERT_IS_NULL(ConstMap_GetValue(aHandle, "dKey"));
+        ASSERT_IS_NULL(ConstMap_GetValue(aHandle, ""));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //Ablution
+        ConstMap_Destroy(aHandle);
+    }
+
     TEST_FUNCTION(ConstMap_GetValue_Null)
     {
         // Arrange
@@ -713,7 +835,11 @@ BEGIN_TEST_SUITE(constmap_unittests)
         const char * value;
 
         MAP_HANDLE sourceMap = VALID_MAP_HANDLE;
-        CONSTMAP_HANDLE aHandle = ConstMap_Create(sourceMap);
+        CONSTMAP_HANDLE aHandle;
+
+        // without the index the lookups go to the map
+        whenShallmalloc_fail = 2;
+        aHandle = ConstMap_Create(sourceMap);
         umock_c_reset_all_calls();
 
         // Call to Map_ContainsKey (match with mapErrorList size)
@@ -770,8 +896,8 @@ BEGIN_TEST_SUITE(constmap_unittests)
 
         ///Assert
         ASSERT_ARE_EQUAL(CONSTMAP_RESULT, CONSTMAP_OK, result);
-        ASSERT_ARE_EQUAL(void_ptr, VALID_CONST_CHAR_POINTER, keys);
-        ASSERT_ARE_EQUAL(void_ptr, VALID_CONST_CHAR_POINTER, values);
+        ASSERT_ARE_EQUAL(void_ptr, TEST_KEYS, keys);
+        ASSERT_ARE_EQUAL(void_ptr, TEST_VALUES, values);
         ASSERT_ARE_EQUAL(size_t, VALID_KV_COUNT, count);
 
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
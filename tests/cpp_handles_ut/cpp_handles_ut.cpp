@@ -0,0 +1,453 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_stdint.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/strings.h"
+#include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/constbuffer.h"
+#undef ENABLE_MOCKS
+
+#include "real_strings.h"
+#include "real_constbuffer.h"
+
+#include "azure_c_shared_utility/cpp_handles.h"
+
+extern "C"
+{
+    extern BUFFER_HANDLE real_BUFFER_new(void);
+    extern BUFFER_HANDLE real_BUFFER_create(const unsigned char* source, size_t size);
+    extern void real_BUFFER_delete(BUFFER_HANDLE handle);
+    extern unsigned char* real_BUFFER_u_char(BUFFER_HANDLE handle);
+    extern size_t real_BUFFER_length(BUFFER_HANDLE handle);
+    extern int real_BUFFER_detach(BUFFER_HANDLE handle, unsigned char** memory, size_t* size);
+}
+
+static const unsigned char test_bytes[] = { 0x42, 0x43, 0x44, 0x45 };
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+BEGIN_TEST_SUITE(cpp_handles_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_UMOCK_ALIAS_TYPE(STRING_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(BUFFER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(CONSTBUFFER_HANDLE, void*);
+
+    REGISTER_STRING_GLOBAL_MOCK_HOOK;
+    REGISTER_CONSTBUFFER_GLOBAL_MOCK_HOOK();
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_new, real_BUFFER_new);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(BUFFER_new, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_create, real_BUFFER_create);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(BUFFER_create, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_delete, real_BUFFER_delete);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_u_char, real_BUFFER_u_char);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_length, real_BUFFER_length);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_detach, real_BUFFER_detach);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* cpp_unique_handle */
+
+TEST_FUNCTION(adopting_a_handle_makes_no_call_and_the_destructor_deletes_it)
+{
+    // arrange
+    STRING_HANDLE handle = real_STRING_construct("abc");
+    ASSERT_IS_NOT_NULL(handle);
+
+    // act
+    {
+        string_handle value(handle);
+
+        // assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(void_ptr, handle, value.get());
+        ASSERT_IS_TRUE((bool)value);
+
+        STRICT_EXPECTED_CALL(STRING_delete(handle));
+    }
+
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(an_empty_wrapper_deletes_nothing)
+{
+    // act
+    {
+        string_handle value;
+        ASSERT_IS_FALSE((bool)value);
+        ASSERT_IS_NULL(value.c_str());
+        ASSERT_ARE_EQUAL(size_t, 0, value.view().size());
+    }
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(moving_a_wrapper_moves_the_handle_without_deleting_it)
+{
+    // arrange
+    STRING_HANDLE handle = real_STRING_construct("abc");
+    ASSERT_IS_NOT_NULL(handle);
+    string_handle source(handle);
+
+    // act
+    {
+        string_handle destination(std::move(source));
+
+        // assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_IS_NULL(source.get());
+        ASSERT_ARE_EQUAL(void_ptr, handle, destination.get());
+
+        STRICT_EXPECTED_CALL(STRING_delete(handle));
+    }
+
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(move_assignment_deletes_the_handle_owned_so_far)
+{
+    // arrange
+    STRING_HANDLE handle_1 = real_STRING_construct("abc");
+    STRING_HANDLE handle_2 = real_STRING_construct("def");
+    ASSERT_IS_NOT_NULL(handle_1);
+    ASSERT_IS_NOT_NULL(handle_2);
+    string_handle source(handle_2);
+    string_handle destination(handle_1);
+
+    STRICT_EXPECTED_CALL(STRING_delete(handle_1));
+
+    // act
+    destination = std::move(source);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(source.get());
+    ASSERT_ARE_EQUAL(void_ptr, handle_2, destination.get());
+
+    // cleanup
+    destination.reset();
+}
+
+TEST_FUNCTION(release_hands_the_handle_over_without_deleting_it)
+{
+    // arrange
+    STRING_HANDLE handle = real_STRING_construct("abc");
+    ASSERT_IS_NOT_NULL(handle);
+    STRING_HANDLE released;
+
+    // act
+    {
+        string_handle value(handle);
+        released = value.release();
+        ASSERT_IS_NULL(value.get());
+    }
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, handle, released);
+
+    // cleanup
+    real_STRING_delete(released);
+}
+
+TEST_FUNCTION(reset_deletes_the_old_handle_and_adopts_the_new_one)
+{
+    // arrange
+    STRING_HANDLE handle_1 = real_STRING_construct("abc");
+    STRING_HANDLE handle_2 = real_STRING_construct("def");
+    ASSERT_IS_NOT_NULL(handle_1);
+    ASSERT_IS_NOT_NULL(handle_2);
+    string_handle value(handle_1);
+
+    STRICT_EXPECTED_CALL(STRING_delete(handle_1));
+
+    // act
+    value.reset(handle_2);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, handle_2, value.get());
+
+    // cleanup
+    value.reset();
+}
+
+/* string_handle */
+
+TEST_FUNCTION(string_handle_create_copies_the_view)
+{
+    // arrange
+    std::string_view source("abc\0def", 3);
+
+    STRICT_EXPECTED_CALL(STRING_from_byte_array(IGNORED_PTR_ARG, 3));
+
+    // act
+    string_handle value = string_handle::create(source);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE((bool)value);
+    ASSERT_ARE_EQUAL(char_ptr, "abc", value.c_str());
+}
+
+TEST_FUNCTION(string_handle_create_returns_an_empty_wrapper_when_STRING_from_byte_array_fails)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(STRING_from_byte_array(IGNORED_PTR_ARG, 3))
+        .SetReturn(NULL);
+
+    // act
+    string_handle value = string_handle::create("abc");
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE((bool)value);
+}
+
+TEST_FUNCTION(string_handle_adopt_memory_does_not_copy_the_memory)
+{
+    // arrange
+    char* memory = (char*)malloc(4);
+    ASSERT_IS_NOT_NULL(memory);
+    (void)strcpy(memory, "abc");
+
+    STRICT_EXPECTED_CALL(STRING_new_with_memory(memory));
+
+    // act
+    string_handle value = string_handle::adopt_memory(memory);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, memory, value.c_str());
+}
+
+TEST_FUNCTION(string_handle_view_points_at_the_content)
+{
+    // arrange
+    string_handle value(real_STRING_construct("abc"));
+    ASSERT_IS_TRUE((bool)value);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(STRING_c_str(value.get()));
+    STRICT_EXPECTED_CALL(STRING_length(value.get()));
+
+    // act
+    std::string_view view = value.view();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, real_STRING_c_str(value.get()), view.data());
+    ASSERT_ARE_EQUAL(size_t, 3, view.size());
+}
+
+/* buffer_handle */
+
+TEST_FUNCTION(buffer_handle_create_copies_the_bytes)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(BUFFER_create(test_bytes, sizeof(test_bytes)));
+
+    // act
+    buffer_handle value = buffer_handle::create(test_bytes, sizeof(test_bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_bytes), value.size());
+}
+
+TEST_FUNCTION(buffer_handle_create_with_no_bytes_creates_an_empty_buffer)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(BUFFER_new());
+
+    // act
+    buffer_handle value = buffer_handle::create(NULL, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE((bool)value);
+    ASSERT_ARE_EQUAL(size_t, 0, value.size());
+}
+
+TEST_FUNCTION(buffer_handle_create_returns_an_empty_wrapper_when_BUFFER_create_fails)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(BUFFER_create(test_bytes, sizeof(test_bytes)))
+        .SetReturn(NULL);
+
+    // act
+    buffer_handle value = buffer_handle::create(test_bytes, sizeof(test_bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE((bool)value);
+}
+
+TEST_FUNCTION(buffer_handle_view_points_at_the_content)
+{
+    // arrange
+    buffer_handle value(real_BUFFER_create(test_bytes, sizeof(test_bytes)));
+    ASSERT_IS_TRUE((bool)value);
+
+    // act
+    std::span<const uint8_t> view = value.view();
+    std::span<uint8_t> mutable_view = value.mutable_view();
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, real_BUFFER_u_char(value.get()), view.data());
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_bytes), view.size());
+    ASSERT_ARE_EQUAL(void_ptr, real_BUFFER_u_char(value.get()), mutable_view.data());
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_bytes), mutable_view.size());
+}
+
+TEST_FUNCTION(buffer_handle_destructor_deletes_the_buffer)
+{
+    // arrange
+    BUFFER_HANDLE handle = real_BUFFER_new();
+    ASSERT_IS_NOT_NULL(handle);
+
+    // act
+    {
+        buffer_handle value(handle);
+        STRICT_EXPECTED_CALL(BUFFER_delete(handle));
+    }
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* constbuffer_handle */
+
+TEST_FUNCTION(constbuffer_handle_destructor_releases_the_reference)
+{
+    // arrange
+    CONSTBUFFER_HANDLE handle = real_CONSTBUFFER_Create(test_bytes, sizeof(test_bytes));
+    ASSERT_IS_NOT_NULL(handle);
+
+    // act
+    {
+        constbuffer_handle value(handle);
+        STRICT_EXPECTED_CALL(CONSTBUFFER_DecRef(handle));
+    }
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(constbuffer_handle_share_takes_another_reference_to_the_same_content)
+{
+    // arrange
+    constbuffer_handle value(real_CONSTBUFFER_Create(test_bytes, sizeof(test_bytes)));
+    ASSERT_IS_TRUE((bool)value);
+
+    STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(value.get()));
+
+    // act
+    constbuffer_handle shared = value.share();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, value.get(), shared.get());
+}
+
+TEST_FUNCTION(constbuffer_handle_create_from_buffer_move_takes_the_memory_of_the_buffer)
+{
+    // arrange
+    buffer_handle buffer(real_BUFFER_create(test_bytes, sizeof(test_bytes)));
+    ASSERT_IS_TRUE((bool)buffer);
+    const unsigned char* memory = real_BUFFER_u_char(buffer.get());
+
+    STRICT_EXPECTED_CALL(CONSTBUFFER_CreateFromBufferMove(buffer.get()));
+    STRICT_EXPECTED_CALL(BUFFER_detach(buffer.get(), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    constbuffer_handle value = constbuffer_handle::create_from_buffer_move(buffer);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE((bool)value);
+    ASSERT_ARE_EQUAL(void_ptr, memory, value.view().data());
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_bytes), value.size());
+    ASSERT_ARE_EQUAL(size_t, 0, buffer.size());
+}
+
+TEST_FUNCTION(constbuffer_handle_slice_points_into_the_same_content)
+{
+    // arrange
+    constbuffer_handle value(real_CONSTBUFFER_Create(test_bytes, sizeof(test_bytes)));
+    ASSERT_IS_TRUE((bool)value);
+
+    // act
+    constbuffer_handle slice = value.slice(1, 2);
+
+    // assert
+    ASSERT_IS_TRUE((bool)slice);
+    ASSERT_ARE_EQUAL(void_ptr, value.view().data() + 1, slice.view().data());
+    ASSERT_ARE_EQUAL(size_t, 2, slice.size());
+}
+
+TEST_FUNCTION(constbuffer_handle_create_returns_an_empty_wrapper_when_CONSTBUFFER_Create_fails)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(CONSTBUFFER_Create(test_bytes, sizeof(test_bytes)))
+        .SetReturn(NULL);
+
+    // act
+    constbuffer_handle value = constbuffer_handle::create(test_bytes, sizeof(test_bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE((bool)value);
+    ASSERT_ARE_EQUAL(size_t, 0, value.view().size());
+}
+
+END_TEST_SUITE(cpp_handles_unittests)
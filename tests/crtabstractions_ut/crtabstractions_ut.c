@@ -6,11 +6,15 @@
 #include <climits>
 #include <cfloat>
 #include <cmath>
+#include <cstdio>
+#include <cstring>
 #else
 #include <stdlib.h>
 #include <limits.h>
 #include <float.h>
 #include <math.h>
+#include <stdio.h>
+#include <string.h>
 #endif
 
 #include "testrunnerswitcher.h"
@@ -2717,4 +2721,105 @@ TEST_FUNCTION(size_tToString_succeeds_for_space_just_about_right)
     }
 }
 
+/*Tests_SRS_CRT_ABSTRACTIONS_01_002: [If destination or length is NULL, or destination cannot hold the decimal representation of value and a null character, unsignedIntToStringWithLength shall fail and return a non-zero value.] */
+TEST_FUNCTION(unsignedIntToStringWithLength_fails_when_length_is_NULL)
+{
+    // arrange
+    char destination[1000];
+
+    // act
+    int result = unsignedIntToStringWithLength(destination, sizeof(destination), 43, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_CRT_ABSTRACTIONS_01_002: [If destination or length is NULL, or destination cannot hold the decimal representation of value and a null character, unsignedIntToStringWithLength shall fail and return a non-zero value.] */
+TEST_FUNCTION(unsignedIntToStringWithLength_fails_when_destination_is_not_sufficient)
+{
+    // arrange
+    char destination[1000];
+    size_t length = 0;
+
+    // act
+    int result = unsignedIntToStringWithLength(destination, 4, 1234, &length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, length);
+}
+
+/*Tests_SRS_CRT_ABSTRACTIONS_01_001: [unsignedIntToStringWithLength shall convert value like unsignedIntToString does and store the number of characters written, not counting the terminating null character, in length.] */
+/*Tests_SRS_CRT_ABSTRACTIONS_01_003: [On success unsignedIntToStringWithLength shall return 0.] */
+TEST_FUNCTION(unsignedIntToStringWithLength_succeeds_for_interesting_numbers)
+{
+    // arrange
+    char destination[1000];
+    char expected[1000];
+    size_t i;
+    for (i = 0; i < sizeof(interestingUnsignedIntNumbersToBeConverted) / sizeof(interestingUnsignedIntNumbersToBeConverted[0]); i++)
+    {
+        size_t length = 0;
+        int result;
+        (void)sprintf(expected, "%u", interestingUnsignedIntNumbersToBeConverted[i]);
+
+        ///act
+        result = unsignedIntToStringWithLength(destination, strlen(expected) + 1, interestingUnsignedIntNumbersToBeConverted[i], &length);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, expected, destination);
+        ASSERT_ARE_EQUAL(size_t, strlen(expected), length);
+    }
+}
+
+/*Tests_SRS_CRT_ABSTRACTIONS_01_005: [If destination or length is NULL, or destination cannot hold the decimal representation of value and a null character, size_tToStringWithLength shall fail and return a non-zero value.] */
+TEST_FUNCTION(size_tToStringWithLength_fails_when_destination_is_NULL)
+{
+    // arrange
+    size_t length;
+
+    // act
+    int result = size_tToStringWithLength(NULL, 100, 43, &length);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_CRT_ABSTRACTIONS_01_004: [size_tToStringWithLength shall convert value like size_tToString does and store the number of characters written, not counting the terminating null character, in length.] */
+/*Tests_SRS_CRT_ABSTRACTIONS_01_006: [On success size_tToStringWithLength shall return 0.] */
+TEST_FUNCTION(size_tToStringWithLength_succeeds_for_SIZE_MAX)
+{
+    // arrange
+    char destination[1000];
+    char expected[1000];
+    size_t length = 0;
+    int result;
+    (void)sprintf(expected, "%llu", (unsigned long long)SIZE_MAX);
+
+    // act
+    result = size_tToStringWithLength(destination, strlen(expected) + 1, SIZE_MAX, &length);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, expected, destination);
+    ASSERT_ARE_EQUAL(size_t, strlen(expected), length);
+}
+
+/*Tests_SRS_CRT_ABSTRACTIONS_21_016: [The strtof_s must return the float that represents the value in the initial part of the string. If any.]*/
+TEST_FUNCTION(strtof_s_short_negative_decimal_with_characters_after_the_number_success)
+{
+    // arrange
+    const char* subjectStr = "-3.25}";
+    char* endptr;
+    float result;
+
+    // act
+    result = strtof_s(subjectStr, &endptr);
+
+    // assert
+    ASSERT_ARE_EQUAL(float, -3.25f, result);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)(subjectStr + 5), (void*)endptr);
+}
+
 END_TEST_SUITE(CRTAbstractions_UnitTests)
@@ -18,6 +18,7 @@
 #include <ctime>
 #else
 #include <stddef.h>
+#include <string.h>
 #include <time.h>
 #endif
 
@@ -47,6 +48,7 @@ void my_gballoc_free(void* ptr)
 
 #include "socket_async_os.h"
 #include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/dns_cache.h"
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -68,10 +70,26 @@ void freeaddrinfo(struct addrinfo* ai)
 #define GETADDRINFO_SUCCESS 0
 #define GETADDRINFO_FAIL -1
 #define FAKE_GOOD_IP_ADDR 444
+#define FAKE_CACHED_IP_ADDR 555
 
 struct sockaddr_in fake_good_addr;
 struct addrinfo fake_addrinfo;
 
+static DNS_CACHE_RESULT my_dns_cache_lookup_miss(const char* hostname, DNS_CACHE_ADDRESSES* addresses)
+{
+    (void)hostname;
+    (void)addresses;
+    return DNS_CACHE_MISS;
+}
+
+static DNS_CACHE_RESULT my_dns_cache_lookup_hit(const char* hostname, DNS_CACHE_ADDRESSES* addresses)
+{
+    (void)hostname;
+    (void)memset(addresses, 0, sizeof(*addresses));
+    addresses->ip_v4 = FAKE_CACHED_IP_ADDR;
+    return DNS_CACHE_HIT;
+}
+
 int my_getaddrinfo(const char *node, const char *service, const struct addrinfo *hints, struct addrinfo **res)
 {
     (void)node;
@@ -85,6 +103,24 @@ int my_getaddrinfo(const char *node, const char *service, const struct addrinfo
     return 0;
 }
 
+#ifdef AF_INET6
+static const unsigned char FAKE_GOOD_IPV6_ADDR[DNS_ASYNC_IPV6_ADDRESS_SIZE] = { 0x20, 0x01, 0x0d, 0xb8, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 1 };
+
+struct sockaddr_in6 fake_good_addr6;
+struct addrinfo fake_addrinfo6;
+
+static int my_getaddrinfo_dual_stack(const char *node, const char *service, const struct addrinfo *hints, struct addrinfo **res)
+{
+    (void)my_getaddrinfo(node, service, hints, res);
+    fake_addrinfo6.ai_next = &fake_addrinfo;
+    fake_addrinfo6.ai_family = AF_INET6;
+    fake_addrinfo6.ai_addr = (struct sockaddr*)(&fake_good_addr6);
+    (void)memcpy(fake_good_addr6.sin6_addr.s6_addr, FAKE_GOOD_IPV6_ADDR, DNS_ASYNC_IPV6_ADDRESS_SIZE);
+    *res = &fake_addrinfo6;
+    return 0;
+}
+#endif
+
 /**
  * Include the test tools.
  */
@@ -139,6 +175,12 @@ BEGIN_TEST_SUITE(dns_async_ut)
 
         REGISTER_GLOBAL_MOCK_RETURNS(getaddrinfo, GETADDRINFO_SUCCESS, GETADDRINFO_FAIL);
         REGISTER_GLOBAL_MOCK_HOOK(getaddrinfo, my_getaddrinfo);
+
+        REGISTER_UMOCK_ALIAS_TYPE(DNS_CACHE_RESULT, int);
+        REGISTER_UMOCK_ALIAS_TYPE(DNS_CACHE_ADDRESSES*, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(const DNS_CACHE_ADDRESSES*, void*);
+        REGISTER_GLOBAL_MOCK_HOOK(dns_cache_lookup, my_dns_cache_lookup_miss);
+        REGISTER_GLOBAL_MOCK_RETURN(dns_cache_add, 0);
 }
 
     /**
@@ -172,6 +214,8 @@ BEGIN_TEST_SUITE(dns_async_ut)
      */
     TEST_FUNCTION_CLEANUP(cleans)
     {
+        REGISTER_GLOBAL_MOCK_HOOK(getaddrinfo, my_getaddrinfo);
+        REGISTER_GLOBAL_MOCK_HOOK(dns_cache_lookup, my_dns_cache_lookup_miss);
         TEST_MUTEX_RELEASE(g_testByTest);
     }
 
@@ -291,6 +335,93 @@ BEGIN_TEST_SUITE(dns_async_ut)
         dns_async_destroy(dns);
     }
 
+    /* Tests_SRS_DNS_ASYNC_01_010: [ dns_async shall add the result of each lookup it makes to dns_cache. ]*/
+    TEST_FUNCTION(dns_async__is_complete_adds_the_result_to_the_cache__succeeds)
+    {
+        ///arrange
+        bool result;
+        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(dns_cache_lookup("fake.com", IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(dns_cache_add("fake.com", IGNORED_PTR_ARG));
+
+        ///act
+        result = dns_async_is_lookup_complete(dns);
+
+        ///assert
+        ASSERT_IS_TRUE(result, "Unexpected non-completion");
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_01_010: [ dns_async shall add the result of each lookup it makes to dns_cache. ]*/
+    TEST_FUNCTION(dns_async__is_complete_adds_the_failure_to_the_cache__succeeds)
+    {
+        ///arrange
+        bool result;
+        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(dns_cache_lookup("fake.com", IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).SetReturn(GETADDRINFO_FAIL);
+        STRICT_EXPECTED_CALL(dns_cache_add("fake.com", NULL));
+
+        ///act
+        result = dns_async_is_lookup_complete(dns);
+
+        ///assert
+        ASSERT_IS_TRUE(result, "Unexpected non-completion");
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_01_009: [ dns_async shall use the addresses or the failure cached by dns_cache for hostname instead of looking it up. ]*/
+    TEST_FUNCTION(dns_async__is_complete_with_cached_addresses__succeeds)
+    {
+        ///arrange
+        bool result;
+        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(dns_cache_lookup, my_dns_cache_lookup_hit);
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(dns_cache_lookup("fake.com", IGNORED_PTR_ARG));
+
+        ///act
+        result = dns_async_is_lookup_complete(dns);
+
+        ///assert
+        ASSERT_IS_TRUE(result, "Unexpected non-completion");
+        ASSERT_ARE_EQUAL(uint32_t, FAKE_CACHED_IP_ADDR, dns_async_get_ipv4(dns), "Unexpected IP");
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_01_009: [ dns_async shall use the addresses or the failure cached by dns_cache for hostname instead of looking it up. ]*/
+    TEST_FUNCTION(dns_async__is_complete_with_cached_failure__fails)
+    {
+        ///arrange
+        bool result;
+        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(dns_cache_lookup("fake.com", IGNORED_PTR_ARG)).SetReturn(DNS_CACHE_NEGATIVE_HIT);
+
+        ///act
+        result = dns_async_is_lookup_complete(dns);
+
+        ///assert
+        ASSERT_IS_TRUE(result, "Unexpected non-completion");
+        ASSERT_ARE_EQUAL(uint32_t, 0, dns_async_get_ipv4(dns), "Unexpected non-zero IP");
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
     /* Tests_SRS_DNS_ASYNC_30_020: [ If the dns parameter is NULL, dns_async_is_create_complete shall log an error and return false. ]*/
     TEST_FUNCTION(dns_async__is_complete_parameter_validation__fails)
     {
@@ -333,6 +464,122 @@ BEGIN_TEST_SUITE(dns_async_ut)
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     }
 
+#ifdef AF_INET6
+    /* Tests_SRS_DNS_ASYNC_01_004: [ If dns_async_is_lookup_complete has returned true and the lookup process has found an IPv6 address, dns_async_get_ipv6 shall copy the first discovered IPv6 address to address and return 0. ]*/
+    /* Tests_SRS_DNS_ASYNC_30_032: [ If dns_async_is_create_complete has returned true and the lookup process has succeeded, dns_async_get_ipv4 shall return the discovered IPv4 address. ]*/
+    TEST_FUNCTION(dns_async__get_ipv6__succeeds)
+    {
+        ///arrange
+        bool result;
+        int ipv6_result;
+        unsigned char ipv6[DNS_ASYNC_IPV6_ADDRESS_SIZE];
+        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(getaddrinfo, my_getaddrinfo_dual_stack);
+        result = dns_async_is_lookup_complete(dns);
+        ASSERT_IS_TRUE(result, "Unexpected non-completion");
+        umock_c_reset_all_calls();
+
+        ///act
+        ipv6_result = dns_async_get_ipv6(dns, ipv6, sizeof(ipv6));
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, ipv6_result, "Unexpected failure");
+        ASSERT_ARE_EQUAL(int, 0, memcmp(FAKE_GOOD_IPV6_ADDR, ipv6, sizeof(ipv6)), "Unexpected IPv6");
+        ASSERT_ARE_EQUAL(uint32_t, FAKE_GOOD_IP_ADDR, dns_async_get_ipv4(dns), "Unexpected IP");
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+#endif
+
+    /* Tests_SRS_DNS_ASYNC_01_006: [ If the lookup process has failed or found no IPv6 address, dns_async_get_ipv6 shall return a non-zero value. ]*/
+    TEST_FUNCTION(dns_async__get_ipv6_with_no_ipv6_address__fails)
+    {
+        ///arrange
+        bool result;
+        int ipv6_result;
+        unsigned char ipv6[DNS_ASYNC_IPV6_ADDRESS_SIZE];
+        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        result = dns_async_is_lookup_complete(dns);
+        ASSERT_IS_TRUE(result, "Unexpected non-completion");
+
+        ///act
+        ipv6_result = dns_async_get_ipv6(dns, ipv6, sizeof(ipv6));
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, ipv6_result, "Unexpected success");
+        ASSERT_ARE_EQUAL(uint32_t, FAKE_GOOD_IP_ADDR, dns_async_get_ipv4(dns), "Unexpected IP");
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_01_006: [ If the lookup process has failed or found no IPv6 address, dns_async_get_ipv6 shall return a non-zero value. ]*/
+    TEST_FUNCTION(dns_async__get_ipv6_after_failure__fails)
+    {
+        ///arrange
+        bool result;
+        int ipv6_result;
+        unsigned char ipv6[DNS_ASYNC_IPV6_ADDRESS_SIZE];
+        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).SetReturn(GETADDRINFO_FAIL);
+        result = dns_async_is_lookup_complete(dns);
+        ASSERT_IS_TRUE(result, "Unexpected non-completion");
+
+        ///act
+        ipv6_result = dns_async_get_ipv6(dns, ipv6, sizeof(ipv6));
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, ipv6_result, "Unexpected success");
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_01_005: [ If dns_async_is_lookup_complete has not yet returned true, dns_async_get_ipv6 shall log an error and return a non-zero value. ]*/
+    TEST_FUNCTION(dns_async__get_ipv6_too_early__fails)
+    {
+        ///arrange
+        unsigned char ipv6[DNS_ASYNC_IPV6_ADDRESS_SIZE];
+        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+
+        ///act
+        int result = dns_async_get_ipv6(dns, ipv6, sizeof(ipv6));
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result, "Unexpected success");
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
+    /* Tests_SRS_DNS_ASYNC_01_003: [ If dns or address is NULL or address_size is smaller than DNS_ASYNC_IPV6_ADDRESS_SIZE, dns_async_get_ipv6 shall log an error and return a non-zero value. ]*/
+    TEST_FUNCTION(dns_async__get_ipv6_parameter_validation__fails)
+    {
+        ///arrange
+        unsigned char ipv6[DNS_ASYNC_IPV6_ADDRESS_SIZE];
+        DNS_ASYNC_HANDLE dns = dns_async_create("fake.com", NULL);
+        bool complete = dns_async_is_lookup_complete(dns);
+        ASSERT_IS_TRUE(complete, "Unexpected non-completion");
+        umock_c_reset_all_calls();
+
+        ///act
+        int null_dns_result = dns_async_get_ipv6(NULL, ipv6, sizeof(ipv6));
+        int null_address_result = dns_async_get_ipv6(dns, NULL, sizeof(ipv6));
+        int small_size_result = dns_async_get_ipv6(dns, ipv6, sizeof(ipv6) - 1);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, null_dns_result, "Unexpected success");
+        ASSERT_ARE_NOT_EQUAL(int, 0, null_address_result, "Unexpected success");
+        ASSERT_ARE_NOT_EQUAL(int, 0, small_size_result, "Unexpected success");
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        dns_async_destroy(dns);
+    }
+
     /* Tests_SRS_DNS_ASYNC_30_050: [ If the dns parameter is NULL, dns_async_destroy shall log an error and do nothing. ]*/
     TEST_FUNCTION(dns_async__destroy_parameter_validation__fails)
     {
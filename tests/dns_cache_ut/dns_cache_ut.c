@@ -0,0 +1,713 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#include "macro_utils.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_bool.h"
+#include "umocktypes_stdint.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/dns_cache.h"
+
+static const TICK_COUNTER_HANDLE TEST_TICK_COUNTER_HANDLE = (TICK_COUNTER_HANDLE)0x4242;
+static const LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4243;
+
+#define TEST_IP_V4 0x0100007F
+#define TEST_OTHER_IP_V4 0x0200007F
+
+static tickcounter_ms_t g_now;
+
+static int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = g_now;
+    return 0;
+}
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+static DNS_CACHE_ADDRESSES make_addresses(uint32_t ip_v4)
+{
+    DNS_CACHE_ADDRESSES result;
+    (void)memset(&result, 0, sizeof(result));
+    result.ip_v4 = ip_v4;
+    return result;
+}
+
+static void init_cache(void)
+{
+    ASSERT_ARE_EQUAL(int, 0, dns_cache_init());
+    umock_c_reset_all_calls();
+}
+
+BEGIN_TEST_SUITE(dns_cache_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result, "umock_c_init");
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_charptr_register_types");
+
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_bool_register_types");
+
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_stdint_register_types");
+
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_RESULT, int);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(tickcounter_create, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock_Init, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    g_now = 1000;
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/* dns_cache_init */
+
+/* Tests_SRS_DNS_CACHE_01_002: [ dns_cache_init shall create a lock and a tick counter. ]*/
+/* Tests_SRS_DNS_CACHE_01_003: [ dns_cache_init shall enable the cache with a TTL of DNS_CACHE_DEFAULT_TTL_MS and a negative TTL of DNS_CACHE_DEFAULT_NEGATIVE_TTL_MS and return 0. ]*/
+TEST_FUNCTION(dns_cache_init_succeeds)
+{
+    // arrange
+    int result;
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(Lock_Init());
+
+    // act
+    result = dns_cache_init();
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    dns_cache_deinit();
+}
+
+/* Tests_SRS_DNS_CACHE_01_001: [ If the cache is already initialized, dns_cache_init shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(dns_cache_init_when_already_initialized_fails)
+{
+    // arrange
+    int result;
+    init_cache();
+
+    // act
+    result = dns_cache_init();
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    dns_cache_deinit();
+}
+
+/* Tests_SRS_DNS_CACHE_01_004: [ If any failure occurs, dns_cache_init shall free what it created and return a non-zero value. ]*/
+TEST_FUNCTION(when_Lock_Init_fails_dns_cache_init_fails)
+{
+    // arrange
+    int result;
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(Lock_Init())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+
+    // act
+    result = dns_cache_init();
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_DNS_CACHE_01_004: [ If any failure occurs, dns_cache_init shall free what it created and return a non-zero value. ]*/
+TEST_FUNCTION(when_tickcounter_create_fails_dns_cache_init_fails)
+{
+    // arrange
+    int result;
+    STRICT_EXPECTED_CALL(tickcounter_create())
+        .SetReturn(NULL);
+
+    // act
+    result = dns_cache_init();
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* dns_cache_deinit */
+
+/* Tests_SRS_DNS_CACHE_01_005: [ If the cache is not initialized, dns_cache_deinit shall return. ]*/
+TEST_FUNCTION(dns_cache_deinit_when_not_initialized_returns)
+{
+    // act
+    dns_cache_deinit();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_DNS_CACHE_01_006: [ dns_cache_deinit shall free all entries, the lock and the tick counter. ]*/
+TEST_FUNCTION(dns_cache_deinit_frees_the_entries_the_lock_and_the_tick_counter)
+{
+    // arrange
+    DNS_CACHE_ADDRESSES addresses = make_addresses(TEST_IP_V4);
+    init_cache();
+    ASSERT_ARE_EQUAL(int, 0, dns_cache_add("host", &addresses));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+
+    // act
+    dns_cache_deinit();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* dns_cache_lookup */
+
+/* Tests_SRS_DNS_CACHE_01_013: [ If the cache is not initialized or is disabled, dns_cache_lookup shall return DNS_CACHE_MISS. ]*/
+/* Tests_SRS_DNS_CACHE_01_019: [ If the cache is not initialized or is disabled, dns_cache_add shall do nothing and return 0. ]*/
+TEST_FUNCTION(dns_cache_lookup_when_not_initialized_misses)
+{
+    // arrange
+    DNS_CACHE_ADDRESSES addresses = make_addresses(TEST_IP_V4);
+    DNS_CACHE_RESULT result;
+    ASSERT_ARE_EQUAL(int, 0, dns_cache_add("host", &addresses));
+
+    // act
+    result = dns_cache_lookup("host", &addresses);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_MISS, (int)result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_DNS_CACHE_01_012: [ If hostname or addresses is NULL, dns_cache_lookup shall return DNS_CACHE_MISS. ]*/
+TEST_FUNCTION(dns_cache_lookup_with_NULL_arguments_misses)
+{
+    // arrange
+    DNS_CACHE_ADDRESSES addresses;
+    init_cache();
+
+    // act
+    DNS_CACHE_RESULT null_hostname_result = dns_cache_lookup(NULL, &addresses);
+    DNS_CACHE_RESULT null_addresses_result = dns_cache_lookup("host", NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_MISS, (int)null_hostname_result);
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_MISS, (int)null_addresses_result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    dns_cache_deinit();
+}
+
+/* Tests_SRS_DNS_CACHE_01_014: [ If hostname has no entry, dns_cache_lookup shall return DNS_CACHE_MISS. ]*/
+TEST_FUNCTION(dns_cache_lookup_of_an_unknown_host_misses)
+{
+    // arrange
+    DNS_CACHE_ADDRESSES addresses = make_addresses(TEST_IP_V4);
+    DNS_CACHE_RESULT result;
+    init_cache();
+    ASSERT_ARE_EQUAL(int, 0, dns_cache_add("host", &addresses));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = dns_cache_lookup("other_host", &addresses);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_MISS, (int)result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    dns_cache_deinit();
+}
+
+/* Tests_SRS_DNS_CACHE_01_017: [ Otherwise dns_cache_lookup shall copy the addresses of the entry to addresses and return DNS_CACHE_HIT. ]*/
+/* Tests_SRS_DNS_CACHE_01_022: [ Otherwise dns_cache_add shall add an entry for hostname, recording a failed lookup if addresses is NULL, and return 0. ]*/
+TEST_FUNCTION(dns_cache_lookup_of_an_added_host_hits)
+{
+    // arrange
+    DNS_CACHE_ADDRESSES addresses = make_addresses(TEST_IP_V4);
+    DNS_CACHE_ADDRESSES found;
+    DNS_CACHE_RESULT result;
+    addresses.has_ip_v6 = true;
+    addresses.ip_v6[15] = 1;
+    init_cache();
+    ASSERT_ARE_EQUAL(int, 0, dns_cache_add("host", &addresses));
+    g_now += DNS_CACHE_DEFAULT_TTL_MS - 1;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = dns_cache_lookup("host", &found);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_HIT, (int)result);
+    ASSERT_ARE_EQUAL(uint32_t, TEST_IP_V4, found.ip_v4);
+    ASSERT_IS_TRUE(found.has_ip_v6);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(addresses.ip_v6, found.ip_v6, DNS_CACHE_IPV6_ADDRESS_SIZE));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    dns_cache_deinit();
+}
+
+/* Tests_SRS_DNS_CACHE_01_015: [ If the entry of hostname has expired, dns_cache_lookup shall remove it and return DNS_CACHE_MISS. ]*/
+TEST_FUNCTION(dns_cache_lookup_of_an_expired_host_misses_and_removes_it)
+{
+    // arrange
+    DNS_CACHE_ADDRESSES addresses = make_addresses(TEST_IP_V4);
+    DNS_CACHE_RESULT result;
+    init_cache();
+    ASSERT_ARE_EQUAL(int, 0, dns_cache_add("host", &addresses));
+    g_now += DNS_CACHE_DEFAULT_TTL_MS;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = dns_cache_lookup("host", &addresses);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_MISS, (int)result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    dns_cache_deinit();
+}
+
+/* Tests_SRS_DNS_CACHE_01_016: [ If the entry of hostname records a failed lookup, dns_cache_lookup shall return DNS_CACHE_NEGATIVE_HIT. ]*/
+TEST_FUNCTION(dns_cache_lookup_of_a_failed_host_is_a_negative_hit_for_the_negative_ttl)
+{
+    // arrange
+    DNS_CACHE_ADDRESSES addresses;
+    DNS_CACHE_RESULT before_expiry;
+    DNS_CACHE_RESULT after_expiry;
+    init_cache();
+    ASSERT_ARE_EQUAL(int, 0, dns_cache_add("host", NULL));
+
+    // act
+    g_now += DNS_CACHE_DEFAULT_NEGATIVE_TTL_MS - 1;
+    before_expiry = dns_cache_lookup("host", &addresses);
+    g_now += 1;
+    after_expiry = dns_cache_lookup("host", &addresses);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_NEGATIVE_HIT, (int)before_expiry);
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_MISS, (int)after_expiry);
+
+    // cleanup
+    dns_cache_deinit();
+}
+
+/* Tests_SRS_DNS_CACHE_01_013: [ If the cache is not initialized or is disabled, dns_cache_lookup shall return DNS_CACHE_MISS. ]*/
+TEST_FUNCTION(dns_cache_lookup_when_disabled_misses)
+{
+    // arrange
+    DNS_CACHE_ADDRESSES addresses = make_addresses(TEST_IP_V4);
+    DNS_CACHE_RESULT result;
+    init_cache();
+    dns_cache_set_enabled(false);
+    ASSERT_ARE_EQUAL(int, 0, dns_cache_add("host", &addresses));
+
+    // act
+    result = dns_cache_lookup("host", &addresses);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_MISS, (int)result);
+
+    // cleanup
+    dns_cache_deinit();
+}
+
+/* dns_cache_set_enabled */
+
+/* Tests_SRS_DNS_CACHE_01_011: [ dns_cache_set_enabled shall enable or disable the cache and, when disabling it, remove all entries. ]*/
+TEST_FUNCTION(dns_cache_set_enabled_false_removes_all_entries)
+{
+    // arrange
+    DNS_CACHE_ADDRESSES addresses = make_addresses(TEST_IP_V4);
+    DNS_CACHE_RESULT result;
+    init_cache();
+    ASSERT_ARE_EQUAL(int, 0, dns_cache_add("host", &addresses));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    dns_cache_set_enabled(false);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    dns_cache_set_enabled(true);
+    result = dns_cache_lookup("host", &addresses);
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_MISS, (int)result);
+
+    // cleanup
+    dns_cache_deinit();
+}
+
+/* Tests_SRS_DNS_CACHE_01_010: [ If the cache is not initialized, dns_cache_set_enabled shall return. ]*/
+TEST_FUNCTION(dns_cache_set_enabled_when_not_initialized_returns)
+{
+    // act
+    dns_cache_set_enabled(true);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* dns_cache_set_ttl */
+
+/* Tests_SRS_DNS_CACHE_01_007: [ If the cache is not initialized, dns_cache_set_ttl shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(dns_cache_set_ttl_when_not_initialized_fails)
+{
+    // act
+    int result = dns_cache_set_ttl(1000, 1000);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_DNS_CACHE_01_008: [ dns_cache_set_ttl shall set the TTLs given to the entries added afterwards and return 0. ]*/
+TEST_FUNCTION(dns_cache_set_ttl_applies_to_the_entries_added_afterwards)
+{
+    // arrange
+    DNS_CACHE_ADDRESSES addresses = make_addresses(TEST_IP_V4);
+    DNS_CACHE_RESULT before_expiry;
+    DNS_CACHE_RESULT after_expiry;
+    int result;
+    init_cache();
+
+    // act
+    result = dns_cache_set_ttl(100, 10);
+    ASSERT_ARE_EQUAL(int, 0, dns_cache_add("host", &addresses));
+    g_now += 99;
+    before_expiry = dns_cache_lookup("host", &addresses);
+    g_now += 1;
+    after_expiry = dns_cache_lookup("host", &addresses);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_HIT, (int)before_expiry);
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_MISS, (int)after_expiry);
+
+    // cleanup
+    dns_cache_deinit();
+}
+
+/* Tests_SRS_DNS_CACHE_01_009: [ If any failure occurs, dns_cache_set_ttl shall return a non-zero value. ]*/
+TEST_FUNCTION(when_Lock_fails_dns_cache_set_ttl_fails)
+{
+    // arrange
+    int result;
+    init_cache();
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE))
+        .SetReturn(LOCK_ERROR);
+
+    // act
+    result = dns_cache_set_ttl(100, 10);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    dns_cache_deinit();
+}
+
+/* dns_cache_add */
+
+/* Tests_SRS_DNS_CACHE_01_018: [ If hostname is NULL, dns_cache_add shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(dns_cache_add_with_NULL_hostname_fails)
+{
+    // arrange
+    DNS_CACHE_ADDRESSES addresses = make_addresses(TEST_IP_V4);
+    int result;
+    init_cache();
+
+    // act
+    result = dns_cache_add(NULL, &addresses);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    dns_cache_deinit();
+}
+
+/* Tests_SRS_DNS_CACHE_01_020: [ If the TTL for the kind of result is 0, dns_cache_add shall remove the entry of hostname and return 0. ]*/
+TEST_FUNCTION(dns_cache_add_with_a_0_ttl_removes_the_entry)
+{
+    // arrange
+    DNS_CACHE_ADDRESSES addresses = make_addresses(TEST_IP_V4);
+    DNS_CACHE_RESULT lookup_result;
+    int result;
+    init_cache();
+    ASSERT_ARE_EQUAL(int, 0, dns_cache_add("host", &addresses));
+    ASSERT_ARE_EQUAL(int, 0, dns_cache_set_ttl(DNS_CACHE_DEFAULT_TTL_MS, 0));
+
+    // act
+    result = dns_cache_add("host", NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    lookup_result = dns_cache_lookup("host", &addresses);
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_MISS, (int)lookup_result);
+
+    // cleanup
+    dns_cache_deinit();
+}
+
+/* Tests_SRS_DNS_CACHE_01_021: [ If hostname already has an entry, dns_cache_add shall replace its result and restart its TTL. ]*/
+TEST_FUNCTION(dns_cache_add_of_a_known_host_replaces_its_entry)
+{
+    // arrange
+    DNS_CACHE_ADDRESSES addresses = make_addresses(TEST_IP_V4);
+    DNS_CACHE_ADDRESSES other_addresses = make_addresses(TEST_OTHER_IP_V4);
+    DNS_CACHE_ADDRESSES found;
+    DNS_CACHE_RESULT lookup_result;
+    int result;
+    init_cache();
+    ASSERT_ARE_EQUAL(int, 0, dns_cache_add("host", &addresses));
+    g_now += DNS_CACHE_DEFAULT_TTL_MS - 1;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = dns_cache_add("host", &other_addresses);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    g_now += DNS_CACHE_DEFAULT_TTL_MS - 1;
+    lookup_result = dns_cache_lookup("host", &found);
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_HIT, (int)lookup_result);
+    ASSERT_ARE_EQUAL(uint32_t, TEST_OTHER_IP_V4, found.ip_v4);
+
+    // cleanup
+    dns_cache_deinit();
+}
+
+/* Tests_SRS_DNS_CACHE_01_023: [ If the cache holds DNS_CACHE_MAX_ENTRIES entries, dns_cache_add shall remove the expired entries and, if none has expired, the oldest entry. ]*/
+TEST_FUNCTION(dns_cache_add_when_full_removes_the_oldest_entry)
+{
+    // arrange
+    DNS_CACHE_ADDRESSES addresses = make_addresses(TEST_IP_V4);
+    char hostname[16];
+    size_t i;
+    int result;
+    init_cache();
+    for (i = 0; i < DNS_CACHE_MAX_ENTRIES; i++)
+    {
+        (void)sprintf(hostname, "host%lu", (unsigned long)i);
+        ASSERT_ARE_EQUAL(int, 0, dns_cache_add(hostname, &addresses));
+        g_now++;
+    }
+
+    // act
+    result = dns_cache_add("one_more_host", &addresses);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_MISS, (int)dns_cache_lookup("host0", &addresses));
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_HIT, (int)dns_cache_lookup("host1", &addresses));
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_HIT, (int)dns_cache_lookup("one_more_host", &addresses));
+
+    // cleanup
+    dns_cache_deinit();
+}
+
+/* Tests_SRS_DNS_CACHE_01_024: [ If any failure occurs, dns_cache_add shall return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_the_entry_fails_dns_cache_add_fails)
+{
+    // arrange
+    DNS_CACHE_ADDRESSES addresses = make_addresses(TEST_IP_V4);
+    int result;
+    init_cache();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = dns_cache_add("host", &addresses);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    dns_cache_deinit();
+}
+
+/* dns_cache_remove */
+
+/* Tests_SRS_DNS_CACHE_01_026: [ dns_cache_remove shall remove the entry of hostname if it has one. ]*/
+TEST_FUNCTION(dns_cache_remove_removes_the_entry)
+{
+    // arrange
+    DNS_CACHE_ADDRESSES addresses = make_addresses(TEST_IP_V4);
+    init_cache();
+    ASSERT_ARE_EQUAL(int, 0, dns_cache_add("host", &addresses));
+    ASSERT_ARE_EQUAL(int, 0, dns_cache_add("other_host", &addresses));
+
+    // act
+    dns_cache_remove("host");
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_MISS, (int)dns_cache_lookup("host", &addresses));
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_HIT, (int)dns_cache_lookup("other_host", &addresses));
+
+    // cleanup
+    dns_cache_deinit();
+}
+
+/* Tests_SRS_DNS_CACHE_01_025: [ If hostname is NULL or the cache is not initialized, dns_cache_remove shall return. ]*/
+TEST_FUNCTION(dns_cache_remove_when_not_initialized_returns)
+{
+    // act
+    dns_cache_remove("host");
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* dns_cache_clear */
+
+/* Tests_SRS_DNS_CACHE_01_028: [ dns_cache_clear shall remove all entries. ]*/
+TEST_FUNCTION(dns_cache_clear_removes_all_entries)
+{
+    // arrange
+    DNS_CACHE_ADDRESSES addresses = make_addresses(TEST_IP_V4);
+    init_cache();
+    ASSERT_ARE_EQUAL(int, 0, dns_cache_add("host", &addresses));
+    ASSERT_ARE_EQUAL(int, 0, dns_cache_add("other_host", NULL));
+
+    // act
+    dns_cache_clear();
+
+    // assert
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_MISS, (int)dns_cache_lookup("host", &addresses));
+    ASSERT_ARE_EQUAL(int, (int)DNS_CACHE_MISS, (int)dns_cache_lookup("other_host", &addresses));
+
+    // cleanup
+    dns_cache_deinit();
+}
+
+/* Tests_SRS_DNS_CACHE_01_027: [ If the cache is not initialized, dns_cache_clear shall return. ]*/
+TEST_FUNCTION(dns_cache_clear_when_not_initialized_returns)
+{
+    // act
+    dns_cache_clear();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+END_TEST_SUITE(dns_cache_unittests)
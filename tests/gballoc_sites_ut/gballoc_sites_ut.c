@@ -0,0 +1,476 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#if defined(GB_MEASURE_MEMORY_FOR_THIS)
+#undef GB_MEASURE_MEMORY_FOR_THIS
+#endif
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <string.h>
+#endif
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "testrunnerswitcher.h"
+#include "azure_c_shared_utility/lock.h"
+
+#ifndef SIZE_MAX
+#define SIZE_MAX ((size_t)~(size_t)0)
+#endif
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+static const LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4244;
+static const char TEST_FILE[] = "test_file.c";
+
+#define ENABLE_MOCKS
+
+#include "umock_c.h"
+#include "umock_c_prod.h"
+
+IMPLEMENT_UMOCK_C_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    MOCKABLE_FUNCTION(, void*, mock_malloc, size_t, size);
+    MOCKABLE_FUNCTION(, void*, mock_calloc, size_t, nmemb, size_t, size);
+    MOCKABLE_FUNCTION(, void*, mock_realloc, void*, ptr, size_t, size);
+    MOCKABLE_FUNCTION(, void, mock_free, void*, ptr);
+
+    MOCKABLE_FUNCTION(, LOCK_HANDLE, Lock_Init);
+    MOCKABLE_FUNCTION(, LOCK_RESULT, Lock_Deinit, LOCK_HANDLE, handle);
+    MOCKABLE_FUNCTION(, LOCK_RESULT, Lock, LOCK_HANDLE, handle);
+    MOCKABLE_FUNCTION(, LOCK_RESULT, Unlock, LOCK_HANDLE, handle);
+#ifdef __cplusplus
+}
+#endif
+
+#undef ENABLE_MOCKS
+
+static void* my_mock_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_mock_calloc(size_t nmemb, size_t size)
+{
+    return calloc(nmemb, size);
+}
+
+static void* my_mock_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+static void my_mock_free(void* ptr)
+{
+    free(ptr);
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+BEGIN_TEST_SUITE(GBAlloc_Sites_UnitTests)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    int result;
+
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_TYPE(LOCK_RESULT, LOCK_RESULT);
+
+    REGISTER_GLOBAL_MOCK_HOOK(mock_malloc, my_mock_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(mock_calloc, my_mock_calloc);
+    REGISTER_GLOBAL_MOCK_HOOK(mock_realloc, my_mock_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(mock_free, my_mock_free);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    gballoc_deinit();
+
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* gballoc_malloc_at */
+
+/* Tests_SRS_GBALLOC_01_075: [When built with GB_TRACK_ALLOCATION_SITES, each tracked allocation shall be counted in the counters of the site identified by file and line.] */
+/* Tests_SRS_GBALLOC_01_079: [gballoc_malloc_at, gballoc_calloc_at and gballoc_realloc_at shall behave as gballoc_malloc, gballoc_calloc and gballoc_realloc and count the allocation under the site given by file and line.] */
+TEST_FUNCTION(gballoc_malloc_at_allocates_the_site_record_on_the_first_allocation_of_a_site)
+{
+    // arrange
+    void* result;
+    GBALLOC_SITE_INFO site;
+    size_t total_site_count;
+    (void)gballoc_init();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument_size();
+    STRICT_EXPECTED_CALL(mock_malloc(42));
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument_size();
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = gballoc_malloc_at(42, TEST_FILE, 10);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, gballoc_getAllocationSites(&site, 1, &total_site_count));
+    ASSERT_ARE_EQUAL(size_t, 1, total_site_count);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_FILE, site.file);
+    ASSERT_ARE_EQUAL(int, 10, site.line);
+    ASSERT_ARE_EQUAL(size_t, 1, site.allocation_count);
+    ASSERT_ARE_EQUAL(size_t, 42, site.current_size);
+    ASSERT_ARE_EQUAL(size_t, 42, site.max_size);
+
+    // cleanup
+    gballoc_free(result);
+}
+
+/* Tests_SRS_GBALLOC_01_075: [When built with GB_TRACK_ALLOCATION_SITES, each tracked allocation shall be counted in the counters of the site identified by file and line.] */
+TEST_FUNCTION(gballoc_malloc_at_reuses_the_site_record_of_a_known_site)
+{
+    // arrange
+    void* first;
+    void* result;
+    GBALLOC_SITE_INFO site;
+    size_t total_site_count;
+    (void)gballoc_init();
+    first = gballoc_malloc_at(2, TEST_FILE, 10);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument_size();
+    STRICT_EXPECTED_CALL(mock_malloc(3));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = gballoc_malloc_at(3, TEST_FILE, 10);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, gballoc_getAllocationSites(&site, 1, &total_site_count));
+    ASSERT_ARE_EQUAL(size_t, 1, total_site_count);
+    ASSERT_ARE_EQUAL(size_t, 2, site.allocation_count);
+    ASSERT_ARE_EQUAL(size_t, 5, site.current_size);
+
+    // cleanup
+    gballoc_free(result);
+    gballoc_free(first);
+}
+
+/* Tests_SRS_GBALLOC_01_075: [When built with GB_TRACK_ALLOCATION_SITES, each tracked allocation shall be counted in the counters of the site identified by file and line.] */
+TEST_FUNCTION(gballoc_malloc_at_with_the_same_file_name_in_another_string_counts_one_site)
+{
+    // arrange
+    char other_file[sizeof(TEST_FILE)];
+    void* first;
+    void* second;
+    GBALLOC_SITE_INFO site;
+    size_t total_site_count;
+    (void)memcpy(other_file, TEST_FILE, sizeof(TEST_FILE));
+    (void)gballoc_init();
+
+    // act
+    first = gballoc_malloc_at(2, TEST_FILE, 10);
+    second = gballoc_malloc_at(3, other_file, 10);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, gballoc_getAllocationSites(&site, 1, &total_site_count));
+    ASSERT_ARE_EQUAL(size_t, 1, total_site_count);
+    ASSERT_ARE_EQUAL(size_t, 2, site.allocation_count);
+
+    // cleanup
+    gballoc_free(second);
+    gballoc_free(first);
+}
+
+/* Tests_SRS_GBALLOC_01_074: [When built with GB_TRACK_ALLOCATION_SITES, the allocations made by calling gballoc_malloc, gballoc_calloc and gballoc_realloc directly shall be counted under a site with a NULL file and line 0.] */
+TEST_FUNCTION(gballoc_malloc_counts_under_the_direct_site)
+{
+    // arrange
+    void* result;
+    GBALLOC_SITE_INFO site;
+    size_t total_site_count;
+    (void)gballoc_init();
+
+    // act
+    result = gballoc_malloc(42);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, gballoc_getAllocationSites(&site, 1, &total_site_count));
+    ASSERT_ARE_EQUAL(size_t, 1, total_site_count);
+    ASSERT_IS_NULL(site.file);
+    ASSERT_ARE_EQUAL(int, 0, site.line);
+    ASSERT_ARE_EQUAL(size_t, 42, site.current_size);
+
+    // cleanup
+    gballoc_free(result);
+}
+
+/* Tests_SRS_GBALLOC_01_075: [When built with GB_TRACK_ALLOCATION_SITES, each tracked allocation shall be counted in the counters of the site identified by file and line.] */
+TEST_FUNCTION(gballoc_calloc_at_counts_nmemb_times_size_under_its_site)
+{
+    // arrange
+    void* result;
+    GBALLOC_SITE_INFO site;
+    size_t total_site_count;
+    (void)gballoc_init();
+
+    // act
+    result = gballoc_calloc_at(3, 4, TEST_FILE, 20);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0, gballoc_getAllocationSites(&site, 1, &total_site_count));
+    ASSERT_ARE_EQUAL(int, 20, site.line);
+    ASSERT_ARE_EQUAL(size_t, 12, site.current_size);
+
+    // cleanup
+    gballoc_free(result);
+}
+
+/* gballoc_realloc_at */
+
+/* Tests_SRS_GBALLOC_01_076: [When built with GB_TRACK_ALLOCATION_SITES, a reallocated block shall be given back to the site that last sized it and be counted in the site of the reallocation.] */
+TEST_FUNCTION(gballoc_realloc_at_moves_the_block_to_the_site_of_the_reallocation)
+{
+    // arrange
+    void* result;
+    GBALLOC_SITE_INFO sites[2];
+    size_t total_site_count;
+    (void)gballoc_init();
+    result = gballoc_malloc_at(10, TEST_FILE, 10);
+
+    // act
+    result = gballoc_realloc_at(result, 100, TEST_FILE, 30);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0, gballoc_getAllocationSites(sites, 2, &total_site_count));
+    ASSERT_ARE_EQUAL(size_t, 2, total_site_count);
+    ASSERT_ARE_EQUAL(int, 30, sites[0].line);
+    ASSERT_ARE_EQUAL(size_t, 1, sites[0].allocation_count);
+    ASSERT_ARE_EQUAL(size_t, 100, sites[0].current_size);
+    ASSERT_ARE_EQUAL(size_t, 100, sites[0].max_size);
+    ASSERT_ARE_EQUAL(int, 10, sites[1].line);
+    ASSERT_ARE_EQUAL(size_t, 0, sites[1].current_size);
+    ASSERT_ARE_EQUAL(size_t, 10, sites[1].max_size);
+
+    // cleanup
+    gballoc_free(result);
+}
+
+/* gballoc_free */
+
+/* Tests_SRS_GBALLOC_01_077: [When built with GB_TRACK_ALLOCATION_SITES, gballoc_free shall decrease the memory used of the site that last sized the block.] */
+TEST_FUNCTION(gballoc_free_gives_the_size_back_to_the_site)
+{
+    // arrange
+    void* block;
+    GBALLOC_SITE_INFO site;
+    size_t total_site_count;
+    (void)gballoc_init();
+    block = gballoc_malloc_at(42, TEST_FILE, 10);
+
+    // act
+    gballoc_free(block);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, gballoc_getAllocationSites(&site, 1, &total_site_count));
+    ASSERT_ARE_EQUAL(size_t, 1, site.allocation_count);
+    ASSERT_ARE_EQUAL(size_t, 0, site.current_size);
+    ASSERT_ARE_EQUAL(size_t, 42, site.max_size);
+}
+
+/* gballoc_resetMetrics */
+
+/* Tests_SRS_GBALLOC_01_078: [When built with GB_TRACK_ALLOCATION_SITES, gballoc_resetMetrics shall reset the allocation count of each site and set its maximum to the memory it currently uses.] */
+TEST_FUNCTION(gballoc_resetMetrics_keeps_the_memory_in_use_of_the_sites)
+{
+    // arrange
+    void* kept;
+    void* freed;
+    GBALLOC_SITE_INFO site;
+    size_t total_site_count;
+    (void)gballoc_init();
+    kept = gballoc_malloc_at(10, TEST_FILE, 10);
+    freed = gballoc_malloc_at(20, TEST_FILE, 10);
+    gballoc_free(freed);
+
+    // act
+    gballoc_resetMetrics();
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, gballoc_getAllocationSites(&site, 1, &total_site_count));
+    ASSERT_ARE_EQUAL(size_t, 0, site.allocation_count);
+    ASSERT_ARE_EQUAL(size_t, 10, site.current_size);
+    ASSERT_ARE_EQUAL(size_t, 10, site.max_size);
+
+    // cleanup
+    gballoc_free(kept);
+}
+
+/* gballoc_deinit */
+
+/* Tests_SRS_GBALLOC_01_080: [gballoc_deinit shall free the site records.] */
+TEST_FUNCTION(gballoc_deinit_frees_the_site_records)
+{
+    // arrange
+    void* block;
+    size_t total_site_count;
+    (void)gballoc_init();
+    block = gballoc_malloc_at(10, TEST_FILE, 10);
+    gballoc_free(block);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_free(IGNORED_PTR_ARG))
+        .IgnoreArgument_ptr();
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+
+    // act
+    gballoc_deinit();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    (void)gballoc_init();
+    ASSERT_ARE_EQUAL(int, 0, gballoc_getAllocationSites(NULL, 0, &total_site_count));
+    ASSERT_ARE_EQUAL(size_t, 0, total_site_count);
+}
+
+/* gballoc_getAllocationSites */
+
+/* Tests_SRS_GBALLOC_01_081: [If total_site_count is NULL, or sites is NULL and site_count is not 0, gballoc_getAllocationSites shall fail and return a non-zero value.] */
+TEST_FUNCTION(gballoc_getAllocationSites_with_NULL_total_site_count_fails)
+{
+    // arrange
+    int result;
+    GBALLOC_SITE_INFO site;
+    (void)gballoc_init();
+
+    // act
+    result = gballoc_getAllocationSites(&site, 1, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_GBALLOC_01_081: [If total_site_count is NULL, or sites is NULL and site_count is not 0, gballoc_getAllocationSites shall fail and return a non-zero value.] */
+TEST_FUNCTION(gballoc_getAllocationSites_with_NULL_sites_and_non_zero_site_count_fails)
+{
+    // arrange
+    int result;
+    size_t total_site_count;
+    (void)gballoc_init();
+
+    // act
+    result = gballoc_getAllocationSites(NULL, 1, &total_site_count);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_GBALLOC_01_082: [If gballoc was not initialized or the lock cannot be acquired, gballoc_getAllocationSites shall fail and return a non-zero value.] */
+TEST_FUNCTION(gballoc_getAllocationSites_when_not_initialized_fails)
+{
+    // arrange
+    int result;
+    size_t total_site_count;
+
+    // act
+    result = gballoc_getAllocationSites(NULL, 0, &total_site_count);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_GBALLOC_01_082: [If gballoc was not initialized or the lock cannot be acquired, gballoc_getAllocationSites shall fail and return a non-zero value.] */
+TEST_FUNCTION(when_the_lock_fails_gballoc_getAllocationSites_fails)
+{
+    // arrange
+    int result;
+    size_t total_site_count;
+    (void)gballoc_init();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE))
+        .SetReturn(LOCK_ERROR);
+
+    // act
+    result = gballoc_getAllocationSites(NULL, 0, &total_site_count);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_GBALLOC_01_083: [gballoc_getAllocationSites shall fill sites with up to site_count sites ordered by decreasing max_size, set total_site_count to the number of sites and return 0.] */
+TEST_FUNCTION(gballoc_getAllocationSites_gives_the_sites_with_the_largest_max_size_first)
+{
+    // arrange
+    int result;
+    void* small_block;
+    void* large_block;
+    void* medium_block;
+    GBALLOC_SITE_INFO sites[2];
+    size_t total_site_count;
+    (void)gballoc_init();
+    small_block = gballoc_malloc_at(1, TEST_FILE, 1);
+    large_block = gballoc_malloc_at(100, TEST_FILE, 2);
+    medium_block = gballoc_malloc_at(10, TEST_FILE, 3);
+
+    // act
+    result = gballoc_getAllocationSites(sites, 2, &total_site_count);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 3, total_site_count);
+    ASSERT_ARE_EQUAL(int, 2, sites[0].line);
+    ASSERT_ARE_EQUAL(int, 3, sites[1].line);
+
+    // cleanup
+    gballoc_free(medium_block);
+    gballoc_free(large_block);
+    gballoc_free(small_block);
+}
+
+END_TEST_SUITE(GBAlloc_Sites_UnitTests)
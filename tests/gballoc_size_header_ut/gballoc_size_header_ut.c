@@ -0,0 +1,486 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#if defined(GB_MEASURE_MEMORY_FOR_THIS)
+#undef GB_MEASURE_MEMORY_FOR_THIS
+#endif
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <string.h>
+#endif
+#include "azure_c_shared_utility/optimize_size.h"
+#include "azure_c_shared_utility/gballoc.h"
+#include "testrunnerswitcher.h"
+#include "azure_c_shared_utility/lock.h"
+
+#ifndef SIZE_MAX
+#define SIZE_MAX ((size_t)~(size_t)0)
+#endif
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+#define ENABLE_MOCKS
+
+#include "umock_c.h"
+#include "umock_c_prod.h"
+
+IMPLEMENT_UMOCK_C_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    MOCKABLE_FUNCTION(, void*, mock_malloc, size_t, size);
+    MOCKABLE_FUNCTION(, void*, mock_calloc, size_t, nmemb, size_t, size);
+    MOCKABLE_FUNCTION(, void*, mock_realloc, void*, ptr, size_t, size);
+    MOCKABLE_FUNCTION(, void, mock_free, void*, ptr);
+
+    MOCKABLE_FUNCTION(, LOCK_HANDLE, Lock_Init);
+    MOCKABLE_FUNCTION(, LOCK_RESULT, Lock_Deinit, LOCK_HANDLE, handle);
+    MOCKABLE_FUNCTION(, LOCK_RESULT, Lock, LOCK_HANDLE, handle);
+    MOCKABLE_FUNCTION(, LOCK_RESULT, Unlock, LOCK_HANDLE, handle);
+#ifdef __cplusplus
+}
+#endif
+
+#undef ENABLE_MOCKS
+
+static void* my_mock_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_mock_calloc(size_t nmemb, size_t size)
+{
+    return calloc(nmemb, size);
+}
+
+static void* my_mock_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+static void my_mock_free(void* ptr)
+{
+    free(ptr);
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+BEGIN_TEST_SUITE(GBAlloc_SizeHeader_UnitTests)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    int result;
+
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_TYPE(LOCK_RESULT, LOCK_RESULT);
+
+    REGISTER_GLOBAL_MOCK_HOOK(mock_malloc, my_mock_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(mock_calloc, my_mock_calloc);
+    REGISTER_GLOBAL_MOCK_HOOK(mock_realloc, my_mock_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(mock_free, my_mock_free);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    umock_c_deinit();
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    gballoc_deinit();
+
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* gballoc_init */
+
+/* Tests_SRS_GBALLOC_01_052: [When built with GB_USE_SIZE_HEADER, gballoc_init shall not create a lock.] */
+/* Tests_SRS_GBALLOC_01_024: [gballoc_init shall initialize the gballoc module and return 0 upon success.] */
+TEST_FUNCTION(gballoc_init_does_not_create_a_lock)
+{
+    // arrange
+    int result;
+
+    // act
+    result = gballoc_init();
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getCurrentMemoryUsed());
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getMaximumMemoryUsed());
+}
+
+/* Tests_SRS_GBALLOC_01_025: [Init after Init shall fail and return a non-zero value.] */
+TEST_FUNCTION(gballoc_init_after_gballoc_init_fails)
+{
+    // arrange
+    int result;
+    (void)gballoc_init();
+
+    // act
+    result = gballoc_init();
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* gballoc_malloc */
+
+/* Tests_SRS_GBALLOC_01_053: [When built with GB_USE_SIZE_HEADER, gballoc_malloc shall allocate size bytes plus a header that records size and is placed in front of the returned block.] */
+/* Tests_SRS_GBALLOC_01_004: [If the underlying malloc call is successful, gb_malloc shall increment the total memory used with the amount indicated by size.] */
+TEST_FUNCTION(gballoc_malloc_allocates_a_header_and_counts_the_size)
+{
+    // arrange
+    void* result;
+    (void)gballoc_init();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument_size();
+
+    // act
+    result = gballoc_malloc(42);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 42, gballoc_getCurrentMemoryUsed());
+    ASSERT_ARE_EQUAL(size_t, 42, gballoc_getMaximumMemoryUsed());
+    ASSERT_ARE_EQUAL(size_t, 1, gballoc_getAllocationCount());
+
+    // cleanup
+    gballoc_free(result);
+}
+
+/* Tests_SRS_GBALLOC_01_012: [When the underlying malloc call fails, gballoc_malloc shall return NULL and size should not be counted towards total memory used.] */
+TEST_FUNCTION(when_malloc_fails_gballoc_malloc_fails_and_does_not_count_the_size)
+{
+    // arrange
+    void* result;
+    (void)gballoc_init();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument_size()
+        .SetReturn(NULL);
+
+    // act
+    result = gballoc_malloc(42);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getCurrentMemoryUsed());
+}
+
+/* gballoc_calloc */
+
+/* Tests_SRS_GBALLOC_01_054: [When built with GB_USE_SIZE_HEADER, gballoc_calloc shall allocate nmemb*size zeroed bytes plus the size header.] */
+/* Tests_SRS_GBALLOC_01_021: [If the underlying calloc call is successful, gballoc_calloc shall increment the total memory used with nmemb*size.] */
+TEST_FUNCTION(gballoc_calloc_returns_zeroed_memory_and_counts_the_size)
+{
+    // arrange
+    unsigned char* result;
+    size_t i;
+    (void)gballoc_init();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_calloc(1, IGNORED_NUM_ARG))
+        .IgnoreArgument_size();
+
+    // act
+    result = (unsigned char*)gballoc_calloc(3, 5);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    for (i = 0; i < 15; i++)
+    {
+        ASSERT_ARE_EQUAL(int, 0, (int)result[i]);
+    }
+    ASSERT_ARE_EQUAL(size_t, 15, gballoc_getCurrentMemoryUsed());
+
+    // cleanup
+    gballoc_free(result);
+}
+
+/* gballoc_realloc */
+
+/* Tests_SRS_GBALLOC_01_006: [If the underlying realloc call is successful, gballoc_realloc shall look up the size associated with the pointer ptr and decrease the total memory used with that size.] */
+/* Tests_SRS_GBALLOC_01_007: [If realloc is successful, gballoc_realloc shall also increment the total memory used value tracked by this module.] */
+TEST_FUNCTION(gballoc_realloc_keeps_the_content_and_updates_the_size)
+{
+    // arrange
+    unsigned char* block;
+    unsigned char* result;
+    (void)gballoc_init();
+    block = (unsigned char*)gballoc_malloc(4);
+    (void)memcpy(block, "abcd", 4);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .IgnoreAllArguments();
+
+    // act
+    result = (unsigned char*)gballoc_realloc(block, 100);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, memcmp(result, "abcd", 4));
+    ASSERT_ARE_EQUAL(size_t, 100, gballoc_getCurrentMemoryUsed());
+    ASSERT_ARE_EQUAL(size_t, 100, gballoc_getMaximumMemoryUsed());
+
+    // cleanup
+    gballoc_free(result);
+}
+
+/* Tests_SRS_GBALLOC_01_014: [When the underlying realloc call fails, gballoc_realloc shall return NULL and no change should be made to the counted total memory usage.] */
+TEST_FUNCTION(when_realloc_fails_gballoc_realloc_keeps_the_counted_size)
+{
+    // arrange
+    void* block;
+    void* result;
+    (void)gballoc_init();
+    block = gballoc_malloc(4);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .IgnoreAllArguments()
+        .SetReturn(NULL);
+
+    // act
+    result = gballoc_realloc(block, 100);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 4, gballoc_getCurrentMemoryUsed());
+
+    // cleanup
+    gballoc_free(block);
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getCurrentMemoryUsed());
+}
+
+/* Tests_SRS_GBALLOC_01_055: [When built with GB_USE_SIZE_HEADER and ptr does not carry a gballoc header, gballoc_realloc shall simply call realloc without any memory tracking being performed.] */
+TEST_FUNCTION(gballoc_realloc_of_a_block_allocated_before_init_is_not_tracked)
+{
+    // arrange
+    void* block;
+    void* result;
+    block = gballoc_calloc(1, 64);
+    (void)gballoc_init();
+
+    // act
+    result = gballoc_realloc(block, 128);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getCurrentMemoryUsed());
+
+    // cleanup
+    gballoc_free(result);
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getCurrentMemoryUsed());
+}
+
+/* gballoc_free */
+
+/* Tests_SRS_GBALLOC_01_057: [When built with GB_USE_SIZE_HEADER, gballoc_free shall read the size from the header in front of ptr, decrease the total memory used with it and free the header and block in one call.] */
+TEST_FUNCTION(gballoc_free_frees_the_header_and_decreases_the_size)
+{
+    // arrange
+    void* block1;
+    void* block2;
+    (void)gballoc_init();
+    block1 = gballoc_malloc(10);
+    block2 = gballoc_malloc(20);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_free(IGNORED_PTR_ARG));
+
+    // act
+    gballoc_free(block1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 20, gballoc_getCurrentMemoryUsed());
+    ASSERT_ARE_EQUAL(size_t, 30, gballoc_getMaximumMemoryUsed());
+
+    // cleanup
+    gballoc_free(block2);
+}
+
+/* Tests_SRS_GBALLOC_01_056: [When built with GB_USE_SIZE_HEADER and ptr does not carry a gballoc header, gballoc_free shall simply call free.] */
+TEST_FUNCTION(gballoc_free_of_a_block_allocated_before_init_calls_free)
+{
+    // arrange
+    void* block = gballoc_malloc(16);
+    (void)gballoc_init();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_free(block));
+
+    // act
+    gballoc_free(block);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getCurrentMemoryUsed());
+}
+
+TEST_FUNCTION(gballoc_free_of_a_tracked_block_after_deinit_frees_the_header)
+{
+    // arrange
+    void* block;
+    (void)gballoc_init();
+    block = gballoc_malloc(16);
+    gballoc_deinit();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_free(IGNORED_PTR_ARG));
+
+    // act
+    gballoc_free(block);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* gballoc_getMaximumMemoryUsed */
+
+/* Tests_SRS_GBALLOC_01_058: [When built with GB_USE_SIZE_HEADER, the maximum shall be updated each time a shard reaches a new high and may therefore under-report a peak reached while other shards were shrinking.] */
+TEST_FUNCTION(gballoc_getMaximumMemoryUsed_returns_the_peak_for_many_blocks)
+{
+    // arrange
+    void* blocks[100];
+    size_t i;
+    (void)gballoc_init();
+
+    for (i = 0; i < 100; i++)
+    {
+        blocks[i] = gballoc_malloc(8);
+    }
+    for (i = 0; i < 100; i++)
+    {
+        gballoc_free(blocks[i]);
+    }
+
+    // act
+    size_t result = gballoc_getMaximumMemoryUsed();
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 800, result);
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getCurrentMemoryUsed());
+    ASSERT_ARE_EQUAL(size_t, 100, gballoc_getAllocationCount());
+}
+
+/* Tests_SRS_GBALLOC_01_038: [If gballoc was not initialized gballoc_getMaximumMemoryUsed shall return MAX_INT_SIZE.] */
+TEST_FUNCTION(gballoc_getMaximumMemoryUsed_without_init_returns_SIZE_MAX)
+{
+    // act
+    size_t result = gballoc_getMaximumMemoryUsed();
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, SIZE_MAX, result);
+}
+
+/* gballoc_resetMetrics */
+
+/* Tests_SRS_GBALLOC_07_008: [ gballoc_resetMetrics shall reset the total allocation size, max allocation size and number of allocation to zero. ] */
+TEST_FUNCTION(gballoc_resetMetrics_resets_all_the_shards)
+{
+    // arrange
+    void* block;
+    (void)gballoc_init();
+    block = gballoc_malloc(10);
+    gballoc_free(block);
+
+    // act
+    gballoc_resetMetrics();
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getCurrentMemoryUsed());
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getMaximumMemoryUsed());
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getAllocationCount());
+}
+
+/* gballoc_getStatistics */
+
+/* Tests_SRS_GBALLOC_01_091: [When built with GB_USE_SIZE_HEADER, gballoc_getStatistics shall return the sum of the per shard statistics.] */
+/* Tests_SRS_GBALLOC_01_085: [Each allocation served by the underlying heap shall be counted in the entry of allocation_size_histogram of its size, the new size of a reallocation included.] */
+/* Tests_SRS_GBALLOC_01_086: [Each successful reallocation of a tracked block shall be counted in realloc_count, and in realloc_grow_count with its growth in realloc_growth_histogram or in realloc_shrink_count when the size changes.] */
+TEST_FUNCTION(gballoc_getStatistics_sums_the_statistics_of_all_shards)
+{
+    // arrange
+    int result;
+    void* blocks[8];
+    size_t i;
+    GBALLOC_STATISTICS statistics;
+    (void)gballoc_init();
+    for (i = 0; i < 8; i++)
+    {
+        blocks[i] = gballoc_malloc(16);
+    }
+    blocks[0] = gballoc_realloc(blocks[0], 20);
+
+    // act
+    result = gballoc_getStatistics(&statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 8, statistics.allocation_size_histogram[5]);
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.realloc_count);
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.realloc_grow_count);
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.realloc_growth_histogram[3]);
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.realloc_in_place_count + statistics.realloc_moved_count);
+
+    // cleanup
+    for (i = 0; i < 8; i++)
+    {
+        gballoc_free(blocks[i]);
+    }
+}
+
+/* Tests_SRS_GBALLOC_01_089: [If gballoc was not initialized or the lock cannot be acquired, gballoc_getStatistics shall fail and return a non-zero value.] */
+TEST_FUNCTION(gballoc_getStatistics_without_init_fails)
+{
+    // arrange
+    int result;
+    GBALLOC_STATISTICS statistics;
+
+    // act
+    result = gballoc_getStatistics(&statistics);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+END_TEST_SUITE(GBAlloc_SizeHeader_UnitTests)
@@ -27,6 +27,10 @@ static void* TEST_REALLOC_PTR = (void*)0x4245;
 
 #define OVERHEAD_SIZE    4096
 static const LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4244;
+static GBALLOC_ALLOCATOR test_allocator;
+/* the first budget left to the application */
+#define TEST_BUDGET 4
+static void* TEST_BUDGET_CONTEXT = (void*)0x4246;
 
 #define ENABLE_MOCKS
 
@@ -42,6 +46,8 @@ extern "C" {
     MOCKABLE_FUNCTION(, void*, mock_calloc, size_t, nmemb, size_t, size);
     MOCKABLE_FUNCTION(, void*, mock_realloc, void*, ptr, size_t, size);
     MOCKABLE_FUNCTION(, void, mock_free, void*, ptr);
+    MOCKABLE_FUNCTION(, void, mock_free_sized, void*, ptr, size_t, size);
+    MOCKABLE_FUNCTION(, void, test_on_budget_exceeded, void*, context, int, budget, size_t, size);
 
     MOCKABLE_FUNCTION(, LOCK_HANDLE, Lock_Init);
     MOCKABLE_FUNCTION(, LOCK_RESULT, Lock_Deinit, LOCK_HANDLE, handle);
@@ -77,6 +83,12 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_GLOBAL_MOCK_RETURN(mock_realloc, TEST_ALLOC_PTR1);
     REGISTER_GLOBAL_MOCK_RETURN(mock_calloc, TEST_ALLOC_PTR1);
 
+    test_allocator.malloc_function = mock_malloc;
+    test_allocator.calloc_function = mock_calloc;
+    test_allocator.realloc_function = mock_realloc;
+    test_allocator.free_function = mock_free;
+    test_allocator.free_sized_function = mock_free_sized;
+
     REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
     REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
     REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
@@ -101,6 +113,9 @@ TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
 TEST_FUNCTION_CLEANUP(TestMethodCleanup)
 {
     gballoc_deinit();
+    (void)gballoc_set_allocator(NULL);
+    (void)gballoc_budget_set_limit(TEST_BUDGET, 0, NULL, NULL);
+    gballoc_budget_end(GBALLOC_BUDGET_NONE);
 
     TEST_MUTEX_RELEASE(g_testByTest);
 }
@@ -1744,4 +1759,800 @@ TEST_FUNCTION(gballoc_resetMetrics_success)
     free(allocation);
 }
 
+/* gballoc_getStatistics */
+
+/* Tests_SRS_GBALLOC_01_088: [If statistics is NULL, gballoc_getStatistics shall fail and return a non-zero value.] */
+TEST_FUNCTION(gballoc_getStatistics_with_NULL_statistics_fails)
+{
+    // arrange
+    int result;
+    gballoc_init();
+    umock_c_reset_all_calls();
+
+    // act
+    result = gballoc_getStatistics(NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_GBALLOC_01_089: [If gballoc was not initialized or the lock cannot be acquired, gballoc_getStatistics shall fail and return a non-zero value.] */
+TEST_FUNCTION(gballoc_getStatistics_without_init_fails)
+{
+    // arrange
+    int result;
+    GBALLOC_STATISTICS statistics;
+
+    // act
+    result = gballoc_getStatistics(&statistics);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_GBALLOC_01_089: [If gballoc was not initialized or the lock cannot be acquired, gballoc_getStatistics shall fail and return a non-zero value.] */
+TEST_FUNCTION(gballoc_getStatistics_lock_fail)
+{
+    // arrange
+    int result;
+    GBALLOC_STATISTICS statistics;
+    gballoc_init();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE))
+        .SetReturn(LOCK_ERROR);
+
+    // act
+    result = gballoc_getStatistics(&statistics);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_GBALLOC_01_085: [Each allocation served by the underlying heap shall be counted in the entry of allocation_size_histogram of its size, the new size of a reallocation included.] */
+/* Tests_SRS_GBALLOC_01_092: [gballoc_getStatistics shall copy the statistics gathered since gballoc_init or gballoc_resetMetrics to statistics and return 0.] */
+TEST_FUNCTION(gballoc_malloc_counts_the_size_in_the_histogram)
+{
+    // arrange
+    int result;
+    void* block;
+    void* allocation;
+    GBALLOC_STATISTICS statistics;
+    gballoc_init();
+    allocation = malloc(OVERHEAD_SIZE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    EXPECTED_CALL(mock_malloc(0))
+        .SetReturn(allocation);
+    STRICT_EXPECTED_CALL(mock_malloc(5));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    block = gballoc_malloc(5);
+
+    // act
+    result = gballoc_getStatistics(&statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.allocation_size_histogram[3]);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.realloc_count);
+
+    // cleanup
+    gballoc_free(block);
+    free(allocation);
+}
+
+/* Tests_SRS_GBALLOC_01_086: [Each successful reallocation of a tracked block shall be counted in realloc_count, and in realloc_grow_count with its growth in realloc_growth_histogram or in realloc_shrink_count when the size changes.] */
+/* Tests_SRS_GBALLOC_01_087: [A reallocation that returns a different block shall be counted in realloc_moved_count and add the smaller of the old and new size to realloc_moved_bytes, any other in realloc_in_place_count.] */
+TEST_FUNCTION(gballoc_realloc_that_moves_the_block_counts_a_moving_growth)
+{
+    // arrange
+    void* result;
+    void* allocation;
+    GBALLOC_STATISTICS statistics;
+    gballoc_init();
+    allocation = malloc(OVERHEAD_SIZE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    EXPECTED_CALL(mock_malloc(0))
+        .SetReturn(allocation);
+    STRICT_EXPECTED_CALL(mock_realloc(NULL, 1));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mock_realloc(TEST_ALLOC_PTR1, 2))
+        .SetReturn(TEST_ALLOC_PTR2);
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    result = gballoc_realloc(NULL, 1);
+
+    // act
+    result = gballoc_realloc(result, 2);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, gballoc_getStatistics(&statistics));
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.allocation_size_histogram[1]);
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.allocation_size_histogram[2]);
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.realloc_count);
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.realloc_grow_count);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.realloc_shrink_count);
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.realloc_growth_histogram[1]);
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.realloc_moved_count);
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.realloc_moved_bytes);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.realloc_in_place_count);
+
+    // cleanup
+    gballoc_free(result);
+    free(allocation);
+}
+
+/* Tests_SRS_GBALLOC_01_086: [Each successful reallocation of a tracked block shall be counted in realloc_count, and in realloc_grow_count with its growth in realloc_growth_histogram or in realloc_shrink_count when the size changes.] */
+/* Tests_SRS_GBALLOC_01_087: [A reallocation that returns a different block shall be counted in realloc_moved_count and add the smaller of the old and new size to realloc_moved_bytes, any other in realloc_in_place_count.] */
+TEST_FUNCTION(gballoc_realloc_in_place_counts_an_in_place_shrink)
+{
+    // arrange
+    void* result;
+    void* allocation;
+    GBALLOC_STATISTICS statistics;
+    gballoc_init();
+    allocation = malloc(OVERHEAD_SIZE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    EXPECTED_CALL(mock_malloc(0))
+        .SetReturn(allocation);
+    STRICT_EXPECTED_CALL(mock_realloc(NULL, 8));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mock_realloc(TEST_ALLOC_PTR1, 4));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    result = gballoc_realloc(NULL, 8);
+
+    // act
+    result = gballoc_realloc(result, 4);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, gballoc_getStatistics(&statistics));
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.realloc_count);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.realloc_grow_count);
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.realloc_shrink_count);
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.realloc_in_place_count);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.realloc_moved_count);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.realloc_moved_bytes);
+
+    // cleanup
+    gballoc_free(result);
+    free(allocation);
+}
+
+/* Tests_SRS_GBALLOC_01_090: [gballoc_resetMetrics shall also reset the statistics.] */
+TEST_FUNCTION(gballoc_resetMetrics_resets_the_statistics)
+{
+    // arrange
+    void* block;
+    void* allocation;
+    GBALLOC_STATISTICS statistics;
+    gballoc_init();
+    allocation = malloc(OVERHEAD_SIZE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    EXPECTED_CALL(mock_malloc(0))
+        .SetReturn(allocation);
+    STRICT_EXPECTED_CALL(mock_malloc(5));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    block = gballoc_malloc(5);
+
+    // act
+    gballoc_resetMetrics();
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, gballoc_getStatistics(&statistics));
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.allocation_size_histogram[3]);
+
+    // cleanup
+    gballoc_free(block);
+    free(allocation);
+}
+
+/* gballoc_arena_begin */
+
+/* Tests_SRS_GBALLOC_01_060: [gballoc_arena_begin shall start a new arena scope for the calling thread, nested in the current one if any, and return 0.] */
+TEST_FUNCTION(gballoc_arena_begin_succeeds)
+{
+    // arrange
+    int result;
+    void* arena_memory = malloc(OVERHEAD_SIZE);
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .SetReturn(arena_memory);
+
+    // act
+    result = gballoc_arena_begin(256);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    gballoc_arena_end();
+    free(arena_memory);
+}
+
+/* Tests_SRS_GBALLOC_01_061: [If allocating the arena fails, gballoc_arena_begin shall return a non-zero value.] */
+TEST_FUNCTION(when_allocating_the_arena_fails_gballoc_arena_begin_fails)
+{
+    // arrange
+    int result;
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = gballoc_arena_begin(256);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_GBALLOC_01_062: [Inside an arena scope gballoc_malloc shall carve the allocation out of the current block of the innermost arena of the calling thread without calling the underlying heap.] */
+/* Tests_SRS_GBALLOC_01_063: [When the current block cannot hold the allocation, a new block of block_size bytes, or larger if the allocation does not fit in block_size, shall be allocated with the underlying heap.] */
+TEST_FUNCTION(gballoc_malloc_inside_an_arena_scope_allocates_one_block_for_several_allocations)
+{
+    // arrange
+    unsigned char* first;
+    unsigned char* second;
+    void* arena_memory = malloc(OVERHEAD_SIZE);
+    unsigned char* block_memory = (unsigned char*)malloc(OVERHEAD_SIZE);
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .SetReturn(arena_memory);
+    (void)gballoc_arena_begin(256);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .SetReturn(block_memory);
+
+    // act
+    first = (unsigned char*)gballoc_malloc(10);
+    second = (unsigned char*)gballoc_malloc(20);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE((first > block_memory) && (first < block_memory + OVERHEAD_SIZE));
+    ASSERT_IS_TRUE((second > first + 10) && (second < block_memory + OVERHEAD_SIZE));
+
+    ///cleanup
+    gballoc_arena_end();
+    free(block_memory);
+    free(arena_memory);
+}
+
+/* Tests_SRS_GBALLOC_01_064: [If allocating a new block fails, the allocation shall return NULL.] */
+TEST_FUNCTION(when_allocating_an_arena_block_fails_gballoc_malloc_fails)
+{
+    // arrange
+    void* result;
+    void* arena_memory = malloc(OVERHEAD_SIZE);
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .SetReturn(arena_memory);
+    (void)gballoc_arena_begin(256);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = gballoc_malloc(10);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    gballoc_arena_end();
+    free(arena_memory);
+}
+
+/* Tests_SRS_GBALLOC_01_066: [When ptr is the last allocation of its arena block and the block has room for size bytes, gballoc_realloc shall resize it in place and return ptr.] */
+TEST_FUNCTION(gballoc_realloc_of_the_last_arena_allocation_grows_in_place)
+{
+    // arrange
+    void* allocation;
+    void* result;
+    void* arena_memory = malloc(OVERHEAD_SIZE);
+    void* block_memory = malloc(OVERHEAD_SIZE);
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .SetReturn(arena_memory);
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .SetReturn(block_memory);
+    (void)gballoc_arena_begin(256);
+    allocation = gballoc_malloc(10);
+    umock_c_reset_all_calls();
+
+    // act
+    result = gballoc_realloc(allocation, 100);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, allocation, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    gballoc_arena_end();
+    free(block_memory);
+    free(arena_memory);
+}
+
+/* Tests_SRS_GBALLOC_01_067: [Otherwise, when ptr was handed out by an arena scope, gballoc_realloc shall allocate size bytes from that same arena and copy the contents of ptr into it.] */
+TEST_FUNCTION(gballoc_realloc_of_an_earlier_arena_allocation_copies_it)
+{
+    // arrange
+    unsigned char* allocation;
+    unsigned char* result;
+    void* arena_memory = malloc(OVERHEAD_SIZE);
+    void* block_memory = malloc(OVERHEAD_SIZE);
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .SetReturn(arena_memory);
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .SetReturn(block_memory);
+    (void)gballoc_arena_begin(256);
+    allocation = (unsigned char*)gballoc_malloc(2);
+    allocation[0] = 0x42;
+    allocation[1] = 0x43;
+    (void)gballoc_malloc(10);
+    umock_c_reset_all_calls();
+
+    // act
+    result = (unsigned char*)gballoc_realloc(allocation, 20);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, allocation, result);
+    ASSERT_ARE_EQUAL(int, 0x42, (int)result[0]);
+    ASSERT_ARE_EQUAL(int, 0x43, (int)result[1]);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    gballoc_arena_end();
+    free(block_memory);
+    free(arena_memory);
+}
+
+/* Tests_SRS_GBALLOC_01_068: [When ptr was handed out by an arena scope of the calling thread, gballoc_free shall do nothing, the memory is given back by gballoc_arena_end.] */
+/* Tests_SRS_GBALLOC_01_069: [gballoc_arena_end shall free all the blocks of the innermost arena of the calling thread and make the enclosing scope, if any, the current one.] */
+TEST_FUNCTION(gballoc_free_inside_an_arena_scope_is_deferred_to_gballoc_arena_end)
+{
+    // arrange
+    void* allocation;
+    void* arena_memory = malloc(OVERHEAD_SIZE);
+    void* block_memory = malloc(OVERHEAD_SIZE);
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .SetReturn(arena_memory);
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .SetReturn(block_memory);
+    (void)gballoc_arena_begin(256);
+    allocation = gballoc_malloc(10);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_free(block_memory));
+    STRICT_EXPECTED_CALL(mock_free(arena_memory));
+
+    // act
+    gballoc_free(allocation);
+    gballoc_arena_end();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    free(block_memory);
+    free(arena_memory);
+}
+
+/* Tests_SRS_GBALLOC_01_072: [Blocks that were not handed out by an arena scope of the calling thread shall be handled by the underlying heap, also inside a scope.] */
+TEST_FUNCTION(gballoc_free_inside_an_arena_scope_frees_heap_blocks)
+{
+    // arrange
+    void* arena_memory = malloc(OVERHEAD_SIZE);
+
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .SetReturn(arena_memory);
+    (void)gballoc_arena_begin(256);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_free(TEST_ALLOC_PTR2));
+
+    // act
+    gballoc_free(TEST_ALLOC_PTR2);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    gballoc_arena_end();
+    free(arena_memory);
+}
+
+/* Tests_SRS_GBALLOC_01_070: [If the calling thread has no arena scope, gballoc_arena_end shall do nothing.] */
+TEST_FUNCTION(gballoc_arena_end_without_a_scope_does_nothing)
+{
+    // arrange
+
+    // act
+    gballoc_arena_end();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* gballoc_set_allocator */
+
+/* Tests_SRS_GBALLOC_01_095: [gballoc_set_allocator shall make gballoc allocate and free the blocks it gets from the heap, including its own bookkeeping, with the functions of allocator and return 0.] */
+/* Tests_SRS_GBALLOC_01_094: [When the block is not tracked by gballoc and free_sized_function is not NULL, gballoc_free_sized shall call free_sized_function with ptr and size, otherwise it shall call free_function.] */
+TEST_FUNCTION(gballoc_set_allocator_makes_gballoc_free_sized_call_free_sized_function)
+{
+    // arrange
+    int result;
+
+    // act
+    result = gballoc_set_allocator(&test_allocator);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    STRICT_EXPECTED_CALL(mock_free_sized((void*)0x4242, 10));
+    gballoc_free_sized((void*)0x4242, 10);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_GBALLOC_01_093: [gballoc_free_sized shall behave as gballoc_free.] */
+/* Tests_SRS_GBALLOC_01_094: [When the block is not tracked by gballoc and free_sized_function is not NULL, gballoc_free_sized shall call free_sized_function with ptr and size, otherwise it shall call free_function.] */
+TEST_FUNCTION(gballoc_free_sized_without_free_sized_function_calls_free)
+{
+    // arrange
+    STRICT_EXPECTED_CALL(mock_free((void*)0x4242));
+
+    // act
+    gballoc_free_sized((void*)0x4242, 10);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_GBALLOC_01_098: [If allocator is NULL, gballoc_set_allocator shall restore the malloc, calloc, realloc and free functions of the C runtime and return 0.] */
+TEST_FUNCTION(gballoc_set_allocator_with_NULL_restores_the_default_allocator)
+{
+    // arrange
+    int result;
+    ASSERT_ARE_EQUAL(int, 0, gballoc_set_allocator(&test_allocator));
+
+    // act
+    result = gballoc_set_allocator(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    STRICT_EXPECTED_CALL(mock_free((void*)0x4242));
+    gballoc_free_sized((void*)0x4242, 10);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_GBALLOC_01_099: [If any of malloc_function, calloc_function, realloc_function and free_function is NULL, gballoc_set_allocator shall fail and return a non-zero value.] */
+TEST_FUNCTION(gballoc_set_allocator_with_NULL_malloc_function_fails)
+{
+    // arrange
+    int result;
+    GBALLOC_ALLOCATOR allocator = test_allocator;
+    allocator.malloc_function = NULL;
+
+    // act
+    result = gballoc_set_allocator(&allocator);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    STRICT_EXPECTED_CALL(mock_free((void*)0x4242));
+    gballoc_free_sized((void*)0x4242, 10);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_GBALLOC_01_099: [If any of malloc_function, calloc_function, realloc_function and free_function is NULL, gballoc_set_allocator shall fail and return a non-zero value.] */
+TEST_FUNCTION(gballoc_set_allocator_with_NULL_free_function_fails)
+{
+    // arrange
+    int result;
+    GBALLOC_ALLOCATOR allocator = test_allocator;
+    allocator.free_function = NULL;
+
+    // act
+    result = gballoc_set_allocator(&allocator);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_GBALLOC_01_097: [If gballoc is initialized or the calling thread has an arena scope, gballoc_set_allocator shall fail and return a non-zero value.] */
+TEST_FUNCTION(gballoc_set_allocator_while_initialized_fails)
+{
+    // arrange
+    int result;
+    gballoc_init();
+    umock_c_reset_all_calls();
+
+    // act
+    result = gballoc_set_allocator(&test_allocator);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_GBALLOC_01_097: [If gballoc is initialized or the calling thread has an arena scope, gballoc_set_allocator shall fail and return a non-zero value.] */
+TEST_FUNCTION(gballoc_set_allocator_inside_an_arena_scope_fails)
+{
+    // arrange
+    int result;
+    void* arena_memory = malloc(OVERHEAD_SIZE);
+    STRICT_EXPECTED_CALL(mock_malloc(IGNORED_NUM_ARG))
+        .SetReturn(arena_memory);
+    ASSERT_ARE_EQUAL(int, 0, gballoc_arena_begin(256));
+    umock_c_reset_all_calls();
+
+    // act
+    result = gballoc_set_allocator(&test_allocator);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    gballoc_arena_end();
+    free(arena_memory);
+}
+
+/* Tests_SRS_GBALLOC_01_095: [gballoc_set_allocator shall make gballoc allocate and free the blocks it gets from the heap, including its own bookkeeping, with the functions of allocator and return 0.] */
+/* Tests_SRS_GBALLOC_01_096: [When the block is tracked, gballoc_free and gballoc_free_sized shall give free_sized_function the size recorded by gballoc, including the size of its own bookkeeping.] */
+TEST_FUNCTION(gballoc_free_of_a_tracked_block_gives_its_size_to_free_sized_function)
+{
+    // arrange
+    void* block;
+    void* allocation;
+    ASSERT_ARE_EQUAL(int, 0, gballoc_set_allocator(&test_allocator));
+    gballoc_init();
+    allocation = malloc(OVERHEAD_SIZE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    EXPECTED_CALL(mock_malloc(0))
+        .SetReturn(allocation);
+    STRICT_EXPECTED_CALL(mock_malloc(5));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    block = gballoc_malloc(5);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mock_free_sized(TEST_ALLOC_PTR1, 5));
+    STRICT_EXPECTED_CALL(mock_free_sized(allocation, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    gballoc_free(block);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_getCurrentMemoryUsed());
+
+    // cleanup
+    free(allocation);
+}
+
+/* gballoc_budget_set_limit */
+
+/* Tests_SRS_GBALLOC_01_101: [If budget is not between 1 and GBALLOC_BUDGET_COUNT - 1, gballoc_budget_set_limit shall fail and return a non-zero value.] */
+TEST_FUNCTION(gballoc_budget_set_limit_with_budget_0_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = gballoc_budget_set_limit(GBALLOC_BUDGET_NONE, 100, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_GBALLOC_01_101: [If budget is not between 1 and GBALLOC_BUDGET_COUNT - 1, gballoc_budget_set_limit shall fail and return a non-zero value.] */
+TEST_FUNCTION(gballoc_budget_set_limit_with_budget_GBALLOC_BUDGET_COUNT_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = gballoc_budget_set_limit(GBALLOC_BUDGET_COUNT, 100, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* gballoc_budget_begin */
+
+/* Tests_SRS_GBALLOC_01_102: [gballoc_budget_begin shall make budget the budget of the allocations of the calling thread and return the budget it had before.] */
+/* Tests_SRS_GBALLOC_01_108: [gballoc_budget_end shall make previous_budget the budget of the allocations of the calling thread.] */
+TEST_FUNCTION(gballoc_budget_begin_returns_the_previous_budget)
+{
+    // arrange
+    int first_previous_budget;
+    int second_previous_budget;
+
+    // act
+    first_previous_budget = gballoc_budget_begin(TEST_BUDGET);
+    second_previous_budget = gballoc_budget_begin(GBALLOC_BUDGET_HTTP_RESPONSE);
+    gballoc_budget_end(second_previous_budget);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, GBALLOC_BUDGET_NONE, first_previous_budget);
+    ASSERT_ARE_EQUAL(int, TEST_BUDGET, second_previous_budget);
+    ASSERT_ARE_EQUAL(int, TEST_BUDGET, gballoc_budget_begin(TEST_BUDGET));
+}
+
+/* Tests_SRS_GBALLOC_01_103: [If budget is not between 0 and GBALLOC_BUDGET_COUNT - 1, gballoc_budget_begin shall leave the budget of the calling thread unchanged.] */
+TEST_FUNCTION(gballoc_budget_begin_with_an_invalid_budget_leaves_the_budget_unchanged)
+{
+    // arrange
+    int previous_budget;
+    (void)gballoc_budget_begin(TEST_BUDGET);
+
+    // act
+    previous_budget = gballoc_budget_begin(-1);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, TEST_BUDGET, previous_budget);
+    ASSERT_ARE_EQUAL(int, TEST_BUDGET, gballoc_budget_begin(GBALLOC_BUDGET_NONE));
+}
+
+/* Tests_SRS_GBALLOC_01_100: [gballoc_budget_set_limit shall set the limit of budget to max_size bytes, 0 meaning no limit, and the callback called when an allocation fails because of it, then return 0.] */
+/* Tests_SRS_GBALLOC_01_109: [gballoc_budget_get_used shall return the bytes of the tracked blocks counted in budget that are not freed yet.] */
+/* Tests_SRS_GBALLOC_01_107: [Freeing a block shall give its size back to the budget it was allocated or last reallocated in.] */
+TEST_FUNCTION(gballoc_malloc_in_a_budget_scope_counts_the_block_in_the_budget)
+{
+    // arrange
+    void* block;
+    void* allocation;
+    int previous_budget;
+    gballoc_init();
+    allocation = malloc(OVERHEAD_SIZE);
+    ASSERT_ARE_EQUAL(int, 0, gballoc_budget_set_limit(TEST_BUDGET, 100, test_on_budget_exceeded, TEST_BUDGET_CONTEXT));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    EXPECTED_CALL(mock_malloc(0))
+        .SetReturn(allocation);
+    STRICT_EXPECTED_CALL(mock_malloc(10));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    previous_budget = gballoc_budget_begin(TEST_BUDGET);
+    block = gballoc_malloc(10);
+    gballoc_budget_end(previous_budget);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_ALLOC_PTR1, block);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 10, gballoc_budget_get_used(TEST_BUDGET));
+    gballoc_free(block);
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_budget_get_used(TEST_BUDGET));
+
+    // cleanup
+    free(allocation);
+}
+
+/* Tests_SRS_GBALLOC_01_104: [An allocation that would take the memory used of its budget over the limit shall fail, and on_budget_exceeded shall be called with the budget and the size of the allocation.] */
+TEST_FUNCTION(gballoc_malloc_over_the_limit_of_the_budget_fails_and_calls_on_budget_exceeded)
+{
+    // arrange
+    void* block;
+    gballoc_init();
+    ASSERT_ARE_EQUAL(int, 0, gballoc_budget_set_limit(TEST_BUDGET, 8, test_on_budget_exceeded, TEST_BUDGET_CONTEXT));
+    (void)gballoc_budget_begin(TEST_BUDGET);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(test_on_budget_exceeded(TEST_BUDGET_CONTEXT, TEST_BUDGET, 10));
+
+    // act
+    block = gballoc_malloc(10);
+
+    // assert
+    ASSERT_IS_NULL(block);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_budget_get_used(TEST_BUDGET));
+}
+
+/* Tests_SRS_GBALLOC_01_105: [A reallocation shall count the new size in the budget of the calling thread before giving the old size back to the budget of the block, since both blocks may exist at once.] */
+TEST_FUNCTION(gballoc_realloc_in_a_budget_scope_moves_the_block_to_the_budget)
+{
+    // arrange
+    void* block;
+    void* allocation;
+    int previous_budget;
+    gballoc_init();
+    allocation = malloc(OVERHEAD_SIZE);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(mock_malloc(0))
+        .SetReturn(allocation);
+    block = gballoc_malloc(10);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(mock_realloc(TEST_ALLOC_PTR1, 20))
+        .SetReturn(TEST_REALLOC_PTR);
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    previous_budget = gballoc_budget_begin(TEST_BUDGET);
+    block = gballoc_realloc(block, 20);
+    gballoc_budget_end(previous_budget);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_REALLOC_PTR, block);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 20, gballoc_budget_get_used(TEST_BUDGET));
+
+    // cleanup
+    gballoc_free(block);
+    free(allocation);
+}
+
+/* Tests_SRS_GBALLOC_01_106: [gballoc_init shall set the memory used of all the budgets to 0.] */
+TEST_FUNCTION(gballoc_init_resets_the_memory_used_of_the_budgets)
+{
+    // arrange
+    void* allocation;
+    gballoc_init();
+    allocation = malloc(OVERHEAD_SIZE);
+    (void)gballoc_budget_begin(TEST_BUDGET);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(mock_malloc(0))
+        .SetReturn(allocation);
+    (void)gballoc_malloc(10);
+    gballoc_deinit();
+
+    // act
+    gballoc_init();
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, gballoc_budget_get_used(TEST_BUDGET));
+
+    // cleanup
+    free(allocation);
+}
+
+/* Tests_SRS_GBALLOC_01_110: [If budget is not between 1 and GBALLOC_BUDGET_COUNT - 1, gballoc_budget_get_used shall return 0.] */
+TEST_FUNCTION(gballoc_budget_get_used_with_an_invalid_budget_returns_0)
+{
+    // arrange
+    size_t result;
+
+    // act
+    result = gballoc_budget_get_used(GBALLOC_BUDGET_COUNT);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+}
+
 END_TEST_SUITE(GBAlloc_UnitTests)
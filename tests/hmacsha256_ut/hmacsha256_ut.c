@@ -30,6 +30,8 @@ void real_free(void* ptr)
 #include "azure_c_shared_utility/strings.h"
 #undef ENABLE_MOCKS
 #include "azure_c_shared_utility/hmacsha256.h"
+#include "azure_c_shared_utility/constbuffer.h"
+#include "azure_c_shared_utility/constbuffer_array.h"
 
 static TEST_MUTEX_HANDLE g_testByTest;
 
@@ -37,6 +39,9 @@ TEST_DEFINE_ENUM_TYPE(HMACSHA256_RESULT, HMACSHA256_RESULT_VALUES);
 
 static BUFFER_HANDLE hash;
 
+static const unsigned char testKey[] = "key";
+static const unsigned char expectedTestPayloadHash[32] = { 108, 7, 130, 47, 104, 233, 39, 188, 126, 122, 134, 187, 63, 19, 52, 120, 172, 7, 43, 25, 133, 60, 92, 217, 59, 59, 69, 116, 85, 104, 55, 224 };
+
 DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
 
 static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
@@ -163,4 +168,614 @@ TEST_FUNCTION(HMACSHA256_ComputeHash_Succeeds)
     ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hash), expectedHash, 8));
 }
 
+/* HMACSHA256_KeyContext_Create */
+
+TEST_FUNCTION(HMACSHA256_KeyContext_Create_With_NULL_Key_Fails)
+{
+    // arrange
+    static const unsigned char key[] = "key";
+
+    // act
+    HMACSHA256_KEY_CONTEXT_HANDLE keyContext = HMACSHA256_KeyContext_Create(NULL, sizeof(key) - 1);
+
+    // assert
+    ASSERT_IS_NULL(keyContext);
+}
+
+TEST_FUNCTION(HMACSHA256_KeyContext_Create_With_Zero_Key_Buffer_Size_Fails)
+{
+    // arrange
+    static const unsigned char key[] = "key";
+
+    // act
+    HMACSHA256_KEY_CONTEXT_HANDLE keyContext = HMACSHA256_KeyContext_Create(key, 0);
+
+    // assert
+    ASSERT_IS_NULL(keyContext);
+}
+
+TEST_FUNCTION(when_allocating_fails_HMACSHA256_KeyContext_Create_fails)
+{
+    // arrange
+    static const unsigned char key[] = "key";
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    HMACSHA256_KEY_CONTEXT_HANDLE keyContext = HMACSHA256_KeyContext_Create(key, sizeof(key) - 1);
+
+    // assert
+    ASSERT_IS_NULL(keyContext);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* HMACSHA256_ComputeHashWithKeyContext */
+
+TEST_FUNCTION(HMACSHA256_ComputeHashWithKeyContext_With_NULL_KeyContext_Fails)
+{
+    // arrange
+    static const unsigned char buffer[] = "testPayload";
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_ComputeHashWithKeyContext(NULL, buffer, sizeof(buffer) - 1, hash);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashWithKeyContext_With_NULL_Payload_Fails)
+{
+    // arrange
+    static const unsigned char key[] = "key";
+    static const unsigned char buffer[] = "testPayload";
+    HMACSHA256_KEY_CONTEXT_HANDLE keyContext = HMACSHA256_KeyContext_Create(key, sizeof(key) - 1);
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_ComputeHashWithKeyContext(keyContext, NULL, sizeof(buffer) - 1, hash);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+
+    // cleanup
+    HMACSHA256_KeyContext_Destroy(keyContext);
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashWithKeyContext_With_Zero_Payload_Buffer_Size_Fails)
+{
+    // arrange
+    static const unsigned char key[] = "key";
+    static const unsigned char buffer[] = "testPayload";
+    HMACSHA256_KEY_CONTEXT_HANDLE keyContext = HMACSHA256_KeyContext_Create(key, sizeof(key) - 1);
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_ComputeHashWithKeyContext(keyContext, buffer, 0, hash);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+
+    // cleanup
+    HMACSHA256_KeyContext_Destroy(keyContext);
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashWithKeyContext_With_NULL_Hash_Fails)
+{
+    // arrange
+    static const unsigned char key[] = "key";
+    static const unsigned char buffer[] = "testPayload";
+    HMACSHA256_KEY_CONTEXT_HANDLE keyContext = HMACSHA256_KeyContext_Create(key, sizeof(key) - 1);
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_ComputeHashWithKeyContext(keyContext, buffer, sizeof(buffer) - 1, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+
+    // cleanup
+    HMACSHA256_KeyContext_Destroy(keyContext);
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashWithKeyContext_Succeeds)
+{
+    // arrange
+    static const unsigned char key[] = "key";
+    static const unsigned char buffer[] = "testPayload";
+    unsigned char expectedHash[32] = { 108, 7, 130, 47, 104, 233, 39, 188, 126, 122, 134, 187, 63, 19, 52, 120, 172, 7, 43, 25, 133, 60, 92, 217, 59, 59, 69, 116, 85, 104, 55, 224 };
+    HMACSHA256_KEY_CONTEXT_HANDLE keyContext = HMACSHA256_KeyContext_Create(key, sizeof(key) - 1);
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_ComputeHashWithKeyContext(keyContext, buffer, sizeof(buffer) - 1, hash);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_OK, result);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hash), expectedHash, sizeof(expectedHash)));
+
+    // cleanup
+    HMACSHA256_KeyContext_Destroy(keyContext);
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashWithKeyContext_can_be_called_again_with_the_same_key_context)
+{
+    // arrange
+    static const unsigned char key[] = "key";
+    static const unsigned char buffer1[] = "anotherPayload";
+    static const unsigned char buffer2[] = "testPayload";
+    unsigned char expectedHash[32] = { 108, 7, 130, 47, 104, 233, 39, 188, 126, 122, 134, 187, 63, 19, 52, 120, 172, 7, 43, 25, 133, 60, 92, 217, 59, 59, 69, 116, 85, 104, 55, 224 };
+    HMACSHA256_KEY_CONTEXT_HANDLE keyContext = HMACSHA256_KeyContext_Create(key, sizeof(key) - 1);
+    BUFFER_HANDLE firstHash = BUFFER_new();
+    (void)HMACSHA256_ComputeHashWithKeyContext(keyContext, buffer1, sizeof(buffer1) - 1, firstHash);
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_ComputeHashWithKeyContext(keyContext, buffer2, sizeof(buffer2) - 1, hash);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_OK, result);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hash), expectedHash, sizeof(expectedHash)));
+
+    // cleanup
+    BUFFER_delete(firstHash);
+    HMACSHA256_KeyContext_Destroy(keyContext);
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashWithKeyContext_with_a_key_longer_than_a_block_matches_HMACSHA256_ComputeHash)
+{
+    // arrange
+    unsigned char key[100];
+    static const unsigned char buffer[] = "testPayload";
+    BUFFER_HANDLE expectedHash = BUFFER_new();
+    HMACSHA256_KEY_CONTEXT_HANDLE keyContext;
+    HMACSHA256_RESULT result;
+    size_t i;
+
+    for (i = 0; i < sizeof(key); i++)
+    {
+        key[i] = (unsigned char)i;
+    }
+    (void)HMACSHA256_ComputeHash(key, sizeof(key), buffer, sizeof(buffer) - 1, expectedHash);
+    keyContext = HMACSHA256_KeyContext_Create(key, sizeof(key));
+
+    // act
+    result = HMACSHA256_ComputeHashWithKeyContext(keyContext, buffer, sizeof(buffer) - 1, hash);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_OK, result);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hash), BUFFER_u_char(expectedHash), 32));
+
+    // cleanup
+    BUFFER_delete(expectedHash);
+    HMACSHA256_KeyContext_Destroy(keyContext);
+}
+
+/* HMACSHA256_KeyContext_Destroy */
+
+TEST_FUNCTION(HMACSHA256_KeyContext_Destroy_With_NULL_does_nothing)
+{
+    // arrange
+    umock_c_reset_all_calls();
+
+    // act
+    HMACSHA256_KeyContext_Destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* HMACSHA256_Stream_Init */
+
+TEST_FUNCTION(HMACSHA256_Stream_Init_With_NULL_Stream_Fails)
+{
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_Stream_Init(NULL, testKey, sizeof(testKey) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+}
+
+TEST_FUNCTION(HMACSHA256_Stream_Init_With_NULL_Key_Fails)
+{
+    // arrange
+    HMACSHA256_STREAM stream;
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_Stream_Init(&stream, NULL, 3);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+}
+
+TEST_FUNCTION(HMACSHA256_Stream_Init_With_Zero_Key_Buffer_Size_Fails)
+{
+    // arrange
+    HMACSHA256_STREAM stream;
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_Stream_Init(&stream, testKey, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+}
+
+TEST_FUNCTION(HMACSHA256_Stream_Init_does_not_allocate)
+{
+    // arrange
+    HMACSHA256_STREAM stream;
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_Stream_Init(&stream, testKey, sizeof(testKey) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* HMACSHA256_Stream_InitWithKeyContext */
+
+TEST_FUNCTION(HMACSHA256_Stream_InitWithKeyContext_With_NULL_Stream_Fails)
+{
+    // arrange
+    HMACSHA256_KEY_CONTEXT_HANDLE keyContext = HMACSHA256_KeyContext_Create(testKey, sizeof(testKey) - 1);
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_Stream_InitWithKeyContext(NULL, keyContext);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+
+    // cleanup
+    HMACSHA256_KeyContext_Destroy(keyContext);
+}
+
+TEST_FUNCTION(HMACSHA256_Stream_InitWithKeyContext_With_NULL_KeyContext_Fails)
+{
+    // arrange
+    HMACSHA256_STREAM stream;
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_Stream_InitWithKeyContext(&stream, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+}
+
+/* HMACSHA256_Stream_Update */
+
+TEST_FUNCTION(HMACSHA256_Stream_Update_With_NULL_Stream_Fails)
+{
+    // arrange
+    static const unsigned char buffer[] = "testPayload";
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_Stream_Update(NULL, buffer, sizeof(buffer) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+}
+
+TEST_FUNCTION(HMACSHA256_Stream_Update_With_NULL_Data_And_Non_Zero_Size_Fails)
+{
+    // arrange
+    HMACSHA256_STREAM stream;
+    (void)HMACSHA256_Stream_Init(&stream, testKey, sizeof(testKey) - 1);
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_Stream_Update(&stream, NULL, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+}
+
+TEST_FUNCTION(HMACSHA256_Stream_Update_With_No_Data_Succeeds)
+{
+    // arrange
+    HMACSHA256_STREAM stream;
+    (void)HMACSHA256_Stream_Init(&stream, testKey, sizeof(testKey) - 1);
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_Stream_Update(&stream, NULL, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_OK, result);
+}
+
+/* HMACSHA256_Stream_Final */
+
+TEST_FUNCTION(HMACSHA256_Stream_Final_With_NULL_Stream_Fails)
+{
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_Stream_Final(NULL, hash);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+}
+
+TEST_FUNCTION(HMACSHA256_Stream_Final_With_NULL_Hash_Fails)
+{
+    // arrange
+    HMACSHA256_STREAM stream;
+    (void)HMACSHA256_Stream_Init(&stream, testKey, sizeof(testKey) - 1);
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_Stream_Final(&stream, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+}
+
+TEST_FUNCTION(HMACSHA256_Stream_of_a_payload_in_pieces_matches_HMACSHA256_ComputeHash)
+{
+    // arrange
+    static const unsigned char buffer1[] = "test";
+    static const unsigned char buffer2[] = "Payload";
+    HMACSHA256_STREAM stream;
+    HMACSHA256_RESULT result;
+    (void)HMACSHA256_Stream_Init(&stream, testKey, sizeof(testKey) - 1);
+
+    // act
+    (void)HMACSHA256_Stream_Update(&stream, buffer1, sizeof(buffer1) - 1);
+    (void)HMACSHA256_Stream_Update(&stream, buffer2, sizeof(buffer2) - 1);
+    result = HMACSHA256_Stream_Final(&stream, hash);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_OK, result);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hash), expectedTestPayloadHash, sizeof(expectedTestPayloadHash)));
+}
+
+TEST_FUNCTION(HMACSHA256_Stream_initialized_from_a_key_context_matches_HMACSHA256_ComputeHash)
+{
+    // arrange
+    static const unsigned char buffer1[] = "testPay";
+    static const unsigned char buffer2[] = "load";
+    HMACSHA256_KEY_CONTEXT_HANDLE keyContext = HMACSHA256_KeyContext_Create(testKey, sizeof(testKey) - 1);
+    HMACSHA256_STREAM stream;
+    HMACSHA256_RESULT result;
+
+    // act
+    result = HMACSHA256_Stream_InitWithKeyContext(&stream, keyContext);
+    (void)HMACSHA256_Stream_Update(&stream, buffer1, sizeof(buffer1) - 1);
+    (void)HMACSHA256_Stream_Update(&stream, buffer2, sizeof(buffer2) - 1);
+    (void)HMACSHA256_Stream_Final(&stream, hash);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_OK, result);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hash), expectedTestPayloadHash, sizeof(expectedTestPayloadHash)));
+
+    // cleanup
+    HMACSHA256_KeyContext_Destroy(keyContext);
+}
+
+/* HMACSHA256_ComputeHashOfConstBufferArray */
+
+TEST_FUNCTION(HMACSHA256_ComputeHashOfConstBufferArray_With_NULL_Key_Fails)
+{
+    // arrange
+    CONSTBUFFER_ARRAY_HANDLE payload = constbuffer_array_create_empty();
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_ComputeHashOfConstBufferArray(NULL, 3, payload, hash);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+
+    // cleanup
+    constbuffer_array_dec_ref(payload);
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashOfConstBufferArray_With_Zero_Key_Buffer_Size_Fails)
+{
+    // arrange
+    CONSTBUFFER_ARRAY_HANDLE payload = constbuffer_array_create_empty();
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_ComputeHashOfConstBufferArray(testKey, 0, payload, hash);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+
+    // cleanup
+    constbuffer_array_dec_ref(payload);
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashOfConstBufferArray_With_NULL_Payload_Fails)
+{
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_ComputeHashOfConstBufferArray(testKey, sizeof(testKey) - 1, NULL, hash);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashOfConstBufferArray_With_NULL_Hash_Fails)
+{
+    // arrange
+    CONSTBUFFER_ARRAY_HANDLE payload = constbuffer_array_create_empty();
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_ComputeHashOfConstBufferArray(testKey, sizeof(testKey) - 1, payload, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+
+    // cleanup
+    constbuffer_array_dec_ref(payload);
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashOfConstBufferArray_matches_HMACSHA256_ComputeHash_of_the_concatenated_buffers)
+{
+    // arrange
+    static const unsigned char buffer1[] = "te";
+    static const unsigned char buffer2[] = "stPay";
+    static const unsigned char buffer3[] = "load";
+    CONSTBUFFER_HANDLE buffers[4];
+    CONSTBUFFER_ARRAY_HANDLE payload;
+    HMACSHA256_RESULT result;
+    buffers[0] = CONSTBUFFER_Create(buffer1, sizeof(buffer1) - 1);
+    buffers[1] = CONSTBUFFER_Create(NULL, 0);
+    buffers[2] = CONSTBUFFER_Create(buffer2, sizeof(buffer2) - 1);
+    buffers[3] = CONSTBUFFER_Create(buffer3, sizeof(buffer3) - 1);
+    payload = constbuffer_array_create(buffers, 4);
+
+    // act
+    result = HMACSHA256_ComputeHashOfConstBufferArray(testKey, sizeof(testKey) - 1, payload, hash);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_OK, result);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hash), expectedTestPayloadHash, sizeof(expectedTestPayloadHash)));
+
+    // cleanup
+    constbuffer_array_dec_ref(payload);
+    CONSTBUFFER_DecRef(buffers[0]);
+    CONSTBUFFER_DecRef(buffers[1]);
+    CONSTBUFFER_DecRef(buffers[2]);
+    CONSTBUFFER_DecRef(buffers[3]);
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashOfConstBufferArray_of_an_empty_array_succeeds)
+{
+    // arrange
+    CONSTBUFFER_ARRAY_HANDLE payload = constbuffer_array_create_empty();
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_ComputeHashOfConstBufferArray(testKey, sizeof(testKey) - 1, payload, hash);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_OK, result);
+    ASSERT_ARE_EQUAL(size_t, 32, BUFFER_length(hash));
+
+    // cleanup
+    constbuffer_array_dec_ref(payload);
+}
+
+/* HMACSHA256_ComputeHashBatch */
+
+TEST_FUNCTION(HMACSHA256_ComputeHashBatch_With_NULL_Items_Fails)
+{
+    // arrange
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_ComputeHashBatch(NULL, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashBatch_With_Zero_Items_Fails)
+{
+    // arrange
+    static const unsigned char buffer[] = "testPayload";
+    HMACSHA256_BATCH_ITEM item = { testKey, sizeof(testKey) - 1, buffer, sizeof(buffer) - 1, NULL };
+    item.hash = hash;
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_ComputeHashBatch(&item, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashBatch_With_An_Item_Without_Hash_Fails_Without_Hashing_Any_Item)
+{
+    // arrange
+    static const unsigned char buffer[] = "testPayload";
+    HMACSHA256_BATCH_ITEM items[2] = {
+        { testKey, sizeof(testKey) - 1, buffer, sizeof(buffer) - 1, NULL },
+        { testKey, sizeof(testKey) - 1, buffer, sizeof(buffer) - 1, NULL }
+    };
+    items[0].hash = hash;
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_ComputeHashBatch(items, 2);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(size_t, 0, BUFFER_length(hash));
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashBatch_With_An_Item_With_Zero_Key_Buffer_Size_Fails)
+{
+    // arrange
+    static const unsigned char buffer[] = "testPayload";
+    HMACSHA256_BATCH_ITEM item = { testKey, 0, buffer, sizeof(buffer) - 1, NULL };
+    item.hash = hash;
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_ComputeHashBatch(&item, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_INVALID_ARG, result);
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashBatch_Succeeds)
+{
+    // arrange
+    static const unsigned char buffer[] = "testPayload";
+    HMACSHA256_BATCH_ITEM item = { testKey, sizeof(testKey) - 1, buffer, sizeof(buffer) - 1, NULL };
+    item.hash = hash;
+
+    // act
+    HMACSHA256_RESULT result = HMACSHA256_ComputeHashBatch(&item, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_OK, result);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(hash), expectedTestPayloadHash, sizeof(expectedTestPayloadHash)));
+}
+
+static void assert_batch_matches_HMACSHA256_ComputeHash(void)
+{
+    /* more items than lanes, with keys longer than a block and payloads spanning blocks */
+    unsigned char data[300];
+    HMACSHA256_BATCH_ITEM items[19];
+    BUFFER_HANDLE expectedHash = BUFFER_new();
+    HMACSHA256_RESULT result;
+    size_t i;
+
+    for (i = 0; i < sizeof(data); i++)
+    {
+        data[i] = (unsigned char)(i * 7);
+    }
+    for (i = 0; i < 19; i++)
+    {
+        items[i].key = data + i;
+        items[i].keyLen = 1 + (i * 7);
+        items[i].payload = data + (19 - i);
+        items[i].payloadLen = 1 + (i * 15);
+        items[i].hash = BUFFER_new();
+    }
+
+    // act
+    result = HMACSHA256_ComputeHashBatch(items, 19);
+
+    // assert
+    ASSERT_ARE_EQUAL(HMACSHA256_RESULT, HMACSHA256_OK, result);
+    for (i = 0; i < 19; i++)
+    {
+        (void)HMACSHA256_ComputeHash(items[i].key, items[i].keyLen, items[i].payload, items[i].payloadLen, expectedHash);
+        ASSERT_ARE_EQUAL(size_t, 32, BUFFER_length(items[i].hash));
+        ASSERT_ARE_EQUAL(int, 0, memcmp(BUFFER_u_char(items[i].hash), BUFFER_u_char(expectedHash), 32));
+    }
+
+    // cleanup
+    for (i = 0; i < 19; i++)
+    {
+        BUFFER_delete(items[i].hash);
+    }
+    BUFFER_delete(expectedHash);
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashBatch_matches_HMACSHA256_ComputeHash)
+{
+    assert_batch_matches_HMACSHA256_ComputeHash();
+}
+
+TEST_FUNCTION(HMACSHA256_ComputeHashBatch_without_hardware_acceleration_matches_HMACSHA256_ComputeHash)
+{
+    // arrange
+    (void)SHA256UseHardwareAcceleration(0);
+
+    assert_batch_matches_HMACSHA256_ComputeHash();
+
+    // cleanup
+    (void)SHA256UseHardwareAcceleration(1);
+}
+
 END_TEST_SUITE(HMACSHA256_UnitTests)
@@ -53,6 +53,11 @@ extern "C"
 #include "azure_c_shared_utility/socketio.h"
 #include "azure_c_shared_utility/strings.h"
 #include "azure_c_shared_utility/base64.h"
+#include "azure_c_shared_utility/tickcounter.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/shared_util_options.h"
 
 IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
@@ -61,6 +66,7 @@ IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
 #define TEST_SOCKETIO_INTERFACE_DESCRIPTION     (const IO_INTERFACE_DESCRIPTION*)0x4242
 #define TEST_IO_HANDLE                          (XIO_HANDLE)0x4243
 #define TEST_STRING_HANDLE                      (STRING_HANDLE)0x4244
+#define TEST_TICK_COUNTER_HANDLE                (TICK_COUNTER_HANDLE)0x4245
 
 MOCK_FUNCTION_WITH_CODE(, void, test_on_io_open_complete, void*, context, IO_OPEN_RESULT, open_result)
 MOCK_FUNCTION_END();
@@ -225,6 +231,15 @@ static int my_xio_open(XIO_HANDLE xio, ON_IO_OPEN_COMPLETE on_io_open_complete,
     return 0;
 }
 
+static tickcounter_ms_t g_current_ms;
+
+static int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = g_current_ms;
+    return 0;
+}
+
 static int my_xio_close(XIO_HANDLE xio, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
 {
     (void)xio;
@@ -309,6 +324,8 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_HOOK(OptionHandler_Create, my_OptionHandler_Create);
     REGISTER_GLOBAL_MOCK_HOOK(xio_open, my_xio_open);
     REGISTER_GLOBAL_MOCK_HOOK(xio_close, my_xio_close);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
     REGISTER_GLOBAL_MOCK_RETURN(OptionHandler_Create, TEST_OPTION_HANDLER);
     REGISTER_GLOBAL_MOCK_RETURN(socketio_get_interface_description, TEST_SOCKETIO_INTERFACE_DESCRIPTION);
     REGISTER_GLOBAL_MOCK_RETURN(xio_create, TEST_IO_HANDLE);
@@ -330,6 +347,8 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(ON_IO_CLOSE_COMPLETE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_SEND_COMPLETE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(STRING_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(tickcounter_ms_t*, void*);
     REGISTER_UMOCKC_PAIRED_CREATE_DESTROY_CALLS(xio_create, xio_destroy);
 }
 
@@ -348,6 +367,7 @@ TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
     }
 
     umock_c_reset_all_calls();
+    g_current_ms = 0;
 }
 
 TEST_FUNCTION_CLEANUP(TestMethodCleanup)
@@ -1426,6 +1446,126 @@ TEST_FUNCTION(http_proxy_io_dowork_when_closed_does_nothing)
     http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
 }
 
+/* http_proxy_io_dowork_ex */
+
+/* Tests_SRS_HTTP_PROXY_IO_01_104: [ Otherwise http_proxy_io_dowork_ex shall call xio_dowork_ex on the underlying IO, passing next_deadline_us down to it. ]*/
+/* Tests_SRS_HTTP_PROXY_IO_01_105: [ made_progress shall be set to true if a callback was made or the underlying IO made progress, false otherwise. ]*/
+/* Tests_SRS_HTTP_PROXY_IO_01_107: [ On success http_proxy_io_dowork_ex shall return 0. ]*/
+TEST_FUNCTION(http_proxy_io_dowork_ex_calls_the_underlying_IO_dowork_ex)
+{
+    // arrange
+    CONCRETE_IO_HANDLE http_io;
+    bool made_progress = false;
+    bool underlying_progress = true;
+    uint64_t next_deadline_us;
+    int result;
+
+    http_io = http_proxy_io_get_interface_description()->concrete_io_create((void*)&default_http_proxy_io_config);
+    (void)http_proxy_io_get_interface_description()->concrete_io_open(http_io, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_io_open_complete_context, (const unsigned char*)connect_response, sizeof(connect_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_dowork_ex(TEST_IO_HANDLE, IGNORED_PTR_ARG, &next_deadline_us))
+        .CopyOutArgumentBuffer_made_progress(&underlying_progress, sizeof(underlying_progress));
+
+    // act
+    result = http_proxy_io_get_interface_description()->concrete_io_dowork_ex(http_io, &made_progress, &next_deadline_us);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(made_progress);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
+}
+
+/* Tests_SRS_HTTP_PROXY_IO_01_102: [ If http_proxy_io, made_progress or next_deadline_us is NULL, http_proxy_io_dowork_ex shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(http_proxy_io_dowork_ex_with_NULL_handle_fails)
+{
+    // arrange
+    bool made_progress;
+    uint64_t next_deadline_us;
+    int result;
+
+    // act
+    result = http_proxy_io_get_interface_description()->concrete_io_dowork_ex(NULL, &made_progress, &next_deadline_us);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_HTTP_PROXY_IO_01_103: [ If the IO is not open, http_proxy_io_dowork_ex shall set made_progress to false, set next_deadline_us to XIO_NO_DEADLINE and return 0. ]*/
+TEST_FUNCTION(http_proxy_io_dowork_ex_when_not_open_reports_no_progress)
+{
+    // arrange
+    CONCRETE_IO_HANDLE http_io;
+    bool made_progress = true;
+    uint64_t next_deadline_us = 0;
+    int result;
+
+    http_io = http_proxy_io_get_interface_description()->concrete_io_create((void*)&default_http_proxy_io_config);
+    umock_c_reset_all_calls();
+
+    // act
+    result = http_proxy_io_get_interface_description()->concrete_io_dowork_ex(http_io, &made_progress, &next_deadline_us);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(made_progress);
+    ASSERT_IS_TRUE(next_deadline_us == XIO_NO_DEADLINE);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
+}
+
+/* http_proxy_io_get_pollable_handle */
+
+/* Tests_SRS_HTTP_PROXY_IO_01_109: [ http_proxy_io_get_pollable_handle shall call xio_get_pollable_handle on the underlying IO, passing pollable_handle and wanted_events down to it. ]*/
+/* Tests_SRS_HTTP_PROXY_IO_01_111: [ On success http_proxy_io_get_pollable_handle shall return 0. ]*/
+TEST_FUNCTION(http_proxy_io_get_pollable_handle_calls_the_underlying_IO)
+{
+    // arrange
+    CONCRETE_IO_HANDLE http_io;
+    intptr_t pollable_handle;
+    unsigned int wanted_events;
+    int result;
+
+    http_io = http_proxy_io_get_interface_description()->concrete_io_create((void*)&default_http_proxy_io_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_get_pollable_handle(TEST_IO_HANDLE, &pollable_handle, &wanted_events));
+
+    // act
+    result = http_proxy_io_get_interface_description()->concrete_io_get_pollable_handle(http_io, &pollable_handle, &wanted_events);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
+}
+
+/* Tests_SRS_HTTP_PROXY_IO_01_108: [ If http_proxy_io, pollable_handle or wanted_events is NULL, http_proxy_io_get_pollable_handle shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(http_proxy_io_get_pollable_handle_with_NULL_handle_fails)
+{
+    // arrange
+    intptr_t pollable_handle;
+    unsigned int wanted_events;
+    int result;
+
+    // act
+    result = http_proxy_io_get_interface_description()->concrete_io_get_pollable_handle(NULL, &pollable_handle, &wanted_events);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 /* http_proxy_io_set_option */
 
 /* Tests_SRS_HTTP_PROXY_IO_01_040: [ If any of the arguments http_proxy_io or option_name is NULL, http_proxy_io_set_option shall return a non-zero value. ]*/
@@ -1488,6 +1628,30 @@ TEST_FUNCTION(when_the_underlying_IO_handles_the_option_http_proxy_io_set_option
     http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
 }
 
+/* Tests_SRS_HTTP_PROXY_IO_01_112: [ OPTION_HTTP_PROXY_TUNNEL_POOL shall set the HTTP_PROXY_TUNNEL_POOL_HANDLE given as value as the tunnel pool used by the following opens, NULL meaning none. ]*/
+TEST_FUNCTION(http_proxy_io_set_option_with_the_tunnel_pool_option_does_not_pass_it_to_the_underlying_IO)
+{
+    // arrange
+    CONCRETE_IO_HANDLE http_io;
+    HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool;
+    int result;
+
+    tunnel_pool = http_proxy_tunnel_pool_create(1, 1000);
+    http_io = http_proxy_io_get_interface_description()->concrete_io_create((void*)&default_http_proxy_io_config);
+    umock_c_reset_all_calls();
+
+    // act
+    result = http_proxy_io_get_interface_description()->concrete_io_setoption(http_io, OPTION_HTTP_PROXY_TUNNEL_POOL, tunnel_pool);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
+    http_proxy_tunnel_pool_destroy(tunnel_pool);
+}
+
 /* Tests_SRS_HTTP_PROXY_IO_01_044: [ if xio_setoption fails, http_proxy_io_set_option shall return a non-zero value. ]*/
 TEST_FUNCTION(when_the_underlying_xio_setoption_fails_http_proxy_io_set_option_also_fails)
 {
@@ -2228,7 +2392,7 @@ TEST_FUNCTION(on_underlying_io_open_complete_in_CLOSING_indicates_an_error)
 
 /* on_underlying_io_bytes_received */
 
-/* Tests_SRS_HTTP_PROXY_IO_01_065: [ When bytes are received and the response to the CONNECT request was not yet received, the bytes shall be accumulated until a double new-line is detected. ]*/
+/* Tests_SRS_HTTP_PROXY_IO_01_065: [ When bytes are received and the response to the CONNECT request was not yet received, the bytes shall be scanned as they arrive until a double new-line is detected. ]*/
 TEST_FUNCTION(on_underlying_io_bytes_received_with_1_byte_buffers_the_received_bytes)
 {
     // arrange
@@ -2239,7 +2403,6 @@ TEST_FUNCTION(on_underlying_io_bytes_received_with_1_byte_buffers_the_received_b
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
 
     // act
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)connect_response, 1);
@@ -2251,7 +2414,7 @@ TEST_FUNCTION(on_underlying_io_bytes_received_with_1_byte_buffers_the_received_b
     http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
 }
 
-/* Tests_SRS_HTTP_PROXY_IO_01_065: [ When bytes are received and the response to the CONNECT request was not yet received, the bytes shall be accumulated until a double new-line is detected. ]*/
+/* Tests_SRS_HTTP_PROXY_IO_01_065: [ When bytes are received and the response to the CONNECT request was not yet received, the bytes shall be scanned as they arrive until a double new-line is detected. ]*/
 TEST_FUNCTION(on_underlying_io_bytes_received_with_2_times_1_byte_buffers_the_received_bytes)
 {
     // arrange
@@ -2263,7 +2426,6 @@ TEST_FUNCTION(on_underlying_io_bytes_received_with_2_times_1_byte_buffers_the_re
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)connect_response, 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
 
     // act
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)connect_response + 1, 1);
@@ -2289,7 +2451,6 @@ TEST_FUNCTION(on_underlying_io_bytes_received_with_a_good_reply_indicates_OPEN_O
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_OK));
 
     // act
@@ -2314,7 +2475,6 @@ TEST_FUNCTION(on_underlying_io_bytes_received_with_a_good_reply_in_2_chunks_indi
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)connect_response, sizeof(connect_response) - 2);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_OK));
 
     // act
@@ -2327,24 +2487,54 @@ TEST_FUNCTION(on_underlying_io_bytes_received_with_a_good_reply_in_2_chunks_indi
     http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
 }
 
-/* Tests_SRS_HTTP_PROXY_IO_01_067: [ If allocating memory for the buffered bytes fails, the on_open_complete callback shall be triggered with IO_OPEN_ERROR, passing also the on_open_complete_context argument as context. ]*/
-TEST_FUNCTION(when_allocating_memory_for_cached_data_in_on_underlying_io_bytes_an_error_is_triggered)
+/* Tests_SRS_HTTP_PROXY_IO_01_101: [ If the status line of the CONNECT response is longer than HTTP_PROXY_IO_MAX_STATUS_LINE_LENGTH bytes, the on_open_complete callback shall be triggered with IO_OPEN_ERROR, passing also the on_open_complete_context argument as context. ]*/
+TEST_FUNCTION(on_underlying_io_bytes_received_with_a_too_long_status_line_indicates_an_error)
 {
     // arrange
     CONCRETE_IO_HANDLE http_io;
+    char long_status_line[300];
 
+    (void)memset(long_status_line, 'x', sizeof(long_status_line));
+    (void)memcpy(long_status_line, "HTTP/1.1 200 ", 13);
     http_io = http_proxy_io_get_interface_description()->concrete_io_create((void*)&http_proxy_io_config_with_username);
     (void)http_proxy_io_get_interface_description()->concrete_io_open(http_io, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-        .SetReturn(NULL);
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
     STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_ERROR));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)connect_response, sizeof(connect_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)long_status_line, sizeof(long_status_line));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
+}
+
+/* Tests_SRS_HTTP_PROXY_IO_01_065: [ When bytes are received and the response to the CONNECT request was not yet received, the bytes shall be scanned as they arrive until a double new-line is detected. ]*/
+/* Tests_SRS_HTTP_PROXY_IO_01_072: [ Any bytes that are extra (not consumed by the CONNECT response), shall be indicated as received by calling the on_bytes_received callback and passing the on_bytes_received_context as context argument. ]*/
+TEST_FUNCTION(on_underlying_io_bytes_received_with_headers_and_the_double_new_line_split_across_chunks_indicates_OPEN_OK)
+{
+    // arrange
+    CONCRETE_IO_HANDLE http_io;
+    static const char connect_response_chunk_1[] = "HTTP/1.1 200 Connection established\r\nProxy-Agent: test\r\n\r";
+    static const char connect_response_chunk_2[] = "\nabc";
+
+    http_io = http_proxy_io_get_interface_description()->concrete_io_create((void*)&http_proxy_io_config_with_username);
+    (void)http_proxy_io_get_interface_description()->concrete_io_open(http_io, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)connect_response_chunk_1, sizeof(connect_response_chunk_1) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_OK));
+    STRICT_EXPECTED_CALL(test_on_bytes_received((void*)0x4243, IGNORED_PTR_ARG, 3))
+        .ValidateArgumentBuffer(2, "abc", 3);
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)connect_response_chunk_2, sizeof(connect_response_chunk_2) - 1);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -2368,7 +2558,6 @@ TEST_FUNCTION(on_underlying_io_bytes_received_with_a_good_reply_status_code_201_
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_OK));
 
     // act
@@ -2396,7 +2585,6 @@ TEST_FUNCTION(on_underlying_io_bytes_received_with_a_good_reply_status_code_299_
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_OK));
 
     // act
@@ -2425,7 +2613,6 @@ TEST_FUNCTION(on_underlying_io_bytes_received_with_a_good_reply_status_code_200_
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_OK));
 
     // act
@@ -2450,7 +2637,6 @@ TEST_FUNCTION(on_underlying_io_bytes_received_with_a_199_code_indicates_an_error
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
     STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_ERROR));
 
@@ -2476,7 +2662,6 @@ TEST_FUNCTION(on_underlying_io_bytes_received_with_a_300_code_indicates_an_error
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
     STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_ERROR));
 
@@ -2536,7 +2721,6 @@ TEST_FUNCTION(one_extra_byte_gets_indicated_as_received)
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_OK));
     STRICT_EXPECTED_CALL(test_on_bytes_received((void*)0x4243, IGNORED_PTR_ARG, sizeof(expected_bytes)))
         .ValidateArgumentBuffer(2, expected_bytes, sizeof(expected_bytes));
@@ -2564,7 +2748,6 @@ TEST_FUNCTION(three_extra_byte_get_indicated_as_received)
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_OK));
     STRICT_EXPECTED_CALL(test_on_bytes_received((void*)0x4243, IGNORED_PTR_ARG, sizeof(expected_bytes)))
         .ValidateArgumentBuffer(2, expected_bytes, sizeof(expected_bytes));
@@ -2640,7 +2823,6 @@ TEST_FUNCTION(a_bad_reply_triggers_an_error_in_open_complete_callback)
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
     STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_ERROR));
 
@@ -2666,7 +2848,6 @@ TEST_FUNCTION(a_bad_reply_malformed_char_triggers_an_error_in_open_complete_call
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
     STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_ERROR));
 
@@ -2692,7 +2873,6 @@ TEST_FUNCTION(a_bad_reply_only_one_char_triggers_an_error_in_open_complete_callb
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
     STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_ERROR));
 
@@ -2895,4 +3075,315 @@ TEST_FUNCTION(when_on_underlying_io_error_is_called_while_waiting_for_underlying
     http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
 }
 
+/* http_proxy_tunnel_pool_create */
+
+/* Tests_SRS_HTTP_PROXY_IO_01_118: [ http_proxy_tunnel_pool_create shall create an empty tunnel pool and return a handle to it. ]*/
+TEST_FUNCTION(http_proxy_tunnel_pool_create_succeeds)
+{
+    // arrange
+    HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool;
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_create());
+
+    // act
+    tunnel_pool = http_proxy_tunnel_pool_create(2, 1000);
+
+    // assert
+    ASSERT_IS_NOT_NULL(tunnel_pool);
+    ASSERT_ARE_EQUAL(size_t, 0, http_proxy_tunnel_pool_get_idle_count(tunnel_pool));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    http_proxy_tunnel_pool_destroy(tunnel_pool);
+}
+
+/* Tests_SRS_HTTP_PROXY_IO_01_119: [ If max_tunnels_per_target or idle_timeout_ms is 0, http_proxy_tunnel_pool_create shall fail and return NULL. ]*/
+TEST_FUNCTION(http_proxy_tunnel_pool_create_with_0_max_tunnels_per_target_fails)
+{
+    // act
+    HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool = http_proxy_tunnel_pool_create(0, 1000);
+
+    // assert
+    ASSERT_IS_NULL(tunnel_pool);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_HTTP_PROXY_IO_01_119: [ If max_tunnels_per_target or idle_timeout_ms is 0, http_proxy_tunnel_pool_create shall fail and return NULL. ]*/
+TEST_FUNCTION(http_proxy_tunnel_pool_create_with_0_idle_timeout_fails)
+{
+    // act
+    HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool = http_proxy_tunnel_pool_create(1, 0);
+
+    // assert
+    ASSERT_IS_NULL(tunnel_pool);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_HTTP_PROXY_IO_01_120: [ If any error occurs, http_proxy_tunnel_pool_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_tickcounter_create_fails_http_proxy_tunnel_pool_create_fails)
+{
+    // arrange
+    HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool;
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_create())
+        .SetReturn(NULL);
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    tunnel_pool = http_proxy_tunnel_pool_create(1, 1000);
+
+    // assert
+    ASSERT_IS_NULL(tunnel_pool);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* http_proxy_tunnel_pool_destroy */
+
+/* Tests_SRS_HTTP_PROXY_IO_01_122: [ If tunnel_pool is NULL, http_proxy_tunnel_pool_destroy shall do nothing. ]*/
+TEST_FUNCTION(http_proxy_tunnel_pool_destroy_with_NULL_does_nothing)
+{
+    // act
+    http_proxy_tunnel_pool_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_HTTP_PROXY_IO_01_121: [ http_proxy_tunnel_pool_destroy shall close and destroy the tunnels of the pool and free the pool. ]*/
+TEST_FUNCTION(http_proxy_tunnel_pool_destroy_closes_and_destroys_the_tunnels)
+{
+    // arrange
+    HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool = http_proxy_tunnel_pool_create(1, 1000);
+    (void)http_proxy_tunnel_pool_warm(tunnel_pool, &http_proxy_io_config_no_username, 1);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)connect_response, sizeof(connect_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    http_proxy_tunnel_pool_destroy(tunnel_pool);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* http_proxy_tunnel_pool_warm */
+
+/* Tests_SRS_HTTP_PROXY_IO_01_124: [ If tunnel_pool or config is NULL, or the hostname or proxy_hostname member of config is NULL, http_proxy_tunnel_pool_warm shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(http_proxy_tunnel_pool_warm_with_NULL_config_fails)
+{
+    // arrange
+    HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool = http_proxy_tunnel_pool_create(1, 1000);
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = http_proxy_tunnel_pool_warm(tunnel_pool, NULL, 1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    http_proxy_tunnel_pool_destroy(tunnel_pool);
+}
+
+/* Tests_SRS_HTTP_PROXY_IO_01_123: [ http_proxy_tunnel_pool_warm shall start establishing tunnels to the target of config, as http_proxy_io_open would, until tunnel_count tunnels to it, capped at max_tunnels_per_target, are idle or being established. ]*/
+TEST_FUNCTION(http_proxy_tunnel_pool_warm_starts_at_most_max_tunnels_per_target)
+{
+    // arrange
+    HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool = http_proxy_tunnel_pool_create(1, 1000);
+    int result;
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_host"))
+        .IgnoreArgument_destination();
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "a_proxy"))
+        .IgnoreArgument_destination();
+    STRICT_EXPECTED_CALL(socketio_get_interface_description());
+    STRICT_EXPECTED_CALL(xio_create(TEST_SOCKETIO_INTERFACE_DESCRIPTION, &socketio_config))
+        .ValidateArgumentValue_io_create_parameters_AsType(UMOCK_TYPE(SOCKETIO_CONFIG*));
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_open_complete()
+        .IgnoreArgument_on_io_open_complete_context()
+        .IgnoreArgument_on_bytes_received()
+        .IgnoreArgument_on_bytes_received_context()
+        .IgnoreArgument_on_io_error()
+        .IgnoreArgument_on_io_error_context();
+
+    // act
+    result = http_proxy_tunnel_pool_warm(tunnel_pool, &http_proxy_io_config_no_username, 3);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    http_proxy_tunnel_pool_destroy(tunnel_pool);
+}
+
+/* Tests_SRS_HTTP_PROXY_IO_01_113: [ If a tunnel pool was set and it has an idle tunnel to the same target through the same proxy with the same credentials, http_proxy_io_open shall take it instead of opening the underlying IO, and the IO shall be OPEN. ]*/
+/* Tests_SRS_HTTP_PROXY_IO_01_114: [ When a tunnel is taken from the pool, the on_io_open_complete callback shall be triggered with IO_OPEN_OK before http_proxy_io_open returns. ]*/
+/* Tests_SRS_HTTP_PROXY_IO_01_115: [ When a tunnel is taken from the pool, the pool shall start establishing a new tunnel to the same target. ]*/
+TEST_FUNCTION(http_proxy_io_open_takes_an_idle_tunnel_from_the_pool)
+{
+    // arrange
+    HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool = http_proxy_tunnel_pool_create(1, 1000);
+    CONCRETE_IO_HANDLE http_io;
+    int result;
+
+    (void)http_proxy_tunnel_pool_warm(tunnel_pool, &http_proxy_io_config_no_username, 1);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)connect_response, sizeof(connect_response) - 1);
+    http_io = http_proxy_io_get_interface_description()->concrete_io_create((void*)&http_proxy_io_config_no_username);
+    (void)http_proxy_io_get_interface_description()->concrete_io_setoption(http_io, OPTION_HTTP_PROXY_TUNNEL_POOL, tunnel_pool);
+    ASSERT_ARE_EQUAL(size_t, 1, http_proxy_tunnel_pool_get_idle_count(tunnel_pool));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_host"))
+        .IgnoreArgument_destination();
+    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "a_proxy"))
+        .IgnoreArgument_destination();
+    STRICT_EXPECTED_CALL(socketio_get_interface_description());
+    STRICT_EXPECTED_CALL(xio_create(TEST_SOCKETIO_INTERFACE_DESCRIPTION, &socketio_config))
+        .ValidateArgumentValue_io_create_parameters_AsType(UMOCK_TYPE(SOCKETIO_CONFIG*));
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_open_complete()
+        .IgnoreArgument_on_io_open_complete_context()
+        .IgnoreArgument_on_bytes_received()
+        .IgnoreArgument_on_bytes_received_context()
+        .IgnoreArgument_on_io_error()
+        .IgnoreArgument_on_io_error_context();
+    STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4242, IO_OPEN_OK));
+
+    // act
+    result = http_proxy_io_get_interface_description()->concrete_io_open(http_io, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, http_proxy_tunnel_pool_get_idle_count(tunnel_pool));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
+    http_proxy_tunnel_pool_destroy(tunnel_pool);
+}
+
+/* Tests_SRS_HTTP_PROXY_IO_01_131: [ Tunnels idle for idle_timeout_ms or longer shall not be taken. ]*/
+TEST_FUNCTION(http_proxy_io_open_does_not_take_an_expired_tunnel)
+{
+    // arrange
+    HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool = http_proxy_tunnel_pool_create(1, 1000);
+    CONCRETE_IO_HANDLE http_io;
+    int result;
+
+    (void)http_proxy_tunnel_pool_warm(tunnel_pool, &http_proxy_io_config_no_username, 1);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)connect_response, sizeof(connect_response) - 1);
+    http_io = http_proxy_io_get_interface_description()->concrete_io_create((void*)&http_proxy_io_config_no_username);
+    (void)http_proxy_io_get_interface_description()->concrete_io_setoption(http_io, OPTION_HTTP_PROXY_TUNNEL_POOL, tunnel_pool);
+    g_current_ms = 1000;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_open_complete()
+        .IgnoreArgument_on_io_open_complete_context()
+        .IgnoreArgument_on_bytes_received()
+        .IgnoreArgument_on_bytes_received_context()
+        .IgnoreArgument_on_io_error()
+        .IgnoreArgument_on_io_error_context();
+
+    // act
+    result = http_proxy_io_get_interface_description()->concrete_io_open(http_io, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    http_proxy_io_get_interface_description()->concrete_io_destroy(http_io);
+    http_proxy_tunnel_pool_destroy(tunnel_pool);
+}
+
+/* http_proxy_tunnel_pool_dowork */
+
+/* Tests_SRS_HTTP_PROXY_IO_01_129: [ http_proxy_tunnel_pool_dowork shall close and destroy the tunnels that have been idle for idle_timeout_ms or longer; they are not replaced. ]*/
+TEST_FUNCTION(http_proxy_tunnel_pool_dowork_evicts_expired_tunnels)
+{
+    // arrange
+    HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool = http_proxy_tunnel_pool_create(1, 1000);
+
+    (void)http_proxy_tunnel_pool_warm(tunnel_pool, &http_proxy_io_config_no_username, 1);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)connect_response, sizeof(connect_response) - 1);
+    g_current_ms = 1000;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    http_proxy_tunnel_pool_dowork(tunnel_pool);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, http_proxy_tunnel_pool_get_idle_count(tunnel_pool));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    http_proxy_tunnel_pool_destroy(tunnel_pool);
+}
+
+/* Tests_SRS_HTTP_PROXY_IO_01_132: [ A tunnel that receives bytes while idle in the pool shall be closed by the next http_proxy_tunnel_pool_dowork, since the bytes have nobody to go to. ]*/
+TEST_FUNCTION(a_tunnel_receiving_bytes_while_idle_is_not_taken)
+{
+    // arrange
+    const unsigned char test_bytes[] = { 0x42 };
+    HTTP_PROXY_TUNNEL_POOL_HANDLE tunnel_pool = http_proxy_tunnel_pool_create(1, 1000);
+    umock_c_reset_all_calls();
+
+    (void)http_proxy_tunnel_pool_warm(tunnel_pool, &http_proxy_io_config_no_username, 1);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)connect_response, sizeof(connect_response) - 1);
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_bytes, sizeof(test_bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, http_proxy_tunnel_pool_get_idle_count(tunnel_pool));
+
+    // cleanup
+    http_proxy_tunnel_pool_destroy(tunnel_pool);
+}
+
 END_TEST_SUITE(http_proxy_io_unittests)
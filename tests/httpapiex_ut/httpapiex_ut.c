@@ -77,6 +77,18 @@ void my_gballoc_free(void* ptr)
 #include "azure_c_shared_utility/buffer_.h"
 #include "azure_c_shared_utility/httpheaders.h"
 #include "azure_c_shared_utility/httpapi.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/gb_rand.h"
+#include "azure_c_shared_utility/tickcounter.h"
+
+#ifdef USE_HTTP_COMPRESSION
+#include "zlib.h"
+
+MOCKABLE_FUNCTION(, int, deflateInit2_, z_streamp, strm, int, level, int, method, int, windowBits, int, memLevel, int, strategy, const char*, version, int, stream_size);
+MOCKABLE_FUNCTION(, int, deflate, z_streamp, strm, int, flush);
+MOCKABLE_FUNCTION(, int, deflateEnd, z_streamp, strm);
+#endif
 
 static size_t currentHTTPAPI_SaveOption_call;
 static size_t whenShallHTTPAPI_SaveOption_fail;
@@ -233,6 +245,61 @@ HTTPAPI_RESULT my_HTTPAPI_CloneOption(const char* optionName, const void* value,
     return result2;
 }
 
+#define TEST_STREAMED_CONTENT "streamed"
+#define TEST_STREAMED_CONTENT_SIZE 8
+
+static HTTPAPI_RESULT streamingRequestResult;
+static unsigned char streamedRequestContent[TEST_STREAMED_CONTENT_SIZE];
+
+HTTPAPI_RESULT my_HTTPAPI_ExecuteStreamingRequest(HTTP_HANDLE handle, HTTPAPI_REQUEST_TYPE requestType, const char* relativePath, HTTP_HEADERS_HANDLE httpHeadersHandle, size_t contentLength, HTTPAPI_READ_CONTENT readContent, void* readContentContext, unsigned int* statusCode, HTTP_HEADERS_HANDLE responseHeadersHandle, HTTPAPI_WRITE_CONTENT writeContent, void* writeContentContext)
+{
+    size_t bytesRead;
+    (void)handle;
+    (void)requestType;
+    (void)relativePath;
+    (void)httpHeadersHandle;
+    (void)responseHeadersHandle;
+    if (contentLength > 0)
+    {
+        (void)readContent(readContentContext, streamedRequestContent, sizeof(streamedRequestContent), &bytesRead);
+    }
+    *statusCode = 200;
+    if (writeContent != NULL)
+    {
+        (void)writeContent(writeContentContext, (const unsigned char*)TEST_STREAMED_CONTENT, TEST_STREAMED_CONTENT_SIZE);
+    }
+    return streamingRequestResult;
+}
+
+#ifdef USE_HTTP_COMPRESSION
+#define TEST_COMPRESSED_CONTENT "gz"
+#define TEST_COMPRESSED_CONTENT_SIZE 2
+/*gzipRequestContent allocates a piece to read into and a piece to compress into, both of 4096 bytes*/
+#define TEST_COMPRESSION_CHUNKS_SIZE (2 * 4096)
+
+/*stands for zlib: the input is consumed and, when the stream is finished, TEST_COMPRESSED_CONTENT is produced*/
+int my_deflate(z_streamp strm, int flush)
+{
+    int result2;
+    strm->next_in += strm->avail_in;
+    strm->total_in += strm->avail_in;
+    strm->avail_in = 0;
+    if (flush == Z_FINISH)
+    {
+        (void)memcpy(strm->next_out, TEST_COMPRESSED_CONTENT, TEST_COMPRESSED_CONTENT_SIZE);
+        strm->next_out += TEST_COMPRESSED_CONTENT_SIZE;
+        strm->avail_out -= TEST_COMPRESSED_CONTENT_SIZE;
+        strm->total_out += TEST_COMPRESSED_CONTENT_SIZE;
+        result2 = Z_STREAM_END;
+    }
+    else
+    {
+        result2 = Z_OK;
+    }
+    return result2;
+}
+#endif
+
 #ifdef __cplusplus
 extern "C"
 {
@@ -270,8 +337,10 @@ extern "C"
 #undef ENABLE_MOCKS
 
 #include "azure_c_shared_utility/httpapiex.h"
+#include "azure_c_shared_utility/shared_util_options.h"
 
 IMPLEMENT_UMOCK_C_ENUM_TYPE(HTTPAPI_RESULT, HTTPAPI_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
 TEST_DEFINE_ENUM_TYPE(HTTPAPIEX_RESULT, HTTPAPIEX_RESULT_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(HTTPAPIEX_RESULT, HTTPAPIEX_RESULT_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(HTTP_HEADERS_RESULT, HTTP_HEADERS_RESULT_VALUES);
@@ -288,6 +357,8 @@ IMPLEMENT_UMOCK_C_ENUM_TYPE(HTTPAPI_REQUEST_TYPE, HTTPAPI_REQUEST_TYPE_VALUES);
 #define TEST_BUFFER_RESP_BODY   (BUFFER_HANDLE) 0x49
 unsigned char* TEST_BUFFER = (unsigned char*)"333333";
 #define TEST_BUFFER_SIZE 6
+#define TEST_LOCK_HANDLE (LOCK_HANDLE)0x4A
+#define TEST_TICK_COUNTER_HANDLE (TICK_COUNTER_HANDLE)0x4B
 
 static TEST_MUTEX_HANDLE g_testByTest;
 
@@ -429,6 +500,10 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_TYPE(HTTPAPIEX_RESULT, HTTPAPIEX_RESULT);
     REGISTER_TYPE(HTTP_HEADERS_RESULT, HTTP_HEADERS_RESULT);
     REGISTER_TYPE(HTTPAPI_REQUEST_TYPE, HTTPAPI_REQUEST_TYPE);
+    REGISTER_TYPE(LOCK_RESULT, LOCK_RESULT);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(tickcounter_ms_t*, void*);
     REGISTER_UMOCK_ALIAS_TYPE(VECTOR_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(const VECTOR_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(PREDICATE_FUNCTION, void*);
@@ -437,6 +512,8 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_UMOCK_ALIAS_TYPE(HTTP_HEADERS_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(HTTP_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(const unsigned char*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(HTTPAPI_READ_CONTENT, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(HTTPAPI_WRITE_CONTENT, void*);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
@@ -456,6 +533,7 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_GLOBAL_MOCK_HOOK(HTTPAPI_CreateConnection, my_HTTPAPI_CreateConnection);
     REGISTER_GLOBAL_MOCK_HOOK(HTTPAPI_CloseConnection, my_HTTPAPI_CloseConnection);
     REGISTER_GLOBAL_MOCK_RETURN(HTTPAPI_ExecuteRequest, HTTPAPI_OK);
+    REGISTER_GLOBAL_MOCK_HOOK(HTTPAPI_ExecuteStreamingRequest, my_HTTPAPI_ExecuteStreamingRequest);
     REGISTER_GLOBAL_MOCK_RETURN(HTTPAPI_SetOption, HTTPAPI_OK);
     REGISTER_GLOBAL_MOCK_HOOK(HTTPAPI_CloneOption, my_HTTPAPI_CloneOption);
     REGISTER_GLOBAL_MOCK_HOOK(VECTOR_create, real_VECTOR_create);
@@ -471,6 +549,19 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_GLOBAL_MOCK_HOOK(VECTOR_size, real_VECTOR_size);
     REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, real_mallocAndStrcpy_s);
     REGISTER_GLOBAL_MOCK_HOOK(size_tToString, real_size_tToString);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock_Init, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_get_current_ms, 0);
+#ifdef USE_HTTP_COMPRESSION
+    REGISTER_UMOCK_ALIAS_TYPE(z_streamp, void*);
+    REGISTER_GLOBAL_MOCK_RETURN(deflateInit2_, Z_OK);
+    REGISTER_GLOBAL_MOCK_HOOK(deflate, my_deflate);
+    REGISTER_GLOBAL_MOCK_RETURN(deflateEnd, Z_OK);
+#endif
 }
 
 TEST_SUITE_CLEANUP(TestClassCleanup)
@@ -3319,6 +3410,1163 @@ TEST_FUNCTION(HTTPAPIEX_SetOption_happy_path_on_update_option_value_succeeds)
 }
 
 /*Tests_SRS_HTTPAPIEX_02_043: [If parameter handle is NULL then HTTPAPIEX_Destroy shall take no action.] */
+/*Tests_SRS_HTTPAPIEX_02_044: [Options handled by HTTPAPIEX shall not be passed to HTTPAPI_CloneOption nor to HTTPAPI_SetOption.]*/
+/*Tests_SRS_HTTPAPIEX_02_045: [Setting OPTION_HTTPAPIEX_MAX_IDLE_CONNECTIONS to a value other than 0 shall enable the connection pool, which makes HTTPAPIEX_ExecuteRequest and HTTPAPIEX_SetOption thread safe.]*/
+TEST_FUNCTION(HTTPAPIEX_SetOption_max_idle_connections_enables_the_connection_pool)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    size_t maxIdleConnections = 2;
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(tickcounter_create());
+
+    /// act
+    result = HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_MAX_IDLE_CONNECTIONS, &maxIdleConnections);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_02_047: [If enabling the connection pool fails then HTTPAPIEX_SetOption shall return HTTPAPIEX_ERROR.]*/
+TEST_FUNCTION(HTTPAPIEX_SetOption_max_idle_connections_fails_when_Lock_Init_fails)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    size_t maxIdleConnections = 2;
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock_Init())
+        .SetReturn(NULL);
+
+    /// act
+    result = HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_MAX_IDLE_CONNECTIONS, &maxIdleConnections);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_02_046: [If OPTION_HTTPAPIEX_MAX_IDLE_CONNECTIONS enables the connection pool after HTTPAPIEX_ExecuteRequest has created a connection then HTTPAPIEX_SetOption shall return HTTPAPIEX_ERROR.]*/
+TEST_FUNCTION(HTTPAPIEX_SetOption_max_idle_connections_after_a_request_fails)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    size_t maxIdleConnections = 2;
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    unsigned int httpStatusCode;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    BUFFER_HANDLE requestHttpBody = TEST_BUFFER_REQ_BODY;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    BUFFER_HANDLE responseHttpBody = TEST_BUFFER_RESP_BODY;
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+    umock_c_reset_all_calls();
+
+    /// act
+    result = HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_MAX_IDLE_CONNECTIONS, &maxIdleConnections);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_02_049: [If the connection pool is enabled then HTTPAPIEX_ExecuteRequest shall execute the request on the most recently used idle connection, or on a new connection when there is none.]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteRequest_with_connection_pool_reuses_the_idle_connection)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    size_t maxIdleConnections = 2;
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    unsigned int httpStatusCode;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    BUFFER_HANDLE requestHttpBody = TEST_BUFFER_REQ_BODY;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    BUFFER_HANDLE responseHttpBody = TEST_BUFFER_RESP_BODY;
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_MAX_IDLE_CONNECTIONS, &maxIdleConnections);
+    (void)HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+    umock_c_reset_all_calls();
+
+    setupAllCallBeforeHTTPsequence();
+    STRICT_EXPECTED_CALL(BUFFER_length(requestHttpBody))
+        .SetReturn(TEST_BUFFER_SIZE);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(requestHttpBody))
+        .SetReturn(TEST_BUFFER);
+    EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPAPI_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, IGNORED_PTR_ARG, TEST_BUFFER_SIZE, IGNORED_PTR_ARG, responseHttpHeaders, responseHttpBody))
+        .IgnoreArgument(1)
+        .IgnoreArgument(5)
+        .IgnoreArgument(7);
+    EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+
+    /// act
+    result = HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_02_050: [If executing the request on a pooled connection fails then HTTPAPIEX_ExecuteRequest shall close that connection and retry the request once on a new connection.]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteRequest_with_connection_pool_retries_once_on_a_new_connection)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    size_t maxIdleConnections = 2;
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    unsigned int httpStatusCode;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    BUFFER_HANDLE requestHttpBody = TEST_BUFFER_REQ_BODY;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    BUFFER_HANDLE responseHttpBody = TEST_BUFFER_RESP_BODY;
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_MAX_IDLE_CONNECTIONS, &maxIdleConnections);
+    (void)HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+    umock_c_reset_all_calls();
+
+    setupAllCallBeforeHTTPsequence();
+    STRICT_EXPECTED_CALL(BUFFER_length(requestHttpBody))
+        .SetReturn(TEST_BUFFER_SIZE);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(requestHttpBody))
+        .SetReturn(TEST_BUFFER);
+    EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPAPI_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, IGNORED_PTR_ARG, TEST_BUFFER_SIZE, IGNORED_PTR_ARG, responseHttpHeaders, responseHttpBody))
+        .IgnoreArgument(1)
+        .IgnoreArgument(5)
+        .IgnoreArgument(7)
+        .SetReturn(HTTPAPI_ERROR);
+    STRICT_EXPECTED_CALL(HTTPAPI_CloseConnection(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    /*no HTTPAPI_Init, it is done once per pool*/
+    EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPAPI_CreateConnection(TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPAPI_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, IGNORED_PTR_ARG, TEST_BUFFER_SIZE, IGNORED_PTR_ARG, responseHttpHeaders, responseHttpBody))
+        .IgnoreArgument(1)
+        .IgnoreArgument(5)
+        .IgnoreArgument(7);
+    EXPECTED_CALL(Lock(IGNORED_PTR_ARG));
+    EXPECTED_CALL(tickcounter_get_current_ms(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(Unlock(IGNORED_PTR_ARG));
+
+    /// act
+    result = HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_02_061: [Setting OPTION_HTTPAPIEX_RETRY_POLICY shall replace the retry policy, fill its retry budget and close its circuit breaker.]*/
+TEST_FUNCTION(HTTPAPIEX_SetOption_retry_policy_is_not_passed_to_httpapi)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    HTTPAPIEX_RETRY_POLICY retryPolicy = { 100, 1000, 10, 3, 5000 };
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_create());
+
+    /// act
+    result = HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_RETRY_POLICY, &retryPolicy);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_02_068: [If setting OPTION_HTTPAPIEX_RETRY_POLICY fails then HTTPAPIEX_SetOption shall return HTTPAPIEX_ERROR.]*/
+TEST_FUNCTION(HTTPAPIEX_SetOption_retry_policy_fails_when_tickcounter_create_fails)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    HTTPAPIEX_RETRY_POLICY retryPolicy = { 100, 1000, 10, 3, 5000 };
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(tickcounter_create())
+        .SetReturn(NULL);
+
+    /// act
+    result = HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_RETRY_POLICY, &retryPolicy);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+#ifndef USE_HTTP_COMPRESSION
+/*Tests_SRS_HTTPAPIEX_01_002: [ If the library is built without use_http_compression, setting OPTION_HTTPAPIEX_REQUEST_COMPRESSION_THRESHOLD shall fail and return HTTPAPIEX_ERROR. ]*/
+TEST_FUNCTION(HTTPAPIEX_SetOption_request_compression_threshold_fails_when_not_supported)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    size_t compressionThreshold = 1024;
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    umock_c_reset_all_calls();
+
+    /// act
+    result = HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_REQUEST_COMPRESSION_THRESHOLD, &compressionThreshold);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+#endif
+
+/*Tests_SRS_HTTPAPIEX_02_062: [If a retry policy is set then HTTPAPIEX_ExecuteRequest shall wait a random delay between 0 and min(max_backoff_ms, initial_backoff_ms * 2^n) before the retry n (0 based).]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteRequest_with_retry_policy_waits_a_jittered_backoff_before_retrying)
+{
+    /// arrange
+    HTTPAPIEX_RETRY_POLICY retryPolicy = { 100, 1000, 0, 0, 0 };
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    HTTPAPIEX_RESULT result;
+
+    unsigned int httpStatusCode;
+    unsigned int asGivenByHttpApi = 23;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    BUFFER_HANDLE requestHttpBody = TEST_BUFFER_REQ_BODY;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    BUFFER_HANDLE responseHttpBody = TEST_BUFFER_RESP_BODY;
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_RETRY_POLICY, &retryPolicy);
+    (void)HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+    umock_c_reset_all_calls();
+
+    prepareHTTPAPIEX_ExecuteRequest(&asGivenByHttpApi, requestHttpHeaders, responseHttpHeaders, responseHttpBody, HTTPAPI_ERROR);
+    STRICT_EXPECTED_CALL(HTTPAPI_CloseConnection(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(gb_rand_uint32())
+        .SetReturn(1234);
+    STRICT_EXPECTED_CALL(ThreadAPI_Sleep(1234 % 101));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPAPI_CreateConnection(TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPAPI_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, IGNORED_PTR_ARG, TEST_BUFFER_SIZE, IGNORED_PTR_ARG, responseHttpHeaders, responseHttpBody))
+        .IgnoreArgument(1)
+        .IgnoreArgument(5)
+        .IgnoreArgument(7);
+
+    /// act
+    result = HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_02_063: [If the retry budget of the retry policy has no token left then HTTPAPIEX_ExecuteRequest shall not retry and shall return HTTPAPIEX_RECOVERYFAILED.]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteRequest_with_retry_policy_stops_retrying_when_the_retry_budget_is_exhausted)
+{
+    /// arrange
+    HTTPAPIEX_RETRY_POLICY retryPolicy = { 0, 0, 1, 0, 0 };
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    HTTPAPIEX_RESULT result;
+
+    unsigned int httpStatusCode;
+    unsigned int asGivenByHttpApi = 23;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    BUFFER_HANDLE requestHttpBody = TEST_BUFFER_REQ_BODY;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    BUFFER_HANDLE responseHttpBody = TEST_BUFFER_RESP_BODY;
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_RETRY_POLICY, &retryPolicy);
+    (void)HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+    umock_c_reset_all_calls();
+
+    prepareHTTPAPIEX_ExecuteRequest(&asGivenByHttpApi, requestHttpHeaders, responseHttpHeaders, responseHttpBody, HTTPAPI_ERROR);
+    STRICT_EXPECTED_CALL(HTTPAPI_CloseConnection(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    /*the only token of the budget is spent here*/
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    whenShallHTTPAPI_CreateConnection_fail[0] = currentHTTPAPI_CreateConnection_call + 1;
+    STRICT_EXPECTED_CALL(HTTPAPI_CreateConnection(TEST_HOSTNAME));
+    /*no HTTPAPI_Init retry*/
+    STRICT_EXPECTED_CALL(HTTPAPI_Deinit());
+
+    /// act
+    result = HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_RECOVERYFAILED, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_02_064: [If the circuit breaker of the retry policy is open then HTTPAPIEX_ExecuteRequest shall fail without executing the request and return HTTPAPIEX_RECOVERYFAILED.]*/
+/*Tests_SRS_HTTPAPIEX_02_065: [If a retry policy is set then HTTPAPIEX_ExecuteRequest shall count the consecutive requests that returned HTTPAPIEX_RECOVERYFAILED and open the circuit breaker for circuit_breaker_open_ms once they reach circuit_breaker_threshold.]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteRequest_with_an_open_circuit_breaker_fails_fast)
+{
+    /// arrange
+    HTTPAPIEX_RETRY_POLICY retryPolicy = { 0, 0, 0, 1, 1000 };
+    tickcounter_ms_t now = 999;
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    HTTPAPIEX_RESULT result;
+
+    unsigned int httpStatusCode;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    BUFFER_HANDLE requestHttpBody = TEST_BUFFER_REQ_BODY;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    BUFFER_HANDLE responseHttpBody = TEST_BUFFER_RESP_BODY;
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_RETRY_POLICY, &retryPolicy);
+    whenShallHTTPAPI_Init_fail[0] = currentHTTPAPI_Init_call + 1;
+    (void)HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+    umock_c_reset_all_calls();
+
+    setupAllCallBeforeHTTPsequence();
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_current_ms(&now, sizeof(now));
+
+    /// act
+    result = HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_RECOVERYFAILED, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_02_066: [A request that returns HTTPAPIEX_OK shall close the circuit breaker, reset the count of consecutive failures and give a token back to the retry budget.]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteRequest_with_an_open_circuit_breaker_probes_the_host_once_circuit_breaker_open_ms_elapsed)
+{
+    /// arrange
+    HTTPAPIEX_RETRY_POLICY retryPolicy = { 0, 0, 0, 1, 1000 };
+    tickcounter_ms_t now = 1000;
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    HTTPAPIEX_RESULT result;
+
+    unsigned int httpStatusCode;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    BUFFER_HANDLE requestHttpBody = TEST_BUFFER_REQ_BODY;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    BUFFER_HANDLE responseHttpBody = TEST_BUFFER_RESP_BODY;
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_RETRY_POLICY, &retryPolicy);
+    whenShallHTTPAPI_Init_fail[0] = currentHTTPAPI_Init_call + 1;
+    (void)HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+    umock_c_reset_all_calls();
+
+    setupAllCallBeforeHTTPsequence();
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_current_ms(&now, sizeof(now));
+    setupAllCallForHTTPsequence(TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, responseHttpHeaders, responseHttpBody);
+
+    /// act
+    result = HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_02_053: [HTTPAPIEX_Destroy shall close all the idle connections of the connection pool.]*/
+TEST_FUNCTION(HTTPAPIEX_Destroy_closes_the_idle_connections_of_the_connection_pool)
+{
+    /// arrange
+    size_t maxIdleConnections = 2;
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    unsigned int httpStatusCode;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    BUFFER_HANDLE requestHttpBody = TEST_BUFFER_REQ_BODY;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    BUFFER_HANDLE responseHttpBody = TEST_BUFFER_RESP_BODY;
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_MAX_IDLE_CONNECTIONS, &maxIdleConnections);
+    (void)HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(HTTPAPI_CloseConnection(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)) /*this is the pooled connection*/
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPAPI_Deinit());
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*this is hostname*/
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(VECTOR_destroy(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(gballoc_free(httpapiexhandle));
+
+    /// act
+    HTTPAPIEX_Destroy(httpapiexhandle);
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+}
+
+/*Tests_SRS_HTTPAPIEX_02_054: [If parameter handle is NULL, requestType is not a valid request or readRequestContent is NULL while requestContentLength is not 0 then HTTPAPIEX_ExecuteStreamingRequest shall fail and return HTTPAPIEX_INVALID_ARG.]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteStreamingRequest_with_NULL_handle_fails)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+
+    /// act
+    result = HTTPAPIEX_ExecuteStreamingRequest(NULL, HTTPAPI_REQUEST_GET, TEST_RELATIVE_PATH, NULL, 0, NULL, NULL, NULL, NULL, NULL, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_HTTPAPIEX_02_054: [If parameter handle is NULL, requestType is not a valid request or readRequestContent is NULL while requestContentLength is not 0 then HTTPAPIEX_ExecuteStreamingRequest shall fail and return HTTPAPIEX_INVALID_ARG.]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteStreamingRequest_with_content_and_NULL_readRequestContent_fails)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    umock_c_reset_all_calls();
+
+    /// act
+    result = HTTPAPIEX_ExecuteStreamingRequest(httpapiexhandle, HTTPAPI_REQUEST_PUT, TEST_RELATIVE_PATH, NULL, TEST_BUFFER_SIZE, NULL, NULL, NULL, NULL, NULL, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+static int test_read_content(void* context, unsigned char* buffer, size_t bufferSize, size_t* bytesRead)
+{
+    size_t* calls = (size_t*)context;
+    (*calls)++;
+    (void)memcpy(buffer, TEST_BUFFER, TEST_BUFFER_SIZE);
+    (void)bufferSize;
+    *bytesRead = TEST_BUFFER_SIZE;
+    return 0;
+}
+
+static int test_write_content(void* context, const unsigned char* buffer, size_t size)
+{
+    size_t* received = (size_t*)context;
+    ASSERT_ARE_EQUAL(int, 0, memcmp(buffer, TEST_STREAMED_CONTENT, size));
+    *received += size;
+    return 0;
+}
+
+/*Tests_SRS_HTTPAPIEX_02_055: [HTTPAPIEX_ExecuteStreamingRequest shall build the request headers, the relative path, the status code and the response headers the same way HTTPAPIEX_ExecuteRequest does, using requestContentLength for the Content-Length header.]*/
+/*Tests_SRS_HTTPAPIEX_02_056: [HTTPAPIEX_ExecuteStreamingRequest shall call HTTPAPI_ExecuteStreamingRequest on the connection HTTPAPIEX_ExecuteRequest would use, creating it if needed.]*/
+/*Tests_SRS_HTTPAPIEX_02_057: [The request body shall be read with readRequestContent and the response body shall be passed to writeResponseContent.]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteStreamingRequest_happy_path_succeeds)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    unsigned int httpStatusCode;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    size_t readCalls = 0;
+    size_t received = 0;
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    streamingRequestResult = HTTPAPI_OK;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, IGNORED_NUM_ARG, TEST_BUFFER_SIZE))
+        .IgnoreArgument(1).IgnoreArgument(2);
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(requestHttpHeaders, "Host", TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(requestHttpHeaders, "Content-Length", TOSTRING(TEST_BUFFER_SIZE)));
+    STRICT_EXPECTED_CALL(HTTPAPI_Init());
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPAPI_CreateConnection(TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPAPI_ExecuteStreamingRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_PUT, TEST_RELATIVE_PATH, requestHttpHeaders, TEST_BUFFER_SIZE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, responseHttpHeaders, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(6)
+        .IgnoreArgument(7)
+        .IgnoreArgument(8)
+        .IgnoreArgument(10)
+        .IgnoreArgument(11);
+
+    /// act
+    result = HTTPAPIEX_ExecuteStreamingRequest(httpapiexhandle, HTTPAPI_REQUEST_PUT, TEST_RELATIVE_PATH, requestHttpHeaders, TEST_BUFFER_SIZE, test_read_content, &readCalls, &httpStatusCode, responseHttpHeaders, test_write_content, &received);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, readCalls);
+    ASSERT_ARE_EQUAL(size_t, TEST_STREAMED_CONTENT_SIZE, received);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(streamedRequestContent, TEST_BUFFER, TEST_BUFFER_SIZE));
+    ASSERT_ARE_EQUAL(int, 200, httpStatusCode);
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_02_060: [If the request fails after readRequestContent or writeResponseContent has been called then HTTPAPIEX_ExecuteStreamingRequest shall not retry it and shall return HTTPAPIEX_ERROR.]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteStreamingRequest_does_not_retry_after_the_content_has_streamed)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    size_t received = 0;
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    streamingRequestResult = HTTPAPI_ERROR;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, IGNORED_NUM_ARG, 0))
+        .IgnoreArgument(1).IgnoreArgument(2);
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(requestHttpHeaders, "Host", TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(requestHttpHeaders, "Content-Length", "0"));
+    STRICT_EXPECTED_CALL(HTTPAPI_Init());
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPAPI_CreateConnection(TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    EXPECTED_CALL(HTTPAPI_ExecuteStreamingRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_GET, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPAPI_CloseConnection(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPAPI_Deinit());
+
+    /// act
+    result = HTTPAPIEX_ExecuteStreamingRequest(httpapiexhandle, HTTPAPI_REQUEST_GET, TEST_RELATIVE_PATH, requestHttpHeaders, 0, NULL, NULL, NULL, responseHttpHeaders, test_write_content, &received);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+#ifdef USE_HTTP_COMPRESSION
+/*the calls of gzipRequestContent compressing a body read in the given number of pieces into compressedBody*/
+static void setupCompressionCalls(BUFFER_HANDLE compressedBody, size_t pieces)
+{
+    size_t i;
+    STRICT_EXPECTED_CALL(gballoc_malloc(TEST_COMPRESSION_CHUNKS_SIZE));
+    STRICT_EXPECTED_CALL(deflateInit2_(IGNORED_PTR_ARG, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY, IGNORED_PTR_ARG, (int)sizeof(z_stream)))
+        .IgnoreArgument(1)
+        .IgnoreArgument(7);
+    STRICT_EXPECTED_CALL(BUFFER_new())
+        .SetReturn(compressedBody);
+    for (i = 0; i < pieces; i++)
+    {
+        STRICT_EXPECTED_CALL(deflate(IGNORED_PTR_ARG, Z_NO_FLUSH))
+            .IgnoreArgument(1);
+    }
+    STRICT_EXPECTED_CALL(deflate(IGNORED_PTR_ARG, Z_FINISH))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(BUFFER_append_build(compressedBody, IGNORED_PTR_ARG, TEST_COMPRESSED_CONTENT_SIZE))
+        .IgnoreArgument(2)
+        .ValidateArgumentBuffer(2, TEST_COMPRESSED_CONTENT, TEST_COMPRESSED_CONTENT_SIZE);
+    STRICT_EXPECTED_CALL(deflateEnd(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+}
+
+/*the calls of sending the compressed body with a copy of requestHttpHeaders that has the Content-Encoding: gzip header*/
+static void setupCompressedRequestCalls(HTTP_HEADERS_HANDLE requestHttpHeaders, HTTP_HEADERS_HANDLE clonedHttpHeaders, BUFFER_HANDLE requestHttpBody, BUFFER_HANDLE compressedBody, HTTP_HEADERS_HANDLE responseHttpHeaders, BUFFER_HANDLE responseHttpBody)
+{
+    STRICT_EXPECTED_CALL(BUFFER_length(requestHttpBody))
+        .SetReturn(TEST_BUFFER_SIZE);
+    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(requestHttpHeaders, "Content-Encoding"));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(requestHttpBody))
+        .SetReturn(TEST_BUFFER);
+    setupCompressionCalls(compressedBody, 1);
+    STRICT_EXPECTED_CALL(BUFFER_length(compressedBody))
+        .SetReturn(TEST_COMPRESSED_CONTENT_SIZE);
+
+    STRICT_EXPECTED_CALL(HTTPHeaders_Clone(requestHttpHeaders))
+        .SetReturn(clonedHttpHeaders);
+    STRICT_EXPECTED_CALL(BUFFER_length(compressedBody))
+        .SetReturn(TEST_COMPRESSED_CONTENT_SIZE);
+    STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, IGNORED_NUM_ARG, TEST_COMPRESSED_CONTENT_SIZE))
+        .IgnoreArgument(1).IgnoreArgument(2);
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(clonedHttpHeaders, "Host", TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(clonedHttpHeaders, "Content-Length", TOSTRING(TEST_COMPRESSED_CONTENT_SIZE)));
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(clonedHttpHeaders, "Content-Encoding", "gzip"));
+
+    STRICT_EXPECTED_CALL(HTTPAPI_Init());
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPAPI_CreateConnection(TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(BUFFER_length(compressedBody))
+        .SetReturn(TEST_COMPRESSED_CONTENT_SIZE);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(compressedBody))
+        .SetReturn((unsigned char*)TEST_COMPRESSED_CONTENT);
+    STRICT_EXPECTED_CALL(HTTPAPI_ExecuteRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, clonedHttpHeaders, IGNORED_PTR_ARG, TEST_COMPRESSED_CONTENT_SIZE, IGNORED_PTR_ARG, responseHttpHeaders, responseHttpBody))
+        .IgnoreArgument(1)
+        .IgnoreArgument(5)
+        .IgnoreArgument(7)
+        .ValidateArgumentBuffer(5, TEST_COMPRESSED_CONTENT, TEST_COMPRESSED_CONTENT_SIZE);
+
+    STRICT_EXPECTED_CALL(BUFFER_delete(compressedBody));
+    STRICT_EXPECTED_CALL(HTTPHeaders_Free(clonedHttpHeaders));
+}
+
+/*the calls of compressing the body of an HTTPAPIEX_ExecuteRequest up to the creation of the compressed buffer*/
+static void setupCompressionStartCalls(HTTP_HEADERS_HANDLE requestHttpHeaders, BUFFER_HANDLE requestHttpBody)
+{
+    STRICT_EXPECTED_CALL(BUFFER_length(requestHttpBody))
+        .SetReturn(TEST_BUFFER_SIZE);
+    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(requestHttpHeaders, "Content-Encoding"));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(requestHttpBody))
+        .SetReturn(TEST_BUFFER);
+    STRICT_EXPECTED_CALL(gballoc_malloc(TEST_COMPRESSION_CHUNKS_SIZE));
+    STRICT_EXPECTED_CALL(deflateInit2_(IGNORED_PTR_ARG, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY, IGNORED_PTR_ARG, (int)sizeof(z_stream)))
+        .IgnoreArgument(1)
+        .IgnoreArgument(7);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_001: [ Setting OPTION_HTTPAPIEX_REQUEST_COMPRESSION_THRESHOLD shall make the requests whose body is at least *value bytes be sent gzip compressed, 0 disabling the compression. ]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteRequest_does_not_compress_a_body_below_the_threshold)
+{
+    /// arrange
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    HTTPAPIEX_RESULT result;
+    size_t compressionThreshold = TEST_BUFFER_SIZE + 1;
+
+    unsigned int httpStatusCode;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    BUFFER_HANDLE requestHttpBody = TEST_BUFFER_REQ_BODY;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    BUFFER_HANDLE responseHttpBody = TEST_BUFFER_RESP_BODY;
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_REQUEST_COMPRESSION_THRESHOLD, &compressionThreshold);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(BUFFER_length(requestHttpBody))
+        .SetReturn(TEST_BUFFER_SIZE);
+    setupAllCallBeforeHTTPsequence();
+    setupAllCallForHTTPsequence(TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, responseHttpHeaders, responseHttpBody);
+
+    /// act
+    result = HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_001: [ Setting OPTION_HTTPAPIEX_REQUEST_COMPRESSION_THRESHOLD shall make the requests whose body is at least *value bytes be sent gzip compressed, 0 disabling the compression. ]*/
+/*Tests_SRS_HTTPAPIEX_01_003: [ If request compression is enabled, requestContent is at least as large as the threshold and requestHttpHeadersHandle has no Content-Encoding header, then HTTPAPIEX_ExecuteRequest shall send the gzip compression of requestContent, with a Content-Encoding: gzip header and the Content-Length of the compressed content, without modifying requestHttpHeadersHandle. ]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteRequest_compresses_a_body_at_the_threshold)
+{
+    /// arrange
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    HTTPAPIEX_RESULT result;
+    size_t compressionThreshold = TEST_BUFFER_SIZE;
+
+    unsigned int httpStatusCode;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    BUFFER_HANDLE requestHttpBody = TEST_BUFFER_REQ_BODY;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    BUFFER_HANDLE responseHttpBody = TEST_BUFFER_RESP_BODY;
+    HTTP_HEADERS_HANDLE clonedHttpHeaders = my_HTTPHeaders_Alloc();
+    BUFFER_HANDLE compressedBody = my_BUFFER_new();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_REQUEST_COMPRESSION_THRESHOLD, &compressionThreshold);
+    umock_c_reset_all_calls();
+
+    setupCompressedRequestCalls(requestHttpHeaders, clonedHttpHeaders, requestHttpBody, compressedBody, responseHttpHeaders, responseHttpBody);
+
+    /// act
+    result = HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_003: [ If request compression is enabled, requestContent is at least as large as the threshold and requestHttpHeadersHandle has no Content-Encoding header, then HTTPAPIEX_ExecuteRequest shall send the gzip compression of requestContent, with a Content-Encoding: gzip header and the Content-Length of the compressed content, without modifying requestHttpHeadersHandle. ]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteRequest_compresses_a_body_above_the_threshold)
+{
+    /// arrange
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    HTTPAPIEX_RESULT result;
+    size_t compressionThreshold = TEST_BUFFER_SIZE - 2;
+
+    unsigned int httpStatusCode;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    BUFFER_HANDLE requestHttpBody = TEST_BUFFER_REQ_BODY;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    BUFFER_HANDLE responseHttpBody = TEST_BUFFER_RESP_BODY;
+    HTTP_HEADERS_HANDLE clonedHttpHeaders = my_HTTPHeaders_Alloc();
+    BUFFER_HANDLE compressedBody = my_BUFFER_new();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_REQUEST_COMPRESSION_THRESHOLD, &compressionThreshold);
+    umock_c_reset_all_calls();
+
+    setupCompressedRequestCalls(requestHttpHeaders, clonedHttpHeaders, requestHttpBody, compressedBody, responseHttpHeaders, responseHttpBody);
+
+    /// act
+    result = HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_004: [ If the compressed content is not smaller than the request content then HTTPAPIEX_ExecuteRequest shall send the request content uncompressed. ]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteRequest_sends_the_body_uncompressed_when_the_compression_does_not_shrink_it)
+{
+    /// arrange
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    HTTPAPIEX_RESULT result;
+    size_t compressionThreshold = TEST_BUFFER_SIZE;
+
+    unsigned int httpStatusCode;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    BUFFER_HANDLE requestHttpBody = TEST_BUFFER_REQ_BODY;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    BUFFER_HANDLE responseHttpBody = TEST_BUFFER_RESP_BODY;
+    BUFFER_HANDLE compressedBody = my_BUFFER_new();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_REQUEST_COMPRESSION_THRESHOLD, &compressionThreshold);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(BUFFER_length(requestHttpBody))
+        .SetReturn(TEST_BUFFER_SIZE);
+    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(requestHttpHeaders, "Content-Encoding"));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(requestHttpBody))
+        .SetReturn(TEST_BUFFER);
+    setupCompressionCalls(compressedBody, 1);
+    STRICT_EXPECTED_CALL(BUFFER_length(compressedBody))
+        .SetReturn(TEST_BUFFER_SIZE);
+    STRICT_EXPECTED_CALL(BUFFER_delete(compressedBody));
+    /*the original headers and body are used, no Content-Encoding is added*/
+    setupAllCallBeforeHTTPsequence();
+    setupAllCallForHTTPsequence(TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, responseHttpHeaders, responseHttpBody);
+
+    /// act
+    result = HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_003: [ If request compression is enabled, requestContent is at least as large as the threshold and requestHttpHeadersHandle has no Content-Encoding header, then HTTPAPIEX_ExecuteRequest shall send the gzip compression of requestContent, with a Content-Encoding: gzip header and the Content-Length of the compressed content, without modifying requestHttpHeadersHandle. ]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteRequest_does_not_compress_a_body_that_already_has_a_Content_Encoding)
+{
+    /// arrange
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    HTTPAPIEX_RESULT result;
+    size_t compressionThreshold = TEST_BUFFER_SIZE;
+
+    unsigned int httpStatusCode;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    BUFFER_HANDLE requestHttpBody = TEST_BUFFER_REQ_BODY;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    BUFFER_HANDLE responseHttpBody = TEST_BUFFER_RESP_BODY;
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_REQUEST_COMPRESSION_THRESHOLD, &compressionThreshold);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(BUFFER_length(requestHttpBody))
+        .SetReturn(TEST_BUFFER_SIZE);
+    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(requestHttpHeaders, "Content-Encoding"))
+        .SetReturn("br");
+    setupAllCallBeforeHTTPsequence();
+    setupAllCallForHTTPsequence(TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, responseHttpHeaders, responseHttpBody);
+
+    /// act
+    result = HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*the failure tests below also show that neither the request body nor the request headers are touched when the compression fails*/
+
+/*Tests_SRS_HTTPAPIEX_01_005: [ If compressing the request content fails then HTTPAPIEX_ExecuteRequest shall fail and return HTTPAPIEX_ERROR. ]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteRequest_fails_when_deflateInit2_fails)
+{
+    /// arrange
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    HTTPAPIEX_RESULT result;
+    size_t compressionThreshold = TEST_BUFFER_SIZE;
+
+    unsigned int httpStatusCode;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    BUFFER_HANDLE requestHttpBody = TEST_BUFFER_REQ_BODY;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    BUFFER_HANDLE responseHttpBody = TEST_BUFFER_RESP_BODY;
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_REQUEST_COMPRESSION_THRESHOLD, &compressionThreshold);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(BUFFER_length(requestHttpBody))
+        .SetReturn(TEST_BUFFER_SIZE);
+    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(requestHttpHeaders, "Content-Encoding"));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(requestHttpBody))
+        .SetReturn(TEST_BUFFER);
+    STRICT_EXPECTED_CALL(gballoc_malloc(TEST_COMPRESSION_CHUNKS_SIZE));
+    STRICT_EXPECTED_CALL(deflateInit2_(IGNORED_PTR_ARG, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY, IGNORED_PTR_ARG, (int)sizeof(z_stream)))
+        .IgnoreArgument(1)
+        .IgnoreArgument(7)
+        .SetReturn(Z_MEM_ERROR);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    /// act
+    result = HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_005: [ If compressing the request content fails then HTTPAPIEX_ExecuteRequest shall fail and return HTTPAPIEX_ERROR. ]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteRequest_fails_when_creating_the_compressed_buffer_fails)
+{
+    /// arrange
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    HTTPAPIEX_RESULT result;
+    size_t compressionThreshold = TEST_BUFFER_SIZE;
+
+    unsigned int httpStatusCode;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    BUFFER_HANDLE requestHttpBody = TEST_BUFFER_REQ_BODY;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    BUFFER_HANDLE responseHttpBody = TEST_BUFFER_RESP_BODY;
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_REQUEST_COMPRESSION_THRESHOLD, &compressionThreshold);
+    umock_c_reset_all_calls();
+
+    setupCompressionStartCalls(requestHttpHeaders, requestHttpBody);
+    STRICT_EXPECTED_CALL(BUFFER_new())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(deflateEnd(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    /// act
+    result = HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_005: [ If compressing the request content fails then HTTPAPIEX_ExecuteRequest shall fail and return HTTPAPIEX_ERROR. ]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteRequest_fails_when_deflate_fails)
+{
+    /// arrange
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    HTTPAPIEX_RESULT result;
+    size_t compressionThreshold = TEST_BUFFER_SIZE;
+
+    unsigned int httpStatusCode;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    BUFFER_HANDLE requestHttpBody = TEST_BUFFER_REQ_BODY;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    BUFFER_HANDLE responseHttpBody = TEST_BUFFER_RESP_BODY;
+    BUFFER_HANDLE compressedBody = my_BUFFER_new();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_REQUEST_COMPRESSION_THRESHOLD, &compressionThreshold);
+    umock_c_reset_all_calls();
+
+    setupCompressionStartCalls(requestHttpHeaders, requestHttpBody);
+    STRICT_EXPECTED_CALL(BUFFER_new())
+        .SetReturn(compressedBody);
+    STRICT_EXPECTED_CALL(deflate(IGNORED_PTR_ARG, Z_NO_FLUSH))
+        .IgnoreArgument(1)
+        .SetReturn(Z_STREAM_ERROR);
+    STRICT_EXPECTED_CALL(BUFFER_delete(compressedBody));
+    STRICT_EXPECTED_CALL(deflateEnd(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    /// act
+    result = HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_005: [ If compressing the request content fails then HTTPAPIEX_ExecuteRequest shall fail and return HTTPAPIEX_ERROR. ]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteRequest_fails_when_appending_to_the_compressed_buffer_fails)
+{
+    /// arrange
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    HTTPAPIEX_RESULT result;
+    size_t compressionThreshold = TEST_BUFFER_SIZE;
+
+    unsigned int httpStatusCode;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    BUFFER_HANDLE requestHttpBody = TEST_BUFFER_REQ_BODY;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    BUFFER_HANDLE responseHttpBody = TEST_BUFFER_RESP_BODY;
+    BUFFER_HANDLE compressedBody = my_BUFFER_new();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_REQUEST_COMPRESSION_THRESHOLD, &compressionThreshold);
+    umock_c_reset_all_calls();
+
+    setupCompressionStartCalls(requestHttpHeaders, requestHttpBody);
+    STRICT_EXPECTED_CALL(BUFFER_new())
+        .SetReturn(compressedBody);
+    STRICT_EXPECTED_CALL(deflate(IGNORED_PTR_ARG, Z_NO_FLUSH))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(deflate(IGNORED_PTR_ARG, Z_FINISH))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(BUFFER_append_build(compressedBody, IGNORED_PTR_ARG, TEST_COMPRESSED_CONTENT_SIZE))
+        .IgnoreArgument(2)
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(BUFFER_delete(compressedBody));
+    STRICT_EXPECTED_CALL(deflateEnd(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    /// act
+    result = HTTPAPIEX_ExecuteRequest(httpapiexhandle, HTTPAPI_REQUEST_PATCH, TEST_RELATIVE_PATH, requestHttpHeaders, requestHttpBody, &httpStatusCode, responseHttpHeaders, responseHttpBody);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+/*Tests_SRS_HTTPAPIEX_01_006: [ If request compression is enabled, requestContentLength is at least as large as the threshold and requestHttpHeadersHandle has no Content-Encoding header, then HTTPAPIEX_ExecuteStreamingRequest shall read the request body with readRequestContent and compress it as it is read, before sending the compressed body with a Content-Encoding: gzip header and the Content-Length of the compressed body. ]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteStreamingRequest_compresses_the_body_as_it_is_read)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    size_t compressionThreshold = TEST_BUFFER_SIZE;
+    unsigned int httpStatusCode;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    HTTP_HEADERS_HANDLE clonedHttpHeaders = my_HTTPHeaders_Alloc();
+    BUFFER_HANDLE compressedBody = my_BUFFER_new();
+    size_t readCalls = 0;
+    size_t received = 0;
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_REQUEST_COMPRESSION_THRESHOLD, &compressionThreshold);
+    streamingRequestResult = HTTPAPI_OK;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(requestHttpHeaders, "Content-Encoding"));
+    /*test_read_content gives TEST_BUFFER_SIZE bytes at a time, the body is read and compressed in 2 pieces*/
+    setupCompressionCalls(compressedBody, 2);
+    STRICT_EXPECTED_CALL(BUFFER_length(compressedBody))
+        .SetReturn(TEST_COMPRESSED_CONTENT_SIZE);
+    STRICT_EXPECTED_CALL(HTTPHeaders_Clone(requestHttpHeaders))
+        .SetReturn(clonedHttpHeaders);
+    STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, IGNORED_NUM_ARG, TEST_COMPRESSED_CONTENT_SIZE))
+        .IgnoreArgument(1).IgnoreArgument(2);
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(clonedHttpHeaders, "Host", TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(clonedHttpHeaders, "Content-Length", TOSTRING(TEST_COMPRESSED_CONTENT_SIZE)));
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(clonedHttpHeaders, "Content-Encoding", "gzip"));
+    STRICT_EXPECTED_CALL(HTTPAPI_Init());
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPAPI_CreateConnection(TEST_HOSTNAME));
+    STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(HTTPAPI_ExecuteStreamingRequest(IGNORED_PTR_ARG, HTTPAPI_REQUEST_PUT, TEST_RELATIVE_PATH, clonedHttpHeaders, TEST_COMPRESSED_CONTENT_SIZE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, responseHttpHeaders, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument(1)
+        .IgnoreArgument(6)
+        .IgnoreArgument(7)
+        .IgnoreArgument(8)
+        .IgnoreArgument(10)
+        .IgnoreArgument(11);
+    /*this is the adapter reading the compressed body*/
+    STRICT_EXPECTED_CALL(BUFFER_length(compressedBody))
+        .SetReturn(TEST_COMPRESSED_CONTENT_SIZE);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(compressedBody))
+        .SetReturn((unsigned char*)TEST_COMPRESSED_CONTENT);
+    STRICT_EXPECTED_CALL(HTTPHeaders_Free(clonedHttpHeaders));
+    STRICT_EXPECTED_CALL(BUFFER_delete(compressedBody));
+
+    /// act
+    result = HTTPAPIEX_ExecuteStreamingRequest(httpapiexhandle, HTTPAPI_REQUEST_PUT, TEST_RELATIVE_PATH, requestHttpHeaders, 2 * TEST_BUFFER_SIZE, test_read_content, &readCalls, &httpStatusCode, responseHttpHeaders, test_write_content, &received);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 2, readCalls);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(streamedRequestContent, TEST_COMPRESSED_CONTENT, TEST_COMPRESSED_CONTENT_SIZE));
+    ASSERT_ARE_EQUAL(size_t, TEST_STREAMED_CONTENT_SIZE, received);
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+
+static int test_read_content_fails(void* context, unsigned char* buffer, size_t bufferSize, size_t* bytesRead)
+{
+    (void)context;
+    (void)buffer;
+    (void)bufferSize;
+    *bytesRead = 0;
+    return 1;
+}
+
+/*Tests_SRS_HTTPAPIEX_01_007: [ If reading or compressing the request body fails then HTTPAPIEX_ExecuteStreamingRequest shall fail and return HTTPAPIEX_ERROR. ]*/
+TEST_FUNCTION(HTTPAPIEX_ExecuteStreamingRequest_fails_when_reading_the_body_to_compress_fails)
+{
+    /// arrange
+    HTTPAPIEX_RESULT result;
+    HTTPAPIEX_HANDLE httpapiexhandle = HTTPAPIEX_Create(TEST_HOSTNAME);
+    size_t compressionThreshold = TEST_BUFFER_SIZE;
+    unsigned int httpStatusCode;
+    HTTP_HEADERS_HANDLE requestHttpHeaders;
+    HTTP_HEADERS_HANDLE responseHttpHeaders;
+    BUFFER_HANDLE compressedBody = my_BUFFER_new();
+    createHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    (void)HTTPAPIEX_SetOption(httpapiexhandle, OPTION_HTTPAPIEX_REQUEST_COMPRESSION_THRESHOLD, &compressionThreshold);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(requestHttpHeaders, "Content-Encoding"));
+    STRICT_EXPECTED_CALL(gballoc_malloc(TEST_COMPRESSION_CHUNKS_SIZE));
+    STRICT_EXPECTED_CALL(deflateInit2_(IGNORED_PTR_ARG, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY, IGNORED_PTR_ARG, (int)sizeof(z_stream)))
+        .IgnoreArgument(1)
+        .IgnoreArgument(7);
+    STRICT_EXPECTED_CALL(BUFFER_new())
+        .SetReturn(compressedBody);
+    STRICT_EXPECTED_CALL(BUFFER_delete(compressedBody));
+    STRICT_EXPECTED_CALL(deflateEnd(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        .IgnoreArgument(1);
+
+    /// act
+    result = HTTPAPIEX_ExecuteStreamingRequest(httpapiexhandle, HTTPAPI_REQUEST_PUT, TEST_RELATIVE_PATH, requestHttpHeaders, TEST_BUFFER_SIZE, test_read_content_fails, NULL, &httpStatusCode, responseHttpHeaders, NULL, NULL);
+
+    ///assert
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, HTTPAPIEX_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///destroy
+    destroyHttpObjects(&requestHttpHeaders, &responseHttpHeaders);
+    HTTPAPIEX_Destroy(httpapiexhandle);
+}
+#endif
+
 TEST_FUNCTION(HTTPAPIEX_Destroy_with_NULL_argument_does_nothing)
 {
     /// arrange
@@ -32,6 +32,7 @@ static void my_gballoc_free(void* ptr)
 #include "azure_c_shared_utility/agenttime.h"
 #include "azure_c_shared_utility/strings.h"
 #include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/hmacsha256.h"
 #include "azure_c_shared_utility/sastoken.h"
 #include "azure_c_shared_utility/httpheaders.h"
 #include "azure_c_shared_utility/httpapiex.h"
@@ -62,6 +63,7 @@ IMPLEMENT_UMOCK_C_ENUM_TYPE(HTTP_HEADERS_RESULT, HTTP_HEADERS_RESULT_VALUES);
 #define TEST_RESPONSE_CONTENT (BUFFER_HANDLE)0x59
 #define TEST_CONST_CHAR_STAR_NULL (const char*)NULL
 #define TEST_SASTOKEN_HANDLE (STRING_HANDLE)0x60
+#define TEST_KEY_CONTEXT_HANDLE (HMACSHA256_KEY_CONTEXT_HANDLE)0x61
 #define TEST_EXPIRY ((size_t)7200)
 #define TEST_TIME_T ((time_t)-1)
 
@@ -102,6 +104,12 @@ static STRING_HANDLE my_SASToken_CreateString(const char* key, const char* scope
     return (STRING_HANDLE)my_gballoc_malloc(1);
 }
 
+static STRING_HANDLE my_SASToken_CreateStringWithKeyContext(HMACSHA256_KEY_CONTEXT_HANDLE keyContext, const char* scope, const char* keyName, size_t expiry)
+{
+    (void)keyContext, (void)scope, (void)keyName, (void)expiry;
+    return (STRING_HANDLE)my_gballoc_malloc(1);
+}
+
 static void setupSASString_Create_happy_path(bool allocateKeyName)
 {
     STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
@@ -111,6 +119,7 @@ static void setupSASString_Create_happy_path(bool allocateKeyName)
     {
         STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     }
+    STRICT_EXPECTED_CALL(SASToken_CreateKeyContext(TEST_KEY));
 }
 
 static void setupSAS_Create_happy_path_provide_key(bool useSasKey, bool allocateKeyName)
@@ -129,6 +138,10 @@ static void setupSAS_Create_happy_path_provide_key(bool useSasKey, bool allocate
     {
         STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     }
+    if (!useSasKey)
+    {
+        STRICT_EXPECTED_CALL(SASToken_CreateKeyContext(TEST_KEY));
+    }
 }
 
 static void setupSAS_Create_happy_path(bool allocateKeyName)
@@ -136,6 +149,21 @@ static void setupSAS_Create_happy_path(bool allocateKeyName)
     setupSAS_Create_happy_path_provide_key(false, allocateKeyName);
 }
 
+static void setupSAS_ExecuteRequest_creates_token(time_t currentTime, size_t expiry, unsigned int* statusCode)
+{
+    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization")).SetReturn(TEST_CHAR_ARRAY);
+    STRICT_EXPECTED_CALL(get_time_coarse()).SetReturn(currentTime);
+    STRICT_EXPECTED_CALL(SASToken_CreateString(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, expiry));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_CHAR_ARRAY);
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization", TEST_CHAR_ARRAY)).SetReturn(HTTP_HEADERS_OK);
+    STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(TEST_HTTPAPIEX_HANDLE, TEST_HTTPAPI_REQUEST_TYPE, TEST_CHAR_ARRAY, TEST_REQUEST_HTTP_HEADERS_HANDLE, TEST_REQUEST_CONTENT, statusCode, TEST_RESPONSE_HTTP_HEADERS_HANDLE, TEST_RESPONSE_CONTENT));
+}
+
+static HTTPAPIEX_RESULT execute_request(HTTPAPIEX_SAS_HANDLE sasHandle, unsigned int* statusCode)
+{
+    return HTTPAPIEX_SAS_ExecuteRequest(sasHandle, TEST_HTTPAPIEX_HANDLE, TEST_HTTPAPI_REQUEST_TYPE, TEST_CHAR_ARRAY, TEST_REQUEST_HTTP_HEADERS_HANDLE, TEST_REQUEST_CONTENT, statusCode, TEST_RESPONSE_HTTP_HEADERS_HANDLE, TEST_RESPONSE_CONTENT);
+}
+
 DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
 
 static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
@@ -210,11 +238,13 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_TYPE(time_t, time_t);
     REGISTER_UMOCK_ALIAS_TYPE(HTTPAPIEX_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(BUFFER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(HMACSHA256_KEY_CONTEXT_HANDLE, void*);
     REGISTER_TYPE(HTTPAPI_REQUEST_TYPE, HTTPAPI_REQUEST_TYPE);
 
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
     REGISTER_GLOBAL_MOCK_HOOK(SASToken_CreateString, my_SASToken_CreateString);
+    REGISTER_GLOBAL_MOCK_HOOK(SASToken_CreateStringWithKeyContext, my_SASToken_CreateStringWithKeyContext);
     REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, my_mallocAndStrcpy_s);
 
     REGISTER_GLOBAL_MOCK_RETURN(STRING_c_str, TEST_CONST_CHAR_STAR_NULL);
@@ -225,7 +255,7 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_GLOBAL_MOCK_RETURN(HTTPAPIEX_ExecuteRequest, HTTPAPIEX_OK);
     REGISTER_GLOBAL_MOCK_RETURN(HTTPHeaders_FindHeaderValue, TEST_CONST_CHAR_STAR_NULL);
     REGISTER_GLOBAL_MOCK_RETURN(HTTPHeaders_ReplaceHeaderNameValuePair, HTTP_HEADERS_ERROR);
-    REGISTER_GLOBAL_MOCK_RETURN(get_time, TEST_TIME_T);
+    REGISTER_GLOBAL_MOCK_RETURN(get_time_coarse, TEST_TIME_T);
 }
 
 TEST_SUITE_CLEANUP(TestClassCleanup)
@@ -577,7 +607,7 @@ TEST_FUNCTION(HTTPAPIEX_SAS_invoke_executerequest_findheadervalues_returns_null_
     HTTPAPIEX_SAS_Destroy(sasHandle);
 }
 
-/*Tests_SRS_HTTPAPIEXSAS_06_018: [A value of type time_t that shall be known as currentTime is obtained from calling get_time.]*/
+/*Tests_SRS_HTTPAPIEXSAS_06_018: [A value of type time_t that shall be known as currentTime is obtained from calling get_time_coarse.]*/
 /*Tests_SRS_HTTPAPIEXSAS_06_019: [If the value of currentTime is (time_t)-1 is then fallthrough.]*/
 TEST_FUNCTION(HTTPAPIEX_SAS_invoke_executerequest_get_time_fails)
 {
@@ -592,7 +622,7 @@ TEST_FUNCTION(HTTPAPIEX_SAS_invoke_executerequest_get_time_fails)
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization")).SetReturn(TEST_CHAR_ARRAY);
-    STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn((time_t)-1);
+    STRICT_EXPECTED_CALL(get_time_coarse()).SetReturn((time_t)-1);
     STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(TEST_HTTPAPIEX_HANDLE, TEST_HTTPAPI_REQUEST_TYPE, TEST_CHAR_ARRAY, TEST_REQUEST_HTTP_HEADERS_HANDLE, TEST_REQUEST_CONTENT, &statusCode, TEST_RESPONSE_HTTP_HEADERS_HANDLE, TEST_RESPONSE_CONTENT)).SetReturn(HTTPAPIEX_OK);
 
     // act
@@ -620,11 +650,10 @@ TEST_FUNCTION(HTTPAPIEX_SAS_invoke_executerequest_sas_is_provided_succeeds)
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization")).SetReturn(TEST_CHAR_ARRAY);
-    STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(3600);
+    STRICT_EXPECTED_CALL(get_time_coarse()).SetReturn(3600);
     STRICT_EXPECTED_CALL(STRING_construct(TEST_SAS));
     STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_CHAR_ARRAY);
     STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization", IGNORED_PTR_ARG)).SetReturn(HTTP_HEADERS_ERROR);
-    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(TEST_HTTPAPIEX_HANDLE, TEST_HTTPAPI_REQUEST_TYPE, TEST_CHAR_ARRAY, TEST_REQUEST_HTTP_HEADERS_HANDLE, TEST_REQUEST_CONTENT, &statusCode, TEST_RESPONSE_HTTP_HEADERS_HANDLE, TEST_RESPONSE_CONTENT)).SetReturn(HTTPAPIEX_OK);
 
     // act
@@ -653,7 +682,7 @@ TEST_FUNCTION(HTTPAPIEX_SAS_invoke_executerequest_sastoken_create_returns_null_s
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization")).SetReturn(TEST_CHAR_ARRAY);
-    STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(3600);
+    STRICT_EXPECTED_CALL(get_time_coarse()).SetReturn(3600);
     STRICT_EXPECTED_CALL(SASToken_CreateString(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, TEST_EXPIRY)).SetReturn(NULL);
     STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(TEST_HTTPAPIEX_HANDLE, TEST_HTTPAPI_REQUEST_TYPE, TEST_CHAR_ARRAY, TEST_REQUEST_HTTP_HEADERS_HANDLE, TEST_REQUEST_CONTENT, &statusCode, TEST_RESPONSE_HTTP_HEADERS_HANDLE, TEST_RESPONSE_CONTENT)).SetReturn(HTTPAPIEX_OK);
 
@@ -670,7 +699,6 @@ TEST_FUNCTION(HTTPAPIEX_SAS_invoke_executerequest_sastoken_create_returns_null_s
 
 /*Tests_SRS_HTTPAPIEXSAS_06_013: [HTTPHeaders_ReplaceHeaderNameValuePair shall be invoked with "Authorization" as its second argument and STRING_c_str (newSASToken) as its third argument.]*/
 /*Tests_SRS_HTTPAPIEXSAS_06_014: [If the result of the invocation of HTTPHeaders_ReplaceHeaderNameValuePair is NOT HTTP_HEADERS_OK then fallthrough.]*/
-/*Tests_SRS_HTTPAPIEXSAS_06_015: [STRING_delete(newSASToken) will be invoked.]*/
 TEST_FUNCTION(HTTPAPIEX_SAS_invoke_executerequest_replace_header_name_value_pair_fails_succeeds)
 {
 
@@ -684,11 +712,10 @@ TEST_FUNCTION(HTTPAPIEX_SAS_invoke_executerequest_replace_header_name_value_pair
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization")).SetReturn(TEST_CHAR_ARRAY);
-    STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn(3600);
+    STRICT_EXPECTED_CALL(get_time_coarse()).SetReturn(3600);
     STRICT_EXPECTED_CALL(SASToken_CreateString(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, TEST_EXPIRY));
     STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_CHAR_ARRAY);
     STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization", IGNORED_PTR_ARG)).SetReturn(HTTP_HEADERS_ERROR);
-    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(TEST_HTTPAPIEX_HANDLE, TEST_HTTPAPI_REQUEST_TYPE, TEST_CHAR_ARRAY, TEST_REQUEST_HTTP_HEADERS_HANDLE, TEST_REQUEST_CONTENT, &statusCode, TEST_RESPONSE_HTTP_HEADERS_HANDLE, TEST_RESPONSE_CONTENT)).SetReturn(HTTPAPIEX_OK);
 
     // act
@@ -716,11 +743,10 @@ TEST_FUNCTION(HTTPAPIEX_SAS_invoke_executerequest_replace_header_name_value_pair
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization")).SetReturn(TEST_CHAR_ARRAY);
-    STRICT_EXPECTED_CALL(get_time(NULL)).SetReturn((time_t)3600);
+    STRICT_EXPECTED_CALL(get_time_coarse()).SetReturn((time_t)3600);
     STRICT_EXPECTED_CALL(SASToken_CreateString(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, TEST_EXPIRY));
     STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_CHAR_ARRAY);
     STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization", TEST_CHAR_ARRAY)).SetReturn(HTTP_HEADERS_OK);
-    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(TEST_HTTPAPIEX_HANDLE, TEST_HTTPAPI_REQUEST_TYPE, TEST_CHAR_ARRAY, TEST_REQUEST_HTTP_HEADERS_HANDLE, TEST_REQUEST_CONTENT, &statusCode, TEST_RESPONSE_HTTP_HEADERS_HANDLE, TEST_RESPONSE_CONTENT));
 
     // act
@@ -734,4 +760,303 @@ TEST_FUNCTION(HTTPAPIEX_SAS_invoke_executerequest_replace_header_name_value_pair
     HTTPAPIEX_SAS_Destroy(sasHandle);
 }
 
+/*Tests_SRS_HTTPAPIEXSAS_01_002: [ If key is not prefixed with "sas=", the key context used to sign the SAS tokens shall be created once by calling SASToken_CreateKeyContext. ]*/
+/*Tests_SRS_HTTPAPIEXSAS_01_004: [ If a key context was created, SASToken_CreateStringWithKeyContext shall be invoked with it instead of SASToken_CreateString. ]*/
+TEST_FUNCTION(HTTPAPIEX_SAS_invoke_executerequest_with_key_context_uses_SASToken_CreateStringWithKeyContext)
+{
+    HTTPAPIEX_RESULT result;
+    unsigned int statusCode;
+    HTTPAPIEX_SAS_HANDLE sasHandle;
+
+    // arrange
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_KEY);
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_URI_RESOURCE);
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_KEY_NAME);
+    STRICT_EXPECTED_CALL(SASToken_CreateKeyContext(TEST_KEY)).SetReturn(TEST_KEY_CONTEXT_HANDLE);
+    sasHandle = HTTPAPIEX_SAS_Create(TEST_KEY_HANDLE, TEST_URIRESOURCE_HANDLE, TEST_KEYNAME_HANDLE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization")).SetReturn(TEST_CHAR_ARRAY);
+    STRICT_EXPECTED_CALL(get_time_coarse()).SetReturn((time_t)3600);
+    STRICT_EXPECTED_CALL(SASToken_CreateStringWithKeyContext(TEST_KEY_CONTEXT_HANDLE, TEST_URI_RESOURCE, TEST_KEY_NAME, TEST_EXPIRY));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_CHAR_ARRAY);
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization", TEST_CHAR_ARRAY)).SetReturn(HTTP_HEADERS_OK);
+    STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(TEST_HTTPAPIEX_HANDLE, TEST_HTTPAPI_REQUEST_TYPE, TEST_CHAR_ARRAY, TEST_REQUEST_HTTP_HEADERS_HANDLE, TEST_REQUEST_CONTENT, &statusCode, TEST_RESPONSE_HTTP_HEADERS_HANDLE, TEST_RESPONSE_CONTENT));
+
+    // act
+    result = HTTPAPIEX_SAS_ExecuteRequest(sasHandle, TEST_HTTPAPIEX_HANDLE, TEST_HTTPAPI_REQUEST_TYPE, TEST_CHAR_ARRAY, TEST_REQUEST_HTTP_HEADERS_HANDLE, TEST_REQUEST_CONTENT, &statusCode, TEST_RESPONSE_HTTP_HEADERS_HANDLE, TEST_RESPONSE_CONTENT);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, result, HTTPAPIEX_OK);
+
+    // Cleanup
+    HTTPAPIEX_SAS_Destroy(sasHandle);
+}
+
+/*Tests_SRS_HTTPAPIEXSAS_06_006: [HTTAPIEX_SAS_Destroy shall deallocate any structures denoted by the parameter handle.]*/
+TEST_FUNCTION(HTTPAPIEX_SAS_Destroy_destroys_the_key_context)
+{
+    // arrange
+    HTTPAPIEX_SAS_HANDLE handle;
+
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_KEY);
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_URI_RESOURCE);
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_KEY_NAME);
+    STRICT_EXPECTED_CALL(SASToken_CreateKeyContext(TEST_KEY)).SetReturn(TEST_KEY_CONTEXT_HANDLE);
+    handle = HTTPAPIEX_SAS_Create(TEST_KEY_HANDLE, TEST_URIRESOURCE_HANDLE, TEST_KEYNAME_HANDLE);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HMACSHA256_KeyContext_Destroy(TEST_KEY_CONTEXT_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    HTTPAPIEX_SAS_Destroy(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* HTTPAPIEX_SAS_SetTokenRefreshMargin */
+
+/*Tests_SRS_HTTPAPIEXSAS_01_005: [ If sasHandle is NULL, HTTPAPIEX_SAS_SetTokenRefreshMargin shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(HTTPAPIEX_SAS_SetTokenRefreshMargin_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = HTTPAPIEX_SAS_SetTokenRefreshMargin(NULL, 60);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_HTTPAPIEXSAS_01_006: [ Otherwise HTTPAPIEX_SAS_SetTokenRefreshMargin shall set the refresh margin used by the following requests and return 0. ]*/
+TEST_FUNCTION(HTTPAPIEX_SAS_SetTokenRefreshMargin_changes_when_the_token_is_refreshed)
+{
+    // arrange
+    int result;
+    unsigned int statusCode;
+    HTTPAPIEX_SAS_HANDLE sasHandle;
+
+    setupSAS_Create_happy_path(true);
+    sasHandle = HTTPAPIEX_SAS_Create(TEST_KEY_HANDLE, TEST_URIRESOURCE_HANDLE, TEST_KEYNAME_HANDLE);
+    setupSAS_ExecuteRequest_creates_token((time_t)3600, TEST_EXPIRY, &statusCode);
+    (void)execute_request(sasHandle, &statusCode);
+    umock_c_reset_all_calls();
+
+    // act
+    result = HTTPAPIEX_SAS_SetTokenRefreshMargin(sasHandle, 60);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // the token expires in 100 seconds, more than the 60 seconds margin
+    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization")).SetReturn(TEST_CHAR_ARRAY);
+    STRICT_EXPECTED_CALL(get_time_coarse()).SetReturn((time_t)(TEST_EXPIRY - 100));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_CHAR_ARRAY);
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization", TEST_CHAR_ARRAY)).SetReturn(HTTP_HEADERS_OK);
+    STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(TEST_HTTPAPIEX_HANDLE, TEST_HTTPAPI_REQUEST_TYPE, TEST_CHAR_ARRAY, TEST_REQUEST_HTTP_HEADERS_HANDLE, TEST_REQUEST_CONTENT, &statusCode, TEST_RESPONSE_HTTP_HEADERS_HANDLE, TEST_RESPONSE_CONTENT));
+    (void)execute_request(sasHandle, &statusCode);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // Cleanup
+    HTTPAPIEX_SAS_Destroy(sasHandle);
+}
+
+/* token cache */
+
+/*Tests_SRS_HTTPAPIEXSAS_01_007: [ If a token was made by a previous request and it expires later than the refresh margin from currentTime, it shall be used again without creating a new one. ]*/
+TEST_FUNCTION(HTTPAPIEX_SAS_invoke_executerequest_reuses_the_token_of_the_previous_request)
+{
+    HTTPAPIEX_RESULT result;
+    unsigned int statusCode;
+    HTTPAPIEX_SAS_HANDLE sasHandle;
+
+    // arrange
+    setupSAS_Create_happy_path(true);
+    sasHandle = HTTPAPIEX_SAS_Create(TEST_KEY_HANDLE, TEST_URIRESOURCE_HANDLE, TEST_KEYNAME_HANDLE);
+    setupSAS_ExecuteRequest_creates_token((time_t)3600, TEST_EXPIRY, &statusCode);
+    (void)execute_request(sasHandle, &statusCode);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization")).SetReturn(TEST_CHAR_ARRAY);
+    STRICT_EXPECTED_CALL(get_time_coarse()).SetReturn((time_t)(TEST_EXPIRY - HTTPAPIEX_SAS_DEFAULT_TOKEN_REFRESH_MARGIN - 1));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_CHAR_ARRAY);
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization", TEST_CHAR_ARRAY)).SetReturn(HTTP_HEADERS_OK);
+    STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(TEST_HTTPAPIEX_HANDLE, TEST_HTTPAPI_REQUEST_TYPE, TEST_CHAR_ARRAY, TEST_REQUEST_HTTP_HEADERS_HANDLE, TEST_REQUEST_CONTENT, &statusCode, TEST_RESPONSE_HTTP_HEADERS_HANDLE, TEST_RESPONSE_CONTENT));
+
+    // act
+    result = execute_request(sasHandle, &statusCode);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, result, HTTPAPIEX_OK);
+
+    // Cleanup
+    HTTPAPIEX_SAS_Destroy(sasHandle);
+}
+
+/*Tests_SRS_HTTPAPIEXSAS_06_015: [The previous token shall be deleted with STRING_delete when it is replaced by newSASToken.]*/
+TEST_FUNCTION(HTTPAPIEX_SAS_invoke_executerequest_refreshes_a_token_within_the_refresh_margin)
+{
+    HTTPAPIEX_RESULT result;
+    unsigned int statusCode;
+    HTTPAPIEX_SAS_HANDLE sasHandle;
+    time_t refreshTime = (time_t)(TEST_EXPIRY - HTTPAPIEX_SAS_DEFAULT_TOKEN_REFRESH_MARGIN);
+
+    // arrange
+    setupSAS_Create_happy_path(true);
+    sasHandle = HTTPAPIEX_SAS_Create(TEST_KEY_HANDLE, TEST_URIRESOURCE_HANDLE, TEST_KEYNAME_HANDLE);
+    setupSAS_ExecuteRequest_creates_token((time_t)3600, TEST_EXPIRY, &statusCode);
+    (void)execute_request(sasHandle, &statusCode);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization")).SetReturn(TEST_CHAR_ARRAY);
+    STRICT_EXPECTED_CALL(get_time_coarse()).SetReturn(refreshTime);
+    STRICT_EXPECTED_CALL(SASToken_CreateString(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, (size_t)refreshTime + 3600));
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_CHAR_ARRAY);
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization", TEST_CHAR_ARRAY)).SetReturn(HTTP_HEADERS_OK);
+    STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(TEST_HTTPAPIEX_HANDLE, TEST_HTTPAPI_REQUEST_TYPE, TEST_CHAR_ARRAY, TEST_REQUEST_HTTP_HEADERS_HANDLE, TEST_REQUEST_CONTENT, &statusCode, TEST_RESPONSE_HTTP_HEADERS_HANDLE, TEST_RESPONSE_CONTENT));
+
+    // act
+    result = execute_request(sasHandle, &statusCode);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, result, HTTPAPIEX_OK);
+
+    // Cleanup
+    HTTPAPIEX_SAS_Destroy(sasHandle);
+}
+
+/*Tests_SRS_HTTPAPIEXSAS_01_008: [ A token provided with the "sas=" prefix shall never be refreshed. ]*/
+TEST_FUNCTION(HTTPAPIEX_SAS_invoke_executerequest_never_refreshes_a_provided_sas)
+{
+    HTTPAPIEX_RESULT result;
+    unsigned int statusCode;
+    HTTPAPIEX_SAS_HANDLE sasHandle;
+
+    // arrange
+    setupSAS_Create_happy_path_provide_key(true, true);
+    sasHandle = HTTPAPIEX_SAS_Create(TEST_KEY_HANDLE, TEST_URIRESOURCE_HANDLE, TEST_KEYNAME_HANDLE);
+    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization")).SetReturn(TEST_CHAR_ARRAY);
+    STRICT_EXPECTED_CALL(get_time_coarse()).SetReturn(3600);
+    (void)execute_request(sasHandle, &statusCode);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization")).SetReturn(TEST_CHAR_ARRAY);
+    STRICT_EXPECTED_CALL(get_time_coarse()).SetReturn(3600 * 24);
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_CHAR_ARRAY);
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization", TEST_CHAR_ARRAY)).SetReturn(HTTP_HEADERS_OK);
+    STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(TEST_HTTPAPIEX_HANDLE, TEST_HTTPAPI_REQUEST_TYPE, TEST_CHAR_ARRAY, TEST_REQUEST_HTTP_HEADERS_HANDLE, TEST_REQUEST_CONTENT, &statusCode, TEST_RESPONSE_HTTP_HEADERS_HANDLE, TEST_RESPONSE_CONTENT));
+
+    // act
+    result = execute_request(sasHandle, &statusCode);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, result, HTTPAPIEX_OK);
+
+    // Cleanup
+    HTTPAPIEX_SAS_Destroy(sasHandle);
+}
+
+/*Tests_SRS_HTTPAPIEXSAS_01_009: [ If creating the new token fails, the previous token shall still be used if it has not expired yet. ]*/
+TEST_FUNCTION(HTTPAPIEX_SAS_invoke_executerequest_uses_the_previous_token_when_refreshing_fails)
+{
+    HTTPAPIEX_RESULT result;
+    unsigned int statusCode;
+    HTTPAPIEX_SAS_HANDLE sasHandle;
+    time_t refreshTime = (time_t)(TEST_EXPIRY - 1);
+
+    // arrange
+    setupSAS_Create_happy_path(true);
+    sasHandle = HTTPAPIEX_SAS_Create(TEST_KEY_HANDLE, TEST_URIRESOURCE_HANDLE, TEST_KEYNAME_HANDLE);
+    setupSAS_ExecuteRequest_creates_token((time_t)3600, TEST_EXPIRY, &statusCode);
+    (void)execute_request(sasHandle, &statusCode);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization")).SetReturn(TEST_CHAR_ARRAY);
+    STRICT_EXPECTED_CALL(get_time_coarse()).SetReturn(refreshTime);
+    STRICT_EXPECTED_CALL(SASToken_CreateString(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, (size_t)refreshTime + 3600)).SetReturn(NULL);
+    STRICT_EXPECTED_CALL(STRING_c_str(IGNORED_PTR_ARG)).SetReturn(TEST_CHAR_ARRAY);
+    STRICT_EXPECTED_CALL(HTTPHeaders_ReplaceHeaderNameValuePair(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization", TEST_CHAR_ARRAY)).SetReturn(HTTP_HEADERS_OK);
+    STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(TEST_HTTPAPIEX_HANDLE, TEST_HTTPAPI_REQUEST_TYPE, TEST_CHAR_ARRAY, TEST_REQUEST_HTTP_HEADERS_HANDLE, TEST_REQUEST_CONTENT, &statusCode, TEST_RESPONSE_HTTP_HEADERS_HANDLE, TEST_RESPONSE_CONTENT));
+
+    // act
+    result = execute_request(sasHandle, &statusCode);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, result, HTTPAPIEX_OK);
+
+    // Cleanup
+    HTTPAPIEX_SAS_Destroy(sasHandle);
+}
+
+/*Tests_SRS_HTTPAPIEXSAS_01_009: [ If creating the new token fails, the previous token shall still be used if it has not expired yet. ]*/
+TEST_FUNCTION(HTTPAPIEX_SAS_invoke_executerequest_drops_an_expired_token_when_refreshing_fails)
+{
+    HTTPAPIEX_RESULT result;
+    unsigned int statusCode;
+    HTTPAPIEX_SAS_HANDLE sasHandle;
+    time_t refreshTime = (time_t)TEST_EXPIRY;
+
+    // arrange
+    setupSAS_Create_happy_path(true);
+    sasHandle = HTTPAPIEX_SAS_Create(TEST_KEY_HANDLE, TEST_URIRESOURCE_HANDLE, TEST_KEYNAME_HANDLE);
+    setupSAS_ExecuteRequest_creates_token((time_t)3600, TEST_EXPIRY, &statusCode);
+    (void)execute_request(sasHandle, &statusCode);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(HTTPHeaders_FindHeaderValue(TEST_REQUEST_HTTP_HEADERS_HANDLE, "Authorization")).SetReturn(TEST_CHAR_ARRAY);
+    STRICT_EXPECTED_CALL(get_time_coarse()).SetReturn(refreshTime);
+    STRICT_EXPECTED_CALL(SASToken_CreateString(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, (size_t)refreshTime + 3600)).SetReturn(NULL);
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(HTTPAPIEX_ExecuteRequest(TEST_HTTPAPIEX_HANDLE, TEST_HTTPAPI_REQUEST_TYPE, TEST_CHAR_ARRAY, TEST_REQUEST_HTTP_HEADERS_HANDLE, TEST_REQUEST_CONTENT, &statusCode, TEST_RESPONSE_HTTP_HEADERS_HANDLE, TEST_RESPONSE_CONTENT));
+
+    // act
+    result = execute_request(sasHandle, &statusCode);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(HTTPAPIEX_RESULT, result, HTTPAPIEX_OK);
+
+    // Cleanup
+    HTTPAPIEX_SAS_Destroy(sasHandle);
+}
+
+/*Tests_SRS_HTTPAPIEXSAS_06_006: [HTTAPIEX_SAS_Destroy shall deallocate any structures denoted by the parameter handle.]*/
+TEST_FUNCTION(HTTPAPIEX_SAS_Destroy_deletes_the_cached_token)
+{
+    // arrange
+    unsigned int statusCode;
+    HTTPAPIEX_SAS_HANDLE sasHandle;
+
+    setupSAS_Create_happy_path(true);
+    sasHandle = HTTPAPIEX_SAS_Create(TEST_KEY_HANDLE, TEST_URIRESOURCE_HANDLE, TEST_KEYNAME_HANDLE);
+    setupSAS_ExecuteRequest_creates_token((time_t)3600, TEST_EXPIRY, &statusCode);
+    (void)execute_request(sasHandle, &statusCode);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    HTTPAPIEX_SAS_Destroy(sasHandle);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 END_TEST_SUITE(httpapiexsas_unittests)
@@ -4,9 +4,13 @@
 #ifdef __cplusplus
 #include <cstdlib>
 #include <climits>
+#include <cstdio>
+#include <cstring>
 #else
 #include <stdlib.h>
 #include <limits.h>
+#include <stdio.h>
+#include <string.h>
 #endif
 
 static size_t currentmalloc_call = 0;
@@ -71,25 +75,6 @@ void my_gballoc_free(void* ptr)
 
 #define ENABLE_MOCKS
 
-#include "azure_c_shared_utility/map.h"
-
-MAP_HANDLE my_Map_Create(MAP_FILTER_CALLBACK mapFilterFunc)
-{
-    (void)mapFilterFunc;
-    return (MAP_HANDLE)malloc(1);
-}
-
-MAP_HANDLE my_Map_Clone(MAP_HANDLE handle)
-{
-    (void)handle;
-    return (MAP_HANDLE)malloc(1);
-}
-
-void my_Map_Destroy(MAP_HANDLE handle)
-{
-    free(handle);
-}
-
 #include "azure_c_shared_utility/gballoc.h"
 
 #undef ENABLE_MOCKS
@@ -104,8 +89,6 @@ static TEST_MUTEX_HANDLE g_testByTest;
 TEST_DEFINE_ENUM_TYPE(HTTP_HEADERS_RESULT, HTTP_HEADERS_RESULT_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(HTTP_HEADERS_RESULT, HTTP_HEADERS_RESULT_VALUES);
 
-IMPLEMENT_UMOCK_C_ENUM_TYPE(MAP_RESULT, MAP_RESULT_VALUES);
-
 /*test assets*/
 #define NAME1 "name1"
 #define VALUE1 "value1"
@@ -130,6 +113,15 @@ static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
     ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
 }
 
+static HTTP_HEADERS_HANDLE create_headers_with_name1(void)
+{
+    HTTP_HEADERS_HANDLE result = HTTPHeaders_Alloc();
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, HTTPHeaders_AddHeaderNameValuePair(result, NAME1, VALUE1));
+    umock_c_reset_all_calls();
+    return result;
+}
+
 BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
 
     TEST_SUITE_INITIALIZE(TestClassInitialize)
@@ -144,17 +136,6 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         result = umocktypes_charptr_register_types();
         ASSERT_ARE_EQUAL(int, 0, result);
 
-        REGISTER_TYPE(MAP_RESULT, MAP_RESULT);
-        REGISTER_UMOCK_ALIAS_TYPE(MAP_FILTER_CALLBACK, void*);
-        REGISTER_UMOCK_ALIAS_TYPE(MAP_HANDLE, void*);
-
-        REGISTER_GLOBAL_MOCK_HOOK(Map_Create, my_Map_Create);
-        REGISTER_GLOBAL_MOCK_HOOK(Map_Clone, my_Map_Clone);
-        REGISTER_GLOBAL_MOCK_HOOK(Map_Destroy, my_Map_Destroy);
-        REGISTER_GLOBAL_MOCK_RETURN(Map_AddOrUpdate, MAP_OK);
-        REGISTER_GLOBAL_MOCK_RETURN(Map_GetValueFromKey, VALUE1);
-        REGISTER_GLOBAL_MOCK_RETURN(Map_GetInternals, MAP_OK);
-
         REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
         REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
         REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
@@ -190,6 +171,7 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
 
 
     /*Tests_SRS_HTTP_HEADERS_99_002:[ This API shall produce a HTTP_HANDLE that can later be used in subsequent calls to the module.]*/
+    /*Tests_SRS_HTTP_HEADERS_99_038: [The names and the values of the headers shall be stored in a single arena owned by the handle, that is allocated when the first header is added and grows as needed.]*/
     TEST_FUNCTION(HTTPHeaders_Alloc_happy_path_succeeds)
     {
         ///arrange
@@ -197,8 +179,6 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(Map_Create(IGNORED_PTR_ARG));
-
         ///act
         handle = HTTPHeaders_Alloc();
 
@@ -245,40 +225,19 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     TEST_FUNCTION(HTTPHeaders_Free_with_valid_handle_succeeds)
     {
         ///arrange
-        HTTP_HEADERS_HANDLE handle = HTTPHeaders_Alloc();
-        umock_c_reset_all_calls();
+        HTTP_HEADERS_HANDLE handle = create_headers_with_name1();
 
-        STRICT_EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
-
-        ///act
-        HTTPHeaders_Free(handle);
-
-        ///assert
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    }
-
-
-    /*Tests_SRS_HTTP_HEADERS_99_003:[ The function shall return NULL when the function cannot execute properly]*/
-    TEST_FUNCTION(HTTPHeaders_Alloc_fails_when_Map_Create_fails)
-    {
-        ///arrange
-        HTTP_HEADERS_HANDLE httpHandle;
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(Map_Create(IGNORED_PTR_ARG))
-            .SetReturn(NULL);
-
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
         ///act
-        httpHandle = HTTPHeaders_Alloc();
+        HTTPHeaders_Free(handle);
 
         ///assert
-        ASSERT_IS_NULL(httpHandle);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     }
 
@@ -289,13 +248,8 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         HTTP_HEADERS_RESULT res;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         size_t nHeaders;
-        size_t zero = 0;
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreAllArguments()
-            .CopyOutArgumentBuffer(4, &zero, sizeof(zero));
-
         ///act
         res = HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
 
@@ -310,6 +264,7 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
 
     /*Tests_SRS_HTTP_HEADERS_99_012:[ Calling this API shall record a header from name and value parameters.]*/
     /*Tests_SRS_HTTP_HEADERS_99_013:[ The function shall return HTTP_HEADERS_OK when execution is successful.]*/
+    /*Tests_SRS_HTTP_HEADERS_99_038: [The names and the values of the headers shall be stored in a single arena owned by the handle, that is allocated when the first header is added and grows as needed.]*/
     TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_happy_path_succeeds)
     {
         ///arrange
@@ -317,11 +272,9 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist*/
-
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, NAME1, VALUE1))
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*the headers and their index*/
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*the arena*/
             .IgnoreArgument(1);
 
         ///act
@@ -331,28 +284,40 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-        //checking content
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_99_038: [The names and the values of the headers shall be stored in a single arena owned by the handle, that is allocated when the first header is added and grows as needed.]*/
+    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_second_header_does_not_allocate)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
+
+        ///act
+        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME2, VALUE2);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
     }
 
-    /*Codes_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
-    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_fails_when_Map_AddOrUpdate_fails)
+    /*Tests_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
+    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_fails_when_growing_the_headers_fails)
     {
         ///arrange
         HTTP_HEADERS_RESULT res;
+        size_t nHeaders;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist*/
-
-
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, NAME1, VALUE1))
-            .IgnoreArgument(1)
-            .SetReturn(MAP_ERROR);
+        whenShallmalloc_fail = currentmalloc_call + 1;
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
 
         ///act
         res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
@@ -360,42 +325,63 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         ///assert
         ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_ALLOC_FAILED, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        //checking content
+        (void)HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
+        ASSERT_ARE_EQUAL(size_t, 0, nHeaders);
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
     }
 
-    /*Tests_SRS_HTTP_HEADERS_99_016:[ The function shall store the name:value pair in such a way that when later retrieved by a call to GetHeader it will return a string that shall strcmp equal to the name+": "+value.]*/
-    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_succeeds)
+    /*Tests_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
+    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_fails_when_growing_the_arena_fails)
     {
         ///arrange
         HTTP_HEADERS_RESULT res;
+        size_t nHeaders;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist*/
-
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, NAME1, VALUE1))
+        whenShallmalloc_fail = currentmalloc_call + 2;
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
         ///act
         res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
 
         ///assert
-        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_ALLOC_FAILED, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        //checking content
+        (void)HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
+        ASSERT_ARE_EQUAL(size_t, 0, nHeaders);
+        ASSERT_IS_NULL(HTTPHeaders_FindHeaderValue(httpHandle, NAME1));
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
     }
 
+    /*Tests_SRS_HTTP_HEADERS_99_016:[ The function shall store the name:value pair in such a way that when later retrieved by a call to GetHeader it will return a string that shall strcmp equal to the name+": "+value.]*/
+    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_succeeds)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        char* headerValue;
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        umock_c_reset_all_calls();
+
+        ///act
+        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, HTTPHeaders_GetHeader(httpHandle, 0, &headerValue));
+        ASSERT_ARE_EQUAL(char_ptr, HEADER1, headerValue);
 
+        ///cleanup
+        free(headerValue);
+        HTTPHeaders_Free(httpHandle);
+    }
 
     /*Tests_SRS_HTTP_HEADERS_99_014:[ The function shall return when the handle is not valid or when name parameter is NULL or when value parameter is NULL.]*/
     TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_with_NULL_handle_fails)
@@ -453,100 +439,100 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     {
         ///arrange
         HTTP_HEADERS_RESULT res;
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
-        umock_c_reset_all_calls();
+        size_t nHeaders;
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn(VALUE1);
+        ///act
+        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1 ", " VALUE1, HTTPHeaders_FindHeaderValue(httpHandle, NAME1));
+        (void)HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
+        ASSERT_ARE_EQUAL(size_t, 1, nHeaders);
 
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, NAME1, VALUE1 ", " VALUE1))
-            .IgnoreArgument(1);
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
 
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+    /*Tests_SRS_HTTP_HEADERS_99_017:[ If the name already exists in the collection of headers, the function shall concatenate the new value after the existing value, separated by a comma and a space as in: old-value+", "+new-value.]*/
+    /*Tests_SRS_HTTP_HEADERS_99_039: [Header names shall be compared case-insensitively.]*/
+    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_with_same_Name_in_another_case_appends_to_existing_value)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        char* headerValue;
+        size_t nHeaders;
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
 
         ///act
-        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
+        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, "NaMe1", VALUE2);
 
         ///assert
         ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        (void)HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
+        ASSERT_ARE_EQUAL(size_t, 1, nHeaders);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, HTTPHeaders_GetHeader(httpHandle, 0, &headerValue));
+        ASSERT_ARE_EQUAL(char_ptr, NAME1 ": " VALUE1 ", " VALUE2, headerValue);
 
         ///cleanup
+        free(headerValue);
         HTTPHeaders_Free(httpHandle);
     }
 
     /*Tests_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
-    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_with_same_Name_appends_fails_when_Map_AddOrUpdate_fails)
+    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_with_same_Name_fails_when_gballoc_fails)
     {
         ///arrange
         HTTP_HEADERS_RESULT res;
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn(VALUE1);
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
 
+        (void)memset(tempBuffer, 'a', 300);
+        tempBuffer[300] = '\0';
+        whenShallmalloc_fail = currentmalloc_call + 1;
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, NAME1, VALUE1 ", " VALUE1))
-            .IgnoreArgument(1)
-            .SetReturn(MAP_ERROR);
-
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
         ///act
-        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
+        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, tempBuffer);
 
         ///assert
-        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_ERROR, res);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_ALLOC_FAILED, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1, HTTPHeaders_FindHeaderValue(httpHandle, NAME1));
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
     }
 
-    /*Tests_SRS_HTTP_HEADERS_99_015:[ The function shall return HTTP_HEADERS_ALLOC_FAILED when an internal request to allocate memory fails.]*/
-    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_with_same_Name_fails_when_gballoc_fails)
+    /*Tests_SRS_HTTP_HEADERS_99_038: [The names and the values of the headers shall be stored in a single arena owned by the handle, that is allocated when the first header is added and grows as needed.]*/
+    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_with_a_value_from_the_same_headers_succeeds_when_the_arena_grows)
     {
         ///arrange
         HTTP_HEADERS_RESULT res;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
-        umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn(VALUE1);
+        (void)memset(tempBuffer, 'a', 200);
+        tempBuffer[200] = '\0';
+        /*the arena is sized for twice the first header, so it is full after the second one*/
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, tempBuffer));
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME2, tempBuffer));
+        umock_c_reset_all_calls();
 
-        whenShallmalloc_fail = currentmalloc_call + 1;
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
 
         ///act
-        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
+        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, "name3", HTTPHeaders_FindHeaderValue(httpHandle, NAME1));
 
         ///assert
-        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_ALLOC_FAILED, res);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(char_ptr, tempBuffer, HTTPHeaders_FindHeaderValue(httpHandle, NAME1));
+        ASSERT_ARE_EQUAL(char_ptr, tempBuffer, HTTPHeaders_FindHeaderValue(httpHandle, NAME2));
+        ASSERT_ARE_EQUAL(char_ptr, tempBuffer, HTTPHeaders_FindHeaderValue(httpHandle, "name3"));
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
@@ -557,26 +543,16 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     {
         ///arrange
         HTTP_HEADERS_RESULT res;
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME2))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, NAME2, VALUE2))
-            .IgnoreArgument(1);
+        size_t nHeaders;
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
 
         ///act
         res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME2, VALUE2);
 
         ///assert
         ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        (void)HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
+        ASSERT_ARE_EQUAL(size_t, 2, nHeaders);
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
@@ -587,26 +563,60 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     {
         ///arrange
         HTTP_HEADERS_RESULT result;
+        size_t nHeaders;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, "ab"))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, "ab", VALUE1);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, "a"))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, "a", VALUE1))
-            .IgnoreArgument(1);
-
         ///act
         result = HTTPHeaders_AddHeaderNameValuePair(httpHandle, "a", VALUE1);
 
         ///assert
         ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, result);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        (void)HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
+        ASSERT_ARE_EQUAL(size_t, 2, nHeaders);
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1, HTTPHeaders_FindHeaderValue(httpHandle, "ab"));
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1, HTTPHeaders_FindHeaderValue(httpHandle, "a"));
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_99_040: [The headers shall be indexed by a hash of their case-folded names.]*/
+    TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_many_headers_are_all_found_in_order)
+    {
+        ///arrange
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        char name[32];
+        char value[32];
+        size_t nHeaders;
+        size_t i;
+
+        ///act
+        for (i = 0; i < MAX_NAME_VALUE_PAIR; i++)
+        {
+            (void)sprintf(name, "header%lu", (unsigned long)i);
+            (void)sprintf(value, "value%lu", (unsigned long)i);
+            ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, HTTPHeaders_AddHeaderNameValuePair(httpHandle, name, value));
+        }
+
+        ///assert
+        (void)HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
+        ASSERT_ARE_EQUAL(size_t, MAX_NAME_VALUE_PAIR, nHeaders);
+        for (i = 0; i < MAX_NAME_VALUE_PAIR; i++)
+        {
+            char* headerValue;
+            char expected[64];
+
+            (void)sprintf(name, "HEADER%lu", (unsigned long)i);
+            (void)sprintf(value, "value%lu", (unsigned long)i);
+            ASSERT_ARE_EQUAL(char_ptr, value, HTTPHeaders_FindHeaderValue(httpHandle, name));
+
+            (void)sprintf(expected, "header%lu: value%lu", (unsigned long)i, (unsigned long)i);
+            ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, HTTPHeaders_GetHeader(httpHandle, i, &headerValue));
+            ASSERT_ARE_EQUAL(char_ptr, expected, headerValue);
+            free(headerValue);
+        }
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
@@ -630,8 +640,7 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     {
         ///arrange
         const char* res;
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        umock_c_reset_all_calls();
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
 
         ///act
         res = HTTPHeaders_FindHeaderValue(httpHandle, NULL);
@@ -649,22 +658,14 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     TEST_FUNCTION(HTTPHeaders_FindHeaderValue_retrieves_previously_stored_value_succeeds)
     {
         ///arrange
-        const char* res1;
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1);
+        const char* res;
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
 
         ///act
-        res1 = HTTPHeaders_FindHeaderValue(httpHandle, NAME1);
+        res = HTTPHeaders_FindHeaderValue(httpHandle, NAME1);
 
         ///assert
-        ASSERT_ARE_EQUAL(char_ptr, VALUE1, res1);
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
@@ -678,24 +679,10 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         ///arrange
         const char* res1;
         const char* res2;
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME2))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME2, VALUE2);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn(VALUE1);
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME2))
-            .IgnoreArgument(1)
-            .SetReturn(VALUE2);
-
         ///act
         res1 = HTTPHeaders_FindHeaderValue(httpHandle, NAME1);
         res2 = HTTPHeaders_FindHeaderValue(httpHandle, NAME2);
@@ -713,27 +700,35 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     /*Tests_SRS_HTTP_HEADERS_99_021:[ In this case the return value shall point to a string that shall strcmp equal to the original stored string.]*/
     TEST_FUNCTION(HTTPHeaders_FindHeaderValue_retrieves_concatenation_of_previously_stored_values_for_header_name_succeeds)
     {
+        ///arrange
         const char* res;
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn(VALUE1); /*this key exists, was added above*/
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE2);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn(VALUE1 ", " VALUE2);
-
         ///act
         res = HTTPHeaders_FindHeaderValue(httpHandle, NAME1);
 
         ///assert
-        ASSERT_ARE_EQUAL(char_ptr,VALUE1 ", " VALUE2, res);
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1 ", " VALUE2, res);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_99_039: [Header names shall be compared case-insensitively.]*/
+    TEST_FUNCTION(HTTPHeaders_FindHeaderValue_ignores_the_case_of_the_name)
+    {
+        ///arrange
+        const char* res;
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
+
+        ///act
+        res = HTTPHeaders_FindHeaderValue(httpHandle, "NAME1");
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
@@ -741,34 +736,23 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     }
 
     /*Tests_SRS_HTTP_HEADERS_99_020:[ The return value shall be different than NULL when the name matches the name of a previously stored name:value pair.]*/
-    /*actually we are trying to see that finding a nonexisting value produces NULL*/
     TEST_FUNCTION(HTTPHeaders_FindHeaderValue_returns_NULL_for_nonexistent_value)
     {
         ///arrange
-        const char* res2;
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME2))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL);
+        const char* res;
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
 
         ///act
-        res2 = HTTPHeaders_FindHeaderValue(httpHandle, NAME2);
+        res = HTTPHeaders_FindHeaderValue(httpHandle, NAME2);
 
         ///assert
-        ASSERT_IS_NULL(res2);
+        ASSERT_IS_NULL(res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
     }
 
-    /*trying to catch some errors here*/
     /*Tests_SRS_HTTP_HEADERS_99_020:[ The return value shall be different than NULL when the name matches the name of a previously stored name:value pair.]*/
     TEST_FUNCTION(HTTPHeaders_FindHeaderValue_with_nonexistent_header_succeeds)
     {
@@ -776,22 +760,7 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         const char* res1;
         const char* res2;
         const char* res3;
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1_TRICK1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL);
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1_TRICK2))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL);
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1_TRICK3))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL);
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
 
         ///act
         res1 = HTTPHeaders_FindHeaderValue(httpHandle, NAME1_TRICK1);
@@ -813,26 +782,36 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     {
         ///arrange
         HTTP_HEADERS_RESULT res;
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
-        umock_c_reset_all_calls();
+        size_t nHeaders;
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
+
+        ///act
+        res = HTTPHeaders_ReplaceHeaderNameValuePair(httpHandle, NAME1, VALUE2);
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn(VALUE1); /*this key does not exist, the line below is adding it*/
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
+        ASSERT_ARE_EQUAL(char_ptr, VALUE2, HTTPHeaders_FindHeaderValue(httpHandle, NAME1));
+        (void)HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
+        ASSERT_ARE_EQUAL(size_t, 1, nHeaders);
 
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, NAME1, VALUE2))
-            .IgnoreArgument(1);
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /* Tests_SRS_HTTP_HEADERS_06_001: [This API will perform exactly as HTTPHeaders_AddHeaderNameValuePair except that if the header name already exists the already existing value will be replaced as opposed to concatenated to.] */
+    TEST_FUNCTION(HTTPHeaders_ReplaceHeaderNameValuePair_with_a_shorter_value_does_not_allocate)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
 
         ///act
-        res = HTTPHeaders_ReplaceHeaderNameValuePair(httpHandle, NAME1, VALUE2);
+        res = HTTPHeaders_ReplaceHeaderNameValuePair(httpHandle, NAME1, "v");
 
         ///assert
         ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(char_ptr, "v", HTTPHeaders_FindHeaderValue(httpHandle, NAME1));
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
@@ -843,22 +822,15 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     {
         ///arrange
         HTTP_HEADERS_RESULT res;
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL);
-
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, NAME1, VALUE2))
-            .IgnoreArgument(1);
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
 
         ///act
-        res = HTTPHeaders_ReplaceHeaderNameValuePair(httpHandle, NAME1, VALUE2);
+        res = HTTPHeaders_ReplaceHeaderNameValuePair(httpHandle, NAME2, VALUE2);
 
         ///assert
         ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1, HTTPHeaders_FindHeaderValue(httpHandle, NAME1));
+        ASSERT_ARE_EQUAL(char_ptr, VALUE2, HTTPHeaders_FindHeaderValue(httpHandle, NAME2));
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
@@ -868,14 +840,13 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     TEST_FUNCTION(HTTPHeaders_GetHeaderCount_with_NULL_handle_fails)
     {
         ///arrange
-        HTTP_HEADERS_RESULT res1;
         size_t nHeaders;
 
         ///act
-        res1 = HTTPHeaders_GetHeaderCount(NULL, &nHeaders);
+        HTTP_HEADERS_RESULT res = HTTPHeaders_GetHeaderCount(NULL, &nHeaders);
 
         ///assert
-        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res1);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
     }
 
@@ -883,15 +854,15 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     TEST_FUNCTION(HTTPHeaders_GetHeaderCount_with_NULL_headersCount_fails)
     {
         ///arrange
-        HTTP_HEADERS_RESULT res1;
+        HTTP_HEADERS_RESULT res;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         umock_c_reset_all_calls();
 
         ///act
-        res1 = HTTPHeaders_GetHeaderCount(httpHandle, NULL);
+        res = HTTPHeaders_GetHeaderCount(httpHandle, NULL);
 
         ///assert
-        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res1);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
@@ -904,95 +875,33 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     TEST_FUNCTION(HTTPHeaders_GetHeaderCount_with_1_header_produces_1)
     {
         ///arrange
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        size_t nHeaders;
-        const char* keys[] = { "NAME1" };
-        const char* values[] = { "VALUE1" };
-        const char* const ** pKeys = (const char* const **)&keys;
-        const char* const ** pValues = (const char* const **)&values;
-        const size_t one = 1;
         HTTP_HEADERS_RESULT res;
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .CopyOutArgumentBuffer(2, &pKeys, sizeof(pKeys))
-            .CopyOutArgumentBuffer(3, &pValues, sizeof(pValues))
-            .CopyOutArgumentBuffer(4, &one, sizeof(one));
-
+        size_t nHeaders;
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
 
         ///act
         res = HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
 
         ///assert
         ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
-        ASSERT_ARE_EQUAL(size_t, (size_t)1, nHeaders);
+        ASSERT_ARE_EQUAL(size_t, 1, nHeaders);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
     }
 
-    /*Tests_SRS_HTTP_HEADERS_99_037:[ The function shall return HTTP_HEADERS_ERROR when an internal error occurs.]*/
-    TEST_FUNCTION(HTTPHeaders_GetHeaderCount_fails_when_Map_GetInternals_fails)
+    /*Tests_SRS_HTTP_HEADERS_99_026:[ The function shall write in *headersCount the number of currently stored headers and shall return HTTP_HEADERS_OK]*/
+    /*Tests_SRS_HTTP_HEADERS_99_023:[ Calling this API shall provide the number of stored headers.]*/
+    TEST_FUNCTION(HTTPHeaders_GetHeaderCount_with_2_header_produces_2)
     {
         ///arrange
         HTTP_HEADERS_RESULT res;
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         size_t nHeaders;
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME2, VALUE2);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreAllArguments()
-            .SetReturn(MAP_ERROR);
-
-        ///act
-        res = HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
-
-        ///assert
-        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_ERROR, res);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-
-        ///cleanup
-        HTTPHeaders_Free(httpHandle);
-    }
-
-    /*Tests_SRS_HTTP_HEADERS_99_026:[ The function shall write in *headersCount the number of currently stored headers and shall return HTTP_HEADERS_OK]*/
-    /*Tests_SRS_HTTP_HEADERS_99_023:[ Calling this API shall provide the number of stored headers.]*/
-    TEST_FUNCTION(HTTPHeaders_GetHeaderCount_with_2_header_produces_2)
-    {
-        ///arrange
-        HTTP_HEADERS_RESULT res;
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        size_t nHeaders;
-        const char* keys[2] = { "NAME1", "NAME2" };
-        const char* values[2] = { "VALUE1", "VALUE2" };
-        const char* const ** pKeys = (const char* const **)&keys;
-        const char* const ** pValues = (const char* const **)&values;
-
-        const size_t two = 2;
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME2))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME2, VALUE2);
-        umock_c_reset_all_calls();
-
-
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .CopyOutArgumentBuffer(2, &pKeys, sizeof(pKeys))
-            .CopyOutArgumentBuffer(3, &pValues, sizeof(pValues))
-            .CopyOutArgumentBuffer(4, &two, sizeof(two));
-
         ///act
         res = HTTPHeaders_GetHeaderCount(httpHandle, &nHeaders);
 
@@ -1024,12 +933,7 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     {
         ///arrange
         HTTP_HEADERS_RESULT res;
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
-        umock_c_reset_all_calls();
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
 
         ///act
         res = HTTPHeaders_GetHeader(httpHandle, 0, NULL);
@@ -1047,24 +951,16 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     TEST_FUNCTION(HTTPHeaders_GetHeader_with_index_too_big_fails_1)
     {
         ///arrange
-        HTTP_HEADERS_RESULT res1;
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        HTTP_HEADERS_RESULT res;
         char* headerValue;
-        const char* thisIsNULL = NULL;
-        const char* zero = 0;
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .CopyOutArgumentBuffer(2, &thisIsNULL, sizeof(thisIsNULL))
-            .CopyOutArgumentBuffer(3, &thisIsNULL, sizeof(thisIsNULL))
-            .CopyOutArgumentBuffer(4, &zero, sizeof(zero));
-
         ///act
-        res1 = HTTPHeaders_GetHeader(httpHandle, 0, &headerValue);
+        res = HTTPHeaders_GetHeader(httpHandle, 0, &headerValue);
 
         ///assert
-        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res1);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
@@ -1076,31 +972,15 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     TEST_FUNCTION(HTTPHeaders_GetHeader_with_index_too_big_fails_2)
     {
         ///arrange
-        HTTP_HEADERS_RESULT res1;
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        const char* keys[1] = { "NAME1" };
-        const char* values[1] = { "VALUE1" };
-        const char* const ** pKeys = (const char* const **)&keys;
-        const char* const ** pValues = (const char* const **)&values;
-        const size_t one = 1;
+        HTTP_HEADERS_RESULT res;
         char* headerValue;
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE1);
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .CopyOutArgumentBuffer(2, pKeys, sizeof(pKeys))
-            .CopyOutArgumentBuffer(3, pValues, sizeof(pValues))
-            .CopyOutArgumentBuffer(4, &one, sizeof(one));
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
 
         ///act
-        res1 = HTTPHeaders_GetHeader(httpHandle, 1, &headerValue);
+        res = HTTPHeaders_GetHeader(httpHandle, 1, &headerValue);
 
         ///assert
-        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res1);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
@@ -1113,74 +993,30 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     {
         ///arrange
         HTTP_HEADERS_RESULT res1;
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        char* headerValue;
-        const char* keys[1] = { "a" };
-        const char** pKeys = &keys[0];
-        const char* values[1] = { "b" };
-        const char** pValues = &values[0];
-        const size_t one = 1;
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, "a"))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, "a", "b");
+        HTTP_HEADERS_RESULT res2;
+        char* headerValue1;
+        char* headerValue2;
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME2, VALUE2);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .CopyOutArgumentBuffer(2, &pKeys, sizeof(pKeys))
-            .CopyOutArgumentBuffer(3, &pValues, sizeof(pValues))
-            .CopyOutArgumentBuffer(4, &one, sizeof(one));
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(HEADER1)));
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(HEADER2)));
 
         ///act
-        res1 = HTTPHeaders_GetHeader(httpHandle, 0, &headerValue);
+        res1 = HTTPHeaders_GetHeader(httpHandle, 0, &headerValue1);
+        res2 = HTTPHeaders_GetHeader(httpHandle, 1, &headerValue2);
 
         ///assert
         ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res1);
-        ASSERT_ARE_EQUAL(char_ptr, "a: b", headerValue);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        ///cleanup
-        HTTPHeaders_Free(httpHandle);
-        free(headerValue);
-    }
-
-    /*Tests_SRS_HTTP_HEADERS_99_034:[ The function shall return HTTP_HEADERS_ERROR when an internal error occurs]*/
-    TEST_FUNCTION(HTTPHeaders_GetHeader_fails_when_Map_GetInternals_fails)
-    {
-        ///arrange
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
-        char* headerValue;
-        const char* keys[1] = { "a" };
-        const char** pKeys = &keys[0];
-        const char* values[1] = { "b" };
-        const char** pValues = &values[0];
-        const size_t one = 1;
-        HTTP_HEADERS_RESULT res1;
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, "a"))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, "a", "b");
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .CopyOutArgumentBuffer(2, &pKeys, sizeof(pKeys))
-            .CopyOutArgumentBuffer(3, &pValues, sizeof(pValues))
-            .CopyOutArgumentBuffer(4, &one, sizeof(one))
-            .SetReturn(MAP_ERROR);
-
-        ///act
-        res1 = HTTPHeaders_GetHeader(httpHandle, 0, &headerValue);
-
-        ///assert
-        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_ERROR, res1);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res2);
+        ASSERT_ARE_EQUAL(char_ptr, HEADER1, headerValue1);
+        ASSERT_ARE_EQUAL(char_ptr, HEADER2, headerValue2);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
+        free(headerValue1);
+        free(headerValue2);
         HTTPHeaders_Free(httpHandle);
     }
 
@@ -1188,40 +1024,23 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     TEST_FUNCTION(HTTPHeaders_GetHeader_succeeds_fails_when_malloc_fails)
     {
         ///arrange
-        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        HTTP_HEADERS_RESULT res;
         char* headerValue;
-        const char* keys[1] = { "a" };
-        const char** pKeys = &keys[0];
-        const char* values[1] = { "b" };
-        const char** pValues = &values[0];
-        const size_t one = 1;
-        HTTP_HEADERS_RESULT res1;
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, "a"))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
-        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, "a", "b");
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .CopyOutArgumentBuffer(2, &pKeys, sizeof(pKeys))
-            .CopyOutArgumentBuffer(3, &pValues, sizeof(pValues))
-            .CopyOutArgumentBuffer(4, &one, sizeof(one));
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
 
         whenShallmalloc_fail = currentmalloc_call + 1;
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
         ///act
-        res1 = HTTPHeaders_GetHeader(httpHandle, 0, &headerValue);
+        res = HTTPHeaders_GetHeader(httpHandle, 0, &headerValue);
 
         ///assert
-        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_ERROR, res1);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_ERROR, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
-        free(headerValue);
     }
 
     /*Tests_SRS_HTTP_HEADERS_99_031:[ If name contains the character ":" then the return value shall be HTTP_HEADERS_INVALID_ARG.]*/
@@ -1247,26 +1066,12 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     TEST_FUNCTION(HTTPHeaders_AddHeaderNameValuePair_with_colon_in_value_succeeds_1)
     {
         ///arrange
-        const char* keys[1] = { "a" };
-        const char** pKeys = &keys[0];
-        const char* values[1] = { ":" };
-        const char** pValues = &values[0];
-        const size_t one = 1;
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         char* headerValue;
         HTTP_HEADERS_RESULT res1;
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, "a"))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist, the line below is adding it*/
         (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, "a", ":");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-            .IgnoreArgument(1)
-            .CopyOutArgumentBuffer(2, &pKeys, sizeof(pKeys))
-            .CopyOutArgumentBuffer(3, &pValues, sizeof(pValues))
-            .CopyOutArgumentBuffer(4, &one, sizeof(one));
-
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
@@ -1323,21 +1128,155 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(Map_GetValueFromKey(IGNORED_PTR_ARG, NAME1))
-            .IgnoreArgument(1)
-            .SetReturn((const char*)NULL); /*this key does not exist*/
+        ///act
+        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, " \r\t\n" VALUE1); /*notice how there are some LWS characters in the value*/
 
-        STRICT_EXPECTED_CALL(Map_AddOrUpdate(IGNORED_PTR_ARG, NAME1, VALUE1))
-            .IgnoreArgument(1);
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1, HTTPHeaders_FindHeaderValue(httpHandle, NAME1));
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_99_041: [If handle or serializedSize is NULL, HTTPHeaders_Serialize shall return HTTP_HEADERS_INVALID_ARG.]*/
+    TEST_FUNCTION(HTTPHeaders_Serialize_with_NULL_handle_fails)
+    {
+        ///arrange
+        size_t serializedSize;
 
         ///act
-        res = HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, " \r\t\n" VALUE1); /*notice how there are some LWS characters in the value*/
+        HTTP_HEADERS_RESULT res = HTTPHeaders_Serialize(NULL, tempBuffer, sizeof(tempBuffer), &serializedSize);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_99_041: [If handle or serializedSize is NULL, HTTPHeaders_Serialize shall return HTTP_HEADERS_INVALID_ARG.]*/
+    TEST_FUNCTION(HTTPHeaders_Serialize_with_NULL_serializedSize_fails)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
+
+        ///act
+        res = HTTPHeaders_Serialize(httpHandle, tempBuffer, sizeof(tempBuffer), NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_99_042: [If buffer is NULL and bufferSize is not 0, HTTPHeaders_Serialize shall return HTTP_HEADERS_INVALID_ARG.]*/
+    TEST_FUNCTION(HTTPHeaders_Serialize_with_NULL_buffer_and_non_zero_size_fails)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        size_t serializedSize;
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
+
+        ///act
+        res = HTTPHeaders_Serialize(httpHandle, NULL, 1, &serializedSize);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_99_043: [HTTPHeaders_Serialize shall write in *serializedSize the number of characters of name+": "+value+"\r\n" for all the headers, not counting the null terminator.]*/
+    /*Tests_SRS_HTTP_HEADERS_99_044: [If bufferSize is not greater than *serializedSize, HTTPHeaders_Serialize shall return HTTP_HEADERS_INSUFFICIENT_BUFFER without writing to buffer.]*/
+    TEST_FUNCTION(HTTPHeaders_Serialize_with_NULL_buffer_returns_the_size)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        size_t serializedSize;
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME2, VALUE2);
+        umock_c_reset_all_calls();
+
+        ///act
+        res = HTTPHeaders_Serialize(httpHandle, NULL, 0, &serializedSize);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INSUFFICIENT_BUFFER, res);
+        ASSERT_ARE_EQUAL(size_t, sizeof(HEADER1 "\r\n" HEADER2 "\r\n") - 1, serializedSize);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_99_044: [If bufferSize is not greater than *serializedSize, HTTPHeaders_Serialize shall return HTTP_HEADERS_INSUFFICIENT_BUFFER without writing to buffer.]*/
+    TEST_FUNCTION(HTTPHeaders_Serialize_without_room_for_the_terminator_fails)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        size_t serializedSize;
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
+        tempBuffer[0] = 'x';
+
+        ///act
+        res = HTTPHeaders_Serialize(httpHandle, tempBuffer, sizeof(HEADER1 "\r\n") - 1, &serializedSize);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INSUFFICIENT_BUFFER, res);
+        ASSERT_ARE_EQUAL(size_t, sizeof(HEADER1 "\r\n") - 1, serializedSize);
+        ASSERT_ARE_EQUAL(int, (int)'x', (int)tempBuffer[0]);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_99_045: [Otherwise HTTPHeaders_Serialize shall write name+": "+value+"\r\n" for every header, in the order in which they were added, followed by a null terminator, into buffer and return HTTP_HEADERS_OK.]*/
+    TEST_FUNCTION(HTTPHeaders_Serialize_writes_all_the_headers)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        size_t serializedSize;
+        HTTP_HEADERS_HANDLE httpHandle = create_headers_with_name1();
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME2, VALUE2);
+        (void)HTTPHeaders_AddHeaderNameValuePair(httpHandle, NAME1, VALUE2);
+        umock_c_reset_all_calls();
+
+        ///act
+        res = HTTPHeaders_Serialize(httpHandle, tempBuffer, sizeof(tempBuffer), &serializedSize);
 
         ///assert
         ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
+        ASSERT_ARE_EQUAL(char_ptr, HEADER1 ", " VALUE2 "\r\n" HEADER2 "\r\n", tempBuffer);
+        ASSERT_ARE_EQUAL(size_t, strlen(tempBuffer), serializedSize);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-        //checking content
+        ///cleanup
+        HTTPHeaders_Free(httpHandle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_99_045: [Otherwise HTTPHeaders_Serialize shall write name+": "+value+"\r\n" for every header, in the order in which they were added, followed by a null terminator, into buffer and return HTTP_HEADERS_OK.]*/
+    TEST_FUNCTION(HTTPHeaders_Serialize_without_headers_writes_an_empty_string)
+    {
+        ///arrange
+        HTTP_HEADERS_RESULT res;
+        size_t serializedSize;
+        HTTP_HEADERS_HANDLE httpHandle = HTTPHeaders_Alloc();
+        umock_c_reset_all_calls();
+        tempBuffer[0] = 'x';
+
+        ///act
+        res = HTTPHeaders_Serialize(httpHandle, tempBuffer, 1, &serializedSize);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
+        ASSERT_ARE_EQUAL(size_t, 0, serializedSize);
+        ASSERT_ARE_EQUAL(char_ptr, "", tempBuffer);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         HTTPHeaders_Free(httpHandle);
@@ -1361,12 +1300,13 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
     {
         ///arrange
         HTTP_HEADERS_HANDLE result;
-        HTTP_HEADERS_HANDLE source = HTTPHeaders_Alloc();
-        umock_c_reset_all_calls();
+        HTTP_HEADERS_HANDLE source = create_headers_with_name1();
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(Map_Clone(IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
 
         ///act
@@ -1375,14 +1315,17 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
         ///assert
         ASSERT_IS_NOT_NULL(result);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        HTTPHeaders_Free(source);
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1, HTTPHeaders_FindHeaderValue(result, NAME1));
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, HTTPHeaders_AddHeaderNameValuePair(result, NAME2, VALUE2));
+        ASSERT_ARE_EQUAL(char_ptr, VALUE2, HTTPHeaders_FindHeaderValue(result, NAME2));
 
         ///cleanup
-        HTTPHeaders_Free(source);
         HTTPHeaders_Free(result);
     }
 
-    /*Tests_SRS_HTTP_HEADERS_02_005: [If cloning fails for any reason, then HTTPHeaders_Clone shall return NULL.] */
-    TEST_FUNCTION(HTTPHEADERS_Clone_fails_when_map_clone_fails)
+    /*Tests_SRS_HTTP_HEADERS_02_004: [Otherwise HTTPHeaders_Clone shall clone the content of handle to a new handle.*/
+    TEST_FUNCTION(HTTPHEADERS_Clone_of_empty_headers_allocates_only_the_handle)
     {
         ///arrange
         HTTP_HEADERS_HANDLE result;
@@ -1391,17 +1334,12 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(Map_Clone(IGNORED_PTR_ARG))
-            .IgnoreArgument(1).SetReturn(NULL);
-
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
 
         ///act
         result = HTTPHeaders_Clone(source);
 
         ///assert
-        ASSERT_IS_NULL(result);
+        ASSERT_IS_NOT_NULL(result);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
@@ -1411,25 +1349,151 @@ BEGIN_TEST_SUITE(HTTPHeaders_UnitTests)
 
     /*Tests_SRS_HTTP_HEADERS_02_005: [If cloning fails for any reason, then HTTPHeaders_Clone shall return NULL.] */
     TEST_FUNCTION(HTTPHEADERS_Clone_fails_when_gballoc_fails)
+    {
+        size_t i;
+
+        for (i = 1; i <= 3; i++)
+        {
+            ///arrange
+            HTTP_HEADERS_HANDLE result;
+            HTTP_HEADERS_HANDLE source = create_headers_with_name1();
+
+            whenShallmalloc_fail = currentmalloc_call + i;
+
+            ///act
+            result = HTTPHeaders_Clone(source);
+
+            ///assert
+            ASSERT_IS_NULL(result);
+
+            ///cleanup
+            HTTPHeaders_Free(source);
+        }
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_99_046: [If httpHeadersHandle is NULL, or lines is NULL while length is not 0, HTTPHeaders_AppendHeaderLines shall return HTTP_HEADERS_INVALID_ARG.]*/
+    TEST_FUNCTION(HTTPHeaders_AppendHeaderLines_with_NULL_handle_fails)
     {
         ///arrange
-        HTTP_HEADERS_HANDLE result;
-        HTTP_HEADERS_HANDLE source = HTTPHeaders_Alloc();
+
+        ///act
+        HTTP_HEADERS_RESULT res = HTTPHeaders_AppendHeaderLines(NULL, NAME1 ":" VALUE1, sizeof(NAME1 ":" VALUE1) - 1);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_INVALID_ARG, res);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_99_047: [HTTPHeaders_AppendHeaderLines shall copy the lines into a buffer owned by the handle without parsing them, and return HTTP_HEADERS_OK.]*/
+    TEST_FUNCTION(HTTPHeaders_AppendHeaderLines_stores_the_lines_in_one_buffer)
+    {
+        ///arrange
+        const char lines[] = "HTTP/1.1 200 OK\r\n" NAME1 ": " VALUE1 "\r\n" NAME2 ":" VALUE2 "\r\n";
+        HTTP_HEADERS_HANDLE handle = HTTPHeaders_Alloc();
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument(1).SetReturn(NULL);
+        STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+            .IgnoreArgument(2);
 
         ///act
-        result = HTTPHeaders_Clone(source);
+        HTTP_HEADERS_RESULT res = HTTPHeaders_AppendHeaderLines(handle, lines, sizeof(lines) - 1);
 
         ///assert
-        ASSERT_IS_NULL(result);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
-        HTTPHeaders_Free(source);
-        HTTPHeaders_Free(result);
+        HTTPHeaders_Free(handle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_99_048: [If the lines cannot be stored, HTTPHeaders_AppendHeaderLines shall return HTTP_HEADERS_ALLOC_FAILED.]*/
+    TEST_FUNCTION(HTTPHeaders_AppendHeaderLines_fails_when_realloc_fails)
+    {
+        ///arrange
+        HTTP_HEADERS_HANDLE handle = HTTPHeaders_Alloc();
+        size_t count;
+        whenShallrealloc_fail = currentrealloc_call + 1;
+
+        ///act
+        HTTP_HEADERS_RESULT res = HTTPHeaders_AppendHeaderLines(handle, NAME1 ":" VALUE1, sizeof(NAME1 ":" VALUE1) - 1);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_ALLOC_FAILED, res);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, HTTPHeaders_GetHeaderCount(handle, &count));
+        ASSERT_ARE_EQUAL(size_t, 0, count);
+
+        ///cleanup
+        HTTPHeaders_Free(handle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_99_049: [The lines appended by HTTPHeaders_AppendHeaderLines shall be parsed and added as if by HTTPHeaders_AddHeaderNameValuePair, in order, the first time the headers are read or changed.]*/
+    /*Tests_SRS_HTTP_HEADERS_99_050: [Lines without a ':' or with an invalid header name shall be ignored.]*/
+    TEST_FUNCTION(HTTPHeaders_AppendHeaderLines_lines_are_parsed_when_read)
+    {
+        ///arrange
+        const char lines[] = "HTTP/1.1 200 OK\r\n" NAME1 ":  " VALUE1 "\r\n" "bad name: x\r\n" NAME2 ":" VALUE2 "\n";
+        HTTP_HEADERS_HANDLE handle = HTTPHeaders_Alloc();
+        size_t count;
+        char* header;
+        (void)HTTPHeaders_AppendHeaderLines(handle, lines, sizeof(lines) - 1);
+        (void)HTTPHeaders_AppendHeaderLines(handle, NAME1 ":" VALUE2, sizeof(NAME1 ":" VALUE2) - 1);
+        (void)HTTPHeaders_AppendHeaderLines(handle, "\r\n", 2);
+
+        ///act
+        HTTP_HEADERS_RESULT res = HTTPHeaders_GetHeaderCount(handle, &count);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
+        ASSERT_ARE_EQUAL(size_t, 2, count);
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1 ", " VALUE2, HTTPHeaders_FindHeaderValue(handle, NAME1));
+        ASSERT_ARE_EQUAL(char_ptr, VALUE2, HTTPHeaders_FindHeaderValue(handle, NAME2));
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, HTTPHeaders_GetHeader(handle, 0, &header));
+        ASSERT_ARE_EQUAL(char_ptr, NAME1 ": " VALUE1 ", " VALUE2, header);
+
+        ///cleanup
+        free(header);
+        HTTPHeaders_Free(handle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_99_049: [The lines appended by HTTPHeaders_AppendHeaderLines shall be parsed and added as if by HTTPHeaders_AddHeaderNameValuePair, in order, the first time the headers are read or changed.]*/
+    TEST_FUNCTION(HTTPHeaders_AppendHeaderLines_lines_come_before_the_headers_added_after)
+    {
+        ///arrange
+        HTTP_HEADERS_HANDLE handle = HTTPHeaders_Alloc();
+        char* header;
+        (void)HTTPHeaders_AppendHeaderLines(handle, NAME1 ":" VALUE1, sizeof(NAME1 ":" VALUE1) - 1);
+
+        ///act
+        HTTP_HEADERS_RESULT res = HTTPHeaders_AddHeaderNameValuePair(handle, NAME2, VALUE2);
+
+        ///assert
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, res);
+        ASSERT_ARE_EQUAL(HTTP_HEADERS_RESULT, HTTP_HEADERS_OK, HTTPHeaders_GetHeader(handle, 0, &header));
+        ASSERT_ARE_EQUAL(char_ptr, NAME1 ": " VALUE1, header);
+
+        ///cleanup
+        free(header);
+        HTTPHeaders_Free(handle);
+    }
+
+    /*Tests_SRS_HTTP_HEADERS_99_051: [If the appended lines cannot be parsed for lack of memory, the API that reads or changes the headers shall fail.]*/
+    TEST_FUNCTION(HTTPHeaders_AppendHeaderLines_FindHeaderValue_fails_when_parsing_fails)
+    {
+        ///arrange
+        HTTP_HEADERS_HANDLE handle = HTTPHeaders_Alloc();
+        (void)HTTPHeaders_AppendHeaderLines(handle, NAME1 ":" VALUE1, sizeof(NAME1 ":" VALUE1) - 1);
+        whenShallmalloc_fail = currentmalloc_call + 1;
+
+        ///act
+        const char* result = HTTPHeaders_FindHeaderValue(handle, NAME1);
+
+        ///assert
+        ASSERT_IS_NULL(result);
+        whenShallmalloc_fail = 0;
+        ASSERT_ARE_EQUAL(char_ptr, VALUE1, HTTPHeaders_FindHeaderValue(handle, NAME1));
+
+        ///cleanup
+        HTTPHeaders_Free(handle);
     }
 
 END_TEST_SUITE(HTTPHeaders_UnitTests)
@@ -0,0 +1,259 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <string.h>
+#endif
+
+
+#include "testrunnerswitcher.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/threadapi.h"
+
+TEST_DEFINE_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+
+#define TEST_PROFILE_COUNT 64
+
+static LOCK_PROFILE_INFO test_profiles[TEST_PROFILE_COUNT];
+
+/* finds the entry of a lock alive, or of the deinitialized locks of a site when handle is NULL */
+static const LOCK_PROFILE_INFO* find_profile(LOCK_HANDLE handle, const char* file, int line)
+{
+    const LOCK_PROFILE_INFO* result = NULL;
+    size_t total_profile_count;
+    size_t i;
+
+    ASSERT_ARE_EQUAL(int, 0, Lock_GetProfiles(test_profiles, TEST_PROFILE_COUNT, &total_profile_count));
+    for (i = 0; (i < total_profile_count) && (i < TEST_PROFILE_COUNT); i++)
+    {
+        if ((test_profiles[i].handle == handle) &&
+            ((handle != NULL) || ((test_profiles[i].file == file) && (test_profiles[i].line == line))))
+        {
+            result = &test_profiles[i];
+            break;
+        }
+    }
+
+    return result;
+}
+
+static int lock_and_unlock_thread(void* arg)
+{
+    LOCK_HANDLE handle = (LOCK_HANDLE)arg;
+    (void)Lock(handle);
+    (void)Unlock(handle);
+    return 0;
+}
+
+BEGIN_TEST_SUITE(lock_profiling_unittests)
+
+TEST_SUITE_INITIALIZE(a)
+{
+}
+
+TEST_SUITE_CLEANUP(b)
+{
+}
+
+/* Tests_SRS_LOCK_01_027: [With LOCK_PROFILING, Lock_Init shall tag the lock with the file and line of the call to Lock_Init and add it to the profiled locks.] */
+TEST_FUNCTION(Lock_Init_tags_the_lock_with_its_creation_site)
+{
+    //arrange
+    const LOCK_PROFILE_INFO* profile;
+    int line = __LINE__ + 1;
+    LOCK_HANDLE handle = Lock_Init();
+
+    //act
+    profile = find_profile(handle, NULL, 0);
+
+    //assert
+    ASSERT_IS_NOT_NULL(profile);
+    ASSERT_ARE_EQUAL(char_ptr, __FILE__, profile->file);
+    ASSERT_ARE_EQUAL(int, line, profile->line);
+    ASSERT_ARE_EQUAL(size_t, 1, profile->lock_count);
+    ASSERT_ARE_EQUAL(uint64_t, 0, profile->acquisition_count);
+
+    //cleanup
+    (void)Lock_Deinit(handle);
+}
+
+/* Tests_SRS_LOCK_01_028: [With LOCK_PROFILING, a lock created by a call to the Lock_Init function rather than through the Lock_Init macro shall be tagged with a NULL file and a line of 0.] */
+TEST_FUNCTION(Lock_Init_called_as_a_function_tags_the_lock_with_a_NULL_file)
+{
+    //arrange
+    const LOCK_PROFILE_INFO* profile;
+    LOCK_HANDLE handle = (Lock_Init)();
+
+    //act
+    profile = find_profile(handle, NULL, 0);
+
+    //assert
+    ASSERT_IS_NOT_NULL(profile);
+    ASSERT_IS_NULL(profile->file);
+    ASSERT_ARE_EQUAL(int, 0, profile->line);
+
+    //cleanup
+    (void)Lock_Deinit(handle);
+}
+
+/* Tests_SRS_LOCK_01_025: [With LOCK_PROFILING, Lock shall count each acquisition of the lock.] */
+TEST_FUNCTION(Lock_counts_uncontended_acquisitions)
+{
+    //arrange
+    const LOCK_PROFILE_INFO* profile;
+    LOCK_HANDLE handle = Lock_Init();
+
+    //act
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_OK, Lock(handle));
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_OK, Unlock(handle));
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_OK, Lock(handle));
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_OK, Unlock(handle));
+
+    //assert
+    profile = find_profile(handle, NULL, 0);
+    ASSERT_IS_NOT_NULL(profile);
+    ASSERT_ARE_EQUAL(uint64_t, 2, profile->acquisition_count);
+    ASSERT_ARE_EQUAL(uint64_t, 0, profile->contended_count);
+    ASSERT_ARE_EQUAL(uint64_t, 0, profile->total_wait_ns);
+
+    //cleanup
+    (void)Lock_Deinit(handle);
+}
+
+/* Tests_SRS_LOCK_01_026: [With LOCK_PROFILING, Lock shall first try to acquire the lock without waiting and, if the lock is held, count a contended acquisition and add the time spent waiting for it to the total and max wait of the lock.] */
+TEST_FUNCTION(Lock_counts_a_contended_acquisition_and_its_wait)
+{
+    //arrange
+    const LOCK_PROFILE_INFO* profile;
+    THREAD_HANDLE thread;
+    int thread_result;
+    LOCK_HANDLE handle = Lock_Init();
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_OK, Lock(handle));
+    ASSERT_ARE_EQUAL(int, (int)THREADAPI_OK, (int)ThreadAPI_Create(&thread, lock_and_unlock_thread, handle));
+
+    //act
+    ThreadAPI_Sleep(100);
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_OK, Unlock(handle));
+    ASSERT_ARE_EQUAL(int, (int)THREADAPI_OK, (int)ThreadAPI_Join(thread, &thread_result));
+
+    //assert
+    profile = find_profile(handle, NULL, 0);
+    ASSERT_IS_NOT_NULL(profile);
+    ASSERT_ARE_EQUAL(uint64_t, 2, profile->acquisition_count);
+    ASSERT_ARE_EQUAL(uint64_t, 1, profile->contended_count);
+    ASSERT_IS_TRUE(profile->max_wait_ns > 0);
+    ASSERT_ARE_EQUAL(uint64_t, profile->max_wait_ns, profile->total_wait_ns);
+
+    //cleanup
+    (void)Lock_Deinit(handle);
+}
+
+/* Tests_SRS_LOCK_01_029: [With LOCK_PROFILING, Lock_Deinit shall add the counters of the lock to the record of its creation site.] */
+TEST_FUNCTION(Lock_Deinit_adds_the_counters_to_the_record_of_the_site)
+{
+    //arrange
+    const LOCK_PROFILE_INFO* profile;
+    size_t lock_count_before = 0;
+    uint64_t acquisition_count_before = 0;
+    int line = 0;
+    int i;
+
+    for (i = 0; i < 2; i++)
+    {
+        LOCK_HANDLE handle;
+        line = __LINE__ + 1;
+        handle = Lock_Init();
+        (void)Lock(handle);
+        (void)Unlock(handle);
+
+        //act
+        (void)Lock_Deinit(handle);
+
+        if (i == 0)
+        {
+            //assert
+            profile = find_profile(NULL, __FILE__, line);
+            ASSERT_IS_NOT_NULL(profile);
+            lock_count_before = profile->lock_count;
+            acquisition_count_before = profile->acquisition_count;
+        }
+    }
+
+    //assert
+    profile = find_profile(NULL, __FILE__, line);
+    ASSERT_IS_NOT_NULL(profile);
+    ASSERT_ARE_EQUAL(size_t, lock_count_before + 1, profile->lock_count);
+    ASSERT_ARE_EQUAL(uint64_t, acquisition_count_before + 1, profile->acquisition_count);
+}
+
+/* Tests_SRS_LOCK_01_030: [If total_profile_count is NULL, or profiles is NULL and profile_count is not 0, Lock_GetProfiles shall fail and return a non-zero value.] */
+TEST_FUNCTION(Lock_GetProfiles_with_invalid_arguments_fails)
+{
+    //arrange
+    size_t total_profile_count;
+
+    //act
+    //assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, Lock_GetProfiles(test_profiles, TEST_PROFILE_COUNT, NULL));
+    ASSERT_ARE_NOT_EQUAL(int, 0, Lock_GetProfiles(NULL, 1, &total_profile_count));
+}
+
+/* Tests_SRS_LOCK_01_032: [Lock_GetProfiles shall fill profiles with up to profile_count entries, one per lock alive and one per creation site of deinitialized locks, ordered by decreasing total_wait_ns, set total_profile_count to the number of entries and return 0.] */
+TEST_FUNCTION(Lock_GetProfiles_orders_the_entries_by_decreasing_total_wait)
+{
+    //arrange
+    size_t total_profile_count;
+    size_t i;
+    LOCK_HANDLE handle = Lock_Init();
+
+    //act
+    int result = Lock_GetProfiles(test_profiles, TEST_PROFILE_COUNT, &total_profile_count);
+
+    //assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(total_profile_count >= 1);
+    for (i = 1; (i < total_profile_count) && (i < TEST_PROFILE_COUNT); i++)
+    {
+        ASSERT_IS_TRUE(test_profiles[i - 1].total_wait_ns >= test_profiles[i].total_wait_ns);
+    }
+
+    //cleanup
+    (void)Lock_Deinit(handle);
+}
+
+/* Tests_SRS_LOCK_01_032: [Lock_GetProfiles shall fill profiles with up to profile_count entries, one per lock alive and one per creation site of deinitialized locks, ordered by decreasing total_wait_ns, set total_profile_count to the number of entries and return 0.] */
+TEST_FUNCTION(Lock_GetProfiles_with_no_room_only_gives_the_count)
+{
+    //arrange
+    size_t total_profile_count = 0;
+    LOCK_HANDLE handle = Lock_Init();
+
+    //act
+    int result = Lock_GetProfiles(NULL, 0, &total_profile_count);
+
+    //assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(total_profile_count >= 1);
+
+    //cleanup
+    (void)Lock_Deinit(handle);
+}
+
+/* Tests_SRS_LOCK_01_033: [Lock_DumpProfiles shall log with LogInfo one line per entry, ordered by decreasing total_wait_ns, with its creation site, the lock or the number of deinitialized locks, the acquisitions, the contended acquisitions and the total and max wait.] */
+TEST_FUNCTION(Lock_DumpProfiles_succeeds)
+{
+    //arrange
+    LOCK_HANDLE handle = Lock_Init();
+
+    //act
+    Lock_DumpProfiles();
+
+    //assert
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_OK, Lock_Deinit(handle));
+}
+
+END_TEST_SUITE(lock_profiling_unittests)
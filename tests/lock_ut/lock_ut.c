@@ -121,6 +121,132 @@ TEST_FUNCTION(LOCK_DeInit_NULL_fails)
     ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_ERROR, result);
 }
 
+/* Tests_SRS_LOCK_01_001: [RWLock_Init on success shall return a valid reader/writer lock handle which should be a non NULL value] */
+/* Tests_SRS_LOCK_01_016: [RWLock_Deinit frees all resources associated with handle] */
+TEST_FUNCTION(RWLock_Init_Deinit_succeeds)
+{
+    //arrange
+    LOCK_RESULT result;
+
+    //act
+    RWLOCK_HANDLE handle = RWLock_Init();
+
+    //assert
+    ASSERT_IS_NOT_NULL(handle);
+    result = RWLock_Deinit(handle);
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_OK, result);
+}
+
+/* Tests_SRS_LOCK_01_004: [RWLock_LockShared shall acquire the lock in shared mode and return LOCK_OK] */
+/* Tests_SRS_LOCK_01_007: [RWLock_UnlockShared shall release the shared lock and return LOCK_OK] */
+TEST_FUNCTION(RWLock_LockShared_UnlockShared_succeed)
+{
+    //arrange
+    LOCK_RESULT lock_result;
+    LOCK_RESULT unlock_result;
+    RWLOCK_HANDLE handle = RWLock_Init();
+
+    //act
+    lock_result = RWLock_LockShared(handle);
+    unlock_result = RWLock_UnlockShared(handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_OK, lock_result);
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_OK, unlock_result);
+
+    //cleanup
+    (void)RWLock_Deinit(handle);
+}
+
+/* Tests_SRS_LOCK_01_010: [RWLock_LockExclusive shall acquire the lock in exclusive mode and return LOCK_OK] */
+/* Tests_SRS_LOCK_01_013: [RWLock_UnlockExclusive shall release the exclusive lock and return LOCK_OK] */
+TEST_FUNCTION(RWLock_LockExclusive_UnlockExclusive_succeed)
+{
+    //arrange
+    LOCK_RESULT lock_result;
+    LOCK_RESULT unlock_result;
+    RWLOCK_HANDLE handle = RWLock_Init();
+
+    //act
+    lock_result = RWLock_LockExclusive(handle);
+    unlock_result = RWLock_UnlockExclusive(handle);
+
+    //assert
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_OK, lock_result);
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_OK, unlock_result);
+
+    //cleanup
+    (void)RWLock_Deinit(handle);
+}
+
+/* Tests_SRS_LOCK_01_003: [RWLock_LockShared on NULL handle passed returns LOCK_ERROR] */
+/* Tests_SRS_LOCK_01_006: [RWLock_UnlockShared on NULL handle passed returns LOCK_ERROR] */
+/* Tests_SRS_LOCK_01_009: [RWLock_LockExclusive on NULL handle passed returns LOCK_ERROR] */
+/* Tests_SRS_LOCK_01_012: [RWLock_UnlockExclusive on NULL handle passed returns LOCK_ERROR] */
+/* Tests_SRS_LOCK_01_015: [RWLock_Deinit on NULL handle passed returns LOCK_ERROR] */
+TEST_FUNCTION(RWLock_functions_with_NULL_handle_fail)
+{
+    //arrange
+
+    //act
+    //assert
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_ERROR, RWLock_LockShared(NULL));
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_ERROR, RWLock_UnlockShared(NULL));
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_ERROR, RWLock_LockExclusive(NULL));
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_ERROR, RWLock_UnlockExclusive(NULL));
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_ERROR, RWLock_Deinit(NULL));
+}
+
+/* Tests_SRS_LOCK_01_017: [SpinLock_Init on success shall return a valid spin lock handle which should be a non NULL value] */
+/* Tests_SRS_LOCK_01_024: [SpinLock_Deinit frees all resources associated with handle] */
+TEST_FUNCTION(SpinLock_Init_Deinit_succeeds)
+{
+    //arrange
+    LOCK_RESULT result;
+
+    //act
+    SPINLOCK_HANDLE handle = SpinLock_Init();
+
+    //assert
+    ASSERT_IS_NOT_NULL(handle);
+    result = SpinLock_Deinit(handle);
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_OK, result);
+}
+
+/* Tests_SRS_LOCK_01_020: [SpinLock_Lock shall spin until the lock is free, yielding the thread once it has spun for a while, then acquire it and return LOCK_OK] */
+/* Tests_SRS_LOCK_01_022: [SpinLock_Unlock shall release the lock and return LOCK_OK] */
+TEST_FUNCTION(SpinLock_Lock_Unlock_can_be_repeated)
+{
+    //arrange
+    SPINLOCK_HANDLE handle = SpinLock_Init();
+    int i;
+
+    //act
+    //assert
+    for (i = 0; i < 2; i++)
+    {
+        ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_OK, SpinLock_Lock(handle));
+        ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_OK, SpinLock_Unlock(handle));
+    }
+
+    //cleanup
+    (void)SpinLock_Deinit(handle);
+}
+
+/* Tests_SRS_LOCK_01_019: [SpinLock_Lock on NULL handle passed returns LOCK_ERROR] */
+/* Tests_SRS_LOCK_01_021: [SpinLock_Unlock on NULL handle passed returns LOCK_ERROR] */
+/* Tests_SRS_LOCK_01_023: [SpinLock_Deinit on NULL handle passed returns LOCK_ERROR] */
+TEST_FUNCTION(SpinLock_functions_with_NULL_handle_fail)
+{
+    //arrange
+
+    //act
+    //assert
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_ERROR, SpinLock_Lock(NULL));
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_ERROR, SpinLock_Unlock(NULL));
+    ASSERT_ARE_EQUAL(LOCK_RESULT, LOCK_ERROR, SpinLock_Deinit(NULL));
+}
+
 /* Extra negative tests - only supported on Win32 since the behavior on other platforms is undefined. */
 #ifdef WIN32
 TEST_FUNCTION(LOCK_Init_Unlock_fails)
@@ -3,8 +3,12 @@
 
 #ifdef __cplusplus
 #include <cstdlib>
+#include <cstdio>
+#include <cstring>
 #else
 #include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
 #endif
 
 #include "azure_c_shared_utility/optimize_size.h"
@@ -68,6 +72,7 @@ void my_gballoc_free(void* ptr)
 #include "testrunnerswitcher.h"
 #include "umock_c.h"
 #include "umocktypes_charptr.h"
+#include "umocktypes_bool.h"
 
 static TEST_MUTEX_HANDLE g_testByTest;
 
@@ -86,10 +91,53 @@ void my_STRING_delete(STRING_HANDLE handle)
     free(handle);
 }
 
-STRING_HANDLE my_STRING_new_JSON(const char* source)
+/*the map tests only use keys and values that need no escaping*/
+int my_STRING_JSON_length(const char* source, size_t* length)
 {
-    (void)source;
-    return (STRING_HANDLE)malloc(1);
+    *length = strlen(source) + 2;
+    return 0;
+}
+
+int my_STRING_JSON_write(char* destination, size_t destinationSize, const char* source, size_t* written)
+{
+    size_t length = strlen(source);
+    (void)destinationSize;
+    destination[0] = '"';
+    (void)memcpy(destination + 1, source, length);
+    destination[length + 1] = '"';
+    *written = length + 2;
+    return 0;
+}
+
+/*the STRING is the memory it was given, my_STRING_delete frees it*/
+STRING_HANDLE my_STRING_new_with_memory(const char* memory)
+{
+    return (STRING_HANDLE)memory;
+}
+
+#include "azure_c_shared_utility/buffer_.h"
+
+static unsigned char test_buffer_content[256];
+static size_t test_buffer_length;
+static BUFFER_HANDLE TEST_BUFFER_HANDLE = (BUFFER_HANDLE)0x4242;
+
+int my_BUFFER_enlarge(BUFFER_HANDLE handle, size_t enlargeSize)
+{
+    (void)handle;
+    test_buffer_length += enlargeSize;
+    return 0;
+}
+
+unsigned char* my_BUFFER_u_char(BUFFER_HANDLE handle)
+{
+    (void)handle;
+    return test_buffer_content;
+}
+
+size_t my_BUFFER_length(BUFFER_HANDLE handle)
+{
+    (void)handle;
+    return test_buffer_length;
 }
 
 #include "azure_c_shared_utility/gballoc.h"
@@ -166,16 +214,24 @@ BEGIN_TEST_SUITE(map_unittests)
 
         result = umocktypes_charptr_register_types();
         ASSERT_ARE_EQUAL(int, 0, result);
+        result = umocktypes_bool_register_types();
+        ASSERT_ARE_EQUAL(int, 0, result);
 
         REGISTER_UMOCK_ALIAS_TYPE(MAP_HANDLE, void*);
         REGISTER_UMOCK_ALIAS_TYPE(STRING_HANDLE, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(BUFFER_HANDLE, void*);
 
         REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
         REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
         REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
         REGISTER_GLOBAL_MOCK_HOOK(STRING_construct, my_STRING_construct);
         REGISTER_GLOBAL_MOCK_HOOK(STRING_delete, my_STRING_delete);
-        REGISTER_GLOBAL_MOCK_HOOK(STRING_new_JSON, my_STRING_new_JSON);
+        REGISTER_GLOBAL_MOCK_HOOK(STRING_JSON_length, my_STRING_JSON_length);
+        REGISTER_GLOBAL_MOCK_HOOK(STRING_JSON_write, my_STRING_JSON_write);
+        REGISTER_GLOBAL_MOCK_HOOK(STRING_new_with_memory, my_STRING_new_with_memory);
+        REGISTER_GLOBAL_MOCK_HOOK(BUFFER_enlarge, my_BUFFER_enlarge);
+        REGISTER_GLOBAL_MOCK_HOOK(BUFFER_u_char, my_BUFFER_u_char);
+        REGISTER_GLOBAL_MOCK_HOOK(BUFFER_length, my_BUFFER_length);
     }
 
     TEST_SUITE_CLEANUP(TestClassCleanup)
@@ -199,6 +255,9 @@ BEGIN_TEST_SUITE(map_unittests)
 
         currentrealloc_call = 0;
         whenShallrealloc_fail = 0;
+
+        (void)memset(test_buffer_content, 0, sizeof(test_buffer_content));
+        test_buffer_length = 0;
     }
 
     TEST_FUNCTION_CLEANUP(TestMethodCleanup)
@@ -345,6 +404,136 @@ BEGIN_TEST_SUITE(map_unittests)
         Map_Destroy(handle);
     }
 
+    /*Tests_SRS_MAP_01_014: [Map_CreateFromArrays shall copy all the keys and values into one allocation and shall build the hash index, when the map needs one, once.] */
+    /*Tests_SRS_MAP_01_017: [Otherwise, Map_CreateFromArrays shall return a non-NULL handle to a map holding the pairs in the order of the arrays.] */
+    TEST_FUNCTION(Map_CreateFromArrays_succeeds)
+    {
+        ///arrange
+        const char* sourceKeys[] = { TEST_REDKEY, TEST_YELLOWKEY, TEST_BLUEKEY };
+        const char* sourceValues[] = { TEST_REDVALUE, TEST_YELLOWVALUE, TEST_BLUEVALUE };
+        const char*const* keys;
+        const char*const* values;
+        size_t count;
+        MAP_HANDLE handle;
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating the HANDLE structure*/
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_malloc(3 * 2 * sizeof(char*) +
+            strlen(TEST_REDKEY) + 1 + strlen(TEST_REDVALUE) + 1 +
+            strlen(TEST_YELLOWKEY) + 1 + strlen(TEST_YELLOWVALUE) + 1 +
+            strlen(TEST_BLUEKEY) + 1 + strlen(TEST_BLUEVALUE) + 1)); /*this is the arena*/
+
+        ///act
+        handle = Map_CreateFromArrays(sourceKeys, sourceValues, 3);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        (void)Map_GetInternals(handle, &keys, &values, &count);
+        ASSERT_ARE_EQUAL(size_t, 3, count);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_REDKEY, keys[0]);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_REDVALUE, values[0]);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_YELLOWKEY, keys[1]);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_YELLOWVALUE, values[1]);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_BLUEKEY, keys[2]);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_BLUEVALUE, values[2]);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_YELLOWVALUE, Map_GetValueFromKey(handle, TEST_YELLOWKEY));
+
+        ///cleanup
+        Map_Destroy(handle);
+    }
+
+    /*Tests_SRS_MAP_01_011: [If count is not 0 and keys or values is NULL, then Map_CreateFromArrays shall return NULL.] */
+    TEST_FUNCTION(Map_CreateFromArrays_with_NULL_keys_fails)
+    {
+        ///arrange
+        const char* sourceValues[] = { TEST_REDVALUE };
+        MAP_HANDLE handle;
+
+        ///act
+        handle = Map_CreateFromArrays(NULL, sourceValues, 1);
+
+        ///assert
+        ASSERT_IS_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_MAP_01_013: [If any of the keys or values is NULL, then Map_CreateFromArrays shall return NULL.] */
+    TEST_FUNCTION(Map_CreateFromArrays_with_a_NULL_value_fails)
+    {
+        ///arrange
+        const char* sourceKeys[] = { TEST_REDKEY, TEST_YELLOWKEY };
+        const char* sourceValues[] = { TEST_REDVALUE, NULL };
+        MAP_HANDLE handle;
+
+        ///act
+        handle = Map_CreateFromArrays(sourceKeys, sourceValues, 2);
+
+        ///assert
+        ASSERT_IS_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_MAP_01_016: [If a key appears more than once, then Map_CreateFromArrays shall return NULL.] */
+    TEST_FUNCTION(Map_CreateFromArrays_with_a_duplicate_key_fails)
+    {
+        ///arrange
+        const char* sourceKeys[] = { TEST_REDKEY, TEST_YELLOWKEY, TEST_REDKEY };
+        const char* sourceValues[] = { TEST_REDVALUE, TEST_YELLOWVALUE, TEST_BLUEVALUE };
+        MAP_HANDLE handle;
+
+        ///act
+        handle = Map_CreateFromArrays(sourceKeys, sourceValues, 3);
+
+        ///assert
+        ASSERT_IS_NULL(handle);
+    }
+
+    /*Tests_SRS_MAP_01_015: [If any allocation fails, then Map_CreateFromArrays shall return NULL.] */
+    TEST_FUNCTION(Map_CreateFromArrays_fails_when_the_arena_malloc_fails)
+    {
+        ///arrange
+        const char* sourceKeys[] = { TEST_REDKEY };
+        const char* sourceValues[] = { TEST_REDVALUE };
+        MAP_HANDLE handle;
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating the HANDLE structure*/
+            .IgnoreArgument(1);
+        whenShallmalloc_fail = currentmalloc_call + 2;
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is the arena*/
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        handle = Map_CreateFromArrays(sourceKeys, sourceValues, 1);
+
+        ///assert
+        ASSERT_IS_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_MAP_01_009: [Before Map_Add, Map_AddOrUpdate or Map_Delete change the pairs of a map that shares them with other maps, they shall copy the pairs; if the copy fails they shall return MAP_ERROR.] */
+    TEST_FUNCTION(Map_AddOrUpdate_on_a_map_created_from_arrays_copies_the_pairs_out_of_the_arena)
+    {
+        ///arrange
+        const char* sourceKeys[] = { TEST_REDKEY, TEST_YELLOWKEY };
+        const char* sourceValues[] = { TEST_REDVALUE, TEST_YELLOWVALUE };
+        MAP_HANDLE handle = Map_CreateFromArrays(sourceKeys, sourceValues, 2);
+        MAP_RESULT result;
+
+        ///act
+        result = Map_AddOrUpdate(handle, TEST_REDKEY, TEST_GREENVALUE);
+
+        ///assert
+        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_GREENVALUE, Map_GetValueFromKey(handle, TEST_REDKEY));
+        ASSERT_ARE_EQUAL(char_ptr, TEST_YELLOWVALUE, Map_GetValueFromKey(handle, TEST_YELLOWKEY));
+
+        ///cleanup
+        Map_Destroy(handle);
+    }
+
     /*Tests_SRS_MAP_02_005: [If parameter handle is NULL then Map_Destroy shall take no action.]*/
     TEST_FUNCTION(Map_Destroy_with_NULL_argument_does_nothing)
     {
@@ -2147,6 +2336,7 @@ BEGIN_TEST_SUITE(map_unittests)
     }
 
     /*Tests_SRS_MAP_02_039: [Map_Clone shall make a copy of the map indicated by parameter handle and return a non-NULL handle to it.]*/
+    /*Tests_SRS_MAP_01_008: [Map_Clone shall not copy the pairs: the clone shall share them with the map until either of them changes them, which shall then copy them first.] */
     TEST_FUNCTION(Map_Clone_with_map_with_1_element_succeeds)
     {
         ///arrange
@@ -2154,20 +2344,17 @@ BEGIN_TEST_SUITE(map_unittests)
         const char*const* keys;
         const char*const* values;
         size_t count;
+        const char*const* sourceKeys;
+        const char*const* sourceValues;
+        size_t sourceCount;
         MAP_HANDLE handle = Map_Create(NULL);
         (void)Map_AddOrUpdate(handle, TEST_REDKEY, TEST_REDVALUE);
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating the HANDLE structure*/
             .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(char*))); /*this is creating a clone of the storage for keys*/
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDKEY) + 1)); /*this is creating a clone of RED key*/
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(char*))); /*this is creating a clone of the storage for values*/
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDVALUE) + 1)); /*this is creating a clone of RED value*/
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating the count of the maps sharing the pairs*/
+            .IgnoreArgument(1);
 
         ///act
         result = Map_Clone(handle);
@@ -2175,8 +2362,9 @@ BEGIN_TEST_SUITE(map_unittests)
         ///assert
         ASSERT_IS_NOT_NULL(result);
         (void)Map_GetInternals(result, &keys, &values, &count);
-        ASSERT_IS_NOT_NULL(keys);
-        ASSERT_IS_NOT_NULL(values);
+        (void)Map_GetInternals(handle, &sourceKeys, &sourceValues, &sourceCount);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)sourceKeys, (void*)keys);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)sourceValues, (void*)values);
         ASSERT_ARE_EQUAL(size_t, 1, count);
         ASSERT_ARE_EQUAL(char_ptr, TEST_REDKEY, keys[0]);
         ASSERT_ARE_EQUAL(char_ptr, TEST_REDVALUE, values[0]);
@@ -2188,7 +2376,7 @@ BEGIN_TEST_SUITE(map_unittests)
     }
 
     /*Tests_SRS_MAP_02_047: [If during cloning, any operation fails, then Map_Clone shall return NULL.] */
-    TEST_FUNCTION(Map_Clone_with_map_with_1_element_fails_when_gbaloc_fails_1)
+    TEST_FUNCTION(Map_Clone_with_map_with_1_element_fails_when_gballoc_fails_1)
     {
         ///arrange
         MAP_HANDLE result;
@@ -2198,21 +2386,8 @@ BEGIN_TEST_SUITE(map_unittests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating the HANDLE structure*/
             .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(char*))); /*this is creating a clone of the storage for keys*/
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDKEY) + 1)); /*this is creating a clone of RED key*/
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(char*))); /*this is creating a clone of the storage for values*/
-
-        whenShallmalloc_fail = currentmalloc_call + 5;
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDVALUE) + 1)); /*this is creating a clone of RED value*/
-
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        whenShallmalloc_fail = currentmalloc_call + 2;
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating the count of the maps sharing the pairs*/
             .IgnoreArgument(1);
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
@@ -2222,15 +2397,15 @@ BEGIN_TEST_SUITE(map_unittests)
 
         ///assert
         ASSERT_IS_NULL(result);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_REDVALUE, Map_GetValueFromKey(handle, TEST_REDKEY));
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         Map_Destroy(handle);
-        Map_Destroy(result);
     }
 
     /*Tests_SRS_MAP_02_047: [If during cloning, any operation fails, then Map_Clone shall return NULL.] */
-    TEST_FUNCTION(Map_Clone_with_map_with_1_element_fails_when_gbaloc_fails_2)
+    TEST_FUNCTION(Map_Clone_with_map_with_1_element_fails_when_gballoc_fails_2)
     {
         ///arrange
         MAP_HANDLE result;
@@ -2238,23 +2413,10 @@ BEGIN_TEST_SUITE(map_unittests)
         (void)Map_AddOrUpdate(handle, TEST_REDKEY, TEST_REDVALUE);
         umock_c_reset_all_calls();
 
+        whenShallmalloc_fail = currentmalloc_call + 1;
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating the HANDLE structure*/
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(char*))); /*this is creating a clone of the storage for keys*/
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDKEY) + 1)); /*this is creating a clone of RED key*/
-
-        whenShallmalloc_fail = currentmalloc_call + 4;
-        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(char*))); /*this is creating a clone of the storage for values*/
-
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
         ///act
         result = Map_Clone(handle);
 
@@ -2264,411 +2426,272 @@ BEGIN_TEST_SUITE(map_unittests)
 
         ///cleanup
         Map_Destroy(handle);
-        Map_Destroy(result);
     }
 
-    /*Tests_SRS_MAP_02_047: [If during cloning, any operation fails, then Map_Clone shall return NULL.] */
-    TEST_FUNCTION(Map_Clone_with_map_with_1_element_fails_when_gbaloc_fails_3)
+    /*Tests_SRS_MAP_01_008: [Map_Clone shall not copy the pairs: the clone shall share them with the map until either of them changes them, which shall then copy them first.] */
+    TEST_FUNCTION(Map_Clone_with_map_with_2_element_that_is_already_shared_only_allocates_the_handle)
     {
         ///arrange
-        MAP_HANDLE result;
+        MAP_HANDLE clone1;
+        MAP_HANDLE clone2;
+        const char*const* keys;
+        const char*const* values;
+        size_t count;
         MAP_HANDLE handle = Map_Create(NULL);
         (void)Map_AddOrUpdate(handle, TEST_REDKEY, TEST_REDVALUE);
+        (void)Map_AddOrUpdate(handle, TEST_BLUEKEY, TEST_BLUEVALUE);
+        clone1 = Map_Clone(handle);
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating the HANDLE structure*/
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(char*))); /*this is creating a clone of the storage for keys*/
-
-        whenShallmalloc_fail = currentmalloc_call + 3;
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDKEY) + 1)); /*this is creating a clone of RED key*/
-
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
         ///act
-        result = Map_Clone(handle);
+        clone2 = Map_Clone(clone1);
 
         ///assert
-        ASSERT_IS_NULL(result);
+        ASSERT_IS_NOT_NULL(clone2);
+        (void)Map_GetInternals(clone2, &keys, &values, &count);
+        ASSERT_ARE_EQUAL(size_t, 2, count);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_REDKEY, keys[0]);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_REDVALUE, values[0]);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_BLUEKEY, keys[1]);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_BLUEVALUE, values[1]);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         Map_Destroy(handle);
-        Map_Destroy(result);
+        Map_Destroy(clone1);
+        Map_Destroy(clone2);
     }
 
-    /*Tests_SRS_MAP_02_047: [If during cloning, any operation fails, then Map_Clone shall return NULL.] */
-    TEST_FUNCTION(Map_Clone_with_map_with_1_element_fails_when_gbaloc_fails_4)
+    /*Tests_SRS_MAP_01_010: [Map_Destroy shall free the pairs only when no other map shares them.] */
+    TEST_FUNCTION(Map_Destroy_on_a_clone_frees_the_pairs_with_the_last_map)
     {
         ///arrange
-        MAP_HANDLE result;
+        MAP_HANDLE clone;
         MAP_HANDLE handle = Map_Create(NULL);
         (void)Map_AddOrUpdate(handle, TEST_REDKEY, TEST_REDVALUE);
+        clone = Map_Clone(handle);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating the HANDLE structure*/
+        STRICT_EXPECTED_CALL(gballoc_free(handle));
+
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)) /*RED key*/
             .IgnoreArgument(1);
-        whenShallmalloc_fail = currentmalloc_call + 2;
-        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(char*))); /*this is creating a clone of the storage for keys*/
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)) /*RED value*/
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)) /*keys*/
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)) /*values*/
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)) /*the count of the maps sharing the pairs*/
             .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_free(clone));
 
         ///act
-        result = Map_Clone(handle);
+        Map_Destroy(handle);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_REDVALUE, Map_GetValueFromKey(clone, TEST_REDKEY));
+        Map_Destroy(clone);
 
         ///assert
-        ASSERT_IS_NULL(result);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        ///cleanup
-        Map_Destroy(handle);
-        Map_Destroy(result);
     }
 
-    /*Tests_SRS_MAP_02_047: [If during cloning, any operation fails, then Map_Clone shall return NULL.] */
-    TEST_FUNCTION(Map_Clone_with_map_with_1_element_fails_when_gbaloc_fails_5)
+    /*Tests_SRS_MAP_01_009: [Before Map_Add, Map_AddOrUpdate or Map_Delete change the pairs of a map that shares them with other maps, they shall copy the pairs; if the copy fails they shall return MAP_ERROR.] */
+    TEST_FUNCTION(Map_AddOrUpdate_on_a_clone_copies_the_pairs_first)
     {
         ///arrange
-        MAP_HANDLE result;
+        MAP_RESULT result;
+        MAP_HANDLE clone;
         MAP_HANDLE handle = Map_Create(NULL);
         (void)Map_AddOrUpdate(handle, TEST_REDKEY, TEST_REDVALUE);
+        clone = Map_Clone(handle);
         umock_c_reset_all_calls();
 
-        whenShallmalloc_fail = currentmalloc_call + 1;
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating the HANDLE structure*/
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(char*))); /*this is creating a copy of the storage for keys*/
+        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDKEY) + 1)); /*this is creating a copy of RED key*/
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(char*))); /*this is creating a copy of the storage for values*/
+        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDVALUE) + 1)); /*this is creating a copy of RED value*/
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, strlen(TEST_BLUEVALUE) + 1))
             .IgnoreArgument(1);
 
         ///act
-        result = Map_Clone(handle);
+        result = Map_AddOrUpdate(clone, TEST_REDKEY, TEST_BLUEVALUE);
 
         ///assert
-        ASSERT_IS_NULL(result);
+        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_BLUEVALUE, Map_GetValueFromKey(clone, TEST_REDKEY));
+        ASSERT_ARE_EQUAL(char_ptr, TEST_REDVALUE, Map_GetValueFromKey(handle, TEST_REDKEY));
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         Map_Destroy(handle);
-        Map_Destroy(result);
+        Map_Destroy(clone);
     }
 
-    /*Tests_SRS_MAP_02_039: [Map_Clone shall make a copy of the map indicated by parameter handle and return a non-NULL handle to it.]*/
-    TEST_FUNCTION(Map_Clone_with_map_with_2_element_succeeds)
+    /*Tests_SRS_MAP_01_009: [Before Map_Add, Map_AddOrUpdate or Map_Delete change the pairs of a map that shares them with other maps, they shall copy the pairs; if the copy fails they shall return MAP_ERROR.] */
+    TEST_FUNCTION(Map_AddOrUpdate_on_a_clone_fails_when_copying_the_keys_fails)
     {
         ///arrange
-        MAP_HANDLE result;
-        const char*const* keys;
-        const char*const* values;
-        size_t count;
+        MAP_RESULT result;
+        MAP_HANDLE clone;
         MAP_HANDLE handle = Map_Create(NULL);
         (void)Map_AddOrUpdate(handle, TEST_REDKEY, TEST_REDVALUE);
-        (void)Map_AddOrUpdate(handle, TEST_BLUEKEY, TEST_BLUEVALUE);
+        clone = Map_Clone(handle);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating the HANDLE structure*/
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(char*))); /*this is creating a copy of the storage for keys*/
+        whenShallmalloc_fail = currentmalloc_call + 2;
+        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDKEY) + 1)); /*this is creating a copy of RED key*/
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(2*sizeof(char*))); /*this is creating a clone of the storage for keys*/
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDKEY) + 1)); /*this is creating a clone of RED key*/
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_BLUEKEY) + 1)); /*this is creating a clone of BLUE key*/
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(2*sizeof(char*))); /*this is creating a clone of the storage for values*/
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDVALUE) + 1)); /*this is creating a clone of RED value*/
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_BLUEVALUE) + 1)); /*this is creating a clone of RED value*/
-
         ///act
-        result = Map_Clone(handle);
+        result = Map_AddOrUpdate(clone, TEST_REDKEY, TEST_BLUEVALUE);
 
         ///assert
-        ASSERT_IS_NOT_NULL(result);
-        (void)Map_GetInternals(result, &keys, &values, &count);
-        ASSERT_IS_NOT_NULL(keys);
-        ASSERT_IS_NOT_NULL(values);
-        ASSERT_ARE_EQUAL(size_t, 2, count);
-        ASSERT_ARE_EQUAL(char_ptr, TEST_REDKEY, keys[0]);
-        ASSERT_ARE_EQUAL(char_ptr, TEST_REDVALUE, values[0]);
-        ASSERT_ARE_EQUAL(char_ptr, TEST_BLUEKEY, keys[1]);
-        ASSERT_ARE_EQUAL(char_ptr, TEST_BLUEVALUE, values[1]);
+        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_ERROR, result);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_REDVALUE, Map_GetValueFromKey(clone, TEST_REDKEY));
+        ASSERT_ARE_EQUAL(char_ptr, TEST_REDVALUE, Map_GetValueFromKey(handle, TEST_REDKEY));
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         Map_Destroy(handle);
-        Map_Destroy(result);
+        Map_Destroy(clone);
     }
 
-    /*Tests_SRS_MAP_02_047: [If during cloning, any operation fails, then Map_Clone shall return NULL.] */
-    TEST_FUNCTION(Map_Clone_with_map_with_2_element_fails_when_gballoc_fails_1)
+    /*Tests_SRS_MAP_01_009: [Before Map_Add, Map_AddOrUpdate or Map_Delete change the pairs of a map that shares them with other maps, they shall copy the pairs; if the copy fails they shall return MAP_ERROR.] */
+    TEST_FUNCTION(Map_AddOrUpdate_on_a_clone_fails_when_copying_the_values_fails)
     {
         ///arrange
-        MAP_HANDLE result;
+        MAP_RESULT result;
+        MAP_HANDLE clone;
         MAP_HANDLE handle = Map_Create(NULL);
         (void)Map_AddOrUpdate(handle, TEST_REDKEY, TEST_REDVALUE);
-        (void)Map_AddOrUpdate(handle, TEST_BLUEKEY, TEST_BLUEVALUE);
+        clone = Map_Clone(handle);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating the HANDLE structure*/
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(char*))); /*this is creating a copy of the storage for keys*/
+        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDKEY) + 1)); /*this is creating a copy of RED key*/
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(char*))); /*this is creating a copy of the storage for values*/
+        whenShallmalloc_fail = currentmalloc_call + 4;
+        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDVALUE) + 1)); /*this is creating a copy of RED value*/
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)) /*values*/
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)) /*RED key*/
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)) /*keys*/
             .IgnoreArgument(1);
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(2 * sizeof(char*))); /*this is creating a clone of the storage for keys*/
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDKEY) + 1)); /*this is creating a clone of RED key*/
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_BLUEKEY) + 1)); /*this is creating a clone of BLUE key*/
+        ///act
+        result = Map_AddOrUpdate(clone, TEST_REDKEY, TEST_BLUEVALUE);
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(2 * sizeof(char*))); /*this is creating a clone of the storage for values*/
+        ///assert
+        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_ERROR, result);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_REDVALUE, Map_GetValueFromKey(clone, TEST_REDKEY));
+        ASSERT_ARE_EQUAL(char_ptr, TEST_REDVALUE, Map_GetValueFromKey(handle, TEST_REDKEY));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDVALUE) + 1)); /*this is creating a clone of RED value*/
+        ///cleanup
+        Map_Destroy(handle);
+        Map_Destroy(clone);
+    }
 
-        whenShallmalloc_fail = currentmalloc_call + 7;
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_BLUEVALUE) + 1)); /*this is creating a clone of BLUE value*/
+    /*Tests_SRS_MAP_01_009: [Before Map_Add, Map_AddOrUpdate or Map_Delete change the pairs of a map that shares them with other maps, they shall copy the pairs; if the copy fails they shall return MAP_ERROR.] */
+    TEST_FUNCTION(Map_Add_on_a_map_that_has_a_clone_copies_the_pairs_first)
+    {
+        ///arrange
+        MAP_RESULT result;
+        MAP_HANDLE clone;
+        const char*const* keys;
+        const char*const* values;
+        size_t count;
+        MAP_HANDLE handle = Map_Create(NULL);
+        (void)Map_AddOrUpdate(handle, TEST_REDKEY, TEST_REDVALUE);
+        clone = Map_Clone(handle);
+        umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(char*))); /*this is creating a copy of the storage for keys*/
+        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDKEY) + 1)); /*this is creating a copy of RED key*/
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(char*))); /*this is creating a copy of the storage for values*/
+        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDVALUE) + 1)); /*this is creating a copy of RED value*/
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 2 * sizeof(char*)))
             .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 2 * sizeof(char*)))
             .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_BLUEKEY) + 1));
+        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_BLUEVALUE) + 1));
 
         ///act
-        result = Map_Clone(handle);
+        result = Map_Add(handle, TEST_BLUEKEY, TEST_BLUEVALUE);
 
         ///assert
-        ASSERT_IS_NULL(result);
+        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_OK, result);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(char_ptr, TEST_BLUEVALUE, Map_GetValueFromKey(handle, TEST_BLUEKEY));
+        (void)Map_GetInternals(clone, &keys, &values, &count);
+        ASSERT_ARE_EQUAL(size_t, 1, count);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_REDKEY, keys[0]);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_REDVALUE, values[0]);
 
         ///cleanup
         Map_Destroy(handle);
-        Map_Destroy(result);
+        Map_Destroy(clone);
     }
 
-    /*Tests_SRS_MAP_02_047: [If during cloning, any operation fails, then Map_Clone shall return NULL.] */
-    TEST_FUNCTION(Map_Clone_with_map_with_2_element_fails_when_gballoc_fails_2)
+    /*Tests_SRS_MAP_01_009: [Before Map_Add, Map_AddOrUpdate or Map_Delete change the pairs of a map that shares them with other maps, they shall copy the pairs; if the copy fails they shall return MAP_ERROR.] */
+    TEST_FUNCTION(Map_Delete_on_a_clone_copies_the_pairs_first)
     {
         ///arrange
-        MAP_HANDLE result;
+        MAP_RESULT result;
+        MAP_HANDLE clone;
         MAP_HANDLE handle = Map_Create(NULL);
         (void)Map_AddOrUpdate(handle, TEST_REDKEY, TEST_REDVALUE);
         (void)Map_AddOrUpdate(handle, TEST_BLUEKEY, TEST_BLUEVALUE);
+        clone = Map_Clone(handle);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating the HANDLE structure*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(2 * sizeof(char*))); /*this is creating a clone of the storage for keys*/
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDKEY) + 1)); /*this is creating a clone of RED key*/
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_BLUEKEY) + 1)); /*this is creating a clone of BLUE key*/
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(2 * sizeof(char*))); /*this is creating a clone of the storage for values*/
-
-        whenShallmalloc_fail = currentmalloc_call + 6;
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDVALUE) + 1)); /*this is creating a clone of RED value*/
-
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        ///act
-        result = Map_Clone(handle);
-
-        ///assert
-        ASSERT_IS_NULL(result);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        ///cleanup
-        Map_Destroy(handle);
-        Map_Destroy(result);
-    }
-
-    /*Tests_SRS_MAP_02_047: [If during cloning, any operation fails, then Map_Clone shall return NULL.] */
-    TEST_FUNCTION(Map_Clone_with_map_with_2_element_fails_when_gballoc_fails_3)
-    {
-        ///arrange
-        MAP_HANDLE result;
-        MAP_HANDLE handle = Map_Create(NULL);
-        (void)Map_AddOrUpdate(handle, TEST_REDKEY, TEST_REDVALUE);
-        (void)Map_AddOrUpdate(handle, TEST_BLUEKEY, TEST_BLUEVALUE);
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating the HANDLE structure*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(2 * sizeof(char*))); /*this is creating a clone of the storage for keys*/
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDKEY) + 1)); /*this is creating a clone of RED key*/
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_BLUEKEY) + 1)); /*this is creating a clone of BLUE key*/
-
-        whenShallmalloc_fail = currentmalloc_call + 5;
-        STRICT_EXPECTED_CALL(gballoc_malloc(2 * sizeof(char*))); /*this is creating a clone of the storage for values*/
-
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        ///act
-        result = Map_Clone(handle);
-
-        ///assert
-        ASSERT_IS_NULL(result);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        ///cleanup
-        Map_Destroy(handle);
-        Map_Destroy(result);
-    }
-
-    /*Tests_SRS_MAP_02_047: [If during cloning, any operation fails, then Map_Clone shall return NULL.] */
-    TEST_FUNCTION(Map_Clone_with_map_with_2_element_fails_when_gballoc_fails_4)
-    {
-        ///arrange
-        MAP_HANDLE result;
-        MAP_HANDLE handle = Map_Create(NULL);
-        (void)Map_AddOrUpdate(handle, TEST_REDKEY, TEST_REDVALUE);
-        (void)Map_AddOrUpdate(handle, TEST_BLUEKEY, TEST_BLUEVALUE);
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating the HANDLE structure*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(2 * sizeof(char*))); /*this is creating a clone of the storage for keys*/
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDKEY) + 1)); /*this is creating a clone of RED key*/
-
-        whenShallmalloc_fail = currentmalloc_call + 4;
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_BLUEKEY) + 1)); /*this is creating a clone of BLUE key*/
-
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        ///act
-        result = Map_Clone(handle);
-
-        ///assert
-        ASSERT_IS_NULL(result);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        ///cleanup
-        Map_Destroy(handle);
-        Map_Destroy(result);
-    }
-
-    /*Tests_SRS_MAP_02_047: [If during cloning, any operation fails, then Map_Clone shall return NULL.] */
-    TEST_FUNCTION(Map_Clone_with_map_with_2_element_fails_when_gballoc_fails_5)
-    {
-        ///arrange
-        MAP_HANDLE result;
-        MAP_HANDLE handle = Map_Create(NULL);
-        (void)Map_AddOrUpdate(handle, TEST_REDKEY, TEST_REDVALUE);
-        (void)Map_AddOrUpdate(handle, TEST_BLUEKEY, TEST_BLUEVALUE);
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating the HANDLE structure*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(2 * sizeof(char*))); /*this is creating a clone of the storage for keys*/
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_REDKEY) + 1))
-            .SetReturn(NULL); /*this is creating a clone of RED key*/
-
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
         ///act
-        result = Map_Clone(handle);
+        result = Map_Delete(clone, TEST_REDKEY);
 
         ///assert
-        ASSERT_IS_NULL(result);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        ///cleanup
-        Map_Destroy(handle);
-        Map_Destroy(result);
-    }
-
-    /*Tests_SRS_MAP_02_047: [If during cloning, any operation fails, then Map_Clone shall return NULL.] */
-    TEST_FUNCTION(Map_Clone_with_map_with_2_element_fails_when_gballoc_fails_6)
-    {
-        ///arrange
-        MAP_HANDLE result;
-        MAP_HANDLE handle = Map_Create(NULL);
-        (void)Map_AddOrUpdate(handle, TEST_REDKEY, TEST_REDVALUE);
-        (void)Map_AddOrUpdate(handle, TEST_BLUEKEY, TEST_BLUEVALUE);
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating the HANDLE structure*/
-            .IgnoreArgument(1);
-
-        whenShallmalloc_fail = currentmalloc_call + 2;
-        STRICT_EXPECTED_CALL(gballoc_malloc(2 * sizeof(char*))); /*this is creating a clone of the storage for keys*/
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        ///act
-        result = Map_Clone(handle);
-
-        ///assert
-        ASSERT_IS_NULL(result);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_OK, result);
+        ASSERT_IS_NULL(Map_GetValueFromKey(clone, TEST_REDKEY));
+        ASSERT_ARE_EQUAL(char_ptr, TEST_BLUEVALUE, Map_GetValueFromKey(clone, TEST_BLUEKEY));
+        ASSERT_ARE_EQUAL(char_ptr, TEST_REDVALUE, Map_GetValueFromKey(handle, TEST_REDKEY));
+        ASSERT_ARE_EQUAL(char_ptr, TEST_BLUEVALUE, Map_GetValueFromKey(handle, TEST_BLUEKEY));
 
         ///cleanup
         Map_Destroy(handle);
-        Map_Destroy(result);
+        Map_Destroy(clone);
     }
 
-    /*Tests_SRS_MAP_02_047: [If during cloning, any operation fails, then Map_Clone shall return NULL.] */
-    TEST_FUNCTION(Map_Clone_with_map_with_2_element_fails_when_gballoc_fails_7)
+    /*Tests_SRS_MAP_01_009: [Before Map_Add, Map_AddOrUpdate or Map_Delete change the pairs of a map that shares them with other maps, they shall copy the pairs; if the copy fails they shall return MAP_ERROR.] */
+    TEST_FUNCTION(Map_Delete_on_a_clone_fails_when_copying_the_pairs_fails)
     {
         ///arrange
-        MAP_HANDLE result;
+        MAP_RESULT result;
+        MAP_HANDLE clone;
         MAP_HANDLE handle = Map_Create(NULL);
         (void)Map_AddOrUpdate(handle, TEST_REDKEY, TEST_REDVALUE);
-        (void)Map_AddOrUpdate(handle, TEST_BLUEKEY, TEST_BLUEVALUE);
+        clone = Map_Clone(handle);
         umock_c_reset_all_calls();
 
         whenShallmalloc_fail = currentmalloc_call + 1;
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating the HANDLE structure*/
-            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(char*))); /*this is creating a copy of the storage for keys*/
 
         ///act
-        result = Map_Clone(handle);
+        result = Map_Delete(clone, TEST_REDKEY);
 
         ///assert
-        ASSERT_IS_NULL(result);
+        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_ERROR, result);
+        ASSERT_ARE_EQUAL(char_ptr, TEST_REDVALUE, Map_GetValueFromKey(clone, TEST_REDKEY));
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         Map_Destroy(handle);
-        Map_Destroy(result);
+        Map_Destroy(clone);
     }
 
     /* Tests_SRS_MAP_07_009: [If the mapFilterCallback function is not NULL, then the return value will be check and if it is not zero then Map_Add shall return MAP_FILTER_REJECT.] */
@@ -2710,374 +2733,76 @@ BEGIN_TEST_SUITE(map_unittests)
         MAP_RESULT result2;
         umock_c_reset_all_calls();
 
-        EXPECTED_CALL(gballoc_realloc(NULL, sizeof(const char*)));
-        EXPECTED_CALL(gballoc_realloc(NULL, sizeof(const char*)));
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_GREENKEY) + 1));
-        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_GREENVALUE) + 1));
-
-        ///act
-        result1 = Map_AddOrUpdate(handle, TEST_REDKEY, TEST_REDVALUE);
-        result2 = Map_AddOrUpdate(handle, TEST_GREENKEY, TEST_GREENVALUE);
-
-        ///assert
-        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_FILTER_REJECT, result1);
-        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_OK, result2);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        ///cleanup
-        Map_Destroy(handle);
-    }
-
-    /*Tests_SRS_MAP_02_052: [If parameter handle is NULL then Map_ToJSON shall return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_fails_with_NULL_argument)
-    {
-        ///arrange
-
-        ///act
-        STRING_HANDLE toJSON = Map_ToJSON(NULL);
-
-        ///assert
-        ASSERT_IS_NULL(toJSON);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        ///cleanup
-    }
-
-    /*Tests_SRS_MAP_02_048: [Map_ToJSON shall produce a STRING_HANDLE representing the content of the MAP.]*/
-    /*Tests_SRS_MAP_02_049: [If the MAP is empty, then Map_ToJSON shall produce the string "{}".] */
-    TEST_FUNCTION(Map_ToJSON_with_empty_MAP_produces_empty_JSON)
-    {
-        ///arrange
-        MAP_HANDLE handle = Map_Create(NULL);
-        STRING_HANDLE toJSON;
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "}"))
-            .IgnoreArgument(1);
-
-        ///act
-        toJSON = Map_ToJSON(handle);
-
-        ///assert
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        ///cleanup
-        Map_Destroy(handle);
-        STRING_delete(toJSON);
-    }
-
-    /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_empty_MAP_produces_empty_JSON_fails_when_STRING_concat_fails)
-    {
-        ///arrange
-        MAP_HANDLE handle = Map_Create(NULL);
-        STRING_HANDLE toJSON;
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "}"))
-            .IgnoreArgument(1).SetReturn(1);
-
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        ///act
-        toJSON = Map_ToJSON(handle);
-
-        ///assert
-        ASSERT_IS_NULL(toJSON);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        ///cleanup
-        Map_Destroy(handle);
-    }
-
-    /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_empty_MAP_produces_empty_JSON_fails_when_STRING_construct_fails)
-    {
-        ///arrange
-        MAP_HANDLE handle = Map_Create(NULL);
-        STRING_HANDLE toJSON;
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1).SetReturn(NULL);
-
-        ///act
-        toJSON = Map_ToJSON(handle);
-
-        ///assert
-        ASSERT_IS_NULL(toJSON);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        ///cleanup
-        Map_Destroy(handle);
-    }
-
-    /*Tests_SRS_MAP_02_050: [If the map has properties then Map_ToJSON shall produce the following string:{"name1":"value1", "name2":"value2" ...}] */
-    TEST_FUNCTION(Map_ToJSON_with_1_MAP_element_succeeds)
-    {
-        ///arrange
-        MAP_HANDLE handle = Map_Create(NULL);
-        STRING_HANDLE toJSON;
-        (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")); /*prepare the key*/
-        STRICT_EXPECTED_CALL(STRING_new_JSON("reddoor")); /*prepare the value*/
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ":")) /*now JSON is {"redkey":*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey":"reddoor"*/
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "}"))/*now JSON is {"redkey":"redoor"}*/
-            .IgnoreArgument(1);
-
-        ///act
-        toJSON = Map_ToJSON(handle);
-
-        ///assert
-        ASSERT_IS_NOT_NULL(toJSON);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        ///cleanup
-        Map_Destroy(handle);
-        STRING_delete(toJSON);
-    }
-
-    /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_1_MAP_element_fail_when_STRING_fails_1)
-    {
-        ///arrange
-        MAP_HANDLE handle = Map_Create(NULL);
-        STRING_HANDLE toJSON;
-        (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")); /*prepare the key*/
-        STRICT_EXPECTED_CALL(STRING_new_JSON("reddoor")); /*prepare the value*/
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ":")) /*now JSON is {"redkey":*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey":"reddoor"*/
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "}"))/*now JSON is {"redkey":"redoor"}*/
-            .IgnoreArgument(1).SetReturn(1);
-
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        ///act
-        toJSON = Map_ToJSON(handle);
-
-        ///assert
-        ASSERT_IS_NULL(toJSON);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        ///cleanup
-        Map_Destroy(handle);
-    }
-
-    /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_1_MAP_element_fail_when_STRING_fails_2)
-    {
-        ///arrange
-        MAP_HANDLE handle = Map_Create(NULL);
-        STRING_HANDLE toJSON;
-        (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")); /*prepare the key*/
-        STRICT_EXPECTED_CALL(STRING_new_JSON("reddoor")); /*prepare the value*/
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ":")) /*now JSON is {"redkey":*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey":"reddoor"*/
-            .IgnoreArgument(1)
-            .IgnoreArgument(2)
-            .SetReturn(1);
-
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
-        ///act
-        toJSON = Map_ToJSON(handle);
-
-        ///assert
-        ASSERT_IS_NULL(toJSON);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        ///cleanup
-        Map_Destroy(handle);
-    }
-
-    /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_1_MAP_element_fail_when_STRING_fails_3)
-    {
-        ///arrange
-        MAP_HANDLE handle = Map_Create(NULL);
-        STRING_HANDLE toJSON;
-        (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")); /*prepare the key*/
-        STRICT_EXPECTED_CALL(STRING_new_JSON("reddoor")); /*prepare the value*/
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-            .IgnoreArgument(1)
-            .IgnoreArgument(2);
-        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ":")) /*now JSON is {"redkey":*/
-            .IgnoreArgument(1)
-            .SetReturn(1);
-
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+        EXPECTED_CALL(gballoc_realloc(NULL, sizeof(const char*)));
+        EXPECTED_CALL(gballoc_realloc(NULL, sizeof(const char*)));
+        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_GREENKEY) + 1));
+        STRICT_EXPECTED_CALL(gballoc_malloc(strlen(TEST_GREENVALUE) + 1));
 
         ///act
-        toJSON = Map_ToJSON(handle);
+        result1 = Map_AddOrUpdate(handle, TEST_REDKEY, TEST_REDVALUE);
+        result2 = Map_AddOrUpdate(handle, TEST_GREENKEY, TEST_GREENVALUE);
 
         ///assert
-        ASSERT_IS_NULL(toJSON);
+        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_FILTER_REJECT, result1);
+        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_OK, result2);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         Map_Destroy(handle);
     }
 
-    /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_1_MAP_element_fail_when_STRING_fails_4)
+    /*Tests_SRS_MAP_02_052: [If parameter handle is NULL then Map_ToJSON shall return NULL.] */
+    TEST_FUNCTION(Map_ToJSON_fails_with_NULL_argument)
     {
         ///arrange
-        MAP_HANDLE handle = Map_Create(NULL);
-        STRING_HANDLE toJSON;
-        (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")); /*prepare the key*/
-        STRICT_EXPECTED_CALL(STRING_new_JSON("reddoor")); /*prepare the value*/
-        STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-            .IgnoreArgument(1)
-            .IgnoreArgument(2)
-            .SetReturn(1);
-
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
 
         ///act
-        toJSON = Map_ToJSON(handle);
+        STRING_HANDLE toJSON = Map_ToJSON(NULL);
 
         ///assert
         ASSERT_IS_NULL(toJSON);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
-        Map_Destroy(handle);
     }
 
-    /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_1_MAP_element_fail_when_STRING_fails_5)
+    /*Tests_SRS_MAP_02_048: [Map_ToJSON shall produce a STRING_HANDLE representing the content of the MAP.]*/
+    /*Tests_SRS_MAP_02_049: [If the MAP is empty, then Map_ToJSON shall produce the string "{}".] */
+    /*Tests_SRS_MAP_01_004: [Map_ToJSON shall compute the exact length of the JSON representation before writing it, so that it allocates its content once.] */
+    TEST_FUNCTION(Map_ToJSON_with_empty_MAP_produces_empty_JSON)
     {
         ///arrange
         MAP_HANDLE handle = Map_Create(NULL);
         STRING_HANDLE toJSON;
-        (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")); /*prepare the key*/
-        STRICT_EXPECTED_CALL(STRING_new_JSON("reddoor"))
-            .SetReturn(NULL); /*prepare the value*/
-
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(gballoc_malloc(3));
+        STRICT_EXPECTED_CALL(STRING_new_with_memory(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
         ///act
         toJSON = Map_ToJSON(handle);
 
         ///assert
-        ASSERT_IS_NULL(toJSON);
+        ASSERT_IS_NOT_NULL(toJSON);
+        ASSERT_ARE_EQUAL(char_ptr, "{}", (const char*)toJSON);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         Map_Destroy(handle);
+        STRING_delete(toJSON);
     }
 
     /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_1_MAP_element_fail_when_STRING_fails_6)
+    TEST_FUNCTION(Map_ToJSON_with_empty_MAP_fails_when_malloc_fails)
     {
         ///arrange
         MAP_HANDLE handle = Map_Create(NULL);
         STRING_HANDLE toJSON;
-        (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")).SetReturn(NULL); /*prepare the key*/
-
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_malloc(3))
+            .SetReturn(NULL);
 
         ///act
         toJSON = Map_ToJSON(handle);
@@ -3091,17 +2816,19 @@ BEGIN_TEST_SUITE(map_unittests)
     }
 
     /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_1_MAP_element_fail_when_STRING_fails_7)
+    TEST_FUNCTION(Map_ToJSON_with_empty_MAP_fails_when_STRING_new_with_memory_fails)
     {
         ///arrange
         MAP_HANDLE handle = Map_Create(NULL);
         STRING_HANDLE toJSON;
-        (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
+        STRICT_EXPECTED_CALL(gballoc_malloc(3));
+        STRICT_EXPECTED_CALL(STRING_new_with_memory(IGNORED_PTR_ARG))
             .IgnoreArgument(1)
             .SetReturn(NULL);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument(1);
 
         ///act
         toJSON = Map_ToJSON(handle);
@@ -3115,57 +2842,25 @@ BEGIN_TEST_SUITE(map_unittests)
     }
 
     /*Tests_SRS_MAP_02_050: [If the map has properties then Map_ToJSON shall produce the following string:{"name1":"value1", "name2":"value2" ...}] */
-    TEST_FUNCTION(Map_ToJSON_with_2_MAP_elements_succeeds)
+    /*Tests_SRS_MAP_01_004: [Map_ToJSON shall compute the exact length of the JSON representation before writing it, so that it allocates its content once.] */
+    TEST_FUNCTION(Map_ToJSON_with_1_MAP_element_succeeds)
     {
         ///arrange
         MAP_HANDLE handle = Map_Create(NULL);
         STRING_HANDLE toJSON;
         (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
-        (void)Map_AddOrUpdate(handle, "yellowkey", "yellowdoor");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        { /*artificial scope for first key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")); /*prepare the key*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("reddoor")); /*prepare the value*/
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ":")) /*now JSON is {"redkey":*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey":"reddoor"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-                .IgnoreArgument(1);
-        }
-
-        { /*artificial scope for second key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("yellowkey")); /*prepare the key*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("yellowdoor")); /*prepare the value*/
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ","))
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ":")) /*now JSON is {"redkey":*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey":"reddoor"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-                .IgnoreArgument(1);
-        }
-
-        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "}"))/*now JSON is {"redkey":"redoor"}*/
+        STRICT_EXPECTED_CALL(STRING_JSON_length("redkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(STRING_JSON_length("reddoor", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof("{\"redkey\":\"reddoor\"}")));
+        STRICT_EXPECTED_CALL(STRING_JSON_write(IGNORED_PTR_ARG, IGNORED_NUM_ARG, "redkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(1).IgnoreArgument(2).IgnoreArgument(4);
+        STRICT_EXPECTED_CALL(STRING_JSON_write(IGNORED_PTR_ARG, IGNORED_NUM_ARG, "reddoor", IGNORED_PTR_ARG))
+            .IgnoreArgument(1).IgnoreArgument(2).IgnoreArgument(4);
+        STRICT_EXPECTED_CALL(STRING_new_with_memory(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
         ///act
@@ -3173,6 +2868,7 @@ BEGIN_TEST_SUITE(map_unittests)
 
         ///assert
         ASSERT_IS_NOT_NULL(toJSON);
+        ASSERT_ARE_EQUAL(char_ptr, "{\"redkey\":\"reddoor\"}", (const char*)toJSON);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
@@ -3181,63 +2877,18 @@ BEGIN_TEST_SUITE(map_unittests)
     }
 
     /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_2_MAP_elements_fails_when_STRING_fails_1)
+    TEST_FUNCTION(Map_ToJSON_with_1_MAP_element_fails_when_STRING_JSON_length_fails_for_the_key)
     {
         ///arrange
         MAP_HANDLE handle = Map_Create(NULL);
         STRING_HANDLE toJSON;
         (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
-        (void)Map_AddOrUpdate(handle, "yellowkey", "yellowdoor");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        { /*artificial scope for first key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")); /*prepare the key*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("reddoor")); /*prepare the value*/
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ":")) /*now JSON is {"redkey":*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey":"reddoor"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-                .IgnoreArgument(1);
-        }
-
-        { /*artificial scope for second key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("yellowkey")); /*prepare the key*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("yellowdoor")); /*prepare the value*/
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ","))
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ":")) /*now JSON is {"redkey":*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey":"reddoor"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-                .IgnoreArgument(1);
-        }
-
-        STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, "}"))/*now JSON is {"redkey":"redoor"}*/
-            .IgnoreArgument(1)
+        STRICT_EXPECTED_CALL(STRING_JSON_length("redkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
             .SetReturn(1);
 
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
-
         ///act
         toJSON = Map_ToJSON(handle);
 
@@ -3250,59 +2901,19 @@ BEGIN_TEST_SUITE(map_unittests)
     }
 
     /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_2_MAP_elements_fails_when_STRING_fails_2)
+    TEST_FUNCTION(Map_ToJSON_with_1_MAP_element_fails_when_STRING_JSON_length_fails_for_the_value)
     {
         ///arrange
         MAP_HANDLE handle = Map_Create(NULL);
         STRING_HANDLE toJSON;
         (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
-        (void)Map_AddOrUpdate(handle, "yellowkey", "yellowdoor");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        { /*artificial scope for first key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")); /*prepare the key*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("reddoor")); /*prepare the value*/
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ":")) /*now JSON is {"redkey":*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey":"reddoor"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-                .IgnoreArgument(1);
-        }
-
-        { /*artificial scope for second key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("yellowkey")); /*prepare the key*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("yellowdoor")); /*prepare the value*/
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ","))
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ":")) /*now JSON is {"redkey":*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey":"reddoor"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2)
-                .SetReturn(1);
-
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-                .IgnoreArgument(1);
-        }
-
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(STRING_JSON_length("redkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(STRING_JSON_length("reddoor", IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .SetReturn(1);
 
         ///act
         toJSON = Map_ToJSON(handle);
@@ -3316,56 +2927,20 @@ BEGIN_TEST_SUITE(map_unittests)
     }
 
     /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_2_MAP_elements_fails_when_STRING_fails_3)
+    TEST_FUNCTION(Map_ToJSON_with_1_MAP_element_fails_when_malloc_fails)
     {
         ///arrange
         MAP_HANDLE handle = Map_Create(NULL);
         STRING_HANDLE toJSON;
         (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
-        (void)Map_AddOrUpdate(handle, "yellowkey", "yellowdoor");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        { /*artificial scope for first key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")); /*prepare the key*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("reddoor")); /*prepare the value*/
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ":")) /*now JSON is {"redkey":*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey":"reddoor"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-                .IgnoreArgument(1);
-        }
-
-        { /*artificial scope for second key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("yellowkey")); /*prepare the key*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("yellowdoor")); /*prepare the value*/
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ","))
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ":")) /*now JSON is {"redkey":*/
-                .IgnoreArgument(1)
-                .SetReturn(1);
-
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-                .IgnoreArgument(1);
-        }
-
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(STRING_JSON_length("redkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(STRING_JSON_length("reddoor", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof("{\"redkey\":\"reddoor\"}")))
+            .SetReturn(NULL);
 
         ///act
         toJSON = Map_ToJSON(handle);
@@ -3379,54 +2954,23 @@ BEGIN_TEST_SUITE(map_unittests)
     }
 
     /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_2_MAP_elements_fails_when_STRING_fails_4)
+    TEST_FUNCTION(Map_ToJSON_with_1_MAP_element_fails_when_STRING_JSON_write_fails_for_the_key)
     {
         ///arrange
         MAP_HANDLE handle = Map_Create(NULL);
         STRING_HANDLE toJSON;
         (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
-        (void)Map_AddOrUpdate(handle, "yellowkey", "yellowdoor");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        { /*artificial scope for first key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")); /*prepare the key*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("reddoor")); /*prepare the value*/
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ":")) /*now JSON is {"redkey":*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey":"reddoor"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-                .IgnoreArgument(1);
-        }
-
-        { /*artificial scope for second key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("yellowkey")); /*prepare the key*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("yellowdoor")); /*prepare the value*/
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ","))
-                .IgnoreArgument(1);
-
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2)
-                .SetReturn(1);
-
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-                .IgnoreArgument(1);
-        }
-
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(STRING_JSON_length("redkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(STRING_JSON_length("reddoor", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof("{\"redkey\":\"reddoor\"}")));
+        STRICT_EXPECTED_CALL(STRING_JSON_write(IGNORED_PTR_ARG, IGNORED_NUM_ARG, "redkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(1).IgnoreArgument(2).IgnoreArgument(4)
+            .SetReturn(1);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
         ///act
@@ -3441,49 +2985,25 @@ BEGIN_TEST_SUITE(map_unittests)
     }
 
     /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_2_MAP_elements_fails_when_STRING_fails_5)
+    TEST_FUNCTION(Map_ToJSON_with_1_MAP_element_fails_when_STRING_JSON_write_fails_for_the_value)
     {
         ///arrange
         MAP_HANDLE handle = Map_Create(NULL);
         STRING_HANDLE toJSON;
         (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
-        (void)Map_AddOrUpdate(handle, "yellowkey", "yellowdoor");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        { /*artificial scope for first key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")); /*prepare the key*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("reddoor")); /*prepare the value*/
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ":")) /*now JSON is {"redkey":*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey":"reddoor"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-                .IgnoreArgument(1);
-        }
-
-        { /*artificial scope for second key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("yellowkey")); /*prepare the key*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("yellowdoor")); /*prepare the value*/
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ","))
-                .IgnoreArgument(1).SetReturn(1);
-
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-                .IgnoreArgument(1);
-        }
-
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(STRING_JSON_length("redkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(STRING_JSON_length("reddoor", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof("{\"redkey\":\"reddoor\"}")));
+        STRICT_EXPECTED_CALL(STRING_JSON_write(IGNORED_PTR_ARG, IGNORED_NUM_ARG, "redkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(1).IgnoreArgument(2).IgnoreArgument(4);
+        STRICT_EXPECTED_CALL(STRING_JSON_write(IGNORED_PTR_ARG, IGNORED_NUM_ARG, "reddoor", IGNORED_PTR_ARG))
+            .IgnoreArgument(1).IgnoreArgument(2).IgnoreArgument(4)
+            .SetReturn(1);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
         ///act
@@ -3498,43 +3018,27 @@ BEGIN_TEST_SUITE(map_unittests)
     }
 
     /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_2_MAP_elements_fails_when_STRING_fails_6)
+    TEST_FUNCTION(Map_ToJSON_with_1_MAP_element_fails_when_STRING_new_with_memory_fails)
     {
         ///arrange
         MAP_HANDLE handle = Map_Create(NULL);
         STRING_HANDLE toJSON;
         (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
-        (void)Map_AddOrUpdate(handle, "yellowkey", "yellowdoor");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        { /*artificial scope for first key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")); /*prepare the key*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("reddoor")); /*prepare the value*/
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ":")) /*now JSON is {"redkey":*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey":"reddoor"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-                .IgnoreArgument(1);
-        }
-
-        { /*artificial scope for second key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("yellowkey")); /*prepare the key*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("yellowdoor")).SetReturn(NULL); /*prepare the value*/
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-                .IgnoreArgument(1);
-        }
-
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(STRING_JSON_length("redkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(STRING_JSON_length("reddoor", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof("{\"redkey\":\"reddoor\"}")));
+        STRICT_EXPECTED_CALL(STRING_JSON_write(IGNORED_PTR_ARG, IGNORED_NUM_ARG, "redkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(1).IgnoreArgument(2).IgnoreArgument(4);
+        STRICT_EXPECTED_CALL(STRING_JSON_write(IGNORED_PTR_ARG, IGNORED_NUM_ARG, "reddoor", IGNORED_PTR_ARG))
+            .IgnoreArgument(1).IgnoreArgument(2).IgnoreArgument(4);
+        STRICT_EXPECTED_CALL(STRING_new_with_memory(IGNORED_PTR_ARG))
+            .IgnoreArgument(1)
+            .SetReturn(NULL);
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
         ///act
@@ -3548,8 +3052,8 @@ BEGIN_TEST_SUITE(map_unittests)
         Map_Destroy(handle);
     }
 
-    /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_2_MAP_elements_fails_when_STRING_fails_7)
+    /*Tests_SRS_MAP_02_050: [If the map has properties then Map_ToJSON shall produce the following string:{"name1":"value1", "name2":"value2" ...}] */
+    TEST_FUNCTION(Map_ToJSON_with_2_MAP_elements_succeeds)
     {
         ///arrange
         MAP_HANDLE handle = Map_Create(NULL);
@@ -3558,295 +3062,281 @@ BEGIN_TEST_SUITE(map_unittests)
         (void)Map_AddOrUpdate(handle, "yellowkey", "yellowdoor");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        { /*artificial scope for first key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")); /*prepare the key*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("reddoor")); /*prepare the value*/
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ":")) /*now JSON is {"redkey":*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey":"reddoor"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-                .IgnoreArgument(1);
-        }
-
-        { /*artificial scope for second key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("yellowkey")).SetReturn(NULL); /*prepare the key*/
-        }
-
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
+        STRICT_EXPECTED_CALL(STRING_JSON_length("redkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(STRING_JSON_length("reddoor", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(STRING_JSON_length("yellowkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(STRING_JSON_length("yellowdoor", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof("{\"redkey\":\"reddoor\",\"yellowkey\":\"yellowdoor\"}")));
+        STRICT_EXPECTED_CALL(STRING_JSON_write(IGNORED_PTR_ARG, IGNORED_NUM_ARG, "redkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(1).IgnoreArgument(2).IgnoreArgument(4);
+        STRICT_EXPECTED_CALL(STRING_JSON_write(IGNORED_PTR_ARG, IGNORED_NUM_ARG, "reddoor", IGNORED_PTR_ARG))
+            .IgnoreArgument(1).IgnoreArgument(2).IgnoreArgument(4);
+        STRICT_EXPECTED_CALL(STRING_JSON_write(IGNORED_PTR_ARG, IGNORED_NUM_ARG, "yellowkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(1).IgnoreArgument(2).IgnoreArgument(4);
+        STRICT_EXPECTED_CALL(STRING_JSON_write(IGNORED_PTR_ARG, IGNORED_NUM_ARG, "yellowdoor", IGNORED_PTR_ARG))
+            .IgnoreArgument(1).IgnoreArgument(2).IgnoreArgument(4);
+        STRICT_EXPECTED_CALL(STRING_new_with_memory(IGNORED_PTR_ARG))
             .IgnoreArgument(1);
 
         ///act
         toJSON = Map_ToJSON(handle);
 
         ///assert
-        ASSERT_IS_NULL(toJSON);
+        ASSERT_IS_NOT_NULL(toJSON);
+        ASSERT_ARE_EQUAL(char_ptr, "{\"redkey\":\"reddoor\",\"yellowkey\":\"yellowdoor\"}", (const char*)toJSON);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         Map_Destroy(handle);
+        STRING_delete(toJSON);
     }
 
-    /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_2_MAP_elements_fails_when_STRING_fails_8)
+    /*Tests_SRS_MAP_01_006: [If handle or destination is NULL then Map_ToJSONBuffer shall return MAP_INVALIDARG.] */
+    TEST_FUNCTION(Map_ToJSONBuffer_with_NULL_handle_fails)
     {
         ///arrange
-        MAP_HANDLE handle = Map_Create(NULL);
-        STRING_HANDLE toJSON;
-        (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
-        (void)Map_AddOrUpdate(handle, "yellowkey", "yellowdoor");
-        umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        { /*artificial scope for first key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")); /*prepare the key*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("reddoor")); /*prepare the value*/
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ":")) /*now JSON is {"redkey":*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey":"reddoor"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2)
-                .SetReturn(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-                .IgnoreArgument(1);
-        }
+        ///act
+        MAP_RESULT result = Map_ToJSONBuffer(NULL, TEST_BUFFER_HANDLE);
 
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+        ///assert
+        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_INVALIDARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_MAP_01_006: [If handle or destination is NULL then Map_ToJSONBuffer shall return MAP_INVALIDARG.] */
+    TEST_FUNCTION(Map_ToJSONBuffer_with_NULL_destination_fails)
+    {
+        ///arrange
+        MAP_HANDLE handle = Map_Create(NULL);
+        MAP_RESULT result;
+        umock_c_reset_all_calls();
 
         ///act
-        toJSON = Map_ToJSON(handle);
+        result = Map_ToJSONBuffer(handle, NULL);
 
         ///assert
-        ASSERT_IS_NULL(toJSON);
+        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_INVALIDARG, result);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         Map_Destroy(handle);
     }
 
-    /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_2_MAP_elements_fails_when_STRING_fails_9)
+    /*Tests_SRS_MAP_01_005: [Map_ToJSONBuffer shall append to destination the JSON representation that Map_ToJSON produces, without a '\0', growing it once by its exact length.] */
+    TEST_FUNCTION(Map_ToJSONBuffer_with_2_MAP_elements_appends_the_JSON)
     {
         ///arrange
+        static const char expectedJSON[] = "{\"redkey\":\"reddoor\",\"yellowkey\":\"yellowdoor\"}";
         MAP_HANDLE handle = Map_Create(NULL);
-        STRING_HANDLE toJSON;
+        MAP_RESULT result;
         (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
         (void)Map_AddOrUpdate(handle, "yellowkey", "yellowdoor");
+        test_buffer_content[0] = 'a';
+        test_buffer_content[1] = 'b';
+        test_buffer_length = 2;
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        { /*artificial scope for first key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")); /*prepare the key*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("reddoor")); /*prepare the value*/
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ":")) /*now JSON is {"redkey":*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey":"reddoor"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2)
-                .SetReturn(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-                .IgnoreArgument(1);
-        }
+        STRICT_EXPECTED_CALL(STRING_JSON_length("redkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(STRING_JSON_length("reddoor", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(STRING_JSON_length("yellowkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(STRING_JSON_length("yellowdoor", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(BUFFER_length(TEST_BUFFER_HANDLE));
+        STRICT_EXPECTED_CALL(BUFFER_enlarge(TEST_BUFFER_HANDLE, sizeof(expectedJSON) - 1));
+        STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_BUFFER_HANDLE));
+        STRICT_EXPECTED_CALL(STRING_JSON_write(IGNORED_PTR_ARG, IGNORED_NUM_ARG, "redkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(1).IgnoreArgument(2).IgnoreArgument(4);
+        STRICT_EXPECTED_CALL(STRING_JSON_write(IGNORED_PTR_ARG, IGNORED_NUM_ARG, "reddoor", IGNORED_PTR_ARG))
+            .IgnoreArgument(1).IgnoreArgument(2).IgnoreArgument(4);
+        STRICT_EXPECTED_CALL(STRING_JSON_write(IGNORED_PTR_ARG, IGNORED_NUM_ARG, "yellowkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(1).IgnoreArgument(2).IgnoreArgument(4);
+        STRICT_EXPECTED_CALL(STRING_JSON_write(IGNORED_PTR_ARG, IGNORED_NUM_ARG, "yellowdoor", IGNORED_PTR_ARG))
+            .IgnoreArgument(1).IgnoreArgument(2).IgnoreArgument(4);
 
         ///act
-        toJSON = Map_ToJSON(handle);
+        result = Map_ToJSONBuffer(handle, TEST_BUFFER_HANDLE);
 
         ///assert
-        ASSERT_IS_NULL(toJSON);
+        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_OK, result);
+        ASSERT_ARE_EQUAL(size_t, sizeof(expectedJSON) + 1, test_buffer_length);
+        ASSERT_ARE_EQUAL(char_ptr, "ab{\"redkey\":\"reddoor\",\"yellowkey\":\"yellowdoor\"}", (const char*)test_buffer_content);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         Map_Destroy(handle);
     }
 
-    /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_2_MAP_elements_fails_when_STRING_fails_10)
+    /*Tests_SRS_MAP_01_007: [If any error occurs while producing the output, then Map_ToJSONBuffer shall return MAP_ERROR and leave destination unchanged.] */
+    TEST_FUNCTION(Map_ToJSONBuffer_fails_when_STRING_JSON_length_fails)
     {
         ///arrange
         MAP_HANDLE handle = Map_Create(NULL);
-        STRING_HANDLE toJSON;
+        MAP_RESULT result;
         (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
-        (void)Map_AddOrUpdate(handle, "yellowkey", "yellowdoor");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        { /*artificial scope for first key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")); /*prepare the key*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("reddoor")); /*prepare the value*/
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2);
-            STRICT_EXPECTED_CALL(STRING_concat(IGNORED_PTR_ARG, ":")) /*now JSON is {"redkey":*/
-                .IgnoreArgument(1)
-                .SetReturn(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-                .IgnoreArgument(1);
-        }
+        STRICT_EXPECTED_CALL(STRING_JSON_length("redkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(2)
+            .SetReturn(1);
 
         ///act
-        toJSON = Map_ToJSON(handle);
+        result = Map_ToJSONBuffer(handle, TEST_BUFFER_HANDLE);
 
         ///assert
-        ASSERT_IS_NULL(toJSON);
+        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_ERROR, result);
+        ASSERT_ARE_EQUAL(size_t, 0, test_buffer_length);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         Map_Destroy(handle);
     }
 
-    /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_2_MAP_elements_fails_when_STRING_fails_11)
+    /*Tests_SRS_MAP_01_007: [If any error occurs while producing the output, then Map_ToJSONBuffer shall return MAP_ERROR and leave destination unchanged.] */
+    TEST_FUNCTION(Map_ToJSONBuffer_fails_when_BUFFER_enlarge_fails)
     {
         ///arrange
         MAP_HANDLE handle = Map_Create(NULL);
-        STRING_HANDLE toJSON;
+        MAP_RESULT result;
         (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
-        (void)Map_AddOrUpdate(handle, "yellowkey", "yellowdoor");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        { /*artificial scope for first key:value*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")); /*prepare the key*/
-            STRICT_EXPECTED_CALL(STRING_new_JSON("reddoor")); /*prepare the value*/
-            STRICT_EXPECTED_CALL(STRING_concat_with_STRING(IGNORED_PTR_ARG, IGNORED_PTR_ARG)) /*now JSON is {"redkey"*/
-                .IgnoreArgument(1)
-                .IgnoreArgument(2)
-                .SetReturn(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the value*/
-                .IgnoreArgument(1);
-            STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-                .IgnoreArgument(1);
-        }
+        STRICT_EXPECTED_CALL(STRING_JSON_length("redkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(STRING_JSON_length("reddoor", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(BUFFER_length(TEST_BUFFER_HANDLE));
+        STRICT_EXPECTED_CALL(BUFFER_enlarge(TEST_BUFFER_HANDLE, sizeof("{\"redkey\":\"reddoor\"}") - 1))
+            .SetReturn(1);
 
         ///act
-        toJSON = Map_ToJSON(handle);
+        result = Map_ToJSONBuffer(handle, TEST_BUFFER_HANDLE);
 
         ///assert
-        ASSERT_IS_NULL(toJSON);
+        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_ERROR, result);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         Map_Destroy(handle);
     }
 
-    /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_2_MAP_elements_fails_when_STRING_fails_12)
+    /*Tests_SRS_MAP_01_007: [If any error occurs while producing the output, then Map_ToJSONBuffer shall return MAP_ERROR and leave destination unchanged.] */
+    TEST_FUNCTION(Map_ToJSONBuffer_fails_when_STRING_JSON_write_fails)
     {
         ///arrange
         MAP_HANDLE handle = Map_Create(NULL);
-        STRING_HANDLE toJSON;
+        MAP_RESULT result;
         (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
-        (void)Map_AddOrUpdate(handle, "yellowkey", "yellowdoor");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-
-        STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")); /*prepare the key*/
-        STRICT_EXPECTED_CALL(STRING_new_JSON("reddoor")).SetReturn(NULL); /*prepare the value*/
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG)) /*delete the key*/
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(STRING_JSON_length("redkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(STRING_JSON_length("reddoor", IGNORED_PTR_ARG))
+            .IgnoreArgument(2);
+        STRICT_EXPECTED_CALL(BUFFER_length(TEST_BUFFER_HANDLE));
+        STRICT_EXPECTED_CALL(BUFFER_enlarge(TEST_BUFFER_HANDLE, sizeof("{\"redkey\":\"reddoor\"}") - 1));
+        STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_BUFFER_HANDLE));
+        STRICT_EXPECTED_CALL(STRING_JSON_write(IGNORED_PTR_ARG, IGNORED_NUM_ARG, "redkey", IGNORED_PTR_ARG))
+            .IgnoreArgument(1).IgnoreArgument(2).IgnoreArgument(4)
+            .SetReturn(1);
+        STRICT_EXPECTED_CALL(BUFFER_shrink(TEST_BUFFER_HANDLE, sizeof("{\"redkey\":\"reddoor\"}") - 1, true));
 
         ///act
-        toJSON = Map_ToJSON(handle);
+        result = Map_ToJSONBuffer(handle, TEST_BUFFER_HANDLE);
 
         ///assert
-        ASSERT_IS_NULL(toJSON);
+        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_ERROR, result);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         Map_Destroy(handle);
     }
 
-    /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_2_MAP_elements_fails_when_STRING_fails_13)
+    /*Tests_SRS_MAP_01_001: [ Maps with more than MAP_SMALL_CAPACITY pairs shall grow their storage geometrically and shall find keys through an open addressing hash index. ]*/
+    /*Tests_SRS_MAP_01_002: [ The pairs shall be kept in insertion order regardless of the hash index, so that Map_GetInternals and Map_ToJSON produce them in the order they were added. ]*/
+    TEST_FUNCTION(Map_Add_with_many_keys_finds_all_keys_and_keeps_insertion_order)
     {
         ///arrange
         MAP_HANDLE handle = Map_Create(NULL);
-        STRING_HANDLE toJSON;
-        (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
-        (void)Map_AddOrUpdate(handle, "yellowkey", "yellowdoor");
-        umock_c_reset_all_calls();
+        const char*const* keys;
+        const char*const* values;
+        size_t count;
+        char key[16];
+        char value[16];
+        size_t i;
 
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1);
-        STRICT_EXPECTED_CALL(STRING_new_JSON("redkey")).SetReturn(NULL); /*prepare the key*/
-        STRICT_EXPECTED_CALL(STRING_delete(IGNORED_PTR_ARG))
-            .IgnoreArgument(1);
+        for (i = 0; i < 100; i++)
+        {
+            (void)sprintf(key, "key%u", (unsigned int)i);
+            (void)sprintf(value, "value%u", (unsigned int)i);
+            ASSERT_ARE_EQUAL(MAP_RESULT, MAP_OK, Map_Add(handle, key, value));
+        }
 
         ///act
-        toJSON = Map_ToJSON(handle);
+        (void)Map_GetInternals(handle, &keys, &values, &count);
 
         ///assert
-        ASSERT_IS_NULL(toJSON);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(size_t, 100, count);
+        for (i = 0; i < 100; i++)
+        {
+            (void)sprintf(key, "key%u", (unsigned int)i);
+            (void)sprintf(value, "value%u", (unsigned int)i);
+            ASSERT_ARE_EQUAL(char_ptr, key, keys[i]);
+            ASSERT_ARE_EQUAL(char_ptr, value, Map_GetValueFromKey(handle, key));
+        }
+        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_KEYEXISTS, Map_Add(handle, "key42", "other"));
+        ASSERT_IS_NULL(Map_GetValueFromKey(handle, "key100"));
 
         ///cleanup
         Map_Destroy(handle);
     }
 
-    /*Tests_SRS_MAP_02_051: [If any error occurs while producing the output, then Map_ToJSON shall fail and return NULL.] */
-    TEST_FUNCTION(Map_ToJSON_with_2_MAP_elements_fails_when_STRING_fails_14)
+    /*Tests_SRS_MAP_01_001: [ Maps with more than MAP_SMALL_CAPACITY pairs shall grow their storage geometrically and shall find keys through an open addressing hash index. ]*/
+    TEST_FUNCTION(Map_Delete_with_many_keys_keeps_the_index_consistent)
     {
         ///arrange
         MAP_HANDLE handle = Map_Create(NULL);
-        STRING_HANDLE toJSON;
-        (void)Map_AddOrUpdate(handle, "redkey", "reddoor");
-        (void)Map_AddOrUpdate(handle, "yellowkey", "yellowdoor");
-        umock_c_reset_all_calls();
+        char key[16];
+        size_t i;
 
-        STRICT_EXPECTED_CALL(STRING_construct("{"))
-            .IgnoreArgument(1)
-            .SetReturn(NULL);
+        for (i = 0; i < 50; i++)
+        {
+            (void)sprintf(key, "key%u", (unsigned int)i);
+            (void)Map_Add(handle, key, key);
+        }
 
         ///act
-        toJSON = Map_ToJSON(handle);
+        for (i = 0; i < 50; i += 2)
+        {
+            (void)sprintf(key, "key%u", (unsigned int)i);
+            ASSERT_ARE_EQUAL(MAP_RESULT, MAP_OK, Map_Delete(handle, key));
+        }
 
         ///assert
-        ASSERT_IS_NULL(toJSON);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        for (i = 0; i < 50; i++)
+        {
+            (void)sprintf(key, "key%u", (unsigned int)i);
+            if ((i % 2) == 0)
+            {
+                ASSERT_IS_NULL(Map_GetValueFromKey(handle, key));
+            }
+            else
+            {
+                ASSERT_ARE_EQUAL(char_ptr, key, Map_GetValueFromKey(handle, key));
+            }
+        }
+        ASSERT_ARE_EQUAL(MAP_RESULT, MAP_OK, Map_AddOrUpdate(handle, "key1", "updated"));
+        ASSERT_ARE_EQUAL(char_ptr, "updated", Map_GetValueFromKey(handle, "key1"));
 
         ///cleanup
         Map_Destroy(handle);
     }
 
-
 END_TEST_SUITE(map_unittests)
@@ -0,0 +1,951 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes_bool.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    void* real_malloc(size_t size)
+    {
+        return malloc(size);
+    }
+
+    void real_free(void* ptr)
+    {
+        free(ptr);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/tickcounter.h"
+
+MOCK_FUNCTION_WITH_CODE(, void, test_on_io_open_complete, void*, context, IO_OPEN_RESULT, open_result)
+MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_bytes_received, void*, context, const unsigned char*, buffer, size_t, size)
+MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_io_error, void*, context)
+MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_io_close_complete, void*, context)
+MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_send_complete, void*, context, IO_SEND_RESULT, send_result)
+MOCK_FUNCTION_END();
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/memio.h"
+
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
+
+#define TEST_OPTION_HANDLER                     (OPTIONHANDLER_HANDLE)0x4245
+#define TEST_CONTEXT_0                          (void*)0x4246
+#define TEST_CONTEXT_1                          (void*)0x4247
+#define TEST_SEND_CONTEXT                       (void*)0x4248
+
+static const IO_INTERFACE_DESCRIPTION* memio_interface;
+static tickcounter_us_t g_current_us;
+
+/* the pair and the IOs of its two sides made by create_ios */
+static MEMIO_PAIR_HANDLE g_pair;
+static CONCRETE_IO_HANDLE g_ios[2];
+
+static int my_tickcounter_get_monotonic_us(tickcounter_us_t* current_us)
+{
+    *current_us = g_current_us;
+    return 0;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+/* creates a pair and the IOs of both sides, closed */
+static void create_ios(const MEMIO_LINK_CONFIG* link_0_to_1, const MEMIO_LINK_CONFIG* link_1_to_0)
+{
+    MEMIO_CONFIG memio_config;
+    int side;
+
+    g_pair = memio_pair_create(link_0_to_1, link_1_to_0);
+    ASSERT_IS_NOT_NULL(g_pair);
+
+    for (side = 0; side < 2; side++)
+    {
+        memio_config.pair = g_pair;
+        memio_config.side = side;
+        g_ios[side] = memio_interface->concrete_io_create(&memio_config);
+        ASSERT_IS_NOT_NULL(g_ios[side]);
+    }
+
+    umock_c_reset_all_calls();
+}
+
+static void open_io(int side)
+{
+    int result = memio_interface->concrete_io_open(g_ios[side], test_on_io_open_complete, (side == 0) ? TEST_CONTEXT_0 : TEST_CONTEXT_1,
+        test_on_bytes_received, (side == 0) ? TEST_CONTEXT_0 : TEST_CONTEXT_1, test_on_io_error, (side == 0) ? TEST_CONTEXT_0 : TEST_CONTEXT_1);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    umock_c_reset_all_calls();
+}
+
+static void create_open_ios(const MEMIO_LINK_CONFIG* link_0_to_1, const MEMIO_LINK_CONFIG* link_1_to_0)
+{
+    create_ios(link_0_to_1, link_1_to_0);
+    open_io(0);
+    open_io(1);
+}
+
+static void destroy_ios(void)
+{
+    memio_interface->concrete_io_destroy(g_ios[0]);
+    memio_interface->concrete_io_destroy(g_ios[1]);
+    memio_pair_destroy(g_pair);
+}
+
+static void send_bytes(int side, const char* bytes, size_t size)
+{
+    int result = memio_interface->concrete_io_send(g_ios[side], bytes, size, test_on_send_complete, TEST_SEND_CONTEXT);
+    ASSERT_ARE_EQUAL(int, 0, result);
+}
+
+BEGIN_TEST_SUITE(memio_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, real_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, real_free);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_monotonic_us, my_tickcounter_get_monotonic_us);
+    REGISTER_GLOBAL_MOCK_RETURN(OptionHandler_Create, TEST_OPTION_HANDLER);
+    REGISTER_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT);
+    REGISTER_TYPE(IO_SEND_RESULT, IO_SEND_RESULT);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfCloneOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(pfSetOption, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(tickcounter_us_t*, void*);
+
+    memio_interface = memio_get_interface_description();
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+    g_current_us = 0;
+    g_pair = NULL;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* memio_pair_create */
+
+/* Tests_SRS_MEMIO_01_001: [ memio_pair_create shall create a pair of sides with no IO, connected by a link from side 0 to side 1 configured by link_0_to_1 and a link from side 1 to side 0 configured by link_1_to_0. ]*/
+/* Tests_SRS_MEMIO_01_003: [ A NULL link configuration shall give a link without latency, bandwidth limit or chunking. ]*/
+TEST_FUNCTION(memio_pair_create_creates_a_pair)
+{
+    // arrange
+    MEMIO_PAIR_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = memio_pair_create(NULL, NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    memio_pair_destroy(result);
+}
+
+/* Tests_SRS_MEMIO_01_002: [ If allocating memory fails, memio_pair_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_memory_fails_memio_pair_create_fails)
+{
+    // arrange
+    MEMIO_PAIR_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = memio_pair_create(NULL, NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* memio_pair_destroy */
+
+/* Tests_SRS_MEMIO_01_004: [ If pair is NULL, memio_pair_destroy shall return. ]*/
+TEST_FUNCTION(memio_pair_destroy_with_NULL_returns)
+{
+    // act
+    memio_pair_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_MEMIO_01_005: [ memio_pair_destroy shall free the bytes left on both links and the pair. ]*/
+TEST_FUNCTION(memio_pair_destroy_frees_the_bytes_left_on_the_links)
+{
+    // arrange
+    create_ios(NULL, NULL);
+    open_io(0);
+    send_bytes(0, "abc", 3);
+    memio_interface->concrete_io_destroy(g_ios[0]);
+    memio_interface->concrete_io_destroy(g_ios[1]);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(g_pair));
+
+    // act
+    memio_pair_destroy(g_pair);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* memio_create */
+
+/* Tests_SRS_MEMIO_01_006: [ If io_create_parameters is NULL, memio_create shall fail and return NULL. ]*/
+TEST_FUNCTION(memio_create_with_NULL_io_create_parameters_fails)
+{
+    // act
+    CONCRETE_IO_HANDLE result = memio_interface->concrete_io_create(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_MEMIO_01_008: [ If pair is NULL, side is neither 0 nor 1, or the side already has an IO, memio_create shall fail and return NULL. ]*/
+TEST_FUNCTION(memio_create_with_bad_sides_fails)
+{
+    // arrange
+    MEMIO_CONFIG memio_config;
+    create_ios(NULL, NULL);
+
+    // act
+    // assert
+    memio_config.pair = NULL;
+    memio_config.side = 0;
+    ASSERT_IS_NULL(memio_interface->concrete_io_create(&memio_config));
+    memio_config.pair = g_pair;
+    memio_config.side = 2;
+    ASSERT_IS_NULL(memio_interface->concrete_io_create(&memio_config));
+    memio_config.side = -1;
+    ASSERT_IS_NULL(memio_interface->concrete_io_create(&memio_config));
+    memio_config.side = 1;
+    ASSERT_IS_NULL(memio_interface->concrete_io_create(&memio_config));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_ios();
+}
+
+/* Tests_SRS_MEMIO_01_007: [ io_create_parameters shall be used as a MEMIO_CONFIG*. ]*/
+/* Tests_SRS_MEMIO_01_009: [ memio_create shall create a closed IO for the side of the pair. ]*/
+TEST_FUNCTION(memio_create_creates_a_closed_io)
+{
+    // arrange
+    MEMIO_CONFIG memio_config;
+    CONCRETE_IO_HANDLE result;
+    MEMIO_PAIR_HANDLE pair = memio_pair_create(NULL, NULL);
+    umock_c_reset_all_calls();
+    memio_config.pair = pair;
+    memio_config.side = 1;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = memio_interface->concrete_io_create(&memio_config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, memio_interface->concrete_io_send(result, "a", 1, NULL, NULL));
+
+    // cleanup
+    memio_interface->concrete_io_destroy(result);
+    memio_pair_destroy(pair);
+}
+
+/* Tests_SRS_MEMIO_01_010: [ If allocating memory fails, memio_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_memory_fails_memio_create_fails)
+{
+    // arrange
+    MEMIO_CONFIG memio_config;
+    CONCRETE_IO_HANDLE result;
+    MEMIO_PAIR_HANDLE pair = memio_pair_create(NULL, NULL);
+    umock_c_reset_all_calls();
+    memio_config.pair = pair;
+    memio_config.side = 0;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = memio_interface->concrete_io_create(&memio_config);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    memio_pair_destroy(pair);
+}
+
+/* memio_destroy */
+
+/* Tests_SRS_MEMIO_01_011: [ If memio is NULL, memio_destroy shall return. ]*/
+TEST_FUNCTION(memio_destroy_with_NULL_returns)
+{
+    // act
+    memio_interface->concrete_io_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_MEMIO_01_012: [ memio_destroy shall close the IO if it is open, and free it, leaving the side of the pair without IO. ]*/
+TEST_FUNCTION(memio_destroy_closes_the_io_and_frees_the_side)
+{
+    // arrange
+    MEMIO_LINK_CONFIG link_config = { 1000, 0, 0, 0 };
+    MEMIO_CONFIG memio_config;
+    create_open_ios(&link_config, NULL);
+    g_current_us = 100;
+    /* leaves at once, reaches side 1 1000 us later */
+    send_bytes(0, "abc", 3);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_send_complete(TEST_SEND_CONTEXT, IO_SEND_OK));
+    STRICT_EXPECTED_CALL(gballoc_free(g_ios[0]));
+
+    // act
+    memio_interface->concrete_io_destroy(g_ios[0]);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    memio_config.pair = g_pair;
+    memio_config.side = 0;
+    g_ios[0] = memio_interface->concrete_io_create(&memio_config);
+    ASSERT_IS_NOT_NULL(g_ios[0]);
+
+    // cleanup
+    destroy_ios();
+}
+
+/* memio_open */
+
+/* Tests_SRS_MEMIO_01_013: [ If memio, on_io_open_complete, on_bytes_received or on_io_error is NULL, memio_open shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(memio_open_with_NULL_arguments_fails)
+{
+    // arrange
+    create_ios(NULL, NULL);
+
+    // act
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, memio_interface->concrete_io_open(NULL, test_on_io_open_complete, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL));
+    ASSERT_ARE_NOT_EQUAL(int, 0, memio_interface->concrete_io_open(g_ios[0], NULL, NULL, test_on_bytes_received, NULL, test_on_io_error, NULL));
+    ASSERT_ARE_NOT_EQUAL(int, 0, memio_interface->concrete_io_open(g_ios[0], test_on_io_open_complete, NULL, NULL, NULL, test_on_io_error, NULL));
+    ASSERT_ARE_NOT_EQUAL(int, 0, memio_interface->concrete_io_open(g_ios[0], test_on_io_open_complete, NULL, test_on_bytes_received, NULL, NULL, NULL));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_ios();
+}
+
+/* Tests_SRS_MEMIO_01_015: [ memio_open shall open the IO and call on_io_open_complete with IO_OPEN_OK before returning 0. ]*/
+TEST_FUNCTION(memio_open_completes_at_once)
+{
+    // arrange
+    int result;
+    create_ios(NULL, NULL);
+    STRICT_EXPECTED_CALL(test_on_io_open_complete(TEST_CONTEXT_0, IO_OPEN_OK));
+
+    // act
+    result = memio_interface->concrete_io_open(g_ios[0], test_on_io_open_complete, TEST_CONTEXT_0, test_on_bytes_received, TEST_CONTEXT_0, test_on_io_error, TEST_CONTEXT_0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_ios();
+}
+
+/* Tests_SRS_MEMIO_01_014: [ If the IO is not closed, memio_open shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(memio_open_when_open_fails)
+{
+    // arrange
+    int result;
+    create_open_ios(NULL, NULL);
+
+    // act
+    result = memio_interface->concrete_io_open(g_ios[0], test_on_io_open_complete, TEST_CONTEXT_0, test_on_bytes_received, TEST_CONTEXT_0, test_on_io_error, TEST_CONTEXT_0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_ios();
+}
+
+/* memio_send */
+
+/* Tests_SRS_MEMIO_01_030: [ If buffer is NULL or size is 0, memio_send shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(memio_send_with_bad_arguments_fails)
+{
+    // arrange
+    create_open_ios(NULL, NULL);
+
+    // act
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, memio_interface->concrete_io_send(g_ios[0], NULL, 1, test_on_send_complete, NULL));
+    ASSERT_ARE_NOT_EQUAL(int, 0, memio_interface->concrete_io_send(g_ios[0], "a", 0, test_on_send_complete, NULL));
+    ASSERT_ARE_NOT_EQUAL(int, 0, memio_interface->concrete_io_send(NULL, "a", 1, test_on_send_complete, NULL));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_ios();
+}
+
+/* Tests_SRS_MEMIO_01_026: [ If allocating memory fails, memio_sendv shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_memory_fails_memio_send_fails)
+{
+    // arrange
+    int result;
+    create_open_ios(NULL, NULL);
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = memio_interface->concrete_io_send(g_ios[0], "abc", 3, test_on_send_complete, TEST_SEND_CONTEXT);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_ios();
+}
+
+/* Tests_SRS_MEMIO_01_025: [ If the IO is not open, memio_sendv shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(memio_send_when_not_open_fails)
+{
+    // arrange
+    int result;
+    create_ios(NULL, NULL);
+
+    // act
+    result = memio_interface->concrete_io_send(g_ios[0], "abc", 3, test_on_send_complete, TEST_SEND_CONTEXT);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_ios();
+}
+
+/* Tests_SRS_MEMIO_01_027: [ memio_sendv shall copy the bytes of the buffers, back to back, at the end of the link to the other side. ]*/
+/* Tests_SRS_MEMIO_01_029: [ On success memio_sendv shall return 0. ]*/
+/* Tests_SRS_MEMIO_01_031: [ Otherwise memio_send shall behave as memio_sendv with the one buffer. ]*/
+TEST_FUNCTION(memio_send_copies_the_bytes)
+{
+    // arrange
+    char bytes[] = "abc";
+    int result;
+    create_open_ios(NULL, NULL);
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = memio_interface->concrete_io_send(g_ios[0], bytes, 3, test_on_send_complete, TEST_SEND_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    bytes[0] = 'x';
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_on_bytes_received(TEST_CONTEXT_1, IGNORED_PTR_ARG, 3))
+        .ValidateArgumentBuffer(2, "abc", 3);
+    memio_interface->concrete_io_dowork(g_ios[1]);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_ios();
+}
+
+/* memio_sendv */
+
+/* Tests_SRS_MEMIO_01_023: [ If memio or buffers is NULL, or buffer_count is 0, memio_sendv shall fail and return a non-zero value. ]*/
+/* Tests_SRS_MEMIO_01_024: [ If a buffer with bytes has a NULL pointer, or the buffers hold no byte, memio_sendv shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(memio_sendv_with_bad_arguments_fails)
+{
+    // arrange
+    XIO_BUFFER buffers[2];
+    create_open_ios(NULL, NULL);
+    buffers[0].buffer = "a";
+    buffers[0].size = 0;
+    buffers[1].buffer = NULL;
+    buffers[1].size = 1;
+
+    // act
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, memio_interface->concrete_io_sendv(NULL, buffers, 1, NULL, NULL));
+    ASSERT_ARE_NOT_EQUAL(int, 0, memio_interface->concrete_io_sendv(g_ios[0], NULL, 1, NULL, NULL));
+    ASSERT_ARE_NOT_EQUAL(int, 0, memio_interface->concrete_io_sendv(g_ios[0], buffers, 0, NULL, NULL));
+    ASSERT_ARE_NOT_EQUAL(int, 0, memio_interface->concrete_io_sendv(g_ios[0], buffers, 1, NULL, NULL));
+    ASSERT_ARE_NOT_EQUAL(int, 0, memio_interface->concrete_io_sendv(g_ios[0], buffers, 2, NULL, NULL));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_ios();
+}
+
+/* Tests_SRS_MEMIO_01_027: [ memio_sendv shall copy the bytes of the buffers, back to back, at the end of the link to the other side. ]*/
+TEST_FUNCTION(memio_sendv_indicates_the_buffers_back_to_back)
+{
+    // arrange
+    XIO_BUFFER buffers[3];
+    int result;
+    create_open_ios(NULL, NULL);
+    buffers[0].buffer = "ab";
+    buffers[0].size = 2;
+    buffers[1].buffer = NULL;
+    buffers[1].size = 0;
+    buffers[2].buffer = "cde";
+    buffers[2].size = 3;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = memio_interface->concrete_io_sendv(g_ios[0], buffers, 3, test_on_send_complete, TEST_SEND_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_on_bytes_received(TEST_CONTEXT_1, IGNORED_PTR_ARG, 5))
+        .ValidateArgumentBuffer(2, "abcde", 5);
+    memio_interface->concrete_io_dowork(g_ios[1]);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_ios();
+}
+
+/* memio_dowork_ex */
+
+/* Tests_SRS_MEMIO_01_032: [ If memio, made_progress or next_deadline_us is NULL, memio_dowork_ex shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(memio_dowork_ex_with_NULL_arguments_fails)
+{
+    // arrange
+    bool made_progress;
+    uint64_t next_deadline_us;
+    create_open_ios(NULL, NULL);
+
+    // act
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, memio_interface->concrete_io_dowork_ex(NULL, &made_progress, &next_deadline_us));
+    ASSERT_ARE_NOT_EQUAL(int, 0, memio_interface->concrete_io_dowork_ex(g_ios[0], NULL, &next_deadline_us));
+    ASSERT_ARE_NOT_EQUAL(int, 0, memio_interface->concrete_io_dowork_ex(g_ios[0], &made_progress, NULL));
+
+    // cleanup
+    destroy_ios();
+}
+
+/* Tests_SRS_MEMIO_01_033: [ memio_dowork_ex shall complete with IO_SEND_OK the sends whose bytes have left, in order. ]*/
+/* Tests_SRS_MEMIO_01_037: [ memio_dowork_ex shall set made_progress to true when it called back the layer above, and return 0. ]*/
+TEST_FUNCTION(memio_dowork_ex_completes_the_sends_on_the_sending_side)
+{
+    // arrange
+    bool made_progress;
+    uint64_t next_deadline_us;
+    int result;
+    create_open_ios(NULL, NULL);
+    send_bytes(0, "abc", 3);
+    send_bytes(0, "de", 2);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_on_send_complete(TEST_SEND_CONTEXT, IO_SEND_OK));
+    STRICT_EXPECTED_CALL(test_on_send_complete(TEST_SEND_CONTEXT, IO_SEND_OK));
+
+    // act
+    result = memio_interface->concrete_io_dowork_ex(g_ios[0], &made_progress, &next_deadline_us);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE(made_progress);
+    ASSERT_ARE_EQUAL(uint64_t, XIO_NO_DEADLINE, next_deadline_us);
+
+    // cleanup
+    destroy_ios();
+}
+
+/* Tests_SRS_MEMIO_01_034: [ When the IO is open, memio_dowork_ex shall then indicate the bytes that reached it with on_bytes_received, in order, each call giving at most the chunk size of the link and never bytes of two sends. ]*/
+TEST_FUNCTION(memio_dowork_ex_indicates_the_bytes_in_chunks)
+{
+    // arrange
+    MEMIO_LINK_CONFIG link_config = { 0, 0, 3, 0 };
+    bool made_progress;
+    uint64_t next_deadline_us;
+    create_open_ios(&link_config, NULL);
+    send_bytes(0, "abcdefg", 7);
+    send_bytes(0, "hi", 2);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_on_bytes_received(TEST_CONTEXT_1, IGNORED_PTR_ARG, 3))
+        .ValidateArgumentBuffer(2, "abc", 3);
+    STRICT_EXPECTED_CALL(test_on_bytes_received(TEST_CONTEXT_1, IGNORED_PTR_ARG, 3))
+        .ValidateArgumentBuffer(2, "def", 3);
+    STRICT_EXPECTED_CALL(test_on_bytes_received(TEST_CONTEXT_1, IGNORED_PTR_ARG, 1))
+        .ValidateArgumentBuffer(2, "g", 1);
+    STRICT_EXPECTED_CALL(test_on_bytes_received(TEST_CONTEXT_1, IGNORED_PTR_ARG, 2))
+        .ValidateArgumentBuffer(2, "hi", 2);
+
+    // act
+    ASSERT_ARE_EQUAL(int, 0, memio_interface->concrete_io_dowork_ex(g_ios[1], &made_progress, &next_deadline_us));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE(made_progress);
+
+    // cleanup
+    destroy_ios();
+}
+
+/* Tests_SRS_MEMIO_01_034: [ When the IO is open, memio_dowork_ex shall then indicate the bytes that reached it with on_bytes_received, in order, each call giving at most the chunk size of the link and never bytes of two sends. ]*/
+TEST_FUNCTION(memio_dowork_ex_indicates_the_bytes_sent_before_the_side_opened)
+{
+    // arrange
+    create_ios(NULL, NULL);
+    open_io(0);
+    send_bytes(0, "abc", 3);
+    memio_interface->concrete_io_dowork(g_ios[1]);
+    open_io(1);
+    STRICT_EXPECTED_CALL(test_on_bytes_received(TEST_CONTEXT_1, IGNORED_PTR_ARG, 3))
+        .ValidateArgumentBuffer(2, "abc", 3);
+
+    // act
+    memio_interface->concrete_io_dowork(g_ios[1]);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_ios();
+}
+
+/* Tests_SRS_MEMIO_01_028: [ The bytes shall leave once the bytes sent before them have, after size / bytes_per_second seconds, and reach the other side latency_us later. ]*/
+/* Tests_SRS_MEMIO_01_036: [ memio_dowork_ex shall give the earliest time a send is to complete or bytes are to reach the IO as next_deadline_us, XIO_NO_DEADLINE if none. ]*/
+TEST_FUNCTION(memio_dowork_ex_waits_for_the_bandwidth_and_the_latency)
+{
+    // arrange
+    /* 10 bytes take 10000 us to leave and reach the other side 500 us later */
+    MEMIO_LINK_CONFIG link_config = { 500, 1000, 0, 0 };
+    bool made_progress;
+    uint64_t next_deadline_us;
+    create_open_ios(&link_config, NULL);
+    g_current_us = 1000;
+    send_bytes(0, "0123456789", 10);
+    umock_c_reset_all_calls();
+
+    // act
+    // assert
+    g_current_us = 10999;
+    ASSERT_ARE_EQUAL(int, 0, memio_interface->concrete_io_dowork_ex(g_ios[0], &made_progress, &next_deadline_us));
+    ASSERT_IS_FALSE(made_progress);
+    ASSERT_ARE_EQUAL(uint64_t, 11000, next_deadline_us);
+
+    g_current_us = 11000;
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_send_complete(TEST_SEND_CONTEXT, IO_SEND_OK));
+    ASSERT_ARE_EQUAL(int, 0, memio_interface->concrete_io_dowork_ex(g_ios[0], &made_progress, &next_deadline_us));
+    ASSERT_IS_TRUE(made_progress);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ASSERT_ARE_EQUAL(int, 0, memio_interface->concrete_io_dowork_ex(g_ios[1], &made_progress, &next_deadline_us));
+    ASSERT_IS_FALSE(made_progress);
+    ASSERT_ARE_EQUAL(uint64_t, 11500, next_deadline_us);
+
+    g_current_us = 11500;
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_bytes_received(TEST_CONTEXT_1, IGNORED_PTR_ARG, 10))
+        .ValidateArgumentBuffer(2, "0123456789", 10);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    ASSERT_ARE_EQUAL(int, 0, memio_interface->concrete_io_dowork_ex(g_ios[1], &made_progress, &next_deadline_us));
+    ASSERT_IS_TRUE(made_progress);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_ios();
+}
+
+/* Tests_SRS_MEMIO_01_038: [ memio_dowork shall do the work of memio_dowork_ex. ]*/
+TEST_FUNCTION(memio_dowork_completes_the_sends)
+{
+    // arrange
+    create_open_ios(NULL, NULL);
+    send_bytes(1, "abc", 3);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_on_send_complete(TEST_SEND_CONTEXT, IO_SEND_OK));
+
+    // act
+    memio_interface->concrete_io_dowork(g_ios[1]);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_ios();
+}
+
+/* memio_close */
+
+/* Tests_SRS_MEMIO_01_016: [ If memio is NULL, memio_close shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(memio_close_with_NULL_fails)
+{
+    // act
+    int result = memio_interface->concrete_io_close(NULL, test_on_io_close_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_MEMIO_01_017: [ If the IO is closed, memio_close shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(memio_close_when_closed_fails)
+{
+    // arrange
+    int result;
+    create_ios(NULL, NULL);
+
+    // act
+    result = memio_interface->concrete_io_close(g_ios[0], test_on_io_close_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_ios();
+}
+
+/* Tests_SRS_MEMIO_01_018: [ memio_close shall complete with IO_SEND_OK the sends whose bytes have left, in order. ]*/
+/* Tests_SRS_MEMIO_01_019: [ memio_close shall complete with IO_SEND_CANCELLED the sends whose bytes have not left, and drop their bytes. ]*/
+/* Tests_SRS_MEMIO_01_022: [ memio_close shall then call on_io_close_complete, if it is not NULL, and return 0. ]*/
+TEST_FUNCTION(memio_close_completes_the_sends_that_left_and_cancels_the_others)
+{
+    // arrange
+    /* 10 bytes take 10000 us to leave */
+    MEMIO_LINK_CONFIG link_config = { 0, 1000, 0, 0 };
+    int result;
+    create_open_ios(&link_config, NULL);
+    send_bytes(0, "0123456789", 10);
+    send_bytes(0, "0123456789", 10);
+    g_current_us = 10000;
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_send_complete(TEST_SEND_CONTEXT, IO_SEND_OK));
+    STRICT_EXPECTED_CALL(test_on_send_complete(TEST_SEND_CONTEXT, IO_SEND_CANCELLED));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_io_close_complete(TEST_CONTEXT_0));
+
+    // act
+    result = memio_interface->concrete_io_close(g_ios[0], test_on_io_close_complete, TEST_CONTEXT_0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_ios();
+}
+
+/* Tests_SRS_MEMIO_01_020: [ memio_close shall drop the bytes that wait to be indicated to the IO. ]*/
+TEST_FUNCTION(memio_close_drops_the_bytes_waiting_for_the_io)
+{
+    // arrange
+    create_open_ios(NULL, NULL);
+    send_bytes(0, "abc", 3);
+    memio_interface->concrete_io_dowork(g_ios[0]);
+    ASSERT_ARE_EQUAL(int, 0, memio_interface->concrete_io_close(g_ios[1], NULL, NULL));
+    open_io(1);
+
+    // act
+    memio_interface->concrete_io_dowork(g_ios[1]);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_ios();
+}
+
+/* Tests_SRS_MEMIO_01_021: [ If the IO of the other side is open, it shall indicate an error once the bytes already sent to it were indicated. ]*/
+/* Tests_SRS_MEMIO_01_035: [ When the other side closed and all the bytes it sent were indicated, memio_dowork_ex shall call on_io_error once. ]*/
+TEST_FUNCTION(the_other_side_gets_an_error_once_the_bytes_sent_before_the_close_are_indicated)
+{
+    // arrange
+    create_open_ios(NULL, NULL);
+    send_bytes(0, "abc", 3);
+    ASSERT_ARE_EQUAL(int, 0, memio_interface->concrete_io_close(g_ios[0], NULL, NULL));
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(test_on_bytes_received(TEST_CONTEXT_1, IGNORED_PTR_ARG, 3))
+        .ValidateArgumentBuffer(2, "abc", 3);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_io_error(TEST_CONTEXT_1));
+
+    // act
+    memio_interface->concrete_io_dowork(g_ios[1]);
+    memio_interface->concrete_io_dowork(g_ios[1]);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, memio_interface->concrete_io_send(g_ios[1], "a", 1, NULL, NULL));
+
+    // cleanup
+    destroy_ios();
+}
+
+/* memio_get_stats */
+
+/* Tests_SRS_MEMIO_01_039: [ memio_get_stats shall fill the first entry of stats with the counters of the IO, the bottom layer of the stack. ]*/
+TEST_FUNCTION(memio_get_stats_gives_the_counters_of_the_io)
+{
+    // arrange
+    XIO_STATS stats[2];
+    size_t layer_count;
+    int result;
+    create_open_ios(NULL, NULL);
+    send_bytes(0, "abc", 3);
+    umock_c_reset_all_calls();
+
+    // act
+    result = memio_interface->concrete_io_get_stats(g_ios[0], stats, 2, &layer_count);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, layer_count);
+    ASSERT_ARE_EQUAL(char_ptr, "memio", stats[0].layer_name);
+    ASSERT_ARE_EQUAL(uint64_t, 3, stats[0].bytes_sent);
+    ASSERT_ARE_EQUAL(uint64_t, 1, stats[0].send_count);
+    ASSERT_ARE_EQUAL(uint64_t, 1, stats[0].pending_send_count);
+
+    // cleanup
+    destroy_ios();
+}
+
+/* memio_setoption */
+
+/* Tests_SRS_MEMIO_01_040: [ memio_setoption shall fail and return a non-zero value, the IO has no option. ]*/
+TEST_FUNCTION(memio_setoption_fails)
+{
+    // arrange
+    int result;
+    create_ios(NULL, NULL);
+
+    // act
+    result = memio_interface->concrete_io_setoption(g_ios[0], "option", "value");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    destroy_ios();
+}
+
+/* memio_retrieveoptions */
+
+/* Tests_SRS_MEMIO_01_041: [ memio_retrieveoptions shall return an empty option handler created with OptionHandler_Create. ]*/
+TEST_FUNCTION(memio_retrieveoptions_creates_an_empty_option_handler)
+{
+    // arrange
+    OPTIONHANDLER_HANDLE result;
+    create_ios(NULL, NULL);
+    STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = memio_interface->concrete_io_retrieveoptions(g_ios[0]);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTION_HANDLER, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    destroy_ios();
+}
+
+/* memio_get_interface_description */
+
+/* Tests_SRS_MEMIO_01_042: [ memio_get_interface_description shall return a pointer to an IO_INTERFACE_DESCRIPTION structure that contains pointers to the functions of the memio. ]*/
+TEST_FUNCTION(memio_get_interface_description_returns_the_functions)
+{
+    // act
+    const IO_INTERFACE_DESCRIPTION* result = memio_get_interface_description();
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_NOT_NULL(result->concrete_io_sendv);
+    ASSERT_IS_NOT_NULL(result->concrete_io_dowork_ex);
+    ASSERT_IS_NULL(result->concrete_io_get_pollable_handle);
+}
+
+END_TEST_SUITE(memio_unittests)
@@ -633,4 +633,171 @@ TEST_FUNCTION(read_uuid_t_succeeds_2)
     ASSERT_ARE_EQUAL(int, 0, memcmp(source, destination, sizeof(UUID_T)));
 }
 
+/* read_uint16_array */
+
+/*Tests_SRS_MEMORY_DATA_01_001: [ read_uint16_array shall write in destination[i] the 2 bytes at source + 2 * i MSB first, for each i less than count. ]*/
+TEST_FUNCTION(read_uint16_array_succeeds)
+{
+    ///arrange
+    unsigned char source[2 * 19];
+    uint16_t destination[19];
+    size_t i;
+    for (i = 0; i < sizeof(source); i++)
+    {
+        source[i] = (unsigned char)(i * 7 + 1);
+    }
+
+    ///act
+    read_uint16_array(source, destination, 19);
+
+    ///assert
+    for (i = 0; i < 19; i++)
+    {
+        ASSERT_ARE_EQUAL(uint16_t, (uint16_t)((source[2 * i] << 8) + source[2 * i + 1]), destination[i]);
+    }
+}
+
+/*Tests_SRS_MEMORY_DATA_01_001: [ read_uint16_array shall write in destination[i] the 2 bytes at source + 2 * i MSB first, for each i less than count. ]*/
+TEST_FUNCTION(read_uint16_array_with_count_0_writes_nothing)
+{
+    ///arrange
+    unsigned char source[2] = { 0x1, 0x2 };
+    uint16_t destination = 0x4242;
+
+    ///act
+    read_uint16_array(source, &destination, 0);
+
+    ///assert
+    ASSERT_ARE_EQUAL(uint16_t, 0x4242, destination);
+}
+
+/* read_uint32_array */
+
+/*Tests_SRS_MEMORY_DATA_01_002: [ read_uint32_array shall write in destination[i] the 4 bytes at source + 4 * i MSB first, for each i less than count. ]*/
+TEST_FUNCTION(read_uint32_array_succeeds)
+{
+    ///arrange
+    unsigned char source[4 * 11];
+    uint32_t destination[11];
+    size_t i;
+    for (i = 0; i < sizeof(source); i++)
+    {
+        source[i] = (unsigned char)(i * 7 + 1);
+    }
+
+    ///act
+    read_uint32_array(source, destination, 11);
+
+    ///assert
+    for (i = 0; i < 11; i++)
+    {
+        uint32_t expected;
+        read_uint32_t(source + 4 * i, &expected);
+        ASSERT_ARE_EQUAL(uint32_t, expected, destination[i]);
+    }
+}
+
+/* read_uint64_array */
+
+/*Tests_SRS_MEMORY_DATA_01_003: [ read_uint64_array shall write in destination[i] the 8 bytes at source + 8 * i MSB first, for each i less than count. ]*/
+TEST_FUNCTION(read_uint64_array_succeeds)
+{
+    ///arrange
+    unsigned char source[8 * 5];
+    uint64_t destination[5];
+    size_t i;
+    for (i = 0; i < sizeof(source); i++)
+    {
+        source[i] = (unsigned char)(i * 7 + 1);
+    }
+
+    ///act
+    read_uint64_array(source, destination, 5);
+
+    ///assert
+    for (i = 0; i < 5; i++)
+    {
+        uint64_t expected;
+        read_uint64_t(source + 8 * i, &expected);
+        ASSERT_ARE_EQUAL(uint64_t, expected, destination[i]);
+    }
+}
+
+/* write_uint16_array */
+
+/*Tests_SRS_MEMORY_DATA_01_004: [ write_uint16_array shall write at destination + 2 * i the bytes of source[i] MSB first, for each i less than count. ]*/
+TEST_FUNCTION(write_uint16_array_succeeds)
+{
+    ///arrange
+    uint16_t source[19];
+    unsigned char destination[2 * 19];
+    size_t i;
+    for (i = 0; i < 19; i++)
+    {
+        source[i] = (uint16_t)(i * 0x0F0F + 0x0102);
+    }
+
+    ///act
+    write_uint16_array(destination, source, 19);
+
+    ///assert
+    for (i = 0; i < 19; i++)
+    {
+        ASSERT_ARE_EQUAL(uint8_t, (uint8_t)(source[i] >> 8), destination[2 * i]);
+        ASSERT_ARE_EQUAL(uint8_t, (uint8_t)source[i], destination[2 * i + 1]);
+    }
+}
+
+/* write_uint32_array */
+
+/*Tests_SRS_MEMORY_DATA_01_005: [ write_uint32_array shall write at destination + 4 * i the bytes of source[i] MSB first, for each i less than count. ]*/
+TEST_FUNCTION(write_uint32_array_succeeds)
+{
+    ///arrange
+    uint32_t source[11];
+    unsigned char destination[4 * 11];
+    unsigned char expected[4];
+    size_t i;
+    for (i = 0; i < 11; i++)
+    {
+        source[i] = (uint32_t)(i * 0x0F0F0F0F + 0x01020304);
+    }
+
+    ///act
+    write_uint32_array(destination, source, 11);
+
+    ///assert
+    for (i = 0; i < 11; i++)
+    {
+        write_uint32_t(expected, source[i]);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(expected, destination + 4 * i, sizeof(expected)));
+    }
+}
+
+/* write_uint64_array */
+
+/*Tests_SRS_MEMORY_DATA_01_006: [ write_uint64_array shall write at destination + 8 * i the bytes of source[i] MSB first, for each i less than count. ]*/
+TEST_FUNCTION(write_uint64_array_succeeds)
+{
+    ///arrange
+    uint64_t source[5];
+    unsigned char destination[8 * 5];
+    unsigned char expected[8];
+    size_t i;
+    for (i = 0; i < 5; i++)
+    {
+        source[i] = (uint64_t)i * 0x0F0F0F0F0F0F0F0FULL + 0x0102030405060708ULL;
+    }
+
+    ///act
+    write_uint64_array(destination, source, 5);
+
+    ///assert
+    for (i = 0; i < 5; i++)
+    {
+        write_uint64_t(expected, source[i]);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(expected, destination + 8 * i, sizeof(expected)));
+    }
+}
+
 END_TEST_SUITE(memory_data_ut)
@@ -0,0 +1,692 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdbool.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_calloc(size_t nmemb, size_t size)
+{
+    return calloc(nmemb, size);
+}
+
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#include "macro_utils.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/xio.h"
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/metrics.h"
+
+static const LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4243;
+static const XIO_HANDLE TEST_XIO_HANDLE = (XIO_HANDLE)0x4244;
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+static int my_xio_get_stats(XIO_HANDLE xio, XIO_STATS* stats, size_t stats_count, size_t* layer_count)
+{
+    (void)xio;
+    ASSERT_IS_TRUE(stats_count >= 2);
+    (void)memset(stats, 0, 2 * sizeof(XIO_STATS));
+    stats[0].layer_name = "tlsio";
+    stats[0].bytes_sent = 42;
+    stats[1].layer_name = "socketio";
+    stats[1].bytes_sent = 64;
+    *layer_count = 2;
+    return 0;
+}
+
+static void init_metrics(void)
+{
+    ASSERT_ARE_EQUAL(int, 0, metrics_init());
+    umock_c_reset_all_calls();
+}
+
+BEGIN_TEST_SUITE(metrics_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result, "umock_c_init");
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_charptr_register_types");
+
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_stdint_register_types");
+
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_RESULT, int);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_STATS*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(GBALLOC_STATISTICS*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(size_t*, void*);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_calloc, my_gballoc_calloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_calloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_realloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock_Init, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock, LOCK_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+
+    REGISTER_GLOBAL_MOCK_HOOK(xio_get_stats, my_xio_get_stats);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(xio_get_stats, __LINE__);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/* metrics_init */
+
+/* Tests_SRS_METRICS_01_001: [ metrics_init shall create the lock of the registry. ]*/
+/* Tests_SRS_METRICS_01_004: [ On success, metrics_init shall return 0. ]*/
+TEST_FUNCTION(metrics_init_succeeds)
+{
+    // arrange
+    int result;
+    STRICT_EXPECTED_CALL(Lock_Init());
+
+    // act
+    result = metrics_init();
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    metrics_deinit();
+}
+
+/* Tests_SRS_METRICS_01_002: [ If the registry is already initialized, metrics_init shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(metrics_init_twice_fails)
+{
+    // arrange
+    int result;
+    init_metrics();
+
+    // act
+    result = metrics_init();
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    metrics_deinit();
+}
+
+/* Tests_SRS_METRICS_01_003: [ If creating the lock fails, metrics_init shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_creating_the_lock_fails_metrics_init_fails)
+{
+    // arrange
+    int result;
+    STRICT_EXPECTED_CALL(Lock_Init())
+        .SetReturn(NULL);
+
+    // act
+    result = metrics_init();
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(metrics_counter_create("sends"));
+}
+
+/* metrics_deinit */
+
+/* Tests_SRS_METRICS_01_005: [ metrics_deinit shall free the registry and its lock, the counters left in it staying usable until destroyed. ]*/
+TEST_FUNCTION(metrics_deinit_frees_the_lock)
+{
+    // arrange
+    init_metrics();
+    STRICT_EXPECTED_CALL(gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+
+    // act
+    metrics_deinit();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* metrics_counter_create */
+
+/* Tests_SRS_METRICS_01_006: [ If name is NULL, metrics_counter_create shall fail and return NULL. ]*/
+TEST_FUNCTION(metrics_counter_create_with_NULL_name_fails)
+{
+    // arrange
+    METRICS_COUNTER_HANDLE counter;
+    init_metrics();
+
+    // act
+    counter = metrics_counter_create(NULL);
+
+    // assert
+    ASSERT_IS_NULL(counter);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    metrics_deinit();
+}
+
+/* Tests_SRS_METRICS_01_007: [ If the registry is not initialized, metrics_counter_create shall fail and return NULL. ]*/
+TEST_FUNCTION(metrics_counter_create_without_init_fails)
+{
+    // arrange
+    METRICS_COUNTER_HANDLE counter;
+
+    // act
+    counter = metrics_counter_create("sends");
+
+    // assert
+    ASSERT_IS_NULL(counter);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_METRICS_01_009: [ metrics_counter_create shall allocate METRICS_COUNTER_SLOT_COUNT zeroed slots, each on its own cache line, and copy name. ]*/
+/* Tests_SRS_METRICS_01_010: [ metrics_counter_create shall add the counter to the registry under its lock. ]*/
+TEST_FUNCTION(metrics_counter_create_succeeds)
+{
+    // arrange
+    METRICS_COUNTER_HANDLE counter;
+    init_metrics();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_calloc(1, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(6));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, sizeof(METRICS_COUNTER_HANDLE)));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    counter = metrics_counter_create("sends");
+
+    // assert
+    ASSERT_IS_NOT_NULL(counter);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(uint64_t, 0, metrics_counter_get(counter));
+
+    // cleanup
+    metrics_counter_destroy(counter);
+    metrics_deinit();
+}
+
+/* Tests_SRS_METRICS_01_008: [ If any allocation fails, metrics_counter_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_slots_fails_metrics_counter_create_fails)
+{
+    // arrange
+    METRICS_COUNTER_HANDLE counter;
+    init_metrics();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_calloc(1, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    counter = metrics_counter_create("sends");
+
+    // assert
+    ASSERT_IS_NULL(counter);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    metrics_deinit();
+}
+
+/* Tests_SRS_METRICS_01_011: [ If locking or growing the registry fails, metrics_counter_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_locking_the_registry_fails_metrics_counter_create_fails)
+{
+    // arrange
+    METRICS_COUNTER_HANDLE counter;
+    init_metrics();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_calloc(1, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(6));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE))
+        .SetReturn(LOCK_ERROR);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    counter = metrics_counter_create("sends");
+
+    // assert
+    ASSERT_IS_NULL(counter);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    metrics_deinit();
+}
+
+/* metrics_counter_add */
+
+/* Tests_SRS_METRICS_01_014: [ metrics_counter_add shall atomically add value to the slot of the calling thread, picked round robin the first time the thread adds to a counter. ]*/
+/* Tests_SRS_METRICS_01_016: [ metrics_counter_get shall return the sum of the slots of the counter. ]*/
+TEST_FUNCTION(metrics_counter_add_adds_to_the_counter)
+{
+    // arrange
+    METRICS_COUNTER_HANDLE counter;
+    init_metrics();
+    counter = metrics_counter_create("sends");
+    umock_c_reset_all_calls();
+
+    // act
+    metrics_counter_add(counter, 2);
+    metrics_counter_add(counter, 40);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(uint64_t, 42, metrics_counter_get(counter));
+
+    // cleanup
+    metrics_counter_destroy(counter);
+    metrics_deinit();
+}
+
+/* Tests_SRS_METRICS_01_015: [ If counter is NULL, metrics_counter_get shall return 0. ]*/
+TEST_FUNCTION(metrics_counter_get_with_NULL_counter_returns_0)
+{
+    // arrange
+    uint64_t result;
+
+    // act
+    result = metrics_counter_get(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, 0, result);
+}
+
+/* metrics_counter_destroy */
+
+/* Tests_SRS_METRICS_01_013: [ metrics_counter_destroy shall remove the counter from the registry under its lock and free it. ]*/
+TEST_FUNCTION(metrics_counter_destroy_removes_the_counter)
+{
+    // arrange
+    METRICS_COUNTER_HANDLE counter;
+    METRICS_SNAPSHOT* snapshot;
+    init_metrics();
+    counter = metrics_counter_create("sends");
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(counter));
+
+    // act
+    metrics_counter_destroy(counter);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    snapshot = metrics_snapshot_create();
+    ASSERT_IS_NOT_NULL(snapshot);
+    ASSERT_ARE_EQUAL(size_t, 0, snapshot->counter_count);
+
+    // cleanup
+    metrics_snapshot_destroy(snapshot);
+    metrics_deinit();
+}
+
+/* metrics_add_xio */
+
+/* Tests_SRS_METRICS_01_017: [ If xio or name is NULL, metrics_add_xio shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(metrics_add_xio_with_NULL_xio_fails)
+{
+    // arrange
+    int result;
+    init_metrics();
+
+    // act
+    result = metrics_add_xio(NULL, "client");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    metrics_deinit();
+}
+
+/* Tests_SRS_METRICS_01_018: [ If the registry is not initialized, metrics_add_xio shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(metrics_add_xio_without_init_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = metrics_add_xio(TEST_XIO_HANDLE, "client");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_METRICS_01_020: [ metrics_add_xio shall add xio and a copy of name to the registry under its lock. ]*/
+/* Tests_SRS_METRICS_01_021: [ On success, metrics_add_xio shall return 0. ]*/
+TEST_FUNCTION(metrics_add_xio_succeeds)
+{
+    // arrange
+    int result;
+    init_metrics();
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(7));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = metrics_add_xio(TEST_XIO_HANDLE, "client");
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    metrics_remove_xio(TEST_XIO_HANDLE);
+    metrics_deinit();
+}
+
+/* Tests_SRS_METRICS_01_019: [ If locking, growing the registry or copying name fails, metrics_add_xio shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_growing_the_registry_fails_metrics_add_xio_fails)
+{
+    // arrange
+    int result;
+    init_metrics();
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = metrics_add_xio(TEST_XIO_HANDLE, "client");
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    metrics_deinit();
+}
+
+/* metrics_snapshot_create */
+
+/* Tests_SRS_METRICS_01_024: [ If the registry is not initialized, metrics_snapshot_create shall fail and return NULL. ]*/
+TEST_FUNCTION(metrics_snapshot_create_without_init_fails)
+{
+    // arrange
+    METRICS_SNAPSHOT* snapshot;
+
+    // act
+    snapshot = metrics_snapshot_create();
+
+    // assert
+    ASSERT_IS_NULL(snapshot);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_METRICS_01_028: [ metrics_snapshot_create shall copy the name and the value of each counter of the registry. ]*/
+/* Tests_SRS_METRICS_01_029: [ metrics_snapshot_create shall read up to METRICS_MAX_XIO_LAYERS layers of each IO stack of the registry with xio_get_stats, leaving out the stacks for which it fails. ]*/
+TEST_FUNCTION(metrics_snapshot_create_collects_the_counters_and_the_io_layers)
+{
+    // arrange
+    METRICS_SNAPSHOT* snapshot;
+    METRICS_COUNTER_HANDLE counter;
+    init_metrics();
+    counter = metrics_counter_create("sends");
+    metrics_counter_add(counter, 3);
+    (void)metrics_add_xio(TEST_XIO_HANDLE, "client");
+    umock_c_reset_all_calls();
+
+    // act
+    snapshot = metrics_snapshot_create();
+
+    // assert
+    ASSERT_IS_NOT_NULL(snapshot);
+    ASSERT_ARE_EQUAL(size_t, 1, snapshot->counter_count);
+    ASSERT_ARE_EQUAL(char_ptr, "sends", snapshot->counters[0].name);
+    ASSERT_ARE_EQUAL(uint64_t, 3, snapshot->counters[0].value);
+    ASSERT_ARE_EQUAL(size_t, 2, snapshot->xio_layer_count);
+    ASSERT_ARE_EQUAL(char_ptr, "client", snapshot->xio_layers[0].io_name);
+    ASSERT_ARE_EQUAL(char_ptr, "tlsio", snapshot->xio_layers[0].stats.layer_name);
+    ASSERT_ARE_EQUAL(uint64_t, 42, snapshot->xio_layers[0].stats.bytes_sent);
+    ASSERT_ARE_EQUAL(char_ptr, "client", snapshot->xio_layers[1].io_name);
+    ASSERT_ARE_EQUAL(uint64_t, 64, snapshot->xio_layers[1].stats.bytes_sent);
+
+    // cleanup
+    metrics_snapshot_destroy(snapshot);
+    metrics_remove_xio(TEST_XIO_HANDLE);
+    metrics_counter_destroy(counter);
+    metrics_deinit();
+}
+
+/* Tests_SRS_METRICS_01_029: [ metrics_snapshot_create shall read up to METRICS_MAX_XIO_LAYERS layers of each IO stack of the registry with xio_get_stats, leaving out the stacks for which it fails. ]*/
+TEST_FUNCTION(metrics_snapshot_create_leaves_out_the_io_stacks_it_cannot_read)
+{
+    // arrange
+    METRICS_SNAPSHOT* snapshot;
+    init_metrics();
+    (void)metrics_add_xio(TEST_XIO_HANDLE, "client");
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(gballoc_calloc(1, sizeof(METRICS_SNAPSHOT)));
+    STRICT_EXPECTED_CALL(gballoc_getStatistics(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_getCurrentMemoryUsed());
+    STRICT_EXPECTED_CALL(gballoc_getMaximumMemoryUsed());
+    STRICT_EXPECTED_CALL(gballoc_getAllocationCount());
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_calloc(METRICS_MAX_XIO_LAYERS, sizeof(METRICS_XIO_LAYER)));
+    STRICT_EXPECTED_CALL(xio_get_stats(TEST_XIO_HANDLE, IGNORED_PTR_ARG, METRICS_MAX_XIO_LAYERS, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    snapshot = metrics_snapshot_create();
+
+    // assert
+    ASSERT_IS_NOT_NULL(snapshot);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, snapshot->xio_layer_count);
+
+    // cleanup
+    metrics_snapshot_destroy(snapshot);
+    metrics_remove_xio(TEST_XIO_HANDLE);
+    metrics_deinit();
+}
+
+/* Tests_SRS_METRICS_01_025: [ If any allocation or locking the registry fails, metrics_snapshot_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_locking_the_registry_fails_metrics_snapshot_create_fails)
+{
+    // arrange
+    METRICS_SNAPSHOT* snapshot;
+    init_metrics();
+    STRICT_EXPECTED_CALL(gballoc_calloc(1, sizeof(METRICS_SNAPSHOT)));
+    STRICT_EXPECTED_CALL(gballoc_getStatistics(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_getCurrentMemoryUsed());
+    STRICT_EXPECTED_CALL(gballoc_getMaximumMemoryUsed());
+    STRICT_EXPECTED_CALL(gballoc_getAllocationCount());
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE))
+        .SetReturn(LOCK_ERROR);
+    STRICT_EXPECTED_CALL(gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    snapshot = metrics_snapshot_create();
+
+    // assert
+    ASSERT_IS_NULL(snapshot);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    metrics_deinit();
+}
+
+/* metrics_snapshot_format */
+
+/* Tests_SRS_METRICS_01_032: [ If snapshot is NULL or format is unknown, metrics_snapshot_format shall fail and return NULL. ]*/
+TEST_FUNCTION(metrics_snapshot_format_with_NULL_snapshot_fails)
+{
+    // arrange
+    STRING_HANDLE text;
+
+    // act
+    text = metrics_snapshot_format(NULL, METRICS_FORMAT_JSON);
+
+    // assert
+    ASSERT_IS_NULL(text);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_METRICS_01_033: [ With METRICS_FORMAT_PROMETHEUS, metrics_snapshot_format shall write one TYPE line per metric followed by its samples, the names prefixed by aziotsharedutil_, the IO layers labelled with io, layer and depth and the counters with name. ]*/
+TEST_FUNCTION(metrics_snapshot_format_writes_prometheus_text)
+{
+    // arrange
+    METRICS_SNAPSHOT snapshot;
+    METRICS_COUNTER_VALUE counter = { "say \"hi\"", 3 };
+    STRING_HANDLE text;
+    (void)memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.counters = &counter;
+    snapshot.counter_count = 1;
+
+    // act
+    text = metrics_snapshot_format(&snapshot, METRICS_FORMAT_PROMETHEUS);
+
+    // assert
+    ASSERT_IS_NOT_NULL(text);
+    ASSERT_ARE_EQUAL(char_ptr,
+        "# TYPE aziotsharedutil_counter_total counter\n"
+        "aziotsharedutil_counter_total{name=\"say \\\"hi\\\"\"} 3\n",
+        STRING_c_str(text));
+
+    // cleanup
+    STRING_delete(text);
+}
+
+/* Tests_SRS_METRICS_01_033: [ With METRICS_FORMAT_PROMETHEUS, metrics_snapshot_format shall write one TYPE line per metric followed by its samples, the names prefixed by aziotsharedutil_, the IO layers labelled with io, layer and depth and the counters with name. ]*/
+TEST_FUNCTION(metrics_snapshot_format_labels_the_io_layers_with_their_depth)
+{
+    // arrange
+    METRICS_SNAPSHOT snapshot;
+    METRICS_XIO_LAYER layers[2];
+    const char* io_name = "client";
+    STRING_HANDLE text;
+    (void)memset(&snapshot, 0, sizeof(snapshot));
+    (void)memset(layers, 0, sizeof(layers));
+    layers[0].io_name = io_name;
+    layers[0].stats.layer_name = "tlsio";
+    layers[0].stats.bytes_sent = 42;
+    layers[1].io_name = io_name;
+    layers[1].stats.layer_name = "socketio";
+    layers[1].stats.bytes_sent = 64;
+    snapshot.xio_layers = layers;
+    snapshot.xio_layer_count = 2;
+
+    // act
+    text = metrics_snapshot_format(&snapshot, METRICS_FORMAT_PROMETHEUS);
+
+    // assert
+    ASSERT_IS_NOT_NULL(text);
+    ASSERT_IS_NOT_NULL(strstr(STRING_c_str(text),
+        "# TYPE aziotsharedutil_xio_bytes_sent_total counter\n"
+        "aziotsharedutil_xio_bytes_sent_total{io=\"client\",layer=\"tlsio\",depth=\"0\"} 42\n"
+        "aziotsharedutil_xio_bytes_sent_total{io=\"client\",layer=\"socketio\",depth=\"1\"} 64\n"));
+
+    // cleanup
+    STRING_delete(text);
+}
+
+/* Tests_SRS_METRICS_01_034: [ With METRICS_FORMAT_JSON, metrics_snapshot_format shall write one object with the memory and lock values, an xio array with one object per layer and a counters object. ]*/
+TEST_FUNCTION(metrics_snapshot_format_writes_json)
+{
+    // arrange
+    METRICS_SNAPSHOT snapshot;
+    METRICS_COUNTER_VALUE counter = { "sends", 3 };
+    STRING_HANDLE text;
+    (void)memset(&snapshot, 0, sizeof(snapshot));
+    snapshot.has_locks = true;
+    snapshot.lock_count = 2;
+    snapshot.lock_acquisition_count = 10;
+    snapshot.counters = &counter;
+    snapshot.counter_count = 1;
+
+    // act
+    text = metrics_snapshot_format(&snapshot, METRICS_FORMAT_JSON);
+
+    // assert
+    ASSERT_IS_NOT_NULL(text);
+    ASSERT_ARE_EQUAL(char_ptr,
+        "{\"lock_count\":2,\"lock_acquisition_count\":10,\"lock_contended_count\":0,\"lock_total_wait_ns\":0,\"lock_max_wait_ns\":0,"
+        "\"xio\":[],\"counters\":{\"sends\":3}}",
+        STRING_c_str(text));
+
+    // cleanup
+    STRING_delete(text);
+}
+
+END_TEST_SUITE(metrics_unittests)
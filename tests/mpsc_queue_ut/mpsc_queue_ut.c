@@ -0,0 +1,302 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stddef.h>
+#include "azure_c_shared_utility/mpsc_queue.h"
+#include "testrunnerswitcher.h"
+
+typedef struct TEST_ITEM_TAG
+{
+    int index;
+    MPSC_QUEUE_ENTRY link;
+} TEST_ITEM;
+
+#define TEST_ITEM_FROM_ENTRY(entry) ((TEST_ITEM*)((unsigned char*)(entry) - offsetof(TEST_ITEM, link)))
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+BEGIN_TEST_SUITE(mpsc_queue_unittests)
+
+TEST_SUITE_INITIALIZE(TestClassInitialize)
+{
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+}
+
+TEST_SUITE_CLEANUP(TestClassCleanup)
+{
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* mpsc_queue_init */
+
+/* Tests_SRS_MPSC_QUEUE_01_001: [ If queue is NULL, mpsc_queue_init shall return. ]*/
+TEST_FUNCTION(mpsc_queue_init_with_NULL_queue_returns)
+{
+    // arrange
+
+    // act
+    mpsc_queue_init(NULL);
+
+    // assert
+    // no explicit assert, no crash
+}
+
+/* Tests_SRS_MPSC_QUEUE_01_002: [ mpsc_queue_init shall initialize queue as an empty queue. ]*/
+TEST_FUNCTION(mpsc_queue_init_initializes_an_empty_queue)
+{
+    // arrange
+    MPSC_QUEUE queue;
+
+    // act
+    mpsc_queue_init(&queue);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, mpsc_queue_is_empty(&queue));
+    ASSERT_IS_NULL(mpsc_queue_pop(&queue));
+}
+
+/* mpsc_queue_push */
+
+/* Tests_SRS_MPSC_QUEUE_01_003: [ If queue is NULL, mpsc_queue_push shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(mpsc_queue_push_with_NULL_queue_fails)
+{
+    // arrange
+    TEST_ITEM item = { 1, { NULL } };
+    int result;
+
+    // act
+    result = mpsc_queue_push(NULL, &item.link);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_MPSC_QUEUE_01_004: [ If entry is NULL, mpsc_queue_push shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(mpsc_queue_push_with_NULL_entry_fails)
+{
+    // arrange
+    MPSC_QUEUE queue;
+    int result;
+    mpsc_queue_init(&queue);
+
+    // act
+    result = mpsc_queue_push(&queue, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, mpsc_queue_is_empty(&queue));
+}
+
+/* Tests_SRS_MPSC_QUEUE_01_005: [ mpsc_queue_push shall add entry at the end of queue without taking any lock. ]*/
+/* Tests_SRS_MPSC_QUEUE_01_006: [ mpsc_queue_push shall succeed and return 0. ]*/
+TEST_FUNCTION(mpsc_queue_push_adds_the_entry_and_succeeds)
+{
+    // arrange
+    MPSC_QUEUE queue;
+    TEST_ITEM item = { 1, { NULL } };
+    int result;
+    mpsc_queue_init(&queue);
+
+    // act
+    result = mpsc_queue_push(&queue, &item.link);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, mpsc_queue_is_empty(&queue));
+}
+
+/* mpsc_queue_pop */
+
+/* Tests_SRS_MPSC_QUEUE_01_007: [ If queue is NULL, mpsc_queue_pop shall fail and return NULL. ]*/
+TEST_FUNCTION(mpsc_queue_pop_with_NULL_queue_fails)
+{
+    // arrange
+    MPSC_QUEUE_ENTRY* result;
+
+    // act
+    result = mpsc_queue_pop(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+}
+
+/* Tests_SRS_MPSC_QUEUE_01_008: [ If queue is empty, mpsc_queue_pop shall return NULL. ]*/
+TEST_FUNCTION(mpsc_queue_pop_on_an_empty_queue_returns_NULL)
+{
+    // arrange
+    MPSC_QUEUE queue;
+    MPSC_QUEUE_ENTRY* result;
+    mpsc_queue_init(&queue);
+
+    // act
+    result = mpsc_queue_pop(&queue);
+
+    // assert
+    ASSERT_IS_NULL(result);
+}
+
+/* Tests_SRS_MPSC_QUEUE_01_009: [ mpsc_queue_pop shall remove the entry at the front of queue and return it. ]*/
+TEST_FUNCTION(mpsc_queue_pop_with_one_entry_returns_it_and_empties_the_queue)
+{
+    // arrange
+    MPSC_QUEUE queue;
+    TEST_ITEM item = { 1, { NULL } };
+    MPSC_QUEUE_ENTRY* result;
+    mpsc_queue_init(&queue);
+    (void)mpsc_queue_push(&queue, &item.link);
+
+    // act
+    result = mpsc_queue_pop(&queue);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, &item.link, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, mpsc_queue_is_empty(&queue));
+    ASSERT_IS_NULL(mpsc_queue_pop(&queue));
+}
+
+/* Tests_SRS_MPSC_QUEUE_01_009: [ mpsc_queue_pop shall remove the entry at the front of queue and return it. ]*/
+TEST_FUNCTION(mpsc_queue_pop_returns_the_entries_in_the_order_they_were_pushed)
+{
+    // arrange
+    MPSC_QUEUE queue;
+    TEST_ITEM items[3] = { { 1, { NULL } }, { 2, { NULL } }, { 3, { NULL } } };
+    int i;
+    mpsc_queue_init(&queue);
+    for (i = 0; i < 3; i++)
+    {
+        (void)mpsc_queue_push(&queue, &items[i].link);
+    }
+
+    // act
+    // assert
+    for (i = 0; i < 3; i++)
+    {
+        MPSC_QUEUE_ENTRY* entry = mpsc_queue_pop(&queue);
+        ASSERT_IS_NOT_NULL(entry);
+        ASSERT_ARE_EQUAL(int, i + 1, TEST_ITEM_FROM_ENTRY(entry)->index);
+    }
+    ASSERT_IS_NULL(mpsc_queue_pop(&queue));
+}
+
+/* Tests_SRS_MPSC_QUEUE_01_009: [ mpsc_queue_pop shall remove the entry at the front of queue and return it. ]*/
+TEST_FUNCTION(mpsc_queue_pop_returns_an_entry_pushed_again_after_it_was_popped)
+{
+    // arrange
+    MPSC_QUEUE queue;
+    TEST_ITEM item1 = { 1, { NULL } };
+    TEST_ITEM item2 = { 2, { NULL } };
+    mpsc_queue_init(&queue);
+    (void)mpsc_queue_push(&queue, &item1.link);
+    (void)mpsc_queue_push(&queue, &item2.link);
+    (void)mpsc_queue_pop(&queue);
+
+    // act
+    (void)mpsc_queue_push(&queue, &item1.link);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, &item2.link, mpsc_queue_pop(&queue));
+    ASSERT_ARE_EQUAL(void_ptr, &item1.link, mpsc_queue_pop(&queue));
+    ASSERT_IS_NULL(mpsc_queue_pop(&queue));
+}
+
+/* Tests_SRS_MPSC_QUEUE_01_010: [ If the push of the entry following the front entry has not finished linking it, mpsc_queue_pop shall return NULL. ]*/
+TEST_FUNCTION(mpsc_queue_pop_while_the_next_push_is_not_linked_returns_NULL)
+{
+    // arrange
+    MPSC_QUEUE queue;
+    TEST_ITEM item1 = { 1, { NULL } };
+    TEST_ITEM item2 = { 2, { NULL } };
+    MPSC_QUEUE_ENTRY* result;
+    mpsc_queue_init(&queue);
+    (void)mpsc_queue_push(&queue, &item1.link);
+
+    // a push of item2 that has swapped the head but not linked item1 to it yet
+    item2.link.next = NULL;
+    queue.head = &item2.link;
+
+    // act
+    result = mpsc_queue_pop(&queue);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0, mpsc_queue_is_empty(&queue));
+
+    // once linked both entries come out
+    item1.link.next = &item2.link;
+    ASSERT_ARE_EQUAL(void_ptr, &item1.link, mpsc_queue_pop(&queue));
+    ASSERT_ARE_EQUAL(void_ptr, &item2.link, mpsc_queue_pop(&queue));
+    ASSERT_IS_NULL(mpsc_queue_pop(&queue));
+}
+
+/* mpsc_queue_is_empty */
+
+/* Tests_SRS_MPSC_QUEUE_01_011: [ If queue is NULL, mpsc_queue_is_empty shall return a non-zero value. ]*/
+TEST_FUNCTION(mpsc_queue_is_empty_with_NULL_queue_returns_non_zero)
+{
+    // arrange
+    int result;
+
+    // act
+    result = mpsc_queue_is_empty(NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_MPSC_QUEUE_01_012: [ mpsc_queue_is_empty shall return a non-zero value if no entry was pushed that was not popped yet, including entries whose push has not finished, and 0 otherwise. ]*/
+TEST_FUNCTION(mpsc_queue_is_empty_counts_a_push_that_has_not_linked_its_entry)
+{
+    // arrange
+    MPSC_QUEUE queue;
+    TEST_ITEM item = { 1, { NULL } };
+    int result;
+    mpsc_queue_init(&queue);
+
+    // a push that has swapped the head but not linked the stub to the entry yet
+    item.link.next = NULL;
+    queue.head = &item.link;
+
+    // act
+    result = mpsc_queue_is_empty(&queue);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(mpsc_queue_pop(&queue));
+}
+
+/* Tests_SRS_MPSC_QUEUE_01_012: [ mpsc_queue_is_empty shall return a non-zero value if no entry was pushed that was not popped yet, including entries whose push has not finished, and 0 otherwise. ]*/
+TEST_FUNCTION(mpsc_queue_is_empty_after_all_entries_are_popped_returns_non_zero)
+{
+    // arrange
+    MPSC_QUEUE queue;
+    TEST_ITEM item1 = { 1, { NULL } };
+    TEST_ITEM item2 = { 2, { NULL } };
+    int result;
+    mpsc_queue_init(&queue);
+    (void)mpsc_queue_push(&queue, &item1.link);
+    (void)mpsc_queue_push(&queue, &item2.link);
+    (void)mpsc_queue_pop(&queue);
+    (void)mpsc_queue_pop(&queue);
+
+    // act
+    result = mpsc_queue_is_empty(&queue);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+END_TEST_SUITE(mpsc_queue_unittests)
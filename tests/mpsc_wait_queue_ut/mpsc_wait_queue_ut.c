@@ -0,0 +1,686 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#include "macro_utils.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+
+/* the wait queue is tested together with the real mpsc_queue */
+#include "azure_c_shared_utility/mpsc_queue.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/mpsc_wait_queue.h"
+
+IMPLEMENT_UMOCK_C_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(COND_RESULT, COND_RESULT_VALUES);
+
+static const LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4242;
+static const COND_HANDLE TEST_COND_HANDLE = (COND_HANDLE)0x4243;
+
+typedef enum TEST_CONDITION_WAIT_ACTION_TAG
+{
+    TEST_CONDITION_WAIT_TIMES_OUT,
+    TEST_CONDITION_WAIT_PUSHES,
+    TEST_CONDITION_WAIT_WAKES
+} TEST_CONDITION_WAIT_ACTION;
+
+/* what a producer does while the consumer waits in Condition_Wait */
+static TEST_CONDITION_WAIT_ACTION g_condition_wait_action;
+static MPSC_WAIT_QUEUE_HANDLE g_waited_queue;
+static MPSC_QUEUE_ENTRY g_pushed_entry;
+static int g_producer_result;
+
+static COND_RESULT my_Condition_Wait(COND_HANDLE handle, LOCK_HANDLE lock, int timeout_milliseconds)
+{
+    COND_RESULT result;
+
+    (void)handle;
+    (void)lock;
+    (void)timeout_milliseconds;
+
+    switch (g_condition_wait_action)
+    {
+    default:
+    case TEST_CONDITION_WAIT_TIMES_OUT:
+        result = COND_TIMEOUT;
+        break;
+    case TEST_CONDITION_WAIT_PUSHES:
+        g_producer_result = mpsc_wait_queue_push(g_waited_queue, &g_pushed_entry);
+        result = COND_OK;
+        break;
+    case TEST_CONDITION_WAIT_WAKES:
+        g_producer_result = mpsc_wait_queue_wake(g_waited_queue);
+        result = COND_OK;
+        break;
+    }
+
+    return result;
+}
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+static MPSC_WAIT_QUEUE_HANDLE create_queue(void)
+{
+    MPSC_WAIT_QUEUE_HANDLE result = mpsc_wait_queue_create();
+    ASSERT_IS_NOT_NULL(result);
+    umock_c_reset_all_calls();
+    return result;
+}
+
+static void setup_wait_expectations(int timeout_milliseconds)
+{
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, TEST_LOCK_HANDLE, timeout_milliseconds));
+}
+
+static void setup_post_expectations(void)
+{
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+}
+
+BEGIN_TEST_SUITE(mpsc_wait_queue_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result, "umock_c_init");
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_charptr_register_types");
+
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(COND_HANDLE, void*);
+    REGISTER_TYPE(LOCK_RESULT, LOCK_RESULT);
+    REGISTER_TYPE(COND_RESULT, COND_RESULT);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Init, TEST_COND_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Post, COND_OK);
+    REGISTER_GLOBAL_MOCK_HOOK(Condition_Wait, my_Condition_Wait);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    g_condition_wait_action = TEST_CONDITION_WAIT_TIMES_OUT;
+    g_waited_queue = NULL;
+    g_producer_result = -1;
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/* mpsc_wait_queue_create */
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_001: [ mpsc_wait_queue_create shall allocate memory for a new queue. ]*/
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_002: [ mpsc_wait_queue_create shall create a lock and a condition. ]*/
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_003: [ mpsc_wait_queue_create shall initialize the queue as empty. ]*/
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_004: [ mpsc_wait_queue_create shall succeed and return a non-NULL value. ]*/
+TEST_FUNCTION(mpsc_wait_queue_create_succeeds)
+{
+    // arrange
+    MPSC_WAIT_QUEUE_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init());
+
+    // act
+    result = mpsc_wait_queue_create();
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NULL(mpsc_wait_queue_try_pop(result));
+
+    // cleanup
+    mpsc_wait_queue_destroy(result);
+}
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_005: [ If any failure occurs, mpsc_wait_queue_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_memory_fails_mpsc_wait_queue_create_fails)
+{
+    // arrange
+    MPSC_WAIT_QUEUE_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = mpsc_wait_queue_create();
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_005: [ If any failure occurs, mpsc_wait_queue_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_Lock_Init_fails_mpsc_wait_queue_create_fails)
+{
+    // arrange
+    MPSC_WAIT_QUEUE_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = mpsc_wait_queue_create();
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_005: [ If any failure occurs, mpsc_wait_queue_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_Condition_Init_fails_mpsc_wait_queue_create_fails)
+{
+    // arrange
+    MPSC_WAIT_QUEUE_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = mpsc_wait_queue_create();
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* mpsc_wait_queue_destroy */
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_006: [ If mpsc_wait_queue is NULL, mpsc_wait_queue_destroy shall return. ]*/
+TEST_FUNCTION(mpsc_wait_queue_destroy_with_NULL_returns)
+{
+    // arrange
+
+    // act
+    mpsc_wait_queue_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_007: [ mpsc_wait_queue_destroy shall free the condition, the lock and the memory of the queue, without touching the entries in it. ]*/
+TEST_FUNCTION(mpsc_wait_queue_destroy_frees_the_condition_the_lock_and_the_memory)
+{
+    // arrange
+    MPSC_WAIT_QUEUE_HANDLE queue = create_queue();
+    MPSC_QUEUE_ENTRY entry;
+    (void)mpsc_wait_queue_push(queue, &entry);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Condition_Deinit(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(queue));
+
+    // act
+    mpsc_wait_queue_destroy(queue);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* mpsc_wait_queue_push */
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_008: [ If mpsc_wait_queue or entry is NULL, mpsc_wait_queue_push shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(mpsc_wait_queue_push_with_NULL_handle_fails)
+{
+    // arrange
+    MPSC_QUEUE_ENTRY entry;
+    int result;
+
+    // act
+    result = mpsc_wait_queue_push(NULL, &entry);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_008: [ If mpsc_wait_queue or entry is NULL, mpsc_wait_queue_push shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(mpsc_wait_queue_push_with_NULL_entry_fails)
+{
+    // arrange
+    MPSC_WAIT_QUEUE_HANDLE queue = create_queue();
+    int result;
+
+    // act
+    result = mpsc_wait_queue_push(queue, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mpsc_wait_queue_destroy(queue);
+}
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_009: [ mpsc_wait_queue_push shall add entry at the end of the queue with mpsc_queue_push. ]*/
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_011: [ mpsc_wait_queue_push shall succeed and return 0. ]*/
+TEST_FUNCTION(mpsc_wait_queue_push_without_a_waiting_consumer_does_not_take_the_lock)
+{
+    // arrange
+    MPSC_WAIT_QUEUE_HANDLE queue = create_queue();
+    MPSC_QUEUE_ENTRY entry;
+    int result;
+
+    // act
+    result = mpsc_wait_queue_push(queue, &entry);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, &entry, mpsc_wait_queue_try_pop(queue));
+
+    // cleanup
+    mpsc_wait_queue_destroy(queue);
+}
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_010: [ If the consumer is waiting, mpsc_wait_queue_push shall post the condition while holding the lock. ]*/
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_011: [ mpsc_wait_queue_push shall succeed and return 0. ]*/
+TEST_FUNCTION(mpsc_wait_queue_push_with_a_waiting_consumer_posts_the_condition)
+{
+    // arrange
+    MPSC_WAIT_QUEUE_HANDLE queue = create_queue();
+    MPSC_QUEUE_ENTRY* result;
+    g_waited_queue = queue;
+    g_condition_wait_action = TEST_CONDITION_WAIT_PUSHES;
+
+    setup_wait_expectations(0);
+    setup_post_expectations();
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = mpsc_wait_queue_pop(queue, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, g_producer_result);
+    ASSERT_ARE_EQUAL(void_ptr, &g_pushed_entry, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mpsc_wait_queue_destroy(queue);
+}
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_012: [ If any failure occurs, mpsc_wait_queue_push shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_Lock_fails_mpsc_wait_queue_push_with_a_waiting_consumer_fails)
+{
+    // arrange
+    MPSC_WAIT_QUEUE_HANDLE queue = create_queue();
+    g_waited_queue = queue;
+    g_condition_wait_action = TEST_CONDITION_WAIT_PUSHES;
+
+    setup_wait_expectations(0);
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE))
+        .SetReturn(LOCK_ERROR);
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    (void)mpsc_wait_queue_pop(queue, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, g_producer_result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mpsc_wait_queue_destroy(queue);
+}
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_012: [ If any failure occurs, mpsc_wait_queue_push shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_Condition_Post_fails_mpsc_wait_queue_push_with_a_waiting_consumer_fails)
+{
+    // arrange
+    MPSC_WAIT_QUEUE_HANDLE queue = create_queue();
+    g_waited_queue = queue;
+    g_condition_wait_action = TEST_CONDITION_WAIT_PUSHES;
+
+    setup_wait_expectations(0);
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE))
+        .SetReturn(COND_ERROR);
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    (void)mpsc_wait_queue_pop(queue, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, g_producer_result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mpsc_wait_queue_destroy(queue);
+}
+
+/* mpsc_wait_queue_try_pop */
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_013: [ If mpsc_wait_queue is NULL, mpsc_wait_queue_try_pop shall fail and return NULL. ]*/
+TEST_FUNCTION(mpsc_wait_queue_try_pop_with_NULL_handle_fails)
+{
+    // arrange
+    MPSC_QUEUE_ENTRY* result;
+
+    // act
+    result = mpsc_wait_queue_try_pop(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_014: [ mpsc_wait_queue_try_pop shall remove and return the entry at the front of the queue, or return NULL if the queue is empty. ]*/
+TEST_FUNCTION(mpsc_wait_queue_try_pop_returns_the_entries_in_order_then_NULL)
+{
+    // arrange
+    MPSC_WAIT_QUEUE_HANDLE queue = create_queue();
+    MPSC_QUEUE_ENTRY entry1;
+    MPSC_QUEUE_ENTRY entry2;
+    (void)mpsc_wait_queue_push(queue, &entry1);
+    (void)mpsc_wait_queue_push(queue, &entry2);
+
+    // act
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, &entry1, mpsc_wait_queue_try_pop(queue));
+    ASSERT_ARE_EQUAL(void_ptr, &entry2, mpsc_wait_queue_try_pop(queue));
+    ASSERT_IS_NULL(mpsc_wait_queue_try_pop(queue));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mpsc_wait_queue_destroy(queue);
+}
+
+/* mpsc_wait_queue_pop */
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_015: [ If mpsc_wait_queue is NULL or timeout_milliseconds is negative, mpsc_wait_queue_pop shall fail and return NULL. ]*/
+TEST_FUNCTION(mpsc_wait_queue_pop_with_NULL_handle_fails)
+{
+    // arrange
+    MPSC_QUEUE_ENTRY* result;
+
+    // act
+    result = mpsc_wait_queue_pop(NULL, 0);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_015: [ If mpsc_wait_queue is NULL or timeout_milliseconds is negative, mpsc_wait_queue_pop shall fail and return NULL. ]*/
+TEST_FUNCTION(mpsc_wait_queue_pop_with_negative_timeout_fails)
+{
+    // arrange
+    MPSC_WAIT_QUEUE_HANDLE queue = create_queue();
+    MPSC_QUEUE_ENTRY entry;
+    MPSC_QUEUE_ENTRY* result;
+    (void)mpsc_wait_queue_push(queue, &entry);
+
+    // act
+    result = mpsc_wait_queue_pop(queue, -1);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mpsc_wait_queue_destroy(queue);
+}
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_016: [ If the queue is not empty, mpsc_wait_queue_pop shall remove and return the entry at the front of the queue without taking the lock. ]*/
+TEST_FUNCTION(mpsc_wait_queue_pop_with_an_entry_returns_it_without_taking_the_lock)
+{
+    // arrange
+    MPSC_WAIT_QUEUE_HANDLE queue = create_queue();
+    MPSC_QUEUE_ENTRY entry;
+    MPSC_QUEUE_ENTRY* result;
+    (void)mpsc_wait_queue_push(queue, &entry);
+
+    // act
+    result = mpsc_wait_queue_pop(queue, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, &entry, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mpsc_wait_queue_destroy(queue);
+}
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_017: [ Otherwise mpsc_wait_queue_pop shall take the lock, mark the consumer as waiting and check the queue again. ]*/
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_018: [ If the queue is still empty, mpsc_wait_queue_pop shall wait on the condition for at most timeout_milliseconds, 0 meaning no timeout. ]*/
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_019: [ After waiting, mpsc_wait_queue_pop shall remove and return the entry at the front of the queue, or return NULL if the queue is still empty. ]*/
+TEST_FUNCTION(mpsc_wait_queue_pop_on_an_empty_queue_waits_and_returns_NULL_on_timeout)
+{
+    // arrange
+    MPSC_WAIT_QUEUE_HANDLE queue = create_queue();
+    MPSC_QUEUE_ENTRY* result;
+
+    setup_wait_expectations(100);
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = mpsc_wait_queue_pop(queue, 100);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mpsc_wait_queue_destroy(queue);
+}
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_021: [ If any failure occurs, mpsc_wait_queue_pop shall fail and return NULL. ]*/
+TEST_FUNCTION(when_Lock_fails_mpsc_wait_queue_pop_fails)
+{
+    // arrange
+    MPSC_WAIT_QUEUE_HANDLE queue = create_queue();
+    MPSC_QUEUE_ENTRY* result;
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE))
+        .SetReturn(LOCK_ERROR);
+
+    // act
+    result = mpsc_wait_queue_pop(queue, 0);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mpsc_wait_queue_destroy(queue);
+}
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_021: [ If any failure occurs, mpsc_wait_queue_pop shall fail and return NULL. ]*/
+TEST_FUNCTION(when_Condition_Wait_fails_mpsc_wait_queue_pop_fails)
+{
+    // arrange
+    MPSC_WAIT_QUEUE_HANDLE queue = create_queue();
+    MPSC_QUEUE_ENTRY* result;
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, TEST_LOCK_HANDLE, 0))
+        .SetReturn(COND_ERROR);
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = mpsc_wait_queue_pop(queue, 0);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mpsc_wait_queue_destroy(queue);
+}
+
+/* mpsc_wait_queue_wake */
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_022: [ If mpsc_wait_queue is NULL, mpsc_wait_queue_wake shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(mpsc_wait_queue_wake_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = mpsc_wait_queue_wake(NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_023: [ mpsc_wait_queue_wake shall record the wake, so that the current or next wait of mpsc_wait_queue_pop returns NULL. ]*/
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_025: [ mpsc_wait_queue_wake shall succeed and return 0. ]*/
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_020: [ If mpsc_wait_queue_wake was called since the last wait, mpsc_wait_queue_pop shall return NULL without waiting. ]*/
+TEST_FUNCTION(mpsc_wait_queue_wake_without_a_waiting_consumer_makes_the_next_pop_return_NULL_without_waiting)
+{
+    // arrange
+    MPSC_WAIT_QUEUE_HANDLE queue = create_queue();
+    MPSC_QUEUE_ENTRY* result;
+    int wake_result;
+
+    // act
+    wake_result = mpsc_wait_queue_wake(queue);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, wake_result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    result = mpsc_wait_queue_pop(queue, 0);
+
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mpsc_wait_queue_destroy(queue);
+}
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_024: [ If the consumer is waiting, mpsc_wait_queue_wake shall post the condition while holding the lock. ]*/
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_025: [ mpsc_wait_queue_wake shall succeed and return 0. ]*/
+TEST_FUNCTION(mpsc_wait_queue_wake_with_a_waiting_consumer_posts_the_condition_and_the_wake_is_consumed)
+{
+    // arrange
+    MPSC_WAIT_QUEUE_HANDLE queue = create_queue();
+    MPSC_QUEUE_ENTRY* result;
+    g_waited_queue = queue;
+    g_condition_wait_action = TEST_CONDITION_WAIT_WAKES;
+
+    setup_wait_expectations(0);
+    setup_post_expectations();
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = mpsc_wait_queue_pop(queue, 0);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0, g_producer_result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // the wake was consumed, the next pop waits again
+    umock_c_reset_all_calls();
+    g_condition_wait_action = TEST_CONDITION_WAIT_TIMES_OUT;
+    setup_wait_expectations(5);
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    result = mpsc_wait_queue_pop(queue, 5);
+
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mpsc_wait_queue_destroy(queue);
+}
+
+/* Tests_SRS_MPSC_WAIT_QUEUE_01_026: [ If any failure occurs, mpsc_wait_queue_wake shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_Condition_Post_fails_mpsc_wait_queue_wake_fails)
+{
+    // arrange
+    MPSC_WAIT_QUEUE_HANDLE queue = create_queue();
+    g_waited_queue = queue;
+    g_condition_wait_action = TEST_CONDITION_WAIT_WAKES;
+
+    setup_wait_expectations(0);
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE))
+        .SetReturn(COND_ERROR);
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    (void)mpsc_wait_queue_pop(queue, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, g_producer_result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    mpsc_wait_queue_destroy(queue);
+}
+
+END_TEST_SUITE(mpsc_wait_queue_unittests)
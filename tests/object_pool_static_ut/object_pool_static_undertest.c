@@ -0,0 +1,20 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#define malloc mock_malloc
+#define free mock_free
+
+extern void* mock_malloc(size_t size);
+extern void mock_free(void* ptr);
+
+#define OBJECT_POOL_PAYLOAD_32_COUNT 2
+#define OBJECT_POOL_PAYLOAD_64_COUNT 1
+#define OBJECT_POOL_PAYLOAD_128_COUNT 1
+#define OBJECT_POOL_PAYLOAD_256_COUNT 1
+#define OBJECT_POOL_PAYLOAD_512_COUNT 1
+#define OBJECT_POOL_PAYLOAD_1024_COUNT 1
+#define OBJECT_POOL_PAYLOAD_2048_COUNT 1
+#define OBJECT_POOL_PAYLOAD_4096_COUNT 1
+
+#include "../../src/object_pool.c"
@@ -0,0 +1,420 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#endif
+
+#include "testrunnerswitcher.h"
+
+static void* my_mock_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_mock_free(void* ptr)
+{
+    free(ptr);
+}
+
+#define ENABLE_MOCKS
+
+#include "umock_c.h"
+#include "umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    MOCKABLE_FUNCTION(, void*, mock_malloc, size_t, size);
+    MOCKABLE_FUNCTION(, void, mock_free, void*, ptr);
+#ifdef __cplusplus
+}
+#endif
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/object_pool.h"
+
+#define TEST_OBJECT_SIZE 48
+#define TEST_OBJECT_COUNT 2
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+BEGIN_TEST_SUITE(object_pool_static_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(mock_malloc, my_mock_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(mock_free, my_mock_free);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* object_pool_alloc */
+
+/* Tests_SRS_OBJECT_POOL_01_010: [ Otherwise, if the pool has static storage, object_pool_alloc shall return the next block of the storage that was never handed out. ]*/
+TEST_FUNCTION(object_pool_alloc_on_a_static_pool_returns_a_block_of_its_storage_without_allocating)
+{
+    // arrange
+    void* object1;
+    void* object2;
+    OBJECT_POOL_ALIGNMENT storage[(OBJECT_POOL_BLOCK_SIZE(TEST_OBJECT_SIZE) / sizeof(OBJECT_POOL_ALIGNMENT)) * TEST_OBJECT_COUNT];
+    OBJECT_POOL pool = OBJECT_POOL_STATIC_INITIALIZER("test", TEST_OBJECT_SIZE, storage, TEST_OBJECT_COUNT);
+
+    // act
+    object1 = object_pool_alloc(&pool);
+    object2 = object_pool_alloc(&pool);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, (void*)storage, object1);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)((unsigned char*)storage + OBJECT_POOL_BLOCK_SIZE(TEST_OBJECT_SIZE)), object2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_OBJECT_POOL_01_011: [ If all the blocks of the static storage are in use, object_pool_alloc shall fail and return NULL without allocating. ]*/
+TEST_FUNCTION(object_pool_alloc_on_an_exhausted_static_pool_fails)
+{
+    // arrange
+    void* result;
+    OBJECT_POOL_STATISTICS statistics;
+    OBJECT_POOL_ALIGNMENT storage[(OBJECT_POOL_BLOCK_SIZE(TEST_OBJECT_SIZE) / sizeof(OBJECT_POOL_ALIGNMENT)) * TEST_OBJECT_COUNT];
+    OBJECT_POOL pool = OBJECT_POOL_STATIC_INITIALIZER("test", TEST_OBJECT_SIZE, storage, TEST_OBJECT_COUNT);
+
+    (void)object_pool_alloc(&pool);
+    (void)object_pool_alloc(&pool);
+    umock_c_reset_all_calls();
+
+    // act
+    result = object_pool_alloc(&pool);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, object_pool_get_statistics(&pool, &statistics));
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.failed_count);
+}
+
+/* Tests_SRS_OBJECT_POOL_01_003: [ Otherwise object_pool_alloc shall allocate a block of the object size of the pool, or of the size of a pointer if that is larger. ]*/
+TEST_FUNCTION(object_pool_alloc_on_a_pool_without_storage_allocates_a_block)
+{
+    // arrange
+    void* result;
+    OBJECT_POOL pool = OBJECT_POOL_INITIALIZER(TEST_OBJECT_SIZE);
+
+    STRICT_EXPECTED_CALL(mock_malloc(TEST_OBJECT_SIZE));
+
+    // act
+    result = object_pool_alloc(&pool);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    free(result);
+}
+
+/* object_pool_free */
+
+/* Tests_SRS_OBJECT_POOL_01_013: [ A block of static storage shall always be added to the pool, and never freed. ]*/
+/* Tests_SRS_OBJECT_POOL_01_002: [ If the pool has a cached block, object_pool_alloc shall remove it from the pool and return it. ]*/
+TEST_FUNCTION(object_pool_free_gives_a_block_back_to_its_static_pool)
+{
+    // arrange
+    void* object;
+    void* result;
+    OBJECT_POOL_ALIGNMENT storage[(OBJECT_POOL_BLOCK_SIZE(TEST_OBJECT_SIZE) / sizeof(OBJECT_POOL_ALIGNMENT)) * TEST_OBJECT_COUNT];
+    OBJECT_POOL pool = OBJECT_POOL_STATIC_INITIALIZER("test", TEST_OBJECT_SIZE, storage, TEST_OBJECT_COUNT);
+
+    (void)object_pool_alloc(&pool);
+    object = object_pool_alloc(&pool);
+
+    // act
+    object_pool_free(&pool, object);
+    result = object_pool_alloc(&pool);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, object, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* object_pool_trim */
+
+/* Tests_SRS_OBJECT_POOL_01_014: [ object_pool_trim shall keep the blocks of a pool with static storage. ]*/
+TEST_FUNCTION(object_pool_trim_keeps_the_blocks_of_a_static_pool)
+{
+    // arrange
+    void* object;
+    OBJECT_POOL_ALIGNMENT storage[(OBJECT_POOL_BLOCK_SIZE(TEST_OBJECT_SIZE) / sizeof(OBJECT_POOL_ALIGNMENT)) * TEST_OBJECT_COUNT];
+    OBJECT_POOL pool = OBJECT_POOL_STATIC_INITIALIZER("test", TEST_OBJECT_SIZE, storage, TEST_OBJECT_COUNT);
+
+    object = object_pool_alloc(&pool);
+    object_pool_free(&pool, object);
+    umock_c_reset_all_calls();
+
+    // act
+    object_pool_trim(&pool);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, object, pool.free_list);
+}
+
+/* object_pool_get_statistics */
+
+/* Tests_SRS_OBJECT_POOL_01_015: [ If pool or statistics is NULL, object_pool_get_statistics shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(object_pool_get_statistics_with_NULL_pool_fails)
+{
+    // arrange
+    OBJECT_POOL_STATISTICS statistics;
+
+    // act
+    int result = object_pool_get_statistics(NULL, &statistics);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_OBJECT_POOL_01_015: [ If pool or statistics is NULL, object_pool_get_statistics shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(object_pool_get_statistics_with_NULL_statistics_fails)
+{
+    // arrange
+    OBJECT_POOL pool = OBJECT_POOL_INITIALIZER(TEST_OBJECT_SIZE);
+
+    // act
+    int result = object_pool_get_statistics(&pool, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_OBJECT_POOL_01_012: [ When OBJECT_POOL_STATIC is defined, object_pool_alloc shall count the blocks in use and keep their high-water mark. ]*/
+/* Tests_SRS_OBJECT_POOL_01_016: [ object_pool_get_statistics shall fill statistics with the object size, the number of blocks of static storage, the blocks in use, their high-water mark and the count of failed allocations of the pool and return 0. ]*/
+TEST_FUNCTION(object_pool_get_statistics_returns_the_use_of_the_pool)
+{
+    // arrange
+    int result;
+    void* object;
+    OBJECT_POOL_STATISTICS statistics;
+    OBJECT_POOL_ALIGNMENT storage[(OBJECT_POOL_BLOCK_SIZE(TEST_OBJECT_SIZE) / sizeof(OBJECT_POOL_ALIGNMENT)) * TEST_OBJECT_COUNT];
+    OBJECT_POOL pool = OBJECT_POOL_STATIC_INITIALIZER("test", TEST_OBJECT_SIZE, storage, TEST_OBJECT_COUNT);
+
+    (void)object_pool_alloc(&pool);
+    object = object_pool_alloc(&pool);
+    object_pool_free(&pool, object);
+
+    // act
+    result = object_pool_get_statistics(&pool, &statistics);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, TEST_OBJECT_SIZE, statistics.object_size);
+    ASSERT_ARE_EQUAL(size_t, TEST_OBJECT_COUNT, statistics.capacity);
+    ASSERT_ARE_EQUAL(size_t, 1, statistics.in_use_count);
+    ASSERT_ARE_EQUAL(size_t, 2, statistics.high_water_mark);
+    ASSERT_ARE_EQUAL(size_t, 0, statistics.failed_count);
+}
+
+/* object_pool_payload_alloc */
+
+/* Tests_SRS_OBJECT_POOL_01_019: [ If size is 0, object_pool_payload_alloc shall fail and return NULL. ]*/
+TEST_FUNCTION(object_pool_payload_alloc_with_0_size_fails)
+{
+    // arrange
+
+    // act
+    void* result = object_pool_payload_alloc(0);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_OBJECT_POOL_01_020: [ object_pool_payload_alloc shall return a block of the smallest payload size class that holds size bytes and has a free block. ]*/
+/* Tests_SRS_OBJECT_POOL_01_031: [ object_pool_is_payload shall return a non-zero value if ptr is in the storage of a payload pool and 0 otherwise. ]*/
+TEST_FUNCTION(object_pool_payload_alloc_takes_a_block_of_the_smallest_class)
+{
+    // arrange
+    void* result;
+
+    // act
+    result = object_pool_payload_alloc(20);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, object_pool_is_payload(result));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    /* the block is one of the 32 bytes class */
+    ASSERT_ARE_EQUAL(void_ptr, result, object_pool_payload_realloc(result, 32));
+
+    // cleanup
+    object_pool_payload_free(result);
+}
+
+/* Tests_SRS_OBJECT_POOL_01_020: [ object_pool_payload_alloc shall return a block of the smallest payload size class that holds size bytes and has a free block. ]*/
+TEST_FUNCTION(object_pool_payload_alloc_takes_a_larger_class_when_the_smallest_is_exhausted)
+{
+    // arrange
+    void* object1 = object_pool_payload_alloc(32);
+    void* object2 = object_pool_payload_alloc(32);
+    void* result;
+
+    // act
+    result = object_pool_payload_alloc(32);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    /* the block is the one of the 64 bytes class */
+    ASSERT_ARE_EQUAL(void_ptr, result, object_pool_payload_realloc(result, 64));
+
+    // cleanup
+    object_pool_payload_free(result);
+    object_pool_payload_free(object2);
+    object_pool_payload_free(object1);
+}
+
+/* Tests_SRS_OBJECT_POOL_01_021: [ If size is larger than the largest payload size class or no class that holds it has a free block, object_pool_payload_alloc shall fail and return NULL. ]*/
+TEST_FUNCTION(object_pool_payload_alloc_larger_than_the_largest_class_fails)
+{
+    // arrange
+
+    // act
+    void* result = object_pool_payload_alloc(4097);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_OBJECT_POOL_01_021: [ If size is larger than the largest payload size class or no class that holds it has a free block, object_pool_payload_alloc shall fail and return NULL. ]*/
+TEST_FUNCTION(object_pool_payload_alloc_fails_when_no_class_has_a_free_block)
+{
+    // arrange
+    void* object = object_pool_payload_alloc(4096);
+    void* result;
+
+    // act
+    result = object_pool_payload_alloc(3000);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    object_pool_payload_free(object);
+}
+
+/* object_pool_payload_realloc */
+
+/* Tests_SRS_OBJECT_POOL_01_025: [ If size fits the block of ptr, object_pool_payload_realloc shall return ptr. ]*/
+TEST_FUNCTION(object_pool_payload_realloc_within_the_block_returns_ptr)
+{
+    // arrange
+    void* object = object_pool_payload_alloc(10);
+    void* result;
+
+    // act
+    result = object_pool_payload_realloc(object, 32);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, object, result);
+
+    // cleanup
+    object_pool_payload_free(result);
+}
+
+/* Tests_SRS_OBJECT_POOL_01_026: [ Otherwise object_pool_payload_realloc shall copy the content of ptr to a block that holds size bytes, give back ptr and return the new block. ]*/
+TEST_FUNCTION(object_pool_payload_realloc_moves_the_content_to_a_larger_class)
+{
+    // arrange
+    unsigned char* object = (unsigned char*)object_pool_payload_alloc(32);
+    unsigned char* result;
+    (void)memset(object, 'x', 32);
+
+    // act
+    result = (unsigned char*)object_pool_payload_realloc(object, 100);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, object, result);
+    ASSERT_ARE_EQUAL(int, 'x', result[31]);
+    ASSERT_ARE_EQUAL(void_ptr, result, object_pool_payload_realloc(result, 128));
+    /* the old block was given back */
+    ASSERT_ARE_EQUAL(void_ptr, object, object_pool_payload_alloc(32));
+
+    // cleanup
+    object_pool_payload_free(object);
+    object_pool_payload_free(result);
+}
+
+/* Tests_SRS_OBJECT_POOL_01_024: [ If ptr was not obtained from object_pool_payload_alloc, object_pool_payload_realloc shall fail and return NULL. ]*/
+TEST_FUNCTION(object_pool_payload_realloc_of_a_heap_block_fails)
+{
+    // arrange
+    int object;
+
+    // act
+    void* result = object_pool_payload_realloc(&object, 10);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(int, 0, object_pool_is_payload(&object));
+}
+
+/* object_pool_payload_free */
+
+/* Tests_SRS_OBJECT_POOL_01_029: [ If ptr was not obtained from object_pool_payload_alloc, object_pool_payload_free shall log an error and do nothing. ]*/
+TEST_FUNCTION(object_pool_payload_free_of_a_heap_block_does_nothing)
+{
+    // arrange
+    int object;
+
+    // act
+    object_pool_payload_free(&object);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+END_TEST_SUITE(object_pool_static_unittests)
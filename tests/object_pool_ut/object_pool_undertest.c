@@ -0,0 +1,11 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <stdlib.h>
+#define malloc mock_malloc
+#define free mock_free
+
+extern void* mock_malloc(size_t size);
+extern void mock_free(void* ptr);
+
+#include "../../src/object_pool.c"
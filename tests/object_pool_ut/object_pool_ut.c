@@ -0,0 +1,319 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#endif
+
+#include "testrunnerswitcher.h"
+
+static void* my_mock_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_mock_free(void* ptr)
+{
+    free(ptr);
+}
+
+#define ENABLE_MOCKS
+
+#include "umock_c.h"
+#include "umock_c_prod.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+    MOCKABLE_FUNCTION(, void*, mock_malloc, size_t, size);
+    MOCKABLE_FUNCTION(, void, mock_free, void*, ptr);
+#ifdef __cplusplus
+}
+#endif
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/object_pool.h"
+
+#define TEST_OBJECT_SIZE 48
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+BEGIN_TEST_SUITE(object_pool_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(mock_malloc, my_mock_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(mock_free, my_mock_free);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* object_pool_alloc */
+
+/* Tests_SRS_OBJECT_POOL_01_001: [ If pool is NULL, object_pool_alloc shall fail and return NULL. ]*/
+TEST_FUNCTION(object_pool_alloc_with_NULL_pool_fails)
+{
+    // arrange
+    void* result;
+
+    // act
+    result = object_pool_alloc(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_OBJECT_POOL_01_003: [ Otherwise object_pool_alloc shall allocate a block of the object size of the pool, or of the size of a pointer if that is larger. ]*/
+TEST_FUNCTION(object_pool_alloc_on_an_empty_pool_allocates_a_block)
+{
+    // arrange
+    void* result;
+    OBJECT_POOL pool = OBJECT_POOL_INITIALIZER(TEST_OBJECT_SIZE);
+
+    STRICT_EXPECTED_CALL(mock_malloc(TEST_OBJECT_SIZE));
+
+    // act
+    result = object_pool_alloc(&pool);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    free(result);
+}
+
+/* Tests_SRS_OBJECT_POOL_01_003: [ Otherwise object_pool_alloc shall allocate a block of the object size of the pool, or of the size of a pointer if that is larger. ]*/
+TEST_FUNCTION(object_pool_alloc_allocates_at_least_a_pointer)
+{
+    // arrange
+    void* result;
+    OBJECT_POOL pool = OBJECT_POOL_INITIALIZER(1);
+
+    STRICT_EXPECTED_CALL(mock_malloc(sizeof(void*)));
+
+    // act
+    result = object_pool_alloc(&pool);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    free(result);
+}
+
+/* Tests_SRS_OBJECT_POOL_01_004: [ If allocating the block fails, object_pool_alloc shall return NULL. ]*/
+TEST_FUNCTION(when_malloc_fails_object_pool_alloc_fails)
+{
+    // arrange
+    void* result;
+    OBJECT_POOL pool = OBJECT_POOL_INITIALIZER(TEST_OBJECT_SIZE);
+
+    STRICT_EXPECTED_CALL(mock_malloc(TEST_OBJECT_SIZE))
+        .SetReturn(NULL);
+
+    // act
+    result = object_pool_alloc(&pool);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_OBJECT_POOL_01_002: [ If the pool has a cached block, object_pool_alloc shall remove it from the pool and return it. ]*/
+/* Tests_SRS_OBJECT_POOL_01_006: [ If the pool holds less than OBJECT_POOL_MAX_CACHED blocks, object_pool_free shall add object to the pool. ]*/
+TEST_FUNCTION(object_pool_alloc_returns_a_freed_block_without_allocating)
+{
+    // arrange
+    void* object;
+    void* result;
+    OBJECT_POOL pool = OBJECT_POOL_INITIALIZER(TEST_OBJECT_SIZE);
+
+    object = object_pool_alloc(&pool);
+    object_pool_free(&pool, object);
+    umock_c_reset_all_calls();
+
+    // act
+    result = object_pool_alloc(&pool);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, object, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    free(result);
+}
+
+/* object_pool_free */
+
+/* Tests_SRS_OBJECT_POOL_01_005: [ If pool or object is NULL, object_pool_free shall do nothing. ]*/
+TEST_FUNCTION(object_pool_free_with_NULL_pool_does_nothing)
+{
+    // arrange
+    int object;
+
+    // act
+    object_pool_free(NULL, &object);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_OBJECT_POOL_01_005: [ If pool or object is NULL, object_pool_free shall do nothing. ]*/
+TEST_FUNCTION(object_pool_free_with_NULL_object_does_nothing)
+{
+    // arrange
+    OBJECT_POOL pool = OBJECT_POOL_INITIALIZER(TEST_OBJECT_SIZE);
+
+    // act
+    object_pool_free(&pool, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, pool.cached_count);
+}
+
+/* Tests_SRS_OBJECT_POOL_01_007: [ Otherwise object_pool_free shall free object. ]*/
+TEST_FUNCTION(object_pool_free_frees_the_block_when_the_pool_is_full)
+{
+    // arrange
+    size_t i;
+    void* objects[OBJECT_POOL_MAX_CACHED + 1];
+    OBJECT_POOL pool = OBJECT_POOL_INITIALIZER(TEST_OBJECT_SIZE);
+
+    for (i = 0; i < OBJECT_POOL_MAX_CACHED + 1; i++)
+    {
+        objects[i] = object_pool_alloc(&pool);
+    }
+    for (i = 0; i < OBJECT_POOL_MAX_CACHED; i++)
+    {
+        object_pool_free(&pool, objects[i]);
+    }
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_free(objects[OBJECT_POOL_MAX_CACHED]));
+
+    // act
+    object_pool_free(&pool, objects[OBJECT_POOL_MAX_CACHED]);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, OBJECT_POOL_MAX_CACHED, pool.cached_count);
+
+    // cleanup
+    object_pool_trim(&pool);
+}
+
+/* object_pool_trim */
+
+/* Tests_SRS_OBJECT_POOL_01_008: [ If pool is NULL, object_pool_trim shall do nothing. ]*/
+TEST_FUNCTION(object_pool_trim_with_NULL_pool_does_nothing)
+{
+    // arrange
+
+    // act
+    object_pool_trim(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_OBJECT_POOL_01_009: [ object_pool_trim shall free all the blocks cached by the pool. ]*/
+TEST_FUNCTION(object_pool_trim_frees_the_cached_blocks)
+{
+    // arrange
+    void* object1;
+    void* object2;
+    OBJECT_POOL pool = OBJECT_POOL_INITIALIZER(TEST_OBJECT_SIZE);
+
+    object1 = object_pool_alloc(&pool);
+    object2 = object_pool_alloc(&pool);
+    object_pool_free(&pool, object1);
+    object_pool_free(&pool, object2);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(mock_free(object2));
+    STRICT_EXPECTED_CALL(mock_free(object1));
+
+    // act
+    object_pool_trim(&pool);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, pool.cached_count);
+    ASSERT_IS_NULL(pool.free_list);
+}
+
+/* object_pool_get_statistics */
+
+/* Tests_SRS_OBJECT_POOL_01_017: [ When OBJECT_POOL_STATIC is not defined, object_pool_get_statistics shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(object_pool_get_statistics_without_OBJECT_POOL_STATIC_fails)
+{
+    // arrange
+    OBJECT_POOL_STATISTICS statistics;
+    OBJECT_POOL pool = OBJECT_POOL_INITIALIZER(TEST_OBJECT_SIZE);
+
+    // act
+    int result = object_pool_get_statistics(&pool, &statistics);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* object_pool_payload_alloc */
+
+/* Tests_SRS_OBJECT_POOL_01_022: [ When OBJECT_POOL_STATIC is not defined, object_pool_payload_alloc shall fail and return NULL. ]*/
+TEST_FUNCTION(object_pool_payload_alloc_without_OBJECT_POOL_STATIC_fails)
+{
+    // arrange
+
+    // act
+    void* result = object_pool_payload_alloc(16);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+END_TEST_SUITE(object_pool_unittests)
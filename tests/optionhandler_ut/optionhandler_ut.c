@@ -3,8 +3,12 @@
 
 #ifdef __cplusplus
 #include <cstdlib>
+#include <cstring>
+#include <cstdio>
 #else
 #include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
 #endif
 
 static void* my_gballoc_malloc(size_t size)
@@ -12,6 +16,11 @@ static void* my_gballoc_malloc(size_t size)
     return malloc(size);
 }
 
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
 static void my_gballoc_free(void* s)
 {
     free(s);
@@ -26,48 +35,24 @@ static void my_gballoc_free(void* s)
 #include "umock_c.h"
 #include "umocktypes_charptr.h"
 #include "umock_c_negative_tests.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/constbuffer.h"
+#undef ENABLE_MOCKS
+
 #include "azure_c_shared_utility/optionhandler.h"
 #include "azure_c_shared_utility/optimize_size.h"
 
-/*not very nice source level preprocessor mocking... */
-/*but real implementation of VECTOR is paramount here, because -> operator cannot be mocked*/
-#define GBALLOC_H
-#define VECTOR_create real_VECTOR_create
-#define VECTOR_move real_VECTOR_move
-#define VECTOR_destroy real_VECTOR_destroy
-#define VECTOR_push_back real_VECTOR_push_back
-#define VECTOR_erase real_VECTOR_erase
-#define VECTOR_clear real_VECTOR_clear
-#define VECTOR_element real_VECTOR_element
-#define VECTOR_front real_VECTOR_front
-#define VECTOR_back real_VECTOR_back
-#define VECTOR_find_if real_VECTOR_find_if
-#define VECTOR_size real_VECTOR_size
-#include "../src/vector.c"
-#undef VECTOR_create
-#undef VECTOR_move
-#undef VECTOR_destroy
-#undef VECTOR_push_back
-#undef VECTOR_erase
-#undef VECTOR_clear
-#undef VECTOR_element
-#undef VECTOR_front
-#undef VECTOR_back
-#undef VECTOR_find_if
-#undef VECTOR_size
-#undef VECTOR_H
-#undef GBALLOC_H
-#undef CRT_ABSTRACTIONS_H
-
 #define ENABLE_MOCKS
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/umock_c_prod.h"
-#include "azure_c_shared_utility/crt_abstractions.h"
-#include "azure_c_shared_utility/vector.h"
+#include "azure_c_shared_utility/string_intern.h"
 
 MOCKABLE_FUNCTION(, void*, aCloneOption, const char*, name, const void*, value);
 MOCKABLE_FUNCTION(, void, aDestroyOption, const char*, name, const void*, value);
 MOCKABLE_FUNCTION(, int, aSetOption, void*, handle, const char*, name, const void*, value);
+MOCKABLE_FUNCTION(, int, aGetOptionKey, const char*, name);
+MOCKABLE_FUNCTION(, int, aSetOptionByKey, void*, handle, int, key, const char*, name, const void*, value);
 
 #undef ENABLE_MOCKS
 
@@ -83,14 +68,22 @@ static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 TEST_DEFINE_ENUM_TYPE(OPTIONHANDLER_RESULT, OPTIONHANDLER_RESULT_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(OPTIONHANDLER_RESULT, OPTIONHANDLER_RESULT_VALUES);
 
-static int my_mallocAndStrcpy_s(char** destination, const char* source)
+static const char* my_string_intern(const char* value)
 {
-
-    size_t l = strlen(source);
+    size_t l = strlen(value);
     char* temp = (char*)my_gballoc_malloc(l + 1);
-    (void)memcpy(temp, source, l+1);
-    *destination=temp;
-    return 0;
+    (void)memcpy(temp, value, l + 1);
+    return temp;
+}
+
+static const char* my_string_intern_clone(const char* interned)
+{
+    return my_string_intern(interned);
+}
+
+static void my_string_intern_release(const char* interned)
+{
+    my_gballoc_free((void*)interned);
 }
 
 static void* my_aCloneOption(const char* name, const void* value)
@@ -105,6 +98,10 @@ static void my_aDestroyOption(const char* name, const void* value)
     my_gballoc_free((void*)value);
 }
 
+#define TEST_SHARED_VALUE ((CONSTBUFFER_HANDLE)0x4242)
+static const unsigned char TEST_SHARED_VALUE_CONTENT[] = "shared value";
+static const CONSTBUFFER TEST_SHARED_VALUE_CONSTBUFFER = { TEST_SHARED_VALUE_CONTENT, sizeof(TEST_SHARED_VALUE_CONTENT) };
+
 
 BEGIN_TEST_SUITE(optionhandler_unittests)
 
@@ -117,33 +114,30 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
 
         (void)umocktypes_charptr_register_types();
 
-        REGISTER_UMOCK_ALIAS_TYPE(const VECTOR_HANDLE, void*);
-        REGISTER_UMOCK_ALIAS_TYPE(VECTOR_HANDLE, void*);
-
         REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_realloc, NULL);
         REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
 
-        REGISTER_GLOBAL_MOCK_HOOK(VECTOR_create, real_VECTOR_create);
-        REGISTER_GLOBAL_MOCK_FAIL_RETURN(VECTOR_create, NULL);
-
-        REGISTER_GLOBAL_MOCK_HOOK(VECTOR_size, real_VECTOR_size);
-        REGISTER_GLOBAL_MOCK_HOOK(VECTOR_push_back, real_VECTOR_push_back);
-        REGISTER_GLOBAL_MOCK_FAIL_RETURN(VECTOR_push_back, __FAILURE__);
-
-        REGISTER_GLOBAL_MOCK_HOOK(VECTOR_element, real_VECTOR_element);
-
-        REGISTER_GLOBAL_MOCK_HOOK(VECTOR_destroy, real_VECTOR_destroy);
-
-        REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, my_mallocAndStrcpy_s);
-        REGISTER_GLOBAL_MOCK_FAIL_RETURN(mallocAndStrcpy_s, __FAILURE__);
+        REGISTER_GLOBAL_MOCK_HOOK(string_intern, my_string_intern);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(string_intern, NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(string_intern_clone, my_string_intern_clone);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(string_intern_clone, NULL);
+        REGISTER_GLOBAL_MOCK_HOOK(string_intern_release, my_string_intern_release);
 
         REGISTER_GLOBAL_MOCK_HOOK(aCloneOption, my_aCloneOption);
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(aCloneOption, NULL);
 
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(aSetOption, __FAILURE__);
 
+        REGISTER_GLOBAL_MOCK_RETURN(aGetOptionKey, OPTIONHANDLER_NO_KEY);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(aSetOptionByKey, __FAILURE__);
+
         REGISTER_GLOBAL_MOCK_HOOK(aDestroyOption, my_aDestroyOption);
+
+        REGISTER_UMOCK_ALIAS_TYPE(CONSTBUFFER_HANDLE, void*);
+        REGISTER_GLOBAL_MOCK_RETURN(CONSTBUFFER_GetContent, &TEST_SHARED_VALUE_CONSTBUFFER);
     }
 
     TEST_SUITE_CLEANUP(TestClassCleanup)
@@ -211,12 +205,9 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
     {
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG)) /*this is creating the handle*/
             .IgnoreArgument_size();
-
-        STRICT_EXPECTED_CALL(VECTOR_create(IGNORED_NUM_ARG)) /*this is creating the vector that stores the options*/
-            .IgnoreArgument_elementSize();
     }
 
-    /*Tests_SRS_OPTIONHANDLER_02_002: [ OptionHandler_Create shall create an empty VECTOR that will hold pairs of const char* and void*. ]*/
+    /*Tests_SRS_OPTIONHANDLER_02_002: [ OptionHandler_Create shall start with an empty array of options, allocated when the first option is added. ]*/
     /*Tests_SRS_OPTIONHANDLER_02_003: [ If all the operations succeed then OptionHandler_Create shall succeed and return a non-NULL handle. ]*/
     TEST_FUNCTION(OptionHandler_Create_happy_path)
     {
@@ -270,6 +261,71 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
         umock_c_negative_tests_deinit();
     }
 
+    /* OptionHandler_CreateWithKeys */
+
+    /*Tests_SRS_OPTIONHANDLER_01_012: [ OptionHandler_CreateWithKeys shall fail and return NULL if any parameters are NULL. ]*/
+    TEST_FUNCTION(OptionHandler_CreateWithKeys_fails_with_NULL_cloneOption_parameter)
+    {
+        ///arrange
+
+        ///act
+        OPTIONHANDLER_HANDLE h = OptionHandler_CreateWithKeys(NULL, aDestroyOption, aSetOption, aGetOptionKey, aSetOptionByKey);
+
+        ///assert
+        ASSERT_IS_NULL(h);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+    }
+
+    /*Tests_SRS_OPTIONHANDLER_01_012: [ OptionHandler_CreateWithKeys shall fail and return NULL if any parameters are NULL. ]*/
+    TEST_FUNCTION(OptionHandler_CreateWithKeys_fails_with_NULL_getOptionKey_parameter)
+    {
+        ///arrange
+
+        ///act
+        OPTIONHANDLER_HANDLE h = OptionHandler_CreateWithKeys(aCloneOption, aDestroyOption, aSetOption, NULL, aSetOptionByKey);
+
+        ///assert
+        ASSERT_IS_NULL(h);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+    }
+
+    /*Tests_SRS_OPTIONHANDLER_01_012: [ OptionHandler_CreateWithKeys shall fail and return NULL if any parameters are NULL. ]*/
+    TEST_FUNCTION(OptionHandler_CreateWithKeys_fails_with_NULL_setOptionByKey_parameter)
+    {
+        ///arrange
+
+        ///act
+        OPTIONHANDLER_HANDLE h = OptionHandler_CreateWithKeys(aCloneOption, aDestroyOption, aSetOption, aGetOptionKey, NULL);
+
+        ///assert
+        ASSERT_IS_NULL(h);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+    }
+
+    /*Tests_SRS_OPTIONHANDLER_01_013: [ Otherwise OptionHandler_CreateWithKeys shall behave as OptionHandler_Create and also remember getOptionKey and setOptionByKey. ]*/
+    TEST_FUNCTION(OptionHandler_CreateWithKeys_happy_path)
+    {
+        ///arrange
+        OPTIONHANDLER_HANDLE h;
+        OptionHandler_Create_inert_path();
+
+        ///act
+        h = OptionHandler_CreateWithKeys(aCloneOption, aDestroyOption, aSetOption, aGetOptionKey, aSetOptionByKey);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(h);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        OptionHandler_Destroy(h);
+    }
+
     /* OptionHandler_Clone */
 
     /* Tests_SRS_OPTIONHANDLER_01_010: [ If handler is NULL, OptionHandler_Clone shall fail and return NULL. ]*/
@@ -289,7 +345,7 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
     /* Tests_SRS_OPTIONHANDLER_01_001: [ OptionHandler_Clone shall clone an existing option handler instance. ]*/
     /* Tests_SRS_OPTIONHANDLER_01_002: [ On success it shall return a non-NULL handle. ]*/
     /* Tests_SRS_OPTIONHANDLER_01_003: [ OptionHandler_Clone shall allocate memory for the new option handler instance. ]*/
-    /* Tests_SRS_OPTIONHANDLER_01_005: [ OptionHandler_Clone shall iterate through all the options stored by the option handler to be cloned by using VECTOR's iteration mechanism. ]*/
+    /* Tests_SRS_OPTIONHANDLER_01_005: [ OptionHandler_Clone shall iterate through all the options stored by the option handler to be cloned. ]*/
     TEST_FUNCTION(OptionHandler_Clone_clones_an_instance_with_no_options)
     {
         ///arrange
@@ -301,10 +357,6 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument_size();
-        STRICT_EXPECTED_CALL(VECTOR_create(IGNORED_NUM_ARG))
-            .IgnoreArgument_elementSize();
-        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
 
         ///act
         result = OptionHandler_Clone(source);
@@ -321,8 +373,9 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
     /* Tests_SRS_OPTIONHANDLER_01_001: [ OptionHandler_Clone shall clone an existing option handler instance. ]*/
     /* Tests_SRS_OPTIONHANDLER_01_002: [ On success it shall return a non-NULL handle. ]*/
     /* Tests_SRS_OPTIONHANDLER_01_003: [ OptionHandler_Clone shall allocate memory for the new option handler instance. ]*/
-    /* Tests_SRS_OPTIONHANDLER_01_005: [ OptionHandler_Clone shall iterate through all the options stored by the option handler to be cloned by using VECTOR's iteration mechanism. ]*/
-    /* Tests_SRS_OPTIONHANDLER_01_006: [ For each option the option name shall be cloned by calling mallocAndStrcpy_s. ]*/
+    /* Tests_SRS_OPTIONHANDLER_01_014: [ OptionHandler_Clone shall allocate in one step an array large enough for all the options of handler. ]*/
+    /* Tests_SRS_OPTIONHANDLER_01_005: [ OptionHandler_Clone shall iterate through all the options stored by the option handler to be cloned. ]*/
+    /* Tests_SRS_OPTIONHANDLER_01_006: [ For each option the option name shall be cloned by calling string_intern_clone. ]*/
     /* Tests_SRS_OPTIONHANDLER_01_007: [ For each option the value shall be cloned by using the cloning function associated with the source option handler handler. ]*/
     TEST_FUNCTION(OptionHandler_Clone_clones_an_instance_with_one_option)
     {
@@ -336,19 +389,11 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument_size();
-        STRICT_EXPECTED_CALL(VECTOR_create(IGNORED_NUM_ARG))
-            .IgnoreArgument_elementSize();
-        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "TrustedCerts"))
-            .IgnoreArgument_destination();
+        STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+            .IgnoreArgument_size();
+        STRICT_EXPECTED_CALL(string_intern_clone("TrustedCerts"));
         STRICT_EXPECTED_CALL(aCloneOption("TrustedCerts", IGNORED_PTR_ARG))
             .IgnoreArgument_value();
-        STRICT_EXPECTED_CALL(VECTOR_push_back(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_elements();
 
         ///act
         result = OptionHandler_Clone(source);
@@ -365,8 +410,9 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
     /* Tests_SRS_OPTIONHANDLER_01_001: [ OptionHandler_Clone shall clone an existing option handler instance. ]*/
     /* Tests_SRS_OPTIONHANDLER_01_002: [ On success it shall return a non-NULL handle. ]*/
     /* Tests_SRS_OPTIONHANDLER_01_003: [ OptionHandler_Clone shall allocate memory for the new option handler instance. ]*/
-    /* Tests_SRS_OPTIONHANDLER_01_005: [ OptionHandler_Clone shall iterate through all the options stored by the option handler to be cloned by using VECTOR's iteration mechanism. ]*/
-    /* Tests_SRS_OPTIONHANDLER_01_006: [ For each option the option name shall be cloned by calling mallocAndStrcpy_s. ]*/
+    /* Tests_SRS_OPTIONHANDLER_01_014: [ OptionHandler_Clone shall allocate in one step an array large enough for all the options of handler. ]*/
+    /* Tests_SRS_OPTIONHANDLER_01_005: [ OptionHandler_Clone shall iterate through all the options stored by the option handler to be cloned. ]*/
+    /* Tests_SRS_OPTIONHANDLER_01_006: [ For each option the option name shall be cloned by calling string_intern_clone. ]*/
     /* Tests_SRS_OPTIONHANDLER_01_007: [ For each option the value shall be cloned by using the cloning function associated with the source option handler handler. ]*/
     TEST_FUNCTION(OptionHandler_Clone_clones_an_instance_with_2_options)
     {
@@ -381,30 +427,16 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument_size();
-        STRICT_EXPECTED_CALL(VECTOR_create(IGNORED_NUM_ARG))
-            .IgnoreArgument_elementSize();
-        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "TrustedCerts"))
-            .IgnoreArgument_destination();
+        STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+            .IgnoreArgument_size();
+
+        STRICT_EXPECTED_CALL(string_intern_clone("TrustedCerts"));
         STRICT_EXPECTED_CALL(aCloneOption("TrustedCerts", IGNORED_PTR_ARG))
             .IgnoreArgument_value();
-        STRICT_EXPECTED_CALL(VECTOR_push_back(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_elements();
-
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 1))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "option_2"))
-            .IgnoreArgument_destination();
+
+        STRICT_EXPECTED_CALL(string_intern_clone("option_2"));
         STRICT_EXPECTED_CALL(aCloneOption("option_2", IGNORED_PTR_ARG))
             .IgnoreArgument_value();
-        STRICT_EXPECTED_CALL(VECTOR_push_back(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_elements();
 
         ///act
         result = OptionHandler_Clone(source);
@@ -418,35 +450,46 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
         OptionHandler_Destroy(result);
     }
 
-    /* Tests_SRS_OPTIONHANDLER_01_004: [ If allocating memory fails, OptionHandler_Clone shall return NULL. ]*/
-    TEST_FUNCTION(when_allocating_memory_for_the_cloned_option_handler_fails_OptionHandler_Clone_fails)
+    /* Tests_SRS_OPTIONHANDLER_01_015: [ The key of each option shall be copied from handler, without calling getOptionKey. ]*/
+    TEST_FUNCTION(OptionHandler_Clone_copies_the_option_keys)
     {
         ///arrange
         OPTIONHANDLER_HANDLE source;
         OPTIONHANDLER_HANDLE result;
+        OPTIONHANDLER_RESULT feed_result;
 
-        source = OptionHandler_Create(aCloneOption, aDestroyOption, aSetOption);
-        (void)OptionHandler_AddOption(source, "TrustedCerts", "xxx");
-        (void)OptionHandler_AddOption(source, "option_2", "y");
+        source = OptionHandler_CreateWithKeys(aCloneOption, aDestroyOption, aSetOption, aGetOptionKey, aSetOptionByKey);
+        STRICT_EXPECTED_CALL(aGetOptionKey("a"))
+            .SetReturn(7);
+        (void)OptionHandler_AddOption(source, "a", "b");
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument_size()
-            .SetReturn(NULL);
+            .IgnoreArgument_size();
+        STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+            .IgnoreArgument_size();
+        STRICT_EXPECTED_CALL(string_intern_clone("a"));
+        STRICT_EXPECTED_CALL(aCloneOption("a", IGNORED_PTR_ARG))
+            .IgnoreArgument_value();
+        STRICT_EXPECTED_CALL(aSetOptionByKey((void*)42, 7, "a", IGNORED_PTR_ARG))
+            .IgnoreArgument_value();
 
         ///act
         result = OptionHandler_Clone(source);
+        feed_result = OptionHandler_FeedOptions(result, (void*)42);
 
         ///assert
-        ASSERT_IS_NULL(result);
+        ASSERT_IS_NOT_NULL(result);
+        ASSERT_ARE_EQUAL(OPTIONHANDLER_RESULT, OPTIONHANDLER_OK, feed_result);
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
         OptionHandler_Destroy(source);
+        OptionHandler_Destroy(result);
     }
 
     /* Tests_SRS_OPTIONHANDLER_01_004: [ If allocating memory fails, OptionHandler_Clone shall return NULL. ]*/
-    TEST_FUNCTION(when_creating_the_vector_fails_OptionHandler_Clone_fails)
+    TEST_FUNCTION(when_allocating_memory_for_the_cloned_option_handler_fails_OptionHandler_Clone_fails)
     {
         ///arrange
         OPTIONHANDLER_HANDLE source;
@@ -458,11 +501,8 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
         umock_c_reset_all_calls();
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument_size();
-        STRICT_EXPECTED_CALL(VECTOR_create(IGNORED_NUM_ARG))
-            .IgnoreArgument_elementSize()
+            .IgnoreArgument_size()
             .SetReturn(NULL);
-        EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
         ///act
         result = OptionHandler_Clone(source);
@@ -475,8 +515,8 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
         OptionHandler_Destroy(source);
     }
 
-    /* Tests_SRS_OPTIONHANDLER_01_008: [ If cloning one of the option names fails, OptionHandler_Clone shall return NULL. ]*/
-    TEST_FUNCTION(when_cloning_the_first_option_name_fails_OptionHandler_Clone_fails)
+    /* Tests_SRS_OPTIONHANDLER_01_011: [ If allocating the array for the cloned options fails, OptionHandler_Clone shall return NULL. ]*/
+    TEST_FUNCTION(when_allocating_the_option_array_fails_OptionHandler_Clone_fails)
     {
         ///arrange
         OPTIONHANDLER_HANDLE source;
@@ -489,20 +529,10 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument_size();
-        STRICT_EXPECTED_CALL(VECTOR_create(IGNORED_NUM_ARG))
-            .IgnoreArgument_elementSize();
-        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "TrustedCerts"))
-            .IgnoreArgument_destination()
-            .SetReturn(1);
-
-        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-        EXPECTED_CALL(VECTOR_destroy(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+            .IgnoreArgument_size()
+            .SetReturn(NULL);
+        EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
         EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
         ///act
@@ -516,8 +546,8 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
         OptionHandler_Destroy(source);
     }
 
-    /* Tests_SRS_OPTIONHANDLER_01_009: [ If cloning one of the option values fails, OptionHandler_Clone shall return NULL. ]*/
-    TEST_FUNCTION(when_cloning_the_first_option_value_fails_OptionHandler_Clone_fails)
+    /* Tests_SRS_OPTIONHANDLER_01_008: [ If cloning one of the option names fails, OptionHandler_Clone shall return NULL. ]*/
+    TEST_FUNCTION(when_cloning_the_first_option_name_fails_OptionHandler_Clone_fails)
     {
         ///arrange
         OPTIONHANDLER_HANDLE source;
@@ -530,23 +560,13 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument_size();
-        STRICT_EXPECTED_CALL(VECTOR_create(IGNORED_NUM_ARG))
-            .IgnoreArgument_elementSize();
-        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "TrustedCerts"))
-            .IgnoreArgument_destination();
-        STRICT_EXPECTED_CALL(aCloneOption("TrustedCerts", IGNORED_PTR_ARG))
-            .IgnoreArgument_value()
+        STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+            .IgnoreArgument_size();
+
+        STRICT_EXPECTED_CALL(string_intern_clone("TrustedCerts"))
             .SetReturn(NULL);
 
         EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-        EXPECTED_CALL(VECTOR_destroy(IGNORED_PTR_ARG));
         EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
         ///act
@@ -560,8 +580,8 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
         OptionHandler_Destroy(source);
     }
 
-    /* Tests_SRS_OPTIONHANDLER_01_011: [ When adding one of the newly cloned options to the option handler storage vector fails, OptionHandler_Clone shall return NULL. ]*/
-    TEST_FUNCTION(when_adding_the_first_cloned_option_fails_OptionHandler_Clone_fails)
+    /* Tests_SRS_OPTIONHANDLER_01_009: [ If cloning one of the option values fails, OptionHandler_Clone shall return NULL. ]*/
+    TEST_FUNCTION(when_cloning_the_first_option_value_fails_OptionHandler_Clone_fails)
     {
         ///arrange
         OPTIONHANDLER_HANDLE source;
@@ -574,27 +594,16 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument_size();
-        STRICT_EXPECTED_CALL(VECTOR_create(IGNORED_NUM_ARG))
-            .IgnoreArgument_elementSize();
-        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "TrustedCerts"))
-            .IgnoreArgument_destination();
+        STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+            .IgnoreArgument_size();
+
+        STRICT_EXPECTED_CALL(string_intern_clone("TrustedCerts"));
         STRICT_EXPECTED_CALL(aCloneOption("TrustedCerts", IGNORED_PTR_ARG))
-            .IgnoreArgument_value();
-        STRICT_EXPECTED_CALL(VECTOR_push_back(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_elements()
-            .SetReturn(1);
+            .IgnoreArgument_value()
+            .SetReturn(NULL);
 
-        EXPECTED_CALL(aDestroyOption("TrustedCerts", IGNORED_PTR_ARG));
+        EXPECTED_CALL(string_intern_release(IGNORED_PTR_ARG));
         EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-        EXPECTED_CALL(VECTOR_destroy(IGNORED_PTR_ARG));
         EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
         ///act
@@ -622,34 +631,19 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument_size();
-        STRICT_EXPECTED_CALL(VECTOR_create(IGNORED_NUM_ARG))
-            .IgnoreArgument_elementSize();
-        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "TrustedCerts"))
-            .IgnoreArgument_destination();
+        STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+            .IgnoreArgument_size();
+
+        STRICT_EXPECTED_CALL(string_intern_clone("TrustedCerts"));
         STRICT_EXPECTED_CALL(aCloneOption("TrustedCerts", IGNORED_PTR_ARG))
             .IgnoreArgument_value();
-        STRICT_EXPECTED_CALL(VECTOR_push_back(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_elements();
-
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 1))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "option_2"))
-            .IgnoreArgument_destination()
-            .SetReturn(1);
 
-        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0))
-            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(string_intern_clone("option_2"))
+            .SetReturn(NULL);
+
         EXPECTED_CALL(aDestroyOption("TrustedCerts", IGNORED_PTR_ARG));
+        EXPECTED_CALL(string_intern_release(IGNORED_PTR_ARG));
         EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-        EXPECTED_CALL(VECTOR_destroy(IGNORED_PTR_ARG));
         EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
         ///act
@@ -677,99 +671,22 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
 
         STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
             .IgnoreArgument_size();
-        STRICT_EXPECTED_CALL(VECTOR_create(IGNORED_NUM_ARG))
-            .IgnoreArgument_elementSize();
-        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "TrustedCerts"))
-            .IgnoreArgument_destination();
+        STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+            .IgnoreArgument_size();
+
+        STRICT_EXPECTED_CALL(string_intern_clone("TrustedCerts"));
         STRICT_EXPECTED_CALL(aCloneOption("TrustedCerts", IGNORED_PTR_ARG))
             .IgnoreArgument_value();
-        STRICT_EXPECTED_CALL(VECTOR_push_back(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_elements();
-
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 1))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "option_2"))
-            .IgnoreArgument_destination();
+
+        STRICT_EXPECTED_CALL(string_intern_clone("option_2"));
         STRICT_EXPECTED_CALL(aCloneOption("option_2", IGNORED_PTR_ARG))
             .IgnoreArgument_value()
             .SetReturn(NULL);
 
-        EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0))
-            .IgnoreArgument_handle();
+        EXPECTED_CALL(string_intern_release(IGNORED_PTR_ARG));
         EXPECTED_CALL(aDestroyOption("TrustedCerts", IGNORED_PTR_ARG));
+        EXPECTED_CALL(string_intern_release(IGNORED_PTR_ARG));
         EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-        EXPECTED_CALL(VECTOR_destroy(IGNORED_PTR_ARG));
-        EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-
-        ///act
-        result = OptionHandler_Clone(source);
-
-        ///assert
-        ASSERT_IS_NULL(result);
-        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-        ///cleanup
-        OptionHandler_Destroy(source);
-    }
-
-    /* Tests_SRS_OPTIONHANDLER_01_011: [ When adding one of the newly cloned options to the option handler storage vector fails, OptionHandler_Clone shall return NULL. ]*/
-    TEST_FUNCTION(when_adding_the_2nd_cloned_option_fails_OptionHandler_Clone_fails)
-    {
-        ///arrange
-        OPTIONHANDLER_HANDLE source;
-        OPTIONHANDLER_HANDLE result;
-
-        source = OptionHandler_Create(aCloneOption, aDestroyOption, aSetOption);
-        (void)OptionHandler_AddOption(source, "TrustedCerts", "xxx");
-        (void)OptionHandler_AddOption(source, "option_2", "y");
-        umock_c_reset_all_calls();
-
-        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
-            .IgnoreArgument_size();
-        STRICT_EXPECTED_CALL(VECTOR_create(IGNORED_NUM_ARG))
-            .IgnoreArgument_elementSize();
-        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "TrustedCerts"))
-            .IgnoreArgument_destination();
-        STRICT_EXPECTED_CALL(aCloneOption("TrustedCerts", IGNORED_PTR_ARG))
-            .IgnoreArgument_value();
-        STRICT_EXPECTED_CALL(VECTOR_push_back(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_elements();
-
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 1))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "option_2"))
-            .IgnoreArgument_destination();
-        STRICT_EXPECTED_CALL(aCloneOption("option_2", IGNORED_PTR_ARG))
-            .IgnoreArgument_value();
-        STRICT_EXPECTED_CALL(VECTOR_push_back(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_elements()
-            .SetReturn(1);
-
-        EXPECTED_CALL(aDestroyOption("option_2", IGNORED_PTR_ARG));
-        EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0))
-            .IgnoreArgument_handle();
-        EXPECTED_CALL(aDestroyOption("TrustedCerts", IGNORED_PTR_ARG));
-        EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-        EXPECTED_CALL(VECTOR_destroy(IGNORED_PTR_ARG));
         EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
         ///act
@@ -833,17 +750,15 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
 
     void OptionHandler_AddOption_inert_path(void* value)
     {
-        STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "name"))
-            .IgnoreArgument_destination();
+        STRICT_EXPECTED_CALL(string_intern("name"));
         STRICT_EXPECTED_CALL(aCloneOption("name", value))
             .IgnoreAllArguments();
-        STRICT_EXPECTED_CALL(VECTOR_push_back(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1))
-            .IgnoreArgument_handle()
-            .IgnoreArgument_elements();
+        STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+            .IgnoreArgument_size();
     }
 
     /*Tests_SRS_OPTIONHANDLER_02_006: [ OptionHandler_AddOption shall call pfCloneOption passing name and value. ]*/
-    /*Tests_SRS_OPTIONHANDLER_02_007: [ OptionHandler_AddOption shall use VECTOR APIs to save the name and the newly created clone of value. ]*/
+    /*Tests_SRS_OPTIONHANDLER_02_007: [ OptionHandler_AddOption shall save the name, the key and the newly created clone of value in its array of options, growing the array when it is full. ]*/
     /*Tests_SRS_OPTIONHANDLER_02_008: [ If all the operations succed then OptionHandler_AddOption shall succeed and return OPTIONHANDLER_OK. ]*/
     TEST_FUNCTION(OptionHandler_AddOption_happy_path)
     {
@@ -864,6 +779,63 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
         OptionHandler_Destroy(handle);
     }
 
+    /*Tests_SRS_OPTIONHANDLER_02_007: [ OptionHandler_AddOption shall save the name, the key and the newly created clone of value in its array of options, growing the array when it is full. ]*/
+    TEST_FUNCTION(OptionHandler_AddOption_grows_the_array_only_when_it_is_full)
+    {
+        ///arrange
+        OPTIONHANDLER_RESULT result;
+        OPTIONHANDLER_HANDLE handle = OptionHandler_Create(aCloneOption, aDestroyOption, aSetOption);
+
+        (void)OptionHandler_AddOption(handle, "a", "b");
+        (void)OptionHandler_AddOption(handle, "c", "d");
+        (void)OptionHandler_AddOption(handle, "e", "f");
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(string_intern("g"));
+        STRICT_EXPECTED_CALL(aCloneOption("g", IGNORED_PTR_ARG))
+            .IgnoreArgument_value();
+        STRICT_EXPECTED_CALL(string_intern("i"));
+        STRICT_EXPECTED_CALL(aCloneOption("i", IGNORED_PTR_ARG))
+            .IgnoreArgument_value();
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+            .IgnoreAllArguments();
+
+        ///act
+        (void)OptionHandler_AddOption(handle, "g", "h");
+        result = OptionHandler_AddOption(handle, "i", "j");
+
+        ///assert
+        ASSERT_ARE_EQUAL(OPTIONHANDLER_RESULT, OPTIONHANDLER_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        OptionHandler_Destroy(handle);
+    }
+
+    /*Tests_SRS_OPTIONHANDLER_01_016: [ If the handler was created with OptionHandler_CreateWithKeys, OptionHandler_AddOption shall call getOptionKey passing name to get the key of the option. ]*/
+    TEST_FUNCTION(OptionHandler_AddOption_with_keys_gets_the_option_key)
+    {
+        ///arrange
+        OPTIONHANDLER_RESULT result;
+        OPTIONHANDLER_HANDLE handle = OptionHandler_CreateWithKeys(aCloneOption, aDestroyOption, aSetOption, aGetOptionKey, aSetOptionByKey);
+        void* value = "value";
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(aGetOptionKey("name"))
+            .SetReturn(3);
+        OptionHandler_AddOption_inert_path(value);
+
+        ///act
+        result = OptionHandler_AddOption(handle, "name", value);
+
+        ///assert
+        ASSERT_ARE_EQUAL(OPTIONHANDLER_RESULT, OPTIONHANDLER_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        OptionHandler_Destroy(handle);
+    }
+
     /*Tests_SRS_OPTIONHANDLER_02_009: [ Otherwise, OptionHandler_AddOption shall succeed and return OPTIONHANDLER_ERROR. ]*/
     /*Tests_SRS_OPTIONHANDLER_02_008: [ If all the operations succed then OptionHandler_AddOption shall succeed and return OPTIONHANDLER_OK. ]*/
     TEST_FUNCTION(OptionHandler_AddOption_unhappy_path)
@@ -937,8 +909,7 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
         OptionHandler_Destroy(handle);
     }
 
-    /*Tests_SRS_OPTIONHANDLER_02_011: [ Otherwise, OptionHandler_FeedOptions shall use VECTOR's iteration mechanisms to retrieve pairs of name, value (const char* and void*). ]*/
-    /*Tests_SRS_OPTIONHANDLER_02_012: [ OptionHandler_FeedOptions shall call for every pair of name,value setOption passing destinationHandle, name and value. ]*/
+    /*Tests_SRS_OPTIONHANDLER_02_011: [ Otherwise, OptionHandler_FeedOptions shall iterate through the stored options in the order they were added. ]*/
     /*Tests_SRS_OPTIONHANDLER_02_013: [ If all the operations succeed then OptionHandler_FeedOptions shall succeed and return OPTIONHANDLER_OK. ]*/
     TEST_FUNCTION(OptionHandler_FeedOptions_with_0_saved_options_feeds_0_succeeds)
     {
@@ -947,9 +918,6 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
         OPTIONHANDLER_HANDLE handle = OptionHandler_Create(aCloneOption, aDestroyOption, aSetOption);
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG)) /*will return 0, so nothing else happens*/
-            .IgnoreArgument_handle();
-
         ///act
         result = OptionHandler_FeedOptions(handle, (void*)42);
 
@@ -963,16 +931,12 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
 
     static void OptionHandler_FeedOptions_with_1_saved_options_feeds_1_inert_path(void)
     {
-        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG)) /*will return 0, so nothing else happens*/
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0))
-            .IgnoreArgument_handle();
         STRICT_EXPECTED_CALL(aSetOption((void*)42, "a", IGNORED_PTR_ARG))
             .IgnoreArgument_value();
     }
 
-    /*Tests_SRS_OPTIONHANDLER_02_011: [ Otherwise, OptionHandler_FeedOptions shall use VECTOR's iteration mechanisms to retrieve pairs of name, value (const char* and void*). ]*/
-    /*Tests_SRS_OPTIONHANDLER_02_012: [ OptionHandler_FeedOptions shall call for every pair of name,value setOption passing destinationHandle, name and value. ]*/
+    /*Tests_SRS_OPTIONHANDLER_02_011: [ Otherwise, OptionHandler_FeedOptions shall iterate through the stored options in the order they were added. ]*/
+    /*Tests_SRS_OPTIONHANDLER_02_012: [ OptionHandler_FeedOptions shall call for every other pair of name,value setOption passing destinationHandle, name and value. ]*/
     /*Tests_SRS_OPTIONHANDLER_02_013: [ If all the operations succeed then OptionHandler_FeedOptions shall succeed and return OPTIONHANDLER_OK. ]*/
     TEST_FUNCTION(OptionHandler_FeedOptions_with_1_saved_options_feeds_1_happypath)
     {
@@ -1000,11 +964,6 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
     {
         ///arrange
         size_t i;
-        size_t calls_that_cannot_fail[] =
-        {
-            0,
-            1,
-        };
         OPTIONHANDLER_HANDLE handle;
 
         int negativeTestsInitResult = umock_c_negative_tests_init();
@@ -1021,22 +980,8 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
         for (i = 0; i < umock_c_negative_tests_call_count(); i++)
         {
             char temp_str[128];
-            size_t j;
             OPTIONHANDLER_RESULT result;
 
-            for (j = 0;j < sizeof(calls_that_cannot_fail) / sizeof(calls_that_cannot_fail[0]);j++)
-            {
-                if (calls_that_cannot_fail[j] == i)
-                {
-                    break;
-                }
-            }
-
-            if (j != sizeof(calls_that_cannot_fail) / sizeof(calls_that_cannot_fail[0]))
-            {
-                continue; //just go to the next call that might be failed.
-            }
-
             umock_c_negative_tests_reset();
             umock_c_negative_tests_fail_call(i);
 
@@ -1058,21 +1003,14 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
 
     static void OptionHandler_FeedOptions_with_2_saved_options_feeds_2_inert_path(void)
     {
-        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG)) /*will return 0, so nothing else happens*/
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0))
-            .IgnoreArgument_handle();
         STRICT_EXPECTED_CALL(aSetOption((void*)42, "a", IGNORED_PTR_ARG))
             .IgnoreArgument_value();
-
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 1))
-            .IgnoreArgument_handle();
         STRICT_EXPECTED_CALL(aSetOption((void*)42, "c", IGNORED_PTR_ARG))
             .IgnoreArgument_value();
     }
 
-    /*Tests_SRS_OPTIONHANDLER_02_011: [ Otherwise, OptionHandler_FeedOptions shall use VECTOR's iteration mechanisms to retrieve pairs of name, value (const char* and void*). ]*/
-    /*Tests_SRS_OPTIONHANDLER_02_012: [ OptionHandler_FeedOptions shall call for every pair of name,value setOption passing destinationHandle, name and value. ]*/
+    /*Tests_SRS_OPTIONHANDLER_02_011: [ Otherwise, OptionHandler_FeedOptions shall iterate through the stored options in the order they were added. ]*/
+    /*Tests_SRS_OPTIONHANDLER_02_012: [ OptionHandler_FeedOptions shall call for every other pair of name,value setOption passing destinationHandle, name and value. ]*/
     /*Tests_SRS_OPTIONHANDLER_02_013: [ If all the operations succeed then OptionHandler_FeedOptions shall succeed and return OPTIONHANDLER_OK. ]*/
     TEST_FUNCTION(OptionHandler_FeedOptions_with_2_saved_options_feeds_2_happypath)
     {
@@ -1102,12 +1040,6 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
     {
         ///arrange
         OPTIONHANDLER_HANDLE handle;
-        size_t calls_that_cannot_fail[] =
-        {
-            0,
-            1,
-            3,
-        };
         size_t i;
         int negativeTestsInitResult = umock_c_negative_tests_init();
         ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
@@ -1124,22 +1056,8 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
         for (i = 0; i < umock_c_negative_tests_call_count(); i++)
         {
             char temp_str[128];
-            size_t j;
             OPTIONHANDLER_RESULT result;
 
-            for (j = 0;j < sizeof(calls_that_cannot_fail) / sizeof(calls_that_cannot_fail[0]);j++)
-            {
-                if (calls_that_cannot_fail[j] == i)
-                {
-                    break;
-                }
-            }
-
-            if (j != sizeof(calls_that_cannot_fail) / sizeof(calls_that_cannot_fail[0]))
-            {
-                continue; //just go to the next call that might be failed.
-            }
-
             umock_c_negative_tests_reset();
             umock_c_negative_tests_fail_call(i);
 
@@ -1158,6 +1076,205 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
         umock_c_negative_tests_deinit();
     }
 
+    /*Tests_SRS_OPTIONHANDLER_01_017: [ For every option that has a key OptionHandler_FeedOptions shall call setOptionByKey passing destinationHandle, the key, name and value. ]*/
+    /*Tests_SRS_OPTIONHANDLER_02_012: [ OptionHandler_FeedOptions shall call for every other pair of name,value setOption passing destinationHandle, name and value. ]*/
+    TEST_FUNCTION(OptionHandler_FeedOptions_with_keys_feeds_the_options_with_a_key_by_key)
+    {
+        ///arrange
+        OPTIONHANDLER_HANDLE handle = OptionHandler_CreateWithKeys(aCloneOption, aDestroyOption, aSetOption, aGetOptionKey, aSetOptionByKey);
+        OPTIONHANDLER_RESULT result;
+
+        STRICT_EXPECTED_CALL(aGetOptionKey("a"))
+            .SetReturn(0);
+        (void)OptionHandler_AddOption(handle, "a", "b");
+        STRICT_EXPECTED_CALL(aGetOptionKey("c"))
+            .SetReturn(OPTIONHANDLER_NO_KEY);
+        (void)OptionHandler_AddOption(handle, "c", "b2");
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(aSetOptionByKey((void*)42, 0, "a", IGNORED_PTR_ARG))
+            .IgnoreArgument_value();
+        STRICT_EXPECTED_CALL(aSetOption((void*)42, "c", IGNORED_PTR_ARG))
+            .IgnoreArgument_value();
+
+        ///act
+        result = OptionHandler_FeedOptions(handle, (void*)42);
+
+        ///assert
+        ASSERT_ARE_EQUAL(OPTIONHANDLER_RESULT, OPTIONHANDLER_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        OptionHandler_Destroy(handle);
+    }
+
+    /*Tests_SRS_OPTIONHANDLER_02_014: [ Otherwise, OptionHandler_FeedOptions shall fail and return OPTIONHANDLER_ERROR. ]*/
+    TEST_FUNCTION(when_setOptionByKey_fails_OptionHandler_FeedOptions_fails)
+    {
+        ///arrange
+        OPTIONHANDLER_HANDLE handle = OptionHandler_CreateWithKeys(aCloneOption, aDestroyOption, aSetOption, aGetOptionKey, aSetOptionByKey);
+        OPTIONHANDLER_RESULT result;
+
+        STRICT_EXPECTED_CALL(aGetOptionKey("a"))
+            .SetReturn(1);
+        (void)OptionHandler_AddOption(handle, "a", "b");
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(aSetOptionByKey((void*)42, 1, "a", IGNORED_PTR_ARG))
+            .IgnoreArgument_value()
+            .SetReturn(1);
+
+        ///act
+        result = OptionHandler_FeedOptions(handle, (void*)42);
+
+        ///assert
+        ASSERT_ARE_EQUAL(OPTIONHANDLER_RESULT, OPTIONHANDLER_ERROR, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        OptionHandler_Destroy(handle);
+    }
+
+    /* OptionHandler_AddSharedOption */
+
+    /*Tests_SRS_OPTIONHANDLER_01_018: [ OptionHandler_AddSharedOption shall fail and return OPTIONHANDLER_INVALIDARG if any parameter is NULL. ]*/
+    TEST_FUNCTION(OptionHandler_AddSharedOption_with_NULL_value_fails)
+    {
+        ///arrange
+        OPTIONHANDLER_HANDLE handle = OptionHandler_Create(aCloneOption, aDestroyOption, aSetOption);
+        umock_c_reset_all_calls();
+
+        ///act
+        OPTIONHANDLER_RESULT result = OptionHandler_AddSharedOption(handle, "name", NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(OPTIONHANDLER_RESULT, OPTIONHANDLER_INVALIDARG, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        OptionHandler_Destroy(handle);
+    }
+
+    /*Tests_SRS_OPTIONHANDLER_01_020: [ OptionHandler_AddSharedOption shall take a reference on value by calling CONSTBUFFER_IncRef instead of calling pfCloneOption, and save it with the name and the key of the option. ]*/
+    /*Tests_SRS_OPTIONHANDLER_01_021: [ If all the operations succeed then OptionHandler_AddSharedOption shall succeed and return OPTIONHANDLER_OK. ]*/
+    TEST_FUNCTION(OptionHandler_AddSharedOption_takes_a_reference_instead_of_cloning)
+    {
+        ///arrange
+        OPTIONHANDLER_RESULT result;
+        OPTIONHANDLER_HANDLE handle = OptionHandler_Create(aCloneOption, aDestroyOption, aSetOption);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(string_intern("name"));
+        STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+            .IgnoreArgument_size();
+        STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_SHARED_VALUE));
+        STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_SHARED_VALUE));
+
+        ///act
+        result = OptionHandler_AddSharedOption(handle, "name", TEST_SHARED_VALUE);
+
+        ///assert
+        ASSERT_ARE_EQUAL(OPTIONHANDLER_RESULT, OPTIONHANDLER_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        OptionHandler_Destroy(handle);
+    }
+
+    /*Tests_SRS_OPTIONHANDLER_01_022: [ If any failure is encountered, OptionHandler_AddSharedOption shall fail and return OPTIONHANDLER_ERROR. ]*/
+    TEST_FUNCTION(when_cloning_the_name_fails_OptionHandler_AddSharedOption_fails)
+    {
+        ///arrange
+        OPTIONHANDLER_RESULT result;
+        OPTIONHANDLER_HANDLE handle = OptionHandler_Create(aCloneOption, aDestroyOption, aSetOption);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(string_intern("name"))
+            .SetReturn(NULL);
+
+        ///act
+        result = OptionHandler_AddSharedOption(handle, "name", TEST_SHARED_VALUE);
+
+        ///assert
+        ASSERT_ARE_EQUAL(OPTIONHANDLER_RESULT, OPTIONHANDLER_ERROR, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        OptionHandler_Destroy(handle);
+    }
+
+    /*Tests_SRS_OPTIONHANDLER_01_019: [ If the handler was created with OptionHandler_CreateWithKeys, OptionHandler_AddSharedOption shall call getOptionKey passing name to get the key of the option. ]*/
+    TEST_FUNCTION(OptionHandler_FeedOptions_feeds_the_content_of_a_shared_option)
+    {
+        ///arrange
+        OPTIONHANDLER_RESULT result;
+        OPTIONHANDLER_HANDLE handle = OptionHandler_CreateWithKeys(aCloneOption, aDestroyOption, aSetOption, aGetOptionKey, aSetOptionByKey);
+
+        STRICT_EXPECTED_CALL(aGetOptionKey("name"))
+            .SetReturn(3);
+        (void)OptionHandler_AddSharedOption(handle, "name", TEST_SHARED_VALUE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(aSetOptionByKey((void*)42, 3, "name", TEST_SHARED_VALUE_CONTENT));
+
+        ///act
+        result = OptionHandler_FeedOptions(handle, (void*)42);
+
+        ///assert
+        ASSERT_ARE_EQUAL(OPTIONHANDLER_RESULT, OPTIONHANDLER_OK, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        OptionHandler_Destroy(handle);
+    }
+
+    /*Tests_SRS_OPTIONHANDLER_01_023: [ The options added by OptionHandler_AddSharedOption shall be shared with the clone by calling CONSTBUFFER_IncRef. ]*/
+    TEST_FUNCTION(OptionHandler_Clone_shares_the_shared_options)
+    {
+        ///arrange
+        OPTIONHANDLER_HANDLE result;
+        OPTIONHANDLER_HANDLE handle = OptionHandler_Create(aCloneOption, aDestroyOption, aSetOption);
+        (void)OptionHandler_AddSharedOption(handle, "name", TEST_SHARED_VALUE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(string_intern_clone("name"));
+        STRICT_EXPECTED_CALL(CONSTBUFFER_IncRef(TEST_SHARED_VALUE));
+        STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(TEST_SHARED_VALUE));
+
+        ///act
+        result = OptionHandler_Clone(handle);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        OptionHandler_Destroy(handle);
+        OptionHandler_Destroy(result);
+    }
+
+    /*Tests_SRS_OPTIONHANDLER_01_024: [ OptionHandler_Destroy shall release the options added by OptionHandler_AddSharedOption by calling CONSTBUFFER_DecRef instead of pfDestroyOption. ]*/
+    TEST_FUNCTION(OptionHandler_Destroy_releases_the_shared_options)
+    {
+        ///arrange
+        OPTIONHANDLER_HANDLE handle = OptionHandler_Create(aCloneOption, aDestroyOption, aSetOption);
+        (void)OptionHandler_AddSharedOption(handle, "name", TEST_SHARED_VALUE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(CONSTBUFFER_DecRef(TEST_SHARED_VALUE));
+        STRICT_EXPECTED_CALL(string_intern_release(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+        ///act
+        OptionHandler_Destroy(handle);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
     /* OptionHandler_Destroy */
 
     /*Tests_SRS_OPTIONHANDLER_02_015: [ OptionHandler_Destroy shall do nothing if parameter handle is NULL. ]*/
@@ -1183,24 +1300,16 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
         (void)OptionHandler_AddOption(handle, "c", "b2");
         umock_c_reset_all_calls();
 
-        STRICT_EXPECTED_CALL(VECTOR_size(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 0))
-            .IgnoreArgument_handle();
         STRICT_EXPECTED_CALL(aDestroyOption("a", IGNORED_PTR_ARG))
             .IgnoreArgument_value();
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument_ptr();
+        STRICT_EXPECTED_CALL(string_intern_release("a"));
 
-        STRICT_EXPECTED_CALL(VECTOR_element(IGNORED_PTR_ARG, 1))
-            .IgnoreArgument_handle();
         STRICT_EXPECTED_CALL(aDestroyOption("c", IGNORED_PTR_ARG))
             .IgnoreArgument_value();
-        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
-            .IgnoreArgument_ptr();
+        STRICT_EXPECTED_CALL(string_intern_release("c"));
 
-        STRICT_EXPECTED_CALL(VECTOR_destroy(IGNORED_PTR_ARG))
-            .IgnoreArgument_handle();
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)) /*the array of options*/
+            .IgnoreArgument_ptr();
 
         STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
             .IgnoreArgument_ptr();
@@ -1215,5 +1324,3 @@ BEGIN_TEST_SUITE(optionhandler_unittests)
     }
 
 END_TEST_SUITE(optionhandler_unittests)
-
-
@@ -0,0 +1,899 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#include "macro_utils.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_bool.h"
+#include "umocktypes_stdint.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/file_mapping.h"
+#include "azure_c_shared_utility/constbuffer.h"
+#include "azure_c_shared_utility/xio.h"
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/persistent_queue.h"
+
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
+
+#define TEST_CAPACITY PERSISTENT_QUEUE_MIN_CAPACITY
+/* where the records start, after the two header slots */
+#define TEST_RECORDS_START 128
+#define TEST_RECORD_HEADER_SIZE 24
+#define TEST_MAX_SENT_BUFFERS 8
+
+static const char* TEST_FILE_PATH = "queue.bin";
+static const FILE_MAPPING_HANDLE TEST_FILE_MAPPING = (FILE_MAPPING_HANDLE)0x4242;
+static const XIO_HANDLE TEST_XIO = (XIO_HANDLE)0x4243;
+static void* const TEST_CONTEXT = (void*)0x4244;
+
+/* the file the queue is mapped on, bigger than TEST_CAPACITY for the tests that open it with another capacity */
+static unsigned char g_file[TEST_CAPACITY * 2];
+static bool g_file_is_new;
+
+static unsigned char g_payload_bytes[TEST_CAPACITY];
+static CONSTBUFFER g_payload;
+
+static XIO_BUFFER g_sent_buffers[TEST_MAX_SENT_BUFFERS];
+static size_t g_sent_buffer_count;
+static ON_SEND_COMPLETE g_on_xio_send_complete;
+static void* g_on_xio_send_complete_context;
+
+static size_t g_on_send_complete_call_count;
+static void* g_on_send_complete_context;
+static IO_SEND_RESULT g_on_send_complete_result;
+
+static FILE_MAPPING_HANDLE my_file_mapping_open(const char* file_path, size_t size, bool* created)
+{
+    (void)file_path;
+    (void)size;
+    *created = g_file_is_new;
+    return TEST_FILE_MAPPING;
+}
+
+static unsigned char* my_file_mapping_get_address(FILE_MAPPING_HANDLE file_mapping)
+{
+    (void)file_mapping;
+    return g_file;
+}
+
+static const CONSTBUFFER* my_CONSTBUFFER_GetContent(CONSTBUFFER_HANDLE constbufferHandle)
+{
+    return (const CONSTBUFFER*)constbufferHandle;
+}
+
+static int my_xio_sendv(XIO_HANDLE xio, const XIO_BUFFER* buffers, size_t buffer_count, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    size_t i;
+
+    (void)xio;
+    ASSERT_IS_TRUE(buffer_count <= TEST_MAX_SENT_BUFFERS);
+    for (i = 0; i < buffer_count; i++)
+    {
+        g_sent_buffers[i] = buffers[i];
+    }
+    g_sent_buffer_count = buffer_count;
+    g_on_xio_send_complete = on_send_complete;
+    g_on_xio_send_complete_context = callback_context;
+    return 0;
+}
+
+static void test_on_send_complete(void* context, IO_SEND_RESULT send_result)
+{
+    g_on_send_complete_call_count++;
+    g_on_send_complete_context = context;
+    g_on_send_complete_result = send_result;
+}
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+/* a payload of size bytes derived from seed, so that the payload of each message can be told apart */
+static CONSTBUFFER_HANDLE make_payload(size_t size, unsigned char seed)
+{
+    size_t i;
+
+    for (i = 0; i < size; i++)
+    {
+        g_payload_bytes[i] = (unsigned char)(seed + i);
+    }
+    g_payload.buffer = g_payload_bytes;
+    g_payload.size = size;
+    return (CONSTBUFFER_HANDLE)&g_payload;
+}
+
+static bool is_payload(const XIO_BUFFER* buffer, size_t size, unsigned char seed)
+{
+    bool result = (buffer->size == size);
+    size_t i;
+
+    for (i = 0; result && (i < size); i++)
+    {
+        result = (((const unsigned char*)buffer->buffer)[i] == (unsigned char)(seed + i));
+    }
+
+    return result;
+}
+
+static PERSISTENT_QUEUE_HANDLE create_queue(void)
+{
+    PERSISTENT_QUEUE_HANDLE result = persistent_queue_create(TEST_FILE_PATH, TEST_CAPACITY);
+    ASSERT_IS_NOT_NULL(result);
+    /* the file exists from now on */
+    g_file_is_new = false;
+    umock_c_reset_all_calls();
+    return result;
+}
+
+static void push_payload(PERSISTENT_QUEUE_HANDLE persistent_queue, size_t size, unsigned char seed)
+{
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_push(persistent_queue, make_payload(size, seed)));
+    umock_c_reset_all_calls();
+}
+
+static void send_and_complete(PERSISTENT_QUEUE_HANDLE persistent_queue, size_t max_message_count, IO_SEND_RESULT send_result)
+{
+    size_t sent_message_count;
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_send(persistent_queue, TEST_XIO, max_message_count, &sent_message_count, test_on_send_complete, TEST_CONTEXT));
+    g_on_xio_send_complete(g_on_xio_send_complete_context, send_result);
+    umock_c_reset_all_calls();
+}
+
+static size_t get_count(PERSISTENT_QUEUE_HANDLE persistent_queue)
+{
+    size_t result;
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_get_count(persistent_queue, &result));
+    return result;
+}
+
+BEGIN_TEST_SUITE(persistent_queue_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result, "umock_c_init");
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_charptr_register_types");
+
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_bool_register_types");
+
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_stdint_register_types");
+
+    REGISTER_UMOCK_ALIAS_TYPE(FILE_MAPPING_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(CONSTBUFFER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(const XIO_BUFFER*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_SEND_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(bool*, void*);
+    REGISTER_TYPE(IO_SEND_RESULT, IO_SEND_RESULT);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_HOOK(file_mapping_open, my_file_mapping_open);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(file_mapping_open, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(file_mapping_get_address, my_file_mapping_get_address);
+    REGISTER_GLOBAL_MOCK_RETURN(file_mapping_flush, 0);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(file_mapping_flush, __LINE__);
+    REGISTER_GLOBAL_MOCK_HOOK(CONSTBUFFER_GetContent, my_CONSTBUFFER_GetContent);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_sendv, my_xio_sendv);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(xio_sendv, __LINE__);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    (void)memset(g_file, 0, sizeof(g_file));
+    g_file_is_new = true;
+    g_sent_buffer_count = 0;
+    g_on_xio_send_complete = NULL;
+    g_on_xio_send_complete_context = NULL;
+    g_on_send_complete_call_count = 0;
+    g_on_send_complete_context = NULL;
+    g_on_send_complete_result = IO_SEND_CANCELLED;
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/* persistent_queue_create */
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_001: [ If file_path is NULL, or capacity is smaller than PERSISTENT_QUEUE_MIN_CAPACITY or not a multiple of 8, persistent_queue_create shall fail and return NULL. ]*/
+TEST_FUNCTION(persistent_queue_create_with_NULL_file_path_fails)
+{
+    // act
+    PERSISTENT_QUEUE_HANDLE result = persistent_queue_create(NULL, TEST_CAPACITY);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_001: [ If file_path is NULL, or capacity is smaller than PERSISTENT_QUEUE_MIN_CAPACITY or not a multiple of 8, persistent_queue_create shall fail and return NULL. ]*/
+TEST_FUNCTION(persistent_queue_create_with_a_capacity_below_the_minimum_fails)
+{
+    // act
+    PERSISTENT_QUEUE_HANDLE result = persistent_queue_create(TEST_FILE_PATH, PERSISTENT_QUEUE_MIN_CAPACITY - 8);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_001: [ If file_path is NULL, or capacity is smaller than PERSISTENT_QUEUE_MIN_CAPACITY or not a multiple of 8, persistent_queue_create shall fail and return NULL. ]*/
+TEST_FUNCTION(persistent_queue_create_with_a_capacity_not_multiple_of_8_fails)
+{
+    // act
+    PERSISTENT_QUEUE_HANDLE result = persistent_queue_create(TEST_FILE_PATH, TEST_CAPACITY + 4);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_002: [ If allocating memory for the queue fails, persistent_queue_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_memory_fails_persistent_queue_create_fails)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = persistent_queue_create(TEST_FILE_PATH, TEST_CAPACITY);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_004: [ If file_mapping_open fails, persistent_queue_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_file_mapping_open_fails_persistent_queue_create_fails)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(file_mapping_open(TEST_FILE_PATH, TEST_CAPACITY, IGNORED_PTR_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = persistent_queue_create(TEST_FILE_PATH, TEST_CAPACITY);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_003: [ persistent_queue_create shall map the capacity bytes of the file at file_path by calling file_mapping_open. ]*/
+/* Tests_SRS_PERSISTENT_QUEUE_01_005: [ When the file was created, persistent_queue_create shall write an empty queue to it. ]*/
+/* Tests_SRS_PERSISTENT_QUEUE_01_010: [ On success persistent_queue_create shall return a non-NULL handle. ]*/
+TEST_FUNCTION(persistent_queue_create_on_a_new_file_creates_an_empty_queue)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(file_mapping_open(TEST_FILE_PATH, TEST_CAPACITY, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(file_mapping_get_address(TEST_FILE_MAPPING));
+
+    // act
+    result = persistent_queue_create(TEST_FILE_PATH, TEST_CAPACITY);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, get_count(result));
+
+    // cleanup
+    persistent_queue_destroy(result);
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_006: [ If none of the header slots of an existing file holds a valid header for capacity bytes, persistent_queue_create shall fail and return NULL, leaving the file as it is. ]*/
+TEST_FUNCTION(persistent_queue_create_on_a_file_that_does_not_hold_a_queue_fails)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE result;
+    (void)memset(g_file, 0x5A, sizeof(g_file));
+    g_file_is_new = false;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(file_mapping_open(TEST_FILE_PATH, TEST_CAPACITY, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(file_mapping_get_address(TEST_FILE_MAPPING));
+    STRICT_EXPECTED_CALL(file_mapping_close(TEST_FILE_MAPPING));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = persistent_queue_create(TEST_FILE_PATH, TEST_CAPACITY);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0x5A, (int)g_file[0]);
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_006: [ If none of the header slots of an existing file holds a valid header for capacity bytes, persistent_queue_create shall fail and return NULL, leaving the file as it is. ]*/
+TEST_FUNCTION(persistent_queue_create_with_another_capacity_than_the_file_fails)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE result;
+    persistent_queue_destroy(create_queue());
+    umock_c_reset_all_calls();
+
+    // act
+    result = persistent_queue_create(TEST_FILE_PATH, TEST_CAPACITY * 2);
+
+    // assert
+    ASSERT_IS_NULL(result);
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_007: [ Otherwise persistent_queue_create shall take the header slot with the highest generation among the valid ones. ]*/
+/* Tests_SRS_PERSISTENT_QUEUE_01_008: [ persistent_queue_create shall keep the records that follow the head of the header, for as long as each one has the next sequence number and a valid CRC. ]*/
+TEST_FUNCTION(persistent_queue_create_on_an_existing_file_recovers_the_messages)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+    PERSISTENT_QUEUE_HANDLE result;
+    size_t sent_message_count;
+    push_payload(persistent_queue, 10, 1);
+    push_payload(persistent_queue, 20, 2);
+    push_payload(persistent_queue, 30, 3);
+    send_and_complete(persistent_queue, 1, IO_SEND_OK);
+    persistent_queue_destroy(persistent_queue);
+    umock_c_reset_all_calls();
+
+    // act
+    result = persistent_queue_create(TEST_FILE_PATH, TEST_CAPACITY);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(size_t, 2, get_count(result));
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_send(result, TEST_XIO, 8, &sent_message_count, test_on_send_complete, TEST_CONTEXT));
+    ASSERT_ARE_EQUAL(size_t, 2, sent_message_count);
+    ASSERT_IS_TRUE(is_payload(&g_sent_buffers[0], 20, 2));
+    ASSERT_IS_TRUE(is_payload(&g_sent_buffers[1], 30, 3));
+
+    // cleanup
+    g_on_xio_send_complete(g_on_xio_send_complete_context, IO_SEND_CANCELLED);
+    persistent_queue_destroy(result);
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_008: [ persistent_queue_create shall keep the records that follow the head of the header, for as long as each one has the next sequence number and a valid CRC. ]*/
+/* Tests_SRS_PERSISTENT_QUEUE_01_009: [ The next message pushed shall go where the first record that is not kept starts. ]*/
+TEST_FUNCTION(persistent_queue_create_drops_a_torn_record_and_the_ones_after_it)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+    PERSISTENT_QUEUE_HANDLE result;
+    size_t sent_message_count;
+    push_payload(persistent_queue, 100, 1);
+    push_payload(persistent_queue, 100, 2);
+    push_payload(persistent_queue, 100, 3);
+    persistent_queue_destroy(persistent_queue);
+    /* a byte of the payload of the second record did not make it to the file */
+    g_file[TEST_RECORDS_START + 128 + TEST_RECORD_HEADER_SIZE + 50] ^= 1;
+    umock_c_reset_all_calls();
+
+    // act
+    result = persistent_queue_create(TEST_FILE_PATH, TEST_CAPACITY);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(size_t, 1, get_count(result));
+    push_payload(result, 40, 4);
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_send(result, TEST_XIO, 8, &sent_message_count, test_on_send_complete, TEST_CONTEXT));
+    ASSERT_ARE_EQUAL(size_t, 2, sent_message_count);
+    ASSERT_IS_TRUE(is_payload(&g_sent_buffers[0], 100, 1));
+    ASSERT_IS_TRUE(is_payload(&g_sent_buffers[1], 40, 4));
+    ASSERT_ARE_EQUAL(void_ptr, (void*)(g_file + TEST_RECORDS_START + 128 + TEST_RECORD_HEADER_SIZE), (void*)g_sent_buffers[1].buffer);
+
+    // cleanup
+    g_on_xio_send_complete(g_on_xio_send_complete_context, IO_SEND_CANCELLED);
+    persistent_queue_destroy(result);
+}
+
+/* persistent_queue_destroy */
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_011: [ If persistent_queue is NULL, persistent_queue_destroy shall return. ]*/
+TEST_FUNCTION(persistent_queue_destroy_with_NULL_returns)
+{
+    // act
+    persistent_queue_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_012: [ persistent_queue_destroy shall close the file mapping with file_mapping_close and free the queue. ]*/
+TEST_FUNCTION(persistent_queue_destroy_closes_the_mapping_and_frees_the_queue)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+    STRICT_EXPECTED_CALL(file_mapping_close(TEST_FILE_MAPPING));
+    STRICT_EXPECTED_CALL(gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(gballoc_free(persistent_queue));
+
+    // act
+    persistent_queue_destroy(persistent_queue);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* persistent_queue_push */
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_013: [ If persistent_queue or payload is NULL, persistent_queue_push shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(persistent_queue_push_with_NULL_persistent_queue_fails)
+{
+    // act
+    int result = persistent_queue_push(NULL, make_payload(10, 1));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_013: [ If persistent_queue or payload is NULL, persistent_queue_push shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(persistent_queue_push_with_NULL_payload_fails)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+
+    // act
+    int result = persistent_queue_push(persistent_queue, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    persistent_queue_destroy(persistent_queue);
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_015: [ persistent_queue_push shall place the record after the newest one, or at the start of the records when there is not enough room before the end of the file. ]*/
+/* Tests_SRS_PERSISTENT_QUEUE_01_018: [ The record shall hold the size of the payload, the next sequence number, a CRC-32 of both and of the payload, followed by a copy of the payload. ]*/
+/* Tests_SRS_PERSISTENT_QUEUE_01_019: [ On success persistent_queue_push shall return 0. ]*/
+TEST_FUNCTION(persistent_queue_push_copies_the_payload_to_the_file)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+    int result;
+    STRICT_EXPECTED_CALL(CONSTBUFFER_GetContent(IGNORED_PTR_ARG));
+
+    // act
+    result = persistent_queue_push(persistent_queue, make_payload(10, 7));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, get_count(persistent_queue));
+    ASSERT_ARE_EQUAL(int, 0, memcmp(g_file + TEST_RECORDS_START + TEST_RECORD_HEADER_SIZE, g_payload_bytes, 10));
+
+    // cleanup
+    persistent_queue_destroy(persistent_queue);
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_014: [ If the record of the payload would not fit in an empty queue, persistent_queue_push shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(persistent_queue_push_of_a_payload_bigger_than_the_queue_fails)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+    int result;
+
+    // act
+    result = persistent_queue_push(persistent_queue, make_payload(TEST_CAPACITY - TEST_RECORDS_START - TEST_RECORD_HEADER_SIZE + 1, 1));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, get_count(persistent_queue));
+
+    // cleanup
+    persistent_queue_destroy(persistent_queue);
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_016: [ If the record would overwrite one of the records in the queue, persistent_queue_push shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(persistent_queue_push_when_the_queue_is_full_fails)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+    int result;
+    /* 3 records of 1024 bytes, 896 bytes are left before the end */
+    push_payload(persistent_queue, 1000, 1);
+    push_payload(persistent_queue, 1000, 2);
+    push_payload(persistent_queue, 1000, 3);
+
+    // act
+    result = persistent_queue_push(persistent_queue, make_payload(1000, 4));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 3, get_count(persistent_queue));
+
+    // cleanup
+    persistent_queue_destroy(persistent_queue);
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_015: [ persistent_queue_push shall place the record after the newest one, or at the start of the records when there is not enough room before the end of the file. ]*/
+/* Tests_SRS_PERSISTENT_QUEUE_01_017: [ When the record goes to the start of the records, a wrap marker with the sequence number of the record shall be written where the record would have gone, if there is room for it. ]*/
+TEST_FUNCTION(persistent_queue_push_wraps_to_the_start_of_the_records_and_survives_a_reopen)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+    size_t sent_message_count;
+    int result;
+    push_payload(persistent_queue, 1000, 1);
+    push_payload(persistent_queue, 1000, 2);
+    push_payload(persistent_queue, 1000, 3);
+    send_and_complete(persistent_queue, 2, IO_SEND_OK);
+
+    // act
+    result = persistent_queue_push(persistent_queue, make_payload(1000, 4));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 2, get_count(persistent_queue));
+    persistent_queue_destroy(persistent_queue);
+    persistent_queue = create_queue();
+    ASSERT_ARE_EQUAL(size_t, 2, get_count(persistent_queue));
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_send(persistent_queue, TEST_XIO, 8, &sent_message_count, test_on_send_complete, TEST_CONTEXT));
+    ASSERT_ARE_EQUAL(size_t, 2, sent_message_count);
+    ASSERT_IS_TRUE(is_payload(&g_sent_buffers[0], 1000, 3));
+    ASSERT_IS_TRUE(is_payload(&g_sent_buffers[1], 1000, 4));
+    ASSERT_ARE_EQUAL(void_ptr, (void*)(g_file + TEST_RECORDS_START + TEST_RECORD_HEADER_SIZE), (void*)g_sent_buffers[1].buffer);
+
+    // cleanup
+    g_on_xio_send_complete(g_on_xio_send_complete_context, IO_SEND_CANCELLED);
+    persistent_queue_destroy(persistent_queue);
+}
+
+/* persistent_queue_send */
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_020: [ If persistent_queue, xio or sent_message_count is NULL, or max_message_count is 0, persistent_queue_send shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(persistent_queue_send_with_invalid_arguments_fails)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+    size_t sent_message_count;
+    push_payload(persistent_queue, 10, 1);
+
+    // act
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, persistent_queue_send(NULL, TEST_XIO, 1, &sent_message_count, test_on_send_complete, TEST_CONTEXT));
+    ASSERT_ARE_NOT_EQUAL(int, 0, persistent_queue_send(persistent_queue, NULL, 1, &sent_message_count, test_on_send_complete, TEST_CONTEXT));
+    ASSERT_ARE_NOT_EQUAL(int, 0, persistent_queue_send(persistent_queue, TEST_XIO, 0, &sent_message_count, test_on_send_complete, TEST_CONTEXT));
+    ASSERT_ARE_NOT_EQUAL(int, 0, persistent_queue_send(persistent_queue, TEST_XIO, 1, NULL, test_on_send_complete, TEST_CONTEXT));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    persistent_queue_destroy(persistent_queue);
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_022: [ If the queue is empty, persistent_queue_send shall set sent_message_count to 0 and return 0 without sending. ]*/
+TEST_FUNCTION(persistent_queue_send_of_an_empty_queue_sends_nothing)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+    size_t sent_message_count = 42;
+    int result;
+
+    // act
+    result = persistent_queue_send(persistent_queue, TEST_XIO, 8, &sent_message_count, test_on_send_complete, TEST_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, sent_message_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, g_on_send_complete_call_count);
+
+    // cleanup
+    persistent_queue_destroy(persistent_queue);
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_023: [ persistent_queue_send shall grow the array of XIO_BUFFERs it keeps to hold one for each of the messages to send. ]*/
+/* Tests_SRS_PERSISTENT_QUEUE_01_025: [ persistent_queue_send shall point the XIO_BUFFERs at the payloads of the up to max_message_count oldest messages, in the mapping, and send them with xio_sendv. ]*/
+/* Tests_SRS_PERSISTENT_QUEUE_01_030: [ On success persistent_queue_send shall set sent_message_count to the number of messages sent and return 0. ]*/
+TEST_FUNCTION(persistent_queue_send_sends_the_oldest_messages_with_one_xio_sendv)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+    size_t sent_message_count;
+    int result;
+    push_payload(persistent_queue, 10, 1);
+    push_payload(persistent_queue, 0, 2);
+    push_payload(persistent_queue, 30, 3);
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, 2 * sizeof(XIO_BUFFER)));
+    STRICT_EXPECTED_CALL(xio_sendv(TEST_XIO, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = persistent_queue_send(persistent_queue, TEST_XIO, 2, &sent_message_count, test_on_send_complete, TEST_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 2, sent_message_count);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)(g_file + TEST_RECORDS_START + TEST_RECORD_HEADER_SIZE), (void*)g_sent_buffers[0].buffer);
+    ASSERT_IS_TRUE(is_payload(&g_sent_buffers[0], 10, 1));
+    ASSERT_IS_TRUE(is_payload(&g_sent_buffers[1], 0, 2));
+    ASSERT_ARE_EQUAL(size_t, 0, g_on_send_complete_call_count);
+
+    // cleanup
+    g_on_xio_send_complete(g_on_xio_send_complete_context, IO_SEND_CANCELLED);
+    persistent_queue_destroy(persistent_queue);
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_024: [ If growing the array fails, persistent_queue_send shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_growing_the_buffers_fails_persistent_queue_send_fails)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+    size_t sent_message_count;
+    int result;
+    push_payload(persistent_queue, 10, 1);
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, sizeof(XIO_BUFFER)))
+        .SetReturn(NULL);
+
+    // act
+    result = persistent_queue_send(persistent_queue, TEST_XIO, 1, &sent_message_count, test_on_send_complete, TEST_CONTEXT);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, get_count(persistent_queue));
+
+    // cleanup
+    persistent_queue_destroy(persistent_queue);
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_026: [ If xio_sendv fails, persistent_queue_send shall fail and return a non-zero value, leaving the messages in the queue. ]*/
+TEST_FUNCTION(when_xio_sendv_fails_persistent_queue_send_fails_and_a_new_send_can_be_made)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+    size_t sent_message_count;
+    int result;
+    push_payload(persistent_queue, 10, 1);
+    STRICT_EXPECTED_CALL(gballoc_realloc(NULL, sizeof(XIO_BUFFER)));
+    STRICT_EXPECTED_CALL(xio_sendv(TEST_XIO, IGNORED_PTR_ARG, 1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    result = persistent_queue_send(persistent_queue, TEST_XIO, 1, &sent_message_count, test_on_send_complete, TEST_CONTEXT);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, get_count(persistent_queue));
+    send_and_complete(persistent_queue, 1, IO_SEND_OK);
+    ASSERT_ARE_EQUAL(size_t, 0, get_count(persistent_queue));
+
+    // cleanup
+    persistent_queue_destroy(persistent_queue);
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_021: [ If a send of the queue is in progress, persistent_queue_send shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(persistent_queue_send_while_a_send_is_in_progress_fails)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+    size_t sent_message_count;
+    int result;
+    push_payload(persistent_queue, 10, 1);
+    push_payload(persistent_queue, 10, 2);
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_send(persistent_queue, TEST_XIO, 1, &sent_message_count, test_on_send_complete, TEST_CONTEXT));
+    umock_c_reset_all_calls();
+
+    // act
+    result = persistent_queue_send(persistent_queue, TEST_XIO, 1, &sent_message_count, test_on_send_complete, TEST_CONTEXT);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    g_on_xio_send_complete(g_on_xio_send_complete_context, IO_SEND_CANCELLED);
+    persistent_queue_destroy(persistent_queue);
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_027: [ When the send completes with IO_SEND_OK, the messages sent shall be removed from the queue by writing a header whose head is the record that follows them. ]*/
+/* Tests_SRS_PERSISTENT_QUEUE_01_029: [ Then on_send_complete shall be called with on_send_complete_context and the send result. ]*/
+TEST_FUNCTION(when_the_send_completes_with_IO_SEND_OK_the_messages_are_removed)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+    size_t sent_message_count;
+    push_payload(persistent_queue, 10, 1);
+    push_payload(persistent_queue, 20, 2);
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_send(persistent_queue, TEST_XIO, 1, &sent_message_count, test_on_send_complete, TEST_CONTEXT));
+    umock_c_reset_all_calls();
+
+    // act
+    g_on_xio_send_complete(g_on_xio_send_complete_context, IO_SEND_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, g_on_send_complete_call_count);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_CONTEXT, g_on_send_complete_context);
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_OK, g_on_send_complete_result);
+    ASSERT_ARE_EQUAL(size_t, 1, get_count(persistent_queue));
+    persistent_queue_destroy(persistent_queue);
+    persistent_queue = create_queue();
+    ASSERT_ARE_EQUAL(size_t, 1, get_count(persistent_queue));
+
+    // cleanup
+    persistent_queue_destroy(persistent_queue);
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_028: [ Otherwise the messages shall stay in the queue, to be sent again. ]*/
+/* Tests_SRS_PERSISTENT_QUEUE_01_029: [ Then on_send_complete shall be called with on_send_complete_context and the send result. ]*/
+TEST_FUNCTION(when_the_send_fails_the_messages_are_sent_again)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+    size_t sent_message_count;
+    push_payload(persistent_queue, 10, 1);
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_send(persistent_queue, TEST_XIO, 1, &sent_message_count, test_on_send_complete, TEST_CONTEXT));
+    umock_c_reset_all_calls();
+
+    // act
+    g_on_xio_send_complete(g_on_xio_send_complete_context, IO_SEND_ERROR);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_on_send_complete_call_count);
+    ASSERT_ARE_EQUAL(IO_SEND_RESULT, IO_SEND_ERROR, g_on_send_complete_result);
+    ASSERT_ARE_EQUAL(size_t, 1, get_count(persistent_queue));
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_send(persistent_queue, TEST_XIO, 1, &sent_message_count, test_on_send_complete, TEST_CONTEXT));
+    ASSERT_IS_TRUE(is_payload(&g_sent_buffers[0], 10, 1));
+
+    // cleanup
+    g_on_xio_send_complete(g_on_xio_send_complete_context, IO_SEND_CANCELLED);
+    persistent_queue_destroy(persistent_queue);
+}
+
+/* persistent_queue_get_count */
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_031: [ If persistent_queue or message_count is NULL, persistent_queue_get_count shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(persistent_queue_get_count_with_invalid_arguments_fails)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+    size_t message_count;
+
+    // act
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, persistent_queue_get_count(NULL, &message_count));
+    ASSERT_ARE_NOT_EQUAL(int, 0, persistent_queue_get_count(persistent_queue, NULL));
+
+    // cleanup
+    persistent_queue_destroy(persistent_queue);
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_032: [ Otherwise persistent_queue_get_count shall set message_count to the number of messages in the queue, including the ones being sent, and return 0. ]*/
+TEST_FUNCTION(persistent_queue_get_count_counts_the_messages_being_sent)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+    size_t sent_message_count;
+    push_payload(persistent_queue, 10, 1);
+    push_payload(persistent_queue, 10, 2);
+    ASSERT_ARE_EQUAL(int, 0, persistent_queue_send(persistent_queue, TEST_XIO, 1, &sent_message_count, test_on_send_complete, TEST_CONTEXT));
+
+    // act
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, get_count(persistent_queue));
+
+    // cleanup
+    g_on_xio_send_complete(g_on_xio_send_complete_context, IO_SEND_CANCELLED);
+    persistent_queue_destroy(persistent_queue);
+}
+
+/* persistent_queue_flush */
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_033: [ If persistent_queue is NULL, persistent_queue_flush shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(persistent_queue_flush_with_NULL_fails)
+{
+    // act
+    int result = persistent_queue_flush(NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_034: [ persistent_queue_flush shall flush the whole file with file_mapping_flush. ]*/
+/* Tests_SRS_PERSISTENT_QUEUE_01_036: [ On success persistent_queue_flush shall return 0. ]*/
+TEST_FUNCTION(persistent_queue_flush_flushes_the_whole_file)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+    int result;
+    STRICT_EXPECTED_CALL(file_mapping_flush(TEST_FILE_MAPPING, 0, TEST_CAPACITY));
+
+    // act
+    result = persistent_queue_flush(persistent_queue);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    persistent_queue_destroy(persistent_queue);
+}
+
+/* Tests_SRS_PERSISTENT_QUEUE_01_035: [ If file_mapping_flush fails, persistent_queue_flush shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_file_mapping_flush_fails_persistent_queue_flush_fails)
+{
+    // arrange
+    PERSISTENT_QUEUE_HANDLE persistent_queue = create_queue();
+    int result;
+    STRICT_EXPECTED_CALL(file_mapping_flush(TEST_FILE_MAPPING, 0, TEST_CAPACITY))
+        .SetReturn(1);
+
+    // act
+    result = persistent_queue_flush(persistent_queue);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    persistent_queue_destroy(persistent_queue);
+}
+
+END_TEST_SUITE(persistent_queue_unittests)
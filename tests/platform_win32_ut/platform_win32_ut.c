@@ -178,6 +178,8 @@ TEST_FUNCTION(platform_init_success)
     STRICT_EXPECTED_CALL(WSAStartup(IGNORED_NUM_ARG, IGNORED_PTR_ARG));
 #ifdef USE_OPENSSL
     STRICT_EXPECTED_CALL(tlsio_openssl_init());
+#else
+    STRICT_EXPECTED_CALL(tlsio_schannel_init());
 #endif
 
     //act
@@ -249,6 +251,8 @@ TEST_FUNCTION(platform_deinit_success)
     STRICT_EXPECTED_CALL(WSACleanup());
 #ifdef USE_OPENSSL
     STRICT_EXPECTED_CALL(tlsio_openssl_deinit());
+#else
+    STRICT_EXPECTED_CALL(tlsio_schannel_deinit());
 #endif
 
     //act
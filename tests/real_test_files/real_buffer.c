@@ -19,6 +19,12 @@
 #define BUFFER_append_build real_BUFFER_append_build
 #define BUFFER_shrink real_BUFFER_shrink
 #define BUFFER_fill real_BUFFER_fill
+#define BUFFER_reserve real_BUFFER_reserve
+#define BUFFER_capacity real_BUFFER_capacity
+#define BUFFER_detach real_BUFFER_detach
+#define BUFFER_create_with_headroom real_BUFFER_create_with_headroom
+#define BUFFER_push_front real_BUFFER_push_front
+#define BUFFER_headroom real_BUFFER_headroom
 
 #define GBALLOC_H
 
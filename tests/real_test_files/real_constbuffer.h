@@ -11,8 +11,10 @@
     FOR_EACH_1(R2, \
         CONSTBUFFER_Create, \
         CONSTBUFFER_CreateFromBuffer, \
+        CONSTBUFFER_CreateFromBufferMove, \
         CONSTBUFFER_CreateWithMoveMemory, \
         CONSTBUFFER_CreateWithCustomFree, \
+        CONSTBUFFER_CreateFromOffsetAndSize, \
         CONSTBUFFER_IncRef, \
         CONSTBUFFER_GetContent, \
         CONSTBUFFER_DecRef \
@@ -30,10 +32,14 @@ CONSTBUFFER_HANDLE real_CONSTBUFFER_Create(const unsigned char* source, size_t s
 
 CONSTBUFFER_HANDLE real_CONSTBUFFER_CreateFromBuffer(BUFFER_HANDLE buffer);
 
+CONSTBUFFER_HANDLE real_CONSTBUFFER_CreateFromBufferMove(BUFFER_HANDLE buffer);
+
 CONSTBUFFER_HANDLE real_CONSTBUFFER_CreateWithMoveMemory(unsigned char* source, size_t size);
 
 CONSTBUFFER_HANDLE real_CONSTBUFFER_CreateWithCustomFree(const unsigned char* source, size_t size, CONSTBUFFER_CUSTOM_FREE_FUNC custom_free_func, void* custom_free_func_context);
 
+CONSTBUFFER_HANDLE real_CONSTBUFFER_CreateFromOffsetAndSize(CONSTBUFFER_HANDLE handle, size_t offset, size_t size);
+
 void real_CONSTBUFFER_IncRef(CONSTBUFFER_HANDLE constbufferHandle);
 
 void real_CONSTBUFFER_DecRef(CONSTBUFFER_HANDLE constbufferHandle);
@@ -4,6 +4,8 @@
 #define mallocAndStrcpy_s real_mallocAndStrcpy_s
 #define unsignedIntToString real_unsignedIntToString
 #define size_tToString real_size_tToString
+#define unsignedIntToStringWithLength real_unsignedIntToStringWithLength
+#define size_tToStringWithLength real_size_tToStringWithLength
 
 #define GBALLOC_H
 
@@ -14,5 +14,6 @@
 #define Map_GetValueFromKey real_Map_GetValueFromKey
 #define Map_GetInternals    real_Map_GetInternals
 #define Map_ToJSON          real_Map_ToJSON
+#define Map_ToJSONBuffer    real_Map_ToJSONBuffer
 
 #include "map.c"
@@ -15,7 +15,8 @@
     REGISTER_GLOBAL_MOCK_HOOK(Map_ContainsValue, real_Map_ContainsValue); \
     REGISTER_GLOBAL_MOCK_HOOK(Map_GetValueFromKey, real_Map_GetValueFromKey); \
     REGISTER_GLOBAL_MOCK_HOOK(Map_GetInternals, real_Map_GetInternals); \
-    REGISTER_GLOBAL_MOCK_HOOK(Map_ToJSON, real_Map_ToJSON);
+    REGISTER_GLOBAL_MOCK_HOOK(Map_ToJSON, real_Map_ToJSON); \
+    REGISTER_GLOBAL_MOCK_HOOK(Map_ToJSONBuffer, real_Map_ToJSONBuffer);
 
 #ifdef __cplusplus
 #include <cstddef>
@@ -35,6 +36,7 @@ extern "C"
     extern const char* real_Map_GetValueFromKey(MAP_HANDLE handle, const char* key);
     extern MAP_RESULT real_Map_GetInternals(MAP_HANDLE handle, const char*const** keys, const char*const** values, size_t* count);
     extern STRING_HANDLE real_Map_ToJSON(MAP_HANDLE handle);
+    extern MAP_RESULT real_Map_ToJSONBuffer(MAP_HANDLE handle, BUFFER_HANDLE destination);
 #ifdef __cplusplus
 }
 #endif
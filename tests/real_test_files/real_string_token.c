@@ -8,6 +8,8 @@
 #define StringToken_GetDelimiter real_StringToken_GetDelimiter
 #define StringToken_Split real_StringToken_Split
 #define StringToken_Destroy real_StringToken_Destroy
+#define StringToken_InitView real_StringToken_InitView
+#define StringToken_NextView real_StringToken_NextView
 
 #define GBALLOC_H
 
@@ -37,7 +37,6 @@ static void my_gballoc_free(void* ptr)
 #include "azure_c_shared_utility/strings.h"
 #include "azure_c_shared_utility/buffer_.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
-#include "azure_c_shared_utility/urlencode.h"
 #include "azure_c_shared_utility/base64.h"
 #include "azure_c_shared_utility/agenttime.h"
 
@@ -60,24 +59,12 @@ BUFFER_HANDLE my_BUFFER_new(void)
     return (BUFFER_HANDLE)malloc(1);
 }
 
-STRING_HANDLE my_Base64_Encode(BUFFER_HANDLE input)
-{
-    (void)input;
-    return (STRING_HANDLE)malloc(1);
-}
-
 BUFFER_HANDLE my_Base64_Decoder(const char* source)
 {
     (void)source;
     return (BUFFER_HANDLE)malloc(1);
 }
 
-STRING_HANDLE my_URL_Encode(STRING_HANDLE input)
-{
-    (void)input;
-    return (STRING_HANDLE)malloc(1);
-}
-
 #include "azure_c_shared_utility/sastoken.h"
 
 #define TEST_STRING_HANDLE (STRING_HANDLE)0x46
@@ -90,9 +77,8 @@ STRING_HANDLE my_URL_Encode(STRING_HANDLE input)
 #define TEST_HASH_HANDLE (BUFFER_HANDLE)0x51
 #define TEST_TOBEHASHED_HANDLE (STRING_HANDLE)0x52
 #define TEST_RESULT_HANDLE (STRING_HANDLE)0x53
-#define TEST_BASE64SIGNATURE_HANDLE (STRING_HANDLE)0x54
-#define TEST_URLENCODEDSIGNATURE_HANDLE (STRING_HANDLE)0x55
 #define TEST_DECODEDKEY_HANDLE (BUFFER_HANDLE)0x56
+#define TEST_KEY_CONTEXT_HANDLE (HMACSHA256_KEY_CONTEXT_HANDLE)0x57
 #define TEST_TIME_T ((time_t)3600)
 #define TEST_PTR_DECODEDKEY (unsigned char*)0x123
 #define TEST_LENGTH_DECODEDKEY (size_t)32
@@ -141,6 +127,8 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_UMOCK_ALIAS_TYPE(size_t, unsigned int);
     REGISTER_UMOCK_ALIAS_TYPE(STRING_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(BUFFER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(HMACSHA256_KEY_CONTEXT_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(HMACSHA256_BATCH_ITEM*, void*);
 
     result = umocktypes_charptr_register_types();
     ASSERT_ARE_EQUAL(int, 0, result);
@@ -161,13 +149,12 @@ TEST_SUITE_INITIALIZE(TestClassInitialize)
     REGISTER_GLOBAL_MOCK_RETURN(BUFFER_u_char, &TEST_UNSIGNED_CHAR_ARRAY[0]);
     REGISTER_GLOBAL_MOCK_RETURN(BUFFER_length, 1);
 
-    REGISTER_GLOBAL_MOCK_HOOK(Base64_Encoder, my_Base64_Encode);
     REGISTER_GLOBAL_MOCK_HOOK(Base64_Decoder, my_Base64_Decoder);
-    REGISTER_GLOBAL_MOCK_HOOK(URL_Encode, my_URL_Encode);
     REGISTER_GLOBAL_MOCK_RETURN(HMACSHA256_ComputeHash, HMACSHA256_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(HMACSHA256_ComputeHashBatch, HMACSHA256_OK);
     REGISTER_GLOBAL_MOCK_RETURN(size_tToString, 0);
 
-    REGISTER_GLOBAL_MOCK_RETURN(get_time, TEST_TIME_T);
+    REGISTER_GLOBAL_MOCK_RETURN(get_time_coarse, TEST_TIME_T);
     REGISTER_GLOBAL_MOCK_HOOK(get_difftime, my_get_difftime);
 
 }
@@ -600,10 +587,8 @@ TEST_FUNCTION(SASToken_validate_proper_format_1_pass)
 
     STRICT_EXPECTED_CALL(STRING_c_str(handle)).SetReturn(TEST_INVALID_SE);
     STRICT_EXPECTED_CALL(STRING_length(handle)).SetReturn(TEST_INVALID_SE_LENGTH);
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(get_time(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(get_time_coarse());
     STRICT_EXPECTED_CALL(get_difftime(IGNORED_NUM_ARG, IGNORED_NUM_ARG)).IgnoreAllArguments().SetReturn(TEST_TIME_T);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)).IgnoreAllArguments();
 
     // act
     result = SASToken_Validate(handle);
@@ -625,10 +610,8 @@ TEST_FUNCTION(SASToken_validate_proper_format_with_skn_1_pass)
 
     STRICT_EXPECTED_CALL(STRING_c_str(handle)).SetReturn(TEST_INVALID_SE);
     STRICT_EXPECTED_CALL(STRING_length(handle)).SetReturn(TEST_INVALID_SE_LENGTH);
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(get_time(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(get_time_coarse());
     STRICT_EXPECTED_CALL(get_difftime(IGNORED_NUM_ARG, IGNORED_NUM_ARG)).IgnoreAllArguments().SetReturn(TEST_TIME_T);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)).IgnoreAllArguments();
 
     // act
     result = SASToken_Validate(handle);
@@ -649,10 +632,8 @@ TEST_FUNCTION(SASToken_validate_proper_format_with_skn_expired_se_fail)
 
     STRICT_EXPECTED_CALL(STRING_c_str(handle)).SetReturn(TEST_INVALID_SE);
     STRICT_EXPECTED_CALL(STRING_length(handle)).SetReturn(TEST_INVALID_SE_LENGTH);
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(get_time(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(get_time_coarse());
     STRICT_EXPECTED_CALL(get_difftime(IGNORED_NUM_ARG, IGNORED_NUM_ARG)).IgnoreAllArguments().SetReturn(TEST_TIME_T);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)).IgnoreAllArguments();
 
     // act
     result = SASToken_Validate(handle);
@@ -673,10 +654,8 @@ TEST_FUNCTION(SASToken_validate_proper_format_2_pass)
 
     STRICT_EXPECTED_CALL(STRING_c_str(handle)).SetReturn(TEST_INVALID_SE);
     STRICT_EXPECTED_CALL(STRING_length(handle)).SetReturn(TEST_INVALID_SE_LENGTH);
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(get_time(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(get_time_coarse());
     STRICT_EXPECTED_CALL(get_difftime(IGNORED_NUM_ARG, IGNORED_NUM_ARG)).IgnoreAllArguments().SetReturn(TEST_TIME_T);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)).IgnoreAllArguments();
 
     // act
     result = SASToken_Validate(handle);
@@ -697,10 +676,8 @@ TEST_FUNCTION(SASToken_validate_proper_format_3_pass)
 
     STRICT_EXPECTED_CALL(STRING_c_str(handle)).SetReturn(TEST_INVALID_SE);
     STRICT_EXPECTED_CALL(STRING_length(handle)).SetReturn(TEST_INVALID_SE_LENGTH);
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(get_time(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(get_time_coarse());
     STRICT_EXPECTED_CALL(get_difftime(IGNORED_NUM_ARG, IGNORED_NUM_ARG)).IgnoreAllArguments().SetReturn(TEST_TIME_T);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)).IgnoreAllArguments();
 
     // act
     result = SASToken_Validate(handle);
@@ -721,10 +698,8 @@ TEST_FUNCTION(SASToken_validate_not_expired_pass)
 
     STRICT_EXPECTED_CALL(STRING_c_str(handle)).SetReturn(TEST_INVALID_SE);
     STRICT_EXPECTED_CALL(STRING_length(handle)).SetReturn(TEST_INVALID_SE_LENGTH);
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(get_time(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(get_time_coarse());
     STRICT_EXPECTED_CALL(get_difftime(IGNORED_NUM_ARG, IGNORED_NUM_ARG)).IgnoreAllArguments().SetReturn(TEST_EARLY_TIME);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)).IgnoreAllArguments();
 
     // act
     result = SASToken_Validate(handle);
@@ -746,10 +721,8 @@ TEST_FUNCTION(SASToken_validate_expired_fail)
 
     STRICT_EXPECTED_CALL(STRING_c_str(handle)).SetReturn(TEST_INVALID_SE);
     STRICT_EXPECTED_CALL(STRING_length(handle)).SetReturn(TEST_INVALID_SE_LENGTH);
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(get_time(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(get_time_coarse());
     STRICT_EXPECTED_CALL(get_difftime(TEST_TIME_T, IGNORED_NUM_ARG)).IgnoreAllArguments().SetReturn(TEST_LATER_TIME);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)).IgnoreAllArguments();
 
     // act
     result = SASToken_Validate(handle);
@@ -770,8 +743,6 @@ TEST_FUNCTION(SASToken_validate_invalid_expiry_1_fail)
 
     STRICT_EXPECTED_CALL(STRING_c_str(handle)).SetReturn(TEST_INVALID_SE);
     STRICT_EXPECTED_CALL(STRING_length(handle)).SetReturn(TEST_INVALID_SE_LENGTH);
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)).IgnoreAllArguments();
 
     // act
     result = SASToken_Validate(handle);
@@ -792,8 +763,6 @@ TEST_FUNCTION(SASToken_validate_invalid_expiry_2_fail)
 
     STRICT_EXPECTED_CALL(STRING_c_str(handle)).SetReturn(TEST_INVALID_SE);
     STRICT_EXPECTED_CALL(STRING_length(handle)).SetReturn(TEST_INVALID_SE_LENGTH);
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)).IgnoreAllArguments();
 
     // act
     result = SASToken_Validate(handle);
@@ -814,8 +783,6 @@ TEST_FUNCTION(SASToken_validate_invalid_expiry_3_fail)
 
     STRICT_EXPECTED_CALL(STRING_c_str(handle)).SetReturn(TEST_INVALID_SE);
     STRICT_EXPECTED_CALL(STRING_length(handle)).SetReturn(TEST_INVALID_SE_LENGTH);
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)).IgnoreAllArguments();
 
     // act
     result = SASToken_Validate(handle);
@@ -836,8 +803,6 @@ TEST_FUNCTION(SASToken_validate_invalid_expiry_4_fail)
 
     STRICT_EXPECTED_CALL(STRING_c_str(handle)).SetReturn(TEST_INVALID_SE);
     STRICT_EXPECTED_CALL(STRING_length(handle)).SetReturn(TEST_INVALID_SE_LENGTH);
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)).IgnoreAllArguments();
 
     // act
     result = SASToken_Validate(handle);
@@ -858,8 +823,6 @@ TEST_FUNCTION(SASToken_validate_invalid_expiry_5_fail)
 
     STRICT_EXPECTED_CALL(STRING_c_str(handle)).SetReturn(TEST_INVALID_SE);
     STRICT_EXPECTED_CALL(STRING_length(handle)).SetReturn(TEST_INVALID_SE_LENGTH);
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)).IgnoreAllArguments();
 
     // act
     result = SASToken_Validate(handle);
@@ -869,6 +832,66 @@ TEST_FUNCTION(SASToken_validate_invalid_expiry_5_fail)
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
+/*Tests_SRS_SASTOKEN_01_013: [ If sasToken is NULL then SASToken_ValidateString shall return false. ]*/
+TEST_FUNCTION(SASToken_ValidateString_with_NULL_token_fails)
+{
+    // act
+    bool result = SASToken_ValidateString(NULL, 10);
+
+    // assert
+    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_SASTOKEN_01_014: [ SASToken_ValidateString shall scan the sasTokenLength characters of sasToken in place, allocating no memory. ]*/
+TEST_FUNCTION(SASToken_ValidateString_only_scans_sasTokenLength_characters)
+{
+    // arrange
+    const char* TEST_TOKEN = "SharedAccessSignature sr=TESTSR&sig=TESTSIG&se=0123456789";
+    bool result;
+
+    // act
+    result = SASToken_ValidateString(TEST_TOKEN, strlen(TEST_TOKEN) - strlen("&se=0123456789"));
+
+    // assert
+    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_SASTOKEN_01_014: [ SASToken_ValidateString shall scan the sasTokenLength characters of sasToken in place, allocating no memory. ]*/
+/*Tests_SRS_SASTOKEN_25_030: [**SASToken_validate shall return true only if the format is obeyed and the token has not yet expired **]*/
+TEST_FUNCTION(SASToken_ValidateString_reads_all_the_digits_of_an_expiry_followed_by_a_field)
+{
+    // arrange
+    const char* TEST_TOKEN = "SharedAccessSignature se=3600&sr=TESTSR&sig=TESTSIG";
+    bool result;
+
+    STRICT_EXPECTED_CALL(get_time_coarse());
+    STRICT_EXPECTED_CALL(get_difftime(IGNORED_NUM_ARG, IGNORED_NUM_ARG)).IgnoreAllArguments().SetReturn(TEST_TIME_T);
+
+    // act
+    result = SASToken_ValidateString(TEST_TOKEN, strlen(TEST_TOKEN));
+
+    // assert
+    ASSERT_IS_TRUE(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_SASTOKEN_01_015: [ The expiry shall be parsed as an integer; if it is not only digits or does not fit in 64 bits, SASToken_ValidateString shall return false. ]*/
+TEST_FUNCTION(SASToken_ValidateString_with_an_expiry_over_64_bits_fails)
+{
+    // arrange
+    const char* TEST_TOKEN = "SharedAccessSignature sr=TESTSR&sig=TESTSIG&se=18446744073709551616";
+    bool result;
+
+    // act
+    result = SASToken_ValidateString(TEST_TOKEN, strlen(TEST_TOKEN));
+
+    // assert
+    ASSERT_IS_FALSE(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 /*Tests_SRS_SASTOKEN_06_001: [If key is NULL then SASToken_Create shall return NULL.]*/
 TEST_FUNCTION(SASToken_Create_null_key_fails)
 {
@@ -912,7 +935,6 @@ TEST_FUNCTION(SASToken_Create_null_keyName_succeeds)
 
     STRICT_EXPECTED_CALL(BUFFER_new()).SetReturn(TEST_HASH_HANDLE);
     STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_TOBEHASHED_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_RESULT_HANDLE);
 
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, "\n"));
@@ -924,17 +946,10 @@ TEST_FUNCTION(SASToken_Create_null_keyName_succeeds)
     STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_DECODEDKEY_HANDLE));
 
     STRICT_EXPECTED_CALL(HMACSHA256_ComputeHash(IGNORED_PTR_ARG, TEST_LENGTH_DECODEDKEY, IGNORED_PTR_ARG, TEST_LENGTH_TOBEHASHED, TEST_HASH_HANDLE)).IgnoreArgument(1).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(Base64_Encoder(TEST_HASH_HANDLE)).SetReturn(TEST_BASE64SIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(URL_Encode(TEST_BASE64SIGNATURE_HANDLE)).SetReturn(TEST_URLENCODEDSIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_copy(TEST_RESULT_HANDLE, "SharedAccessSignature sr="));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&sig="));
-    STRICT_EXPECTED_CALL(STRING_concat_with_STRING(TEST_RESULT_HANDLE, TEST_URLENCODEDSIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&se="));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, TEST_TOKEN_EXPIRATION_TIME));
-
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_BASE64SIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_URLENCODEDSIGNATURE_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_HASH_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_length(TEST_HASH_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_malloc(64));
+    STRICT_EXPECTED_CALL(STRING_new_with_memory("SharedAccessSignature sr=Test string value&sig=AQ%3d%3d&se=7200")).SetReturn(TEST_RESULT_HANDLE);
     STRICT_EXPECTED_CALL(STRING_delete(TEST_TOBEHASHED_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_DECODEDKEY_HANDLE));
@@ -1043,33 +1058,6 @@ TEST_FUNCTION(SASToken_Create_first_string_new_fails)
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-TEST_FUNCTION(SASToken_Create_second_string_new_fails)
-{
-    // arrange
-    STRING_HANDLE handle;
-
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEY_HANDLE)).SetReturn(&TEST_CHAR_ARRAY[0]);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_SCOPE_HANDLE)).SetReturn(TEST_STRING_VALUE);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEYNAME_HANDLE)).SetReturn(TEST_STRING_VALUE);
-    STRICT_EXPECTED_CALL(Base64_Decoder(&TEST_CHAR_ARRAY[0])).SetReturn(TEST_DECODEDKEY_HANDLE);
-
-    STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, sizeof(TEST_TOKEN_EXPIRATION_TIME), TEST_EXPIRY)).IgnoreArgument(1).CopyOutArgumentBuffer(1, TEST_TOKEN_EXPIRATION_TIME, sizeof(TEST_TOKEN_EXPIRATION_TIME));
-    STRICT_EXPECTED_CALL(BUFFER_new()).SetReturn(TEST_HASH_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_TOBEHASHED_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(NULL);
-
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_TOBEHASHED_HANDLE));
-    STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
-    STRICT_EXPECTED_CALL(BUFFER_delete(TEST_DECODEDKEY_HANDLE));
-
-    // act
-    handle = SASToken_Create(TEST_KEY_HANDLE, TEST_SCOPE_HANDLE, TEST_KEYNAME_HANDLE, TEST_EXPIRY);
-
-    // assert
-    ASSERT_IS_NULL(handle);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-}
-
 TEST_FUNCTION(SASToken_Create_build_to_be_hashed_part1_fails)
 {
     // arrange
@@ -1083,11 +1071,9 @@ TEST_FUNCTION(SASToken_Create_build_to_be_hashed_part1_fails)
     STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, sizeof(TEST_TOKEN_EXPIRATION_TIME), TEST_EXPIRY)).IgnoreArgument(1).CopyOutArgumentBuffer(1, TEST_TOKEN_EXPIRATION_TIME, sizeof(TEST_TOKEN_EXPIRATION_TIME));
     STRICT_EXPECTED_CALL(BUFFER_new()).SetReturn(TEST_HASH_HANDLE);
     STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_TOBEHASHED_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_RESULT_HANDLE);
 
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, IGNORED_PTR_ARG)).SetReturn(1);
 
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_RESULT_HANDLE));
     STRICT_EXPECTED_CALL(STRING_delete(TEST_TOBEHASHED_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_DECODEDKEY_HANDLE));
@@ -1114,12 +1100,10 @@ TEST_FUNCTION(SASToken_Create_build_to_be_hashed_part2_fails)
     STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, sizeof(TEST_TOKEN_EXPIRATION_TIME), TEST_EXPIRY)).IgnoreArgument(1).CopyOutArgumentBuffer(1, TEST_TOKEN_EXPIRATION_TIME, sizeof(TEST_TOKEN_EXPIRATION_TIME));
     STRICT_EXPECTED_CALL(BUFFER_new()).SetReturn(TEST_HASH_HANDLE);
     STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_TOBEHASHED_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_RESULT_HANDLE);
 
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, "\n")).SetReturn(1);
 
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_RESULT_HANDLE));
     STRICT_EXPECTED_CALL(STRING_delete(TEST_TOBEHASHED_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_DECODEDKEY_HANDLE));
@@ -1146,13 +1130,11 @@ TEST_FUNCTION(SASToken_Create_build_to_be_hashed_part3_fails)
     STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, sizeof(TEST_TOKEN_EXPIRATION_TIME), TEST_EXPIRY)).IgnoreArgument(1).CopyOutArgumentBuffer(1, TEST_TOKEN_EXPIRATION_TIME, sizeof(TEST_TOKEN_EXPIRATION_TIME));
     STRICT_EXPECTED_CALL(BUFFER_new()).SetReturn(TEST_HASH_HANDLE);
     STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_TOBEHASHED_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_RESULT_HANDLE);
 
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, "\n"));
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, TEST_TOKEN_EXPIRATION_TIME)).SetReturn(1);
 
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_RESULT_HANDLE));
     STRICT_EXPECTED_CALL(STRING_delete(TEST_TOBEHASHED_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_DECODEDKEY_HANDLE));
@@ -1180,7 +1162,6 @@ TEST_FUNCTION(SASToken_Create_HMAC256_fails)
     STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, sizeof(TEST_TOKEN_EXPIRATION_TIME), TEST_EXPIRY)).IgnoreArgument(1).CopyOutArgumentBuffer(1, TEST_TOKEN_EXPIRATION_TIME, sizeof(TEST_TOKEN_EXPIRATION_TIME));
     STRICT_EXPECTED_CALL(BUFFER_new()).SetReturn(TEST_HASH_HANDLE);
     STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_TOBEHASHED_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_RESULT_HANDLE);
 
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, "\n"));
@@ -1193,9 +1174,6 @@ TEST_FUNCTION(SASToken_Create_HMAC256_fails)
 
     STRICT_EXPECTED_CALL(HMACSHA256_ComputeHash(IGNORED_PTR_ARG, TEST_LENGTH_DECODEDKEY, IGNORED_PTR_ARG, TEST_LENGTH_TOBEHASHED, TEST_HASH_HANDLE)).SetReturn(HMACSHA256_ERROR);
 
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_RESULT_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(NULL));
-    STRICT_EXPECTED_CALL(STRING_delete(NULL));
     STRICT_EXPECTED_CALL(STRING_delete(TEST_TOBEHASHED_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_DECODEDKEY_HANDLE));
@@ -1209,9 +1187,9 @@ TEST_FUNCTION(SASToken_Create_HMAC256_fails)
 }
 
 
-/*Tests_SRS_SASTOKEN_06_012: [An HMAC256 hash is calculated using the decodedKey, over toBeHashed.]*/
 /*Tests_SRS_SASTOKEN_06_014: [If there are any errors from the following operations then NULL shall be returned.]*/
-TEST_FUNCTION(SASToken_Create_HMAC256_passes_signature_encode_fails)
+/*Tests_SRS_SASTOKEN_01_017: [ The token shall be written in one buffer allocated with its exact length, which becomes the result through STRING_new_with_memory. ]*/
+TEST_FUNCTION(SASToken_Create_allocating_the_token_fails)
 {
     // arrange
     STRING_HANDLE handle;
@@ -1224,7 +1202,6 @@ TEST_FUNCTION(SASToken_Create_HMAC256_passes_signature_encode_fails)
     STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, sizeof(TEST_TOKEN_EXPIRATION_TIME), TEST_EXPIRY)).IgnoreArgument(1).CopyOutArgumentBuffer(1, TEST_TOKEN_EXPIRATION_TIME, sizeof(TEST_TOKEN_EXPIRATION_TIME));
     STRICT_EXPECTED_CALL(BUFFER_new()).SetReturn(TEST_HASH_HANDLE);
     STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_TOBEHASHED_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_RESULT_HANDLE);
 
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, "\n"));
@@ -1236,11 +1213,10 @@ TEST_FUNCTION(SASToken_Create_HMAC256_passes_signature_encode_fails)
     STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_DECODEDKEY_HANDLE));
 
     STRICT_EXPECTED_CALL(HMACSHA256_ComputeHash(IGNORED_PTR_ARG, TEST_LENGTH_DECODEDKEY, IGNORED_PTR_ARG, TEST_LENGTH_TOBEHASHED, TEST_HASH_HANDLE)).IgnoreArgument(1).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(Base64_Encoder(TEST_HASH_HANDLE)).SetReturn(NULL);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_HASH_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_length(TEST_HASH_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_malloc(86)).SetReturn(NULL);
 
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_RESULT_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(NULL));
-    STRICT_EXPECTED_CALL(STRING_delete(NULL));
     STRICT_EXPECTED_CALL(STRING_delete(TEST_TOBEHASHED_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_DECODEDKEY_HANDLE));
@@ -1254,8 +1230,7 @@ TEST_FUNCTION(SASToken_Create_HMAC256_passes_signature_encode_fails)
 }
 
 /*Tests_SRS_SASTOKEN_06_014: [If there are any errors from the following operations then NULL shall be returned.]*/
-/*Tests_SRS_SASTOKEN_06_015: [The hash is base 64 encoded.]*/
-TEST_FUNCTION(SASToken_Create_building_token_signature_url_encoding_fails)
+TEST_FUNCTION(SASToken_Create_STRING_new_with_memory_fails)
 {
     // arrange
     STRING_HANDLE handle;
@@ -1268,7 +1243,6 @@ TEST_FUNCTION(SASToken_Create_building_token_signature_url_encoding_fails)
     STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, sizeof(TEST_TOKEN_EXPIRATION_TIME), TEST_EXPIRY)).IgnoreArgument(1).CopyOutArgumentBuffer(1, TEST_TOKEN_EXPIRATION_TIME, sizeof(TEST_TOKEN_EXPIRATION_TIME));
     STRICT_EXPECTED_CALL(BUFFER_new()).SetReturn(TEST_HASH_HANDLE);
     STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_TOBEHASHED_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_RESULT_HANDLE);
 
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, "\n"));
@@ -1280,12 +1254,12 @@ TEST_FUNCTION(SASToken_Create_building_token_signature_url_encoding_fails)
     STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_DECODEDKEY_HANDLE));
 
     STRICT_EXPECTED_CALL(HMACSHA256_ComputeHash(IGNORED_PTR_ARG, TEST_LENGTH_DECODEDKEY, IGNORED_PTR_ARG, TEST_LENGTH_TOBEHASHED, TEST_HASH_HANDLE)).IgnoreArgument(1).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(Base64_Encoder(TEST_HASH_HANDLE)).SetReturn(TEST_BASE64SIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(URL_Encode(TEST_BASE64SIGNATURE_HANDLE)).SetReturn(NULL);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_HASH_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_length(TEST_HASH_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_malloc(86));
+    STRICT_EXPECTED_CALL(STRING_new_with_memory(IGNORED_PTR_ARG)).SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_RESULT_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_BASE64SIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(NULL));
     STRICT_EXPECTED_CALL(STRING_delete(TEST_TOBEHASHED_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_DECODEDKEY_HANDLE));
@@ -1298,9 +1272,8 @@ TEST_FUNCTION(SASToken_Create_building_token_signature_url_encoding_fails)
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/*Tests_SRS_SASTOKEN_06_014: [If there are any errors from the following operations then NULL shall be returned.]*/
-/*Tests_SRS_SASTOKEN_06_028: [base64Signature shall be url encoded.]*/
-TEST_FUNCTION(SASToken_Create_building_token_copy_scope_identifier_fails)
+/*Tests_SRS_SASTOKEN_06_023: [The argument keyName is appended to result.]*/
+TEST_FUNCTION(SASToken_Create_succeeds)
 {
     // arrange
     STRING_HANDLE handle;
@@ -1308,12 +1281,12 @@ TEST_FUNCTION(SASToken_Create_building_token_copy_scope_identifier_fails)
     STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEY_HANDLE)).SetReturn(&TEST_CHAR_ARRAY[0]);
     STRICT_EXPECTED_CALL(STRING_c_str(TEST_SCOPE_HANDLE)).SetReturn(TEST_STRING_VALUE);
     STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEYNAME_HANDLE)).SetReturn(TEST_STRING_VALUE);
-    STRICT_EXPECTED_CALL(Base64_Decoder(&TEST_CHAR_ARRAY[0])).SetReturn(TEST_DECODEDKEY_HANDLE);
 
+    STRICT_EXPECTED_CALL(Base64_Decoder(&TEST_CHAR_ARRAY[0])).SetReturn(TEST_DECODEDKEY_HANDLE);
     STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, sizeof(TEST_TOKEN_EXPIRATION_TIME), TEST_EXPIRY)).IgnoreArgument(1).CopyOutArgumentBuffer(1, TEST_TOKEN_EXPIRATION_TIME, sizeof(TEST_TOKEN_EXPIRATION_TIME));
+
     STRICT_EXPECTED_CALL(BUFFER_new()).SetReturn(TEST_HASH_HANDLE);
     STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_TOBEHASHED_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_RESULT_HANDLE);
 
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, "\n"));
@@ -1325,13 +1298,10 @@ TEST_FUNCTION(SASToken_Create_building_token_copy_scope_identifier_fails)
     STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_DECODEDKEY_HANDLE));
 
     STRICT_EXPECTED_CALL(HMACSHA256_ComputeHash(IGNORED_PTR_ARG, TEST_LENGTH_DECODEDKEY, IGNORED_PTR_ARG, TEST_LENGTH_TOBEHASHED, TEST_HASH_HANDLE)).IgnoreArgument(1).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(Base64_Encoder(TEST_HASH_HANDLE)).SetReturn(TEST_BASE64SIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(URL_Encode(TEST_BASE64SIGNATURE_HANDLE)).SetReturn(TEST_URLENCODEDSIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_copy(TEST_RESULT_HANDLE, "SharedAccessSignature sr=")).SetReturn(1);
-
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_RESULT_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_BASE64SIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_URLENCODEDSIGNATURE_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_HASH_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_length(TEST_HASH_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_malloc(86));
+    STRICT_EXPECTED_CALL(STRING_new_with_memory("SharedAccessSignature sr=Test string value&sig=AQ%3d%3d&se=7200&skn=Test string value")).SetReturn(TEST_RESULT_HANDLE);
     STRICT_EXPECTED_CALL(STRING_delete(TEST_TOBEHASHED_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_DECODEDKEY_HANDLE));
@@ -1340,26 +1310,20 @@ TEST_FUNCTION(SASToken_Create_building_token_copy_scope_identifier_fails)
     handle = SASToken_Create(TEST_KEY_HANDLE, TEST_SCOPE_HANDLE, TEST_KEYNAME_HANDLE, TEST_EXPIRY);
 
     // assert
-    ASSERT_IS_NULL(handle);
+    ASSERT_IS_NOT_NULL(handle);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/*Tests_SRS_SASTOKEN_06_016: [The string "SharedAccessSignature sr=" is the first part of the result of SASToken_Create.]*/
-/*Tests_SRS_SASTOKEN_06_014: [If there are any errors from the following operations then NULL shall be returned.]*/
-TEST_FUNCTION(SASToken_Create_building_token_concat_scope_fails)
+TEST_FUNCTION(SASToken_CreateString_succeeds)
 {
     // arrange
     STRING_HANDLE handle;
 
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEY_HANDLE)).SetReturn(&TEST_CHAR_ARRAY[0]);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_SCOPE_HANDLE)).SetReturn(TEST_STRING_VALUE);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEYNAME_HANDLE)).SetReturn(TEST_STRING_VALUE);
     STRICT_EXPECTED_CALL(Base64_Decoder(&TEST_CHAR_ARRAY[0])).SetReturn(TEST_DECODEDKEY_HANDLE);
-
     STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, sizeof(TEST_TOKEN_EXPIRATION_TIME), TEST_EXPIRY)).IgnoreArgument(1).CopyOutArgumentBuffer(1, TEST_TOKEN_EXPIRATION_TIME, sizeof(TEST_TOKEN_EXPIRATION_TIME));
+
     STRICT_EXPECTED_CALL(BUFFER_new()).SetReturn(TEST_HASH_HANDLE);
     STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_TOBEHASHED_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_RESULT_HANDLE);
 
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, "\n"));
@@ -1371,189 +1335,131 @@ TEST_FUNCTION(SASToken_Create_building_token_concat_scope_fails)
     STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_DECODEDKEY_HANDLE));
 
     STRICT_EXPECTED_CALL(HMACSHA256_ComputeHash(IGNORED_PTR_ARG, TEST_LENGTH_DECODEDKEY, IGNORED_PTR_ARG, TEST_LENGTH_TOBEHASHED, TEST_HASH_HANDLE)).IgnoreArgument(1).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(Base64_Encoder(TEST_HASH_HANDLE)).SetReturn(TEST_BASE64SIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(URL_Encode(TEST_BASE64SIGNATURE_HANDLE)).SetReturn(TEST_URLENCODEDSIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_copy(TEST_RESULT_HANDLE, "SharedAccessSignature sr="));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, IGNORED_PTR_ARG)).SetReturn(1);
-
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_RESULT_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_BASE64SIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_URLENCODEDSIGNATURE_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_HASH_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_length(TEST_HASH_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_malloc(86));
+    STRICT_EXPECTED_CALL(STRING_new_with_memory("SharedAccessSignature sr=Test string value&sig=AQ%3d%3d&se=7200&skn=Test string value")).SetReturn(TEST_RESULT_HANDLE);
     STRICT_EXPECTED_CALL(STRING_delete(TEST_TOBEHASHED_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_DECODEDKEY_HANDLE));
 
     // act
-    handle = SASToken_Create(TEST_KEY_HANDLE, TEST_SCOPE_HANDLE, TEST_KEYNAME_HANDLE, TEST_EXPIRY);
+    handle = SASToken_CreateString(TEST_CHAR_ARRAY, TEST_STRING_VALUE, TEST_STRING_VALUE, TEST_EXPIRY);
 
     // assert
-    ASSERT_IS_NULL(handle);
+    ASSERT_IS_NOT_NULL(handle);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/*Tests_SRS_SASTOKEN_06_014: [If there are any errors from the following operations then NULL shall be returned.]*/
-/*Tests_SRS_SASTOKEN_06_017: [The scope parameter is appended to result.]*/
-TEST_FUNCTION(SASToken_Create_building_token_concat_signature_identifier_fails)
+/*Tests_SRS_SASTOKEN_01_001: [ If key is NULL then SASToken_CreateKeyContext shall return NULL. ]*/
+TEST_FUNCTION(SASToken_CreateKeyContext_null_key_fails)
 {
     // arrange
-    STRING_HANDLE handle;
+    HMACSHA256_KEY_CONTEXT_HANDLE keyContext;
 
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEY_HANDLE)).SetReturn(&TEST_CHAR_ARRAY[0]);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_SCOPE_HANDLE)).SetReturn(TEST_STRING_VALUE);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEYNAME_HANDLE)).SetReturn(TEST_STRING_VALUE);
-    STRICT_EXPECTED_CALL(Base64_Decoder(&TEST_CHAR_ARRAY[0])).SetReturn(TEST_DECODEDKEY_HANDLE);
+    // act
+    keyContext = SASToken_CreateKeyContext(NULL);
 
-    STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, sizeof(TEST_TOKEN_EXPIRATION_TIME), TEST_EXPIRY)).IgnoreArgument(1).CopyOutArgumentBuffer(1, TEST_TOKEN_EXPIRATION_TIME, sizeof(TEST_TOKEN_EXPIRATION_TIME));
-    STRICT_EXPECTED_CALL(BUFFER_new()).SetReturn(TEST_HASH_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_TOBEHASHED_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_RESULT_HANDLE);
+    // assert
+    ASSERT_IS_NULL(keyContext);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
 
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, "\n"));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, TEST_TOKEN_EXPIRATION_TIME));
+/*Tests_SRS_SASTOKEN_01_002: [ The key parameter shall be decoded from base64 and a key context shall be created from the decoded key by calling HMACSHA256_KeyContext_Create. ]*/
+TEST_FUNCTION(SASToken_CreateKeyContext_succeeds)
+{
+    // arrange
+    HMACSHA256_KEY_CONTEXT_HANDLE keyContext;
 
-    STRICT_EXPECTED_CALL(STRING_length(TEST_TOBEHASHED_HANDLE)).SetReturn(TEST_LENGTH_TOBEHASHED);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_TOBEHASHED_HANDLE));
+    STRICT_EXPECTED_CALL(Base64_Decoder(&TEST_CHAR_ARRAY[0])).SetReturn(TEST_DECODEDKEY_HANDLE);
     STRICT_EXPECTED_CALL(BUFFER_length(TEST_DECODEDKEY_HANDLE)).SetReturn(TEST_LENGTH_DECODEDKEY);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_DECODEDKEY_HANDLE));
-
-    STRICT_EXPECTED_CALL(HMACSHA256_ComputeHash(IGNORED_PTR_ARG, TEST_LENGTH_DECODEDKEY, IGNORED_PTR_ARG, TEST_LENGTH_TOBEHASHED, TEST_HASH_HANDLE)).IgnoreArgument(1).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(Base64_Encoder(TEST_HASH_HANDLE)).SetReturn(TEST_BASE64SIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(URL_Encode(TEST_BASE64SIGNATURE_HANDLE)).SetReturn(TEST_URLENCODEDSIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_copy(TEST_RESULT_HANDLE, "SharedAccessSignature sr="));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&sig=")).SetReturn(1);
-
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_RESULT_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_BASE64SIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_URLENCODEDSIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_TOBEHASHED_HANDLE));
-    STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_DECODEDKEY_HANDLE)).SetReturn(TEST_PTR_DECODEDKEY);
+    STRICT_EXPECTED_CALL(HMACSHA256_KeyContext_Create(TEST_PTR_DECODEDKEY, TEST_LENGTH_DECODEDKEY)).SetReturn(TEST_KEY_CONTEXT_HANDLE);
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_DECODEDKEY_HANDLE));
 
     // act
-    handle = SASToken_Create(TEST_KEY_HANDLE, TEST_SCOPE_HANDLE, TEST_KEYNAME_HANDLE, TEST_EXPIRY);
+    keyContext = SASToken_CreateKeyContext(TEST_CHAR_ARRAY);
 
     // assert
-    ASSERT_IS_NULL(handle);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_KEY_CONTEXT_HANDLE, keyContext);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/*Tests_SRS_SASTOKEN_06_014: [If there are any errors from the following operations then NULL shall be returned.]*/
-/*Tests_SRS_SASTOKEN_06_018: [The string "&sig=" is appended to result.]*/
-TEST_FUNCTION(SASToken_Create_building_token_concat_signature_fails)
+/*Tests_SRS_SASTOKEN_01_003: [ If decoding the key or creating the key context fails then SASToken_CreateKeyContext shall return NULL. ]*/
+TEST_FUNCTION(SASToken_CreateKeyContext_decoded_key_fails)
 {
     // arrange
-    STRING_HANDLE handle;
+    HMACSHA256_KEY_CONTEXT_HANDLE keyContext;
 
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEY_HANDLE)).SetReturn(&TEST_CHAR_ARRAY[0]);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_SCOPE_HANDLE)).SetReturn(TEST_STRING_VALUE);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEYNAME_HANDLE)).SetReturn(TEST_STRING_VALUE);
-    STRICT_EXPECTED_CALL(Base64_Decoder(&TEST_CHAR_ARRAY[0])).SetReturn(TEST_DECODEDKEY_HANDLE);
+    STRICT_EXPECTED_CALL(Base64_Decoder(&TEST_CHAR_ARRAY[0])).SetReturn(TEST_NULL_BUFFER_HANDLE);
 
-    STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, sizeof(TEST_TOKEN_EXPIRATION_TIME), TEST_EXPIRY)).IgnoreArgument(1).CopyOutArgumentBuffer(1, TEST_TOKEN_EXPIRATION_TIME, sizeof(TEST_TOKEN_EXPIRATION_TIME));
-    STRICT_EXPECTED_CALL(BUFFER_new()).SetReturn(TEST_HASH_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_TOBEHASHED_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_RESULT_HANDLE);
+    // act
+    keyContext = SASToken_CreateKeyContext(TEST_CHAR_ARRAY);
 
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, "\n"));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, TEST_TOKEN_EXPIRATION_TIME));
+    // assert
+    ASSERT_IS_NULL(keyContext);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
 
-    STRICT_EXPECTED_CALL(STRING_length(TEST_TOBEHASHED_HANDLE)).SetReturn(TEST_LENGTH_TOBEHASHED);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_TOBEHASHED_HANDLE));
-    STRICT_EXPECTED_CALL(BUFFER_length(TEST_DECODEDKEY_HANDLE)).SetReturn(TEST_LENGTH_DECODEDKEY);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_DECODEDKEY_HANDLE));
+/*Tests_SRS_SASTOKEN_01_003: [ If decoding the key or creating the key context fails then SASToken_CreateKeyContext shall return NULL. ]*/
+TEST_FUNCTION(SASToken_CreateKeyContext_key_context_create_fails)
+{
+    // arrange
+    HMACSHA256_KEY_CONTEXT_HANDLE keyContext;
 
-    STRICT_EXPECTED_CALL(HMACSHA256_ComputeHash(IGNORED_PTR_ARG, TEST_LENGTH_DECODEDKEY, IGNORED_PTR_ARG, TEST_LENGTH_TOBEHASHED, TEST_HASH_HANDLE)).IgnoreArgument(1).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(Base64_Encoder(TEST_HASH_HANDLE)).SetReturn(TEST_BASE64SIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(URL_Encode(TEST_BASE64SIGNATURE_HANDLE)).SetReturn(TEST_URLENCODEDSIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_copy(TEST_RESULT_HANDLE, "SharedAccessSignature sr="));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&sig="));
-    STRICT_EXPECTED_CALL(STRING_concat_with_STRING(TEST_RESULT_HANDLE, TEST_URLENCODEDSIGNATURE_HANDLE)).SetReturn(1);
-
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_RESULT_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_BASE64SIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_URLENCODEDSIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_TOBEHASHED_HANDLE));
-    STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
+    STRICT_EXPECTED_CALL(Base64_Decoder(&TEST_CHAR_ARRAY[0])).SetReturn(TEST_DECODEDKEY_HANDLE);
+    STRICT_EXPECTED_CALL(BUFFER_length(TEST_DECODEDKEY_HANDLE)).SetReturn(TEST_LENGTH_DECODEDKEY);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_DECODEDKEY_HANDLE)).SetReturn(TEST_PTR_DECODEDKEY);
+    STRICT_EXPECTED_CALL(HMACSHA256_KeyContext_Create(TEST_PTR_DECODEDKEY, TEST_LENGTH_DECODEDKEY)).SetReturn(NULL);
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_DECODEDKEY_HANDLE));
 
     // act
-    handle = SASToken_Create(TEST_KEY_HANDLE, TEST_SCOPE_HANDLE, TEST_KEYNAME_HANDLE, TEST_EXPIRY);
+    keyContext = SASToken_CreateKeyContext(TEST_CHAR_ARRAY);
 
     // assert
-    ASSERT_IS_NULL(handle);
+    ASSERT_IS_NULL(keyContext);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/*Tests_SRS_SASTOKEN_06_014: [If there are any errors from the following operations then NULL shall be returned.]*/
-/*Tests_SRS_SASTOKEN_06_019: [The string urlEncodedSignature shall be appended to result.]*/
-TEST_FUNCTION(SASToken_Create_building_token_concat_token_expiration_time_identifier_fails)
+/*Tests_SRS_SASTOKEN_01_005: [ If keyContext or scope is NULL then SASToken_CreateStringWithKeyContext shall return NULL. ]*/
+TEST_FUNCTION(SASToken_CreateStringWithKeyContext_null_key_context_fails)
 {
     // arrange
     STRING_HANDLE handle;
 
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEY_HANDLE)).SetReturn(&TEST_CHAR_ARRAY[0]);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_SCOPE_HANDLE)).SetReturn(TEST_STRING_VALUE);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEYNAME_HANDLE)).SetReturn(TEST_STRING_VALUE);
-    STRICT_EXPECTED_CALL(Base64_Decoder(&TEST_CHAR_ARRAY[0])).SetReturn(TEST_DECODEDKEY_HANDLE);
-
-    STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, sizeof(TEST_TOKEN_EXPIRATION_TIME), TEST_EXPIRY)).IgnoreArgument(1).CopyOutArgumentBuffer(1, TEST_TOKEN_EXPIRATION_TIME, sizeof(TEST_TOKEN_EXPIRATION_TIME));
-    STRICT_EXPECTED_CALL(BUFFER_new()).SetReturn(TEST_HASH_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_TOBEHASHED_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_RESULT_HANDLE);
-
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, "\n"));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, TEST_TOKEN_EXPIRATION_TIME));
+    // act
+    handle = SASToken_CreateStringWithKeyContext(NULL, TEST_STRING_VALUE, TEST_STRING_VALUE, TEST_EXPIRY);
 
-    STRICT_EXPECTED_CALL(STRING_length(TEST_TOBEHASHED_HANDLE)).SetReturn(TEST_LENGTH_TOBEHASHED);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_TOBEHASHED_HANDLE));
-    STRICT_EXPECTED_CALL(BUFFER_length(TEST_DECODEDKEY_HANDLE)).SetReturn(TEST_LENGTH_DECODEDKEY);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_DECODEDKEY_HANDLE));
+    // assert
+    ASSERT_IS_NULL(handle);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
 
-    STRICT_EXPECTED_CALL(HMACSHA256_ComputeHash(IGNORED_PTR_ARG, TEST_LENGTH_DECODEDKEY, IGNORED_PTR_ARG, TEST_LENGTH_TOBEHASHED, TEST_HASH_HANDLE)).IgnoreArgument(1).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(Base64_Encoder(TEST_HASH_HANDLE)).SetReturn(TEST_BASE64SIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(URL_Encode(TEST_BASE64SIGNATURE_HANDLE)).SetReturn(TEST_URLENCODEDSIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_copy(TEST_RESULT_HANDLE, "SharedAccessSignature sr="));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&sig="));
-    STRICT_EXPECTED_CALL(STRING_concat_with_STRING(TEST_RESULT_HANDLE, TEST_URLENCODEDSIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&se=")).SetReturn(1);
-
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_RESULT_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_BASE64SIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_URLENCODEDSIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_TOBEHASHED_HANDLE));
-    STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
-    STRICT_EXPECTED_CALL(BUFFER_delete(TEST_DECODEDKEY_HANDLE));
+/*Tests_SRS_SASTOKEN_01_005: [ If keyContext or scope is NULL then SASToken_CreateStringWithKeyContext shall return NULL. ]*/
+TEST_FUNCTION(SASToken_CreateStringWithKeyContext_null_scope_fails)
+{
+    // arrange
+    STRING_HANDLE handle;
 
     // act
-    handle = SASToken_Create(TEST_KEY_HANDLE, TEST_SCOPE_HANDLE, TEST_KEYNAME_HANDLE, TEST_EXPIRY);
+    handle = SASToken_CreateStringWithKeyContext(TEST_KEY_CONTEXT_HANDLE, NULL, TEST_STRING_VALUE, TEST_EXPIRY);
 
     // assert
     ASSERT_IS_NULL(handle);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/*Tests_SRS_SASTOKEN_06_014: [If there are any errors from the following operations then NULL shall be returned.]*/
-/*Tests_SRS_SASTOKEN_06_020: [The string "&se=" shall be appended to result.]*/
-TEST_FUNCTION(SASToken_Create_building_token_concat_token_expiration_time_fails)
+/*Tests_SRS_SASTOKEN_01_006: [ Otherwise SASToken_CreateStringWithKeyContext shall build the token as SASToken_Create does, without decoding a key. ]*/
+/*Tests_SRS_SASTOKEN_01_004: [ The HMAC256 hash shall be calculated with HMACSHA256_ComputeHashWithKeyContext using keyContext, over toBeHashed. ]*/
+TEST_FUNCTION(SASToken_CreateStringWithKeyContext_succeeds)
 {
     // arrange
     STRING_HANDLE handle;
 
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEY_HANDLE)).SetReturn(&TEST_CHAR_ARRAY[0]);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_SCOPE_HANDLE)).SetReturn(TEST_STRING_VALUE);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEYNAME_HANDLE)).SetReturn(TEST_STRING_VALUE);
-    STRICT_EXPECTED_CALL(Base64_Decoder(&TEST_CHAR_ARRAY[0])).SetReturn(TEST_DECODEDKEY_HANDLE);
-
     STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, sizeof(TEST_TOKEN_EXPIRATION_TIME), TEST_EXPIRY)).IgnoreArgument(1).CopyOutArgumentBuffer(1, TEST_TOKEN_EXPIRATION_TIME, sizeof(TEST_TOKEN_EXPIRATION_TIME));
+
     STRICT_EXPECTED_CALL(BUFFER_new()).SetReturn(TEST_HASH_HANDLE);
     STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_TOBEHASHED_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_RESULT_HANDLE);
 
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, "\n"));
@@ -1561,50 +1467,33 @@ TEST_FUNCTION(SASToken_Create_building_token_concat_token_expiration_time_fails)
 
     STRICT_EXPECTED_CALL(STRING_length(TEST_TOBEHASHED_HANDLE)).SetReturn(TEST_LENGTH_TOBEHASHED);
     STRICT_EXPECTED_CALL(STRING_c_str(TEST_TOBEHASHED_HANDLE));
-    STRICT_EXPECTED_CALL(BUFFER_length(TEST_DECODEDKEY_HANDLE)).SetReturn(TEST_LENGTH_DECODEDKEY);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_DECODEDKEY_HANDLE));
 
-    STRICT_EXPECTED_CALL(HMACSHA256_ComputeHash(IGNORED_PTR_ARG, TEST_LENGTH_DECODEDKEY, IGNORED_PTR_ARG, TEST_LENGTH_TOBEHASHED, TEST_HASH_HANDLE)).IgnoreArgument(1).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(Base64_Encoder(TEST_HASH_HANDLE)).SetReturn(TEST_BASE64SIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(URL_Encode(TEST_BASE64SIGNATURE_HANDLE)).SetReturn(TEST_URLENCODEDSIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_copy(TEST_RESULT_HANDLE, "SharedAccessSignature sr="));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&sig="));
-    STRICT_EXPECTED_CALL(STRING_concat_with_STRING(TEST_RESULT_HANDLE, TEST_URLENCODEDSIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&se="));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, TEST_TOKEN_EXPIRATION_TIME)).SetReturn(1);
-
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_RESULT_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_BASE64SIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_URLENCODEDSIGNATURE_HANDLE));
+    STRICT_EXPECTED_CALL(HMACSHA256_ComputeHashWithKeyContext(TEST_KEY_CONTEXT_HANDLE, IGNORED_PTR_ARG, TEST_LENGTH_TOBEHASHED, TEST_HASH_HANDLE)).SetReturn(HMACSHA256_OK);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_HASH_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_length(TEST_HASH_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_malloc(86));
+    STRICT_EXPECTED_CALL(STRING_new_with_memory("SharedAccessSignature sr=Test string value&sig=AQ%3d%3d&se=7200&skn=Test string value")).SetReturn(TEST_RESULT_HANDLE);
     STRICT_EXPECTED_CALL(STRING_delete(TEST_TOBEHASHED_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
-    STRICT_EXPECTED_CALL(BUFFER_delete(TEST_DECODEDKEY_HANDLE));
 
     // act
-    handle = SASToken_Create(TEST_KEY_HANDLE, TEST_SCOPE_HANDLE, TEST_KEYNAME_HANDLE, TEST_EXPIRY);
+    handle = SASToken_CreateStringWithKeyContext(TEST_KEY_CONTEXT_HANDLE, TEST_STRING_VALUE, TEST_STRING_VALUE, TEST_EXPIRY);
 
     // assert
-    ASSERT_IS_NULL(handle);
+    ASSERT_IS_NOT_NULL(handle);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/*Tests_SRS_SASTOKEN_06_014: [If there are any errors from the following operations then NULL shall be returned.]*/
-/*Tests_SRS_SASTOKEN_06_021: [tokenExpirationTime is appended to result.]*/
-TEST_FUNCTION(SASToken_Create_building_token_concat_keyname_identifier_fails)
+/*Tests_SRS_SASTOKEN_06_013: [If an error is returned from the HMAC256 function then NULL is returned from SASToken_Create.]*/
+TEST_FUNCTION(SASToken_CreateStringWithKeyContext_HMAC256_fails)
 {
     // arrange
     STRING_HANDLE handle;
 
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEY_HANDLE)).SetReturn(&TEST_CHAR_ARRAY[0]);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_SCOPE_HANDLE)).SetReturn(TEST_STRING_VALUE);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEYNAME_HANDLE)).SetReturn(TEST_STRING_VALUE);
-    STRICT_EXPECTED_CALL(Base64_Decoder(&TEST_CHAR_ARRAY[0])).SetReturn(TEST_DECODEDKEY_HANDLE);
-
     STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, sizeof(TEST_TOKEN_EXPIRATION_TIME), TEST_EXPIRY)).IgnoreArgument(1).CopyOutArgumentBuffer(1, TEST_TOKEN_EXPIRATION_TIME, sizeof(TEST_TOKEN_EXPIRATION_TIME));
+
     STRICT_EXPECTED_CALL(BUFFER_new()).SetReturn(TEST_HASH_HANDLE);
     STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_TOBEHASHED_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_RESULT_HANDLE);
 
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, "\n"));
@@ -1612,184 +1501,190 @@ TEST_FUNCTION(SASToken_Create_building_token_concat_keyname_identifier_fails)
 
     STRICT_EXPECTED_CALL(STRING_length(TEST_TOBEHASHED_HANDLE)).SetReturn(TEST_LENGTH_TOBEHASHED);
     STRICT_EXPECTED_CALL(STRING_c_str(TEST_TOBEHASHED_HANDLE));
-    STRICT_EXPECTED_CALL(BUFFER_length(TEST_DECODEDKEY_HANDLE)).SetReturn(TEST_LENGTH_DECODEDKEY);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_DECODEDKEY_HANDLE));
 
-    STRICT_EXPECTED_CALL(HMACSHA256_ComputeHash(IGNORED_PTR_ARG, TEST_LENGTH_DECODEDKEY, IGNORED_PTR_ARG, TEST_LENGTH_TOBEHASHED, TEST_HASH_HANDLE)).IgnoreArgument(1).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(Base64_Encoder(TEST_HASH_HANDLE)).SetReturn(TEST_BASE64SIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(URL_Encode(TEST_BASE64SIGNATURE_HANDLE)).SetReturn(TEST_URLENCODEDSIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_copy(TEST_RESULT_HANDLE, "SharedAccessSignature sr="));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&sig="));
-    STRICT_EXPECTED_CALL(STRING_concat_with_STRING(TEST_RESULT_HANDLE, TEST_URLENCODEDSIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&se="));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, TEST_TOKEN_EXPIRATION_TIME));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&skn=")).SetReturn(1);
-
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_RESULT_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_BASE64SIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_URLENCODEDSIGNATURE_HANDLE));
+    STRICT_EXPECTED_CALL(HMACSHA256_ComputeHashWithKeyContext(TEST_KEY_CONTEXT_HANDLE, IGNORED_PTR_ARG, TEST_LENGTH_TOBEHASHED, TEST_HASH_HANDLE)).SetReturn(HMACSHA256_ERROR);
     STRICT_EXPECTED_CALL(STRING_delete(TEST_TOBEHASHED_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
-    STRICT_EXPECTED_CALL(BUFFER_delete(TEST_DECODEDKEY_HANDLE));
 
     // act
-    handle = SASToken_Create(TEST_KEY_HANDLE, TEST_SCOPE_HANDLE, TEST_KEYNAME_HANDLE, TEST_EXPIRY);
+    handle = SASToken_CreateStringWithKeyContext(TEST_KEY_CONTEXT_HANDLE, TEST_STRING_VALUE, TEST_STRING_VALUE, TEST_EXPIRY);
 
     // assert
     ASSERT_IS_NULL(handle);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/*Tests_SRS_SASTOKEN_06_014: [If there are any errors from the following operations then NULL shall be returned.]*/
-/*Tests_SRS_SASTOKEN_06_022: [If keyName is non-NULL, the string "&skn=" is appended to result.]*/
-TEST_FUNCTION(SASToken_Create_building_token_concat_keyname_fails)
+/*Tests_SRS_SASTOKEN_01_007: [ If items is NULL or itemCount is 0 then SASToken_CreateBatch shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(SASToken_CreateBatch_null_items_fails)
 {
     // arrange
-    STRING_HANDLE handle;
+    int result;
 
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEY_HANDLE)).SetReturn(&TEST_CHAR_ARRAY[0]);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_SCOPE_HANDLE)).SetReturn(TEST_STRING_VALUE);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEYNAME_HANDLE)).SetReturn(TEST_STRING_VALUE);
-    STRICT_EXPECTED_CALL(Base64_Decoder(&TEST_CHAR_ARRAY[0])).SetReturn(TEST_DECODEDKEY_HANDLE);
+    // act
+    result = SASToken_CreateBatch(NULL, 1);
 
-    STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, sizeof(TEST_TOKEN_EXPIRATION_TIME), TEST_EXPIRY)).IgnoreArgument(1).CopyOutArgumentBuffer(1, TEST_TOKEN_EXPIRATION_TIME, sizeof(TEST_TOKEN_EXPIRATION_TIME));
-    STRICT_EXPECTED_CALL(BUFFER_new()).SetReturn(TEST_HASH_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_TOBEHASHED_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_RESULT_HANDLE);
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
 
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, "\n"));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, TEST_TOKEN_EXPIRATION_TIME));
+/*Tests_SRS_SASTOKEN_01_007: [ If items is NULL or itemCount is 0 then SASToken_CreateBatch shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(SASToken_CreateBatch_zero_items_fails)
+{
+    // arrange
+    SAS_TOKEN_BATCH_ITEM item = { TEST_CHAR_ARRAY, TEST_STRING_VALUE, TEST_STRING_VALUE, TEST_EXPIRY, NULL };
+    int result;
 
-    STRICT_EXPECTED_CALL(STRING_length(TEST_TOBEHASHED_HANDLE)).SetReturn(TEST_LENGTH_TOBEHASHED);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_TOBEHASHED_HANDLE));
-    STRICT_EXPECTED_CALL(BUFFER_length(TEST_DECODEDKEY_HANDLE)).SetReturn(TEST_LENGTH_DECODEDKEY);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_DECODEDKEY_HANDLE));
+    // act
+    result = SASToken_CreateBatch(&item, 0);
 
-    STRICT_EXPECTED_CALL(HMACSHA256_ComputeHash(IGNORED_PTR_ARG, TEST_LENGTH_DECODEDKEY, IGNORED_PTR_ARG, TEST_LENGTH_TOBEHASHED, TEST_HASH_HANDLE)).IgnoreArgument(1).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(Base64_Encoder(TEST_HASH_HANDLE)).SetReturn(TEST_BASE64SIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(URL_Encode(TEST_BASE64SIGNATURE_HANDLE)).SetReturn(TEST_URLENCODEDSIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_copy(TEST_RESULT_HANDLE, "SharedAccessSignature sr="));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&sig="));
-    STRICT_EXPECTED_CALL(STRING_concat_with_STRING(TEST_RESULT_HANDLE, TEST_URLENCODEDSIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&se="));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, TEST_TOKEN_EXPIRATION_TIME));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&skn="));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, IGNORED_PTR_ARG)).SetReturn(1);
-
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_RESULT_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_BASE64SIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_URLENCODEDSIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_TOBEHASHED_HANDLE));
-    STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
-    STRICT_EXPECTED_CALL(BUFFER_delete(TEST_DECODEDKEY_HANDLE));
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_SASTOKEN_01_008: [ If the key or the scope of any item is NULL then SASToken_CreateBatch shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(SASToken_CreateBatch_null_key_fails)
+{
+    // arrange
+    SAS_TOKEN_BATCH_ITEM items[2] = {
+        { TEST_CHAR_ARRAY, TEST_STRING_VALUE, TEST_STRING_VALUE, TEST_EXPIRY, TEST_RESULT_HANDLE },
+        { NULL, TEST_STRING_VALUE, TEST_STRING_VALUE, TEST_EXPIRY, TEST_RESULT_HANDLE }
+    };
+    int result;
 
     // act
-    handle = SASToken_Create(TEST_KEY_HANDLE, TEST_SCOPE_HANDLE, TEST_KEYNAME_HANDLE, TEST_EXPIRY);
+    result = SASToken_CreateBatch(items, 2);
 
     // assert
-    ASSERT_IS_NULL(handle);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(items[0].token);
+    ASSERT_IS_NULL(items[1].token);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/*Tests_SRS_SASTOKEN_06_023: [The argument keyName is appended to result.]*/
-TEST_FUNCTION(SASToken_Create_succeeds)
+/*Tests_SRS_SASTOKEN_01_008: [ If the key or the scope of any item is NULL then SASToken_CreateBatch shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(SASToken_CreateBatch_null_scope_fails)
 {
     // arrange
-    STRING_HANDLE handle;
+    SAS_TOKEN_BATCH_ITEM item = { TEST_CHAR_ARRAY, NULL, TEST_STRING_VALUE, TEST_EXPIRY, NULL };
+    int result;
 
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEY_HANDLE)).SetReturn(&TEST_CHAR_ARRAY[0]);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_SCOPE_HANDLE)).SetReturn(TEST_STRING_VALUE);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_KEYNAME_HANDLE)).SetReturn(TEST_STRING_VALUE);
+    // act
+    result = SASToken_CreateBatch(&item, 1);
 
-    STRICT_EXPECTED_CALL(Base64_Decoder(&TEST_CHAR_ARRAY[0])).SetReturn(TEST_DECODEDKEY_HANDLE);
-    STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, sizeof(TEST_TOKEN_EXPIRATION_TIME), TEST_EXPIRY)).IgnoreArgument(1).CopyOutArgumentBuffer(1, TEST_TOKEN_EXPIRATION_TIME, sizeof(TEST_TOKEN_EXPIRATION_TIME));
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(item.token);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
 
+static void setup_create_batch_prepare_item_expectations(void)
+{
+    STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, sizeof(TEST_TOKEN_EXPIRATION_TIME), TEST_EXPIRY)).IgnoreArgument(1).CopyOutArgumentBuffer(1, TEST_TOKEN_EXPIRATION_TIME, sizeof(TEST_TOKEN_EXPIRATION_TIME));
+    STRICT_EXPECTED_CALL(Base64_Decoder(&TEST_CHAR_ARRAY[0])).SetReturn(TEST_DECODEDKEY_HANDLE);
     STRICT_EXPECTED_CALL(BUFFER_new()).SetReturn(TEST_HASH_HANDLE);
     STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_TOBEHASHED_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_RESULT_HANDLE);
 
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, "\n"));
     STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, TEST_TOKEN_EXPIRATION_TIME));
 
-    STRICT_EXPECTED_CALL(STRING_length(TEST_TOBEHASHED_HANDLE)).SetReturn(TEST_LENGTH_TOBEHASHED);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_TOBEHASHED_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_DECODEDKEY_HANDLE)).SetReturn(TEST_PTR_DECODEDKEY);
     STRICT_EXPECTED_CALL(BUFFER_length(TEST_DECODEDKEY_HANDLE)).SetReturn(TEST_LENGTH_DECODEDKEY);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_DECODEDKEY_HANDLE));
+    STRICT_EXPECTED_CALL(STRING_c_str(TEST_TOBEHASHED_HANDLE));
+    STRICT_EXPECTED_CALL(STRING_length(TEST_TOBEHASHED_HANDLE)).SetReturn(TEST_LENGTH_TOBEHASHED);
+}
+
+/*Tests_SRS_SASTOKEN_01_009: [ For each item SASToken_CreateBatch shall decode the key from base64 and build the string to sign as SASToken_Create does. ]*/
+/*Tests_SRS_SASTOKEN_01_010: [ SASToken_CreateBatch shall compute the signatures of all the items with one call to HMACSHA256_ComputeHashBatch. ]*/
+/*Tests_SRS_SASTOKEN_01_011: [ SASToken_CreateBatch shall then build the token of each item as SASToken_Create does and store it in the token field of the item. ]*/
+TEST_FUNCTION(SASToken_CreateBatch_succeeds)
+{
+    // arrange
+    SAS_TOKEN_BATCH_ITEM item = { TEST_CHAR_ARRAY, TEST_STRING_VALUE, TEST_STRING_VALUE, TEST_EXPIRY, NULL };
+    int result;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    setup_create_batch_prepare_item_expectations();
+
+    STRICT_EXPECTED_CALL(HMACSHA256_ComputeHashBatch(IGNORED_PTR_ARG, 1));
+
+    STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_HASH_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_length(TEST_HASH_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_malloc(86));
+    STRICT_EXPECTED_CALL(STRING_new_with_memory("SharedAccessSignature sr=Test string value&sig=AQ%3d%3d&se=7200&skn=Test string value")).SetReturn(TEST_RESULT_HANDLE);
 
-    STRICT_EXPECTED_CALL(HMACSHA256_ComputeHash(IGNORED_PTR_ARG, TEST_LENGTH_DECODEDKEY, IGNORED_PTR_ARG, TEST_LENGTH_TOBEHASHED, TEST_HASH_HANDLE)).IgnoreArgument(1).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(Base64_Encoder(TEST_HASH_HANDLE)).SetReturn(TEST_BASE64SIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(URL_Encode(TEST_BASE64SIGNATURE_HANDLE)).SetReturn(TEST_URLENCODEDSIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_copy(TEST_RESULT_HANDLE, "SharedAccessSignature sr="));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&sig="));
-    STRICT_EXPECTED_CALL(STRING_concat_with_STRING(TEST_RESULT_HANDLE, TEST_URLENCODEDSIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&se="));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, TEST_TOKEN_EXPIRATION_TIME));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&skn="));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, IGNORED_PTR_ARG));
-
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_BASE64SIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_URLENCODEDSIGNATURE_HANDLE));
     STRICT_EXPECTED_CALL(STRING_delete(TEST_TOBEHASHED_HANDLE));
-    STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_DECODEDKEY_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
-    handle = SASToken_Create(TEST_KEY_HANDLE, TEST_SCOPE_HANDLE, TEST_KEYNAME_HANDLE, TEST_EXPIRY);
+    result = SASToken_CreateBatch(&item, 1);
 
     // assert
-    ASSERT_IS_NOT_NULL(handle);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_RESULT_HANDLE, item.token);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-TEST_FUNCTION(SASToken_CreateString_succeeds)
+/*Tests_SRS_SASTOKEN_01_012: [ If any of the operations fails then SASToken_CreateBatch shall fail, destroy the tokens it created, set the token of every item to NULL and return a non-zero value. ]*/
+TEST_FUNCTION(SASToken_CreateBatch_HMAC256_fails)
 {
     // arrange
-    STRING_HANDLE handle;
+    SAS_TOKEN_BATCH_ITEM item = { TEST_CHAR_ARRAY, TEST_STRING_VALUE, TEST_STRING_VALUE, TEST_EXPIRY, NULL };
+    int result;
 
-    STRICT_EXPECTED_CALL(Base64_Decoder(&TEST_CHAR_ARRAY[0])).SetReturn(TEST_DECODEDKEY_HANDLE);
-    STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, sizeof(TEST_TOKEN_EXPIRATION_TIME), TEST_EXPIRY)).IgnoreArgument(1).CopyOutArgumentBuffer(1, TEST_TOKEN_EXPIRATION_TIME, sizeof(TEST_TOKEN_EXPIRATION_TIME));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    setup_create_batch_prepare_item_expectations();
 
-    STRICT_EXPECTED_CALL(BUFFER_new()).SetReturn(TEST_HASH_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_TOBEHASHED_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_new()).SetReturn(TEST_RESULT_HANDLE);
+    STRICT_EXPECTED_CALL(HMACSHA256_ComputeHashBatch(IGNORED_PTR_ARG, 1)).SetReturn(HMACSHA256_ERROR);
 
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, "\n"));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_TOBEHASHED_HANDLE, TEST_TOKEN_EXPIRATION_TIME));
-
-    STRICT_EXPECTED_CALL(STRING_length(TEST_TOBEHASHED_HANDLE)).SetReturn(TEST_LENGTH_TOBEHASHED);
-    STRICT_EXPECTED_CALL(STRING_c_str(TEST_TOBEHASHED_HANDLE));
-    STRICT_EXPECTED_CALL(BUFFER_length(TEST_DECODEDKEY_HANDLE)).SetReturn(TEST_LENGTH_DECODEDKEY);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(TEST_DECODEDKEY_HANDLE));
-
-    STRICT_EXPECTED_CALL(HMACSHA256_ComputeHash(IGNORED_PTR_ARG, TEST_LENGTH_DECODEDKEY, IGNORED_PTR_ARG, TEST_LENGTH_TOBEHASHED, TEST_HASH_HANDLE)).IgnoreArgument(1).IgnoreArgument(3);
-    STRICT_EXPECTED_CALL(Base64_Encoder(TEST_HASH_HANDLE)).SetReturn(TEST_BASE64SIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(URL_Encode(TEST_BASE64SIGNATURE_HANDLE)).SetReturn(TEST_URLENCODEDSIGNATURE_HANDLE);
-    STRICT_EXPECTED_CALL(STRING_copy(TEST_RESULT_HANDLE, "SharedAccessSignature sr="));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&sig="));
-    STRICT_EXPECTED_CALL(STRING_concat_with_STRING(TEST_RESULT_HANDLE, TEST_URLENCODEDSIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&se="));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, TEST_TOKEN_EXPIRATION_TIME));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, "&skn="));
-    STRICT_EXPECTED_CALL(STRING_concat(TEST_RESULT_HANDLE, IGNORED_PTR_ARG));
-
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_BASE64SIGNATURE_HANDLE));
-    STRICT_EXPECTED_CALL(STRING_delete(TEST_URLENCODEDSIGNATURE_HANDLE));
+    STRICT_EXPECTED_CALL(STRING_delete(NULL));
     STRICT_EXPECTED_CALL(STRING_delete(TEST_TOBEHASHED_HANDLE));
-    STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
     STRICT_EXPECTED_CALL(BUFFER_delete(TEST_DECODEDKEY_HANDLE));
+    STRICT_EXPECTED_CALL(BUFFER_delete(TEST_HASH_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
-    handle = SASToken_CreateString(TEST_CHAR_ARRAY, TEST_STRING_VALUE, TEST_STRING_VALUE, TEST_EXPIRY);
+    result = SASToken_CreateBatch(&item, 1);
 
     // assert
-    ASSERT_IS_NOT_NULL(handle);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(item.token);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/*Tests_SRS_SASTOKEN_01_012: [ If any of the operations fails then SASToken_CreateBatch shall fail, destroy the tokens it created, set the token of every item to NULL and return a non-zero value. ]*/
+TEST_FUNCTION(SASToken_CreateBatch_decoding_key_fails)
+{
+    // arrange
+    SAS_TOKEN_BATCH_ITEM item = { TEST_CHAR_ARRAY, TEST_STRING_VALUE, TEST_STRING_VALUE, TEST_EXPIRY, NULL };
+    int result;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(size_tToString(IGNORED_PTR_ARG, sizeof(TEST_TOKEN_EXPIRATION_TIME), TEST_EXPIRY)).IgnoreArgument(1).CopyOutArgumentBuffer(1, TEST_TOKEN_EXPIRATION_TIME, sizeof(TEST_TOKEN_EXPIRATION_TIME));
+    STRICT_EXPECTED_CALL(Base64_Decoder(&TEST_CHAR_ARRAY[0])).SetReturn(TEST_NULL_BUFFER_HANDLE);
+
+    STRICT_EXPECTED_CALL(STRING_delete(NULL));
+    STRICT_EXPECTED_CALL(STRING_delete(NULL));
+    STRICT_EXPECTED_CALL(BUFFER_delete(NULL));
+    STRICT_EXPECTED_CALL(BUFFER_delete(NULL));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = SASToken_CreateBatch(&item, 1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(item.token);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
@@ -12,9 +12,11 @@
  */
 #ifdef __cplusplus
 #include <cstddef>
+#include <cstring>
 #include <ctime>
 #else
 #include <stddef.h>
+#include <string.h>
 #include <time.h>
 #endif
 
@@ -44,6 +46,53 @@ static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
  */
 static TEST_MUTEX_HANDLE g_testByTest;
 
+static const uint8_t ABC_SHA256_DIGEST[SHA256HashSize] =
+{
+    0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+    0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad
+};
+
+static void compute_sha256(const uint8_t* bytes, unsigned int count, unsigned int first_count, uint8_t Message_Digest[SHA256HashSize])
+{
+    SHA256Context sha_ctx;
+    ASSERT_ARE_EQUAL(int, 0, SHA256Reset(&sha_ctx));
+    ASSERT_ARE_EQUAL(int, 0, SHA256Input(&sha_ctx, bytes, first_count));
+    ASSERT_ARE_EQUAL(int, 0, SHA256Input(&sha_ctx, bytes + first_count, count - first_count));
+    ASSERT_ARE_EQUAL(int, 0, SHA256Result(&sha_ctx, Message_Digest));
+}
+
+static const uint8_t ABC_SHA1_DIGEST[SHA1HashSize] =
+{
+    0xa9, 0x99, 0x3e, 0x36, 0x47, 0x06, 0x81, 0x6a, 0xba, 0x3e, 0x25, 0x71, 0x78, 0x50, 0xc2, 0x6c,
+    0x9c, 0xd0, 0xd8, 0x9d
+};
+
+static const uint8_t ABC_SHA512_DIGEST[SHA512HashSize] =
+{
+    0xdd, 0xaf, 0x35, 0xa1, 0x93, 0x61, 0x7a, 0xba, 0xcc, 0x41, 0x73, 0x49, 0xae, 0x20, 0x41, 0x31,
+    0x12, 0xe6, 0xfa, 0x4e, 0x89, 0xa9, 0x7e, 0xa2, 0x0a, 0x9e, 0xee, 0xe6, 0x4b, 0x55, 0xd3, 0x9a,
+    0x21, 0x92, 0x99, 0x2a, 0x27, 0x4f, 0xc1, 0xa8, 0x36, 0xba, 0x3c, 0x23, 0xa3, 0xfe, 0xeb, 0xbd,
+    0x45, 0x4d, 0x44, 0x23, 0x64, 0x3c, 0xe8, 0x0e, 0x2a, 0x9a, 0xc9, 0x4f, 0xa5, 0x4c, 0xa4, 0x9f
+};
+
+static void compute_sha1(const uint8_t* bytes, unsigned int count, unsigned int first_count, uint8_t Message_Digest[SHA1HashSize])
+{
+    SHA1Context sha_ctx;
+    ASSERT_ARE_EQUAL(int, 0, SHA1Reset(&sha_ctx));
+    ASSERT_ARE_EQUAL(int, 0, SHA1Input(&sha_ctx, bytes, first_count));
+    ASSERT_ARE_EQUAL(int, 0, SHA1Input(&sha_ctx, bytes + first_count, count - first_count));
+    ASSERT_ARE_EQUAL(int, 0, SHA1Result(&sha_ctx, Message_Digest));
+}
+
+static void compute_sha512(const uint8_t* bytes, unsigned int count, unsigned int first_count, uint8_t Message_Digest[SHA512HashSize])
+{
+    SHA512Context sha_ctx;
+    ASSERT_ARE_EQUAL(int, 0, SHA512Reset(&sha_ctx));
+    ASSERT_ARE_EQUAL(int, 0, SHA512Input(&sha_ctx, bytes, first_count));
+    ASSERT_ARE_EQUAL(int, 0, SHA512Input(&sha_ctx, bytes + first_count, count - first_count));
+    ASSERT_ARE_EQUAL(int, 0, SHA512Result(&sha_ctx, Message_Digest));
+}
+
 BEGIN_TEST_SUITE(sha_ut)
 
     TEST_SUITE_INITIALIZE(TestClassInitialize)
@@ -433,4 +482,220 @@ BEGIN_TEST_SUITE(sha_ut)
         //cleanup
     }
 
+    TEST_FUNCTION(SHA256UseHardwareAcceleration_0_succeeds)
+    {
+        //arrange
+        int result;
+        uint8_t Message_Digest[SHA256HashSize];
+
+        //act
+        result = SHA256UseHardwareAcceleration(0);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        compute_sha256((const uint8_t*)"abc", 3, 1, Message_Digest);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(ABC_SHA256_DIGEST, Message_Digest, SHA256HashSize));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(SHA256UseHardwareAcceleration_1_computes_the_same_digests_as_the_portable_code)
+    {
+        //arrange
+        uint8_t bytes[1000];
+        uint8_t portable_digest[SHA256HashSize];
+        uint8_t hardware_digest[SHA256HashSize];
+        unsigned int count;
+
+        for (count = 0; count < sizeof(bytes); count++)
+        {
+            bytes[count] = (uint8_t)(count * 7);
+        }
+
+        //act
+        if (SHA256UseHardwareAcceleration(1) == shaSuccess)
+        {
+            compute_sha256((const uint8_t*)"abc", 3, 1, hardware_digest);
+            ASSERT_ARE_EQUAL(int, 0, memcmp(ABC_SHA256_DIGEST, hardware_digest, SHA256HashSize));
+
+            for (count = 0; count < sizeof(bytes); count += 13)
+            {
+                ASSERT_ARE_EQUAL(int, 0, SHA256UseHardwareAcceleration(0));
+                compute_sha256(bytes, count, count / 3, portable_digest);
+                ASSERT_ARE_EQUAL(int, 0, SHA256UseHardwareAcceleration(1));
+                compute_sha256(bytes, count, count / 2, hardware_digest);
+
+                //assert
+                ASSERT_ARE_EQUAL(int, 0, memcmp(portable_digest, hardware_digest, SHA256HashSize));
+            }
+        }
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(SHA256Input_of_whole_blocks_and_of_single_bytes_compute_the_same_digest)
+    {
+        //arrange
+        uint8_t bytes[300];
+        uint8_t whole_digest[SHA256HashSize];
+        uint8_t bytewise_digest[SHA256HashSize];
+        SHA256Context sha_ctx;
+        unsigned int i;
+
+        for (i = 0; i < sizeof(bytes); i++)
+        {
+            bytes[i] = (uint8_t)i;
+        }
+
+        //act
+        compute_sha256(bytes, sizeof(bytes), 0, whole_digest);
+        (void)SHA256Reset(&sha_ctx);
+        for (i = 0; i < sizeof(bytes); i++)
+        {
+            (void)SHA256Input(&sha_ctx, &bytes[i], 1);
+        }
+        (void)SHA256Result(&sha_ctx, bytewise_digest);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, memcmp(whole_digest, bytewise_digest, SHA256HashSize));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(SHA1UseHardwareAcceleration_0_succeeds)
+    {
+        //arrange
+        int result;
+        uint8_t Message_Digest[SHA1HashSize];
+
+        //act
+        result = SHA1UseHardwareAcceleration(0);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        compute_sha1((const uint8_t*)"abc", 3, 1, Message_Digest);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(ABC_SHA1_DIGEST, Message_Digest, SHA1HashSize));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(SHA1UseHardwareAcceleration_1_computes_the_same_digests_as_the_portable_code)
+    {
+        //arrange
+        uint8_t bytes[1000];
+        uint8_t portable_digest[SHA1HashSize];
+        uint8_t hardware_digest[SHA1HashSize];
+        unsigned int count;
+
+        for (count = 0; count < sizeof(bytes); count++)
+        {
+            bytes[count] = (uint8_t)(count * 7);
+        }
+
+        //act
+        if (SHA1UseHardwareAcceleration(1) == shaSuccess)
+        {
+            compute_sha1((const uint8_t*)"abc", 3, 1, hardware_digest);
+            ASSERT_ARE_EQUAL(int, 0, memcmp(ABC_SHA1_DIGEST, hardware_digest, SHA1HashSize));
+
+            for (count = 0; count < sizeof(bytes); count += 13)
+            {
+                ASSERT_ARE_EQUAL(int, 0, SHA1UseHardwareAcceleration(0));
+                compute_sha1(bytes, count, count / 3, portable_digest);
+                ASSERT_ARE_EQUAL(int, 0, SHA1UseHardwareAcceleration(1));
+                compute_sha1(bytes, count, count / 2, hardware_digest);
+
+                //assert
+                ASSERT_ARE_EQUAL(int, 0, memcmp(portable_digest, hardware_digest, SHA1HashSize));
+            }
+        }
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(SHA512UseHardwareAcceleration_0_succeeds)
+    {
+        //arrange
+        int result;
+        uint8_t Message_Digest[SHA512HashSize];
+
+        //act
+        result = SHA512UseHardwareAcceleration(0);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        compute_sha512((const uint8_t*)"abc", 3, 1, Message_Digest);
+        ASSERT_ARE_EQUAL(int, 0, memcmp(ABC_SHA512_DIGEST, Message_Digest, SHA512HashSize));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(SHA512UseHardwareAcceleration_1_computes_the_same_digests_as_the_portable_code)
+    {
+        //arrange
+        uint8_t bytes[1000];
+        uint8_t portable_digest[SHA512HashSize];
+        uint8_t hardware_digest[SHA512HashSize];
+        unsigned int count;
+
+        for (count = 0; count < sizeof(bytes); count++)
+        {
+            bytes[count] = (uint8_t)(count * 7);
+        }
+
+        //act
+        if (SHA512UseHardwareAcceleration(1) == shaSuccess)
+        {
+            compute_sha512((const uint8_t*)"abc", 3, 1, hardware_digest);
+            ASSERT_ARE_EQUAL(int, 0, memcmp(ABC_SHA512_DIGEST, hardware_digest, SHA512HashSize));
+
+            for (count = 0; count < sizeof(bytes); count += 13)
+            {
+                ASSERT_ARE_EQUAL(int, 0, SHA512UseHardwareAcceleration(0));
+                compute_sha512(bytes, count, count / 3, portable_digest);
+                ASSERT_ARE_EQUAL(int, 0, SHA512UseHardwareAcceleration(1));
+                compute_sha512(bytes, count, count / 2, hardware_digest);
+
+                //assert
+                ASSERT_ARE_EQUAL(int, 0, memcmp(portable_digest, hardware_digest, SHA512HashSize));
+            }
+        }
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(SHA1Input_and_SHA512Input_of_whole_blocks_and_of_single_bytes_compute_the_same_digest)
+    {
+        //arrange
+        uint8_t bytes[300];
+        uint8_t whole_digest[SHA512HashSize];
+        uint8_t bytewise_digest[SHA512HashSize];
+        SHA1Context sha1_ctx;
+        SHA512Context sha512_ctx;
+        unsigned int i;
+
+        for (i = 0; i < sizeof(bytes); i++)
+        {
+            bytes[i] = (uint8_t)i;
+        }
+
+        //act
+        compute_sha1(bytes, sizeof(bytes), 0, whole_digest);
+        (void)SHA1Reset(&sha1_ctx);
+        for (i = 0; i < sizeof(bytes); i++)
+        {
+            (void)SHA1Input(&sha1_ctx, &bytes[i], 1);
+        }
+        (void)SHA1Result(&sha1_ctx, bytewise_digest);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, memcmp(whole_digest, bytewise_digest, SHA1HashSize));
+
+        //act
+        compute_sha512(bytes, sizeof(bytes), 0, whole_digest);
+        (void)SHA512Reset(&sha512_ctx);
+        for (i = 0; i < sizeof(bytes); i++)
+        {
+            (void)SHA512Input(&sha512_ctx, &bytes[i], 1);
+        }
+        (void)SHA512Result(&sha512_ctx, bytewise_digest);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, memcmp(whole_digest, bytewise_digest, SHA512HashSize));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
 END_TEST_SUITE(sha_ut)
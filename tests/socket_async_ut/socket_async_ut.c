@@ -52,6 +52,7 @@ extern "C" {
     MOCKABLE_FUNCTION(, int, connect, int, sockfd, const struct sockaddr*, addr, socklen_t, addrlen);
     MOCKABLE_FUNCTION(, int, select, int, nfds, fd_set*, readfds, fd_set*, writefds, fd_set*, exceptfds, struct timeval*, timeout);
     MOCKABLE_FUNCTION(, ssize_t, send, int, sockfd, const void*, buf, size_t, len, int, flags);
+    MOCKABLE_FUNCTION(, ssize_t, sendmsg, int, sockfd, const struct msghdr*, msg, int, flags);
     MOCKABLE_FUNCTION(, ssize_t, recv, int, sockfd, void*, buf, size_t, len, int, flags);
     MOCKABLE_FUNCTION(, int, close, int, sockfd);
 #ifdef __cplusplus
@@ -71,6 +72,9 @@ typedef enum
     SELECT_TCP_IS_COMPLETE_ERRSET_FAIL,
     SELECT_TCP_IS_COMPLETE_READY_OK,
     SELECT_TCP_IS_COMPLETE_NOT_READY_OK,
+    SELECT_WAIT_ANY_TIMEOUT,
+    SELECT_WAIT_ANY_RECEIVE_READY,
+    SELECT_WAIT_ANY_SEND_READY,
 } SELECT_BEHAVIOR;
 
 // The mocked select() function uses FD_SET, etc. macros, so it needs to be specially implemented
@@ -101,12 +105,46 @@ int my_select(int nfds, fd_set *readfds, fd_set *writefds, fd_set *exceptfds, st
         FD_ZERO(exceptfds);
         FD_ZERO(writefds);
         break;
+    // socket_async_wait_any passes in sets holding all of its sockets, so these behaviors
+    // only clear the sets of the sockets that are not ready.
+    case SELECT_WAIT_ANY_TIMEOUT:
+        FD_ZERO(readfds);
+        FD_ZERO(writefds);
+        FD_ZERO(exceptfds);
+        break;
+    case SELECT_WAIT_ANY_RECEIVE_READY:
+        FD_ZERO(writefds);
+        FD_ZERO(exceptfds);
+        break;
+    case SELECT_WAIT_ANY_SEND_READY:
+        FD_ZERO(readfds);
+        FD_ZERO(exceptfds);
+        break;
     default:
         ASSERT_FAIL("program bug");
     }
     return 0;
 }
 
+// The mocked sendmsg() records how many buffers it was given and accepts all their bytes
+static size_t sendmsg_iovlen;
+
+ssize_t my_sendmsg(int sockfd, const struct msghdr* msg, int flags)
+{
+    size_t total = 0;
+    size_t i;
+    (void)sockfd;
+    (void)flags;
+
+    sendmsg_iovlen = (size_t)msg->msg_iovlen;
+    for (i = 0; i < sendmsg_iovlen; i++)
+    {
+        total += msg->msg_iov[i].iov_len;
+    }
+
+    return (ssize_t)total;
+}
+
 /**
 * Umock error will helps you to identify errors in the test suite or in the way that you are
 *    using it, just keep it as is.
@@ -186,9 +224,11 @@ TEST_SUITE_INITIALIZE(a)
     REGISTER_GLOBAL_MOCK_RETURNS(select, 0, -1);
     REGISTER_GLOBAL_MOCK_RETURNS(send, sizeof(test_msg), sr_error);
     REGISTER_GLOBAL_MOCK_RETURNS(recv, sizeof(test_msg), sr_error);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(sendmsg, sr_error);
 
     REGISTER_GLOBAL_MOCK_HOOK(setsockopt, my_setsockopt);
     REGISTER_GLOBAL_MOCK_HOOK(select, my_select);
+    REGISTER_GLOBAL_MOCK_HOOK(sendmsg, my_sendmsg);
 }
 
 
@@ -488,6 +528,287 @@ TEST_SUITE_INITIALIZE(a)
         // no cleanup necessary
     }
 
+    /* Tests_SRS_SOCKET_ASYNC_01_001: [ If the buffers parameter is NULL and buffer_count is not 0, socket_async_send_vector shall log the error and return FAILURE. ]*/
+    /* Tests_SRS_SOCKET_ASYNC_01_002: [ If the sent_count parameter is NULL, socket_async_send_vector shall log the error and return FAILURE. ]*/
+    /* Tests_SRS_SOCKET_ASYNC_01_003: [ If a buffer with a non-zero size is NULL, socket_async_send_vector shall log the error and return FAILURE. ]*/
+    TEST_FUNCTION(socket_async_send_vector__parameter_validation__fails)
+    {
+        ///arrange
+        // no calls expected
+        size_t sent_count_receptor = BAD_BUFFER_COUNT;
+        SOCKET_ASYNC_BUFFER buffers[2] = { { test_msg, sizeof(test_msg) }, { NULL, sizeof(test_msg) } };
+
+        ///act
+        int null_buffers_result = socket_async_send_vector(test_socket, NULL, 1, &sent_count_receptor);
+        int null_sent_count_result = socket_async_send_vector(test_socket, buffers, 1, NULL);
+        int null_buffer_result = socket_async_send_vector(test_socket, buffers, 2, &sent_count_receptor);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, null_buffers_result, 0, "Unexpected send_result success when buffers is NULL");
+        ASSERT_ARE_NOT_EQUAL(int, null_sent_count_result, 0, "Unexpected send_result success when sent_count is NULL");
+        ASSERT_ARE_NOT_EQUAL(int, null_buffer_result, 0, "Unexpected send_result success when a buffer is NULL");
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        // no cleanup necessary
+    }
+
+    /* Tests_SRS_SOCKET_ASYNC_01_005: [ If all the buffers are empty, socket_async_send_vector shall set sent_count to 0 and return 0. ]*/
+    TEST_FUNCTION(socket_async_send_vector__empty_buffers__succeeds)
+    {
+        ///arrange
+        size_t sent_count_receptor = BAD_BUFFER_COUNT;
+        SOCKET_ASYNC_BUFFER buffers[2] = { { test_msg, 0 }, { NULL, 0 } };
+
+        ///act
+        int send_result = socket_async_send_vector(test_socket, buffers, 2, &sent_count_receptor);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, sent_count_receptor, 0, "Unexpected sent_count_receptor");
+        ASSERT_ARE_EQUAL(int, send_result, 0, "Unexpected send_result failure");
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        // no cleanup necessary
+    }
+
+    /* Tests_SRS_SOCKET_ASYNC_01_006: [ socket_async_send_vector shall send the buffers with a single call to the underlying sendmsg. ]*/
+    /* Tests_SRS_SOCKET_ASYNC_01_007: [ If the underlying socket accepts one or more bytes for transmission, socket_async_send_vector shall return 0 and the sent_count parameter shall receive the number of bytes accepted for transmission. ]*/
+    TEST_FUNCTION(socket_async_send_vector__succeeds)
+    {
+        ///arrange
+        int send_result;
+        size_t sent_count_receptor = BAD_BUFFER_COUNT;
+        SOCKET_ASYNC_BUFFER buffers[3] = { { test_msg, 4 }, { NULL, 0 }, { test_msg + 4, sizeof(test_msg) - 4 } };
+        sendmsg_iovlen = 0;
+
+        STRICT_EXPECTED_CALL(sendmsg(test_socket, IGNORED_PTR_ARG, SEND_ZERO_FLAGS));
+
+        ///act
+        send_result = socket_async_send_vector(test_socket, buffers, 3, &sent_count_receptor);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, sendmsg_iovlen, 2, "Unexpected number of buffers given to sendmsg");
+        ASSERT_ARE_EQUAL(size_t, sent_count_receptor, sizeof(test_msg), "Unexpected sent_count_receptor");
+        ASSERT_ARE_EQUAL(int, send_result, 0, "Unexpected send_result failure");
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        // no cleanup necessary
+    }
+
+    /* Tests_SRS_SOCKET_ASYNC_01_004: [ At most SOCKET_ASYNC_MAX_BUFFER_COUNT buffers shall be given to the underlying socket by one call. ]*/
+    TEST_FUNCTION(socket_async_send_vector__more_than_max_buffers__sends_max_buffers)
+    {
+        ///arrange
+        int send_result;
+        size_t i;
+        size_t sent_count_receptor = BAD_BUFFER_COUNT;
+        SOCKET_ASYNC_BUFFER buffers[SOCKET_ASYNC_MAX_BUFFER_COUNT + 4];
+        for (i = 0; i < sizeof(buffers) / sizeof(buffers[0]); i++)
+        {
+            buffers[i].buffer = test_msg;
+            buffers[i].size = 1;
+        }
+        sendmsg_iovlen = 0;
+
+        STRICT_EXPECTED_CALL(sendmsg(test_socket, IGNORED_PTR_ARG, SEND_ZERO_FLAGS));
+
+        ///act
+        send_result = socket_async_send_vector(test_socket, buffers, sizeof(buffers) / sizeof(buffers[0]), &sent_count_receptor);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, sendmsg_iovlen, SOCKET_ASYNC_MAX_BUFFER_COUNT, "Unexpected number of buffers given to sendmsg");
+        ASSERT_ARE_EQUAL(size_t, sent_count_receptor, SOCKET_ASYNC_MAX_BUFFER_COUNT, "Unexpected sent_count_receptor");
+        ASSERT_ARE_EQUAL(int, send_result, 0, "Unexpected send_result failure");
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        // no cleanup necessary
+    }
+
+    /* Tests_SRS_SOCKET_ASYNC_01_008: [ If the underlying socket is unable to accept any bytes for transmission because its buffer is full, socket_async_send_vector shall return 0 and the sent_count parameter shall receive the value 0. ]*/
+    TEST_FUNCTION(socket_async_send_vector__sendmsg_waiting__succeeds)
+    {
+        ///arrange
+        int send_result;
+        size_t sent_count_receptor = BAD_BUFFER_COUNT;
+        SOCKET_ASYNC_BUFFER buffers[1] = { { test_msg, sizeof(test_msg) } };
+        // getsockopt is used to get the extended error information after a socket failure
+        int getsockopt_extended_error_return_value = EXTENDED_ERROR_WAITING;
+
+        STRICT_EXPECTED_CALL(sendmsg(test_socket, IGNORED_PTR_ARG, SEND_ZERO_FLAGS)).SetReturn(SEND_FAIL_RETURN);
+        STRICT_EXPECTED_CALL(getsockopt(test_socket, SOL_SOCKET, SO_ERROR, IGNORED_NUM_ARG, IGNORED_NUM_ARG))
+            .CopyOutArgumentBuffer_optval(&getsockopt_extended_error_return_value, sizeof_int);
+
+        ///act
+        send_result = socket_async_send_vector(test_socket, buffers, 1, &sent_count_receptor);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, sent_count_receptor, 0, "Unexpected sent_count_receptor");
+        ASSERT_ARE_EQUAL(int, send_result, 0, "Unexpected send_result failure");
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        // no cleanup necessary
+    }
+
+    /* Tests_SRS_SOCKET_ASYNC_01_009: [ If the underlying sendmsg fails unexpectedly, socket_async_send_vector shall log the error and return FAILURE. ]*/
+    TEST_FUNCTION(socket_async_send_vector__sendmsg_fail__fails)
+    {
+        ///arrange
+        int send_result;
+        size_t sent_count_receptor = BAD_BUFFER_COUNT;
+        SOCKET_ASYNC_BUFFER buffers[1] = { { test_msg, sizeof(test_msg) } };
+        // getsockopt is used to get the extended error information after a socket failure
+        int getsockopt_extended_error_return_value = EXTENDED_ERROR_FAIL;
+
+        STRICT_EXPECTED_CALL(sendmsg(test_socket, IGNORED_PTR_ARG, SEND_ZERO_FLAGS)).SetReturn(SEND_FAIL_RETURN);
+        STRICT_EXPECTED_CALL(getsockopt(test_socket, SOL_SOCKET, SO_ERROR, IGNORED_NUM_ARG, IGNORED_NUM_ARG))
+            .CopyOutArgumentBuffer_optval(&getsockopt_extended_error_return_value, sizeof_int);
+
+        ///act
+        send_result = socket_async_send_vector(test_socket, buffers, 1, &sent_count_receptor);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, send_result, 0, "Unexpected send_result success");
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        // no cleanup necessary
+    }
+
+    /* Tests_SRS_SOCKET_ASYNC_01_010: [ If items is NULL, item_count is 0 or ready_count is NULL, socket_async_wait_any shall log an error and return FAILURE. ]*/
+    /* Tests_SRS_SOCKET_ASYNC_01_011: [ If a socket cannot be waited for by select, socket_async_wait_any shall log an error and return FAILURE. ]*/
+    TEST_FUNCTION(socket_async_wait_any__parameter_validation__fails)
+    {
+        ///arrange
+        // no calls expected
+        int null_items_result;
+        int zero_count_result;
+        int null_ready_count_result;
+        int invalid_socket_result;
+        size_t ready_count;
+        SOCKET_ASYNC_WAIT_ITEM items[2];
+        (void)memset(items, 0, sizeof(items));
+        items[0].sock = test_socket;
+        items[1].sock = SOCKET_ASYNC_INVALID_SOCKET;
+
+        ///act
+        null_items_result = socket_async_wait_any(NULL, 1, 0, &ready_count);
+        zero_count_result = socket_async_wait_any(items, 0, 0, &ready_count);
+        null_ready_count_result = socket_async_wait_any(items, 1, 0, NULL);
+        invalid_socket_result = socket_async_wait_any(items, 2, 0, &ready_count);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, null_items_result, 0, "Unexpected wait_result success when items is NULL");
+        ASSERT_ARE_NOT_EQUAL(int, zero_count_result, 0, "Unexpected wait_result success when item_count is 0");
+        ASSERT_ARE_NOT_EQUAL(int, null_ready_count_result, 0, "Unexpected wait_result success when ready_count is NULL");
+        ASSERT_ARE_NOT_EQUAL(int, invalid_socket_result, 0, "Unexpected wait_result success with an invalid socket");
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_SOCKET_ASYNC_01_016: [ If the underlying select fails, socket_async_wait_any shall log an error and return FAILURE. ]*/
+    TEST_FUNCTION(socket_async_wait_any__select_fail__fails)
+    {
+        ///arrange
+        int wait_result;
+        size_t ready_count;
+        SOCKET_ASYNC_WAIT_ITEM items[1];
+        int getsockopt_extended_error_return_value = EXTENDED_ERROR_FAIL;
+        (void)memset(items, 0, sizeof(items));
+        items[0].sock = test_socket;
+
+        STRICT_EXPECTED_CALL(select(test_socket + 1, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG)).SetReturn(SELECT_FAIL_RETURN);
+        STRICT_EXPECTED_CALL(getsockopt(test_socket, SOL_SOCKET, SO_ERROR, IGNORED_NUM_ARG, IGNORED_NUM_ARG))
+            .CopyOutArgumentBuffer_optval(&getsockopt_extended_error_return_value, sizeof_int);
+
+        ///act
+        wait_result = socket_async_wait_any(items, 1, 100, &ready_count);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, wait_result, 0, "Unexpected wait_result success");
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_SOCKET_ASYNC_01_012: [ socket_async_wait_any shall wait for all the sockets with a single call to the underlying select, for received bytes and errors and, for the items with wait_for_send set, for room to send. ]*/
+    /* Tests_SRS_SOCKET_ASYNC_01_015: [ If the timeout expires first, ready_count shall be set to 0. ]*/
+    TEST_FUNCTION(socket_async_wait_any__timeout__succeeds)
+    {
+        ///arrange
+        int wait_result;
+        size_t ready_count = BAD_BUFFER_COUNT;
+        SOCKET_ASYNC_WAIT_ITEM items[2];
+        (void)memset(items, 0, sizeof(items));
+        items[0].sock = test_socket + 2;
+        items[1].sock = test_socket;
+        items[1].wait_for_send = true;
+        select_behavior = SELECT_WAIT_ANY_TIMEOUT;
+
+        STRICT_EXPECTED_CALL(select(test_socket + 3, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+        ///act
+        wait_result = socket_async_wait_any(items, 2, 100, &ready_count);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, wait_result, 0, "Unexpected wait_result failure");
+        ASSERT_ARE_EQUAL(size_t, ready_count, 0, "Unexpected ready_count");
+        ASSERT_IS_FALSE(items[0].is_receive_ready || items[0].is_send_ready || items[0].has_error, "Unexpected ready state");
+        ASSERT_IS_FALSE(items[1].is_receive_ready || items[1].is_send_ready || items[1].has_error, "Unexpected ready state");
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_SOCKET_ASYNC_01_014: [ On success, socket_async_wait_any shall set the ready states of every item, set ready_count to the number of items with a ready state set and return 0. ]*/
+    TEST_FUNCTION(socket_async_wait_any__receive_ready__succeeds)
+    {
+        ///arrange
+        int wait_result;
+        size_t ready_count = BAD_BUFFER_COUNT;
+        SOCKET_ASYNC_WAIT_ITEM items[1];
+        (void)memset(items, 0, sizeof(items));
+        items[0].sock = test_socket;
+        select_behavior = SELECT_WAIT_ANY_RECEIVE_READY;
+
+        STRICT_EXPECTED_CALL(select(test_socket + 1, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+        ///act
+        wait_result = socket_async_wait_any(items, 1, 0, &ready_count);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, wait_result, 0, "Unexpected wait_result failure");
+        ASSERT_ARE_EQUAL(size_t, ready_count, 1, "Unexpected ready_count");
+        ASSERT_IS_TRUE(items[0].is_receive_ready, "Unexpected is_receive_ready");
+        ASSERT_IS_FALSE(items[0].is_send_ready, "Unexpected is_send_ready");
+        ASSERT_IS_FALSE(items[0].has_error, "Unexpected has_error");
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_SOCKET_ASYNC_01_014: [ On success, socket_async_wait_any shall set the ready states of every item, set ready_count to the number of items with a ready state set and return 0. ]*/
+    TEST_FUNCTION(socket_async_wait_any__send_ready__succeeds)
+    {
+        ///arrange
+        int wait_result;
+        size_t ready_count = BAD_BUFFER_COUNT;
+        SOCKET_ASYNC_WAIT_ITEM items[1];
+        (void)memset(items, 0, sizeof(items));
+        items[0].sock = test_socket;
+        items[0].wait_for_send = true;
+        select_behavior = SELECT_WAIT_ANY_SEND_READY;
+
+        STRICT_EXPECTED_CALL(select(test_socket + 1, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+        ///act
+        wait_result = socket_async_wait_any(items, 1, 0, &ready_count);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, wait_result, 0, "Unexpected wait_result failure");
+        ASSERT_ARE_EQUAL(size_t, ready_count, 1, "Unexpected ready_count");
+        ASSERT_IS_FALSE(items[0].is_receive_ready, "Unexpected is_receive_ready");
+        ASSERT_IS_TRUE(items[0].is_send_ready, "Unexpected is_send_ready");
+        ASSERT_IS_FALSE(items[0].has_error, "Unexpected has_error");
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
     /* Tests_SRS_SOCKET_ASYNC_30_026: [ If the is_complete parameter is NULL, socket_async_is_create_complete shall log an error and return FAILURE. ]*/
     TEST_FUNCTION(socket_async_is_create_complete__parameter_validation__fails)
     {
@@ -46,6 +46,7 @@ extern "C" {
 #define FD_CLR(n, p) *(p) = 0
 #define FD_ISSET(n, p) (*(p) == 1)
 #define FD_ZERO(p) *(p) = 0
+#define FD_SETSIZE 64
 
     typedef size_t socklen_t;
     typedef int ssize_t;
@@ -72,6 +73,21 @@ extern "C" {
         struct in_addr  sin_addr;   /* internet address */
     };
 
+    struct iovec {
+        void*   iov_base;
+        size_t  iov_len;
+    };
+
+    struct msghdr {
+        void*           msg_name;
+        socklen_t       msg_namelen;
+        struct iovec*   msg_iov;
+        size_t          msg_iovlen;
+        void*           msg_control;
+        size_t          msg_controllen;
+        int             msg_flags;
+    };
+
     struct timeval {
         long    tv_sec;         /* seconds */
         long    tv_usec;        /* and microseconds */
@@ -95,6 +111,8 @@ extern "C" {
 
     ssize_t send(int sockfd, const void *buf, size_t len, int flags);
 
+    ssize_t sendmsg(int sockfd, const struct msghdr *msg, int flags);
+
     ssize_t recv(int sockfd, void *buf, size_t len, int flags);
 
     int close(int fd);
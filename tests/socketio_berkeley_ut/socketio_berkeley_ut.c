@@ -3,30 +3,186 @@
 
 #ifdef __cplusplus
 #include <cstdint>
+#include <cstdlib>
 #else
 #include <stdint.h>
+#include <stdlib.h>
 #endif
 
 #include "testrunnerswitcher.h"
 
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
 #define ENABLE_MOCKS
 
 #include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/dns_cache.h"
+#include "azure_c_shared_utility/socket_reactor.h"
+#include "azure_c_shared_utility/constbuffer.h"
+#include "azure_c_shared_utility/constbuffer_array.h"
+#include "dns_async.h"
+#include "azure_c_shared_utility/string_intern.h"
+#include "azure_c_shared_utility/tickcounter.h"
 
 #undef ENABLE_MOCKS
 
 #include "azure_c_shared_utility/socketio.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
 
 #include <sys/types.h>
 #include <sys/socket.h>
 #include <netdb.h>
+#include <unistd.h>
+
+#define PORT_NUM 80
+#define HOSTNAME_ARG "hostname"
 
 TEST_MUTEX_HANDLE test_serialize_mutex;
 
+static TEST_MUTEX_HANDLE g_testByTest;
+
+static const char* my_string_intern(const char* value)
+{
+    return value;
+}
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
 BEGIN_TEST_SUITE(socketio_berkeley_unittests)
 
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_UMOCK_ALIAS_TYPE(CONCRETE_IO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(SOCKET_REACTOR_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_SOCKET_REACTOR_EVENT, void*);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    REGISTER_GLOBAL_MOCK_HOOK(string_intern, my_string_intern);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* socketio_setoption socket_descriptor */
+
+TEST_FUNCTION(socketio_setoption_socket_descriptor_fails_when_not_open)
+{
+    // arrange
+    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
+    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig);
+    int socket_descriptor = -42;
+    int result;
+    ASSERT_IS_NOT_NULL(ioHandle);
+    umock_c_reset_all_calls();
+
+    // act
+    result = socketio_setoption(ioHandle, OPTION_SOCKET_DESCRIPTOR, &socket_descriptor);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, -42, socket_descriptor);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(ioHandle);
+}
+
+TEST_FUNCTION(socketio_setoption_socket_descriptor_with_NULL_value_fails)
+{
+    // arrange
+    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
+    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig);
+    int result;
+    ASSERT_IS_NOT_NULL(ioHandle);
+    umock_c_reset_all_calls();
+
+    // act
+    result = socketio_setoption(ioHandle, OPTION_SOCKET_DESCRIPTOR, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(ioHandle);
+}
+
+TEST_FUNCTION(socketio_setoption_socket_descriptor_returns_the_socket_of_an_open_socketio)
+{
+    // arrange
+    int sockets[2];
+    SOCKETIO_CONFIG socketConfig = { NULL, 0, NULL };
+    CONCRETE_IO_HANDLE ioHandle;
+    int socket_descriptor = -42;
+    int result;
+
+    ASSERT_ARE_EQUAL(int, 0, socketpair(AF_UNIX, SOCK_STREAM, 0, sockets));
+    socketConfig.accepted_socket = &sockets[0];
+    ioHandle = socketio_create(&socketConfig);
+    ASSERT_IS_NOT_NULL(ioHandle);
+    ASSERT_ARE_EQUAL(int, 0, socketio_open(ioHandle, NULL, NULL, NULL, NULL, NULL, NULL));
+    umock_c_reset_all_calls();
+
+    // act
+    result = socketio_setoption(ioHandle, OPTION_SOCKET_DESCRIPTOR, &socket_descriptor);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, sockets[0], socket_descriptor);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(ioHandle);
+    (void)close(sockets[1]);
+}
+
 #if 0
 
 // SOCKETIO_SETOPTION TESTS WERE WORKING BEFORE SWITCH TO umock_c...need to finish the conversion
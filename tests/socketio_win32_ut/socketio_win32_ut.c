@@ -63,18 +63,12 @@ void my_gballoc_free(void* ptr)
 
 #include "umock_c.h"
 #include "umocktypes_charptr.h"
-#include "azure_c_shared_utility/singlylinkedlist.h"
+#include "azure_c_shared_utility/socket_reactor.h"
 static bool g_addrinfo_call_fail;
 //static int g_socket_send_size_value;
 static int g_socket_recv_size_value;
 
-static const SINGLYLINKEDLIST_HANDLE TEST_SINGLYLINKEDLIST_HANDLE = (SINGLYLINKEDLIST_HANDLE)0x4242;
-static const LIST_ITEM_HANDLE TEST_LIST_ITEM_HANDLE = (LIST_ITEM_HANDLE)0x11;
-static const void** list_items = NULL;
-static size_t list_item_count = 0;
 static SOCKET test_socket = (SOCKET)0x4243;
-static size_t list_head_count = 0;
-static bool singlylinkedlist_add_called = false;
 static size_t callbackContext = 11;
 static const struct sockaddr test_sock_addr = { 0 };
 static ADDRINFO TEST_ADDR_INFO = { AI_PASSIVE, AF_INET, SOCK_STREAM, IPPROTO_TCP, 128, NULL, (struct sockaddr*)&test_sock_addr, NULL };
@@ -89,6 +83,12 @@ static const char* TEST_BUFFER_VALUE = "test_buffer_value";
 
 static struct tcp_keepalive persisted_tcp_keepalive;
 
+static const SOCKET_REACTOR_HANDLE TEST_SOCKET_REACTOR_HANDLE = (SOCKET_REACTOR_HANDLE)0x4244;
+static ON_SOCKET_REACTOR_EVENT g_on_socket_reactor_event;
+static void* g_on_socket_reactor_event_context;
+static SOCKET_REACTOR_OVERLAPPED* g_receive_operation;
+static size_t g_bytes_received;
+
 MOCK_FUNCTION_WITH_CODE(WSAAPI, SOCKET, socket, int, af, int, type, int, protocol)
 MOCK_FUNCTION_END(test_socket)
 MOCK_FUNCTION_WITH_CODE(WSAAPI, int, closesocket, SOCKET, s)
@@ -134,72 +134,30 @@ MOCK_FUNCTION_END(0)
 MOCK_FUNCTION_WITH_CODE(WSAAPI, int, WSAIoctl, SOCKET, s, DWORD, dwIoControlCode, LPVOID, lpvInBuffer, DWORD, cbInBuffer, LPVOID, lpvOutBuffer, DWORD, cbOutBuffer, LPDWORD, lpcbBytesReturned, LPWSAOVERLAPPED, lpOverlapped, LPWSAOVERLAPPED_COMPLETION_ROUTINE, lpCompletionRoutine)
 (void)memcpy(&persisted_tcp_keepalive, lpvInBuffer, sizeof(struct tcp_keepalive));
 MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(WSAAPI, int, WSARecv, SOCKET, s, LPWSABUF, lpBuffers, DWORD, dwBufferCount, LPDWORD, lpNumberOfBytesRecvd, LPDWORD, lpFlags, LPWSAOVERLAPPED, lpOverlapped, LPWSAOVERLAPPED_COMPLETION_ROUTINE, lpCompletionRoutine)
+    g_receive_operation = CONTAINING_RECORD(lpOverlapped, SOCKET_REACTOR_OVERLAPPED, overlapped);
+MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(WSAAPI, int, WSASend, SOCKET, s, LPWSABUF, lpBuffers, DWORD, dwBufferCount, LPDWORD, lpNumberOfBytesSent, DWORD, dwFlags, LPWSAOVERLAPPED, lpOverlapped, LPWSAOVERLAPPED_COMPLETION_ROUTINE, lpCompletionRoutine)
+MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(WSAAPI, BOOL, WSAGetOverlappedResult, SOCKET, s, LPWSAOVERLAPPED, lpOverlapped, LPDWORD, lpcbTransfer, BOOL, fWait, LPDWORD, lpdwFlags)
+MOCK_FUNCTION_END(TRUE)
+MOCK_FUNCTION_WITH_CODE(WINAPI, BOOL, CancelIoEx, HANDLE, hFile, LPOVERLAPPED, lpOverlapped)
+MOCK_FUNCTION_END(TRUE)
 
-LIST_ITEM_HANDLE my_singlylinkedlist_get_head_item(SINGLYLINKEDLIST_HANDLE list)
-{
-    LIST_ITEM_HANDLE listHandle = NULL;
-    (void)list;
-    if (list_item_count > 0)
-    {
-        listHandle = (LIST_ITEM_HANDLE)list_items[0];
-        list_item_count--;
-    }
-    return listHandle;
-}
-
-LIST_ITEM_HANDLE my_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item)
-{
-    const void** items = (const void**)realloc((void*)list_items, (list_item_count + 1) * sizeof(item));
-    (void)list;
-    if (items != NULL)
-    {
-        list_items = items;
-        list_items[list_item_count++] = item;
-    }
-    singlylinkedlist_add_called = true;
-    return (LIST_ITEM_HANDLE)list_item_count;
-}
-
-const void* my_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_handle)
-{
-    const void* resultPtr = NULL;
-    if (singlylinkedlist_add_called)
-    {
-        resultPtr = item_handle;
-    }
-
-    return (const void*)resultPtr;
-}
-
-LIST_ITEM_HANDLE my_singlylinkedlist_find(SINGLYLINKEDLIST_HANDLE handle, LIST_MATCH_FUNCTION match_function, const void* match_context)
-{
-    size_t i;
-    const void* found_item = NULL;
-    (void)handle;
-    for (i = 0; i < list_item_count; i++)
-    {
-        if (match_function((LIST_ITEM_HANDLE)list_items[i], match_context))
-        {
-            found_item = list_items[i];
-            break;
-        }
-    }
-
-    return (LIST_ITEM_HANDLE)found_item;
-}
-
-void my_singlylinkedlist_destroy(SINGLYLINKEDLIST_HANDLE handle)
+static int my_socket_reactor_register(SOCKET_REACTOR_HANDLE reactor, int socket, ON_SOCKET_REACTOR_EVENT on_event, void* on_event_context)
 {
-    (void)handle;
-    free((void*)list_items);
-    list_items = NULL;
+    (void)reactor;
+    (void)socket;
+    g_on_socket_reactor_event = on_event;
+    g_on_socket_reactor_event_context = on_event_context;
+    return 0;
 }
 
 static void test_on_bytes_received(void* context, const unsigned char* buffer, size_t size)
 {
     (void)context;
     (void)buffer;
-    (void)size;
+    g_bytes_received += size;
 }
 
 static void test_on_io_open_complete(void* context, IO_OPEN_RESULT open_result)
@@ -363,8 +321,6 @@ TEST_SUITE_INITIALIZE(suite_init)
     ASSERT_ARE_EQUAL(int, 0, result);
 
     REGISTER_UMOCK_ALIAS_TYPE(CONCRETE_IO_HANDLE, void*);
-    REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
-    REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(SOCKET, void*);
     REGISTER_UMOCK_ALIAS_TYPE(PCSTR, char*);
     REGISTER_TYPE(const ADDRINFOA*, const_ADDRINFOA_ptr);
@@ -374,16 +330,17 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(LPDWORD, void*);
     REGISTER_UMOCK_ALIAS_TYPE(LPWSAOVERLAPPED, void*);
     REGISTER_UMOCK_ALIAS_TYPE(LPWSAOVERLAPPED_COMPLETION_ROUTINE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LPWSABUF, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LPOVERLAPPED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(BOOL, int);
+    REGISTER_UMOCK_ALIAS_TYPE(SOCKET_REACTOR_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_SOCKET_REACTOR_EVENT, void*);
 
-    REGISTER_GLOBAL_MOCK_RETURN(singlylinkedlist_remove, 0);
-    REGISTER_GLOBAL_MOCK_RETURN(singlylinkedlist_create, TEST_SINGLYLINKEDLIST_HANDLE);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, my_singlylinkedlist_get_head_item);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, my_singlylinkedlist_add);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_item_get_value, my_singlylinkedlist_item_get_value);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_find, my_singlylinkedlist_find);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_destroy, my_singlylinkedlist_destroy);
+    REGISTER_GLOBAL_MOCK_HOOK(socket_reactor_register, my_socket_reactor_register);
+    REGISTER_GLOBAL_MOCK_RETURN(socket_reactor_unregister, 0);
 }
 
 TEST_SUITE_CLEANUP(suite_cleanup)
@@ -404,11 +361,13 @@ TEST_FUNCTION_INITIALIZE(method_init)
 
     currentmalloc_call = 0;
     whenShallmalloc_fail = 0;
-    list_head_count = 0;
-    singlylinkedlist_add_called = false;
     g_addrinfo_call_fail = false;
     //g_socket_send_size_value = -1;
     g_socket_recv_size_value = -1;
+    g_on_socket_reactor_event = NULL;
+    g_on_socket_reactor_event_context = NULL;
+    g_receive_operation = NULL;
+    g_bytes_received = 0;
 }
 
 TEST_FUNCTION_CLEANUP(method_cleanup)
@@ -435,24 +394,6 @@ TEST_FUNCTION(socketio_create_io_create_parameters_NULL_fails)
     ASSERT_IS_NULL(ioHandle);
 }
 
-TEST_FUNCTION(socketio_create_singlylinkedlist_create_fails)
-{
-    // arrange
-    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
-    CONCRETE_IO_HANDLE ioHandle;
-
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(singlylinkedlist_create()).SetReturn((SINGLYLINKEDLIST_HANDLE)NULL);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-
-    // act
-    ioHandle = socketio_create(&socketConfig);
-
-    // assert
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_IS_NULL(ioHandle);
-}
-
 TEST_FUNCTION(socketio_create_succeeds)
 {
     // arrange
@@ -460,7 +401,6 @@ TEST_FUNCTION(socketio_create_succeeds)
     CONCRETE_IO_HANDLE ioHandle;
 
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(singlylinkedlist_create());
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
 
     // act
@@ -493,7 +433,6 @@ TEST_FUNCTION(socketio_destroy_socket_succeeds)
     socketio_open(ioHandle, test_on_io_open_complete, &callbackContext, test_on_bytes_received, &callbackContext, test_on_io_error, &callbackContext);
 
     umock_c_reset_all_calls();
-    EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
     EXPECTED_CALL(send(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG))
         .SetReturn(0);
     EXPECTED_CALL(WSAGetLastError())
@@ -503,13 +442,8 @@ TEST_FUNCTION(socketio_destroy_socket_succeeds)
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(closesocket(IGNORED_NUM_ARG));
-    EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    EXPECTED_CALL(singlylinkedlist_remove(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
-    EXPECTED_CALL(singlylinkedlist_destroy(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
@@ -837,7 +771,6 @@ TEST_FUNCTION(socketio_send_succeeds)
 
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
     EXPECTED_CALL(send(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG));
 
     // act
@@ -862,12 +795,10 @@ TEST_FUNCTION(socketio_send_returns_1_succeeds)
 
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
     EXPECTED_CALL(send(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG)).SetReturn(1);
     EXPECTED_CALL(WSAGetLastError()).SetReturn(WSAEWOULDBLOCK);
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    EXPECTED_CALL(singlylinkedlist_add(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
 
     // act
     result = socketio_send(ioHandle, (const void*)TEST_BUFFER_VALUE, TEST_BUFFER_SIZE, OnSendComplete, (void*)TEST_CALLBACK_CONTEXT);
@@ -876,7 +807,6 @@ TEST_FUNCTION(socketio_send_returns_1_succeeds)
     ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-    list_head_count = list_item_count;
     socketio_destroy(ioHandle);
 }
 
@@ -901,7 +831,6 @@ TEST_FUNCTION(socketio_dowork_succeeds)
 
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
     EXPECTED_CALL(recv(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(WSAGetLastError());
 
@@ -924,7 +853,6 @@ TEST_FUNCTION(socketio_dowork_recv_bytes_succeeds)
 
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(singlylinkedlist_get_head_item(IGNORED_PTR_ARG));
     EXPECTED_CALL(recv(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG))
         .CopyOutArgumentBuffer(2, "t", 1)
         .SetReturn(1);
@@ -1251,4 +1179,183 @@ TEST_FUNCTION(calling_socketio_setoption_with_domain_socket_address_type_succeed
 }
 #endif
 
+// socket reactor (completion port) tests
+
+static CONCRETE_IO_HANDLE setup_socket_with_reactor()
+{
+    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
+    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig);
+    int result = socketio_setoption(ioHandle, OPTION_SOCKET_REACTOR, TEST_SOCKET_REACTOR_HANDLE);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = socketio_open(ioHandle, test_on_io_open_complete, &callbackContext, test_on_bytes_received, &callbackContext, test_on_io_error, &callbackContext);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    return ioHandle;
+}
+
+TEST_FUNCTION(socketio_setoption_socket_reactor_fails_on_an_open_socket)
+{
+    // arrange
+    CONCRETE_IO_HANDLE ioHandle = setup_socket();
+
+    umock_c_reset_all_calls();
+
+    // act
+    int result = socketio_setoption(ioHandle, OPTION_SOCKET_REACTOR, TEST_SOCKET_REACTOR_HANDLE);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    verify_mocks_and_destroy_socket(ioHandle);
+}
+
+TEST_FUNCTION(socketio_open_with_socket_reactor_registers_and_posts_a_receive)
+{
+    // arrange
+    int result;
+    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
+    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig);
+    (void)socketio_setoption(ioHandle, OPTION_SOCKET_REACTOR, TEST_SOCKET_REACTOR_HANDLE);
+
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(socket(IGNORED_NUM_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG));
+    EXPECTED_CALL(getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, &TEST_ADDR_INFO, IGNORED_PTR_ARG));
+    EXPECTED_CALL(connect(IGNORED_NUM_ARG, &test_sock_addr, IGNORED_NUM_ARG));
+    EXPECTED_CALL(ioctlsocket(IGNORED_NUM_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(freeaddrinfo(&TEST_ADDR_INFO));
+    STRICT_EXPECTED_CALL(socket_reactor_register(TEST_SOCKET_REACTOR_HANDLE, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    EXPECTED_CALL(WSARecv(IGNORED_NUM_ARG, IGNORED_PTR_ARG, 1, NULL, IGNORED_PTR_ARG, IGNORED_PTR_ARG, NULL));
+
+    // act
+    result = socketio_open(ioHandle, test_on_io_open_complete, &callbackContext, test_on_bytes_received, &callbackContext, test_on_io_error, &callbackContext);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(ioHandle);
+}
+
+TEST_FUNCTION(socketio_open_with_socket_reactor_fails_when_socket_reactor_register_fails)
+{
+    // arrange
+    int result;
+    SOCKETIO_CONFIG socketConfig = { HOSTNAME_ARG, PORT_NUM, NULL };
+    CONCRETE_IO_HANDLE ioHandle = socketio_create(&socketConfig);
+    (void)socketio_setoption(ioHandle, OPTION_SOCKET_REACTOR, TEST_SOCKET_REACTOR_HANDLE);
+
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(socket(IGNORED_NUM_ARG, IGNORED_NUM_ARG, IGNORED_NUM_ARG));
+    EXPECTED_CALL(getaddrinfo(IGNORED_PTR_ARG, IGNORED_PTR_ARG, &TEST_ADDR_INFO, IGNORED_PTR_ARG));
+    EXPECTED_CALL(connect(IGNORED_NUM_ARG, &test_sock_addr, IGNORED_NUM_ARG));
+    EXPECTED_CALL(ioctlsocket(IGNORED_NUM_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(freeaddrinfo(&TEST_ADDR_INFO));
+    STRICT_EXPECTED_CALL(socket_reactor_register(TEST_SOCKET_REACTOR_HANDLE, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(__LINE__);
+    EXPECTED_CALL(closesocket(IGNORED_NUM_ARG));
+
+    // act
+    result = socketio_open(ioHandle, test_on_io_open_complete, &callbackContext, test_on_bytes_received, &callbackContext, test_on_io_error, &callbackContext);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(ioHandle);
+}
+
+TEST_FUNCTION(socketio_send_with_socket_reactor_posts_an_overlapped_send)
+{
+    // arrange
+    int result;
+    CONCRETE_IO_HANDLE ioHandle = setup_socket_with_reactor();
+
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    EXPECTED_CALL(WSASend(IGNORED_NUM_ARG, IGNORED_PTR_ARG, 1, NULL, 0, IGNORED_PTR_ARG, NULL));
+
+    // act
+    result = socketio_send(ioHandle, (const void*)TEST_BUFFER_VALUE, TEST_BUFFER_SIZE, OnSendComplete, (void*)TEST_CALLBACK_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(ioHandle);
+}
+
+TEST_FUNCTION(socketio_dowork_with_socket_reactor_and_no_completion_does_no_io)
+{
+    // arrange
+    CONCRETE_IO_HANDLE ioHandle = setup_socket_with_reactor();
+
+    umock_c_reset_all_calls();
+
+    // act
+    socketio_dowork(ioHandle);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(ioHandle);
+}
+
+TEST_FUNCTION(socketio_dowork_with_socket_reactor_indicates_a_completed_receive_and_posts_the_next_one)
+{
+    // arrange
+    CONCRETE_IO_HANDLE ioHandle = setup_socket_with_reactor();
+    ASSERT_IS_NOT_NULL(g_on_socket_reactor_event);
+    ASSERT_IS_NOT_NULL(g_receive_operation);
+
+    g_receive_operation->bytes_transferred = 5;
+    g_receive_operation->error = 0;
+    g_on_socket_reactor_event(g_on_socket_reactor_event_context, SOCKET_REACTOR_EVENT_READABLE);
+
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(WSARecv(IGNORED_NUM_ARG, IGNORED_PTR_ARG, 1, NULL, IGNORED_PTR_ARG, IGNORED_PTR_ARG, NULL));
+
+    // act
+    socketio_dowork(ioHandle);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 5, g_bytes_received);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(ioHandle);
+}
+
+TEST_FUNCTION(socketio_close_with_socket_reactor_waits_for_the_posted_receive_and_unregisters)
+{
+    // arrange
+    int result;
+    CONCRETE_IO_HANDLE ioHandle = setup_socket_with_reactor();
+
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(CancelIoEx(IGNORED_PTR_ARG, NULL));
+    EXPECTED_CALL(WSAGetOverlappedResult(IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, TRUE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(socket_reactor_unregister(TEST_SOCKET_REACTOR_HANDLE, IGNORED_NUM_ARG));
+    EXPECTED_CALL(closesocket(IGNORED_NUM_ARG));
+
+    // act
+    result = socketio_close(ioHandle, test_on_io_close_complete, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    socketio_destroy(ioHandle);
+}
+
 END_TEST_SUITE(socketio_win32_unittests)
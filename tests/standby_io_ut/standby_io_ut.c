@@ -0,0 +1,1082 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+#include "umocktypes_bool.h"
+#include "umock_c_negative_tests.h"
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+#if defined _MSC_VER
+#pragma warning(disable: 4054) /* MSC incorrectly fires this */
+#endif
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    void* real_malloc(size_t size)
+    {
+        return malloc(size);
+    }
+
+    void real_free(void* ptr)
+    {
+        free(ptr);
+    }
+
+#ifdef __cplusplus
+}
+#endif
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/constbuffer_array.h"
+#include "azure_c_shared_utility/tickcounter.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/standby_io.h"
+
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
+
+#define TEST_UNDERLYING_INTERFACE_DESCRIPTION   (const IO_INTERFACE_DESCRIPTION*)0x4242
+#define TEST_IO_HANDLE_1                        (XIO_HANDLE)0x4243
+#define TEST_IO_HANDLE_2                        (XIO_HANDLE)0x4244
+#define TEST_OPTION_HANDLER                     (OPTIONHANDLER_HANDLE)0x4245
+
+MOCK_FUNCTION_WITH_CODE(, void, test_on_io_open_complete, void*, context, IO_OPEN_RESULT, open_result)
+MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_bytes_received, void*, context, const unsigned char*, buffer, size_t, size)
+MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_io_error, void*, context)
+MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_io_close_complete, void*, context)
+MOCK_FUNCTION_END();
+MOCK_FUNCTION_WITH_CODE(, void, test_on_send_complete, void*, context, IO_SEND_RESULT, send_result)
+MOCK_FUNCTION_END();
+
+/* the callbacks given to xio_open, per underlying IO: index 0 for TEST_IO_HANDLE_1, 1 for TEST_IO_HANDLE_2 */
+static ON_IO_OPEN_COMPLETE g_on_io_open_complete[2];
+static void* g_on_io_open_complete_context[2];
+static ON_BYTES_RECEIVED g_on_bytes_received[2];
+static void* g_on_bytes_received_context[2];
+static ON_IO_ERROR g_on_io_error[2];
+static void* g_on_io_error_context[2];
+static ON_IO_CLOSE_COMPLETE g_on_io_close_complete[2];
+static void* g_on_io_close_complete_context[2];
+static size_t g_xio_create_count;
+static tickcounter_us_t g_current_us;
+
+static size_t get_io_index(XIO_HANDLE xio)
+{
+    return (xio == TEST_IO_HANDLE_1) ? 0 : 1;
+}
+
+static XIO_HANDLE my_xio_create(const IO_INTERFACE_DESCRIPTION* io_interface_description, const void* xio_create_parameters)
+{
+    (void)io_interface_description;
+    (void)xio_create_parameters;
+    g_xio_create_count++;
+    return (g_xio_create_count % 2 == 1) ? TEST_IO_HANDLE_1 : TEST_IO_HANDLE_2;
+}
+
+static int my_xio_open(XIO_HANDLE xio, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    size_t index = get_io_index(xio);
+    g_on_io_open_complete[index] = on_io_open_complete;
+    g_on_io_open_complete_context[index] = on_io_open_complete_context;
+    g_on_bytes_received[index] = on_bytes_received;
+    g_on_bytes_received_context[index] = on_bytes_received_context;
+    g_on_io_error[index] = on_io_error;
+    g_on_io_error_context[index] = on_io_error_context;
+    return 0;
+}
+
+static int my_xio_close(XIO_HANDLE xio, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    size_t index = get_io_index(xio);
+    g_on_io_close_complete[index] = on_io_close_complete;
+    g_on_io_close_complete_context[index] = callback_context;
+    return 0;
+}
+
+static int my_tickcounter_get_monotonic_us(tickcounter_us_t* monotonic_us)
+{
+    *monotonic_us = g_current_us;
+    return 0;
+}
+
+static int test_primary_parameters;
+static int test_secondary_parameters;
+
+static const STANDBY_IO_CONFIG default_standby_io_config =
+{
+    TEST_UNDERLYING_INTERFACE_DESCRIPTION,
+    &test_primary_parameters,
+    &test_secondary_parameters,
+    60000,
+    1000
+};
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+/* creates a standby IO and opens it with both links open, TEST_IO_HANDLE_1 being the link in use */
+static CONCRETE_IO_HANDLE create_and_open_standby_io(void)
+{
+    CONCRETE_IO_HANDLE standby_io = standby_io_get_interface_description()->concrete_io_create((void*)&default_standby_io_config);
+    (void)standby_io_get_interface_description()->concrete_io_open(standby_io, test_on_io_open_complete, (void*)0x4246, test_on_bytes_received, (void*)0x4247, test_on_io_error, (void*)0x4248);
+    g_on_io_open_complete[0](g_on_io_open_complete_context[0], IO_OPEN_OK);
+    g_on_io_open_complete[1](g_on_io_open_complete_context[1], IO_OPEN_OK);
+    return standby_io;
+}
+
+BEGIN_TEST_SUITE(standby_io_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, real_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, real_free);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_create, my_xio_create);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_open, my_xio_open);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_close, my_xio_close);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_monotonic_us, my_tickcounter_get_monotonic_us);
+    REGISTER_GLOBAL_MOCK_RETURN(xio_retrieveoptions, TEST_OPTION_HANDLER);
+    REGISTER_GLOBAL_MOCK_RETURN(xio_send, 0);
+    REGISTER_GLOBAL_MOCK_RETURN(xio_setoption, 0);
+    REGISTER_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT);
+    REGISTER_TYPE(IO_SEND_RESULT, IO_SEND_RESULT);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(CONSTBUFFER_ARRAY_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_CLOSE_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_SEND_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(tickcounter_us_t*, void*);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(TestMethodInitialize)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+    g_xio_create_count = 0;
+    g_current_us = 1000;
+}
+
+TEST_FUNCTION_CLEANUP(TestMethodCleanup)
+{
+    umock_c_negative_tests_deinit();
+
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* standby_io_create */
+
+/* Tests_SRS_STANDBY_IO_01_001: [ standby_io_create shall create a new instance of the standby IO. ]*/
+/* Tests_SRS_STANDBY_IO_01_003: [ io_create_parameters shall be used as a STANDBY_IO_CONFIG*. ]*/
+/* Tests_SRS_STANDBY_IO_01_005: [ standby_io_create shall create the two underlying IOs by calling xio_create with underlying_io_interface, the first one with underlying_io_parameters and the second one with standby_io_parameters, or underlying_io_parameters if standby_io_parameters is NULL. ]*/
+TEST_FUNCTION(standby_io_create_creates_both_underlying_ios)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io;
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(xio_create(TEST_UNDERLYING_INTERFACE_DESCRIPTION, &test_primary_parameters));
+    STRICT_EXPECTED_CALL(xio_create(TEST_UNDERLYING_INTERFACE_DESCRIPTION, &test_secondary_parameters));
+
+    // act
+    standby_io = standby_io_get_interface_description()->concrete_io_create((void*)&default_standby_io_config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(standby_io);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* Tests_SRS_STANDBY_IO_01_005: [ standby_io_create shall create the two underlying IOs by calling xio_create with underlying_io_interface, the first one with underlying_io_parameters and the second one with standby_io_parameters, or underlying_io_parameters if standby_io_parameters is NULL. ]*/
+TEST_FUNCTION(standby_io_create_with_NULL_standby_io_parameters_uses_the_underlying_io_parameters_twice)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io;
+    STANDBY_IO_CONFIG standby_io_config = default_standby_io_config;
+    standby_io_config.standby_io_parameters = NULL;
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(xio_create(TEST_UNDERLYING_INTERFACE_DESCRIPTION, &test_primary_parameters));
+    STRICT_EXPECTED_CALL(xio_create(TEST_UNDERLYING_INTERFACE_DESCRIPTION, &test_primary_parameters));
+
+    // act
+    standby_io = standby_io_get_interface_description()->concrete_io_create(&standby_io_config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(standby_io);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* Tests_SRS_STANDBY_IO_01_002: [ If io_create_parameters is NULL, standby_io_create shall fail and return NULL. ]*/
+TEST_FUNCTION(standby_io_create_with_NULL_io_create_parameters_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io;
+
+    // act
+    standby_io = standby_io_get_interface_description()->concrete_io_create(NULL);
+
+    // assert
+    ASSERT_IS_NULL(standby_io);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_STANDBY_IO_01_004: [ If underlying_io_interface or underlying_io_parameters is NULL, standby_io_create shall fail and return NULL. ]*/
+TEST_FUNCTION(standby_io_create_with_NULL_underlying_io_interface_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io;
+    STANDBY_IO_CONFIG standby_io_config = default_standby_io_config;
+    standby_io_config.underlying_io_interface = NULL;
+
+    // act
+    standby_io = standby_io_get_interface_description()->concrete_io_create(&standby_io_config);
+
+    // assert
+    ASSERT_IS_NULL(standby_io);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_STANDBY_IO_01_004: [ If underlying_io_interface or underlying_io_parameters is NULL, standby_io_create shall fail and return NULL. ]*/
+TEST_FUNCTION(standby_io_create_with_NULL_underlying_io_parameters_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io;
+    STANDBY_IO_CONFIG standby_io_config = default_standby_io_config;
+    standby_io_config.underlying_io_parameters = NULL;
+
+    // act
+    standby_io = standby_io_get_interface_description()->concrete_io_create(&standby_io_config);
+
+    // assert
+    ASSERT_IS_NULL(standby_io);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_STANDBY_IO_01_006: [ If any failure occurs, standby_io_create shall free what it created and return NULL. ]*/
+TEST_FUNCTION(when_creating_the_standby_underlying_io_fails_standby_io_create_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io;
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(xio_create(TEST_UNDERLYING_INTERFACE_DESCRIPTION, &test_primary_parameters));
+    STRICT_EXPECTED_CALL(xio_create(TEST_UNDERLYING_INTERFACE_DESCRIPTION, &test_secondary_parameters))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE_1));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    standby_io = standby_io_get_interface_description()->concrete_io_create((void*)&default_standby_io_config);
+
+    // assert
+    ASSERT_IS_NULL(standby_io);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* standby_io_destroy */
+
+/* Tests_SRS_STANDBY_IO_01_008: [ If standby_io is NULL, standby_io_destroy shall do nothing. ]*/
+TEST_FUNCTION(standby_io_destroy_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    standby_io_get_interface_description()->concrete_io_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_STANDBY_IO_01_007: [ standby_io_destroy shall close the underlying IOs that are not closed by calling xio_close, destroy them by calling xio_destroy and free the instance. ]*/
+TEST_FUNCTION(standby_io_destroy_closes_and_destroys_both_underlying_ios)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = create_and_open_standby_io();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE_1, NULL, NULL));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE_2, NULL, NULL));
+    STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE_1));
+    STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE_2));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* standby_io_open */
+
+/* Tests_SRS_STANDBY_IO_01_016: [ If the link used is closed, standby_io_open shall open it by calling xio_open. ]*/
+/* Tests_SRS_STANDBY_IO_01_018: [ On success standby_io_open shall also open the other link in the background if it is closed, by calling xio_open. ]*/
+/* Tests_SRS_STANDBY_IO_01_019: [ On success standby_io_open shall return 0. ]*/
+TEST_FUNCTION(standby_io_open_opens_both_links)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = standby_io_get_interface_description()->concrete_io_create((void*)&default_standby_io_config);
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE_1, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_open_complete()
+        .IgnoreArgument_on_io_open_complete_context()
+        .IgnoreArgument_on_bytes_received()
+        .IgnoreArgument_on_bytes_received_context()
+        .IgnoreArgument_on_io_error()
+        .IgnoreArgument_on_io_error_context();
+    EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE_2, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_open_complete()
+        .IgnoreArgument_on_io_open_complete_context()
+        .IgnoreArgument_on_bytes_received()
+        .IgnoreArgument_on_bytes_received_context()
+        .IgnoreArgument_on_io_error()
+        .IgnoreArgument_on_io_error_context();
+
+    // act
+    result = standby_io_get_interface_description()->concrete_io_open(standby_io, test_on_io_open_complete, (void*)0x4246, test_on_bytes_received, (void*)0x4247, test_on_io_error, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* Tests_SRS_STANDBY_IO_01_010: [ If any of the arguments standby_io, on_io_open_complete, on_bytes_received or on_io_error are NULL then standby_io_open shall return a non-zero value. ]*/
+TEST_FUNCTION(standby_io_open_with_NULL_standby_io_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = standby_io_get_interface_description()->concrete_io_open(NULL, test_on_io_open_complete, (void*)0x4246, test_on_bytes_received, (void*)0x4247, test_on_io_error, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_STANDBY_IO_01_010: [ If any of the arguments standby_io, on_io_open_complete, on_bytes_received or on_io_error are NULL then standby_io_open shall return a non-zero value. ]*/
+TEST_FUNCTION(standby_io_open_with_NULL_on_io_error_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = standby_io_get_interface_description()->concrete_io_create((void*)&default_standby_io_config);
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = standby_io_get_interface_description()->concrete_io_open(standby_io, test_on_io_open_complete, (void*)0x4246, test_on_bytes_received, (void*)0x4247, NULL, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* Tests_SRS_STANDBY_IO_01_011: [ If the standby IO is not CLOSED, standby_io_open shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(standby_io_open_when_open_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = create_and_open_standby_io();
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = standby_io_get_interface_description()->concrete_io_open(standby_io, test_on_io_open_complete, (void*)0x4246, test_on_bytes_received, (void*)0x4247, test_on_io_error, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* Tests_SRS_STANDBY_IO_01_017: [ If xio_open fails, standby_io_open shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_xio_open_fails_standby_io_open_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = standby_io_get_interface_description()->concrete_io_create((void*)&default_standby_io_config);
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE_1, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_open_complete()
+        .IgnoreArgument_on_io_open_complete_context()
+        .IgnoreArgument_on_bytes_received()
+        .IgnoreArgument_on_bytes_received_context()
+        .IgnoreArgument_on_io_error()
+        .IgnoreArgument_on_io_error_context()
+        .SetReturn(1);
+    EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+
+    // act
+    result = standby_io_get_interface_description()->concrete_io_open(standby_io, test_on_io_open_complete, (void*)0x4246, test_on_bytes_received, (void*)0x4247, test_on_io_error, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* on_link_open_complete */
+
+/* Tests_SRS_STANDBY_IO_01_020: [ When the link being opened for the layer above completes its open, the standby IO shall be OPEN and on_io_open_complete shall be called with IO_OPEN_OK. ]*/
+TEST_FUNCTION(when_the_link_in_use_opens_on_io_open_complete_is_called_with_IO_OPEN_OK)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = standby_io_get_interface_description()->concrete_io_create((void*)&default_standby_io_config);
+    (void)standby_io_get_interface_description()->concrete_io_open(standby_io, test_on_io_open_complete, (void*)0x4246, test_on_bytes_received, (void*)0x4247, test_on_io_error, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4246, IO_OPEN_OK));
+
+    // act
+    g_on_io_open_complete[0](g_on_io_open_complete_context[0], IO_OPEN_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* Tests_SRS_STANDBY_IO_01_020: [ When the link being opened for the layer above completes its open, the standby IO shall be OPEN and on_io_open_complete shall be called with IO_OPEN_OK. ]*/
+TEST_FUNCTION(when_the_standby_link_opens_on_io_open_complete_is_not_called)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = standby_io_get_interface_description()->concrete_io_create((void*)&default_standby_io_config);
+    (void)standby_io_get_interface_description()->concrete_io_open(standby_io, test_on_io_open_complete, (void*)0x4246, test_on_bytes_received, (void*)0x4247, test_on_io_error, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+
+    // act
+    g_on_io_open_complete[1](g_on_io_open_complete_context[1], IO_OPEN_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* Tests_SRS_STANDBY_IO_01_021: [ If the link being opened fails while the standby link is open, the standby link shall be used, the standby IO shall be OPEN and on_io_open_complete shall be called with IO_OPEN_OK. ]*/
+/* Tests_SRS_STANDBY_IO_01_024: [ A link that fails shall be closed by calling xio_close, and shall not be opened in the background before retry_interval_ms has passed. ]*/
+TEST_FUNCTION(when_the_link_in_use_fails_to_open_and_the_standby_link_is_open_the_standby_link_is_used)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = standby_io_get_interface_description()->concrete_io_create((void*)&default_standby_io_config);
+    (void)standby_io_get_interface_description()->concrete_io_open(standby_io, test_on_io_open_complete, (void*)0x4246, test_on_bytes_received, (void*)0x4247, test_on_io_error, (void*)0x4248);
+    g_on_io_open_complete[1](g_on_io_open_complete_context[1], IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE_1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4246, IO_OPEN_OK));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE_2, IGNORED_PTR_ARG, 1, NULL, NULL))
+        .IgnoreArgument_buffer();
+
+    // act
+    g_on_io_open_complete[0](g_on_io_open_complete_context[0], IO_OPEN_ERROR);
+    (void)standby_io_get_interface_description()->concrete_io_send(standby_io, "a", 1, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* Tests_SRS_STANDBY_IO_01_023: [ Otherwise the standby IO shall be CLOSED and on_io_open_complete shall be called with IO_OPEN_ERROR. ]*/
+TEST_FUNCTION(when_both_links_fail_to_open_on_io_open_complete_is_called_with_IO_OPEN_ERROR)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = standby_io_get_interface_description()->concrete_io_create((void*)&default_standby_io_config);
+    (void)standby_io_get_interface_description()->concrete_io_open(standby_io, test_on_io_open_complete, (void*)0x4246, test_on_bytes_received, (void*)0x4247, test_on_io_error, (void*)0x4248);
+    g_on_io_open_complete[1](g_on_io_open_complete_context[1], IO_OPEN_ERROR);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE_1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4246, IO_OPEN_ERROR));
+
+    // act
+    g_on_io_open_complete[0](g_on_io_open_complete_context[0], IO_OPEN_ERROR);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* on_link_error */
+
+/* Tests_SRS_STANDBY_IO_01_024: [ A link that fails shall be closed by calling xio_close, and shall not be opened in the background before retry_interval_ms has passed. ]*/
+/* Tests_SRS_STANDBY_IO_01_025: [ When the link in use fails while the standby IO is OPEN, the standby IO shall be in ERROR and on_io_error shall be called. ]*/
+TEST_FUNCTION(when_the_link_in_use_fails_on_io_error_is_called)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = create_and_open_standby_io();
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE_1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(test_on_io_error((void*)0x4248));
+
+    // act
+    g_on_io_error[0](g_on_io_error_context[0]);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* Tests_SRS_STANDBY_IO_01_026: [ If the standby link is open, it shall become the link in use by the next open. ]*/
+/* Tests_SRS_STANDBY_IO_01_036: [ standby_io_close in ERROR shall leave the links as they are, the standby IO shall be CLOSED and on_io_close_complete shall be called before standby_io_close returns, if it is not NULL. ]*/
+/* Tests_SRS_STANDBY_IO_01_013: [ If the link used is open, the standby IO shall be OPEN and on_io_open_complete shall be called with IO_OPEN_OK before standby_io_open returns. ]*/
+TEST_FUNCTION(after_the_link_in_use_fails_close_and_open_complete_at_once_on_the_standby_link)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = create_and_open_standby_io();
+    int close_result;
+    int open_result;
+    g_on_io_error[0](g_on_io_error_context[0]);
+    g_on_io_close_complete[0](g_on_io_close_complete_context[0]);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_io_close_complete((void*)0x4249));
+    STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4246, IO_OPEN_OK));
+    EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE_2, IGNORED_PTR_ARG, 1, NULL, NULL))
+        .IgnoreArgument_buffer();
+
+    // act
+    close_result = standby_io_get_interface_description()->concrete_io_close(standby_io, test_on_io_close_complete, (void*)0x4249);
+    open_result = standby_io_get_interface_description()->concrete_io_open(standby_io, test_on_io_open_complete, (void*)0x4246, test_on_bytes_received, (void*)0x4247, test_on_io_error, (void*)0x4248);
+    (void)standby_io_get_interface_description()->concrete_io_send(standby_io, "a", 1, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, close_result);
+    ASSERT_ARE_EQUAL(int, 0, open_result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* on_link_bytes_received */
+
+/* Tests_SRS_STANDBY_IO_01_027: [ The bytes received on the link in use while the standby IO is OPEN shall be indicated by calling on_bytes_received. ]*/
+TEST_FUNCTION(bytes_received_on_the_link_in_use_are_indicated)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = create_and_open_standby_io();
+    const unsigned char test_bytes[] = { 0x42, 0x43 };
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_bytes_received((void*)0x4247, IGNORED_PTR_ARG, sizeof(test_bytes)))
+        .ValidateArgumentBuffer(2, test_bytes, sizeof(test_bytes));
+
+    // act
+    g_on_bytes_received[0](g_on_bytes_received_context[0], test_bytes, sizeof(test_bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* Tests_SRS_STANDBY_IO_01_028: [ Bytes received on an idle link shall close it as failed. ]*/
+TEST_FUNCTION(bytes_received_on_the_standby_link_close_it)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = create_and_open_standby_io();
+    const unsigned char test_bytes[] = { 0x42 };
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE_2, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context();
+
+    // act
+    g_on_bytes_received[1](g_on_bytes_received_context[1], test_bytes, sizeof(test_bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* standby_io_close */
+
+/* Tests_SRS_STANDBY_IO_01_033: [ If standby_io is NULL, standby_io_close shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(standby_io_close_with_NULL_standby_io_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = standby_io_get_interface_description()->concrete_io_close(NULL, test_on_io_close_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_STANDBY_IO_01_034: [ If the standby IO is CLOSED or CLOSING, standby_io_close shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(standby_io_close_when_closed_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = standby_io_get_interface_description()->concrete_io_create((void*)&default_standby_io_config);
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = standby_io_get_interface_description()->concrete_io_close(standby_io, test_on_io_close_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* Tests_SRS_STANDBY_IO_01_030: [ standby_io_close while OPEN shall close the link in use by calling xio_close. The standby link stays open. ]*/
+/* Tests_SRS_STANDBY_IO_01_031: [ When the link in use completes its close while the standby IO is CLOSING, the standby IO shall be CLOSED and on_io_close_complete shall be called, if it is not NULL. ]*/
+/* Tests_SRS_STANDBY_IO_01_037: [ On success standby_io_close shall return 0. ]*/
+TEST_FUNCTION(standby_io_close_closes_only_the_link_in_use)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = create_and_open_standby_io();
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE_1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(test_on_io_close_complete((void*)0x4249));
+
+    // act
+    result = standby_io_get_interface_description()->concrete_io_close(standby_io, test_on_io_close_complete, (void*)0x4249);
+    g_on_io_close_complete[0](g_on_io_close_complete_context[0]);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* Tests_SRS_STANDBY_IO_01_032: [ If xio_close fails, standby_io_close shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_xio_close_fails_standby_io_close_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = create_and_open_standby_io();
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE_1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context()
+        .SetReturn(1);
+
+    // act
+    result = standby_io_get_interface_description()->concrete_io_close(standby_io, test_on_io_close_complete, (void*)0x4249);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* Tests_SRS_STANDBY_IO_01_035: [ standby_io_close while OPENING shall close the link being opened and call on_io_open_complete with IO_OPEN_CANCELLED. ]*/
+TEST_FUNCTION(standby_io_close_while_opening_cancels_the_open)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = standby_io_get_interface_description()->concrete_io_create((void*)&default_standby_io_config);
+    int result;
+    (void)standby_io_get_interface_description()->concrete_io_open(standby_io, test_on_io_open_complete, (void*)0x4246, test_on_bytes_received, (void*)0x4247, test_on_io_error, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE_1, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(test_on_io_open_complete((void*)0x4246, IO_OPEN_CANCELLED));
+
+    // act
+    result = standby_io_get_interface_description()->concrete_io_close(standby_io, test_on_io_close_complete, (void*)0x4249);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* standby_io_send */
+
+/* Tests_SRS_STANDBY_IO_01_044: [ standby_io_send shall send the bytes by calling xio_send on the link in use. ]*/
+/* Tests_SRS_STANDBY_IO_01_046: [ On success standby_io_send shall return 0. ]*/
+TEST_FUNCTION(standby_io_send_sends_on_the_link_in_use)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = create_and_open_standby_io();
+    const unsigned char test_bytes[] = { 0x42, 0x43 };
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE_1, test_bytes, sizeof(test_bytes), test_on_send_complete, (void*)0x4250));
+
+    // act
+    result = standby_io_get_interface_description()->concrete_io_send(standby_io, test_bytes, sizeof(test_bytes), test_on_send_complete, (void*)0x4250);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* Tests_SRS_STANDBY_IO_01_042: [ If standby_io or buffer is NULL or size is 0, standby_io_send shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(standby_io_send_with_0_size_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = create_and_open_standby_io();
+    const unsigned char test_bytes[] = { 0x42 };
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = standby_io_get_interface_description()->concrete_io_send(standby_io, test_bytes, 0, test_on_send_complete, (void*)0x4250);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* Tests_SRS_STANDBY_IO_01_043: [ If the standby IO is not OPEN, standby_io_send shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(standby_io_send_in_error_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = create_and_open_standby_io();
+    const unsigned char test_bytes[] = { 0x42 };
+    int result;
+    g_on_io_error[0](g_on_io_error_context[0]);
+    umock_c_reset_all_calls();
+
+    // act
+    result = standby_io_get_interface_description()->concrete_io_send(standby_io, test_bytes, sizeof(test_bytes), test_on_send_complete, (void*)0x4250);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* Tests_SRS_STANDBY_IO_01_045: [ If xio_send fails, standby_io_send shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_xio_send_fails_standby_io_send_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = create_and_open_standby_io();
+    const unsigned char test_bytes[] = { 0x42 };
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE_1, test_bytes, sizeof(test_bytes), test_on_send_complete, (void*)0x4250))
+        .SetReturn(1);
+
+    // act
+    result = standby_io_get_interface_description()->concrete_io_send(standby_io, test_bytes, sizeof(test_bytes), test_on_send_complete, (void*)0x4250);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* standby_io_dowork */
+
+/* Tests_SRS_STANDBY_IO_01_039: [ If standby_io is NULL, standby_io_dowork shall do nothing. ]*/
+TEST_FUNCTION(standby_io_dowork_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    standby_io_get_interface_description()->concrete_io_dowork(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_STANDBY_IO_01_038: [ standby_io_dowork shall call xio_dowork on each link that is not closed. ]*/
+TEST_FUNCTION(standby_io_dowork_works_both_links)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = create_and_open_standby_io();
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE_1));
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE_2));
+    EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+
+    // act
+    standby_io_get_interface_description()->concrete_io_dowork(standby_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* Tests_SRS_STANDBY_IO_01_024: [ A link that fails shall be closed by calling xio_close, and shall not be opened in the background before retry_interval_ms has passed. ]*/
+/* Tests_SRS_STANDBY_IO_01_040: [ If the standby link is closed and the retry interval since its last failure has passed, it shall be opened by calling xio_open. ]*/
+TEST_FUNCTION(standby_io_dowork_reopens_a_failed_standby_link_after_the_retry_interval)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = create_and_open_standby_io();
+    g_on_io_error[1](g_on_io_error_context[1]);
+    g_on_io_close_complete[1](g_on_io_close_complete_context[1]);
+    g_current_us += 999999;
+    standby_io_get_interface_description()->concrete_io_dowork(standby_io);
+    g_current_us += 1;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE_1));
+    EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE_2, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_open_complete()
+        .IgnoreArgument_on_io_open_complete_context()
+        .IgnoreArgument_on_bytes_received()
+        .IgnoreArgument_on_bytes_received_context()
+        .IgnoreArgument_on_io_error()
+        .IgnoreArgument_on_io_error_context();
+
+    // act
+    standby_io_get_interface_description()->concrete_io_dowork(standby_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* Tests_SRS_STANDBY_IO_01_041: [ If the standby link has been open and idle for refresh_interval_ms and refresh_interval_ms is not 0, it shall be closed by calling xio_close and opened again once closed. ]*/
+TEST_FUNCTION(standby_io_dowork_refreshes_an_idle_standby_link)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = create_and_open_standby_io();
+    g_current_us += 60000000;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE_1));
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE_2));
+    EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE_2, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context();
+
+    // act
+    standby_io_get_interface_description()->concrete_io_dowork(standby_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* standby_io_set_option */
+
+/* Tests_SRS_STANDBY_IO_01_055: [ standby_io_set_option shall set the option on both links by calling xio_setoption. ]*/
+TEST_FUNCTION(standby_io_set_option_sets_the_option_on_both_links)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = standby_io_get_interface_description()->concrete_io_create((void*)&default_standby_io_config);
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_IO_HANDLE_1, "option", (void*)0x4251));
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_IO_HANDLE_2, "option", (void*)0x4251));
+
+    // act
+    result = standby_io_get_interface_description()->concrete_io_setoption(standby_io, "option", (void*)0x4251);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* Tests_SRS_STANDBY_IO_01_057: [ If xio_setoption fails for either link, standby_io_set_option shall return a non-zero value. ]*/
+TEST_FUNCTION(when_xio_setoption_fails_for_the_standby_link_standby_io_set_option_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = standby_io_get_interface_description()->concrete_io_create((void*)&default_standby_io_config);
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_IO_HANDLE_1, "option", (void*)0x4251));
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_IO_HANDLE_2, "option", (void*)0x4251))
+        .SetReturn(1);
+
+    // act
+    result = standby_io_get_interface_description()->concrete_io_setoption(standby_io, "option", (void*)0x4251);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* standby_io_retrieve_options */
+
+/* Tests_SRS_STANDBY_IO_01_058: [ standby_io_retrieve_options shall return the result of xio_retrieveoptions on the link in use. ]*/
+TEST_FUNCTION(standby_io_retrieve_options_returns_the_options_of_the_link_in_use)
+{
+    // arrange
+    CONCRETE_IO_HANDLE standby_io = standby_io_get_interface_description()->concrete_io_create((void*)&default_standby_io_config);
+    OPTIONHANDLER_HANDLE result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE_1));
+
+    // act
+    result = standby_io_get_interface_description()->concrete_io_retrieveoptions(standby_io);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTION_HANDLER, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    standby_io_get_interface_description()->concrete_io_destroy(standby_io);
+}
+
+/* standby_io_get_interface_description */
+
+/* Tests_SRS_STANDBY_IO_01_059: [ standby_io_get_interface_description shall return a pointer to an IO_INTERFACE_DESCRIPTION structure that contains pointers to the functions of the standby IO. ]*/
+TEST_FUNCTION(standby_io_get_interface_description_returns_all_the_functions)
+{
+    // arrange
+
+    // act
+    const IO_INTERFACE_DESCRIPTION* io_interface = standby_io_get_interface_description();
+
+    // assert
+    ASSERT_IS_NOT_NULL(io_interface);
+    ASSERT_IS_NOT_NULL((void*)io_interface->concrete_io_retrieveoptions);
+    ASSERT_IS_NOT_NULL((void*)io_interface->concrete_io_create);
+    ASSERT_IS_NOT_NULL((void*)io_interface->concrete_io_destroy);
+    ASSERT_IS_NOT_NULL((void*)io_interface->concrete_io_open);
+    ASSERT_IS_NOT_NULL((void*)io_interface->concrete_io_close);
+    ASSERT_IS_NOT_NULL((void*)io_interface->concrete_io_send);
+    ASSERT_IS_NOT_NULL((void*)io_interface->concrete_io_dowork);
+    ASSERT_IS_NOT_NULL((void*)io_interface->concrete_io_setoption);
+    ASSERT_IS_NOT_NULL((void*)io_interface->concrete_io_sendv);
+    ASSERT_IS_NOT_NULL((void*)io_interface->concrete_io_send_constbuffer_array);
+    ASSERT_IS_NOT_NULL((void*)io_interface->concrete_io_get_stats);
+    ASSERT_IS_NOT_NULL((void*)io_interface->concrete_io_dowork_ex);
+    ASSERT_IS_NOT_NULL((void*)io_interface->concrete_io_get_pollable_handle);
+}
+
+END_TEST_SUITE(standby_io_unittests)
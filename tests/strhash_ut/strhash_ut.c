@@ -0,0 +1,347 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#endif
+
+#include "macro_utils.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_stdint.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gb_rand.h"
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/strhash.h"
+
+/* the lowest bit is clear so that the tests see it being set */
+#define TEST_RANDOM_SEED 0x0123456789abcdeeull
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+static unsigned char test_bytes[256];
+static unsigned char test_bytes_other_case[256];
+
+BEGIN_TEST_SUITE(strhash_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+    size_t i;
+
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result, "umock_c_init");
+
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_stdint_register_types");
+
+    REGISTER_GLOBAL_MOCK_RETURN(gb_rand_uint64, TEST_RANDOM_SEED);
+
+    /* printable ASCII with both cases of every letter, and bytes above 0x7f that must not be folded */
+    for (i = 0; i < sizeof(test_bytes); i++)
+    {
+        unsigned char c = (unsigned char)((i < 192) ? (0x20 + (i % 0x5f)) : (0x80 + i));
+        test_bytes[i] = c;
+        test_bytes_other_case[i] = ((c >= 'a') && (c <= 'z')) ? (unsigned char)(c - 'a' + 'A') : ((c >= 'A') && (c <= 'Z')) ? (unsigned char)(c - 'A' + 'a') : c;
+    }
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/* strhash_get_process_seed */
+
+/* this test has to run first, before anything in the process has drawn the seed */
+/* Tests_SRS_STRHASH_01_001: [ The first time the seed is needed `strhash_get_process_seed` shall draw it with `gb_rand_uint64`, with its lowest bit set so that it is never 0. ]*/
+TEST_FUNCTION(strhash_get_process_seed_draws_the_seed_once)
+{
+    // arrange
+    uint64_t first;
+    uint64_t second;
+    STRICT_EXPECTED_CALL(gb_rand_uint64());
+
+    // act
+    first = strhash_get_process_seed();
+    second = strhash_get_process_seed();
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, TEST_RANDOM_SEED | 1, first);
+    ASSERT_ARE_EQUAL(uint64_t, first, second);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* strhash_bytes */
+
+/* Tests_SRS_STRHASH_01_003: [ `strhash_bytes` shall return the hash of the `length` bytes at `data` with the seed of the process. ]*/
+TEST_FUNCTION(strhash_bytes_hashes_with_the_process_seed)
+{
+    // arrange
+    uint64_t seed = strhash_get_process_seed();
+    size_t length;
+    umock_c_reset_all_calls();
+
+    // act
+    // assert
+    for (length = 0; length <= sizeof(test_bytes); length++)
+    {
+        ASSERT_ARE_EQUAL(uint64_t, strhash_bytes_with_seed(test_bytes, length, seed), strhash_bytes(test_bytes, length));
+    }
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_STRHASH_01_003: [ `strhash_bytes` shall return the hash of the `length` bytes at `data` with the seed of the process. ]*/
+TEST_FUNCTION(strhash_bytes_with_NULL_data_and_0_length_succeeds)
+{
+    // arrange
+    char empty = 0;
+
+    // act
+    uint64_t result = strhash_bytes(NULL, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, strhash_bytes(&empty, 0), result);
+}
+
+/* strhash_bytes_with_seed */
+
+/* Tests_SRS_STRHASH_01_007: [ `strhash_bytes_with_seed` shall return the hash of the `length` bytes at `data` with `seed`. ]*/
+TEST_FUNCTION(strhash_bytes_with_seed_is_deterministic)
+{
+    // arrange
+    size_t length;
+
+    // act
+    // assert
+    for (length = 0; length <= sizeof(test_bytes); length++)
+    {
+        ASSERT_ARE_EQUAL(uint64_t, strhash_bytes_with_seed(test_bytes, length, 42), strhash_bytes_with_seed(test_bytes, length, 42));
+    }
+}
+
+/* Tests_SRS_STRHASH_01_007: [ `strhash_bytes_with_seed` shall return the hash of the `length` bytes at `data` with `seed`. ]*/
+TEST_FUNCTION(strhash_bytes_with_seed_depends_on_the_seed)
+{
+    // arrange
+    size_t length;
+
+    // act
+    // assert
+    for (length = 0; length <= sizeof(test_bytes); length++)
+    {
+        ASSERT_ARE_NOT_EQUAL(uint64_t, strhash_bytes_with_seed(test_bytes, length, 1), strhash_bytes_with_seed(test_bytes, length, 3));
+    }
+}
+
+/* Tests_SRS_STRHASH_01_007: [ `strhash_bytes_with_seed` shall return the hash of the `length` bytes at `data` with `seed`. ]*/
+TEST_FUNCTION(strhash_bytes_with_seed_depends_on_every_byte)
+{
+    // arrange
+    unsigned char bytes[sizeof(test_bytes)];
+    size_t length;
+
+    // act
+    // assert
+    for (length = 1; length <= sizeof(test_bytes); length++)
+    {
+        size_t i;
+
+        (void)memcpy(bytes, test_bytes, length);
+        for (i = 0; i < length; i++)
+        {
+            bytes[i] ^= 1;
+            ASSERT_ARE_NOT_EQUAL(uint64_t, strhash_bytes_with_seed(test_bytes, length, 42), strhash_bytes_with_seed(bytes, length, 42));
+            bytes[i] ^= 1;
+        }
+    }
+}
+
+/* Tests_SRS_STRHASH_01_007: [ `strhash_bytes_with_seed` shall return the hash of the `length` bytes at `data` with `seed`. ]*/
+TEST_FUNCTION(strhash_bytes_with_seed_depends_on_the_length)
+{
+    // arrange
+    unsigned char zeros[64];
+    size_t length;
+    (void)memset(zeros, 0, sizeof(zeros));
+
+    // act
+    // assert
+    for (length = 1; length < sizeof(zeros); length++)
+    {
+        ASSERT_ARE_NOT_EQUAL(uint64_t, strhash_bytes_with_seed(zeros, length - 1, 42), strhash_bytes_with_seed(zeros, length, 42));
+    }
+}
+
+/* Tests_SRS_STRHASH_01_007: [ `strhash_bytes_with_seed` shall return the hash of the `length` bytes at `data` with `seed`. ]*/
+TEST_FUNCTION(strhash_bytes_with_seed_is_case_sensitive)
+{
+    // arrange
+    size_t length;
+
+    // act
+    // assert
+    /* the first letter, 'A', is the 34th byte */
+    for (length = 34; length <= sizeof(test_bytes); length++)
+    {
+        ASSERT_ARE_NOT_EQUAL(uint64_t, strhash_bytes_with_seed(test_bytes, length, 42), strhash_bytes_with_seed(test_bytes_other_case, length, 42));
+    }
+}
+
+/* strhash_bytes_nocase_with_seed */
+
+/* Tests_SRS_STRHASH_01_008: [ `strhash_bytes_nocase_with_seed` shall return the hash of the `length` bytes at `data` with the ASCII letters lowered, with `seed`. ]*/
+TEST_FUNCTION(strhash_bytes_nocase_with_seed_ignores_the_case_of_ASCII_letters)
+{
+    // arrange
+    size_t length;
+
+    // act
+    // assert
+    for (length = 0; length <= sizeof(test_bytes); length++)
+    {
+        ASSERT_ARE_EQUAL(uint64_t, strhash_bytes_nocase_with_seed(test_bytes, length, 42), strhash_bytes_nocase_with_seed(test_bytes_other_case, length, 42));
+    }
+}
+
+/* Tests_SRS_STRHASH_01_008: [ `strhash_bytes_nocase_with_seed` shall return the hash of the `length` bytes at `data` with the ASCII letters lowered, with `seed`. ]*/
+TEST_FUNCTION(strhash_bytes_nocase_with_seed_equals_the_hash_of_the_lowered_bytes)
+{
+    // arrange
+    unsigned char lowered[sizeof(test_bytes)];
+    size_t length;
+    size_t i;
+    for (i = 0; i < sizeof(test_bytes); i++)
+    {
+        lowered[i] = ((test_bytes[i] >= 'A') && (test_bytes[i] <= 'Z')) ? (unsigned char)(test_bytes[i] - 'A' + 'a') : test_bytes[i];
+    }
+
+    // act
+    // assert
+    for (length = 0; length <= sizeof(test_bytes); length++)
+    {
+        ASSERT_ARE_EQUAL(uint64_t, strhash_bytes_with_seed(lowered, length, 42), strhash_bytes_nocase_with_seed(test_bytes, length, 42));
+    }
+}
+
+/* Tests_SRS_STRHASH_01_008: [ `strhash_bytes_nocase_with_seed` shall return the hash of the `length` bytes at `data` with the ASCII letters lowered, with `seed`. ]*/
+TEST_FUNCTION(strhash_bytes_nocase_with_seed_does_not_fold_the_characters_around_the_letters)
+{
+    // arrange
+    /* the characters right before and after both ranges of letters, and a byte above 0x7f that is 'A' | 0x80 */
+    static const char* const pairs[][2] =
+    {
+        { "@", "`" },
+        { "[", "{" },
+        { "\xc1", "\xe1" }
+    };
+    size_t i;
+
+    // act
+    // assert
+    for (i = 0; i < sizeof(pairs) / sizeof(pairs[0]); i++)
+    {
+        ASSERT_ARE_NOT_EQUAL(uint64_t, strhash_bytes_nocase_with_seed(pairs[i][0], 1, 42), strhash_bytes_nocase_with_seed(pairs[i][1], 1, 42));
+    }
+}
+
+/* strhash_bytes_nocase */
+
+/* Tests_SRS_STRHASH_01_004: [ `strhash_bytes_nocase` shall return the hash of the `length` bytes at `data` with the ASCII letters lowered, with the seed of the process. ]*/
+TEST_FUNCTION(strhash_bytes_nocase_hashes_with_the_process_seed)
+{
+    // arrange
+    uint64_t seed = strhash_get_process_seed();
+    size_t length;
+
+    // act
+    // assert
+    for (length = 0; length <= sizeof(test_bytes); length++)
+    {
+        ASSERT_ARE_EQUAL(uint64_t, strhash_bytes_nocase_with_seed(test_bytes, length, seed), strhash_bytes_nocase(test_bytes_other_case, length));
+    }
+}
+
+/* strhash_string */
+
+/* Tests_SRS_STRHASH_01_005: [ `strhash_string` shall return the hash of the characters of `value` before its `'\0'`, and the hash of no bytes when `value` is `NULL`. ]*/
+TEST_FUNCTION(strhash_string_hashes_the_characters_before_the_terminator)
+{
+    // arrange
+    const char* value = "Content-Type";
+
+    // act
+    uint64_t result = strhash_string(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, strhash_bytes(value, strlen(value)), result);
+    ASSERT_ARE_NOT_EQUAL(uint64_t, strhash_string("content-type"), result);
+}
+
+/* Tests_SRS_STRHASH_01_005: [ `strhash_string` shall return the hash of the characters of `value` before its `'\0'`, and the hash of no bytes when `value` is `NULL`. ]*/
+TEST_FUNCTION(strhash_string_with_NULL_value_hashes_no_bytes)
+{
+    // arrange
+
+    // act
+    uint64_t result = strhash_string(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, strhash_string(""), result);
+}
+
+/* strhash_string_nocase */
+
+/* Tests_SRS_STRHASH_01_006: [ `strhash_string_nocase` shall return the case-insensitive hash of the characters of `value` before its `'\0'`, and the hash of no bytes when `value` is `NULL`. ]*/
+TEST_FUNCTION(strhash_string_nocase_ignores_the_case)
+{
+    // arrange
+
+    // act
+    uint64_t result = strhash_string_nocase("Content-Type");
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, strhash_string_nocase("content-type"), result);
+    ASSERT_ARE_EQUAL(uint64_t, strhash_string_nocase("CONTENT-TYPE"), result);
+    ASSERT_ARE_NOT_EQUAL(uint64_t, strhash_string_nocase("Content-Length"), result);
+    ASSERT_ARE_EQUAL(uint64_t, strhash_string_nocase(""), strhash_string_nocase(NULL));
+}
+
+END_TEST_SUITE(strhash_unittests)
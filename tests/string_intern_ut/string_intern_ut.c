@@ -0,0 +1,641 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#include <cstdio>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdio.h>
+#include <stdbool.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_calloc(size_t nmemb, size_t size)
+{
+    return calloc(nmemb, size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#include "macro_utils.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_bool.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/string_intern.h"
+
+static const LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4243;
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+static void init_pool(void)
+{
+    ASSERT_ARE_EQUAL(int, 0, string_intern_init());
+    umock_c_reset_all_calls();
+}
+
+BEGIN_TEST_SUITE(string_intern_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result, "umock_c_init");
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_charptr_register_types");
+
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_bool_register_types");
+
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_RESULT, int);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_calloc, my_gballoc_calloc);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_calloc, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock_Init, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock, LOCK_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/* string_intern_init */
+
+/* Tests_SRS_STRING_INTERN_01_002: [ string_intern_init shall allocate STRING_INTERN_INITIAL_BUCKET_COUNT buckets and create a lock. ]*/
+/* Tests_SRS_STRING_INTERN_01_004: [ On success string_intern_init shall return 0. ]*/
+TEST_FUNCTION(string_intern_init_succeeds)
+{
+    // arrange
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_calloc(STRING_INTERN_INITIAL_BUCKET_COUNT, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+
+    // act
+    result = string_intern_init();
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    string_intern_deinit();
+}
+
+/* Tests_SRS_STRING_INTERN_01_001: [ If the pool is already initialized, string_intern_init shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(string_intern_init_when_already_initialized_fails)
+{
+    // arrange
+    int result;
+    init_pool();
+
+    // act
+    result = string_intern_init();
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    string_intern_deinit();
+}
+
+/* Tests_SRS_STRING_INTERN_01_003: [ If any failure occurs, string_intern_init shall free what it created and return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_the_buckets_fails_string_intern_init_fails)
+{
+    // arrange
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_calloc(STRING_INTERN_INITIAL_BUCKET_COUNT, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = string_intern_init();
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_STRING_INTERN_01_003: [ If any failure occurs, string_intern_init shall free what it created and return a non-zero value. ]*/
+TEST_FUNCTION(when_Lock_Init_fails_string_intern_init_fails)
+{
+    // arrange
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_calloc(STRING_INTERN_INITIAL_BUCKET_COUNT, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = string_intern_init();
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* string_intern_deinit */
+
+/* Tests_SRS_STRING_INTERN_01_005: [ If the pool is not initialized, string_intern_deinit shall return. ]*/
+TEST_FUNCTION(string_intern_deinit_when_not_initialized_returns)
+{
+    // act
+    string_intern_deinit();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_STRING_INTERN_01_006: [ string_intern_deinit shall turn the strings still referenced into private copies, and free the buckets and the lock. ]*/
+TEST_FUNCTION(string_intern_deinit_keeps_the_referenced_strings_as_private_copies)
+{
+    // arrange
+    const char* interned;
+    const char* clone;
+    init_pool();
+    interned = string_intern("host");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+
+    // act
+    string_intern_deinit();
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    clone = string_intern_clone(interned);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, interned, clone);
+    ASSERT_ARE_EQUAL(char_ptr, "host", clone);
+
+    // cleanup
+    string_intern_release(clone);
+    string_intern_release(interned);
+}
+
+/* string_intern */
+
+/* Tests_SRS_STRING_INTERN_01_007: [ If value is NULL, string_intern shall fail and return NULL. ]*/
+TEST_FUNCTION(string_intern_with_NULL_value_fails)
+{
+    // arrange
+    const char* result;
+    init_pool();
+
+    // act
+    result = string_intern(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    string_intern_deinit();
+}
+
+/* Tests_SRS_STRING_INTERN_01_008: [ If the pool is not initialized, string_intern shall return a private copy of value. ]*/
+TEST_FUNCTION(string_intern_when_not_initialized_returns_a_private_copy)
+{
+    // arrange
+    const char* first;
+    const char* second;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    first = string_intern("host");
+    second = string_intern("host");
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(char_ptr, "host", first);
+    ASSERT_ARE_EQUAL(char_ptr, "host", second);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, first, second);
+
+    // cleanup
+    string_intern_release(first);
+    string_intern_release(second);
+}
+
+/* Tests_SRS_STRING_INTERN_01_011: [ Otherwise string_intern shall add a copy of value to the pool and return it. ]*/
+TEST_FUNCTION(string_intern_adds_a_copy_of_value_to_the_pool)
+{
+    // arrange
+    char value[] = "host";
+    const char* result;
+    init_pool();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = string_intern(value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(void_ptr, value, result);
+    ASSERT_ARE_EQUAL(char_ptr, "host", result);
+
+    // cleanup
+    string_intern_release(result);
+    string_intern_deinit();
+}
+
+/* Tests_SRS_STRING_INTERN_01_010: [ If the pool holds a string equal to value, string_intern shall add a reference to it and return it. ]*/
+TEST_FUNCTION(string_intern_of_a_pooled_string_returns_the_pooled_string)
+{
+    // arrange
+    const char* first;
+    const char* second;
+    init_pool();
+    first = string_intern("host");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    second = string_intern("host");
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, first, second);
+
+    // cleanup
+    string_intern_release(first);
+    string_intern_release(second);
+    string_intern_deinit();
+}
+
+/* Tests_SRS_STRING_INTERN_01_011: [ Otherwise string_intern shall add a copy of value to the pool and return it. ]*/
+TEST_FUNCTION(string_intern_keeps_finding_strings_after_the_pool_grows)
+{
+    // arrange
+    const char* interned[STRING_INTERN_INITIAL_BUCKET_COUNT * 2];
+    char value[16];
+    size_t i;
+    init_pool();
+
+    for (i = 0; i < STRING_INTERN_INITIAL_BUCKET_COUNT * 2; i++)
+    {
+        (void)sprintf(value, "host%u", (unsigned int)i);
+        interned[i] = string_intern(value);
+        ASSERT_IS_NOT_NULL(interned[i]);
+    }
+
+    // act
+    for (i = 0; i < STRING_INTERN_INITIAL_BUCKET_COUNT * 2; i++)
+    {
+        const char* again;
+        (void)sprintf(value, "host%u", (unsigned int)i);
+        again = string_intern(value);
+
+        // assert
+        ASSERT_ARE_EQUAL(void_ptr, interned[i], again);
+        string_intern_release(again);
+    }
+
+    // cleanup
+    for (i = 0; i < STRING_INTERN_INITIAL_BUCKET_COUNT * 2; i++)
+    {
+        string_intern_release(interned[i]);
+    }
+    string_intern_deinit();
+}
+
+/* Tests_SRS_STRING_INTERN_01_009: [ If any failure occurs, string_intern shall fail and return NULL. ]*/
+TEST_FUNCTION(when_Lock_fails_string_intern_fails)
+{
+    // arrange
+    const char* result;
+    init_pool();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE))
+        .SetReturn(LOCK_ERROR);
+
+    // act
+    result = string_intern("host");
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    string_intern_deinit();
+}
+
+/* Tests_SRS_STRING_INTERN_01_009: [ If any failure occurs, string_intern shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_string_fails_string_intern_fails)
+{
+    // arrange
+    const char* result;
+    init_pool();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = string_intern("host");
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    string_intern_deinit();
+}
+
+/* string_intern_clone */
+
+/* Tests_SRS_STRING_INTERN_01_012: [ If interned is NULL, string_intern_clone shall fail and return NULL. ]*/
+TEST_FUNCTION(string_intern_clone_with_NULL_fails)
+{
+    // act
+    const char* result = string_intern_clone(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_STRING_INTERN_01_013: [ If interned is not pooled, string_intern_clone shall return a new private copy of it. ]*/
+TEST_FUNCTION(string_intern_clone_of_a_private_copy_copies_it)
+{
+    // arrange
+    const char* interned = string_intern("host");
+    const char* result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = string_intern_clone(interned);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(void_ptr, interned, result);
+    ASSERT_ARE_EQUAL(char_ptr, "host", result);
+
+    // cleanup
+    string_intern_release(result);
+    string_intern_release(interned);
+}
+
+/* Tests_SRS_STRING_INTERN_01_015: [ Otherwise string_intern_clone shall add a reference to interned and return it. ]*/
+TEST_FUNCTION(string_intern_clone_of_a_pooled_string_returns_it)
+{
+    // arrange
+    const char* interned;
+    const char* result;
+    init_pool();
+    interned = string_intern("host");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = string_intern_clone(interned);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(void_ptr, interned, result);
+
+    // cleanup
+    string_intern_release(result);
+    string_intern_release(interned);
+    string_intern_deinit();
+}
+
+/* Tests_SRS_STRING_INTERN_01_014: [ If any failure occurs, string_intern_clone shall fail and return NULL. ]*/
+TEST_FUNCTION(when_Lock_fails_string_intern_clone_fails)
+{
+    // arrange
+    const char* interned;
+    const char* result;
+    init_pool();
+    interned = string_intern("host");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE))
+        .SetReturn(LOCK_ERROR);
+
+    // act
+    result = string_intern_clone(interned);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    string_intern_release(interned);
+    string_intern_deinit();
+}
+
+/* string_intern_release */
+
+/* Tests_SRS_STRING_INTERN_01_016: [ If interned is NULL, string_intern_release shall return. ]*/
+TEST_FUNCTION(string_intern_release_with_NULL_returns)
+{
+    // act
+    string_intern_release(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_STRING_INTERN_01_017: [ If interned is not pooled, string_intern_release shall remove a reference and free it when none is left. ]*/
+TEST_FUNCTION(string_intern_release_frees_a_private_copy)
+{
+    // arrange
+    const char* interned = string_intern("host");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    string_intern_release(interned);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_STRING_INTERN_01_018: [ Otherwise string_intern_release shall remove a reference, and when none is left remove the string from the pool and free it. ]*/
+TEST_FUNCTION(string_intern_release_keeps_a_pooled_string_still_referenced)
+{
+    // arrange
+    const char* first;
+    const char* second;
+    init_pool();
+    first = string_intern("host");
+    second = string_intern("host");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    string_intern_release(first);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(char_ptr, "host", second);
+
+    // cleanup
+    string_intern_release(second);
+    string_intern_deinit();
+}
+
+/* Tests_SRS_STRING_INTERN_01_018: [ Otherwise string_intern_release shall remove a reference, and when none is left remove the string from the pool and free it. ]*/
+TEST_FUNCTION(string_intern_release_of_the_last_reference_removes_the_string_from_the_pool)
+{
+    // arrange
+    const char* interned;
+    const char* result;
+    init_pool();
+    interned = string_intern("host");
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    string_intern_release(interned);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    result = string_intern("host");
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    string_intern_release(result);
+    string_intern_deinit();
+}
+
+/* string_intern_equals */
+
+/* Tests_SRS_STRING_INTERN_01_019: [ If left and right are the same pointer, string_intern_equals shall return true. ]*/
+/* Tests_SRS_STRING_INTERN_01_020: [ If only one of left and right is NULL, string_intern_equals shall return false. ]*/
+TEST_FUNCTION(string_intern_equals_with_NULL_arguments)
+{
+    // arrange
+    const char* interned = string_intern("host");
+
+    // act
+    // assert
+    ASSERT_IS_TRUE(string_intern_equals(NULL, NULL));
+    ASSERT_IS_FALSE(string_intern_equals(interned, NULL));
+    ASSERT_IS_FALSE(string_intern_equals(NULL, interned));
+
+    // cleanup
+    string_intern_release(interned);
+}
+
+/* Tests_SRS_STRING_INTERN_01_019: [ If left and right are the same pointer, string_intern_equals shall return true. ]*/
+/* Tests_SRS_STRING_INTERN_01_021: [ If both strings are pooled and different pointers, string_intern_equals shall return false. ]*/
+TEST_FUNCTION(string_intern_equals_compares_pooled_strings_by_pointer)
+{
+    // arrange
+    const char* host_1;
+    const char* host_2;
+    const char* other;
+    init_pool();
+    host_1 = string_intern("host");
+    host_2 = string_intern("host");
+    other = string_intern("other");
+
+    // act
+    // assert
+    ASSERT_IS_TRUE(string_intern_equals(host_1, host_2));
+    ASSERT_IS_FALSE(string_intern_equals(host_1, other));
+
+    // cleanup
+    string_intern_release(host_1);
+    string_intern_release(host_2);
+    string_intern_release(other);
+    string_intern_deinit();
+}
+
+/* Tests_SRS_STRING_INTERN_01_022: [ Otherwise string_intern_equals shall return whether the strings have the same content. ]*/
+TEST_FUNCTION(string_intern_equals_compares_private_copies_by_content)
+{
+    // arrange
+    const char* host_1 = string_intern("host");
+    const char* host_2 = string_intern("host");
+    const char* other = string_intern("other");
+
+    // act
+    // assert
+    ASSERT_IS_TRUE(string_intern_equals(host_1, host_2));
+    ASSERT_IS_FALSE(string_intern_equals(host_1, other));
+
+    // cleanup
+    string_intern_release(host_1);
+    string_intern_release(host_2);
+    string_intern_release(other);
+}
+
+END_TEST_SUITE(string_intern_unittests)
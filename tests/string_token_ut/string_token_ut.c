@@ -79,22 +79,9 @@ static void register_global_mock_hooks()
 }
 
 // Set Expected Call Helpers
-static void set_expected_calls_for_get_delimiters_lengths()
-{
-    STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
-}
-
 static void set_expected_calls_for_StringToken_GetFirst()
 {
     STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
-    set_expected_calls_for_get_delimiters_lengths();
-    STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
-}
-
-static void set_expected_calls_for_StringToken_GetNext()
-{
-    set_expected_calls_for_get_delimiters_lengths();
-    STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG)); // delimiters lengths
 }
 
 BEGIN_TEST_SUITE(string_token_ut)
@@ -223,8 +210,6 @@ BEGIN_TEST_SUITE(string_token_ut)
 
         umock_c_reset_all_calls();
         STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
-        set_expected_calls_for_get_delimiters_lengths();
-        STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
         STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
 
         // act
@@ -252,7 +237,6 @@ BEGIN_TEST_SUITE(string_token_ut)
 
         umock_c_reset_all_calls();
         STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
-        set_expected_calls_for_get_delimiters_lengths();
         umock_c_negative_tests_snapshot();
 
         // act
@@ -290,8 +274,6 @@ BEGIN_TEST_SUITE(string_token_ut)
 
         umock_c_reset_all_calls();
         STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
-        set_expected_calls_for_get_delimiters_lengths();
-        STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
 
         // act
         handle = StringToken_GetFirst(string, length, delimiters, 1);
@@ -316,8 +298,6 @@ BEGIN_TEST_SUITE(string_token_ut)
 
         umock_c_reset_all_calls();
         STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
-        set_expected_calls_for_get_delimiters_lengths();
-        STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
 
         // act
         handle = StringToken_GetFirst(string, length, delimiters, 1);
@@ -347,8 +327,6 @@ BEGIN_TEST_SUITE(string_token_ut)
 
         umock_c_reset_all_calls();
         STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
-        set_expected_calls_for_get_delimiters_lengths();
-        STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG)); // delimiters lengths
 
         // act
         handle = StringToken_GetFirst(string, length, delimiters, 1);
@@ -467,8 +445,6 @@ BEGIN_TEST_SUITE(string_token_ut)
         handle = StringToken_GetFirst(string, length, delimiters, 2);
         
         umock_c_reset_all_calls();
-        set_expected_calls_for_get_delimiters_lengths();
-        STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG)); // delimiters lengths
 
         // act
         result = StringToken_GetNext(handle, delimiters, 2);
@@ -482,8 +458,8 @@ BEGIN_TEST_SUITE(string_token_ut)
         StringToken_Destroy(handle);
     }
 
-    // Tests_SRS_STRING_TOKENIZER_09_012: [ If a token was identified, the function shall return true ]
-    TEST_FUNCTION(StringToken_GetNext_malloc_fails)
+    // Tests_SRS_STRING_TOKENIZER_09_002: [ If any of the strings in delimiters are NULL, the function shall return NULL ]
+    TEST_FUNCTION(StringToken_GetNext_NULL_delimiter)
     {
         ///arrange
         bool result;
@@ -491,11 +467,9 @@ BEGIN_TEST_SUITE(string_token_ut)
         const char* delimiters[2];
         char* string = "https://some.site.com/path/morepath/?prop1=site.com&prop2=/prop2/abc";
         size_t length = strlen(string);
-        
-        ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
 
         delimiters[0] = "https://";
-        delimiters[1] = "/path"; // this causes the failure
+        delimiters[1] = "/path";
 
         umock_c_reset_all_calls();
         set_expected_calls_for_StringToken_GetFirst();
@@ -503,11 +477,7 @@ BEGIN_TEST_SUITE(string_token_ut)
         handle = StringToken_GetFirst(string, length, delimiters, 2);
 
         umock_c_reset_all_calls();
-        STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG)); // delimiters lengths
-        umock_c_negative_tests_snapshot();
-
-        umock_c_negative_tests_reset();
-        umock_c_negative_tests_fail_call(0);
+        delimiters[1] = NULL;
 
         // act
         result = StringToken_GetNext(handle, delimiters, 2);
@@ -517,7 +487,6 @@ BEGIN_TEST_SUITE(string_token_ut)
         ASSERT_IS_FALSE(result);
 
         // cleanup
-        umock_c_negative_tests_deinit();
         StringToken_Destroy(handle);
     }
 
@@ -538,7 +507,6 @@ BEGIN_TEST_SUITE(string_token_ut)
         handle = StringToken_GetFirst(string, length, delimiters, 1);
         ASSERT_IS_NOT_NULL(handle);
 
-        set_expected_calls_for_StringToken_GetNext();
         result = StringToken_GetNext(handle, delimiters, 1);
         ASSERT_IS_TRUE(result);
 
@@ -572,8 +540,6 @@ BEGIN_TEST_SUITE(string_token_ut)
         handle = StringToken_GetFirst(string, length, delimiters, 1);
 
         umock_c_reset_all_calls();
-        set_expected_calls_for_get_delimiters_lengths();
-        STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG)); // delimiters lengths
 
         // act
         result = StringToken_GetNext(handle, delimiters, 1);
@@ -719,25 +685,21 @@ BEGIN_TEST_SUITE(string_token_ut)
         ASSERT_IS_NULL(StringToken_GetValue(handle));
         ASSERT_ARE_EQUAL(int, 0, StringToken_GetLength(handle));
 
-        set_expected_calls_for_StringToken_GetNext();
         result = StringToken_GetNext(handle, delimiters1, 4);
         ASSERT_IS_TRUE(result);
         ASSERT_ARE_EQUAL(void_ptr, (void*)delimiters1[3], (void*)StringToken_GetDelimiter(handle));
         ASSERT_IS_TRUE(strncmp(host, StringToken_GetValue(handle), StringToken_GetLength(handle)) == 0);
 
-        set_expected_calls_for_StringToken_GetNext();
         result = StringToken_GetNext(handle, delimiters1, 1); // intentionally restricting to "?" only
         ASSERT_IS_TRUE(result);
         ASSERT_ARE_EQUAL(void_ptr, (void*)delimiters1[0], (void*)StringToken_GetDelimiter(handle));
         ASSERT_IS_TRUE(strncmp(relative_path, StringToken_GetValue(handle), StringToken_GetLength(handle)) == 0);
 
-        set_expected_calls_for_StringToken_GetNext();
         result = StringToken_GetNext(handle, delimiters2, 1);
         ASSERT_IS_TRUE(result);
         ASSERT_ARE_EQUAL(void_ptr, (void*)delimiters2[0], (void*)StringToken_GetDelimiter(handle));
         ASSERT_IS_TRUE(strncmp(property1, StringToken_GetValue(handle), StringToken_GetLength(handle)) == 0);
 
-        set_expected_calls_for_StringToken_GetNext();
         result = StringToken_GetNext(handle, delimiters2, 1);
         ASSERT_IS_TRUE(result);
         // SRS_STRING_TOKENIZER_09_019:
@@ -776,7 +738,6 @@ BEGIN_TEST_SUITE(string_token_ut)
         ASSERT_ARE_EQUAL(int, 3, StringToken_GetLength(handle));
 
         ///arrange
-        set_expected_calls_for_StringToken_GetNext();
 
         // act
         result = StringToken_GetNext(handle, delimiters, 1);
@@ -907,15 +868,12 @@ BEGIN_TEST_SUITE(string_token_ut)
         STRICT_EXPECTED_CALL(realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
         STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
 
-        set_expected_calls_for_StringToken_GetNext();
         STRICT_EXPECTED_CALL(realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
         STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
         
-        set_expected_calls_for_StringToken_GetNext();
         STRICT_EXPECTED_CALL(realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
         STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
         
-        set_expected_calls_for_StringToken_GetNext();
         STRICT_EXPECTED_CALL(realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
         STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
         
@@ -989,29 +947,22 @@ BEGIN_TEST_SUITE(string_token_ut)
         set_expected_calls_for_StringToken_GetFirst();
         STRICT_EXPECTED_CALL(realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
 
-        set_expected_calls_for_StringToken_GetNext();
         STRICT_EXPECTED_CALL(realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
         STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
 
-        set_expected_calls_for_StringToken_GetNext();
         STRICT_EXPECTED_CALL(realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
 
-        set_expected_calls_for_StringToken_GetNext();
         STRICT_EXPECTED_CALL(realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
         STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
 
-        set_expected_calls_for_StringToken_GetNext();
         STRICT_EXPECTED_CALL(realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
         STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
 
-        set_expected_calls_for_StringToken_GetNext();
         STRICT_EXPECTED_CALL(realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
         STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
 
-        set_expected_calls_for_StringToken_GetNext();
         STRICT_EXPECTED_CALL(realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
 
-        set_expected_calls_for_StringToken_GetNext();
         STRICT_EXPECTED_CALL(realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
 
         STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
@@ -1060,23 +1011,20 @@ BEGIN_TEST_SUITE(string_token_ut)
         delimiters[1] = "&";
 
         umock_c_reset_all_calls();
-        set_expected_calls_for_StringToken_GetFirst(); // 0, 1, 2
+        set_expected_calls_for_StringToken_GetFirst(); // 0
         STRICT_EXPECTED_CALL(realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
         STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
 
-        set_expected_calls_for_StringToken_GetNext(); // 5, 6
         STRICT_EXPECTED_CALL(realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
         STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
 
-        set_expected_calls_for_StringToken_GetNext(); // 9, 10
         STRICT_EXPECTED_CALL(realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
         STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
 
-        set_expected_calls_for_StringToken_GetNext(); // 13, 14
         STRICT_EXPECTED_CALL(realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
         STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
 
-        STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG)); // 17
+        STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG)); // 9
         umock_c_negative_tests_snapshot();
 
         for (i = 0; i < umock_c_negative_tests_call_count(); i++)
@@ -1085,7 +1033,7 @@ BEGIN_TEST_SUITE(string_token_ut)
             char error_msg[64];
             int result;
 
-            if (i == 0 || i == 1 || i == 2 || i == 5 || i == 6 || i == 9 || i == 10 || i == 13 || i == 14 || i == 17)
+            if (i == 0 || i == 9)
             {
                 continue;
             }
@@ -1104,4 +1052,312 @@ BEGIN_TEST_SUITE(string_token_ut)
         umock_c_negative_tests_deinit();
     }
 
+    // Tests_SRS_STRING_TOKENIZER_09_028: [ If view or source are NULL, the function shall return a non-zero value ]
+    TEST_FUNCTION(StringToken_InitView_NULL_view)
+    {
+        ///arrange
+        int result;
+        char* string = "abc/def";
+
+        umock_c_reset_all_calls();
+
+        // act
+        result = StringToken_InitView(NULL, string, strlen(string));
+
+        // assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    }
+
+    // Tests_SRS_STRING_TOKENIZER_09_028: [ If view or source are NULL, the function shall return a non-zero value ]
+    TEST_FUNCTION(StringToken_InitView_NULL_source)
+    {
+        ///arrange
+        int result;
+        STRING_TOKEN_VIEW view;
+
+        umock_c_reset_all_calls();
+
+        // act
+        result = StringToken_InitView(&view, NULL, 0);
+
+        // assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    }
+
+    // Tests_SRS_STRING_TOKENIZER_09_029: [ The function shall set view to scan source up to length from its beginning, with no current token, and return zero ]
+    TEST_FUNCTION(StringToken_InitView_Success)
+    {
+        ///arrange
+        int result;
+        STRING_TOKEN_VIEW view;
+        char* string = "abc/def";
+
+        umock_c_reset_all_calls();
+
+        // act
+        result = StringToken_InitView(&view, string, strlen(string));
+
+        // assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_IS_NULL(view.value);
+        ASSERT_ARE_EQUAL(size_t, 0, view.length);
+        ASSERT_IS_NULL(view.delimiter);
+    }
+
+    // Tests_SRS_STRING_TOKENIZER_09_030: [ If view or delimiters are NULL, n_delims is zero or any of the strings in delimiters are NULL, the function shall return false ]
+    TEST_FUNCTION(StringToken_NextView_invalid_arguments)
+    {
+        ///arrange
+        STRING_TOKEN_VIEW view;
+        const char* delimiters[2];
+        char* string = "abc/def";
+
+        delimiters[0] = "/";
+        delimiters[1] = NULL;
+
+        ASSERT_ARE_EQUAL(int, 0, StringToken_InitView(&view, string, strlen(string)));
+        umock_c_reset_all_calls();
+
+        // act
+        // assert
+        ASSERT_IS_FALSE(StringToken_NextView(NULL, delimiters, 1));
+        ASSERT_IS_FALSE(StringToken_NextView(&view, NULL, 1));
+        ASSERT_IS_FALSE(StringToken_NextView(&view, delimiters, 0));
+        ASSERT_IS_FALSE(StringToken_NextView(&view, delimiters, 2));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    // Tests_SRS_STRING_TOKENIZER_09_031: [ If the previous token already extended to the end of source, the function shall return false ]
+    // Tests_SRS_STRING_TOKENIZER_09_032: [ The token shall start at the beginning of source on the first call, or right after the previous delimiter otherwise, and extend up to the first occurrence of any one of delimiters, whichever occurs first in the order provided ]
+    // Tests_SRS_STRING_TOKENIZER_09_033: [ If none of delimiters occurs, the token shall extend to the end of source and delimiter shall be set to NULL ]
+    // Tests_SRS_STRING_TOKENIZER_09_034: [ Otherwise delimiter shall point to the element of delimiters that ended the token ]
+    // Tests_SRS_STRING_TOKENIZER_09_035: [ The function shall not allocate memory, shall not modify source and shall return true ]
+    TEST_FUNCTION(StringToken_NextView_tokenize_HTTP_URL)
+    {
+        ///arrange
+        STRING_TOKEN_VIEW view;
+        char* string = "https://some.site.com/path/morepath/?prop1=site.com&prop2=/prop2/abc";
+        const char* delimiters1[4];
+        const char* delimiters2[1];
+
+        delimiters1[0] = "?";
+        delimiters1[1] = "http://";
+        delimiters1[2] = "https://";
+        delimiters1[3] = "/";
+
+        delimiters2[0] = "&";
+
+        umock_c_reset_all_calls();
+
+        // act
+        // assert
+        ASSERT_ARE_EQUAL(int, 0, StringToken_InitView(&view, string, strlen(string)));
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters1, 4));
+        ASSERT_ARE_EQUAL(void_ptr, (void*)string, (void*)view.value);
+        ASSERT_ARE_EQUAL(size_t, 0, view.length);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)delimiters1[2], (void*)view.delimiter);
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters1, 4));
+        ASSERT_ARE_EQUAL(void_ptr, (void*)(string + 8), (void*)view.value);
+        ASSERT_ARE_EQUAL(size_t, strlen("some.site.com"), view.length);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)delimiters1[3], (void*)view.delimiter);
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters1, 1)); // intentionally restricting to "?" only
+        ASSERT_ARE_EQUAL(int, 0, strncmp("path/morepath/", view.value, view.length));
+        ASSERT_ARE_EQUAL(size_t, strlen("path/morepath/"), view.length);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)delimiters1[0], (void*)view.delimiter);
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters2, 1));
+        ASSERT_ARE_EQUAL(int, 0, strncmp("prop1=site.com", view.value, view.length));
+        ASSERT_ARE_EQUAL(size_t, strlen("prop1=site.com"), view.length);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)delimiters2[0], (void*)view.delimiter);
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters2, 1));
+        ASSERT_ARE_EQUAL(int, 0, strncmp("prop2=/prop2/abc", view.value, view.length));
+        ASSERT_ARE_EQUAL(size_t, strlen("prop2=/prop2/abc"), view.length);
+        ASSERT_IS_NULL(view.delimiter);
+
+        ASSERT_IS_FALSE(StringToken_NextView(&view, delimiters2, 1));
+
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(StringToken_NextView_string_ends_with_delimiter)
+    {
+        ///arrange
+        STRING_TOKEN_VIEW view;
+        const char* delimiters[1];
+        char* string = "abcde";
+
+        delimiters[0] = "de";
+
+        umock_c_reset_all_calls();
+
+        // act
+        // assert
+        ASSERT_ARE_EQUAL(int, 0, StringToken_InitView(&view, string, strlen(string)));
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters, 1));
+        ASSERT_ARE_EQUAL(void_ptr, (void*)string, (void*)view.value);
+        ASSERT_ARE_EQUAL(size_t, 3, view.length);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)delimiters[0], (void*)view.delimiter);
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters, 1));
+        ASSERT_ARE_EQUAL(void_ptr, (void*)(string + 5), (void*)view.value);
+        ASSERT_ARE_EQUAL(size_t, 0, view.length);
+        ASSERT_IS_NULL(view.delimiter);
+
+        ASSERT_IS_FALSE(StringToken_NextView(&view, delimiters, 1));
+
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    TEST_FUNCTION(StringToken_NextView_empty_string)
+    {
+        ///arrange
+        STRING_TOKEN_VIEW view;
+        const char* delimiters[1];
+        char* string = "";
+
+        delimiters[0] = "?";
+
+        umock_c_reset_all_calls();
+
+        // act
+        // assert
+        ASSERT_ARE_EQUAL(int, 0, StringToken_InitView(&view, string, 0));
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters, 1));
+        ASSERT_ARE_EQUAL(size_t, 0, view.length);
+        ASSERT_IS_NULL(view.delimiter);
+
+        ASSERT_IS_FALSE(StringToken_NextView(&view, delimiters, 1));
+
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    // Tests_SRS_STRING_TOKENIZER_09_032: [ The token shall start at the beginning of source on the first call, or right after the previous delimiter otherwise, and extend up to the first occurrence of any one of delimiters, whichever occurs first in the order provided ]
+    TEST_FUNCTION(StringToken_NextView_finds_the_delimiters_in_a_long_string)
+    {
+        ///arrange
+        STRING_TOKEN_VIEW view;
+        const char* delimiters[3];
+        char* string = "HostName=some-iot-hub.azure-devices.net;SharedAccessKeyName=iothubowner;SharedAccessKey=abc,def";
+
+        delimiters[0] = ";";
+        delimiters[1] = "=";
+        delimiters[2] = ",";
+
+        umock_c_reset_all_calls();
+
+        // act
+        // assert
+        ASSERT_ARE_EQUAL(int, 0, StringToken_InitView(&view, string, strlen(string)));
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters, 3));
+        ASSERT_ARE_EQUAL(size_t, strlen("HostName"), view.length);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)delimiters[1], (void*)view.delimiter);
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters, 3));
+        ASSERT_ARE_EQUAL(int, 0, strncmp("some-iot-hub.azure-devices.net", view.value, view.length));
+        ASSERT_ARE_EQUAL(size_t, strlen("some-iot-hub.azure-devices.net"), view.length);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)delimiters[0], (void*)view.delimiter);
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters, 3));
+        ASSERT_ARE_EQUAL(int, 0, strncmp("SharedAccessKeyName", view.value, view.length));
+        ASSERT_ARE_EQUAL(size_t, strlen("SharedAccessKeyName"), view.length);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)delimiters[1], (void*)view.delimiter);
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters, 3));
+        ASSERT_ARE_EQUAL(size_t, strlen("iothubowner"), view.length);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)delimiters[0], (void*)view.delimiter);
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters, 3));
+        ASSERT_ARE_EQUAL(size_t, strlen("SharedAccessKey"), view.length);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)delimiters[1], (void*)view.delimiter);
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters, 3));
+        ASSERT_ARE_EQUAL(int, 0, strncmp("abc", view.value, view.length));
+        ASSERT_ARE_EQUAL(size_t, strlen("abc"), view.length);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)delimiters[2], (void*)view.delimiter);
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters, 3));
+        ASSERT_ARE_EQUAL(int, 0, strncmp("def", view.value, view.length));
+        ASSERT_IS_NULL(view.delimiter);
+
+        ASSERT_IS_FALSE(StringToken_NextView(&view, delimiters, 3));
+
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    // Tests_SRS_STRING_TOKENIZER_09_032: [ The token shall start at the beginning of source on the first call, or right after the previous delimiter otherwise, and extend up to the first occurrence of any one of delimiters, whichever occurs first in the order provided ]
+    TEST_FUNCTION(StringToken_NextView_with_many_delimiters_in_a_long_string)
+    {
+        ///arrange
+        STRING_TOKEN_VIEW view;
+        const char* delimiters[6];
+        char* string = "abcdefghijklmnopqrstuvwxyz0123456789|tail";
+
+        delimiters[0] = "!";
+        delimiters[1] = "#";
+        delimiters[2] = "$";
+        delimiters[3] = "%";
+        delimiters[4] = "&";
+        delimiters[5] = "|";
+
+        umock_c_reset_all_calls();
+
+        // act
+        // assert
+        ASSERT_ARE_EQUAL(int, 0, StringToken_InitView(&view, string, strlen(string)));
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters, 6));
+        ASSERT_ARE_EQUAL(size_t, 36, view.length);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)delimiters[5], (void*)view.delimiter);
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters, 6));
+        ASSERT_ARE_EQUAL(void_ptr, (void*)(string + 37), (void*)view.value);
+        ASSERT_ARE_EQUAL(size_t, strlen("tail"), view.length);
+        ASSERT_IS_NULL(view.delimiter);
+
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    // Tests_SRS_STRING_TOKENIZER_09_032: [ The token shall start at the beginning of source on the first call, or right after the previous delimiter otherwise, and extend up to the first occurrence of any one of delimiters, whichever occurs first in the order provided ]
+    TEST_FUNCTION(StringToken_NextView_skips_the_first_bytes_of_delimiters_that_do_not_follow)
+    {
+        ///arrange
+        STRING_TOKEN_VIEW view;
+        const char* delimiters[2];
+        char* string = "header-value\rwith-dashes--boundary\r\n";
+
+        delimiters[0] = "\r\n";
+        delimiters[1] = "--";
+
+        umock_c_reset_all_calls();
+
+        // act
+        // assert
+        ASSERT_ARE_EQUAL(int, 0, StringToken_InitView(&view, string, strlen(string)));
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters, 2));
+        ASSERT_ARE_EQUAL(size_t, strlen("header-value\rwith-dashes"), view.length);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)delimiters[1], (void*)view.delimiter);
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters, 2));
+        ASSERT_ARE_EQUAL(int, 0, strncmp("boundary", view.value, view.length));
+        ASSERT_ARE_EQUAL(size_t, strlen("boundary"), view.length);
+        ASSERT_ARE_EQUAL(void_ptr, (void*)delimiters[0], (void*)view.delimiter);
+
+        ASSERT_IS_TRUE(StringToken_NextView(&view, delimiters, 2));
+        ASSERT_ARE_EQUAL(size_t, 0, view.length);
+        ASSERT_IS_NULL(view.delimiter);
+
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
 END_TEST_SUITE(string_token_ut)
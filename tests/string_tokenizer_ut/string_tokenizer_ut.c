@@ -642,6 +642,61 @@ BEGIN_TEST_SUITE(string_tokenizer_unittests)
         STRING_delete(output_string_handle);
     }
 
+    /* Tests_SRS_STRING_04_008: [STRING_TOKENIZER_get_next_token than searches from the start of a token for a character that is contained in the delimiters string.] */
+    /* Tests_SRS_STRING_04_010: [If such a character is found, STRING_TOKENIZER_get_next_token consider it the end of the token and copy it's content to output, updates the current position inside t to the next character and returns 0.] */
+    TEST_FUNCTION(STRING_TOKENIZER_get_next_token_ends_the_token_at_the_first_of_any_delimiter_Succeed)
+    {
+        ///arrange
+        int r;
+        const char* inputString = "key=value;next,last";
+
+        STRING_HANDLE input_string_handle = STRING_construct(inputString);
+        STRING_HANDLE output_string_handle = STRING_construct(inputString);
+
+        STRING_TOKENIZER_HANDLE t = STRING_TOKENIZER_create(input_string_handle);
+
+        umock_c_reset_all_calls();
+
+        ///act1
+        EXPECTED_CALL(gballoc_realloc(0, 0))  //Alloc memory to copy result.
+            .IgnoreArgument(1)
+            .IgnoreArgument(2);
+
+        r = STRING_TOKENIZER_get_next_token(t, output_string_handle, ",;");
+
+        ///Assert1
+        ASSERT_ARE_EQUAL(char_ptr, "key=value", STRING_c_str(output_string_handle));
+        ASSERT_ARE_EQUAL(int, r, 0);
+
+        ///act2
+        EXPECTED_CALL(gballoc_realloc(0, 0))  //Alloc memory to copy result.
+            .IgnoreArgument(1)
+            .IgnoreArgument(2);
+
+        r = STRING_TOKENIZER_get_next_token(t, output_string_handle, ",;");
+
+        ///Assert2
+        ASSERT_ARE_EQUAL(char_ptr, "next", STRING_c_str(output_string_handle));
+        ASSERT_ARE_EQUAL(int, r, 0);
+
+        ///act3
+        EXPECTED_CALL(gballoc_realloc(0, 0))  //Alloc memory to copy result.
+            .IgnoreArgument(1)
+            .IgnoreArgument(2);
+
+        r = STRING_TOKENIZER_get_next_token(t, output_string_handle, ",;");
+
+        ///Assert3
+        ASSERT_ARE_EQUAL(char_ptr, "last", STRING_c_str(output_string_handle));
+        ASSERT_ARE_EQUAL(int, r, 0);
+
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        ///Cleanup
+        STRING_TOKENIZER_destroy(t);
+        STRING_delete(input_string_handle);
+        STRING_delete(output_string_handle);
+    }
+
     /* Tests_SRS_STRING_04_010: [If such a character is found, STRING_TOKENIZER_get_next_token consider it the end of the token and copy it's content to output, updates the current position inside t to the next character and returns 0.] */
     /* Tests_SRS_STRING_04_011: [Each subsequent call to STRING_TOKENIZER_get_next_token starts searching from the saved position on t and behaves as described above.] */
     TEST_FUNCTION(STRING_TOKENIZER_get_next_token_inputString_with_SingleCharacter_call2Times_succeed)
@@ -0,0 +1,267 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#endif
+
+void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void* my_gballoc_realloc(void* ptr, size_t size)
+{
+    return realloc(ptr, size);
+}
+
+void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umock_c_negative_tests.h"
+#include "umocktypes_charptr.h"
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/strings.h"
+
+/*these tests run with the default STRING_INLINE_CAPACITY of 24 bytes*/
+static const char SHORT_STRING_VALUE[] = "DataValueTest";
+static const char INITIAL_STRING_VALUE[] = "Initial_";
+static const char LONG_STRING_VALUE[] = "DataValueTestDataValueTest";
+static const char COMBINED_STRING_VALUE[] = "Initial_DataValueTestDataValueTest";
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+BEGIN_TEST_SUITE(strings_inline_unittests)
+
+    TEST_SUITE_INITIALIZE(suite_init)
+    {
+        g_testByTest = TEST_MUTEX_CREATE();
+        ASSERT_IS_NOT_NULL(g_testByTest);
+
+        umock_c_init(on_umock_c_error);
+
+        REGISTER_UMOCK_ALIAS_TYPE(STRING_HANDLE, void*);
+        ASSERT_ARE_EQUAL(int, 0, umocktypes_charptr_register_types());
+
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_malloc, NULL);
+
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_realloc, my_gballoc_realloc);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(gballoc_realloc, NULL);
+
+        REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    }
+
+    TEST_SUITE_CLEANUP(suite_cleanup)
+    {
+        umock_c_deinit();
+
+        TEST_MUTEX_DESTROY(g_testByTest);
+    }
+
+    TEST_FUNCTION_INITIALIZE(method_init)
+    {
+        if (TEST_MUTEX_ACQUIRE(g_testByTest))
+        {
+            ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+        }
+
+        umock_c_reset_all_calls();
+    }
+
+    TEST_FUNCTION_CLEANUP(method_cleanup)
+    {
+        TEST_MUTEX_RELEASE(g_testByTest);
+    }
+
+    /* Tests_SRS_STRING_01_009: [ Values of up to STRING_INLINE_CAPACITY bytes, including the terminating '\0', shall be stored in the STRING control block without a separate allocation. ] */
+    TEST_FUNCTION(STRING_new_allocates_only_the_handle)
+    {
+        ///arrange
+        STRING_HANDLE handle;
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        handle = STRING_new();
+
+        ///assert
+        ASSERT_IS_NOT_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, "", STRING_c_str(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        STRING_delete(handle);
+    }
+
+    /* Tests_SRS_STRING_01_009: [ Values of up to STRING_INLINE_CAPACITY bytes, including the terminating '\0', shall be stored in the STRING control block without a separate allocation. ] */
+    TEST_FUNCTION(STRING_construct_of_a_short_string_allocates_only_the_handle)
+    {
+        ///arrange
+        STRING_HANDLE handle;
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+
+        ///act
+        handle = STRING_construct(SHORT_STRING_VALUE);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, SHORT_STRING_VALUE, STRING_c_str(handle));
+        ASSERT_ARE_EQUAL(size_t, sizeof(SHORT_STRING_VALUE) - 1, STRING_length(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        STRING_delete(handle);
+    }
+
+    /* Tests_SRS_STRING_01_009: [ Values of up to STRING_INLINE_CAPACITY bytes, including the terminating '\0', shall be stored in the STRING control block without a separate allocation. ] */
+    TEST_FUNCTION(STRING_construct_of_a_long_string_allocates_the_value)
+    {
+        ///arrange
+        STRING_HANDLE handle;
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+            .IgnoreArgument(1);
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(LONG_STRING_VALUE)));
+
+        ///act
+        handle = STRING_construct(LONG_STRING_VALUE);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(handle);
+        ASSERT_ARE_EQUAL(char_ptr, LONG_STRING_VALUE, STRING_c_str(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        STRING_delete(handle);
+    }
+
+    /* Tests_SRS_STRING_01_009: [ Values of up to STRING_INLINE_CAPACITY bytes, including the terminating '\0', shall be stored in the STRING control block without a separate allocation. ] */
+    TEST_FUNCTION(STRING_delete_of_a_short_string_frees_only_the_handle)
+    {
+        ///arrange
+        STRING_HANDLE handle = STRING_construct(SHORT_STRING_VALUE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_free((void*)handle));
+
+        ///act
+        STRING_delete(handle);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_STRING_01_009: [ Values of up to STRING_INLINE_CAPACITY bytes, including the terminating '\0', shall be stored in the STRING control block without a separate allocation. ] */
+    TEST_FUNCTION(STRING_concat_within_the_inline_storage_does_not_allocate)
+    {
+        ///arrange
+        int result;
+        STRING_HANDLE handle = STRING_construct(INITIAL_STRING_VALUE);
+        umock_c_reset_all_calls();
+
+        ///act
+        result = STRING_concat(handle, SHORT_STRING_VALUE);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, "Initial_DataValueTest", STRING_c_str(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        STRING_delete(handle);
+    }
+
+    /* Tests_SRS_STRING_01_010: [ When a value stored in the STRING control block grows beyond STRING_INLINE_CAPACITY bytes, it shall be moved to memory allocated with malloc. ] */
+    TEST_FUNCTION(STRING_concat_past_the_inline_storage_moves_the_value_to_the_heap)
+    {
+        ///arrange
+        int result;
+        STRING_HANDLE handle = STRING_construct(INITIAL_STRING_VALUE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(COMBINED_STRING_VALUE)));
+
+        ///act
+        result = STRING_concat(handle, LONG_STRING_VALUE);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, COMBINED_STRING_VALUE, STRING_c_str(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        STRING_delete(handle);
+    }
+
+    /* Tests_SRS_STRING_01_010: [ When a value stored in the STRING control block grows beyond STRING_INLINE_CAPACITY bytes, it shall be moved to memory allocated with malloc. ] */
+    TEST_FUNCTION(when_moving_the_value_to_the_heap_fails_STRING_concat_fails_and_keeps_the_value)
+    {
+        ///arrange
+        int result;
+        STRING_HANDLE handle = STRING_construct(INITIAL_STRING_VALUE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(COMBINED_STRING_VALUE)))
+            .SetReturn(NULL);
+
+        ///act
+        result = STRING_concat(handle, LONG_STRING_VALUE);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, INITIAL_STRING_VALUE, STRING_c_str(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        STRING_delete(handle);
+    }
+
+    /* Tests_SRS_STRING_01_010: [ When a value stored in the STRING control block grows beyond STRING_INLINE_CAPACITY bytes, it shall be moved to memory allocated with malloc. ] */
+    TEST_FUNCTION(STRING_concat_with_STRING_of_a_string_with_itself_past_the_inline_storage_succeeds)
+    {
+        ///arrange
+        int result;
+        STRING_HANDLE handle = STRING_construct(SHORT_STRING_VALUE);
+        umock_c_reset_all_calls();
+
+        /*the capacity doubles, from the 14 bytes of the value*/
+        STRICT_EXPECTED_CALL(gballoc_malloc(2 * sizeof(SHORT_STRING_VALUE)));
+
+        ///act
+        result = STRING_concat_with_STRING(handle, handle);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, LONG_STRING_VALUE, STRING_c_str(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        STRING_delete(handle);
+    }
+
+END_TEST_SUITE(strings_inline_unittests)
@@ -4,9 +4,11 @@
 #ifdef __cplusplus
 #include <cstdlib>
 #include <cstddef>
+#include <cstring>
 #else
 #include <stdlib.h>
 #include <stddef.h>
+#include <string.h>
 #endif
 
 void* my_gballoc_malloc(size_t size)
@@ -1346,6 +1348,263 @@ BEGIN_TEST_SUITE(strings_unittests)
         ///cleanup
     }
 
+    /* Tests_SRS_STRING_01_012: [ If handle or source is NULL, STRING_concat_JSON shall fail and return a non-zero value. ] */
+    TEST_FUNCTION(STRING_concat_JSON_with_NULL_handle_fails)
+    {
+        ///arrange
+
+        ///act
+        int result = STRING_concat_JSON(NULL, "a");
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_STRING_01_012: [ If handle or source is NULL, STRING_concat_JSON shall fail and return a non-zero value. ] */
+    TEST_FUNCTION(STRING_concat_JSON_with_NULL_source_fails)
+    {
+        ///arrange
+        int result;
+        STRING_HANDLE handle = STRING_construct("{");
+        umock_c_reset_all_calls();
+
+        ///act
+        result = STRING_concat_JSON(handle, NULL);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, "{", STRING_c_str(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        STRING_delete(handle);
+    }
+
+    /* Tests_SRS_STRING_01_011: [ STRING_concat_JSON shall append to handle the JSON representation of source that STRING_new_JSON produces. ] */
+    /* Tests_SRS_STRING_01_015: [ On success STRING_concat_JSON shall return 0. ] */
+    TEST_FUNCTION(STRING_concat_JSON_succeeds)
+    {
+        size_t i;
+        for (i = 0; i < sizeof(JSONtests) / sizeof(JSONtests[0]); i++)
+        {
+            ///arrange
+            int result;
+            STRING_HANDLE handle = STRING_construct("{");
+            umock_c_reset_all_calls();
+
+            STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, strlen(JSONtests[i].expectedJSON) + 2))
+                .IgnoreArgument(1);
+
+            ///act
+            result = STRING_concat_JSON(handle, JSONtests[i].source);
+
+            ///assert
+            ASSERT_ARE_EQUAL(int, 0, result);
+            ASSERT_ARE_EQUAL(char_ptr, JSONtests[i].expectedJSON, STRING_c_str(handle) + 1);
+            ASSERT_ARE_EQUAL(size_t, strlen(JSONtests[i].expectedJSON) + 1, STRING_length(handle));
+            ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+            ///cleanup
+            STRING_delete(handle);
+        }
+    }
+
+    /* Tests_SRS_STRING_01_011: [ STRING_concat_JSON shall append to handle the JSON representation of source that STRING_new_JSON produces. ] */
+    TEST_FUNCTION(STRING_concat_JSON_with_the_value_of_the_same_handle_succeeds)
+    {
+        ///arrange
+        int result;
+        STRING_HANDLE handle = STRING_construct("a\"b");
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+            .IgnoreArgument(1)
+            .IgnoreArgument(2);
+
+        ///act
+        result = STRING_concat_JSON(handle, STRING_c_str(handle));
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, "a\"b\"a\\\"b\"", STRING_c_str(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        STRING_delete(handle);
+    }
+
+    /* Tests_SRS_STRING_01_013: [ If source has a character that STRING_new_JSON rejects, STRING_concat_JSON shall fail, return a non-zero value and leave handle unchanged. ] */
+    TEST_FUNCTION(STRING_concat_JSON_when_character_not_ASCII_fails)
+    {
+        ///arrange
+        int result;
+        STRING_HANDLE handle = STRING_construct("{");
+        umock_c_reset_all_calls();
+
+        ///act
+        result = STRING_concat_JSON(handle, "a\xFF");
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, "{", STRING_c_str(handle));
+        ASSERT_ARE_EQUAL(size_t, 1, STRING_length(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        STRING_delete(handle);
+    }
+
+    /* Tests_SRS_STRING_01_014: [ If the capacity is not enough, STRING_concat_JSON shall grow it like STRING_concat does; if that fails, STRING_concat_JSON shall return a non-zero value and leave handle unchanged. ] */
+    TEST_FUNCTION(STRING_concat_JSON_when_realloc_fails_fails)
+    {
+        ///arrange
+        int result;
+        STRING_HANDLE handle = STRING_construct("{");
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+            .IgnoreArgument(1)
+            .IgnoreArgument(2)
+            .SetReturn(NULL);
+
+        ///act
+        result = STRING_concat_JSON(handle, "key");
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, "{", STRING_c_str(handle));
+        ASSERT_ARE_EQUAL(size_t, 1, STRING_length(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        STRING_delete(handle);
+    }
+
+    /* Tests_SRS_STRING_01_016: [ STRING_JSON_length shall write in length the number of characters of the JSON representation of source that STRING_new_JSON produces, quotes included, and return 0. ] */
+    TEST_FUNCTION(STRING_JSON_length_succeeds)
+    {
+        size_t i;
+        for (i = 0; i < sizeof(JSONtests) / sizeof(JSONtests[0]); i++)
+        {
+            ///arrange
+            size_t length = 0;
+            int result;
+
+            ///act
+            result = STRING_JSON_length(JSONtests[i].source, &length);
+
+            ///assert
+            ASSERT_ARE_EQUAL(int, 0, result);
+            ASSERT_ARE_EQUAL(size_t, strlen(JSONtests[i].expectedJSON), length);
+            ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        }
+    }
+
+    /* Tests_SRS_STRING_01_017: [ If source or length is NULL, STRING_JSON_length shall fail and return a non-zero value. ] */
+    TEST_FUNCTION(STRING_JSON_length_with_NULL_arguments_fails)
+    {
+        ///arrange
+        size_t length;
+
+        ///act
+        int result1 = STRING_JSON_length(NULL, &length);
+        int result2 = STRING_JSON_length("a", NULL);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+        ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_STRING_01_018: [ If source has a character that STRING_new_JSON rejects, STRING_JSON_length shall fail and return a non-zero value. ] */
+    TEST_FUNCTION(STRING_JSON_length_when_character_not_ASCII_fails)
+    {
+        ///arrange
+        size_t length;
+
+        ///act
+        int result = STRING_JSON_length("a\xFF", &length);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_STRING_01_019: [ STRING_JSON_write shall write at destination the JSON representation of source that STRING_new_JSON produces, without a '\0', write in written the number of characters it wrote and return 0. ] */
+    TEST_FUNCTION(STRING_JSON_write_succeeds)
+    {
+        size_t i;
+        for (i = 0; i < sizeof(JSONtests) / sizeof(JSONtests[0]); i++)
+        {
+            ///arrange
+            char destination[256];
+            size_t expectedLength = strlen(JSONtests[i].expectedJSON);
+            size_t written = 0;
+            int result;
+            (void)memset(destination, 'x', sizeof(destination));
+
+            ///act
+            result = STRING_JSON_write(destination, expectedLength, JSONtests[i].source, &written);
+
+            ///assert
+            ASSERT_ARE_EQUAL(int, 0, result);
+            ASSERT_ARE_EQUAL(size_t, expectedLength, written);
+            ASSERT_ARE_EQUAL(int, 0, memcmp(JSONtests[i].expectedJSON, destination, expectedLength));
+            ASSERT_ARE_EQUAL(int, (int)'x', (int)destination[expectedLength]);
+            ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+        }
+    }
+
+    /* Tests_SRS_STRING_01_020: [ If destination, source or written is NULL, STRING_JSON_write shall fail and return a non-zero value. ] */
+    TEST_FUNCTION(STRING_JSON_write_with_NULL_arguments_fails)
+    {
+        ///arrange
+        char destination[8];
+        size_t written;
+
+        ///act
+        int result1 = STRING_JSON_write(NULL, sizeof(destination), "a", &written);
+        int result2 = STRING_JSON_write(destination, sizeof(destination), NULL, &written);
+        int result3 = STRING_JSON_write(destination, sizeof(destination), "a", NULL);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result1);
+        ASSERT_ARE_NOT_EQUAL(int, 0, result2);
+        ASSERT_ARE_NOT_EQUAL(int, 0, result3);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_STRING_01_021: [ If source has a character that STRING_new_JSON rejects or destinationSize is smaller than the JSON representation, STRING_JSON_write shall fail, return a non-zero value; what it wrote at destination is then unspecified. ] */
+    TEST_FUNCTION(STRING_JSON_write_when_destination_is_too_small_fails)
+    {
+        ///arrange
+        char destination[8];
+        size_t written;
+
+        ///act
+        int result = STRING_JSON_write(destination, 4, "a\"b", &written);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_STRING_01_021: [ If source has a character that STRING_new_JSON rejects or destinationSize is smaller than the JSON representation, STRING_JSON_write shall fail, return a non-zero value; what it wrote at destination is then unspecified. ] */
+    TEST_FUNCTION(STRING_JSON_write_when_character_not_ASCII_fails)
+    {
+        ///arrange
+        char destination[8];
+        size_t written;
+
+        ///act
+        int result = STRING_JSON_write(destination, sizeof(destination), "a\xFF", &written);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
     /*Tests_SRS_STRING_02_022: [ If source is NULL and size > 0 then STRING_from_BUFFER shall fail and return NULL. ]*/
     TEST_FUNCTION(STRING_from_byte_array_with_NULL_array_and_size_not_zero_fails)
     {
@@ -1570,6 +1829,81 @@ BEGIN_TEST_SUITE(strings_unittests)
         STRING_delete(str_handle);
     }
 
+    /* Tests_SRS_STRING_01_022: [ STRING_construct_sprintf and STRING_sprintf shall format only once when the result fits in STRING_SPRINTF_BUFFER_SIZE bytes or in the spare capacity of the STRING. ] */
+    TEST_FUNCTION(STRING_sprintf_within_capacity_does_not_realloc)
+    {
+        ///arrange
+        int str_result;
+        STRING_HANDLE str_handle = STRING_construct(INITIAL_STRING_VALUE);
+        ASSERT_IS_NOT_NULL(str_handle);
+        ASSERT_ARE_EQUAL(int, 0, STRING_reserve(str_handle, strlen(INITIAL_STRING_VALUE) + 512));
+        umock_c_reset_all_calls();
+
+        ///act
+        str_result = STRING_sprintf(str_handle, FORMAT_STRING, TEST_STRING_VALUE);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, str_result);
+        ASSERT_ARE_EQUAL(char_ptr, INIT_FORMAT_STRING_RESULT, STRING_c_str(str_handle));
+        ASSERT_ARE_EQUAL(size_t, strlen(INIT_FORMAT_STRING_RESULT), STRING_length(str_handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        STRING_delete(str_handle);
+    }
+
+    /* Tests_SRS_STRING_07_044: [On success STRING_sprintf shall return 0.] */
+    TEST_FUNCTION(STRING_sprintf_longer_than_the_stack_buffer_succeeds)
+    {
+        ///arrange
+        int str_result;
+        char long_value[1000];
+        STRING_HANDLE str_handle = STRING_construct(INITIAL_STRING_VALUE);
+        ASSERT_IS_NOT_NULL(str_handle);
+        (void)memset(long_value, 'x', sizeof(long_value) - 1);
+        long_value[sizeof(long_value) - 1] = '\0';
+        umock_c_reset_all_calls();
+
+        EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+
+        ///act
+        str_result = STRING_sprintf(str_handle, "%s", long_value);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, str_result);
+        ASSERT_ARE_EQUAL(size_t, strlen(INITIAL_STRING_VALUE) + sizeof(long_value) - 1, STRING_length(str_handle));
+        ASSERT_ARE_EQUAL(int, 0, strncmp(STRING_c_str(str_handle), INITIAL_STRING_VALUE, strlen(INITIAL_STRING_VALUE)));
+        ASSERT_ARE_EQUAL(char_ptr, long_value, STRING_c_str(str_handle) + strlen(INITIAL_STRING_VALUE));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        STRING_delete(str_handle);
+    }
+
+    /* Tests_SRS_STRING_07_045: [STRING_construct_sprintf shall allocate a new string with the value of the specified printf formated const char. ] */
+    TEST_FUNCTION(STRING_construct_sprintf_longer_than_the_stack_buffer_succeeds)
+    {
+        ///arrange
+        STRING_HANDLE str_handle;
+        char long_value[1000];
+        (void)memset(long_value, 'x', sizeof(long_value) - 1);
+        long_value[sizeof(long_value) - 1] = '\0';
+
+        EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+        EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+        ///act
+        str_handle = STRING_construct_sprintf("%s", long_value);
+
+        ///assert
+        ASSERT_IS_NOT_NULL(str_handle);
+        ASSERT_ARE_EQUAL(char_ptr, long_value, STRING_c_str(str_handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        STRING_delete(str_handle);
+    }
+
     /* Tests_SRS_STRING_07_046: [ If handle is NULL STRING_replace shall return a non-zero value. ] */
     TEST_FUNCTION(STRING_replace_handle_NULL_fail)
     {
@@ -1695,4 +2029,185 @@ BEGIN_TEST_SUITE(strings_unittests)
         STRING_delete(str_handle);
     }
 
+    /* Tests_SRS_STRING_01_001: [ If the capacity is not enough, STRING_concat, STRING_concat_with_STRING and STRING_sprintf shall grow the capacity to the larger of the required size and twice the current capacity. ] */
+    TEST_FUNCTION(STRING_concat_doubles_the_capacity)
+    {
+        //arrange
+        int str_result;
+        STRING_HANDLE str_handle = STRING_construct(TEST_STRING_VALUE);
+        ASSERT_IS_NOT_NULL(str_handle);
+        (void)STRING_empty(str_handle);
+        (void)STRING_concat(str_handle, "a");
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 4))
+            .IgnoreArgument(1);
+
+        //act
+        str_result = STRING_concat(str_handle, "b");
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, str_result);
+        ASSERT_ARE_EQUAL(char_ptr, "ab", STRING_c_str(str_handle));
+        ASSERT_ARE_EQUAL(size_t, 2, STRING_length(str_handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        STRING_delete(str_handle);
+    }
+
+    /* Tests_SRS_STRING_01_001: [ If the capacity is not enough, STRING_concat, STRING_concat_with_STRING and STRING_sprintf shall grow the capacity to the larger of the required size and twice the current capacity. ] */
+    TEST_FUNCTION(STRING_concat_within_capacity_does_not_realloc)
+    {
+        //arrange
+        int str_result;
+        STRING_HANDLE str_handle = STRING_construct(INITIAL_STRING_VALUE);
+        ASSERT_IS_NOT_NULL(str_handle);
+        ASSERT_ARE_EQUAL(int, 0, STRING_reserve(str_handle, strlen(COMBINED_STRING_VALUE)));
+        umock_c_reset_all_calls();
+
+        //act
+        str_result = STRING_concat(str_handle, TEST_STRING_VALUE);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, str_result);
+        ASSERT_ARE_EQUAL(char_ptr, COMBINED_STRING_VALUE, STRING_c_str(str_handle));
+        ASSERT_ARE_EQUAL(size_t, strlen(COMBINED_STRING_VALUE), STRING_length(str_handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        STRING_delete(str_handle);
+    }
+
+    /* Tests_SRS_STRING_07_034: [String_Concat_with_STRING shall concatenate a given STRING_HANDLE variable with a source STRING_HANDLE.] */
+    TEST_FUNCTION(STRING_concat_with_STRING_same_handle_succeeds)
+    {
+        //arrange
+        int str_result;
+        STRING_HANDLE str_handle = STRING_construct(TEST_STRING_VALUE);
+        ASSERT_IS_NOT_NULL(str_handle);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+            .IgnoreArgument(1)
+            .IgnoreArgument(2);
+
+        //act
+        str_result = STRING_concat_with_STRING(str_handle, str_handle);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, str_result);
+        ASSERT_ARE_EQUAL(char_ptr, MULTIPLE_TEST_STRING_VALUE, STRING_c_str(str_handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        STRING_delete(str_handle);
+    }
+
+    /* Tests_SRS_STRING_01_002: [ If handle is NULL, STRING_reserve shall fail and return a non-zero value. ] */
+    TEST_FUNCTION(STRING_reserve_with_NULL_handle_fails)
+    {
+        //arrange
+        int str_result;
+
+        //act
+        str_result = STRING_reserve(NULL, 10);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, str_result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_STRING_01_003: [ If capacity + 1 overflows, STRING_reserve shall fail and return a non-zero value. ] */
+    TEST_FUNCTION(STRING_reserve_with_overflowing_capacity_fails)
+    {
+        //arrange
+        int str_result;
+        STRING_HANDLE str_handle = STRING_construct(INITIAL_STRING_VALUE);
+        ASSERT_IS_NOT_NULL(str_handle);
+        umock_c_reset_all_calls();
+
+        //act
+        str_result = STRING_reserve(str_handle, (size_t)-1);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, str_result);
+        ASSERT_ARE_EQUAL(char_ptr, INITIAL_STRING_VALUE, STRING_c_str(str_handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        STRING_delete(str_handle);
+    }
+
+    /* Tests_SRS_STRING_01_004: [ If the string can already hold capacity characters, STRING_reserve shall not allocate and shall return 0. ] */
+    TEST_FUNCTION(STRING_reserve_smaller_than_the_capacity_does_not_allocate)
+    {
+        //arrange
+        int str_result;
+        STRING_HANDLE str_handle = STRING_construct(INITIAL_STRING_VALUE);
+        ASSERT_IS_NOT_NULL(str_handle);
+        umock_c_reset_all_calls();
+
+        //act
+        str_result = STRING_reserve(str_handle, strlen(INITIAL_STRING_VALUE));
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, str_result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        STRING_delete(str_handle);
+    }
+
+    /* Tests_SRS_STRING_01_005: [ Otherwise STRING_reserve shall reallocate the string so that it can hold capacity characters plus the terminating '\0', leaving its content unchanged. ] */
+    /* Tests_SRS_STRING_01_007: [ On success STRING_reserve shall return 0. ] */
+    TEST_FUNCTION(STRING_reserve_reallocates_the_string)
+    {
+        //arrange
+        int str_result;
+        STRING_HANDLE str_handle = STRING_construct(INITIAL_STRING_VALUE);
+        ASSERT_IS_NOT_NULL(str_handle);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 101))
+            .IgnoreArgument(1);
+
+        //act
+        str_result = STRING_reserve(str_handle, 100);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, str_result);
+        ASSERT_ARE_EQUAL(char_ptr, INITIAL_STRING_VALUE, STRING_c_str(str_handle));
+        ASSERT_ARE_EQUAL(size_t, strlen(INITIAL_STRING_VALUE), STRING_length(str_handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        STRING_delete(str_handle);
+    }
+
+    /* Tests_SRS_STRING_01_006: [ If reallocating fails, STRING_reserve shall return a non-zero value and leave the string unchanged. ] */
+    TEST_FUNCTION(STRING_reserve_when_realloc_fails_fails)
+    {
+        //arrange
+        int str_result;
+        STRING_HANDLE str_handle = STRING_construct(INITIAL_STRING_VALUE);
+        ASSERT_IS_NOT_NULL(str_handle);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 101))
+            .IgnoreArgument(1)
+            .SetReturn(NULL);
+
+        //act
+        str_result = STRING_reserve(str_handle, 100);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, str_result);
+        ASSERT_ARE_EQUAL(char_ptr, INITIAL_STRING_VALUE, STRING_c_str(str_handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        STRING_delete(str_handle);
+    }
+
 END_TEST_SUITE(strings_unittests)
\ No newline at end of file
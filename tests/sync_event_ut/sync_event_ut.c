@@ -0,0 +1,931 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#include "macro_utils.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_bool.h"
+#include "umocktypes_stdint.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#include "azure_c_shared_utility/sync_wait.h"
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/sync_event.h"
+
+IMPLEMENT_UMOCK_C_ENUM_TYPE(SYNC_WAIT_RESULT, SYNC_WAIT_RESULT_VALUES);
+TEST_DEFINE_ENUM_TYPE(SYNC_EVENT_RESULT, SYNC_EVENT_RESULT_VALUES);
+
+static const TICK_COUNTER_HANDLE TEST_TICK_COUNTER_HANDLE = (TICK_COUNTER_HANDLE)0x4242;
+
+typedef enum TEST_SYNC_WAIT_ACTION_TAG
+{
+    TEST_SYNC_WAIT_TIMES_OUT,
+    TEST_SYNC_WAIT_WAKES_SPURIOUSLY,
+    TEST_SYNC_WAIT_SETS_EVENT,
+    TEST_SYNC_WAIT_RELEASES_SEMAPHORE
+} TEST_SYNC_WAIT_ACTION;
+
+/* what another thread does while the waiter is parked in sync_wait_on_address */
+static TEST_SYNC_WAIT_ACTION g_sync_wait_action;
+static SYNC_EVENT_HANDLE g_waited_event;
+static SYNC_SEMAPHORE_HANDLE g_waited_semaphore;
+static uint32_t g_released_count;
+static SYNC_EVENT_RESULT g_setter_result;
+static tickcounter_ms_t g_now;
+
+static SYNC_WAIT_RESULT my_sync_wait_on_address(volatile int32_t* address, int32_t compare_value, int timeout_milliseconds)
+{
+    SYNC_WAIT_RESULT result;
+
+    (void)address;
+    (void)compare_value;
+
+    switch (g_sync_wait_action)
+    {
+    default:
+    case TEST_SYNC_WAIT_TIMES_OUT:
+        g_now += (tickcounter_ms_t)timeout_milliseconds;
+        result = SYNC_WAIT_TIMEOUT;
+        break;
+    case TEST_SYNC_WAIT_WAKES_SPURIOUSLY:
+        /* the next park gets the real wake */
+        g_sync_wait_action = (g_waited_event != NULL) ? TEST_SYNC_WAIT_SETS_EVENT : TEST_SYNC_WAIT_RELEASES_SEMAPHORE;
+        result = SYNC_WAIT_OK;
+        break;
+    case TEST_SYNC_WAIT_SETS_EVENT:
+        g_setter_result = sync_event_set(g_waited_event);
+        result = SYNC_WAIT_OK;
+        break;
+    case TEST_SYNC_WAIT_RELEASES_SEMAPHORE:
+        g_setter_result = sync_semaphore_release(g_waited_semaphore, g_released_count);
+        result = SYNC_WAIT_OK;
+        break;
+    }
+
+    return result;
+}
+
+static int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = g_now;
+    return 0;
+}
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+static SYNC_EVENT_HANDLE create_event(bool manual_reset, bool initially_set)
+{
+    SYNC_EVENT_HANDLE result = sync_event_create(manual_reset, initially_set);
+    ASSERT_IS_NOT_NULL(result);
+    umock_c_reset_all_calls();
+    return result;
+}
+
+static SYNC_SEMAPHORE_HANDLE create_semaphore(uint32_t initial_count)
+{
+    SYNC_SEMAPHORE_HANDLE result = sync_semaphore_create(initial_count);
+    ASSERT_IS_NOT_NULL(result);
+    umock_c_reset_all_calls();
+    return result;
+}
+
+BEGIN_TEST_SUITE(sync_event_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result, "umock_c_init");
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_charptr_register_types");
+
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_bool_register_types");
+
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_stdint_register_types");
+
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(volatile int32_t*, void*);
+    REGISTER_TYPE(SYNC_WAIT_RESULT, SYNC_WAIT_RESULT);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+    REGISTER_GLOBAL_MOCK_HOOK(sync_wait_on_address, my_sync_wait_on_address);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    g_sync_wait_action = TEST_SYNC_WAIT_TIMES_OUT;
+    g_waited_event = NULL;
+    g_waited_semaphore = NULL;
+    g_released_count = 1;
+    g_setter_result = SYNC_EVENT_ERROR;
+    g_now = 0;
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/* sync_event_create */
+
+/* Tests_SRS_SYNC_EVENT_01_001: [ sync_event_create shall create an event that is reset manually if manual_reset is true, and set if initially_set is true, and return a non-NULL handle to it. ]*/
+TEST_FUNCTION(sync_event_create_creates_a_reset_event)
+{
+    // arrange
+    SYNC_EVENT_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = sync_event_create(false, false);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_TIMEOUT, sync_event_try_wait(result));
+
+    // cleanup
+    sync_event_destroy(result);
+}
+
+/* Tests_SRS_SYNC_EVENT_01_001: [ sync_event_create shall create an event that is reset manually if manual_reset is true, and set if initially_set is true, and return a non-NULL handle to it. ]*/
+TEST_FUNCTION(sync_event_create_creates_a_set_event)
+{
+    // arrange
+    SYNC_EVENT_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = sync_event_create(false, true);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, sync_event_try_wait(result));
+
+    // cleanup
+    sync_event_destroy(result);
+}
+
+/* Tests_SRS_SYNC_EVENT_01_002: [ If allocating memory for the event fails, sync_event_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_memory_fails_sync_event_create_fails)
+{
+    // arrange
+    SYNC_EVENT_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = sync_event_create(false, false);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* sync_event_destroy */
+
+/* Tests_SRS_SYNC_EVENT_01_003: [ sync_event_destroy shall free the event. ]*/
+TEST_FUNCTION(sync_event_destroy_frees_the_event)
+{
+    // arrange
+    SYNC_EVENT_HANDLE sync_event = create_event(false, false);
+    STRICT_EXPECTED_CALL(gballoc_free(sync_event));
+
+    // act
+    sync_event_destroy(sync_event);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SYNC_EVENT_01_004: [ If sync_event is NULL, sync_event_destroy shall do nothing. ]*/
+TEST_FUNCTION(sync_event_destroy_with_NULL_returns)
+{
+    // arrange
+
+    // act
+    sync_event_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* sync_event_set */
+
+/* Tests_SRS_SYNC_EVENT_01_005: [ If sync_event is NULL, sync_event_set shall fail and return SYNC_EVENT_INVALID_ARG. ]*/
+TEST_FUNCTION(sync_event_set_with_NULL_fails)
+{
+    // arrange
+    SYNC_EVENT_RESULT result;
+
+    // act
+    result = sync_event_set(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SYNC_EVENT_01_006: [ sync_event_set shall set the event. ]*/
+/* Tests_SRS_SYNC_EVENT_01_008: [ On success sync_event_set shall return SYNC_EVENT_OK. ]*/
+TEST_FUNCTION(sync_event_set_without_waiters_does_not_wake)
+{
+    // arrange
+    SYNC_EVENT_HANDLE sync_event = create_event(false, false);
+    SYNC_EVENT_RESULT result;
+
+    // act
+    result = sync_event_set(sync_event);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, sync_event_try_wait(sync_event));
+
+    // cleanup
+    sync_event_destroy(sync_event);
+}
+
+/* Tests_SRS_SYNC_EVENT_01_007: [ If the event was not set and a thread is parked on it, sync_event_set shall wake one waiter of an auto reset event, or all the waiters of a manual reset event, with sync_wake_by_address. ]*/
+TEST_FUNCTION(sync_event_set_wakes_one_waiter_of_an_auto_reset_event)
+{
+    // arrange
+    SYNC_EVENT_HANDLE sync_event = create_event(false, false);
+    SYNC_EVENT_RESULT result;
+    g_waited_event = sync_event;
+    g_sync_wait_action = TEST_SYNC_WAIT_SETS_EVENT;
+    STRICT_EXPECTED_CALL(sync_wait_on_address(IGNORED_PTR_ARG, 0, 0));
+    STRICT_EXPECTED_CALL(sync_wake_by_address(IGNORED_PTR_ARG, false));
+
+    // act
+    result = sync_event_wait(sync_event, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, result);
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, g_setter_result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sync_event_destroy(sync_event);
+}
+
+/* Tests_SRS_SYNC_EVENT_01_007: [ If the event was not set and a thread is parked on it, sync_event_set shall wake one waiter of an auto reset event, or all the waiters of a manual reset event, with sync_wake_by_address. ]*/
+TEST_FUNCTION(sync_event_set_wakes_all_the_waiters_of_a_manual_reset_event)
+{
+    // arrange
+    SYNC_EVENT_HANDLE sync_event = create_event(true, false);
+    SYNC_EVENT_RESULT result;
+    g_waited_event = sync_event;
+    g_sync_wait_action = TEST_SYNC_WAIT_SETS_EVENT;
+    STRICT_EXPECTED_CALL(sync_wait_on_address(IGNORED_PTR_ARG, 0, 0));
+    STRICT_EXPECTED_CALL(sync_wake_by_address(IGNORED_PTR_ARG, true));
+
+    // act
+    result = sync_event_wait(sync_event, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sync_event_destroy(sync_event);
+}
+
+/* sync_event_reset */
+
+/* Tests_SRS_SYNC_EVENT_01_009: [ If sync_event is NULL, sync_event_reset shall fail and return SYNC_EVENT_INVALID_ARG. ]*/
+TEST_FUNCTION(sync_event_reset_with_NULL_fails)
+{
+    // arrange
+    SYNC_EVENT_RESULT result;
+
+    // act
+    result = sync_event_reset(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SYNC_EVENT_01_010: [ sync_event_reset shall reset the event and return SYNC_EVENT_OK. ]*/
+TEST_FUNCTION(sync_event_reset_resets_a_manual_reset_event)
+{
+    // arrange
+    SYNC_EVENT_HANDLE sync_event = create_event(true, true);
+    SYNC_EVENT_RESULT result;
+
+    // act
+    result = sync_event_reset(sync_event);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_TIMEOUT, sync_event_try_wait(sync_event));
+
+    // cleanup
+    sync_event_destroy(sync_event);
+}
+
+/* sync_event_wait */
+
+/* Tests_SRS_SYNC_EVENT_01_011: [ If sync_event is NULL or timeout_milliseconds is negative, sync_event_wait shall fail and return SYNC_EVENT_INVALID_ARG. ]*/
+TEST_FUNCTION(sync_event_wait_with_NULL_fails)
+{
+    // arrange
+    SYNC_EVENT_RESULT result;
+
+    // act
+    result = sync_event_wait(NULL, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SYNC_EVENT_01_011: [ If sync_event is NULL or timeout_milliseconds is negative, sync_event_wait shall fail and return SYNC_EVENT_INVALID_ARG. ]*/
+TEST_FUNCTION(sync_event_wait_with_negative_timeout_fails)
+{
+    // arrange
+    SYNC_EVENT_HANDLE sync_event = create_event(false, true);
+    SYNC_EVENT_RESULT result;
+
+    // act
+    result = sync_event_wait(sync_event, -1);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sync_event_destroy(sync_event);
+}
+
+/* Tests_SRS_SYNC_EVENT_01_012: [ sync_event_wait shall check the event up to SYNC_EVENT_SPIN_COUNT times, pausing the processor in between, before it parks. ]*/
+/* Tests_SRS_SYNC_EVENT_01_013: [ Once the event is set, sync_event_wait shall return SYNC_EVENT_OK, resetting an auto reset event. ]*/
+TEST_FUNCTION(sync_event_wait_on_a_set_auto_reset_event_returns_without_parking_and_resets_it)
+{
+    // arrange
+    SYNC_EVENT_HANDLE sync_event = create_event(false, true);
+    SYNC_EVENT_RESULT result;
+
+    // act
+    result = sync_event_wait(sync_event, 100);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_TIMEOUT, sync_event_try_wait(sync_event));
+
+    // cleanup
+    sync_event_destroy(sync_event);
+}
+
+/* Tests_SRS_SYNC_EVENT_01_013: [ Once the event is set, sync_event_wait shall return SYNC_EVENT_OK, resetting an auto reset event. ]*/
+TEST_FUNCTION(sync_event_wait_on_a_set_manual_reset_event_leaves_it_set)
+{
+    // arrange
+    SYNC_EVENT_HANDLE sync_event = create_event(true, true);
+    SYNC_EVENT_RESULT result;
+
+    // act
+    result = sync_event_wait(sync_event, 100);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, sync_event_try_wait(sync_event));
+
+    // cleanup
+    sync_event_destroy(sync_event);
+}
+
+/* Tests_SRS_SYNC_EVENT_01_014: [ While the event is not set, sync_event_wait shall park with sync_wait_on_address, at most for the time left of timeout_milliseconds as measured by a tick counter, and check the event again when it returns. ]*/
+TEST_FUNCTION(sync_event_wait_parks_again_after_a_spurious_wakeup)
+{
+    // arrange
+    SYNC_EVENT_HANDLE sync_event = create_event(false, false);
+    SYNC_EVENT_RESULT result;
+    g_waited_event = sync_event;
+    g_sync_wait_action = TEST_SYNC_WAIT_WAKES_SPURIOUSLY;
+    g_now = 0;
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(sync_wait_on_address(IGNORED_PTR_ARG, 0, 100));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(sync_wait_on_address(IGNORED_PTR_ARG, 0, 100));
+    STRICT_EXPECTED_CALL(sync_wake_by_address(IGNORED_PTR_ARG, false));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+
+    // act
+    result = sync_event_wait(sync_event, 100);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sync_event_destroy(sync_event);
+}
+
+/* Tests_SRS_SYNC_EVENT_01_014: [ While the event is not set, sync_event_wait shall park with sync_wait_on_address, at most for the time left of timeout_milliseconds as measured by a tick counter, and check the event again when it returns. ]*/
+/* Tests_SRS_SYNC_EVENT_01_015: [ If timeout_milliseconds is not 0 and the event is not set in time, sync_event_wait shall return SYNC_EVENT_TIMEOUT. ]*/
+TEST_FUNCTION(sync_event_wait_times_out_when_the_event_is_not_set)
+{
+    // arrange
+    SYNC_EVENT_HANDLE sync_event = create_event(false, false);
+    SYNC_EVENT_RESULT result;
+    g_now = 0;
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(sync_wait_on_address(IGNORED_PTR_ARG, 0, 100));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+
+    // act
+    result = sync_event_wait(sync_event, 100);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_TIMEOUT, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sync_event_destroy(sync_event);
+}
+
+/* Tests_SRS_SYNC_EVENT_01_016: [ If creating or reading the tick counter or sync_wait_on_address fails, sync_event_wait shall fail and return SYNC_EVENT_ERROR. ]*/
+TEST_FUNCTION(when_tickcounter_create_fails_sync_event_wait_fails)
+{
+    // arrange
+    SYNC_EVENT_HANDLE sync_event = create_event(false, false);
+    SYNC_EVENT_RESULT result;
+    STRICT_EXPECTED_CALL(tickcounter_create())
+        .SetReturn(NULL);
+
+    // act
+    result = sync_event_wait(sync_event, 100);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sync_event_destroy(sync_event);
+}
+
+/* Tests_SRS_SYNC_EVENT_01_016: [ If creating or reading the tick counter or sync_wait_on_address fails, sync_event_wait shall fail and return SYNC_EVENT_ERROR. ]*/
+TEST_FUNCTION(when_tickcounter_get_current_ms_fails_sync_event_wait_fails)
+{
+    // arrange
+    SYNC_EVENT_HANDLE sync_event = create_event(false, false);
+    SYNC_EVENT_RESULT result;
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+
+    // act
+    result = sync_event_wait(sync_event, 100);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sync_event_destroy(sync_event);
+}
+
+/* Tests_SRS_SYNC_EVENT_01_016: [ If creating or reading the tick counter or sync_wait_on_address fails, sync_event_wait shall fail and return SYNC_EVENT_ERROR. ]*/
+TEST_FUNCTION(when_sync_wait_on_address_fails_sync_event_wait_fails)
+{
+    // arrange
+    SYNC_EVENT_HANDLE sync_event = create_event(false, false);
+    SYNC_EVENT_RESULT result;
+    STRICT_EXPECTED_CALL(sync_wait_on_address(IGNORED_PTR_ARG, 0, 0))
+        .SetReturn(SYNC_WAIT_ERROR);
+
+    // act
+    result = sync_event_wait(sync_event, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sync_event_destroy(sync_event);
+}
+
+/* sync_event_try_wait */
+
+/* Tests_SRS_SYNC_EVENT_01_017: [ If sync_event is NULL, sync_event_try_wait shall fail and return SYNC_EVENT_INVALID_ARG. ]*/
+TEST_FUNCTION(sync_event_try_wait_with_NULL_fails)
+{
+    // arrange
+    SYNC_EVENT_RESULT result;
+
+    // act
+    result = sync_event_try_wait(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SYNC_EVENT_01_018: [ If the event is set, sync_event_try_wait shall return SYNC_EVENT_OK, resetting an auto reset event, otherwise it shall return SYNC_EVENT_TIMEOUT. ]*/
+TEST_FUNCTION(sync_event_try_wait_takes_a_set_auto_reset_event_once)
+{
+    // arrange
+    SYNC_EVENT_HANDLE sync_event = create_event(false, true);
+    SYNC_EVENT_RESULT result_1;
+    SYNC_EVENT_RESULT result_2;
+
+    // act
+    result_1 = sync_event_try_wait(sync_event);
+    result_2 = sync_event_try_wait(sync_event);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, result_1);
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_TIMEOUT, result_2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sync_event_destroy(sync_event);
+}
+
+/* sync_semaphore_create */
+
+/* Tests_SRS_SYNC_EVENT_01_019: [ sync_semaphore_create shall create a semaphore holding initial_count units and return a non-NULL handle to it. ]*/
+TEST_FUNCTION(sync_semaphore_create_creates_a_semaphore_holding_initial_count_units)
+{
+    // arrange
+    SYNC_SEMAPHORE_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = sync_semaphore_create(2);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, sync_semaphore_try_wait(result));
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, sync_semaphore_try_wait(result));
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_TIMEOUT, sync_semaphore_try_wait(result));
+
+    // cleanup
+    sync_semaphore_destroy(result);
+}
+
+/* Tests_SRS_SYNC_EVENT_01_020: [ If initial_count is greater than INT32_MAX, sync_semaphore_create shall fail and return NULL. ]*/
+TEST_FUNCTION(sync_semaphore_create_with_too_many_units_fails)
+{
+    // arrange
+    SYNC_SEMAPHORE_HANDLE result;
+
+    // act
+    result = sync_semaphore_create((uint32_t)INT32_MAX + 1);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SYNC_EVENT_01_021: [ If allocating memory for the semaphore fails, sync_semaphore_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_memory_fails_sync_semaphore_create_fails)
+{
+    // arrange
+    SYNC_SEMAPHORE_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = sync_semaphore_create(0);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* sync_semaphore_destroy */
+
+/* Tests_SRS_SYNC_EVENT_01_022: [ sync_semaphore_destroy shall free the semaphore. ]*/
+TEST_FUNCTION(sync_semaphore_destroy_frees_the_semaphore)
+{
+    // arrange
+    SYNC_SEMAPHORE_HANDLE sync_semaphore = create_semaphore(0);
+    STRICT_EXPECTED_CALL(gballoc_free(sync_semaphore));
+
+    // act
+    sync_semaphore_destroy(sync_semaphore);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SYNC_EVENT_01_023: [ If sync_semaphore is NULL, sync_semaphore_destroy shall do nothing. ]*/
+TEST_FUNCTION(sync_semaphore_destroy_with_NULL_returns)
+{
+    // arrange
+
+    // act
+    sync_semaphore_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* sync_semaphore_release */
+
+/* Tests_SRS_SYNC_EVENT_01_024: [ If sync_semaphore is NULL or count is 0 or greater than INT32_MAX, sync_semaphore_release shall fail and return SYNC_EVENT_INVALID_ARG. ]*/
+TEST_FUNCTION(sync_semaphore_release_with_NULL_fails)
+{
+    // arrange
+    SYNC_EVENT_RESULT result;
+
+    // act
+    result = sync_semaphore_release(NULL, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SYNC_EVENT_01_024: [ If sync_semaphore is NULL or count is 0 or greater than INT32_MAX, sync_semaphore_release shall fail and return SYNC_EVENT_INVALID_ARG. ]*/
+TEST_FUNCTION(sync_semaphore_release_of_0_units_fails)
+{
+    // arrange
+    SYNC_SEMAPHORE_HANDLE sync_semaphore = create_semaphore(0);
+    SYNC_EVENT_RESULT result;
+
+    // act
+    result = sync_semaphore_release(sync_semaphore, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sync_semaphore_destroy(sync_semaphore);
+}
+
+/* Tests_SRS_SYNC_EVENT_01_026: [ If the semaphore would hold more than INT32_MAX units, sync_semaphore_release shall fail and return SYNC_EVENT_INVALID_ARG. ]*/
+TEST_FUNCTION(sync_semaphore_release_past_INT32_MAX_units_fails)
+{
+    // arrange
+    SYNC_SEMAPHORE_HANDLE sync_semaphore = create_semaphore(INT32_MAX - 1);
+    SYNC_EVENT_RESULT result;
+
+    // act
+    result = sync_semaphore_release(sync_semaphore, 2);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sync_semaphore_destroy(sync_semaphore);
+}
+
+/* Tests_SRS_SYNC_EVENT_01_025: [ sync_semaphore_release shall add count units to the semaphore. ]*/
+/* Tests_SRS_SYNC_EVENT_01_028: [ On success sync_semaphore_release shall return SYNC_EVENT_OK. ]*/
+TEST_FUNCTION(sync_semaphore_release_without_waiters_does_not_wake)
+{
+    // arrange
+    SYNC_SEMAPHORE_HANDLE sync_semaphore = create_semaphore(0);
+    SYNC_EVENT_RESULT result;
+
+    // act
+    result = sync_semaphore_release(sync_semaphore, 2);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, sync_semaphore_try_wait(sync_semaphore));
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, sync_semaphore_try_wait(sync_semaphore));
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_TIMEOUT, sync_semaphore_try_wait(sync_semaphore));
+
+    // cleanup
+    sync_semaphore_destroy(sync_semaphore);
+}
+
+/* Tests_SRS_SYNC_EVENT_01_027: [ If a thread is parked on the semaphore, sync_semaphore_release shall wake one waiter when count is 1 and all of them otherwise, with sync_wake_by_address. ]*/
+TEST_FUNCTION(sync_semaphore_release_of_1_unit_wakes_one_waiter)
+{
+    // arrange
+    SYNC_SEMAPHORE_HANDLE sync_semaphore = create_semaphore(0);
+    SYNC_EVENT_RESULT result;
+    g_waited_semaphore = sync_semaphore;
+    g_released_count = 1;
+    g_sync_wait_action = TEST_SYNC_WAIT_RELEASES_SEMAPHORE;
+    STRICT_EXPECTED_CALL(sync_wait_on_address(IGNORED_PTR_ARG, 0, 0));
+    STRICT_EXPECTED_CALL(sync_wake_by_address(IGNORED_PTR_ARG, false));
+
+    // act
+    result = sync_semaphore_wait(sync_semaphore, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, result);
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, g_setter_result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_TIMEOUT, sync_semaphore_try_wait(sync_semaphore));
+
+    // cleanup
+    sync_semaphore_destroy(sync_semaphore);
+}
+
+/* Tests_SRS_SYNC_EVENT_01_027: [ If a thread is parked on the semaphore, sync_semaphore_release shall wake one waiter when count is 1 and all of them otherwise, with sync_wake_by_address. ]*/
+TEST_FUNCTION(sync_semaphore_release_of_several_units_wakes_all_the_waiters)
+{
+    // arrange
+    SYNC_SEMAPHORE_HANDLE sync_semaphore = create_semaphore(0);
+    SYNC_EVENT_RESULT result;
+    g_waited_semaphore = sync_semaphore;
+    g_released_count = 3;
+    g_sync_wait_action = TEST_SYNC_WAIT_RELEASES_SEMAPHORE;
+    STRICT_EXPECTED_CALL(sync_wait_on_address(IGNORED_PTR_ARG, 0, 0));
+    STRICT_EXPECTED_CALL(sync_wake_by_address(IGNORED_PTR_ARG, true));
+
+    // act
+    result = sync_semaphore_wait(sync_semaphore, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, sync_semaphore_try_wait(sync_semaphore));
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, sync_semaphore_try_wait(sync_semaphore));
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_TIMEOUT, sync_semaphore_try_wait(sync_semaphore));
+
+    // cleanup
+    sync_semaphore_destroy(sync_semaphore);
+}
+
+/* sync_semaphore_wait */
+
+/* Tests_SRS_SYNC_EVENT_01_029: [ If sync_semaphore is NULL or timeout_milliseconds is negative, sync_semaphore_wait shall fail and return SYNC_EVENT_INVALID_ARG. ]*/
+TEST_FUNCTION(sync_semaphore_wait_with_NULL_fails)
+{
+    // arrange
+    SYNC_EVENT_RESULT result;
+
+    // act
+    result = sync_semaphore_wait(NULL, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SYNC_EVENT_01_030: [ sync_semaphore_wait shall take one unit of the semaphore and return SYNC_EVENT_OK, spinning and parking while it holds none as sync_event_wait does. ]*/
+TEST_FUNCTION(sync_semaphore_wait_takes_an_available_unit_without_parking)
+{
+    // arrange
+    SYNC_SEMAPHORE_HANDLE sync_semaphore = create_semaphore(1);
+    SYNC_EVENT_RESULT result;
+
+    // act
+    result = sync_semaphore_wait(sync_semaphore, 100);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_OK, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_TIMEOUT, sync_semaphore_try_wait(sync_semaphore));
+
+    // cleanup
+    sync_semaphore_destroy(sync_semaphore);
+}
+
+/* Tests_SRS_SYNC_EVENT_01_031: [ If timeout_milliseconds is not 0 and no unit is released in time, sync_semaphore_wait shall return SYNC_EVENT_TIMEOUT. ]*/
+TEST_FUNCTION(sync_semaphore_wait_times_out_when_no_unit_is_released)
+{
+    // arrange
+    SYNC_SEMAPHORE_HANDLE sync_semaphore = create_semaphore(0);
+    SYNC_EVENT_RESULT result;
+    g_now = 0;
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(sync_wait_on_address(IGNORED_PTR_ARG, 0, 50));
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+
+    // act
+    result = sync_semaphore_wait(sync_semaphore, 50);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_TIMEOUT, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sync_semaphore_destroy(sync_semaphore);
+}
+
+/* Tests_SRS_SYNC_EVENT_01_032: [ If creating or reading the tick counter or sync_wait_on_address fails, sync_semaphore_wait shall fail and return SYNC_EVENT_ERROR. ]*/
+TEST_FUNCTION(when_sync_wait_on_address_fails_sync_semaphore_wait_fails)
+{
+    // arrange
+    SYNC_SEMAPHORE_HANDLE sync_semaphore = create_semaphore(0);
+    SYNC_EVENT_RESULT result;
+    STRICT_EXPECTED_CALL(sync_wait_on_address(IGNORED_PTR_ARG, 0, 0))
+        .SetReturn(SYNC_WAIT_ERROR);
+
+    // act
+    result = sync_semaphore_wait(sync_semaphore, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_ERROR, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sync_semaphore_destroy(sync_semaphore);
+}
+
+/* sync_semaphore_try_wait */
+
+/* Tests_SRS_SYNC_EVENT_01_033: [ If sync_semaphore is NULL, sync_semaphore_try_wait shall fail and return SYNC_EVENT_INVALID_ARG. ]*/
+TEST_FUNCTION(sync_semaphore_try_wait_with_NULL_fails)
+{
+    // arrange
+    SYNC_EVENT_RESULT result;
+
+    // act
+    result = sync_semaphore_try_wait(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_INVALID_ARG, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_SYNC_EVENT_01_034: [ If the semaphore holds a unit, sync_semaphore_try_wait shall take it and return SYNC_EVENT_OK, otherwise it shall return SYNC_EVENT_TIMEOUT. ]*/
+TEST_FUNCTION(sync_semaphore_try_wait_on_an_empty_semaphore_returns_SYNC_EVENT_TIMEOUT)
+{
+    // arrange
+    SYNC_SEMAPHORE_HANDLE sync_semaphore = create_semaphore(0);
+    SYNC_EVENT_RESULT result;
+
+    // act
+    result = sync_semaphore_try_wait(sync_semaphore);
+
+    // assert
+    ASSERT_ARE_EQUAL(SYNC_EVENT_RESULT, SYNC_EVENT_TIMEOUT, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    sync_semaphore_destroy(sync_semaphore);
+}
+
+END_TEST_SUITE(sync_event_unittests)
@@ -0,0 +1,739 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#include "macro_utils.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/condition.h"
+#include "azure_c_shared_utility/threadapi.h"
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/threadpool.h"
+
+IMPLEMENT_UMOCK_C_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(COND_RESULT, COND_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(THREADAPI_RESULT, THREADAPI_RESULT_VALUES);
+
+/* enough for the workers created with one per processor */
+#define TEST_MAX_WORKERS 1024
+
+static const LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4242;
+static const COND_HANDLE TEST_COND_HANDLE = (COND_HANDLE)0x4243;
+
+/* the spin lock handed to each worker, in creation order */
+static char test_spinlocks[TEST_MAX_WORKERS];
+static size_t test_spinlock_count;
+#define TEST_SPINLOCK(index) ((SPINLOCK_HANDLE)&test_spinlocks[index])
+
+static SPINLOCK_HANDLE my_SpinLock_Init(void)
+{
+    return (test_spinlock_count < TEST_MAX_WORKERS) ? TEST_SPINLOCK(test_spinlock_count++) : NULL;
+}
+
+/* workers do not run until they are joined, ThreadAPI_Join runs them on the test thread */
+typedef struct TEST_THREAD_TAG
+{
+    THREAD_START_FUNC func;
+    void* arg;
+} TEST_THREAD;
+
+static TEST_THREAD test_threads[TEST_MAX_WORKERS];
+static size_t test_thread_count;
+
+static THREADAPI_RESULT my_ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg)
+{
+    ASSERT_IS_TRUE(test_thread_count < TEST_MAX_WORKERS);
+    test_threads[test_thread_count].func = func;
+    test_threads[test_thread_count].arg = arg;
+    *threadHandle = &test_threads[test_thread_count];
+    test_thread_count++;
+    return THREADAPI_OK;
+}
+
+static THREADPOOL_HANDLE g_joined_threadpool;
+static int g_schedule_while_joining_result;
+
+static int count_work(void* context);
+
+static THREADAPI_RESULT my_ThreadAPI_Join(THREAD_HANDLE threadHandle, int* res)
+{
+    TEST_THREAD* thread = (TEST_THREAD*)threadHandle;
+
+    if (g_joined_threadpool != NULL)
+    {
+        /* some other thread tries to schedule while the pool is being destroyed */
+        g_schedule_while_joining_result = threadpool_schedule_work(g_joined_threadpool, count_work, NULL, NULL, NULL);
+    }
+
+    *res = thread->func(thread->arg);
+    return THREADAPI_OK;
+}
+
+/* how many times Condition_Wait returns COND_OK before returning COND_ERROR */
+static size_t g_condition_wait_ok_count;
+static THREADPOOL_HANDLE g_waited_threadpool;
+
+static COND_RESULT my_Condition_Wait(COND_HANDLE handle, LOCK_HANDLE lock, int timeout_milliseconds)
+{
+    COND_RESULT result;
+
+    (void)handle;
+    (void)lock;
+    (void)timeout_milliseconds;
+
+    if (g_condition_wait_ok_count == 0)
+    {
+        result = COND_ERROR;
+    }
+    else
+    {
+        g_condition_wait_ok_count--;
+        (void)threadpool_schedule_work(g_waited_threadpool, count_work, NULL, NULL, NULL);
+        result = COND_OK;
+    }
+
+    return result;
+}
+
+static size_t g_work_count;
+static size_t g_complete_count;
+static int g_last_work_result;
+static void* g_last_complete_context;
+static THREADPOOL_HANDLE g_scheduling_threadpool;
+
+static int count_work(void* context)
+{
+    (void)context;
+    g_work_count++;
+    return 42;
+}
+
+static int schedule_more_work(void* context)
+{
+    (void)context;
+    g_work_count++;
+    return threadpool_schedule_work(g_scheduling_threadpool, count_work, NULL, NULL, NULL);
+}
+
+static void on_work_complete(void* context, int work_result)
+{
+    g_complete_count++;
+    g_last_complete_context = context;
+    g_last_work_result = work_result;
+}
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+static THREADPOOL_HANDLE create_threadpool(size_t worker_count)
+{
+    THREADPOOL_CONFIG config;
+    THREADPOOL_HANDLE result;
+
+    config.worker_count = worker_count;
+    config.pin_workers = false;
+    result = threadpool_create(&config);
+    ASSERT_IS_NOT_NULL(result);
+    umock_c_reset_all_calls();
+    return result;
+}
+
+/* a worker with nothing to do that finds the pool stopping */
+static void setup_idle_worker_exit_expectations(size_t index, size_t worker_count)
+{
+    size_t i;
+    for (i = 0; i < worker_count; i++)
+    {
+        STRICT_EXPECTED_CALL(SpinLock_Lock(TEST_SPINLOCK((index + i) % worker_count)));
+        STRICT_EXPECTED_CALL(SpinLock_Unlock(TEST_SPINLOCK((index + i) % worker_count)));
+    }
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+}
+
+BEGIN_TEST_SUITE(threadpool_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result, "umock_c_init");
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_charptr_register_types");
+
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_stdint_register_types");
+
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(SPINLOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(COND_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_START_FUNC, void*);
+    REGISTER_TYPE(LOCK_RESULT, LOCK_RESULT);
+    REGISTER_TYPE(COND_RESULT, COND_RESULT);
+    REGISTER_TYPE(THREADAPI_RESULT, THREADAPI_RESULT);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_HOOK(SpinLock_Init, my_SpinLock_Init);
+    REGISTER_GLOBAL_MOCK_RETURN(SpinLock_Deinit, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(SpinLock_Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(SpinLock_Unlock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Init, TEST_COND_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(Condition_Post, COND_OK);
+    REGISTER_GLOBAL_MOCK_HOOK(Condition_Wait, my_Condition_Wait);
+    REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Create, my_ThreadAPI_Create);
+    REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Join, my_ThreadAPI_Join);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    test_spinlock_count = 0;
+    test_thread_count = 0;
+    g_joined_threadpool = NULL;
+    g_schedule_while_joining_result = 0;
+    g_condition_wait_ok_count = 0;
+    g_waited_threadpool = NULL;
+    g_work_count = 0;
+    g_complete_count = 0;
+    g_last_work_result = 0;
+    g_last_complete_context = NULL;
+    g_scheduling_threadpool = NULL;
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/* threadpool_create */
+
+/* Tests_SRS_THREADPOOL_01_003: [ threadpool_create shall allocate memory for the pool and create its lock and condition. ]*/
+/* Tests_SRS_THREADPOOL_01_004: [ threadpool_create shall create a spin lock and an empty deque for each worker. ]*/
+/* Tests_SRS_THREADPOOL_01_005: [ threadpool_create shall start each worker with ThreadAPI_Create. ]*/
+/* Tests_SRS_THREADPOOL_01_006: [ threadpool_create shall succeed and return a non-NULL value. ]*/
+/* Tests_SRS_THREADPOOL_01_025: [ threadpool_get_worker_count shall return the number of workers of threadpool. ]*/
+TEST_FUNCTION(threadpool_create_starts_the_configured_number_of_workers)
+{
+    // arrange
+    THREADPOOL_CONFIG config = { 2, false };
+    THREADPOOL_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init());
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(SpinLock_Init());
+    STRICT_EXPECTED_CALL(SpinLock_Init());
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = threadpool_create(&config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 2, threadpool_get_worker_count(result));
+
+    // cleanup
+    threadpool_destroy(result);
+}
+
+/* Tests_SRS_THREADPOOL_01_001: [ If config is NULL, threadpool_create shall create one worker per processor and not pin them. ]*/
+TEST_FUNCTION(threadpool_create_with_NULL_config_creates_at_least_one_worker)
+{
+    // arrange
+    THREADPOOL_HANDLE result;
+
+    // act
+    result = threadpool_create(NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(threadpool_get_worker_count(result) >= 1);
+    ASSERT_ARE_EQUAL(size_t, threadpool_get_worker_count(result), test_thread_count);
+
+    // cleanup
+    threadpool_destroy(result);
+}
+
+/* Tests_SRS_THREADPOOL_01_002: [ If the worker_count of config is 0, threadpool_create shall create one worker per processor. ]*/
+TEST_FUNCTION(threadpool_create_with_0_workers_creates_as_many_workers_as_with_NULL_config)
+{
+    // arrange
+    THREADPOOL_CONFIG config = { 0, false };
+    THREADPOOL_HANDLE default_threadpool = threadpool_create(NULL);
+    THREADPOOL_HANDLE result;
+    ASSERT_IS_NOT_NULL(default_threadpool);
+
+    // act
+    result = threadpool_create(&config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(size_t, threadpool_get_worker_count(default_threadpool), threadpool_get_worker_count(result));
+
+    // cleanup
+    threadpool_destroy(result);
+    threadpool_destroy(default_threadpool);
+}
+
+/* Tests_SRS_THREADPOOL_01_007: [ If any failure occurs, threadpool_create shall stop the workers it started, free all resources and return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_pool_fails_threadpool_create_fails)
+{
+    // arrange
+    THREADPOOL_CONFIG config = { 2, false };
+    THREADPOOL_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = threadpool_create(&config);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_THREADPOOL_01_007: [ If any failure occurs, threadpool_create shall stop the workers it started, free all resources and return NULL. ]*/
+TEST_FUNCTION(when_Lock_Init_fails_threadpool_create_fails)
+{
+    // arrange
+    THREADPOOL_CONFIG config = { 2, false };
+    THREADPOOL_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = threadpool_create(&config);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_THREADPOOL_01_007: [ If any failure occurs, threadpool_create shall stop the workers it started, free all resources and return NULL. ]*/
+TEST_FUNCTION(when_Condition_Init_fails_threadpool_create_fails)
+{
+    // arrange
+    THREADPOOL_CONFIG config = { 2, false };
+    THREADPOOL_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = threadpool_create(&config);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_THREADPOOL_01_007: [ If any failure occurs, threadpool_create shall stop the workers it started, free all resources and return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_workers_fails_threadpool_create_fails)
+{
+    // arrange
+    THREADPOOL_CONFIG config = { 2, false };
+    THREADPOOL_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init());
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(Condition_Deinit(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = threadpool_create(&config);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_THREADPOOL_01_007: [ If any failure occurs, threadpool_create shall stop the workers it started, free all resources and return NULL. ]*/
+TEST_FUNCTION(when_SpinLock_Init_fails_threadpool_create_fails)
+{
+    // arrange
+    THREADPOOL_CONFIG config = { 2, false };
+    THREADPOOL_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init());
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(SpinLock_Init());
+    STRICT_EXPECTED_CALL(SpinLock_Init())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(SpinLock_Deinit(TEST_SPINLOCK(0)));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Deinit(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = threadpool_create(&config);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_THREADPOOL_01_007: [ If any failure occurs, threadpool_create shall stop the workers it started, free all resources and return NULL. ]*/
+TEST_FUNCTION(when_ThreadAPI_Create_fails_threadpool_create_stops_the_started_workers_and_fails)
+{
+    // arrange
+    THREADPOOL_CONFIG config = { 2, false };
+    THREADPOOL_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(Condition_Init());
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(SpinLock_Init());
+    STRICT_EXPECTED_CALL(SpinLock_Init());
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(THREADAPI_ERROR);
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    setup_idle_worker_exit_expectations(0, 2);
+    STRICT_EXPECTED_CALL(SpinLock_Deinit(TEST_SPINLOCK(0)));
+    STRICT_EXPECTED_CALL(SpinLock_Deinit(TEST_SPINLOCK(1)));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Deinit(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = threadpool_create(&config);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* threadpool_destroy */
+
+/* Tests_SRS_THREADPOOL_01_013: [ If threadpool is NULL, threadpool_destroy shall return. ]*/
+TEST_FUNCTION(threadpool_destroy_with_NULL_returns)
+{
+    // arrange
+
+    // act
+    threadpool_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_THREADPOOL_01_012: [ Once the pool is stopping and no work is left, a worker shall exit. ]*/
+/* Tests_SRS_THREADPOOL_01_014: [ threadpool_destroy shall mark the pool as stopping and wake the workers. ]*/
+/* Tests_SRS_THREADPOOL_01_015: [ threadpool_destroy shall wait with ThreadAPI_Join for all workers to exit, which they do after running all the work still scheduled. ]*/
+/* Tests_SRS_THREADPOOL_01_016: [ threadpool_destroy shall free the spin locks, the condition, the lock and the memory of the pool. ]*/
+TEST_FUNCTION(threadpool_destroy_stops_the_workers_and_frees_the_pool)
+{
+    // arrange
+    THREADPOOL_HANDLE threadpool = create_threadpool(2);
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    setup_idle_worker_exit_expectations(0, 2);
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    setup_idle_worker_exit_expectations(1, 2);
+    STRICT_EXPECTED_CALL(SpinLock_Deinit(TEST_SPINLOCK(0)));
+    STRICT_EXPECTED_CALL(SpinLock_Deinit(TEST_SPINLOCK(1)));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Condition_Deinit(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(threadpool));
+
+    // act
+    threadpool_destroy(threadpool);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_THREADPOOL_01_009: [ A worker shall take the newest work item of its own deque, or otherwise steal the oldest work item of another worker. ]*/
+/* Tests_SRS_THREADPOOL_01_010: [ A worker shall call the work function of the work item, then the completion callback if there is one with the value returned by the work function, and free the work item. ]*/
+/* Tests_SRS_THREADPOOL_01_015: [ threadpool_destroy shall wait with ThreadAPI_Join for all workers to exit, which they do after running all the work still scheduled. ]*/
+TEST_FUNCTION(threadpool_destroy_runs_the_work_scheduled_on_all_workers)
+{
+    // arrange
+    THREADPOOL_HANDLE threadpool = create_threadpool(3);
+    size_t i;
+    for (i = 0; i < 5; i++)
+    {
+        ASSERT_ARE_EQUAL(int, 0, threadpool_schedule_work(threadpool, count_work, NULL, on_work_complete, (void*)0x1234));
+    }
+
+    // act
+    threadpool_destroy(threadpool);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 5, g_work_count);
+    ASSERT_ARE_EQUAL(size_t, 5, g_complete_count);
+    ASSERT_ARE_EQUAL(int, 42, g_last_work_result);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x1234, g_last_complete_context);
+}
+
+/* Tests_SRS_THREADPOOL_01_010: [ A worker shall call the work function of the work item, then the completion callback if there is one with the value returned by the work function, and free the work item. ]*/
+TEST_FUNCTION(work_without_completion_callback_runs)
+{
+    // arrange
+    THREADPOOL_HANDLE threadpool = create_threadpool(1);
+    ASSERT_ARE_EQUAL(int, 0, threadpool_schedule_work(threadpool, count_work, NULL, NULL, NULL));
+
+    // act
+    threadpool_destroy(threadpool);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_work_count);
+    ASSERT_ARE_EQUAL(size_t, 0, g_complete_count);
+}
+
+/* Tests_SRS_THREADPOOL_01_015: [ threadpool_destroy shall wait with ThreadAPI_Join for all workers to exit, which they do after running all the work still scheduled. ]*/
+/* Tests_SRS_THREADPOOL_01_018: [ If the pool is being destroyed and threadpool_schedule_work is not called by one of its workers, threadpool_schedule_work shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(work_scheduled_by_a_work_item_during_threadpool_destroy_runs)
+{
+    // arrange
+    THREADPOOL_HANDLE threadpool = create_threadpool(2);
+    g_scheduling_threadpool = threadpool;
+    ASSERT_ARE_EQUAL(int, 0, threadpool_schedule_work(threadpool, schedule_more_work, NULL, on_work_complete, NULL));
+
+    // act
+    threadpool_destroy(threadpool);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, g_work_count);
+    ASSERT_ARE_EQUAL(size_t, 1, g_complete_count);
+    ASSERT_ARE_EQUAL(int, 0, g_last_work_result);
+}
+
+/* threadpool_schedule_work */
+
+/* Tests_SRS_THREADPOOL_01_017: [ If threadpool or work_function is NULL, threadpool_schedule_work shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(threadpool_schedule_work_with_NULL_threadpool_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = threadpool_schedule_work(NULL, count_work, NULL, on_work_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_THREADPOOL_01_017: [ If threadpool or work_function is NULL, threadpool_schedule_work shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(threadpool_schedule_work_with_NULL_work_function_fails)
+{
+    // arrange
+    THREADPOOL_HANDLE threadpool = create_threadpool(1);
+    int result;
+
+    // act
+    result = threadpool_schedule_work(threadpool, NULL, NULL, on_work_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    threadpool_destroy(threadpool);
+}
+
+/* Tests_SRS_THREADPOOL_01_018: [ If the pool is being destroyed and threadpool_schedule_work is not called by one of its workers, threadpool_schedule_work shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(threadpool_schedule_work_from_another_thread_during_threadpool_destroy_fails)
+{
+    // arrange
+    THREADPOOL_HANDLE threadpool = create_threadpool(1);
+    g_joined_threadpool = threadpool;
+
+    // act
+    threadpool_destroy(threadpool);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, g_schedule_while_joining_result);
+    ASSERT_ARE_EQUAL(size_t, 0, g_work_count);
+}
+
+/* Tests_SRS_THREADPOOL_01_020: [ If allocating the work item fails, threadpool_schedule_work shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_the_work_item_fails_threadpool_schedule_work_fails)
+{
+    // arrange
+    THREADPOOL_HANDLE threadpool = create_threadpool(1);
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = threadpool_schedule_work(threadpool, count_work, NULL, on_work_complete, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    threadpool_destroy(threadpool);
+    ASSERT_ARE_EQUAL(size_t, 0, g_work_count);
+}
+
+/* Tests_SRS_THREADPOOL_01_019: [ threadpool_schedule_work shall allocate a work item holding work_function, work_context, on_work_complete and on_work_complete_context. ]*/
+/* Tests_SRS_THREADPOOL_01_021: [ When called by a worker of threadpool, threadpool_schedule_work shall add the work item at the tail of the deque of that worker, otherwise at the tail of the deque of the next worker in turn. ]*/
+/* Tests_SRS_THREADPOOL_01_023: [ threadpool_schedule_work shall succeed and return 0. ]*/
+TEST_FUNCTION(threadpool_schedule_work_spreads_work_over_the_workers_without_taking_the_lock)
+{
+    // arrange
+    THREADPOOL_HANDLE threadpool = create_threadpool(2);
+    int result_1;
+    int result_2;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(SpinLock_Lock(TEST_SPINLOCK(1)));
+    STRICT_EXPECTED_CALL(SpinLock_Unlock(TEST_SPINLOCK(1)));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(SpinLock_Lock(TEST_SPINLOCK(0)));
+    STRICT_EXPECTED_CALL(SpinLock_Unlock(TEST_SPINLOCK(0)));
+
+    // act
+    result_1 = threadpool_schedule_work(threadpool, count_work, NULL, on_work_complete, NULL);
+    result_2 = threadpool_schedule_work(threadpool, count_work, NULL, on_work_complete, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result_1);
+    ASSERT_ARE_EQUAL(int, 0, result_2);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    threadpool_destroy(threadpool);
+    ASSERT_ARE_EQUAL(size_t, 2, g_work_count);
+}
+
+/* Tests_SRS_THREADPOOL_01_011: [ When there is no work, a worker shall wait on the condition of the pool. ]*/
+/* Tests_SRS_THREADPOOL_01_022: [ If a worker is waiting, threadpool_schedule_work shall post the condition of the pool while holding its lock. ]*/
+TEST_FUNCTION(threadpool_schedule_work_wakes_a_waiting_worker)
+{
+    // arrange
+    THREADPOOL_HANDLE threadpool = create_threadpool(1);
+    int worker_result;
+    g_waited_threadpool = threadpool;
+    g_condition_wait_ok_count = 1;
+
+    /* the worker finds nothing and waits */
+    STRICT_EXPECTED_CALL(SpinLock_Lock(TEST_SPINLOCK(0)));
+    STRICT_EXPECTED_CALL(SpinLock_Unlock(TEST_SPINLOCK(0)));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, TEST_LOCK_HANDLE, 0));
+    /* work is scheduled while it waits */
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(SpinLock_Lock(TEST_SPINLOCK(0)));
+    STRICT_EXPECTED_CALL(SpinLock_Unlock(TEST_SPINLOCK(0)));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Post(TEST_COND_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    /* the worker runs it */
+    STRICT_EXPECTED_CALL(SpinLock_Lock(TEST_SPINLOCK(0)));
+    STRICT_EXPECTED_CALL(SpinLock_Unlock(TEST_SPINLOCK(0)));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    /* and waits again, this time Condition_Wait fails and the worker stops */
+    STRICT_EXPECTED_CALL(SpinLock_Lock(TEST_SPINLOCK(0)));
+    STRICT_EXPECTED_CALL(SpinLock_Unlock(TEST_SPINLOCK(0)));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Condition_Wait(TEST_COND_HANDLE, TEST_LOCK_HANDLE, 0));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    worker_result = test_threads[0].func(test_threads[0].arg);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, worker_result);
+    ASSERT_ARE_EQUAL(size_t, 1, g_work_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    threadpool_destroy(threadpool);
+}
+
+/* threadpool_get_worker_count */
+
+/* Tests_SRS_THREADPOOL_01_024: [ If threadpool is NULL, threadpool_get_worker_count shall return 0. ]*/
+TEST_FUNCTION(threadpool_get_worker_count_with_NULL_returns_0)
+{
+    // arrange
+    size_t result;
+
+    // act
+    result = threadpool_get_worker_count(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+}
+
+END_TEST_SUITE(threadpool_unittests)
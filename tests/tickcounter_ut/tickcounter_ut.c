@@ -188,6 +188,95 @@ TEST_FUNCTION(tickcounter_get_current_ms_succeed)
     tickcounter_destroy(tickHandle);
 }
 
+TEST_FUNCTION(tickcounter_get_current_us_tick_counter_NULL_fail)
+{
+    ///arrange
+    tickcounter_us_t current_us = 0;
+
+    ///act
+    int result = tickcounter_get_current_us(NULL, &current_us);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+TEST_FUNCTION(tickcounter_get_current_us_current_us_NULL_fail)
+{
+    ///arrange
+    int result;
+    TICK_COUNTER_HANDLE tickHandle = tickcounter_create();
+    umock_c_reset_all_calls();
+
+    ///act
+    result = tickcounter_get_current_us(tickHandle, NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    tickcounter_destroy(tickHandle);
+}
+
+TEST_FUNCTION(tickcounter_get_current_us_succeed)
+{
+    ///arrange
+    int result;
+    int resultAlso;
+    tickcounter_us_t first_us = 0;
+    tickcounter_us_t next_us = 0;
+    tickcounter_ms_t current_ms = 0;
+    TICK_COUNTER_HANDLE tickHandle = tickcounter_create();
+    umock_c_reset_all_calls();
+
+    ///act
+    result = tickcounter_get_current_us(tickHandle, &first_us);
+    ThreadAPI_Sleep(20);
+    resultAlso = tickcounter_get_current_us(tickHandle, &next_us);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, resultAlso);
+    ASSERT_IS_TRUE(next_us >= first_us + 10000);
+    ASSERT_ARE_EQUAL(int, 0, tickcounter_get_current_ms(tickHandle, &current_ms));
+    ASSERT_IS_TRUE((tickcounter_us_t)current_ms >= next_us / 1000);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    /// clean
+    tickcounter_destroy(tickHandle);
+}
+
+TEST_FUNCTION(tickcounter_get_monotonic_us_NULL_fail)
+{
+    ///arrange
+
+    ///act
+    int result = tickcounter_get_monotonic_us(NULL);
+
+    ///assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+TEST_FUNCTION(tickcounter_get_monotonic_us_succeed_without_allocating)
+{
+    ///arrange
+    int result;
+    int resultAlso;
+    tickcounter_us_t first_us = 0;
+    tickcounter_us_t next_us = 0;
+
+    ///act
+    result = tickcounter_get_monotonic_us(&first_us);
+    ThreadAPI_Sleep(20);
+    resultAlso = tickcounter_get_monotonic_us(&next_us);
+
+    ///assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, resultAlso);
+    ASSERT_IS_TRUE(next_us >= first_us + 10000);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 //TEST_FUNCTION(tickcounter_get_current_ms_validate_tick_succeed)
 //{
 //    ///arrange
@@ -0,0 +1,772 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdbool.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#include "macro_utils.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_bool.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/timer_wheel.h"
+
+static const TICK_COUNTER_HANDLE TEST_TICK_COUNTER_HANDLE = (TICK_COUNTER_HANDLE)0x4242;
+
+static tickcounter_ms_t g_now;
+
+static int my_tickcounter_get_current_ms(TICK_COUNTER_HANDLE tick_counter, tickcounter_ms_t* current_ms)
+{
+    (void)tick_counter;
+    *current_ms = g_now;
+    return 0;
+}
+
+#define TEST_MAX_EXPIRED 16
+
+/* the contexts of the expired timers, in the order they expired */
+static void* g_expired[TEST_MAX_EXPIRED];
+static size_t g_expired_count;
+
+/* what the callback of the first timer to expire does */
+static TIMER_WHEEL_TIMER_HANDLE g_timer_to_restart;
+static TIMER_WHEEL_TIMER_HANDLE g_timer_to_cancel;
+static TIMER_WHEEL_TIMER_HANDLE g_timer_to_destroy;
+
+static void on_timer_expired(void* context)
+{
+    ASSERT_IS_TRUE(g_expired_count < TEST_MAX_EXPIRED);
+    g_expired[g_expired_count++] = context;
+
+    if (g_timer_to_restart != NULL)
+    {
+        TIMER_WHEEL_TIMER_HANDLE timer = g_timer_to_restart;
+        g_timer_to_restart = NULL;
+        ASSERT_ARE_EQUAL(int, 0, timer_wheel_start_timer(timer, 0));
+    }
+    if (g_timer_to_cancel != NULL)
+    {
+        timer_wheel_cancel_timer(g_timer_to_cancel);
+        g_timer_to_cancel = NULL;
+    }
+    if (g_timer_to_destroy != NULL)
+    {
+        timer_wheel_destroy_timer(g_timer_to_destroy);
+        g_timer_to_destroy = NULL;
+    }
+}
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+static TIMER_WHEEL_HANDLE create_timer_wheel(void)
+{
+    TIMER_WHEEL_HANDLE result = timer_wheel_create();
+    ASSERT_IS_NOT_NULL(result);
+    umock_c_reset_all_calls();
+    return result;
+}
+
+static TIMER_WHEEL_TIMER_HANDLE create_timer(TIMER_WHEEL_HANDLE timer_wheel, void* context)
+{
+    TIMER_WHEEL_TIMER_HANDLE result = timer_wheel_create_timer(timer_wheel, on_timer_expired, context);
+    ASSERT_IS_NOT_NULL(result);
+    umock_c_reset_all_calls();
+    return result;
+}
+
+/* checks that a timer started now expires exactly timeout_ms later */
+static void assert_timer_expires_after(tickcounter_ms_t timeout_ms)
+{
+    TIMER_WHEEL_HANDLE timer_wheel = create_timer_wheel();
+    TIMER_WHEEL_TIMER_HANDLE timer = create_timer(timer_wheel, (void*)0x1);
+    tickcounter_ms_t start = g_now;
+    ASSERT_ARE_EQUAL(int, 0, timer_wheel_start_timer(timer, timeout_ms));
+
+    g_now = start + timeout_ms - 1;
+    timer_wheel_dowork(timer_wheel);
+    ASSERT_ARE_EQUAL(size_t, 0, g_expired_count);
+    ASSERT_IS_TRUE(timer_wheel_is_timer_running(timer));
+
+    g_now = start + timeout_ms;
+    timer_wheel_dowork(timer_wheel);
+    ASSERT_ARE_EQUAL(size_t, 1, g_expired_count);
+    ASSERT_IS_FALSE(timer_wheel_is_timer_running(timer));
+
+    timer_wheel_destroy_timer(timer);
+    timer_wheel_destroy(timer_wheel);
+}
+
+BEGIN_TEST_SUITE(timer_wheel_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result, "umock_c_init");
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_charptr_register_types");
+
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_bool_register_types");
+
+    REGISTER_UMOCK_ALIAS_TYPE(TICK_COUNTER_HANDLE, void*);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_create, TEST_TICK_COUNTER_HANDLE);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_current_ms, my_tickcounter_get_current_ms);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    g_now = 1000;
+    g_expired_count = 0;
+    g_timer_to_restart = NULL;
+    g_timer_to_cancel = NULL;
+    g_timer_to_destroy = NULL;
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/* timer_wheel_create */
+
+/* Tests_SRS_TIMER_WHEEL_01_001: [ timer_wheel_create shall allocate memory for a new timer wheel and create its tick counter. ]*/
+/* Tests_SRS_TIMER_WHEEL_01_002: [ timer_wheel_create shall start the wheel at the current time of the tick counter, with no timer running. ]*/
+/* Tests_SRS_TIMER_WHEEL_01_003: [ timer_wheel_create shall succeed and return a non-NULL value. ]*/
+TEST_FUNCTION(timer_wheel_create_succeeds)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+
+    // act
+    result = timer_wheel_create();
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy(result);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_004: [ If any failure occurs, timer_wheel_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_memory_fails_timer_wheel_create_fails)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = timer_wheel_create();
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_004: [ If any failure occurs, timer_wheel_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_tickcounter_create_fails_timer_wheel_create_fails)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_create())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = timer_wheel_create();
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_004: [ If any failure occurs, timer_wheel_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_tickcounter_get_current_ms_fails_timer_wheel_create_fails)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_create());
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = timer_wheel_create();
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* timer_wheel_destroy */
+
+/* Tests_SRS_TIMER_WHEEL_01_005: [ If timer_wheel is NULL, timer_wheel_destroy shall return. ]*/
+TEST_FUNCTION(timer_wheel_destroy_with_NULL_returns)
+{
+    // arrange
+
+    // act
+    timer_wheel_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_006: [ timer_wheel_destroy shall destroy the tick counter and free the memory of the wheel. ]*/
+TEST_FUNCTION(timer_wheel_destroy_frees_the_tick_counter_and_the_memory)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = create_timer_wheel();
+    STRICT_EXPECTED_CALL(tickcounter_destroy(TEST_TICK_COUNTER_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(timer_wheel));
+
+    // act
+    timer_wheel_destroy(timer_wheel);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* timer_wheel_create_timer */
+
+/* Tests_SRS_TIMER_WHEEL_01_007: [ If timer_wheel or on_timer_expired is NULL, timer_wheel_create_timer shall fail and return NULL. ]*/
+TEST_FUNCTION(timer_wheel_create_timer_with_NULL_timer_wheel_fails)
+{
+    // arrange
+    TIMER_WHEEL_TIMER_HANDLE result;
+
+    // act
+    result = timer_wheel_create_timer(NULL, on_timer_expired, NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_007: [ If timer_wheel or on_timer_expired is NULL, timer_wheel_create_timer shall fail and return NULL. ]*/
+TEST_FUNCTION(timer_wheel_create_timer_with_NULL_on_timer_expired_fails)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = create_timer_wheel();
+    TIMER_WHEEL_TIMER_HANDLE result;
+
+    // act
+    result = timer_wheel_create_timer(timer_wheel, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_008: [ timer_wheel_create_timer shall allocate memory for a timer that is not running and return it. ]*/
+TEST_FUNCTION(timer_wheel_create_timer_creates_a_timer_that_is_not_running)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = create_timer_wheel();
+    TIMER_WHEEL_TIMER_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = timer_wheel_create_timer(timer_wheel, on_timer_expired, NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(timer_wheel_is_timer_running(result));
+
+    // cleanup
+    timer_wheel_destroy_timer(result);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_009: [ If allocating memory fails, timer_wheel_create_timer shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_memory_fails_timer_wheel_create_timer_fails)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = create_timer_wheel();
+    TIMER_WHEEL_TIMER_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = timer_wheel_create_timer(timer_wheel, on_timer_expired, NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* timer_wheel_destroy_timer */
+
+/* Tests_SRS_TIMER_WHEEL_01_010: [ If timer is NULL, timer_wheel_destroy_timer shall return. ]*/
+TEST_FUNCTION(timer_wheel_destroy_timer_with_NULL_returns)
+{
+    // arrange
+
+    // act
+    timer_wheel_destroy_timer(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_011: [ timer_wheel_destroy_timer shall cancel the timer if it is running and free it. ]*/
+TEST_FUNCTION(timer_wheel_destroy_timer_cancels_a_running_timer)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = create_timer_wheel();
+    TIMER_WHEEL_TIMER_HANDLE timer = create_timer(timer_wheel, (void*)0x1);
+    ASSERT_ARE_EQUAL(int, 0, timer_wheel_start_timer(timer, 10));
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(gballoc_free(timer));
+
+    // act
+    timer_wheel_destroy_timer(timer);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    g_now += 10;
+    timer_wheel_dowork(timer_wheel);
+    ASSERT_ARE_EQUAL(size_t, 0, g_expired_count);
+
+    // cleanup
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* timer_wheel_start_timer */
+
+/* Tests_SRS_TIMER_WHEEL_01_012: [ If timer is NULL, timer_wheel_start_timer shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(timer_wheel_start_timer_with_NULL_timer_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = timer_wheel_start_timer(NULL, 10);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_013: [ If timeout_ms is more than half the range of tickcounter_ms_t, timer_wheel_start_timer shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(timer_wheel_start_timer_with_a_timeout_over_half_the_range_fails)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = create_timer_wheel();
+    TIMER_WHEEL_TIMER_HANDLE timer = create_timer(timer_wheel, (void*)0x1);
+    int result;
+
+    // act
+    result = timer_wheel_start_timer(timer, (((tickcounter_ms_t)~(tickcounter_ms_t)0) >> 1) + 1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(timer_wheel_is_timer_running(timer));
+
+    // cleanup
+    timer_wheel_destroy_timer(timer);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_014: [ If tickcounter_get_current_ms fails, timer_wheel_start_timer shall fail and return a non-zero value, leaving the timer as it was. ]*/
+TEST_FUNCTION(when_tickcounter_get_current_ms_fails_timer_wheel_start_timer_fails)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = create_timer_wheel();
+    TIMER_WHEEL_TIMER_HANDLE timer = create_timer(timer_wheel, (void*)0x1);
+    int result;
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    result = timer_wheel_start_timer(timer, 10);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(timer_wheel_is_timer_running(timer));
+
+    // cleanup
+    timer_wheel_destroy_timer(timer);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_016: [ timer_wheel_start_timer shall place the timer in the wheel so that it expires timeout_ms after the current time of the tick counter. ]*/
+/* Tests_SRS_TIMER_WHEEL_01_017: [ timer_wheel_start_timer shall succeed and return 0. ]*/
+/* Tests_SRS_TIMER_WHEEL_01_021: [ timer_wheel_is_timer_running shall return whether the timer was started and neither expired nor was cancelled since. ]*/
+TEST_FUNCTION(timer_wheel_start_timer_succeeds)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = create_timer_wheel();
+    TIMER_WHEEL_TIMER_HANDLE timer = create_timer(timer_wheel, (void*)0x1);
+    int result;
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+
+    // act
+    result = timer_wheel_start_timer(timer, 10);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE(timer_wheel_is_timer_running(timer));
+
+    // cleanup
+    timer_wheel_destroy_timer(timer);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_016: [ timer_wheel_start_timer shall place the timer in the wheel so that it expires timeout_ms after the current time of the tick counter. ]*/
+/* Tests_SRS_TIMER_WHEEL_01_026: [ For each timer whose deadline is in a processed millisecond, timer_wheel_dowork shall mark the timer as not running and call its on_timer_expired with its context. ]*/
+TEST_FUNCTION(a_timer_in_the_first_level_expires_on_time)
+{
+    assert_timer_expires_after(200);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_016: [ timer_wheel_start_timer shall place the timer in the wheel so that it expires timeout_ms after the current time of the tick counter. ]*/
+TEST_FUNCTION(a_timer_in_the_second_level_expires_on_time)
+{
+    assert_timer_expires_after(5000);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_016: [ timer_wheel_start_timer shall place the timer in the wheel so that it expires timeout_ms after the current time of the tick counter. ]*/
+TEST_FUNCTION(a_timer_in_the_third_level_expires_on_time)
+{
+    assert_timer_expires_after(300000);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_016: [ timer_wheel_start_timer shall place the timer in the wheel so that it expires timeout_ms after the current time of the tick counter. ]*/
+TEST_FUNCTION(a_timer_in_the_last_level_expires_on_time)
+{
+    assert_timer_expires_after(20000000);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_016: [ timer_wheel_start_timer shall place the timer in the wheel so that it expires timeout_ms after the current time of the tick counter. ]*/
+TEST_FUNCTION(a_timer_beyond_the_wheel_expires_on_time)
+{
+    assert_timer_expires_after(100000000);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_016: [ timer_wheel_start_timer shall place the timer in the wheel so that it expires timeout_ms after the current time of the tick counter. ]*/
+TEST_FUNCTION(a_timer_expires_on_time_across_the_tick_counter_wrapping_around)
+{
+    g_now = (tickcounter_ms_t)0 - 300;
+    assert_timer_expires_after(1000);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_015: [ If the timer is running, timer_wheel_start_timer shall cancel it first. ]*/
+TEST_FUNCTION(timer_wheel_start_timer_on_a_running_timer_moves_its_deadline)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = create_timer_wheel();
+    TIMER_WHEEL_TIMER_HANDLE timer = create_timer(timer_wheel, (void*)0x1);
+    ASSERT_ARE_EQUAL(int, 0, timer_wheel_start_timer(timer, 10));
+
+    // act
+    ASSERT_ARE_EQUAL(int, 0, timer_wheel_start_timer(timer, 1000));
+
+    // assert
+    g_now += 999;
+    timer_wheel_dowork(timer_wheel);
+    ASSERT_ARE_EQUAL(size_t, 0, g_expired_count);
+    g_now += 1;
+    timer_wheel_dowork(timer_wheel);
+    ASSERT_ARE_EQUAL(size_t, 1, g_expired_count);
+
+    // cleanup
+    timer_wheel_destroy_timer(timer);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* timer_wheel_cancel_timer */
+
+/* Tests_SRS_TIMER_WHEEL_01_018: [ If timer is NULL, timer_wheel_cancel_timer shall return. ]*/
+TEST_FUNCTION(timer_wheel_cancel_timer_with_NULL_returns)
+{
+    // arrange
+
+    // act
+    timer_wheel_cancel_timer(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_019: [ If the timer is running, timer_wheel_cancel_timer shall remove it from the wheel without calling its callback. ]*/
+TEST_FUNCTION(a_cancelled_timer_does_not_expire)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = create_timer_wheel();
+    TIMER_WHEEL_TIMER_HANDLE timer = create_timer(timer_wheel, (void*)0x1);
+    ASSERT_ARE_EQUAL(int, 0, timer_wheel_start_timer(timer, 10));
+    umock_c_reset_all_calls();
+
+    // act
+    timer_wheel_cancel_timer(timer);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_FALSE(timer_wheel_is_timer_running(timer));
+    g_now += 10;
+    timer_wheel_dowork(timer_wheel);
+    ASSERT_ARE_EQUAL(size_t, 0, g_expired_count);
+
+    // cleanup
+    timer_wheel_destroy_timer(timer);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* timer_wheel_is_timer_running */
+
+/* Tests_SRS_TIMER_WHEEL_01_020: [ If timer is NULL, timer_wheel_is_timer_running shall return false. ]*/
+TEST_FUNCTION(timer_wheel_is_timer_running_with_NULL_returns_false)
+{
+    // arrange
+    bool result;
+
+    // act
+    result = timer_wheel_is_timer_running(NULL);
+
+    // assert
+    ASSERT_IS_FALSE(result);
+}
+
+/* timer_wheel_dowork */
+
+/* Tests_SRS_TIMER_WHEEL_01_022: [ If timer_wheel is NULL, timer_wheel_dowork shall return. ]*/
+TEST_FUNCTION(timer_wheel_dowork_with_NULL_returns)
+{
+    // arrange
+
+    // act
+    timer_wheel_dowork(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_023: [ If tickcounter_get_current_ms fails, timer_wheel_dowork shall return without expiring any timer. ]*/
+TEST_FUNCTION(when_tickcounter_get_current_ms_fails_timer_wheel_dowork_expires_nothing)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = create_timer_wheel();
+    TIMER_WHEEL_TIMER_HANDLE timer = create_timer(timer_wheel, (void*)0x1);
+    ASSERT_ARE_EQUAL(int, 0, timer_wheel_start_timer(timer, 10));
+    g_now += 10;
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    timer_wheel_dowork(timer_wheel);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, g_expired_count);
+    ASSERT_IS_TRUE(timer_wheel_is_timer_running(timer));
+
+    // cleanup
+    timer_wheel_destroy_timer(timer);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_024: [ timer_wheel_dowork shall process each millisecond from the last one it processed up to the current time of the tick counter. ]*/
+TEST_FUNCTION(timers_expire_in_deadline_order_when_dowork_is_late)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = create_timer_wheel();
+    TIMER_WHEEL_TIMER_HANDLE late = create_timer(timer_wheel, (void*)0x2);
+    TIMER_WHEEL_TIMER_HANDLE early = create_timer(timer_wheel, (void*)0x1);
+    TIMER_WHEEL_TIMER_HANDLE not_due = create_timer(timer_wheel, (void*)0x3);
+    ASSERT_ARE_EQUAL(int, 0, timer_wheel_start_timer(late, 3000));
+    ASSERT_ARE_EQUAL(int, 0, timer_wheel_start_timer(early, 20));
+    ASSERT_ARE_EQUAL(int, 0, timer_wheel_start_timer(not_due, 6000));
+    g_now += 5000;
+
+    // act
+    timer_wheel_dowork(timer_wheel);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, g_expired_count);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x1, g_expired[0]);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x2, g_expired[1]);
+    ASSERT_IS_TRUE(timer_wheel_is_timer_running(not_due));
+
+    // cleanup
+    timer_wheel_destroy_timer(not_due);
+    timer_wheel_destroy_timer(early);
+    timer_wheel_destroy_timer(late);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_025: [ When no timer is running, timer_wheel_dowork shall skip to the current time at once. ]*/
+TEST_FUNCTION(a_timer_started_after_an_idle_period_expires_on_time)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = create_timer_wheel();
+    TIMER_WHEEL_TIMER_HANDLE timer = create_timer(timer_wheel, (void*)0x1);
+    g_now += 1000000;
+    timer_wheel_dowork(timer_wheel);
+    ASSERT_ARE_EQUAL(int, 0, timer_wheel_start_timer(timer, 300));
+
+    // act
+    g_now += 299;
+    timer_wheel_dowork(timer_wheel);
+    ASSERT_ARE_EQUAL(size_t, 0, g_expired_count);
+    g_now += 1;
+    timer_wheel_dowork(timer_wheel);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_expired_count);
+
+    // cleanup
+    timer_wheel_destroy_timer(timer);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_026: [ For each timer whose deadline is in a processed millisecond, timer_wheel_dowork shall mark the timer as not running and call its on_timer_expired with its context. ]*/
+TEST_FUNCTION(a_timer_restarted_with_0_from_its_callback_expires_with_the_next_millisecond)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = create_timer_wheel();
+    TIMER_WHEEL_TIMER_HANDLE timer = create_timer(timer_wheel, (void*)0x1);
+    ASSERT_ARE_EQUAL(int, 0, timer_wheel_start_timer(timer, 10));
+    g_timer_to_restart = timer;
+    g_now += 10;
+
+    // act
+    timer_wheel_dowork(timer_wheel);
+    ASSERT_ARE_EQUAL(size_t, 1, g_expired_count);
+    ASSERT_IS_TRUE(timer_wheel_is_timer_running(timer));
+    timer_wheel_dowork(timer_wheel);
+    ASSERT_ARE_EQUAL(size_t, 1, g_expired_count);
+    g_now += 1;
+    timer_wheel_dowork(timer_wheel);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, g_expired_count);
+    ASSERT_IS_FALSE(timer_wheel_is_timer_running(timer));
+
+    // cleanup
+    timer_wheel_destroy_timer(timer);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_026: [ For each timer whose deadline is in a processed millisecond, timer_wheel_dowork shall mark the timer as not running and call its on_timer_expired with its context. ]*/
+TEST_FUNCTION(a_timer_due_at_the_same_time_cancelled_by_a_callback_does_not_expire)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = create_timer_wheel();
+    TIMER_WHEEL_TIMER_HANDLE first = create_timer(timer_wheel, (void*)0x1);
+    TIMER_WHEEL_TIMER_HANDLE second = create_timer(timer_wheel, (void*)0x2);
+    ASSERT_ARE_EQUAL(int, 0, timer_wheel_start_timer(first, 10));
+    ASSERT_ARE_EQUAL(int, 0, timer_wheel_start_timer(second, 10));
+    g_timer_to_cancel = second;
+    g_now += 10;
+
+    // act
+    timer_wheel_dowork(timer_wheel);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_expired_count);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x1, g_expired[0]);
+    ASSERT_IS_FALSE(timer_wheel_is_timer_running(second));
+
+    // cleanup
+    timer_wheel_destroy_timer(second);
+    timer_wheel_destroy_timer(first);
+    timer_wheel_destroy(timer_wheel);
+}
+
+/* Tests_SRS_TIMER_WHEEL_01_026: [ For each timer whose deadline is in a processed millisecond, timer_wheel_dowork shall mark the timer as not running and call its on_timer_expired with its context. ]*/
+TEST_FUNCTION(a_timer_can_be_destroyed_from_its_callback)
+{
+    // arrange
+    TIMER_WHEEL_HANDLE timer_wheel = create_timer_wheel();
+    TIMER_WHEEL_TIMER_HANDLE timer = create_timer(timer_wheel, (void*)0x1);
+    ASSERT_ARE_EQUAL(int, 0, timer_wheel_start_timer(timer, 10));
+    g_timer_to_destroy = timer;
+    g_now += 10;
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(tickcounter_get_current_ms(TEST_TICK_COUNTER_HANDLE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(timer));
+
+    // act
+    timer_wheel_dowork(timer_wheel);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, g_expired_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    timer_wheel_destroy(timer_wheel);
+}
+
+END_TEST_SUITE(timer_wheel_unittests)
@@ -34,11 +34,14 @@ static TEST_MUTEX_HANDLE g_testByTest;
 const char* fake_trusted_cert = "Fake trusted cert";
 const char* fake_x509_cert = "Fake x509 cert";
 const char* fake_x509_key = "Fake x509 key";
+const char* fake_groups = "X25519:P-256:secp384r1";
+const char* fake_signature_algorithms = "ecdsa_secp256r1_sha256:rsa_pss_rsae_sha256:ed25519";
 
 #define SET_PV_COUNT 3
 #define RETRIEVE_PV_COUNT 4
 #define SET_INCONSISTENT_x509_COUNT 8
 #define SET_NOT_SUPPORTED_COUNT 5
+#define SET_BAD_LIST_COUNT 6
 
 void ASSERT_COPIED_STRING(const char* target, const char* source)
 {
@@ -138,6 +141,10 @@ TEST_FUNCTION(tlsio_options_initialize__succeeds)
     ASSERT_IS_NULL(options.trusted_certs);
     ASSERT_IS_NULL(options.x509_cert);
     ASSERT_IS_NULL(options.x509_key);
+    ASSERT_IS_NULL(options.groups);
+    ASSERT_ARE_EQUAL(size_t, 0, options.group_count);
+    ASSERT_IS_NULL(options.signature_algorithms);
+    ASSERT_ARE_EQUAL(size_t, 0, options.signature_algorithm_count);
     ASSERT_ARE_EQUAL(int, options.supported_options, (int)(TLSIO_OPTION_BIT_TRUSTED_CERTS | TLSIO_OPTION_BIT_x509_RSA_CERT | TLSIO_OPTION_BIT_x509_ECC_CERT));
     ASSERT_ARE_EQUAL(int, (int)options.x509_type, (int)TLSIO_OPTIONS_x509_TYPE_UNSPECIFIED);
 
@@ -259,6 +266,117 @@ TEST_FUNCTION(tlsio_options__set_x509_ECC_key__succeeds)
     assert_gballoc_checks();
 }
 
+TEST_FUNCTION(tlsio_options__set_groups__succeeds)
+{
+    ///arrange
+    TLSIO_OPTIONS_RESULT result;
+    TLSIO_OPTIONS options;
+    tlsio_options_initialize(&options, TLSIO_OPTION_BIT_GROUPS);
+
+    ///act
+    result = tlsio_options_set(&options, OPTION_TLS_GROUPS, fake_groups);
+
+    ///assert
+    ASSERT_COPIED_STRING(options.groups, fake_groups);
+    ASSERT_ARE_EQUAL(size_t, 3, options.group_count);
+    ASSERT_ARE_EQUAL(int, TLSIO_GROUP_X25519, (int)options.group_ids[0]);
+    ASSERT_ARE_EQUAL(int, TLSIO_GROUP_SECP256R1, (int)options.group_ids[1]);
+    ASSERT_ARE_EQUAL(int, TLSIO_GROUP_SECP384R1, (int)options.group_ids[2]);
+    ASSERT_IS_NULL(options.signature_algorithms);
+    ASSERT_ARE_EQUAL(int, (int)result, 0);
+
+    ///clean
+    tlsio_options_release_resources(&options);
+    assert_gballoc_checks();
+}
+
+TEST_FUNCTION(tlsio_options__set_groups_twice__replaces_the_list)
+{
+    ///arrange
+    TLSIO_OPTIONS_RESULT result;
+    TLSIO_OPTIONS options;
+    tlsio_options_initialize(&options, TLSIO_OPTION_BIT_GROUPS);
+    result = tlsio_options_set(&options, OPTION_TLS_GROUPS, fake_groups);
+    ASSERT_ARE_EQUAL(int, (int)result, (int)TLSIO_OPTIONS_RESULT_SUCCESS);
+
+    ///act
+    result = tlsio_options_set(&options, OPTION_TLS_GROUPS, "P-521");
+
+    ///assert
+    ASSERT_ARE_EQUAL(char_ptr, "P-521", options.groups);
+    ASSERT_ARE_EQUAL(size_t, 1, options.group_count);
+    ASSERT_ARE_EQUAL(int, TLSIO_GROUP_SECP521R1, (int)options.group_ids[0]);
+    ASSERT_ARE_EQUAL(int, (int)result, 0);
+
+    ///clean
+    tlsio_options_release_resources(&options);
+    assert_gballoc_checks();
+}
+
+TEST_FUNCTION(tlsio_options__set_signature_algorithms__succeeds)
+{
+    ///arrange
+    TLSIO_OPTIONS_RESULT result;
+    TLSIO_OPTIONS options;
+    tlsio_options_initialize(&options, TLSIO_OPTION_BIT_SIGNATURE_ALGORITHMS);
+
+    ///act
+    result = tlsio_options_set(&options, OPTION_TLS_SIGNATURE_ALGORITHMS, fake_signature_algorithms);
+
+    ///assert
+    ASSERT_COPIED_STRING(options.signature_algorithms, fake_signature_algorithms);
+    ASSERT_ARE_EQUAL(size_t, 3, options.signature_algorithm_count);
+    ASSERT_ARE_EQUAL(int, TLSIO_SIGNATURE_ALGORITHM_ECDSA_SECP256R1_SHA256, (int)options.signature_algorithm_ids[0]);
+    ASSERT_ARE_EQUAL(int, TLSIO_SIGNATURE_ALGORITHM_RSA_PSS_RSAE_SHA256, (int)options.signature_algorithm_ids[1]);
+    ASSERT_ARE_EQUAL(int, TLSIO_SIGNATURE_ALGORITHM_ED25519, (int)options.signature_algorithm_ids[2]);
+    ASSERT_IS_NULL(options.groups);
+    ASSERT_ARE_EQUAL(int, (int)result, 0);
+
+    ///clean
+    tlsio_options_release_resources(&options);
+    assert_gballoc_checks();
+}
+
+TEST_FUNCTION(tlsio_options__set_bad_lists__fails)
+{
+    int i;
+    int k = 0;
+    const char* p0[SET_BAD_LIST_COUNT];
+    const char* p1[SET_BAD_LIST_COUNT];
+
+    TLSIO_OPTIONS options;
+    TLSIO_OPTIONS_RESULT result;
+
+    p0[k] = OPTION_TLS_GROUPS; /*            */ p1[k] = ""; k++;
+    p0[k] = OPTION_TLS_GROUPS; /*            */ p1[k] = "X25519:"; k++;
+    p0[k] = OPTION_TLS_GROUPS; /*            */ p1[k] = "X25519:P-255"; k++;
+    p0[k] = OPTION_TLS_GROUPS; /*            */ p1[k] = "X25519:X25519:X25519:X25519:X25519:X25519:X25519:X25519:X25519:X25519:X25519:X25519:X25519:X25519:X25519:X25519:X25519"; k++;
+    p0[k] = OPTION_TLS_SIGNATURE_ALGORITHMS; p1[k] = "ECDSA+SHA256"; k++;
+    p0[k] = OPTION_TLS_SIGNATURE_ALGORITHMS; p1[k] = "ed25519:"; k++;
+
+    // Cycle through each bad list
+    for (i = 0; i < SET_BAD_LIST_COUNT; i++)
+    {
+        ///arrange
+        tlsio_options_initialize(&options, TLSIO_OPTION_BIT_GROUPS | TLSIO_OPTION_BIT_SIGNATURE_ALGORITHMS);
+        result = tlsio_options_set(&options, OPTION_TLS_GROUPS, "P-256");
+        ASSERT_ARE_EQUAL(int, (int)result, (int)TLSIO_OPTIONS_RESULT_SUCCESS);
+
+        ///act
+        result = tlsio_options_set(&options, p0[i], p1[i]);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, (int)result, (int)TLSIO_OPTIONS_RESULT_ERROR, "Unexpected success with a bad list");
+        ASSERT_ARE_EQUAL(char_ptr, "P-256", options.groups, "The previous list was not kept");
+        ASSERT_ARE_EQUAL(size_t, 1, options.group_count);
+        ASSERT_IS_NULL(options.signature_algorithms);
+
+        ///clean
+        tlsio_options_release_resources(&options);
+        assert_gballoc_checks();
+    }
+}
+
 TEST_FUNCTION(tlsio_options__set_unhandled__succeeds)
 {
     ///arrange
@@ -806,6 +924,41 @@ TEST_FUNCTION(tlsio_options__retrieve_ex_OPTION_X509_ECC_KEY__succeeds)
     assert_gballoc_checks();
 }
 
+TEST_FUNCTION(tlsio_options__retrieve_ex_OPTION_TLS_GROUPS_and_OPTION_TLS_SIGNATURE_ALGORITHMS__succeeds)
+{
+    ///arrange
+    TLSIO_OPTIONS options;
+    TLSIO_OPTIONS_RESULT set_result;
+    OPTIONHANDLER_RESULT option_handler_result;
+    OPTIONHANDLER_HANDLE result = NULL;
+    tlsio_options_initialize(&options, TLSIO_OPTION_BIT_GROUPS | TLSIO_OPTION_BIT_SIGNATURE_ALGORITHMS);
+    set_result = tlsio_options_set(&options, OPTION_TLS_GROUPS, fake_groups);
+    ASSERT_ARE_EQUAL(int, (int)set_result, (int)TLSIO_OPTIONS_RESULT_SUCCESS);
+    set_result = tlsio_options_set(&options, OPTION_TLS_SIGNATURE_ALGORITHMS, fake_signature_algorithms);
+    ASSERT_ARE_EQUAL(int, (int)set_result, (int)TLSIO_OPTIONS_RESULT_SUCCESS);
+
+    ///act
+    result = tlsio_options_retrieve_options_ex(&options, pfCloneOption_impl, pfDestroyOption_impl, pfSetOption_impl);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(result);
+    tlsio_options_release_resources(&options);
+    tlsio_options_initialize(&options, TLSIO_OPTION_BIT_GROUPS | TLSIO_OPTION_BIT_SIGNATURE_ALGORITHMS);
+
+    option_handler_result = OptionHandler_FeedOptions(result, &options);
+    ASSERT_ARE_EQUAL(int, (int)option_handler_result, (int)OPTIONHANDLER_OK);
+
+    ASSERT_COPIED_STRING(options.groups, fake_groups);
+    ASSERT_ARE_EQUAL(size_t, 3, options.group_count);
+    ASSERT_COPIED_STRING(options.signature_algorithms, fake_signature_algorithms);
+    ASSERT_ARE_EQUAL(size_t, 3, options.signature_algorithm_count);
+
+    ///clean
+    tlsio_options_release_resources(&options);
+    OptionHandler_Destroy(result);
+    assert_gballoc_checks();
+}
+
 TEST_FUNCTION(tlsio_options__retrieve_ex_parameter_validation__fails)
 {
     int i;
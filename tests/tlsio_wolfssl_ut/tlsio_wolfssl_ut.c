@@ -6,6 +6,7 @@
 #else
 #include <stdlib.h>
 #include <stddef.h>
+#include <stdbool.h>
 #endif
 
 static void* my_gballoc_malloc(size_t size)
@@ -45,6 +46,7 @@ static void my_gballoc_free(void* ptr)
 #include "azure_c_shared_utility/shared_util_options.h"
 #include "azure_c_shared_utility/platform.h"
 #include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/lock.h"
 
 MOCKABLE_FUNCTION(, void, on_bytes_recv, void*, context, const unsigned char*, buffer, size_t, size);
 MOCKABLE_FUNCTION(, void, on_error, void*, context);
@@ -740,6 +742,27 @@ TEST_FUNCTION(tlsio_wolfssl_setoption_trusted_cert_twice_succeed)
 }
 
 #ifdef INVALID_DEVID
+TEST_FUNCTION(tlsio_wolfssl_setoption_session_cache_without_init_fail)
+{
+    //arrange
+    bool use_session_cache = true;
+    TLSIO_CONFIG tls_io_config;
+    memset(&tls_io_config, 0, sizeof(tls_io_config));
+    tls_io_config.hostname = "test.azure-devices.net";
+    CONCRETE_IO_HANDLE io_handle = tlsio_wolfssl_create(&tls_io_config);
+    umock_c_reset_all_calls();
+
+    //act
+    int test_result = tlsio_wolfssl_setoption(io_handle, OPTION_TLS_SESSION_CACHE, &use_session_cache);
+
+    //assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, test_result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    //clean
+    tlsio_wolfssl_destroy(io_handle);
+}
+
 TEST_FUNCTION(tlsio_wolfssl_setoption_device_id_succeed)
 {
     //arrange
@@ -85,4 +85,50 @@ TEST_FUNCTION(UniqueId_Generate_Succeed)
     ASSERT_ARE_EQUAL(size_t, 36, strlen(uid) );
 }
 
+/* UniqueId_GenerateBinary */
+/* Tests_SRS_UNIQUEID_07_006: [If uid is NULL then UniqueId_GenerateBinary shall return UNIQUEID_INVALID_ARG] */
+TEST_FUNCTION(UniqueId_GenerateBinary_UID_NULL_Fail)
+{
+    //Arrange
+
+    //Act
+    UNIQUEID_RESULT result = UniqueId_GenerateBinary(NULL, UNIQUEID_BINARY_SIZE);
+
+    //Assert
+    ASSERT_ARE_EQUAL(UNIQUEID_RESULT, UNIQUEID_INVALID_ARG, result);
+}
+
+/* Tests_SRS_UNIQUEID_07_007: [If len is less then 16 then UniqueId_GenerateBinary shall return UNIQUEID_INVALID_ARG] */
+TEST_FUNCTION(UniqueId_GenerateBinary_Len_too_small_Fail)
+{
+    //Arrange
+    unsigned char uid[UNIQUEID_BINARY_SIZE];
+
+    //Act
+    UNIQUEID_RESULT result = UniqueId_GenerateBinary(uid, UNIQUEID_BINARY_SIZE - 1);
+
+    //Assert
+    ASSERT_ARE_EQUAL(UNIQUEID_RESULT, UNIQUEID_INVALID_ARG, result);
+}
+
+/* Tests_SRS_UNIQUEID_07_005: [UniqueId_GenerateBinary shall write the 16 bytes of a random (version 4) UUID to uid, in the order they appear in the UUID string.] */
+TEST_FUNCTION(UniqueId_GenerateBinary_Succeed)
+{
+    //Arrange
+    unsigned char uid[UNIQUEID_BINARY_SIZE];
+    unsigned char uid2[UNIQUEID_BINARY_SIZE];
+    UNIQUEID_RESULT result2;
+
+    //Act
+    UNIQUEID_RESULT result = UniqueId_GenerateBinary(uid, sizeof(uid));
+    result2 = UniqueId_GenerateBinary(uid2, sizeof(uid2));
+
+    //Assert
+    ASSERT_ARE_EQUAL(UNIQUEID_RESULT, UNIQUEID_OK, result);
+    ASSERT_ARE_EQUAL(UNIQUEID_RESULT, UNIQUEID_OK, result2);
+    ASSERT_ARE_EQUAL(int, 0x40, uid[6] & 0xf0);
+    ASSERT_ARE_EQUAL(int, 0x80, uid[8] & 0xc0);
+    ASSERT_ARE_NOT_EQUAL(int, 0, memcmp(uid, uid2, sizeof(uid)));
+}
+
 END_TEST_SUITE(uniqueid_unittests)
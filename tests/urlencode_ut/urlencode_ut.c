@@ -851,6 +851,191 @@ TEST_FUNCTION(URL_Exhaustive_chars)
     }
 }
 
+/*Tests_SRS_URL_ENCODE_01_001: [ If no character of input needs escaping, URL_Encode shall return a copy of input without encoding it character by character. ]*/
+TEST_FUNCTION(URL_EncodeString_with_nothing_to_escape_returns_a_copy)
+{
+    // arrange
+
+    // act
+    STRING_HANDLE encodedURL = URL_EncodeString(UNRESERVED_CHAR);
+
+    //assert
+    ASSERT_IS_NOT_NULL(encodedURL);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, (void*)UNRESERVED_CHAR, (void*)STRING_c_str(encodedURL));
+    ASSERT_ARE_EQUAL(char_ptr, UNRESERVED_CHAR, STRING_c_str(encodedURL));
+    STRING_delete(encodedURL);
+}
+
+/* URL_Encoded_Length */
+
+/*Tests_SRS_URL_ENCODE_01_002: [ If text is NULL, URL_Encoded_Length shall return 0. ]*/
+TEST_FUNCTION(URL_Encoded_Length_with_NULL_text_returns_0)
+{
+    // arrange
+
+    // act
+    size_t result = URL_Encoded_Length(NULL);
+
+    //assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+}
+
+/*Tests_SRS_URL_ENCODE_01_003: [ Otherwise URL_Encoded_Length shall return the number of characters of the encoding of text, not counting the terminating '\0'. ]*/
+TEST_FUNCTION(URL_Encoded_Length_matches_the_length_of_the_encoding_for_all_chars)
+{
+    size_t i;
+    size_t numberOfTests = sizeof(testVector) / sizeof(testVector[i]);
+    for (i = 0; i < numberOfTests; i++)
+    {
+        // act
+        size_t result = URL_Encoded_Length(testVector[i].inputData);
+
+        //assert
+        ASSERT_ARE_EQUAL(size_t, strlen(testVector[i].expectedOutput), result);
+    }
+}
+
+/* URL_Encode_To */
+
+/*Tests_SRS_URL_ENCODE_01_004: [ If text or destination is NULL or destination_size is 0, URL_Encode_To shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(URL_Encode_To_with_NULL_text_fails)
+{
+    // arrange
+    char destination[16];
+
+    // act
+    int result = URL_Encode_To(NULL, destination, sizeof(destination));
+
+    //assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_URL_ENCODE_01_004: [ If text or destination is NULL or destination_size is 0, URL_Encode_To shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(URL_Encode_To_with_NULL_destination_fails)
+{
+    // arrange
+
+    // act
+    int result = URL_Encode_To("hello world", NULL, 16);
+
+    //assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_URL_ENCODE_01_004: [ If text or destination is NULL or destination_size is 0, URL_Encode_To shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(URL_Encode_To_with_0_destination_size_fails)
+{
+    // arrange
+    char destination[16];
+
+    // act
+    int result = URL_Encode_To("hello world", destination, 0);
+
+    //assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_URL_ENCODE_01_005: [ URL_Encode_To shall write the encoding of text followed by a '\0' to destination in a single pass over text and return 0. ]*/
+TEST_FUNCTION(URL_Encode_To_encodes_all_chars)
+{
+    size_t i;
+    size_t numberOfTests = sizeof(testVector) / sizeof(testVector[i]);
+    for (i = 0; i < numberOfTests; i++)
+    {
+        // arrange
+        char destination[8];
+
+        // act
+        int result = URL_Encode_To(testVector[i].inputData, destination, strlen(testVector[i].expectedOutput) + 1);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, testVector[i].expectedOutput, destination);
+    }
+}
+
+/*Tests_SRS_URL_ENCODE_01_005: [ URL_Encode_To shall write the encoding of text followed by a '\0' to destination in a single pass over text and return 0. ]*/
+TEST_FUNCTION(URL_Encode_To_encodes_a_path)
+{
+    // arrange
+    char destination[64];
+
+    // act
+    int result = URL_Encode_To("/getalarm('Le Pichet')", destination, sizeof(destination));
+
+    //assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, "%2fgetalarm(%27Le%20Pichet%27)", destination);
+}
+
+/*Tests_SRS_URL_ENCODE_01_006: [ If destination_size is smaller than the length of the encoding of text plus 1, URL_Encode_To shall fail, set destination to an empty string and return a non-zero value. ]*/
+TEST_FUNCTION(URL_Encode_To_with_a_destination_too_small_fails)
+{
+    // arrange
+    char destination[64];
+
+    // act
+    int result = URL_Encode_To("hello world", destination, sizeof("hello%20world") - 1);
+
+    //assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, "", destination);
+}
+
+/* URL_Encode_If_Needed */
+
+/*Tests_SRS_URL_ENCODE_01_007: [ If text is NULL, URL_Encode_If_Needed shall fail and return NULL. ]*/
+TEST_FUNCTION(URL_Encode_If_Needed_with_NULL_text_fails)
+{
+    // arrange
+    char destination[16];
+
+    // act
+    const char* result = URL_Encode_If_Needed(NULL, destination, sizeof(destination));
+
+    //assert
+    ASSERT_IS_NULL(result);
+}
+
+/*Tests_SRS_URL_ENCODE_01_008: [ If no character of text needs escaping, URL_Encode_If_Needed shall return text without copying it. ]*/
+TEST_FUNCTION(URL_Encode_If_Needed_with_nothing_to_escape_returns_text)
+{
+    // arrange
+
+    // act
+    const char* result = URL_Encode_If_Needed(UNRESERVED_CHAR, NULL, 0);
+
+    //assert
+    ASSERT_ARE_EQUAL(void_ptr, (void*)UNRESERVED_CHAR, (void*)result);
+}
+
+/*Tests_SRS_URL_ENCODE_01_009: [ Otherwise URL_Encode_If_Needed shall encode text into destination as URL_Encode_To does and return destination. ]*/
+TEST_FUNCTION(URL_Encode_If_Needed_encodes_into_destination)
+{
+    // arrange
+    char destination[16];
+
+    // act
+    const char* result = URL_Encode_If_Needed("hello world", destination, sizeof(destination));
+
+    //assert
+    ASSERT_ARE_EQUAL(void_ptr, (void*)destination, (void*)result);
+    ASSERT_ARE_EQUAL(char_ptr, "hello%20world", destination);
+}
+
+/*Tests_SRS_URL_ENCODE_01_010: [ If URL_Encode_To fails, URL_Encode_If_Needed shall return NULL. ]*/
+TEST_FUNCTION(URL_Encode_If_Needed_with_a_destination_too_small_fails)
+{
+    // arrange
+    char destination[4];
+
+    // act
+    const char* result = URL_Encode_If_Needed("hello world", destination, sizeof(destination));
+
+    //assert
+    ASSERT_IS_NULL(result);
+}
+
 /* Decode Tests */
 TEST_FUNCTION(URL_DecodeString_null_input)
 {
@@ -1292,4 +1477,164 @@ TEST_FUNCTION(URL_Decode_Extended_ASCII_chars)
     }
 }
 
+/* URL_DecodeInPlace */
+
+/*Tests_SRS_URL_ENCODE_01_011: [ If text or length is NULL, URL_DecodeInPlace shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(URL_DecodeInPlace_with_NULL_text_fails)
+{
+    // arrange
+    size_t length = 0;
+
+    // act
+    int result = URL_DecodeInPlace(NULL, &length);
+
+    //assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_URL_ENCODE_01_011: [ If text or length is NULL, URL_DecodeInPlace shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(URL_DecodeInPlace_with_NULL_length_fails)
+{
+    // arrange
+    char text[] = "hello%20world";
+
+    // act
+    int result = URL_DecodeInPlace(text, NULL);
+
+    //assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/*Tests_SRS_URL_ENCODE_01_012: [ If the first *length characters of text are not a valid encoding, URL_DecodeInPlace shall fail, leave text unchanged and return a non-zero value. ]*/
+TEST_FUNCTION(URL_DecodeInPlace_with_invalid_encoding_fails)
+{
+    // arrange
+    char text[] = "hello%20world%2";
+    size_t length = sizeof(text) - 1;
+
+    // act
+    int result = URL_DecodeInPlace(text, &length);
+
+    //assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, "hello%20world%2", text);
+    ASSERT_ARE_EQUAL(size_t, sizeof(text) - 1, length);
+}
+
+/*Tests_SRS_URL_ENCODE_01_013: [ Otherwise URL_DecodeInPlace shall write the decoding of text over its first *length characters, followed by a '\0' only when the decoding is shorter, set *length to the length of the decoding and return 0. ]*/
+TEST_FUNCTION(URL_DecodeInPlace_decodes_over_text)
+{
+    // arrange
+    char text[] = "devices%2fmyDevice%3fapi-version%3d2016";
+    size_t length = sizeof(text) - 1;
+
+    // act
+    int result = URL_DecodeInPlace(text, &length);
+
+    //assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, "devices/myDevice?api-version=2016", text);
+    ASSERT_ARE_EQUAL(size_t, strlen("devices/myDevice?api-version=2016"), length);
+}
+
+/*Tests_SRS_URL_ENCODE_01_013: [ Otherwise URL_DecodeInPlace shall write the decoding of text over its first *length characters, followed by a '\0' only when the decoding is shorter, set *length to the length of the decoding and return 0. ]*/
+TEST_FUNCTION(URL_DecodeInPlace_decodes_only_length_characters)
+{
+    // arrange
+    char text[] = "a%20b&c%20d";
+    size_t length = 5;
+
+    // act
+    int result = URL_DecodeInPlace(text, &length);
+
+    //assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, "a b", text);
+    ASSERT_ARE_EQUAL(size_t, 3, length);
+    ASSERT_ARE_EQUAL(char_ptr, "c%20d", text + 6);
+}
+
+/*Tests_SRS_URL_ENCODE_01_013: [ Otherwise URL_DecodeInPlace shall write the decoding of text over its first *length characters, followed by a '\0' only when the decoding is shorter, set *length to the length of the decoding and return 0. ]*/
+TEST_FUNCTION(URL_DecodeInPlace_without_escapes_leaves_the_characters_after_length_unchanged)
+{
+    // arrange
+    char text[] = "ab&cd";
+    size_t length = 2;
+
+    // act
+    int result = URL_DecodeInPlace(text, &length);
+
+    //assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 2, length);
+    ASSERT_ARE_EQUAL(char_ptr, "ab&cd", text);
+}
+
+/* URL_Decode_If_Needed */
+
+/*Tests_SRS_URL_ENCODE_01_014: [ If text is NULL, URL_Decode_If_Needed shall fail and return NULL. ]*/
+TEST_FUNCTION(URL_Decode_If_Needed_with_NULL_text_fails)
+{
+    // arrange
+    char destination[16];
+
+    // act
+    const char* result = URL_Decode_If_Needed(NULL, destination, sizeof(destination));
+
+    //assert
+    ASSERT_IS_NULL(result);
+}
+
+/*Tests_SRS_URL_ENCODE_01_015: [ If text is not a valid encoding, URL_Decode_If_Needed shall fail and return NULL. ]*/
+TEST_FUNCTION(URL_Decode_If_Needed_with_invalid_encoding_fails)
+{
+    // arrange
+    char destination[16];
+
+    // act
+    const char* result = URL_Decode_If_Needed("hello world", destination, sizeof(destination));
+
+    //assert
+    ASSERT_IS_NULL(result);
+}
+
+/*Tests_SRS_URL_ENCODE_01_016: [ If text contains no '%', URL_Decode_If_Needed shall return text without copying it. ]*/
+TEST_FUNCTION(URL_Decode_If_Needed_with_nothing_escaped_returns_text)
+{
+    // arrange
+
+    // act
+    const char* result = URL_Decode_If_Needed(UNRESERVED_CHAR, NULL, 0);
+
+    //assert
+    ASSERT_ARE_EQUAL(void_ptr, (void*)UNRESERVED_CHAR, (void*)result);
+}
+
+/*Tests_SRS_URL_ENCODE_01_017: [ If destination is NULL or destination_size is smaller than the length of the decoding of text plus 1, URL_Decode_If_Needed shall fail and return NULL. ]*/
+TEST_FUNCTION(URL_Decode_If_Needed_with_a_destination_too_small_fails)
+{
+    // arrange
+    char destination[11];
+
+    // act
+    const char* result = URL_Decode_If_Needed("hello%20world", destination, sizeof(destination));
+
+    //assert
+    ASSERT_IS_NULL(result);
+}
+
+/*Tests_SRS_URL_ENCODE_01_018: [ Otherwise URL_Decode_If_Needed shall write the decoding of text followed by a '\0' to destination and return destination. ]*/
+TEST_FUNCTION(URL_Decode_If_Needed_decodes_into_destination)
+{
+    // arrange
+    char destination[12];
+
+    // act
+    const char* result = URL_Decode_If_Needed("hello%20world", destination, sizeof(destination));
+
+    //assert
+    ASSERT_ARE_EQUAL(void_ptr, (void*)destination, (void*)result);
+    ASSERT_ARE_EQUAL(char_ptr, "hello world", destination);
+}
+
 END_TEST_SUITE(URLEncode_UnitTests)
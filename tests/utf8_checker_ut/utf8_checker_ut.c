@@ -13,9 +13,11 @@
 
 #ifdef __cplusplus
 #include <cstddef>
+#include <cstring>
 #else
 #include <stddef.h>
 #include <stdbool.h>
+#include <string.h>
 #endif
 
 #include "testrunnerswitcher.h"
@@ -558,4 +560,288 @@ TEST_FUNCTION(utf8_checker_with_4th_char_bad_fails)
     ASSERT_IS_FALSE(result);
 }
 
+/* Tests_SRS_UTF8_CHECKER_01_010: [ utf8_checker_is_valid_utf8 shall skip runs of 1 byte code points several bytes at a time. ]*/
+TEST_FUNCTION(utf8_checker_with_a_long_ascii_string_succeeds)
+{
+    // arrange
+    bool result;
+    unsigned char test_str[100];
+    (void)memset(test_str, 'x', sizeof(test_str));
+
+    // act
+    result = utf8_checker_is_valid_utf8(test_str, sizeof(test_str));
+
+    // assert
+    ASSERT_IS_TRUE(result);
+}
+
+/* Tests_SRS_UTF8_CHECKER_01_010: [ utf8_checker_is_valid_utf8 shall skip runs of 1 byte code points several bytes at a time. ]*/
+TEST_FUNCTION(utf8_checker_with_a_bad_byte_after_a_long_ascii_run_fails)
+{
+    // arrange
+    size_t i;
+    unsigned char test_str[100];
+
+    for (i = 0; i < sizeof(test_str); i++)
+    {
+        bool result;
+        (void)memset(test_str, 'x', sizeof(test_str));
+        test_str[i] = 0x80;
+
+        // act
+        result = utf8_checker_is_valid_utf8(test_str, sizeof(test_str));
+
+        // assert
+        ASSERT_IS_FALSE(result);
+    }
+}
+
+/* Tests_SRS_UTF8_CHECKER_01_011: [ When the CPU has SIMD instructions, utf8_checker_is_valid_utf8 shall validate long strings 16 bytes at a time and accept exactly the strings the byte by byte validation accepts. ]*/
+TEST_FUNCTION(utf8_checker_with_a_long_string_of_all_length_chars_at_any_offset_succeeds)
+{
+    // arrange
+    static const unsigned char chars[] = { 0x01, 0xC2, 0x80, 0xEF, 0xBF, 0xBF, 0xF7, 0xBF, 0xBF, 0xBF, 0xED, 0xA0, 0x80 };
+    size_t offset;
+    unsigned char test_str[100];
+
+    for (offset = 0; offset < sizeof(test_str) - sizeof(chars); offset++)
+    {
+        bool result;
+        (void)memset(test_str, 'x', sizeof(test_str));
+        (void)memcpy(test_str + offset, chars, sizeof(chars));
+
+        // act
+        result = utf8_checker_is_valid_utf8(test_str, sizeof(test_str));
+
+        // assert
+        ASSERT_IS_TRUE(result);
+    }
+}
+
+/* Tests_SRS_UTF8_CHECKER_01_011: [ When the CPU has SIMD instructions, utf8_checker_is_valid_utf8 shall validate long strings 16 bytes at a time and accept exactly the strings the byte by byte validation accepts. ]*/
+TEST_FUNCTION(utf8_checker_with_a_long_string_with_invalid_codes_at_any_offset_fails)
+{
+    // arrange
+    static const unsigned char invalid_codes[][4] =
+    {
+        { 0xC1, 0xBF, 'x', 'x' },
+        { 0xE0, 0x9F, 0xBF, 'x' },
+        { 0xF0, 0x8F, 0xBF, 0xBF },
+        { 0xEF, 0xBF, 'x', 'x' },
+        { 0xF7, 0xBF, 0xBF, 'x' },
+        { 0xF8, 0x88, 0x80, 0x80 },
+        { 0xBF, 'x', 'x', 'x' }
+    };
+    size_t i;
+    size_t offset;
+    unsigned char test_str[100];
+
+    for (i = 0; i < sizeof(invalid_codes) / sizeof(invalid_codes[0]); i++)
+    {
+        for (offset = 0; offset < sizeof(test_str) - sizeof(invalid_codes[i]); offset++)
+        {
+            bool result;
+            (void)memset(test_str, 'x', sizeof(test_str));
+            (void)memcpy(test_str + offset, invalid_codes[i], sizeof(invalid_codes[i]));
+
+            // act
+            result = utf8_checker_is_valid_utf8(test_str, sizeof(test_str));
+
+            // assert
+            ASSERT_IS_FALSE(result);
+        }
+    }
+}
+
+/* Tests_SRS_UTF8_CHECKER_01_011: [ When the CPU has SIMD instructions, utf8_checker_is_valid_utf8 shall validate long strings 16 bytes at a time and accept exactly the strings the byte by byte validation accepts. ]*/
+TEST_FUNCTION(utf8_checker_with_a_long_string_ending_with_an_incomplete_code_fails)
+{
+    // arrange
+    bool result;
+    unsigned char test_str[96];
+    (void)memset(test_str, 'x', sizeof(test_str));
+    test_str[sizeof(test_str) - 3] = 0xF0;
+    test_str[sizeof(test_str) - 2] = 0x90;
+    test_str[sizeof(test_str) - 1] = 0x80;
+
+    // act
+    result = utf8_checker_is_valid_utf8(test_str, sizeof(test_str));
+
+    // assert
+    ASSERT_IS_FALSE(result);
+}
+
+/* utf8_checker_init */
+
+/* Tests_SRS_UTF8_CHECKER_01_012: [ If state is NULL, utf8_checker_init shall return. ]*/
+TEST_FUNCTION(utf8_checker_init_with_NULL_state_returns)
+{
+    // arrange
+
+    // act
+    utf8_checker_init(NULL);
+
+    // assert
+    // no explicit assert
+}
+
+/* Tests_SRS_UTF8_CHECKER_01_013: [ utf8_checker_init shall set state to hold an empty, valid string. ]*/
+/* Tests_SRS_UTF8_CHECKER_01_021: [ utf8_checker_complete shall return true if all the fragments were valid UTF-8 and the last one did not end with an incomplete code point, and false otherwise. ]*/
+TEST_FUNCTION(utf8_checker_complete_after_init_succeeds)
+{
+    // arrange
+    bool result;
+    UTF8_CHECKER_STATE state;
+    utf8_checker_init(&state);
+
+    // act
+    result = utf8_checker_complete(&state);
+
+    // assert
+    ASSERT_IS_TRUE(result);
+}
+
+/* utf8_checker_validate_fragment */
+
+/* Tests_SRS_UTF8_CHECKER_01_014: [ If state or utf8_str is NULL, utf8_checker_validate_fragment shall return false. ]*/
+TEST_FUNCTION(utf8_checker_validate_fragment_with_NULL_state_fails)
+{
+    // arrange
+    bool result;
+    unsigned char test_str[] = { 0x01 };
+
+    // act
+    result = utf8_checker_validate_fragment(NULL, test_str, sizeof(test_str));
+
+    // assert
+    ASSERT_IS_FALSE(result);
+}
+
+/* Tests_SRS_UTF8_CHECKER_01_014: [ If state or utf8_str is NULL, utf8_checker_validate_fragment shall return false. ]*/
+TEST_FUNCTION(utf8_checker_validate_fragment_with_NULL_utf8_str_fails)
+{
+    // arrange
+    bool result;
+    UTF8_CHECKER_STATE state;
+    utf8_checker_init(&state);
+
+    // act
+    result = utf8_checker_validate_fragment(&state, NULL, 1);
+
+    // assert
+    ASSERT_IS_FALSE(result);
+}
+
+/* Tests_SRS_UTF8_CHECKER_01_016: [ utf8_checker_validate_fragment shall first complete the code point left incomplete by the previous fragment with the first bytes of utf8_str and validate it. ]*/
+/* Tests_SRS_UTF8_CHECKER_01_017: [ A code point cut by the end of utf8_str shall be kept in state and validated with the next fragment. ]*/
+/* Tests_SRS_UTF8_CHECKER_01_019: [ utf8_checker_validate_fragment shall return true if all the bytes seen so far are valid UTF-8, possibly ending with an incomplete code point, and false otherwise. ]*/
+TEST_FUNCTION(utf8_checker_validate_fragment_with_code_points_cut_at_every_byte_succeeds)
+{
+    // arrange
+    unsigned char test_str[] = { 0x01, 0xC2, 0x80, 0xEF, 0xBF, 0xBF, 0xF7, 0xBF, 0xBF, 0xBF };
+    size_t i;
+    UTF8_CHECKER_STATE state;
+    utf8_checker_init(&state);
+
+    // act
+    for (i = 0; i < sizeof(test_str); i++)
+    {
+        ASSERT_IS_TRUE(utf8_checker_validate_fragment(&state, test_str + i, 1));
+    }
+
+    // assert
+    ASSERT_IS_TRUE(utf8_checker_complete(&state));
+}
+
+/* Tests_SRS_UTF8_CHECKER_01_016: [ utf8_checker_validate_fragment shall first complete the code point left incomplete by the previous fragment with the first bytes of utf8_str and validate it. ]*/
+/* Tests_SRS_UTF8_CHECKER_01_019: [ utf8_checker_validate_fragment shall return true if all the bytes seen so far are valid UTF-8, possibly ending with an incomplete code point, and false otherwise. ]*/
+TEST_FUNCTION(utf8_checker_validate_fragment_with_a_too_low_code_point_cut_between_fragments_fails)
+{
+    // arrange
+    bool result;
+    unsigned char fragment_1[] = { 0x01, 0xE0 };
+    unsigned char fragment_2[] = { 0x9F, 0xBF, 0x01 };
+    UTF8_CHECKER_STATE state;
+    utf8_checker_init(&state);
+    ASSERT_IS_TRUE(utf8_checker_validate_fragment(&state, fragment_1, sizeof(fragment_1)));
+
+    // act
+    result = utf8_checker_validate_fragment(&state, fragment_2, sizeof(fragment_2));
+
+    // assert
+    ASSERT_IS_FALSE(result);
+    ASSERT_IS_FALSE(utf8_checker_complete(&state));
+}
+
+/* Tests_SRS_UTF8_CHECKER_01_018: [ The remaining bytes of utf8_str shall be validated as utf8_checker_is_valid_utf8 does. ]*/
+/* Tests_SRS_UTF8_CHECKER_01_015: [ If a previous fragment was found not to be valid UTF-8, utf8_checker_validate_fragment shall return false. ]*/
+TEST_FUNCTION(utf8_checker_validate_fragment_after_an_invalid_fragment_fails)
+{
+    // arrange
+    bool result;
+    unsigned char bad_fragment[] = { 0xFF, 0xBF };
+    unsigned char good_fragment[] = { 0x01 };
+    UTF8_CHECKER_STATE state;
+    utf8_checker_init(&state);
+    ASSERT_IS_FALSE(utf8_checker_validate_fragment(&state, bad_fragment, sizeof(bad_fragment)));
+
+    // act
+    result = utf8_checker_validate_fragment(&state, good_fragment, sizeof(good_fragment));
+
+    // assert
+    ASSERT_IS_FALSE(result);
+}
+
+/* utf8_checker_complete */
+
+/* Tests_SRS_UTF8_CHECKER_01_020: [ If state is NULL, utf8_checker_complete shall return false. ]*/
+TEST_FUNCTION(utf8_checker_complete_with_NULL_state_fails)
+{
+    // arrange
+    bool result;
+
+    // act
+    result = utf8_checker_complete(NULL);
+
+    // assert
+    ASSERT_IS_FALSE(result);
+}
+
+/* Tests_SRS_UTF8_CHECKER_01_021: [ utf8_checker_complete shall return true if all the fragments were valid UTF-8 and the last one did not end with an incomplete code point, and false otherwise. ]*/
+TEST_FUNCTION(utf8_checker_complete_with_an_incomplete_code_point_fails)
+{
+    // arrange
+    bool result;
+    unsigned char test_str[] = { 0x01, 0xEF, 0xBF };
+    UTF8_CHECKER_STATE state;
+    utf8_checker_init(&state);
+    ASSERT_IS_TRUE(utf8_checker_validate_fragment(&state, test_str, sizeof(test_str)));
+
+    // act
+    result = utf8_checker_complete(&state);
+
+    // assert
+    ASSERT_IS_FALSE(result);
+}
+
+/* Tests_SRS_UTF8_CHECKER_01_022: [ utf8_checker_complete shall reset state so that it can be used for the next message. ]*/
+TEST_FUNCTION(utf8_checker_complete_resets_the_state)
+{
+    // arrange
+    bool result;
+    unsigned char bad_fragment[] = { 0xFF };
+    unsigned char good_fragment[] = { 0xC2, 0x80 };
+    UTF8_CHECKER_STATE state;
+    utf8_checker_init(&state);
+    (void)utf8_checker_validate_fragment(&state, bad_fragment, sizeof(bad_fragment));
+    (void)utf8_checker_complete(&state);
+
+    // act
+    result = utf8_checker_validate_fragment(&state, good_fragment, sizeof(good_fragment));
+
+    // assert
+    ASSERT_IS_TRUE(result);
+    ASSERT_IS_TRUE(utf8_checker_complete(&state));
+}
+
 END_TEST_SUITE(utf8_checker_ut)
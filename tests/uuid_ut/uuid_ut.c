@@ -31,33 +31,31 @@ static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
 
 
 #define UUID_OCTET_COUNT    16
-#define UUID_STRING_LENGTH  36
-#define UUID_STRING_SIZE    (UUID_STRING_LENGTH + 1)
 
 static const UUID_T TEST_UUID = { 222, 193, 74, 152, 197, 252, 67, 14, 180, 227, 51, 193, 196, 52, 220, 175 };
 static char* TEST_UUID_STRING = "dec14a98-c5fc-430e-b4e3-33c1c434dcaf";
 
-static UNIQUEID_RESULT mock_UniqueId_Generate_result;
-static UNIQUEID_RESULT mock_UniqueId_Generate(char* uid, size_t bufferSize)
+static UNIQUEID_RESULT mock_UniqueId_GenerateBinary_result;
+static UNIQUEID_RESULT mock_UniqueId_GenerateBinary(unsigned char* uid, size_t bufferSize)
 {
-    (void)memcpy(uid, TEST_UUID_STRING, bufferSize);
-    return mock_UniqueId_Generate_result;
+    (void)memcpy(uid, TEST_UUID, bufferSize);
+    return mock_UniqueId_GenerateBinary_result;
 }
 
 static void initialize_variables()
 {
-    mock_UniqueId_Generate_result = UNIQUEID_OK;
+    mock_UniqueId_GenerateBinary_result = UNIQUEID_OK;
 }
 
 static void register_global_mock_returns()
 {
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(malloc, NULL);
-    REGISTER_GLOBAL_MOCK_FAIL_RETURN(UniqueId_Generate, UNIQUEID_ERROR);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(UniqueId_GenerateBinary, UNIQUEID_ERROR);
 }
 
 static void register_global_function_hooks()
 {
-    REGISTER_GLOBAL_MOCK_HOOK(UniqueId_Generate, mock_UniqueId_Generate);
+    REGISTER_GLOBAL_MOCK_HOOK(UniqueId_GenerateBinary, mock_UniqueId_GenerateBinary);
 }
 
 static void register_mock_aliases()
@@ -118,21 +116,16 @@ TEST_FUNCTION(UUID_generate_NULL_uuid)
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
 }
 
-// Tests_SRS_UUID_09_002: [ UUID_generate shall obtain an UUID string from UniqueId_Generate ]
-// Tests_SRS_UUID_09_004: [ The UUID string shall be parsed into an UUID_T type (16 unsigned char array) and filled in uuid ]
+// Tests_SRS_UUID_09_002: [ UUID_generate shall obtain the UUID bytes from UniqueId_GenerateBinary, writing them directly in uuid ]
 // Tests_SRS_UUID_09_006: [ If no failures occur, UUID_generate shall return zero ]
 TEST_FUNCTION(UUID_generate_succeed)
 {
     //Arrange
     UUID_T uuid;
     int result;
-    char uuid_string[UUID_STRING_SIZE];
 
     umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(malloc(UUID_STRING_SIZE))
-        .SetReturn(uuid_string);
-    STRICT_EXPECTED_CALL(UniqueId_Generate(uuid_string, UUID_STRING_SIZE));
-    STRICT_EXPECTED_CALL(free(uuid_string));
+    STRICT_EXPECTED_CALL(UniqueId_GenerateBinary(uuid, UUID_OCTET_COUNT));
 
     //Act
     result = UUID_generate(&uuid);
@@ -150,31 +143,24 @@ TEST_FUNCTION(UUID_generate_succeed)
     }
 }
 
-// Tests_SRS_UUID_09_003: [ If the UUID string fails to be obtained, UUID_generate shall fail and return a non-zero value ]
-// Tests_SRS_UUID_09_005: [ If uuid fails to be set, UUID_generate shall fail and return a non-zero value ]
+// Tests_SRS_UUID_09_003: [ If the UUID fails to be obtained, UUID_generate shall fail and return a non-zero value ]
 TEST_FUNCTION(UUID_generate_failure_checks)
 {
     //Arrange
     UUID_T uuid;
     int result;
     size_t i;
-    char uuid_string[UUID_STRING_SIZE];
 
     ASSERT_ARE_EQUAL(int, 0, umock_c_negative_tests_init());
 
     umock_c_reset_all_calls();
-    STRICT_EXPECTED_CALL(malloc(UUID_STRING_SIZE))
-        .SetReturn(uuid_string);
-    STRICT_EXPECTED_CALL(UniqueId_Generate(uuid_string, UUID_STRING_SIZE));
-    STRICT_EXPECTED_CALL(free(uuid_string));
+    STRICT_EXPECTED_CALL(UniqueId_GenerateBinary(uuid, UUID_OCTET_COUNT));
     umock_c_negative_tests_snapshot();
 
     for (i = 0; i < umock_c_negative_tests_call_count(); i++)
     {
         char temp_str[64];
 
-        if (i == 2) continue;
-
         umock_c_negative_tests_reset();
         umock_c_negative_tests_fail_call(i);
 
@@ -261,6 +247,75 @@ TEST_FUNCTION(UUID_to_string_failure_checks)
     umock_c_negative_tests_deinit();
 }
 
+// Tests_SRS_UUID_09_017: [ If uuid or buffer are NULL, UUID_to_string_buffer shall return a non-zero value ]
+TEST_FUNCTION(UUID_to_string_buffer_NULL_uuid)
+{
+    //Arrange
+    int result;
+    char buffer[UUID_STRING_SIZE];
+
+    umock_c_reset_all_calls();
+
+    //Act
+    result = UUID_to_string_buffer(NULL, buffer, sizeof(buffer));
+
+    //Assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+// Tests_SRS_UUID_09_017: [ If uuid or buffer are NULL, UUID_to_string_buffer shall return a non-zero value ]
+TEST_FUNCTION(UUID_to_string_buffer_NULL_buffer)
+{
+    //Arrange
+    int result;
+
+    umock_c_reset_all_calls();
+
+    //Act
+    result = UUID_to_string_buffer(&TEST_UUID, NULL, UUID_STRING_SIZE);
+
+    //Assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+// Tests_SRS_UUID_09_018: [ If buffer_size is less than UUID_STRING_SIZE, UUID_to_string_buffer shall return a non-zero value ]
+TEST_FUNCTION(UUID_to_string_buffer_small_buffer_fails)
+{
+    //Arrange
+    int result;
+    char buffer[UUID_STRING_SIZE];
+
+    umock_c_reset_all_calls();
+
+    //Act
+    result = UUID_to_string_buffer(&TEST_UUID, buffer, UUID_STRING_LENGTH);
+
+    //Assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+// Tests_SRS_UUID_09_019: [ Each character in uuid shall be written in the respective positions of buffer as a 2-digit lowercase HEX value, with dashes as per RFC 4122, followed by a null terminator ]
+// Tests_SRS_UUID_09_020: [ If no failures occur, UUID_to_string_buffer shall return zero ]
+TEST_FUNCTION(UUID_to_string_buffer_succeed)
+{
+    //Arrange
+    int result;
+    char buffer[UUID_STRING_SIZE];
+
+    umock_c_reset_all_calls();
+
+    //Act
+    result = UUID_to_string_buffer(&TEST_UUID, buffer, sizeof(buffer));
+
+    //Assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_UUID_STRING, buffer);
+}
+
 // Tests_SRS_UUID_09_007: [ If uuid_string or uuid are NULL, UUID_from_string shall return a non-zero value ]
 TEST_FUNCTION(UUID_from_string_NULL_uuid_string)
 {
@@ -5,11 +5,13 @@
 #include <cstdlib>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 #else
 #include <stdlib.h>
 #include <stddef.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <string.h>
 #endif
 
 #include "testrunnerswitcher.h"
@@ -55,26 +57,23 @@ Tests_SRS_UWS_CLIENT_01_211: [ One implication of this is that in absence of ext
 #include "azure_c_shared_utility/xio.h"
 #include "azure_c_shared_utility/shared_util_options.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
-#include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/tlsio.h"
 #include "azure_c_shared_utility/uws_frame_encoder.h"
 #include "azure_c_shared_utility/gb_rand.h"
 #include "azure_c_shared_utility/base64.h"
 #include "azure_c_shared_utility/map.h"
+#include "azure_c_shared_utility/timer_wheel.h"
 
 IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(OPTIONHANDLER_RESULT, OPTIONHANDLER_RESULT_VALUES);
 IMPLEMENT_UMOCK_C_ENUM_TYPE(WS_FRAME_TYPE, WS_FRAME_TYPE_VALUES);
 
-static const void** list_items = NULL;
-static size_t list_item_count = 0;
-static const SINGLYLINKEDLIST_HANDLE TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE = (SINGLYLINKEDLIST_HANDLE)0x4242;
-static const LIST_ITEM_HANDLE TEST_LIST_ITEM_HANDLE = (LIST_ITEM_HANDLE)0x4243;
 static const XIO_HANDLE TEST_IO_HANDLE = (XIO_HANDLE)0x4244;
 static const OPTIONHANDLER_HANDLE TEST_IO_OPTIONHANDLER_HANDLE = (OPTIONHANDLER_HANDLE)0x4446;
 static const OPTIONHANDLER_HANDLE TEST_OPTIONHANDLER_HANDLE = (OPTIONHANDLER_HANDLE)0x4447;
-static const STRING_HANDLE BASE64_ENCODED_STRING = (STRING_HANDLE)0x4447;
+static const TIMER_WHEEL_HANDLE TEST_TIMER_WHEEL_HANDLE = (TIMER_WHEEL_HANDLE)0x4450;
+static const TIMER_WHEEL_TIMER_HANDLE TEST_KEEPALIVE_TIMER_HANDLE = (TIMER_WHEEL_TIMER_HANDLE)0x4451;
 static const MAP_HANDLE TEST_REQUEST_HEADERS_MAP = (MAP_HANDLE)0x4448;
 
 static size_t currentmalloc_call;
@@ -138,75 +137,6 @@ static int my_mallocAndStrcpy_s(char** destination, const char* source)
     return 0;
 }
 
-static LIST_ITEM_HANDLE add_to_list(const void* item)
-{
-    const void** items = (const void**)realloc((void*)list_items, (list_item_count + 1) * sizeof(item));
-    if (items != NULL)
-    {
-        list_items = items;
-        list_items[list_item_count++] = item;
-    }
-    return (LIST_ITEM_HANDLE)list_item_count;
-}
-
-static int singlylinkedlist_remove_result;
-
-static int my_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item)
-{
-    size_t index = (size_t)item - 1;
-    (void)list;
-    (void)memmove((void*)&list_items[index], &list_items[index + 1], sizeof(const void*) * (list_item_count - index - 1));
-    list_item_count--;
-    if (list_item_count == 0)
-    {
-        free((void*)list_items);
-        list_items = NULL;
-    }
-    return singlylinkedlist_remove_result;
-}
-
-static LIST_ITEM_HANDLE my_singlylinkedlist_get_head_item(SINGLYLINKEDLIST_HANDLE list)
-{
-    LIST_ITEM_HANDLE list_item_handle = NULL;
-    (void)list;
-    if (list_item_count > 0)
-    {
-        list_item_handle = (LIST_ITEM_HANDLE)1;
-    }
-    else
-    {
-        list_item_handle = NULL;
-    }
-    return list_item_handle;
-}
-
-static LIST_ITEM_HANDLE my_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item)
-{
-    (void)list;
-    return add_to_list(item);
-}
-
-static const void* my_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_handle)
-{
-    return (const void*)list_items[(size_t)item_handle - 1];
-}
-
-static LIST_ITEM_HANDLE my_singlylinkedlist_find(SINGLYLINKEDLIST_HANDLE handle, LIST_MATCH_FUNCTION match_function, const void* match_context)
-{
-    size_t i;
-    const void* found_item = NULL;
-    (void)handle;
-    for (i = 0; i < list_item_count; i++)
-    {
-        if (match_function((LIST_ITEM_HANDLE)list_items[i], match_context))
-        {
-            found_item = list_items[i];
-            break;
-        }
-    }
-    return (LIST_ITEM_HANDLE)found_item;
-}
-
 static MAP_RESULT my_Map_GetInternals_return;
 static char* my_Map_GetInternals_keys[10];
 static char* my_Map_GetInternals_values[10];
@@ -339,6 +269,8 @@ MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_open_complete, void*, context, WS_OPE
 MOCK_FUNCTION_END()
 MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_frame_received, void*, context, unsigned char, frame_type, const unsigned char*, buffer, size_t, size)
 MOCK_FUNCTION_END()
+MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_fragment_received, void*, context, unsigned char, frame_type, unsigned char, fragment_flags, const unsigned char*, buffer, size_t, size)
+MOCK_FUNCTION_END()
 MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_peer_closed, void*, context, uint16_t*, close_code, const unsigned char*, extra_data, size_t, extra_data_length)
 MOCK_FUNCTION_END()
 MOCK_FUNCTION_WITH_CODE(, void, test_on_ws_error, void*, context, WS_ERROR, error_code);
@@ -353,6 +285,7 @@ static void* g_on_io_open_complete_context;
 static ON_SEND_COMPLETE g_on_io_send_complete;
 static void* g_on_io_send_complete_context;
 static int g_xio_send_result;
+static bool g_xio_send_completes_with_error;
 static ON_BYTES_RECEIVED g_on_bytes_received;
 static void* g_on_bytes_received_context;
 static ON_IO_ERROR g_on_io_error;
@@ -380,6 +313,16 @@ static int my_xio_close(XIO_HANDLE xio, ON_IO_CLOSE_COMPLETE on_io_close_complet
     return 0;
 }
 
+static unsigned char* g_lent_receive_buffer;
+static size_t g_lent_receive_buffer_size;
+static int my_xio_set_receive_buffer(XIO_HANDLE xio, unsigned char* buffer, size_t size)
+{
+    (void)xio;
+    g_lent_receive_buffer = buffer;
+    g_lent_receive_buffer_size = size;
+    return 0;
+}
+
 static int my_xio_send(XIO_HANDLE xio, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
 {
     (void)xio;
@@ -387,6 +330,11 @@ static int my_xio_send(XIO_HANDLE xio, const void* buffer, size_t size, ON_SEND_
     (void)size;
     g_on_io_send_complete = on_send_complete;
     g_on_io_send_complete_context = callback_context;
+    if (g_xio_send_completes_with_error)
+    {
+        /* the underlying IO indicates the send as failed before returning */
+        on_send_complete(callback_context, IO_SEND_ERROR);
+    }
     return g_xio_send_result;
 }
 
@@ -403,6 +351,23 @@ static OPTIONHANDLER_HANDLE my_OptionHandler_Create(pfCloneOption cloneOption, p
     return TEST_OPTIONHANDLER_HANDLE;
 }
 
+static ON_TIMER_EXPIRED g_on_timer_expired;
+static void* g_on_timer_expired_context;
+
+static TIMER_WHEEL_TIMER_HANDLE my_timer_wheel_create_timer(TIMER_WHEEL_HANDLE timer_wheel, ON_TIMER_EXPIRED on_timer_expired, void* context)
+{
+    (void)timer_wheel;
+    g_on_timer_expired = on_timer_expired;
+    g_on_timer_expired_context = context;
+    return TEST_KEEPALIVE_TIMER_HANDLE;
+}
+
+static int my_tickcounter_get_monotonic_us(tickcounter_us_t* monotonic_us)
+{
+    *monotonic_us = 1000000;
+    return 0;
+}
+
 static TEST_MUTEX_HANDLE g_testByTest;
 
 static const IO_INTERFACE_DESCRIPTION* TEST_SOCKET_IO_INTERFACE_DESCRIPTION = (const IO_INTERFACE_DESCRIPTION*)0x4542;
@@ -428,6 +393,26 @@ extern "C" {
         return real_BUFFER_new();
     }
 
+    /* a masked header with a zero masking key, so that the masked payload is the payload */
+    int my_uws_frame_encoder_encode_header(WS_FRAME_TYPE opcode, size_t length, bool is_masked, bool is_final, unsigned char reserved, unsigned char* header, size_t* header_size)
+    {
+        (void)is_masked;
+        header[0] = (unsigned char)((is_final ? 0x80 : 0x00) | (reserved << 4) | (unsigned char)opcode);
+        header[1] = (unsigned char)(0x80 | length);
+        (void)memset(header + 2, 0, 4);
+        *header_size = 6;
+        return 0;
+    }
+
+    void my_uws_frame_encoder_mask(unsigned char* destination, const unsigned char* source, size_t length, const unsigned char* masking_key)
+    {
+        size_t i;
+        for (i = 0; i < length; i++)
+        {
+            destination[i] = source[i] ^ masking_key[i % 4];
+        }
+    }
+
 #ifdef __cplusplus
 }
 #endif
@@ -461,19 +446,13 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_HOOK(xio_open, my_xio_open);
     REGISTER_GLOBAL_MOCK_HOOK(xio_close, my_xio_close);
     REGISTER_GLOBAL_MOCK_HOOK(xio_send, my_xio_send);
-    REGISTER_GLOBAL_MOCK_RETURN(singlylinkedlist_create, TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, my_singlylinkedlist_remove);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, my_singlylinkedlist_get_head_item);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, my_singlylinkedlist_add);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_item_get_value, my_singlylinkedlist_item_get_value);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_find, my_singlylinkedlist_find);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_set_receive_buffer, my_xio_set_receive_buffer);
     REGISTER_GLOBAL_MOCK_HOOK(OptionHandler_Create, my_OptionHandler_Create);
     REGISTER_GLOBAL_MOCK_RETURN(socketio_get_interface_description, TEST_SOCKET_IO_INTERFACE_DESCRIPTION);
     REGISTER_GLOBAL_MOCK_RETURN(platform_get_default_tlsio, TEST_TLS_IO_INTERFACE_DESCRIPTION);
     REGISTER_GLOBAL_MOCK_RETURN(xio_create, TEST_IO_HANDLE);
     REGISTER_GLOBAL_MOCK_RETURN(xio_retrieveoptions, TEST_IO_OPTIONHANDLER_HANDLE);
     REGISTER_GLOBAL_MOCK_RETURN(utf8_checker_is_valid_utf8, true);
-    REGISTER_GLOBAL_MOCK_RETURN(Base64_Encode_Bytes, BASE64_ENCODED_STRING);
     REGISTER_GLOBAL_MOCK_RETURN(OptionHandler_FeedOptions, OPTIONHANDLER_OK);
     REGISTER_GLOBAL_MOCK_RETURN(OptionHandler_AddOption, OPTIONHANDLER_OK);
     REGISTER_GLOBAL_MOCK_RETURN(OptionHandler_Clone, TEST_OPTIONHANDLER_HANDLE);
@@ -482,6 +461,8 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_HOOK(BUFFER_u_char, real_BUFFER_u_char);
     REGISTER_GLOBAL_MOCK_HOOK(BUFFER_length, real_BUFFER_length);
     REGISTER_GLOBAL_MOCK_HOOK(uws_frame_encoder_encode, my_uws_frame_encoder_encode);
+    REGISTER_GLOBAL_MOCK_HOOK(uws_frame_encoder_encode_header, my_uws_frame_encoder_encode_header);
+    REGISTER_GLOBAL_MOCK_HOOK(uws_frame_encoder_mask, my_uws_frame_encoder_mask);
     REGISTER_GLOBAL_MOCK_HOOK(Map_GetInternals, my_Map_GetInternals);
     REGISTER_GLOBAL_MOCK_RETURN(STRING_c_str, "test_str");
     REGISTER_GLOBAL_MOCK_RETURN(Map_Create, TEST_REQUEST_HEADERS_MAP);
@@ -490,6 +471,12 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(Map_AddOrUpdate, MAP_ERROR);
     REGISTER_GLOBAL_MOCK_RETURN(Map_GetInternals, MAP_OK);
     REGISTER_GLOBAL_MOCK_FAIL_RETURN(Map_GetInternals, MAP_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(timer_wheel_create, TEST_TIMER_WHEEL_HANDLE);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(timer_wheel_create, NULL);
+    REGISTER_GLOBAL_MOCK_HOOK(timer_wheel_create_timer, my_timer_wheel_create_timer);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(timer_wheel_create_timer, NULL);
+    REGISTER_GLOBAL_MOCK_RETURN(timer_wheel_start_timer, 0);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_monotonic_us, my_tickcounter_get_monotonic_us);
     REGISTER_TYPE(IO_OPEN_RESULT, IO_OPEN_RESULT);
     REGISTER_TYPE(IO_SEND_RESULT, IO_SEND_RESULT);
     REGISTER_TYPE(WS_OPEN_RESULT, WS_OPEN_RESULT);
@@ -499,8 +486,6 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_TYPE(WS_FRAME_TYPE, WS_FRAME_TYPE);
     REGISTER_TYPE(const SOCKETIO_CONFIG*, const_SOCKETIO_CONFIG_ptr);
 
-    REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
-    REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(LIST_MATCH_FUNCTION, void*);
     REGISTER_UMOCK_ALIAS_TYPE(UWS_CLIENT_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
@@ -519,6 +504,14 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
     REGISTER_UMOCK_ALIAS_TYPE(MAP_FILTER_CALLBACK, void*);
     REGISTER_UMOCK_ALIAS_TYPE(MAP_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TIMER_WHEEL_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(TIMER_WHEEL_TIMER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_TIMER_EXPIRED, void*);
+#if defined(_WIN32)
+    REGISTER_UMOCK_ALIAS_TYPE(tickcounter_ms_t, unsigned long long);
+#else
+    REGISTER_UMOCK_ALIAS_TYPE(tickcounter_ms_t, unsigned long);
+#endif
 }
 
 TEST_SUITE_CLEANUP(suite_cleanup)
@@ -541,8 +534,12 @@ TEST_FUNCTION_INITIALIZE(method_init)
     whenShallmalloc_fail = 0;
     currentrealloc_call = 0;
     whenShallrealloc_fail = 0;
-    singlylinkedlist_remove_result = 0;
     g_xio_send_result = 0;
+    g_xio_send_completes_with_error = false;
+    g_on_timer_expired = NULL;
+    g_on_timer_expired_context = NULL;
+    g_lent_receive_buffer = NULL;
+    g_lent_receive_buffer_size = 0;
 
     memset(my_Map_GetInternals_keys, 0, sizeof(my_Map_GetInternals_keys));
     memset(my_Map_GetInternals_values, 0, sizeof(my_Map_GetInternals_values));
@@ -559,7 +556,7 @@ TEST_FUNCTION_CLEANUP(method_cleanup)
 /* uws_client_create */
 
 /* Tests_SRS_UWS_CLIENT_01_001: [uws_client_create shall create an instance of uws and return a non-NULL handle to it.]*/
-/* Tests_SRS_UWS_CLIENT_01_017: [ uws_client_create shall create a pending send IO list that is to be used to queue send packets by calling singlylinkedlist_create. ]*/
+/* Tests_SRS_UWS_CLIENT_01_017: [ uws_client_create shall initialize an empty pending send IO list that is to be used to queue send packets. ]*/
 /* Tests_SRS_UWS_CLIENT_01_005: [ If use_ssl is false then uws_client_create shall obtain the interface used to create a socketio instance by calling socketio_get_interface_description. ]*/
 /* Tests_SRS_UWS_CLIENT_01_008: [ The obtained interface shall be used to create the IO used as underlying IO by the newly created uws instance. ]*/
 /* Tests_SRS_UWS_CLIENT_01_009: [ The underlying IO shall be created by calling xio_create. ]*/
@@ -588,7 +585,6 @@ TEST_FUNCTION(uws_client_create_with_valid_args_no_ssl_succeeds)
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "111"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(Map_Create(NULL));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create());
     STRICT_EXPECTED_CALL(socketio_get_interface_description());
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters();
@@ -650,7 +646,6 @@ TEST_FUNCTION(uws_client_create_with_valid_args_no_ssl_port_different_than_80_su
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "333"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(Map_Create(NULL));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create());
     STRICT_EXPECTED_CALL(socketio_get_interface_description());
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters();
@@ -686,7 +681,6 @@ TEST_FUNCTION(uws_client_create_with_NULL_protocols_succeeds)
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "333"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(Map_Create(NULL));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create());
     STRICT_EXPECTED_CALL(socketio_get_interface_description());
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters();
@@ -821,38 +815,6 @@ TEST_FUNCTION(when_allocating_memory_for_the_resource_name_copy_fails_then_uws_c
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_UWS_CLIENT_01_018: [ If singlylinkedlist_create fails then uws_client_create shall fail and return NULL. ]*/
-TEST_FUNCTION(when_creating_the_pending_sends_list_fails_then_uws_client_create_fails)
-{
-    // arrange
-    SOCKETIO_CONFIG socketio_config;
-    UWS_CLIENT_HANDLE uws_client;
-
-    socketio_config.accepted_socket = NULL;
-    socketio_config.hostname = "test_host";
-    socketio_config.port = 80;
-
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_host"))
-        .IgnoreArgument_destination();
-    STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_resource/1"))
-        .IgnoreArgument_destination();
-    STRICT_EXPECTED_CALL(Map_Create(NULL));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create())
-        .SetReturn(NULL);
-    EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-
-    // act
-    uws_client = uws_client_create("test_host", 80, "test_resource/1", false, protocols, sizeof(protocols) / sizeof(protocols[0]));
-
-    // assert
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_IS_NULL(uws_client);
-}
-
 /* Tests_SRS_UWS_CLIENT_01_007: [ If obtaining the underlying IO interface fails, then uws_client_create shall fail and return NULL. ]*/
 TEST_FUNCTION(when_getting_the_socket_interface_description_fails_then_uws_client_create_fails)
 {
@@ -870,10 +832,8 @@ TEST_FUNCTION(when_getting_the_socket_interface_description_fails_then_uws_clien
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_resource/1"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(Map_Create(NULL));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create());
     STRICT_EXPECTED_CALL(socketio_get_interface_description())
         .SetReturn(NULL);
-    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -904,12 +864,10 @@ TEST_FUNCTION(when_creating_the_io_handle_fails_then_uws_client_create_fails)
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_resource/1"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(Map_Create(NULL));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create());
     STRICT_EXPECTED_CALL(socketio_get_interface_description());
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters()
         .SetReturn(NULL);
-    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -940,14 +898,12 @@ TEST_FUNCTION(when_allocating_memory_for_the_protocols_array_fails_then_uws_clie
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_resource/1"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(Map_Create(NULL));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create());
     STRICT_EXPECTED_CALL(socketio_get_interface_description());
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters();
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
-    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -978,7 +934,6 @@ TEST_FUNCTION(when_allocating_memory_for_the_first_proitocol_name_fails_then_uws
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_resource/1"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(Map_Create(NULL));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create());
     STRICT_EXPECTED_CALL(socketio_get_interface_description());
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters();
@@ -988,7 +943,6 @@ TEST_FUNCTION(when_allocating_memory_for_the_first_proitocol_name_fails_then_uws
         .SetReturn(1);
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
-    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -1020,7 +974,6 @@ TEST_FUNCTION(when_allocating_memory_for_the_second_protocol_name_fails_then_uws
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_resource/1"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(Map_Create(NULL));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create());
     STRICT_EXPECTED_CALL(socketio_get_interface_description());
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters();
@@ -1033,7 +986,6 @@ TEST_FUNCTION(when_allocating_memory_for_the_second_protocol_name_fails_then_uws
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
-    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -1075,7 +1027,6 @@ TEST_FUNCTION(uws_client_create_with_valid_args_ssl_succeeds)
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_resource/23"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(Map_Create(NULL));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create());
     STRICT_EXPECTED_CALL(platform_get_default_tlsio());
     STRICT_EXPECTED_CALL(socketio_get_interface_description());
     STRICT_EXPECTED_CALL(xio_create(TEST_TLS_IO_INTERFACE_DESCRIPTION, &tlsio_config))
@@ -1121,7 +1072,6 @@ TEST_FUNCTION(uws_client_create_with_valid_args_ssl_port_different_than_443_succ
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_resource/23"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(Map_Create(NULL));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create());
     STRICT_EXPECTED_CALL(platform_get_default_tlsio());
     STRICT_EXPECTED_CALL(socketio_get_interface_description());
     STRICT_EXPECTED_CALL(xio_create(TEST_TLS_IO_INTERFACE_DESCRIPTION, &tlsio_config))
@@ -1157,10 +1107,8 @@ TEST_FUNCTION(when_getting_the_tlsio_interface_fails_then_uws_client_create_fail
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "test_resource/23"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(Map_Create(NULL));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create());
     STRICT_EXPECTED_CALL(platform_get_default_tlsio())
         .SetReturn(NULL);
-    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
@@ -1181,7 +1129,7 @@ TEST_FUNCTION(when_getting_the_tlsio_interface_fails_then_uws_client_create_fail
 /* Tests_SRS_UWS_CLIENT_01_520: [ The argument port shall be copied for later use. ]*/
 /* Tests_SRS_UWS_CLIENT_01_521: [ The underlying IO shall be created by calling xio_create, while passing as arguments the io_interface and io_create_parameters argument values. ]*/
 /* Tests_SRS_UWS_CLIENT_01_523: [ The argument resource_name shall be copied for later use. ]*/
-/* Tests_SRS_UWS_CLIENT_01_530: [ uws_client_create_with_io shall create a pending send IO list that is to be used to queue send packets by calling singlylinkedlist_create. ]*/
+/* Tests_SRS_UWS_CLIENT_01_530: [ uws_client_create_with_io shall initialize an empty pending send IO list that is to be used to queue send packets. ]*/
 /* Tests_SRS_UWS_CLIENT_01_527: [ The protocol information indicated by protocols and protocol_count shall be copied for later use (for constructing the upgrade request). ]*/
 TEST_FUNCTION(uws_client_create_with_io_valid_args_succeeds)
 {
@@ -1199,7 +1147,6 @@ TEST_FUNCTION(uws_client_create_with_io_valid_args_succeeds)
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "111"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(Map_Create(NULL));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create());
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters();
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
@@ -1278,7 +1225,6 @@ TEST_FUNCTION(uws_client_create_with_io_with_NULL_resource_name_fails)
 /* Tests_SRS_UWS_CLIENT_01_519: [ If allocating memory for the copy of the hostname argument fails, then uws_client_create shall return NULL. ]*/
 /* Tests_SRS_UWS_CLIENT_01_522: [ If xio_create fails, then uws_client_create_with_io shall fail and return NULL. ]*/
 /* Tests_SRS_UWS_CLIENT_01_529: [ If allocating memory for the copy of the resource_name argument fails, then uws_client_create_with_io shall return NULL. ]*/
-/* Tests_SRS_UWS_CLIENT_01_531: [ If singlylinkedlist_create fails then uws_client_create_with_io shall fail and return NULL. ]*/
 /* Tests_SRS_UWS_CLIENT_01_528: [ If allocating memory for the copied protocol information fails then uws_client_create_with_io shall fail and return NULL. ]*/
 TEST_FUNCTION(when_any_call_fails_uws_client_create_with_io_fails)
 {
@@ -1304,8 +1250,6 @@ TEST_FUNCTION(when_any_call_fails_uws_client_create_with_io_fails)
         .IgnoreArgument_destination()
         .SetFailReturn(1);
     STRICT_EXPECTED_CALL(Map_Create(NULL));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create())
-        .SetFailReturn(NULL);
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters()
         .SetFailReturn(NULL);
@@ -1354,7 +1298,6 @@ TEST_FUNCTION(uws_client_create_with_io_with_NULL_protocols_succeeds)
     STRICT_EXPECTED_CALL(mallocAndStrcpy_s(IGNORED_PTR_ARG, "111"))
         .IgnoreArgument_destination();
     STRICT_EXPECTED_CALL(Map_Create(NULL));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create());
     STRICT_EXPECTED_CALL(xio_create(TEST_SOCKET_IO_INTERFACE_DESCRIPTION, &socketio_config))
         .IgnoreArgument_io_create_parameters();
 
@@ -1432,9 +1375,9 @@ TEST_FUNCTION(uws_client_create_with_io_with_a_NULL_protocol_name_for_second_pro
 
 /* Tests_SRS_UWS_CLIENT_01_019: [ uws_client_destroy shall free all resources associated with the uws instance. ]*/
 /* Tests_SRS_UWS_CLIENT_01_023: [ uws_client_destroy shall ensure the underlying IO created in uws_client_open_async is destroyed by calling xio_destroy. ]*/
-/* Tests_SRS_UWS_CLIENT_01_024: [ uws_client_destroy shall free the list used to track the pending sends by calling singlylinkedlist_destroy. ]*/
 /* Tests_SRS_UWS_CLIENT_01_424: [ uws_client_destroy shall free the buffer allocated in uws_client_create by calling BUFFER_delete. ]*/
 /* Tests_SRS_UWS_CLIENT_01_437: [ uws_client_destroy shall free the protocols array allocated in uws_client_create. ]*/
+/* Tests_SRS_UWS_CLIENT_01_584: [ uws_client_destroy shall free the kept upgrade request. ]*/
 TEST_FUNCTION(uws_client_destroy_fress_the_resources)
 {
     // arrange
@@ -1451,8 +1394,9 @@ TEST_FUNCTION(uws_client_destroy_fress_the_resources)
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
-    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
@@ -1484,8 +1428,9 @@ TEST_FUNCTION(uws_client_destroy_with_2_protocols_fress_both_protocols)
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
-    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
@@ -1511,10 +1456,11 @@ TEST_FUNCTION(uws_client_destroy_with_no_protocols_frees_all_other_resources)
     uws_client = uws_client_create("test_host", 444, "aaa", true, NULL, 0);
     umock_c_reset_all_calls();
 
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
-    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
@@ -1541,7 +1487,7 @@ TEST_FUNCTION(uws_client_destroy_with_NULL_does_nothing)
 
 /* Tests_SRS_UWS_CLIENT_01_021: [ uws_client_destroy shall perform a close action if the uws instance has already been open. ]*/
 /* Tests_SRS_UWS_CLIENT_01_034: [ uws_client_close_async shall obtain all the pending send frames by repetitively querying for the head of the pending IO list and freeing that head item. ]*/
-/* Tests_SRS_UWS_CLIENT_01_035: [ Obtaining the head of the pending send frames list shall be done by calling singlylinkedlist_get_head_item. ]*/
+/* Tests_SRS_UWS_CLIENT_01_035: [ Obtaining the head of the pending send frames list shall be done by taking the first entry of the list. ]*/
 TEST_FUNCTION(uws_client_destroy_also_performs_a_close)
 {
     TLSIO_CONFIG tlsio_config;
@@ -1557,14 +1503,14 @@ TEST_FUNCTION(uws_client_destroy_also_performs_a_close)
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
-    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
@@ -2007,7 +1953,6 @@ TEST_FUNCTION(uws_client_close_async_closes_the_underlying_IO)
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_on_io_close_complete()
         .IgnoreArgument_callback_context();
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
 
     // act
     result = uws_client_close_async(uws_client, test_on_ws_close_complete, (void*)0x4242);
@@ -2055,7 +2000,6 @@ TEST_FUNCTION(uws_client_close_async_with_NULL_close_complete_callback_is_allowe
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_on_io_close_complete()
         .IgnoreArgument_callback_context();
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
 
     // act
     result = uws_client_close_async(uws_client, NULL, (void*)0x4242);
@@ -2089,7 +2033,6 @@ TEST_FUNCTION(uws_client_close_async_with_NULL_close_context_succeeds)
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_on_io_close_complete()
         .IgnoreArgument_callback_context();
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
 
     // act
     result = uws_client_close_async(uws_client, test_on_ws_close_complete, NULL);
@@ -2247,7 +2190,7 @@ TEST_FUNCTION(uws_client_close_async_after_close_complete_fails)
 }
 
 /* Tests_SRS_UWS_CLIENT_01_034: [ uws_client_close_async shall obtain all the pending send frames by repetitively querying for the head of the pending IO list and freeing that head item. ]*/
-/* Tests_SRS_UWS_CLIENT_01_035: [ Obtaining the head of the pending send frames list shall be done by calling singlylinkedlist_get_head_item. ]*/
+/* Tests_SRS_UWS_CLIENT_01_035: [ Obtaining the head of the pending send frames list shall be done by taking the first entry of the list. ]*/
 /* Tests_SRS_UWS_CLIENT_01_036: [ For each pending send frame the send complete callback shall be called with UWS_SEND_FRAME_CANCELLED. ]*/
 /* Tests_SRS_UWS_CLIENT_01_037: [ When indicating pending send frames as cancelled the callback context passed to the on_ws_send_frame_complete callback shall be the context given to uws_client_send_frame_async. ]*/
 TEST_FUNCTION(uws_client_close_async_with_1_pending_send_frames_indicates_the_frames_as_cancelled)
@@ -2257,7 +2200,6 @@ TEST_FUNCTION(uws_client_close_async_with_1_pending_send_frames_indicates_the_fr
     int result;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    LIST_ITEM_HANDLE list_item;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -2272,14 +2214,46 @@ TEST_FUNCTION(uws_client_close_async_with_1_pending_send_frames_indicates_the_fr
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_on_io_close_complete()
         .IgnoreArgument_callback_context();
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE))
-        .CaptureReturn(&list_item);
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .ValidateArgumentValue_item_handle(&list_item);
     STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_CANCELLED));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
+
+    // act
+    result = uws_client_close_async(uws_client, test_on_ws_close_complete, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_577: [ The frames waiting to be sent because of send coalescing shall be cancelled with the other pending send frames, without being sent. ]*/
+TEST_FUNCTION(uws_client_close_async_cancels_the_coalesced_frames_without_sending_them)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    int result;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    size_t send_coalescing_size = 1000;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_send_coalescing", &send_coalescing_size);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, NULL, 0, true, test_on_ws_send_frame_complete, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_CANCELLED));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     result = uws_client_close_async(uws_client, test_on_ws_close_complete, NULL);
@@ -2293,7 +2267,7 @@ TEST_FUNCTION(uws_client_close_async_with_1_pending_send_frames_indicates_the_fr
 }
 
 /* Tests_SRS_UWS_CLIENT_01_034: [ uws_client_close_async shall obtain all the pending send frames by repetitively querying for the head of the pending IO list and freeing that head item. ]*/
-/* Tests_SRS_UWS_CLIENT_01_035: [ Obtaining the head of the pending send frames list shall be done by calling singlylinkedlist_get_head_item. ]*/
+/* Tests_SRS_UWS_CLIENT_01_035: [ Obtaining the head of the pending send frames list shall be done by taking the first entry of the list. ]*/
 /* Tests_SRS_UWS_CLIENT_01_036: [ For each pending send frame the send complete callback shall be called with UWS_SEND_FRAME_CANCELLED. ]*/
 /* Tests_SRS_UWS_CLIENT_01_037: [ When indicating pending send frames as cancelled the callback context passed to the on_ws_send_frame_complete callback shall be the context given to uws_client_send_frame_async. ]*/
 TEST_FUNCTION(uws_client_close_async_with_2_pending_send_frames_indicates_the_frames_as_cancelled)
@@ -2305,8 +2279,6 @@ TEST_FUNCTION(uws_client_close_async_with_2_pending_send_frames_indicates_the_fr
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
     const unsigned char test_frame_1[] = { 0x42 };
     const unsigned char test_frame_2[] = { 0x43, 0x44 };
-    LIST_ITEM_HANDLE list_item_1;
-    LIST_ITEM_HANDLE list_item_2;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -2322,21 +2294,10 @@ TEST_FUNCTION(uws_client_close_async_with_2_pending_send_frames_indicates_the_fr
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_on_io_close_complete()
         .IgnoreArgument_callback_context();
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE))
-        .CaptureReturn(&list_item_1);
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .ValidateArgumentValue_item_handle(&list_item_1);
     STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_CANCELLED));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE))
-        .CaptureReturn(&list_item_2);
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .ValidateArgumentValue_item_handle(&list_item_2);
     STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4249, WS_SEND_FRAME_CANCELLED));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
 
     // act
     result = uws_client_close_async(uws_client, test_on_ws_close_complete, NULL);
@@ -2388,7 +2349,6 @@ TEST_FUNCTION(uws_client_close_handshake_async_sends_the_close_frame)
         .ValidateArgumentBuffer(2, close_frame, sizeof(close_frame));
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle);
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
 
     // act
     result = uws_client_close_handshake_async(uws_client, 1002, "", test_on_ws_close_complete, (void*)0x4445);
@@ -2449,7 +2409,6 @@ TEST_FUNCTION(uws_client_close_handshake_async_with_NULL_close_complete_callback
         .ValidateArgumentBuffer(2, close_frame, sizeof(close_frame));
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle);
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
 
     // act
     result = uws_client_close_handshake_async(uws_client, 1002, "", NULL, NULL);
@@ -2496,7 +2455,6 @@ TEST_FUNCTION(uws_client_close_handshake_async_with_NULL_context_is_allowed)
         .ValidateArgumentBuffer(2, close_frame, sizeof(close_frame));
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle);
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
 
     // act
     result = uws_client_close_handshake_async(uws_client, 1002, "", test_on_ws_close_complete, NULL);
@@ -2840,7 +2798,8 @@ TEST_FUNCTION(uws_client_open_async_after_WS_OPEN_ERROR_UNDERLYING_IO_OPEN_CANCE
 /* Tests_SRS_UWS_CLIENT_01_101: [ The request MAY include any other header fields, for example, cookies [RFC6265] and/or authentication-related header fields such as the |Authorization| header field [RFC2616], which are processed according to documents that define them. ] */
 /* Tests_SRS_UWS_CLIENT_01_089: [ The value of this header field MUST be a nonce consisting of a randomly selected 16-byte value that has been base64-encoded (see Section 4 of [RFC4648]). ]*/
 /* Tests_SRS_UWS_CLIENT_01_090: [ The nonce MUST be selected randomly for each connection. ]*/
-/* Tests_SRS_UWS_CLIENT_01_497: [ The nonce needed for the upgrade request shall be Base64 encoded with Base64_Encode_Bytes. ]*/
+/* Tests_SRS_UWS_CLIENT_01_497: [ The nonce needed for the upgrade request shall be Base64 encoded with Base64_Encode_To. ]*/
+/* Tests_SRS_UWS_CLIENT_01_581: [ The upgrade request shall be built once, with a placeholder for the Sec-WebSocket-Key value, and kept by the uws instance for the next opens. ]*/
 TEST_FUNCTION(on_underlying_io_open_complete_with_OK_prepares_and_sends_the_WebSocket_upgrade_request)
 {
     // arrange
@@ -2874,22 +2833,19 @@ TEST_FUNCTION(on_underlying_io_open_complete_with_OK_prepares_and_sends_the_WebS
         expected_nonce[i] = (unsigned char)i;
     }
 
-    STRICT_EXPECTED_CALL(Base64_Encode_Bytes(IGNORED_PTR_ARG, 16))
+    STRICT_EXPECTED_CALL(Base64_Encode_To(IGNORED_PTR_ARG, 16, IGNORED_PTR_ARG, 25))
         .ValidateArgumentBuffer(1, expected_nonce, 16);
     // get_request_headers()
     STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(malloc(strlen(req_header1_key)+strlen(req_header1_value)+2+2+1));
 
-    STRICT_EXPECTED_CALL(STRING_c_str(BASE64_ENCODED_STRING)).SetReturn("ZWRuYW1vZGU6bm9jYXBlcyE=");
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    EXPECTED_CALL(free(IGNORED_PTR_ARG)); // request headers
     STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_on_send_complete()
         .IgnoreArgument_callback_context()
         .IgnoreArgument_buffer()
         .IgnoreArgument_size();
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_delete(BASE64_ENCODED_STRING));
-    EXPECTED_CALL(free(IGNORED_PTR_ARG)); // request headers
 
     // act
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
@@ -2924,9 +2880,9 @@ TEST_FUNCTION(when_base64_encode_fails_on_underlying_io_open_complete_triggers_t
         expected_nonce[i] = (unsigned char)i;
     }
 
-    STRICT_EXPECTED_CALL(Base64_Encode_Bytes(IGNORED_PTR_ARG, 16))
+    STRICT_EXPECTED_CALL(Base64_Encode_To(IGNORED_PTR_ARG, 16, IGNORED_PTR_ARG, 25))
         .ValidateArgumentBuffer(1, expected_nonce, 16)
-        .SetReturn(NULL);
+        .SetReturn(1);
     STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_BASE64_ENCODE_FAILED));
 
     // act
@@ -2962,19 +2918,17 @@ TEST_FUNCTION(when_allocating_memory_for_the_websocket_upgrade_request_fails_the
         expected_nonce[i] = (unsigned char)i;
     }
 
-    STRICT_EXPECTED_CALL(Base64_Encode_Bytes(IGNORED_PTR_ARG, 16))
+    STRICT_EXPECTED_CALL(Base64_Encode_To(IGNORED_PTR_ARG, 16, IGNORED_PTR_ARG, 25))
         .ValidateArgumentBuffer(1, expected_nonce, 16);
     // get_request_headers()
     STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
 
-    STRICT_EXPECTED_CALL(STRING_c_str(BASE64_ENCODED_STRING)).SetReturn("ZWRuYW1vZGU6bm9jYXBlcyE=");
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); // empty request headers
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
     STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_NOT_ENOUGH_MEMORY));
-    STRICT_EXPECTED_CALL(STRING_delete(BASE64_ENCODED_STRING));
-    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG)); // empty request headers
 
     // act
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
@@ -3010,7 +2964,7 @@ TEST_FUNCTION(uws_client_open_async_after_WS_OPEN_ERROR_NOT_ENOUGH_MEMORY_succee
         expected_nonce[i] = (unsigned char)i;
     }
 
-    STRICT_EXPECTED_CALL(Base64_Encode_Bytes(IGNORED_PTR_ARG, 16))
+    STRICT_EXPECTED_CALL(Base64_Encode_To(IGNORED_PTR_ARG, 16, IGNORED_PTR_ARG, 25))
         .ValidateArgumentBuffer(1, expected_nonce, 16);
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
         .SetReturn(NULL);
@@ -3061,12 +3015,12 @@ TEST_FUNCTION(when_sending_the_upgrade_request_fails_the_error_WS_OPEN_ERROR_CAN
         expected_nonce[i] = (unsigned char)i;
     }
 
-    STRICT_EXPECTED_CALL(Base64_Encode_Bytes(IGNORED_PTR_ARG, 16))
+    STRICT_EXPECTED_CALL(Base64_Encode_To(IGNORED_PTR_ARG, 16, IGNORED_PTR_ARG, 25))
         .ValidateArgumentBuffer(1, expected_nonce, 16);
     STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG)); // get_request_headers(), no headers
-    STRICT_EXPECTED_CALL(STRING_c_str(BASE64_ENCODED_STRING)).SetReturn("ZWRuYW1vZGU6bm9jYXBlcyE=");
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_on_send_complete()
         .IgnoreArgument_callback_context()
@@ -3075,9 +3029,6 @@ TEST_FUNCTION(when_sending_the_upgrade_request_fails_the_error_WS_OPEN_ERROR_CAN
         .SetReturn(1);
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
     STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_CANNOT_SEND_UPGRADE_REQUEST));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(STRING_delete(BASE64_ENCODED_STRING));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
@@ -3113,14 +3064,13 @@ TEST_FUNCTION(uws_client_open_async_after_WS_OPEN_ERROR_CANNOT_SEND_UPGRADE_REQU
         expected_nonce[i] = (unsigned char)i;
     }
 
-    STRICT_EXPECTED_CALL(Base64_Encode_Bytes(IGNORED_PTR_ARG, 16))
+    STRICT_EXPECTED_CALL(Base64_Encode_To(IGNORED_PTR_ARG, 16, IGNORED_PTR_ARG, 25))
         .ValidateArgumentBuffer(1, expected_nonce, 16);
     // get_request_headers()
     STRICT_EXPECTED_CALL(Map_GetInternals(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(malloc(IGNORED_NUM_ARG));
-        
-    STRICT_EXPECTED_CALL(STRING_c_str(BASE64_ENCODED_STRING)).SetReturn("ZWRuYW1vZGU6bm9jYXBlcyE=");
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_on_send_complete()
         .IgnoreArgument_callback_context()
@@ -3150,6 +3100,55 @@ TEST_FUNCTION(uws_client_open_async_after_WS_OPEN_ERROR_CANNOT_SEND_UPGRADE_REQU
     uws_client_destroy(uws_client);
 }
 
+/* Tests_SRS_UWS_CLIENT_01_582: [ For each open only the Sec-WebSocket-Key value of the kept upgrade request shall be replaced, with the Base64 encoded nonce. ]*/
+TEST_FUNCTION(on_underlying_io_open_complete_for_a_reopen_sends_the_kept_upgrade_request)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    size_t i;
+    unsigned char expected_nonce[16];
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context()
+        .IgnoreArgument_buffer()
+        .IgnoreArgument_size()
+        .SetReturn(1);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+
+    /* get the random 16 bytes */
+    for (i = 0; i < 16; i++)
+    {
+        EXPECTED_CALL(gb_rand()).SetReturn((int)(i + 1));
+        expected_nonce[i] = (unsigned char)(i + 1);
+    }
+
+    STRICT_EXPECTED_CALL(Base64_Encode_To(IGNORED_PTR_ARG, 16, IGNORED_PTR_ARG, 25))
+        .ValidateArgumentBuffer(1, expected_nonce, 16);
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context()
+        .IgnoreArgument_buffer()
+        .IgnoreArgument_size();
+
+    // act
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
 /* Tests_SRS_UWS_CLIENT_01_407: [ When on_underlying_io_open_complete is called when the uws instance has send the upgrade request but it is waiting for the response, an error shall be reported to the user by calling the on_ws_open_complete with WS_OPEN_ERROR_MULTIPLE_UNDERLYING_IO_OPEN_EVENTS. ]*/
 TEST_FUNCTION(when_sending_the_upgrade_request_fails_the_error_WS_OPEN_ERROR_MULTIPLE_UNDERLYING_IO_OPEN_EVENTS_is_indicated)
 {
@@ -3890,7 +3889,6 @@ TEST_FUNCTION(when_a_1_byte_binary_frame_is_received_it_shall_be_indicated_to_th
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 1))
         .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
 
@@ -3927,7 +3925,6 @@ TEST_FUNCTION(when_a_1_byte_text_frame_is_received_it_shall_be_indicated_to_the_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 1))
         .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
 
@@ -3961,7 +3958,6 @@ TEST_FUNCTION(when_a_0_bytes_binary_frame_is_received_it_shall_be_indicated_to_t
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 0))
         .IgnoreArgument_buffer();
 
@@ -3995,7 +3991,6 @@ TEST_FUNCTION(when_a_0_bytes_text_frame_is_received_it_shall_be_indicated_to_the
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 0))
         .IgnoreArgument_buffer();
 
@@ -4053,8 +4048,6 @@ TEST_FUNCTION(when_a_fragmented_text_frame_is_received_it_shall_be_indicated_to_
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 255))
         .ValidateArgumentBuffer(3, result_payload, 255);
 
@@ -4115,8 +4108,6 @@ TEST_FUNCTION(when_a_fragmented_binary_frame_is_received_it_shall_be_indicated_t
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 255))
         .ValidateArgumentBuffer(3, result_payload, 255);
 
@@ -4152,9 +4143,6 @@ TEST_FUNCTION(when_a_fragmented_frame_is_interleaved_within_another_fragmented_f
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4168,6 +4156,73 @@ TEST_FUNCTION(when_a_fragmented_frame_is_interleaved_within_another_fragmented_f
     uws_client_destroy(uws_client);
 }
 
+/* Tests_SRS_UWS_CLIENT_01_637: [ When a maximum frame size is set and the header of a received frame gives it more payload than that, the connection shall be closed with a Close frame with status code 1009 and an error shall be indicated by calling the on_ws_error callback with WS_ERROR_MESSAGE_TOO_BIG. ]*/
+TEST_FUNCTION(when_a_frame_bigger_than_the_max_frame_size_is_received_there_is_an_error)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    WS_RECEIVE_LIMITS receive_limits = { 4, 0, 0 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    /* only the header, so that the frame is refused before its payload is received */
+    const unsigned char test_frame_header[] = { 0x82, 0x05 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_receive_limits", &receive_limits);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_MESSAGE_TOO_BIG));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame_header, sizeof(test_frame_header));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_638: [ When a maximum message size is set and the payload of a received data frame together with the payload of the fragments received before it for the same message is more than that, the connection shall be closed with a Close frame with status code 1009 and an error shall be indicated by calling the on_ws_error callback with WS_ERROR_MESSAGE_TOO_BIG. ]*/
+TEST_FUNCTION(when_the_fragments_of_a_message_add_up_to_more_than_the_max_message_size_there_is_an_error)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    WS_RECEIVE_LIMITS receive_limits = { 0, 3, 0 };
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char first_fragment[] = { 0x02, 0x02, 0x42, 0x43 };
+    const unsigned char last_fragment_header[] = { 0x80, 0x02 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_receive_limits", &receive_limits);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, first_fragment, sizeof(first_fragment));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_MESSAGE_TOO_BIG));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, last_fragment_header, sizeof(last_fragment_header));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
 /* Tests_SRS_UWS_CLIENT_01_213: [ A fragmented message consists of a single frame with the FIN bit clear and an opcode other than 0, followed by zero or more frames with the FIN bit clear and the opcode set to 0, and terminated by a single frame with the FIN bit set and an opcode of 0. ]*/
 /* Tests_SRS_UWS_CLIENT_01_147: [ Indicates that this is the final fragment in a message. ]*/
 /* Tests_SRS_UWS_CLIENT_01_152: [* *  %x0 denotes a continuation frame *]*/
@@ -4191,9 +4246,6 @@ TEST_FUNCTION(when_a_fragmented_frame_is_received_all_at_once_the_frame_is_indic
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 1))
         .IgnoreArgument_buffer();
@@ -4255,7 +4307,6 @@ TEST_FUNCTION(pong_frame_can_be_injected_in_middle_of_fragmented_message)
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_PONG_FRAME, IGNORED_PTR_ARG, 0, true, true, 0))
         .IgnoreArgument_payload()
         .CaptureReturn(&buffer_handle);
@@ -4270,8 +4321,6 @@ TEST_FUNCTION(pong_frame_can_be_injected_in_middle_of_fragmented_message)
     STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
         .ValidateArgumentValue_handle(&buffer_handle);
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_TEXT, IGNORED_PTR_ARG, 255))
@@ -4309,7 +4358,6 @@ TEST_FUNCTION(when_a_fragmented_control_frame_is_received_there_is_an_error)
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4322,6 +4370,161 @@ TEST_FUNCTION(when_a_fragmented_control_frame_is_received_there_is_an_error)
     uws_client_destroy(uws_client);
 }
 
+/* Tests_SRS_UWS_CLIENT_01_535: [ When fragment streaming is enabled, each fragment of a fragmented message shall be indicated as soon as it is decoded by calling on_ws_fragment_received with the message type, the fragment flags and the fragment payload, without accumulating it. ]*/
+/* Tests_SRS_UWS_CLIENT_01_536: [ The first fragment of a message shall be indicated with WS_FRAGMENT_FIRST, the final one with WS_FRAGMENT_FINAL and the ones in between with no flag set. ]*/
+TEST_FUNCTION(when_fragment_streaming_is_enabled_each_fragment_is_indicated_as_it_is_received)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    WS_FRAGMENT_STREAMING fragment_streaming;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char first_fragment[] = { 0x01, 0x03, 'a', 'b', 'c' };
+    const unsigned char middle_fragment[] = { 0x00, 0x02, 'd', 'e' };
+    const unsigned char last_fragment[] = { 0x80, 0x01, 'f' };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    fragment_streaming.on_ws_fragment_received = test_on_ws_fragment_received;
+    fragment_streaming.on_ws_fragment_received_context = (void*)0x4245;
+    (void)uws_client_set_option(uws_client, "ws_fragment_streaming", &fragment_streaming);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_fragment_received((void*)0x4245, WS_FRAME_TYPE_TEXT, WS_FRAGMENT_FIRST, IGNORED_PTR_ARG, 3))
+        .ValidateArgumentBuffer(4, "abc", 3);
+    STRICT_EXPECTED_CALL(test_on_ws_fragment_received((void*)0x4245, WS_FRAME_TYPE_TEXT, 0, IGNORED_PTR_ARG, 2))
+        .ValidateArgumentBuffer(4, "de", 2);
+    STRICT_EXPECTED_CALL(test_on_ws_fragment_received((void*)0x4245, WS_FRAME_TYPE_TEXT, WS_FRAGMENT_FINAL, IGNORED_PTR_ARG, 1))
+        .ValidateArgumentBuffer(4, "f", 1);
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, first_fragment, sizeof(first_fragment));
+    g_on_bytes_received(g_on_bytes_received_context, middle_fragment, sizeof(middle_fragment));
+    g_on_bytes_received(g_on_bytes_received_context, last_fragment, sizeof(last_fragment));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_534: [ Setting a NULL on_ws_fragment_received shall disable fragment streaming, fragmented messages being accumulated and indicated with on_ws_frame_received. ]*/
+TEST_FUNCTION(when_fragment_streaming_is_disabled_fragments_are_accumulated)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    WS_FRAGMENT_STREAMING fragment_streaming;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char first_fragment[] = { 0x02, 0x02, 0x01, 0x02 };
+    const unsigned char last_fragment[] = { 0x80, 0x01, 0x03 };
+    const unsigned char expected_payload[] = { 0x01, 0x02, 0x03 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    fragment_streaming.on_ws_fragment_received = test_on_ws_fragment_received;
+    fragment_streaming.on_ws_fragment_received_context = (void*)0x4245;
+    (void)uws_client_set_option(uws_client, "ws_fragment_streaming", &fragment_streaming);
+    fragment_streaming.on_ws_fragment_received = NULL;
+    fragment_streaming.on_ws_fragment_received_context = NULL;
+    (void)uws_client_set_option(uws_client, "ws_fragment_streaming", &fragment_streaming);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, sizeof(expected_payload)))
+        .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, first_fragment, sizeof(first_fragment));
+    g_on_bytes_received(g_on_bytes_received_context, last_fragment, sizeof(last_fragment));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_537: [ When fragment streaming is enabled and a continuation fragment is received without an initial fragment, an error shall be indicated by calling the on_ws_error callback with WS_ERROR_BAD_FRAME_RECEIVED. ]*/
+TEST_FUNCTION(when_fragment_streaming_is_enabled_a_continuation_fragment_without_an_initial_fragment_is_an_error)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    WS_FRAGMENT_STREAMING fragment_streaming;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char middle_fragment[] = { 0x00, 0x02, 'd', 'e' };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    fragment_streaming.on_ws_fragment_received = test_on_ws_fragment_received;
+    fragment_streaming.on_ws_fragment_received_context = (void*)0x4245;
+    (void)uws_client_set_option(uws_client, "ws_fragment_streaming", &fragment_streaming);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, middle_fragment, sizeof(middle_fragment));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_539: [ If a fragmented message is being received, setting ws_fragment_streaming shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_fragment_streaming_while_a_fragmented_message_is_received_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    WS_FRAGMENT_STREAMING fragment_streaming;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char first_fragment[] = { 0x01, 0x03, 'a', 'b', 'c' };
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, first_fragment, sizeof(first_fragment));
+    fragment_streaming.on_ws_fragment_received = test_on_ws_fragment_received;
+    fragment_streaming.on_ws_fragment_received_context = (void*)0x4245;
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_option(uws_client, "ws_fragment_streaming", &fragment_streaming);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
 /* Tests_SRS_UWS_CLIENT_01_163: [ The length of the "Payload data", in bytes: ]*/
 /* Tests_SRS_UWS_CLIENT_01_164: [ if 0-125, that is the payload length. ]*/
 /* Tests_SRS_UWS_CLIENT_01_264: [ The "Payload data" is arbitrary binary data whose interpretation is solely up to the application layer. ]*/
@@ -4604,7 +4807,6 @@ TEST_FUNCTION(when_a_0_byte_binary_frame_is_received_with_16_bit_length_an_error
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4674,7 +4876,6 @@ TEST_FUNCTION(when_a_0_byte_binary_frame_is_received_with_64_bit_length_an_error
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4755,7 +4956,6 @@ TEST_FUNCTION(check_for_16_bit_length_too_low_is_done_as_soon_as_length_is_recei
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4787,7 +4987,6 @@ TEST_FUNCTION(check_for_64_bit_length_too_low_is_done_as_soon_as_length_is_recei
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_BAD_FRAME_RECEIVED));
 
     // act
@@ -4856,7 +5055,8 @@ TEST_FUNCTION(when_allocating_memory_for_the_received_frame_bytes_fails_an_error
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    unsigned char test_frame[] = { 0x82, 0x00 };
+    /* bigger than the memory allocated for the upgrade response, so that it has to be reallocated */
+    unsigned char test_frame[62 + 2] = { 0x82, 0x3E };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -4881,6 +5081,187 @@ TEST_FUNCTION(when_allocating_memory_for_the_received_frame_bytes_fails_an_error
     uws_client_destroy(uws_client);
 }
 
+/* Tests_SRS_UWS_CLIENT_01_532: [ The memory used for accumulating received bytes shall only be reallocated when the bytes not yet decoded together with the new bytes do not fit in it. ]*/
+TEST_FUNCTION(frames_split_across_several_receive_calls_reuse_the_memory_of_the_stream_buffer)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char test_frames[] = { 0x82, 0x01, 0x42, 0x82, 0x02, 0x43, 0x44, 0x82, 0x01, 0x45 };
+    const unsigned char expected_payload_1[] = { 0x42 };
+    const unsigned char expected_payload_2[] = { 0x43, 0x44 };
+    const unsigned char expected_payload_3[] = { 0x45 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 1))
+        .ValidateArgumentBuffer(3, expected_payload_1, sizeof(expected_payload_1));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 2))
+        .ValidateArgumentBuffer(3, expected_payload_2, sizeof(expected_payload_2));
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 1))
+        .ValidateArgumentBuffer(3, expected_payload_3, sizeof(expected_payload_3));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frames, 5);
+    g_on_bytes_received(g_on_bytes_received_context, test_frames + 5, 4);
+    g_on_bytes_received(g_on_bytes_received_context, test_frames + 9, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_633: [ If a receive buffer size is set and the uws instance is still accumulating received bytes, on_underlying_io_bytes_received shall lend the memory after the bytes not yet decoded to the underlying IO by calling xio_set_receive_buffer, growing it to the receive buffer size first when less than half of that is left. ]*/
+TEST_FUNCTION(with_a_receive_buffer_size_the_memory_after_the_pending_bytes_is_lent_to_the_underlying_io)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    size_t receive_buffer_size = 64;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char test_frame[] = { 0x82, 0x01, 0x42 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_receive_buffer_size", &receive_buffer_size);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 1))
+        .IgnoreArgument_buffer();
+    STRICT_EXPECTED_CALL(xio_set_receive_buffer(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(test_upgrade_response) - 1))
+        .IgnoreArgument_buffer();
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_NOT_NULL(g_lent_receive_buffer);
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_634: [ Bytes received in the memory lent with xio_set_receive_buffer shall be accumulated without being copied. ]*/
+TEST_FUNCTION(bytes_received_in_the_lent_memory_are_decoded_in_place)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    size_t receive_buffer_size = 64;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char test_frame[] = { 0x82, 0x02, 0x42, 0x43 };
+    const unsigned char expected_payload[] = { 0x42, 0x43 };
+    unsigned char* lent_receive_buffer;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_receive_buffer_size", &receive_buffer_size);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    lent_receive_buffer = g_lent_receive_buffer;
+    ASSERT_IS_NOT_NULL(lent_receive_buffer);
+    ASSERT_IS_TRUE(g_lent_receive_buffer_size >= sizeof(test_frame));
+    (void)memcpy(lent_receive_buffer, test_frame, sizeof(test_frame));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, sizeof(expected_payload)))
+        .ValidateArgumentBuffer(3, expected_payload, sizeof(expected_payload));
+    STRICT_EXPECTED_CALL(xio_set_receive_buffer(TEST_IO_HANDLE, lent_receive_buffer, sizeof(test_upgrade_response) - 1));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, lent_receive_buffer, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_636: [ If xio_set_receive_buffer fails, the memory shall not be lent again until the next uws_client_open_async. ]*/
+TEST_FUNCTION(when_xio_set_receive_buffer_fails_the_memory_is_not_lent_again)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    size_t receive_buffer_size = 64;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char test_frame[] = { 0x82, 0x01, 0x42 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_receive_buffer_size", &receive_buffer_size);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_set_receive_buffer(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_NUM_ARG))
+        .SetReturn(1);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 1))
+        .IgnoreArgument_buffer();
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_frame, sizeof(test_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_635: [ If a receive buffer size is set, uws_client_destroy shall call xio_set_receive_buffer with NULL and 0 before freeing the memory used for accumulating received bytes. ]*/
+TEST_FUNCTION(uws_client_destroy_takes_back_the_lent_memory)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    size_t receive_buffer_size = 64;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_receive_buffer_size", &receive_buffer_size);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    ASSERT_IS_NOT_NULL(g_lent_receive_buffer);
+    umock_c_reset_all_calls();
+
+    // act
+    uws_client_destroy(uws_client);
+
+    // assert
+    ASSERT_IS_NULL(g_lent_receive_buffer);
+    ASSERT_ARE_EQUAL(size_t, 0, g_lent_receive_buffer_size);
+}
+
 /* Tests_SRS_UWS_CLIENT_01_384: [ Any extra bytes that are left unconsumed after decoding a succesfull WebSocket upgrade response shall be used for decoding WebSocket frames ]*/
 TEST_FUNCTION(when_1_byte_is_received_together_with_the_upgrade_request_and_one_byte_with_a_separate_call_decoding_frame_succeeds)
 {
@@ -4903,7 +5284,6 @@ TEST_FUNCTION(when_1_byte_is_received_together_with_the_upgrade_request_and_one_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)upgrade_response_frame, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(test_on_ws_frame_received((void*)0x4243, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, 0))
         .IgnoreArgument_buffer();
 
@@ -5063,7 +5443,6 @@ TEST_FUNCTION(when_a_masked_frame_is_received_an_error_is_indicated_and_connecti
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
         .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
         .CaptureReturn(&buffer_handle);
@@ -5115,7 +5494,6 @@ TEST_FUNCTION(when_a_masked_frame_is_received_and_encoding_the_close_frame_fails
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
         .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
         .SetReturn(NULL);
@@ -5155,7 +5533,6 @@ TEST_FUNCTION(when_a_masked_frame_is_received_and_sending_the_encoded_CLOSE_fram
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, IGNORED_PTR_ARG, sizeof(close_frame_payload), true, true, 0))
         .ValidateArgumentBuffer(2, close_frame_payload, sizeof(close_frame_payload))
         .CaptureReturn(&buffer_handle);
@@ -5213,7 +5590,6 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_the_code_is_reported_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .CaptureReturn(&buffer_handle);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
@@ -5266,7 +5642,6 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_without_a_close_code_while_in_open_
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .CaptureReturn(&buffer_handle);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
@@ -5317,7 +5692,6 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_with_extra_bytes_the_bytes_are_pass
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(utf8_checker_is_valid_utf8(IGNORED_PTR_ARG, 2))
         .ValidateArgumentBuffer(1, &close_frame[4], 2);
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
@@ -5367,7 +5741,6 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_with_a_malformed_UTF8_text_the_conn
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(utf8_checker_is_valid_utf8(IGNORED_PTR_ARG, 1))
         .ValidateArgumentBuffer(1, &close_frame[4], 1)
         .SetReturn(false);
@@ -5408,7 +5781,6 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_and_encoding_the_outg
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
@@ -5450,7 +5822,6 @@ TEST_FUNCTION(when_a_CLOSE_frame_is_received_while_in_open_and_sending_the_outgo
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .CaptureReturn(&buffer_handle);
     STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
@@ -5650,10 +6021,9 @@ TEST_FUNCTION(uws_client_send_frame_async_when_waiting_for_upgrade_response_fail
 /* Tests_SRS_UWS_CLIENT_01_040: [ - the send complete callback on_ws_send_frame_complete ]*/
 /* Tests_SRS_UWS_CLIENT_01_056: [ - the send_complete callback shall be the on_underlying_io_send_complete function. ]*/
 /* Tests_SRS_UWS_CLIENT_01_042: [ On success, uws_client_send_frame_async shall return 0. ]*/
-/* Tests_SRS_UWS_CLIENT_01_425: [ Encoding shall be done by calling uws_frame_encoder_encode and passing to it the buffer and size argument for payload, the is_final flag and setting is_masked to true. ]*/
-/* Tests_SRS_UWS_CLIENT_01_428: [ The encoded frame buffer memory shall be obtained by calling BUFFER_u_char on the encode buffer. ]*/
-/* Tests_SRS_UWS_CLIENT_01_429: [ The encoded frame size shall be obtained by calling BUFFER_length on the encode buffer. ]*/
-/* Tests_SRS_UWS_CLIENT_01_048: [ Queueing shall be done by calling singlylinkedlist_add. ]*/
+/* Tests_SRS_UWS_CLIENT_01_425: [ Encoding shall be done by calling uws_frame_encoder_encode_header with the size of the payload, the is_final flag and is_masked set to true, and then masking the payload behind the header with uws_frame_encoder_mask. ]*/
+/* Tests_SRS_UWS_CLIENT_01_565: [ The frame shall be laid out in a send buffer that the uws instance keeps for the next frames, grown with realloc when it cannot hold the largest header and the payload. ]*/
+/* Tests_SRS_UWS_CLIENT_01_048: [ Queueing shall be done by inserting the list entry embedded in the pending send at the tail of the pending send list, without allocating. ]*/
 /* Tests_SRS_UWS_CLIENT_01_038: [ uws_client_send_frame_async shall create and queue a structure that contains: ]*/
 /* Tests_SRS_UWS_CLIENT_01_040: [ - the send complete callback on_ws_send_frame_complete ]*/
 /* Tests_SRS_UWS_CLIENT_01_041: [ - the send complete callback context on_ws_send_frame_complete_context ]*/
@@ -5669,9 +6039,8 @@ TEST_FUNCTION(uws_client_send_frame_async_succeeds)
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
     unsigned char test_payload[] = { 0x42 };
-    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
+    unsigned char encoded_frame[] = { 0x82, 0x81, 0x00, 0x00, 0x00, 0x00, 0x42 };
     int result;
-    BUFFER_HANDLE buffer_handle;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -5683,22 +6052,13 @@ TEST_FUNCTION(uws_client_send_frame_async_succeeds)
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(encoded_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item();
+    EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload, sizeof(test_payload), IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_on_send_complete()
         .IgnoreArgument_callback_context()
         .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
 
     // act
     result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
@@ -5719,9 +6079,8 @@ TEST_FUNCTION(uws_send_text_frame_succeeds)
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
     unsigned char test_payload[] = { 'a' };
-    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 'a' };
+    unsigned char encoded_frame[] = { 0x81, 0x81, 0x00, 0x00, 0x00, 0x00, 'a' };
     int result;
-    BUFFER_HANDLE buffer_handle;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -5733,22 +6092,13 @@ TEST_FUNCTION(uws_send_text_frame_succeeds)
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_TEXT_FRAME, test_payload, sizeof(test_payload), true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(encoded_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item();
+    EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(WS_TEXT_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload, sizeof(test_payload), IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_on_send_complete()
         .IgnoreArgument_callback_context()
         .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
 
     // act
     result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_TEXT, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
@@ -5794,7 +6144,7 @@ TEST_FUNCTION(when_allocating_memory_for_the_new_sent_item_fails_uws_client_send
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_426: [ If uws_frame_encoder_encode fails, uws_client_send_frame_async shall fail and return a non-zero value. ]*/
+/* Tests_SRS_UWS_CLIENT_01_426: [ If uws_frame_encoder_encode_header fails, uws_client_send_frame_async shall fail and return a non-zero value. ]*/
 TEST_FUNCTION(when_encoding_the_frame_fails_uws_client_send_frame_async_fails)
 {
     // arrange
@@ -5814,8 +6164,9 @@ TEST_FUNCTION(when_encoding_the_frame_fails_uws_client_send_frame_async_fails)
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
-        .SetReturn(NULL);
+    EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
@@ -5829,27 +6180,19 @@ TEST_FUNCTION(when_encoding_the_frame_fails_uws_client_send_frame_async_fails)
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_058: [ If xio_send fails, uws_client_send_frame_async shall fail and return a non-zero value. ]*/
-/* Tests_SRS_UWS_CLIENT_09_001: [ If xio_send fails and the message is still queued, it shall be de-queued and destroyed. ] */
-TEST_FUNCTION(when_xio_send_fails_uws_client_send_frame_async_fails)
+/* Tests_SRS_UWS_CLIENT_01_566: [ If growing the send buffer fails, uws_client_send_frame_async shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_growing_the_send_buffer_fails_uws_client_send_frame_async_fails)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
     unsigned char test_payload[] = { 0x42 };
-    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
     int result;
-    BUFFER_HANDLE buffer_handle;
-    LIST_ITEM_HANDLE new_item_handle;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(BUFFER_new())
-        .CaptureReturn(&buffer_handle);
-
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
@@ -5857,29 +6200,9 @@ TEST_FUNCTION(when_xio_send_fails_uws_client_send_frame_async_fails)
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(encoded_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item()
-        .CaptureReturn(&new_item_handle);
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_send_complete()
-        .IgnoreArgument_callback_context()
-        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame))
-        .SetReturn(1);
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .SetReturn((LIST_ITEM_HANDLE)0x1234);
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .ValidateArgumentValue_item_handle(&new_item_handle);
+    EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
 
     // act
     result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
@@ -5892,87 +6215,147 @@ TEST_FUNCTION(when_xio_send_fails_uws_client_send_frame_async_fails)
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_09_001: [ If xio_send fails and the message is still queued, it shall be de-queued and destroyed. ] */
-TEST_FUNCTION(when_xio_send_fails_uws_client_send_frame_async_fails_message_removed_by_xio_send)
+/* Tests_SRS_UWS_CLIENT_01_565: [ The frame shall be laid out in a send buffer that the uws instance keeps for the next frames, grown with realloc when it cannot hold the largest header and the payload. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_reuses_the_send_buffer_of_the_previous_frame)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
     unsigned char test_payload[] = { 0x42 };
-    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
+    unsigned char encoded_frame[] = { 0x82, 0x81, 0x00, 0x00, 0x00, 0x00, 0x42 };
     int result;
-    BUFFER_HANDLE buffer_handle;
-    LIST_ITEM_HANDLE new_item_handle;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(BUFFER_new())
-        .CaptureReturn(&buffer_handle);
-
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(encoded_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item()
-        .CaptureReturn(&new_item_handle);
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload, sizeof(test_payload), IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_on_send_complete()
         .IgnoreArgument_callback_context()
         .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(singlylinkedlist_find(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .SetReturn(NULL);
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
 
-    // section for on_io_send_complete()
-    g_xio_send_result = 1;
-    STRICT_EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete(IGNORED_PTR_ARG, WS_SEND_FRAME_ERROR));
-    STRICT_EXPECTED_CALL(free(IGNORED_PTR_ARG));
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_571: [ When send coalescing is enabled or frames are waiting to be sent, the frame shall be left in the send buffer behind the frames waiting to be sent instead of being sent with xio_send, and uws_client_send_frame_async shall return 0. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_with_send_coalescing_does_not_send_the_frame)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    unsigned char test_payload[] = { 0x42 };
+    size_t send_coalescing_size = 1000;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_send_coalescing", &send_coalescing_size);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload, sizeof(test_payload), IGNORED_PTR_ARG));
 
     // act
     result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
-    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_ERROR);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_049: [ If singlylinkedlist_add fails, uws_client_send_frame_async shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(when_adding_the_item_to_the_list_fails_uws_client_send_frame_async_fails)
+/* Tests_SRS_UWS_CLIENT_01_572: [ Once the frames waiting to be sent reach the send coalescing size, they shall be sent with one xio_send. ]*/
+TEST_FUNCTION(when_the_coalesced_frames_reach_the_send_coalescing_size_uws_client_send_frame_async_sends_them)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    unsigned char test_payload_1[] = { 0x42 };
+    unsigned char test_payload_2[] = { 0x43 };
+    unsigned char encoded_frames[] = { 0x82, 0x81, 0x00, 0x00, 0x00, 0x00, 0x42, 0x82, 0x81, 0x00, 0x00, 0x00, 0x00, 0x43 };
+    size_t send_coalescing_size = sizeof(encoded_frames);
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_send_coalescing", &send_coalescing_size);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload_1, sizeof(test_payload_1), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(WS_BINARY_FRAME, sizeof(test_payload_2), true, true, 0, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload_2, sizeof(test_payload_2), IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frames), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context()
+        .ValidateArgumentBuffer(2, encoded_frames, sizeof(encoded_frames));
+
+    // act
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload_2, sizeof(test_payload_2), true, test_on_ws_send_frame_complete, (void*)0x4249);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_058: [ If xio_send fails, uws_client_send_frame_async shall fail and return a non-zero value. ]*/
+/* Tests_SRS_UWS_CLIENT_09_001: [ If xio_send fails and the message is still queued, it shall be de-queued and destroyed. ] */
+TEST_FUNCTION(when_xio_send_fails_uws_client_send_frame_async_fails)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
     unsigned char test_payload[] = { 0x42 };
-    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
+    unsigned char encoded_frame[] = { 0x82, 0x81, 0x00, 0x00, 0x00, 0x00, 0x42 };
     int result;
     BUFFER_HANDLE buffer_handle;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_new())
+        .CaptureReturn(&buffer_handle);
+
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
@@ -5980,20 +6363,15 @@ TEST_FUNCTION(when_adding_the_item_to_the_list_fails_uws_client_send_frame_async
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(encoded_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item()
-        .SetReturn(NULL);
+    EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload, sizeof(test_payload), IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context()
+        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame))
+        .SetReturn(1);
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
 
     // act
     result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
@@ -6006,68 +6384,68 @@ TEST_FUNCTION(when_adding_the_item_to_the_list_fails_uws_client_send_frame_async
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_050: [ The argument on_ws_send_frame_complete shall be optional, if NULL is passed by the caller then no send complete callback shall be triggered. ]*/
-TEST_FUNCTION(uws_client_send_frame_async_with_NULL_complete_callback_succeeds)
+/* Tests_SRS_UWS_CLIENT_09_001: [ If xio_send fails and the message is still queued, it shall be de-queued and destroyed. ] */
+TEST_FUNCTION(when_xio_send_fails_uws_client_send_frame_async_fails_message_removed_by_xio_send)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
     unsigned char test_payload[] = { 0x42 };
-    unsigned char encoded_frame[] = { 0x82, 0x01, 0x00, 0x00, 0x00, 0x00, 0x42 };
+    unsigned char encoded_frame[] = { 0x82, 0x81, 0x00, 0x00, 0x00, 0x00, 0x42 };
     int result;
     BUFFER_HANDLE buffer_handle;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_new())
+        .CaptureReturn(&buffer_handle);
+
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_BINARY_FRAME, test_payload, sizeof(test_payload), true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(encoded_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload, sizeof(test_payload), IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .IgnoreArgument_on_send_complete()
         .IgnoreArgument_callback_context()
         .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame));
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
+
+    // section for on_io_send_complete() called from within xio_send
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_ERROR));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    g_xio_send_result = 1;
+    g_xio_send_completes_with_error = true;
 
     // act
-    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, NULL, NULL);
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* on_underlying_io_send_complete */
-
-/* Tests_SRS_UWS_CLIENT_01_389: [ When on_underlying_io_send_complete is called with IO_SEND_OK as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling on_ws_send_frame_complete with WS_SEND_FRAME_OK. ]*/
-/* Tests_SRS_UWS_CLIENT_01_432: [ The indicated sent frame shall be removed from the list by calling singlylinkedlist_remove. ]*/
-/* Tests_SRS_UWS_CLIENT_01_434: [ The memory associated with the sent frame shall be freed. ]*/
-TEST_FUNCTION(on_underlying_io_send_complete_with_OK_indicates_the_frame_as_sent_OK)
+/* Tests_SRS_UWS_CLIENT_01_050: [ The argument on_ws_send_frame_complete shall be optional, if NULL is passed by the caller then no send complete callback shall be triggered. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_with_NULL_complete_callback_succeeds)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
     unsigned char test_payload[] = { 0x42 };
+    unsigned char encoded_frame[] = { 0x82, 0x81, 0x00, 0x00, 0x00, 0x00, 0x42 };
+    int result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -6076,27 +6454,34 @@ TEST_FUNCTION(on_underlying_io_send_complete_with_OK_indicates_the_frame_as_sent
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
-    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item_handle();
-    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4245, WS_SEND_FRAME_OK));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(WS_BINARY_FRAME, sizeof(test_payload), true, true, 0, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, test_payload, sizeof(test_payload), IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context()
+        .ValidateArgumentBuffer(2, encoded_frame, sizeof(encoded_frame));
 
     // act
-    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, NULL, NULL);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_433: [ If singlylinkedlist_remove fails an error shall be indicated by calling the on_ws_error callback with WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST. ]*/
-TEST_FUNCTION(when_removing_the_sent_framefrom_the_list_fails_then_an_error_is_indicated)
+/* on_underlying_io_send_complete */
+
+/* Tests_SRS_UWS_CLIENT_01_389: [ When on_underlying_io_send_complete is called with IO_SEND_OK as a result of sending a WebSocket frame to the underlying IO, the send shall be indicated to the uws user by calling on_ws_send_frame_complete with WS_SEND_FRAME_OK. ]*/
+/* Tests_SRS_UWS_CLIENT_01_432: [ The indicated sent frame shall be removed from the list by unlinking the list entry embedded in it. ]*/
+/* Tests_SRS_UWS_CLIENT_01_434: [ The memory associated with the sent frame shall be freed. ]*/
+TEST_FUNCTION(on_underlying_io_send_complete_with_OK_indicates_the_frame_as_sent_OK)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
@@ -6114,11 +6499,8 @@ TEST_FUNCTION(when_removing_the_sent_framefrom_the_list_fails_then_an_error_is_i
     (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item_handle()
-        .SetReturn(1);
-    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_CANNOT_REMOVE_SENT_ITEM_FROM_LIST));
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4245, WS_SEND_FRAME_OK));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
@@ -6149,9 +6531,6 @@ TEST_FUNCTION(on_underlying_io_send_complete_with_ERROR_indicates_the_frame_with
     (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item_handle();
     STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4245, WS_SEND_FRAME_ERROR));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
@@ -6184,9 +6563,6 @@ TEST_FUNCTION(on_underlying_io_send_complete_with_CANCELLED_indicates_the_frame_
     (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item_handle();
     STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4245, WS_SEND_FRAME_CANCELLED));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
@@ -6248,9 +6624,6 @@ TEST_FUNCTION(on_underlying_io_send_complete_with_an_unknown_result_indicates_an
     (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4245);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .IgnoreArgument_item_handle();
     STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4245, WS_SEND_FRAME_ERROR));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
@@ -6327,28 +6700,38 @@ TEST_FUNCTION(uws_client_dowork_when_closed_does_nothing)
     uws_client_destroy(uws_client);
 }
 
-/* on_underlying_io_error */
-
-/* Tests_SRS_UWS_CLIENT_01_375: [ When on_underlying_io_error is called while uws is OPENING, uws shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_UNDERLYING_IO_ERROR. ]*/
-/* Tests_SRS_UWS_CLIENT_01_077: [ If this fails (e.g., the server's certificate could not be verified), then the client MUST _Fail the WebSocket Connection_ and abort the connection. ]*/
-TEST_FUNCTION(on_underlying_io_error_while_opening_underlying_io_indicates_an_open_complete_with_WS_OPEN_ERROR_UNDERLYING_IO_ERROR)
+/* Tests_SRS_UWS_CLIENT_01_573: [ uws_client_dowork shall send the frames waiting because of send coalescing with one xio_send before calling xio_dowork. ]*/
+TEST_FUNCTION(uws_client_dowork_sends_the_coalesced_frames_with_one_xio_send)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    unsigned char test_payload_1[] = { 0x42 };
+    unsigned char test_payload_2[] = { 0x43 };
+    unsigned char encoded_frames[] = { 0x82, 0x81, 0x00, 0x00, 0x00, 0x00, 0x42, 0x82, 0x81, 0x00, 0x00, 0x00, 0x00, 0x43 };
+    size_t send_coalescing_size = 1000;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_send_coalescing", &send_coalescing_size);
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload_1, sizeof(test_payload_1), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload_2, sizeof(test_payload_2), true, test_on_ws_send_frame_complete, (void*)0x4249);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
-    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_UNDERLYING_IO_ERROR));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_frames), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context()
+        .ValidateArgumentBuffer(2, encoded_frames, sizeof(encoded_frames));
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
 
     // act
-    g_on_io_error(g_on_io_error_context);
+    uws_client_dowork(uws_client);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -6357,127 +6740,144 @@ TEST_FUNCTION(on_underlying_io_error_while_opening_underlying_io_indicates_an_op
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_375: [ When on_underlying_io_error is called while uws is OPENING, uws shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_UNDERLYING_IO_ERROR. ]*/
-TEST_FUNCTION(on_underlying_io_error_while_waiting_for_upgrade_response_indicates_an_open_complete_with_WS_OPEN_ERROR_UNDERLYING_IO_ERROR)
+/* uws_client_dowork_ex */
+
+/* Tests_SRS_UWS_CLIENT_01_597: [ If uws_client, made_progress or next_deadline_us is NULL, uws_client_dowork_ex shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_dowork_ex_with_NULL_handle_fails)
+{
+    // arrange
+    bool made_progress;
+    uint64_t next_deadline_us;
+    int result;
+
+    // act
+    result = uws_client_dowork_ex(NULL, &made_progress, &next_deadline_us);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_CLIENT_01_599: [ Otherwise uws_client_dowork_ex shall send the frames waiting because of send coalescing and call xio_dowork_ex on the underlying IO, passing next_deadline_us down to it. ]*/
+/* Tests_SRS_UWS_CLIENT_01_600: [ made_progress shall be set to true if frames waiting because of send coalescing were sent, a callback was made or the underlying IO made progress, false otherwise. ]*/
+/* Tests_SRS_UWS_CLIENT_01_602: [ On success uws_client_dowork_ex shall return 0. ]*/
+TEST_FUNCTION(uws_client_dowork_ex_calls_the_underlying_io_dowork_ex)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
+    bool made_progress = true;
+    bool underlying_progress = false;
+    uint64_t next_deadline_us;
+    int result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
-    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_UNDERLYING_IO_ERROR));
+    STRICT_EXPECTED_CALL(xio_dowork_ex(TEST_IO_HANDLE, IGNORED_PTR_ARG, &next_deadline_us))
+        .CopyOutArgumentBuffer_made_progress(&underlying_progress, sizeof(underlying_progress));
 
     // act
-    g_on_io_error(g_on_io_error_context);
+    result = uws_client_dowork_ex(uws_client, &made_progress, &next_deadline_us);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(made_progress);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_376: [ When on_underlying_io_error is called while the uws instance is OPEN, an error shall be reported to the user by calling the on_ws_error callback that was passed to uws_client_open_async with the argument WS_ERROR_UNDERLYING_IO_ERROR. ]*/
-/* Tests_SRS_UWS_CLIENT_01_318: [ Servers MAY close the WebSocket connection whenever desired. ]*/
-/* Tests_SRS_UWS_CLIENT_01_269: [ If at any point the state of the WebSocket connection changes, the endpoint MUST abort the following steps. ]*/
-TEST_FUNCTION(on_underlying_io_error_while_OPEN_indicates_an_error)
+/* Tests_SRS_UWS_CLIENT_01_598: [ If the IO is not yet open, uws_client_dowork_ex shall set made_progress to false, set next_deadline_us to XIO_NO_DEADLINE and return 0. ]*/
+TEST_FUNCTION(uws_client_dowork_ex_when_closed_reports_no_progress)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    bool made_progress = true;
+    uint64_t next_deadline_us = 0;
+    int result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_UNDERLYING_IO_ERROR));
-
     // act
-    g_on_io_error(g_on_io_error_context);
+    result = uws_client_dowork_ex(uws_client, &made_progress, &next_deadline_us);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(made_progress);
+    ASSERT_IS_TRUE(next_deadline_us == XIO_NO_DEADLINE);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_377: [ When on_underlying_io_error is called while the uws instance is CLOSING the underlying IO shall be closed by calling xio_close. ]*/
-TEST_FUNCTION(on_underlying_io_error_while_CLOSING_indicates_an_error)
+/* Tests_SRS_UWS_CLIENT_01_601: [ If xio_dowork_ex fails, made_progress shall be set to true and next_deadline_us to XIO_NO_DEADLINE. ]*/
+TEST_FUNCTION(when_xio_dowork_ex_fails_uws_client_dowork_ex_reports_progress)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char close_frame[] = { 0x88, 0x00 };
+    bool made_progress = false;
+    uint64_t next_deadline_us = 0;
+    int result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(xio_dowork_ex(TEST_IO_HANDLE, IGNORED_PTR_ARG, &next_deadline_us))
+        .SetReturn(1);
 
     // act
-    g_on_io_error(g_on_io_error_context);
+    result = uws_client_dowork_ex(uws_client, &made_progress, &next_deadline_us);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(made_progress);
+    ASSERT_IS_TRUE(next_deadline_us == XIO_NO_DEADLINE);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_377: [ When on_underlying_io_error is called while the uws instance is CLOSING the underlying IO shall be closed by calling xio_close. ]*/
-TEST_FUNCTION(open_after_error_during_sending_close_succeeds)
+/* uws_client_get_pollable_handle */
+
+/* Tests_SRS_UWS_CLIENT_01_604: [ uws_client_get_pollable_handle shall call xio_get_pollable_handle on the underlying IO, passing pollable_handle and wanted_events down to it. ]*/
+/* Tests_SRS_UWS_CLIENT_01_606: [ On success uws_client_get_pollable_handle shall return 0. ]*/
+TEST_FUNCTION(uws_client_get_pollable_handle_calls_the_underlying_io)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char close_frame[] = { 0x88, 0x00 };
+    intptr_t pollable_handle;
+    unsigned int wanted_events;
     int result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
-    g_on_io_error(g_on_io_error_context);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_io_open_complete()
-        .IgnoreArgument_on_io_open_complete_context()
-        .IgnoreArgument_on_bytes_received()
-        .IgnoreArgument_on_bytes_received_context()
-        .IgnoreArgument_on_io_error()
-        .IgnoreArgument_on_io_error_context();
+    STRICT_EXPECTED_CALL(xio_get_pollable_handle(TEST_IO_HANDLE, &pollable_handle, &wanted_events));
 
     // act
-    result = uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    result = uws_client_get_pollable_handle(uws_client, &pollable_handle, &wanted_events);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
@@ -6487,140 +6887,147 @@ TEST_FUNCTION(open_after_error_during_sending_close_succeeds)
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_377: [ When on_underlying_io_error is called while the uws instance is CLOSING the underlying IO shall be closed by calling xio_close. ]*/
-/* Tests_SRS_UWS_CLIENT_01_499: [ If the CLOSE was due to the peer closing, the callback on_ws_close_complete shall not be called. ]*/
-TEST_FUNCTION(on_underlying_io_error_while_CLOSING_underlying_io_indicates_the_close)
+/* Tests_SRS_UWS_CLIENT_01_605: [ If xio_get_pollable_handle fails, uws_client_get_pollable_handle shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_xio_get_pollable_handle_fails_uws_client_get_pollable_handle_fails)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char close_frame[] = { 0x88, 0x00 };
+    intptr_t pollable_handle;
+    unsigned int wanted_events;
+    int result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
-    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
-    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_callback_context()
-        .IgnoreArgument_on_io_close_complete();
+    STRICT_EXPECTED_CALL(xio_get_pollable_handle(TEST_IO_HANDLE, &pollable_handle, &wanted_events))
+        .SetReturn(1);
 
     // act
-    g_on_io_error(g_on_io_error_context);
+    result = uws_client_get_pollable_handle(uws_client, &pollable_handle, &wanted_events);
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_377: [ When on_underlying_io_error is called while the uws instance is CLOSING the underlying IO shall be closed by calling xio_close. ]*/
-TEST_FUNCTION(open_after_error_during_closing_underlying_io_succeeds)
+/* Tests_SRS_UWS_CLIENT_01_574: [ When the frames sent by one xio_send complete, each of them shall be indicated in the order it was sent, as if it had been sent alone. ]*/
+TEST_FUNCTION(when_the_coalesced_frames_are_sent_the_frame_is_indicated_as_sent)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char close_frame[] = { 0x88, 0x00 };
-    int result;
+    unsigned char test_payload[] = { 0x42 };
+    size_t send_coalescing_size = 1000;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_send_coalescing", &send_coalescing_size);
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
-    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
-    g_on_io_error(g_on_io_error_context);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    uws_client_dowork(uws_client);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_io_open_complete()
-        .IgnoreArgument_on_io_open_complete_context()
-        .IgnoreArgument_on_bytes_received()
-        .IgnoreArgument_on_bytes_received_context()
-        .IgnoreArgument_on_io_error()
-        .IgnoreArgument_on_io_error_context();
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_OK));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
-    result = uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_500: [ If xio_close fails then the callback on_ws_close_complete shall be called, while passing the on_ws_close_complete_context argument to it. ]*/
-/* Tests_SRS_UWS_CLIENT_01_500: [ The callback on_ws_close_complete shall be called, while passing the on_ws_close_complete_context argument to it. ]*/
-TEST_FUNCTION(on_underlying_io_error_while_CLOSING_due_to_local_initiated_close)
+/* Tests_SRS_UWS_CLIENT_01_588: [ When a send fragment size is set, a data frame with more payload than that, and any data frame sent while messages are waiting to be sent as fragments, shall be copied and sent as fragments of at most that size, only the first one having the opcode and RSV bits of the frame and only the last one having the FIN bit of the frame, and uws_client_send_frame_async shall return 0. ]*/
+TEST_FUNCTION(uws_client_send_frame_async_with_more_payload_than_the_send_fragment_size_sends_the_first_fragment)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    unsigned char test_payload[] = { 0x42, 0x43 };
+    unsigned char encoded_fragment[] = { 0x02, 0x81, 0x00, 0x00, 0x00, 0x00, 0x42 };
+    size_t send_fragment_size = 1;
+    int result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_send_fragment_size", &send_fragment_size);
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    (void)uws_client_close_handshake_async(uws_client, 1002, "", test_on_ws_close_complete, (void*)0x6666);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_io_close_complete()
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    EXPECTED_CALL(gballoc_realloc(NULL, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(WS_BINARY_FRAME, 1, true, false, 0, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(2, test_payload, 1);
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_fragment), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
         .IgnoreArgument_callback_context()
-        .SetReturn(1);
-    STRICT_EXPECTED_CALL(test_on_ws_close_complete((void*)0x6666));
+        .ValidateArgumentBuffer(2, encoded_fragment, sizeof(encoded_fragment));
 
     // act
-    g_on_io_error(g_on_io_error_context);
+    result = uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* on_underlying_io_close_sent */
-
-/* Tests_SRS_UWS_CLIENT_01_489: [ When on_underlying_io_close_sent is called with NULL context, it shall do nothing. ]*/
-TEST_FUNCTION(on_underlying_io_close_sent_with_NULL_context_does_nothing)
+/* Tests_SRS_UWS_CLIENT_01_589: [ The fragments shall be sent one at a time, the next fragment being sent once the previous one of the same message is sent, so that the frames sent in between are not held back by the whole message. ]*/
+TEST_FUNCTION(when_a_fragment_is_sent_the_next_fragment_is_sent)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char close_frame[] = { 0x88, 0x00 };
+    unsigned char test_payload[] = { 0x42, 0x43 };
+    unsigned char encoded_fragment[] = { 0x80, 0x81, 0x00, 0x00, 0x00, 0x00, 0x43 };
+    size_t send_fragment_size = 1;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_send_fragment_size", &send_fragment_size);
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode_header(WS_CONTINUATION_FRAME, 1, true, true, 0, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, IGNORED_PTR_ARG, 1, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(2, test_payload + 1, 1);
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, IGNORED_PTR_ARG, sizeof(encoded_fragment), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_send_complete()
+        .IgnoreArgument_callback_context()
+        .ValidateArgumentBuffer(2, encoded_fragment, sizeof(encoded_fragment));
+
     // act
-    g_on_io_send_complete(NULL, IO_SEND_OK);
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -6629,28 +7036,31 @@ TEST_FUNCTION(on_underlying_io_close_sent_with_NULL_context_does_nothing)
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_490: [ When on_underlying_io_close_sent is called while the uws client is CLOSING, on_underlying_io_close_sent shall close the underlying IO by calling xio_close. ]*/
-TEST_FUNCTION(on_underlying_io_close_sent_when_a_CLOSE_was_sent_closes_the_underlying_IO)
+/* Tests_SRS_UWS_CLIENT_01_590: [ When the last fragment of a message is sent, or a fragment of it fails, the message shall be indicated once by calling on_ws_send_frame_complete, with the result of that fragment. ]*/
+TEST_FUNCTION(when_the_last_fragment_is_sent_the_frame_is_indicated_as_sent)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char close_frame[] = { 0x88, 0x00 };
+    unsigned char test_payload[] = { 0x42, 0x43 };
+    size_t send_fragment_size = 1;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_send_fragment_size", &send_fragment_size);
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response));
+    (void)uws_client_send_frame_async(uws_client, WS_FRAME_TYPE_BINARY, test_payload, sizeof(test_payload), true, test_on_ws_send_frame_complete, (void*)0x4248);
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_io_close_complete()
-        .IgnoreArgument_callback_context();
+    STRICT_EXPECTED_CALL(test_on_ws_send_frame_complete((void*)0x4248, WS_SEND_FRAME_OK));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
     g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
@@ -6662,33 +7072,28 @@ TEST_FUNCTION(on_underlying_io_close_sent_when_a_CLOSE_was_sent_closes_the_under
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_493: [ If calling xio_close fails, the state of the uws client shall be considered CLOSED and the on_ws_close_complete shall be called if it was specified. ]*/
-/* Tests_SRS_UWS_CLIENT_01_496: [ If the close was initiated by the peer no on_ws_close_complete shall be called. ]*/
-TEST_FUNCTION(when_xio_close_fails_in_on_underlying_io_close_sent_and_CLOSE_initiated_by_peer_no_callback_is_triggered)
+/* on_underlying_io_error */
+
+/* Tests_SRS_UWS_CLIENT_01_375: [ When on_underlying_io_error is called while uws is OPENING, uws shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_UNDERLYING_IO_ERROR. ]*/
+/* Tests_SRS_UWS_CLIENT_01_077: [ If this fails (e.g., the server's certificate could not be verified), then the client MUST _Fail the WebSocket Connection_ and abort the connection. ]*/
+TEST_FUNCTION(on_underlying_io_error_while_opening_underlying_io_indicates_an_open_complete_with_WS_OPEN_ERROR_UNDERLYING_IO_ERROR)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char close_frame[] = { 0x88, 0x00 };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
-    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_io_close_complete()
-        .IgnoreArgument_callback_context()
-        .SetReturn(1);
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_UNDERLYING_IO_ERROR));
 
     // act
-    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+    g_on_io_error(g_on_io_error_context);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -6697,16 +7102,12 @@ TEST_FUNCTION(when_xio_close_fails_in_on_underlying_io_close_sent_and_CLOSE_init
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_493: [ If calling xio_close fails, the state of the uws client shall be considered CLOSED and the on_ws_close_complete shall be called if it was specified. ]*/
-/* Tests_SRS_UWS_CLIENT_01_496: [ If the close was initiated by the peer no on_ws_close_complete shall be called. ]*/
-TEST_FUNCTION(when_xio_close_fails_in_on_underlying_io_close_sent_and_CLOSE_initiated_by_peer_no_callback_is_triggered_and_next_open_succeeds)
+/* Tests_SRS_UWS_CLIENT_01_375: [ When on_underlying_io_error is called while uws is OPENING, uws shall report that the open failed by calling the on_ws_open_complete callback passed to uws_client_open_async with WS_OPEN_ERROR_UNDERLYING_IO_ERROR. ]*/
+TEST_FUNCTION(on_underlying_io_error_while_waiting_for_upgrade_response_indicates_an_open_complete_with_WS_OPEN_ERROR_UNDERLYING_IO_ERROR)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char close_frame[] = { 0x88, 0x00 };
-    int result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -6714,27 +7115,13 @@ TEST_FUNCTION(when_xio_close_fails_in_on_underlying_io_close_sent_and_CLOSE_init
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
-    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
-    umock_c_reset_all_calls();
-
-    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_io_close_complete()
-        .IgnoreArgument_callback_context()
-        .SetReturn(1);
-    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .IgnoreArgument_on_io_open_complete()
-        .IgnoreArgument_on_io_open_complete_context()
-        .IgnoreArgument_on_bytes_received()
-        .IgnoreArgument_on_bytes_received_context()
-        .IgnoreArgument_on_io_error()
-        .IgnoreArgument_on_io_error_context();
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_ERROR_UNDERLYING_IO_ERROR));
 
     // act
-    result = uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_error(g_on_io_error_context);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -6743,23 +7130,15 @@ TEST_FUNCTION(when_xio_close_fails_in_on_underlying_io_close_sent_and_CLOSE_init
     uws_client_destroy(uws_client);
 }
 
-/* Ping frame */
-
-/* Tests_SRS_UWS_CLIENT_01_157: [ *  %x9 denotes a ping ]*/
-/* Tests_SRS_UWS_CLIENT_01_249: [ Upon receipt of a Ping frame, an endpoint MUST send a Pong frame in response ]*/
-/* Tests_SRS_UWS_CLIENT_01_250: [ It SHOULD respond with Pong frame as soon as is practical. ]*/
-/* Tests_SRS_UWS_CLIENT_01_253: [ A Pong frame sent in response to a Ping frame must have identical "Application data" as found in the message body of the Ping frame being replied to. ]*/
-/* Tests_SRS_UWS_CLIENT_01_247: [ The Ping frame contains an opcode of 0x9. ]*/
-/* Tests_SRS_UWS_CLIENT_01_251: [ An endpoint MAY send a Ping frame any time after the connection is established and before the connection is closed. ]*/
-TEST_FUNCTION(when_a_PING_frame_was_received_a_PONG_frame_is_sent)
+/* Tests_SRS_UWS_CLIENT_01_376: [ When on_underlying_io_error is called while the uws instance is OPEN, an error shall be reported to the user by calling the on_ws_error callback that was passed to uws_client_open_async with the argument WS_ERROR_UNDERLYING_IO_ERROR. ]*/
+/* Tests_SRS_UWS_CLIENT_01_318: [ Servers MAY close the WebSocket connection whenever desired. ]*/
+/* Tests_SRS_UWS_CLIENT_01_269: [ If at any point the state of the WebSocket connection changes, the endpoint MUST abort the following steps. ]*/
+TEST_FUNCTION(on_underlying_io_error_while_OPEN_indicates_an_error)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char ping_frame[] = { 0x89, 0x00 };
-    unsigned char pong_frame[] = { 0x8A, 0x00, 0x00, 0x00, 0x00, 0x00 };
-    BUFFER_HANDLE buffer_handle;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -6770,23 +7149,10 @@ TEST_FUNCTION(when_a_PING_frame_was_received_a_PONG_frame_is_sent)
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_PONG_FRAME, IGNORED_PTR_ARG, 0, true, true, 0))
-        .IgnoreArgument_payload()
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(pong_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(pong_frame));
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, pong_frame, sizeof(pong_frame), IGNORED_PTR_ARG, NULL))
-        .ValidateArgumentBuffer(2, pong_frame, sizeof(pong_frame));
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_UNDERLYING_IO_ERROR));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)ping_frame, sizeof(ping_frame));
+    g_on_io_error(g_on_io_error_context);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -6795,49 +7161,29 @@ TEST_FUNCTION(when_a_PING_frame_was_received_a_PONG_frame_is_sent)
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_253: [ A Pong frame sent in response to a Ping frame must have identical "Application data" as found in the message body of the Ping frame being replied to. ]*/
-/* Tests_SRS_UWS_CLIENT_01_248: [ A Ping frame MAY include "Application data". ]*/
-TEST_FUNCTION(when_a_PING_frame_was_received_with_some_payload_a_PONG_frame_is_sent_with_the_Same_payload)
+/* Tests_SRS_UWS_CLIENT_01_377: [ When on_underlying_io_error is called while the uws instance is CLOSING the underlying IO shall be closed by calling xio_close. ]*/
+TEST_FUNCTION(on_underlying_io_error_while_CLOSING_indicates_an_error)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char ping_frame[] = { 0x89, 0x02, 0x42, 0x43 };
-    unsigned char pong_frame_payload[] = { 0x42, 0x43 };
-    unsigned char pong_frame[] = { 0x8A, 0x02, 0x00, 0x00, 0x00, 0x00, 0x42, 0x43 };
-    BUFFER_HANDLE buffer_handle;
+    const unsigned char close_frame[] = { 0x88, 0x00 };
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
 
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(BUFFER_new())
-        .CaptureReturn(&buffer_handle);
-
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_PONG_FRAME, pong_frame_payload, sizeof(pong_frame_payload), true, true, 0))
-        .ValidateArgumentBuffer(2, pong_frame_payload, sizeof(pong_frame_payload))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(pong_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(pong_frame));
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, pong_frame, sizeof(pong_frame), IGNORED_PTR_ARG, NULL))
-        .ValidateArgumentBuffer(2, pong_frame, sizeof(pong_frame));
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, NULL, NULL));
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)ping_frame, sizeof(ping_frame));
+    g_on_io_error(g_on_io_error_context);
 
     // assert
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
@@ -6846,17 +7192,15 @@ TEST_FUNCTION(when_a_PING_frame_was_received_with_some_payload_a_PONG_frame_is_s
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_251: [ An endpoint MAY send a Ping frame any time after the connection is established and before the connection is closed. ]*/
-/* Tests_SRS_UWS_CLIENT_01_240: [ The application MUST NOT send any more data frames after sending a Close frame. ]*/
-TEST_FUNCTION(when_a_PING_frame_is_received_after_a_close_frame_no_pong_is_sent)
+/* Tests_SRS_UWS_CLIENT_01_377: [ When on_underlying_io_error is called while the uws instance is CLOSING the underlying IO shall be closed by calling xio_close. ]*/
+TEST_FUNCTION(open_after_error_during_sending_close_succeeds)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
     const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
-    const unsigned char close_and_ping_frames[] = { 0x88, 0x00, 0x89, 0x02, 0x42, 0x43 };
-    BUFFER_HANDLE buffer_handle;
-    unsigned char sent_close_frame[] = { 0x88, 0x80, 0x00, 0x00, 0x00, 0x00 };
+    const unsigned char close_frame[] = { 0x88, 0x00 };
+    int result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -6865,37 +7209,435 @@ TEST_FUNCTION(when_a_PING_frame_is_received_after_a_close_frame_no_pong_is_sent)
     (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
     g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    g_on_io_error(g_on_io_error_context);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
-        .CaptureReturn(&buffer_handle);
-    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sent_close_frame);
-    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle)
-        .SetReturn(sizeof(sent_close_frame));
-    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, sent_close_frame, sizeof(sent_close_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .ValidateArgumentBuffer(2, sent_close_frame, sizeof(sent_close_frame))
-        .IgnoreArgument_callback_context()
-        .IgnoreArgument_on_send_complete();
-    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
-        .ValidateArgumentValue_handle(&buffer_handle);
-    EXPECTED_CALL(test_on_ws_peer_closed(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0));
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_open_complete()
+        .IgnoreArgument_on_io_open_complete_context()
+        .IgnoreArgument_on_bytes_received()
+        .IgnoreArgument_on_bytes_received_context()
+        .IgnoreArgument_on_io_error()
+        .IgnoreArgument_on_io_error_context();
 
     // act
-    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)close_and_ping_frames, sizeof(close_and_ping_frames));
+    result = uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* uws_setoption */
-
+/* Tests_SRS_UWS_CLIENT_01_377: [ When on_underlying_io_error is called while the uws instance is CLOSING the underlying IO shall be closed by calling xio_close. ]*/
+/* Tests_SRS_UWS_CLIENT_01_499: [ If the CLOSE was due to the peer closing, the callback on_ws_close_complete shall not be called. ]*/
+TEST_FUNCTION(on_underlying_io_error_while_CLOSING_underlying_io_indicates_the_close)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char close_frame[] = { 0x88, 0x00 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_callback_context()
+        .IgnoreArgument_on_io_close_complete();
+
+    // act
+    g_on_io_error(g_on_io_error_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_377: [ When on_underlying_io_error is called while the uws instance is CLOSING the underlying IO shall be closed by calling xio_close. ]*/
+TEST_FUNCTION(open_after_error_during_closing_underlying_io_succeeds)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char close_frame[] = { 0x88, 0x00 };
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+    g_on_io_error(g_on_io_error_context);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_open_complete()
+        .IgnoreArgument_on_io_open_complete_context()
+        .IgnoreArgument_on_bytes_received()
+        .IgnoreArgument_on_bytes_received_context()
+        .IgnoreArgument_on_io_error()
+        .IgnoreArgument_on_io_error_context();
+
+    // act
+    result = uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_500: [ If xio_close fails then the callback on_ws_close_complete shall be called, while passing the on_ws_close_complete_context argument to it. ]*/
+/* Tests_SRS_UWS_CLIENT_01_500: [ The callback on_ws_close_complete shall be called, while passing the on_ws_close_complete_context argument to it. ]*/
+TEST_FUNCTION(on_underlying_io_error_while_CLOSING_due_to_local_initiated_close)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    (void)uws_client_close_handshake_async(uws_client, 1002, "", test_on_ws_close_complete, (void*)0x6666);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context()
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(test_on_ws_close_complete((void*)0x6666));
+
+    // act
+    g_on_io_error(g_on_io_error_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* on_underlying_io_close_sent */
+
+/* Tests_SRS_UWS_CLIENT_01_489: [ When on_underlying_io_close_sent is called with NULL context, it shall do nothing. ]*/
+TEST_FUNCTION(on_underlying_io_close_sent_with_NULL_context_does_nothing)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char close_frame[] = { 0x88, 0x00 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    umock_c_reset_all_calls();
+
+    // act
+    g_on_io_send_complete(NULL, IO_SEND_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_490: [ When on_underlying_io_close_sent is called while the uws client is CLOSING, on_underlying_io_close_sent shall close the underlying IO by calling xio_close. ]*/
+TEST_FUNCTION(on_underlying_io_close_sent_when_a_CLOSE_was_sent_closes_the_underlying_IO)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char close_frame[] = { 0x88, 0x00 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context();
+
+    // act
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_493: [ If calling xio_close fails, the state of the uws client shall be considered CLOSED and the on_ws_close_complete shall be called if it was specified. ]*/
+/* Tests_SRS_UWS_CLIENT_01_496: [ If the close was initiated by the peer no on_ws_close_complete shall be called. ]*/
+TEST_FUNCTION(when_xio_close_fails_in_on_underlying_io_close_sent_and_CLOSE_initiated_by_peer_no_callback_is_triggered)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char close_frame[] = { 0x88, 0x00 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context()
+        .SetReturn(1);
+
+    // act
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_493: [ If calling xio_close fails, the state of the uws client shall be considered CLOSED and the on_ws_close_complete shall be called if it was specified. ]*/
+/* Tests_SRS_UWS_CLIENT_01_496: [ If the close was initiated by the peer no on_ws_close_complete shall be called. ]*/
+TEST_FUNCTION(when_xio_close_fails_in_on_underlying_io_close_sent_and_CLOSE_initiated_by_peer_no_callback_is_triggered_and_next_open_succeeds)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char close_frame[] = { 0x88, 0x00 };
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, close_frame, sizeof(close_frame));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_close_complete()
+        .IgnoreArgument_callback_context()
+        .SetReturn(1);
+    g_on_io_send_complete(g_on_io_send_complete_context, IO_SEND_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .IgnoreArgument_on_io_open_complete()
+        .IgnoreArgument_on_io_open_complete_context()
+        .IgnoreArgument_on_bytes_received()
+        .IgnoreArgument_on_bytes_received_context()
+        .IgnoreArgument_on_io_error()
+        .IgnoreArgument_on_io_error_context();
+
+    // act
+    result = uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Ping frame */
+
+/* Tests_SRS_UWS_CLIENT_01_157: [ *  %x9 denotes a ping ]*/
+/* Tests_SRS_UWS_CLIENT_01_249: [ Upon receipt of a Ping frame, an endpoint MUST send a Pong frame in response ]*/
+/* Tests_SRS_UWS_CLIENT_01_250: [ It SHOULD respond with Pong frame as soon as is practical. ]*/
+/* Tests_SRS_UWS_CLIENT_01_253: [ A Pong frame sent in response to a Ping frame must have identical "Application data" as found in the message body of the Ping frame being replied to. ]*/
+/* Tests_SRS_UWS_CLIENT_01_247: [ The Ping frame contains an opcode of 0x9. ]*/
+/* Tests_SRS_UWS_CLIENT_01_251: [ An endpoint MAY send a Ping frame any time after the connection is established and before the connection is closed. ]*/
+TEST_FUNCTION(when_a_PING_frame_was_received_a_PONG_frame_is_sent)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char ping_frame[] = { 0x89, 0x00 };
+    unsigned char pong_frame[] = { 0x8A, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    BUFFER_HANDLE buffer_handle;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_PONG_FRAME, IGNORED_PTR_ARG, 0, true, true, 0))
+        .IgnoreArgument_payload()
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(pong_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(pong_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, pong_frame, sizeof(pong_frame), IGNORED_PTR_ARG, NULL))
+        .ValidateArgumentBuffer(2, pong_frame, sizeof(pong_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)ping_frame, sizeof(ping_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_253: [ A Pong frame sent in response to a Ping frame must have identical "Application data" as found in the message body of the Ping frame being replied to. ]*/
+/* Tests_SRS_UWS_CLIENT_01_248: [ A Ping frame MAY include "Application data". ]*/
+TEST_FUNCTION(when_a_PING_frame_was_received_with_some_payload_a_PONG_frame_is_sent_with_the_Same_payload)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char ping_frame[] = { 0x89, 0x02, 0x42, 0x43 };
+    unsigned char pong_frame_payload[] = { 0x42, 0x43 };
+    unsigned char pong_frame[] = { 0x8A, 0x02, 0x00, 0x00, 0x00, 0x00, 0x42, 0x43 };
+    BUFFER_HANDLE buffer_handle;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(BUFFER_new())
+        .CaptureReturn(&buffer_handle);
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_PONG_FRAME, pong_frame_payload, sizeof(pong_frame_payload), true, true, 0))
+        .ValidateArgumentBuffer(2, pong_frame_payload, sizeof(pong_frame_payload))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(pong_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(pong_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, pong_frame, sizeof(pong_frame), IGNORED_PTR_ARG, NULL))
+        .ValidateArgumentBuffer(2, pong_frame, sizeof(pong_frame));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)ping_frame, sizeof(ping_frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_251: [ An endpoint MAY send a Ping frame any time after the connection is established and before the connection is closed. ]*/
+/* Tests_SRS_UWS_CLIENT_01_240: [ The application MUST NOT send any more data frames after sending a Close frame. ]*/
+TEST_FUNCTION(when_a_PING_frame_is_received_after_a_close_frame_no_pong_is_sent)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char close_and_ping_frames[] = { 0x88, 0x00, 0x89, 0x02, 0x42, 0x43 };
+    BUFFER_HANDLE buffer_handle;
+    unsigned char sent_close_frame[] = { 0x88, 0x80, 0x00, 0x00, 0x00, 0x00 };
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sent_close_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(sent_close_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, sent_close_frame, sizeof(sent_close_frame), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(2, sent_close_frame, sizeof(sent_close_frame))
+        .IgnoreArgument_callback_context()
+        .IgnoreArgument_on_send_complete();
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+    EXPECTED_CALL(test_on_ws_peer_closed(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, 0));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)close_and_ping_frames, sizeof(close_and_ping_frames));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* uws_setoption */
+
 /* Tests_SRS_UWS_CLIENT_01_440: [ If any of the arguments uws_client or option_name is NULL uws_client_set_option shall return a non-zero value. ]*/
 TEST_FUNCTION(uws_set_option_with_NULL_uws_handle_fails)
 {
@@ -6903,82 +7645,1284 @@ TEST_FUNCTION(uws_set_option_with_NULL_uws_handle_fails)
     int result;
 
     // act
-    result = uws_client_set_option(NULL, "test_option", (void*)0x4242);
+    result = uws_client_set_option(NULL, "test_option", (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_CLIENT_01_440: [ If any of the arguments uws_client or option_name is NULL uws_client_set_option shall return a non-zero value. ]*/
+TEST_FUNCTION(uws_set_option_with_NULL_option_name_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_option(uws_client, NULL, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_510: [ If the option name is uWSClientOptions then uws_client_set_option shall call OptionHandler_FeedOptions and pass to it the underlying IO handle and the value argument. ]*/
+/* Tests_SRS_UWS_CLIENT_01_442: [ On success, uws_client_set_option shall return 0. ]*/
+TEST_FUNCTION(uws_set_option_with_uws_client_options_calls_OptionHandler_FeedOptions)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(OptionHandler_FeedOptions((OPTIONHANDLER_HANDLE)0x4242, TEST_IO_HANDLE));
+
+    // act
+    result = uws_client_set_option(uws_client, "uWSClientOptions", (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_511: [ If OptionHandler_FeedOptions fails, uws_client_set_option shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_OptionHandler_FeedOptions_fails_then_uws_set_option_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(OptionHandler_FeedOptions((OPTIONHANDLER_HANDLE)0x4242, TEST_IO_HANDLE))
+        .SetReturn(OPTIONHANDLER_ERROR);
+
+    // act
+    result = uws_client_set_option(uws_client, "uWSClientOptions", (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_441: [ Otherwise all options shall be passed as they are to the underlying IO by calling xio_setoption. ]*/
+/* Tests_SRS_UWS_CLIENT_01_442: [ On success, uws_client_set_option shall return 0. ]*/
+TEST_FUNCTION(uws_set_option_passes_the_option_down)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_IO_HANDLE, "option1", (void*)0x4242));
+
+    // act
+    result = uws_client_set_option(uws_client, "option1", (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_443: [ If xio_setoption fails, uws_client_set_option shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_xio_setoption_fails_then_uws_set_option_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_IO_HANDLE, "option1", (void*)0x4242))
+        .SetReturn(1);
+
+    // act
+    result = uws_client_set_option(uws_client, "option1", (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* uws_client_retrieve_options */
+
+/* Tests_SRS_UWS_CLIENT_01_444: [ If parameter uws_client is NULL then uws_client_retrieve_options shall fail and return NULL. ]*/
+TEST_FUNCTION(uws_retrieve_options_with_NULL_handle_fails)
+{
+    // arrange
+    OPTIONHANDLER_HANDLE result;
+
+    // act
+    result = uws_client_retrieve_options(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_CLIENT_01_445: [ uws_client_retrieve_options shall call OptionHandler_Create to produce an OPTIONHANDLER_HANDLE and on success return the new OPTIONHANDLER_HANDLE handle. ]*/
+/* Tests_SRS_UWS_CLIENT_01_501: [ uws_client_retrieve_options shall add to the option handler one option, whose name shall be uWSClientOptions and the value shall be queried by calling xio_retrieveoptions. ]*/
+/* Tests_SRS_UWS_CLIENT_01_502: [ When calling xio_retrieveoptions the underlying IO handle shall be passed to it. ]*/
+/* Tests_SRS_UWS_CLIENT_01_504: [ Adding the option shall be done by calling OptionHandler_AddOption. ]*/
+TEST_FUNCTION(uws_retrieve_options_calls_the_underlying_xio_retrieve_options_and_returns_the_a_new_option_handler_instance)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    OPTIONHANDLER_HANDLE result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "uWSClientOptions", TEST_IO_OPTIONHANDLER_HANDLE));
+
+    // act
+    result = uws_client_retrieve_options(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_446: [ If OptionHandler_Create fails then uws_client_retrieve_options shall fail and return NULL. ]*/
+TEST_FUNCTION(when_OptionHandler_Create_fails_then_uws_retrieve_options_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    OPTIONHANDLER_HANDLE result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = uws_client_retrieve_options(uws_client);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_503: [ If xio_retrieveoptions fails, uws_client_retrieve_options shall fail and return NULL. ]*/
+TEST_FUNCTION(when_xio_retrieveoptions_fails_then_uws_retrieve_options_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    OPTIONHANDLER_HANDLE result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(OptionHandler_Destroy(TEST_OPTIONHANDLER_HANDLE));
+
+    // act
+    result = uws_client_retrieve_options(uws_client);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_505: [ If OptionHandler_AddOption fails, uws_client_retrieve_options shall fail and return NULL. ]*/
+TEST_FUNCTION(when_OptionHandler_AddOption_fails_then_uws_retrieve_options_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    OPTIONHANDLER_HANDLE result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "uWSClientOptions", TEST_IO_OPTIONHANDLER_HANDLE))
+        .SetReturn(OPTIONHANDLER_ERROR);
+    STRICT_EXPECTED_CALL(OptionHandler_Destroy(TEST_IO_OPTIONHANDLER_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_Destroy(TEST_OPTIONHANDLER_HANDLE));
+
+    // act
+    result = uws_client_retrieve_options(uws_client);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_538: [ If the option name is ws_fragment_streaming and value is NULL, uws_client_set_option shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_fragment_streaming_and_NULL_value_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_option(uws_client, "ws_fragment_streaming", NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_533: [ If the option name is ws_fragment_streaming, uws_client_set_option shall store the on_ws_fragment_received callback and its context from the WS_FRAGMENT_STREAMING structure pointed to by value. ]*/
+/* Tests_SRS_UWS_CLIENT_01_542: [ If fragment streaming is enabled, uws_client_retrieve_options shall also add the ws_fragment_streaming option. ]*/
+TEST_FUNCTION(uws_client_retrieve_options_adds_the_ws_fragment_streaming_option_when_enabled)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    WS_FRAGMENT_STREAMING fragment_streaming;
+    OPTIONHANDLER_HANDLE result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    fragment_streaming.on_ws_fragment_received = test_on_ws_fragment_received;
+    fragment_streaming.on_ws_fragment_received_context = (void*)0x4245;
+    (void)uws_client_set_option(uws_client, "ws_fragment_streaming", &fragment_streaming);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "uWSClientOptions", TEST_IO_OPTIONHANDLER_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "ws_fragment_streaming", IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_retrieve_options(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_570: [ If the option name is ws_send_coalescing and value is NULL, uws_client_set_option shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_send_coalescing_and_NULL_value_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_option(uws_client, "ws_send_coalescing", NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_569: [ If the option name is ws_send_coalescing, uws_client_set_option shall store the size_t pointed to by value as the number of bytes of frames that can wait to be sent together, 0 disabling send coalescing. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_send_coalescing_succeeds)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    size_t send_coalescing_size = 1000;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_option(uws_client, "ws_send_coalescing", &send_coalescing_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_580: [ If send coalescing is enabled, uws_client_retrieve_options shall also add the ws_send_coalescing option. ]*/
+TEST_FUNCTION(uws_client_retrieve_options_adds_the_ws_send_coalescing_option_when_enabled)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    size_t send_coalescing_size = 1000;
+    OPTIONHANDLER_HANDLE result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_send_coalescing", &send_coalescing_size);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "uWSClientOptions", TEST_IO_OPTIONHANDLER_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "ws_send_coalescing", IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_retrieve_options(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_587: [ If the option name is ws_send_fragment_size and value is NULL, uws_client_set_option shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_send_fragment_size_and_NULL_value_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_option(uws_client, "ws_send_fragment_size", NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_586: [ If the option name is ws_send_fragment_size, uws_client_set_option shall store the size_t pointed to by value as the largest payload of the data frames sent, 0 sending each data frame whole. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_send_fragment_size_succeeds)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    size_t send_fragment_size = 1000;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_option(uws_client, "ws_send_fragment_size", &send_fragment_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_596: [ If a send fragment size is set, uws_client_retrieve_options shall also add the ws_send_fragment_size option. ]*/
+TEST_FUNCTION(uws_client_retrieve_options_adds_the_ws_send_fragment_size_option_when_enabled)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    size_t send_fragment_size = 1000;
+    OPTIONHANDLER_HANDLE result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_send_fragment_size", &send_fragment_size);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "uWSClientOptions", TEST_IO_OPTIONHANDLER_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "ws_send_fragment_size", IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_retrieve_options(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_629: [ If the option name is ws_receive_buffer_size and value is NULL, uws_client_set_option shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_receive_buffer_size_and_NULL_value_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_option(uws_client, "ws_receive_buffer_size", NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_628: [ If the option name is ws_receive_buffer_size, uws_client_set_option shall store the size_t pointed to by value as the size of the memory lent to the underlying IO for receiving, 0 copying the received bytes. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_receive_buffer_size_succeeds)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    size_t receive_buffer_size = 65536;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_option(uws_client, "ws_receive_buffer_size", &receive_buffer_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_630: [ If a receive buffer size is set, uws_client_retrieve_options shall also add the ws_receive_buffer_size option. ]*/
+TEST_FUNCTION(uws_client_retrieve_options_adds_the_ws_receive_buffer_size_option_when_set)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    size_t receive_buffer_size = 65536;
+    OPTIONHANDLER_HANDLE result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_receive_buffer_size", &receive_buffer_size);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "uWSClientOptions", TEST_IO_OPTIONHANDLER_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "ws_receive_buffer_size", IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_retrieve_options(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_647: [ If any receive limit is set, uws_client_retrieve_options shall also add the ws_receive_limits option. ]*/
+TEST_FUNCTION(uws_client_retrieve_options_adds_the_ws_receive_limits_option_when_set)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    WS_RECEIVE_LIMITS receive_limits = { 0, 1048576, 0 };
+    OPTIONHANDLER_HANDLE result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_receive_limits", &receive_limits);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "uWSClientOptions", TEST_IO_OPTIONHANDLER_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "ws_receive_limits", IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_retrieve_options(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_643: [ If the option name is ws_receive_limits and value is NULL, uws_client_set_option shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_receive_limits_and_NULL_value_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_option(uws_client, "ws_receive_limits", NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_612: [ If the option name is ws_keepalive and value is NULL or has a ping interval with a pong timeout of 0, uws_client_set_option shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_keepalive_and_NULL_value_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_option(uws_client, "ws_keepalive", NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_612: [ If the option name is ws_keepalive and value is NULL or has a ping interval with a pong timeout of 0, uws_client_set_option shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_keepalive_and_0_pong_timeout_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    WS_KEEPALIVE_OPTIONS keepalive_options;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    keepalive_options.ping_interval_ms = 30000;
+    keepalive_options.pong_timeout_ms = 0;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_613: [ If the option name is ws_keepalive, uws_client_set_option shall store a copy of the WS_KEEPALIVE_OPTIONS pointed to by value, creating a timer wheel with timer_wheel_create and its keepalive timer with timer_wheel_create_timer the first time a ping interval is set. ]*/
+/* Tests_SRS_UWS_CLIENT_01_442: [ On success, uws_client_set_option shall return 0. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_keepalive_creates_the_keepalive_timer)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    WS_KEEPALIVE_OPTIONS keepalive_options;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    keepalive_options.ping_interval_ms = 30000;
+    keepalive_options.pong_timeout_ms = 5000;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(timer_wheel_create());
+    STRICT_EXPECTED_CALL(timer_wheel_create_timer(TEST_TIMER_WHEEL_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_613: [ If the option name is ws_keepalive, uws_client_set_option shall store a copy of the WS_KEEPALIVE_OPTIONS pointed to by value, creating a timer wheel with timer_wheel_create and its keepalive timer with timer_wheel_create_timer the first time a ping interval is set. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_keepalive_a_second_time_keeps_the_keepalive_timer)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    WS_KEEPALIVE_OPTIONS keepalive_options;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    keepalive_options.ping_interval_ms = 30000;
+    keepalive_options.pong_timeout_ms = 5000;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
+    umock_c_reset_all_calls();
+
+    keepalive_options.ping_interval_ms = 10000;
+
+    // act
+    result = uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_613: [ If the option name is ws_keepalive, uws_client_set_option shall store a copy of the WS_KEEPALIVE_OPTIONS pointed to by value, creating a timer wheel with timer_wheel_create and its keepalive timer with timer_wheel_create_timer the first time a ping interval is set. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_keepalive_and_0_ping_interval_creates_no_timer)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    WS_KEEPALIVE_OPTIONS keepalive_options;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    keepalive_options.ping_interval_ms = 0;
+    keepalive_options.pong_timeout_ms = 0;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_614: [ If timer_wheel_create or timer_wheel_create_timer fails, uws_client_set_option shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_timer_wheel_create_fails_uws_client_set_option_with_ws_keepalive_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    WS_KEEPALIVE_OPTIONS keepalive_options;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    keepalive_options.ping_interval_ms = 30000;
+    keepalive_options.pong_timeout_ms = 5000;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(timer_wheel_create())
+        .SetReturn(NULL);
+
+    // act
+    result = uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_614: [ If timer_wheel_create or timer_wheel_create_timer fails, uws_client_set_option shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_timer_wheel_create_timer_fails_uws_client_set_option_with_ws_keepalive_fails)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    WS_KEEPALIVE_OPTIONS keepalive_options;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    keepalive_options.ping_interval_ms = 30000;
+    keepalive_options.pong_timeout_ms = 5000;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(timer_wheel_create());
+    STRICT_EXPECTED_CALL(timer_wheel_create_timer(TEST_TIMER_WHEEL_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(timer_wheel_destroy(TEST_TIMER_WHEEL_HANDLE));
+
+    // act
+    result = uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_615: [ If the uws instance is OPEN, setting ws_keepalive shall start the keepalive timer with the new ping interval, or cancel it with timer_wheel_cancel_timer when the ping interval is 0. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_keepalive_while_open_starts_the_keepalive_timer)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    WS_KEEPALIVE_OPTIONS keepalive_options;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    keepalive_options.ping_interval_ms = 30000;
+    keepalive_options.pong_timeout_ms = 5000;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(timer_wheel_create());
+    STRICT_EXPECTED_CALL(timer_wheel_create_timer(TEST_TIMER_WHEEL_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_start_timer(TEST_KEEPALIVE_TIMER_HANDLE, 30000));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_615: [ If the uws instance is OPEN, setting ws_keepalive shall start the keepalive timer with the new ping interval, or cancel it with timer_wheel_cancel_timer when the ping interval is 0. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_keepalive_and_0_ping_interval_cancels_the_keepalive_timer)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    WS_KEEPALIVE_OPTIONS keepalive_options;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    keepalive_options.ping_interval_ms = 30000;
+    keepalive_options.pong_timeout_ms = 5000;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    keepalive_options.ping_interval_ms = 0;
+    STRICT_EXPECTED_CALL(timer_wheel_cancel_timer(TEST_KEEPALIVE_TIMER_HANDLE));
+
+    // act
+    result = uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_616: [ When the uws instance becomes OPEN and keepalive is enabled, the keepalive timer shall be started with the ping interval by calling timer_wheel_start_timer. ]*/
+TEST_FUNCTION(when_the_upgrade_response_is_received_the_keepalive_timer_is_started)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    WS_KEEPALIVE_OPTIONS keepalive_options;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    keepalive_options.ping_interval_ms = 30000;
+    keepalive_options.pong_timeout_ms = 5000;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_start_timer(TEST_KEEPALIVE_TIMER_HANDLE, 30000));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_ws_open_complete((void*)0x4242, WS_OPEN_OK));
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_618: [ When the ping interval expires and no bytes were received since the timer was started, a Ping frame without payload shall be encoded with uws_frame_encoder_encode and sent with xio_send, and the timer shall be started with the pong timeout. ]*/
+TEST_FUNCTION(when_the_ping_interval_expires_without_bytes_received_a_ping_is_sent)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    WS_KEEPALIVE_OPTIONS keepalive_options;
+    unsigned char ping_frame[] = { 0x89, 0x80, 0x00, 0x00, 0x00, 0x00 };
+    BUFFER_HANDLE buffer_handle;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    keepalive_options.ping_interval_ms = 30000;
+    keepalive_options.pong_timeout_ms = 5000;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_PING_FRAME, NULL, 0, true, true, 0))
+        .CaptureReturn(&buffer_handle);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(ping_frame);
+    STRICT_EXPECTED_CALL(BUFFER_length(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle)
+        .SetReturn(sizeof(ping_frame));
+    STRICT_EXPECTED_CALL(xio_send(TEST_IO_HANDLE, ping_frame, sizeof(ping_frame), IGNORED_PTR_ARG, NULL));
+    STRICT_EXPECTED_CALL(BUFFER_delete(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&buffer_handle);
+    STRICT_EXPECTED_CALL(timer_wheel_start_timer(TEST_KEEPALIVE_TIMER_HANDLE, 5000));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+
+    // act
+    g_on_timer_expired(g_on_timer_expired_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_619: [ When the pong timeout expires and no bytes were received since the Ping was sent, an error shall be reported by calling on_ws_error with WS_ERROR_PONG_TIMEOUT. ]*/
+TEST_FUNCTION(when_the_pong_timeout_expires_without_bytes_received_a_pong_timeout_error_is_indicated)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    WS_KEEPALIVE_OPTIONS keepalive_options;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    keepalive_options.ping_interval_ms = 30000;
+    keepalive_options.pong_timeout_ms = 5000;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_timer_expired(g_on_timer_expired_context);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_ws_error((void*)0x4244, WS_ERROR_PONG_TIMEOUT));
+
+    // act
+    g_on_timer_expired(g_on_timer_expired_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_617: [ When the keepalive timer expires and bytes were received since it was started, the timer shall be started again with the ping interval. ]*/
+/* Tests_SRS_UWS_CLIENT_01_621: [ Any bytes received shall count as a sign of life of the connection for keepalive. ]*/
+TEST_FUNCTION(when_bytes_were_received_during_the_ping_interval_no_ping_is_sent)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char pong_frame[] = { 0x8A, 0x00 };
+    WS_KEEPALIVE_OPTIONS keepalive_options;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    keepalive_options.ping_interval_ms = 30000;
+    keepalive_options.pong_timeout_ms = 5000;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_bytes_received(g_on_bytes_received_context, pong_frame, sizeof(pong_frame));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(timer_wheel_start_timer(TEST_KEEPALIVE_TIMER_HANDLE, 30000));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+
+    // act
+    g_on_timer_expired(g_on_timer_expired_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_617: [ When the keepalive timer expires and bytes were received since it was started, the timer shall be started again with the ping interval. ]*/
+TEST_FUNCTION(when_bytes_were_received_after_the_ping_the_ping_interval_starts_again)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    const unsigned char pong_frame[] = { 0x8A, 0x00 };
+    WS_KEEPALIVE_OPTIONS keepalive_options;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    keepalive_options.ping_interval_ms = 30000;
+    keepalive_options.pong_timeout_ms = 5000;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_timer_expired(g_on_timer_expired_context);
+    g_on_bytes_received(g_on_bytes_received_context, pong_frame, sizeof(pong_frame));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(timer_wheel_start_timer(TEST_KEEPALIVE_TIMER_HANDLE, 30000));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+
+    // act
+    g_on_timer_expired(g_on_timer_expired_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_620: [ When the keepalive timer expires while the uws instance is not OPEN or keepalive was disabled, nothing shall be done. ]*/
+TEST_FUNCTION(when_the_keepalive_timer_expires_after_an_error_nothing_is_done)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    WS_KEEPALIVE_OPTIONS keepalive_options;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    keepalive_options.ping_interval_ms = 30000;
+    keepalive_options.pong_timeout_ms = 5000;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    g_on_io_error(g_on_io_error_context);
+    umock_c_reset_all_calls();
+
+    // act
+    g_on_timer_expired(g_on_timer_expired_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_622: [ When keepalive was enabled, uws_client_dowork shall call timer_wheel_dowork after xio_dowork. ]*/
+TEST_FUNCTION(uws_client_dowork_with_keepalive_runs_the_timer_wheel)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    WS_KEEPALIVE_OPTIONS keepalive_options;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    keepalive_options.ping_interval_ms = 30000;
+    keepalive_options.pong_timeout_ms = 5000;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_dowork(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(timer_wheel_dowork(TEST_TIMER_WHEEL_HANDLE));
+
+    // act
+    uws_client_dowork(uws_client);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
+/* Tests_SRS_UWS_CLIENT_01_623: [ When keepalive was enabled, uws_client_dowork_ex shall call timer_wheel_dowork after xio_dowork_ex and, while the uws instance is OPEN, lower next_deadline_us to the time the keepalive timer expires. ]*/
+TEST_FUNCTION(uws_client_dowork_ex_with_keepalive_lowers_the_deadline_to_the_keepalive_timer)
+{
+    // arrange
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    const char test_upgrade_response[] = "HTTP/1.1 101 Switching Protocols\r\n\r\n";
+    WS_KEEPALIVE_OPTIONS keepalive_options;
+    bool made_progress = true;
+    bool underlying_progress = false;
+    uint64_t next_deadline_us = XIO_NO_DEADLINE;
+    int result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    keepalive_options.ping_interval_ms = 30000;
+    keepalive_options.pong_timeout_ms = 5000;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_dowork_ex(TEST_IO_HANDLE, IGNORED_PTR_ARG, &next_deadline_us))
+        .CopyOutArgumentBuffer_made_progress(&underlying_progress, sizeof(underlying_progress));
+    STRICT_EXPECTED_CALL(timer_wheel_dowork(TEST_TIMER_WHEEL_HANDLE));
+
+    // act
+    result = uws_client_dowork_ex(uws_client, &made_progress, &next_deadline_us);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(made_progress);
+    ASSERT_ARE_EQUAL(uint64_t, 1000000 + 30001000, next_deadline_us);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_440: [ If any of the arguments uws_client or option_name is NULL uws_client_set_option shall return a non-zero value. ]*/
-TEST_FUNCTION(uws_set_option_with_NULL_option_name_fails)
+/* Tests_SRS_UWS_CLIENT_01_626: [ uws_client_destroy shall destroy the keepalive timer and its timer wheel with timer_wheel_destroy_timer and timer_wheel_destroy. ]*/
+TEST_FUNCTION(uws_client_destroy_destroys_the_keepalive_timer)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    int result;
+    WS_KEEPALIVE_OPTIONS keepalive_options;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
+    keepalive_options.ping_interval_ms = 30000;
+    keepalive_options.pong_timeout_ms = 5000;
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
     umock_c_reset_all_calls();
 
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_destroy(TEST_IO_HANDLE));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    EXPECTED_CALL(Map_Destroy(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(timer_wheel_destroy_timer(TEST_KEEPALIVE_TIMER_HANDLE));
+    STRICT_EXPECTED_CALL(timer_wheel_destroy(TEST_TIMER_WHEEL_HANDLE));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
     // act
-    result = uws_client_set_option(uws_client, NULL, (void*)0x4242);
+    uws_client_destroy(uws_client);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_510: [ If the option name is uWSClientOptions then uws_client_set_option shall call OptionHandler_FeedOptions and pass to it the underlying IO handle and the value argument. ]*/
-/* Tests_SRS_UWS_CLIENT_01_442: [ On success, uws_client_set_option shall return 0. ]*/
-TEST_FUNCTION(uws_set_option_with_uws_client_options_calls_OptionHandler_FeedOptions)
+/* Tests_SRS_UWS_CLIENT_01_627: [ If keepalive is enabled, uws_client_retrieve_options shall also add the ws_keepalive option. ]*/
+TEST_FUNCTION(uws_client_retrieve_options_adds_the_ws_keepalive_option_when_enabled)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    int result;
+    WS_KEEPALIVE_OPTIONS keepalive_options;
+    OPTIONHANDLER_HANDLE result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
+    keepalive_options.ping_interval_ms = 30000;
+    keepalive_options.pong_timeout_ms = 5000;
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_set_option(uws_client, "ws_keepalive", &keepalive_options);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(OptionHandler_FeedOptions((OPTIONHANDLER_HANDLE)0x4242, TEST_IO_HANDLE));
+    EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "uWSClientOptions", TEST_IO_OPTIONHANDLER_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "ws_keepalive", IGNORED_PTR_ARG));
 
     // act
-    result = uws_client_set_option(uws_client, "uWSClientOptions", (void*)0x4242);
+    result = uws_client_retrieve_options(uws_client);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_511: [ If OptionHandler_FeedOptions fails, uws_client_set_option shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(when_OptionHandler_FeedOptions_fails_then_uws_set_option_fails)
+#ifndef USE_WS_PERMESSAGE_DEFLATE
+/* Tests_SRS_UWS_CLIENT_01_554: [ If the library was built without permessage-deflate support, setting ws_permessage_deflate shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_client_set_option_with_ws_permessage_deflate_fails_when_not_supported)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS permessage_deflate_options;
     int result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    permessage_deflate_options.client_max_window_bits = 15;
+    permessage_deflate_options.server_max_window_bits = 15;
+    permessage_deflate_options.client_no_context_takeover = false;
+    permessage_deflate_options.server_no_context_takeover = false;
+    permessage_deflate_options.compression_level = -1;
+    permessage_deflate_options.mem_level = 8;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(OptionHandler_FeedOptions((OPTIONHANDLER_HANDLE)0x4242, TEST_IO_HANDLE))
-        .SetReturn(OPTIONHANDLER_ERROR);
-
     // act
-    result = uws_client_set_option(uws_client, "uWSClientOptions", (void*)0x4242);
+    result = uws_client_set_option(uws_client, "ws_permessage_deflate", &permessage_deflate_options);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
@@ -6987,204 +8931,187 @@ TEST_FUNCTION(when_OptionHandler_FeedOptions_fails_then_uws_set_option_fails)
     // cleanup
     uws_client_destroy(uws_client);
 }
+#endif
 
-/* Tests_SRS_UWS_CLIENT_01_441: [ Otherwise all options shall be passed as they are to the underlying IO by calling xio_setoption. ]*/
-/* Tests_SRS_UWS_CLIENT_01_442: [ On success, uws_client_set_option shall return 0. ]*/
-TEST_FUNCTION(uws_set_option_passes_the_option_down)
+/* uws_client_clone_option */
+
+/* Tests_SRS_UWS_CLIENT_01_507: [ uws_client_clone_option called with name being uWSClientOptions shall return the same value. ]*/
+TEST_FUNCTION(uws_client_clone_option_calls_xio_cloneoption)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    int result;
+    void* result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_retrieve_options(uws_client);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_setoption(TEST_IO_HANDLE, "option1", (void*)0x4242));
-
     // act
-    result = uws_client_set_option(uws_client, "option1", (void*)0x4242);
+    result = g_clone_option("uWSClientOptions", (void*)0x4243);
 
     // assert
-    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x4243, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_443: [ If xio_setoption fails, uws_client_set_option shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(when_xio_setoption_fails_then_uws_set_option_fails)
+/* Tests_SRS_UWS_CLIENT_01_512: [ uws_client_clone_option called with any other option name than uWSClientOptions shall return NULL. ]*/
+TEST_FUNCTION(uws_client_clone_with_an_unknown_option_fails)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    int result;
+    void* result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_retrieve_options(uws_client);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(xio_setoption(TEST_IO_HANDLE, "option1", (void*)0x4242))
-        .SetReturn(1);
-
     // act
-    result = uws_client_set_option(uws_client, "option1", (void*)0x4242);
+    result = g_clone_option("TrustedCerts", (void*)0x4243);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_IS_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* uws_client_retrieve_options */
-
-/* Tests_SRS_UWS_CLIENT_01_444: [ If parameter uws_client is NULL then uws_client_retrieve_options shall fail and return NULL. ]*/
-TEST_FUNCTION(uws_retrieve_options_with_NULL_handle_fails)
+/* Tests_SRS_UWS_CLIENT_01_506: [ If uws_client_clone_option is called with NULL name or value it shall return NULL. ]*/
+TEST_FUNCTION(uws_client_clone_option_with_NULL_name_fails)
 {
     // arrange
-    OPTIONHANDLER_HANDLE result;
+    TLSIO_CONFIG tlsio_config;
+    UWS_CLIENT_HANDLE uws_client;
+    void* result;
+
+    tlsio_config.hostname = "test_host";
+    tlsio_config.port = 444;
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_retrieve_options(uws_client);
+    umock_c_reset_all_calls();
 
     // act
-    result = uws_client_retrieve_options(NULL);
+    result = g_clone_option(NULL, (void*)0x4243);
 
     // assert
     ASSERT_IS_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_445: [ uws_client_retrieve_options shall call OptionHandler_Create to produce an OPTIONHANDLER_HANDLE and on success return the new OPTIONHANDLER_HANDLE handle. ]*/
-/* Tests_SRS_UWS_CLIENT_01_501: [ uws_client_retrieve_options shall add to the option handler one option, whose name shall be uWSClientOptions and the value shall be queried by calling xio_retrieveoptions. ]*/
-/* Tests_SRS_UWS_CLIENT_01_502: [ When calling xio_retrieveoptions the underlying IO handle shall be passed to it. ]*/
-/* Tests_SRS_UWS_CLIENT_01_504: [ Adding the option shall be done by calling OptionHandler_AddOption. ]*/
-TEST_FUNCTION(uws_retrieve_options_calls_the_underlying_xio_retrieve_options_and_returns_the_a_new_option_handler_instance)
+/* Tests_SRS_UWS_CLIENT_01_506: [ If uws_client_clone_option is called with NULL name or value it shall return NULL. ]*/
+TEST_FUNCTION(uws_client_clone_option_with_NULL_value_fails)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    OPTIONHANDLER_HANDLE result;
+    void* result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_retrieve_options(uws_client);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
-    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "uWSClientOptions", TEST_IO_OPTIONHANDLER_HANDLE));
-
     // act
-    result = uws_client_retrieve_options(uws_client);
+    result = g_clone_option("uWSClientOptions", NULL);
 
     // assert
-    ASSERT_ARE_EQUAL(void_ptr, TEST_OPTIONHANDLER_HANDLE, result);
+    ASSERT_IS_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_446: [ If OptionHandler_Create fails then uws_client_retrieve_options shall fail and return NULL. ]*/
-TEST_FUNCTION(when_OptionHandler_Create_fails_then_uws_retrieve_options_fails)
+/* uws_client_destroy_option */
+
+/* Tests_SRS_UWS_CLIENT_01_509: [ If uws_client_destroy_option is called with NULL name or value it shall do nothing. ]*/
+TEST_FUNCTION(uws_client_destroy_option_with_NULL_name_does_no_destroy)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    OPTIONHANDLER_HANDLE result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_retrieve_options(uws_client);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
-        .SetReturn(NULL);
-
     // act
-    result = uws_client_retrieve_options(uws_client);
+    g_destroy_option(NULL, (void*)0x4243);
 
     // assert
-    ASSERT_IS_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_503: [ If xio_retrieveoptions fails, uws_client_retrieve_options shall fail and return NULL. ]*/
-TEST_FUNCTION(when_xio_retrieveoptions_fails_then_uws_retrieve_options_fails)
+/* Tests_SRS_UWS_CLIENT_01_509: [ If uws_client_destroy_option is called with NULL name or value it shall do nothing. ]*/
+TEST_FUNCTION(uws_client_destroy_option_with_NULL_value_does_no_destroy)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    OPTIONHANDLER_HANDLE result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_retrieve_options(uws_client);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE))
-        .SetReturn(NULL);
-    STRICT_EXPECTED_CALL(OptionHandler_Destroy(TEST_OPTIONHANDLER_HANDLE));
-
     // act
-    result = uws_client_retrieve_options(uws_client);
+    g_destroy_option("uWSClientOptions", NULL);
 
     // assert
-    ASSERT_IS_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_505: [ If OptionHandler_AddOption fails, uws_client_retrieve_options shall fail and return NULL. ]*/
-TEST_FUNCTION(when_OptionHandler_AddOption_fails_then_uws_retrieve_options_fails)
+/* Tests_SRS_UWS_CLIENT_01_513: [ If uws_client_destroy_option is called with any other name it shall do nothing. ]*/
+TEST_FUNCTION(uws_client_destroy_option_with_an_unknown_option_does_no_destroy)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    OPTIONHANDLER_HANDLE result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_retrieve_options(uws_client);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(xio_retrieveoptions(TEST_IO_HANDLE));
-    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "uWSClientOptions", TEST_IO_OPTIONHANDLER_HANDLE))
-        .SetReturn(OPTIONHANDLER_ERROR);
-    STRICT_EXPECTED_CALL(OptionHandler_Destroy(TEST_IO_OPTIONHANDLER_HANDLE));
-    STRICT_EXPECTED_CALL(OptionHandler_Destroy(TEST_OPTIONHANDLER_HANDLE));
-
     // act
-    result = uws_client_retrieve_options(uws_client);
+    g_destroy_option("TrustedCerts", (void*)0x4243);
 
     // assert
-    ASSERT_IS_NULL(result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* uws_client_clone_option */
-
-/* Tests_SRS_UWS_CLIENT_01_507: [ uws_client_clone_option called with name being uWSClientOptions shall return the same value. ]*/
-TEST_FUNCTION(uws_client_clone_option_calls_xio_cloneoption)
+/* Tests_SRS_UWS_CLIENT_01_508: [ uws_client_destroy_option called with the option name being uWSClientOptions shall destroy the value by calling OptionHandler_Destroy. ]*/
+TEST_FUNCTION(uws_client_destroy_option_with_uWSClientOptions_calls_OptionHandler_Destroy)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    void* result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -7192,49 +9119,62 @@ TEST_FUNCTION(uws_client_clone_option_calls_xio_cloneoption)
     (void)uws_client_retrieve_options(uws_client);
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(OptionHandler_Destroy(TEST_OPTIONHANDLER_HANDLE));
+
     // act
-    result = g_clone_option("uWSClientOptions", (void*)0x4243);
+    g_destroy_option("uWSClientOptions", TEST_OPTIONHANDLER_HANDLE);
 
     // assert
-    ASSERT_ARE_EQUAL(void_ptr, (void*)0x4243, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_512: [ uws_client_clone_option called with any other option name than uWSClientOptions shall return NULL. ]*/
-TEST_FUNCTION(uws_client_clone_with_an_unknown_option_fails)
+/* Tests_SRS_UWS_CLIENT_01_540: [ uws_client_clone_option called with name being ws_fragment_streaming shall return a newly allocated copy of the WS_FRAGMENT_STREAMING value. ]*/
+/* Tests_SRS_UWS_CLIENT_01_541: [ uws_client_destroy_option called with the option name being ws_fragment_streaming shall free the value. ]*/
+TEST_FUNCTION(uws_client_clone_option_with_ws_fragment_streaming_copies_the_value)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    void* result;
+    WS_FRAGMENT_STREAMING fragment_streaming;
+    WS_FRAGMENT_STREAMING* result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_retrieve_options(uws_client);
+    fragment_streaming.on_ws_fragment_received = test_on_ws_fragment_received;
+    fragment_streaming.on_ws_fragment_received_context = (void*)0x4245;
     umock_c_reset_all_calls();
 
+    EXPECTED_CALL(gballoc_malloc(sizeof(WS_FRAGMENT_STREAMING)));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
     // act
-    result = g_clone_option("TrustedCerts", (void*)0x4243);
+    result = (WS_FRAGMENT_STREAMING*)g_clone_option("ws_fragment_streaming", &fragment_streaming);
 
     // assert
-    ASSERT_IS_NULL(result);
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, &fragment_streaming, result);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x4245, result->on_ws_fragment_received_context);
+    g_destroy_option("ws_fragment_streaming", result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_506: [ If uws_client_clone_option is called with NULL name or value it shall return NULL. ]*/
-TEST_FUNCTION(uws_client_clone_option_with_NULL_name_fails)
+/* Tests_SRS_UWS_CLIENT_01_578: [ uws_client_clone_option called with name being ws_send_coalescing shall return a newly allocated copy of the size_t value. ]*/
+/* Tests_SRS_UWS_CLIENT_01_579: [ uws_client_destroy_option called with the option name being ws_send_coalescing shall free the value. ]*/
+TEST_FUNCTION(uws_client_clone_option_with_ws_send_coalescing_copies_the_value)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    void* result;
+    size_t send_coalescing_size = 1000;
+    size_t* result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -7242,24 +9182,32 @@ TEST_FUNCTION(uws_client_clone_option_with_NULL_name_fails)
     (void)uws_client_retrieve_options(uws_client);
     umock_c_reset_all_calls();
 
+    EXPECTED_CALL(gballoc_malloc(sizeof(size_t)));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
     // act
-    result = g_clone_option(NULL, (void*)0x4243);
+    result = (size_t*)g_clone_option("ws_send_coalescing", &send_coalescing_size);
 
     // assert
-    ASSERT_IS_NULL(result);
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, &send_coalescing_size, result);
+    ASSERT_ARE_EQUAL(size_t, 1000, *result);
+    g_destroy_option("ws_send_coalescing", result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_506: [ If uws_client_clone_option is called with NULL name or value it shall return NULL. ]*/
-TEST_FUNCTION(uws_client_clone_option_with_NULL_value_fails)
+/* Tests_SRS_UWS_CLIENT_01_594: [ uws_client_clone_option called with name being ws_send_fragment_size shall return a newly allocated copy of the size_t value. ]*/
+/* Tests_SRS_UWS_CLIENT_01_595: [ uws_client_destroy_option called with the option name being ws_send_fragment_size shall free the value. ]*/
+TEST_FUNCTION(uws_client_clone_option_with_ws_send_fragment_size_copies_the_value)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
-    void* result;
+    size_t send_fragment_size = 1000;
+    size_t* result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -7267,25 +9215,32 @@ TEST_FUNCTION(uws_client_clone_option_with_NULL_value_fails)
     (void)uws_client_retrieve_options(uws_client);
     umock_c_reset_all_calls();
 
+    EXPECTED_CALL(gballoc_malloc(sizeof(size_t)));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
     // act
-    result = g_clone_option("uWSClientOptions", NULL);
+    result = (size_t*)g_clone_option("ws_send_fragment_size", &send_fragment_size);
 
     // assert
-    ASSERT_IS_NULL(result);
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, &send_fragment_size, result);
+    ASSERT_ARE_EQUAL(size_t, 1000, *result);
+    g_destroy_option("ws_send_fragment_size", result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* uws_client_destroy_option */
-
-/* Tests_SRS_UWS_CLIENT_01_509: [ If uws_client_destroy_option is called with NULL name or value it shall do nothing. ]*/
-TEST_FUNCTION(uws_client_destroy_option_with_NULL_name_does_no_destroy)
+/* Tests_SRS_UWS_CLIENT_01_631: [ uws_client_clone_option called with name being ws_receive_buffer_size shall return a newly allocated copy of the size_t value. ]*/
+/* Tests_SRS_UWS_CLIENT_01_632: [ uws_client_destroy_option called with the option name being ws_receive_buffer_size shall free the value. ]*/
+TEST_FUNCTION(uws_client_clone_option_with_ws_receive_buffer_size_copies_the_value)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
+    size_t receive_buffer_size = 65536;
+    size_t* result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -7293,22 +9248,32 @@ TEST_FUNCTION(uws_client_destroy_option_with_NULL_name_does_no_destroy)
     (void)uws_client_retrieve_options(uws_client);
     umock_c_reset_all_calls();
 
+    EXPECTED_CALL(gballoc_malloc(sizeof(size_t)));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
     // act
-    g_destroy_option(NULL, (void*)0x4243);
+    result = (size_t*)g_clone_option("ws_receive_buffer_size", &receive_buffer_size);
 
     // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, &receive_buffer_size, result);
+    ASSERT_ARE_EQUAL(size_t, 65536, *result);
+    g_destroy_option("ws_receive_buffer_size", result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_509: [ If uws_client_destroy_option is called with NULL name or value it shall do nothing. ]*/
-TEST_FUNCTION(uws_client_destroy_option_with_NULL_value_does_no_destroy)
+/* Tests_SRS_UWS_CLIENT_01_645: [ uws_client_clone_option called with name being ws_receive_limits shall return a newly allocated copy of the WS_RECEIVE_LIMITS value. ]*/
+/* Tests_SRS_UWS_CLIENT_01_646: [ uws_client_destroy_option called with the option name being ws_receive_limits shall free the value. ]*/
+TEST_FUNCTION(uws_client_clone_option_with_ws_receive_limits_copies_the_value)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
+    WS_RECEIVE_LIMITS receive_limits = { 65536, 1048576, 2097152 };
+    WS_RECEIVE_LIMITS* result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
@@ -7316,58 +9281,96 @@ TEST_FUNCTION(uws_client_destroy_option_with_NULL_value_does_no_destroy)
     (void)uws_client_retrieve_options(uws_client);
     umock_c_reset_all_calls();
 
+    EXPECTED_CALL(gballoc_malloc(sizeof(WS_RECEIVE_LIMITS)));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
     // act
-    g_destroy_option("uWSClientOptions", NULL);
+    result = (WS_RECEIVE_LIMITS*)g_clone_option("ws_receive_limits", &receive_limits);
 
     // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, &receive_limits, result);
+    ASSERT_ARE_EQUAL(size_t, 65536, result->max_frame_size);
+    ASSERT_ARE_EQUAL(size_t, 1048576, result->max_message_size);
+    ASSERT_ARE_EQUAL(size_t, 2097152, result->receive_memory_budget);
+    g_destroy_option("ws_receive_limits", result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_513: [ If uws_client_destroy_option is called with any other name it shall do nothing. ]*/
-TEST_FUNCTION(uws_client_destroy_option_with_an_unknown_option_does_no_destroy)
+/* Tests_SRS_UWS_CLIENT_01_624: [ uws_client_clone_option called with name being ws_keepalive shall return a newly allocated copy of the WS_KEEPALIVE_OPTIONS value. ]*/
+/* Tests_SRS_UWS_CLIENT_01_625: [ uws_client_destroy_option called with the option name being ws_keepalive shall free the value. ]*/
+TEST_FUNCTION(uws_client_clone_option_with_ws_keepalive_copies_the_value)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
+    WS_KEEPALIVE_OPTIONS keepalive_options;
+    WS_KEEPALIVE_OPTIONS* result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
+    keepalive_options.ping_interval_ms = 30000;
+    keepalive_options.pong_timeout_ms = 5000;
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_retrieve_options(uws_client);
     umock_c_reset_all_calls();
 
+    EXPECTED_CALL(gballoc_malloc(sizeof(WS_KEEPALIVE_OPTIONS)));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
     // act
-    g_destroy_option("TrustedCerts", (void*)0x4243);
+    result = (WS_KEEPALIVE_OPTIONS*)g_clone_option("ws_keepalive", &keepalive_options);
 
     // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, &keepalive_options, result);
+    ASSERT_ARE_EQUAL(int, 30000, (int)result->ping_interval_ms);
+    ASSERT_ARE_EQUAL(int, 5000, (int)result->pong_timeout_ms);
+    g_destroy_option("ws_keepalive", result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     uws_client_destroy(uws_client);
 }
 
-/* Tests_SRS_UWS_CLIENT_01_508: [ uws_client_destroy_option called with the option name being uWSClientOptions shall destroy the value by calling OptionHandler_Destroy. ]*/
-TEST_FUNCTION(uws_client_destroy_option_with_uWSClientOptions_calls_OptionHandler_Destroy)
+/* Tests_SRS_UWS_CLIENT_01_555: [ uws_client_clone_option called with name being ws_permessage_deflate shall return a newly allocated copy of the WS_PERMESSAGE_DEFLATE_OPTIONS value. ]*/
+/* Tests_SRS_UWS_CLIENT_01_556: [ uws_client_destroy_option called with the option name being ws_permessage_deflate shall free the value. ]*/
+TEST_FUNCTION(uws_client_clone_option_with_ws_permessage_deflate_copies_the_value)
 {
     // arrange
     TLSIO_CONFIG tlsio_config;
     UWS_CLIENT_HANDLE uws_client;
+    WS_PERMESSAGE_DEFLATE_OPTIONS permessage_deflate_options;
+    WS_PERMESSAGE_DEFLATE_OPTIONS* result;
 
     tlsio_config.hostname = "test_host";
     tlsio_config.port = 444;
     uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
     (void)uws_client_retrieve_options(uws_client);
+    permessage_deflate_options.client_max_window_bits = 10;
+    permessage_deflate_options.server_max_window_bits = 12;
+    permessage_deflate_options.client_no_context_takeover = true;
+    permessage_deflate_options.server_no_context_takeover = false;
+    permessage_deflate_options.compression_level = 6;
+    permessage_deflate_options.mem_level = 4;
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(OptionHandler_Destroy(TEST_OPTIONHANDLER_HANDLE));
+    EXPECTED_CALL(gballoc_malloc(sizeof(WS_PERMESSAGE_DEFLATE_OPTIONS)));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
-    g_destroy_option("uWSClientOptions", TEST_OPTIONHANDLER_HANDLE);
+    result = (WS_PERMESSAGE_DEFLATE_OPTIONS*)g_clone_option("ws_permessage_deflate", &permessage_deflate_options);
 
     // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, &permessage_deflate_options, result);
+    ASSERT_ARE_EQUAL(int, 10, result->client_max_window_bits);
+    ASSERT_ARE_EQUAL(int, 12, result->server_max_window_bits);
+    ASSERT_ARE_EQUAL(int, 4, result->mem_level);
+    g_destroy_option("ws_permessage_deflate", result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
@@ -7396,7 +9399,6 @@ TEST_FUNCTION(underlying_io_close_after_a_send_close_frame_failed_puts_the_uws_i
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
@@ -7448,7 +9450,6 @@ TEST_FUNCTION(underlying_io_close_due_to_CLOSE_frame_being_received_doe_not_trig
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
@@ -7491,7 +9492,6 @@ TEST_FUNCTION(underlying_io_close_complete_with_NULL_context_does_nothing)
     g_on_bytes_received(g_on_bytes_received_context, (const unsigned char*)test_upgrade_response, sizeof(test_upgrade_response) - 1);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_frame_encoder_encode(WS_CLOSE_FRAME, NULL, 0, true, true, 0))
         .SetReturn(NULL);
     STRICT_EXPECTED_CALL(xio_close(TEST_IO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
@@ -7711,4 +9711,32 @@ TEST_FUNCTION(uws_client_set_request_header_success)
     uws_client_destroy(uws_client);
 }
 
+// Tests_SRS_UWS_CLIENT_01_583: [ On success the kept upgrade request shall be discarded, so that the next open sends the new header. ]
+TEST_FUNCTION(uws_client_set_request_header_discards_the_kept_upgrade_request)
+{
+    // arrange
+    UWS_CLIENT_HANDLE uws_client;
+    int result;
+    char* req_header1_key = "Authorization";
+    char* req_header1_value = "Bearer 23420939909809283488230949";
+
+    uws_client = uws_client_create("test_host", 444, "/aaa", true, protocols, sizeof(protocols) / sizeof(protocols[0]));
+    (void)uws_client_open_async(uws_client, test_on_ws_open_complete, (void*)0x4242, test_on_ws_frame_received, (void*)0x4243, test_on_ws_peer_closed, (void*)0x4301, test_on_ws_error, (void*)0x4244);
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(Map_AddOrUpdate(TEST_REQUEST_HEADERS_MAP, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = uws_client_set_request_header(uws_client, req_header1_key, req_header1_value);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    // cleanup
+    uws_client_destroy(uws_client);
+}
+
 END_TEST_SUITE(uws_client_ut)
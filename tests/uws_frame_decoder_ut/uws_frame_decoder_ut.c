@@ -0,0 +1,634 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#endif
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+
+void* real_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+void real_free(void* ptr)
+{
+    free(ptr);
+}
+
+#define ENABLE_MOCKS
+
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/uws_frame_encoder.h"
+
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/uws_frame_decoder.h"
+
+#define TEST_MAX_INDICATIONS 32
+
+typedef struct TEST_INDICATION_TAG
+{
+    WS_FRAME_HEADER header;
+    const unsigned char* payload;
+    size_t size;
+    uint64_t offset;
+} TEST_INDICATION;
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+static TEST_INDICATION indications[TEST_MAX_INDICATIONS];
+static size_t indication_count;
+static unsigned char indicated_payload[70000];
+static size_t indicated_payload_size;
+static void* test_context = (void*)0x4242;
+
+IMPLEMENT_UMOCK_C_ENUM_TYPE(WS_FRAME_TYPE, WS_FRAME_TYPE_VALUES);
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+static void my_uws_frame_encoder_mask(unsigned char* destination, const unsigned char* source, size_t length, const unsigned char* masking_key)
+{
+    size_t i;
+
+    for (i = 0; i < length; i++)
+    {
+        destination[i] = source[i] ^ masking_key[i % 4];
+    }
+}
+
+static void test_on_frame_decoded(void* context, const WS_FRAME_HEADER* header, const unsigned char* payload, size_t size, uint64_t offset)
+{
+    ASSERT_ARE_EQUAL(void_ptr, test_context, context);
+    if (indication_count < TEST_MAX_INDICATIONS)
+    {
+        indications[indication_count].header = *header;
+        indications[indication_count].payload = payload;
+        indications[indication_count].size = size;
+        indications[indication_count].offset = offset;
+    }
+    indication_count++;
+
+    ASSERT_IS_TRUE(indicated_payload_size + size <= sizeof(indicated_payload));
+    if (size > 0)
+    {
+        (void)memcpy(indicated_payload + indicated_payload_size, payload, size);
+        indicated_payload_size += size;
+    }
+}
+
+BEGIN_TEST_SUITE(uws_frame_decoder_ut)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, real_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, real_free);
+    REGISTER_GLOBAL_MOCK_HOOK(uws_frame_encoder_mask, my_uws_frame_encoder_mask);
+
+    REGISTER_TYPE(WS_FRAME_TYPE, WS_FRAME_TYPE);
+
+    REGISTER_UMOCK_ALIAS_TYPE(BUFFER_HANDLE, void*);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    umock_c_reset_all_calls();
+    indication_count = 0;
+    indicated_payload_size = 0;
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* uws_frame_decoder_create */
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_001: [ uws_frame_decoder_create shall create a decoder that indicates the frames it decodes to on_frame_decoded and return a non-NULL handle to it. ]*/
+TEST_FUNCTION(uws_frame_decoder_create_succeeds)
+{
+    // arrange
+    UWS_FRAME_DECODER_HANDLE result;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = uws_frame_decoder_create(test_on_frame_decoded, test_context);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_frame_decoder_destroy(result);
+}
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_002: [ If on_frame_decoded is NULL, uws_frame_decoder_create shall fail and return NULL. ]*/
+TEST_FUNCTION(uws_frame_decoder_create_with_NULL_on_frame_decoded_fails)
+{
+    // arrange
+    UWS_FRAME_DECODER_HANDLE result;
+
+    // act
+    result = uws_frame_decoder_create(NULL, test_context);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_003: [ If allocating memory for the decoder fails, uws_frame_decoder_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_allocating_memory_fails_uws_frame_decoder_create_fails)
+{
+    // arrange
+    UWS_FRAME_DECODER_HANDLE result;
+
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = uws_frame_decoder_create(test_on_frame_decoded, test_context);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* uws_frame_decoder_destroy */
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_004: [ uws_frame_decoder_destroy shall free the decoder. ]*/
+TEST_FUNCTION(uws_frame_decoder_destroy_frees_the_decoder)
+{
+    // arrange
+    UWS_FRAME_DECODER_HANDLE uws_frame_decoder = uws_frame_decoder_create(test_on_frame_decoded, test_context);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(gballoc_free(uws_frame_decoder));
+
+    // act
+    uws_frame_decoder_destroy(uws_frame_decoder);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_005: [ If uws_frame_decoder is NULL, uws_frame_decoder_destroy shall do nothing. ]*/
+TEST_FUNCTION(uws_frame_decoder_destroy_with_NULL_does_nothing)
+{
+    // arrange
+
+    // act
+    uws_frame_decoder_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* uws_frame_decoder_decode */
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_006: [ If uws_frame_decoder is NULL, or buffer is NULL and size is not 0, uws_frame_decoder_decode shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_decoder_decode_with_NULL_handle_fails)
+{
+    // arrange
+    const unsigned char frame[] = { 0x82, 0x00 };
+    int result;
+
+    // act
+    result = uws_frame_decoder_decode(NULL, frame, sizeof(frame));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_006: [ If uws_frame_decoder is NULL, or buffer is NULL and size is not 0, uws_frame_decoder_decode shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_decoder_decode_with_NULL_buffer_and_non_zero_size_fails)
+{
+    // arrange
+    UWS_FRAME_DECODER_HANDLE uws_frame_decoder = uws_frame_decoder_create(test_on_frame_decoded, test_context);
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_frame_decoder_decode(uws_frame_decoder, NULL, 1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_frame_decoder_destroy(uws_frame_decoder);
+}
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_016: [ On success uws_frame_decoder_decode shall return 0. ]*/
+TEST_FUNCTION(uws_frame_decoder_decode_with_NULL_buffer_and_zero_size_succeeds)
+{
+    // arrange
+    UWS_FRAME_DECODER_HANDLE uws_frame_decoder = uws_frame_decoder_create(test_on_frame_decoded, test_context);
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_frame_decoder_decode(uws_frame_decoder, NULL, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, indication_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_frame_decoder_destroy(uws_frame_decoder);
+}
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_007: [ uws_frame_decoder_decode shall decode the frames in the size bytes at buffer, the bytes of a header that is not complete yet being kept for the next call. ]*/
+/* Tests_SRS_UWS_FRAME_DECODER_01_008: [ Once all the bytes of a header are available, uws_frame_decoder_decode shall decode from them the FIN bit, the RSV bits, the opcode, the MASK bit, the payload length and the masking key as RFC6455 section 5.2 describes. ]*/
+/* Tests_SRS_UWS_FRAME_DECODER_01_012: [ The payload of a frame shall be indicated by calling on_frame_decoded with the bytes of buffer that hold it, without copying them. ]*/
+/* Tests_SRS_UWS_FRAME_DECODER_01_016: [ On success uws_frame_decoder_decode shall return 0. ]*/
+TEST_FUNCTION(uws_frame_decoder_decode_indicates_an_unmasked_frame_as_a_view_of_the_buffer)
+{
+    // arrange
+    UWS_FRAME_DECODER_HANDLE uws_frame_decoder = uws_frame_decoder_create(test_on_frame_decoded, test_context);
+    const unsigned char frame[] = { 0xA2, 0x03, 0x42, 0x43, 0x44 };
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_frame_decoder_decode(uws_frame_decoder, frame, sizeof(frame));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, indication_count);
+    ASSERT_ARE_EQUAL(int, (int)WS_BINARY_FRAME, (int)indications[0].header.opcode);
+    ASSERT_IS_TRUE(indications[0].header.is_final);
+    ASSERT_ARE_EQUAL(int, 2, (int)indications[0].header.reserved);
+    ASSERT_IS_FALSE(indications[0].header.is_masked);
+    ASSERT_ARE_EQUAL(uint64_t, 3, indications[0].header.payload_length);
+    ASSERT_ARE_EQUAL(void_ptr, frame + 2, indications[0].payload);
+    ASSERT_ARE_EQUAL(size_t, 3, indications[0].size);
+    ASSERT_ARE_EQUAL(uint64_t, 0, indications[0].offset);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_frame_decoder_destroy(uws_frame_decoder);
+}
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_007: [ uws_frame_decoder_decode shall decode the frames in the size bytes at buffer, the bytes of a header that is not complete yet being kept for the next call. ]*/
+TEST_FUNCTION(uws_frame_decoder_decode_decodes_a_frame_given_one_byte_at_a_time)
+{
+    // arrange
+    UWS_FRAME_DECODER_HANDLE uws_frame_decoder = uws_frame_decoder_create(test_on_frame_decoded, test_context);
+    const unsigned char frame[] = { 0x01, 0x7E, 0x00, 0x7E };
+    unsigned char payload[126];
+    size_t i;
+    int result = 0;
+    umock_c_reset_all_calls();
+
+    for (i = 0; i < sizeof(payload); i++)
+    {
+        payload[i] = (unsigned char)i;
+    }
+
+    // act
+    for (i = 0; i < sizeof(frame); i++)
+    {
+        result |= uws_frame_decoder_decode(uws_frame_decoder, &frame[i], 1);
+    }
+    ASSERT_ARE_EQUAL(size_t, 0, indication_count);
+    for (i = 0; i < sizeof(payload); i++)
+    {
+        result |= uws_frame_decoder_decode(uws_frame_decoder, &payload[i], 1);
+    }
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 126, indication_count);
+    ASSERT_ARE_EQUAL(int, (int)WS_TEXT_FRAME, (int)indications[0].header.opcode);
+    ASSERT_IS_FALSE(indications[0].header.is_final);
+    ASSERT_ARE_EQUAL(uint64_t, 126, indications[0].header.payload_length);
+    ASSERT_ARE_EQUAL(uint64_t, 0, indications[0].offset);
+    ASSERT_ARE_EQUAL(uint64_t, 31, indications[31].offset);
+    ASSERT_ARE_EQUAL(size_t, 1, indications[31].size);
+    ASSERT_ARE_EQUAL(size_t, sizeof(payload), indicated_payload_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(payload, indicated_payload, sizeof(payload)));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_frame_decoder_destroy(uws_frame_decoder);
+}
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_008: [ Once all the bytes of a header are available, uws_frame_decoder_decode shall decode from them the FIN bit, the RSV bits, the opcode, the MASK bit, the payload length and the masking key as RFC6455 section 5.2 describes. ]*/
+TEST_FUNCTION(uws_frame_decoder_decode_decodes_a_64_bit_payload_length)
+{
+    // arrange
+    UWS_FRAME_DECODER_HANDLE uws_frame_decoder = uws_frame_decoder_create(test_on_frame_decoded, test_context);
+    unsigned char* frame = (unsigned char*)malloc(10 + 65536);
+    int result;
+    umock_c_reset_all_calls();
+
+    frame[0] = 0x82;
+    frame[1] = 0x7F;
+    (void)memset(frame + 2, 0, 8);
+    frame[7] = 0x01;
+    (void)memset(frame + 10, 0x42, 65536);
+
+    // act
+    result = uws_frame_decoder_decode(uws_frame_decoder, frame, 10 + 1000);
+    result |= uws_frame_decoder_decode(uws_frame_decoder, frame + 10 + 1000, 65536 - 1000);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 2, indication_count);
+    ASSERT_ARE_EQUAL(uint64_t, 65536, indications[0].header.payload_length);
+    ASSERT_ARE_EQUAL(size_t, 1000, indications[0].size);
+    ASSERT_ARE_EQUAL(uint64_t, 0, indications[0].offset);
+    ASSERT_ARE_EQUAL(size_t, 65536 - 1000, indications[1].size);
+    ASSERT_ARE_EQUAL(uint64_t, 1000, indications[1].offset);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_frame_decoder_destroy(uws_frame_decoder);
+    free(frame);
+}
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_013: [ A masked payload shall be unmasked with uws_frame_encoder_mask into a buffer of the decoder and indicated in pieces of at most 4096 bytes. ]*/
+TEST_FUNCTION(uws_frame_decoder_decode_unmasks_a_masked_payload_split_inside_the_masking_key)
+{
+    // arrange
+    UWS_FRAME_DECODER_HANDLE uws_frame_decoder = uws_frame_decoder_create(test_on_frame_decoded, test_context);
+    const unsigned char frame[] = { 0x82, 0x85, 0x01, 0x02, 0x03, 0x04, 0x42 ^ 0x01, 0x43 ^ 0x02, 0x44 ^ 0x03, 0x45 ^ 0x04, 0x46 ^ 0x01 };
+    const unsigned char expected_payload[] = { 0x42, 0x43, 0x44, 0x45, 0x46 };
+    const unsigned char rotated_masking_key[] = { 0x04, 0x01, 0x02, 0x03 };
+    int result;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, frame + 6, 3, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(4, frame + 2, 4);
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, frame + 9, 2, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(4, rotated_masking_key, 4);
+
+    // act
+    result = uws_frame_decoder_decode(uws_frame_decoder, frame, 9);
+    result |= uws_frame_decoder_decode(uws_frame_decoder, frame + 9, sizeof(frame) - 9);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 2, indication_count);
+    ASSERT_IS_TRUE(indications[0].header.is_masked);
+    ASSERT_ARE_EQUAL(uint64_t, 3, indications[1].offset);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_payload), indicated_payload_size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(expected_payload, indicated_payload, sizeof(expected_payload)));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_frame_decoder_destroy(uws_frame_decoder);
+}
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_013: [ A masked payload shall be unmasked with uws_frame_encoder_mask into a buffer of the decoder and indicated in pieces of at most 4096 bytes. ]*/
+TEST_FUNCTION(uws_frame_decoder_decode_indicates_a_large_masked_payload_in_4096_byte_pieces)
+{
+    // arrange
+    UWS_FRAME_DECODER_HANDLE uws_frame_decoder = uws_frame_decoder_create(test_on_frame_decoded, test_context);
+    unsigned char* frame = (unsigned char*)malloc(8 + 10000);
+    int result;
+    umock_c_reset_all_calls();
+
+    frame[0] = 0x82;
+    frame[1] = 0xFE;
+    frame[2] = (unsigned char)(10000 >> 8);
+    frame[3] = (unsigned char)(10000 & 0xFF);
+    (void)memset(frame + 4, 0, 4 + 10000);
+
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, frame + 8, 4096, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, frame + 8 + 4096, 4096, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_frame_encoder_mask(IGNORED_PTR_ARG, frame + 8 + 8192, 10000 - 8192, IGNORED_PTR_ARG));
+
+    // act
+    result = uws_frame_decoder_decode(uws_frame_decoder, frame, 8 + 10000);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 3, indication_count);
+    ASSERT_ARE_EQUAL(uint64_t, 4096, indications[1].offset);
+    ASSERT_ARE_EQUAL(uint64_t, 8192, indications[2].offset);
+    ASSERT_ARE_EQUAL(size_t, 10000 - 8192, indications[2].size);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_frame_decoder_destroy(uws_frame_decoder);
+    free(frame);
+}
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_014: [ A frame without payload shall be indicated once, with payload NULL and size 0. ]*/
+TEST_FUNCTION(uws_frame_decoder_decode_indicates_a_frame_without_payload_once)
+{
+    // arrange
+    UWS_FRAME_DECODER_HANDLE uws_frame_decoder = uws_frame_decoder_create(test_on_frame_decoded, test_context);
+    const unsigned char frame[] = { 0x89, 0x80, 0x01, 0x02, 0x03, 0x04 };
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_frame_decoder_decode(uws_frame_decoder, frame, sizeof(frame));
+    result |= uws_frame_decoder_decode(uws_frame_decoder, NULL, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, indication_count);
+    ASSERT_ARE_EQUAL(int, (int)WS_PING_FRAME, (int)indications[0].header.opcode);
+    ASSERT_IS_NULL(indications[0].payload);
+    ASSERT_ARE_EQUAL(size_t, 0, indications[0].size);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_frame_decoder_destroy(uws_frame_decoder);
+}
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_007: [ uws_frame_decoder_decode shall decode the frames in the size bytes at buffer, the bytes of a header that is not complete yet being kept for the next call. ]*/
+TEST_FUNCTION(uws_frame_decoder_decode_decodes_several_frames_from_one_buffer)
+{
+    // arrange
+    UWS_FRAME_DECODER_HANDLE uws_frame_decoder = uws_frame_decoder_create(test_on_frame_decoded, test_context);
+    const unsigned char frames[] = { 0x01, 0x01, 0x41, 0x8A, 0x00, 0x80, 0x02, 0x42, 0x43 };
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_frame_decoder_decode(uws_frame_decoder, frames, sizeof(frames));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 3, indication_count);
+    ASSERT_ARE_EQUAL(int, (int)WS_TEXT_FRAME, (int)indications[0].header.opcode);
+    ASSERT_ARE_EQUAL(int, (int)WS_PONG_FRAME, (int)indications[1].header.opcode);
+    ASSERT_ARE_EQUAL(int, (int)WS_CONTINUATION_FRAME, (int)indications[2].header.opcode);
+    ASSERT_IS_TRUE(indications[2].header.is_final);
+    ASSERT_ARE_EQUAL(void_ptr, frames + 7, indications[2].payload);
+    ASSERT_ARE_EQUAL(size_t, 2, indications[2].size);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_frame_decoder_destroy(uws_frame_decoder);
+}
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_009: [ If the payload length is not encoded with the minimal number of bytes, uws_frame_decoder_decode shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_decoder_decode_with_a_16_bit_length_below_126_fails)
+{
+    // arrange
+    UWS_FRAME_DECODER_HANDLE uws_frame_decoder = uws_frame_decoder_create(test_on_frame_decoded, test_context);
+    const unsigned char frame[] = { 0x82, 0x7E, 0x00, 0x7D };
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_frame_decoder_decode(uws_frame_decoder, frame, sizeof(frame));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, indication_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_frame_decoder_destroy(uws_frame_decoder);
+}
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_009: [ If the payload length is not encoded with the minimal number of bytes, uws_frame_decoder_decode shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_decoder_decode_with_a_64_bit_length_below_65536_fails)
+{
+    // arrange
+    UWS_FRAME_DECODER_HANDLE uws_frame_decoder = uws_frame_decoder_create(test_on_frame_decoded, test_context);
+    const unsigned char frame[] = { 0x82, 0x7F, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xFF, 0xFF };
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_frame_decoder_decode(uws_frame_decoder, frame, sizeof(frame));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, indication_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_frame_decoder_destroy(uws_frame_decoder);
+}
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_010: [ If the most significant bit of a 64 bit payload length is set, uws_frame_decoder_decode shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_decoder_decode_with_the_highest_bit_of_a_64_bit_length_set_fails)
+{
+    // arrange
+    UWS_FRAME_DECODER_HANDLE uws_frame_decoder = uws_frame_decoder_create(test_on_frame_decoded, test_context);
+    const unsigned char frame[] = { 0x82, 0x7F, 0x80, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 };
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_frame_decoder_decode(uws_frame_decoder, frame, sizeof(frame));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, indication_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_frame_decoder_destroy(uws_frame_decoder);
+}
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_011: [ If a control frame (opcode 0x8 or higher) is fragmented or has more than 125 bytes of payload, uws_frame_decoder_decode shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_decoder_decode_with_a_fragmented_control_frame_fails)
+{
+    // arrange
+    UWS_FRAME_DECODER_HANDLE uws_frame_decoder = uws_frame_decoder_create(test_on_frame_decoded, test_context);
+    const unsigned char frame[] = { 0x09, 0x00 };
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_frame_decoder_decode(uws_frame_decoder, frame, sizeof(frame));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, indication_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_frame_decoder_destroy(uws_frame_decoder);
+}
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_011: [ If a control frame (opcode 0x8 or higher) is fragmented or has more than 125 bytes of payload, uws_frame_decoder_decode shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_decoder_decode_with_a_control_frame_of_126_bytes_fails)
+{
+    // arrange
+    UWS_FRAME_DECODER_HANDLE uws_frame_decoder = uws_frame_decoder_create(test_on_frame_decoded, test_context);
+    const unsigned char frame[] = { 0x88, 0x7E, 0x00, 0x7E };
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_frame_decoder_decode(uws_frame_decoder, frame, sizeof(frame));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, indication_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_frame_decoder_destroy(uws_frame_decoder);
+}
+
+/* Tests_SRS_UWS_FRAME_DECODER_01_015: [ Once decoding failed, uws_frame_decoder_decode shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_decoder_decode_after_a_failure_fails)
+{
+    // arrange
+    UWS_FRAME_DECODER_HANDLE uws_frame_decoder = uws_frame_decoder_create(test_on_frame_decoded, test_context);
+    const unsigned char bad_frame[] = { 0x09, 0x00 };
+    const unsigned char good_frame[] = { 0x82, 0x01, 0x42 };
+    int result;
+    (void)uws_frame_decoder_decode(uws_frame_decoder, bad_frame, sizeof(bad_frame));
+    umock_c_reset_all_calls();
+
+    // act
+    result = uws_frame_decoder_decode(uws_frame_decoder, good_frame, sizeof(good_frame));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 0, indication_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    uws_frame_decoder_destroy(uws_frame_decoder);
+}
+
+END_TEST_SUITE(uws_frame_decoder_ut)
@@ -1415,4 +1415,178 @@ TEST_FUNCTION(uws_frame_encoder_encode_masks_a_8_byte_frame_with_different_mask_
     real_BUFFER_delete(result);
 }
 
+/* Tests_SRS_UWS_FRAME_ENCODER_01_041: [ Octet i of the transformed data ("transformed-octet-i") is the XOR of octet i of the original data ("original-octet-i") with octet at index i modulo 4 of the masking key ("masking-key-octet-j"): ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_masks_a_19_byte_frame_that_is_not_a_multiple_of_the_word_size)
+{
+    // arrange
+    BUFFER_HANDLE result;
+    BUFFER_HANDLE newly_created_buffer;
+    unsigned char payload[] = { 0x0B, 0x30, 0x55, 0x7A, 0x9F, 0xC4, 0xE9, 0x0E, 0x33, 0x58, 0x7D, 0xA2, 0xC7, 0xEC, 0x11, 0x36, 0x5B, 0x80, 0xA5 };
+    unsigned char expected_bytes[] = { 0x82, 0x93, 0x00, 0xFF, 0xAA, 0x42, 0x0B, 0xCF, 0xFF, 0x38, 0x9F, 0x3B, 0x43, 0x4C, 0x33, 0xA7, 0xD7, 0xE0, 0xC7, 0x13, 0xBB, 0x74, 0x5B, 0x7F, 0x0F };
+
+    STRICT_EXPECTED_CALL(BUFFER_new())
+        .CaptureReturn(&newly_created_buffer);
+    STRICT_EXPECTED_CALL(BUFFER_enlarge(IGNORED_PTR_ARG, sizeof(expected_bytes)))
+        .ValidateArgumentValue_handle(&newly_created_buffer);
+    STRICT_EXPECTED_CALL(BUFFER_u_char(IGNORED_PTR_ARG))
+        .ValidateArgumentValue_handle(&newly_created_buffer);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0x00);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0xFF);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0xAA);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0x42);
+
+    // act
+    result = uws_frame_encoder_encode(WS_BINARY_FRAME, payload, sizeof(payload), true, true, 0);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_encoded_str, sizeof(expected_encoded_str));
+    stringify_bytes(real_BUFFER_u_char(result), real_BUFFER_length(result), actual_encoded_str, sizeof(actual_encoded_str));
+    ASSERT_ARE_EQUAL(char_ptr, expected_encoded_str, actual_encoded_str);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    real_BUFFER_delete(result);
+}
+
+/* uws_frame_encoder_encode_header */
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_056: [ If header or header_size is NULL, uws_frame_encoder_encode_header shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_with_NULL_header_fails)
+{
+    // arrange
+    size_t header_size;
+    int result;
+
+    // act
+    result = uws_frame_encoder_encode_header(WS_BINARY_FRAME, 1, true, true, 0, NULL, &header_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_056: [ If header or header_size is NULL, uws_frame_encoder_encode_header shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_with_NULL_header_size_fails)
+{
+    // arrange
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    int result;
+
+    // act
+    result = uws_frame_encoder_encode_header(WS_BINARY_FRAME, 1, true, true, 0, header, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_057: [ If reserved has any bits set except the lowest 3 or opcode is greater than 0x0F, uws_frame_encoder_encode_header shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_with_reserved_8_fails)
+{
+    // arrange
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    size_t header_size;
+    int result;
+
+    // act
+    result = uws_frame_encoder_encode_header(WS_BINARY_FRAME, 1, true, true, 8, header, &header_size);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_055: [ uws_frame_encoder_encode_header shall write at header the header that uws_frame_encoder_encode produces for a payload of length bytes, set *header_size to its size and return 0. ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_writes_an_unmasked_header_for_126_bytes)
+{
+    // arrange
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    unsigned char expected_bytes[] = { 0x82, 0x7E, 0x00, 0x7E };
+    size_t header_size;
+    int result;
+
+    // act
+    result = uws_frame_encoder_encode_header(WS_BINARY_FRAME, 126, false, true, 0, header, &header_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, sizeof(expected_bytes), header_size);
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_encoded_str, sizeof(expected_encoded_str));
+    stringify_bytes(header, header_size, actual_encoded_str, sizeof(actual_encoded_str));
+    ASSERT_ARE_EQUAL(char_ptr, expected_encoded_str, actual_encoded_str);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_055: [ uws_frame_encoder_encode_header shall write at header the header that uws_frame_encoder_encode produces for a payload of length bytes, set *header_size to its size and return 0. ]*/
+/* Tests_SRS_UWS_FRAME_ENCODER_01_053: [ In order to obtain a 32 bit value for masking, gb_rand shall be used 4 times (for each byte). ]*/
+TEST_FUNCTION(uws_frame_encoder_encode_header_writes_a_masked_header_for_65536_bytes)
+{
+    // arrange
+    unsigned char header[UWS_FRAME_ENCODER_MAX_HEADER_SIZE];
+    unsigned char expected_bytes[] = { 0x01, 0xFF, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 0xFF, 0xAA, 0x42 };
+    size_t header_size;
+    int result;
+
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0x00);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0xFF);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0xAA);
+    STRICT_EXPECTED_CALL(gb_rand())
+        .SetReturn(0x42);
+
+    // act
+    result = uws_frame_encoder_encode_header(WS_TEXT_FRAME, 65536, true, false, 0, header, &header_size);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, UWS_FRAME_ENCODER_MAX_HEADER_SIZE, header_size);
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_encoded_str, sizeof(expected_encoded_str));
+    stringify_bytes(header, header_size, actual_encoded_str, sizeof(actual_encoded_str));
+    ASSERT_ARE_EQUAL(char_ptr, expected_encoded_str, actual_encoded_str);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* uws_frame_encoder_mask */
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_058: [ uws_frame_encoder_mask shall write at destination the length bytes of source XORed with masking_key as RFC6455 section 5.3 describes; destination may be source. ]*/
+TEST_FUNCTION(uws_frame_encoder_mask_masks_19_bytes_in_place)
+{
+    // arrange
+    unsigned char masking_key[] = { 0x00, 0xFF, 0xAA, 0x42 };
+    unsigned char payload[] = { 0x0B, 0x30, 0x55, 0x7A, 0x9F, 0xC4, 0xE9, 0x0E, 0x33, 0x58, 0x7D, 0xA2, 0xC7, 0xEC, 0x11, 0x36, 0x5B, 0x80, 0xA5 };
+    unsigned char expected_bytes[] = { 0x0B, 0xCF, 0xFF, 0x38, 0x9F, 0x3B, 0x43, 0x4C, 0x33, 0xA7, 0xD7, 0xE0, 0xC7, 0x13, 0xBB, 0x74, 0x5B, 0x7F, 0x0F };
+
+    // act
+    uws_frame_encoder_mask(payload, payload, sizeof(payload), masking_key);
+
+    // assert
+    stringify_bytes(expected_bytes, sizeof(expected_bytes), expected_encoded_str, sizeof(expected_encoded_str));
+    stringify_bytes(payload, sizeof(payload), actual_encoded_str, sizeof(actual_encoded_str));
+    ASSERT_ARE_EQUAL(char_ptr, expected_encoded_str, actual_encoded_str);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_UWS_FRAME_ENCODER_01_059: [ If length is greater than 0 and destination, source or masking_key is NULL, uws_frame_encoder_mask shall do nothing. ]*/
+TEST_FUNCTION(uws_frame_encoder_mask_with_NULL_masking_key_does_nothing)
+{
+    // arrange
+    unsigned char payload[] = { 0x42, 0x43 };
+    unsigned char destination[] = { 0x00, 0x00 };
+
+    // act
+    uws_frame_encoder_mask(destination, payload, sizeof(payload), NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, destination[0]);
+    ASSERT_ARE_EQUAL(int, 0, destination[1]);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
 END_TEST_SUITE(uws_frame_encoder_ut)
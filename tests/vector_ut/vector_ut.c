@@ -769,7 +769,7 @@ BEGIN_TEST_SUITE(Vector_UnitTests)
         VECTOR_destroy(handle);
     }
 
-    /* Tests_SRS_VECTOR_10_014: [VECTOR_erase shall remove the numElements starting at elements and reduce its internal storage.] */
+    /* Tests_SRS_VECTOR_10_014: [VECTOR_erase shall remove the numElements starting at elements, keeping the order of the remaining elements.] */
     TEST_FUNCTION(VECTOR_erase_succeeds_case_1)
     {
         ///arrange
@@ -782,8 +782,6 @@ BEGIN_TEST_SUITE(Vector_UnitTests)
         (void)VECTOR_push_back(handle, &sItem2, 1);
         pfindItem = (VECTOR_UNITTEST*)VECTOR_find_if(handle, VECTOR_UNITTEST_isEqual, &sItem1);
         umock_c_reset_all_calls();
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, sizeof(VECTOR_UNITTEST)))
-            .IgnoreArgument_ptr();
 
         ///act
         VECTOR_erase(handle, pfindItem, 1);
@@ -799,7 +797,7 @@ BEGIN_TEST_SUITE(Vector_UnitTests)
         VECTOR_destroy(handle);
     }
 
-    /* Tests_SRS_VECTOR_10_014: [VECTOR_erase shall remove the numElements starting at elements and reduce its internal storage.] */
+    /* Tests_SRS_VECTOR_10_047: [VECTOR_erase shall release the internal storage when the vector becomes empty.] */
     TEST_FUNCTION(VECTOR_erase_succeeds_case_2)
     {
         ///arrange
@@ -829,34 +827,32 @@ BEGIN_TEST_SUITE(Vector_UnitTests)
         VECTOR_destroy(handle);
     }
 
-    /* Tests_SRS_VECTOR_10_014: [VECTOR_erase shall remove the numElements starting at elements and reduce its internal storage.] */
+    /* Tests_SRS_VECTOR_10_014: [VECTOR_erase shall remove the numElements starting at elements, keeping the order of the remaining elements.] */
     TEST_FUNCTION(VECTOR_erase_succeeds_case_3)
     {
         ///arrange
         size_t num;
-        VECTOR_UNITTEST* pfindItem;
+        VECTOR_UNITTEST* pResult;
         VECTOR_UNITTEST sItem1 = {1, 2};
         VECTOR_UNITTEST sItem2 = {3, 4};
+        VECTOR_UNITTEST sItem3 = {5, 6};
         VECTOR_HANDLE handle = VECTOR_create(sizeof(VECTOR_UNITTEST));
         (void)VECTOR_push_back(handle, &sItem1, 1);
         (void)VECTOR_push_back(handle, &sItem2, 1);
-        pfindItem = (VECTOR_UNITTEST*)VECTOR_find_if(handle, VECTOR_UNITTEST_isEqual, &sItem1);
+        (void)VECTOR_push_back(handle, &sItem3, 1);
         umock_c_reset_all_calls();
-        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, IGNORED_NUM_ARG))
-            .IgnoreArgument_ptr()
-            .IgnoreArgument_size()
-            .SetReturn(NULL);
 
         ///act
-        VECTOR_erase(handle, pfindItem, 1);
+        VECTOR_erase(handle, VECTOR_front(handle), 1);
 
         ///assert
         num = VECTOR_size(handle);
-        ASSERT_ARE_EQUAL(size_t, 1, num);
-        pfindItem = (VECTOR_UNITTEST*)VECTOR_find_if(handle, VECTOR_UNITTEST_isEqual, &sItem1);
-        ASSERT_IS_NULL(pfindItem);
-        pfindItem = (VECTOR_UNITTEST*)VECTOR_find_if(handle, VECTOR_UNITTEST_isEqual, &sItem2);
-        ASSERT_IS_NOT_NULL(pfindItem);
+        ASSERT_ARE_EQUAL(size_t, 2, num);
+        pResult = (VECTOR_UNITTEST*)VECTOR_element(handle, 0);
+        ASSERT_ARE_EQUAL(int, sItem2.nValue1, pResult->nValue1);
+        pResult = (VECTOR_UNITTEST*)VECTOR_element(handle, 1);
+        ASSERT_ARE_EQUAL(int, sItem3.nValue1, pResult->nValue1);
+        ASSERT_ARE_EQUAL(size_t, 4, VECTOR_capacity(handle));
         ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
         ///cleanup
@@ -991,6 +987,7 @@ BEGIN_TEST_SUITE(Vector_UnitTests)
         VECTOR_destroy(handle);
     }
 
+    /* Tests_SRS_VECTOR_10_042: [VECTOR_push_back shall only reallocate the internal storage when its capacity is exceeded, at least doubling it.] */
     TEST_FUNCTION(VECTOR_push_back_multiple_elements_succeeds)
     {
         ///arrange
@@ -1000,9 +997,9 @@ BEGIN_TEST_SUITE(Vector_UnitTests)
         VECTOR_UNITTEST sItem1 = {1, 2};
         VECTOR_HANDLE handle = VECTOR_create(sizeof(VECTOR_UNITTEST));
         umock_c_reset_all_calls();
-        for (nIndex = 0; nIndex < NUM_ITEM_PUSH_BACK; nIndex++)
+        for (nIndex = 1; nIndex <= NUM_ITEM_PUSH_BACK; nIndex *= 2)
         {
-            STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, (nIndex + 1) * sizeof(VECTOR_UNITTEST)))
+            STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, nIndex * sizeof(VECTOR_UNITTEST)))
                 .IgnoreArgument_ptr();
         }
 
@@ -1026,6 +1023,349 @@ BEGIN_TEST_SUITE(Vector_UnitTests)
         VECTOR_destroy(handle);
     }
 
+    /* Tests_SRS_VECTOR_10_042: [VECTOR_push_back shall only reallocate the internal storage when its capacity is exceeded, at least doubling it.] */
+    TEST_FUNCTION(VECTOR_push_back_grows_to_fit_a_large_append)
+    {
+        ///arrange
+        int result;
+        VECTOR_UNITTEST sItems[5] = { {1, 2}, {3, 4}, {5, 6}, {7, 8}, {9, 10} };
+        VECTOR_HANDLE handle = VECTOR_create(sizeof(VECTOR_UNITTEST));
+        (void)VECTOR_push_back(handle, &sItems[0], 1);
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, 5 * sizeof(VECTOR_UNITTEST)))
+            .IgnoreArgument_ptr();
+
+        ///act
+        result = VECTOR_push_back(handle, &sItems[1], 4);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, 5, VECTOR_size(handle));
+        ASSERT_ARE_EQUAL(size_t, 5, VECTOR_capacity(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        VECTOR_destroy(handle);
+    }
+
+    /* Tests_SRS_VECTOR_10_043: [VECTOR_reserve shall fail and return non-zero if handle is NULL.] */
+    TEST_FUNCTION(VECTOR_reserve_fails_if_handle_is_NULL)
+    {
+        ///arrange
+        int result;
+
+        ///act
+        result = VECTOR_reserve(NULL, 10);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_VECTOR_10_045: [VECTOR_reserve shall grow the internal storage to hold exactly numElements elements and return 0.] */
+    TEST_FUNCTION(VECTOR_reserve_succeeds)
+    {
+        ///arrange
+        int result;
+        size_t nIndex;
+        VECTOR_UNITTEST sItem1 = {1, 2};
+        VECTOR_HANDLE handle = VECTOR_create(sizeof(VECTOR_UNITTEST));
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(gballoc_realloc(NULL, NUM_ITEM_PUSH_BACK * sizeof(VECTOR_UNITTEST)));
+
+        ///act
+        result = VECTOR_reserve(handle, NUM_ITEM_PUSH_BACK);
+        for (nIndex = 0; nIndex < NUM_ITEM_PUSH_BACK; nIndex++)
+        {
+            (void)VECTOR_push_back(handle, &sItem1, 1);
+        }
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, NUM_ITEM_PUSH_BACK, VECTOR_size(handle));
+        ASSERT_ARE_EQUAL(size_t, NUM_ITEM_PUSH_BACK, VECTOR_capacity(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        VECTOR_destroy(handle);
+    }
+
+    /* Tests_SRS_VECTOR_10_044: [VECTOR_reserve shall return 0 without allocating if the capacity is already at least numElements.] */
+    TEST_FUNCTION(VECTOR_reserve_smaller_than_capacity_does_not_allocate)
+    {
+        ///arrange
+        int result;
+        VECTOR_HANDLE handle = VECTOR_create(sizeof(VECTOR_UNITTEST));
+        (void)VECTOR_reserve(handle, 4);
+        umock_c_reset_all_calls();
+
+        ///act
+        result = VECTOR_reserve(handle, 2);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, 4, VECTOR_capacity(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        VECTOR_destroy(handle);
+    }
+
+    /* Tests_SRS_VECTOR_10_046: [VECTOR_reserve shall fail and return non-zero if memory allocation fails.] */
+    TEST_FUNCTION(VECTOR_reserve_fails_if_realloc_fails)
+    {
+        ///arrange
+        int result;
+        VECTOR_HANDLE handle = VECTOR_create(sizeof(VECTOR_UNITTEST));
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(gballoc_realloc(NULL, 4 * sizeof(VECTOR_UNITTEST)))
+            .SetReturn(NULL);
+
+        ///act
+        result = VECTOR_reserve(handle, 4);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, 0, VECTOR_capacity(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        VECTOR_destroy(handle);
+    }
+
+    /* Tests_SRS_VECTOR_10_048: [VECTOR_erase_unordered shall return if handle or elements are NULL or numElements is 0.] */
+    TEST_FUNCTION(VECTOR_erase_unordered_if_handle_is_NULL)
+    {
+        ///arrange
+        VECTOR_UNITTEST sItem1 = {1, 2};
+
+        ///act
+        VECTOR_erase_unordered(NULL, &sItem1, 1);
+
+        ///assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_VECTOR_10_049: [VECTOR_erase_unordered shall return if the numElements starting at elements are out of bound or misaligned.] */
+    TEST_FUNCTION(VECTOR_erase_unordered_numElements_out_of_bound)
+    {
+        ///arrange
+        VECTOR_UNITTEST sItem1 = {1, 2};
+        VECTOR_UNITTEST sItem2 = {3, 4};
+        VECTOR_HANDLE handle = VECTOR_create(sizeof(VECTOR_UNITTEST));
+        (void)VECTOR_push_back(handle, &sItem1, 1);
+        (void)VECTOR_push_back(handle, &sItem2, 1);
+        umock_c_reset_all_calls();
+
+        ///act
+        VECTOR_erase_unordered(handle, VECTOR_back(handle), 2);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 2, VECTOR_size(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        VECTOR_destroy(handle);
+    }
+
+    /* Tests_SRS_VECTOR_10_050: [VECTOR_erase_unordered shall remove the numElements starting at elements by moving the last elements of the vector in their place.] */
+    TEST_FUNCTION(VECTOR_erase_unordered_succeeds)
+    {
+        ///arrange
+        VECTOR_UNITTEST* pResult;
+        VECTOR_UNITTEST sItems[4] = { {1, 2}, {3, 4}, {5, 6}, {7, 8} };
+        VECTOR_HANDLE handle = VECTOR_create(sizeof(VECTOR_UNITTEST));
+        (void)VECTOR_push_back(handle, sItems, 4);
+        umock_c_reset_all_calls();
+
+        ///act
+        VECTOR_erase_unordered(handle, VECTOR_front(handle), 1);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 3, VECTOR_size(handle));
+        pResult = (VECTOR_UNITTEST*)VECTOR_element(handle, 0);
+        ASSERT_ARE_EQUAL(int, sItems[3].nValue1, pResult->nValue1);
+        pResult = (VECTOR_UNITTEST*)VECTOR_element(handle, 1);
+        ASSERT_ARE_EQUAL(int, sItems[1].nValue1, pResult->nValue1);
+        pResult = (VECTOR_UNITTEST*)VECTOR_element(handle, 2);
+        ASSERT_ARE_EQUAL(int, sItems[2].nValue1, pResult->nValue1);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        VECTOR_destroy(handle);
+    }
+
+    /* Tests_SRS_VECTOR_10_050: [VECTOR_erase_unordered shall remove the numElements starting at elements by moving the last elements of the vector in their place.] */
+    TEST_FUNCTION(VECTOR_erase_unordered_overlapping_tail_succeeds)
+    {
+        ///arrange
+        VECTOR_UNITTEST* pResult;
+        VECTOR_UNITTEST sItems[4] = { {1, 2}, {3, 4}, {5, 6}, {7, 8} };
+        VECTOR_HANDLE handle = VECTOR_create(sizeof(VECTOR_UNITTEST));
+        (void)VECTOR_push_back(handle, sItems, 4);
+        umock_c_reset_all_calls();
+
+        ///act
+        VECTOR_erase_unordered(handle, VECTOR_element(handle, 1), 2);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 2, VECTOR_size(handle));
+        pResult = (VECTOR_UNITTEST*)VECTOR_element(handle, 0);
+        ASSERT_ARE_EQUAL(int, sItems[0].nValue1, pResult->nValue1);
+        pResult = (VECTOR_UNITTEST*)VECTOR_element(handle, 1);
+        ASSERT_ARE_EQUAL(int, sItems[3].nValue1, pResult->nValue1);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        VECTOR_destroy(handle);
+    }
+
+    /* Tests_SRS_VECTOR_10_051: [VECTOR_erase_unordered shall release the internal storage when the vector becomes empty.] */
+    TEST_FUNCTION(VECTOR_erase_unordered_all_frees_storage)
+    {
+        ///arrange
+        VECTOR_UNITTEST sItem1 = {1, 2};
+        VECTOR_HANDLE handle = VECTOR_create(sizeof(VECTOR_UNITTEST));
+        (void)VECTOR_push_back(handle, &sItem1, 1);
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument_ptr();
+
+        ///act
+        VECTOR_erase_unordered(handle, VECTOR_front(handle), 1);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 0, VECTOR_size(handle));
+        ASSERT_ARE_EQUAL(size_t, 0, VECTOR_capacity(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        VECTOR_destroy(handle);
+    }
+
+    /* Tests_SRS_VECTOR_10_053: [VECTOR_capacity shall return 0 if the given handle is NULL.] */
+    TEST_FUNCTION(VECTOR_capacity_fails_if_handle_is_NULL)
+    {
+        ///arrange
+
+        ///act
+        size_t num = VECTOR_capacity(NULL);
+
+        ///assert
+        ASSERT_ARE_EQUAL(size_t, 0, num);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_VECTOR_10_054: [VECTOR_shrink_to_fit shall fail and return non-zero if handle is NULL.] */
+    TEST_FUNCTION(VECTOR_shrink_to_fit_fails_if_handle_is_NULL)
+    {
+        ///arrange
+        int result;
+
+        ///act
+        result = VECTOR_shrink_to_fit(NULL);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /* Tests_SRS_VECTOR_10_055: [VECTOR_shrink_to_fit shall return 0 without reallocating if the capacity already equals the size.] */
+    TEST_FUNCTION(VECTOR_shrink_to_fit_when_full_does_not_allocate)
+    {
+        ///arrange
+        int result;
+        VECTOR_UNITTEST sItem1 = {1, 2};
+        VECTOR_HANDLE handle = VECTOR_create(sizeof(VECTOR_UNITTEST));
+        (void)VECTOR_push_back(handle, &sItem1, 1);
+        umock_c_reset_all_calls();
+
+        ///act
+        result = VECTOR_shrink_to_fit(handle);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        VECTOR_destroy(handle);
+    }
+
+    /* Tests_SRS_VECTOR_10_056: [VECTOR_shrink_to_fit shall release the internal storage of an empty vector.] */
+    TEST_FUNCTION(VECTOR_shrink_to_fit_empty_frees_storage)
+    {
+        ///arrange
+        int result;
+        VECTOR_HANDLE handle = VECTOR_create(sizeof(VECTOR_UNITTEST));
+        (void)VECTOR_reserve(handle, 4);
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG))
+            .IgnoreArgument_ptr();
+
+        ///act
+        result = VECTOR_shrink_to_fit(handle);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, 0, VECTOR_capacity(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        VECTOR_destroy(handle);
+    }
+
+    /* Tests_SRS_VECTOR_10_057: [VECTOR_shrink_to_fit shall reduce the internal storage to the size of the vector and return 0.] */
+    TEST_FUNCTION(VECTOR_shrink_to_fit_succeeds)
+    {
+        ///arrange
+        int result;
+        VECTOR_UNITTEST sItem1 = {1, 2};
+        VECTOR_HANDLE handle = VECTOR_create(sizeof(VECTOR_UNITTEST));
+        (void)VECTOR_reserve(handle, 4);
+        (void)VECTOR_push_back(handle, &sItem1, 1);
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, sizeof(VECTOR_UNITTEST)))
+            .IgnoreArgument_ptr();
+
+        ///act
+        result = VECTOR_shrink_to_fit(handle);
+
+        ///assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, 1, VECTOR_capacity(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        VECTOR_destroy(handle);
+    }
+
+    /* Tests_SRS_VECTOR_10_058: [VECTOR_shrink_to_fit shall fail and return non-zero if memory allocation fails, leaving the vector unchanged.] */
+    TEST_FUNCTION(VECTOR_shrink_to_fit_fails_if_realloc_fails)
+    {
+        ///arrange
+        int result;
+        VECTOR_UNITTEST sItem1 = {1, 2};
+        VECTOR_HANDLE handle = VECTOR_create(sizeof(VECTOR_UNITTEST));
+        (void)VECTOR_reserve(handle, 4);
+        (void)VECTOR_push_back(handle, &sItem1, 1);
+        umock_c_reset_all_calls();
+        STRICT_EXPECTED_CALL(gballoc_realloc(IGNORED_PTR_ARG, sizeof(VECTOR_UNITTEST)))
+            .IgnoreArgument_ptr()
+            .SetReturn(NULL);
+
+        ///act
+        result = VECTOR_shrink_to_fit(handle);
+
+        ///assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(size_t, 4, VECTOR_capacity(handle));
+        ASSERT_ARE_EQUAL(size_t, 1, VECTOR_size(handle));
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        ///cleanup
+        VECTOR_destroy(handle);
+    }
+
     /* Vector_Tests END */
 
 END_TEST_SUITE(Vector_UnitTests)
@@ -20,18 +20,13 @@
 
 #include "azure_c_shared_utility/xio.h"
 #include "azure_c_shared_utility/crt_abstractions.h"
-#include "azure_c_shared_utility/singlylinkedlist.h"
 #include "azure_c_shared_utility/optionhandler.h"
 #include "azure_c_shared_utility/uws_client.h"
 
-static const void** list_items = NULL;
-static size_t list_item_count = 0;
 static const char* TEST_HOST_ADDRESS = "host_address.com";
 static const char* TEST_RESOURCE_NAME = "/test_resource";
 static const char* TEST_PROTOCOL = "test_proto";
 
-static const SINGLYLINKEDLIST_HANDLE TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE = (SINGLYLINKEDLIST_HANDLE)0x4242;
-static const LIST_ITEM_HANDLE TEST_LIST_ITEM_HANDLE = (LIST_ITEM_HANDLE)0x11;
 static const UWS_CLIENT_HANDLE TEST_UWS_HANDLE = (UWS_CLIENT_HANDLE)0x4243;
 static const XIO_HANDLE TEST_UNDERLYING_IO_HANDLE = (XIO_HANDLE)0x4244;
 static const OPTIONHANDLER_HANDLE TEST_OPTIONHANDLER_HANDLE = (OPTIONHANDLER_HANDLE)0x4246;
@@ -75,75 +70,6 @@ static void my_gballoc_free(void* ptr)
     free(ptr);
 }
 
-static LIST_ITEM_HANDLE add_to_list(const void* item)
-{
-    const void** items = (const void**)realloc((void*)list_items, (list_item_count + 1) * sizeof(item));
-    if (items != NULL)
-    {
-        list_items = items;
-        list_items[list_item_count++] = item;
-    }
-    return (LIST_ITEM_HANDLE)list_item_count;
-}
-
-static int singlylinkedlist_remove_result;
-
-static int my_singlylinkedlist_remove(SINGLYLINKEDLIST_HANDLE list, LIST_ITEM_HANDLE item)
-{
-    size_t index = (size_t)item - 1;
-    (void)list;
-    (void)memmove((void*)&list_items[index], &list_items[index + 1], sizeof(const void*) * (list_item_count - index - 1));
-    list_item_count--;
-    if (list_item_count == 0)
-    {
-        free((void*)list_items);
-        list_items = NULL;
-    }
-    return singlylinkedlist_remove_result;
-}
-
-static LIST_ITEM_HANDLE my_singlylinkedlist_get_head_item(SINGLYLINKEDLIST_HANDLE list)
-{
-    LIST_ITEM_HANDLE list_item_handle = NULL;
-    (void)list;
-    if (list_item_count > 0)
-    {
-        list_item_handle = (LIST_ITEM_HANDLE)1;
-    }
-    else
-    {
-        list_item_handle = NULL;
-    }
-    return list_item_handle;
-}
-
-static LIST_ITEM_HANDLE my_singlylinkedlist_add(SINGLYLINKEDLIST_HANDLE list, const void* item)
-{
-    (void)list;
-    return add_to_list(item);
-}
-
-static const void* my_singlylinkedlist_item_get_value(LIST_ITEM_HANDLE item_handle)
-{
-    return (const void*)list_items[(size_t)item_handle - 1];
-}
-
-static LIST_ITEM_HANDLE my_singlylinkedlist_find(SINGLYLINKEDLIST_HANDLE handle, LIST_MATCH_FUNCTION match_function, const void* match_context)
-{
-    size_t i;
-    const void* found_item = NULL;
-    (void)handle;
-    for (i = 0; i < list_item_count; i++)
-    {
-        if (match_function((LIST_ITEM_HANDLE)list_items[i], match_context))
-        {
-            found_item = list_items[i];
-            break;
-        }
-    }
-    return (LIST_ITEM_HANDLE)found_item;
-}
-
 int my_mallocAndStrcpy_s(char** destination, const char* source)
 {
     *destination = (char*)malloc(strlen(source) + 1);
@@ -181,6 +107,8 @@ MOCK_FUNCTION_WITH_CODE(, void, test_on_io_close_complete, void*, context);
 MOCK_FUNCTION_END()
 MOCK_FUNCTION_WITH_CODE(, void, test_on_send_complete, void*, context, IO_SEND_RESULT, send_result)
 MOCK_FUNCTION_END()
+MOCK_FUNCTION_WITH_CODE(, void, test_on_send_window_changed, void*, context, bool, is_open)
+MOCK_FUNCTION_END()
 
 static ON_WS_OPEN_COMPLETE g_on_ws_open_complete;
 static void* g_on_ws_open_complete_context;
@@ -265,12 +193,6 @@ TEST_SUITE_INITIALIZE(suite_init)
 
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
     REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
-    REGISTER_GLOBAL_MOCK_RETURN(singlylinkedlist_create, TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_remove, my_singlylinkedlist_remove);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_get_head_item, my_singlylinkedlist_get_head_item);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_add, my_singlylinkedlist_add);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_item_get_value, my_singlylinkedlist_item_get_value);
-    REGISTER_GLOBAL_MOCK_HOOK(singlylinkedlist_find, my_singlylinkedlist_find);
     REGISTER_GLOBAL_MOCK_HOOK(mallocAndStrcpy_s, my_mallocAndStrcpy_s);
     REGISTER_GLOBAL_MOCK_HOOK(uws_client_open_async, my_uws_open_async);
     REGISTER_GLOBAL_MOCK_HOOK(uws_client_close_async, my_uws_close_async);
@@ -286,8 +208,6 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_TYPE(IO_SEND_RESULT, IO_SEND_RESULT);
     REGISTER_TYPE(OPTIONHANDLER_RESULT, OPTIONHANDLER_RESULT);
 
-    REGISTER_UMOCK_ALIAS_TYPE(SINGLYLINKEDLIST_HANDLE, void*);
-    REGISTER_UMOCK_ALIAS_TYPE(LIST_ITEM_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(UWS_CLIENT_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_WS_OPEN_COMPLETE, void*);
@@ -320,7 +240,6 @@ TEST_FUNCTION_INITIALIZE(method_init)
 
     currentmalloc_call = 0;
     whenShallmalloc_fail = 0;
-    singlylinkedlist_remove_result = 0;
 }
 
 TEST_FUNCTION_CLEANUP(method_cleanup)
@@ -340,7 +259,7 @@ TEST_FUNCTION_CLEANUP(method_cleanup)
 /* Tests_SRS_WSIO_01_130: [ - port set to the port field in the io_create_parameters passed to wsio_create. ]*/
 /* Tests_SRS_WSIO_01_128: [ - resource_name set to the resource_name field in the io_create_parameters passed to wsio_create. ]*/
 /* Tests_SRS_WSIO_01_129: [ - protocols shall be filled with only one structure, that shall have the protocol set to the value of the protocol field in the io_create_parameters passed to wsio_create. ]*/
-/* Tests_SRS_WSIO_01_076: [ wsio_create shall create a pending send IO list that is to be used to queue send packets by calling singlylinkedlist_create. ]*/
+/* Tests_SRS_WSIO_01_076: [ wsio_create shall initialize an empty pending send IO list that is to be used to queue send packets. ]*/
 TEST_FUNCTION(wsio_create_for_secure_connection_with_valid_args_succeeds)
 {
     // arrange
@@ -348,7 +267,6 @@ TEST_FUNCTION(wsio_create_for_secure_connection_with_valid_args_succeeds)
 
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_client_create_with_io(TEST_UNDERLYING_IO_INTERFACE, TEST_UNDERLYING_IO_PARAMETERS, TEST_HOST_ADDRESS, 443, TEST_RESOURCE_NAME, IGNORED_PTR_ARG, 1));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create());
 
     // act
     wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
@@ -474,27 +392,6 @@ TEST_FUNCTION(when_uws_create_fails_then_wsio_create_fails)
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 }
 
-/* Tests_SRS_WSIO_01_077: [ If singlylinkedlist_create fails then wsio_create shall fail and return NULL. ]*/
-TEST_FUNCTION(when_singlylinkedlist_create_fails_then_wsio_create_fails)
-{
-    // arrange
-    CONCRETE_IO_HANDLE wsio;
-
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(uws_client_create_with_io(TEST_UNDERLYING_IO_INTERFACE, TEST_UNDERLYING_IO_PARAMETERS, TEST_HOST_ADDRESS, 443, TEST_RESOURCE_NAME, IGNORED_PTR_ARG, 1));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create())
-        .SetReturn(NULL);
-    STRICT_EXPECTED_CALL(uws_client_destroy(TEST_UWS_HANDLE));
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-
-    // act
-    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
-
-    // assert
-    ASSERT_IS_NULL(wsio);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-}
-
 /* Tests_SRS_WSIO_01_071: [ The arguments for uws_client_create_with_io shall be: ]*/
 /* Tests_SRS_WSIO_01_185: [ - underlying_io_interface shall be set to the underlying_io_interface field in the io_create_parameters passed to wsio_create. ]*/
 /* Tests_SRS_WSIO_01_186: [ - underlying_io_parameters shall be set to the underlying_io_parameters field in the io_create_parameters passed to wsio_create. ]*/
@@ -517,7 +414,6 @@ TEST_FUNCTION(wsio_create_for_secure_connection_with_valid_args_succeeds_2)
 
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
     STRICT_EXPECTED_CALL(uws_client_create_with_io(TEST_UNDERLYING_IO_INTERFACE, NULL, "another.com", 80, "haga", IGNORED_PTR_ARG, 1));
-    STRICT_EXPECTED_CALL(singlylinkedlist_create());
 
     // act
     wsio = wsio_get_interface_description()->concrete_io_create(&wsio_config);
@@ -534,7 +430,6 @@ TEST_FUNCTION(wsio_create_for_secure_connection_with_valid_args_succeeds_2)
 
 /* Tests_SRS_WSIO_01_078: [ wsio_destroy shall free all resources associated with the wsio instance. ]*/
 /* Tests_SRS_WSIO_01_080: [ wsio_destroy shall destroy the uws instance created in wsio_create by calling uws_client_destroy. ]*/
-/* Tests_SRS_WSIO_01_081: [ wsio_destroy shall free the list used to track the pending send IOs by calling singlylinkedlist_destroy. ]*/
 TEST_FUNCTION(wsio_destroy_frees_all_resources)
 {
     // arrange
@@ -543,7 +438,6 @@ TEST_FUNCTION(wsio_destroy_frees_all_resources)
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(uws_client_destroy(TEST_UWS_HANDLE));
-    STRICT_EXPECTED_CALL(singlylinkedlist_destroy(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
@@ -763,7 +657,7 @@ TEST_FUNCTION(wsio_open_after_close_succeeds)
 /* Tests_SRS_WSIO_01_133: [ On success wsio_close shall return 0. ]*/
 /* Tests_SRS_WSIO_01_091: [ wsio_close shall obtain all the pending IO items by repetitively querying for the head of the pending IO list and freeing that head item. ]*/
 /* Tests_SRS_WSIO_01_087: [ wsio_close shall call uws_client_close_async while passing as argument the IO handle created in wsio_create.  ]*/
-/* Tests_SRS_WSIO_01_092: [ Obtaining the head of the pending IO list shall be done by calling singlylinkedlist_get_head_item. ]*/
+/* Tests_SRS_WSIO_01_092: [ Obtaining the head of the pending IO list shall be done by taking the first entry of the list. ]*/
 /* Tests_SRS_WSIO_01_094: [ The callback context passed to the on_send_complete callback shall be the context given to wsio_send.  ]*/
 TEST_FUNCTION(wsio_close_when_IO_is_open_closes_the_uws)
 {
@@ -776,7 +670,6 @@ TEST_FUNCTION(wsio_close_when_IO_is_open_closes_the_uws)
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(uws_client_close_async(TEST_UWS_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
 
     // act
     result = wsio_get_interface_description()->concrete_io_close(wsio, test_on_io_close_complete, (void*)0x4245);
@@ -882,7 +775,6 @@ TEST_FUNCTION(when_uws_close_fails_then_wsio_close_fails)
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(uws_client_close_async(TEST_UWS_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
 
     // act
     result = wsio_get_interface_description()->concrete_io_close(wsio, test_on_io_close_complete, (void*)0x4245);
@@ -907,7 +799,6 @@ TEST_FUNCTION(wsio_close_with_NULL_close_complete_callback_succeeds)
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(uws_client_close_async(TEST_UWS_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
 
     // act
     result = wsio_get_interface_description()->concrete_io_close(wsio, NULL, NULL);
@@ -935,12 +826,8 @@ TEST_FUNCTION(wsio_close_indicates_a_pending_send_as_CANCELLED)
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(uws_client_close_async(TEST_UWS_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(test_on_send_complete((void*)0x4343, IO_SEND_CANCELLED));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
 
     // act
     result = wsio_get_interface_description()->concrete_io_close(wsio, NULL, NULL);
@@ -969,17 +856,10 @@ TEST_FUNCTION(wsio_close_indicates_2_pending_sends_as_CANCELLED)
     umock_c_reset_all_calls();
 
     STRICT_EXPECTED_CALL(uws_client_close_async(TEST_UWS_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(test_on_send_complete((void*)0x4343, IO_SEND_CANCELLED));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(test_on_send_complete((void*)0x4343, IO_SEND_CANCELLED));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_get_head_item(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE));
 
     // act
     result = wsio_get_interface_description()->concrete_io_close(wsio, NULL, NULL);
@@ -997,7 +877,7 @@ TEST_FUNCTION(wsio_close_indicates_2_pending_sends_as_CANCELLED)
 /* Tests_SRS_WSIO_01_095: [ wsio_send shall call uws_client_send_frame_async, passing the buffer and size arguments as they are: ]*/
 /* Tests_SRS_WSIO_01_097: [ The is_final argument shall be set to true. ]*/
 /* Tests_SRS_WSIO_01_098: [ On success, wsio_send shall return 0. ]*/
-/* Tests_SRS_WSIO_01_102: [ An entry shall be queued in the singly linked list by calling singlylinkedlist_add. ]*/
+/* Tests_SRS_WSIO_01_102: [ An entry shall be queued at the tail of the pending IO list through the list entry embedded in it, without allocating. ]*/
 /* Tests_SRS_WSIO_01_103: [ The entry shall contain the on_send_complete callback and its context. ]*/
 /* Tests_SRS_WSIO_01_096: [ The frame type used shall be WS_FRAME_TYPE_BINARY. ]*/
 TEST_FUNCTION(wsio_send_with_1_byte_calls_uws_send_frame)
@@ -1013,7 +893,6 @@ TEST_FUNCTION(wsio_send_with_1_byte_calls_uws_send_frame)
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(uws_client_send_frame_async(TEST_UWS_HANDLE, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, sizeof(test_buffer), true, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .ValidateArgumentBuffer(3, test_buffer, sizeof(test_buffer));
 
@@ -1189,35 +1068,6 @@ TEST_FUNCTION(when_allocating_memory_for_the_pending_send_fails_wsio_send_fails)
     wsio_get_interface_description()->concrete_io_destroy(wsio);
 }
 
-/* Tests_SRS_WSIO_01_104: [ If singlylinkedlist_add fails, wsio_send shall fail and return a non-zero value. ]*/
-TEST_FUNCTION(when_adding_the_pending_item_to_the_list_fails_wsio_send_fails)
-{
-    // arrange
-    CONCRETE_IO_HANDLE wsio;
-    int result;
-    unsigned char test_buffer[] = { 42 };
-
-    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
-    (void)wsio_get_interface_description()->concrete_io_open(wsio, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
-    g_on_ws_open_complete(g_on_ws_open_complete_context, WS_OPEN_OK);
-    umock_c_reset_all_calls();
-
-    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG))
-        .SetReturn(NULL);
-    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
-
-    // act
-    result = wsio_get_interface_description()->concrete_io_send(wsio, test_buffer, sizeof(test_buffer), test_on_send_complete, (void*)0x4343);
-
-    // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
-    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-
-    // cleanup
-    wsio_get_interface_description()->concrete_io_destroy(wsio);
-}
-
 /* Tests_SRS_WSIO_01_105: [ The argument on_send_complete shall be optional, if NULL is passed by the caller then no send complete callback shall be triggered. ]*/
 TEST_FUNCTION(wsio_send_with_NULL_send_complete_callback_succeeds)
 {
@@ -1232,7 +1082,6 @@ TEST_FUNCTION(wsio_send_with_NULL_send_complete_callback_succeeds)
     umock_c_reset_all_calls();
 
     EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_add(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(uws_client_send_frame_async(TEST_UWS_HANDLE, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, sizeof(test_buffer), true, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
         .ValidateArgumentBuffer(3, test_buffer, sizeof(test_buffer));
 
@@ -1370,6 +1219,165 @@ TEST_FUNCTION(wsio_dowork_in_closing_calls_uws_do_work)
     wsio_get_interface_description()->concrete_io_destroy(wsio);
 }
 
+/* wsio_dowork_ex */
+
+/* Tests_SRS_WSIO_01_206: [ Otherwise wsio_dowork_ex shall call uws_client_dowork_ex with the uws handle created in wsio_create, passing next_deadline_us down to it. ]*/
+/* Tests_SRS_WSIO_01_207: [ made_progress shall be set to true if a callback was made or the uws instance made progress, false otherwise. ]*/
+/* Tests_SRS_WSIO_01_209: [ On success wsio_dowork_ex shall return 0. ]*/
+TEST_FUNCTION(wsio_dowork_ex_calls_uws_client_dowork_ex)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+    bool made_progress = true;
+    bool uws_progress = false;
+    uint64_t next_deadline_us;
+    int result;
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    (void)wsio_get_interface_description()->concrete_io_open(wsio, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    g_on_ws_open_complete(g_on_ws_open_complete_context, WS_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_client_dowork_ex(TEST_UWS_HANDLE, IGNORED_PTR_ARG, &next_deadline_us))
+        .CopyOutArgumentBuffer_made_progress(&uws_progress, sizeof(uws_progress));
+
+    // act
+    result = wsio_get_interface_description()->concrete_io_dowork_ex(wsio, &made_progress, &next_deadline_us);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(made_progress);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
+/* Tests_SRS_WSIO_01_204: [ If ws_io, made_progress or next_deadline_us is NULL, wsio_dowork_ex shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(wsio_dowork_ex_with_NULL_handle_fails)
+{
+    // arrange
+    bool made_progress;
+    uint64_t next_deadline_us;
+    int result;
+
+    // act
+    result = wsio_get_interface_description()->concrete_io_dowork_ex(NULL, &made_progress, &next_deadline_us);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_WSIO_01_205: [ If the IO is not yet open, wsio_dowork_ex shall set made_progress to false, set next_deadline_us to XIO_NO_DEADLINE and return 0. ]*/
+TEST_FUNCTION(wsio_dowork_ex_when_not_open_reports_no_progress)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+    bool made_progress = true;
+    uint64_t next_deadline_us = 0;
+    int result;
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    umock_c_reset_all_calls();
+
+    // act
+    result = wsio_get_interface_description()->concrete_io_dowork_ex(wsio, &made_progress, &next_deadline_us);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_FALSE(made_progress);
+    ASSERT_IS_TRUE(next_deadline_us == XIO_NO_DEADLINE);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
+/* Tests_SRS_WSIO_01_208: [ If uws_client_dowork_ex fails, made_progress shall be set to true and next_deadline_us to XIO_NO_DEADLINE. ]*/
+TEST_FUNCTION(when_uws_client_dowork_ex_fails_wsio_dowork_ex_reports_progress)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+    bool made_progress = false;
+    uint64_t next_deadline_us = 0;
+    int result;
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    (void)wsio_get_interface_description()->concrete_io_open(wsio, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    g_on_ws_open_complete(g_on_ws_open_complete_context, WS_OPEN_OK);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_client_dowork_ex(TEST_UWS_HANDLE, IGNORED_PTR_ARG, &next_deadline_us))
+        .SetReturn(1);
+
+    // act
+    result = wsio_get_interface_description()->concrete_io_dowork_ex(wsio, &made_progress, &next_deadline_us);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(made_progress);
+    ASSERT_IS_TRUE(next_deadline_us == XIO_NO_DEADLINE);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
+/* wsio_get_pollable_handle */
+
+/* Tests_SRS_WSIO_01_211: [ wsio_get_pollable_handle shall call uws_client_get_pollable_handle with the uws handle created in wsio_create, passing pollable_handle and wanted_events down to it. ]*/
+/* Tests_SRS_WSIO_01_213: [ On success wsio_get_pollable_handle shall return 0. ]*/
+TEST_FUNCTION(wsio_get_pollable_handle_calls_uws_client_get_pollable_handle)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+    intptr_t pollable_handle;
+    unsigned int wanted_events;
+    int result;
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_client_get_pollable_handle(TEST_UWS_HANDLE, &pollable_handle, &wanted_events));
+
+    // act
+    result = wsio_get_interface_description()->concrete_io_get_pollable_handle(wsio, &pollable_handle, &wanted_events);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
+/* Tests_SRS_WSIO_01_212: [ If uws_client_get_pollable_handle fails, wsio_get_pollable_handle shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_uws_client_get_pollable_handle_fails_wsio_get_pollable_handle_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+    intptr_t pollable_handle;
+    unsigned int wanted_events;
+    int result;
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(uws_client_get_pollable_handle(TEST_UWS_HANDLE, &pollable_handle, &wanted_events))
+        .SetReturn(1);
+
+    // act
+    result = wsio_get_interface_description()->concrete_io_get_pollable_handle(wsio, &pollable_handle, &wanted_events);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
 /* on_ws_error */
 
 /* Tests_SRS_WSIO_01_121: [ When on_underlying_ws_error is called while the IO is OPEN the wsio instance shall be set to ERROR and an error shall be indicated via the on_io_error callback passed to wsio_open. ]*/
@@ -1792,7 +1800,7 @@ TEST_FUNCTION(when_on_underlying_ws_frame_received_is_called_with_positive_size_
 /* on_underlying_ws_send_frame_complete */
 
 /* Tests_SRS_WSIO_01_143: [ When on_underlying_ws_send_frame_complete is called after sending a WebSocket frame, the pending IO shall be removed from the list. ]*/
-/* Tests_SRS_WSIO_01_145: [ Removing it from the list shall be done by calling singlylinkedlist_remove. ]*/
+/* Tests_SRS_WSIO_01_145: [ Removing it from the list shall be done by unlinking the list entry embedded in the pending IO. ]*/
 /* Tests_SRS_WSIO_01_144: [ Also the pending IO data shall be freed. ]*/
 /* Tests_SRS_WSIO_01_146: [ When on_underlying_ws_send_frame_complete is called with WS_SEND_OK, the callback on_send_complete shall be called with IO_SEND_OK. ]*/
 TEST_FUNCTION(wsio_send_with_1_byte_completed_indicates_the_completion_up)
@@ -1807,8 +1815,6 @@ TEST_FUNCTION(wsio_send_with_1_byte_completed_indicates_the_completion_up)
     (void)wsio_get_interface_description()->concrete_io_send(wsio, test_buffer, sizeof(test_buffer), test_on_send_complete, (void*)0x4343);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(test_on_send_complete((void*)0x4343, IO_SEND_OK));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
@@ -1835,8 +1841,6 @@ TEST_FUNCTION(wsio_send_with_1_byte_completed_with_CANCELLED_indicates_the_compl
     (void)wsio_get_interface_description()->concrete_io_send(wsio, test_buffer, sizeof(test_buffer), test_on_send_complete, (void*)0x4343);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(test_on_send_complete((void*)0x4343, IO_SEND_CANCELLED));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
@@ -1863,8 +1867,6 @@ TEST_FUNCTION(wsio_send_with_1_byte_completed_with_ERROR_indicates_the_completio
     (void)wsio_get_interface_description()->concrete_io_send(wsio, test_buffer, sizeof(test_buffer), test_on_send_complete, (void*)0x4343);
     umock_c_reset_all_calls();
 
-    EXPECTED_CALL(singlylinkedlist_item_get_value(IGNORED_PTR_ARG));
-    STRICT_EXPECTED_CALL(singlylinkedlist_remove(TEST_SINGLYLINKEDSINGLYLINKEDLIST_HANDLE, IGNORED_PTR_ARG));
     STRICT_EXPECTED_CALL(test_on_send_complete((void*)0x4343, IO_SEND_ERROR));
     EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
@@ -2034,6 +2036,199 @@ TEST_FUNCTION(when_uws_set_option_fails_wsio_setoption_fails)
     wsio_get_interface_description()->concrete_io_destroy(wsio);
 }
 
+/* Tests_SRS_WSIO_01_187: [ If the option name is wsio_send_window, wsio_setoption shall store the WSIO_SEND_WINDOW structure pointed to by value. ]*/
+/* Tests_SRS_WSIO_01_190: [ On success, size shall be added to the number of queued bytes. ]*/
+/* Tests_SRS_WSIO_01_191: [ When the number of queued bytes reaches the high_watermark the send window shall be closed. ]*/
+/* Tests_SRS_WSIO_01_194: [ Whenever the send window is closed or opened, on_send_window_changed shall be called with the on_send_window_changed_context and is_open set to false or true respectively. ]*/
+TEST_FUNCTION(wsio_send_reaching_the_high_watermark_closes_the_send_window)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+    WSIO_SEND_WINDOW send_window;
+    unsigned char test_buffer[] = { 42, 43 };
+    int result;
+
+    send_window.high_watermark = 4;
+    send_window.low_watermark = 1;
+    send_window.on_send_window_changed = test_on_send_window_changed;
+    send_window.on_send_window_changed_context = (void*)0x4545;
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    (void)wsio_get_interface_description()->concrete_io_setoption(wsio, "wsio_send_window", &send_window);
+    (void)wsio_get_interface_description()->concrete_io_open(wsio, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    g_on_ws_open_complete(g_on_ws_open_complete_context, WS_OPEN_OK);
+    (void)wsio_get_interface_description()->concrete_io_send(wsio, test_buffer, sizeof(test_buffer), test_on_send_complete, (void*)0x4343);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(uws_client_send_frame_async(TEST_UWS_HANDLE, WS_FRAME_TYPE_BINARY, IGNORED_PTR_ARG, sizeof(test_buffer), true, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(3, test_buffer, sizeof(test_buffer));
+    STRICT_EXPECTED_CALL(test_on_send_window_changed((void*)0x4545, false));
+
+    // act
+    result = wsio_get_interface_description()->concrete_io_send(wsio, test_buffer, sizeof(test_buffer), test_on_send_complete, (void*)0x4343);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
+/* Tests_SRS_WSIO_01_192: [ While the send window is closed wsio_send shall fail and return a non-zero value without queueing the buffer. ]*/
+TEST_FUNCTION(wsio_send_while_the_send_window_is_closed_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+    WSIO_SEND_WINDOW send_window;
+    unsigned char test_buffer[] = { 42, 43 };
+    int result;
+
+    send_window.high_watermark = 2;
+    send_window.low_watermark = 0;
+    send_window.on_send_window_changed = NULL;
+    send_window.on_send_window_changed_context = NULL;
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    (void)wsio_get_interface_description()->concrete_io_setoption(wsio, "wsio_send_window", &send_window);
+    (void)wsio_get_interface_description()->concrete_io_open(wsio, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    g_on_ws_open_complete(g_on_ws_open_complete_context, WS_OPEN_OK);
+    (void)wsio_get_interface_description()->concrete_io_send(wsio, test_buffer, sizeof(test_buffer), test_on_send_complete, (void*)0x4343);
+    umock_c_reset_all_calls();
+
+    // act
+    result = wsio_get_interface_description()->concrete_io_send(wsio, test_buffer, sizeof(test_buffer), test_on_send_complete, (void*)0x4343);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
+/* Tests_SRS_WSIO_01_193: [ When completing pending IOs brings the number of queued bytes down to the low_watermark the send window shall be opened again. ]*/
+/* Tests_SRS_WSIO_01_194: [ Whenever the send window is closed or opened, on_send_window_changed shall be called with the on_send_window_changed_context and is_open set to false or true respectively. ]*/
+TEST_FUNCTION(completing_sends_down_to_the_low_watermark_opens_the_send_window)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+    WSIO_SEND_WINDOW send_window;
+    unsigned char test_buffer[] = { 42, 43 };
+    void* second_send_context;
+
+    send_window.high_watermark = 4;
+    send_window.low_watermark = 2;
+    send_window.on_send_window_changed = test_on_send_window_changed;
+    send_window.on_send_window_changed_context = (void*)0x4545;
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    (void)wsio_get_interface_description()->concrete_io_setoption(wsio, "wsio_send_window", &send_window);
+    (void)wsio_get_interface_description()->concrete_io_open(wsio, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    g_on_ws_open_complete(g_on_ws_open_complete_context, WS_OPEN_OK);
+    (void)wsio_get_interface_description()->concrete_io_send(wsio, test_buffer, sizeof(test_buffer), test_on_send_complete, (void*)0x4343);
+    (void)wsio_get_interface_description()->concrete_io_send(wsio, test_buffer, sizeof(test_buffer), test_on_send_complete, (void*)0x4344);
+    second_send_context = g_on_ws_send_frame_complete_context;
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_on_send_complete((void*)0x4344, IO_SEND_OK));
+    EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_send_window_changed((void*)0x4545, true));
+
+    // act
+    g_on_ws_send_frame_complete(second_send_context, WS_SEND_FRAME_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
+/* Tests_SRS_WSIO_01_188: [ If the option name is wsio_send_window and value is NULL, or high_watermark is not zero and low_watermark is not smaller than high_watermark, wsio_setoption shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(wsio_setoption_with_wsio_send_window_and_NULL_value_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+    int result;
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    umock_c_reset_all_calls();
+
+    // act
+    result = wsio_get_interface_description()->concrete_io_setoption(wsio, "wsio_send_window", NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
+/* Tests_SRS_WSIO_01_188: [ If the option name is wsio_send_window and value is NULL, or high_watermark is not zero and low_watermark is not smaller than high_watermark, wsio_setoption shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(wsio_setoption_with_wsio_send_window_low_watermark_equal_to_high_watermark_fails)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+    WSIO_SEND_WINDOW send_window;
+    int result;
+
+    send_window.high_watermark = 4;
+    send_window.low_watermark = 4;
+    send_window.on_send_window_changed = NULL;
+    send_window.on_send_window_changed_context = NULL;
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    umock_c_reset_all_calls();
+
+    // act
+    result = wsio_get_interface_description()->concrete_io_setoption(wsio, "wsio_send_window", &send_window);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
+/* Tests_SRS_WSIO_01_189: [ The new watermarks shall be applied immediately to the bytes already queued. ]*/
+TEST_FUNCTION(wsio_setoption_disabling_the_send_window_reopens_it)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+    WSIO_SEND_WINDOW send_window;
+    unsigned char test_buffer[] = { 42, 43 };
+    int result;
+
+    send_window.high_watermark = 2;
+    send_window.low_watermark = 0;
+    send_window.on_send_window_changed = test_on_send_window_changed;
+    send_window.on_send_window_changed_context = (void*)0x4545;
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    (void)wsio_get_interface_description()->concrete_io_setoption(wsio, "wsio_send_window", &send_window);
+    (void)wsio_get_interface_description()->concrete_io_open(wsio, test_on_io_open_complete, (void*)0x4242, test_on_bytes_received, (void*)0x4243, test_on_io_error, (void*)0x4244);
+    g_on_ws_open_complete(g_on_ws_open_complete_context, WS_OPEN_OK);
+    (void)wsio_get_interface_description()->concrete_io_send(wsio, test_buffer, sizeof(test_buffer), test_on_send_complete, (void*)0x4343);
+    umock_c_reset_all_calls();
+
+    send_window.high_watermark = 0;
+    STRICT_EXPECTED_CALL(test_on_send_window_changed((void*)0x4545, true));
+
+    // act
+    result = wsio_get_interface_description()->concrete_io_setoption(wsio, "wsio_send_window", &send_window);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
 /* wsio_retrieveoptions */
 
 /* Tests_SRS_WSIO_01_118: [ If parameter handle is NULL then wsio_retrieveoptions shall fail and return NULL. ]*/
@@ -2246,6 +2441,75 @@ TEST_FUNCTION(wsio_clone_option_with_an_unknown_option_name_fails)
     wsio_get_interface_description()->concrete_io_destroy(wsio);
 }
 
+/* Tests_SRS_WSIO_01_198: [ If a send window is configured, wsio_retrieveoptions shall also add the wsio_send_window option. ]*/
+TEST_FUNCTION(wsio_retrieveoptions_adds_the_send_window_when_configured)
+{
+    // arrange
+    OPTIONHANDLER_HANDLE result;
+    CONCRETE_IO_HANDLE wsio;
+    WSIO_SEND_WINDOW send_window;
+
+    send_window.high_watermark = 4;
+    send_window.low_watermark = 2;
+    send_window.on_send_window_changed = NULL;
+    send_window.on_send_window_changed_context = NULL;
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    (void)wsio_get_interface_description()->concrete_io_setoption(wsio, "wsio_send_window", &send_window);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(uws_client_retrieve_options(TEST_UWS_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "WSIOOptions", TEST_UWS_CLIENT_OPTIONHANDLER_HANDLE));
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(TEST_OPTIONHANDLER_HANDLE, "wsio_send_window", IGNORED_PTR_ARG));
+
+    // act
+    result = wsio_get_interface_description()->concrete_io_retrieveoptions(wsio);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
+/* Tests_SRS_WSIO_01_196: [ wsio_clone_option called with name being wsio_send_window shall return a newly allocated copy of the WSIO_SEND_WINDOW value. ]*/
+/* Tests_SRS_WSIO_01_197: [ wsio_destroy_option called with the option name being wsio_send_window shall free the value. ]*/
+TEST_FUNCTION(wsio_clone_option_with_wsio_send_window_copies_the_value)
+{
+    // arrange
+    CONCRETE_IO_HANDLE wsio;
+    WSIO_SEND_WINDOW send_window;
+    WSIO_SEND_WINDOW* result;
+
+    send_window.high_watermark = 4;
+    send_window.low_watermark = 2;
+    send_window.on_send_window_changed = test_on_send_window_changed;
+    send_window.on_send_window_changed_context = (void*)0x4545;
+
+    wsio = wsio_get_interface_description()->concrete_io_create(&default_wsio_config);
+    (void)wsio_get_interface_description()->concrete_io_retrieveoptions(wsio);
+    umock_c_reset_all_calls();
+
+    EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    result = (WSIO_SEND_WINDOW*)g_clone_option("wsio_send_window", &send_window);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, &send_window, result);
+    ASSERT_ARE_EQUAL(size_t, 4, result->high_watermark);
+    ASSERT_ARE_EQUAL(size_t, 2, result->low_watermark);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x4545, result->on_send_window_changed_context);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    g_destroy_option("wsio_send_window", result);
+    wsio_get_interface_description()->concrete_io_destroy(wsio);
+}
+
 /* wsio_destroy_option */
 
 /* Tests_SRS_WSIO_01_175: [ wsio_destroy_option called with the option name being WSIOOptions shall destroy the value by calling OptionHandler_Destroy. ]*/
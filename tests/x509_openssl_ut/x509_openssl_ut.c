@@ -41,6 +41,7 @@ static void my_gballoc_free(void* s)
 
 #define ENABLE_MOCKS
 #include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
 
 #include "azure_c_shared_utility/umock_c_prod.h"
 
@@ -120,6 +121,21 @@ MOCKABLE_FUNCTION(, void, ERR_clear_error);
 MOCKABLE_FUNCTION(, int, EVP_PKEY_id, const EVP_PKEY*, pkey);
 #endif
 
+/*from openssl/evp.h*/
+MOCKABLE_FUNCTION(, int, EVP_Digest, const void*, data, size_t, count, unsigned char*, md, unsigned int*, size, const EVP_MD*, type, ENGINE*, impl);
+MOCKABLE_FUNCTION(, const EVP_MD*, EVP_sha256);
+
+#if (OPENSSL_VERSION_NUMBER >= 0x10100000L) && (OPENSSL_VERSION_NUMBER < 0x20000000L)
+MOCKABLE_FUNCTION(, int, X509_up_ref, X509*, a);
+#else
+MOCKABLE_FUNCTION(, int, CRYPTO_add_lock, int*, pointer, int, amount, int, type, const char*, file, int, line);
+#endif
+
+#ifdef X509_OPENSSL_ENGINES_SUPPORTED
+/*from openssl/engine.h*/
+MOCKABLE_FUNCTION(, EVP_PKEY*, ENGINE_load_private_key, ENGINE*, e, const char*, key_id, UI_METHOD*, ui_method, void*, callback_data);
+#endif
+
 #undef ENABLE_MOCKS
 
 /*the below function has different signatures on different versions of OPENSSL*/
@@ -192,6 +208,15 @@ static RSA * my_PEM_read_bio_RSAPrivateKey(BIO * bp, RSA ** x, pem_password_cb *
     return (RSA*)my_gballoc_malloc(1);
 }
 
+static int my_EVP_Digest(const void* data, size_t count, unsigned char* md, unsigned int* size, const EVP_MD* type, ENGINE* impl)
+{
+    (void)size, (void)type, (void)impl;
+    /*the digest only has to tell different PEM texts apart*/
+    (void)memset(md, 0, 32);
+    (void)memcpy(md, data, count < 32 ? count : 32);
+    return 1;
+}
+
 static TEST_MUTEX_HANDLE g_testByTest;
 static TEST_MUTEX_HANDLE g_dllByDll;
 
@@ -216,6 +241,8 @@ typedef struct replace_evp_pkey_st_tag
 #define TEST_X509_STORE (X509_STORE *)"le store"
 #define TEST_BIO_METHOD (BIO_METHOD*)"le method"
 #define TEST_BIO (BIO*)"le bio"
+#define TEST_EVP_MD (const EVP_MD*)"le digest"
+#define TEST_LOCK_HANDLE (LOCK_HANDLE)0x4243
 
 static const char* TEST_PUBLIC_CERTIFICATE = "PUBLIC CERTIFICATE";
 static const char* TEST_PRIVATE_CERTIFICATE = "PRIVATE KEY";
@@ -272,11 +299,23 @@ BEGIN_TEST_SUITE(x509_openssl_unittests)
         REGISTER_GLOBAL_MOCK_FAIL_RETURN(EVP_PKEY_get1_RSA, NULL);
 
         REGISTER_GLOBAL_MOCK_RETURNS(PEM_read_bio_PrivateKey, g_evp_pkey, NULL);
+#ifdef X509_OPENSSL_ENGINES_SUPPORTED
+        REGISTER_GLOBAL_MOCK_RETURNS(ENGINE_load_private_key, g_evp_pkey, NULL);
+#endif
 
         REGISTER_GLOBAL_MOCK_RETURNS(BIO_new_mem_buf, TEST_BIO_CERT, NULL);
         REGISTER_GLOBAL_MOCK_HOOK(PEM_read_bio_X509_AUX, my_PEM_read_bio_X509_AUX);
         REGISTER_GLOBAL_MOCK_RETURNS(SSL_CTX_use_PrivateKey, 1, 0);
         REGISTER_GLOBAL_MOCK_HOOK(SSL_CTX_ctrl, my_SSL_CTX_ctrl);
+
+        REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+        REGISTER_UMOCK_ALIAS_TYPE(LOCK_RESULT, int);
+        REGISTER_GLOBAL_MOCK_RETURNS(Lock_Init, TEST_LOCK_HANDLE, NULL);
+        REGISTER_GLOBAL_MOCK_RETURNS(Lock, LOCK_OK, LOCK_ERROR);
+        REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+        REGISTER_GLOBAL_MOCK_RETURN(EVP_sha256, TEST_EVP_MD);
+        REGISTER_GLOBAL_MOCK_HOOK(EVP_Digest, my_EVP_Digest);
+        REGISTER_GLOBAL_MOCK_FAIL_RETURN(EVP_Digest, 0);
     }
 
     TEST_SUITE_CLEANUP(TestClassCleanup)
@@ -300,6 +339,7 @@ BEGIN_TEST_SUITE(x509_openssl_unittests)
 
     TEST_FUNCTION_CLEANUP(cleans)
     {
+        x509_openssl_credentials_cache_deinit();
     }
 
     static int should_skip_index(size_t current_index, const size_t skip_array[], size_t length)
@@ -626,4 +666,413 @@ BEGIN_TEST_SUITE(x509_openssl_unittests)
         umock_c_negative_tests_deinit();
     }
 
+    static void setup_parse_credentials_mocks(void)
+    {
+        STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+        STRICT_EXPECTED_CALL(BIO_new_mem_buf((char*)TEST_PRIVATE_CERTIFICATE, -1));
+        STRICT_EXPECTED_CALL(PEM_read_bio_PrivateKey(IGNORED_PTR_ARG, NULL, NULL, NULL));
+        STRICT_EXPECTED_CALL(BIO_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(BIO_new_mem_buf((void*)TEST_PUBLIC_CERTIFICATE, -1));
+        STRICT_EXPECTED_CALL(PEM_read_bio_X509_AUX(IGNORED_PTR_ARG, NULL, NULL, NULL));
+        STRICT_EXPECTED_CALL(PEM_read_bio_X509(IGNORED_PTR_ARG, NULL, NULL, NULL))
+            .SetReturn(NULL);
+        STRICT_EXPECTED_CALL(ERR_peek_last_error());
+        STRICT_EXPECTED_CALL(ERR_clear_error());
+        STRICT_EXPECTED_CALL(BIO_free(IGNORED_PTR_ARG));
+    }
+
+    static void setup_acquire_digest_mocks(void)
+    {
+        STRICT_EXPECTED_CALL(EVP_sha256());
+        STRICT_EXPECTED_CALL(EVP_Digest(TEST_PUBLIC_CERTIFICATE, strlen(TEST_PUBLIC_CERTIFICATE), IGNORED_PTR_ARG, NULL, TEST_EVP_MD, NULL));
+        STRICT_EXPECTED_CALL(EVP_sha256());
+        STRICT_EXPECTED_CALL(EVP_Digest(TEST_PRIVATE_CERTIFICATE, strlen(TEST_PRIVATE_CERTIFICATE), IGNORED_PTR_ARG, NULL, TEST_EVP_MD, NULL));
+    }
+
+    /*Tests_SRS_X509_OPENSSL_01_001: [ x509_openssl_credentials_cache_init shall create the lock guarding the process wide cache and return 0. ]*/
+    TEST_FUNCTION(x509_openssl_credentials_cache_init_succeeds)
+    {
+        //arrange
+        STRICT_EXPECTED_CALL(Lock_Init());
+
+        //act
+        int result = x509_openssl_credentials_cache_init();
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_X509_OPENSSL_01_002: [ If the cache is already initialized, x509_openssl_credentials_cache_init shall fail and return a non-zero value. ]*/
+    TEST_FUNCTION(x509_openssl_credentials_cache_init_twice_fails)
+    {
+        //arrange
+        ASSERT_ARE_EQUAL(int, 0, x509_openssl_credentials_cache_init());
+        umock_c_reset_all_calls();
+
+        //act
+        int result = x509_openssl_credentials_cache_init();
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_X509_OPENSSL_01_003: [ If Lock_Init fails, x509_openssl_credentials_cache_init shall fail and return a non-zero value. ]*/
+    TEST_FUNCTION(x509_openssl_credentials_cache_init_fails_when_Lock_Init_fails)
+    {
+        //arrange
+        STRICT_EXPECTED_CALL(Lock_Init())
+            .SetReturn(NULL);
+
+        //act
+        int result = x509_openssl_credentials_cache_init();
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_X509_OPENSSL_01_005: [ x509_openssl_credentials_cache_deinit shall free the cache lock. ]*/
+    TEST_FUNCTION(x509_openssl_credentials_cache_deinit_frees_the_lock)
+    {
+        //arrange
+        ASSERT_ARE_EQUAL(int, 0, x509_openssl_credentials_cache_init());
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+
+        //act
+        x509_openssl_credentials_cache_deinit();
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_X509_OPENSSL_01_006: [ If x509certificate or x509privatekey is NULL, x509_openssl_credentials_acquire shall fail and return NULL. ]*/
+    TEST_FUNCTION(x509_openssl_credentials_acquire_with_NULL_certificate_fails)
+    {
+        //act
+        X509_OPENSSL_CREDENTIALS_HANDLE result = x509_openssl_credentials_acquire(NULL, TEST_PRIVATE_CERTIFICATE);
+
+        //assert
+        ASSERT_IS_NULL(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_X509_OPENSSL_01_006: [ If x509certificate or x509privatekey is NULL, x509_openssl_credentials_acquire shall fail and return NULL. ]*/
+    TEST_FUNCTION(x509_openssl_credentials_acquire_with_NULL_privatekey_fails)
+    {
+        //act
+        X509_OPENSSL_CREDENTIALS_HANDLE result = x509_openssl_credentials_acquire(TEST_PUBLIC_CERTIFICATE, NULL);
+
+        //assert
+        ASSERT_IS_NULL(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_X509_OPENSSL_01_007: [ x509_openssl_credentials_acquire shall compute the SHA-256 digest of x509certificate and of x509privatekey by calling EVP_Digest. ]*/
+    /*Tests_SRS_X509_OPENSSL_01_008: [ If the cache is not initialized, x509_openssl_credentials_acquire shall return credentials parsed from x509certificate and x509privatekey that are not shared. ]*/
+    /*Tests_SRS_X509_OPENSSL_01_012: [ x509_openssl_credentials_release shall decrement the reference count of credentials and free them, removing them from the cache, when it reaches 0. ]*/
+    TEST_FUNCTION(x509_openssl_credentials_acquire_without_cache_parses_the_credentials)
+    {
+        //arrange
+        setup_acquire_digest_mocks();
+        setup_parse_credentials_mocks();
+
+        //act
+        X509_OPENSSL_CREDENTIALS_HANDLE result = x509_openssl_credentials_acquire(TEST_PUBLIC_CERTIFICATE, TEST_PRIVATE_CERTIFICATE);
+
+        //assert
+        ASSERT_IS_NOT_NULL(result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        x509_openssl_credentials_release(result);
+    }
+
+    /*Tests_SRS_X509_OPENSSL_01_009: [ If credentials with the same digests are in the cache, x509_openssl_credentials_acquire shall increment their reference count and return them without parsing the PEM text. ]*/
+    /*Tests_SRS_X509_OPENSSL_01_010: [ Otherwise x509_openssl_credentials_acquire shall read the private key with PEM_read_bio_PrivateKey, the certificate with PEM_read_bio_X509_AUX and the rest of the chain with PEM_read_bio_X509, and add the parsed credentials to the cache. ]*/
+    TEST_FUNCTION(x509_openssl_credentials_acquire_twice_parses_the_credentials_once)
+    {
+        //arrange
+        X509_OPENSSL_CREDENTIALS_HANDLE first;
+        X509_OPENSSL_CREDENTIALS_HANDLE second;
+        ASSERT_ARE_EQUAL(int, 0, x509_openssl_credentials_cache_init());
+        umock_c_reset_all_calls();
+
+        setup_acquire_digest_mocks();
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        setup_parse_credentials_mocks();
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+        setup_acquire_digest_mocks();
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        //act
+        first = x509_openssl_credentials_acquire(TEST_PUBLIC_CERTIFICATE, TEST_PRIVATE_CERTIFICATE);
+        second = x509_openssl_credentials_acquire(TEST_PUBLIC_CERTIFICATE, TEST_PRIVATE_CERTIFICATE);
+
+        //assert
+        ASSERT_IS_NOT_NULL(first);
+        ASSERT_ARE_EQUAL(void_ptr, first, second);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        x509_openssl_credentials_release(second);
+        x509_openssl_credentials_release(first);
+    }
+
+    /*Tests_SRS_X509_OPENSSL_01_012: [ x509_openssl_credentials_release shall decrement the reference count of credentials and free them, removing them from the cache, when it reaches 0. ]*/
+    TEST_FUNCTION(x509_openssl_credentials_release_frees_the_last_reference)
+    {
+        //arrange
+        X509_OPENSSL_CREDENTIALS_HANDLE first;
+        X509_OPENSSL_CREDENTIALS_HANDLE second;
+        ASSERT_ARE_EQUAL(int, 0, x509_openssl_credentials_cache_init());
+        first = x509_openssl_credentials_acquire(TEST_PUBLIC_CERTIFICATE, TEST_PRIVATE_CERTIFICATE);
+        second = x509_openssl_credentials_acquire(TEST_PUBLIC_CERTIFICATE, TEST_PRIVATE_CERTIFICATE);
+        umock_c_reset_all_calls();
+
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+        STRICT_EXPECTED_CALL(gballoc_free(NULL));
+        STRICT_EXPECTED_CALL(X509_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(EVP_PKEY_free(g_evp_pkey));
+        STRICT_EXPECTED_CALL(gballoc_free(first));
+        STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+        //act
+        x509_openssl_credentials_release(second);
+        x509_openssl_credentials_release(first);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_X509_OPENSSL_01_011: [ If credentials is NULL, x509_openssl_credentials_release shall return. ]*/
+    TEST_FUNCTION(x509_openssl_credentials_release_with_NULL_returns)
+    {
+        //act
+        x509_openssl_credentials_release(NULL);
+
+        //assert
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_X509_OPENSSL_01_013: [ If any failure is encountered, x509_openssl_credentials_acquire shall fail and return NULL. ]*/
+    TEST_FUNCTION(x509_openssl_credentials_acquire_fails)
+    {
+        //arrange
+        int negativeTestsInitResult = umock_c_negative_tests_init();
+        ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+        setup_acquire_digest_mocks();
+        setup_parse_credentials_mocks();
+        umock_c_negative_tests_snapshot();
+
+        /*EVP_sha256, BIO_free, PEM_read_bio_X509 (the end of the chain), ERR_peek_last_error, ERR_clear_error, BIO_free*/
+        size_t calls_cannot_fail[] = { 0, 2, 7, 10, 11, 12, 13 };
+
+        size_t count = umock_c_negative_tests_call_count();
+        for (size_t index = 0; index < count; index++)
+        {
+            if (should_skip_index(index, calls_cannot_fail, sizeof(calls_cannot_fail) / sizeof(calls_cannot_fail[0])) != 0)
+            {
+                continue;
+            }
+
+            umock_c_negative_tests_reset();
+            umock_c_negative_tests_fail_call(index);
+
+            char tmp_msg[128];
+            sprintf(tmp_msg, "x509_openssl_credentials_acquire failure in test %lu/%lu", (unsigned long)index, (unsigned long)count);
+
+            //act
+            X509_OPENSSL_CREDENTIALS_HANDLE result = x509_openssl_credentials_acquire(TEST_PUBLIC_CERTIFICATE, TEST_PRIVATE_CERTIFICATE);
+
+            //assert
+            ASSERT_IS_NULL(result, tmp_msg);
+        }
+
+        //cleanup
+        umock_c_negative_tests_deinit();
+    }
+
+    /*Tests_SRS_X509_OPENSSL_01_014: [ If ssl_ctx or credentials is NULL, x509_openssl_add_parsed_credentials shall fail and return a non-zero value. ]*/
+    TEST_FUNCTION(x509_openssl_add_parsed_credentials_with_NULL_ssl_ctx_fails)
+    {
+        //arrange
+        X509_OPENSSL_CREDENTIALS_HANDLE credentials = x509_openssl_credentials_acquire(TEST_PUBLIC_CERTIFICATE, TEST_PRIVATE_CERTIFICATE);
+        umock_c_reset_all_calls();
+
+        //act
+        int result = x509_openssl_add_parsed_credentials(NULL, credentials);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        x509_openssl_credentials_release(credentials);
+    }
+
+    /*Tests_SRS_X509_OPENSSL_01_014: [ If ssl_ctx or credentials is NULL, x509_openssl_add_parsed_credentials shall fail and return a non-zero value. ]*/
+    TEST_FUNCTION(x509_openssl_add_parsed_credentials_with_NULL_credentials_fails)
+    {
+        //act
+        int result = x509_openssl_add_parsed_credentials(TEST_SSL_CTX_STRUCTURE, NULL);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    }
+
+    /*Tests_SRS_X509_OPENSSL_01_015: [ x509_openssl_add_parsed_credentials shall load the private key of credentials into ssl_ctx the same way x509_openssl_add_credentials does. ]*/
+    /*Tests_SRS_X509_OPENSSL_01_016: [ x509_openssl_add_parsed_credentials shall load the certificate of credentials by calling SSL_CTX_use_certificate. ]*/
+    /*Tests_SRS_X509_OPENSSL_01_017: [ x509_openssl_add_parsed_credentials shall replace the extra chain certificates of ssl_ctx with a new reference to each CA certificate of credentials. ]*/
+    TEST_FUNCTION(x509_openssl_add_parsed_credentials_happy_path)
+    {
+        //arrange
+        X509_OPENSSL_CREDENTIALS_HANDLE credentials = x509_openssl_credentials_acquire(TEST_PUBLIC_CERTIFICATE, TEST_PRIVATE_CERTIFICATE);
+        umock_c_reset_all_calls();
+
+#ifndef __APPLE__
+        STRICT_EXPECTED_CALL(EVP_PKEY_id(g_evp_pkey)).SetReturn(EVP_PKEY_RSA);
+#else
+        g_replace_evp_key.type = EVP_PKEY_RSA;
+#endif
+        STRICT_EXPECTED_CALL(EVP_PKEY_get1_RSA(g_evp_pkey));
+        STRICT_EXPECTED_CALL(SSL_CTX_use_RSAPrivateKey(TEST_SSL_CTX_STRUCTURE, IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(RSA_free(IGNORED_PTR_ARG));
+        STRICT_EXPECTED_CALL(SSL_CTX_use_certificate(TEST_SSL_CTX_STRUCTURE, IGNORED_PTR_ARG));
+#if (OPENSSL_VERSION_NUMBER >= 0x10100000L) && (OPENSSL_VERSION_NUMBER < 0x20000000L)
+        STRICT_EXPECTED_CALL(SSL_CTX_ctrl(TEST_SSL_CTX_STRUCTURE, SSL_CTRL_CLEAR_EXTRA_CHAIN_CERTS, 0, NULL));
+#endif
+
+        //act
+        int result = x509_openssl_add_parsed_credentials(TEST_SSL_CTX_STRUCTURE, credentials);
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        x509_openssl_credentials_release(credentials);
+    }
+
+    /*Tests_SRS_X509_OPENSSL_01_018: [ If any failure is encountered, x509_openssl_add_parsed_credentials shall fail and return a non-zero value. ]*/
+    TEST_FUNCTION(x509_openssl_add_parsed_credentials_fails_when_SSL_CTX_use_certificate_fails)
+    {
+        //arrange
+        X509_OPENSSL_CREDENTIALS_HANDLE credentials = x509_openssl_credentials_acquire(TEST_PUBLIC_CERTIFICATE, TEST_PRIVATE_CERTIFICATE);
+        umock_c_reset_all_calls();
+
+#ifndef __APPLE__
+        STRICT_EXPECTED_CALL(EVP_PKEY_id(g_evp_pkey)).SetReturn(EVP_PKEY_EC);
+#else
+        g_replace_evp_key.type = EVP_PKEY_EC;
+#endif
+        STRICT_EXPECTED_CALL(SSL_CTX_use_PrivateKey(TEST_SSL_CTX_STRUCTURE, g_evp_pkey));
+        STRICT_EXPECTED_CALL(SSL_CTX_use_certificate(TEST_SSL_CTX_STRUCTURE, IGNORED_PTR_ARG))
+            .SetReturn(0);
+        STRICT_EXPECTED_CALL(ERR_get_error());
+
+        //act
+        int result = x509_openssl_add_parsed_credentials(TEST_SSL_CTX_STRUCTURE, credentials);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+        x509_openssl_credentials_release(credentials);
+    }
+
+#ifdef X509_OPENSSL_ENGINES_SUPPORTED
+    /*Tests_SRS_X509_OPENSSL_01_019: [ If ssl_ctx, x509certificate, engine or x509privatekey_id is NULL, x509_openssl_add_engine_credentials shall fail and return a non-zero value. ]*/
+    TEST_FUNCTION(x509_openssl_add_engine_credentials_with_NULL_engine_fails)
+    {
+        //arrange
+
+        //act
+        int result = x509_openssl_add_engine_credentials(TEST_SSL_CTX_STRUCTURE, TEST_PUBLIC_CERTIFICATE, NULL, "key-id");
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    /*Tests_SRS_X509_OPENSSL_01_019: [ If ssl_ctx, x509certificate, engine or x509privatekey_id is NULL, x509_openssl_add_engine_credentials shall fail and return a non-zero value. ]*/
+    TEST_FUNCTION(x509_openssl_add_engine_credentials_with_NULL_key_id_fails)
+    {
+        //arrange
+
+        //act
+        int result = x509_openssl_add_engine_credentials(TEST_SSL_CTX_STRUCTURE, TEST_PUBLIC_CERTIFICATE, (ENGINE*)0x42, NULL);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    /*Tests_SRS_X509_OPENSSL_01_020: [ x509_openssl_add_engine_credentials shall get the private key x509privatekey_id of engine by calling ENGINE_load_private_key. ]*/
+    /*Tests_SRS_X509_OPENSSL_01_021: [ x509_openssl_add_engine_credentials shall load the private key into ssl_ctx by calling SSL_CTX_use_PrivateKey and the certificate chain of x509certificate the same way x509_openssl_add_credentials does. ]*/
+    TEST_FUNCTION(x509_openssl_add_engine_credentials_happy_path)
+    {
+        //arrange
+        STRICT_EXPECTED_CALL(ENGINE_load_private_key((ENGINE*)0x42, "key-id", NULL, NULL));
+        STRICT_EXPECTED_CALL(SSL_CTX_use_PrivateKey(TEST_SSL_CTX_STRUCTURE, g_evp_pkey));
+        setup_load_certificate_chain_mocks();
+        STRICT_EXPECTED_CALL(EVP_PKEY_free(g_evp_pkey));
+
+        //act
+        int result = x509_openssl_add_engine_credentials(TEST_SSL_CTX_STRUCTURE, TEST_PUBLIC_CERTIFICATE, (ENGINE*)0x42, "key-id");
+
+        //assert
+        ASSERT_ARE_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
+    /*Tests_SRS_X509_OPENSSL_01_022: [ If any failure is encountered, x509_openssl_add_engine_credentials shall fail and return a non-zero value. ]*/
+    TEST_FUNCTION(x509_openssl_add_engine_credentials_fails_when_ENGINE_load_private_key_fails)
+    {
+        //arrange
+        STRICT_EXPECTED_CALL(ENGINE_load_private_key((ENGINE*)0x42, "key-id", NULL, NULL))
+            .SetReturn(NULL);
+        STRICT_EXPECTED_CALL(ERR_get_error());
+
+        //act
+        int result = x509_openssl_add_engine_credentials(TEST_SSL_CTX_STRUCTURE, TEST_PUBLIC_CERTIFICATE, (ENGINE*)0x42, "key-id");
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+#endif
+
+    /*Tests_SRS_X509_OPENSSL_01_023: [ If ssl_ctx, x509certificate or x509privatekey_uri is NULL, x509_openssl_add_uri_credentials shall fail and return a non-zero value. ]*/
+    TEST_FUNCTION(x509_openssl_add_uri_credentials_with_NULL_uri_fails)
+    {
+        //arrange
+
+        //act
+        int result = x509_openssl_add_uri_credentials(TEST_SSL_CTX_STRUCTURE, TEST_PUBLIC_CERTIFICATE, NULL);
+
+        //assert
+        ASSERT_ARE_NOT_EQUAL(int, 0, result);
+        ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+        //cleanup
+    }
+
 END_TEST_SUITE(x509_openssl_unittests)
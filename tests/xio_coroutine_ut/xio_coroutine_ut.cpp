@@ -0,0 +1,464 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_bool.h"
+#include "umocktypes_stdint.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/buffer_.h"
+#include "azure_c_shared_utility/threadapi.h"
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/xio_coroutine.h"
+
+extern "C"
+{
+    extern BUFFER_HANDLE real_BUFFER_new(void);
+    extern void real_BUFFER_delete(BUFFER_HANDLE handle);
+    extern int real_BUFFER_build(BUFFER_HANDLE handle, const unsigned char* source, size_t size);
+    extern int real_BUFFER_append_build(BUFFER_HANDLE handle, const unsigned char* source, size_t size);
+    extern unsigned char* real_BUFFER_u_char(BUFFER_HANDLE handle);
+    extern size_t real_BUFFER_length(BUFFER_HANDLE handle);
+}
+
+static XIO_HANDLE TEST_XIO_HANDLE = (XIO_HANDLE)0x4242;
+static const unsigned char test_bytes[] = { 0x42, 0x43, 0x44 };
+
+/* the callbacks the awaitables registered, for the tests to call them */
+static ON_IO_OPEN_COMPLETE g_on_io_open_complete;
+static void* g_on_io_open_complete_context;
+static ON_BYTES_RECEIVED g_on_bytes_received;
+static void* g_on_bytes_received_context;
+static ON_IO_ERROR g_on_io_error;
+static void* g_on_io_error_context;
+static ON_SEND_COMPLETE g_on_send_complete;
+static void* g_on_send_complete_context;
+static ON_IO_CLOSE_COMPLETE g_on_io_close_complete;
+static void* g_on_io_close_complete_context;
+/* when set, xio_open completes the open before returning */
+static bool g_open_completes_at_once;
+
+/* what the test coroutines resumed with */
+static int g_step;
+static IO_OPEN_RESULT g_open_result;
+static IO_SEND_RESULT g_send_result;
+static int g_close_result;
+static xio_coroutine_bytes g_received;
+static unsigned char g_received_copy[16];
+
+static int my_xio_open(XIO_HANDLE xio, ON_IO_OPEN_COMPLETE on_io_open_complete, void* on_io_open_complete_context, ON_BYTES_RECEIVED on_bytes_received, void* on_bytes_received_context, ON_IO_ERROR on_io_error, void* on_io_error_context)
+{
+    (void)xio;
+    g_on_io_open_complete = on_io_open_complete;
+    g_on_io_open_complete_context = on_io_open_complete_context;
+    g_on_bytes_received = on_bytes_received;
+    g_on_bytes_received_context = on_bytes_received_context;
+    g_on_io_error = on_io_error;
+    g_on_io_error_context = on_io_error_context;
+    if (g_open_completes_at_once)
+    {
+        on_io_open_complete(on_io_open_complete_context, IO_OPEN_OK);
+    }
+    return 0;
+}
+
+static int my_xio_send(XIO_HANDLE xio, const void* buffer, size_t size, ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    (void)xio;
+    (void)buffer;
+    (void)size;
+    g_on_send_complete = on_send_complete;
+    g_on_send_complete_context = callback_context;
+    return 0;
+}
+
+static int my_xio_close(XIO_HANDLE xio, ON_IO_CLOSE_COMPLETE on_io_close_complete, void* callback_context)
+{
+    (void)xio;
+    g_on_io_close_complete = on_io_close_complete;
+    g_on_io_close_complete_context = callback_context;
+    return 0;
+}
+
+/* the dowork passes that xio_coroutine_run made, the second one completes the send */
+static int g_dowork_count;
+
+static int my_xio_dowork_ex(XIO_HANDLE xio, bool* made_progress, uint64_t* next_deadline_us)
+{
+    (void)xio;
+    g_dowork_count++;
+    *made_progress = false;
+    *next_deadline_us = XIO_NO_DEADLINE;
+    if (g_dowork_count == 2)
+    {
+        g_on_send_complete(g_on_send_complete_context, IO_SEND_OK);
+    }
+    return 0;
+}
+
+static xio_coroutine_task open_coroutine(xio_coroutine_io& io)
+{
+    g_step = 1;
+    g_open_result = co_await io.open();
+    g_step = 2;
+}
+
+static xio_coroutine_task send_coroutine(xio_coroutine_io& io)
+{
+    g_step = 1;
+    g_send_result = co_await io.send(test_bytes, sizeof(test_bytes));
+    g_step = 2;
+}
+
+static xio_coroutine_task close_coroutine(xio_coroutine_io& io)
+{
+    g_step = 1;
+    g_close_result = co_await io.close();
+    g_step = 2;
+}
+
+static xio_coroutine_task receive_coroutine(xio_coroutine_io& io)
+{
+    (void)co_await io.open();
+    g_step = 1;
+    g_received = co_await io.receive();
+    /* the bytes are only valid until the next suspension */
+    if (g_received.size <= sizeof(g_received_copy))
+    {
+        (void)memcpy(g_received_copy, g_received.bytes, g_received.size);
+    }
+    g_step = 2;
+    (void)co_await io.receive();
+    g_step = 3;
+}
+
+static xio_coroutine_task open_then_send_coroutine(xio_coroutine_io& io)
+{
+    (void)co_await io.open();
+    (void)co_await io.send(test_bytes, sizeof(test_bytes));
+    g_step = 1;
+    g_received = co_await io.receive();
+    if (g_received.size <= sizeof(g_received_copy))
+    {
+        (void)memcpy(g_received_copy, g_received.bytes, g_received.size);
+    }
+    g_step = 2;
+}
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+BEGIN_TEST_SUITE(xio_coroutine_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_bool_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(BUFFER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_SEND_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_CLOSE_COMPLETE, void*);
+
+    REGISTER_GLOBAL_MOCK_HOOK(xio_open, my_xio_open);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_send, my_xio_send);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_close, my_xio_close);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_dowork_ex, my_xio_dowork_ex);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_new, real_BUFFER_new);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_delete, real_BUFFER_delete);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_build, real_BUFFER_build);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_append_build, real_BUFFER_append_build);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_u_char, real_BUFFER_u_char);
+    REGISTER_GLOBAL_MOCK_HOOK(BUFFER_length, real_BUFFER_length);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("our mutex is ABANDONED. Failure in test framework");
+    }
+
+    umock_c_reset_all_calls();
+    g_open_completes_at_once = false;
+    g_step = 0;
+    g_dowork_count = 0;
+    g_open_result = IO_OPEN_CANCELLED;
+    g_send_result = IO_SEND_CANCELLED;
+    g_close_result = -1;
+    g_received.bytes = NULL;
+    g_received.size = 0;
+    g_received.error = false;
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* open */
+
+TEST_FUNCTION(open_suspends_until_the_open_completes)
+{
+    // arrange
+    xio_coroutine_io io(TEST_XIO_HANDLE);
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_XIO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, &io, IGNORED_PTR_ARG, &io));
+
+    // act
+    xio_coroutine_task task = open_coroutine(io);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 1, g_step);
+    ASSERT_IS_FALSE(task.done());
+
+    g_on_io_open_complete(g_on_io_open_complete_context, IO_OPEN_OK);
+    ASSERT_ARE_EQUAL(int, 2, g_step);
+    ASSERT_ARE_EQUAL(int, (int)IO_OPEN_OK, (int)g_open_result);
+    ASSERT_IS_TRUE(task.done());
+}
+
+TEST_FUNCTION(open_that_completes_before_xio_open_returns_does_not_suspend)
+{
+    // arrange
+    xio_coroutine_io io(TEST_XIO_HANDLE);
+    g_open_completes_at_once = true;
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_XIO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, &io, IGNORED_PTR_ARG, &io));
+
+    // act
+    xio_coroutine_task task = open_coroutine(io);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 2, g_step);
+    ASSERT_ARE_EQUAL(int, (int)IO_OPEN_OK, (int)g_open_result);
+    ASSERT_IS_TRUE(task.done());
+}
+
+TEST_FUNCTION(when_xio_open_fails_open_resumes_with_IO_OPEN_ERROR)
+{
+    // arrange
+    xio_coroutine_io io(TEST_XIO_HANDLE);
+
+    STRICT_EXPECTED_CALL(xio_open(TEST_XIO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, &io, IGNORED_PTR_ARG, &io))
+        .SetReturn(1);
+
+    // act
+    xio_coroutine_task task = open_coroutine(io);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)IO_OPEN_ERROR, (int)g_open_result);
+    ASSERT_IS_TRUE(task.done());
+}
+
+/* send */
+
+TEST_FUNCTION(send_suspends_until_the_send_completes)
+{
+    // arrange
+    xio_coroutine_io io(TEST_XIO_HANDLE);
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_XIO_HANDLE, test_bytes, sizeof(test_bytes), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    xio_coroutine_task task = send_coroutine(io);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 1, g_step);
+
+    g_on_send_complete(g_on_send_complete_context, IO_SEND_OK);
+    ASSERT_ARE_EQUAL(int, (int)IO_SEND_OK, (int)g_send_result);
+    ASSERT_IS_TRUE(task.done());
+}
+
+TEST_FUNCTION(when_xio_send_fails_send_resumes_with_IO_SEND_ERROR)
+{
+    // arrange
+    xio_coroutine_io io(TEST_XIO_HANDLE);
+
+    STRICT_EXPECTED_CALL(xio_send(TEST_XIO_HANDLE, test_bytes, sizeof(test_bytes), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    xio_coroutine_task task = send_coroutine(io);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, (int)IO_SEND_ERROR, (int)g_send_result);
+    ASSERT_IS_TRUE(task.done());
+}
+
+/* close */
+
+TEST_FUNCTION(close_suspends_until_the_close_completes)
+{
+    // arrange
+    xio_coroutine_io io(TEST_XIO_HANDLE);
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_XIO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    xio_coroutine_task task = close_coroutine(io);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 1, g_step);
+
+    g_on_io_close_complete(g_on_io_close_complete_context);
+    ASSERT_ARE_EQUAL(int, 0, g_close_result);
+    ASSERT_IS_TRUE(task.done());
+}
+
+TEST_FUNCTION(when_xio_close_fails_close_resumes_with_a_non_zero_value)
+{
+    // arrange
+    xio_coroutine_io io(TEST_XIO_HANDLE);
+
+    STRICT_EXPECTED_CALL(xio_close(TEST_XIO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    xio_coroutine_task task = close_coroutine(io);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, g_close_result);
+    ASSERT_IS_TRUE(task.done());
+}
+
+/* receive */
+
+TEST_FUNCTION(a_waiting_receive_gets_the_bytes_without_a_copy)
+{
+    // arrange
+    xio_coroutine_io io(TEST_XIO_HANDLE);
+    g_open_completes_at_once = true;
+    xio_coroutine_task task = receive_coroutine(io);
+    umock_c_reset_all_calls();
+
+    // act
+    g_on_bytes_received(g_on_bytes_received_context, test_bytes, sizeof(test_bytes));
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(int, 2, g_step);
+    ASSERT_ARE_EQUAL(void_ptr, (const void*)test_bytes, (const void*)g_received.bytes);
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_bytes), g_received.size);
+    ASSERT_IS_FALSE(g_received.error);
+}
+
+TEST_FUNCTION(bytes_received_while_no_receive_waits_are_kept_for_the_next_receive)
+{
+    // arrange
+    xio_coroutine_io io(TEST_XIO_HANDLE);
+    g_open_completes_at_once = true;
+    xio_coroutine_task task = open_then_send_coroutine(io);
+    g_on_bytes_received(g_on_bytes_received_context, test_bytes, 1);
+    g_on_bytes_received(g_on_bytes_received_context, test_bytes + 1, 2);
+
+    // act
+    g_on_send_complete(g_on_send_complete_context, IO_SEND_OK);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 2, g_step);
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_bytes), g_received.size);
+    ASSERT_ARE_EQUAL(int, 0, memcmp(test_bytes, g_received_copy, sizeof(test_bytes)));
+    ASSERT_IS_FALSE(g_received.error);
+    ASSERT_IS_TRUE(task.done());
+}
+
+TEST_FUNCTION(an_IO_error_resumes_the_waiting_receive_with_error)
+{
+    // arrange
+    xio_coroutine_io io(TEST_XIO_HANDLE);
+    g_open_completes_at_once = true;
+    xio_coroutine_task task = receive_coroutine(io);
+    umock_c_reset_all_calls();
+
+    // act
+    g_on_io_error(g_on_io_error_context);
+
+    // assert
+    ASSERT_IS_TRUE(g_received.error);
+    ASSERT_ARE_EQUAL(size_t, 0, g_received.size);
+    /* and the receive that follows does not wait */
+    ASSERT_ARE_EQUAL(int, 3, g_step);
+    ASSERT_IS_TRUE(task.done());
+}
+
+TEST_FUNCTION(an_IO_error_after_bytes_resumes_the_next_receive_with_error)
+{
+    // arrange
+    xio_coroutine_io io(TEST_XIO_HANDLE);
+    g_open_completes_at_once = true;
+    xio_coroutine_task task = receive_coroutine(io);
+    g_on_bytes_received(g_on_bytes_received_context, test_bytes, sizeof(test_bytes));
+
+    // act
+    g_on_io_error(g_on_io_error_context);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, sizeof(test_bytes), g_received.size);
+    ASSERT_ARE_EQUAL(int, 3, g_step);
+    ASSERT_IS_TRUE(task.done());
+}
+
+/* xio_coroutine_run */
+
+TEST_FUNCTION(xio_coroutine_run_calls_dowork_until_the_task_is_done)
+{
+    // arrange
+    xio_coroutine_io io(TEST_XIO_HANDLE);
+    xio_coroutine_task task = send_coroutine(io);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(xio_dowork_ex(TEST_XIO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(ThreadAPI_Sleep(1));
+    STRICT_EXPECTED_CALL(xio_dowork_ex(TEST_XIO_HANDLE, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(ThreadAPI_Sleep(1));
+
+    // act
+    xio_coroutine_run(io, task);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_IS_TRUE(task.done());
+}
+
+END_TEST_SUITE(xio_coroutine_unittests)
@@ -0,0 +1,919 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#include "macro_utils.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/threadapi.h"
+#include "azure_c_shared_utility/socket_reactor.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/xio_reactor_group.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+
+IMPLEMENT_UMOCK_C_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+IMPLEMENT_UMOCK_C_ENUM_TYPE(THREADAPI_RESULT, THREADAPI_RESULT_VALUES);
+
+/* enough for the reactors created with one per processor */
+#define TEST_MAX_REACTORS 1024
+#define TEST_MAX_SETOPTIONS 16
+
+static const LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4242;
+static XIO_HANDLE TEST_XIO_HANDLE = (XIO_HANDLE)0x4243;
+static XIO_HANDLE TEST_XIO_HANDLE_2 = (XIO_HANDLE)0x4244;
+
+/* the socket reactor handed to each reactor, in creation order */
+static char test_socket_reactors[TEST_MAX_REACTORS];
+static size_t test_socket_reactor_count;
+#define TEST_SOCKET_REACTOR(index) ((SOCKET_REACTOR_HANDLE)&test_socket_reactors[index])
+
+static SOCKET_REACTOR_HANDLE my_socket_reactor_create(void)
+{
+    return (test_socket_reactor_count < TEST_MAX_REACTORS) ? TEST_SOCKET_REACTOR(test_socket_reactor_count++) : NULL;
+}
+
+/* reactors do not run until they are joined, ThreadAPI_Join runs them on the test thread */
+typedef struct TEST_THREAD_TAG
+{
+    THREAD_START_FUNC func;
+    void* arg;
+    uint64_t cpu_affinity_mask;
+    const char* name;
+} TEST_THREAD;
+
+static TEST_THREAD test_threads[TEST_MAX_REACTORS];
+static size_t test_thread_count;
+
+static THREADAPI_RESULT my_ThreadAPI_Create(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg)
+{
+    ASSERT_IS_TRUE(test_thread_count < TEST_MAX_REACTORS);
+    test_threads[test_thread_count].func = func;
+    test_threads[test_thread_count].arg = arg;
+    test_threads[test_thread_count].cpu_affinity_mask = 0;
+    test_threads[test_thread_count].name = NULL;
+    *threadHandle = &test_threads[test_thread_count];
+    test_thread_count++;
+    return THREADAPI_OK;
+}
+
+static THREADAPI_RESULT my_ThreadAPI_CreateEx(THREAD_HANDLE* threadHandle, THREAD_START_FUNC func, void* arg, const THREAD_ATTRIBUTES* attributes)
+{
+    THREADAPI_RESULT result = my_ThreadAPI_Create(threadHandle, func, arg);
+    test_threads[test_thread_count - 1].cpu_affinity_mask = attributes->cpu_affinity_mask;
+    test_threads[test_thread_count - 1].name = attributes->name;
+    return result;
+}
+
+static THREADAPI_RESULT my_ThreadAPI_Join(THREAD_HANDLE threadHandle, int* res)
+{
+    TEST_THREAD* thread = (TEST_THREAD*)threadHandle;
+    *res = thread->func(thread->arg);
+    return THREADAPI_OK;
+}
+
+/* the OPTION_SOCKET_REACTOR values set on the IO stacks, in order */
+static XIO_HANDLE g_setoption_xios[TEST_MAX_SETOPTIONS];
+static const void* g_setoption_values[TEST_MAX_SETOPTIONS];
+static size_t g_setoption_count;
+
+static int my_xio_setoption(XIO_HANDLE xio, const char* optionName, const void* value)
+{
+    ASSERT_ARE_EQUAL(char_ptr, OPTION_SOCKET_REACTOR, optionName);
+    ASSERT_IS_TRUE(g_setoption_count < TEST_MAX_SETOPTIONS);
+    g_setoption_xios[g_setoption_count] = xio;
+    g_setoption_values[g_setoption_count] = value;
+    g_setoption_count++;
+    return 0;
+}
+
+/* the calls made on the reactor threads, in order */
+static void* g_call_contexts[TEST_MAX_SETOPTIONS];
+static XIO_HANDLE g_call_xios[TEST_MAX_SETOPTIONS];
+static size_t g_call_count;
+
+static void on_reactor_call(void* context, XIO_HANDLE xio)
+{
+    ASSERT_IS_TRUE(g_call_count < TEST_MAX_SETOPTIONS);
+    g_call_contexts[g_call_count] = context;
+    g_call_xios[g_call_count] = xio;
+    g_call_count++;
+}
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+static XIO_REACTOR_GROUP_HANDLE create_group(size_t reactor_count)
+{
+    XIO_REACTOR_GROUP_CONFIG config;
+    XIO_REACTOR_GROUP_HANDLE result;
+
+    config.reactor_count = reactor_count;
+    config.pin_reactors = false;
+    result = xio_reactor_group_create(&config);
+    ASSERT_IS_NOT_NULL(result);
+    umock_c_reset_all_calls();
+    return result;
+}
+
+static XIO_REACTOR_CONNECTION_HANDLE add_connection(XIO_REACTOR_GROUP_HANDLE group, XIO_HANDLE xio)
+{
+    XIO_REACTOR_CONNECTION_HANDLE result = xio_reactor_group_add(group, xio, NULL, NULL);
+    ASSERT_IS_NOT_NULL(result);
+    umock_c_reset_all_calls();
+    return result;
+}
+
+static size_t get_connection_count(XIO_REACTOR_GROUP_HANDLE group, size_t reactor_index)
+{
+    XIO_REACTOR_LOAD load;
+    ASSERT_ARE_EQUAL(int, 0, xio_reactor_group_get_load(group, reactor_index, &load));
+    return load.connection_count;
+}
+
+BEGIN_TEST_SUITE(xio_reactor_group_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result, "umock_c_init");
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_charptr_register_types");
+
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_stdint_register_types");
+
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(THREAD_START_FUNC, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(SOCKET_REACTOR_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_SOCKET_REACTOR_EVENT, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_TYPE(LOCK_RESULT, LOCK_RESULT);
+    REGISTER_TYPE(THREADAPI_RESULT, THREADAPI_RESULT);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_FAIL_RETURN(Lock, LOCK_ERROR);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Create, my_ThreadAPI_Create);
+    REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_CreateEx, my_ThreadAPI_CreateEx);
+    REGISTER_GLOBAL_MOCK_HOOK(ThreadAPI_Join, my_ThreadAPI_Join);
+    REGISTER_GLOBAL_MOCK_HOOK(socket_reactor_create, my_socket_reactor_create);
+    REGISTER_GLOBAL_MOCK_RETURN(socket_reactor_wake, 0);
+    REGISTER_GLOBAL_MOCK_RETURN(socket_reactor_run, 0);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_setoption, my_xio_setoption);
+    REGISTER_GLOBAL_MOCK_RETURN(tickcounter_get_monotonic_us, 0);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    test_socket_reactor_count = 0;
+    test_thread_count = 0;
+    g_setoption_count = 0;
+    g_call_count = 0;
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/* xio_reactor_group_create */
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_001: [ xio_reactor_group_create shall allocate the group and create its lock. ]*/
+/* Tests_SRS_XIO_REACTOR_GROUP_01_003: [ xio_reactor_group_create shall create a socket reactor for each reactor. ]*/
+/* Tests_SRS_XIO_REACTOR_GROUP_01_004: [ xio_reactor_group_create shall start a thread for each reactor, named xio_reactor and pinned to the processor of its index when pin_reactors is true. ]*/
+/* Tests_SRS_XIO_REACTOR_GROUP_01_026: [ xio_reactor_group_get_reactor_count shall return the number of reactors of group, 0 if group is NULL. ]*/
+TEST_FUNCTION(xio_reactor_group_create_starts_the_configured_number_of_reactors)
+{
+    // arrange
+    XIO_REACTOR_GROUP_CONFIG config = { 2, false };
+    XIO_REACTOR_GROUP_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(socket_reactor_create());
+    STRICT_EXPECTED_CALL(socket_reactor_create());
+    STRICT_EXPECTED_CALL(ThreadAPI_CreateEx(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(ThreadAPI_CreateEx(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = xio_reactor_group_create(&config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 2, xio_reactor_group_get_reactor_count(result));
+    ASSERT_ARE_EQUAL(char_ptr, "xio_reactor", test_threads[0].name);
+    ASSERT_IS_TRUE(test_threads[0].cpu_affinity_mask == 0);
+    ASSERT_IS_TRUE(test_threads[1].cpu_affinity_mask == 0);
+
+    // cleanup
+    xio_reactor_group_destroy(result);
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_002: [ If config is NULL or its reactor_count is 0, xio_reactor_group_create shall create one reactor per processor; reactors are pinned only when config asks for it. ]*/
+TEST_FUNCTION(xio_reactor_group_create_with_NULL_config_creates_at_least_one_unpinned_reactor)
+{
+    // arrange
+    XIO_REACTOR_GROUP_HANDLE result;
+
+    // act
+    result = xio_reactor_group_create(NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(xio_reactor_group_get_reactor_count(result) >= 1);
+    ASSERT_ARE_EQUAL(size_t, xio_reactor_group_get_reactor_count(result), test_thread_count);
+    ASSERT_IS_TRUE(test_threads[0].cpu_affinity_mask == 0);
+
+    // cleanup
+    xio_reactor_group_destroy(result);
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_002: [ If config is NULL or its reactor_count is 0, xio_reactor_group_create shall create one reactor per processor; reactors are pinned only when config asks for it. ]*/
+TEST_FUNCTION(xio_reactor_group_create_with_0_reactors_creates_as_many_reactors_as_with_NULL_config)
+{
+    // arrange
+    XIO_REACTOR_GROUP_CONFIG config = { 0, false };
+    XIO_REACTOR_GROUP_HANDLE default_group = xio_reactor_group_create(NULL);
+    XIO_REACTOR_GROUP_HANDLE result;
+    ASSERT_IS_NOT_NULL(default_group);
+
+    // act
+    result = xio_reactor_group_create(&config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(size_t, xio_reactor_group_get_reactor_count(default_group), xio_reactor_group_get_reactor_count(result));
+
+    // cleanup
+    xio_reactor_group_destroy(result);
+    xio_reactor_group_destroy(default_group);
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_004: [ xio_reactor_group_create shall start a thread for each reactor, named xio_reactor and pinned to the processor of its index when pin_reactors is true. ]*/
+TEST_FUNCTION(xio_reactor_group_create_with_pin_reactors_pins_each_reactor_to_one_processor)
+{
+    // arrange
+    XIO_REACTOR_GROUP_CONFIG config = { 1, true };
+    XIO_REACTOR_GROUP_HANDLE result;
+
+    // act
+    result = xio_reactor_group_create(&config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_IS_TRUE(test_threads[0].cpu_affinity_mask == 1);
+
+    // cleanup
+    xio_reactor_group_destroy(result);
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_004: [ xio_reactor_group_create shall start a thread for each reactor, named xio_reactor and pinned to the processor of its index when pin_reactors is true. ]*/
+TEST_FUNCTION(xio_reactor_group_create_falls_back_to_ThreadAPI_Create_when_attributes_are_not_supported)
+{
+    // arrange
+    XIO_REACTOR_GROUP_CONFIG config = { 1, true };
+    XIO_REACTOR_GROUP_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(socket_reactor_create());
+    STRICT_EXPECTED_CALL(ThreadAPI_CreateEx(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(THREADAPI_INVALID_ARG);
+    STRICT_EXPECTED_CALL(ThreadAPI_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = xio_reactor_group_create(&config);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_reactor_group_destroy(result);
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_005: [ If any failure occurs, xio_reactor_group_create shall stop the reactors it started, free all resources and return NULL. ]*/
+TEST_FUNCTION(when_creating_a_socket_reactor_fails_xio_reactor_group_create_fails)
+{
+    // arrange
+    XIO_REACTOR_GROUP_CONFIG config = { 2, false };
+    XIO_REACTOR_GROUP_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(socket_reactor_create());
+    STRICT_EXPECTED_CALL(socket_reactor_create())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(socket_reactor_destroy(TEST_SOCKET_REACTOR(0)));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = xio_reactor_group_create(&config);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, test_thread_count);
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_005: [ If any failure occurs, xio_reactor_group_create shall stop the reactors it started, free all resources and return NULL. ]*/
+TEST_FUNCTION(when_starting_a_thread_fails_xio_reactor_group_create_stops_the_reactors_already_started)
+{
+    // arrange
+    XIO_REACTOR_GROUP_CONFIG config = { 2, false };
+    XIO_REACTOR_GROUP_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(socket_reactor_create());
+    STRICT_EXPECTED_CALL(socket_reactor_create());
+    STRICT_EXPECTED_CALL(ThreadAPI_CreateEx(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(ThreadAPI_CreateEx(IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(THREADAPI_ERROR);
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(socket_reactor_wake(TEST_SOCKET_REACTOR(0)));
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(socket_reactor_destroy(TEST_SOCKET_REACTOR(0)));
+    STRICT_EXPECTED_CALL(socket_reactor_destroy(TEST_SOCKET_REACTOR(1)));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = xio_reactor_group_create(&config);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* xio_reactor_group_destroy */
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_006: [ If group is NULL, xio_reactor_group_destroy shall return. ]*/
+TEST_FUNCTION(xio_reactor_group_destroy_with_NULL_group_returns)
+{
+    // arrange
+
+    // act
+    xio_reactor_group_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_007: [ xio_reactor_group_destroy shall queue a stop request behind the requests of each reactor and join the reactor threads. ]*/
+/* Tests_SRS_XIO_REACTOR_GROUP_01_009: [ xio_reactor_group_destroy shall destroy the socket reactors and the lock and free the group. ]*/
+TEST_FUNCTION(xio_reactor_group_destroy_stops_and_joins_the_reactors)
+{
+    // arrange
+    XIO_REACTOR_GROUP_HANDLE group = create_group(2);
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(socket_reactor_wake(TEST_SOCKET_REACTOR(0)));
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(&test_threads[0], IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(socket_reactor_wake(TEST_SOCKET_REACTOR(1)));
+    STRICT_EXPECTED_CALL(ThreadAPI_Join(&test_threads[1], IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(socket_reactor_destroy(TEST_SOCKET_REACTOR(0)));
+    STRICT_EXPECTED_CALL(socket_reactor_destroy(TEST_SOCKET_REACTOR(1)));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    xio_reactor_group_destroy(group);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_008: [ xio_reactor_group_destroy shall run the requests still queued, set OPTION_SOCKET_REACTOR to NULL on the connections left in the group and free them. ]*/
+TEST_FUNCTION(xio_reactor_group_destroy_takes_the_connections_left_off_their_socket_reactor)
+{
+    // arrange
+    XIO_REACTOR_GROUP_HANDLE group = create_group(1);
+    (void)add_connection(group, TEST_XIO_HANDLE);
+
+    // act
+    xio_reactor_group_destroy(group);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, g_setoption_count);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_XIO_HANDLE, g_setoption_xios[0]);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_SOCKET_REACTOR(0), g_setoption_values[0]);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_XIO_HANDLE, g_setoption_xios[1]);
+    ASSERT_IS_NULL(g_setoption_values[1]);
+}
+
+/* xio_reactor_group_add */
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_010: [ If group or xio is NULL, xio_reactor_group_add shall fail and return NULL. ]*/
+TEST_FUNCTION(xio_reactor_group_add_with_NULL_group_fails)
+{
+    // arrange
+    XIO_REACTOR_CONNECTION_HANDLE result;
+
+    // act
+    result = xio_reactor_group_add(NULL, TEST_XIO_HANDLE, on_reactor_call, NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_010: [ If group or xio is NULL, xio_reactor_group_add shall fail and return NULL. ]*/
+TEST_FUNCTION(xio_reactor_group_add_with_NULL_xio_fails)
+{
+    // arrange
+    XIO_REACTOR_GROUP_HANDLE group = create_group(1);
+    XIO_REACTOR_CONNECTION_HANDLE result;
+
+    // act
+    result = xio_reactor_group_add(group, NULL, on_reactor_call, NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_reactor_group_destroy(group);
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_011: [ xio_reactor_group_add shall place the connection on the reactor with the fewest connections, the one with the lowest busy_percent among those. ]*/
+/* Tests_SRS_XIO_REACTOR_GROUP_01_013: [ xio_reactor_group_add shall wake the reactor and return the connection. ]*/
+TEST_FUNCTION(xio_reactor_group_add_places_the_connection_on_the_reactor_with_the_fewest_connections)
+{
+    // arrange
+    XIO_REACTOR_GROUP_HANDLE group = create_group(2);
+    XIO_REACTOR_CONNECTION_HANDLE result;
+    (void)add_connection(group, TEST_XIO_HANDLE);
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(socket_reactor_wake(TEST_SOCKET_REACTOR(1)));
+
+    // act
+    result = xio_reactor_group_add(group, TEST_XIO_HANDLE_2, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, get_connection_count(group, 0));
+    ASSERT_ARE_EQUAL(size_t, 1, get_connection_count(group, 1));
+
+    // cleanup
+    xio_reactor_group_destroy(group);
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_012: [ The reactor thread shall set OPTION_SOCKET_REACTOR to its socket reactor on the connection, polling the connection if that fails, and then call on_added if it is not NULL. ]*/
+TEST_FUNCTION(the_reactor_thread_puts_an_added_connection_on_its_socket_reactor_and_calls_on_added)
+{
+    // arrange
+    XIO_REACTOR_GROUP_HANDLE group = create_group(1);
+    (void)xio_reactor_group_add(group, TEST_XIO_HANDLE, on_reactor_call, (void*)0x42);
+
+    // act
+    xio_reactor_group_destroy(group);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_SOCKET_REACTOR(0), g_setoption_values[0]);
+    ASSERT_ARE_EQUAL(size_t, 1, g_call_count);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x42, g_call_contexts[0]);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_XIO_HANDLE, g_call_xios[0]);
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_014: [ If any failure occurs, xio_reactor_group_add shall fail and return NULL. ]*/
+TEST_FUNCTION(when_Lock_fails_xio_reactor_group_add_fails)
+{
+    // arrange
+    XIO_REACTOR_GROUP_HANDLE group = create_group(1);
+    XIO_REACTOR_CONNECTION_HANDLE result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE))
+        .SetReturn(LOCK_ERROR);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = xio_reactor_group_add(group, TEST_XIO_HANDLE, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, get_connection_count(group, 0));
+
+    // cleanup
+    xio_reactor_group_destroy(group);
+}
+
+/* xio_reactor_group_remove */
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_015: [ If connection is NULL, xio_reactor_group_remove shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_reactor_group_remove_with_NULL_connection_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = xio_reactor_group_remove(NULL, on_reactor_call, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_016: [ xio_reactor_group_remove shall queue the removal behind the requests made for the connection and wake its reactor. ]*/
+/* Tests_SRS_XIO_REACTOR_GROUP_01_017: [ The reactor thread shall set OPTION_SOCKET_REACTOR to NULL on the connection, drop the requests made for it afterwards, call on_removed if it is not NULL and free the connection. ]*/
+TEST_FUNCTION(xio_reactor_group_remove_takes_the_connection_off_its_reactor_and_calls_on_removed)
+{
+    // arrange
+    XIO_REACTOR_GROUP_HANDLE group = create_group(1);
+    XIO_REACTOR_CONNECTION_HANDLE connection = add_connection(group, TEST_XIO_HANDLE);
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(socket_reactor_wake(TEST_SOCKET_REACTOR(0)));
+
+    // act
+    result = xio_reactor_group_remove(connection, on_reactor_call, (void*)0x43);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, get_connection_count(group, 0));
+    xio_reactor_group_destroy(group);
+    ASSERT_ARE_EQUAL(size_t, 2, g_setoption_count);
+    ASSERT_IS_NULL(g_setoption_values[1]);
+    ASSERT_ARE_EQUAL(size_t, 1, g_call_count);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x43, g_call_contexts[0]);
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_018: [ If any failure occurs, xio_reactor_group_remove shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_Lock_fails_xio_reactor_group_remove_fails)
+{
+    // arrange
+    XIO_REACTOR_GROUP_HANDLE group = create_group(1);
+    XIO_REACTOR_CONNECTION_HANDLE connection = add_connection(group, TEST_XIO_HANDLE);
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE))
+        .SetReturn(LOCK_ERROR);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = xio_reactor_group_remove(connection, on_reactor_call, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, get_connection_count(group, 0));
+
+    // cleanup
+    xio_reactor_group_destroy(group);
+}
+
+/* xio_reactor_group_call */
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_019: [ If connection or on_call is NULL, xio_reactor_group_call shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_reactor_group_call_with_NULL_on_call_fails)
+{
+    // arrange
+    XIO_REACTOR_GROUP_HANDLE group = create_group(1);
+    XIO_REACTOR_CONNECTION_HANDLE connection = add_connection(group, TEST_XIO_HANDLE);
+    int result;
+
+    // act
+    result = xio_reactor_group_call(connection, NULL, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_reactor_group_destroy(group);
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_020: [ xio_reactor_group_call shall queue the call behind the requests made for the connection and wake its reactor, whose thread calls on_call with on_call_context and the IO stack. ]*/
+TEST_FUNCTION(xio_reactor_group_call_runs_the_calls_in_order_on_the_reactor_thread)
+{
+    // arrange
+    XIO_REACTOR_GROUP_HANDLE group = create_group(1);
+    XIO_REACTOR_CONNECTION_HANDLE connection = add_connection(group, TEST_XIO_HANDLE);
+    int result_1;
+    int result_2;
+
+    // act
+    result_1 = xio_reactor_group_call(connection, on_reactor_call, (void*)0x1);
+    result_2 = xio_reactor_group_call(connection, on_reactor_call, (void*)0x2);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result_1);
+    ASSERT_ARE_EQUAL(int, 0, result_2);
+    ASSERT_ARE_EQUAL(size_t, 0, g_call_count);
+    xio_reactor_group_destroy(group);
+    ASSERT_ARE_EQUAL(size_t, 2, g_call_count);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x1, g_call_contexts[0]);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x2, g_call_contexts[1]);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_XIO_HANDLE, g_call_xios[1]);
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_021: [ If any failure occurs, xio_reactor_group_call shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_the_request_fails_xio_reactor_group_call_fails)
+{
+    // arrange
+    XIO_REACTOR_GROUP_HANDLE group = create_group(1);
+    XIO_REACTOR_CONNECTION_HANDLE connection = add_connection(group, TEST_XIO_HANDLE);
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = xio_reactor_group_call(connection, on_reactor_call, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_reactor_group_destroy(group);
+    ASSERT_ARE_EQUAL(size_t, 0, g_call_count);
+}
+
+/* xio_reactor_group_migrate */
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_022: [ If connection is NULL or reactor_index is not the index of a reactor of the group, xio_reactor_group_migrate shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_reactor_group_migrate_with_NULL_connection_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = xio_reactor_group_migrate(NULL, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_022: [ If connection is NULL or reactor_index is not the index of a reactor of the group, xio_reactor_group_migrate shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_reactor_group_migrate_to_a_reactor_outside_the_group_fails)
+{
+    // arrange
+    XIO_REACTOR_GROUP_HANDLE group = create_group(2);
+    XIO_REACTOR_CONNECTION_HANDLE connection = add_connection(group, TEST_XIO_HANDLE);
+    int result;
+
+    // act
+    result = xio_reactor_group_migrate(connection, 2);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_reactor_group_destroy(group);
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_023: [ xio_reactor_group_migrate shall queue the migration behind the requests made for the connection, count the connection on the target reactor and wake its current reactor. ]*/
+TEST_FUNCTION(xio_reactor_group_migrate_counts_the_connection_on_the_target_reactor)
+{
+    // arrange
+    XIO_REACTOR_GROUP_HANDLE group = create_group(2);
+    XIO_REACTOR_CONNECTION_HANDLE connection = add_connection(group, TEST_XIO_HANDLE);
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(socket_reactor_wake(TEST_SOCKET_REACTOR(0)));
+
+    // act
+    result = xio_reactor_group_migrate(connection, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, get_connection_count(group, 0));
+    ASSERT_ARE_EQUAL(size_t, 1, get_connection_count(group, 1));
+
+    // cleanup
+    xio_reactor_group_destroy(group);
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_024: [ The reactor thread shall take the connection off its connections, make the target reactor receive the requests for it, queue an adopt request first, and wake the target, whose thread sets OPTION_SOCKET_REACTOR to its socket reactor. ]*/
+TEST_FUNCTION(a_migrated_connection_moves_to_the_socket_reactor_of_the_target_with_its_requests)
+{
+    // arrange
+    XIO_REACTOR_GROUP_HANDLE group = create_group(2);
+    XIO_REACTOR_CONNECTION_HANDLE connection = add_connection(group, TEST_XIO_HANDLE);
+    ASSERT_ARE_EQUAL(int, 0, xio_reactor_group_migrate(connection, 1));
+    ASSERT_ARE_EQUAL(int, 0, xio_reactor_group_call(connection, on_reactor_call, (void*)0x44));
+
+    // act
+    xio_reactor_group_destroy(group);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 3, g_setoption_count);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_SOCKET_REACTOR(0), g_setoption_values[0]);
+    ASSERT_ARE_EQUAL(void_ptr, TEST_SOCKET_REACTOR(1), g_setoption_values[1]);
+    ASSERT_IS_NULL(g_setoption_values[2]);
+    ASSERT_ARE_EQUAL(size_t, 1, g_call_count);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x44, g_call_contexts[0]);
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_025: [ If any failure occurs, xio_reactor_group_migrate shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_allocating_the_adopt_request_fails_xio_reactor_group_migrate_fails)
+{
+    // arrange
+    XIO_REACTOR_GROUP_HANDLE group = create_group(2);
+    XIO_REACTOR_CONNECTION_HANDLE connection = add_connection(group, TEST_XIO_HANDLE);
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(NULL));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = xio_reactor_group_migrate(connection, 1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, get_connection_count(group, 0));
+
+    // cleanup
+    xio_reactor_group_destroy(group);
+}
+
+/* xio_reactor_group_get_reactor_count */
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_026: [ xio_reactor_group_get_reactor_count shall return the number of reactors of group, 0 if group is NULL. ]*/
+TEST_FUNCTION(xio_reactor_group_get_reactor_count_with_NULL_group_returns_0)
+{
+    // arrange
+
+    // act
+    size_t result = xio_reactor_group_get_reactor_count(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, result);
+}
+
+/* xio_reactor_group_get_load */
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_027: [ If group or load is NULL or reactor_index is not the index of a reactor of the group, xio_reactor_group_get_load shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_reactor_group_get_load_with_invalid_arguments_fails)
+{
+    // arrange
+    XIO_REACTOR_GROUP_HANDLE group = create_group(1);
+    XIO_REACTOR_LOAD load;
+
+    // act
+    int result_null_group = xio_reactor_group_get_load(NULL, 0, &load);
+    int result_bad_index = xio_reactor_group_get_load(group, 1, &load);
+    int result_null_load = xio_reactor_group_get_load(group, 0, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_null_group);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_bad_index);
+    ASSERT_ARE_NOT_EQUAL(int, 0, result_null_load);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_reactor_group_destroy(group);
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_028: [ xio_reactor_group_get_load shall copy the connection count and busy_percent of the reactor into load. ]*/
+TEST_FUNCTION(xio_reactor_group_get_load_gives_the_load_of_the_reactor)
+{
+    // arrange
+    XIO_REACTOR_GROUP_HANDLE group = create_group(1);
+    XIO_REACTOR_LOAD load;
+    int result;
+    (void)add_connection(group, TEST_XIO_HANDLE);
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = xio_reactor_group_get_load(group, 0, &load);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, load.connection_count);
+    ASSERT_ARE_EQUAL(int, 0, (int)load.busy_percent);
+
+    // cleanup
+    xio_reactor_group_destroy(group);
+}
+
+/* Tests_SRS_XIO_REACTOR_GROUP_01_029: [ If any failure occurs, xio_reactor_group_get_load shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_Lock_fails_xio_reactor_group_get_load_fails)
+{
+    // arrange
+    XIO_REACTOR_GROUP_HANDLE group = create_group(1);
+    XIO_REACTOR_LOAD load;
+    int result;
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE))
+        .SetReturn(LOCK_ERROR);
+
+    // act
+    result = xio_reactor_group_get_load(group, 0, &load);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_reactor_group_destroy(group);
+}
+
+END_TEST_SUITE(xio_reactor_group_unittests)
@@ -0,0 +1,8 @@
+#include "testrunnerswitcher.h"
+
+int main(void)
+{
+    size_t failedTestCount = 0;
+    RUN_TEST_SUITE(xio_stack_unittests, failedTestCount);
+    return failedTestCount;
+}
@@ -0,0 +1,387 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <string.h>
+#include <stdbool.h>
+#endif
+
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/socketio.h"
+#include "azure_c_shared_utility/http_proxy_io.h"
+#include "azure_c_shared_utility/tlsio.h"
+#include "azure_c_shared_utility/wsio.h"
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/xio_stack.h"
+#include "azure_c_shared_utility/shared_util_options.h"
+
+static const IO_INTERFACE_DESCRIPTION* TEST_SOCKETIO_INTERFACE = (const IO_INTERFACE_DESCRIPTION*)0x4201;
+static const IO_INTERFACE_DESCRIPTION* TEST_HTTP_PROXY_IO_INTERFACE = (const IO_INTERFACE_DESCRIPTION*)0x4202;
+static const IO_INTERFACE_DESCRIPTION* TEST_TLSIO_INTERFACE = (const IO_INTERFACE_DESCRIPTION*)0x4203;
+static const IO_INTERFACE_DESCRIPTION* TEST_WSIO_INTERFACE = (const IO_INTERFACE_DESCRIPTION*)0x4204;
+static XIO_HANDLE TEST_XIO_HANDLE = (XIO_HANDLE)0x4242;
+
+/* the configs only live for the xio_create call, so the hook keeps what the tests check */
+static const IO_INTERFACE_DESCRIPTION* g_ws_underlying_interface;
+static const IO_INTERFACE_DESCRIPTION* g_tls_underlying_interface;
+static const char* g_ws_resource_name;
+static const char* g_ws_protocol;
+static const char* g_tls_hostname;
+static const char* g_bottom_hostname;
+static int g_bottom_port;
+static const char* g_proxy_hostname;
+static int g_proxy_port;
+static size_t g_read_chunk_size;
+
+static XIO_HANDLE my_xio_create(const IO_INTERFACE_DESCRIPTION* io_interface_description, const void* xio_create_parameters)
+{
+    const IO_INTERFACE_DESCRIPTION* layer_interface = io_interface_description;
+    const void* layer_parameters = xio_create_parameters;
+
+    if (layer_interface == TEST_WSIO_INTERFACE)
+    {
+        const WSIO_CONFIG* wsio_config = (const WSIO_CONFIG*)layer_parameters;
+        g_ws_resource_name = wsio_config->resource_name;
+        g_ws_protocol = wsio_config->protocol;
+        g_ws_underlying_interface = wsio_config->underlying_io_interface;
+        layer_interface = wsio_config->underlying_io_interface;
+        layer_parameters = wsio_config->underlying_io_parameters;
+    }
+    if (layer_interface == TEST_TLSIO_INTERFACE)
+    {
+        const TLSIO_CONFIG* tlsio_config = (const TLSIO_CONFIG*)layer_parameters;
+        g_tls_hostname = tlsio_config->hostname;
+        g_tls_underlying_interface = tlsio_config->underlying_io_interface;
+        layer_interface = tlsio_config->underlying_io_interface;
+        layer_parameters = tlsio_config->underlying_io_parameters;
+    }
+    if (layer_interface == TEST_SOCKETIO_INTERFACE)
+    {
+        const SOCKETIO_CONFIG* socketio_config = (const SOCKETIO_CONFIG*)layer_parameters;
+        g_bottom_hostname = socketio_config->hostname;
+        g_bottom_port = socketio_config->port;
+    }
+    else if (layer_interface == TEST_HTTP_PROXY_IO_INTERFACE)
+    {
+        const HTTP_PROXY_IO_CONFIG* http_proxy_io_config = (const HTTP_PROXY_IO_CONFIG*)layer_parameters;
+        g_bottom_hostname = http_proxy_io_config->hostname;
+        g_bottom_port = http_proxy_io_config->port;
+        g_proxy_hostname = http_proxy_io_config->proxy_hostname;
+        g_proxy_port = http_proxy_io_config->proxy_port;
+    }
+    return TEST_XIO_HANDLE;
+}
+
+static int my_xio_setoption(XIO_HANDLE xio, const char* optionName, const void* value)
+{
+    (void)xio;
+    if (strcmp(optionName, OPTION_TLS_READ_CHUNK_SIZE) == 0)
+    {
+        g_read_chunk_size = *(const size_t*)value;
+    }
+    return 0;
+}
+
+MU_DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%" PRI_MU_ENUM "", MU_ENUM_VALUE(UMOCK_C_ERROR_CODE, error_code));
+}
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+static XIO_STACK_CONFIG make_config(void)
+{
+    XIO_STACK_CONFIG config;
+    config.hostname = "test.host";
+    config.port = 443;
+    config.proxy_hostname = NULL;
+    config.proxy_port = 0;
+    config.proxy_username = NULL;
+    config.proxy_password = NULL;
+    config.tlsio_interface = NULL;
+    config.ws_resource_name = NULL;
+    config.ws_protocol = NULL;
+    return config;
+}
+
+BEGIN_TEST_SUITE(xio_stack_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    umock_c_init(on_umock_c_error);
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
+
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(CONCRETE_IO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_SEND_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_CLOSE_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+
+    REGISTER_GLOBAL_MOCK_RETURN(socketio_get_interface_description, TEST_SOCKETIO_INTERFACE);
+    REGISTER_GLOBAL_MOCK_RETURN(http_proxy_io_get_interface_description, TEST_HTTP_PROXY_IO_INTERFACE);
+    REGISTER_GLOBAL_MOCK_RETURN(wsio_get_interface_description, TEST_WSIO_INTERFACE);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_create, my_xio_create);
+    REGISTER_GLOBAL_MOCK_HOOK(xio_setoption, my_xio_setoption);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    g_ws_underlying_interface = NULL;
+    g_tls_underlying_interface = NULL;
+    g_ws_resource_name = NULL;
+    g_ws_protocol = NULL;
+    g_tls_hostname = NULL;
+    g_bottom_hostname = NULL;
+    g_bottom_port = 0;
+    g_proxy_hostname = NULL;
+    g_proxy_port = 0;
+    g_read_chunk_size = 0;
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+/* xio_stack_create */
+
+/* Tests_SRS_XIO_STACK_01_001: [ If config is NULL, its hostname is NULL, or it has a ws_resource_name but no ws_protocol, xio_stack_create shall fail and return NULL. ]*/
+TEST_FUNCTION(xio_stack_create_with_NULL_config_fails)
+{
+    // arrange
+    XIO_HANDLE result;
+
+    // act
+    result = xio_stack_create(NULL);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_STACK_01_001: [ If config is NULL, its hostname is NULL, or it has a ws_resource_name but no ws_protocol, xio_stack_create shall fail and return NULL. ]*/
+TEST_FUNCTION(xio_stack_create_with_NULL_hostname_fails)
+{
+    // arrange
+    XIO_HANDLE result;
+    XIO_STACK_CONFIG config = make_config();
+    config.hostname = NULL;
+
+    // act
+    result = xio_stack_create(&config);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_STACK_01_001: [ If config is NULL, its hostname is NULL, or it has a ws_resource_name but no ws_protocol, xio_stack_create shall fail and return NULL. ]*/
+TEST_FUNCTION(xio_stack_create_with_ws_resource_name_and_NULL_ws_protocol_fails)
+{
+    // arrange
+    XIO_HANDLE result;
+    XIO_STACK_CONFIG config = make_config();
+    config.ws_resource_name = "/ws";
+
+    // act
+    result = xio_stack_create(&config);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_STACK_01_002: [ Without a proxy_hostname the bottom layer shall be a socket IO connecting to hostname and port. ]*/
+/* Tests_SRS_XIO_STACK_01_007: [ xio_stack_create shall create the stack by calling xio_create for the top layer, which creates each layer below it. ]*/
+/* Tests_SRS_XIO_STACK_01_010: [ xio_stack_create shall set OPTION_SOCKETIO_SHARED_RECEIVE_BUFFER, since every layer above the socket consumes the received bytes during on_bytes_received. ]*/
+/* Tests_SRS_XIO_STACK_01_012: [ On success xio_stack_create shall return the handle of the top layer. ]*/
+TEST_FUNCTION(xio_stack_create_creates_a_socket_io)
+{
+    // arrange
+    XIO_HANDLE result;
+    XIO_STACK_CONFIG config = make_config();
+
+    STRICT_EXPECTED_CALL(socketio_get_interface_description());
+    STRICT_EXPECTED_CALL(xio_create(TEST_SOCKETIO_INTERFACE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_XIO_HANDLE, OPTION_SOCKETIO_SHARED_RECEIVE_BUFFER, IGNORED_PTR_ARG));
+
+    // act
+    result = xio_stack_create(&config);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_XIO_HANDLE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(char_ptr, "test.host", g_bottom_hostname);
+    ASSERT_ARE_EQUAL(int, 443, g_bottom_port);
+}
+
+/* Tests_SRS_XIO_STACK_01_003: [ With a proxy_hostname the bottom layer shall be an HTTP proxy IO tunnelling to hostname and port through proxy_hostname, proxy_port, proxy_username and proxy_password. ]*/
+/* Tests_SRS_XIO_STACK_01_004: [ If tlsio_interface is not NULL a TLS IO of that interface shall be stacked on the layer below, for hostname and port. ]*/
+TEST_FUNCTION(xio_stack_create_creates_a_tls_io_over_an_http_proxy_io)
+{
+    // arrange
+    XIO_HANDLE result;
+    XIO_STACK_CONFIG config = make_config();
+    config.proxy_hostname = "proxy.host";
+    config.proxy_port = 8888;
+    config.tlsio_interface = TEST_TLSIO_INTERFACE;
+
+    STRICT_EXPECTED_CALL(http_proxy_io_get_interface_description());
+    STRICT_EXPECTED_CALL(xio_create(TEST_TLSIO_INTERFACE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_XIO_HANDLE, OPTION_SOCKETIO_SHARED_RECEIVE_BUFFER, IGNORED_PTR_ARG));
+
+    // act
+    result = xio_stack_create(&config);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_XIO_HANDLE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(char_ptr, "test.host", g_tls_hostname);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)TEST_HTTP_PROXY_IO_INTERFACE, (void*)g_tls_underlying_interface);
+    ASSERT_ARE_EQUAL(char_ptr, "test.host", g_bottom_hostname);
+    ASSERT_ARE_EQUAL(char_ptr, "proxy.host", g_proxy_hostname);
+    ASSERT_ARE_EQUAL(int, 8888, g_proxy_port);
+}
+
+/* Tests_SRS_XIO_STACK_01_005: [ If ws_resource_name is not NULL a WebSocket IO for ws_resource_name and ws_protocol shall be stacked on the layer below. ]*/
+/* Tests_SRS_XIO_STACK_01_009: [ The options shall be set on the top layer, which passes the ones it does not handle to the layers below. ]*/
+/* Tests_SRS_XIO_STACK_01_011: [ For a TLS IO under the WebSocket IO, xio_stack_create shall set OPTION_TLS_READ_CHUNK_SIZE to 16384 and OPTION_TLS_COALESCE_RECEIVED_BYTES to true. ]*/
+TEST_FUNCTION(xio_stack_create_creates_a_ws_io_over_a_tls_io_and_tunes_the_tls_io)
+{
+    // arrange
+    XIO_HANDLE result;
+    XIO_STACK_CONFIG config = make_config();
+    config.tlsio_interface = TEST_TLSIO_INTERFACE;
+    config.ws_resource_name = "/ws";
+    config.ws_protocol = "test_protocol";
+
+    STRICT_EXPECTED_CALL(socketio_get_interface_description());
+    STRICT_EXPECTED_CALL(wsio_get_interface_description());
+    STRICT_EXPECTED_CALL(xio_create(TEST_WSIO_INTERFACE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_XIO_HANDLE, OPTION_SOCKETIO_SHARED_RECEIVE_BUFFER, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_XIO_HANDLE, OPTION_TLS_READ_CHUNK_SIZE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_XIO_HANDLE, OPTION_TLS_COALESCE_RECEIVED_BYTES, IGNORED_PTR_ARG));
+
+    // act
+    result = xio_stack_create(&config);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_XIO_HANDLE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(char_ptr, "/ws", g_ws_resource_name);
+    ASSERT_ARE_EQUAL(char_ptr, "test_protocol", g_ws_protocol);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)TEST_TLSIO_INTERFACE, (void*)g_ws_underlying_interface);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)TEST_SOCKETIO_INTERFACE, (void*)g_tls_underlying_interface);
+    ASSERT_ARE_EQUAL(size_t, 16384, g_read_chunk_size);
+}
+
+/* Tests_SRS_XIO_STACK_01_006: [ If getting the interface description of a layer fails, xio_stack_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_getting_the_ws_interface_description_fails_xio_stack_create_fails)
+{
+    // arrange
+    XIO_HANDLE result;
+    XIO_STACK_CONFIG config = make_config();
+    config.ws_resource_name = "/ws";
+    config.ws_protocol = "test_protocol";
+
+    STRICT_EXPECTED_CALL(socketio_get_interface_description());
+    STRICT_EXPECTED_CALL(wsio_get_interface_description())
+        .SetReturn(NULL);
+
+    // act
+    result = xio_stack_create(&config);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_STACK_01_008: [ If xio_create fails, xio_stack_create shall fail and return NULL. ]*/
+TEST_FUNCTION(when_xio_create_fails_xio_stack_create_fails)
+{
+    // arrange
+    XIO_HANDLE result;
+    XIO_STACK_CONFIG config = make_config();
+
+    STRICT_EXPECTED_CALL(socketio_get_interface_description());
+    STRICT_EXPECTED_CALL(xio_create(TEST_SOCKETIO_INTERFACE, IGNORED_PTR_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = xio_stack_create(&config);
+
+    // assert
+    ASSERT_IS_NULL(result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_STACK_01_013: [ If setting one of these options fails, xio_stack_create shall carry on without it. ]*/
+TEST_FUNCTION(when_setting_an_option_fails_xio_stack_create_still_succeeds)
+{
+    // arrange
+    XIO_HANDLE result;
+    XIO_STACK_CONFIG config = make_config();
+    config.tlsio_interface = TEST_TLSIO_INTERFACE;
+    config.ws_resource_name = "/ws";
+    config.ws_protocol = "test_protocol";
+
+    STRICT_EXPECTED_CALL(socketio_get_interface_description());
+    STRICT_EXPECTED_CALL(wsio_get_interface_description());
+    STRICT_EXPECTED_CALL(xio_create(TEST_WSIO_INTERFACE, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_XIO_HANDLE, OPTION_SOCKETIO_SHARED_RECEIVE_BUFFER, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_XIO_HANDLE, OPTION_TLS_READ_CHUNK_SIZE, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(xio_setoption(TEST_XIO_HANDLE, OPTION_TLS_COALESCE_RECEIVED_BYTES, IGNORED_PTR_ARG));
+
+    // act
+    result = xio_stack_create(&config);
+
+    // assert
+    ASSERT_ARE_EQUAL(void_ptr, TEST_XIO_HANDLE, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+END_TEST_SUITE(xio_stack_unittests)
@@ -0,0 +1,692 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ctime>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void* my_gballoc_calloc(size_t nmemb, size_t size)
+{
+    return calloc(nmemb, size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#include "macro_utils.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/agenttime.h"
+#include "azure_c_shared_utility/gb_rand.h"
+#include "azure_c_shared_utility/lock.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/xio_trace_otel.h"
+
+IMPLEMENT_UMOCK_C_ENUM_TYPE(LOCK_RESULT, LOCK_RESULT_VALUES);
+
+static const LOCK_HANDLE TEST_LOCK_HANDLE = (LOCK_HANDLE)0x4242;
+static const char* TEST_LAYER_NAME = "test_layer";
+static const char* TEST_OPERATION = "send";
+
+/* 1000 s of UNIX time when the monotonic clock reads 2 s: the epoch offset is 998 s */
+#define TEST_UNIX_TIME 1000
+#define TEST_MONOTONIC_TIME_US 2000000
+
+static void my_gb_rand_fill(void* buffer, size_t size)
+{
+    (void)memset(buffer, 0xAB, size);
+}
+
+static int my_tickcounter_get_monotonic_us(tickcounter_us_t* monotonic_us)
+{
+    *monotonic_us = TEST_MONOTONIC_TIME_US;
+    return 0;
+}
+
+/* the spans handed to test_on_span */
+#define TEST_MAX_SPANS 8
+
+static XIO_TRACE_OTEL_SPAN test_spans[TEST_MAX_SPANS];
+static size_t test_span_count;
+static void* test_on_span_context;
+
+static void test_on_span(void* context, const XIO_TRACE_OTEL_SPAN* span)
+{
+    ASSERT_IS_TRUE(test_span_count < TEST_MAX_SPANS);
+    test_on_span_context = context;
+    test_spans[test_span_count] = *span;
+    test_span_count++;
+}
+
+static XIO_TRACE_EVENT make_test_event(XIO_TRACE_EVENT_TYPE type, uint64_t span_id, uint64_t parent_span_id, uint64_t correlation_id, uint64_t time_us)
+{
+    XIO_TRACE_EVENT event;
+
+    (void)memset(&event, 0, sizeof(event));
+    event.type = type;
+    event.span.span_id = span_id;
+    event.span.parent_span_id = parent_span_id;
+    event.span.correlation_id = correlation_id;
+    event.layer_name = TEST_LAYER_NAME;
+    event.operation = TEST_OPERATION;
+    event.time_us = time_us;
+    event.size = (type == XIO_TRACE_EVENT_BEGIN) ? 42 : 0;
+
+    return event;
+}
+
+static XIO_TRACE_OTEL_SPAN make_test_span(void)
+{
+    XIO_TRACE_OTEL_SPAN span;
+
+    (void)memset(&span, 0, sizeof(span));
+    span.trace_id[0] = 0x01;
+    span.trace_id[15] = 0xFE;
+    span.span_id[7] = 0x02;
+    span.layer_name = TEST_LAYER_NAME;
+    span.operation = TEST_OPERATION;
+    span.start_time_unix_nano = 1000;
+    span.end_time_unix_nano = 2000;
+    span.size = 42;
+    span.result = 0;
+
+    return span;
+}
+
+static XIO_TRACE_OTEL_HANDLE create_test_otel(size_t max_open_spans)
+{
+    XIO_TRACE_OTEL_HANDLE result = xio_trace_otel_create(max_open_spans, test_on_span, (void*)0x4243);
+    ASSERT_IS_NOT_NULL(result);
+    umock_c_reset_all_calls();
+    return result;
+}
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+BEGIN_TEST_SUITE(xio_trace_otel_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result, "umock_c_init");
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_charptr_register_types");
+
+    REGISTER_UMOCK_ALIAS_TYPE(LOCK_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(time_t, int);
+    REGISTER_UMOCK_ALIAS_TYPE(time_t*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(tickcounter_us_t, uint64_t);
+    REGISTER_TYPE(LOCK_RESULT, LOCK_RESULT);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_calloc, my_gballoc_calloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    REGISTER_GLOBAL_MOCK_HOOK(gb_rand_fill, my_gb_rand_fill);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_monotonic_us, my_tickcounter_get_monotonic_us);
+
+    REGISTER_GLOBAL_MOCK_RETURN(get_time, (time_t)TEST_UNIX_TIME);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Init, TEST_LOCK_HANDLE);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock_Deinit, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Lock, LOCK_OK);
+    REGISTER_GLOBAL_MOCK_RETURN(Unlock, LOCK_OK);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    test_span_count = 0;
+    test_on_span_context = NULL;
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/* xio_trace_otel_create */
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_002: [ xio_trace_otel_create shall allocate a table of max_open_spans open spans rounded up to a power of 2, or of 1024 if max_open_spans is 0, all free. ]*/
+/* Tests_SRS_XIO_TRACE_OTEL_01_003: [ xio_trace_otel_create shall create a lock. ]*/
+/* Tests_SRS_XIO_TRACE_OTEL_01_004: [ xio_trace_otel_create shall draw the 8 bytes that start the trace ids with gb_rand_fill and read the offset of the monotonic clock to the UNIX epoch with get_time and tickcounter_get_monotonic_us. ]*/
+TEST_FUNCTION(xio_trace_otel_create_allocates_the_builder)
+{
+    // arrange
+    XIO_TRACE_OTEL_HANDLE otel;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_calloc(4, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(gb_rand_fill(IGNORED_PTR_ARG, 8));
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+
+    // act
+    otel = xio_trace_otel_create(3, test_on_span, NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(otel);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_trace_otel_destroy(otel);
+}
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_002: [ xio_trace_otel_create shall allocate a table of max_open_spans open spans rounded up to a power of 2, or of 1024 if max_open_spans is 0, all free. ]*/
+TEST_FUNCTION(xio_trace_otel_create_with_0_allocates_1024_open_spans)
+{
+    // arrange
+    XIO_TRACE_OTEL_HANDLE otel;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_calloc(1024, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init());
+    STRICT_EXPECTED_CALL(gb_rand_fill(IGNORED_PTR_ARG, 8));
+    STRICT_EXPECTED_CALL(get_time(NULL));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+
+    // act
+    otel = xio_trace_otel_create(0, test_on_span, NULL);
+
+    // assert
+    ASSERT_IS_NOT_NULL(otel);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_trace_otel_destroy(otel);
+}
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_001: [ If on_span is NULL or max_open_spans is too large for the table to be allocated, xio_trace_otel_create shall fail and return NULL. ]*/
+TEST_FUNCTION(xio_trace_otel_create_with_NULL_on_span_fails)
+{
+    // arrange
+    XIO_TRACE_OTEL_HANDLE otel;
+
+    // act
+    otel = xio_trace_otel_create(16, NULL, NULL);
+
+    // assert
+    ASSERT_IS_NULL(otel);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_001: [ If on_span is NULL or max_open_spans is too large for the table to be allocated, xio_trace_otel_create shall fail and return NULL. ]*/
+TEST_FUNCTION(xio_trace_otel_create_with_a_huge_max_open_spans_fails)
+{
+    // arrange
+    XIO_TRACE_OTEL_HANDLE otel;
+
+    // act
+    otel = xio_trace_otel_create(((size_t)~(size_t)0) / 2, test_on_span, NULL);
+
+    // assert
+    ASSERT_IS_NULL(otel);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_005: [ If any failure occurs, xio_trace_otel_create shall free what it allocated and return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_builder_fails_xio_trace_otel_create_fails)
+{
+    // arrange
+    XIO_TRACE_OTEL_HANDLE otel;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    otel = xio_trace_otel_create(16, test_on_span, NULL);
+
+    // assert
+    ASSERT_IS_NULL(otel);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_005: [ If any failure occurs, xio_trace_otel_create shall free what it allocated and return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_table_fails_xio_trace_otel_create_fails)
+{
+    // arrange
+    XIO_TRACE_OTEL_HANDLE otel;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_calloc(16, IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    otel = xio_trace_otel_create(16, test_on_span, NULL);
+
+    // assert
+    ASSERT_IS_NULL(otel);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_005: [ If any failure occurs, xio_trace_otel_create shall free what it allocated and return NULL. ]*/
+TEST_FUNCTION(when_Lock_Init_fails_xio_trace_otel_create_fails)
+{
+    // arrange
+    XIO_TRACE_OTEL_HANDLE otel;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_calloc(16, IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(Lock_Init())
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    otel = xio_trace_otel_create(16, test_on_span, NULL);
+
+    // assert
+    ASSERT_IS_NULL(otel);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* xio_trace_otel_destroy */
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_007: [ xio_trace_otel_destroy shall free the lock, the table of open spans and the builder. ]*/
+TEST_FUNCTION(xio_trace_otel_destroy_frees_the_builder)
+{
+    // arrange
+    XIO_TRACE_OTEL_HANDLE otel = create_test_otel(16);
+    STRICT_EXPECTED_CALL(Lock_Deinit(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(otel));
+
+    // act
+    xio_trace_otel_destroy(otel);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_006: [ If otel is NULL, xio_trace_otel_destroy shall return. ]*/
+TEST_FUNCTION(xio_trace_otel_destroy_with_NULL_returns)
+{
+    // arrange
+
+    // act
+    xio_trace_otel_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* xio_trace_otel_sink */
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_009: [ xio_trace_otel_sink shall add event to the builder while holding its lock. ]*/
+/* Tests_SRS_XIO_TRACE_OTEL_01_015: [ A begin event shall be kept in the entry of the table of open spans given by its span_id. ]*/
+TEST_FUNCTION(xio_trace_otel_sink_keeps_a_begin_event_open)
+{
+    // arrange
+    XIO_TRACE_OTEL_HANDLE otel = create_test_otel(16);
+    XIO_TRACE_EVENT begin = make_test_event(XIO_TRACE_EVENT_BEGIN, 1, 0, 1, TEST_MONOTONIC_TIME_US);
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    xio_trace_otel_sink(otel, &begin);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, test_span_count);
+    ASSERT_ARE_EQUAL(uint64_t, 0, xio_trace_otel_get_dropped_count(otel));
+
+    // cleanup
+    xio_trace_otel_destroy(otel);
+}
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_017: [ An end event shall finish the open span of the same span_id and free its entry. ]*/
+/* Tests_SRS_XIO_TRACE_OTEL_01_018: [ The trace id of a span shall be the 8 random bytes drawn by xio_trace_otel_create followed by the correlation_id, big endian; its span id and parent span id shall be the span_id and parent_span_id, big endian. ]*/
+/* Tests_SRS_XIO_TRACE_OTEL_01_019: [ The layer name, operation and size of a span shall be the ones of its begin event, its result the one of its end event, and its start and end times the times of its events moved to the UNIX epoch, in nanoseconds. ]*/
+/* Tests_SRS_XIO_TRACE_OTEL_01_020: [ Each finished span shall be given to on_span, with on_span_context, without holding the lock. ]*/
+TEST_FUNCTION(xio_trace_otel_sink_finishes_the_span_with_its_end_event)
+{
+    // arrange
+    XIO_TRACE_OTEL_HANDLE otel = create_test_otel(16);
+    XIO_TRACE_EVENT begin = make_test_event(XIO_TRACE_EVENT_BEGIN, 0x0102, 0x0101, 0x0101, TEST_MONOTONIC_TIME_US);
+    XIO_TRACE_EVENT end = make_test_event(XIO_TRACE_EVENT_END, 0x0102, 0x0101, 0x0101, TEST_MONOTONIC_TIME_US + 5);
+    size_t i;
+    end.result = 3;
+    xio_trace_otel_sink(otel, &begin);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    xio_trace_otel_sink(otel, &end);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, test_span_count);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x4243, test_on_span_context);
+    for (i = 0; i < 8; i++)
+    {
+        ASSERT_ARE_EQUAL(uint8_t, 0xAB, test_spans[0].trace_id[i]);
+    }
+    for (i = 8; i < 14; i++)
+    {
+        ASSERT_ARE_EQUAL(uint8_t, 0, test_spans[0].trace_id[i]);
+    }
+    ASSERT_ARE_EQUAL(uint8_t, 0x01, test_spans[0].trace_id[14]);
+    ASSERT_ARE_EQUAL(uint8_t, 0x01, test_spans[0].trace_id[15]);
+    ASSERT_ARE_EQUAL(uint8_t, 0x01, test_spans[0].span_id[6]);
+    ASSERT_ARE_EQUAL(uint8_t, 0x02, test_spans[0].span_id[7]);
+    ASSERT_ARE_EQUAL(uint8_t, 0x01, test_spans[0].parent_span_id[6]);
+    ASSERT_ARE_EQUAL(uint8_t, 0x01, test_spans[0].parent_span_id[7]);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_LAYER_NAME, test_spans[0].layer_name);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_OPERATION, test_spans[0].operation);
+    ASSERT_ARE_EQUAL(uint64_t, (uint64_t)TEST_UNIX_TIME * 1000000000, test_spans[0].start_time_unix_nano);
+    ASSERT_ARE_EQUAL(uint64_t, ((uint64_t)TEST_UNIX_TIME * 1000000000) + 5000, test_spans[0].end_time_unix_nano);
+    ASSERT_ARE_EQUAL(uint64_t, 42, test_spans[0].size);
+    ASSERT_ARE_EQUAL(int, 3, test_spans[0].result);
+
+    // cleanup
+    xio_trace_otel_destroy(otel);
+}
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_008: [ If context or event is NULL, xio_trace_otel_sink shall return. ]*/
+TEST_FUNCTION(xio_trace_otel_sink_with_NULL_arguments_returns)
+{
+    // arrange
+    XIO_TRACE_OTEL_HANDLE otel = create_test_otel(16);
+    XIO_TRACE_EVENT begin = make_test_event(XIO_TRACE_EVENT_BEGIN, 1, 0, 1, TEST_MONOTONIC_TIME_US);
+
+    // act
+    xio_trace_otel_sink(NULL, &begin);
+    xio_trace_otel_sink(otel, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_trace_otel_destroy(otel);
+}
+
+/* Span building */
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_013: [ Events of a span that is not traced (span_id 0) shall be dropped and counted. ]*/
+TEST_FUNCTION(events_of_an_untraced_span_are_dropped)
+{
+    // arrange
+    XIO_TRACE_OTEL_HANDLE otel = create_test_otel(16);
+    XIO_TRACE_EVENT begin = make_test_event(XIO_TRACE_EVENT_BEGIN, 0, 0, 0, TEST_MONOTONIC_TIME_US);
+
+    // act
+    xio_trace_otel_sink(otel, &begin);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, 1, xio_trace_otel_get_dropped_count(otel));
+
+    // cleanup
+    xio_trace_otel_destroy(otel);
+}
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_014: [ If the entry of the table of open spans for the span_id of a begin event is taken by a span that is still open, the event shall be dropped and counted. ]*/
+TEST_FUNCTION(a_begin_event_whose_entry_is_taken_is_dropped)
+{
+    // arrange
+    XIO_TRACE_OTEL_HANDLE otel = create_test_otel(2);
+    XIO_TRACE_EVENT begin_1 = make_test_event(XIO_TRACE_EVENT_BEGIN, 1, 0, 1, TEST_MONOTONIC_TIME_US);
+    XIO_TRACE_EVENT begin_3 = make_test_event(XIO_TRACE_EVENT_BEGIN, 3, 0, 3, TEST_MONOTONIC_TIME_US);
+    XIO_TRACE_EVENT end_3 = make_test_event(XIO_TRACE_EVENT_END, 3, 0, 3, TEST_MONOTONIC_TIME_US);
+    XIO_TRACE_EVENT end_1 = make_test_event(XIO_TRACE_EVENT_END, 1, 0, 1, TEST_MONOTONIC_TIME_US);
+    xio_trace_otel_sink(otel, &begin_1);
+
+    // act
+    xio_trace_otel_sink(otel, &begin_3);
+    xio_trace_otel_sink(otel, &end_3);
+    xio_trace_otel_sink(otel, &end_1);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, 2, xio_trace_otel_get_dropped_count(otel));
+    ASSERT_ARE_EQUAL(size_t, 1, test_span_count);
+    ASSERT_ARE_EQUAL(uint8_t, 1, test_spans[0].span_id[7]);
+
+    // cleanup
+    xio_trace_otel_destroy(otel);
+}
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_016: [ An end event whose span is not open shall be dropped and counted. ]*/
+TEST_FUNCTION(an_end_event_without_begin_is_dropped)
+{
+    // arrange
+    XIO_TRACE_OTEL_HANDLE otel = create_test_otel(16);
+    XIO_TRACE_EVENT end = make_test_event(XIO_TRACE_EVENT_END, 1, 0, 1, TEST_MONOTONIC_TIME_US);
+
+    // act
+    xio_trace_otel_sink(otel, &end);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, test_span_count);
+    ASSERT_ARE_EQUAL(uint64_t, 1, xio_trace_otel_get_dropped_count(otel));
+
+    // cleanup
+    xio_trace_otel_destroy(otel);
+}
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_017: [ An end event shall finish the open span of the same span_id and free its entry. ]*/
+TEST_FUNCTION(a_finished_span_frees_its_entry)
+{
+    // arrange
+    XIO_TRACE_OTEL_HANDLE otel = create_test_otel(2);
+    XIO_TRACE_EVENT begin_1 = make_test_event(XIO_TRACE_EVENT_BEGIN, 1, 0, 1, TEST_MONOTONIC_TIME_US);
+    XIO_TRACE_EVENT end_1 = make_test_event(XIO_TRACE_EVENT_END, 1, 0, 1, TEST_MONOTONIC_TIME_US);
+    XIO_TRACE_EVENT begin_3 = make_test_event(XIO_TRACE_EVENT_BEGIN, 3, 0, 3, TEST_MONOTONIC_TIME_US);
+    XIO_TRACE_EVENT end_3 = make_test_event(XIO_TRACE_EVENT_END, 3, 0, 3, TEST_MONOTONIC_TIME_US);
+    xio_trace_otel_sink(otel, &begin_1);
+    xio_trace_otel_sink(otel, &end_1);
+
+    // act
+    xio_trace_otel_sink(otel, &begin_3);
+    xio_trace_otel_sink(otel, &end_3);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 2, test_span_count);
+    ASSERT_ARE_EQUAL(uint64_t, 0, xio_trace_otel_get_dropped_count(otel));
+
+    // cleanup
+    xio_trace_otel_destroy(otel);
+}
+
+/* xio_trace_otel_add_events */
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_011: [ xio_trace_otel_add_events shall add the events in order, each while holding the lock, and return 0. ]*/
+TEST_FUNCTION(xio_trace_otel_add_events_adds_the_events_in_order)
+{
+    // arrange
+    XIO_TRACE_OTEL_HANDLE otel = create_test_otel(16);
+    XIO_TRACE_EVENT events[4];
+    int result;
+    events[0] = make_test_event(XIO_TRACE_EVENT_BEGIN, 1, 0, 1, TEST_MONOTONIC_TIME_US);
+    events[1] = make_test_event(XIO_TRACE_EVENT_BEGIN, 2, 1, 1, TEST_MONOTONIC_TIME_US);
+    events[2] = make_test_event(XIO_TRACE_EVENT_END, 2, 1, 1, TEST_MONOTONIC_TIME_US);
+    events[3] = make_test_event(XIO_TRACE_EVENT_END, 1, 0, 1, TEST_MONOTONIC_TIME_US);
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Lock(TEST_LOCK_HANDLE));
+    STRICT_EXPECTED_CALL(Unlock(TEST_LOCK_HANDLE));
+
+    // act
+    result = xio_trace_otel_add_events(otel, events, 4);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 2, test_span_count);
+    ASSERT_ARE_EQUAL(uint8_t, 2, test_spans[0].span_id[7]);
+    ASSERT_ARE_EQUAL(uint8_t, 1, test_spans[0].parent_span_id[7]);
+    ASSERT_ARE_EQUAL(uint8_t, 1, test_spans[1].span_id[7]);
+    ASSERT_ARE_EQUAL(uint8_t, 0, test_spans[1].parent_span_id[7]);
+
+    // cleanup
+    xio_trace_otel_destroy(otel);
+}
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_010: [ If otel is NULL, or events is NULL while event_count is not 0, xio_trace_otel_add_events shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_trace_otel_add_events_with_invalid_arguments_fails)
+{
+    // arrange
+    XIO_TRACE_OTEL_HANDLE otel = create_test_otel(16);
+    XIO_TRACE_EVENT events[1];
+    events[0] = make_test_event(XIO_TRACE_EVENT_BEGIN, 1, 0, 1, TEST_MONOTONIC_TIME_US);
+
+    // act
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, xio_trace_otel_add_events(NULL, events, 1));
+    ASSERT_ARE_NOT_EQUAL(int, 0, xio_trace_otel_add_events(otel, NULL, 1));
+    ASSERT_ARE_EQUAL(int, 0, xio_trace_otel_add_events(otel, NULL, 0));
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_trace_otel_destroy(otel);
+}
+
+/* xio_trace_otel_get_dropped_count */
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_012: [ If otel is NULL, xio_trace_otel_get_dropped_count shall return 0. ]*/
+TEST_FUNCTION(xio_trace_otel_get_dropped_count_with_NULL_returns_0)
+{
+    // arrange
+
+    // act
+    uint64_t result = xio_trace_otel_get_dropped_count(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, 0, result);
+}
+
+/* xio_trace_otel_format_span */
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_023: [ xio_trace_otel_format_span shall write span as an OTLP/JSON Span object: the ids in lower case hex (an empty parentSpanId for the outermost span), the name made of the layer name and the operation, the kind SPAN_KIND_INTERNAL, the times as decimal strings, the layer name, operation, size and result as xio.* attributes, and a status code of STATUS_CODE_OK when result is 0, STATUS_CODE_ERROR otherwise. ]*/
+/* Tests_SRS_XIO_TRACE_OTEL_01_026: [ On success xio_trace_otel_format_span shall set written to the length of the object, without the '\0', and return 0. ]*/
+TEST_FUNCTION(xio_trace_otel_format_span_writes_an_otlp_json_span)
+{
+    // arrange
+    XIO_TRACE_OTEL_SPAN span = make_test_span();
+    char buffer[1024];
+    size_t written;
+    int result;
+    static const char* expected =
+        "{\"traceId\":\"010000000000000000000000000000fe\",\"spanId\":\"0000000000000002\",\"parentSpanId\":\"\",\"name\":\"test_layer send\",\"kind\":1,"
+        "\"startTimeUnixNano\":\"1000\",\"endTimeUnixNano\":\"2000\","
+        "\"attributes\":[{\"key\":\"xio.layer\",\"value\":{\"stringValue\":\"test_layer\"}},"
+        "{\"key\":\"xio.operation\",\"value\":{\"stringValue\":\"send\"}},"
+        "{\"key\":\"xio.size\",\"value\":{\"intValue\":\"42\"}},"
+        "{\"key\":\"xio.result\",\"value\":{\"intValue\":\"0\"}}],"
+        "\"status\":{\"code\":1}}";
+
+    // act
+    result = xio_trace_otel_format_span(&span, buffer, sizeof(buffer), &written);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, expected, buffer);
+    ASSERT_ARE_EQUAL(size_t, strlen(expected), written);
+}
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_023: [ xio_trace_otel_format_span shall write span as an OTLP/JSON Span object: the ids in lower case hex (an empty parentSpanId for the outermost span), the name made of the layer name and the operation, the kind SPAN_KIND_INTERNAL, the times as decimal strings, the layer name, operation, size and result as xio.* attributes, and a status code of STATUS_CODE_OK when result is 0, STATUS_CODE_ERROR otherwise. ]*/
+TEST_FUNCTION(xio_trace_otel_format_span_of_a_failed_child_span)
+{
+    // arrange
+    XIO_TRACE_OTEL_SPAN span = make_test_span();
+    char buffer[1024];
+    size_t written;
+    int result;
+    span.parent_span_id[7] = 0x1F;
+    span.result = 2;
+
+    // act
+    result = xio_trace_otel_format_span(&span, buffer, sizeof(buffer), &written);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_NOT_NULL(strstr(buffer, "\"parentSpanId\":\"000000000000001f\""));
+    ASSERT_IS_NOT_NULL(strstr(buffer, "{\"key\":\"xio.result\",\"value\":{\"intValue\":\"2\"}}"));
+    ASSERT_IS_NOT_NULL(strstr(buffer, "\"status\":{\"code\":2}}"));
+}
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_024: [ If buffer_size cannot hold the object and its '\0', xio_trace_otel_format_span shall set written to the length of the object and fail with a non-zero value. ]*/
+TEST_FUNCTION(xio_trace_otel_format_span_with_a_small_buffer_fails_and_gives_the_length)
+{
+    // arrange
+    XIO_TRACE_OTEL_SPAN span = make_test_span();
+    char buffer[1024];
+    char small_buffer[16];
+    size_t written;
+    size_t needed;
+    int result;
+    ASSERT_ARE_EQUAL(int, 0, xio_trace_otel_format_span(&span, buffer, sizeof(buffer), &needed));
+
+    // act
+    result = xio_trace_otel_format_span(&span, small_buffer, sizeof(small_buffer), &written);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, needed, written);
+    ASSERT_ARE_NOT_EQUAL(int, 0, xio_trace_otel_format_span(&span, NULL, 0, &written));
+    ASSERT_ARE_EQUAL(size_t, needed, written);
+}
+
+/* Tests_SRS_XIO_TRACE_OTEL_01_022: [ If span or written is NULL, or buffer is NULL while buffer_size is not 0, xio_trace_otel_format_span shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_trace_otel_format_span_with_invalid_arguments_fails)
+{
+    // arrange
+    XIO_TRACE_OTEL_SPAN span = make_test_span();
+    char buffer[16];
+    size_t written;
+
+    // act
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, xio_trace_otel_format_span(NULL, buffer, sizeof(buffer), &written));
+    ASSERT_ARE_NOT_EQUAL(int, 0, xio_trace_otel_format_span(&span, buffer, sizeof(buffer), NULL));
+    ASSERT_ARE_NOT_EQUAL(int, 0, xio_trace_otel_format_span(&span, NULL, sizeof(buffer), &written));
+}
+
+END_TEST_SUITE(xio_trace_otel_unittests)
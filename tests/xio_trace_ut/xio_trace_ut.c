@@ -0,0 +1,773 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#endif
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* s)
+{
+    free(s);
+}
+
+#include "macro_utils.h"
+#include "testrunnerswitcher.h"
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/xio_trace.h"
+
+static const char* TEST_LAYER_NAME = "test_layer";
+static const char* TEST_OPERATION = "send";
+
+static tickcounter_us_t test_now_us;
+
+static int my_tickcounter_get_monotonic_us(tickcounter_us_t* monotonic_us)
+{
+    *monotonic_us = test_now_us;
+    return 0;
+}
+
+/* the events handed to test_sink */
+#define TEST_MAX_EVENTS 16
+
+static XIO_TRACE_EVENT test_events[TEST_MAX_EVENTS];
+static size_t test_event_count;
+static void* test_sink_context;
+
+static void test_sink(void* context, const XIO_TRACE_EVENT* event)
+{
+    ASSERT_IS_TRUE(test_event_count < TEST_MAX_EVENTS);
+    test_sink_context = context;
+    test_events[test_event_count] = *event;
+    test_event_count++;
+}
+
+static XIO_TRACE_EVENT make_test_event(uint64_t span_id)
+{
+    XIO_TRACE_EVENT event;
+
+    (void)memset(&event, 0, sizeof(event));
+    event.type = XIO_TRACE_EVENT_BEGIN;
+    event.span.span_id = span_id;
+    event.span.correlation_id = span_id;
+    event.layer_name = TEST_LAYER_NAME;
+    event.operation = TEST_OPERATION;
+    event.size = 42;
+
+    return event;
+}
+
+static TEST_MUTEX_HANDLE test_serialize_mutex;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+BEGIN_TEST_SUITE(xio_trace_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    test_serialize_mutex = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(test_serialize_mutex);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result, "umock_c_init");
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_charptr_register_types");
+
+    REGISTER_UMOCK_ALIAS_TYPE(tickcounter_us_t, uint64_t);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_monotonic_us, my_tickcounter_get_monotonic_us);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(test_serialize_mutex);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(test_serialize_mutex))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    test_now_us = 1000;
+    test_event_count = 0;
+    test_sink_context = NULL;
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    XIO_TRACE_SPAN no_span;
+
+    (void)xio_trace_set_sink(NULL, NULL);
+    no_span.span_id = 0;
+    xio_trace_leave(no_span);
+
+    TEST_MUTEX_RELEASE(test_serialize_mutex);
+}
+
+/* xio_trace_set_sink */
+
+/* Tests_SRS_XIO_TRACE_01_002: [ Otherwise xio_trace_set_sink shall keep sink and sink_context, start tracing and return 0. ]*/
+TEST_FUNCTION(xio_trace_set_sink_starts_tracing)
+{
+    // arrange
+    int result;
+
+    // act
+    result = xio_trace_set_sink(test_sink, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_NOT_EQUAL(long, 0, (long)xio_trace_enabled);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_TRACE_01_001: [ If sink is NULL, xio_trace_set_sink shall stop tracing, so that the hooks make no event anymore, and return 0. ]*/
+TEST_FUNCTION(xio_trace_set_sink_with_NULL_stops_tracing)
+{
+    // arrange
+    int result;
+    XIO_TRACE_SPAN span;
+    (void)xio_trace_set_sink(test_sink, NULL);
+
+    // act
+    result = xio_trace_set_sink(NULL, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(long, 0, (long)xio_trace_enabled);
+    xio_trace_begin(&span, TEST_LAYER_NAME, TEST_OPERATION, 1);
+    ASSERT_ARE_EQUAL(size_t, 0, test_event_count);
+}
+
+/* xio_trace_begin */
+
+/* Tests_SRS_XIO_TRACE_01_004: [ If no sink is set, xio_trace_begin shall set the span_id of span to 0, so that the span is not traced, and return. ]*/
+TEST_FUNCTION(xio_trace_begin_without_sink_makes_the_span_untraced)
+{
+    // arrange
+    XIO_TRACE_SPAN span;
+    span.span_id = 42;
+
+    // act
+    xio_trace_begin(&span, TEST_LAYER_NAME, TEST_OPERATION, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, 0, span.span_id);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_TRACE_01_003: [ If span is NULL, xio_trace_begin shall return. ]*/
+TEST_FUNCTION(xio_trace_begin_with_NULL_span_does_nothing)
+{
+    // arrange
+    (void)xio_trace_set_sink(test_sink, NULL);
+
+    // act
+    xio_trace_begin(NULL, TEST_LAYER_NAME, TEST_OPERATION, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, test_event_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_TRACE_01_005: [ xio_trace_begin shall give span a new span_id from a process wide counter, which is never 0. ]*/
+/* Tests_SRS_XIO_TRACE_01_007: [ Otherwise span shall be the outermost span of a new message: its parent_span_id shall be 0 and its correlation_id its span_id. ]*/
+/* Tests_SRS_XIO_TRACE_01_008: [ xio_trace_begin shall call the sink with an XIO_TRACE_EVENT_BEGIN event carrying span, layer_name, operation, size and the time given by tickcounter_get_monotonic_us (0 if it fails). ]*/
+TEST_FUNCTION(xio_trace_begin_without_current_span_begins_a_new_message)
+{
+    // arrange
+    XIO_TRACE_SPAN span;
+    (void)xio_trace_set_sink(test_sink, (void*)0x4242);
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+
+    // act
+    xio_trace_begin(&span, TEST_LAYER_NAME, TEST_OPERATION, 42);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(uint64_t, 0, span.span_id);
+    ASSERT_ARE_EQUAL(uint64_t, 0, span.parent_span_id);
+    ASSERT_ARE_EQUAL(uint64_t, span.span_id, span.correlation_id);
+    ASSERT_ARE_EQUAL(size_t, 1, test_event_count);
+    ASSERT_ARE_EQUAL(void_ptr, (void*)0x4242, test_sink_context);
+    ASSERT_ARE_EQUAL(int, (int)XIO_TRACE_EVENT_BEGIN, (int)test_events[0].type);
+    ASSERT_ARE_EQUAL(uint64_t, span.span_id, test_events[0].span.span_id);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_LAYER_NAME, test_events[0].layer_name);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_OPERATION, test_events[0].operation);
+    ASSERT_ARE_EQUAL(uint64_t, 42, test_events[0].size);
+    ASSERT_ARE_EQUAL(uint64_t, 1000, test_events[0].time_us);
+}
+
+/* Tests_SRS_XIO_TRACE_01_005: [ xio_trace_begin shall give span a new span_id from a process wide counter, which is never 0. ]*/
+TEST_FUNCTION(xio_trace_begin_gives_each_span_a_new_span_id)
+{
+    // arrange
+    XIO_TRACE_SPAN span_1;
+    XIO_TRACE_SPAN span_2;
+    (void)xio_trace_set_sink(test_sink, NULL);
+
+    // act
+    xio_trace_begin(&span_1, TEST_LAYER_NAME, TEST_OPERATION, 1);
+    xio_trace_begin(&span_2, TEST_LAYER_NAME, TEST_OPERATION, 1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(uint64_t, span_1.span_id, span_2.span_id);
+    ASSERT_ARE_NOT_EQUAL(uint64_t, span_1.correlation_id, span_2.correlation_id);
+}
+
+/* Tests_SRS_XIO_TRACE_01_008: [ xio_trace_begin shall call the sink with an XIO_TRACE_EVENT_BEGIN event carrying span, layer_name, operation, size and the time given by tickcounter_get_monotonic_us (0 if it fails). ]*/
+TEST_FUNCTION(when_tickcounter_get_monotonic_us_fails_xio_trace_begin_makes_the_event_with_time_0)
+{
+    // arrange
+    XIO_TRACE_SPAN span;
+    (void)xio_trace_set_sink(test_sink, NULL);
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    xio_trace_begin(&span, TEST_LAYER_NAME, TEST_OPERATION, 1);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, test_event_count);
+    ASSERT_ARE_EQUAL(uint64_t, 0, test_events[0].time_us);
+}
+
+/* Tests_SRS_XIO_TRACE_01_006: [ If a span is current on the thread, xio_trace_begin shall make span its child: the parent_span_id of span shall be the span_id of the current span and its correlation_id the correlation_id of the current span. ]*/
+TEST_FUNCTION(xio_trace_begin_with_a_current_span_begins_a_child)
+{
+    // arrange
+    XIO_TRACE_SPAN parent;
+    XIO_TRACE_SPAN child;
+    XIO_TRACE_SPAN previous;
+    (void)xio_trace_set_sink(test_sink, NULL);
+    xio_trace_begin(&parent, TEST_LAYER_NAME, TEST_OPERATION, 1);
+    previous = xio_trace_enter(&parent);
+    umock_c_reset_all_calls();
+
+    // act
+    xio_trace_begin(&child, "child_layer", TEST_OPERATION, 1);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(uint64_t, parent.span_id, child.span_id);
+    ASSERT_ARE_EQUAL(uint64_t, parent.span_id, child.parent_span_id);
+    ASSERT_ARE_EQUAL(uint64_t, parent.correlation_id, child.correlation_id);
+    ASSERT_ARE_EQUAL(size_t, 2, test_event_count);
+    ASSERT_ARE_EQUAL(uint64_t, parent.span_id, test_events[1].span.parent_span_id);
+
+    // cleanup
+    xio_trace_leave(previous);
+}
+
+/* xio_trace_end */
+
+/* Tests_SRS_XIO_TRACE_01_010: [ xio_trace_end shall call the sink with an XIO_TRACE_EVENT_END event carrying span, layer_name, operation, result and the time given by tickcounter_get_monotonic_us (0 if it fails). ]*/
+TEST_FUNCTION(xio_trace_end_makes_the_end_event)
+{
+    // arrange
+    XIO_TRACE_SPAN span;
+    (void)xio_trace_set_sink(test_sink, NULL);
+    xio_trace_begin(&span, TEST_LAYER_NAME, TEST_OPERATION, 1);
+    test_now_us = 1500;
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+
+    // act
+    xio_trace_end(&span, TEST_LAYER_NAME, TEST_OPERATION, 2);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 2, test_event_count);
+    ASSERT_ARE_EQUAL(int, (int)XIO_TRACE_EVENT_END, (int)test_events[1].type);
+    ASSERT_ARE_EQUAL(uint64_t, span.span_id, test_events[1].span.span_id);
+    ASSERT_ARE_EQUAL(uint64_t, span.correlation_id, test_events[1].span.correlation_id);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_LAYER_NAME, test_events[1].layer_name);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_OPERATION, test_events[1].operation);
+    ASSERT_ARE_EQUAL(int, 2, test_events[1].result);
+    ASSERT_ARE_EQUAL(uint64_t, 1500, test_events[1].time_us);
+}
+
+/* Tests_SRS_XIO_TRACE_01_009: [ If span is NULL, is not traced or no sink is set, xio_trace_end shall return. ]*/
+TEST_FUNCTION(xio_trace_end_with_untraced_span_does_nothing)
+{
+    // arrange
+    XIO_TRACE_SPAN span;
+    (void)xio_trace_set_sink(test_sink, NULL);
+    span.span_id = 0;
+
+    // act
+    xio_trace_end(&span, TEST_LAYER_NAME, TEST_OPERATION, 0);
+    xio_trace_end(NULL, TEST_LAYER_NAME, TEST_OPERATION, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 0, test_event_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_TRACE_01_009: [ If span is NULL, is not traced or no sink is set, xio_trace_end shall return. ]*/
+TEST_FUNCTION(xio_trace_end_after_the_sink_was_removed_does_nothing)
+{
+    // arrange
+    XIO_TRACE_SPAN span;
+    (void)xio_trace_set_sink(test_sink, NULL);
+    xio_trace_begin(&span, TEST_LAYER_NAME, TEST_OPERATION, 1);
+    (void)xio_trace_set_sink(NULL, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    xio_trace_end(&span, TEST_LAYER_NAME, TEST_OPERATION, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, test_event_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* xio_trace_enter */
+
+/* Tests_SRS_XIO_TRACE_01_012: [ xio_trace_enter shall make span the current span of the thread. ]*/
+/* Tests_SRS_XIO_TRACE_01_013: [ xio_trace_enter shall return the span that was current on the thread, with a span_id of 0 if there was none. ]*/
+TEST_FUNCTION(xio_trace_enter_makes_the_span_current_and_returns_the_previous_one)
+{
+    // arrange
+    XIO_TRACE_SPAN outer;
+    XIO_TRACE_SPAN inner;
+    XIO_TRACE_SPAN previous_1;
+    XIO_TRACE_SPAN previous_2;
+    (void)xio_trace_set_sink(test_sink, NULL);
+    xio_trace_begin(&outer, TEST_LAYER_NAME, TEST_OPERATION, 1);
+    xio_trace_begin(&inner, TEST_LAYER_NAME, TEST_OPERATION, 1);
+
+    // act
+    previous_1 = xio_trace_enter(&outer);
+    previous_2 = xio_trace_enter(&inner);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, 0, previous_1.span_id);
+    ASSERT_ARE_EQUAL(uint64_t, outer.span_id, previous_2.span_id);
+
+    // cleanup
+    xio_trace_leave(previous_2);
+    xio_trace_leave(previous_1);
+}
+
+/* Tests_SRS_XIO_TRACE_01_011: [ If span is NULL, xio_trace_enter shall leave the current span of the thread alone. ]*/
+TEST_FUNCTION(xio_trace_enter_with_NULL_keeps_the_current_span)
+{
+    // arrange
+    XIO_TRACE_SPAN outer;
+    XIO_TRACE_SPAN previous;
+    XIO_TRACE_SPAN result;
+    (void)xio_trace_set_sink(test_sink, NULL);
+    xio_trace_begin(&outer, TEST_LAYER_NAME, TEST_OPERATION, 1);
+    previous = xio_trace_enter(&outer);
+
+    // act
+    result = xio_trace_enter(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, outer.span_id, result.span_id);
+    ASSERT_ARE_EQUAL(uint64_t, outer.span_id, xio_trace_enter(NULL).span_id);
+
+    // cleanup
+    xio_trace_leave(previous);
+}
+
+/* xio_trace_leave */
+
+/* Tests_SRS_XIO_TRACE_01_014: [ xio_trace_leave shall make previous the current span of the thread. ]*/
+TEST_FUNCTION(xio_trace_leave_makes_the_previous_span_current_again)
+{
+    // arrange
+    XIO_TRACE_SPAN outer;
+    XIO_TRACE_SPAN previous;
+    XIO_TRACE_SPAN span;
+    (void)xio_trace_set_sink(test_sink, NULL);
+    xio_trace_begin(&outer, TEST_LAYER_NAME, TEST_OPERATION, 1);
+    previous = xio_trace_enter(&outer);
+
+    // act
+    xio_trace_leave(previous);
+
+    // assert
+    xio_trace_begin(&span, TEST_LAYER_NAME, TEST_OPERATION, 1);
+    ASSERT_ARE_EQUAL(uint64_t, 0, span.parent_span_id);
+    ASSERT_ARE_EQUAL(uint64_t, span.span_id, span.correlation_id);
+}
+
+/* XIO_TRACE_BEGIN */
+
+TEST_FUNCTION(XIO_TRACE_BEGIN_without_sink_makes_the_span_untraced)
+{
+    // arrange
+    XIO_TRACE_SPAN span;
+    span.span_id = 42;
+
+    // act
+    XIO_TRACE_BEGIN(&span, TEST_LAYER_NAME, TEST_OPERATION, 1);
+    XIO_TRACE_END(&span, TEST_LAYER_NAME, TEST_OPERATION, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, 0, span.span_id);
+    ASSERT_ARE_EQUAL(size_t, 0, test_event_count);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* xio_trace_ring_create */
+
+/* Tests_SRS_XIO_TRACE_01_016: [ xio_trace_ring_create shall allocate a ring of event_count events rounded up to a power of 2, or of 4096 events if event_count is 0. ]*/
+TEST_FUNCTION(xio_trace_ring_create_allocates_the_ring)
+{
+    // arrange
+    XIO_TRACE_RING_HANDLE ring;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+
+    // act
+    ring = xio_trace_ring_create(3);
+
+    // assert
+    ASSERT_IS_NOT_NULL(ring);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(uint64_t, 0, xio_trace_ring_get_dropped_count(ring));
+
+    // cleanup
+    xio_trace_ring_destroy(ring);
+}
+
+/* Tests_SRS_XIO_TRACE_01_016: [ xio_trace_ring_create shall allocate a ring of event_count events rounded up to a power of 2, or of 4096 events if event_count is 0. ]*/
+TEST_FUNCTION(xio_trace_ring_create_rounds_the_event_count_up_to_a_power_of_2)
+{
+    // arrange
+    XIO_TRACE_RING_HANDLE ring = xio_trace_ring_create(3);
+    XIO_TRACE_EVENT event = make_test_event(1);
+    size_t i;
+
+    // act
+    for (i = 0; i < 5; i++)
+    {
+        xio_trace_ring_sink(ring, &event);
+    }
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, 1, xio_trace_ring_get_dropped_count(ring));
+
+    // cleanup
+    xio_trace_ring_destroy(ring);
+}
+
+/* Tests_SRS_XIO_TRACE_01_016: [ xio_trace_ring_create shall allocate a ring of event_count events rounded up to a power of 2, or of 4096 events if event_count is 0. ]*/
+TEST_FUNCTION(xio_trace_ring_create_with_0_allocates_4096_events)
+{
+    // arrange
+    XIO_TRACE_RING_HANDLE ring = xio_trace_ring_create(0);
+    XIO_TRACE_EVENT event = make_test_event(1);
+    size_t i;
+
+    // act
+    for (i = 0; i < 4097; i++)
+    {
+        xio_trace_ring_sink(ring, &event);
+    }
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, 1, xio_trace_ring_get_dropped_count(ring));
+
+    // cleanup
+    xio_trace_ring_destroy(ring);
+}
+
+/* Tests_SRS_XIO_TRACE_01_015: [ If event_count is too large for the entries to be allocated, xio_trace_ring_create shall fail and return NULL. ]*/
+TEST_FUNCTION(xio_trace_ring_create_with_a_huge_event_count_fails)
+{
+    // arrange
+    XIO_TRACE_RING_HANDLE ring;
+
+    // act
+    ring = xio_trace_ring_create(((size_t)~(size_t)0) / 2);
+
+    // assert
+    ASSERT_IS_NULL(ring);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_TRACE_01_017: [ If any allocation fails, xio_trace_ring_create shall free what it allocated and return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_ring_fails_xio_trace_ring_create_fails)
+{
+    // arrange
+    XIO_TRACE_RING_HANDLE ring;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    ring = xio_trace_ring_create(16);
+
+    // assert
+    ASSERT_IS_NULL(ring);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_TRACE_01_017: [ If any allocation fails, xio_trace_ring_create shall free what it allocated and return NULL. ]*/
+TEST_FUNCTION(when_allocating_the_events_fails_xio_trace_ring_create_fails)
+{
+    // arrange
+    XIO_TRACE_RING_HANDLE ring;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    ring = xio_trace_ring_create(16);
+
+    // assert
+    ASSERT_IS_NULL(ring);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* xio_trace_ring_destroy */
+
+/* Tests_SRS_XIO_TRACE_01_019: [ xio_trace_ring_destroy shall free the events and the ring. ]*/
+TEST_FUNCTION(xio_trace_ring_destroy_frees_the_ring)
+{
+    // arrange
+    XIO_TRACE_RING_HANDLE ring = xio_trace_ring_create(16);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(ring));
+
+    // act
+    xio_trace_ring_destroy(ring);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_TRACE_01_018: [ If ring is NULL, xio_trace_ring_destroy shall return. ]*/
+TEST_FUNCTION(xio_trace_ring_destroy_with_NULL_returns)
+{
+    // arrange
+
+    // act
+    xio_trace_ring_destroy(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* xio_trace_ring_sink */
+
+/* Tests_SRS_XIO_TRACE_01_022: [ xio_trace_ring_sink shall claim the next entry of the ring with a compare-and-swap, without taking a lock. ]*/
+/* Tests_SRS_XIO_TRACE_01_024: [ xio_trace_ring_sink shall copy the event into the entry and publish it. ]*/
+/* Tests_SRS_XIO_TRACE_01_026: [ xio_trace_ring_read shall copy into events, oldest first, up to event_count events, stopping at the first entry that is not published yet, and free their entries. ]*/
+/* Tests_SRS_XIO_TRACE_01_027: [ xio_trace_ring_read shall set read_count to the number of events copied and return 0. ]*/
+TEST_FUNCTION(xio_trace_ring_sink_keeps_the_events_for_xio_trace_ring_read)
+{
+    // arrange
+    XIO_TRACE_RING_HANDLE ring = xio_trace_ring_create(4);
+    XIO_TRACE_EVENT event_1 = make_test_event(1);
+    XIO_TRACE_EVENT event_2 = make_test_event(2);
+    XIO_TRACE_EVENT events[4];
+    size_t read_count;
+    int result;
+    umock_c_reset_all_calls();
+
+    // act
+    xio_trace_ring_sink(ring, &event_1);
+    xio_trace_ring_sink(ring, &event_2);
+    result = xio_trace_ring_read(ring, events, 4, &read_count);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 2, read_count);
+    ASSERT_ARE_EQUAL(uint64_t, 1, events[0].span.span_id);
+    ASSERT_ARE_EQUAL(uint64_t, 2, events[1].span.span_id);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_LAYER_NAME, events[0].layer_name);
+    ASSERT_ARE_EQUAL(uint64_t, 42, events[0].size);
+
+    // cleanup
+    xio_trace_ring_destroy(ring);
+}
+
+/* Tests_SRS_XIO_TRACE_01_023: [ If the ring is full, xio_trace_ring_sink shall drop the event and count it. ]*/
+/* Tests_SRS_XIO_TRACE_01_029: [ xio_trace_ring_get_dropped_count shall return the number of events the ring dropped since it was created. ]*/
+TEST_FUNCTION(xio_trace_ring_sink_when_the_ring_is_full_drops_the_event)
+{
+    // arrange
+    XIO_TRACE_RING_HANDLE ring = xio_trace_ring_create(2);
+    XIO_TRACE_EVENT events[4];
+    size_t read_count;
+    XIO_TRACE_EVENT event_1 = make_test_event(1);
+    XIO_TRACE_EVENT event_2 = make_test_event(2);
+    XIO_TRACE_EVENT event_3 = make_test_event(3);
+    xio_trace_ring_sink(ring, &event_1);
+    xio_trace_ring_sink(ring, &event_2);
+
+    // act
+    xio_trace_ring_sink(ring, &event_3);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, 1, xio_trace_ring_get_dropped_count(ring));
+    ASSERT_ARE_EQUAL(int, 0, xio_trace_ring_read(ring, events, 4, &read_count));
+    ASSERT_ARE_EQUAL(size_t, 2, read_count);
+    ASSERT_ARE_EQUAL(uint64_t, 1, events[0].span.span_id);
+    ASSERT_ARE_EQUAL(uint64_t, 2, events[1].span.span_id);
+
+    // cleanup
+    xio_trace_ring_destroy(ring);
+}
+
+/* Tests_SRS_XIO_TRACE_01_026: [ xio_trace_ring_read shall copy into events, oldest first, up to event_count events, stopping at the first entry that is not published yet, and free their entries. ]*/
+TEST_FUNCTION(xio_trace_ring_read_frees_the_entries_it_reads)
+{
+    // arrange
+    XIO_TRACE_RING_HANDLE ring = xio_trace_ring_create(2);
+    XIO_TRACE_EVENT events[2];
+    size_t read_count;
+    size_t i;
+
+    // act
+    for (i = 1; i <= 7; i++)
+    {
+        XIO_TRACE_EVENT event = make_test_event(i);
+        xio_trace_ring_sink(ring, &event);
+        ASSERT_ARE_EQUAL(int, 0, xio_trace_ring_read(ring, events, 1, &read_count));
+        ASSERT_ARE_EQUAL(size_t, 1, read_count);
+        ASSERT_ARE_EQUAL(uint64_t, (uint64_t)i, events[0].span.span_id);
+    }
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, xio_trace_ring_read(ring, events, 2, &read_count));
+    ASSERT_ARE_EQUAL(size_t, 0, read_count);
+    ASSERT_ARE_EQUAL(uint64_t, 0, xio_trace_ring_get_dropped_count(ring));
+
+    // cleanup
+    xio_trace_ring_destroy(ring);
+}
+
+/* Tests_SRS_XIO_TRACE_01_021: [ If event is NULL, xio_trace_ring_sink shall count it as dropped. ]*/
+TEST_FUNCTION(xio_trace_ring_sink_with_NULL_event_counts_it_as_dropped)
+{
+    // arrange
+    XIO_TRACE_RING_HANDLE ring = xio_trace_ring_create(2);
+
+    // act
+    xio_trace_ring_sink(ring, NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, 1, xio_trace_ring_get_dropped_count(ring));
+
+    // cleanup
+    xio_trace_ring_destroy(ring);
+}
+
+/* Tests_SRS_XIO_TRACE_01_020: [ If context is NULL, xio_trace_ring_sink shall return. ]*/
+TEST_FUNCTION(xio_trace_ring_sink_with_NULL_context_returns)
+{
+    // arrange
+    XIO_TRACE_EVENT event = make_test_event(1);
+
+    // act
+    xio_trace_ring_sink(NULL, &event);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_TRACE_01_022: [ xio_trace_ring_sink shall claim the next entry of the ring with a compare-and-swap, without taking a lock. ]*/
+TEST_FUNCTION(the_ring_as_sink_keeps_the_begin_and_end_events)
+{
+    // arrange
+    XIO_TRACE_RING_HANDLE ring = xio_trace_ring_create(4);
+    XIO_TRACE_EVENT events[4];
+    size_t read_count;
+    XIO_TRACE_SPAN span;
+    (void)xio_trace_set_sink(xio_trace_ring_sink, ring);
+
+    // act
+    xio_trace_begin(&span, TEST_LAYER_NAME, TEST_OPERATION, 10);
+    xio_trace_end(&span, TEST_LAYER_NAME, TEST_OPERATION, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, xio_trace_ring_read(ring, events, 4, &read_count));
+    ASSERT_ARE_EQUAL(size_t, 2, read_count);
+    ASSERT_ARE_EQUAL(int, (int)XIO_TRACE_EVENT_BEGIN, (int)events[0].type);
+    ASSERT_ARE_EQUAL(int, (int)XIO_TRACE_EVENT_END, (int)events[1].type);
+    ASSERT_ARE_EQUAL(uint64_t, span.span_id, events[1].span.span_id);
+
+    // cleanup
+    (void)xio_trace_set_sink(NULL, NULL);
+    xio_trace_ring_destroy(ring);
+}
+
+/* xio_trace_ring_read */
+
+/* Tests_SRS_XIO_TRACE_01_025: [ If ring, events or read_count is NULL or event_count is 0, xio_trace_ring_read shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_trace_ring_read_with_invalid_arguments_fails)
+{
+    // arrange
+    XIO_TRACE_RING_HANDLE ring = xio_trace_ring_create(2);
+    XIO_TRACE_EVENT events[2];
+    size_t read_count;
+
+    // act
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, xio_trace_ring_read(NULL, events, 2, &read_count));
+    ASSERT_ARE_NOT_EQUAL(int, 0, xio_trace_ring_read(ring, NULL, 2, &read_count));
+    ASSERT_ARE_NOT_EQUAL(int, 0, xio_trace_ring_read(ring, events, 0, &read_count));
+    ASSERT_ARE_NOT_EQUAL(int, 0, xio_trace_ring_read(ring, events, 2, NULL));
+
+    // cleanup
+    xio_trace_ring_destroy(ring);
+}
+
+/* xio_trace_ring_get_dropped_count */
+
+/* Tests_SRS_XIO_TRACE_01_028: [ If ring is NULL, xio_trace_ring_get_dropped_count shall return 0. ]*/
+TEST_FUNCTION(xio_trace_ring_get_dropped_count_with_NULL_returns_0)
+{
+    // arrange
+
+    // act
+    uint64_t result = xio_trace_ring_get_dropped_count(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, 0, result);
+}
+
+END_TEST_SUITE(xio_trace_unittests)
@@ -0,0 +1,525 @@
+// Copyright (c) Microsoft. All rights reserved.
+// Licensed under the MIT license. See LICENSE file in the project root for full license information.
+
+#ifdef __cplusplus
+#include <cstdlib>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#else
+#include <stdlib.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#endif
+
+#include "testrunnerswitcher.h"
+
+static void* my_gballoc_malloc(size_t size)
+{
+    return malloc(size);
+}
+
+static void my_gballoc_free(void* ptr)
+{
+    free(ptr);
+}
+
+#include "umock_c.h"
+#include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
+
+#define ENABLE_MOCKS
+#include "azure_c_shared_utility/gballoc.h"
+#include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/constbuffer_array.h"
+#include "azure_c_shared_utility/tickcounter.h"
+#undef ENABLE_MOCKS
+
+#include "azure_c_shared_utility/xio.h"
+#include "azure_c_shared_utility/xio_trace.h"
+
+static CONCRETE_IO_HANDLE TEST_CONCRETE_IO_HANDLE = (CONCRETE_IO_HANDLE)0x4242;
+static CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = (CONSTBUFFER_ARRAY_HANDLE)0x4243;
+static void* TEST_CALLBACK_CONTEXT = (void*)0x4244;
+static const char* TEST_LAYER_NAME = "test_layer";
+
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
+
+/* the callback the concrete IO was given, and the span current on the thread while it was called */
+static ON_SEND_COMPLETE g_on_send_complete;
+static void* g_callback_context;
+static XIO_TRACE_SPAN g_span_during_send;
+/* when set, the concrete IO completes the send from within the call */
+static bool g_complete_in_call;
+
+static void capture_send(ON_SEND_COMPLETE on_send_complete, void* callback_context)
+{
+    g_on_send_complete = on_send_complete;
+    g_callback_context = callback_context;
+    g_span_during_send = xio_trace_enter(NULL);
+    if (g_complete_in_call)
+    {
+        on_send_complete(callback_context, IO_SEND_OK);
+    }
+}
+
+#define ENABLE_MOCKS
+MOCK_FUNCTION_WITH_CODE(, CONCRETE_IO_HANDLE, test_xio_create, void*, xio_create_parameters)
+MOCK_FUNCTION_END(TEST_CONCRETE_IO_HANDLE)
+MOCK_FUNCTION_WITH_CODE(, void, test_xio_destroy, CONCRETE_IO_HANDLE, handle)
+MOCK_FUNCTION_END()
+MOCK_FUNCTION_WITH_CODE(, int, test_xio_open, CONCRETE_IO_HANDLE, handle, ON_IO_OPEN_COMPLETE, on_io_open_complete, void*, on_io_open_complete_context, ON_BYTES_RECEIVED, on_bytes_received, void*, on_bytes_received_context, ON_IO_ERROR, on_io_error, void*, on_io_error_context)
+MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(, int, test_xio_close, CONCRETE_IO_HANDLE, handle, ON_IO_CLOSE_COMPLETE, on_io_close_complete, void*, callback_context)
+MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(, int, test_xio_send, CONCRETE_IO_HANDLE, handle, const void*, buffer, size_t, size, ON_SEND_COMPLETE, on_send_complete, void*, callback_context)
+    capture_send(on_send_complete, callback_context);
+MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(, void, test_xio_dowork, CONCRETE_IO_HANDLE, handle)
+MOCK_FUNCTION_END()
+MOCK_FUNCTION_WITH_CODE(, int, test_xio_setoption, CONCRETE_IO_HANDLE, handle, const char*, optionName, const void*, value)
+MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(, int, test_xio_sendv, CONCRETE_IO_HANDLE, handle, const XIO_BUFFER*, buffers, size_t, buffer_count, ON_SEND_COMPLETE, on_send_complete, void*, callback_context)
+    capture_send(on_send_complete, callback_context);
+MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(, int, test_xio_send_constbuffer_array, CONCRETE_IO_HANDLE, handle, CONSTBUFFER_ARRAY_HANDLE, constbuffer_array, ON_SEND_COMPLETE, on_send_complete, void*, callback_context)
+    capture_send(on_send_complete, callback_context);
+MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(, int, test_xio_get_stats, CONCRETE_IO_HANDLE, handle, XIO_STATS*, stats, size_t, stats_count, size_t*, layer_count)
+    (void)memset(stats, 0, sizeof(XIO_STATS));
+    stats->layer_name = TEST_LAYER_NAME;
+    *layer_count = 1;
+MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(, void, test_on_send_complete, void*, context, IO_SEND_RESULT, send_result)
+MOCK_FUNCTION_END()
+
+#include "azure_c_shared_utility/umock_c_prod.h"
+MOCKABLE_FUNCTION(, OPTIONHANDLER_HANDLE, test_xio_retrieveoptions, CONCRETE_IO_HANDLE, handle);
+#undef ENABLE_MOCKS
+
+static const IO_INTERFACE_DESCRIPTION test_io_description =
+{
+    test_xio_retrieveoptions,
+    test_xio_create,
+    test_xio_destroy,
+    test_xio_open,
+    test_xio_close,
+    test_xio_send,
+    test_xio_dowork,
+    test_xio_setoption
+};
+
+static const IO_INTERFACE_DESCRIPTION test_io_description_with_stats =
+{
+    test_xio_retrieveoptions,
+    test_xio_create,
+    test_xio_destroy,
+    test_xio_open,
+    test_xio_close,
+    test_xio_send,
+    test_xio_dowork,
+    test_xio_setoption,
+    test_xio_sendv,
+    test_xio_send_constbuffer_array,
+    test_xio_get_stats
+};
+
+static int my_tickcounter_get_monotonic_us(tickcounter_us_t* monotonic_us)
+{
+    *monotonic_us = 1000;
+    return 0;
+}
+
+static int my_constbuffer_array_get_all_buffers_size(CONSTBUFFER_ARRAY_HANDLE constbuffer_array_handle, uint32_t* all_buffers_size)
+{
+    (void)constbuffer_array_handle;
+    *all_buffers_size = 77;
+    return 0;
+}
+
+/* the events handed to test_sink */
+#define TEST_MAX_EVENTS 8
+
+static XIO_TRACE_EVENT test_events[TEST_MAX_EVENTS];
+static size_t test_event_count;
+
+static void test_sink(void* context, const XIO_TRACE_EVENT* event)
+{
+    (void)context;
+    ASSERT_IS_TRUE(test_event_count < TEST_MAX_EVENTS);
+    test_events[test_event_count] = *event;
+    test_event_count++;
+}
+
+static XIO_HANDLE create_test_xio(const IO_INTERFACE_DESCRIPTION* io_description)
+{
+    XIO_HANDLE result = xio_create(io_description, NULL);
+    ASSERT_IS_NOT_NULL(result);
+    umock_c_reset_all_calls();
+    return result;
+}
+
+static TEST_MUTEX_HANDLE g_testByTest;
+
+DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
+
+static void on_umock_c_error(UMOCK_C_ERROR_CODE error_code)
+{
+    ASSERT_FAIL("umock_c reported error :%s", ENUM_TO_STRING(UMOCK_C_ERROR_CODE, error_code));
+}
+
+BEGIN_TEST_SUITE(xio_traced_unittests)
+
+TEST_SUITE_INITIALIZE(suite_init)
+{
+    int result;
+
+    g_testByTest = TEST_MUTEX_CREATE();
+    ASSERT_IS_NOT_NULL(g_testByTest);
+
+    result = umock_c_init(on_umock_c_error);
+    ASSERT_ARE_EQUAL(int, 0, result, "umock_c_init");
+
+    result = umocktypes_charptr_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_charptr_register_types");
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result, "umocktypes_stdint_register_types");
+
+    REGISTER_UMOCK_ALIAS_TYPE(CONCRETE_IO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_SEND_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_CLOSE_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(const XIO_BUFFER*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(XIO_STATS*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(CONSTBUFFER_ARRAY_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(OPTIONHANDLER_HANDLE, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(uint32_t*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(tickcounter_us_t, uint64_t);
+    REGISTER_TYPE(IO_SEND_RESULT, IO_SEND_RESULT);
+
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_malloc, my_gballoc_malloc);
+    REGISTER_GLOBAL_MOCK_HOOK(gballoc_free, my_gballoc_free);
+    REGISTER_GLOBAL_MOCK_HOOK(tickcounter_get_monotonic_us, my_tickcounter_get_monotonic_us);
+    REGISTER_GLOBAL_MOCK_HOOK(constbuffer_array_get_all_buffers_size, my_constbuffer_array_get_all_buffers_size);
+}
+
+TEST_SUITE_CLEANUP(suite_cleanup)
+{
+    umock_c_deinit();
+
+    TEST_MUTEX_DESTROY(g_testByTest);
+}
+
+TEST_FUNCTION_INITIALIZE(method_init)
+{
+    if (TEST_MUTEX_ACQUIRE(g_testByTest))
+    {
+        ASSERT_FAIL("Could not acquire test serialization mutex.");
+    }
+
+    g_on_send_complete = NULL;
+    g_callback_context = NULL;
+    g_span_during_send.span_id = 0;
+    g_complete_in_call = false;
+    test_event_count = 0;
+    (void)xio_trace_set_sink(test_sink, NULL);
+
+    umock_c_reset_all_calls();
+}
+
+TEST_FUNCTION_CLEANUP(method_cleanup)
+{
+    (void)xio_trace_set_sink(NULL, NULL);
+
+    TEST_MUTEX_RELEASE(g_testByTest);
+}
+
+TEST_FUNCTION(xio_send_when_tracing_is_off_passes_the_callback_as_is)
+{
+    // arrange
+    XIO_HANDLE xio = create_test_xio(&test_io_description_with_stats);
+    unsigned char send_data[] = { 0x42 };
+    int result;
+    (void)xio_trace_set_sink(NULL, NULL);
+    STRICT_EXPECTED_CALL(test_xio_send(TEST_CONCRETE_IO_HANDLE, send_data, sizeof(send_data), test_on_send_complete, TEST_CALLBACK_CONTEXT));
+
+    // act
+    result = xio_send(xio, send_data, sizeof(send_data), test_on_send_complete, TEST_CALLBACK_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, test_event_count);
+
+    // cleanup
+    xio_destroy(xio);
+}
+
+/* Tests_SRS_XIO_01_064: [ When tracing is on, xio_send, xio_sendv and xio_send_constbuffer_array shall begin a span with the XIO_STATS layer_name of the concrete IO ("xio" if it keeps no counters), the name of the function without xio_ and the number of bytes sent. ]*/
+/* Tests_SRS_XIO_01_065: [ The span shall be the current span of the thread while the concrete IO is called, and the concrete IO shall be given a callback that ends it. ]*/
+TEST_FUNCTION(xio_send_when_tracing_begins_a_span_and_makes_it_current)
+{
+    // arrange
+    XIO_HANDLE xio = create_test_xio(&test_io_description_with_stats);
+    unsigned char send_data[] = { 0x42, 0x43 };
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_xio_get_stats(TEST_CONCRETE_IO_HANDLE, IGNORED_PTR_ARG, 1, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_xio_send(TEST_CONCRETE_IO_HANDLE, send_data, sizeof(send_data), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    result = xio_send(xio, send_data, sizeof(send_data), test_on_send_complete, TEST_CALLBACK_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 1, test_event_count);
+    ASSERT_ARE_EQUAL(int, (int)XIO_TRACE_EVENT_BEGIN, (int)test_events[0].type);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_LAYER_NAME, test_events[0].layer_name);
+    ASSERT_ARE_EQUAL(char_ptr, "send", test_events[0].operation);
+    ASSERT_ARE_EQUAL(uint64_t, 2, test_events[0].size);
+    ASSERT_ARE_EQUAL(uint64_t, test_events[0].span.span_id, g_span_during_send.span_id);
+    ASSERT_ARE_NOT_EQUAL(void_ptr, (void*)test_on_send_complete, (void*)g_on_send_complete);
+    ASSERT_ARE_EQUAL(uint64_t, 0, xio_trace_enter(NULL).span_id);
+
+    // cleanup
+    g_on_send_complete(g_callback_context, IO_SEND_OK);
+    xio_destroy(xio);
+}
+
+/* Tests_SRS_XIO_01_066: [ When a traced send completes, the span shall end with send_result, the memory of the traced send shall be freed and on_send_complete shall be called with send_result. ]*/
+TEST_FUNCTION(when_a_traced_send_completes_the_span_ends_and_on_send_complete_is_called)
+{
+    // arrange
+    XIO_HANDLE xio = create_test_xio(&test_io_description_with_stats);
+    unsigned char send_data[] = { 0x42 };
+    (void)xio_send(xio, send_data, sizeof(send_data), test_on_send_complete, TEST_CALLBACK_CONTEXT);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_send_complete(TEST_CALLBACK_CONTEXT, IO_SEND_CANCELLED));
+
+    // act
+    g_on_send_complete(g_callback_context, IO_SEND_CANCELLED);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 2, test_event_count);
+    ASSERT_ARE_EQUAL(int, (int)XIO_TRACE_EVENT_END, (int)test_events[1].type);
+    ASSERT_ARE_EQUAL(uint64_t, test_events[0].span.span_id, test_events[1].span.span_id);
+    ASSERT_ARE_EQUAL(char_ptr, TEST_LAYER_NAME, test_events[1].layer_name);
+    ASSERT_ARE_EQUAL(char_ptr, "send", test_events[1].operation);
+    ASSERT_ARE_EQUAL(int, (int)IO_SEND_CANCELLED, test_events[1].result);
+
+    // cleanup
+    xio_destroy(xio);
+}
+
+/* Tests_SRS_XIO_01_066: [ When a traced send completes, the span shall end with send_result, the memory of the traced send shall be freed and on_send_complete shall be called with send_result. ]*/
+TEST_FUNCTION(a_traced_send_completed_from_within_the_call_ends_once)
+{
+    // arrange
+    XIO_HANDLE xio = create_test_xio(&test_io_description_with_stats);
+    unsigned char send_data[] = { 0x42 };
+    int result;
+    g_complete_in_call = true;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_xio_get_stats(TEST_CONCRETE_IO_HANDLE, IGNORED_PTR_ARG, 1, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_xio_send(TEST_CONCRETE_IO_HANDLE, send_data, sizeof(send_data), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_send_complete(TEST_CALLBACK_CONTEXT, IO_SEND_OK));
+
+    // act
+    result = xio_send(xio, send_data, sizeof(send_data), test_on_send_complete, TEST_CALLBACK_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 2, test_event_count);
+    ASSERT_ARE_EQUAL(int, (int)XIO_TRACE_EVENT_END, (int)test_events[1].type);
+    ASSERT_ARE_EQUAL(int, (int)IO_SEND_OK, test_events[1].result);
+
+    // cleanup
+    xio_destroy(xio);
+}
+
+/* Tests_SRS_XIO_01_064: [ When tracing is on, xio_send, xio_sendv and xio_send_constbuffer_array shall begin a span with the XIO_STATS layer_name of the concrete IO ("xio" if it keeps no counters), the name of the function without xio_ and the number of bytes sent. ]*/
+TEST_FUNCTION(xio_send_on_a_concrete_io_without_counters_traces_the_layer_as_xio)
+{
+    // arrange
+    XIO_HANDLE xio = create_test_xio(&test_io_description);
+    unsigned char send_data[] = { 0x42 };
+
+    // act
+    (void)xio_send(xio, send_data, sizeof(send_data), test_on_send_complete, TEST_CALLBACK_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(size_t, 1, test_event_count);
+    ASSERT_ARE_EQUAL(char_ptr, "xio", test_events[0].layer_name);
+
+    // cleanup
+    g_on_send_complete(g_callback_context, IO_SEND_OK);
+    xio_destroy(xio);
+}
+
+/* Tests_SRS_XIO_01_064: [ When tracing is on, xio_send, xio_sendv and xio_send_constbuffer_array shall begin a span with the XIO_STATS layer_name of the concrete IO ("xio" if it keeps no counters), the name of the function without xio_ and the number of bytes sent. ]*/
+TEST_FUNCTION(xio_send_reads_the_layer_name_only_once)
+{
+    // arrange
+    XIO_HANDLE xio = create_test_xio(&test_io_description_with_stats);
+    unsigned char send_data[] = { 0x42 };
+    (void)xio_send(xio, send_data, sizeof(send_data), test_on_send_complete, TEST_CALLBACK_CONTEXT);
+    g_on_send_complete(g_callback_context, IO_SEND_OK);
+    umock_c_reset_all_calls();
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_xio_send(TEST_CONCRETE_IO_HANDLE, send_data, sizeof(send_data), IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+
+    // act
+    (void)xio_send(xio, send_data, sizeof(send_data), test_on_send_complete, TEST_CALLBACK_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(char_ptr, TEST_LAYER_NAME, test_events[2].layer_name);
+
+    // cleanup
+    g_on_send_complete(g_callback_context, IO_SEND_OK);
+    xio_destroy(xio);
+}
+
+/* Tests_SRS_XIO_01_068: [ If the concrete IO fails the send, the span shall end with IO_SEND_ERROR and the memory of the traced send shall be freed. ]*/
+TEST_FUNCTION(when_the_concrete_io_fails_the_send_the_span_ends_with_IO_SEND_ERROR)
+{
+    // arrange
+    XIO_HANDLE xio = create_test_xio(&test_io_description_with_stats);
+    unsigned char send_data[] = { 0x42 };
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(test_xio_get_stats(TEST_CONCRETE_IO_HANDLE, IGNORED_PTR_ARG, 1, IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_xio_send(TEST_CONCRETE_IO_HANDLE, send_data, sizeof(send_data), IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(1);
+    STRICT_EXPECTED_CALL(tickcounter_get_monotonic_us(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = xio_send(xio, send_data, sizeof(send_data), test_on_send_complete, TEST_CALLBACK_CONTEXT);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 2, test_event_count);
+    ASSERT_ARE_EQUAL(int, (int)XIO_TRACE_EVENT_END, (int)test_events[1].type);
+    ASSERT_ARE_EQUAL(int, (int)IO_SEND_ERROR, test_events[1].result);
+    ASSERT_ARE_EQUAL(uint64_t, 0, xio_trace_enter(NULL).span_id);
+
+    // cleanup
+    xio_destroy(xio);
+}
+
+/* Tests_SRS_XIO_01_067: [ If allocating the traced send fails, the send shall go on without being traced. ]*/
+TEST_FUNCTION(when_allocating_the_traced_send_fails_the_send_is_not_traced)
+{
+    // arrange
+    XIO_HANDLE xio = create_test_xio(&test_io_description_with_stats);
+    unsigned char send_data[] = { 0x42 };
+    int result;
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+    STRICT_EXPECTED_CALL(test_xio_send(TEST_CONCRETE_IO_HANDLE, send_data, sizeof(send_data), test_on_send_complete, TEST_CALLBACK_CONTEXT));
+
+    // act
+    result = xio_send(xio, send_data, sizeof(send_data), test_on_send_complete, TEST_CALLBACK_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_EQUAL(size_t, 0, test_event_count);
+
+    // cleanup
+    xio_destroy(xio);
+}
+
+/* Tests_SRS_XIO_01_064: [ When tracing is on, xio_send, xio_sendv and xio_send_constbuffer_array shall begin a span with the XIO_STATS layer_name of the concrete IO ("xio" if it keeps no counters), the name of the function without xio_ and the number of bytes sent. ]*/
+TEST_FUNCTION(xio_sendv_traces_the_size_of_all_buffers)
+{
+    // arrange
+    XIO_HANDLE xio = create_test_xio(&test_io_description_with_stats);
+    unsigned char data_1[] = { 0x42, 0x43 };
+    unsigned char data_2[] = { 0x44, 0x45, 0x46 };
+    XIO_BUFFER buffers[2];
+    int result;
+    buffers[0].buffer = data_1;
+    buffers[0].size = sizeof(data_1);
+    buffers[1].buffer = data_2;
+    buffers[1].size = sizeof(data_2);
+
+    // act
+    result = xio_sendv(xio, buffers, 2, test_on_send_complete, TEST_CALLBACK_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, test_event_count);
+    ASSERT_ARE_EQUAL(char_ptr, "sendv", test_events[0].operation);
+    ASSERT_ARE_EQUAL(uint64_t, 5, test_events[0].size);
+    ASSERT_ARE_EQUAL(uint64_t, test_events[0].span.span_id, g_span_during_send.span_id);
+
+    // cleanup
+    g_on_send_complete(g_callback_context, IO_SEND_OK);
+    xio_destroy(xio);
+}
+
+/* Tests_SRS_XIO_01_064: [ When tracing is on, xio_send, xio_sendv and xio_send_constbuffer_array shall begin a span with the XIO_STATS layer_name of the concrete IO ("xio" if it keeps no counters), the name of the function without xio_ and the number of bytes sent. ]*/
+TEST_FUNCTION(xio_send_constbuffer_array_traces_the_size_of_the_array)
+{
+    // arrange
+    XIO_HANDLE xio = create_test_xio(&test_io_description_with_stats);
+    int result;
+
+    // act
+    result = xio_send_constbuffer_array(xio, TEST_CONSTBUFFER_ARRAY_HANDLE, test_on_send_complete, TEST_CALLBACK_CONTEXT);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(size_t, 1, test_event_count);
+    ASSERT_ARE_EQUAL(char_ptr, "send_constbuffer_array", test_events[0].operation);
+    ASSERT_ARE_EQUAL(uint64_t, 77, test_events[0].size);
+
+    // cleanup
+    g_on_send_complete(g_callback_context, IO_SEND_OK);
+    xio_destroy(xio);
+}
+
+/* Tests_SRS_XIO_01_065: [ The span shall be the current span of the thread while the concrete IO is called, and the concrete IO shall be given a callback that ends it. ]*/
+TEST_FUNCTION(a_send_made_while_a_traced_send_runs_is_its_child)
+{
+    // arrange
+    XIO_HANDLE xio = create_test_xio(&test_io_description_with_stats);
+    unsigned char send_data[] = { 0x42 };
+    XIO_TRACE_SPAN child;
+    XIO_TRACE_SPAN previous;
+    (void)xio_send(xio, send_data, sizeof(send_data), test_on_send_complete, TEST_CALLBACK_CONTEXT);
+
+    // act
+    previous = xio_trace_enter(&g_span_during_send);
+    xio_trace_begin(&child, "lower_layer", "send", 1);
+    xio_trace_leave(previous);
+
+    // assert
+    ASSERT_ARE_EQUAL(uint64_t, test_events[0].span.span_id, child.parent_span_id);
+    ASSERT_ARE_EQUAL(uint64_t, test_events[0].span.correlation_id, child.correlation_id);
+
+    // cleanup
+    g_on_send_complete(g_callback_context, IO_SEND_OK);
+    xio_destroy(xio);
+}
+
+END_TEST_SUITE(xio_traced_unittests)
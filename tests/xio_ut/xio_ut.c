@@ -28,15 +28,22 @@ static void my_gballoc_free(void* ptr)
 
 #include "umock_c.h"
 #include "umocktypes_charptr.h"
+#include "umocktypes_stdint.h"
 #include "umock_c_negative_tests.h"
 
 #define ENABLE_MOCKS
 #include "azure_c_shared_utility/gballoc.h"
 #include "azure_c_shared_utility/optionhandler.h"
+#include "azure_c_shared_utility/constbuffer_array.h"
 #undef ENABLE_MOCKS
 
 #include "azure_c_shared_utility/xio.h"
 static CONCRETE_IO_HANDLE TEST_CONCRETE_IO_HANDLE = (CONCRETE_IO_HANDLE)0x4242;
+static CONSTBUFFER_ARRAY_HANDLE TEST_CONSTBUFFER_ARRAY_HANDLE = (CONSTBUFFER_ARRAY_HANDLE)0x4243;
+
+IMPLEMENT_UMOCK_C_ENUM_TYPE(IO_SEND_RESULT, IO_SEND_RESULT_VALUES);
+static ON_SEND_COMPLETE g_sendv_on_send_complete;
+static void* g_sendv_callback_context;
 
 #define ENABLE_MOCKS
 MOCK_FUNCTION_WITH_CODE(, CONCRETE_IO_HANDLE, test_xio_create, void*, xio_create_parameters)
@@ -53,6 +60,22 @@ MOCK_FUNCTION_WITH_CODE(, void, test_xio_dowork, CONCRETE_IO_HANDLE, handle)
 MOCK_FUNCTION_END()
 MOCK_FUNCTION_WITH_CODE(, int, test_xio_setoption, CONCRETE_IO_HANDLE, handle, const char*, optionName, const void*, value)
 MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(, int, test_xio_sendv, CONCRETE_IO_HANDLE, handle, const XIO_BUFFER*, buffers, size_t, buffer_count, ON_SEND_COMPLETE, on_send_complete, void*, callback_context)
+    g_sendv_on_send_complete = on_send_complete;
+    g_sendv_callback_context = callback_context;
+MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(, int, test_xio_send_constbuffer_array, CONCRETE_IO_HANDLE, handle, CONSTBUFFER_ARRAY_HANDLE, constbuffer_array, ON_SEND_COMPLETE, on_send_complete, void*, callback_context)
+MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(, int, test_xio_get_stats, CONCRETE_IO_HANDLE, handle, XIO_STATS*, stats, size_t, stats_count, size_t*, layer_count)
+MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(, int, test_xio_dowork_ex, CONCRETE_IO_HANDLE, handle, bool*, made_progress, uint64_t*, next_deadline_us)
+MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(, int, test_xio_get_pollable_handle, CONCRETE_IO_HANDLE, handle, intptr_t*, pollable_handle, unsigned int*, wanted_events)
+MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(, int, test_xio_set_receive_buffer, CONCRETE_IO_HANDLE, handle, unsigned char*, buffer, size_t, size)
+MOCK_FUNCTION_END(0)
+MOCK_FUNCTION_WITH_CODE(, void, test_on_constbuffer_array_send_complete, void*, context, IO_SEND_RESULT, send_result)
+MOCK_FUNCTION_END()
 
 #include "azure_c_shared_utility/umock_c_prod.h"
 /*this function will clone an option given by name and value*/
@@ -113,6 +136,104 @@ const IO_INTERFACE_DESCRIPTION test_io_description =
     test_xio_setoption
 };
 
+const IO_INTERFACE_DESCRIPTION test_io_description_with_sendv =
+{
+    test_xio_retrieveoptions,
+    test_xio_create,
+    test_xio_destroy,
+    test_xio_open,
+    test_xio_close,
+    test_xio_send,
+    test_xio_dowork,
+    test_xio_setoption,
+    test_xio_sendv
+};
+
+const IO_INTERFACE_DESCRIPTION test_io_description_with_send_constbuffer_array =
+{
+    test_xio_retrieveoptions,
+    test_xio_create,
+    test_xio_destroy,
+    test_xio_open,
+    test_xio_close,
+    test_xio_send,
+    test_xio_dowork,
+    test_xio_setoption,
+    test_xio_sendv,
+    test_xio_send_constbuffer_array
+};
+
+const IO_INTERFACE_DESCRIPTION test_io_description_with_get_stats =
+{
+    test_xio_retrieveoptions,
+    test_xio_create,
+    test_xio_destroy,
+    test_xio_open,
+    test_xio_close,
+    test_xio_send,
+    test_xio_dowork,
+    test_xio_setoption,
+    NULL,
+    NULL,
+    test_xio_get_stats
+};
+
+const IO_INTERFACE_DESCRIPTION test_io_description_with_dowork_ex =
+{
+    test_xio_retrieveoptions,
+    test_xio_create,
+    test_xio_destroy,
+    test_xio_open,
+    test_xio_close,
+    test_xio_send,
+    test_xio_dowork,
+    test_xio_setoption,
+    NULL,
+    NULL,
+    NULL,
+    test_xio_dowork_ex
+};
+
+const IO_INTERFACE_DESCRIPTION test_io_description_with_get_pollable_handle =
+{
+    test_xio_retrieveoptions,
+    test_xio_create,
+    test_xio_destroy,
+    test_xio_open,
+    test_xio_close,
+    test_xio_send,
+    test_xio_dowork,
+    test_xio_setoption,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    test_xio_get_pollable_handle
+};
+
+const IO_INTERFACE_DESCRIPTION test_io_description_with_set_receive_buffer =
+{
+    test_xio_retrieveoptions,
+    test_xio_create,
+    test_xio_destroy,
+    test_xio_open,
+    test_xio_close,
+    test_xio_send,
+    test_xio_dowork,
+    test_xio_setoption,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    NULL,
+    test_xio_set_receive_buffer
+};
+
+static const unsigned char test_header[] = { 0x01, 0x02 };
+static const unsigned char test_payload[] = { 0x42, 43, 44 };
+static const CONSTBUFFER test_header_content = { test_header, sizeof(test_header) };
+static const CONSTBUFFER test_payload_content = { test_payload, sizeof(test_payload) };
+
 static TEST_MUTEX_HANDLE g_testByTest;
 
 DEFINE_ENUM_STRINGS(UMOCK_C_ERROR_CODE, UMOCK_C_ERROR_CODE_VALUES)
@@ -161,6 +282,8 @@ TEST_SUITE_INITIALIZE(suite_init)
 
     result = umocktypes_charptr_register_types();
     ASSERT_ARE_EQUAL(int, 0, result);
+    result = umocktypes_stdint_register_types();
+    ASSERT_ARE_EQUAL(int, 0, result);
 
     REGISTER_UMOCK_ALIAS_TYPE(CONCRETE_IO_HANDLE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(XIO_HANDLE, void*);
@@ -170,6 +293,10 @@ TEST_SUITE_INITIALIZE(suite_init)
     REGISTER_UMOCK_ALIAS_TYPE(ON_IO_OPEN_COMPLETE, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_BYTES_RECEIVED, void*);
     REGISTER_UMOCK_ALIAS_TYPE(ON_IO_ERROR, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(const XIO_BUFFER*, void*);
+    REGISTER_UMOCK_ALIAS_TYPE(CONSTBUFFER_ARRAY_HANDLE, void*);
+    REGISTER_TYPE(IO_SEND_RESULT, IO_SEND_RESULT);
+    REGISTER_UMOCK_ALIAS_TYPE(uint32_t*, void*);
 
     REGISTER_UMOCK_ALIAS_TYPE(pfCloneOption, void*);
     REGISTER_UMOCK_ALIAS_TYPE(pfDestroyOption, void*);
@@ -772,69 +899,114 @@ TEST_FUNCTION(xio_send_with_non_NULL_buffer_and_zero_length_passes_the_args_down
     xio_destroy(handle);
 }
 
-/* xio_dowork */
+/* xio_sendv */
 
-/* Tests_SRS_XIO_01_012: [xio_dowork shall call the concrete IO implementation specified in xio_create, by calling the concrete_xio_dowork function.] */
-TEST_FUNCTION(xio_dowork_calls_the_concrete_dowork_and_succeeds)
+/* Tests_SRS_XIO_01_032: [If the argument xio is NULL or buffers is NULL or buffer_count is 0, xio_sendv shall return a non-zero value.] */
+TEST_FUNCTION(xio_sendv_with_NULL_handle_fails)
 {
     // arrange
-    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    int result;
+    unsigned char send_data[] = { 0x42, 43 };
+    XIO_BUFFER buffers[1];
+    buffers[0].buffer = send_data;
+    buffers[0].size = sizeof(send_data);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(test_xio_dowork(TEST_CONCRETE_IO_HANDLE));
+    // act
+    result = xio_sendv(NULL, buffers, 1, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_01_032: [If the argument xio is NULL or buffers is NULL or buffer_count is 0, xio_sendv shall return a non-zero value.] */
+TEST_FUNCTION(xio_sendv_with_NULL_buffers_fails)
+{
+    // arrange
+    int result;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_sendv, NULL);
+    umock_c_reset_all_calls();
 
     // act
-    xio_dowork(handle);
+    result = xio_sendv(handle, NULL, 1, test_on_send_complete, (void*)0x4242);
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     xio_destroy(handle);
 }
 
-/* Tests_SRS_XIO_01_018: [When the handle argument is NULL, xio_dowork shall do nothing.] */
-TEST_FUNCTION(xio_dowork_with_NULL_handle_does_nothing)
+/* Tests_SRS_XIO_01_032: [If the argument xio is NULL or buffers is NULL or buffer_count is 0, xio_sendv shall return a non-zero value.] */
+TEST_FUNCTION(xio_sendv_with_zero_buffer_count_fails)
 {
     // arrange
+    int result;
+    unsigned char send_data[] = { 0x42, 43 };
+    XIO_BUFFER buffers[1];
+    XIO_HANDLE handle = xio_create(&test_io_description_with_sendv, NULL);
+    buffers[0].buffer = send_data;
+    buffers[0].size = sizeof(send_data);
+    umock_c_reset_all_calls();
 
     // act
-    xio_dowork(NULL);
+    result = xio_sendv(handle, buffers, 0, test_on_send_complete, (void*)0x4242);
 
     // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
 }
 
-/* Tests_SRS_XIO_03_030: [If the xio argument or the optionName argument is NULL, xio_setoption shall return a non-zero value.] */
-TEST_FUNCTION(xio_setoption_with_NULL_handle_fails)
+/* Tests_SRS_XIO_01_033: [If the concrete IO implements concrete_io_sendv, xio_sendv shall pass all arguments down to it and return its result.] */
+TEST_FUNCTION(xio_sendv_calls_the_underlying_concrete_xio_sendv_and_succeeds)
 {
     // arrange
     int result;
-    const char* optionName = "TheOptionName";
-    const void* optionValue = (void*)1;
-
+    unsigned char header[] = { 0x01 };
+    unsigned char payload[] = { 0x42, 43 };
+    XIO_BUFFER buffers[2];
+    XIO_HANDLE handle = xio_create(&test_io_description_with_sendv, NULL);
+    buffers[0].buffer = header;
+    buffers[0].size = sizeof(header);
+    buffers[1].buffer = payload;
+    buffers[1].size = sizeof(payload);
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(test_xio_sendv(TEST_CONCRETE_IO_HANDLE, buffers, 2, test_on_send_complete, (void*)0x4242));
+
     // act
-    result = xio_setoption(NULL, optionName, optionValue);
+    result = xio_sendv(handle, buffers, 2, test_on_send_complete, (void*)0x4242);
 
     // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+
+    // cleanup
+    xio_destroy(handle);
 }
 
-/* Tests_SRS_XIO_03_030: [If the xio argument or the optionName argument is NULL, xio_setoption shall return a non-zero value.] */
-TEST_FUNCTION(xio_setoption_with_NULL_optionName_fails)
+/* Tests_SRS_XIO_01_033: [If the concrete IO implements concrete_io_sendv, xio_sendv shall pass all arguments down to it and return its result.] */
+TEST_FUNCTION(when_the_concrete_xio_sendv_fails_then_xio_sendv_fails)
 {
     // arrange
-    const void* optionValue = (void*)1;
     int result;
-    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
-
+    unsigned char payload[] = { 0x42, 43 };
+    XIO_BUFFER buffers[1];
+    XIO_HANDLE handle = xio_create(&test_io_description_with_sendv, NULL);
+    buffers[0].buffer = payload;
+    buffers[0].size = sizeof(payload);
     umock_c_reset_all_calls();
 
+    STRICT_EXPECTED_CALL(test_xio_sendv(TEST_CONCRETE_IO_HANDLE, buffers, 1, test_on_send_complete, (void*)0x4242))
+        .SetReturn(42);
+
     // act
-    result = xio_setoption(handle, NULL, optionValue);
+    result = xio_sendv(handle, buffers, 1, test_on_send_complete, (void*)0x4242);
 
     // assert
     ASSERT_ARE_NOT_EQUAL(int, 0, result);
@@ -844,22 +1016,22 @@ TEST_FUNCTION(xio_setoption_with_NULL_optionName_fails)
     xio_destroy(handle);
 }
 
-/* Tests_SRS_XIO_003_028: [xio_setoption shall pass the optionName and value to the concrete IO implementation specified in xio_create by invoking the concrete_xio_setoption function.] */
-/* Tests_SRS_XIO_03_029: [xio_setoption shall return 0 upon success.] */
-TEST_FUNCTION(xio_setoption_with_valid_args_passes_the_args_down_and_succeeds)
+/* Tests_SRS_XIO_01_034: [If concrete_io_sendv is NULL and buffer_count is 1, xio_sendv shall call concrete_io_send with the only buffer, without copying it.] */
+TEST_FUNCTION(xio_sendv_with_one_buffer_and_no_concrete_sendv_calls_concrete_send)
 {
     // arrange
     int result;
-    const char* optionName = "TheOptionName";
-    const void* optionValue = (void*)1;
+    unsigned char payload[] = { 0x42, 43 };
+    XIO_BUFFER buffers[1];
     XIO_HANDLE handle = xio_create(&test_io_description, NULL);
-
+    buffers[0].buffer = payload;
+    buffers[0].size = sizeof(payload);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(test_xio_setoption(TEST_CONCRETE_IO_HANDLE, optionName, optionValue));
+    STRICT_EXPECTED_CALL(test_xio_send(TEST_CONCRETE_IO_HANDLE, payload, sizeof(payload), test_on_send_complete, (void*)0x4242));
 
     // act
-    result = xio_setoption(handle, optionName, optionValue);
+    result = xio_sendv(handle, buffers, 1, test_on_send_complete, (void*)0x4242);
 
     // assert
     ASSERT_ARE_EQUAL(int, 0, result);
@@ -869,124 +1041,1107 @@ TEST_FUNCTION(xio_setoption_with_valid_args_passes_the_args_down_and_succeeds)
     xio_destroy(handle);
 }
 
-/* Tests_SRS_XIO_03_031: [If the underlying concrete_xio_setoption fails, xio_setOption shall return a non-zero value.] */
-TEST_FUNCTION(xio_setoption_fails_when_concrete_xio_setoption_fails)
+/* Tests_SRS_XIO_01_035: [If concrete_io_sendv is NULL and buffer_count is greater than 1, xio_sendv shall copy all buffers in order into one allocation and call concrete_io_send with it, then free the allocation.] */
+TEST_FUNCTION(xio_sendv_with_several_buffers_and_no_concrete_sendv_coalesces_them)
 {
     // arrange
     int result;
-    const char* optionName = "TheOptionName";
-    const void* optionValue = (void*)1;
+    unsigned char header[] = { 0x01, 0x02 };
+    unsigned char payload[] = { 0x42, 43, 44 };
+    unsigned char expected[] = { 0x01, 0x02, 0x42, 43, 44 };
+    XIO_BUFFER buffers[3];
     XIO_HANDLE handle = xio_create(&test_io_description, NULL);
-
+    buffers[0].buffer = header;
+    buffers[0].size = sizeof(header);
+    buffers[1].buffer = NULL;
+    buffers[1].size = 0;
+    buffers[2].buffer = payload;
+    buffers[2].size = sizeof(payload);
     umock_c_reset_all_calls();
 
-    STRICT_EXPECTED_CALL(test_xio_setoption(TEST_CONCRETE_IO_HANDLE, optionName, optionValue))
-        .SetReturn(42);
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(expected)));
+    STRICT_EXPECTED_CALL(test_xio_send(TEST_CONCRETE_IO_HANDLE, IGNORED_PTR_ARG, sizeof(expected), test_on_send_complete, (void*)0x4242))
+        .ValidateArgumentBuffer(2, expected, sizeof(expected));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
 
     // act
-    result = xio_setoption(handle, optionName, optionValue);
+    result = xio_sendv(handle, buffers, 3, test_on_send_complete, (void*)0x4242);
 
     // assert
-    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
     // cleanup
     xio_destroy(handle);
 }
 
-/*Tests_SRS_XIO_02_001: [ If argument xio is NULL then xio_retrieveoptions shall fail and return NULL. ]*/
-TEST_FUNCTION(xio_retrieveoptions_with_NULL_xio_fails)
+/* Tests_SRS_XIO_01_037: [If allocating the coalesced buffer fails, xio_sendv shall return a non-zero value.] */
+TEST_FUNCTION(when_allocating_the_coalesced_buffer_fails_then_xio_sendv_fails)
 {
-    ///arrange
-
-    ///act
-    OPTIONHANDLER_HANDLE h = xio_retrieveoptions(NULL);
+    // arrange
+    int result;
+    unsigned char header[] = { 0x01, 0x02 };
+    unsigned char payload[] = { 0x42, 43, 44 };
+    XIO_BUFFER buffers[2];
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    buffers[0].buffer = header;
+    buffers[0].size = sizeof(header);
+    buffers[1].buffer = payload;
+    buffers[1].size = sizeof(payload);
+    umock_c_reset_all_calls();
 
-    ///assert
-    ASSERT_IS_NULL(h);
+    STRICT_EXPECTED_CALL(gballoc_malloc(sizeof(header) + sizeof(payload)))
+        .SetReturn(NULL);
 
-    ///cleanup
-}
+    // act
+    result = xio_sendv(handle, buffers, 2, test_on_send_complete, (void*)0x4242);
 
-/*this function exists for the purpose of sharing code between happy and unhappy paths*/
-static void xio_retrieveoptions_inert_path(void)
-{
-    STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, (pfSetOption)xio_setoption))
-        .IgnoreArgument_cloneOption()
-        .IgnoreArgument_destroyOption();
-    STRICT_EXPECTED_CALL(test_xio_retrieveoptions(IGNORED_PTR_ARG))
-        .IgnoreArgument_handle();
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-    STRICT_EXPECTED_CALL(OptionHandler_AddOption(IGNORED_PTR_ARG, "concreteOptions", IGNORED_PTR_ARG))
-        .IgnoreArgument_handle()
-        .IgnoreArgument_value();
+    // cleanup
+    xio_destroy(handle);
 }
 
-/*Tests_SRS_XIO_02_002: [ xio_retrieveoptions shall create a OPTIONHANDLER_HANDLE by calling OptionHandler_Create passing xio_setoption as setOption argument and xio_CloneOption and xio_DestroyOption for cloneOption and destroyOption. ]*/
-/*Tests_SRS_XIO_02_003: [ xio_retrieveoptions shall retrieve the concrete handle's options by a call to concrete_io_retrieveoptions. ]*/
-/*Tests_SRS_XIO_02_004: [ xio_retrieveoptions shall add a hardcoded option named concreteOptions having the same content as the concrete handle's options. ]*/
-/*Tests_SRS_XIO_02_006: [ Otherwise, xio_retrieveoptions shall succeed and return a non-NULL handle. ]*/
-TEST_FUNCTION(xio_retrieveoptions_happypath)
+/* Tests_SRS_XIO_01_036: [If the total size of all buffers is 0, xio_sendv shall call concrete_io_send with a NULL buffer and a size of 0.] */
+TEST_FUNCTION(xio_sendv_with_only_empty_buffers_calls_concrete_send_with_zero_size)
 {
-    ///arrange
-    OPTIONHANDLER_HANDLE h;
-    XIO_HANDLE x = xio_create(&test_io_description, NULL);
+    // arrange
+    int result;
+    XIO_BUFFER buffers[2];
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    buffers[0].buffer = NULL;
+    buffers[0].size = 0;
+    buffers[1].buffer = NULL;
+    buffers[1].size = 0;
     umock_c_reset_all_calls();
 
-    xio_retrieveoptions_inert_path();
+    STRICT_EXPECTED_CALL(test_xio_send(TEST_CONCRETE_IO_HANDLE, NULL, 0, test_on_send_complete, (void*)0x4242));
 
-    ///act
-    h = xio_retrieveoptions(x);
+    // act
+    result = xio_sendv(handle, buffers, 2, test_on_send_complete, (void*)0x4242);
 
-    ///assert
-    ASSERT_IS_NOT_NULL(h);
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
     ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-    ///cleanup
-    OptionHandler_Destroy(h);
-    xio_destroy(x);
+    // cleanup
+    xio_destroy(handle);
 }
 
-/*Tests_SRS_XIO_02_005: [ If any operation fails, then xio_retrieveoptions shall fail and return NULL. ]*/
+/* xio_send_constbuffer_array */
 
-TEST_FUNCTION(xio_retrieveoptions_unhappypaths)
+static void setup_constbuffer_array_with_2_buffers(void)
 {
-    ///arrange
-    XIO_HANDLE x;
-    size_t i;
-    int negativeTestsInitResult = umock_c_negative_tests_init();
-    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+    uint32_t buffer_count = 2;
+
+    STRICT_EXPECTED_CALL(constbuffer_array_get_buffer_count(TEST_CONSTBUFFER_ARRAY_HANDLE, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_buffer_count(&buffer_count, sizeof(buffer_count));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG));
+    STRICT_EXPECTED_CALL(constbuffer_array_get_buffer_content(TEST_CONSTBUFFER_ARRAY_HANDLE, 0))
+        .SetReturn(&test_header_content);
+    STRICT_EXPECTED_CALL(constbuffer_array_get_buffer_content(TEST_CONSTBUFFER_ARRAY_HANDLE, 1))
+        .SetReturn(&test_payload_content);
+    STRICT_EXPECTED_CALL(constbuffer_array_inc_ref(TEST_CONSTBUFFER_ARRAY_HANDLE));
+}
 
-    x = xio_create(&test_io_description, NULL);
+/* Tests_SRS_XIO_01_038: [If the argument xio is NULL or constbuffer_array is NULL, xio_send_constbuffer_array shall return a non-zero value.] */
+TEST_FUNCTION(xio_send_constbuffer_array_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+
+    // act
+    result = xio_send_constbuffer_array(NULL, TEST_CONSTBUFFER_ARRAY_HANDLE, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_01_038: [If the argument xio is NULL or constbuffer_array is NULL, xio_send_constbuffer_array shall return a non-zero value.] */
+TEST_FUNCTION(xio_send_constbuffer_array_with_NULL_constbuffer_array_fails)
+{
+    // arrange
+    int result;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_send_constbuffer_array, NULL);
     umock_c_reset_all_calls();
 
-    xio_retrieveoptions_inert_path();
+    // act
+    result = xio_send_constbuffer_array(handle, NULL, test_on_send_complete, (void*)0x4242);
 
-    umock_c_negative_tests_snapshot();
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-    ///act
-    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
-    {
-        char temp_str[128];
-        OPTIONHANDLER_HANDLE h;
+    // cleanup
+    xio_destroy(handle);
+}
 
-        umock_c_negative_tests_reset();
-        umock_c_negative_tests_fail_call(i);
+/* Tests_SRS_XIO_01_039: [If the concrete IO implements concrete_io_send_constbuffer_array, xio_send_constbuffer_array shall pass all arguments down to it and return its result.] */
+TEST_FUNCTION(xio_send_constbuffer_array_calls_the_underlying_concrete_xio_send_constbuffer_array)
+{
+    // arrange
+    int result;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_send_constbuffer_array, NULL);
+    umock_c_reset_all_calls();
 
-        ///act
-        (void)sprintf(temp_str, "On failed call %lu", (unsigned long)i);
+    STRICT_EXPECTED_CALL(test_xio_send_constbuffer_array(TEST_CONCRETE_IO_HANDLE, TEST_CONSTBUFFER_ARRAY_HANDLE, test_on_send_complete, (void*)0x4242));
 
-        ///act
-        h = xio_retrieveoptions(x);
+    // act
+    result = xio_send_constbuffer_array(handle, TEST_CONSTBUFFER_ARRAY_HANDLE, test_on_send_complete, (void*)0x4242);
 
-        ///assert
-        ASSERT_IS_NULL(h, temp_str);
-    }
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
 
-    ///cleanup
-    xio_destroy(x);
-    umock_c_negative_tests_deinit();
+    // cleanup
+    xio_destroy(handle);
 }
 
+/* Tests_SRS_XIO_01_039: [If the concrete IO implements concrete_io_send_constbuffer_array, xio_send_constbuffer_array shall pass all arguments down to it and return its result.] */
+TEST_FUNCTION(when_the_concrete_xio_send_constbuffer_array_fails_then_xio_send_constbuffer_array_fails)
+{
+    // arrange
+    int result;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_send_constbuffer_array, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_send_constbuffer_array(TEST_CONCRETE_IO_HANDLE, TEST_CONSTBUFFER_ARRAY_HANDLE, test_on_send_complete, (void*)0x4242))
+        .SetReturn(42);
+
+    // act
+    result = xio_send_constbuffer_array(handle, TEST_CONSTBUFFER_ARRAY_HANDLE, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_040: [If constbuffer_array has no buffers, xio_send_constbuffer_array shall call concrete_io_send with a NULL buffer and a size of 0.] */
+TEST_FUNCTION(xio_send_constbuffer_array_with_an_empty_array_calls_concrete_send_with_zero_size)
+{
+    // arrange
+    int result;
+    uint32_t buffer_count = 0;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_sendv, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(constbuffer_array_get_buffer_count(TEST_CONSTBUFFER_ARRAY_HANDLE, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_buffer_count(&buffer_count, sizeof(buffer_count));
+    STRICT_EXPECTED_CALL(test_xio_send(TEST_CONCRETE_IO_HANDLE, NULL, 0, test_on_send_complete, (void*)0x4242));
+
+    // act
+    result = xio_send_constbuffer_array(handle, TEST_CONSTBUFFER_ARRAY_HANDLE, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_041: [Otherwise xio_send_constbuffer_array shall allocate memory to hold constbuffer_array, on_send_complete, callback_context and one XIO_BUFFER for each buffer of constbuffer_array.] */
+/* Tests_SRS_XIO_01_042: [xio_send_constbuffer_array shall point each XIO_BUFFER at the content of the matching buffer, without copying it.] */
+/* Tests_SRS_XIO_01_043: [xio_send_constbuffer_array shall inc_ref constbuffer_array, so that the buffers stay alive until the send completes.] */
+/* Tests_SRS_XIO_01_044: [xio_send_constbuffer_array shall send the XIO_BUFFERs with xio_sendv.] */
+/* Tests_SRS_XIO_01_048: [On success, xio_send_constbuffer_array shall return 0.] */
+TEST_FUNCTION(xio_send_constbuffer_array_without_concrete_send_constbuffer_array_uses_sendv)
+{
+    // arrange
+    int result;
+    XIO_BUFFER expected_buffers[2];
+    XIO_HANDLE handle = xio_create(&test_io_description_with_sendv, NULL);
+    umock_c_reset_all_calls();
+
+    expected_buffers[0].buffer = test_header;
+    expected_buffers[0].size = sizeof(test_header);
+    expected_buffers[1].buffer = test_payload;
+    expected_buffers[1].size = sizeof(test_payload);
+
+    setup_constbuffer_array_with_2_buffers();
+    STRICT_EXPECTED_CALL(test_xio_sendv(TEST_CONCRETE_IO_HANDLE, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .ValidateArgumentBuffer(2, expected_buffers, sizeof(expected_buffers));
+
+    // act
+    result = xio_send_constbuffer_array(handle, TEST_CONSTBUFFER_ARRAY_HANDLE, test_on_constbuffer_array_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    g_sendv_on_send_complete(g_sendv_callback_context, IO_SEND_OK);
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_045: [When the send completes, xio_send_constbuffer_array shall dec_ref constbuffer_array, free the allocated memory and call on_send_complete with send_result.] */
+TEST_FUNCTION(when_the_send_completes_xio_send_constbuffer_array_releases_the_array_and_indicates_the_result)
+{
+    // arrange
+    XIO_HANDLE handle = xio_create(&test_io_description_with_sendv, NULL);
+    umock_c_reset_all_calls();
+
+    setup_constbuffer_array_with_2_buffers();
+    STRICT_EXPECTED_CALL(test_xio_sendv(TEST_CONCRETE_IO_HANDLE, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, IGNORED_PTR_ARG));
+    ASSERT_ARE_EQUAL(int, 0, xio_send_constbuffer_array(handle, TEST_CONSTBUFFER_ARRAY_HANDLE, test_on_constbuffer_array_send_complete, (void*)0x4242));
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+    STRICT_EXPECTED_CALL(test_on_constbuffer_array_send_complete((void*)0x4242, IO_SEND_CANCELLED));
+
+    // act
+    g_sendv_on_send_complete(g_sendv_callback_context, IO_SEND_CANCELLED);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_046: [If any failure occurs, xio_send_constbuffer_array shall return a non-zero value.] */
+TEST_FUNCTION(when_getting_the_buffer_count_fails_then_xio_send_constbuffer_array_fails)
+{
+    // arrange
+    int result;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_sendv, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(constbuffer_array_get_buffer_count(TEST_CONSTBUFFER_ARRAY_HANDLE, IGNORED_PTR_ARG))
+        .SetReturn(1);
+
+    // act
+    result = xio_send_constbuffer_array(handle, TEST_CONSTBUFFER_ARRAY_HANDLE, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_046: [If any failure occurs, xio_send_constbuffer_array shall return a non-zero value.] */
+TEST_FUNCTION(when_allocating_the_send_context_fails_then_xio_send_constbuffer_array_fails)
+{
+    // arrange
+    int result;
+    uint32_t buffer_count = 2;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_sendv, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(constbuffer_array_get_buffer_count(TEST_CONSTBUFFER_ARRAY_HANDLE, IGNORED_PTR_ARG))
+        .CopyOutArgumentBuffer_buffer_count(&buffer_count, sizeof(buffer_count));
+    STRICT_EXPECTED_CALL(gballoc_malloc(IGNORED_NUM_ARG))
+        .SetReturn(NULL);
+
+    // act
+    result = xio_send_constbuffer_array(handle, TEST_CONSTBUFFER_ARRAY_HANDLE, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_047: [If xio_sendv fails, xio_send_constbuffer_array shall dec_ref constbuffer_array, free the allocated memory and return a non-zero value.] */
+TEST_FUNCTION(when_xio_sendv_fails_then_xio_send_constbuffer_array_releases_the_array_and_fails)
+{
+    // arrange
+    int result;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_sendv, NULL);
+    umock_c_reset_all_calls();
+
+    setup_constbuffer_array_with_2_buffers();
+    STRICT_EXPECTED_CALL(test_xio_sendv(TEST_CONCRETE_IO_HANDLE, IGNORED_PTR_ARG, 2, IGNORED_PTR_ARG, IGNORED_PTR_ARG))
+        .SetReturn(42);
+    STRICT_EXPECTED_CALL(constbuffer_array_dec_ref(TEST_CONSTBUFFER_ARRAY_HANDLE));
+    STRICT_EXPECTED_CALL(gballoc_free(IGNORED_PTR_ARG));
+
+    // act
+    result = xio_send_constbuffer_array(handle, TEST_CONSTBUFFER_ARRAY_HANDLE, test_on_send_complete, (void*)0x4242);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* xio_dowork */
+
+/* Tests_SRS_XIO_01_012: [xio_dowork shall call the concrete IO implementation specified in xio_create, by calling the concrete_xio_dowork function.] */
+TEST_FUNCTION(xio_dowork_calls_the_concrete_dowork_and_succeeds)
+{
+    // arrange
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_dowork(TEST_CONCRETE_IO_HANDLE));
+
+    // act
+    xio_dowork(handle);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_018: [When the handle argument is NULL, xio_dowork shall do nothing.] */
+TEST_FUNCTION(xio_dowork_with_NULL_handle_does_nothing)
+{
+    // arrange
+
+    // act
+    xio_dowork(NULL);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* xio_dowork_ex */
+
+/* Tests_SRS_XIO_01_054: [ If xio, made_progress or next_deadline_us is NULL, xio_dowork_ex shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_dowork_ex_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+    bool made_progress;
+    uint64_t next_deadline_us;
+
+    // act
+    result = xio_dowork_ex(NULL, &made_progress, &next_deadline_us);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_01_054: [ If xio, made_progress or next_deadline_us is NULL, xio_dowork_ex shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_dowork_ex_with_NULL_made_progress_fails)
+{
+    // arrange
+    int result;
+    uint64_t next_deadline_us;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_dowork_ex, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_dowork_ex(handle, NULL, &next_deadline_us);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_054: [ If xio, made_progress or next_deadline_us is NULL, xio_dowork_ex shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_dowork_ex_with_NULL_next_deadline_us_fails)
+{
+    // arrange
+    int result;
+    bool made_progress;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_dowork_ex, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_dowork_ex(handle, &made_progress, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_055: [ If the concrete IO does not implement concrete_io_dowork_ex, xio_dowork_ex shall call concrete_io_dowork, set made_progress to true, as it cannot tell that no work was done, and set next_deadline_us to XIO_NO_DEADLINE. ]*/
+TEST_FUNCTION(xio_dowork_ex_when_the_concrete_io_has_no_dowork_ex_calls_the_concrete_dowork)
+{
+    // arrange
+    int result;
+    bool made_progress = false;
+    uint64_t next_deadline_us = 0;
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_dowork(TEST_CONCRETE_IO_HANDLE));
+
+    // act
+    result = xio_dowork_ex(handle, &made_progress, &next_deadline_us);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_IS_TRUE(made_progress);
+    ASSERT_IS_TRUE(next_deadline_us == XIO_NO_DEADLINE);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_056: [ xio_dowork_ex shall pass all arguments down to concrete_io_dowork_ex. ]*/
+/* Tests_SRS_XIO_01_058: [ On success, xio_dowork_ex shall return 0. ]*/
+TEST_FUNCTION(xio_dowork_ex_calls_the_concrete_dowork_ex_and_succeeds)
+{
+    // arrange
+    int result;
+    bool made_progress;
+    uint64_t next_deadline_us;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_dowork_ex, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_dowork_ex(TEST_CONCRETE_IO_HANDLE, &made_progress, &next_deadline_us));
+
+    // act
+    result = xio_dowork_ex(handle, &made_progress, &next_deadline_us);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_057: [ If concrete_io_dowork_ex fails, xio_dowork_ex shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_the_concrete_dowork_ex_fails_then_xio_dowork_ex_fails)
+{
+    // arrange
+    int result;
+    bool made_progress;
+    uint64_t next_deadline_us;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_dowork_ex, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_dowork_ex(TEST_CONCRETE_IO_HANDLE, &made_progress, &next_deadline_us))
+        .SetReturn(42);
+
+    // act
+    result = xio_dowork_ex(handle, &made_progress, &next_deadline_us);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_03_030: [If the xio argument or the optionName argument is NULL, xio_setoption shall return a non-zero value.] */
+TEST_FUNCTION(xio_setoption_with_NULL_handle_fails)
+{
+    // arrange
+    int result;
+    const char* optionName = "TheOptionName";
+    const void* optionValue = (void*)1;
+
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_setoption(NULL, optionName, optionValue);
+
+    // assert
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+}
+
+/* Tests_SRS_XIO_03_030: [If the xio argument or the optionName argument is NULL, xio_setoption shall return a non-zero value.] */
+TEST_FUNCTION(xio_setoption_with_NULL_optionName_fails)
+{
+    // arrange
+    const void* optionValue = (void*)1;
+    int result;
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_setoption(handle, NULL, optionValue);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_003_028: [xio_setoption shall pass the optionName and value to the concrete IO implementation specified in xio_create by invoking the concrete_xio_setoption function.] */
+/* Tests_SRS_XIO_03_029: [xio_setoption shall return 0 upon success.] */
+TEST_FUNCTION(xio_setoption_with_valid_args_passes_the_args_down_and_succeeds)
+{
+    // arrange
+    int result;
+    const char* optionName = "TheOptionName";
+    const void* optionValue = (void*)1;
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_setoption(TEST_CONCRETE_IO_HANDLE, optionName, optionValue));
+
+    // act
+    result = xio_setoption(handle, optionName, optionValue);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_03_031: [If the underlying concrete_xio_setoption fails, xio_setOption shall return a non-zero value.] */
+TEST_FUNCTION(xio_setoption_fails_when_concrete_xio_setoption_fails)
+{
+    // arrange
+    int result;
+    const char* optionName = "TheOptionName";
+    const void* optionValue = (void*)1;
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_setoption(TEST_CONCRETE_IO_HANDLE, optionName, optionValue))
+        .SetReturn(42);
+
+    // act
+    result = xio_setoption(handle, optionName, optionValue);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/*Tests_SRS_XIO_02_001: [ If argument xio is NULL then xio_retrieveoptions shall fail and return NULL. ]*/
+TEST_FUNCTION(xio_retrieveoptions_with_NULL_xio_fails)
+{
+    ///arrange
+
+    ///act
+    OPTIONHANDLER_HANDLE h = xio_retrieveoptions(NULL);
+
+    ///assert
+    ASSERT_IS_NULL(h);
+
+    ///cleanup
+}
+
+/*this function exists for the purpose of sharing code between happy and unhappy paths*/
+static void xio_retrieveoptions_inert_path(void)
+{
+    STRICT_EXPECTED_CALL(OptionHandler_Create(IGNORED_PTR_ARG, IGNORED_PTR_ARG, (pfSetOption)xio_setoption))
+        .IgnoreArgument_cloneOption()
+        .IgnoreArgument_destroyOption();
+    STRICT_EXPECTED_CALL(test_xio_retrieveoptions(IGNORED_PTR_ARG))
+        .IgnoreArgument_handle();
+
+    STRICT_EXPECTED_CALL(OptionHandler_AddOption(IGNORED_PTR_ARG, "concreteOptions", IGNORED_PTR_ARG))
+        .IgnoreArgument_handle()
+        .IgnoreArgument_value();
+}
+
+/*Tests_SRS_XIO_02_002: [ xio_retrieveoptions shall create a OPTIONHANDLER_HANDLE by calling OptionHandler_Create passing xio_setoption as setOption argument and xio_CloneOption and xio_DestroyOption for cloneOption and destroyOption. ]*/
+/*Tests_SRS_XIO_02_003: [ xio_retrieveoptions shall retrieve the concrete handle's options by a call to concrete_io_retrieveoptions. ]*/
+/*Tests_SRS_XIO_02_004: [ xio_retrieveoptions shall add a hardcoded option named concreteOptions having the same content as the concrete handle's options. ]*/
+/*Tests_SRS_XIO_02_006: [ Otherwise, xio_retrieveoptions shall succeed and return a non-NULL handle. ]*/
+TEST_FUNCTION(xio_retrieveoptions_happypath)
+{
+    ///arrange
+    OPTIONHANDLER_HANDLE h;
+    XIO_HANDLE x = xio_create(&test_io_description, NULL);
+    umock_c_reset_all_calls();
+
+    xio_retrieveoptions_inert_path();
+
+    ///act
+    h = xio_retrieveoptions(x);
+
+    ///assert
+    ASSERT_IS_NOT_NULL(h);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    ///cleanup
+    OptionHandler_Destroy(h);
+    xio_destroy(x);
+}
+
+/*Tests_SRS_XIO_02_005: [ If any operation fails, then xio_retrieveoptions shall fail and return NULL. ]*/
+
+TEST_FUNCTION(xio_retrieveoptions_unhappypaths)
+{
+    ///arrange
+    XIO_HANDLE x;
+    size_t i;
+    int negativeTestsInitResult = umock_c_negative_tests_init();
+    ASSERT_ARE_EQUAL(int, 0, negativeTestsInitResult);
+
+    x = xio_create(&test_io_description, NULL);
+    umock_c_reset_all_calls();
+
+    xio_retrieveoptions_inert_path();
+
+    umock_c_negative_tests_snapshot();
+
+    ///act
+    for (i = 0; i < umock_c_negative_tests_call_count(); i++)
+    {
+        char temp_str[128];
+        OPTIONHANDLER_HANDLE h;
+
+        umock_c_negative_tests_reset();
+        umock_c_negative_tests_fail_call(i);
+
+        ///act
+        (void)sprintf(temp_str, "On failed call %lu", (unsigned long)i);
+
+        ///act
+        h = xio_retrieveoptions(x);
+
+        ///assert
+        ASSERT_IS_NULL(h, temp_str);
+    }
+
+    ///cleanup
+    xio_destroy(x);
+    umock_c_negative_tests_deinit();
+}
+
+
+/* xio_get_stats */
+
+/* Tests_SRS_XIO_01_049: [ If xio, stats or layer_count is NULL or stats_count is 0, xio_get_stats shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_get_stats_with_NULL_xio_fails)
+{
+    // arrange
+    int result;
+    XIO_STATS stats[2];
+    size_t layer_count;
+
+    // act
+    result = xio_get_stats(NULL, stats, 2, &layer_count);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_01_049: [ If xio, stats or layer_count is NULL or stats_count is 0, xio_get_stats shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_get_stats_with_NULL_stats_fails)
+{
+    // arrange
+    int result;
+    size_t layer_count;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_get_stats, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_get_stats(handle, NULL, 2, &layer_count);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_049: [ If xio, stats or layer_count is NULL or stats_count is 0, xio_get_stats shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_get_stats_with_0_stats_count_fails)
+{
+    // arrange
+    int result;
+    XIO_STATS stats[2];
+    size_t layer_count;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_get_stats, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_get_stats(handle, stats, 0, &layer_count);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_049: [ If xio, stats or layer_count is NULL or stats_count is 0, xio_get_stats shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_get_stats_with_NULL_layer_count_fails)
+{
+    // arrange
+    int result;
+    XIO_STATS stats[2];
+    XIO_HANDLE handle = xio_create(&test_io_description_with_get_stats, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_get_stats(handle, stats, 2, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_050: [ If the concrete IO does not implement concrete_io_get_stats, xio_get_stats shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_get_stats_when_the_concrete_io_has_no_get_stats_fails)
+{
+    // arrange
+    int result;
+    XIO_STATS stats[2];
+    size_t layer_count;
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_get_stats(handle, stats, 2, &layer_count);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_051: [ xio_get_stats shall pass all arguments down to concrete_io_get_stats. ]*/
+/* Tests_SRS_XIO_01_053: [ On success, xio_get_stats shall return 0. ]*/
+TEST_FUNCTION(xio_get_stats_calls_the_concrete_get_stats_and_succeeds)
+{
+    // arrange
+    int result;
+    XIO_STATS stats[2];
+    size_t layer_count;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_get_stats, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_get_stats(TEST_CONCRETE_IO_HANDLE, stats, 2, &layer_count));
+
+    // act
+    result = xio_get_stats(handle, stats, 2, &layer_count);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_052: [ If concrete_io_get_stats fails, xio_get_stats shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_the_concrete_get_stats_fails_then_xio_get_stats_fails)
+{
+    // arrange
+    int result;
+    XIO_STATS stats[2];
+    size_t layer_count;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_get_stats, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_get_stats(TEST_CONCRETE_IO_HANDLE, stats, 2, &layer_count))
+        .SetReturn(42);
+
+    // act
+    result = xio_get_stats(handle, stats, 2, &layer_count);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* xio_get_pollable_handle */
+
+/* Tests_SRS_XIO_01_059: [ If xio, pollable_handle or wanted_events is NULL, xio_get_pollable_handle shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_get_pollable_handle_with_NULL_xio_fails)
+{
+    // arrange
+    int result;
+    intptr_t pollable_handle;
+    unsigned int wanted_events;
+
+    // act
+    result = xio_get_pollable_handle(NULL, &pollable_handle, &wanted_events);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_01_059: [ If xio, pollable_handle or wanted_events is NULL, xio_get_pollable_handle shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_get_pollable_handle_with_NULL_pollable_handle_fails)
+{
+    // arrange
+    int result;
+    unsigned int wanted_events;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_get_pollable_handle, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_get_pollable_handle(handle, NULL, &wanted_events);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_059: [ If xio, pollable_handle or wanted_events is NULL, xio_get_pollable_handle shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_get_pollable_handle_with_NULL_wanted_events_fails)
+{
+    // arrange
+    int result;
+    intptr_t pollable_handle;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_get_pollable_handle, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_get_pollable_handle(handle, &pollable_handle, NULL);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_060: [ If the concrete IO does not implement concrete_io_get_pollable_handle, xio_get_pollable_handle shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_get_pollable_handle_when_the_concrete_io_has_no_get_pollable_handle_fails)
+{
+    // arrange
+    int result;
+    intptr_t pollable_handle;
+    unsigned int wanted_events;
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_get_pollable_handle(handle, &pollable_handle, &wanted_events);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_061: [ xio_get_pollable_handle shall pass all arguments down to concrete_io_get_pollable_handle. ]*/
+/* Tests_SRS_XIO_01_063: [ On success, xio_get_pollable_handle shall return 0. ]*/
+TEST_FUNCTION(xio_get_pollable_handle_calls_the_concrete_get_pollable_handle_and_succeeds)
+{
+    // arrange
+    int result;
+    intptr_t pollable_handle;
+    unsigned int wanted_events;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_get_pollable_handle, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_get_pollable_handle(TEST_CONCRETE_IO_HANDLE, &pollable_handle, &wanted_events));
+
+    // act
+    result = xio_get_pollable_handle(handle, &pollable_handle, &wanted_events);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_062: [ If concrete_io_get_pollable_handle fails, xio_get_pollable_handle shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_the_concrete_get_pollable_handle_fails_then_xio_get_pollable_handle_fails)
+{
+    // arrange
+    int result;
+    intptr_t pollable_handle;
+    unsigned int wanted_events;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_get_pollable_handle, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_get_pollable_handle(TEST_CONCRETE_IO_HANDLE, &pollable_handle, &wanted_events))
+        .SetReturn(42);
+
+    // act
+    result = xio_get_pollable_handle(handle, &pollable_handle, &wanted_events);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* xio_set_receive_buffer */
+
+/* Tests_SRS_XIO_01_069: [ If xio is NULL, or only one of buffer and size is NULL or 0, xio_set_receive_buffer shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_set_receive_buffer_with_NULL_xio_fails)
+{
+    // arrange
+    int result;
+    unsigned char buffer[16];
+
+    // act
+    result = xio_set_receive_buffer(NULL, buffer, sizeof(buffer));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+}
+
+/* Tests_SRS_XIO_01_069: [ If xio is NULL, or only one of buffer and size is NULL or 0, xio_set_receive_buffer shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_set_receive_buffer_with_NULL_buffer_and_non_zero_size_fails)
+{
+    // arrange
+    int result;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_set_receive_buffer, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_set_receive_buffer(handle, NULL, 16);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_069: [ If xio is NULL, or only one of buffer and size is NULL or 0, xio_set_receive_buffer shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_set_receive_buffer_with_zero_size_and_non_NULL_buffer_fails)
+{
+    // arrange
+    int result;
+    unsigned char buffer[16];
+    XIO_HANDLE handle = xio_create(&test_io_description_with_set_receive_buffer, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_set_receive_buffer(handle, buffer, 0);
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_070: [ If the concrete IO does not implement concrete_io_set_receive_buffer, xio_set_receive_buffer shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(xio_set_receive_buffer_when_the_concrete_io_has_no_set_receive_buffer_fails)
+{
+    // arrange
+    int result;
+    unsigned char buffer[16];
+    XIO_HANDLE handle = xio_create(&test_io_description, NULL);
+    umock_c_reset_all_calls();
+
+    // act
+    result = xio_set_receive_buffer(handle, buffer, sizeof(buffer));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_071: [ xio_set_receive_buffer shall pass all arguments down to concrete_io_set_receive_buffer. ]*/
+/* Tests_SRS_XIO_01_073: [ On success, xio_set_receive_buffer shall return 0. ]*/
+TEST_FUNCTION(xio_set_receive_buffer_calls_the_concrete_set_receive_buffer_and_succeeds)
+{
+    // arrange
+    int result;
+    unsigned char buffer[16];
+    XIO_HANDLE handle = xio_create(&test_io_description_with_set_receive_buffer, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_set_receive_buffer(TEST_CONCRETE_IO_HANDLE, buffer, sizeof(buffer)));
+
+    // act
+    result = xio_set_receive_buffer(handle, buffer, sizeof(buffer));
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_071: [ xio_set_receive_buffer shall pass all arguments down to concrete_io_set_receive_buffer. ]*/
+TEST_FUNCTION(xio_set_receive_buffer_with_NULL_buffer_and_zero_size_forgets_the_lent_buffer)
+{
+    // arrange
+    int result;
+    XIO_HANDLE handle = xio_create(&test_io_description_with_set_receive_buffer, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_set_receive_buffer(TEST_CONCRETE_IO_HANDLE, NULL, 0));
+
+    // act
+    result = xio_set_receive_buffer(handle, NULL, 0);
+
+    // assert
+    ASSERT_ARE_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
+
+/* Tests_SRS_XIO_01_072: [ If concrete_io_set_receive_buffer fails, xio_set_receive_buffer shall fail and return a non-zero value. ]*/
+TEST_FUNCTION(when_the_concrete_set_receive_buffer_fails_then_xio_set_receive_buffer_fails)
+{
+    // arrange
+    int result;
+    unsigned char buffer[16];
+    XIO_HANDLE handle = xio_create(&test_io_description_with_set_receive_buffer, NULL);
+    umock_c_reset_all_calls();
+
+    STRICT_EXPECTED_CALL(test_xio_set_receive_buffer(TEST_CONCRETE_IO_HANDLE, buffer, sizeof(buffer)))
+        .SetReturn(42);
+
+    // act
+    result = xio_set_receive_buffer(handle, buffer, sizeof(buffer));
+
+    // assert
+    ASSERT_ARE_NOT_EQUAL(int, 0, result);
+    ASSERT_ARE_EQUAL(char_ptr, umock_c_get_expected_calls(), umock_c_get_actual_calls());
+
+    // cleanup
+    xio_destroy(handle);
+}
 
 END_TEST_SUITE(xio_unittests)